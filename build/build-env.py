@@ -90,18 +90,18 @@ OldEnvironment = Environment;
 # this dictionary maps the name of a compiler program to a dictionary mapping the name of
 # a compiler switch of interest to the specific switch implementing the feature
 gCompilerOptions = {
-    'gcc' : {'warn_all' : '-Wall', 'warn_errors' : '-Werror', 'optimization' : '-O2', 'debug' : '-g',  'exception_handling' : '',      'omp' : '-fopenmp'},
-    'g++' : {'warn_all' : '-Wall', 'warn_errors' : '-Werror', 'optimization' : '-O2', 'debug' : '-g',  'exception_handling' : '',      'omp' : '-fopenmp'},
-    'cl'  : {'warn_all' : '/Wall', 'warn_errors' : '/WX',     'optimization' : '/Ox', 'debug' : ['/Zi', '-D_DEBUG', '/MTd'], 'exception_handling' : '/EHsc', 'omp' : '/openmp'}
+    'gcc' : {'warn_all' : '-Wall', 'warn_errors' : '-Werror', 'optimization' : '-O2', 'debug' : '-g',  'exception_handling' : '',      'omp' : '-fopenmp', 'threads' : '-pthread'},
+    'g++' : {'warn_all' : '-Wall', 'warn_errors' : '-Werror', 'optimization' : '-O2', 'debug' : '-g',  'exception_handling' : '',      'omp' : '-fopenmp', 'threads' : '-pthread'},
+    'cl'  : {'warn_all' : '/Wall', 'warn_errors' : '/WX',     'optimization' : '/Ox', 'debug' : ['/Zi', '-D_DEBUG', '/MTd'], 'exception_handling' : '/EHsc', 'omp' : '/openmp', 'threads' : ''}
   }
 
 
 # this dictionary maps the name of a linker program to a dictionary mapping the name of
 # a linker switch of interest to the specific switch implementing the feature
 gLinkerOptions = {
-    'gcc' : {'debug' : ''},
-    'g++' : {'debug' : ''},
-    'link'  : {'debug' : '/debug'}
+    'gcc' : {'debug' : '', 'threads' : '-pthread'},
+    'g++' : {'debug' : '', 'threads' : '-pthread'},
+    'link'  : {'debug' : '/debug', 'threads' : ''}
   }
 
 
@@ -124,6 +124,9 @@ def getCFLAGS(mode, backend, warn, warnings_as_errors, hostspblas, b40c, CC):
   if CC == 'cl':
     result.append('/bigobj')
 
+  # cusp/detail/mutex.h and the cuBLAS handle cleanup use pthreads
+  result.append(gCompilerOptions[CC]['threads'])
+
   # generate omp code
   if backend == 'omp':
     result.append(gCompilerOptions[CC]['omp'])
@@ -153,6 +156,8 @@ def getCXXFLAGS(mode, backend, warn, warnings_as_errors, hostspblas, b40c, CXX):
     result.append(gCompilerOptions[CXX]['debug'])
   # enable exception handling
   result.append(gCompilerOptions[CXX]['exception_handling'])
+  # cusp/detail/mutex.h and the cuBLAS handle cleanup use pthreads
+  result.append(gCompilerOptions[CXX]['threads'])
   # force 32b code on darwin
   if platform.platform()[:6] == 'Darwin':
     result.append('-m32')
@@ -194,6 +199,8 @@ def getLINKFLAGS(mode, backend, hostspblas, LINK):
   if mode == 'debug':
     # turn on debug mode
     result.append(gLinkerOptions[LINK]['debug'])
+  # link pthreads for cusp/detail/mutex.h and the cuBLAS handle cleanup
+  result.append(gLinkerOptions[LINK]['threads'])
   # force 32b code on darwin
   if platform.platform()[:6] == 'Darwin':
     result.append('-m32')
@@ -247,6 +254,24 @@ def Environment():
   # add a variable to enable B40C support
   vars.Add(BoolVariable('b40c', 'Enable support for B40C', 0))
 
+  # add a variable to enable OpenMP in host code with any backend
+  vars.Add(BoolVariable('openmp', 'Enable OpenMP for host_memory algorithms', 0))
+
+  # add a variable to enable zlib support
+  vars.Add(BoolVariable('zlib', 'Enable support for gzip compressed files', 0))
+
+  # add a variable to enable zstd support
+  vars.Add(BoolVariable('zstd', 'Enable support for zstd compressed files', 0))
+
+  # add a variable to enable the containers distributed over MPI processes
+  vars.Add(BoolVariable('mpi', 'Enable support for MPI distributed containers', 0))
+
+  # add a variable to enable cuBLAS for dense device BLAS
+  vars.Add(BoolVariable('cublas', 'Enable cuBLAS for dense device_memory BLAS', 0))
+
+  # add a variable to enable clock control and energy readings in the benchmarks
+  vars.Add(BoolVariable('nvml', 'Enable NVML clock locking and energy readings in the benchmarks', 0))
+
   # create an Environment
   env = OldEnvironment(tools = getTools(), variables = vars)
 
@@ -303,6 +328,39 @@ def Environment():
     else:
       raise ValueError, "Unknown OS.  What is the name of the OpenMP library?"
 
+  if env['openmp'] and env['backend'] != 'omp':
+    env.Append(CFLAGS = [gCompilerOptions[env.subst('$CC')]['omp']])
+    env.Append(CXXFLAGS = [gCompilerOptions[env.subst('$CXX')]['omp']])
+    if os.name == 'posix':
+      env.Append(LIBS = ['gomp'])
+    elif os.name == 'nt':
+      env.Append(LIBS = ['VCOMP'])
+
+  if env['zlib']:
+    env.Append(CFLAGS = ['-D__CUSP_USE_ZLIB__'])
+    env.Append(CXXFLAGS = ['-D__CUSP_USE_ZLIB__'])
+    env.Append(LIBS = ['z'])
+
+  if env['zstd']:
+    env.Append(CFLAGS = ['-D__CUSP_USE_ZSTD__'])
+    env.Append(CXXFLAGS = ['-D__CUSP_USE_ZSTD__'])
+    env.Append(LIBS = ['zstd'])
+
+  if env['mpi']:
+    env.Append(CFLAGS = ['-D__CUSP_USE_MPI__'])
+    env.Append(CXXFLAGS = ['-D__CUSP_USE_MPI__'])
+    env.Append(LIBS = ['mpi'])
+
+  if env['cublas']:
+    env.Append(CFLAGS = ['-D__CUSP_USE_CUBLAS__'])
+    env.Append(CXXFLAGS = ['-D__CUSP_USE_CUBLAS__'])
+    env.Append(LIBS = ['cublas'])
+
+  if env['nvml']:
+    env.Append(CFLAGS = ['-DCUSP_BENCHMARK_NVML'])
+    env.Append(CXXFLAGS = ['-DCUSP_BENCHMARK_NVML'])
+    env.Append(LIBS = ['nvidia-ml'])
+
   if env['hostspblas'] == 'mkl':
     intel_lib = 'mkl_intel'
     if platform.machine()[-2:] == '64':
@@ -29,12 +29,23 @@
 #include <thrust/host_vector.h>
 #include <thrust/device_vector.h>
 #include <thrust/detail/vector_base.h>
+#include <thrust/copy.h>
 
 namespace cusp
 {
   // forward definitions
   template <typename RandomAccessIterator> class array1d_view;
 
+/*! \p uninitialized_t : Tag of the constructors and resizes of \p array1d
+ *  which leave the elements uninitialized, for storage whose contents are
+ *  written before they are read.
+ */
+struct uninitialized_t {};
+
+/*! Instance of \p uninitialized_t, e.g. <tt>v.resize(n, cusp::uninitialized)</tt>
+ */
+const uninitialized_t uninitialized = uninitialized_t();
+
 /*! \addtogroup arrays Arrays
  */
 
@@ -81,6 +92,8 @@ class array1d : public thrust::detail::vector_base<T, typename cusp::default_mem
 
         array1d(void) : Parent() {}
 
+        /*! Allocate \p n elements without initializing them.
+         */
         explicit array1d(size_type n)
             : Parent()
         {
@@ -90,6 +103,19 @@ class array1d : public thrust::detail::vector_base<T, typename cusp::default_mem
                 Parent::m_size = n;
             }
         }
+
+        /*! Allocate \p n elements without initializing them, like
+         *  <tt>array1d(n)</tt> but explicit about it.
+         */
+        array1d(size_type n, cusp::uninitialized_t)
+            : Parent()
+        {
+            if(n > 0)
+            {
+                Parent::m_storage.allocate(n);
+                Parent::m_size = n;
+            }
+        }
         
         array1d(size_type n, const value_type &value) 
           : Parent(n, value) {}
@@ -106,7 +132,28 @@ class array1d : public thrust::detail::vector_base<T, typename cusp::default_mem
           array1d &operator=(const Array& a)
           { Parent::assign(a.begin(), a.end()); return *this; }
 
-        // TODO specialize resize()
+        using Parent::resize;
+
+        /*! Resize to \p n elements.  Unlike <tt>resize(n)</tt> the added
+         *  elements are not value-initialized, which saves a fill kernel
+         *  on device arrays; the first <tt>min(n, size())</tt> elements
+         *  are kept.  No storage is reallocated when \p n does not exceed
+         *  the capacity.
+         */
+        void resize(size_type n, cusp::uninitialized_t)
+        {
+            if(n <= Parent::capacity())
+            {
+                // the elements are trivially destructible
+                Parent::m_size = n;
+            }
+            else
+            {
+                array1d grown(n, cusp::uninitialized);
+                thrust::copy(Parent::begin(), Parent::end(), grown.begin());
+                Parent::swap(grown);
+            }
+        }
 }; // class array1d
 /*! \}
  */
@@ -264,6 +311,63 @@ typename array1d<T,MemorySpace>::const_view make_array1d_view(const array1d<T,Me
 {
   return make_array1d_view(a.begin(), a.end());
 }
+
+namespace detail
+{
+
+// view of n values at p in MemorySpace, with the same type as the views of
+// an array1d<T,MemorySpace> (or its const_view when T is const)
+template <typename T, typename MemorySpace>
+struct raw_array1d_view
+{
+  typedef T                            value_type;
+  typedef cusp::array1d<T,MemorySpace> Array;
+  typedef typename Array::view         type;
+
+  static type make(T * p, size_t n)
+  {
+    typename Array::iterator first = typename Array::iterator(typename Array::pointer(p));
+    return type(first, first + n);
+  }
+};
+
+template <typename T, typename MemorySpace>
+struct raw_array1d_view<const T, MemorySpace>
+{
+  typedef T                            value_type;
+  typedef cusp::array1d<T,MemorySpace> Array;
+  typedef typename Array::const_view   type;
+
+  static type make(const T * p, size_t n)
+  {
+    typename Array::const_iterator first = typename Array::const_iterator(typename Array::const_pointer(p));
+    return type(first, first + n);
+  }
+};
+
+} // end namespace detail
+
+/*! \p make_array1d_view : View \p n values of an external buffer in
+ *  \p MemorySpace (\p cusp::host_memory or \p cusp::device_memory).
+ *
+ *  Nothing is copied or allocated; the view has the same type as the \p view
+ *  (or, for const pointers, the \p const_view) of an \p array1d in that
+ *  memory space, so it is accepted wherever such a view is.
+ *
+ *  \code
+ *  float * d_x;
+ *  cudaMalloc(&d_x, n * sizeof(float));
+ *  ...
+ *  cusp::array1d<float,cusp::device_memory>::view x =
+ *      cusp::make_array1d_view(d_x, n, cusp::device_memory());
+ *  \endcode
+ */
+template <typename T, typename MemorySpace>
+typename detail::raw_array1d_view<T,MemorySpace>::type
+make_array1d_view(T * first, size_t n, MemorySpace)
+{
+  return detail::raw_array1d_view<T,MemorySpace>::make(first, n);
+}
 /*! \}
  */
   
@@ -75,6 +75,27 @@ IndexType major_dimension(IndexType num_rows, IndexType num_cols, column_major)
     return num_cols;
 }
 
+// pitch of a minor dimension whose slices start at multiples of alignment
+// bytes.  Minor dimensions shorter than the alignment are padded to the next
+// power of two instead, so that short rows of a row-major block of vectors
+// tile the aligned segments without spanning two of them.
+inline size_t aligned_pitch(size_t minor_dimension, size_t value_size, size_t alignment)
+{
+    if (minor_dimension == 0 || value_size == 0 || alignment % value_size != 0)
+        return minor_dimension;
+
+    const size_t values_per_segment = alignment / value_size;
+
+    if (minor_dimension >= values_per_segment)
+        return values_per_segment * ((minor_dimension + values_per_segment - 1) / values_per_segment);
+
+    size_t pitch = 1;
+    while (pitch < minor_dimension)
+        pitch *= 2;
+
+    return pitch;
+}
+
 // convert logical linear index into a logical (i,j) index
 template <typename IndexType>
 __host__ __device__
@@ -328,6 +349,15 @@ public:
         resize(num_rows, num_cols, cusp::detail::minor_dimension(num_rows, num_cols, orientation()));
     }
 
+    // resize with a pitch of a multiple of alignment bytes, like cudaMallocPitch,
+    // so that every row (row_major) or column (column_major) is aligned
+    void resize_pitched(size_t num_rows, size_t num_cols, size_t alignment = 128)
+    {
+        resize(num_rows, num_cols,
+               cusp::detail::aligned_pitch(cusp::detail::minor_dimension(num_rows, num_cols, orientation()),
+                                           sizeof(ValueType), alignment));
+    }
+
     void swap(array2d& matrix)
     {
         Parent::swap(matrix);
@@ -513,6 +543,23 @@ make_array2d_view(const cusp::array2d<ValueType,MemorySpace,Orientation>& a)
 {
     return cusp::make_array2d_view(a.num_rows, a.num_cols, a.pitch, cusp::make_array1d_view(a.values), Orientation());
 }
+
+/*! \p make_array2d_view : View a \p num_rows by \p num_cols array stored
+ *  with the given \p pitch and \p Orientation in an external buffer in
+ *  \p MemorySpace.  Nothing is copied.
+ */
+template<typename ValueType, class Orientation, class MemorySpace>
+array2d_view<typename cusp::detail::raw_array1d_view<ValueType,MemorySpace>::type, Orientation>
+make_array2d_view(size_t num_rows, size_t num_cols, size_t pitch, ValueType * values, Orientation, MemorySpace)
+{
+    const size_t major = cusp::detail::major_dimension(num_rows, num_cols, Orientation());
+    const size_t minor = cusp::detail::minor_dimension(num_rows, num_cols, Orientation());
+    const size_t size  = (major == 0 || minor == 0) ? 0 : pitch * (major - 1) + minor;
+
+    return cusp::make_array2d_view(num_rows, num_cols, pitch,
+                                   cusp::detail::raw_array1d_view<ValueType,MemorySpace>::make(values, size),
+                                   Orientation());
+}
 /*! \}
  */
 
@@ -0,0 +1,206 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*! \file assembly.h
+ *  \brief Incremental assembly of sparse matrices from triplets
+ */
+
+#pragma once
+
+#include <cusp/detail/config.h>
+
+#include <cusp/array1d.h>
+#include <cusp/csr_matrix.h>
+#include <cusp/memory.h>
+
+namespace cusp
+{
+
+/*! \addtogroup sparse_matrices Sparse Matrices
+ */
+
+/*! \addtogroup sparse_matrix_containers Sparse Matrix Containers
+ *  \ingroup sparse_matrices
+ *  \{
+ */
+
+/*! \p matrix_assembler : Buffer of (i,j,v) triplets which are sorted and
+ *  combined only when the matrix is requested.
+ *
+ *  Triplets are appended in any order and duplicate coordinates are summed.
+ *  \p finalize sorts the buffered triplets and converts them to any matrix
+ *  format, while \p assemble_values accumulates them into the values of an
+ *  existing CSR matrix with the same sparsity pattern, without sorting the
+ *  coordinates or allocating the matrix again.  Both empty the buffer but
+ *  keep its storage, so assembling the next step does not reallocate.
+ *
+ *  Triplets can be appended as whole arrays from any memory space, one at a
+ *  time, or written directly into the \c row_indices, \c column_indices and
+ *  \c values arrays, e.g. by a device kernel, after reserving a range with
+ *  \p append(count).
+ *
+ * \tparam IndexType Type used for matrix indices (e.g. \c int).
+ * \tparam ValueType Type used for matrix values (e.g. \c float).
+ * \tparam MemorySpace A memory space (e.g. \c cusp::host_memory or cusp::device_memory)
+ *
+ * \note Appending arrays or single triplets is safe from several OpenMP
+ *       threads at once, the copies are serialized.  \p append(count)
+ *       may reallocate the arrays and must not be called while other
+ *       threads are writing triplets.
+ *
+ *  \code
+ *  #include <cusp/assembly.h>
+ *  #include <cusp/csr_matrix.h>
+ *  ...
+ *
+ *  cusp::matrix_assembler<int,float,cusp::device_memory> assembler(num_nodes, num_nodes);
+ *
+ *  // element matrices computed on the host
+ *  assembler.append(element_rows, element_cols, element_values);
+ *
+ *  // sort, sum duplicates and build the matrix once
+ *  cusp::csr_matrix<int,float,cusp::device_memory> A;
+ *  assembler.finalize(A);
+ *
+ *  for (int step = 0; step < num_steps; step++)
+ *  {
+ *      assembler.append(element_rows, element_cols, element_values);
+ *
+ *      // only the values of A are updated
+ *      assembler.assemble_values(A);
+ *  }
+ *  \endcode
+ */
+template <typename IndexType, typename ValueType, class MemorySpace>
+class matrix_assembler
+{
+  public:
+    /*! type of the triplet index arrays
+     */
+    typedef typename cusp::array1d<IndexType, MemorySpace> index_array_type;
+
+    /*! type of the triplet value array
+     */
+    typedef typename cusp::array1d<ValueType, MemorySpace> value_array_type;
+
+    /*! Number of rows of the assembled matrix.
+     */
+    size_t num_rows;
+
+    /*! Number of columns of the assembled matrix.
+     */
+    size_t num_cols;
+
+    /*! Row indices of the buffered triplets.
+     */
+    index_array_type row_indices;
+
+    /*! Column indices of the buffered triplets.
+     */
+    index_array_type column_indices;
+
+    /*! Values of the buffered triplets.
+     */
+    value_array_type values;
+
+    /*! Construct an empty \p matrix_assembler.
+     */
+    matrix_assembler(void)
+      : num_rows(0), num_cols(0) {}
+
+    /*! Construct a \p matrix_assembler for a matrix of the given shape.
+     *
+     *  \param num_rows Number of rows.
+     *  \param num_cols Number of columns.
+     *  \param capacity Number of triplets to reserve storage for.
+     */
+    matrix_assembler(size_t num_rows, size_t num_cols, size_t capacity = 0)
+      : num_rows(num_rows), num_cols(num_cols)
+    {
+      reserve(capacity);
+    }
+
+    /*! Number of buffered triplets.
+     */
+    size_t num_triplets(void) const
+    {
+      return values.size();
+    }
+
+    /*! Reserve storage for \p capacity triplets.
+     */
+    void reserve(size_t capacity);
+
+    /*! Discard the buffered triplets and keep their storage.
+     */
+    void clear(void);
+
+    /*! Append \p count uninitialized triplets.
+     *
+     *  \return position of the first new triplet in the arrays
+     */
+    size_t append(size_t count);
+
+    /*! Append a single triplet.
+     */
+    void push_back(IndexType row, IndexType column, ValueType value);
+
+    /*! Append arrays of triplets from any memory space.
+     *
+     *  \param rows Row indices.
+     *  \param columns Column indices.
+     *  \param values Values.
+     *
+     *  \throws cusp::invalid_input_exception if the arrays differ in size
+     */
+    template <typename Array1, typename Array2, typename Array3>
+    void append(const Array1& rows, const Array2& columns, const Array3& values);
+
+    /*! Sort the triplets, sum the duplicates and convert the result to
+     *  another matrix.  The buffer is empty afterwards.
+     *
+     *  \param matrix Matrix of any format which is overwritten.
+     *
+     *  \throws cusp::invalid_input_exception if a triplet lies outside the matrix
+     */
+    template <typename MatrixType>
+    void finalize(MatrixType& matrix);
+
+    /*! Overwrite the values of a CSR matrix with the sums of the triplets,
+     *  keeping its sparsity pattern.  Entries without triplets become zero.
+     *  The buffer is empty afterwards.
+     *
+     *  \param matrix CSR matrix with sorted column indices within each row.
+     *
+     *  \throws cusp::invalid_input_exception if the shape differs or a
+     *          triplet has no entry in the pattern of \p matrix
+     */
+    void assemble_values(cusp::csr_matrix<IndexType,ValueType,MemorySpace>& matrix);
+
+  private:
+    // storage for assemble_values
+    index_array_type positions;
+    index_array_type unique_positions;
+    value_array_type sums;
+
+    size_t grow(size_t count);
+}; // class matrix_assembler
+/*! \}
+ */
+
+} // end namespace cusp
+
+#include <cusp/detail/assembly.inl>
@@ -0,0 +1,181 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*! \file autotune.h
+ *  \brief Runtime selection of the sparse matrix format and SpMV kernel
+ */
+
+#pragma once
+
+#include <cusp/detail/config.h>
+
+#include <cusp/csr_matrix.h>
+#include <cusp/linear_operator.h>
+
+#include <string>
+#include <vector>
+
+namespace cusp
+{
+
+/*! \addtogroup algorithms Algorithms
+ *  \ingroup algorithms
+ *  \{
+ */
+
+/*! \p matrix_structure : Summary statistics of the sparsity pattern
+ *  of a matrix, as computed by \p analyze_structure.
+ */
+struct matrix_structure
+{
+    size_t num_rows;
+    size_t num_cols;
+    size_t num_entries;
+
+    size_t min_entries_per_row;
+    size_t max_entries_per_row;
+    double mean_entries_per_row;
+    double stddev_entries_per_row;
+
+    size_t num_diagonals;           // number of occupied diagonals
+    size_t bandwidth;               // max |i - j| over the entries A(i,j)
+    size_t hyb_entries_per_row;     // ELL width of the HYB heuristic
+
+    // row_length_histogram[0] counts the empty rows and
+    // row_length_histogram[k] the rows of length [2^(k-1), 2^k)
+    std::vector<size_t> row_length_histogram;
+
+    matrix_structure()
+      : num_rows(0), num_cols(0), num_entries(0),
+        min_entries_per_row(0), max_entries_per_row(0),
+        mean_entries_per_row(0), stddev_entries_per_row(0),
+        num_diagonals(0), bandwidth(0), hyb_entries_per_row(0) {}
+};
+
+/*! \p analyze_structure : Computes the \p matrix_structure of a host CSR matrix.
+ *
+ * \param A input matrix
+ */
+template <typename IndexType, typename ValueType>
+cusp::matrix_structure
+analyze_structure(const cusp::csr_matrix<IndexType,ValueType,cusp::host_memory>& A);
+
+/*! \p autotune_options : Parameters of the format selection.
+ */
+struct autotune_options
+{
+    bool   benchmark;     // time the candidate kernels instead of using the heuristic
+    size_t iterations;    // number of timed SpMVs per candidate
+    float  max_fill;      // largest admissible DIA and ELL fill ratio
+
+    autotune_options()
+      : benchmark(false), iterations(20), max_fill(3.0f) {}
+};
+
+namespace detail
+{
+template <typename ValueType> class spmv_kernel_base;
+} // end namespace detail
+
+/*! \p autotuned_spmv : Device linear operator which stores a matrix in the
+ *  format whose SpMV kernel is expected (or measured) to be the fastest.
+ *
+ *  The structure of the input matrix is analyzed to decide between the DIA,
+ *  ELL, CSR, COO and HYB formats.  When \p autotune_options::benchmark is
+ *  set, every admissible candidate is transferred to the device and timed,
+ *  like \p time_spmv in the SpMV benchmark, and the fastest one is kept.
+ *  Candidates whose fill exceeds \p max_fill are never converted, so the
+ *  selection does not throw \p format_conversion_exception.
+ *
+ * \tparam IndexType integer type of the matrix indices
+ * \tparam ValueType scalar type of the matrix entries
+ *
+ *  \code
+ *  #include <cusp/autotune.h>
+ *  #include <cusp/krylov/cg.h>
+ *  #include <cusp/gallery/poisson.h>
+ *
+ *  int main(void)
+ *  {
+ *      cusp::csr_matrix<int, float, cusp::host_memory> A;
+ *      cusp::gallery::poisson5pt(A, 100, 100);
+ *
+ *      cusp::autotune_options options;
+ *      options.benchmark = true;
+ *
+ *      cusp::autotuned_spmv<int, float> M(A, options);
+ *
+ *      std::cout << "selected kernel " << M.kernel_name() << std::endl;
+ *
+ *      cusp::array1d<float, cusp::device_memory> x(A.num_rows, 0);
+ *      cusp::array1d<float, cusp::device_memory> b(A.num_rows, 1);
+ *
+ *      cusp::krylov::cg(M, x, b);
+ *
+ *      return 0;
+ *  }
+ *  \endcode
+ */
+template <typename IndexType, typename ValueType>
+class autotuned_spmv : public cusp::linear_operator<ValueType,cusp::device_memory,IndexType>
+{
+    typedef cusp::linear_operator<ValueType,cusp::device_memory,IndexType> Parent;
+
+    cusp::detail::spmv_kernel_base<ValueType> * kernel;
+    cusp::matrix_structure structure_;
+    float milliseconds;
+
+    // not copyable
+    autotuned_spmv(const autotuned_spmv&);
+    autotuned_spmv& operator=(const autotuned_spmv&);
+
+    public:
+
+    /*! Construct the operator from a host matrix.
+     *
+     * \param A input matrix
+     * \param options parameters of the selection
+     */
+    autotuned_spmv(const cusp::csr_matrix<IndexType,ValueType,cusp::host_memory>& A,
+                   const cusp::autotune_options& options = cusp::autotune_options());
+
+    ~autotuned_spmv(void);
+
+    /*! Compute y = A * x with the selected kernel.
+     */
+    template <typename VectorType1, typename VectorType2>
+    void operator()(const VectorType1& x, VectorType2& y) const;
+
+    /*! Name of the selected format and kernel, e.g. "csr_vector".
+     */
+    const std::string& kernel_name(void) const;
+
+    /*! Structure statistics of the input matrix.
+     */
+    const cusp::matrix_structure& structure(void) const { return structure_; }
+
+    /*! Measured time of one SpMV with the selected kernel in milliseconds,
+     *  or zero when the heuristic was used.
+     */
+    float milliseconds_per_spmv(void) const { return milliseconds; }
+};
+/*! \}
+ */
+
+} // end namespace cusp
+
+#include <cusp/detail/autotune.inl>
+
@@ -0,0 +1,145 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*! \file bitmap_tile_operator.h
+ *  \brief Operator of a sparse matrix stored in bitmap tiles and a CSR remainder
+ */
+
+#pragma once
+
+#include <cusp/detail/config.h>
+
+#include <cusp/array1d.h>
+#include <cusp/csr_matrix.h>
+#include <cusp/linear_operator.h>
+
+namespace cusp
+{
+
+/*! \addtogroup algorithms Algorithms
+ *  \ingroup algorithms
+ *  \{
+ */
+
+/*! \p bitmap_tile_operator : Linear operator of a sparse matrix whose
+ *  locally dense parts are stored in tiles with a bitmap of their entries.
+ *
+ *  The matrix is cut into tiles of 8 x 8 entries.  A tile holding at
+ *  least \p min_tile_entries entries is stored as its tile column, a
+ *  64-bit bitmap of the positions it holds and its values packed in the
+ *  order of the bits, so that a tile of \c n entries costs 16 bytes of
+ *  indices instead of the <tt>4 n</tt> bytes of CSR.  The tiles are
+ *  grouped by tile row as in a \p bsr_matrix, but only the entries which
+ *  are present take values, so blocks of any size and shape are stored
+ *  without the padding of a fixed block size.  The entries of the sparser
+ *  tiles form the \p tail, a \p csr_matrix, like the COO part of a
+ *  \p hyb_matrix.
+ *
+ *  A multiply computes the product of the tail and then adds the tiles
+ *  with one thread per row, which finds the values of its row within each
+ *  tile with one popcount of the bitmap.
+ *
+ * \tparam IndexType type of the column indices
+ * \tparam ValueType type of the values
+ * \tparam MemorySpace memory space of the arrays and vectors
+ *
+ *  \code
+ *  #include <cusp/bitmap_tile_operator.h>
+ *  #include <cusp/io/matrix_market.h>
+ *  #include <cusp/krylov/gmres.h>
+ *
+ *  int main(void)
+ *  {
+ *      cusp::csr_matrix<int, float, cusp::device_memory> B;
+ *      cusp::io::read_matrix_market_file(B, "A.mtx");
+ *
+ *      cusp::bitmap_tile_operator<int, float, cusp::device_memory> A(B);
+ *
+ *      cusp::array1d<float, cusp::device_memory> x(A.num_rows, 0);
+ *      cusp::array1d<float, cusp::device_memory> b(A.num_rows, 1);
+ *
+ *      cusp::krylov::gmres(A, x, b, 50);
+ *
+ *      return 0;
+ *  }
+ *  \endcode
+ */
+template <typename IndexType, typename ValueType, typename MemorySpace>
+class bitmap_tile_operator : public cusp::linear_operator<ValueType,MemorySpace,IndexType>
+{
+    typedef cusp::linear_operator<ValueType,MemorySpace,IndexType> Parent;
+
+    public:
+
+    /*! Offsets of the tiles of each tile row.
+     */
+    cusp::array1d<IndexType,MemorySpace> tile_row_offsets;
+
+    /*! Tile column of each tile.
+     */
+    cusp::array1d<IndexType,MemorySpace> tile_column_indices;
+
+    /*! Entries of each tile, bit <tt>8 r + c</tt> for entry (r,c).
+     */
+    cusp::array1d<unsigned long long,MemorySpace> tile_bitmaps;
+
+    /*! Offset of the values of each tile, followed by their number.
+     */
+    cusp::array1d<IndexType,MemorySpace> tile_value_offsets;
+
+    /*! Values of the tiles, packed in the order of the bits.
+     */
+    cusp::array1d<ValueType,MemorySpace> tile_values;
+
+    /*! Entries which are not in a tile.
+     */
+    cusp::csr_matrix<IndexType,ValueType,MemorySpace> tail;
+
+    /*! Construct an empty operator.
+     */
+    bitmap_tile_operator(void);
+
+    /*! Construct the operator of a matrix.
+     *
+     * \param A matrix in any format and memory space
+     * \param min_tile_entries fewest entries of a stored tile
+     */
+    template <typename MatrixType>
+    bitmap_tile_operator(const MatrixType& A, const size_t min_tile_entries = 8);
+
+    /*! Construct a copy of an operator in another memory space.
+     */
+    template <typename MemorySpace2>
+    bitmap_tile_operator(const bitmap_tile_operator<IndexType,ValueType,MemorySpace2>& A);
+
+    /*! Number of tiles.
+     */
+    size_t num_tiles(void) const
+    {
+        return tile_bitmaps.size();
+    }
+
+    /*! Compute y = A * x.
+     */
+    template <typename VectorType1, typename VectorType2>
+    void operator()(const VectorType1& x, VectorType2& y) const;
+};
+/*! \}
+ */
+
+} // end namespace cusp
+
+#include <cusp/detail/bitmap_tile_operator.inl>
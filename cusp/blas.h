@@ -24,7 +24,10 @@
 #include <cusp/detail/config.h>
 
 #include <cusp/complex.h>
+#include <cusp/reduction.h>
+#include <cusp/detail/forward_definitions.h>
 
+#include <thrust/pair.h>
 #include <thrust/iterator/iterator_traits.h>
 
 namespace cusp
@@ -224,6 +227,16 @@ typename Array1::value_type
     dot(const Array1& x,
         const Array2& y);
 
+/*! \p dot : dot product (x^T * y) summed with the given \p reduction_mode
+ *  instead of \p current_reduction_mode()
+ */
+template <typename Array1,
+          typename Array2>
+typename Array1::value_type
+    dot(const Array1& x,
+        const Array2& y,
+        cusp::reduction_mode mode);
+
 
 template <typename InputIterator1,
           typename InputIterator2>
@@ -241,6 +254,16 @@ typename Array1::value_type
     dotc(const Array1& x,
          const Array2& y);
 
+/*! \p dotc : conjugate dot product (conjugate(x)^T * y) summed with the
+ *  given \p reduction_mode instead of \p current_reduction_mode()
+ */
+template <typename Array1,
+          typename Array2>
+typename Array1::value_type
+    dotc(const Array1& x,
+         const Array2& y,
+         cusp::reduction_mode mode);
+
 
 template <typename ForwardIterator,
           typename ScalarType>
@@ -289,6 +312,14 @@ template <typename Array>
 typename norm_type<typename Array::value_type>::type
     nrm2(const Array& array);
 
+/*! \p nrm2 : vector 2-norm (sqrt(sum x[i] * x[i] )) summed with the given
+ *  \p reduction_mode instead of \p current_reduction_mode()
+ */
+template <typename Array>
+typename norm_type<typename Array::value_type>::type
+    nrm2(const Array& array,
+         cusp::reduction_mode mode);
+
 
 template <typename InputIterator>
 CUSP_DEPRECATED
@@ -324,6 +355,313 @@ template <typename Array,
 void scal(const Array& x,
           ScalarType alpha);
 
+/*! \p dot2 : two dot products in one pass (x^T * y, x^T * z)
+ *
+ *  Reads \p x once and transfers both results together, where two calls
+ *  to \p dot would read \p x twice and wait for the device twice.
+ *
+ *  \throws cusp::invalid_input_exception if the sizes do not match
+ */
+template <typename Array1,
+          typename Array2,
+          typename Array3>
+thrust::pair<typename Array1::value_type, typename Array1::value_type>
+    dot2(const Array1& x,
+         const Array2& y,
+         const Array3& z);
+
+/*! \p dotc2 : two conjugate dot products in one pass (conjugate(x)^T * y, conjugate(x)^T * z)
+ */
+template <typename Array1,
+          typename Array2,
+          typename Array3>
+thrust::pair<typename Array1::value_type, typename Array1::value_type>
+    dotc2(const Array1& x,
+          const Array2& y,
+          const Array3& z);
+
+/*! \p axpy_dot : scaled vector addition fused with a dot product
+ *  (y = alpha * x + y, returns z^T * y)
+ *
+ *  The dot product uses the updated \p y, and \p z may be \p y itself,
+ *  e.g. to update a residual and return its squared norm.
+ */
+template <typename Array1,
+          typename Array2,
+          typename Array3,
+          typename ScalarType>
+typename Array2::value_type
+    axpy_dot(const Array1& x,
+                   Array2& y,
+             const Array3& z,
+             ScalarType alpha);
+
+/*! \p axpy_dot : scaled vector addition fused with a dot product
+ *  (y = alpha * x + y, returns z^T * y)
+ */
+template <typename Array1,
+          typename Array2,
+          typename Array3,
+          typename ScalarType>
+typename Array2::value_type
+    axpy_dot(const Array1& x,
+             const Array2& y,
+             const Array3& z,
+             ScalarType alpha);
+
+/*! \p axpy_dotc : scaled vector addition fused with a conjugate dot product
+ *  (y = alpha * x + y, returns conjugate(z)^T * y)
+ */
+template <typename Array1,
+          typename Array2,
+          typename Array3,
+          typename ScalarType>
+typename Array2::value_type
+    axpy_dotc(const Array1& x,
+                    Array2& y,
+              const Array3& z,
+              ScalarType alpha);
+
+/*! \p axpy_dotc : scaled vector addition fused with a conjugate dot product
+ *  (y = alpha * x + y, returns conjugate(z)^T * y)
+ */
+template <typename Array1,
+          typename Array2,
+          typename Array3,
+          typename ScalarType>
+typename Array2::value_type
+    axpy_dotc(const Array1& x,
+              const Array2& y,
+              const Array3& z,
+              ScalarType alpha);
+
+/*! \p mdot : dot products of one vector with many (result[j] = x^T * Y[:,j])
+ *
+ *  The vectors are the columns of the \p array2d or \p array2d_view \p Y,
+ *  which is read once.  All the results are computed in the memory space
+ *  of \p Y and transferred to \p result in one copy, so \p result may be
+ *  a host array for a device \p Y.
+ *
+ *  \throws cusp::invalid_input_exception if the sizes do not match
+ */
+template <typename Array1,
+          typename Array2d,
+          typename Array2>
+void mdot(const Array1& x,
+          const Array2d& Y,
+                Array2& result);
+
+/*! \p mdotc : conjugate dot products of one vector with many
+ *  (result[j] = conjugate(x)^T * Y[:,j])
+ */
+template <typename Array1,
+          typename Array2d,
+          typename Array2>
+void mdotc(const Array1& x,
+           const Array2d& Y,
+                 Array2& result);
+
+/*! \p gemv : dense matrix-vector multiplication (y = alpha * A * x + beta * y)
+ *
+ *  \p A is an \p array2d or \p array2d_view of either orientation and any
+ *  pitch, and \p x and \p y are contiguous arrays in the memory space of
+ *  \p A with the same value type.  \p y is not read when \p beta is zero.
+ *  On the device float and double use cuBLAS when cusp is built with
+ *  \p __CUSP_USE_CUBLAS__.
+ *
+ *  \throws cusp::invalid_input_exception if the dimensions do not match
+ */
+template <typename Array2d,
+          typename Array1,
+          typename Array2,
+          typename ScalarType1,
+          typename ScalarType2>
+void gemv(const Array2d& A,
+          const Array1& x,
+                Array2& y,
+          ScalarType1 alpha,
+          ScalarType2 beta);
+
+/*! \p gemv : dense matrix-vector multiplication (y = alpha * A * x + beta * y)
+ */
+template <typename Array2d,
+          typename Array1,
+          typename Array2,
+          typename ScalarType1,
+          typename ScalarType2>
+void gemv(const Array2d& A,
+          const Array1& x,
+          const Array2& y,
+          ScalarType1 alpha,
+          ScalarType2 beta);
+
+/*! \p gemv : dense matrix-vector multiplication (y = A * x)
+ */
+template <typename Array2d,
+          typename Array1,
+          typename Array2>
+void gemv(const Array2d& A,
+          const Array1& x,
+                Array2& y);
+
+/*! \p gemm : dense matrix-matrix multiplication (C = alpha * A * B + beta * C)
+ *
+ *  \p A, \p B and \p C are \p array2d or \p array2d_view of the same
+ *  value type and memory space, each of either orientation and any pitch.
+ *  \p C is not resized and is not read when \p beta is zero.  On the device
+ *  float and double use cuBLAS when cusp is built with \p __CUSP_USE_CUBLAS__.
+ *
+ *  \throws cusp::invalid_input_exception if the dimensions do not match
+ */
+template <typename Array2d1,
+          typename Array2d2,
+          typename Array2d3,
+          typename ScalarType1,
+          typename ScalarType2>
+void gemm(const Array2d1& A,
+          const Array2d2& B,
+                Array2d3& C,
+          ScalarType1 alpha,
+          ScalarType2 beta);
+
+/*! \p gemm : dense matrix-matrix multiplication (C = alpha * A * B + beta * C)
+ */
+template <typename Array2d1,
+          typename Array2d2,
+          typename Array2d3,
+          typename ScalarType1,
+          typename ScalarType2>
+void gemm(const Array2d1& A,
+          const Array2d2& B,
+          const Array2d3& C,
+          ScalarType1 alpha,
+          ScalarType2 beta);
+
+/*! \p gemm : dense matrix-matrix multiplication (C = A * B)
+ */
+template <typename Array2d1,
+          typename Array2d2,
+          typename Array2d3>
+void gemm(const Array2d1& A,
+          const Array2d2& B,
+                Array2d3& C);
+
+/*! \p trsm : triangular solve with multiple right-hand sides (B = inv(A) * B)
+ *
+ *  Only the lower (\p lower is true) or upper triangle of the square matrix
+ *  \p A is referenced, and its diagonal is taken to be one when
+ *  \p unit_diagonal is true.  \p A and \p B are \p array2d or
+ *  \p array2d_view of the same value type and memory space.
+ *
+ *  \throws cusp::invalid_input_exception if the dimensions do not match
+ */
+template <typename Array2d1,
+          typename Array2d2>
+void trsm(const Array2d1& A,
+                Array2d2& B,
+          bool lower,
+          bool unit_diagonal = false);
+
+/*! \p trsm : triangular solve with multiple right-hand sides (B = inv(A) * B)
+ */
+template <typename Array2d1,
+          typename Array2d2>
+void trsm(const Array2d1& A,
+          const Array2d2& B,
+          bool lower,
+          bool unit_diagonal = false);
+
+/*! \p distributed arrays : The following overloads accept
+ *  \p distributed_array1d arguments with identical layouts.  Each part is
+ *  processed on its own device and reductions are summed on the host.
+ */
+template <typename ValueType,
+          typename ScalarType>
+void axpy(const cusp::distributed_array1d<ValueType>& x,
+                cusp::distributed_array1d<ValueType>& y,
+          ScalarType alpha);
+
+template <typename ValueType,
+          typename ScalarType1,
+          typename ScalarType2>
+void axpby(const cusp::distributed_array1d<ValueType>& x,
+           const cusp::distributed_array1d<ValueType>& y,
+                 cusp::distributed_array1d<ValueType>& output,
+           ScalarType1 alpha,
+           ScalarType2 beta);
+
+template <typename ValueType>
+void copy(const cusp::distributed_array1d<ValueType>& array1,
+                cusp::distributed_array1d<ValueType>& array2);
+
+template <typename ValueType>
+ValueType dot(const cusp::distributed_array1d<ValueType>& x,
+              const cusp::distributed_array1d<ValueType>& y);
+
+template <typename ValueType>
+ValueType dotc(const cusp::distributed_array1d<ValueType>& x,
+               const cusp::distributed_array1d<ValueType>& y);
+
+template <typename ValueType,
+          typename ScalarType>
+void fill(cusp::distributed_array1d<ValueType>& array,
+          ScalarType alpha);
+
+template <typename ValueType>
+typename norm_type<ValueType>::type
+    nrm2(const cusp::distributed_array1d<ValueType>& array);
+
+template <typename ValueType,
+          typename ScalarType>
+void scal(cusp::distributed_array1d<ValueType>& x,
+          ScalarType alpha);
+
+/*! \p MPI arrays : The following overloads accept \p mpi_array1d
+ *  arguments with identical layouts.  Each process works on its local
+ *  rows and reductions are summed over the communicator, so they must be
+ *  called by every process.  They require \c __CUSP_USE_MPI__.
+ */
+template <typename ValueType,
+          typename ScalarType>
+void axpy(const cusp::mpi_array1d<ValueType>& x,
+                cusp::mpi_array1d<ValueType>& y,
+          ScalarType alpha);
+
+template <typename ValueType,
+          typename ScalarType1,
+          typename ScalarType2>
+void axpby(const cusp::mpi_array1d<ValueType>& x,
+           const cusp::mpi_array1d<ValueType>& y,
+                 cusp::mpi_array1d<ValueType>& output,
+           ScalarType1 alpha,
+           ScalarType2 beta);
+
+template <typename ValueType>
+void copy(const cusp::mpi_array1d<ValueType>& array1,
+                cusp::mpi_array1d<ValueType>& array2);
+
+template <typename ValueType>
+ValueType dot(const cusp::mpi_array1d<ValueType>& x,
+              const cusp::mpi_array1d<ValueType>& y);
+
+template <typename ValueType>
+ValueType dotc(const cusp::mpi_array1d<ValueType>& x,
+               const cusp::mpi_array1d<ValueType>& y);
+
+template <typename ValueType,
+          typename ScalarType>
+void fill(cusp::mpi_array1d<ValueType>& array,
+          ScalarType alpha);
+
+template <typename ValueType>
+typename norm_type<ValueType>::type
+    nrm2(const cusp::mpi_array1d<ValueType>& array);
+
+template <typename ValueType,
+          typename ScalarType>
+void scal(cusp::mpi_array1d<ValueType>& x,
+          ScalarType alpha);
+
 /*! \}
  */
 
@@ -0,0 +1,219 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*! \file bsr_matrix.h
+ *  \brief Block Sparse Row matrix format.
+ */
+
+#pragma once
+
+#include <cusp/detail/config.h>
+
+#include <cusp/array1d.h>
+#include <cusp/format.h>
+#include <cusp/memory.h>
+#include <cusp/detail/matrix_base.h>
+
+namespace cusp
+{
+
+/*! \addtogroup sparse_matrices Sparse Matrices
+ */
+
+/*! \addtogroup sparse_matrix_containers Sparse Matrix Containers
+ *  \ingroup sparse_matrices
+ *  \{
+ */
+
+/*! \p bsr_matrix : Block Sparse Row matrix container
+ *
+ * The matrix is partitioned into dense square blocks of \c block_size rows
+ * and columns, and the nonzero blocks are stored in a CSR structure over
+ * the block rows.  Only one column index is stored per block, and the
+ * SpMV kernels for block sizes 2 to 6 keep the rows of a block in
+ * registers.
+ *
+ * The entries of block \c n are stored contiguously in row-major order,
+ * so entry <tt>(r,c)</tt> of the block is <tt>values[n * block_size * block_size + r * block_size + c]</tt>.
+ *
+ * \tparam IndexType Type used for matrix indices (e.g. \c int).
+ * \tparam ValueType Type used for matrix values (e.g. \c float).
+ * \tparam MemorySpace A memory space (e.g. \c cusp::host_memory or cusp::device_memory)
+ *
+ * \note The number of rows and columns must be multiples of \c block_size.
+ * \note The block column indices within each block row are sorted.
+ * \note \c num_entries counts every entry of the stored blocks, including
+ *       the explicit zeros inside a block.
+ * \note The block size of a conversion is taken from the destination
+ *       matrix, so set \c block_size before calling \p cusp::convert, or
+ *       use the constructor which takes it.
+ *
+ *  The following code snippet demonstrates how to convert a \p csr_matrix
+ *  with 3x3 blocks to a \p bsr_matrix on the device.
+ *
+ *  \code
+ *  #include <cusp/csr_matrix.h>
+ *  #include <cusp/bsr_matrix.h>
+ *  #include <cusp/multiply.h>
+ *  ...
+ *
+ *  // A has 3 degrees of freedom per node
+ *  cusp::csr_matrix<int,float,cusp::device_memory> A;
+ *  ...
+ *
+ *  cusp::bsr_matrix<int,float,cusp::device_memory> B(A, 3);
+ *
+ *  cusp::array1d<float,cusp::device_memory> x(B.num_cols, 1);
+ *  cusp::array1d<float,cusp::device_memory> y(B.num_rows);
+ *
+ *  cusp::multiply(B, x, y);
+ *  \endcode
+ *
+ */
+template <typename IndexType, typename ValueType, class MemorySpace>
+class bsr_matrix : public detail::matrix_base<IndexType,ValueType,MemorySpace,cusp::bsr_format>
+{
+  typedef cusp::detail::matrix_base<IndexType,ValueType,MemorySpace,cusp::bsr_format> Parent;
+  public:
+    /*! rebind matrix to a different MemorySpace
+     */
+    template<typename MemorySpace2>
+    struct rebind { typedef cusp::bsr_matrix<IndexType, ValueType, MemorySpace2> type; };
+
+    /*! type of block row offsets array
+     */
+    typedef typename cusp::array1d<IndexType, MemorySpace> row_offsets_array_type;
+
+    /*! type of block column indices array
+     */
+    typedef typename cusp::array1d<IndexType, MemorySpace> column_indices_array_type;
+
+    /*! type of values array
+     */
+    typedef typename cusp::array1d<ValueType, MemorySpace> values_array_type;
+
+    /*! equivalent container type
+     */
+    typedef typename cusp::bsr_matrix<IndexType, ValueType, MemorySpace> container;
+
+    /*! Number of rows and columns of each block.
+     */
+    size_t block_size;
+
+    /*! Storage for the offsets of the block rows.
+     */
+    row_offsets_array_type row_offsets;
+
+    /*! Storage for the column indices of the blocks.
+     */
+    column_indices_array_type column_indices;
+
+    /*! Storage for the entries of the blocks.
+     */
+    values_array_type values;
+
+    /*! Construct an empty \p bsr_matrix.
+     */
+    bsr_matrix()
+      : block_size(1) {}
+
+    /*! Construct a \p bsr_matrix with a specific shape and number of blocks.
+     *
+     *  \param num_rows Number of rows.
+     *  \param num_cols Number of columns.
+     *  \param num_blocks Number of nonzero blocks.
+     *  \param block_size Number of rows and columns of each block.
+     */
+    bsr_matrix(size_t num_rows, size_t num_cols, size_t num_blocks, size_t block_size)
+      : Parent(num_rows, num_cols, num_blocks * block_size * block_size),
+        block_size(block_size),
+        row_offsets(num_rows / block_size + 1),
+        column_indices(num_blocks),
+        values(num_blocks * block_size * block_size) {}
+
+    /*! Construct a \p bsr_matrix from another matrix.
+     *
+     *  \param matrix Another sparse or dense matrix.
+     */
+    template <typename MatrixType>
+    bsr_matrix(const MatrixType& matrix);
+
+    /*! Construct a \p bsr_matrix from another matrix with the given block size.
+     *
+     *  \param matrix Another sparse or dense matrix.
+     *  \param block_size Number of rows and columns of each block.
+     */
+    template <typename MatrixType>
+    bsr_matrix(const MatrixType& matrix, size_t block_size);
+
+    /*! Number of block rows.
+     */
+    size_t num_block_rows(void) const
+    {
+      return row_offsets.size() == 0 ? 0 : row_offsets.size() - 1;
+    }
+
+    /*! Number of nonzero blocks.
+     */
+    size_t num_blocks(void) const
+    {
+      return column_indices.size();
+    }
+
+    /*! Resize matrix dimensions and underlying storage
+     */
+    void resize(size_t num_rows, size_t num_cols, size_t num_blocks)
+    {
+      Parent::resize(num_rows, num_cols, num_blocks * block_size * block_size);
+      row_offsets.resize(num_rows / block_size + 1);
+      column_indices.resize(num_blocks);
+      values.resize(num_blocks * block_size * block_size);
+    }
+
+    /*! Resize matrix dimensions, block size and underlying storage
+     */
+    void resize(size_t num_rows, size_t num_cols, size_t num_blocks, size_t block_size)
+    {
+      this->block_size = block_size;
+      resize(num_rows, num_cols, num_blocks);
+    }
+
+    /*! Swap the contents of two \p bsr_matrix objects.
+     *
+     *  \param matrix Another \p bsr_matrix with the same IndexType and ValueType.
+     */
+    void swap(bsr_matrix& matrix)
+    {
+      Parent::swap(matrix);
+      thrust::swap(block_size, matrix.block_size);
+      row_offsets.swap(matrix.row_offsets);
+      column_indices.swap(matrix.column_indices);
+      values.swap(matrix.values);
+    }
+
+    /*! Assignment from another matrix.
+     *
+     *  \param matrix Another sparse or dense matrix.
+     */
+    template <typename MatrixType>
+    bsr_matrix& operator=(const MatrixType& matrix);
+}; // class bsr_matrix
+/*! \}
+ */
+
+} // end namespace cusp
+
+#include <cusp/detail/bsr_matrix.inl>
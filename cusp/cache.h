@@ -0,0 +1,212 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+/*! \file cache.h
+ *  \brief Select how device SpMV kernels read the input vector
+ */
+
+#pragma once
+
+#include <cusp/detail/config.h>
+
+#include <cusp/detail/mutex.h>
+
+#include <cusp/detail/device/l2_persistence.h>
+
+namespace cusp
+{
+
+/*! \addtogroup execution Execution
+ *  \{
+ */
+
+/*! \p spmv_cache_mode : How the device SpMV kernels read the vector \c x
+ *  in <tt>y = A * x</tt>.
+ */
+enum spmv_cache_mode
+{
+    /*! Load \c x through the read-only data cache (\c __ldg) on devices of
+     *  compute capability 3.5 and newer.  On older devices the CSR vector
+     *  and ELL kernels read \c x through a texture, the other kernels with
+     *  plain loads.
+     */
+    read_only_cache,
+
+    /*! Read \c x through a texture object created for each multiply.  Falls
+     *  back to \p read_only_cache when the vector is not aligned for texture
+     *  fetches or is longer than a linear texture can address.
+     */
+    texture_cache
+};
+
+namespace detail
+{
+namespace device
+{
+
+// kept per host thread, like the current stream
+inline cusp::spmv_cache_mode& current_spmv_cache_storage(void)
+{
+    static __CUSP_THREAD_LOCAL cusp::spmv_cache_mode mode = cusp::read_only_cache;
+    return mode;
+}
+
+inline bool& current_l2_persistence_storage(void)
+{
+    static __CUSP_THREAD_LOCAL bool enabled = false;
+    return enabled;
+}
+
+} // end namespace device
+} // end namespace detail
+
+/*! \p spmv_cache_scope : Selects the \p spmv_cache_mode of the device SpMV
+ *  kernels issued while the scope is alive.
+ *
+ * The cache state belongs to each launch rather than to a global texture
+ * reference, so SpMVs issued concurrently on different streams do not
+ * contend for a binding.  Scopes may be nested; the previous mode is
+ * restored when the scope is destroyed.
+ *
+ * \note Like the current stream, the mode is kept per host thread, so a
+ * scope only affects the SpMVs issued by the thread which opened it.
+ *
+ *  \code
+ *  #include <cusp/cache.h>
+ *  #include <cusp/csr_matrix.h>
+ *  #include <cusp/multiply.h>
+ *  ...
+ *
+ *  {
+ *      cusp::spmv_cache_scope scope(cusp::texture_cache);
+ *      cusp::multiply(A, x, y);
+ *  }
+ *  \endcode
+ */
+class spmv_cache_scope
+{
+    public:
+    /*! Use \p mode for subsequent device SpMVs
+     */
+    explicit spmv_cache_scope(cusp::spmv_cache_mode mode)
+        : previous(cusp::detail::device::current_spmv_cache_storage())
+    {
+        cusp::detail::device::current_spmv_cache_storage() = mode;
+    }
+
+    /*! Restore the previously active mode
+     */
+    ~spmv_cache_scope(void)
+    {
+        cusp::detail::device::current_spmv_cache_storage() = previous;
+    }
+
+    private:
+    cusp::spmv_cache_mode previous;
+
+    // non-copyable
+    spmv_cache_scope(const spmv_cache_scope&);
+    spmv_cache_scope& operator=(const spmv_cache_scope&);
+};
+
+/*! \p current_spmv_cache_mode : mode currently used by the device SpMV kernels
+ */
+inline cusp::spmv_cache_mode current_spmv_cache_mode(void)
+{
+    return cusp::detail::device::current_spmv_cache_storage();
+}
+
+/*! \p l2_persistence_scope : Keeps the vector \c x of the device SpMVs
+ *  issued while the scope is alive persistent in the L2 cache.
+ *
+ * An SpMV streams the matrix through the cache once but reads \c x many
+ * times, at random for unstructured matrices, so the entries of \c x are
+ * easily evicted by the matrix between two uses.  On devices of compute
+ * capability 8.0 and newer (with CUDA 11) the scope sets aside as much of
+ * the L2 cache for persisting accesses as the device allows, and each
+ * SpMV sets the access policy window of the current stream to \c x for
+ * its kernels.  When \c x is larger than the set-aside, a fraction of it
+ * of the size of the set-aside is kept.  Open the scope around a Krylov
+ * solver to cover all of its products.
+ *
+ * The window replaces any window of the current stream and is cleared
+ * after each SpMV.  On older devices, older toolkits or streams which do
+ * not accept the attribute the scope has no effect.
+ *
+ * \note The set-aside belongs to the device and is restored when the
+ * outermost scope of a thread is destroyed; the window only affects the
+ * SpMVs issued by the thread which opened the scope.
+ *
+ *  \code
+ *  #include <cusp/cache.h>
+ *  #include <cusp/krylov/cg.h>
+ *  ...
+ *
+ *  {
+ *      cusp::l2_persistence_scope scope;
+ *      cusp::krylov::cg(A, x, b, monitor);
+ *  }
+ *  \endcode
+ */
+class l2_persistence_scope
+{
+    public:
+    /*! Keep \c x persistent in subsequent device SpMVs, or stop doing so
+     *  inside an enclosing scope when \p enable is false
+     */
+    explicit l2_persistence_scope(bool enable = true)
+        : previous(cusp::detail::device::current_l2_persistence_storage()),
+          reserved(enable && !previous), previous_set_aside(0)
+    {
+        if (reserved)
+            previous_set_aside = cusp::detail::device::l2_persistence_reserve();
+
+        cusp::detail::device::current_l2_persistence_storage() = enable;
+    }
+
+    /*! Restore the previous state
+     */
+    ~l2_persistence_scope(void)
+    {
+        if (reserved)
+            cusp::detail::device::l2_persistence_release(previous_set_aside);
+
+        cusp::detail::device::current_l2_persistence_storage() = previous;
+    }
+
+    private:
+    bool previous;
+    bool reserved;
+    size_t previous_set_aside;
+
+    // non-copyable
+    l2_persistence_scope(const l2_persistence_scope&);
+    l2_persistence_scope& operator=(const l2_persistence_scope&);
+};
+
+/*! \p l2_persistence_enabled : whether the device SpMVs currently keep
+ *  \c x persistent in the L2 cache
+ */
+inline bool l2_persistence_enabled(void)
+{
+    return cusp::detail::device::current_l2_persistence_storage();
+}
+
+/*! \}
+ */
+
+} // end namespace cusp
@@ -0,0 +1,276 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*! \file composite_operator.h
+ *  \brief Lazy sums, products and scalings of linear operators
+ */
+
+#pragma once
+
+#include <cusp/detail/config.h>
+
+#include <cusp/array1d.h>
+#include <cusp/linear_operator.h>
+
+namespace cusp
+{
+
+template <typename Operator1, typename Operator2> class sum_operator;
+template <typename Operator1, typename Operator2> class product_operator;
+template <typename Operator>                      class scaled_operator;
+
+namespace detail
+{
+
+// Matrices and user operators are held by reference, as by
+// transposed_operator, while the composite operators and the identity are
+// small and held by value, so nested expressions do not refer to temporaries.
+template <typename Operator>
+struct composite_operand
+{
+    typedef const Operator& type;
+};
+
+template <typename Operator1, typename Operator2>
+struct composite_operand< cusp::sum_operator<Operator1,Operator2> >
+{
+    typedef cusp::sum_operator<Operator1,Operator2> type;
+};
+
+template <typename Operator1, typename Operator2>
+struct composite_operand< cusp::product_operator<Operator1,Operator2> >
+{
+    typedef cusp::product_operator<Operator1,Operator2> type;
+};
+
+template <typename Operator>
+struct composite_operand< cusp::scaled_operator<Operator> >
+{
+    typedef cusp::scaled_operator<Operator> type;
+};
+
+template <typename ValueType, typename MemorySpace, typename IndexType>
+struct composite_operand< cusp::identity_operator<ValueType,MemorySpace,IndexType> >
+{
+    typedef cusp::identity_operator<ValueType,MemorySpace,IndexType> type;
+};
+
+} // end namespace detail
+
+/*! \addtogroup algorithms Algorithms
+ *  \ingroup algorithms
+ *  \{
+ */
+
+/*! \p sum_operator : the linear operator <tt>alpha * A + beta * B</tt>
+ *
+ *  Applying the operator computes <tt>y = alpha * A * x + beta * B * x</tt>
+ *  without forming the sum.  When \p B is a COO, CSR, DIA, ELL or HYB
+ *  matrix the second product is accumulated into \c y by
+ *  \p generalized_multiply, when it is an \p identity_operator by an
+ *  \c axpy, and otherwise through a work vector.  Likewise the scaling by
+ *  \p alpha is fused into the first product for those formats.
+ *
+ *  Matrices and user-defined operators are referred to and must outlive
+ *  the sum, while nested composite operators are copied.  The operators
+ *  are usually built by \p make_sum and \p make_shifted.
+ *
+ *  \tparam Operator1 type of \c A
+ *  \tparam Operator2 type of \c B
+ */
+template <typename Operator1, typename Operator2>
+class sum_operator
+  : public cusp::linear_operator<typename Operator1::value_type,
+                                 typename Operator1::memory_space,
+                                 typename Operator1::index_type>
+{
+    typedef cusp::linear_operator<typename Operator1::value_type,
+                                  typename Operator1::memory_space,
+                                  typename Operator1::index_type> Parent;
+  public:
+    typedef typename Operator1::value_type   value_type;
+    typedef typename Operator1::memory_space memory_space;
+
+    typename detail::composite_operand<Operator1>::type A;
+    typename detail::composite_operand<Operator2>::type B;
+
+    value_type alpha;
+    value_type beta;
+
+    /*! Construct <tt>alpha * A + beta * B</tt>.
+     *
+     *  \throws cusp::invalid_input_exception if the shapes of \p A and \p B differ
+     */
+    sum_operator(const Operator1& A, const Operator2& B,
+                 value_type alpha = value_type(1), value_type beta = value_type(1));
+
+    /*! Compute <tt>y = alpha * A * x + beta * B * x</tt>.
+     */
+    template <typename VectorType1, typename VectorType2>
+    void operator()(const VectorType1& x, VectorType2& y) const;
+
+  private:
+    mutable cusp::array1d<value_type, memory_space> work;
+}; // class sum_operator
+
+/*! \p product_operator : the linear operator <tt>A * B</tt>
+ *
+ *  Applying the operator computes <tt>y = A * (B * x)</tt> through a work
+ *  vector of the size of <tt>B * x</tt>, kept between applications, so
+ *  products such as the Schur complement <tt>C - B^T A^{-1} B</tt> can be
+ *  applied inside a Krylov solver without forming them.
+ *
+ *  Matrices and user-defined operators are referred to and must outlive
+ *  the product, while nested composite operators are copied.
+ *
+ *  \tparam Operator1 type of \c A
+ *  \tparam Operator2 type of \c B
+ */
+template <typename Operator1, typename Operator2>
+class product_operator
+  : public cusp::linear_operator<typename Operator1::value_type,
+                                 typename Operator1::memory_space,
+                                 typename Operator1::index_type>
+{
+    typedef cusp::linear_operator<typename Operator1::value_type,
+                                  typename Operator1::memory_space,
+                                  typename Operator1::index_type> Parent;
+  public:
+    typedef typename Operator1::value_type   value_type;
+    typedef typename Operator1::memory_space memory_space;
+
+    typename detail::composite_operand<Operator1>::type A;
+    typename detail::composite_operand<Operator2>::type B;
+
+    /*! Construct <tt>A * B</tt>.
+     *
+     *  \throws cusp::invalid_input_exception if the columns of \p A do not
+     *          match the rows of \p B
+     */
+    product_operator(const Operator1& A, const Operator2& B);
+
+    /*! Compute <tt>y = A * (B * x)</tt>.
+     */
+    template <typename VectorType1, typename VectorType2>
+    void operator()(const VectorType1& x, VectorType2& y) const;
+
+  private:
+    mutable cusp::array1d<value_type, memory_space> work;
+}; // class product_operator
+
+/*! \p scaled_operator : the linear operator <tt>alpha * A</tt>
+ *
+ *  The scaling is fused into the product for COO, CSR, DIA, ELL and HYB
+ *  matrices and applied to the result otherwise.
+ *
+ *  \tparam Operator type of \c A
+ */
+template <typename Operator>
+class scaled_operator
+  : public cusp::linear_operator<typename Operator::value_type,
+                                 typename Operator::memory_space,
+                                 typename Operator::index_type>
+{
+    typedef cusp::linear_operator<typename Operator::value_type,
+                                  typename Operator::memory_space,
+                                  typename Operator::index_type> Parent;
+  public:
+    typedef typename Operator::value_type value_type;
+
+    typename detail::composite_operand<Operator>::type A;
+
+    value_type alpha;
+
+    /*! Construct <tt>alpha * A</tt>.
+     */
+    scaled_operator(value_type alpha, const Operator& A);
+
+    /*! Compute <tt>y = alpha * A * x</tt>.
+     */
+    template <typename VectorType1, typename VectorType2>
+    void operator()(const VectorType1& x, VectorType2& y) const;
+}; // class scaled_operator
+
+/*! \p make_sum : the operator <tt>A + B</tt>
+ *
+ *  \code
+ *  #include <cusp/composite_operator.h>
+ *  #include <cusp/krylov/gmres.h>
+ *  ...
+ *
+ *  // solve (A - sigma M) x = b without forming A - sigma M
+ *  cusp::sum_operator<Matrix,Matrix> S = cusp::make_shifted(A, sigma, M);
+ *  cusp::krylov::gmres(S, x, b, 30, monitor);
+ *
+ *  // apply the Schur complement D - C B, with B and C sparse
+ *  cusp::make_sum(D, cusp::make_scaled(-1.0f, cusp::make_product(C, B)))(x, y);
+ *  \endcode
+ */
+template <typename Operator1, typename Operator2>
+sum_operator<Operator1,Operator2>
+make_sum(const Operator1& A, const Operator2& B)
+{
+    return sum_operator<Operator1,Operator2>(A, B);
+}
+
+/*! \p make_product : the operator <tt>A * B</tt>
+ */
+template <typename Operator1, typename Operator2>
+product_operator<Operator1,Operator2>
+make_product(const Operator1& A, const Operator2& B)
+{
+    return product_operator<Operator1,Operator2>(A, B);
+}
+
+/*! \p make_scaled : the operator <tt>alpha * A</tt>
+ */
+template <typename ValueType, typename Operator>
+scaled_operator<Operator>
+make_scaled(const ValueType alpha, const Operator& A)
+{
+    return scaled_operator<Operator>(typename Operator::value_type(alpha), A);
+}
+
+/*! \p make_shifted : the operator <tt>A - sigma * M</tt>
+ */
+template <typename Operator1, typename ValueType, typename Operator2>
+sum_operator<Operator1,Operator2>
+make_shifted(const Operator1& A, const ValueType sigma, const Operator2& M)
+{
+    typedef typename Operator1::value_type value_type;
+    return sum_operator<Operator1,Operator2>(A, M, value_type(1), -value_type(sigma));
+}
+
+/*! \p make_shifted : the operator <tt>A - sigma * I</tt>
+ */
+template <typename Operator, typename ValueType>
+sum_operator<Operator, cusp::identity_operator<typename Operator::value_type,
+                                               typename Operator::memory_space,
+                                               typename Operator::index_type> >
+make_shifted(const Operator& A, const ValueType sigma)
+{
+    typedef cusp::identity_operator<typename Operator::value_type,
+                                    typename Operator::memory_space,
+                                    typename Operator::index_type> Identity;
+
+    return make_shifted(A, sigma, Identity(A.num_rows, A.num_cols));
+}
+/*! \}
+ */
+
+} // end namespace cusp
+
+#include <cusp/detail/composite_operator.inl>
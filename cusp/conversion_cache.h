@@ -0,0 +1,197 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+/*! \file conversion_cache.h
+ *  \brief Reuse the format conversions of operations on mixed formats
+ */
+
+#pragma once
+
+#include <cusp/detail/config.h>
+
+#include <cusp/detail/mutex.h>
+
+#include <map>
+#include <utility>
+
+namespace cusp
+{
+
+/*! \addtogroup execution Execution
+ *  \{
+ */
+
+/*! \p conversion_cache : Keeps the temporary conversions made by
+ *  operations on matrices of different formats.
+ *
+ * Operations without a kernel for their combination of formats convert
+ * their operands first: \p multiply and \p galerkin_product of sparse
+ * matrices go through CSR, and \p add and \p subtract through COO on the
+ * device and CSR on the host.  While a \p conversion_cache_scope is open
+ * these conversions are stored in the cache, attached to the address of
+ * the source matrix, and later operations on the same source reuse them.
+ * Operands which already are in the required format are never copied,
+ * with or without a cache.
+ *
+ * A conversion is reused as long as the source keeps its dimensions, its
+ * number of entries and its storage; a resized or reallocated source is
+ * converted again.  Changing the entries of a source in place is not
+ * detected: call \p touch, which bumps the version of the source and
+ * drops its conversions, or \p clear.  The cache holds a copy of every
+ * converted source, so it doubles their storage until it is destroyed.
+ *
+ * \note Like the scopes of \p cache.h the active cache is kept per host
+ * thread.  A cache must not be used by two threads at once.
+ *
+ *  \code
+ *  #include <cusp/conversion_cache.h>
+ *  #include <cusp/multiply.h>
+ *  ...
+ *
+ *  cusp::conversion_cache cache;
+ *  {
+ *      cusp::conversion_cache_scope scope(cache);
+ *
+ *      for (int k = 0; k < 100; k++)
+ *          cusp::multiply(A_csr, B_hyb, C);   // B_hyb is converted once
+ *  }
+ *
+ *  // after changing the values of B_hyb in place
+ *  cache.touch(B_hyb);
+ *  \endcode
+ */
+class conversion_cache
+{
+    public:
+    conversion_cache(void) : num_hits(0), num_misses(0) {}
+
+    ~conversion_cache(void) { clear(); }
+
+    /*! Bump the version of \p A and drop its conversions, after its
+     *  entries were changed in place
+     */
+    template <typename MatrixType>
+    void touch(const MatrixType& A);
+
+    /*! Number of times \p touch was called for \p A
+     */
+    template <typename MatrixType>
+    size_t version(const MatrixType& A) const;
+
+    /*! Drop every conversion
+     */
+    void clear(void);
+
+    /*! Number of conversions held
+     */
+    size_t size(void) const { return entries.size(); }
+
+    /*! Number of conversions reused and made since construction
+     */
+    size_t hits(void) const   { return num_hits; }
+    size_t misses(void) const { return num_misses; }
+
+    /*! Conversion of \p src to \c DestinationType, made and stored if not
+     *  held or stale.  The reference is valid until the conversion is
+     *  dropped.
+     */
+    template <typename DestinationType, typename SourceType>
+    const DestinationType& get(const SourceType& src);
+
+    private:
+    struct entry
+    {
+        size_t version;
+        size_t num_rows, num_cols, num_entries;
+        const void * storage;
+
+        virtual ~entry(void) {}
+    };
+
+    template <typename MatrixType>
+    struct holder : public entry
+    {
+        MatrixType matrix;
+    };
+
+    // (source, destination type)
+    typedef std::pair<const void *, const void *> key_type;
+
+    std::map<key_type, entry *> entries;
+    std::map<const void *, size_t> versions;
+
+    size_t num_hits;
+    size_t num_misses;
+
+    void drop(const void * src);
+
+    // non-copyable
+    conversion_cache(const conversion_cache&);
+    conversion_cache& operator=(const conversion_cache&);
+};
+
+namespace detail
+{
+
+// kept per host thread, like the current stream
+inline cusp::conversion_cache *& current_conversion_cache_storage(void)
+{
+    static __CUSP_THREAD_LOCAL cusp::conversion_cache * cache = NULL;
+    return cache;
+}
+
+} // end namespace detail
+
+/*! \p conversion_cache_scope : Stores the conversions of the operations
+ *  issued while the scope is alive in \p cache.  Scopes may be nested;
+ *  the previous cache is restored when the scope is destroyed.
+ */
+class conversion_cache_scope
+{
+    public:
+    explicit conversion_cache_scope(cusp::conversion_cache& cache)
+        : previous(cusp::detail::current_conversion_cache_storage())
+    {
+        cusp::detail::current_conversion_cache_storage() = &cache;
+    }
+
+    ~conversion_cache_scope(void)
+    {
+        cusp::detail::current_conversion_cache_storage() = previous;
+    }
+
+    private:
+    cusp::conversion_cache * previous;
+
+    // non-copyable
+    conversion_cache_scope(const conversion_cache_scope&);
+    conversion_cache_scope& operator=(const conversion_cache_scope&);
+};
+
+/*! \p current_conversion_cache : cache of the current scope, or \c NULL
+ */
+inline cusp::conversion_cache * current_conversion_cache(void)
+{
+    return cusp::detail::current_conversion_cache_storage();
+}
+
+/*! \}
+ */
+
+} // end namespace cusp
+
+#include <cusp/detail/conversion_cache.inl>
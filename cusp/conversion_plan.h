@@ -0,0 +1,170 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*! \file conversion_plan.h
+ *  \brief Cost model driven choice of the sparse matrix format
+ */
+
+#pragma once
+
+#include <cusp/detail/config.h>
+
+#include <cstddef>
+
+namespace cusp
+{
+
+/*! \addtogroup algorithms Algorithms
+ *  \ingroup algorithms
+ *  \{
+ */
+
+/*! \p conversion_plan_options : Parameters of the SpMV cost model.
+ */
+struct conversion_plan_options
+{
+    float  bandwidth;        // sustained memory bandwidth in GB/s
+    float  launch_latency;   // cost of one kernel launch in seconds
+    size_t alignment;        // row alignment of the DIA, ELL and HYB formats
+
+    conversion_plan_options()
+      : bandwidth(150.0f), launch_latency(5e-6f), alignment(32) {}
+};
+
+/*! \p conversion_plan : Sizes, fill and SpMV cost of every candidate
+ *  format of a matrix, as computed by \p plan_conversion.
+ *
+ *  The cost of a format is the number of bytes one SpMV moves: the arrays
+ *  of the format, including padding, one read of x per entry and one write
+ *  of y per row.  Its estimated time is the cost divided by
+ *  \p conversion_plan_options::bandwidth plus the launch latency of each
+ *  kernel.  The ELL width of the HYB format is the one of least estimated
+ *  time, so widths 0 and \p max_entries_per_row stand for pure COO and ELL.
+ *
+ *  A plan replaces the \p max_fill and \p relative_speed heuristics of
+ *  \p convert: \p format names the cheapest candidate, the fill of DIA and
+ *  ELL is reported instead of throwing \p format_conversion_exception and
+ *  the plan is executed later by the \p convert overload which accepts it.
+ *
+ *  \code
+ *  #include <cusp/conversion_plan.h>
+ *  #include <cusp/csr_matrix.h>
+ *  #include <cusp/dia_matrix.h>
+ *  #include <cusp/hyb_matrix.h>
+ *  ...
+ *
+ *  cusp::csr_matrix<int,float,cusp::device_memory> A = ...;
+ *
+ *  cusp::conversion_plan plan = cusp::plan_conversion(A);
+ *
+ *  if (plan.format == cusp::conversion_plan::dia)
+ *  {
+ *      cusp::dia_matrix<int,float,cusp::device_memory> B;
+ *      cusp::convert(A, B, plan);
+ *      ...
+ *  }
+ *  else
+ *  {
+ *      cusp::hyb_matrix<int,float,cusp::device_memory> B;
+ *      cusp::convert(A, B, plan);
+ *      ...
+ *  }
+ *  \endcode
+ */
+struct conversion_plan
+{
+    enum format_type { coo = 0, csr = 1, dia = 2, ell = 3, hyb = 4 };
+
+    static const size_t num_formats = 5;
+
+    size_t num_rows;
+    size_t num_cols;
+    size_t num_entries;
+
+    size_t alignment;               // row alignment used for the sizes below
+    size_t num_diagonals;           // number of occupied diagonals
+    size_t max_entries_per_row;     // ELL width
+    size_t hyb_entries_per_row;     // ELL width of the HYB part
+    size_t hyb_coo_entries;         // entries in the COO part of HYB
+
+    float dia_fill;                 // stored DIA values per entry
+    float ell_fill;                 // stored ELL values per entry
+
+    size_t bytes[num_formats];      // bytes moved by one SpMV
+    double seconds[num_formats];    // estimated time of one SpMV
+
+    format_type format;             // candidate of least estimated time
+
+    conversion_plan()
+      : num_rows(0), num_cols(0), num_entries(0), alignment(32),
+        num_diagonals(0), max_entries_per_row(0),
+        hyb_entries_per_row(0), hyb_coo_entries(0),
+        dia_fill(0), ell_fill(0), format(csr)
+    {
+        for (size_t i = 0; i < num_formats; i++)
+        {
+            bytes[i]   = 0;
+            seconds[i] = 0;
+        }
+    }
+
+    /*! Name of \p format, e.g. "hyb".
+     */
+    const char * format_name(void) const
+    {
+        static const char * names[num_formats] = { "coo", "csr", "dia", "ell", "hyb" };
+        return names[format];
+    }
+};
+
+/*! \p plan_conversion : Computes the \p conversion_plan of a matrix.
+ *
+ *  The row lengths and diagonal offsets are analyzed in the memory space
+ *  of \p A, so device matrices are planned with a few passes on the device
+ *  and without converting them.
+ *
+ * \param A \p coo_matrix or \p csr_matrix
+ * \param options parameters of the cost model
+ */
+template <typename MatrixType>
+cusp::conversion_plan
+plan_conversion(const MatrixType& A,
+                const cusp::conversion_plan_options& options = cusp::conversion_plan_options());
+
+/*! \p convert : Convert between matrix formats with the parameters of a plan.
+ *
+ *  DIA destinations use the planned alignment and are built whatever
+ *  their fill, ELL destinations the width \p max_entries_per_row and HYB
+ *  destinations the width \p hyb_entries_per_row.  Other formats are
+ *  converted as usual.
+ *
+ * \param src \p coo_matrix or \p csr_matrix the plan was computed for
+ * \param dst destination matrix, resized as necessary
+ * \param plan plan of \p src
+ *
+ * \throws cusp::invalid_input_exception if the dimensions of \p src do not match \p plan
+ */
+template <typename SourceType, typename DestinationType>
+void convert(const SourceType& src, DestinationType& dst,
+             const cusp::conversion_plan& plan);
+
+/*! \}
+ */
+
+} // end namespace cusp
+
+#include <cusp/detail/conversion_plan.inl>
+
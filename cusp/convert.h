@@ -22,6 +22,13 @@
 
 #include <cusp/detail/config.h>
 
+#include <cusp/array1d.h>
+
+#include <thrust/device_ptr.h>
+
+#include <algorithm>
+#include <deque>
+
 namespace cusp
 {
 
@@ -30,6 +37,92 @@ namespace cusp
  *  \{
  */
 
+/*! \p convert_workspace : Temporary storage shared by successive conversions
+ *
+ * Format conversions need temporary index and value arrays as large as
+ * the matrix.  When a \p convert_workspace is passed to \p convert these
+ * arrays are taken from the workspace and remain allocated afterwards, so
+ * repeated conversions of matrices of similar size perform no temporary
+ * allocations after the first one.  The storage is untyped and may be
+ * shared by conversions of matrices with different index and value types.
+ *
+ * \tparam MemorySpace memory space of the temporary arrays
+ *
+ *  \code
+ *  #include <cusp/convert.h>
+ *  #include <cusp/coo_matrix.h>
+ *  #include <cusp/hyb_matrix.h>
+ *
+ *  int main(void)
+ *  {
+ *      cusp::convert_workspace<cusp::device_memory> workspace;
+ *
+ *      for (int step = 0; step < 100; step++)
+ *      {
+ *          cusp::coo_matrix<int, float, cusp::device_memory> A;
+ *          // assemble A ...
+ *
+ *          cusp::hyb_matrix<int, float, cusp::device_memory> B;
+ *          cusp::convert(A, B, workspace);
+ *      }
+ *
+ *      return 0;
+ *  }
+ *  \endcode
+ */
+template <typename MemorySpace>
+class convert_workspace
+{
+    template <typename T, typename Space>
+    struct pointer_type { typedef thrust::device_ptr<T> type; };
+
+    template <typename T>
+    struct pointer_type<T, cusp::host_memory> { typedef T * type; };
+
+    public:
+    typedef MemorySpace memory_space;
+
+    /*! Type of the temporary arrays with elements of type \p T
+     */
+    template <typename T>
+    struct view
+    {
+        typedef cusp::array1d_view<typename pointer_type<T,MemorySpace>::type> type;
+    };
+
+    /*! Return the \p i-th temporary array as \p N elements of type \p T.
+     *  Storage is only reallocated when it is smaller than \p N elements.
+     *  The contents are unspecified.
+     */
+    template <typename T>
+    typename view<T>::type array(size_t i, size_t N)
+    {
+        typedef typename pointer_type<T,MemorySpace>::type Pointer;
+
+        // std::deque keeps references to existing elements valid
+        while (buffers.size() <= i)
+            buffers.push_back(buffer_type());
+
+        buffers[i].resize(std::max(buffers[i].size(), std::max<size_t>(1, N * sizeof(T))));
+
+        Pointer first(reinterpret_cast<T *>(thrust::raw_pointer_cast(&buffers[i][0])));
+
+        return typename view<T>::type(first, first + N);
+    }
+
+    /*! Free all temporary arrays
+     */
+    void release(void)
+    {
+        buffers.clear();
+    }
+
+    private:
+    typedef cusp::array1d<char,MemorySpace> buffer_type;
+
+    std::deque<buffer_type> buffers;
+};
+
 /*! \p copy : Convert between matrix formats
  *
  * \note DestinationType will be resized as necessary
@@ -39,6 +132,37 @@ namespace cusp
 template <typename SourceType, typename DestinationType>
 void convert(const SourceType& src, DestinationType& dst);
 
+/*! \p convert : Convert between matrix formats with temporary arrays
+ *  drawn from \p workspace
+ *
+ * Conversions between device matrices take their temporary index and
+ * value arrays, including the intermediate \p coo_matrix of conversions
+ * without a direct path, from \p workspace.  Conversions across memory
+ * spaces and on the host ignore it.
+ *
+ * \see \p convert_workspace
+ */
+template <typename SourceType, typename DestinationType, typename MemorySpace>
+void convert(const SourceType& src, DestinationType& dst,
+             cusp::convert_workspace<MemorySpace>& workspace);
+
+/*! \p convert_in_place : Convert between matrix formats and release \p src
+ *
+ * Arrays shared by both formats are moved from \p src to \p dst instead
+ * of being copied.  Between \p csr_matrix and \p coo_matrix containers of
+ * the same index type, value type and memory space, only the row offsets
+ * or row indices are computed, so the conversion needs memory for one
+ * extra index array instead of a second matrix.  Other formats are
+ * converted with \p convert.  In both cases \p src is left empty and its
+ * storage is freed.  As for \p convert, the entries of a \p coo_matrix
+ * source must be sorted by row.
+ *
+ * \tparam SourceType matrix container
+ * \tparam DestinationType matrix container
+ */
+template <typename SourceType, typename DestinationType>
+void convert_in_place(SourceType& src, DestinationType& dst);
+
 /*! \}
  */
 
@@ -338,6 +338,54 @@ make_coo_matrix_view(const coo_matrix_view<Array1,Array2,Array3,IndexType,ValueT
   return coo_matrix_view<Array1,Array2,Array3,IndexType,ValueType,MemorySpace>(m);
 }
     
+/*! \p make_coo_matrix_view : View a COO matrix whose row indices, column
+ *  indices and values are stored in external buffers in \p MemorySpace
+ *  (e.g. arrays allocated with \c cudaMalloc by another library).
+ *
+ *  Nothing is copied.  With non-const pointers the result has the type of
+ *  \p coo_matrix<IndexType,ValueType,MemorySpace>::view, and with const
+ *  pointers that of its \p const_view, so it may be passed to
+ *  \p cusp::multiply, the solvers and the preconditioners like a view of a
+ *  \p coo_matrix.
+ *
+ *  \code
+ *  // d_row_indices, d_column_indices and d_values are device pointers
+ *  cusp::coo_matrix<int,float,cusp::device_memory>::view A =
+ *      cusp::make_coo_matrix_view(num_rows, num_cols, num_entries,
+ *                                 d_row_indices, d_column_indices, d_values,
+ *                                 cusp::device_memory());
+ *  \endcode
+ */
+template <typename IndexType, typename ValueType, class MemorySpace>
+coo_matrix_view<typename cusp::detail::raw_array1d_view<IndexType,MemorySpace>::type,
+                typename cusp::detail::raw_array1d_view<IndexType,MemorySpace>::type,
+                typename cusp::detail::raw_array1d_view<ValueType,MemorySpace>::type,
+                typename cusp::detail::raw_array1d_view<IndexType,MemorySpace>::value_type,
+                typename cusp::detail::raw_array1d_view<ValueType,MemorySpace>::value_type,
+                MemorySpace>
+make_coo_matrix_view(size_t num_rows,
+                     size_t num_cols,
+                     size_t num_entries,
+                     IndexType * row_indices,
+                     IndexType * column_indices,
+                     ValueType * values,
+                     MemorySpace)
+{
+  typedef cusp::detail::raw_array1d_view<IndexType,MemorySpace> IndexView;
+  typedef cusp::detail::raw_array1d_view<ValueType,MemorySpace> ValueView;
+
+  return coo_matrix_view<typename IndexView::type,
+                         typename IndexView::type,
+                         typename ValueView::type,
+                         typename IndexView::value_type,
+                         typename ValueView::value_type,
+                         MemorySpace>
+    (num_rows, num_cols, num_entries,
+     IndexView::make(row_indices, num_entries),
+     IndexView::make(column_indices, num_entries),
+     ValueView::make(values, num_entries));
+}
+
 template <typename IndexType, typename ValueType, class MemorySpace>
 typename coo_matrix<IndexType,ValueType,MemorySpace>::view
 make_coo_matrix_view(coo_matrix<IndexType,ValueType,MemorySpace>& m)
@@ -34,6 +34,10 @@ namespace cusp
  *
  * \note T1 and T2 must have the same format type
  * \note T2 will be resized as necessary
+ * \note Large arrays are transferred between host and device memory
+ *       through a pool of page-locked staging buffers.  Uploads return
+ *       before the transfer completes; later work on the current stream
+ *       (see \p stream_scope) is ordered after it.
  *
  * \see \p convert
  */
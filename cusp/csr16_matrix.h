@@ -0,0 +1,187 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+/*! \file csr16_matrix.h
+ *  \brief Compressed Sparse Row matrix format with 16-bit column offsets.
+ */
+
+#pragma once
+
+#include <cusp/detail/config.h>
+
+#include <cusp/array1d.h>
+#include <cusp/format.h>
+#include <cusp/memory.h>
+#include <cusp/detail/matrix_base.h>
+
+namespace cusp
+{
+
+/*! \addtogroup sparse_matrices Sparse Matrices
+ */
+
+/*! \addtogroup sparse_matrix_containers Sparse Matrix Containers
+ *  \ingroup sparse_matrices
+ *  \{
+ */
+
+/*! \p csr16_matrix : Compressed Sparse Row matrix container with 16-bit
+ *  column offsets
+ *
+ * The column of each entry is stored as a signed 16-bit offset from its
+ * row, so entry \c n of row \c i lies in column <tt>i + column_offsets[n]</tt>.
+ * For matrices whose bandwidth is below 32768 this halves the index storage
+ * of a \p csr_matrix with \c int indices, and the SpMV kernels decode the
+ * columns on the fly.
+ *
+ * \tparam IndexType Type used for matrix indices (e.g. \c int).
+ * \tparam ValueType Type used for matrix values (e.g. \c float).
+ * \tparam MemorySpace A memory space (e.g. \c cusp::host_memory or cusp::device_memory)
+ *
+ * \note The matrix entries within the same row must be sorted by column index.
+ * \note The matrix should not contain duplicate entries.
+ * \note Converting a matrix with an entry further than 32767 columns from
+ *       the diagonal throws \p format_conversion_exception.
+ *
+ *  The following code snippet demonstrates how to convert a banded
+ *  \p csr_matrix to a \p csr16_matrix on the device.
+ *
+ *  \code
+ *  #include <cusp/csr_matrix.h>
+ *  #include <cusp/csr16_matrix.h>
+ *  #include <cusp/multiply.h>
+ *  #include <cusp/gallery/poisson.h>
+ *  ...
+ *
+ *  cusp::csr_matrix<int,float,cusp::device_memory> A;
+ *  cusp::gallery::poisson5pt(A, 1000, 1000);
+ *
+ *  // the bandwidth of A is 1000
+ *  cusp::csr16_matrix<int,float,cusp::device_memory> B(A);
+ *
+ *  cusp::array1d<float,cusp::device_memory> x(B.num_cols, 1);
+ *  cusp::array1d<float,cusp::device_memory> y(B.num_rows);
+ *
+ *  cusp::multiply(B, x, y);
+ *  \endcode
+ *
+ */
+template <typename IndexType, typename ValueType, class MemorySpace>
+class csr16_matrix : public detail::matrix_base<IndexType,ValueType,MemorySpace,cusp::csr16_format>
+{
+  typedef cusp::detail::matrix_base<IndexType,ValueType,MemorySpace,cusp::csr16_format> Parent;
+  public:
+    /*! rebind matrix to a different MemorySpace
+     */
+    template<typename MemorySpace2>
+    struct rebind { typedef cusp::csr16_matrix<IndexType, ValueType, MemorySpace2> type; };
+
+    /*! type of the stored column offsets
+     */
+    typedef short column_offset_type;
+
+    /*! type of row offsets array
+     */
+    typedef typename cusp::array1d<IndexType, MemorySpace> row_offsets_array_type;
+
+    /*! type of column offsets array
+     */
+    typedef typename cusp::array1d<column_offset_type, MemorySpace> column_offsets_array_type;
+
+    /*! type of values array
+     */
+    typedef typename cusp::array1d<ValueType, MemorySpace> values_array_type;
+
+    /*! equivalent container type
+     */
+    typedef typename cusp::csr16_matrix<IndexType, ValueType, MemorySpace> container;
+
+    /*! Smallest and largest column offset which can be stored.
+     */
+    const static int min_column_offset = -32768;
+    const static int max_column_offset =  32767;
+
+    /*! Storage for the row offsets of the CSR data structure.
+     */
+    row_offsets_array_type row_offsets;
+
+    /*! Storage for the column of each entry relative to its row.
+     */
+    column_offsets_array_type column_offsets;
+
+    /*! Storage for the nonzero entries of the CSR data structure.
+     */
+    values_array_type values;
+
+    /*! Construct an empty \p csr16_matrix.
+     */
+    csr16_matrix() {}
+
+    /*! Construct a \p csr16_matrix with a specific shape and number of nonzero entries.
+     *
+     *  \param num_rows Number of rows.
+     *  \param num_cols Number of columns.
+     *  \param num_entries Number of nonzero matrix entries.
+     */
+    csr16_matrix(size_t num_rows, size_t num_cols, size_t num_entries)
+      : Parent(num_rows, num_cols, num_entries),
+        row_offsets(num_rows + 1),
+        column_offsets(num_entries),
+        values(num_entries) {}
+
+    /*! Construct a \p csr16_matrix from another matrix.
+     *
+     *  \param matrix Another sparse or dense matrix.
+     */
+    template <typename MatrixType>
+    csr16_matrix(const MatrixType& matrix);
+
+    /*! Resize matrix dimensions and underlying storage
+     */
+    void resize(size_t num_rows, size_t num_cols, size_t num_entries)
+    {
+      Parent::resize(num_rows, num_cols, num_entries);
+      row_offsets.resize(num_rows + 1);
+      column_offsets.resize(num_entries);
+      values.resize(num_entries);
+    }
+
+    /*! Swap the contents of two \p csr16_matrix objects.
+     *
+     *  \param matrix Another \p csr16_matrix with the same IndexType and ValueType.
+     */
+    void swap(csr16_matrix& matrix)
+    {
+      Parent::swap(matrix);
+      row_offsets.swap(matrix.row_offsets);
+      column_offsets.swap(matrix.column_offsets);
+      values.swap(matrix.values);
+    }
+
+    /*! Assignment from another matrix.
+     *
+     *  \param matrix Another sparse or dense matrix.
+     */
+    template <typename MatrixType>
+    csr16_matrix& operator=(const MatrixType& matrix);
+}; // class csr16_matrix
+/*! \}
+ */
+
+} // end namespace cusp
+
+#include <cusp/detail/csr16_matrix.inl>
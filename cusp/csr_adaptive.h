@@ -0,0 +1,107 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+/*! \file csr_adaptive.h
+ *  \brief Device SpMV with the rows of a CSR matrix binned by length
+ */
+
+#pragma once
+
+#include <cusp/detail/config.h>
+
+#include <cusp/csr_matrix.h>
+#include <cusp/linear_operator.h>
+#include <cusp/detail/device/spmv/csr_adaptive.h>
+
+namespace cusp
+{
+
+/*! \addtogroup algorithms Algorithms
+ *  \ingroup algorithms
+ *  \{
+ */
+
+/*! \p csr_adaptive_spmv : Device linear operator which multiplies with a
+ *  CSR matrix whose rows are grouped by their number of nonzeros.
+ *
+ *  The rows are sorted once into bins of rows of similar length.  Every
+ *  multiply then processes each bin with a kernel whose number of threads
+ *  per row suits the length of its rows: a single thread or part of a warp
+ *  for short rows, a warp for medium rows and a whole thread block for very
+ *  long rows.  Unlike \p cusp::multiply with a \p csr_matrix, which chooses
+ *  one number of threads per row for the whole matrix, the operator handles
+ *  matrices whose row lengths vary widely, and the analysis is amortized
+ *  over the many multiplies of an iterative solver.
+ *
+ * \tparam IndexType integer type of the matrix indices
+ * \tparam ValueType scalar type of the matrix entries
+ *
+ *  \code
+ *  #include <cusp/csr_adaptive.h>
+ *  #include <cusp/krylov/cg.h>
+ *  #include <cusp/gallery/poisson.h>
+ *
+ *  int main(void)
+ *  {
+ *      cusp::csr_matrix<int, float, cusp::device_memory> A;
+ *      cusp::gallery::poisson5pt(A, 100, 100);
+ *
+ *      cusp::csr_adaptive_spmv<int, float> M(A);
+ *
+ *      cusp::array1d<float, cusp::device_memory> x(A.num_rows, 0);
+ *      cusp::array1d<float, cusp::device_memory> b(A.num_rows, 1);
+ *
+ *      cusp::krylov::cg(M, x, b);
+ *
+ *      return 0;
+ *  }
+ *  \endcode
+ */
+template <typename IndexType, typename ValueType>
+class csr_adaptive_spmv : public cusp::linear_operator<ValueType,cusp::device_memory,IndexType>
+{
+    typedef cusp::linear_operator<ValueType,cusp::device_memory,IndexType> Parent;
+
+    cusp::csr_matrix<IndexType,ValueType,cusp::device_memory> A;
+    cusp::detail::device::csr_adaptive_analysis<IndexType> analysis;
+
+    public:
+
+    /*! Construct the operator from a host or device matrix.
+     *
+     * \param matrix input matrix in any format
+     */
+    template <typename MatrixType>
+    csr_adaptive_spmv(const MatrixType& matrix);
+
+    /*! Number of rows processed by groups of \p threads_per_row threads,
+     *  where \p threads_per_row is 1, 2, 4, 8, 16 or 32, or zero for the
+     *  rows processed by whole thread blocks.
+     */
+    size_t num_binned_rows(size_t threads_per_row) const;
+
+    /*! Compute y = A * x.
+     */
+    template <typename VectorType1, typename VectorType2>
+    void operator()(const VectorType1& x, VectorType2& y) const;
+};
+/*! \}
+ */
+
+} // end namespace cusp
+
+#include <cusp/detail/csr_adaptive.inl>
@@ -0,0 +1,137 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+/*! \file csr_dictionary_operator.h
+ *  \brief CSR operator whose values are codes into a table of distinct values
+ */
+
+#pragma once
+
+#include <cusp/detail/config.h>
+
+#include <cusp/array1d.h>
+#include <cusp/linear_operator.h>
+
+namespace cusp
+{
+
+/*! \addtogroup algorithms Algorithms
+ *  \ingroup algorithms
+ *  \{
+ */
+
+/*! \p csr_dictionary_operator : Linear operator of a sparse matrix with few
+ *  distinct values, stored in CSR format with a small integer code per
+ *  entry in place of its value.
+ *
+ *  The distinct values of the matrix are kept, sorted, in \p dictionary
+ *  and entry k has the value <tt>dictionary[codes[k]]</tt>.  The matrices
+ *  of \p cusp::gallery::poisson5pt and the other constant-coefficient
+ *  stencils, or the Laplacians of unweighted graphs, have two to a few
+ *  dozen distinct values, so one-byte codes replace the four or eight
+ *  bytes of each value, which are the largest part of the memory traffic
+ *  of a CSR multiply.  On the device the entries go through the CSR vector
+ *  kernel, whose reads of the table hit the cache.  The products are
+ *  those of the \p csr_matrix with the same entries.
+ *
+ *  The operator can be passed to the Krylov solvers wherever a matrix is
+ *  expected.  For stencils on regular grids \p stencil_operator stores
+ *  neither the values nor the indices.
+ *
+ * \tparam IndexType type of the row offsets and column indices
+ * \tparam ValueType type of the values
+ * \tparam MemorySpace memory space of the arrays and vectors
+ * \tparam CodeType unsigned integer type of the codes, which bounds the
+ *         number of distinct values
+ *
+ *  \code
+ *  #include <cusp/csr_dictionary_operator.h>
+ *  #include <cusp/gallery/poisson.h>
+ *  #include <cusp/krylov/cg.h>
+ *
+ *  int main(void)
+ *  {
+ *      cusp::csr_matrix<int, float, cusp::device_memory> B;
+ *      cusp::gallery::poisson5pt(B, 256, 256);
+ *
+ *      // two distinct values, -1 and 4
+ *      cusp::csr_dictionary_operator<int, float, cusp::device_memory> A(B);
+ *
+ *      cusp::array1d<float, cusp::device_memory> x(A.num_rows, 0);
+ *      cusp::array1d<float, cusp::device_memory> b(A.num_rows, 1);
+ *
+ *      cusp::krylov::cg(A, x, b);
+ *
+ *      return 0;
+ *  }
+ *  \endcode
+ */
+template <typename IndexType, typename ValueType, typename MemorySpace, typename CodeType=unsigned char>
+class csr_dictionary_operator : public cusp::linear_operator<ValueType,MemorySpace,IndexType>
+{
+    typedef cusp::linear_operator<ValueType,MemorySpace,IndexType> Parent;
+
+    public:
+
+    typedef CodeType code_type;
+
+    /*! Offsets of the first entry of each row, as in \p csr_matrix.
+     */
+    cusp::array1d<IndexType,MemorySpace> row_offsets;
+
+    /*! Column index of each entry.
+     */
+    cusp::array1d<IndexType,MemorySpace> column_indices;
+
+    /*! Code of the value of each entry.
+     */
+    cusp::array1d<CodeType,MemorySpace> codes;
+
+    /*! Distinct values of the entries, in increasing order.
+     */
+    cusp::array1d<ValueType,MemorySpace> dictionary;
+
+    /*! Construct an empty operator.
+     */
+    csr_dictionary_operator(void);
+
+    /*! Construct the operator of a matrix.
+     *
+     * \param A matrix in any format and memory space
+     *
+     * \throws cusp::invalid_input_exception if \p A has more distinct
+     *         values than \p CodeType can number
+     */
+    template <typename MatrixType>
+    csr_dictionary_operator(const MatrixType& A);
+
+    /*! Construct a copy of an operator in another memory space.
+     */
+    template <typename MemorySpace2>
+    csr_dictionary_operator(const csr_dictionary_operator<IndexType,ValueType,MemorySpace2,CodeType>& A);
+
+    /*! Compute y = A * x.
+     */
+    template <typename VectorType1, typename VectorType2>
+    void operator()(const VectorType1& x, VectorType2& y) const;
+};
+/*! \}
+ */
+
+} // end namespace cusp
+
+#include <cusp/detail/csr_dictionary_operator.inl>
@@ -187,6 +187,16 @@ class csr_matrix : public detail::matrix_base<IndexType,ValueType,MemorySpace,cu
      */
     template <typename MatrixType>
     csr_matrix& operator=(const MatrixType& matrix);
+
+    /*! Sort the entries of every row by column index.
+     */
+    void sort_by_column(void);
+
+    /*! Sort the entries of every row by column index and sum the
+     *  entries with the same row and column, as assembly and SpGEMM
+     *  produce them.
+     */
+    void sum_duplicates(void);
 }; // class csr_matrix
 /*! \}
  */
@@ -197,11 +207,16 @@ class csr_matrix : public detail::matrix_base<IndexType,ValueType,MemorySpace,cu
  */
 
 /*! \p csr_matrix_view : Compressed Sparse Row matrix view
+ *
+ * The row offsets may have a wider type than the column indices, e.g.
+ * 64-bit offsets with 32-bit column indices for a matrix with more than
+ * 2^31 entries.  The SpMV kernels and conversions address the entries with
+ * the value type of \p Array1 and the columns with \p IndexType.
  *
  * \tparam Array1 Type of \c row_offsets array view
  * \tparam Array2 Type of \c column_indices array view
  * \tparam Array3 Type of \c values array view
- * \tparam IndexType Type used for matrix indices (e.g. \c int).
+ * \tparam IndexType Type used for matrix indices (e.g. \c int), by default that of the column indices.
  * \tparam ValueType Type used for matrix values (e.g. \c float).
  * \tparam MemorySpace A memory space (e.g. \c cusp::host_memory or cusp::device_memory)
  *
@@ -209,7 +224,7 @@ class csr_matrix : public detail::matrix_base<IndexType,ValueType,MemorySpace,cu
 template <typename Array1,
           typename Array2,
           typename Array3,
-          typename IndexType   = typename Array1::value_type,
+          typename IndexType   = typename Array2::value_type,
           typename ValueType   = typename Array3::value_type,
           typename MemorySpace = typename cusp::minimum_space<typename Array1::memory_space, typename Array2::memory_space, typename Array3::memory_space>::type >
 class csr_matrix_view : public cusp::detail::matrix_base<IndexType,ValueType,MemorySpace,cusp::csr_format>
@@ -305,6 +320,59 @@ make_csr_matrix_view(const csr_matrix_view<Array1,Array2,Array3,IndexType,ValueT
   return csr_matrix_view<Array1,Array2,Array3,IndexType,ValueType,MemorySpace>(m);
 }
     
+/*! \p make_csr_matrix_view : View a CSR matrix whose row offsets, column
+ *  indices and values are stored in external buffers in \p MemorySpace
+ *  (e.g. arrays allocated with \c cudaMalloc by another library).
+ *
+ *  Nothing is copied.  With non-const pointers the result has the type of
+ *  \p csr_matrix<IndexType,ValueType,MemorySpace>::view, and with const
+ *  pointers that of its \p const_view, so it may be passed to
+ *  \p cusp::multiply, the solvers and the preconditioners like a view of a
+ *  \p csr_matrix.
+ *
+ *  The row offsets may have a wider type than the column indices, e.g.
+ *  \c long \c long offsets with \c int column indices for a matrix with
+ *  more than 2^31 entries.
+ *
+ *  \code
+ *  // d_row_offsets, d_column_indices and d_values are device pointers
+ *  cusp::csr_matrix<int,float,cusp::device_memory>::view A =
+ *      cusp::make_csr_matrix_view(num_rows, num_cols, num_entries,
+ *                                 d_row_offsets, d_column_indices, d_values,
+ *                                 cusp::device_memory());
+ *  \endcode
+ */
+template <typename OffsetType, typename IndexType, typename ValueType, class MemorySpace>
+csr_matrix_view<typename cusp::detail::raw_array1d_view<OffsetType,MemorySpace>::type,
+                typename cusp::detail::raw_array1d_view<IndexType,MemorySpace>::type,
+                typename cusp::detail::raw_array1d_view<ValueType,MemorySpace>::type,
+                typename cusp::detail::raw_array1d_view<IndexType,MemorySpace>::value_type,
+                typename cusp::detail::raw_array1d_view<ValueType,MemorySpace>::value_type,
+                MemorySpace>
+make_csr_matrix_view(size_t num_rows,
+                     size_t num_cols,
+                     size_t num_entries,
+                     OffsetType * row_offsets,
+                     IndexType * column_indices,
+                     ValueType * values,
+                     MemorySpace)
+{
+  typedef cusp::detail::raw_array1d_view<OffsetType,MemorySpace> OffsetView;
+  typedef cusp::detail::raw_array1d_view<IndexType,MemorySpace>  IndexView;
+  typedef cusp::detail::raw_array1d_view<ValueType,MemorySpace>  ValueView;
+
+  return csr_matrix_view<typename OffsetView::type,
+                         typename IndexView::type,
+                         typename ValueView::type,
+                         typename IndexView::value_type,
+                         typename ValueView::value_type,
+                         MemorySpace>
+    (num_rows, num_cols, num_entries,
+     OffsetView::make(row_offsets, num_rows + 1),
+     IndexView::make(column_indices, num_entries),
+     ValueView::make(values, num_entries));
+}
+
 template <typename IndexType, typename ValueType, class MemorySpace>
 typename csr_matrix<IndexType,ValueType,MemorySpace>::view
 make_csr_matrix_view(csr_matrix<IndexType,ValueType,MemorySpace>& m)
@@ -0,0 +1,362 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*! \file deadline_monitor.h
+ *  \brief Stop iterative solvers at a time budget
+ */
+
+#pragma once
+
+#include <cusp/detail/config.h>
+
+#include <cusp/blas.h>
+#include <cusp/monitor.h>
+
+#include <cusp/detail/timer.h>
+#include <cusp/detail/device/stream.h>
+
+#include <cuda_runtime_api.h>
+
+#include <thrust/detail/type_traits.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace cusp
+{
+
+/*! \addtogroup iterative_solvers Iterative Solvers
+ *  \addtogroup monitors Monitors
+ *  \ingroup iterative_solvers
+ *  \{
+ */
+
+/*! Clocks measuring the time budget of \p deadline_monitor
+ */
+enum deadline_clock
+{
+  wall_clock,    //!< host wall-clock time
+  device_clock   //!< time of the work queued on the current stream, from CUDA events
+};
+
+/*! \p deadline_monitor is similar to \p interval_monitor except that it
+ * also stops the solver once a time budget is spent.
+ *
+ * The clock starts when the monitor is constructed and is read whenever
+ * a residual is tested, i.e. every \p check_interval iterations for
+ * residuals in device memory.  Neither clock synchronizes with the
+ * device: the wall clock is read on the host, and the device clock reads
+ * the event recorded at the previous test, which the residual norm
+ * computed since has already waited for.  The device clock therefore
+ * lags by one test, and it excludes the time the stream spent on work
+ * queued before the solve.
+ *
+ * The monitor keeps the smallest residual norm tested, which latency
+ * bound callers may report when the budget runs out.  The solution is
+ * the last iterate of the solver, not the one of the best residual.
+ *
+ * From the average convergence factor of the tested residuals, as
+ * reported by \p convergence_monitor::geometric_rate, and the average
+ * time of an iteration the monitor projects when the tolerance will be
+ * reached.  With \p stop_when_late the solver is stopped as soon as the
+ * projection misses the budget, leaving the rest of the budget to the
+ * caller, e.g. for a fallback solver.
+ *
+ * \tparam ValueType scalar type used in the solver (e.g. \c float or \c cusp::complex<double>).
+ *
+ *  The following code snippet gives \p cg 20 milliseconds.
+ *
+ *  \code
+ *  #include <cusp/csr_matrix.h>
+ *  #include <cusp/deadline_monitor.h>
+ *  #include <cusp/krylov/cg.h>
+ *  #include <cusp/gallery/poisson.h>
+ *
+ *  int main(void)
+ *  {
+ *      cusp::csr_matrix<int, float, cusp::device_memory> A;
+ *      cusp::gallery::poisson5pt(A, 100, 100);
+ *
+ *      cusp::array1d<float, cusp::device_memory> x(A.num_rows, 0);
+ *      cusp::array1d<float, cusp::device_memory> b(A.num_rows, 1);
+ *
+ *      // 20 ms, 1000 iterations, 1e-6 relative tolerance, tested every 10 iterations
+ *      cusp::deadline_monitor<float> monitor(b, 20.0, 1000, 1e-6);
+ *
+ *      cusp::krylov::cg(A, x, b, monitor);
+ *
+ *      if (monitor.timed_out())
+ *          std::cout << "best residual " << monitor.best_residual_norm() << std::endl;
+ *
+ *      return 0;
+ *  }
+ *  \endcode
+ *
+ *  \see \p interval_monitor
+ *  \see \p convergence_monitor
+ */
+template <typename ValueType>
+class deadline_monitor : public interval_monitor<ValueType>
+{
+    typedef typename norm_type<ValueType>::type Real;
+    typedef cusp::interval_monitor<ValueType> super;
+    typedef cusp::default_monitor<ValueType> base;
+
+    public:
+    /*! Construct a \p deadline_monitor for a given right-hand-side \p b
+     *
+     *  \param b right-hand-side of the linear system A x = b
+     *  \param time_limit time budget of the solve in milliseconds
+     *  \param iteration_limit maximum number of solver iterations to allow
+     *  \param relative_tolerance determines convergence criteria
+     *  \param absolute_tolerance determines convergence criteria
+     *  \param check_interval number of iterations between two tests of the residual
+     *  \param clock clock measuring the budget
+     *  \param stop_when_late whether to stop once convergence is projected past the budget
+     *
+     *  \tparam VectorType vector
+     */
+    template <typename Vector>
+    deadline_monitor(const Vector& b, double time_limit, size_t iteration_limit = 500,
+                     Real relative_tolerance = 1e-5, Real absolute_tolerance = 0,
+                     size_t check_interval = 10, deadline_clock clock = wall_clock,
+                     bool stop_when_late = false)
+        : super(b, iteration_limit, relative_tolerance, absolute_tolerance, check_interval),
+          time_limit_(time_limit),
+          clock_(clock),
+          stop_when_late_(stop_when_late),
+          timed_out_(false),
+          late_(false),
+          elapsed_(0),
+          best_norm_(std::numeric_limits<Real>::max()),
+          first_norm_(0),
+          first_iteration_(0),
+          tested_(false),
+          start_event_(NULL),
+          last_event_(NULL),
+          last_event_pending_(false)
+    {
+        if (clock_ == device_clock)
+        {
+            cudaEventCreate(&start_event_);
+            cudaEventCreate(&last_event_);
+            cudaEventRecord(start_event_, cusp::detail::device::current_stream());
+        }
+        else
+        {
+            start_time_ = cusp::detail::wall_clock_milliseconds();
+        }
+    }
+
+    ~deadline_monitor(void)
+    {
+        if (clock_ == device_clock)
+        {
+            cudaEventDestroy(start_event_);
+            cudaEventDestroy(last_event_);
+        }
+    }
+
+    /*! applies the convergence criteria and the time budget to the
+     *  residual vector \p r if the current iteration is tested
+     */
+    template <typename Vector>
+    bool finished(const Vector& r)
+    {
+        typedef typename thrust::detail::is_convertible<typename Vector::memory_space, cusp::host_memory>::type on_host;
+
+        if (!on_host::value && !super::is_check_iteration())
+            return false;
+
+        return finished(cusp::blas::nrm2(r));
+    }
+
+    /*! applies the convergence criteria and the time budget to a residual
+     *  norm computed by the solver
+     */
+    bool finished(const Real& residual_norm)
+    {
+        base::r_norm = residual_norm;
+
+        if (residual_norm < best_norm_)
+            best_norm_ = residual_norm;
+
+        if (!tested_)
+        {
+            first_norm_ = residual_norm;
+            first_iteration_ = base::iteration_count();
+            tested_ = true;
+        }
+
+        update_elapsed();
+
+        if (base::converged() || base::iteration_count() >= base::iteration_limit())
+            return true;
+
+        if (elapsed_ >= time_limit_)
+        {
+            timed_out_ = true;
+            return true;
+        }
+
+        if (stop_when_late_ && !will_converge_in_time())
+        {
+            late_ = true;
+            return true;
+        }
+
+        return false;
+    }
+
+    /*! applies the criteria to the squared residual norm <r,r> held by
+     *  the first entry of \p squared_norm if the current iteration is
+     *  tested.  \p squared_norm may reside in device memory.
+     */
+    template <typename Array>
+    bool finished_squared_norm(const Array& squared_norm)
+    {
+        if (!super::is_check_iteration())
+            return false;
+
+        using std::abs;
+        using std::sqrt;
+
+        const typename Array::value_type rr = squared_norm[0];
+
+        return finished(Real(sqrt(abs(rr))));
+    }
+
+    /*! time budget in milliseconds
+     */
+    double time_limit() const { return time_limit_; }
+
+    /*! milliseconds spent at the last test
+     */
+    double elapsed_time() const { return elapsed_; }
+
+    /*! whether the solver was stopped by the time budget
+     */
+    bool timed_out() const { return timed_out_; }
+
+    /*! whether the solver was stopped because convergence was projected
+     *  past the time budget
+     */
+    bool stopped_late() const { return late_; }
+
+    /*! smallest residual norm tested
+     */
+    Real best_residual_norm() const { return best_norm_; }
+
+    /*! milliseconds from the start until the tolerance is projected to be
+     *  reached, infinite until two residuals have been tested or if the
+     *  residual does not decrease
+     */
+    double projected_time() const
+    {
+        if (base::converged())
+            return elapsed_;
+
+        const size_t iterations = base::iteration_count() - first_iteration_;
+        const Real r = base::residual_norm();
+
+        if (!tested_ || iterations == 0 || first_norm_ <= Real(0) || r <= Real(0))
+            return std::numeric_limits<double>::infinity();
+
+        // geometric_rate of convergence_monitor
+        const double rate = std::pow(double(r) / double(first_norm_), 1.0 / double(iterations));
+
+        if (!(rate < 1.0))
+            return std::numeric_limits<double>::infinity();
+
+        const double remaining     = std::log(double(base::tolerance()) / double(r)) / std::log(rate);
+        const double per_iteration = elapsed_ / double(base::iteration_count());
+
+        return elapsed_ + remaining * per_iteration;
+    }
+
+    /*! whether the tolerance is projected to be reached within the budget,
+     *  \c true until two residuals have been tested
+     */
+    bool will_converge_in_time() const
+    {
+        if (!tested_ || base::iteration_count() == first_iteration_)
+            return true;
+
+        return projected_time() <= time_limit_;
+    }
+
+    protected:
+    double time_limit_;
+    deadline_clock clock_;
+    bool stop_when_late_;
+    bool timed_out_;
+    bool late_;
+    double elapsed_;
+    double start_time_;
+    Real best_norm_;
+    Real first_norm_;
+    size_t first_iteration_;
+    bool tested_;
+
+    cudaEvent_t start_event_;
+    cudaEvent_t last_event_;
+    bool last_event_pending_;
+
+    void update_elapsed(void)
+    {
+        if (clock_ == wall_clock)
+        {
+            elapsed_ = cusp::detail::wall_clock_milliseconds() - start_time_;
+            return;
+        }
+
+        // the event of the previous test has completed unless the solver
+        // queued work without reading anything back since
+        if (last_event_pending_)
+        {
+            if (cudaEventQuery(last_event_) != cudaSuccess)
+            {
+                cudaGetLastError();
+                return;
+            }
+
+            float ms = 0.0f;
+            cudaEventElapsedTime(&ms, start_event_, last_event_);
+            elapsed_ = ms;
+        }
+
+        cudaEventRecord(last_event_, cusp::detail::device::current_stream());
+        last_event_pending_ = true;
+    }
+
+    private:
+    // owns events
+    deadline_monitor(const deadline_monitor&);
+    deadline_monitor& operator=(const deadline_monitor&);
+};
+/*! \}
+ */
+
+namespace detail
+{
+
+template <typename ValueType>
+struct accepts_residual_norm< cusp::deadline_monitor<ValueType> > : thrust::detail::true_type {};
+
+} // end namespace detail
+
+} // end namespace cusp
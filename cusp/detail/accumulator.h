@@ -0,0 +1,236 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+#pragma once
+
+#include <cusp/detail/config.h>
+
+#include <cusp/complex.h>
+
+#include <math.h>
+
+// Accumulation policies for sums of products, used by the SpMV kernels and
+// the BLAS reductions.
+//
+// plain_accumulation adds in the working precision.
+//
+// compensated_accumulation keeps the rounding error of every addition
+// (two_sum) and, for float and double, of every product (two_product) in a
+// second term, which is the Dot2 algorithm of Ogita, Rump and Oishi.  The
+// result is about as accurate as a sum computed in twice the working
+// precision and rounded at the end, while the operands stay in the working
+// precision.  Complex values compensate their additions only.
+//
+// Partial sums are merged with operator+, so an accumulator can be passed
+// through warp shuffles and Thrust reductions like a plain value.
+
+namespace cusp
+{
+namespace detail
+{
+
+struct plain_accumulation {};
+struct compensated_accumulation {};
+
+// s + e == a + b exactly, where s is the rounded sum
+template <typename T>
+__host__ __device__
+void two_sum(const T a, const T b, T& s, T& e)
+{
+    s = a + b;
+    const T bb = s - a;
+    e = (a - (s - bb)) + (b - bb);
+}
+
+// p + e == a * b exactly, where p is the rounded product.  Products of types
+// without a fused multiply-add are not compensated.
+template <typename T>
+__host__ __device__
+void two_product(const T a, const T b, T& p, T& e)
+{
+    p = a * b;
+    e = T(0);
+}
+
+__host__ __device__
+inline void two_product(const float a, const float b, float& p, float& e)
+{
+#ifdef __CUDA_ARCH__
+    // __fmul_rn is never contracted into a neighbouring addition
+    p = __fmul_rn(a, b);
+    e = fmaf(a, b, -p);
+#else
+    // the product of two floats is exact in double
+    const double ab = double(a) * double(b);
+    p = float(ab);
+    e = float(ab - double(p));
+#endif
+}
+
+__host__ __device__
+inline void two_product(const double a, const double b, double& p, double& e)
+{
+#ifdef __CUDA_ARCH__
+    p = __dmul_rn(a, b);
+#else
+    p = a * b;
+#endif
+    e = fma(a, b, -p);
+}
+
+template <typename T, typename Accumulation>
+struct accumulator;
+
+template <typename T>
+struct accumulator<T, plain_accumulation>
+{
+    T sum;
+
+    __host__ __device__
+    accumulator(void) : sum(0) {}
+
+    __host__ __device__
+    accumulator(const T& init) : sum(init) {}
+
+    __host__ __device__
+    void add(const T& x)
+    {
+        sum = sum + x;
+    }
+
+    __host__ __device__
+    void add_product(const T& a, const T& b)
+    {
+        sum = sum + a * b;
+    }
+
+    __host__ __device__
+    T result(void) const
+    {
+        return sum;
+    }
+
+    __host__ __device__
+    accumulator operator+(const accumulator& other) const
+    {
+        return accumulator(sum + other.sum);
+    }
+};
+
+__host__ __device__
+inline float fused_multiply_add(const float a, const float b, const float c)
+{
+    return fmaf(a, b, c);
+}
+
+__host__ __device__
+inline double fused_multiply_add(const double a, const double b, const double c)
+{
+    return fma(a, b, c);
+}
+
+// sum + a * b rounds the complex product before adding it; accumulating
+// the four component products with fused multiply-adds takes four
+// instructions instead of six and rounds once per component product
+template <typename T>
+struct accumulator<cusp::complex<T>, plain_accumulation>
+{
+    T re;
+    T im;
+
+    __host__ __device__
+    accumulator(void) : re(0), im(0) {}
+
+    __host__ __device__
+    accumulator(const cusp::complex<T>& init) : re(init.real()), im(init.imag()) {}
+
+    __host__ __device__
+    void add(const cusp::complex<T>& x)
+    {
+        re = re + x.real();
+        im = im + x.imag();
+    }
+
+    __host__ __device__
+    void add_product(const cusp::complex<T>& a, const cusp::complex<T>& b)
+    {
+        re = fused_multiply_add( a.real(), b.real(), re);
+        re = fused_multiply_add(-a.imag(), b.imag(), re);
+        im = fused_multiply_add( a.real(), b.imag(), im);
+        im = fused_multiply_add( a.imag(), b.real(), im);
+    }
+
+    __host__ __device__
+    cusp::complex<T> result(void) const
+    {
+        return cusp::complex<T>(re, im);
+    }
+
+    __host__ __device__
+    accumulator operator+(const accumulator& other) const
+    {
+        return accumulator(cusp::complex<T>(re + other.re, im + other.im));
+    }
+};
+
+template <typename T>
+struct accumulator<T, compensated_accumulation>
+{
+    T sum;
+    T error;
+
+    __host__ __device__
+    accumulator(void) : sum(0), error(0) {}
+
+    __host__ __device__
+    accumulator(const T& init) : sum(init), error(0) {}
+
+    __host__ __device__
+    void add(const T& x)
+    {
+        T e;
+        two_sum(sum, x, sum, e);
+        error = error + e;
+    }
+
+    __host__ __device__
+    void add_product(const T& a, const T& b)
+    {
+        T p, e;
+        two_product(a, b, p, e);
+        error = error + e;
+        add(p);
+    }
+
+    __host__ __device__
+    T result(void) const
+    {
+        return sum + error;
+    }
+
+    __host__ __device__
+    accumulator operator+(const accumulator& other) const
+    {
+        accumulator r;
+        two_sum(sum, other.sum, r.sum, r.error);
+        r.error = r.error + (error + other.error);
+        return r;
+    }
+};
+
+} // end namespace detail
+} // end namespace cusp
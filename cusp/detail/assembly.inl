@@ -0,0 +1,308 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include <cusp/convert.h>
+#include <cusp/coo_matrix.h>
+#include <cusp/exception.h>
+#include <cusp/detail/format_utils.h>
+
+#include <thrust/copy.h>
+#include <thrust/count.h>
+#include <thrust/fill.h>
+#include <thrust/find.h>
+#include <thrust/functional.h>
+#include <thrust/inner_product.h>
+#include <thrust/reduce.h>
+#include <thrust/scatter.h>
+#include <thrust/sort.h>
+#include <thrust/transform.h>
+#include <thrust/iterator/zip_iterator.h>
+
+namespace cusp
+{
+namespace detail
+{
+
+template <typename IndexType>
+struct triplet_outside_matrix
+{
+  IndexType num_rows;
+  IndexType num_cols;
+
+  triplet_outside_matrix(IndexType num_rows, IndexType num_cols)
+    : num_rows(num_rows), num_cols(num_cols) {}
+
+  template <typename Tuple>
+  __host__ __device__
+  bool operator()(const Tuple& t) const
+  {
+    IndexType i = thrust::get<0>(t);
+    IndexType j = thrust::get<1>(t);
+
+    return i < IndexType(0) || i >= num_rows || j < IndexType(0) || j >= num_cols;
+  }
+};
+
+// position of entry (i,j) in a CSR matrix, or -1 if it is not in the pattern
+template <typename IndexType>
+struct locate_pattern_entry
+{
+  IndexType num_rows;
+  IndexType num_cols;
+  const IndexType * row_offsets;
+  const IndexType * column_indices;
+
+  locate_pattern_entry(IndexType num_rows, IndexType num_cols,
+                       const IndexType * row_offsets, const IndexType * column_indices)
+    : num_rows(num_rows), num_cols(num_cols),
+      row_offsets(row_offsets), column_indices(column_indices) {}
+
+  template <typename Tuple>
+  __host__ __device__
+  IndexType operator()(const Tuple& t) const
+  {
+    IndexType i = thrust::get<0>(t);
+    IndexType j = thrust::get<1>(t);
+
+    if (i < IndexType(0) || i >= num_rows || j < IndexType(0) || j >= num_cols)
+      return IndexType(-1);
+
+    // binary search within the sorted row
+    IndexType first = row_offsets[i];
+    IndexType last  = row_offsets[i + 1];
+
+    while (first < last)
+    {
+      IndexType middle = first + (last - first) / 2;
+
+      if (column_indices[middle] < j)
+        first = middle + 1;
+      else
+        last = middle;
+    }
+
+    if (first < row_offsets[i + 1] && column_indices[first] == j)
+      return first;
+    else
+      return IndexType(-1);
+  }
+};
+
+// accumulate values[k] into output[positions[k]]
+template <typename Array1, typename Array2, typename Array3, typename Array4, typename Array5>
+void accumulate_by_position(Array1& positions, Array2& values,
+                            Array3& unique_positions, Array4& sums,
+                            Array5& output,
+                            cusp::host_memory)
+{
+  typedef typename Array5::value_type ValueType;
+
+  thrust::fill(output.begin(), output.end(), ValueType(0));
+
+  // a sequential pass is faster than sorting on the host
+  for (size_t n = 0; n < positions.size(); n++)
+    output[positions[n]] += values[n];
+}
+
+template <typename Array1, typename Array2, typename Array3, typename Array4, typename Array5>
+void accumulate_by_position(Array1& positions, Array2& values,
+                            Array3& unique_positions, Array4& sums,
+                            Array5& output,
+                            cusp::device_memory)
+{
+  typedef typename Array5::value_type ValueType;
+
+  thrust::sort_by_key(positions.begin(), positions.end(), values.begin());
+
+  unique_positions.resize(positions.size());
+  sums.resize(positions.size());
+
+  size_t num_unique = thrust::reduce_by_key
+    (positions.begin(), positions.end(),
+     values.begin(),
+     unique_positions.begin(),
+     sums.begin()).first - unique_positions.begin();
+
+  thrust::fill(output.begin(), output.end(), ValueType(0));
+
+  thrust::scatter(sums.begin(), sums.begin() + num_unique,
+                  unique_positions.begin(),
+                  output.begin());
+}
+
+} // end namespace detail
+
+
+template <typename IndexType, typename ValueType, class MemorySpace>
+void matrix_assembler<IndexType,ValueType,MemorySpace>
+::reserve(size_t capacity)
+{
+  row_indices.reserve(capacity);
+  column_indices.reserve(capacity);
+  values.reserve(capacity);
+}
+
+template <typename IndexType, typename ValueType, class MemorySpace>
+void matrix_assembler<IndexType,ValueType,MemorySpace>
+::clear(void)
+{
+  // shrinking keeps the capacity of the arrays
+  row_indices.resize(0);
+  column_indices.resize(0);
+  values.resize(0);
+}
+
+template <typename IndexType, typename ValueType, class MemorySpace>
+size_t matrix_assembler<IndexType,ValueType,MemorySpace>
+::grow(size_t count)
+{
+  size_t offset = values.size();
+
+  // the arrays grow geometrically, so repeated appends are amortized
+  row_indices.resize(offset + count);
+  column_indices.resize(offset + count);
+  values.resize(offset + count);
+
+  return offset;
+}
+
+template <typename IndexType, typename ValueType, class MemorySpace>
+size_t matrix_assembler<IndexType,ValueType,MemorySpace>
+::append(size_t count)
+{
+  return grow(count);
+}
+
+template <typename IndexType, typename ValueType, class MemorySpace>
+void matrix_assembler<IndexType,ValueType,MemorySpace>
+::push_back(IndexType row, IndexType column, ValueType value)
+{
+#ifdef _OPENMP
+  #pragma omp critical (cusp_matrix_assembler)
+#endif
+  {
+    size_t offset = grow(1);
+
+    row_indices[offset]    = row;
+    column_indices[offset] = column;
+    values[offset]         = value;
+  }
+}
+
+template <typename IndexType, typename ValueType, class MemorySpace>
+template <typename Array1, typename Array2, typename Array3>
+void matrix_assembler<IndexType,ValueType,MemorySpace>
+::append(const Array1& rows, const Array2& columns, const Array3& values)
+{
+  if (rows.size() != columns.size() || rows.size() != values.size())
+    throw cusp::invalid_input_exception("triplet arrays must have the same size");
+
+#ifdef _OPENMP
+  #pragma omp critical (cusp_matrix_assembler)
+#endif
+  {
+    size_t offset = grow(rows.size());
+
+    thrust::copy(rows.begin(),    rows.end(),    row_indices.begin()    + offset);
+    thrust::copy(columns.begin(), columns.end(), column_indices.begin() + offset);
+    thrust::copy(values.begin(),  values.end(),  this->values.begin()   + offset);
+  }
+}
+
+template <typename IndexType, typename ValueType, class MemorySpace>
+template <typename MatrixType>
+void matrix_assembler<IndexType,ValueType,MemorySpace>
+::finalize(MatrixType& matrix)
+{
+  CUSP_PROFILE_SCOPED();
+
+  const size_t N = num_triplets();
+
+  if (thrust::count_if(thrust::make_zip_iterator(thrust::make_tuple(row_indices.begin(), column_indices.begin())),
+                       thrust::make_zip_iterator(thrust::make_tuple(row_indices.end(),   column_indices.end())),
+                       detail::triplet_outside_matrix<IndexType>(num_rows, num_cols)) > 0)
+    throw cusp::invalid_input_exception("triplet index outside of the matrix");
+
+  cusp::detail::sort_by_row_and_column(row_indices, column_indices, values);
+
+  // count the distinct coordinates
+  size_t num_entries = 0;
+
+  if (N > 0)
+    num_entries = thrust::inner_product
+      (thrust::make_zip_iterator(thrust::make_tuple(row_indices.begin(), column_indices.begin())),
+       thrust::make_zip_iterator(thrust::make_tuple(row_indices.end(),   column_indices.end())) - 1,
+       thrust::make_zip_iterator(thrust::make_tuple(row_indices.begin(), column_indices.begin())) + 1,
+       size_t(1),
+       thrust::plus<size_t>(),
+       thrust::not_equal_to< thrust::tuple<IndexType,IndexType> >());
+
+  cusp::coo_matrix<IndexType,ValueType,MemorySpace> coo(num_rows, num_cols, num_entries);
+
+  // sum the duplicate entries
+  thrust::reduce_by_key
+    (thrust::make_zip_iterator(thrust::make_tuple(row_indices.begin(), column_indices.begin())),
+     thrust::make_zip_iterator(thrust::make_tuple(row_indices.end(),   column_indices.end())),
+     values.begin(),
+     thrust::make_zip_iterator(thrust::make_tuple(coo.row_indices.begin(), coo.column_indices.begin())),
+     coo.values.begin());
+
+  cusp::convert(coo, matrix);
+
+  clear();
+}
+
+template <typename IndexType, typename ValueType, class MemorySpace>
+void matrix_assembler<IndexType,ValueType,MemorySpace>
+::assemble_values(cusp::csr_matrix<IndexType,ValueType,MemorySpace>& matrix)
+{
+  CUSP_PROFILE_SCOPED();
+
+  if (matrix.num_rows != num_rows || matrix.num_cols != num_cols)
+    throw cusp::invalid_input_exception("matrix dimensions do not match the assembler");
+
+  const size_t N = num_triplets();
+
+  if (N > 0)
+  {
+    if (matrix.num_entries == 0)
+      throw cusp::invalid_input_exception("triplet has no entry in the sparsity pattern");
+
+    positions.resize(N);
+
+    thrust::transform(thrust::make_zip_iterator(thrust::make_tuple(row_indices.begin(), column_indices.begin())),
+                      thrust::make_zip_iterator(thrust::make_tuple(row_indices.end(),   column_indices.end())),
+                      positions.begin(),
+                      detail::locate_pattern_entry<IndexType>(num_rows, num_cols,
+                                                              thrust::raw_pointer_cast(&matrix.row_offsets[0]),
+                                                              thrust::raw_pointer_cast(&matrix.column_indices[0])));
+
+    if (thrust::find(positions.begin(), positions.end(), IndexType(-1)) != positions.end())
+      throw cusp::invalid_input_exception("triplet has no entry in the sparsity pattern");
+  }
+  else
+  {
+    positions.resize(0);
+  }
+
+  cusp::detail::accumulate_by_position(positions, values, unique_positions, sums, matrix.values, MemorySpace());
+
+  clear();
+}
+
+} // end namespace cusp
@@ -0,0 +1,371 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include <cusp/array1d.h>
+#include <cusp/coo_matrix.h>
+#include <cusp/dia_matrix.h>
+#include <cusp/ell_matrix.h>
+#include <cusp/hyb_matrix.h>
+
+#include <cusp/detail/timer.h>
+#include <cusp/detail/host/conversion.h>
+#include <cusp/detail/host/conversion_utils.h>
+
+#include <cusp/detail/device/spmv/coo_flat.h>
+#include <cusp/detail/device/spmv/csr_merge.h>
+#include <cusp/detail/device/spmv/csr_scalar.h>
+#include <cusp/detail/device/spmv/csr_vector.h>
+#include <cusp/detail/device/spmv/dia.h>
+#include <cusp/detail/device/spmv/ell.h>
+#include <cusp/detail/device/spmv/hyb.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace cusp
+{
+namespace detail
+{
+
+// SpMV y = A * x on raw device pointers, independent of the format of A
+template <typename ValueType>
+class spmv_kernel_base
+{
+    public:
+    const std::string name;
+
+    spmv_kernel_base(const std::string& name) : name(name) {}
+
+    virtual ~spmv_kernel_base(void) {}
+
+    virtual void operator()(const ValueType * x, ValueType * y) const = 0;
+};
+
+template <typename Matrix>
+class spmv_kernel : public spmv_kernel_base<typename Matrix::value_type>
+{
+    typedef typename Matrix::value_type ValueType;
+    typedef spmv_kernel_base<ValueType> Parent;
+
+    public:
+    typedef void (*kernel_type)(const Matrix&, const ValueType *, ValueType *);
+
+    template <typename HostMatrix>
+    spmv_kernel(const std::string& name, const HostMatrix& matrix, kernel_type kernel)
+      : Parent(name), A(matrix), kernel(kernel) {}
+
+    void operator()(const ValueType * x, ValueType * y) const
+    {
+        kernel(A, x, y);
+    }
+
+    private:
+    const Matrix A;
+    kernel_type kernel;
+};
+
+// average time of one SpMV in milliseconds
+template <typename ValueType>
+float time_spmv_kernel(const spmv_kernel_base<ValueType>& kernel,
+                       const size_t num_rows,
+                       const size_t num_cols,
+                       const size_t iterations)
+{
+    cusp::array1d<ValueType,cusp::device_memory> x(num_cols, ValueType(1));
+    cusp::array1d<ValueType,cusp::device_memory> y(num_rows, ValueType(0));
+
+    const ValueType * x_ptr = thrust::raw_pointer_cast(&x[0]);
+          ValueType * y_ptr = thrust::raw_pointer_cast(&y[0]);
+
+    // warmup
+    kernel(x_ptr, y_ptr);
+
+    cusp::detail::timer t;
+    cudaEventRecord(t._start, 0);
+
+    for(size_t i = 0; i < iterations; i++)
+        kernel(x_ptr, y_ptr);
+
+    return t.milliseconds_elapsed() / std::max<size_t>(1, iterations);
+}
+
+// keeps the fastest of the candidates it is given
+template <typename ValueType>
+class spmv_kernel_selector
+{
+    const size_t num_rows;
+    const size_t num_cols;
+    const size_t iterations;
+
+    public:
+    spmv_kernel_base<ValueType> * best;
+    float best_milliseconds;
+
+    spmv_kernel_selector(const size_t num_rows, const size_t num_cols, const size_t iterations)
+      : num_rows(num_rows), num_cols(num_cols), iterations(iterations), best(0), best_milliseconds(0) {}
+
+    void consider(spmv_kernel_base<ValueType> * candidate)
+    {
+        const float milliseconds = time_spmv_kernel(*candidate, num_rows, num_cols, iterations);
+
+        if (best == 0 || milliseconds < best_milliseconds)
+        {
+            delete best;
+            best              = candidate;
+            best_milliseconds = milliseconds;
+        }
+        else
+        {
+            delete candidate;
+        }
+    }
+};
+
+inline bool dia_is_admissible(const cusp::matrix_structure& s, const cusp::autotune_options& options)
+{
+    return s.num_entries > 0 &&
+           float(s.num_diagonals) * float(s.num_rows) <= options.max_fill * float(s.num_entries);
+}
+
+inline bool ell_is_admissible(const cusp::matrix_structure& s, const cusp::autotune_options& options)
+{
+    return s.num_entries > 0 &&
+           float(s.max_entries_per_row) * float(s.num_rows) <= options.max_fill * float(s.num_entries);
+}
+
+// time every admissible format and kernel and return the fastest
+template <typename IndexType, typename ValueType>
+spmv_kernel_base<ValueType> *
+benchmark_spmv_kernels(const cusp::csr_matrix<IndexType,ValueType,cusp::host_memory>& A,
+                       const cusp::matrix_structure& s,
+                       const cusp::autotune_options& options,
+                             float& milliseconds)
+{
+    typedef cusp::coo_matrix<IndexType,ValueType,cusp::device_memory> DeviceCoo;
+    typedef cusp::csr_matrix<IndexType,ValueType,cusp::device_memory> DeviceCsr;
+    typedef cusp::dia_matrix<IndexType,ValueType,cusp::device_memory> DeviceDia;
+    typedef cusp::ell_matrix<IndexType,ValueType,cusp::device_memory> DeviceEll;
+    typedef cusp::hyb_matrix<IndexType,ValueType,cusp::device_memory> DeviceHyb;
+
+    spmv_kernel_selector<ValueType> selector(A.num_rows, A.num_cols, options.iterations);
+
+    selector.consider(new spmv_kernel<DeviceCsr>("csr_scalar",  A, cusp::detail::device::spmv_csr_scalar<DeviceCsr,ValueType>));
+    selector.consider(new spmv_kernel<DeviceCsr>("csr_vector",  A, cusp::detail::device::spmv_csr_vector<DeviceCsr,ValueType>));
+    selector.consider(new spmv_kernel<DeviceCsr>("csr_merge",   A, cusp::detail::device::spmv_csr_merge<DeviceCsr,ValueType>));
+    selector.consider(new spmv_kernel<DeviceCsr>("csr_scalar_tex", A, cusp::detail::device::spmv_csr_scalar_tex<DeviceCsr,ValueType>));
+    selector.consider(new spmv_kernel<DeviceCsr>("csr_vector_tex", A, cusp::detail::device::spmv_csr_vector_tex<DeviceCsr,ValueType>));
+    selector.consider(new spmv_kernel<DeviceCsr>("csr_merge_tex",  A, cusp::detail::device::spmv_csr_merge_tex<DeviceCsr,ValueType>));
+
+    {
+        cusp::coo_matrix<IndexType,ValueType,cusp::host_memory> coo(A);
+        selector.consider(new spmv_kernel<DeviceCoo>("coo_flat", coo, cusp::detail::device::spmv_coo_flat<DeviceCoo,ValueType>));
+        selector.consider(new spmv_kernel<DeviceCoo>("coo_flat_tex", coo, cusp::detail::device::spmv_coo_flat_tex<DeviceCoo,ValueType>));
+    }
+
+    if (dia_is_admissible(s, options))
+    {
+        cusp::dia_matrix<IndexType,ValueType,cusp::host_memory> dia;
+        cusp::detail::host::csr_to_dia(A, dia);
+        selector.consider(new spmv_kernel<DeviceDia>("dia", dia, cusp::detail::device::spmv_dia<DeviceDia,ValueType>));
+        selector.consider(new spmv_kernel<DeviceDia>("dia_tex", dia, cusp::detail::device::spmv_dia_tex<DeviceDia,ValueType>));
+        selector.consider(new spmv_kernel<DeviceDia>("dia_tiled", dia, cusp::detail::device::spmv_dia_tiled<DeviceDia,ValueType>));
+    }
+
+    if (ell_is_admissible(s, options))
+    {
+        cusp::ell_matrix<IndexType,ValueType,cusp::host_memory> ell;
+        cusp::detail::host::csr_to_ell(A, ell, s.max_entries_per_row);
+        selector.consider(new spmv_kernel<DeviceEll>("ell", ell, cusp::detail::device::spmv_ell<DeviceEll,ValueType>));
+        selector.consider(new spmv_kernel<DeviceEll>("ell_tex", ell, cusp::detail::device::spmv_ell_tex<DeviceEll,ValueType>));
+    }
+
+    // try a narrower and a wider ELL part than the heuristic
+    const size_t widths[3] = { s.hyb_entries_per_row / 2, s.hyb_entries_per_row, 2 * s.hyb_entries_per_row };
+
+    for(size_t i = 0; i < 3; i++)
+    {
+        if (widths[i] == 0 || widths[i] > s.max_entries_per_row || (i > 0 && widths[i] == widths[i - 1]))
+            continue;
+
+        cusp::hyb_matrix<IndexType,ValueType,cusp::host_memory> hyb;
+        cusp::detail::host::csr_to_hyb(A, hyb, widths[i]);
+        selector.consider(new spmv_kernel<DeviceHyb>("hyb", hyb, cusp::detail::device::spmv_hyb<DeviceHyb,ValueType>));
+        selector.consider(new spmv_kernel<DeviceHyb>("hyb_tex", hyb, cusp::detail::device::spmv_hyb_tex<DeviceHyb,ValueType>));
+    }
+
+    milliseconds = selector.best_milliseconds;
+
+    return selector.best;
+}
+
+// choose the format from the structure of A alone
+template <typename IndexType, typename ValueType>
+spmv_kernel_base<ValueType> *
+select_spmv_kernel(const cusp::csr_matrix<IndexType,ValueType,cusp::host_memory>& A,
+                   const cusp::matrix_structure& s,
+                   const cusp::autotune_options& options)
+{
+    typedef cusp::coo_matrix<IndexType,ValueType,cusp::device_memory> DeviceCoo;
+    typedef cusp::csr_matrix<IndexType,ValueType,cusp::device_memory> DeviceCsr;
+    typedef cusp::dia_matrix<IndexType,ValueType,cusp::device_memory> DeviceDia;
+    typedef cusp::ell_matrix<IndexType,ValueType,cusp::device_memory> DeviceEll;
+    typedef cusp::hyb_matrix<IndexType,ValueType,cusp::device_memory> DeviceHyb;
+
+    // banded matrices
+    if (dia_is_admissible(s, options))
+    {
+        cusp::dia_matrix<IndexType,ValueType,cusp::host_memory> dia;
+        cusp::detail::host::csr_to_dia(A, dia);
+        return new spmv_kernel<DeviceDia>("dia_tiled", dia, cusp::detail::device::spmv_dia_tiled<DeviceDia,ValueType>);
+    }
+
+    // nearly uniform row lengths
+    if (ell_is_admissible(s, options))
+    {
+        cusp::ell_matrix<IndexType,ValueType,cusp::host_memory> ell;
+        cusp::detail::host::csr_to_ell(A, ell, s.max_entries_per_row);
+        return new spmv_kernel<DeviceEll>("ell_tex", ell, cusp::detail::device::spmv_ell_tex<DeviceEll,ValueType>);
+    }
+
+    // highly irregular row lengths (coefficient of variation > 1)
+    if (s.num_entries > 0 && s.stddev_entries_per_row > s.mean_entries_per_row)
+    {
+        return new spmv_kernel<DeviceCsr>("csr_merge_tex", A, cusp::detail::device::spmv_csr_merge_tex<DeviceCsr,ValueType>);
+    }
+
+    // a regular part with a few long rows
+    if (s.hyb_entries_per_row > 0)
+    {
+        cusp::hyb_matrix<IndexType,ValueType,cusp::host_memory> hyb;
+        cusp::detail::host::csr_to_hyb(A, hyb, s.hyb_entries_per_row);
+        return new spmv_kernel<DeviceHyb>("hyb_tex", hyb, cusp::detail::device::spmv_hyb_tex<DeviceHyb,ValueType>);
+    }
+
+    // too few rows for the ELL part to pay off
+    if (s.num_entries > 0)
+    {
+        cusp::coo_matrix<IndexType,ValueType,cusp::host_memory> coo(A);
+        return new spmv_kernel<DeviceCoo>("coo_flat_tex", coo, cusp::detail::device::spmv_coo_flat_tex<DeviceCoo,ValueType>);
+    }
+
+    return new spmv_kernel<DeviceCsr>("csr_vector", A, cusp::detail::device::spmv_csr_vector<DeviceCsr,ValueType>);
+}
+
+} // end namespace detail
+
+template <typename IndexType, typename ValueType>
+cusp::matrix_structure
+analyze_structure(const cusp::csr_matrix<IndexType,ValueType,cusp::host_memory>& A)
+{
+    cusp::matrix_structure s;
+
+    s.num_rows    = A.num_rows;
+    s.num_cols    = A.num_cols;
+    s.num_entries = A.num_entries;
+
+    if (A.num_rows == 0)
+        return s;
+
+    s.min_entries_per_row = A.num_entries;
+
+    double sum_of_squares = 0;
+
+    for(size_t i = 0; i < A.num_rows; i++)
+    {
+        const size_t length = A.row_offsets[i + 1] - A.row_offsets[i];
+
+        s.min_entries_per_row = std::min(s.min_entries_per_row, length);
+        s.max_entries_per_row = std::max(s.max_entries_per_row, length);
+        sum_of_squares += double(length) * double(length);
+
+        // bucket 0 holds empty rows, bucket k lengths in [2^(k-1), 2^k)
+        size_t bucket = 0;
+        for(size_t n = length; n > 0; n >>= 1)
+            bucket++;
+
+        if (s.row_length_histogram.size() <= bucket)
+            s.row_length_histogram.resize(bucket + 1, 0);
+
+        s.row_length_histogram[bucket]++;
+
+        for(IndexType jj = A.row_offsets[i]; jj < A.row_offsets[i + 1]; jj++)
+        {
+            const size_t j = A.column_indices[jj];
+            s.bandwidth = std::max(s.bandwidth, (i < j) ? j - i : i - j);
+        }
+    }
+
+    s.mean_entries_per_row   = double(A.num_entries) / double(A.num_rows);
+    s.stddev_entries_per_row = std::sqrt(std::max(0.0, sum_of_squares / double(A.num_rows) - s.mean_entries_per_row * s.mean_entries_per_row));
+
+    s.num_diagonals       = cusp::detail::host::count_diagonals(A);
+    s.hyb_entries_per_row = cusp::detail::host::compute_optimal_entries_per_row(A);
+
+    return s;
+}
+
+template <typename IndexType, typename ValueType>
+autotuned_spmv<IndexType,ValueType>
+::autotuned_spmv(const cusp::csr_matrix<IndexType,ValueType,cusp::host_memory>& A,
+                 const cusp::autotune_options& options)
+  : Parent(A.num_rows, A.num_cols, A.num_entries), kernel(0), milliseconds(0)
+{
+    CUSP_PROFILE_SCOPED();
+
+    structure_ = cusp::analyze_structure(A);
+
+    if (options.benchmark && A.num_entries > 0)
+        kernel = cusp::detail::benchmark_spmv_kernels(A, structure_, options, milliseconds);
+    else
+        kernel = cusp::detail::select_spmv_kernel(A, structure_, options);
+}
+
+template <typename IndexType, typename ValueType>
+autotuned_spmv<IndexType,ValueType>
+::~autotuned_spmv(void)
+{
+    delete kernel;
+}
+
+template <typename IndexType, typename ValueType>
+template <typename VectorType1, typename VectorType2>
+void autotuned_spmv<IndexType,ValueType>
+::operator()(const VectorType1& x, VectorType2& y) const
+{
+    if (x.size() != Parent::num_cols || y.size() != Parent::num_rows)
+        throw cusp::invalid_input_exception("array dimensions do not match the operator");
+
+    if (Parent::num_rows == 0)
+        return;
+
+    if (Parent::num_entries == 0)
+    {
+        cusp::blas::fill(y, ValueType(0));
+        return;
+    }
+
+    (*kernel)(thrust::raw_pointer_cast(&x[0]), thrust::raw_pointer_cast(&y[0]));
+}
+
+template <typename IndexType, typename ValueType>
+const std::string& autotuned_spmv<IndexType,ValueType>
+::kernel_name(void) const
+{
+    return kernel->name;
+}
+
+} // end namespace cusp
+
@@ -0,0 +1,319 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include <cusp/coo_matrix.h>
+#include <cusp/exception.h>
+#include <cusp/multiply.h>
+#include <cusp/detail/format_utils.h>
+
+#include <cusp/detail/device/spmv/bitmap.h>
+
+#include <thrust/binary_search.h>
+#include <thrust/copy.h>
+#include <thrust/count.h>
+#include <thrust/functional.h>
+#include <thrust/gather.h>
+#include <thrust/reduce.h>
+#include <thrust/remove.h>
+#include <thrust/scan.h>
+#include <thrust/sort.h>
+#include <thrust/transform.h>
+#include <thrust/tuple.h>
+#include <thrust/iterator/transform_iterator.h>
+#include <thrust/iterator/zip_iterator.h>
+
+namespace cusp
+{
+namespace detail
+{
+
+// the key of an entry is its tile, shifted by the log2 of the entries of a
+// tile, followed by its bit within the tile
+const unsigned int BITMAP_TILE_KEY_SHIFT = 6;
+
+template <typename IndexType>
+struct bitmap_tile_key
+{
+    unsigned long long num_tile_cols;
+
+    bitmap_tile_key(const unsigned long long num_tile_cols) : num_tile_cols(num_tile_cols) {}
+
+    template <typename Tuple>
+    __host__ __device__
+    unsigned long long operator()(const Tuple& t) const
+    {
+        const IndexType S = cusp::detail::device::BITMAP_TILE_SIZE;
+
+        const IndexType i = thrust::get<0>(t);
+        const IndexType j = thrust::get<1>(t);
+
+        const unsigned long long tile = (unsigned long long) (i / S) * num_tile_cols + (unsigned long long) (j / S);
+
+        return (tile << BITMAP_TILE_KEY_SHIFT) | (unsigned long long) ((i % S) * S + j % S);
+    }
+};
+
+struct bitmap_tile_id
+{
+    __host__ __device__
+    unsigned long long operator()(const unsigned long long key) const
+    {
+        return key >> BITMAP_TILE_KEY_SHIFT;
+    }
+};
+
+struct bitmap_tile_bit
+{
+    __host__ __device__
+    unsigned long long operator()(const unsigned long long key) const
+    {
+        return 1ull << (key & ((1ull << BITMAP_TILE_KEY_SHIFT) - 1));
+    }
+};
+
+struct bitmap_tile_is_dense
+{
+    unsigned int min_tile_entries;
+
+    bitmap_tile_is_dense(const unsigned int min_tile_entries) : min_tile_entries(min_tile_entries) {}
+
+    __host__ __device__
+    unsigned char operator()(const unsigned long long bitmap) const
+    {
+        return cusp::detail::device::bitmap_popcount(bitmap) >= min_tile_entries ? 1 : 0;
+    }
+};
+
+template <typename IndexType>
+struct bitmap_tile_count
+{
+    __host__ __device__
+    IndexType operator()(const unsigned long long bitmap) const
+    {
+        return cusp::detail::device::bitmap_popcount(bitmap);
+    }
+};
+
+// tile row and tile column of a tile
+template <typename IndexType>
+struct bitmap_tile_split
+{
+    unsigned long long num_tile_cols;
+
+    bitmap_tile_split(const unsigned long long num_tile_cols) : num_tile_cols(num_tile_cols) {}
+
+    __host__ __device__
+    thrust::tuple<IndexType,IndexType> operator()(const unsigned long long tile) const
+    {
+        return thrust::make_tuple(IndexType(tile / num_tile_cols), IndexType(tile % num_tile_cols));
+    }
+};
+
+// row and column of the entry of a key
+template <typename IndexType>
+struct bitmap_tile_entry
+{
+    unsigned long long num_tile_cols;
+
+    bitmap_tile_entry(const unsigned long long num_tile_cols) : num_tile_cols(num_tile_cols) {}
+
+    __host__ __device__
+    thrust::tuple<IndexType,IndexType> operator()(const unsigned long long key) const
+    {
+        const IndexType S = cusp::detail::device::BITMAP_TILE_SIZE;
+
+        const unsigned long long tile = key >> BITMAP_TILE_KEY_SHIFT;
+        const IndexType bit = IndexType(key & ((1ull << BITMAP_TILE_KEY_SHIFT) - 1));
+
+        return thrust::make_tuple(IndexType(tile / num_tile_cols) * S + bit / S,
+                                  IndexType(tile % num_tile_cols) * S + bit % S);
+    }
+};
+
+template <typename Matrix, typename ValueType>
+void bitmap_tile_multiply(const Matrix& A, const ValueType * x, ValueType * y, cusp::host_memory)
+{
+    typedef typename Matrix::index_type IndexType;
+
+    if (A.tile_bitmaps.empty())
+        return;
+
+    for (size_t i = 0; i < A.num_rows; i++)
+        y[i] += cusp::detail::device::bitmap_tile_row(IndexType(i),
+                                                      &A.tile_row_offsets[0], &A.tile_column_indices[0],
+                                                      &A.tile_bitmaps[0], &A.tile_value_offsets[0],
+                                                      &A.tile_values[0], x);
+}
+
+template <typename Matrix, typename ValueType>
+void bitmap_tile_multiply(const Matrix& A, const ValueType * x, ValueType * y, cusp::device_memory)
+{
+    cusp::detail::device::spmv_bitmap_tile(A, x, y);
+}
+
+} // end namespace detail
+
+template <typename IndexType, typename ValueType, typename MemorySpace>
+bitmap_tile_operator<IndexType,ValueType,MemorySpace>
+::bitmap_tile_operator(void)
+    : Parent(), tile_row_offsets(1, IndexType(0)), tile_value_offsets(1, IndexType(0))
+{
+}
+
+template <typename IndexType, typename ValueType, typename MemorySpace>
+template <typename MatrixType>
+bitmap_tile_operator<IndexType,ValueType,MemorySpace>
+::bitmap_tile_operator(const MatrixType& A, const size_t min_tile_entries)
+    : Parent(), tile_row_offsets(1, IndexType(0)), tile_value_offsets(1, IndexType(0))
+{
+    CUSP_PROFILE_SCOPED();
+
+    typedef unsigned long long KeyType;
+
+    const size_t S = cusp::detail::device::BITMAP_TILE_SIZE;
+
+    cusp::coo_matrix<IndexType,ValueType,MemorySpace> B(A);
+
+    const size_t num_entries = B.num_entries;
+
+    this->resize(B.num_rows, B.num_cols, num_entries);
+
+    const KeyType num_tile_rows = (B.num_rows + S - 1) / S;
+    const KeyType num_tile_cols = (B.num_cols + S - 1) / S;
+
+    if (num_tile_cols > 0 && num_tile_rows > (KeyType(1) << (64 - detail::BITMAP_TILE_KEY_SHIFT)) / num_tile_cols)
+        throw cusp::invalid_input_exception("matrix dimensions are too large for bitmap tiles");
+
+    tile_row_offsets.resize(num_tile_rows + 1, IndexType(0));
+
+    if (num_entries == 0)
+    {
+        tail = B;
+        return;
+    }
+
+    // entries sorted by tile, and by bit within each tile
+    cusp::array1d<KeyType,MemorySpace> keys(num_entries);
+    thrust::transform(thrust::make_zip_iterator(thrust::make_tuple(B.row_indices.begin(), B.column_indices.begin())),
+                      thrust::make_zip_iterator(thrust::make_tuple(B.row_indices.end(),   B.column_indices.end())),
+                      keys.begin(), detail::bitmap_tile_key<IndexType>(num_tile_cols));
+
+    thrust::sort_by_key(keys.begin(), keys.end(), B.values.begin());
+
+    // bitmap of every tile which holds an entry
+    cusp::array1d<KeyType,MemorySpace> tiles(num_entries);
+    cusp::array1d<KeyType,MemorySpace> bitmaps(num_entries);
+
+    const size_t num_nonempty_tiles =
+        thrust::reduce_by_key(thrust::make_transform_iterator(keys.begin(), detail::bitmap_tile_id()),
+                              thrust::make_transform_iterator(keys.end(),   detail::bitmap_tile_id()),
+                              thrust::make_transform_iterator(keys.begin(), detail::bitmap_tile_bit()),
+                              tiles.begin(), bitmaps.begin(),
+                              thrust::equal_to<KeyType>(), thrust::bit_or<KeyType>()).first - tiles.begin();
+
+    tiles.resize(num_nonempty_tiles);
+    bitmaps.resize(num_nonempty_tiles);
+
+    // whether each tile, and the tile of each entry, is kept as a tile
+    cusp::array1d<unsigned char,MemorySpace> tiled(num_nonempty_tiles);
+    thrust::transform(bitmaps.begin(), bitmaps.end(), tiled.begin(),
+                      detail::bitmap_tile_is_dense(min_tile_entries));
+
+    cusp::array1d<IndexType,MemorySpace> entry_tiles(num_entries);
+    thrust::lower_bound(tiles.begin(), tiles.end(),
+                        thrust::make_transform_iterator(keys.begin(), detail::bitmap_tile_id()),
+                        thrust::make_transform_iterator(keys.end(),   detail::bitmap_tile_id()),
+                        entry_tiles.begin());
+
+    cusp::array1d<unsigned char,MemorySpace> tiled_entries(num_entries);
+    thrust::gather(entry_tiles.begin(), entry_tiles.end(), tiled.begin(), tiled_entries.begin());
+
+    // the tiles and their packed values
+    const size_t num_tiles        = thrust::count(tiled.begin(), tiled.end(), (unsigned char) 1);
+    const size_t num_tile_entries = thrust::count(tiled_entries.begin(), tiled_entries.end(), (unsigned char) 1);
+
+    cusp::array1d<KeyType,MemorySpace> tile_ids(num_tiles);
+    tile_bitmaps.resize(num_tiles);
+    tile_values.resize(num_tile_entries);
+
+    thrust::copy_if(tiles.begin(), tiles.end(), tiled.begin(), tile_ids.begin(), thrust::identity<unsigned char>());
+    thrust::copy_if(bitmaps.begin(), bitmaps.end(), tiled.begin(), tile_bitmaps.begin(), thrust::identity<unsigned char>());
+    thrust::copy_if(B.values.begin(), B.values.end(), tiled_entries.begin(), tile_values.begin(), thrust::identity<unsigned char>());
+
+    tile_value_offsets.resize(num_tiles + 1);
+    thrust::transform(tile_bitmaps.begin(), tile_bitmaps.end(), tile_value_offsets.begin(), detail::bitmap_tile_count<IndexType>());
+    tile_value_offsets[num_tiles] = 0;
+    thrust::exclusive_scan(tile_value_offsets.begin(), tile_value_offsets.end(), tile_value_offsets.begin());
+
+    cusp::array1d<IndexType,MemorySpace> tile_rows(num_tiles);
+    tile_column_indices.resize(num_tiles);
+    thrust::transform(tile_ids.begin(), tile_ids.end(),
+                      thrust::make_zip_iterator(thrust::make_tuple(tile_rows.begin(), tile_column_indices.begin())),
+                      detail::bitmap_tile_split<IndexType>(num_tile_cols));
+    cusp::detail::indices_to_offsets(tile_rows, tile_row_offsets);
+
+    // the remaining entries
+    const size_t num_tail_entries = num_entries - num_tile_entries;
+
+    cusp::array1d<KeyType,MemorySpace> tail_keys(num_tail_entries);
+    cusp::coo_matrix<IndexType,ValueType,MemorySpace> T(B.num_rows, B.num_cols, num_tail_entries);
+
+    thrust::remove_copy_if(thrust::make_zip_iterator(thrust::make_tuple(keys.begin(), B.values.begin())),
+                           thrust::make_zip_iterator(thrust::make_tuple(keys.end(),   B.values.end())),
+                           tiled_entries.begin(),
+                           thrust::make_zip_iterator(thrust::make_tuple(tail_keys.begin(), T.values.begin())),
+                           thrust::identity<unsigned char>());
+    thrust::transform(tail_keys.begin(), tail_keys.end(),
+                      thrust::make_zip_iterator(thrust::make_tuple(T.row_indices.begin(), T.column_indices.begin())),
+                      detail::bitmap_tile_entry<IndexType>(num_tile_cols));
+
+    T.sort_by_row_and_column();
+    tail = T;
+}
+
+template <typename IndexType, typename ValueType, typename MemorySpace>
+template <typename MemorySpace2>
+bitmap_tile_operator<IndexType,ValueType,MemorySpace>
+::bitmap_tile_operator(const bitmap_tile_operator<IndexType,ValueType,MemorySpace2>& A)
+    : Parent(A.num_rows, A.num_cols, A.num_entries),
+      tile_row_offsets(A.tile_row_offsets), tile_column_indices(A.tile_column_indices),
+      tile_bitmaps(A.tile_bitmaps), tile_value_offsets(A.tile_value_offsets),
+      tile_values(A.tile_values), tail(A.tail)
+{
+}
+
+template <typename IndexType, typename ValueType, typename MemorySpace>
+template <typename VectorType1, typename VectorType2>
+void bitmap_tile_operator<IndexType,ValueType,MemorySpace>
+::operator()(const VectorType1& x, VectorType2& y) const
+{
+    CUSP_PROFILE_SCOPED();
+
+    if (x.size() != size_t(this->num_cols) || y.size() != size_t(this->num_rows))
+        throw cusp::invalid_input_exception("array dimensions do not match the operator");
+
+    if (this->num_rows == 0)
+        return;
+
+    cusp::multiply(tail, x, y);
+
+    detail::bitmap_tile_multiply(*this,
+                                 thrust::raw_pointer_cast(&x[0]),
+                                 thrust::raw_pointer_cast(&y[0]),
+                                 MemorySpace());
+}
+
+} // end namespace cusp
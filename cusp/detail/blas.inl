@@ -18,6 +18,17 @@
 #include <cusp/array1d.h>
 
 #include <cusp/exception.h>
+#include <cusp/reduction.h>
+#include <cusp/detail/stream.h>
+#include <cusp/detail/accumulator.h>
+#include <cusp/detail/functional.h>
+#include <cusp/detail/work_estimate.h>
+#include <cusp/detail/device/utils.h>
+#include <cusp/detail/dispatch/blas.h>
+
+#ifdef __CUSP_USE_MPI__
+#include <cusp/detail/mpi.h>
+#endif
 
 #include <thrust/copy.h>
 #include <thrust/fill.h>
@@ -25,6 +36,8 @@
 #include <thrust/transform.h>
 #include <thrust/transform_reduce.h>
 #include <thrust/inner_product.h>
+#include <thrust/pair.h>
+#include <thrust/tuple.h>
 
 #include <thrust/iterator/transform_iterator.h>
 
@@ -65,6 +78,40 @@ namespace detail
         assert_same_dimensions(array3, array4);
     }
 
+    template <typename ValueType>
+    void assert_same_layout(const cusp::distributed_array1d<ValueType>& array1,
+                            const cusp::distributed_array1d<ValueType>& array2)
+    {
+        if(array1.layout != array2.layout)
+            throw cusp::invalid_input_exception("distributed array layouts do not match");
+    }
+
+    template <typename ValueType>
+    void assert_same_layout(const cusp::distributed_array1d<ValueType>& array1,
+                            const cusp::distributed_array1d<ValueType>& array2,
+                            const cusp::distributed_array1d<ValueType>& array3)
+    {
+        assert_same_layout(array1, array2);
+        assert_same_layout(array2, array3);
+    }
+
+    template <typename ValueType>
+    void assert_same_layout(const cusp::mpi_array1d<ValueType>& array1,
+                            const cusp::mpi_array1d<ValueType>& array2)
+    {
+        if(array1.layout != array2.layout)
+            throw cusp::invalid_input_exception("MPI array layouts do not match");
+    }
+
+    template <typename ValueType>
+    void assert_same_layout(const cusp::mpi_array1d<ValueType>& array1,
+                            const cusp::mpi_array1d<ValueType>& array2,
+                            const cusp::mpi_array1d<ValueType>& array3)
+    {
+        assert_same_layout(array1, array2);
+        assert_same_layout(array2, array3);
+    }
+
     // square<T> computes the square of a number f(x) -> x*x
     template <typename T>
         struct square : public thrust::unary_function<T,T>
@@ -232,9 +279,9 @@ namespace detail
 	    ScalarType alpha)
   {
     size_t N = last1 - first1;
-    thrust::for_each(thrust::make_zip_iterator(thrust::make_tuple(first1, first2)),
-                     thrust::make_zip_iterator(thrust::make_tuple(first1, first2)) + N,
-                     detail::AXPY<ScalarType>(alpha));
+    cusp::detail::stream::for_each(thrust::make_zip_iterator(thrust::make_tuple(first1, first2)),
+                                   thrust::make_zip_iterator(thrust::make_tuple(first1, first2)) + N,
+                                   detail::AXPY<ScalarType>(alpha));
   }
 
   template <typename InputIterator1,
@@ -250,9 +297,9 @@ namespace detail
 	     ScalarType2 beta)
   {
     size_t N = last1 - first1;
-    thrust::for_each(thrust::make_zip_iterator(thrust::make_tuple(first1, first2, output)),
-                     thrust::make_zip_iterator(thrust::make_tuple(first1, first2, output)) + N,
-                     detail::AXPBY<ScalarType1,ScalarType2>(alpha, beta));
+    cusp::detail::stream::for_each(thrust::make_zip_iterator(thrust::make_tuple(first1, first2, output)),
+                                   thrust::make_zip_iterator(thrust::make_tuple(first1, first2, output)) + N,
+                                   detail::AXPBY<ScalarType1,ScalarType2>(alpha, beta));
   }
 
   template <typename InputIterator1,
@@ -273,9 +320,9 @@ namespace detail
   {
     CUSP_PROFILE_SCOPED();
     size_t N = last1 - first1;
-    thrust::for_each(thrust::make_zip_iterator(thrust::make_tuple(first1, first2, first3, output)),
-                     thrust::make_zip_iterator(thrust::make_tuple(first1, first2, first3, output)) + N,
-                     detail::AXPBYPCZ<ScalarType1,ScalarType2,ScalarType3>(alpha, beta, gamma));
+    cusp::detail::stream::for_each(thrust::make_zip_iterator(thrust::make_tuple(first1, first2, first3, output)),
+                                   thrust::make_zip_iterator(thrust::make_tuple(first1, first2, first3, output)) + N,
+                                   detail::AXPBYPCZ<ScalarType1,ScalarType2,ScalarType3>(alpha, beta, gamma));
   }
   
   template <typename InputIterator1,
@@ -287,7 +334,7 @@ namespace detail
 	   OutputIterator output)
   {
     typedef typename thrust::iterator_value<OutputIterator>::type ScalarType;
-    thrust::transform(first1, last1, first2, output, detail::XMY<ScalarType>());
+    cusp::detail::stream::transform(first1, last1, first2, output, detail::XMY<ScalarType>());
   }
   
   template <typename InputIterator,
@@ -296,7 +343,7 @@ namespace detail
 	    InputIterator   last1,
 	    ForwardIterator first2)
   {
-    thrust::copy(first1, last1, first2);
+    cusp::detail::stream::copy(first1, last1, first2);
   }
   
   template <typename InputIterator1,
@@ -307,7 +354,7 @@ namespace detail
       InputIterator2 first2)
   {
     typedef typename thrust::iterator_value<InputIterator1>::type OutputType;
-    return thrust::inner_product(first1, last1, first2, OutputType(0));
+    return cusp::detail::stream::inner_product(first1, last1, first2, OutputType(0));
   }
 
   template <typename InputIterator1,
@@ -318,10 +365,10 @@ namespace detail
        InputIterator2 first2)
   {
     typedef typename thrust::iterator_value<InputIterator1>::type OutputType;
-    return thrust::inner_product(thrust::make_transform_iterator(first1, detail::conjugate<OutputType>()),
-                                 thrust::make_transform_iterator(last1,  detail::conjugate<OutputType>()),
-                                 first2,
-                                 OutputType(0));
+    return cusp::detail::stream::inner_product(thrust::make_transform_iterator(first1, detail::conjugate<OutputType>()),
+                                               thrust::make_transform_iterator(last1,  detail::conjugate<OutputType>()),
+                                               first2,
+                                               OutputType(0));
   }
 
   template <typename ForwardIterator,
@@ -330,7 +377,7 @@ namespace detail
 	    ForwardIterator last,
 	    ScalarType alpha)
   {
-    thrust::fill(first, last, alpha);
+    cusp::detail::stream::fill(first, last, alpha);
   }
   
   template <typename InputIterator>
@@ -345,7 +392,7 @@ namespace detail
     
     ValueType init = 0;
     
-    return abs(thrust::transform_reduce(first, last, unary_op, init, binary_op));
+    return abs(cusp::detail::stream::transform_reduce(first, last, unary_op, init, binary_op));
   }
 
   template <typename InputIterator>
@@ -360,7 +407,7 @@ namespace detail
 
     ValueType init = 0;
 
-    return std::sqrt( abs(thrust::transform_reduce(first, last, unary_op, init, binary_op)) );
+    return std::sqrt( abs(cusp::detail::stream::transform_reduce(first, last, unary_op, init, binary_op)) );
   }
 
   template <typename InputIterator>
@@ -375,7 +422,7 @@ namespace detail
 
     ValueType init = 0;
 
-    return thrust::transform_reduce(first, last, unary_op, init, binary_op);
+    return cusp::detail::stream::transform_reduce(first, last, unary_op, init, binary_op);
   }
 
   template <typename ForwardIterator,
@@ -384,9 +431,117 @@ namespace detail
 	    ForwardIterator last,
 	    ScalarType alpha)
   {
-    thrust::for_each(first,
-                     last,
-                     detail::SCAL<ScalarType>(alpha));
+    cusp::detail::stream::for_each(first,
+                                   last,
+                                   detail::SCAL<ScalarType>(alpha));
+  }
+
+  // DOT_TERM maps (x, y) to x * y, conjugating x when Conjugate is true
+  template <typename T, bool Conjugate>
+  struct DOT_TERM : public thrust::binary_function<T,T,T>
+  {
+    __host__ __device__
+    T operator()(T x, T y) const
+    {
+      return cusp::detail::conjugate_if<Conjugate>()(x) * y;
+    }
+  };
+
+  // NORM_TERM maps (x, x) to x * conj(x)
+  template <typename T>
+  struct NORM_TERM : public thrust::binary_function<T,T,T>
+  {
+    __host__ __device__
+    T operator()(T x, T) const
+    {
+      return x * cusp::detail::conjugate_value(x);
+    }
+  };
+
+  // PRODUCT_ACCUMULATOR maps (x, y) to an accumulator holding x * y,
+  // conjugating x when Conjugate is true
+  template <typename T, bool Conjugate, typename Accumulation>
+  struct PRODUCT_ACCUMULATOR : public thrust::unary_function<thrust::tuple<T,T>, cusp::detail::accumulator<T,Accumulation> >
+  {
+    template <typename Tuple>
+    __host__ __device__
+    cusp::detail::accumulator<T,Accumulation> operator()(const Tuple& t) const
+    {
+      cusp::detail::accumulator<T,Accumulation> acc;
+      acc.add_product(cusp::detail::conjugate_if<Conjugate>()(T(thrust::get<0>(t))), T(thrust::get<1>(t)));
+      return acc;
+    }
+  };
+
+  // dot product with the rounding errors carried in a second term
+  template <bool Conjugate,
+            typename Array1,
+            typename Array2>
+  typename Array1::value_type
+  compensated_dot(const Array1& x,
+                  const Array2& y)
+  {
+    typedef typename Array1::value_type ValueType;
+    typedef cusp::detail::accumulator<ValueType, cusp::detail::compensated_accumulation> Accumulator;
+
+    return cusp::detail::stream::transform_reduce
+        (thrust::make_zip_iterator(thrust::make_tuple(x.begin(), y.begin())),
+         thrust::make_zip_iterator(thrust::make_tuple(x.begin(), y.begin())) + x.size(),
+         PRODUCT_ACCUMULATOR<ValueType, Conjugate, cusp::detail::compensated_accumulation>(),
+         Accumulator(),
+         thrust::plus<Accumulator>()).result();
+  }
+
+  // dot product in the fixed summation order of cusp/reduction.h
+  template <bool Conjugate,
+            typename Array1,
+            typename Array2>
+  typename Array1::value_type
+  reproducible_dot(const Array1& x,
+                   const Array2& y)
+  {
+    typedef typename Array1::value_type ValueType;
+
+    return cusp::detail::dispatch::reproducible_sum<ValueType>(x, y, DOT_TERM<ValueType,Conjugate>(),
+                                                               typename Array1::memory_space(),
+                                                               typename Array2::memory_space());
+  }
+
+  template <bool Conjugate,
+            typename Array1,
+            typename Array2>
+  typename Array1::value_type
+  dot(const Array1& x,
+      const Array2& y,
+      cusp::reduction_mode mode)
+  {
+    assert_same_dimensions(x, y);
+
+    if (mode == cusp::reproducible_reduction)
+      return reproducible_dot<Conjugate>(x, y);
+    else if (mode == cusp::compensated_reduction)
+      return compensated_dot<Conjugate>(x, y);
+    else if (Conjugate)
+      return cusp::blas::detail::dotc(x.begin(), x.end(), y.begin());
+    else
+      return cusp::blas::detail::dot(x.begin(), x.end(), y.begin());
+  }
+
+  template <typename Array>
+  typename norm_type<typename Array::value_type>::type
+  nrm2(const Array& x,
+       cusp::reduction_mode mode)
+  {
+    typedef typename Array::value_type ValueType;
+
+    if (mode == cusp::reproducible_reduction)
+      return std::sqrt( abs(cusp::detail::dispatch::reproducible_sum<ValueType>(x, x, NORM_TERM<ValueType>(),
+                                                                                typename Array::memory_space(),
+                                                                                typename Array::memory_space())) );
+    else if (mode == cusp::compensated_reduction)
+      return std::sqrt( abs(compensated_dot<true>(x, x)) );
+    else
+      return cusp::blas::detail::nrm2(x.begin(), x.end());
   }
 } // end namespace detail
 
@@ -410,6 +565,7 @@ void axpy(const Array1& x,
           ScalarType alpha)
 {
     CUSP_PROFILE_SCOPED();
+    CUSP_PROFILE_WORK(cusp::detail::vector_bytes(x, 3), 2.0 * x.size());
     detail::assert_same_dimensions(x, y);
     cusp::blas::detail::axpy(x.begin(), x.end(), y.begin(), alpha);
 }
@@ -422,6 +578,7 @@ void axpy(const Array1& x,
           ScalarType alpha)
 {
     CUSP_PROFILE_SCOPED();
+    CUSP_PROFILE_WORK(cusp::detail::vector_bytes(x, 3), 2.0 * x.size());
     detail::assert_same_dimensions(x, y);
     cusp::blas::detail::axpy(x.begin(), x.end(), y.begin(), alpha);
 }
@@ -453,6 +610,7 @@ void axpby(const Array1& x,
            ScalarType2 beta)
 {
     CUSP_PROFILE_SCOPED();
+    CUSP_PROFILE_WORK(cusp::detail::vector_bytes(x, 3), 3.0 * x.size());
     detail::assert_same_dimensions(x, y, z);
     cusp::blas::detail::axpby(x.begin(), x.end(), y.begin(), z.begin(), alpha, beta);
 }
@@ -469,6 +627,7 @@ void axpby(const Array1& x,
            ScalarType2 beta)
 {
     CUSP_PROFILE_SCOPED();
+    CUSP_PROFILE_WORK(cusp::detail::vector_bytes(x, 3), 3.0 * x.size());
     detail::assert_same_dimensions(x, y, z);
     cusp::blas::detail::axpby(x.begin(), x.end(), y.begin(), z.begin(), alpha, beta);
 }
@@ -507,6 +666,7 @@ void axpbypcz(const Array1& x,
 	      ScalarType3 gamma)
 {
     CUSP_PROFILE_SCOPED();
+    CUSP_PROFILE_WORK(cusp::detail::vector_bytes(x, 4), 5.0 * x.size());
     detail::assert_same_dimensions(x, y, z, output);
     cusp::blas::detail::axpbypcz(x.begin(), x.end(), y.begin(), z.begin(), output.begin(), alpha, beta, gamma);
 }
@@ -527,6 +687,7 @@ void axpbypcz(const Array1& x,
 	      ScalarType3 gamma)
 {
     CUSP_PROFILE_SCOPED();
+    CUSP_PROFILE_WORK(cusp::detail::vector_bytes(x, 4), 5.0 * x.size());
     detail::assert_same_dimensions(x, y, z, output);
     cusp::blas::detail::axpbypcz(x.begin(), x.end(), y.begin(), z.begin(), output.begin(), alpha, beta, gamma);
 }
@@ -541,7 +702,7 @@ void xmy(InputIterator1 first1,
          OutputIterator output)
 {
     typedef typename thrust::iterator_value<OutputIterator>::type ScalarType;
-    thrust::transform(first1, last1, first2, output, detail::XMY<ScalarType>());
+    cusp::detail::stream::transform(first1, last1, first2, output, detail::XMY<ScalarType>());
 }
 
 template <typename Array1,
@@ -552,6 +713,7 @@ void xmy(const Array1& x,
                Array3& output)
 {
     CUSP_PROFILE_SCOPED();
+    CUSP_PROFILE_WORK(cusp::detail::vector_bytes(x, 3), 1.0 * x.size());
     detail::assert_same_dimensions(x, y, output);
     cusp::blas::detail::xmy(x.begin(), x.end(), y.begin(), output.begin());
 }
@@ -564,6 +726,7 @@ void xmy(const Array1& x,
          const Array3& output)
 {
     CUSP_PROFILE_SCOPED();
+    CUSP_PROFILE_WORK(cusp::detail::vector_bytes(x, 3), 1.0 * x.size());
     detail::assert_same_dimensions(x, y, output);
     cusp::blas::detail::xmy(x.begin(), x.end(), y.begin(), output.begin());
 }
@@ -574,7 +737,7 @@ void copy(InputIterator   first1,
           InputIterator   last1,
           ForwardIterator first2)
 {
-    thrust::copy(first1, last1, first2);
+    cusp::detail::stream::copy(first1, last1, first2);
 }
 
 template <typename Array1,
@@ -583,6 +746,7 @@ void copy(const Array1& x,
                 Array2& y)
 {
     CUSP_PROFILE_SCOPED();
+    CUSP_PROFILE_WORK(cusp::detail::vector_bytes(x, 2), 0.0);
     detail::assert_same_dimensions(x, y);
     cusp::blas::detail::copy(x.begin(), x.end(), y.begin());
 }
@@ -593,6 +757,7 @@ void copy(const Array1& x,
           const Array2& y)
 {
     CUSP_PROFILE_SCOPED();
+    CUSP_PROFILE_WORK(cusp::detail::vector_bytes(x, 2), 0.0);
     detail::assert_same_dimensions(x, y);
     cusp::blas::detail::copy(x.begin(), x.end(), y.begin());
 }
@@ -607,7 +772,7 @@ typename thrust::iterator_value<InputIterator1>::type
         InputIterator2 first2)
 {
     typedef typename thrust::iterator_value<InputIterator1>::type OutputType;
-    return thrust::inner_product(first1, last1, first2, OutputType(0));
+    return cusp::detail::stream::inner_product(first1, last1, first2, OutputType(0));
 }
 
 // TODO properly harmonize heterogenous types
@@ -618,8 +783,20 @@ typename Array1::value_type
         const Array2& y)
 {
     CUSP_PROFILE_SCOPED();
-    detail::assert_same_dimensions(x, y);
-    return cusp::blas::detail::dot(x.begin(), x.end(), y.begin());
+    CUSP_PROFILE_WORK(cusp::detail::vector_bytes(x, 2), 2.0 * x.size());
+    return cusp::blas::detail::dot<false>(x, y, cusp::current_reduction_mode());
+}
+
+template <typename Array1,
+          typename Array2>
+typename Array1::value_type
+    dot(const Array1& x,
+        const Array2& y,
+        cusp::reduction_mode mode)
+{
+    CUSP_PROFILE_SCOPED();
+    CUSP_PROFILE_WORK(cusp::detail::vector_bytes(x, 2), 2.0 * x.size());
+    return cusp::blas::detail::dot<false>(x, y, mode);
 }
 
 // TODO properly harmonize heterogenous types
@@ -631,10 +808,10 @@ typename thrust::iterator_value<InputIterator1>::type
          InputIterator2 first2)
 {
     typedef typename thrust::iterator_value<InputIterator1>::type OutputType;
-    return thrust::inner_product(thrust::make_transform_iterator(first1, detail::conjugate<OutputType>()),
-                                 thrust::make_transform_iterator(last1,  detail::conjugate<OutputType>()),
-                                 first2,
-                                 OutputType(0));
+    return cusp::detail::stream::inner_product(thrust::make_transform_iterator(first1, detail::conjugate<OutputType>()),
+                                               thrust::make_transform_iterator(last1,  detail::conjugate<OutputType>()),
+                                               first2,
+                                               OutputType(0));
 }
 
 // TODO properly harmonize heterogenous types
@@ -645,8 +822,20 @@ typename Array1::value_type
          const Array2& y)
 {
     CUSP_PROFILE_SCOPED();
-    detail::assert_same_dimensions(x, y);
-    return cusp::blas::detail::dotc(x.begin(), x.end(), y.begin());
+    CUSP_PROFILE_WORK(cusp::detail::vector_bytes(x, 2), 2.0 * x.size());
+    return cusp::blas::detail::dot<true>(x, y, cusp::current_reduction_mode());
+}
+
+template <typename Array1,
+          typename Array2>
+typename Array1::value_type
+    dotc(const Array1& x,
+         const Array2& y,
+         cusp::reduction_mode mode)
+{
+    CUSP_PROFILE_SCOPED();
+    CUSP_PROFILE_WORK(cusp::detail::vector_bytes(x, 2), 2.0 * x.size());
+    return cusp::blas::detail::dot<true>(x, y, mode);
 }
 
 
@@ -657,7 +846,7 @@ void fill(ForwardIterator first,
           ForwardIterator last,
           ScalarType alpha)
 {
-    thrust::fill(first, last, alpha);
+    cusp::detail::stream::fill(first, last, alpha);
 }
 
 template <typename Array,
@@ -666,6 +855,7 @@ void fill(Array& x,
 	  ScalarType alpha)
 {
     CUSP_PROFILE_SCOPED();
+    CUSP_PROFILE_WORK(cusp::detail::vector_bytes(x, 1), 0.0);
     cusp::blas::detail::fill(x.begin(), x.end(), alpha);
 }
 
@@ -675,6 +865,7 @@ void fill(const Array& x,
           ScalarType alpha)
 {
     CUSP_PROFILE_SCOPED();
+    CUSP_PROFILE_WORK(cusp::detail::vector_bytes(x, 1), 0.0);
     cusp::blas::detail::fill(x.begin(), x.end(), alpha);
 }
 
@@ -691,7 +882,7 @@ typename norm_type<typename thrust::iterator_value<InputIterator>::type>::type
 
     ValueType init = 0;
 
-    return thrust::transform_reduce(first, last, unary_op, init, binary_op);
+    return cusp::detail::stream::transform_reduce(first, last, unary_op, init, binary_op);
 }
 
 template <typename Array>
@@ -699,6 +890,7 @@ typename norm_type<typename Array::value_type>::type
     nrm1(const Array& x)
 {
     CUSP_PROFILE_SCOPED();
+    CUSP_PROFILE_WORK(cusp::detail::vector_bytes(x, 1), 1.0 * x.size());
     return cusp::blas::detail::nrm1(x.begin(), x.end());
 }
 
@@ -715,7 +907,7 @@ typename norm_type<typename thrust::iterator_value<InputIterator>::type>::type
 
     ValueType init = 0;
 
-    return std::sqrt( thrust::transform_reduce(first, last, unary_op, init, binary_op) );
+    return std::sqrt( cusp::detail::stream::transform_reduce(first, last, unary_op, init, binary_op) );
 }
 
 template <typename Array>
@@ -723,7 +915,18 @@ typename norm_type<typename Array::value_type>::type
     nrm2(const Array& x)
 {
     CUSP_PROFILE_SCOPED();
-    return cusp::blas::detail::nrm2(x.begin(), x.end());
+    CUSP_PROFILE_WORK(cusp::detail::vector_bytes(x, 1), 2.0 * x.size());
+    return cusp::blas::detail::nrm2(x, cusp::current_reduction_mode());
+}
+
+template <typename Array>
+typename norm_type<typename Array::value_type>::type
+    nrm2(const Array& x,
+         cusp::reduction_mode mode)
+{
+    CUSP_PROFILE_SCOPED();
+    CUSP_PROFILE_WORK(cusp::detail::vector_bytes(x, 1), 2.0 * x.size());
+    return cusp::blas::detail::nrm2(x, mode);
 }
 
 
@@ -739,7 +942,7 @@ typename thrust::iterator_value<InputIterator>::type
 
     ValueType init = 0;
 
-    return thrust::transform_reduce(first, last, unary_op, init, binary_op);
+    return cusp::detail::stream::transform_reduce(first, last, unary_op, init, binary_op);
 }
 
 template <typename Array>
@@ -747,6 +950,7 @@ typename Array::value_type
     nrmmax(const Array& x)
 {
     CUSP_PROFILE_SCOPED();
+    CUSP_PROFILE_WORK(cusp::detail::vector_bytes(x, 1), 1.0 * x.size());
     return cusp::blas::detail::nrmmax(x.begin(), x.end());
 }
 
@@ -758,7 +962,7 @@ void scal(ForwardIterator first,
           ScalarType alpha)
 {
     typedef typename thrust::iterator_value<ForwardIterator>::type ValueType;
-    thrust::transform(first, last, first, detail::SCAL<ValueType>(alpha));
+    cusp::detail::stream::transform(first, last, first, detail::SCAL<ValueType>(alpha));
 }
 
 template <typename Array,
@@ -767,6 +971,7 @@ void scal(Array& x,
           ScalarType alpha)
 {
     CUSP_PROFILE_SCOPED();
+    CUSP_PROFILE_WORK(cusp::detail::vector_bytes(x, 2), 1.0 * x.size());
     cusp::blas::detail::scal(x.begin(), x.end(), alpha);
 }
 
@@ -776,9 +981,709 @@ void scal(const Array& x,
           ScalarType alpha)
 {
     CUSP_PROFILE_SCOPED();
+    CUSP_PROFILE_WORK(cusp::detail::vector_bytes(x, 2), 1.0 * x.size());
     cusp::blas::detail::scal(x.begin(), x.end(), alpha);
 }
 
+
+/////////////////////
+// Fused Reductions //
+/////////////////////
+
+namespace detail
+{
+
+// DOT2 maps (x, y, z) to (x * y, x * z), conjugating x when Conjugate is true
+template <typename T, bool Conjugate>
+struct DOT2 : public thrust::unary_function<thrust::tuple<T,T,T>, thrust::tuple<T,T> >
+{
+    template <typename Tuple>
+    __host__ __device__
+    thrust::tuple<T,T> operator()(const Tuple& t) const
+    {
+        const T x = cusp::detail::conjugate_if<Conjugate>()(T(thrust::get<0>(t)));
+        return thrust::make_tuple(x * T(thrust::get<1>(t)), x * T(thrust::get<2>(t)));
+    }
+};
+
+// PLUS2 adds pairs of sums
+template <typename T>
+struct PLUS2 : public thrust::binary_function<thrust::tuple<T,T>, thrust::tuple<T,T>, thrust::tuple<T,T> >
+{
+    __host__ __device__
+    thrust::tuple<T,T> operator()(const thrust::tuple<T,T>& a, const thrust::tuple<T,T>& b) const
+    {
+        return thrust::make_tuple(thrust::get<0>(a) + thrust::get<0>(b),
+                                  thrust::get<1>(a) + thrust::get<1>(b));
+    }
+};
+
+// AXPY_DOT updates y <- alpha * x + y and maps (x, y, z) to z * y with the
+// updated y, conjugating z when Conjugate is true.  z is read after y is
+// written so that it may be the same vector as y.
+template <typename T, bool Conjugate>
+struct AXPY_DOT
+{
+    T alpha;
+
+    AXPY_DOT(T _alpha)
+        : alpha(_alpha) {}
+
+    template <typename Tuple>
+    __host__ __device__
+    T operator()(Tuple t) const
+    {
+        const T y = alpha * T(thrust::get<0>(t)) + T(thrust::get<1>(t));
+        thrust::get<1>(t) = y;
+        return cusp::detail::conjugate_if<Conjugate>()(T(thrust::get<2>(t))) * y;
+    }
+};
+
+template <bool Conjugate,
+          typename Array1,
+          typename Array2,
+          typename Array3>
+thrust::pair<typename Array1::value_type, typename Array1::value_type>
+    dot2(const Array1& x,
+         const Array2& y,
+         const Array3& z)
+{
+    typedef typename Array1::value_type ValueType;
+
+    assert_same_dimensions(x, y, z);
+
+    const cusp::reduction_mode mode = cusp::current_reduction_mode();
+
+    if (mode != cusp::fast_reduction)
+        return thrust::make_pair(dot<Conjugate>(x, y, mode),
+                                 dot<Conjugate>(x, z, mode));
+
+    thrust::tuple<ValueType,ValueType> sums =
+        cusp::detail::stream::transform_reduce
+            (thrust::make_zip_iterator(thrust::make_tuple(x.begin(), y.begin(), z.begin())),
+             thrust::make_zip_iterator(thrust::make_tuple(x.begin(), y.begin(), z.begin())) + x.size(),
+             DOT2<ValueType,Conjugate>(),
+             thrust::make_tuple(ValueType(0), ValueType(0)),
+             PLUS2<ValueType>());
+
+    return thrust::make_pair(thrust::get<0>(sums), thrust::get<1>(sums));
+}
+
+template <bool Conjugate,
+          typename Array1,
+          typename Array2,
+          typename Array3,
+          typename ScalarType>
+typename Array2::value_type
+    axpy_dot(const Array1& x,
+                   Array2& y,
+             const Array3& z,
+             ScalarType alpha)
+{
+    typedef typename Array2::value_type ValueType;
+
+    assert_same_dimensions(x, y, z);
+
+    const cusp::reduction_mode mode = cusp::current_reduction_mode();
+
+    if (mode != cusp::fast_reduction)
+    {
+        cusp::blas::detail::axpy(x.begin(), x.end(), y.begin(), alpha);
+        return dot<Conjugate>(z, y, mode);
+    }
+
+    return cusp::detail::stream::transform_reduce
+        (thrust::make_zip_iterator(thrust::make_tuple(x.begin(), y.begin(), z.begin())),
+         thrust::make_zip_iterator(thrust::make_tuple(x.begin(), y.begin(), z.begin())) + x.size(),
+         AXPY_DOT<ValueType,Conjugate>(ValueType(alpha)),
+         ValueType(0),
+         thrust::plus<ValueType>());
+}
+
+template <bool Conjugate,
+          typename Array1,
+          typename Array2d,
+          typename Array2>
+void mdot(const Array1& x,
+          const Array2d& Y,
+                Array2& result)
+{
+    typedef typename Array2d::value_type   ValueType;
+    typedef typename Array2d::memory_space MemorySpace;
+
+    if (x.size() != Y.num_rows || result.size() != Y.num_cols)
+        throw cusp::invalid_input_exception("array dimensions do not match");
+
+    if (Y.num_cols == 0)
+        return;
+
+    if (Y.num_rows == 0)
+    {
+        cusp::blas::fill(result, ValueType(0));
+        return;
+    }
+
+    const cusp::reduction_mode mode = cusp::current_reduction_mode();
+
+    if (mode != cusp::fast_reduction)
+    {
+        for (size_t j = 0; j < Y.num_cols; j++)
+            result[j] = dot<Conjugate>(x, Y.column(j), mode);
+        return;
+    }
+
+    // all the dot products are computed in the memory space of Y and
+    // transferred at once
+    cusp::array1d<ValueType,MemorySpace> dots(Y.num_cols);
+
+    cusp::detail::dispatch::mdot<Conjugate>(x, Y, dots,
+                                            typename Array1::memory_space(),
+                                            MemorySpace());
+
+    cusp::blas::detail::copy(dots.begin(), dots.end(), result.begin());
+}
+
+} // end namespace detail
+
+template <typename Array1,
+          typename Array2,
+          typename Array3>
+thrust::pair<typename Array1::value_type, typename Array1::value_type>
+    dot2(const Array1& x,
+         const Array2& y,
+         const Array3& z)
+{
+    CUSP_PROFILE_SCOPED();
+    return cusp::blas::detail::dot2<false>(x, y, z);
+}
+
+template <typename Array1,
+          typename Array2,
+          typename Array3>
+thrust::pair<typename Array1::value_type, typename Array1::value_type>
+    dotc2(const Array1& x,
+          const Array2& y,
+          const Array3& z)
+{
+    CUSP_PROFILE_SCOPED();
+    return cusp::blas::detail::dot2<true>(x, y, z);
+}
+
+template <typename Array1,
+          typename Array2,
+          typename Array3,
+          typename ScalarType>
+typename Array2::value_type
+    axpy_dot(const Array1& x,
+                   Array2& y,
+             const Array3& z,
+             ScalarType alpha)
+{
+    CUSP_PROFILE_SCOPED();
+    return cusp::blas::detail::axpy_dot<false>(x, y, z, alpha);
+}
+
+template <typename Array1,
+          typename Array2,
+          typename Array3,
+          typename ScalarType>
+typename Array2::value_type
+    axpy_dot(const Array1& x,
+             const Array2& y,
+             const Array3& z,
+             ScalarType alpha)
+{
+    CUSP_PROFILE_SCOPED();
+    return cusp::blas::detail::axpy_dot<false>(x, y, z, alpha);
+}
+
+template <typename Array1,
+          typename Array2,
+          typename Array3,
+          typename ScalarType>
+typename Array2::value_type
+    axpy_dotc(const Array1& x,
+                    Array2& y,
+              const Array3& z,
+              ScalarType alpha)
+{
+    CUSP_PROFILE_SCOPED();
+    return cusp::blas::detail::axpy_dot<true>(x, y, z, alpha);
+}
+
+template <typename Array1,
+          typename Array2,
+          typename Array3,
+          typename ScalarType>
+typename Array2::value_type
+    axpy_dotc(const Array1& x,
+              const Array2& y,
+              const Array3& z,
+              ScalarType alpha)
+{
+    CUSP_PROFILE_SCOPED();
+    return cusp::blas::detail::axpy_dot<true>(x, y, z, alpha);
+}
+
+template <typename Array1,
+          typename Array2d,
+          typename Array2>
+void mdot(const Array1& x,
+          const Array2d& Y,
+                Array2& result)
+{
+    CUSP_PROFILE_SCOPED();
+    cusp::blas::detail::mdot<false>(x, Y, result);
+}
+
+template <typename Array1,
+          typename Array2d,
+          typename Array2>
+void mdotc(const Array1& x,
+           const Array2d& Y,
+                 Array2& result)
+{
+    CUSP_PROFILE_SCOPED();
+    cusp::blas::detail::mdot<true>(x, Y, result);
+}
+
+
+////////////////////////////
+// Dense Level-2, Level-3 //
+////////////////////////////
+
+namespace detail
+{
+
+// y = beta * y without reading y when beta is zero
+template <typename Array,
+          typename ValueType>
+void scale_output(Array& y, const ValueType beta)
+{
+    if (beta == ValueType(0))
+        cusp::blas::fill(y, ValueType(0));
+    else
+        cusp::blas::scal(y, beta);
+}
+
+template <typename Array2d,
+          typename Array1,
+          typename Array2,
+          typename ScalarType1,
+          typename ScalarType2>
+void gemv(const Array2d& A,
+          const Array1& x,
+                Array2& y,
+          ScalarType1 alpha,
+          ScalarType2 beta)
+{
+    typedef typename Array2::value_type ValueType;
+
+    if (A.num_rows != y.size() || A.num_cols != x.size())
+        throw cusp::invalid_input_exception("array dimensions do not match");
+
+    if (A.num_rows == 0)
+        return;
+
+    if (A.num_cols == 0)
+    {
+        scale_output(y, ValueType(beta));
+        return;
+    }
+
+    cusp::detail::dispatch::gemv(A, x, y, ValueType(alpha), ValueType(beta),
+                                 typename Array2d::memory_space(),
+                                 typename Array1::memory_space(),
+                                 typename Array2::memory_space());
+}
+
+template <typename Array2d1,
+          typename Array2d2,
+          typename Array2d3,
+          typename ScalarType1,
+          typename ScalarType2>
+void gemm(const Array2d1& A,
+          const Array2d2& B,
+                Array2d3& C,
+          ScalarType1 alpha,
+          ScalarType2 beta)
+{
+    typedef typename Array2d3::value_type ValueType;
+
+    if (A.num_cols != B.num_rows || C.num_rows != A.num_rows || C.num_cols != B.num_cols)
+        throw cusp::invalid_input_exception("array dimensions do not match");
+
+    if (C.num_rows == 0 || C.num_cols == 0)
+        return;
+
+    if (A.num_cols == 0)
+    {
+        scale_output(C.values, ValueType(beta));
+        return;
+    }
+
+    cusp::detail::dispatch::gemm(A, B, C, ValueType(alpha), ValueType(beta),
+                                 typename Array2d1::memory_space(),
+                                 typename Array2d2::memory_space(),
+                                 typename Array2d3::memory_space());
+}
+
+template <typename Array2d1,
+          typename Array2d2>
+void trsm(const Array2d1& A,
+                Array2d2& B,
+          bool lower,
+          bool unit_diagonal)
+{
+    if (A.num_rows != A.num_cols || A.num_rows != B.num_rows)
+        throw cusp::invalid_input_exception("array dimensions do not match");
+
+    if (B.num_rows == 0 || B.num_cols == 0)
+        return;
+
+    cusp::detail::dispatch::trsm(A, B, lower, unit_diagonal,
+                                 typename Array2d1::memory_space(),
+                                 typename Array2d2::memory_space());
+}
+
+} // end namespace detail
+
+template <typename Array2d,
+          typename Array1,
+          typename Array2,
+          typename ScalarType1,
+          typename ScalarType2>
+void gemv(const Array2d& A,
+          const Array1& x,
+                Array2& y,
+          ScalarType1 alpha,
+          ScalarType2 beta)
+{
+    CUSP_PROFILE_SCOPED();
+    cusp::blas::detail::gemv(A, x, y, alpha, beta);
+}
+
+template <typename Array2d,
+          typename Array1,
+          typename Array2,
+          typename ScalarType1,
+          typename ScalarType2>
+void gemv(const Array2d& A,
+          const Array1& x,
+          const Array2& y,
+          ScalarType1 alpha,
+          ScalarType2 beta)
+{
+    CUSP_PROFILE_SCOPED();
+    cusp::blas::detail::gemv(A, x, y, alpha, beta);
+}
+
+template <typename Array2d,
+          typename Array1,
+          typename Array2>
+void gemv(const Array2d& A,
+          const Array1& x,
+                Array2& y)
+{
+    CUSP_PROFILE_SCOPED();
+    cusp::blas::detail::gemv(A, x, y, 1, 0);
+}
+
+template <typename Array2d1,
+          typename Array2d2,
+          typename Array2d3,
+          typename ScalarType1,
+          typename ScalarType2>
+void gemm(const Array2d1& A,
+          const Array2d2& B,
+                Array2d3& C,
+          ScalarType1 alpha,
+          ScalarType2 beta)
+{
+    CUSP_PROFILE_SCOPED();
+    cusp::blas::detail::gemm(A, B, C, alpha, beta);
+}
+
+template <typename Array2d1,
+          typename Array2d2,
+          typename Array2d3,
+          typename ScalarType1,
+          typename ScalarType2>
+void gemm(const Array2d1& A,
+          const Array2d2& B,
+          const Array2d3& C,
+          ScalarType1 alpha,
+          ScalarType2 beta)
+{
+    CUSP_PROFILE_SCOPED();
+    cusp::blas::detail::gemm(A, B, C, alpha, beta);
+}
+
+template <typename Array2d1,
+          typename Array2d2,
+          typename Array2d3>
+void gemm(const Array2d1& A,
+          const Array2d2& B,
+                Array2d3& C)
+{
+    CUSP_PROFILE_SCOPED();
+    cusp::blas::detail::gemm(A, B, C, 1, 0);
+}
+
+template <typename Array2d1,
+          typename Array2d2>
+void trsm(const Array2d1& A,
+                Array2d2& B,
+          bool lower,
+          bool unit_diagonal)
+{
+    CUSP_PROFILE_SCOPED();
+    cusp::blas::detail::trsm(A, B, lower, unit_diagonal);
+}
+
+template <typename Array2d1,
+          typename Array2d2>
+void trsm(const Array2d1& A,
+          const Array2d2& B,
+          bool lower,
+          bool unit_diagonal)
+{
+    CUSP_PROFILE_SCOPED();
+    cusp::blas::detail::trsm(A, B, lower, unit_diagonal);
+}
+
+
+////////////////////////
+// Distributed Arrays //
+////////////////////////
+
+template <typename ValueType,
+          typename ScalarType>
+void axpy(const cusp::distributed_array1d<ValueType>& x,
+                cusp::distributed_array1d<ValueType>& y,
+          ScalarType alpha)
+{
+    CUSP_PROFILE_SCOPED();
+    detail::assert_same_layout(x, y);
+
+    for (size_t p = 0; p < x.num_parts(); p++)
+    {
+        cusp::detail::device::device_scope scope(x.layout.devices[p]);
+        cusp::blas::axpy(x.parts[p], y.parts[p], alpha);
+    }
+}
+
+template <typename ValueType,
+          typename ScalarType1,
+          typename ScalarType2>
+void axpby(const cusp::distributed_array1d<ValueType>& x,
+           const cusp::distributed_array1d<ValueType>& y,
+                 cusp::distributed_array1d<ValueType>& z,
+           ScalarType1 alpha,
+           ScalarType2 beta)
+{
+    CUSP_PROFILE_SCOPED();
+    detail::assert_same_layout(x, y, z);
+
+    for (size_t p = 0; p < x.num_parts(); p++)
+    {
+        cusp::detail::device::device_scope scope(x.layout.devices[p]);
+        cusp::blas::axpby(x.parts[p], y.parts[p], z.parts[p], alpha, beta);
+    }
+}
+
+template <typename ValueType>
+void copy(const cusp::distributed_array1d<ValueType>& x,
+                cusp::distributed_array1d<ValueType>& y)
+{
+    CUSP_PROFILE_SCOPED();
+    detail::assert_same_layout(x, y);
+
+    for (size_t p = 0; p < x.num_parts(); p++)
+    {
+        cusp::detail::device::device_scope scope(x.layout.devices[p]);
+        cusp::blas::copy(x.parts[p], y.parts[p]);
+    }
+}
+
+template <typename ValueType>
+ValueType dot(const cusp::distributed_array1d<ValueType>& x,
+              const cusp::distributed_array1d<ValueType>& y)
+{
+    CUSP_PROFILE_SCOPED();
+    detail::assert_same_layout(x, y);
+
+    ValueType result(0);
+
+    for (size_t p = 0; p < x.num_parts(); p++)
+    {
+        cusp::detail::device::device_scope scope(x.layout.devices[p]);
+        result += cusp::blas::dot(x.parts[p], y.parts[p]);
+    }
+
+    return result;
+}
+
+template <typename ValueType>
+ValueType dotc(const cusp::distributed_array1d<ValueType>& x,
+               const cusp::distributed_array1d<ValueType>& y)
+{
+    CUSP_PROFILE_SCOPED();
+    detail::assert_same_layout(x, y);
+
+    ValueType result(0);
+
+    for (size_t p = 0; p < x.num_parts(); p++)
+    {
+        cusp::detail::device::device_scope scope(x.layout.devices[p]);
+        result += cusp::blas::dotc(x.parts[p], y.parts[p]);
+    }
+
+    return result;
+}
+
+template <typename ValueType,
+          typename ScalarType>
+void fill(cusp::distributed_array1d<ValueType>& x,
+          ScalarType alpha)
+{
+    CUSP_PROFILE_SCOPED();
+
+    for (size_t p = 0; p < x.num_parts(); p++)
+    {
+        cusp::detail::device::device_scope scope(x.layout.devices[p]);
+        cusp::blas::fill(x.parts[p], alpha);
+    }
+}
+
+template <typename ValueType>
+typename norm_type<ValueType>::type
+    nrm2(const cusp::distributed_array1d<ValueType>& x)
+{
+    CUSP_PROFILE_SCOPED();
+
+    // sum the squares of the parts before taking the root
+    ValueType result(0);
+
+    for (size_t p = 0; p < x.num_parts(); p++)
+    {
+        cusp::detail::device::device_scope scope(x.layout.devices[p]);
+        result += cusp::detail::stream::transform_reduce(x.parts[p].begin(), x.parts[p].end(),
+                                                         detail::norm_squared<ValueType>(),
+                                                         ValueType(0),
+                                                         thrust::plus<ValueType>());
+    }
+
+    return std::sqrt(abs(result));
+}
+
+template <typename ValueType,
+          typename ScalarType>
+void scal(cusp::distributed_array1d<ValueType>& x,
+          ScalarType alpha)
+{
+    CUSP_PROFILE_SCOPED();
+
+    for (size_t p = 0; p < x.num_parts(); p++)
+    {
+        cusp::detail::device::device_scope scope(x.layout.devices[p]);
+        cusp::blas::scal(x.parts[p], alpha);
+    }
+}
+
+#ifdef __CUSP_USE_MPI__
+
+////////////////
+// MPI Arrays //
+////////////////
+
+template <typename ValueType,
+          typename ScalarType>
+void axpy(const cusp::mpi_array1d<ValueType>& x,
+                cusp::mpi_array1d<ValueType>& y,
+          ScalarType alpha)
+{
+    CUSP_PROFILE_SCOPED();
+    detail::assert_same_layout(x, y);
+    cusp::blas::axpy(x.local, y.local, alpha);
+}
+
+template <typename ValueType,
+          typename ScalarType1,
+          typename ScalarType2>
+void axpby(const cusp::mpi_array1d<ValueType>& x,
+           const cusp::mpi_array1d<ValueType>& y,
+                 cusp::mpi_array1d<ValueType>& z,
+           ScalarType1 alpha,
+           ScalarType2 beta)
+{
+    CUSP_PROFILE_SCOPED();
+    detail::assert_same_layout(x, y, z);
+    cusp::blas::axpby(x.local, y.local, z.local, alpha, beta);
+}
+
+template <typename ValueType>
+void copy(const cusp::mpi_array1d<ValueType>& x,
+                cusp::mpi_array1d<ValueType>& y)
+{
+    CUSP_PROFILE_SCOPED();
+    detail::assert_same_layout(x, y);
+    cusp::blas::copy(x.local, y.local);
+}
+
+template <typename ValueType>
+ValueType dot(const cusp::mpi_array1d<ValueType>& x,
+              const cusp::mpi_array1d<ValueType>& y)
+{
+    CUSP_PROFILE_SCOPED();
+    detail::assert_same_layout(x, y);
+    return cusp::detail::mpi_sum(cusp::blas::dot(x.local, y.local), x.layout.comm);
+}
+
+template <typename ValueType>
+ValueType dotc(const cusp::mpi_array1d<ValueType>& x,
+               const cusp::mpi_array1d<ValueType>& y)
+{
+    CUSP_PROFILE_SCOPED();
+    detail::assert_same_layout(x, y);
+    return cusp::detail::mpi_sum(cusp::blas::dotc(x.local, y.local), x.layout.comm);
+}
+
+template <typename ValueType,
+          typename ScalarType>
+void fill(cusp::mpi_array1d<ValueType>& x,
+          ScalarType alpha)
+{
+    CUSP_PROFILE_SCOPED();
+    cusp::blas::fill(x.local, alpha);
+}
+
+template <typename ValueType>
+typename norm_type<ValueType>::type
+    nrm2(const cusp::mpi_array1d<ValueType>& x)
+{
+    CUSP_PROFILE_SCOPED();
+
+    // sum the squares of the local rows before taking the root
+    ValueType result = cusp::detail::stream::transform_reduce(x.local.begin(), x.local.end(),
+                                                              detail::norm_squared<ValueType>(),
+                                                              ValueType(0),
+                                                              thrust::plus<ValueType>());
+
+    return std::sqrt(abs(cusp::detail::mpi_sum(result, x.layout.comm)));
+}
+
+template <typename ValueType,
+          typename ScalarType>
+void scal(cusp::mpi_array1d<ValueType>& x,
+          ScalarType alpha)
+{
+    CUSP_PROFILE_SCOPED();
+    cusp::blas::scal(x.local, alpha);
+}
+
+#endif // __CUSP_USE_MPI__
+
 } // end namespace blas
 } // end namespace cusp
 
@@ -0,0 +1,71 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include <cusp/convert.h>
+#include <cusp/copy.h>
+
+namespace cusp
+{
+
+//////////////////
+// Constructors //
+//////////////////
+
+// construct from a different matrix
+template <typename IndexType, typename ValueType, class MemorySpace>
+template <typename MatrixType>
+bsr_matrix<IndexType,ValueType,MemorySpace>
+    ::bsr_matrix(const MatrixType& matrix)
+      : block_size(1)
+    {
+        cusp::convert(matrix, *this);
+    }
+
+// construct from a different matrix with the given block size
+template <typename IndexType, typename ValueType, class MemorySpace>
+template <typename MatrixType>
+bsr_matrix<IndexType,ValueType,MemorySpace>
+    ::bsr_matrix(const MatrixType& matrix, size_t block_size)
+      : block_size(block_size)
+    {
+        // convert in the memory space of the source so the block size is preserved
+        typedef typename cusp::bsr_matrix<IndexType,ValueType,typename MatrixType::memory_space> SourceSpaceMatrix;
+
+        SourceSpaceMatrix tmp;
+        tmp.block_size = block_size;
+
+        cusp::convert(matrix, tmp);
+        cusp::copy(tmp, *this);
+    }
+
+//////////////////////
+// Member Functions //
+//////////////////////
+
+// assignment from another matrix
+template <typename IndexType, typename ValueType, class MemorySpace>
+template <typename MatrixType>
+    bsr_matrix<IndexType,ValueType,MemorySpace>&
+    bsr_matrix<IndexType,ValueType,MemorySpace>
+    ::operator=(const MatrixType& matrix)
+    {
+        cusp::convert(matrix, *this);
+
+        return *this;
+    }
+
+} // end namespace cusp
+
@@ -0,0 +1,143 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include <cusp/blas.h>
+#include <cusp/exception.h>
+#include <cusp/format.h>
+#include <cusp/multiply.h>
+#include <cusp/detail/functional.h>
+
+#include <thrust/functional.h>
+
+namespace cusp
+{
+namespace detail
+{
+
+// y <- alpha * A * x
+template <typename Operator, typename VectorType1, typename VectorType2, typename ValueType>
+void scaled_multiply(const Operator& A, const VectorType1& x, VectorType2& y, const ValueType alpha)
+{
+    cusp::multiply(A, x, y, alpha, ValueType(0));
+}
+
+// y <- y + beta * B * x
+template <typename Operator, typename VectorType1, typename VectorType2, typename ValueType, typename WorkArray>
+void accumulate_multiply(const Operator& B, const VectorType1& x, VectorType2& y, const ValueType beta, WorkArray& work,
+                         thrust::detail::true_type)
+{
+    cusp::generalized_multiply(B, x, y,
+                               thrust::identity<ValueType>(),
+                               scaled_multiplies<ValueType>(beta),
+                               thrust::plus<ValueType>());
+}
+
+template <typename Operator, typename VectorType1, typename VectorType2, typename ValueType, typename WorkArray>
+void accumulate_multiply(const Operator& B, const VectorType1& x, VectorType2& y, const ValueType beta, WorkArray& work,
+                         thrust::detail::false_type)
+{
+    work.resize(y.size());
+    cusp::multiply(B, x, work);
+    cusp::blas::axpy(work, y, beta);
+}
+
+template <typename Operator, typename VectorType1, typename VectorType2, typename ValueType, typename WorkArray>
+void accumulate_multiply(const Operator& B, const VectorType1& x, VectorType2& y, const ValueType beta, WorkArray& work)
+{
+    accumulate_multiply(B, x, y, beta, work, typename fused_multiply<Operator>::type());
+}
+
+template <typename IndexType, typename MemorySpace, typename VectorType1, typename VectorType2, typename ValueType, typename WorkArray>
+void accumulate_multiply(const cusp::identity_operator<ValueType,MemorySpace,IndexType>& B,
+                         const VectorType1& x, VectorType2& y, const ValueType beta, WorkArray& work)
+{
+    cusp::blas::axpy(x, y, beta);
+}
+
+} // end namespace detail
+
+//////////////////
+// sum_operator //
+//////////////////
+
+template <typename Operator1, typename Operator2>
+sum_operator<Operator1,Operator2>
+::sum_operator(const Operator1& A, const Operator2& B, value_type alpha, value_type beta)
+    : Parent(A.num_rows, A.num_cols, A.num_entries + B.num_entries), A(A), B(B), alpha(alpha), beta(beta)
+{
+    if (A.num_rows != B.num_rows || A.num_cols != B.num_cols)
+        throw cusp::invalid_input_exception("the operators of a sum must have the same shape");
+}
+
+template <typename Operator1, typename Operator2>
+template <typename VectorType1, typename VectorType2>
+void sum_operator<Operator1,Operator2>
+::operator()(const VectorType1& x, VectorType2& y) const
+{
+    CUSP_PROFILE_SCOPED();
+
+    detail::scaled_multiply(A, x, y, alpha);
+    detail::accumulate_multiply(B, x, y, beta, work);
+}
+
+//////////////////////
+// product_operator //
+//////////////////////
+
+template <typename Operator1, typename Operator2>
+product_operator<Operator1,Operator2>
+::product_operator(const Operator1& A, const Operator2& B)
+    : Parent(A.num_rows, B.num_cols, A.num_entries + B.num_entries), A(A), B(B)
+{
+    if (A.num_cols != B.num_rows)
+        throw cusp::invalid_input_exception("the operators of a product have incompatible shapes");
+}
+
+template <typename Operator1, typename Operator2>
+template <typename VectorType1, typename VectorType2>
+void product_operator<Operator1,Operator2>
+::operator()(const VectorType1& x, VectorType2& y) const
+{
+    CUSP_PROFILE_SCOPED();
+
+    work.resize(B.num_rows);
+
+    cusp::multiply(B, x, work);
+    cusp::multiply(A, work, y);
+}
+
+/////////////////////
+// scaled_operator //
+/////////////////////
+
+template <typename Operator>
+scaled_operator<Operator>
+::scaled_operator(value_type alpha, const Operator& A)
+    : Parent(A.num_rows, A.num_cols, A.num_entries), A(A), alpha(alpha)
+{
+}
+
+template <typename Operator>
+template <typename VectorType1, typename VectorType2>
+void scaled_operator<Operator>
+::operator()(const VectorType1& x, VectorType2& y) const
+{
+    CUSP_PROFILE_SCOPED();
+
+    detail::scaled_multiply(A, x, y, alpha);
+}
+
+} // end namespace cusp
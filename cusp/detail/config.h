@@ -32,14 +32,33 @@
 #define CUSP_DEPRECATED THRUST_DEPRECATED
 
 // hooks for profiling
-#if defined(CUSP_PROFILE_ENABLED)
+#if defined(CUSP_PROFILE_ENABLED) && defined(CUSP_PROFILE_DEVICE)
+// profiling enabled, device time per call path from CUDA events
+#define CUSP_PROFILE_TIME_SCOPED()  cusp::detail::device_profiler::scoped cusp_profile_scope(CUSP_DEVICE_PROFILE_FUNCTION())
+#define CUSP_PROFILE_DUMP()    cusp::detail::device_profiler::dump()
+#define CUSP_PROFILE_WORK(bytes, flops) cusp::detail::device_profiler::add_work(bytes, flops)
+#include <cusp/detail/device_profiler.h>
+#elif defined(CUSP_PROFILE_ENABLED)
 // profiling enabled
-#define CUSP_PROFILE_SCOPED()  PROFILE_SCOPED()
+#define CUSP_PROFILE_TIME_SCOPED()  PROFILE_SCOPED()
 #define CUSP_PROFILE_DUMP()    cusp::detail::profiler::dump()
+#define CUSP_PROFILE_WORK(bytes, flops)
 #include <cusp/detail/profiler.h>
 #else
 // profiling disabled
-#define CUSP_PROFILE_SCOPED()
+#define CUSP_PROFILE_TIME_SCOPED()
 #define CUSP_PROFILE_DUMP()
+#define CUSP_PROFILE_WORK(bytes, flops)
 #endif
 
+// hooks for device memory tracking, regions follow the profiler scopes
+#if defined(CUSP_TRACK_MEMORY)
+#define CUSP_MEMORY_SCOPED()   cusp::detail::memory_tracker::scoped cusp_memory_scope(CUSP_MEMORY_TRACKER_FUNCTION())
+#define CUSP_MEMORY_DUMP()     cusp::detail::memory_tracker::dump()
+#include <cusp/detail/memory_tracker.h>
+#else
+#define CUSP_MEMORY_SCOPED()
+#define CUSP_MEMORY_DUMP()
+#endif
+
+#define CUSP_PROFILE_SCOPED()  CUSP_PROFILE_TIME_SCOPED(); CUSP_MEMORY_SCOPED()
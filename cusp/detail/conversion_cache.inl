@@ -0,0 +1,176 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+#include <cusp/format.h>
+#include <cusp/convert.h>
+
+#include <thrust/memory.h>
+
+namespace cusp
+{
+namespace detail
+{
+
+// an address per type, the key of the destination of a conversion
+template <typename T>
+struct conversion_type_id
+{
+    static const char value;
+};
+
+template <typename T>
+const char conversion_type_id<T>::value = 0;
+
+// first value of the storage of a matrix, which changes when the matrix
+// is reallocated
+template <typename Array>
+const void * first_value(const Array& values)
+{
+    return values.size() == 0 ? NULL : (const void *) thrust::raw_pointer_cast(&values[0]);
+}
+
+template <typename MatrixType>
+const void * conversion_storage(const MatrixType& A, cusp::coo_format)     { return first_value(A.values); }
+template <typename MatrixType>
+const void * conversion_storage(const MatrixType& A, cusp::csr_format)     { return first_value(A.values); }
+template <typename MatrixType>
+const void * conversion_storage(const MatrixType& A, cusp::dia_format)     { return first_value(A.values.values); }
+template <typename MatrixType>
+const void * conversion_storage(const MatrixType& A, cusp::ell_format)     { return first_value(A.values.values); }
+template <typename MatrixType>
+const void * conversion_storage(const MatrixType& A, cusp::hyb_format)     { return first_value(A.ell.values.values); }
+template <typename MatrixType>
+const void * conversion_storage(const MatrixType& A, cusp::array2d_format) { return first_value(A.values); }
+
+// other formats are only checked by their dimensions
+template <typename MatrixType, typename Format>
+const void * conversion_storage(const MatrixType& A, Format)               { return NULL; }
+
+// src in DestinationType: src itself when it already is, the conversion
+// held by the current conversion_cache, or temp converted from src
+template <typename DestinationType, typename SourceType>
+const DestinationType& cached_conversion(const SourceType& src, DestinationType& temp)
+{
+    cusp::conversion_cache * cache = cusp::current_conversion_cache();
+
+    if (cache != NULL)
+        return cache->template get<DestinationType>(src);
+
+    cusp::convert(src, temp);
+
+    return temp;
+}
+
+template <typename MatrixType>
+const MatrixType& cached_conversion(const MatrixType& src, MatrixType&)
+{
+    return src;
+}
+
+} // end namespace detail
+
+template <typename MatrixType>
+void conversion_cache
+::touch(const MatrixType& A)
+{
+    versions[&A]++;
+
+    drop(&A);
+}
+
+template <typename MatrixType>
+size_t conversion_cache
+::version(const MatrixType& A) const
+{
+    std::map<const void *, size_t>::const_iterator iter = versions.find(&A);
+
+    return iter == versions.end() ? 0 : iter->second;
+}
+
+inline void conversion_cache
+::clear(void)
+{
+    for (std::map<key_type, entry *>::iterator iter = entries.begin(); iter != entries.end(); ++iter)
+        delete iter->second;
+
+    entries.clear();
+}
+
+inline void conversion_cache
+::drop(const void * src)
+{
+    std::map<key_type, entry *>::iterator iter = entries.lower_bound(key_type(src, (const void *) NULL));
+
+    while (iter != entries.end() && iter->first.first == src)
+    {
+        delete iter->second;
+        entries.erase(iter++);
+    }
+}
+
+template <typename DestinationType, typename SourceType>
+const DestinationType& conversion_cache
+::get(const SourceType& src)
+{
+    const key_type key(&src, &cusp::detail::conversion_type_id<DestinationType>::value);
+
+    const size_t current_version = version(src);
+    const void * storage = cusp::detail::conversion_storage(src, typename SourceType::format());
+
+    std::map<key_type, entry *>::iterator iter = entries.find(key);
+
+    if (iter != entries.end())
+    {
+        const entry * e = iter->second;
+
+        if (e->version == current_version && e->storage == storage &&
+            e->num_rows == src.num_rows && e->num_cols == src.num_cols && e->num_entries == src.num_entries)
+        {
+            num_hits++;
+            return static_cast<holder<DestinationType> *>(iter->second)->matrix;
+        }
+
+        // stale
+        delete iter->second;
+        entries.erase(iter);
+    }
+
+    holder<DestinationType> * h = new holder<DestinationType>();
+
+    try
+    {
+        cusp::convert(src, h->matrix);
+    }
+    catch (...)
+    {
+        delete h;
+        throw;
+    }
+
+    h->version     = current_version;
+    h->num_rows    = src.num_rows;
+    h->num_cols    = src.num_cols;
+    h->num_entries = src.num_entries;
+    h->storage     = storage;
+
+    entries[key] = h;
+    num_misses++;
+
+    return h->matrix;
+}
+
+} // end namespace cusp
@@ -0,0 +1,434 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include <cusp/array1d.h>
+#include <cusp/convert.h>
+#include <cusp/csr_matrix.h>
+#include <cusp/exception.h>
+#include <cusp/format.h>
+
+#include <cusp/detail/format_utils.h>
+#include <cusp/detail/host/conversion.h>
+#include <cusp/detail/device/conversion.h>
+
+#include <thrust/binary_search.h>
+#include <thrust/extrema.h>
+#include <thrust/functional.h>
+#include <thrust/reduce.h>
+#include <thrust/scan.h>
+#include <thrust/scatter.h>
+#include <thrust/sort.h>
+#include <thrust/transform.h>
+#include <thrust/tuple.h>
+#include <thrust/iterator/constant_iterator.h>
+#include <thrust/iterator/counting_iterator.h>
+#include <thrust/iterator/transform_iterator.h>
+#include <thrust/iterator/zip_iterator.h>
+
+#include <algorithm>
+
+namespace cusp
+{
+namespace detail
+{
+
+// A(i,j) lies on diagonal j - i, stored at j - i + num_rows
+template <typename IndexType>
+struct plan_diagonal_functor
+{
+  typedef IndexType result_type;
+
+  const IndexType num_rows;
+
+  plan_diagonal_functor(const IndexType num_rows)
+    : num_rows(num_rows) {}
+
+  template <typename Tuple>
+  __host__ __device__
+  IndexType operator()(const Tuple& t) const
+  {
+    return thrust::get<1>(t) - thrust::get<0>(t) + num_rows;
+  }
+};
+
+// number of rows longer than k from the number of rows of length <= k
+template <typename IndexType>
+struct plan_overflow_functor
+{
+  typedef IndexType result_type;
+
+  const IndexType num_rows;
+
+  plan_overflow_functor(const IndexType num_rows)
+    : num_rows(num_rows) {}
+
+  __host__ __device__
+  IndexType operator()(const IndexType rows) const
+  {
+    return num_rows - rows;
+  }
+};
+
+// bytes and estimated time of a SpMV with the HYB format of ELL width K
+// and c entries in the COO part
+struct plan_hyb_cost
+{
+  typedef double result_type;
+
+  size_t pitch;
+  size_t index_bytes;
+  size_t value_bytes;
+  size_t vector_bytes;
+  double bytes_per_second;
+  double launch_latency;
+
+  __host__ __device__
+  size_t bytes(const size_t K, const size_t c) const
+  {
+    return pitch * K * (index_bytes + value_bytes) + c * (2 * index_bytes + value_bytes) + vector_bytes;
+  }
+
+  // the ELL kernel, and the two kernels of the COO part
+  __host__ __device__
+  size_t launches(const size_t K, const size_t c) const
+  {
+    const size_t n = (K > 0 ? 1 : 0) + (c > 0 ? 2 : 0);
+    return n > 0 ? n : 1;
+  }
+
+  __host__ __device__
+  double seconds(const size_t K, const size_t c) const
+  {
+    return double(bytes(K, c)) / bytes_per_second + double(launches(K, c)) * launch_latency;
+  }
+
+  template <typename Tuple>
+  __host__ __device__
+  double operator()(const Tuple& t) const
+  {
+    return seconds(thrust::get<0>(t), thrust::get<1>(t));
+  }
+};
+
+// fills in the plan from the row offsets and the row and column indices
+template <typename ValueType, typename Array1, typename Array2, typename Array3>
+void plan_conversion(const Array1& row_offsets,
+                     const Array2& row_indices,
+                     const Array3& column_indices,
+                     const cusp::conversion_plan_options& options,
+                     cusp::conversion_plan& plan)
+{
+  typedef typename Array1::value_type   IndexType;
+  typedef typename Array1::memory_space MemorySpace;
+
+  const size_t num_rows    = plan.num_rows;
+  const size_t num_cols    = plan.num_cols;
+  const size_t num_entries = plan.num_entries;
+
+  // distribution of the row lengths
+  cusp::array1d<IndexType,MemorySpace> row_lengths(num_rows);
+  thrust::transform(row_offsets.begin() + 1, row_offsets.end(),
+                    row_offsets.begin(),
+                    row_lengths.begin(),
+                    thrust::minus<IndexType>());
+
+  thrust::sort(row_lengths.begin(), row_lengths.end());
+
+  const size_t max_entries_per_row = row_lengths[num_rows - 1];
+
+  // coo_entries[K] = number of rows of length <= K
+  cusp::array1d<IndexType,MemorySpace> coo_entries(max_entries_per_row + 1);
+  thrust::upper_bound(row_lengths.begin(), row_lengths.end(),
+                      thrust::counting_iterator<IndexType>(0),
+                      thrust::counting_iterator<IndexType>(max_entries_per_row + 1),
+                      coo_entries.begin());
+
+  // coo_entries[K] = sum over k >= K of the rows longer than k,
+  //                = entries left over by an ELL part of width K
+  thrust::transform(coo_entries.begin(), coo_entries.end(), coo_entries.begin(),
+                    plan_overflow_functor<IndexType>(num_rows));
+  thrust::inclusive_scan(coo_entries.rbegin(), coo_entries.rend(), coo_entries.rbegin());
+
+  // occupied diagonals
+  size_t num_diagonals = 0;
+
+  if (num_entries > 0)
+  {
+    cusp::array1d<IndexType,MemorySpace> occupied(num_rows + num_cols, IndexType(0));
+
+    thrust::scatter(thrust::constant_iterator<IndexType>(1),
+                    thrust::constant_iterator<IndexType>(1) + num_entries,
+                    thrust::make_transform_iterator(thrust::make_zip_iterator(thrust::make_tuple(row_indices.begin(), column_indices.begin())),
+                                                    plan_diagonal_functor<IndexType>(num_rows)),
+                    occupied.begin());
+
+    num_diagonals = thrust::reduce(occupied.begin(), occupied.end());
+  }
+
+  // cost model
+  const size_t alignment = std::max<size_t>(1, options.alignment);
+  const size_t pitch     = alignment * ((num_rows + alignment - 1) / alignment);
+
+  plan_hyb_cost cost;
+  cost.pitch            = pitch;
+  cost.index_bytes      = sizeof(IndexType);
+  cost.value_bytes      = sizeof(ValueType);
+  cost.vector_bytes     = (num_entries + num_rows) * sizeof(ValueType);
+  cost.bytes_per_second = double(options.bandwidth) * 1e9;
+  cost.launch_latency   = options.launch_latency;
+
+  // the HYB width of least estimated time
+  typedef thrust::counting_iterator<IndexType>                                   WidthIterator;
+  typedef typename cusp::array1d<IndexType,MemorySpace>::iterator               EntryIterator;
+  typedef thrust::zip_iterator< thrust::tuple<WidthIterator,EntryIterator> >    ZipIterator;
+  typedef thrust::transform_iterator<plan_hyb_cost, ZipIterator>                CostIterator;
+
+  CostIterator cost_begin(ZipIterator(thrust::make_tuple(WidthIterator(0), coo_entries.begin())), cost);
+  CostIterator cost_end = cost_begin + coo_entries.size();
+
+  const size_t hyb_entries_per_row = thrust::min_element(cost_begin, cost_end) - cost_begin;
+
+  const size_t hyb_coo_entries = coo_entries[hyb_entries_per_row];
+
+  plan.alignment           = alignment;
+  plan.num_diagonals       = num_diagonals;
+  plan.max_entries_per_row = max_entries_per_row;
+  plan.hyb_entries_per_row = hyb_entries_per_row;
+  plan.hyb_coo_entries     = hyb_coo_entries;
+
+  plan.dia_fill = float(num_diagonals * pitch) / float(std::max<size_t>(1, num_entries));
+  plan.ell_fill = float(max_entries_per_row * pitch) / float(std::max<size_t>(1, num_entries));
+
+  plan.bytes[cusp::conversion_plan::coo] = cost.bytes(0, num_entries);
+  plan.bytes[cusp::conversion_plan::csr] = (num_rows + 1) * sizeof(IndexType) + num_entries * (sizeof(IndexType) + sizeof(ValueType)) + cost.vector_bytes;
+  plan.bytes[cusp::conversion_plan::dia] = num_diagonals * (sizeof(IndexType) + pitch * sizeof(ValueType)) + cost.vector_bytes;
+  plan.bytes[cusp::conversion_plan::ell] = cost.bytes(max_entries_per_row, 0);
+  plan.bytes[cusp::conversion_plan::hyb] = cost.bytes(hyb_entries_per_row, hyb_coo_entries);
+
+  plan.seconds[cusp::conversion_plan::coo] = cost.seconds(0, num_entries);
+  plan.seconds[cusp::conversion_plan::csr] = double(plan.bytes[cusp::conversion_plan::csr]) / cost.bytes_per_second + cost.launch_latency;
+  plan.seconds[cusp::conversion_plan::dia] = double(plan.bytes[cusp::conversion_plan::dia]) / cost.bytes_per_second + cost.launch_latency;
+  plan.seconds[cusp::conversion_plan::ell] = cost.seconds(max_entries_per_row, 0);
+  plan.seconds[cusp::conversion_plan::hyb] = cost.seconds(hyb_entries_per_row, hyb_coo_entries);
+
+  // ties go to the simpler format
+  plan.format = cusp::conversion_plan::csr;
+
+  for (size_t i = 0; i < cusp::conversion_plan::num_formats; i++)
+    if (plan.seconds[i] < plan.seconds[plan.format])
+      plan.format = cusp::conversion_plan::format_type(i);
+}
+
+template <typename Matrix>
+void plan_conversion(const Matrix& A,
+                     const cusp::conversion_plan_options& options,
+                     cusp::conversion_plan& plan,
+                     cusp::coo_format)
+{
+  typedef typename Matrix::index_type   IndexType;
+  typedef typename Matrix::value_type   ValueType;
+  typedef typename Matrix::memory_space MemorySpace;
+
+  cusp::array1d<IndexType,MemorySpace> row_offsets(A.num_rows + 1);
+  cusp::detail::indices_to_offsets(A.row_indices, row_offsets);
+
+  plan_conversion<ValueType>(row_offsets, A.row_indices, A.column_indices, options, plan);
+}
+
+template <typename Matrix>
+void plan_conversion(const Matrix& A,
+                     const cusp::conversion_plan_options& options,
+                     cusp::conversion_plan& plan,
+                     cusp::csr_format)
+{
+  typedef typename Matrix::index_type   IndexType;
+  typedef typename Matrix::value_type   ValueType;
+  typedef typename Matrix::memory_space MemorySpace;
+
+  cusp::array1d<IndexType,MemorySpace> row_indices(A.num_entries);
+  cusp::detail::offsets_to_indices(A.row_offsets, row_indices);
+
+  plan_conversion<ValueType>(A.row_offsets, row_indices, A.column_indices, options, plan);
+}
+
+/////////////////////
+// Planned Convert //
+/////////////////////
+
+// host conversions start from CSR
+template <typename Matrix1, typename Matrix2>
+void planned_convert_to(const Matrix1& src, Matrix2& dst, const cusp::conversion_plan& plan,
+                        cusp::csr_format, cusp::dia_format, cusp::host_memory)
+{    cusp::detail::host::csr_to_dia(src, dst, plan.alignment);    }
+
+template <typename Matrix1, typename Matrix2>
+void planned_convert_to(const Matrix1& src, Matrix2& dst, const cusp::conversion_plan& plan,
+                        cusp::csr_format, cusp::ell_format, cusp::host_memory)
+{    cusp::detail::host::csr_to_ell(src, dst, plan.max_entries_per_row, plan.alignment);    }
+
+template <typename Matrix1, typename Matrix2>
+void planned_convert_to(const Matrix1& src, Matrix2& dst, const cusp::conversion_plan& plan,
+                        cusp::csr_format, cusp::hyb_format, cusp::host_memory)
+{    cusp::detail::host::csr_to_hyb(src, dst, plan.hyb_entries_per_row, plan.alignment);    }
+
+template <typename Matrix1, typename Matrix2>
+void planned_convert_from(const Matrix1& src, Matrix2& dst, const cusp::conversion_plan& plan,
+                          cusp::coo_format, cusp::host_memory)
+{
+  typedef typename Matrix1::index_type IndexType;
+  typedef typename Matrix1::value_type ValueType;
+
+  cusp::csr_matrix<IndexType,ValueType,cusp::host_memory> csr(src);
+
+  planned_convert_to(csr, dst, plan, cusp::csr_format(), typename Matrix2::format(), cusp::host_memory());
+}
+
+template <typename Matrix1, typename Matrix2>
+void planned_convert_from(const Matrix1& src, Matrix2& dst, const cusp::conversion_plan& plan,
+                          cusp::csr_format, cusp::host_memory)
+{
+  planned_convert_to(src, dst, plan, cusp::csr_format(), typename Matrix2::format(), cusp::host_memory());
+}
+
+// device conversions start from COO or CSR
+template <typename Matrix1, typename Matrix2, typename Workspace>
+void planned_convert_to(const Matrix1& src, Matrix2& dst, Workspace& workspace, const cusp::conversion_plan& plan,
+                        cusp::coo_format, cusp::dia_format)
+{    cusp::detail::device::coo_to_dia(src, dst, workspace, plan.alignment);    }
+
+template <typename Matrix1, typename Matrix2, typename Workspace>
+void planned_convert_to(const Matrix1& src, Matrix2& dst, Workspace& workspace, const cusp::conversion_plan& plan,
+                        cusp::csr_format, cusp::dia_format)
+{    cusp::detail::device::csr_to_dia(src, dst, workspace, plan.alignment);    }
+
+template <typename Matrix1, typename Matrix2, typename Workspace>
+void planned_convert_to(const Matrix1& src, Matrix2& dst, Workspace& workspace, const cusp::conversion_plan& plan,
+                        cusp::coo_format, cusp::ell_format)
+{    cusp::detail::device::coo_to_ell(src, dst, workspace, plan.max_entries_per_row, plan.alignment);    }
+
+template <typename Matrix1, typename Matrix2, typename Workspace>
+void planned_convert_to(const Matrix1& src, Matrix2& dst, Workspace& workspace, const cusp::conversion_plan& plan,
+                        cusp::csr_format, cusp::ell_format)
+{    cusp::detail::device::csr_to_ell(src, dst, workspace, plan.max_entries_per_row, plan.alignment);    }
+
+template <typename Matrix1, typename Matrix2, typename Workspace>
+void planned_convert_to(const Matrix1& src, Matrix2& dst, Workspace& workspace, const cusp::conversion_plan& plan,
+                        cusp::coo_format, cusp::hyb_format)
+{    cusp::detail::device::coo_to_hyb(src, dst, workspace, plan.hyb_entries_per_row, plan.alignment);    }
+
+template <typename Matrix1, typename Matrix2, typename Workspace>
+void planned_convert_to(const Matrix1& src, Matrix2& dst, Workspace& workspace, const cusp::conversion_plan& plan,
+                        cusp::csr_format, cusp::hyb_format)
+{    cusp::detail::device::csr_to_hyb(src, dst, workspace, plan.hyb_entries_per_row, plan.alignment);    }
+
+template <typename Matrix1, typename Matrix2, typename Format>
+void planned_convert_from(const Matrix1& src, Matrix2& dst, const cusp::conversion_plan& plan,
+                          Format, cusp::device_memory)
+{
+  cusp::convert_workspace<cusp::device_memory> workspace;
+
+  planned_convert_to(src, dst, workspace, plan, Format(), typename Matrix2::format());
+}
+
+template <typename Matrix1, typename Matrix2, typename MemorySpace>
+void planned_convert(const Matrix1& src, Matrix2& dst, const cusp::conversion_plan& plan,
+                     MemorySpace, MemorySpace)
+{
+  planned_convert_from(src, dst, plan, typename Matrix1::format(), MemorySpace());
+}
+
+// convert in the memory space of the source and transfer the result
+template <typename Matrix1, typename Matrix2, typename MemorySpace1, typename MemorySpace2>
+void planned_convert(const Matrix1& src, Matrix2& dst, const cusp::conversion_plan& plan,
+                     MemorySpace1, MemorySpace2)
+{
+  typename Matrix2::template rebind<MemorySpace1>::type temp;
+
+  planned_convert_from(src, temp, plan, typename Matrix1::format(), MemorySpace1());
+
+  cusp::convert(temp, dst);
+}
+
+// DIA, ELL and HYB destinations use the planned parameters
+template <typename Matrix1, typename Matrix2>
+void planned_convert(const Matrix1& src, Matrix2& dst, const cusp::conversion_plan& plan,
+                     cusp::dia_format)
+{
+  planned_convert(src, dst, plan, typename Matrix1::memory_space(), typename Matrix2::memory_space());
+}
+
+template <typename Matrix1, typename Matrix2>
+void planned_convert(const Matrix1& src, Matrix2& dst, const cusp::conversion_plan& plan,
+                     cusp::ell_format)
+{
+  planned_convert(src, dst, plan, typename Matrix1::memory_space(), typename Matrix2::memory_space());
+}
+
+template <typename Matrix1, typename Matrix2>
+void planned_convert(const Matrix1& src, Matrix2& dst, const cusp::conversion_plan& plan,
+                     cusp::hyb_format)
+{
+  planned_convert(src, dst, plan, typename Matrix1::memory_space(), typename Matrix2::memory_space());
+}
+
+// other formats have nothing to plan
+template <typename Matrix1, typename Matrix2>
+void planned_convert(const Matrix1& src, Matrix2& dst, const cusp::conversion_plan& plan,
+                     cusp::known_format)
+{
+  cusp::convert(src, dst);
+}
+
+} // end namespace detail
+
+template <typename MatrixType>
+cusp::conversion_plan
+plan_conversion(const MatrixType& A,
+                const cusp::conversion_plan_options& options)
+{
+  CUSP_PROFILE_SCOPED();
+
+  cusp::conversion_plan plan;
+
+  plan.num_rows    = A.num_rows;
+  plan.num_cols    = A.num_cols;
+  plan.num_entries = A.num_entries;
+  plan.alignment   = options.alignment;
+
+  if (A.num_rows == 0)
+    return plan;
+
+  cusp::detail::plan_conversion(A, options, plan, typename MatrixType::format());
+
+  return plan;
+}
+
+template <typename SourceType, typename DestinationType>
+void convert(const SourceType& src, DestinationType& dst,
+             const cusp::conversion_plan& plan)
+{
+  CUSP_PROFILE_SCOPED();
+
+  if (src.num_rows != plan.num_rows || src.num_cols != plan.num_cols || src.num_entries != plan.num_entries)
+    throw cusp::invalid_input_exception("matrix does not match the conversion plan");
+
+  cusp::detail::planned_convert(src, dst, plan, typename DestinationType::format());
+}
+
+} // end namespace cusp
+
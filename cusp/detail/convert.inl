@@ -17,6 +17,9 @@
 #include <cusp/detail/dispatch/convert.h>
 
 #include <cusp/copy.h>
+#include <cusp/detail/format_utils.h>
+#include <cusp/detail/forward_definitions.h>
+#include <cusp/detail/work_estimate.h>
 
 namespace cusp
 {
@@ -43,6 +46,72 @@ void convert(const SourceType& src, DestinationType& dst,
       typename DestinationType::memory_space());
 }
 
+// same format
+template <typename SourceType, typename DestinationType, typename Workspace,
+          typename T1>
+void convert(const SourceType& src, DestinationType& dst, Workspace& workspace,
+             T1, T1)
+{
+  cusp::copy(src, dst);
+}
+
+// different formats
+template <typename SourceType, typename DestinationType, typename Workspace,
+          typename T1, typename T2>
+void convert(const SourceType& src, DestinationType& dst, Workspace& workspace,
+             T1, T2)
+{
+  cusp::detail::dispatch::convert(src, dst, workspace,
+      typename SourceType::memory_space(),
+      typename DestinationType::memory_space());
+}
+
+// CSR -> COO keeps the column indices and values of src
+template <typename IndexType, typename ValueType, typename MemorySpace>
+void convert_in_place(cusp::csr_matrix<IndexType,ValueType,MemorySpace>& src,
+                      cusp::coo_matrix<IndexType,ValueType,MemorySpace>& dst)
+{
+  cusp::array1d<IndexType,MemorySpace> row_indices(src.num_entries);
+  cusp::detail::offsets_to_indices(src.row_offsets, row_indices);
+
+  cusp::coo_matrix<IndexType,ValueType,MemorySpace> temp;
+  temp.row_indices.swap(row_indices);
+  temp.column_indices.swap(src.column_indices);
+  temp.values.swap(src.values);
+  temp.resize(src.num_rows, src.num_cols, src.num_entries);
+
+  dst.swap(temp);
+
+  cusp::csr_matrix<IndexType,ValueType,MemorySpace>().swap(src);
+}
+
+// COO -> CSR keeps the column indices and values of src
+template <typename IndexType, typename ValueType, typename MemorySpace>
+void convert_in_place(cusp::coo_matrix<IndexType,ValueType,MemorySpace>& src,
+                      cusp::csr_matrix<IndexType,ValueType,MemorySpace>& dst)
+{
+  cusp::array1d<IndexType,MemorySpace> row_offsets(src.num_rows + 1);
+  cusp::detail::indices_to_offsets(src.row_indices, row_offsets);
+
+  cusp::csr_matrix<IndexType,ValueType,MemorySpace> temp;
+  temp.row_offsets.swap(row_offsets);
+  temp.column_indices.swap(src.column_indices);
+  temp.values.swap(src.values);
+  temp.resize(src.num_rows, src.num_cols, src.num_entries);
+
+  dst.swap(temp);
+
+  cusp::coo_matrix<IndexType,ValueType,MemorySpace>().swap(src);
+}
+
+template <typename SourceType, typename DestinationType>
+void convert_in_place(SourceType& src, DestinationType& dst)
+{
+  cusp::convert(src, dst);
+
+  SourceType().swap(src);
+}
+
 } // end namespace detail
 
 /////////////////
@@ -56,6 +125,29 @@ void convert(const SourceType& src, DestinationType& dst)
   cusp::detail::convert(src, dst,
       typename SourceType::format(),
       typename DestinationType::format());
+
+  CUSP_PROFILE_WORK(cusp::detail::storage_bytes(src) + cusp::detail::storage_bytes(dst), 0.0);
+}
+
+template <typename SourceType, typename DestinationType, typename MemorySpace>
+void convert(const SourceType& src, DestinationType& dst,
+             cusp::convert_workspace<MemorySpace>& workspace)
+{
+  CUSP_PROFILE_SCOPED();
+
+  cusp::detail::convert(src, dst, workspace,
+      typename SourceType::format(),
+      typename DestinationType::format());
+
+  CUSP_PROFILE_WORK(cusp::detail::storage_bytes(src) + cusp::detail::storage_bytes(dst), 0.0);
+}
+
+template <typename SourceType, typename DestinationType>
+void convert_in_place(SourceType& src, DestinationType& dst)
+{
+  CUSP_PROFILE_SCOPED();
+
+  cusp::detail::convert_in_place(src, dst);
 }
 
 } // end namespace cusp
@@ -19,6 +19,11 @@
 // TODO replace with detail/array2d_utils.h or something
 #include <cusp/array2d.h>
 
+#if (defined THRUST_DEVICE_BACKEND && THRUST_DEVICE_BACKEND == THRUST_DEVICE_BACKEND_CUDA) || (defined THRUST_DEVICE_SYSTEM && THRUST_DEVICE_SYSTEM == THRUST_DEVICE_SYSTEM_CUDA)
+#define __CUSP_USE_STAGED_COPY__
+#include <cusp/detail/device/staged_copy.h>
+#endif
+
 #include <thrust/copy.h>
 #include <thrust/gather.h>
 #include <thrust/iterator/counting_iterator.h>
@@ -89,13 +94,79 @@ void copy(const T1& src, T2& dst,
   cusp::copy(src.coo, dst.coo);
 }
 
+template <typename T1, typename T2>
+void copy(const T1& src, T2& dst,
+          cusp::sell_format,
+          cusp::sell_format)
+{    
+  copy_matrix_dimensions(src, dst);
+  dst.slice_height   = src.slice_height;
+  dst.sorting_window = src.sorting_window;
+  cusp::copy(src.slice_offsets,   dst.slice_offsets);
+  cusp::copy(src.row_permutation, dst.row_permutation);
+  cusp::copy(src.column_indices,  dst.column_indices);
+  cusp::copy(src.values,          dst.values);
+}
+
+template <typename T1, typename T2>
+void copy(const T1& src, T2& dst,
+          cusp::bsr_format,
+          cusp::bsr_format)
+{    
+  copy_matrix_dimensions(src, dst);
+  dst.block_size = src.block_size;
+  cusp::copy(src.row_offsets,    dst.row_offsets);
+  cusp::copy(src.column_indices, dst.column_indices);
+  cusp::copy(src.values,         dst.values);
+}
+
+template <typename T1, typename T2>
+void copy(const T1& src, T2& dst,
+          cusp::csr16_format,
+          cusp::csr16_format)
+{    
+  copy_matrix_dimensions(src, dst);
+  cusp::copy(src.row_offsets,    dst.row_offsets);
+  cusp::copy(src.column_offsets, dst.column_offsets);
+  cusp::copy(src.values,         dst.values);
+}
+
+template <typename T1, typename T2>
+void copy_array1d(const T1& src, T2& dst)
+{
+  thrust::copy(src.begin(), src.end(), dst.begin());
+}
+
+#ifdef __CUSP_USE_STAGED_COPY__
+// large transfers between array1d containers use pinned staging buffers
+template <typename ValueType>
+void copy_array1d(const cusp::array1d<ValueType,cusp::host_memory>& src,
+                        cusp::array1d<ValueType,cusp::device_memory>& dst)
+{
+  if (src.size() == 0 ||
+      !cusp::detail::device::staged_copy_to_device(thrust::raw_pointer_cast(&dst[0]),
+                                                   thrust::raw_pointer_cast(&src[0]), src.size()))
+    thrust::copy(src.begin(), src.end(), dst.begin());
+}
+
+template <typename ValueType>
+void copy_array1d(const cusp::array1d<ValueType,cusp::device_memory>& src,
+                        cusp::array1d<ValueType,cusp::host_memory>& dst)
+{
+  if (src.size() == 0 ||
+      !cusp::detail::device::staged_copy_to_host(thrust::raw_pointer_cast(&dst[0]),
+                                                 thrust::raw_pointer_cast(&src[0]), src.size()))
+    thrust::copy(src.begin(), src.end(), dst.begin());
+}
+#endif
+
 template <typename T1, typename T2>
 void copy(const T1& src, T2& dst,
           cusp::array1d_format,
           cusp::array1d_format)
 {    
   dst.resize(src.size());
-  thrust::copy(src.begin(), src.end(), dst.begin());
+  copy_array1d(src, dst);
 }
 
   
@@ -169,3 +240,5 @@ void copy(const T1& src, T2& dst)
 
 } // end namespace cusp
 
+#undef __CUSP_USE_STAGED_COPY__
+
@@ -0,0 +1,76 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+#include <cusp/blas.h>
+#include <cusp/exception.h>
+
+namespace cusp
+{
+
+template <typename IndexType, typename ValueType>
+template <typename MatrixType>
+csr_adaptive_spmv<IndexType,ValueType>
+::csr_adaptive_spmv(const MatrixType& matrix)
+  : Parent(matrix.num_rows, matrix.num_cols, matrix.num_entries), A(matrix)
+{
+    CUSP_PROFILE_SCOPED();
+
+    cusp::detail::device::analyze_csr_adaptive(A, analysis);
+}
+
+template <typename IndexType, typename ValueType>
+size_t csr_adaptive_spmv<IndexType,ValueType>
+::num_binned_rows(size_t threads_per_row) const
+{
+    size_t bin = cusp::detail::device::CSR_ADAPTIVE_BLOCK_BIN;
+
+    if (threads_per_row != 0)
+    {
+        bin = 0;
+        while (bin < cusp::detail::device::CSR_ADAPTIVE_BLOCK_BIN && (size_t(1) << bin) != threads_per_row)
+            bin++;
+
+        if (bin == cusp::detail::device::CSR_ADAPTIVE_BLOCK_BIN)
+            throw cusp::invalid_input_exception("threads_per_row must be a power of two no larger than 32");
+    }
+
+    return analysis.bin_offsets[bin + 1] - analysis.bin_offsets[bin];
+}
+
+template <typename IndexType, typename ValueType>
+template <typename VectorType1, typename VectorType2>
+void csr_adaptive_spmv<IndexType,ValueType>
+::operator()(const VectorType1& x, VectorType2& y) const
+{
+    if (x.size() != A.num_cols || y.size() != A.num_rows)
+        throw cusp::invalid_input_exception("array dimensions do not match the operator");
+
+    if (A.num_rows == 0)
+        return;
+
+    if (A.num_entries == 0)
+    {
+        cusp::blas::fill(y, ValueType(0));
+        return;
+    }
+
+    cusp::detail::device::spmv_csr_adaptive_tex(A, analysis,
+                                                thrust::raw_pointer_cast(&x[0]),
+                                                thrust::raw_pointer_cast(&y[0]));
+}
+
+} // end namespace cusp
@@ -0,0 +1,165 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include <cusp/csr_matrix.h>
+#include <cusp/exception.h>
+
+#include <cusp/detail/device/spmv/csr_vector.h>
+
+#include <thrust/binary_search.h>
+#include <thrust/fill.h>
+#include <thrust/sort.h>
+#include <thrust/unique.h>
+
+#include <limits>
+
+namespace cusp
+{
+namespace detail
+{
+
+// value of entry i of a csr_dictionary_operator
+template <typename CodeType, typename ValueType>
+struct dictionary_values
+{
+    const CodeType  * codes;
+    const ValueType * dictionary;
+
+    dictionary_values(const CodeType * codes, const ValueType * dictionary)
+        : codes(codes), dictionary(dictionary) {}
+
+    template <typename IndexType>
+    __host__ __device__
+    ValueType operator[](const IndexType i) const
+    {
+        return dictionary[codes[i]];
+    }
+};
+
+namespace device
+{
+
+template <typename IndexType, typename ValueType, typename MemorySpace, typename CodeType>
+struct csr_vector_values< cusp::csr_dictionary_operator<IndexType,ValueType,MemorySpace,CodeType> >
+{
+    typedef cusp::detail::dictionary_values<CodeType,ValueType> type;
+
+    static type get(const cusp::csr_dictionary_operator<IndexType,ValueType,MemorySpace,CodeType>& A)
+    {
+        return type(thrust::raw_pointer_cast(&A.codes[0]), thrust::raw_pointer_cast(&A.dictionary[0]));
+    }
+};
+
+} // end namespace device
+
+template <typename Matrix, typename ValueType>
+void dictionary_multiply(const Matrix& A, const ValueType * x, ValueType * y, cusp::host_memory)
+{
+    typedef typename Matrix::index_type IndexType;
+    typedef typename Matrix::code_type  CodeType;
+
+    const dictionary_values<CodeType,ValueType> Ax(&A.codes[0], &A.dictionary[0]);
+
+    for (size_t i = 0; i < A.num_rows; i++)
+    {
+        ValueType sum = ValueType(0);
+
+        for (IndexType jj = A.row_offsets[i]; jj < A.row_offsets[i + 1]; jj++)
+            sum += Ax[jj] * x[A.column_indices[jj]];
+
+        y[i] = sum;
+    }
+}
+
+template <typename Matrix, typename ValueType>
+void dictionary_multiply(const Matrix& A, const ValueType * x, ValueType * y, cusp::device_memory)
+{
+    cusp::detail::device::spmv_csr_vector(A, x, y);
+}
+
+} // end namespace detail
+
+template <typename IndexType, typename ValueType, typename MemorySpace, typename CodeType>
+csr_dictionary_operator<IndexType,ValueType,MemorySpace,CodeType>
+::csr_dictionary_operator(void)
+    : Parent()
+{
+}
+
+template <typename IndexType, typename ValueType, typename MemorySpace, typename CodeType>
+template <typename MatrixType>
+csr_dictionary_operator<IndexType,ValueType,MemorySpace,CodeType>
+::csr_dictionary_operator(const MatrixType& A)
+    : Parent()
+{
+    CUSP_PROFILE_SCOPED();
+
+    cusp::csr_matrix<IndexType,ValueType,MemorySpace> B(A);
+
+    dictionary = B.values;
+    thrust::sort(dictionary.begin(), dictionary.end());
+    dictionary.resize(thrust::unique(dictionary.begin(), dictionary.end()) - dictionary.begin());
+
+    if (dictionary.size() > size_t(std::numeric_limits<CodeType>::max()) + 1)
+        throw cusp::invalid_input_exception("matrix has more distinct values than the code type can number");
+
+    codes.resize(B.num_entries);
+    thrust::lower_bound(dictionary.begin(), dictionary.end(),
+                        B.values.begin(), B.values.end(),
+                        codes.begin());
+
+    row_offsets.swap(B.row_offsets);
+    column_indices.swap(B.column_indices);
+
+    this->resize(B.num_rows, B.num_cols, B.num_entries);
+}
+
+template <typename IndexType, typename ValueType, typename MemorySpace, typename CodeType>
+template <typename MemorySpace2>
+csr_dictionary_operator<IndexType,ValueType,MemorySpace,CodeType>
+::csr_dictionary_operator(const csr_dictionary_operator<IndexType,ValueType,MemorySpace2,CodeType>& A)
+    : Parent(A.num_rows, A.num_cols, A.num_entries),
+      row_offsets(A.row_offsets), column_indices(A.column_indices),
+      codes(A.codes), dictionary(A.dictionary)
+{
+}
+
+template <typename IndexType, typename ValueType, typename MemorySpace, typename CodeType>
+template <typename VectorType1, typename VectorType2>
+void csr_dictionary_operator<IndexType,ValueType,MemorySpace,CodeType>
+::operator()(const VectorType1& x, VectorType2& y) const
+{
+    CUSP_PROFILE_SCOPED();
+
+    if (x.size() != size_t(this->num_cols) || y.size() != size_t(this->num_rows))
+        throw cusp::invalid_input_exception("array dimensions do not match the operator");
+
+    if (this->num_rows == 0)
+        return;
+
+    if (this->num_entries == 0)
+    {
+        thrust::fill(y.begin(), y.end(), ValueType(0));
+        return;
+    }
+
+    detail::dictionary_multiply(*this,
+                                thrust::raw_pointer_cast(&x[0]),
+                                thrust::raw_pointer_cast(&y[0]),
+                                MemorySpace());
+}
+
+} // end namespace cusp
@@ -15,6 +15,7 @@
  */
 
 #include <cusp/convert.h>
+#include <cusp/detail/format_utils.h>
 
 namespace cusp
 {
@@ -48,5 +49,23 @@ template <typename MatrixType>
         return *this;
     }
 
+// sort the entries of every row by column index
+template <typename IndexType, typename ValueType, class MemorySpace>
+    void
+    csr_matrix<IndexType,ValueType,MemorySpace>
+    ::sort_by_column(void)
+    {
+        cusp::detail::sort_columns_by_row(row_offsets, column_indices, values);
+    }
+
+// sort the entries of every row and sum the duplicates
+template <typename IndexType, typename ValueType, class MemorySpace>
+    void
+    csr_matrix<IndexType,ValueType,MemorySpace>
+    ::sum_duplicates(void)
+    {
+        this->num_entries = cusp::detail::sum_duplicates_by_row(row_offsets, column_indices, values);
+    }
+
 } // end namespace cusp
 
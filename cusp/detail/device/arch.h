@@ -17,9 +17,16 @@
 #pragma once
 
 #include <cusp/detail/config.h>
+#include <cusp/detail/mutex.h>
+
+#include <cusp/detail/device/common.h>
 
 #include <thrust/extrema.h>
 
+#include <cuda_runtime_api.h>
+
+#include <map>
+
 #if THRUST_VERSION >= 100700
 #include <thrust/system/cuda/detail/detail/launch_calculator.h>
 #elif THRUST_VERSION >= 100600
@@ -28,6 +35,15 @@
 #include <thrust/detail/backend/cuda/arch.h>
 #endif
 
+// Warp synchronous code which exchanges values through volatile shared
+// memory is only safe while the lanes of a warp execute in lockstep.  On
+// sm_30 and newer the lanes exchange registers through warp shuffles
+// instead, which is also correct under the independent thread scheduling
+// of sm_70 and newer.
+#if defined(__CUDA_ARCH__) && (__CUDA_ARCH__ >= 300)
+#define __CUSP_HAS_WARP_SHUFFLE__
+#endif
+
 namespace cusp
 {
 namespace detail
@@ -38,7 +54,7 @@ namespace arch
 {
 
 template <typename KernelFunction>
-size_t max_active_blocks(KernelFunction kernel, const size_t CTA_SIZE, const size_t dynamic_smem_bytes)
+size_t query_max_active_blocks(KernelFunction kernel, const size_t CTA_SIZE, const size_t dynamic_smem_bytes)
 {
 #if THRUST_VERSION >= 100700
   using namespace thrust::system::cuda::detail;
@@ -52,6 +68,158 @@ size_t max_active_blocks(KernelFunction kernel, const size_t CTA_SIZE, const siz
 #endif
 }
 
+// occupancy of a kernel launch on a device
+struct occupancy_key
+{
+  const void * kernel;
+  int device;
+  size_t cta_size;
+  size_t dynamic_smem_bytes;
+
+  occupancy_key(const void * kernel, int device, size_t cta_size, size_t dynamic_smem_bytes)
+    : kernel(kernel), device(device), cta_size(cta_size), dynamic_smem_bytes(dynamic_smem_bytes) {}
+
+  bool operator<(const occupancy_key& other) const
+  {
+    if (kernel   != other.kernel)   return kernel   < other.kernel;
+    if (device   != other.device)   return device   < other.device;
+    if (cta_size != other.cta_size) return cta_size < other.cta_size;
+    return dynamic_smem_bytes < other.dynamic_smem_bytes;
+  }
+};
+
+// Queried once per kernel, launch shape and device: the first query of a
+// kernel calls cudaFuncGetAttributes, which also loads its module when
+// modules are loaded lazily.  Shared by all host threads, which hold
+// occupancy_cache_lock() while they use it.
+inline std::map<occupancy_key, size_t>& occupancy_cache(void)
+{
+  static std::map<occupancy_key, size_t> cache;
+  return cache;
+}
+
+inline cusp::detail::mutex& occupancy_cache_lock(void)
+{
+  static cusp::detail::mutex m = __CUSP_MUTEX_INITIALIZER;
+  return m;
+}
+
+template <typename KernelFunction>
+size_t max_active_blocks(KernelFunction kernel, const size_t CTA_SIZE, const size_t dynamic_smem_bytes)
+{
+  int device = 0;
+  cudaGetDevice(&device);
+
+  const occupancy_key key((const void *) kernel, device, CTA_SIZE, dynamic_smem_bytes);
+
+  std::map<occupancy_key, size_t>& cache = occupancy_cache();
+
+  {
+    cusp::detail::scoped_lock guard(occupancy_cache_lock());
+    std::map<occupancy_key, size_t>::const_iterator it = cache.find(key);
+
+    if (it != cache.end())
+      return it->second;
+  }
+
+  // threads racing on the first query compute the same value
+  const size_t blocks = query_max_active_blocks(kernel, CTA_SIZE, dynamic_smem_bytes);
+
+  cusp::detail::scoped_lock guard(occupancy_cache_lock());
+  cache.insert(std::make_pair(key, blocks));
+  return blocks;
+}
+
+#ifdef __CUSP_HAS_WARP_SHUFFLE__
+// mask of the lanes in the group of WIDTH consecutive lanes holding lane
+template <unsigned int WIDTH>
+__inline__ __device__ unsigned int lane_mask(const unsigned int lane)
+{
+  return (WIDTH == WARP_SIZE) ? 0xffffffffu : (((1u << WIDTH) - 1) << (lane & (WARP_SIZE - 1) & ~(WIDTH - 1)));
+}
+
+__inline__ __device__ int shfl_word(const unsigned int mask, const int word, const int src_lane, const int width)
+{
+#if CUDART_VERSION >= 9000
+  return __shfl_sync(mask, word, src_lane, width);
+#else
+  return __shfl(word, src_lane, width);
+#endif
+}
+
+__inline__ __device__ int shfl_up_word(const unsigned int mask, const int word, const unsigned int delta, const int width)
+{
+#if CUDART_VERSION >= 9000
+  return __shfl_up_sync(mask, word, delta, width);
+#else
+  return __shfl_up(word, delta, width);
+#endif
+}
+
+__inline__ __device__ int shfl_down_word(const unsigned int mask, const int word, const unsigned int delta, const int width)
+{
+#if CUDART_VERSION >= 9000
+  return __shfl_down_sync(mask, word, delta, width);
+#else
+  return __shfl_down(word, delta, width);
+#endif
+}
+
+// the shuffles move any value whose size is a multiple of 32 bits
+// (int, float, double and cusp::complex) one word at a time
+template <typename T>
+__inline__ __device__ T shfl(const unsigned int mask, T var, const int src_lane, const int width = WARP_SIZE)
+{
+  int * words = reinterpret_cast<int *>(&var);
+  for(unsigned int k = 0; k < sizeof(T) / sizeof(int); k++)
+    words[k] = shfl_word(mask, words[k], src_lane, width);
+  return var;
+}
+
+template <typename T>
+__inline__ __device__ T shfl_up(const unsigned int mask, T var, const unsigned int delta, const int width = WARP_SIZE)
+{
+  int * words = reinterpret_cast<int *>(&var);
+  for(unsigned int k = 0; k < sizeof(T) / sizeof(int); k++)
+    words[k] = shfl_up_word(mask, words[k], delta, width);
+  return var;
+}
+
+template <typename T>
+__inline__ __device__ T shfl_down(const unsigned int mask, T var, const unsigned int delta, const int width = WARP_SIZE)
+{
+  int * words = reinterpret_cast<int *>(&var);
+  for(unsigned int k = 0; k < sizeof(T) / sizeof(int); k++)
+    words[k] = shfl_down_word(mask, words[k], delta, width);
+  return var;
+}
+
+// sum of val over a group of WIDTH consecutive lanes, valid in the first lane of the group
+template <unsigned int WIDTH, typename ValueType>
+__inline__ __device__ ValueType reduce_lanes(const unsigned int mask, ValueType val)
+{
+  for(unsigned int offset = WIDTH / 2; offset > 0; offset /= 2)
+    val = val + shfl_down(mask, val, offset, WIDTH);
+  return val;
+}
+
+// inclusive scan of val over the lanes of a warp holding equal keys, assuming
+// that the lanes of each key are consecutive
+template <typename IndexType, typename ValueType>
+__inline__ __device__ ValueType segmented_scan_warp(const unsigned int lane, const IndexType key, ValueType val)
+{
+  for(unsigned int offset = 1; offset < WARP_SIZE; offset *= 2)
+  {
+    const IndexType key_left = shfl_up(0xffffffffu, key, offset);
+    const ValueType val_left = shfl_up(0xffffffffu, val, offset);
+
+    if(lane >= offset && key == key_left)
+      val = val + val_left;
+  }
+  return val;
+}
+#endif // __CUSP_HAS_WARP_SHUFFLE__
+
 } // end namespace arch
 } // end namespace device
 } // end namespace detail
@@ -0,0 +1,156 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include <cusp/detail/mutex.h>
+
+#include <cuda_runtime_api.h>
+
+#include <map>
+#include <sstream>
+#include <string>
+
+// Compile-time descriptions of the device generations.
+//
+// The architecture-specialized kernels take one of the policies below as a
+// template parameter, and their launchers instantiate every policy and
+// pick the one of the current device at run time (current_policy), so one
+// fat binary built for several -gencode targets runs the code written for
+// each generation.  The device code of a policy is only used where the
+// compilation target supports it: a kernel of sm70_policy built for an
+// sm_20 target falls back to the code of that target, but it is never
+// launched there since the dispatch follows the compute capability.
+//
+//   sm20_policy   warp synchronous shared memory exchanges, x cached
+//                 through textures (compute capability 2.0 to 3.2)
+//   sm35_policy   warp shuffles with lane masks, which are also correct
+//                 under the independent thread scheduling of sm_70 and
+//                 newer, x cached through __ldg (3.5 and newer)
+//
+// Defining CUSP_MIN_ARCH=350 drops sm20_policy from the dispatch, which
+// shortens the compilation and shrinks the binary when such devices are
+// not deployed.
+
+#ifndef CUSP_MIN_ARCH
+#define CUSP_MIN_ARCH 200
+#endif
+
+namespace cusp
+{
+namespace detail
+{
+namespace device
+{
+namespace arch
+{
+
+template <int ARCH_, bool HAS_WARP_SHUFFLE_, bool HAS_READ_ONLY_CACHE_>
+struct policy
+{
+    // lowest compute capability of the generation, times 100
+    static const int ARCH = ARCH_;
+
+    static const unsigned int WARP_SIZE = 32;
+
+    // lanes exchange registers with __shfl*
+    static const bool HAS_WARP_SHUFFLE = HAS_WARP_SHUFFLE_;
+
+    // loads of read-only data through __ldg, otherwise x is cached
+    // through a texture
+    static const bool HAS_READ_ONLY_CACHE = HAS_READ_ONLY_CACHE_;
+
+    // default launch shapes, overridden by the launch database
+    static const unsigned int CSR_VECTOR_BLOCK_SIZE = 128;
+    static const unsigned int ELL_BLOCK_SIZE        = 256;
+};
+
+typedef policy<200, false, false> sm20_policy;
+typedef policy<350, true,  true > sm35_policy;
+
+enum policy_id
+{
+    SM20_POLICY,
+    SM35_POLICY
+};
+
+// warp shuffles in the device code of Policy for the current compilation
+// target, which must support them as well
+template <typename Policy>
+struct use_warp_shuffle
+{
+#if defined(__CUDA_ARCH__) && (__CUDA_ARCH__ >= 300)
+    static const bool value = Policy::HAS_WARP_SHUFFLE;
+#else
+    static const bool value = false;
+#endif
+};
+
+struct device_description
+{
+    std::string arch;                   // e.g. "sm_80"
+    int compute_capability;             // e.g. 800
+    unsigned int multiprocessors;
+};
+
+// the descriptions are queried once per device and never change, so the
+// references stay valid after the lock is released
+inline const device_description& current_device_description(void)
+{
+    static std::map<int, device_description> devices;
+    static cusp::detail::mutex devices_lock = __CUSP_MUTEX_INITIALIZER;
+
+    int device = 0;
+    cudaGetDevice(&device);
+
+    cusp::detail::scoped_lock guard(devices_lock);
+
+    std::map<int, device_description>::iterator it = devices.find(device);
+
+    if (it == devices.end())
+    {
+        cudaDeviceProp properties;
+        cudaGetDeviceProperties(&properties, device);
+
+        std::ostringstream arch;
+        arch << "sm_" << properties.major << properties.minor;
+
+        device_description d;
+        d.arch               = arch.str();
+        d.compute_capability = 100 * properties.major + 10 * properties.minor;
+        d.multiprocessors    = properties.multiProcessorCount;
+
+        it = devices.insert(std::make_pair(device, d)).first;
+    }
+
+    return it->second;
+}
+
+// the policy of the current device
+inline policy_id current_policy(void)
+{
+    const int cc = current_device_description().compute_capability;
+
+    if (cc >= sm35_policy::ARCH || CUSP_MIN_ARCH >= sm35_policy::ARCH)
+        return SM35_POLICY;
+
+    return SM20_POLICY;
+}
+
+} // end namespace arch
+} // end namespace device
+} // end namespace detail
+} // end namespace cusp
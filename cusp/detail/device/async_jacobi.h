@@ -0,0 +1,159 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+#pragma once
+
+#include <cusp/detail/device/arch.h>
+#include <cusp/detail/device/utils.h>
+#include <cusp/detail/device/stream.h>
+
+#include <algorithm>
+
+namespace cusp
+{
+namespace detail
+{
+namespace device
+{
+
+// One step of block-asynchronous relaxation in a single persistent kernel.
+//
+// Each thread block owns BLOCK_SIZE consecutive rows, one per thread, and
+// loops over the row blocks with a grid stride.  The part of b - A x which
+// couples the block to the other rows is computed once from the current
+// contents of x, which may or may not hold the values written by other
+// blocks of the same launch.  The local sweeps then only involve the rows
+// of the block, whose values are kept in shared memory, and the results are
+// written back to x once.  Local Jacobi sweeps synchronize the block
+// between reading and writing its values, local Gauss-Seidel sweeps do not
+// and read whichever values the other warps have written so far.  When
+// backward is set the row blocks are visited in decreasing order.
+
+template <typename IndexType, typename ValueType, unsigned int BLOCK_SIZE>
+__launch_bounds__(BLOCK_SIZE,1)
+__global__ void
+async_jacobi_kernel(const IndexType num_rows,
+                    const IndexType * Ap,
+                    const IndexType * Aj,
+                    const ValueType * Ax,
+                    const ValueType * inv_diagonal,
+                    const ValueType * b,
+                          ValueType * x,
+                    const ValueType omega,
+                    const int local_sweeps,
+                    const bool gauss_seidel,
+                    const bool backward)
+{
+    __shared__ ValueType s_x[BLOCK_SIZE];
+
+    const IndexType num_blocks = DIVIDE_INTO(num_rows, BLOCK_SIZE);
+
+    for(IndexType k = blockIdx.x; k < num_blocks; k += gridDim.x)
+    {
+        const IndexType block = backward ? num_blocks - 1 - k : k;
+        const IndexType first = block * BLOCK_SIZE;
+        const IndexType last  = min(first + IndexType(BLOCK_SIZE), num_rows);
+        const IndexType row   = first + threadIdx.x;
+
+        ValueType rhs = 0;
+
+        if (row < last)
+        {
+            // b[row] minus the coupling to the other blocks, possibly stale
+            rhs = b[row];
+
+            for(IndexType jj = Ap[row]; jj < Ap[row + 1]; jj++)
+            {
+                const IndexType j = Aj[jj];
+
+                if (j < first || j >= last)
+                    rhs -= Ax[jj] * x[j];
+            }
+
+            s_x[threadIdx.x] = x[row];
+        }
+
+        __syncthreads();
+
+        for(int sweep = 0; sweep < local_sweeps; sweep++)
+        {
+            ValueType sum = rhs;
+
+            if (row < last)
+            {
+                for(IndexType jj = Ap[row]; jj < Ap[row + 1]; jj++)
+                {
+                    const IndexType j = Aj[jj];
+
+                    if (j >= first && j < last)
+                        sum -= Ax[jj] * s_x[j - first];
+                }
+            }
+
+            if (!gauss_seidel)
+                __syncthreads();
+
+            if (row < last)
+                s_x[threadIdx.x] += omega * sum * inv_diagonal[row];
+
+            __syncthreads();
+        }
+
+        if (row < last)
+            x[row] = s_x[threadIdx.x];
+
+        __syncthreads();
+    }
+}
+
+template <unsigned int BLOCK_SIZE, typename IndexType, typename ValueType>
+void __async_jacobi_step(const IndexType num_rows,
+                         const IndexType * Ap, const IndexType * Aj, const ValueType * Ax,
+                         const ValueType * inv_diagonal, const ValueType * b, ValueType * x,
+                         const ValueType omega, const int local_sweeps, const bool gauss_seidel, const bool backward)
+{
+    const size_t MAX_BLOCKS = cusp::detail::device::arch::max_active_blocks(async_jacobi_kernel<IndexType, ValueType, BLOCK_SIZE>, BLOCK_SIZE, (size_t) 0);
+    const size_t NUM_BLOCKS = std::min(MAX_BLOCKS, DIVIDE_INTO(size_t(num_rows), BLOCK_SIZE));
+
+    async_jacobi_kernel<IndexType, ValueType, BLOCK_SIZE> <<<NUM_BLOCKS, BLOCK_SIZE, 0, cusp::detail::device::current_stream()>>>
+        (num_rows, Ap, Aj, Ax, inv_diagonal, b, x, omega, local_sweeps, gauss_seidel, backward);
+}
+
+// block_size is a power of two from 32 to 1024
+template <typename IndexType, typename ValueType>
+void async_jacobi_step(const IndexType num_rows, const size_t block_size,
+                       const IndexType * Ap, const IndexType * Aj, const ValueType * Ax,
+                       const ValueType * inv_diagonal, const ValueType * b, ValueType * x,
+                       const ValueType omega, const int local_sweeps, const bool gauss_seidel, const bool backward)
+{
+    if (num_rows == 0)
+        return;
+
+    switch(block_size)
+    {
+        case   32: __async_jacobi_step<  32>(num_rows, Ap, Aj, Ax, inv_diagonal, b, x, omega, local_sweeps, gauss_seidel, backward); break;
+        case   64: __async_jacobi_step<  64>(num_rows, Ap, Aj, Ax, inv_diagonal, b, x, omega, local_sweeps, gauss_seidel, backward); break;
+        case  128: __async_jacobi_step< 128>(num_rows, Ap, Aj, Ax, inv_diagonal, b, x, omega, local_sweeps, gauss_seidel, backward); break;
+        case  256: __async_jacobi_step< 256>(num_rows, Ap, Aj, Ax, inv_diagonal, b, x, omega, local_sweeps, gauss_seidel, backward); break;
+        case  512: __async_jacobi_step< 512>(num_rows, Ap, Aj, Ax, inv_diagonal, b, x, omega, local_sweeps, gauss_seidel, backward); break;
+        case 1024: __async_jacobi_step<1024>(num_rows, Ap, Aj, Ax, inv_diagonal, b, x, omega, local_sweeps, gauss_seidel, backward); break;
+    }
+}
+
+} // end namespace device
+} // end namespace detail
+} // end namespace cusp
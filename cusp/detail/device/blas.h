@@ -0,0 +1,716 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+#pragma once
+
+#include <cusp/array1d.h>
+#include <cusp/exception.h>
+#include <cusp/reduction.h>
+
+#include <cusp/detail/functional.h>
+#include <cusp/detail/mutex.h>
+#include <cusp/detail/device/arch.h>
+#include <cusp/detail/device/common.h>
+#include <cusp/detail/device/stream.h>
+#include <cusp/detail/device/utils.h>
+
+#ifdef __CUSP_USE_CUBLAS__
+#include <cublas_v2.h>
+#endif
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+// Dense level-2 and level-3 BLAS for the device.  Matrices are passed as
+// raw pointers with the strides (rs, cs) between consecutive rows and
+// columns, as in cusp/detail/host/blas.h.
+//
+// When cusp is built with __CUSP_USE_CUBLAS__ (scons cublas=1) float and
+// double arguments are handed to cuBLAS on the current stream.  cuBLAS
+// expects column-major matrices, so a row-major matrix is passed as its
+// column-major transpose with the pitch as leading dimension, and a
+// row-major result is computed as the transpose of the column-major one.
+// Other value types, and builds without cuBLAS, use the kernels below.
+
+namespace cusp
+{
+namespace detail
+{
+namespace device
+{
+
+//////////////////////////////////////////////////////////////////////////////
+// Dense kernels
+//////////////////////////////////////////////////////////////////////////////
+//
+// gemv_kernel
+//   Each row of y is assigned to a thread.
+//
+// gemm_kernel
+//   Each TILE_SIZE x TILE_SIZE tile of C is assigned to a block, which
+//   stages matching tiles of A and B in shared memory.
+//
+// trsm_kernel
+//   Each column of B is assigned to a thread which runs the substitution.
+//
+// mdot_kernel
+//   Each thread accumulates MDOT_GROUP_SIZE dot products at a time over its
+//   rows, so x is read once per group of columns of Y, and each block
+//   writes its partial sums.  mdot_reduce_kernel then sums the partial
+//   sums of each column in a single block.
+//
+// reproducible_reduce_kernel
+//   Each chunk of REDUCTION_LANES * REDUCTION_ITEMS terms is assigned to a
+//   block of REDUCTION_LANES threads, which sum the chunk in the fixed order
+//   of cusp/reduction.h.  The result does not depend on the number of
+//   blocks, and matches reproducible_sum in cusp/detail/host/blas.h.
+
+template <typename ValueType, unsigned int BLOCK_SIZE>
+__launch_bounds__(BLOCK_SIZE,1)
+__global__ void
+gemv_kernel(const int num_rows, const int num_cols,
+            const ValueType alpha,
+            const ValueType * A, const int rs, const int cs,
+            const ValueType * x,
+            const ValueType beta,
+                  ValueType * y)
+{
+    const int grid_size = BLOCK_SIZE * gridDim.x;
+
+    for(int i = BLOCK_SIZE * blockIdx.x + threadIdx.x; i < num_rows; i += grid_size)
+    {
+        ValueType sum = 0;
+
+        for(int j = 0; j < num_cols; j++)
+            sum += A[i * rs + j * cs] * x[j];
+
+        y[i] = (beta == ValueType(0)) ? alpha * sum : alpha * sum + beta * y[i];
+    }
+}
+
+template <typename ValueType, unsigned int TILE_SIZE>
+__launch_bounds__(TILE_SIZE * TILE_SIZE,1)
+__global__ void
+gemm_kernel(const int m, const int n, const int k,
+            const ValueType alpha,
+            const ValueType * A, const int A_rs, const int A_cs,
+            const ValueType * B, const int B_rs, const int B_cs,
+            const ValueType beta,
+                  ValueType * C, const int C_rs, const int C_cs)
+{
+    __shared__ ValueType A_tile[TILE_SIZE][TILE_SIZE + 1];  // padded to avoid bank conflicts
+    __shared__ ValueType B_tile[TILE_SIZE][TILE_SIZE + 1];
+
+    const int tx = threadIdx.x % TILE_SIZE;
+    const int ty = threadIdx.x / TILE_SIZE;
+
+    const int num_tile_cols = DIVIDE_INTO(n, TILE_SIZE);
+    const int num_tiles     = DIVIDE_INTO(m, TILE_SIZE) * num_tile_cols;
+
+    for(int tile = blockIdx.x; tile < num_tiles; tile += gridDim.x)
+    {
+        const int i = (tile / num_tile_cols) * TILE_SIZE + ty;
+        const int j = (tile % num_tile_cols) * TILE_SIZE + tx;
+
+        ValueType sum = 0;
+
+        for(int kb = 0; kb < k; kb += TILE_SIZE)
+        {
+            A_tile[ty][tx] = (i < m && kb + tx < k) ? A[i * A_rs + (kb + tx) * A_cs] : ValueType(0);
+            B_tile[ty][tx] = (kb + ty < k && j < n) ? B[(kb + ty) * B_rs + j * B_cs] : ValueType(0);
+
+            __syncthreads();
+
+            for(int kk = 0; kk < TILE_SIZE; kk++)
+                sum += A_tile[ty][kk] * B_tile[kk][tx];
+
+            __syncthreads();
+        }
+
+        if (i < m && j < n)
+        {
+            ValueType& c = C[i * C_rs + j * C_cs];
+            c = (beta == ValueType(0)) ? alpha * sum : alpha * sum + beta * c;
+        }
+    }
+}
+
+template <typename ValueType, unsigned int BLOCK_SIZE>
+__launch_bounds__(BLOCK_SIZE,1)
+__global__ void
+trsm_kernel(const int n, const int num_rhs,
+            const bool lower, const bool unit_diagonal,
+            const ValueType * A, const int A_rs, const int A_cs,
+                  ValueType * B, const int B_rs, const int B_cs)
+{
+    const int grid_size = BLOCK_SIZE * gridDim.x;
+
+    for(int j = BLOCK_SIZE * blockIdx.x + threadIdx.x; j < num_rhs; j += grid_size)
+    {
+        ValueType * b = B + j * B_cs;
+
+        for(int t = 0; t < n; t++)
+        {
+            const int k = lower ? t : n - 1 - t;
+
+            ValueType b_k = b[k * B_rs];
+
+            if (!unit_diagonal)
+                b_k /= A[k * A_rs + k * A_cs];
+
+            b[k * B_rs] = b_k;
+
+            const int i_begin = lower ? k + 1 : 0;
+            const int i_end   = lower ? n     : k;
+
+            for(int i = i_begin; i < i_end; i++)
+                b[i * B_rs] -= A[i * A_rs + k * A_cs] * b_k;
+        }
+    }
+}
+
+// number of columns of Y processed by each pass of mdot_kernel
+const int MDOT_GROUP_SIZE = 4;
+
+template <typename ValueType, unsigned int BLOCK_SIZE, bool Conjugate>
+__launch_bounds__(BLOCK_SIZE,1)
+__global__ void
+mdot_kernel(const int n, const int num_vectors,
+            const ValueType * x,
+            const ValueType * Y, const int rs, const int cs,
+                  ValueType * partial)
+{
+    __shared__ ValueType sdata[BLOCK_SIZE];
+
+    const cusp::detail::conjugate_if<Conjugate> conj_x;
+
+    const int grid_size = BLOCK_SIZE * gridDim.x;
+
+    for(int jb = 0; jb < num_vectors; jb += MDOT_GROUP_SIZE)
+    {
+        ValueType sum[MDOT_GROUP_SIZE];
+
+        for(int g = 0; g < MDOT_GROUP_SIZE; g++)
+            sum[g] = 0;
+
+        for(int i = BLOCK_SIZE * blockIdx.x + threadIdx.x; i < n; i += grid_size)
+        {
+            const ValueType x_i = conj_x(x[i]);
+
+            for(int g = 0; g < MDOT_GROUP_SIZE; g++)
+                if (jb + g < num_vectors)
+                    sum[g] += x_i * Y[i * rs + (jb + g) * cs];
+        }
+
+        // reduce the sums of the block, one column at a time
+        for(int g = 0; g < MDOT_GROUP_SIZE && jb + g < num_vectors; g++)
+        {
+            sdata[threadIdx.x] = sum[g];
+            __syncthreads();
+
+            for(unsigned int offset = BLOCK_SIZE / 2; offset > 0; offset /= 2)
+            {
+                if (threadIdx.x < offset)
+                    sdata[threadIdx.x] = sdata[threadIdx.x] + sdata[threadIdx.x + offset];
+                __syncthreads();
+            }
+
+            if (threadIdx.x == 0)
+                partial[(jb + g) * gridDim.x + blockIdx.x] = sdata[0];
+            __syncthreads();
+        }
+    }
+}
+
+template <typename ValueType, unsigned int BLOCK_SIZE>
+__launch_bounds__(BLOCK_SIZE,1)
+__global__ void
+mdot_reduce_kernel(const int num_partials, const int num_vectors,
+                   const ValueType * partial,
+                         ValueType * result)
+{
+    __shared__ ValueType sdata[BLOCK_SIZE];
+
+    for(int j = blockIdx.x; j < num_vectors; j += gridDim.x)
+    {
+        ValueType sum = 0;
+
+        for(int b = threadIdx.x; b < num_partials; b += BLOCK_SIZE)
+            sum += partial[j * num_partials + b];
+
+        sdata[threadIdx.x] = sum;
+        __syncthreads();
+
+        for(unsigned int offset = BLOCK_SIZE / 2; offset > 0; offset /= 2)
+        {
+            if (threadIdx.x < offset)
+                sdata[threadIdx.x] = sdata[threadIdx.x] + sdata[threadIdx.x + offset];
+            __syncthreads();
+        }
+
+        if (threadIdx.x == 0)
+            result[j] = sdata[0];
+        __syncthreads();
+    }
+}
+
+template <typename OutputType, unsigned int LANES, unsigned int ITEMS,
+          typename Iterator1, typename Iterator2, typename BinaryFunction>
+__launch_bounds__(LANES,1)
+__global__ void
+reproducible_reduce_kernel(const size_t n,
+                           Iterator1 x, Iterator2 y,
+                           BinaryFunction op,
+                           OutputType * partial)
+{
+    __shared__ OutputType sdata[LANES];
+
+    const size_t num_chunks = DIVIDE_INTO(n, LANES * ITEMS);
+
+    for(size_t c = blockIdx.x; c < num_chunks; c += gridDim.x)
+    {
+        OutputType sum = 0;
+
+        for(unsigned int k = 0; k < ITEMS; k++)
+        {
+            const size_t i = c * (LANES * ITEMS) + k * LANES + threadIdx.x;
+
+            if (i < n)
+                sum = sum + OutputType(op(x[i], y[i]));
+        }
+
+        sdata[threadIdx.x] = sum;
+        __syncthreads();
+
+        for(unsigned int offset = LANES / 2; offset > 0; offset /= 2)
+        {
+            if (threadIdx.x < offset)
+                sdata[threadIdx.x] = sdata[threadIdx.x] + sdata[threadIdx.x + offset];
+            __syncthreads();
+        }
+
+        if (threadIdx.x == 0)
+            partial[c] = sdata[0];
+        __syncthreads();
+    }
+}
+
+// partial[c] = sum of op(x[i], y[i]) over chunk c of the n terms
+template <typename OutputType, typename Iterator1, typename Iterator2, typename BinaryFunction>
+void reproducible_partials(const size_t n,
+                           Iterator1 x, Iterator2 y,
+                           BinaryFunction op,
+                           OutputType * partial)
+{
+    const size_t LANES = cusp::detail::REDUCTION_LANES;
+    const size_t ITEMS = cusp::detail::REDUCTION_ITEMS;
+
+    const size_t MAX_BLOCKS = cusp::detail::device::arch::max_active_blocks(reproducible_reduce_kernel<OutputType, LANES, ITEMS, Iterator1, Iterator2, BinaryFunction>, LANES, (size_t) 0);
+    const size_t NUM_BLOCKS = std::min<size_t>(MAX_BLOCKS, DIVIDE_INTO(n, LANES * ITEMS));
+
+    reproducible_reduce_kernel<OutputType, LANES, ITEMS> <<<NUM_BLOCKS, LANES, 0, cusp::detail::device::current_stream()>>>
+        (n, x, y, op, partial);
+}
+
+// sum of op(x[i], y[i]) for 0 <= i < n in the order of cusp/reduction.h.
+// The chunk sums are reduced by further launches until a single value is
+// left, which is the only value copied to the host.
+template <typename OutputType, typename Iterator1, typename Iterator2, typename BinaryFunction>
+OutputType reproducible_sum(const size_t n,
+                            Iterator1 x, Iterator2 y,
+                            BinaryFunction op)
+{
+    const size_t CHUNK = cusp::detail::REDUCTION_LANES * cusp::detail::REDUCTION_ITEMS;
+
+    if (n == 0)
+        return OutputType(0);
+
+    cusp::array1d<OutputType, cusp::device_memory> partial(DIVIDE_INTO(n, CHUNK));
+
+    reproducible_partials(n, x, y, op, thrust::raw_pointer_cast(&partial[0]));
+
+    while (partial.size() > 1)
+    {
+        cusp::array1d<OutputType, cusp::device_memory> next(DIVIDE_INTO(partial.size(), CHUNK));
+
+        const OutputType * p = thrust::raw_pointer_cast(&partial[0]);
+
+        reproducible_partials(partial.size(), p, p,
+                              cusp::detail::first_argument<OutputType>(),
+                              thrust::raw_pointer_cast(&next[0]));
+
+        partial.swap(next);
+    }
+
+    OutputType result;
+
+    cudaMemcpyAsync(&result, thrust::raw_pointer_cast(&partial[0]), sizeof(OutputType),
+                    cudaMemcpyDeviceToHost, cusp::detail::device::current_stream());
+    cudaStreamSynchronize(cusp::detail::device::current_stream());
+
+    return result;
+}
+
+// result[j] = x^T Y[:,j] (conj(x)^T Y[:,j] when Conjugate is true) for the
+// num_vectors columns of the n x num_vectors matrix Y.  result is a device
+// array of num_vectors values.
+template <bool Conjugate, typename ValueType>
+void mdot(const int n, const int num_vectors,
+          const ValueType * x,
+          const ValueType * Y, const int rs, const int cs,
+                ValueType * result)
+{
+    const size_t BLOCK_SIZE = 256;
+    const size_t MAX_BLOCKS = cusp::detail::device::arch::max_active_blocks(mdot_kernel<ValueType, BLOCK_SIZE, Conjugate>, BLOCK_SIZE, (size_t) 0);
+    const size_t NUM_BLOCKS = std::max<size_t>(1, std::min<size_t>(MAX_BLOCKS, DIVIDE_INTO(n, BLOCK_SIZE)));
+
+    cusp::array1d<ValueType, cusp::device_memory> partial(NUM_BLOCKS * num_vectors);
+
+    mdot_kernel<ValueType, BLOCK_SIZE, Conjugate> <<<NUM_BLOCKS, BLOCK_SIZE, 0, cusp::detail::device::current_stream()>>>
+        (n, num_vectors, x, Y, rs, cs, thrust::raw_pointer_cast(&partial[0]));
+
+    const size_t REDUCE_BLOCKS = std::min<size_t>(cusp::detail::device::arch::max_active_blocks(mdot_reduce_kernel<ValueType, BLOCK_SIZE>, BLOCK_SIZE, (size_t) 0), num_vectors);
+
+    mdot_reduce_kernel<ValueType, BLOCK_SIZE> <<<REDUCE_BLOCKS, BLOCK_SIZE, 0, cusp::detail::device::current_stream()>>>
+        (int(NUM_BLOCKS), num_vectors, thrust::raw_pointer_cast(&partial[0]), result);
+}
+
+template <typename ValueType>
+void gemv(const int num_rows, const int num_cols,
+          const ValueType alpha,
+          const ValueType * A, const int rs, const int cs,
+          const ValueType * x,
+          const ValueType beta,
+                ValueType * y)
+{
+    const size_t BLOCK_SIZE = 256;
+    const size_t MAX_BLOCKS = cusp::detail::device::arch::max_active_blocks(gemv_kernel<ValueType, BLOCK_SIZE>, BLOCK_SIZE, (size_t) 0);
+    const size_t NUM_BLOCKS = std::min<size_t>(MAX_BLOCKS, DIVIDE_INTO(num_rows, BLOCK_SIZE));
+
+    gemv_kernel<ValueType, BLOCK_SIZE> <<<NUM_BLOCKS, BLOCK_SIZE, 0, cusp::detail::device::current_stream()>>>
+        (num_rows, num_cols, alpha, A, rs, cs, x, beta, y);
+}
+
+template <typename ValueType>
+void gemm(const int m, const int n, const int k,
+          const ValueType alpha,
+          const ValueType * A, const int A_rs, const int A_cs,
+          const ValueType * B, const int B_rs, const int B_cs,
+          const ValueType beta,
+                ValueType * C, const int C_rs, const int C_cs)
+{
+    const size_t TILE_SIZE  = 16;
+    const size_t BLOCK_SIZE = TILE_SIZE * TILE_SIZE;
+    const size_t MAX_BLOCKS = cusp::detail::device::arch::max_active_blocks(gemm_kernel<ValueType, TILE_SIZE>, BLOCK_SIZE, (size_t) 0);
+    const size_t NUM_BLOCKS = std::min<size_t>(MAX_BLOCKS, DIVIDE_INTO(m, TILE_SIZE) * DIVIDE_INTO(n, TILE_SIZE));
+
+    gemm_kernel<ValueType, TILE_SIZE> <<<NUM_BLOCKS, BLOCK_SIZE, 0, cusp::detail::device::current_stream()>>>
+        (m, n, k, alpha, A, A_rs, A_cs, B, B_rs, B_cs, beta, C, C_rs, C_cs);
+}
+
+template <typename ValueType>
+void trsm(const int n, const int num_rhs,
+          const bool lower, const bool unit_diagonal,
+          const ValueType * A, const int A_rs, const int A_cs,
+                ValueType * B, const int B_rs, const int B_cs)
+{
+    const size_t BLOCK_SIZE = 128;
+    const size_t MAX_BLOCKS = cusp::detail::device::arch::max_active_blocks(trsm_kernel<ValueType, BLOCK_SIZE>, BLOCK_SIZE, (size_t) 0);
+    const size_t NUM_BLOCKS = std::min<size_t>(MAX_BLOCKS, DIVIDE_INTO(num_rhs, BLOCK_SIZE));
+
+    trsm_kernel<ValueType, BLOCK_SIZE> <<<NUM_BLOCKS, BLOCK_SIZE, 0, cusp::detail::device::current_stream()>>>
+        (n, num_rhs, lower, unit_diagonal, A, A_rs, A_cs, B, B_rs, B_cs);
+}
+
+#ifdef __CUSP_USE_CUBLAS__
+//////////////////////////////////////////////////////////////////////////////
+// cuBLAS
+//////////////////////////////////////////////////////////////////////////////
+//
+// The non-template overloads below are preferred over the kernels above
+// for float and double.
+
+namespace cublas
+{
+
+inline void check(cublasStatus_t status, const char * routine)
+{
+    if (status != CUBLAS_STATUS_SUCCESS)
+        throw cusp::runtime_exception(std::string("cuBLAS ") + routine + " failed");
+}
+
+// The handles of one host thread, as cuBLAS recommends, indexed by device
+// since a handle stays bound to the device which was current when it was
+// created.  They are destroyed when the thread exits.
+struct handle_set
+{
+    std::vector<cublasHandle_t> handles;
+
+    ~handle_set(void)
+    {
+        int current = -1;
+        cudaGetDevice(&current);
+
+        for (size_t device = 0; device < handles.size(); device++)
+        {
+            if (handles[device] != 0 && cudaSetDevice(int(device)) == cudaSuccess)
+                cublasDestroy(handles[device]);
+        }
+
+        if (current >= 0)
+            cudaSetDevice(current);
+    }
+};
+
+#if defined(_WIN32)
+inline VOID NTAPI destroy_handle_set(PVOID p)
+#else
+inline void destroy_handle_set(void * p)
+#endif
+{
+    delete static_cast<handle_set *>(p);
+}
+
+// __CUSP_THREAD_LOCAL only holds trivial types, so the handle set of a
+// thread is also stored under a thread-specific key whose destructor
+// releases it at thread exit
+inline handle_set& thread_handle_set(void)
+{
+    static __CUSP_THREAD_LOCAL handle_set * set = 0;
+
+    if (set == 0)
+    {
+        static cusp::detail::mutex lock = __CUSP_MUTEX_INITIALIZER;
+        static bool created = false;
+
+#if defined(_WIN32)
+        static DWORD key;
+        {
+            cusp::detail::scoped_lock guard(lock);
+            if (!created)
+            {
+                key = FlsAlloc(destroy_handle_set);
+                created = key != FLS_OUT_OF_INDEXES;
+            }
+        }
+
+        set = new handle_set;
+        if (created)
+            FlsSetValue(key, set);
+#else
+        static pthread_key_t key;
+        {
+            cusp::detail::scoped_lock guard(lock);
+            if (!created)
+                created = pthread_key_create(&key, destroy_handle_set) == 0;
+        }
+
+        set = new handle_set;
+        if (created)
+            pthread_setspecific(key, set);
+#endif
+    }
+
+    return *set;
+}
+
+// the handle of the calling thread for the current device, bound to the
+// current stream of the thread before each call
+inline cublasHandle_t handle(void)
+{
+    int device = 0;
+    if (cudaGetDevice(&device) != cudaSuccess)
+        throw cusp::runtime_exception("cudaGetDevice failed");
+
+    std::vector<cublasHandle_t>& handles = thread_handle_set().handles;
+
+    if (size_t(device) >= handles.size())
+        handles.resize(device + 1, cublasHandle_t(0));
+
+    cublasHandle_t& h = handles[device];
+
+    if (h == 0)
+        check(cublasCreate(&h), "cublasCreate");
+
+    check(cublasSetStream(h, cusp::detail::device::current_stream()), "cublasSetStream");
+
+    return h;
+}
+
+// a strided matrix is column-major when its rows are adjacent
+inline bool is_column_major(const int rs)
+{
+    return rs == 1;
+}
+
+// leading dimension of the column-major storage of an m x n strided matrix
+inline int leading_dimension(const int m, const int n, const int rs, const int cs)
+{
+    return is_column_major(rs) ? std::max(std::max(cs, m), 1) : std::max(std::max(rs, n), 1);
+}
+
+// operation which turns the column-major storage back into the matrix
+inline cublasOperation_t storage_op(const int rs)
+{
+    return is_column_major(rs) ? CUBLAS_OP_N : CUBLAS_OP_T;
+}
+
+inline cublasStatus_t gemv(cublasHandle_t h, cublasOperation_t op, int m, int n, const float * alpha, const float * A, int lda, const float * x, const float * beta, float * y)
+{
+    return cublasSgemv(h, op, m, n, alpha, A, lda, x, 1, beta, y, 1);
+}
+
+inline cublasStatus_t gemv(cublasHandle_t h, cublasOperation_t op, int m, int n, const double * alpha, const double * A, int lda, const double * x, const double * beta, double * y)
+{
+    return cublasDgemv(h, op, m, n, alpha, A, lda, x, 1, beta, y, 1);
+}
+
+inline cublasStatus_t gemm(cublasHandle_t h, cublasOperation_t op_a, cublasOperation_t op_b, int m, int n, int k, const float * alpha, const float * A, int lda, const float * B, int ldb, const float * beta, float * C, int ldc)
+{
+    return cublasSgemm(h, op_a, op_b, m, n, k, alpha, A, lda, B, ldb, beta, C, ldc);
+}
+
+inline cublasStatus_t gemm(cublasHandle_t h, cublasOperation_t op_a, cublasOperation_t op_b, int m, int n, int k, const double * alpha, const double * A, int lda, const double * B, int ldb, const double * beta, double * C, int ldc)
+{
+    return cublasDgemm(h, op_a, op_b, m, n, k, alpha, A, lda, B, ldb, beta, C, ldc);
+}
+
+inline cublasStatus_t trsm(cublasHandle_t h, cublasSideMode_t side, cublasFillMode_t uplo, cublasOperation_t op, cublasDiagType_t diag, int m, int n, const float * alpha, const float * A, int lda, float * B, int ldb)
+{
+    return cublasStrsm(h, side, uplo, op, diag, m, n, alpha, A, lda, B, ldb);
+}
+
+inline cublasStatus_t trsm(cublasHandle_t h, cublasSideMode_t side, cublasFillMode_t uplo, cublasOperation_t op, cublasDiagType_t diag, int m, int n, const double * alpha, const double * A, int lda, double * B, int ldb)
+{
+    return cublasDtrsm(h, side, uplo, op, diag, m, n, alpha, A, lda, B, ldb);
+}
+
+template <typename ValueType>
+void gemv(const int num_rows, const int num_cols,
+          const ValueType alpha,
+          const ValueType * A, const int rs, const int cs,
+          const ValueType * x,
+          const ValueType beta,
+                ValueType * y)
+{
+    const int lda = leading_dimension(num_rows, num_cols, rs, cs);
+
+    // the column-major storage of a row-major A is num_cols x num_rows
+    if (is_column_major(rs))
+        check(gemv(handle(), CUBLAS_OP_N, num_rows, num_cols, &alpha, A, lda, x, &beta, y), "gemv");
+    else
+        check(gemv(handle(), CUBLAS_OP_T, num_cols, num_rows, &alpha, A, lda, x, &beta, y), "gemv");
+}
+
+template <typename ValueType>
+void gemm(const int m, const int n, const int k,
+          const ValueType alpha,
+          const ValueType * A, const int A_rs, const int A_cs,
+          const ValueType * B, const int B_rs, const int B_cs,
+          const ValueType beta,
+                ValueType * C, const int C_rs, const int C_cs)
+{
+    const int lda = leading_dimension(m, k, A_rs, A_cs);
+    const int ldb = leading_dimension(k, n, B_rs, B_cs);
+    const int ldc = leading_dimension(m, n, C_rs, C_cs);
+
+    if (is_column_major(C_rs))
+    {
+        // C = op(A) * op(B)
+        check(gemm(handle(), storage_op(A_rs), storage_op(B_rs), m, n, k,
+                   &alpha, A, lda, B, ldb, &beta, C, ldc), "gemm");
+    }
+    else
+    {
+        // C^T = B^T * A^T, where the storage of a row-major matrix is its transpose
+        const cublasOperation_t op_a = is_column_major(A_rs) ? CUBLAS_OP_T : CUBLAS_OP_N;
+        const cublasOperation_t op_b = is_column_major(B_rs) ? CUBLAS_OP_T : CUBLAS_OP_N;
+
+        check(gemm(handle(), op_b, op_a, n, m, k,
+                   &alpha, B, ldb, A, lda, &beta, C, ldc), "gemm");
+    }
+}
+
+template <typename ValueType>
+void trsm(const int n, const int num_rhs,
+          const bool lower, const bool unit_diagonal,
+          const ValueType * A, const int A_rs, const int A_cs,
+                ValueType * B, const int B_rs, const int B_cs)
+{
+    const ValueType one = 1;
+
+    const int lda = leading_dimension(n, n,       A_rs, A_cs);
+    const int ldb = leading_dimension(n, num_rhs, B_rs, B_cs);
+
+    // the storage of a row-major A holds the opposite triangle
+    const cublasFillMode_t uplo = (lower == is_column_major(A_rs)) ? CUBLAS_FILL_MODE_LOWER : CUBLAS_FILL_MODE_UPPER;
+    const cublasDiagType_t diag = unit_diagonal ? CUBLAS_DIAG_UNIT : CUBLAS_DIAG_NON_UNIT;
+
+    if (is_column_major(B_rs))
+    {
+        // A X = B
+        check(trsm(handle(), CUBLAS_SIDE_LEFT, uplo, storage_op(A_rs), diag,
+                   n, num_rhs, &one, A, lda, B, ldb), "trsm");
+    }
+    else
+    {
+        // X^T A^T = B^T, where the storage of B is B^T
+        const cublasOperation_t op = is_column_major(A_rs) ? CUBLAS_OP_T : CUBLAS_OP_N;
+
+        check(trsm(handle(), CUBLAS_SIDE_RIGHT, uplo, op, diag,
+                   num_rhs, n, &one, A, lda, B, ldb), "trsm");
+    }
+}
+
+} // end namespace cublas
+
+inline void gemv(const int num_rows, const int num_cols, const float alpha, const float * A, const int rs, const int cs, const float * x, const float beta, float * y)
+{
+    cublas::gemv(num_rows, num_cols, alpha, A, rs, cs, x, beta, y);
+}
+
+inline void gemv(const int num_rows, const int num_cols, const double alpha, const double * A, const int rs, const int cs, const double * x, const double beta, double * y)
+{
+    cublas::gemv(num_rows, num_cols, alpha, A, rs, cs, x, beta, y);
+}
+
+inline void gemm(const int m, const int n, const int k, const float alpha, const float * A, const int A_rs, const int A_cs, const float * B, const int B_rs, const int B_cs, const float beta, float * C, const int C_rs, const int C_cs)
+{
+    cublas::gemm(m, n, k, alpha, A, A_rs, A_cs, B, B_rs, B_cs, beta, C, C_rs, C_cs);
+}
+
+inline void gemm(const int m, const int n, const int k, const double alpha, const double * A, const int A_rs, const int A_cs, const double * B, const int B_rs, const int B_cs, const double beta, double * C, const int C_rs, const int C_cs)
+{
+    cublas::gemm(m, n, k, alpha, A, A_rs, A_cs, B, B_rs, B_cs, beta, C, C_rs, C_cs);
+}
+
+inline void trsm(const int n, const int num_rhs, const bool lower, const bool unit_diagonal, const float * A, const int A_rs, const int A_cs, float * B, const int B_rs, const int B_cs)
+{
+    cublas::trsm(n, num_rhs, lower, unit_diagonal, A, A_rs, A_cs, B, B_rs, B_cs);
+}
+
+inline void trsm(const int n, const int num_rhs, const bool lower, const bool unit_diagonal, const double * A, const int A_rs, const int A_cs, double * B, const int B_rs, const int B_cs)
+{
+    cublas::trsm(n, num_rhs, lower, unit_diagonal, A, A_rs, A_cs, B, B_rs, B_cs);
+}
+#endif // __CUSP_USE_CUBLAS__
+
+} // end namespace device
+} // end namespace detail
+} // end namespace cusp
+
@@ -0,0 +1,449 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include <cusp/detail/mutex.h>
+#include <cusp/detail/device/stream.h>
+
+#include <cuda_runtime_api.h>
+
+#include <thrust/device_malloc_allocator.h>
+
+#include <map>
+#include <new>
+#include <utility>
+#include <vector>
+
+// Size-class caching of the device allocations of the Cusp containers.
+//
+// Requests are rounded up to a power of two (at least 2^CACHE_MIN_BIN bytes)
+// and a freed block is kept in the cache of its device and size class
+// instead of being returned with cudaFree, which synchronizes the whole
+// device.  Blocks larger than 2^CACHE_MAX_BIN bytes are allocated and
+// freed exactly.
+//
+// The cache is stream-ordered: a freed block records an event on the
+// current stream.  A later request on the same stream reuses the block at
+// once, since its pending work precedes any new work on that stream; a
+// request on another stream only reuses it once the event has completed.
+// When cudaMalloc fails the unused blocks are released and the allocation
+// is retried before std::bad_alloc is thrown.
+//
+// The cache is shared by all host threads and every operation holds its
+// lock, so containers may be created and destroyed from several threads at
+// once.  Since the current stream is kept per thread, the blocks freed by
+// one thread are reused at once only by the work of that thread.
+//
+// While a thread records a CUDA Graph (captured_graph in graph.h), the
+// launches it records keep using the blocks freed during the capture each
+// time the graph is replayed.  Those blocks are therefore retained for the
+// owner of the graph instead of being cached, and return to the cache when
+// the graph is released.
+
+namespace cusp
+{
+namespace detail
+{
+namespace device
+{
+
+const unsigned int CACHE_MIN_BIN = 9;     // 512 bytes
+const unsigned int CACHE_MAX_BIN = 30;    // 1 GiB
+
+// the graph whose capture the current thread is recording, NULL otherwise
+inline const void *& capturing_graph(void)
+{
+    static __CUSP_THREAD_LOCAL const void * graph = NULL;
+    return graph;
+}
+
+struct cache_statistics
+{
+    size_t live_bytes;      // bytes held by the containers (rounded to the size classes)
+    size_t cached_bytes;    // bytes kept for reuse
+    size_t allocations;     // requests served
+    size_t hits;            // requests served from the cache
+    size_t device_mallocs;  // calls to cudaMalloc
+
+    cache_statistics(void)
+        : live_bytes(0), cached_bytes(0), allocations(0), hits(0), device_mallocs(0) {}
+};
+
+class device_cache
+{
+    struct block
+    {
+        void * ptr;
+        size_t bytes;
+        int bin;                // -1 for exact allocations which are not cached
+        int device;
+        cudaStream_t stream;    // stream of the last use
+        cudaEvent_t ready;      // recorded on stream when the block was freed
+
+        block(void) : ptr(NULL), bytes(0), bin(-1), device(0), stream(0), ready(NULL) {}
+    };
+
+    typedef std::pair<int,int>                     bin_key;    // (device, bin)
+    typedef std::map<bin_key, std::vector<block> > free_lists;
+
+    free_lists cached;
+    std::map<void *, block> live;
+    std::map<const void *, std::vector<void *> > retained;    // live blocks freed during a capture
+
+    cache_statistics statistics;
+    size_t max_cached_bytes;
+    bool enabled;
+
+    static unsigned int bin_of(size_t bytes)
+    {
+        unsigned int bin = CACHE_MIN_BIN;
+        while ((size_t(1) << bin) < bytes && bin <= CACHE_MAX_BIN)
+            bin++;
+        return bin;
+    }
+
+    static int current_device(void)
+    {
+        int device = 0;
+        cudaGetDevice(&device);
+        return device;
+    }
+
+    // take a block of the size class from the cache, false if none is ready
+    bool reuse(const bin_key& key, cudaStream_t stream, block& result)
+    {
+        free_lists::iterator list = cached.find(key);
+
+        if (list == cached.end() || list->second.empty())
+            return false;
+
+        std::vector<block>& blocks = list->second;
+
+        for (int pass = 0; pass < 2; pass++)
+        {
+            for (size_t i = blocks.size(); i-- > 0;)
+            {
+                // same stream first, then any block whose work has completed
+                const bool usable = pass == 0 ? blocks[i].stream == stream
+                                              : cudaEventQuery(blocks[i].ready) == cudaSuccess;
+                if (usable)
+                {
+                    result = blocks[i];
+                    blocks[i] = blocks.back();
+                    blocks.pop_back();
+                    statistics.cached_bytes -= result.bytes;
+                    return true;
+                }
+            }
+        }
+
+        // clear the error state left by cudaEventQuery
+        cudaGetLastError();
+
+        return false;
+    }
+
+    // serializes the operations of the host threads
+    static cusp::detail::mutex& lock(void)
+    {
+        static cusp::detail::mutex m = __CUSP_MUTEX_INITIALIZER;
+        return m;
+    }
+
+    void release(block& b)
+    {
+        int previous = current_device();
+
+        if (b.device != previous)
+            cudaSetDevice(b.device);
+
+        if (b.ready != NULL)
+        {
+            cudaEventSynchronize(b.ready);
+            cudaEventDestroy(b.ready);
+        }
+
+        cudaFree(b.ptr);
+
+        if (b.device != previous)
+            cudaSetDevice(previous);
+    }
+
+    // return a live block with the lock held
+    void deallocate_unlocked(void * ptr)
+    {
+        std::map<void *, block>::iterator it = live.find(ptr);
+
+        if (it == live.end())
+            return;
+
+        block b = it->second;
+        live.erase(it);
+
+        statistics.live_bytes -= b.bytes;
+
+        if (b.bin < 0 || !enabled || statistics.cached_bytes + b.bytes > max_cached_bytes)
+        {
+            release(b);
+            return;
+        }
+
+        // the block is ready for other streams once the work issued so far
+        // on the current stream of its device has completed
+        int previous = current_device();
+
+        if (b.device != previous)
+        {
+            cudaSetDevice(b.device);
+            b.stream = 0;
+        }
+        else
+        {
+            b.stream = cusp::detail::device::current_stream();
+        }
+
+        if (b.ready == NULL)
+            cudaEventCreateWithFlags(&b.ready, cudaEventDisableTiming);
+
+        cudaEventRecord(b.ready, b.stream);
+
+        if (b.device != previous)
+            cudaSetDevice(previous);
+
+        cached[bin_key(b.device, b.bin)].push_back(b);
+        statistics.cached_bytes += b.bytes;
+    }
+
+    // trim with the lock held
+    void trim_unlocked(size_t keep_bytes, int device)
+    {
+        // largest size classes first
+        for (free_lists::reverse_iterator list = cached.rbegin(); list != cached.rend(); ++list)
+        {
+            if (device >= 0 && list->first.first != device)
+                continue;
+
+            std::vector<block>& blocks = list->second;
+
+            while (!blocks.empty() && statistics.cached_bytes > keep_bytes)
+            {
+                statistics.cached_bytes -= blocks.back().bytes;
+                release(blocks.back());
+                blocks.pop_back();
+            }
+        }
+    }
+
+    public:
+    device_cache(void) : max_cached_bytes(size_t(-1)), enabled(true) {}
+
+    void * allocate(size_t bytes)
+    {
+        block b;
+        b.device = current_device();
+        b.stream = cusp::detail::device::current_stream();
+
+        const unsigned int bin = bin_of(bytes);
+
+        cusp::detail::scoped_lock guard(lock());
+
+        if (enabled && bin <= CACHE_MAX_BIN)
+        {
+            b.bin   = bin;
+            b.bytes = size_t(1) << bin;
+        }
+        else
+        {
+            b.bytes = bytes;
+        }
+
+        statistics.allocations++;
+
+        block reused;
+        if (b.bin >= 0 && reuse(bin_key(b.device, b.bin), b.stream, reused))
+        {
+            reused.stream = b.stream;
+            b = reused;
+            statistics.hits++;
+        }
+        else
+        {
+            if (cudaMalloc(&b.ptr, b.bytes) != cudaSuccess)
+            {
+                // release the unused blocks of the device and retry
+                cudaGetLastError();
+                trim_unlocked(0, b.device);
+
+                if (cudaMalloc(&b.ptr, b.bytes) != cudaSuccess)
+                {
+                    cudaGetLastError();
+                    throw std::bad_alloc();
+                }
+            }
+
+            statistics.device_mallocs++;
+        }
+
+        statistics.live_bytes += b.bytes;
+        live[b.ptr] = b;
+
+        return b.ptr;
+    }
+
+    void deallocate(void * ptr)
+    {
+        cusp::detail::scoped_lock guard(lock());
+
+        // a block freed while a graph is recorded stays live for the graph
+        const void * graph = capturing_graph();
+
+        if (graph != NULL && live.find(ptr) != live.end())
+        {
+            retained[graph].push_back(ptr);
+            return;
+        }
+
+        deallocate_unlocked(ptr);
+    }
+
+    // number of blocks kept for the launches recorded into a graph
+    size_t retained_blocks(const void * graph) const
+    {
+        cusp::detail::scoped_lock guard(lock());
+
+        std::map<const void *, std::vector<void *> >::const_iterator it = retained.find(graph);
+
+        return it == retained.end() ? 0 : it->second.size();
+    }
+
+    // return the blocks kept for a graph, which may no longer be running
+    void release_retained(const void * graph)
+    {
+        cusp::detail::scoped_lock guard(lock());
+
+        std::map<const void *, std::vector<void *> >::iterator it = retained.find(graph);
+
+        if (it == retained.end())
+            return;
+
+        for (size_t i = 0; i < it->second.size(); i++)
+            deallocate_unlocked(it->second[i]);
+
+        retained.erase(it);
+    }
+
+    // release cached blocks until at most keep_bytes remain, only those of
+    // one device if device >= 0
+    void trim(size_t keep_bytes = 0, int device = -1)
+    {
+        cusp::detail::scoped_lock guard(lock());
+        trim_unlocked(keep_bytes, device);
+    }
+
+    void set_max_cached_bytes(size_t bytes)
+    {
+        cusp::detail::scoped_lock guard(lock());
+        max_cached_bytes = bytes;
+        trim_unlocked(bytes, -1);
+    }
+
+    // disabling releases the cache, later requests go to cudaMalloc
+    void set_enabled(bool enable)
+    {
+        cusp::detail::scoped_lock guard(lock());
+        enabled = enable;
+
+        if (!enabled)
+            trim_unlocked(0, -1);
+    }
+
+    bool is_enabled(void) const
+    {
+        cusp::detail::scoped_lock guard(lock());
+        return enabled;
+    }
+
+    cache_statistics get_statistics(void) const
+    {
+        cusp::detail::scoped_lock guard(lock());
+        return statistics;
+    }
+};
+
+// never destroyed, containers with static storage may still free blocks
+// after the end of main
+inline device_cache& current_device_cache(void)
+{
+    static device_cache * cache = new device_cache();
+    return *cache;
+}
+
+// device allocator of the containers, see cusp/device_cache.h
+template <typename T>
+class caching_allocator : public thrust::device_malloc_allocator<T>
+{
+    typedef thrust::device_malloc_allocator<T> Parent;
+
+    public:
+    typedef typename Parent::pointer   pointer;
+    typedef typename Parent::size_type size_type;
+
+    template <typename U>
+    struct rebind { typedef caching_allocator<U> other; };
+
+    caching_allocator(void) {}
+
+    caching_allocator(const caching_allocator&) {}
+
+    template <typename U>
+    caching_allocator(const caching_allocator<U>&) {}
+
+    pointer allocate(size_type n)
+    {
+        if (n == 0)
+            return pointer(static_cast<T*>(NULL));
+
+        return pointer(static_cast<T*>(current_device_cache().allocate(n * sizeof(T))));
+    }
+
+    void deallocate(pointer p, size_type)
+    {
+        if (p.get() != NULL)
+            current_device_cache().deallocate(p.get());
+    }
+
+    size_type max_size(void) const
+    {
+        return size_type(-1) / sizeof(T);
+    }
+};
+
+template <typename T1, typename T2>
+bool operator==(const caching_allocator<T1>&, const caching_allocator<T2>&)
+{
+    return true;
+}
+
+template <typename T1, typename T2>
+bool operator!=(const caching_allocator<T1>&, const caching_allocator<T2>&)
+{
+    return false;
+}
+
+} // end namespace device
+} // end namespace detail
+} // end namespace cusp
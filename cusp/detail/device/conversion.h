@@ -22,24 +22,32 @@
 #include <cusp/format.h>
 #include <cusp/coo_matrix.h>
 #include <cusp/csr_matrix.h>
+#include <cusp/exception.h>
 
 #include <cusp/detail/format_utils.h>
 #include <cusp/detail/device/conversion_utils.h>
 #include <cusp/detail/host/convert.h>
 
 #include <thrust/count.h>
+#include <thrust/functional.h>
 #include <thrust/gather.h>
 #include <thrust/inner_product.h>
+#include <thrust/reduce.h>
 #include <thrust/replace.h>
 #include <thrust/scan.h>
 #include <thrust/scatter.h>
 #include <thrust/sequence.h>
+#include <thrust/sort.h>
 #include <thrust/tuple.h>
 
 #include <thrust/iterator/constant_iterator.h>
 #include <thrust/iterator/counting_iterator.h>
+#include <thrust/iterator/discard_iterator.h>
+#include <thrust/iterator/permutation_iterator.h>
+#include <thrust/iterator/transform_iterator.h>
 #include <thrust/iterator/zip_iterator.h>
 
+#include <algorithm>
 #include <cassert>
 
 namespace cusp
@@ -54,6 +62,8 @@ namespace device
 //     <- ELL
 //     <- DIA
 //     <- HYB
+//     <- SELL
+//     <- BSR
 // CSR <- COO
 //     <- ELL
 //     <- DIA
@@ -64,6 +74,10 @@ namespace device
 // HYB <- CSR
 //     <- COO
 //     <- ELL
+// SELL <- CSR
+//      <- COO
+// BSR <- CSR
+//     <- COO
 
 template <typename IndexType>
 struct is_valid_ell_index
@@ -244,6 +258,136 @@ struct less_than
   __host__ __device__ bool operator()(const T &x) const {return x < num;}
 };
 
+template <typename IndexType>
+struct sell_index_functor : public thrust::unary_function<IndexType,IndexType>
+{
+  const IndexType slice_height;
+  const IndexType * position;
+  const IndexType * slice_offsets;
+
+  sell_index_functor(const IndexType slice_height, const IndexType * position, const IndexType * slice_offsets)
+    : slice_height(slice_height), position(position), slice_offsets(slice_offsets) {}
+
+  template <typename Tuple>
+    __host__ __device__
+  IndexType operator()(const Tuple& t) const
+  {
+    const IndexType row = thrust::get<0>(t);
+    const IndexType k   = thrust::get<1>(t);
+    const IndexType p   = position[row];
+
+    return slice_offsets[p / slice_height] + k * slice_height + (p % slice_height);
+  }
+};
+
+template <typename IndexType>
+struct sell_row_functor : public thrust::unary_function<IndexType,IndexType>
+{
+  const IndexType num_rows;
+  const IndexType num_slices;
+  const IndexType slice_height;
+  const IndexType * slice_offsets;
+  const IndexType * row_permutation;
+
+  sell_row_functor(const IndexType num_rows, const IndexType num_slices, const IndexType slice_height,
+                   const IndexType * slice_offsets, const IndexType * row_permutation)
+    : num_rows(num_rows), num_slices(num_slices), slice_height(slice_height),
+      slice_offsets(slice_offsets), row_permutation(row_permutation) {}
+
+    __host__ __device__
+  IndexType operator()(const IndexType n) const
+  {
+    // find the last slice s with slice_offsets[s] <= n
+    IndexType first = 0;
+    IndexType last  = num_slices;
+
+    while (last - first > 1)
+    {
+      const IndexType middle = (first + last) / 2;
+
+      if (slice_offsets[middle] <= n)
+        first = middle;
+      else
+        last = middle;
+    }
+
+    IndexType p = first * slice_height + (n - slice_offsets[first]) % slice_height;
+
+    // slots past the last row of the final slice only hold padding
+    if (p >= num_rows)
+      p = num_rows - 1;
+
+    return row_permutation[p];
+  }
+};
+
+template <typename IndexType>
+struct bsr_index_functor : public thrust::unary_function<IndexType,IndexType>
+{
+  const IndexType block_size;
+
+  bsr_index_functor(const IndexType block_size)
+    : block_size(block_size) {}
+
+  template <typename Tuple>
+    __host__ __device__
+  IndexType operator()(const Tuple& t) const
+  {
+    const IndexType block = thrust::get<0>(t);
+    const IndexType row   = thrust::get<1>(t);
+    const IndexType col   = thrust::get<2>(t);
+
+    return (block * block_size + (row % block_size)) * block_size + (col % block_size);
+  }
+};
+
+template <typename IndexType>
+struct bsr_entry_functor
+{
+  typedef thrust::tuple<IndexType,IndexType> result_type;
+
+  const IndexType block_size;
+  const IndexType * block_rows;
+  const IndexType * block_cols;
+
+  bsr_entry_functor(const IndexType block_size, const IndexType * block_rows, const IndexType * block_cols)
+    : block_size(block_size), block_rows(block_rows), block_cols(block_cols) {}
+
+    __host__ __device__
+  result_type operator()(const IndexType n) const
+  {
+    const IndexType block = n / (block_size * block_size);
+    const IndexType local = n % (block_size * block_size);
+
+    return result_type(block_rows[block] * block_size + local / block_size,
+                       block_cols[block] * block_size + local % block_size);
+  }
+};
+
+// (row, column) -> column offset
+template <typename IndexType>
+struct csr16_offset_functor : public thrust::unary_function<IndexType,IndexType>
+{
+  template <typename Tuple>
+    __host__ __device__
+  IndexType operator()(const Tuple& t) const
+  {
+    return thrust::get<1>(t) - thrust::get<0>(t);
+  }
+};
+
+// (row, column offset) -> column
+template <typename IndexType>
+struct csr16_column_functor : public thrust::unary_function<IndexType,IndexType>
+{
+  template <typename Tuple>
+    __host__ __device__
+  IndexType operator()(const Tuple& t) const
+  {
+    return thrust::get<0>(t) + IndexType(thrust::get<1>(t));
+  }
+};
+
 template <typename IndexType>
 struct is_positive
 {
@@ -268,13 +412,13 @@ void csr_to_coo(const Matrix1& src, Matrix2& dst)
 }
 
 
-template <typename Matrix1, typename Matrix2>
-void ell_to_coo(const Matrix1& src, Matrix2& dst)
+// number of valid entries in an ELL matrix
+template <typename Matrix>
+size_t ell_num_entries(const Matrix& src)
 {
-   typedef typename Matrix1::index_type IndexType;
-   
-   const IndexType pitch               = src.column_indices.pitch;
-   const IndexType num_entries_per_row = src.column_indices.num_cols;
+   typedef typename Matrix::index_type IndexType;
+
+   const IndexType pitch = src.column_indices.pitch;
 
    // define types used to programatically generate row_indices
    typedef typename thrust::counting_iterator<IndexType> IndexIterator;
@@ -282,26 +426,50 @@ void ell_to_coo(const Matrix1& src, Matrix2& dst)
 
    RowIndexIterator row_indices_begin(IndexIterator(0), modulus_value<IndexType>(pitch));
 
-   // compute true number of nonzeros in ELL
-   const IndexType num_entries = 
-     thrust::count_if
+   return thrust::count_if
       (thrust::make_zip_iterator(thrust::make_tuple(row_indices_begin, src.column_indices.values.begin())),
        thrust::make_zip_iterator(thrust::make_tuple(row_indices_begin, src.column_indices.values.begin())) + src.column_indices.values.size(),
        is_valid_ell_index<IndexType>(src.num_rows));
+}
 
-   // allocate output storage
-   dst.resize(src.num_rows, src.num_cols, num_entries);
+// copy the valid entries of an ELL matrix in row-major order to
+// a zip of (row index, column index, value) output iterators
+template <typename Matrix, typename OutputIterator>
+void ell_copy_entries(const Matrix& src, OutputIterator output)
+{
+   typedef typename Matrix::index_type IndexType;
+
+   const IndexType pitch               = src.column_indices.pitch;
+   const IndexType num_entries_per_row = src.column_indices.num_cols;
+
+   // define types used to programatically generate row_indices
+   typedef typename thrust::counting_iterator<IndexType> IndexIterator;
+   typedef typename thrust::transform_iterator<modulus_value<IndexType>, IndexIterator> RowIndexIterator;
+
+   RowIndexIterator row_indices_begin(IndexIterator(0), modulus_value<IndexType>(pitch));
 
-   // copy valid entries to COO format
    thrust::copy_if
      (thrust::make_permutation_iterator(thrust::make_zip_iterator(thrust::make_tuple(row_indices_begin, src.column_indices.values.begin(), src.values.values.begin())), thrust::make_transform_iterator(thrust::counting_iterator<IndexType>(0), transpose_index_functor<IndexType>(pitch, num_entries_per_row))),
       thrust::make_permutation_iterator(thrust::make_zip_iterator(thrust::make_tuple(row_indices_begin, src.column_indices.values.begin(), src.values.values.begin())), thrust::make_transform_iterator(thrust::counting_iterator<IndexType>(0), transpose_index_functor<IndexType>(pitch, num_entries_per_row))) + src.column_indices.values.size(),
-      thrust::make_zip_iterator(thrust::make_tuple(dst.row_indices.begin(), dst.column_indices.begin(), dst.values.begin())),
+      output,
       is_valid_ell_index<IndexType>(src.num_rows));
 }
 
-template <typename Matrix1, typename Matrix2>
-void dia_to_coo(const Matrix1& src, Matrix2& dst)
+template <typename Matrix1, typename Matrix2, typename Workspace>
+void ell_to_coo(const Matrix1& src, Matrix2& dst, Workspace& workspace)
+{
+   // compute true number of nonzeros in ELL
+   const size_t num_entries = ell_num_entries(src);
+
+   // allocate output storage
+   dst.resize(src.num_rows, src.num_cols, num_entries);
+
+   // copy valid entries to COO format
+   ell_copy_entries(src, thrust::make_zip_iterator(thrust::make_tuple(dst.row_indices.begin(), dst.column_indices.begin(), dst.values.begin())));
+}
+
+template <typename Matrix1, typename Matrix2, typename Workspace>
+void dia_to_coo(const Matrix1& src, Matrix2& dst, Workspace& workspace)
 {
    typedef typename Matrix1::index_type IndexType;
    typedef typename Matrix1::value_type ValueType;
@@ -342,9 +510,9 @@ void dia_to_coo(const Matrix1& src, Matrix2& dst)
    //   is_valid_coo_index<IndexType,ValueType>(src.num_rows,src.num_cols));
    {
      // TODO remove this when copy_if can accept more parameters
-     cusp::array1d<IndexType, cusp::device_memory> temp0(num_entries);
-     cusp::array1d<IndexType, cusp::device_memory> temp1(num_entries);
-     cusp::array1d<ValueType, cusp::device_memory> temp2(num_entries);
+     typename Workspace::template view<IndexType>::type temp0 = workspace.template array<IndexType>(0, num_entries);
+     typename Workspace::template view<IndexType>::type temp1 = workspace.template array<IndexType>(1, num_entries);
+     typename Workspace::template view<ValueType>::type temp2 = workspace.template array<ValueType>(2, num_entries);
      thrust::copy(thrust::make_permutation_iterator(thrust::make_zip_iterator(thrust::make_tuple(row_indices_begin, column_indices_begin, src.values.values.begin())), thrust::make_transform_iterator(thrust::counting_iterator<IndexType>(0), transpose_index_functor<IndexType>(pitch, num_diagonals))),
                   thrust::make_permutation_iterator(thrust::make_zip_iterator(thrust::make_tuple(row_indices_begin, column_indices_begin, src.values.values.begin())), thrust::make_transform_iterator(thrust::counting_iterator<IndexType>(0), transpose_index_functor<IndexType>(pitch, num_diagonals))) + num_entries,
                   thrust::make_zip_iterator(thrust::make_tuple(temp0.begin(), temp1.begin(), temp2.begin())));
@@ -356,28 +524,23 @@ void dia_to_coo(const Matrix1& src, Matrix2& dst)
    }
 }
 
-template <typename Matrix1, typename Matrix2>
-void hyb_to_coo(const Matrix1& src, Matrix2& dst)
+template <typename Matrix1, typename Matrix2, typename Workspace>
+void hyb_to_coo(const Matrix1& src, Matrix2& dst, Workspace& workspace)
 {
-   typedef typename Matrix1::coo_matrix_type  CooMatrixType;
-   typedef typename CooMatrixType::container  CooMatrix;
+   // count the entries of the ell portion
+   const size_t num_ell_entries = ell_num_entries(src.ell);
 
-   // convert ell portion to coo
-   CooMatrix temp;
-   ell_to_coo(src.ell, temp);
-   
    // resize output
-   dst.resize(src.num_rows, src.num_cols, temp.num_entries + src.coo.num_entries);
+   dst.resize(src.num_rows, src.num_cols, num_ell_entries + src.coo.num_entries);
+
+   // write the ell portion, then the coo portion
+   ell_copy_entries(src.ell, thrust::make_zip_iterator(thrust::make_tuple(dst.row_indices.begin(), dst.column_indices.begin(), dst.values.begin())));
 
-   // merge coo matrices together
-   thrust::copy(temp.row_indices.begin(),    temp.row_indices.end(),    dst.row_indices.begin());
-   thrust::copy(temp.column_indices.begin(), temp.column_indices.end(), dst.column_indices.begin());
-   thrust::copy(temp.values.begin(),         temp.values.end(),         dst.values.begin());
-   thrust::copy(src.coo.row_indices.begin(),    src.coo.row_indices.end(),    dst.row_indices.begin()    + temp.num_entries);
-   thrust::copy(src.coo.column_indices.begin(), src.coo.column_indices.end(), dst.column_indices.begin() + temp.num_entries);
-   thrust::copy(src.coo.values.begin(),         src.coo.values.end(),         dst.values.begin()         + temp.num_entries);
+   thrust::copy(src.coo.row_indices.begin(),    src.coo.row_indices.end(),    dst.row_indices.begin()    + num_ell_entries);
+   thrust::copy(src.coo.column_indices.begin(), src.coo.column_indices.end(), dst.column_indices.begin() + num_ell_entries);
+   thrust::copy(src.coo.values.begin(),         src.coo.values.end(),         dst.values.begin()         + num_ell_entries);
 
-   if (temp.num_entries > 0 && src.coo.num_entries > 0)
+   if (num_ell_entries > 0 && src.coo.num_entries > 0)
      cusp::detail::sort_by_row_and_column(dst.row_indices, dst.column_indices, dst.values); 
 }
    
@@ -396,46 +559,29 @@ void coo_to_csr(const Matrix1& src, Matrix2& dst)
     cusp::copy(src.values,         dst.values);
 }
 
-template <typename Matrix1, typename Matrix2>
-void ell_to_csr(const Matrix1& src, Matrix2& dst)
+template <typename Matrix1, typename Matrix2, typename Workspace>
+void ell_to_csr(const Matrix1& src, Matrix2& dst, Workspace& workspace)
 {
    typedef typename Matrix1::index_type IndexType;
-   
-   const IndexType pitch               = src.column_indices.pitch;
-   const IndexType num_entries_per_row = src.column_indices.num_cols;
-
-   // define types used to programatically generate row_indices
-   typedef typename thrust::counting_iterator<IndexType> IndexIterator;
-   typedef typename thrust::transform_iterator<modulus_value<IndexType>, IndexIterator> RowIndexIterator;
-
-   RowIndexIterator row_indices_begin(IndexIterator(0), modulus_value<IndexType>(pitch));
 
    // compute true number of nonzeros in ELL
-   const IndexType num_entries = 
-     thrust::count_if
-      (thrust::make_zip_iterator(thrust::make_tuple(row_indices_begin, src.column_indices.values.begin())),
-       thrust::make_zip_iterator(thrust::make_tuple(row_indices_begin, src.column_indices.values.begin())) + src.column_indices.values.size(),
-       is_valid_ell_index<IndexType>(src.num_rows));
+   const size_t num_entries = ell_num_entries(src);
 
    // allocate output storage
    dst.resize(src.num_rows, src.num_cols, num_entries);
 
-   // create temporary row_indices array to capture valid ELL row indices
-   cusp::array1d<IndexType, cusp::device_memory> row_indices(num_entries);
+   // temporary row_indices array to capture valid ELL row indices
+   typename Workspace::template view<IndexType>::type row_indices = workspace.template array<IndexType>(0, num_entries);
 
    // copy valid entries to mixed COO/CSR format
-   thrust::copy_if
-     (thrust::make_permutation_iterator(thrust::make_zip_iterator(thrust::make_tuple(row_indices_begin, src.column_indices.values.begin(), src.values.values.begin())), thrust::make_transform_iterator(thrust::counting_iterator<IndexType>(0), transpose_index_functor<IndexType>(pitch, num_entries_per_row))),
-      thrust::make_permutation_iterator(thrust::make_zip_iterator(thrust::make_tuple(row_indices_begin, src.column_indices.values.begin(), src.values.values.begin())), thrust::make_transform_iterator(thrust::counting_iterator<IndexType>(0), transpose_index_functor<IndexType>(pitch, num_entries_per_row))) + src.column_indices.values.size(),
-      thrust::make_zip_iterator(thrust::make_tuple(row_indices.begin(), dst.column_indices.begin(), dst.values.begin())),
-      is_valid_ell_index<IndexType>(src.num_rows));
+   ell_copy_entries(src, thrust::make_zip_iterator(thrust::make_tuple(row_indices.begin(), dst.column_indices.begin(), dst.values.begin())));
 
    // convert COO row_indices to CSR row_offsets
    cusp::detail::indices_to_offsets(row_indices, dst.row_offsets);
 }
 
-template <typename Matrix1, typename Matrix2>
-void dia_to_csr(const Matrix1& src, Matrix2& dst)
+template <typename Matrix1, typename Matrix2, typename Workspace>
+void dia_to_csr(const Matrix1& src, Matrix2& dst, Workspace& workspace)
 {
    typedef typename Matrix1::index_type IndexType;
    typedef typename Matrix1::value_type ValueType;
@@ -468,14 +614,14 @@ void dia_to_csr(const Matrix1& src, Matrix2& dst)
    ZipIterator offset_modulus_tuple(thrust::make_tuple(offsets_begin, row_indices_begin));
    ColumnIndexIterator column_indices_begin(offset_modulus_tuple, sum_tuple_functor<IndexType>());
 
-   cusp::array1d<IndexType, cusp::device_memory> row_indices(src.num_entries);
+   typename Workspace::template view<IndexType>::type row_indices = workspace.template array<IndexType>(3, src.num_entries);
 
    // copy valid entries to COO format
    {
      // TODO remove this when copy_if can accept more parameters
-     cusp::array1d<IndexType, cusp::device_memory> temp0(num_entries);
-     cusp::array1d<IndexType, cusp::device_memory> temp1(num_entries);
-     cusp::array1d<ValueType, cusp::device_memory> temp2(num_entries);
+     typename Workspace::template view<IndexType>::type temp0 = workspace.template array<IndexType>(0, num_entries);
+     typename Workspace::template view<IndexType>::type temp1 = workspace.template array<IndexType>(1, num_entries);
+     typename Workspace::template view<ValueType>::type temp2 = workspace.template array<ValueType>(2, num_entries);
      thrust::copy(thrust::make_permutation_iterator(thrust::make_zip_iterator(thrust::make_tuple(row_indices_begin, column_indices_begin, src.values.values.begin())), thrust::make_transform_iterator(thrust::counting_iterator<IndexType>(0), transpose_index_functor<IndexType>(pitch, num_diagonals))),
                   thrust::make_permutation_iterator(thrust::make_zip_iterator(thrust::make_tuple(row_indices_begin, column_indices_begin, src.values.values.begin())), thrust::make_transform_iterator(thrust::counting_iterator<IndexType>(0), transpose_index_functor<IndexType>(pitch, num_diagonals))) + num_entries,
                   thrust::make_zip_iterator(thrust::make_tuple(temp0.begin(), temp1.begin(), temp2.begin())));
@@ -498,22 +644,23 @@ void dia_to_csr(const Matrix1& src, Matrix2& dst)
 /////////
 // DIA //
 /////////
-template <typename Matrix1, typename Matrix2>
-void coo_to_dia(const Matrix1& src, Matrix2& dst,
+template <typename Matrix1, typename Matrix2, typename Workspace>
+void coo_to_dia(const Matrix1& src, Matrix2& dst, Workspace& workspace,
                 const size_t alignment = 32)
 {
     typedef typename Matrix2::index_type IndexType;
     typedef typename Matrix2::value_type ValueType;
 
     // compute number of occupied diagonals and enumerate them
-    cusp::array1d<IndexType,cusp::device_memory> diag_map(src.num_entries);
+    typename Workspace::template view<IndexType>::type diag_map = workspace.template array<IndexType>(0, src.num_entries);
     thrust::transform(thrust::make_zip_iterator( thrust::make_tuple( src.row_indices.begin(), src.column_indices.begin() ) ), 
 		      thrust::make_zip_iterator( thrust::make_tuple( src.row_indices.end()  , src.column_indices.end() ) )  ,
 		      diag_map.begin(),
 		      occupied_diagonal_functor<IndexType>(src.num_rows)); 
 
     // place ones in diagonals array locations with occupied diagonals
-    cusp::array1d<IndexType,cusp::device_memory> diagonals(src.num_rows+src.num_cols,IndexType(0));
+    typename Workspace::template view<IndexType>::type diagonals = workspace.template array<IndexType>(1, src.num_rows+src.num_cols);
+    thrust::fill(diagonals.begin(), diagonals.end(), IndexType(0));
     thrust::scatter(thrust::constant_iterator<IndexType>(1), 
 		    thrust::constant_iterator<IndexType>(1)+src.num_entries, 
 		    diag_map.begin(),
@@ -555,25 +702,26 @@ void coo_to_dia(const Matrix1& src, Matrix2& dst,
 		     IndexType(-1));
 }
 
-template <typename Matrix1, typename Matrix2>
-void csr_to_dia(const Matrix1& src, Matrix2& dst,
+template <typename Matrix1, typename Matrix2, typename Workspace>
+void csr_to_dia(const Matrix1& src, Matrix2& dst, Workspace& workspace,
                 const size_t alignment = 32)
 {
     typedef typename Matrix2::index_type IndexType;
     typedef typename Matrix2::value_type ValueType;
 
     // compute number of occupied diagonals and enumerate them
-    cusp::array1d<IndexType,cusp::device_memory> row_indices(src.num_entries);
+    typename Workspace::template view<IndexType>::type row_indices = workspace.template array<IndexType>(0, src.num_entries);
     cusp::detail::offsets_to_indices(src.row_offsets, row_indices);
 
-    cusp::array1d<IndexType,cusp::device_memory> diag_map(src.num_entries);
+    typename Workspace::template view<IndexType>::type diag_map = workspace.template array<IndexType>(1, src.num_entries);
     thrust::transform(thrust::make_zip_iterator( thrust::make_tuple( row_indices.begin(), src.column_indices.begin() ) ), 
 		      thrust::make_zip_iterator( thrust::make_tuple( row_indices.end()  , src.column_indices.end() ) )  ,
 		      diag_map.begin(),
 		      occupied_diagonal_functor<IndexType>(src.num_rows)); 
 
     // place ones in diagonals array locations with occupied diagonals
-    cusp::array1d<IndexType,cusp::device_memory> diagonals(src.num_rows+src.num_cols,IndexType(0));
+    typename Workspace::template view<IndexType>::type diagonals = workspace.template array<IndexType>(2, src.num_rows+src.num_cols);
+    thrust::fill(diagonals.begin(), diagonals.end(), IndexType(0));
     thrust::scatter(thrust::constant_iterator<IndexType>(1), 
 		    thrust::constant_iterator<IndexType>(1)+src.num_entries, 
 		    diag_map.begin(),
@@ -620,8 +768,8 @@ void csr_to_dia(const Matrix1& src, Matrix2& dst,
 /////////
 // ELL //
 /////////
-template <typename Matrix1, typename Matrix2>
-void coo_to_ell(const Matrix1& src, Matrix2& dst,
+template <typename Matrix1, typename Matrix2, typename Workspace>
+void coo_to_ell(const Matrix1& src, Matrix2& dst, Workspace& workspace,
                 const size_t num_entries_per_row, const size_t alignment = 32)
 {
   typedef typename Matrix2::index_type IndexType;
@@ -638,7 +786,7 @@ void coo_to_ell(const Matrix1& src, Matrix2& dst,
 
   // compute permutation from COO index to ELL index
   // first enumerate the entries within each row, e.g. [0, 1, 2, 0, 1, 2, 3, ...]
-  cusp::array1d<IndexType, cusp::device_memory> permutation(src.num_entries);
+  typename Workspace::template view<IndexType>::type permutation = workspace.template array<IndexType>(0, src.num_entries);
 
   thrust::exclusive_scan_by_key(src.row_indices.begin(), src.row_indices.end(),
                                 thrust::constant_iterator<IndexType>(1),
@@ -664,8 +812,8 @@ void coo_to_ell(const Matrix1& src, Matrix2& dst,
                   dst.values.values.begin());
 }
 
-template <typename Matrix1, typename Matrix2>
-void csr_to_ell(const Matrix1& src, Matrix2& dst,
+template <typename Matrix1, typename Matrix2, typename Workspace>
+void csr_to_ell(const Matrix1& src, Matrix2& dst, Workspace& workspace,
                 const size_t num_entries_per_row, const size_t alignment = 32)
 {
   typedef typename Matrix2::index_type IndexType;
@@ -675,12 +823,12 @@ void csr_to_ell(const Matrix1& src, Matrix2& dst,
   dst.resize(src.num_rows, src.num_cols, src.num_entries, num_entries_per_row, alignment);
 
   // expand row offsets into row indices
-  cusp::array1d<IndexType, cusp::device_memory> row_indices(src.num_entries);
+  typename Workspace::template view<IndexType>::type row_indices = workspace.template array<IndexType>(0, src.num_entries);
   cusp::detail::offsets_to_indices(src.row_offsets, row_indices);
 
   // compute permutation from CSR index to ELL index
   // first enumerate the entries within each row, e.g. [0, 1, 2, 0, 1, 2, 3, ...]
-  cusp::array1d<IndexType, cusp::device_memory> permutation(src.num_entries);
+  typename Workspace::template view<IndexType>::type permutation = workspace.template array<IndexType>(1, src.num_entries);
   thrust::exclusive_scan_by_key(row_indices.begin(), row_indices.end(),
                                 thrust::constant_iterator<IndexType>(1),
                                 permutation.begin(),
@@ -710,14 +858,14 @@ void csr_to_ell(const Matrix1& src, Matrix2& dst,
 // HYB //
 /////////
 
-template <typename Matrix1, typename Matrix2>
-void coo_to_hyb(const Matrix1& src, Matrix2& dst,
+template <typename Matrix1, typename Matrix2, typename Workspace>
+void coo_to_hyb(const Matrix1& src, Matrix2& dst, Workspace& workspace,
                 const size_t num_entries_per_row, const size_t alignment = 32)
 {
   typedef typename Matrix2::index_type IndexType;
   typedef typename Matrix2::value_type ValueType;
 
-  cusp::array1d<IndexType, cusp::device_memory> indices(src.num_entries);
+  typename Workspace::template view<IndexType>::type indices = workspace.template array<IndexType>(0, src.num_entries);
   thrust::exclusive_scan_by_key(src.row_indices.begin(), src.row_indices.end(),
                                 thrust::constant_iterator<IndexType>(1),
                                 indices.begin(),
@@ -771,20 +919,20 @@ void coo_to_hyb(const Matrix1& src, Matrix2& dst,
 //                     less_than<size_t>(dst.ell.column_indices.values.size()));
 }
 
-template <typename Matrix1, typename Matrix2>
-void csr_to_hyb(const Matrix1& src, Matrix2& dst,
+template <typename Matrix1, typename Matrix2, typename Workspace>
+void csr_to_hyb(const Matrix1& src, Matrix2& dst, Workspace& workspace,
                 const size_t num_entries_per_row, const size_t alignment = 32)
 {
   typedef typename Matrix2::index_type IndexType;
   typedef typename Matrix2::value_type ValueType;
 
   // expand row offsets into row indices
-  cusp::array1d<IndexType, cusp::device_memory> row_indices(src.num_entries);
+  typename Workspace::template view<IndexType>::type row_indices = workspace.template array<IndexType>(0, src.num_entries);
   cusp::detail::offsets_to_indices(src.row_offsets, row_indices);
 
   // TODO call coo_to_hyb with a coo_matrix_view
 
-  cusp::array1d<IndexType, cusp::device_memory> indices(src.num_entries);
+  typename Workspace::template view<IndexType>::type indices = workspace.template array<IndexType>(1, src.num_entries);
   thrust::exclusive_scan_by_key(row_indices.begin(), row_indices.end(),
                                 thrust::constant_iterator<IndexType>(1),
                                 indices.begin(),
@@ -836,6 +984,386 @@ void ell_to_hyb(const Matrix1& src, Matrix2& dst)
   cusp::copy(src, dst.ell);
 }
 
+
+//////////
+// SELL //
+//////////
+template <typename Matrix1, typename Matrix2>
+void csr_to_sell(const Matrix1& src, Matrix2& dst)
+{
+  typedef typename Matrix2::index_type IndexType;
+  typedef typename Matrix2::value_type ValueType;
+
+  const IndexType slice_height   = std::max<size_t>(1, dst.slice_height);
+  const IndexType sorting_window = std::max<size_t>(1, dst.sorting_window);
+
+  dst.slice_height   = slice_height;
+  dst.sorting_window = sorting_window;
+
+  const IndexType num_rows   = src.num_rows;
+  const IndexType num_slices = (num_rows + slice_height - 1) / slice_height;
+
+  // compute the row lengths
+  cusp::array1d<IndexType, cusp::device_memory> row_lengths(num_rows);
+  thrust::transform(src.row_offsets.begin() + 1, src.row_offsets.end(),
+                    src.row_offsets.begin(),
+                    row_lengths.begin(),
+                    thrust::minus<IndexType>());
+
+  // sort the rows by decreasing length, then (stably) by window, which
+  // leaves every window sorted by decreasing length
+  cusp::array1d<IndexType, cusp::device_memory> permutation(num_rows);
+  thrust::sequence(permutation.begin(), permutation.end());
+
+  {
+    cusp::array1d<IndexType, cusp::device_memory> keys(row_lengths);
+    thrust::stable_sort_by_key(keys.begin(), keys.end(), permutation.begin(), thrust::greater<IndexType>());
+
+    thrust::transform(permutation.begin(), permutation.end(), keys.begin(), divide_value<IndexType>(sorting_window));
+    thrust::stable_sort_by_key(keys.begin(), keys.end(), permutation.begin());
+  }
+
+  // each slice is as wide as its longest row
+  cusp::array1d<IndexType, cusp::device_memory> slice_offsets(num_slices + 1, IndexType(0));
+
+  if (num_rows > 0)
+  {
+    cusp::array1d<IndexType, cusp::device_memory> slice_widths(num_slices);
+
+    thrust::reduce_by_key
+      (thrust::make_transform_iterator(thrust::counting_iterator<IndexType>(0), divide_value<IndexType>(slice_height)),
+       thrust::make_transform_iterator(thrust::counting_iterator<IndexType>(0), divide_value<IndexType>(slice_height)) + num_rows,
+       thrust::make_permutation_iterator(row_lengths.begin(), permutation.begin()),
+       thrust::make_discard_iterator(),
+       slice_widths.begin(),
+       thrust::equal_to<IndexType>(),
+       thrust::maximum<IndexType>());
+
+    thrust::inclusive_scan(thrust::make_transform_iterator(slice_widths.begin(), multiply_value<IndexType>(slice_height)),
+                           thrust::make_transform_iterator(slice_widths.end(),   multiply_value<IndexType>(slice_height)),
+                           slice_offsets.begin() + 1);
+  }
+
+  const IndexType num_stored_entries = slice_offsets[num_slices];
+
+  // allocate output storage
+  dst.resize(src.num_rows, src.num_cols, src.num_entries, num_stored_entries);
+
+  // fill output with padding
+  thrust::fill(dst.column_indices.begin(), dst.column_indices.end(), IndexType(Matrix2::invalid_index));
+  thrust::fill(dst.values.begin(),         dst.values.end(),         ValueType(0));
+
+  if (src.num_entries > 0)
+  {
+    // position of each original row in the SELL storage
+    cusp::array1d<IndexType, cusp::device_memory> position(num_rows);
+    thrust::scatter(thrust::counting_iterator<IndexType>(0),
+                    thrust::counting_iterator<IndexType>(num_rows),
+                    permutation.begin(),
+                    position.begin());
+
+    // expand row offsets into row indices
+    cusp::array1d<IndexType, cusp::device_memory> row_indices(src.num_entries);
+    cusp::detail::offsets_to_indices(src.row_offsets, row_indices);
+
+    // enumerate the entries within each row, e.g. [0, 1, 2, 0, 1, 2, 3, ...]
+    cusp::array1d<IndexType, cusp::device_memory> indices(src.num_entries);
+    thrust::exclusive_scan_by_key(row_indices.begin(), row_indices.end(),
+                                  thrust::constant_iterator<IndexType>(1),
+                                  indices.begin(),
+                                  IndexType(0));
+
+    // compute permutation from CSR index to SELL index
+    thrust::transform(thrust::make_zip_iterator(thrust::make_tuple(row_indices.begin(), indices.begin())),
+                      thrust::make_zip_iterator(thrust::make_tuple(row_indices.end(),   indices.end())),
+                      indices.begin(),
+                      sell_index_functor<IndexType>(slice_height,
+                                                    thrust::raw_pointer_cast(&position[0]),
+                                                    thrust::raw_pointer_cast(&slice_offsets[0])));
+
+    // scatter CSR entries to SELL
+    thrust::scatter(src.column_indices.begin(), src.column_indices.end(),
+                    indices.begin(),
+                    dst.column_indices.begin());
+    thrust::scatter(src.values.begin(), src.values.end(),
+                    indices.begin(),
+                    dst.values.begin());
+  }
+
+  dst.slice_offsets.swap(slice_offsets);
+  dst.row_permutation.swap(permutation);
+}
+
+template <typename Matrix1, typename Matrix2>
+void coo_to_sell(const Matrix1& src, Matrix2& dst)
+{
+  typedef typename Matrix1::index_type IndexType;
+  typedef typename Matrix1::value_type ValueType;
+
+  cusp::csr_matrix<IndexType,ValueType,cusp::device_memory> csr;
+  coo_to_csr(src, csr);
+  csr_to_sell(csr, dst);
+}
+
+template <typename Matrix1, typename Matrix2>
+void sell_to_coo(const Matrix1& src, Matrix2& dst)
+{
+  typedef typename Matrix1::index_type IndexType;
+
+  const IndexType invalid_index      = Matrix1::invalid_index;
+  const IndexType num_stored_entries = src.column_indices.size();
+
+  dst.resize(src.num_rows, src.num_cols, src.num_entries);
+
+  if (src.num_entries == 0)
+    return;
+
+  // original row index of each stored entry
+  typedef typename thrust::counting_iterator<IndexType> IndexIterator;
+  typedef typename thrust::transform_iterator<sell_row_functor<IndexType>, IndexIterator> RowIndexIterator;
+
+  RowIndexIterator row_indices_begin(IndexIterator(0),
+                                     sell_row_functor<IndexType>(src.num_rows, src.num_slices(), src.slice_height,
+                                                                 thrust::raw_pointer_cast(&src.slice_offsets[0]),
+                                                                 thrust::raw_pointer_cast(&src.row_permutation[0])));
+
+  // copy valid entries to COO format
+  thrust::copy_if
+    (thrust::make_zip_iterator(thrust::make_tuple(row_indices_begin, src.column_indices.begin(), src.values.begin())),
+     thrust::make_zip_iterator(thrust::make_tuple(row_indices_begin, src.column_indices.begin(), src.values.begin())) + num_stored_entries,
+     src.column_indices.begin(),
+     thrust::make_zip_iterator(thrust::make_tuple(dst.row_indices.begin(), dst.column_indices.begin(), dst.values.begin())),
+     thrust::placeholders::_1 != invalid_index);
+
+  // the entries of each row are stored in order, so a stable sort by row suffices
+  thrust::stable_sort_by_key(dst.row_indices.begin(), dst.row_indices.end(),
+                             thrust::make_zip_iterator(thrust::make_tuple(dst.column_indices.begin(), dst.values.begin())));
+}
+
+/////////
+// BSR //
+/////////
+template <typename Matrix1, typename Matrix2>
+void csr_to_bsr(const Matrix1& src, Matrix2& dst)
+{
+  typedef typename Matrix2::index_type IndexType;
+  typedef typename Matrix2::value_type ValueType;
+
+  const IndexType block_size = std::max<size_t>(1, dst.block_size);
+
+  if (src.num_rows % block_size != 0 || src.num_cols % block_size != 0)
+    throw cusp::format_conversion_exception("bsr_matrix dimensions must be multiples of the block size");
+
+  dst.block_size = block_size;
+
+  if (src.num_entries == 0)
+  {
+    dst.resize(src.num_rows, src.num_cols, 0);
+    thrust::fill(dst.row_offsets.begin(), dst.row_offsets.end(), IndexType(0));
+    return;
+  }
+
+  // expand row offsets into row indices
+  cusp::array1d<IndexType, cusp::device_memory> row_indices(src.num_entries);
+  cusp::detail::offsets_to_indices(src.row_offsets, row_indices);
+
+  // sort the entries by block column, then (stably) by block row
+  cusp::array1d<IndexType, cusp::device_memory> permutation(src.num_entries);
+  thrust::sequence(permutation.begin(), permutation.end());
+
+  cusp::array1d<IndexType, cusp::device_memory> block_cols(src.num_entries);
+  cusp::array1d<IndexType, cusp::device_memory> block_rows(src.num_entries);
+
+  thrust::transform(src.column_indices.begin(), src.column_indices.end(), block_cols.begin(), divide_value<IndexType>(block_size));
+  thrust::stable_sort_by_key(block_cols.begin(), block_cols.end(), permutation.begin());
+
+  thrust::transform(thrust::make_permutation_iterator(row_indices.begin(), permutation.begin()),
+                    thrust::make_permutation_iterator(row_indices.begin(), permutation.end()),
+                    block_rows.begin(),
+                    divide_value<IndexType>(block_size));
+  thrust::stable_sort_by_key(block_rows.begin(), block_rows.end(), permutation.begin());
+
+  thrust::transform(thrust::make_permutation_iterator(src.column_indices.begin(), permutation.begin()),
+                    thrust::make_permutation_iterator(src.column_indices.begin(), permutation.end()),
+                    block_cols.begin(),
+                    divide_value<IndexType>(block_size));
+
+  // enumerate the distinct blocks and count their entries
+  cusp::array1d<IndexType, cusp::device_memory> unique_rows(src.num_entries);
+  cusp::array1d<IndexType, cusp::device_memory> unique_cols(src.num_entries);
+  cusp::array1d<IndexType, cusp::device_memory> block_offsets(src.num_entries + 1);
+
+  const IndexType num_blocks =
+    thrust::reduce_by_key
+      (thrust::make_zip_iterator(thrust::make_tuple(block_rows.begin(), block_cols.begin())),
+       thrust::make_zip_iterator(thrust::make_tuple(block_rows.end(),   block_cols.end())),
+       thrust::constant_iterator<IndexType>(1),
+       thrust::make_zip_iterator(thrust::make_tuple(unique_rows.begin(), unique_cols.begin())),
+       block_offsets.begin() + 1).second - (block_offsets.begin() + 1);
+
+  unique_rows.resize(num_blocks);
+  unique_cols.resize(num_blocks);
+  block_offsets.resize(num_blocks + 1);
+
+  block_offsets[0] = 0;
+  thrust::inclusive_scan(block_offsets.begin() + 1, block_offsets.end(), block_offsets.begin() + 1);
+
+  // allocate output storage
+  dst.resize(src.num_rows, src.num_cols, num_blocks);
+
+  cusp::detail::indices_to_offsets(unique_rows, dst.row_offsets);
+  cusp::copy(unique_cols, dst.column_indices);
+
+  // compute permutation from sorted CSR index to BSR index
+  cusp::array1d<IndexType, cusp::device_memory> indices(src.num_entries);
+  cusp::detail::offsets_to_indices(block_offsets, indices);
+
+  thrust::transform(thrust::make_zip_iterator(thrust::make_tuple(indices.begin(),
+                                                                 thrust::make_permutation_iterator(row_indices.begin(), permutation.begin()),
+                                                                 thrust::make_permutation_iterator(src.column_indices.begin(), permutation.begin()))),
+                    thrust::make_zip_iterator(thrust::make_tuple(indices.end(),
+                                                                 thrust::make_permutation_iterator(row_indices.begin(), permutation.end()),
+                                                                 thrust::make_permutation_iterator(src.column_indices.begin(), permutation.end()))),
+                    indices.begin(),
+                    bsr_index_functor<IndexType>(block_size));
+
+  // fill output with explicit zeros and scatter CSR entries to BSR
+  thrust::fill(dst.values.begin(), dst.values.end(), ValueType(0));
+
+  thrust::scatter(thrust::make_permutation_iterator(src.values.begin(), permutation.begin()),
+                  thrust::make_permutation_iterator(src.values.begin(), permutation.end()),
+                  indices.begin(),
+                  dst.values.begin());
+}
+
+template <typename Matrix1, typename Matrix2>
+void coo_to_bsr(const Matrix1& src, Matrix2& dst)
+{
+  typedef typename Matrix1::index_type IndexType;
+  typedef typename Matrix1::value_type ValueType;
+
+  cusp::csr_matrix<IndexType,ValueType,cusp::device_memory> csr;
+  coo_to_csr(src, csr);
+  csr_to_bsr(csr, dst);
+}
+
+template <typename Matrix1, typename Matrix2>
+void bsr_to_coo(const Matrix1& src, Matrix2& dst)
+{
+  typedef typename Matrix1::index_type IndexType;
+
+  const IndexType block_size  = src.block_size;
+  const IndexType num_blocks  = src.num_blocks();
+  const IndexType num_entries = num_blocks * block_size * block_size;
+
+  dst.resize(src.num_rows, src.num_cols, num_entries);
+
+  if (num_entries == 0)
+    return;
+
+  // expand block row offsets into block row indices
+  cusp::array1d<IndexType, cusp::device_memory> block_rows(num_blocks);
+  cusp::detail::offsets_to_indices(src.row_offsets, block_rows);
+
+  thrust::transform(thrust::counting_iterator<IndexType>(0),
+                    thrust::counting_iterator<IndexType>(num_entries),
+                    thrust::make_zip_iterator(thrust::make_tuple(dst.row_indices.begin(), dst.column_indices.begin())),
+                    bsr_entry_functor<IndexType>(block_size,
+                                                 thrust::raw_pointer_cast(&block_rows[0]),
+                                                 thrust::raw_pointer_cast(&src.column_indices[0])));
+  cusp::copy(src.values, dst.values);
+
+  // the blocks of a block row are sorted, so a stable sort by row suffices
+  thrust::stable_sort_by_key(dst.row_indices.begin(), dst.row_indices.end(),
+                             thrust::make_zip_iterator(thrust::make_tuple(dst.column_indices.begin(), dst.values.begin())));
+}
+
+///////////
+// CSR16 //
+///////////
+template <typename Matrix1, typename Matrix2>
+void csr_to_csr16(const Matrix1& src, Matrix2& dst)
+{
+  typedef typename Matrix1::index_type IndexType;
+
+  dst.resize(src.num_rows, src.num_cols, src.num_entries);
+  cusp::copy(src.row_offsets, dst.row_offsets);
+  cusp::copy(src.values,      dst.values);
+
+  if (src.num_entries == 0)
+    return;
+
+  cusp::array1d<IndexType, cusp::device_memory> row_indices(src.num_entries);
+  cusp::detail::offsets_to_indices(src.row_offsets, row_indices);
+
+  // compute the column offsets in IndexType and check their range before narrowing
+  cusp::array1d<IndexType, cusp::device_memory> offsets(src.num_entries);
+  thrust::transform(thrust::make_zip_iterator(thrust::make_tuple(row_indices.begin(), src.column_indices.begin())),
+                    thrust::make_zip_iterator(thrust::make_tuple(row_indices.end(),   src.column_indices.end())),
+                    offsets.begin(),
+                    csr16_offset_functor<IndexType>());
+
+  const IndexType min_offset = Matrix2::min_column_offset;
+  const IndexType max_offset = Matrix2::max_column_offset;
+
+  if (thrust::count_if(offsets.begin(), offsets.end(), less_than<IndexType>(min_offset)) > 0 ||
+      thrust::count_if(offsets.begin(), offsets.end(), greater_than_or_equal_to<IndexType>(max_offset + 1)) > 0)
+    throw cusp::format_conversion_exception("csr16_matrix column offsets must fit in 16 bits");
+
+  thrust::copy(offsets.begin(), offsets.end(), dst.column_offsets.begin());
+}
+
+template <typename Matrix1, typename Matrix2>
+void coo_to_csr16(const Matrix1& src, Matrix2& dst)
+{
+  typedef typename Matrix1::index_type IndexType;
+  typedef typename Matrix1::value_type ValueType;
+
+  cusp::csr_matrix<IndexType,ValueType,cusp::device_memory> csr;
+  coo_to_csr(src, csr);
+  csr_to_csr16(csr, dst);
+}
+
+template <typename Matrix1, typename Matrix2>
+void csr16_to_coo(const Matrix1& src, Matrix2& dst)
+{
+  typedef typename Matrix1::index_type IndexType;
+
+  dst.resize(src.num_rows, src.num_cols, src.num_entries);
+
+  if (src.num_entries == 0)
+    return;
+
+  cusp::detail::offsets_to_indices(src.row_offsets, dst.row_indices);
+
+  thrust::transform(thrust::make_zip_iterator(thrust::make_tuple(dst.row_indices.begin(), src.column_offsets.begin())),
+                    thrust::make_zip_iterator(thrust::make_tuple(dst.row_indices.end(),   src.column_offsets.end())),
+                    dst.column_indices.begin(),
+                    csr16_column_functor<IndexType>());
+  cusp::copy(src.values, dst.values);
+}
+
+template <typename Matrix1, typename Matrix2>
+void csr16_to_csr(const Matrix1& src, Matrix2& dst)
+{
+  typedef typename Matrix1::index_type IndexType;
+
+  dst.resize(src.num_rows, src.num_cols, src.num_entries);
+  cusp::copy(src.row_offsets, dst.row_offsets);
+  cusp::copy(src.values,      dst.values);
+
+  if (src.num_entries == 0)
+    return;
+
+  cusp::array1d<IndexType, cusp::device_memory> row_indices(src.num_entries);
+  cusp::detail::offsets_to_indices(src.row_offsets, row_indices);
+
+  thrust::transform(thrust::make_zip_iterator(thrust::make_tuple(row_indices.begin(), src.column_offsets.begin())),
+                    thrust::make_zip_iterator(thrust::make_tuple(row_indices.end(),   src.column_offsets.end())),
+                    dst.column_indices.begin(),
+                    csr16_column_functor<IndexType>());
+}
+
 ///////////
 // Array //
 ///////////
@@ -34,57 +34,81 @@ namespace device
 /////////
 // COO //
 /////////
-template <typename Matrix1, typename Matrix2>
-void convert(const Matrix1& src, Matrix2& dst,
+template <typename Matrix1, typename Matrix2, typename Workspace>
+void convert(const Matrix1& src, Matrix2& dst, Workspace& workspace,
              cusp::csr_format,
              cusp::coo_format)
 {    cusp::detail::device::csr_to_coo(src, dst);    }
 
-template <typename Matrix1, typename Matrix2>
-void convert(const Matrix1& src, Matrix2& dst,
+template <typename Matrix1, typename Matrix2, typename Workspace>
+void convert(const Matrix1& src, Matrix2& dst, Workspace& workspace,
              cusp::ell_format,
              cusp::coo_format)
-{    cusp::detail::device::ell_to_coo(src, dst);    }
+{    cusp::detail::device::ell_to_coo(src, dst, workspace);    }
 
-template <typename Matrix1, typename Matrix2>
-void convert(const Matrix1& src, Matrix2& dst,
+template <typename Matrix1, typename Matrix2, typename Workspace>
+void convert(const Matrix1& src, Matrix2& dst, Workspace& workspace,
              cusp::dia_format,
              cusp::coo_format)
-{    cusp::detail::device::dia_to_coo(src, dst);    }
+{    cusp::detail::device::dia_to_coo(src, dst, workspace);    }
 
-template <typename Matrix1, typename Matrix2>
-void convert(const Matrix1& src, Matrix2& dst,
+template <typename Matrix1, typename Matrix2, typename Workspace>
+void convert(const Matrix1& src, Matrix2& dst, Workspace& workspace,
              cusp::hyb_format,
              cusp::coo_format)
-{    cusp::detail::device::hyb_to_coo(src, dst);    }
+{    cusp::detail::device::hyb_to_coo(src, dst, workspace);    }
+
+template <typename Matrix1, typename Matrix2, typename Workspace>
+void convert(const Matrix1& src, Matrix2& dst, Workspace& workspace,
+             cusp::sell_format,
+             cusp::coo_format)
+{    cusp::detail::device::sell_to_coo(src, dst);    }
+
+template <typename Matrix1, typename Matrix2, typename Workspace>
+void convert(const Matrix1& src, Matrix2& dst, Workspace& workspace,
+             cusp::bsr_format,
+             cusp::coo_format)
+{    cusp::detail::device::bsr_to_coo(src, dst);    }
+
+template <typename Matrix1, typename Matrix2, typename Workspace>
+void convert(const Matrix1& src, Matrix2& dst, Workspace& workspace,
+             cusp::csr16_format,
+             cusp::coo_format)
+{    cusp::detail::device::csr16_to_coo(src, dst);    }
 
 /////////
 // CSR //
 /////////
-template <typename Matrix1, typename Matrix2>
-void convert(const Matrix1& src, Matrix2& dst,
+template <typename Matrix1, typename Matrix2, typename Workspace>
+void convert(const Matrix1& src, Matrix2& dst, Workspace& workspace,
              cusp::coo_format,
              cusp::csr_format)
 {    cusp::detail::device::coo_to_csr(src, dst);    }
 
-template <typename Matrix1, typename Matrix2>
-void convert(const Matrix1& src, Matrix2& dst,
+template <typename Matrix1, typename Matrix2, typename Workspace>
+void convert(const Matrix1& src, Matrix2& dst, Workspace& workspace,
              cusp::ell_format,
              cusp::csr_format)
-{    cusp::detail::device::ell_to_csr(src, dst);    }
+{    cusp::detail::device::ell_to_csr(src, dst, workspace);    }
 
-template <typename Matrix1, typename Matrix2>
-void convert(const Matrix1& src, Matrix2& dst,
+template <typename Matrix1, typename Matrix2, typename Workspace>
+void convert(const Matrix1& src, Matrix2& dst, Workspace& workspace,
              cusp::dia_format,
              cusp::csr_format)
-{    cusp::detail::device::dia_to_csr(src, dst);    }
+{    cusp::detail::device::dia_to_csr(src, dst, workspace);    }
+
+template <typename Matrix1, typename Matrix2, typename Workspace>
+void convert(const Matrix1& src, Matrix2& dst, Workspace& workspace,
+             cusp::csr16_format,
+             cusp::csr_format)
+{    cusp::detail::device::csr16_to_csr(src, dst);    }
 
 
 /////////
 // DIA //
 /////////
-template <typename Matrix1, typename Matrix2>
-void convert(const Matrix1& src, Matrix2& dst,
+template <typename Matrix1, typename Matrix2, typename Workspace>
+void convert(const Matrix1& src, Matrix2& dst, Workspace& workspace,
              cusp::coo_format,
              cusp::dia_format,
              const float  max_fill  = 3.0,
@@ -99,11 +123,11 @@ void convert(const Matrix1& src, Matrix2& dst,
     if (max_fill < fill_ratio && size > threshold)
         throw cusp::format_conversion_exception("dia_matrix fill-in would exceed maximum tolerance");
 
-    cusp::detail::device::coo_to_dia(src, dst, alignment);
+    cusp::detail::device::coo_to_dia(src, dst, workspace, alignment);
 }
 
-template <typename Matrix1, typename Matrix2>
-void convert(const Matrix1& src, Matrix2& dst,
+template <typename Matrix1, typename Matrix2, typename Workspace>
+void convert(const Matrix1& src, Matrix2& dst, Workspace& workspace,
              cusp::csr_format,
              cusp::dia_format,
              const float  max_fill  = 3.0,
@@ -118,14 +142,14 @@ void convert(const Matrix1& src, Matrix2& dst,
     if (max_fill < fill_ratio && size > threshold)
         throw cusp::format_conversion_exception("dia_matrix fill-in would exceed maximum tolerance");
 
-    cusp::detail::device::csr_to_dia(src, dst, alignment);
+    cusp::detail::device::csr_to_dia(src, dst, workspace, alignment);
 }
 
 /////////
 // ELL //
 /////////
-template <typename Matrix1, typename Matrix2>
-void convert(const Matrix1& src, Matrix2& dst,
+template <typename Matrix1, typename Matrix2, typename Workspace>
+void convert(const Matrix1& src, Matrix2& dst, Workspace& workspace,
              cusp::coo_format,
              cusp::ell_format,
              const float  max_fill  = 3.0,
@@ -140,11 +164,11 @@ void convert(const Matrix1& src, Matrix2& dst,
     if (max_fill < fill_ratio && size > threshold)
         throw cusp::format_conversion_exception("ell_matrix fill-in would exceed maximum tolerance");
 
-    cusp::detail::device::coo_to_ell(src, dst, max_entries_per_row, alignment);
+    cusp::detail::device::coo_to_ell(src, dst, workspace, max_entries_per_row, alignment);
 }
 
-template <typename Matrix1, typename Matrix2>
-void convert(const Matrix1& src, Matrix2& dst,
+template <typename Matrix1, typename Matrix2, typename Workspace>
+void convert(const Matrix1& src, Matrix2& dst, Workspace& workspace,
              cusp::csr_format,
              cusp::ell_format,
              const float  max_fill  = 3.0,
@@ -159,7 +183,7 @@ void convert(const Matrix1& src, Matrix2& dst,
     if (max_fill < fill_ratio && size > threshold)
         throw cusp::format_conversion_exception("ell_matrix fill-in would exceed maximum tolerance");
 
-    cusp::detail::device::csr_to_ell(src, dst, max_entries_per_row, alignment);
+    cusp::detail::device::csr_to_ell(src, dst, workspace, max_entries_per_row, alignment);
 }
 
 
@@ -167,42 +191,87 @@ void convert(const Matrix1& src, Matrix2& dst,
 // HYB //
 /////////
 
-template <typename Matrix1, typename Matrix2>
-void convert(const Matrix1& src, Matrix2& dst,
+template <typename Matrix1, typename Matrix2, typename Workspace>
+void convert(const Matrix1& src, Matrix2& dst, Workspace& workspace,
              cusp::coo_format,
              cusp::hyb_format,
              const float  relative_speed      = 3.0,
              const size_t breakeven_threshold = 4096)
 {
     const size_t num_entries_per_row = cusp::detail::device::compute_optimal_entries_per_row(src, relative_speed, breakeven_threshold);
-    cusp::detail::device::coo_to_hyb(src, dst, num_entries_per_row);
+    cusp::detail::device::coo_to_hyb(src, dst, workspace, num_entries_per_row);
 }
 
-template <typename Matrix1, typename Matrix2>
-void convert(const Matrix1& src, Matrix2& dst,
+template <typename Matrix1, typename Matrix2, typename Workspace>
+void convert(const Matrix1& src, Matrix2& dst, Workspace& workspace,
              cusp::csr_format,
              cusp::hyb_format,
              const float  relative_speed      = 3.0,
              const size_t breakeven_threshold = 4096)
 {
     const size_t num_entries_per_row = cusp::detail::device::compute_optimal_entries_per_row(src, relative_speed, breakeven_threshold);
-    cusp::detail::device::csr_to_hyb(src, dst, num_entries_per_row);
+    cusp::detail::device::csr_to_hyb(src, dst, workspace, num_entries_per_row);
 }
 
-template <typename Matrix1, typename Matrix2>
-void convert(const Matrix1& src, Matrix2& dst,
+template <typename Matrix1, typename Matrix2, typename Workspace>
+void convert(const Matrix1& src, Matrix2& dst, Workspace& workspace,
              cusp::ell_format,
              cusp::hyb_format)
 {
     cusp::detail::device::ell_to_hyb(src, dst);
 }
 
+//////////
+// SELL //
+//////////
+template <typename Matrix1, typename Matrix2, typename Workspace>
+void convert(const Matrix1& src, Matrix2& dst, Workspace& workspace,
+             cusp::csr_format,
+             cusp::sell_format)
+{    cusp::detail::device::csr_to_sell(src, dst);    }
+
+template <typename Matrix1, typename Matrix2, typename Workspace>
+void convert(const Matrix1& src, Matrix2& dst, Workspace& workspace,
+             cusp::coo_format,
+             cusp::sell_format)
+{    cusp::detail::device::coo_to_sell(src, dst);    }
+
+/////////
+// BSR //
+/////////
+template <typename Matrix1, typename Matrix2, typename Workspace>
+void convert(const Matrix1& src, Matrix2& dst, Workspace& workspace,
+             cusp::csr_format,
+             cusp::bsr_format)
+{    cusp::detail::device::csr_to_bsr(src, dst);    }
+
+template <typename Matrix1, typename Matrix2, typename Workspace>
+void convert(const Matrix1& src, Matrix2& dst, Workspace& workspace,
+             cusp::coo_format,
+             cusp::bsr_format)
+{    cusp::detail::device::coo_to_bsr(src, dst);    }
+
+///////////
+// CSR16 //
+///////////
+template <typename Matrix1, typename Matrix2, typename Workspace>
+void convert(const Matrix1& src, Matrix2& dst, Workspace& workspace,
+             cusp::csr_format,
+             cusp::csr16_format)
+{    cusp::detail::device::csr_to_csr16(src, dst);    }
+
+template <typename Matrix1, typename Matrix2, typename Workspace>
+void convert(const Matrix1& src, Matrix2& dst, Workspace& workspace,
+             cusp::coo_format,
+             cusp::csr16_format)
+{    cusp::detail::device::coo_to_csr16(src, dst);    }
+
 /////////////
 // Array1d //
 /////////////
 
-template <typename Matrix1, typename Matrix2>
-void convert(const Matrix1& src, Matrix2& dst,
+template <typename Matrix1, typename Matrix2, typename Workspace>
+void convert(const Matrix1& src, Matrix2& dst, Workspace& workspace,
              cusp::array2d_format,
              cusp::array1d_format)
 {
@@ -239,8 +308,8 @@ void convert(const Matrix1& src, Matrix2& dst,
 /////////////
 // Array2d //
 /////////////
-template <typename Matrix1, typename Matrix2>
-void convert(const Matrix1& src, Matrix2& dst,
+template <typename Matrix1, typename Matrix2, typename Workspace>
+void convert(const Matrix1& src, Matrix2& dst, Workspace& workspace,
              cusp::array1d_format,
              cusp::array2d_format)
 {
@@ -255,8 +324,8 @@ void convert(const Matrix1& src, Matrix2& dst,
 ////////////////////
 // Dense<->Sparse //
 ////////////////////
-template <typename Matrix1, typename Matrix2>
-void convert(const Matrix1& src, Matrix2& dst,
+template <typename Matrix1, typename Matrix2, typename Workspace>
+void convert(const Matrix1& src, Matrix2& dst, Workspace& workspace,
              cusp::sparse_format,
              cusp::array2d_format)
 {
@@ -277,8 +346,8 @@ void convert(const Matrix1& src, Matrix2& dst,
   cusp::copy(tmp2, dst);
 }
 
-template <typename Matrix1, typename Matrix2>
-void convert(const Matrix1& src, Matrix2& dst,
+template <typename Matrix1, typename Matrix2, typename Workspace>
+void convert(const Matrix1& src, Matrix2& dst, Workspace& workspace,
              cusp::array2d_format,
              cusp::sparse_format)
 {
@@ -299,8 +368,8 @@ void convert(const Matrix1& src, Matrix2& dst,
   cusp::copy(tmp2, dst);
 }
 
-template <typename Matrix1, typename Matrix2>
-void convert(const Matrix1& src, Matrix2& dst,
+template <typename Matrix1, typename Matrix2, typename Workspace>
+void convert(const Matrix1& src, Matrix2& dst, Workspace& workspace,
              cusp::sparse_format,
              cusp::dense_format)
 {
@@ -310,8 +379,8 @@ void convert(const Matrix1& src, Matrix2& dst,
     cusp::convert(tmp, dst);
 }
 
-template <typename Matrix1, typename Matrix2>
-void convert(const Matrix1& src, Matrix2& dst,
+template <typename Matrix1, typename Matrix2, typename Workspace>
+void convert(const Matrix1& src, Matrix2& dst, Workspace& workspace,
              cusp::dense_format,
              cusp::sparse_format)
 {
@@ -324,31 +393,51 @@ void convert(const Matrix1& src, Matrix2& dst,
 /////////////////////////////
 // Sparse->Sparse Fallback //
 /////////////////////////////
-template <typename Matrix1, typename Matrix2>
-void convert(const Matrix1& src, Matrix2& dst,
+template <typename Matrix1, typename Matrix2, typename Workspace>
+void convert(const Matrix1& src, Matrix2& dst, Workspace& workspace,
              cusp::sparse_format,
              cusp::sparse_format)
 {
    typedef typename Matrix1::index_type IndexType;
    typedef typename Matrix1::value_type ValueType;
 
-   // convert src -> coo_matrix -> dst
-   cusp::coo_matrix<IndexType, ValueType, cusp::device_memory> tmp;
-   cusp::convert(src, tmp);
-   cusp::convert(tmp, dst);
+   // convert src -> coo_matrix -> dst, with the coo_matrix stored in the
+   // workspace after the temporary arrays of the conversions themselves
+   const size_t first = 8;
+
+   typedef typename Workspace::template view<IndexType>::type IndexView;
+   typedef typename Workspace::template view<ValueType>::type ValueView;
+
+   IndexView row_indices    = workspace.template array<IndexType>(first + 0, src.num_entries);
+   IndexView column_indices = workspace.template array<IndexType>(first + 1, src.num_entries);
+   ValueView values         = workspace.template array<ValueType>(first + 2, src.num_entries);
+
+   cusp::coo_matrix_view<IndexView, IndexView, ValueView> tmp(src.num_rows, src.num_cols, src.num_entries,
+                                                              row_indices, column_indices, values);
+
+   cusp::detail::device::convert(src, tmp, workspace);
+   cusp::detail::device::convert(tmp, dst, workspace);
 }
 
 /////////////////
 // Entry Point //
 /////////////////
-template <typename Matrix1, typename Matrix2>
-void convert(const Matrix1& src, Matrix2& dst)
+template <typename Matrix1, typename Matrix2, typename Workspace>
+void convert(const Matrix1& src, Matrix2& dst, Workspace& workspace)
 {
-    cusp::detail::device::convert(src, dst,
+    cusp::detail::device::convert(src, dst, workspace,
             typename Matrix1::format(),
             typename Matrix2::format());
 }
-            
+
+template <typename Matrix1, typename Matrix2>
+void convert(const Matrix1& src, Matrix2& dst)
+{
+    cusp::convert_workspace<cusp::device_memory> workspace;
+
+    cusp::detail::device::convert(src, dst, workspace);
+}
+
 } // end namespace device
 } // end namespace detail
 } // end namespace cusp
@@ -0,0 +1,310 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+#pragma once
+
+#include <cusp/array1d.h>
+#include <cusp/exception.h>
+
+#include <cusp/detail/masked_product.h>
+
+#include <cusp/detail/device/arch.h>
+#include <cusp/detail/device/common.h>
+#include <cusp/detail/device/stream.h>
+#include <cusp/detail/device/utils.h>
+
+#include <thrust/copy.h>
+#include <thrust/fill.h>
+#include <thrust/scan.h>
+
+#include <algorithm>
+
+namespace cusp
+{
+namespace detail
+{
+namespace device
+{
+namespace detail
+{
+
+//////////////////////////////////////////////////////////////////////////////
+// Row-wise sparse matrix addition (C = alpha * A + beta * B, all CSR)
+//////////////////////////////////////////////////////////////////////////////
+//
+// Each thread merges the sorted column indices of A(i,:) and B(i,:).  The
+// symbolic pass counts the distinct columns of each row, the counts are
+// scanned into the row offsets of C, and the numeric pass writes the
+// columns and values of C.  Entries of the union of both patterns are
+// kept even when their values cancel, so the pattern of C only depends on
+// the patterns of A and B and the numeric pass may be repeated on its own
+// whenever their values change.
+//
+
+// C_row_offsets[i] = |columns of A(i,:) and B(i,:)|
+template <typename IndexType1, typename IndexType2, typename IndexType3, unsigned int BLOCK_SIZE>
+__launch_bounds__(BLOCK_SIZE,1)
+__global__ void
+csr_add_symbolic_kernel(const IndexType3 num_rows,
+                        const IndexType1 * Ap, const IndexType1 * Aj,
+                        const IndexType2 * Bp, const IndexType2 * Bj,
+                              IndexType3 * Cp)
+{
+    const IndexType3 grid_size = gridDim.x * BLOCK_SIZE;
+
+    for(IndexType3 i = blockIdx.x * BLOCK_SIZE + threadIdx.x; i < num_rows; i += grid_size)
+    {
+        IndexType1 a = Ap[i], a_end = Ap[i + 1];
+        IndexType2 b = Bp[i], b_end = Bp[i + 1];
+
+        IndexType3 count = 0;
+
+        while (a < a_end && b < b_end)
+        {
+            const IndexType1 ja = Aj[a];
+            const IndexType2 jb = Bj[b];
+
+            if (ja <= jb) a++;
+            if (jb <= ja) b++;
+
+            count++;
+        }
+
+        Cp[i] = count + (a_end - a) + (b_end - b);
+    }
+}
+
+// C(i,:) = alpha * A(i,:) + beta * B(i,:) in the row offsets of C.  The
+// columns of C are only written when WriteColumns is true.
+template <typename IndexType1, typename ValueType1,
+          typename IndexType2, typename ValueType2,
+          typename IndexType3, typename ValueType3,
+          unsigned int BLOCK_SIZE, bool WriteColumns>
+__launch_bounds__(BLOCK_SIZE,1)
+__global__ void
+csr_add_numeric_kernel(const IndexType3 num_rows,
+                       const ValueType3 alpha,
+                       const IndexType1 * Ap, const IndexType1 * Aj, const ValueType1 * Ax,
+                       const ValueType3 beta,
+                       const IndexType2 * Bp, const IndexType2 * Bj, const ValueType2 * Bx,
+                       const IndexType3 * Cp,       IndexType3 * Cj,       ValueType3 * Cx)
+{
+    const IndexType3 grid_size = gridDim.x * BLOCK_SIZE;
+
+    for(IndexType3 i = blockIdx.x * BLOCK_SIZE + threadIdx.x; i < num_rows; i += grid_size)
+    {
+        IndexType1 a = Ap[i], a_end = Ap[i + 1];
+        IndexType2 b = Bp[i], b_end = Bp[i + 1];
+        IndexType3 k = Cp[i];
+
+        while (a < a_end || b < b_end)
+        {
+            IndexType3 j;
+            ValueType3 value;
+
+            if (b == b_end || (a < a_end && Aj[a] < Bj[b]))
+            {
+                j = Aj[a];
+                value = alpha * ValueType3(Ax[a++]);
+            }
+            else if (a == a_end || Bj[b] < Aj[a])
+            {
+                j = Bj[b];
+                value = beta * ValueType3(Bx[b++]);
+            }
+            else
+            {
+                j = Aj[a];
+                value = alpha * ValueType3(Ax[a++]) + beta * ValueType3(Bx[b++]);
+            }
+
+            if (WriteColumns)
+                Cj[k] = j;
+
+            Cx[k++] = value;
+        }
+    }
+}
+
+template <unsigned int BLOCK_SIZE, bool WriteColumns,
+          typename Matrix1, typename Matrix2, typename Matrix3, typename ScalarType>
+void csr_add_numeric(const ScalarType alpha, const Matrix1& A,
+                     const ScalarType beta,  const Matrix2& B,
+                           Matrix3& C)
+{
+    typedef typename Matrix1::index_type IndexType1;
+    typedef typename Matrix1::value_type ValueType1;
+    typedef typename Matrix2::index_type IndexType2;
+    typedef typename Matrix2::value_type ValueType2;
+    typedef typename Matrix3::index_type IndexType3;
+    typedef typename Matrix3::value_type ValueType3;
+
+    const size_t MAX_BLOCKS = cusp::detail::device::arch::max_active_blocks(csr_add_numeric_kernel<IndexType1, ValueType1, IndexType2, ValueType2, IndexType3, ValueType3, BLOCK_SIZE, WriteColumns>, BLOCK_SIZE, (size_t) 0);
+    const size_t NUM_BLOCKS = std::min<size_t>(MAX_BLOCKS, DIVIDE_INTO(C.num_rows, BLOCK_SIZE));
+
+    csr_add_numeric_kernel<IndexType1, ValueType1, IndexType2, ValueType2, IndexType3, ValueType3, BLOCK_SIZE, WriteColumns> <<<NUM_BLOCKS, BLOCK_SIZE, 0, cusp::detail::device::current_stream()>>>
+        (IndexType3(C.num_rows),
+         ValueType3(alpha),
+         thrust::raw_pointer_cast(&A.row_offsets[0]),
+         thrust::raw_pointer_cast(&A.column_indices[0]),
+         thrust::raw_pointer_cast(&A.values[0]),
+         ValueType3(beta),
+         thrust::raw_pointer_cast(&B.row_offsets[0]),
+         thrust::raw_pointer_cast(&B.column_indices[0]),
+         thrust::raw_pointer_cast(&B.values[0]),
+         thrust::raw_pointer_cast(&C.row_offsets[0]),
+         thrust::raw_pointer_cast(&C.column_indices[0]),
+         thrust::raw_pointer_cast(&C.values[0]));
+}
+
+// C = alpha * A + beta * B for CSR matrices with sorted column indices.
+// With reuse_pattern the pattern of C is assumed to be that of a previous
+// sum of matrices with the patterns of A and B and only the values are
+// computed.
+template <typename Matrix1, typename Matrix2, typename Matrix3, typename ScalarType>
+void csr_add(const ScalarType alpha, const Matrix1& A,
+             const ScalarType beta,  const Matrix2& B,
+                   Matrix3& C, const bool reuse_pattern)
+{
+    typedef typename Matrix1::index_type IndexType1;
+    typedef typename Matrix2::index_type IndexType2;
+    typedef typename Matrix3::index_type IndexType3;
+
+    const unsigned int BLOCK_SIZE = 256;
+
+    const size_t num_rows = A.num_rows;
+
+    if (reuse_pattern)
+    {
+        if (C.num_rows != A.num_rows || C.num_cols != A.num_cols)
+            throw cusp::invalid_input_exception("pattern of C does not match A and B");
+
+        if (C.num_entries > 0)
+            csr_add_numeric<BLOCK_SIZE, false>(alpha, A, beta, B, C);
+
+        return;
+    }
+
+    C.resize(A.num_rows, A.num_cols, 0);
+
+    if (num_rows == 0)
+        return;
+
+    // count the entries of each row of C
+    {
+        const size_t MAX_BLOCKS = cusp::detail::device::arch::max_active_blocks(csr_add_symbolic_kernel<IndexType1, IndexType2, IndexType3, BLOCK_SIZE>, BLOCK_SIZE, (size_t) 0);
+        const size_t NUM_BLOCKS = std::min<size_t>(MAX_BLOCKS, DIVIDE_INTO(num_rows, BLOCK_SIZE));
+
+        csr_add_symbolic_kernel<IndexType1, IndexType2, IndexType3, BLOCK_SIZE> <<<NUM_BLOCKS, BLOCK_SIZE, 0, cusp::detail::device::current_stream()>>>
+            (IndexType3(num_rows),
+             thrust::raw_pointer_cast(&A.row_offsets[0]),
+             thrust::raw_pointer_cast(&A.column_indices[0]),
+             thrust::raw_pointer_cast(&B.row_offsets[0]),
+             thrust::raw_pointer_cast(&B.column_indices[0]),
+             thrust::raw_pointer_cast(&C.row_offsets[0]) + 1);
+    }
+
+    C.row_offsets[0] = 0;
+    thrust::inclusive_scan(C.row_offsets.begin() + 1, C.row_offsets.end(), C.row_offsets.begin() + 1);
+
+    const size_t num_entries = C.row_offsets[num_rows];
+
+    C.resize(A.num_rows, A.num_cols, num_entries);
+
+    if (num_entries > 0)
+        csr_add_numeric<BLOCK_SIZE, true>(alpha, A, beta, B, C);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Masked sparse matrix product (C = (A * B) at the pattern of M, all CSR)
+//////////////////////////////////////////////////////////////////////////////
+//
+// C takes the pattern of M and each thread computes the values of one row
+// by intersecting the rows of B selected by A(i,:) with M(i,:), so neither
+// a symbolic pass nor an accumulator for the columns outside of the mask
+// is needed.
+//
+
+template <typename IndexType1, typename ValueType1,
+          typename IndexType2, typename ValueType2,
+          typename IndexType3, typename ValueType3,
+          unsigned int BLOCK_SIZE>
+__launch_bounds__(BLOCK_SIZE,1)
+__global__ void
+masked_spmm_csr_kernel(const IndexType3 num_rows,
+                       const IndexType1 * Ap, const IndexType1 * Aj, const ValueType1 * Ax,
+                       const IndexType2 * Bp, const IndexType2 * Bj, const ValueType2 * Bx,
+                       const IndexType3 * Cp, const IndexType3 * Cj,       ValueType3 * Cx)
+{
+    const IndexType3 grid_size = gridDim.x * BLOCK_SIZE;
+
+    for(IndexType3 i = blockIdx.x * BLOCK_SIZE + threadIdx.x; i < num_rows; i += grid_size)
+        cusp::detail::masked_row_product(i, Ap, Aj, Ax, Bp, Bj, Bx, Cp, Cj, Cx);
+}
+
+// C = (A * B) restricted to the pattern of M, which C takes.  The columns
+// of B and M must be sorted within each row.
+template <typename Matrix1, typename Matrix2, typename Matrix3, typename Matrix4>
+void masked_spmm_csr(const Matrix1& A,
+                     const Matrix2& B,
+                     const Matrix3& M,
+                           Matrix4& C)
+{
+    typedef typename Matrix1::index_type IndexType1;
+    typedef typename Matrix1::value_type ValueType1;
+    typedef typename Matrix2::index_type IndexType2;
+    typedef typename Matrix2::value_type ValueType2;
+    typedef typename Matrix4::index_type IndexType3;
+    typedef typename Matrix4::value_type ValueType3;
+
+    const unsigned int BLOCK_SIZE = 256;
+
+    C.resize(M.num_rows, M.num_cols, M.num_entries);
+
+    thrust::copy(M.row_offsets.begin(), M.row_offsets.end(), C.row_offsets.begin());
+    thrust::copy(M.column_indices.begin(), M.column_indices.end(), C.column_indices.begin());
+
+    if (C.num_entries == 0)
+        return;
+
+    if (A.num_entries == 0 || B.num_entries == 0)
+    {
+        thrust::fill(C.values.begin(), C.values.end(), ValueType3(0));
+        return;
+    }
+
+    const size_t MAX_BLOCKS = cusp::detail::device::arch::max_active_blocks(masked_spmm_csr_kernel<IndexType1, ValueType1, IndexType2, ValueType2, IndexType3, ValueType3, BLOCK_SIZE>, BLOCK_SIZE, (size_t) 0);
+    const size_t NUM_BLOCKS = std::min<size_t>(MAX_BLOCKS, DIVIDE_INTO(C.num_rows, BLOCK_SIZE));
+
+    masked_spmm_csr_kernel<IndexType1, ValueType1, IndexType2, ValueType2, IndexType3, ValueType3, BLOCK_SIZE> <<<NUM_BLOCKS, BLOCK_SIZE, 0, cusp::detail::device::current_stream()>>>
+        (IndexType3(C.num_rows),
+         thrust::raw_pointer_cast(&A.row_offsets[0]),
+         thrust::raw_pointer_cast(&A.column_indices[0]),
+         thrust::raw_pointer_cast(&A.values[0]),
+         thrust::raw_pointer_cast(&B.row_offsets[0]),
+         thrust::raw_pointer_cast(&B.column_indices[0]),
+         thrust::raw_pointer_cast(&B.values[0]),
+         thrust::raw_pointer_cast(&C.row_offsets[0]),
+         thrust::raw_pointer_cast(&C.column_indices[0]),
+         thrust::raw_pointer_cast(&C.values[0]));
+}
+
+} // end namespace detail
+} // end namespace device
+} // end namespace detail
+} // end namespace cusp
+
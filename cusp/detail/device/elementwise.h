@@ -46,6 +46,17 @@ void subtract(const Matrix1& A,
               const Matrix2& B,
                     Matrix3& C);
 
+template <typename ScalarType,
+          typename Matrix1,
+          typename Matrix2,
+          typename Matrix3>
+void add(const ScalarType alpha,
+         const Matrix1& A,
+         const ScalarType beta,
+         const Matrix2& B,
+               Matrix3& C,
+         const bool reuse_pattern);
+
 } // end namespace device
 } // end namespace detail
 } // end namespace cusp
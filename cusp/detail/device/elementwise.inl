@@ -18,9 +18,12 @@
 #pragma once
 
 #include <cusp/format.h>
+#include <cusp/conversion_cache.h>
 #include <cusp/coo_matrix.h>
+#include <cusp/csr_matrix.h>
 
 #include <cusp/detail/device/detail/coo.h>
+#include <cusp/detail/device/detail/csr.h>
 
 namespace cusp
 {
@@ -62,6 +65,58 @@ void subtract(const Matrix1& A,
 }
 
 
+/////////
+// CSR //
+/////////
+
+template <typename Matrix1,
+          typename Matrix2,
+          typename Matrix3>
+void add(const Matrix1& A,
+         const Matrix2& B,
+               Matrix3& C,
+         cusp::csr_format,
+         cusp::csr_format,
+         cusp::csr_format)
+{
+    typedef typename Matrix3::value_type ValueType;
+
+    cusp::detail::device::detail::csr_add(ValueType(1), A, ValueType(1), B, C, false);
+}
+
+template <typename Matrix1,
+          typename Matrix2,
+          typename Matrix3>
+void subtract(const Matrix1& A,
+              const Matrix2& B,
+                    Matrix3& C,
+              cusp::csr_format,
+              cusp::csr_format,
+              cusp::csr_format)
+{
+    typedef typename Matrix3::value_type ValueType;
+
+    cusp::detail::device::detail::csr_add(ValueType(1), A, ValueType(-1), B, C, false);
+}
+
+template <typename ScalarType,
+          typename Matrix1,
+          typename Matrix2,
+          typename Matrix3>
+void add(const ScalarType alpha,
+         const Matrix1& A,
+         const ScalarType beta,
+         const Matrix2& B,
+               Matrix3& C,
+         const bool reuse_pattern,
+         cusp::csr_format,
+         cusp::csr_format,
+         cusp::csr_format)
+{
+    cusp::detail::device::detail::csr_add(alpha, A, beta, B, C, reuse_pattern);
+}
+
+
 ///////////
 // Array //
 ///////////
@@ -106,6 +161,47 @@ void subtract(const Matrix1& A,
                       thrust::minus<ValueType>());
 }
 
+template <typename ValueType>
+struct axpby_functor
+{
+    const ValueType alpha;
+    const ValueType beta;
+
+    axpby_functor(const ValueType alpha, const ValueType beta)
+        : alpha(alpha), beta(beta) {}
+
+    template <typename T1, typename T2>
+    __host__ __device__
+    ValueType operator()(const T1& a, const T2& b) const
+    {
+        return alpha * ValueType(a) + beta * ValueType(b);
+    }
+};
+
+template <typename ScalarType,
+          typename Matrix1,
+          typename Matrix2,
+          typename Matrix3>
+void add(const ScalarType alpha,
+         const Matrix1& A,
+         const ScalarType beta,
+         const Matrix2& B,
+               Matrix3& C,
+         const bool reuse_pattern,
+         cusp::array2d_format,
+         cusp::array2d_format,
+         cusp::array2d_format)
+{
+    typedef typename Matrix3::value_type ValueType;
+
+    C.resize(A.num_rows, A.num_cols);
+
+    thrust::transform(A.values.values.begin(), A.values.values.end(),
+                      B.values.values.begin(),
+                      C.values.values.begin(),
+                      axpby_functor<ValueType>(ValueType(alpha), ValueType(beta)));
+}
+
 /////////////
 // Default //
 /////////////
@@ -130,8 +226,10 @@ void add(const Matrix1& A,
     typedef typename Matrix2::value_type ValueType2;
     typedef typename Matrix3::value_type ValueType3;
 
-    cusp::coo_matrix<IndexType1,ValueType1,cusp::device_memory> A_(A);
-    cusp::coo_matrix<IndexType2,ValueType2,cusp::device_memory> B_(B);
+    cusp::coo_matrix<IndexType1,ValueType1,cusp::device_memory> A_temp;
+    const cusp::coo_matrix<IndexType1,ValueType1,cusp::device_memory>& A_ = cusp::detail::cached_conversion(A, A_temp);
+    cusp::coo_matrix<IndexType2,ValueType2,cusp::device_memory> B_temp;
+    const cusp::coo_matrix<IndexType2,ValueType2,cusp::device_memory>& B_ = cusp::detail::cached_conversion(B, B_temp);
     cusp::coo_matrix<IndexType3,ValueType3,cusp::device_memory> C_;
 
     cusp::detail::device::add(A_, B_, C_);
@@ -159,8 +257,10 @@ void subtract(const Matrix1& A,
     typedef typename Matrix2::value_type ValueType2;
     typedef typename Matrix3::value_type ValueType3;
 
-    cusp::coo_matrix<IndexType1,ValueType1,cusp::device_memory> A_(A);
-    cusp::coo_matrix<IndexType2,ValueType2,cusp::device_memory> B_(B);
+    cusp::coo_matrix<IndexType1,ValueType1,cusp::device_memory> A_temp;
+    const cusp::coo_matrix<IndexType1,ValueType1,cusp::device_memory>& A_ = cusp::detail::cached_conversion(A, A_temp);
+    cusp::coo_matrix<IndexType2,ValueType2,cusp::device_memory> B_temp;
+    const cusp::coo_matrix<IndexType2,ValueType2,cusp::device_memory>& B_ = cusp::detail::cached_conversion(B, B_temp);
     cusp::coo_matrix<IndexType3,ValueType3,cusp::device_memory> C_;
 
     cusp::detail::device::subtract(A_, B_, C_);
@@ -168,6 +268,42 @@ void subtract(const Matrix1& A,
     cusp::convert(C_, C);
 }
 
+// the pattern of C is only reused in CSR format
+template <typename ScalarType,
+          typename Matrix1,
+          typename Matrix2,
+          typename Matrix3,
+          typename MatrixType1,
+          typename MatrixType2,
+          typename MatrixType3>
+void add(const ScalarType alpha,
+         const Matrix1& A,
+         const ScalarType beta,
+         const Matrix2& B,
+               Matrix3& C,
+         const bool reuse_pattern,
+         MatrixType1,
+         MatrixType2,
+         MatrixType3)
+{
+    typedef typename Matrix1::index_type IndexType1;
+    typedef typename Matrix2::index_type IndexType2;
+    typedef typename Matrix3::index_type IndexType3;
+    typedef typename Matrix1::value_type ValueType1;
+    typedef typename Matrix2::value_type ValueType2;
+    typedef typename Matrix3::value_type ValueType3;
+
+    cusp::csr_matrix<IndexType1,ValueType1,cusp::device_memory> A_temp;
+    const cusp::csr_matrix<IndexType1,ValueType1,cusp::device_memory>& A_ = cusp::detail::cached_conversion(A, A_temp);
+    cusp::csr_matrix<IndexType2,ValueType2,cusp::device_memory> B_temp;
+    const cusp::csr_matrix<IndexType2,ValueType2,cusp::device_memory>& B_ = cusp::detail::cached_conversion(B, B_temp);
+    cusp::csr_matrix<IndexType3,ValueType3,cusp::device_memory> C_;
+
+    cusp::detail::device::detail::csr_add(alpha, A_, beta, B_, C_, false);
+
+    cusp::convert(C_, C);
+}
+
 } // end namespace dispatch
 
 
@@ -202,6 +338,23 @@ void subtract(const Matrix1& A,
             typename Matrix3::format());
 }
 
+template <typename ScalarType,
+          typename Matrix1,
+          typename Matrix2,
+          typename Matrix3>
+void add(const ScalarType alpha,
+         const Matrix1& A,
+         const ScalarType beta,
+         const Matrix2& B,
+               Matrix3& C,
+         const bool reuse_pattern)
+{
+    cusp::detail::device::dispatch::add(alpha, A, beta, B, C, reuse_pattern,
+            typename Matrix1::format(),
+            typename Matrix2::format(),
+            typename Matrix3::format());
+}
+
 } // end namespace device
 } // end namespace detail
 } // end namespace cusp
@@ -0,0 +1,257 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+#pragma once
+
+#include <cusp/format.h>
+#include <cusp/array1d.h>
+#include <cusp/csr_matrix.h>
+#include <cusp/detail/format_utils.h>
+
+#include <cusp/detail/device/generalized_spmv/csr_vector.h>
+#include <cusp/detail/device/generalized_spmv/dia.h>
+#include <cusp/detail/device/generalized_spmv/ell.h>
+
+#include <thrust/functional.h>
+
+// Dispatch of y[i] = reduce(initialize(y[i]), reduce_j combine(A(i,j), x[j]))
+// over an arbitrary semiring to the kernels in generalized_spmv/.
+
+namespace cusp
+{
+namespace detail
+{
+namespace device
+{
+
+///////////////////////////////////////
+// Generalized Matrix-Vector Multiply //
+///////////////////////////////////////
+template <typename Matrix,
+          typename Vector1,
+          typename Vector2,
+          typename UnaryFunction,
+          typename BinaryFunction1,
+          typename BinaryFunction2>
+void generalized_multiply(const Matrix&  A,
+                          const Vector1& x,
+                                Vector2& y,
+                          UnaryFunction   initialize,
+                          BinaryFunction1 combine,
+                          BinaryFunction2 reduce,
+                          cusp::csr_format)
+{
+    typedef typename Matrix::index_type IndexType;
+
+    generalized_spmv_csr_vector(IndexType(A.num_rows), IndexType(A.num_cols), IndexType(A.num_entries),
+                                thrust::raw_pointer_cast(&A.row_offsets[0]),
+                                thrust::raw_pointer_cast(&A.column_indices[0]),
+                                thrust::raw_pointer_cast(&A.values[0]),
+                                thrust::raw_pointer_cast(&x[0]),
+                                (const unsigned char *) 0, (const unsigned char *) 0, (unsigned char *) 0,
+                                thrust::raw_pointer_cast(&y[0]),
+                                initialize, combine, reduce);
+}
+
+template <typename Matrix,
+          typename Vector1,
+          typename Vector2,
+          typename UnaryFunction,
+          typename BinaryFunction1,
+          typename BinaryFunction2>
+void generalized_multiply(const Matrix&  A,
+                          const Vector1& x,
+                                Vector2& y,
+                          UnaryFunction   initialize,
+                          BinaryFunction1 combine,
+                          BinaryFunction2 reduce,
+                          cusp::coo_format)
+{
+    typedef typename Matrix::index_type IndexType;
+
+    if (A.num_rows == 0)
+        return;
+
+    // the row indices are sorted, so the rows are compressed and
+    // handled by the CSR kernel
+    cusp::array1d<IndexType,cusp::device_memory> row_offsets(A.num_rows + 1);
+    cusp::detail::indices_to_offsets(A.row_indices, row_offsets);
+
+    generalized_spmv_csr_vector(IndexType(A.num_rows), IndexType(A.num_cols), IndexType(A.num_entries),
+                                thrust::raw_pointer_cast(&row_offsets[0]),
+                                thrust::raw_pointer_cast(&A.column_indices[0]),
+                                thrust::raw_pointer_cast(&A.values[0]),
+                                thrust::raw_pointer_cast(&x[0]),
+                                (const unsigned char *) 0, (const unsigned char *) 0, (unsigned char *) 0,
+                                thrust::raw_pointer_cast(&y[0]),
+                                initialize, combine, reduce);
+}
+
+template <typename Matrix,
+          typename Vector1,
+          typename Vector2,
+          typename UnaryFunction,
+          typename BinaryFunction1,
+          typename BinaryFunction2>
+void generalized_multiply(const Matrix&  A,
+                          const Vector1& x,
+                                Vector2& y,
+                          UnaryFunction   initialize,
+                          BinaryFunction1 combine,
+                          BinaryFunction2 reduce,
+                          cusp::ell_format)
+{
+    generalized_spmv_ell(A, x, y, initialize, combine, reduce);
+}
+
+template <typename Matrix,
+          typename Vector1,
+          typename Vector2,
+          typename UnaryFunction,
+          typename BinaryFunction1,
+          typename BinaryFunction2>
+void generalized_multiply(const Matrix&  A,
+                          const Vector1& x,
+                                Vector2& y,
+                          UnaryFunction   initialize,
+                          BinaryFunction1 combine,
+                          BinaryFunction2 reduce,
+                          cusp::dia_format)
+{
+    generalized_spmv_dia(A, x, y, initialize, combine, reduce);
+}
+
+template <typename Matrix,
+          typename Vector1,
+          typename Vector2,
+          typename UnaryFunction,
+          typename BinaryFunction1,
+          typename BinaryFunction2>
+void generalized_multiply(const Matrix&  A,
+                          const Vector1& x,
+                                Vector2& y,
+                          UnaryFunction   initialize,
+                          BinaryFunction1 combine,
+                          BinaryFunction2 reduce,
+                          cusp::hyb_format)
+{
+    typedef typename Vector2::value_type ValueType2;
+
+    generalized_multiply(A.ell, x, y, initialize, combine, reduce, cusp::ell_format());
+    generalized_multiply(A.coo, x, y, thrust::identity<ValueType2>(), combine, reduce, cusp::coo_format());
+}
+
+// the remaining formats are multiplied in CSR format
+template <typename Matrix,
+          typename Vector1,
+          typename Vector2,
+          typename UnaryFunction,
+          typename BinaryFunction1,
+          typename BinaryFunction2>
+void generalized_multiply(const Matrix&  A,
+                          const Vector1& x,
+                                Vector2& y,
+                          UnaryFunction   initialize,
+                          BinaryFunction1 combine,
+                          BinaryFunction2 reduce,
+                          cusp::sparse_format)
+{
+    typedef typename Matrix::index_type IndexType;
+    typedef typename Matrix::value_type ValueType;
+
+    cusp::csr_matrix<IndexType,ValueType,cusp::device_memory> B(A);
+
+    generalized_multiply(B, x, y, initialize, combine, reduce, cusp::csr_format());
+}
+
+//////////////////////////////////
+// Masked Matrix-Vector Multiply //
+//////////////////////////////////
+template <typename Matrix,
+          typename Vector1,
+          typename Vector2,
+          typename Vector3,
+          typename UnaryFunction,
+          typename BinaryFunction1,
+          typename BinaryFunction2>
+void masked_multiply(const Matrix&  A,
+                     const Vector1& x,
+                     const Vector2& mask,
+                           Vector3& y,
+                     UnaryFunction   initialize,
+                     BinaryFunction1 combine,
+                     BinaryFunction2 reduce,
+                     cusp::csr_format)
+{
+    typedef typename Matrix::index_type IndexType;
+
+    generalized_spmv_csr_vector(IndexType(A.num_rows), IndexType(A.num_cols), IndexType(A.num_entries),
+                                thrust::raw_pointer_cast(&A.row_offsets[0]),
+                                thrust::raw_pointer_cast(&A.column_indices[0]),
+                                thrust::raw_pointer_cast(&A.values[0]),
+                                thrust::raw_pointer_cast(&x[0]),
+                                (const unsigned char *) 0,
+                                thrust::raw_pointer_cast(&mask[0]),
+                                (unsigned char *) 0,
+                                thrust::raw_pointer_cast(&y[0]),
+                                initialize, combine, reduce);
+}
+
+template <typename Matrix,
+          typename Vector1,
+          typename Vector2,
+          typename Vector3,
+          typename UnaryFunction,
+          typename BinaryFunction1,
+          typename BinaryFunction2>
+void masked_multiply(const Matrix&  A,
+                     const Vector1& x,
+                     const Vector2& mask,
+                           Vector3& y,
+                     UnaryFunction   initialize,
+                     BinaryFunction1 combine,
+                     BinaryFunction2 reduce,
+                     cusp::sparse_format)
+{
+    typedef typename Matrix::index_type IndexType;
+    typedef typename Matrix::value_type ValueType;
+
+    cusp::csr_matrix<IndexType,ValueType,cusp::device_memory> B(A);
+
+    masked_multiply(B, x, mask, y, initialize, combine, reduce, cusp::csr_format());
+}
+
+template <typename Matrix,
+          typename Vector1,
+          typename Vector2,
+          typename UnaryFunction,
+          typename BinaryFunction1,
+          typename BinaryFunction2>
+void generalized_multiply(const Matrix&  A,
+                          const Vector1& x,
+                                Vector2& y,
+                          UnaryFunction   initialize,
+                          BinaryFunction1 combine,
+                          BinaryFunction2 reduce)
+{
+    cusp::detail::device::generalized_multiply(A, x, y, initialize, combine, reduce,
+                                               typename Matrix::format());
+}
+
+} // end namespace device
+} // end namespace detail
+} // end namespace cusp
@@ -22,6 +22,8 @@
 #include <cusp/detail/device/arch.h>
 #include <cusp/detail/device/utils.h>
 #include <cusp/detail/device/dereference.h>
+#include <cusp/detail/stream.h>
+#include <cusp/detail/device/stream.h>
 
 #include <thrust/copy.h>
 #include <thrust/iterator/iterator_traits.h>
@@ -687,7 +689,7 @@ void spmv_coo(SizeType        num_rows,
     typedef typename cusp::array1d<IndexType2, cusp::device_memory>::iterator OutputIterator1;
     typedef typename cusp::array1d<ValueType4, cusp::device_memory>::iterator OutputIterator2;
 
-    thrust::copy(y, y + num_rows, z);
+    cusp::detail::stream::copy(y, y + num_rows, z);
 
     if (num_entries == 0) return;
 
@@ -705,7 +707,7 @@ void spmv_coo(SizeType        num_rows,
     cusp::array1d<ValueType4, cusp::device_memory> val_carries(num_blocks);
 
     // note: we don't need to pass y
-    spmv_coo_kernel<block_size, K><<<num_blocks, block_size>>>
+    spmv_coo_kernel<block_size, K><<<num_blocks, block_size, 0, cusp::detail::device::current_stream()>>>
     (num_entries,
      interval_size,
      row_indices, column_indices, values,
@@ -714,7 +716,7 @@ void spmv_coo(SizeType        num_rows,
      row_carries.begin(), val_carries.begin());
 
     // process the per-interval results
-    spmv_coo_kernel_postprocess<block_size><<<1,block_size>>>
+    spmv_coo_kernel_postprocess<block_size><<<1, block_size, 0, cusp::detail::device::current_stream()>>>
     (num_blocks, z, reduce,
      row_carries.begin(), val_carries.begin());
 }
@@ -17,13 +17,19 @@
 
 #pragma once
 
-#include <cusp/csr_matrix.h>
-
+#include <cusp/detail/device/arch.h>
 #include <cusp/detail/device/common.h>
+#include <cusp/detail/device/stream.h>
 #include <cusp/detail/device/utils.h>
 #include <cusp/detail/device/texture.h>
 
-#include <thrust/experimental/arch.h>
+#include <algorithm>
+
+// Generalized CSR SpMV kernel with one vector of threads per row for
+// y[i] = reduce(initialize(y[i]), reduce_j combine(A(i,j), x[j])) over an
+// arbitrary semiring.  The kernel follows spmv/csr_vector.h but never
+// assumes that reduce has an identity element, so rows and lanes without
+// entries are tracked explicitly instead of starting from zero.
 
 namespace cusp
 {
@@ -32,130 +38,176 @@ namespace detail
 namespace device
 {
 
-//////////////////////////////////////////////////////////////////////////////
-// CSR SpMV kernels based on a vector model (one warp per row)
-//////////////////////////////////////////////////////////////////////////////
-//
-// spmv_csr_vector_device
-//   Each row of the CSR matrix is assigned to a warp.  The warp computes
-//   y[i] = A[i,:] * x, i.e. the dot product of the i-th row of A with 
-//   the x vector, in parallel.  This division of work implies that 
-//   the CSR index and data arrays (Aj and Ax) are accessed in a contiguous
-//   manner (but generally not aligned).  On GT200 these accesses are
-//   coalesced, unlike kernels based on the one-row-per-thread division of 
-//   work.  Since an entire 32-thread warp is assigned to each row, many 
-//   threads will remain idle when their row contains a small number 
-//   of elements.  This code relies on implicit synchronization among 
-//   threads in a warp.
-//
-// spmv_csr_vector_tex_device
-//   Same as spmv_csr_vector_tex_device, except that the texture cache is 
-//   used for accessing the x vector.
-//  
-//  Note: THREADS_PER_VECTOR must be one of [2,4,8,16,32]
-
-
-template <typename IndexType, typename ValueType, unsigned int VECTORS_PER_BLOCK, unsigned int THREADS_PER_VECTOR, bool UseCache>
+// Rows with row_mask[i] == 0 and entries with x_mask[j] == 0 are skipped
+// when the masks are given.  When row_valid is given it records which rows
+// had an entry and y receives the bare reduction of those rows, without
+// initialize, as needed by the sparse products.
+template <typename IndexType, typename MatrixValueType, typename ValueType1, typename ValueType2, typename RowMaskType,
+          unsigned int VECTORS_PER_BLOCK, unsigned int THREADS_PER_VECTOR,
+          typename UnaryFunction, typename BinaryFunction1, typename BinaryFunction2>
+__launch_bounds__(VECTORS_PER_BLOCK * THREADS_PER_VECTOR,1)
 __global__ void
-spmv_csr_vector_kernel(const IndexType num_rows,
-                       const IndexType * Ap, 
-                       const IndexType * Aj, 
-                       const ValueType * Ax, 
-                       const ValueType * x, 
-                             ValueType * y)
+generalized_spmv_csr_vector_kernel(const IndexType num_rows,
+                                   const IndexType * Ap,
+                                   const IndexType * Aj,
+                                   const MatrixValueType * Ax,
+                                   const cached_x<ValueType1> x,
+                                   const unsigned char * x_mask,
+                                   const RowMaskType * row_mask,
+                                         unsigned char * row_valid,
+                                         ValueType2 * y,
+                                   UnaryFunction   initialize,
+                                   BinaryFunction1 combine,
+                                   BinaryFunction2 reduce)
 {
-    __shared__ volatile ValueType sdata[(VECTORS_PER_BLOCK + 1) * THREADS_PER_VECTOR];      // padded to avoid reduction conditionals
-    __shared__ volatile IndexType ptrs[VECTORS_PER_BLOCK][2];
-    
+#ifndef __CUSP_HAS_WARP_SHUFFLE__
+    __shared__ volatile ValueType2 sdata[VECTORS_PER_BLOCK * THREADS_PER_VECTOR];
+    __shared__ volatile bool       svalid[VECTORS_PER_BLOCK * THREADS_PER_VECTOR];
+#endif
+
     const IndexType THREADS_PER_BLOCK = VECTORS_PER_BLOCK * THREADS_PER_VECTOR;
 
     const IndexType thread_id   = THREADS_PER_BLOCK * blockIdx.x + threadIdx.x;    // global thread index
     const IndexType thread_lane = threadIdx.x & (THREADS_PER_VECTOR - 1);          // thread index within the vector
     const IndexType vector_id   = thread_id   /  THREADS_PER_VECTOR;               // global vector index
-    const IndexType vector_lane = threadIdx.x /  THREADS_PER_VECTOR;               // vector index within the block
     const IndexType num_vectors = VECTORS_PER_BLOCK * gridDim.x;                   // total number of active vectors
 
     for(IndexType row = vector_id; row < num_rows; row += num_vectors)
     {
-        // use two threads to fetch Ap[row] and Ap[row+1]
-        // this is considerably faster than the straightforward version
-        if(thread_lane < 2)
-            ptrs[vector_lane][thread_lane] = Ap[row + thread_lane];
-
-        const IndexType row_start = ptrs[vector_lane][0];                   //same as: row_start = Ap[row];
-        const IndexType row_end   = ptrs[vector_lane][1];                   //same as: row_end   = Ap[row+1];
-
-        // initialize local sum
-        ValueType sum = 0;
-        
-        // accumulate local sums
+        // the whole vector skips the row
+        if (row_mask && row_mask[row] == RowMaskType(0))
+            continue;
+
+        const IndexType row_start = Ap[row];
+        const IndexType row_end   = Ap[row + 1];
+
+        // the first entry of each lane starts its partial result
+        ValueType2 sum   = ValueType2();
+        bool       valid = false;
+
         for(IndexType jj = row_start + thread_lane; jj < row_end; jj += THREADS_PER_VECTOR)
-            sum += Ax[jj] * fetch_x<UseCache>(Aj[jj], x);
-
-        // store local sum in shared memory
-        sdata[threadIdx.x] = sum;
-        
-        // reduce local sums to row sum
-        if (THREADS_PER_VECTOR > 16) sdata[threadIdx.x] = sum = sum + sdata[threadIdx.x + 16];
-        if (THREADS_PER_VECTOR >  8) sdata[threadIdx.x] = sum = sum + sdata[threadIdx.x +  8];
-        if (THREADS_PER_VECTOR >  4) sdata[threadIdx.x] = sum = sum + sdata[threadIdx.x +  4];
-        if (THREADS_PER_VECTOR >  2) sdata[threadIdx.x] = sum = sum + sdata[threadIdx.x +  2];
-        if (THREADS_PER_VECTOR >  1) sdata[threadIdx.x] = sum = sum + sdata[threadIdx.x +  1];
-       
-//// Alternative method (slightly slower)
-//      if (THREADS_PER_VECTOR > 16)  sdata[threadIdx.x] += sdata[threadIdx.x + 16];
-//      if (THREADS_PER_VECTOR >  8)  sdata[threadIdx.x] += sdata[threadIdx.x +  8];
-//      if (THREADS_PER_VECTOR >  4)  sdata[threadIdx.x] += sdata[threadIdx.x +  4];
-//      if (THREADS_PER_VECTOR >  2)  sdata[threadIdx.x] += sdata[threadIdx.x +  2];
-//      if (THREADS_PER_VECTOR >  1)  sdata[threadIdx.x] += sdata[threadIdx.x +  1];
+        {
+            const IndexType j = Aj[jj];
+
+            if (x_mask && !x_mask[j])
+                continue;
+
+            const ValueType2 A_ij_x_j = combine(Ax[jj], fetch_x<true>(j, x));
+
+            sum   = valid ? reduce(sum, A_ij_x_j) : A_ij_x_j;
+            valid = true;
+        }
+
+        // reduce the partial results of the lanes which saw an entry
+#ifdef __CUSP_HAS_WARP_SHUFFLE__
+        const unsigned int mask = arch::lane_mask<THREADS_PER_VECTOR>(threadIdx.x);
+
+        for(unsigned int offset = THREADS_PER_VECTOR / 2; offset > 0; offset /= 2)
+        {
+            const ValueType2 other       = arch::shfl_down(mask, sum, offset, THREADS_PER_VECTOR);
+            const int        other_valid = arch::shfl_down(mask, int(valid), offset, THREADS_PER_VECTOR);
+
+            if (other_valid)
+            {
+                sum   = valid ? reduce(sum, other) : other;
+                valid = true;
+            }
+        }
+#else
+        sdata[threadIdx.x]  = sum;
+        svalid[threadIdx.x] = valid;
+
+        for(unsigned int offset = THREADS_PER_VECTOR / 2; offset > 0; offset /= 2)
+        {
+            if (thread_lane < offset && svalid[threadIdx.x + offset])
+            {
+                const ValueType2 other = sdata[threadIdx.x + offset];
+
+                sdata[threadIdx.x]  = sum = valid ? reduce(sum, other) : other;
+                svalid[threadIdx.x] = valid = true;
+            }
+        }
+#endif
 
         // first thread writes the result
         if (thread_lane == 0)
-            y[row] += sdata[threadIdx.x];
+        {
+            if (row_valid)
+            {
+                row_valid[row] = valid;
+
+                if (valid)
+                    y[row] = sum;
+            }
+            else
+            {
+                const ValueType2 y_i = initialize(y[row]);
+                y[row] = valid ? reduce(y_i, sum) : y_i;
+            }
+        }
     }
 }
 
-template <bool UseCache, typename IndexType, typename ValueType>
-void __spmv_csr_vector(const csr_matrix<IndexType,ValueType,cusp::device_memory>& csr, 
-                       const ValueType * x, 
-                             ValueType * y)
+template <unsigned int THREADS_PER_VECTOR,
+          typename IndexType, typename MatrixValueType, typename ValueType1, typename ValueType2, typename RowMaskType,
+          typename UnaryFunction, typename BinaryFunction1, typename BinaryFunction2>
+void __generalized_spmv_csr_vector(const IndexType num_rows,
+                                   const IndexType num_cols,
+                                   const IndexType * Ap,
+                                   const IndexType * Aj,
+                                   const MatrixValueType * Ax,
+                                   const ValueType1 * x,
+                                   const unsigned char * x_mask,
+                                   const RowMaskType * row_mask,
+                                         unsigned char * row_valid,
+                                         ValueType2 * y,
+                                   UnaryFunction   initialize,
+                                   BinaryFunction1 combine,
+                                   BinaryFunction2 reduce)
 {
-    const unsigned int THREADS_PER_BLOCK  = 128;
-    const unsigned int THREADS_PER_VECTOR = 32;
-    const unsigned int VECTORS_PER_BLOCK  = THREADS_PER_BLOCK / THREADS_PER_VECTOR;
-
-    //const unsigned int MAX_BLOCKS = MAX_THREADS / THREADS_PER_BLOCK;
-    const unsigned int MAX_BLOCKS = thrust::experimental::arch::max_active_blocks(spmv_csr_vector_kernel<IndexType, ValueType, VECTORS_PER_BLOCK, THREADS_PER_VECTOR, UseCache>, THREADS_PER_BLOCK, (size_t) 0);
-    const unsigned int NUM_BLOCKS = std::min(MAX_BLOCKS, DIVIDE_INTO(csr.num_rows, VECTORS_PER_BLOCK));
-    
-    if (UseCache)
-        bind_x(x);
-
-    spmv_csr_vector_kernel<IndexType, ValueType, VECTORS_PER_BLOCK, THREADS_PER_VECTOR, UseCache> <<<NUM_BLOCKS, THREADS_PER_BLOCK>>> 
-        (csr.num_rows,
-         thrust::raw_pointer_cast(&csr.row_offsets[0]),
-         thrust::raw_pointer_cast(&csr.column_indices[0]),
-         thrust::raw_pointer_cast(&csr.values[0]),
-         x, y);
-
-    if (UseCache)
-        unbind_x(x);
-}
+    const size_t THREADS_PER_BLOCK  = 128;
+    const size_t VECTORS_PER_BLOCK  = THREADS_PER_BLOCK / THREADS_PER_VECTOR;
 
-template <typename IndexType, typename ValueType>
-void spmv_csr_vector(const cusp::csr_matrix<IndexType,ValueType,cusp::device_memory>& csr, 
-                     const ValueType * x, 
-                           ValueType * y)
-{
-    __spmv_csr_vector<false>(csr, x, y);
+    const size_t MAX_BLOCKS = cusp::detail::device::arch::max_active_blocks(generalized_spmv_csr_vector_kernel<IndexType, MatrixValueType, ValueType1, ValueType2, RowMaskType, VECTORS_PER_BLOCK, THREADS_PER_VECTOR, UnaryFunction, BinaryFunction1, BinaryFunction2>, THREADS_PER_BLOCK, (size_t) 0);
+    const size_t NUM_BLOCKS = std::min<size_t>(MAX_BLOCKS, DIVIDE_INTO(num_rows, VECTORS_PER_BLOCK));
+
+    const cached_x<ValueType1> x_cached = bind_x<true>(x, num_cols);
+
+    generalized_spmv_csr_vector_kernel<IndexType, MatrixValueType, ValueType1, ValueType2, RowMaskType, VECTORS_PER_BLOCK, THREADS_PER_VECTOR> <<<NUM_BLOCKS, THREADS_PER_BLOCK, 0, cusp::detail::device::current_stream()>>>
+        (num_rows, Ap, Aj, Ax, x_cached, x_mask, row_mask, row_valid, y, initialize, combine, reduce);
+
+    unbind_x(x_cached);
 }
 
-template <typename IndexType, typename ValueType>
-void spmv_csr_vector_tex(const csr_matrix<IndexType,ValueType,cusp::device_memory>& csr, 
-                         const ValueType * x, 
-                               ValueType * y)
+// rows of nnz_per_row entries are handled by vectors of as many threads
+template <typename IndexType, typename MatrixValueType, typename ValueType1, typename ValueType2, typename RowMaskType,
+          typename UnaryFunction, typename BinaryFunction1, typename BinaryFunction2>
+void generalized_spmv_csr_vector(const IndexType num_rows,
+                                 const IndexType num_cols,
+                                 const IndexType num_entries,
+                                 const IndexType * Ap,
+                                 const IndexType * Aj,
+                                 const MatrixValueType * Ax,
+                                 const ValueType1 * x,
+                                 const unsigned char * x_mask,
+                                 const RowMaskType * row_mask,
+                                       unsigned char * row_valid,
+                                       ValueType2 * y,
+                                 UnaryFunction   initialize,
+                                 BinaryFunction1 combine,
+                                 BinaryFunction2 reduce)
 {
-    __spmv_csr_vector<true>(csr, x, y);
+    if (num_rows == 0)
+        return;
+
+    const IndexType nnz_per_row = num_entries / num_rows;
+
+    if (nnz_per_row <=  2) { __generalized_spmv_csr_vector< 2>(num_rows, num_cols, Ap, Aj, Ax, x, x_mask, row_mask, row_valid, y, initialize, combine, reduce); return; }
+    if (nnz_per_row <=  4) { __generalized_spmv_csr_vector< 4>(num_rows, num_cols, Ap, Aj, Ax, x, x_mask, row_mask, row_valid, y, initialize, combine, reduce); return; }
+    if (nnz_per_row <=  8) { __generalized_spmv_csr_vector< 8>(num_rows, num_cols, Ap, Aj, Ax, x, x_mask, row_mask, row_valid, y, initialize, combine, reduce); return; }
+    if (nnz_per_row <= 16) { __generalized_spmv_csr_vector<16>(num_rows, num_cols, Ap, Aj, Ax, x, x_mask, row_mask, row_valid, y, initialize, combine, reduce); return; }
+
+    __generalized_spmv_csr_vector<32>(num_rows, num_cols, Ap, Aj, Ax, x, x_mask, row_mask, row_valid, y, initialize, combine, reduce);
 }
 
 } // end namespace device
@@ -19,12 +19,18 @@
 
 #include <cusp/dia_matrix.h>
 
+#include <cusp/detail/device/arch.h>
 #include <cusp/detail/device/common.h>
+#include <cusp/detail/device/stream.h>
 #include <cusp/detail/device/utils.h>
 #include <cusp/detail/device/texture.h>
 
-#include <thrust/functional.h>
-#include <thrust/experimental/arch.h>
+#include <algorithm>
+
+// Generalized SpMV kernel for the DIA matrix format, one thread per row.
+// Entries of the diagonals outside the matrix are skipped and every row
+// starts from initialize(y[i]), so reduce needs no identity element.  The
+// stored zeros of the diagonals take part like any other entry.
 
 namespace cusp
 {
@@ -33,145 +39,81 @@ namespace detail
 namespace device
 {
 
-////////////////////////////////////////////////////////////////////////
-// DIA SpMV kernels 
-///////////////////////////////////////////////////////////////////////
-//
-// Diagonal matrices arise in grid-based discretizations using stencils.  
-// For instance, the standard 5-point discretization of the two-dimensional 
-// Laplacian operator has the stencil:
-//      [  0  -1   0 ]
-//      [ -1   4  -1 ]
-//      [  0  -1   0 ]
-// and the resulting DIA format has 5 diagonals.
-//
-// spmv_dia
-//   Each thread computes y[i] += A[i,:] * x 
-//   (the dot product of the i-th row of A with the x vector)
-//
-// spmv_dia_tex
-//   Same as spmv_dia, except x is accessed via texture cache.
-//
-
-
-template <unsigned int BLOCK_SIZE, bool UseCache,
-          typename IndexType,
-          typename ValueType,
-          typename UnaryFunction,
-          typename BinaryFunction1,
-          typename BinaryFunction2>
-__global__ 
-void spmv_dia_kernel(const IndexType num_rows, 
-                     const IndexType num_cols, 
-                     const IndexType num_diagonals,
-                     const IndexType stride,
-                     const IndexType * diagonal_offsets,
-                     const ValueType * values,
-                     const ValueType * x, 
-                           ValueType * y,
-                     UnaryFunction   initialize,
-                     BinaryFunction1 combine,
-                     BinaryFunction2 reduce)
+template <typename IndexType, typename MatrixValueType, typename ValueType1, typename ValueType2, size_t BLOCK_SIZE,
+          typename UnaryFunction, typename BinaryFunction1, typename BinaryFunction2>
+__launch_bounds__(BLOCK_SIZE,1)
+__global__ void
+generalized_spmv_dia_kernel(const IndexType num_rows,
+                            const IndexType num_cols,
+                            const IndexType num_diagonals,
+                            const IndexType pitch,
+                            const IndexType * diagonal_offsets,
+                            const MatrixValueType * values,
+                            const cached_x<ValueType1> x,
+                                  ValueType2 * y,
+                            UnaryFunction   initialize,
+                            BinaryFunction1 combine,
+                            BinaryFunction2 reduce)
 {
-    __shared__ IndexType offsets[BLOCK_SIZE];
-    
     const IndexType thread_id = blockDim.x * blockIdx.x + threadIdx.x;
     const IndexType grid_size = gridDim.x * blockDim.x;
 
-    // load diagonal offsets into shared memory
-    if(threadIdx.x < num_diagonals)
-        offsets[threadIdx.x] = diagonal_offsets[threadIdx.x];
-
-    __syncthreads();
-
     for(IndexType row = thread_id; row < num_rows; row += grid_size)
     {
-        ValueType sum = initialize(y[row]);
+        ValueType2 sum = initialize(y[row]);
 
-        IndexType offset = row;
+        IndexType idx = row;
 
         for(IndexType n = 0; n < num_diagonals; n++)
         {
-            const IndexType col = row + offsets[n];
-    
-            if(col >= 0 && col < num_cols)
-            {
-                const ValueType A_ij = values[offset];
-                sum = reduce(sum, combine(A_ij, fetch_x<UseCache>(col, x)));
-            }
-    
-            offset += stride;
+            const IndexType col = row + diagonal_offsets[n];
+
+            if (col >= 0 && col < num_cols)
+                sum = reduce(sum, combine(values[idx], fetch_x<true>(col, x)));
+
+            idx += pitch;
         }
 
         y[row] = sum;
     }
 }
 
-    
-template <bool UseCache, typename IndexType, typename ValueType>
-void __spmv_dia(const cusp::dia_matrix<IndexType,ValueType,cusp::device_memory>& dia, 
-                const ValueType * x, 
-                      ValueType * y)
+template <typename Matrix,
+          typename Vector1,
+          typename Vector2,
+          typename UnaryFunction,
+          typename BinaryFunction1,
+          typename BinaryFunction2>
+void generalized_spmv_dia(const Matrix&  A,
+                          const Vector1& x,
+                                Vector2& y,
+                          UnaryFunction   initialize,
+                          BinaryFunction1 combine,
+                          BinaryFunction2 reduce)
 {
-    const unsigned int BLOCK_SIZE = 256;
-    const unsigned int MAX_BLOCKS = MAX_THREADS / BLOCK_SIZE;
-//    const unsigned int MAX_BLOCKS = thrust::experimental::arch::max_active_blocks(spmv_dia_kernel<IndexType, ValueType, BLOCK_SIZE, UseCache>, BLOCK_SIZE, (size_t) 0);
-    const unsigned int NUM_BLOCKS = std::min(MAX_BLOCKS, DIVIDE_INTO(dia.num_rows, BLOCK_SIZE));
-   
-    const IndexType stride = dia.values.num_rows;
-
-    if (UseCache)
-        bind_x(x);
-  
-    // the dia_kernel only handles BLOCK_SIZE diagonals at a time
-    for(unsigned int base = 0; base < dia.values.num_cols; base += BLOCK_SIZE)
-    {
-        // TODO break this loop up for general initialize()
-        IndexType num_diagonals = std::min<unsigned int>(dia.values.num_cols - base, BLOCK_SIZE);
-
-        spmv_dia_kernel<BLOCK_SIZE, UseCache> <<<NUM_BLOCKS, BLOCK_SIZE>>>
-            (dia.num_rows, dia.num_cols, num_diagonals, stride,
-             thrust::raw_pointer_cast(&dia.diagonal_offsets[0]) + base,
-             thrust::raw_pointer_cast(&dia.values.values[0]) + base * stride,
-             x, y,
-             thrust::identity<ValueType>(), thrust::multiplies<ValueType>(), thrust::plus<ValueType>());
-    }
+    typedef typename Matrix::index_type IndexType;
+    typedef typename Matrix::value_type MatrixValueType;
+    typedef typename Vector1::value_type ValueType1;
+    typedef typename Vector2::value_type ValueType2;
 
-    if (UseCache)
-        unbind_x(x);
-}
+    if (A.num_rows == 0)
+        return;
 
-template <typename IndexType, typename ValueType>
-void spmv_dia(const cusp::dia_matrix<IndexType,ValueType,cusp::device_memory>& dia, 
-              const ValueType * x, 
-                    ValueType * y)
-{
-    __spmv_dia<false>(dia, x, y);
-}
+    const size_t BLOCK_SIZE = 256;
+    const size_t MAX_BLOCKS = cusp::detail::device::arch::max_active_blocks(generalized_spmv_dia_kernel<IndexType,MatrixValueType,ValueType1,ValueType2,BLOCK_SIZE,UnaryFunction,BinaryFunction1,BinaryFunction2>, BLOCK_SIZE, (size_t) 0);
+    const size_t NUM_BLOCKS = std::min<size_t>(MAX_BLOCKS, DIVIDE_INTO(A.num_rows, BLOCK_SIZE));
 
-template <typename IndexType, typename ValueType>
-void spmv_dia_tex(const cusp::dia_matrix<IndexType,ValueType,cusp::device_memory>& dia, 
-                  const ValueType * x, 
-                        ValueType * y)
-{
-    __spmv_dia<true>(dia, x, y);
-}
+    const cached_x<ValueType1> x_cached = bind_x<true>(thrust::raw_pointer_cast(&x[0]), A.num_cols);
 
+    generalized_spmv_dia_kernel<IndexType,MatrixValueType,ValueType1,ValueType2,BLOCK_SIZE> <<<NUM_BLOCKS, BLOCK_SIZE, 0, cusp::detail::device::current_stream()>>>
+        (IndexType(A.num_rows), IndexType(A.num_cols),
+         IndexType(A.diagonal_offsets.size()), IndexType(A.values.pitch),
+         thrust::raw_pointer_cast(&A.diagonal_offsets[0]),
+         thrust::raw_pointer_cast(&A.values.values[0]),
+         x_cached, thrust::raw_pointer_cast(&y[0]),
+         initialize, combine, reduce);
 
-template <typename IndexType, typename ValueType>
-void spmv(const cusp::dia_matrix<IndexType,ValueType,cusp::device_memory>& dia, 
-          const ValueType * x, 
-                ValueType * y)
-{
-    spmv_dia(dia, x, y);
-}
-
-template <typename IndexType, typename ValueType>
-void spmv_tex(const cusp::dia_matrix<IndexType,ValueType,cusp::device_memory>& dia, 
-              const ValueType * x, 
-                    ValueType * y)
-{
-    spmv_dia_tex(dia, x, y);
+    unbind_x(x_cached);
 }
 
 } // end namespace device
@@ -19,14 +19,17 @@
 
 #include <cusp/ell_matrix.h>
 
+#include <cusp/detail/device/arch.h>
 #include <cusp/detail/device/common.h>
+#include <cusp/detail/device/stream.h>
 #include <cusp/detail/device/utils.h>
 #include <cusp/detail/device/texture.h>
 
-#include <thrust/functional.h>
-#include <thrust/experimental/arch.h>
+#include <algorithm>
 
-// SpMV kernel for the ELLPACK/ITPACK matrix format.
+// Generalized SpMV kernel for the ELLPACK/ITPACK matrix format, one thread
+// per row.  Padding entries are skipped and every row starts from
+// initialize(y[i]), so reduce needs no identity element.
 
 namespace cusp
 {
@@ -35,33 +38,29 @@ namespace detail
 namespace device
 {
 
-template <bool UseCache,
-          typename IndexType,
-          typename ValueType,
-          typename UnaryFunction,
-          typename BinaryFunction1,
-          typename BinaryFunction2>
-__global__ 
-void spmv_ell_kernel(const IndexType num_rows, 
-                     const IndexType num_cols, 
-                     const IndexType num_cols_per_row,
-                     const IndexType stride,
-                     const IndexType * Aj,
-                     const ValueType * Ax, 
-                     const ValueType * x, 
-                           ValueType * y,
-                     UnaryFunction   initialize,
-                     BinaryFunction1 combine,
-                     BinaryFunction2 reduce)
+template <typename IndexType, typename MatrixValueType, typename ValueType1, typename ValueType2, size_t BLOCK_SIZE,
+          typename UnaryFunction, typename BinaryFunction1, typename BinaryFunction2>
+__launch_bounds__(BLOCK_SIZE,1)
+__global__ void
+generalized_spmv_ell_kernel(const IndexType num_rows,
+                            const IndexType num_cols_per_row,
+                            const IndexType pitch,
+                            const IndexType * Aj,
+                            const MatrixValueType * Ax,
+                            const cached_x<ValueType1> x,
+                                  ValueType2 * y,
+                            UnaryFunction   initialize,
+                            BinaryFunction1 combine,
+                            BinaryFunction2 reduce)
 {
-    const IndexType invalid_index = cusp::ell_matrix<IndexType, ValueType, cusp::device_memory>::invalid_index;
+    const IndexType invalid_index = cusp::ell_matrix<IndexType, MatrixValueType, cusp::device_memory>::invalid_index;
 
     const IndexType thread_id = blockDim.x * blockIdx.x + threadIdx.x;
     const IndexType grid_size = gridDim.x * blockDim.x;
 
     for(IndexType row = thread_id; row < num_rows; row += grid_size)
     {
-        ValueType sum = initialize(y[row]);
+        ValueType2 sum = initialize(y[row]);
 
         IndexType offset = row;
 
@@ -70,77 +69,50 @@ void spmv_ell_kernel(const IndexType num_rows,
             const IndexType col = Aj[offset];
 
             if (col != invalid_index)
-            {
-                const ValueType A_ij = Ax[offset];
-                sum = reduce(sum, combine(A_ij, fetch_x<UseCache>(col, x)));
-            }
+                sum = reduce(sum, combine(Ax[offset], fetch_x<true>(col, x)));
 
-            offset += stride;
+            offset += pitch;
         }
 
         y[row] = sum;
     }
 }
 
-
-template <bool UseCache, typename IndexType, typename ValueType>
-void __spmv_ell(const cusp::ell_matrix<IndexType,ValueType,cusp::device_memory>& ell, 
-                const ValueType * x, 
-                      ValueType * y)
+template <typename Matrix,
+          typename Vector1,
+          typename Vector2,
+          typename UnaryFunction,
+          typename BinaryFunction1,
+          typename BinaryFunction2>
+void generalized_spmv_ell(const Matrix&  A,
+                          const Vector1& x,
+                                Vector2& y,
+                          UnaryFunction   initialize,
+                          BinaryFunction1 combine,
+                          BinaryFunction2 reduce)
 {
-    const unsigned int BLOCK_SIZE = 256;
-    const unsigned int MAX_BLOCKS = MAX_THREADS / BLOCK_SIZE;
-//    const unsigned int MAX_BLOCKS = thrust::experimental::arch::max_active_blocks(spmv_ell_kernel<IndexType, ValueType, UseCache>, BLOCK_SIZE, (size_t) 0);
-    const unsigned int NUM_BLOCKS = std::min(MAX_BLOCKS, DIVIDE_INTO(ell.num_rows, BLOCK_SIZE));
-
-    const IndexType stride              = ell.column_indices.num_rows;
-    const IndexType num_entries_per_row = ell.column_indices.num_cols;
-    
-    if (UseCache)
-        bind_x(x);
-
-    spmv_ell_kernel<UseCache> <<<NUM_BLOCKS, BLOCK_SIZE>>>
-        (ell.num_rows, ell.num_cols,
-         num_entries_per_row, stride,
-         thrust::raw_pointer_cast(&ell.column_indices.values[0]), 
-         thrust::raw_pointer_cast(&ell.values.values[0]),
-         x, y,
-         thrust::identity<ValueType>(), thrust::multiplies<ValueType>(), thrust::plus<ValueType>());
-
-    if (UseCache)
-        unbind_x(x);
-}
+    typedef typename Matrix::index_type IndexType;
+    typedef typename Matrix::value_type MatrixValueType;
+    typedef typename Vector1::value_type ValueType1;
+    typedef typename Vector2::value_type ValueType2;
 
-template <typename IndexType, typename ValueType>
-void spmv_ell(const cusp::ell_matrix<IndexType,ValueType,cusp::device_memory>& ell, 
-              const ValueType * x, 
-                    ValueType * y)
-{
-    __spmv_ell<false>(ell, x, y);
-}
+    if (A.num_rows == 0)
+        return;
 
-template <typename IndexType, typename ValueType>
-void spmv_ell_tex(const cusp::ell_matrix<IndexType,ValueType,cusp::device_memory>& ell, 
-                  const ValueType * x, 
-                        ValueType * y)
-{
-    __spmv_ell<true>(ell, x, y);
-}
+    const size_t BLOCK_SIZE = 256;
+    const size_t MAX_BLOCKS = cusp::detail::device::arch::max_active_blocks(generalized_spmv_ell_kernel<IndexType,MatrixValueType,ValueType1,ValueType2,BLOCK_SIZE,UnaryFunction,BinaryFunction1,BinaryFunction2>, BLOCK_SIZE, (size_t) 0);
+    const size_t NUM_BLOCKS = std::min<size_t>(MAX_BLOCKS, DIVIDE_INTO(A.num_rows, BLOCK_SIZE));
 
-template <typename IndexType, typename ValueType>
-void spmv(const cusp::ell_matrix<IndexType,ValueType,cusp::device_memory>& ell, 
-          const ValueType * x, 
-                ValueType * y)
-{
-    spmv_ell(ell, x, y);
-}
+    const cached_x<ValueType1> x_cached = bind_x<true>(thrust::raw_pointer_cast(&x[0]), A.num_cols);
 
-template <typename IndexType, typename ValueType>
-void spmv_tex(const cusp::ell_matrix<IndexType,ValueType,cusp::device_memory>& ell, 
-              const ValueType * x, 
-                    ValueType * y)
-{
-    spmv_ell_tex(ell, x, y);
+    generalized_spmv_ell_kernel<IndexType,MatrixValueType,ValueType1,ValueType2,BLOCK_SIZE> <<<NUM_BLOCKS, BLOCK_SIZE, 0, cusp::detail::device::current_stream()>>>
+        (IndexType(A.num_rows), IndexType(A.column_indices.num_cols), IndexType(A.column_indices.pitch),
+         thrust::raw_pointer_cast(&A.column_indices.values[0]),
+         thrust::raw_pointer_cast(&A.values.values[0]),
+         x_cached, thrust::raw_pointer_cast(&y[0]),
+         initialize, combine, reduce);
+
+    unbind_x(x_cached);
 }
 
 } // end namespace device
@@ -0,0 +1,222 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+#pragma once
+
+#include <cusp/detail/mutex.h>
+#include <cusp/detail/device/caching_allocator.h>
+
+#include <cuda_runtime_api.h>
+
+// stream capture with cudaStreamCaptureModeRelaxed requires CUDA 10.1
+#if defined(CUDART_VERSION) && CUDART_VERSION >= 10010
+#define __CUSP_HAS_CUDA_GRAPHS 1
+#else
+#define __CUSP_HAS_CUDA_GRAPHS 0
+#endif
+
+namespace cusp
+{
+namespace detail
+{
+namespace device
+{
+
+// true when work issued on stream is being recorded into a graph
+inline bool is_capturing(cudaStream_t stream)
+{
+#if __CUSP_HAS_CUDA_GRAPHS
+    cudaStreamCaptureStatus status = cudaStreamCaptureStatusNone;
+    if (cudaStreamIsCapturing(stream, &status) != cudaSuccess)
+    {
+        cudaGetLastError();
+        return false;
+    }
+    return status != cudaStreamCaptureStatusNone;
+#else
+    return false;
+#endif
+}
+
+// A sequence of device operations recorded once with stream capture and
+// replayed with a single launch.
+//
+// The operations are recorded on a private non-blocking stream between
+// begin_capture() and end_capture(); nothing is executed while capturing,
+// so the work has to be launched afterwards.  Copies of a captured_graph
+// start out empty, and every operation issued between begin_capture() and
+// end_capture() must be legal during capture (no synchronization with the
+// host).  Temporary storage may come from the device allocation cache: the
+// blocks freed while capturing are retained until the graph is released,
+// since every replay of the recorded launches uses them again (see
+// caching_allocator.h).
+class captured_graph
+{
+    public:
+    captured_graph(void)
+        : stream_(0)
+#if __CUSP_HAS_CUDA_GRAPHS
+        , graph(0), exec(0)
+#endif
+    {}
+
+    captured_graph(const captured_graph&)
+        : stream_(0)
+#if __CUSP_HAS_CUDA_GRAPHS
+        , graph(0), exec(0)
+#endif
+    {}
+
+    captured_graph& operator=(const captured_graph&)
+    {
+        reset();
+        return *this;
+    }
+
+    ~captured_graph(void)
+    {
+        reset();
+
+        if (stream_ != 0)
+            cudaStreamDestroy(stream_);
+    }
+
+    // whether this build of the CUDA runtime supports capture
+    static bool supported(void)
+    {
+        return __CUSP_HAS_CUDA_GRAPHS != 0;
+    }
+
+    // number of graphs the current thread has instantiated
+    static size_t& instantiations(void)
+    {
+        static __CUSP_THREAD_LOCAL size_t count = 0;
+        return count;
+    }
+
+    // true when a graph has been captured and instantiated
+    bool empty(void) const
+    {
+#if __CUSP_HAS_CUDA_GRAPHS
+        return exec == 0;
+#else
+        return true;
+#endif
+    }
+
+    // stream on which the operations must be issued during capture
+    cudaStream_t stream(void)
+    {
+        if (stream_ == 0)
+            cudaStreamCreateWithFlags(&stream_, cudaStreamNonBlocking);
+
+        return stream_;
+    }
+
+    // start recording the operations issued on stream(), returns false
+    // when capture is unavailable
+    bool begin_capture(void)
+    {
+        reset();
+
+#if __CUSP_HAS_CUDA_GRAPHS
+        if (cudaStreamBeginCapture(stream(), cudaStreamCaptureModeRelaxed) == cudaSuccess)
+        {
+            capturing_graph() = this;
+            return true;
+        }
+
+        cudaGetLastError();
+#endif
+        return false;
+    }
+
+    // stop recording and instantiate the graph, returns false when one of
+    // the recorded operations invalidated the capture
+    bool end_capture(void)
+    {
+#if __CUSP_HAS_CUDA_GRAPHS
+        if (capturing_graph() == this)
+            capturing_graph() = NULL;
+
+        cudaError_t error = cudaStreamEndCapture(stream(), &graph);
+
+        if (error == cudaSuccess)
+#if CUDART_VERSION >= 11040
+            error = cudaGraphInstantiateWithFlags(&exec, graph, 0);
+#else
+            error = cudaGraphInstantiate(&exec, graph, NULL, NULL, 0);
+#endif
+
+        if (error != cudaSuccess)
+        {
+            cudaGetLastError();
+            reset();
+            return false;
+        }
+
+        instantiations()++;
+
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    // enqueue the recorded operations on stream
+    void launch(cudaStream_t stream)
+    {
+#if __CUSP_HAS_CUDA_GRAPHS
+        cudaGraphLaunch(exec, stream);
+#endif
+    }
+
+    // release the recorded graph
+    void reset(void)
+    {
+#if __CUSP_HAS_CUDA_GRAPHS
+        if (exec != 0)
+            cudaGraphExecDestroy(exec);
+        if (graph != 0)
+            cudaGraphDestroy(graph);
+
+        exec  = 0;
+        graph = 0;
+#endif
+
+        if (capturing_graph() == this)
+            capturing_graph() = NULL;
+
+        // the storage of the recorded launches, once no replay is running
+        if (current_device_cache().retained_blocks(this) > 0)
+        {
+            cudaDeviceSynchronize();
+            current_device_cache().release_retained(this);
+        }
+    }
+
+    private:
+    cudaStream_t stream_;
+#if __CUSP_HAS_CUDA_GRAPHS
+    cudaGraph_t graph;
+    cudaGraphExec_t exec;
+#endif
+};
+
+} // end namespace device
+} // end namespace detail
+} // end namespace cusp
@@ -0,0 +1,138 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include <cusp/detail/device/stream.h>
+
+#include <cuda_runtime_api.h>
+
+#include <cstring>
+
+// L2 persistence of the vector x of y = A * x (CUDA 11 and compute
+// capability 8.0 and newer).  A part of the L2 cache is set aside for
+// persisting accesses while a cusp::l2_persistence_scope is alive, and
+// bind_x marks x as persisting through the access policy window of the
+// current stream for the kernels of one SpMV.  The matrix streams through
+// the rest of the cache once, so reserving the set-aside for x costs it
+// nothing.  Every call is a hint: devices and streams which do not support
+// it return errors, which are cleared and ignored.
+
+namespace cusp
+{
+namespace detail
+{
+namespace device
+{
+
+// size of the set-aside while a scope is alive: as much as the device
+// allows, which is at most three quarters of the L2 cache
+inline size_t l2_persistence_reserve(void)
+{
+#if CUDART_VERSION >= 11000
+    int device = 0, max_size = 0;
+
+    if (cudaGetDevice(&device) != cudaSuccess ||
+        cudaDeviceGetAttribute(&max_size, cudaDevAttrMaxPersistingL2CacheSize, device) != cudaSuccess)
+    {
+        cudaGetLastError();
+        return 0;
+    }
+
+    size_t previous = 0;
+
+    if (cudaDeviceGetLimit(&previous, cudaLimitPersistingL2CacheSize) != cudaSuccess ||
+        cudaDeviceSetLimit(cudaLimitPersistingL2CacheSize, size_t(max_size)) != cudaSuccess)
+        cudaGetLastError();
+
+    return previous;
+#else
+    return 0;
+#endif
+}
+
+// restore the set-aside and demote the persisting lines to normal ones
+inline void l2_persistence_release(size_t previous)
+{
+#if CUDART_VERSION >= 11000
+    if (cudaCtxResetPersistingL2Cache() != cudaSuccess ||
+        cudaDeviceSetLimit(cudaLimitPersistingL2CacheSize, previous) != cudaSuccess)
+        cudaGetLastError();
+#endif
+}
+
+// mark [x, x + bytes) as persisting for the kernels issued next on the
+// current stream, returns false when the window could not be set
+inline bool set_persistent_window(const void * x, size_t bytes)
+{
+#if CUDART_VERSION >= 11000
+    if (x == NULL || bytes == 0)
+        return false;
+
+    int device = 0, max_window = 0;
+    size_t set_aside = 0;
+
+    if (cudaGetDevice(&device) != cudaSuccess ||
+        cudaDeviceGetAttribute(&max_window, cudaDevAttrMaxAccessPolicyWindowSize, device) != cudaSuccess ||
+        cudaDeviceGetLimit(&set_aside, cudaLimitPersistingL2CacheSize) != cudaSuccess)
+    {
+        cudaGetLastError();
+        return false;
+    }
+
+    if (max_window <= 0 || set_aside == 0)
+        return false;
+
+    // a window larger than the set-aside keeps a random subset of x of the
+    // size of the set-aside, rather than letting the lines evict each other
+    const size_t window = bytes < size_t(max_window) ? bytes : size_t(max_window);
+
+    cudaStreamAttrValue attribute;
+    std::memset(&attribute, 0, sizeof(attribute));
+    attribute.accessPolicyWindow.base_ptr  = const_cast<void *>(x);
+    attribute.accessPolicyWindow.num_bytes = window;
+    attribute.accessPolicyWindow.hitRatio  = window <= set_aside ? 1.0f : float(double(set_aside) / window);
+    attribute.accessPolicyWindow.hitProp   = cudaAccessPropertyPersisting;
+    attribute.accessPolicyWindow.missProp  = cudaAccessPropertyStreaming;
+
+    if (cudaStreamSetAttribute(current_stream(), cudaStreamAttributeAccessPolicyWindow, &attribute) != cudaSuccess)
+    {
+        cudaGetLastError();
+        return false;
+    }
+
+    return true;
+#else
+    return false;
+#endif
+}
+
+// clear the window of the current stream, the kernels already issued keep it
+inline void clear_persistent_window(void)
+{
+#if CUDART_VERSION >= 11000
+    cudaStreamAttrValue attribute;
+    std::memset(&attribute, 0, sizeof(attribute));
+    attribute.accessPolicyWindow.num_bytes = 0;
+
+    if (cudaStreamSetAttribute(current_stream(), cudaStreamAttributeAccessPolicyWindow, &attribute) != cudaSuccess)
+        cudaGetLastError();
+#endif
+}
+
+} // end namespace device
+} // end namespace detail
+} // end namespace cusp
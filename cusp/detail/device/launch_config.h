@@ -0,0 +1,219 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include <cusp/detail/mutex.h>
+#include <cusp/detail/device/arch_policy.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <ostream>
+#include <sstream>
+#include <string>
+
+// Launch configurations of the SpMV kernels tuned per device architecture.
+//
+// The launchers of the tunable kernels ask tuned_launch() for the block
+// size, the threads per row (csr_vector) and a cap on the blocks per
+// multiprocessor, keyed by the compute capability of the current device,
+// the kernel and the size of the values.  Entries which are not in the
+// database, and fields left at zero, keep the built-in defaults.
+//
+// The database is a text file named by the CUSP_LAUNCH_DATABASE environment
+// variable, read the first time a tunable kernel is launched.  It is
+// written by performance/benchmark/tune_launch, one entry per line:
+//
+//   # arch  kernel        value_bytes  block_size  threads_per_vector  blocks_per_sm
+//   sm_80   csr_vector/8  8            256         8                   0
+//
+// The kernels are instantiated for a fixed set of block sizes (see
+// is_launch_block_size); other values in the file are ignored.  The database
+// is shared by all host threads.  Lookups, including the first one which
+// reads the file, may run concurrently; entries are expected to be set
+// before the solves which use them start.
+
+namespace cusp
+{
+namespace detail
+{
+namespace device
+{
+namespace arch
+{
+
+struct launch_config
+{
+    unsigned int block_size;            // threads per block, 0 for the default
+    unsigned int threads_per_vector;    // threads per row of csr_vector, 0 for the default
+    unsigned int blocks_per_sm;         // cap on resident blocks per SM, 0 for no cap
+
+    launch_config(unsigned int block_size = 0, unsigned int threads_per_vector = 0, unsigned int blocks_per_sm = 0)
+        : block_size(block_size), threads_per_vector(threads_per_vector), blocks_per_sm(blocks_per_sm) {}
+};
+
+// block sizes for which the tunable kernels are instantiated
+inline bool is_launch_block_size(unsigned int block_size)
+{
+    return block_size == 64 || block_size == 128 || block_size == 256 || block_size == 512;
+}
+
+inline bool is_threads_per_vector(unsigned int threads_per_vector)
+{
+    return threads_per_vector == 2  || threads_per_vector == 4 || threads_per_vector == 8 ||
+           threads_per_vector == 16 || threads_per_vector == 32;
+}
+
+class launch_database
+{
+    typedef std::map<std::string, launch_config> entry_map;
+
+    entry_map entries;
+    bool loaded;
+
+    static std::string key(const std::string& arch, const std::string& kernel, size_t value_bytes)
+    {
+        std::ostringstream k;
+        k << arch << ' ' << kernel << ' ' << value_bytes;
+        return k.str();
+    }
+
+    void load_environment(void)
+    {
+        loaded = true;
+
+        const char * filename = getenv("CUSP_LAUNCH_DATABASE");
+
+        if (filename != NULL && *filename != '\0')
+            load(filename);
+    }
+
+    public:
+    launch_database(void) : loaded(false) {}
+
+    // add the entries of a file, false if it cannot be read
+    bool load(const char * filename)
+    {
+        loaded = true;
+
+        std::ifstream file(filename);
+
+        if (!file)
+        {
+            fprintf(stderr, "cusp: cannot read the launch database %s\n", filename);
+            return false;
+        }
+
+        std::string line;
+
+        while (std::getline(file, line))
+        {
+            if (line.empty() || line[0] == '#')
+                continue;
+
+            std::istringstream fields(line);
+
+            std::string arch, kernel;
+            size_t value_bytes = 0;
+            launch_config config;
+
+            if (fields >> arch >> kernel >> value_bytes >> config.block_size >> config.threads_per_vector >> config.blocks_per_sm)
+                set(arch, kernel, value_bytes, config);
+        }
+
+        return true;
+    }
+
+    void set(const std::string& arch, const std::string& kernel, size_t value_bytes, const launch_config& config)
+    {
+        launch_config c = config;
+
+        if (!is_launch_block_size(c.block_size))
+            c.block_size = 0;
+
+        if (!is_threads_per_vector(c.threads_per_vector))
+            c.threads_per_vector = 0;
+
+        entries[key(arch, kernel, value_bytes)] = c;
+    }
+
+    void clear(void)
+    {
+        entries.clear();
+        loaded = true;
+    }
+
+    // read the file named by CUSP_LAUNCH_DATABASE unless done already
+    void initialize(void)
+    {
+        static cusp::detail::mutex initialize_lock = __CUSP_MUTEX_INITIALIZER;
+        cusp::detail::scoped_lock guard(initialize_lock);
+
+        if (!loaded)
+            load_environment();
+    }
+
+    launch_config lookup(const std::string& arch, const std::string& kernel, size_t value_bytes)
+    {
+        initialize();
+
+        entry_map::const_iterator it = entries.find(key(arch, kernel, value_bytes));
+
+        return it == entries.end() ? launch_config() : it->second;
+    }
+
+    void write(std::ostream& os) const
+    {
+        os << "# arch kernel value_bytes block_size threads_per_vector blocks_per_sm\n";
+
+        for (entry_map::const_iterator it = entries.begin(); it != entries.end(); ++it)
+            os << it->first << ' ' << it->second.block_size << ' '
+               << it->second.threads_per_vector << ' ' << it->second.blocks_per_sm << '\n';
+    }
+};
+
+inline launch_database& current_launch_database(void)
+{
+    static launch_database database;
+    return database;
+}
+
+// configuration of kernel on the current device
+inline launch_config tuned_launch(const std::string& kernel, size_t value_bytes)
+{
+    return current_launch_database().lookup(current_device_description().arch, kernel, value_bytes);
+}
+
+// number of blocks to launch: enough for the work, at most max_blocks
+// (the resident blocks of the device) and the tuned cap per SM
+inline size_t launch_blocks(const launch_config& config, size_t max_blocks, size_t needed_blocks)
+{
+    size_t blocks = std::min(max_blocks, needed_blocks);
+
+    if (config.blocks_per_sm > 0)
+        blocks = std::min<size_t>(blocks, size_t(config.blocks_per_sm) * current_device_description().multiprocessors);
+
+    return std::max<size_t>(blocks, 1);
+}
+
+} // end namespace arch
+} // end namespace device
+} // end namespace detail
+} // end namespace cusp
@@ -0,0 +1,155 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include <cusp/detail/device/stream.h>
+
+#include <cuda_runtime_api.h>
+
+#include <thrust/device_malloc_allocator.h>
+
+#include <new>
+
+// Allocator of the containers in managed_memory.
+//
+// Blocks come from cudaMallocManaged and are visible to the host and to
+// every device, so the pages migrate on demand.  They are not cached:
+// a managed block is only worth reusing on the device it has migrated to,
+// and the containers are expected to live across many kernels anyway.
+// The helpers below move the pages ahead of the kernels (prefetch) and
+// mark arrays which the device only reads (advise) so that every
+// processor keeps a copy instead of faulting them back and forth.
+// Both are hints and their errors are ignored, since devices without
+// concurrent managed access reject them.
+
+namespace cusp
+{
+namespace detail
+{
+namespace device
+{
+
+template <typename T>
+class managed_allocator : public thrust::device_malloc_allocator<T>
+{
+    typedef thrust::device_malloc_allocator<T> Parent;
+
+    public:
+    typedef typename Parent::pointer   pointer;
+    typedef typename Parent::size_type size_type;
+
+    template <typename U>
+    struct rebind { typedef managed_allocator<U> other; };
+
+    managed_allocator(void) {}
+
+    managed_allocator(const managed_allocator&) {}
+
+    template <typename U>
+    managed_allocator(const managed_allocator<U>&) {}
+
+    pointer allocate(size_type n)
+    {
+        if (n == 0)
+            return pointer(static_cast<T*>(NULL));
+
+        void * ptr = NULL;
+
+        if (cudaMallocManaged(&ptr, n * sizeof(T), cudaMemAttachGlobal) != cudaSuccess)
+        {
+            cudaGetLastError();
+            throw std::bad_alloc();
+        }
+
+        return pointer(static_cast<T*>(ptr));
+    }
+
+    void deallocate(pointer p, size_type)
+    {
+        if (p.get() != NULL)
+            cudaFree(p.get());
+    }
+
+    size_type max_size(void) const
+    {
+        return size_type(-1) / sizeof(T);
+    }
+};
+
+template <typename T1, typename T2>
+bool operator==(const managed_allocator<T1>&, const managed_allocator<T2>&)
+{
+    return true;
+}
+
+template <typename T1, typename T2>
+bool operator!=(const managed_allocator<T1>&, const managed_allocator<T2>&)
+{
+    return false;
+}
+
+// migrate [ptr, ptr + bytes) to the current device, or to the host when
+// to_host is set, on the current stream
+inline void managed_prefetch(const void * ptr, size_t bytes, bool to_host)
+{
+#if CUDART_VERSION >= 8000
+    if (ptr == NULL || bytes == 0)
+        return;
+
+#if CUDART_VERSION >= 10000
+    // a graph being captured must not record the hint
+    cudaStreamCaptureStatus status = cudaStreamCaptureStatusNone;
+
+    if (cudaStreamIsCapturing(current_stream(), &status) != cudaSuccess)
+        cudaGetLastError();
+
+    if (status != cudaStreamCaptureStatusNone)
+        return;
+#endif
+
+    int device = cudaCpuDeviceId;
+
+    if (!to_host && cudaGetDevice(&device) != cudaSuccess)
+    {
+        cudaGetLastError();
+        return;
+    }
+
+    if (cudaMemPrefetchAsync(ptr, bytes, device, current_stream()) != cudaSuccess)
+        cudaGetLastError();
+#endif
+}
+
+// keep a read-only copy of [ptr, ptr + bytes) on every processor which
+// reads it, until it is written
+inline void managed_advise_read_mostly(const void * ptr, size_t bytes, bool read_mostly)
+{
+#if CUDART_VERSION >= 8000
+    if (ptr == NULL || bytes == 0)
+        return;
+
+    int device = 0;
+
+    if (cudaGetDevice(&device) != cudaSuccess ||
+        cudaMemAdvise(ptr, bytes, read_mostly ? cudaMemAdviseSetReadMostly : cudaMemAdviseUnsetReadMostly, device) != cudaSuccess)
+        cudaGetLastError();
+#endif
+}
+
+} // end namespace device
+} // end namespace detail
+} // end namespace cusp
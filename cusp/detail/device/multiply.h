@@ -17,17 +17,38 @@
 #pragma once
 
 #include <cusp/format.h>
+#include <cusp/conversion_cache.h>
 #include <cusp/coo_matrix.h>
+#include <cusp/csr_matrix.h>
+#include <cusp/blas.h>
+#include <cusp/reduction.h>
+
+#include <cusp/detail/format_utils.h>
+#include <cusp/detail/offset_type.h>
 
 // SpMV
+#include <cusp/detail/device/spmv/array2d.h>
 #include <cusp/detail/device/spmv/coo_flat.h>
+#include <cusp/detail/device/spmv/csr_merge.h>
 #include <cusp/detail/device/spmv/csr_vector.h>
 #include <cusp/detail/device/spmv/dia.h>
 #include <cusp/detail/device/spmv/ell.h>
 #include <cusp/detail/device/spmv/hyb.h>
+#include <cusp/detail/device/spmv/sell.h>
+#include <cusp/detail/device/spmv/bsr.h>
+#include <cusp/detail/device/spmv/csr16.h>
+#include <cusp/detail/device/spmv/transpose.h>
 
 // SpMM
 #include <cusp/detail/device/spmm/coo.h>
+#include <cusp/detail/device/spmm/csr.h>
+#include <cusp/detail/device/spmm/csr_block.h>
+#include <cusp/detail/device/spmm/dia_block.h>
+#include <cusp/detail/device/spmm/ell_block.h>
+#include <cusp/detail/device/spmm/hyb_block.h>
+#include <cusp/detail/device/spmm/bsr_block.h>
+
+#include <cusp/detail/device/detail/csr.h>
 
 namespace cusp
 {
@@ -39,18 +60,18 @@ namespace device
 //////////////////////////////////
 // Dense Matrix-Vector Multiply //
 //////////////////////////////////
-//// TODO implement this for both row and column-major ordering
-//template <typename Matrix,
-//          typename Vector1,
-//          typename Vector2>
-//void multiply(const Matrix&  A,
-//              const Vector1& B,
-//                    Vector2& C,
-//              cusp::array2d_format,
-//              cusp::array1d_format,
-//              cusp::array1d_format)
-//{
-//}
+template <typename Matrix,
+          typename Vector1,
+          typename Vector2>
+void multiply(const Matrix&  A,
+              const Vector1& B,
+                    Vector2& C,
+              cusp::array2d_format,
+              cusp::array1d_format,
+              cusp::array1d_format)
+{
+    cusp::detail::device::spmv_array2d(A, thrust::raw_pointer_cast(&B[0]), thrust::raw_pointer_cast(&C[0]));
+}
 
 ///////////////////////////////////
 // Sparse Matrix-Vector Multiply //
@@ -65,11 +86,23 @@ void multiply(const Matrix&  A,
               cusp::array1d_format,
               cusp::array1d_format)
 {
-#ifdef CUSP_USE_TEXTURE_MEMORY
+    // the flat kernel addresses the entries with the index type of A, so
+    // more entries than it represents go through 64-bit row offsets to the
+    // CSR kernel, which reads the column indices and values of A in place
+    if (!cusp::detail::offsets_fit<typename Matrix::index_type>(A.num_entries))
+    {
+        cusp::array1d<cusp::detail::wide_offset_type,cusp::device_memory> row_offsets(A.num_rows + 1);
+        cusp::detail::indices_to_offsets(A.row_indices, row_offsets);
+
+        cusp::detail::device::spmv_csr_vector_tex(cusp::make_csr_matrix_view(A.num_rows, A.num_cols, A.num_entries,
+                                                                             cusp::make_array1d_view(row_offsets),
+                                                                             cusp::make_array1d_view(A.column_indices),
+                                                                             cusp::make_array1d_view(A.values)),
+                                                  thrust::raw_pointer_cast(&B[0]), thrust::raw_pointer_cast(&C[0]));
+        return;
+    }
+
     cusp::detail::device::spmv_coo_flat_tex(A, thrust::raw_pointer_cast(&B[0]), thrust::raw_pointer_cast(&C[0]));
-#else
-    cusp::detail::device::spmv_coo_flat(A, thrust::raw_pointer_cast(&B[0]), thrust::raw_pointer_cast(&C[0]));
-#endif
 }
 
 template <typename Matrix,
@@ -82,11 +115,16 @@ void multiply(const Matrix&  A,
               cusp::array1d_format,
               cusp::array1d_format)
 {
-#ifdef CUSP_USE_TEXTURE_MEMORY
+    // irregular row lengths are handled by the load-balanced merge-path
+    // kernel, except in compensated mode which only the vector kernel has
+    if (cusp::current_reduction_mode() != cusp::compensated_reduction &&
+        cusp::detail::device::spmv_csr_merge_is_profitable(A))
+    {
+        cusp::detail::device::spmv_csr_merge_tex(A, thrust::raw_pointer_cast(&B[0]), thrust::raw_pointer_cast(&C[0]));
+        return;
+    }
+
     cusp::detail::device::spmv_csr_vector_tex(A, thrust::raw_pointer_cast(&B[0]), thrust::raw_pointer_cast(&C[0]));
-#else
-    cusp::detail::device::spmv_csr_vector(A, thrust::raw_pointer_cast(&B[0]), thrust::raw_pointer_cast(&C[0]));
-#endif
 }
 
 template <typename Matrix,
@@ -99,11 +137,7 @@ void multiply(const Matrix&  A,
               cusp::array1d_format,
               cusp::array1d_format)
 {
-#ifdef CUSP_USE_TEXTURE_MEMORY
-    cusp::detail::device::spmv_dia_tex(A, thrust::raw_pointer_cast(&B[0]), thrust::raw_pointer_cast(&C[0]));
-#else
-    cusp::detail::device::spmv_dia(A, thrust::raw_pointer_cast(&B[0]), thrust::raw_pointer_cast(&C[0]));
-#endif
+    cusp::detail::device::spmv_dia_tiled(A, thrust::raw_pointer_cast(&B[0]), thrust::raw_pointer_cast(&C[0]));
 }
 
 template <typename Matrix,
@@ -116,11 +150,7 @@ void multiply(const Matrix&  A,
               cusp::array1d_format,
               cusp::array1d_format)
 {
-#ifdef CUSP_USE_TEXTURE_MEMORY
     cusp::detail::device::spmv_ell_tex(A, thrust::raw_pointer_cast(&B[0]), thrust::raw_pointer_cast(&C[0]));
-#else
-    cusp::detail::device::spmv_ell(A, thrust::raw_pointer_cast(&B[0]), thrust::raw_pointer_cast(&C[0]));
-#endif
 }
 
 template <typename Matrix,
@@ -133,17 +163,130 @@ void multiply(const Matrix&  A,
               cusp::array1d_format,
               cusp::array1d_format)
 {
-#ifdef CUSP_USE_TEXTURE_MEMORY
     cusp::detail::device::spmv_hyb_tex(A, thrust::raw_pointer_cast(&B[0]), thrust::raw_pointer_cast(&C[0]));
-#else
-    cusp::detail::device::spmv_hyb(A, thrust::raw_pointer_cast(&B[0]), thrust::raw_pointer_cast(&C[0]));
-#endif
+}
+
+template <typename Matrix,
+         typename Vector1,
+         typename Vector2>
+void multiply(const Matrix&  A,
+              const Vector1& B,
+              Vector2& C,
+              cusp::sell_format,
+              cusp::array1d_format,
+              cusp::array1d_format)
+{
+    cusp::detail::device::spmv_sell_tex(A, thrust::raw_pointer_cast(&B[0]), thrust::raw_pointer_cast(&C[0]));
+}
+
+template <typename Matrix,
+         typename Vector1,
+         typename Vector2>
+void multiply(const Matrix&  A,
+              const Vector1& B,
+              Vector2& C,
+              cusp::bsr_format,
+              cusp::array1d_format,
+              cusp::array1d_format)
+{
+    cusp::detail::device::spmv_bsr_tex(A, thrust::raw_pointer_cast(&B[0]), thrust::raw_pointer_cast(&C[0]));
+}
+
+template <typename Matrix,
+         typename Vector1,
+         typename Vector2>
+void multiply(const Matrix&  A,
+              const Vector1& B,
+              Vector2& C,
+              cusp::csr16_format,
+              cusp::array1d_format,
+              cusp::array1d_format)
+{
+    cusp::detail::device::spmv_csr16_tex(A, thrust::raw_pointer_cast(&B[0]), thrust::raw_pointer_cast(&C[0]));
 }
 
 ////////////////////////////////////////
 // Sparse Matrix-BlockVector Multiply //
 ////////////////////////////////////////
-//// TODO specialize
+template <typename Matrix,
+         typename Vector1,
+         typename Vector2>
+void multiply(const Matrix&  A,
+              const Vector1& B,
+              Vector2& C,
+              cusp::coo_format,
+              cusp::array2d_format,
+              cusp::array2d_format)
+{
+    cusp::detail::device::spmm_coo_block(A, B, C);
+}
+
+template <typename Matrix,
+         typename Vector1,
+         typename Vector2>
+void multiply(const Matrix&  A,
+              const Vector1& B,
+              Vector2& C,
+              cusp::csr_format,
+              cusp::array2d_format,
+              cusp::array2d_format)
+{
+    cusp::detail::device::spmm_csr_block(A, B, C);
+}
+
+template <typename Matrix,
+         typename Vector1,
+         typename Vector2>
+void multiply(const Matrix&  A,
+              const Vector1& B,
+              Vector2& C,
+              cusp::dia_format,
+              cusp::array2d_format,
+              cusp::array2d_format)
+{
+    cusp::detail::device::spmm_dia_block(A, B, C);
+}
+
+template <typename Matrix,
+         typename Vector1,
+         typename Vector2>
+void multiply(const Matrix&  A,
+              const Vector1& B,
+              Vector2& C,
+              cusp::ell_format,
+              cusp::array2d_format,
+              cusp::array2d_format)
+{
+    cusp::detail::device::spmm_ell_block(A, B, C);
+}
+
+template <typename Matrix,
+         typename Vector1,
+         typename Vector2>
+void multiply(const Matrix&  A,
+              const Vector1& B,
+              Vector2& C,
+              cusp::hyb_format,
+              cusp::array2d_format,
+              cusp::array2d_format)
+{
+    cusp::detail::device::spmm_hyb_block(A, B, C);
+}
+
+template <typename Matrix,
+         typename Vector1,
+         typename Vector2>
+void multiply(const Matrix&  A,
+              const Vector1& B,
+              Vector2& C,
+              cusp::bsr_format,
+              cusp::array2d_format,
+              cusp::array2d_format)
+{
+    cusp::detail::device::spmm_bsr_block(A, B, C);
+}
+
+// other formats multiply one column at a time
 template <typename Matrix,
          typename Vector1,
          typename Vector2>
@@ -160,7 +303,28 @@ void multiply(const Matrix&  A,
         cusp::multiply(A, B.column(j), C.column(j));
 }
 
-// Ensure 2D arrays are stored in column-major format
+template <typename Matrix,
+         typename Vector1,
+         typename Vector2,
+         typename Orientation1,
+         typename Orientation2>
+void multiply(const Matrix&  A,
+              const Vector1& B,
+              Vector2& C,
+              cusp::sparse_format,
+              cusp::array2d_format,
+              cusp::array2d_format,
+              Orientation1,
+              Orientation2)
+{
+    // columns are not contiguous, use CSR * dense block
+    cusp::csr_matrix<typename Matrix::index_type,typename Matrix::value_type,cusp::device_memory> A_temp;
+    const cusp::csr_matrix<typename Matrix::index_type,typename Matrix::value_type,cusp::device_memory>& A_ = cusp::detail::cached_conversion(A, A_temp);
+
+    cusp::detail::device::spmm_csr_block(A_, B, C);
+}
+
+// Dispatch on the orientation of the 2D arrays
 template <typename Matrix,
          typename Vector1,
          typename Vector2>
@@ -182,22 +346,119 @@ void multiply(const Matrix&  A,
 ////////////////////////////////////////
 // Dense Matrix-Matrix Multiplication //
 ////////////////////////////////////////
-// TODO implement
-//template <typename Matrix1,
-//          typename Matrix2,
-//          typename Matrix3>
-//void multiply(const Matrix1& A,
-//              const Matrix2& B,
-//                    Matrix3& C,
-//              cusp::array2d_format,
-//              cusp::array2d_format,
-//              cusp::array2d_format)
-//{
-//}
+template <typename Matrix1,
+          typename Matrix2,
+          typename Matrix3>
+void multiply(const Matrix1& A,
+              const Matrix2& B,
+                    Matrix3& C,
+              cusp::array2d_format,
+              cusp::array2d_format,
+              cusp::array2d_format)
+{
+    C.resize(A.num_rows, B.num_cols);
+
+    cusp::blas::gemm(A, B, C);
+}
 
 /////////////////////////////////////////
 // Sparse Matrix-Matrix Multiplication //
 /////////////////////////////////////////
+
+// The row-wise kernels in spmm/csr.h rely on atomics which only exist for
+// int and unsigned int indices and float and double values.  Products of
+// other types are formed by expansion of COO matrices as in spmm_coo.
+template <typename Matrix1,
+         typename Matrix2,
+         typename Matrix3>
+void spmm_csr(const Matrix1& A,
+              const Matrix2& B,
+              Matrix3& C,
+              thrust::detail::true_type)
+{
+    cusp::detail::device::spmm_csr(A,B,C);
+}
+
+template <typename Matrix1,
+         typename Matrix2,
+         typename Matrix3>
+void spmm_csr(const Matrix1& A,
+              const Matrix2& B,
+              Matrix3& C,
+              thrust::detail::false_type)
+{
+    cusp::coo_matrix<typename Matrix1::index_type,typename Matrix1::value_type,cusp::device_memory> A_(A);
+    cusp::coo_matrix<typename Matrix2::index_type,typename Matrix2::value_type,cusp::device_memory> B_(B);
+    cusp::coo_matrix<typename Matrix3::index_type,typename Matrix3::value_type,cusp::device_memory> C_;
+
+    cusp::detail::device::spmm_coo_expand(A_,B_,C_);
+
+    cusp::convert(C_, C);
+}
+
+template <typename Matrix1,
+          typename Matrix2,
+          typename Matrix3,
+          typename Matrix4>
+void spmm_coo_rap(const Matrix1& R,
+                  const Matrix2& A,
+                  const Matrix3& P,
+                        Matrix4& RAP,
+                  thrust::detail::true_type)
+{
+    cusp::detail::device::spmm_coo_rap(R,A,P,RAP);
+}
+
+template <typename Matrix1,
+          typename Matrix2,
+          typename Matrix3,
+          typename Matrix4>
+void spmm_coo_rap(const Matrix1& R,
+                  const Matrix2& A,
+                  const Matrix3& P,
+                        Matrix4& RAP,
+                  thrust::detail::false_type)
+{
+    // RAP = R * (A * P)
+    cusp::coo_matrix<typename Matrix4::index_type,typename Matrix4::value_type,cusp::device_memory> AP;
+
+    cusp::detail::device::spmm_coo_expand(A,P,AP);
+    cusp::detail::device::spmm_coo_expand(R,AP,RAP);
+}
+
+template <typename Matrix1,
+          typename Matrix2,
+          typename Matrix3,
+          typename Matrix4>
+void spmm_csr_rap(const Matrix1& R,
+                  const Matrix2& A,
+                  const Matrix3& P,
+                        Matrix4& RAP,
+                  thrust::detail::true_type)
+{
+    cusp::detail::device::spmm_csr_rap(R,A,P,RAP);
+}
+
+template <typename Matrix1,
+          typename Matrix2,
+          typename Matrix3,
+          typename Matrix4>
+void spmm_csr_rap(const Matrix1& R,
+                  const Matrix2& A,
+                  const Matrix3& P,
+                        Matrix4& RAP,
+                  thrust::detail::false_type)
+{
+    cusp::coo_matrix<typename Matrix1::index_type,typename Matrix1::value_type,cusp::device_memory> R_(R);
+    cusp::coo_matrix<typename Matrix2::index_type,typename Matrix2::value_type,cusp::device_memory> A_(A);
+    cusp::coo_matrix<typename Matrix3::index_type,typename Matrix3::value_type,cusp::device_memory> P_(P);
+    cusp::coo_matrix<typename Matrix4::index_type,typename Matrix4::value_type,cusp::device_memory> RAP_;
+
+    spmm_coo_rap(R_,A_,P_,RAP_, thrust::detail::false_type());
+
+    cusp::convert(RAP_, RAP);
+}
+
 template <typename Matrix1,
          typename Matrix2,
          typename Matrix3>
@@ -211,6 +472,20 @@ void multiply(const Matrix1& A,
     cusp::detail::device::spmm_coo(A,B,C);
 }
 
+template <typename Matrix1,
+         typename Matrix2,
+         typename Matrix3>
+void multiply(const Matrix1& A,
+              const Matrix2& B,
+              Matrix3& C,
+              cusp::csr_format,
+              cusp::csr_format,
+              cusp::csr_format)
+{
+    cusp::detail::device::spmm_csr(A,B,C,
+        spmm_csr_is_supported<typename Matrix3::index_type,typename Matrix3::value_type>());
+}
+
 template <typename Matrix1,
          typename Matrix2,
          typename Matrix3>
@@ -221,16 +496,192 @@ void multiply(const Matrix1& A,
               cusp::sparse_format,
               cusp::sparse_format)
 {
-    // other formats use COO * COO
-    cusp::coo_matrix<typename Matrix1::index_type,typename Matrix1::value_type,cusp::device_memory> A_(A);
-    cusp::coo_matrix<typename Matrix2::index_type,typename Matrix2::value_type,cusp::device_memory> B_(B);
-    cusp::coo_matrix<typename Matrix3::index_type,typename Matrix3::value_type,cusp::device_memory> C_;
+    // other formats use CSR * CSR
+    cusp::csr_matrix<typename Matrix1::index_type,typename Matrix1::value_type,cusp::device_memory> A_temp;
+    const cusp::csr_matrix<typename Matrix1::index_type,typename Matrix1::value_type,cusp::device_memory>& A_ = cusp::detail::cached_conversion(A, A_temp);
+    cusp::csr_matrix<typename Matrix2::index_type,typename Matrix2::value_type,cusp::device_memory> B_temp;
+    const cusp::csr_matrix<typename Matrix2::index_type,typename Matrix2::value_type,cusp::device_memory>& B_ = cusp::detail::cached_conversion(B, B_temp);
+    cusp::csr_matrix<typename Matrix3::index_type,typename Matrix3::value_type,cusp::device_memory> C_;
 
-    cusp::detail::device::spmm_coo(A_,B_,C_);
+    cusp::detail::device::spmm_csr(A_,B_,C_,
+        spmm_csr_is_supported<typename Matrix3::index_type,typename Matrix3::value_type>());
 
     cusp::convert(C_, C);
 }
 
+//////////////////////
+// Galerkin Product //
+//////////////////////
+template <typename Matrix1,
+          typename Matrix2,
+          typename Matrix3,
+          typename Matrix4>
+void galerkin_product(const Matrix1& R,
+                      const Matrix2& A,
+                      const Matrix3& P,
+                            Matrix4& RAP,
+                      cusp::coo_format,
+                      cusp::coo_format,
+                      cusp::coo_format,
+                      cusp::coo_format)
+{
+    cusp::detail::device::spmm_coo_rap(R,A,P,RAP,
+        spmm_csr_is_supported<typename Matrix4::index_type,typename Matrix4::value_type>());
+}
+
+template <typename Matrix1,
+          typename Matrix2,
+          typename Matrix3,
+          typename Matrix4>
+void galerkin_product(const Matrix1& R,
+                      const Matrix2& A,
+                      const Matrix3& P,
+                            Matrix4& RAP,
+                      cusp::csr_format,
+                      cusp::csr_format,
+                      cusp::csr_format,
+                      cusp::csr_format)
+{
+    cusp::detail::device::spmm_csr_rap(R,A,P,RAP,
+        spmm_csr_is_supported<typename Matrix4::index_type,typename Matrix4::value_type>());
+}
+
+template <typename Matrix1,
+          typename Matrix2,
+          typename Matrix3,
+          typename Matrix4>
+void galerkin_product(const Matrix1& R,
+                      const Matrix2& A,
+                      const Matrix3& P,
+                            Matrix4& RAP,
+                      cusp::sparse_format,
+                      cusp::sparse_format,
+                      cusp::sparse_format,
+                      cusp::sparse_format)
+{
+    // other formats use CSR * CSR * CSR
+    cusp::csr_matrix<typename Matrix1::index_type,typename Matrix1::value_type,cusp::device_memory> R_temp;
+    const cusp::csr_matrix<typename Matrix1::index_type,typename Matrix1::value_type,cusp::device_memory>& R_ = cusp::detail::cached_conversion(R, R_temp);
+    cusp::csr_matrix<typename Matrix2::index_type,typename Matrix2::value_type,cusp::device_memory> A_temp;
+    const cusp::csr_matrix<typename Matrix2::index_type,typename Matrix2::value_type,cusp::device_memory>& A_ = cusp::detail::cached_conversion(A, A_temp);
+    cusp::csr_matrix<typename Matrix3::index_type,typename Matrix3::value_type,cusp::device_memory> P_temp;
+    const cusp::csr_matrix<typename Matrix3::index_type,typename Matrix3::value_type,cusp::device_memory>& P_ = cusp::detail::cached_conversion(P, P_temp);
+    cusp::csr_matrix<typename Matrix4::index_type,typename Matrix4::value_type,cusp::device_memory> RAP_;
+
+    cusp::detail::device::spmm_csr_rap(R_,A_,P_,RAP_,
+        spmm_csr_is_supported<typename Matrix4::index_type,typename Matrix4::value_type>());
+
+    cusp::convert(RAP_, RAP);
+}
+
+template <typename Matrix1,
+          typename Matrix2,
+          typename Matrix3,
+          typename Matrix4>
+void galerkin_product(const Matrix1& R,
+                      const Matrix2& A,
+                      const Matrix3& P,
+                            Matrix4& RAP)
+{
+    cusp::detail::device::galerkin_product(R, A, P, RAP,
+                                           typename Matrix1::format(),
+                                           typename Matrix2::format(),
+                                           typename Matrix3::format(),
+                                           typename Matrix4::format());
+}
+
+//////////////////////////////////////////////
+// Transposed Sparse Matrix-Vector Multiply //
+//////////////////////////////////////////////
+template <typename Orientation> struct transposed_orientation {};
+template <> struct transposed_orientation<cusp::row_major>    { typedef cusp::column_major type; };
+template <> struct transposed_orientation<cusp::column_major> { typedef cusp::row_major    type; };
+
+template <typename Matrix,
+          typename Vector1,
+          typename Vector2>
+void multiply_transpose(const Matrix&  A,
+                        const Vector1& x,
+                              Vector2& y,
+                        cusp::array2d_format)
+{
+    // the storage of A read in the other orientation is A^T
+    typedef typename transposed_orientation<typename Matrix::orientation>::type Orientation;
+
+    cusp::detail::device::spmv_array2d(cusp::make_array2d_view(A.num_cols, A.num_rows, A.pitch, cusp::make_array1d_view(A.values), Orientation()),
+                                       thrust::raw_pointer_cast(&x[0]), thrust::raw_pointer_cast(&y[0]));
+}
+
+template <typename Matrix,
+          typename Vector1,
+          typename Vector2>
+void multiply_transpose(const Matrix&  A,
+                        const Vector1& x,
+                              Vector2& y,
+                        cusp::coo_format)
+{
+    cusp::detail::device::spmv_coo_transpose(A, thrust::raw_pointer_cast(&x[0]), thrust::raw_pointer_cast(&y[0]));
+}
+
+template <typename Matrix,
+          typename Vector1,
+          typename Vector2>
+void multiply_transpose(const Matrix&  A,
+                        const Vector1& x,
+                              Vector2& y,
+                        cusp::csr_format)
+{
+    cusp::detail::device::spmv_csr_transpose(A, thrust::raw_pointer_cast(&x[0]), thrust::raw_pointer_cast(&y[0]));
+}
+
+template <typename Matrix,
+          typename Vector1,
+          typename Vector2>
+void multiply_transpose(const Matrix&  A,
+                        const Vector1& x,
+                              Vector2& y,
+                        cusp::dia_format)
+{
+    cusp::detail::device::spmv_dia_transpose(A, thrust::raw_pointer_cast(&x[0]), thrust::raw_pointer_cast(&y[0]));
+}
+
+template <typename Matrix,
+          typename Vector1,
+          typename Vector2>
+void multiply_transpose(const Matrix&  A,
+                        const Vector1& x,
+                              Vector2& y,
+                        cusp::ell_format)
+{
+    cusp::detail::device::spmv_ell_transpose(A, thrust::raw_pointer_cast(&x[0]), thrust::raw_pointer_cast(&y[0]));
+}
+
+template <typename Matrix,
+          typename Vector1,
+          typename Vector2>
+void multiply_transpose(const Matrix&  A,
+                        const Vector1& x,
+                              Vector2& y,
+                        cusp::hyb_format)
+{
+    cusp::detail::device::spmv_hyb_transpose(A, thrust::raw_pointer_cast(&x[0]), thrust::raw_pointer_cast(&y[0]));
+}
+
+template <typename Matrix,
+          typename Vector1,
+          typename Vector2>
+void multiply_transpose(const Matrix&  A,
+                        const Vector1& x,
+                              Vector2& y,
+                        cusp::sparse_format)
+{
+    // other formats use COO
+    cusp::coo_matrix<typename Matrix::index_type,typename Matrix::value_type,cusp::device_memory> A_temp;
+    const cusp::coo_matrix<typename Matrix::index_type,typename Matrix::value_type,cusp::device_memory>& A_ = cusp::detail::cached_conversion(A, A_temp);
+
+    cusp::detail::device::spmv_coo_transpose(A_, thrust::raw_pointer_cast(&x[0]), thrust::raw_pointer_cast(&y[0]));
+}
+
 /////////////////
 // Entry Point //
 /////////////////
@@ -247,6 +698,80 @@ void multiply(const Matrix&  A,
                                    typename MatrixOrVector2::format());
 }
 
+template <typename Matrix,
+          typename Vector1,
+          typename Vector2>
+void multiply_transpose(const Matrix&  A,
+                        const Vector1& x,
+                              Vector2& y)
+{
+    cusp::detail::device::multiply_transpose(A, x, y,
+                                             typename Matrix::format());
+}
+
+
+///////////////////////////
+// Masked Sparse Product //
+///////////////////////////
+template <typename Matrix1,
+          typename Matrix2,
+          typename Matrix3,
+          typename Matrix4>
+void masked_product(const Matrix1& A,
+                    const Matrix2& B,
+                    const Matrix3& M,
+                          Matrix4& C,
+                    cusp::csr_format,
+                    cusp::csr_format,
+                    cusp::csr_format,
+                    cusp::csr_format)
+{
+    cusp::detail::device::detail::masked_spmm_csr(A, B, M, C);
+}
+
+template <typename Matrix1,
+          typename Matrix2,
+          typename Matrix3,
+          typename Matrix4>
+void masked_product(const Matrix1& A,
+                    const Matrix2& B,
+                    const Matrix3& M,
+                          Matrix4& C,
+                    cusp::sparse_format,
+                    cusp::sparse_format,
+                    cusp::sparse_format,
+                    cusp::sparse_format)
+{
+    // other formats use CSR, whose columns are sorted by the conversion
+    cusp::csr_matrix<typename Matrix1::index_type,typename Matrix1::value_type,cusp::device_memory> A_temp;
+    const cusp::csr_matrix<typename Matrix1::index_type,typename Matrix1::value_type,cusp::device_memory>& A_ = cusp::detail::cached_conversion(A, A_temp);
+    cusp::csr_matrix<typename Matrix2::index_type,typename Matrix2::value_type,cusp::device_memory> B_temp;
+    const cusp::csr_matrix<typename Matrix2::index_type,typename Matrix2::value_type,cusp::device_memory>& B_ = cusp::detail::cached_conversion(B, B_temp);
+    cusp::csr_matrix<typename Matrix3::index_type,typename Matrix3::value_type,cusp::device_memory> M_temp;
+    const cusp::csr_matrix<typename Matrix3::index_type,typename Matrix3::value_type,cusp::device_memory>& M_ = cusp::detail::cached_conversion(M, M_temp);
+    cusp::csr_matrix<typename Matrix4::index_type,typename Matrix4::value_type,cusp::device_memory> C_;
+
+    cusp::detail::device::detail::masked_spmm_csr(A_, B_, M_, C_);
+
+    cusp::convert(C_, C);
+}
+
+template <typename Matrix1,
+          typename Matrix2,
+          typename Matrix3,
+          typename Matrix4>
+void masked_product(const Matrix1& A,
+                    const Matrix2& B,
+                    const Matrix3& M,
+                          Matrix4& C)
+{
+    cusp::detail::device::masked_product(A, B, M, C,
+                                      typename Matrix1::format(),
+                                      typename Matrix2::format(),
+                                      typename Matrix3::format(),
+                                      typename Matrix4::format());
+}
+
 } // end namespace device
 } // end namespace detail
 } // end namespace cusp
@@ -0,0 +1,435 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include <cusp/array1d.h>
+#include <cusp/format.h>
+#include <cusp/ell_matrix.h>
+
+#include <cusp/detail/functional.h>
+#include <cusp/detail/stream.h>
+#include <cusp/detail/device/arch.h>
+#include <cusp/detail/device/blas.h>
+#include <cusp/detail/device/common.h>
+#include <cusp/detail/device/stream.h>
+#include <cusp/detail/device/utils.h>
+#include <cusp/detail/device/spmv/coo_flat.h>
+
+#include <thrust/functional.h>
+#include <thrust/iterator/permutation_iterator.h>
+#include <thrust/iterator/zip_iterator.h>
+
+#include <algorithm>
+
+// SpMV kernels y = A * x fused with the dot product conj(y)^T x, as needed
+// by the step length of CG.  Each row writes y[i] and adds conj(y[i]) * x[i]
+// to a sum kept by its thread, each block reduces the sums of its threads
+// into one partial sum, and mdot_reduce_kernel (cusp/detail/device/blas.h)
+// adds the partial sums of the blocks.  y and x are thus read once less
+// than by a product followed by blas::dotc.
+//
+// spmv_dot_csr_vector_kernel
+//   Each row is assigned to a vector of THREADS_PER_VECTOR threads, as in
+//   spmv_csr_vector_kernel.
+//
+// spmv_dot_ell_kernel, spmv_dot_dia_kernel
+//   Each row is assigned to a thread.
+//
+// The HYB format runs the ELL kernel and then adds its COO part to y, whose
+// contribution conj(A(i,j) * x[j]) * x[i] to the dot product is summed over
+// the entries of the COO part, which is usually small.
+
+namespace cusp
+{
+namespace detail
+{
+namespace device
+{
+
+// sum of value over the threads of the block, valid in thread 0
+template <unsigned int BLOCK_SIZE, typename ValueType>
+__device__ ValueType block_sum(ValueType * sdata, const ValueType value)
+{
+    sdata[threadIdx.x] = value;
+    __syncthreads();
+
+    for(unsigned int offset = BLOCK_SIZE / 2; offset > 0; offset /= 2)
+    {
+        if (threadIdx.x < offset)
+            sdata[threadIdx.x] = sdata[threadIdx.x] + sdata[threadIdx.x + offset];
+        __syncthreads();
+    }
+
+    return sdata[0];
+}
+
+template <typename IndexType, typename ValueType, typename MatrixValueType, unsigned int VECTORS_PER_BLOCK, unsigned int THREADS_PER_VECTOR>
+__launch_bounds__(VECTORS_PER_BLOCK * THREADS_PER_VECTOR,1)
+__global__ void
+spmv_dot_csr_vector_kernel(const IndexType num_rows,
+                           const IndexType * Ap,
+                           const IndexType * Aj,
+                           const MatrixValueType * Ax,
+                           const ValueType * x,
+                                 ValueType * y,
+                                 ValueType * partial)
+{
+    const unsigned int THREADS_PER_BLOCK = VECTORS_PER_BLOCK * THREADS_PER_VECTOR;
+
+    __shared__ ValueType sdata[THREADS_PER_BLOCK];
+#ifndef __CUSP_HAS_WARP_SHUFFLE__
+    __shared__ volatile ValueType sums[THREADS_PER_BLOCK + THREADS_PER_VECTOR / 2];  // padded to avoid reduction conditionals
+#endif
+
+    const cusp::detail::conjugate_if<true> conj;
+
+    const IndexType thread_id   = THREADS_PER_BLOCK * blockIdx.x + threadIdx.x;    // global thread index
+    const IndexType thread_lane = threadIdx.x & (THREADS_PER_VECTOR - 1);          // thread index within the vector
+    const IndexType vector_id   = thread_id   /  THREADS_PER_VECTOR;               // global vector index
+    const IndexType num_vectors = VECTORS_PER_BLOCK * gridDim.x;                   // total number of active vectors
+
+#ifdef __CUSP_HAS_WARP_SHUFFLE__
+    const unsigned int mask = arch::lane_mask<THREADS_PER_VECTOR>(threadIdx.x);
+#endif
+
+    ValueType dot = ValueType(0);
+
+    for(IndexType row = vector_id; row < num_rows; row += num_vectors)
+    {
+        const IndexType row_start = Ap[row];
+        const IndexType row_end   = Ap[row + 1];
+
+        ValueType sum = ValueType(0);
+
+        for(IndexType jj = row_start + thread_lane; jj < row_end; jj += THREADS_PER_VECTOR)
+            sum = sum + ValueType(Ax[jj]) * x[Aj[jj]];
+
+        // reduce local sums to row sum
+#ifdef __CUSP_HAS_WARP_SHUFFLE__
+        sum = arch::reduce_lanes<THREADS_PER_VECTOR>(mask, sum);
+#else
+        sums[threadIdx.x] = sum;
+
+        if (THREADS_PER_VECTOR > 16) sums[threadIdx.x] = sum = sum + sums[threadIdx.x + 16];
+        if (THREADS_PER_VECTOR >  8) sums[threadIdx.x] = sum = sum + sums[threadIdx.x +  8];
+        if (THREADS_PER_VECTOR >  4) sums[threadIdx.x] = sum = sum + sums[threadIdx.x +  4];
+        if (THREADS_PER_VECTOR >  2) sums[threadIdx.x] = sum = sum + sums[threadIdx.x +  2];
+        if (THREADS_PER_VECTOR >  1) sums[threadIdx.x] = sum = sum + sums[threadIdx.x +  1];
+
+        sum = sums[threadIdx.x];
+#endif
+
+        // first thread writes the result and adds it to the dot product
+        if (thread_lane == 0)
+        {
+            y[row] = sum;
+            dot = dot + conj(sum) * x[row];
+        }
+    }
+
+    dot = block_sum<THREADS_PER_BLOCK>(sdata, dot);
+
+    if (threadIdx.x == 0)
+        partial[blockIdx.x] = dot;
+}
+
+template <typename IndexType, typename ValueType, typename MatrixValueType, unsigned int BLOCK_SIZE>
+__launch_bounds__(BLOCK_SIZE,1)
+__global__ void
+spmv_dot_ell_kernel(const IndexType num_rows,
+                    const IndexType num_cols_per_row,
+                    const IndexType pitch,
+                    const IndexType * Aj,
+                    const MatrixValueType * Ax,
+                    const ValueType * x,
+                          ValueType * y,
+                          ValueType * partial)
+{
+    __shared__ ValueType sdata[BLOCK_SIZE];
+
+    const IndexType invalid_index = cusp::ell_matrix<IndexType, MatrixValueType, cusp::device_memory>::invalid_index;
+
+    const cusp::detail::conjugate_if<true> conj;
+
+    const IndexType grid_size = BLOCK_SIZE * gridDim.x;
+
+    ValueType dot = ValueType(0);
+
+    for(IndexType row = BLOCK_SIZE * blockIdx.x + threadIdx.x; row < num_rows; row += grid_size)
+    {
+        ValueType sum = ValueType(0);
+
+        IndexType offset = row;
+
+        for(IndexType n = 0; n < num_cols_per_row; n++)
+        {
+            const IndexType col = Aj[offset];
+
+            if (col != invalid_index)
+                sum = sum + ValueType(Ax[offset]) * x[col];
+
+            offset += pitch;
+        }
+
+        y[row] = sum;
+        dot = dot + conj(sum) * x[row];
+    }
+
+    dot = block_sum<BLOCK_SIZE>(sdata, dot);
+
+    if (threadIdx.x == 0)
+        partial[blockIdx.x] = dot;
+}
+
+template <typename IndexType, typename ValueType, typename MatrixValueType, unsigned int BLOCK_SIZE>
+__launch_bounds__(BLOCK_SIZE,1)
+__global__ void
+spmv_dot_dia_kernel(const IndexType num_rows,
+                    const IndexType num_cols,
+                    const IndexType num_diagonals,
+                    const IndexType pitch,
+                    const IndexType * diagonal_offsets,
+                    const MatrixValueType * values,
+                    const ValueType * x,
+                          ValueType * y,
+                          ValueType * partial)
+{
+    __shared__ ValueType sdata[BLOCK_SIZE];
+
+    const cusp::detail::conjugate_if<true> conj;
+
+    const IndexType grid_size = BLOCK_SIZE * gridDim.x;
+
+    ValueType dot = ValueType(0);
+
+    for(IndexType row = BLOCK_SIZE * blockIdx.x + threadIdx.x; row < num_rows; row += grid_size)
+    {
+        ValueType sum = ValueType(0);
+
+        // index into values array
+        IndexType idx = row;
+
+        for(IndexType n = 0; n < num_diagonals; n++)
+        {
+            const IndexType col = row + diagonal_offsets[n];
+
+            if (col >= 0 && col < num_cols)
+                sum = sum + ValueType(values[idx]) * x[col];
+
+            idx += pitch;
+        }
+
+        y[row] = sum;
+        dot = dot + conj(sum) * x[row];
+    }
+
+    dot = block_sum<BLOCK_SIZE>(sdata, dot);
+
+    if (threadIdx.x == 0)
+        partial[blockIdx.x] = dot;
+}
+
+// conj(A(i,j) * x[j]) * x[i] for an entry (i, j, A(i,j)) of a COO matrix
+template <typename ValueType>
+struct coo_entry_dot
+{
+    const ValueType * x;
+
+    coo_entry_dot(const ValueType * x)
+        : x(x) {}
+
+    template <typename Tuple>
+    __host__ __device__
+    ValueType operator()(const Tuple& t) const
+    {
+        const ValueType A_ij_x_j = ValueType(thrust::get<2>(t)) * x[thrust::get<1>(t)];
+        return cusp::detail::conjugate_if<true>()(A_ij_x_j) * x[thrust::get<0>(t)];
+    }
+};
+
+// sum of the num_partials partial sums, copied to the host
+template <typename ValueType>
+ValueType sum_partials(cusp::array1d<ValueType,cusp::device_memory>& partial, const size_t num_partials)
+{
+    const size_t BLOCK_SIZE = 256;
+
+    ValueType * partial_ptr = thrust::raw_pointer_cast(&partial[0]);
+
+    // the last entry receives the sum
+    mdot_reduce_kernel<ValueType, BLOCK_SIZE> <<<1, BLOCK_SIZE, 0, cusp::detail::device::current_stream()>>>
+        (int(num_partials), 1, partial_ptr, partial_ptr + num_partials);
+
+    ValueType result;
+
+    cudaMemcpyAsync(&result, partial_ptr + num_partials, sizeof(ValueType),
+                    cudaMemcpyDeviceToHost, cusp::detail::device::current_stream());
+    cudaStreamSynchronize(cusp::detail::device::current_stream());
+
+    return result;
+}
+
+template <unsigned int THREADS_PER_VECTOR, typename Matrix, typename ValueType>
+ValueType __spmv_dot_csr_vector(const Matrix& A, const ValueType * x, ValueType * y)
+{
+    typedef typename Matrix::index_type IndexType;
+    typedef typename Matrix::value_type MatrixValueType;
+
+    const size_t THREADS_PER_BLOCK = 256;
+    const size_t VECTORS_PER_BLOCK = THREADS_PER_BLOCK / THREADS_PER_VECTOR;
+
+    const size_t MAX_BLOCKS = cusp::detail::device::arch::max_active_blocks(spmv_dot_csr_vector_kernel<IndexType, ValueType, MatrixValueType, VECTORS_PER_BLOCK, THREADS_PER_VECTOR>, THREADS_PER_BLOCK, (size_t) 0);
+    const size_t NUM_BLOCKS = std::min<size_t>(MAX_BLOCKS, DIVIDE_INTO(A.num_rows, VECTORS_PER_BLOCK));
+
+    cusp::array1d<ValueType,cusp::device_memory> partial(NUM_BLOCKS + 1);
+
+    spmv_dot_csr_vector_kernel<IndexType, ValueType, MatrixValueType, VECTORS_PER_BLOCK, THREADS_PER_VECTOR> <<<NUM_BLOCKS, THREADS_PER_BLOCK, 0, cusp::detail::device::current_stream()>>>
+        (IndexType(A.num_rows),
+         thrust::raw_pointer_cast(&A.row_offsets[0]),
+         A.num_entries == 0 ? (const IndexType *) NULL : thrust::raw_pointer_cast(&A.column_indices[0]),
+         A.num_entries == 0 ? (const MatrixValueType *) NULL : thrust::raw_pointer_cast(&A.values[0]),
+         x, y, thrust::raw_pointer_cast(&partial[0]));
+
+    return sum_partials(partial, NUM_BLOCKS);
+}
+
+template <typename Matrix, typename ValueType>
+ValueType spmv_dot_csr(const Matrix& A, const ValueType * x, ValueType * y)
+{
+    typedef typename Matrix::index_type IndexType;
+
+    // threads per row from the average row length, as in spmv_csr_vector
+    const IndexType nnz_per_row = A.num_entries / A.num_rows;
+
+    if      (nnz_per_row <=  2) return __spmv_dot_csr_vector< 2>(A, x, y);
+    else if (nnz_per_row <=  4) return __spmv_dot_csr_vector< 4>(A, x, y);
+    else if (nnz_per_row <=  8) return __spmv_dot_csr_vector< 8>(A, x, y);
+    else if (nnz_per_row <= 16) return __spmv_dot_csr_vector<16>(A, x, y);
+    else                        return __spmv_dot_csr_vector<32>(A, x, y);
+}
+
+template <typename Matrix, typename ValueType>
+ValueType spmv_dot_ell(const Matrix& A, const ValueType * x, ValueType * y)
+{
+    typedef typename Matrix::index_type IndexType;
+    typedef typename Matrix::value_type MatrixValueType;
+
+    const size_t BLOCK_SIZE = 256;
+    const size_t MAX_BLOCKS = cusp::detail::device::arch::max_active_blocks(spmv_dot_ell_kernel<IndexType, ValueType, MatrixValueType, BLOCK_SIZE>, BLOCK_SIZE, (size_t) 0);
+    const size_t NUM_BLOCKS = std::min<size_t>(MAX_BLOCKS, DIVIDE_INTO(A.num_rows, BLOCK_SIZE));
+
+    // TODO generalize this
+    assert(A.column_indices.pitch == A.values.pitch);
+
+    cusp::array1d<ValueType,cusp::device_memory> partial(NUM_BLOCKS + 1);
+
+    spmv_dot_ell_kernel<IndexType, ValueType, MatrixValueType, BLOCK_SIZE> <<<NUM_BLOCKS, BLOCK_SIZE, 0, cusp::detail::device::current_stream()>>>
+        (IndexType(A.num_rows),
+         IndexType(A.column_indices.num_cols), IndexType(A.column_indices.pitch),
+         A.column_indices.num_cols == 0 ? (const IndexType *) NULL : thrust::raw_pointer_cast(&A.column_indices.values[0]),
+         A.column_indices.num_cols == 0 ? (const MatrixValueType *) NULL : thrust::raw_pointer_cast(&A.values.values[0]),
+         x, y, thrust::raw_pointer_cast(&partial[0]));
+
+    return sum_partials(partial, NUM_BLOCKS);
+}
+
+template <typename Matrix, typename ValueType>
+ValueType spmv_dot_dia(const Matrix& A, const ValueType * x, ValueType * y)
+{
+    typedef typename Matrix::index_type IndexType;
+    typedef typename Matrix::value_type MatrixValueType;
+
+    const size_t BLOCK_SIZE = 256;
+    const size_t MAX_BLOCKS = cusp::detail::device::arch::max_active_blocks(spmv_dot_dia_kernel<IndexType, ValueType, MatrixValueType, BLOCK_SIZE>, BLOCK_SIZE, (size_t) 0);
+    const size_t NUM_BLOCKS = std::min<size_t>(MAX_BLOCKS, DIVIDE_INTO(A.num_rows, BLOCK_SIZE));
+
+    const IndexType num_diagonals = A.values.num_cols;
+
+    cusp::array1d<ValueType,cusp::device_memory> partial(NUM_BLOCKS + 1);
+
+    spmv_dot_dia_kernel<IndexType, ValueType, MatrixValueType, BLOCK_SIZE> <<<NUM_BLOCKS, BLOCK_SIZE, 0, cusp::detail::device::current_stream()>>>
+        (IndexType(A.num_rows), IndexType(A.num_cols),
+         num_diagonals, IndexType(A.values.pitch),
+         num_diagonals == 0 ? (const IndexType *) NULL : thrust::raw_pointer_cast(&A.diagonal_offsets[0]),
+         num_diagonals == 0 ? (const MatrixValueType *) NULL : thrust::raw_pointer_cast(&A.values.values[0]),
+         x, y, thrust::raw_pointer_cast(&partial[0]));
+
+    return sum_partials(partial, NUM_BLOCKS);
+}
+
+template <typename Matrix, typename ValueType>
+ValueType spmv_dot_hyb(const Matrix& A, const ValueType * x, ValueType * y)
+{
+    ValueType dot = spmv_dot_ell(A.ell, x, y);
+
+    if (A.coo.num_entries == 0)
+        return dot;
+
+    // y <- y + A.coo * x
+    __spmv_coo_flat<false, false>(A.coo, x, y);
+
+    return dot + cusp::detail::stream::transform_reduce
+        (thrust::make_zip_iterator(thrust::make_tuple(A.coo.row_indices.begin(), A.coo.column_indices.begin(), A.coo.values.begin())),
+         thrust::make_zip_iterator(thrust::make_tuple(A.coo.row_indices.end(),   A.coo.column_indices.end(),   A.coo.values.end())),
+         coo_entry_dot<ValueType>(x),
+         ValueType(0),
+         thrust::plus<ValueType>());
+}
+
+template <typename Matrix, typename Vector1, typename Vector2>
+typename Vector2::value_type
+multiply_dot(const Matrix& A, const Vector1& x, Vector2& y, cusp::csr_format)
+{
+    return spmv_dot_csr(A, thrust::raw_pointer_cast(&x[0]), thrust::raw_pointer_cast(&y[0]));
+}
+
+template <typename Matrix, typename Vector1, typename Vector2>
+typename Vector2::value_type
+multiply_dot(const Matrix& A, const Vector1& x, Vector2& y, cusp::ell_format)
+{
+    return spmv_dot_ell(A, thrust::raw_pointer_cast(&x[0]), thrust::raw_pointer_cast(&y[0]));
+}
+
+template <typename Matrix, typename Vector1, typename Vector2>
+typename Vector2::value_type
+multiply_dot(const Matrix& A, const Vector1& x, Vector2& y, cusp::dia_format)
+{
+    return spmv_dot_dia(A, thrust::raw_pointer_cast(&x[0]), thrust::raw_pointer_cast(&y[0]));
+}
+
+template <typename Matrix, typename Vector1, typename Vector2>
+typename Vector2::value_type
+multiply_dot(const Matrix& A, const Vector1& x, Vector2& y, cusp::hyb_format)
+{
+    return spmv_dot_hyb(A, thrust::raw_pointer_cast(&x[0]), thrust::raw_pointer_cast(&y[0]));
+}
+
+// y <- A * x and returns conj(y)^T x for the CSR, ELL, DIA and HYB formats
+template <typename Matrix, typename Vector1, typename Vector2>
+typename Vector2::value_type
+multiply_dot(const Matrix& A, const Vector1& x, Vector2& y)
+{
+    typedef typename Vector2::value_type ValueType;
+
+    if (A.num_rows == 0)
+        return ValueType(0);
+
+    return multiply_dot(A, x, y, typename Matrix::format());
+}
+
+} // end namespace device
+} // end namespace detail
+} // end namespace cusp
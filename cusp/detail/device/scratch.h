@@ -0,0 +1,73 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+#pragma once
+
+#include <cusp/memory.h>
+
+#include <thrust/memory.h>
+
+#include <cstddef>
+
+namespace cusp
+{
+namespace detail
+{
+namespace device
+{
+
+// Temporary device storage of the kernels of a single call, e.g. the tile
+// states of the COO SpMV.
+//
+// The storage comes from the allocator of the device containers, which is
+// the device allocation cache unless CUSP_NO_DEVICE_CACHE is defined (see
+// cusp/device_cache.h).  The cache hands the block freed by the previous
+// call on the current stream straight back, so a kernel that needs scratch
+// on every call does not pay for cudaMalloc and cudaFree (and the device
+// synchronization of cudaFree) each time.
+template <typename T>
+class device_scratch
+{
+    typedef typename cusp::detail::device_memory_allocator<T>::type allocator_type;
+    typedef typename allocator_type::pointer pointer;
+
+    allocator_type allocator;
+    pointer ptr;
+    size_t n;
+
+    // not copyable
+    device_scratch(const device_scratch&);
+    device_scratch& operator=(const device_scratch&);
+
+    public:
+    explicit device_scratch(size_t n)
+      : ptr(n == 0 ? pointer(static_cast<T*>(NULL)) : allocator.allocate(n)), n(n)
+    {}
+
+    ~device_scratch(void)
+    {
+        if (n != 0)
+            allocator.deallocate(ptr, n);
+    }
+
+    T * get(void) const { return thrust::raw_pointer_cast(ptr); }
+};
+
+} // end namespace device
+} // end namespace detail
+} // end namespace cusp
+
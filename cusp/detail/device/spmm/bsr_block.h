@@ -0,0 +1,172 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+#pragma once
+
+#include <cusp/array2d.h>
+
+#include <cusp/detail/device/arch.h>
+#include <cusp/detail/device/common.h>
+#include <cusp/detail/device/stream.h>
+#include <cusp/detail/device/utils.h>
+
+#include <thrust/device_ptr.h>
+#include <thrust/fill.h>
+
+// SpMM kernel for the Block Sparse Row (BSR) matrix format and a dense block of vectors.
+
+namespace cusp
+{
+namespace detail
+{
+namespace device
+{
+
+// Each row of A is assigned to a group of THREADS_PER_GROUP threads, one per
+// column of B (see spmm_csr_block).  BSR_SIZE is the block size of A, or zero
+// when it is only known at runtime (see spmv_bsr).
+template <typename IndexType, typename ValueType, typename Orientation1, typename Orientation2,
+          unsigned int BSR_SIZE, unsigned int BLOCK_SIZE, unsigned int THREADS_PER_GROUP>
+__launch_bounds__(BLOCK_SIZE,1)
+__global__ void
+spmm_bsr_block_kernel(const IndexType num_rows,
+                      const IndexType num_vectors,
+                      const IndexType block_size,
+                      const IndexType * Ap,
+                      const IndexType * Aj,
+                      const ValueType * Ax,
+                      const ValueType * B,
+                      const IndexType   B_pitch,
+                            ValueType * C,
+                      const IndexType   C_pitch)
+{
+    const IndexType bs = BSR_SIZE > 0 ? IndexType(BSR_SIZE) : block_size;
+
+    const IndexType thread_id   = BLOCK_SIZE * blockIdx.x + threadIdx.x;    // global thread index
+    const IndexType thread_lane = threadIdx.x & (THREADS_PER_GROUP - 1);   // thread index within the group
+    const IndexType group_id    = thread_id   / THREADS_PER_GROUP;         // global group index
+    const IndexType num_groups  = (BLOCK_SIZE / THREADS_PER_GROUP) * gridDim.x;
+
+    for(IndexType row = group_id; row < num_rows; row += num_groups)
+    {
+        const IndexType block_row = row / bs;
+        const IndexType r         = row - block_row * bs;
+
+        const IndexType row_start = Ap[block_row];
+        const IndexType row_end   = Ap[block_row + 1];
+
+        for(IndexType k = thread_lane; k < num_vectors; k += THREADS_PER_GROUP)
+        {
+            ValueType sum = 0;
+
+            for(IndexType jj = row_start; jj < row_end; jj++)
+            {
+                const IndexType   col = Aj[jj] * bs;
+                const ValueType * Ak  = Ax + (jj * bs + r) * bs;
+
+#pragma unroll
+                for(IndexType c = 0; c < bs; c++)
+                    sum += Ak[c] * B[cusp::detail::index_of(col + c, k, B_pitch, Orientation1())];
+            }
+
+            C[cusp::detail::index_of(row, k, C_pitch, Orientation2())] = sum;
+        }
+    }
+}
+
+template <unsigned int BSR_SIZE,
+          unsigned int THREADS_PER_GROUP,
+          typename Matrix1,
+          typename Matrix2,
+          typename Matrix3>
+void __spmm_bsr_block_launch(const Matrix1& A,
+                             const Matrix2& B,
+                                   Matrix3& C)
+{
+    typedef typename Matrix1::index_type  IndexType;
+    typedef typename Matrix1::value_type  ValueType;
+    typedef typename Matrix2::orientation Orientation1;
+    typedef typename Matrix3::orientation Orientation2;
+
+    const size_t BLOCK_SIZE       = 128;
+    const size_t GROUPS_PER_BLOCK = BLOCK_SIZE / THREADS_PER_GROUP;
+
+    const size_t MAX_BLOCKS = cusp::detail::device::arch::max_active_blocks(spmm_bsr_block_kernel<IndexType, ValueType, Orientation1, Orientation2, BSR_SIZE, BLOCK_SIZE, THREADS_PER_GROUP>, BLOCK_SIZE, (size_t) 0);
+    const size_t NUM_BLOCKS = std::min<size_t>(MAX_BLOCKS, DIVIDE_INTO(A.num_rows, GROUPS_PER_BLOCK));
+
+    spmm_bsr_block_kernel<IndexType, ValueType, Orientation1, Orientation2, BSR_SIZE, BLOCK_SIZE, THREADS_PER_GROUP> <<<NUM_BLOCKS, BLOCK_SIZE, 0, cusp::detail::device::current_stream()>>>
+        (IndexType(A.num_rows), IndexType(B.num_cols), IndexType(A.block_size),
+         thrust::raw_pointer_cast(&A.row_offsets[0]),
+         thrust::raw_pointer_cast(&A.column_indices[0]),
+         thrust::raw_pointer_cast(&A.values[0]),
+         thrust::raw_pointer_cast(&B.values[0]), IndexType(B.pitch),
+         thrust::raw_pointer_cast(&C.values[0]), IndexType(C.pitch));
+}
+
+template <unsigned int BSR_SIZE,
+          typename Matrix1,
+          typename Matrix2,
+          typename Matrix3>
+void __spmm_bsr_block(const Matrix1& A,
+                      const Matrix2& B,
+                            Matrix3& C)
+{
+    // assign one thread per column of B, up to a full warp per row
+    const size_t num_vectors = B.num_cols;
+
+    if (num_vectors <=  1) { __spmm_bsr_block_launch<BSR_SIZE, 1>(A, B, C); return; }
+    if (num_vectors <=  2) { __spmm_bsr_block_launch<BSR_SIZE, 2>(A, B, C); return; }
+    if (num_vectors <=  4) { __spmm_bsr_block_launch<BSR_SIZE, 4>(A, B, C); return; }
+    if (num_vectors <=  8) { __spmm_bsr_block_launch<BSR_SIZE, 8>(A, B, C); return; }
+    if (num_vectors <= 16) { __spmm_bsr_block_launch<BSR_SIZE,16>(A, B, C); return; }
+
+    __spmm_bsr_block_launch<BSR_SIZE,32>(A, B, C);
+}
+
+template <typename Matrix1,
+          typename Matrix2,
+          typename Matrix3>
+void spmm_bsr_block(const Matrix1& A,
+                    const Matrix2& B,
+                          Matrix3& C)
+{
+    typedef typename Matrix3::value_type ValueType;
+
+    if (A.num_rows == 0 || B.num_cols == 0)
+        return;
+
+    if (A.num_blocks() == 0)
+    {
+        thrust::fill(C.values.begin(), C.values.end(), ValueType(0));
+        return;
+    }
+
+    switch(A.block_size)
+    {
+        case 1:  __spmm_bsr_block<1>(A, B, C); break;
+        case 2:  __spmm_bsr_block<2>(A, B, C); break;
+        case 3:  __spmm_bsr_block<3>(A, B, C); break;
+        case 4:  __spmm_bsr_block<4>(A, B, C); break;
+        case 5:  __spmm_bsr_block<5>(A, B, C); break;
+        case 6:  __spmm_bsr_block<6>(A, B, C); break;
+        default: __spmm_bsr_block<0>(A, B, C); break;
+    }
+}
+
+} // end namespace device
+} // end namespace detail
+} // end namespace cusp
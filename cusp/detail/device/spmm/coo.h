@@ -17,6 +17,7 @@
 #include <cusp/array1d.h>
 
 #include <cusp/detail/format_utils.h>
+#include <cusp/detail/device/spmm/csr.h>
 
 #include <thrust/gather.h>
 #include <thrust/scan.h>
@@ -134,12 +135,17 @@ void coo_spmm_helper(size_t workspace_size,
 }
 
 
+// C = A * B for COO matrices sorted by row.  Every product A(i,k) * B(k,j)
+// is expanded into an intermediate (I,J,V) workspace, which is sorted by
+// (I,J) and reduced.  The workspace is proportional to the number of
+// products, so large products are formed in slices of rows.  The result
+// does not depend on scheduling, and any index or value type is supported.
 template <typename Matrix1,
           typename Matrix2,
           typename Matrix3>
-void spmm_coo(const Matrix1& A,
-              const Matrix2& B,
-                    Matrix3& C)
+void spmm_coo_expand(const Matrix1& A,
+                     const Matrix2& B,
+                           Matrix3& C)
 {
     CUSP_PROFILE_SCOPED();
 
@@ -303,6 +309,137 @@ void spmm_coo(const Matrix1& A,
     }
 }
 
+// C = A * B for COO matrices sorted by row.  The row indices of A and B
+// are compressed into offsets and the product is formed by the row-wise
+// CSR kernels in csr.h, so no intermediate (I,J,V) products are stored.
+template <typename Matrix1,
+          typename Matrix2,
+          typename Matrix3>
+void spmm_coo(const Matrix1& A,
+              const Matrix2& B,
+                    Matrix3& C,
+              thrust::detail::true_type)
+{
+    CUSP_PROFILE_SCOPED();
+
+    typedef typename Matrix3::index_type   IndexType;
+    typedef typename Matrix3::value_type   ValueType;
+    typedef typename Matrix3::memory_space MemorySpace;
+
+    // check whether matrices are empty
+    if (A.num_entries == 0 || B.num_entries == 0)
+    {
+        C.resize(A.num_rows, B.num_cols, 0);
+        return;
+    }
+
+    // compute row offsets for A and B
+    cusp::array1d<IndexType,MemorySpace> A_row_offsets(A.num_rows + 1);
+    cusp::detail::indices_to_offsets(A.row_indices, A_row_offsets);
+
+    cusp::array1d<IndexType,MemorySpace> B_row_offsets(B.num_rows + 1);
+    cusp::detail::indices_to_offsets(B.row_indices, B_row_offsets);
+
+    // compute the pattern of C
+    cusp::array1d<IndexType,MemorySpace> C_row_offsets(A.num_rows + 1);
+    C.resize(A.num_rows, B.num_cols, 0);
+
+    spmm_csr_symbolic(A.num_rows,
+                      A_row_offsets, A.column_indices,
+                      B_row_offsets, B.column_indices,
+                      C_row_offsets, C.column_indices);
+
+    C.resize(A.num_rows, B.num_cols, C.column_indices.size());
+
+    // compute the values of C
+    spmm_csr_numeric(A.num_rows,
+                     A_row_offsets, A.column_indices, A.values,
+                     B_row_offsets, B.column_indices, B.values,
+                     C_row_offsets, C.column_indices, C.values);
+
+    cusp::detail::offsets_to_indices(C_row_offsets, C.row_indices);
+}
+
+// the row-wise kernels do not support these index or value types
+template <typename Matrix1,
+          typename Matrix2,
+          typename Matrix3>
+void spmm_coo(const Matrix1& A,
+              const Matrix2& B,
+                    Matrix3& C,
+              thrust::detail::false_type)
+{
+    spmm_coo_expand(A, B, C);
+}
+
+template <typename Matrix1,
+          typename Matrix2,
+          typename Matrix3>
+void spmm_coo(const Matrix1& A,
+              const Matrix2& B,
+                    Matrix3& C)
+{
+    typedef typename Matrix3::index_type IndexType;
+    typedef typename Matrix3::value_type ValueType;
+
+    spmm_coo(A, B, C, spmm_csr_is_supported<IndexType,ValueType>());
+}
+
+// RAP = R * A * P for COO matrices sorted by row, formed by the fused
+// triple product in csr.h without storing A * P.
+template <typename Matrix1,
+          typename Matrix2,
+          typename Matrix3,
+          typename Matrix4>
+void spmm_coo_rap(const Matrix1& R,
+                  const Matrix2& A,
+                  const Matrix3& P,
+                        Matrix4& RAP)
+{
+    CUSP_PROFILE_SCOPED();
+
+    typedef typename Matrix4::index_type   IndexType;
+    typedef typename Matrix4::memory_space MemorySpace;
+
+    // check whether matrices are empty
+    if (R.num_entries == 0 || A.num_entries == 0 || P.num_entries == 0)
+    {
+        RAP.resize(R.num_rows, P.num_cols, 0);
+        return;
+    }
+
+    // compute row offsets for R, A and P
+    cusp::array1d<IndexType,MemorySpace> R_row_offsets(R.num_rows + 1);
+    cusp::detail::indices_to_offsets(R.row_indices, R_row_offsets);
+
+    cusp::array1d<IndexType,MemorySpace> A_row_offsets(A.num_rows + 1);
+    cusp::detail::indices_to_offsets(A.row_indices, A_row_offsets);
+
+    cusp::array1d<IndexType,MemorySpace> P_row_offsets(P.num_rows + 1);
+    cusp::detail::indices_to_offsets(P.row_indices, P_row_offsets);
+
+    // compute the pattern of RAP
+    cusp::array1d<IndexType,MemorySpace> RAP_row_offsets(R.num_rows + 1);
+    RAP.resize(R.num_rows, P.num_cols, 0);
+
+    spmm_csr_rap_symbolic(R.num_rows,
+                          R_row_offsets, R.column_indices,
+                          A_row_offsets, A.column_indices,
+                          P_row_offsets, P.column_indices,
+                          RAP_row_offsets, RAP.column_indices);
+
+    RAP.resize(R.num_rows, P.num_cols, RAP.column_indices.size());
+
+    // compute the values of RAP
+    spmm_csr_rap_numeric(R.num_rows,
+                         R_row_offsets, R.column_indices, R.values,
+                         A_row_offsets, A.column_indices, A.values,
+                         P_row_offsets, P.column_indices, P.values,
+                         RAP_row_offsets, RAP.column_indices, RAP.values);
+
+    cusp::detail::offsets_to_indices(RAP_row_offsets, RAP.row_indices);
+}
+
 } // end namespace device
 } // end namespace detail
 } // end namespace cusp
@@ -0,0 +1,1015 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+#pragma once
+
+#include <cusp/array1d.h>
+
+#include <cusp/detail/format_utils.h>
+#include <cusp/detail/stream.h>
+#include <cusp/detail/device/arch.h>
+#include <cusp/detail/device/common.h>
+#include <cusp/detail/device/stream.h>
+#include <cusp/detail/device/utils.h>
+
+#include <thrust/binary_search.h>
+#include <thrust/copy.h>
+#include <thrust/device_ptr.h>
+#include <thrust/functional.h>
+#include <thrust/gather.h>
+#include <thrust/scan.h>
+#include <thrust/scatter.h>
+#include <thrust/sort.h>
+#include <thrust/iterator/counting_iterator.h>
+
+#include <thrust/detail/type_traits.h>
+
+namespace cusp
+{
+namespace detail
+{
+namespace device
+{
+
+//////////////////////////////////////////////////////////////////////////////
+// Row-wise sparse matrix-matrix multiplication (C = A * B, all CSR)
+//////////////////////////////////////////////////////////////////////////////
+//
+// spmm_csr_symbolic
+//   Computes the sparsity pattern of C.  Each row of C is assigned to a warp
+//   which inserts the column indices of the partial products A(i,k) * B(k,:)
+//   into a hash table to find the distinct columns of C(i,:).  A first pass
+//   counts the columns of each row, the counts are scanned into the row
+//   offsets of C, and a second pass writes the columns of each row in
+//   sorted order.  Rows whose upper bound on the number of entries,
+//   sum_k nnz(B(k,:)), fits in HASH_SIZE use a table in shared memory.
+//   The remaining rows use tables in global memory, which are allocated
+//   in batches of bounded size, and are sorted after the second pass.
+//
+// spmm_csr_numeric
+//   Computes the values of C given its pattern.  Each warp locates every
+//   partial product A(i,k) * B(k,j) in the sorted columns of C(i,:) with a
+//   binary search and accumulates it there.  Rows with at most CACHE_SIZE
+//   entries are accumulated in shared memory and written out at once.
+//
+//   Since the pattern only depends on the patterns of A and B, the numeric
+//   phase may be repeated whenever the values of A or B change.
+//
+//   Partial products are accumulated with atomic additions, so the order in
+//   which they are summed depends on scheduling.  Floating point results may
+//   differ in the last bits from one run to the next and are not
+//   deterministic, unlike those of the expansion-sort-contraction approach.
+//
+//   In contrast to the expansion-sort-contraction approach, the workspace
+//   and the work of both phases are proportional to the rows of C rather
+//   than to the number of intermediate products.
+//
+// spmm_csr_rap
+//   Computes the Galerkin product R * A * P with the same kernels, where
+//   the partial products of row i are R(i,k) * A(k,l) * P(l,:).  The
+//   intermediate A * P is never formed.
+//
+//  The kernels are parameterized on a product type which enumerates the
+//  partial products of a row (spmm_product_ab and spmm_product_rap).
+//
+//  The hash tables and row counts rely on atomicCAS and atomicAdd for the
+//  index type, and the accumulation on spmm_atomic_add for the value type.
+//  spmm_csr_is_supported is true for the types the kernels can be built
+//  for (int and unsigned int indices, float and double values); callers
+//  must use the expansion-sort-contraction path for other types.
+//
+
+template <typename IndexType, typename ValueType>
+struct spmm_csr_is_supported
+  : public thrust::detail::integral_constant<bool,
+      (thrust::detail::is_same<IndexType,int>::value ||
+       thrust::detail::is_same<IndexType,unsigned int>::value) &&
+      (thrust::detail::is_same<ValueType,float>::value ||
+       thrust::detail::is_same<ValueType,double>::value)> {};
+
+template <typename IndexType>
+struct spmm_csr_row_fits : public thrust::unary_function<IndexType,bool>
+{
+    const IndexType capacity;
+
+    spmm_csr_row_fits(const IndexType capacity) : capacity(capacity) {}
+
+    __host__ __device__
+    bool operator()(const IndexType n) const
+    {
+        return n <= capacity;
+    }
+};
+
+template <typename IndexType>
+struct spmm_csr_row_exceeds : public thrust::unary_function<IndexType,bool>
+{
+    const IndexType capacity;
+
+    spmm_csr_row_exceeds(const IndexType capacity) : capacity(capacity) {}
+
+    __host__ __device__
+    bool operator()(const IndexType n) const
+    {
+        return n > capacity;
+    }
+};
+
+__device__ inline float spmm_atomic_add(float * address, const float value)
+{
+    return atomicAdd(address, value);
+}
+
+__device__ inline double spmm_atomic_add(double * address, const double value)
+{
+    unsigned long long int * address_as_ull = (unsigned long long int *) address;
+    unsigned long long int old = *address_as_ull, assumed;
+
+    do
+    {
+        assumed = old;
+        old = atomicCAS(address_as_ull, assumed, __double_as_longlong(value + __longlong_as_double(assumed)));
+    } while (assumed != old);
+
+    return __longlong_as_double(old);
+}
+
+// inserts key into an open addressing table, returns true if key was not present
+template <typename IndexType>
+__device__ bool
+spmm_hash_insert(IndexType * keys, const IndexType size, const IndexType key)
+{
+    IndexType slot = key % size;
+
+    while (true)
+    {
+        const IndexType prev = atomicCAS(keys + slot, IndexType(-1), key);
+
+        if (prev == IndexType(-1)) return true;
+        if (prev == key)           return false;
+
+        slot = (slot + 1 == size) ? 0 : slot + 1;
+    }
+}
+
+template <typename IndexType>
+__device__ IndexType
+spmm_lower_bound(const IndexType * columns, const IndexType n, const IndexType key)
+{
+    IndexType lo = 0;
+    IndexType hi = n;
+
+    while (lo < hi)
+    {
+        const IndexType mid = (lo + hi) >> 1;
+
+        if (columns[mid] < key)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    return lo;
+}
+
+// partial products A(i,k) * B(k,:) of row i of A * B
+template <typename IndexType, typename ValueType>
+struct spmm_product_ab
+{
+    const IndexType * Ap; const IndexType * Aj; const ValueType * Ax;
+    const IndexType * Bp; const IndexType * Bj; const ValueType * Bx;
+
+    template <typename Visitor>
+    __device__ void columns(const IndexType row, const IndexType thread_lane, Visitor& visitor) const
+    {
+        for(IndexType jj = Ap[row] + thread_lane; jj < Ap[row + 1]; jj += WARP_SIZE)
+        {
+            const IndexType k = Aj[jj];
+
+            for(IndexType kk = Bp[k]; kk < Bp[k + 1]; kk++)
+                visitor(Bj[kk]);
+        }
+    }
+
+    template <typename Visitor>
+    __device__ void products(const IndexType row, const IndexType thread_lane, Visitor& visitor) const
+    {
+        for(IndexType jj = Ap[row] + thread_lane; jj < Ap[row + 1]; jj += WARP_SIZE)
+        {
+            const IndexType k = Aj[jj];
+            const ValueType a = Ax[jj];
+
+            for(IndexType kk = Bp[k]; kk < Bp[k + 1]; kk++)
+                visitor(Bj[kk], a * Bx[kk]);
+        }
+    }
+};
+
+// partial products R(i,k) * A(k,l) * P(l,:) of row i of R * A * P
+template <typename IndexType, typename ValueType>
+struct spmm_product_rap
+{
+    const IndexType * Rp; const IndexType * Rj; const ValueType * Rx;
+    const IndexType * Ap; const IndexType * Aj; const ValueType * Ax;
+    const IndexType * Pp; const IndexType * Pj; const ValueType * Px;
+
+    template <typename Visitor>
+    __device__ void columns(const IndexType row, const IndexType thread_lane, Visitor& visitor) const
+    {
+        for(IndexType jj = Rp[row] + thread_lane; jj < Rp[row + 1]; jj += WARP_SIZE)
+        {
+            const IndexType k = Rj[jj];
+
+            for(IndexType kk = Ap[k]; kk < Ap[k + 1]; kk++)
+            {
+                const IndexType l = Aj[kk];
+
+                for(IndexType ll = Pp[l]; ll < Pp[l + 1]; ll++)
+                    visitor(Pj[ll]);
+            }
+        }
+    }
+
+    template <typename Visitor>
+    __device__ void products(const IndexType row, const IndexType thread_lane, Visitor& visitor) const
+    {
+        for(IndexType jj = Rp[row] + thread_lane; jj < Rp[row + 1]; jj += WARP_SIZE)
+        {
+            const IndexType k = Rj[jj];
+            const ValueType r = Rx[jj];
+
+            for(IndexType kk = Ap[k]; kk < Ap[k + 1]; kk++)
+            {
+                const IndexType l  = Aj[kk];
+                const ValueType ra = r * Ax[kk];
+
+                for(IndexType ll = Pp[l]; ll < Pp[l + 1]; ll++)
+                    visitor(Pj[ll], ra * Px[ll]);
+            }
+        }
+    }
+};
+
+// inserts the column of each partial product into the row's hash table
+template <typename IndexType, bool UseSharedTable, bool WriteColumns>
+struct spmm_symbolic_visitor
+{
+    IndexType * keys;
+    IndexType   size;
+    IndexType * count;
+    IndexType * columns;   // compacted columns of the row
+
+    __device__ void operator()(const IndexType col)
+    {
+        if (spmm_hash_insert(keys, size, col))
+        {
+            const IndexType position = atomicAdd(count, IndexType(1));
+
+            if (WriteColumns)
+                columns[position] = col;
+        }
+    }
+};
+
+// accumulates each partial product into its entry of the row of C
+template <typename IndexType, typename ValueType>
+struct spmm_numeric_visitor
+{
+    const IndexType * columns;
+          ValueType * values;
+          IndexType   n;
+
+    __device__ void operator()(const IndexType col, const ValueType value)
+    {
+        spmm_atomic_add(values + spmm_lower_bound(columns, n, col), value);
+    }
+};
+
+// bounds[i] = sum_k weights[k] over the entries A(i,k)
+template <typename IndexType, unsigned int BLOCK_SIZE>
+__launch_bounds__(BLOCK_SIZE,1)
+__global__ void
+spmm_csr_row_bounds_kernel(const IndexType num_rows,
+                           const IndexType * Ap,
+                           const IndexType * Aj,
+                           const IndexType * weights,
+                                 IndexType * bounds)
+{
+    const IndexType thread_id = BLOCK_SIZE * blockIdx.x + threadIdx.x;
+    const IndexType grid_size = BLOCK_SIZE * gridDim.x;
+
+    for(IndexType row = thread_id; row < num_rows; row += grid_size)
+    {
+        IndexType sum = 0;
+
+        for(IndexType jj = Ap[row]; jj < Ap[row + 1]; jj++)
+            sum += weights[Aj[jj]];
+
+        bounds[row] = sum;
+    }
+}
+
+// One warp per row in the list rows[0, num_rows).  When WriteColumns is
+// false the number of distinct columns of each row is written to
+// row_counts, otherwise the columns are written to C.  Global tables are
+// located at table_ends[r] - table_sizes[r] - table_base.
+template <typename IndexType, typename Product, unsigned int BLOCK_SIZE, unsigned int HASH_SIZE, bool UseSharedTable, bool WriteColumns>
+__launch_bounds__(BLOCK_SIZE,1)
+__global__ void
+spmm_csr_symbolic_kernel(const IndexType num_rows,
+                         const IndexType * rows,
+                         const Product     product,
+                         const IndexType * table_ends,
+                         const IndexType * table_sizes,
+                         const IndexType   table_base,
+                               IndexType * table_keys,
+                               IndexType * row_counts,
+                         const IndexType * Cp,
+                               IndexType * Cj)
+{
+    const IndexType WARPS_PER_BLOCK = BLOCK_SIZE / WARP_SIZE;
+
+    __shared__ IndexType s_keys[UseSharedTable ? (BLOCK_SIZE / WARP_SIZE) * HASH_SIZE : 1];
+    __shared__ IndexType s_columns[(UseSharedTable && WriteColumns) ? (BLOCK_SIZE / WARP_SIZE) * HASH_SIZE : 1];
+    __shared__ IndexType s_counts[BLOCK_SIZE / WARP_SIZE];
+
+    const IndexType thread_lane = threadIdx.x & (WARP_SIZE - 1);   // thread index within the warp
+    const IndexType warp_lane   = threadIdx.x / WARP_SIZE;         // warp index within the block
+
+    // every thread of the block runs the same number of iterations
+    for(IndexType base = WARPS_PER_BLOCK * blockIdx.x; base < num_rows; base += WARPS_PER_BLOCK * gridDim.x)
+    {
+        const IndexType r      = base + warp_lane;
+        const bool      active = r < num_rows;
+        const IndexType row    = active ? rows[r] : 0;
+
+        spmm_symbolic_visitor<IndexType, UseSharedTable, WriteColumns> visitor;
+        visitor.keys    = s_keys + (UseSharedTable ? warp_lane * HASH_SIZE : 0);
+        visitor.size    = HASH_SIZE;
+        visitor.count   = s_counts + warp_lane;
+        visitor.columns = s_columns + ((UseSharedTable && WriteColumns) ? warp_lane * HASH_SIZE : 0);
+
+        if (UseSharedTable)
+        {
+            for(IndexType n = thread_lane; n < IndexType(HASH_SIZE); n += WARP_SIZE)
+                visitor.keys[n] = IndexType(-1);
+
+            if (thread_lane == 0)
+                *visitor.count = 0;
+        }
+        else if (active)
+        {
+            // global tables and counters are initialized by the caller,
+            // columns are written to C directly and sorted afterwards
+            visitor.keys    = table_keys + (table_ends[r] - table_sizes[r] - table_base);
+            visitor.size    = table_sizes[r];
+            visitor.count   = row_counts + r;
+            visitor.columns = Cj + (WriteColumns ? Cp[row] : 0);
+        }
+
+        __syncthreads();
+
+        if (active)
+            product.columns(row, thread_lane, visitor);
+
+        __syncthreads();
+
+        if (active && UseSharedTable)
+        {
+            const IndexType n = *visitor.count;
+
+            if (!WriteColumns)
+            {
+                if (thread_lane == 0)
+                    row_counts[r] = n;
+            }
+            else
+            {
+                // place each column at its rank within the row
+                const IndexType * columns = visitor.columns;
+                const IndexType   offset  = Cp[row];
+
+                for(IndexType i = thread_lane; i < n; i += WARP_SIZE)
+                {
+                    const IndexType col = columns[i];
+
+                    IndexType rank = 0;
+                    for(IndexType j = 0; j < n; j++)
+                        rank += (columns[j] < col) ? 1 : 0;
+
+                    Cj[offset + rank] = col;
+                }
+            }
+        }
+
+        __syncthreads();
+    }
+}
+
+// One warp per row in the list rows[0, num_rows).  Global accumulation
+// expects Cx to be zero on entry.
+template <typename IndexType, typename ValueType, typename Product, unsigned int BLOCK_SIZE, unsigned int CACHE_SIZE, bool UseSharedCache>
+__launch_bounds__(BLOCK_SIZE,1)
+__global__ void
+spmm_csr_numeric_kernel(const IndexType num_rows,
+                        const IndexType * rows,
+                        const Product     product,
+                        const IndexType * Cp,
+                        const IndexType * Cj,
+                              ValueType * Cx)
+{
+    const IndexType WARPS_PER_BLOCK = BLOCK_SIZE / WARP_SIZE;
+
+    __shared__ IndexType s_columns[UseSharedCache ? (BLOCK_SIZE / WARP_SIZE) * CACHE_SIZE : 1];
+    __shared__ ValueType s_values [UseSharedCache ? (BLOCK_SIZE / WARP_SIZE) * CACHE_SIZE : 1];
+
+    const IndexType thread_lane = threadIdx.x & (WARP_SIZE - 1);   // thread index within the warp
+    const IndexType warp_lane   = threadIdx.x / WARP_SIZE;         // warp index within the block
+
+    // every thread of the block runs the same number of iterations
+    for(IndexType base = WARPS_PER_BLOCK * blockIdx.x; base < num_rows; base += WARPS_PER_BLOCK * gridDim.x)
+    {
+        const IndexType r      = base + warp_lane;
+        const bool      active = r < num_rows;
+        const IndexType row    = active ? rows[r] : 0;
+
+        const IndexType offset = active ? Cp[row] : 0;
+
+        spmm_numeric_visitor<IndexType, ValueType> visitor;
+        visitor.columns = Cj + offset;
+        visitor.values  = Cx + offset;
+        visitor.n       = active ? Cp[row + 1] - offset : 0;
+
+        if (UseSharedCache)
+        {
+            IndexType * cached_columns = s_columns + warp_lane * CACHE_SIZE;
+            ValueType * cached_values  = s_values  + warp_lane * CACHE_SIZE;
+
+            for(IndexType i = thread_lane; i < visitor.n; i += WARP_SIZE)
+            {
+                cached_columns[i] = Cj[offset + i];
+                cached_values[i]  = ValueType(0);
+            }
+
+            visitor.columns = cached_columns;
+            visitor.values  = cached_values;
+        }
+
+        __syncthreads();
+
+        if (active)
+            product.products(row, thread_lane, visitor);
+
+        __syncthreads();
+
+        if (UseSharedCache)
+        {
+            for(IndexType i = thread_lane; i < visitor.n; i += WARP_SIZE)
+                Cx[offset + i] = visitor.values[i];
+        }
+
+        __syncthreads();
+    }
+}
+
+template <unsigned int BLOCK_SIZE, typename IndexType>
+void spmm_csr_row_bounds(const IndexType  num_rows,
+                         const IndexType* Ap,
+                         const IndexType* Aj,
+                         const IndexType* weights,
+                               IndexType* bounds)
+{
+    const size_t MAX_BLOCKS = cusp::detail::device::arch::max_active_blocks(spmm_csr_row_bounds_kernel<IndexType, BLOCK_SIZE>, BLOCK_SIZE, (size_t) 0);
+    const size_t NUM_BLOCKS = std::min<size_t>(MAX_BLOCKS, DIVIDE_INTO(num_rows, BLOCK_SIZE));
+
+    spmm_csr_row_bounds_kernel<IndexType, BLOCK_SIZE> <<<NUM_BLOCKS, BLOCK_SIZE, 0, cusp::detail::device::current_stream()>>>
+        (num_rows, Ap, Aj, weights, bounds);
+}
+
+template <bool WriteColumns, unsigned int BLOCK_SIZE, unsigned int HASH_SIZE, typename IndexType, typename Product>
+void __spmm_csr_symbolic_short(const IndexType  num_rows,
+                               const IndexType* rows,
+                               const Product&   product,
+                                     IndexType* row_counts,
+                               const IndexType* Cp,
+                                     IndexType* Cj)
+{
+    if (num_rows == 0)
+        return;
+
+    const size_t WARPS_PER_BLOCK = BLOCK_SIZE / WARP_SIZE;
+
+    const size_t MAX_BLOCKS = cusp::detail::device::arch::max_active_blocks(spmm_csr_symbolic_kernel<IndexType, Product, BLOCK_SIZE, HASH_SIZE, true, WriteColumns>, BLOCK_SIZE, (size_t) 0);
+    const size_t NUM_BLOCKS = std::min<size_t>(MAX_BLOCKS, DIVIDE_INTO(num_rows, WARPS_PER_BLOCK));
+
+    spmm_csr_symbolic_kernel<IndexType, Product, BLOCK_SIZE, HASH_SIZE, true, WriteColumns> <<<NUM_BLOCKS, BLOCK_SIZE, 0, cusp::detail::device::current_stream()>>>
+        (num_rows, rows, product,
+         (const IndexType *) 0, (const IndexType *) 0, IndexType(0), (IndexType *) 0,
+         row_counts, Cp, Cj);
+}
+
+template <bool WriteColumns, unsigned int BLOCK_SIZE, typename IndexType, typename Product, typename Array>
+void __spmm_csr_symbolic_long(const IndexType  num_rows,
+                              const IndexType* rows,
+                              const Product&   product,
+                              const Array&     table_sizes,
+                              const Array&     table_ends,
+                              const size_t     capacity,
+                                    IndexType* row_counts,
+                              const IndexType* Cp,
+                                    IndexType* Cj)
+{
+    if (num_rows == 0)
+        return;
+
+    const size_t WARPS_PER_BLOCK = BLOCK_SIZE / WARP_SIZE;
+
+    const size_t MAX_BLOCKS = cusp::detail::device::arch::max_active_blocks(spmm_csr_symbolic_kernel<IndexType, Product, BLOCK_SIZE, 1, false, WriteColumns>, BLOCK_SIZE, (size_t) 0);
+
+    cusp::array1d<IndexType,cusp::device_memory> keys;
+
+    cusp::detail::stream::fill(thrust::device_pointer_cast(row_counts),
+                               thrust::device_pointer_cast(row_counts) + num_rows,
+                               IndexType(0));
+
+    size_t begin = 0;
+    size_t base  = 0;
+
+    while (begin < size_t(num_rows))
+    {
+        // find the largest batch of rows whose tables fit in the capacity
+        size_t end = thrust::upper_bound(table_ends.begin() + begin, table_ends.begin() + num_rows,
+                                         IndexType(base + capacity)) - table_ends.begin();
+
+        // a single row which exceeds the capacity is processed by itself
+        if (end == begin)
+            end = begin + 1;
+
+        const size_t batch_end = table_ends[end - 1];
+
+        keys.resize(batch_end - base);
+        cusp::detail::stream::fill(keys.begin(), keys.end(), IndexType(-1));
+
+        const size_t NUM_BLOCKS = std::min<size_t>(MAX_BLOCKS, DIVIDE_INTO(end - begin, WARPS_PER_BLOCK));
+
+        spmm_csr_symbolic_kernel<IndexType, Product, BLOCK_SIZE, 1, false, WriteColumns> <<<NUM_BLOCKS, BLOCK_SIZE, 0, cusp::detail::device::current_stream()>>>
+            (IndexType(end - begin), rows + begin, product,
+             thrust::raw_pointer_cast(&table_ends[0]) + begin,
+             thrust::raw_pointer_cast(&table_sizes[0]) + begin,
+             IndexType(base),
+             thrust::raw_pointer_cast(&keys[0]),
+             row_counts + begin, Cp, Cj);
+
+        base  = batch_end;
+        begin = end;
+    }
+}
+
+// computes the pattern of C given an upper bound on the length of each row
+template <typename Product, typename Array1, typename Array2, typename Array3>
+void __spmm_csr_symbolic(const size_t   num_rows,
+                         const Product& product,
+                               Array1&  bounds,
+                               Array2&  C_row_offsets,
+                               Array3&  C_column_indices)
+{
+    typedef typename Array2::value_type IndexType;
+
+    const unsigned int BLOCK_SIZE = 128;
+    const unsigned int HASH_SIZE  = 512;
+
+    // separate the rows whose hash table fits in shared memory from the rest
+    cusp::array1d<IndexType,cusp::device_memory> short_rows(num_rows);
+    cusp::array1d<IndexType,cusp::device_memory> long_rows(num_rows);
+
+    const IndexType num_short_rows =
+        thrust::copy_if(thrust::counting_iterator<IndexType>(0), thrust::counting_iterator<IndexType>(num_rows),
+                        bounds.begin(), short_rows.begin(), spmm_csr_row_fits<IndexType>(HASH_SIZE)) - short_rows.begin();
+    const IndexType num_long_rows =
+        thrust::copy_if(thrust::counting_iterator<IndexType>(0), thrust::counting_iterator<IndexType>(num_rows),
+                        bounds.begin(), long_rows.begin(), spmm_csr_row_exceeds<IndexType>(HASH_SIZE)) - long_rows.begin();
+
+    // size and location of the global tables of the long rows
+    cusp::array1d<IndexType,cusp::device_memory> table_sizes(num_long_rows);
+    cusp::array1d<IndexType,cusp::device_memory> table_ends(num_long_rows);
+    size_t capacity = 0;
+
+    if (num_long_rows > 0)
+    {
+        thrust::gather(long_rows.begin(), long_rows.begin() + num_long_rows, bounds.begin(), table_sizes.begin());
+        thrust::inclusive_scan(table_sizes.begin(), table_sizes.end(), table_ends.begin());
+
+        capacity = thrust::min<size_t>(table_ends[num_long_rows - 1], 16 << 20);
+
+        // TODO abstract this
+        size_t free, total;
+        cudaMemGetInfo(&free, &total);
+
+        // use at most one third of the remaining memory
+        capacity = thrust::min<size_t>(free / sizeof(IndexType) / 3, capacity);
+    }
+
+    // count the entries in each row of C
+    cusp::array1d<IndexType,cusp::device_memory> short_counts(num_short_rows);
+    cusp::array1d<IndexType,cusp::device_memory> long_counts(num_long_rows);
+
+    __spmm_csr_symbolic_short<false, BLOCK_SIZE, HASH_SIZE>
+        (num_short_rows, thrust::raw_pointer_cast(&short_rows[0]), product,
+         thrust::raw_pointer_cast(&short_counts[0]),
+         (const IndexType *) 0, (IndexType *) 0);
+
+    __spmm_csr_symbolic_long<false, BLOCK_SIZE>
+        (num_long_rows, thrust::raw_pointer_cast(&long_rows[0]), product,
+         table_sizes, table_ends, capacity,
+         thrust::raw_pointer_cast(&long_counts[0]),
+         (const IndexType *) 0, (IndexType *) 0);
+
+    // scan the row lengths into the row offsets of C (bounds is reused for the row lengths)
+    thrust::scatter(short_counts.begin(), short_counts.end(), short_rows.begin(), bounds.begin());
+    thrust::scatter(long_counts.begin(),  long_counts.end(),  long_rows.begin(),  bounds.begin());
+
+    C_row_offsets[0] = 0;
+    thrust::inclusive_scan(bounds.begin(), bounds.end(), C_row_offsets.begin() + 1);
+
+    C_column_indices.resize(C_row_offsets[num_rows]);
+
+    if (C_column_indices.size() == 0)
+        return;
+
+    IndexType * Cp = thrust::raw_pointer_cast(&C_row_offsets[0]);
+    IndexType * Cj = thrust::raw_pointer_cast(&C_column_indices[0]);
+
+    // write the columns of each row of C
+    __spmm_csr_symbolic_short<true, BLOCK_SIZE, HASH_SIZE>
+        (num_short_rows, thrust::raw_pointer_cast(&short_rows[0]), product,
+         (IndexType *) 0, Cp, Cj);
+
+    __spmm_csr_symbolic_long<true, BLOCK_SIZE>
+        (num_long_rows, thrust::raw_pointer_cast(&long_rows[0]), product,
+         table_sizes, table_ends, capacity,
+         thrust::raw_pointer_cast(&long_counts[0]), Cp, Cj);
+
+    // the columns of the long rows were written in arbitrary order
+    if (num_long_rows > 0)
+    {
+        cusp::array1d<IndexType,cusp::device_memory> row_indices(C_column_indices.size());
+        cusp::detail::offsets_to_indices(C_row_offsets, row_indices);
+
+        thrust::stable_sort_by_key(C_column_indices.begin(), C_column_indices.end(), row_indices.begin());
+        thrust::stable_sort_by_key(row_indices.begin(), row_indices.end(), C_column_indices.begin());
+    }
+}
+
+// computes the values of C given its pattern
+template <typename Product, typename Array1, typename Array2, typename Array3>
+void __spmm_csr_numeric(const size_t   num_rows,
+                        const Product& product,
+                        const Array1&  C_row_offsets,
+                        const Array2&  C_column_indices,
+                              Array3&  C_values)
+{
+    typedef typename Array1::value_type IndexType;
+    typedef typename Array3::value_type ValueType;
+
+    const unsigned int BLOCK_SIZE = 128;
+    const unsigned int CACHE_SIZE = 256;
+
+    const size_t WARPS_PER_BLOCK = BLOCK_SIZE / WARP_SIZE;
+
+    C_values.resize(C_column_indices.size());
+
+    if (C_values.size() == 0)
+        return;
+
+    // separate the rows of C which fit in shared memory from the rest
+    cusp::array1d<IndexType,cusp::device_memory> row_lengths(num_rows);
+    cusp::detail::stream::transform(C_row_offsets.begin() + 1, C_row_offsets.end(), C_row_offsets.begin(),
+                                    row_lengths.begin(), thrust::minus<IndexType>());
+
+    cusp::array1d<IndexType,cusp::device_memory> short_rows(num_rows);
+    cusp::array1d<IndexType,cusp::device_memory> long_rows(num_rows);
+
+    const IndexType num_short_rows =
+        thrust::copy_if(thrust::counting_iterator<IndexType>(0), thrust::counting_iterator<IndexType>(num_rows),
+                        row_lengths.begin(), short_rows.begin(), spmm_csr_row_fits<IndexType>(CACHE_SIZE)) - short_rows.begin();
+    const IndexType num_long_rows =
+        thrust::copy_if(thrust::counting_iterator<IndexType>(0), thrust::counting_iterator<IndexType>(num_rows),
+                        row_lengths.begin(), long_rows.begin(), spmm_csr_row_exceeds<IndexType>(CACHE_SIZE)) - long_rows.begin();
+
+    const IndexType * Cp = thrust::raw_pointer_cast(&C_row_offsets[0]);
+    const IndexType * Cj = thrust::raw_pointer_cast(&C_column_indices[0]);
+          ValueType * Cx = thrust::raw_pointer_cast(&C_values[0]);
+
+    if (num_short_rows > 0)
+    {
+        const size_t MAX_BLOCKS = cusp::detail::device::arch::max_active_blocks(spmm_csr_numeric_kernel<IndexType, ValueType, Product, BLOCK_SIZE, CACHE_SIZE, true>, BLOCK_SIZE, (size_t) 0);
+        const size_t NUM_BLOCKS = std::min<size_t>(MAX_BLOCKS, DIVIDE_INTO(num_short_rows, WARPS_PER_BLOCK));
+
+        spmm_csr_numeric_kernel<IndexType, ValueType, Product, BLOCK_SIZE, CACHE_SIZE, true> <<<NUM_BLOCKS, BLOCK_SIZE, 0, cusp::detail::device::current_stream()>>>
+            (num_short_rows, thrust::raw_pointer_cast(&short_rows[0]), product, Cp, Cj, Cx);
+    }
+
+    if (num_long_rows > 0)
+    {
+        // long rows are accumulated in place
+        cusp::detail::stream::fill(C_values.begin(), C_values.end(), ValueType(0));
+
+        const size_t MAX_BLOCKS = cusp::detail::device::arch::max_active_blocks(spmm_csr_numeric_kernel<IndexType, ValueType, Product, BLOCK_SIZE, 1, false>, BLOCK_SIZE, (size_t) 0);
+        const size_t NUM_BLOCKS = std::min<size_t>(MAX_BLOCKS, DIVIDE_INTO(num_long_rows, WARPS_PER_BLOCK));
+
+        spmm_csr_numeric_kernel<IndexType, ValueType, Product, BLOCK_SIZE, 1, false> <<<NUM_BLOCKS, BLOCK_SIZE, 0, cusp::detail::device::current_stream()>>>
+            (num_long_rows, thrust::raw_pointer_cast(&long_rows[0]), product, Cp, Cj, Cx);
+    }
+}
+
+template <typename Array1, typename Array2, typename Array3, typename Array4, typename Array5, typename Array6>
+void spmm_csr_symbolic(const size_t  num_rows,
+                       const Array1& A_row_offsets,
+                       const Array2& A_column_indices,
+                       const Array3& B_row_offsets,
+                       const Array4& B_column_indices,
+                             Array5& C_row_offsets,
+                             Array6& C_column_indices)
+{
+    CUSP_PROFILE_SCOPED();
+
+    typedef typename Array5::value_type IndexType;
+    typedef float                       ValueType;  // values are not referenced
+
+    C_row_offsets.resize(num_rows + 1);
+
+    if (num_rows == 0 || A_column_indices.size() == 0 || B_column_indices.size() == 0)
+    {
+        cusp::detail::stream::fill(C_row_offsets.begin(), C_row_offsets.end(), IndexType(0));
+        C_column_indices.resize(0);
+        return;
+    }
+
+    spmm_product_ab<IndexType,ValueType> product;
+    product.Ap = thrust::raw_pointer_cast(&A_row_offsets[0]);
+    product.Aj = thrust::raw_pointer_cast(&A_column_indices[0]);
+    product.Ax = 0;
+    product.Bp = thrust::raw_pointer_cast(&B_row_offsets[0]);
+    product.Bj = thrust::raw_pointer_cast(&B_column_indices[0]);
+    product.Bx = 0;
+
+    // bound the length of row i of C by sum_k nnz(B(k,:))
+    cusp::array1d<IndexType,cusp::device_memory> B_row_lengths(B_row_offsets.size() - 1);
+    cusp::detail::stream::transform(B_row_offsets.begin() + 1, B_row_offsets.end(), B_row_offsets.begin(),
+                                    B_row_lengths.begin(), thrust::minus<IndexType>());
+
+    cusp::array1d<IndexType,cusp::device_memory> bounds(num_rows);
+    spmm_csr_row_bounds<128>(IndexType(num_rows), product.Ap, product.Aj,
+                             thrust::raw_pointer_cast(&B_row_lengths[0]),
+                             thrust::raw_pointer_cast(&bounds[0]));
+
+    __spmm_csr_symbolic(num_rows, product, bounds, C_row_offsets, C_column_indices);
+}
+
+template <typename Array1, typename Array2, typename Array3,
+          typename Array4, typename Array5, typename Array6,
+          typename Array7, typename Array8, typename Array9>
+void spmm_csr_numeric(const size_t  num_rows,
+                      const Array1& A_row_offsets,
+                      const Array2& A_column_indices,
+                      const Array3& A_values,
+                      const Array4& B_row_offsets,
+                      const Array5& B_column_indices,
+                      const Array6& B_values,
+                      const Array7& C_row_offsets,
+                      const Array8& C_column_indices,
+                            Array9& C_values)
+{
+    CUSP_PROFILE_SCOPED();
+
+    typedef typename Array7::value_type IndexType;
+    typedef typename Array9::value_type ValueType;
+
+    if (C_column_indices.size() == 0)
+    {
+        C_values.resize(0);
+        return;
+    }
+
+    spmm_product_ab<IndexType,ValueType> product;
+    product.Ap = thrust::raw_pointer_cast(&A_row_offsets[0]);
+    product.Aj = thrust::raw_pointer_cast(&A_column_indices[0]);
+    product.Ax = thrust::raw_pointer_cast(&A_values[0]);
+    product.Bp = thrust::raw_pointer_cast(&B_row_offsets[0]);
+    product.Bj = thrust::raw_pointer_cast(&B_column_indices[0]);
+    product.Bx = thrust::raw_pointer_cast(&B_values[0]);
+
+    __spmm_csr_numeric(num_rows, product, C_row_offsets, C_column_indices, C_values);
+}
+
+template <typename Array1, typename Array2, typename Array3, typename Array4,
+          typename Array5, typename Array6, typename Array7, typename Array8>
+void spmm_csr_rap_symbolic(const size_t  num_rows,
+                           const Array1& R_row_offsets,
+                           const Array2& R_column_indices,
+                           const Array3& A_row_offsets,
+                           const Array4& A_column_indices,
+                           const Array5& P_row_offsets,
+                           const Array6& P_column_indices,
+                                 Array7& C_row_offsets,
+                                 Array8& C_column_indices)
+{
+    CUSP_PROFILE_SCOPED();
+
+    typedef typename Array7::value_type IndexType;
+    typedef float                       ValueType;  // values are not referenced
+
+    C_row_offsets.resize(num_rows + 1);
+
+    if (num_rows == 0 || R_column_indices.size() == 0 || A_column_indices.size() == 0 || P_column_indices.size() == 0)
+    {
+        cusp::detail::stream::fill(C_row_offsets.begin(), C_row_offsets.end(), IndexType(0));
+        C_column_indices.resize(0);
+        return;
+    }
+
+    spmm_product_rap<IndexType,ValueType> product;
+    product.Rp = thrust::raw_pointer_cast(&R_row_offsets[0]);
+    product.Rj = thrust::raw_pointer_cast(&R_column_indices[0]);
+    product.Rx = 0;
+    product.Ap = thrust::raw_pointer_cast(&A_row_offsets[0]);
+    product.Aj = thrust::raw_pointer_cast(&A_column_indices[0]);
+    product.Ax = 0;
+    product.Pp = thrust::raw_pointer_cast(&P_row_offsets[0]);
+    product.Pj = thrust::raw_pointer_cast(&P_column_indices[0]);
+    product.Px = 0;
+
+    // bound the length of row i of C by sum_k sum_l nnz(P(l,:))
+    const size_t num_inner_rows = A_row_offsets.size() - 1;
+
+    cusp::array1d<IndexType,cusp::device_memory> P_row_lengths(P_row_offsets.size() - 1);
+    cusp::detail::stream::transform(P_row_offsets.begin() + 1, P_row_offsets.end(), P_row_offsets.begin(),
+                                    P_row_lengths.begin(), thrust::minus<IndexType>());
+
+    cusp::array1d<IndexType,cusp::device_memory> AP_bounds(num_inner_rows);
+    spmm_csr_row_bounds<128>(IndexType(num_inner_rows), product.Ap, product.Aj,
+                             thrust::raw_pointer_cast(&P_row_lengths[0]),
+                             thrust::raw_pointer_cast(&AP_bounds[0]));
+
+    cusp::array1d<IndexType,cusp::device_memory> bounds(num_rows);
+    spmm_csr_row_bounds<128>(IndexType(num_rows), product.Rp, product.Rj,
+                             thrust::raw_pointer_cast(&AP_bounds[0]),
+                             thrust::raw_pointer_cast(&bounds[0]));
+
+    __spmm_csr_symbolic(num_rows, product, bounds, C_row_offsets, C_column_indices);
+}
+
+template <typename Array1, typename Array2, typename Array3, typename Array4,
+          typename Array5, typename Array6, typename Array7, typename Array8,
+          typename Array9, typename Array10, typename Array11, typename Array12>
+void spmm_csr_rap_numeric(const size_t   num_rows,
+                          const Array1&  R_row_offsets,
+                          const Array2&  R_column_indices,
+                          const Array3&  R_values,
+                          const Array4&  A_row_offsets,
+                          const Array5&  A_column_indices,
+                          const Array6&  A_values,
+                          const Array7&  P_row_offsets,
+                          const Array8&  P_column_indices,
+                          const Array9&  P_values,
+                          const Array10& C_row_offsets,
+                          const Array11& C_column_indices,
+                                Array12& C_values)
+{
+    CUSP_PROFILE_SCOPED();
+
+    typedef typename Array10::value_type IndexType;
+    typedef typename Array12::value_type ValueType;
+
+    if (C_column_indices.size() == 0)
+    {
+        C_values.resize(0);
+        return;
+    }
+
+    spmm_product_rap<IndexType,ValueType> product;
+    product.Rp = thrust::raw_pointer_cast(&R_row_offsets[0]);
+    product.Rj = thrust::raw_pointer_cast(&R_column_indices[0]);
+    product.Rx = thrust::raw_pointer_cast(&R_values[0]);
+    product.Ap = thrust::raw_pointer_cast(&A_row_offsets[0]);
+    product.Aj = thrust::raw_pointer_cast(&A_column_indices[0]);
+    product.Ax = thrust::raw_pointer_cast(&A_values[0]);
+    product.Pp = thrust::raw_pointer_cast(&P_row_offsets[0]);
+    product.Pj = thrust::raw_pointer_cast(&P_column_indices[0]);
+    product.Px = thrust::raw_pointer_cast(&P_values[0]);
+
+    __spmm_csr_numeric(num_rows, product, C_row_offsets, C_column_indices, C_values);
+}
+
+template <typename Matrix1,
+          typename Matrix2,
+          typename Matrix3>
+void spmm_csr_symbolic(const Matrix1& A,
+                       const Matrix2& B,
+                             Matrix3& C)
+{
+    C.resize(A.num_rows, B.num_cols, 0);
+
+    spmm_csr_symbolic(A.num_rows,
+                      A.row_offsets, A.column_indices,
+                      B.row_offsets, B.column_indices,
+                      C.row_offsets, C.column_indices);
+
+    C.resize(A.num_rows, B.num_cols, C.column_indices.size());
+}
+
+template <typename Matrix1,
+          typename Matrix2,
+          typename Matrix3>
+void spmm_csr_numeric(const Matrix1& A,
+                      const Matrix2& B,
+                            Matrix3& C)
+{
+    spmm_csr_numeric(A.num_rows,
+                     A.row_offsets, A.column_indices, A.values,
+                     B.row_offsets, B.column_indices, B.values,
+                     C.row_offsets, C.column_indices, C.values);
+}
+
+template <typename Matrix1,
+          typename Matrix2,
+          typename Matrix3>
+void spmm_csr(const Matrix1& A,
+              const Matrix2& B,
+                    Matrix3& C)
+{
+    CUSP_PROFILE_SCOPED();
+
+    spmm_csr_symbolic(A, B, C);
+    spmm_csr_numeric(A, B, C);
+}
+
+template <typename Matrix1,
+          typename Matrix2,
+          typename Matrix3,
+          typename Matrix4>
+void spmm_csr_rap_symbolic(const Matrix1& R,
+                           const Matrix2& A,
+                           const Matrix3& P,
+                                 Matrix4& RAP)
+{
+    RAP.resize(R.num_rows, P.num_cols, 0);
+
+    spmm_csr_rap_symbolic(R.num_rows,
+                          R.row_offsets, R.column_indices,
+                          A.row_offsets, A.column_indices,
+                          P.row_offsets, P.column_indices,
+                          RAP.row_offsets, RAP.column_indices);
+
+    RAP.resize(R.num_rows, P.num_cols, RAP.column_indices.size());
+}
+
+template <typename Matrix1,
+          typename Matrix2,
+          typename Matrix3,
+          typename Matrix4>
+void spmm_csr_rap_numeric(const Matrix1& R,
+                          const Matrix2& A,
+                          const Matrix3& P,
+                                Matrix4& RAP)
+{
+    spmm_csr_rap_numeric(R.num_rows,
+                         R.row_offsets, R.column_indices, R.values,
+                         A.row_offsets, A.column_indices, A.values,
+                         P.row_offsets, P.column_indices, P.values,
+                         RAP.row_offsets, RAP.column_indices, RAP.values);
+}
+
+template <typename Matrix1,
+          typename Matrix2,
+          typename Matrix3,
+          typename Matrix4>
+void spmm_csr_rap(const Matrix1& R,
+                  const Matrix2& A,
+                  const Matrix3& P,
+                        Matrix4& RAP)
+{
+    CUSP_PROFILE_SCOPED();
+
+    spmm_csr_rap_symbolic(R, A, P, RAP);
+    spmm_csr_rap_numeric(R, A, P, RAP);
+}
+
+} // end namespace device
+} // end namespace detail
+} // end namespace cusp
+
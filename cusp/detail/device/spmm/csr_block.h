@@ -0,0 +1,247 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+#pragma once
+
+#include <cusp/array1d.h>
+#include <cusp/array2d.h>
+
+#include <cusp/detail/format_utils.h>
+#include <cusp/detail/device/arch.h>
+#include <cusp/detail/device/common.h>
+#include <cusp/detail/stream.h>
+#include <cusp/detail/device/stream.h>
+#include <cusp/detail/device/utils.h>
+
+#include <thrust/fill.h>
+#include <thrust/device_ptr.h>
+
+namespace cusp
+{
+namespace detail
+{
+namespace device
+{
+
+//////////////////////////////////////////////////////////////////////////////
+// CSR SpMM kernels for dense blocks of vectors (C = A * B, B is array2d)
+//////////////////////////////////////////////////////////////////////////////
+//
+// spmm_csr_block
+//   Each row of A is assigned to a group of THREADS_PER_GROUP threads and
+//   each thread in the group computes the entries of C[row,:] belonging to
+//   the columns lane, lane + THREADS_PER_GROUP, ...  All threads of a group
+//   read the same A(i,j) value and column index, so each nonzero of A is
+//   fetched from memory once (broadcast across the group) and applied to
+//   all columns of B together, rather than once per right-hand side.
+//   Both row-major and column-major B and C are supported; with row-major
+//   storage the reads of B[j,:] and writes of C[i,:] are also coalesced.
+//
+//   Beyond 32 columns a full warp handles each row and every thread keeps
+//   a tile of up to TILE_SIZE = 4 sums in registers, for the columns lane,
+//   lane + 32, lane + 64 and lane + 96.  Up to 128 columns A is therefore
+//   read once, and wider blocks read A once per 128 columns.
+//
+// spmm_coo_block
+//   A COO matrix sorted by row is processed by the same kernel after
+//   compressing its row indices into row offsets.
+//
+//  Note: THREADS_PER_GROUP must be one of [1,2,4,8,16,32] and TILE_SIZE
+//  is larger than one only for groups of 32 threads
+
+template <typename IndexType, typename ValueType, typename Orientation1, typename Orientation2,
+          unsigned int BLOCK_SIZE, unsigned int THREADS_PER_GROUP, unsigned int TILE_SIZE, bool InitializeC>
+__launch_bounds__(BLOCK_SIZE,1)
+__global__ void
+spmm_csr_block_kernel(const IndexType num_rows,
+                      const IndexType num_vectors,
+                      const IndexType * Ap,
+                      const IndexType * Aj,
+                      const ValueType * Ax,
+                      const ValueType * B,
+                      const IndexType   B_pitch,
+                            ValueType * C,
+                      const IndexType   C_pitch)
+{
+    const IndexType thread_id   = BLOCK_SIZE * blockIdx.x + threadIdx.x;    // global thread index
+    const IndexType thread_lane = threadIdx.x & (THREADS_PER_GROUP - 1);   // thread index within the group
+    const IndexType group_id    = thread_id   / THREADS_PER_GROUP;         // global group index
+    const IndexType num_groups  = (BLOCK_SIZE / THREADS_PER_GROUP) * gridDim.x;
+
+    for(IndexType row = group_id; row < num_rows; row += num_groups)
+    {
+        const IndexType row_start = Ap[row];
+        const IndexType row_end   = Ap[row + 1];
+
+        // each pass over the row accumulates TILE_SIZE columns per thread
+        for(IndexType k0 = thread_lane; k0 < num_vectors; k0 += THREADS_PER_GROUP * TILE_SIZE)
+        {
+            ValueType sum[TILE_SIZE];
+
+            for(unsigned int t = 0; t < TILE_SIZE; t++)
+                sum[t] = 0;
+
+            for(IndexType jj = row_start; jj < row_end; jj++)
+            {
+                const IndexType j    = Aj[jj];
+                const ValueType A_ij = Ax[jj];
+
+                for(unsigned int t = 0; t < TILE_SIZE; t++)
+                {
+                    const IndexType k = k0 + t * THREADS_PER_GROUP;
+
+                    if (k < num_vectors)
+                        sum[t] += A_ij * B[cusp::detail::index_of(j, k, B_pitch, Orientation1())];
+                }
+            }
+
+            for(unsigned int t = 0; t < TILE_SIZE; t++)
+            {
+                const IndexType k = k0 + t * THREADS_PER_GROUP;
+
+                if (k < num_vectors)
+                {
+                    const IndexType n = cusp::detail::index_of(row, k, C_pitch, Orientation2());
+
+                    if (InitializeC)
+                        C[n] = sum[t];
+                    else
+                        C[n] += sum[t];
+                }
+            }
+        }
+    }
+}
+
+template <bool InitializeC, unsigned int THREADS_PER_GROUP, unsigned int TILE_SIZE,
+          typename IndexType, typename ValueType, typename Matrix1, typename Matrix2>
+void __spmm_csr_block(const IndexType  num_rows,
+                      const IndexType* Ap,
+                      const IndexType* Aj,
+                      const ValueType* Ax,
+                      const Matrix1&   B,
+                            Matrix2&   C)
+{
+    typedef typename Matrix1::orientation Orientation1;
+    typedef typename Matrix2::orientation Orientation2;
+
+    const size_t BLOCK_SIZE        = 128;
+    const size_t GROUPS_PER_BLOCK  = BLOCK_SIZE / THREADS_PER_GROUP;
+
+    const size_t MAX_BLOCKS = cusp::detail::device::arch::max_active_blocks(spmm_csr_block_kernel<IndexType, ValueType, Orientation1, Orientation2, BLOCK_SIZE, THREADS_PER_GROUP, TILE_SIZE, InitializeC>, BLOCK_SIZE, (size_t) 0);
+    const size_t NUM_BLOCKS = std::min<size_t>(MAX_BLOCKS, DIVIDE_INTO(num_rows, GROUPS_PER_BLOCK));
+
+    spmm_csr_block_kernel<IndexType, ValueType, Orientation1, Orientation2, BLOCK_SIZE, THREADS_PER_GROUP, TILE_SIZE, InitializeC> <<<NUM_BLOCKS, BLOCK_SIZE, 0, cusp::detail::device::current_stream()>>>
+        (num_rows, IndexType(B.num_cols),
+         Ap, Aj, Ax,
+         thrust::raw_pointer_cast(&B.values[0]), IndexType(B.pitch),
+         thrust::raw_pointer_cast(&C.values[0]), IndexType(C.pitch));
+}
+
+template <bool InitializeC,
+          typename IndexType, typename ValueType, typename Matrix1, typename Matrix2>
+void spmm_csr_block(const IndexType  num_rows,
+                    const IndexType* Ap,
+                    const IndexType* Aj,
+                    const ValueType* Ax,
+                    const Matrix1&   B,
+                          Matrix2&   C)
+{
+    if (num_rows == 0 || B.num_cols == 0)
+        return;
+
+    // assign one thread per column of B, up to a full warp per row, and
+    // then several columns per thread
+    const size_t num_vectors = B.num_cols;
+
+    if (num_vectors <=  1) { __spmm_csr_block<InitializeC, 1,1>(num_rows, Ap, Aj, Ax, B, C); return; }
+    if (num_vectors <=  2) { __spmm_csr_block<InitializeC, 2,1>(num_rows, Ap, Aj, Ax, B, C); return; }
+    if (num_vectors <=  4) { __spmm_csr_block<InitializeC, 4,1>(num_rows, Ap, Aj, Ax, B, C); return; }
+    if (num_vectors <=  8) { __spmm_csr_block<InitializeC, 8,1>(num_rows, Ap, Aj, Ax, B, C); return; }
+    if (num_vectors <= 16) { __spmm_csr_block<InitializeC,16,1>(num_rows, Ap, Aj, Ax, B, C); return; }
+    if (num_vectors <= 32) { __spmm_csr_block<InitializeC,32,1>(num_rows, Ap, Aj, Ax, B, C); return; }
+    if (num_vectors <= 64) { __spmm_csr_block<InitializeC,32,2>(num_rows, Ap, Aj, Ax, B, C); return; }
+
+    __spmm_csr_block<InitializeC,32,4>(num_rows, Ap, Aj, Ax, B, C);
+}
+
+template <typename Matrix1,
+          typename Matrix2,
+          typename Matrix3>
+void spmm_csr_block(const Matrix1& A,
+                    const Matrix2& B,
+                          Matrix3& C)
+{
+    typedef typename Matrix1::index_type IndexType;
+    typedef typename Matrix1::value_type ValueType;
+
+    if (A.num_entries == 0)
+    {
+        cusp::detail::stream::fill(C.values.begin(), C.values.end(), ValueType(0));
+        return;
+    }
+
+    spmm_csr_block<true>(IndexType(A.num_rows),
+                         thrust::raw_pointer_cast(&A.row_offsets[0]),
+                         thrust::raw_pointer_cast(&A.column_indices[0]),
+                         thrust::raw_pointer_cast(&A.values[0]),
+                         B, C);
+}
+
+template <bool InitializeC,
+          typename Matrix1,
+          typename Matrix2,
+          typename Matrix3>
+void __spmm_coo_block(const Matrix1& A,
+                      const Matrix2& B,
+                            Matrix3& C)
+{
+    typedef typename Matrix1::index_type IndexType;
+    typedef typename Matrix1::value_type ValueType;
+
+    if (A.num_entries == 0)
+    {
+        if (InitializeC)
+            cusp::detail::stream::fill(C.values.begin(), C.values.end(), ValueType(0));
+        return;
+    }
+
+    // compress the (sorted) row indices
+    cusp::array1d<IndexType,cusp::device_memory> row_offsets(A.num_rows + 1);
+    cusp::detail::indices_to_offsets(A.row_indices, row_offsets);
+
+    spmm_csr_block<InitializeC>(IndexType(A.num_rows),
+                                thrust::raw_pointer_cast(&row_offsets[0]),
+                                thrust::raw_pointer_cast(&A.column_indices[0]),
+                                thrust::raw_pointer_cast(&A.values[0]),
+                                B, C);
+}
+
+template <typename Matrix1,
+          typename Matrix2,
+          typename Matrix3>
+void spmm_coo_block(const Matrix1& A,
+                    const Matrix2& B,
+                          Matrix3& C)
+{
+    __spmm_coo_block<true>(A, B, C);
+}
+
+} // end namespace device
+} // end namespace detail
+} // end namespace cusp
+
@@ -0,0 +1,141 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+#pragma once
+
+#include <cusp/array2d.h>
+#include <cusp/dia_matrix.h>
+
+#include <cusp/detail/device/arch.h>
+#include <cusp/detail/device/common.h>
+#include <cusp/detail/device/stream.h>
+#include <cusp/detail/device/utils.h>
+
+#include <thrust/device_ptr.h>
+
+// SpMM kernel for the DIA matrix format and a dense block of vectors.
+
+namespace cusp
+{
+namespace detail
+{
+namespace device
+{
+
+// Each row of A is assigned to a group of THREADS_PER_GROUP threads which
+// share the value of every diagonal (see spmm_csr_block).  Consecutive
+// groups read consecutive values of a diagonal, and with column-major B
+// and C consecutive rows of each column, so accesses to A, B and C all
+// follow the pitches of the arrays.
+template <typename IndexType, typename ValueType, typename Orientation1, typename Orientation2,
+          unsigned int BLOCK_SIZE, unsigned int THREADS_PER_GROUP>
+__launch_bounds__(BLOCK_SIZE,1)
+__global__ void
+spmm_dia_block_kernel(const IndexType num_rows,
+                      const IndexType num_cols,
+                      const IndexType num_vectors,
+                      const IndexType num_diagonals,
+                      const IndexType * diagonal_offsets,
+                      const ValueType * Ax,
+                      const IndexType   Ax_pitch,
+                      const ValueType * B,
+                      const IndexType   B_pitch,
+                            ValueType * C,
+                      const IndexType   C_pitch)
+{
+    const IndexType thread_id   = BLOCK_SIZE * blockIdx.x + threadIdx.x;    // global thread index
+    const IndexType thread_lane = threadIdx.x & (THREADS_PER_GROUP - 1);   // thread index within the group
+    const IndexType group_id    = thread_id   / THREADS_PER_GROUP;         // global group index
+    const IndexType num_groups  = (BLOCK_SIZE / THREADS_PER_GROUP) * gridDim.x;
+
+    for(IndexType row = group_id; row < num_rows; row += num_groups)
+    {
+        for(IndexType k = thread_lane; k < num_vectors; k += THREADS_PER_GROUP)
+        {
+            ValueType sum = 0;
+
+            IndexType offset = row;
+
+            for(IndexType n = 0; n < num_diagonals; n++)
+            {
+                const IndexType col = row + diagonal_offsets[n];
+
+                if (col >= 0 && col < num_cols)
+                    sum += Ax[offset] * B[cusp::detail::index_of(col, k, B_pitch, Orientation1())];
+
+                offset += Ax_pitch;
+            }
+
+            C[cusp::detail::index_of(row, k, C_pitch, Orientation2())] = sum;
+        }
+    }
+}
+
+template <unsigned int THREADS_PER_GROUP,
+          typename Matrix1,
+          typename Matrix2,
+          typename Matrix3>
+void __spmm_dia_block(const Matrix1& A,
+                      const Matrix2& B,
+                            Matrix3& C)
+{
+    typedef typename Matrix1::index_type  IndexType;
+    typedef typename Matrix1::value_type  ValueType;
+    typedef typename Matrix2::orientation Orientation1;
+    typedef typename Matrix3::orientation Orientation2;
+
+    const size_t BLOCK_SIZE       = 128;
+    const size_t GROUPS_PER_BLOCK = BLOCK_SIZE / THREADS_PER_GROUP;
+
+    const size_t MAX_BLOCKS = cusp::detail::device::arch::max_active_blocks(spmm_dia_block_kernel<IndexType, ValueType, Orientation1, Orientation2, BLOCK_SIZE, THREADS_PER_GROUP>, BLOCK_SIZE, (size_t) 0);
+    const size_t NUM_BLOCKS = std::min<size_t>(MAX_BLOCKS, DIVIDE_INTO(A.num_rows, GROUPS_PER_BLOCK));
+
+    spmm_dia_block_kernel<IndexType, ValueType, Orientation1, Orientation2, BLOCK_SIZE, THREADS_PER_GROUP> <<<NUM_BLOCKS, BLOCK_SIZE, 0, cusp::detail::device::current_stream()>>>
+        (IndexType(A.num_rows), IndexType(A.num_cols), IndexType(B.num_cols),
+         IndexType(A.diagonal_offsets.size()),
+         thrust::raw_pointer_cast(&A.diagonal_offsets[0]),
+         thrust::raw_pointer_cast(&A.values.values[0]), IndexType(A.values.pitch),
+         thrust::raw_pointer_cast(&B.values[0]), IndexType(B.pitch),
+         thrust::raw_pointer_cast(&C.values[0]), IndexType(C.pitch));
+}
+
+template <typename Matrix1,
+          typename Matrix2,
+          typename Matrix3>
+void spmm_dia_block(const Matrix1& A,
+                    const Matrix2& B,
+                          Matrix3& C)
+{
+    if (A.num_rows == 0 || B.num_cols == 0)
+        return;
+
+    // assign one thread per column of B, up to a full warp per row
+    const size_t num_vectors = B.num_cols;
+
+    if (num_vectors <=  1) { __spmm_dia_block< 1>(A, B, C); return; }
+    if (num_vectors <=  2) { __spmm_dia_block< 2>(A, B, C); return; }
+    if (num_vectors <=  4) { __spmm_dia_block< 4>(A, B, C); return; }
+    if (num_vectors <=  8) { __spmm_dia_block< 8>(A, B, C); return; }
+    if (num_vectors <= 16) { __spmm_dia_block<16>(A, B, C); return; }
+
+    __spmm_dia_block<32>(A, B, C);
+}
+
+} // end namespace device
+} // end namespace detail
+} // end namespace cusp
+
@@ -0,0 +1,169 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+#pragma once
+
+#include <cusp/array2d.h>
+#include <cusp/ell_matrix.h>
+
+#include <cusp/detail/device/arch.h>
+#include <cusp/detail/device/common.h>
+#include <cusp/detail/device/stream.h>
+#include <cusp/detail/device/utils.h>
+
+#include <thrust/device_ptr.h>
+
+// SpMM kernel for the ELLPACK/ITPACK matrix format and a dense block of vectors.
+
+namespace cusp
+{
+namespace detail
+{
+namespace device
+{
+
+// Each row of A is assigned to a group of THREADS_PER_GROUP threads which
+// share the column index and value of every entry, and each thread keeps
+// TILE_SIZE sums in registers (see spmm_csr_block).  The column indices
+// and values of A may have different pitches.
+template <typename IndexType, typename ValueType, typename Orientation1, typename Orientation2,
+          unsigned int BLOCK_SIZE, unsigned int THREADS_PER_GROUP, unsigned int TILE_SIZE>
+__launch_bounds__(BLOCK_SIZE,1)
+__global__ void
+spmm_ell_block_kernel(const IndexType num_rows,
+                      const IndexType num_vectors,
+                      const IndexType num_cols_per_row,
+                      const IndexType * Aj,
+                      const IndexType   Aj_pitch,
+                      const ValueType * Ax,
+                      const IndexType   Ax_pitch,
+                      const ValueType * B,
+                      const IndexType   B_pitch,
+                            ValueType * C,
+                      const IndexType   C_pitch)
+{
+    const IndexType invalid_index = cusp::ell_matrix<IndexType, ValueType, cusp::device_memory>::invalid_index;
+
+    const IndexType thread_id   = BLOCK_SIZE * blockIdx.x + threadIdx.x;    // global thread index
+    const IndexType thread_lane = threadIdx.x & (THREADS_PER_GROUP - 1);   // thread index within the group
+    const IndexType group_id    = thread_id   / THREADS_PER_GROUP;         // global group index
+    const IndexType num_groups  = (BLOCK_SIZE / THREADS_PER_GROUP) * gridDim.x;
+
+    for(IndexType row = group_id; row < num_rows; row += num_groups)
+    {
+        // each pass over the row accumulates TILE_SIZE columns per thread
+        for(IndexType k0 = thread_lane; k0 < num_vectors; k0 += THREADS_PER_GROUP * TILE_SIZE)
+        {
+            ValueType sum[TILE_SIZE];
+
+            for(unsigned int t = 0; t < TILE_SIZE; t++)
+                sum[t] = 0;
+
+            IndexType j_offset = row;
+            IndexType x_offset = row;
+
+            for(IndexType n = 0; n < num_cols_per_row; n++)
+            {
+                const IndexType col = Aj[j_offset];
+
+                if (col != invalid_index)
+                {
+                    const ValueType A_ij = Ax[x_offset];
+
+                    for(unsigned int t = 0; t < TILE_SIZE; t++)
+                    {
+                        const IndexType k = k0 + t * THREADS_PER_GROUP;
+
+                        if (k < num_vectors)
+                            sum[t] += A_ij * B[cusp::detail::index_of(col, k, B_pitch, Orientation1())];
+                    }
+                }
+
+                j_offset += Aj_pitch;
+                x_offset += Ax_pitch;
+            }
+
+            for(unsigned int t = 0; t < TILE_SIZE; t++)
+            {
+                const IndexType k = k0 + t * THREADS_PER_GROUP;
+
+                if (k < num_vectors)
+                    C[cusp::detail::index_of(row, k, C_pitch, Orientation2())] = sum[t];
+            }
+        }
+    }
+}
+
+template <unsigned int THREADS_PER_GROUP, unsigned int TILE_SIZE,
+          typename Matrix1,
+          typename Matrix2,
+          typename Matrix3>
+void __spmm_ell_block(const Matrix1& A,
+                      const Matrix2& B,
+                            Matrix3& C)
+{
+    typedef typename Matrix1::index_type  IndexType;
+    typedef typename Matrix1::value_type  ValueType;
+    typedef typename Matrix2::orientation Orientation1;
+    typedef typename Matrix3::orientation Orientation2;
+
+    const size_t BLOCK_SIZE       = 128;
+    const size_t GROUPS_PER_BLOCK = BLOCK_SIZE / THREADS_PER_GROUP;
+
+    const size_t MAX_BLOCKS = cusp::detail::device::arch::max_active_blocks(spmm_ell_block_kernel<IndexType, ValueType, Orientation1, Orientation2, BLOCK_SIZE, THREADS_PER_GROUP, TILE_SIZE>, BLOCK_SIZE, (size_t) 0);
+    const size_t NUM_BLOCKS = std::min<size_t>(MAX_BLOCKS, DIVIDE_INTO(A.num_rows, GROUPS_PER_BLOCK));
+
+    const IndexType num_entries_per_row = A.column_indices.num_cols;
+
+    spmm_ell_block_kernel<IndexType, ValueType, Orientation1, Orientation2, BLOCK_SIZE, THREADS_PER_GROUP, TILE_SIZE> <<<NUM_BLOCKS, BLOCK_SIZE, 0, cusp::detail::device::current_stream()>>>
+        (IndexType(A.num_rows), IndexType(B.num_cols),
+         num_entries_per_row,
+         thrust::raw_pointer_cast(&A.column_indices.values[0]), IndexType(A.column_indices.pitch),
+         thrust::raw_pointer_cast(&A.values.values[0]),         IndexType(A.values.pitch),
+         thrust::raw_pointer_cast(&B.values[0]), IndexType(B.pitch),
+         thrust::raw_pointer_cast(&C.values[0]), IndexType(C.pitch));
+}
+
+template <typename Matrix1,
+          typename Matrix2,
+          typename Matrix3>
+void spmm_ell_block(const Matrix1& A,
+                    const Matrix2& B,
+                          Matrix3& C)
+{
+    if (A.num_rows == 0 || B.num_cols == 0)
+        return;
+
+    // assign one thread per column of B, up to a full warp per row, and
+    // then up to four columns per thread (A is read once per 128 columns)
+    const size_t num_vectors = B.num_cols;
+
+    if (num_vectors <=  1) { __spmm_ell_block< 1,1>(A, B, C); return; }
+    if (num_vectors <=  2) { __spmm_ell_block< 2,1>(A, B, C); return; }
+    if (num_vectors <=  4) { __spmm_ell_block< 4,1>(A, B, C); return; }
+    if (num_vectors <=  8) { __spmm_ell_block< 8,1>(A, B, C); return; }
+    if (num_vectors <= 16) { __spmm_ell_block<16,1>(A, B, C); return; }
+    if (num_vectors <= 32) { __spmm_ell_block<32,1>(A, B, C); return; }
+    if (num_vectors <= 64) { __spmm_ell_block<32,2>(A, B, C); return; }
+
+    __spmm_ell_block<32,4>(A, B, C);
+}
+
+} // end namespace device
+} // end namespace detail
+} // end namespace cusp
+
@@ -15,10 +15,10 @@
  */
 
 
-
 #pragma once
 
-#include <cusp/detail/device/spmv/coo_flat.h>
+#include <cusp/detail/device/spmm/ell_block.h>
+#include <cusp/detail/device/spmm/csr_block.h>
 
 namespace cusp
 {
@@ -27,20 +27,16 @@ namespace detail
 namespace device
 {
 
-template <typename IndexType, typename ValueType>
-void spmv(const coo_matrix<IndexType,ValueType,cusp::device_memory>& coo, 
-          const ValueType * x, 
-                ValueType * y)
-{ 
-    spmv_coo_flat(coo, x, y);
-}
-
-template <typename IndexType, typename ValueType>
-void spmv_tex(const coo_matrix<IndexType,ValueType,cusp::device_memory>& coo, 
-              const ValueType * x, 
-                    ValueType * y)
-{ 
-    spmv_coo_flat_tex(coo, x, y);
+template <typename Matrix1,
+          typename Matrix2,
+          typename Matrix3>
+void spmm_hyb_block(const Matrix1& A,
+                    const Matrix2& B,
+                          Matrix3& C)
+{
+    // C = A.ell * B, then C += A.coo * B
+    spmm_ell_block(A.ell, B, C);
+    __spmm_coo_block<false>(A.coo, B, C);
 }
 
 } // end namespace device
@@ -0,0 +1,239 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+#pragma once
+
+#include <cusp/array1d.h>
+
+#include <cusp/detail/device/generalized_multiply.h>
+
+#include <thrust/binary_search.h>
+#include <thrust/copy.h>
+#include <thrust/count.h>
+#include <thrust/fill.h>
+#include <thrust/functional.h>
+#include <thrust/reduce.h>
+#include <thrust/scan.h>
+#include <thrust/scatter.h>
+#include <thrust/sort.h>
+#include <thrust/transform.h>
+#include <thrust/tuple.h>
+#include <thrust/iterator/constant_iterator.h>
+#include <thrust/iterator/counting_iterator.h>
+#include <thrust/iterator/zip_iterator.h>
+
+// Products of CSR matrices with sparse vectors.  A push expands the
+// columns matching the entries of x into (row, value) pairs with one
+// thread per pair, whatever the column lengths, and reduces them by row
+// after a sort.  A pull expands x into a dense vector with a presence
+// mask and runs the generalized CSR kernel over the rows to compute.
+
+namespace cusp
+{
+namespace detail
+{
+namespace device
+{
+
+template <typename IndexType>
+struct spmspv_column_length
+{
+    const IndexType * offsets;
+
+    spmspv_column_length(const IndexType * offsets)
+      : offsets(offsets) {}
+
+    __host__ __device__
+    IndexType operator()(const IndexType& j) const
+    {
+        return offsets[j + 1] - offsets[j];
+    }
+};
+
+// pair s of the expansion lies in the column of entry n = owner - 1 of x,
+// rows which are masked out receive the key num_rows
+template <typename IndexType, typename MatrixValueType, typename InputType, typename ValueType, typename MaskType, typename BinaryFunction>
+struct spmspv_expand
+{
+    typedef thrust::tuple<IndexType,ValueType> result_type;
+
+    IndexType num_rows;
+    const IndexType * starts;
+    const IndexType * x_indices;
+    const InputType * x_values;
+    const IndexType * Cp;
+    const IndexType * Cj;
+    const MatrixValueType * Cx;
+    const MaskType * mask;
+    BinaryFunction combine;
+
+    spmspv_expand(IndexType num_rows, const IndexType * starts,
+                  const IndexType * x_indices, const InputType * x_values,
+                  const IndexType * Cp, const IndexType * Cj, const MatrixValueType * Cx,
+                  const MaskType * mask, BinaryFunction combine)
+      : num_rows(num_rows), starts(starts), x_indices(x_indices), x_values(x_values),
+        Cp(Cp), Cj(Cj), Cx(Cx), mask(mask), combine(combine) {}
+
+    template <typename Tuple>
+    __host__ __device__
+    result_type operator()(const Tuple& t) const
+    {
+        const IndexType s  = thrust::get<0>(t);
+        const IndexType n  = thrust::get<1>(t) - 1;
+        const IndexType jj = Cp[x_indices[n]] + (s - starts[n]);
+        const IndexType i  = Cj[jj];
+
+        if (mask && mask[i] == MaskType(0))
+            return result_type(num_rows, ValueType());
+
+        return result_type(i, combine(Cx[jj], x_values[n]));
+    }
+};
+
+template <typename Array>
+const typename Array::value_type * spmspv_mask_pointer(const Array* mask)
+{
+    return mask ? thrust::raw_pointer_cast(&(*mask)[0]) : (const typename Array::value_type *) 0;
+}
+
+// C holds the columns of A as its rows
+template <typename Matrix, typename SparseVector1, typename Array, typename SparseVector2,
+          typename BinaryFunction1, typename BinaryFunction2>
+void spmspv_push(const Matrix& C, size_t num_rows,
+                 const SparseVector1& x, const Array* mask, SparseVector2& y,
+                 BinaryFunction1 combine, BinaryFunction2 reduce)
+{
+    typedef typename Matrix::index_type        IndexType;
+    typedef typename Matrix::value_type        MatrixValueType;
+    typedef typename SparseVector1::value_type InputType;
+    typedef typename SparseVector2::value_type ValueType;
+    typedef typename Array::value_type         MaskType;
+
+    const size_t num_entries = x.num_entries;
+
+    if (num_entries == 0)
+    {
+        y.resize(num_rows, 0);
+        return;
+    }
+
+    // offsets of the columns of the entries of x in the expansion
+    cusp::array1d<IndexType,cusp::device_memory> starts(num_entries + 1, IndexType(0));
+    thrust::transform(x.indices.begin(), x.indices.end(), starts.begin(),
+                      spmspv_column_length<IndexType>(thrust::raw_pointer_cast(&C.row_offsets[0])));
+    thrust::exclusive_scan(starts.begin(), starts.end(), starts.begin());
+
+    const IndexType num_pairs = starts[num_entries];
+
+    if (num_pairs == 0)
+    {
+        y.resize(num_rows, 0);
+        return;
+    }
+
+    cusp::array1d<IndexType,cusp::device_memory> owners(num_pairs);
+    thrust::upper_bound(starts.begin(), starts.end(),
+                        thrust::counting_iterator<IndexType>(0),
+                        thrust::counting_iterator<IndexType>(num_pairs),
+                        owners.begin());
+
+    cusp::array1d<IndexType,cusp::device_memory> rows(num_pairs);
+    cusp::array1d<ValueType,cusp::device_memory> vals(num_pairs);
+
+    thrust::transform(thrust::make_zip_iterator(thrust::make_tuple(thrust::counting_iterator<IndexType>(0), owners.begin())),
+                      thrust::make_zip_iterator(thrust::make_tuple(thrust::counting_iterator<IndexType>(num_pairs), owners.end())),
+                      thrust::make_zip_iterator(thrust::make_tuple(rows.begin(), vals.begin())),
+                      spmspv_expand<IndexType,MatrixValueType,InputType,ValueType,MaskType,BinaryFunction1>
+                          (IndexType(num_rows),
+                           thrust::raw_pointer_cast(&starts[0]),
+                           thrust::raw_pointer_cast(&x.indices[0]),
+                           thrust::raw_pointer_cast(&x.values[0]),
+                           thrust::raw_pointer_cast(&C.row_offsets[0]),
+                           thrust::raw_pointer_cast(&C.column_indices[0]),
+                           thrust::raw_pointer_cast(&C.values[0]),
+                           spmspv_mask_pointer(mask), combine));
+
+    // the masked out pairs are sorted to the end
+    thrust::sort_by_key(rows.begin(), rows.end(), vals.begin());
+
+    cusp::array1d<ValueType,cusp::device_memory> sums(num_pairs);
+
+    size_t num_outputs =
+        thrust::reduce_by_key(rows.begin(), rows.end(), vals.begin(),
+                              owners.begin(), sums.begin(),
+                              thrust::equal_to<IndexType>(), reduce).first - owners.begin();
+
+    if (owners[num_outputs - 1] == IndexType(num_rows))
+        num_outputs--;
+
+    y.resize(num_rows, num_outputs);
+    thrust::copy(owners.begin(), owners.begin() + num_outputs, y.indices.begin());
+    thrust::copy(sums.begin(),   sums.begin()   + num_outputs, y.values.begin());
+}
+
+template <typename Matrix, typename SparseVector1, typename Array, typename SparseVector2,
+          typename BinaryFunction1, typename BinaryFunction2>
+void spmspv_pull(const Matrix& A,
+                 const SparseVector1& x, const Array* mask, SparseVector2& y,
+                 BinaryFunction1 combine, BinaryFunction2 reduce)
+{
+    typedef typename Matrix::index_type        IndexType;
+    typedef typename SparseVector1::value_type InputType;
+    typedef typename SparseVector2::value_type ValueType;
+
+    if (A.num_rows == 0)
+    {
+        y.resize(0, 0);
+        return;
+    }
+
+    // expand x
+    cusp::array1d<InputType,cusp::device_memory>     x_dense(A.num_cols);
+    cusp::array1d<unsigned char,cusp::device_memory> present(A.num_cols, 0);
+
+    thrust::scatter(x.values.begin(), x.values.end(), x.indices.begin(), x_dense.begin());
+    thrust::scatter(thrust::constant_iterator<unsigned char>(1),
+                    thrust::constant_iterator<unsigned char>(1) + x.num_entries,
+                    x.indices.begin(), present.begin());
+
+    cusp::array1d<ValueType,cusp::device_memory>     y_dense(A.num_rows);
+    cusp::array1d<unsigned char,cusp::device_memory> valid(A.num_rows, 0);
+
+    generalized_spmv_csr_vector(IndexType(A.num_rows), IndexType(A.num_cols), IndexType(A.num_entries),
+                                thrust::raw_pointer_cast(&A.row_offsets[0]),
+                                thrust::raw_pointer_cast(&A.column_indices[0]),
+                                thrust::raw_pointer_cast(&A.values[0]),
+                                thrust::raw_pointer_cast(&x_dense[0]),
+                                thrust::raw_pointer_cast(&present[0]),
+                                spmspv_mask_pointer(mask),
+                                thrust::raw_pointer_cast(&valid[0]),
+                                thrust::raw_pointer_cast(&y_dense[0]),
+                                thrust::identity<ValueType>(), combine, reduce);
+
+    const size_t num_outputs = thrust::count(valid.begin(), valid.end(), (unsigned char) 1);
+
+    y.resize(A.num_rows, num_outputs);
+    thrust::copy_if(thrust::counting_iterator<IndexType>(0),
+                    thrust::counting_iterator<IndexType>(A.num_rows),
+                    valid.begin(), y.indices.begin(), thrust::identity<unsigned char>());
+    thrust::copy_if(y_dense.begin(), y_dense.end(),
+                    valid.begin(), y.values.begin(), thrust::identity<unsigned char>());
+}
+
+} // end namespace device
+} // end namespace detail
+} // end namespace cusp
@@ -0,0 +1,177 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+#pragma once
+
+#include <cusp/array2d.h>
+
+#include <cusp/detail/device/arch.h>
+#include <cusp/detail/device/common.h>
+#include <cusp/detail/device/stream.h>
+#include <cusp/detail/device/utils.h>
+
+#include <thrust/device_ptr.h>
+
+namespace cusp
+{
+namespace detail
+{
+namespace device
+{
+
+//////////////////////////////////////////////////////////////////////////////
+// Dense matrix-vector multiply kernels (y = A * x, A is array2d)
+//////////////////////////////////////////////////////////////////////////////
+//
+// spmv_array2d (column-major)
+//   Each row is assigned to a thread.  Consecutive threads read
+//   consecutive entries of a column, so accesses to A are coalesced.
+//
+// spmv_array2d (row-major)
+//   Each row is assigned to a warp which computes the dot product of
+//   the row with x, as in spmv_csr_vector.  This code relies on implicit
+//   synchronization among threads in a warp.
+
+template <typename IndexType, typename ValueType, unsigned int BLOCK_SIZE>
+__launch_bounds__(BLOCK_SIZE,1)
+__global__ void
+spmv_array2d_column_major_kernel(const IndexType num_rows,
+                                 const IndexType num_cols,
+                                 const IndexType pitch,
+                                 const ValueType * A,
+                                 const ValueType * x,
+                                       ValueType * y)
+{
+    const IndexType thread_id = BLOCK_SIZE * blockIdx.x + threadIdx.x;
+    const IndexType grid_size = BLOCK_SIZE * gridDim.x;
+
+    for(IndexType row = thread_id; row < num_rows; row += grid_size)
+    {
+        ValueType sum = 0;
+
+        IndexType offset = row;
+
+        for(IndexType j = 0; j < num_cols; j++)
+        {
+            sum += A[offset] * x[j];
+            offset += pitch;
+        }
+
+        y[row] = sum;
+    }
+}
+
+template <typename IndexType, typename ValueType, unsigned int VECTORS_PER_BLOCK>
+__launch_bounds__(VECTORS_PER_BLOCK * WARP_SIZE,1)
+__global__ void
+spmv_array2d_row_major_kernel(const IndexType num_rows,
+                              const IndexType num_cols,
+                              const IndexType pitch,
+                              const ValueType * A,
+                              const ValueType * x,
+                                    ValueType * y)
+{
+    __shared__ volatile ValueType sdata[VECTORS_PER_BLOCK * WARP_SIZE + WARP_SIZE / 2];  // padded to avoid reduction conditionals
+
+    const IndexType THREADS_PER_BLOCK = VECTORS_PER_BLOCK * WARP_SIZE;
+
+    const IndexType thread_id   = THREADS_PER_BLOCK * blockIdx.x + threadIdx.x;    // global thread index
+    const IndexType thread_lane = threadIdx.x & (WARP_SIZE - 1);                   // thread index within the warp
+    const IndexType warp_id     = thread_id   / WARP_SIZE;                         // global warp index
+    const IndexType num_warps   = VECTORS_PER_BLOCK * gridDim.x;                   // total number of active warps
+
+    for(IndexType row = warp_id; row < num_rows; row += num_warps)
+    {
+        const ValueType * A_row = A + row * pitch;
+
+        ValueType sum = 0;
+
+        for(IndexType j = thread_lane; j < num_cols; j += WARP_SIZE)
+            sum += A_row[j] * x[j];
+
+        // store local sum in shared memory
+        sdata[threadIdx.x] = sum;
+        
+        // reduce local sums to row sum
+        sdata[threadIdx.x] = sum = sum + sdata[threadIdx.x + 16];
+        sdata[threadIdx.x] = sum = sum + sdata[threadIdx.x +  8];
+        sdata[threadIdx.x] = sum = sum + sdata[threadIdx.x +  4];
+        sdata[threadIdx.x] = sum = sum + sdata[threadIdx.x +  2];
+        sdata[threadIdx.x] = sum = sum + sdata[threadIdx.x +  1];
+
+        // first thread writes the result
+        if (thread_lane == 0)
+            y[row] = sdata[threadIdx.x];
+    }
+}
+
+template <typename Matrix,
+          typename ValueType>
+void spmv_array2d(const Matrix&    A,
+                  const ValueType* x,
+                        ValueType* y,
+                  cusp::column_major)
+{
+    typedef int IndexType;
+
+    const size_t BLOCK_SIZE = 256;
+    const size_t MAX_BLOCKS = cusp::detail::device::arch::max_active_blocks(spmv_array2d_column_major_kernel<IndexType, ValueType, BLOCK_SIZE>, BLOCK_SIZE, (size_t) 0);
+    const size_t NUM_BLOCKS = std::min<size_t>(MAX_BLOCKS, DIVIDE_INTO(A.num_rows, BLOCK_SIZE));
+
+    spmv_array2d_column_major_kernel<IndexType, ValueType, BLOCK_SIZE> <<<NUM_BLOCKS, BLOCK_SIZE, 0, cusp::detail::device::current_stream()>>>
+        (IndexType(A.num_rows), IndexType(A.num_cols), IndexType(A.pitch),
+         thrust::raw_pointer_cast(&A.values[0]),
+         x, y);
+}
+
+template <typename Matrix,
+          typename ValueType>
+void spmv_array2d(const Matrix&    A,
+                  const ValueType* x,
+                        ValueType* y,
+                  cusp::row_major)
+{
+    typedef int IndexType;
+
+    const size_t VECTORS_PER_BLOCK = 4;
+    const size_t THREADS_PER_BLOCK = VECTORS_PER_BLOCK * WARP_SIZE;
+
+    const size_t MAX_BLOCKS = cusp::detail::device::arch::max_active_blocks(spmv_array2d_row_major_kernel<IndexType, ValueType, VECTORS_PER_BLOCK>, THREADS_PER_BLOCK, (size_t) 0);
+    const size_t NUM_BLOCKS = std::min<size_t>(MAX_BLOCKS, DIVIDE_INTO(A.num_rows, VECTORS_PER_BLOCK));
+
+    spmv_array2d_row_major_kernel<IndexType, ValueType, VECTORS_PER_BLOCK> <<<NUM_BLOCKS, THREADS_PER_BLOCK, 0, cusp::detail::device::current_stream()>>>
+        (IndexType(A.num_rows), IndexType(A.num_cols), IndexType(A.pitch),
+         thrust::raw_pointer_cast(&A.values[0]),
+         x, y);
+}
+
+template <typename Matrix,
+          typename ValueType>
+void spmv_array2d(const Matrix&    A,
+                  const ValueType* x,
+                        ValueType* y)
+{
+    if (A.num_rows == 0)
+        return;
+
+    spmv_array2d(A, x, y, typename Matrix::orientation());
+}
+
+} // end namespace device
+} // end namespace detail
+} // end namespace cusp
+
@@ -0,0 +1,149 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include <cusp/detail/device/arch.h>
+#include <cusp/detail/device/common.h>
+#include <cusp/detail/device/stream.h>
+#include <cusp/detail/device/utils.h>
+
+#include <thrust/device_ptr.h>
+
+#include <algorithm>
+
+// SpMV with the tiles of a bitmap_tile_operator (cusp/bitmap_tile_operator.h).
+//
+// A tile covers BITMAP_TILE_SIZE x BITMAP_TILE_SIZE entries and bit
+// r * BITMAP_TILE_SIZE + c of its bitmap is set when entry (r,c) is stored.
+// The values of a tile are packed in the order of the bits, so the values
+// of row r start after the bits of the rows above it, which one popcount
+// of the bitmap finds.  One thread per row of the matrix walks the tiles
+// of its tile row and adds its sum to y, which holds the product of the
+// remainder already, so no row is shared between threads.
+
+namespace cusp
+{
+namespace detail
+{
+namespace device
+{
+
+const unsigned int BITMAP_TILE_SIZE = 8;
+
+__host__ __device__
+inline unsigned int bitmap_popcount(unsigned long long v)
+{
+#ifdef __CUDA_ARCH__
+    return __popcll(v);
+#else
+    v = v - ((v >> 1) & 0x5555555555555555ull);
+    v = (v & 0x3333333333333333ull) + ((v >> 2) & 0x3333333333333333ull);
+    v = (v + (v >> 4)) & 0x0f0f0f0f0f0f0f0full;
+    return (unsigned int) ((v * 0x0101010101010101ull) >> 56);
+#endif
+}
+
+template <typename IndexType, typename ValueType, typename MatrixValueType>
+__host__ __device__
+ValueType bitmap_tile_row(const IndexType row,
+                          const IndexType * Tp,
+                          const IndexType * Tj,
+                          const unsigned long long * Tb,
+                          const IndexType * To,
+                          const MatrixValueType * Tx,
+                          const ValueType * x)
+{
+    const IndexType S = BITMAP_TILE_SIZE;
+
+    const IndexType tile_row = row / S;
+    const unsigned int shift = (unsigned int) (row - tile_row * S) * S;
+
+    // bits of the rows above this one within a tile
+    const unsigned long long above = (1ull << shift) - 1;
+
+    ValueType sum = ValueType(0);
+
+    for (IndexType k = Tp[tile_row]; k < Tp[tile_row + 1]; k++)
+    {
+        const unsigned long long bitmap = Tb[k];
+        const unsigned int bits = (unsigned int) (bitmap >> shift) & ((1u << S) - 1);
+
+        if (bits == 0)
+            continue;
+
+        const MatrixValueType * values = Tx + To[k] + bitmap_popcount(bitmap & above);
+        const ValueType * x_tile = x + Tj[k] * S;
+
+        IndexType n = 0;
+
+        for (IndexType c = 0; c < S; c++)
+            if ((bits >> c) & 1)
+                sum += ValueType(values[n++]) * x_tile[c];
+    }
+
+    return sum;
+}
+
+template <typename IndexType, typename ValueType, typename MatrixValueType, unsigned int BLOCK_SIZE>
+__launch_bounds__(BLOCK_SIZE,1)
+__global__ void
+spmv_bitmap_tile_kernel(const IndexType num_rows,
+                        const IndexType * Tp,
+                        const IndexType * Tj,
+                        const unsigned long long * Tb,
+                        const IndexType * To,
+                        const MatrixValueType * Tx,
+                        const ValueType * x,
+                              ValueType * y)
+{
+    const IndexType thread_id = BLOCK_SIZE * blockIdx.x + threadIdx.x;
+    const IndexType grid_size = BLOCK_SIZE * gridDim.x;
+
+    for (IndexType row = thread_id; row < num_rows; row += grid_size)
+        y[row] += bitmap_tile_row(row, Tp, Tj, Tb, To, Tx, x);
+}
+
+template <typename Matrix, typename ValueType>
+void spmv_bitmap_tile(const Matrix&    A,
+                      const ValueType* x,
+                            ValueType* y)
+{
+    typedef typename Matrix::index_type IndexType;
+    typedef typename Matrix::value_type MatrixValueType;
+
+    if (A.tile_bitmaps.empty())
+        return;
+
+    const IndexType num_rows = A.num_rows;
+
+    const unsigned int BLOCK_SIZE = 256;
+    const size_t MAX_BLOCKS = cusp::detail::device::arch::max_active_blocks(spmv_bitmap_tile_kernel<IndexType, ValueType, MatrixValueType, BLOCK_SIZE>, BLOCK_SIZE, (size_t) 0);
+    const size_t NUM_BLOCKS = std::min<size_t>(MAX_BLOCKS, DIVIDE_INTO(num_rows, BLOCK_SIZE));
+
+    spmv_bitmap_tile_kernel<IndexType, ValueType, MatrixValueType, BLOCK_SIZE> <<<NUM_BLOCKS, BLOCK_SIZE, 0, cusp::detail::device::current_stream()>>>
+        (num_rows,
+         thrust::raw_pointer_cast(&A.tile_row_offsets[0]),
+         thrust::raw_pointer_cast(&A.tile_column_indices[0]),
+         thrust::raw_pointer_cast(&A.tile_bitmaps[0]),
+         thrust::raw_pointer_cast(&A.tile_value_offsets[0]),
+         thrust::raw_pointer_cast(&A.tile_values[0]),
+         x, y);
+}
+
+} // end namespace device
+} // end namespace detail
+} // end namespace cusp
@@ -0,0 +1,160 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+#pragma once
+
+#include <cusp/detail/stream.h>
+#include <cusp/detail/device/arch.h>
+#include <cusp/detail/device/common.h>
+#include <cusp/detail/device/stream.h>
+#include <cusp/detail/device/utils.h>
+#include <cusp/detail/device/texture.h>
+#include <cusp/detail/device/unrolled_widths.h>
+
+#include <thrust/device_ptr.h>
+
+// SpMV kernel for the Block Sparse Row (BSR) matrix format.
+//
+// One thread per row of the matrix.  The threads of a block row walk the
+// same blocks, so they read the block entries from one contiguous range and
+// share the column index and the entries of x.  The block size is a template
+// parameter for the sizes of CUSP_BSR_UNROLLED_SIZES (1 to 6 by default),
+// which unrolls the loop over the block row; BSR_SIZE == 0 reads the block
+// size at runtime.
+
+namespace cusp
+{
+namespace detail
+{
+namespace device
+{
+
+template <typename IndexType, typename ValueType, unsigned int BSR_SIZE, size_t BLOCK_SIZE, bool UseCache>
+__launch_bounds__(BLOCK_SIZE,1)
+__global__ void
+spmv_bsr_kernel(const IndexType num_rows,
+                const IndexType block_size,
+                const IndexType * Ap,
+                const IndexType * Aj,
+                const ValueType * Ax,
+                const cached_x<ValueType> x,
+                      ValueType * y)
+{
+    const IndexType bs = BSR_SIZE > 0 ? IndexType(BSR_SIZE) : block_size;
+
+    const IndexType thread_id = blockDim.x * blockIdx.x + threadIdx.x;
+    const IndexType grid_size = gridDim.x * blockDim.x;
+
+    for(IndexType row = thread_id; row < num_rows; row += grid_size)
+    {
+        const IndexType block_row = row / bs;
+        const IndexType r         = row - block_row * bs;
+
+        const IndexType row_start = Ap[block_row];
+        const IndexType row_end   = Ap[block_row + 1];
+
+        ValueType sum = 0;
+
+        for(IndexType k = row_start; k < row_end; k++)
+        {
+            const IndexType   col = Aj[k] * bs;
+            const ValueType * Ak  = Ax + (k * bs + r) * bs;
+
+#pragma unroll
+            for(IndexType c = 0; c < bs; c++)
+                sum += Ak[c] * fetch_x<UseCache>(col + c, x);
+        }
+
+        y[row] = sum;
+    }
+}
+
+
+template <bool UseCache,
+          unsigned int BSR_SIZE,
+          typename Matrix,
+          typename ValueType>
+void __spmv_bsr_launch(const Matrix&    A,
+                       const ValueType* x,
+                             ValueType* y)
+{
+    typedef typename Matrix::index_type IndexType;
+
+    const size_t BLOCK_SIZE = 256;
+    const size_t MAX_BLOCKS = cusp::detail::device::arch::max_active_blocks(spmv_bsr_kernel<IndexType,ValueType,BSR_SIZE,BLOCK_SIZE,UseCache>, BLOCK_SIZE, (size_t) 0);
+    const size_t NUM_BLOCKS = std::min<size_t>(MAX_BLOCKS, DIVIDE_INTO(A.num_rows, BLOCK_SIZE));
+
+    const cached_x<ValueType> x_cached = bind_x<UseCache>(x, A.num_cols);
+
+    spmv_bsr_kernel<IndexType,ValueType,BSR_SIZE,BLOCK_SIZE,UseCache> <<<NUM_BLOCKS, BLOCK_SIZE, 0, cusp::detail::device::current_stream()>>>
+        (A.num_rows, A.block_size,
+         thrust::raw_pointer_cast(&A.row_offsets[0]),
+         thrust::raw_pointer_cast(&A.column_indices[0]),
+         thrust::raw_pointer_cast(&A.values[0]),
+         x_cached, y);
+
+    unbind_x(x_cached);
+}
+
+template <bool UseCache,
+          typename Matrix,
+          typename ValueType>
+void __spmv_bsr(const Matrix&    A,
+                const ValueType* x,
+                      ValueType* y)
+{
+    if (A.num_rows == 0)
+        return;
+
+    if (A.num_blocks() == 0)
+    {
+        thrust::device_ptr<ValueType> y_ptr(y);
+        cusp::detail::stream::fill(y_ptr, y_ptr + A.num_rows, ValueType(0));
+        return;
+    }
+
+    switch(A.block_size)
+    {
+#define __CUSP_BSR_SIZE_CASE(BSR_SIZE) \
+        case BSR_SIZE: __spmv_bsr_launch<UseCache,BSR_SIZE>(A, x, y); break;
+        CUSP_BSR_UNROLLED_SIZES(__CUSP_BSR_SIZE_CASE)
+#undef __CUSP_BSR_SIZE_CASE
+        default: __spmv_bsr_launch<UseCache,0>(A, x, y); break;
+    }
+}
+
+template <typename Matrix,
+          typename ValueType>
+void spmv_bsr(const Matrix&    A,
+              const ValueType* x,
+                    ValueType* y)
+{
+    __spmv_bsr<false>(A, x, y);
+}
+
+template <typename Matrix,
+          typename ValueType>
+void spmv_bsr_tex(const Matrix&    A,
+                  const ValueType* x,
+                        ValueType* y)
+{
+    __spmv_bsr<true>(A, x, y);
+}
+
+} // end namespace device
+} // end namespace detail
+} // end namespace cusp
@@ -20,8 +20,11 @@
 
 #include <cusp/detail/device/arch.h>
 #include <cusp/detail/device/common.h>
+#include <cusp/detail/stream.h>
+#include <cusp/detail/device/stream.h>
 #include <cusp/detail/device/utils.h>
 #include <cusp/detail/device/texture.h>
+#include <cusp/detail/device/scratch.h>
 #include <cusp/detail/device/spmv/coo_serial.h>
 
 #include <thrust/device_ptr.h>
@@ -88,126 +91,172 @@ __device__ void segreduce_block(const IndexType * idx, ValueType * val)
 
 // spmv_coo_flat_kernel
 //
-// In this kernel each warp processes an interval of the nonzero values.
-// For example, if the matrix contains 128 nonzero values and there are
-// two warps and interval_size is 64, then the first warp (warp_id == 0)
-// will process the first set of 64 values (interval [0, 64)) and the 
-// second warp will process // the second set of 64 values 
-// (interval [64, 128)).  Note that the  number of nonzeros is not always
-// a multiple of 32 (the warp size) or 32 * the number of active warps,
-// so the last active warp will not always process a "full" interval of
-// interval_size.
-// 
-// The first thread in each warp (thread_lane == 0) has a special role:
-// it is responsible for keeping track of the "carry" values from one
-// iteration to the next.  The carry values consist of the row index and
-// partial sum from the previous batch of 32 elements.  In the example 
-// mentioned before with two warps and 128 nonzero elements, the first
-// warp iterates twice and looks at the carry of the first iteration to
-// decide whether to include this partial sum into the current batch.
-// Specifically, if a row extends over a 32-element boundary, then the
-// partial sum is carried over into the new 32-element batch.  If,
-// on the other hand, the _last_ row index of the previous batch (the carry)
-// differs from the _first_ row index of the current batch (the row
-// read by the thread with thread_lane == 0), then the partial sum
-// is written out to memory.
+// The nonzeros are split into tiles of TILE_SIZE = WARP_SIZE * ITEMS_PER_LANE
+// consecutive entries.  The kernel is launched with only as many blocks as
+// can be resident at once, and each warp repeatedly claims the next tile
+// from a global counter until all tiles are taken.  Claiming the tiles in
+// order guarantees that every tile preceding a claimed tile is already owned
+// by a running warp, which the carry propagation below relies on.
 //
-// Each warp iterates over its interval, processing 32 elements at a time.
-// For each batch of 32 elements, the warp does the following
-//  1) Fetch the row index, column index, and value for a matrix entry.  These
-//     values are loaded from I[n], J[n], and V[n] respectively.
-//     The row entry is stored in the shared memory array idx.
-//  2) Fetch the corresponding entry from the input vector.  Specifically, for a 
-//     nonzero entry (i,j) in the matrix, the thread must load the value x[j]
-//     from memory.  We use the function fetch_x to control whether the texture
-//     cache is used to load the value (UseCache == True) or whether a normal
-//     global load is used (UseCache == False).
-//  3) The matrix value A(i,j) (which was stored in V[n]) is multiplied by the 
-//     value x[j] and stored in the shared memory array val.
-//  4) The first thread in the warp (thread_lane == 0) considers the "carry"
-//     row index and either includes the carried sum in its own sum, or it
-//     updates the output vector (y) with the carried sum.
-//  5) With row indices in the shared array idx and sums in the shared array
-//     val, the warp conducts a segmented scan.  The segmented scan operation
-//     looks at the row entries for each thread (stored in idx) to see whether
-//     two values belong to the same segment (segments correspond to matrix rows).
-//     Consider the following example which consists of 3 segments
-//     (note: this example uses a warp size of 16 instead of the usual 32)
+// Within a tile the warp processes WARP_SIZE entries at a time:
+//  1) Each lane fetches the row index, column index and value of an entry
+//     and computes the product A(i,j) * x(j).  Lanes past the end of the
+//     matrix contribute zero to the last row.
+//  2) The first lane either adds the carry of the previous batch (the row
+//     and partial sum of the last lane) to its own product when the row
+//     continues, or terminates the carried row.
+//  3) The warp conducts a segmented scan of the products, where segments
+//     correspond to matrix rows.  For example, with a warp size of 16
 //
 //           0  1  2  3  4  5  6  7  8  9 10 11 12 13 14 15   # thread_lane
 //     idx [ 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 2, 2]  # row indices
 //     val [ 4, 6, 5, 0, 8, 3, 2, 8, 3, 1, 4, 9, 2, 5, 2, 4]  # A(i,j) * x(j)
 //
-//     After the segmented scan the result will be
+//     becomes
 //
 //     val [ 4,10,15,15,23,26, 2,10,13,14, 4,13,15,20,22,26]  # A(i,j) * x(j)
 //
-//  6) After the warp computes the segmented scan operation 
-//     each thread except for the last (thread_lane == 31) looks
-//     at the row index of the next thread (threadIdx.x + 1) to 
-//     see if the segment ends here, or continues into the 
-//     next thread.  The thread at the end of the segment writes
-//     the sum into the output vector (y) at the corresponding row
-//     index.
-//  7) The last thread in each warp (thread_lane == 31) writes
-//     its row index and partial sum into the designated spote in the
-//     carry_idx and carry_val arrays.  The carry arrays are indexed
-//     by warp_lane which is a number in [0, BLOCK_SIZE / 32).
-//  
-//  These steps are repeated until the warp reaches the end of its interval.
-//  The carry values at the end of each interval are written to arrays 
-//  temp_rows and temp_vals, which are processed by a second kernel.
+//  4) Each lane except the last one whose row differs from the row of the
+//     next lane terminates its row.  The last lane becomes the carry.
 //
-template <typename IndexType, typename ValueType, unsigned int BLOCK_SIZE, bool UseCache>
-__launch_bounds__(BLOCK_SIZE,1)
-__global__ void
-spmv_coo_flat_kernel(const IndexType num_nonzeros,
-                     const IndexType interval_size,
-                     const IndexType * I, 
-                     const IndexType * J, 
-                     const ValueType * V, 
-                     const ValueType * x, 
-                           ValueType * y,
-                           IndexType * temp_rows,
-                           ValueType * temp_vals)
+// Terminating a row adds its sum to y, except for the first row of the tile,
+// which may have started in a preceding tile, and the last row of the tile
+// (the final carry), which may continue in a following tile.  The partial
+// sums of these rows are propagated between tiles in a single pass with a
+// decoupled look-back.  The summary of a tile is the pair (row, sum) of its
+// last row and the sum of the entries of that row within the tile.  The
+// pairs combine as
+//
+//     (r0, s0) + (r1, s1) = (r1, (r0 == r1 ? s0 : 0) + s1)
+//
+// which accumulates the partial sums of a row spanning several tiles.  Each
+// tile publishes its summary as soon as its entries are processed.  A tile
+// which holds a row boundary, or the first tile, knows that its summary is
+// already the inclusive prefix of all tiles up to itself.  The other tiles
+// (those within a single row) publish their summary as an aggregate, look
+// back at the published states of the preceding tiles until they reach an
+// inclusive prefix or a different row, and then publish their own inclusive
+// prefix.  The exclusive prefix found by the look-back is finally added to
+// y: to the first row of the tile when the row continues and the tile
+// terminates it, or to its own row when that row ended at the tile boundary.
+// The last tile also adds its inclusive prefix, which closes the last row.
+//
+// Every row is therefore written by exactly one warp, the first pass over
+// the matrix completes y, and no second kernel has to reduce the carries.
+//
+
+const int COO_FLAT_TILE_EMPTY     = 0;
+const int COO_FLAT_TILE_AGGREGATE = 1;
+const int COO_FLAT_TILE_INCLUSIVE = 2;
+
+template <typename IndexType, typename ValueType>
+struct coo_flat_tile_state
 {
-    __shared__ volatile IndexType rows[48 *(BLOCK_SIZE/32)];
-    __shared__ volatile ValueType vals[BLOCK_SIZE];
+    volatile int * status;                 // num_tiles tile states followed by the tile counter
 
-    const IndexType thread_id   = BLOCK_SIZE * blockIdx.x + threadIdx.x;                         // global thread index
-    const IndexType thread_lane = threadIdx.x & (WARP_SIZE-1);                                   // thread index within the warp
-    const IndexType warp_id     = thread_id   / WARP_SIZE;                                       // global warp index
+    volatile IndexType * rows;             // aggregate of tile t at t, inclusive prefix at num_tiles + t
+    volatile ValueType * vals;
+};
+
+template <typename IndexType, typename ValueType>
+__device__ void
+publish_coo_flat_tile(const coo_flat_tile_state<IndexType,ValueType> state,
+                      const IndexType num_tiles, const IndexType tile, const int status,
+                      const IndexType row, const ValueType val)
+{
+    const IndexType slot = (status == COO_FLAT_TILE_INCLUSIVE) ? num_tiles + tile : tile;
+
+    state.rows[slot] = row;
+    state.vals[slot] = val;
 
-    const IndexType interval_begin = warp_id * interval_size;                                    // warp's offset into I,J,V
-    const IndexType interval_end   = thrust::min(interval_begin + interval_size, num_nonzeros);  // end of warps's work
+    // the summary must be visible before the status
+    __threadfence();
+
+    state.status[tile] = status;
+}
+
+// claims the next tile of a persistent kernel for the whole warp
+template <typename IndexType, unsigned int BLOCK_SIZE>
+__device__ IndexType
+claim_tile(volatile int * counter)
+{
+    IndexType tile = 0;
+
+    if ((threadIdx.x & (WARP_SIZE-1)) == 0)
+        tile = atomicAdd((unsigned int *) counter, 1u);
+
+#ifdef __CUSP_HAS_WARP_SHUFFLE__
+    return arch::shfl(0xffffffffu, tile, 0);
+#else
+    __shared__ volatile IndexType tiles[BLOCK_SIZE/32];
+
+    if ((threadIdx.x & (WARP_SIZE-1)) == 0)
+        tiles[threadIdx.x / 32] = tile;
+
+    return tiles[threadIdx.x / 32];
+#endif
+}
+
+// processes one tile of the nonzeros with one warp
+template <typename IndexType, typename ValueType, typename MatrixValueType, unsigned int BLOCK_SIZE, unsigned int ITEMS_PER_LANE, bool UseCache>
+__device__ void
+spmv_coo_flat_tile(const IndexType tile,
+                   const IndexType num_nonzeros,
+                   const IndexType num_tiles,
+                   const IndexType * I, 
+                   const IndexType * J, 
+                   const MatrixValueType * V, 
+                   const cached_x<ValueType>& x, 
+                         ValueType * y,
+                   const coo_flat_tile_state<IndexType,ValueType>& state)
+{
+#ifndef __CUSP_HAS_WARP_SHUFFLE__
+    __shared__ volatile IndexType rows[48 *(BLOCK_SIZE/32)];
+    __shared__ volatile ValueType vals[BLOCK_SIZE];
 
     const IndexType idx = 16 * (threadIdx.x/32 + 1) + threadIdx.x;                               // thread's index into padded rows array
 
     rows[idx - 16] = -1;                                                                         // fill padding with invalid row index
+#endif
 
-    if(interval_begin >= interval_end)                                                           // warp has no work to do 
-        return;
+    const IndexType TILE_SIZE   = WARP_SIZE * ITEMS_PER_LANE;
+    const IndexType thread_lane = threadIdx.x & (WARP_SIZE-1);                                   // thread index within the warp
+    const IndexType last_row    = I[num_nonzeros - 1];
 
-    if (thread_lane == 31)
-    {
-        // initialize the carry in values
-        rows[idx] = I[interval_begin]; 
-	vals[threadIdx.x] = ValueType(0);
-    }
-  
-    for(IndexType n = interval_begin + thread_lane; n < interval_end; n += WARP_SIZE)
+    const IndexType tile_begin = tile * TILE_SIZE;
+    const IndexType tile_end   = tile_begin + TILE_SIZE;
+    const IndexType first_row  = I[tile_begin];
+
+    IndexType carry_row = first_row;
+    ValueType carry_val = ValueType(0);
+    ValueType head_val  = ValueType(0);                           // partial sum of the first row
+
+    for(IndexType n = tile_begin + thread_lane; n < tile_end; n += WARP_SIZE)
     {
-        IndexType row = I[n];                                         // row index (i)
-        ValueType val = V[n] * fetch_x<UseCache>(J[n], x);            // A(i,j) * x(j)
-        
+        IndexType row = last_row;                                 // row index (i)
+        ValueType val = ValueType(0);                             // A(i,j) * x(j)
+
+        if (n < num_nonzeros)
+        {
+            row = I[n];
+            val = V[n] * fetch_x<UseCache>(J[n], x);
+        }
+
         if (thread_lane == 0)
         {
-            if(row == rows[idx + 31])
-                val += vals[threadIdx.x + 31];                        // row continues
+            if(row == carry_row)
+                val += carry_val;                                 // row continues
+            else if(carry_row == first_row)
+                head_val += carry_val;                            // first row terminated
             else
-                y[rows[idx + 31]] += vals[threadIdx.x + 31];  // row terminated
+                y[carry_row] += carry_val;                        // row terminated
         }
-        
+
+#ifdef __CUSP_HAS_WARP_SHUFFLE__
+        val = arch::segmented_scan_warp(thread_lane, row, val);
+
+        const IndexType next_row = arch::shfl_down(0xffffffffu, row, 1);
+#else
         rows[idx]         = row;
         vals[threadIdx.x] = val;
 
@@ -217,20 +266,137 @@ spmv_coo_flat_kernel(const IndexType num_nonzeros,
         if(row == rows[idx -  8]) { vals[threadIdx.x] = val = val + vals[threadIdx.x -  8]; }
         if(row == rows[idx - 16]) { vals[threadIdx.x] = val = val + vals[threadIdx.x - 16]; }
 
-        if(thread_lane < 31 && row != rows[idx + 1])
-            y[row] += vals[threadIdx.x];                                            // row terminated
+        const IndexType next_row = rows[idx + 1];
+#endif
+
+        if(thread_lane < 31 && row != next_row)
+        {
+            if(row == first_row)
+                head_val += val;                                  // first row terminated
+            else
+                y[row] += val;                                    // row terminated
+        }
+
+#ifdef __CUSP_HAS_WARP_SHUFFLE__
+        carry_row = arch::shfl(0xffffffffu, row, 31);
+        carry_val = arch::shfl(0xffffffffu, val, 31);
+#else
+        carry_row = rows[idx - thread_lane + 31];
+        carry_val = vals[threadIdx.x - thread_lane + 31];
+#endif
     }
 
-    if(thread_lane == 31)
+    // at most one lane terminated the first row
+#ifdef __CUSP_HAS_WARP_SHUFFLE__
+    head_val = arch::reduce_lanes<WARP_SIZE>(0xffffffffu, head_val);
+#else
+    vals[threadIdx.x] = head_val;
+    if (thread_lane < 16) vals[threadIdx.x] = head_val = head_val + vals[threadIdx.x + 16];
+    if (thread_lane <  8) vals[threadIdx.x] = head_val = head_val + vals[threadIdx.x +  8];
+    if (thread_lane <  4) vals[threadIdx.x] = head_val = head_val + vals[threadIdx.x +  4];
+    if (thread_lane <  2) vals[threadIdx.x] = head_val = head_val + vals[threadIdx.x +  2];
+    if (thread_lane <  1) vals[threadIdx.x] = head_val = head_val + vals[threadIdx.x +  1];
+#endif
+
+    if (thread_lane == 0)
     {
-        // write the carry out values
-        temp_rows[warp_id] = rows[idx];
-        temp_vals[warp_id] = vals[threadIdx.x];
+        const bool has_boundary = carry_row != first_row;
+
+        if (tile == 0 || has_boundary)
+            publish_coo_flat_tile(state, num_tiles, tile, COO_FLAT_TILE_INCLUSIVE, carry_row, carry_val);
+        else
+            publish_coo_flat_tile(state, num_tiles, tile, COO_FLAT_TILE_AGGREGATE, carry_row, carry_val);
+
+        // look back for the exclusive prefix
+        bool      has_prefix = false;
+        IndexType prefix_row = 0;
+        ValueType prefix_val = ValueType(0);
+
+        for(IndexType predecessor = tile; predecessor > 0; predecessor--)
+        {
+            const IndexType p = predecessor - 1;
+
+            int status;
+            do
+            {
+                status = state.status[p];
+            } while (status == COO_FLAT_TILE_EMPTY);
+
+            __threadfence();
+
+            const IndexType slot = (status == COO_FLAT_TILE_INCLUSIVE) ? num_tiles + p : p;
+            const IndexType row  = state.rows[slot];
+            const ValueType val  = state.vals[slot];
+
+            if (!has_prefix)
+            {
+                has_prefix = true;
+                prefix_row = row;
+                prefix_val = val;
+            }
+            else if (row == prefix_row)
+            {
+                prefix_val = val + prefix_val;
+            }
+            else
+            {
+                // earlier tiles end in other rows
+                break;
+            }
+
+            if (status == COO_FLAT_TILE_INCLUSIVE)
+                break;
+        }
+
+        IndexType inclusive_row = carry_row;
+        ValueType inclusive_val = carry_val;
+
+        if (has_prefix && !has_boundary && prefix_row == carry_row)
+            inclusive_val = prefix_val + carry_val;
+
+        if (tile != 0 && !has_boundary)
+            publish_coo_flat_tile(state, num_tiles, tile, COO_FLAT_TILE_INCLUSIVE, inclusive_row, inclusive_val);
+
+        // the row of the prefix ended at the start of this tile
+        if (has_prefix && prefix_row != first_row)
+            y[prefix_row] += prefix_val;
+
+        // the first row ended within this tile
+        if (has_boundary)
+            y[first_row] += (has_prefix && prefix_row == first_row) ? prefix_val + head_val : head_val;
+
+        // the last row of the matrix ended with this tile
+        if (tile == num_tiles - 1)
+            y[inclusive_row] += inclusive_val;
     }
 }
 
+template <typename IndexType, typename ValueType, typename MatrixValueType, unsigned int BLOCK_SIZE, unsigned int ITEMS_PER_LANE, bool UseCache>
+__launch_bounds__(BLOCK_SIZE,1)
+__global__ void
+spmv_coo_flat_kernel(const IndexType num_nonzeros,
+                     const IndexType num_tiles,
+                     const IndexType * I, 
+                     const IndexType * J, 
+                     const MatrixValueType * V, 
+                     const cached_x<ValueType> x, 
+                           ValueType * y,
+                     const coo_flat_tile_state<IndexType,ValueType> state)
+{
+    while(true)
+    {
+        const IndexType tile = claim_tile<IndexType,BLOCK_SIZE>(state.status + num_tiles);
+
+        if (tile >= num_tiles)
+            return;
 
-// The second level of the segmented reduction operation
+        spmv_coo_flat_tile<IndexType, ValueType, MatrixValueType, BLOCK_SIZE, ITEMS_PER_LANE, UseCache>
+            (tile, num_nonzeros, num_tiles, I, J, V, x, y, state);
+    }
+}
+
+
+// The second level of the multi-pass segmented reduction in coo_flat_k.h
 template <typename IndexType, typename ValueType, unsigned int BLOCK_SIZE>
 __launch_bounds__(BLOCK_SIZE,1)
 __global__ void
@@ -301,13 +467,14 @@ void __spmv_coo_flat(const Matrix&    A,
                            ValueType* y)
 {
     typedef typename Matrix::index_type IndexType;
+    typedef typename Matrix::value_type MatrixValueType;
 
     const IndexType * I = thrust::raw_pointer_cast(&A.row_indices[0]);
     const IndexType * J = thrust::raw_pointer_cast(&A.column_indices[0]);
-    const ValueType * V = thrust::raw_pointer_cast(&A.values[0]);
+    const MatrixValueType * V = thrust::raw_pointer_cast(&A.values[0]);
 
     if (InitializeY)
-        thrust::fill(thrust::device_pointer_cast(y), thrust::device_pointer_cast(y) + A.num_rows, ValueType(0));
+        cusp::detail::stream::fill(thrust::device_pointer_cast(y), thrust::device_pointer_cast(y) + A.num_rows, ValueType(0));
 
     if(A.num_entries == 0)
     {
@@ -317,44 +484,39 @@ void __spmv_coo_flat(const Matrix&    A,
     else if (A.num_entries < static_cast<size_t>(WARP_SIZE))
     {
         // small matrix
-        spmv_coo_serial_kernel<IndexType,ValueType> <<<1,1>>>
+        spmv_coo_serial_kernel<IndexType,ValueType,MatrixValueType> <<<1, 1, 0, cusp::detail::device::current_stream()>>>
             (A.num_entries, I, J, V, x, y);
         return;
     }
 
-    const unsigned int BLOCK_SIZE = 256;
-    const unsigned int MAX_BLOCKS = cusp::detail::device::arch::max_active_blocks(spmv_coo_flat_kernel<IndexType, ValueType, BLOCK_SIZE, UseCache>, BLOCK_SIZE, (size_t) 0);
+    const unsigned int BLOCK_SIZE      = 256;
+    const unsigned int ITEMS_PER_LANE  = 8;
     const unsigned int WARPS_PER_BLOCK = BLOCK_SIZE / WARP_SIZE;
+    const unsigned int MAX_BLOCKS      = cusp::detail::device::arch::max_active_blocks(spmv_coo_flat_kernel<IndexType, ValueType, MatrixValueType, BLOCK_SIZE, ITEMS_PER_LANE, UseCache>, BLOCK_SIZE, (size_t) 0);
 
-    const unsigned int num_units  = A.num_entries / WARP_SIZE; 
-    const unsigned int num_warps  = std::min(num_units, WARPS_PER_BLOCK * MAX_BLOCKS);
-    const unsigned int num_blocks = DIVIDE_INTO(num_warps, WARPS_PER_BLOCK);
-    const unsigned int num_iters  = DIVIDE_INTO(num_units, num_warps);
-    
-    const unsigned int interval_size = WARP_SIZE * num_iters;
+    const IndexType num_tiles = DIVIDE_INTO(A.num_entries, WARP_SIZE * ITEMS_PER_LANE);
 
-    const IndexType tail = num_units * WARP_SIZE; // do the last few nonzeros separately (fewer than WARP_SIZE elements)
+    const unsigned int num_blocks = std::min<size_t>(MAX_BLOCKS, DIVIDE_INTO(num_tiles, WARPS_PER_BLOCK));
 
-    const unsigned int active_warps = (interval_size == 0) ? 0 : DIVIDE_INTO(tail, interval_size);
+    // the tile states and the tile counter start at zero (COO_FLAT_TILE_EMPTY),
+    // the summaries are always written before they are read
+    device_scratch<int>       status(num_tiles + 1);
+    device_scratch<IndexType> summary_rows(2 * num_tiles);
+    device_scratch<ValueType> summary_vals(2 * num_tiles);
 
-    if (UseCache)
-        bind_x(x);
+    cudaMemsetAsync(status.get(), 0, (num_tiles + 1) * sizeof(int), cusp::detail::device::current_stream());
 
-    cusp::array1d<IndexType,cusp::device_memory> temp_rows(active_warps);
-    cusp::array1d<ValueType,cusp::device_memory> temp_vals(active_warps);
+    coo_flat_tile_state<IndexType,ValueType> state;
+    state.status = status.get();
+    state.rows   = summary_rows.get();
+    state.vals   = summary_vals.get();
 
-    spmv_coo_flat_kernel<IndexType, ValueType, BLOCK_SIZE, UseCache> <<<num_blocks, BLOCK_SIZE>>>
-        (tail, interval_size, I, J, V, x, y,
-         thrust::raw_pointer_cast(&temp_rows[0]), thrust::raw_pointer_cast(&temp_vals[0]));
+    const cached_x<ValueType> x_cached = bind_x<UseCache>(x, A.num_cols);
 
-    spmv_coo_reduce_update_kernel<IndexType, ValueType, BLOCK_SIZE> <<<1, BLOCK_SIZE>>>
-        (active_warps, thrust::raw_pointer_cast(&temp_rows[0]), thrust::raw_pointer_cast(&temp_vals[0]), y);
-    
-    spmv_coo_serial_kernel<IndexType,ValueType> <<<1,1>>>
-        (A.num_entries - tail, I + tail, J + tail, V + tail, x, y);
+    spmv_coo_flat_kernel<IndexType, ValueType, MatrixValueType, BLOCK_SIZE, ITEMS_PER_LANE, UseCache> <<<num_blocks, BLOCK_SIZE, 0, cusp::detail::device::current_stream()>>>
+        (IndexType(A.num_entries), num_tiles, I, J, V, x_cached, y, state);
 
-    if (UseCache)
-        unbind_x(x);
+    unbind_x(x_cached);
 }
 
 template <typename Matrix,
@@ -21,6 +21,8 @@
 #include <cusp/coo_matrix.h>
 #include <cusp/detail/device/arch.h>
 #include <cusp/detail/device/common.h>
+#include <cusp/detail/stream.h>
+#include <cusp/detail/device/stream.h>
 #include <cusp/detail/device/utils.h>
 #include <cusp/detail/device/texture.h>
 #include <cusp/detail/device/spmv/coo_serial.h>
@@ -71,7 +73,7 @@ spmv_coo_flat_k_kernel(const IndexType N,
                        const IndexType * I, 
                        const IndexType * J, 
                        const ValueType * V, 
-                       const ValueType * x, 
+                       const cached_x<ValueType> x, 
                              ValueType * y,
                              IndexType * temp_rows,
                              ValueType * temp_vals)
@@ -226,7 +228,7 @@ void __spmv_coo_flat_k(const coo_matrix<IndexType,ValueType,cusp::device_memory>
     const ValueType * V = thrust::raw_pointer_cast(&coo.values[0]);
 
     if (InitializeY)
-        thrust::fill(thrust::device_pointer_cast(d_y), thrust::device_pointer_cast(d_y) + coo.num_rows, ValueType(0));
+        cusp::detail::stream::fill(thrust::device_pointer_cast(d_y), thrust::device_pointer_cast(d_y) + coo.num_rows, ValueType(0));
 
     if(coo.num_entries == 0)
     {
@@ -236,7 +238,7 @@ void __spmv_coo_flat_k(const coo_matrix<IndexType,ValueType,cusp::device_memory>
     else if (coo.num_entries < WARP_SIZE)
     {
         // small matrix
-        spmv_coo_serial_kernel<IndexType,ValueType> <<<1,1>>>
+        spmv_coo_serial_kernel<IndexType,ValueType> <<<1, 1, 0, cusp::detail::device::current_stream()>>>
             (coo.num_entries, I, J, V, d_x, d_y);
         return;
     }
@@ -255,24 +257,22 @@ void __spmv_coo_flat_k(const coo_matrix<IndexType,ValueType,cusp::device_memory>
 
     const unsigned int interval_size = unit_size * num_iters;
 
-    if (UseCache)
-        bind_x(d_x);
+    const cached_x<ValueType> d_x_cached = bind_x<UseCache>(d_x, coo.num_cols);
 
     cusp::array1d<IndexType,cusp::device_memory> temp_rows(num_blocks);
     cusp::array1d<ValueType,cusp::device_memory> temp_vals(num_blocks);
 
-    spmv_coo_flat_k_kernel<CTA_SIZE,K,UseCache,IndexType,ValueType> <<<num_blocks,CTA_SIZE>>>
-        (N, interval_size, I, J, V, d_x, d_y,
+    spmv_coo_flat_k_kernel<CTA_SIZE,K,UseCache,IndexType,ValueType> <<<num_blocks, CTA_SIZE, 0, cusp::detail::device::current_stream()>>>
+        (N, interval_size, I, J, V, d_x_cached, d_y,
          thrust::raw_pointer_cast(&temp_rows[0]), thrust::raw_pointer_cast(&temp_vals[0]));
 
 //    spmv_coo_serial_kernel<IndexType,ValueType> <<<1,1>>>
 //        (coo.num_entries - tail, I + tail, J + tail, V + tail, d_x, d_y);
 
-    spmv_coo_reduce_update_kernel<IndexType, ValueType, 512> <<<1, 512>>>
+    spmv_coo_reduce_update_kernel<IndexType, ValueType, 512> <<<1, 512, 0, cusp::detail::device::current_stream()>>>
         (num_blocks, thrust::raw_pointer_cast(&temp_rows[0]), thrust::raw_pointer_cast(&temp_vals[0]), d_y);
 
-    if (UseCache)
-        unbind_x(d_x);
+    unbind_x(d_x_cached);
 }
 
 template <typename IndexType, typename ValueType>
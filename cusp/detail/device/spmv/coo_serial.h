@@ -16,6 +16,8 @@
 
 #pragma once
 
+#include <cusp/detail/device/stream.h>
+
 #include <thrust/device_ptr.h>
 
 namespace cusp
@@ -30,12 +32,12 @@ namespace device
 // *extremely* small matrices, or a few elements at the end of a 
 // larger matrix
 
-template <typename IndexType, typename ValueType>
+template <typename IndexType, typename ValueType, typename MatrixValueType>
 __global__ void
 spmv_coo_serial_kernel(const IndexType num_entries,
                        const IndexType * I, 
                        const IndexType * J, 
-                       const ValueType * V, 
+                       const MatrixValueType * V, 
                        const ValueType * x, 
                              ValueType * y)
 {
@@ -53,12 +55,13 @@ void spmv_coo_serial_device(const Matrix&    A,
                                   ValueType* y)
 {
     typedef typename Matrix::index_type IndexType;
+    typedef typename Matrix::value_type MatrixValueType;
 
     const IndexType * I = thrust::raw_pointer_cast(&A.row_indices[0]);
     const IndexType * J = thrust::raw_pointer_cast(&A.column_indices[0]);
-    const ValueType * V = thrust::raw_pointer_cast(&A.values[0]);
+    const MatrixValueType * V = thrust::raw_pointer_cast(&A.values[0]);
 
-    spmv_coo_serial_kernel<IndexType,ValueType> <<<1,1>>>
+    spmv_coo_serial_kernel<IndexType,ValueType,MatrixValueType> <<<1, 1, 0, cusp::detail::device::current_stream()>>>
         (A.num_entries, I, J, V, x, y);
 }
 
@@ -0,0 +1,324 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+#pragma once
+
+#include <cusp/array1d.h>
+
+#include <cusp/detail/stream.h>
+#include <cusp/detail/device/arch.h>
+#include <cusp/detail/device/common.h>
+#include <cusp/detail/device/utils.h>
+#include <cusp/detail/device/stream.h>
+#include <cusp/detail/device/texture.h>
+
+#include <thrust/binary_search.h>
+#include <thrust/device_ptr.h>
+#include <thrust/extrema.h>
+#include <thrust/functional.h>
+#include <thrust/sequence.h>
+#include <thrust/sort.h>
+#include <thrust/iterator/counting_iterator.h>
+
+namespace cusp
+{
+namespace detail
+{
+namespace device
+{
+
+//////////////////////////////////////////////////////////////////////////////
+// CSR SpMV kernels with rows binned by length (CSR-adaptive)
+//////////////////////////////////////////////////////////////////////////////
+//
+// analyze_csr_adaptive
+//   Sorts the rows of A into bins by their number of nonzeros.  A row of
+//   length L goes to the bin whose rows are processed by a group of
+//   max(1, L / 2) threads rounded up to a power of two, with at most one
+//   warp per row.  Rows longer than CSR_ADAPTIVE_LONG_ROW are processed by
+//   a whole thread block.  The rows of a bin keep their original order.
+//   The analysis only depends on the sparsity pattern of A, so it is meant
+//   to be computed once and reused by every multiply with A.
+//
+// spmv_csr_adaptive
+//   Launches one kernel per nonempty bin.  Each group of threads computes
+//   y[i] = A[i,:] * x for the rows of its bin, like spmv_csr_vector does
+//   with a single group size for the whole matrix.  Short rows therefore
+//   do not leave most of a warp idle, and long rows do not serialize on
+//   one warp.
+
+const unsigned int CSR_ADAPTIVE_NUM_BINS   = 7;        // groups of 1, 2, 4, 8, 16, 32 threads and blocks
+const unsigned int CSR_ADAPTIVE_BLOCK_BIN  = 6;
+const unsigned int CSR_ADAPTIVE_LONG_ROW   = 2048;
+
+template <typename IndexType>
+struct csr_adaptive_analysis
+{
+    // rows of A sorted by bin
+    cusp::array1d<IndexType,cusp::device_memory> rows;
+
+    // the rows of bin b are rows[bin_offsets[b], bin_offsets[b+1])
+    size_t bin_offsets[CSR_ADAPTIVE_NUM_BINS + 1];
+
+    csr_adaptive_analysis(void)
+    {
+        for(unsigned int b = 0; b <= CSR_ADAPTIVE_NUM_BINS; b++)
+            bin_offsets[b] = 0;
+    }
+};
+
+template <typename IndexType>
+struct csr_adaptive_bin : public thrust::binary_function<IndexType,IndexType,IndexType>
+{
+    __host__ __device__
+    IndexType operator()(const IndexType row_end, const IndexType row_start) const
+    {
+        const IndexType length = row_end - row_start;
+
+        if (length > IndexType(CSR_ADAPTIVE_LONG_ROW))
+            return CSR_ADAPTIVE_BLOCK_BIN;
+
+        IndexType bin = 0;
+        while (bin + 1 < IndexType(CSR_ADAPTIVE_BLOCK_BIN) && (IndexType(2) << bin) < length)
+            bin++;
+
+        return bin;
+    }
+};
+
+template <typename Matrix>
+void analyze_csr_adaptive(const Matrix& A, csr_adaptive_analysis<typename Matrix::index_type>& analysis)
+{
+    typedef typename Matrix::index_type IndexType;
+
+    cusp::array1d<IndexType,cusp::device_memory> bins(A.num_rows);
+    cusp::array1d<IndexType,cusp::device_memory> offsets(CSR_ADAPTIVE_NUM_BINS + 1);
+
+    analysis.rows.resize(A.num_rows);
+
+    cusp::detail::stream::transform(A.row_offsets.begin() + 1, A.row_offsets.end(),
+                                    A.row_offsets.begin(),
+                                    bins.begin(),
+                                    csr_adaptive_bin<IndexType>());
+
+    thrust::sequence(analysis.rows.begin(), analysis.rows.end());
+    thrust::stable_sort_by_key(bins.begin(), bins.end(), analysis.rows.begin());
+
+    thrust::lower_bound(bins.begin(), bins.end(),
+                        thrust::counting_iterator<IndexType>(0),
+                        thrust::counting_iterator<IndexType>(CSR_ADAPTIVE_NUM_BINS + 1),
+                        offsets.begin());
+
+    cusp::array1d<IndexType,cusp::host_memory> h_offsets(offsets);
+
+    for(unsigned int b = 0; b <= CSR_ADAPTIVE_NUM_BINS; b++)
+        analysis.bin_offsets[b] = h_offsets[b];
+}
+
+// a group of THREADS_PER_VECTOR threads per row of the bin
+template <typename IndexType, typename ValueType, typename MatrixValueType, unsigned int VECTORS_PER_BLOCK, unsigned int THREADS_PER_VECTOR, bool UseCache>
+__launch_bounds__(VECTORS_PER_BLOCK * THREADS_PER_VECTOR,1)
+__global__ void
+spmv_csr_adaptive_vector_kernel(const IndexType num_bin_rows,
+                                const IndexType * rows,
+                                const IndexType * Ap,
+                                const IndexType * Aj,
+                                const MatrixValueType * Ax,
+                                const cached_x<ValueType> x,
+                                      ValueType * y)
+{
+#ifndef __CUSP_HAS_WARP_SHUFFLE__
+    __shared__ volatile ValueType sdata[VECTORS_PER_BLOCK * THREADS_PER_VECTOR + THREADS_PER_VECTOR / 2];  // padded to avoid reduction conditionals
+#endif
+
+    const IndexType THREADS_PER_BLOCK = VECTORS_PER_BLOCK * THREADS_PER_VECTOR;
+
+    const IndexType thread_id   = THREADS_PER_BLOCK * blockIdx.x + threadIdx.x;    // global thread index
+    const IndexType thread_lane = threadIdx.x & (THREADS_PER_VECTOR - 1);          // thread index within the vector
+    const IndexType vector_id   = thread_id   /  THREADS_PER_VECTOR;               // global vector index
+    const IndexType num_vectors = VECTORS_PER_BLOCK * gridDim.x;                   // total number of active vectors
+
+    for(IndexType n = vector_id; n < num_bin_rows; n += num_vectors)
+    {
+        const IndexType row       = rows[n];
+        const IndexType row_start = Ap[row];
+        const IndexType row_end   = Ap[row + 1];
+
+        // accumulate local sums
+        ValueType sum = 0;
+
+        for(IndexType jj = row_start + thread_lane; jj < row_end; jj += THREADS_PER_VECTOR)
+            sum += Ax[jj] * fetch_x<UseCache>(Aj[jj], x);
+
+        // reduce local sums to row sum
+#ifdef __CUSP_HAS_WARP_SHUFFLE__
+        sum = arch::reduce_lanes<THREADS_PER_VECTOR>(arch::lane_mask<THREADS_PER_VECTOR>(threadIdx.x), sum);
+#else
+        sdata[threadIdx.x] = sum;
+
+        if (THREADS_PER_VECTOR > 16) sdata[threadIdx.x] = sum = sum + sdata[threadIdx.x + 16];
+        if (THREADS_PER_VECTOR >  8) sdata[threadIdx.x] = sum = sum + sdata[threadIdx.x +  8];
+        if (THREADS_PER_VECTOR >  4) sdata[threadIdx.x] = sum = sum + sdata[threadIdx.x +  4];
+        if (THREADS_PER_VECTOR >  2) sdata[threadIdx.x] = sum = sum + sdata[threadIdx.x +  2];
+        if (THREADS_PER_VECTOR >  1) sdata[threadIdx.x] = sum = sum + sdata[threadIdx.x +  1];
+#endif
+
+        // first thread writes the result
+        if (thread_lane == 0)
+            y[row] = sum;
+    }
+}
+
+// a thread block per row of the bin
+template <typename IndexType, typename ValueType, typename MatrixValueType, unsigned int BLOCK_SIZE, bool UseCache>
+__launch_bounds__(BLOCK_SIZE,1)
+__global__ void
+spmv_csr_adaptive_block_kernel(const IndexType num_bin_rows,
+                               const IndexType * rows,
+                               const IndexType * Ap,
+                               const IndexType * Aj,
+                               const MatrixValueType * Ax,
+                               const cached_x<ValueType> x,
+                                     ValueType * y)
+{
+    __shared__ ValueType sdata[BLOCK_SIZE];
+
+    for(IndexType n = blockIdx.x; n < num_bin_rows; n += gridDim.x)
+    {
+        const IndexType row       = rows[n];
+        const IndexType row_start = Ap[row];
+        const IndexType row_end   = Ap[row + 1];
+
+        ValueType sum = 0;
+
+        for(IndexType jj = row_start + threadIdx.x; jj < row_end; jj += BLOCK_SIZE)
+            sum += Ax[jj] * fetch_x<UseCache>(Aj[jj], x);
+
+        sdata[threadIdx.x] = sum;
+
+        __syncthreads();
+
+        for(unsigned int offset = BLOCK_SIZE / 2; offset > 0; offset /= 2)
+        {
+            if (threadIdx.x < offset)
+                sdata[threadIdx.x] = sdata[threadIdx.x] + sdata[threadIdx.x + offset];
+
+            __syncthreads();
+        }
+
+        if (threadIdx.x == 0)
+            y[row] = sdata[0];
+
+        // sdata is reused by the next row
+        __syncthreads();
+    }
+}
+
+template <bool UseCache, unsigned int THREADS_PER_VECTOR, typename Matrix, typename ValueType>
+void __spmv_csr_adaptive_bin(const Matrix&    A,
+                             const typename Matrix::index_type * rows,
+                             const size_t     num_bin_rows,
+                             const cached_x<ValueType>& x,
+                                   ValueType* y)
+{
+    typedef typename Matrix::index_type IndexType;
+    typedef typename Matrix::value_type MatrixValueType;
+
+    if (num_bin_rows == 0)
+        return;
+
+    const size_t THREADS_PER_BLOCK  = 128;
+    const size_t VECTORS_PER_BLOCK  = THREADS_PER_BLOCK / THREADS_PER_VECTOR;
+
+    const size_t MAX_BLOCKS = cusp::detail::device::arch::max_active_blocks(spmv_csr_adaptive_vector_kernel<IndexType, ValueType, MatrixValueType, VECTORS_PER_BLOCK, THREADS_PER_VECTOR, UseCache>, THREADS_PER_BLOCK, (size_t) 0);
+    const size_t NUM_BLOCKS = std::min<size_t>(MAX_BLOCKS, DIVIDE_INTO(num_bin_rows, VECTORS_PER_BLOCK));
+
+    spmv_csr_adaptive_vector_kernel<IndexType, ValueType, MatrixValueType, VECTORS_PER_BLOCK, THREADS_PER_VECTOR, UseCache> <<<NUM_BLOCKS, THREADS_PER_BLOCK, 0, cusp::detail::device::current_stream()>>>
+        (IndexType(num_bin_rows), rows,
+         thrust::raw_pointer_cast(&A.row_offsets[0]),
+         thrust::raw_pointer_cast(&A.column_indices[0]),
+         thrust::raw_pointer_cast(&A.values[0]),
+         x, y);
+}
+
+template <bool UseCache, typename Matrix, typename ValueType>
+void __spmv_csr_adaptive(const Matrix&    A,
+                         const csr_adaptive_analysis<typename Matrix::index_type>& analysis,
+                         const ValueType* x,
+                               ValueType* y)
+{
+    typedef typename Matrix::index_type IndexType;
+    typedef typename Matrix::value_type MatrixValueType;
+
+    if (A.num_rows == 0)
+        return;
+
+    const IndexType * rows   = thrust::raw_pointer_cast(&analysis.rows[0]);
+    const size_t    * offset = analysis.bin_offsets;
+
+    const cached_x<ValueType> x_cached = bind_x<UseCache>(x, A.num_cols);
+
+    __spmv_csr_adaptive_bin<UseCache, 1>(A, rows + offset[0], offset[1] - offset[0], x_cached, y);
+    __spmv_csr_adaptive_bin<UseCache, 2>(A, rows + offset[1], offset[2] - offset[1], x_cached, y);
+    __spmv_csr_adaptive_bin<UseCache, 4>(A, rows + offset[2], offset[3] - offset[2], x_cached, y);
+    __spmv_csr_adaptive_bin<UseCache, 8>(A, rows + offset[3], offset[4] - offset[3], x_cached, y);
+    __spmv_csr_adaptive_bin<UseCache,16>(A, rows + offset[4], offset[5] - offset[4], x_cached, y);
+    __spmv_csr_adaptive_bin<UseCache,32>(A, rows + offset[5], offset[6] - offset[5], x_cached, y);
+
+    const size_t num_long_rows = offset[CSR_ADAPTIVE_BLOCK_BIN + 1] - offset[CSR_ADAPTIVE_BLOCK_BIN];
+
+    if (num_long_rows > 0)
+    {
+        const unsigned int BLOCK_SIZE = 256;
+
+        const size_t MAX_BLOCKS = cusp::detail::device::arch::max_active_blocks(spmv_csr_adaptive_block_kernel<IndexType, ValueType, MatrixValueType, BLOCK_SIZE, UseCache>, BLOCK_SIZE, (size_t) 0);
+        const size_t NUM_BLOCKS = std::min<size_t>(MAX_BLOCKS, num_long_rows);
+
+        spmv_csr_adaptive_block_kernel<IndexType, ValueType, MatrixValueType, BLOCK_SIZE, UseCache> <<<NUM_BLOCKS, BLOCK_SIZE, 0, cusp::detail::device::current_stream()>>>
+            (IndexType(num_long_rows), rows + offset[CSR_ADAPTIVE_BLOCK_BIN],
+             thrust::raw_pointer_cast(&A.row_offsets[0]),
+             thrust::raw_pointer_cast(&A.column_indices[0]),
+             thrust::raw_pointer_cast(&A.values[0]),
+             x_cached, y);
+    }
+
+    unbind_x(x_cached);
+}
+
+template <typename Matrix,
+          typename ValueType>
+void spmv_csr_adaptive(const Matrix&    A,
+                       const csr_adaptive_analysis<typename Matrix::index_type>& analysis,
+                       const ValueType* x,
+                             ValueType* y)
+{
+    __spmv_csr_adaptive<false>(A, analysis, x, y);
+}
+
+template <typename Matrix,
+          typename ValueType>
+void spmv_csr_adaptive_tex(const Matrix&    A,
+                           const csr_adaptive_analysis<typename Matrix::index_type>& analysis,
+                           const ValueType* x,
+                                 ValueType* y)
+{
+    __spmv_csr_adaptive<true>(A, analysis, x, y);
+}
+
+} // end namespace device
+} // end namespace detail
+} // end namespace cusp
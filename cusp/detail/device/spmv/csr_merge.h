@@ -0,0 +1,372 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+#pragma once
+
+#include <cusp/array1d.h>
+
+#include <cusp/detail/mutex.h>
+#include <cusp/detail/offset_type.h>
+#include <cusp/detail/stream.h>
+#include <cusp/detail/device/arch.h>
+#include <cusp/detail/device/common.h>
+#include <cusp/detail/device/utils.h>
+#include <cusp/detail/device/stream.h>
+#include <cusp/detail/device/texture.h>
+#include <cusp/detail/device/graph.h>
+#include <cusp/detail/device/scratch.h>
+#include <cusp/detail/device/spmv/coo_flat.h>
+
+#include <thrust/device_ptr.h>
+#include <thrust/extrema.h>
+#include <thrust/functional.h>
+#include <thrust/reduce.h>
+#include <thrust/transform_reduce.h>
+#include <thrust/iterator/zip_iterator.h>
+
+namespace cusp
+{
+namespace detail
+{
+namespace device
+{
+
+//////////////////////////////////////////////////////////////////////////////
+// CSR SpMV kernels based on a merge-path decomposition
+//////////////////////////////////////////////////////////////////////////////
+//
+// spmv_csr_merge
+//   The computation y = A * x is viewed as a merge of two sorted lists:
+//   the row end offsets (A.row_offsets[1:]) and the natural numbers
+//   [0, num_entries) indexing the nonzeros.  Each step along the merge
+//   path either consumes one nonzero (accumulating A(i,j) * x(j) into the
+//   running row sum) or terminates the current row (writing its sum).
+//   The path has exactly num_rows + num_entries steps, which are split
+//   into equal intervals, one interval per thread.  Consequently every
+//   thread performs the same amount of work regardless of how the
+//   nonzeros are distributed among the rows, so a single very long row
+//   is shared by many threads instead of stalling one warp.  The path
+//   is addressed with the OffsetType of the row offsets, which may be
+//   wider than the IndexType of the columns (cusp/detail/offset_type.h).
+//
+//   A thread locates the start of its interval with a binary search along
+//   the corresponding cross diagonal of the merge grid.  Rows that are
+//   terminated inside an interval are written directly.  The partial sum
+//   of the row that is still open at the end of an interval is its carry.
+//   The carries are ordered by row, so each block adds its carries to the
+//   rows which end within the block with a segmented reduction, and only
+//   the carry of its last row, which ends in a later block, is left to a
+//   second kernel.  The number of these block carries is known in advance
+//   and no result returns to the host, so the product can be recorded in
+//   a CUDA Graph.
+//
+// spmv_csr_merge_tex
+//   Same as spmv_csr_merge, except that the texture cache is
+//   used for accessing the x vector.
+//
+// spmv_csr_merge_is_profitable
+//   Inspects the row lengths of A and returns true when they are
+//   irregular enough for the merge-path kernel to outperform the
+//   one-vector-per-row kernel in csr_vector.h.  The row lengths are only
+//   reduced the first time a matrix is seen: the decision is remembered
+//   per host thread for the last few row offset arrays, keyed by their
+//   address and the dimensions of the matrix, so repeated products with
+//   the same matrix (e.g. in a Krylov solver) do not synchronize.  Both
+//   kernels compute the same product, so a matrix whose row offsets are
+//   changed in place merely keeps the kernel chosen before, and a matrix
+//   first seen while a CUDA Graph is captured takes csr_vector.h.
+//
+
+// find the coordinate (row, nonzero) where the merge path crosses a diagonal
+template <typename IndexType>
+__device__ void
+merge_path_search(const IndexType diagonal,
+                  const IndexType * row_end_offsets,
+                  const IndexType num_rows,
+                  const IndexType num_entries,
+                        IndexType& row,
+                        IndexType& nonzero)
+{
+    IndexType row_min = thrust::max(diagonal - num_entries, IndexType(0));
+    IndexType row_max = thrust::min(diagonal, num_rows);
+
+    while (row_min < row_max)
+    {
+        const IndexType pivot = (row_min + row_max) >> 1;
+
+        if (row_end_offsets[pivot] <= diagonal - pivot - 1)
+            row_min = pivot + 1;  // path passes below the pivot row end
+        else
+            row_max = pivot;
+    }
+
+    row     = thrust::min(row_min, num_rows);
+    nonzero = diagonal - row_min;
+}
+
+template <typename IndexType, typename OffsetType, typename ValueType, typename MatrixValueType, unsigned int BLOCK_SIZE, bool UseCache>
+__launch_bounds__(BLOCK_SIZE,1)
+__global__ void
+spmv_csr_merge_kernel(const OffsetType num_rows,
+                      const OffsetType num_entries,
+                      const OffsetType items_per_thread,
+                      const OffsetType * Ap,
+                      const IndexType * Aj,
+                      const MatrixValueType * Ax,
+                      const cached_x<ValueType> x,
+                            ValueType * y,
+                            OffsetType * block_carry_rows,
+                            ValueType * block_carry_vals)
+{
+    __shared__ OffsetType carry_rows[BLOCK_SIZE];
+    __shared__ ValueType  carry_vals[BLOCK_SIZE];
+
+    const OffsetType * row_end_offsets = Ap + 1;
+
+    const OffsetType thread_id = BLOCK_SIZE * blockIdx.x + threadIdx.x;    // global thread index
+    const OffsetType num_items = num_rows + num_entries;                    // length of the merge path
+
+    const OffsetType diagonal_begin = thrust::min(items_per_thread * thread_id, num_items);
+    const OffsetType diagonal_end   = thrust::min(diagonal_begin + items_per_thread, num_items);
+
+    OffsetType row, nonzero;
+    merge_path_search(diagonal_begin, row_end_offsets, num_rows, num_entries, row, nonzero);
+
+    ValueType sum = 0;
+
+    for(OffsetType n = diagonal_begin; n < diagonal_end; n++)
+    {
+        if (nonzero < row_end_offsets[row])
+        {
+            // consume a nonzero of the current row
+            sum += Ax[nonzero] * fetch_x<UseCache>(Aj[nonzero], x);
+            nonzero++;
+        }
+        else
+        {
+            // the current row ends here
+            y[row] = sum;
+            sum = 0;
+            row++;
+        }
+    }
+
+    // sum the carries of each row in the block (row == num_rows marks an empty carry)
+    carry_rows[threadIdx.x] = row;
+    carry_vals[threadIdx.x] = sum;
+
+    __syncthreads();
+
+    segreduce_block(carry_rows, carry_vals);
+
+    if (threadIdx.x < BLOCK_SIZE - 1)
+    {
+        // the row ends in the interval of the next thread, which wrote y[row] above
+        if (row < num_rows && row != carry_rows[threadIdx.x + 1])
+            y[row] += carry_vals[threadIdx.x];
+    }
+    else
+    {
+        block_carry_rows[blockIdx.x] = row;
+        block_carry_vals[blockIdx.x] = carry_vals[threadIdx.x];
+    }
+}
+
+// The second level of the merge-path reduction
+template <typename IndexType, typename ValueType, unsigned int BLOCK_SIZE>
+__launch_bounds__(BLOCK_SIZE,1)
+__global__ void
+spmv_csr_merge_update_kernel(const IndexType num_rows,
+                             const IndexType num_carries,
+                             const IndexType * carry_rows,
+                             const ValueType * carry_vals,
+                                   ValueType * y)
+{
+    const IndexType thread_id = BLOCK_SIZE * blockIdx.x + threadIdx.x;
+    const IndexType grid_size = BLOCK_SIZE * gridDim.x;
+
+    // the first carry of each row adds all carries of the row, so no two
+    // threads touch the same y[row]
+    for(IndexType n = thread_id; n < num_carries; n += grid_size)
+    {
+        const IndexType row = carry_rows[n];
+
+        if (row < num_rows && (n == 0 || carry_rows[n - 1] != row))
+        {
+            ValueType sum = carry_vals[n];
+
+            for(IndexType k = n + 1; k < num_carries && carry_rows[k] == row; k++)
+                sum = sum + carry_vals[k];
+
+            y[row] += sum;
+        }
+    }
+}
+
+template <typename IndexType>
+struct csr_row_length_squared
+{
+    typedef double result_type;
+
+    template <typename Tuple>
+    __host__ __device__
+    double operator()(const Tuple& t) const
+    {
+        const double length = thrust::get<1>(t) - thrust::get<0>(t);
+        return length * length;
+    }
+};
+
+struct spmv_csr_merge_decision
+{
+    const void * row_offsets;
+    size_t num_rows;
+    size_t num_entries;
+    bool profitable;
+};
+
+const size_t SPMV_CSR_MERGE_DECISIONS = 8;
+
+// the decisions of a host thread, replaced in round-robin order
+struct spmv_csr_merge_decisions
+{
+    spmv_csr_merge_decision entries[SPMV_CSR_MERGE_DECISIONS];
+    size_t next;
+};
+
+inline spmv_csr_merge_decisions& thread_spmv_csr_merge_decisions(void)
+{
+    static __CUSP_THREAD_LOCAL spmv_csr_merge_decisions decisions;
+    return decisions;
+}
+
+template <typename Matrix>
+bool spmv_csr_merge_is_profitable(const Matrix& A)
+{
+    typedef typename Matrix::index_type IndexType;
+
+    // regular launch overhead dominates for small matrices
+    if (A.num_rows == 0 || A.num_entries < size_t(MAX_THREADS))
+        return false;
+
+    const void * row_offsets = thrust::raw_pointer_cast(&A.row_offsets[0]);
+
+    spmv_csr_merge_decisions& decisions = thread_spmv_csr_merge_decisions();
+
+    for (size_t n = 0; n < SPMV_CSR_MERGE_DECISIONS; n++)
+    {
+        const spmv_csr_merge_decision& decision = decisions.entries[n];
+
+        if (decision.row_offsets == row_offsets &&
+            decision.num_rows    == A.num_rows  &&
+            decision.num_entries == A.num_entries)
+            return decision.profitable;
+    }
+
+    // the reduction returns to the host, which a capture does not allow,
+    // so an unknown matrix takes the one-vector-per-row kernel
+    if (is_capturing(cusp::detail::device::current_stream()))
+        return false;
+
+    // compute the variance of the row lengths with one pass over the row offsets
+    const double sum_of_squares =
+        cusp::detail::stream::transform_reduce(thrust::make_zip_iterator(thrust::make_tuple(A.row_offsets.begin(), A.row_offsets.begin() + 1)),
+                                               thrust::make_zip_iterator(thrust::make_tuple(A.row_offsets.begin(), A.row_offsets.begin() + 1)) + A.num_rows,
+                                               csr_row_length_squared<IndexType>(),
+                                               double(0),
+                                               thrust::plus<double>());
+
+    const double mean     = double(A.num_entries) / double(A.num_rows);
+    const double variance = sum_of_squares / double(A.num_rows) - mean * mean;
+
+    // the standard deviation exceeds the mean row length (coefficient of variation > 1)
+    const spmv_csr_merge_decision decision = {row_offsets, A.num_rows, A.num_entries, variance > mean * mean};
+
+    decisions.entries[decisions.next] = decision;
+    decisions.next = (decisions.next + 1) % SPMV_CSR_MERGE_DECISIONS;
+
+    return decision.profitable;
+}
+
+template <bool UseCache, typename Matrix, typename ValueType>
+void __spmv_csr_merge(const Matrix&    A,
+                      const ValueType* x,
+                            ValueType* y)
+{
+    typedef typename Matrix::index_type IndexType;
+    typedef typename cusp::detail::offset_type<Matrix>::type OffsetType;
+    typedef typename Matrix::value_type MatrixValueType;
+
+    if (A.num_rows == 0)
+        return;
+
+    const unsigned int BLOCK_SIZE       = 128;
+    const unsigned int ITEMS_PER_THREAD = 7;
+
+    const OffsetType num_items   = A.num_rows + A.num_entries;
+    const OffsetType num_threads = DIVIDE_INTO(num_items, OffsetType(ITEMS_PER_THREAD));
+    const size_t     num_blocks  = DIVIDE_INTO(num_threads, OffsetType(BLOCK_SIZE));
+
+    // one carry per block
+    device_scratch<OffsetType> carry_rows(num_blocks);
+    device_scratch<ValueType>  carry_vals(num_blocks);
+
+    const cached_x<ValueType> x_cached = bind_x<UseCache>(x, A.num_cols);
+
+    spmv_csr_merge_kernel<IndexType, OffsetType, ValueType, MatrixValueType, BLOCK_SIZE, UseCache> <<<num_blocks, BLOCK_SIZE, 0, cusp::detail::device::current_stream()>>>
+        (OffsetType(A.num_rows), OffsetType(A.num_entries), OffsetType(ITEMS_PER_THREAD),
+         thrust::raw_pointer_cast(&A.row_offsets[0]),
+         thrust::raw_pointer_cast(&A.column_indices[0]),
+         thrust::raw_pointer_cast(&A.values[0]),
+         x_cached, y,
+         carry_rows.get(),
+         carry_vals.get());
+
+    unbind_x(x_cached);
+
+    const size_t UPDATE_MAX_BLOCKS = cusp::detail::device::arch::max_active_blocks(spmv_csr_merge_update_kernel<OffsetType, ValueType, BLOCK_SIZE>, BLOCK_SIZE, (size_t) 0);
+    const size_t UPDATE_NUM_BLOCKS = std::min<size_t>(UPDATE_MAX_BLOCKS, DIVIDE_INTO(num_blocks, size_t(BLOCK_SIZE)));
+
+    spmv_csr_merge_update_kernel<OffsetType, ValueType, BLOCK_SIZE> <<<UPDATE_NUM_BLOCKS, BLOCK_SIZE, 0, cusp::detail::device::current_stream()>>>
+        (OffsetType(A.num_rows), OffsetType(num_blocks),
+         carry_rows.get(),
+         carry_vals.get(),
+         y);
+}
+
+template <typename Matrix,
+          typename ValueType>
+void spmv_csr_merge(const Matrix&    A,
+                    const ValueType* x,
+                          ValueType* y)
+{
+    __spmv_csr_merge<false>(A, x, y);
+}
+
+template <typename Matrix,
+          typename ValueType>
+void spmv_csr_merge_tex(const Matrix&    A,
+                        const ValueType* x,
+                              ValueType* y)
+{
+    __spmv_csr_merge<true>(A, x, y);
+}
+
+} // end namespace device
+} // end namespace detail
+} // end namespace cusp
+
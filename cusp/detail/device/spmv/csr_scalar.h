@@ -16,8 +16,10 @@
 
 #pragma once
 
+#include <cusp/detail/offset_type.h>
 #include <cusp/detail/device/arch.h>
 #include <cusp/detail/device/utils.h>
+#include <cusp/detail/device/stream.h>
 #include <cusp/detail/device/texture.h>
 
 #include <thrust/device_ptr.h>
@@ -41,16 +43,21 @@ namespace device
 // spmv_csr_scalar_tex_device
 //   Same as spmv_csr_scalar_device, except x is accessed via texture cache.
 //
+// The positions of the entries have the OffsetType of the row offsets
+// (cusp/detail/offset_type.h).
+//
 
 template <bool UseCache,
           typename IndexType,
-          typename ValueType>
+          typename OffsetType,
+          typename ValueType,
+          typename MatrixValueType>
 __global__ void
 spmv_csr_scalar_kernel(const IndexType num_rows,
-                       const IndexType * Ap, 
+                       const OffsetType * Ap, 
                        const IndexType * Aj, 
-                       const ValueType * Ax, 
-                       const ValueType * x, 
+                       const MatrixValueType * Ax, 
+                       const cached_x<ValueType> x, 
                              ValueType * y)
 {
     const IndexType thread_id = blockDim.x * blockIdx.x + threadIdx.x;
@@ -58,12 +65,12 @@ spmv_csr_scalar_kernel(const IndexType num_rows,
 
     for(IndexType row = thread_id; row < num_rows; row += grid_size)
     {
-        const IndexType row_start = Ap[row];
-        const IndexType row_end   = Ap[row+1];
+        const OffsetType row_start = Ap[row];
+        const OffsetType row_end   = Ap[row+1];
         
         ValueType sum = 0;
     
-        for (IndexType jj = row_start; jj < row_end; jj++)
+        for (OffsetType jj = row_start; jj < row_end; jj++)
             sum += Ax[jj] * fetch_x<UseCache>(Aj[jj], x);       
 
         y[row] = sum;
@@ -79,23 +86,23 @@ void __spmv_csr_scalar(const Matrix&    A,
                              ValueType* y)
 {
     typedef typename Matrix::index_type IndexType;
+    typedef typename cusp::detail::offset_type<Matrix>::type OffsetType;
+    typedef typename Matrix::value_type MatrixValueType;
 
     const size_t BLOCK_SIZE = 256;
-    const size_t MAX_BLOCKS = cusp::detail::device::arch::max_active_blocks(spmv_csr_scalar_kernel<UseCache, IndexType, ValueType>, BLOCK_SIZE, (size_t) 0);
+    const size_t MAX_BLOCKS = cusp::detail::device::arch::max_active_blocks(spmv_csr_scalar_kernel<UseCache, IndexType, OffsetType, ValueType, MatrixValueType>, BLOCK_SIZE, (size_t) 0);
     const size_t NUM_BLOCKS = std::min(MAX_BLOCKS, DIVIDE_INTO(A.num_rows, BLOCK_SIZE));
     
-    if (UseCache)
-        bind_x(x);
+    const cached_x<ValueType> x_cached = bind_x<UseCache>(x, A.num_cols);
 
-    spmv_csr_scalar_kernel<UseCache,IndexType,ValueType> <<<NUM_BLOCKS, BLOCK_SIZE>>> 
+    spmv_csr_scalar_kernel<UseCache,IndexType,OffsetType,ValueType,MatrixValueType> <<<NUM_BLOCKS, BLOCK_SIZE, 0, cusp::detail::device::current_stream()>>> 
         (A.num_rows,
          thrust::raw_pointer_cast(&A.row_offsets[0]),
          thrust::raw_pointer_cast(&A.column_indices[0]),
          thrust::raw_pointer_cast(&A.values[0]),
-         x, y);
+         x_cached, y);
 
-    if (UseCache)
-        unbind_x(x);
+    unbind_x(x_cached);
 }
 
 template <typename Matrix,
@@ -17,13 +17,23 @@
 
 #pragma once
 
+#include <cusp/reduction.h>
+
+#include <cusp/detail/accumulator.h>
+#include <cusp/detail/offset_type.h>
 #include <cusp/detail/device/arch.h>
+#include <cusp/detail/device/arch_policy.h>
 #include <cusp/detail/device/common.h>
+#include <cusp/detail/device/launch_config.h>
+#include <cusp/detail/device/stream.h>
 #include <cusp/detail/device/utils.h>
 #include <cusp/detail/device/texture.h>
 
 #include <thrust/device_ptr.h>
 
+#include <sstream>
+#include <string>
+
 namespace cusp
 {
 namespace detail
@@ -44,28 +54,57 @@ namespace device
 //   coalesced, unlike kernels based on the one-row-per-thread division of 
 //   work.  Since an entire 32-thread warp is assigned to each row, many 
 //   threads will remain idle when their row contains a small number 
-//   of elements.  This code relies on implicit synchronization among 
-//   threads in a warp.
+//   of elements.  The threads of a row exchange their partial sums through
+//   warp shuffles with sm35_policy (cusp/detail/device/arch_policy.h),
+//   while sm20_policy relies on implicit synchronization among threads in
+//   a warp.
 //
 // spmv_csr_vector_tex_device
 //   Same as spmv_csr_vector_tex_device, except that the texture cache is 
 //   used for accessing the x vector.
 //  
+// The local sums are kept in an accumulator of the Accumulation policy
+// (cusp/detail/accumulator.h), which compensated_reduction selects as
+// compensated_accumulation.  Without warp shuffles only the per-thread sums
+// are compensated, and the threads of a row add their results plainly.
+//
+// The positions of the entries (Ap and the loops over a row) have the
+// OffsetType of the row offsets, which may be wider than the IndexType of
+// the rows and columns (cusp/detail/offset_type.h).
+//
 //  Note: THREADS_PER_VECTOR must be one of [2,4,8,16,32]
 
 
-template <typename IndexType, typename ValueType, unsigned int VECTORS_PER_BLOCK, unsigned int THREADS_PER_VECTOR, bool UseCache>
+// The values of the entries as the kernel reads them: the values array of
+// the matrix, unless a matrix storing them otherwise specializes this to
+// return an object whose operator[] yields the value of an entry.
+template <typename Matrix>
+struct csr_vector_values
+{
+    typedef const typename Matrix::value_type * type;
+
+    static type get(const Matrix& A)
+    {
+        return thrust::raw_pointer_cast(&A.values[0]);
+    }
+};
+
+
+template <typename Policy, typename IndexType, typename OffsetType, typename ValueType, typename MatrixValues, unsigned int VECTORS_PER_BLOCK, unsigned int THREADS_PER_VECTOR, bool UseCache, typename Accumulation>
 __launch_bounds__(VECTORS_PER_BLOCK * THREADS_PER_VECTOR,1)
 __global__ void
 spmv_csr_vector_kernel(const IndexType num_rows,
-                       const IndexType * Ap, 
+                       const OffsetType * Ap, 
                        const IndexType * Aj, 
-                       const ValueType * Ax, 
-                       const ValueType * x, 
+                       const MatrixValues Ax, 
+                       const cached_x<ValueType> x, 
                              ValueType * y)
 {
-    __shared__ volatile ValueType sdata[VECTORS_PER_BLOCK * THREADS_PER_VECTOR + THREADS_PER_VECTOR / 2];  // padded to avoid reduction conditionals
-    __shared__ volatile IndexType ptrs[VECTORS_PER_BLOCK][2];
+    const bool USE_SHUFFLE = arch::use_warp_shuffle<Policy>::value;
+
+    // only the exchanges without shuffles go through shared memory
+    __shared__ volatile ValueType sdata[USE_SHUFFLE ? 1 : VECTORS_PER_BLOCK * THREADS_PER_VECTOR + THREADS_PER_VECTOR / 2];  // padded to avoid reduction conditionals
+    __shared__ volatile OffsetType ptrs[USE_SHUFFLE ? 1 : VECTORS_PER_BLOCK][2];
     
     const IndexType THREADS_PER_BLOCK = VECTORS_PER_BLOCK * THREADS_PER_VECTOR;
 
@@ -75,39 +114,76 @@ spmv_csr_vector_kernel(const IndexType num_rows,
     const IndexType vector_lane = threadIdx.x /  THREADS_PER_VECTOR;               // vector index within the block
     const IndexType num_vectors = VECTORS_PER_BLOCK * gridDim.x;                   // total number of active vectors
 
+#ifdef __CUSP_HAS_WARP_SHUFFLE__
+    const unsigned int mask = arch::lane_mask<THREADS_PER_VECTOR>(threadIdx.x);
+#endif
+
     for(IndexType row = vector_id; row < num_rows; row += num_vectors)
     {
+        OffsetType row_start;
+        OffsetType row_end;
+
         // use two threads to fetch Ap[row] and Ap[row+1]
         // this is considerably faster than the straightforward version
-        if(thread_lane < 2)
-            ptrs[vector_lane][thread_lane] = Ap[row + thread_lane];
+#ifdef __CUSP_HAS_WARP_SHUFFLE__
+        if (USE_SHUFFLE)
+        {
+            OffsetType ptr = 0;
+            if(thread_lane < 2)
+                ptr = Ap[row + thread_lane];
+
+            row_start = arch::shfl(mask, ptr, 0, THREADS_PER_VECTOR);   //same as: row_start = Ap[row];
+            row_end   = arch::shfl(mask, ptr, 1, THREADS_PER_VECTOR);   //same as: row_end   = Ap[row+1];
+        }
+        else
+#endif
+        {
+            if(thread_lane < 2)
+                ptrs[vector_lane][thread_lane] = Ap[row + thread_lane];
 
-        const IndexType row_start = ptrs[vector_lane][0];                   //same as: row_start = Ap[row];
-        const IndexType row_end   = ptrs[vector_lane][1];                   //same as: row_end   = Ap[row+1];
+            row_start = ptrs[vector_lane][0];                   //same as: row_start = Ap[row];
+            row_end   = ptrs[vector_lane][1];                   //same as: row_end   = Ap[row+1];
+        }
 
         // initialize local sum
-        ValueType sum = 0;
+        accumulator<ValueType, Accumulation> acc;
      
-        if (THREADS_PER_VECTOR == 32 && row_end - row_start > 32)
+        if (THREADS_PER_VECTOR == Policy::WARP_SIZE && row_end - row_start > OffsetType(Policy::WARP_SIZE))
         {
             // ensure aligned memory access to Aj and Ax
 
-            IndexType jj = row_start - (row_start & (THREADS_PER_VECTOR - 1)) + thread_lane;
+            OffsetType jj = row_start - (row_start & (THREADS_PER_VECTOR - 1)) + thread_lane;
 
             // accumulate local sums
             if(jj >= row_start && jj < row_end)
-                sum += Ax[jj] * fetch_x<UseCache>(Aj[jj], x);
+                acc.add_product(ValueType(Ax[jj]), fetch_x<UseCache>(Aj[jj], x));
 
             // accumulate local sums
             for(jj += THREADS_PER_VECTOR; jj < row_end; jj += THREADS_PER_VECTOR)
-                sum += Ax[jj] * fetch_x<UseCache>(Aj[jj], x);
+                acc.add_product(ValueType(Ax[jj]), fetch_x<UseCache>(Aj[jj], x));
         }
         else
         {
             // accumulate local sums
-            for(IndexType jj = row_start + thread_lane; jj < row_end; jj += THREADS_PER_VECTOR)
-                sum += Ax[jj] * fetch_x<UseCache>(Aj[jj], x);
+            for(OffsetType jj = row_start + thread_lane; jj < row_end; jj += THREADS_PER_VECTOR)
+                acc.add_product(ValueType(Ax[jj]), fetch_x<UseCache>(Aj[jj], x));
+        }
+
+#ifdef __CUSP_HAS_WARP_SHUFFLE__
+        if (USE_SHUFFLE)
+        {
+            // reduce local sums to row sum
+            acc = arch::reduce_lanes<THREADS_PER_VECTOR>(mask, acc);
+
+            // first thread writes the result
+            if (thread_lane == 0)
+                y[row] = acc.result();
+
+            continue;
         }
+#endif
+
+        ValueType sum = acc.result();
 
         // store local sum in shared memory
         sdata[threadIdx.x] = sum;
@@ -125,49 +201,123 @@ spmv_csr_vector_kernel(const IndexType num_rows,
     }
 }
 
-template <bool UseCache, unsigned int THREADS_PER_VECTOR, typename Matrix, typename ValueType>
+template <typename Policy, bool UseCache, unsigned int THREADS_PER_VECTOR, unsigned int THREADS_PER_BLOCK, typename Accumulation, typename Matrix, typename ValueType>
 void __spmv_csr_vector(const Matrix&    A, 
                        const ValueType* x, 
-                             ValueType* y)
+                             ValueType* y,
+                       const arch::launch_config& config)
 {
     typedef typename Matrix::index_type IndexType;
+    typedef typename cusp::detail::offset_type<Matrix>::type OffsetType;
+    typedef typename csr_vector_values<Matrix>::type MatrixValues;
 
-    const size_t THREADS_PER_BLOCK  = 128;
     const size_t VECTORS_PER_BLOCK  = THREADS_PER_BLOCK / THREADS_PER_VECTOR;
 
-    const size_t MAX_BLOCKS = cusp::detail::device::arch::max_active_blocks(spmv_csr_vector_kernel<IndexType, ValueType, VECTORS_PER_BLOCK, THREADS_PER_VECTOR, UseCache>, THREADS_PER_BLOCK, (size_t) 0);
-    const size_t NUM_BLOCKS = std::min<size_t>(MAX_BLOCKS, DIVIDE_INTO(A.num_rows, VECTORS_PER_BLOCK));
+    const size_t MAX_BLOCKS = cusp::detail::device::arch::max_active_blocks(spmv_csr_vector_kernel<Policy, IndexType, OffsetType, ValueType, MatrixValues, VECTORS_PER_BLOCK, THREADS_PER_VECTOR, UseCache, Accumulation>, THREADS_PER_BLOCK, (size_t) 0);
+    const size_t NUM_BLOCKS = cusp::detail::device::arch::launch_blocks(config, MAX_BLOCKS, DIVIDE_INTO(A.num_rows, VECTORS_PER_BLOCK));
     
-    if (UseCache)
-        bind_x(x);
+    const cached_x<ValueType> x_cached = bind_x<UseCache, Policy>(x, A.num_cols);
 
-    spmv_csr_vector_kernel<IndexType, ValueType, VECTORS_PER_BLOCK, THREADS_PER_VECTOR, UseCache> <<<NUM_BLOCKS, THREADS_PER_BLOCK>>> 
+    spmv_csr_vector_kernel<Policy, IndexType, OffsetType, ValueType, MatrixValues, VECTORS_PER_BLOCK, THREADS_PER_VECTOR, UseCache, Accumulation> <<<NUM_BLOCKS, THREADS_PER_BLOCK, 0, cusp::detail::device::current_stream()>>> 
         (A.num_rows,
          thrust::raw_pointer_cast(&A.row_offsets[0]),
          thrust::raw_pointer_cast(&A.column_indices[0]),
-         thrust::raw_pointer_cast(&A.values[0]),
-         x, y);
+         csr_vector_values<Matrix>::get(A),
+         x_cached, y);
 
-    if (UseCache)
-        unbind_x(x);
+    unbind_x(x_cached);
 }
 
-template <typename Matrix,
+// block size from the launch database, the default of Policy otherwise
+template <typename Policy, bool UseCache, unsigned int THREADS_PER_VECTOR, typename Accumulation, typename Matrix, typename ValueType>
+void __spmv_csr_vector_block(const Matrix&    A, 
+                             const ValueType* x, 
+                                   ValueType* y,
+                             const arch::launch_config& config)
+{
+    switch (config.block_size)
+    {
+        case  64: __spmv_csr_vector<Policy, UseCache, THREADS_PER_VECTOR,  64, Accumulation>(A, x, y, config); return;
+        case 128: __spmv_csr_vector<Policy, UseCache, THREADS_PER_VECTOR, 128, Accumulation>(A, x, y, config); return;
+        case 256: __spmv_csr_vector<Policy, UseCache, THREADS_PER_VECTOR, 256, Accumulation>(A, x, y, config); return;
+        case 512: __spmv_csr_vector<Policy, UseCache, THREADS_PER_VECTOR, 512, Accumulation>(A, x, y, config); return;
+        default:  __spmv_csr_vector<Policy, UseCache, THREADS_PER_VECTOR, Policy::CSR_VECTOR_BLOCK_SIZE, Accumulation>(A, x, y, config); return;
+    }
+}
+
+// name of the csr_vector kernel in the launch database, per class of rows
+inline std::string csr_vector_launch_name(bool use_cache, unsigned int threads_per_vector)
+{
+    std::ostringstream name;
+    name << (use_cache ? "csr_vector_tex/" : "csr_vector/") << threads_per_vector;
+    return name.str();
+}
+
+// choose the number of threads per row from the average row length, unless
+// the launch database chooses another one for this class of rows
+template <typename Policy,
+          bool UseCache,
+          typename Accumulation,
+          typename Matrix,
           typename ValueType>
-void spmv_csr_vector(const Matrix&    A, 
-                     const ValueType* x, 
-                           ValueType* y)
+void __spmv_csr_vector_select(const Matrix&    A, 
+                              const ValueType* x, 
+                                    ValueType* y)
 {
     typedef typename Matrix::index_type IndexType;
 
     const IndexType nnz_per_row = A.num_entries / A.num_rows;
 
-    if (nnz_per_row <=  2) { __spmv_csr_vector<false, 2>(A, x, y); return; }
-    if (nnz_per_row <=  4) { __spmv_csr_vector<false, 4>(A, x, y); return; }
-    if (nnz_per_row <=  8) { __spmv_csr_vector<false, 8>(A, x, y); return; }
-    if (nnz_per_row <= 16) { __spmv_csr_vector<false,16>(A, x, y); return; }
-    
-    __spmv_csr_vector<false,32>(A, x, y);
+    unsigned int threads_per_vector = 32;
+
+    if      (nnz_per_row <=  2) threads_per_vector =  2;
+    else if (nnz_per_row <=  4) threads_per_vector =  4;
+    else if (nnz_per_row <=  8) threads_per_vector =  8;
+    else if (nnz_per_row <= 16) threads_per_vector = 16;
+
+    const arch::launch_config config = arch::tuned_launch(csr_vector_launch_name(UseCache, threads_per_vector), sizeof(ValueType));
+
+    if (config.threads_per_vector != 0)
+        threads_per_vector = config.threads_per_vector;
+
+    switch (threads_per_vector)
+    {
+        case  2: __spmv_csr_vector_block<Policy, UseCache, 2,Accumulation>(A, x, y, config); return;
+        case  4: __spmv_csr_vector_block<Policy, UseCache, 4,Accumulation>(A, x, y, config); return;
+        case  8: __spmv_csr_vector_block<Policy, UseCache, 8,Accumulation>(A, x, y, config); return;
+        case 16: __spmv_csr_vector_block<Policy, UseCache,16,Accumulation>(A, x, y, config); return;
+        default: __spmv_csr_vector_block<Policy, UseCache,32,Accumulation>(A, x, y, config); return;
+    }
+}
+
+// the instantiation of the generation of the current device
+template <bool UseCache,
+          typename Accumulation,
+          typename Matrix,
+          typename ValueType>
+void __spmv_csr_vector_arch(const Matrix&    A, 
+                            const ValueType* x, 
+                                  ValueType* y)
+{
+    switch (arch::current_policy())
+    {
+#if CUSP_MIN_ARCH < 350
+        case arch::SM20_POLICY: __spmv_csr_vector_select<arch::sm20_policy, UseCache, Accumulation>(A, x, y); return;
+#endif
+        default:                __spmv_csr_vector_select<arch::sm35_policy, UseCache, Accumulation>(A, x, y); return;
+    }
+}
+
+template <typename Matrix,
+          typename ValueType>
+void spmv_csr_vector(const Matrix&    A, 
+                     const ValueType* x, 
+                           ValueType* y)
+{
+    if (cusp::current_reduction_mode() == cusp::compensated_reduction)
+        __spmv_csr_vector_arch<false, compensated_accumulation>(A, x, y);
+    else
+        __spmv_csr_vector_arch<false, plain_accumulation>(A, x, y);
 }
 
 template <typename Matrix,
@@ -176,16 +326,10 @@ void spmv_csr_vector_tex(const Matrix&    A,
                          const ValueType* x, 
                                ValueType* y)
 {
-    typedef typename Matrix::index_type IndexType;
-
-    const IndexType nnz_per_row = A.num_entries / A.num_rows;
-
-    if (nnz_per_row <=  2) { __spmv_csr_vector<true, 2>(A, x, y); return; }
-    if (nnz_per_row <=  4) { __spmv_csr_vector<true, 4>(A, x, y); return; }
-    if (nnz_per_row <=  8) { __spmv_csr_vector<true, 8>(A, x, y); return; }
-    if (nnz_per_row <= 16) { __spmv_csr_vector<true,16>(A, x, y); return; }
-
-    __spmv_csr_vector<true,32>(A, x, y);
+    if (cusp::current_reduction_mode() == cusp::compensated_reduction)
+        __spmv_csr_vector_arch<true, compensated_accumulation>(A, x, y);
+    else
+        __spmv_csr_vector_arch<true, plain_accumulation>(A, x, y);
 }
 
 } // end namespace device
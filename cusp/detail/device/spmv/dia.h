@@ -21,6 +21,8 @@
 
 #include <cusp/detail/device/arch.h>
 #include <cusp/detail/device/common.h>
+#include <cusp/detail/stream.h>
+#include <cusp/detail/device/stream.h>
 #include <cusp/detail/device/utils.h>
 #include <cusp/detail/device/texture.h>
 
@@ -52,6 +54,17 @@ namespace device
 // spmv_dia_tex
 //   Same as spmv_dia, except x is accessed via texture cache.
 //
+// spmv_dia_tiled
+//   Each block stages the part of x read by a run of diagonals for its
+//   rows in shared memory and applies all the diagonals of the run from
+//   there.  A run is a maximal sequence of consecutive diagonals whose
+//   offsets span at most DIA_TILE_HALO, so the three adjacent diagonals
+//   of each grid line of a 3D stencil share one tile of x (and a 2D
+//   stencil on a narrow grid, or a banded matrix, shares a single tile
+//   between all its diagonals).  Every value of x is then loaded from
+//   global memory once per run rather than once per diagonal.  The runs
+//   are found by every block from the offsets, with no setup.
+//
 
 
 template <typename IndexType, typename ValueType, unsigned int BLOCK_SIZE, bool UseCache>
@@ -63,7 +76,7 @@ spmv_dia_kernel(const IndexType num_rows,
                 const IndexType pitch,
                 const IndexType * diagonal_offsets,
                 const ValueType * values,
-                const ValueType * x, 
+                const cached_x<ValueType> x, 
                       ValueType * y)
 {
     __shared__ IndexType offsets[BLOCK_SIZE];
@@ -110,7 +123,83 @@ spmv_dia_kernel(const IndexType num_rows,
     }
 }
 
-    
+
+// largest span of the offsets of the diagonals sharing a tile of x
+const unsigned int DIA_TILE_HALO = 1024;
+
+template <typename IndexType, typename ValueType, unsigned int BLOCK_SIZE>
+__launch_bounds__(BLOCK_SIZE,1)
+__global__ void
+spmv_dia_tiled_kernel(const IndexType num_rows,
+                      const IndexType num_cols,
+                      const IndexType num_diagonals,
+                      const IndexType pitch,
+                      const IndexType * diagonal_offsets,
+                      const ValueType * values,
+                      const ValueType * x,
+                            ValueType * y)
+{
+    __shared__ ValueType x_tile[BLOCK_SIZE + DIA_TILE_HALO];
+
+    const IndexType grid_size = BLOCK_SIZE * gridDim.x;
+
+    for(IndexType base = BLOCK_SIZE * blockIdx.x; base < num_rows; base += grid_size)
+    {
+        const IndexType row = base + threadIdx.x;
+
+        ValueType sum = ValueType(0);
+
+        for(IndexType first = 0; first < num_diagonals; )
+        {
+            // the run of diagonals starting at first
+            IndexType lo   = diagonal_offsets[first];
+            IndexType hi   = lo;
+            IndexType last = first + 1;
+
+            while(last < num_diagonals)
+            {
+                const IndexType offset = diagonal_offsets[last];
+                const IndexType run_lo = thrust::min(lo, offset);
+                const IndexType run_hi = thrust::max(hi, offset);
+
+                if(run_hi - run_lo > IndexType(DIA_TILE_HALO))
+                    break;
+
+                lo = run_lo;
+                hi = run_hi;
+                last++;
+            }
+
+            // wait until all threads are done reading the previous tile
+            __syncthreads();
+
+            for(IndexType i = threadIdx.x; i < IndexType(BLOCK_SIZE) + hi - lo; i += BLOCK_SIZE)
+            {
+                const IndexType col = base + lo + i;
+                x_tile[i] = (col >= 0 && col < num_cols) ? x[col] : ValueType(0);
+            }
+
+            __syncthreads();
+
+            if(row < num_rows)
+            {
+                for(IndexType n = first; n < last; n++)
+                {
+                    const IndexType col = row + diagonal_offsets[n];
+
+                    if(col >= 0 && col < num_cols)
+                        sum += values[row + pitch * n] * x_tile[col - base - lo];
+                }
+            }
+
+            first = last;
+        }
+
+        if(row < num_rows)
+            y[row] = sum;
+    }
+}
+
 template <bool UseCache,
           typename Matrix,
           typename ValueType>
@@ -131,21 +220,19 @@ void __spmv_dia(const Matrix&    A,
     if (num_diagonals == 0)
     {
         // empty matrix
-        thrust::fill(thrust::device_pointer_cast(y), thrust::device_pointer_cast(y) + A.num_rows, ValueType(0));
+        cusp::detail::stream::fill(thrust::device_pointer_cast(y), thrust::device_pointer_cast(y) + A.num_rows, ValueType(0));
         return;
     }
 
-    if (UseCache)
-        bind_x(x);
+    const cached_x<ValueType> x_cached = bind_x<UseCache>(x, A.num_cols);
   
-    spmv_dia_kernel<IndexType, ValueType, BLOCK_SIZE, UseCache> <<<NUM_BLOCKS, BLOCK_SIZE>>>
+    spmv_dia_kernel<IndexType, ValueType, BLOCK_SIZE, UseCache> <<<NUM_BLOCKS, BLOCK_SIZE, 0, cusp::detail::device::current_stream()>>>
         (A.num_rows, A.num_cols, num_diagonals, pitch,
          thrust::raw_pointer_cast(&A.diagonal_offsets[0]),
          thrust::raw_pointer_cast(&A.values.values[0]),
-         x, y);
+         x_cached, y);
 
-    if (UseCache)
-        unbind_x(x);
+    unbind_x(x_cached);
 }
 
 template <typename Matrix,
@@ -166,6 +253,35 @@ void spmv_dia_tex(const Matrix&    A,
     __spmv_dia<true>(A, x, y);
 }
 
+template <typename Matrix,
+          typename ValueType>
+void spmv_dia_tiled(const Matrix&    A,
+                    const ValueType* x,
+                          ValueType* y)
+{
+    typedef typename Matrix::index_type IndexType;
+
+    const size_t BLOCK_SIZE = 256;
+    const size_t MAX_BLOCKS = cusp::detail::device::arch::max_active_blocks(spmv_dia_tiled_kernel<IndexType, ValueType, BLOCK_SIZE>, BLOCK_SIZE, (size_t) 0);
+    const size_t NUM_BLOCKS = std::min<size_t>(MAX_BLOCKS, DIVIDE_INTO(A.num_rows, BLOCK_SIZE));
+
+    const IndexType num_diagonals = A.values.num_cols;
+    const IndexType pitch         = A.values.pitch;
+
+    if (num_diagonals == 0)
+    {
+        // empty matrix
+        cusp::detail::stream::fill(thrust::device_pointer_cast(y), thrust::device_pointer_cast(y) + A.num_rows, ValueType(0));
+        return;
+    }
+
+    spmv_dia_tiled_kernel<IndexType, ValueType, BLOCK_SIZE> <<<NUM_BLOCKS, BLOCK_SIZE, 0, cusp::detail::device::current_stream()>>>
+        (A.num_rows, A.num_cols, num_diagonals, pitch,
+         thrust::raw_pointer_cast(&A.diagonal_offsets[0]),
+         thrust::raw_pointer_cast(&A.values.values[0]),
+         x, y);
+}
+
 } // end namespace device
 } // end namespace detail
 } // end namespace cusp
@@ -17,14 +17,34 @@
 
 #pragma once
 
+#include <cusp/reduction.h>
+
+#include <cusp/detail/accumulator.h>
+#include <cusp/detail/offset_type.h>
 #include <cusp/detail/device/arch.h>
+#include <cusp/detail/device/arch_policy.h>
 #include <cusp/detail/device/common.h>
+#include <cusp/detail/device/launch_config.h>
+#include <cusp/detail/device/stream.h>
 #include <cusp/detail/device/utils.h>
 #include <cusp/detail/device/texture.h>
+#include <cusp/detail/device/unrolled_widths.h>
 
 #include <thrust/device_ptr.h>
 
-// SpMV kernel for the ELLPACK/ITPACK matrix format.
+// SpMV kernel for the ELLPACK/ITPACK matrix format.  The row sums are kept
+// in an accumulator of the Accumulation policy (cusp/detail/accumulator.h),
+// which compensated_reduction selects as compensated_accumulation.
+//
+// WIDTH > 0 is the number of stored entries per row, known at compile
+// time for the widths of CUSP_ELL_UNROLLED_WIDTHS: the column indices of
+// a row are then loaded into registers up front and the loop over the
+// row is unrolled.  WIDTH == 0 reads the width at runtime.
+//
+// The positions row + n * pitch of the entries are computed in OffsetType,
+// the index type of the matrix unless its padded storage exceeds the range
+// of the index type, in which case they are computed in wide_offset_type
+// (cusp/detail/offset_type.h) while the column indices keep their type.
 
 namespace cusp
 {
@@ -33,78 +53,165 @@ namespace detail
 namespace device
 {
 
-template <typename IndexType, typename ValueType, size_t BLOCK_SIZE, bool UseCache>
+template <typename Policy, typename IndexType, typename OffsetType, typename ValueType, typename MatrixValueType, size_t BLOCK_SIZE, unsigned int WIDTH, bool UseCache, typename Accumulation>
 __launch_bounds__(BLOCK_SIZE,1)
 __global__ void
 spmv_ell_kernel(const IndexType num_rows, 
                 const IndexType num_cols, 
                 const IndexType num_cols_per_row,
-                const IndexType pitch,
+                const OffsetType pitch,
                 const IndexType * Aj,
-                const ValueType * Ax, 
-                const ValueType * x, 
+                const MatrixValueType * Ax, 
+                const cached_x<ValueType> x, 
                       ValueType * y)
 {
-    const IndexType invalid_index = cusp::ell_matrix<IndexType, ValueType, cusp::device_memory>::invalid_index;
+    const IndexType invalid_index = cusp::ell_matrix<IndexType, MatrixValueType, cusp::device_memory>::invalid_index;
 
     const IndexType thread_id = blockDim.x * blockIdx.x + threadIdx.x;
     const IndexType grid_size = gridDim.x * blockDim.x;
 
     for(IndexType row = thread_id; row < num_rows; row += grid_size)
     {
-        ValueType sum = 0;
-
-        IndexType offset = row;
+        accumulator<ValueType, Accumulation> acc;
 
-        for(IndexType n = 0; n < num_cols_per_row; n++)
+        if (WIDTH > 0)
         {
-            const IndexType col = Aj[offset];
+            IndexType cols[WIDTH > 0 ? WIDTH : 1];
+
+#pragma unroll
+            for(unsigned int n = 0; n < WIDTH; n++)
+                cols[n] = Aj[OffsetType(row) + OffsetType(n) * pitch];
 
-            if (col != invalid_index)
+#pragma unroll
+            for(unsigned int n = 0; n < WIDTH; n++)
             {
-                const ValueType A_ij = Ax[offset];
-                sum += A_ij * fetch_x<UseCache>(col, x);
+                if (cols[n] != invalid_index)
+                {
+                    const ValueType A_ij = Ax[OffsetType(row) + OffsetType(n) * pitch];
+                    acc.add_product(A_ij, fetch_x<UseCache>(cols[n], x));
+                }
             }
+        }
+        else
+        {
+            OffsetType offset = row;
 
-            offset += pitch;
+            for(IndexType n = 0; n < num_cols_per_row; n++)
+            {
+                const IndexType col = Aj[offset];
+
+                if (col != invalid_index)
+                {
+                    const ValueType A_ij = Ax[offset];
+                    acc.add_product(A_ij, fetch_x<UseCache>(col, x));
+                }
+
+                offset += pitch;
+            }
         }
 
-        y[row] = sum;
+        y[row] = acc.result();
     }
 }
 
 
-template <bool UseCache,
+template <typename Policy,
+          bool UseCache,
+          size_t BLOCK_SIZE,
+          unsigned int WIDTH,
+          typename Accumulation,
+          typename OffsetType,
           typename Matrix,
           typename ValueType>
 void __spmv_ell(const Matrix&    A, 
                 const ValueType* x, 
-                      ValueType* y)
+                      ValueType* y,
+                const arch::launch_config& config)
 {
     typedef typename Matrix::index_type IndexType;
+    typedef typename Matrix::value_type MatrixValueType;
 
-    const size_t BLOCK_SIZE = 256;
-    const size_t MAX_BLOCKS = cusp::detail::device::arch::max_active_blocks(spmv_ell_kernel<IndexType,ValueType,BLOCK_SIZE,UseCache>, BLOCK_SIZE, (size_t) 0);
-    const size_t NUM_BLOCKS = std::min<size_t>(MAX_BLOCKS, DIVIDE_INTO(A.num_rows, BLOCK_SIZE));
+    const size_t MAX_BLOCKS = cusp::detail::device::arch::max_active_blocks(spmv_ell_kernel<Policy,IndexType,OffsetType,ValueType,MatrixValueType,BLOCK_SIZE,WIDTH,UseCache,Accumulation>, BLOCK_SIZE, (size_t) 0);
+    const size_t NUM_BLOCKS = cusp::detail::device::arch::launch_blocks(config, MAX_BLOCKS, DIVIDE_INTO(A.num_rows, BLOCK_SIZE));
 
-    const IndexType pitch               = A.column_indices.pitch;
+    const OffsetType pitch              = A.column_indices.pitch;
     const IndexType num_entries_per_row = A.column_indices.num_cols;
 
     // TODO generalize this
     assert(A.column_indices.pitch == A.values.pitch);
     
-    if (UseCache)
-        bind_x(x);
+    const cached_x<ValueType> x_cached = bind_x<UseCache, Policy>(x, A.num_cols);
 
-    spmv_ell_kernel<IndexType,ValueType,BLOCK_SIZE,UseCache> <<<NUM_BLOCKS, BLOCK_SIZE>>>
+    spmv_ell_kernel<Policy,IndexType,OffsetType,ValueType,MatrixValueType,BLOCK_SIZE,WIDTH,UseCache,Accumulation> <<<NUM_BLOCKS, BLOCK_SIZE, 0, cusp::detail::device::current_stream()>>>
         (A.num_rows, A.num_cols,
          num_entries_per_row, pitch,
          thrust::raw_pointer_cast(&A.column_indices.values[0]), 
          thrust::raw_pointer_cast(&A.values.values[0]),
-         x, y);
+         x_cached, y);
+
+    unbind_x(x_cached);
+}
+
+// block size from the launch database, the default of Policy otherwise.
+// The widths of CUSP_ELL_UNROLLED_WIDTHS are only instantiated with the
+// default block size of Policy, which bounds the number of kernels; the
+// grid size of the launch database still applies.
+template <typename Policy,
+          bool UseCache,
+          typename Accumulation,
+          typename Matrix,
+          typename ValueType>
+void __spmv_ell_block(const Matrix&    A, 
+                      const ValueType* x, 
+                            ValueType* y)
+{
+    typedef typename Matrix::index_type IndexType;
+
+    const arch::launch_config config = arch::tuned_launch(UseCache ? "ell_tex" : "ell", sizeof(ValueType));
 
-    if (UseCache)
-        unbind_x(x);
+    // storage beyond the range of IndexType is only addressed by the
+    // generic kernel of the default block size
+    if (!cusp::detail::offsets_fit<IndexType>(A.column_indices.pitch * A.column_indices.num_cols))
+    {
+        __spmv_ell<Policy, UseCache, Policy::ELL_BLOCK_SIZE, 0, Accumulation, cusp::detail::wide_offset_type>(A, x, y, config);
+        return;
+    }
+
+    switch (A.column_indices.num_cols)
+    {
+#define __CUSP_ELL_WIDTH_CASE(WIDTH) \
+        case WIDTH: __spmv_ell<Policy, UseCache, Policy::ELL_BLOCK_SIZE, WIDTH, Accumulation, IndexType>(A, x, y, config); return;
+        CUSP_ELL_UNROLLED_WIDTHS(__CUSP_ELL_WIDTH_CASE)
+#undef __CUSP_ELL_WIDTH_CASE
+        default: break;
+    }
+
+    switch (config.block_size)
+    {
+        case  64: __spmv_ell<Policy, UseCache,  64, 0, Accumulation, IndexType>(A, x, y, config); return;
+        case 128: __spmv_ell<Policy, UseCache, 128, 0, Accumulation, IndexType>(A, x, y, config); return;
+        case 256: __spmv_ell<Policy, UseCache, 256, 0, Accumulation, IndexType>(A, x, y, config); return;
+        case 512: __spmv_ell<Policy, UseCache, 512, 0, Accumulation, IndexType>(A, x, y, config); return;
+        default:  __spmv_ell<Policy, UseCache, Policy::ELL_BLOCK_SIZE, 0, Accumulation, IndexType>(A, x, y, config); return;
+    }
+}
+
+// the instantiation of the generation of the current device
+template <bool UseCache,
+          typename Accumulation,
+          typename Matrix,
+          typename ValueType>
+void __spmv_ell(const Matrix&    A, 
+                const ValueType* x, 
+                      ValueType* y)
+{
+    switch (arch::current_policy())
+    {
+#if CUSP_MIN_ARCH < 350
+        case arch::SM20_POLICY: __spmv_ell_block<arch::sm20_policy, UseCache, Accumulation>(A, x, y); return;
+#endif
+        default:                __spmv_ell_block<arch::sm35_policy, UseCache, Accumulation>(A, x, y); return;
+    }
 }
 
 template <typename Matrix,
@@ -113,7 +220,10 @@ void spmv_ell(const Matrix&    A,
               const ValueType* x, 
                     ValueType* y)
 {
-    __spmv_ell<false>(A, x, y);
+    if (cusp::current_reduction_mode() == cusp::compensated_reduction)
+        __spmv_ell<false, compensated_accumulation>(A, x, y);
+    else
+        __spmv_ell<false, plain_accumulation>(A, x, y);
 }
 
 template <typename Matrix,
@@ -122,7 +232,10 @@ void spmv_ell_tex(const Matrix&    A,
                   const ValueType* x, 
                         ValueType* y)
 {
-    __spmv_ell<true>(A, x, y);
+    if (cusp::current_reduction_mode() == cusp::compensated_reduction)
+        __spmv_ell<true, compensated_accumulation>(A, x, y);
+    else
+        __spmv_ell<true, plain_accumulation>(A, x, y);
 }
 
 } // end namespace device
@@ -0,0 +1,229 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include <cusp/complex.h>
+#include <cusp/reduction.h>
+
+#include <cusp/detail/accumulator.h>
+#include <cusp/detail/device/arch.h>
+#include <cusp/detail/device/common.h>
+#include <cusp/detail/device/stream.h>
+#include <cusp/detail/device/utils.h>
+
+#include <thrust/device_ptr.h>
+
+#include <algorithm>
+
+// SpMV with an ellr_operator (cusp/ellr_operator.h), i.e. ELLPACK-R with
+// the entries of each row grouped in chunks of ELLR_CHUNK_SIZE.
+//
+// Chunk k of row i starts at (k * pitch + i) * ELLR_CHUNK_SIZE, so one
+// thread per row reads a whole chunk with one 128-bit load of the column
+// indices (and one or two of the values) and the threads of a warp read
+// consecutive chunks.  Each thread stops after the chunks of its own row
+// rather than running over the width of the longest row; the padding of
+// the last chunk of a row has column 0 and value 0.
+
+namespace cusp
+{
+namespace detail
+{
+namespace device
+{
+
+const unsigned int ELLR_CHUNK_SIZE = 4;
+
+// the four entries of a chunk, with vector loads for the 4 and 8 byte types
+template <typename T>
+struct ellr_chunk
+{
+    T v[4];
+
+    __host__ __device__
+    void load(const T * p)
+    {
+        for (int i = 0; i < 4; i++)
+            v[i] = p[i];
+    }
+};
+
+template <>
+struct ellr_chunk<int>
+{
+    int v[4];
+
+    __host__ __device__
+    void load(const int * p)
+    {
+#ifdef __CUDA_ARCH__
+        const int4 c = *reinterpret_cast<const int4*>(p);
+        v[0] = c.x; v[1] = c.y; v[2] = c.z; v[3] = c.w;
+#else
+        for (int i = 0; i < 4; i++)
+            v[i] = p[i];
+#endif
+    }
+};
+
+template <>
+struct ellr_chunk<float>
+{
+    float v[4];
+
+    __host__ __device__
+    void load(const float * p)
+    {
+#ifdef __CUDA_ARCH__
+        const float4 c = *reinterpret_cast<const float4*>(p);
+        v[0] = c.x; v[1] = c.y; v[2] = c.z; v[3] = c.w;
+#else
+        for (int i = 0; i < 4; i++)
+            v[i] = p[i];
+#endif
+    }
+};
+
+template <>
+struct ellr_chunk<double>
+{
+    double v[4];
+
+    __host__ __device__
+    void load(const double * p)
+    {
+#ifdef __CUDA_ARCH__
+        const double2 a = *reinterpret_cast<const double2*>(p);
+        const double2 b = *reinterpret_cast<const double2*>(p + 2);
+        v[0] = a.x; v[1] = a.y; v[2] = b.x; v[3] = b.y;
+#else
+        for (int i = 0; i < 4; i++)
+            v[i] = p[i];
+#endif
+    }
+};
+
+// two values of a chunk per float4
+template <>
+struct ellr_chunk< cusp::complex<float> >
+{
+    cusp::complex<float> v[4];
+
+    __host__ __device__
+    void load(const cusp::complex<float> * p)
+    {
+#ifdef __CUDA_ARCH__
+        const float4 a = *reinterpret_cast<const float4*>(p);
+        const float4 b = *reinterpret_cast<const float4*>(p + 2);
+        v[0] = cusp::complex<float>(a.x, a.y);
+        v[1] = cusp::complex<float>(a.z, a.w);
+        v[2] = cusp::complex<float>(b.x, b.y);
+        v[3] = cusp::complex<float>(b.z, b.w);
+#else
+        for (int i = 0; i < 4; i++)
+            v[i] = p[i];
+#endif
+    }
+};
+
+template <typename IndexType, typename ValueType, typename MatrixValueType, typename Accumulation>
+__host__ __device__
+ValueType ellr_row(const IndexType row,
+                   const IndexType pitch,
+                   const IndexType * row_lengths,
+                   const IndexType * Aj,
+                   const MatrixValueType * Ax,
+                   const ValueType * x)
+{
+    const IndexType C = ELLR_CHUNK_SIZE;
+    const IndexType num_chunks = (row_lengths[row] + C - 1) / C;
+
+    accumulator<ValueType, Accumulation> acc;
+
+    IndexType offset = row * C;
+
+    for (IndexType k = 0; k < num_chunks; k++)
+    {
+        ellr_chunk<IndexType> cols;
+        ellr_chunk<MatrixValueType> vals;
+
+        cols.load(Aj + offset);
+        vals.load(Ax + offset);
+
+        for (IndexType n = 0; n < C; n++)
+            acc.add_product(ValueType(vals.v[n]), x[cols.v[n]]);
+
+        offset += pitch * C;
+    }
+
+    return acc.result();
+}
+
+template <typename IndexType, typename ValueType, typename MatrixValueType, unsigned int BLOCK_SIZE, typename Accumulation>
+__launch_bounds__(BLOCK_SIZE,1)
+__global__ void
+spmv_ellr_kernel(const IndexType num_rows,
+                 const IndexType pitch,
+                 const IndexType * row_lengths,
+                 const IndexType * Aj,
+                 const MatrixValueType * Ax,
+                 const ValueType * x,
+                       ValueType * y)
+{
+    const IndexType thread_id = BLOCK_SIZE * blockIdx.x + threadIdx.x;
+    const IndexType grid_size = BLOCK_SIZE * gridDim.x;
+
+    for (IndexType row = thread_id; row < num_rows; row += grid_size)
+        y[row] = ellr_row<IndexType,ValueType,MatrixValueType,Accumulation>(row, pitch, row_lengths, Aj, Ax, x);
+}
+
+template <typename Accumulation, typename Matrix, typename ValueType>
+void __spmv_ellr(const Matrix&    A,
+                 const ValueType* x,
+                       ValueType* y)
+{
+    typedef typename Matrix::index_type IndexType;
+    typedef typename Matrix::value_type MatrixValueType;
+
+    const unsigned int BLOCK_SIZE = 256;
+    const size_t MAX_BLOCKS = cusp::detail::device::arch::max_active_blocks(spmv_ellr_kernel<IndexType, ValueType, MatrixValueType, BLOCK_SIZE, Accumulation>, BLOCK_SIZE, (size_t) 0);
+    const size_t NUM_BLOCKS = std::min<size_t>(MAX_BLOCKS, DIVIDE_INTO(A.num_rows, BLOCK_SIZE));
+
+    // a matrix without entries has no chunks to point at
+    const IndexType * Aj = A.column_indices.empty() ? NULL : thrust::raw_pointer_cast(&A.column_indices[0]);
+    const MatrixValueType * Ax = A.values.empty() ? NULL : thrust::raw_pointer_cast(&A.values[0]);
+
+    spmv_ellr_kernel<IndexType, ValueType, MatrixValueType, BLOCK_SIZE, Accumulation> <<<NUM_BLOCKS, BLOCK_SIZE, 0, cusp::detail::device::current_stream()>>>
+        (A.num_rows, IndexType(A.pitch),
+         thrust::raw_pointer_cast(&A.row_lengths[0]),
+         Aj, Ax, x, y);
+}
+
+template <typename Matrix, typename ValueType>
+void spmv_ellr(const Matrix&    A,
+               const ValueType* x,
+                     ValueType* y)
+{
+    if (cusp::current_reduction_mode() == cusp::compensated_reduction)
+        __spmv_ellr<compensated_accumulation>(A, x, y);
+    else
+        __spmv_ellr<plain_accumulation>(A, x, y);
+}
+
+} // end namespace device
+} // end namespace detail
+} // end namespace cusp
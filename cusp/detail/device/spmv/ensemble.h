@@ -0,0 +1,130 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+#pragma once
+
+#include <cusp/reduction.h>
+
+#include <cusp/detail/accumulator.h>
+#include <cusp/detail/device/arch.h>
+#include <cusp/detail/device/common.h>
+#include <cusp/detail/device/stream.h>
+#include <cusp/detail/device/utils.h>
+
+#include <thrust/device_ptr.h>
+
+#include <algorithm>
+
+// SpMV with an ensemble_csr_operator (cusp/ensemble_csr_operator.h), i.e.
+// num_members matrices with one CSR pattern and interleaved values.
+//
+// Thread t computes member e = t % num_members of row t / num_members, so
+// the threads of a row read the same row offsets and column indices (one
+// broadcast load per warp) and consecutive values and entries of X.
+
+namespace cusp
+{
+namespace detail
+{
+namespace device
+{
+
+// entry (row, e) of Y = A_e * X(:,e)
+template <typename IndexType, typename ValueType, typename Accumulation>
+__host__ __device__
+ValueType ensemble_row(const IndexType row,
+                       const size_t e,
+                       const size_t num_members,
+                       const IndexType * Ap,
+                       const IndexType * Aj,
+                       const ValueType * Ax,
+                       const ValueType * X,
+                       const size_t X_pitch)
+{
+    accumulator<ValueType, Accumulation> acc;
+
+    const IndexType row_start = Ap[row];
+    const IndexType row_end   = Ap[row + 1];
+
+    for (IndexType jj = row_start; jj < row_end; jj++)
+        acc.add_product(Ax[jj * num_members + e], X[Aj[jj] * X_pitch + e]);
+
+    return acc.result();
+}
+
+template <typename IndexType, typename ValueType, unsigned int BLOCK_SIZE, typename Accumulation>
+__launch_bounds__(BLOCK_SIZE,1)
+__global__ void
+spmv_ensemble_kernel(const IndexType num_rows,
+                     const size_t num_members,
+                     const IndexType * Ap,
+                     const IndexType * Aj,
+                     const ValueType * Ax,
+                     const ValueType * X,
+                     const size_t X_pitch,
+                           ValueType * Y,
+                     const size_t Y_pitch)
+{
+    const size_t thread_id = size_t(BLOCK_SIZE) * blockIdx.x + threadIdx.x;
+    const size_t grid_size = size_t(BLOCK_SIZE) * gridDim.x;
+
+    const size_t num_threads = size_t(num_rows) * num_members;
+
+    for (size_t t = thread_id; t < num_threads; t += grid_size)
+    {
+        const IndexType row = t / num_members;
+        const size_t e      = t - size_t(row) * num_members;
+
+        Y[row * Y_pitch + e] = ensemble_row<IndexType,ValueType,Accumulation>(row, e, num_members, Ap, Aj, Ax, X, X_pitch);
+    }
+}
+
+template <typename Accumulation, typename Matrix, typename ValueType>
+void __spmv_ensemble(const Matrix&    A,
+                     const ValueType* X, const size_t X_pitch,
+                           ValueType* Y, const size_t Y_pitch)
+{
+    typedef typename Matrix::index_type IndexType;
+
+    const unsigned int BLOCK_SIZE = 256;
+    const size_t MAX_BLOCKS = cusp::detail::device::arch::max_active_blocks(spmv_ensemble_kernel<IndexType, ValueType, BLOCK_SIZE, Accumulation>, BLOCK_SIZE, (size_t) 0);
+    const size_t NUM_BLOCKS = std::min<size_t>(MAX_BLOCKS, DIVIDE_INTO(A.num_rows * A.num_members, BLOCK_SIZE));
+
+    // a pattern without entries has no indices to point at
+    const IndexType * Aj = A.column_indices.empty() ? NULL : thrust::raw_pointer_cast(&A.column_indices[0]);
+    const ValueType * Ax = A.values.empty() ? NULL : thrust::raw_pointer_cast(&A.values[0]);
+
+    spmv_ensemble_kernel<IndexType, ValueType, BLOCK_SIZE, Accumulation> <<<NUM_BLOCKS, BLOCK_SIZE, 0, cusp::detail::device::current_stream()>>>
+        (IndexType(A.num_rows), A.num_members,
+         thrust::raw_pointer_cast(&A.row_offsets[0]),
+         Aj, Ax, X, X_pitch, Y, Y_pitch);
+}
+
+template <typename Matrix, typename ValueType>
+void spmv_ensemble(const Matrix&    A,
+                   const ValueType* X, const size_t X_pitch,
+                         ValueType* Y, const size_t Y_pitch)
+{
+    if (cusp::current_reduction_mode() == cusp::compensated_reduction)
+        __spmv_ensemble<compensated_accumulation>(A, X, X_pitch, Y, Y_pitch);
+    else
+        __spmv_ensemble<plain_accumulation>(A, X, X_pitch, Y, Y_pitch);
+}
+
+} // end namespace device
+} // end namespace detail
+} // end namespace cusp
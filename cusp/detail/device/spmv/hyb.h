@@ -19,6 +19,9 @@
 
 #include <cusp/detail/device/spmv/ell.h>
 #include <cusp/detail/device/spmv/coo_flat.h>
+#include <cusp/detail/device/scratch.h>
+
+#include <thrust/extrema.h>
 
 namespace cusp
 {
@@ -27,14 +30,173 @@ namespace detail
 namespace device
 {
 
+//////////////////////////////////////////////////////////////////////////////
+// HYB SpMV kernel computing the ELL and COO parts in one launch
+//////////////////////////////////////////////////////////////////////////////
+//
+// spmv_hyb_kernel
+//   A persistent kernel whose warps claim tiles from one global counter.
+//   The first tiles hold ELL_TILE_ROWS rows of the ELL part each, and a
+//   warp computes them with one thread per row like spmv_ell_kernel, which
+//   overwrites y.  The remaining tiles are the tiles of the COO part, which
+//   spmv_coo_flat_tile adds to y with the single-pass carry propagation of
+//   coo_flat.h.  Every ELL tile is claimed before the first COO tile, so a
+//   COO tile only waits, before it touches y, for the ELL tiles which are
+//   still being processed by other warps.  y is thus written once by the
+//   ELL part and updated once per row by the COO part, in a single launch
+//   instead of one launch for each part.
+
+template <typename IndexType, typename ValueType, typename MatrixValueType, unsigned int BLOCK_SIZE, unsigned int ITEMS_PER_LANE, bool UseCache>
+__launch_bounds__(BLOCK_SIZE,1)
+__global__ void
+spmv_hyb_kernel(const IndexType num_rows,
+                const IndexType num_ell_tiles,
+                const IndexType num_cols_per_row,
+                const IndexType pitch,
+                const IndexType * Aj,
+                const MatrixValueType * Ax,
+                const IndexType num_coo_nonzeros,
+                const IndexType num_coo_tiles,
+                const IndexType * I,
+                const IndexType * J,
+                const MatrixValueType * V,
+                const cached_x<ValueType> x,
+                      ValueType * y,
+                const coo_flat_tile_state<IndexType,ValueType> state)
+{
+    const IndexType invalid_index = cusp::ell_matrix<IndexType, MatrixValueType, cusp::device_memory>::invalid_index;
+
+    const IndexType ELL_TILE_ROWS = WARP_SIZE * ITEMS_PER_LANE;
+    const IndexType thread_lane   = threadIdx.x & (WARP_SIZE-1);
+
+    volatile int * next_tile     = state.status + num_coo_tiles;
+    volatile int * ell_completed = state.status + num_coo_tiles + 1;
+
+    while(true)
+    {
+        const IndexType tile = claim_tile<IndexType,BLOCK_SIZE>(next_tile);
+
+        if (tile < num_ell_tiles)
+        {
+            const IndexType tile_end = thrust::min(ELL_TILE_ROWS * (tile + 1), num_rows);
+
+            for(IndexType row = ELL_TILE_ROWS * tile + thread_lane; row < tile_end; row += WARP_SIZE)
+            {
+                ValueType sum = 0;
+
+                IndexType offset = row;
+
+                for(IndexType n = 0; n < num_cols_per_row; n++)
+                {
+                    const IndexType col = Aj[offset];
+
+                    if (col != invalid_index)
+                        sum += Ax[offset] * fetch_x<UseCache>(col, x);
+
+                    offset += pitch;
+                }
+
+                y[row] = sum;
+            }
+
+            // the rows of the tile must be visible before the COO tiles update them
+            __threadfence();
+
+            if (thread_lane == 0)
+                atomicAdd((unsigned int *) ell_completed, 1u);
+        }
+        else if (tile < num_ell_tiles + num_coo_tiles)
+        {
+            if (thread_lane == 0)
+            {
+                while (IndexType(*ell_completed) < num_ell_tiles);
+
+                __threadfence();
+            }
+
+#if CUDART_VERSION >= 9000
+            __syncwarp();
+#endif
+
+            spmv_coo_flat_tile<IndexType, ValueType, MatrixValueType, BLOCK_SIZE, ITEMS_PER_LANE, UseCache>
+                (tile - num_ell_tiles, num_coo_nonzeros, num_coo_tiles, I, J, V, x, y, state);
+        }
+        else
+        {
+            return;
+        }
+    }
+}
+
+template <bool UseCache,
+          typename Matrix,
+          typename ValueType>
+void __spmv_hyb(const Matrix&    A,
+                const ValueType* x,
+                      ValueType* y)
+{
+    typedef typename Matrix::index_type IndexType;
+    typedef typename Matrix::value_type MatrixValueType;
+
+    if (A.num_rows == 0)
+        return;
+
+    // without a COO part the ELL kernel is a single launch already
+    if (A.coo.num_entries == 0)
+    {
+        __spmv_ell<UseCache, plain_accumulation>(A.ell, x, y);
+        return;
+    }
+
+    const unsigned int BLOCK_SIZE      = 256;
+    const unsigned int ITEMS_PER_LANE  = 8;
+    const unsigned int WARPS_PER_BLOCK = BLOCK_SIZE / WARP_SIZE;
+    const unsigned int MAX_BLOCKS      = cusp::detail::device::arch::max_active_blocks(spmv_hyb_kernel<IndexType, ValueType, MatrixValueType, BLOCK_SIZE, ITEMS_PER_LANE, UseCache>, BLOCK_SIZE, (size_t) 0);
+
+    const IndexType num_ell_tiles = DIVIDE_INTO(A.num_rows,        WARP_SIZE * ITEMS_PER_LANE);
+    const IndexType num_coo_tiles = DIVIDE_INTO(A.coo.num_entries, WARP_SIZE * ITEMS_PER_LANE);
+
+    const unsigned int num_blocks = std::min<size_t>(MAX_BLOCKS, DIVIDE_INTO(num_ell_tiles + num_coo_tiles, WARPS_PER_BLOCK));
+
+    // TODO generalize this
+    assert(A.ell.column_indices.pitch == A.ell.values.pitch);
+
+    // the COO tile states followed by the tile counter and the number of
+    // completed ELL tiles, all starting at zero (COO_FLAT_TILE_EMPTY)
+    device_scratch<int>       status(num_coo_tiles + 2);
+    device_scratch<IndexType> summary_rows(2 * num_coo_tiles);
+    device_scratch<ValueType> summary_vals(2 * num_coo_tiles);
+
+    cudaMemsetAsync(status.get(), 0, (num_coo_tiles + 2) * sizeof(int), cusp::detail::device::current_stream());
+
+    coo_flat_tile_state<IndexType,ValueType> state;
+    state.status = status.get();
+    state.rows   = summary_rows.get();
+    state.vals   = summary_vals.get();
+
+    const cached_x<ValueType> x_cached = bind_x<UseCache>(x, A.num_cols);
+
+    spmv_hyb_kernel<IndexType, ValueType, MatrixValueType, BLOCK_SIZE, ITEMS_PER_LANE, UseCache> <<<num_blocks, BLOCK_SIZE, 0, cusp::detail::device::current_stream()>>>
+        (IndexType(A.num_rows), num_ell_tiles,
+         IndexType(A.ell.column_indices.num_cols), IndexType(A.ell.column_indices.pitch),
+         thrust::raw_pointer_cast(&A.ell.column_indices.values[0]),
+         thrust::raw_pointer_cast(&A.ell.values.values[0]),
+         IndexType(A.coo.num_entries), num_coo_tiles,
+         thrust::raw_pointer_cast(&A.coo.row_indices[0]),
+         thrust::raw_pointer_cast(&A.coo.column_indices[0]),
+         thrust::raw_pointer_cast(&A.coo.values[0]),
+         x_cached, y, state);
+
+    unbind_x(x_cached);
+}
+
 template <typename Matrix,
           typename ValueType>
 void spmv_hyb(const Matrix&    A, 
               const ValueType* x, 
                     ValueType* y)
 {
-    spmv_ell(A.ell, x, y);
-    __spmv_coo_flat<false, false>(A.coo, x, y);
+    __spmv_hyb<false>(A, x, y);
 }
 
 template <typename Matrix,
@@ -43,8 +205,7 @@ void spmv_hyb_tex(const Matrix&    A,
                   const ValueType* x, 
                         ValueType* y)
 {
-    spmv_ell_tex(A.ell, x, y);
-    __spmv_coo_flat<true, false>(A.coo, x, y);
+    __spmv_hyb<true>(A, x, y);
 }
 
 } // end namespace device
@@ -0,0 +1,141 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+#pragma once
+
+#include <cusp/sell_matrix.h>
+
+#include <cusp/detail/stream.h>
+#include <cusp/detail/device/arch.h>
+#include <cusp/detail/device/common.h>
+#include <cusp/detail/device/stream.h>
+#include <cusp/detail/device/utils.h>
+#include <cusp/detail/device/texture.h>
+
+#include <thrust/device_ptr.h>
+
+// SpMV kernel for the sliced ELLPACK (SELL-C-sigma) matrix format.
+//
+// One thread per stored row.  The rows of a slice are interleaved, so the
+// threads of a slice read consecutive entries like the ELL kernel, while each
+// slice only loops over its own width.  The result of stored row p is written
+// to y[row_permutation[p]], which restores the original row order.
+
+namespace cusp
+{
+namespace detail
+{
+namespace device
+{
+
+template <typename IndexType, typename ValueType, size_t BLOCK_SIZE, bool UseCache>
+__launch_bounds__(BLOCK_SIZE,1)
+__global__ void
+spmv_sell_kernel(const IndexType num_rows,
+                 const IndexType slice_height,
+                 const IndexType * slice_offsets,
+                 const IndexType * row_permutation,
+                 const IndexType * Aj,
+                 const ValueType * Ax,
+                 const cached_x<ValueType> x,
+                       ValueType * y)
+{
+    const IndexType invalid_index = cusp::sell_matrix<IndexType, ValueType, cusp::device_memory>::invalid_index;
+
+    const IndexType thread_id = blockDim.x * blockIdx.x + threadIdx.x;
+    const IndexType grid_size = gridDim.x * blockDim.x;
+
+    for(IndexType p = thread_id; p < num_rows; p += grid_size)
+    {
+        const IndexType slice = p / slice_height;
+        const IndexType end   = slice_offsets[slice + 1];
+
+        ValueType sum = 0;
+
+        for(IndexType offset = slice_offsets[slice] + (p - slice * slice_height); offset < end; offset += slice_height)
+        {
+            const IndexType col = Aj[offset];
+
+            // rows are shifted to the left, so the padding comes last
+            if (col == invalid_index)
+                break;
+
+            sum += Ax[offset] * fetch_x<UseCache>(col, x);
+        }
+
+        y[row_permutation[p]] = sum;
+    }
+}
+
+
+template <bool UseCache,
+          typename Matrix,
+          typename ValueType>
+void __spmv_sell(const Matrix&    A,
+                 const ValueType* x,
+                       ValueType* y)
+{
+    typedef typename Matrix::index_type IndexType;
+
+    if (A.num_rows == 0)
+        return;
+
+    if (A.column_indices.size() == 0)
+    {
+        thrust::device_ptr<ValueType> y_ptr(y);
+        cusp::detail::stream::fill(y_ptr, y_ptr + A.num_rows, ValueType(0));
+        return;
+    }
+
+    const size_t BLOCK_SIZE = 256;
+    const size_t MAX_BLOCKS = cusp::detail::device::arch::max_active_blocks(spmv_sell_kernel<IndexType,ValueType,BLOCK_SIZE,UseCache>, BLOCK_SIZE, (size_t) 0);
+    const size_t NUM_BLOCKS = std::min<size_t>(MAX_BLOCKS, DIVIDE_INTO(A.num_rows, BLOCK_SIZE));
+
+    const cached_x<ValueType> x_cached = bind_x<UseCache>(x, A.num_cols);
+
+    spmv_sell_kernel<IndexType,ValueType,BLOCK_SIZE,UseCache> <<<NUM_BLOCKS, BLOCK_SIZE, 0, cusp::detail::device::current_stream()>>>
+        (A.num_rows, A.slice_height,
+         thrust::raw_pointer_cast(&A.slice_offsets[0]),
+         thrust::raw_pointer_cast(&A.row_permutation[0]),
+         thrust::raw_pointer_cast(&A.column_indices[0]),
+         thrust::raw_pointer_cast(&A.values[0]),
+         x_cached, y);
+
+    unbind_x(x_cached);
+}
+
+template <typename Matrix,
+          typename ValueType>
+void spmv_sell(const Matrix&    A,
+               const ValueType* x,
+                     ValueType* y)
+{
+    __spmv_sell<false>(A, x, y);
+}
+
+template <typename Matrix,
+          typename ValueType>
+void spmv_sell_tex(const Matrix&    A,
+                   const ValueType* x,
+                         ValueType* y)
+{
+    __spmv_sell<true>(A, x, y);
+}
+
+} // end namespace device
+} // end namespace detail
+} // end namespace cusp
@@ -0,0 +1,186 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include <cusp/detail/stencil.h>
+#include <cusp/detail/stream.h>
+#include <cusp/detail/device/arch.h>
+#include <cusp/detail/device/common.h>
+#include <cusp/detail/device/stream.h>
+#include <cusp/detail/device/utils.h>
+
+#include <thrust/extrema.h>
+#include <thrust/iterator/counting_iterator.h>
+
+#include <algorithm>
+
+namespace cusp
+{
+namespace detail
+{
+namespace device
+{
+
+//////////////////////////////////////////////////////////////////////////////
+// Matrix-free stencil SpMV
+//////////////////////////////////////////////////////////////////////////////
+//
+// spmv_stencil
+//   Computes y = A * x where A is the matrix of a constant-coefficient
+//   stencil, without reading any index or value array.  The only memory
+//   traffic is one read of x and one write of y.
+//
+//   Stencils which reach at most one point away in every dimension (the
+//   3-, 5-, 7-, 9- and 27-point stencils) on grids of two or three
+//   dimensions use spmv_stencil_tiled_kernel.  Each block loads a tile of
+//   STENCIL_TILE_X x STENCIL_TILE_Y points of x plus a halo of one point
+//   into shared memory and marches through a range of z planes, keeping
+//   the planes z-1, z and z+1 in a ring of three tiles so that every plane
+//   is loaded once per block.  Points outside the grid are loaded as
+//   zeros, which drops their contribution like the boundary rows of the
+//   explicit matrix.  Other stencils apply stencil_row to every row.
+
+const unsigned int STENCIL_TILE_X = 32;
+const unsigned int STENCIL_TILE_Y = 8;
+
+template <typename IndexType, typename ValueType>
+__device__ void
+load_stencil_plane(const stencil_coefficients<IndexType,ValueType>& stencil,
+                   const ValueType * x,
+                   const IndexType k,
+                   ValueType tile[STENCIL_TILE_Y + 2][STENCIL_TILE_X + 2])
+{
+    const IndexType nx = stencil.grid[0];
+    const IndexType ny = stencil.grid[1];
+    const IndexType nz = stencil.grid[2];
+
+    const bool plane_inside = k >= 0 && k < nz;
+
+    for(unsigned int ty = threadIdx.y; ty < STENCIL_TILE_Y + 2; ty += STENCIL_TILE_Y)
+    {
+        for(unsigned int tx = threadIdx.x; tx < STENCIL_TILE_X + 2; tx += STENCIL_TILE_X)
+        {
+            const IndexType i = IndexType(blockIdx.x * STENCIL_TILE_X + tx) - 1;
+            const IndexType j = IndexType(blockIdx.y * STENCIL_TILE_Y + ty) - 1;
+
+            if (plane_inside && i >= 0 && i < nx && j >= 0 && j < ny)
+                tile[ty][tx] = x[(k * ny + j) * nx + i];
+            else
+                tile[ty][tx] = ValueType(0);
+        }
+    }
+}
+
+template <typename IndexType, typename ValueType>
+__launch_bounds__(STENCIL_TILE_X * STENCIL_TILE_Y,1)
+__global__ void
+spmv_stencil_tiled_kernel(const stencil_coefficients<IndexType,ValueType> stencil,
+                          const IndexType planes_per_block,
+                          const ValueType * x,
+                                ValueType * y)
+{
+    // ring of the planes k-1, k and k+1, plane k is in tiles[(k + 3) % 3]
+    __shared__ ValueType tiles[3][STENCIL_TILE_Y + 2][STENCIL_TILE_X + 2];
+
+    const IndexType nx = stencil.grid[0];
+    const IndexType ny = stencil.grid[1];
+    const IndexType nz = stencil.grid[2];
+
+    const IndexType i = blockIdx.x * STENCIL_TILE_X + threadIdx.x;
+    const IndexType j = blockIdx.y * STENCIL_TILE_Y + threadIdx.y;
+
+    const IndexType k_begin = blockIdx.z * planes_per_block;
+    const IndexType k_end   = thrust::min(nz, k_begin + planes_per_block);
+
+    if (k_begin >= k_end)
+        return;
+
+    load_stencil_plane(stencil, x, k_begin - 1, tiles[(k_begin + 2) % 3]);
+    load_stencil_plane(stencil, x, k_begin,     tiles[k_begin % 3]);
+
+    for(IndexType k = k_begin; k < k_end; k++)
+    {
+        // replaces plane k-2, which the previous iteration finished with
+        load_stencil_plane(stencil, x, k + 1, tiles[(k + 1) % 3]);
+
+        __syncthreads();
+
+        if (i < nx && j < ny)
+        {
+            ValueType sum = ValueType(0);
+
+            for(int n = 0; n < stencil.num_points; n++)
+                sum += stencil.values[n] * tiles[(k + 3 + stencil.offsets[n][2]) % 3]
+                                                [threadIdx.y + 1 + stencil.offsets[n][1]]
+                                                [threadIdx.x + 1 + stencil.offsets[n][0]];
+
+            y[(k * ny + j) * nx + i] = sum;
+        }
+
+        __syncthreads();
+    }
+}
+
+template <typename IndexType, typename ValueType>
+bool use_tiled_stencil(const stencil_coefficients<IndexType,ValueType>& stencil)
+{
+    return stencil.grid[1] > 1 &&
+           DIVIDE_INTO(stencil.grid[1], STENCIL_TILE_Y) <= 65535 &&
+           stencil.radius(0) <= 1 && stencil.radius(1) <= 1 && stencil.radius(2) <= 1;
+}
+
+template <typename IndexType, typename ValueType>
+void spmv_stencil(const stencil_coefficients<IndexType,ValueType>& stencil,
+                  const ValueType * x,
+                        ValueType * y)
+{
+    const IndexType num_rows = stencil.num_rows();
+
+    if (num_rows == 0)
+        return;
+
+    if (!use_tiled_stencil(stencil))
+    {
+        cusp::detail::stream::for_each(thrust::counting_iterator<IndexType,cusp::device_memory>(0),
+                                       thrust::counting_iterator<IndexType,cusp::device_memory>(num_rows),
+                                       stencil_row<IndexType,ValueType>(stencil, x, y));
+        return;
+    }
+
+    const size_t BLOCK_SIZE = STENCIL_TILE_X * STENCIL_TILE_Y;
+    const size_t MAX_BLOCKS = cusp::detail::device::arch::max_active_blocks(spmv_stencil_tiled_kernel<IndexType, ValueType>, BLOCK_SIZE, (size_t) 0);
+
+    const size_t tiles_x = DIVIDE_INTO(stencil.grid[0], STENCIL_TILE_X);
+    const size_t tiles_y = DIVIDE_INTO(stencil.grid[1], STENCIL_TILE_Y);
+    const size_t nz      = stencil.grid[2];
+
+    // split the z planes only as far as needed to fill the device, longer
+    // marches load fewer halo planes
+    const size_t z_blocks = std::min<size_t>(std::min<size_t>(nz, 65535),
+                                             std::max<size_t>(1, DIVIDE_INTO(MAX_BLOCKS, tiles_x * tiles_y)));
+    const IndexType planes_per_block = DIVIDE_INTO(nz, z_blocks);
+
+    const dim3 grid(tiles_x, tiles_y, DIVIDE_INTO(nz, planes_per_block));
+    const dim3 block(STENCIL_TILE_X, STENCIL_TILE_Y);
+
+    spmv_stencil_tiled_kernel<IndexType, ValueType> <<<grid, block, 0, cusp::detail::device::current_stream()>>>
+        (stencil, planes_per_block, x, y);
+}
+
+} // end namespace device
+} // end namespace detail
+} // end namespace cusp
@@ -0,0 +1,195 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include <cusp/array1d.h>
+
+#include <cusp/detail/functional.h>
+#include <cusp/detail/device/arch.h>
+#include <cusp/detail/device/common.h>
+#include <cusp/detail/device/multiply_dot.h>
+#include <cusp/detail/device/stream.h>
+#include <cusp/detail/device/utils.h>
+#include <cusp/detail/device/spmv/transpose.h>
+
+#include <thrust/device_ptr.h>
+
+#include <algorithm>
+
+// SpMV with the upper triangle U of a symmetric matrix, diagonal included,
+// y = (U + U^T - D) x, or of a Hermitian matrix, y = (U + U^H - D) x.
+//
+// The rows of U are assigned to vectors of THREADS_PER_VECTOR threads as in
+// spmv_csr_vector.  Each entry U(i,j) is read once and contributes to both
+// products: U(i,j) * x[j] to the partial sum of row i, and, off the
+// diagonal, U(i,j) * x[i] (conj(U(i,j)) * x[i] when Hermitian) to y[j]
+// with an atomic addition.  Every thread adds its partial sum to y[i]
+// atomically as well, so there is no reduction within the vector.  y is
+// cleared first; the order of the additions (and thus the rounding) may
+// differ between runs.
+//
+// Since no row of y is complete before the kernel ends, the dot product
+// conj(y)^T x of multiply_dot is summed over the contributions instead:
+// each contribution c to y[k] adds conj(c) * x[k], and the blocks reduce
+// their sums as in the kernels of multiply_dot.h.
+
+namespace cusp
+{
+namespace detail
+{
+namespace device
+{
+
+template <typename IndexType, typename ValueType, typename MatrixValueType, unsigned int VECTORS_PER_BLOCK, unsigned int THREADS_PER_VECTOR, bool Hermitian, bool Dot>
+__launch_bounds__(VECTORS_PER_BLOCK * THREADS_PER_VECTOR,1)
+__global__ void
+spmv_csr_symmetric_kernel(const IndexType num_rows,
+                          const IndexType * Ap,
+                          const IndexType * Aj,
+                          const MatrixValueType * Ax,
+                          const ValueType * x,
+                                ValueType * y,
+                                ValueType * partial)
+{
+    const IndexType THREADS_PER_BLOCK = VECTORS_PER_BLOCK * THREADS_PER_VECTOR;
+
+    __shared__ ValueType sdata[Dot ? THREADS_PER_BLOCK : 1];
+
+    const cusp::detail::conjugate_if<Hermitian> mirror;
+    const cusp::detail::conjugate_if<true> conj;
+
+    const IndexType thread_id   = THREADS_PER_BLOCK * blockIdx.x + threadIdx.x;
+    const IndexType thread_lane = threadIdx.x & (THREADS_PER_VECTOR - 1);
+    const IndexType vector_id   = thread_id   /  THREADS_PER_VECTOR;
+    const IndexType num_vectors = VECTORS_PER_BLOCK * gridDim.x;
+
+    ValueType dot = ValueType(0);
+
+    for(IndexType row = vector_id; row < num_rows; row += num_vectors)
+    {
+        const IndexType row_start = Ap[row];
+        const IndexType row_end   = Ap[row + 1];
+
+        const ValueType x_i = x[row];
+
+        ValueType sum = ValueType(0);
+
+        for(IndexType jj = row_start + thread_lane; jj < row_end; jj += THREADS_PER_VECTOR)
+        {
+            const IndexType col  = Aj[jj];
+            const ValueType A_ij = Ax[jj];
+            const ValueType x_j  = x[col];
+
+            const ValueType t = A_ij * x_j;
+
+            sum += t;
+
+            if (Dot)
+                dot += conj(t) * x_i;
+
+            if (col != row && x_i != ValueType(0))
+            {
+                const ValueType m = mirror(A_ij) * x_i;
+
+                spmv_transpose_atomic_add(y + col, m);
+
+                if (Dot)
+                    dot += conj(m) * x_j;
+            }
+        }
+
+        if (sum != ValueType(0))
+            spmv_transpose_atomic_add(y + row, sum);
+    }
+
+    if (Dot)
+    {
+        dot = block_sum<THREADS_PER_BLOCK>(sdata, dot);
+
+        if (threadIdx.x == 0)
+            partial[blockIdx.x] = dot;
+    }
+}
+
+template <unsigned int THREADS_PER_VECTOR, bool Hermitian, bool Dot, typename Matrix, typename ValueType>
+ValueType __spmv_csr_symmetric(const Matrix&    A,
+                               const ValueType* x,
+                                     ValueType* y)
+{
+    typedef typename Matrix::index_type IndexType;
+    typedef typename Matrix::value_type MatrixValueType;
+
+    const unsigned int THREADS_PER_BLOCK = 256;
+    const unsigned int VECTORS_PER_BLOCK = THREADS_PER_BLOCK / THREADS_PER_VECTOR;
+
+    const size_t MAX_BLOCKS = cusp::detail::device::arch::max_active_blocks(spmv_csr_symmetric_kernel<IndexType, ValueType, MatrixValueType, VECTORS_PER_BLOCK, THREADS_PER_VECTOR, Hermitian, Dot>, THREADS_PER_BLOCK, (size_t) 0);
+    const size_t NUM_BLOCKS = std::min<size_t>(MAX_BLOCKS, DIVIDE_INTO(A.num_rows, VECTORS_PER_BLOCK));
+
+    cusp::array1d<ValueType,cusp::device_memory> partial(Dot ? NUM_BLOCKS + 1 : 0);
+
+    spmv_csr_symmetric_kernel<IndexType, ValueType, MatrixValueType, VECTORS_PER_BLOCK, THREADS_PER_VECTOR, Hermitian, Dot> <<<NUM_BLOCKS, THREADS_PER_BLOCK, 0, cusp::detail::device::current_stream()>>>
+        (A.num_rows,
+         thrust::raw_pointer_cast(&A.row_offsets[0]),
+         thrust::raw_pointer_cast(&A.column_indices[0]),
+         thrust::raw_pointer_cast(&A.values[0]),
+         x, y,
+         Dot ? thrust::raw_pointer_cast(&partial[0]) : (ValueType *) NULL);
+
+    return Dot ? sum_partials(partial, NUM_BLOCKS) : ValueType(0);
+}
+
+template <bool Hermitian, bool Dot, typename Matrix, typename ValueType>
+ValueType __spmv_csr_symmetric(const Matrix&    A,
+                               const ValueType* x,
+                                     ValueType* y)
+{
+    spmv_transpose_clear(A.num_rows, y);
+
+    if (A.num_rows == 0 || A.num_entries == 0)
+        return ValueType(0);
+
+    const size_t nnz_per_row = A.num_entries / A.num_rows;
+
+    if      (nnz_per_row <=  2) return __spmv_csr_symmetric< 2, Hermitian, Dot>(A, x, y);
+    else if (nnz_per_row <=  4) return __spmv_csr_symmetric< 4, Hermitian, Dot>(A, x, y);
+    else if (nnz_per_row <=  8) return __spmv_csr_symmetric< 8, Hermitian, Dot>(A, x, y);
+    else if (nnz_per_row <= 16) return __spmv_csr_symmetric<16, Hermitian, Dot>(A, x, y);
+    else                        return __spmv_csr_symmetric<32, Hermitian, Dot>(A, x, y);
+}
+
+// y <- (U + U^T - D) x for the upper triangle U of a symmetric matrix, or
+// (U + U^H - D) x of a Hermitian matrix
+template <bool Hermitian, typename Matrix, typename ValueType>
+void spmv_csr_symmetric(const Matrix&    A,
+                        const ValueType* x,
+                              ValueType* y)
+{
+    __spmv_csr_symmetric<Hermitian, false>(A, x, y);
+}
+
+// the same product, returning conj(y)^T x
+template <bool Hermitian, typename Matrix, typename ValueType>
+ValueType spmv_dot_csr_symmetric(const Matrix&    A,
+                                 const ValueType* x,
+                                       ValueType* y)
+{
+    return __spmv_csr_symmetric<Hermitian, true>(A, x, y);
+}
+
+} // end namespace device
+} // end namespace detail
+} // end namespace cusp
@@ -0,0 +1,165 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include <cusp/detail/device/arch.h>
+#include <cusp/detail/device/common.h>
+#include <cusp/detail/device/stream.h>
+#include <cusp/detail/device/utils.h>
+#include <cusp/detail/device/spmv/transpose.h>
+
+#include <thrust/device_ptr.h>
+
+#include <algorithm>
+
+// SpMV with the tiles of a tiled_csr_operator (cusp/tiled_csr_operator.h).
+//
+// The entries, in CSR order, are cut into tiles of TILED_CSR_WIDTH lanes
+// of TILED_CSR_DEPTH consecutive entries.  Within a tile the entries are
+// stored transposed, step s of every lane next to each other, so the
+// threads of a warp, one per lane, read the entries of a step with one
+// coalesced access whatever the lengths of the rows.  Bit s of the flags
+// of a lane is set when its entry s starts a row (bit DEPTH when the
+// entry after the lane does), and the lane starts in row lane_rows[lane]
+// of the nonempty rows.  A lane stores the sums of the rows it holds
+// entirely and adds its partial sums of rows shared with other lanes
+// atomically, after y has been cleared.  On the host the lanes are
+// processed in order with plain additions.
+
+namespace cusp
+{
+namespace detail
+{
+namespace device
+{
+
+const unsigned int TILED_CSR_WIDTH = 32;
+const unsigned int TILED_CSR_DEPTH = 16;
+
+template <typename IndexType, typename ValueType>
+__host__ __device__
+void tiled_csr_store(const IndexType row, const ValueType sum, const bool complete,
+                     const IndexType num_compact_rows, const IndexType * row_map, ValueType * y)
+{
+    // the padding of the last tile runs past the nonempty rows
+    if (row >= num_compact_rows)
+        return;
+
+    ValueType * y_i = y + (row_map == NULL ? row : row_map[row]);
+
+    if (complete)
+        *y_i = sum;
+    else if (sum != ValueType(0))
+#ifdef __CUDA_ARCH__
+        spmv_transpose_atomic_add(y_i, sum);
+#else
+        *y_i += sum;
+#endif
+}
+
+template <typename IndexType, typename ValueType, typename MatrixValueType>
+__host__ __device__
+void tiled_csr_lane(const IndexType lane,
+                    const IndexType num_compact_rows,
+                    const IndexType * lane_rows,
+                    const unsigned int * lane_flags,
+                    const IndexType * row_map,
+                    const IndexType * Aj,
+                    const MatrixValueType * Ax,
+                    const ValueType * x,
+                          ValueType * y)
+{
+    const IndexType W = TILED_CSR_WIDTH;
+    const IndexType S = TILED_CSR_DEPTH;
+
+    const IndexType base = (lane / W) * W * S + lane % W;
+    const unsigned int flags = lane_flags[lane];
+
+    IndexType row = lane_rows[lane];
+    bool started = (flags & 1) != 0;
+    ValueType sum = ValueType(0);
+
+    for (IndexType s = 0; s < S; s++)
+    {
+        if (s > 0 && ((flags >> s) & 1))
+        {
+            tiled_csr_store(row, sum, started, num_compact_rows, row_map, y);
+
+            row++;
+            sum = ValueType(0);
+            started = true;
+        }
+
+        const IndexType n = base + s * W;
+        sum += ValueType(Ax[n]) * x[Aj[n]];
+    }
+
+    tiled_csr_store(row, sum, started && ((flags >> S) & 1), num_compact_rows, row_map, y);
+}
+
+template <typename IndexType, typename ValueType, typename MatrixValueType, unsigned int BLOCK_SIZE>
+__launch_bounds__(BLOCK_SIZE,1)
+__global__ void
+spmv_tiled_csr_kernel(const IndexType num_lanes,
+                      const IndexType num_compact_rows,
+                      const IndexType * lane_rows,
+                      const unsigned int * lane_flags,
+                      const IndexType * row_map,
+                      const IndexType * Aj,
+                      const MatrixValueType * Ax,
+                      const ValueType * x,
+                            ValueType * y)
+{
+    const IndexType thread_id = BLOCK_SIZE * blockIdx.x + threadIdx.x;
+    const IndexType grid_size = BLOCK_SIZE * gridDim.x;
+
+    for (IndexType lane = thread_id; lane < num_lanes; lane += grid_size)
+        tiled_csr_lane(lane, num_compact_rows, lane_rows, lane_flags, row_map, Aj, Ax, x, y);
+}
+
+template <typename Matrix, typename ValueType>
+void spmv_tiled_csr(const Matrix&    A,
+                    const ValueType* x,
+                          ValueType* y)
+{
+    typedef typename Matrix::index_type IndexType;
+    typedef typename Matrix::value_type MatrixValueType;
+
+    spmv_transpose_clear(A.num_rows, y);
+
+    const IndexType num_lanes = A.lane_rows.size();
+
+    if (num_lanes == 0)
+        return;
+
+    const unsigned int BLOCK_SIZE = 256;
+    const size_t MAX_BLOCKS = cusp::detail::device::arch::max_active_blocks(spmv_tiled_csr_kernel<IndexType, ValueType, MatrixValueType, BLOCK_SIZE>, BLOCK_SIZE, (size_t) 0);
+    const size_t NUM_BLOCKS = std::min<size_t>(MAX_BLOCKS, DIVIDE_INTO(num_lanes, BLOCK_SIZE));
+
+    spmv_tiled_csr_kernel<IndexType, ValueType, MatrixValueType, BLOCK_SIZE> <<<NUM_BLOCKS, BLOCK_SIZE, 0, cusp::detail::device::current_stream()>>>
+        (num_lanes, IndexType(A.num_compact_rows),
+         thrust::raw_pointer_cast(&A.lane_rows[0]),
+         thrust::raw_pointer_cast(&A.lane_flags[0]),
+         A.row_map.empty() ? NULL : thrust::raw_pointer_cast(&A.row_map[0]),
+         thrust::raw_pointer_cast(&A.column_indices[0]),
+         thrust::raw_pointer_cast(&A.values[0]),
+         x, y);
+}
+
+} // end namespace device
+} // end namespace detail
+} // end namespace cusp
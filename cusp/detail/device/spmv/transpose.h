@@ -0,0 +1,378 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+#pragma once
+
+#include <cusp/complex.h>
+#include <cusp/ell_matrix.h>
+
+#include <cusp/detail/device/arch.h>
+#include <cusp/detail/device/common.h>
+#include <cusp/detail/device/stream.h>
+#include <cusp/detail/device/utils.h>
+
+#include <thrust/device_ptr.h>
+#include <thrust/extrema.h>
+
+#include <cuda_runtime_api.h>
+
+#include <algorithm>
+
+// Transposed SpMV kernels, y = A^T x, for the COO, CSR, DIA, ELL and HYB
+// formats.
+//
+// The entries of A are traversed in their storage order as for y = A x, but
+// A(i,j) * x[i] is scattered into y[j] with an atomic addition instead of
+// being reduced into y[i].  y is cleared first, so the result does not
+// depend on the contents of y, but the order of the additions (and thus the
+// rounding) may differ between runs.  No transposed copy of A is formed.
+//
+// The diagonals of a DIA matrix are diagonals of A^T as well, so the DIA
+// kernel gathers column j of A with one thread per column instead, which
+// needs no atomics and is deterministic.
+
+namespace cusp
+{
+namespace detail
+{
+namespace device
+{
+
+__device__ inline float spmv_transpose_atomic_add(float * address, const float value)
+{
+    return atomicAdd(address, value);
+}
+
+__device__ inline double spmv_transpose_atomic_add(double * address, const double value)
+{
+#if __CUDA_ARCH__ >= 600
+    return atomicAdd(address, value);
+#else
+    unsigned long long int * address_as_ull = (unsigned long long int *) address;
+    unsigned long long int old = *address_as_ull, assumed;
+
+    do
+    {
+        assumed = old;
+        old = atomicCAS(address_as_ull, assumed, __double_as_longlong(value + __longlong_as_double(assumed)));
+    } while (assumed != old);
+
+    return __longlong_as_double(old);
+#endif
+}
+
+// the real and imaginary parts are added separately
+template <typename T>
+__device__ inline cusp::complex<T> spmv_transpose_atomic_add(cusp::complex<T> * address, const cusp::complex<T> value)
+{
+    T * parts = reinterpret_cast<T *>(address);
+
+    const T re = spmv_transpose_atomic_add(parts,     value.real());
+    const T im = spmv_transpose_atomic_add(parts + 1, value.imag());
+
+    return cusp::complex<T>(re, im);
+}
+
+template <typename IndexType, typename ValueType, typename MatrixValueType, unsigned int BLOCK_SIZE>
+__launch_bounds__(BLOCK_SIZE,1)
+__global__ void
+spmv_coo_transpose_kernel(const IndexType num_entries,
+                          const IndexType * Ai,
+                          const IndexType * Aj,
+                          const MatrixValueType * Ax,
+                          const ValueType * x,
+                                ValueType * y)
+{
+    const IndexType thread_id = BLOCK_SIZE * blockIdx.x + threadIdx.x;
+    const IndexType grid_size = BLOCK_SIZE * gridDim.x;
+
+    for(IndexType n = thread_id; n < num_entries; n += grid_size)
+    {
+        const ValueType A_ij = Ax[n];
+        spmv_transpose_atomic_add(y + Aj[n], A_ij * x[Ai[n]]);
+    }
+}
+
+template <typename IndexType, typename ValueType, typename MatrixValueType, unsigned int BLOCK_SIZE>
+__launch_bounds__(BLOCK_SIZE,1)
+__global__ void
+spmv_csr_transpose_kernel(const IndexType num_rows,
+                          const IndexType * Ap,
+                          const IndexType * Aj,
+                          const MatrixValueType * Ax,
+                          const ValueType * x,
+                                ValueType * y)
+{
+    const IndexType thread_id = BLOCK_SIZE * blockIdx.x + threadIdx.x;
+    const IndexType grid_size = BLOCK_SIZE * gridDim.x;
+
+    for(IndexType row = thread_id; row < num_rows; row += grid_size)
+    {
+        const ValueType x_i = x[row];
+
+        if (x_i == ValueType(0))
+            continue;
+
+        const IndexType row_end = Ap[row + 1];
+
+        for(IndexType jj = Ap[row]; jj < row_end; jj++)
+        {
+            const ValueType A_ij = Ax[jj];
+            spmv_transpose_atomic_add(y + Aj[jj], A_ij * x_i);
+        }
+    }
+}
+
+template <typename IndexType, typename ValueType, typename MatrixValueType, unsigned int BLOCK_SIZE>
+__launch_bounds__(BLOCK_SIZE,1)
+__global__ void
+spmv_ell_transpose_kernel(const IndexType num_rows,
+                          const IndexType num_cols_per_row,
+                          const IndexType pitch,
+                          const IndexType * Aj,
+                          const MatrixValueType * Ax,
+                          const ValueType * x,
+                                ValueType * y)
+{
+    const IndexType invalid_index = cusp::ell_matrix<IndexType, MatrixValueType, cusp::device_memory>::invalid_index;
+
+    const IndexType thread_id = BLOCK_SIZE * blockIdx.x + threadIdx.x;
+    const IndexType grid_size = BLOCK_SIZE * gridDim.x;
+
+    for(IndexType row = thread_id; row < num_rows; row += grid_size)
+    {
+        const ValueType x_i = x[row];
+
+        if (x_i == ValueType(0))
+            continue;
+
+        IndexType offset = row;
+
+        for(IndexType n = 0; n < num_cols_per_row; n++)
+        {
+            const IndexType col = Aj[offset];
+
+            if (col != invalid_index)
+            {
+                const ValueType A_ij = Ax[offset];
+                spmv_transpose_atomic_add(y + col, A_ij * x_i);
+            }
+
+            offset += pitch;
+        }
+    }
+}
+
+template <typename IndexType, typename ValueType, typename MatrixValueType, unsigned int BLOCK_SIZE>
+__launch_bounds__(BLOCK_SIZE,1)
+__global__ void
+spmv_dia_transpose_kernel(const IndexType num_rows,
+                          const IndexType num_cols,
+                          const IndexType num_diagonals,
+                          const IndexType pitch,
+                          const IndexType * diagonal_offsets,
+                          const MatrixValueType * values,
+                          const ValueType * x,
+                                ValueType * y)
+{
+    __shared__ IndexType offsets[BLOCK_SIZE];
+
+    const IndexType thread_id = BLOCK_SIZE * blockIdx.x + threadIdx.x;
+    const IndexType grid_size = BLOCK_SIZE * gridDim.x;
+
+    for(IndexType base = 0; base < num_diagonals; base += BLOCK_SIZE)
+    {
+        // read a chunk of the diagonal offsets into shared memory
+        const IndexType chunk_size = thrust::min(IndexType(BLOCK_SIZE), num_diagonals - base);
+
+        if(threadIdx.x < chunk_size)
+            offsets[threadIdx.x] = diagonal_offsets[base + threadIdx.x];
+
+        __syncthreads();
+
+        // process chunk, A(row, col) is stored at values[row + pitch * n]
+        for(IndexType col = thread_id; col < num_cols; col += grid_size)
+        {
+            ValueType sum = (base == 0) ? ValueType(0) : y[col];
+
+            for(IndexType n = 0; n < chunk_size; n++)
+            {
+                const IndexType row = col - offsets[n];
+
+                if(row >= 0 && row < num_rows)
+                {
+                    const ValueType A_ij = values[row + pitch * (base + n)];
+                    sum += A_ij * x[row];
+                }
+            }
+
+            y[col] = sum;
+        }
+
+        // wait until all threads are done reading offsets
+        __syncthreads();
+    }
+}
+
+// y <- 0 on the current stream
+template <typename ValueType>
+void spmv_transpose_clear(const size_t N, ValueType * y)
+{
+    if (N > 0)
+        cudaMemsetAsync(y, 0, N * sizeof(ValueType), cusp::detail::device::current_stream());
+}
+
+// y <- y + A^T x for the entries of a COO matrix
+template <typename Matrix, typename ValueType>
+void __spmv_coo_transpose(const Matrix&    A,
+                          const ValueType* x,
+                                ValueType* y)
+{
+    typedef typename Matrix::index_type IndexType;
+    typedef typename Matrix::value_type MatrixValueType;
+
+    if (A.num_entries == 0)
+        return;
+
+    const unsigned int BLOCK_SIZE = 256;
+    const size_t MAX_BLOCKS = cusp::detail::device::arch::max_active_blocks(spmv_coo_transpose_kernel<IndexType,ValueType,MatrixValueType,BLOCK_SIZE>, BLOCK_SIZE, (size_t) 0);
+    const size_t NUM_BLOCKS = std::min<size_t>(MAX_BLOCKS, DIVIDE_INTO(A.num_entries, BLOCK_SIZE));
+
+    spmv_coo_transpose_kernel<IndexType,ValueType,MatrixValueType,BLOCK_SIZE> <<<NUM_BLOCKS, BLOCK_SIZE, 0, cusp::detail::device::current_stream()>>>
+        (A.num_entries,
+         thrust::raw_pointer_cast(&A.row_indices[0]),
+         thrust::raw_pointer_cast(&A.column_indices[0]),
+         thrust::raw_pointer_cast(&A.values[0]),
+         x, y);
+}
+
+// y <- y + A^T x for the entries of an ELL matrix
+template <typename Matrix, typename ValueType>
+void __spmv_ell_transpose(const Matrix&    A,
+                          const ValueType* x,
+                                ValueType* y)
+{
+    typedef typename Matrix::index_type IndexType;
+    typedef typename Matrix::value_type MatrixValueType;
+
+    if (A.num_rows == 0 || A.column_indices.num_cols == 0)
+        return;
+
+    const unsigned int BLOCK_SIZE = 256;
+    const size_t MAX_BLOCKS = cusp::detail::device::arch::max_active_blocks(spmv_ell_transpose_kernel<IndexType,ValueType,MatrixValueType,BLOCK_SIZE>, BLOCK_SIZE, (size_t) 0);
+    const size_t NUM_BLOCKS = std::min<size_t>(MAX_BLOCKS, DIVIDE_INTO(A.num_rows, BLOCK_SIZE));
+
+    // TODO generalize this
+    assert(A.column_indices.pitch == A.values.pitch);
+
+    spmv_ell_transpose_kernel<IndexType,ValueType,MatrixValueType,BLOCK_SIZE> <<<NUM_BLOCKS, BLOCK_SIZE, 0, cusp::detail::device::current_stream()>>>
+        (A.num_rows,
+         A.column_indices.num_cols,
+         A.column_indices.pitch,
+         thrust::raw_pointer_cast(&A.column_indices.values[0]),
+         thrust::raw_pointer_cast(&A.values.values[0]),
+         x, y);
+}
+
+template <typename Matrix, typename ValueType>
+void spmv_csr_transpose(const Matrix&    A,
+                        const ValueType* x,
+                              ValueType* y)
+{
+    typedef typename Matrix::index_type IndexType;
+    typedef typename Matrix::value_type MatrixValueType;
+
+    spmv_transpose_clear(A.num_cols, y);
+
+    if (A.num_rows == 0)
+        return;
+
+    const unsigned int BLOCK_SIZE = 256;
+    const size_t MAX_BLOCKS = cusp::detail::device::arch::max_active_blocks(spmv_csr_transpose_kernel<IndexType,ValueType,MatrixValueType,BLOCK_SIZE>, BLOCK_SIZE, (size_t) 0);
+    const size_t NUM_BLOCKS = std::min<size_t>(MAX_BLOCKS, DIVIDE_INTO(A.num_rows, BLOCK_SIZE));
+
+    spmv_csr_transpose_kernel<IndexType,ValueType,MatrixValueType,BLOCK_SIZE> <<<NUM_BLOCKS, BLOCK_SIZE, 0, cusp::detail::device::current_stream()>>>
+        (A.num_rows,
+         thrust::raw_pointer_cast(&A.row_offsets[0]),
+         thrust::raw_pointer_cast(&A.column_indices[0]),
+         thrust::raw_pointer_cast(&A.values[0]),
+         x, y);
+}
+
+template <typename Matrix, typename ValueType>
+void spmv_coo_transpose(const Matrix&    A,
+                        const ValueType* x,
+                              ValueType* y)
+{
+    spmv_transpose_clear(A.num_cols, y);
+    __spmv_coo_transpose(A, x, y);
+}
+
+template <typename Matrix, typename ValueType>
+void spmv_dia_transpose(const Matrix&    A,
+                        const ValueType* x,
+                              ValueType* y)
+{
+    typedef typename Matrix::index_type IndexType;
+    typedef typename Matrix::value_type MatrixValueType;
+
+    const IndexType num_diagonals = A.values.num_cols;
+    const IndexType pitch         = A.values.pitch;
+
+    if (num_diagonals == 0)
+    {
+        // empty matrix
+        spmv_transpose_clear(A.num_cols, y);
+        return;
+    }
+
+    if (A.num_cols == 0)
+        return;
+
+    const unsigned int BLOCK_SIZE = 256;
+    const size_t MAX_BLOCKS = cusp::detail::device::arch::max_active_blocks(spmv_dia_transpose_kernel<IndexType,ValueType,MatrixValueType,BLOCK_SIZE>, BLOCK_SIZE, (size_t) sizeof(IndexType) * BLOCK_SIZE);
+    const size_t NUM_BLOCKS = std::min<size_t>(MAX_BLOCKS, DIVIDE_INTO(A.num_cols, BLOCK_SIZE));
+
+    spmv_dia_transpose_kernel<IndexType,ValueType,MatrixValueType,BLOCK_SIZE> <<<NUM_BLOCKS, BLOCK_SIZE, 0, cusp::detail::device::current_stream()>>>
+        (A.num_rows, A.num_cols, num_diagonals, pitch,
+         thrust::raw_pointer_cast(&A.diagonal_offsets[0]),
+         thrust::raw_pointer_cast(&A.values.values[0]),
+         x, y);
+}
+
+template <typename Matrix, typename ValueType>
+void spmv_ell_transpose(const Matrix&    A,
+                        const ValueType* x,
+                              ValueType* y)
+{
+    spmv_transpose_clear(A.num_cols, y);
+    __spmv_ell_transpose(A, x, y);
+}
+
+template <typename Matrix, typename ValueType>
+void spmv_hyb_transpose(const Matrix&    A,
+                        const ValueType* x,
+                              ValueType* y)
+{
+    spmv_transpose_clear(A.num_cols, y);
+    __spmv_ell_transpose(A.ell, x, y);
+    __spmv_coo_transpose(A.coo, x, y);
+}
+
+} // end namespace device
+} // end namespace detail
+} // end namespace cusp
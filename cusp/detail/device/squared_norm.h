@@ -0,0 +1,118 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+#pragma once
+
+#include <cusp/detail/device/arch.h>
+#include <cusp/detail/device/common.h>
+#include <cusp/detail/device/utils.h>
+#include <cusp/detail/device/stream.h>
+
+#include <cusp/blas.h>
+
+#include <algorithm>
+
+namespace cusp
+{
+namespace detail
+{
+namespace device
+{
+
+// sum of the BLOCK_SIZE values of s_sum, valid in thread 0
+template <typename ValueType, unsigned int BLOCK_SIZE>
+__device__ ValueType squared_norm_block_sum(ValueType * s_sum, const ValueType value)
+{
+    s_sum[threadIdx.x] = value;
+
+    __syncthreads();
+
+    for(unsigned int offset = BLOCK_SIZE / 2; offset > 0; offset /= 2)
+    {
+        if (threadIdx.x < offset)
+            s_sum[threadIdx.x] = s_sum[threadIdx.x] + s_sum[threadIdx.x + offset];
+
+        __syncthreads();
+    }
+
+    return s_sum[0];
+}
+
+// partial sums of x[i] * conj(x[i]), one per block
+template <typename ValueType, unsigned int BLOCK_SIZE>
+__launch_bounds__(BLOCK_SIZE,1)
+__global__ void
+squared_norm_partials_kernel(const ValueType * x, const size_t N, ValueType * partials)
+{
+    __shared__ ValueType s_sum[BLOCK_SIZE];
+
+    cusp::blas::detail::norm_squared<ValueType> op;
+
+    ValueType sum = 0;
+
+    for(size_t i = blockIdx.x * BLOCK_SIZE + threadIdx.x; i < N; i += gridDim.x * BLOCK_SIZE)
+        sum += op(x[i]);
+
+    sum = squared_norm_block_sum<ValueType,BLOCK_SIZE>(s_sum, sum);
+
+    if (threadIdx.x == 0)
+        partials[blockIdx.x] = sum;
+}
+
+template <typename ValueType, unsigned int BLOCK_SIZE>
+__launch_bounds__(BLOCK_SIZE,1)
+__global__ void
+squared_norm_finish_kernel(const ValueType * partials, const size_t num_partials, ValueType * result)
+{
+    __shared__ ValueType s_sum[BLOCK_SIZE];
+
+    ValueType sum = 0;
+
+    for(size_t i = threadIdx.x; i < num_partials; i += BLOCK_SIZE)
+        sum += partials[i];
+
+    sum = squared_norm_block_sum<ValueType,BLOCK_SIZE>(s_sum, sum);
+
+    if (threadIdx.x == 0)
+        *result = sum;
+}
+
+// number of partial sums written by squared_norm
+inline size_t squared_norm_num_partials(void)
+{
+    return 256;
+}
+
+// *result <- <x,x> with two kernels on the current stream and no
+// synchronization with the host
+template <typename ValueType>
+void squared_norm(const ValueType * x, const size_t N, ValueType * partials, ValueType * result)
+{
+    const unsigned int BLOCK_SIZE = 256;
+
+    const size_t num_blocks = std::max<size_t>(1, std::min<size_t>(squared_norm_num_partials(), DIVIDE_INTO(N, BLOCK_SIZE)));
+
+    cudaStream_t stream = cusp::detail::device::current_stream();
+
+    squared_norm_partials_kernel<ValueType, BLOCK_SIZE> <<<num_blocks, BLOCK_SIZE, 0, stream>>>(x, N, partials);
+    squared_norm_finish_kernel<ValueType, BLOCK_SIZE> <<<1, BLOCK_SIZE, 0, stream>>>(partials, num_blocks, result);
+}
+
+} // end namespace device
+} // end namespace detail
+} // end namespace cusp
+
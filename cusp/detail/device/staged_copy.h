@@ -0,0 +1,284 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include <cusp/exception.h>
+
+#include <cusp/detail/mutex.h>
+#include <cusp/detail/device/stream.h>
+
+#include <cuda_runtime_api.h>
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+
+namespace cusp
+{
+namespace detail
+{
+namespace device
+{
+
+// Transfers between pageable host memory and the device are staged through a
+// ring of page-locked buffers, so the host fills one buffer while the DMA
+// engine drains another.  The transfers are issued on a dedicated stream which
+// first waits for the work on the current stream.  Uploads return as soon as
+// the last chunk is staged, and the current stream waits for them, so
+// consecutive uploads (e.g. the arrays of one matrix) and the kernels which
+// consume them are queued without blocking the host.  The pool is shared by
+// all host threads: a transfer which finds it in use by another thread takes
+// the regular path rather than waiting for the buffers.
+class pinned_staging_pool
+{
+  public:
+  static const size_t num_buffers = 4;
+  static const size_t buffer_size = 8 << 20;
+
+  // smaller transfers are not worth the staging
+  static const size_t min_staged_size = 1 << 20;
+
+  static pinned_staging_pool& get(void)
+  {
+    static pinned_staging_pool pool;
+    return pool;
+  }
+
+  // held by the thread whose transfer uses the buffers
+  static cusp::detail::mutex& lock(void)
+  {
+    static cusp::detail::mutex m = __CUSP_MUTEX_INITIALIZER;
+    return m;
+  }
+
+  void copy_to_device(void * dst, const void * src, size_t bytes)
+  {
+    char       * d = static_cast<char *>(dst);
+    const char * s = static_cast<const char *>(src);
+
+    wait_for_current_stream();
+
+    for (size_t offset = 0; offset < bytes; offset += buffer_size)
+    {
+      size_t length = std::min(size_t(buffer_size), bytes - offset);
+      size_t b = next;
+      next = (next + 1) % num_buffers;
+
+      // the previous transfer from this buffer must be complete
+      check(cudaEventSynchronize(events[b]));
+
+      std::memcpy(buffers[b], s + offset, length);
+
+      check(cudaMemcpyAsync(d + offset, buffers[b], length, cudaMemcpyHostToDevice, stream));
+      check(cudaEventRecord(events[b], stream));
+    }
+
+    // order later work on the current stream after the upload
+    check(cudaEventRecord(done, stream));
+    check(cudaStreamWaitEvent(current_stream(), done, 0));
+  }
+
+  void copy_to_host(void * dst, const void * src, size_t bytes)
+  {
+    char       * d = static_cast<char *>(dst);
+    const char * s = static_cast<const char *>(src);
+
+    wait_for_current_stream();
+
+    const size_t num_chunks = (bytes + buffer_size - 1) / buffer_size;
+
+    // keep every buffer in flight and drain them in order
+    for (size_t c = 0; c < num_chunks + num_buffers; c++)
+    {
+      if (c >= num_buffers && c - num_buffers < num_chunks)
+        drain(d, c - num_buffers, bytes);
+
+      if (c < num_chunks)
+      {
+        size_t offset = c * buffer_size;
+        size_t length = std::min(size_t(buffer_size), bytes - offset);
+        size_t b = c % num_buffers;
+
+        check(cudaMemcpyAsync(buffers[b], s + offset, length, cudaMemcpyDeviceToHost, stream));
+        check(cudaEventRecord(events[b], stream));
+      }
+    }
+
+    next = 0;
+  }
+
+  // false if page-locked memory is unavailable
+  bool available(void)
+  {
+    if (!initialized)
+      initialize();
+
+    return valid;
+  }
+
+  ~pinned_staging_pool(void)
+  {
+    if (!valid)
+      return;
+
+    // errors are ignored while the runtime shuts down
+    cudaStreamSynchronize(stream);
+
+    for (size_t b = 0; b < num_buffers; b++)
+    {
+      cudaFreeHost(buffers[b]);
+      cudaEventDestroy(events[b]);
+    }
+
+    cudaEventDestroy(done);
+    cudaStreamDestroy(stream);
+  }
+
+  private:
+  char *       buffers[num_buffers];
+  cudaEvent_t  events[num_buffers];
+  cudaEvent_t  done;
+  cudaStream_t stream;
+  size_t       next;
+  bool         initialized;
+  bool         valid;
+
+  pinned_staging_pool(void)
+    : next(0), initialized(false), valid(false) {}
+
+  // not copyable
+  pinned_staging_pool(const pinned_staging_pool&);
+  pinned_staging_pool& operator=(const pinned_staging_pool&);
+
+  void initialize(void)
+  {
+    initialized = true;
+
+    size_t allocated = 0;
+
+    for (; allocated < num_buffers; allocated++)
+      if (cudaMallocHost((void **) &buffers[allocated], buffer_size) != cudaSuccess)
+        break;
+
+    if (allocated < num_buffers ||
+        cudaStreamCreate(&stream) != cudaSuccess)
+    {
+      for (size_t b = 0; b < allocated; b++)
+        cudaFreeHost(buffers[b]);
+
+      // clear the error and fall back to pageable transfers
+      cudaGetLastError();
+      return;
+    }
+
+    for (size_t b = 0; b < num_buffers; b++)
+      cudaEventCreateWithFlags(&events[b], cudaEventDisableTiming);
+
+    cudaEventCreateWithFlags(&done, cudaEventDisableTiming);
+
+    valid = true;
+  }
+
+  void wait_for_current_stream(void)
+  {
+    check(cudaEventRecord(done, current_stream()));
+    check(cudaStreamWaitEvent(stream, done, 0));
+  }
+
+  void drain(char * d, size_t c, size_t bytes)
+  {
+    size_t offset = c * buffer_size;
+    size_t length = std::min(size_t(buffer_size), bytes - offset);
+    size_t b = c % num_buffers;
+
+    check(cudaEventSynchronize(events[b]));
+
+    std::memcpy(d + offset, buffers[b], length);
+  }
+
+  static void check(cudaError_t error)
+  {
+    if (error != cudaSuccess)
+      throw cusp::runtime_exception(std::string("staged transfer failed: ") + cudaGetErrorString(error));
+  }
+};
+
+// holds the pool for one transfer if no other thread is using it
+class staging_guard
+{
+  public:
+  staging_guard(void) : owned(pinned_staging_pool::lock().try_lock()) {}
+
+  ~staging_guard(void)
+  {
+    if (owned)
+      pinned_staging_pool::lock().unlock();
+  }
+
+  bool usable(void) const
+  {
+    return owned && pinned_staging_pool::get().available();
+  }
+
+  private:
+  bool owned;
+
+  // not copyable
+  staging_guard(const staging_guard&);
+  staging_guard& operator=(const staging_guard&);
+};
+
+// returns false when the transfer should use the regular path instead
+template <typename ValueType>
+bool staged_copy_to_device(ValueType * dst, const ValueType * src, size_t n)
+{
+  const size_t bytes = n * sizeof(ValueType);
+
+  if (bytes < pinned_staging_pool::min_staged_size)
+    return false;
+
+  staging_guard guard;
+
+  if (!guard.usable())
+    return false;
+
+  pinned_staging_pool::get().copy_to_device(dst, src, bytes);
+
+  return true;
+}
+
+template <typename ValueType>
+bool staged_copy_to_host(ValueType * dst, const ValueType * src, size_t n)
+{
+  const size_t bytes = n * sizeof(ValueType);
+
+  if (bytes < pinned_staging_pool::min_staged_size)
+    return false;
+
+  staging_guard guard;
+
+  if (!guard.usable())
+    return false;
+
+  pinned_staging_pool::get().copy_to_host(dst, src, bytes);
+
+  return true;
+}
+
+} // end namespace device
+} // end namespace detail
+} // end namespace cusp
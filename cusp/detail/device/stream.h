@@ -0,0 +1,73 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+#pragma once
+
+#include <cusp/detail/mutex.h>
+
+#include <cuda_runtime_api.h>
+
+namespace cusp
+{
+namespace detail
+{
+namespace device
+{
+
+// stream used while no cusp::stream_scope is active.  With
+// CUSP_PER_THREAD_DEFAULT_STREAM each host thread issues its work on its
+// own default stream, which does not serialize with the other threads.
+inline cudaStream_t default_stream(void)
+{
+#if defined(CUSP_PER_THREAD_DEFAULT_STREAM) && CUDART_VERSION >= 7000
+    return cudaStreamPerThread;
+#else
+    return 0;
+#endif
+}
+
+// The stream on which Cusp issues device kernels and Thrust algorithms.
+// Each host thread has its own, so a cusp::stream_scope only directs the
+// work of the thread which opened it.
+inline cudaStream_t& current_stream_storage(void)
+{
+    static __CUSP_THREAD_LOCAL bool initialized = false;
+    static __CUSP_THREAD_LOCAL cudaStream_t stream = 0;
+
+    if (!initialized)
+    {
+        stream = default_stream();
+        initialized = true;
+    }
+
+    return stream;
+}
+
+inline cudaStream_t current_stream(void)
+{
+    return current_stream_storage();
+}
+
+inline void set_current_stream(cudaStream_t stream)
+{
+    current_stream_storage() = stream;
+}
+
+} // end namespace device
+} // end namespace detail
+} // end namespace cusp
+
@@ -14,165 +14,238 @@
  *  limitations under the License.
  */
 
+
 #pragma once
 
-#include <cuda.h>
+#include <cstring>
+
+#include <cuda_runtime_api.h>
+#include <thrust/detail/type_traits.h>
+
+#include <cusp/cache.h>
 #include <cusp/complex.h>
-#include <cusp/exception.h>
-#include <cusp/detail/device/utils.h>
 
-#ifdef CUSP_USE_TEXTURE_MEMORY    
-// These textures are (optionally) used to cache the 'x' vector in y += A*x
-texture<float,1> tex_x_float;
-texture<int2,1>  tex_x_double;
+#include <cusp/detail/device/l2_persistence.h>
+
+// The kernels of y = A * x read x through fetch_x.  With UseCache the loads
+// go through the read-only data cache (__ldg) or, when the current
+// spmv_cache_mode asks for it, through a texture object created by bind_x
+// for that launch.  Unlike the former global texture references nothing is
+// shared between launches, so cached SpMVs on several streams or host
+// threads may run at the same time.  Inside a cusp::l2_persistence_scope
+// bind_x also points the access policy window of the current stream at x
+// and unbind_x clears it again.
+
+#if CUDART_VERSION >= 5000
+#define __CUSP_USE_TEXTURE_OBJECTS__
 #endif
 
-inline void bind_x(const float * x)
-{   
-#ifdef CUSP_USE_TEXTURE_MEMORY    
-    size_t offset = size_t(-1);
-    CUDA_SAFE_CALL(cudaBindTexture(&offset, tex_x_float, x));
-    if (offset != 0)
-        throw cusp::invalid_input_exception("memory is not aligned, refusing to use texture cache");
-#else
-    throw cusp::runtime_exception("texture support was not enabled");
+namespace cusp
+{
+namespace detail
+{
+namespace device
+{
+
+// x as passed to the SpMV kernels
+template <typename ValueType>
+struct cached_x
+{
+    const ValueType * ptr;
+#ifdef __CUSP_USE_TEXTURE_OBJECTS__
+    cudaTextureObject_t texture;
 #endif
+    bool textured;
+    bool persistent;
+};
+
+// element types read through textures, doubles are fetched as pairs of ints
+template <typename ValueType> struct texture_element { static const bool value = false; };
+template <> struct texture_element<float>                 { static const bool value = true; typedef float  type; };
+template <> struct texture_element<double>                { static const bool value = true; typedef int2   type; };
+template <> struct texture_element<cusp::complex<float> > { static const bool value = true; typedef float2 type; };
+template <> struct texture_element<cusp::complex<double> >{ static const bool value = true; typedef int4   type; };
+
+#ifdef __CUSP_USE_TEXTURE_OBJECTS__
+template <typename ValueType>
+bool create_texture(const ValueType * x, size_t n, cudaTextureObject_t& texture, thrust::detail::true_type)
+{
+    int device, alignment, max_width;
+    cudaGetDevice(&device);
+    cudaDeviceGetAttribute(&alignment, cudaDevAttrTextureAlignment,         device);
+    cudaDeviceGetAttribute(&max_width, cudaDevAttrMaxTexture1DLinearWidth, device);
+
+    if (n == 0 || n > size_t(max_width) || reinterpret_cast<size_t>(x) % size_t(alignment) != 0)
+        return false;
+
+    cudaResourceDesc resource;
+    std::memset(&resource, 0, sizeof(resource));
+    resource.resType                = cudaResourceTypeLinear;
+    resource.res.linear.devPtr      = const_cast<ValueType *>(x);
+    resource.res.linear.desc        = cudaCreateChannelDesc<typename texture_element<ValueType>::type>();
+    resource.res.linear.sizeInBytes = n * sizeof(ValueType);
+
+    cudaTextureDesc description;
+    std::memset(&description, 0, sizeof(description));
+    description.readMode = cudaReadModeElementType;
+
+    if (cudaCreateTextureObject(&texture, &resource, &description, 0) != cudaSuccess)
+    {
+        // clear the error and use the read-only cache instead
+        cudaGetLastError();
+        return false;
+    }
+
+    return true;
 }
 
-// Use int2 to pull doubles through texture cache
-inline void bind_x(const double * x)
-{   
-#ifdef CUSP_USE_TEXTURE_MEMORY    
-    size_t offset = size_t(-1);
-    CUDA_SAFE_CALL(cudaBindTexture(&offset, tex_x_double, x));
-    if (offset != 0)
-        throw cusp::invalid_input_exception("memory is not aligned, refusing to use texture cache");
-#else
-    throw cusp::runtime_exception("texture support was not enabled");
-#endif
+template <typename ValueType>
+bool create_texture(const ValueType *, size_t, cudaTextureObject_t&, thrust::detail::false_type)
+{
+    return false;
 }
+#endif // __CUSP_USE_TEXTURE_OBJECTS__
+
+// keep the n entries of x in the persisting part of the L2 cache
+inline bool persist_x(const void * x, size_t bytes)
+{
+    return cusp::detail::device::current_l2_persistence_storage() &&
+           cusp::detail::device::set_persistent_window(x, bytes);
+}
+
+// prepare the n entries of x for the kernels of one SpMV
+template <bool UseCache, typename ValueType>
+cached_x<ValueType> bind_x(const ValueType * x, size_t n)
+{
+    cached_x<ValueType> result;
+    result.ptr        = x;
+    result.textured   = false;
+    result.persistent = UseCache && persist_x(x, n * sizeof(ValueType));
 
+#ifdef __CUSP_USE_TEXTURE_OBJECTS__
+    result.texture  = 0;
 
-inline void bind_x(const cusp::complex<float> * x)
-{   
-#ifdef CUSP_USE_TEXTURE_MEMORY    
-    size_t offset = size_t(-1);
-    CUDA_SAFE_CALL(cudaBindTexture(&offset, tex_x_float, x));
-    if (offset != 0)
-        throw cusp::invalid_input_exception("memory is not aligned, refusing to use texture cache");
-#else
-    throw cusp::runtime_exception("texture support was not enabled");
+    if (UseCache && cusp::detail::device::current_spmv_cache_storage() == cusp::texture_cache)
+        result.textured = create_texture(x, n, result.texture,
+                                         thrust::detail::integral_constant<bool, texture_element<ValueType>::value>());
 #endif
+
+    return result;
 }
 
-// Use int2 to pull doubles through texture cache
-inline void bind_x(const cusp::complex<double> * x)
-{   
-#ifdef CUSP_USE_TEXTURE_MEMORY    
-    size_t offset = size_t(-1);
-    CUDA_SAFE_CALL(cudaBindTexture(&offset, tex_x_double, x));
-    if (offset != 0)
-        throw cusp::invalid_input_exception("memory is not aligned, refusing to use texture cache");
-#else
-    throw cusp::runtime_exception("texture support was not enabled");
+// bind_x for the kernels of Policy (cusp/detail/device/arch_policy.h):
+// without the read-only data cache the texture is the only cache for x, so
+// it is used in either spmv_cache_mode
+template <bool UseCache, typename Policy, typename ValueType>
+cached_x<ValueType> bind_x(const ValueType * x, size_t n)
+{
+    if (!UseCache || Policy::HAS_READ_ONLY_CACHE)
+        return bind_x<UseCache>(x, n);
+
+    cached_x<ValueType> result;
+    result.ptr        = x;
+    result.textured   = false;
+    result.persistent = persist_x(x, n * sizeof(ValueType));
+
+#ifdef __CUSP_USE_TEXTURE_OBJECTS__
+    result.texture  = 0;
+    result.textured = create_texture(x, n, result.texture,
+                                     thrust::detail::integral_constant<bool, texture_element<ValueType>::value>());
 #endif
-}
 
+    return result;
+}
 
-// Note: x is unused, but distinguishes the two unbind functions
-inline void unbind_x(const float * x)
+// Destruction does not wait for the kernels which use the texture, like
+// unbinding the texture references did not.
+template <typename ValueType>
+void unbind_x(const cached_x<ValueType>& x)
 {
-#ifdef CUSP_USE_TEXTURE_MEMORY
-    CUDA_SAFE_CALL(cudaUnbindTexture(tex_x_float));
-#else
-    throw cusp::runtime_exception("texture support was not enabled");
+    if (x.persistent)
+        cusp::detail::device::clear_persistent_window();
+
+#ifdef __CUSP_USE_TEXTURE_OBJECTS__
+    if (x.textured)
+        cudaDestroyTextureObject(x.texture);
 #endif
 }
-inline void unbind_x(const double * x)
+
+// loads through the read-only data cache
+template <typename ValueType>
+__inline__ __device__ ValueType load_read_only(const ValueType * x)
 {
-#ifdef CUSP_USE_TEXTURE_MEMORY
-    CUDA_SAFE_CALL(cudaUnbindTexture(tex_x_double));
-#else
-    throw cusp::runtime_exception("texture support was not enabled");
-#endif
+    return *x;
 }
-inline void unbind_x(const cusp::complex<float> * x)
+
+#if defined(__CUDA_ARCH__) && __CUDA_ARCH__ >= 350
+__inline__ __device__ int    load_read_only(const int * x)    { return __ldg(x); }
+__inline__ __device__ float  load_read_only(const float * x)  { return __ldg(x); }
+__inline__ __device__ double load_read_only(const double * x) { return __ldg(x); }
+
+__inline__ __device__ cusp::complex<float> load_read_only(const cusp::complex<float> * x)
 {
-#ifdef CUSP_USE_TEXTURE_MEMORY
-    CUDA_SAFE_CALL(cudaUnbindTexture(tex_x_float));
-#else
-    throw cusp::runtime_exception("texture support was not enabled");
-#endif
+    float2 v = __ldg(reinterpret_cast<const float2 *>(x));
+    return cusp::complex<float>(v.x, v.y);
 }
 
-inline void unbind_x(const cusp::complex<double> * x)
+__inline__ __device__ cusp::complex<double> load_read_only(const cusp::complex<double> * x)
 {
-#ifdef CUSP_USE_TEXTURE_MEMORY
-    CUDA_SAFE_CALL(cudaUnbindTexture(tex_x_double));
-#else
-    throw cusp::runtime_exception("texture support was not enabled");
+    double2 v = __ldg(reinterpret_cast<const double2 *>(x));
+    return cusp::complex<double>(v.x, v.y);
+}
 #endif
+
+#ifdef __CUSP_USE_TEXTURE_OBJECTS__
+template <typename ValueType>
+__inline__ __device__ ValueType fetch_texture(cudaTextureObject_t texture, const int& i, ValueType *)
+{
+    // not reached, bind_x only creates textures of the types below
+    return ValueType();
 }
 
-template <bool UseCache>
-__inline__ __device__ float fetch_x(const int& i, const float * x)
+__inline__ __device__ float fetch_texture(cudaTextureObject_t texture, const int& i, float *)
 {
-#ifdef CUSP_USE_TEXTURE_MEMORY
-    if (UseCache)
-        return tex1Dfetch(tex_x_float, i);
-    else
-#endif
-        return x[i];
+    return tex1Dfetch<float>(texture, i);
 }
 
-template <bool UseCache>
-__inline__ __device__ double fetch_x(const int& i, const double * x)
+__inline__ __device__ double fetch_texture(cudaTextureObject_t texture, const int& i, double *)
 {
-#if __CUDA_ARCH__ >= 130
-#ifdef CUSP_USE_TEXTURE_MEMORY
-    // double requires Compute Capability 1.3 or greater
-    if (UseCache)
-    {
-        int2 v = tex1Dfetch(tex_x_double, i);
-        return __hiloint2double(v.y, v.x);
-    }
-    else
-#endif // CUSP_USE_TEXTURE_MEMORY
-        return x[i];
-#else 
-    return 1.0f;
-#endif
+    int2 v = tex1Dfetch<int2>(texture, i);
+    return __hiloint2double(v.y, v.x);
 }
 
+__inline__ __device__ cusp::complex<float> fetch_texture(cudaTextureObject_t texture, const int& i, cusp::complex<float> *)
+{
+    float2 v = tex1Dfetch<float2>(texture, i);
+    return cusp::complex<float>(v.x, v.y);
+}
 
-template <bool UseCache>
-__inline__ __device__ cusp::complex<float> fetch_x(const int& i, const cusp::complex<float> * x)
+__inline__ __device__ cusp::complex<double> fetch_texture(cudaTextureObject_t texture, const int& i, cusp::complex<double> *)
 {
-#ifdef CUSP_USE_TEXTURE_MEMORY
-    if (UseCache)
-      return cusp::complex<float>(tex1Dfetch(tex_x_float, i*2),tex1Dfetch(tex_x_float, i*2+1));
-    else
-#endif
-        return x[i];
+    int4 v = tex1Dfetch<int4>(texture, i);
+    return cusp::complex<double>(__hiloint2double(v.y, v.x), __hiloint2double(v.w, v.z));
 }
+#endif // __CUSP_USE_TEXTURE_OBJECTS__
 
-template <bool UseCache>
-__inline__ __device__ cusp::complex<double> fetch_x(const int& i, const cusp::complex<double> * x)
+template <bool UseCache, typename ValueType>
+__inline__ __device__ ValueType fetch_x(const int& i, const cached_x<ValueType>& x)
 {
-#if __CUDA_ARCH__ >= 130
-#ifdef CUSP_USE_TEXTURE_MEMORY
-    // double requires Compute Capability 1.3 or greater
     if (UseCache)
-      {
-	int2 vr = tex1Dfetch(tex_x_double, i*2);
-	int2 vi = tex1Dfetch(tex_x_double, i*2+1);
-        return cusp::complex<double<(__hiloint2double(vr.y, vr.x),__hiloint2double(vr.y, vr.x));
+    {
+#ifdef __CUSP_USE_TEXTURE_OBJECTS__
+        if (x.textured)
+            return fetch_texture(x.texture, i, (ValueType *) 0);
+#endif
+        return load_read_only(x.ptr + i);
     }
     else
-#endif // CUSP_USE_TEXTURE_MEMORY
-        return x[i];
-#else 
-    return 1.0f;
-#endif
+    {
+        return x.ptr[i];
+    }
 }
 
+} // end namespace device
+} // end namespace detail
+} // end namespace cusp
+
+#undef __CUSP_USE_TEXTURE_OBJECTS__
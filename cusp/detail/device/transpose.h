@@ -23,14 +23,24 @@
 #include <cusp/detail/utils.h>
 #include <cusp/detail/format_utils.h>
 
+#include <cusp/detail/device/arch.h>
+#include <cusp/detail/device/common.h>
+#include <cusp/detail/device/stream.h>
+#include <cusp/detail/device/utils.h>
+
+#include <thrust/fill.h>
 #include <thrust/functional.h>
 #include <thrust/gather.h>
+#include <thrust/inner_product.h>
+#include <thrust/scan.h>
 #include <thrust/sequence.h>
 #include <thrust/sort.h>
 #include <thrust/iterator/counting_iterator.h>
 #include <thrust/iterator/transform_iterator.h>
 #include <thrust/iterator/zip_iterator.h>
 
+#include <thrust/detail/type_traits.h>
+
 namespace cusp
 {
 namespace detail
@@ -55,16 +65,104 @@ void transpose(const MatrixType1& A, MatrixType2& At,
 
 
 // CSR format
+//
+// The transpose is a counting sort by column: the entries of each column
+// of A are counted with atomics into the row offsets of A^T, which are
+// then scanned, and every entry is scattered to its row of A^T with an
+// atomic increment of that row's cursor.  The atomics leave the entries
+// of a row of A^T in arbitrary order, so one thread per row then sorts
+// its segment by insertion, which keeps the work O(nnz) for the short
+// rows of restriction operators.  Matrices with a row of A^T longer than
+// TRANSPOSE_INSERTION_LIMIT, where the insertion sort would be
+// quadratic, are transposed by sorting the entries by column instead.
+// CUDA has no atomicAdd for signed 64-bit integers, so index types other
+// than int and unsigned int are always transposed by sorting.
+
+const size_t TRANSPOSE_INSERTION_LIMIT = 64;
+
+template <typename IndexType1, typename IndexType2, unsigned int BLOCK_SIZE>
+__launch_bounds__(BLOCK_SIZE,1)
+__global__ void
+transpose_count_kernel(const IndexType1 num_entries,
+                       const IndexType1 * Aj,
+                             IndexType2 * counts)
+{
+    const IndexType1 thread_id = BLOCK_SIZE * blockIdx.x + threadIdx.x;
+    const IndexType1 grid_size = BLOCK_SIZE * gridDim.x;
+
+    for(IndexType1 n = thread_id; n < num_entries; n += grid_size)
+        atomicAdd(counts + Aj[n], IndexType2(1));
+}
+
+template <typename IndexType1, typename IndexType2, typename ValueType1, typename ValueType2, unsigned int BLOCK_SIZE>
+__launch_bounds__(BLOCK_SIZE,1)
+__global__ void
+transpose_scatter_kernel(const IndexType1 num_rows,
+                         const IndexType1 * Ap,
+                         const IndexType1 * Aj,
+                         const ValueType1 * Ax,
+                               IndexType2 * cursor,
+                               IndexType2 * Bj,
+                               ValueType2 * Bx)
+{
+    const IndexType1 thread_id = BLOCK_SIZE * blockIdx.x + threadIdx.x;
+    const IndexType1 grid_size = BLOCK_SIZE * gridDim.x;
+
+    for(IndexType1 row = thread_id; row < num_rows; row += grid_size)
+    {
+        const IndexType1 row_end = Ap[row + 1];
+
+        for(IndexType1 jj = Ap[row]; jj < row_end; jj++)
+        {
+            const IndexType2 position = atomicAdd(cursor + Aj[jj], IndexType2(1));
+
+            Bj[position] = row;
+            Bx[position] = Ax[jj];
+        }
+    }
+}
+
+template <typename IndexType, typename ValueType, unsigned int BLOCK_SIZE>
+__launch_bounds__(BLOCK_SIZE,1)
+__global__ void
+transpose_sort_rows_kernel(const IndexType num_rows,
+                           const IndexType * Bp,
+                                 IndexType * Bj,
+                                 ValueType * Bx)
+{
+    const IndexType thread_id = BLOCK_SIZE * blockIdx.x + threadIdx.x;
+    const IndexType grid_size = BLOCK_SIZE * gridDim.x;
+
+    for(IndexType row = thread_id; row < num_rows; row += grid_size)
+    {
+        const IndexType row_start = Bp[row];
+        const IndexType row_end   = Bp[row + 1];
+
+        for(IndexType jj = row_start + 1; jj < row_end; jj++)
+        {
+            const IndexType col   = Bj[jj];
+            const ValueType value = Bx[jj];
+
+            IndexType ii = jj;
+
+            for(; ii > row_start && Bj[ii - 1] > col; ii--)
+            {
+                Bj[ii] = Bj[ii - 1];
+                Bx[ii] = Bx[ii - 1];
+            }
+
+            Bj[ii] = col;
+            Bx[ii] = value;
+        }
+    }
+}
+
 template <typename MatrixType1,   typename MatrixType2>
-void transpose(const MatrixType1& A, MatrixType2& At,
-               cusp::csr_format,
-               cusp::csr_format)
+void transpose_by_sort(const MatrixType1& A, MatrixType2& At)
 {
     typedef typename MatrixType2::index_type   IndexType2;
     typedef typename MatrixType2::memory_space MemorySpace2;
 
-    At.resize(A.num_cols, A.num_rows, A.num_entries);
-
     cusp::detail::offsets_to_indices(A.row_offsets, At.column_indices);
     cusp::copy(A.values, At.values);
 
@@ -75,6 +173,102 @@ void transpose(const MatrixType1& A, MatrixType2& At,
     cusp::detail::indices_to_offsets(At_row_indices, At.row_offsets);
 }
 
+template <typename MatrixType1,   typename MatrixType2>
+void transpose_by_count(const MatrixType1& A, MatrixType2& At,
+                        thrust::detail::false_type)
+{
+    transpose_by_sort(A, At);
+}
+
+template <typename MatrixType1,   typename MatrixType2>
+void transpose_by_count(const MatrixType1& A, MatrixType2& At,
+                        thrust::detail::true_type)
+{
+    typedef typename MatrixType1::index_type   IndexType1;
+    typedef typename MatrixType2::index_type   IndexType;
+    typedef typename MatrixType1::value_type   ValueType1;
+    typedef typename MatrixType2::value_type   ValueType2;
+    typedef typename MatrixType2::memory_space MemorySpace;
+
+    thrust::fill(At.row_offsets.begin(), At.row_offsets.end(), IndexType(0));
+
+    const unsigned int BLOCK_SIZE = 256;
+
+    // entries per column of A, shifted by one so the scan gives offsets
+    {
+        const size_t MAX_BLOCKS = cusp::detail::device::arch::max_active_blocks(transpose_count_kernel<IndexType1,IndexType,BLOCK_SIZE>, BLOCK_SIZE, (size_t) 0);
+        const size_t NUM_BLOCKS = std::min<size_t>(MAX_BLOCKS, DIVIDE_INTO(A.num_entries, BLOCK_SIZE));
+
+        transpose_count_kernel<IndexType1,IndexType,BLOCK_SIZE> <<<NUM_BLOCKS, BLOCK_SIZE, 0, cusp::detail::device::current_stream()>>>
+            (A.num_entries,
+             thrust::raw_pointer_cast(&A.column_indices[0]),
+             thrust::raw_pointer_cast(&At.row_offsets[0]) + 1);
+    }
+
+    thrust::inclusive_scan(At.row_offsets.begin(), At.row_offsets.end(), At.row_offsets.begin());
+
+    // longest row of A^T
+    const IndexType max_row_length =
+        thrust::inner_product(At.row_offsets.begin() + 1, At.row_offsets.end(), At.row_offsets.begin(),
+                              IndexType(0), thrust::maximum<IndexType>(), thrust::minus<IndexType>());
+
+    if (size_t(max_row_length) > TRANSPOSE_INSERTION_LIMIT)
+    {
+        transpose_by_sort(A, At);
+        return;
+    }
+
+    cusp::array1d<IndexType,MemorySpace> cursor(At.row_offsets.begin(), At.row_offsets.end() - 1);
+
+    if (A.num_rows > 0)
+    {
+        const size_t MAX_BLOCKS = cusp::detail::device::arch::max_active_blocks(transpose_scatter_kernel<IndexType1,IndexType,ValueType1,ValueType2,BLOCK_SIZE>, BLOCK_SIZE, (size_t) 0);
+        const size_t NUM_BLOCKS = std::min<size_t>(MAX_BLOCKS, DIVIDE_INTO(A.num_rows, BLOCK_SIZE));
+
+        transpose_scatter_kernel<IndexType1,IndexType,ValueType1,ValueType2,BLOCK_SIZE> <<<NUM_BLOCKS, BLOCK_SIZE, 0, cusp::detail::device::current_stream()>>>
+            (A.num_rows,
+             thrust::raw_pointer_cast(&A.row_offsets[0]),
+             thrust::raw_pointer_cast(&A.column_indices[0]),
+             thrust::raw_pointer_cast(&A.values[0]),
+             thrust::raw_pointer_cast(&cursor[0]),
+             thrust::raw_pointer_cast(&At.column_indices[0]),
+             thrust::raw_pointer_cast(&At.values[0]));
+    }
+
+    if (At.num_rows > 0)
+    {
+        const size_t MAX_BLOCKS = cusp::detail::device::arch::max_active_blocks(transpose_sort_rows_kernel<IndexType,ValueType2,BLOCK_SIZE>, BLOCK_SIZE, (size_t) 0);
+        const size_t NUM_BLOCKS = std::min<size_t>(MAX_BLOCKS, DIVIDE_INTO(At.num_rows, BLOCK_SIZE));
+
+        transpose_sort_rows_kernel<IndexType,ValueType2,BLOCK_SIZE> <<<NUM_BLOCKS, BLOCK_SIZE, 0, cusp::detail::device::current_stream()>>>
+            (At.num_rows,
+             thrust::raw_pointer_cast(&At.row_offsets[0]),
+             thrust::raw_pointer_cast(&At.column_indices[0]),
+             thrust::raw_pointer_cast(&At.values[0]));
+    }
+}
+
+template <typename MatrixType1,   typename MatrixType2>
+void transpose(const MatrixType1& A, MatrixType2& At,
+               cusp::csr_format,
+               cusp::csr_format)
+{
+    typedef typename MatrixType2::index_type IndexType;
+
+    At.resize(A.num_cols, A.num_rows, A.num_entries);
+
+    if (A.num_entries == 0)
+    {
+        thrust::fill(At.row_offsets.begin(), At.row_offsets.end(), IndexType(0));
+        return;
+    }
+
+    transpose_by_count(A, At,
+                       thrust::detail::integral_constant<bool,
+                           thrust::detail::is_same<IndexType,int>::value ||
+                           thrust::detail::is_same<IndexType,unsigned int>::value>());
+}
+
 
 } // end namespace device
 } // end namespace detail
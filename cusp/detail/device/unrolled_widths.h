@@ -0,0 +1,46 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+#pragma once
+
+// Row widths with a kernel of their own.
+//
+// The ELL kernel loops over the stored entries of each row and the BSR
+// kernel over the columns of each block.  When the width is a template
+// parameter the loop is unrolled, the column indices of a row are loaded
+// into registers before the values and x are read, and the loop bounds
+// are constants; stencil matrices, whose ELL width is 5, 7, 9 or 27, and
+// small block sizes run noticeably faster that way.  The launchers
+// instantiate one kernel per width listed below and use the generic
+// kernel for every other width.
+//
+// Each list applies its argument to the widths, so they may be replaced
+// on the command line, e.g.
+//
+//   -D'CUSP_ELL_UNROLLED_WIDTHS(W)=W(5) W(7)'
+//   -D'CUSP_BSR_UNROLLED_SIZES(W)='
+//
+// where an empty list leaves only the generic kernel.  Every width costs
+// one kernel per launch configuration in the binary.
+
+#ifndef CUSP_ELL_UNROLLED_WIDTHS
+#define CUSP_ELL_UNROLLED_WIDTHS(W) W(3) W(4) W(5) W(7) W(9) W(27)
+#endif
+
+#ifndef CUSP_BSR_UNROLLED_SIZES
+#define CUSP_BSR_UNROLLED_SIZES(W) W(1) W(2) W(3) W(4) W(5) W(6)
+#endif
@@ -17,6 +17,8 @@
 
 #pragma once
 
+#include <cusp/detail/device/stream.h>
+
 #include <thrust/pair.h>
 
 #define CUDA_SAFE_CALL_NO_SYNC( call) do {                                \
@@ -51,6 +53,43 @@ Size1 DIVIDE_INTO(Size1 N, Size2 granularity)
   return (N + (granularity - 1)) / granularity;
 }
 
+// makes a device and one of its streams current for the lifetime of the
+// object, so that work on several devices is not issued on the stream of
+// another device
+class device_scope
+{
+    public:
+    explicit device_scope(int device, cudaStream_t stream = 0)
+        : previous_stream(current_stream())
+    {
+        cudaGetDevice(&previous_device);
+
+        if (device != previous_device)
+            cudaSetDevice(device);
+
+        set_current_stream(stream);
+    }
+
+    ~device_scope(void)
+    {
+        set_current_stream(previous_stream);
+
+        int device;
+        cudaGetDevice(&device);
+
+        if (device != previous_device)
+            cudaSetDevice(previous_device);
+    }
+
+    private:
+    int previous_device;
+    cudaStream_t previous_stream;
+
+    // non-copyable
+    device_scope(const device_scope&);
+    device_scope& operator=(const device_scope&);
+};
+
 template <typename T>
 thrust::pair<T,T> uniform_splitting(const T N, const T granularity, const T max_intervals)
 {
@@ -0,0 +1,77 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+namespace cusp
+{
+
+#if defined(CUSP_USE_DEVICE_CACHE)
+
+inline device_cache_scope::device_cache_scope(bool enable)
+    : previous(cusp::detail::device::current_device_cache().is_enabled())
+{
+    cusp::detail::device::current_device_cache().set_enabled(enable);
+}
+
+inline device_cache_scope::~device_cache_scope(void)
+{
+    cusp::detail::device::current_device_cache().set_enabled(previous);
+}
+
+inline void trim_device_cache(size_t keep_bytes)
+{
+    cusp::detail::device::current_device_cache().trim(keep_bytes);
+}
+
+inline void set_device_cache_limit(size_t max_cached_bytes)
+{
+    cusp::detail::device::current_device_cache().set_max_cached_bytes(max_cached_bytes);
+}
+
+inline cusp::device_cache_statistics device_cache_usage(void)
+{
+    const cusp::detail::device::cache_statistics s =
+        cusp::detail::device::current_device_cache().get_statistics();
+
+    cusp::device_cache_statistics result;
+    result.live_bytes     = s.live_bytes;
+    result.cached_bytes   = s.cached_bytes;
+    result.allocations    = s.allocations;
+    result.hits           = s.hits;
+    result.device_mallocs = s.device_mallocs;
+    return result;
+}
+
+#else
+
+// the cache is not compiled in (CUSP_NO_DEVICE_CACHE or a non-CUDA device
+// system), there is nothing to control
+
+inline device_cache_scope::device_cache_scope(bool enable) : previous(false) {}
+
+inline device_cache_scope::~device_cache_scope(void) {}
+
+inline void trim_device_cache(size_t keep_bytes) {}
+
+inline void set_device_cache_limit(size_t max_cached_bytes) {}
+
+inline cusp::device_cache_statistics device_cache_usage(void)
+{
+    return cusp::device_cache_statistics();
+}
+
+#endif
+
+} // end namespace cusp
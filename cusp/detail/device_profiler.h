@@ -0,0 +1,564 @@
+/*
+ *  Copyright 2008-2010 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+// Device-side backend of CUSP_PROFILE_SCOPED, selected by defining
+// CUSP_PROFILE_DEVICE together with CUSP_PROFILE_ENABLED.
+//
+// Every scope records a pair of CUDA events on the current stream when it is
+// entered and left.  The events are not waited for when the scope ends;
+// they are resolved in batches (and by dump()), so that profiling does not
+// serialize the host with the device and the time of asynchronous kernels is
+// charged to the scope which launched them rather than to whichever later
+// call happens to synchronize.  The elapsed times are aggregated per call
+// path, i.e. per chain of enclosing scopes.
+//
+// Entry points annotate their scope with the bytes they move and the flops
+// they perform through CUSP_PROFILE_WORK, so the reports include the
+// achieved GB/s and GFLOP/s of every call path.  Besides the tree printed by
+// dump(), write_json() and write_csv() export the aggregated call paths and,
+// after set_tracing(true), write_chrome_trace() exports every scope as a
+// Chrome trace event (chrome://tracing, Perfetto).
+//
+// When CUSP_PROFILE_NVTX is defined every scope also pushes an NVTX range
+// named after the function, so that the structure of the Cusp calls shows
+// up in Nsight timelines (link with -lnvToolsExt).
+//
+// The profiler state is shared by all host threads and is not synchronized,
+// so only one thread should run profiled code at a time.  The host profiler
+// (CUSP_PROFILE_ENABLED alone) keeps a call tree per thread instead.
+
+#pragma once
+
+#include <cusp/detail/device/stream.h>
+
+#include <cuda_runtime_api.h>
+
+#if defined(CUSP_PROFILE_NVTX)
+#include <nvToolsExt.h>
+#endif
+
+#include <stdio.h>
+#include <string.h>
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+#if defined(_MSC_VER)
+#define CUSP_DEVICE_PROFILE_FUNCTION() __FUNCSIG__
+#else
+#define CUSP_DEVICE_PROFILE_FUNCTION() __PRETTY_FUNCTION__
+#endif
+
+namespace cusp
+{
+namespace detail
+{
+namespace device_profiler
+{
+
+// number of completed scopes whose events are kept before they are resolved
+const size_t MAX_PENDING = 4096;
+
+// number of scopes kept for write_chrome_trace(), later scopes are dropped
+const size_t MAX_TRACE_EVENTS = 1 << 20;
+
+// bytes moved and floating point operations performed by a scope
+struct work
+{
+    double bytes;
+    double flops;
+
+    work(void) : bytes(0.0), flops(0.0) {}
+};
+
+struct call_path
+{
+    const char * name;
+    call_path * parent;
+    std::vector<call_path *> children;
+    size_t calls;
+    double milliseconds;
+    cusp::detail::device_profiler::work work;
+
+    call_path(const char * name, call_path * parent)
+        : name(name), parent(parent), calls(0), milliseconds(0.0) {}
+
+    ~call_path(void)
+    {
+        for (size_t i = 0; i < children.size(); i++)
+            delete children[i];
+    }
+
+    call_path * child(const char * child_name)
+    {
+        for (size_t i = 0; i < children.size(); i++)
+            if (children[i]->name == child_name || strcmp(children[i]->name, child_name) == 0)
+                return children[i];
+
+        children.push_back(new call_path(child_name, this));
+        return children.back();
+    }
+
+    double child_milliseconds(void) const
+    {
+        double sum = 0.0;
+        for (size_t i = 0; i < children.size(); i++)
+            sum += children[i]->milliseconds;
+        return sum;
+    }
+
+    // work of this path and all paths below it
+    cusp::detail::device_profiler::work inclusive_work(void) const
+    {
+        cusp::detail::device_profiler::work sum = work;
+        for (size_t i = 0; i < children.size(); i++)
+        {
+            cusp::detail::device_profiler::work w = children[i]->inclusive_work();
+            sum.bytes += w.bytes;
+            sum.flops += w.flops;
+        }
+        return sum;
+    }
+
+    private:
+    // not copyable
+    call_path(const call_path&);
+    call_path& operator=(const call_path&);
+};
+
+// a completed scope whose device time is not known yet
+struct pending_scope
+{
+    call_path * path;
+    cudaEvent_t start;
+    cudaEvent_t end;
+    cusp::detail::device_profiler::work work;
+};
+
+// a resolved scope for write_chrome_trace(), times are relative to the
+// origin event
+struct trace_event
+{
+    const call_path * path;
+    double start;
+    double duration;
+    cusp::detail::device_profiler::work work;
+};
+
+struct profiler_state
+{
+    call_path root;
+    call_path * active;
+    std::vector<cudaEvent_t> free_events;
+    std::vector<cudaEvent_t> open_events;   // start events of the active scopes
+    std::vector<work> open_work;            // work of the active scopes
+    std::vector<pending_scope> pending;
+
+    bool tracing;
+    cudaEvent_t origin;
+    std::vector<trace_event> trace;
+    size_t dropped_trace_events;
+
+    profiler_state(void)
+        : root("/Main", NULL), active(&root), tracing(false), origin(NULL), dropped_trace_events(0) {}
+
+    ~profiler_state(void)
+    {
+        // the CUDA context may already be gone when static objects are
+        // destroyed, so the events are not released here
+    }
+
+    cudaEvent_t acquire_event(void)
+    {
+        if (free_events.empty())
+        {
+            cudaEvent_t event;
+            cudaEventCreate(&event);
+            return event;
+        }
+
+        cudaEvent_t event = free_events.back();
+        free_events.pop_back();
+        return event;
+    }
+
+    // wait for the pending scopes and add their times to their paths
+    void resolve(void)
+    {
+        for (size_t i = 0; i < pending.size(); i++)
+        {
+            float elapsed_time = 0.0f;
+            cudaEventSynchronize(pending[i].end);
+            cudaEventElapsedTime(&elapsed_time, pending[i].start, pending[i].end);
+
+            pending[i].path->milliseconds += elapsed_time;
+
+            if (tracing && trace.size() < MAX_TRACE_EVENTS)
+            {
+                float start_time = 0.0f;
+                cudaEventElapsedTime(&start_time, origin, pending[i].start);
+
+                trace_event event;
+                event.path     = pending[i].path;
+                event.start    = start_time;
+                event.duration = elapsed_time;
+                event.work     = pending[i].work;
+                trace.push_back(event);
+            }
+            else if (tracing)
+            {
+                dropped_trace_events++;
+            }
+
+            free_events.push_back(pending[i].start);
+            free_events.push_back(pending[i].end);
+        }
+
+        pending.clear();
+    }
+};
+
+inline profiler_state& state(void)
+{
+    static profiler_state s;
+    return s;
+}
+
+inline void enter(const char * name)
+{
+    profiler_state& s = state();
+
+    s.active = s.active->child(name);
+    s.active->calls++;
+
+    cudaEvent_t start = s.acquire_event();
+    cudaEventRecord(start, cusp::detail::device::current_stream());
+    s.open_events.push_back(start);
+    s.open_work.push_back(work());
+
+#if defined(CUSP_PROFILE_NVTX)
+    nvtxRangePushA(name);
+#endif
+}
+
+inline void exit(void)
+{
+    profiler_state& s = state();
+
+    if (s.open_events.empty())
+        return;
+
+#if defined(CUSP_PROFILE_NVTX)
+    nvtxRangePop();
+#endif
+
+    pending_scope scope;
+    scope.path  = s.active;
+    scope.start = s.open_events.back();
+    scope.end   = s.acquire_event();
+    scope.work  = s.open_work.back();
+    cudaEventRecord(scope.end, cusp::detail::device::current_stream());
+
+    s.open_events.pop_back();
+    s.open_work.pop_back();
+    s.pending.push_back(scope);
+    s.active = s.active->parent;
+
+    if (s.pending.size() >= MAX_PENDING)
+        s.resolve();
+}
+
+// charge bytes and flops to the innermost active scope
+inline void add_work(double bytes, double flops)
+{
+    profiler_state& s = state();
+
+    if (s.open_work.empty())
+        return;
+
+    s.open_work.back().bytes += bytes;
+    s.open_work.back().flops += flops;
+    s.active->work.bytes += bytes;
+    s.active->work.flops += flops;
+}
+
+// record every scope from now on for write_chrome_trace()
+inline void set_tracing(bool enabled)
+{
+    profiler_state& s = state();
+
+    s.resolve();
+
+    if (enabled && s.origin == NULL)
+    {
+        cudaEventCreate(&s.origin);
+        cudaEventRecord(s.origin, cusp::detail::device::current_stream());
+    }
+
+    s.tracing = enabled;
+}
+
+// length of the function name without its argument list
+inline int short_name_length(const char * name)
+{
+    const char * paren = strchr(name, '(');
+    return paren ? int(paren - name) : int(strlen(name));
+}
+
+inline double gbytes_per_second(const work& w, double milliseconds)
+{
+    return milliseconds > 0.0 ? w.bytes / (milliseconds * 1.0e6) : 0.0;
+}
+
+inline double gflops_per_second(const work& w, double milliseconds)
+{
+    return milliseconds > 0.0 ? w.flops / (milliseconds * 1.0e6) : 0.0;
+}
+
+// write the first length characters of text as a JSON string
+inline void write_json_string(std::ostream& os, const char * text, int length)
+{
+    os << '"';
+    for (int i = 0; i < length && text[i]; i++)
+    {
+        const char c = text[i];
+        if (c == '"' || c == '\\')
+            os << '\\' << c;
+        else if (c == '\n' || c == '\t')
+            os << ' ';
+        else
+            os << c;
+    }
+    os << '"';
+}
+
+// write text as a CSV field
+inline void write_csv_field(std::ostream& os, const char * text, int length)
+{
+    os << '"';
+    for (int i = 0; i < length && text[i]; i++)
+    {
+        if (text[i] == '"')
+            os << '"';
+        os << text[i];
+    }
+    os << '"';
+}
+
+// children of a call path which were entered, sorted by device time
+inline std::vector<const call_path *> sorted_children(const call_path * path)
+{
+    std::vector<const call_path *> sorted;
+    for (size_t i = 0; i < path->children.size(); i++)
+        if (path->children[i]->calls > 0)
+            sorted.push_back(path->children[i]);
+
+    for (size_t i = 1; i < sorted.size(); i++)
+        for (size_t j = i; j > 0 && sorted[j]->milliseconds > sorted[j - 1]->milliseconds; j--)
+        {
+            const call_path * temp = sorted[j];
+            sorted[j] = sorted[j - 1];
+            sorted[j - 1] = temp;
+        }
+
+    return sorted;
+}
+
+inline double self_milliseconds(const call_path * path)
+{
+    const double children = path->child_milliseconds();
+    return path->milliseconds > children ? path->milliseconds - children : 0.0;
+}
+
+// print a call path and its children, sorted by device time.  The function
+// signature is cut at the argument list, like the host profiler does.
+// Rates are computed from the work of the path and all paths below it.
+inline void print(const call_path * path, size_t depth)
+{
+    const work total = path->inclusive_work();
+    const std::vector<const call_path *> children = sorted_children(path);
+
+    printf("%*s%s %.3f ms device (%.3f ms self), %lu calls",
+           int(2 * depth), "", children.empty() ? "-" : "+",
+           path->milliseconds, self_milliseconds(path), (unsigned long) path->calls);
+
+    if (total.bytes > 0.0 || total.flops > 0.0)
+        printf(", %.2f GB/s, %.2f GFLOP/s",
+               gbytes_per_second(total, path->milliseconds),
+               gflops_per_second(total, path->milliseconds));
+
+    printf(": %.*s\n", short_name_length(path->name), path->name);
+
+    for (size_t i = 0; i < children.size(); i++)
+        print(children[i], depth + 1);
+}
+
+// wait for all scopes and total the top-level scopes in the root
+inline profiler_state& resolved_state(void)
+{
+    profiler_state& s = state();
+
+    s.resolve();
+
+    s.root.milliseconds = s.root.child_milliseconds();
+
+    return s;
+}
+
+inline void dump(void)
+{
+    profiler_state& s = resolved_state();
+
+    printf("> Device time per call path (CUDA events on the current stream)\n");
+    print(&s.root, 0);
+    printf("\n");
+}
+
+inline void write_json(std::ostream& os, const call_path * path, size_t depth)
+{
+    const work total = path->inclusive_work();
+    const std::vector<const call_path *> children = sorted_children(path);
+    const int indent = int(2 * depth + 2);
+
+    os << std::string(indent, ' ') << "{\"name\": ";
+    write_json_string(os, path->name, short_name_length(path->name));
+    os << ", \"signature\": ";
+    write_json_string(os, path->name, int(strlen(path->name)));
+    os << ",\n" << std::string(indent, ' ')
+       << " \"calls\": " << path->calls
+       << ", \"device_ms\": " << path->milliseconds
+       << ", \"self_ms\": " << self_milliseconds(path)
+       << ", \"bytes\": " << total.bytes
+       << ", \"flops\": " << total.flops
+       << ", \"gbytes_per_second\": " << gbytes_per_second(total, path->milliseconds)
+       << ", \"gflops_per_second\": " << gflops_per_second(total, path->milliseconds)
+       << ",\n" << std::string(indent, ' ') << " \"children\": [";
+
+    for (size_t i = 0; i < children.size(); i++)
+    {
+        os << (i == 0 ? "\n" : ",\n");
+        write_json(os, children[i], depth + 1);
+    }
+
+    os << (children.empty() ? "]}" : "\n" + std::string(indent, ' ') + " ]}");
+}
+
+// aggregated call paths as a JSON tree.  bytes and flops include the paths
+// below, and the rates divide them by the inclusive device time.
+inline void write_json(std::ostream& os)
+{
+    profiler_state& s = resolved_state();
+
+    os << "{\n  \"call_paths\":\n";
+    write_json(os, &s.root, 0);
+    os << "\n}\n";
+}
+
+inline void write_csv(std::ostream& os, const call_path * path, const std::string& prefix, size_t depth)
+{
+    const work total = path->inclusive_work();
+
+    std::string name = prefix;
+    name.append(path->name, short_name_length(path->name));
+
+    write_csv_field(os, name.c_str(), int(name.size()));
+    os << "," << depth
+       << "," << path->calls
+       << "," << path->milliseconds
+       << "," << self_milliseconds(path)
+       << "," << total.bytes
+       << "," << total.flops
+       << "," << gbytes_per_second(total, path->milliseconds)
+       << "," << gflops_per_second(total, path->milliseconds)
+       << ",";
+    write_csv_field(os, path->name, int(strlen(path->name)));
+    os << "\n";
+
+    const std::vector<const call_path *> children = sorted_children(path);
+    for (size_t i = 0; i < children.size(); i++)
+        write_csv(os, children[i], name + " > ", depth + 1);
+}
+
+// aggregated call paths as CSV, one row per path
+inline void write_csv(std::ostream& os)
+{
+    profiler_state& s = resolved_state();
+
+    os << "path,depth,calls,device_ms,self_ms,bytes,flops,gbytes_per_second,gflops_per_second,signature\n";
+    write_csv(os, &s.root, std::string(), 0);
+}
+
+// the scopes recorded since set_tracing(true) in the Chrome trace event
+// format, with their bytes and flops as arguments
+inline void write_chrome_trace(std::ostream& os)
+{
+    profiler_state& s = resolved_state();
+
+    os << "{\"traceEvents\": [";
+
+    for (size_t i = 0; i < s.trace.size(); i++)
+    {
+        const trace_event& event = s.trace[i];
+
+        os << (i == 0 ? "\n" : ",\n");
+        os << "  {\"name\": ";
+        write_json_string(os, event.path->name, short_name_length(event.path->name));
+        os << ", \"cat\": \"cusp\", \"ph\": \"X\", \"pid\": 0, \"tid\": 0"
+           << ", \"ts\": " << 1000.0 * event.start
+           << ", \"dur\": " << 1000.0 * event.duration
+           << ", \"args\": {\"bytes\": " << event.work.bytes
+           << ", \"flops\": " << event.work.flops
+           << ", \"gbytes_per_second\": " << gbytes_per_second(event.work, event.duration)
+           << ", \"gflops_per_second\": " << gflops_per_second(event.work, event.duration)
+           << "}}";
+    }
+
+    os << "\n ],\n \"displayTimeUnit\": \"ms\",\n \"otherData\": {\"dropped_events\": "
+       << s.dropped_trace_events << "}}\n";
+}
+
+inline void clear(call_path * path)
+{
+    path->calls = 0;
+    path->milliseconds = 0.0;
+    path->work = work();
+
+    for (size_t i = 0; i < path->children.size(); i++)
+        clear(path->children[i]);
+}
+
+// discard the collected times and trace events
+inline void reset(void)
+{
+    profiler_state& s = state();
+
+    s.resolve();
+    clear(&s.root);
+
+    s.trace.clear();
+    s.dropped_trace_events = 0;
+}
+
+struct scoped
+{
+    scoped(const char * name) { enter(name); }
+    ~scoped(void) { exit(); }
+};
+
+} // end namespace device_profiler
+} // end namespace detail
+} // end namespace cusp
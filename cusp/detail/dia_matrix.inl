@@ -78,6 +78,34 @@ make_dia_matrix_view(const dia_matrix_view<Array1,Array2,IndexType,ValueType,Mem
   return dia_matrix_view<Array1,Array2,IndexType,ValueType,MemorySpace>(m);
 }
     
+template <typename IndexType, typename ValueType, class MemorySpace>
+dia_matrix_view<typename cusp::detail::raw_array1d_view<IndexType,MemorySpace>::type,
+                array2d_view<typename cusp::detail::raw_array1d_view<ValueType,MemorySpace>::type, cusp::column_major>,
+                typename cusp::detail::raw_array1d_view<IndexType,MemorySpace>::value_type,
+                typename cusp::detail::raw_array1d_view<ValueType,MemorySpace>::value_type,
+                MemorySpace>
+make_dia_matrix_view(size_t num_rows,
+                     size_t num_cols,
+                     size_t num_entries,
+                     size_t num_diagonals,
+                     size_t pitch,
+                     IndexType * diagonal_offsets,
+                     ValueType * values,
+                     MemorySpace)
+{
+  typedef cusp::detail::raw_array1d_view<IndexType,MemorySpace> IndexView;
+  typedef cusp::detail::raw_array1d_view<ValueType,MemorySpace> ValueView;
+
+  return dia_matrix_view<typename IndexView::type,
+                         array2d_view<typename ValueView::type, cusp::column_major>,
+                         typename IndexView::value_type,
+                         typename ValueView::value_type,
+                         MemorySpace>
+    (num_rows, num_cols, num_entries,
+     IndexView::make(diagonal_offsets, num_diagonals),
+     cusp::make_array2d_view(num_rows, num_diagonals, pitch, values, cusp::column_major(), MemorySpace()));
+}
+
 template <typename IndexType, typename ValueType, class MemorySpace>
 typename dia_matrix<IndexType,ValueType,MemorySpace>::view
 make_dia_matrix_view(dia_matrix<IndexType,ValueType,MemorySpace>& m)
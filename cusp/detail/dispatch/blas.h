@@ -0,0 +1,221 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include <cusp/memory.h>
+
+#include <cusp/detail/host/blas.h>
+#include <cusp/detail/device/blas.h>
+
+#include <thrust/detail/type_traits.h>
+
+namespace cusp
+{
+
+struct row_major;
+
+namespace detail
+{
+namespace dispatch
+{
+
+// strides between consecutive rows and columns of an array2d
+template <typename Matrix>
+int row_stride(const Matrix& A)
+{
+    return thrust::detail::is_same<typename Matrix::orientation, cusp::row_major>::value ? int(A.pitch) : 1;
+}
+
+template <typename Matrix>
+int column_stride(const Matrix& A)
+{
+    return thrust::detail::is_same<typename Matrix::orientation, cusp::row_major>::value ? 1 : int(A.pitch);
+}
+
+////////////////
+// Host Paths //
+////////////////
+template <typename Matrix,
+          typename Array1,
+          typename Array2,
+          typename ValueType>
+void gemv(const Matrix& A,
+          const Array1& x,
+                Array2& y,
+          const ValueType alpha,
+          const ValueType beta,
+          cusp::host_memory,
+          cusp::host_memory,
+          cusp::host_memory)
+{
+    cusp::detail::host::gemv(int(A.num_rows), int(A.num_cols), alpha,
+                             &A.values[0], row_stride(A), column_stride(A),
+                             x, beta, y);
+}
+
+template <typename OutputType,
+          typename Array1,
+          typename Array2,
+          typename BinaryFunction>
+OutputType reproducible_sum(const Array1& x,
+                            const Array2& y,
+                            BinaryFunction op,
+                            cusp::host_memory,
+                            cusp::host_memory)
+{
+    return cusp::detail::host::reproducible_sum<OutputType>(x.size(), x.begin(), y.begin(), op);
+}
+
+template <bool Conjugate,
+          typename Array1,
+          typename Matrix,
+          typename Array2>
+void mdot(const Array1& x,
+          const Matrix& Y,
+                Array2& result,
+          cusp::host_memory,
+          cusp::host_memory)
+{
+    cusp::detail::host::mdot<Conjugate>(int(Y.num_rows), int(Y.num_cols), x,
+                                        &Y.values[0], row_stride(Y), column_stride(Y),
+                                        result);
+}
+
+template <typename Matrix1,
+          typename Matrix2,
+          typename Matrix3,
+          typename ValueType>
+void gemm(const Matrix1& A,
+          const Matrix2& B,
+                Matrix3& C,
+          const ValueType alpha,
+          const ValueType beta,
+          cusp::host_memory,
+          cusp::host_memory,
+          cusp::host_memory)
+{
+    cusp::detail::host::gemm(int(A.num_rows), int(B.num_cols), int(A.num_cols), alpha,
+                             &A.values[0], row_stride(A), column_stride(A),
+                             &B.values[0], row_stride(B), column_stride(B),
+                             beta,
+                             &C.values[0], row_stride(C), column_stride(C));
+}
+
+template <typename Matrix1,
+          typename Matrix2>
+void trsm(const Matrix1& A,
+                Matrix2& B,
+          const bool lower,
+          const bool unit_diagonal,
+          cusp::host_memory,
+          cusp::host_memory)
+{
+    cusp::detail::host::trsm(int(A.num_rows), int(B.num_cols), lower, unit_diagonal,
+                             &A.values[0], row_stride(A), column_stride(A),
+                             &B.values[0], row_stride(B), column_stride(B));
+}
+
+//////////////////
+// Device Paths //
+//////////////////
+template <typename Matrix,
+          typename Array1,
+          typename Array2,
+          typename ValueType>
+void gemv(const Matrix& A,
+          const Array1& x,
+                Array2& y,
+          const ValueType alpha,
+          const ValueType beta,
+          cusp::device_memory,
+          cusp::device_memory,
+          cusp::device_memory)
+{
+    cusp::detail::device::gemv(int(A.num_rows), int(A.num_cols), alpha,
+                               thrust::raw_pointer_cast(&A.values[0]), row_stride(A), column_stride(A),
+                               thrust::raw_pointer_cast(&x[0]),
+                               beta,
+                               thrust::raw_pointer_cast(&y[0]));
+}
+
+template <typename OutputType,
+          typename Array1,
+          typename Array2,
+          typename BinaryFunction>
+OutputType reproducible_sum(const Array1& x,
+                            const Array2& y,
+                            BinaryFunction op,
+                            cusp::device_memory,
+                            cusp::device_memory)
+{
+    return cusp::detail::device::reproducible_sum<OutputType>(x.size(), x.begin(), y.begin(), op);
+}
+
+template <bool Conjugate,
+          typename Array1,
+          typename Matrix,
+          typename Array2>
+void mdot(const Array1& x,
+          const Matrix& Y,
+                Array2& result,
+          cusp::device_memory,
+          cusp::device_memory)
+{
+    cusp::detail::device::mdot<Conjugate>(int(Y.num_rows), int(Y.num_cols),
+                                          thrust::raw_pointer_cast(&x[0]),
+                                          thrust::raw_pointer_cast(&Y.values[0]), row_stride(Y), column_stride(Y),
+                                          thrust::raw_pointer_cast(&result[0]));
+}
+
+template <typename Matrix1,
+          typename Matrix2,
+          typename Matrix3,
+          typename ValueType>
+void gemm(const Matrix1& A,
+          const Matrix2& B,
+                Matrix3& C,
+          const ValueType alpha,
+          const ValueType beta,
+          cusp::device_memory,
+          cusp::device_memory,
+          cusp::device_memory)
+{
+    cusp::detail::device::gemm(int(A.num_rows), int(B.num_cols), int(A.num_cols), alpha,
+                               thrust::raw_pointer_cast(&A.values[0]), row_stride(A), column_stride(A),
+                               thrust::raw_pointer_cast(&B.values[0]), row_stride(B), column_stride(B),
+                               beta,
+                               thrust::raw_pointer_cast(&C.values[0]), row_stride(C), column_stride(C));
+}
+
+template <typename Matrix1,
+          typename Matrix2>
+void trsm(const Matrix1& A,
+                Matrix2& B,
+          const bool lower,
+          const bool unit_diagonal,
+          cusp::device_memory,
+          cusp::device_memory)
+{
+    cusp::detail::device::trsm(int(A.num_rows), int(B.num_cols), lower, unit_diagonal,
+                               thrust::raw_pointer_cast(&A.values[0]), row_stride(A), column_stride(A),
+                               thrust::raw_pointer_cast(&B.values[0]), row_stride(B), column_stride(B));
+}
+
+} // end namespace dispatch
+} // end namespace detail
+} // end namespace cusp
+
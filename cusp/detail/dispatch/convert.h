@@ -77,6 +77,27 @@ void convert(const SourceType& src, DestinationType& dst, cusp::device_memory, c
     cusp::detail::device::convert(src, dst);
 }
 
+//////////////////////////
+// Paths with Workspace //
+//////////////////////////
+
+// only conversions between device matrices use the workspace
+template <typename SourceType, typename DestinationType, typename Workspace,
+          typename MemorySpace1, typename MemorySpace2>
+void convert(const SourceType& src, DestinationType& dst, Workspace& workspace,
+             MemorySpace1, MemorySpace2)
+{
+    cusp::detail::dispatch::convert(src, dst, MemorySpace1(), MemorySpace2());
+}
+
+template <typename SourceType, typename DestinationType>
+void convert(const SourceType& src, DestinationType& dst,
+             cusp::convert_workspace<cusp::device_memory>& workspace,
+             cusp::device_memory, cusp::device_memory)
+{
+    cusp::detail::device::convert(src, dst, workspace);
+}
+
 } // end namespace dispatch
 } // end namespace detail
 } // end namespace cusp
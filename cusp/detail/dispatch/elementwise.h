@@ -74,6 +74,23 @@ void subtract(const Matrix1& A,
     cusp::detail::host::transform_elementwise(A, B, C, thrust::minus<ValueType>());
 }
 
+template <typename ScalarType,
+          typename Matrix1,
+          typename Matrix2,
+          typename Matrix3>
+void add(const ScalarType alpha,
+         const Matrix1& A,
+         const ScalarType beta,
+         const Matrix2& B,
+               Matrix3& C,
+         const bool reuse_pattern,
+         cusp::host_memory,
+         cusp::host_memory,
+         cusp::host_memory)
+{
+    cusp::detail::host::add(alpha, A, beta, B, C, reuse_pattern);
+}
+
 //////////////////
 // Device Paths //
 //////////////////
@@ -118,6 +135,23 @@ void subtract(const Matrix1& A,
     cusp::detail::device::subtract(A, B, C);
 }
 
+template <typename ScalarType,
+          typename Matrix1,
+          typename Matrix2,
+          typename Matrix3>
+void add(const ScalarType alpha,
+         const Matrix1& A,
+         const ScalarType beta,
+         const Matrix2& B,
+               Matrix3& C,
+         const bool reuse_pattern,
+         cusp::device_memory,
+         cusp::device_memory,
+         cusp::device_memory)
+{
+    cusp::detail::device::add(alpha, A, beta, B, C, reuse_pattern);
+}
+
 } // end namespace dispatch
 } // end namespace detail
 } // end namespace cusp
@@ -18,6 +18,12 @@
 
 #include <cusp/detail/host/multiply.h>
 #include <cusp/detail/device/multiply.h>
+#include <cusp/detail/device/generalized_multiply.h>
+#include <cusp/detail/device/multiply_dot.h>
+
+#ifdef INTEL_MKL_SPBLAS
+#include <cusp/detail/host/mkl.h>
+#endif
 
 namespace cusp
 {
@@ -39,6 +45,11 @@ void multiply(const LinearOperator&  A,
               cusp::host_memory,
               cusp::host_memory)
 {
+#ifdef INTEL_MKL_SPBLAS
+    if (cusp::detail::host::mkl::multiply(A, B, C))
+        return;
+#endif
+
     cusp::detail::host::multiply(A, B, C);
 }
 
@@ -58,6 +69,218 @@ void multiply(const LinearOperator&  A,
     cusp::detail::device::multiply(A, B, C);
 }
 
+//////////////////////////////////////
+// Transposed Matrix-Vector Product //
+//////////////////////////////////////
+template <typename Matrix,
+          typename Vector1,
+          typename Vector2>
+void multiply_transpose(const Matrix&  A,
+                        const Vector1& x,
+                              Vector2& y,
+                        cusp::host_memory,
+                        cusp::host_memory,
+                        cusp::host_memory)
+{
+    cusp::detail::host::multiply_transpose(A, x, y);
+}
+
+template <typename Matrix,
+          typename Vector1,
+          typename Vector2>
+void multiply_transpose(const Matrix&  A,
+                        const Vector1& x,
+                              Vector2& y,
+                        cusp::device_memory,
+                        cusp::device_memory,
+                        cusp::device_memory)
+{
+    cusp::detail::device::multiply_transpose(A, x, y);
+}
+
+//////////////////////////////////////
+// Generalized Matrix-Vector Product //
+//////////////////////////////////////
+template <typename Matrix,
+          typename Vector1,
+          typename Vector2,
+          typename UnaryFunction,
+          typename BinaryFunction1,
+          typename BinaryFunction2>
+void generalized_multiply(const Matrix&  A,
+                          const Vector1& x,
+                                Vector2& y,
+                          UnaryFunction   initialize,
+                          BinaryFunction1 combine,
+                          BinaryFunction2 reduce,
+                          cusp::host_memory,
+                          cusp::host_memory,
+                          cusp::host_memory)
+{
+    cusp::detail::host::generalized_multiply(A, x, y, initialize, combine, reduce,
+                                             typename Matrix::format());
+}
+
+template <typename Matrix,
+          typename Vector1,
+          typename Vector2,
+          typename UnaryFunction,
+          typename BinaryFunction1,
+          typename BinaryFunction2>
+void generalized_multiply(const Matrix&  A,
+                          const Vector1& x,
+                                Vector2& y,
+                          UnaryFunction   initialize,
+                          BinaryFunction1 combine,
+                          BinaryFunction2 reduce,
+                          cusp::device_memory,
+                          cusp::device_memory,
+                          cusp::device_memory)
+{
+    cusp::detail::device::generalized_multiply(A, x, y, initialize, combine, reduce);
+}
+
+////////////////////////////////////
+// Matrix-Vector Product with dotc //
+////////////////////////////////////
+template <typename Matrix,
+          typename Vector1,
+          typename Vector2>
+typename Vector2::value_type
+multiply_dot(const Matrix&  A,
+             const Vector1& x,
+                   Vector2& y,
+             cusp::device_memory,
+             cusp::device_memory,
+             cusp::device_memory)
+{
+    return cusp::detail::device::multiply_dot(A, x, y);
+}
+
+template <typename Matrix,
+          typename Vector1,
+          typename Vector2,
+          typename Vector3,
+          typename UnaryFunction,
+          typename BinaryFunction1,
+          typename BinaryFunction2>
+void masked_multiply(const Matrix&  A,
+                     const Vector1& x,
+                     const Vector2& mask,
+                           Vector3& y,
+                     UnaryFunction   initialize,
+                     BinaryFunction1 combine,
+                     BinaryFunction2 reduce,
+                     cusp::host_memory,
+                     cusp::host_memory,
+                     cusp::host_memory,
+                     cusp::host_memory)
+{
+    cusp::detail::host::masked_multiply(A, x, mask, y, initialize, combine, reduce,
+                                        typename Matrix::format());
+}
+
+template <typename Matrix,
+          typename Vector1,
+          typename Vector2,
+          typename Vector3,
+          typename UnaryFunction,
+          typename BinaryFunction1,
+          typename BinaryFunction2>
+void masked_multiply(const Matrix&  A,
+                     const Vector1& x,
+                     const Vector2& mask,
+                           Vector3& y,
+                     UnaryFunction   initialize,
+                     BinaryFunction1 combine,
+                     BinaryFunction2 reduce,
+                     cusp::device_memory,
+                     cusp::device_memory,
+                     cusp::device_memory,
+                     cusp::device_memory)
+{
+    cusp::detail::device::masked_multiply(A, x, mask, y, initialize, combine, reduce,
+                                          typename Matrix::format());
+}
+
+//////////////////////
+// Galerkin Product //
+//////////////////////
+template <typename Matrix1,
+          typename Matrix2,
+          typename Matrix3,
+          typename Matrix4>
+void galerkin_product(const Matrix1& R,
+                      const Matrix2& A,
+                      const Matrix3& P,
+                            Matrix4& RAP,
+                      cusp::host_memory,
+                      cusp::host_memory,
+                      cusp::host_memory,
+                      cusp::host_memory)
+{
+#ifdef INTEL_MKL_SPBLAS
+    // RAP = R * (A * P) with the MKL SpGEMM where it applies
+    cusp::csr_matrix<typename Matrix4::index_type,typename Matrix4::value_type,cusp::host_memory> AP;
+
+    cusp::detail::dispatch::multiply(A, P, AP, cusp::host_memory(), cusp::host_memory(), cusp::host_memory());
+    cusp::detail::dispatch::multiply(R, AP, RAP, cusp::host_memory(), cusp::host_memory(), cusp::host_memory());
+#else
+    cusp::detail::host::galerkin_product(R, A, P, RAP);
+#endif
+}
+
+template <typename Matrix1,
+          typename Matrix2,
+          typename Matrix3,
+          typename Matrix4>
+void galerkin_product(const Matrix1& R,
+                      const Matrix2& A,
+                      const Matrix3& P,
+                            Matrix4& RAP,
+                      cusp::device_memory,
+                      cusp::device_memory,
+                      cusp::device_memory,
+                      cusp::device_memory)
+{
+    cusp::detail::device::galerkin_product(R, A, P, RAP);
+}
+
+///////////////////////////
+// Masked Sparse Product //
+///////////////////////////
+template <typename Matrix1,
+          typename Matrix2,
+          typename Matrix3,
+          typename Matrix4>
+void masked_product(const Matrix1& A,
+                    const Matrix2& B,
+                    const Matrix3& M,
+                          Matrix4& C,
+                    cusp::host_memory,
+                    cusp::host_memory,
+                    cusp::host_memory,
+                    cusp::host_memory)
+{
+    cusp::detail::host::masked_product(A, B, M, C);
+}
+
+template <typename Matrix1,
+          typename Matrix2,
+          typename Matrix3,
+          typename Matrix4>
+void masked_product(const Matrix1& A,
+                    const Matrix2& B,
+                    const Matrix3& M,
+                          Matrix4& C,
+                    cusp::device_memory,
+                    cusp::device_memory,
+                    cusp::device_memory,
+                    cusp::device_memory)
+{
+    cusp::detail::device::masked_product(A, B, M, C);
+}
+
 } // end namespace dispatch
 } // end namespace detail
 } // end namespace cusp
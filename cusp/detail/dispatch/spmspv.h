@@ -0,0 +1,78 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+#pragma once
+
+#include <cusp/detail/host/spmspv.h>
+#include <cusp/detail/device/spmspv.h>
+
+namespace cusp
+{
+namespace detail
+{
+namespace dispatch
+{
+
+////////////////
+// Host Paths //
+////////////////
+template <typename Matrix, typename SparseVector1, typename Array, typename SparseVector2,
+          typename BinaryFunction1, typename BinaryFunction2>
+void spmspv_push(const Matrix& C, size_t num_rows,
+                 const SparseVector1& x, const Array* mask, SparseVector2& y,
+                 BinaryFunction1 combine, BinaryFunction2 reduce,
+                 cusp::host_memory, cusp::host_memory, cusp::host_memory)
+{
+    cusp::detail::host::spmspv_push(C, num_rows, x, mask, y, combine, reduce);
+}
+
+template <typename Matrix, typename SparseVector1, typename Array, typename SparseVector2,
+          typename BinaryFunction1, typename BinaryFunction2>
+void spmspv_pull(const Matrix& A,
+                 const SparseVector1& x, const Array* mask, SparseVector2& y,
+                 BinaryFunction1 combine, BinaryFunction2 reduce,
+                 cusp::host_memory, cusp::host_memory, cusp::host_memory)
+{
+    cusp::detail::host::spmspv_pull(A, x, mask, y, combine, reduce);
+}
+
+//////////////////
+// Device Paths //
+//////////////////
+template <typename Matrix, typename SparseVector1, typename Array, typename SparseVector2,
+          typename BinaryFunction1, typename BinaryFunction2>
+void spmspv_push(const Matrix& C, size_t num_rows,
+                 const SparseVector1& x, const Array* mask, SparseVector2& y,
+                 BinaryFunction1 combine, BinaryFunction2 reduce,
+                 cusp::device_memory, cusp::device_memory, cusp::device_memory)
+{
+    cusp::detail::device::spmspv_push(C, num_rows, x, mask, y, combine, reduce);
+}
+
+template <typename Matrix, typename SparseVector1, typename Array, typename SparseVector2,
+          typename BinaryFunction1, typename BinaryFunction2>
+void spmspv_pull(const Matrix& A,
+                 const SparseVector1& x, const Array* mask, SparseVector2& y,
+                 BinaryFunction1 combine, BinaryFunction2 reduce,
+                 cusp::device_memory, cusp::device_memory, cusp::device_memory)
+{
+    cusp::detail::device::spmspv_pull(A, x, mask, y, combine, reduce);
+}
+
+} // end namespace dispatch
+} // end namespace detail
+} // end namespace cusp
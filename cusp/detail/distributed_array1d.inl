@@ -0,0 +1,233 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+#include <cusp/exception.h>
+#include <cusp/detail/device/utils.h>
+
+#include <thrust/copy.h>
+#include <thrust/fill.h>
+
+#include <algorithm>
+
+namespace cusp
+{
+
+////////////////////////
+// distributed_layout //
+////////////////////////
+inline distributed_layout
+::distributed_layout(size_t N, const std::vector<int>& devices)
+  : devices(devices), offsets(devices.size() + 1)
+{
+    const size_t num_parts = devices.size();
+
+    if (num_parts == 0)
+        throw cusp::invalid_input_exception("distributed_layout requires at least one device");
+
+    offsets[0] = 0;
+
+    for (size_t p = 0; p < num_parts; p++)
+        offsets[p + 1] = offsets[p] + N / num_parts + (p < N % num_parts ? 1 : 0);
+}
+
+inline size_t distributed_layout
+::owner(size_t i) const
+{
+    return std::upper_bound(offsets.begin(), offsets.end(), i) - offsets.begin() - 1;
+}
+
+/////////////////////////
+// distributed_array1d //
+/////////////////////////
+template <typename ValueType>
+distributed_array1d<ValueType>
+::distributed_array1d(const cusp::distributed_layout& layout)
+{
+    resize(layout);
+}
+
+template <typename ValueType>
+distributed_array1d<ValueType>
+::distributed_array1d(const cusp::distributed_layout& layout, const ValueType& value)
+{
+    resize(layout);
+
+    for (size_t p = 0; p < num_parts(); p++)
+    {
+        cusp::detail::device::device_scope scope(layout.devices[p]);
+        thrust::fill(parts[p].begin(), parts[p].end(), value);
+    }
+}
+
+template <typename ValueType>
+template <typename Array>
+distributed_array1d<ValueType>
+::distributed_array1d(const cusp::distributed_layout& layout, const Array& x)
+{
+    resize(layout);
+    scatter(x);
+}
+
+template <typename ValueType>
+distributed_array1d<ValueType>
+::distributed_array1d(const distributed_array1d& x)
+{
+    resize(x.layout);
+
+    for (size_t p = 0; p < num_parts(); p++)
+    {
+        cusp::detail::device::device_scope scope(layout.devices[p]);
+        thrust::copy(x.parts[p].begin(), x.parts[p].end(), parts[p].begin());
+    }
+}
+
+template <typename ValueType>
+distributed_array1d<ValueType>
+::~distributed_array1d(void)
+{
+    // free the storage of each part on its own device
+    for (size_t p = 0; p < parts.size(); p++)
+    {
+        cusp::detail::device::device_scope scope(layout.devices[p]);
+        local_array_type().swap(parts[p]);
+    }
+}
+
+template <typename ValueType>
+distributed_array1d<ValueType>&
+distributed_array1d<ValueType>
+::operator=(const distributed_array1d& x)
+{
+    if (this != &x)
+    {
+        if (layout != x.layout)
+            resize(x.layout);
+
+        for (size_t p = 0; p < num_parts(); p++)
+        {
+            cusp::detail::device::device_scope scope(layout.devices[p]);
+            thrust::copy(x.parts[p].begin(), x.parts[p].end(), parts[p].begin());
+        }
+    }
+
+    return *this;
+}
+
+template <typename ValueType>
+void distributed_array1d<ValueType>
+::resize(const cusp::distributed_layout& new_layout)
+{
+    for (size_t p = 0; p < parts.size(); p++)
+    {
+        cusp::detail::device::device_scope scope(layout.devices[p]);
+        local_array_type().swap(parts[p]);
+    }
+
+    layout = new_layout;
+
+    // the parts are empty while the vector is resized, so no
+    // device storage is copied
+    parts.clear();
+    parts.resize(layout.num_parts());
+
+    for (size_t p = 0; p < num_parts(); p++)
+    {
+        cusp::detail::device::device_scope scope(layout.devices[p]);
+        parts[p].resize(layout.part_size(p));
+    }
+}
+
+template <typename ValueType>
+template <typename Array>
+void distributed_array1d<ValueType>
+::scatter(const Array& x)
+{
+    if (x.size() != size())
+        throw cusp::invalid_input_exception("array has the wrong size for the distributed layout");
+
+    // stage on the host so that no part is copied between devices
+    cusp::array1d<ValueType,cusp::host_memory> x_host(x.begin(), x.end());
+
+    for (size_t p = 0; p < num_parts(); p++)
+    {
+        cusp::detail::device::device_scope scope(layout.devices[p]);
+        thrust::copy(x_host.begin() + layout.offsets[p],
+                     x_host.begin() + layout.offsets[p + 1],
+                     parts[p].begin());
+    }
+}
+
+template <typename ValueType>
+template <typename Array>
+void distributed_array1d<ValueType>
+::gather(Array& x) const
+{
+    cusp::array1d<ValueType,cusp::host_memory> x_host(size());
+
+    for (size_t p = 0; p < num_parts(); p++)
+    {
+        cusp::detail::device::device_scope scope(layout.devices[p]);
+        thrust::copy(parts[p].begin(), parts[p].end(),
+                     x_host.begin() + layout.offsets[p]);
+    }
+
+    x.resize(size());
+    thrust::copy(x_host.begin(), x_host.end(), x.begin());
+}
+
+template <typename ValueType>
+void distributed_array1d<ValueType>
+::redistribute(const distributed_array1d& x)
+{
+    if (x.size() != size())
+        throw cusp::invalid_input_exception("distributed arrays have different sizes");
+
+    for (size_t p = 0; p < x.num_parts(); p++)
+    {
+        const size_t begin = x.layout.offsets[p];
+        const size_t end   = x.layout.offsets[p + 1];
+
+        if (begin == end)
+            continue;
+
+        // the parts of this array which overlap part p of x
+        for (size_t q = layout.owner(begin); q < num_parts() && layout.offsets[q] < end; q++)
+        {
+            const size_t first = std::max(begin, layout.offsets[q]);
+            const size_t last  = std::min(end,   layout.offsets[q + 1]);
+
+            if (first >= last)
+                continue;
+
+            cudaMemcpyPeer(thrust::raw_pointer_cast(&parts[q][0]) + (first - layout.offsets[q]),
+                           layout.devices[q],
+                           thrust::raw_pointer_cast(&x.parts[p][0]) + (first - begin),
+                           x.layout.devices[p],
+                           (last - first) * sizeof(ValueType));
+        }
+    }
+}
+
+template <typename ValueType>
+void distributed_array1d<ValueType>
+::swap(distributed_array1d& x)
+{
+    std::swap(layout, x.layout);
+    parts.swap(x.parts);
+}
+
+} // end namespace cusp
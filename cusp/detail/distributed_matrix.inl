@@ -0,0 +1,345 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include <cusp/csr_matrix.h>
+#include <cusp/exception.h>
+#include <cusp/multiply.h>
+
+#include <cusp/detail/stream.h>
+#include <cusp/detail/device/utils.h>
+#include <cusp/detail/device/spmv/coo_flat.h>
+
+#include <thrust/copy.h>
+#include <thrust/iterator/permutation_iterator.h>
+
+#include <algorithm>
+
+namespace cusp
+{
+
+//////////////////
+// Constructors //
+//////////////////
+
+template <typename LocalMatrix>
+template <typename MatrixType>
+distributed_matrix<LocalMatrix>
+::distributed_matrix(const MatrixType& matrix, const std::vector<int>& devices)
+  : Parent(matrix.num_rows, matrix.num_cols, matrix.num_entries)
+{
+    cusp::distributed_layout uniform_layout(matrix.num_rows, devices);
+
+    initialize(matrix, uniform_layout, uniform_layout);
+}
+
+template <typename LocalMatrix>
+template <typename MatrixType>
+distributed_matrix<LocalMatrix>
+::distributed_matrix(const MatrixType& matrix, const cusp::distributed_layout& layout)
+  : Parent(matrix.num_rows, matrix.num_cols, matrix.num_entries)
+{
+    initialize(matrix, layout, layout);
+}
+
+template <typename LocalMatrix>
+template <typename MatrixType>
+distributed_matrix<LocalMatrix>
+::distributed_matrix(const MatrixType& matrix,
+                     const cusp::distributed_layout& layout,
+                     const cusp::distributed_layout& column_layout)
+  : Parent(matrix.num_rows, matrix.num_cols, matrix.num_entries)
+{
+    initialize(matrix, layout, column_layout);
+}
+
+template <typename LocalMatrix>
+distributed_matrix<LocalMatrix>
+::~distributed_matrix(void)
+{
+    release();
+}
+
+//////////////////////
+// Member Functions //
+//////////////////////
+
+template <typename LocalMatrix>
+template <typename MatrixType>
+void distributed_matrix<LocalMatrix>
+::initialize(const MatrixType& matrix,
+             const cusp::distributed_layout& new_layout,
+             const cusp::distributed_layout& new_column_layout)
+{
+    if (new_layout.size() != matrix.num_rows || new_column_layout.size() != matrix.num_cols)
+        throw cusp::invalid_input_exception("distributed layout does not match the matrix dimensions");
+
+    if (new_layout.devices != new_column_layout.devices)
+        throw cusp::invalid_input_exception("row and column layouts must place their parts on the same devices");
+
+    cusp::csr_matrix<IndexType,ValueType,cusp::host_memory> A(matrix);
+
+    layout        = new_layout;
+    column_layout = new_column_layout;
+
+    const size_t num_parts = layout.num_parts();
+
+    parts.resize(num_parts);
+
+    // local rows of each part which are sent to other parts
+    std::vector< std::vector<IndexType> > send_lists(num_parts);
+
+    for (size_t p = 0; p < num_parts; p++)
+    {
+        const IndexType row_begin = layout.offsets[p];
+        const IndexType row_end   = layout.offsets[p + 1];
+        const IndexType num_rows  = row_end - row_begin;
+
+        const IndexType column_begin = column_layout.offsets[p];
+        const IndexType column_end   = column_layout.offsets[p + 1];
+        const IndexType num_columns  = column_end - column_begin;
+
+        // columns owned by other parts
+        std::vector<IndexType> halo_columns;
+
+        size_t num_interior_entries = 0;
+
+        for (IndexType jj = A.row_offsets[row_begin]; jj < A.row_offsets[row_end]; jj++)
+        {
+            const IndexType j = A.column_indices[jj];
+
+            if (j < column_begin || j >= column_end)
+                halo_columns.push_back(j);
+            else
+                num_interior_entries++;
+        }
+
+        const size_t num_boundary_entries = halo_columns.size();
+
+        std::sort(halo_columns.begin(), halo_columns.end());
+        halo_columns.erase(std::unique(halo_columns.begin(), halo_columns.end()), halo_columns.end());
+
+        cusp::coo_matrix<IndexType,ValueType,cusp::host_memory> interior(num_rows, num_columns, num_interior_entries);
+        cusp::coo_matrix<IndexType,ValueType,cusp::host_memory> boundary(num_rows, halo_columns.size(), num_boundary_entries);
+
+        size_t n_interior = 0;
+        size_t n_boundary = 0;
+
+        for (IndexType i = row_begin; i < row_end; i++)
+        {
+            for (IndexType jj = A.row_offsets[i]; jj < A.row_offsets[i + 1]; jj++)
+            {
+                const IndexType j = A.column_indices[jj];
+
+                if (j < column_begin || j >= column_end)
+                {
+                    boundary.row_indices[n_boundary]    = i - row_begin;
+                    boundary.column_indices[n_boundary] = std::lower_bound(halo_columns.begin(), halo_columns.end(), j) - halo_columns.begin();
+                    boundary.values[n_boundary]         = A.values[jj];
+                    n_boundary++;
+                }
+                else
+                {
+                    interior.row_indices[n_interior]    = i - row_begin;
+                    interior.column_indices[n_interior] = j - column_begin;
+                    interior.values[n_interior]         = A.values[jj];
+                    n_interior++;
+                }
+            }
+        }
+
+        // the halo columns are sorted, so the columns of each owner are contiguous
+        for (size_t k = 0; k < halo_columns.size();)
+        {
+            const size_t q = column_layout.owner(halo_columns[k]);
+
+            size_t end = k;
+            while (end < halo_columns.size() && size_t(halo_columns[end]) < column_layout.offsets[q + 1])
+                end++;
+
+            message m;
+            m.part        = p;
+            m.send_offset = send_lists[q].size();
+            m.recv_offset = k;
+            m.size        = end - k;
+
+            for (size_t n = k; n < end; n++)
+                send_lists[q].push_back(halo_columns[n] - column_layout.offsets[q]);
+
+            parts[q].messages.push_back(m);
+            parts[p].sources.push_back(q);
+
+            k = end;
+        }
+
+        cusp::detail::device::device_scope scope(layout.devices[p]);
+
+        parts[p].interior = interior;
+        parts[p].boundary = boundary;
+        parts[p].halo.resize(halo_columns.size());
+    }
+
+    for (size_t p = 0; p < num_parts; p++)
+    {
+        cusp::detail::device::device_scope scope(layout.devices[p]);
+
+        part_type& part = parts[p];
+
+        part.send_indices.resize(send_lists[p].size());
+        part.send_buffer.resize(send_lists[p].size());
+        thrust::copy(send_lists[p].begin(), send_lists[p].end(), part.send_indices.begin());
+
+        cudaStreamCreate(&part.compute_stream);
+        cudaStreamCreate(&part.halo_stream);
+        cudaEventCreateWithFlags(&part.halo_sent, cudaEventDisableTiming);
+        cudaEventCreateWithFlags(&part.finished,  cudaEventDisableTiming);
+    }
+
+    // enable peer-to-peer copies between the devices of the layout
+    std::vector<int> devices(layout.devices);
+    std::sort(devices.begin(), devices.end());
+    devices.erase(std::unique(devices.begin(), devices.end()), devices.end());
+
+    for (size_t d = 0; d < devices.size(); d++)
+    {
+        cusp::detail::device::device_scope scope(devices[d]);
+
+        for (size_t e = 0; e < devices.size(); e++)
+        {
+            int can_access = 0;
+
+            if (d != e && cudaDeviceCanAccessPeer(&can_access, devices[d], devices[e]) == cudaSuccess && can_access)
+            {
+                // access may already have been enabled by another matrix
+                if (cudaDeviceEnablePeerAccess(devices[e], 0) != cudaSuccess)
+                    cudaGetLastError();
+            }
+        }
+    }
+}
+
+template <typename LocalMatrix>
+void distributed_matrix<LocalMatrix>
+::release(void)
+{
+    for (size_t p = 0; p < parts.size(); p++)
+    {
+        cusp::detail::device::device_scope scope(layout.devices[p]);
+
+        part_type& part = parts[p];
+
+        if (part.compute_stream) cudaStreamDestroy(part.compute_stream);
+        if (part.halo_stream)    cudaStreamDestroy(part.halo_stream);
+        if (part.halo_sent)      cudaEventDestroy(part.halo_sent);
+        if (part.finished)       cudaEventDestroy(part.finished);
+
+        // free the storage on the device of the part
+        local_matrix_type().swap(part.interior);
+        boundary_matrix_type().swap(part.boundary);
+        cusp::array1d<ValueType,cusp::device_memory>().swap(part.halo);
+        cusp::array1d<IndexType,cusp::device_memory>().swap(part.send_indices);
+        cusp::array1d<ValueType,cusp::device_memory>().swap(part.send_buffer);
+    }
+
+    parts.clear();
+}
+
+template <typename LocalMatrix>
+size_t distributed_matrix<LocalMatrix>
+::num_halo_entries(void) const
+{
+    size_t num_entries = 0;
+
+    for (size_t p = 0; p < parts.size(); p++)
+        num_entries += parts[p].halo.size();
+
+    return num_entries;
+}
+
+template <typename LocalMatrix>
+void distributed_matrix<LocalMatrix>
+::operator()(const cusp::distributed_array1d<ValueType>& x,
+                   cusp::distributed_array1d<ValueType>& y) const
+{
+    CUSP_PROFILE_SCOPED();
+
+    if (x.layout != column_layout || y.layout != layout)
+        throw cusp::invalid_input_exception("distributed array layouts do not match the matrix");
+
+    const size_t num_parts = parts.size();
+
+    // gather the halo entries and send them to the other parts
+    for (size_t q = 0; q < num_parts; q++)
+    {
+        const part_type& part = parts[q];
+
+        if (part.messages.empty())
+            continue;
+
+        cusp::detail::device::device_scope scope(layout.devices[q], part.halo_stream);
+
+        // the receivers may still read their halo in the previous product
+        for (size_t k = 0; k < part.messages.size(); k++)
+            cudaStreamWaitEvent(part.halo_stream, parts[part.messages[k].part].finished, 0);
+
+        cusp::detail::stream::copy(thrust::make_permutation_iterator(x.parts[q].begin(), part.send_indices.begin()),
+                                   thrust::make_permutation_iterator(x.parts[q].begin(), part.send_indices.end()),
+                                   part.send_buffer.begin());
+
+        for (size_t k = 0; k < part.messages.size(); k++)
+        {
+            const message& m = part.messages[k];
+
+            cudaMemcpyPeerAsync(thrust::raw_pointer_cast(&parts[m.part].halo[0]) + m.recv_offset,
+                                layout.devices[m.part],
+                                thrust::raw_pointer_cast(&part.send_buffer[0]) + m.send_offset,
+                                layout.devices[q],
+                                m.size * sizeof(ValueType),
+                                part.halo_stream);
+        }
+
+        cudaEventRecord(part.halo_sent, part.halo_stream);
+    }
+
+    // multiply the interior blocks while the halo entries are in flight
+    for (size_t p = 0; p < num_parts; p++)
+    {
+        if (layout.part_size(p) == 0)
+            continue;
+
+        cusp::detail::device::device_scope scope(layout.devices[p], parts[p].compute_stream);
+        cusp::multiply(parts[p].interior, x.parts[p], y.parts[p]);
+    }
+
+    // add the products of the boundary blocks once the halo has arrived
+    for (size_t p = 0; p < num_parts; p++)
+    {
+        const part_type& part = parts[p];
+
+        cusp::detail::device::device_scope scope(layout.devices[p], part.compute_stream);
+
+        for (size_t k = 0; k < part.sources.size(); k++)
+            cudaStreamWaitEvent(part.compute_stream, parts[part.sources[k]].halo_sent, 0);
+
+        if (part.boundary.num_entries > 0)
+            cusp::detail::device::__spmv_coo_flat<false, false>(part.boundary,
+                                                                thrust::raw_pointer_cast(&part.halo[0]),
+                                                                thrust::raw_pointer_cast(&y.parts[p][0]));
+
+        cudaEventRecord(part.finished, part.compute_stream);
+    }
+}
+
+} // end namespace cusp
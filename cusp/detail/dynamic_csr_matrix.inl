@@ -0,0 +1,575 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include <cusp/convert.h>
+#include <cusp/exception.h>
+#include <cusp/detail/format_utils.h>
+#include <cusp/detail/stream.h>
+
+#include <thrust/copy.h>
+#include <thrust/count.h>
+#include <thrust/functional.h>
+#include <thrust/reduce.h>
+#include <thrust/scan.h>
+#include <thrust/sort.h>
+#include <thrust/transform.h>
+#include <thrust/iterator/counting_iterator.h>
+#include <thrust/iterator/zip_iterator.h>
+
+namespace cusp
+{
+namespace detail
+{
+
+template <typename Array>
+typename Array::value_type * dynamic_csr_pointer(Array& a)
+{
+    return a.size() == 0 ? NULL : thrust::raw_pointer_cast(&a[0]);
+}
+
+template <typename Array>
+const typename Array::value_type * dynamic_csr_pointer(const Array& a)
+{
+    return a.size() == 0 ? NULL : thrust::raw_pointer_cast(&a[0]);
+}
+
+template <typename IndexType>
+struct dynamic_csr_out_of_range
+{
+    IndexType num_rows, num_cols;
+
+    dynamic_csr_out_of_range(const IndexType num_rows, const IndexType num_cols)
+        : num_rows(num_rows), num_cols(num_cols) {}
+
+    template <typename Tuple>
+    __host__ __device__
+    bool operator()(const Tuple& t) const
+    {
+        const IndexType i = thrust::get<0>(t);
+        const IndexType j = thrust::get<1>(t);
+
+        return i < IndexType(0) || i >= num_rows || j < IndexType(0) || j >= num_cols;
+    }
+};
+
+// slots of row i after a reallocation for lengths[i] entries
+template <typename IndexType>
+struct dynamic_csr_row_capacity
+{
+    const IndexType * Ap;
+    const IndexType * lengths;
+    IndexType slack;
+    bool all_rows;
+
+    dynamic_csr_row_capacity(const IndexType * Ap, const IndexType * lengths, const IndexType slack, const bool all_rows)
+        : Ap(Ap), lengths(lengths), slack(slack), all_rows(all_rows) {}
+
+    __host__ __device__
+    IndexType operator()(const IndexType i) const
+    {
+        const IndexType capacity = Ap[i + 1] - Ap[i];
+
+        return (all_rows || lengths[i] > capacity) ? lengths[i] + slack : capacity;
+    }
+};
+
+template <typename IndexType>
+struct dynamic_csr_row_overflows
+{
+    const IndexType * Ap;
+    const IndexType * lengths;
+
+    dynamic_csr_row_overflows(const IndexType * Ap, const IndexType * lengths)
+        : Ap(Ap), lengths(lengths) {}
+
+    __host__ __device__
+    bool operator()(const IndexType i) const
+    {
+        return lengths[i] > Ap[i + 1] - Ap[i];
+    }
+};
+
+template <typename IndexType, typename ValueType>
+struct dynamic_csr_copy_row
+{
+    const IndexType * Ap;
+    const IndexType * lengths;
+    const IndexType * Aj;
+    const ValueType * Ax;
+    const IndexType * Bp;
+    IndexType * Bj;
+    ValueType * Bx;
+
+    dynamic_csr_copy_row(const IndexType * Ap, const IndexType * lengths, const IndexType * Aj, const ValueType * Ax,
+                         const IndexType * Bp, IndexType * Bj, ValueType * Bx)
+        : Ap(Ap), lengths(lengths), Aj(Aj), Ax(Ax), Bp(Bp), Bj(Bj), Bx(Bx) {}
+
+    __host__ __device__
+    void operator()(const IndexType i) const
+    {
+        const IndexType a = Ap[i];
+        const IndexType b = Bp[i];
+
+        for(IndexType n = 0; n < lengths[i]; n++)
+        {
+            Bj[b + n] = Aj[a + n];
+            Bx[b + n] = Ax[a + n];
+        }
+    }
+};
+
+// length of row i once the sorted batch columns [Bp[i], Bp[i+1]) are merged in
+template <typename IndexType>
+struct dynamic_csr_insert_count
+{
+    const IndexType * Ap;
+    const IndexType * lengths;
+    const IndexType * Aj;
+    const IndexType * Bp;
+    const IndexType * Bj;
+    IndexType * new_lengths;
+
+    dynamic_csr_insert_count(const IndexType * Ap, const IndexType * lengths, const IndexType * Aj,
+                             const IndexType * Bp, const IndexType * Bj, IndexType * new_lengths)
+        : Ap(Ap), lengths(lengths), Aj(Aj), Bp(Bp), Bj(Bj), new_lengths(new_lengths) {}
+
+    __host__ __device__
+    void operator()(const IndexType i) const
+    {
+        IndexType a = Ap[i];
+        IndexType b = Bp[i];
+
+        const IndexType a_end = a + lengths[i];
+        const IndexType b_end = Bp[i + 1];
+
+        IndexType n = lengths[i];
+
+        while(b < b_end)
+        {
+            if(a < a_end && Aj[a] < Bj[b])
+            {
+                a++;
+            }
+            else
+            {
+                if(a == a_end || Bj[b] < Aj[a])
+                    n++;
+                else
+                    a++;
+
+                b++;
+            }
+        }
+
+        new_lengths[i] = n;
+    }
+};
+
+// merges the batch into row i from the back, so that no entry is
+// overwritten before it has moved
+template <typename IndexType, typename ValueType>
+struct dynamic_csr_insert_row
+{
+    const IndexType * Ap;
+    const IndexType * new_lengths;
+    const IndexType * Bp;
+    const IndexType * Bj;
+    const ValueType * Bx;
+    IndexType * lengths;
+    IndexType * Aj;
+    ValueType * Ax;
+
+    dynamic_csr_insert_row(const IndexType * Ap, const IndexType * new_lengths,
+                           const IndexType * Bp, const IndexType * Bj, const ValueType * Bx,
+                           IndexType * lengths, IndexType * Aj, ValueType * Ax)
+        : Ap(Ap), new_lengths(new_lengths), Bp(Bp), Bj(Bj), Bx(Bx), lengths(lengths), Aj(Aj), Ax(Ax) {}
+
+    __host__ __device__
+    void operator()(const IndexType i) const
+    {
+        const IndexType a_begin = Ap[i];
+        const IndexType b_begin = Bp[i];
+
+        IndexType a = a_begin + lengths[i];
+        IndexType b = Bp[i + 1];
+        IndexType k = a_begin + new_lengths[i];
+
+        while(b > b_begin)
+        {
+            k--;
+
+            if(a > a_begin && Aj[a - 1] > Bj[b - 1])
+            {
+                a--;
+                Aj[k] = Aj[a];
+                Ax[k] = Ax[a];
+            }
+            else
+            {
+                if(a > a_begin && Aj[a - 1] == Bj[b - 1])
+                    a--;
+
+                b--;
+                Aj[k] = Bj[b];
+                Ax[k] = Bx[b];
+            }
+        }
+
+        lengths[i] = new_lengths[i];
+    }
+};
+
+template <typename IndexType, typename ValueType>
+struct dynamic_csr_erase_row
+{
+    const IndexType * Ap;
+    const IndexType * Bp;
+    const IndexType * Bj;
+    IndexType * lengths;
+    IndexType * Aj;
+    ValueType * Ax;
+
+    dynamic_csr_erase_row(const IndexType * Ap, const IndexType * Bp, const IndexType * Bj,
+                          IndexType * lengths, IndexType * Aj, ValueType * Ax)
+        : Ap(Ap), Bp(Bp), Bj(Bj), lengths(lengths), Aj(Aj), Ax(Ax) {}
+
+    __host__ __device__
+    void operator()(const IndexType i) const
+    {
+        IndexType b = Bp[i];
+
+        const IndexType b_end = Bp[i + 1];
+
+        if(b == b_end)
+            return;
+
+        const IndexType a_begin = Ap[i];
+        const IndexType a_end   = a_begin + lengths[i];
+
+        IndexType k = a_begin;
+
+        for(IndexType a = a_begin; a < a_end; a++)
+        {
+            while(b < b_end && Bj[b] < Aj[a])
+                b++;
+
+            if(b < b_end && Bj[b] == Aj[a])
+                continue;
+
+            Aj[k] = Aj[a];
+            Ax[k] = Ax[a];
+            k++;
+        }
+
+        lengths[i] = k - a_begin;
+    }
+};
+
+template <typename IndexType, typename ValueType>
+struct dynamic_csr_spmv_row
+{
+    const IndexType * Ap;
+    const IndexType * lengths;
+    const IndexType * Aj;
+    const ValueType * Ax;
+    const ValueType * x;
+    ValueType * y;
+
+    dynamic_csr_spmv_row(const IndexType * Ap, const IndexType * lengths, const IndexType * Aj, const ValueType * Ax,
+                         const ValueType * x, ValueType * y)
+        : Ap(Ap), lengths(lengths), Aj(Aj), Ax(Ax), x(x), y(y) {}
+
+    __host__ __device__
+    void operator()(const IndexType i) const
+    {
+        const IndexType a_begin = Ap[i];
+        const IndexType a_end   = a_begin + lengths[i];
+
+        ValueType sum = ValueType(0);
+
+        for(IndexType a = a_begin; a < a_end; a++)
+            sum += Ax[a] * x[Aj[a]];
+
+        y[i] = sum;
+    }
+};
+
+template <typename IndexType, typename MemorySpace, typename Array1, typename Array2>
+void dynamic_csr_batch(const size_t num_rows, const size_t num_cols,
+                       const Array1& rows, const Array2& cols,
+                       cusp::array1d<IndexType,MemorySpace>& I,
+                       cusp::array1d<IndexType,MemorySpace>& J)
+{
+    if(rows.size() != cols.size())
+        throw cusp::invalid_input_exception("batch arrays must have the same size");
+
+    I = rows;
+    J = cols;
+
+    if(thrust::count_if(thrust::make_zip_iterator(thrust::make_tuple(I.begin(), J.begin())),
+                        thrust::make_zip_iterator(thrust::make_tuple(I.end(),   J.end())),
+                        dynamic_csr_out_of_range<IndexType>(num_rows, num_cols)) > 0)
+        throw cusp::invalid_input_exception("batch index out of range");
+}
+
+} // end namespace detail
+
+
+template <typename IndexType, typename ValueType, class MemorySpace>
+template <typename MatrixType>
+dynamic_csr_matrix<IndexType,ValueType,MemorySpace>
+  ::dynamic_csr_matrix(const MatrixType& matrix, const size_t slack)
+    : Parent(matrix.num_rows, matrix.num_cols), slack(slack)
+{
+    container A(matrix);
+
+    this->num_entries = A.num_entries;
+
+    row_lengths.resize(A.num_rows);
+    thrust::transform(A.row_offsets.begin() + 1, A.row_offsets.end(), A.row_offsets.begin(),
+                      row_lengths.begin(), thrust::minus<IndexType>());
+
+    row_offsets.swap(A.row_offsets);
+    column_indices.swap(A.column_indices);
+    values.swap(A.values);
+
+    reserve(slack);
+}
+
+template <typename IndexType, typename ValueType, class MemorySpace>
+void dynamic_csr_matrix<IndexType,ValueType,MemorySpace>
+  ::reserve(const size_t slack)
+{
+    this->slack = slack;
+
+    reallocate(row_lengths, true);
+}
+
+template <typename IndexType, typename ValueType, class MemorySpace>
+template <typename ArrayType>
+void dynamic_csr_matrix<IndexType,ValueType,MemorySpace>
+  ::reallocate(const ArrayType& lengths, const bool all_rows)
+{
+    typedef thrust::counting_iterator<IndexType,MemorySpace> CountingIterator;
+
+    const size_t N = this->num_rows;
+
+    cusp::array1d<IndexType,MemorySpace> offsets(N + 1);
+
+    thrust::transform(CountingIterator(0), CountingIterator(N), offsets.begin(),
+                      cusp::detail::dynamic_csr_row_capacity<IndexType>(thrust::raw_pointer_cast(&row_offsets[0]),
+                                                                        cusp::detail::dynamic_csr_pointer(lengths),
+                                                                        IndexType(slack), all_rows));
+    offsets[N] = 0;
+    thrust::exclusive_scan(offsets.begin(), offsets.end(), offsets.begin());
+
+    cusp::array1d<IndexType,MemorySpace> new_column_indices(offsets[N]);
+    cusp::array1d<ValueType,MemorySpace> new_values(offsets[N]);
+
+    cusp::detail::stream::for_each(CountingIterator(0), CountingIterator(N),
+                                   cusp::detail::dynamic_csr_copy_row<IndexType,ValueType>
+                                       (thrust::raw_pointer_cast(&row_offsets[0]),
+                                        cusp::detail::dynamic_csr_pointer(row_lengths),
+                                        cusp::detail::dynamic_csr_pointer(column_indices),
+                                        cusp::detail::dynamic_csr_pointer(values),
+                                        thrust::raw_pointer_cast(&offsets[0]),
+                                        cusp::detail::dynamic_csr_pointer(new_column_indices),
+                                        cusp::detail::dynamic_csr_pointer(new_values)));
+
+    row_offsets.swap(offsets);
+    column_indices.swap(new_column_indices);
+    values.swap(new_values);
+}
+
+template <typename IndexType, typename ValueType, class MemorySpace>
+template <typename Array1, typename Array2, typename Array3>
+size_t dynamic_csr_matrix<IndexType,ValueType,MemorySpace>
+  ::insert(const Array1& rows, const Array2& cols, const Array3& vals)
+{
+    CUSP_PROFILE_SCOPED();
+
+    typedef thrust::counting_iterator<IndexType,MemorySpace> CountingIterator;
+
+    const size_t N = this->num_rows;
+
+    if(rows.size() != vals.size())
+        throw cusp::invalid_input_exception("batch arrays must have the same size");
+
+    if(rows.size() == 0)
+        return 0;
+
+    cusp::array1d<IndexType,MemorySpace> I;
+    cusp::array1d<IndexType,MemorySpace> J;
+    cusp::detail::dynamic_csr_batch(this->num_rows, this->num_cols, rows, cols, I, J);
+
+    cusp::array1d<ValueType,MemorySpace> V(vals);
+
+    // sum the duplicates of the batch
+    cusp::detail::sort_by_row_and_column(I, J, V);
+
+    cusp::array1d<IndexType,MemorySpace> Bi(I.size());
+    cusp::array1d<IndexType,MemorySpace> Bj(I.size());
+    cusp::array1d<ValueType,MemorySpace> Bx(I.size());
+
+    const size_t batch_size =
+        thrust::reduce_by_key(thrust::make_zip_iterator(thrust::make_tuple(I.begin(), J.begin())),
+                              thrust::make_zip_iterator(thrust::make_tuple(I.end(),   J.end())),
+                              V.begin(),
+                              thrust::make_zip_iterator(thrust::make_tuple(Bi.begin(), Bj.begin())),
+                              Bx.begin()).second - Bx.begin();
+    Bi.resize(batch_size);
+    Bj.resize(batch_size);
+    Bx.resize(batch_size);
+
+    cusp::array1d<IndexType,MemorySpace> Bp(N + 1);
+    cusp::detail::indices_to_offsets(Bi, Bp);
+
+    cusp::array1d<IndexType,MemorySpace> new_lengths(N);
+
+    cusp::detail::stream::for_each(CountingIterator(0), CountingIterator(N),
+                                   cusp::detail::dynamic_csr_insert_count<IndexType>
+                                       (thrust::raw_pointer_cast(&row_offsets[0]),
+                                        thrust::raw_pointer_cast(&row_lengths[0]),
+                                        cusp::detail::dynamic_csr_pointer(column_indices),
+                                        thrust::raw_pointer_cast(&Bp[0]),
+                                        thrust::raw_pointer_cast(&Bj[0]),
+                                        thrust::raw_pointer_cast(&new_lengths[0])));
+
+    // only a batch which overflows a row moves the storage
+    if(thrust::count_if(CountingIterator(0), CountingIterator(N),
+                        cusp::detail::dynamic_csr_row_overflows<IndexType>(thrust::raw_pointer_cast(&row_offsets[0]),
+                                                                           thrust::raw_pointer_cast(&new_lengths[0]))) > 0)
+        reallocate(new_lengths, false);
+
+    cusp::detail::stream::for_each(CountingIterator(0), CountingIterator(N),
+                                   cusp::detail::dynamic_csr_insert_row<IndexType,ValueType>
+                                       (thrust::raw_pointer_cast(&row_offsets[0]),
+                                        thrust::raw_pointer_cast(&new_lengths[0]),
+                                        thrust::raw_pointer_cast(&Bp[0]),
+                                        thrust::raw_pointer_cast(&Bj[0]),
+                                        thrust::raw_pointer_cast(&Bx[0]),
+                                        thrust::raw_pointer_cast(&row_lengths[0]),
+                                        cusp::detail::dynamic_csr_pointer(column_indices),
+                                        cusp::detail::dynamic_csr_pointer(values)));
+
+    const size_t num_entries = this->num_entries;
+
+    this->num_entries = thrust::reduce(row_lengths.begin(), row_lengths.end(), IndexType(0));
+
+    return this->num_entries - num_entries;
+}
+
+template <typename IndexType, typename ValueType, class MemorySpace>
+template <typename Array1, typename Array2>
+size_t dynamic_csr_matrix<IndexType,ValueType,MemorySpace>
+  ::erase(const Array1& rows, const Array2& cols)
+{
+    CUSP_PROFILE_SCOPED();
+
+    typedef thrust::counting_iterator<IndexType,MemorySpace> CountingIterator;
+
+    const size_t N = this->num_rows;
+
+    if(rows.size() == 0 || this->num_entries == 0)
+        return 0;
+
+    cusp::array1d<IndexType,MemorySpace> I;
+    cusp::array1d<IndexType,MemorySpace> J;
+    cusp::detail::dynamic_csr_batch(this->num_rows, this->num_cols, rows, cols, I, J);
+
+    thrust::sort(thrust::make_zip_iterator(thrust::make_tuple(I.begin(), J.begin())),
+                 thrust::make_zip_iterator(thrust::make_tuple(I.end(),   J.end())));
+
+    cusp::array1d<IndexType,MemorySpace> Bp(N + 1);
+    cusp::detail::indices_to_offsets(I, Bp);
+
+    cusp::detail::stream::for_each(CountingIterator(0), CountingIterator(N),
+                                   cusp::detail::dynamic_csr_erase_row<IndexType,ValueType>
+                                       (thrust::raw_pointer_cast(&row_offsets[0]),
+                                        thrust::raw_pointer_cast(&Bp[0]),
+                                        thrust::raw_pointer_cast(&J[0]),
+                                        thrust::raw_pointer_cast(&row_lengths[0]),
+                                        cusp::detail::dynamic_csr_pointer(column_indices),
+                                        cusp::detail::dynamic_csr_pointer(values)));
+
+    const size_t num_entries = this->num_entries;
+
+    this->num_entries = thrust::reduce(row_lengths.begin(), row_lengths.end(), IndexType(0));
+
+    return num_entries - this->num_entries;
+}
+
+template <typename IndexType, typename ValueType, class MemorySpace>
+void dynamic_csr_matrix<IndexType,ValueType,MemorySpace>
+  ::compact(container& matrix) const
+{
+    CUSP_PROFILE_SCOPED();
+
+    typedef thrust::counting_iterator<IndexType,MemorySpace> CountingIterator;
+
+    const size_t N = this->num_rows;
+
+    matrix.resize(N, this->num_cols, this->num_entries);
+
+    thrust::copy(row_lengths.begin(), row_lengths.end(), matrix.row_offsets.begin());
+    matrix.row_offsets[N] = 0;
+    thrust::exclusive_scan(matrix.row_offsets.begin(), matrix.row_offsets.end(), matrix.row_offsets.begin());
+
+    cusp::detail::stream::for_each(CountingIterator(0), CountingIterator(N),
+                                   cusp::detail::dynamic_csr_copy_row<IndexType,ValueType>
+                                       (thrust::raw_pointer_cast(&row_offsets[0]),
+                                        cusp::detail::dynamic_csr_pointer(row_lengths),
+                                        cusp::detail::dynamic_csr_pointer(column_indices),
+                                        cusp::detail::dynamic_csr_pointer(values),
+                                        thrust::raw_pointer_cast(&matrix.row_offsets[0]),
+                                        cusp::detail::dynamic_csr_pointer(matrix.column_indices),
+                                        cusp::detail::dynamic_csr_pointer(matrix.values)));
+}
+
+template <typename IndexType, typename ValueType, class MemorySpace>
+template <typename MatrixType>
+void dynamic_csr_matrix<IndexType,ValueType,MemorySpace>
+  ::compact(MatrixType& matrix) const
+{
+    container A;
+    compact(A);
+
+    cusp::convert(A, matrix);
+}
+
+template <typename IndexType, typename ValueType, class MemorySpace>
+template <typename VectorType1, typename VectorType2>
+void dynamic_csr_matrix<IndexType,ValueType,MemorySpace>
+  ::operator()(const VectorType1& x, VectorType2& y) const
+{
+    CUSP_PROFILE_SCOPED();
+
+    typedef thrust::counting_iterator<IndexType,MemorySpace> CountingIterator;
+
+    if(x.size() != this->num_cols || y.size() != this->num_rows)
+        throw cusp::invalid_input_exception("array dimensions do not match the matrix");
+
+    cusp::detail::stream::for_each(CountingIterator(0), CountingIterator(this->num_rows),
+                                   cusp::detail::dynamic_csr_spmv_row<IndexType,ValueType>
+                                       (thrust::raw_pointer_cast(&row_offsets[0]),
+                                        cusp::detail::dynamic_csr_pointer(row_lengths),
+                                        cusp::detail::dynamic_csr_pointer(column_indices),
+                                        cusp::detail::dynamic_csr_pointer(values),
+                                        cusp::detail::dynamic_csr_pointer(x),
+                                        cusp::detail::dynamic_csr_pointer(y)));
+}
+
+} // end namespace cusp
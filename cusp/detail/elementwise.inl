@@ -14,10 +14,290 @@
  *  limitations under the License.
  */
 
+#include <cusp/array1d.h>
+#include <cusp/conversion_cache.h>
+#include <cusp/convert.h>
+#include <cusp/coo_matrix.h>
+#include <cusp/copy.h>
+#include <cusp/csr_matrix.h>
+#include <cusp/exception.h>
+#include <cusp/format.h>
+#include <cusp/detail/format_utils.h>
+#include <cusp/detail/stream.h>
+
 #include <cusp/detail/dispatch/elementwise.h>
 
+#include <thrust/functional.h>
+#include <thrust/scan.h>
+#include <thrust/transform.h>
+#include <thrust/iterator/counting_iterator.h>
+
 namespace cusp
 {
+namespace detail
+{
+
+// merges the sorted columns of row i of A and B, counting the common
+// columns or, when Cj is set, writing their products into row i of C
+template <typename IndexType, typename ValueType1, typename ValueType2, typename ValueType3>
+struct hadamard_row
+{
+    const IndexType  * Ap;
+    const IndexType  * Aj;
+    const ValueType1 * Ax;
+    const IndexType  * Bp;
+    const IndexType  * Bj;
+    const ValueType2 * Bx;
+    const IndexType  * Cp;
+    IndexType  * Cj;
+    ValueType3 * Cx;
+    IndexType  * counts;
+
+    hadamard_row(const IndexType * Ap, const IndexType * Aj, const ValueType1 * Ax,
+                 const IndexType * Bp, const IndexType * Bj, const ValueType2 * Bx,
+                 const IndexType * Cp, IndexType * Cj, ValueType3 * Cx, IndexType * counts)
+        : Ap(Ap), Aj(Aj), Ax(Ax), Bp(Bp), Bj(Bj), Bx(Bx), Cp(Cp), Cj(Cj), Cx(Cx), counts(counts) {}
+
+    __host__ __device__
+    void operator()(const IndexType i) const
+    {
+        IndexType a = Ap[i];
+        IndexType b = Bp[i];
+
+        const IndexType a_end = Ap[i + 1];
+        const IndexType b_end = Bp[i + 1];
+
+        IndexType n = Cj == NULL ? 0 : Cp[i];
+
+        while(a < a_end && b < b_end)
+        {
+            const IndexType ja = Aj[a];
+            const IndexType jb = Bj[b];
+
+            if(ja < jb)
+            {
+                a++;
+            }
+            else if(jb < ja)
+            {
+                b++;
+            }
+            else
+            {
+                if(Cj != NULL)
+                {
+                    Cj[n] = ja;
+                    Cx[n] = ValueType3(Ax[a]) * ValueType3(Bx[b]);
+                }
+
+                n++;
+                a++;
+                b++;
+            }
+        }
+
+        if(Cj == NULL)
+            counts[i] = n;
+    }
+};
+
+// C = A .* B on row offsets, column indices and values sorted within rows
+template <typename OffsetArray1, typename IndexArray1, typename ValueArray1,
+          typename OffsetArray2, typename IndexArray2, typename ValueArray2,
+          typename MatrixType>
+void hadamard_rows(const size_t num_rows, const size_t num_cols,
+                   const OffsetArray1& Ap, const IndexArray1& Aj, const ValueArray1& Ax,
+                   const OffsetArray2& Bp, const IndexArray2& Bj, const ValueArray2& Bx,
+                   MatrixType& C, cusp::array1d<typename MatrixType::index_type,typename MatrixType::memory_space>& Cp)
+{
+    typedef typename MatrixType::index_type   IndexType;
+    typedef typename MatrixType::value_type   ValueType;
+    typedef typename MatrixType::memory_space MemorySpace;
+    typedef typename ValueArray1::value_type  ValueType1;
+    typedef typename ValueArray2::value_type  ValueType2;
+
+    typedef thrust::counting_iterator<IndexType,MemorySpace> CountingIterator;
+
+    Cp.resize(num_rows + 1);
+
+    if(Aj.size() == 0 || Bj.size() == 0)
+    {
+        thrust::fill(Cp.begin(), Cp.end(), IndexType(0));
+        C.resize(num_rows, num_cols, 0);
+        return;
+    }
+
+    const IndexType  * Ap_ptr = thrust::raw_pointer_cast(&Ap[0]);
+    const IndexType  * Aj_ptr = thrust::raw_pointer_cast(&Aj[0]);
+    const ValueType1 * Ax_ptr = thrust::raw_pointer_cast(&Ax[0]);
+    const IndexType  * Bp_ptr = thrust::raw_pointer_cast(&Bp[0]);
+    const IndexType  * Bj_ptr = thrust::raw_pointer_cast(&Bj[0]);
+    const ValueType2 * Bx_ptr = thrust::raw_pointer_cast(&Bx[0]);
+
+    // symbolic pass
+    cusp::detail::stream::for_each(CountingIterator(0), CountingIterator(num_rows),
+                                   hadamard_row<IndexType,ValueType1,ValueType2,ValueType>
+                                       (Ap_ptr, Aj_ptr, Ax_ptr, Bp_ptr, Bj_ptr, Bx_ptr,
+                                        NULL, NULL, NULL, thrust::raw_pointer_cast(&Cp[0])));
+    Cp[num_rows] = 0;
+    thrust::exclusive_scan(Cp.begin(), Cp.end(), Cp.begin());
+
+    const size_t num_entries = Cp[num_rows];
+
+    C.resize(num_rows, num_cols, num_entries);
+
+    if(num_entries == 0)
+        return;
+
+    // numeric pass
+    cusp::detail::stream::for_each(CountingIterator(0), CountingIterator(num_rows),
+                                   hadamard_row<IndexType,ValueType1,ValueType2,ValueType>
+                                       (Ap_ptr, Aj_ptr, Ax_ptr, Bp_ptr, Bj_ptr, Bx_ptr,
+                                        thrust::raw_pointer_cast(&Cp[0]),
+                                        thrust::raw_pointer_cast(&C.column_indices[0]),
+                                        thrust::raw_pointer_cast(&C.values[0]), NULL));
+}
+
+template <typename Matrix1, typename Matrix2, typename Matrix3>
+void elementwise_multiply(const Matrix1& A, const Matrix2& B, Matrix3& C,
+                          cusp::csr_format, cusp::csr_format, cusp::csr_format)
+{
+    typedef typename Matrix3::index_type   IndexType;
+    typedef typename Matrix3::memory_space MemorySpace;
+
+    cusp::array1d<IndexType,MemorySpace> Cp;
+
+    cusp::detail::hadamard_rows(A.num_rows, A.num_cols,
+                                A.row_offsets, A.column_indices, A.values,
+                                B.row_offsets, B.column_indices, B.values, C, Cp);
+
+    thrust::copy(Cp.begin(), Cp.end(), C.row_offsets.begin());
+}
+
+template <typename Matrix1, typename Matrix2, typename Matrix3>
+void elementwise_multiply(const Matrix1& A, const Matrix2& B, Matrix3& C,
+                          cusp::coo_format, cusp::coo_format, cusp::coo_format)
+{
+    typedef typename Matrix3::index_type   IndexType;
+    typedef typename Matrix3::memory_space MemorySpace;
+
+    // row offsets of the entries sorted by row
+    cusp::array1d<IndexType,MemorySpace> Ap(A.num_rows + 1);
+    cusp::array1d<IndexType,MemorySpace> Bp(B.num_rows + 1);
+    cusp::detail::indices_to_offsets(A.row_indices, Ap);
+    cusp::detail::indices_to_offsets(B.row_indices, Bp);
+
+    cusp::array1d<IndexType,MemorySpace> Cp;
+
+    cusp::detail::hadamard_rows(A.num_rows, A.num_cols,
+                                Ap, A.column_indices, A.values,
+                                Bp, B.column_indices, B.values, C, Cp);
+
+    if(C.num_entries > 0)
+        cusp::detail::offsets_to_indices(Cp, C.row_indices);
+}
+
+template <typename Matrix1, typename Matrix2, typename Matrix3>
+void elementwise_multiply(const Matrix1& A, const Matrix2& B, Matrix3& C,
+                          cusp::array2d_format, cusp::array2d_format, cusp::array2d_format)
+{
+    typedef typename Matrix3::value_type ValueType;
+
+    // entries match one to one once both operands have the layout and pitch of C
+    Matrix3 A_(A);
+    Matrix3 B_(B);
+
+    if(A_.pitch != B_.pitch)
+    {
+        Matrix3 B_pitched(A_.num_rows, A_.num_cols, ValueType(0), A_.pitch);
+        cusp::copy(B_, B_pitched);
+        B_.swap(B_pitched);
+    }
+
+    C.resize(A_.num_rows, A_.num_cols, A_.pitch);
+
+    thrust::transform(A_.values.begin(), A_.values.end(), B_.values.begin(), C.values.begin(),
+                      thrust::multiplies<ValueType>());
+}
+
+// other formats are multiplied in CSR format
+template <typename Matrix1, typename Matrix2, typename Matrix3,
+          typename Format1, typename Format2, typename Format3>
+void elementwise_multiply(const Matrix1& A, const Matrix2& B, Matrix3& C,
+                          Format1, Format2, Format3)
+{
+    typedef typename Matrix1::index_type   IndexType1;
+    typedef typename Matrix2::index_type   IndexType2;
+    typedef typename Matrix3::index_type   IndexType3;
+    typedef typename Matrix1::value_type   ValueType1;
+    typedef typename Matrix2::value_type   ValueType2;
+    typedef typename Matrix3::value_type   ValueType3;
+    typedef typename Matrix3::memory_space MemorySpace;
+
+    cusp::csr_matrix<IndexType1,ValueType1,MemorySpace> A_temp;
+    const cusp::csr_matrix<IndexType1,ValueType1,MemorySpace>& A_ = cusp::detail::cached_conversion(A, A_temp);
+    cusp::csr_matrix<IndexType2,ValueType2,MemorySpace> B_temp;
+    const cusp::csr_matrix<IndexType2,ValueType2,MemorySpace>& B_ = cusp::detail::cached_conversion(B, B_temp);
+    cusp::csr_matrix<IndexType3,ValueType3,MemorySpace> C_;
+
+    cusp::detail::elementwise_multiply(A_, B_, C_, cusp::csr_format(), cusp::csr_format(), cusp::csr_format());
+
+    cusp::convert(C_, C);
+}
+
+template <typename Matrix, typename UnaryFunction>
+void transform_values(Matrix& A, UnaryFunction op, cusp::coo_format)
+{
+    thrust::transform(A.values.begin(), A.values.end(), A.values.begin(), op);
+}
+
+template <typename Matrix, typename UnaryFunction>
+void transform_values(Matrix& A, UnaryFunction op, cusp::csr_format)
+{
+    thrust::transform(A.values.begin(), A.values.end(), A.values.begin(), op);
+}
+
+template <typename Matrix, typename UnaryFunction>
+void transform_values(Matrix& A, UnaryFunction op, cusp::dia_format)
+{
+    thrust::transform(A.values.values.begin(), A.values.values.end(), A.values.values.begin(), op);
+}
+
+template <typename Matrix, typename UnaryFunction>
+void transform_values(Matrix& A, UnaryFunction op, cusp::ell_format)
+{
+    thrust::transform(A.values.values.begin(), A.values.values.end(), A.values.values.begin(), op);
+}
+
+template <typename Matrix, typename UnaryFunction>
+void transform_values(Matrix& A, UnaryFunction op, cusp::hyb_format)
+{
+    cusp::detail::transform_values(A.ell, op, cusp::ell_format());
+    cusp::detail::transform_values(A.coo, op, cusp::coo_format());
+}
+
+template <typename Matrix, typename UnaryFunction>
+void transform_values(Matrix& A, UnaryFunction op, cusp::array2d_format)
+{
+    thrust::transform(A.values.begin(), A.values.end(), A.values.begin(), op);
+}
+
+// other formats are transformed in COO format
+template <typename Matrix, typename UnaryFunction, typename Format>
+void transform_values(Matrix& A, UnaryFunction op, Format)
+{
+    typedef typename Matrix::index_type   IndexType;
+    typedef typename Matrix::value_type   ValueType;
+    typedef typename Matrix::memory_space MemorySpace;
+
+    cusp::coo_matrix<IndexType,ValueType,MemorySpace> C(A);
+    cusp::detail::transform_values(C, op, cusp::coo_format());
+
+    A = C;
+}
+
+} // end namespace detail
+
 
 //template <typename Matrix1,
 //          typename Matrix2,
@@ -73,5 +353,57 @@ void subtract(const Matrix1& A,
             typename Matrix3::memory_space());
 }
 
+template <typename ScalarType,
+          typename Matrix1,
+          typename Matrix2,
+          typename Matrix3>
+void add(const ScalarType alpha,
+         const Matrix1& A,
+         const ScalarType beta,
+         const Matrix2& B,
+               Matrix3& C,
+         const bool reuse_pattern)
+{
+    CUSP_PROFILE_SCOPED();
+
+    // TODO replace with cusp::detail::assert_same_dimensions(A,B);
+    if(A.num_rows != B.num_rows || A.num_cols != B.num_cols)
+        throw cusp::invalid_input_exception("array dimensions do not match");
+
+    cusp::detail::dispatch::add(alpha, A, beta, B, C, reuse_pattern,
+            typename Matrix1::memory_space(),
+            typename Matrix2::memory_space(),
+            typename Matrix3::memory_space());
+}
+
+template <typename Matrix1,
+          typename Matrix2,
+          typename Matrix3>
+void elementwise_multiply(const Matrix1& A,
+                          const Matrix2& B,
+                                Matrix3& C)
+{
+    CUSP_PROFILE_SCOPED();
+
+    // TODO replace with cusp::detail::assert_same_dimensions(A,B);
+    if(A.num_rows != B.num_rows || A.num_cols != B.num_cols)
+        throw cusp::invalid_input_exception("array dimensions do not match");
+
+    cusp::detail::elementwise_multiply(A, B, C,
+            typename Matrix1::format(),
+            typename Matrix2::format(),
+            typename Matrix3::format());
+}
+
+template <typename Matrix,
+          typename UnaryFunction>
+void transform_values(Matrix& A,
+                      UnaryFunction op)
+{
+    CUSP_PROFILE_SCOPED();
+
+    cusp::detail::transform_values(A, op, typename Matrix::format());
+}
+
 } // end namespace cusp
 
@@ -78,6 +78,34 @@ make_ell_matrix_view(const ell_matrix_view<Array1,Array2,IndexType,ValueType,Mem
   return ell_matrix_view<Array1,Array2,IndexType,ValueType,MemorySpace>(m);
 }
     
+template <typename IndexType, typename ValueType, class MemorySpace>
+ell_matrix_view<array2d_view<typename cusp::detail::raw_array1d_view<IndexType,MemorySpace>::type, cusp::column_major>,
+                array2d_view<typename cusp::detail::raw_array1d_view<ValueType,MemorySpace>::type, cusp::column_major>,
+                typename cusp::detail::raw_array1d_view<IndexType,MemorySpace>::value_type,
+                typename cusp::detail::raw_array1d_view<ValueType,MemorySpace>::value_type,
+                MemorySpace>
+make_ell_matrix_view(size_t num_rows,
+                     size_t num_cols,
+                     size_t num_entries,
+                     size_t num_entries_per_row,
+                     size_t pitch,
+                     IndexType * column_indices,
+                     ValueType * values,
+                     MemorySpace)
+{
+  typedef cusp::detail::raw_array1d_view<IndexType,MemorySpace> IndexView;
+  typedef cusp::detail::raw_array1d_view<ValueType,MemorySpace> ValueView;
+
+  return ell_matrix_view<array2d_view<typename IndexView::type, cusp::column_major>,
+                         array2d_view<typename ValueView::type, cusp::column_major>,
+                         typename IndexView::value_type,
+                         typename ValueView::value_type,
+                         MemorySpace>
+    (num_rows, num_cols, num_entries,
+     cusp::make_array2d_view(num_rows, num_entries_per_row, pitch, column_indices, cusp::column_major(), MemorySpace()),
+     cusp::make_array2d_view(num_rows, num_entries_per_row, pitch, values, cusp::column_major(), MemorySpace()));
+}
+
 template <typename IndexType, typename ValueType, class MemorySpace>
 typename ell_matrix<IndexType,ValueType,MemorySpace>::view
 make_ell_matrix_view(ell_matrix<IndexType,ValueType,MemorySpace>& m)
@@ -0,0 +1,170 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include <cusp/csr_matrix.h>
+#include <cusp/exception.h>
+#include <cusp/detail/format_utils.h>
+#include <cusp/detail/utils.h>
+
+#include <cusp/detail/device/spmv/ellr.h>
+
+#include <thrust/extrema.h>
+#include <thrust/functional.h>
+#include <thrust/scatter.h>
+#include <thrust/transform.h>
+#include <thrust/iterator/counting_iterator.h>
+
+namespace cusp
+{
+namespace detail
+{
+
+// position of the entry p in CSR order among the chunks
+template <typename IndexType>
+struct ellr_position
+{
+    const IndexType * row_offsets;
+    const IndexType * rows;
+    IndexType pitch;
+
+    ellr_position(const IndexType * row_offsets, const IndexType * rows, const IndexType pitch)
+        : row_offsets(row_offsets), rows(rows), pitch(pitch) {}
+
+    __host__ __device__
+    IndexType operator()(const IndexType p) const
+    {
+        const IndexType C = cusp::detail::device::ELLR_CHUNK_SIZE;
+
+        const IndexType i = rows[p];
+        const IndexType n = p - row_offsets[i];
+
+        return ((n / C) * pitch + i) * C + n % C;
+    }
+};
+
+template <typename Accumulation, typename Matrix, typename ValueType>
+void ellr_multiply(const Matrix& A, const ValueType * x, ValueType * y)
+{
+    typedef typename Matrix::index_type IndexType;
+    typedef typename Matrix::value_type MatrixValueType;
+
+    const IndexType * Aj = A.column_indices.empty() ? NULL : &A.column_indices[0];
+    const MatrixValueType * Ax = A.values.empty() ? NULL : &A.values[0];
+
+    for (size_t i = 0; i < A.num_rows; i++)
+        y[i] = cusp::detail::device::ellr_row<IndexType,ValueType,MatrixValueType,Accumulation>
+                   (IndexType(i), IndexType(A.pitch), &A.row_lengths[0], Aj, Ax, x);
+}
+
+template <typename Matrix, typename ValueType>
+void ellr_multiply(const Matrix& A, const ValueType * x, ValueType * y, cusp::host_memory)
+{
+    if (cusp::current_reduction_mode() == cusp::compensated_reduction)
+        ellr_multiply<compensated_accumulation>(A, x, y);
+    else
+        ellr_multiply<plain_accumulation>(A, x, y);
+}
+
+template <typename Matrix, typename ValueType>
+void ellr_multiply(const Matrix& A, const ValueType * x, ValueType * y, cusp::device_memory)
+{
+    cusp::detail::device::spmv_ellr(A, x, y);
+}
+
+} // end namespace detail
+
+template <typename IndexType, typename ValueType, typename MemorySpace>
+ellr_operator<IndexType,ValueType,MemorySpace>
+::ellr_operator(void)
+    : Parent(), pitch(0)
+{
+}
+
+template <typename IndexType, typename ValueType, typename MemorySpace>
+template <typename MatrixType>
+ellr_operator<IndexType,ValueType,MemorySpace>
+::ellr_operator(const MatrixType& A)
+    : Parent(), pitch(0)
+{
+    CUSP_PROFILE_SCOPED();
+
+    const IndexType C = cusp::detail::device::ELLR_CHUNK_SIZE;
+
+    cusp::csr_matrix<IndexType,ValueType,MemorySpace> B(A);
+
+    const IndexType num_rows    = B.num_rows;
+    const IndexType num_entries = B.num_entries;
+
+    this->resize(B.num_rows, B.num_cols, B.num_entries);
+
+    pitch = cusp::detail::round_up(size_t(num_rows), size_t(32));
+
+    row_lengths.resize(num_rows);
+    thrust::transform(B.row_offsets.begin() + 1, B.row_offsets.end(), B.row_offsets.begin(),
+                      row_lengths.begin(), thrust::minus<IndexType>());
+
+    if (num_entries == 0)
+        return;
+
+    const IndexType max_length = *thrust::max_element(row_lengths.begin(), row_lengths.end());
+    const IndexType num_chunks = (max_length + C - 1) / C;
+
+    column_indices.resize(num_chunks * pitch * C, IndexType(0));
+    values.resize(num_chunks * pitch * C, ValueType(0));
+
+    cusp::array1d<IndexType,MemorySpace> positions(num_entries);
+    cusp::detail::offsets_to_indices(B.row_offsets, positions);
+
+    thrust::transform(thrust::counting_iterator<IndexType>(0), thrust::counting_iterator<IndexType>(num_entries),
+                      positions.begin(),
+                      detail::ellr_position<IndexType>(thrust::raw_pointer_cast(&B.row_offsets[0]),
+                                                       thrust::raw_pointer_cast(&positions[0]),
+                                                       IndexType(pitch)));
+
+    thrust::scatter(B.column_indices.begin(), B.column_indices.end(), positions.begin(), column_indices.begin());
+    thrust::scatter(B.values.begin(), B.values.end(), positions.begin(), values.begin());
+}
+
+template <typename IndexType, typename ValueType, typename MemorySpace>
+template <typename MemorySpace2>
+ellr_operator<IndexType,ValueType,MemorySpace>
+::ellr_operator(const ellr_operator<IndexType,ValueType,MemorySpace2>& A)
+    : Parent(A.num_rows, A.num_cols, A.num_entries),
+      column_indices(A.column_indices), values(A.values),
+      row_lengths(A.row_lengths), pitch(A.pitch)
+{
+}
+
+template <typename IndexType, typename ValueType, typename MemorySpace>
+template <typename VectorType1, typename VectorType2>
+void ellr_operator<IndexType,ValueType,MemorySpace>
+::operator()(const VectorType1& x, VectorType2& y) const
+{
+    CUSP_PROFILE_SCOPED();
+
+    if (x.size() != size_t(this->num_cols) || y.size() != size_t(this->num_rows))
+        throw cusp::invalid_input_exception("array dimensions do not match the operator");
+
+    if (this->num_rows == 0)
+        return;
+
+    detail::ellr_multiply(*this,
+                          thrust::raw_pointer_cast(&x[0]),
+                          thrust::raw_pointer_cast(&y[0]),
+                          MemorySpace());
+}
+
+} // end namespace cusp
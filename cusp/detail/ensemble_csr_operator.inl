@@ -0,0 +1,245 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+#include <cusp/array2d.h>
+#include <cusp/csr_matrix.h>
+#include <cusp/exception.h>
+
+#include <cusp/detail/device/spmv/ensemble.h>
+
+#include <thrust/copy.h>
+#include <thrust/iterator/counting_iterator.h>
+#include <thrust/iterator/permutation_iterator.h>
+#include <thrust/iterator/transform_iterator.h>
+
+namespace cusp
+{
+namespace detail
+{
+
+// interleaved position k * num_members + e -> member position e * num_entries + k
+struct ensemble_member_position
+{
+    size_t num_members;
+    size_t num_entries;
+
+    ensemble_member_position(const size_t num_members, const size_t num_entries)
+        : num_members(num_members), num_entries(num_entries) {}
+
+    __host__ __device__
+    size_t operator()(const size_t idx) const
+    {
+        const size_t k = idx / num_members;
+        return (idx - k * num_members) * num_entries + k;
+    }
+};
+
+// entry k of member e -> interleaved position k * num_members + e
+struct ensemble_value_position
+{
+    size_t num_members;
+    size_t e;
+
+    ensemble_value_position(const size_t num_members, const size_t e)
+        : num_members(num_members), e(e) {}
+
+    __host__ __device__
+    size_t operator()(const size_t k) const
+    {
+        return k * num_members + e;
+    }
+};
+
+template <typename Array2d>
+void ensemble_check_vectors(const Array2d& X, const size_t num_rows, const size_t num_members, cusp::row_major)
+{
+    if (X.num_rows != num_rows || X.num_cols != num_members)
+        throw cusp::invalid_input_exception("array dimensions do not match the operator");
+}
+
+template <typename Array2d>
+void ensemble_check_vectors(const Array2d&, const size_t, const size_t, cusp::column_major)
+{
+    throw cusp::invalid_input_exception("the vectors of an ensemble must be row-major");
+}
+
+template <typename Matrix, typename ValueType>
+void ensemble_multiply(const Matrix& A,
+                       const ValueType * X, const size_t X_pitch,
+                             ValueType * Y, const size_t Y_pitch,
+                       cusp::host_memory)
+{
+    typedef typename Matrix::index_type IndexType;
+
+    const IndexType * Aj = A.column_indices.empty() ? NULL : &A.column_indices[0];
+    const ValueType * Ax = A.values.empty() ? NULL : &A.values[0];
+
+    const bool compensated = cusp::current_reduction_mode() == cusp::compensated_reduction;
+
+    for (size_t i = 0; i < A.num_rows; i++)
+    {
+        for (size_t e = 0; e < A.num_members; e++)
+        {
+            if (compensated)
+                Y[i * Y_pitch + e] = cusp::detail::device::ensemble_row<IndexType,ValueType,compensated_accumulation>
+                                         (IndexType(i), e, A.num_members, &A.row_offsets[0], Aj, Ax, X, X_pitch);
+            else
+                Y[i * Y_pitch + e] = cusp::detail::device::ensemble_row<IndexType,ValueType,plain_accumulation>
+                                         (IndexType(i), e, A.num_members, &A.row_offsets[0], Aj, Ax, X, X_pitch);
+        }
+    }
+}
+
+template <typename Matrix, typename ValueType>
+void ensemble_multiply(const Matrix& A,
+                       const ValueType * X, const size_t X_pitch,
+                             ValueType * Y, const size_t Y_pitch,
+                       cusp::device_memory)
+{
+    cusp::detail::device::spmv_ensemble(A, X, X_pitch, Y, Y_pitch);
+}
+
+} // end namespace detail
+
+template <typename IndexType, typename ValueType, typename MemorySpace>
+ensemble_csr_operator<IndexType,ValueType,MemorySpace>
+::ensemble_csr_operator(void)
+    : Parent(), num_members(0)
+{
+}
+
+template <typename IndexType, typename ValueType, typename MemorySpace>
+template <typename MatrixType>
+ensemble_csr_operator<IndexType,ValueType,MemorySpace>
+::ensemble_csr_operator(const MatrixType& pattern, const size_t num_members)
+    : Parent(), num_members(num_members)
+{
+    CUSP_PROFILE_SCOPED();
+
+    cusp::csr_matrix<IndexType,ValueType,MemorySpace> B(pattern);
+
+    this->resize(B.num_rows, B.num_cols, B.num_entries);
+
+    row_offsets.swap(B.row_offsets);
+    column_indices.swap(B.column_indices);
+
+    values.resize(B.num_entries * num_members);
+
+    // every member has the values of the pattern
+    thrust::copy(thrust::make_permutation_iterator(B.values.begin(),
+                     thrust::make_transform_iterator(thrust::counting_iterator<size_t>(0),
+                                                     detail::ensemble_member_position(num_members, 0))),
+                 thrust::make_permutation_iterator(B.values.begin(),
+                     thrust::make_transform_iterator(thrust::counting_iterator<size_t>(values.size()),
+                                                     detail::ensemble_member_position(num_members, 0))),
+                 values.begin());
+}
+
+template <typename IndexType, typename ValueType, typename MemorySpace>
+template <typename MatrixType, typename ArrayType>
+ensemble_csr_operator<IndexType,ValueType,MemorySpace>
+::ensemble_csr_operator(const MatrixType& pattern, const ArrayType& member_values, const size_t num_members)
+    : Parent(), num_members(num_members)
+{
+    CUSP_PROFILE_SCOPED();
+
+    cusp::csr_matrix<IndexType,ValueType,MemorySpace> B(pattern);
+
+    if (member_values.size() != num_members * B.num_entries)
+        throw cusp::invalid_input_exception("ensemble values do not match the pattern and the number of members");
+
+    this->resize(B.num_rows, B.num_cols, B.num_entries);
+
+    row_offsets.swap(B.row_offsets);
+    column_indices.swap(B.column_indices);
+
+    cusp::array1d<ValueType,MemorySpace> V(member_values);
+
+    values.resize(V.size());
+
+    thrust::copy(thrust::make_permutation_iterator(V.begin(),
+                     thrust::make_transform_iterator(thrust::counting_iterator<size_t>(0),
+                                                     detail::ensemble_member_position(num_members, B.num_entries))),
+                 thrust::make_permutation_iterator(V.begin(),
+                     thrust::make_transform_iterator(thrust::counting_iterator<size_t>(V.size()),
+                                                     detail::ensemble_member_position(num_members, B.num_entries))),
+                 values.begin());
+}
+
+template <typename IndexType, typename ValueType, typename MemorySpace>
+template <typename MemorySpace2>
+ensemble_csr_operator<IndexType,ValueType,MemorySpace>
+::ensemble_csr_operator(const ensemble_csr_operator<IndexType,ValueType,MemorySpace2>& A)
+    : Parent(A.num_rows, A.num_cols, A.num_entries), num_members(A.num_members),
+      row_offsets(A.row_offsets), column_indices(A.column_indices), values(A.values)
+{
+}
+
+template <typename IndexType, typename ValueType, typename MemorySpace>
+template <typename ArrayType>
+void ensemble_csr_operator<IndexType,ValueType,MemorySpace>
+::get_member(const size_t e, ArrayType& member_values) const
+{
+    cusp::array1d<ValueType,MemorySpace> V(this->num_entries);
+
+    thrust::copy(thrust::make_permutation_iterator(values.begin(),
+                     thrust::make_transform_iterator(thrust::counting_iterator<size_t>(0),
+                                                     detail::ensemble_value_position(num_members, e))),
+                 thrust::make_permutation_iterator(values.begin(),
+                     thrust::make_transform_iterator(thrust::counting_iterator<size_t>(this->num_entries),
+                                                     detail::ensemble_value_position(num_members, e))),
+                 V.begin());
+
+    member_values = V;
+}
+
+template <typename IndexType, typename ValueType, typename MemorySpace>
+template <typename ArrayType>
+void ensemble_csr_operator<IndexType,ValueType,MemorySpace>
+::set_member(const size_t e, const ArrayType& member_values)
+{
+    if (e >= num_members || member_values.size() != size_t(this->num_entries))
+        throw cusp::invalid_input_exception("member values do not match the ensemble");
+
+    cusp::array1d<ValueType,MemorySpace> V(member_values);
+
+    thrust::copy(V.begin(), V.end(),
+                 thrust::make_permutation_iterator(values.begin(),
+                     thrust::make_transform_iterator(thrust::counting_iterator<size_t>(0),
+                                                     detail::ensemble_value_position(num_members, e))));
+}
+
+template <typename IndexType, typename ValueType, typename MemorySpace>
+template <typename Array2d1, typename Array2d2>
+void ensemble_csr_operator<IndexType,ValueType,MemorySpace>
+::operator()(const Array2d1& X, Array2d2& Y) const
+{
+    CUSP_PROFILE_SCOPED();
+
+    detail::ensemble_check_vectors(X, this->num_cols, num_members, typename Array2d1::orientation());
+    detail::ensemble_check_vectors(Y, this->num_rows, num_members, typename Array2d2::orientation());
+
+    if (this->num_rows == 0 || num_members == 0)
+        return;
+
+    detail::ensemble_multiply(*this,
+                              thrust::raw_pointer_cast(&X.values[0]), X.pitch,
+                              thrust::raw_pointer_cast(&Y.values[0]), Y.pitch,
+                              MemorySpace());
+}
+
+} // end namespace cusp
@@ -0,0 +1,471 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include <cusp/array1d.h>
+#include <cusp/blas.h>
+#include <cusp/coo_matrix.h>
+#include <cusp/exception.h>
+#include <cusp/format.h>
+#include <cusp/detail/stream.h>
+
+#include <thrust/extrema.h>
+#include <thrust/fill.h>
+#include <thrust/functional.h>
+#include <thrust/reduce.h>
+#include <thrust/scatter.h>
+#include <thrust/sequence.h>
+#include <thrust/sort.h>
+#include <thrust/transform.h>
+#include <thrust/transform_reduce.h>
+#include <thrust/detail/type_traits.h>
+#include <thrust/iterator/counting_iterator.h>
+#include <thrust/iterator/permutation_iterator.h>
+#include <thrust/iterator/transform_iterator.h>
+
+#include <cmath>
+
+namespace cusp
+{
+namespace detail
+{
+
+// factor of row or column i, one when the factors are not given
+template <typename IndexType, typename ValueType>
+__host__ __device__
+ValueType equilibrate_factor(const ValueType * s, const IndexType i)
+{
+    return s == NULL ? ValueType(1) : s[i];
+}
+
+template <typename IndexType, typename ValueType>
+struct scale_coo_entry
+{
+    const IndexType * Ai;
+    const IndexType * Aj;
+    ValueType * Ax;
+    const ValueType * r;
+    const ValueType * c;
+
+    scale_coo_entry(const IndexType * Ai, const IndexType * Aj, ValueType * Ax, const ValueType * r, const ValueType * c)
+        : Ai(Ai), Aj(Aj), Ax(Ax), r(r), c(c) {}
+
+    __host__ __device__
+    void operator()(const IndexType n) const
+    {
+        Ax[n] *= equilibrate_factor(r, Ai[n]) * equilibrate_factor(c, Aj[n]);
+    }
+};
+
+template <typename IndexType, typename ValueType>
+struct scale_csr_row
+{
+    const IndexType * Ap;
+    const IndexType * Aj;
+    ValueType * Ax;
+    const ValueType * r;
+    const ValueType * c;
+
+    scale_csr_row(const IndexType * Ap, const IndexType * Aj, ValueType * Ax, const ValueType * r, const ValueType * c)
+        : Ap(Ap), Aj(Aj), Ax(Ax), r(r), c(c) {}
+
+    __host__ __device__
+    void operator()(const IndexType i) const
+    {
+        const ValueType ri = equilibrate_factor(r, i);
+
+        for(IndexType k = Ap[i]; k < Ap[i + 1]; k++)
+            Ax[k] *= ri * equilibrate_factor(c, Aj[k]);
+    }
+};
+
+// entry n of the column-major ELL arrays, skipping the padding
+template <typename IndexType, typename ValueType>
+struct scale_ell_entry
+{
+    IndexType num_rows;
+    IndexType pitch;
+    IndexType invalid_index;
+    const IndexType * Aj;
+    ValueType * Ax;
+    const ValueType * r;
+    const ValueType * c;
+
+    scale_ell_entry(IndexType num_rows, IndexType pitch, IndexType invalid_index,
+                    const IndexType * Aj, ValueType * Ax, const ValueType * r, const ValueType * c)
+        : num_rows(num_rows), pitch(pitch), invalid_index(invalid_index), Aj(Aj), Ax(Ax), r(r), c(c) {}
+
+    __host__ __device__
+    void operator()(const IndexType n) const
+    {
+        const IndexType i = n % pitch;
+        const IndexType j = Aj[n];
+
+        if(i < num_rows && j != invalid_index)
+            Ax[n] *= equilibrate_factor(r, i) * equilibrate_factor(c, j);
+    }
+};
+
+// entry n of the column-major DIA values, skipping the entries outside the matrix
+template <typename IndexType, typename ValueType>
+struct scale_dia_entry
+{
+    IndexType num_rows;
+    IndexType num_cols;
+    IndexType pitch;
+    const IndexType * offsets;
+    ValueType * Ax;
+    const ValueType * r;
+    const ValueType * c;
+
+    scale_dia_entry(IndexType num_rows, IndexType num_cols, IndexType pitch,
+                    const IndexType * offsets, ValueType * Ax, const ValueType * r, const ValueType * c)
+        : num_rows(num_rows), num_cols(num_cols), pitch(pitch), offsets(offsets), Ax(Ax), r(r), c(c) {}
+
+    __host__ __device__
+    void operator()(const IndexType n) const
+    {
+        const IndexType i = n % pitch;
+        const IndexType j = i + offsets[n / pitch];
+
+        if(i < num_rows && j >= 0 && j < num_cols)
+            Ax[n] *= equilibrate_factor(r, i) * equilibrate_factor(c, j);
+    }
+};
+
+// entry n of a dense array whose major dimension is the rows (row_major) or columns
+template <typename IndexType, typename ValueType, bool RowMajor>
+struct scale_array2d_entry
+{
+    IndexType num_rows;
+    IndexType num_cols;
+    IndexType pitch;
+    ValueType * Ax;
+    const ValueType * r;
+    const ValueType * c;
+
+    scale_array2d_entry(IndexType num_rows, IndexType num_cols, IndexType pitch,
+                        ValueType * Ax, const ValueType * r, const ValueType * c)
+        : num_rows(num_rows), num_cols(num_cols), pitch(pitch), Ax(Ax), r(r), c(c) {}
+
+    __host__ __device__
+    void operator()(const IndexType n) const
+    {
+        const IndexType i = RowMajor ? n / pitch : n % pitch;
+        const IndexType j = RowMajor ? n % pitch : n / pitch;
+
+        if(i < num_rows && j < num_cols)
+            Ax[n] *= equilibrate_factor(r, i) * equilibrate_factor(c, j);
+    }
+};
+
+template <typename T>
+struct equilibrate_abs : public thrust::unary_function<T,T>
+{
+    __host__ __device__
+    T operator()(const T x) const
+    {
+        return x < T(0) ? -x : x;
+    }
+};
+
+// distance of a nonzero norm from one
+template <typename T>
+struct equilibrate_deviation : public thrust::unary_function<T,T>
+{
+    __host__ __device__
+    T operator()(const T x) const
+    {
+        if(x == T(0))
+            return T(0);
+
+        return x < T(1) ? T(1) - x : x - T(1);
+    }
+};
+
+// factor dividing a row or column by the square root of its norm
+template <typename T>
+struct equilibrate_ruiz_factor : public thrust::unary_function<T,T>
+{
+    __host__ __device__
+    T operator()(const T x) const
+    {
+        using namespace std;
+
+        return x == T(0) ? T(1) : T(1) / sqrt(x);
+    }
+};
+
+template <typename ArrayType>
+const typename ArrayType::value_type * equilibrate_pointer(const ArrayType * s)
+{
+    return s == NULL ? NULL : thrust::raw_pointer_cast(&(*s)[0]);
+}
+
+template <typename MatrixType, typename ArrayType>
+void scale_rows_and_columns(MatrixType& A, const ArrayType * r, const ArrayType * c, cusp::coo_format)
+{
+    typedef typename MatrixType::index_type   IndexType;
+    typedef typename MatrixType::value_type   ValueType;
+    typedef typename MatrixType::memory_space MemorySpace;
+
+    if(A.num_entries == 0)
+        return;
+
+    cusp::detail::stream::for_each(thrust::counting_iterator<IndexType,MemorySpace>(0),
+                                   thrust::counting_iterator<IndexType,MemorySpace>(A.num_entries),
+                                   scale_coo_entry<IndexType,ValueType>(thrust::raw_pointer_cast(&A.row_indices[0]),
+                                                                        thrust::raw_pointer_cast(&A.column_indices[0]),
+                                                                        thrust::raw_pointer_cast(&A.values[0]),
+                                                                        equilibrate_pointer(r), equilibrate_pointer(c)));
+}
+
+template <typename MatrixType, typename ArrayType>
+void scale_rows_and_columns(MatrixType& A, const ArrayType * r, const ArrayType * c, cusp::csr_format)
+{
+    typedef typename MatrixType::index_type   IndexType;
+    typedef typename MatrixType::value_type   ValueType;
+    typedef typename MatrixType::memory_space MemorySpace;
+
+    if(A.num_entries == 0)
+        return;
+
+    cusp::detail::stream::for_each(thrust::counting_iterator<IndexType,MemorySpace>(0),
+                                   thrust::counting_iterator<IndexType,MemorySpace>(A.num_rows),
+                                   scale_csr_row<IndexType,ValueType>(thrust::raw_pointer_cast(&A.row_offsets[0]),
+                                                                      thrust::raw_pointer_cast(&A.column_indices[0]),
+                                                                      thrust::raw_pointer_cast(&A.values[0]),
+                                                                      equilibrate_pointer(r), equilibrate_pointer(c)));
+}
+
+template <typename MatrixType, typename ArrayType>
+void scale_rows_and_columns(MatrixType& A, const ArrayType * r, const ArrayType * c, cusp::ell_format)
+{
+    typedef typename MatrixType::index_type   IndexType;
+    typedef typename MatrixType::value_type   ValueType;
+    typedef typename MatrixType::memory_space MemorySpace;
+
+    if(A.values.values.size() == 0)
+        return;
+
+    cusp::detail::stream::for_each(thrust::counting_iterator<IndexType,MemorySpace>(0),
+                                   thrust::counting_iterator<IndexType,MemorySpace>(A.values.values.size()),
+                                   scale_ell_entry<IndexType,ValueType>(A.num_rows, A.column_indices.pitch, MatrixType::invalid_index,
+                                                                        thrust::raw_pointer_cast(&A.column_indices.values[0]),
+                                                                        thrust::raw_pointer_cast(&A.values.values[0]),
+                                                                        equilibrate_pointer(r), equilibrate_pointer(c)));
+}
+
+template <typename MatrixType, typename ArrayType>
+void scale_rows_and_columns(MatrixType& A, const ArrayType * r, const ArrayType * c, cusp::dia_format)
+{
+    typedef typename MatrixType::index_type   IndexType;
+    typedef typename MatrixType::value_type   ValueType;
+    typedef typename MatrixType::memory_space MemorySpace;
+
+    if(A.values.values.size() == 0)
+        return;
+
+    cusp::detail::stream::for_each(thrust::counting_iterator<IndexType,MemorySpace>(0),
+                                   thrust::counting_iterator<IndexType,MemorySpace>(A.values.values.size()),
+                                   scale_dia_entry<IndexType,ValueType>(A.num_rows, A.num_cols, A.values.pitch,
+                                                                        thrust::raw_pointer_cast(&A.diagonal_offsets[0]),
+                                                                        thrust::raw_pointer_cast(&A.values.values[0]),
+                                                                        equilibrate_pointer(r), equilibrate_pointer(c)));
+}
+
+template <typename MatrixType, typename ArrayType>
+void scale_rows_and_columns(MatrixType& A, const ArrayType * r, const ArrayType * c, cusp::hyb_format)
+{
+    cusp::detail::scale_rows_and_columns(A.ell, r, c, cusp::ell_format());
+    cusp::detail::scale_rows_and_columns(A.coo, r, c, cusp::coo_format());
+}
+
+template <typename MatrixType, typename ArrayType>
+void scale_rows_and_columns(MatrixType& A, const ArrayType * r, const ArrayType * c, cusp::array2d_format)
+{
+    typedef typename MatrixType::index_type   IndexType;
+    typedef typename MatrixType::value_type   ValueType;
+    typedef typename MatrixType::memory_space MemorySpace;
+
+    if(A.values.size() == 0)
+        return;
+
+    cusp::detail::stream::for_each(thrust::counting_iterator<IndexType,MemorySpace>(0),
+                                   thrust::counting_iterator<IndexType,MemorySpace>(A.values.size()),
+                                   scale_array2d_entry<IndexType,ValueType,
+                                                       thrust::detail::is_same<typename MatrixType::orientation,cusp::row_major>::value>
+                                                      (A.num_rows, A.num_cols, A.pitch,
+                                                       thrust::raw_pointer_cast(&A.values[0]),
+                                                       equilibrate_pointer(r), equilibrate_pointer(c)));
+}
+
+// other formats are scaled in COO format
+template <typename MatrixType, typename ArrayType, typename Format>
+void scale_rows_and_columns(MatrixType& A, const ArrayType * r, const ArrayType * c, Format)
+{
+    typedef typename MatrixType::index_type   IndexType;
+    typedef typename MatrixType::value_type   ValueType;
+    typedef typename MatrixType::memory_space MemorySpace;
+
+    cusp::coo_matrix<IndexType,ValueType,MemorySpace> C(A);
+    cusp::detail::scale_rows_and_columns(C, r, c, cusp::coo_format());
+
+    A = C;
+}
+
+template <typename MatrixType, typename ArrayType1, typename ArrayType2>
+void scale_rows_and_columns(MatrixType& A, const ArrayType1 * r, const ArrayType2 * c)
+{
+    typedef typename MatrixType::value_type   ValueType;
+    typedef typename MatrixType::memory_space MemorySpace;
+
+    if(r != NULL && r->size() != A.num_rows)
+        throw cusp::invalid_input_exception("row factors do not match the matrix");
+
+    if(c != NULL && c->size() != A.num_cols)
+        throw cusp::invalid_input_exception("column factors do not match the matrix");
+
+    // the factors in the memory space and value type of A
+    cusp::array1d<ValueType,MemorySpace> row_factors;
+    cusp::array1d<ValueType,MemorySpace> column_factors;
+
+    if(r != NULL)
+        row_factors = *r;
+
+    if(c != NULL)
+        column_factors = *c;
+
+    cusp::detail::scale_rows_and_columns(A,
+                                         r == NULL ? NULL : &row_factors,
+                                         c == NULL ? NULL : &column_factors,
+                                         typename MatrixType::format());
+}
+
+// largest absolute value of every segment of values with equal sorted keys
+template <typename KeyArray, typename ValueIterator, typename IndexArray, typename ValueArray>
+void equilibrate_norms(const KeyArray& sorted_keys, ValueIterator values,
+                       IndexArray& keys, ValueArray& norms, ValueArray& output)
+{
+    typedef typename KeyArray::value_type   IndexType;
+    typedef typename ValueArray::value_type ValueType;
+
+    const size_t num_keys =
+        thrust::reduce_by_key(sorted_keys.begin(), sorted_keys.end(),
+                              thrust::make_transform_iterator(values, equilibrate_abs<ValueType>()),
+                              keys.begin(), norms.begin(),
+                              thrust::equal_to<IndexType>(), thrust::maximum<ValueType>()).first - keys.begin();
+
+    thrust::fill(output.begin(), output.end(), ValueType(0));
+    thrust::scatter(norms.begin(), norms.begin() + num_keys, keys.begin(), output.begin());
+}
+
+} // end namespace detail
+
+/////////////////
+// Entry Point //
+/////////////////
+
+template <typename MatrixType, typename ArrayType>
+void scale_rows(MatrixType& A, const ArrayType& r)
+{
+    CUSP_PROFILE_SCOPED();
+
+    cusp::detail::scale_rows_and_columns(A, &r, static_cast<const ArrayType *>(NULL));
+}
+
+template <typename MatrixType, typename ArrayType>
+void scale_columns(MatrixType& A, const ArrayType& c)
+{
+    CUSP_PROFILE_SCOPED();
+
+    cusp::detail::scale_rows_and_columns(A, static_cast<const ArrayType *>(NULL), &c);
+}
+
+template <typename MatrixType, typename ArrayType1, typename ArrayType2>
+void scale_rows_and_columns(MatrixType& A, const ArrayType1& r, const ArrayType2& c)
+{
+    CUSP_PROFILE_SCOPED();
+
+    cusp::detail::scale_rows_and_columns(A, &r, &c);
+}
+
+template <typename MatrixType, typename ArrayType1, typename ArrayType2>
+size_t ruiz_equilibrate(MatrixType& A, ArrayType1& r, ArrayType2& c,
+                        const size_t max_iterations, const double tolerance)
+{
+    CUSP_PROFILE_SCOPED();
+
+    typedef typename MatrixType::index_type   IndexType;
+    typedef typename MatrixType::value_type   ValueType;
+    typedef typename MatrixType::memory_space MemorySpace;
+
+    const size_t N = A.num_rows;
+    const size_t M = A.num_cols;
+
+    cusp::array1d<ValueType,MemorySpace> row_factors(N, ValueType(1));
+    cusp::array1d<ValueType,MemorySpace> column_factors(M, ValueType(1));
+
+    // the iterations scale a COO copy sorted by row, whose columns are
+    // reduced through a permutation sorting the entries by column
+    cusp::coo_matrix<IndexType,ValueType,MemorySpace> C(A);
+    C.sort_by_row();
+
+    cusp::array1d<IndexType,MemorySpace> sorted_columns(C.column_indices);
+    cusp::array1d<IndexType,MemorySpace> column_order(C.num_entries);
+    thrust::sequence(column_order.begin(), column_order.end());
+    thrust::stable_sort_by_key(sorted_columns.begin(), sorted_columns.end(), column_order.begin());
+
+    cusp::array1d<ValueType,MemorySpace> row_norms(N);
+    cusp::array1d<ValueType,MemorySpace> column_norms(M);
+    cusp::array1d<IndexType,MemorySpace> keys(C.num_entries);
+    cusp::array1d<ValueType,MemorySpace> norms(C.num_entries);
+
+    size_t iteration = 0;
+
+    for(; iteration < max_iterations; iteration++)
+    {
+        detail::equilibrate_norms(C.row_indices, C.values.begin(), keys, norms, row_norms);
+        detail::equilibrate_norms(sorted_columns, thrust::make_permutation_iterator(C.values.begin(), column_order.begin()),
+                                  keys, norms, column_norms);
+
+        const ValueType deviation =
+            thrust::max(thrust::transform_reduce(row_norms.begin(), row_norms.end(), detail::equilibrate_deviation<ValueType>(),
+                                                 ValueType(0), thrust::maximum<ValueType>()),
+                        thrust::transform_reduce(column_norms.begin(), column_norms.end(), detail::equilibrate_deviation<ValueType>(),
+                                                 ValueType(0), thrust::maximum<ValueType>()));
+
+        if(deviation <= ValueType(tolerance))
+            break;
+
+        thrust::transform(row_norms.begin(), row_norms.end(), row_norms.begin(), detail::equilibrate_ruiz_factor<ValueType>());
+        thrust::transform(column_norms.begin(), column_norms.end(), column_norms.begin(), detail::equilibrate_ruiz_factor<ValueType>());
+
+        cusp::detail::scale_rows_and_columns(C, &row_norms, &column_norms, cusp::coo_format());
+
+        cusp::blas::xmy(row_factors, row_norms, row_factors);
+        cusp::blas::xmy(column_factors, column_norms, column_factors);
+    }
+
+    if(iteration > 0)
+        cusp::detail::scale_rows_and_columns(A, &row_factors, &column_factors);
+
+    r = row_factors;
+    c = column_factors;
+
+    return iteration;
+}
+
+} // end namespace cusp
@@ -0,0 +1,113 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include <cusp/coo_matrix.h>
+#include <cusp/equilibrate.h>
+#include <cusp/exception.h>
+#include <cusp/multiply.h>
+
+#include <thrust/functional.h>
+#include <thrust/transform.h>
+
+namespace cusp
+{
+
+template <typename MatrixType>
+template <typename MatrixType2>
+equilibrated_matrix<MatrixType>
+  ::equilibrated_matrix(const MatrixType2& A, const size_t max_iterations, const double tolerance)
+    : Parent(A.num_rows, A.num_cols, A.num_entries)
+{
+    typedef typename MatrixType2::index_type   IndexType;
+    typedef typename MatrixType2::value_type   ValueType;
+    typedef typename MatrixType2::memory_space MemorySpace;
+
+    // equilibrate in the precision of A
+    cusp::coo_matrix<IndexType,ValueType,MemorySpace> B(A);
+    cusp::array1d<ValueType,MemorySpace> r;
+    cusp::array1d<ValueType,MemorySpace> c;
+
+    iterations = cusp::ruiz_equilibrate(B, r, c, max_iterations, tolerance);
+
+    matrix = B;
+    row_scaling = r;
+    column_scaling = c;
+}
+
+template <typename MatrixType>
+template <typename VectorType1, typename VectorType2>
+void equilibrated_matrix<MatrixType>
+  ::scale_rhs(const VectorType1& b, VectorType2& b_new) const
+{
+    if(b.size() != row_scaling.size() || b_new.size() != row_scaling.size())
+        throw cusp::invalid_input_exception("array dimensions do not match the matrix");
+
+    thrust::transform(b.begin(), b.end(), row_scaling.begin(), b_new.begin(), thrust::multiplies<value_type>());
+}
+
+template <typename MatrixType>
+template <typename VectorType1, typename VectorType2>
+void equilibrated_matrix<MatrixType>
+  ::scale_initial_guess(const VectorType1& x, VectorType2& x_new) const
+{
+    if(x.size() != column_scaling.size() || x_new.size() != column_scaling.size())
+        throw cusp::invalid_input_exception("array dimensions do not match the matrix");
+
+    thrust::transform(x.begin(), x.end(), column_scaling.begin(), x_new.begin(), thrust::divides<value_type>());
+}
+
+template <typename MatrixType>
+template <typename VectorType1, typename VectorType2>
+void equilibrated_matrix<MatrixType>
+  ::unscale_solution(const VectorType1& x_new, VectorType2& x) const
+{
+    if(x.size() != column_scaling.size() || x_new.size() != column_scaling.size())
+        throw cusp::invalid_input_exception("array dimensions do not match the matrix");
+
+    thrust::transform(x_new.begin(), x_new.end(), column_scaling.begin(), x.begin(), thrust::multiplies<value_type>());
+}
+
+template <typename MatrixType>
+template <typename Solver, typename VectorType1, typename VectorType2>
+void equilibrated_matrix<MatrixType>
+  ::solve(const Solver& solver, VectorType1& x, const VectorType2& b) const
+{
+    cusp::array1d<value_type, memory_space> x_new(column_scaling.size());
+    cusp::array1d<value_type, memory_space> b_new(row_scaling.size());
+
+    scale_initial_guess(x, x_new);
+    scale_rhs(b, b_new);
+
+    solver(matrix, x_new, b_new);
+
+    unscale_solution(x_new, x);
+}
+
+template <typename MatrixType>
+template <typename VectorType1, typename VectorType2>
+void equilibrated_matrix<MatrixType>
+  ::operator()(const VectorType1& x, VectorType2& y) const
+{
+    x_work.resize(column_scaling.size());
+    y_work.resize(row_scaling.size());
+
+    scale_initial_guess(x, x_work);
+    cusp::multiply(matrix, x_work, y_work);
+
+    thrust::transform(y_work.begin(), y_work.end(), row_scaling.begin(), y.begin(), thrust::divides<value_type>());
+}
+
+} // end namespace cusp
@@ -36,6 +36,15 @@ void sort_by_row(Array1& rows, Array2& columns, Array3& values);
 
 template <typename Array1, typename Array2, typename Array3>
 void sort_by_row_and_column(Array1& rows, Array2& columns, Array3& values);
+
+// sorts the columns within every row of a CSR matrix in place
+template <typename Array1, typename Array2, typename Array3>
+void sort_columns_by_row(const Array1& row_offsets, Array2& columns, Array3& values);
+
+// sorts the columns within every row and sums the entries of the same
+// column, returning the new number of entries
+template <typename Array1, typename Array2, typename Array3>
+size_t sum_duplicates_by_row(Array1& row_offsets, Array2& columns, Array3& values);
     
 } // end namespace detail
 } // end namespace cusp
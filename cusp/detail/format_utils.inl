@@ -18,7 +18,11 @@
 #include <cusp/format.h>
 #include <cusp/array1d.h>
 
+#include <thrust/count.h>
 #include <thrust/fill.h>
+#include <thrust/for_each.h>
+#include <thrust/functional.h>
+#include <thrust/tuple.h>
 #include <thrust/extrema.h>
 #include <thrust/binary_search.h>
 #include <thrust/transform.h>
@@ -27,6 +31,8 @@
 #include <thrust/sequence.h>
 #include <thrust/scan.h>
 #include <thrust/sort.h>
+#include <thrust/iterator/counting_iterator.h>
+#include <thrust/iterator/zip_iterator.h>
 
 namespace cusp
 {
@@ -259,17 +265,105 @@ void sort_by_row(Array1& rows, Array2& columns, Array3& values)
                    thrust::make_zip_iterator(thrust::make_tuple(columns.begin(), values.begin())));
 }
 
+// (row,column) <-> row << shift | column
+template <typename IndexType1, typename IndexType2>
+struct pack_row_and_column_functor
+{
+  typedef unsigned long long result_type;
+
+  const unsigned int shift;
+
+  pack_row_and_column_functor(const unsigned int shift) : shift(shift) {}
+
+  template <typename Tuple>
+    __host__ __device__
+  result_type operator()(const Tuple& t) const
+  {
+    return (result_type(thrust::get<0>(t)) << shift) | result_type(thrust::get<1>(t));
+  }
+};
+
+template <typename IndexType1, typename IndexType2>
+struct unpack_row_and_column_functor
+{
+  typedef thrust::tuple<IndexType1,IndexType2> result_type;
+
+  const unsigned int shift;
+
+  unpack_row_and_column_functor(const unsigned int shift) : shift(shift) {}
+
+  __host__ __device__
+  result_type operator()(const unsigned long long key) const
+  {
+    return result_type(IndexType1(key >> shift),
+                       IndexType2(key & ((1ull << shift) - 1)));
+  }
+};
+
+// number of bits needed to represent the nonnegative index i
+template <typename IndexType>
+unsigned int index_bits(const IndexType i)
+{
+    unsigned int bits = 0;
+
+    while (bits < 8 * sizeof(IndexType) && (i >> bits) != 0)
+        bits++;
+
+    return bits;
+}
+
 template <typename Array1, typename Array2, typename Array3>
 void sort_by_row_and_column(Array1& rows, Array2& columns, Array3& values)
 {
     CUSP_PROFILE_SCOPED();
 
     typedef typename Array1::value_type IndexType;
+    typedef typename Array2::value_type IndexType2;
     typedef typename Array3::value_type ValueType;
     typedef typename Array1::memory_space MemorySpace;
         
     size_t N = rows.size();
 
+    if (N < 2)
+        return;
+
+    // nothing to do when the entries are already in order
+    if (thrust::is_sorted(thrust::make_zip_iterator(thrust::make_tuple(rows.begin(), columns.begin())),
+                          thrust::make_zip_iterator(thrust::make_tuple(rows.end(),   columns.end()))))
+        return;
+
+    // sort once by a 64-bit (row,column) key when both indices fit
+    {
+        const IndexType  min_row    = *thrust::min_element(rows.begin(), rows.end());
+        const IndexType  max_row    = *thrust::max_element(rows.begin(), rows.end());
+        const IndexType2 min_column = *thrust::min_element(columns.begin(), columns.end());
+        const IndexType2 max_column = *thrust::max_element(columns.begin(), columns.end());
+
+        if (!(min_row < IndexType(0)) && !(min_column < IndexType2(0)))
+        {
+            const unsigned int row_bits    = index_bits(max_row);
+            const unsigned int column_bits = index_bits(max_column);
+
+            if (row_bits + column_bits <= 64 && column_bits < 64)
+            {
+                cusp::array1d<unsigned long long,MemorySpace> keys(N);
+
+                thrust::transform(thrust::make_zip_iterator(thrust::make_tuple(rows.begin(), columns.begin())),
+                                  thrust::make_zip_iterator(thrust::make_tuple(rows.end(),   columns.end())),
+                                  keys.begin(),
+                                  pack_row_and_column_functor<IndexType,IndexType2>(column_bits));
+
+                thrust::stable_sort_by_key(keys.begin(), keys.end(), values.begin());
+
+                thrust::transform(keys.begin(), keys.end(),
+                                  thrust::make_zip_iterator(thrust::make_tuple(rows.begin(), columns.begin())),
+                                  unpack_row_and_column_functor<IndexType,IndexType2>(column_bits));
+
+                return;
+            }
+        }
+    }
+
     cusp::array1d<IndexType,MemorySpace> permutation(N);
     thrust::sequence(permutation.begin(), permutation.end());
   
@@ -293,6 +387,321 @@ void sort_by_row_and_column(Array1& rows, Array2& columns, Array3& values)
     }
 }
 
+// rows up to SEGMENTED_SORT_INSERTION_LIMIT entries are sorted by their
+// own thread with an insertion sort and rows up to
+// SEGMENTED_SORT_THREAD_LIMIT with a heapsort, while the entries of the
+// longer rows are gathered and sorted together
+const int SEGMENTED_SORT_INSERTION_LIMIT = 16;
+const int SEGMENTED_SORT_THREAD_LIMIT    = 256;
+
+template <typename IndexType, typename ValueType>
+__host__ __device__
+void segmented_swap(IndexType * Aj, ValueType * Ax, const IndexType a, const IndexType b)
+{
+    const IndexType j = Aj[a];
+    const ValueType v = Ax[a];
+    Aj[a] = Aj[b];
+    Ax[a] = Ax[b];
+    Aj[b] = j;
+    Ax[b] = v;
+}
+
+// restores the max-heap of Aj[0, n) below root
+template <typename IndexType, typename ValueType>
+__host__ __device__
+void segmented_sift_down(IndexType * Aj, ValueType * Ax, IndexType root, const IndexType n)
+{
+    while (2 * root + 1 < n)
+    {
+        IndexType child = 2 * root + 1;
+
+        if (child + 1 < n && Aj[child] < Aj[child + 1])
+            child++;
+
+        if (!(Aj[root] < Aj[child]))
+            return;
+
+        segmented_swap(Aj, Ax, root, child);
+        root = child;
+    }
+}
+
+template <typename IndexType, typename ValueType>
+struct segmented_sort_row
+{
+    const IndexType * Ap;
+    IndexType * Aj;
+    ValueType * Ax;
+    IndexType * long_lengths;
+
+    segmented_sort_row(const IndexType * Ap, IndexType * Aj, ValueType * Ax, IndexType * long_lengths)
+        : Ap(Ap), Aj(Aj), Ax(Ax), long_lengths(long_lengths) {}
+
+    __host__ __device__
+    void operator()(const IndexType i) const
+    {
+        const IndexType first = Ap[i];
+        const IndexType n     = Ap[i + 1] - first;
+
+        long_lengths[i] = 0;
+
+        bool sorted = true;
+
+        for (IndexType k = first + 1; k < first + n; k++)
+        {
+            if (Aj[k] < Aj[k - 1])
+            {
+                sorted = false;
+                break;
+            }
+        }
+
+        if (sorted)
+            return;
+
+        if (n > SEGMENTED_SORT_THREAD_LIMIT)
+        {
+            long_lengths[i] = n;
+        }
+        else if (n > SEGMENTED_SORT_INSERTION_LIMIT)
+        {
+            IndexType * row_j = Aj + first;
+            ValueType * row_x = Ax + first;
+
+            for (IndexType root = n / 2; root > 0; root--)
+                segmented_sift_down(row_j, row_x, root - 1, n);
+
+            for (IndexType end = n - 1; end > 0; end--)
+            {
+                segmented_swap(row_j, row_x, IndexType(0), end);
+                segmented_sift_down(row_j, row_x, IndexType(0), end);
+            }
+        }
+        else
+        {
+            for (IndexType k = first + 1; k < first + n; k++)
+            {
+                const IndexType j = Aj[k];
+                const ValueType v = Ax[k];
+
+                IndexType m = k;
+
+                for (; m > first && j < Aj[m - 1]; m--)
+                {
+                    Aj[m] = Aj[m - 1];
+                    Ax[m] = Ax[m - 1];
+                }
+
+                Aj[m] = j;
+                Ax[m] = v;
+            }
+        }
+    }
+};
+
+// copies the entries of the long rows to or from the arrays in which they
+// are sorted together
+template <typename IndexType, typename ValueType>
+struct segmented_copy_long_row
+{
+    const IndexType * Ap;
+    const IndexType * long_offsets;
+    IndexType * Aj;
+    ValueType * Ax;
+    IndexType * rows;
+    IndexType * columns;
+    ValueType * values;
+    bool gather;
+
+    segmented_copy_long_row(const IndexType * Ap, const IndexType * long_offsets, IndexType * Aj, ValueType * Ax,
+                            IndexType * rows, IndexType * columns, ValueType * values, const bool gather)
+        : Ap(Ap), long_offsets(long_offsets), Aj(Aj), Ax(Ax),
+          rows(rows), columns(columns), values(values), gather(gather) {}
+
+    __host__ __device__
+    void operator()(const IndexType i) const
+    {
+        const IndexType first = Ap[i];
+        const IndexType start = long_offsets[i];
+        const IndexType n     = long_offsets[i + 1] - start;
+
+        for (IndexType k = 0; k < n; k++)
+        {
+            if (gather)
+            {
+                rows[start + k]    = i;
+                columns[start + k] = Aj[first + k];
+                values[start + k]  = Ax[first + k];
+            }
+            else
+            {
+                Aj[first + k] = columns[start + k];
+                Ax[first + k] = values[start + k];
+            }
+        }
+    }
+};
+
+template <typename IndexType>
+struct segmented_count_unique
+{
+    const IndexType * Ap;
+    const IndexType * Aj;
+
+    segmented_count_unique(const IndexType * Ap, const IndexType * Aj)
+        : Ap(Ap), Aj(Aj) {}
+
+    __host__ __device__
+    IndexType operator()(const IndexType i) const
+    {
+        IndexType count = 0;
+
+        for (IndexType k = Ap[i]; k < Ap[i + 1]; k++)
+            if (k == Ap[i] || Aj[k] != Aj[k - 1])
+                count++;
+
+        return count;
+    }
+};
+
+template <typename IndexType, typename ValueType>
+struct segmented_sum_row
+{
+    const IndexType * Ap;
+    const IndexType * Aj;
+    const ValueType * Ax;
+    const IndexType * Bp;
+    IndexType * Bj;
+    ValueType * Bx;
+
+    segmented_sum_row(const IndexType * Ap, const IndexType * Aj, const ValueType * Ax,
+                      const IndexType * Bp, IndexType * Bj, ValueType * Bx)
+        : Ap(Ap), Aj(Aj), Ax(Ax), Bp(Bp), Bj(Bj), Bx(Bx) {}
+
+    __host__ __device__
+    void operator()(const IndexType i) const
+    {
+        IndexType n = Bp[i] - 1;
+
+        for (IndexType k = Ap[i]; k < Ap[i + 1]; k++)
+        {
+            if (k == Ap[i] || Aj[k] != Aj[k - 1])
+            {
+                n++;
+                Bj[n] = Aj[k];
+                Bx[n] = Ax[k];
+            }
+            else
+            {
+                Bx[n] += Ax[k];
+            }
+        }
+    }
+};
+
+template <typename Array1, typename Array2, typename Array3>
+void sort_columns_by_row(const Array1& row_offsets, Array2& columns, Array3& values)
+{
+    CUSP_PROFILE_SCOPED();
+
+    typedef typename Array2::value_type   IndexType;
+    typedef typename Array3::value_type   ValueType;
+    typedef typename Array2::memory_space MemorySpace;
+
+    typedef thrust::counting_iterator<IndexType,MemorySpace> CountingIterator;
+
+    const size_t N = row_offsets.size() - 1;
+
+    if (columns.size() < 2)
+        return;
+
+    cusp::array1d<IndexType,MemorySpace> long_offsets(N + 1);
+
+    thrust::for_each(CountingIterator(0), CountingIterator(N),
+                     segmented_sort_row<IndexType,ValueType>(thrust::raw_pointer_cast(&row_offsets[0]),
+                                                             thrust::raw_pointer_cast(&columns[0]),
+                                                             thrust::raw_pointer_cast(&values[0]),
+                                                             thrust::raw_pointer_cast(&long_offsets[0])));
+
+    long_offsets[N] = 0;
+    thrust::exclusive_scan(long_offsets.begin(), long_offsets.end(), long_offsets.begin());
+
+    const size_t num_long_entries = long_offsets[N];
+
+    if (num_long_entries == 0)
+        return;
+
+    cusp::array1d<IndexType,MemorySpace> long_rows(num_long_entries);
+    cusp::array1d<IndexType,MemorySpace> long_columns(num_long_entries);
+    cusp::array1d<ValueType,MemorySpace> long_values(num_long_entries);
+
+    for (int gather = 1; gather >= 0; gather--)
+    {
+        thrust::for_each(CountingIterator(0), CountingIterator(N),
+                         segmented_copy_long_row<IndexType,ValueType>(thrust::raw_pointer_cast(&row_offsets[0]),
+                                                                      thrust::raw_pointer_cast(&long_offsets[0]),
+                                                                      thrust::raw_pointer_cast(&columns[0]),
+                                                                      thrust::raw_pointer_cast(&values[0]),
+                                                                      thrust::raw_pointer_cast(&long_rows[0]),
+                                                                      thrust::raw_pointer_cast(&long_columns[0]),
+                                                                      thrust::raw_pointer_cast(&long_values[0]),
+                                                                      gather == 1));
+
+        if (gather)
+            cusp::detail::sort_by_row_and_column(long_rows, long_columns, long_values);
+    }
+}
+
+template <typename Array1, typename Array2, typename Array3>
+size_t sum_duplicates_by_row(Array1& row_offsets, Array2& columns, Array3& values)
+{
+    CUSP_PROFILE_SCOPED();
+
+    typedef typename Array2::value_type   IndexType;
+    typedef typename Array3::value_type   ValueType;
+    typedef typename Array2::memory_space MemorySpace;
+
+    typedef thrust::counting_iterator<IndexType,MemorySpace> CountingIterator;
+
+    const size_t N = row_offsets.size() - 1;
+
+    cusp::detail::sort_columns_by_row(row_offsets, columns, values);
+
+    if (columns.size() < 2)
+        return columns.size();
+
+    cusp::array1d<IndexType,MemorySpace> offsets(N + 1);
+
+    thrust::transform(CountingIterator(0), CountingIterator(N), offsets.begin(),
+                      segmented_count_unique<IndexType>(thrust::raw_pointer_cast(&row_offsets[0]),
+                                                        thrust::raw_pointer_cast(&columns[0])));
+    offsets[N] = 0;
+    thrust::exclusive_scan(offsets.begin(), offsets.end(), offsets.begin());
+
+    const size_t num_entries = offsets[N];
+
+    if (num_entries == columns.size())
+        return num_entries;
+
+    // rows move towards the front, so the sums go to new arrays
+    Array2 new_columns(num_entries);
+    Array3 new_values(num_entries);
+
+    thrust::for_each(CountingIterator(0), CountingIterator(N),
+                     segmented_sum_row<IndexType,ValueType>(thrust::raw_pointer_cast(&row_offsets[0]),
+                                                            thrust::raw_pointer_cast(&columns[0]),
+                                                            thrust::raw_pointer_cast(&values[0]),
+                                                            thrust::raw_pointer_cast(&offsets[0]),
+                                                            thrust::raw_pointer_cast(&new_columns[0]),
+                                                            thrust::raw_pointer_cast(&new_values[0])));
+
+    cusp::copy(offsets, row_offsets);
+    columns.swap(new_columns);
+    values.swap(new_values);
+
+    return num_entries;
+}
+
 } // end namespace detail
 } // end namespace cusp
 
@@ -26,6 +26,15 @@ template <typename IndexType, typename ValueType, typename MemorySpace> class cs
 template <typename IndexType, typename ValueType, typename MemorySpace> class dia_matrix;
 template <typename IndexType, typename ValueType, typename MemorySpace> class ell_matrix;
 template <typename IndexType, typename ValueType, typename MemorySpace> class hyb_matrix;
+template <typename IndexType, typename ValueType, typename MemorySpace> class sell_matrix;
+template <typename IndexType, typename ValueType, typename MemorySpace> class bsr_matrix;
+template <typename IndexType, typename ValueType, typename MemorySpace> class csr16_matrix;
+
+template <typename ValueType>                                           class distributed_array1d;
+template <typename LocalMatrix>                                         class distributed_matrix;
+
+template <typename ValueType>                                           class mpi_array1d;
+template <typename LocalMatrix>                                         class mpi_matrix;
 
 } // end namespace cusp
 
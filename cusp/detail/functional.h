@@ -24,6 +24,8 @@
 
 #include <cusp/detail/config.h>
 
+#include <cusp/complex.h>
+
 #include <thrust/functional.h>
 
 namespace cusp
@@ -37,6 +39,42 @@ template<typename T>
   __host__ __device__ T operator()(const T &x) const {return T(0);}
 }; // end minus
 
+template<typename T>
+  struct first_argument : public thrust::binary_function<T,T,T>
+{
+  __host__ __device__ T operator()(const T &x, const T &y) const {return x;}
+}; // end first_argument
+
+// conj(x) of complex values and x itself of real values
+template <typename T>
+__host__ __device__
+T conjugate_value(const T& x)
+{
+  return x;
+}
+
+template <typename T>
+__host__ __device__
+cusp::complex<T> conjugate_value(const cusp::complex<T>& x)
+{
+  return cusp::conj(x);
+}
+
+// conjugate_value(x) when Conjugate is true and x otherwise
+template <bool Conjugate>
+  struct conjugate_if
+{
+  template <typename T>
+  __host__ __device__ T operator()(const T &x) const {return x;}
+};
+
+template <>
+  struct conjugate_if<true>
+{
+  template <typename T>
+  __host__ __device__ T operator()(const T &x) const {return conjugate_value(x);}
+};
+
 } // end namespace detail
 } // end namespace cusp
 
@@ -14,36 +14,26 @@
  *  limitations under the License.
  */
 
-
 #pragma once
 
-#include <cusp/detail/device/spmv/csr_scalar.h>
-#include <cusp/detail/device/spmv/csr_vector.h>
+#include <thrust/detail/type_traits.h>
 
 namespace cusp
 {
 namespace detail
 {
-namespace device
-{
 
-template <typename IndexType, typename ValueType>
-void spmv(const csr_matrix<IndexType,ValueType,cusp::device_memory>& csr, 
-          const ValueType * x, 
-                ValueType * y)
-{ 
-    spmv_csr_vector(csr, x, y);
-}
+// Linear operators with a multiply_dot of their own.  A specialization
+// derives from true_type and provides
+//
+//   template <typename Vector1, typename Vector2>
+//   static typename Vector2::value_type
+//   multiply_dot(const LinearOperator& A, const Vector1& x, Vector2& y);
+//
+// which computes y = A x and returns conj(y)^T x.  cusp::multiply_dot calls
+// it in the fast reduction mode, after checking the dimensions.
+template <typename LinearOperator>
+struct fused_dot_operator : public thrust::detail::false_type {};
 
-template <typename IndexType, typename ValueType>
-void spmv_tex(const csr_matrix<IndexType,ValueType,cusp::device_memory>& csr, 
-              const ValueType * x, 
-                    ValueType * y)
-{ 
-    spmv_csr_vector_tex(csr, x, y);
-}
-
-} // end namespace device
 } // end namespace detail
 } // end namespace cusp
-
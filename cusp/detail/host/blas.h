@@ -0,0 +1,386 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+#pragma once
+
+#include <cusp/reduction.h>
+
+#include <cusp/detail/functional.h>
+#include <cusp/detail/host/parallel.h>
+
+#include <algorithm>
+#include <vector>
+
+// Dense level-2 and level-3 BLAS for the host.  A matrix is addressed as
+// M[i * rs + j * cs] with the strides (rs, cs) of its orientation, so the
+// same loops serve row-major and column-major array2d of any pitch, and the
+// innermost loop always runs along the unit stride.  gemm is blocked by
+// DENSE_TILE_SIZE rows, columns and inner indices so that the tiles of A, B
+// and C stay in cache.  gemv and gemm split the rows of the result among the
+// OpenMP threads and trsm splits the columns of the right-hand sides.
+// mdot splits the rows of Y and sums the partial results of the threads.
+//
+// reproducible_sum adds the terms of a reduction in the fixed order of
+// cusp/reduction.h, which the device kernels follow as well, and splits
+// whole chunks among the threads so the order does not depend on them.
+
+namespace cusp
+{
+namespace detail
+{
+namespace host
+{
+
+// tile size of the blocked gemm
+const int DENSE_TILE_SIZE = 64;
+
+// y = alpha * A * x + beta * y where A is num_rows x num_cols.  y is not
+// read when beta is zero.
+template <typename ValueType, typename Array1, typename Array2>
+void gemv(const int num_rows, const int num_cols,
+          const ValueType alpha,
+          const ValueType * A, const int rs, const int cs,
+          const Array1& x,
+          const ValueType beta,
+                Array2& y)
+{
+    const int P = num_parts(size_t(num_rows) * (num_cols + 1));
+
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(static) num_threads(P)
+#endif
+    for (int part = 0; part < P; part++)
+    {
+        const int i_begin = uniform_split(num_rows, part,     P);
+        const int i_end   = uniform_split(num_rows, part + 1, P);
+
+        for (int i = i_begin; i < i_end; i++)
+            y[i] = (beta == ValueType(0)) ? ValueType(0) : ValueType(beta * y[i]);
+
+        if (cs == 1)
+        {
+            // row-major: dot product of each row with x
+            for (int i = i_begin; i < i_end; i++)
+            {
+                const ValueType * A_row = A + i * rs;
+
+                ValueType sum = 0;
+
+                for (int j = 0; j < num_cols; j++)
+                    sum += A_row[j] * ValueType(x[j]);
+
+                y[i] += alpha * sum;
+            }
+        }
+        else
+        {
+            // column-major: add the scaled columns to this block of y
+            for (int j = 0; j < num_cols; j++)
+            {
+                const ValueType   a     = alpha * ValueType(x[j]);
+                const ValueType * A_col = A + j * cs;
+
+                for (int i = i_begin; i < i_end; i++)
+                    y[i] += A_col[i] * a;
+            }
+        }
+    }
+}
+
+// result[j] = x^T Y[:,j] (conj(x)^T Y[:,j] when Conjugate is true) for the
+// num_vectors columns of the n x num_vectors matrix Y
+template <bool Conjugate, typename ValueType, typename Array1, typename Array2>
+void mdot(const int n, const int num_vectors,
+          const Array1& x,
+          const ValueType * Y, const int rs, const int cs,
+                Array2& result)
+{
+    const int k = num_vectors;
+    const int P = num_parts(size_t(n) * (k + 1));
+
+    const cusp::detail::conjugate_if<Conjugate> conj_x;
+
+    std::vector<ValueType> partial(size_t(P) * k, ValueType(0));
+
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(static) num_threads(P)
+#endif
+    for (int part = 0; part < P; part++)
+    {
+        const int i_begin = uniform_split(n, part,     P);
+        const int i_end   = uniform_split(n, part + 1, P);
+
+        ValueType * sums = &partial[size_t(part) * k];
+
+        if (cs == 1)
+        {
+            // row-major: each row of Y adds to every sum
+            for (int i = i_begin; i < i_end; i++)
+            {
+                const ValueType   x_i   = conj_x(ValueType(x[i]));
+                const ValueType * Y_row = Y + i * rs;
+
+                for (int j = 0; j < k; j++)
+                    sums[j] += x_i * Y_row[j];
+            }
+        }
+        else
+        {
+            // column-major: one dot product per column
+            for (int j = 0; j < k; j++)
+            {
+                const ValueType * Y_col = Y + j * cs;
+
+                ValueType sum = 0;
+
+                for (int i = i_begin; i < i_end; i++)
+                    sum += conj_x(ValueType(x[i])) * Y_col[i];
+
+                sums[j] = sum;
+            }
+        }
+    }
+
+    for (int j = 0; j < k; j++)
+    {
+        ValueType sum = 0;
+
+        for (int part = 0; part < P; part++)
+            sum += partial[size_t(part) * k + j];
+
+        result[j] = sum;
+    }
+}
+
+// partial[c] = sum of op(x[i], y[i]) over chunk c of the n terms.  Lane t of
+// a chunk adds items t, t + REDUCTION_LANES, ... in turn and the lanes are
+// then added pairwise, exactly as a block of the device kernel does.
+template <typename OutputType, typename Iterator1, typename Iterator2, typename BinaryFunction>
+void reproducible_partials(const size_t n,
+                           Iterator1 x, Iterator2 y,
+                           BinaryFunction op,
+                           OutputType * partial)
+{
+    const size_t LANES = cusp::detail::REDUCTION_LANES;
+    const size_t CHUNK = LANES * cusp::detail::REDUCTION_ITEMS;
+
+    const size_t num_chunks = (n + CHUNK - 1) / CHUNK;
+
+    const int P = int(std::min<size_t>(num_parts(n), num_chunks));
+
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(static) num_threads(P)
+#endif
+    for (int part = 0; part < P; part++)
+    {
+        const size_t c_begin = uniform_split(num_chunks, part,     P);
+        const size_t c_end   = uniform_split(num_chunks, part + 1, P);
+
+        std::vector<OutputType> lane(LANES);
+
+        for (size_t c = c_begin; c < c_end; c++)
+        {
+            const size_t base = c * CHUNK;
+
+            std::fill(lane.begin(), lane.end(), OutputType(0));
+
+            for (size_t i = base; i < std::min(base + CHUNK, n); i += LANES)
+                for (size_t t = 0; t < LANES && i + t < n; t++)
+                    lane[t] = lane[t] + OutputType(op(x[i + t], y[i + t]));
+
+            for (size_t offset = LANES / 2; offset > 0; offset /= 2)
+                for (size_t t = 0; t < offset; t++)
+                    lane[t] = lane[t] + lane[t + offset];
+
+            partial[c] = lane[0];
+        }
+    }
+}
+
+// sum of op(x[i], y[i]) for 0 <= i < n in the order of cusp/reduction.h.
+// The chunk sums are reduced the same way until a single value is left.
+template <typename OutputType, typename Iterator1, typename Iterator2, typename BinaryFunction>
+OutputType reproducible_sum(const size_t n,
+                            Iterator1 x, Iterator2 y,
+                            BinaryFunction op)
+{
+    const size_t CHUNK = cusp::detail::REDUCTION_LANES * cusp::detail::REDUCTION_ITEMS;
+
+    if (n == 0)
+        return OutputType(0);
+
+    std::vector<OutputType> partial((n + CHUNK - 1) / CHUNK);
+
+    reproducible_partials(n, x, y, op, &partial[0]);
+
+    while (partial.size() > 1)
+    {
+        std::vector<OutputType> next((partial.size() + CHUNK - 1) / CHUNK);
+
+        reproducible_partials(partial.size(), &partial[0], &partial[0],
+                              cusp::detail::first_argument<OutputType>(), &next[0]);
+
+        partial.swap(next);
+    }
+
+    return partial[0];
+}
+
+// C[i_begin:i_end, j_begin:j_end] += alpha * A[i_begin:i_end, k_begin:k_end] * B[k_begin:k_end, j_begin:j_end]
+template <typename ValueType>
+void gemm_tile(const ValueType alpha,
+               const ValueType * A, const int A_rs, const int A_cs,
+               const ValueType * B, const int B_rs, const int B_cs,
+                     ValueType * C, const int C_rs, const int C_cs,
+               const int i_begin, const int i_end,
+               const int j_begin, const int j_end,
+               const int k_begin, const int k_end)
+{
+    if (C_cs == 1)
+    {
+        // row-major C: innermost loop runs along a row of B and C
+        for (int i = i_begin; i < i_end; i++)
+        {
+            ValueType * C_row = C + i * C_rs;
+
+            for (int k = k_begin; k < k_end; k++)
+            {
+                const ValueType a = alpha * A[i * A_rs + k * A_cs];
+                const ValueType * B_row = B + k * B_rs;
+
+                for (int j = j_begin; j < j_end; j++)
+                    C_row[j] += a * B_row[j * B_cs];
+            }
+        }
+    }
+    else
+    {
+        // column-major C: innermost loop runs along a column of A and C
+        for (int j = j_begin; j < j_end; j++)
+        {
+            ValueType * C_col = C + j * C_cs;
+
+            for (int k = k_begin; k < k_end; k++)
+            {
+                const ValueType b = alpha * B[k * B_rs + j * B_cs];
+                const ValueType * A_col = A + k * A_cs;
+
+                for (int i = i_begin; i < i_end; i++)
+                    C_col[i] += A_col[i * A_rs] * b;
+            }
+        }
+    }
+}
+
+// C = alpha * A * B + beta * C where A is m x k, B is k x n and C is m x n.
+// C is not read when beta is zero.
+template <typename ValueType>
+void gemm(const int m, const int n, const int k,
+          const ValueType alpha,
+          const ValueType * A, const int A_rs, const int A_cs,
+          const ValueType * B, const int B_rs, const int B_cs,
+          const ValueType beta,
+                ValueType * C, const int C_rs, const int C_cs)
+{
+    const int NB = DENSE_TILE_SIZE;
+
+    const int num_row_tiles = (m + NB - 1) / NB;
+
+    if (num_row_tiles == 0)
+        return;
+
+    const int P = std::min(num_parts(size_t(m) * n * (k + 1)), num_row_tiles);
+
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(static) num_threads(P)
+#endif
+    for (int part = 0; part < P; part++)
+    {
+        const int i_begin = NB * int(uniform_split(num_row_tiles, part,     P));
+        const int i_end   = std::min(m, NB * int(uniform_split(num_row_tiles, part + 1, P)));
+
+        for (int i = i_begin; i < i_end; i++)
+            for (int j = 0; j < n; j++)
+            {
+                ValueType& c = C[i * C_rs + j * C_cs];
+                c = (beta == ValueType(0)) ? ValueType(0) : ValueType(beta * c);
+            }
+
+        for (int ib = i_begin; ib < i_end; ib += NB)
+            for (int kb = 0; kb < k; kb += NB)
+                for (int jb = 0; jb < n; jb += NB)
+                    gemm_tile(alpha,
+                              A, A_rs, A_cs,
+                              B, B_rs, B_cs,
+                              C, C_rs, C_cs,
+                              ib, std::min(ib + NB, i_end),
+                              jb, std::min(jb + NB, n),
+                              kb, std::min(kb + NB, k));
+    }
+}
+
+// B = inv(A) * B where A is the n x n lower or upper triangle of a matrix
+// and B has num_rhs columns.  The diagonal of A is taken to be one when
+// unit_diagonal is true.
+template <typename ValueType>
+void trsm(const int n, const int num_rhs,
+          const bool lower, const bool unit_diagonal,
+          const ValueType * A, const int A_rs, const int A_cs,
+                ValueType * B, const int B_rs, const int B_cs)
+{
+    const int P = std::min(num_parts(size_t(n) * (n + 1) * num_rhs / 2), std::max(num_rhs, 1));
+
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(static) num_threads(P)
+#endif
+    for (int part = 0; part < P; part++)
+    {
+        const int j_begin = uniform_split(num_rhs, part,     P);
+        const int j_end   = uniform_split(num_rhs, part + 1, P);
+
+        for (int j = j_begin; j < j_end; j++)
+        {
+            ValueType * b = B + j * B_cs;
+
+            // eliminate one unknown at a time, subtracting its column of A
+            // from the remaining right-hand side
+            for (int t = 0; t < n; t++)
+            {
+                const int k = lower ? t : n - 1 - t;
+
+                ValueType& b_k = b[k * B_rs];
+
+                if (!unit_diagonal)
+                    b_k /= A[k * A_rs + k * A_cs];
+
+                const ValueType * A_col = A + k * A_cs;
+
+                if (lower)
+                    for (int i = k + 1; i < n; i++)
+                        b[i * B_rs] -= A_col[i * A_rs] * b_k;
+                else
+                    for (int i = 0; i < k; i++)
+                        b[i * B_rs] -= A_col[i * A_rs] * b_k;
+            }
+        }
+    }
+}
+
+} // end namespace host
+} // end namespace detail
+} // end namespace cusp
+
@@ -21,12 +21,16 @@
 #include <cusp/ell_matrix.h>
 #include <cusp/exception.h>
 
+#include <cusp/detail/offset_type.h>
 #include <cusp/detail/host/conversion_utils.h>
+#include <cusp/detail/host/parallel.h>
 
 #include <thrust/fill.h>
 #include <thrust/extrema.h>
 #include <thrust/count.h>
 
+#include <algorithm>
+
 namespace cusp
 {
 namespace detail
@@ -38,48 +42,182 @@ namespace host
 // COO Conversions //
 /////////////////////
     
+// Entries of a row-sorted COO matrix are already in CSR order, so each
+// block of entries sets the offsets of the rows which start inside it and
+// copies its entries.  Otherwise each block counts its entries per row, and
+// the entries of a row are placed block after block, in their COO order.
 template <typename Matrix1, typename Matrix2>
 void coo_to_csr(const Matrix1& src, Matrix2& dst)
 {
     typedef typename Matrix2::index_type IndexType;
-    typedef typename Matrix2::value_type ValueType;
+    typedef typename cusp::detail::offset_type<Matrix2>::type OffsetType;
 
     dst.resize(src.num_rows, src.num_cols, src.num_entries);
-    
-    // compute number of non-zero entries per row of A 
-    thrust::fill(dst.row_offsets.begin(), dst.row_offsets.end(), IndexType(0));
 
-    for (size_t n = 0; n < src.num_entries; n++)
-        dst.row_offsets[src.row_indices[n]]++;
+    const size_t num_rows    = src.num_rows;
+    const size_t num_entries = src.num_entries;
 
-    // cumsum the num_entries per row to get dst.row_offsets[]
-    IndexType cumsum = 0;
-    for(size_t i = 0; i < src.num_rows; i++)
+    const int P = cusp::detail::host::num_parts(num_rows + num_entries);
+
+    int unsorted = 0;
+
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(static) num_threads(P) reduction(+:unsorted)
+#endif
+    for(int part = 0; part < P; part++)
     {
-        IndexType temp = dst.row_offsets[i];
-        dst.row_offsets[i] = cumsum;
-        cumsum += temp;
+        const size_t n_end = uniform_split(num_entries, part + 1, P);
+
+        for(size_t n = std::max<size_t>(uniform_split(num_entries, part, P), 1); n < n_end; n++)
+            if(src.row_indices[n] < src.row_indices[n - 1])
+            {
+                unsorted++;
+                break;
+            }
     }
-    dst.row_offsets[src.num_rows] = cumsum;
 
-    // write Aj,Ax into dst.column_indices,dst.values
-    for(size_t n = 0; n < src.num_entries; n++)
+    if(unsorted == 0)
     {
-        IndexType row  = src.row_indices[n];
-        IndexType dest = dst.row_offsets[row];
+#ifdef _OPENMP
+        #pragma omp parallel for schedule(static) num_threads(P)
+#endif
+        for(int part = 0; part < P; part++)
+        {
+            const size_t n_end = uniform_split(num_entries, part + 1, P);
+
+            for(size_t n = uniform_split(num_entries, part, P); n < n_end; n++)
+            {
+                // rows (previous row, row] start at n
+                const size_t first = n == 0 ? 0 : size_t(src.row_indices[n - 1]) + 1;
+                const size_t last  = src.row_indices[n];
+
+                for(size_t i = first; i <= last; i++)
+                    dst.row_offsets[i] = n;
 
-        dst.column_indices[dest] = src.column_indices[n];
-        dst.values[dest]         = src.values[n];
+                dst.column_indices[n] = src.column_indices[n];
+                dst.values[n]         = src.values[n];
+            }
+        }
+
+        // rows after the last entry
+        const size_t first = num_entries == 0 ? 0 : size_t(src.row_indices[num_entries - 1]) + 1;
 
-        dst.row_offsets[row]++;
+        for(size_t i = first; i <= num_rows; i++)
+            dst.row_offsets[i] = num_entries;
+
+        return;
     }
 
-    IndexType last = 0; 
-    for(size_t i = 0; i <= src.num_rows; i++)
+    // the counts of every block take P * num_rows indices, only worth it
+    // when they are no larger than the matrix
+    if(P == 1 || size_t(P) * num_rows > num_entries)
     {
-        IndexType temp = dst.row_offsets[i];
-        dst.row_offsets[i]  = last;
-        last   = temp;
+        // compute number of non-zero entries per row of A
+        thrust::fill(dst.row_offsets.begin(), dst.row_offsets.end(), OffsetType(0));
+
+        for (size_t n = 0; n < num_entries; n++)
+            dst.row_offsets[src.row_indices[n]]++;
+
+        cusp::detail::host::counts_to_offsets(dst.row_offsets, num_rows);
+
+        // write Aj,Ax into dst.column_indices,dst.values
+        for(size_t n = 0; n < num_entries; n++)
+        {
+            IndexType row  = src.row_indices[n];
+            OffsetType dest = dst.row_offsets[row];
+
+            dst.column_indices[dest] = src.column_indices[n];
+            dst.values[dest]         = src.values[n];
+
+            dst.row_offsets[row]++;
+        }
+
+        OffsetType last = 0;
+        for(size_t i = 0; i <= num_rows; i++)
+        {
+            OffsetType temp = dst.row_offsets[i];
+            dst.row_offsets[i]  = last;
+            last   = temp;
+        }
+
+        return;
+    }
+
+    // positions[part * num_rows + i] <- entries of row i in block part
+    cusp::array1d<OffsetType,cusp::host_memory> positions(P * num_rows, OffsetType(0));
+
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(static) num_threads(P)
+#endif
+    for(int part = 0; part < P; part++)
+    {
+        OffsetType * counts = &positions[part * num_rows];
+
+        const size_t n_end = uniform_split(num_entries, part + 1, P);
+
+        for(size_t n = uniform_split(num_entries, part, P); n < n_end; n++)
+            counts[src.row_indices[n]]++;
+    }
+
+    // row_offsets[i] <- entries of row i, then their prefix sums
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(static) num_threads(P)
+#endif
+    for(int part = 0; part < P; part++)
+    {
+        const size_t i_end = uniform_split(num_rows, part + 1, P);
+
+        for(size_t i = uniform_split(num_rows, part, P); i < i_end; i++)
+        {
+            OffsetType count = 0;
+
+            for(int q = 0; q < P; q++)
+                count += positions[q * num_rows + i];
+
+            dst.row_offsets[i] = count;
+        }
+    }
+
+    cusp::detail::host::counts_to_offsets(dst.row_offsets, num_rows);
+
+    // positions[part * num_rows + i] <- first position of the entries of
+    // row i in block part
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(static) num_threads(P)
+#endif
+    for(int part = 0; part < P; part++)
+    {
+        const size_t i_end = uniform_split(num_rows, part + 1, P);
+
+        for(size_t i = uniform_split(num_rows, part, P); i < i_end; i++)
+        {
+            OffsetType start = dst.row_offsets[i];
+
+            for(int q = 0; q < P; q++)
+            {
+                const OffsetType count = positions[q * num_rows + i];
+                positions[q * num_rows + i] = start;
+                start += count;
+            }
+        }
+    }
+
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(static) num_threads(P)
+#endif
+    for(int part = 0; part < P; part++)
+    {
+        OffsetType * next = &positions[part * num_rows];
+
+        const size_t n_end = uniform_split(num_entries, part + 1, P);
+
+        for(size_t n = uniform_split(num_entries, part, P); n < n_end; n++)
+        {
+            const OffsetType dest = next[src.row_indices[n]]++;
+
+            dst.column_indices[dest] = src.column_indices[n];
+            dst.values[dest]         = src.values[n];
+        }
     }
 
     //csr may contain duplicates
@@ -107,14 +245,25 @@ template <typename Matrix1, typename Matrix2>
 void csr_to_coo(const Matrix1& src, Matrix2& dst)
 {
     typedef typename Matrix2::index_type IndexType;
+    typedef typename cusp::detail::offset_type<Matrix1>::type OffsetType;
     typedef typename Matrix2::value_type ValueType;
 
     dst.resize(src.num_rows, src.num_cols, src.num_entries);
    
+    const int P = cusp::detail::host::num_parts(src.num_rows + src.num_entries);
+
     // TODO replace with offsets_to_indices
-    for(size_t i = 0; i < src.num_rows; i++)
-        for(IndexType jj = src.row_offsets[i]; jj < src.row_offsets[i + 1]; jj++)
-            dst.row_indices[jj] = i;
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(static) num_threads(P)
+#endif
+    for(int part = 0; part < P; part++)
+    {
+        const size_t i_end = balanced_split(src.row_offsets, src.num_rows, part + 1, P);
+
+        for(size_t i = balanced_split(src.row_offsets, src.num_rows, part, P); i < i_end; i++)
+            for(OffsetType jj = src.row_offsets[i]; jj < src.row_offsets[i + 1]; jj++)
+                dst.row_indices[jj] = i;
+    }
 
     cusp::copy(src.column_indices, dst.column_indices);
     cusp::copy(src.values,         dst.values);
@@ -125,55 +274,90 @@ void csr_to_dia(const Matrix1& src, Matrix2& dst,
                 const size_t alignment = 32)
 {
     typedef typename Matrix2::index_type IndexType;
+    typedef typename cusp::detail::offset_type<Matrix1>::type OffsetType;
     typedef typename Matrix2::value_type ValueType;
 
-    // compute number of occupied diagonals and enumerate them
-    size_t num_diagonals = 0;
+    const size_t num_offsets = src.num_rows + src.num_cols;
 
-    cusp::array1d<IndexType,cusp::host_memory> diag_map(src.num_rows + src.num_cols, 0);
+    // each block of rows marks the diagonals it occupies in a map of its
+    // own, index (num_rows - i) + j, and the maps are merged by diagonal;
+    // there are no more maps than make up the size of the matrix
+    const int P = std::min<int>(cusp::detail::host::num_parts(src.num_rows + src.num_entries),
+                                std::max<size_t>(src.num_entries / std::max<size_t>(num_offsets, 1), 1));
 
-    for(size_t i = 0; i < src.num_rows; i++)
+    cusp::array1d<unsigned char,cusp::host_memory> occupied(P * num_offsets, 0);
+
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(static) num_threads(P)
+#endif
+    for(int part = 0; part < P; part++)
+    {
+        unsigned char * map = &occupied[part * num_offsets];
+
+        const size_t i_end = balanced_split(src.row_offsets, src.num_rows, part + 1, P);
+
+        for(size_t i = balanced_split(src.row_offsets, src.num_rows, part, P); i < i_end; i++)
+            for(OffsetType jj = src.row_offsets[i]; jj < src.row_offsets[i+1]; jj++)
+                map[(src.num_rows - i) + src.column_indices[jj]] = 1;
+    }
+
+    cusp::array1d<IndexType,cusp::host_memory> diag_map(num_offsets + 1, 0);
+
+    const int Q = cusp::detail::host::num_parts(P * num_offsets);
+
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(static) num_threads(Q)
+#endif
+    for(int part = 0; part < Q; part++)
     {
-        for(IndexType jj = src.row_offsets[i]; jj < src.row_offsets[i+1]; jj++)
+        const size_t n_end = uniform_split(num_offsets, part + 1, Q);
+
+        for(size_t n = uniform_split(num_offsets, part, Q); n < n_end; n++)
         {
-            size_t j         = src.column_indices[jj];
-            size_t map_index = (src.num_rows - i) + j; //offset shifted by + num_rows
+            unsigned char any = 0;
 
-            if(diag_map[map_index] == 0)
-            {
-                diag_map[map_index] = 1;
-                num_diagonals++;
-            }
+            for(int q = 0; q < P; q++)
+                any |= occupied[q * num_offsets + n];
+
+            diag_map[n] = any;
         }
     }
-   
+
+    // diag_map[n] <- number of the diagonal at offset n - num_rows
+    cusp::detail::host::counts_to_offsets(diag_map, num_offsets);
+
+    const size_t num_diagonals = diag_map[num_offsets];
 
     // allocate DIA structure
     dst.resize(src.num_rows, src.num_cols, src.num_entries, num_diagonals, alignment);
 
     // fill in diagonal_offsets array
-    for(size_t n = 0, diag = 0; n < src.num_rows + src.num_cols; n++)
-    {
-        if(diag_map[n] == 1)
-        {
-            diag_map[n] = diag;
-            dst.diagonal_offsets[diag] = (IndexType) n - (IndexType) src.num_rows;
-            diag++;
-        }
-    }
+    for(size_t n = 0; n < num_offsets; n++)
+        if(diag_map[n + 1] != diag_map[n])
+            dst.diagonal_offsets[diag_map[n]] = (IndexType) n - (IndexType) src.num_rows;
 
     // fill in values array
     thrust::fill(dst.values.values.begin(), dst.values.values.end(), ValueType(0));
 
-    for(size_t i = 0; i < src.num_rows; i++)
+    const int R = cusp::detail::host::num_parts(src.num_rows + src.num_entries);
+
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(static) num_threads(R)
+#endif
+    for(int part = 0; part < R; part++)
     {
-        for(IndexType jj = src.row_offsets[i]; jj < src.row_offsets[i+1]; jj++)
+        const size_t i_end = balanced_split(src.row_offsets, src.num_rows, part + 1, R);
+
+        for(size_t i = balanced_split(src.row_offsets, src.num_rows, part, R); i < i_end; i++)
         {
-            size_t j = src.column_indices[jj];
-            size_t map_index = (src.num_rows - i) + j; //offset shifted by + num_rows
-            size_t diag = diag_map[map_index];
-        
-            dst.values(i, diag) = src.values[jj];
+            for(OffsetType jj = src.row_offsets[i]; jj < src.row_offsets[i+1]; jj++)
+            {
+                size_t j = src.column_indices[jj];
+                size_t map_index = (src.num_rows - i) + j; //offset shifted by + num_rows
+                size_t diag = diag_map[map_index];
+
+                dst.values(i, diag) = src.values[jj];
+            }
         }
     }
 }
@@ -185,18 +369,37 @@ void csr_to_hyb(const Matrix1& src, Matrix2& dst,
                 const size_t alignment = 32)
 {
     typedef typename Matrix2::index_type IndexType;
+    typedef typename cusp::detail::offset_type<Matrix1>::type OffsetType;
     typedef typename Matrix2::value_type ValueType;
 
     // The ELL portion of the HYB matrix will have 'num_entries_per_row' columns.
     // Nonzero values that do not fit within the ELL structure are placed in the 
     // COO format portion of the HYB matrix.
-    
-    // compute number of nonzeros in the ELL and COO portions
-    size_t num_ell_entries = 0;
-    for(size_t i = 0; i < src.num_rows; i++)
-        num_ell_entries += thrust::min<size_t>(num_entries_per_row, src.row_offsets[i+1] - src.row_offsets[i]); 
 
-    IndexType num_coo_entries = src.num_entries - num_ell_entries;
+    const int P = cusp::detail::host::num_parts(src.num_rows + src.num_entries);
+
+    // coo_offsets[i] <- first COO entry of row i
+    cusp::array1d<size_t,cusp::host_memory> coo_offsets(src.num_rows + 1);
+
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(static) num_threads(P)
+#endif
+    for(int part = 0; part < P; part++)
+    {
+        const size_t i_end = uniform_split(src.num_rows, part + 1, P);
+
+        for(size_t i = uniform_split(src.num_rows, part, P); i < i_end; i++)
+        {
+            const size_t length = src.row_offsets[i+1] - src.row_offsets[i];
+            coo_offsets[i] = length > num_entries_per_row ? length - num_entries_per_row : 0;
+        }
+    }
+
+    cusp::detail::host::counts_to_offsets(coo_offsets, src.num_rows);
+
+    // compute number of nonzeros in the ELL and COO portions
+    size_t num_coo_entries = coo_offsets[src.num_rows];
+    size_t num_ell_entries = src.num_entries - num_coo_entries;
 
     dst.resize(src.num_rows, src.num_cols, 
                num_ell_entries, num_coo_entries, 
@@ -208,26 +411,35 @@ void csr_to_hyb(const Matrix1& src, Matrix2& dst,
     thrust::fill(dst.ell.column_indices.values.begin(), dst.ell.column_indices.values.end(), invalid_index);
     thrust::fill(dst.ell.values.values.begin(),         dst.ell.values.values.end(),         ValueType(0));
 
-    for(size_t i = 0, coo_nnz = 0; i < src.num_rows; i++)
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(static) num_threads(P)
+#endif
+    for(int part = 0; part < P; part++)
     {
-        size_t n = 0;
-        IndexType jj = src.row_offsets[i];
+        const size_t i_end = balanced_split(src.row_offsets, src.num_rows, part + 1, P);
 
-        // copy up to num_cols_per_row values of row i into the ELL
-        while(jj < src.row_offsets[i+1] && n < num_entries_per_row)
+        for(size_t i = balanced_split(src.row_offsets, src.num_rows, part, P); i < i_end; i++)
         {
-            dst.ell.column_indices(i,n) = src.column_indices[jj];
-            dst.ell.values(i,n)         = src.values[jj];
-            jj++, n++;
-        }
+            size_t n = 0;
+            size_t coo_nnz = coo_offsets[i];
+            OffsetType jj = src.row_offsets[i];
 
-        // copy any remaining values in row i into the COO
-        while(jj < src.row_offsets[i+1])
-        {
-            dst.coo.row_indices[coo_nnz]    = i;
-            dst.coo.column_indices[coo_nnz] = src.column_indices[jj];
-            dst.coo.values[coo_nnz]         = src.values[jj];
-            jj++; coo_nnz++;
+            // copy up to num_cols_per_row values of row i into the ELL
+            while(jj < src.row_offsets[i+1] && n < num_entries_per_row)
+            {
+                dst.ell.column_indices(i,n) = src.column_indices[jj];
+                dst.ell.values(i,n)         = src.values[jj];
+                jj++, n++;
+            }
+
+            // copy any remaining values in row i into the COO
+            while(jj < src.row_offsets[i+1])
+            {
+                dst.coo.row_indices[coo_nnz]    = i;
+                dst.coo.column_indices[coo_nnz] = src.column_indices[jj];
+                dst.coo.values[coo_nnz]         = src.values[jj];
+                jj++; coo_nnz++;
+            }
         }
     }
 }
@@ -238,13 +450,25 @@ void csr_to_ell(const Matrix1& src, Matrix2& dst,
                 const size_t num_entries_per_row, const size_t alignment = 32)
 {
     typedef typename Matrix2::index_type IndexType;
+    typedef typename cusp::detail::offset_type<Matrix1>::type OffsetType;
     typedef typename Matrix2::value_type ValueType;
 
     // compute number of nonzeros
 
+    const int P = cusp::detail::host::num_parts(src.num_rows + src.num_entries);
+
     size_t num_entries = 0;
-    for(size_t i = 0; i < src.num_rows; i++)
-        num_entries += thrust::min<size_t>(num_entries_per_row, src.row_offsets[i+1] - src.row_offsets[i]); 
+
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(static) num_threads(P) reduction(+:num_entries)
+#endif
+    for(int part = 0; part < P; part++)
+    {
+        const size_t i_end = uniform_split(src.num_rows, part + 1, P);
+
+        for(size_t i = uniform_split(src.num_rows, part, P); i < i_end; i++)
+            num_entries += thrust::min<size_t>(num_entries_per_row, src.row_offsets[i+1] - src.row_offsets[i]);
+    }
 
     dst.resize(src.num_rows, src.num_cols, num_entries, num_entries_per_row, alignment);
 
@@ -254,19 +478,229 @@ void csr_to_ell(const Matrix1& src, Matrix2& dst,
     thrust::fill(dst.column_indices.values.begin(), dst.column_indices.values.end(), invalid_index);
     thrust::fill(dst.values.values.begin(),         dst.values.values.end(),         ValueType(0));
 
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(static) num_threads(P)
+#endif
+    for(int part = 0; part < P; part++)
+    {
+        const size_t i_end = balanced_split(src.row_offsets, src.num_rows, part + 1, P);
+
+        for(size_t i = balanced_split(src.row_offsets, src.num_rows, part, P); i < i_end; i++)
+        {
+            size_t n = 0;
+            OffsetType jj = src.row_offsets[i];
+
+            // copy up to num_cols_per_row values of row i into the ELL
+            while(jj < src.row_offsets[i+1] && n < num_entries_per_row)
+            {
+                dst.column_indices(i,n) = src.column_indices[jj];
+                dst.values(i,n)         = src.values[jj];
+                jj++, n++;
+            }
+        }
+    }
+}
+
+
+// orders rows by decreasing length
+template <typename Array>
+struct sell_row_length_greater
+{
+    const Array& row_lengths;
+
+    sell_row_length_greater(const Array& row_lengths) : row_lengths(row_lengths) {}
+
+    template <typename IndexType>
+    bool operator()(const IndexType i, const IndexType j) const
+    {
+        return row_lengths[i] > row_lengths[j];
+    }
+};
+
+template <typename Matrix1, typename Matrix2>
+void csr_to_sell(const Matrix1& src, Matrix2& dst)
+{
+    typedef typename Matrix2::index_type IndexType;
+    typedef typename cusp::detail::offset_type<Matrix1>::type OffsetType;
+    typedef typename Matrix2::value_type ValueType;
+
+    const size_t slice_height   = std::max<size_t>(1, dst.slice_height);
+    const size_t sorting_window = std::max<size_t>(1, dst.sorting_window);
+
+    dst.slice_height   = slice_height;
+    dst.sorting_window = sorting_window;
+
+    const size_t num_slices = (src.num_rows + slice_height - 1) / slice_height;
+
+    cusp::array1d<IndexType,cusp::host_memory> row_lengths(src.num_rows);
     for(size_t i = 0; i < src.num_rows; i++)
+        row_lengths[i] = src.row_offsets[i + 1] - src.row_offsets[i];
+
+    // sort the rows by decreasing length within each window
+    cusp::array1d<IndexType,cusp::host_memory> permutation(src.num_rows);
+    for(size_t i = 0; i < src.num_rows; i++)
+        permutation[i] = i;
+
+    for(size_t base = 0; base < src.num_rows; base += sorting_window)
+        std::stable_sort(permutation.begin() + base,
+                         permutation.begin() + std::min(base + sorting_window, size_t(src.num_rows)),
+                         sell_row_length_greater< cusp::array1d<IndexType,cusp::host_memory> >(row_lengths));
+
+    // each slice is as wide as its longest row
+    cusp::array1d<IndexType,cusp::host_memory> slice_offsets(num_slices + 1);
+    slice_offsets[0] = 0;
+
+    for(size_t s = 0; s < num_slices; s++)
     {
-        size_t n = 0;
-        IndexType jj = src.row_offsets[i];
+        IndexType width = 0;
+        for(size_t p = s * slice_height; p < std::min((s + 1) * slice_height, size_t(src.num_rows)); p++)
+            width = std::max(width, row_lengths[permutation[p]]);
+
+        slice_offsets[s + 1] = slice_offsets[s] + width * IndexType(slice_height);
+    }
+
+    dst.resize(src.num_rows, src.num_cols, src.num_entries, slice_offsets[num_slices]);
+
+    const IndexType invalid_index = Matrix2::invalid_index;
 
-        // copy up to num_cols_per_row values of row i into the ELL
-        while(jj < src.row_offsets[i+1] && n < num_entries_per_row)
+    // pad out SELL format with zeros
+    thrust::fill(dst.column_indices.begin(), dst.column_indices.end(), invalid_index);
+    thrust::fill(dst.values.begin(),         dst.values.end(),         ValueType(0));
+
+    for(size_t p = 0; p < src.num_rows; p++)
+    {
+        const IndexType i = permutation[p];
+
+        IndexType offset = slice_offsets[p / slice_height] + (p % slice_height);
+
+        for(OffsetType jj = src.row_offsets[i]; jj < src.row_offsets[i + 1]; jj++)
         {
-            dst.column_indices(i,n) = src.column_indices[jj];
-            dst.values(i,n)         = src.values[jj];
-            jj++, n++;
+            dst.column_indices[offset] = src.column_indices[jj];
+            dst.values[offset]         = src.values[jj];
+            offset += slice_height;
         }
     }
+
+    dst.slice_offsets.swap(slice_offsets);
+    dst.row_permutation.swap(permutation);
+}
+
+template <typename Matrix1, typename Matrix2>
+void csr_to_bsr(const Matrix1& src, Matrix2& dst)
+{
+    typedef typename Matrix2::index_type IndexType;
+    typedef typename cusp::detail::offset_type<Matrix1>::type OffsetType;
+    typedef typename Matrix2::value_type ValueType;
+
+    const size_t block_size = std::max<size_t>(1, dst.block_size);
+
+    if (src.num_rows % block_size != 0 || src.num_cols % block_size != 0)
+        throw cusp::format_conversion_exception("bsr_matrix dimensions must be multiples of the block size");
+
+    dst.block_size = block_size;
+
+    const size_t num_block_rows = src.num_rows / block_size;
+    const size_t num_block_cols = src.num_cols / block_size;
+
+    // marker[j] is the last block row which contains block column j
+    cusp::array1d<IndexType,cusp::host_memory> marker(num_block_cols, IndexType(-1));
+
+    // count the blocks of each block row
+    cusp::array1d<IndexType,cusp::host_memory> row_offsets(num_block_rows + 1);
+    row_offsets[0] = 0;
+
+    for(size_t bi = 0; bi < num_block_rows; bi++)
+    {
+        IndexType num_blocks = 0;
+
+        for(size_t i = bi * block_size; i < (bi + 1) * block_size; i++)
+        {
+            for(OffsetType jj = src.row_offsets[i]; jj < src.row_offsets[i + 1]; jj++)
+            {
+                const IndexType bj = src.column_indices[jj] / block_size;
+
+                if (marker[bj] != IndexType(bi))
+                {
+                    marker[bj] = bi;
+                    num_blocks++;
+                }
+            }
+        }
+
+        row_offsets[bi + 1] = row_offsets[bi] + num_blocks;
+    }
+
+    dst.resize(src.num_rows, src.num_cols, row_offsets[num_block_rows]);
+
+    thrust::fill(dst.values.begin(), dst.values.end(), ValueType(0));
+    thrust::fill(marker.begin(),     marker.end(),     IndexType(-1));
+
+    // position[j] is the index of block column j in the current block row
+    cusp::array1d<IndexType,cusp::host_memory> position(num_block_cols);
+
+    for(size_t bi = 0; bi < num_block_rows; bi++)
+    {
+        IndexType n = row_offsets[bi];
+
+        for(size_t i = bi * block_size; i < (bi + 1) * block_size; i++)
+        {
+            for(OffsetType jj = src.row_offsets[i]; jj < src.row_offsets[i + 1]; jj++)
+            {
+                const IndexType bj = src.column_indices[jj] / block_size;
+
+                if (marker[bj] != IndexType(bi))
+                {
+                    marker[bj] = bi;
+                    dst.column_indices[n++] = bj;
+                }
+            }
+        }
+
+        std::sort(dst.column_indices.begin() + row_offsets[bi], dst.column_indices.begin() + row_offsets[bi + 1]);
+
+        for(IndexType k = row_offsets[bi]; k < row_offsets[bi + 1]; k++)
+            position[dst.column_indices[k]] = k;
+
+        for(size_t i = bi * block_size; i < (bi + 1) * block_size; i++)
+        {
+            for(OffsetType jj = src.row_offsets[i]; jj < src.row_offsets[i + 1]; jj++)
+            {
+                const IndexType j = src.column_indices[jj];
+                const IndexType k = position[j / block_size];
+
+                dst.values[(k * block_size + (i % block_size)) * block_size + (j % block_size)] = src.values[jj];
+            }
+        }
+    }
+
+    dst.row_offsets.swap(row_offsets);
+}
+
+template <typename Matrix1, typename Matrix2>
+void csr_to_csr16(const Matrix1& src, Matrix2& dst)
+{
+    typedef typename Matrix2::index_type         IndexType;
+    typedef typename Matrix2::column_offset_type OffsetType;
+
+    dst.resize(src.num_rows, src.num_cols, src.num_entries);
+
+    for(size_t i = 0; i < src.num_rows; i++)
+    {
+        dst.row_offsets[i] = src.row_offsets[i];
+
+        for(IndexType jj = src.row_offsets[i]; jj < src.row_offsets[i + 1]; jj++)
+        {
+            const long offset = long(src.column_indices[jj]) - long(i);
+
+            if (offset < Matrix2::min_column_offset || offset > Matrix2::max_column_offset)
+                throw cusp::format_conversion_exception("csr16_matrix column offsets must fit in 16 bits");
+
+            dst.column_offsets[jj] = static_cast<OffsetType>(offset);
+            dst.values[jj]         = src.values[jj];
+        }
+    }
+
+    dst.row_offsets[src.num_rows] = src.row_offsets[src.num_rows];
 }
 
     
@@ -274,15 +708,27 @@ template <typename Matrix1, typename Matrix2>
 void csr_to_array2d(const Matrix1& src, Matrix2& dst)
 {
     typedef typename Matrix2::index_type IndexType;
+    typedef typename cusp::detail::offset_type<Matrix1>::type OffsetType;
     typedef typename Matrix2::value_type ValueType;
 
     dst.resize(src.num_rows, src.num_cols);
 
     thrust::fill(dst.values.begin(), dst.values.end(), ValueType(0));
 
-    for(size_t i = 0; i < src.num_rows; i++)
-        for(IndexType jj = src.row_offsets[i]; jj < src.row_offsets[i+1]; jj++)
-            dst(i, src.column_indices[jj]) += src.values[jj]; //sum duplicates
+    const int P = cusp::detail::host::num_parts(src.num_rows + src.num_entries);
+
+    // rows are owned by one thread, so duplicates are summed without races
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(static) num_threads(P)
+#endif
+    for(int part = 0; part < P; part++)
+    {
+        const size_t i_end = balanced_split(src.row_offsets, src.num_rows, part + 1, P);
+
+        for(size_t i = balanced_split(src.row_offsets, src.num_rows, part, P); i < i_end; i++)
+            for(OffsetType jj = src.row_offsets[i]; jj < src.row_offsets[i+1]; jj++)
+                dst(i, src.column_indices[jj]) += src.values[jj]; //sum duplicates
+    }
 }
 
 
@@ -507,7 +953,136 @@ void hyb_to_csr(const Matrix1& src, Matrix2& dst)
 }
 
 
-/////////////////////////
+///////////////////////
+// SELL Conversions //
+/////////////////////
+
+template <typename Matrix1, typename Matrix2>
+void sell_to_csr(const Matrix1& src, Matrix2& dst)
+{
+    typedef typename Matrix2::index_type IndexType;
+    typedef typename Matrix2::value_type ValueType;
+
+    const IndexType invalid_index = Matrix1::invalid_index;
+
+    const size_t slice_height = src.slice_height;
+
+    dst.resize(src.num_rows, src.num_cols, src.num_entries);
+
+    // count the entries of each row
+    thrust::fill(dst.row_offsets.begin(), dst.row_offsets.end(), IndexType(0));
+
+    for(size_t p = 0; p < src.num_rows; p++)
+    {
+        const size_t s = p / slice_height;
+
+        IndexType n = 0;
+        for(IndexType offset = src.slice_offsets[s] + (p % slice_height); offset < src.slice_offsets[s + 1]; offset += slice_height)
+            if (src.column_indices[offset] != invalid_index)
+                n++;
+
+        dst.row_offsets[src.row_permutation[p] + 1] = n;
+    }
+
+    for(size_t i = 0; i < src.num_rows; i++)
+        dst.row_offsets[i + 1] += dst.row_offsets[i];
+
+    // copy the entries in the original row order
+    for(size_t p = 0; p < src.num_rows; p++)
+    {
+        const size_t s = p / slice_height;
+
+        IndexType jj = dst.row_offsets[src.row_permutation[p]];
+
+        for(IndexType offset = src.slice_offsets[s] + (p % slice_height); offset < src.slice_offsets[s + 1]; offset += slice_height)
+        {
+            if (src.column_indices[offset] != invalid_index)
+            {
+                dst.column_indices[jj] = src.column_indices[offset];
+                dst.values[jj]         = src.values[offset];
+                jj++;
+            }
+        }
+    }
+}
+
+
+/////////////////////
+// BSR Conversions //
+/////////////////////
+
+template <typename Matrix1, typename Matrix2>
+void bsr_to_csr(const Matrix1& src, Matrix2& dst)
+{
+    typedef typename Matrix2::index_type IndexType;
+
+    const size_t block_size     = src.block_size;
+    const size_t num_block_rows = src.num_block_rows();
+
+    dst.resize(src.num_rows, src.num_cols, src.num_blocks() * block_size * block_size);
+
+    // every row of a block row has the same length
+    dst.row_offsets[0] = 0;
+
+    for(size_t bi = 0; bi < num_block_rows; bi++)
+    {
+        const IndexType row_length = block_size * (src.row_offsets[bi + 1] - src.row_offsets[bi]);
+
+        for(size_t r = 0; r < block_size; r++)
+        {
+            const size_t i = bi * block_size + r;
+            dst.row_offsets[i + 1] = dst.row_offsets[i] + row_length;
+        }
+    }
+
+    for(size_t bi = 0; bi < num_block_rows; bi++)
+    {
+        for(size_t r = 0; r < block_size; r++)
+        {
+            IndexType jj = dst.row_offsets[bi * block_size + r];
+
+            for(IndexType k = src.row_offsets[bi]; k < src.row_offsets[bi + 1]; k++)
+            {
+                for(size_t c = 0; c < block_size; c++)
+                {
+                    dst.column_indices[jj] = src.column_indices[k] * block_size + c;
+                    dst.values[jj]         = src.values[(k * block_size + r) * block_size + c];
+                    jj++;
+                }
+            }
+        }
+    }
+}
+
+
+///////////////////////
+// CSR16 Conversions //
+///////////////////////
+
+template <typename Matrix1, typename Matrix2>
+void csr16_to_csr(const Matrix1& src, Matrix2& dst)
+{
+    typedef typename Matrix2::index_type IndexType;
+    typedef typename cusp::detail::offset_type<Matrix1>::type OffsetType;
+
+    dst.resize(src.num_rows, src.num_cols, src.num_entries);
+
+    for(size_t i = 0; i < src.num_rows; i++)
+    {
+        dst.row_offsets[i] = src.row_offsets[i];
+
+        for(OffsetType jj = src.row_offsets[i]; jj < src.row_offsets[i + 1]; jj++)
+        {
+            dst.column_indices[jj] = IndexType(i) + src.column_offsets[jj];
+            dst.values[jj]         = src.values[jj];
+        }
+    }
+
+    dst.row_offsets[src.num_rows] = src.row_offsets[src.num_rows];
+}
+
+
+///////////////////////
 // Array1d Conversions //
 /////////////////////////
 template <typename Matrix1, typename Matrix2>
@@ -44,10 +44,16 @@ namespace host
 //     <- DIA
 //     <- ELL
 //     <- HYB
+//     <- SELL
+//     <- BSR
+//     <- CSR16
 //     <- Array
 // DIA <- CSR
 // ELL <- CSR
 // HYB <- CSR
+// SELL <- CSR
+// BSR <- CSR
+// CSR16 <- CSR
 // Array1d <- Array2d (under restrictions)
 // Array2d <- COO
 //         <- CSR
@@ -114,6 +120,24 @@ void convert(const Matrix1& src, Matrix2& dst,
              cusp::csr_format)
 {    cusp::detail::host::hyb_to_csr(src, dst);    }
 
+template <typename Matrix1, typename Matrix2>
+void convert(const Matrix1& src, Matrix2& dst,
+             cusp::sell_format,
+             cusp::csr_format)
+{    cusp::detail::host::sell_to_csr(src, dst);    }
+
+template <typename Matrix1, typename Matrix2>
+void convert(const Matrix1& src, Matrix2& dst,
+             cusp::bsr_format,
+             cusp::csr_format)
+{    cusp::detail::host::bsr_to_csr(src, dst);    }
+
+template <typename Matrix1, typename Matrix2>
+void convert(const Matrix1& src, Matrix2& dst,
+             cusp::csr16_format,
+             cusp::csr_format)
+{    cusp::detail::host::csr16_to_csr(src, dst);    }
+
 /////////
 // DIA //
 /////////
@@ -208,6 +232,69 @@ void convert(const Matrix1& src, Matrix2& dst,
     cusp::convert(csr, dst);
 }
 
+//////////
+// SELL //
+//////////
+template <typename Matrix1, typename Matrix2>
+void convert(const Matrix1& src, Matrix2& dst,
+             cusp::csr_format,
+             cusp::sell_format)
+{    cusp::detail::host::csr_to_sell(src, dst);    }
+
+template <typename Matrix1, typename Matrix2>
+void convert(const Matrix1& src, Matrix2& dst,
+             cusp::sparse_format,
+             cusp::sell_format)
+{
+    typedef typename Matrix1::index_type IndexType;
+    typedef typename Matrix1::value_type ValueType;
+    cusp::csr_matrix<IndexType,ValueType,cusp::host_memory> csr;
+    cusp::convert(src, csr);
+    cusp::convert(csr, dst);
+}
+
+/////////
+// BSR //
+/////////
+template <typename Matrix1, typename Matrix2>
+void convert(const Matrix1& src, Matrix2& dst,
+             cusp::csr_format,
+             cusp::bsr_format)
+{    cusp::detail::host::csr_to_bsr(src, dst);    }
+
+template <typename Matrix1, typename Matrix2>
+void convert(const Matrix1& src, Matrix2& dst,
+             cusp::sparse_format,
+             cusp::bsr_format)
+{
+    typedef typename Matrix1::index_type IndexType;
+    typedef typename Matrix1::value_type ValueType;
+    cusp::csr_matrix<IndexType,ValueType,cusp::host_memory> csr;
+    cusp::convert(src, csr);
+    cusp::convert(csr, dst);
+}
+
+///////////
+// CSR16 //
+///////////
+template <typename Matrix1, typename Matrix2>
+void convert(const Matrix1& src, Matrix2& dst,
+             cusp::csr_format,
+             cusp::csr16_format)
+{    cusp::detail::host::csr_to_csr16(src, dst);    }
+
+template <typename Matrix1, typename Matrix2>
+void convert(const Matrix1& src, Matrix2& dst,
+             cusp::sparse_format,
+             cusp::csr16_format)
+{
+    typedef typename Matrix1::index_type IndexType;
+    typedef typename Matrix1::value_type ValueType;
+    cusp::csr_matrix<IndexType,ValueType,cusp::host_memory> csr;
+    cusp::convert(src, csr);
+    cusp::convert(csr, dst);
+}
+
 /////////////
 // Array1d //
 /////////////
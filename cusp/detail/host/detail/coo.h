@@ -46,24 +46,15 @@ void spmm_coo(const Matrix1& A,
     cusp::detail::indices_to_offsets(A.row_indices, A_row_offsets);
     cusp::detail::indices_to_offsets(B.row_indices, B_row_offsets);
     
-    typedef typename Matrix3::index_type IndexType;
-    
-    IndexType estimated_nonzeros = 
-        spmm_csr_pass1(A.num_rows, B.num_cols,
-                       A_row_offsets, A.column_indices,
-                       B_row_offsets, B.column_indices);
-                         
-    // Resize output
-    C.resize(A.num_rows, B.num_cols, estimated_nonzeros);
-    
-    IndexType true_nonzeros =
-        spmm_csr_pass2(A.num_rows, B.num_cols,
-                       A_row_offsets, A.column_indices, A.values,
-                       B_row_offsets, B.column_indices, B.values,
-                       C_row_offsets, C.column_indices, C.values);
+    C.resize(A.num_rows, B.num_cols, 0);
+
+    const size_t num_nonzeros =
+        spmm_csr(A.num_rows, B.num_cols,
+                 A_row_offsets, A.column_indices, A.values,
+                 B_row_offsets, B.column_indices, B.values,
+                 C_row_offsets, C.column_indices, C.values);
 
-    // true_nonzeros may be less than estimated_nonzeros
-    C.resize(A.num_rows, B.num_cols, true_nonzeros);
+    C.resize(A.num_rows, B.num_cols, num_nonzeros);
 
     cusp::detail::offsets_to_indices(C_row_offsets, C.row_indices);
 }
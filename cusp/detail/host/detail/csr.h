@@ -17,6 +17,15 @@
 #pragma once
 
 #include <cusp/array1d.h>
+#include <cusp/exception.h>
+
+#include <cusp/detail/masked_product.h>
+#include <cusp/detail/host/parallel.h>
+
+#include <thrust/copy.h>
+#include <thrust/fill.h>
+
+#include <algorithm>
 
 namespace cusp
 {
@@ -109,121 +118,490 @@ void csr_transform_elementwise(const Matrix1& A,
 } // csr_transform_elementwise
 
 
-template <typename Array1, typename Array2,
-          typename Array3, typename Array4>
-size_t spmm_csr_pass1(const size_t num_rows, const size_t num_cols,
-                         const Array1& A_row_offsets, const Array2& A_column_indices,
-                         const Array3& B_row_offsets, const Array4& B_column_indices)
+// C = alpha * A + beta * B for matrices with sorted column indices by
+// merging the rows of A and B.  The pattern of C is the union of the
+// patterns of A and B, including entries whose values cancel, so with
+// reuse_pattern only the values of an existing C are recomputed.
+template <typename Matrix1,
+          typename Matrix2,
+          typename Matrix3,
+          typename ScalarType>
+void csr_add(const ScalarType alpha, const Matrix1& A,
+             const ScalarType beta,  const Matrix2& B,
+                   Matrix3& C, const bool reuse_pattern)
 {
-    typedef typename Array1::value_type IndexType1;
-    typedef typename Array2::value_type IndexType2;
-    
-    cusp::array1d<size_t, cusp::host_memory> mask(num_cols, static_cast<size_t>(-1));
+    typedef typename Matrix1::index_type IndexType1;
+    typedef typename Matrix2::index_type IndexType2;
+    typedef typename Matrix3::index_type IndexType3;
+    typedef typename Matrix3::value_type ValueType;
 
-    // Compute nnz in C (including explicit zeros)
-    size_t num_nonzeros = 0;
+    if (reuse_pattern)
+    {
+        if (C.num_rows != A.num_rows || C.num_cols != A.num_cols)
+            throw cusp::invalid_input_exception("pattern of C does not match A and B");
+    }
+    else
+    {
+        // count the entries of each row of C
+        C.resize(A.num_rows, A.num_cols, 0);
+
+        size_t num_entries = 0;
 
-    for(size_t i = 0; i < num_rows; i++)
+        C.row_offsets[0] = 0;
+
+        for(size_t i = 0; i < A.num_rows; i++)
+        {
+            IndexType1 a = A.row_offsets[i], a_end = A.row_offsets[i + 1];
+            IndexType2 b = B.row_offsets[i], b_end = B.row_offsets[i + 1];
+
+            while (a < a_end && b < b_end)
+            {
+                const IndexType1 ja = A.column_indices[a];
+                const IndexType2 jb = B.column_indices[b];
+
+                if (ja <= jb) a++;
+                if (jb <= ja) b++;
+
+                num_entries++;
+            }
+
+            num_entries += (a_end - a) + (b_end - b);
+
+            C.row_offsets[i + 1] = num_entries;
+        }
+
+        C.resize(A.num_rows, A.num_cols, num_entries);
+    }
+
+    for(size_t i = 0; i < A.num_rows; i++)
     {
-        for(IndexType1 jj = A_row_offsets[i]; jj < A_row_offsets[i+1]; jj++)
+        IndexType1 a = A.row_offsets[i], a_end = A.row_offsets[i + 1];
+        IndexType2 b = B.row_offsets[i], b_end = B.row_offsets[i + 1];
+        IndexType3 k = C.row_offsets[i];
+
+        while (a < a_end || b < b_end)
         {
-            IndexType1 j = A_column_indices[jj];
+            IndexType3 j;
+            ValueType value;
 
-            for(IndexType2 kk = B_row_offsets[j]; kk < B_row_offsets[j+1]; kk++)
+            if (b == b_end || (a < a_end && A.column_indices[a] < B.column_indices[b]))
+            {
+                j = A.column_indices[a];
+                value = ValueType(alpha) * ValueType(A.values[a++]);
+            }
+            else if (a == a_end || B.column_indices[b] < A.column_indices[a])
             {
-                IndexType2 k = B_column_indices[kk];
+                j = B.column_indices[b];
+                value = ValueType(beta) * ValueType(B.values[b++]);
+            }
+            else
+            {
+                j = A.column_indices[a];
+                value = ValueType(alpha) * ValueType(A.values[a++]) + ValueType(beta) * ValueType(B.values[b++]);
+            }
+
+            if (!reuse_pattern)
+                C.column_indices[k] = j;
+
+            C.values[k++] = value;
+        }
+    }
+} // csr_add
+
+
+// The sparse matrix-matrix product C = A * B is computed by rows, in two
+// passes over the rows of A.  The symbolic pass counts the distinct
+// columns of every row of C, which bounds its number of entries, and the
+// numeric pass writes the row at the offset given by these counts,
+// dropping the entries which cancel to zero.  The rows are split into
+// blocks of equal numbers of products, so that the threads are balanced
+// even when a few rows of A hit the long rows of B.
+//
+// Each thread accumulates its rows in an accumulator of its own.  The
+// dense accumulator keeps a value and a link for every column of C, the
+// columns of the current row forming a list; the hash accumulator keeps a
+// table sized for the products of the row, for products with many
+// columns of which each row touches only a few.
+
+// rows touching less than 1/16th of the columns use the hash accumulator
+// once C has more columns than this
+const size_t spmm_dense_columns_limit = 65536;
+
+template <typename IndexType, typename ValueType>
+class spmm_dense_accumulator
+{
+    cusp::array1d<IndexType,cusp::host_memory> next;
+    cusp::array1d<ValueType,cusp::host_memory> sums;
+    IndexType head;
+    IndexType length;
+
+    static IndexType unseen(void) { return static_cast<IndexType>(-1); }
+    static IndexType init(void)   { return static_cast<IndexType>(-2); }
+
+    public:
+
+    spmm_dense_accumulator(const size_t num_cols)
+        : next(num_cols, unseen()), sums(num_cols, ValueType(0)), head(init()), length(0) {}
+
+    void reserve(const size_t) {}
+
+    void insert(const IndexType k)
+    {
+        if (next[k] == unseen())
+        {
+            next[k] = head;
+            head = k;
+            length++;
+        }
+    }
+
+    void add(const IndexType k, const ValueType v)
+    {
+        sums[k] += v;
+        insert(k);
+    }
 
-                if(mask[k] != i)
-                {
-                    mask[k] = i;                        
-                    num_nonzeros++;
-                }
+    size_t size(void) const { return length; }
+
+    // forget the columns of the row
+    void clear(void)
+    {
+        for (IndexType n = 0; n < length; n++)
+        {
+            const IndexType k = head;
+            head = next[k];
+            next[k] = unseen();
+            sums[k] = ValueType(0);
+        }
+
+        head = init();
+        length = 0;
+    }
+
+    // write the nonzero entries of the row and forget it
+    template <typename Array1, typename Array2>
+    size_t flush(Array1& column_indices, Array2& values, size_t offset)
+    {
+        const size_t start = offset;
+
+        for (IndexType n = 0; n < length; n++)
+        {
+            const IndexType k = head;
+
+            if (sums[k] != ValueType(0))
+            {
+                column_indices[offset] = k;
+                values[offset]         = sums[k];
+                offset++;
             }
+
+            head = next[k];
+            next[k] = unseen();
+            sums[k] = ValueType(0);
         }
+
+        head = init();
+        length = 0;
+
+        return offset - start;
     }
+};
 
-    return num_nonzeros;
+template <typename IndexType, typename ValueType>
+class spmm_hash_accumulator
+{
+    cusp::array1d<IndexType,cusp::host_memory> keys;
+    cusp::array1d<ValueType,cusp::host_memory> sums;
+    cusp::array1d<size_t,cusp::host_memory>    used;
+    size_t length;
+
+    static IndexType empty(void) { return static_cast<IndexType>(-1); }
+
+    size_t find(const IndexType k) const
+    {
+        const size_t mask = keys.size() - 1;
+
+        size_t slot = (size_t(k) * 2654435761u) & mask;
+
+        while (keys[slot] != k && keys[slot] != empty())
+            slot = (slot + 1) & mask;
+
+        return slot;
+    }
+
+    public:
+
+    spmm_hash_accumulator(const size_t) : length(0) {}
+
+    // room for a row of at most n columns, with a load below one half
+    void reserve(const size_t n)
+    {
+        size_t capacity = 16;
+        while (capacity < 2 * n)
+            capacity *= 2;
+
+        if (capacity > keys.size())
+        {
+            keys.resize(capacity);
+            sums.resize(capacity);
+            used.resize(capacity / 2);
+
+            thrust::fill(keys.begin(), keys.end(), empty());
+            thrust::fill(sums.begin(), sums.end(), ValueType(0));
+        }
+    }
+
+    void insert(const IndexType k)
+    {
+        const size_t slot = find(k);
+
+        if (keys[slot] == empty())
+        {
+            keys[slot] = k;
+            used[length++] = slot;
+        }
+    }
+
+    void add(const IndexType k, const ValueType v)
+    {
+        const size_t slot = find(k);
+
+        if (keys[slot] == empty())
+        {
+            keys[slot] = k;
+            used[length++] = slot;
+        }
+
+        sums[slot] += v;
+    }
+
+    size_t size(void) const { return length; }
+
+    void clear(void)
+    {
+        for (size_t n = 0; n < length; n++)
+        {
+            keys[used[n]] = empty();
+            sums[used[n]] = ValueType(0);
+        }
+
+        length = 0;
+    }
+
+    template <typename Array1, typename Array2>
+    size_t flush(Array1& column_indices, Array2& values, size_t offset)
+    {
+        const size_t start = offset;
+
+        for (size_t n = 0; n < length; n++)
+        {
+            const size_t slot = used[n];
+
+            if (sums[slot] != ValueType(0))
+            {
+                column_indices[offset] = keys[slot];
+                values[offset]         = sums[slot];
+                offset++;
+            }
+
+            keys[slot] = empty();
+            sums[slot] = ValueType(0);
+        }
+
+        length = 0;
+
+        return offset - start;
+    }
+};
+
+// row_nnz[i] <- number of distinct columns of row i of A * B
+template <typename Accumulator, typename Array1, typename Array2, typename Array3, typename Array4, typename Array5>
+void spmm_csr_symbolic(const size_t num_rows, const size_t num_cols,
+                       const Array1& A_row_offsets, const Array2& A_column_indices,
+                       const Array3& B_row_offsets, const Array4& B_column_indices,
+                       const Array5& flops, Array5& row_nnz, const int P)
+{
+    typedef typename Array1::value_type IndexType1;
+    typedef typename Array3::value_type IndexType2;
+
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(static) num_threads(P)
+#endif
+    for (int part = 0; part < P; part++)
+    {
+        Accumulator acc(num_cols);
+
+        const size_t i_end = balanced_split(flops, num_rows, part + 1, P);
+
+        for (size_t i = balanced_split(flops, num_rows, part, P); i < i_end; i++)
+        {
+            acc.reserve(flops[i + 1] - flops[i]);
+
+            for (IndexType1 jj = A_row_offsets[i]; jj < A_row_offsets[i + 1]; jj++)
+            {
+                const IndexType1 j = A_column_indices[jj];
+
+                for (IndexType2 kk = B_row_offsets[j]; kk < B_row_offsets[j + 1]; kk++)
+                    acc.insert(B_column_indices[kk]);
+            }
+
+            row_nnz[i] = acc.size();
+            acc.clear();
+        }
+    }
 }
 
-template <typename Array1, typename Array2, typename Array3,
+// the entries of row i of A * B at C_row_offsets[i], row_nnz[i] <- their number
+template <typename Accumulator,
+          typename Array1, typename Array2, typename Array3,
           typename Array4, typename Array5, typename Array6,
-          typename Array7, typename Array8, typename Array9>
-size_t spmm_csr_pass2(const size_t num_rows, const size_t num_cols,
-                         const Array1& A_row_offsets, const Array2& A_column_indices, const Array3& A_values,
-                         const Array4& B_row_offsets, const Array5& B_column_indices, const Array6& B_values,
-                               Array7& C_row_offsets,       Array8& C_column_indices,       Array9& C_values)
+          typename Array7, typename Array8, typename Array9, typename Array10>
+void spmm_csr_numeric(const size_t num_rows, const size_t num_cols,
+                      const Array1& A_row_offsets, const Array2& A_column_indices, const Array3& A_values,
+                      const Array4& B_row_offsets, const Array5& B_column_indices, const Array6& B_values,
+                      const Array7& C_row_offsets, Array8& C_column_indices, Array9& C_values,
+                      const Array10& flops, Array10& row_nnz, const int P)
 {
-    typedef typename Array7::value_type IndexType;
+    typedef typename Array1::value_type IndexType1;
+    typedef typename Array4::value_type IndexType2;
     typedef typename Array9::value_type ValueType;
 
-    size_t num_nonzeros = 0;
-
-    const IndexType unseen = static_cast<IndexType>(-1);
-    const IndexType init   = static_cast<IndexType>(-2);  
-
-    // Compute entries of C
-    cusp::array1d<IndexType,cusp::host_memory> next(num_cols, unseen);
-    cusp::array1d<ValueType,cusp::host_memory> sums(num_cols, ValueType(0));
-    
-    num_nonzeros = 0;
-    
-    C_row_offsets[0] = 0;
-    
-    for(size_t i = 0; i < num_rows; i++)
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(static) num_threads(P)
+#endif
+    for (int part = 0; part < P; part++)
     {
-        IndexType head   = init;
-        IndexType length =    0;
-    
-        IndexType jj_start = A_row_offsets[i];
-        IndexType jj_end   = A_row_offsets[i+1];
+        Accumulator acc(num_cols);
 
-        for(IndexType jj = jj_start; jj < jj_end; jj++)
+        const size_t i_end = balanced_split(flops, num_rows, part + 1, P);
+
+        for (size_t i = balanced_split(flops, num_rows, part, P); i < i_end; i++)
         {
-            IndexType j = A_column_indices[jj];
-            ValueType v = A_values[jj];
-    
-            IndexType kk_start = B_row_offsets[j];
-            IndexType kk_end   = B_row_offsets[j+1];
+            acc.reserve(flops[i + 1] - flops[i]);
 
-            for(IndexType kk = kk_start; kk < kk_end; kk++)
+            for (IndexType1 jj = A_row_offsets[i]; jj < A_row_offsets[i + 1]; jj++)
             {
-                IndexType k = B_column_indices[kk];
-    
-                sums[k] += v * B_values[kk];
-    
-                if(next[k] == unseen)
-                {
-                    next[k] = head;                        
-                    head  = k;
-                    length++;
-                }
+                const IndexType1 j = A_column_indices[jj];
+                const ValueType  v = A_values[jj];
+
+                for (IndexType2 kk = B_row_offsets[j]; kk < B_row_offsets[j + 1]; kk++)
+                    acc.add(B_column_indices[kk], v * B_values[kk]);
             }
+
+            row_nnz[i] = acc.flush(C_column_indices, C_values, C_row_offsets[i]);
         }
-    
-        for(IndexType jj = 0; jj < length; jj++)
+    }
+}
+
+template <typename Accumulator,
+          typename Array1, typename Array2, typename Array3,
+          typename Array4, typename Array5, typename Array6,
+          typename Array7, typename Array8, typename Array9, typename Array10>
+size_t spmm_csr(const size_t num_rows, const size_t num_cols,
+                const Array1& A_row_offsets, const Array2& A_column_indices, const Array3& A_values,
+                const Array4& B_row_offsets, const Array5& B_column_indices, const Array6& B_values,
+                      Array7& C_row_offsets,       Array8& C_column_indices,       Array9& C_values,
+                const Array10& flops, const int P)
+{
+    typedef typename Array7::value_type IndexType;
+
+    Array10 row_nnz(num_rows);
+
+    spmm_csr_symbolic<Accumulator>(num_rows, num_cols,
+                                   A_row_offsets, A_column_indices,
+                                   B_row_offsets, B_column_indices,
+                                   flops, row_nnz, P);
+
+    // room for every distinct column, including the entries which cancel
+    C_row_offsets[0] = 0;
+    for (size_t i = 0; i < num_rows; i++)
+        C_row_offsets[i + 1] = C_row_offsets[i] + IndexType(row_nnz[i]);
+
+    C_column_indices.resize(C_row_offsets[num_rows]);
+    C_values.resize(C_row_offsets[num_rows]);
+
+    spmm_csr_numeric<Accumulator>(num_rows, num_cols,
+                                  A_row_offsets, A_column_indices, A_values,
+                                  B_row_offsets, B_column_indices, B_values,
+                                  C_row_offsets, C_column_indices, C_values,
+                                  flops, row_nnz, P);
+
+    // move the rows up over the room of the cancelled entries, which is
+    // rare enough for a serial pass
+    size_t num_nonzeros = 0;
+
+    for (size_t i = 0; i < num_rows; i++)
+    {
+        const size_t start = C_row_offsets[i];
+
+        if (start != num_nonzeros)
         {
-            if(sums[head] != ValueType(0))
+            for (size_t n = 0; n < row_nnz[i]; n++)
             {
-                C_column_indices[num_nonzeros] = head;
-                C_values[num_nonzeros]         = sums[head];
-                num_nonzeros++;
+                C_column_indices[num_nonzeros + n] = C_column_indices[start + n];
+                C_values[num_nonzeros + n]         = C_values[start + n];
             }
-    
-            IndexType temp = head; head = next[head];
-    
-            // clear arrays
-            next[temp] = unseen; 
-            sums[temp] = ValueType(0);                              
         }
-    
-        C_row_offsets[i+1] = num_nonzeros;
+
+        C_row_offsets[i] = num_nonzeros;
+        num_nonzeros += row_nnz[i];
     }
-    
-    // XXX note: entries of C are unsorted within each row
+
+    C_row_offsets[num_rows] = num_nonzeros;
 
     return num_nonzeros;
 }
 
+// C <- A * B with the row offsets of A and B given, returns the number of
+// entries of C
+template <typename Array1, typename Array2, typename Array3,
+          typename Array4, typename Array5, typename Array6,
+          typename Array7, typename Array8, typename Array9>
+size_t spmm_csr(const size_t num_rows, const size_t num_cols,
+                const Array1& A_row_offsets, const Array2& A_column_indices, const Array3& A_values,
+                const Array4& B_row_offsets, const Array5& B_column_indices, const Array6& B_values,
+                      Array7& C_row_offsets,       Array8& C_column_indices,       Array9& C_values)
+{
+    typedef typename Array7::value_type IndexType;
+    typedef typename Array9::value_type ValueType;
+    typedef cusp::array1d<size_t,cusp::host_memory> SizeArray;
+
+    // products of each row, as a prefix sum
+    SizeArray flops(num_rows + 1);
+
+    size_t max_row_flops = 0;
+
+    flops[0] = 0;
+    for (size_t i = 0; i < num_rows; i++)
+    {
+        size_t row_flops = 0;
+
+        for (typename Array1::value_type jj = A_row_offsets[i]; jj < A_row_offsets[i + 1]; jj++)
+        {
+            const size_t j = A_column_indices[jj];
+            row_flops += B_row_offsets[j + 1] - B_row_offsets[j];
+        }
+
+        flops[i + 1] = flops[i] + row_flops;
+        max_row_flops = std::max(max_row_flops, row_flops);
+    }
+
+    const int P = cusp::detail::host::num_parts(flops[num_rows]);
+
+    if (num_cols > spmm_dense_columns_limit && 16 * max_row_flops < num_cols)
+        return spmm_csr< spmm_hash_accumulator<IndexType,ValueType> >
+                   (num_rows, num_cols,
+                    A_row_offsets, A_column_indices, A_values,
+                    B_row_offsets, B_column_indices, B_values,
+                    C_row_offsets, C_column_indices, C_values, flops, P);
+    else
+        return spmm_csr< spmm_dense_accumulator<IndexType,ValueType> >
+                   (num_rows, num_cols,
+                    A_row_offsets, A_column_indices, A_values,
+                    B_row_offsets, B_column_indices, B_values,
+                    C_row_offsets, C_column_indices, C_values, flops, P);
+}
+
 template <typename Matrix1,
           typename Matrix2,
           typename Matrix3>
@@ -231,26 +609,66 @@ void spmm_csr(const Matrix1& A,
               const Matrix2& B,
                     Matrix3& C)
 {
-    typedef typename Matrix3::index_type IndexType;
+    C.resize(A.num_rows, B.num_cols, 0);
 
-    IndexType num_nonzeros = 
-        spmm_csr_pass1(A.num_rows, B.num_cols,
-                       A.row_offsets, A.column_indices,
-                       B.row_offsets, B.column_indices);
-                         
-    // Resize output
-    C.resize(A.num_rows, B.num_cols, num_nonzeros);
-    
-    num_nonzeros =
-      spmm_csr_pass2(A.num_rows, B.num_cols,
-                     A.row_offsets, A.column_indices, A.values,
-                     B.row_offsets, B.column_indices, B.values,
-                     C.row_offsets, C.column_indices, C.values);
+    const size_t num_nonzeros =
+      spmm_csr(A.num_rows, B.num_cols,
+               A.row_offsets, A.column_indices, A.values,
+               B.row_offsets, B.column_indices, B.values,
+               C.row_offsets, C.column_indices, C.values);
 
-    // Resize output again since pass2 omits explict zeros
+    // XXX note: entries of C are unsorted within each row
     C.resize(A.num_rows, B.num_cols, num_nonzeros);
 }
 
+// C = (A * B) restricted to the pattern of M, which C takes.  The columns
+// of B and M must be sorted within each row.  Rows are split by the
+// entries of A, whose rows of B are intersected with the mask.
+template <typename Matrix1,
+          typename Matrix2,
+          typename Matrix3,
+          typename Matrix4>
+void masked_spmm_csr(const Matrix1& A,
+                     const Matrix2& B,
+                     const Matrix3& M,
+                           Matrix4& C)
+{
+    typedef typename Matrix4::index_type IndexType;
+    typedef typename Matrix4::value_type ValueType;
+
+    C.resize(M.num_rows, M.num_cols, M.num_entries);
+
+    thrust::copy(M.row_offsets.begin(), M.row_offsets.end(), C.row_offsets.begin());
+    thrust::copy(M.column_indices.begin(), M.column_indices.end(), C.column_indices.begin());
+
+    if (C.num_entries == 0)
+        return;
+
+    if (A.num_entries == 0 || B.num_entries == 0)
+    {
+        thrust::fill(C.values.begin(), C.values.end(), ValueType(0));
+        return;
+    }
+
+    const size_t num_rows = C.num_rows;
+    const int P = num_parts(A.num_entries + C.num_entries);
+
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(static) num_threads(P)
+#endif
+    for (int part = 0; part < P; part++)
+    {
+        const size_t i_end = balanced_split(A.row_offsets, num_rows, part + 1, P);
+
+        for (size_t i = balanced_split(A.row_offsets, num_rows, part, P); i < i_end; i++)
+            cusp::detail::masked_row_product(IndexType(i),
+                                             &A.row_offsets[0], &A.column_indices[0], &A.values[0],
+                                             &B.row_offsets[0], &B.column_indices[0], &B.values[0],
+                                             &C.row_offsets[0], &C.column_indices[0],
+                                             &C.values[0]);
+    }
+}
+
 } // end namespace detail
 } // end namespace host
 } // end namespace detail
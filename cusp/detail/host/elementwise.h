@@ -32,6 +32,17 @@ void transform_elementwise(const Matrix1& A,
                                  Matrix3& C,
                                  BinaryFunction op);
 
+template <typename ScalarType,
+          typename Matrix1,
+          typename Matrix2,
+          typename Matrix3>
+void add(const ScalarType alpha,
+         const Matrix1& A,
+         const ScalarType beta,
+         const Matrix2& B,
+               Matrix3& C,
+         const bool reuse_pattern);
+
 } // end namespace host
 } // end namespace detail
 } // end namespace cusp
@@ -17,6 +17,7 @@
 #pragma once
 
 #include <cusp/format.h>
+#include <cusp/conversion_cache.h>
 #include <cusp/csr_matrix.h>
 #include <cusp/detail/host/detail/csr.h>
 
@@ -69,6 +70,23 @@ void transform_elementwise(const Matrix1& A,
     cusp::detail::host::detail::csr_transform_elementwise(A, B, C, op); 
 }
 
+template <typename ScalarType,
+          typename Matrix1,
+          typename Matrix2,
+          typename Matrix3>
+void add(const ScalarType alpha,
+         const Matrix1& A,
+         const ScalarType beta,
+         const Matrix2& B,
+               Matrix3& C,
+         const bool reuse_pattern,
+         cusp::csr_format,
+         cusp::csr_format,
+         cusp::csr_format)
+{
+    cusp::detail::host::detail::csr_add(alpha, A, beta, B, C, reuse_pattern);
+}
+
 ///////////
 // Array //
 ///////////
@@ -92,6 +110,29 @@ void transform_elementwise(const Matrix1& A,
             C(i,j) = op(A(i,j), B(i,j));
 }
 
+template <typename ScalarType,
+          typename Matrix1,
+          typename Matrix2,
+          typename Matrix3>
+void add(const ScalarType alpha,
+         const Matrix1& A,
+         const ScalarType beta,
+         const Matrix2& B,
+               Matrix3& C,
+         const bool reuse_pattern,
+         cusp::array2d_format,
+         cusp::array2d_format,
+         cusp::array2d_format)
+{
+    typedef typename Matrix3::value_type ValueType;
+
+    C.resize(A.num_rows, A.num_cols);
+
+    for(size_t i = 0; i < A.num_rows; i++)
+        for(size_t j = 0; j < A.num_cols; j++)
+            C(i,j) = ValueType(alpha) * ValueType(A(i,j)) + ValueType(beta) * ValueType(B(i,j));
+}
+
 /////////////
 // Default //
 /////////////
@@ -115,8 +156,10 @@ void transform_elementwise(const Matrix1& A,
     typedef typename Matrix2::value_type ValueType2;
     typedef typename Matrix3::value_type ValueType3;
 
-    cusp::csr_matrix<IndexType1,ValueType1,cusp::host_memory> A_(A);
-    cusp::csr_matrix<IndexType2,ValueType2,cusp::host_memory> B_(B);
+    cusp::csr_matrix<IndexType1,ValueType1,cusp::host_memory> A_temp;
+    const cusp::csr_matrix<IndexType1,ValueType1,cusp::host_memory>& A_ = cusp::detail::cached_conversion(A, A_temp);
+    cusp::csr_matrix<IndexType2,ValueType2,cusp::host_memory> B_temp;
+    const cusp::csr_matrix<IndexType2,ValueType2,cusp::host_memory>& B_ = cusp::detail::cached_conversion(B, B_temp);
     cusp::csr_matrix<IndexType3,ValueType3,cusp::host_memory> C_;
 
     cusp::detail::host::transform_elementwise(A_, B_, C_, op);
@@ -124,6 +167,39 @@ void transform_elementwise(const Matrix1& A,
     cusp::convert(C_, C);
 }
 
+// the pattern of C is only reused in CSR format
+template <typename ScalarType,
+          typename Matrix1,
+          typename Matrix2,
+          typename Matrix3>
+void add(const ScalarType alpha,
+         const Matrix1& A,
+         const ScalarType beta,
+         const Matrix2& B,
+               Matrix3& C,
+         const bool reuse_pattern,
+         sparse_format,
+         sparse_format,
+         sparse_format)
+{
+    typedef typename Matrix1::index_type IndexType1;
+    typedef typename Matrix2::index_type IndexType2;
+    typedef typename Matrix3::index_type IndexType3;
+    typedef typename Matrix1::value_type ValueType1;
+    typedef typename Matrix2::value_type ValueType2;
+    typedef typename Matrix3::value_type ValueType3;
+
+    cusp::csr_matrix<IndexType1,ValueType1,cusp::host_memory> A_temp;
+    const cusp::csr_matrix<IndexType1,ValueType1,cusp::host_memory>& A_ = cusp::detail::cached_conversion(A, A_temp);
+    cusp::csr_matrix<IndexType2,ValueType2,cusp::host_memory> B_temp;
+    const cusp::csr_matrix<IndexType2,ValueType2,cusp::host_memory>& B_ = cusp::detail::cached_conversion(B, B_temp);
+    cusp::csr_matrix<IndexType3,ValueType3,cusp::host_memory> C_;
+
+    cusp::detail::host::detail::csr_add(alpha, A_, beta, B_, C_, false);
+
+    cusp::convert(C_, C);
+}
+
 } // end namespace dispatch
 
 
@@ -146,6 +222,23 @@ void transform_elementwise(const Matrix1& A,
             typename Matrix3::format());
 }
 
+template <typename ScalarType,
+          typename Matrix1,
+          typename Matrix2,
+          typename Matrix3>
+void add(const ScalarType alpha,
+         const Matrix1& A,
+         const ScalarType beta,
+         const Matrix2& B,
+               Matrix3& C,
+         const bool reuse_pattern)
+{
+    cusp::detail::host::dispatch::add(alpha, A, beta, B, C, reuse_pattern,
+            typename Matrix1::format(),
+            typename Matrix2::format(),
+            typename Matrix3::format());
+}
+
 } // end namespace host
 } // end namespace detail
 } // end namespace cusp
@@ -0,0 +1,534 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+#pragma once
+
+#include <limits>
+#include <string>
+#include <algorithm>
+
+#include <thrust/detail/type_traits.h>
+
+#include <cusp/format.h>
+#include <cusp/array1d.h>
+#include <cusp/array2d.h>
+#include <cusp/exception.h>
+#include <cusp/detail/host/spmv_simd.h>
+
+#include <mkl_spblas.h>
+#include <mkl_types.h>
+#include <mkl_version.h>
+
+// Intel MKL kernels for the host multiply, enabled by defining
+// INTEL_MKL_SPBLAS (scons hostspblas=mkl).  With MKL 2018 or newer the
+// inspector-executor interface provides CSR and COO SpMV, CSR times dense
+// matrix (SpMM) and CSR times CSR (SpGEMM).  Older versions only provide the
+// square CSR and COO SpMV of the mkl_cspblas routines.  Each entry point
+// returns false when MKL does not apply to the arguments (value types other
+// than float and double, strided vectors, empty matrices, or more entries
+// than MKL_INT can index) and the caller uses the cusp kernels instead.
+
+#if INTEL_MKL_VERSION >= 20180000
+#define __CUSP_USE_MKL_INSPECTOR_EXECUTOR__
+#endif
+
+namespace cusp
+{
+namespace detail
+{
+namespace host
+{
+namespace mkl
+{
+
+template <typename T> struct is_mkl_value         : thrust::detail::false_type {};
+template <>           struct is_mkl_value<float>  : thrust::detail::true_type  {};
+template <>           struct is_mkl_value<double> : thrust::detail::true_type  {};
+
+// contiguous arrays of float or double
+template <typename Array, typename ValueType>
+struct is_mkl_array
+{
+  static const bool value = cusp::detail::host::simd::is_contiguous<typename Array::iterator>::value &&
+                            thrust::detail::is_same<typename Array::value_type, ValueType>::value &&
+                            is_mkl_value<ValueType>::value;
+};
+
+// index arrays which MKL reads in place, others are copied to MKL_INT
+template <typename Array>
+struct is_mkl_index_array
+{
+  static const bool value = cusp::detail::host::simd::is_contiguous<typename Array::iterator>::value &&
+                            thrust::detail::is_same<typename Array::value_type, MKL_INT>::value;
+};
+
+inline bool fits(size_t n)
+{
+  return n <= size_t(std::numeric_limits<MKL_INT>::max());
+}
+
+template <typename Array>
+MKL_INT * index_pointer(const Array& a, cusp::array1d<MKL_INT,cusp::host_memory>&, thrust::detail::true_type)
+{
+  return const_cast<MKL_INT *>(cusp::detail::host::simd::host_pointer(a));
+}
+
+template <typename Array>
+MKL_INT * index_pointer(const Array& a, cusp::array1d<MKL_INT,cusp::host_memory>& copy, thrust::detail::false_type)
+{
+  copy = a;
+  return cusp::detail::host::simd::host_pointer(copy);
+}
+
+// pointer to the indices of a, converted into copy when needed
+template <typename Array>
+MKL_INT * index_pointer(const Array& a, cusp::array1d<MKL_INT,cusp::host_memory>& copy)
+{
+  return index_pointer(a, copy, thrust::detail::integral_constant<bool, is_mkl_index_array<Array>::value>());
+}
+
+template <typename Array>
+typename Array::value_type * value_pointer(const Array& a)
+{
+  return const_cast<typename Array::value_type *>(cusp::detail::host::simd::host_pointer(a));
+}
+
+#ifdef __CUSP_USE_MKL_INSPECTOR_EXECUTOR__
+
+inline void check(sparse_status_t status, const char * routine)
+{
+  if (status != SPARSE_STATUS_SUCCESS)
+    throw cusp::runtime_exception(std::string("MKL ") + routine + " failed");
+}
+
+inline struct matrix_descr general_descr(void)
+{
+  struct matrix_descr descr;
+  descr.type = SPARSE_MATRIX_TYPE_GENERAL;
+  descr.mode = SPARSE_FILL_MODE_FULL;
+  descr.diag = SPARSE_DIAG_NON_UNIT;
+  return descr;
+}
+
+inline sparse_status_t create_csr(sparse_matrix_t * A, MKL_INT m, MKL_INT n, MKL_INT * rows_start, MKL_INT * rows_end, MKL_INT * col_indx, float * values)
+{
+  return mkl_sparse_s_create_csr(A, SPARSE_INDEX_BASE_ZERO, m, n, rows_start, rows_end, col_indx, values);
+}
+
+inline sparse_status_t create_csr(sparse_matrix_t * A, MKL_INT m, MKL_INT n, MKL_INT * rows_start, MKL_INT * rows_end, MKL_INT * col_indx, double * values)
+{
+  return mkl_sparse_d_create_csr(A, SPARSE_INDEX_BASE_ZERO, m, n, rows_start, rows_end, col_indx, values);
+}
+
+inline sparse_status_t create_coo(sparse_matrix_t * A, MKL_INT m, MKL_INT n, MKL_INT nnz, MKL_INT * row_indx, MKL_INT * col_indx, float * values)
+{
+  return mkl_sparse_s_create_coo(A, SPARSE_INDEX_BASE_ZERO, m, n, nnz, row_indx, col_indx, values);
+}
+
+inline sparse_status_t create_coo(sparse_matrix_t * A, MKL_INT m, MKL_INT n, MKL_INT nnz, MKL_INT * row_indx, MKL_INT * col_indx, double * values)
+{
+  return mkl_sparse_d_create_coo(A, SPARSE_INDEX_BASE_ZERO, m, n, nnz, row_indx, col_indx, values);
+}
+
+inline sparse_status_t mv(const sparse_matrix_t A, const float * x, float * y)
+{
+  return mkl_sparse_s_mv(SPARSE_OPERATION_NON_TRANSPOSE, 1.0f, A, general_descr(), x, 0.0f, y);
+}
+
+inline sparse_status_t mv(const sparse_matrix_t A, const double * x, double * y)
+{
+  return mkl_sparse_d_mv(SPARSE_OPERATION_NON_TRANSPOSE, 1.0, A, general_descr(), x, 0.0, y);
+}
+
+inline sparse_status_t mm(const sparse_matrix_t A, sparse_layout_t layout, const float * X, MKL_INT columns, MKL_INT ldx, float * Y, MKL_INT ldy)
+{
+  return mkl_sparse_s_mm(SPARSE_OPERATION_NON_TRANSPOSE, 1.0f, A, general_descr(), layout, X, columns, ldx, 0.0f, Y, ldy);
+}
+
+inline sparse_status_t mm(const sparse_matrix_t A, sparse_layout_t layout, const double * X, MKL_INT columns, MKL_INT ldx, double * Y, MKL_INT ldy)
+{
+  return mkl_sparse_d_mm(SPARSE_OPERATION_NON_TRANSPOSE, 1.0, A, general_descr(), layout, X, columns, ldx, 0.0, Y, ldy);
+}
+
+inline sparse_status_t export_csr(const sparse_matrix_t A, MKL_INT * m, MKL_INT * n, MKL_INT ** rows_start, MKL_INT ** rows_end, MKL_INT ** col_indx, float ** values)
+{
+  sparse_index_base_t base;
+  return mkl_sparse_s_export_csr(A, &base, m, n, rows_start, rows_end, col_indx, values);
+}
+
+inline sparse_status_t export_csr(const sparse_matrix_t A, MKL_INT * m, MKL_INT * n, MKL_INT ** rows_start, MKL_INT ** rows_end, MKL_INT ** col_indx, double ** values)
+{
+  sparse_index_base_t base;
+  return mkl_sparse_d_export_csr(A, &base, m, n, rows_start, rows_end, col_indx, values);
+}
+
+inline sparse_layout_t layout(cusp::row_major)    { return SPARSE_LAYOUT_ROW_MAJOR; }
+inline sparse_layout_t layout(cusp::column_major) { return SPARSE_LAYOUT_COLUMN_MAJOR; }
+
+// owns an inspector-executor handle, which refers to the arrays it was
+// created from without copying them
+class sparse_matrix
+{
+    sparse_matrix_t A;
+
+    // not copyable
+    sparse_matrix(const sparse_matrix&);
+    sparse_matrix& operator=(const sparse_matrix&);
+
+  public:
+    sparse_matrix(void) : A(0) {}
+
+    ~sparse_matrix(void)
+    {
+      if (A) mkl_sparse_destroy(A);
+    }
+
+    sparse_matrix_t& get(void)       { return A; }
+    sparse_matrix_t  get(void) const { return A; }
+
+    // analyze the matrix for the expected number of SpMVs
+    void optimize(size_t expected_calls)
+    {
+      MKL_INT calls = MKL_INT(std::min(expected_calls, size_t(std::numeric_limits<MKL_INT>::max())));
+
+      check(mkl_sparse_set_mv_hint(A, SPARSE_OPERATION_NON_TRANSPOSE, general_descr(), calls), "mkl_sparse_set_mv_hint");
+      check(mkl_sparse_set_memory_hint(A, SPARSE_MEMORY_AGGRESSIVE), "mkl_sparse_set_memory_hint");
+      check(mkl_sparse_optimize(A), "mkl_sparse_optimize");
+    }
+};
+
+// the index copies must outlive the handle
+struct csr_indices
+{
+  cusp::array1d<MKL_INT,cusp::host_memory> row_offsets;
+  cusp::array1d<MKL_INT,cusp::host_memory> column_indices;
+};
+
+template <typename Matrix>
+void create_csr(const Matrix& A, sparse_matrix& handle, csr_indices& indices)
+{
+  MKL_INT * P = index_pointer(A.row_offsets,    indices.row_offsets);
+  MKL_INT * J = index_pointer(A.column_indices, indices.column_indices);
+
+  check(create_csr(&handle.get(), MKL_INT(A.num_rows), MKL_INT(A.num_cols), P, P + 1, J, value_pointer(A.values)), "mkl_sparse_create_csr");
+}
+
+template <typename Matrix>
+bool is_mkl_shape(const Matrix& A)
+{
+  return A.num_rows > 0 && A.num_cols > 0 && A.num_entries > 0 &&
+         fits(A.num_rows) && fits(A.num_cols) && fits(A.num_entries);
+}
+
+//////////////
+// CSR SpMV //
+//////////////
+template <typename Matrix, typename Vector1, typename Vector2>
+bool spmv_csr(const Matrix& A, const Vector1& x, Vector2& y, thrust::detail::true_type)
+{
+  if (!is_mkl_shape(A))
+    return false;
+
+  sparse_matrix handle;
+  csr_indices indices;
+
+  create_csr(A, handle, indices);
+
+  check(mv(handle.get(), value_pointer(x), value_pointer(y)), "mkl_sparse_mv");
+
+  return true;
+}
+
+//////////////
+// COO SpMV //
+//////////////
+template <typename Matrix, typename Vector1, typename Vector2>
+bool spmv_coo(const Matrix& A, const Vector1& x, Vector2& y, thrust::detail::true_type)
+{
+  if (!is_mkl_shape(A))
+    return false;
+
+  sparse_matrix handle;
+  cusp::array1d<MKL_INT,cusp::host_memory> I_copy;
+  cusp::array1d<MKL_INT,cusp::host_memory> J_copy;
+
+  MKL_INT * I = index_pointer(A.row_indices,    I_copy);
+  MKL_INT * J = index_pointer(A.column_indices, J_copy);
+
+  check(create_coo(&handle.get(), MKL_INT(A.num_rows), MKL_INT(A.num_cols), MKL_INT(A.num_entries), I, J, value_pointer(A.values)), "mkl_sparse_create_coo");
+  check(mv(handle.get(), value_pointer(x), value_pointer(y)), "mkl_sparse_mv");
+
+  return true;
+}
+
+//////////////
+// CSR SpMM //
+//////////////
+template <typename Matrix1, typename Matrix2, typename Matrix3>
+bool spmm_dense(const Matrix1& A, const Matrix2& B, Matrix3& C, thrust::detail::true_type)
+{
+  if (!is_mkl_shape(A) || B.num_cols == 0 || !fits(B.pitch) || !fits(C.pitch) ||
+      !fits(B.num_cols * B.pitch) || !fits(C.num_cols * C.pitch))
+    return false;
+
+  sparse_matrix handle;
+  csr_indices indices;
+
+  create_csr(A, handle, indices);
+
+  check(mm(handle.get(), layout(typename Matrix2::orientation()),
+           value_pointer(B.values), MKL_INT(B.num_cols), MKL_INT(B.pitch),
+           value_pointer(C.values), MKL_INT(C.pitch)), "mkl_sparse_mm");
+
+  return true;
+}
+
+////////////////
+// CSR SpGEMM //
+////////////////
+template <typename Matrix1, typename Matrix2, typename Matrix3>
+bool spmm_csr(const Matrix1& A, const Matrix2& B, Matrix3& C, thrust::detail::true_type)
+{
+  typedef typename Matrix3::value_type ValueType;
+
+  if (!is_mkl_shape(A) || !is_mkl_shape(B) || A.num_cols != B.num_rows)
+    return false;
+
+  sparse_matrix A_handle, B_handle, C_handle;
+  csr_indices A_indices, B_indices;
+
+  create_csr(A, A_handle, A_indices);
+  create_csr(B, B_handle, B_indices);
+
+  check(mkl_sparse_spmm(SPARSE_OPERATION_NON_TRANSPOSE, A_handle.get(), B_handle.get(), &C_handle.get()), "mkl_sparse_spmm");
+
+  // cusp expects the columns of each row in increasing order
+  check(mkl_sparse_order(C_handle.get()), "mkl_sparse_order");
+
+  MKL_INT m, n;
+  MKL_INT * rows_start;
+  MKL_INT * rows_end;
+  MKL_INT * col_indx;
+  ValueType * values;
+
+  check(export_csr(C_handle.get(), &m, &n, &rows_start, &rows_end, &col_indx, &values), "mkl_sparse_export_csr");
+
+  const MKL_INT num_entries = rows_end[m - 1];
+
+  C.resize(m, n, num_entries);
+
+  std::copy(rows_start, rows_start + m, C.row_offsets.begin());
+  C.row_offsets[m] = num_entries;
+
+  std::copy(col_indx, col_indx + num_entries, C.column_indices.begin());
+  std::copy(values,   values   + num_entries, C.values.begin());
+
+  return true;
+}
+
+template <typename Matrix, typename Vector1, typename Vector2>
+struct is_mkl_spmv
+{
+  typedef typename Matrix::value_type ValueType;
+
+  static const bool value = is_mkl_array<typename Matrix::values_array_type, ValueType>::value &&
+                            is_mkl_array<Vector1, ValueType>::value &&
+                            is_mkl_array<Vector2, ValueType>::value;
+};
+
+template <typename Matrix1, typename Matrix2, typename Matrix3>
+struct is_mkl_spmm_dense
+{
+  typedef typename Matrix1::value_type ValueType;
+
+  static const bool value = is_mkl_array<typename Matrix1::values_array_type, ValueType>::value &&
+                            is_mkl_array<typename Matrix2::values_array_type, ValueType>::value &&
+                            is_mkl_array<typename Matrix3::values_array_type, ValueType>::value &&
+                            thrust::detail::is_same<typename Matrix2::orientation, typename Matrix3::orientation>::value;
+};
+
+template <typename Matrix1, typename Matrix2, typename Matrix3>
+struct is_mkl_spmm_csr
+{
+  typedef typename Matrix1::value_type ValueType;
+
+  static const bool value = is_mkl_array<typename Matrix1::values_array_type, ValueType>::value &&
+                            is_mkl_array<typename Matrix2::values_array_type, ValueType>::value &&
+                            thrust::detail::is_same<typename Matrix3::value_type, ValueType>::value;
+};
+
+#else // legacy mkl_cspblas routines
+
+inline void csrgemv(MKL_INT m, float * values, MKL_INT * row_offsets, MKL_INT * column_indices, float * x, float * y)
+{
+  char transa = 'N';
+  mkl_cspblas_scsrgemv(&transa, &m, values, row_offsets, column_indices, x, y);
+}
+
+inline void csrgemv(MKL_INT m, double * values, MKL_INT * row_offsets, MKL_INT * column_indices, double * x, double * y)
+{
+  char transa = 'N';
+  mkl_cspblas_dcsrgemv(&transa, &m, values, row_offsets, column_indices, x, y);
+}
+
+inline void coogemv(MKL_INT m, float * values, MKL_INT * row_indices, MKL_INT * column_indices, MKL_INT nnz, float * x, float * y)
+{
+  char transa = 'N';
+  mkl_cspblas_scoogemv(&transa, &m, values, row_indices, column_indices, &nnz, x, y);
+}
+
+inline void coogemv(MKL_INT m, double * values, MKL_INT * row_indices, MKL_INT * column_indices, MKL_INT nnz, double * x, double * y)
+{
+  char transa = 'N';
+  mkl_cspblas_dcoogemv(&transa, &m, values, row_indices, column_indices, &nnz, x, y);
+}
+
+// the mkl_cspblas routines only multiply square matrices
+template <typename Matrix>
+bool is_mkl_shape(const Matrix& A)
+{
+  return A.num_rows > 0 && A.num_rows == A.num_cols && A.num_entries > 0 &&
+         fits(A.num_rows) && fits(A.num_entries);
+}
+
+template <typename Matrix, typename Vector1, typename Vector2>
+bool spmv_csr(const Matrix& A, const Vector1& x, Vector2& y, thrust::detail::true_type)
+{
+  if (!is_mkl_shape(A))
+    return false;
+
+  cusp::array1d<MKL_INT,cusp::host_memory> P_copy;
+  cusp::array1d<MKL_INT,cusp::host_memory> J_copy;
+
+  csrgemv(MKL_INT(A.num_rows), value_pointer(A.values),
+          index_pointer(A.row_offsets, P_copy), index_pointer(A.column_indices, J_copy),
+          value_pointer(x), value_pointer(y));
+
+  return true;
+}
+
+template <typename Matrix, typename Vector1, typename Vector2>
+bool spmv_coo(const Matrix& A, const Vector1& x, Vector2& y, thrust::detail::true_type)
+{
+  if (!is_mkl_shape(A))
+    return false;
+
+  cusp::array1d<MKL_INT,cusp::host_memory> I_copy;
+  cusp::array1d<MKL_INT,cusp::host_memory> J_copy;
+
+  coogemv(MKL_INT(A.num_rows), value_pointer(A.values),
+          index_pointer(A.row_indices, I_copy), index_pointer(A.column_indices, J_copy),
+          MKL_INT(A.num_entries), value_pointer(x), value_pointer(y));
+
+  return true;
+}
+
+template <typename Matrix, typename Vector1, typename Vector2>
+struct is_mkl_spmv
+{
+  typedef typename Matrix::value_type ValueType;
+
+  static const bool value = is_mkl_array<typename Matrix::values_array_type, ValueType>::value &&
+                            is_mkl_array<Vector1, ValueType>::value &&
+                            is_mkl_array<Vector2, ValueType>::value;
+};
+
+template <typename Matrix1, typename Matrix2, typename Matrix3>
+struct is_mkl_spmm_dense : thrust::detail::false_type {};
+
+template <typename Matrix1, typename Matrix2, typename Matrix3>
+struct is_mkl_spmm_csr : thrust::detail::false_type {};
+
+#endif // __CUSP_USE_MKL_INSPECTOR_EXECUTOR__
+
+// other types and configurations use the cusp kernels
+template <typename Matrix, typename Vector1, typename Vector2>
+bool spmv_csr(const Matrix&, const Vector1&, Vector2&, thrust::detail::false_type)
+{
+  return false;
+}
+
+template <typename Matrix, typename Vector1, typename Vector2>
+bool spmv_coo(const Matrix&, const Vector1&, Vector2&, thrust::detail::false_type)
+{
+  return false;
+}
+
+template <typename Matrix1, typename Matrix2, typename Matrix3>
+bool spmm_dense(const Matrix1&, const Matrix2&, Matrix3&, thrust::detail::false_type)
+{
+  return false;
+}
+
+template <typename Matrix1, typename Matrix2, typename Matrix3>
+bool spmm_csr(const Matrix1&, const Matrix2&, Matrix3&, thrust::detail::false_type)
+{
+  return false;
+}
+
+template <typename LinearOperator, typename MatrixOrVector1, typename MatrixOrVector2,
+          typename Format1, typename Format2, typename Format3>
+bool multiply(const LinearOperator&, const MatrixOrVector1&, MatrixOrVector2&,
+              Format1, Format2, Format3)
+{
+  return false;
+}
+
+template <typename Matrix, typename Vector1, typename Vector2>
+bool multiply(const Matrix& A, const Vector1& x, Vector2& y,
+              cusp::csr_format, cusp::array1d_format, cusp::array1d_format)
+{
+  return spmv_csr(A, x, y, thrust::detail::integral_constant<bool, is_mkl_spmv<Matrix,Vector1,Vector2>::value>());
+}
+
+template <typename Matrix, typename Vector1, typename Vector2>
+bool multiply(const Matrix& A, const Vector1& x, Vector2& y,
+              cusp::coo_format, cusp::array1d_format, cusp::array1d_format)
+{
+  return spmv_coo(A, x, y, thrust::detail::integral_constant<bool, is_mkl_spmv<Matrix,Vector1,Vector2>::value>());
+}
+
+template <typename Matrix1, typename Matrix2, typename Matrix3>
+bool multiply(const Matrix1& A, const Matrix2& B, Matrix3& C,
+              cusp::csr_format, cusp::array2d_format, cusp::array2d_format)
+{
+  return spmm_dense(A, B, C, thrust::detail::integral_constant<bool, is_mkl_spmm_dense<Matrix1,Matrix2,Matrix3>::value>());
+}
+
+template <typename Matrix1, typename Matrix2, typename Matrix3>
+bool multiply(const Matrix1& A, const Matrix2& B, Matrix3& C,
+              cusp::csr_format, cusp::csr_format, cusp::csr_format)
+{
+  return spmm_csr(A, B, C, thrust::detail::integral_constant<bool, is_mkl_spmm_csr<Matrix1,Matrix2,Matrix3>::value>());
+}
+
+// C = A * B with MKL, returns false when the cusp kernels must be used
+template <typename LinearOperator, typename MatrixOrVector1, typename MatrixOrVector2>
+bool multiply(const LinearOperator& A, const MatrixOrVector1& B, MatrixOrVector2& C)
+{
+  return multiply(A, B, C,
+                  typename LinearOperator::format(),
+                  typename MatrixOrVector1::format(),
+                  typename MatrixOrVector2::format());
+}
+
+} // end namespace mkl
+} // end namespace host
+} // end namespace detail
+} // end namespace cusp
+
+#undef __CUSP_USE_MKL_INSPECTOR_EXECUTOR__
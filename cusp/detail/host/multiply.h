@@ -17,19 +17,20 @@
 #pragma once
 
 #include <cusp/format.h>
+#include <cusp/conversion_cache.h>
+#include <cusp/coo_matrix.h>
 #include <cusp/csr_matrix.h>
 
 #include <cusp/detail/functional.h>
+#include <cusp/detail/host/parallel.h>
 
-#ifdef INTEL_MKL_SPBLAS
-#include <cusp/detail/host/spmv_mkl.h>
-#else
 #include <cusp/detail/host/spmv.h>
-#endif
 
 #include <cusp/detail/host/detail/coo.h>
 #include <cusp/detail/host/detail/csr.h>
 
+#include <algorithm>
+
 namespace cusp
 {
 namespace detail
@@ -52,14 +53,24 @@ void multiply(const Matrix&  A,
 {
     typedef typename Vector2::value_type ValueType;
 
-    for(size_t i = 0; i < A.num_rows; i++)
+    const int P = cusp::detail::host::num_parts(A.num_rows * (A.num_cols + 1));
+
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(static) num_threads(P)
+#endif
+    for(int part = 0; part < P; part++)
     {
-        ValueType sum = 0;
-        for(size_t j = 0; j < A.num_cols; j++)
+        const size_t i_end = uniform_split(A.num_rows, part + 1, P);
+
+        for(size_t i = uniform_split(A.num_rows, part, P); i < i_end; i++)
         {
-            sum += A(i,j) * B[j];
+            ValueType sum = 0;
+            for(size_t j = 0; j < A.num_cols; j++)
+            {
+                sum += A(i,j) * B[j];
+            }
+            C[i] = sum;
         }
-        C[i] = sum;
     }
 }
 
@@ -134,6 +145,233 @@ void multiply(const Matrix&  A,
     cusp::detail::host::spmv_coo(A.coo, B, C, thrust::identity<ValueType>(), thrust::multiplies<ValueType>(), thrust::plus<ValueType>());
 }
 
+template <typename Matrix,
+         typename Vector1,
+         typename Vector2>
+void multiply(const Matrix&  A,
+              const Vector1& B,
+              Vector2& C,
+              cusp::sell_format,
+              cusp::array1d_format,
+              cusp::array1d_format)
+{
+    cusp::detail::host::spmv_sell(A, B, C);
+}
+
+template <typename Matrix,
+         typename Vector1,
+         typename Vector2>
+void multiply(const Matrix&  A,
+              const Vector1& B,
+              Vector2& C,
+              cusp::bsr_format,
+              cusp::array1d_format,
+              cusp::array1d_format)
+{
+    cusp::detail::host::spmv_bsr(A, B, C);
+}
+
+template <typename Matrix,
+         typename Vector1,
+         typename Vector2>
+void multiply(const Matrix&  A,
+              const Vector1& B,
+              Vector2& C,
+              cusp::csr16_format,
+              cusp::array1d_format,
+              cusp::array1d_format)
+{
+    cusp::detail::host::spmv_csr16(A, B, C);
+}
+
+///////////////////////////////////////
+// Generalized Matrix-Vector Multiply //
+///////////////////////////////////////
+template <typename Matrix,
+         typename Vector1,
+         typename Vector2,
+         typename UnaryFunction,
+         typename BinaryFunction1,
+         typename BinaryFunction2>
+void generalized_multiply(const Matrix&  A,
+                          const Vector1& x,
+                                Vector2& y,
+                          UnaryFunction   initialize,
+                          BinaryFunction1 combine,
+                          BinaryFunction2 reduce,
+                          cusp::coo_format)
+{
+    cusp::detail::host::spmv_coo(A, x, y, initialize, combine, reduce);
+}
+
+template <typename Matrix,
+         typename Vector1,
+         typename Vector2,
+         typename UnaryFunction,
+         typename BinaryFunction1,
+         typename BinaryFunction2>
+void generalized_multiply(const Matrix&  A,
+                          const Vector1& x,
+                                Vector2& y,
+                          UnaryFunction   initialize,
+                          BinaryFunction1 combine,
+                          BinaryFunction2 reduce,
+                          cusp::csr_format)
+{
+    cusp::detail::host::spmv_csr(A, x, y, initialize, combine, reduce);
+}
+
+template <typename Matrix,
+         typename Vector1,
+         typename Vector2,
+         typename UnaryFunction,
+         typename BinaryFunction1,
+         typename BinaryFunction2>
+void generalized_multiply(const Matrix&  A,
+                          const Vector1& x,
+                                Vector2& y,
+                          UnaryFunction   initialize,
+                          BinaryFunction1 combine,
+                          BinaryFunction2 reduce,
+                          cusp::dia_format)
+{
+    cusp::detail::host::spmv_dia(A, x, y, initialize, combine, reduce);
+}
+
+template <typename Matrix,
+         typename Vector1,
+         typename Vector2,
+         typename UnaryFunction,
+         typename BinaryFunction1,
+         typename BinaryFunction2>
+void generalized_multiply(const Matrix&  A,
+                          const Vector1& x,
+                                Vector2& y,
+                          UnaryFunction   initialize,
+                          BinaryFunction1 combine,
+                          BinaryFunction2 reduce,
+                          cusp::ell_format)
+{
+    cusp::detail::host::spmv_ell(A, x, y, initialize, combine, reduce);
+}
+
+template <typename Matrix,
+         typename Vector1,
+         typename Vector2,
+         typename UnaryFunction,
+         typename BinaryFunction1,
+         typename BinaryFunction2>
+void generalized_multiply(const Matrix&  A,
+                          const Vector1& x,
+                                Vector2& y,
+                          UnaryFunction   initialize,
+                          BinaryFunction1 combine,
+                          BinaryFunction2 reduce,
+                          cusp::sell_format)
+{
+    cusp::detail::host::spmv_sell(A, x, y, initialize, combine, reduce);
+}
+
+template <typename Matrix,
+         typename Vector1,
+         typename Vector2,
+         typename UnaryFunction,
+         typename BinaryFunction1,
+         typename BinaryFunction2>
+void generalized_multiply(const Matrix&  A,
+                          const Vector1& x,
+                                Vector2& y,
+                          UnaryFunction   initialize,
+                          BinaryFunction1 combine,
+                          BinaryFunction2 reduce,
+                          cusp::bsr_format)
+{
+    cusp::detail::host::spmv_bsr(A, x, y, initialize, combine, reduce);
+}
+
+template <typename Matrix,
+         typename Vector1,
+         typename Vector2,
+         typename UnaryFunction,
+         typename BinaryFunction1,
+         typename BinaryFunction2>
+void generalized_multiply(const Matrix&  A,
+                          const Vector1& x,
+                                Vector2& y,
+                          UnaryFunction   initialize,
+                          BinaryFunction1 combine,
+                          BinaryFunction2 reduce,
+                          cusp::csr16_format)
+{
+    cusp::detail::host::spmv_csr16(A, x, y, initialize, combine, reduce);
+}
+
+template <typename Matrix,
+         typename Vector1,
+         typename Vector2,
+         typename UnaryFunction,
+         typename BinaryFunction1,
+         typename BinaryFunction2>
+void generalized_multiply(const Matrix&  A,
+                          const Vector1& x,
+                                Vector2& y,
+                          UnaryFunction   initialize,
+                          BinaryFunction1 combine,
+                          BinaryFunction2 reduce,
+                          cusp::hyb_format)
+{
+    typedef typename Vector2::value_type ValueType;
+
+    cusp::detail::host::spmv_ell(A.ell, x, y, initialize, combine, reduce);
+    cusp::detail::host::spmv_coo(A.coo, x, y, thrust::identity<ValueType>(), combine, reduce);
+}
+
+//////////////////////////////////
+// Masked Matrix-Vector Multiply //
+//////////////////////////////////
+template <typename Matrix,
+         typename Vector1,
+         typename Vector2,
+         typename Vector3,
+         typename UnaryFunction,
+         typename BinaryFunction1,
+         typename BinaryFunction2>
+void masked_multiply(const Matrix&  A,
+                     const Vector1& x,
+                     const Vector2& mask,
+                           Vector3& y,
+                     UnaryFunction   initialize,
+                     BinaryFunction1 combine,
+                     BinaryFunction2 reduce,
+                     cusp::csr_format)
+{
+    cusp::detail::host::spmv_csr_masked(A, x, mask, y, initialize, combine, reduce);
+}
+
+template <typename Matrix,
+         typename Vector1,
+         typename Vector2,
+         typename Vector3,
+         typename UnaryFunction,
+         typename BinaryFunction1,
+         typename BinaryFunction2>
+void masked_multiply(const Matrix&  A,
+                     const Vector1& x,
+                     const Vector2& mask,
+                           Vector3& y,
+                     UnaryFunction   initialize,
+                     BinaryFunction1 combine,
+                     BinaryFunction2 reduce,
+                     cusp::sparse_format)
+{
+    typedef typename Matrix::index_type IndexType;
+    typedef typename Matrix::value_type ValueType;
+
+    cusp::csr_matrix<IndexType,ValueType,cusp::host_memory> B(A);
+
+    cusp::detail::host::spmv_csr_masked(B, x, mask, y, initialize, combine, reduce);
+}
+
 ////////////////////////////////////////
 // Sparse Matrix-BlockVector Multiply //
 ////////////////////////////////////////
@@ -223,8 +461,10 @@ void multiply(const Matrix1& A,
               cusp::sparse_format)
 {
     // other formats use CSR * CSR
-    cusp::csr_matrix<typename Matrix1::index_type,typename Matrix1::value_type,cusp::host_memory> A_(A);
-    cusp::csr_matrix<typename Matrix2::index_type,typename Matrix2::value_type,cusp::host_memory> B_(B);
+    cusp::csr_matrix<typename Matrix1::index_type,typename Matrix1::value_type,cusp::host_memory> A_temp;
+    const cusp::csr_matrix<typename Matrix1::index_type,typename Matrix1::value_type,cusp::host_memory>& A_ = cusp::detail::cached_conversion(A, A_temp);
+    cusp::csr_matrix<typename Matrix2::index_type,typename Matrix2::value_type,cusp::host_memory> B_temp;
+    const cusp::csr_matrix<typename Matrix2::index_type,typename Matrix2::value_type,cusp::host_memory>& B_ = cusp::detail::cached_conversion(B, B_temp);
     cusp::csr_matrix<typename Matrix3::index_type,typename Matrix3::value_type,cusp::host_memory> C_;
 
     cusp::detail::host::detail::spmm_csr(A_,B_,C_);
@@ -248,6 +488,184 @@ void multiply(const Matrix&  A,
                                  typename MatrixOrVector2::format());
 }
 
+//////////////////////////////////////////////
+// Transposed Sparse Matrix-Vector Multiply //
+//////////////////////////////////////////////
+template <typename Matrix,
+          typename Vector1,
+          typename Vector2>
+void multiply_transpose(const Matrix&  A,
+                        const Vector1& x,
+                              Vector2& y,
+                        cusp::array2d_format)
+{
+    typedef typename Vector2::value_type ValueType;
+
+    std::fill(y.begin(), y.end(), ValueType(0));
+
+    for(size_t i = 0; i < A.num_rows; i++)
+    {
+        const ValueType x_i = x[i];
+
+        for(size_t j = 0; j < A.num_cols; j++)
+            y[j] += ValueType(A(i,j)) * x_i;
+    }
+}
+
+template <typename Matrix,
+          typename Vector1,
+          typename Vector2>
+void multiply_transpose(const Matrix&  A,
+                        const Vector1& x,
+                              Vector2& y,
+                        cusp::coo_format)
+{
+    typedef typename Matrix::index_type  IndexType;
+    typedef typename Vector2::value_type ValueType;
+
+    std::fill(y.begin(), y.end(), ValueType(0));
+
+    // the entries of a column are scattered over the rows, so y is
+    // accumulated serially
+    for(size_t n = 0; n < A.num_entries; n++)
+    {
+        const IndexType i = A.row_indices[n];
+        const IndexType j = A.column_indices[n];
+
+        y[j] += ValueType(A.values[n]) * x[i];
+    }
+}
+
+template <typename Matrix,
+          typename Vector1,
+          typename Vector2>
+void multiply_transpose(const Matrix&  A,
+                        const Vector1& x,
+                              Vector2& y,
+                        cusp::csr_format)
+{
+    typedef typename Matrix::index_type  IndexType;
+    typedef typename Vector2::value_type ValueType;
+
+    std::fill(y.begin(), y.end(), ValueType(0));
+
+    for(size_t i = 0; i < A.num_rows; i++)
+    {
+        const ValueType x_i = x[i];
+
+        for(IndexType jj = A.row_offsets[i]; jj < A.row_offsets[i + 1]; jj++)
+            y[A.column_indices[jj]] += ValueType(A.values[jj]) * x_i;
+    }
+}
+
+template <typename Matrix,
+          typename Vector1,
+          typename Vector2>
+void multiply_transpose(const Matrix&  A,
+                        const Vector1& x,
+                              Vector2& y,
+                        cusp::sparse_format)
+{
+    // other formats use COO
+    cusp::coo_matrix<typename Matrix::index_type,typename Matrix::value_type,cusp::host_memory> A_temp;
+    const cusp::coo_matrix<typename Matrix::index_type,typename Matrix::value_type,cusp::host_memory>& A_ = cusp::detail::cached_conversion(A, A_temp);
+
+    cusp::detail::host::multiply_transpose(A_, x, y, cusp::coo_format());
+}
+
+template <typename Matrix,
+          typename Vector1,
+          typename Vector2>
+void multiply_transpose(const Matrix&  A,
+                        const Vector1& x,
+                              Vector2& y)
+{
+    cusp::detail::host::multiply_transpose(A, x, y,
+                                           typename Matrix::format());
+}
+
+//////////////////////
+// Galerkin Product //
+//////////////////////
+template <typename Matrix1,
+          typename Matrix2,
+          typename Matrix3,
+          typename Matrix4>
+void galerkin_product(const Matrix1& R,
+                      const Matrix2& A,
+                      const Matrix3& P,
+                            Matrix4& RAP)
+{
+    // RAP = R * (A * P)
+    cusp::csr_matrix<typename Matrix4::index_type,typename Matrix4::value_type,cusp::host_memory> AP;
+
+    cusp::detail::host::multiply(A, P, AP);
+    cusp::detail::host::multiply(R, AP, RAP);
+}
+
+
+///////////////////////////
+// Masked Sparse Product //
+///////////////////////////
+template <typename Matrix1,
+          typename Matrix2,
+          typename Matrix3,
+          typename Matrix4>
+void masked_product(const Matrix1& A,
+                    const Matrix2& B,
+                    const Matrix3& M,
+                          Matrix4& C,
+                    cusp::csr_format,
+                    cusp::csr_format,
+                    cusp::csr_format,
+                    cusp::csr_format)
+{
+    cusp::detail::host::detail::masked_spmm_csr(A, B, M, C);
+}
+
+template <typename Matrix1,
+          typename Matrix2,
+          typename Matrix3,
+          typename Matrix4>
+void masked_product(const Matrix1& A,
+                    const Matrix2& B,
+                    const Matrix3& M,
+                          Matrix4& C,
+                    cusp::sparse_format,
+                    cusp::sparse_format,
+                    cusp::sparse_format,
+                    cusp::sparse_format)
+{
+    // other formats use CSR, whose columns are sorted by the conversion
+    cusp::csr_matrix<typename Matrix1::index_type,typename Matrix1::value_type,cusp::host_memory> A_temp;
+    const cusp::csr_matrix<typename Matrix1::index_type,typename Matrix1::value_type,cusp::host_memory>& A_ = cusp::detail::cached_conversion(A, A_temp);
+    cusp::csr_matrix<typename Matrix2::index_type,typename Matrix2::value_type,cusp::host_memory> B_temp;
+    const cusp::csr_matrix<typename Matrix2::index_type,typename Matrix2::value_type,cusp::host_memory>& B_ = cusp::detail::cached_conversion(B, B_temp);
+    cusp::csr_matrix<typename Matrix3::index_type,typename Matrix3::value_type,cusp::host_memory> M_temp;
+    const cusp::csr_matrix<typename Matrix3::index_type,typename Matrix3::value_type,cusp::host_memory>& M_ = cusp::detail::cached_conversion(M, M_temp);
+    cusp::csr_matrix<typename Matrix4::index_type,typename Matrix4::value_type,cusp::host_memory> C_;
+
+    cusp::detail::host::detail::masked_spmm_csr(A_, B_, M_, C_);
+
+    cusp::convert(C_, C);
+}
+
+template <typename Matrix1,
+          typename Matrix2,
+          typename Matrix3,
+          typename Matrix4>
+void masked_product(const Matrix1& A,
+                    const Matrix2& B,
+                    const Matrix3& M,
+                          Matrix4& C)
+{
+    cusp::detail::host::masked_product(A, B, M, C,
+                                      typename Matrix1::format(),
+                                      typename Matrix2::format(),
+                                      typename Matrix3::format(),
+                                      typename Matrix4::format());
+}
+
 } // end namespace host
 } // end namespace detail
 } // end namespace cusp
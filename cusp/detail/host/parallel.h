@@ -0,0 +1,155 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// Helpers for the OpenMP host kernels.  Every parallel loop runs over
+// num_parts contiguous blocks of rows with a static schedule, so a thread
+// always processes the same block of a matrix from one call to the next and
+// the rows of the output vector are written by the thread which owns them.
+// Without OpenMP the loops run as a single block on the calling thread.
+
+namespace cusp
+{
+namespace detail
+{
+namespace host
+{
+
+// loops with less work than this are not worth waking up the thread team for
+const size_t parallel_work_threshold = 32768;
+
+// number of blocks to split a loop into for the given amount of work
+inline int num_parts(size_t work)
+{
+#ifdef _OPENMP
+  return work < parallel_work_threshold ? 1 : omp_get_max_threads();
+#else
+  return 1;
+#endif
+}
+
+// first index of block part when n items are split evenly
+inline size_t uniform_split(size_t n, int part, int num_parts)
+{
+  return n * part / num_parts;
+}
+
+// first row of block part when the rows are split by the cost of their
+// entries plus one per row, so that long rows and empty rows are both balanced
+template <typename Array>
+size_t balanced_split(const Array& row_offsets, size_t num_rows, int part, int num_parts)
+{
+  if (part == 0)         return 0;
+  if (part == num_parts) return num_rows;
+
+  const size_t num_entries = row_offsets[num_rows] - row_offsets[0];
+  const size_t target      = uniform_split(num_entries + num_rows, part, num_parts);
+
+  // find the first row whose cost prefix reaches the target
+  size_t first = 0;
+  size_t last  = num_rows;
+
+  while (first < last)
+  {
+    const size_t mid = first + (last - first) / 2;
+
+    if (size_t(row_offsets[mid] - row_offsets[0]) + mid < target)
+      first = mid + 1;
+    else
+      last = mid;
+  }
+
+  return first;
+}
+
+// first entry of block part of a row-sorted index array, moved forward to
+// the start of a row so that a row never straddles two blocks
+template <typename Array>
+size_t row_aligned_split(const Array& row_indices, size_t num_entries, int part, int num_parts)
+{
+  size_t n = uniform_split(num_entries, part, num_parts);
+
+  if (part == 0 || part == num_parts)
+    return n;
+
+  while (n > 0 && n < num_entries && row_indices[n] == row_indices[n - 1])
+    n++;
+
+  return n;
+}
+
+// a[0,n) <- exclusive prefix sums of the counts a[0,n), a[n] <- their total.
+// Each block sums its counts, the block sums are scanned, and each block
+// then scans its counts from its own start.
+template <typename Array>
+void counts_to_offsets(Array& a, size_t n)
+{
+  typedef typename Array::value_type T;
+
+  const int P = num_parts(n);
+
+  std::vector<T> starts(P + 1, T(0));
+
+#ifdef _OPENMP
+  #pragma omp parallel for schedule(static) num_threads(P)
+#endif
+  for (int part = 0; part < P; part++)
+  {
+    T sum = T(0);
+
+    const size_t i_end = uniform_split(n, part + 1, P);
+
+    for (size_t i = uniform_split(n, part, P); i < i_end; i++)
+      sum += a[i];
+
+    starts[part + 1] = sum;
+  }
+
+  for (int part = 0; part < P; part++)
+    starts[part + 1] += starts[part];
+
+#ifdef _OPENMP
+  #pragma omp parallel for schedule(static) num_threads(P)
+#endif
+  for (int part = 0; part < P; part++)
+  {
+    T sum = starts[part];
+
+    const size_t i_end = uniform_split(n, part + 1, P);
+
+    for (size_t i = uniform_split(n, part, P); i < i_end; i++)
+    {
+      const T count = a[i];
+      a[i] = sum;
+      sum += count;
+    }
+  }
+
+  a[n] = starts[P];
+}
+
+} // end namespace host
+} // end namespace detail
+} // end namespace cusp
@@ -0,0 +1,144 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+#include <thrust/copy.h>
+
+namespace cusp
+{
+namespace detail
+{
+namespace host
+{
+
+// C holds the columns of A as its rows
+template <typename Matrix, typename SparseVector1, typename Array, typename SparseVector2,
+          typename BinaryFunction1, typename BinaryFunction2>
+void spmspv_push(const Matrix& C, size_t num_rows,
+                 const SparseVector1& x, const Array* mask, SparseVector2& y,
+                 BinaryFunction1 combine, BinaryFunction2 reduce)
+{
+    typedef typename SparseVector2::index_type IndexType;
+    typedef typename SparseVector2::value_type ValueType;
+    typedef typename Array::value_type         MaskType;
+
+    std::vector<ValueType> accumulator(num_rows);
+    std::vector<char>      touched(num_rows, 0);
+    std::vector<IndexType> rows;
+
+    for(size_t n = 0; n < x.num_entries; n++)
+    {
+        const IndexType j = x.indices[n];
+
+        for(IndexType jj = C.row_offsets[j]; jj < C.row_offsets[j + 1]; jj++)
+        {
+            const IndexType i = C.column_indices[jj];
+
+            if (mask && (*mask)[i] == MaskType(0))
+                continue;
+
+            const ValueType A_ij_x_j = combine(C.values[jj], x.values[n]);
+
+            if (touched[i])
+            {
+                accumulator[i] = reduce(accumulator[i], A_ij_x_j);
+            }
+            else
+            {
+                accumulator[i] = A_ij_x_j;
+                touched[i]     = 1;
+                rows.push_back(i);
+            }
+        }
+    }
+
+    std::sort(rows.begin(), rows.end());
+
+    y.resize(num_rows, rows.size());
+
+    for(size_t n = 0; n < rows.size(); n++)
+    {
+        y.indices[n] = rows[n];
+        y.values[n]  = accumulator[rows[n]];
+    }
+}
+
+template <typename Matrix, typename SparseVector1, typename Array, typename SparseVector2,
+          typename BinaryFunction1, typename BinaryFunction2>
+void spmspv_pull(const Matrix& A,
+                 const SparseVector1& x, const Array* mask, SparseVector2& y,
+                 BinaryFunction1 combine, BinaryFunction2 reduce)
+{
+    typedef typename SparseVector1::value_type InputType;
+    typedef typename SparseVector2::index_type IndexType;
+    typedef typename SparseVector2::value_type ValueType;
+    typedef typename Array::value_type         MaskType;
+
+    // expand x
+    std::vector<InputType> x_dense(A.num_cols);
+    std::vector<char>      present(A.num_cols, 0);
+
+    for(size_t n = 0; n < x.num_entries; n++)
+    {
+        x_dense[x.indices[n]] = x.values[n];
+        present[x.indices[n]] = 1;
+    }
+
+    std::vector<IndexType> rows;
+    std::vector<ValueType> values;
+
+    for(size_t i = 0; i < A.num_rows; i++)
+    {
+        if (mask && (*mask)[i] == MaskType(0))
+            continue;
+
+        ValueType sum   = ValueType();
+        bool      valid = false;
+
+        for(IndexType jj = A.row_offsets[i]; jj < A.row_offsets[i + 1]; jj++)
+        {
+            const IndexType j = A.column_indices[jj];
+
+            if (!present[j])
+                continue;
+
+            const ValueType A_ij_x_j = combine(A.values[jj], x_dense[j]);
+
+            sum   = valid ? reduce(sum, A_ij_x_j) : A_ij_x_j;
+            valid = true;
+        }
+
+        if (valid)
+        {
+            rows.push_back(i);
+            values.push_back(sum);
+        }
+    }
+
+    y.resize(A.num_rows, rows.size());
+
+    thrust::copy(rows.begin(),   rows.end(),   y.indices.begin());
+    thrust::copy(values.begin(), values.end(), y.values.begin());
+}
+
+} // end namespace host
+} // end namespace detail
+} // end namespace cusp
@@ -1,7 +1,14 @@
 #pragma once
 
+#include <algorithm>
+
 #include <thrust/functional.h>
+#include <cusp/reduction.h>
+#include <cusp/detail/accumulator.h>
 #include <cusp/detail/functional.h>
+#include <cusp/detail/offset_type.h>
+#include <cusp/detail/host/parallel.h>
+#include <cusp/detail/host/spmv_simd.h>
 
 namespace cusp
 {
@@ -29,17 +36,33 @@ void spmv_coo(const Matrix&  A,
     typedef typename Matrix::index_type  IndexType;
     typedef typename Vector2::value_type ValueType;
 
-    for(size_t i = 0; i < A.num_rows; i++)
-        y[i] = initialize(y[i]);
-
-    for(size_t n = 0; n < A.num_entries; n++)
+    const int P = cusp::detail::host::num_parts(A.num_rows + A.num_entries);
+
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(static) num_threads(P)
+#endif
+    for(int part = 0; part < P; part++)
+        for(size_t i = uniform_split(A.num_rows, part, P); i < uniform_split(A.num_rows, part + 1, P); i++)
+            y[i] = initialize(y[i]);
+
+    // the entries are sorted by row, so blocks which begin at a row
+    // boundary update disjoint parts of y
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(static) num_threads(P)
+#endif
+    for(int part = 0; part < P; part++)
     {
-        const IndexType& i   = A.row_indices[n];
-        const IndexType& j   = A.column_indices[n];
-        const ValueType& Aij = A.values[n];
-        const ValueType& xj  = x[j];
+        const size_t n_end = row_aligned_split(A.row_indices, A.num_entries, part + 1, P);
 
-        y[i] = reduce(y[i], combine(Aij, xj));
+        for(size_t n = row_aligned_split(A.row_indices, A.num_entries, part, P); n < n_end; n++)
+        {
+            const IndexType& i   = A.row_indices[n];
+            const IndexType& j   = A.column_indices[n];
+            const ValueType& Aij = A.values[n];
+            const ValueType& xj  = x[j];
+
+            y[i] = reduce(y[i], combine(Aij, xj));
+        }
     }
 }
 
@@ -76,25 +99,118 @@ void spmv_csr(const Matrix&  A,
               BinaryFunction2 reduce)
 {
     typedef typename Matrix::index_type  IndexType;
+    typedef typename cusp::detail::offset_type<Matrix>::type OffsetType;
     typedef typename Vector2::value_type ValueType;
- 
-    for(size_t i = 0; i < A.num_rows; i++)
+
+    const int P = cusp::detail::host::num_parts(A.num_rows + A.num_entries);
+
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(static) num_threads(P)
+#endif
+    for(int part = 0; part < P; part++)
     {
-        const IndexType& row_start = A.row_offsets[i];
-        const IndexType& row_end   = A.row_offsets[i+1];
- 
-        ValueType accumulator = initialize(y[i]);
- 
-        for (IndexType jj = row_start; jj < row_end; jj++)
+        const size_t i_end = balanced_split(A.row_offsets, A.num_rows, part + 1, P);
+
+        for(size_t i = balanced_split(A.row_offsets, A.num_rows, part, P); i < i_end; i++)
         {
-            const IndexType& j   = A.column_indices[jj];
-            const ValueType& Aij = A.values[jj];
-            const ValueType& xj  = x[j];
- 
-            accumulator = reduce(accumulator, combine(Aij, xj));
+            const OffsetType row_start = A.row_offsets[i];
+            const OffsetType row_end   = A.row_offsets[i+1];
+
+            ValueType accumulator = initialize(y[i]);
+
+            for (OffsetType jj = row_start; jj < row_end; jj++)
+            {
+                const IndexType& j   = A.column_indices[jj];
+                const ValueType& Aij = A.values[jj];
+                const ValueType& xj  = x[j];
+
+                accumulator = reduce(accumulator, combine(Aij, xj));
+            }
+
+            y[i] = accumulator;
+        }
+    }
+}
+
+// only the rows with mask[i] != 0 are computed, the others keep y[i]
+template <typename Matrix,
+          typename Vector1,
+          typename Vector2,
+          typename Vector3,
+          typename UnaryFunction,
+          typename BinaryFunction1,
+          typename BinaryFunction2>
+void spmv_csr_masked(const Matrix&  A,
+                     const Vector1& x,
+                     const Vector2& mask,
+                           Vector3& y,
+                     UnaryFunction   initialize,
+                     BinaryFunction1 combine,
+                     BinaryFunction2 reduce)
+{
+    typedef typename cusp::detail::offset_type<Matrix>::type OffsetType;
+    typedef typename Vector2::value_type MaskType;
+    typedef typename Vector3::value_type ValueType;
+
+    const int P = cusp::detail::host::num_parts(A.num_rows + A.num_entries);
+
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(static) num_threads(P)
+#endif
+    for(int part = 0; part < P; part++)
+    {
+        const size_t i_end = balanced_split(A.row_offsets, A.num_rows, part + 1, P);
+
+        for(size_t i = balanced_split(A.row_offsets, A.num_rows, part, P); i < i_end; i++)
+        {
+            if (mask[i] == MaskType(0))
+                continue;
+
+            const OffsetType row_start = A.row_offsets[i];
+            const OffsetType row_end   = A.row_offsets[i+1];
+
+            ValueType accumulator = initialize(y[i]);
+
+            for (OffsetType jj = row_start; jj < row_end; jj++)
+                accumulator = reduce(accumulator, combine(A.values[jj], x[A.column_indices[jj]]));
+
+            y[i] = accumulator;
+        }
+    }
+}
+
+
+// y = A * x with the row sums kept in an accumulator of the Accumulation
+// policy (cusp/detail/accumulator.h)
+template <typename Accumulation,
+          typename Matrix,
+          typename Vector1,
+          typename Vector2>
+void spmv_csr_accumulate(const Matrix&  A,
+                         const Vector1& x,
+                               Vector2& y)
+{
+    typedef typename cusp::detail::offset_type<Matrix>::type OffsetType;
+    typedef typename Vector2::value_type ValueType;
+
+    const int P = cusp::detail::host::num_parts(A.num_rows + A.num_entries);
+
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(static) num_threads(P)
+#endif
+    for(int part = 0; part < P; part++)
+    {
+        const size_t i_end = balanced_split(A.row_offsets, A.num_rows, part + 1, P);
+
+        for(size_t i = balanced_split(A.row_offsets, A.num_rows, part, P); i < i_end; i++)
+        {
+            cusp::detail::accumulator<ValueType, Accumulation> acc;
+
+            for (OffsetType jj = A.row_offsets[i]; jj < A.row_offsets[i+1]; jj++)
+                acc.add_product(ValueType(A.values[jj]), ValueType(x[A.column_indices[jj]]));
+
+            y[i] = acc.result();
         }
- 
-        y[i] = accumulator;
     }
 }
 
@@ -108,6 +224,15 @@ void spmv_csr(const Matrix&  A,
 {
     typedef typename Vector2::value_type ValueType;
 
+    if (cusp::current_reduction_mode() == cusp::compensated_reduction)
+    {
+        spmv_csr_accumulate<cusp::detail::compensated_accumulation>(A, x, y);
+        return;
+    }
+
+    if (cusp::detail::host::simd::spmv_csr(A, x, y))
+        return;
+
     spmv_csr(A, x, y,
              cusp::detail::zero_function<ValueType>(),
              thrust::multiplies<ValueType>(),
@@ -136,27 +261,43 @@ void spmv_dia(const Matrix&  A,
 
     const size_t num_diagonals = A.values.num_cols;
 
-    for(size_t i = 0; i < A.num_rows; i++)
-        y[i] = initialize(y[i]);
+    const int P = cusp::detail::host::num_parts(A.num_rows * (num_diagonals + 1));
 
-    for(size_t i = 0; i < num_diagonals; i++)
+    // each block of rows is swept once per diagonal
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(static) num_threads(P)
+#endif
+    for(int part = 0; part < P; part++)
     {
-        const IndexType& k = A.diagonal_offsets[i];
-
-        const IndexType& i_start = std::max<IndexType>(0, -k);
-        const IndexType& j_start = std::max<IndexType>(0,  k);
+        const IndexType row_begin = uniform_split(A.num_rows, part,     P);
+        const IndexType row_end   = uniform_split(A.num_rows, part + 1, P);
 
-        // number of elements to process in this diagonal
-        const IndexType N = std::min(A.num_rows - i_start, A.num_cols - j_start);
+        for(IndexType r = row_begin; r < row_end; r++)
+            y[r] = initialize(y[r]);
 
-        for(IndexType n = 0; n < N; n++)
+        for(size_t i = 0; i < num_diagonals; i++)
         {
-            const ValueType& Aij = A.values(i_start + n, i);
+            const IndexType& k = A.diagonal_offsets[i];
 
-            const ValueType& xj = x[j_start + n];
-                  ValueType& yi = y[i_start + n];
-    
-            yi = reduce(yi, combine(Aij, xj));
+            const IndexType i_start = std::max<IndexType>(0, -k);
+            const IndexType j_start = std::max<IndexType>(0,  k);
+
+            // number of elements to process in this diagonal
+            const IndexType N = std::min(A.num_rows - i_start, A.num_cols - j_start);
+
+            // part of the diagonal within this block
+            const IndexType n_begin = std::max<IndexType>(0, row_begin - i_start);
+            const IndexType n_end   = std::min<IndexType>(N, row_end   - i_start);
+
+            for(IndexType n = n_begin; n < n_end; n++)
+            {
+                const ValueType& Aij = A.values(i_start + n, i);
+
+                const ValueType& xj = x[j_start + n];
+                      ValueType& yi = y[i_start + n];
+
+                yi = reduce(yi, combine(Aij, xj));
+            }
         }
     }
 }
@@ -199,21 +340,77 @@ void spmv_ell(const Matrix&  A,
 
     const IndexType invalid_index = Matrix::invalid_index;
     
-    for(size_t i = 0; i < A.num_rows; i++)
-        y[i] = initialize(y[i]);
+    const int P = cusp::detail::host::num_parts(A.num_rows * (num_entries_per_row + 1));
 
-    for(size_t n = 0; n < num_entries_per_row; n++)
+    // each block of rows is swept once per column of the ELL arrays
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(static) num_threads(P)
+#endif
+    for(int part = 0; part < P; part++)
     {
-        for(size_t i = 0; i < A.num_rows; i++)
+        const size_t row_begin = uniform_split(A.num_rows, part,     P);
+        const size_t row_end   = uniform_split(A.num_rows, part + 1, P);
+
+        for(size_t i = row_begin; i < row_end; i++)
+            y[i] = initialize(y[i]);
+
+        for(size_t n = 0; n < num_entries_per_row; n++)
         {
-            const IndexType& j   = A.column_indices(i, n);
-            const ValueType& Aij = A.values(i,n);
+            for(size_t i = row_begin; i < row_end; i++)
+            {
+                const IndexType& j   = A.column_indices(i, n);
+                const ValueType& Aij = A.values(i,n);
+
+                if (j != invalid_index)
+                {
+                    const ValueType& xj = x[j];
+                    y[i] = reduce(y[i], combine(Aij, xj));
+                }
+            }
+        }
+    }
+}
+
 
-            if (j != invalid_index)
+// y = A * x with the row sums kept in an accumulator of the Accumulation
+// policy (cusp/detail/accumulator.h)
+template <typename Accumulation,
+          typename Matrix,
+          typename Vector1,
+          typename Vector2>
+void spmv_ell_accumulate(const Matrix&  A,
+                         const Vector1& x,
+                               Vector2& y)
+{
+    typedef typename Matrix::index_type  IndexType;
+    typedef typename Vector2::value_type ValueType;
+
+    const size_t& num_entries_per_row = A.column_indices.num_cols;
+
+    const IndexType invalid_index = Matrix::invalid_index;
+
+    const int P = cusp::detail::host::num_parts(A.num_rows * (num_entries_per_row + 1));
+
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(static) num_threads(P)
+#endif
+    for(int part = 0; part < P; part++)
+    {
+        const size_t row_end = uniform_split(A.num_rows, part + 1, P);
+
+        for(size_t i = uniform_split(A.num_rows, part, P); i < row_end; i++)
+        {
+            cusp::detail::accumulator<ValueType, Accumulation> acc;
+
+            for(size_t n = 0; n < num_entries_per_row; n++)
             {
-                const ValueType& xj = x[j];
-                y[i] = reduce(y[i], combine(Aij, xj));
+                const IndexType& j = A.column_indices(i, n);
+
+                if (j != invalid_index)
+                    acc.add_product(ValueType(A.values(i,n)), ValueType(x[j]));
             }
+
+            y[i] = acc.result();
         }
     }
 }
@@ -228,12 +425,238 @@ void spmv_ell(const Matrix&  A,
 {
     typedef typename Vector2::value_type ValueType;
 
+    if (cusp::current_reduction_mode() == cusp::compensated_reduction)
+    {
+        spmv_ell_accumulate<cusp::detail::compensated_accumulation>(A, x, y);
+        return;
+    }
+
+    if (cusp::detail::host::simd::spmv_ell(A, x, y))
+        return;
+
     spmv_ell(A, x, y,
              cusp::detail::zero_function<ValueType>(),
              thrust::multiplies<ValueType>(),
              thrust::plus<ValueType>());
 }
 
+///////////////
+// SELL SpMV //
+///////////////
+template <typename Matrix,
+          typename Vector1,
+          typename Vector2,
+          typename UnaryFunction,
+          typename BinaryFunction1,
+          typename BinaryFunction2>
+void spmv_sell(const Matrix&  A,
+               const Vector1& x,
+                     Vector2& y,
+               UnaryFunction   initialize,
+               BinaryFunction1 combine,
+               BinaryFunction2 reduce)
+{
+    typedef typename Matrix::index_type  IndexType;
+    typedef typename Vector2::value_type ValueType;
+
+    const IndexType invalid_index = Matrix::invalid_index;
+
+    const size_t slice_height = A.slice_height;
+    const size_t num_slices   = A.num_slices();
+
+    const int P = cusp::detail::host::num_parts(A.num_rows + A.column_indices.size());
+
+    // blocks of whole slices balanced by their stored entries
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(static) num_threads(P)
+#endif
+    for(int part = 0; part < P; part++)
+    {
+        const size_t p_begin = std::min<size_t>(A.num_rows, balanced_split(A.slice_offsets, num_slices, part,     P) * slice_height);
+        const size_t p_end   = std::min<size_t>(A.num_rows, balanced_split(A.slice_offsets, num_slices, part + 1, P) * slice_height);
+
+        for(size_t p = p_begin; p < p_end; p++)
+        {
+            const size_t    s = p / slice_height;
+            const IndexType i = A.row_permutation[p];
+
+            ValueType sum = initialize(y[i]);
+
+            for(IndexType offset = A.slice_offsets[s] + (p % slice_height); offset < A.slice_offsets[s + 1]; offset += slice_height)
+            {
+                const IndexType& j   = A.column_indices[offset];
+                const ValueType& Aij = A.values[offset];
+
+                if (j != invalid_index)
+                {
+                    const ValueType& xj = x[j];
+                    sum = reduce(sum, combine(Aij, xj));
+                }
+            }
+
+            y[i] = sum;
+        }
+    }
+}
+
+
+template <typename Matrix,
+          typename Vector1,
+          typename Vector2>
+void spmv_sell(const Matrix&  A,
+               const Vector1& x,
+                     Vector2& y)
+{
+    typedef typename Vector2::value_type ValueType;
+
+    if (cusp::detail::host::simd::spmv_sell(A, x, y))
+        return;
+
+    spmv_sell(A, x, y,
+              cusp::detail::zero_function<ValueType>(),
+              thrust::multiplies<ValueType>(),
+              thrust::plus<ValueType>());
+}
+
+//////////////
+// BSR SpMV //
+//////////////
+template <typename Matrix,
+          typename Vector1,
+          typename Vector2,
+          typename UnaryFunction,
+          typename BinaryFunction1,
+          typename BinaryFunction2>
+void spmv_bsr(const Matrix&  A,
+              const Vector1& x,
+                    Vector2& y,
+              UnaryFunction   initialize,
+              BinaryFunction1 combine,
+              BinaryFunction2 reduce)
+{
+    typedef typename Matrix::index_type  IndexType;
+    typedef typename Vector2::value_type ValueType;
+
+    const size_t block_size     = A.block_size;
+    const size_t num_block_rows = A.num_block_rows();
+
+    const int P = cusp::detail::host::num_parts(A.num_rows + A.num_entries);
+
+    // blocks of block rows balanced by their number of blocks
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(static) num_threads(P)
+#endif
+    for(int part = 0; part < P; part++)
+    {
+        const size_t bi_end = balanced_split(A.row_offsets, num_block_rows, part + 1, P);
+
+        for(size_t bi = balanced_split(A.row_offsets, num_block_rows, part, P); bi < bi_end; bi++)
+        {
+            for(size_t r = 0; r < block_size; r++)
+            {
+                const size_t i = bi * block_size + r;
+
+                ValueType sum = initialize(y[i]);
+
+                for(IndexType k = A.row_offsets[bi]; k < A.row_offsets[bi + 1]; k++)
+                {
+                    const size_t offset = (k * block_size + r) * block_size;
+                    const size_t col    = A.column_indices[k] * block_size;
+
+                    for(size_t c = 0; c < block_size; c++)
+                    {
+                        const ValueType& Aij = A.values[offset + c];
+                        const ValueType& xj  = x[col + c];
+
+                        sum = reduce(sum, combine(Aij, xj));
+                    }
+                }
+
+                y[i] = sum;
+            }
+        }
+    }
+}
+
+
+template <typename Matrix,
+          typename Vector1,
+          typename Vector2>
+void spmv_bsr(const Matrix&  A,
+              const Vector1& x,
+                    Vector2& y)
+{
+    typedef typename Vector2::value_type ValueType;
+
+    spmv_bsr(A, x, y,
+             cusp::detail::zero_function<ValueType>(),
+             thrust::multiplies<ValueType>(),
+             thrust::plus<ValueType>());
+}
+
+template <typename Matrix,
+          typename Vector1,
+          typename Vector2,
+          typename UnaryFunction,
+          typename BinaryFunction1,
+          typename BinaryFunction2>
+void spmv_csr16(const Matrix&  A,
+                const Vector1& x,
+                      Vector2& y,
+                UnaryFunction   initialize,
+                BinaryFunction1 combine,
+                BinaryFunction2 reduce)
+{
+    typedef typename Matrix::index_type  IndexType;
+    typedef typename Vector2::value_type ValueType;
+
+    const int P = cusp::detail::host::num_parts(A.num_rows + A.num_entries);
+
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(static) num_threads(P)
+#endif
+    for(int part = 0; part < P; part++)
+    {
+        const size_t i_end = balanced_split(A.row_offsets, A.num_rows, part + 1, P);
+
+        for(size_t i = balanced_split(A.row_offsets, A.num_rows, part, P); i < i_end; i++)
+        {
+            const IndexType row_start = A.row_offsets[i];
+            const IndexType row_end   = A.row_offsets[i + 1];
+
+            ValueType accumulator = initialize(y[i]);
+
+            for (IndexType jj = row_start; jj < row_end; jj++)
+            {
+                const IndexType j = IndexType(i) + A.column_offsets[jj];
+
+                const ValueType& Aij = A.values[jj];
+                const ValueType& xj  = x[j];
+
+                accumulator = reduce(accumulator, combine(Aij, xj));
+            }
+
+            y[i] = accumulator;
+        }
+    }
+}
+
+
+template <typename Matrix,
+          typename Vector1,
+          typename Vector2>
+void spmv_csr16(const Matrix&  A,
+                const Vector1& x,
+                      Vector2& y)
+{
+    typedef typename Vector2::value_type ValueType;
+
+    spmv_csr16(A, x, y,
+               cusp::detail::zero_function<ValueType>(),
+               thrust::multiplies<ValueType>(),
+               thrust::plus<ValueType>());
+}
+
 } // end namespace host
 } // end namespace detail
 } // end namespace cusp
@@ -0,0 +1,705 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+#pragma once
+
+#include <cstddef>
+
+#include <thrust/detail/type_traits.h>
+#include <thrust/detail/normal_iterator.h>
+
+#include <cusp/format.h>
+#include <cusp/detail/host/parallel.h>
+
+// Vectorized host kernels for float and double matrices with int indices.
+// AVX2 and AVX-512 versions are compiled with function target attributes and
+// chosen at runtime from the features of the processor, so no architecture
+// flags are needed to build.  They require GCC 7 or Clang 5 on x86 and are
+// skipped in CUDA translation units, whose host front end does not accept the
+// AVX-512 intrinsics of every host compiler.  Host SpMV called from a .cu file
+// therefore always uses the portable kernels in cusp/detail/host/spmv.h; only
+// code compiled by the host compiler (.cpp files) gets the vectorized ones.
+// Define CUSP_NO_HOST_SIMD to always use the portable kernels.
+
+#if !defined(CUSP_NO_HOST_SIMD) && !defined(__CUDACC__) && (defined(__x86_64__) || defined(__i386__)) && \
+    ((defined(__clang__) && __clang_major__ >= 5) || (!defined(__clang__) && defined(__GNUC__) && __GNUC__ >= 7))
+#define __CUSP_USE_HOST_SIMD__
+#include <immintrin.h>
+#endif
+
+namespace cusp
+{
+namespace detail
+{
+namespace host
+{
+namespace simd
+{
+
+// iterators over contiguous host storage
+template <typename Iterator>
+struct is_contiguous : thrust::detail::false_type {};
+
+template <typename T>
+struct is_contiguous<T*> : thrust::detail::true_type {};
+
+template <typename T>
+struct is_contiguous< thrust::detail::normal_iterator<T*> > : thrust::detail::true_type {};
+
+// contiguous arrays of int, or of ValueType when it is float or double
+template <typename Array, typename ValueType>
+struct is_simd_array
+{
+  typedef typename Array::value_type T;
+
+  static const bool value = is_contiguous<typename Array::iterator>::value &&
+                            thrust::detail::is_same<T, ValueType>::value &&
+                            (thrust::detail::is_same<T, int>::value   ||
+                             thrust::detail::is_same<T, float>::value ||
+                             thrust::detail::is_same<T, double>::value);
+};
+
+template <typename Array>
+const typename Array::value_type * host_pointer(const Array& a)
+{
+  return a.size() == 0 ? 0 : &*a.begin();
+}
+
+template <typename Array>
+typename Array::value_type * host_pointer(Array& a)
+{
+  return a.size() == 0 ? 0 : &*a.begin();
+}
+
+#ifdef __CUSP_USE_HOST_SIMD__
+
+#define __CUSP_AVX2   __attribute__((target("avx2,fma")))
+#define __CUSP_AVX512 __attribute__((target("avx512f")))
+
+enum { level_none, level_avx2, level_avx512 };
+
+inline int detect_level(void)
+{
+  __builtin_cpu_init();
+
+  if (__builtin_cpu_supports("avx512f"))
+    return level_avx512;
+
+  if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+    return level_avx2;
+
+  return level_none;
+}
+
+inline int level(void)
+{
+  static const int result = detect_level();
+  return result;
+}
+
+//////////////////////////
+// Vector Operations    //
+//////////////////////////
+
+// The gathers, conversions and reductions use the masked intrinsics with a
+// zero source, since the unmasked ones start from an undefined register which
+// GCC reports as uninitialized under -Wall.
+
+struct avx2_float
+{
+  typedef float   value_type;
+  typedef __m256  vector_type;
+  typedef __m256i index_type;
+  typedef __m256  mask_type;
+
+  static const int width = 8;
+
+  static inline __CUSP_AVX2 vector_type zero(void)              { return _mm256_setzero_ps(); }
+  static inline __CUSP_AVX2 vector_type load(const float * p)   { return _mm256_loadu_ps(p); }
+  static inline __CUSP_AVX2 void        store(float * p, vector_type v) { _mm256_storeu_ps(p, v); }
+  static inline __CUSP_AVX2 index_type  load_index(const int * p) { return _mm256_loadu_si256((const __m256i *) p); }
+
+  static inline __CUSP_AVX2 vector_type gather(const float * x, index_type j) { return _mm256_mask_i32gather_ps(zero(), x, j, _mm256_castsi256_ps(_mm256_set1_epi32(-1)), 4); }
+  static inline __CUSP_AVX2 vector_type fmadd(vector_type a, vector_type b, vector_type c) { return _mm256_fmadd_ps(a, b, c); }
+
+  // lanes whose column index is not the padding index -1
+  static inline __CUSP_AVX2 mask_type valid(index_type j)
+  {
+    return _mm256_castsi256_ps(_mm256_cmpgt_epi32(j, _mm256_set1_epi32(-1)));
+  }
+
+  static inline __CUSP_AVX2 vector_type gather(const float * x, index_type j, mask_type m)
+  {
+    return _mm256_mask_i32gather_ps(zero(), x, j, m, 4);
+  }
+
+  static inline __CUSP_AVX2 vector_type fmadd(vector_type a, vector_type b, vector_type c, mask_type m)
+  {
+    return _mm256_blendv_ps(c, _mm256_fmadd_ps(a, b, c), m);
+  }
+
+  // the first n lanes, and loads of those lanes with zeros elsewhere
+  static inline __CUSP_AVX2 mask_type first(int n)
+  {
+    return _mm256_castsi256_ps(_mm256_cmpgt_epi32(_mm256_set1_epi32(n), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7)));
+  }
+
+  static inline __CUSP_AVX2 vector_type load(const float * p, mask_type m)     { return _mm256_maskload_ps(p, _mm256_castps_si256(m)); }
+  static inline __CUSP_AVX2 index_type  load_index(const int * p, mask_type m) { return _mm256_maskload_epi32(p, _mm256_castps_si256(m)); }
+
+  static inline __CUSP_AVX2 float sum(vector_type v)
+  {
+    __m128 s = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+    s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+    return _mm_cvtss_f32(s);
+  }
+};
+
+struct avx2_double
+{
+  typedef double  value_type;
+  typedef __m256d vector_type;
+  typedef __m128i index_type;
+  typedef __m256d mask_type;
+
+  static const int width = 4;
+
+  static inline __CUSP_AVX2 vector_type zero(void)              { return _mm256_setzero_pd(); }
+  static inline __CUSP_AVX2 vector_type load(const double * p)  { return _mm256_loadu_pd(p); }
+  static inline __CUSP_AVX2 void        store(double * p, vector_type v) { _mm256_storeu_pd(p, v); }
+  static inline __CUSP_AVX2 index_type  load_index(const int * p) { return _mm_loadu_si128((const __m128i *) p); }
+
+  static inline __CUSP_AVX2 vector_type gather(const double * x, index_type j) { return _mm256_mask_i32gather_pd(zero(), x, j, _mm256_castsi256_pd(_mm256_set1_epi64x(-1)), 8); }
+  static inline __CUSP_AVX2 vector_type fmadd(vector_type a, vector_type b, vector_type c) { return _mm256_fmadd_pd(a, b, c); }
+
+  static inline __CUSP_AVX2 mask_type valid(index_type j)
+  {
+    return _mm256_castsi256_pd(_mm256_cvtepi32_epi64(_mm_cmpgt_epi32(j, _mm_set1_epi32(-1))));
+  }
+
+  static inline __CUSP_AVX2 vector_type gather(const double * x, index_type j, mask_type m)
+  {
+    return _mm256_mask_i32gather_pd(zero(), x, j, m, 8);
+  }
+
+  static inline __CUSP_AVX2 vector_type fmadd(vector_type a, vector_type b, vector_type c, mask_type m)
+  {
+    return _mm256_blendv_pd(c, _mm256_fmadd_pd(a, b, c), m);
+  }
+
+  static inline __CUSP_AVX2 mask_type first(int n)
+  {
+    return _mm256_castsi256_pd(_mm256_cmpgt_epi64(_mm256_set1_epi64x(n), _mm256_setr_epi64x(0, 1, 2, 3)));
+  }
+
+  static inline __CUSP_AVX2 vector_type load(const double * p, mask_type m) { return _mm256_maskload_pd(p, _mm256_castpd_si256(m)); }
+
+  static inline __CUSP_AVX2 index_type load_index(const int * p, mask_type m)
+  {
+    // narrow the 64-bit lane mask to the four 32-bit indices
+    const __m256i w = _mm256_permutevar8x32_epi32(_mm256_castpd_si256(m), _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7));
+    return _mm_maskload_epi32(p, _mm256_castsi256_si128(w));
+  }
+
+  static inline __CUSP_AVX2 double sum(vector_type v)
+  {
+    __m128d s = _mm_add_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+    s = _mm_add_sd(s, _mm_unpackhi_pd(s, s));
+    return _mm_cvtsd_f64(s);
+  }
+};
+
+struct avx512_float
+{
+  typedef float     value_type;
+  typedef __m512    vector_type;
+  typedef __m512i   index_type;
+  typedef __mmask16 mask_type;
+
+  static const int width = 16;
+
+  static inline __CUSP_AVX512 vector_type zero(void)              { return _mm512_setzero_ps(); }
+  static inline __CUSP_AVX512 vector_type load(const float * p)   { return _mm512_loadu_ps(p); }
+  static inline __CUSP_AVX512 void        store(float * p, vector_type v) { _mm512_storeu_ps(p, v); }
+  static inline __CUSP_AVX512 index_type  load_index(const int * p) { return _mm512_loadu_si512(p); }
+
+  static inline __CUSP_AVX512 vector_type gather(const float * x, index_type j) { return _mm512_mask_i32gather_ps(zero(), 0xFFFF, j, x, 4); }
+  static inline __CUSP_AVX512 vector_type fmadd(vector_type a, vector_type b, vector_type c) { return _mm512_fmadd_ps(a, b, c); }
+
+  static inline __CUSP_AVX512 mask_type valid(index_type j)
+  {
+    return _mm512_cmpgt_epi32_mask(j, _mm512_set1_epi32(-1));
+  }
+
+  static inline __CUSP_AVX512 vector_type gather(const float * x, index_type j, mask_type m)
+  {
+    return _mm512_mask_i32gather_ps(zero(), m, j, x, 4);
+  }
+
+  static inline __CUSP_AVX512 vector_type fmadd(vector_type a, vector_type b, vector_type c, mask_type m)
+  {
+    return _mm512_mask3_fmadd_ps(a, b, c, m);
+  }
+
+  static inline __CUSP_AVX512 mask_type   first(int n)                           { return mask_type((1u << n) - 1); }
+  static inline __CUSP_AVX512 vector_type load(const float * p, mask_type m)     { return _mm512_maskz_loadu_ps(m, p); }
+  static inline __CUSP_AVX512 index_type  load_index(const int * p, mask_type m) { return _mm512_maskz_loadu_epi32(m, p); }
+
+  static inline __CUSP_AVX512 float sum(vector_type v)
+  {
+    const __m256 lo = _mm256_castpd_ps(_mm512_maskz_extractf64x4_pd(0xF, _mm512_castps_pd(v), 0));
+    const __m256 hi = _mm256_castpd_ps(_mm512_maskz_extractf64x4_pd(0xF, _mm512_castps_pd(v), 1));
+    return avx2_float::sum(_mm256_add_ps(lo, hi));
+  }
+};
+
+struct avx512_double
+{
+  typedef double   value_type;
+  typedef __m512d  vector_type;
+  typedef __m256i  index_type;
+  typedef __mmask8 mask_type;
+
+  static const int width = 8;
+
+  static inline __CUSP_AVX512 vector_type zero(void)              { return _mm512_setzero_pd(); }
+  static inline __CUSP_AVX512 vector_type load(const double * p)  { return _mm512_loadu_pd(p); }
+  static inline __CUSP_AVX512 void        store(double * p, vector_type v) { _mm512_storeu_pd(p, v); }
+  static inline __CUSP_AVX512 index_type  load_index(const int * p) { return _mm256_loadu_si256((const __m256i *) p); }
+
+  static inline __CUSP_AVX512 vector_type gather(const double * x, index_type j) { return _mm512_mask_i32gather_pd(zero(), 0xFF, j, x, 8); }
+  static inline __CUSP_AVX512 vector_type fmadd(vector_type a, vector_type b, vector_type c) { return _mm512_fmadd_pd(a, b, c); }
+
+  static inline __CUSP_AVX512 mask_type valid(index_type j)
+  {
+    return _mm512_cmpgt_epi64_mask(_mm512_maskz_cvtepi32_epi64(0xFF, j), _mm512_set1_epi64(-1));
+  }
+
+  static inline __CUSP_AVX512 vector_type gather(const double * x, index_type j, mask_type m)
+  {
+    return _mm512_mask_i32gather_pd(zero(), m, j, x, 8);
+  }
+
+  static inline __CUSP_AVX512 vector_type fmadd(vector_type a, vector_type b, vector_type c, mask_type m)
+  {
+    return _mm512_mask3_fmadd_pd(a, b, c, m);
+  }
+
+  static inline __CUSP_AVX512 mask_type   first(int n)                          { return mask_type((1u << n) - 1); }
+  static inline __CUSP_AVX512 vector_type load(const double * p, mask_type m)   { return _mm512_maskz_loadu_pd(m, p); }
+
+  static inline __CUSP_AVX512 index_type load_index(const int * p, mask_type m)
+  {
+    return _mm512_maskz_extracti64x4_epi64(0xF, _mm512_maskz_loadu_epi32(__mmask16(m), p), 0);
+  }
+
+  static inline __CUSP_AVX512 double sum(vector_type v)
+  {
+    return avx2_double::sum(_mm256_add_pd(_mm512_maskz_extractf64x4_pd(0xF, v, 0), _mm512_maskz_extractf64x4_pd(0xF, v, 1)));
+  }
+};
+
+template <typename ValueType> struct avx2_ops;
+template <> struct avx2_ops<float>  { typedef avx2_float  type; };
+template <> struct avx2_ops<double> { typedef avx2_double type; };
+
+template <typename ValueType> struct avx512_ops;
+template <> struct avx512_ops<float>  { typedef avx512_float  type; };
+template <> struct avx512_ops<double> { typedef avx512_double type; };
+
+//////////////////////////
+// Row Kernels          //
+//////////////////////////
+
+// The kernels are repeated for each instruction set since the target of a
+// function cannot depend on its template arguments.
+
+// CSR : each row is summed in vector lanes with gathered x values
+#define __CUSP_CSR_ROWS_BODY                                                            \
+  {                                                                                     \
+    typedef typename Ops::vector_type VectorType;                                       \
+    typedef typename Ops::index_type  IndexVector;                                      \
+    typedef typename Ops::mask_type   MaskType;                                         \
+                                                                                        \
+    const int W = Ops::width;                                                           \
+                                                                                        \
+    for(size_t i = row_begin; i < row_end; i++)                                         \
+    {                                                                                   \
+      int jj = Ap[i];                                                                   \
+      const int jj_end = Ap[i + 1];                                                     \
+                                                                                        \
+      VectorType accumulator = Ops::zero();                                             \
+                                                                                        \
+      for(; jj + W <= jj_end; jj += W)                                                  \
+        accumulator = Ops::fmadd(Ops::load(Ax + jj), Ops::gather(x, Ops::load_index(Aj + jj)), accumulator); \
+                                                                                        \
+      /* the remainder of the row in masked lanes */                                    \
+      if (jj < jj_end)                                                                  \
+      {                                                                                 \
+        const MaskType    m = Ops::first(jj_end - jj);                                  \
+        const IndexVector j = Ops::load_index(Aj + jj, m);                              \
+                                                                                        \
+        accumulator = Ops::fmadd(Ops::load(Ax + jj, m), Ops::gather(x, j, m), accumulator, m); \
+      }                                                                                 \
+                                                                                        \
+      y[i] = Ops::sum(accumulator);                                                     \
+    }                                                                                   \
+  }
+
+// ELL : consecutive rows of the column-major arrays fill the vector lanes
+#define __CUSP_ELL_ROWS_BODY                                                            \
+  {                                                                                     \
+    typedef typename Ops::vector_type VectorType;                                       \
+    typedef typename Ops::index_type  IndexVector;                                      \
+    typedef typename Ops::mask_type   MaskType;                                         \
+                                                                                        \
+    const int W = Ops::width;                                                           \
+                                                                                        \
+    size_t i = row_begin;                                                               \
+                                                                                        \
+    for(; i + W <= row_end; i += W)                                                     \
+    {                                                                                   \
+      VectorType accumulator = Ops::zero();                                             \
+                                                                                        \
+      for(size_t n = 0; n < num_entries_per_row; n++)                                   \
+      {                                                                                 \
+        const size_t offset = n * pitch + i;                                            \
+                                                                                        \
+        const IndexVector j = Ops::load_index(Aj + offset);                             \
+        const MaskType    m = Ops::valid(j);                                            \
+                                                                                        \
+        accumulator = Ops::fmadd(Ops::load(Ax + offset), Ops::gather(x, j, m), accumulator, m); \
+      }                                                                                 \
+                                                                                        \
+      Ops::store(y + i, accumulator);                                                   \
+    }                                                                                   \
+                                                                                        \
+    for(; i < row_end; i++)                                                             \
+    {                                                                                   \
+      typename Ops::value_type sum = 0;                                                 \
+                                                                                        \
+      for(size_t n = 0; n < num_entries_per_row; n++)                                   \
+      {                                                                                 \
+        const int j = Aj[n * pitch + i];                                                \
+                                                                                        \
+        if (j != -1)                                                                    \
+          sum += Ax[n * pitch + i] * x[j];                                              \
+      }                                                                                 \
+                                                                                        \
+      y[i] = sum;                                                                       \
+    }                                                                                   \
+  }
+
+// SELL : consecutive stored rows of a slice fill the vector lanes and the
+// results are written through the row permutation
+#define __CUSP_SELL_ROWS_BODY                                                           \
+  {                                                                                     \
+    typedef typename Ops::value_type  ValueType;                                        \
+    typedef typename Ops::vector_type VectorType;                                       \
+    typedef typename Ops::index_type  IndexVector;                                      \
+    typedef typename Ops::mask_type   MaskType;                                         \
+                                                                                        \
+    const int W = Ops::width;                                                           \
+                                                                                        \
+    ValueType result[Ops::width];                                                       \
+                                                                                        \
+    for(size_t s = slice_begin; s < slice_end; s++)                                     \
+    {                                                                                   \
+      const size_t width = (slice_offsets[s + 1] - slice_offsets[s]) / slice_height;    \
+                                                                                        \
+      for(size_t q = 0; q < slice_height; q += W)                                       \
+      {                                                                                 \
+        VectorType accumulator = Ops::zero();                                           \
+                                                                                        \
+        for(size_t k = 0; k < width; k++)                                               \
+        {                                                                               \
+          const size_t offset = slice_offsets[s] + k * slice_height + q;                \
+                                                                                        \
+          const IndexVector j = Ops::load_index(Aj + offset);                           \
+          const MaskType    m = Ops::valid(j);                                          \
+                                                                                        \
+          accumulator = Ops::fmadd(Ops::load(Ax + offset), Ops::gather(x, j, m), accumulator, m); \
+        }                                                                               \
+                                                                                        \
+        Ops::store(result, accumulator);                                                \
+                                                                                        \
+        const size_t p_begin = s * slice_height + q;                                    \
+        const size_t p_end   = p_begin + W < num_rows ? p_begin + W : num_rows;         \
+                                                                                        \
+        for(size_t p = p_begin; p < p_end; p++)                                         \
+          y[permutation[p]] = result[p - p_begin];                                      \
+      }                                                                                 \
+    }                                                                                   \
+  }
+
+#define __CUSP_CSR_ROWS_ARGS  const int * Ap, const int * Aj, const typename Ops::value_type * Ax, \
+                              const typename Ops::value_type * x, typename Ops::value_type * y,    \
+                              size_t row_begin, size_t row_end
+#define __CUSP_ELL_ROWS_ARGS  const int * Aj, const typename Ops::value_type * Ax,                 \
+                              size_t pitch, size_t num_entries_per_row,                            \
+                              const typename Ops::value_type * x, typename Ops::value_type * y,    \
+                              size_t row_begin, size_t row_end
+#define __CUSP_SELL_ROWS_ARGS const int * slice_offsets, const int * permutation,                  \
+                              const int * Aj, const typename Ops::value_type * Ax,                 \
+                              size_t slice_height, size_t num_rows,                                \
+                              const typename Ops::value_type * x, typename Ops::value_type * y,    \
+                              size_t slice_begin, size_t slice_end
+
+template <typename Ops> __CUSP_AVX2   void csr_rows_avx2    (__CUSP_CSR_ROWS_ARGS)  __CUSP_CSR_ROWS_BODY
+template <typename Ops> __CUSP_AVX512 void csr_rows_avx512  (__CUSP_CSR_ROWS_ARGS)  __CUSP_CSR_ROWS_BODY
+template <typename Ops> __CUSP_AVX2   void ell_rows_avx2    (__CUSP_ELL_ROWS_ARGS)  __CUSP_ELL_ROWS_BODY
+template <typename Ops> __CUSP_AVX512 void ell_rows_avx512  (__CUSP_ELL_ROWS_ARGS)  __CUSP_ELL_ROWS_BODY
+template <typename Ops> __CUSP_AVX2   void sell_rows_avx2   (__CUSP_SELL_ROWS_ARGS) __CUSP_SELL_ROWS_BODY
+template <typename Ops> __CUSP_AVX512 void sell_rows_avx512 (__CUSP_SELL_ROWS_ARGS) __CUSP_SELL_ROWS_BODY
+
+#undef __CUSP_CSR_ROWS_BODY
+#undef __CUSP_ELL_ROWS_BODY
+#undef __CUSP_SELL_ROWS_BODY
+#undef __CUSP_CSR_ROWS_ARGS
+#undef __CUSP_ELL_ROWS_ARGS
+#undef __CUSP_SELL_ROWS_ARGS
+#undef __CUSP_AVX2
+#undef __CUSP_AVX512
+
+//////////////////////////
+// Entry Points         //
+//////////////////////////
+
+template <typename Matrix, typename Vector1, typename Vector2>
+bool spmv_csr(const Matrix& A, const Vector1& x, Vector2& y, thrust::detail::true_type)
+{
+  typedef typename Vector2::value_type ValueType;
+
+  const int simd_level = level();
+
+  if (simd_level == level_none)
+    return false;
+
+  const int       * Ap = host_pointer(A.row_offsets);
+  const int       * Aj = host_pointer(A.column_indices);
+  const ValueType * Ax = host_pointer(A.values);
+  const ValueType * xp = host_pointer(x);
+        ValueType * yp = host_pointer(y);
+
+  const int P = cusp::detail::host::num_parts(A.num_rows + A.num_entries);
+
+#ifdef _OPENMP
+  #pragma omp parallel for schedule(static) num_threads(P)
+#endif
+  for(int part = 0; part < P; part++)
+  {
+    const size_t row_begin = balanced_split(A.row_offsets, A.num_rows, part,     P);
+    const size_t row_end   = balanced_split(A.row_offsets, A.num_rows, part + 1, P);
+
+    if (simd_level == level_avx512)
+      csr_rows_avx512<typename avx512_ops<ValueType>::type>(Ap, Aj, Ax, xp, yp, row_begin, row_end);
+    else
+      csr_rows_avx2<typename avx2_ops<ValueType>::type>(Ap, Aj, Ax, xp, yp, row_begin, row_end);
+  }
+
+  return true;
+}
+
+template <typename Matrix, typename Vector1, typename Vector2>
+bool spmv_ell(const Matrix& A, const Vector1& x, Vector2& y, thrust::detail::true_type)
+{
+  typedef typename Vector2::value_type ValueType;
+
+  const int simd_level = level();
+
+  if (simd_level == level_none || Matrix::invalid_index != -1)
+    return false;
+
+  const size_t num_entries_per_row = A.column_indices.num_cols;
+  const size_t pitch               = A.column_indices.pitch;
+
+  // both arrays are addressed with the pitch of the column indices
+  if (A.values.pitch != pitch)
+    return false;
+
+  const int       * Aj = host_pointer(A.column_indices.values);
+  const ValueType * Ax = host_pointer(A.values.values);
+  const ValueType * xp = host_pointer(x);
+        ValueType * yp = host_pointer(y);
+
+  const int P = cusp::detail::host::num_parts(A.num_rows * (num_entries_per_row + 1));
+
+#ifdef _OPENMP
+  #pragma omp parallel for schedule(static) num_threads(P)
+#endif
+  for(int part = 0; part < P; part++)
+  {
+    const size_t row_begin = uniform_split(A.num_rows, part,     P);
+    const size_t row_end   = uniform_split(A.num_rows, part + 1, P);
+
+    if (simd_level == level_avx512)
+      ell_rows_avx512<typename avx512_ops<ValueType>::type>(Aj, Ax, pitch, num_entries_per_row, xp, yp, row_begin, row_end);
+    else
+      ell_rows_avx2<typename avx2_ops<ValueType>::type>(Aj, Ax, pitch, num_entries_per_row, xp, yp, row_begin, row_end);
+  }
+
+  return true;
+}
+
+template <typename Matrix, typename Vector1, typename Vector2>
+bool spmv_sell(const Matrix& A, const Vector1& x, Vector2& y, thrust::detail::true_type)
+{
+  typedef typename Vector2::value_type ValueType;
+
+  const int simd_level = level();
+
+  if (simd_level == level_none || Matrix::invalid_index != -1)
+    return false;
+
+  const size_t W = simd_level == level_avx512 ? size_t(avx512_ops<ValueType>::type::width)
+                                              : size_t(avx2_ops<ValueType>::type::width);
+
+  // the vector lanes must not cross slices
+  if (A.slice_height % W != 0)
+    return false;
+
+  const int       * So = host_pointer(A.slice_offsets);
+  const int       * Sp = host_pointer(A.row_permutation);
+  const int       * Aj = host_pointer(A.column_indices);
+  const ValueType * Ax = host_pointer(A.values);
+  const ValueType * xp = host_pointer(x);
+        ValueType * yp = host_pointer(y);
+
+  const size_t num_slices = A.num_slices();
+
+  const int P = cusp::detail::host::num_parts(A.num_rows + A.column_indices.size());
+
+#ifdef _OPENMP
+  #pragma omp parallel for schedule(static) num_threads(P)
+#endif
+  for(int part = 0; part < P; part++)
+  {
+    const size_t slice_begin = balanced_split(A.slice_offsets, num_slices, part,     P);
+    const size_t slice_end   = balanced_split(A.slice_offsets, num_slices, part + 1, P);
+
+    if (simd_level == level_avx512)
+      sell_rows_avx512<typename avx512_ops<ValueType>::type>(So, Sp, Aj, Ax, A.slice_height, A.num_rows, xp, yp, slice_begin, slice_end);
+    else
+      sell_rows_avx2<typename avx2_ops<ValueType>::type>(So, Sp, Aj, Ax, A.slice_height, A.num_rows, xp, yp, slice_begin, slice_end);
+  }
+
+  return true;
+}
+
+#endif // __CUSP_USE_HOST_SIMD__
+
+// other types and configurations use the portable kernels
+template <typename Matrix, typename Vector1, typename Vector2>
+bool spmv_csr(const Matrix&, const Vector1&, Vector2&, thrust::detail::false_type)
+{
+  return false;
+}
+
+template <typename Matrix, typename Vector1, typename Vector2>
+bool spmv_ell(const Matrix&, const Vector1&, Vector2&, thrust::detail::false_type)
+{
+  return false;
+}
+
+template <typename Matrix, typename Vector1, typename Vector2>
+bool spmv_sell(const Matrix&, const Vector1&, Vector2&, thrust::detail::false_type)
+{
+  return false;
+}
+
+template <typename Matrix, typename Vector1, typename Vector2>
+struct is_simd_csr
+{
+  typedef typename Vector2::value_type ValueType;
+
+  static const bool value =
+#ifdef __CUSP_USE_HOST_SIMD__
+    is_simd_array<typename Matrix::row_offsets_array_type,    int>::value &&
+    is_simd_array<typename Matrix::column_indices_array_type, int>::value &&
+    is_simd_array<typename Matrix::values_array_type,   ValueType>::value &&
+    is_simd_array<Vector1, ValueType>::value &&
+    is_simd_array<Vector2, ValueType>::value &&
+    !thrust::detail::is_same<ValueType, int>::value;
+#else
+    false;
+#endif
+};
+
+template <typename Matrix, typename Vector1, typename Vector2>
+struct is_simd_ell
+{
+  typedef typename Vector2::value_type ValueType;
+
+  static const bool value =
+#ifdef __CUSP_USE_HOST_SIMD__
+    is_simd_array<typename Matrix::column_indices_array_type::values_array_type, int>::value &&
+    is_simd_array<typename Matrix::values_array_type::values_array_type,   ValueType>::value &&
+    thrust::detail::is_same<typename Matrix::column_indices_array_type::orientation, cusp::column_major>::value &&
+    thrust::detail::is_same<typename Matrix::values_array_type::orientation,         cusp::column_major>::value &&
+    is_simd_array<Vector1, ValueType>::value &&
+    is_simd_array<Vector2, ValueType>::value &&
+    !thrust::detail::is_same<ValueType, int>::value;
+#else
+    false;
+#endif
+};
+
+template <typename Matrix, typename Vector1, typename Vector2>
+struct is_simd_sell
+{
+  typedef typename Vector2::value_type ValueType;
+
+  static const bool value =
+#ifdef __CUSP_USE_HOST_SIMD__
+    is_simd_array<typename Matrix::slice_offsets_array_type,   int>::value &&
+    is_simd_array<typename Matrix::row_permutation_array_type, int>::value &&
+    is_simd_array<typename Matrix::column_indices_array_type,  int>::value &&
+    is_simd_array<typename Matrix::values_array_type,    ValueType>::value &&
+    is_simd_array<Vector1, ValueType>::value &&
+    is_simd_array<Vector2, ValueType>::value &&
+    !thrust::detail::is_same<ValueType, int>::value;
+#else
+    false;
+#endif
+};
+
+// y = A * x with a vectorized kernel, returns false when none applies
+template <typename Matrix, typename Vector1, typename Vector2>
+bool spmv_csr(const Matrix& A, const Vector1& x, Vector2& y)
+{
+  return spmv_csr(A, x, y, thrust::detail::integral_constant<bool, is_simd_csr<Matrix,Vector1,Vector2>::value>());
+}
+
+template <typename Matrix, typename Vector1, typename Vector2>
+bool spmv_ell(const Matrix& A, const Vector1& x, Vector2& y)
+{
+  return spmv_ell(A, x, y, thrust::detail::integral_constant<bool, is_simd_ell<Matrix,Vector1,Vector2>::value>());
+}
+
+template <typename Matrix, typename Vector1, typename Vector2>
+bool spmv_sell(const Matrix& A, const Vector1& x, Vector2& y)
+{
+  return spmv_sell(A, x, y, thrust::detail::integral_constant<bool, is_simd_sell<Matrix,Vector1,Vector2>::value>());
+}
+
+} // end namespace simd
+} // end namespace host
+} // end namespace detail
+} // end namespace cusp
+
+#undef __CUSP_USE_HOST_SIMD__
@@ -0,0 +1,87 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include <cusp/array1d.h>
+#include <cusp/coo_matrix.h>
+#include <cusp/multiply.h>
+
+#include <cusp/detail/device/launch_config.h>
+
+#include <cuda_runtime_api.h>
+
+#include <stdlib.h>
+
+namespace cusp
+{
+
+inline void initialize(int device, bool lazy_module_loading)
+{
+    // read by the CUDA runtime when it creates the context
+    if (lazy_module_loading && getenv("CUDA_MODULE_LOADING") == NULL)
+    {
+#if defined(_WIN32)
+        _putenv_s("CUDA_MODULE_LOADING", "LAZY");
+#else
+        setenv("CUDA_MODULE_LOADING", "LAZY", 0);
+#endif
+    }
+
+    if (device >= 0)
+        cudaSetDevice(device);
+
+    // creates the primary context of the device
+    cudaFree(0);
+
+    // the properties and the launch database used by the launchers
+    cusp::detail::device::arch::current_device_description();
+    cusp::detail::device::arch::current_launch_database().initialize();
+}
+
+template <typename MatrixType>
+void initialize_spmv(size_t entries_per_row)
+{
+    typedef typename MatrixType::index_type IndexType;
+    typedef typename MatrixType::value_type ValueType;
+
+    // a band of entries_per_row diagonals
+    const size_t num_rows = 256;
+    const size_t width    = entries_per_row < num_rows ? entries_per_row : num_rows;
+
+    cusp::coo_matrix<IndexType, ValueType, cusp::host_memory> A(num_rows, num_rows, num_rows * width);
+
+    for (size_t i = 0, n = 0; i < num_rows; i++)
+    {
+        const size_t first = i < width / 2 ? 0 : (i - width / 2 + width > num_rows ? num_rows - width : i - width / 2);
+
+        for (size_t k = 0; k < width; k++, n++)
+        {
+            A.row_indices[n]    = i;
+            A.column_indices[n] = first + k;
+            A.values[n]         = ValueType(1);
+        }
+    }
+
+    MatrixType M(A);
+
+    cusp::array1d<ValueType, typename MatrixType::memory_space> x(num_rows, ValueType(1));
+    cusp::array1d<ValueType, typename MatrixType::memory_space> y(num_rows);
+
+    cusp::multiply(M, x, y);
+
+    cudaDeviceSynchronize();
+}
+
+} // end namespace cusp
@@ -18,8 +18,11 @@
 
 #include <cusp/array1d.h>
 #include <cusp/array2d.h>
+#include <cusp/exception.h>
 #include <cusp/linear_operator.h>
+#include <cusp/multiply.h>
 
+#include <algorithm>
 #include <cmath>
 
 namespace cusp
@@ -27,46 +30,125 @@ namespace cusp
 namespace detail
 {
 
+// block size of the blocked factorizations
+const int DENSE_BLOCK_SIZE = 64;
+
+// C[i,j] -= sum_k A[i,k] * B[k,j] over a tile of the trailing submatrix
+// where A, B and C are views into the same matrix with strides (rs, cs)
+template <typename ValueType>
+void dense_update_tile(ValueType * M, const int rs, const int cs,
+                       const int i_begin, const int i_end,
+                       const int j_begin, const int j_end,
+                       const int k_begin, const int k_end)
+{
+    if (cs == 1)
+    {
+        // row-major: innermost loop runs along a row
+        for (int i = i_begin; i < i_end; i++)
+            for (int k = k_begin; k < k_end; k++)
+            {
+                const ValueType a = M[i * rs + k];
+                ValueType * row_i = M + i * rs;
+                const ValueType * row_k = M + k * rs;
+
+                for (int j = j_begin; j < j_end; j++)
+                    row_i[j] -= a * row_k[j];
+            }
+    }
+    else
+    {
+        // column-major: innermost loop runs along a column
+        for (int j = j_begin; j < j_end; j++)
+            for (int k = k_begin; k < k_end; k++)
+            {
+                const ValueType b = M[k + j * cs];
+                ValueType * col_j = M + j * cs;
+                const ValueType * col_k = M + k * cs;
+
+                for (int i = i_begin; i < i_end; i++)
+                    col_j[i] -= col_k[i] * b;
+            }
+    }
+}
+
+// Blocked right-looking LU factorization with partial pivoting.
+//
+// Each step factors a panel of DENSE_BLOCK_SIZE columns with the
+// unblocked algorithm, computes the corresponding block row of U and
+// applies the rank-DENSE_BLOCK_SIZE update to the trailing submatrix
+// tile by tile, so the trailing update (where nearly all the work is)
+// runs out of cache.  The pivot sequence and the factors are the same as
+// those of the unblocked algorithm.
 template <typename IndexType, typename ValueType, typename MemorySpace, typename Orientation>
 int lu_factor(cusp::array2d<ValueType,MemorySpace,Orientation>& A,
               cusp::array1d<IndexType,MemorySpace>& pivot)
 {
-    const int n = A.num_rows;
+    const int n  = A.num_rows;
+    const int NB = DENSE_BLOCK_SIZE;
 
-    // For each row and column, k = 0, ..., n-1,
-    for (int k = 0; k < n; k++)
+    if (n == 0)
+        return 0;
+
+    // strides between consecutive rows and columns
+    const int rs = cusp::detail::index_of(1, 0, int(A.pitch), Orientation());
+    const int cs = cusp::detail::index_of(0, 1, int(A.pitch), Orientation());
+
+    ValueType * M = &A.values[0];
+
+    for (int kb = 0; kb < n; kb += NB)
     {
-        // find the pivot row
-        pivot[k] = k;
-        ValueType max = std::fabs(A(k,k));
-        
-        for (int j = k + 1; j < n; j++)
+        const int kb_end = std::min(kb + NB, n);
+
+        // factor the panel A[kb:n, kb:kb_end]
+        for (int k = kb; k < kb_end; k++)
         {
-            if (max < std::fabs(A(j,k)))
+            // find the pivot row
+            pivot[k] = k;
+            ValueType max = std::fabs(M[k * rs + k * cs]);
+
+            for (int i = k + 1; i < n; i++)
             {
-                max = std::fabs(A(j,k));
-                pivot[k] = j;
+                if (max < std::fabs(M[i * rs + k * cs]))
+                {
+                    max = std::fabs(M[i * rs + k * cs]);
+                    pivot[k] = i;
+                }
             }
-        }
 
-        // and if the pivot row differs from the current row, then
-        // interchange the two rows.
-        if (pivot[k] != k)
-            for (int j = 0; j < n; j++)
-                std::swap(A(k,j), A(pivot[k],j));
+            // and if the pivot row differs from the current row, then
+            // interchange the two rows.
+            if (pivot[k] != k)
+                for (int j = 0; j < n; j++)
+                    std::swap(M[k * rs + j * cs], M[pivot[k] * rs + j * cs]);
 
-        // and if the matrix is singular, return error
-        if (A(k,k) == 0.0)
-            return -1;
+            // and if the matrix is singular, return error
+            if (M[k * rs + k * cs] == ValueType(0))
+                return -1;
 
-        // otherwise find the lower triangular matrix elements for column k. 
-        for (int i = k + 1; i < n; i++)
-            A(i,k) /= A(k,k);
+            // otherwise find the lower triangular matrix elements for column k. 
+            const ValueType inv_pivot = ValueType(1) / M[k * rs + k * cs];
 
-        // update remaining matrix
-        for (int i = k + 1; i < n; i++)
-            for (int j = k + 1; j < n; j++)
-                A(i,j) -= A(i,k) * A(k,j);
+            for (int i = k + 1; i < n; i++)
+                M[i * rs + k * cs] *= inv_pivot;
+
+            // update the remainder of the panel
+            dense_update_tile(M, rs, cs, k + 1, n, k + 1, kb_end, k, k + 1);
+        }
+
+        if (kb_end == n)
+            break;
+
+        // U[kb:kb_end, kb_end:n] <- L11^{-1} A[kb:kb_end, kb_end:n]
+        for (int k = kb; k < kb_end; k++)
+            dense_update_tile(M, rs, cs, k + 1, kb_end, kb_end, n, k, k + 1);
+
+        // A22 <- A22 - L21 * U12
+        for (int ib = kb_end; ib < n; ib += NB)
+            for (int jb = kb_end; jb < n; jb += NB)
+                dense_update_tile(M, rs, cs,
+                                  ib, std::min(ib + NB, n),
+                                  jb, std::min(jb + NB, n),
+                                  kb, kb_end);
     }
 
     return 0;
@@ -113,6 +195,115 @@ int lu_solve(const cusp::array2d<ValueType,MemorySpace,Orientation>& A,
 }
 
 
+// Blocked Cholesky factorization A = L * L^T of a symmetric positive
+// definite matrix.  On return the lower triangle of A holds L, and the
+// strict upper triangle is left unchanged.  Returns -1 if A is not
+// positive definite.
+template <typename ValueType, typename MemorySpace, typename Orientation>
+int cholesky_factor(cusp::array2d<ValueType,MemorySpace,Orientation>& A)
+{
+    const int n  = A.num_rows;
+    const int NB = DENSE_BLOCK_SIZE;
+
+    if (n == 0)
+        return 0;
+
+    const int rs = cusp::detail::index_of(1, 0, int(A.pitch), Orientation());
+    const int cs = cusp::detail::index_of(0, 1, int(A.pitch), Orientation());
+
+    ValueType * M = &A.values[0];
+
+    for (int kb = 0; kb < n; kb += NB)
+    {
+        const int kb_end = std::min(kb + NB, n);
+
+        // factor the panel A[kb:n, kb:kb_end]
+        for (int k = kb; k < kb_end; k++)
+        {
+            ValueType diagonal = M[k * rs + k * cs];
+
+            for (int j = kb; j < k; j++)
+                diagonal -= M[k * rs + j * cs] * M[k * rs + j * cs];
+
+            if (!(diagonal > ValueType(0)))
+                return -1;
+
+            diagonal = std::sqrt(diagonal);
+            M[k * rs + k * cs] = diagonal;
+
+            for (int i = k + 1; i < n; i++)
+            {
+                ValueType sum = M[i * rs + k * cs];
+
+                for (int j = kb; j < k; j++)
+                    sum -= M[i * rs + j * cs] * M[k * rs + j * cs];
+
+                M[i * rs + k * cs] = sum / diagonal;
+            }
+        }
+
+        // A22 <- A22 - L21 * L21^T (lower triangle only)
+        for (int jb = kb_end; jb < n; jb += NB)
+        {
+            const int jb_end = std::min(jb + NB, n);
+
+            for (int ib = jb; ib < n; ib += NB)
+            {
+                const int ib_end = std::min(ib + NB, n);
+
+                for (int j = jb; j < jb_end; j++)
+                    for (int i = std::max(ib, j); i < ib_end; i++)
+                    {
+                        ValueType sum = 0;
+
+                        for (int k = kb; k < kb_end; k++)
+                            sum += M[i * rs + k * cs] * M[j * rs + k * cs];
+
+                        M[i * rs + j * cs] -= sum;
+                    }
+            }
+        }
+    }
+
+    return 0;
+}
+
+// Solve L * L^T x = b given the factor computed by cholesky_factor
+template <typename ValueType, typename MemorySpace, typename Orientation>
+int cholesky_solve(const cusp::array2d<ValueType,MemorySpace,Orientation>& A,
+                   const cusp::array1d<ValueType,MemorySpace>& b,
+                         cusp::array1d<ValueType,MemorySpace>& x)
+{
+    const int n = A.num_rows;
+
+    for (int k = 0; k < n; k++)
+        x[k] = b[k];
+
+    // Solve L y = b
+    for (int k = 0; k < n; k++)
+    {
+        for (int i = 0; i < k; i++)
+            x[k] -= A(k,i) * x[i];
+
+        if (A(k,k) == 0)
+            return -1;
+
+        x[k] /= A(k,k);
+    }
+
+    // Solve L^T x = y
+    for (int k = n - 1; k >= 0; k--)
+    {
+        for (int i = k + 1; i < n; i++)
+            x[k] -= A(i,k) * x[i];
+
+        x[k] /= A(k,k);
+    }
+
+    return 0;
+}
+
+
 template <typename ValueType, typename MemorySpace>
 class lu_solver : public cusp::linear_operator<ValueType,MemorySpace>
 {
@@ -146,6 +337,97 @@ class lu_solver : public cusp::linear_operator<ValueType,MemorySpace>
     }
 };
 
+// Direct solver for symmetric positive definite matrices, e.g. the
+// coarse level of an AMG hierarchy built from an SPD operator.  The
+// Cholesky factorization requires half the work and storage traffic of
+// lu_solver and no pivoting.
+template <typename ValueType, typename MemorySpace>
+class cholesky_solver : public cusp::linear_operator<ValueType,MemorySpace>
+{
+    cusp::array2d<ValueType,cusp::host_memory> L;
+
+    public:
+    cholesky_solver()
+        : linear_operator<ValueType,MemorySpace>()
+    { }
+
+    template <typename MatrixType>
+    cholesky_solver(const MatrixType& A) 
+        : linear_operator<ValueType,MemorySpace>(A.num_rows, A.num_cols, A.num_entries)
+    {
+        CUSP_PROFILE_SCOPED();
+
+        // TODO assert A is square
+        L = A;
+
+        if (cholesky_factor(L) != 0)
+            throw cusp::invalid_input_exception("matrix is not symmetric positive definite");
+    }
+
+    // TODO handle host and device
+    template <typename VectorType1, typename VectorType2>
+    void operator()(const VectorType1& x, VectorType2& y) const
+    {
+        CUSP_PROFILE_SCOPED();
+
+        cholesky_solve(L, x, y);
+    }
+};
+
+// Coarse solver which applies the explicit inverse of A with a dense
+// matrix-vector product.  The inverse is computed on the host from the LU
+// factorization and stored in MemorySpace, so for device memory the solve
+// does not transfer any data between the host and the device.
+template <typename ValueType, typename MemorySpace>
+class dense_inverse_solver : public cusp::linear_operator<ValueType,MemorySpace>
+{
+    public:
+    cusp::array2d<ValueType,MemorySpace,cusp::column_major> inverse;
+
+    dense_inverse_solver()
+        : linear_operator<ValueType,MemorySpace>()
+    { }
+
+    template <typename MatrixType>
+    dense_inverse_solver(const MatrixType& A)
+        : linear_operator<ValueType,MemorySpace>(A.num_rows, A.num_cols, A.num_rows * A.num_cols)
+    {
+        CUSP_PROFILE_SCOPED();
+
+        // TODO assert A is square
+        const int n = A.num_rows;
+
+        cusp::array2d<ValueType,cusp::host_memory> lu(A);
+        cusp::array1d<int,cusp::host_memory>       pivot(n);
+        lu_factor(lu, pivot);
+
+        // solve for the columns of the inverse
+        cusp::array2d<ValueType,cusp::host_memory,cusp::column_major> temp(n, n);
+        cusp::array1d<ValueType,cusp::host_memory> e(n, ValueType(0));
+        cusp::array1d<ValueType,cusp::host_memory> column(n);
+
+        for (int j = 0; j < n; j++)
+        {
+            e[j] = ValueType(1);
+            lu_solve(lu, pivot, e, column);
+            e[j] = ValueType(0);
+
+            for (int i = 0; i < n; i++)
+                temp(i,j) = column[i];
+        }
+
+        inverse = temp;
+    }
+
+    template <typename VectorType1, typename VectorType2>
+    void operator()(const VectorType1& x, VectorType2& y) const
+    {
+        CUSP_PROFILE_SCOPED();
+
+        cusp::multiply(inverse, x, y);
+    }
+};
+
 } // end namespace detail
 } // end namespace cusp
 
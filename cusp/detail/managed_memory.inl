@@ -0,0 +1,178 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include <cusp/format.h>
+
+#include <thrust/memory.h>
+
+namespace cusp
+{
+namespace detail
+{
+
+struct managed_prefetch_array
+{
+    bool to_host;
+
+    managed_prefetch_array(bool to_host) : to_host(to_host) {}
+
+    template <typename Array>
+    void operator()(const Array& a) const
+    {
+#if defined(CUSP_USE_MANAGED_MEMORY)
+        cusp::detail::device::managed_prefetch(thrust::raw_pointer_cast(a.data()),
+                                               a.size() * sizeof(typename Array::value_type), to_host);
+#endif
+    }
+};
+
+struct managed_advise_array
+{
+    bool read_mostly;
+
+    managed_advise_array(bool read_mostly) : read_mostly(read_mostly) {}
+
+    template <typename Array>
+    void operator()(const Array& a) const
+    {
+#if defined(CUSP_USE_MANAGED_MEMORY)
+        cusp::detail::device::managed_advise_read_mostly(thrust::raw_pointer_cast(a.data()),
+                                                         a.size() * sizeof(typename Array::value_type), read_mostly);
+#endif
+    }
+};
+
+// apply op to each array holding the storage of A
+template <typename Matrix, typename Operation, typename Format>
+void for_each_format_array(const Matrix&, const Operation&, Format) {}
+
+template <typename Array, typename Operation>
+void for_each_format_array(const Array& a, const Operation& op, cusp::array1d_format)
+{
+    op(a);
+}
+
+template <typename Matrix, typename Operation>
+void for_each_format_array(const Matrix& A, const Operation& op, cusp::array2d_format)
+{
+    op(A.values);
+}
+
+template <typename Matrix, typename Operation>
+void for_each_format_array(const Matrix& A, const Operation& op, cusp::coo_format)
+{
+    op(A.row_indices);
+    op(A.column_indices);
+    op(A.values);
+}
+
+template <typename Matrix, typename Operation>
+void for_each_format_array(const Matrix& A, const Operation& op, cusp::csr_format)
+{
+    op(A.row_offsets);
+    op(A.column_indices);
+    op(A.values);
+}
+
+template <typename Matrix, typename Operation>
+void for_each_format_array(const Matrix& A, const Operation& op, cusp::dia_format)
+{
+    op(A.diagonal_offsets);
+    op(A.values.values);
+}
+
+template <typename Matrix, typename Operation>
+void for_each_format_array(const Matrix& A, const Operation& op, cusp::ell_format)
+{
+    op(A.column_indices.values);
+    op(A.values.values);
+}
+
+template <typename Matrix, typename Operation>
+void for_each_format_array(const Matrix& A, const Operation& op, cusp::hyb_format)
+{
+    for_each_format_array(A.ell, op, cusp::ell_format());
+    for_each_format_array(A.coo, op, cusp::coo_format());
+}
+
+template <typename Matrix, typename Operation>
+void for_each_format_array(const Matrix& A, const Operation& op, cusp::sell_format)
+{
+    op(A.slice_offsets);
+    op(A.row_permutation);
+    op(A.column_indices);
+    op(A.values);
+}
+
+template <typename Matrix, typename Operation>
+void for_each_format_array(const Matrix& A, const Operation& op, cusp::bsr_format)
+{
+    op(A.row_offsets);
+    op(A.column_indices);
+    op(A.values);
+}
+
+template <typename Matrix, typename Operation>
+void for_each_format_array(const Matrix& A, const Operation& op, cusp::csr16_format)
+{
+    op(A.row_offsets);
+    op(A.column_offsets);
+    op(A.values);
+}
+
+// only containers in managed_memory own managed storage
+template <typename Matrix, typename Operation, typename MemorySpace>
+void for_each_managed_array(const Matrix&, const Operation&, MemorySpace) {}
+
+template <typename Matrix, typename Operation>
+void for_each_managed_array(const Matrix& A, const Operation& op, cusp::managed_memory)
+{
+    for_each_format_array(A, op, typename Matrix::format());
+}
+
+// migrate the operands of a device routine ahead of its kernels
+template <typename Matrix, typename Vector1, typename Vector2>
+void prefetch_operands(const Matrix& A, const Vector1& x, const Vector2& y)
+{
+    cusp::prefetch(A);
+    cusp::prefetch(x);
+    cusp::prefetch(y);
+}
+
+} // end namespace detail
+
+template <typename ArrayOrMatrix>
+void prefetch(const ArrayOrMatrix& A)
+{
+    cusp::detail::for_each_managed_array(A, cusp::detail::managed_prefetch_array(false),
+                                         typename ArrayOrMatrix::memory_space());
+}
+
+template <typename ArrayOrMatrix>
+void prefetch_to_host(const ArrayOrMatrix& A)
+{
+    cusp::detail::for_each_managed_array(A, cusp::detail::managed_prefetch_array(true),
+                                         typename ArrayOrMatrix::memory_space());
+}
+
+template <typename ArrayOrMatrix>
+void advise_read_mostly(const ArrayOrMatrix& A, bool read_mostly)
+{
+    cusp::detail::for_each_managed_array(A, cusp::detail::managed_advise_array(read_mostly),
+                                         typename ArrayOrMatrix::memory_space());
+}
+
+} // end namespace cusp
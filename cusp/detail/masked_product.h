@@ -0,0 +1,116 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+#pragma once
+
+#include <cusp/detail/config.h>
+
+namespace cusp
+{
+namespace detail
+{
+
+// C(i,:) = (A * B)(i,:) at the positions of M(i,:), whose columns, like
+// those of B, are sorted within each row.  Every row of B selected by
+// A(i,:) is intersected with M(i,:) by a merge, or by binary searches in
+// M(i,:) when the row of B is much shorter, so no entry outside of the
+// mask is ever formed.  Cx holds the values of C in the positions of M.
+template <typename IndexType1, typename ValueType1,
+          typename IndexType2, typename ValueType2,
+          typename IndexType3, typename ValueType3>
+__host__ __device__
+void masked_row_product(const IndexType3 i,
+                        const IndexType1 * Ap, const IndexType1 * Aj, const ValueType1 * Ax,
+                        const IndexType2 * Bp, const IndexType2 * Bj, const ValueType2 * Bx,
+                        const IndexType3 * Mp, const IndexType3 * Mj,
+                              ValueType3 * Cx)
+{
+    const IndexType3 m_begin = Mp[i];
+    const IndexType3 m_end   = Mp[i + 1];
+
+    for (IndexType3 m = m_begin; m < m_end; m++)
+        Cx[m] = ValueType3(0);
+
+    if (m_begin == m_end)
+        return;
+
+    for (IndexType1 jj = Ap[i]; jj < Ap[i + 1]; jj++)
+    {
+        const IndexType1 k = Aj[jj];
+        const ValueType3 a = ValueType3(Ax[jj]);
+
+        const IndexType2 b_begin = Bp[k];
+        const IndexType2 b_end   = Bp[k + 1];
+
+        if (IndexType3(8 * (b_end - b_begin)) < m_end - m_begin)
+        {
+            IndexType3 first = m_begin;
+
+            for (IndexType2 b = b_begin; b < b_end; b++)
+            {
+                const IndexType3 j = IndexType3(Bj[b]);
+
+                // lower bound of j in the rest of M(i,:)
+                IndexType3 last = m_end;
+
+                while (first < last)
+                {
+                    const IndexType3 middle = first + (last - first) / 2;
+
+                    if (Mj[middle] < j)
+                        first = middle + 1;
+                    else
+                        last = middle;
+                }
+
+                if (first == m_end)
+                    break;
+
+                if (Mj[first] == j)
+                    Cx[first] += a * ValueType3(Bx[b]);
+            }
+        }
+        else
+        {
+            IndexType2 b = b_begin;
+            IndexType3 m = m_begin;
+
+            while (b < b_end && m < m_end)
+            {
+                const IndexType3 jb = IndexType3(Bj[b]);
+                const IndexType3 jm = Mj[m];
+
+                if (jb < jm)
+                {
+                    b++;
+                }
+                else if (jm < jb)
+                {
+                    m++;
+                }
+                else
+                {
+                    Cx[m] += a * ValueType3(Bx[b]);
+                    b++;
+                }
+            }
+        }
+    }
+}
+
+} // end namespace detail
+} // end namespace cusp
@@ -17,12 +17,26 @@
 #include <memory>
 
 #include <thrust/device_allocator.h>
+#include <thrust/detail/type_traits.h>
 #include <thrust/iterator/iterator_traits.h>
 
 #if THRUST_VERSION >= 100600
 #include <thrust/device_malloc_allocator.h>
 #endif
 
+// device containers allocate through the caching allocator unless
+// CUSP_NO_DEVICE_CACHE is defined, see cusp/device_cache.h
+#if !defined(CUSP_NO_DEVICE_CACHE) && \
+    ((defined THRUST_DEVICE_BACKEND && THRUST_DEVICE_BACKEND == THRUST_DEVICE_BACKEND_CUDA) || (defined THRUST_DEVICE_SYSTEM && THRUST_DEVICE_SYSTEM == THRUST_DEVICE_SYSTEM_CUDA))
+#define CUSP_USE_DEVICE_CACHE
+#include <cusp/detail/device/caching_allocator.h>
+#endif
+
+#if (defined THRUST_DEVICE_BACKEND && THRUST_DEVICE_BACKEND == THRUST_DEVICE_BACKEND_CUDA) || (defined THRUST_DEVICE_SYSTEM && THRUST_DEVICE_SYSTEM == THRUST_DEVICE_SYSTEM_CUDA)
+#define CUSP_USE_MANAGED_MEMORY
+#include <cusp/detail/device/managed_allocator.h>
+#endif
+
 namespace cusp
 {
 namespace detail
@@ -38,6 +52,50 @@ namespace detail
   struct minimum_space_impl<MemorySpace,any_memory>  { typedef MemorySpace type; };
   template <>
   struct minimum_space_impl<any_memory,any_memory>   { typedef any_memory  type; };
+  // managed arrays are device arrays to the algorithms
+  template <>
+  struct minimum_space_impl<managed_memory,device_memory> { typedef device_memory type; };
+  template <>
+  struct minimum_space_impl<device_memory,managed_memory> { typedef device_memory type; };
+
+  // spaces whose containers the device kernels may access directly
+  template <typename MemorySpace>
+  struct is_device_space
+    : public thrust::detail::integral_constant<bool,
+               thrust::detail::is_same<MemorySpace, device_memory>::value ||
+               thrust::detail::is_same<MemorySpace, managed_memory>::value> {};
+
+  template <typename T>
+  struct device_memory_allocator
+  {
+#if defined(CUSP_USE_DEVICE_CACHE)
+    typedef cusp::detail::device::caching_allocator<T> base;
+#else
+    typedef thrust::device_malloc_allocator<T> base;
+#endif
+
+#if defined(CUSP_TRACK_MEMORY)
+    typedef cusp::detail::memory_tracker::tracking_allocator<T,base> type;
+#else
+    typedef base type;
+#endif
+  };
+
+  template <typename T>
+  struct managed_memory_allocator
+  {
+#if defined(CUSP_USE_MANAGED_MEMORY)
+    typedef cusp::detail::device::managed_allocator<T> base;
+#else
+    typedef typename device_memory_allocator<T>::base base;
+#endif
+
+#if defined(CUSP_TRACK_MEMORY)
+    typedef cusp::detail::memory_tracker::tracking_allocator<T,base> type;
+#else
+    typedef base type;
+#endif
+  };
   
 } // end namespace detail
    
@@ -51,11 +109,17 @@ namespace detail
           // XXX add backend-specific allocators here?
   
           thrust::detail::eval_if<
-            thrust::detail::is_convertible<MemorySpace, device_memory>::value,
+            thrust::detail::is_same<MemorySpace, managed_memory>::value,
+  
+            cusp::detail::managed_memory_allocator<T>,
+  
+            thrust::detail::eval_if<
+              thrust::detail::is_convertible<MemorySpace, device_memory>::value,
   
-            thrust::detail::identity_< thrust::device_malloc_allocator<T> >,
+              cusp::detail::device_memory_allocator<T>,
   
-            thrust::detail::identity_< MemorySpace >
+              thrust::detail::identity_< MemorySpace >
+            >
           >
         >
   {};
@@ -0,0 +1,423 @@
+/*
+ *  Copyright 2008-2010 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+// Device memory tracking, selected by defining CUSP_TRACK_MEMORY.
+//
+// The device containers (array1d and the matrices built on it) then
+// allocate through tracking_allocator, which counts the bytes currently
+// allocated and their high-water mark.  Every CUSP_PROFILE_SCOPED scope
+// also opens a region of the tracker, so the high-water marks are kept per
+// call path, the same paths as the profiler reports.  For each path the
+// tracker records the highest usage reached while it was active (children
+// included), the largest growth above the usage at its entry, and the
+// bytes it allocated itself.  Applications open their own regions with
+// cusp::detail::memory_tracker::scoped, e.g. around a time step.
+//
+// A failed allocation is recorded with its size and call path before the
+// exception propagates, so that an out of memory error during, say, the
+// setup of smoothed_aggregation names the stage and the usage at the time.
+//
+// Only the allocations of the device containers are counted; temporary
+// storage which Thrust allocates inside its algorithms is not.  Like the
+// device profiler, the tracker state is shared by all host threads and is
+// not synchronized.
+
+#pragma once
+
+#include <thrust/device_malloc_allocator.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+#if defined(_MSC_VER)
+#define CUSP_MEMORY_TRACKER_FUNCTION() __FUNCSIG__
+#else
+#define CUSP_MEMORY_TRACKER_FUNCTION() __PRETTY_FUNCTION__
+#endif
+
+namespace cusp
+{
+namespace detail
+{
+namespace memory_tracker
+{
+
+struct call_path
+{
+    const char * name;
+    call_path * parent;
+    std::vector<call_path *> children;
+    size_t calls;
+    size_t allocations;         // allocations made by the path itself
+    size_t allocated_bytes;     // bytes allocated by the path itself
+    size_t peak_bytes;          // highest usage while the path was active
+    size_t peak_growth;         // largest peak above the usage at entry
+
+    // state of the active call
+    size_t entry_bytes;
+    size_t active_peak;
+
+    call_path(const char * name, call_path * parent)
+        : name(name), parent(parent), calls(0), allocations(0), allocated_bytes(0),
+          peak_bytes(0), peak_growth(0), entry_bytes(0), active_peak(0) {}
+
+    ~call_path(void)
+    {
+        for (size_t i = 0; i < children.size(); i++)
+            delete children[i];
+    }
+
+    call_path * child(const char * child_name)
+    {
+        for (size_t i = 0; i < children.size(); i++)
+            if (children[i]->name == child_name || strcmp(children[i]->name, child_name) == 0)
+                return children[i];
+
+        children.push_back(new call_path(child_name, this));
+        return children.back();
+    }
+
+    private:
+    // not copyable
+    call_path(const call_path&);
+    call_path& operator=(const call_path&);
+};
+
+// the allocation which failed last
+struct failure
+{
+    const call_path * path;
+    size_t requested_bytes;
+    size_t current_bytes;
+
+    failure(void) : path(NULL), requested_bytes(0), current_bytes(0) {}
+};
+
+struct tracker_state
+{
+    call_path root;
+    call_path * active;
+    size_t current_bytes;
+    size_t peak_bytes;
+    size_t live_allocations;
+    cusp::detail::memory_tracker::failure last_failure;
+
+    tracker_state(void)
+        : root("/Main", NULL), active(&root), current_bytes(0), peak_bytes(0), live_allocations(0) {}
+};
+
+inline tracker_state& state(void)
+{
+    static tracker_state s;
+    return s;
+}
+
+inline void enter(const char * name)
+{
+    tracker_state& s = state();
+
+    s.active = s.active->child(name);
+    s.active->calls++;
+    s.active->entry_bytes = s.current_bytes;
+    s.active->active_peak = s.current_bytes;
+}
+
+inline void exit(void)
+{
+    tracker_state& s = state();
+
+    if (s.active == &s.root)
+        return;
+
+    call_path * path = s.active;
+
+    if (path->active_peak > path->peak_bytes)
+        path->peak_bytes = path->active_peak;
+
+    if (path->active_peak - path->entry_bytes > path->peak_growth)
+        path->peak_growth = path->active_peak - path->entry_bytes;
+
+    // the peak of a child is reached while its parent is active
+    if (path->active_peak > path->parent->active_peak)
+        path->parent->active_peak = path->active_peak;
+
+    s.active = path->parent;
+}
+
+inline void allocated(size_t bytes)
+{
+    tracker_state& s = state();
+
+    s.current_bytes += bytes;
+    s.live_allocations++;
+
+    if (s.current_bytes > s.peak_bytes)
+        s.peak_bytes = s.current_bytes;
+
+    if (s.current_bytes > s.active->active_peak)
+        s.active->active_peak = s.current_bytes;
+
+    s.active->allocations++;
+    s.active->allocated_bytes += bytes;
+}
+
+inline void deallocated(size_t bytes)
+{
+    tracker_state& s = state();
+
+    s.current_bytes -= bytes < s.current_bytes ? bytes : s.current_bytes;
+
+    if (s.live_allocations > 0)
+        s.live_allocations--;
+}
+
+inline void failed(size_t bytes)
+{
+    tracker_state& s = state();
+
+    s.last_failure.path            = s.active;
+    s.last_failure.requested_bytes = bytes;
+    s.last_failure.current_bytes   = s.current_bytes;
+}
+
+struct scoped
+{
+    scoped(const char * name)
+    {
+        enter(name);
+    }
+
+    ~scoped(void)
+    {
+        exit();
+    }
+};
+
+// bytes currently allocated by the device containers
+inline size_t current_bytes(void)
+{
+    return state().current_bytes;
+}
+
+// highest value of current_bytes() since the start or the last reset()
+inline size_t peak_bytes(void)
+{
+    return state().peak_bytes;
+}
+
+inline void clear(call_path * path)
+{
+    for (size_t i = 0; i < path->children.size(); i++)
+        clear(path->children[i]);
+
+    path->calls           = 0;
+    path->allocations     = 0;
+    path->allocated_bytes = 0;
+    path->peak_bytes      = 0;
+    path->peak_growth     = 0;
+    path->entry_bytes     = state().current_bytes;
+    path->active_peak     = state().current_bytes;
+}
+
+// clear the statistics, the bytes currently allocated stay counted
+inline void reset(void)
+{
+    tracker_state& s = state();
+
+    clear(&s.root);
+
+    s.peak_bytes   = s.current_bytes;
+    s.last_failure = failure();
+}
+
+// length of the function name without its argument list
+inline int short_name_length(const char * name)
+{
+    const char * paren = strchr(name, '(');
+    return paren ? int(paren - name) : int(strlen(name));
+}
+
+inline double megabytes(size_t bytes)
+{
+    return bytes / (1024.0 * 1024.0);
+}
+
+inline void print(const call_path * path, size_t depth)
+{
+    printf("%10.2f MB peak %+10.2f MB growth %8lu allocs %10.2f MB %6lu calls ",
+           megabytes(path->peak_bytes), megabytes(path->peak_growth),
+           (unsigned long) path->allocations, megabytes(path->allocated_bytes), (unsigned long) path->calls);
+
+    for (size_t i = 0; i < depth; i++)
+        printf("  ");
+
+    printf(": %.*s\n", short_name_length(path->name), path->name);
+
+    for (size_t i = 0; i < path->children.size(); i++)
+        print(path->children[i], depth + 1);
+}
+
+// the usage of the root covers everything since the start or reset()
+inline tracker_state& finished_state(void)
+{
+    tracker_state& s = state();
+
+    s.root.calls       = 1;
+    s.root.peak_bytes  = s.peak_bytes;
+    s.root.peak_growth = s.peak_bytes - (s.root.entry_bytes < s.peak_bytes ? s.root.entry_bytes : s.peak_bytes);
+
+    return s;
+}
+
+inline void dump(void)
+{
+    tracker_state& s = finished_state();
+
+    printf("> Device memory per call path (current %.2f MB in %lu allocations, peak %.2f MB)\n",
+           megabytes(s.current_bytes), (unsigned long) s.live_allocations, megabytes(s.peak_bytes));
+    print(&s.root, 0);
+
+    if (s.last_failure.path != NULL)
+        printf("> Failed to allocate %.2f MB with %.2f MB in use in %.*s\n",
+               megabytes(s.last_failure.requested_bytes), megabytes(s.last_failure.current_bytes),
+               short_name_length(s.last_failure.path->name), s.last_failure.path->name);
+
+    printf("\n");
+}
+
+inline void write_json_name(std::ostream& os, const char * text)
+{
+    const int length = short_name_length(text);
+
+    os << '"';
+    for (int i = 0; i < length && text[i]; i++)
+    {
+        if (text[i] == '"' || text[i] == '\\')
+            os << '\\';
+        os << text[i];
+    }
+    os << '"';
+}
+
+inline void write_json(std::ostream& os, const call_path * path)
+{
+    os << "{\"name\": ";
+    write_json_name(os, path->name);
+    os << ", \"calls\": " << path->calls
+       << ", \"allocations\": " << path->allocations
+       << ", \"allocated_bytes\": " << path->allocated_bytes
+       << ", \"peak_bytes\": " << path->peak_bytes
+       << ", \"peak_growth_bytes\": " << path->peak_growth
+       << ", \"children\": [";
+
+    for (size_t i = 0; i < path->children.size(); i++)
+    {
+        if (i > 0)
+            os << ", ";
+        write_json(os, path->children[i]);
+    }
+
+    os << "]}";
+}
+
+// the call path tree as a JSON object
+inline void write_json(std::ostream& os)
+{
+    tracker_state& s = finished_state();
+
+    os << "{\"current_bytes\": " << s.current_bytes
+       << ", \"peak_bytes\": " << s.peak_bytes
+       << ", \"live_allocations\": " << s.live_allocations;
+
+    if (s.last_failure.path != NULL)
+    {
+        os << ", \"failure\": {\"path\": ";
+        write_json_name(os, s.last_failure.path->name);
+        os << ", \"requested_bytes\": " << s.last_failure.requested_bytes
+           << ", \"current_bytes\": " << s.last_failure.current_bytes << "}";
+    }
+
+    os << ", \"paths\": ";
+    write_json(os, &s.root);
+    os << "}\n";
+}
+
+// device allocator of the containers when CUSP_TRACK_MEMORY is defined,
+// counts the requests and forwards them to Allocator
+template <typename T, typename Allocator = thrust::device_malloc_allocator<T> >
+class tracking_allocator : public Allocator
+{
+    typedef Allocator Parent;
+
+    public:
+    typedef typename Parent::pointer   pointer;
+    typedef typename Parent::size_type size_type;
+
+    template <typename U>
+    struct rebind { typedef tracking_allocator<U, typename Allocator::template rebind<U>::other> other; };
+
+    tracking_allocator(void) {}
+
+    tracking_allocator(const tracking_allocator&) {}
+
+    template <typename U, typename Allocator2>
+    tracking_allocator(const tracking_allocator<U, Allocator2>&) {}
+
+    pointer allocate(size_type n)
+    {
+        pointer p;
+
+        try
+        {
+            p = Parent::allocate(n);
+        }
+        catch (...)
+        {
+            failed(n * sizeof(T));
+            throw;
+        }
+
+        allocated(n * sizeof(T));
+
+        return p;
+    }
+
+    void deallocate(pointer p, size_type n)
+    {
+        Parent::deallocate(p, n);
+        deallocated(n * sizeof(T));
+    }
+};
+
+template <typename T1, typename A1, typename T2, typename A2>
+bool operator==(const tracking_allocator<T1,A1>&, const tracking_allocator<T2,A2>&)
+{
+    return true;
+}
+
+template <typename T1, typename A1, typename T2, typename A2>
+bool operator!=(const tracking_allocator<T1,A1>&, const tracking_allocator<T2,A2>&)
+{
+    return false;
+}
+
+} // end namespace memory_tracker
+} // end namespace detail
+} // end namespace cusp
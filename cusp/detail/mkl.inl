@@ -0,0 +1,98 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+#include <cusp/copy.h>
+#include <cusp/exception.h>
+
+#include <thrust/fill.h>
+
+namespace cusp
+{
+namespace detail
+{
+
+template <typename ValueType, typename VectorType1, typename VectorType2>
+void apply_mkl_spmv(const sparse_matrix_t A, const VectorType1& x, VectorType2& y, thrust::detail::true_type)
+{
+  cusp::detail::host::mkl::check(cusp::detail::host::mkl::mv(A, cusp::detail::host::mkl::value_pointer(x),
+                                                                 cusp::detail::host::mkl::value_pointer(y)),
+                                 "mkl_sparse_mv");
+}
+
+// other vectors are staged through contiguous host arrays
+template <typename ValueType, typename VectorType1, typename VectorType2>
+void apply_mkl_spmv(const sparse_matrix_t A, const VectorType1& x, VectorType2& y, thrust::detail::false_type)
+{
+  cusp::array1d<ValueType,cusp::host_memory> x_(x);
+  cusp::array1d<ValueType,cusp::host_memory> y_(y.size());
+
+  apply_mkl_spmv<ValueType>(A, x_, y_, thrust::detail::true_type());
+
+  cusp::copy(y_, y);
+}
+
+} // end namespace detail
+
+template <typename IndexType, typename ValueType>
+template <typename MatrixType>
+mkl_spmv<IndexType,ValueType>
+::mkl_spmv(const MatrixType& matrix, size_t expected_calls)
+  : Parent(matrix.num_rows, matrix.num_cols, matrix.num_entries), A(matrix)
+{
+  if (!cusp::detail::host::mkl::fits(A.num_rows) ||
+      !cusp::detail::host::mkl::fits(A.num_cols) ||
+      !cusp::detail::host::mkl::fits(A.num_entries))
+    throw cusp::invalid_input_exception("matrix is too large for MKL_INT indices");
+
+  // MKL rejects empty arrays, so empty matrices multiply without a handle
+  if (A.num_rows == 0 || A.num_cols == 0 || A.num_entries == 0)
+    return;
+
+  MKL_INT * P = cusp::detail::host::simd::host_pointer(A.row_offsets);
+
+  cusp::detail::host::mkl::check(cusp::detail::host::mkl::create_csr(&handle.get(),
+                                                                     MKL_INT(A.num_rows), MKL_INT(A.num_cols),
+                                                                     P, P + 1,
+                                                                     cusp::detail::host::simd::host_pointer(A.column_indices),
+                                                                     cusp::detail::host::simd::host_pointer(A.values)),
+                                 "mkl_sparse_create_csr");
+
+  handle.optimize(expected_calls);
+}
+
+template <typename IndexType, typename ValueType>
+template <typename VectorType1, typename VectorType2>
+void mkl_spmv<IndexType,ValueType>
+::operator()(const VectorType1& x, VectorType2& y) const
+{
+  if (x.size() != A.num_cols || y.size() != A.num_rows)
+    throw cusp::invalid_input_exception("array dimensions do not match the operator");
+
+  if (handle.get() == 0)
+  {
+    thrust::fill(y.begin(), y.end(), ValueType(0));
+    return;
+  }
+
+  typedef cusp::detail::host::mkl::is_mkl_array<VectorType1, ValueType> is_mkl_x;
+  typedef cusp::detail::host::mkl::is_mkl_array<VectorType2, ValueType> is_mkl_y;
+
+  cusp::detail::apply_mkl_spmv<ValueType>(handle.get(), x, y,
+                                          thrust::detail::integral_constant<bool, is_mkl_x::value && is_mkl_y::value>());
+}
+
+} // end namespace cusp
@@ -0,0 +1,161 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#ifndef __CUSP_USE_MPI__
+#error "the MPI containers require MPI (compile with __CUSP_USE_MPI__)"
+#endif
+
+#include <cusp/complex.h>
+#include <cusp/exception.h>
+
+#include <mpi.h>
+
+#if defined(OPEN_MPI) && OPEN_MPI
+#include <mpi-ext.h>
+#endif
+
+#include <string>
+#include <vector>
+
+// Helpers of the containers distributed over MPI processes (see
+// cusp/mpi_array1d.h).  Every call is checked and failures are reported
+// as cusp::runtime_exception, so the communicators must not abort on
+// errors for the exception to be seen (MPI_ERRORS_RETURN).
+
+namespace cusp
+{
+namespace detail
+{
+
+template <typename T> struct mpi_datatype;
+
+template <> struct mpi_datatype<int>                  { static MPI_Datatype type(void) { return MPI_INT; } };
+template <> struct mpi_datatype<unsigned int>         { static MPI_Datatype type(void) { return MPI_UNSIGNED; } };
+template <> struct mpi_datatype<long>                 { static MPI_Datatype type(void) { return MPI_LONG; } };
+template <> struct mpi_datatype<unsigned long>        { static MPI_Datatype type(void) { return MPI_UNSIGNED_LONG; } };
+template <> struct mpi_datatype<long long>            { static MPI_Datatype type(void) { return MPI_LONG_LONG; } };
+template <> struct mpi_datatype<unsigned long long>   { static MPI_Datatype type(void) { return MPI_UNSIGNED_LONG_LONG; } };
+template <> struct mpi_datatype<float>                { static MPI_Datatype type(void) { return MPI_FLOAT; } };
+template <> struct mpi_datatype<double>               { static MPI_Datatype type(void) { return MPI_DOUBLE; } };
+template <> struct mpi_datatype< cusp::complex<float> >  { static MPI_Datatype type(void) { return MPI_C_FLOAT_COMPLEX; } };
+template <> struct mpi_datatype< cusp::complex<double> > { static MPI_Datatype type(void) { return MPI_C_DOUBLE_COMPLEX; } };
+
+inline void mpi_check(int status, const char * call)
+{
+    if (status != MPI_SUCCESS)
+    {
+        char message[MPI_MAX_ERROR_STRING];
+        int length = 0;
+
+        if (MPI_Error_string(status, message, &length) != MPI_SUCCESS)
+            length = 0;
+
+        throw cusp::runtime_exception(std::string(call) + " failed: " + std::string(message, length));
+    }
+}
+
+// whether the MPI library accepts device pointers, which then move
+// between the devices of different nodes without staging on the host
+inline bool mpi_cuda_aware(void)
+{
+#if defined(__CUSP_MPI_CUDA_AWARE__)
+    return true;
+#elif defined(MPIX_CUDA_AWARE_SUPPORT) && MPIX_CUDA_AWARE_SUPPORT
+    return MPIX_Query_cuda_support() == 1;
+#else
+    return false;
+#endif
+}
+
+inline int mpi_rank(MPI_Comm comm)
+{
+    int rank = 0;
+    mpi_check(MPI_Comm_rank(comm, &rank), "MPI_Comm_rank");
+    return rank;
+}
+
+inline int mpi_size(MPI_Comm comm)
+{
+    int size = 0;
+    mpi_check(MPI_Comm_size(comm, &size), "MPI_Comm_size");
+    return size;
+}
+
+// sum of value over the processes of comm
+template <typename ValueType>
+ValueType mpi_sum(const ValueType& value, MPI_Comm comm)
+{
+    ValueType result(value);
+    mpi_check(MPI_Allreduce(MPI_IN_PLACE, &result, 1, mpi_datatype<ValueType>::type(), MPI_SUM, comm), "MPI_Allreduce");
+    return result;
+}
+
+template <typename ValueType>
+ValueType mpi_max(const ValueType& value, MPI_Comm comm)
+{
+    ValueType result(value);
+    mpi_check(MPI_Allreduce(MPI_IN_PLACE, &result, 1, mpi_datatype<ValueType>::type(), MPI_MAX, comm), "MPI_Allreduce");
+    return result;
+}
+
+// Sums of Size values over the processes of comm, started by begin() and
+// completed by end(), so that the reduction proceeds while the caller
+// issues other work (e.g. the products of pipelined CG).
+template <typename ValueType, size_t Size>
+class mpi_nonblocking_sum
+{
+    public:
+    mpi_nonblocking_sum(MPI_Comm comm)
+        : comm(comm), request(MPI_REQUEST_NULL) {}
+
+    ~mpi_nonblocking_sum(void)
+    {
+        // a reduction abandoned by an exception must still complete
+        if (request != MPI_REQUEST_NULL)
+            MPI_Wait(&request, MPI_STATUS_IGNORE);
+    }
+
+    void begin(const ValueType * local)
+    {
+        for (size_t i = 0; i < Size; i++)
+            values[i] = local[i];
+
+        mpi_check(MPI_Iallreduce(MPI_IN_PLACE, values, int(Size), mpi_datatype<ValueType>::type(), MPI_SUM, comm, &request),
+                  "MPI_Iallreduce");
+    }
+
+    void end(ValueType * global)
+    {
+        mpi_check(MPI_Wait(&request, MPI_STATUS_IGNORE), "MPI_Wait");
+
+        for (size_t i = 0; i < Size; i++)
+            global[i] = values[i];
+    }
+
+    private:
+    MPI_Comm comm;
+    MPI_Request request;
+    ValueType values[Size];
+
+    // not copyable
+    mpi_nonblocking_sum(const mpi_nonblocking_sum&);
+    mpi_nonblocking_sum& operator=(const mpi_nonblocking_sum&);
+};
+
+} // end namespace detail
+} // end namespace cusp
@@ -0,0 +1,145 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include <cusp/exception.h>
+
+#include <thrust/copy.h>
+#include <thrust/fill.h>
+
+#include <algorithm>
+
+namespace cusp
+{
+
+////////////////
+// mpi_layout //
+////////////////
+inline mpi_layout
+::mpi_layout(MPI_Comm comm, size_t num_local_rows)
+  : comm(comm), rank(cusp::detail::mpi_rank(comm))
+{
+    const int num_ranks = cusp::detail::mpi_size(comm);
+
+    unsigned long long n = num_local_rows;
+    std::vector<unsigned long long> sizes(num_ranks);
+
+    cusp::detail::mpi_check(MPI_Allgather(&n, 1, MPI_UNSIGNED_LONG_LONG, &sizes[0], 1, MPI_UNSIGNED_LONG_LONG, comm),
+                            "MPI_Allgather");
+
+    offsets.resize(num_ranks + 1);
+    offsets[0] = 0;
+
+    for (int r = 0; r < num_ranks; r++)
+        offsets[r + 1] = offsets[r] + sizes[r];
+}
+
+inline int mpi_layout
+::owner(size_t i) const
+{
+    return int(std::upper_bound(offsets.begin(), offsets.end(), i) - offsets.begin() - 1);
+}
+
+inline mpi_layout mpi_uniform_layout(MPI_Comm comm, size_t N)
+{
+    const size_t num_ranks = cusp::detail::mpi_size(comm);
+
+    mpi_layout layout;
+    layout.comm = comm;
+    layout.rank = cusp::detail::mpi_rank(comm);
+    layout.offsets.resize(num_ranks + 1);
+
+    for (size_t r = 0; r < num_ranks; r++)
+        layout.offsets[r + 1] = layout.offsets[r] + N / num_ranks + (r < N % num_ranks ? 1 : 0);
+
+    return layout;
+}
+
+/////////////////
+// mpi_array1d //
+/////////////////
+template <typename ValueType>
+mpi_array1d<ValueType>
+::mpi_array1d(const cusp::mpi_layout& layout)
+  : layout(layout), local(layout.local_size())
+{
+}
+
+template <typename ValueType>
+mpi_array1d<ValueType>
+::mpi_array1d(const cusp::mpi_layout& layout, const ValueType& value)
+  : layout(layout), local(layout.local_size(), value)
+{
+}
+
+template <typename ValueType>
+template <typename Array>
+mpi_array1d<ValueType>
+::mpi_array1d(const cusp::mpi_layout& layout, const Array& local_rows)
+  : layout(layout)
+{
+    if (local_rows.size() != layout.local_size())
+        throw cusp::invalid_input_exception("array has the wrong size for the local rows of the layout");
+
+    local.resize(local_rows.size());
+    thrust::copy(local_rows.begin(), local_rows.end(), local.begin());
+}
+
+template <typename ValueType>
+void mpi_array1d<ValueType>
+::resize(const cusp::mpi_layout& new_layout)
+{
+    layout = new_layout;
+    local.resize(layout.local_size());
+}
+
+template <typename ValueType>
+template <typename Array>
+void mpi_array1d<ValueType>
+::gather(Array& x) const
+{
+    const size_t num_ranks = layout.num_ranks();
+
+    std::vector<int> counts(num_ranks);
+    std::vector<int> displacements(num_ranks);
+
+    for (size_t r = 0; r < num_ranks; r++)
+    {
+        counts[r]        = int(layout.offsets[r + 1] - layout.offsets[r]);
+        displacements[r] = int(layout.offsets[r]);
+    }
+
+    cusp::array1d<ValueType,cusp::host_memory> local_host(local);
+    cusp::array1d<ValueType,cusp::host_memory> x_host(size());
+
+    cusp::detail::mpi_check(MPI_Allgatherv(local_host.size() ? &local_host[0] : NULL, int(local_host.size()),
+                                           cusp::detail::mpi_datatype<ValueType>::type(),
+                                           x_host.size() ? &x_host[0] : NULL, &counts[0], &displacements[0],
+                                           cusp::detail::mpi_datatype<ValueType>::type(), layout.comm),
+                            "MPI_Allgatherv");
+
+    x.resize(size());
+    thrust::copy(x_host.begin(), x_host.end(), x.begin());
+}
+
+template <typename ValueType>
+void mpi_array1d<ValueType>
+::swap(mpi_array1d& x)
+{
+    std::swap(layout, x.layout);
+    local.swap(x.local);
+}
+
+} // end namespace cusp
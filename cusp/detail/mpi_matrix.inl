@@ -0,0 +1,336 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include <cusp/csr_matrix.h>
+#include <cusp/exception.h>
+#include <cusp/multiply.h>
+#include <cusp/stream.h>
+
+#include <cusp/detail/stream.h>
+#include <cusp/detail/device/spmv/coo_flat.h>
+
+#include <thrust/copy.h>
+#include <thrust/iterator/permutation_iterator.h>
+
+#include <algorithm>
+
+namespace cusp
+{
+
+//////////////////
+// Constructors //
+//////////////////
+
+template <typename LocalMatrix>
+mpi_matrix<LocalMatrix>
+::mpi_matrix(void)
+  : cuda_aware(false), comm(MPI_COMM_NULL), halo_stream(0), x_ready(0), finished(0)
+{
+}
+
+template <typename LocalMatrix>
+template <typename MatrixType>
+mpi_matrix<LocalMatrix>
+::mpi_matrix(const MatrixType& local_rows, const cusp::mpi_layout& layout)
+  : Parent(layout.size(), layout.size(), 0),
+    layout(layout), cuda_aware(cusp::detail::mpi_cuda_aware()),
+    comm(MPI_COMM_NULL), halo_stream(0), x_ready(0), finished(0)
+{
+    if (local_rows.num_rows != layout.local_size() || local_rows.num_cols != layout.size())
+        throw cusp::invalid_input_exception("local rows do not match the MPI layout");
+
+    initialize(local_rows);
+}
+
+template <typename LocalMatrix>
+mpi_matrix<LocalMatrix>
+::~mpi_matrix(void)
+{
+    release();
+}
+
+//////////////////////
+// Member Functions //
+//////////////////////
+
+template <typename LocalMatrix>
+template <typename MatrixType>
+void mpi_matrix<LocalMatrix>
+::initialize(const MatrixType& local_rows)
+{
+    cusp::csr_matrix<IndexType,ValueType,cusp::host_memory> A(local_rows);
+
+    const IndexType num_rows     = layout.local_size();
+    const IndexType column_begin = layout.first_row();
+    const IndexType column_end   = column_begin + num_rows;
+    const size_t    num_ranks    = layout.num_ranks();
+
+    // the entries of all processes form the global matrix
+    this->num_entries = cusp::detail::mpi_sum<unsigned long long>(A.num_entries, layout.comm);
+
+    // columns owned by other processes
+    std::vector<IndexType> ghosts;
+
+    size_t num_interior_entries = 0;
+
+    for (size_t jj = 0; jj < A.num_entries; jj++)
+    {
+        const IndexType j = A.column_indices[jj];
+
+        if (j < column_begin || j >= column_end)
+            ghosts.push_back(j);
+        else
+            num_interior_entries++;
+    }
+
+    const size_t num_boundary_entries = ghosts.size();
+
+    std::sort(ghosts.begin(), ghosts.end());
+    ghosts.erase(std::unique(ghosts.begin(), ghosts.end()), ghosts.end());
+
+    cusp::coo_matrix<IndexType,ValueType,cusp::host_memory> interior_host(num_rows, num_rows, num_interior_entries);
+    cusp::coo_matrix<IndexType,ValueType,cusp::host_memory> boundary_host(num_rows, ghosts.size(), num_boundary_entries);
+
+    size_t n_interior = 0;
+    size_t n_boundary = 0;
+
+    for (IndexType i = 0; i < num_rows; i++)
+    {
+        for (IndexType jj = A.row_offsets[i]; jj < A.row_offsets[i + 1]; jj++)
+        {
+            const IndexType j = A.column_indices[jj];
+
+            if (j < column_begin || j >= column_end)
+            {
+                boundary_host.row_indices[n_boundary]    = i;
+                boundary_host.column_indices[n_boundary] = std::lower_bound(ghosts.begin(), ghosts.end(), j) - ghosts.begin();
+                boundary_host.values[n_boundary]         = A.values[jj];
+                n_boundary++;
+            }
+            else
+            {
+                interior_host.row_indices[n_interior]    = i;
+                interior_host.column_indices[n_interior] = j - column_begin;
+                interior_host.values[n_interior]         = A.values[jj];
+                n_interior++;
+            }
+        }
+    }
+
+    // the ghosts are sorted, so the columns of each owner are contiguous
+    std::vector<int> receive_counts(num_ranks, 0);
+    std::vector<int> receive_displacements(num_ranks, 0);
+
+    for (size_t k = 0; k < ghosts.size();)
+    {
+        const int r = layout.owner(ghosts[k]);
+
+        size_t end = k;
+        while (end < ghosts.size() && size_t(ghosts[end]) < layout.offsets[r + 1])
+            end++;
+
+        message m;
+        m.rank   = r;
+        m.offset = k;
+        m.size   = end - k;
+        receives.push_back(m);
+
+        receive_counts[r]        = int(end - k);
+        receive_displacements[r] = int(k);
+
+        k = end;
+    }
+
+    // tell the owners which of their rows are needed
+    std::vector<int> send_counts(num_ranks, 0);
+    std::vector<int> send_displacements(num_ranks, 0);
+
+    cusp::detail::mpi_check(MPI_Alltoall(&receive_counts[0], 1, MPI_INT, &send_counts[0], 1, MPI_INT, layout.comm),
+                            "MPI_Alltoall");
+
+    size_t num_sent = 0;
+
+    for (size_t r = 0; r < num_ranks; r++)
+    {
+        send_displacements[r] = int(num_sent);
+
+        if (send_counts[r] > 0)
+        {
+            message m;
+            m.rank   = int(r);
+            m.offset = num_sent;
+            m.size   = send_counts[r];
+            sends.push_back(m);
+        }
+
+        num_sent += send_counts[r];
+    }
+
+    std::vector<long long> requested(ghosts.begin(), ghosts.end());
+    std::vector<long long> needed(num_sent);
+
+    cusp::detail::mpi_check(MPI_Alltoallv(requested.empty() ? NULL : &requested[0], &receive_counts[0], &receive_displacements[0], MPI_LONG_LONG,
+                                          needed.empty()    ? NULL : &needed[0],    &send_counts[0],    &send_displacements[0],    MPI_LONG_LONG,
+                                          layout.comm),
+                            "MPI_Alltoallv");
+
+    cusp::array1d<IndexType,cusp::host_memory> send_indices_host(num_sent);
+
+    for (size_t k = 0; k < num_sent; k++)
+        send_indices_host[k] = IndexType(needed[k] - column_begin);
+
+    interior = interior_host;
+    boundary = boundary_host;
+
+    ghost_columns.resize(ghosts.size());
+    thrust::copy(ghosts.begin(), ghosts.end(), ghost_columns.begin());
+
+    halo.resize(ghosts.size());
+    send_indices = send_indices_host;
+    send_buffer.resize(num_sent);
+
+    if (!cuda_aware)
+    {
+        halo_host.resize(ghosts.size());
+        send_host.resize(num_sent);
+    }
+
+    cudaStreamCreateWithFlags(&halo_stream, cudaStreamNonBlocking);
+    cudaEventCreateWithFlags(&x_ready,  cudaEventDisableTiming);
+    cudaEventCreateWithFlags(&finished, cudaEventDisableTiming);
+
+    // a private communicator keeps the messages of this matrix apart
+    cusp::detail::mpi_check(MPI_Comm_dup(layout.comm, &comm), "MPI_Comm_dup");
+
+    ValueType * halo_ptr = cuda_aware ? thrust::raw_pointer_cast(halo.data()) : thrust::raw_pointer_cast(halo_host.data());
+    ValueType * send_ptr = cuda_aware ? thrust::raw_pointer_cast(send_buffer.data()) : thrust::raw_pointer_cast(send_host.data());
+
+    const MPI_Datatype datatype = cusp::detail::mpi_datatype<ValueType>::type();
+
+    requests.resize(receives.size() + sends.size(), MPI_REQUEST_NULL);
+
+    for (size_t k = 0; k < receives.size(); k++)
+        cusp::detail::mpi_check(MPI_Recv_init(halo_ptr + receives[k].offset, int(receives[k].size), datatype,
+                                              receives[k].rank, 0, comm, &requests[k]),
+                                "MPI_Recv_init");
+
+    for (size_t k = 0; k < sends.size(); k++)
+        cusp::detail::mpi_check(MPI_Send_init(send_ptr + sends[k].offset, int(sends[k].size), datatype,
+                                              sends[k].rank, 0, comm, &requests[receives.size() + k]),
+                                "MPI_Send_init");
+}
+
+template <typename LocalMatrix>
+void mpi_matrix<LocalMatrix>
+::release(void)
+{
+    int finalized = 0;
+    MPI_Finalized(&finalized);
+
+    // nothing can be freed once MPI has been finalized
+    if (!finalized)
+    {
+        for (size_t k = 0; k < requests.size(); k++)
+            if (requests[k] != MPI_REQUEST_NULL)
+                MPI_Request_free(&requests[k]);
+
+        if (comm != MPI_COMM_NULL)
+            MPI_Comm_free(&comm);
+    }
+
+    requests.clear();
+
+    if (halo_stream) cudaStreamDestroy(halo_stream);
+    if (x_ready)     cudaEventDestroy(x_ready);
+    if (finished)    cudaEventDestroy(finished);
+}
+
+template <typename LocalMatrix>
+void mpi_matrix<LocalMatrix>
+::operator()(const cusp::mpi_array1d<ValueType>& x,
+                   cusp::mpi_array1d<ValueType>& y) const
+{
+    CUSP_PROFILE_SCOPED();
+
+    if (x.layout != layout || y.layout != layout)
+        throw cusp::invalid_input_exception("MPI array layouts do not match the matrix");
+
+    const cudaStream_t stream = cusp::detail::device::current_stream();
+
+    const int num_receives = int(receives.size());
+    const int num_sends    = int(sends.size());
+
+    if (!requests.empty())
+    {
+        // the previous product must have read the halo before it is overwritten
+        cudaEventSynchronize(finished);
+
+        if (num_receives > 0)
+            cusp::detail::mpi_check(MPI_Startall(num_receives, &requests[0]), "MPI_Startall");
+    }
+
+    if (num_sends > 0)
+    {
+        // gather the rows needed by the neighbours once x has been written
+        cudaEventRecord(x_ready, stream);
+        cudaStreamWaitEvent(halo_stream, x_ready, 0);
+
+        {
+            cusp::stream_scope scope(halo_stream);
+
+            cusp::detail::stream::copy(thrust::make_permutation_iterator(x.local.begin(), send_indices.begin()),
+                                       thrust::make_permutation_iterator(x.local.begin(), send_indices.end()),
+                                       send_buffer.begin());
+        }
+
+        if (!cuda_aware)
+            cudaMemcpyAsync(thrust::raw_pointer_cast(send_host.data()),
+                            thrust::raw_pointer_cast(send_buffer.data()),
+                            send_buffer.size() * sizeof(ValueType),
+                            cudaMemcpyDeviceToHost, halo_stream);
+
+        // MPI does not order its transfers with the streams
+        cudaStreamSynchronize(halo_stream);
+
+        cusp::detail::mpi_check(MPI_Startall(num_sends, &requests[num_receives]), "MPI_Startall");
+    }
+
+    // multiply the interior block while the messages are in flight
+    if (layout.local_size() > 0)
+        cusp::multiply(interior, x.local, y.local);
+
+    if (!requests.empty())
+        cusp::detail::mpi_check(MPI_Waitall(int(requests.size()), &requests[0], MPI_STATUSES_IGNORE), "MPI_Waitall");
+
+    // add the product of the boundary block
+    if (boundary.num_entries > 0)
+    {
+        if (!cuda_aware)
+            cudaMemcpyAsync(thrust::raw_pointer_cast(halo.data()),
+                            thrust::raw_pointer_cast(halo_host.data()),
+                            halo.size() * sizeof(ValueType),
+                            cudaMemcpyHostToDevice, stream);
+
+        cusp::detail::device::__spmv_coo_flat<false, false>(boundary,
+                                                            thrust::raw_pointer_cast(&halo[0]),
+                                                            thrust::raw_pointer_cast(&y.local[0]));
+    }
+
+    if (!requests.empty())
+        cudaEventRecord(finished, stream);
+}
+
+} // end namespace cusp
@@ -14,36 +14,562 @@
  *  limitations under the License.
  */
 
+#include <cusp/array2d.h>
 #include <cusp/blas.h>
+#include <cusp/conversion_plan.h>
+#include <cusp/coo_matrix.h>
+#include <cusp/copy.h>
+#include <cusp/csr_matrix.h>
+#include <cusp/dia_matrix.h>
+#include <cusp/ell_matrix.h>
+#include <cusp/hyb_matrix.h>
 #include <cusp/multiply.h>
 #include <cusp/monitor.h>
+#include <cusp/transpose.h>
+
+#include <thrust/detail/type_traits.h>
 
 namespace cusp
 {
+namespace detail
+{
+
+// coarse solvers operating on host memory (e.g. lu_solver)
+template <typename SolverType, typename Array1, typename Array2>
+void coarse_solve(SolverType& solver, const Array1& b, Array2& x, cusp::host_memory)
+{
+    typedef typename Array2::value_type ValueType;
+
+    cusp::array1d<ValueType,cusp::host_memory> temp_b(b);
+    cusp::array1d<ValueType,cusp::host_memory> temp_x(x.size());
+    solver(temp_b, temp_x);
+    x = temp_x;
+}
+
+// coarse solvers operating on device memory (e.g. dense_inverse_solver)
+template <typename SolverType, typename Array1, typename Array2>
+void coarse_solve(SolverType& solver, const Array1& b, Array2& x, cusp::device_memory)
+{
+    solver(b, x);
+}
+
+// estimated bytes moved by one SpMV with a sparse matrix: the column
+// indices and values of the entries, one offset per row, the input vector
+// and the output vector
+template <typename IndexType, typename MatrixValueType, typename ValueType>
+double spmv_bytes(size_t num_rows, size_t num_cols, size_t num_entries)
+{
+    return double(num_entries) * (sizeof(IndexType) + sizeof(MatrixValueType)) +
+           double(num_rows)    * (sizeof(IndexType) + sizeof(ValueType)) +
+           double(num_cols)    * sizeof(ValueType);
+}
+
+inline const char * level_format_name(const cusp::level_format format)
+{
+    static const char * names[] = { "matrix_type", "coo", "csr", "dia", "ell", "hyb", "dense", "auto" };
+    return names[format];
+}
+
+// copy of M in format, wrapped in op.  LEVEL_AUTO picks the planned sparse
+// format or a dense array2d, whichever has the least estimated SpMV time:
+// a dense SpMV reads every value of M and both vectors in one launch.
+template <typename MatrixType, typename ValueType, typename MemorySpace, typename IndexType>
+cusp::level_format
+level_operator(const MatrixType& M, cusp::level_format format,
+               const cusp::conversion_plan_options& options,
+               cusp::detail::erased_operator<ValueType,MemorySpace,IndexType>& op)
+{
+    typedef typename MatrixType::value_type MatrixValueType;
+    typedef cusp::detail::erased_operator<ValueType,MemorySpace,IndexType> Operator;
+
+    if (format == cusp::LEVEL_MATRIX_TYPE)
+    {
+        op = Operator();
+        return format;
+    }
+
+    cusp::csr_matrix<IndexType,MatrixValueType,MemorySpace> C(M);
+    const cusp::conversion_plan plan = cusp::plan_conversion(C, options);
+
+    if (format == cusp::LEVEL_AUTO)
+    {
+        const double dense_bytes = double(M.num_rows) * double(M.num_cols) * sizeof(MatrixValueType) +
+                                   double(M.num_rows + M.num_cols) * sizeof(ValueType);
+        const double dense_seconds = dense_bytes / (double(options.bandwidth) * 1.0e9) + options.launch_latency;
+
+        if (dense_seconds < plan.seconds[plan.format])
+            format = cusp::LEVEL_DENSE;
+        else
+            format = cusp::level_format(cusp::LEVEL_COO + plan.format);
+    }
+
+    switch (format)
+    {
+        case cusp::LEVEL_COO:
+        {
+            cusp::coo_matrix<IndexType,MatrixValueType,MemorySpace> D(C);
+            op = Operator(D);
+            break;
+        }
+        case cusp::LEVEL_DIA:
+        {
+            cusp::dia_matrix<IndexType,MatrixValueType,MemorySpace> D;
+            cusp::convert(C, D, plan);
+            op = Operator(D);
+            break;
+        }
+        case cusp::LEVEL_ELL:
+        {
+            cusp::ell_matrix<IndexType,MatrixValueType,MemorySpace> D;
+            cusp::convert(C, D, plan);
+            op = Operator(D);
+            break;
+        }
+        case cusp::LEVEL_HYB:
+        {
+            cusp::hyb_matrix<IndexType,MatrixValueType,MemorySpace> D;
+            cusp::convert(C, D, plan);
+            op = Operator(D);
+            break;
+        }
+        case cusp::LEVEL_DENSE:
+        {
+            cusp::array2d<MatrixValueType,MemorySpace> D(C);
+            op = Operator(D);
+            break;
+        }
+        default:
+            op = Operator(C);
+            format = cusp::LEVEL_CSR;
+    }
+
+    return format;
+}
+
+} // end namespace detail
+
+namespace relaxation
+{
+
+// presmooth x and compute residual <- b - A*x.  Smoothers which fuse the
+// residual computation into their sweeps (e.g. jacobi) provide overloads
+// of this function which are found by argument dependent lookup.
+template <typename SmootherType, typename MatrixType, typename Array1, typename Array2, typename Array3>
+void presmooth_with_residual(SmootherType& smoother, const MatrixType& A, const Array1& b, Array2& x, Array3& residual)
+{
+    smoother.presmooth(A, b, x);
+
+    cusp::detail::residual(A, x, b, residual);
+}
 
-template <typename MatrixType, typename SmootherType, typename SolverType>
-template <typename MatrixType2, typename SmootherType2, typename SolverType2>
-multilevel<MatrixType,SmootherType,SolverType>
-::multilevel(const multilevel<MatrixType2,SmootherType2,SolverType2>& M)
+// postsmooth x and compute residual <- b - A*x
+template <typename SmootherType, typename MatrixType, typename Array1, typename Array2, typename Array3>
+void postsmooth_with_residual(SmootherType& smoother, const MatrixType& A, const Array1& b, Array2& x, Array3& residual)
+{
+    smoother.postsmooth(A, b, x);
+
+    cusp::detail::residual(A, x, b, residual);
+}
+
+} // end namespace relaxation
+
+template <typename MatrixType, typename SmootherType, typename SolverType, typename ValueType>
+multilevel<MatrixType,SmootherType,SolverType,ValueType>
+::multilevel(const multilevel& M)
+    : solver(M.solver), levels(M.levels),
+      cycle(M.cycle), presmooth_sweeps(M.presmooth_sweeps), postsmooth_sweeps(M.postsmooth_sweeps),
+      host_level_size(0), host_level_begin(0), host_levels(NULL),
+      implicit_restriction(M.implicit_restriction),
+      graph_capture(M.graph_capture), profiling(M.profiling), fine_operator(M.fine_operator),
+      level_format_options(M.level_format_options), graph_b(NULL), graph_x(NULL)
+{
+   set_host_levels(M.host_level_size);
+}
+
+template <typename MatrixType, typename SmootherType, typename SolverType, typename ValueType>
+template <typename MatrixType2, typename SmootherType2, typename SolverType2, typename ValueType2>
+multilevel<MatrixType,SmootherType,SolverType,ValueType>
+::multilevel(const multilevel<MatrixType2,SmootherType2,SolverType2,ValueType2>& M)
+    : cycle(M.cycle), presmooth_sweeps(M.presmooth_sweeps), postsmooth_sweeps(M.postsmooth_sweeps),
+      host_level_size(0), host_level_begin(0), host_levels(NULL),
+      implicit_restriction(M.implicit_restriction),
+      graph_capture(M.graph_capture), profiling(M.profiling), graph_b(NULL), graph_x(NULL)
 {
    for( size_t lvl = 0; lvl < M.levels.size(); lvl++ )
       levels.push_back(M.levels[lvl]);
+
+   // the coarse solver may live in a different memory space so set it up again
+   if (!levels.empty())
+      solver = SolverType(levels.back().A);
+
+   set_host_levels(M.host_level_size);
+}
+
+template <typename MatrixType, typename SmootherType, typename SolverType, typename ValueType>
+multilevel<MatrixType,SmootherType,SolverType,ValueType>
+::~multilevel()
+{
+   delete host_levels;
+}
+
+template <typename MatrixType, typename SmootherType, typename SolverType, typename ValueType>
+multilevel<MatrixType,SmootherType,SolverType,ValueType>&
+multilevel<MatrixType,SmootherType,SolverType,ValueType>
+::operator=(const multilevel& M)
+{
+   if (this != &M)
+   {
+      solver = M.solver;
+      levels = M.levels;
+      cycle = M.cycle;
+      presmooth_sweeps = M.presmooth_sweeps;
+      postsmooth_sweeps = M.postsmooth_sweeps;
+      implicit_restriction = M.implicit_restriction;
+      profiling = M.profiling;
+      fine_operator = M.fine_operator;
+      level_format_options = M.level_format_options;
+
+      set_host_levels(M.host_level_size);
+      set_graph_capture(M.graph_capture);
+   }
+
+   return *this;
+}
+
+template <typename MatrixType, typename SmootherType, typename SolverType, typename ValueType>
+void multilevel<MatrixType,SmootherType,SolverType,ValueType>
+::set_host_levels(size_t max_rows)
+{
+    CUSP_PROFILE_SCOPED();
+
+    delete host_levels;
+    host_levels = NULL;
+
+    set_graph_capture(graph_capture);
+
+    host_level_size  = max_rows;
+    host_level_begin = levels.size();
+
+    // levels of a host hierarchy already run on the host
+    if (max_rows == 0 || thrust::detail::is_same<MemorySpace,cusp::host_memory>::value)
+        return;
+
+    // the finest level always stays in place
+    for (size_t lvl = 1; lvl < levels.size(); lvl++)
+    {
+        if (levels[lvl].A.num_rows <= max_rows)
+        {
+            host_level_begin = lvl;
+            break;
+        }
+    }
+
+    if (host_level_begin == levels.size())
+        return;
+
+    host_levels = new host_hierarchy;
+    host_levels->implicit_restriction = implicit_restriction;
+    host_levels->profiling = profiling;
+
+    for (size_t lvl = host_level_begin; lvl < levels.size(); lvl++)
+        host_levels->levels.push_back(typename host_hierarchy::level(levels[lvl]));
+
+    host_levels->solver = HostSolverType(host_levels->levels.back().A);
 }
 
-template <typename MatrixType, typename SmootherType, typename SolverType>
+template <typename MatrixType, typename SmootherType, typename SolverType, typename ValueType>
 template <typename Array1, typename Array2>
-void multilevel<MatrixType,SmootherType,SolverType>
+void multilevel<MatrixType,SmootherType,SolverType,ValueType>
 ::operator()(const Array1& b, Array2& x)
 {
     CUSP_PROFILE_SCOPED();
 
-    // perform 1 V-cycle
+    // profiled stages synchronize and cannot be captured
+    if (!graph_capture || profiling || !_graph_capturable() || b.size() == 0)
+    {
+        // perform 1 cycle
+        _solve(b, x, 0);
+        return;
+    }
+
+    cudaStream_t stream = cusp::current_stream();
+
+    // inside an enclosing capture the cycle is simply recorded there
+    if (cusp::detail::device::is_capturing(stream))
+    {
+        _solve(b, x, 0);
+        return;
+    }
+
+    const void* b_ptr = thrust::raw_pointer_cast(&b[0]);
+    const void* x_ptr = thrust::raw_pointer_cast(&x[0]);
+
+    if (b_ptr == graph_b && x_ptr == graph_x && !graph.empty())
+    {
+        graph.launch(stream);
+        return;
+    }
+
+    if (b_ptr != graph_b || x_ptr != graph_x)
+    {
+        // warm up with new vectors, the next cycle is captured
+        graph.reset();
+        graph_b = b_ptr;
+        graph_x = x_ptr;
+
+        _solve(b, x, 0);
+        return;
+    }
+
+    if (graph.begin_capture())
+    {
+        {
+            cusp::stream_scope scope(graph.stream());
+            _solve(b, x, 0);
+        }
+
+        if (graph.end_capture())
+        {
+            graph.launch(stream);
+            return;
+        }
+    }
+
+    // the cycle cannot be captured, stop trying
+    graph_capture = false;
+    graph_b = graph_x = NULL;
+
     _solve(b, x, 0);
 }
 
-template <typename MatrixType, typename SmootherType, typename SolverType>
+template <typename MatrixType, typename SmootherType, typename SolverType, typename ValueType>
+void multilevel<MatrixType,SmootherType,SolverType,ValueType>
+::set_graph_capture(bool enable)
+{
+    graph.reset();
+    graph_capture = enable;
+    graph_b = graph_x = NULL;
+}
+
+template <typename MatrixType, typename SmootherType, typename SolverType, typename ValueType>
+void multilevel<MatrixType,SmootherType,SolverType,ValueType>
+::set_implicit_restriction(bool enable)
+{
+    CUSP_PROFILE_SCOPED();
+
+    if (enable)
+    {
+        // release the explicit restriction operators
+        for (size_t lvl = 0; lvl < levels.size(); lvl++)
+        {
+            MatrixType empty;
+            levels[lvl].R.swap(empty);
+        }
+    }
+    else if (implicit_restriction)
+    {
+        // form R = P^T again
+        for (size_t lvl = 0; lvl + 1 < levels.size(); lvl++)
+        {
+            cusp::coo_matrix<IndexType,typename MatrixType::value_type,MemorySpace> P(levels[lvl].P);
+            cusp::coo_matrix<IndexType,typename MatrixType::value_type,MemorySpace> R;
+            cusp::transpose(P, R);
+            levels[lvl].R = R;
+        }
+    }
+
+    implicit_restriction = enable;
+
+    // the host levels hold a copy of R
+    set_host_levels(host_level_size);
+}
+
+template <typename MatrixType, typename SmootherType, typename SolverType, typename ValueType>
+template <typename LinearOperator>
+void multilevel<MatrixType,SmootherType,SolverType,ValueType>
+::set_fine_operator(const LinearOperator& A)
+{
+    if (levels.empty() || A.num_rows != levels[0].A.num_rows || A.num_cols != levels[0].A.num_cols)
+        throw cusp::invalid_input_exception("the fine operator must have the dimensions of the finest level");
+
+    fine_operator = detail::erased_operator<ValueType,MemorySpace,IndexType>(A);
+
+    // a captured cycle applies the previous operator
+    set_graph_capture(graph_capture);
+}
+
+template <typename MatrixType, typename SmootherType, typename SolverType, typename ValueType>
+void multilevel<MatrixType,SmootherType,SolverType,ValueType>
+::clear_fine_operator(void)
+{
+    fine_operator = detail::erased_operator<ValueType,MemorySpace,IndexType>();
+
+    set_graph_capture(graph_capture);
+}
+
+template <typename MatrixType, typename SmootherType, typename SolverType, typename ValueType>
+void multilevel<MatrixType,SmootherType,SolverType,ValueType>
+::set_level_formats(level_format format, const cusp::conversion_plan_options& options)
+{
+    set_level_formats(std::vector<level_format>(levels.size(), format), options);
+}
+
+template <typename MatrixType, typename SmootherType, typename SolverType, typename ValueType>
+void multilevel<MatrixType,SmootherType,SolverType,ValueType>
+::set_level_formats(const std::vector<level_format>& formats, const cusp::conversion_plan_options& options)
+{
+    if (formats.size() != levels.size())
+        throw cusp::invalid_input_exception("set_level_formats needs one format per level");
+
+    level_format_options = options;
+
+    for (size_t lvl = 0; lvl < levels.size(); lvl++)
+    {
+        level& L = levels[lvl];
+
+        L.A_format = detail::level_operator(L.A, formats[lvl], options, L.A_op);
+
+        // the coarsest level has no transfer operators
+        const bool coarsest = lvl + 1 == levels.size();
+
+        L.P_format = detail::level_operator(L.P, coarsest ? LEVEL_MATRIX_TYPE : formats[lvl], options, L.P_op);
+        L.R_format = detail::level_operator(L.R, coarsest || implicit_restriction ? LEVEL_MATRIX_TYPE : formats[lvl], options, L.R_op);
+    }
+
+    // a captured cycle applies the previous operators
+    set_graph_capture(graph_capture);
+}
+
+template <typename MatrixType, typename SmootherType, typename SolverType, typename ValueType>
+void multilevel<MatrixType,SmootherType,SolverType,ValueType>
+::_refresh_level_formats(void)
+{
+    for (size_t lvl = 0; lvl < levels.size(); lvl++)
+    {
+        level& L = levels[lvl];
+
+        L.A_format = detail::level_operator(L.A, L.A_format, level_format_options, L.A_op);
+        L.P_format = detail::level_operator(L.P, L.P_format, level_format_options, L.P_op);
+        L.R_format = detail::level_operator(L.R, implicit_restriction ? LEVEL_MATRIX_TYPE : L.R_format, level_format_options, L.R_op);
+    }
+}
+
+template <typename MatrixType, typename SmootherType, typename SolverType, typename ValueType>
+void multilevel<MatrixType,SmootherType,SolverType,ValueType>
+::set_profiling(bool enable)
+{
+    profiling = enable;
+
+    for (size_t lvl = 0; lvl < levels.size(); lvl++)
+        levels[lvl].timings = multilevel_level_timings();
+
+    if (host_levels != NULL)
+        host_levels->set_profiling(enable);
+}
+
+template <typename MatrixType, typename SmootherType, typename SolverType, typename ValueType>
+const multilevel_level_timings&
+multilevel<MatrixType,SmootherType,SolverType,ValueType>
+::_level_timings(const size_t i) const
+{
+    if (host_levels != NULL && i >= host_level_begin)
+        return host_levels->levels[i - host_level_begin].timings;
+    else
+        return levels[i].timings;
+}
+
+template <typename MatrixType, typename SmootherType, typename SolverType, typename ValueType>
+void multilevel<MatrixType,SmootherType,SolverType,ValueType>
+::write_profile(std::ostream& os) const
+{
+    typedef typename MatrixType::value_type MatrixValueType;
+
+    const size_t num_levels = levels.size();
+
+    size_t rows = 0;
+    size_t nnz  = 0;
+    for (size_t lvl = 0; lvl < num_levels; lvl++)
+    {
+        rows += levels[lvl].A.num_rows;
+        nnz  += levels[lvl].A.num_entries;
+    }
+
+    os << "{\n";
+    os << "  \"num_levels\": " << num_levels << ",\n";
+    if (num_levels > 0)
+    {
+        os << "  \"operator_complexity\": " << double(nnz)  / double(levels[0].A.num_entries) << ",\n";
+        os << "  \"grid_complexity\": "     << double(rows) / double(levels[0].A.num_rows)    << ",\n";
+    }
+    os << "  \"cycles\": " << (num_levels > 0 ? _level_timings(0).visits : 0) << ",\n";
+    os << "  \"levels\": [";
+
+    for (size_t lvl = 0; lvl < num_levels; lvl++)
+    {
+        const MatrixType& A = levels[lvl].A;
+        const multilevel_level_timings& T = _level_timings(lvl);
+
+        double A_bytes = detail::spmv_bytes<IndexType,MatrixValueType,ValueType>(A.num_rows, A.num_cols, A.num_entries);
+        double bytes   = A_bytes;
+
+        // smoothing sweeps, residual, restriction and prolongation
+        if (lvl + 1 < num_levels)
+        {
+            const MatrixType& P = levels[lvl].P;
+            double P_bytes = detail::spmv_bytes<IndexType,MatrixValueType,ValueType>(P.num_rows, P.num_cols, P.num_entries);
+            double R_bytes = detail::spmv_bytes<IndexType,MatrixValueType,ValueType>(P.num_cols, P.num_rows, P.num_entries);
+
+            bytes = (presmooth_sweeps + postsmooth_sweeps + 1) * A_bytes + R_bytes + P_bytes;
+        }
+
+        const double total = T.total();
+        const double gbytes_per_second = total > 0 ? (bytes * T.visits) / (total * 1.0e6) : 0.0;
+
+        os << (lvl == 0 ? "\n" : ",\n");
+        os << "    {\"level\": " << lvl
+           << ", \"rows\": " << A.num_rows
+           << ", \"nonzeros\": " << A.num_entries
+           << ", \"host\": " << ((host_levels != NULL && lvl >= host_level_begin) ? "true" : "false")
+           << ", \"format\": \"" << detail::level_format_name(levels[lvl].A_format) << "\""
+           << ", \"visits\": " << T.visits
+           << ",\n     \"presmooth_ms\": " << T.presmooth
+           << ", \"residual_ms\": " << T.residual
+           << ", \"restriction_ms\": " << T.restriction
+           << ", \"prolongation_ms\": " << T.prolongation
+           << ", \"postsmooth_ms\": " << T.postsmooth
+           << ", \"coarse_solve_ms\": " << T.coarse_solve
+           << ", \"total_ms\": " << total
+           << ",\n     \"bytes_per_visit\": " << bytes
+           << ", \"effective_gbytes_per_second\": " << gbytes_per_second << "}";
+    }
+
+    os << "\n  ]\n}";
+}
+
+template <typename MatrixType, typename SmootherType, typename SolverType, typename ValueType>
+bool multilevel<MatrixType,SmootherType,SolverType,ValueType>
+::_graph_capturable(void) const
+{
+    return cusp::detail::device::captured_graph::supported() &&
+           thrust::detail::is_same<MemorySpace,cusp::device_memory>::value &&
+           thrust::detail::is_same<typename SolverType::memory_space,cusp::device_memory>::value &&
+           cycle != K_CYCLE && host_levels == NULL && !levels.empty();
+}
+
+template <typename MatrixType, typename SmootherType, typename SolverType, typename ValueType>
+void multilevel<MatrixType,SmootherType,SolverType,ValueType>
+::set_cycle(cycle_type cycle, size_t presmooth_sweeps, size_t postsmooth_sweeps)
+{
+    this->cycle = cycle;
+    this->presmooth_sweeps = presmooth_sweeps;
+    this->postsmooth_sweeps = postsmooth_sweeps;
+
+    set_graph_capture(graph_capture);
+}
+
+template <typename MatrixType, typename SmootherType, typename SolverType, typename ValueType>
 template <typename Array1, typename Array2>
-void multilevel<MatrixType,SmootherType,SolverType>
+void multilevel<MatrixType,SmootherType,SolverType,ValueType>
 ::solve(const Array1& b, Array2& x)
 {
     CUSP_PROFILE_SCOPED();
@@ -53,9 +579,9 @@ void multilevel<MatrixType,SmootherType,SolverType>
     solve(b, x, monitor);
 }
 
-template <typename MatrixType, typename SmootherType, typename SolverType>
+template <typename MatrixType, typename SmootherType, typename SolverType, typename ValueType>
 template <typename Array1, typename Array2, typename Monitor>
-void multilevel<MatrixType,SmootherType,SolverType>
+void multilevel<MatrixType,SmootherType,SolverType,ValueType>
 ::solve(const Array1& b, Array2& x, Monitor& monitor)
 {
     CUSP_PROFILE_SCOPED();
@@ -69,9 +595,7 @@ void multilevel<MatrixType,SmootherType,SolverType>
     cusp::array1d<ValueType,MemorySpace> residual(n);
 
     // compute initial residual
-    /* cusp::multiply(A, x, residual); */
-    cusp::multiply(levels[0].A, x, residual);
-    cusp::blas::axpby(b, residual, residual, ValueType(1.0), ValueType(-1.0));
+    _fine_residual(b, x, residual);
 
     while(!monitor.finished(residual))
     {
@@ -81,60 +605,275 @@ void multilevel<MatrixType,SmootherType,SolverType>
         cusp::blas::axpy(update, x, ValueType(1.0));
 
         // update residual
-        /* cusp::multiply(A, x, residual); */
-        cusp::multiply(levels[0].A, x, residual);
-        cusp::blas::axpby(b, residual, residual, ValueType(1.0), ValueType(-1.0));
+        _fine_residual(b, x, residual);
         ++monitor;
     }
 }
 
-template <typename MatrixType, typename SmootherType, typename SolverType>
+template <typename MatrixType, typename SmootherType, typename SolverType, typename ValueType>
 template <typename Array1, typename Array2>
-void multilevel<MatrixType,SmootherType,SolverType>
+void multilevel<MatrixType,SmootherType,SolverType,ValueType>
 ::_solve(const Array1& b, Array2& x, const size_t i)
+{
+    _solve(b, x, i, cycle);
+}
+
+template <typename MatrixType, typename SmootherType, typename SolverType, typename ValueType>
+template <typename Array1, typename Array2, typename Array3>
+void multilevel<MatrixType,SmootherType,SolverType,ValueType>
+::_fine_residual(const Array1& b, const Array2& x, Array3& residual)
+{
+    if (fine_operator.empty())
+        _level_residual(0, x, b, residual);
+    else
+        cusp::detail::residual(fine_operator, x, b, residual);
+}
+
+template <typename MatrixType, typename SmootherType, typename SolverType, typename ValueType>
+template <typename Array1, typename Array2>
+void multilevel<MatrixType,SmootherType,SolverType,ValueType>
+::_level_multiply(const size_t i, const Array1& x, Array2& y)
+{
+    if (levels[i].A_op.empty())
+        cusp::multiply(levels[i].A, x, y);
+    else
+        levels[i].A_op(x, y);
+}
+
+template <typename MatrixType, typename SmootherType, typename SolverType, typename ValueType>
+template <typename Array1, typename Array2, typename Array3>
+void multilevel<MatrixType,SmootherType,SolverType,ValueType>
+::_level_residual(const size_t i, const Array1& x, const Array2& b, Array3& r)
+{
+    if (levels[i].A_op.empty())
+        cusp::detail::residual(levels[i].A, x, b, r);
+    else
+        levels[i].A_op.residual(x, b, r);
+}
+
+template <typename MatrixType, typename SmootherType, typename SolverType, typename ValueType>
+template <typename Array1, typename Array2>
+void multilevel<MatrixType,SmootherType,SolverType,ValueType>
+::_solve(const Array1& b, Array2& x, const size_t i, const cycle_type level_cycle)
+{
+    if (i == 0 && !fine_operator.empty())
+        _solve(fine_operator, b, x, i, level_cycle);
+    else if (!levels[i].A_op.empty())
+        _solve(levels[i].A_op, b, x, i, level_cycle);
+    else
+        _solve(levels[i].A, b, x, i, level_cycle);
+}
+
+template <typename MatrixType, typename SmootherType, typename SolverType, typename ValueType>
+template <typename LevelOperator, typename Array1, typename Array2>
+void multilevel<MatrixType,SmootherType,SolverType,ValueType>
+::_solve(const LevelOperator& A, const Array1& b, Array2& x, const size_t i, const cycle_type level_cycle)
 {
     CUSP_PROFILE_SCOPED();
 
+    // a disabled timer returns 0 for every lap
+    multilevel_level_timings& T = levels[i].timings;
+    cusp::detail::lap_timer timer(cusp::current_stream(), profiling);
+
+    if (profiling)
+        T.visits++;
+
     if (i + 1 == levels.size())
     {
         // coarse grid solve
-        // TODO streamline
-        cusp::array1d<ValueType,cusp::host_memory> temp_b(b);
-        cusp::array1d<ValueType,cusp::host_memory> temp_x(x.size());
-        solver(temp_b, temp_x);
-        x = temp_x;
+        cusp::detail::coarse_solve(solver, b, x, typename SolverType::memory_space());
+        T.coarse_solve += timer.lap();
     }
     else
     {
-    	/* const MatrixType& A = levels[i].A; */
-
-        // presmooth
-        /* levels[i].smoother.presmooth(A, b, x); */
-        levels[i].smoother.presmooth(levels[i].A, b, x);
-
-        // compute residual <- b - A*x
-        /* cusp::multiply(A, x, levels[i].residual); */
-        cusp::multiply(levels[i].A, x, levels[i].residual);
-        cusp::blas::axpby(b, levels[i].residual, levels[i].residual, ValueType(1.0), ValueType(-1.0));
+        using cusp::relaxation::presmooth_with_residual;
+        using cusp::relaxation::postsmooth_with_residual;
+
+        // presmooth and compute residual <- b - A*x
+        if (presmooth_sweeps == 0)
+        {
+            cusp::blas::fill(x, ValueType(0));
+            T.presmooth += timer.lap();
+            cusp::blas::copy(b, levels[i].residual);
+            T.residual += timer.lap();
+        }
+        else if (profiling)
+        {
+            // time the smoother and the residual separately
+            levels[i].smoother.presmooth(A, b, x);
+            for (size_t k = 1; k < presmooth_sweeps; k++)
+                levels[i].smoother.postsmooth(A, b, x);
+            T.presmooth += timer.lap();
+
+            cusp::detail::residual(A, x, b, levels[i].residual);
+            T.residual += timer.lap();
+        }
+        else if (presmooth_sweeps == 1)
+        {
+            presmooth_with_residual(levels[i].smoother, A, b, x, levels[i].residual);
+        }
+        else
+        {
+            levels[i].smoother.presmooth(A, b, x);
+            for (size_t k = 2; k < presmooth_sweeps; k++)
+                levels[i].smoother.postsmooth(A, b, x);
+            postsmooth_with_residual(levels[i].smoother, A, b, x, levels[i].residual);
+        }
 
         // restrict to coarse grid
-        cusp::multiply(levels[i].R, levels[i].residual, levels[i + 1].b);
+        if (implicit_restriction)
+            cusp::multiply_transpose(levels[i].P, levels[i].residual, levels[i + 1].b);
+        else if (!levels[i].R_op.empty())
+            levels[i].R_op(levels[i].residual, levels[i + 1].b);
+        else
+            cusp::multiply(levels[i].R, levels[i].residual, levels[i + 1].b);
+        T.restriction += timer.lap();
 
         // compute coarse grid solution
-        _solve(levels[i + 1].b, levels[i + 1].x, i + 1);
+        _coarse_correction(i + 1, level_cycle);
+
+        // the correction is timed on the coarser levels
+        timer.lap();
 
         // apply coarse grid correction
-        cusp::multiply(levels[i].P, levels[i + 1].x, levels[i].residual);
+        if (levels[i].P_op.empty())
+            cusp::multiply(levels[i].P, levels[i + 1].x, levels[i].residual);
+        else
+            levels[i].P_op(levels[i + 1].x, levels[i].residual);
         cusp::blas::axpy(levels[i].residual, x, ValueType(1.0));
+        T.prolongation += timer.lap();
 
         // postsmooth
-        /* levels[i].smoother.postsmooth(A, b, x); */
-        levels[i].smoother.postsmooth(levels[i].A, b, x);
+        for (size_t k = 0; k < postsmooth_sweeps; k++)
+            levels[i].smoother.postsmooth(A, b, x);
+        T.postsmooth += timer.lap();
     }
 }
 
-template <typename MatrixType, typename SmootherType, typename SolverType>
-void multilevel<MatrixType,SmootherType,SolverType>
+template <typename MatrixType, typename SmootherType, typename SolverType, typename ValueType>
+void multilevel<MatrixType,SmootherType,SolverType,ValueType>
+::_coarse_correction(const size_t i, const cycle_type level_cycle)
+{
+    // continue the cycle on the host copy of the coarse levels
+    if (host_levels != NULL && i == host_level_begin)
+    {
+        host_hierarchy& H = *host_levels;
+
+        H.presmooth_sweeps  = presmooth_sweeps;
+        H.postsmooth_sweeps = postsmooth_sweeps;
+
+        cusp::copy(levels[i].b, H.levels[0].b);
+        H._coarse_correction(0, level_cycle);
+        cusp::copy(H.levels[0].x, levels[i].x);
+        return;
+    }
+
+    // the coarsest level is solved directly and needs no further corrections
+    if (i + 1 == levels.size())
+    {
+        _solve(levels[i].b, levels[i].x, i, level_cycle);
+        return;
+    }
+
+    switch (level_cycle)
+    {
+        case W_CYCLE:
+            _solve(levels[i].b, levels[i].x, i, W_CYCLE);
+            _correct(i, W_CYCLE);
+            break;
+        case F_CYCLE:
+            _solve(levels[i].b, levels[i].x, i, F_CYCLE);
+            _correct(i, V_CYCLE);
+            break;
+        case K_CYCLE:
+            _k_cycle(i);
+            break;
+        default:
+            _solve(levels[i].b, levels[i].x, i, V_CYCLE);
+    }
+}
+
+template <typename MatrixType, typename SmootherType, typename SolverType, typename ValueType>
+void multilevel<MatrixType,SmootherType,SolverType,ValueType>
+::_correct(const size_t i, const cycle_type level_cycle)
+{
+    CUSP_PROFILE_SCOPED();
+
+    level& L = levels[i];
+
+    L.cycle_b.resize(L.A.num_rows, cusp::uninitialized);
+    L.cycle_x.resize(L.A.num_rows, cusp::uninitialized);
+
+    // r <- b - A*x
+    _level_residual(i, L.x, L.b, L.cycle_b);
+
+    // x <- x + M * r
+    _solve(L.cycle_b, L.cycle_x, i, level_cycle);
+    cusp::blas::axpy(L.cycle_x, L.x, ValueType(1.0));
+}
+
+template <typename MatrixType, typename SmootherType, typename SolverType, typename ValueType>
+void multilevel<MatrixType,SmootherType,SolverType,ValueType>
+::_k_cycle(const size_t i)
+{
+    CUSP_PROFILE_SCOPED();
+
+    // the second step is skipped once the residual dropped by this factor
+    const ValueType tolerance(0.25);
+
+    level& L = levels[i];
+
+    L.cycle_b.resize(L.A.num_rows, cusp::uninitialized);
+    L.cycle_x.resize(L.A.num_rows, cusp::uninitialized);
+    L.cycle_Ax.resize(L.A.num_rows, cusp::uninitialized);
+
+    // names follow flexible CG: c1 = L.x, v1 = L.cycle_Ax, r1 = L.cycle_b, c2 = L.cycle_x
+
+    // c1 <- M * b, v1 <- A * c1
+    _solve(L.b, L.x, i, K_CYCLE);
+    _level_multiply(i, L.x, L.cycle_Ax);
+
+    const ValueType rho1   = cusp::blas::dot(L.x, L.cycle_Ax);
+    const ValueType alpha1 = cusp::blas::dot(L.x, L.b);
+
+    if (rho1 == ValueType(0))
+        return;
+
+    // r1 <- b - (alpha1 / rho1) v1
+    cusp::blas::axpby(L.b, L.cycle_Ax, L.cycle_b, ValueType(1.0), -alpha1 / rho1);
+
+    if (cusp::blas::nrm2(L.cycle_b) <= tolerance * cusp::blas::nrm2(L.b))
+    {
+        cusp::blas::scal(L.x, alpha1 / rho1);
+        return;
+    }
+
+    // c2 <- M * r1
+    _solve(L.cycle_b, L.cycle_x, i, K_CYCLE);
+
+    const ValueType alpha2 = cusp::blas::dot(L.cycle_x, L.cycle_b);
+    const ValueType gamma  = cusp::blas::dot(L.cycle_x, L.cycle_Ax);
+
+    // v2 <- A * c2 overwrites r1, which is no longer needed
+    _level_multiply(i, L.cycle_x, L.cycle_b);
+
+    const ValueType beta = cusp::blas::dot(L.cycle_x, L.cycle_b);
+    const ValueType rho2 = beta - gamma * gamma / rho1;
+
+    if (rho2 == ValueType(0))
+    {
+        cusp::blas::scal(L.x, alpha1 / rho1);
+        return;
+    }
+
+    // x <- (alpha1 / rho1) c1 + (alpha2 / rho2) (c2 - (gamma / rho1) c1)
+    cusp::blas::axpby(L.x, L.cycle_x, L.x,
+                      alpha1 / rho1 - (alpha2 / rho2) * (gamma / rho1),
+                      alpha2 / rho2);
+}
+
+template <typename MatrixType, typename SmootherType, typename SolverType, typename ValueType>
+void multilevel<MatrixType,SmootherType,SolverType,ValueType>
 ::print( void )
 {
     size_t num_levels = levels.size();
@@ -142,6 +881,15 @@ void multilevel<MatrixType,SmootherType,SolverType>
     std::cout << "\tNumber of Levels:\t" << num_levels << std::endl;
     std::cout << "\tOperator Complexity:\t" << operator_complexity() << std::endl;
     std::cout << "\tGrid Complexity:\t" << grid_complexity() << std::endl;
+    if (host_levels != NULL)
+        std::cout << "\tHost Levels:\t\t" << host_level_begin << " to " << num_levels - 1 << std::endl;
+    if (profiling)
+    {
+        std::cout << "\tlevel\tvisits\ttime [ms]:" << std::endl;
+        for(size_t index = 0; index < num_levels; index++)
+            std::cout << "\t" << index << "\t" << _level_timings(index).visits \
+                      << "\t" << _level_timings(index).total() << std::endl;
+    }
     std::cout << "\tlevel\tunknowns\tnonzeros:\t" << std::endl;
 
     double nnz = 0;
@@ -158,8 +906,8 @@ void multilevel<MatrixType,SmootherType,SolverType>
     }
 }
 
-template <typename MatrixType, typename SmootherType, typename SolverType>
-double multilevel<MatrixType,SmootherType,SolverType>
+template <typename MatrixType, typename SmootherType, typename SolverType, typename ValueType>
+double multilevel<MatrixType,SmootherType,SolverType,ValueType>
 ::operator_complexity( void )
 {
     size_t nnz = 0;
@@ -170,8 +918,8 @@ double multilevel<MatrixType,SmootherType,SolverType>
     return (double) nnz / (double) levels[0].A.num_entries;
 }
 
-template <typename MatrixType, typename SmootherType, typename SolverType>
-double multilevel<MatrixType,SmootherType,SolverType>
+template <typename MatrixType, typename SmootherType, typename SolverType, typename ValueType>
+double multilevel<MatrixType,SmootherType,SolverType,ValueType>
 ::grid_complexity( void )
 {
     size_t unknowns = 0;
@@ -16,7 +16,17 @@
 
 #include <cusp/detail/dispatch/multiply.h>
 
+#include <cusp/array1d.h>
+#include <cusp/blas.h>
+#include <cusp/exception.h>
+#include <cusp/format.h>
 #include <cusp/linear_operator.h>
+#include <cusp/managed_memory.h>
+#include <cusp/reduction.h>
+#include <cusp/detail/functional.h>
+#include <cusp/detail/fused_dot_operator.h>
+#include <cusp/detail/work_estimate.h>
+#include <thrust/functional.h>
 #include <thrust/detail/type_traits.h>
 
 namespace cusp
@@ -51,6 +61,238 @@ void multiply(LinearOperator&  A,
                                    typename MatrixOrVector2::memory_space());
 }
 
+template <typename LinearOperator,
+          typename Vector1,
+          typename Vector2>
+void multiply_transpose(const LinearOperator& A,
+                        const Vector1& x,
+                              Vector2& y,
+                        cusp::unknown_format)
+{
+  throw cusp::not_implemented_exception("a user-defined linear_operator cannot be applied transposed");
+}
+
+template <typename LinearOperator,
+          typename Vector1,
+          typename Vector2>
+void multiply_transpose(const LinearOperator& A,
+                        const Vector1& x,
+                              Vector2& y,
+                        cusp::known_format)
+{
+  cusp::multiply_transpose(A, x, y);
+}
+
+// combine of generalized_multiply for alpha * A(i,j) * x[j]
+template <typename ValueType>
+struct scaled_multiplies : public thrust::binary_function<ValueType,ValueType,ValueType>
+{
+    ValueType alpha;
+
+    scaled_multiplies(ValueType alpha)
+        : alpha(alpha) {}
+
+    __host__ __device__
+    ValueType operator()(const ValueType& a, const ValueType& x) const
+    {
+        return alpha * (a * x);
+    }
+};
+
+// initialize of generalized_multiply for beta * y[i], which does not read
+// y[i] when beta is zero so that y may hold anything, even NaN
+template <typename ValueType>
+struct scaled_identity : public thrust::unary_function<ValueType,ValueType>
+{
+    ValueType beta;
+
+    scaled_identity(ValueType beta)
+        : beta(beta) {}
+
+    __host__ __device__
+    ValueType operator()(const ValueType& y) const
+    {
+        return beta == ValueType(0) ? ValueType(0) : beta * y;
+    }
+};
+
+// formats with kernels of their own for generalized_multiply, the device
+// converts the other formats to CSR first
+template <typename Format, typename MemorySpace> struct fused_multiply_format                                  : public thrust::detail::false_type {};
+template <typename MemorySpace> struct fused_multiply_format<cusp::coo_format,MemorySpace>         : public thrust::detail::true_type {};
+template <typename MemorySpace> struct fused_multiply_format<cusp::csr_format,MemorySpace>         : public thrust::detail::true_type {};
+template <typename MemorySpace> struct fused_multiply_format<cusp::dia_format,MemorySpace>         : public thrust::detail::true_type {};
+template <typename MemorySpace> struct fused_multiply_format<cusp::ell_format,MemorySpace>         : public thrust::detail::true_type {};
+template <typename MemorySpace> struct fused_multiply_format<cusp::hyb_format,MemorySpace>         : public thrust::detail::true_type {};
+template <>                     struct fused_multiply_format<cusp::sell_format,cusp::host_memory>  : public thrust::detail::true_type {};
+template <>                     struct fused_multiply_format<cusp::bsr_format,cusp::host_memory>   : public thrust::detail::true_type {};
+template <>                     struct fused_multiply_format<cusp::csr16_format,cusp::host_memory> : public thrust::detail::true_type {};
+
+template <typename Operator>
+struct fused_multiply
+  : public fused_multiply_format<typename Operator::format, typename Operator::memory_space> {};
+
+// y <- alpha * A * x + beta * y in a single pass over A and y
+template <typename LinearOperator,
+          typename Vector1,
+          typename Vector2,
+          typename ValueType>
+void multiply(const LinearOperator& A,
+              const Vector1& x,
+                    Vector2& y,
+              const ValueType alpha,
+              const ValueType beta,
+              thrust::detail::true_type)
+{
+  cusp::generalized_multiply(A, x, y,
+                             scaled_identity<ValueType>(beta),
+                             scaled_multiplies<ValueType>(alpha),
+                             thrust::plus<ValueType>());
+}
+
+// other formats and user-defined operators apply A first
+template <typename LinearOperator,
+          typename Vector1,
+          typename Vector2,
+          typename ValueType>
+void multiply(const LinearOperator& A,
+              const Vector1& x,
+                    Vector2& y,
+              const ValueType alpha,
+              const ValueType beta,
+              thrust::detail::false_type)
+{
+  if (beta == ValueType(0))
+  {
+    cusp::multiply(A, x, y);
+
+    if (alpha != ValueType(1))
+      cusp::blas::scal(y, alpha);
+  }
+  else
+  {
+    cusp::array1d<ValueType,typename Vector2::memory_space> Ax(y.size());
+    cusp::multiply(A, x, Ax);
+    cusp::blas::axpby(Ax, y, y, alpha, beta);
+  }
+}
+
+// formats with a kernel of their own for multiply_dot on the device
+template <typename Format> struct fused_dot_format                    : public thrust::detail::false_type {};
+template <>                struct fused_dot_format<cusp::csr_format> : public thrust::detail::true_type {};
+template <>                struct fused_dot_format<cusp::dia_format> : public thrust::detail::true_type {};
+template <>                struct fused_dot_format<cusp::ell_format> : public thrust::detail::true_type {};
+template <>                struct fused_dot_format<cusp::hyb_format> : public thrust::detail::true_type {};
+
+template <typename Matrix, typename Vector1, typename Vector2>
+struct fused_dot
+  : public thrust::detail::integral_constant<bool,
+             fused_dot_format<typename Matrix::format>::value &&
+             cusp::detail::is_device_space<typename Matrix::memory_space>::value &&
+             cusp::detail::is_device_space<typename Vector1::memory_space>::value &&
+             cusp::detail::is_device_space<typename Vector2::memory_space>::value &&
+             thrust::detail::is_same<typename Vector1::value_type, typename Vector2::value_type>::value> {};
+
+template <typename LinearOperator,
+          typename Vector1,
+          typename Vector2>
+typename Vector2::value_type
+multiply_dot(const LinearOperator& A,
+             const Vector1& x,
+                   Vector2& y,
+             thrust::detail::true_type)
+{
+  return cusp::detail::dispatch::multiply_dot(A, x, y,
+                                              typename LinearOperator::memory_space(),
+                                              typename Vector1::memory_space(),
+                                              typename Vector2::memory_space());
+}
+
+template <typename LinearOperator,
+          typename Vector1,
+          typename Vector2>
+typename Vector2::value_type
+multiply_dot(const LinearOperator& A,
+             const Vector1& x,
+                   Vector2& y,
+             thrust::detail::false_type)
+{
+  cusp::multiply(A, x, y);
+  return cusp::blas::dotc(y, x);
+}
+
+// operators with a fused kernel of their own
+template <typename LinearOperator,
+          typename Vector1,
+          typename Vector2>
+typename Vector2::value_type
+operator_multiply_dot(const LinearOperator& A,
+                      const Vector1& x,
+                            Vector2& y,
+                      thrust::detail::true_type)
+{
+  return cusp::detail::fused_dot_operator<LinearOperator>::multiply_dot(A, x, y);
+}
+
+template <typename LinearOperator,
+          typename Vector1,
+          typename Vector2>
+typename Vector2::value_type
+operator_multiply_dot(const LinearOperator& A,
+                      const Vector1& x,
+                            Vector2& y,
+                      thrust::detail::false_type)
+{
+  return cusp::detail::multiply_dot(A, x, y,
+                                    typename cusp::detail::fused_dot<LinearOperator,Vector1,Vector2>::type());
+}
+
+// r <- b - A * x, the residual of the solvers and smoothers
+template <typename LinearOperator,
+          typename Vector1,
+          typename Vector2,
+          typename Vector3>
+void residual(const LinearOperator& A,
+              const Vector1& x,
+              const Vector2& b,
+                    Vector3& r,
+              thrust::detail::true_type)
+{
+  typedef typename Vector3::value_type ValueType;
+
+  cusp::blas::copy(b, r);
+  cusp::multiply(A, x, r, ValueType(-1), ValueType(1));
+}
+
+// without a fused kernel the product is formed in r, which needs no temporary
+template <typename LinearOperator,
+          typename Vector1,
+          typename Vector2,
+          typename Vector3>
+void residual(const LinearOperator& A,
+              const Vector1& x,
+              const Vector2& b,
+                    Vector3& r,
+              thrust::detail::false_type)
+{
+  typedef typename Vector3::value_type ValueType;
+
+  cusp::multiply(A, x, r);
+  cusp::blas::axpby(b, r, r, ValueType(1), ValueType(-1));
+}
+
+template <typename LinearOperator,
+          typename Vector1,
+          typename Vector2,
+          typename Vector3>
+void residual(const LinearOperator& A,
+              const Vector1& x,
+              const Vector2& b,
+                    Vector3& r)
+{
+  residual(A, x, b, r, typename fused_multiply<LinearOperator>::type());
+}
+
 } // end namespace detail
 
 template <typename LinearOperator,
@@ -61,6 +303,9 @@ void multiply(LinearOperator&  A,
               MatrixOrVector2& C)
 {
   CUSP_PROFILE_SCOPED();
+  CUSP_PROFILE_WORK(cusp::detail::multiply_bytes(A, B, C), cusp::detail::multiply_flops(A, B));
+
+  cusp::detail::prefetch_operands(A, B, C);
 
   // TODO check that dimensions are compatible
 
@@ -79,6 +324,9 @@ void multiply(const LinearOperator&  A,
               const MatrixOrVector2& C)
 {
   CUSP_PROFILE_SCOPED();
+  CUSP_PROFILE_WORK(cusp::detail::multiply_bytes(A, B, C), cusp::detail::multiply_flops(A, B));
+
+  cusp::detail::prefetch_operands(A, B, C);
 
   // TODO check that dimensions are compatible
 
@@ -89,5 +337,198 @@ void multiply(const LinearOperator&  A,
                          typename LinearOperator::format());
 }
 
+template <typename Matrix,
+          typename Vector1,
+          typename Vector2,
+          typename UnaryFunction,
+          typename BinaryFunction1,
+          typename BinaryFunction2>
+void generalized_multiply(const Matrix&  A,
+                          const Vector1& x,
+                                Vector2& y,
+                          UnaryFunction   initialize,
+                          BinaryFunction1 combine,
+                          BinaryFunction2 reduce)
+{
+  CUSP_PROFILE_SCOPED();
+  CUSP_PROFILE_WORK(cusp::detail::multiply_bytes(A, x, y), cusp::detail::multiply_flops(A, x));
+
+  if (x.size() != A.num_cols || y.size() != A.num_rows)
+    throw cusp::invalid_input_exception("array dimensions do not match the matrix");
+
+  cusp::detail::prefetch_operands(A, x, y);
+
+  cusp::detail::dispatch::generalized_multiply(A, x, y, initialize, combine, reduce,
+                                               typename Matrix::memory_space(),
+                                               typename Vector1::memory_space(),
+                                               typename Vector2::memory_space());
+}
+
+template <typename Matrix,
+          typename Vector1,
+          typename Vector2,
+          typename Vector3,
+          typename UnaryFunction,
+          typename BinaryFunction1,
+          typename BinaryFunction2>
+void masked_multiply(const Matrix&  A,
+                     const Vector1& x,
+                     const Vector2& mask,
+                           Vector3& y,
+                     UnaryFunction   initialize,
+                     BinaryFunction1 combine,
+                     BinaryFunction2 reduce)
+{
+  CUSP_PROFILE_SCOPED();
+
+  if (x.size() != A.num_cols || mask.size() != A.num_rows || y.size() != A.num_rows)
+    throw cusp::invalid_input_exception("array dimensions do not match the matrix");
+
+  cusp::detail::dispatch::masked_multiply(A, x, mask, y, initialize, combine, reduce,
+                                          typename Matrix::memory_space(),
+                                          typename Vector1::memory_space(),
+                                          typename Vector2::memory_space(),
+                                          typename Vector3::memory_space());
+}
+
+template <typename Matrix,
+          typename Vector1,
+          typename Vector2,
+          typename Vector3>
+void masked_multiply(const Matrix&  A,
+                     const Vector1& x,
+                     const Vector2& mask,
+                           Vector3& y)
+{
+  typedef typename Vector3::value_type ValueType;
+
+  cusp::masked_multiply(A, x, mask, y,
+                        cusp::detail::zero_function<ValueType>(),
+                        thrust::multiplies<ValueType>(),
+                        thrust::plus<ValueType>());
+}
+
+template <typename Matrix,
+          typename Vector1,
+          typename Vector2>
+void multiply_transpose(const Matrix&  A,
+                        const Vector1& x,
+                              Vector2& y)
+{
+  CUSP_PROFILE_SCOPED();
+  CUSP_PROFILE_WORK(cusp::detail::multiply_bytes(A, x, y), cusp::detail::multiply_flops(A, x));
+
+  if (x.size() != A.num_rows || y.size() != A.num_cols)
+    throw cusp::invalid_input_exception("array dimensions do not match the matrix");
+
+  cusp::detail::dispatch::multiply_transpose(A, x, y,
+                                             typename Matrix::memory_space(),
+                                             typename Vector1::memory_space(),
+                                             typename Vector2::memory_space());
+}
+
+template <typename LinearOperator,
+          typename Vector1,
+          typename Vector2>
+void multiply(const LinearOperator& A,
+              const Vector1& x,
+                    Vector2& y,
+              const bool transpose)
+{
+  if (transpose)
+    cusp::detail::multiply_transpose(A, x, y, typename LinearOperator::format());
+  else
+    cusp::multiply(A, x, y);
+}
+
+template <typename LinearOperator,
+          typename Vector1,
+          typename Vector2,
+          typename ScalarType1,
+          typename ScalarType2>
+void multiply(const LinearOperator& A,
+              const Vector1& x,
+                    Vector2& y,
+              const ScalarType1 alpha,
+              const ScalarType2 beta)
+{
+  typedef typename Vector2::value_type ValueType;
+
+  if (x.size() != A.num_cols || y.size() != A.num_rows)
+    throw cusp::invalid_input_exception("array dimensions do not match the matrix");
+
+  cusp::detail::multiply(A, x, y, ValueType(alpha), ValueType(beta),
+                         typename cusp::detail::fused_multiply<LinearOperator>::type());
+}
+
+template <typename LinearOperator,
+          typename Vector1,
+          typename Vector2>
+typename Vector2::value_type
+multiply_dot(const LinearOperator& A,
+             const Vector1& x,
+                   Vector2& y)
+{
+  CUSP_PROFILE_SCOPED();
+
+  if (A.num_rows != A.num_cols)
+    throw cusp::invalid_input_exception("multiply_dot requires a square matrix");
+
+  if (x.size() != A.num_cols || y.size() != A.num_rows)
+    throw cusp::invalid_input_exception("array dimensions do not match the matrix");
+
+  cusp::detail::prefetch_operands(A, x, y);
+
+  // the other reduction modes order or compensate the sum themselves
+  if (cusp::current_reduction_mode() != cusp::fast_reduction)
+    return cusp::detail::multiply_dot(A, x, y, thrust::detail::false_type());
+
+  return cusp::detail::operator_multiply_dot(A, x, y,
+                                             typename cusp::detail::fused_dot_operator<LinearOperator>::type());
+}
+
+template <typename Matrix1,
+          typename Matrix2,
+          typename Matrix3,
+          typename Matrix4>
+void galerkin_product(const Matrix1& R,
+                      const Matrix2& A,
+                      const Matrix3& P,
+                            Matrix4& RAP)
+{
+  CUSP_PROFILE_SCOPED();
+
+  if (R.num_cols != A.num_rows || A.num_cols != P.num_rows)
+    throw cusp::invalid_input_exception("matrix dimensions do not match");
+
+  cusp::detail::dispatch::galerkin_product(R, A, P, RAP,
+                                           typename Matrix1::memory_space(),
+                                           typename Matrix2::memory_space(),
+                                           typename Matrix3::memory_space(),
+                                           typename Matrix4::memory_space());
+}
+
+
+template <typename Matrix1,
+          typename Matrix2,
+          typename Matrix3,
+          typename Matrix4>
+void masked_product(const Matrix1& A,
+                    const Matrix2& B,
+                    const Matrix3& M,
+                          Matrix4& C)
+{
+  CUSP_PROFILE_SCOPED();
+
+  if (A.num_cols != B.num_rows || M.num_rows != A.num_rows || M.num_cols != B.num_cols)
+    throw cusp::invalid_input_exception("matrix dimensions do not match");
+
+  cusp::detail::dispatch::masked_product(A, B, M, C,
+                                         typename Matrix1::memory_space(),
+                                         typename Matrix2::memory_space(),
+                                         typename Matrix3::memory_space(),
+                                         typename Matrix4::memory_space());
+}
+
 } // end namespace cusp
 
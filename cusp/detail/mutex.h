@@ -0,0 +1,87 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+#pragma once
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+// Synchronization of the state which Cusp keeps for all host threads (the
+// device allocation cache, the occupancy and device caches, the staging
+// buffers).  The state which selects how work is issued (the current
+// stream, the SpMV cache mode) is kept per thread instead, so that
+// independent solves issued from several host threads do not interfere.
+
+#if defined(_MSC_VER)
+#define __CUSP_THREAD_LOCAL __declspec(thread)
+#else
+#define __CUSP_THREAD_LOCAL __thread
+#endif
+
+namespace cusp
+{
+namespace detail
+{
+
+// A mutex which needs no constructor, so that one with static storage is
+// initialized before any thread can use it:
+//
+//   static cusp::detail::mutex lock = __CUSP_MUTEX_INITIALIZER;
+struct mutex
+{
+#if defined(_WIN32)
+    SRWLOCK handle;
+
+    void lock(void)     { AcquireSRWLockExclusive(&handle); }
+    bool try_lock(void) { return TryAcquireSRWLockExclusive(&handle) != 0; }
+    void unlock(void)   { ReleaseSRWLockExclusive(&handle); }
+#else
+    pthread_mutex_t handle;
+
+    void lock(void)     { pthread_mutex_lock(&handle); }
+    bool try_lock(void) { return pthread_mutex_trylock(&handle) == 0; }
+    void unlock(void)   { pthread_mutex_unlock(&handle); }
+#endif
+};
+
+#if defined(_WIN32)
+#define __CUSP_MUTEX_INITIALIZER { SRWLOCK_INIT }
+#else
+#define __CUSP_MUTEX_INITIALIZER { PTHREAD_MUTEX_INITIALIZER }
+#endif
+
+// holds a mutex for the lifetime of the object
+class scoped_lock
+{
+    public:
+    explicit scoped_lock(cusp::detail::mutex& m) : m(m) { m.lock(); }
+
+    ~scoped_lock(void) { m.unlock(); }
+
+    private:
+    cusp::detail::mutex& m;
+
+    // non-copyable
+    scoped_lock(const scoped_lock&);
+    scoped_lock& operator=(const scoped_lock&);
+};
+
+} // end namespace detail
+} // end namespace cusp
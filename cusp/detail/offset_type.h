@@ -0,0 +1,59 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+#pragma once
+
+#include <cusp/format.h>
+
+#include <limits>
+
+namespace cusp
+{
+namespace detail
+{
+
+// Type of the positions of the entries of a matrix.  A CSR matrix may
+// store its row offsets in a wider type than its column indices (e.g. a
+// csr_matrix_view of 64-bit row offsets and 32-bit column indices, for more
+// than 2^31 entries without doubling the column index traffic), so the
+// loops over the entries of a row use the value type of the row offsets.
+// Other formats address their entries with their index type.
+template <typename Matrix, typename Format = typename Matrix::format>
+struct offset_type
+{
+    typedef typename Matrix::index_type type;
+};
+
+template <typename Matrix>
+struct offset_type<Matrix, cusp::csr_format>
+{
+    typedef typename Matrix::row_offsets_array_type::value_type type;
+};
+
+// positions of the entries of matrices whose storage exceeds the range of
+// their index type
+typedef long long wide_offset_type;
+
+// whether the positions [0, n) are representable in IndexType
+template <typename IndexType>
+bool offsets_fit(const size_t n)
+{
+    return n <= size_t(std::numeric_limits<IndexType>::max());
+}
+
+} // end namespace detail
+} // end namespace cusp
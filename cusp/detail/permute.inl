@@ -0,0 +1,277 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include <cusp/array1d.h>
+#include <cusp/csr_matrix.h>
+#include <cusp/exception.h>
+#include <cusp/format.h>
+#include <cusp/detail/format_utils.h>
+#include <cusp/detail/stream.h>
+
+#include <thrust/fill.h>
+#include <thrust/scan.h>
+#include <thrust/scatter.h>
+#include <thrust/transform.h>
+#include <thrust/iterator/counting_iterator.h>
+
+namespace cusp
+{
+namespace detail
+{
+
+// number of entries of row rows[i] of A
+template <typename IndexType>
+struct permute_row_length
+{
+    const IndexType * Ap;
+
+    permute_row_length(const IndexType * Ap) : Ap(Ap) {}
+
+    __host__ __device__
+    IndexType operator()(const IndexType r) const
+    {
+        return Ap[r + 1] - Ap[r];
+    }
+};
+
+// number of entries of row rows[i] of A in a mapped column
+template <typename IndexType>
+struct permute_count_row
+{
+    const IndexType * Ap;
+    const IndexType * Aj;
+    const IndexType * column_map;
+
+    permute_count_row(const IndexType * Ap, const IndexType * Aj, const IndexType * column_map)
+        : Ap(Ap), Aj(Aj), column_map(column_map) {}
+
+    __host__ __device__
+    IndexType operator()(const IndexType r) const
+    {
+        IndexType count = 0;
+
+        for(IndexType k = Ap[r]; k < Ap[r + 1]; k++)
+            if(column_map[Aj[k]] >= 0)
+                count++;
+
+        return count;
+    }
+};
+
+// copies row rows[i] of A into row i of B, renumbering its columns
+template <typename IndexType, typename ValueType>
+struct permute_copy_row
+{
+    const IndexType * Ap;
+    const IndexType * Aj;
+    const ValueType * Ax;
+    const IndexType * rows;
+    const IndexType * column_map;
+    const IndexType * Bp;
+    IndexType * Bj;
+    ValueType * Bx;
+
+    permute_copy_row(const IndexType * Ap, const IndexType * Aj, const ValueType * Ax,
+                     const IndexType * rows, const IndexType * column_map,
+                     const IndexType * Bp, IndexType * Bj, ValueType * Bx)
+        : Ap(Ap), Aj(Aj), Ax(Ax), rows(rows), column_map(column_map),
+          Bp(Bp), Bj(Bj), Bx(Bx) {}
+
+    __host__ __device__
+    void operator()(const IndexType i) const
+    {
+        const IndexType r = rows[i];
+
+        IndexType n = Bp[i];
+
+        for(IndexType k = Ap[r]; k < Ap[r + 1]; k++)
+        {
+            const IndexType j = column_map[Aj[k]];
+
+            if(j < 0)
+                continue;
+
+            Bj[n] = j;
+            Bx[n] = Ax[k];
+            n++;
+        }
+    }
+};
+
+// B = A(rows, :) with the columns renumbered by column_map, whose negative
+// entries drop a column, all_columns meaning that none is dropped
+template <typename MatrixType, typename ArrayType, typename IndexType, typename ValueType, typename MemorySpace>
+void permute_rows(const MatrixType& A, const ArrayType& rows,
+                  const cusp::array1d<IndexType,MemorySpace>& column_map,
+                  const size_t num_cols, const bool all_columns,
+                  cusp::csr_matrix<IndexType,ValueType,MemorySpace>& B)
+{
+    typedef thrust::counting_iterator<IndexType,MemorySpace> CountingIterator;
+
+    const size_t N = rows.size();
+
+    cusp::array1d<IndexType,MemorySpace> offsets(N + 1);
+
+    if(all_columns)
+        thrust::transform(rows.begin(), rows.end(), offsets.begin(),
+                          permute_row_length<IndexType>(thrust::raw_pointer_cast(&A.row_offsets[0])));
+    else
+        thrust::transform(rows.begin(), rows.end(), offsets.begin(),
+                          permute_count_row<IndexType>(thrust::raw_pointer_cast(&A.row_offsets[0]),
+                                                       A.num_entries == 0 ? NULL : thrust::raw_pointer_cast(&A.column_indices[0]),
+                                                       column_map.size() == 0 ? NULL : thrust::raw_pointer_cast(&column_map[0])));
+
+    offsets[N] = 0;
+    thrust::exclusive_scan(offsets.begin(), offsets.end(), offsets.begin());
+
+    B.resize(N, num_cols, offsets[N]);
+    B.row_offsets.swap(offsets);
+
+    if(B.num_entries == 0)
+        return;
+
+    cusp::detail::stream::for_each(CountingIterator(0), CountingIterator(N),
+                                   permute_copy_row<IndexType,ValueType>(thrust::raw_pointer_cast(&A.row_offsets[0]),
+                                                                         thrust::raw_pointer_cast(&A.column_indices[0]),
+                                                                         thrust::raw_pointer_cast(&A.values[0]),
+                                                                         thrust::raw_pointer_cast(&rows[0]),
+                                                                         thrust::raw_pointer_cast(&column_map[0]),
+                                                                         thrust::raw_pointer_cast(&B.row_offsets[0]),
+                                                                         thrust::raw_pointer_cast(&B.column_indices[0]),
+                                                                         thrust::raw_pointer_cast(&B.values[0])));
+
+    // renumbering the columns unsorts the rows
+    cusp::detail::sort_columns_by_row(B.row_offsets, B.column_indices, B.values);
+}
+
+template <typename IndexType, typename ValueType, typename MemorySpace, typename MatrixType>
+void permute_assign(cusp::csr_matrix<IndexType,ValueType,MemorySpace>& C, MatrixType& B)
+{
+    B = C;
+}
+
+template <typename IndexType, typename ValueType, typename MemorySpace>
+void permute_assign(cusp::csr_matrix<IndexType,ValueType,MemorySpace>& C,
+                    cusp::csr_matrix<IndexType,ValueType,MemorySpace>& B)
+{
+    B.swap(C);
+}
+
+template <typename MatrixType1, typename ArrayType, typename MatrixType2>
+void symmetric_permute(const MatrixType1& A, const ArrayType& permutation, MatrixType2& B, cusp::csr_format)
+{
+    typedef typename MatrixType1::index_type   IndexType;
+    typedef typename MatrixType1::value_type   ValueType;
+    typedef typename MatrixType1::memory_space MemorySpace;
+
+    const size_t N = A.num_rows;
+
+    cusp::array1d<IndexType,MemorySpace> rows(permutation);
+
+    // new index of each row
+    cusp::array1d<IndexType,MemorySpace> inverse(N);
+    thrust::scatter(thrust::counting_iterator<IndexType>(0), thrust::counting_iterator<IndexType>(N),
+                    rows.begin(), inverse.begin());
+
+    cusp::csr_matrix<IndexType,ValueType,MemorySpace> C;
+    cusp::detail::permute_rows(A, rows, inverse, N, true, C);
+
+    cusp::detail::permute_assign(C, B);
+}
+
+template <typename MatrixType1, typename ArrayType1, typename ArrayType2, typename MatrixType2>
+void extract_submatrix(const MatrixType1& A, const ArrayType1& rows, const ArrayType2& cols, MatrixType2& B,
+                       cusp::csr_format)
+{
+    typedef typename MatrixType1::index_type   IndexType;
+    typedef typename MatrixType1::value_type   ValueType;
+    typedef typename MatrixType1::memory_space MemorySpace;
+
+    cusp::array1d<IndexType,MemorySpace> rows_copy(rows);
+    cusp::array1d<IndexType,MemorySpace> cols_copy(cols);
+
+    // column of B of each column of A, -1 when not extracted
+    cusp::array1d<IndexType,MemorySpace> column_map(A.num_cols, IndexType(-1));
+    thrust::scatter(thrust::counting_iterator<IndexType>(0), thrust::counting_iterator<IndexType>(cols_copy.size()),
+                    cols_copy.begin(), column_map.begin());
+
+    cusp::csr_matrix<IndexType,ValueType,MemorySpace> C;
+    cusp::detail::permute_rows(A, rows_copy, column_map, cols_copy.size(), cols_copy.size() == A.num_cols, C);
+
+    cusp::detail::permute_assign(C, B);
+}
+
+//////////////////
+// General Path //
+//////////////////
+
+template <typename MatrixType1, typename ArrayType, typename MatrixType2, typename Format>
+void symmetric_permute(const MatrixType1& A, const ArrayType& permutation, MatrixType2& B, Format)
+{
+    typedef typename MatrixType1::index_type   IndexType;
+    typedef typename MatrixType1::value_type   ValueType;
+    typedef typename MatrixType1::memory_space MemorySpace;
+
+    cusp::csr_matrix<IndexType,ValueType,MemorySpace> A_csr(A);
+
+    cusp::detail::symmetric_permute(A_csr, permutation, B, cusp::csr_format());
+}
+
+template <typename MatrixType1, typename ArrayType1, typename ArrayType2, typename MatrixType2, typename Format>
+void extract_submatrix(const MatrixType1& A, const ArrayType1& rows, const ArrayType2& cols, MatrixType2& B,
+                       Format)
+{
+    typedef typename MatrixType1::index_type   IndexType;
+    typedef typename MatrixType1::value_type   ValueType;
+    typedef typename MatrixType1::memory_space MemorySpace;
+
+    cusp::csr_matrix<IndexType,ValueType,MemorySpace> A_csr(A);
+
+    cusp::detail::extract_submatrix(A_csr, rows, cols, B, cusp::csr_format());
+}
+
+} // end namespace detail
+
+/////////////////
+// Entry Point //
+/////////////////
+
+template <typename MatrixType1, typename ArrayType, typename MatrixType2>
+void symmetric_permute(const MatrixType1& A, const ArrayType& permutation, MatrixType2& B)
+{
+    CUSP_PROFILE_SCOPED();
+
+    if(A.num_rows != A.num_cols)
+        throw cusp::invalid_input_exception("matrix must be square");
+
+    if(permutation.size() != A.num_rows)
+        throw cusp::invalid_input_exception("permutation size does not match the matrix");
+
+    cusp::detail::symmetric_permute(A, permutation, B, typename MatrixType1::format());
+}
+
+template <typename MatrixType1, typename ArrayType1, typename ArrayType2, typename MatrixType2>
+void extract_submatrix(const MatrixType1& A, const ArrayType1& rows, const ArrayType2& cols, MatrixType2& B)
+{
+    CUSP_PROFILE_SCOPED();
+
+    if(cols.size() > A.num_cols)
+        throw cusp::invalid_input_exception("more columns than the matrix has");
+
+    cusp::detail::extract_submatrix(A, rows, cols, B, typename MatrixType1::format());
+}
+
+} // end namespace cusp
@@ -0,0 +1,143 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+#include <cusp/coo_matrix.h>
+#include <cusp/csr_matrix.h>
+#include <cusp/exception.h>
+#include <cusp/multiply.h>
+#include <cusp/permute.h>
+#include <cusp/graph/symmetric_rcm.h>
+
+#include <thrust/functional.h>
+#include <thrust/gather.h>
+#include <thrust/scatter.h>
+#include <thrust/sequence.h>
+#include <thrust/sort.h>
+#include <thrust/transform.h>
+#include <thrust/iterator/counting_iterator.h>
+
+namespace cusp
+{
+namespace detail
+{
+
+template <typename MatrixType, typename ArrayType>
+void degree_ordering(const MatrixType& A, ArrayType& permutation)
+{
+    typedef typename MatrixType::index_type   IndexType;
+    typedef typename MatrixType::value_type   ValueType;
+    typedef typename MatrixType::memory_space MemorySpace;
+
+    cusp::csr_matrix<IndexType,ValueType,MemorySpace> A_csr(A);
+
+    cusp::array1d<IndexType,MemorySpace> degrees(A.num_rows);
+    thrust::transform(A_csr.row_offsets.begin() + 1, A_csr.row_offsets.end(), A_csr.row_offsets.begin(),
+                      degrees.begin(), thrust::minus<IndexType>());
+
+    permutation.resize(A.num_rows);
+    thrust::sequence(permutation.begin(), permutation.end());
+    thrust::stable_sort_by_key(degrees.begin(), degrees.end(), permutation.begin());
+}
+
+} // end namespace detail
+
+template <typename MatrixType>
+template <typename MatrixType2>
+permuted_matrix<MatrixType>
+  ::permuted_matrix(const MatrixType2& A, reordering_method method)
+    : Parent(A.num_rows, A.num_cols, A.num_entries)
+{
+    if(A.num_rows != A.num_cols)
+        throw cusp::invalid_input_exception("matrix must be square");
+
+    // compute the ordering in the memory space of A
+    cusp::array1d<typename MatrixType2::index_type, typename MatrixType2::memory_space> P(A.num_rows);
+
+    switch(method)
+    {
+      case reorder_rcm:
+        cusp::graph::symmetric_rcm(A, P); break;
+      case reorder_degree:
+        cusp::detail::degree_ordering(A, P); break;
+      default:
+        throw cusp::invalid_input_exception("unrecognized reordering method");
+    }
+
+    permutation = P;
+
+    reorder(A);
+}
+
+template <typename MatrixType>
+template <typename MatrixType2, typename ArrayType>
+permuted_matrix<MatrixType>
+  ::permuted_matrix(const MatrixType2& A, const ArrayType& permutation)
+    : Parent(A.num_rows, A.num_cols, A.num_entries), permutation(permutation)
+{
+    if(A.num_rows != A.num_cols)
+        throw cusp::invalid_input_exception("matrix must be square");
+
+    if(permutation.size() != A.num_rows)
+        throw cusp::invalid_input_exception("permutation size does not match the matrix");
+
+    reorder(A);
+}
+
+template <typename MatrixType>
+template <typename MatrixType2>
+void permuted_matrix<MatrixType>
+  ::reorder(const MatrixType2& A)
+{
+    cusp::symmetric_permute(A, permutation, matrix);
+}
+
+template <typename MatrixType>
+template <typename VectorType1, typename VectorType2>
+void permuted_matrix<MatrixType>
+  ::permute(const VectorType1& x, VectorType2& x_new) const
+{
+    if(x.size() != permutation.size() || x_new.size() != permutation.size())
+        throw cusp::invalid_input_exception("array dimensions do not match the matrix");
+
+    thrust::gather(permutation.begin(), permutation.end(), x.begin(), x_new.begin());
+}
+
+template <typename MatrixType>
+template <typename VectorType1, typename VectorType2>
+void permuted_matrix<MatrixType>
+  ::unpermute(const VectorType1& x_new, VectorType2& x) const
+{
+    if(x.size() != permutation.size() || x_new.size() != permutation.size())
+        throw cusp::invalid_input_exception("array dimensions do not match the matrix");
+
+    thrust::scatter(x_new.begin(), x_new.end(), permutation.begin(), x.begin());
+}
+
+template <typename MatrixType>
+template <typename VectorType1, typename VectorType2>
+void permuted_matrix<MatrixType>
+  ::operator()(const VectorType1& x, VectorType2& y) const
+{
+    x_work.resize(permutation.size());
+    y_work.resize(permutation.size());
+
+    permute(x, x_work);
+    cusp::multiply(matrix, x_work, y_work);
+    unpermute(y_work, y);
+}
+
+} // end namespace cusp
@@ -33,6 +33,7 @@
 #endif
 
 #include <time.h>
+#include <cusp/detail/mutex.h>
 #include <cusp/detail/timer.h>
 
 #if defined(__ICC) || defined(__ICL)
@@ -46,7 +47,7 @@
         #define YIELD() Sleep(0);
         #define PRINTFU64() "%I64u"
         #define PATHSLASH() '\\'
-        #define threadlocal __declspec(thread)
+        #define threadlocal __CUSP_THREAD_LOCAL
         #define snprintf _snprintf
 
         #undef inline
@@ -58,12 +59,7 @@
         #define PRINTFU64() "%lu"
         #define pathslash() '/'
         #define PATHSLASH() '/'
-        #define threadlocal __thread
-#endif
-
-#if !defined(__PROFILER_SMP__)
-        #undef threadlocal
-        #define threadlocal
+        #define threadlocal __CUSP_THREAD_LOCAL
 #endif
 
 namespace cusp
@@ -102,16 +98,6 @@ namespace profiler
         #undef min
         #undef max
 
-	struct CASLock {
-		void Acquire() {}
-		void Release() {}
-		bool TryAcquire() { return false; }
-		bool TryRelease() { return false; }
-		size_t Value() const { return 0; }
-		size_t dummy;
-	};
-
-
         template< class T >
         inline const T& min( const T& a, const T& b ) {
                 return ( a < b ) ? a : b;
@@ -253,15 +239,14 @@ namespace profiler
 
                 } maxStats;
 
-                // per thread state
+                // per thread state, held by dump() while it reads the thread's callers
                 struct ThreadState 
 		{
-                        CASLock threadLock;
-                        bool requireThreadLock;
+                        cusp::detail::mutex threadLock;
                         Caller *activeCaller;
                 };
                
-                static threadlocal ThreadState thisThread;
+                static threadlocal ThreadState *thisThread;
 
                 struct foreach 
 		{
@@ -665,7 +650,7 @@ namespace profiler
 
 
 	#if defined(__PROFILER_ENABLED__)
-        threadlocal Caller::ThreadState Caller::thisThread = { {0}, 0, 0 };
+        threadlocal Caller::ThreadState *Caller::thisThread = NULL;
         double Caller::mTimerOverhead = 0.0;
         double Caller::mGlobalDuration = 0.0;
         Caller::Max Caller::maxStats;
@@ -713,7 +698,8 @@ namespace profiler
 
         /*
         ============
-        Root - Holds the root caller and the thread state for a thread
+        Root - Holds the root caller and the thread state for a thread.  Both
+        outlive the thread, so dump() can still read them after it exits.
         ============
         */
 
@@ -730,30 +716,32 @@ namespace profiler
                         if ( list ) {
                                 Buffer<Root> &threadsref = *list;
                                 size_t cnt = threadsref.Size();
-                                for ( size_t i = 0; i < cnt; i++ )
+                                for ( size_t i = 0; i < cnt; i++ ) {
                                         delete threadsref[i].root;
+                                        delete threadsref[i].threadState;
+                                }
                         }
                         delete list;
                 }
 
                 void AcquireGlobalLock() 
 		{
-                        threadsLock.Acquire();
+                        threadsLock.lock();
                         if ( !list )
                                 list = new Buffer<Root>;
                 }
 
                 void ReleaseGlobalLock() 
 		{
-                        threadsLock.Release();
+                        threadsLock.unlock();
                 }
 
                 Buffer<Root> *list;
-                CASLock threadsLock;
+                cusp::detail::mutex threadsLock;
         };
 
         cudaEvent_t globalStart;
-        GlobalThreadList threads = { NULL, {0} };
+        GlobalThreadList threads = { NULL, __CUSP_MUTEX_INITIALIZER };
         threadlocal Caller *root = NULL;
        
 
@@ -805,6 +793,8 @@ namespace profiler
                 dumper.Init();
                 dumper.GlobalInfo( rawDuration );
 
+                // held until the end so that concurrent dumps do not share the
+                // formatter and the max stats
                 threads.AcquireGlobalLock();    
 
                 // crawl the list of theads and store their data in to packer
@@ -812,12 +802,10 @@ namespace profiler
                 for ( size_t i = 0; i < threadsref.Size(); i++ ) {
                         Root &thread = threadsref[i];
 
-                        // if the thread is no longer active, the lock won't be valid
-                        bool active = ( thread.root->IsActive() );
-                        if ( active ) {
-                                thread.threadState->threadLock.Acquire();
-                                // disable requiring our local lock in case the caller is in our thread, accumulate will try to set it otherwise
-                                Caller::thisThread.requireThreadLock = false;
+                        // the thread cannot enter or leave a caller while it is copied
+                        thread.threadState->threadLock.lock();
+
+                        if ( thread.root->IsActive() ) {
                                 for ( Caller *walk = thread.threadState->activeCaller; walk; walk = walk->GetParent() )
                                         walk->GetTimer().soft_stop();
                         }
@@ -829,15 +817,9 @@ namespace profiler
                         stubroot->SetParent( NULL ); // for proper crawling
                         packedThreads.Push( stubroot );
 
-                        if ( active ) {
-                                Caller::thisThread.requireThreadLock = true;
-                                thread.threadState->threadLock.Release();
-                        }
+                        thread.threadState->threadLock.unlock();
                 }
 
-                // working on local data now, don't need the threads lock any more
-                threads.ReleaseGlobalLock();    
-
                 // do the pre-computations on the gathered threads
                 Caller::ComputeChildTicks preprocessor( *accumulate );
                 for ( size_t i = 0; i < packedThreads.Size(); i++ )
@@ -860,6 +842,8 @@ namespace profiler
                 dumper.PrintAccumulated( accumulate );          
                 dumper.Finish();
 
+                threads.ReleaseGlobalLock();    
+
                 delete accumulate;
                 delete packer;
         }
@@ -869,18 +853,25 @@ namespace profiler
         	cudaEventDestroy(globalStart);
         	cudaEventCreate(&globalStart); 
 
-                if ( root )
+                if ( root ) {
+                        cusp::detail::scoped_lock guard( Caller::thisThread->threadLock );
                         root->SoftReset();
+                }
         }
 
+        // give the calling thread its own call tree
         void enterThread( const char *name ) 
 	{
                 Caller *tmp = new Caller( name );
+                Caller::ThreadState *state = new Caller::ThreadState;
+                cusp::detail::mutex unlocked = __CUSP_MUTEX_INITIALIZER;
+                state->threadLock = unlocked;
+                state->activeCaller = tmp;
 
                 threads.AcquireGlobalLock();
-                threads.list->Push( Root( tmp, &Caller::thisThread ) );
+                threads.list->Push( Root( tmp, state ) );
 
-                Caller::thisThread.activeCaller = tmp;
+                Caller::thisThread = state;
                 tmp->Start();
                 tmp->SetActive( true );
                 root = tmp;
@@ -891,45 +882,72 @@ namespace profiler
         void exitThread() 
 	{
                 threads.AcquireGlobalLock();
+                Caller::thisThread->threadLock.lock();
 
                 root->Stop();
                 root->SetActive( false );
-                Caller::thisThread.activeCaller = NULL;
+                Caller::thisThread->activeCaller = NULL;
 
+                Caller::thisThread->threadLock.unlock();
                 threads.ReleaseGlobalLock();
         }
 
         inline void fastcall enterCaller( const char *name ) 
 	{
-                Caller *parent = Caller::thisThread.activeCaller;
+                // threads other than the main thread start their tree on their first call
+                if ( !Caller::thisThread )
+                        enterThread( "/Thread" );
+
+                Caller::ThreadState *state = Caller::thisThread;
+                cusp::detail::scoped_lock guard( state->threadLock );
+
+                Caller *parent = state->activeCaller;
                 if ( !parent )
                         return;
                
                 Caller *active = parent->FindOrCreate( name );
                 active->Start();
-                Caller::thisThread.activeCaller = active;
+                state->activeCaller = active;
         }
 
         inline void exitCaller() 
 	{
-                Caller *active = Caller::thisThread.activeCaller;
+                Caller::ThreadState *state = Caller::thisThread;
+                if ( !state )
+                        return;
+
+                cusp::detail::scoped_lock guard( state->threadLock );
+
+                Caller *active = state->activeCaller;
                 if ( !active )
                         return;
                
                 active->Stop();
-                Caller::thisThread.activeCaller = active->GetParent();
+                state->activeCaller = active->GetParent();
         }
 
         inline void pauseCaller() 
 	{
-                Caller *iter = Caller::thisThread.activeCaller;
+                Caller::ThreadState *state = Caller::thisThread;
+                if ( !state )
+                        return;
+
+                cusp::detail::scoped_lock guard( state->threadLock );
+
+                Caller *iter = state->activeCaller;
                 for ( ; iter; iter = iter->GetParent() )
                         iter->GetTimer().pause();
         }
 
         inline void unpauseCaller() 
 	{
-                Caller *iter = Caller::thisThread.activeCaller;
+                Caller::ThreadState *state = Caller::thisThread;
+                if ( !state )
+                        return;
+
+                cusp::detail::scoped_lock guard( state->threadLock );
+
+                Caller *iter = state->activeCaller;
                 for ( ; iter; iter = iter->GetParent() )
                         iter->GetTimer().unpause();
         }
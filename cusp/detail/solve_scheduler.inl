@@ -0,0 +1,583 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+#include <cusp/exception.h>
+#include <cusp/linear_operator.h>
+#include <cusp/monitor.h>
+#include <cusp/stream.h>
+
+#include <cusp/krylov/bicgstab.h>
+#include <cusp/krylov/cg.h>
+#include <cusp/krylov/gmres.h>
+
+#include <cusp/precond/diagonal.h>
+#include <cusp/precond/aggregation/smoothed_aggregation.h>
+
+#include <cusp/detail/thread.h>
+#include <cusp/detail/device/utils.h>
+
+#include <cuda_runtime_api.h>
+
+#include <algorithm>
+#include <exception>
+#include <new>
+
+namespace cusp
+{
+namespace detail
+{
+
+// tasks a worker scans for one whose matrix is cached on its device
+const size_t SCHEDULER_AFFINITY_WINDOW = 64;
+
+template <typename LinearOperator, typename Vector, typename Monitor, typename Preconditioner>
+void scheduled_solve(const cusp::solve_config& config, LinearOperator& A, Vector& x, Vector& b,
+                     Monitor& monitor, Preconditioner& M)
+{
+    switch (config.solver)
+    {
+        case cusp::scheduled_cg:
+            cusp::krylov::cg(A, x, b, monitor, M);
+            break;
+        case cusp::scheduled_bicgstab:
+            cusp::krylov::bicgstab(A, x, b, monitor, M);
+            break;
+        case cusp::scheduled_gmres:
+            cusp::krylov::gmres(A, x, b, std::max<size_t>(config.restart, 1), monitor, M);
+            break;
+        default:
+            throw cusp::invalid_input_exception("unknown scheduled_solver");
+    }
+}
+
+// CUDA events around the phases of a task
+class scheduled_timer
+{
+    public:
+    scheduled_timer(void)
+    {
+        for (int i = 0; i < 4; i++)
+            cudaEventCreate(&events[i]);
+    }
+
+    ~scheduled_timer(void)
+    {
+        for (int i = 0; i < 4; i++)
+            cudaEventDestroy(events[i]);
+    }
+
+    void record(int i)
+    {
+        cudaEventRecord(events[i], cusp::current_stream());
+    }
+
+    // milliseconds between events i and i + 1, which must have completed
+    float elapsed(int i) const
+    {
+        float ms = 0.0f;
+        cudaEventElapsedTime(&ms, events[i], events[i + 1]);
+        return ms;
+    }
+
+    private:
+    cudaEvent_t events[4];
+
+    scheduled_timer(const scheduled_timer&);
+    scheduled_timer& operator=(const scheduled_timer&);
+};
+
+} // end namespace detail
+
+template <typename IndexType, typename ValueType>
+struct solve_scheduler<IndexType,ValueType>::cache_entry
+{
+    typedef cusp::csr_matrix<IndexType,ValueType,cusp::device_memory> device_matrix_type;
+    typedef cusp::precond::aggregation::smoothed_aggregation<IndexType,ValueType,cusp::device_memory> hierarchy_type;
+
+    // identity of the host matrix
+    const matrix_type * key;
+    size_t num_rows;
+    size_t num_entries;
+
+    device_matrix_type A;
+
+    // hierarchies of A which no solve is using
+    std::vector<hierarchy_type *> hierarchies;
+
+    // solves using A, which is not evicted while they run
+    size_t users;
+
+    // dropped by invalidate() while in use, deleted by its last user
+    bool stale;
+
+    cache_entry(const matrix_type& host_A)
+        : key(&host_A), num_rows(host_A.num_rows), num_entries(host_A.num_entries),
+          A(host_A), users(0), stale(false) {}
+
+    ~cache_entry(void)
+    {
+        for (size_t i = 0; i < hierarchies.size(); i++)
+            delete hierarchies[i];
+    }
+
+    bool matches(const matrix_type& host_A) const
+    {
+        return key == &host_A && num_rows == host_A.num_rows && num_entries == host_A.num_entries && !stale;
+    }
+};
+
+template <typename IndexType, typename ValueType>
+solve_scheduler<IndexType,ValueType>
+::solve_scheduler(size_t streams_per_device, size_t cached_matrices_per_device)
+    : streams_per_device(std::max<size_t>(streams_per_device, 1)),
+      cached_matrices_per_device(cached_matrices_per_device)
+{
+    cusp::detail::mutex unlocked = __CUSP_MUTEX_INITIALIZER;
+    lock = unlocked;
+
+    int count = 0;
+
+    if (cudaGetDeviceCount(&count) != cudaSuccess || count == 0)
+    {
+        cudaGetLastError();
+        throw cusp::runtime_exception("solve_scheduler found no device");
+    }
+
+    for (int d = 0; d < count; d++)
+        devices_.push_back(d);
+
+    caches.resize(devices_.size());
+}
+
+template <typename IndexType, typename ValueType>
+solve_scheduler<IndexType,ValueType>
+::solve_scheduler(const std::vector<int>& devices, size_t streams_per_device, size_t cached_matrices_per_device)
+    : streams_per_device(std::max<size_t>(streams_per_device, 1)),
+      cached_matrices_per_device(cached_matrices_per_device)
+{
+    cusp::detail::mutex unlocked = __CUSP_MUTEX_INITIALIZER;
+    lock = unlocked;
+
+    for (size_t i = 0; i < devices.size(); i++)
+        if (std::find(devices_.begin(), devices_.end(), devices[i]) == devices_.end())
+            devices_.push_back(devices[i]);
+
+    if (devices_.empty())
+        throw cusp::invalid_input_exception("solve_scheduler needs at least one device");
+
+    caches.resize(devices_.size());
+}
+
+template <typename IndexType, typename ValueType>
+solve_scheduler<IndexType,ValueType>
+::~solve_scheduler(void)
+{
+    clear_cache();
+}
+
+template <typename IndexType, typename ValueType>
+size_t solve_scheduler<IndexType,ValueType>
+::submit(const matrix_type& A, const array_type& b, array_type& x, const solve_config& config)
+{
+    if (A.num_rows != A.num_cols)
+        throw cusp::invalid_input_exception("scheduled matrix must be square");
+
+    if (b.size() != A.num_rows || x.size() != A.num_rows)
+        throw cusp::invalid_input_exception("scheduled right-hand side and solution must have a size equal to the number of rows");
+
+    task t;
+    t.A      = &A;
+    t.b      = &b;
+    t.x      = &x;
+    t.config = config;
+
+    tasks.push_back(t);
+
+    return tasks.size() - 1;
+}
+
+template <typename IndexType, typename ValueType>
+std::vector<cusp::solve_report> solve_scheduler<IndexType,ValueType>
+::run(void)
+{
+    reports.assign(tasks.size(), cusp::solve_report());
+    pending.clear();
+
+    for (size_t t = 0; t < tasks.size(); t++)
+    {
+        reports[t].task = t;
+        pending.push_back(t);
+    }
+
+    const size_t num_workers = std::min(devices_.size() * streams_per_device, std::max<size_t>(tasks.size(), 1));
+
+    if (!tasks.empty())
+        cusp::detail::run_threads(num_workers, &solve_scheduler::worker, this);
+
+    // left over when no worker could set up its device
+    for (typename std::list<size_t>::iterator it = pending.begin(); it != pending.end(); ++it)
+        reports[*it].error = "no device could run the task";
+
+    pending.clear();
+
+    tasks.clear();
+
+    std::vector<cusp::solve_report> result;
+    result.swap(reports);
+
+    return result;
+}
+
+template <typename IndexType, typename ValueType>
+void solve_scheduler<IndexType,ValueType>
+::worker(void * scheduler, size_t w)
+{
+    static_cast<solve_scheduler *>(scheduler)->run_worker(w);
+}
+
+template <typename IndexType, typename ValueType>
+void solve_scheduler<IndexType,ValueType>
+::run_worker(size_t w)
+{
+    // workers are dealt to the devices in turn, so that a few tasks still
+    // spread over all devices
+    const size_t slot = w % devices_.size();
+
+    cudaStream_t stream = 0;
+
+    if (cudaSetDevice(devices_[slot]) != cudaSuccess ||
+        cudaStreamCreateWithFlags(&stream, cudaStreamNonBlocking) != cudaSuccess)
+    {
+        // leave the tasks to the other workers
+        cudaGetLastError();
+        return;
+    }
+
+    {
+        cusp::stream_scope scope(stream);
+
+        size_t t;
+
+        while (next_task(slot, t))
+        {
+            cusp::solve_report& report = reports[t];
+            report.device = devices_[slot];
+            report.worker = w;
+
+            try
+            {
+                execute(slot, t, report);
+                report.completed = true;
+            }
+            catch (const std::exception& e)
+            {
+                report.error = e.what();
+            }
+            catch (...)
+            {
+                report.error = "unknown exception";
+            }
+
+            // clear an error left by a failed solve
+            cudaStreamSynchronize(stream);
+            cudaGetLastError();
+        }
+    }
+
+    cudaStreamDestroy(stream);
+}
+
+template <typename IndexType, typename ValueType>
+bool solve_scheduler<IndexType,ValueType>
+::next_task(size_t slot, size_t& t)
+{
+    cusp::detail::scoped_lock guard(lock);
+
+    if (pending.empty())
+        return false;
+
+    std::list<cache_entry *>& cache = caches[slot];
+
+    // a task whose matrix is cached on this device, else the oldest
+    typename std::list<size_t>::iterator choice = pending.begin();
+    size_t scanned = 0;
+
+    for (typename std::list<size_t>::iterator it = pending.begin();
+         it != pending.end() && scanned < cusp::detail::SCHEDULER_AFFINITY_WINDOW; ++it, ++scanned)
+    {
+        bool cached = false;
+
+        for (typename std::list<cache_entry *>::iterator e = cache.begin(); e != cache.end() && !cached; ++e)
+            cached = (*e)->matches(*tasks[*it].A);
+
+        if (cached)
+        {
+            choice = it;
+            break;
+        }
+    }
+
+    t = *choice;
+    pending.erase(choice);
+
+    return true;
+}
+
+template <typename IndexType, typename ValueType>
+void solve_scheduler<IndexType,ValueType>
+::execute(size_t slot, size_t t, cusp::solve_report& report)
+{
+    typedef typename cache_entry::hierarchy_type               hierarchy_type;
+    typedef cusp::array1d<ValueType,cusp::device_memory>       device_array_type;
+    typedef typename cusp::norm_type<ValueType>::type          Real;
+
+    const task& job = tasks[t];
+
+    cusp::detail::scheduled_timer timer;
+
+    timer.record(0);
+
+    cache_entry * entry = acquire_matrix(slot, *job.A, report.matrix_cached);
+
+    hierarchy_type * hierarchy = NULL;
+
+    try
+    {
+        device_array_type x(*job.x);
+        device_array_type b(*job.b);
+
+        cusp::default_monitor<ValueType> monitor(b, job.config.iteration_limit,
+                                                 Real(job.config.relative_tolerance),
+                                                 Real(job.config.absolute_tolerance));
+
+        switch (job.config.preconditioner)
+        {
+            case cusp::scheduled_identity:
+            {
+                cusp::identity_operator<ValueType,cusp::device_memory> M(entry->A.num_rows, entry->A.num_rows);
+                timer.record(1);
+                cusp::detail::scheduled_solve(job.config, entry->A, x, b, monitor, M);
+                break;
+            }
+            case cusp::scheduled_diagonal:
+            {
+                cusp::precond::diagonal<ValueType,cusp::device_memory> M(entry->A);
+                timer.record(1);
+                cusp::detail::scheduled_solve(job.config, entry->A, x, b, monitor, M);
+                break;
+            }
+            case cusp::scheduled_smoothed_aggregation:
+            {
+                {
+                    cusp::detail::scoped_lock guard(lock);
+
+                    if (!entry->hierarchies.empty())
+                    {
+                        hierarchy = entry->hierarchies.back();
+                        entry->hierarchies.pop_back();
+                    }
+                }
+
+                report.hierarchy_cached = hierarchy != NULL;
+
+                if (hierarchy == NULL)
+                    hierarchy = new hierarchy_type(entry->A);
+
+                timer.record(1);
+                cusp::detail::scheduled_solve(job.config, entry->A, x, b, monitor, *hierarchy);
+                break;
+            }
+            default:
+                throw cusp::invalid_input_exception("unknown scheduled_preconditioner");
+        }
+
+        timer.record(2);
+
+        *job.x = x;
+
+        timer.record(3);
+
+        // the cached matrix and hierarchy are handed to the other streams of
+        // the device only once this solve no longer uses them
+        cudaStreamSynchronize(cusp::current_stream());
+
+        report.converged     = monitor.converged();
+        report.iterations    = monitor.iteration_count();
+        report.residual_norm = monitor.residual_norm();
+
+        report.setup_milliseconds    = timer.elapsed(0);
+        report.solve_milliseconds    = timer.elapsed(1);
+        report.download_milliseconds = timer.elapsed(2);
+    }
+    catch (...)
+    {
+        cudaStreamSynchronize(cusp::current_stream());
+        delete hierarchy;
+        release_matrix(slot, entry);
+        throw;
+    }
+
+    if (hierarchy != NULL)
+    {
+        cusp::detail::scoped_lock guard(lock);
+        entry->hierarchies.push_back(hierarchy);
+    }
+
+    release_matrix(slot, entry);
+}
+
+template <typename IndexType, typename ValueType>
+typename solve_scheduler<IndexType,ValueType>::cache_entry *
+solve_scheduler<IndexType,ValueType>
+::acquire_matrix(size_t slot, const matrix_type& A, bool& cached)
+{
+    std::list<cache_entry *>& cache = caches[slot];
+
+    {
+        cusp::detail::scoped_lock guard(lock);
+
+        for (typename std::list<cache_entry *>::iterator it = cache.begin(); it != cache.end(); ++it)
+        {
+            if ((*it)->matches(A))
+            {
+                cache_entry * entry = *it;
+                entry->users++;
+
+                // most recently used first
+                cache.erase(it);
+                cache.push_front(entry);
+
+                cached = true;
+                return entry;
+            }
+        }
+    }
+
+    // copy the matrix without holding the lock
+    cache_entry * entry = new cache_entry(A);
+    cudaStreamSynchronize(cusp::current_stream());
+
+    cusp::detail::scoped_lock guard(lock);
+
+    // another worker of the device may have copied it meanwhile
+    for (typename std::list<cache_entry *>::iterator it = cache.begin(); it != cache.end(); ++it)
+    {
+        if ((*it)->matches(A))
+        {
+            delete entry;
+            entry = *it;
+            entry->users++;
+
+            cached = true;
+            return entry;
+        }
+    }
+
+    entry->users = 1;
+    cache.push_front(entry);
+    evict(slot);
+
+    cached = false;
+    return entry;
+}
+
+template <typename IndexType, typename ValueType>
+void solve_scheduler<IndexType,ValueType>
+::release_matrix(size_t slot, cache_entry * entry)
+{
+    cusp::detail::scoped_lock guard(lock);
+
+    entry->users--;
+
+    if (entry->stale && entry->users == 0)
+    {
+        caches[slot].remove(entry);
+        delete entry;
+        return;
+    }
+
+    evict(slot);
+}
+
+// with the lock held: drop the least recently used matrices which no solve
+// is using until at most cached_matrices_per_device remain
+template <typename IndexType, typename ValueType>
+void solve_scheduler<IndexType,ValueType>
+::evict(size_t slot)
+{
+    std::list<cache_entry *>& cache = caches[slot];
+
+    typename std::list<cache_entry *>::iterator it = cache.end();
+
+    while (cache.size() > cached_matrices_per_device && it != cache.begin())
+    {
+        --it;
+
+        if ((*it)->users == 0)
+        {
+            delete *it;
+            it = cache.erase(it);
+        }
+    }
+}
+
+template <typename IndexType, typename ValueType>
+void solve_scheduler<IndexType,ValueType>
+::clear_slot(size_t slot, const matrix_type * A)
+{
+    cusp::detail::device::device_scope scope(devices_[slot]);
+
+    cusp::detail::scoped_lock guard(lock);
+
+    std::list<cache_entry *>& cache = caches[slot];
+
+    for (typename std::list<cache_entry *>::iterator it = cache.begin(); it != cache.end();)
+    {
+        if (A != NULL && (*it)->key != A)
+        {
+            ++it;
+        }
+        else if ((*it)->users > 0)
+        {
+            (*it)->stale = true;
+            ++it;
+        }
+        else
+        {
+            delete *it;
+            it = cache.erase(it);
+        }
+    }
+}
+
+template <typename IndexType, typename ValueType>
+void solve_scheduler<IndexType,ValueType>
+::invalidate(const matrix_type& A)
+{
+    for (size_t slot = 0; slot < devices_.size(); slot++)
+        clear_slot(slot, &A);
+}
+
+template <typename IndexType, typename ValueType>
+void solve_scheduler<IndexType,ValueType>
+::clear_cache(void)
+{
+    for (size_t slot = 0; slot < devices_.size(); slot++)
+        clear_slot(slot, NULL);
+}
+
+} // end namespace cusp
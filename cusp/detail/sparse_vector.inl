@@ -0,0 +1,110 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+#include <cusp/format.h>
+
+#include <thrust/copy.h>
+#include <thrust/count.h>
+#include <thrust/fill.h>
+#include <thrust/scatter.h>
+#include <thrust/iterator/counting_iterator.h>
+
+namespace cusp
+{
+namespace detail
+{
+
+template <typename ValueType>
+struct sparse_vector_nonzero
+{
+  __host__ __device__
+  bool operator()(const ValueType& x) const
+  {
+    return x != ValueType(0);
+  }
+};
+
+template <typename IndexType, typename ValueType, class MemorySpace, typename VectorType>
+void assign_sparse_vector(cusp::sparse_vector<IndexType,ValueType,MemorySpace>& dst,
+                          const VectorType& src, cusp::sparse_vector_format)
+{
+  dst.resize(src.length, src.num_entries);
+  dst.indices = src.indices;
+  dst.values  = src.values;
+}
+
+template <typename IndexType, typename ValueType, class MemorySpace, typename VectorType>
+void assign_sparse_vector(cusp::sparse_vector<IndexType,ValueType,MemorySpace>& dst,
+                          const VectorType& src, cusp::array1d_format)
+{
+  // compact in the destination memory space
+  cusp::array1d<ValueType,MemorySpace> dense(src.begin(), src.end());
+
+  const size_t num_entries = thrust::count_if(dense.begin(), dense.end(),
+                                              sparse_vector_nonzero<ValueType>());
+
+  dst.resize(dense.size(), num_entries);
+
+  thrust::copy_if(thrust::counting_iterator<IndexType>(0),
+                  thrust::counting_iterator<IndexType>(dense.size()),
+                  dense.begin(), dst.indices.begin(),
+                  sparse_vector_nonzero<ValueType>());
+  thrust::copy_if(dense.begin(), dense.end(), dst.values.begin(),
+                  sparse_vector_nonzero<ValueType>());
+}
+
+} // end namespace detail
+
+template <typename IndexType, typename ValueType, class MemorySpace>
+template <typename VectorType>
+sparse_vector<IndexType,ValueType,MemorySpace>
+  ::sparse_vector(const VectorType& vector)
+    : length(0), num_entries(0)
+{
+  cusp::detail::assign_sparse_vector(*this, vector, typename VectorType::format());
+}
+
+template <typename IndexType, typename ValueType, class MemorySpace>
+template <typename VectorType>
+sparse_vector<IndexType,ValueType,MemorySpace>&
+sparse_vector<IndexType,ValueType,MemorySpace>
+  ::operator=(const VectorType& vector)
+{
+  cusp::detail::assign_sparse_vector(*this, vector, typename VectorType::format());
+
+  return *this;
+}
+
+template <typename IndexType, typename ValueType, class MemorySpace>
+template <typename ArrayType>
+void sparse_vector<IndexType,ValueType,MemorySpace>
+  ::to_dense(ArrayType& dense) const
+{
+  typedef typename ArrayType::value_type   DenseValueType;
+  typedef typename ArrayType::memory_space DenseMemorySpace;
+
+  dense.resize(length);
+  thrust::fill(dense.begin(), dense.end(), DenseValueType(0));
+
+  // scatter in the memory space of the dense array
+  cusp::array1d<IndexType,DenseMemorySpace>      I(indices);
+  cusp::array1d<DenseValueType,DenseMemorySpace> V(values);
+
+  thrust::scatter(V.begin(), V.end(), I.begin(), dense.begin());
+}
+
+} // end namespace cusp
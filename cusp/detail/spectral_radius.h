@@ -22,12 +22,18 @@
 #include <cusp/krylov/arnoldi.h>
 #include <cusp/array1d.h>
 #include <cusp/array2d.h>
+#include <cusp/coo_matrix.h>
 #include <cusp/detail/random.h>
 #include <cusp/detail/format_utils.h>
 
 #include <thrust/extrema.h>
+#include <thrust/fill.h>
+#include <thrust/functional.h>
+#include <thrust/scatter.h>
 #include <thrust/transform.h>
 #include <thrust/iterator/counting_iterator.h>
+#include <thrust/iterator/transform_iterator.h>
+#include <thrust/iterator/zip_iterator.h>
 #include <thrust/reduce.h>
 
 #include <thrust/detail/integer_traits.h>
@@ -106,24 +112,38 @@ double ritz_spectral_radius_symmetric(const Matrix& A, size_t k = 10)
     return estimate_spectral_radius(H);
 }
 
-template <typename IndexType, typename ValueType, typename MemorySpace>    
-double disks_spectral_radius(const cusp::coo_matrix<IndexType,ValueType,MemorySpace>& A)
+// sums[i] <- sum_j |A(i,j)|, rows without entries are zero
+template <typename IndexType, typename ValueType, typename MemorySpace, typename Array>
+void absolute_row_sums(const cusp::coo_matrix<IndexType,ValueType,MemorySpace>& A, Array& sums)
 {
     CUSP_PROFILE_SCOPED();
 
-    const IndexType N = A.num_rows;
-
-    // compute sum of absolute values for each row of A
-    cusp::array1d<IndexType, MemorySpace> row_sums(N);
+    cusp::array1d<IndexType, MemorySpace> rows(A.num_rows);
+    cusp::array1d<ValueType, MemorySpace> row_sums(A.num_rows);
 
-    {
-      cusp::array1d<IndexType, MemorySpace> temp(N);
+    IndexType num_rows =
       thrust::reduce_by_key
         (A.row_indices.begin(), A.row_indices.end(),
          thrust::make_transform_iterator(A.values.begin(), absolute<ValueType>()),
-         temp.begin(),
-         row_sums.begin());
-    }
+         rows.begin(),
+         row_sums.begin()).first - rows.begin();
+
+    sums.resize(A.num_rows);
+    thrust::fill(sums.begin(), sums.end(), ValueType(0));
+    thrust::scatter(row_sums.begin(), row_sums.begin() + num_rows, rows.begin(), sums.begin());
+}
+
+template <typename IndexType, typename ValueType, typename MemorySpace>    
+double disks_spectral_radius(const cusp::coo_matrix<IndexType,ValueType,MemorySpace>& A)
+{
+    CUSP_PROFILE_SCOPED();
+
+    if (A.num_rows == 0)
+        return 0;
+
+    // compute sum of absolute values for each row of A
+    cusp::array1d<ValueType, MemorySpace> row_sums;
+    absolute_row_sums(A, row_sums);
 
     return *thrust::max_element(row_sums.begin(), row_sums.end());
 }
@@ -140,6 +160,86 @@ double disks_spectral_radius(const Matrix& A)
     return disks_spectral_radius(C);
 }
 
+template <typename ValueType>
+struct disks_Dinv_A_radius
+{
+    template <typename Tuple>
+    __host__ __device__
+    ValueType operator()(const Tuple& t) const
+    {
+        const ValueType sum = thrust::get<0>(t);
+        const ValueType d   = thrust::get<1>(t);
+
+        return sum / (d < 0 ? -d : d);
+    }
+};
+
+// Gershgorin bound of the spectral radius of D^-1 A, i.e.
+// max_i sum_j |A(i,j)| / |A(i,i)|, computed with a few reductions
+template <typename Matrix> 
+double disks_spectral_radius_Dinv_A(const Matrix& A)
+{
+    CUSP_PROFILE_SCOPED();
+
+    typedef typename Matrix::index_type   IndexType;
+    typedef typename Matrix::value_type   ValueType;
+    typedef typename Matrix::memory_space MemorySpace;
+
+    if (A.num_rows == 0)
+        return 0;
+
+    const cusp::coo_matrix<IndexType,ValueType,MemorySpace> C(A);
+
+    cusp::array1d<ValueType, MemorySpace> row_sums;
+    cusp::array1d<ValueType, MemorySpace> diagonal;
+    absolute_row_sums(C, row_sums);
+    cusp::detail::extract_diagonal(C, diagonal);
+
+    return thrust::transform_reduce
+        (thrust::make_zip_iterator(thrust::make_tuple(row_sums.begin(), diagonal.begin())),
+         thrust::make_zip_iterator(thrust::make_tuple(row_sums.end(),   diagonal.end())),
+         disks_Dinv_A_radius<ValueType>(),
+         ValueType(0),
+         thrust::maximum<ValueType>());
+}
+
+// power iteration for the spectral radius of D^-1 A, which only uses SpMVs
+// and vector operations in the memory space of A and therefore avoids the
+// host Hessenberg matrices of the Ritz estimates
+template <typename Matrix>    
+double estimate_spectral_radius_Dinv_A(const Matrix& A, size_t k = 15)
+{
+    CUSP_PROFILE_SCOPED();
+
+    typedef typename Matrix::index_type   IndexType;
+    typedef typename Matrix::value_type   ValueType;
+    typedef typename Matrix::memory_space MemorySpace;
+
+    const IndexType N = A.num_rows;
+
+    if (N == 0 || k == 0)
+        return 0;
+
+    cusp::array1d<ValueType, MemorySpace> diagonal;
+    cusp::detail::extract_diagonal(A, diagonal);
+
+    cusp::array1d<ValueType, MemorySpace> x(N);
+    cusp::array1d<ValueType, MemorySpace> y(N);
+
+    // initialize x to random values in [0,1)
+    cusp::copy(cusp::detail::random_reals<ValueType>(N), x);
+
+    for(size_t i = 0; i < k; i++)
+    {
+        cusp::blas::scal(x, ValueType(1.0) / cusp::blas::nrmmax(x));
+        cusp::multiply(A, x, y);
+        thrust::transform(y.begin(), y.end(), diagonal.begin(), y.begin(), thrust::divides<ValueType>());
+        x.swap(y);
+    }
+   
+    return cusp::blas::nrm2(x) / cusp::blas::nrm2(y);
+}
+
 } // end namespace detail
 } // end namespace cusp
 
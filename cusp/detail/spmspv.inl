@@ -0,0 +1,178 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+#include <cusp/exception.h>
+#include <cusp/transpose.h>
+
+#include <cusp/detail/dispatch/spmspv.h>
+
+#include <thrust/functional.h>
+#include <thrust/inner_product.h>
+#include <thrust/iterator/permutation_iterator.h>
+
+namespace cusp
+{
+namespace detail
+{
+
+template <typename IndexType, typename MaskType>
+struct spmspv_masked_offset
+{
+  __host__ __device__
+  size_t operator()(const IndexType& offset, const MaskType& mask) const
+  {
+    return mask == MaskType(0) ? 0 : size_t(offset);
+  }
+};
+
+// number of entries in the columns of A matching the entries of x
+template <typename IndexType, typename ValueType, class MemorySpace, typename SparseVector>
+size_t spmspv_push_cost(const cusp::spmspv_matrix<IndexType,ValueType,MemorySpace>& A,
+                        const SparseVector& x)
+{
+  const cusp::csr_matrix<IndexType,ValueType,MemorySpace>& C = A.column_matrix();
+
+  return thrust::inner_product(thrust::make_permutation_iterator(C.row_offsets.begin() + 1, x.indices.begin()),
+                               thrust::make_permutation_iterator(C.row_offsets.begin() + 1, x.indices.end()),
+                               thrust::make_permutation_iterator(C.row_offsets.begin(),     x.indices.begin()),
+                               size_t(0),
+                               thrust::plus<size_t>(),
+                               thrust::minus<size_t>());
+}
+
+// number of entries in the rows of A selected by the mask
+template <typename IndexType, typename ValueType, class MemorySpace, typename Array>
+size_t spmspv_pull_cost(const cusp::spmspv_matrix<IndexType,ValueType,MemorySpace>& A,
+                        const Array* mask)
+{
+  typedef typename Array::value_type MaskType;
+
+  if (mask == 0)
+    return A.num_entries;
+
+  const cusp::csr_matrix<IndexType,ValueType,MemorySpace>& R = A.rows;
+
+  const size_t ends   = thrust::inner_product(R.row_offsets.begin() + 1, R.row_offsets.end(), mask->begin(), size_t(0),
+                                              thrust::plus<size_t>(), spmspv_masked_offset<IndexType,MaskType>());
+  const size_t starts = thrust::inner_product(R.row_offsets.begin(), R.row_offsets.end() - 1, mask->begin(), size_t(0),
+                                              thrust::plus<size_t>(), spmspv_masked_offset<IndexType,MaskType>());
+
+  return ends - starts;
+}
+
+template <typename IndexType, typename ValueType, class MemorySpace,
+          typename SparseVector1, typename Array, typename SparseVector2,
+          typename BinaryFunction1, typename BinaryFunction2>
+spmspv_direction generalized_spmspv(const cusp::spmspv_matrix<IndexType,ValueType,MemorySpace>& A,
+                                    const SparseVector1& x,
+                                    const Array* mask,
+                                          SparseVector2& y,
+                                    BinaryFunction1 combine,
+                                    BinaryFunction2 reduce)
+{
+  if (x.size() != A.num_cols)
+    throw cusp::invalid_input_exception("sparse vector size does not match the matrix");
+  if (mask != 0 && mask->size() != A.num_rows)
+    throw cusp::invalid_input_exception("mask size does not match the matrix");
+
+  spmspv_direction direction = A.direction;
+
+  if (direction == spmspv_auto)
+  {
+    const size_t push_cost = spmspv_push_cost(A, x);
+    const size_t pull_cost = spmspv_pull_cost(A, mask);
+
+    direction = A.alpha * push_cost < pull_cost ? spmspv_push : spmspv_pull;
+  }
+
+  if (direction == spmspv_push)
+    cusp::detail::dispatch::spmspv_push(A.column_matrix(), A.num_rows, x, mask, y, combine, reduce,
+                                        MemorySpace(),
+                                        typename SparseVector1::memory_space(),
+                                        typename SparseVector2::memory_space());
+  else
+    cusp::detail::dispatch::spmspv_pull(A.rows, x, mask, y, combine, reduce,
+                                        MemorySpace(),
+                                        typename SparseVector1::memory_space(),
+                                        typename SparseVector2::memory_space());
+
+  return direction;
+}
+
+} // end namespace detail
+
+template <typename IndexType, typename ValueType, class MemorySpace>
+template <typename MatrixType>
+spmspv_matrix<IndexType,ValueType,MemorySpace>
+  ::spmspv_matrix(const MatrixType& matrix, bool symmetric)
+    : num_rows(matrix.num_rows), num_cols(matrix.num_cols), num_entries(0),
+      rows(matrix), symmetric(symmetric), direction(spmspv_auto), alpha(14.0f)
+{
+  if (symmetric && num_rows != num_cols)
+    throw cusp::invalid_input_exception("a symmetric matrix must be square");
+
+  num_entries = rows.num_entries;
+
+  if (!symmetric)
+    cusp::transpose(rows, columns);
+}
+
+template <typename IndexType, typename ValueType, class MemorySpace,
+          typename SparseVector1, typename SparseVector2,
+          typename BinaryFunction1, typename BinaryFunction2>
+spmspv_direction generalized_spmspv(const cusp::spmspv_matrix<IndexType,ValueType,MemorySpace>& A,
+                                    const SparseVector1& x,
+                                          SparseVector2& y,
+                                    BinaryFunction1 combine,
+                                    BinaryFunction2 reduce)
+{
+  CUSP_PROFILE_SCOPED();
+
+  const cusp::array1d<unsigned char,MemorySpace>* no_mask = 0;
+
+  return cusp::detail::generalized_spmspv(A, x, no_mask, y, combine, reduce);
+}
+
+template <typename IndexType, typename ValueType, class MemorySpace,
+          typename SparseVector1, typename Array, typename SparseVector2,
+          typename BinaryFunction1, typename BinaryFunction2>
+spmspv_direction generalized_spmspv(const cusp::spmspv_matrix<IndexType,ValueType,MemorySpace>& A,
+                                    const SparseVector1& x,
+                                    const Array& mask,
+                                          SparseVector2& y,
+                                    BinaryFunction1 combine,
+                                    BinaryFunction2 reduce)
+{
+  CUSP_PROFILE_SCOPED();
+
+  return cusp::detail::generalized_spmspv(A, x, &mask, y, combine, reduce);
+}
+
+template <typename IndexType, typename ValueType, class MemorySpace,
+          typename SparseVector1, typename SparseVector2>
+spmspv_direction spmspv(const cusp::spmspv_matrix<IndexType,ValueType,MemorySpace>& A,
+                        const SparseVector1& x,
+                              SparseVector2& y)
+{
+  typedef typename SparseVector2::value_type OutputType;
+
+  return cusp::generalized_spmspv(A, x, y,
+                                  thrust::multiplies<OutputType>(),
+                                  thrust::plus<OutputType>());
+}
+
+} // end namespace cusp
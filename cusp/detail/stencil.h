@@ -0,0 +1,106 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include <cusp/detail/config.h>
+
+namespace cusp
+{
+namespace detail
+{
+
+// A constant-coefficient stencil on a grid of up to three dimensions, the
+// first of which varies fastest, as in gallery::generate_matrix_from_stencil.
+// Points of the stencil which fall outside the grid contribute nothing.
+// The struct is passed to the kernels by value.
+template <typename IndexType, typename ValueType>
+struct stencil_coefficients
+{
+    static const int MAX_DIMENSIONS = 3;
+    static const int MAX_POINTS     = 27;
+
+    IndexType grid[MAX_DIMENSIONS];             // points per dimension, 1 for unused dimensions
+    int       num_points;
+    int       offsets[MAX_POINTS][MAX_DIMENSIONS];  // position of each point relative to the row
+    ValueType values[MAX_POINTS];
+
+    __host__ __device__
+    IndexType num_rows(void) const
+    {
+        return grid[0] * grid[1] * grid[2];
+    }
+
+    // largest offset of any point along dimension d
+    __host__ __device__
+    int radius(int d) const
+    {
+        int r = 0;
+        for (int n = 0; n < num_points; n++)
+        {
+            const int o = offsets[n][d] < 0 ? -offsets[n][d] : offsets[n][d];
+            if (o > r)
+                r = o;
+        }
+        return r;
+    }
+
+    // column of point n in the row, false if the point is outside the grid
+    __host__ __device__
+    bool column(const IndexType row, const int n, IndexType& col) const
+    {
+        const IndexType i = row % grid[0]             + offsets[n][0];
+        const IndexType j = (row / grid[0]) % grid[1] + offsets[n][1];
+        const IndexType k = row / (grid[0] * grid[1]) + offsets[n][2];
+
+        if (i < 0 || i >= grid[0] || j < 0 || j >= grid[1] || k < 0 || k >= grid[2])
+            return false;
+
+        col = (k * grid[1] + j) * grid[0] + i;
+        return true;
+    }
+};
+
+// y[row] <- sum of the stencil applied to x around row
+template <typename IndexType, typename ValueType>
+struct stencil_row
+{
+    stencil_coefficients<IndexType,ValueType> stencil;
+    const ValueType * x;
+    ValueType * y;
+
+    stencil_row(const stencil_coefficients<IndexType,ValueType>& stencil, const ValueType * x, ValueType * y)
+        : stencil(stencil), x(x), y(y) {}
+
+    __host__ __device__
+    void operator()(const IndexType row) const
+    {
+        ValueType sum = ValueType(0);
+
+        for (int n = 0; n < stencil.num_points; n++)
+        {
+            IndexType col;
+
+            if (stencil.column(row, n, col))
+                sum += stencil.values[n] * x[col];
+        }
+
+        y[row] = sum;
+    }
+};
+
+} // end namespace detail
+} // end namespace cusp
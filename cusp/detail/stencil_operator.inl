@@ -0,0 +1,127 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include <cusp/exception.h>
+#include <cusp/gallery/stencil.h>
+
+#include <cusp/detail/stream.h>
+
+#include <thrust/tuple.h>
+#include <thrust/iterator/counting_iterator.h>
+
+namespace cusp
+{
+namespace detail
+{
+
+template <typename IndexType, typename ValueType>
+void apply_stencil(const stencil_coefficients<IndexType,ValueType>& stencil,
+                   const ValueType * x, ValueType * y, cusp::host_memory)
+{
+    cusp::detail::stream::for_each(thrust::counting_iterator<IndexType>(0),
+                                   thrust::counting_iterator<IndexType>(stencil.num_rows()),
+                                   stencil_row<IndexType,ValueType>(stencil, x, y));
+}
+
+template <typename IndexType, typename ValueType>
+void apply_stencil(const stencil_coefficients<IndexType,ValueType>& stencil,
+                   const ValueType * x, ValueType * y, cusp::device_memory)
+{
+    cusp::detail::device::spmv_stencil(stencil, x, y);
+}
+
+// nonzeros of the matrix of the stencil, as counted by generate_matrix_from_stencil
+template <typename IndexType, typename ValueType>
+IndexType stencil_num_entries(const stencil_coefficients<IndexType,ValueType>& stencil)
+{
+    IndexType num_entries = 0;
+
+    for (int n = 0; n < stencil.num_points; n++)
+    {
+        if (stencil.values[n] == ValueType(0))
+            continue;
+
+        // rows whose neighbor at the offset is inside the grid
+        IndexType rows = 1;
+
+        for (int d = 0; d < stencil.MAX_DIMENSIONS; d++)
+        {
+            const IndexType o = stencil.offsets[n][d] < 0 ? -stencil.offsets[n][d] : stencil.offsets[n][d];
+            rows *= o < stencil.grid[d] ? stencil.grid[d] - o : IndexType(0);
+        }
+
+        num_entries += rows;
+    }
+
+    return num_entries;
+}
+
+} // end namespace detail
+
+template <typename ValueType, typename MemorySpace, typename IndexType>
+stencil_operator<ValueType,MemorySpace,IndexType>
+::stencil_operator(void)
+    : Parent()
+{
+    for (int d = 0; d < stencil.MAX_DIMENSIONS; d++)
+        stencil.grid[d] = d == 0 ? 0 : 1;
+
+    stencil.num_points = 0;
+}
+
+template <typename ValueType, typename MemorySpace, typename IndexType>
+template <typename StencilPoint, typename GridDimension>
+stencil_operator<ValueType,MemorySpace,IndexType>
+::stencil_operator(const cusp::array1d<StencilPoint,cusp::host_memory>& points,
+                   const GridDimension& grid)
+    : Parent()
+{
+    if (!cusp::gallery::detail::make_stencil_coefficients(stencil, points, grid))
+        throw cusp::invalid_input_exception("stencil_operator supports grids of at most three dimensions and stencils of at most 27 points");
+
+    const IndexType num_rows = stencil.num_rows();
+
+    this->resize(num_rows, num_rows, detail::stencil_num_entries(stencil));
+}
+
+template <typename ValueType, typename MemorySpace, typename IndexType>
+template <typename MemorySpace2>
+stencil_operator<ValueType,MemorySpace,IndexType>
+::stencil_operator(const stencil_operator<ValueType,MemorySpace2,IndexType>& A)
+    : Parent(A.num_rows, A.num_cols, A.num_entries), stencil(A.stencil)
+{
+}
+
+template <typename ValueType, typename MemorySpace, typename IndexType>
+template <typename VectorType1, typename VectorType2>
+void stencil_operator<ValueType,MemorySpace,IndexType>
+::operator()(const VectorType1& x, VectorType2& y) const
+{
+    CUSP_PROFILE_SCOPED();
+
+    if (x.size() != size_t(this->num_cols) || y.size() != size_t(this->num_rows))
+        throw cusp::invalid_input_exception("array dimensions do not match the operator");
+
+    if (this->num_rows == 0)
+        return;
+
+    detail::apply_stencil(stencil,
+                          thrust::raw_pointer_cast(&x[0]),
+                          thrust::raw_pointer_cast(&y[0]),
+                          MemorySpace());
+}
+
+} // end namespace cusp
@@ -0,0 +1,308 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+#pragma once
+
+#include <cusp/detail/config.h>
+#include <cusp/memory.h>
+
+#include <cusp/detail/device/stream.h>
+
+#include <thrust/copy.h>
+#include <thrust/fill.h>
+#include <thrust/for_each.h>
+#include <thrust/reduce.h>
+#include <thrust/transform.h>
+#include <thrust/transform_reduce.h>
+#include <thrust/inner_product.h>
+#include <thrust/iterator/iterator_traits.h>
+
+#if THRUST_VERSION >= 100800 && THRUST_DEVICE_SYSTEM == THRUST_DEVICE_SYSTEM_CUDA
+#include <thrust/system/cuda/execution_policy.h>
+#endif
+
+#if THRUST_VERSION >= 100700 && defined(_OPENMP) && THRUST_HOST_SYSTEM != THRUST_HOST_SYSTEM_OMP
+#define __CUSP_USE_HOST_POLICY__
+#include <thrust/system/omp/execution_policy.h>
+#endif
+
+// Thin wrappers around the Thrust algorithms used on the solver paths.
+// Device iterators are processed on cusp::detail::device::current_stream()
+// when Thrust supports execution policies with streams (v1.8 and above with
+// the CUDA device system).  Host iterators are processed by Thrust's OpenMP
+// system when the host compiler has OpenMP enabled (v1.7 and above), and
+// other memory spaces use the plain Thrust algorithm.
+
+// Thrust 1.16 and above block on the stream at the end of each algorithm
+// unless par_nosync is used, which would also break stream capture.
+
+#if THRUST_VERSION >= 101600 && THRUST_DEVICE_SYSTEM == THRUST_DEVICE_SYSTEM_CUDA
+#define __CUSP_STREAM_POLICY thrust::cuda::par_nosync.on(cusp::detail::device::current_stream()),
+#elif THRUST_VERSION >= 100800 && THRUST_DEVICE_SYSTEM == THRUST_DEVICE_SYSTEM_CUDA
+#define __CUSP_STREAM_POLICY thrust::cuda::par.on(cusp::detail::device::current_stream()),
+#else
+#define __CUSP_STREAM_POLICY
+#endif
+
+namespace cusp
+{
+namespace detail
+{
+namespace stream
+{
+
+template <typename Iterator>
+struct iterator_memory_space
+{
+#if THRUST_VERSION >= 100600
+    typedef typename thrust::iterator_system<Iterator>::type type;
+#else
+    typedef typename thrust::iterator_space<Iterator>::type type;
+#endif
+};
+
+// for_each
+template <typename InputIterator, typename UnaryFunction, typename MemorySpace>
+void for_each(InputIterator first, InputIterator last, UnaryFunction f, MemorySpace)
+{
+    thrust::for_each(first, last, f);
+}
+
+template <typename InputIterator, typename UnaryFunction>
+void for_each(InputIterator first, InputIterator last, UnaryFunction f, cusp::device_memory)
+{
+    thrust::for_each(__CUSP_STREAM_POLICY first, last, f);
+}
+
+#ifdef __CUSP_USE_HOST_POLICY__
+template <typename InputIterator, typename UnaryFunction>
+void for_each(InputIterator first, InputIterator last, UnaryFunction f, cusp::host_memory)
+{
+    thrust::for_each(thrust::omp::par, first, last, f);
+}
+#endif
+
+template <typename InputIterator, typename UnaryFunction>
+void for_each(InputIterator first, InputIterator last, UnaryFunction f)
+{
+    cusp::detail::stream::for_each(first, last, f, typename iterator_memory_space<InputIterator>::type());
+}
+
+// unary transform
+template <typename InputIterator, typename OutputIterator, typename UnaryFunction, typename MemorySpace>
+OutputIterator transform(InputIterator first, InputIterator last, OutputIterator result, UnaryFunction op, MemorySpace)
+{
+    return thrust::transform(first, last, result, op);
+}
+
+template <typename InputIterator, typename OutputIterator, typename UnaryFunction>
+OutputIterator transform(InputIterator first, InputIterator last, OutputIterator result, UnaryFunction op, cusp::device_memory)
+{
+    return thrust::transform(__CUSP_STREAM_POLICY first, last, result, op);
+}
+
+#ifdef __CUSP_USE_HOST_POLICY__
+template <typename InputIterator, typename OutputIterator, typename UnaryFunction>
+OutputIterator transform(InputIterator first, InputIterator last, OutputIterator result, UnaryFunction op, cusp::host_memory)
+{
+    return thrust::transform(thrust::omp::par, first, last, result, op);
+}
+#endif
+
+template <typename InputIterator, typename OutputIterator, typename UnaryFunction>
+OutputIterator transform(InputIterator first, InputIterator last, OutputIterator result, UnaryFunction op)
+{
+    return cusp::detail::stream::transform(first, last, result, op, typename iterator_memory_space<OutputIterator>::type());
+}
+
+// binary transform
+template <typename InputIterator1, typename InputIterator2, typename OutputIterator, typename BinaryFunction, typename MemorySpace>
+OutputIterator transform(InputIterator1 first1, InputIterator1 last1, InputIterator2 first2, OutputIterator result, BinaryFunction op, MemorySpace)
+{
+    return thrust::transform(first1, last1, first2, result, op);
+}
+
+template <typename InputIterator1, typename InputIterator2, typename OutputIterator, typename BinaryFunction>
+OutputIterator transform(InputIterator1 first1, InputIterator1 last1, InputIterator2 first2, OutputIterator result, BinaryFunction op, cusp::device_memory)
+{
+    return thrust::transform(__CUSP_STREAM_POLICY first1, last1, first2, result, op);
+}
+
+#ifdef __CUSP_USE_HOST_POLICY__
+template <typename InputIterator1, typename InputIterator2, typename OutputIterator, typename BinaryFunction>
+OutputIterator transform(InputIterator1 first1, InputIterator1 last1, InputIterator2 first2, OutputIterator result, BinaryFunction op, cusp::host_memory)
+{
+    return thrust::transform(thrust::omp::par, first1, last1, first2, result, op);
+}
+#endif
+
+template <typename InputIterator1, typename InputIterator2, typename OutputIterator, typename BinaryFunction>
+OutputIterator transform(InputIterator1 first1, InputIterator1 last1, InputIterator2 first2, OutputIterator result, BinaryFunction op)
+{
+    return cusp::detail::stream::transform(first1, last1, first2, result, op, typename iterator_memory_space<OutputIterator>::type());
+}
+
+// transform_reduce
+template <typename InputIterator, typename UnaryFunction, typename OutputType, typename BinaryFunction, typename MemorySpace>
+OutputType transform_reduce(InputIterator first, InputIterator last, UnaryFunction unary_op, OutputType init, BinaryFunction binary_op, MemorySpace)
+{
+    return thrust::transform_reduce(first, last, unary_op, init, binary_op);
+}
+
+template <typename InputIterator, typename UnaryFunction, typename OutputType, typename BinaryFunction>
+OutputType transform_reduce(InputIterator first, InputIterator last, UnaryFunction unary_op, OutputType init, BinaryFunction binary_op, cusp::device_memory)
+{
+    return thrust::transform_reduce(__CUSP_STREAM_POLICY first, last, unary_op, init, binary_op);
+}
+
+#ifdef __CUSP_USE_HOST_POLICY__
+template <typename InputIterator, typename UnaryFunction, typename OutputType, typename BinaryFunction>
+OutputType transform_reduce(InputIterator first, InputIterator last, UnaryFunction unary_op, OutputType init, BinaryFunction binary_op, cusp::host_memory)
+{
+    return thrust::transform_reduce(thrust::omp::par, first, last, unary_op, init, binary_op);
+}
+#endif
+
+template <typename InputIterator, typename UnaryFunction, typename OutputType, typename BinaryFunction>
+OutputType transform_reduce(InputIterator first, InputIterator last, UnaryFunction unary_op, OutputType init, BinaryFunction binary_op)
+{
+    return cusp::detail::stream::transform_reduce(first, last, unary_op, init, binary_op, typename iterator_memory_space<InputIterator>::type());
+}
+
+// inner_product
+template <typename InputIterator1, typename InputIterator2, typename OutputType, typename MemorySpace>
+OutputType inner_product(InputIterator1 first1, InputIterator1 last1, InputIterator2 first2, OutputType init, MemorySpace)
+{
+    return thrust::inner_product(first1, last1, first2, init);
+}
+
+template <typename InputIterator1, typename InputIterator2, typename OutputType>
+OutputType inner_product(InputIterator1 first1, InputIterator1 last1, InputIterator2 first2, OutputType init, cusp::device_memory)
+{
+    return thrust::inner_product(__CUSP_STREAM_POLICY first1, last1, first2, init);
+}
+
+#ifdef __CUSP_USE_HOST_POLICY__
+template <typename InputIterator1, typename InputIterator2, typename OutputType>
+OutputType inner_product(InputIterator1 first1, InputIterator1 last1, InputIterator2 first2, OutputType init, cusp::host_memory)
+{
+    return thrust::inner_product(thrust::omp::par, first1, last1, first2, init);
+}
+#endif
+
+template <typename InputIterator1, typename InputIterator2, typename OutputType>
+OutputType inner_product(InputIterator1 first1, InputIterator1 last1, InputIterator2 first2, OutputType init)
+{
+    return cusp::detail::stream::inner_product(first1, last1, first2, init, typename iterator_memory_space<InputIterator1>::type());
+}
+
+// fill
+template <typename ForwardIterator, typename T, typename MemorySpace>
+void fill(ForwardIterator first, ForwardIterator last, const T& value, MemorySpace)
+{
+    thrust::fill(first, last, value);
+}
+
+template <typename ForwardIterator, typename T>
+void fill(ForwardIterator first, ForwardIterator last, const T& value, cusp::device_memory)
+{
+    thrust::fill(__CUSP_STREAM_POLICY first, last, value);
+}
+
+#ifdef __CUSP_USE_HOST_POLICY__
+template <typename ForwardIterator, typename T>
+void fill(ForwardIterator first, ForwardIterator last, const T& value, cusp::host_memory)
+{
+    thrust::fill(thrust::omp::par, first, last, value);
+}
+#endif
+
+template <typename ForwardIterator, typename T>
+void fill(ForwardIterator first, ForwardIterator last, const T& value)
+{
+    cusp::detail::stream::fill(first, last, value, typename iterator_memory_space<ForwardIterator>::type());
+}
+
+// copy (within one memory space)
+template <typename InputIterator, typename OutputIterator, typename MemorySpace>
+OutputIterator copy(InputIterator first, InputIterator last, OutputIterator result, MemorySpace, MemorySpace)
+{
+    return thrust::copy(first, last, result);
+}
+
+template <typename InputIterator, typename OutputIterator>
+OutputIterator copy(InputIterator first, InputIterator last, OutputIterator result, cusp::device_memory, cusp::device_memory)
+{
+    return thrust::copy(__CUSP_STREAM_POLICY first, last, result);
+}
+
+#ifdef __CUSP_USE_HOST_POLICY__
+template <typename InputIterator, typename OutputIterator>
+OutputIterator copy(InputIterator first, InputIterator last, OutputIterator result, cusp::host_memory, cusp::host_memory)
+{
+    return thrust::copy(thrust::omp::par, first, last, result);
+}
+#endif
+
+// copy (across memory spaces)
+template <typename InputIterator, typename OutputIterator, typename MemorySpace1, typename MemorySpace2>
+OutputIterator copy(InputIterator first, InputIterator last, OutputIterator result, MemorySpace1, MemorySpace2)
+{
+    return thrust::copy(first, last, result);
+}
+
+template <typename InputIterator, typename OutputIterator>
+OutputIterator copy(InputIterator first, InputIterator last, OutputIterator result)
+{
+    return cusp::detail::stream::copy(first, last, result,
+                                      typename iterator_memory_space<InputIterator>::type(),
+                                      typename iterator_memory_space<OutputIterator>::type());
+}
+
+// reduce_by_key
+template <typename InputIterator1, typename InputIterator2, typename OutputIterator1, typename OutputIterator2, typename MemorySpace>
+thrust::pair<OutputIterator1,OutputIterator2>
+reduce_by_key(InputIterator1 keys_first, InputIterator1 keys_last, InputIterator2 values_first,
+              OutputIterator1 keys_output, OutputIterator2 values_output, MemorySpace)
+{
+    return thrust::reduce_by_key(keys_first, keys_last, values_first, keys_output, values_output);
+}
+
+template <typename InputIterator1, typename InputIterator2, typename OutputIterator1, typename OutputIterator2>
+thrust::pair<OutputIterator1,OutputIterator2>
+reduce_by_key(InputIterator1 keys_first, InputIterator1 keys_last, InputIterator2 values_first,
+              OutputIterator1 keys_output, OutputIterator2 values_output, cusp::device_memory)
+{
+    return thrust::reduce_by_key(__CUSP_STREAM_POLICY keys_first, keys_last, values_first, keys_output, values_output);
+}
+
+template <typename InputIterator1, typename InputIterator2, typename OutputIterator1, typename OutputIterator2>
+thrust::pair<OutputIterator1,OutputIterator2>
+reduce_by_key(InputIterator1 keys_first, InputIterator1 keys_last, InputIterator2 values_first,
+              OutputIterator1 keys_output, OutputIterator2 values_output)
+{
+    return cusp::detail::stream::reduce_by_key(keys_first, keys_last, values_first, keys_output, values_output,
+                                               typename iterator_memory_space<InputIterator1>::type());
+}
+
+} // end namespace stream
+} // end namespace detail
+} // end namespace cusp
+
+#undef __CUSP_STREAM_POLICY
+#undef __CUSP_USE_HOST_POLICY__
+
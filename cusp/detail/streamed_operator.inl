@@ -0,0 +1,246 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include <cusp/csr_matrix.h>
+#include <cusp/exception.h>
+#include <cusp/multiply.h>
+
+#include <cusp/detail/device/stream.h>
+
+#include <thrust/copy.h>
+
+#include <algorithm>
+#include <new>
+
+namespace cusp
+{
+
+template <typename IndexType, typename ValueType>
+streamed_operator<IndexType,ValueType>
+::streamed_operator(void)
+    : Parent(), row_offsets(NULL), column_indices(NULL), values(NULL), copy_stream(0), resident(false)
+{
+    block_rows.push_back(0);
+    block_entries.push_back(0);
+
+    for (int b = 0; b < 2; b++)
+        copied[b] = consumed[b] = 0;
+}
+
+template <typename IndexType, typename ValueType>
+template <typename MatrixType>
+streamed_operator<IndexType,ValueType>
+::streamed_operator(const MatrixType& A, size_t block_bytes)
+    : Parent(A.num_rows, A.num_cols, A.num_entries),
+      row_offsets(NULL), column_indices(NULL), values(NULL), copy_stream(0), resident(false)
+{
+    CUSP_PROFILE_SCOPED();
+
+    typedef typename MatrixType::index_type MatrixIndexType;
+
+    for (int b = 0; b < 2; b++)
+        copied[b] = consumed[b] = 0;
+
+    const size_t num_rows    = A.num_rows;
+    const size_t num_entries = A.num_entries;
+
+    cusp::array1d<MatrixIndexType,cusp::host_memory> Ap(A.row_offsets);
+
+    // close a block before the row which would take it past block_bytes
+    const size_t entry_bytes = sizeof(IndexType) + sizeof(ValueType);
+
+    block_rows.push_back(0);
+    block_entries.push_back(0);
+
+    for (size_t i = 0; i < num_rows; i++)
+    {
+        const size_t r0 = block_rows.back();
+        const size_t bytes = (i + 2 - r0) * sizeof(IndexType) + size_t(Ap[i + 1] - Ap[r0]) * entry_bytes;
+
+        if (i > r0 && bytes > block_bytes)
+        {
+            block_rows.push_back(i);
+            block_entries.push_back(Ap[i]);
+        }
+    }
+
+    if (num_rows > 0)
+    {
+        block_rows.push_back(num_rows);
+        block_entries.push_back(num_entries);
+    }
+
+    const size_t blocks = num_blocks();
+
+    try
+    {
+        if (cudaMallocHost((void **) &row_offsets,    (num_rows + blocks) * sizeof(IndexType)) != cudaSuccess ||
+            cudaMallocHost((void **) &column_indices, num_entries * sizeof(IndexType)) != cudaSuccess ||
+            cudaMallocHost((void **) &values,         num_entries * sizeof(ValueType)) != cudaSuccess ||
+            cudaStreamCreateWithFlags(&copy_stream, cudaStreamNonBlocking) != cudaSuccess)
+        {
+            cudaGetLastError();
+            throw std::bad_alloc();
+        }
+
+        for (int b = 0; b < 2; b++)
+        {
+            if (cudaEventCreateWithFlags(&copied[b],   cudaEventDisableTiming) != cudaSuccess ||
+                cudaEventCreateWithFlags(&consumed[b], cudaEventDisableTiming) != cudaSuccess)
+            {
+                cudaGetLastError();
+                throw std::bad_alloc();
+            }
+        }
+
+        size_t max_rows    = 0;
+        size_t max_entries = 0;
+
+        for (size_t k = 0; k < blocks; k++)
+        {
+            const size_t r0 = block_rows[k];
+            const size_t r1 = block_rows[k + 1];
+
+            // offsets of block k, relative to its first entry
+            for (size_t i = r0; i <= r1; i++)
+                row_offsets[i + k] = IndexType(Ap[i] - Ap[r0]);
+
+            max_rows    = std::max(max_rows,    r1 - r0);
+            max_entries = std::max(max_entries, block_entries[k + 1] - block_entries[k]);
+        }
+
+        thrust::copy(A.column_indices.begin(), A.column_indices.begin() + num_entries, column_indices);
+        thrust::copy(A.values.begin(),         A.values.begin()         + num_entries, values);
+
+        for (int b = 0; b < 2 && b < int(blocks); b++)
+        {
+            buffer_offsets[b].resize(max_rows + 1);
+            buffer_indices[b].resize(max_entries);
+            buffer_values[b].resize(max_entries);
+        }
+    }
+    catch (...)
+    {
+        release();
+        throw;
+    }
+}
+
+template <typename IndexType, typename ValueType>
+streamed_operator<IndexType,ValueType>
+::~streamed_operator(void)
+{
+    release();
+}
+
+template <typename IndexType, typename ValueType>
+void streamed_operator<IndexType,ValueType>
+::release(void)
+{
+    if (copy_stream != 0)
+        cudaStreamSynchronize(copy_stream);
+
+    for (int b = 0; b < 2; b++)
+    {
+        if (copied[b]   != 0) cudaEventDestroy(copied[b]);
+        if (consumed[b] != 0) cudaEventDestroy(consumed[b]);
+    }
+
+    if (copy_stream    != 0)    cudaStreamDestroy(copy_stream);
+    if (row_offsets    != NULL) cudaFreeHost(row_offsets);
+    if (column_indices != NULL) cudaFreeHost(column_indices);
+    if (values         != NULL) cudaFreeHost(values);
+}
+
+template <typename IndexType, typename ValueType>
+size_t streamed_operator<IndexType,ValueType>
+::num_blocks(void) const
+{
+    return block_rows.size() - 1;
+}
+
+template <typename IndexType, typename ValueType>
+template <typename VectorType1, typename VectorType2>
+void streamed_operator<IndexType,ValueType>
+::operator()(const VectorType1& x, VectorType2& y) const
+{
+    CUSP_PROFILE_SCOPED();
+
+    if (x.size() != size_t(this->num_cols) || y.size() != size_t(this->num_rows))
+        throw cusp::invalid_input_exception("array dimensions do not match the operator");
+
+    if (this->num_rows == 0)
+        return;
+
+    const cudaStream_t stream = cusp::detail::device::current_stream();
+
+    typename cusp::array1d<ValueType,cusp::device_memory>::const_view x_view =
+        cusp::make_array1d_view(thrust::raw_pointer_cast(&x[0]), this->num_cols, cusp::device_memory());
+
+    ValueType * y_ptr = thrust::raw_pointer_cast(&y[0]);
+
+    const size_t blocks = num_blocks();
+
+    for (size_t k = 0; k < blocks; k++)
+    {
+        const int b = k % 2;
+
+        const size_t r0 = block_rows[k];
+        const size_t r1 = block_rows[k + 1];
+        const size_t e0 = block_entries[k];
+        const size_t e1 = block_entries[k + 1];
+
+        IndexType * Ap = thrust::raw_pointer_cast(&buffer_offsets[b][0]);
+        IndexType * Aj = e1 == e0 ? NULL : thrust::raw_pointer_cast(&buffer_indices[b][0]);
+        ValueType * Ax = e1 == e0 ? NULL : thrust::raw_pointer_cast(&buffer_values[b][0]);
+
+        // the copy of block k overlaps the multiply of block k-1 and only
+        // waits for the multiply of block k-2, which read the same buffer
+        if (!resident)
+        {
+            cudaStreamWaitEvent(copy_stream, consumed[b], 0);
+
+            cudaMemcpyAsync(Ap, row_offsets + r0 + k, (r1 - r0 + 1) * sizeof(IndexType),
+                            cudaMemcpyHostToDevice, copy_stream);
+
+            if (e1 > e0)
+            {
+                cudaMemcpyAsync(Aj, column_indices + e0, (e1 - e0) * sizeof(IndexType),
+                                cudaMemcpyHostToDevice, copy_stream);
+                cudaMemcpyAsync(Ax, values + e0, (e1 - e0) * sizeof(ValueType),
+                                cudaMemcpyHostToDevice, copy_stream);
+            }
+
+            cudaEventRecord(copied[b], copy_stream);
+        }
+
+        cudaStreamWaitEvent(stream, copied[b], 0);
+
+        typename cusp::array1d<ValueType,cusp::device_memory>::view y_view =
+            cusp::make_array1d_view(y_ptr + r0, r1 - r0, cusp::device_memory());
+
+        cusp::multiply(cusp::make_csr_matrix_view(r1 - r0, this->num_cols, e1 - e0, Ap, Aj, Ax, cusp::device_memory()),
+                       x_view, y_view);
+
+        cudaEventRecord(consumed[b], stream);
+    }
+
+    // both buffers hold the whole matrix from now on
+    if (blocks <= 2)
+        resident = true;
+}
+
+} // end namespace cusp
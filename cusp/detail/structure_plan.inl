@@ -0,0 +1,305 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include <cusp/convert.h>
+#include <cusp/copy.h>
+#include <cusp/coo_matrix.h>
+#include <cusp/csr_matrix.h>
+#include <cusp/ell_matrix.h>
+#include <cusp/exception.h>
+#include <cusp/format.h>
+#include <cusp/hyb_matrix.h>
+
+#include <thrust/copy.h>
+#include <thrust/fill.h>
+#include <thrust/functional.h>
+#include <thrust/sequence.h>
+#include <thrust/transform.h>
+#include <thrust/iterator/constant_iterator.h>
+
+namespace cusp
+{
+namespace detail
+{
+
+template <typename IndexType, typename ValueType>
+struct gather_plan_value
+{
+  const ValueType * values;
+
+  gather_plan_value(const ValueType * values)
+    : values(values) {}
+
+  __host__ __device__
+  ValueType operator()(IndexType k) const
+  {
+    return k == IndexType(-1) ? ValueType(0) : values[k];
+  }
+};
+
+// the entry values were stored as k + 1 with 0 for padding
+template <typename Array, typename IndexType, class MemorySpace>
+void record_plan_sources(const Array& entries, size_t offset,
+                         cusp::structure_plan<IndexType,MemorySpace>& plan)
+{
+  thrust::transform(entries.begin(), entries.end(),
+                    thrust::constant_iterator<IndexType>(1),
+                    plan.sources.begin() + offset,
+                    thrust::minus<IndexType>());
+}
+
+// dst[n] = values[plan.sources[offset + n]]
+template <typename Array, typename OutputIterator, typename IndexType, class MemorySpace>
+void gather_plan_values(const Array& values, size_t offset, size_t count, OutputIterator output,
+                        const cusp::structure_plan<IndexType,MemorySpace>& plan,
+                        MemorySpace, MemorySpace)
+{
+  typedef typename Array::value_type ValueType;
+
+  if (plan.num_entries == 0)
+  {
+    thrust::fill(output, output + count, ValueType(0));
+    return;
+  }
+
+  thrust::transform(plan.sources.begin() + offset, plan.sources.begin() + offset + count,
+                    output,
+                    gather_plan_value<IndexType,ValueType>(thrust::raw_pointer_cast(&values[0])));
+}
+
+template <typename Array, typename OutputIterator, typename IndexType, class MemorySpace, class MemorySpace2>
+void gather_plan_values(const Array& values, size_t offset, size_t count, OutputIterator output,
+                        const cusp::structure_plan<IndexType,MemorySpace>& plan,
+                        MemorySpace, MemorySpace2)
+{
+  typedef typename Array::value_type ValueType;
+
+  // bring the source values to the memory space of the destination
+  cusp::array1d<ValueType,MemorySpace> temp(values);
+
+  gather_plan_values(temp, offset, count, output, plan, MemorySpace(), MemorySpace());
+}
+
+/////////////////
+// Destination //
+/////////////////
+
+template <typename IndexMatrix, typename Matrix, typename IndexType, class MemorySpace>
+void convert_index_matrix(const IndexMatrix& index, Matrix& dst,
+                          cusp::structure_plan<IndexType,MemorySpace>& plan,
+                          cusp::coo_format)
+{
+  cusp::coo_matrix<IndexType,IndexType,MemorySpace> temp;
+  cusp::convert(index, temp);
+
+  dst.resize(temp.num_rows, temp.num_cols, temp.num_entries);
+  cusp::copy(temp.row_indices,    dst.row_indices);
+  cusp::copy(temp.column_indices, dst.column_indices);
+
+  plan.sources.resize(temp.values.size());
+  record_plan_sources(temp.values, 0, plan);
+}
+
+template <typename IndexMatrix, typename Matrix, typename IndexType, class MemorySpace>
+void convert_index_matrix(const IndexMatrix& index, Matrix& dst,
+                          cusp::structure_plan<IndexType,MemorySpace>& plan,
+                          cusp::csr_format)
+{
+  cusp::csr_matrix<IndexType,IndexType,MemorySpace> temp;
+  cusp::convert(index, temp);
+
+  dst.resize(temp.num_rows, temp.num_cols, temp.num_entries);
+  cusp::copy(temp.row_offsets,    dst.row_offsets);
+  cusp::copy(temp.column_indices, dst.column_indices);
+
+  plan.sources.resize(temp.values.size());
+  record_plan_sources(temp.values, 0, plan);
+}
+
+// reproduce the layout of the ELL part, including its pitch
+template <typename IndexMatrix, typename Matrix>
+void copy_ell_structure(const IndexMatrix& temp, Matrix& dst)
+{
+  size_t num_entries_per_row = temp.column_indices.num_cols;
+
+  dst.resize(temp.num_rows, temp.num_cols, temp.num_entries, num_entries_per_row);
+  dst.column_indices.resize(temp.num_rows, num_entries_per_row, temp.column_indices.pitch);
+  dst.values.resize        (temp.num_rows, num_entries_per_row, temp.values.pitch);
+
+  cusp::copy(temp.column_indices.values, dst.column_indices.values);
+}
+
+template <typename IndexMatrix, typename Matrix, typename IndexType, class MemorySpace>
+void convert_index_matrix(const IndexMatrix& index, Matrix& dst,
+                          cusp::structure_plan<IndexType,MemorySpace>& plan,
+                          cusp::ell_format)
+{
+  cusp::ell_matrix<IndexType,IndexType,MemorySpace> temp;
+  cusp::convert(index, temp);
+
+  copy_ell_structure(temp, dst);
+
+  plan.sources.resize(temp.values.values.size());
+  record_plan_sources(temp.values.values, 0, plan);
+}
+
+template <typename IndexMatrix, typename Matrix, typename IndexType, class MemorySpace>
+void convert_index_matrix(const IndexMatrix& index, Matrix& dst,
+                          cusp::structure_plan<IndexType,MemorySpace>& plan,
+                          cusp::hyb_format)
+{
+  cusp::hyb_matrix<IndexType,IndexType,MemorySpace> temp;
+  cusp::convert(index, temp);
+
+  dst.resize(temp.num_rows, temp.num_cols,
+             temp.ell.num_entries, temp.coo.num_entries,
+             temp.ell.column_indices.num_cols);
+
+  copy_ell_structure(temp.ell, dst.ell);
+
+  cusp::copy(temp.coo.row_indices,    dst.coo.row_indices);
+  cusp::copy(temp.coo.column_indices, dst.coo.column_indices);
+
+  size_t num_ell_slots = temp.ell.values.values.size();
+
+  plan.sources.resize(num_ell_slots + temp.coo.values.size());
+  record_plan_sources(temp.ell.values.values, 0,             plan);
+  record_plan_sources(temp.coo.values,        num_ell_slots, plan);
+}
+
+////////////
+// Source //
+////////////
+
+template <typename Matrix1, typename Matrix2, typename IndexType, class MemorySpace>
+void convert_with_plan(const Matrix1& src, Matrix2& dst,
+                       cusp::structure_plan<IndexType,MemorySpace>& plan,
+                       cusp::coo_format)
+{
+  // a copy of the source whose values are the entry numbers plus one
+  cusp::coo_matrix<IndexType,IndexType,MemorySpace> index(src.num_rows, src.num_cols, src.num_entries);
+  cusp::copy(src.row_indices,    index.row_indices);
+  cusp::copy(src.column_indices, index.column_indices);
+  thrust::sequence(index.values.begin(), index.values.end(), IndexType(1));
+
+  convert_index_matrix(index, dst, plan, typename Matrix2::format());
+}
+
+template <typename Matrix1, typename Matrix2, typename IndexType, class MemorySpace>
+void convert_with_plan(const Matrix1& src, Matrix2& dst,
+                       cusp::structure_plan<IndexType,MemorySpace>& plan,
+                       cusp::csr_format)
+{
+  cusp::csr_matrix<IndexType,IndexType,MemorySpace> index(src.num_rows, src.num_cols, src.num_entries);
+  cusp::copy(src.row_offsets,    index.row_offsets);
+  cusp::copy(src.column_indices, index.column_indices);
+  thrust::sequence(index.values.begin(), index.values.end(), IndexType(1));
+
+  convert_index_matrix(index, dst, plan, typename Matrix2::format());
+}
+
+////////////
+// Update //
+////////////
+
+// coo_matrix and csr_matrix
+template <typename Matrix1, typename Matrix2, typename IndexType, class MemorySpace>
+void update_entry_values(const Matrix1& src, Matrix2& dst,
+                         const cusp::structure_plan<IndexType,MemorySpace>& plan)
+{
+  if (dst.values.size() != plan.sources.size())
+    throw cusp::invalid_input_exception("destination matrix does not match the structure plan");
+
+  gather_plan_values(src.values, 0, plan.sources.size(), dst.values.begin(), plan,
+                     MemorySpace(), typename Matrix1::memory_space());
+}
+
+template <typename Matrix1, typename Matrix2, typename IndexType, class MemorySpace>
+void update_values(const Matrix1& src, Matrix2& dst,
+                   const cusp::structure_plan<IndexType,MemorySpace>& plan,
+                   cusp::coo_format)
+{
+  update_entry_values(src, dst, plan);
+}
+
+template <typename Matrix1, typename Matrix2, typename IndexType, class MemorySpace>
+void update_values(const Matrix1& src, Matrix2& dst,
+                   const cusp::structure_plan<IndexType,MemorySpace>& plan,
+                   cusp::csr_format)
+{
+  update_entry_values(src, dst, plan);
+}
+
+template <typename Matrix1, typename Matrix2, typename IndexType, class MemorySpace>
+void update_values(const Matrix1& src, Matrix2& dst,
+                   const cusp::structure_plan<IndexType,MemorySpace>& plan,
+                   cusp::ell_format)
+{
+  if (dst.values.values.size() != plan.sources.size())
+    throw cusp::invalid_input_exception("destination matrix does not match the structure plan");
+
+  gather_plan_values(src.values, 0, plan.sources.size(), dst.values.values.begin(), plan,
+                     MemorySpace(), typename Matrix1::memory_space());
+}
+
+template <typename Matrix1, typename Matrix2, typename IndexType, class MemorySpace>
+void update_values(const Matrix1& src, Matrix2& dst,
+                   const cusp::structure_plan<IndexType,MemorySpace>& plan,
+                   cusp::hyb_format)
+{
+  size_t num_ell_slots = dst.ell.values.values.size();
+  size_t num_coo_slots = dst.coo.values.size();
+
+  if (num_ell_slots + num_coo_slots != plan.sources.size())
+    throw cusp::invalid_input_exception("destination matrix does not match the structure plan");
+
+  gather_plan_values(src.values, 0,             num_ell_slots, dst.ell.values.values.begin(), plan,
+                     MemorySpace(), typename Matrix1::memory_space());
+  gather_plan_values(src.values, num_ell_slots, num_coo_slots, dst.coo.values.begin(),        plan,
+                     MemorySpace(), typename Matrix1::memory_space());
+}
+
+} // end namespace detail
+
+
+template <typename SourceType, typename DestinationType, typename IndexType, class MemorySpace>
+void convert(const SourceType& src, DestinationType& dst,
+             cusp::structure_plan<IndexType,MemorySpace>& plan)
+{
+  CUSP_PROFILE_SCOPED();
+
+  plan.num_entries = src.num_entries;
+
+  cusp::detail::convert_with_plan(src, dst, plan, typename SourceType::format());
+
+  cusp::update_values(src, dst, plan);
+}
+
+template <typename SourceType, typename DestinationType, typename IndexType, class MemorySpace>
+void update_values(const SourceType& src, DestinationType& dst,
+                   const cusp::structure_plan<IndexType,MemorySpace>& plan)
+{
+  CUSP_PROFILE_SCOPED();
+
+  if (src.num_entries != plan.num_entries)
+    throw cusp::invalid_input_exception("source matrix does not match the structure plan");
+
+  cusp::detail::update_values(src, dst, plan, typename DestinationType::format());
+}
+
+} // end namespace cusp
@@ -0,0 +1,241 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include <cusp/coo_matrix.h>
+#include <cusp/exception.h>
+
+#include <cusp/detail/functional.h>
+#include <cusp/detail/fused_dot_operator.h>
+
+#include <cusp/detail/device/spmv/symmetric.h>
+
+#include <thrust/copy.h>
+#include <thrust/count.h>
+#include <thrust/tuple.h>
+#include <thrust/iterator/zip_iterator.h>
+
+namespace cusp
+{
+namespace detail
+{
+
+// entries on or above the diagonal
+struct is_upper_entry
+{
+    template <typename Tuple>
+    __host__ __device__
+    bool operator()(const Tuple& t) const
+    {
+        return thrust::get<1>(t) >= thrust::get<0>(t);
+    }
+};
+
+template <bool Hermitian, typename Matrix, typename ValueType>
+void symmetric_multiply(const Matrix& U, const ValueType * x, ValueType * y, cusp::host_memory)
+{
+    typedef typename Matrix::index_type IndexType;
+
+    const conjugate_if<Hermitian> mirror;
+
+    for (size_t i = 0; i < U.num_rows; i++)
+        y[i] = ValueType(0);
+
+    for (size_t i = 0; i < U.num_rows; i++)
+    {
+        const ValueType x_i = x[i];
+
+        ValueType sum = ValueType(0);
+
+        for (IndexType jj = U.row_offsets[i]; jj < U.row_offsets[i + 1]; jj++)
+        {
+            const IndexType j = U.column_indices[jj];
+            const ValueType A_ij = U.values[jj];
+
+            sum += A_ij * x[j];
+
+            if (size_t(j) != i)
+                y[j] += mirror(A_ij) * x_i;
+        }
+
+        y[i] += sum;
+    }
+}
+
+template <bool Hermitian, typename Matrix, typename ValueType>
+void symmetric_multiply(const Matrix& U, const ValueType * x, ValueType * y, cusp::device_memory)
+{
+    cusp::detail::device::spmv_csr_symmetric<Hermitian>(U, x, y);
+}
+
+template <bool Hermitian, typename Matrix, typename ValueType>
+ValueType symmetric_multiply_dot(const Matrix& U, const ValueType * x, ValueType * y, cusp::host_memory)
+{
+    symmetric_multiply<Hermitian>(U, x, y, cusp::host_memory());
+
+    ValueType dot = ValueType(0);
+
+    for (size_t i = 0; i < U.num_rows; i++)
+        dot += conjugate_value(y[i]) * x[i];
+
+    return dot;
+}
+
+template <bool Hermitian, typename Matrix, typename ValueType>
+ValueType symmetric_multiply_dot(const Matrix& U, const ValueType * x, ValueType * y, cusp::device_memory)
+{
+    return cusp::detail::device::spmv_dot_csr_symmetric<Hermitian>(U, x, y);
+}
+
+// y <- A x and conj(y)^T x of the operators of the upper triangle
+template <bool Hermitian, typename Operator>
+struct symmetric_fused_dot : public thrust::detail::true_type
+{
+    template <typename Vector1, typename Vector2>
+    static typename Vector2::value_type
+    multiply_dot(const Operator& A, const Vector1& x, Vector2& y)
+    {
+        typedef typename Vector2::value_type ValueType;
+
+        if (A.num_rows == 0)
+            return ValueType(0);
+
+        return symmetric_multiply_dot<Hermitian>(A.upper,
+                                                 thrust::raw_pointer_cast(&x[0]),
+                                                 thrust::raw_pointer_cast(&y[0]),
+                                                 typename Operator::memory_space());
+    }
+};
+
+template <typename IndexType, typename ValueType, typename MemorySpace>
+struct fused_dot_operator< cusp::symmetric_csr_operator<IndexType,ValueType,MemorySpace> >
+  : public symmetric_fused_dot< false, cusp::symmetric_csr_operator<IndexType,ValueType,MemorySpace> > {};
+
+template <typename IndexType, typename ValueType, typename MemorySpace>
+struct fused_dot_operator< cusp::hermitian_csr_operator<IndexType,ValueType,MemorySpace> >
+  : public symmetric_fused_dot< true, cusp::hermitian_csr_operator<IndexType,ValueType,MemorySpace> > {};
+
+} // end namespace detail
+
+template <typename IndexType, typename ValueType, typename MemorySpace>
+symmetric_csr_operator<IndexType,ValueType,MemorySpace>
+::symmetric_csr_operator(void)
+    : Parent()
+{
+}
+
+template <typename IndexType, typename ValueType, typename MemorySpace>
+template <typename MatrixType>
+symmetric_csr_operator<IndexType,ValueType,MemorySpace>
+::symmetric_csr_operator(const MatrixType& A)
+    : Parent()
+{
+    CUSP_PROFILE_SCOPED();
+
+    if (A.num_rows != A.num_cols)
+        throw cusp::invalid_input_exception("symmetric_csr_operator requires a square matrix");
+
+    cusp::coo_matrix<IndexType,ValueType,MemorySpace> C(A);
+
+    if (!C.is_sorted_by_row())
+        C.sort_by_row();
+
+    const size_t num_upper =
+        thrust::count_if(thrust::make_zip_iterator(thrust::make_tuple(C.row_indices.begin(), C.column_indices.begin())),
+                         thrust::make_zip_iterator(thrust::make_tuple(C.row_indices.end(),   C.column_indices.end())),
+                         detail::is_upper_entry());
+
+    cusp::coo_matrix<IndexType,ValueType,MemorySpace> U(C.num_rows, C.num_cols, num_upper);
+
+    thrust::copy_if(thrust::make_zip_iterator(thrust::make_tuple(C.row_indices.begin(), C.column_indices.begin(), C.values.begin())),
+                    thrust::make_zip_iterator(thrust::make_tuple(C.row_indices.end(),   C.column_indices.end(),   C.values.end())),
+                    thrust::make_zip_iterator(thrust::make_tuple(U.row_indices.begin(), U.column_indices.begin(), U.values.begin())),
+                    detail::is_upper_entry());
+
+    upper = U;
+
+    this->resize(C.num_rows, C.num_cols, C.num_entries);
+}
+
+template <typename IndexType, typename ValueType, typename MemorySpace>
+template <typename MemorySpace2>
+symmetric_csr_operator<IndexType,ValueType,MemorySpace>
+::symmetric_csr_operator(const symmetric_csr_operator<IndexType,ValueType,MemorySpace2>& A)
+    : Parent(A.num_rows, A.num_cols, A.num_entries), upper(A.upper)
+{
+}
+
+template <typename IndexType, typename ValueType, typename MemorySpace>
+template <typename VectorType1, typename VectorType2>
+void symmetric_csr_operator<IndexType,ValueType,MemorySpace>
+::operator()(const VectorType1& x, VectorType2& y) const
+{
+    CUSP_PROFILE_SCOPED();
+
+    if (x.size() != size_t(this->num_cols) || y.size() != size_t(this->num_rows))
+        throw cusp::invalid_input_exception("array dimensions do not match the operator");
+
+    if (this->num_rows == 0)
+        return;
+
+    detail::symmetric_multiply<false>(upper,
+                                      thrust::raw_pointer_cast(&x[0]),
+                                      thrust::raw_pointer_cast(&y[0]),
+                                      MemorySpace());
+}
+
+template <typename IndexType, typename ValueType, typename MemorySpace>
+hermitian_csr_operator<IndexType,ValueType,MemorySpace>
+::hermitian_csr_operator(void)
+    : Parent()
+{
+}
+
+template <typename IndexType, typename ValueType, typename MemorySpace>
+template <typename MatrixType>
+hermitian_csr_operator<IndexType,ValueType,MemorySpace>
+::hermitian_csr_operator(const MatrixType& A)
+    : Parent(A)
+{
+}
+
+template <typename IndexType, typename ValueType, typename MemorySpace>
+template <typename MemorySpace2>
+hermitian_csr_operator<IndexType,ValueType,MemorySpace>
+::hermitian_csr_operator(const hermitian_csr_operator<IndexType,ValueType,MemorySpace2>& A)
+    : Parent(static_cast<const symmetric_csr_operator<IndexType,ValueType,MemorySpace2>&>(A))
+{
+}
+
+template <typename IndexType, typename ValueType, typename MemorySpace>
+template <typename VectorType1, typename VectorType2>
+void hermitian_csr_operator<IndexType,ValueType,MemorySpace>
+::operator()(const VectorType1& x, VectorType2& y) const
+{
+    CUSP_PROFILE_SCOPED();
+
+    if (x.size() != size_t(this->num_cols) || y.size() != size_t(this->num_rows))
+        throw cusp::invalid_input_exception("array dimensions do not match the operator");
+
+    if (this->num_rows == 0)
+        return;
+
+    detail::symmetric_multiply<true>(this->upper,
+                                     thrust::raw_pointer_cast(&x[0]),
+                                     thrust::raw_pointer_cast(&y[0]),
+                                     MemorySpace());
+}
+
+} // end namespace cusp
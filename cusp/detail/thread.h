@@ -0,0 +1,117 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+#pragma once
+
+#include <cusp/exception.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+#include <vector>
+
+// Host threads for the work which Cusp spreads over several devices, e.g.
+// one thread per device and stream in cusp::solve_scheduler.
+
+namespace cusp
+{
+namespace detail
+{
+
+// body(argument, t) for t in [0, num_threads), each on its own host
+// thread, returning once all of them have finished.  body must not throw.
+struct thread_arguments
+{
+    void (*body)(void *, size_t);
+    void * argument;
+    size_t index;
+};
+
+#if defined(_WIN32)
+inline DWORD WINAPI thread_entry(LPVOID p)
+{
+    thread_arguments * a = static_cast<thread_arguments *>(p);
+    a->body(a->argument, a->index);
+    return 0;
+}
+#else
+inline void * thread_entry(void * p)
+{
+    thread_arguments * a = static_cast<thread_arguments *>(p);
+    a->body(a->argument, a->index);
+    return NULL;
+}
+#endif
+
+inline void run_threads(size_t num_threads, void (*body)(void *, size_t), void * argument)
+{
+    std::vector<thread_arguments> arguments(num_threads);
+
+#if defined(_WIN32)
+    std::vector<HANDLE> threads(num_threads, (HANDLE) NULL);
+#else
+    std::vector<pthread_t> threads(num_threads);
+    std::vector<bool> started(num_threads, false);
+#endif
+
+    size_t failed = num_threads;
+
+    for (size_t t = 0; t < num_threads; t++)
+    {
+        arguments[t].body     = body;
+        arguments[t].argument = argument;
+        arguments[t].index    = t;
+
+#if defined(_WIN32)
+        threads[t] = CreateThread(NULL, 0, thread_entry, &arguments[t], 0, NULL);
+
+        if (threads[t] == NULL)
+#else
+        started[t] = pthread_create(&threads[t], NULL, thread_entry, &arguments[t]) == 0;
+
+        if (!started[t])
+#endif
+        {
+            failed = t;
+            break;
+        }
+    }
+
+    // wait for the threads which did start before reporting the failure
+    for (size_t t = 0; t < num_threads; t++)
+    {
+#if defined(_WIN32)
+        if (threads[t] != NULL)
+        {
+            WaitForSingleObject(threads[t], INFINITE);
+            CloseHandle(threads[t]);
+        }
+#else
+        if (started[t])
+            pthread_join(threads[t], NULL);
+#endif
+    }
+
+    if (failed < num_threads)
+        throw cusp::runtime_exception("unable to create a host thread");
+}
+
+} // end namespace detail
+} // end namespace cusp
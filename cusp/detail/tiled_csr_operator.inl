@@ -0,0 +1,239 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include <cusp/csr_matrix.h>
+#include <cusp/exception.h>
+#include <cusp/detail/format_utils.h>
+
+#include <cusp/detail/device/spmv/tiled.h>
+
+#include <thrust/copy.h>
+#include <thrust/for_each.h>
+#include <thrust/functional.h>
+#include <thrust/gather.h>
+#include <thrust/scan.h>
+#include <thrust/scatter.h>
+#include <thrust/transform.h>
+#include <thrust/iterator/counting_iterator.h>
+#include <thrust/iterator/permutation_iterator.h>
+#include <thrust/iterator/transform_iterator.h>
+
+namespace cusp
+{
+namespace detail
+{
+
+// position in tile order of the entry p in CSR order
+template <typename IndexType>
+struct tiled_csr_position
+{
+    __host__ __device__
+    IndexType operator()(const IndexType p) const
+    {
+        const IndexType W = cusp::detail::device::TILED_CSR_WIDTH;
+        const IndexType S = cusp::detail::device::TILED_CSR_DEPTH;
+
+        const IndexType q = p % (W * S);
+
+        return p - q + (q % S) * W + q / S;
+    }
+};
+
+template <typename IndexType>
+struct is_nonempty_row
+{
+    __host__ __device__
+    IndexType operator()(const IndexType length) const
+    {
+        return length > 0 ? 1 : 0;
+    }
+};
+
+template <typename IndexType>
+struct tiled_csr_lane_descriptor
+{
+    const IndexType * entry_rows;
+    const unsigned char * row_starts;
+    IndexType num_entries;
+    IndexType num_compact_rows;
+    IndexType * lane_rows;
+    unsigned int * lane_flags;
+
+    tiled_csr_lane_descriptor(const IndexType * entry_rows, const unsigned char * row_starts,
+                              const IndexType num_entries, const IndexType num_compact_rows,
+                              IndexType * lane_rows, unsigned int * lane_flags)
+        : entry_rows(entry_rows), row_starts(row_starts),
+          num_entries(num_entries), num_compact_rows(num_compact_rows),
+          lane_rows(lane_rows), lane_flags(lane_flags) {}
+
+    __host__ __device__
+    void operator()(const IndexType lane) const
+    {
+        const IndexType S = cusp::detail::device::TILED_CSR_DEPTH;
+        const IndexType first = lane * S;
+
+        lane_rows[lane] = first < num_entries ? entry_rows[first] : num_compact_rows;
+
+        // the padding after the last entry counts as row starts
+        unsigned int flags = 0;
+
+        for (IndexType s = 0; s <= S; s++)
+            if (first + s >= num_entries || row_starts[first + s])
+                flags |= 1u << s;
+
+        lane_flags[lane] = flags;
+    }
+};
+
+template <typename Matrix, typename ValueType>
+void tiled_csr_multiply(const Matrix& A, const ValueType * x, ValueType * y, cusp::host_memory)
+{
+    typedef typename Matrix::index_type IndexType;
+
+    for (size_t i = 0; i < A.num_rows; i++)
+        y[i] = ValueType(0);
+
+    const IndexType num_lanes = A.lane_rows.size();
+
+    for (IndexType lane = 0; lane < num_lanes; lane++)
+        cusp::detail::device::tiled_csr_lane(lane, IndexType(A.num_compact_rows),
+                                             &A.lane_rows[0], &A.lane_flags[0],
+                                             A.row_map.empty() ? NULL : &A.row_map[0],
+                                             &A.column_indices[0], &A.values[0], x, y);
+}
+
+template <typename Matrix, typename ValueType>
+void tiled_csr_multiply(const Matrix& A, const ValueType * x, ValueType * y, cusp::device_memory)
+{
+    cusp::detail::device::spmv_tiled_csr(A, x, y);
+}
+
+} // end namespace detail
+
+template <typename IndexType, typename ValueType, typename MemorySpace>
+tiled_csr_operator<IndexType,ValueType,MemorySpace>
+::tiled_csr_operator(void)
+    : Parent(), num_compact_rows(0)
+{
+}
+
+template <typename IndexType, typename ValueType, typename MemorySpace>
+template <typename MatrixType>
+tiled_csr_operator<IndexType,ValueType,MemorySpace>
+::tiled_csr_operator(const MatrixType& A)
+    : Parent(), num_compact_rows(0)
+{
+    CUSP_PROFILE_SCOPED();
+
+    const IndexType TILE_SIZE = cusp::detail::device::TILED_CSR_WIDTH * cusp::detail::device::TILED_CSR_DEPTH;
+
+    cusp::csr_matrix<IndexType,ValueType,MemorySpace> B(A);
+
+    const IndexType num_rows    = B.num_rows;
+    const IndexType num_entries = B.num_entries;
+
+    this->resize(B.num_rows, B.num_cols, B.num_entries);
+
+    if (num_entries == 0)
+        return;
+
+    // index of each row among the nonempty rows
+    cusp::array1d<IndexType,MemorySpace> row_lengths(num_rows);
+    thrust::transform(B.row_offsets.begin() + 1, B.row_offsets.end(), B.row_offsets.begin(),
+                      row_lengths.begin(), thrust::minus<IndexType>());
+
+    cusp::array1d<IndexType,MemorySpace> compact_rows(num_rows);
+    thrust::transform_exclusive_scan(row_lengths.begin(), row_lengths.end(), compact_rows.begin(),
+                                     detail::is_nonempty_row<IndexType>(), IndexType(0), thrust::plus<IndexType>());
+
+    num_compact_rows = compact_rows[num_rows - 1] + (row_lengths[num_rows - 1] > 0 ? 1 : 0);
+
+    if (num_compact_rows < size_t(num_rows))
+    {
+        row_map.resize(num_compact_rows);
+        thrust::copy_if(thrust::counting_iterator<IndexType>(0), thrust::counting_iterator<IndexType>(num_rows),
+                        row_lengths.begin(), row_map.begin(), detail::is_nonempty_row<IndexType>());
+    }
+
+    // nonempty row of each entry, and whether it is the first of its row
+    cusp::array1d<IndexType,MemorySpace> entry_rows(num_entries);
+    cusp::detail::offsets_to_indices(B.row_offsets, entry_rows);
+
+    cusp::array1d<unsigned char,MemorySpace> row_starts(num_entries);
+    thrust::transform(thrust::counting_iterator<IndexType>(0), thrust::counting_iterator<IndexType>(num_entries),
+                      thrust::make_permutation_iterator(B.row_offsets.begin(), entry_rows.begin()),
+                      row_starts.begin(), thrust::equal_to<IndexType>());
+
+    thrust::gather(entry_rows.begin(), entry_rows.end(), compact_rows.begin(), entry_rows.begin());
+
+    // entries in tile order
+    const IndexType num_padded = (num_entries + TILE_SIZE - 1) / TILE_SIZE * TILE_SIZE;
+
+    column_indices.resize(num_padded, IndexType(0));
+    values.resize(num_padded, ValueType(0));
+
+    thrust::scatter(B.column_indices.begin(), B.column_indices.end(),
+                    thrust::make_transform_iterator(thrust::counting_iterator<IndexType>(0), detail::tiled_csr_position<IndexType>()),
+                    column_indices.begin());
+    thrust::scatter(B.values.begin(), B.values.end(),
+                    thrust::make_transform_iterator(thrust::counting_iterator<IndexType>(0), detail::tiled_csr_position<IndexType>()),
+                    values.begin());
+
+    // descriptors of the lanes
+    const IndexType num_lanes = num_padded / IndexType(cusp::detail::device::TILED_CSR_DEPTH);
+
+    lane_rows.resize(num_lanes);
+    lane_flags.resize(num_lanes);
+
+    thrust::for_each(thrust::counting_iterator<IndexType>(0), thrust::counting_iterator<IndexType>(num_lanes),
+                     detail::tiled_csr_lane_descriptor<IndexType>(thrust::raw_pointer_cast(&entry_rows[0]),
+                                                                  thrust::raw_pointer_cast(&row_starts[0]),
+                                                                  num_entries, IndexType(num_compact_rows),
+                                                                  thrust::raw_pointer_cast(&lane_rows[0]),
+                                                                  thrust::raw_pointer_cast(&lane_flags[0])));
+}
+
+template <typename IndexType, typename ValueType, typename MemorySpace>
+template <typename MemorySpace2>
+tiled_csr_operator<IndexType,ValueType,MemorySpace>
+::tiled_csr_operator(const tiled_csr_operator<IndexType,ValueType,MemorySpace2>& A)
+    : Parent(A.num_rows, A.num_cols, A.num_entries),
+      column_indices(A.column_indices), values(A.values),
+      lane_rows(A.lane_rows), lane_flags(A.lane_flags), row_map(A.row_map),
+      num_compact_rows(A.num_compact_rows)
+{
+}
+
+template <typename IndexType, typename ValueType, typename MemorySpace>
+template <typename VectorType1, typename VectorType2>
+void tiled_csr_operator<IndexType,ValueType,MemorySpace>
+::operator()(const VectorType1& x, VectorType2& y) const
+{
+    CUSP_PROFILE_SCOPED();
+
+    if (x.size() != size_t(this->num_cols) || y.size() != size_t(this->num_rows))
+        throw cusp::invalid_input_exception("array dimensions do not match the operator");
+
+    if (this->num_rows == 0)
+        return;
+
+    detail::tiled_csr_multiply(*this,
+                               thrust::raw_pointer_cast(&x[0]),
+                               thrust::raw_pointer_cast(&y[0]),
+                               MemorySpace());
+}
+
+} // end namespace cusp
@@ -18,11 +18,33 @@
 
 #include <cuda.h>
 
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <sys/time.h>
+#endif
+
 namespace cusp
 {
 namespace detail
 {
 
+// host wall clock in milliseconds from an arbitrary origin, reading it
+// does not wait for the device
+inline double wall_clock_milliseconds(void)
+{
+#if defined(_WIN32)
+    LARGE_INTEGER count, frequency;
+    QueryPerformanceCounter(&count);
+    QueryPerformanceFrequency(&frequency);
+    return 1000.0 * double(count.QuadPart) / double(frequency.QuadPart);
+#else
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return 1000.0 * double(tv.tv_sec) + 0.001 * double(tv.tv_usec);
+#endif
+}
+
 class timer
 {
   public:
@@ -133,6 +155,71 @@ class timer
 
 };
 
+// measures the time between consecutive calls to lap(), with events on the
+// given stream for device work and with the host wall clock otherwise, so
+// timing host work records nothing on the device.  a disabled timer does
+// nothing and returns 0
+class lap_timer
+{
+  cudaEvent_t _start;
+  cudaEvent_t _end;
+  cudaStream_t stream;
+  bool enabled;
+  bool device;
+  double _start_milliseconds;
+
+  // not copyable
+  lap_timer(const lap_timer&);
+  lap_timer& operator=(const lap_timer&);
+
+  public:
+    lap_timer(cudaStream_t stream = 0, bool enabled = true, bool device = true)
+      : _start(NULL), _end(NULL), stream(stream), enabled(enabled), device(device),
+        _start_milliseconds(wall_clock_milliseconds())
+    {
+      if (enabled && device)
+      {
+        cudaEventCreate(&_start);
+        cudaEventCreate(&_end);
+        cudaEventRecord(_start, stream);
+      }
+    }
+
+    ~lap_timer()
+    {
+      if (enabled && device)
+      {
+        cudaEventDestroy(_start);
+        cudaEventDestroy(_end);
+      }
+    }
+
+    double lap(void)
+    {
+      if (!enabled)
+        return 0.0;
+
+      if (!device)
+      {
+        const double now = wall_clock_milliseconds();
+        const double elapsed_time = now - _start_milliseconds;
+        _start_milliseconds = now;
+        return elapsed_time;
+      }
+
+      float elapsed_time;
+      cudaEventRecord(_end, stream);
+      cudaEventSynchronize(_end);
+      cudaEventElapsedTime(&elapsed_time, _start, _end);
+
+      cudaEvent_t temp = _start;
+      _start = _end;
+      _end = temp;
+
+      return elapsed_time;
+    }
+};
+
 } // end namespace detail
 } // end namespace cusp
 
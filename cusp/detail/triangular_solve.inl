@@ -0,0 +1,231 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include <cusp/array1d.h>
+#include <cusp/coo_matrix.h>
+#include <cusp/csr_matrix.h>
+#include <cusp/exception.h>
+#include <cusp/detail/stream.h>
+
+#include <thrust/extrema.h>
+
+#include <vector>
+
+namespace cusp
+{
+namespace detail
+{
+
+// solves row i of (D + S) x = b, the rows referenced by the
+// strict part S must belong to an earlier level
+template <typename IndexType, typename ValueType>
+struct triangular_solve_row
+{
+    const IndexType * row_offsets;
+    const IndexType * column_indices;
+    const ValueType * values;
+    const ValueType * inv_diagonal;
+    const ValueType * b;
+    ValueType * x;
+
+    triangular_solve_row(const IndexType * row_offsets, const IndexType * column_indices,
+                         const ValueType * values, const ValueType * inv_diagonal,
+                         const ValueType * b, ValueType * x)
+        : row_offsets(row_offsets), column_indices(column_indices), values(values),
+          inv_diagonal(inv_diagonal), b(b), x(x) {}
+
+    __host__ __device__
+    void operator()(const IndexType row) const
+    {
+        ValueType sum = b[row];
+
+        for(IndexType jj = row_offsets[row]; jj < row_offsets[row + 1]; jj++)
+            sum -= values[jj] * x[column_indices[jj]];
+
+        x[row] = sum * inv_diagonal[row];
+    }
+};
+
+} // end namespace detail
+
+template <typename IndexType, typename ValueType, typename MemorySpace>
+template <typename MatrixType>
+triangular_solve_plan<IndexType,ValueType,MemorySpace>
+::triangular_solve_plan(const MatrixType& A,
+                        const cusp::triangle_type triangle,
+                        const cusp::diagonal_type diagonal,
+                        const bool transposed)
+{
+    CUSP_PROFILE_SCOPED();
+
+    if(A.num_rows != A.num_cols)
+        throw cusp::invalid_input_exception("matrix must be square");
+
+    const cusp::coo_matrix<IndexType,ValueType,cusp::host_memory> C(A);
+
+    const size_t N = C.num_rows;
+    const bool lower = (triangle == cusp::lower_triangle) != transposed;
+
+    cusp::array1d<ValueType,cusp::host_memory> D(N, diagonal == cusp::unit_diagonal ? ValueType(1) : ValueType(0));
+
+    // entries of the triangle by row of the solved matrix, whose rows are
+    // the columns of A when transposed
+    std::vector<size_t> row_counts(N + 1, 0);
+
+    for(size_t n = 0; n < C.num_entries; n++)
+    {
+        const IndexType i = transposed ? C.column_indices[n] : C.row_indices[n];
+        const IndexType j = transposed ? C.row_indices[n]    : C.column_indices[n];
+
+        if(lower ? j < i : j > i)
+            row_counts[i + 1]++;
+    }
+
+    for(size_t i = 0; i < N; i++)
+        row_counts[i + 1] += row_counts[i];
+
+    cusp::csr_matrix<IndexType,ValueType,cusp::host_memory> S(N, N, row_counts[N]);
+
+    for(size_t i = 0; i <= N; i++)
+        S.row_offsets[i] = row_counts[i];
+
+    for(size_t n = 0; n < C.num_entries; n++)
+    {
+        const IndexType i = transposed ? C.column_indices[n] : C.row_indices[n];
+        const IndexType j = transposed ? C.row_indices[n]    : C.column_indices[n];
+
+        if(i == j)
+        {
+            if(diagonal == cusp::stored_diagonal)
+                D[i] += C.values[n];
+        }
+        else if(lower ? j < i : j > i)
+        {
+            const size_t k = row_counts[i]++;
+            S.column_indices[k] = j;
+            S.values[k]         = C.values[n];
+        }
+    }
+
+    analyze(S, D, lower);
+}
+
+template <typename IndexType, typename ValueType, typename MemorySpace>
+void triangular_solve_plan<IndexType,ValueType,MemorySpace>
+::analyze(const cusp::csr_matrix<IndexType,ValueType,cusp::host_memory>& S,
+          const cusp::array1d<ValueType,cusp::host_memory>& diagonal,
+          const bool lower)
+{
+    const size_t N = S.num_rows;
+
+    cusp::array1d<ValueType,cusp::host_memory> h_inv_diagonal(N);
+    cusp::array1d<IndexType,cusp::host_memory> level(N);
+
+    size_t max_level = 0;
+
+    // rows are visited in the order of the substitution
+    for(size_t n = 0; n < N; n++)
+    {
+        const IndexType i = lower ? n : N - 1 - n;
+
+        if(diagonal[i] == ValueType(0))
+            throw cusp::invalid_input_exception("triangular matrix has a zero on the diagonal");
+
+        h_inv_diagonal[i] = ValueType(1) / diagonal[i];
+
+        IndexType l = 0;
+
+        for(IndexType jj = S.row_offsets[i]; jj < S.row_offsets[i + 1]; jj++)
+        {
+            const IndexType j = S.column_indices[jj];
+
+            if(lower ? j >= i : j <= i)
+                throw cusp::invalid_input_exception("matrix is not strictly triangular");
+
+            l = thrust::max(l, level[j] + 1);
+        }
+
+        level[i]  = l;
+        max_level = thrust::max(max_level, size_t(l));
+    }
+
+    // counting sort of the rows by level, rows of a level stay in order
+    level_offsets.assign(N == 0 ? 1 : max_level + 2, 0);
+
+    for(size_t i = 0; i < N; i++)
+        level_offsets[level[i] + 1]++;
+
+    for(size_t l = 1; l < level_offsets.size(); l++)
+        level_offsets[l] += level_offsets[l - 1];
+
+    std::vector<size_t> next(level_offsets.begin(), level_offsets.end() - 1);
+    cusp::array1d<IndexType,cusp::host_memory> h_level_rows(N);
+
+    for(size_t i = 0; i < N; i++)
+        h_level_rows[next[level[i]]++] = i;
+
+    strict       = S;
+    inv_diagonal = h_inv_diagonal;
+    level_rows   = h_level_rows;
+}
+
+template <typename IndexType, typename ValueType, typename MemorySpace>
+template <typename Array1, typename Array2>
+void triangular_solve_plan<IndexType,ValueType,MemorySpace>
+::solve(const Array1& b, Array2& x) const
+{
+    CUSP_PROFILE_SCOPED();
+
+    if(b.size() != strict.num_rows || x.size() != strict.num_rows)
+        throw cusp::invalid_input_exception("array dimensions do not match");
+
+    if(strict.num_rows == 0)
+        return;
+
+    cusp::detail::triangular_solve_row<IndexType,ValueType>
+        f(thrust::raw_pointer_cast(strict.row_offsets.data()),
+          strict.num_entries == 0 ? NULL : thrust::raw_pointer_cast(strict.column_indices.data()),
+          strict.num_entries == 0 ? NULL : thrust::raw_pointer_cast(strict.values.data()),
+          thrust::raw_pointer_cast(inv_diagonal.data()),
+          thrust::raw_pointer_cast(&b[0]),
+          thrust::raw_pointer_cast(&x[0]));
+
+    for(size_t l = 0; l < num_levels(); l++)
+        cusp::detail::stream::for_each(level_rows.begin() + level_offsets[l],
+                                       level_rows.begin() + level_offsets[l + 1],
+                                       f);
+}
+
+template <typename MatrixType, typename Array1, typename Array2>
+void solve_triangular(const MatrixType& A,
+                      const Array1& b,
+                            Array2& x,
+                      const cusp::triangle_type triangle,
+                      const cusp::diagonal_type diagonal,
+                      const bool transposed)
+{
+    typedef typename MatrixType::index_type   IndexType;
+    typedef typename MatrixType::value_type   ValueType;
+    typedef typename MatrixType::memory_space MemorySpace;
+
+    cusp::triangular_solve_plan<IndexType,ValueType,MemorySpace> plan(A, triangle, diagonal, transposed);
+
+    plan.solve(b, x);
+}
+
+} // end namespace cusp
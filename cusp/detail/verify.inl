@@ -16,11 +16,16 @@
 
 #include <cusp/format.h>
 #include <cusp/exception.h>
+#include <cusp/array1d.h>
+#include <cusp/detail/format_utils.h>
 
 #include <thrust/sort.h>
 #include <thrust/count.h>
 #include <thrust/extrema.h>
 #include <thrust/functional.h>
+#include <thrust/transform.h>
+#include <thrust/transform_reduce.h>
+#include <thrust/iterator/counting_iterator.h>
 
 #include <sstream>
 
@@ -47,47 +52,200 @@ index_range(const IndexVector& indices)
        *thrust::max_element(indices.begin(), indices.end()));
 }
 
+// The COO, CSR and ELL checks below run as one transform_reduce over the
+// entries instead of a min, a max and an is_sorted pass each.  Every entry
+// yields a verify_result which names the first check it fails, if any, and
+// the reduction keeps the violation of the smallest position, so the
+// message can point at the offending entry.  The same pass counts the
+// entries.
+
+enum verify_violation
+{
+    VERIFY_VALID = 0,
+    VERIFY_NEGATIVE_ROW,
+    VERIFY_ROW_OUT_OF_RANGE,
+    VERIFY_UNSORTED_ROWS,
+    VERIFY_DECREASING_OFFSETS,
+    VERIFY_NEGATIVE_COLUMN,
+    VERIFY_COLUMN_OUT_OF_RANGE
+};
+
+struct verify_result
+{
+    size_t position;
+    int    violation;
+    size_t num_entries;
+
+    __host__ __device__
+    verify_result(void)
+        : position(size_t(-1)), violation(VERIFY_VALID), num_entries(0) {}
+
+    __host__ __device__
+    verify_result(const size_t position, const int violation, const size_t num_entries)
+        : position(violation == VERIFY_VALID ? size_t(-1) : position), violation(violation),
+          num_entries(num_entries) {}
+};
+
+struct combine_verify_results
+{
+    __host__ __device__
+    verify_result operator()(const verify_result& a, const verify_result& b) const
+    {
+        const bool first = a.position < b.position || (a.position == b.position && a.violation <= b.violation);
+
+        return verify_result(first ? a.position  : b.position,
+                             first ? a.violation : b.violation,
+                             a.num_entries + b.num_entries);
+    }
+};
+
+template <typename IndexType>
+__host__ __device__
+int check_column(const IndexType j, const IndexType num_cols)
+{
+    if (j < 0)
+        return VERIFY_NEGATIVE_COLUMN;
+    if (j >= num_cols)
+        return VERIFY_COLUMN_OUT_OF_RANGE;
+    return VERIFY_VALID;
+}
+
+// entry n of a COO matrix and its order relative to entry n + 1
 template <typename IndexType>
-struct is_ell_entry
+struct check_coo_entry
 {
+    const IndexType * I;
+    const IndexType * J;
     IndexType num_rows;
-    IndexType pitch;
-    IndexType invalid_index;
+    IndexType num_cols;
+    IndexType num_entries;
+
+    check_coo_entry(const IndexType * I, const IndexType * J,
+                    const IndexType num_rows, const IndexType num_cols, const IndexType num_entries)
+        : I(I), J(J), num_rows(num_rows), num_cols(num_cols), num_entries(num_entries) {}
+
+    __host__ __device__
+    verify_result operator()(const IndexType n) const
+    {
+        const IndexType i = I[n];
+        const IndexType j = J[n];
+
+        if (i < 0)
+            return verify_result(n, VERIFY_NEGATIVE_ROW, 1);
+        if (i >= num_rows)
+            return verify_result(n, VERIFY_ROW_OUT_OF_RANGE, 1);
 
-    is_ell_entry(IndexType num_rows, IndexType pitch, IndexType invalid_index)
-        : num_rows(num_rows), pitch(pitch), invalid_index(invalid_index) {}
+        const int column = check_column(j, num_cols);
+
+        if (column != VERIFY_VALID)
+            return verify_result(n, column, 1);
+
+        if (n + 1 == num_entries)
+            return verify_result(n, VERIFY_VALID, 1);
+
+        if (I[n + 1] < i)
+            return verify_result(n + 1, VERIFY_UNSORTED_ROWS, 1);
+
+        return verify_result(n, VERIFY_VALID, 1);
+    }
+};
+
+// row i of a CSR matrix
+template <typename IndexType>
+struct check_csr_offset
+{
+    const IndexType * Ap;
+
+    check_csr_offset(const IndexType * Ap) : Ap(Ap) {}
+
+    __host__ __device__
+    verify_result operator()(const IndexType i) const
+    {
+        return verify_result(i + 1, Ap[i + 1] < Ap[i] ? VERIFY_DECREASING_OFFSETS : VERIFY_VALID, 0);
+    }
+};
+
+// entry k of a CSR matrix
+template <typename IndexType>
+struct check_csr_entry
+{
+    const IndexType * Aj;
+    IndexType num_cols;
+
+    check_csr_entry(const IndexType * Aj, const IndexType num_cols)
+        : Aj(Aj), num_cols(num_cols) {}
 
-    template <typename Tuple>
     __host__ __device__
-    bool operator()(const Tuple& t) const
+    verify_result operator()(const IndexType k) const
     {
-        IndexType n = thrust::get<0>(t);
-        IndexType j = thrust::get<1>(t);
-        return (n % pitch < num_rows) && (j != invalid_index);
+        return verify_result(k, check_column(Aj[k], num_cols), 1);
     }
 };
 
+// slot n of the padded ELL column indices
 template <typename IndexType>
-struct is_ell_entry_in_bounds
+struct check_ell_entry
 {
+    const IndexType * Aj;
     IndexType num_rows;
     IndexType num_cols;
     IndexType pitch;
     IndexType invalid_index;
 
-    is_ell_entry_in_bounds(IndexType num_rows, IndexType num_cols, IndexType pitch, IndexType invalid_index)
-        : num_rows(num_rows), num_cols(num_cols), pitch(pitch), invalid_index(invalid_index) {}
+    check_ell_entry(const IndexType * Aj, const IndexType num_rows, const IndexType num_cols,
+                    const IndexType pitch, const IndexType invalid_index)
+        : Aj(Aj), num_rows(num_rows), num_cols(num_cols), pitch(pitch), invalid_index(invalid_index) {}
 
-    template <typename Tuple>
     __host__ __device__
-    bool operator()(const Tuple& t) const
+    verify_result operator()(const IndexType n) const
     {
-        IndexType n = thrust::get<0>(t);
-        IndexType j = thrust::get<1>(t);
-        return (n % pitch < num_rows) && (j != invalid_index) && (j >= 0) && (j < num_cols);
+        const IndexType j = Aj[n];
+
+        if (n % pitch >= num_rows || j == invalid_index)
+            return verify_result();
+
+        return verify_result(n, check_column(j, num_cols), 1);
     }
 };
 
+template <typename MemorySpace, typename IndexType, typename UnaryFunction>
+verify_result reduce_verify(const IndexType n, UnaryFunction check)
+{
+    typedef thrust::counting_iterator<IndexType,MemorySpace> CountingIterator;
+
+    return thrust::transform_reduce(CountingIterator(0), CountingIterator(n),
+                                    check, verify_result(), combine_verify_results());
+}
+
+template <typename OutputStream>
+void describe_violation(OutputStream& ostream, const verify_result& result,
+                        const size_t num_rows, const size_t num_cols)
+{
+    switch (result.violation)
+    {
+        case VERIFY_NEGATIVE_ROW:
+            ostream << "row indices should be non-negative";
+            break;
+        case VERIFY_ROW_OUT_OF_RANGE:
+            ostream << "row indices should be less than num_row (" << num_rows << ")";
+            break;
+        case VERIFY_UNSORTED_ROWS:
+            ostream << "row indices should form a non-decreasing sequence";
+            break;
+        case VERIFY_DECREASING_OFFSETS:
+            ostream << "row offsets should form a non-decreasing sequence";
+            break;
+        case VERIFY_NEGATIVE_COLUMN:
+            ostream << "column indices should be non-negative";
+            break;
+        case VERIFY_COLUMN_OUT_OF_RANGE:
+            ostream << "column indices should be less than num_cols (" << num_cols << ")";
+            break;
+    }
+
+    ostream << " (first violation at position " << result.position << ")";
+}
+
 
 ///////////////////////////////
 // Matrix-Specific Functions //
@@ -98,9 +256,11 @@ bool is_valid_matrix(const MatrixType& A,
                      OutputStream& ostream,
                      cusp::coo_format)
 {
-    typedef typename MatrixType::index_type IndexType;
+    typedef typename MatrixType::index_type   IndexType;
+    typedef typename MatrixType::memory_space MemorySpace;
 
     // we could relax some of these conditions if necessary
+
     if (A.row_indices.size() != A.num_entries)
     {
         ostream << "size of row_indices (" << A.row_indices.size() << ") "
@@ -122,40 +282,18 @@ bool is_valid_matrix(const MatrixType& A,
         return false;
     }
    
+    verify_result result;
+
     if (A.num_entries > 0)
-    {
-        // check that row indices are within [0, num_rows)
-        thrust::pair<IndexType,IndexType> min_max_row = index_range(A.row_indices);
-        if (min_max_row.first < 0)
-        {
-            ostream << "row indices should be non-negative";
-            return false;
-        }
-        if (static_cast<size_t>(min_max_row.second) >= A.num_rows)
-        {
-            ostream << "row indices should be less than num_row (" << A.num_rows << ")";
-            return false;
-        }
-        
-        // check that row_indices is a non-decreasing sequence
-        if (!thrust::is_sorted(A.row_indices.begin(), A.row_indices.end()))
-        {
-            ostream << "row indices should form a non-decreasing sequence";
-            return false;
-        }
+        result = reduce_verify<MemorySpace>(IndexType(A.num_entries),
+                                            check_coo_entry<IndexType>(thrust::raw_pointer_cast(&A.row_indices[0]),
+                                                                       thrust::raw_pointer_cast(&A.column_indices[0]),
+                                                                       A.num_rows, A.num_cols, A.num_entries));
 
-        // check that column indices are within [0, num_cols)
-        thrust::pair<IndexType,IndexType> min_max_col = index_range(A.column_indices);
-        if (min_max_col.first < 0)
-        {
-            ostream << "column indices should be non-negative";
-            return false;
-        }
-        if (static_cast<size_t>(min_max_col.second) >= A.num_cols)
-        {
-            ostream << "column indices should be less than num_cols (" << A.num_cols << ")";
-            return false;
-        }
+    if (result.violation != VERIFY_VALID)
+    {
+        describe_violation(ostream, result, A.num_rows, A.num_cols);
+        return false;
     }
 
     return true;
@@ -167,10 +305,11 @@ bool is_valid_matrix(const MatrixType& A,
                      OutputStream& ostream,
                      cusp::csr_format)
 {
-    typedef typename MatrixType::index_type IndexType;
+    typedef typename MatrixType::index_type   IndexType;
+    typedef typename MatrixType::memory_space MemorySpace;
 
     // we could relax some of these conditions if necessary
-    
+
     if (A.row_offsets.size() != A.num_rows + 1)
     {
         ostream << "size of row_offsets (" << A.row_offsets.size() << ") "
@@ -207,7 +346,68 @@ bool is_valid_matrix(const MatrixType& A,
         return false;
     }
 
+    const IndexType * Ap = thrust::raw_pointer_cast(&A.row_offsets[0]);
+
     // check that row_offsets is a non-decreasing sequence
+    verify_result result = reduce_verify<MemorySpace>(IndexType(A.num_rows), check_csr_offset<IndexType>(Ap));
+
+    if (result.violation == VERIFY_VALID && A.num_entries > 0)
+        result = reduce_verify<MemorySpace>(IndexType(A.num_entries),
+                                            check_csr_entry<IndexType>(thrust::raw_pointer_cast(&A.column_indices[0]), A.num_cols));
+
+    if (result.violation != VERIFY_VALID)
+    {
+        describe_violation(ostream, result, A.num_rows, A.num_cols);
+        return false;
+    }
+
+    return true;
+}
+
+
+template <typename MatrixType, typename OutputStream>
+bool is_valid_matrix(const MatrixType& A,
+                     OutputStream& ostream,
+                     cusp::csr16_format)
+{
+    typedef typename MatrixType::index_type   IndexType;
+    typedef typename MatrixType::memory_space MemorySpace;
+
+    if (A.row_offsets.size() != A.num_rows + 1)
+    {
+        ostream << "size of row_offsets (" << A.row_offsets.size() << ") "
+                << "should be equal to num_rows + 1 (" << (A.num_rows + 1) << ")";
+        return false;
+    }
+    
+    if (A.row_offsets.front() != IndexType(0))
+    {
+        ostream << "first value in row_offsets (" << A.row_offsets.front() << ") "
+                << "should be equal to 0";
+        return false;
+    }
+
+    if (static_cast<size_t>(A.row_offsets.back()) != A.num_entries)
+    {
+        ostream << "last value in row_offsets (" << A.row_offsets.back() << ") "
+                << "should be equal to num_entries (" << A.num_entries << ")";
+        return false;
+    }
+    
+    if (A.column_offsets.size() != A.num_entries)
+    {
+        ostream << "size of column_offsets (" << A.column_offsets.size() << ") "
+                << "should be equal to num_entries (" << A.num_entries << ")";
+        return false;
+    }
+    
+    if (A.values.size() != A.num_entries)
+    {
+        ostream << "size of values (" << A.values.size() << ") "
+                << "should be equal to num_entries (" << A.num_entries << ")";
+        return false;
+    }
+
     if (!thrust::is_sorted(A.row_offsets.begin(), A.row_offsets.end()))
     {
         ostream << "row offsets should form a non-decreasing sequence";
@@ -216,8 +416,15 @@ bool is_valid_matrix(const MatrixType& A,
 
     if (A.num_entries > 0)
     {
-        // check that column indices are within [0, num_cols)
-        thrust::pair<IndexType,IndexType> min_max = index_range(A.column_indices);
+        // decode the columns and check that they are within [0, num_cols)
+        cusp::array1d<IndexType,MemorySpace> column_indices(A.num_entries);
+        cusp::detail::offsets_to_indices(A.row_offsets, column_indices);
+        thrust::transform(column_indices.begin(), column_indices.end(),
+                          A.column_offsets.begin(),
+                          column_indices.begin(),
+                          thrust::plus<IndexType>());
+
+        thrust::pair<IndexType,IndexType> min_max = index_range(column_indices);
 
         if (min_max.first < 0)
         {
@@ -262,7 +469,8 @@ bool is_valid_matrix(const MatrixType& A,
                      OutputStream& ostream,
                      cusp::ell_format)
 {
-    typedef typename MatrixType::index_type IndexType;
+    typedef typename MatrixType::index_type   IndexType;
+    typedef typename MatrixType::memory_space MemorySpace;
 
     const IndexType invalid_index = MatrixType::invalid_index;
 
@@ -281,19 +489,81 @@ bool is_valid_matrix(const MatrixType& A,
         return false;
     }
 
-    // count true number of entries in ell structure
+    // count the true number of entries in the ell structure and check
+    // that their column indices are in [0, num_cols)
+    verify_result result;
+
+    if (A.column_indices.values.size() > 0)
+        result = reduce_verify<MemorySpace>(IndexType(A.column_indices.values.size()),
+                                            check_ell_entry<IndexType>(thrust::raw_pointer_cast(&A.column_indices.values[0]),
+                                                                       A.num_rows, A.num_cols,
+                                                                       A.column_indices.pitch, invalid_index));
+
+    if (A.num_entries != result.num_entries)
+    {
+        ostream << "number of valid column indices (" << result.num_entries << ") ";
+        ostream << "should be == num_entries (" << A.num_entries << ")";
+        return false;
+    }
+
+    if (result.violation != VERIFY_VALID)
+    {
+        describe_violation(ostream, result, A.num_rows, A.num_cols);
+        return false;
+    }
+
+    return true;
+}
+
+template <typename MatrixType, typename OutputStream>
+bool is_valid_matrix(const MatrixType& A,
+                     OutputStream& ostream,
+                     cusp::sell_format)
+{
+    typedef typename MatrixType::index_type IndexType;
+
+    const IndexType invalid_index = MatrixType::invalid_index;
+
+    if (A.slice_height == 0)
+    {
+        ostream << "slice_height should be > 0";
+        return false;
+    }
+
+    const size_t num_slices = (A.num_rows + A.slice_height - 1) / A.slice_height;
+
+    if (A.slice_offsets.size() != num_slices + 1)
+    {
+        ostream << "size of slice_offsets (" << A.slice_offsets.size() << ") ";
+        ostream << "should be equal to the number of slices + 1 (" << (num_slices + 1) << ")";
+        return false;
+    }
+
+    if (A.row_permutation.size() != A.num_rows)
+    {
+        ostream << "size of row_permutation (" << A.row_permutation.size() << ") ";
+        ostream << "should be equal to num_rows (" << A.num_rows << ")";
+        return false;
+    }
+
+    if (A.column_indices.size() != A.values.size())
+    {
+        ostream << "size of column_indices array (" << A.column_indices.size() << ") ";
+        ostream << "should agree with the values array (" << A.values.size() << ")";
+        return false;
+    }
+
+    if (A.slice_offsets[num_slices] != IndexType(A.column_indices.size()))
+    {
+        ostream << "last slice offset (" << A.slice_offsets[num_slices] << ") ";
+        ostream << "should be equal to the size of column_indices (" << A.column_indices.size() << ")";
+        return false;
+    }
+
+    // count true number of entries in sell structure
     size_t true_num_entries = 
-      thrust::count_if(thrust::make_zip_iterator
-                       (
-                           thrust::make_tuple(thrust::counting_iterator<IndexType>(0), 
-                                              A.column_indices.values.begin())
-                       ),
-                       thrust::make_zip_iterator
-                       (
-                           thrust::make_tuple(thrust::counting_iterator<IndexType>(0), 
-                                              A.column_indices.values.begin())
-                       ) + A.column_indices.values.size(),
-                       is_ell_entry<IndexType>(A.num_rows, A.column_indices.pitch, invalid_index));
+      thrust::count_if(A.column_indices.begin(), A.column_indices.end(),
+                       thrust::placeholders::_1 != invalid_index);
 
     if (A.num_entries != true_num_entries)
     {
@@ -306,17 +576,9 @@ bool is_valid_matrix(const MatrixType& A,
     {
         // check that column indices are in [0, num_cols)
         size_t num_entries_in_bounds =
-          thrust::count_if(thrust::make_zip_iterator
-                           (
-                               thrust::make_tuple(thrust::counting_iterator<IndexType>(0), 
-                                                  A.column_indices.values.begin())
-                           ),
-                           thrust::make_zip_iterator
-                           (
-                               thrust::make_tuple(thrust::counting_iterator<IndexType>(0), 
-                                                  A.column_indices.values.begin())
-                           ) + A.column_indices.values.size(),
-                           is_ell_entry_in_bounds<IndexType>(A.num_rows, A.num_cols, A.column_indices.pitch, invalid_index));
+          thrust::count_if(A.column_indices.begin(), A.column_indices.end(),
+                           thrust::placeholders::_1 >= IndexType(0) && thrust::placeholders::_1 < IndexType(A.num_cols));
+
         if (num_entries_in_bounds != true_num_entries)
         {
             ostream << "matrix contains (" << (true_num_entries - num_entries_in_bounds) << ") out-of-bounds column indices";
@@ -327,6 +589,76 @@ bool is_valid_matrix(const MatrixType& A,
     return true;
 }
 
+template <typename MatrixType, typename OutputStream>
+bool is_valid_matrix(const MatrixType& A,
+                     OutputStream& ostream,
+                     cusp::bsr_format)
+{
+    typedef typename MatrixType::index_type IndexType;
+
+    if (A.block_size == 0)
+    {
+        ostream << "block_size should be > 0";
+        return false;
+    }
+
+    if (A.num_rows % A.block_size != 0 || A.num_cols % A.block_size != 0)
+    {
+        ostream << "matrix shape (" << A.num_rows << "," << A.num_cols << ") ";
+        ostream << "should be a multiple of block_size (" << A.block_size << ")";
+        return false;
+    }
+
+    const size_t num_block_rows = A.num_rows / A.block_size;
+    const size_t num_block_cols = A.num_cols / A.block_size;
+
+    if (A.row_offsets.size() != num_block_rows + 1)
+    {
+        ostream << "size of row_offsets (" << A.row_offsets.size() << ") ";
+        ostream << "should be equal to the number of block rows + 1 (" << (num_block_rows + 1) << ")";
+        return false;
+    }
+
+    if (A.row_offsets[0] != IndexType(0) || A.row_offsets[num_block_rows] != IndexType(A.column_indices.size()))
+    {
+        ostream << "row_offsets should begin with 0 and end with the number of blocks (" << A.column_indices.size() << ")";
+        return false;
+    }
+
+    if (A.values.size() != A.column_indices.size() * A.block_size * A.block_size ||
+        A.num_entries   != A.values.size())
+    {
+        ostream << "size of values array (" << A.values.size() << ") and num_entries (" << A.num_entries << ") ";
+        ostream << "should be equal to the number of blocks times block_size^2 (" << (A.column_indices.size() * A.block_size * A.block_size) << ")";
+        return false;
+    }
+
+    if (!thrust::is_sorted(A.row_offsets.begin(), A.row_offsets.end()))
+    {
+        ostream << "row offsets should form a non-decreasing sequence";
+        return false;
+    }
+
+    if (A.column_indices.size() > 0)
+    {
+        // check that block column indices are in [0, num_block_cols)
+        thrust::pair<IndexType,IndexType> min_max = index_range(A.column_indices);
+
+        if (min_max.first < 0)
+        {
+            ostream << "block column indices should be non-negative";
+            return false;
+        }
+        if (static_cast<size_t>(min_max.second) >= num_block_cols)
+        {
+            ostream << "block column indices should be less than the number of block columns (" << num_block_cols << ")";
+            return false;
+        }
+    }
+
+    return true;
+}
+
 template <typename MatrixType, typename OutputStream>
 bool is_valid_matrix(const MatrixType& A,
                      OutputStream& ostream,
@@ -0,0 +1,244 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include <cusp/format.h>
+
+#include <cstddef>
+
+// Estimates of the bytes moved and the floating point operations performed
+// by the entry points, reported through CUSP_PROFILE_WORK.  The SpMV
+// estimates follow performance/spmv/bytes_per_spmv.h, except that COO
+// charges the output for every row instead of scanning the row indices.
+
+namespace cusp
+{
+namespace detail
+{
+
+// bytes occupied by the entries of a container or view
+template <typename Array>
+double storage_bytes(const Array& x, cusp::array1d_format)
+{
+    return double(x.size()) * sizeof(typename Array::value_type);
+}
+
+template <typename Array>
+double storage_bytes(const Array& x, cusp::array2d_format)
+{
+    return double(x.num_rows) * double(x.num_cols) * sizeof(typename Array::value_type);
+}
+
+template <typename Matrix>
+double storage_bytes(const Matrix& A, cusp::coo_format)
+{
+    return double(A.num_entries) * (2 * sizeof(typename Matrix::index_type) + sizeof(typename Matrix::value_type));
+}
+
+template <typename Matrix>
+double storage_bytes(const Matrix& A, cusp::dia_format)
+{
+    return double(A.diagonal_offsets.size()) * sizeof(typename Matrix::index_type) +
+           double(A.values.num_rows) * double(A.values.num_cols) * sizeof(typename Matrix::value_type);
+}
+
+template <typename Matrix>
+double storage_bytes(const Matrix& A, cusp::ell_format)
+{
+    return double(A.values.num_rows) * double(A.values.num_cols) *
+           (sizeof(typename Matrix::index_type) + sizeof(typename Matrix::value_type));
+}
+
+template <typename Matrix>
+double storage_bytes(const Matrix& A, cusp::hyb_format)
+{
+    return storage_bytes(A.ell, cusp::ell_format()) + storage_bytes(A.coo, cusp::coo_format());
+}
+
+// CSR and the other compressed formats: one offset per row and an index
+// and a value per entry
+template <typename Matrix>
+double storage_bytes(const Matrix& A, cusp::sparse_format)
+{
+    return double(A.num_rows + 1) * sizeof(typename Matrix::index_type) +
+           double(A.num_entries) * (sizeof(typename Matrix::index_type) + sizeof(typename Matrix::value_type));
+}
+
+template <typename Matrix>
+double storage_bytes(const Matrix& A, cusp::known_format)
+{
+    return 0.0;
+}
+
+template <typename Matrix>
+double storage_bytes(const Matrix& A, cusp::unknown_format)
+{
+    return 0.0;
+}
+
+template <typename Matrix>
+double storage_bytes(const Matrix& A)
+{
+    return storage_bytes(A, typename Matrix::format());
+}
+
+// bytes moved by y = A * x
+template <typename Matrix>
+double spmv_bytes(const Matrix& A, cusp::dia_format)
+{
+    // neglects the diagonal offsets
+    return 2.0 * sizeof(typename Matrix::value_type) * A.num_entries +  // A[i,j] and x[j]
+           2.0 * sizeof(typename Matrix::value_type) * A.num_rows;      // y[i]
+}
+
+template <typename Matrix>
+double spmv_bytes(const Matrix& A, cusp::ell_format)
+{
+    return 1.0 * sizeof(typename Matrix::value_type) * A.num_rows * A.values.num_cols +  // A[i,j] and padding
+           1.0 * sizeof(typename Matrix::index_type) * A.num_entries +                  // column index
+           1.0 * sizeof(typename Matrix::value_type) * A.num_entries +                  // x[j]
+           2.0 * sizeof(typename Matrix::value_type) * A.num_rows;                      // y[i]
+}
+
+template <typename Matrix>
+double spmv_bytes(const Matrix& A, cusp::coo_format)
+{
+    return 2.0 * sizeof(typename Matrix::index_type) * A.num_entries +  // row and column indices
+           2.0 * sizeof(typename Matrix::value_type) * A.num_entries +  // A[i,j] and x[j]
+           2.0 * sizeof(typename Matrix::value_type) * A.num_rows;      // y[i]
+}
+
+template <typename Matrix>
+double spmv_bytes(const Matrix& A, cusp::hyb_format)
+{
+    return spmv_bytes(A.ell, cusp::ell_format()) + spmv_bytes(A.coo, cusp::coo_format());
+}
+
+// CSR and the other compressed formats
+template <typename Matrix>
+double spmv_bytes(const Matrix& A, cusp::sparse_format)
+{
+    return 2.0 * sizeof(typename Matrix::index_type) * A.num_rows +     // row pointer
+           1.0 * sizeof(typename Matrix::index_type) * A.num_entries +  // column index
+           2.0 * sizeof(typename Matrix::value_type) * A.num_entries +  // A[i,j] and x[j]
+           2.0 * sizeof(typename Matrix::value_type) * A.num_rows;      // y[i]
+}
+
+template <typename Matrix>
+double spmv_bytes(const Matrix& A, cusp::array2d_format)
+{
+    return 1.0 * sizeof(typename Matrix::value_type) * A.num_rows * A.num_cols +  // A[i,j]
+           1.0 * sizeof(typename Matrix::value_type) * A.num_cols +               // x[j]
+           2.0 * sizeof(typename Matrix::value_type) * A.num_rows;                // y[i]
+}
+
+template <typename Matrix>
+double spmv_bytes(const Matrix& A, cusp::known_format)
+{
+    return 0.0;
+}
+
+template <typename Matrix>
+double spmv_bytes(const Matrix& A, cusp::unknown_format)
+{
+    return 0.0;
+}
+
+template <typename Matrix>
+double spmv_flops(const Matrix& A, cusp::unknown_format)
+{
+    return 0.0;
+}
+
+template <typename Matrix>
+double spmv_flops(const Matrix& A, cusp::known_format)
+{
+    return 2.0 * A.num_entries;
+}
+
+// work of C = A * B: SpMV when B is a vector, otherwise one pass over A
+// for every column of B
+template <typename Matrix, typename MatrixOrVector1, typename MatrixOrVector2>
+double multiply_bytes(const Matrix& A, const MatrixOrVector1& B, const MatrixOrVector2& C, cusp::array1d_format)
+{
+    return spmv_bytes(A, typename Matrix::format());
+}
+
+template <typename Matrix, typename MatrixOrVector1, typename MatrixOrVector2>
+double multiply_bytes(const Matrix& A, const MatrixOrVector1& B, const MatrixOrVector2& C, cusp::array2d_format)
+{
+    return storage_bytes(A) + storage_bytes(B) + 2.0 * storage_bytes(C);
+}
+
+template <typename Matrix, typename MatrixOrVector1, typename MatrixOrVector2>
+double multiply_bytes(const Matrix& A, const MatrixOrVector1& B, const MatrixOrVector2& C, cusp::known_format)
+{
+    return storage_bytes(A) + storage_bytes(B) + storage_bytes(C);
+}
+
+template <typename Matrix, typename MatrixOrVector1, typename MatrixOrVector2>
+double multiply_bytes(const Matrix& A, const MatrixOrVector1& B, const MatrixOrVector2& C, cusp::unknown_format)
+{
+    return 0.0;
+}
+
+template <typename Matrix, typename MatrixOrVector1, typename MatrixOrVector2>
+double multiply_bytes(const Matrix& A, const MatrixOrVector1& B, const MatrixOrVector2& C)
+{
+    return multiply_bytes(A, B, C, typename MatrixOrVector1::format());
+}
+
+template <typename Matrix, typename MatrixOrVector1>
+double multiply_flops(const Matrix& A, const MatrixOrVector1& B, cusp::array1d_format)
+{
+    return spmv_flops(A, typename Matrix::format());
+}
+
+template <typename Matrix, typename MatrixOrVector1>
+double multiply_flops(const Matrix& A, const MatrixOrVector1& B, cusp::array2d_format)
+{
+    return spmv_flops(A, typename Matrix::format()) * B.num_cols;
+}
+
+// sparse products: the flops depend on the structure of the result
+template <typename Matrix, typename MatrixOrVector1>
+double multiply_flops(const Matrix& A, const MatrixOrVector1& B, cusp::known_format)
+{
+    return 0.0;
+}
+
+template <typename Matrix, typename MatrixOrVector1>
+double multiply_flops(const Matrix& A, const MatrixOrVector1& B, cusp::unknown_format)
+{
+    return 0.0;
+}
+
+template <typename Matrix, typename MatrixOrVector1>
+double multiply_flops(const Matrix& A, const MatrixOrVector1& B)
+{
+    return multiply_flops(A, B, typename MatrixOrVector1::format());
+}
+
+// bytes of count vectors with the length and value type of x
+template <typename Array>
+double vector_bytes(const Array& x, size_t count)
+{
+    return double(count) * double(x.size()) * sizeof(typename Array::value_type);
+}
+
+} // end namespace detail
+} // end namespace cusp
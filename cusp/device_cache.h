@@ -0,0 +1,138 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+/*! \file device_cache.h
+ *  \brief Control the cache of device allocations
+ */
+
+#pragma once
+
+#include <cusp/detail/config.h>
+
+#include <cusp/memory.h>
+
+namespace cusp
+{
+
+/*! \addtogroup execution Execution
+ *  \{
+ */
+
+/*! \p device_cache_statistics : Usage of the device allocation cache
+ */
+struct device_cache_statistics
+{
+    /*! Bytes held by device containers, rounded up to the size classes */
+    size_t live_bytes;
+
+    /*! Bytes of freed blocks kept for reuse */
+    size_t cached_bytes;
+
+    /*! Allocations requested by device containers */
+    size_t allocations;
+
+    /*! Allocations served from the cache */
+    size_t hits;
+
+    /*! Calls to \c cudaMalloc */
+    size_t device_mallocs;
+
+    device_cache_statistics(void)
+        : live_bytes(0), cached_bytes(0), allocations(0), hits(0), device_mallocs(0) {}
+};
+
+/*! \p device_cache_scope : Enables or disables the cache of device
+ *  allocations while the scope is alive.
+ *
+ * Device containers (\p array1d, the matrix formats and therefore the
+ * temporaries of the conversions, the sparse products, the multilevel
+ * hierarchies and the Krylov solvers) allocate through a cache of
+ * power-of-two size classes.  A freed block stays allocated on the device
+ * and serves the next request of its size class, so repeated setups and
+ * solves stop paying for \c cudaMalloc and the device synchronization of
+ * \c cudaFree.  Reuse is stream-ordered: a block freed on the current
+ * stream (see \p stream_scope) is reused at once by requests on the same
+ * stream and by other streams once the work issued before the free has
+ * completed.  When \c cudaMalloc fails the cached blocks are released and
+ * the allocation is retried.
+ *
+ * The cache is used unless \c CUSP_NO_DEVICE_CACHE is defined when
+ * compiling.  A scope constructed with \c false turns it off at run time
+ * (releasing the cached blocks), e.g. to hand the memory to another
+ * library.  Scopes may be nested; the previous state is restored when the
+ * scope is destroyed.
+ *
+ * \note The cache is shared by all host threads and may be used by several
+ * of them at once.  A scope enables or disables it for every thread.
+ *
+ *  \code
+ *  #include <cusp/device_cache.h>
+ *  ...
+ *
+ *  {
+ *      // allocate with cudaMalloc and cudaFree directly
+ *      cusp::device_cache_scope scope(false);
+ *      cusp::krylov::cg(A, x, b, monitor);
+ *  }
+ *  \endcode
+ */
+class device_cache_scope
+{
+    public:
+    /*! Enable (\c true) or disable (\c false) the cache
+     */
+    explicit device_cache_scope(bool enable);
+
+    /*! Restore the previous state
+     */
+    ~device_cache_scope(void);
+
+    private:
+    bool previous;
+
+    // non-copyable
+    device_cache_scope(const device_cache_scope&);
+    device_cache_scope& operator=(const device_cache_scope&);
+};
+
+/*! \p trim_device_cache : Release cached blocks with \c cudaFree until at
+ *  most \p keep_bytes remain cached, largest size classes first.  Blocks
+ *  held by containers are not affected.
+ *
+ *  \param keep_bytes bytes which may stay cached
+ */
+inline void trim_device_cache(size_t keep_bytes = 0);
+
+/*! \p set_device_cache_limit : Limit the bytes kept by the cache; blocks
+ *  freed beyond the limit are released with \c cudaFree.  The default is
+ *  no limit.
+ *
+ *  \param max_cached_bytes largest number of cached bytes
+ */
+inline void set_device_cache_limit(size_t max_cached_bytes);
+
+/*! \p device_cache_usage : Statistics of the cache since the start of the
+ *  program (all zero when the cache is not compiled in)
+ */
+inline cusp::device_cache_statistics device_cache_usage(void);
+
+/*! \}
+ */
+
+} // end namespace cusp
+
+#include <cusp/detail/device_cache.inl>
@@ -159,11 +159,8 @@ class dia_matrix : public detail::matrix_base<IndexType,ValueType,MemorySpace,cu
     dia_matrix(size_t num_rows, size_t num_cols, size_t num_entries,
                size_t num_diagonals, size_t alignment = 32)
       : Parent(num_rows, num_cols, num_entries),
-        diagonal_offsets(num_diagonals)
-      {
-        // TODO use array2d constructor when it can accept pitch
-        values.resize(num_rows, num_diagonals, detail::round_up(num_rows, alignment));
-      }
+        diagonal_offsets(num_diagonals),
+        values(num_rows, num_diagonals, ValueType(0), detail::round_up(num_rows, alignment)) {}
     
     /*! Construct a \p dia_matrix from another matrix.
      *
@@ -321,6 +318,27 @@ template <typename Array1,
 dia_matrix_view<Array1,Array2,IndexType,ValueType,MemorySpace>
 make_dia_matrix_view(const dia_matrix_view<Array1,Array2,IndexType,ValueType,MemorySpace>& m);
     
+/*! \p make_dia_matrix_view : View a DIA matrix whose \p num_diagonals
+ *  diagonal offsets and \p num_rows by \p num_diagonals values (stored
+ *  column-major with leading dimension \p pitch) are in external buffers in
+ *  \p MemorySpace.  Nothing is copied; the result has the type of the
+ *  \p view (or, for const pointers, the \p const_view) of a \p dia_matrix.
+ */
+template <typename IndexType, typename ValueType, class MemorySpace>
+dia_matrix_view<typename cusp::detail::raw_array1d_view<IndexType,MemorySpace>::type,
+                array2d_view<typename cusp::detail::raw_array1d_view<ValueType,MemorySpace>::type, cusp::column_major>,
+                typename cusp::detail::raw_array1d_view<IndexType,MemorySpace>::value_type,
+                typename cusp::detail::raw_array1d_view<ValueType,MemorySpace>::value_type,
+                MemorySpace>
+make_dia_matrix_view(size_t num_rows,
+                     size_t num_cols,
+                     size_t num_entries,
+                     size_t num_diagonals,
+                     size_t pitch,
+                     IndexType * diagonal_offsets,
+                     ValueType * values,
+                     MemorySpace);
+
 template <typename IndexType, typename ValueType, class MemorySpace>
 typename dia_matrix<IndexType,ValueType,MemorySpace>::view
 make_dia_matrix_view(dia_matrix<IndexType,ValueType,MemorySpace>& m);
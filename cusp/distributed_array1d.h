@@ -0,0 +1,212 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*! \file distributed_array1d.h
+ *  \brief One-dimensional array partitioned across several devices
+ */
+
+#pragma once
+
+#include <cusp/detail/config.h>
+
+#include <cusp/array1d.h>
+#include <cusp/memory.h>
+
+#include <vector>
+
+namespace cusp
+{
+
+/*! \addtogroup arrays Arrays
+ */
+
+/*! \addtogroup distributed_containers Distributed Containers
+ *  \ingroup arrays
+ *  \{
+ */
+
+/*! \p distributed_layout : Partition of the rows [0, N) into contiguous
+ * parts which are each stored on one device.
+ *
+ * Part \c p holds the rows <tt>[offsets[p], offsets[p+1])</tt> on the
+ * device \c devices[p].  Several parts may be placed on the same device.
+ */
+struct distributed_layout
+{
+    /*! device of each part
+     */
+    std::vector<int> devices;
+
+    /*! first row of each part followed by the total number of rows
+     */
+    std::vector<size_t> offsets;
+
+    /*! Construct an empty layout.
+     */
+    distributed_layout(void)
+      : offsets(1, 0) {}
+
+    /*! Split \p N rows into one part per entry of \p devices such that
+     *  the sizes of the parts differ by at most one row.
+     *
+     *  \param N Number of rows.
+     *  \param devices Device of each part.
+     */
+    distributed_layout(size_t N, const std::vector<int>& devices);
+
+    /*! Number of parts.
+     */
+    size_t num_parts(void) const { return devices.size(); }
+
+    /*! Total number of rows.
+     */
+    size_t size(void) const { return offsets.back(); }
+
+    /*! Number of rows of part \p p.
+     */
+    size_t part_size(size_t p) const { return offsets[p + 1] - offsets[p]; }
+
+    /*! Part which holds row \p i.
+     */
+    size_t owner(size_t i) const;
+
+    bool operator==(const distributed_layout& other) const
+    {
+      return devices == other.devices && offsets == other.offsets;
+    }
+
+    bool operator!=(const distributed_layout& other) const
+    {
+      return !(*this == other);
+    }
+};
+
+/*! \p distributed_array1d : One-dimensional array whose rows are split
+ * into contiguous parts according to a \p distributed_layout.  Each part is
+ * a \p cusp::array1d allocated on the device of the part.
+ *
+ * The \p cusp::blas functions accept distributed arrays with identical
+ * layouts.  They process one part after the other on its device and
+ * reductions such as \p cusp::blas::dot are summed on the host.
+ *
+ * \tparam ValueType Type of the elements (e.g. \c float).
+ *
+ *  The following code snippet demonstrates how to distribute a vector
+ *  across two devices.
+ *
+ *  \code
+ *  #include <cusp/distributed_array1d.h>
+ *  #include <cusp/blas.h>
+ *  ...
+ *
+ *  std::vector<int> devices;
+ *  devices.push_back(0);
+ *  devices.push_back(1);
+ *
+ *  cusp::distributed_layout layout(1000, devices);
+ *
+ *  cusp::array1d<float,cusp::host_memory> x(1000, 2.0f);
+ *
+ *  // rows [0,500) are stored on device 0 and rows [500,1000) on device 1
+ *  cusp::distributed_array1d<float> d_x(layout, x);
+ *
+ *  float norm = cusp::blas::nrm2(d_x);
+ *
+ *  // copy the values back to the host
+ *  d_x.gather(x);
+ *  \endcode
+ */
+template <typename ValueType>
+class distributed_array1d
+{
+    public:
+    typedef ValueType                                     value_type;
+    typedef cusp::device_memory                           memory_space;
+    typedef cusp::array1d<ValueType,cusp::device_memory>  local_array_type;
+
+    /*! partition of the rows
+     */
+    cusp::distributed_layout layout;
+
+    /*! rows of each part, stored on the device of the part
+     */
+    std::vector<local_array_type> parts;
+
+    /*! Construct an empty array.
+     */
+    distributed_array1d(void) {}
+
+    /*! Construct an array with the given layout.
+     */
+    distributed_array1d(const cusp::distributed_layout& layout);
+
+    /*! Construct an array with the given layout whose elements are
+     *  set to \p value.
+     */
+    distributed_array1d(const cusp::distributed_layout& layout, const ValueType& value);
+
+    /*! Construct an array with the given layout from a host or device
+     *  array of length <tt>layout.size()</tt>.
+     */
+    template <typename Array>
+    distributed_array1d(const cusp::distributed_layout& layout, const Array& x);
+
+    distributed_array1d(const distributed_array1d& x);
+
+    ~distributed_array1d(void);
+
+    distributed_array1d& operator=(const distributed_array1d& x);
+
+    /*! Total number of elements.
+     */
+    size_t size(void) const { return layout.size(); }
+
+    /*! Number of parts.
+     */
+    size_t num_parts(void) const { return layout.num_parts(); }
+
+    /*! Reallocate the parts for a new layout.  The values are not preserved.
+     */
+    void resize(const cusp::distributed_layout& layout);
+
+    /*! Distribute the elements of a host or device array of length \p size().
+     */
+    template <typename Array>
+    void scatter(const Array& x);
+
+    /*! Collect the elements into a host or device array.
+     *  \p x is resized to \p size().
+     */
+    template <typename Array>
+    void gather(Array& x) const;
+
+    /*! Copy the elements of an array of the same size whose layout
+     *  differs, e.g. to collect a small vector on fewer devices.  The
+     *  overlapping ranges of the parts are copied between the devices
+     *  and the layout of this array is kept.
+     */
+    void redistribute(const distributed_array1d& x);
+
+    /*! Swap the contents of two arrays.
+     */
+    void swap(distributed_array1d& x);
+}; // class distributed_array1d
+/*! \}
+ */
+
+} // end namespace cusp
+
+#include <cusp/detail/distributed_array1d.inl>
@@ -0,0 +1,226 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*! \file distributed_matrix.h
+ *  \brief Sparse matrix partitioned by rows across several devices
+ */
+
+#pragma once
+
+#include <cusp/detail/config.h>
+
+#include <cusp/array1d.h>
+#include <cusp/coo_matrix.h>
+#include <cusp/distributed_array1d.h>
+#include <cusp/linear_operator.h>
+
+#include <cuda_runtime_api.h>
+
+#include <vector>
+
+namespace cusp
+{
+
+/*! \addtogroup distributed_containers Distributed Containers
+ *  \{
+ */
+
+/*! \p distributed_matrix : Sparse matrix whose rows are partitioned
+ * across several devices according to a \p distributed_layout.
+ *
+ * The columns are partitioned by a second layout with the same parts and
+ * devices, which is the layout of the rows for square matrices.  Each part
+ * stores the rows it owns in two blocks on its device.  The \c interior
+ * block holds the entries whose columns are owned by the same part and is
+ * stored in the \p LocalMatrix format (e.g. \p csr_matrix or
+ * \p hyb_matrix).  The \c boundary block holds the remaining entries in a
+ * \p coo_matrix whose columns index the \c halo vector, which receives the
+ * entries of \c x owned by other parts.
+ *
+ * The product <tt>y = A * x</tt>, where \c x has the layout of the columns
+ * and \c y the layout of the rows, is computed in two steps.  While every part
+ * multiplies its interior block, the owners of the halo entries gather them
+ * and copy them to the neighbouring devices with peer-to-peer transfers on
+ * a second stream.  Once its halo has arrived each part adds the product of
+ * the boundary block.
+ *
+ * \tparam LocalMatrix Device matrix type of the interior blocks
+ *         (e.g. <tt>cusp::hyb_matrix<int,float,cusp::device_memory></tt>).
+ *
+ * \note Peer access is enabled between all pairs of devices of the layout
+ *       which support it.  Several parts may share one device.
+ * \note \p cusp::krylov::cg accepts a \p distributed_matrix together with
+ *       \p distributed_array1d vectors.
+ *
+ *  The following code snippet demonstrates how to solve a Poisson problem
+ *  with the rows split across four devices.
+ *
+ *  \code
+ *  #include <cusp/hyb_matrix.h>
+ *  #include <cusp/distributed_matrix.h>
+ *  #include <cusp/krylov/cg.h>
+ *  #include <cusp/gallery/poisson.h>
+ *  ...
+ *
+ *  cusp::csr_matrix<int,float,cusp::host_memory> A;
+ *  cusp::gallery::poisson5pt(A, 1000, 1000);
+ *
+ *  std::vector<int> devices;
+ *  for (int d = 0; d < 4; d++)
+ *      devices.push_back(d);
+ *
+ *  cusp::distributed_matrix< cusp::hyb_matrix<int,float,cusp::device_memory> > d_A(A, devices);
+ *
+ *  cusp::distributed_array1d<float> x(d_A.layout, 0.0f);
+ *  cusp::distributed_array1d<float> b(d_A.layout, 1.0f);
+ *
+ *  cusp::krylov::cg(d_A, x, b);
+ *  \endcode
+ */
+template <typename LocalMatrix>
+class distributed_matrix
+  : public cusp::linear_operator<typename LocalMatrix::value_type,
+                                 cusp::device_memory,
+                                 typename LocalMatrix::index_type>
+{
+    typedef cusp::linear_operator<typename LocalMatrix::value_type,
+                                  cusp::device_memory,
+                                  typename LocalMatrix::index_type> Parent;
+    public:
+    typedef typename LocalMatrix::index_type IndexType;
+    typedef typename LocalMatrix::value_type ValueType;
+
+    typedef LocalMatrix                                            local_matrix_type;
+    typedef cusp::coo_matrix<IndexType,ValueType,cusp::device_memory> boundary_matrix_type;
+
+    /*! halo entries sent by one part to another part
+     */
+    struct message
+    {
+        size_t part;          // receiving part
+        size_t send_offset;   // first entry in the send buffer of the sender
+        size_t recv_offset;   // first entry in the halo of the receiver
+        size_t size;          // number of entries
+    };
+
+    /*! storage of the rows owned by one part
+     */
+    struct part_type
+    {
+        local_matrix_type    interior;
+        boundary_matrix_type boundary;
+
+        // entries of x owned by other parts, ordered by global column
+        mutable cusp::array1d<ValueType,cusp::device_memory> halo;
+
+        // local rows of x needed by other parts and their staging buffer
+        cusp::array1d<IndexType,cusp::device_memory>         send_indices;
+        mutable cusp::array1d<ValueType,cusp::device_memory> send_buffer;
+
+        std::vector<message> messages;   // halo entries sent to other parts
+        std::vector<size_t>  sources;    // parts which send halo entries to this part
+
+        cudaStream_t compute_stream;     // interior and boundary products
+        cudaStream_t halo_stream;        // gathering and sending of halo entries
+        cudaEvent_t  halo_sent;          // recorded after the sends of this part
+        cudaEvent_t  finished;           // recorded after the boundary product
+
+        part_type(void)
+          : compute_stream(0), halo_stream(0), halo_sent(0), finished(0) {}
+    };
+
+    /*! partition of the rows
+     */
+    cusp::distributed_layout layout;
+
+    /*! partition of the columns, with the same devices as \c layout
+     */
+    cusp::distributed_layout column_layout;
+
+    /*! storage of each part
+     */
+    std::vector<part_type> parts;
+
+    /*! Construct an empty matrix.
+     */
+    distributed_matrix(void) {}
+
+    /*! Partition a square matrix into parts of equal numbers of rows,
+     *  one on each of the given devices.  The columns are partitioned
+     *  like the rows.
+     *
+     *  \param matrix Square sparse or dense matrix on the host or device.
+     *  \param devices Device of each part.
+     */
+    template <typename MatrixType>
+    distributed_matrix(const MatrixType& matrix, const std::vector<int>& devices);
+
+    /*! Partition the rows and columns of a square matrix according
+     *  to \p layout.
+     *
+     *  \param matrix Square sparse or dense matrix on the host or device.
+     *  \param layout Partition of the rows.
+     */
+    template <typename MatrixType>
+    distributed_matrix(const MatrixType& matrix, const cusp::distributed_layout& layout);
+
+    /*! Partition a rectangular matrix according to the layouts of its rows
+     *  and columns.
+     *
+     *  \param matrix Sparse or dense matrix on the host or device.
+     *  \param layout Partition of the rows.
+     *  \param column_layout Partition of the columns.
+     *
+     *  \throws cusp::invalid_input_exception if the layouts do not match the
+     *          dimensions of the matrix or place their parts on different devices.
+     */
+    template <typename MatrixType>
+    distributed_matrix(const MatrixType& matrix,
+                       const cusp::distributed_layout& layout,
+                       const cusp::distributed_layout& column_layout);
+
+    ~distributed_matrix(void);
+
+    /*! Number of halo entries received by all parts in each product.
+     */
+    size_t num_halo_entries(void) const;
+
+    /*! Compute y = A * x.
+     *
+     *  \throws cusp::invalid_input_exception if the layout of \p x differs
+     *          from \c column_layout or the layout of \p y from \c layout.
+     */
+    void operator()(const cusp::distributed_array1d<ValueType>& x,
+                          cusp::distributed_array1d<ValueType>& y) const;
+
+    private:
+    template <typename MatrixType>
+    void initialize(const MatrixType& matrix,
+                    const cusp::distributed_layout& layout,
+                    const cusp::distributed_layout& column_layout);
+
+    void release(void);
+
+    // not copyable
+    distributed_matrix(const distributed_matrix&);
+    distributed_matrix& operator=(const distributed_matrix&);
+}; // class distributed_matrix
+/*! \}
+ */
+
+} // end namespace cusp
+
+#include <cusp/detail/distributed_matrix.inl>
@@ -0,0 +1,177 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*! \file dynamic_csr_matrix.h
+ *  \brief CSR matrix with free slots in every row for in-place updates
+ */
+
+#pragma once
+
+#include <cusp/detail/config.h>
+
+#include <cusp/array1d.h>
+#include <cusp/csr_matrix.h>
+#include <cusp/linear_operator.h>
+
+namespace cusp
+{
+
+/*! \addtogroup sparse_matrices Sparse Matrices
+ */
+
+/*! \addtogroup sparse_matrix_containers Sparse Matrix Containers
+ *  \ingroup sparse_matrices
+ *  \{
+ */
+
+/*! \p dynamic_csr_matrix : CSR matrix whose pattern changes in place
+ *
+ * Row \c i owns the slots <tt>[row_offsets[i], row_offsets[i+1])</tt> of
+ * \p column_indices and \p values, of which the first
+ * <tt>row_lengths[i]</tt> hold its entries sorted by column.  The free
+ * slots at the end of each row absorb batches of insertions, which are
+ * merged into the rows in parallel without moving any other row, and
+ * deletions simply shorten the rows.  Only a batch which overflows a row
+ * reallocates the storage, giving the rows which overflowed \p slack
+ * free slots beyond their new length.
+ *
+ * A \p dynamic_csr_matrix is a linear operator and can be multiplied as
+ * is, but the free slots cost bandwidth: \p compact copies it into a
+ * standard matrix (e.g. \p cusp::csr_matrix or \p cusp::hyb_matrix) for
+ * repeated SpMV once the pattern has settled.
+ *
+ * \tparam IndexType Type used for matrix indices (e.g. \c int).
+ * \tparam ValueType Type used for matrix values (e.g. \c float).
+ * \tparam MemorySpace A memory space (e.g. \c cusp::host_memory or cusp::device_memory)
+ *
+ *  The following code snippet refines the pattern of a matrix and then
+ *  compacts it for the solver.
+ *
+ *  \code
+ *  #include <cusp/dynamic_csr_matrix.h>
+ *  #include <cusp/hyb_matrix.h>
+ *  ...
+ *
+ *  // four free slots per row
+ *  cusp::dynamic_csr_matrix<int,float,cusp::device_memory> D(A, 4);
+ *
+ *  // new couplings (rows[n], cols[n]) with values vals[n]
+ *  D.insert(rows, cols, vals);
+ *
+ *  // couplings which disappeared
+ *  D.erase(old_rows, old_cols);
+ *
+ *  cusp::hyb_matrix<int,float,cusp::device_memory> H;
+ *  D.compact(H);
+ *  \endcode
+ */
+template <typename IndexType, typename ValueType, class MemorySpace>
+class dynamic_csr_matrix : public cusp::linear_operator<ValueType,MemorySpace,IndexType>
+{
+    typedef cusp::linear_operator<ValueType,MemorySpace,IndexType> Parent;
+  public:
+    /*! equivalent compacted container type
+     */
+    typedef typename cusp::csr_matrix<IndexType, ValueType, MemorySpace> container;
+
+    /*! First slot of every row, followed by the total number of slots.
+     */
+    cusp::array1d<IndexType, MemorySpace> row_offsets;
+
+    /*! Number of entries stored in every row.
+     */
+    cusp::array1d<IndexType, MemorySpace> row_lengths;
+
+    /*! Column indices and values of the slots.
+     */
+    cusp::array1d<IndexType, MemorySpace> column_indices;
+    cusp::array1d<ValueType, MemorySpace> values;
+
+    /*! Free slots given to a row whenever it is reallocated.
+     */
+    size_t slack;
+
+    /*! Construct an empty \p dynamic_csr_matrix.
+     */
+    dynamic_csr_matrix() : row_offsets(1, IndexType(0)), slack(0) {}
+
+    /*! Construct a \p dynamic_csr_matrix from another matrix.
+     *
+     *  \param matrix Another sparse or dense matrix in any memory space.
+     *  \param slack Free slots given to every row.
+     */
+    template <typename MatrixType>
+    dynamic_csr_matrix(const MatrixType& matrix, const size_t slack = 4);
+
+    /*! Total number of slots, used or free.
+     */
+    size_t capacity(void) const
+    {
+        return column_indices.size();
+    }
+
+    /*! Reallocate the storage with \p slack free slots in every row.
+     */
+    void reserve(const size_t slack);
+
+    /*! Insert a batch of entries.  Entries already in the matrix take the
+     *  new value; entries repeated within the batch are summed first, as in
+     *  COO assembly.
+     *
+     *  \param rows Row indices of the batch.
+     *  \param cols Column indices of the batch.
+     *  \param vals Values of the batch.
+     *  \return Number of entries added to the pattern.
+     *
+     *  \throws cusp::invalid_input_exception if an index is out of range.
+     */
+    template <typename Array1, typename Array2, typename Array3>
+    size_t insert(const Array1& rows, const Array2& cols, const Array3& vals);
+
+    /*! Remove a batch of entries.  Positions which hold no entry are
+     *  ignored.
+     *
+     *  \param rows Row indices of the batch.
+     *  \param cols Column indices of the batch.
+     *  \return Number of entries removed from the pattern.
+     */
+    template <typename Array1, typename Array2>
+    size_t erase(const Array1& rows, const Array2& cols);
+
+    /*! Copy the entries into a standard matrix without free slots.
+     *
+     *  \param matrix Output sparse or dense matrix.
+     */
+    void compact(container& matrix) const;
+
+    template <typename MatrixType>
+    void compact(MatrixType& matrix) const;
+
+    /*! Compute <tt>y = A * x</tt>.
+     */
+    template <typename VectorType1, typename VectorType2>
+    void operator()(const VectorType1& x, VectorType2& y) const;
+
+  private:
+    template <typename ArrayType>
+    void reallocate(const ArrayType& lengths, const bool all_rows);
+}; // class dynamic_csr_matrix
+/*! \}
+ */
+
+} // end namespace cusp
+
+#include <cusp/detail/dynamic_csr_matrix.inl>
@@ -0,0 +1,234 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*! \file eisenstat_walker_monitor.h
+ *  \brief Adaptive linear tolerances for inexact Newton methods
+ */
+
+#pragma once
+
+#include <cusp/detail/config.h>
+
+#include <cusp/blas.h>
+#include <cusp/monitor.h>
+
+#include <thrust/detail/type_traits.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace cusp
+{
+
+/*! \addtogroup iterative_solvers Iterative Solvers
+ *  \addtogroup monitors Monitors
+ *  \ingroup iterative_solvers
+ *  \{
+ */
+
+/*! Forcing terms of \p eisenstat_walker_monitor
+ */
+enum forcing_term_choice
+{
+  eisenstat_walker_1,  //!< how well the last linear model predicted the nonlinear residual
+  eisenstat_walker_2   //!< 0.9 times the squared reduction of the nonlinear residual
+};
+
+/*! \p eisenstat_walker_monitor : linear solver monitor for the steps of
+ * an inexact Newton method.
+ *
+ * Each Newton step k solves J_k s_k = -F(x_k) to the relative tolerance
+ * eta_k, the forcing term.  Solving far beyond the accuracy of the
+ * linear model wastes iterations while the nonlinear residual is still
+ * large, so eta_k follows the progress of the nonlinear iteration as
+ * proposed by Eisenstat and Walker:
+ *
+ *   \p eisenstat_walker_1 :
+ *     eta_k = | ||F_k|| - ||F_{k-1} + J_{k-1} s_{k-1}|| | / ||F_{k-1}||
+ *   \p eisenstat_walker_2 :
+ *     eta_k = 0.9 (||F_k|| / ||F_{k-1}||)^2
+ *
+ * Both are kept from dropping much faster than eta_{k-1}, bounded by
+ * \p max_forcing_term, and kept above 0.5 tol / ||F_k|| when a
+ * \p nonlinear_tolerance tol is given, so the last step does not solve
+ * past the accuracy the Newton iteration needs.  The first step uses
+ * \p max_forcing_term.
+ *
+ * One monitor serves every step: \p next_step takes ||F_k||, which the
+ * Newton iteration computes anyway for its own convergence test, sets
+ * the tolerance of the next solve and restarts the iteration count.
+ * ||F_{k-1} + J_{k-1} s_{k-1}|| is the last residual norm tested by the
+ * previous solve, which must therefore start from s = 0.
+ *
+ * \tparam ValueType scalar type used in the solver (e.g. \c float or \c cusp::complex<double>).
+ *
+ *  The following code snippet demonstrates the Newton loop.
+ *
+ *  \code
+ *  #include <cusp/csr_matrix.h>
+ *  #include <cusp/eisenstat_walker_monitor.h>
+ *  #include <cusp/krylov/gmres.h>
+ *
+ *  void newton(cusp::array1d<float, cusp::device_memory>& x)
+ *  {
+ *      cusp::csr_matrix<int, float, cusp::device_memory> J;
+ *      cusp::array1d<float, cusp::device_memory> F(x.size());
+ *      cusp::array1d<float, cusp::device_memory> s(x.size());
+ *
+ *      // at most 200 linear iterations per step, ||F|| <= 1e-8 overall
+ *      cusp::eisenstat_walker_monitor<float> monitor(200, 0.9, cusp::eisenstat_walker_2, 1e-8);
+ *
+ *      for (int k = 0; k < 50; k++)
+ *      {
+ *          // ... F <- -F(x), J <- F'(x) ...
+ *
+ *          float F_norm = cusp::blas::nrm2(F);
+ *          if (F_norm <= 1e-8)
+ *              break;
+ *
+ *          monitor.next_step(F_norm);
+ *
+ *          cusp::blas::fill(s, 0);
+ *          cusp::krylov::gmres(J, s, F, 50, monitor);
+ *
+ *          cusp::blas::axpy(s, x, 1);
+ *      }
+ *  }
+ *  \endcode
+ *
+ *  \see \p default_monitor
+ */
+template <typename ValueType>
+class eisenstat_walker_monitor : public default_monitor<ValueType>
+{
+    typedef typename norm_type<ValueType>::type Real;
+    typedef cusp::default_monitor<ValueType> super;
+
+    public:
+    /*! Construct an \p eisenstat_walker_monitor for a Newton iteration
+     *
+     *  \param iteration_limit maximum number of iterations of each linear solve
+     *  \param max_forcing_term upper bound of the relative tolerances
+     *  \param choice formula of the forcing terms
+     *  \param nonlinear_tolerance target of the nonlinear residual norm, or 0
+     *  \param absolute_tolerance absolute tolerance of each linear solve
+     */
+    eisenstat_walker_monitor(size_t iteration_limit = 500, Real max_forcing_term = 0.9,
+                             forcing_term_choice choice = eisenstat_walker_2,
+                             Real nonlinear_tolerance = 0, Real absolute_tolerance = 0)
+        : super(Real(0), iteration_limit, max_forcing_term, absolute_tolerance),
+          choice_(choice),
+          max_forcing_term_(max_forcing_term),
+          nonlinear_tolerance_(nonlinear_tolerance),
+          previous_norm_(0),
+          step_count_(0),
+          total_iteration_count_(0)
+    {}
+
+    /*! start the solve of the next Newton step, whose right-hand-side is
+     *  the nonlinear residual \p F
+     */
+    template <typename Vector>
+    void next_step(const Vector& F)
+    {
+        next_step(cusp::blas::nrm2(F));
+    }
+
+    /*! start the solve of the next Newton step given the precomputed
+     *  nonlinear residual norm \p F_norm
+     */
+    void next_step(const Real& F_norm)
+    {
+        using std::abs;
+        using std::pow;
+
+        const Real eta_old = super::relative_tolerance_;
+
+        Real eta = max_forcing_term_;
+
+        if (step_count_ > 0 && previous_norm_ > Real(0))
+        {
+            Real safeguard;
+
+            if (choice_ == eisenstat_walker_1)
+            {
+                // the last tested residual of the previous solve
+                const Real model_norm = super::r_norm == std::numeric_limits<Real>::max() ? previous_norm_ : super::r_norm;
+                const Real alpha = Real(0.5) * (Real(1) + std::sqrt(Real(5)));
+
+                eta = abs(F_norm - model_norm) / previous_norm_;
+                safeguard = pow(eta_old, alpha);
+            }
+            else
+            {
+                const Real ratio = F_norm / previous_norm_;
+
+                eta = Real(0.9) * ratio * ratio;
+                safeguard = Real(0.9) * eta_old * eta_old;
+            }
+
+            // no sudden drop, unless the previous term was small already
+            if (safeguard > Real(0.1))
+                eta = std::max(eta, safeguard);
+
+            // no over-solving of the last step
+            if (nonlinear_tolerance_ > Real(0) && F_norm > Real(0))
+                eta = std::max(eta, Real(0.5) * nonlinear_tolerance_ / F_norm);
+
+            eta = std::min(eta, max_forcing_term_);
+        }
+
+        total_iteration_count_ += super::iteration_count_;
+        ++step_count_;
+        previous_norm_ = F_norm;
+
+        super::relative_tolerance_ = eta;
+        super::reset(F_norm);
+    }
+
+    /*! relative tolerance of the current linear solve
+     */
+    Real forcing_term() const { return super::relative_tolerance(); }
+
+    /*! number of Newton steps started by \p next_step
+     */
+    size_t step_count() const { return step_count_; }
+
+    /*! number of linear iterations of all steps, the current one included
+     */
+    size_t total_iteration_count() const { return total_iteration_count_ + super::iteration_count(); }
+
+    protected:
+    forcing_term_choice choice_;
+    Real max_forcing_term_;
+    Real nonlinear_tolerance_;
+    Real previous_norm_;
+    size_t step_count_;
+    size_t total_iteration_count_;
+};
+/*! \}
+ */
+
+namespace detail
+{
+
+template <typename ValueType>
+struct accepts_residual_norm< cusp::eisenstat_walker_monitor<ValueType> > : thrust::detail::true_type {};
+
+} // end namespace detail
+
+} // end namespace cusp
@@ -22,6 +22,8 @@
 
 #include <cusp/detail/config.h>
 
+#include <cusp/equilibrate.h>
+
 namespace cusp
 {
 
@@ -57,6 +59,73 @@ template <typename Matrix1,
 void subtract(const Matrix1& A,
               const Matrix2& B,
                     Matrix3& C);
+
+/*! \p add : Compute the linear combination C = alpha * A + beta * B
+ *
+ *  CSR matrices are added by merging their rows, which requires sorted
+ *  column indices.  A symbolic pass counts the entries of each row of C
+ *  and a numeric pass computes them.  C contains every entry of A and B,
+ *  even where the values cancel, so its pattern depends only on the
+ *  patterns of A and B.  When \p reuse_pattern is true and C is a CSR
+ *  matrix computed by a previous call with matrices of the same patterns,
+ *  the symbolic pass is skipped and only the values of C are updated.
+ *  Other sparse formats are converted to CSR.  C must not alias A or B.
+ *
+ *  \param alpha scalar multiplying A
+ *  \param A first input matrix
+ *  \param beta scalar multiplying B
+ *  \param B second input matrix
+ *  \param C output matrix
+ *  \param reuse_pattern keep the pattern of C and compute only its values
+ */
+template <typename ScalarType,
+          typename Matrix1,
+          typename Matrix2,
+          typename Matrix3>
+void add(const ScalarType alpha,
+         const Matrix1& A,
+         const ScalarType beta,
+         const Matrix2& B,
+               Matrix3& C,
+         const bool reuse_pattern = false);
+
+/*! \p elementwise_multiply : Compute the Hadamard product <tt>C(i,j) = A(i,j) * B(i,j)</tt>
+ *
+ *  The pattern of C is the intersection of the patterns of A and B.  CSR
+ *  and COO matrices are multiplied directly on their storage by merging
+ *  the sorted columns of every row, with a symbolic pass counting the
+ *  entries of each row of C followed by a numeric pass, so the entries of
+ *  every row must be sorted by column.  Dense matrices are multiplied
+ *  entry by entry and other sparse formats are converted to CSR.  A, B
+ *  and C live in the same memory space and C must not alias A or B.
+ *
+ *  \param A first input matrix
+ *  \param B second input matrix
+ *  \param C output matrix
+ */
+template <typename Matrix1,
+          typename Matrix2,
+          typename Matrix3>
+void elementwise_multiply(const Matrix1& A,
+                          const Matrix2& B,
+                                Matrix3& C);
+
+/*! \p transform_values : Apply a function to the stored values of a matrix in place
+ *
+ *  Computes <tt>A(i,j) = op(A(i,j))</tt> for every stored entry without
+ *  changing the pattern, so entries which are not stored stay zero even
+ *  when <tt>op(0)</tt> is not.  The values are transformed where they are
+ *  stored in every format, including the padding of DIA and ELL
+ *  matrices, which the formats ignore.  Rows and columns are scaled in
+ *  place by \p cusp::scale_rows and \p cusp::scale_columns.
+ *
+ *  \param A matrix
+ *  \param op unary function applied to the values
+ */
+template <typename Matrix,
+          typename UnaryFunction>
+void transform_values(Matrix& A,
+                      UnaryFunction op);
 /*! \}
  */
 
@@ -22,6 +22,7 @@
 
 #include <cusp/detail/config.h>
 
+#include <cusp/array1d.h>
 #include <cusp/format.h>
 #include <cusp/memory.h>
 #include <cusp/detail/matrix_base.h>
@@ -158,12 +159,9 @@ class ell_matrix : public detail::matrix_base<IndexType,ValueType,MemorySpace,cu
      */
     ell_matrix(size_t num_rows, size_t num_cols, size_t num_entries,
                size_t num_entries_per_row, size_t alignment = 32)
-      : Parent(num_rows, num_cols, num_entries)
-    {
-      // TODO use array2d constructor when it can accept pitch
-      column_indices.resize(num_rows, num_entries_per_row, detail::round_up(num_rows, alignment));
-      values.resize        (num_rows, num_entries_per_row, detail::round_up(num_rows, alignment));
-    }
+      : Parent(num_rows, num_cols, num_entries),
+        column_indices(num_rows, num_entries_per_row, IndexType(0), detail::round_up(num_rows, alignment)),
+        values        (num_rows, num_entries_per_row, ValueType(0), detail::round_up(num_rows, alignment)) {}
 
     /*! Construct an \p ell_matrix from another matrix.
      *
@@ -326,6 +324,28 @@ template <typename Array1,
 ell_matrix_view<Array1,Array2,IndexType,ValueType,MemorySpace>
 make_ell_matrix_view(const ell_matrix_view<Array1,Array2,IndexType,ValueType,MemorySpace>& m);
     
+/*! \p make_ell_matrix_view : View an ELL matrix whose \p num_rows by
+ *  \p num_entries_per_row column indices and values are stored column-major,
+ *  with leading dimension \p pitch, in external buffers in \p MemorySpace.
+ *  Padding entries must hold \p ell_matrix::invalid_index.  Nothing is
+ *  copied; the result has the type of the \p view (or, for const pointers,
+ *  the \p const_view) of an \p ell_matrix.
+ */
+template <typename IndexType, typename ValueType, class MemorySpace>
+ell_matrix_view<array2d_view<typename cusp::detail::raw_array1d_view<IndexType,MemorySpace>::type, cusp::column_major>,
+                array2d_view<typename cusp::detail::raw_array1d_view<ValueType,MemorySpace>::type, cusp::column_major>,
+                typename cusp::detail::raw_array1d_view<IndexType,MemorySpace>::value_type,
+                typename cusp::detail::raw_array1d_view<ValueType,MemorySpace>::value_type,
+                MemorySpace>
+make_ell_matrix_view(size_t num_rows,
+                     size_t num_cols,
+                     size_t num_entries,
+                     size_t num_entries_per_row,
+                     size_t pitch,
+                     IndexType * column_indices,
+                     ValueType * values,
+                     MemorySpace);
+
 template <typename IndexType, typename ValueType, class MemorySpace>
 typename ell_matrix<IndexType,ValueType,MemorySpace>::view
 make_ell_matrix_view(ell_matrix<IndexType,ValueType,MemorySpace>& m);
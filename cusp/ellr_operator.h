@@ -0,0 +1,130 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+/*! \file ellr_operator.h
+ *  \brief Operator of a sparse matrix in ELLPACK-R format
+ */
+
+#pragma once
+
+#include <cusp/detail/config.h>
+
+#include <cusp/array1d.h>
+#include <cusp/linear_operator.h>
+
+namespace cusp
+{
+
+/*! \addtogroup algorithms Algorithms
+ *  \ingroup algorithms
+ *  \{
+ */
+
+/*! \p ellr_operator : Linear operator of a sparse matrix in ELLPACK-R
+ *  format, i.e. ELL with the length of every row.
+ *
+ *  The multiply of an \p ell_matrix runs every row over the width of the
+ *  longest row and loads the column index of each padding entry to find
+ *  out that it is padding.  Here each row stops after its own entries, so
+ *  the padding of the short rows is never read.  The entries of a row are
+ *  grouped in chunks of four, stored so that the thread of a row reads a
+ *  chunk with 128-bit loads and the threads of a warp read adjacent
+ *  chunks: chunk \c k of row \c i holds entries <tt>4k</tt> to
+ *  <tt>4k + 3</tt> of the row at <tt>4 (k * pitch + i)</tt>.  The last
+ *  chunk of a row is padded with column 0 and value 0.
+ *
+ *  The operator suits matrices with a moderate spread of row lengths,
+ *  such as finite element meshes, whose \p ell_matrix pads a large part
+ *  of the storage.  It can be passed to the Krylov solvers wherever a
+ *  matrix is expected.
+ *
+ * \tparam IndexType type of the column indices
+ * \tparam ValueType type of the values
+ * \tparam MemorySpace memory space of the arrays and vectors
+ *
+ *  \code
+ *  #include <cusp/ellr_operator.h>
+ *  #include <cusp/io/matrix_market.h>
+ *  #include <cusp/krylov/cg.h>
+ *
+ *  int main(void)
+ *  {
+ *      cusp::csr_matrix<int, float, cusp::device_memory> B;
+ *      cusp::io::read_matrix_market_file(B, "A.mtx");
+ *
+ *      cusp::ellr_operator<int, float, cusp::device_memory> A(B);
+ *
+ *      cusp::array1d<float, cusp::device_memory> x(A.num_rows, 0);
+ *      cusp::array1d<float, cusp::device_memory> b(A.num_rows, 1);
+ *
+ *      cusp::krylov::cg(A, x, b);
+ *
+ *      return 0;
+ *  }
+ *  \endcode
+ */
+template <typename IndexType, typename ValueType, typename MemorySpace>
+class ellr_operator : public cusp::linear_operator<ValueType,MemorySpace,IndexType>
+{
+    typedef cusp::linear_operator<ValueType,MemorySpace,IndexType> Parent;
+
+    public:
+
+    /*! Column indices in chunks of four entries per row.
+     */
+    cusp::array1d<IndexType,MemorySpace> column_indices;
+
+    /*! Values in chunks of four entries per row.
+     */
+    cusp::array1d<ValueType,MemorySpace> values;
+
+    /*! Number of entries of each row.
+     */
+    cusp::array1d<IndexType,MemorySpace> row_lengths;
+
+    /*! Distance in chunks between consecutive chunks of a row, the number
+     *  of rows rounded up to a multiple of 32.
+     */
+    size_t pitch;
+
+    /*! Construct an empty operator.
+     */
+    ellr_operator(void);
+
+    /*! Construct the operator of a matrix.
+     *
+     * \param A matrix in any format and memory space
+     */
+    template <typename MatrixType>
+    ellr_operator(const MatrixType& A);
+
+    /*! Construct a copy of an operator in another memory space.
+     */
+    template <typename MemorySpace2>
+    ellr_operator(const ellr_operator<IndexType,ValueType,MemorySpace2>& A);
+
+    /*! Compute y = A * x.
+     */
+    template <typename VectorType1, typename VectorType2>
+    void operator()(const VectorType1& x, VectorType2& y) const;
+};
+/*! \}
+ */
+
+} // end namespace cusp
+
+#include <cusp/detail/ellr_operator.inl>
@@ -0,0 +1,171 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+/*! \file ensemble_csr_operator.h
+ *  \brief Operator of an ensemble of matrices with a common sparsity pattern
+ */
+
+#pragma once
+
+#include <cusp/detail/config.h>
+
+#include <cusp/array1d.h>
+#include <cusp/linear_operator.h>
+
+namespace cusp
+{
+
+/*! \addtogroup algorithms Algorithms
+ *  \ingroup algorithms
+ *  \{
+ */
+
+/*! \p ensemble_csr_operator : Linear operator of an ensemble of matrices
+ *  which share one CSR sparsity pattern and differ in their values.
+ *
+ *  The row offsets and column indices are stored once, and the values of
+ *  the \c num_members matrices are interleaved: the value of entry \c k of
+ *  member \c e is <tt>values[k * num_members + e]</tt>.  A multiply
+ *  applies every member to its own vector in one pass, so the index
+ *  arrays are read once for the whole ensemble instead of once per
+ *  member, and one launch replaces \c num_members launches.
+ *
+ *  The vectors of the ensemble are the columns of a row-major
+ *  \p array2d with \c num_members columns, i.e. they are interleaved as
+ *  the values are: <tt>X(i,e)</tt> is entry \c i of the vector of member
+ *  \c e.  On the device the consecutive threads of a row handle
+ *  consecutive members, so the loads of the values and of \c X are
+ *  coalesced and the index loads are shared by the threads of a row.
+ *
+ *  The ensemble Krylov solvers of \p cusp/krylov/ensemble.h solve the
+ *  systems of all members together with per-member scalars.
+ *
+ * \tparam IndexType type of the row offsets and column indices
+ * \tparam ValueType type of the values
+ * \tparam MemorySpace memory space of the arrays and vectors
+ *
+ *  \code
+ *  #include <cusp/ensemble_csr_operator.h>
+ *  #include <cusp/array2d.h>
+ *  #include <cusp/multiply.h>
+ *  #include <cusp/gallery/poisson.h>
+ *
+ *  int main(void)
+ *  {
+ *      cusp::csr_matrix<int, float, cusp::device_memory> P;
+ *      cusp::gallery::poisson5pt(P, 100, 100);
+ *
+ *      // values of 16 members, one member after the other
+ *      const size_t E = 16;
+ *      cusp::array1d<float, cusp::device_memory> values(E * P.num_entries);
+ *      for (size_t e = 0; e < E; e++)
+ *          thrust::copy(P.values.begin(), P.values.end(), values.begin() + e * P.num_entries);
+ *
+ *      cusp::ensemble_csr_operator<int, float, cusp::device_memory> A(P, values, E);
+ *
+ *      cusp::array2d<float, cusp::device_memory, cusp::row_major> X(A.num_cols, E, 1);
+ *      cusp::array2d<float, cusp::device_memory, cusp::row_major> Y(A.num_rows, E);
+ *
+ *      // Y(:,e) = A_e * X(:,e) for every member e
+ *      cusp::multiply(A, X, Y);
+ *
+ *      return 0;
+ *  }
+ *  \endcode
+ */
+template <typename IndexType, typename ValueType, typename MemorySpace>
+class ensemble_csr_operator : public cusp::linear_operator<ValueType,MemorySpace,IndexType>
+{
+    typedef cusp::linear_operator<ValueType,MemorySpace,IndexType> Parent;
+
+    public:
+
+    /*! Number of matrices of the ensemble.
+     */
+    size_t num_members;
+
+    /*! Row offsets of the common pattern.
+     */
+    cusp::array1d<IndexType,MemorySpace> row_offsets;
+
+    /*! Column indices of the common pattern.
+     */
+    cusp::array1d<IndexType,MemorySpace> column_indices;
+
+    /*! Values of the members, interleaved entry by entry.
+     */
+    cusp::array1d<ValueType,MemorySpace> values;
+
+    /*! Construct an empty operator.
+     */
+    ensemble_csr_operator(void);
+
+    /*! Construct an ensemble whose members all have the values of
+     *  \p pattern.
+     *
+     * \param pattern matrix in any format and memory space
+     * \param num_members number of matrices of the ensemble
+     */
+    template <typename MatrixType>
+    ensemble_csr_operator(const MatrixType& pattern, const size_t num_members);
+
+    /*! Construct an ensemble from a pattern and the values of the members.
+     *
+     * \param pattern matrix in any format and memory space, whose entries
+     *        are in CSR order once converted
+     * \param member_values values of the members, one member after the
+     *        other, as for \p cusp::krylov::batched_block_diagonal
+     * \param num_members number of matrices of the ensemble
+     *
+     * \throws cusp::invalid_input_exception if the size of \p member_values
+     *         is not <tt>num_members * pattern.num_entries</tt>
+     */
+    template <typename MatrixType, typename ArrayType>
+    ensemble_csr_operator(const MatrixType& pattern, const ArrayType& member_values, const size_t num_members);
+
+    /*! Construct a copy of an operator in another memory space.
+     */
+    template <typename MemorySpace2>
+    ensemble_csr_operator(const ensemble_csr_operator<IndexType,ValueType,MemorySpace2>& A);
+
+    /*! Copy the values of member \p e, in CSR order, to \p member_values.
+     */
+    template <typename ArrayType>
+    void get_member(const size_t e, ArrayType& member_values) const;
+
+    /*! Replace the values of member \p e by \p member_values, in CSR order.
+     */
+    template <typename ArrayType>
+    void set_member(const size_t e, const ArrayType& member_values);
+
+    /*! Compute Y(:,e) = A_e * X(:,e) for every member \c e.
+     *
+     * \param X row-major \p array2d of size num_cols x num_members
+     * \param Y row-major \p array2d of size num_rows x num_members
+     *
+     * \throws cusp::invalid_input_exception if the sizes of \p X and \p Y
+     *         do not match the operator or they are column-major
+     */
+    template <typename Array2d1, typename Array2d2>
+    void operator()(const Array2d1& X, Array2d2& Y) const;
+};
+/*! \}
+ */
+
+} // end namespace cusp
+
+#include <cusp/detail/ensemble_csr_operator.inl>
@@ -0,0 +1,129 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*! \file equilibrate.h
+ *  \brief Diagonal scaling and equilibration of matrices
+ */
+
+#pragma once
+
+#include <cusp/detail/config.h>
+
+#include <cstddef>
+
+namespace cusp
+{
+
+/*! \addtogroup algorithms Algorithms
+ *  \ingroup algorithms
+ *  \{
+ */
+
+/*! \p scale_rows : scale the rows of a matrix in place
+ *
+ * Computes <tt>A = diag(r) A</tt>.  The stored entries are scaled where
+ * they are, so the pattern and the padding of \p A do not change.
+ *
+ * \param A matrix, of any format
+ * \param r factor of every row
+ *
+ * \tparam MatrixType matrix
+ * \tparam ArrayType array1d
+ */
+template <typename MatrixType, typename ArrayType>
+void scale_rows(MatrixType& A, const ArrayType& r);
+
+/*! \p scale_columns : scale the columns of a matrix in place
+ *
+ * Computes <tt>A = A diag(c)</tt>.
+ *
+ * \param A matrix, of any format
+ * \param c factor of every column
+ *
+ * \tparam MatrixType matrix
+ * \tparam ArrayType array1d
+ */
+template <typename MatrixType, typename ArrayType>
+void scale_columns(MatrixType& A, const ArrayType& c);
+
+/*! \p scale_rows_and_columns : scale the rows and columns of a matrix in place
+ *
+ * Computes <tt>A = diag(r) A diag(c)</tt> with a single pass over the
+ * entries of \p A.
+ *
+ * \param A matrix, of any format
+ * \param r factor of every row
+ * \param c factor of every column
+ *
+ * \tparam MatrixType matrix
+ * \tparam ArrayType1 array1d
+ * \tparam ArrayType2 array1d
+ */
+template <typename MatrixType, typename ArrayType1, typename ArrayType2>
+void scale_rows_and_columns(MatrixType& A, const ArrayType1& r, const ArrayType2& c);
+
+/*! \p ruiz_equilibrate : equilibrate a matrix in place by Ruiz scaling
+ *
+ * Every iteration computes the infinity norms of the rows and columns of
+ * \p A with segmented reductions and divides each row and column by the
+ * square root of its norm.  The norms converge to one, which removes bad
+ * scaling that slows down iterative solvers and makes the entries fit in
+ * reduced precision storage.  On exit <tt>A = diag(r) A_0 diag(c)</tt>,
+ * where \c A_0 is the input matrix.
+ *
+ * \param A matrix, of any format, equilibrated on exit
+ * \param r factor of every row on exit
+ * \param c factor of every column on exit
+ * \param max_iterations maximum number of scaling iterations
+ * \param tolerance stop once every nonzero row and column norm lies
+ *        within \p tolerance of one
+ *
+ * \return number of scaling iterations applied
+ *
+ * \tparam MatrixType matrix
+ * \tparam ArrayType1 array1d
+ * \tparam ArrayType2 array1d
+ *
+ * \note Rows and columns without nonzero entries keep a factor of one.
+ *
+ *  The following code snippet equilibrates a matrix and solves the scaled
+ *  system <tt>(R A C) y = R b</tt>, <tt>x = C y</tt>.
+ *
+ *  \code
+ *  #include <cusp/equilibrate.h>
+ *  #include <cusp/blas.h>
+ *  #include <cusp/krylov/gmres.h>
+ *  ...
+ *
+ *  cusp::array1d<float,cusp::device_memory> r;
+ *  cusp::array1d<float,cusp::device_memory> c;
+ *  cusp::ruiz_equilibrate(A, r, c);
+ *
+ *  cusp::blas::xmy(r, b, b);
+ *  cusp::krylov::gmres(A, y, b, 50);
+ *  cusp::blas::xmy(c, y, x);
+ *  \endcode
+ */
+template <typename MatrixType, typename ArrayType1, typename ArrayType2>
+size_t ruiz_equilibrate(MatrixType& A, ArrayType1& r, ArrayType2& c,
+                        const size_t max_iterations = 10, const double tolerance = 1e-2);
+
+/*! \}
+ */
+
+} // end namespace cusp
+
+#include <cusp/detail/equilibrate.inl>
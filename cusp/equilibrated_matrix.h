@@ -0,0 +1,160 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*! \file equilibrated_matrix.h
+ *  \brief Equilibrated matrix which works in the original scaling
+ */
+
+#pragma once
+
+#include <cusp/detail/config.h>
+
+#include <cusp/array1d.h>
+#include <cusp/linear_operator.h>
+
+namespace cusp
+{
+
+/*! \addtogroup sparse_matrices Sparse Matrices
+ */
+
+/*! \addtogroup sparse_matrix_containers Sparse Matrix Containers
+ *  \ingroup sparse_matrices
+ *  \{
+ */
+
+/*! \p equilibrated_matrix : Ruiz equilibrated copy of a matrix
+ *
+ * The matrix <tt>B = R A C</tt> computed by \p cusp::ruiz_equilibrate is
+ * stored in \p matrix together with the diagonal scalings \c R and \c C.
+ * The system <tt>A x = b</tt> is solved as <tt>B y = R b</tt> followed by
+ * <tt>x = C y</tt>, which \p solve does around any solver.
+ *
+ * The equilibration is computed in the precision of the input matrix
+ * before \p matrix is stored, so that \p matrix may use a lower precision
+ * than \c A: its entries are at most one in magnitude.
+ *
+ * An \p equilibrated_matrix is a linear operator in the original scaling,
+ * computing <tt>A x = R^-1 B C^-1 x</tt>.
+ *
+ * \tparam MatrixType Type of the equilibrated matrix (e.g. \c cusp::csr_matrix).
+ *
+ *  The following code snippet solves an equilibrated system with GMRES.
+ *
+ *  \code
+ *  #include <cusp/csr_matrix.h>
+ *  #include <cusp/equilibrated_matrix.h>
+ *  #include <cusp/krylov/gmres.h>
+ *  ...
+ *
+ *  struct gmres_solver
+ *  {
+ *      template <typename Matrix, typename Vector1, typename Vector2>
+ *      void operator()(const Matrix& B, Vector1& y, const Vector2& c) const
+ *      {
+ *          cusp::krylov::gmres(B, y, c, 50);
+ *      }
+ *  };
+ *
+ *  cusp::equilibrated_matrix< cusp::csr_matrix<int,float,cusp::device_memory> > E(A);
+ *
+ *  E.solve(gmres_solver(), x, b);
+ *  \endcode
+ */
+template <typename MatrixType>
+class equilibrated_matrix
+  : public cusp::linear_operator<typename MatrixType::value_type,
+                                 typename MatrixType::memory_space,
+                                 typename MatrixType::index_type>
+{
+    typedef cusp::linear_operator<typename MatrixType::value_type,
+                                  typename MatrixType::memory_space,
+                                  typename MatrixType::index_type> Parent;
+  public:
+    typedef typename MatrixType::index_type   index_type;
+    typedef typename MatrixType::value_type   value_type;
+    typedef typename MatrixType::memory_space memory_space;
+
+    /*! type of the equilibrated matrix
+     */
+    typedef MatrixType matrix_type;
+
+    /*! The equilibrated matrix <tt>R A C</tt>.
+     */
+    MatrixType matrix;
+
+    /*! Diagonals of \c R and \c C.
+     */
+    cusp::array1d<value_type, memory_space> row_scaling;
+    cusp::array1d<value_type, memory_space> column_scaling;
+
+    /*! Number of Ruiz iterations applied.
+     */
+    size_t iterations;
+
+    /*! Construct an empty \p equilibrated_matrix.
+     */
+    equilibrated_matrix() : iterations(0) {}
+
+    /*! Equilibrate a matrix.
+     *
+     *  \param A Sparse matrix.
+     *  \param max_iterations Maximum number of Ruiz iterations.
+     *  \param tolerance Distance of the row and column norms from one
+     *         at which the iterations stop.
+     */
+    template <typename MatrixType2>
+    equilibrated_matrix(const MatrixType2& A, const size_t max_iterations = 10, const double tolerance = 1e-2);
+
+    /*! Scale a right-hand side: <tt>b_new = R b</tt>.
+     */
+    template <typename VectorType1, typename VectorType2>
+    void scale_rhs(const VectorType1& b, VectorType2& b_new) const;
+
+    /*! Scale an initial guess: <tt>x_new = C^-1 x</tt>.
+     */
+    template <typename VectorType1, typename VectorType2>
+    void scale_initial_guess(const VectorType1& x, VectorType2& x_new) const;
+
+    /*! Recover the solution of the original system: <tt>x = C x_new</tt>.
+     */
+    template <typename VectorType1, typename VectorType2>
+    void unscale_solution(const VectorType1& x_new, VectorType2& x) const;
+
+    /*! Solve <tt>A x = b</tt> by calling <tt>solver(matrix, x_new, b_new)</tt>
+     *  on the equilibrated system, starting from the scaled \p x.
+     *
+     *  \note Tolerances of the solver apply to the residual of the
+     *        equilibrated system.
+     */
+    template <typename Solver, typename VectorType1, typename VectorType2>
+    void solve(const Solver& solver, VectorType1& x, const VectorType2& b) const;
+
+    /*! Compute <tt>y = A * x</tt> in the original scaling.
+     */
+    template <typename VectorType1, typename VectorType2>
+    void operator()(const VectorType1& x, VectorType2& y) const;
+
+  private:
+    mutable cusp::array1d<value_type, memory_space> x_work;
+    mutable cusp::array1d<value_type, memory_space> y_work;
+}; // class equilibrated_matrix
+/*! \}
+ */
+
+} // end namespace cusp
+
+#include <cusp/detail/equilibrated_matrix.inl>
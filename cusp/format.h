@@ -39,6 +39,11 @@ struct csr_format : public sparse_format {};
 struct dia_format : public sparse_format {};
 struct ell_format : public sparse_format {};
 struct hyb_format : public sparse_format {};
+struct sell_format : public sparse_format {};
+struct bsr_format : public sparse_format {};
+struct csr16_format : public sparse_format {};
+
+struct sparse_vector_format : public known_format {};
 
 } // end namespace cusp
 
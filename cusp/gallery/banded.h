@@ -0,0 +1,175 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*! \file banded.h
+ *  \brief Banded matrix generator with random bandwidth
+ */
+
+#pragma once
+
+#include <cusp/detail/config.h>
+
+#include <cusp/csr_matrix.h>
+#include <cusp/gallery/random.h>
+
+#include <thrust/for_each.h>
+#include <thrust/scan.h>
+#include <thrust/transform.h>
+#include <thrust/iterator/counting_iterator.h>
+
+namespace cusp
+{
+namespace gallery
+{
+namespace detail
+{
+
+// first and last column of a row, a random bandwidth on either side of the diagonal
+template <typename IndexType>
+struct random_band
+{
+    cusp::detail::detail::random_integer_functor<size_t,unsigned long long> hash;
+    IndexType num_rows;
+    IndexType max_bandwidth;
+
+    random_band(size_t seed, IndexType num_rows, IndexType max_bandwidth)
+        : hash(seed), num_rows(num_rows), max_bandwidth(max_bandwidth) {}
+
+    __host__ __device__
+    IndexType first(const IndexType row) const
+    {
+        const IndexType lower = IndexType(hash(2 * size_t(row)) % (max_bandwidth + 1));
+        return row < lower ? IndexType(0) : row - lower;
+    }
+
+    __host__ __device__
+    IndexType last(const IndexType row) const
+    {
+        const IndexType upper = IndexType(hash(2 * size_t(row) + 1) % (max_bandwidth + 1));
+        return num_rows - 1 - row < upper ? num_rows - 1 : row + upper;
+    }
+};
+
+template <typename IndexType>
+struct random_band_length : public thrust::unary_function<IndexType,IndexType>
+{
+    random_band<IndexType> band;
+
+    random_band_length(const random_band<IndexType>& band)
+        : band(band) {}
+
+    __host__ __device__
+    IndexType operator()(const IndexType row) const
+    {
+        return band.last(row) - band.first(row) + 1;
+    }
+};
+
+// -1 off the diagonal and the length of the row on it
+template <typename IndexType, typename ValueType>
+struct random_band_entries
+{
+    random_band<IndexType> band;
+    const IndexType * row_offsets;
+    IndexType * column_indices;
+    ValueType * values;
+
+    random_band_entries(const random_band<IndexType>& band, const IndexType * row_offsets,
+                        IndexType * column_indices, ValueType * values)
+        : band(band), row_offsets(row_offsets), column_indices(column_indices), values(values) {}
+
+    __host__ __device__
+    void operator()(const IndexType row) const
+    {
+        const IndexType first = band.first(row);
+        const IndexType last  = band.last(row);
+
+        IndexType jj = row_offsets[row];
+
+        for (IndexType col = first; col <= last; col++, jj++)
+        {
+            column_indices[jj] = col;
+            values[jj]         = col == row ? ValueType(last - first + 1) : ValueType(-1);
+        }
+    }
+};
+
+} // end namespace detail
+
+/*! \addtogroup gallery Matrix Gallery
+ *  \ingroup gallery
+ *  \{
+ */
+
+/*! \p random_banded : Create a square banded matrix whose rows each have
+ *  a random bandwidth.
+ *
+ *  Row \c i has entries in the columns <tt>i - l</tt> through
+ *  <tt>i + u</tt> that are inside the matrix, where \c l and \c u are
+ *  drawn uniformly from <tt>[0, max_bandwidth]</tt> for each row, so the
+ *  row lengths vary between 1 and <tt>2 * max_bandwidth + 1</tt> around a
+ *  common diagonal.  The off-diagonal entries are -1 and the diagonal
+ *  entry is the length of the row, so the matrix is diagonally dominant.
+ *
+ *  The bandwidths are a hash of \p seed and of the row, so the matrix is
+ *  generated in parallel in the memory space of \p output and the same
+ *  seed gives the same matrix in both memory spaces.
+ *
+ *  \param output generated matrix
+ *  \param num_rows number of rows and columns
+ *  \param max_bandwidth largest number of entries on either side of the diagonal
+ *  \param seed seed of the bandwidths
+ */
+template <typename MatrixType>
+void random_banded(MatrixType& output, size_t num_rows, size_t max_bandwidth, size_t seed = 0)
+{
+    CUSP_PROFILE_SCOPED();
+
+    typedef typename MatrixType::index_type   IndexType;
+    typedef typename MatrixType::value_type   ValueType;
+    typedef typename MatrixType::memory_space MemorySpace;
+    typedef thrust::counting_iterator<IndexType,MemorySpace> CountingIterator;
+
+    const detail::random_band<IndexType> band(seed, num_rows, max_bandwidth);
+
+    cusp::csr_matrix<IndexType,ValueType,MemorySpace> csr(num_rows, num_rows, 0);
+
+    csr.row_offsets[num_rows] = 0;
+
+    thrust::transform(CountingIterator(0), CountingIterator(num_rows),
+                      csr.row_offsets.begin(),
+                      detail::random_band_length<IndexType>(band));
+
+    thrust::exclusive_scan(csr.row_offsets.begin(), csr.row_offsets.end(), csr.row_offsets.begin());
+
+    const IndexType num_entries = csr.row_offsets[num_rows];
+
+    csr.resize(num_rows, num_rows, num_entries);
+
+    if (num_entries > 0)
+        thrust::for_each(CountingIterator(0), CountingIterator(num_rows),
+                         detail::random_band_entries<IndexType,ValueType>(band,
+                                                                         thrust::raw_pointer_cast(&csr.row_offsets[0]),
+                                                                         thrust::raw_pointer_cast(&csr.column_indices[0]),
+                                                                         thrust::raw_pointer_cast(&csr.values[0])));
+
+    output = csr;
+}
+/*! \}
+ */
+
+} // end namespace gallery
+} // end namespace cusp
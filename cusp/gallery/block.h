@@ -0,0 +1,232 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*! \file block.h
+ *  \brief Block-structured matrix generator
+ */
+
+#pragma once
+
+#include <cusp/detail/config.h>
+
+#include <cusp/coo_matrix.h>
+#include <cusp/csr_matrix.h>
+#include <cusp/exception.h>
+#include <cusp/detail/format_utils.h>
+#include <cusp/gallery/random.h>
+
+#include <thrust/for_each.h>
+#include <thrust/transform.h>
+#include <thrust/iterator/counting_iterator.h>
+#include <thrust/iterator/zip_iterator.h>
+
+namespace cusp
+{
+namespace gallery
+{
+namespace detail
+{
+
+// the n-th sampled block: the diagonal block of a block row followed by the
+// edges to neighbors drawn within a window around it, in both directions
+template <typename IndexType>
+struct random_block_coordinate : public thrust::unary_function<size_t, thrust::tuple<IndexType,IndexType> >
+{
+    cusp::detail::detail::random_integer_functor<size_t,unsigned long long> hash;
+    size_t num_block_rows;
+    size_t samples_per_row;   // diagonal block, then the edges and their transposes
+    size_t window;
+
+    random_block_coordinate(size_t seed, size_t num_block_rows, size_t edges_per_row, size_t window)
+        : hash(seed), num_block_rows(num_block_rows), samples_per_row(2 * edges_per_row + 1), window(window) {}
+
+    __host__ __device__
+    thrust::tuple<IndexType,IndexType> operator()(const size_t n) const
+    {
+        const size_t i = n / samples_per_row;
+        const size_t k = n % samples_per_row;
+
+        if (k == 0)
+            return thrust::make_tuple(IndexType(i), IndexType(i));
+
+        // both samples of a pair draw the same neighbor, at distance 1
+        // through window below or above the diagonal
+        const size_t offset   = hash(k % 2 ? n : n - 1) % (2 * window);
+        const size_t distance = offset % window + 1;
+
+        size_t j = i;
+
+        if (offset < window && i + distance < num_block_rows)
+            j = i + distance;
+        else if (offset >= window && distance <= i)
+            j = i - distance;
+
+        // the second sample of each pair is the transpose of the first
+        return k % 2 ? thrust::make_tuple(IndexType(i), IndexType(j))
+                     : thrust::make_tuple(IndexType(j), IndexType(i));
+    }
+};
+
+// offset of a row, whose block row has (end - start) blocks of block_size columns
+template <typename IndexType>
+struct random_block_row_offset : public thrust::unary_function<IndexType,IndexType>
+{
+    IndexType block_size;
+    const IndexType * block_row_offsets;
+
+    random_block_row_offset(IndexType block_size, const IndexType * block_row_offsets)
+        : block_size(block_size), block_row_offsets(block_row_offsets) {}
+
+    __host__ __device__
+    IndexType operator()(const IndexType row) const
+    {
+        const IndexType block_row = row / block_size;
+        const IndexType r         = row % block_size;
+        const IndexType start     = block_row_offsets[block_row];
+
+        if (r == 0)
+            return start * block_size * block_size;
+
+        return (start * block_size + r * (block_row_offsets[block_row + 1] - start)) * block_size;
+    }
+};
+
+// the entries of a row in the dense blocks of its block row, one on the
+// diagonal and -1 / (length of the row) elsewhere
+template <typename IndexType, typename ValueType>
+struct random_block_entries
+{
+    IndexType block_size;
+    const IndexType * block_row_offsets;
+    const IndexType * block_column_indices;
+    const IndexType * row_offsets;
+    IndexType * column_indices;
+    ValueType * values;
+
+    random_block_entries(IndexType block_size, const IndexType * block_row_offsets, const IndexType * block_column_indices,
+                         const IndexType * row_offsets, IndexType * column_indices, ValueType * values)
+        : block_size(block_size), block_row_offsets(block_row_offsets), block_column_indices(block_column_indices),
+          row_offsets(row_offsets), column_indices(column_indices), values(values) {}
+
+    __host__ __device__
+    void operator()(const IndexType row) const
+    {
+        const IndexType block_row = row / block_size;
+        const IndexType length    = row_offsets[row + 1] - row_offsets[row];
+
+        IndexType jj = row_offsets[row];
+
+        for (IndexType b = block_row_offsets[block_row]; b < block_row_offsets[block_row + 1]; b++)
+        {
+            for (IndexType c = 0; c < block_size; c++, jj++)
+            {
+                const IndexType col = block_column_indices[b] * block_size + c;
+
+                column_indices[jj] = col;
+                values[jj]         = col == row ? ValueType(1) : ValueType(-1) / ValueType(length);
+            }
+        }
+    }
+};
+
+} // end namespace detail
+
+/*! \addtogroup gallery Matrix Gallery
+ *  \ingroup gallery
+ *  \{
+ */
+
+/*! \p random_block : Create a square matrix of dense \p block_size by
+ *  \p block_size blocks, like the matrix of a finite element problem with
+ *  \p block_size unknowns per node.
+ *
+ *  The block rows are the nodes of a graph in which each node has about
+ *  \p average_degree neighbors, drawn within <tt>2 * average_degree</tt>
+ *  block rows of it, as in a mesh numbered for locality.  Each block row
+ *  holds its diagonal block and the block of each neighbor; the block
+ *  pattern is symmetric and repeated neighbors are merged, so a block row
+ *  has a little fewer than <tt>average_degree + 1</tt> blocks on average.  The diagonal
+ *  of the matrix is one and the other entries of a row are
+ *  <tt>-1 / length</tt>, so the matrix is diagonally dominant.
+ *
+ *  The neighbors are a hash of \p seed and of the index of the sample, so
+ *  the matrix is generated in parallel in the memory space of \p output and
+ *  the same seed gives the same matrix in both memory spaces.
+ *
+ *  \param output generated matrix
+ *  \param num_block_rows number of block rows and block columns
+ *  \param block_size number of rows and columns of each block
+ *  \param average_degree average number of off-diagonal blocks per block row
+ *  \param seed seed of the neighbors
+ *
+ *  \throws cusp::invalid_input_exception if \p block_size is zero
+ */
+template <typename MatrixType>
+void random_block(MatrixType& output, size_t num_block_rows, size_t block_size, size_t average_degree, size_t seed = 0)
+{
+    CUSP_PROFILE_SCOPED();
+
+    typedef typename MatrixType::index_type   IndexType;
+    typedef typename MatrixType::value_type   ValueType;
+    typedef typename MatrixType::memory_space MemorySpace;
+    typedef thrust::counting_iterator<size_t,MemorySpace>    SampleIterator;
+    typedef thrust::counting_iterator<IndexType,MemorySpace> CountingIterator;
+
+    if (block_size == 0)
+        throw cusp::invalid_input_exception("block size must be positive");
+
+    // each edge is sampled by one of its two block rows
+    const size_t edges_per_row = (average_degree + 1) / 2;
+    const size_t window        = average_degree > 0 ? 2 * average_degree : 1;
+    const size_t num_samples   = num_block_rows * (2 * edges_per_row + 1);
+
+    // pattern of the blocks
+    cusp::coo_matrix<IndexType,char,MemorySpace> blocks(num_block_rows, num_block_rows, num_samples);
+
+    thrust::transform(SampleIterator(0), SampleIterator(num_samples),
+                      thrust::make_zip_iterator(thrust::make_tuple(blocks.row_indices.begin(), blocks.column_indices.begin())),
+                      detail::random_block_coordinate<IndexType>(seed, num_block_rows, edges_per_row, window));
+
+    detail::sort_and_remove_duplicates(blocks);
+
+    cusp::array1d<IndexType,MemorySpace> block_row_offsets(num_block_rows + 1);
+    cusp::detail::indices_to_offsets(blocks.row_indices, block_row_offsets);
+
+    // expand each block into block_size rows of block_size entries
+    const size_t num_rows    = num_block_rows * block_size;
+    const size_t num_entries = blocks.num_entries * block_size * block_size;
+
+    cusp::csr_matrix<IndexType,ValueType,MemorySpace> csr(num_rows, num_rows, num_entries);
+
+    thrust::transform(CountingIterator(0), CountingIterator(num_rows + 1), csr.row_offsets.begin(),
+                      detail::random_block_row_offset<IndexType>(block_size, thrust::raw_pointer_cast(&block_row_offsets[0])));
+
+    if (num_entries > 0)
+        thrust::for_each(CountingIterator(0), CountingIterator(num_rows),
+                         detail::random_block_entries<IndexType,ValueType>(block_size,
+                                                                           thrust::raw_pointer_cast(&block_row_offsets[0]),
+                                                                           thrust::raw_pointer_cast(&blocks.column_indices[0]),
+                                                                           thrust::raw_pointer_cast(&csr.row_offsets[0]),
+                                                                           thrust::raw_pointer_cast(&csr.column_indices[0]),
+                                                                           thrust::raw_pointer_cast(&csr.values[0])));
+
+    output = csr;
+}
+/*! \}
+ */
+
+} // end namespace gallery
+} // end namespace cusp
@@ -23,50 +23,123 @@
 #include <cusp/detail/config.h>
 
 #include <cusp/coo_matrix.h>
-#include <thrust/unique.h>
-#include <thrust/sort.h>
+#include <cusp/detail/random.h>
 
-#include <stdlib.h> // XXX remove when we switch RNGs
+#include <thrust/fill.h>
+#include <thrust/transform.h>
+#include <thrust/unique.h>
+#include <thrust/iterator/counting_iterator.h>
+#include <thrust/iterator/zip_iterator.h>
 
 namespace cusp
 {
 namespace gallery
 {
+namespace detail
+{
+
+// coordinate of the n-th sample, a counter-based hash of the seed and n
+template <typename IndexType>
+struct random_coordinate : public thrust::unary_function<size_t,IndexType>
+{
+    cusp::detail::detail::random_integer_functor<size_t,unsigned long long> hash;
+    size_t coordinate;  // 0 for the row, 1 for the column
+    size_t bound;
+
+    random_coordinate(size_t seed, size_t coordinate, size_t bound)
+        : hash(seed), coordinate(coordinate), bound(bound) {}
+
+    __host__ __device__
+    IndexType operator()(const size_t n) const
+    {
+        return IndexType(hash(2 * n + coordinate) % bound);
+    }
+};
+
+// real in [0,1) from the counter-based hash of the seed and n
+struct random_uniform : public thrust::unary_function<size_t,double>
+{
+    cusp::detail::detail::random_integer_functor<size_t,unsigned long long> hash;
+
+    random_uniform(size_t seed)
+        : hash(seed) {}
+
+    __host__ __device__
+    double operator()(const size_t n) const
+    {
+        return double(hash(n) >> 11) * (1.0 / 9007199254740992.0);
+    }
+};
+
+// sort the entries of a coo_matrix and keep the first of each repeated (row,column)
+template <typename IndexType, typename ValueType, typename MemorySpace>
+void sort_and_remove_duplicates(cusp::coo_matrix<IndexType,ValueType,MemorySpace>& coo)
+{
+    coo.sort_by_row_and_column();
+
+    size_t num_entries = thrust::unique_by_key(thrust::make_zip_iterator(thrust::make_tuple(coo.row_indices.begin(), coo.column_indices.begin())),
+                                               thrust::make_zip_iterator(thrust::make_tuple(coo.row_indices.end(),   coo.column_indices.end())),
+                                               coo.values.begin()).first
+                         - thrust::make_zip_iterator(thrust::make_tuple(coo.row_indices.begin(), coo.column_indices.begin()));
+
+    coo.resize(coo.num_rows, coo.num_cols, num_entries);
+}
+
+} // end namespace detail
+
 /*! \addtogroup gallery Matrix Gallery
  *  \ingroup gallery
  *  \{
  */
 
-// TODO use thrust RNGs, add seed parameter defaulting to num_rows ^ num_cols ^ num_samples
-// TODO document
+/*! \p random : Create a matrix with \p num_samples entries equal to one at
+ *  random positions, of which duplicates are merged, so the matrix has at
+ *  most \p num_samples entries.
+ *
+ *  The positions are a hash of \p seed and of the index of the sample, so
+ *  they are generated in parallel in the memory space of \p output (on the
+ *  device for device matrices, without host storage) and the same seed
+ *  gives the same matrix in both memory spaces.
+ *
+ *  \param num_rows number of rows
+ *  \param num_cols number of columns
+ *  \param num_samples number of random positions
+ *  \param output generated matrix
+ *  \param seed seed of the positions
+ */
 template <class MatrixType>
-void random(size_t num_rows, size_t num_cols, size_t num_samples, MatrixType& output)
+void random(size_t num_rows, size_t num_cols, size_t num_samples, MatrixType& output, size_t seed)
 {
-    typedef typename MatrixType::index_type IndexType;
-    typedef typename MatrixType::value_type ValueType;
+    CUSP_PROFILE_SCOPED();
 
-    cusp::coo_matrix<IndexType,ValueType,cusp::host_memory> coo(num_rows, num_cols, num_samples);
+    typedef typename MatrixType::index_type   IndexType;
+    typedef typename MatrixType::value_type   ValueType;
+    typedef typename MatrixType::memory_space MemorySpace;
+    typedef thrust::counting_iterator<size_t,MemorySpace> CountingIterator;
 
-    srand(num_rows ^ num_cols ^ num_samples);
+    if (num_rows == 0 || num_cols == 0)
+        num_samples = 0;
 
-    for(size_t n = 0; n < num_samples; n++)
-    {
-        coo.row_indices[n]    = rand() % num_rows;
-        coo.column_indices[n] = rand() % num_cols;
-        coo.values[n]         = ValueType(1);
-    }
+    cusp::coo_matrix<IndexType,ValueType,MemorySpace> coo(num_rows, num_cols, num_samples);
 
-    // sort indices by (row,column)
-    coo.sort_by_row_and_column();
+    thrust::transform(CountingIterator(0), CountingIterator(num_samples), coo.row_indices.begin(),
+                      detail::random_coordinate<IndexType>(seed, 0, num_rows));
+    thrust::transform(CountingIterator(0), CountingIterator(num_samples), coo.column_indices.begin(),
+                      detail::random_coordinate<IndexType>(seed, 1, num_cols));
+    thrust::fill(coo.values.begin(), coo.values.end(), ValueType(1));
 
-    size_t num_entries = thrust::unique(thrust::make_zip_iterator(thrust::make_tuple(coo.row_indices.begin(), coo.column_indices.begin())),
-                                        thrust::make_zip_iterator(thrust::make_tuple(coo.row_indices.end(),   coo.column_indices.end())))
-                         - thrust::make_zip_iterator(thrust::make_tuple(coo.row_indices.begin(), coo.column_indices.begin()));
+    detail::sort_and_remove_duplicates(coo);
 
-    coo.resize(num_rows, num_cols, num_entries);
-    
     output = coo;
 }
+
+/*! \p random with the seed <tt>num_rows ^ num_cols ^ num_samples</tt>
+ */
+template <class MatrixType>
+void random(size_t num_rows, size_t num_cols, size_t num_samples, MatrixType& output)
+{
+    cusp::gallery::random(num_rows, num_cols, num_samples, output, num_rows ^ num_cols ^ num_samples);
+}
 /*! \}
  */
 
@@ -0,0 +1,164 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*! \file rmat.h
+ *  \brief R-MAT (recursive Kronecker) graph generator
+ */
+
+#pragma once
+
+#include <cusp/detail/config.h>
+
+#include <cusp/coo_matrix.h>
+#include <cusp/exception.h>
+#include <cusp/gallery/random.h>
+
+#include <thrust/fill.h>
+#include <thrust/transform.h>
+#include <thrust/iterator/counting_iterator.h>
+#include <thrust/iterator/zip_iterator.h>
+
+namespace cusp
+{
+namespace gallery
+{
+namespace detail
+{
+
+// (row,column) of the n-th edge, one quadrant of the adjacency matrix per level
+template <typename IndexType>
+struct rmat_edge : public thrust::unary_function<size_t, thrust::tuple<IndexType,IndexType> >
+{
+    random_uniform uniform;
+    size_t scale;
+    double a, ab, abc;
+
+    rmat_edge(size_t seed, size_t scale, double a, double b, double c)
+        : uniform(seed), scale(scale), a(a), ab(a + b), abc(a + b + c) {}
+
+    __host__ __device__
+    thrust::tuple<IndexType,IndexType> operator()(const size_t n) const
+    {
+        IndexType row = 0;
+        IndexType col = 0;
+
+        for (size_t level = 0; level < scale; level++)
+        {
+            const double r = uniform(n * scale + level);
+
+            row <<= 1;
+            col <<= 1;
+
+            if (r < a)
+                continue;
+            else if (r < ab)
+                col |= 1;
+            else if (r < abc)
+                row |= 1;
+            else
+            {
+                row |= 1;
+                col |= 1;
+            }
+        }
+
+        return thrust::make_tuple(row, col);
+    }
+};
+
+} // end namespace detail
+
+/*! \addtogroup gallery Matrix Gallery
+ *  \ingroup gallery
+ *  \{
+ */
+
+/*! \p rmat : Create the adjacency matrix of an R-MAT graph, whose
+ *  degrees follow a power law, as used by the Graph500 benchmark.
+ *
+ *  Each of the <tt>edge_factor * 2^scale</tt> edges picks one quadrant of
+ *  the <tt>2^scale</tt> by <tt>2^scale</tt> adjacency matrix with the
+ *  probabilities \p a, \p b, \p c and <tt>1 - a - b - c</tt>, then one
+ *  quadrant of that, and so on for \p scale levels.  Repeated edges are
+ *  merged, so the matrix has at most <tt>edge_factor * 2^scale</tt>
+ *  entries, all equal to one.  The vertices are not permuted, so the rows
+ *  with the most entries come first.
+ *
+ *  The edges are a hash of \p seed and of the index of the edge, so they
+ *  are generated in parallel in the memory space of \p output and the
+ *  same seed gives the same matrix in both memory spaces.
+ *
+ *  \param output generated matrix
+ *  \param scale base 2 logarithm of the number of vertices
+ *  \param edge_factor number of edges per vertex
+ *  \param seed seed of the edges
+ *  \param a probability of the upper left quadrant
+ *  \param b probability of the upper right quadrant
+ *  \param c probability of the lower left quadrant
+ *
+ *  \throws cusp::invalid_input_exception if the probabilities are negative
+ *          or exceed one, or \p scale does not fit the index type
+ *
+ *  \code
+ *  #include <cusp/gallery/rmat.h>
+ *  #include <cusp/csr_matrix.h>
+ *
+ *  int main(void)
+ *  {
+ *      // graph of 2^16 vertices and 16 * 2^16 edges
+ *      cusp::csr_matrix<int, float, cusp::device_memory> A;
+ *      cusp::gallery::rmat(A, 16, 16);
+ *
+ *      return 0;
+ *  }
+ *  \endcode
+ */
+template <typename MatrixType>
+void rmat(MatrixType& output, size_t scale, size_t edge_factor, size_t seed = 0,
+          double a = 0.57, double b = 0.19, double c = 0.19)
+{
+    CUSP_PROFILE_SCOPED();
+
+    typedef typename MatrixType::index_type   IndexType;
+    typedef typename MatrixType::value_type   ValueType;
+    typedef typename MatrixType::memory_space MemorySpace;
+    typedef thrust::counting_iterator<size_t,MemorySpace> CountingIterator;
+
+    if (a < 0 || b < 0 || c < 0 || a + b + c > 1)
+        throw cusp::invalid_input_exception("R-MAT probabilities must be nonnegative and sum to at most one");
+
+    if (scale >= 8 * sizeof(IndexType) - 1)
+        throw cusp::invalid_input_exception("R-MAT scale exceeds the range of the index type");
+
+    const size_t num_vertices = size_t(1) << scale;
+    const size_t num_edges    = edge_factor * num_vertices;
+
+    cusp::coo_matrix<IndexType,ValueType,MemorySpace> coo(num_vertices, num_vertices, num_edges);
+
+    thrust::transform(CountingIterator(0), CountingIterator(num_edges),
+                      thrust::make_zip_iterator(thrust::make_tuple(coo.row_indices.begin(), coo.column_indices.begin())),
+                      detail::rmat_edge<IndexType>(seed, scale, a, b, c));
+    thrust::fill(coo.values.begin(), coo.values.end(), ValueType(1));
+
+    detail::sort_and_remove_duplicates(coo);
+
+    output = coo;
+}
+/*! \}
+ */
+
+} // end namespace gallery
+} // end namespace cusp
@@ -0,0 +1,142 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*! \file row_lengths.h
+ *  \brief Random matrix generator with prescribed row lengths
+ */
+
+#pragma once
+
+#include <cusp/detail/config.h>
+
+#include <cusp/array1d.h>
+#include <cusp/csr_matrix.h>
+#include <cusp/exception.h>
+#include <cusp/gallery/random.h>
+
+#include <thrust/copy.h>
+#include <thrust/fill.h>
+#include <thrust/for_each.h>
+#include <thrust/functional.h>
+#include <thrust/reduce.h>
+#include <thrust/scan.h>
+#include <thrust/iterator/counting_iterator.h>
+
+namespace cusp
+{
+namespace gallery
+{
+namespace detail
+{
+
+// one column in each of the row_length equal segments of [0, num_cols),
+// so the columns are distinct and sorted
+template <typename IndexType>
+struct random_row_columns
+{
+    cusp::detail::detail::random_integer_functor<size_t,unsigned long long> hash;
+    size_t num_cols;
+    const IndexType * row_offsets;
+    IndexType * column_indices;
+
+    random_row_columns(size_t seed, size_t num_cols, const IndexType * row_offsets, IndexType * column_indices)
+        : hash(seed), num_cols(num_cols), row_offsets(row_offsets), column_indices(column_indices) {}
+
+    __host__ __device__
+    void operator()(const IndexType row) const
+    {
+        const size_t start  = row_offsets[row];
+        const size_t length = row_offsets[row + 1] - start;
+
+        for (size_t k = 0; k < length; k++)
+        {
+            const size_t first = (k * num_cols) / length;
+            const size_t last  = ((k + 1) * num_cols) / length;
+
+            column_indices[start + k] = IndexType(first + hash(start + k) % (last - first));
+        }
+    }
+};
+
+} // end namespace detail
+
+/*! \addtogroup gallery Matrix Gallery
+ *  \ingroup gallery
+ *  \{
+ */
+
+/*! \p random_row_lengths : Create a matrix with \p row_lengths[i] entries
+ *  equal to one in row \c i, at random columns.
+ *
+ *  Any distribution of row lengths, for example a power law or a few very
+ *  long rows among short ones, can be prescribed this way.  Row \c i
+ *  splits the columns into \p row_lengths[i] equal ranges and has one
+ *  entry at a random column of each, so the rows have exactly the given
+ *  lengths and their entries are spread over the whole row.
+ *
+ *  The columns are a hash of \p seed and of the index of the entry, so the
+ *  matrix is generated in parallel in the memory space of \p output and
+ *  the same seed gives the same matrix in both memory spaces.
+ *
+ *  \param output generated matrix
+ *  \param num_cols number of columns
+ *  \param row_lengths number of entries of each row
+ *  \param seed seed of the columns
+ *
+ *  \throws cusp::invalid_input_exception if a row is longer than \p num_cols
+ */
+template <typename MatrixType, typename ArrayType>
+void random_row_lengths(MatrixType& output, size_t num_cols, const ArrayType& row_lengths, size_t seed = 0)
+{
+    CUSP_PROFILE_SCOPED();
+
+    typedef typename MatrixType::index_type   IndexType;
+    typedef typename MatrixType::value_type   ValueType;
+    typedef typename MatrixType::memory_space MemorySpace;
+    typedef thrust::counting_iterator<IndexType,MemorySpace> CountingIterator;
+
+    const size_t num_rows = row_lengths.size();
+
+    cusp::csr_matrix<IndexType,ValueType,MemorySpace> csr(num_rows, num_cols, 0);
+
+    thrust::copy(row_lengths.begin(), row_lengths.end(), csr.row_offsets.begin());
+
+    if (num_rows > 0 &&
+        size_t(thrust::reduce(csr.row_offsets.begin(), csr.row_offsets.begin() + num_rows, IndexType(0), thrust::maximum<IndexType>())) > num_cols)
+        throw cusp::invalid_input_exception("row lengths must not exceed the number of columns");
+
+    csr.row_offsets[num_rows] = 0;
+    thrust::exclusive_scan(csr.row_offsets.begin(), csr.row_offsets.end(), csr.row_offsets.begin());
+
+    const IndexType num_entries = csr.row_offsets[num_rows];
+
+    csr.resize(num_rows, num_cols, num_entries);
+
+    if (num_entries > 0)
+        thrust::for_each(CountingIterator(0), CountingIterator(num_rows),
+                         detail::random_row_columns<IndexType>(seed, num_cols,
+                                                               thrust::raw_pointer_cast(&csr.row_offsets[0]),
+                                                               thrust::raw_pointer_cast(&csr.column_indices[0])));
+
+    thrust::fill(csr.values.begin(), csr.values.end(), ValueType(1));
+
+    output = csr;
+}
+/*! \}
+ */
+
+} // end namespace gallery
+} // end namespace cusp
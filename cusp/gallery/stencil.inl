@@ -15,13 +15,24 @@
  */
 
 #include <cusp/copy.h>
+#include <cusp/coo_matrix.h>
+#include <cusp/csr_matrix.h>
 #include <cusp/dia_matrix.h>
+#include <cusp/detail/format_utils.h>
+#include <cusp/detail/stencil.h>
 
 #include <thrust/tuple.h>
 #include <thrust/reduce.h>
 #include <thrust/scan.h>
 #include <thrust/count.h>
 #include <thrust/functional.h>
+#include <thrust/for_each.h>
+#include <thrust/transform.h>
+#include <thrust/iterator/counting_iterator.h>
+
+#include <algorithm>
+#include <utility>
+#include <vector>
 
 namespace cusp
 {
@@ -133,6 +144,188 @@ struct fill_diagonal_entries
     }
 };
 
+
+// the stencil with its points sorted by column offset, points with the same
+// offsets merged and zero coefficients dropped, false for stencils of more
+// than three dimensions or 27 points
+template <typename IndexType, typename ValueType, typename StencilPoint, typename GridDimension>
+bool make_stencil_coefficients(      cusp::detail::stencil_coefficients<IndexType,ValueType>& coefficients,
+                               const cusp::array1d<StencilPoint,cusp::host_memory>& stencil,
+                               const GridDimension& grid)
+{
+    typedef typename thrust::tuple_element<0,StencilPoint>::type StencilIndex;
+
+    const int MAX_DIMENSIONS = cusp::detail::stencil_coefficients<IndexType,ValueType>::MAX_DIMENSIONS;
+    const int MAX_POINTS     = cusp::detail::stencil_coefficients<IndexType,ValueType>::MAX_POINTS;
+
+    if (thrust::tuple_size<GridDimension>::value > MAX_DIMENSIONS ||
+        thrust::tuple_size<StencilIndex>::value  > MAX_DIMENSIONS ||
+        stencil.size() > size_t(MAX_POINTS))
+        return false;
+
+    IndexType dimensions[3] = {1, 1, 1};
+    unpack_tuple(grid, dimensions);
+
+    for (int d = 0; d < MAX_DIMENSIONS; d++)
+        coefficients.grid[d] = dimensions[d];
+
+    // (column offset, point) in the order of the columns
+    std::vector< std::pair<IndexType,size_t> > order;
+
+    for (size_t n = 0; n < stencil.size(); n++)
+    {
+        int offsets[3] = {0, 0, 0};
+        unpack_tuple(thrust::get<0>(stencil[n]), offsets);
+
+        const IndexType offset = (offsets[2] * dimensions[1] + offsets[1]) * dimensions[0] + offsets[0];
+        order.push_back(std::make_pair(offset, n));
+    }
+
+    std::stable_sort(order.begin(), order.end());
+
+    coefficients.num_points = 0;
+
+    for (size_t m = 0; m < order.size(); m++)
+    {
+        int offsets[3] = {0, 0, 0};
+        unpack_tuple(thrust::get<0>(stencil[order[m].second]), offsets);
+
+        const ValueType value = thrust::get<1>(stencil[order[m].second]);
+
+        // merge with an earlier point of the same offsets
+        int p = coefficients.num_points - 1;
+        while (p >= 0 && (offsets[0] != coefficients.offsets[p][0] ||
+                          offsets[1] != coefficients.offsets[p][1] ||
+                          offsets[2] != coefficients.offsets[p][2]))
+            p--;
+
+        if (p >= 0)
+        {
+            coefficients.values[p] += value;
+            continue;
+        }
+
+        p = coefficients.num_points++;
+
+        for (int d = 0; d < MAX_DIMENSIONS; d++)
+            coefficients.offsets[p][d] = offsets[d];
+
+        coefficients.values[p] = value;
+    }
+
+    // drop the points whose coefficients are (or sum to) zero
+    int num_points = 0;
+
+    for (int p = 0; p < coefficients.num_points; p++)
+    {
+        if (coefficients.values[p] == ValueType(0))
+            continue;
+
+        for (int d = 0; d < MAX_DIMENSIONS; d++)
+            coefficients.offsets[num_points][d] = coefficients.offsets[p][d];
+
+        coefficients.values[num_points++] = coefficients.values[p];
+    }
+
+    coefficients.num_points = num_points;
+
+    return true;
+}
+
+// number of entries in a row of the stencil matrix
+template <typename IndexType, typename ValueType>
+struct stencil_row_length : public thrust::unary_function<IndexType,IndexType>
+{
+    cusp::detail::stencil_coefficients<IndexType,ValueType> coefficients;
+
+    stencil_row_length(const cusp::detail::stencil_coefficients<IndexType,ValueType>& coefficients)
+        : coefficients(coefficients) {}
+
+    __host__ __device__
+    IndexType operator()(const IndexType row) const
+    {
+        IndexType length = 0;
+
+        for (int n = 0; n < coefficients.num_points; n++)
+        {
+            IndexType col;
+
+            if (coefficients.column(row, n, col))
+                length++;
+        }
+
+        return length;
+    }
+};
+
+// columns and values of a row of the stencil matrix, in increasing column order
+template <typename IndexType, typename ValueType>
+struct stencil_row_entries
+{
+    cusp::detail::stencil_coefficients<IndexType,ValueType> coefficients;
+    const IndexType * row_offsets;
+    IndexType * column_indices;
+    ValueType * values;
+
+    stencil_row_entries(const cusp::detail::stencil_coefficients<IndexType,ValueType>& coefficients,
+                        const IndexType * row_offsets, IndexType * column_indices, ValueType * values)
+        : coefficients(coefficients), row_offsets(row_offsets), column_indices(column_indices), values(values) {}
+
+    __host__ __device__
+    void operator()(const IndexType row) const
+    {
+        IndexType k = row_offsets[row];
+
+        for (int n = 0; n < coefficients.num_points; n++)
+        {
+            IndexType col;
+
+            if (coefficients.column(row, n, col))
+            {
+                column_indices[k] = col;
+                values[k]         = coefficients.values[n];
+                k++;
+            }
+        }
+    }
+};
+
+// row offsets, column indices and values of the stencil matrix, computed
+// row by row in the memory space of the arrays
+template <typename IndexType, typename ValueType, typename MemorySpace>
+void stencil_entries(const cusp::detail::stencil_coefficients<IndexType,ValueType>& coefficients,
+                     cusp::array1d<IndexType,MemorySpace>& row_offsets,
+                     cusp::array1d<IndexType,MemorySpace>& column_indices,
+                     cusp::array1d<ValueType,MemorySpace>& values)
+{
+    typedef thrust::counting_iterator<IndexType,MemorySpace> CountingIterator;
+
+    const IndexType num_rows = coefficients.num_rows();
+
+    row_offsets.resize(num_rows + 1);
+    row_offsets[num_rows] = 0;
+
+    thrust::transform(CountingIterator(0), CountingIterator(num_rows),
+                      row_offsets.begin(),
+                      stencil_row_length<IndexType,ValueType>(coefficients));
+
+    thrust::exclusive_scan(row_offsets.begin(), row_offsets.end(), row_offsets.begin());
+
+    const IndexType num_entries = row_offsets[num_rows];
+
+    column_indices.resize(num_entries);
+    values.resize(num_entries);
+
+    if (num_entries == 0)
+        return;
+
+    thrust::for_each(CountingIterator(0), CountingIterator(num_rows),
+                     stencil_row_entries<IndexType,ValueType>(coefficients,
+                                                              thrust::raw_pointer_cast(&row_offsets[0]),
+                                                              thrust::raw_pointer_cast(&column_indices[0]),
+                                                              thrust::raw_pointer_cast(&values[0])));
+}
+
 } // end namespace detail
 
 template <typename IndexType,
@@ -185,6 +378,74 @@ void generate_matrix_from_stencil(      cusp::dia_matrix<IndexType,ValueType,Mem
     matrix.num_entries = matrix.values.values.size() - thrust::count(matrix.values.values.begin(), matrix.values.values.end(), ValueType(0));
 }
 
+// CSR and COO matrices are written directly, one row per thread in the
+// memory space of the matrix, without an intermediate DIA matrix
+template <typename IndexType,
+          typename ValueType,
+          typename MemorySpace,
+          typename StencilPoint,
+          typename GridDimension>
+void generate_matrix_from_stencil(      cusp::csr_matrix<IndexType,ValueType,MemorySpace>& matrix,
+                                  const cusp::array1d<StencilPoint,cusp::host_memory>& stencil,
+                                  const GridDimension& grid)
+{
+    CUSP_PROFILE_SCOPED();
+
+    cusp::detail::stencil_coefficients<IndexType,ValueType> coefficients;
+
+    if (!detail::make_stencil_coefficients(coefficients, stencil, grid))
+    {
+        cusp::dia_matrix<IndexType,ValueType,MemorySpace> dia;
+        generate_matrix_from_stencil(dia, stencil, grid);
+        cusp::convert(dia, matrix);
+        return;
+    }
+
+    const IndexType num_rows = coefficients.num_rows();
+
+    detail::stencil_entries(coefficients, matrix.row_offsets, matrix.column_indices, matrix.values);
+
+    matrix.num_rows    = num_rows;
+    matrix.num_cols    = num_rows;
+    matrix.num_entries = matrix.values.size();
+}
+
+template <typename IndexType,
+          typename ValueType,
+          typename MemorySpace,
+          typename StencilPoint,
+          typename GridDimension>
+void generate_matrix_from_stencil(      cusp::coo_matrix<IndexType,ValueType,MemorySpace>& matrix,
+                                  const cusp::array1d<StencilPoint,cusp::host_memory>& stencil,
+                                  const GridDimension& grid)
+{
+    CUSP_PROFILE_SCOPED();
+
+    cusp::detail::stencil_coefficients<IndexType,ValueType> coefficients;
+
+    if (!detail::make_stencil_coefficients(coefficients, stencil, grid))
+    {
+        cusp::dia_matrix<IndexType,ValueType,MemorySpace> dia;
+        generate_matrix_from_stencil(dia, stencil, grid);
+        cusp::convert(dia, matrix);
+        return;
+    }
+
+    const IndexType num_rows = coefficients.num_rows();
+
+    {
+        cusp::array1d<IndexType,MemorySpace> row_offsets;
+        detail::stencil_entries(coefficients, row_offsets, matrix.column_indices, matrix.values);
+
+        matrix.row_indices.resize(matrix.values.size());
+        cusp::detail::offsets_to_indices(row_offsets, matrix.row_indices);
+    }
+
+    matrix.num_rows    = num_rows;
+    matrix.num_cols    = num_rows;
+    matrix.num_entries = matrix.values.size();
+}
+
 // TODO add an entry point and make this the default path
 template <typename MatrixType,
           typename StencilPoint,
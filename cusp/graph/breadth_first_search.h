@@ -22,6 +22,9 @@
 
 #include <cusp/detail/config.h>
 
+#include <cusp/array2d.h>
+#include <cusp/spmspv.h>
+
 namespace cusp
 {
 namespace graph
@@ -46,6 +49,60 @@ namespace graph
 template<bool MARK_PREDECESSORS, typename MatrixType, typename ArrayType>
 void breadth_first_search(const MatrixType& G, const typename MatrixType::index_type src, ArrayType& labels);
 
+/*! \p breadth_first_search : Performs a Breadth-first traversal of a graph
+ * starting from a given source vertex, expanding each level of the search
+ * with a sparse matrix-sparse vector product.
+ *
+ * \c cusp::spmspv_push expands the frontier top-down along the edges of
+ * its vertices and \c cusp::spmspv_pull checks every unvisited vertex
+ * bottom-up for a neighbor in the frontier.  \c cusp::spmspv_auto
+ * switches between the two at each level from the number of edges either
+ * direction would examine, which is the direction-optimizing search of
+ * Beamer et al.  Top-down levels cost work proportional to the frontier,
+ * bottom-up levels win once the frontier covers much of the graph.
+ *
+ * \param A symmetric matrix that represents a graph
+ * \param source vertex to begin traversal
+ * \param labels of vertices from source in BFS order, or the predecessor
+ *        of each vertex when \p MARK_PREDECESSORS is set
+ * \param direction direction used to expand each level
+ *
+ * \tparam Matrix matrix
+ * \tparam Array array
+ *
+ * \note The bottom-up levels read the neighbors of a vertex from its row,
+ *       so the graph must be symmetric unless \c cusp::spmspv_push is used.
+ * \note The predecessor of a vertex is its smallest neighbor in the
+ *       previous level, so the result does not depend on the direction.
+ *
+ *  \see http://en.wikipedia.org/wiki/Breadth-first_search
+ */
+template<bool MARK_PREDECESSORS, typename MatrixType, typename ArrayType>
+void breadth_first_search(const MatrixType& G, const typename MatrixType::index_type src, ArrayType& labels,
+                          cusp::spmspv_direction direction);
+
+/*! \p multi_source_breadth_first_search : Performs Breadth-first traversals
+ * of a graph from several source vertices at once.
+ *
+ * All searches advance one level together, so a batch of \c k sources
+ * costs one set of launches per level instead of \c k.  Column \c s of
+ * \p levels receives the distances of the vertices from \c sources[s],
+ * with -1 for unreachable vertices.
+ *
+ * \param A symmetric matrix that represents a graph
+ * \param sources vertices to begin the traversals
+ * \param levels column-major array of the distances from each source
+ *
+ * \tparam Matrix matrix
+ * \tparam Array array
+ *
+ * \note The product of the number of vertices and the number of sources
+ *       must be representable in the index type.
+ */
+template<typename MatrixType, typename ArrayType, typename IndexType, typename MemorySpace>
+void multi_source_breadth_first_search(const MatrixType& G, const ArrayType& sources,
+                                       cusp::array2d<IndexType,MemorySpace,cusp::column_major>& levels);
+
 /*! \}
  */
 
@@ -32,10 +32,18 @@ namespace graph
  */
 
 /*! \p connected_components : Computes the connected components of a graph 
+ *
+ * The components are numbered from zero in the order of their smallest
+ * vertex.  On the device the components are found by hooking and pointer
+ * jumping over all edges at once, so the number of passes does not grow
+ * with the number of components.  On the host a union-find over the edges
+ * runs on blocks of rows in parallel when OpenMP is enabled.
  *
  * \param A symmetric matrix that represents a graph
  * \param component each vertex is connected to
  *
+ * \return the number of components
+ *
  * \tparam Matrix matrix
  * \tparam Array array
  *
@@ -18,6 +18,7 @@
 #include <cusp/csr_matrix.h>
 
 #include <cusp/graph/detail/dispatch/breadth_first_search.h>
+#include <cusp/graph/detail/direction_optimizing_bfs.h>
 
 namespace cusp
 {
@@ -47,7 +48,47 @@ void breadth_first_search(const MatrixType& G, const typename MatrixType::index_
   // convert matrix to CSR format and compute on the host
   cusp::csr_matrix<IndexType,ValueType,MemorySpace> G_csr(G);
 
-  cusp::graph::breadth_first_search(G_csr, src, labels);
+  cusp::graph::breadth_first_search<MARK_PREDECESSORS>(G_csr, src, labels);
+}
+
+template<bool MARK_PREDECESSORS, typename MatrixType, typename ArrayType>
+void breadth_first_search(const MatrixType& G, const typename MatrixType::index_type src, ArrayType& labels,
+                          cusp::spmspv_direction direction, cusp::csr_format)
+{
+    cusp::graph::detail::direction_optimizing_bfs<MARK_PREDECESSORS>(G, src, labels, direction);
+}
+
+template<bool MARK_PREDECESSORS, typename MatrixType, typename ArrayType, typename Format>
+void breadth_first_search(const MatrixType& G, const typename MatrixType::index_type src, ArrayType& labels,
+                          cusp::spmspv_direction direction, Format)
+{
+  typedef typename MatrixType::index_type   IndexType;
+  typedef typename MatrixType::value_type   ValueType;
+  typedef typename MatrixType::memory_space MemorySpace;
+
+  cusp::csr_matrix<IndexType,ValueType,MemorySpace> G_csr(G);
+
+  cusp::graph::detail::direction_optimizing_bfs<MARK_PREDECESSORS>(G_csr, src, labels, direction);
+}
+
+template<typename MatrixType, typename ArrayType, typename IndexType, typename MemorySpace>
+void multi_source_breadth_first_search(const MatrixType& G, const ArrayType& sources,
+                                       cusp::array2d<IndexType,MemorySpace,cusp::column_major>& levels,
+                                       cusp::csr_format)
+{
+    cusp::graph::detail::multi_source_bfs(G, sources, levels);
+}
+
+template<typename MatrixType, typename ArrayType, typename IndexType, typename MemorySpace, typename Format>
+void multi_source_breadth_first_search(const MatrixType& G, const ArrayType& sources,
+                                       cusp::array2d<IndexType,MemorySpace,cusp::column_major>& levels,
+                                       Format)
+{
+  typedef typename MatrixType::value_type ValueType;
+
+  cusp::csr_matrix<IndexType,ValueType,MemorySpace> G_csr(G);
+
+  cusp::graph::detail::multi_source_bfs(G_csr, sources, levels);
 }
 
 } // end namespace detail
@@ -68,6 +109,32 @@ void breadth_first_search(const MatrixType& G, const typename MatrixType::index_
             typename MatrixType::format());
 }
 
+template<bool MARK_PREDECESSORS, typename MatrixType, typename ArrayType>
+void breadth_first_search(const MatrixType& G, const typename MatrixType::index_type src, ArrayType& labels,
+                          cusp::spmspv_direction direction)
+{
+    CUSP_PROFILE_SCOPED();
+
+    if(G.num_rows != G.num_cols)
+        throw cusp::invalid_input_exception("matrix must be square");
+
+    cusp::graph::detail::breadth_first_search<MARK_PREDECESSORS>(G, src, labels, direction,
+            typename MatrixType::format());
+}
+
+template<typename MatrixType, typename ArrayType, typename IndexType, typename MemorySpace>
+void multi_source_breadth_first_search(const MatrixType& G, const ArrayType& sources,
+                                       cusp::array2d<IndexType,MemorySpace,cusp::column_major>& levels)
+{
+    CUSP_PROFILE_SCOPED();
+
+    if(G.num_rows != G.num_cols)
+        throw cusp::invalid_input_exception("matrix must be square");
+
+    cusp::graph::detail::multi_source_breadth_first_search(G, sources, levels,
+            typename MatrixType::format());
+}
+
 } // end namespace graph
 } // end namespace cusp
 
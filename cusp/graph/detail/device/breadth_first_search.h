@@ -71,6 +71,8 @@ int STDOUT_COPY;
 #endif // end ifdef __CUSP_USE_B40C__
 
 #include <cusp/exception.h>
+#include <cusp/spmspv.h>
+#include <cusp/graph/detail/direction_optimizing_bfs.h>
 
 namespace cusp
 {
@@ -177,7 +179,8 @@ void breadth_first_search(const MatrixType& G, const typename MatrixType::index_
 
     CUSP_REOPEN_STDOUT;
 #else
-    throw cusp::not_implemented_exception("Device BFS implementation depends on B40C support.");
+    // without B40C the levels are expanded with sparse matrix-sparse vector products
+    cusp::graph::detail::direction_optimizing_bfs<MARK_PREDECESSORS>(G, src, labels, cusp::spmspv_auto);
 #endif
 }
 
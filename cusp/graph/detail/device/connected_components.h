@@ -14,13 +14,17 @@
  *  limitations under the License.
  */
 
-#include <cusp/exception.h>
-
 #include <cusp/array1d.h>
-#include <cusp/graph/breadth_first_search.h>
+#include <cusp/detail/format_utils.h>
 
-#include <thrust/scatter.h>
-#include <thrust/iterator/constant_iterator.h>
+#include <thrust/count.h>
+#include <thrust/fill.h>
+#include <thrust/for_each.h>
+#include <thrust/gather.h>
+#include <thrust/scan.h>
+#include <thrust/sequence.h>
+#include <thrust/transform.h>
+#include <thrust/iterator/counting_iterator.h>
 
 namespace cusp
 {
@@ -31,32 +35,139 @@ namespace detail
 namespace device
 {
 
+// Connected components by hooking and pointer jumping (Shiloach-Vishkin).
+// Every vertex points to a smaller one or to itself, so the parent
+// pointers form a forest whose roots are the smallest vertices of their
+// trees.  Each round the root of the larger label of an edge is hooked
+// onto the smaller label, reading the labels of the previous round so that
+// only roots are ever re-pointed, and the trees are then flattened.  The
+// number of rounds depends on the diameter of the components in the
+// worst case, not on their number.
+
+// parent[label[u]] <- label[v] for every edge whose label[v] < label[u]
+template <typename IndexType>
+struct cc_hook
+{
+    const IndexType * row_indices;
+    const IndexType * column_indices;
+    const IndexType * label;
+    IndexType * parent;
+    int * changed;
+
+    cc_hook(const IndexType * row_indices, const IndexType * column_indices,
+            const IndexType * label, IndexType * parent, int * changed)
+        : row_indices(row_indices), column_indices(column_indices),
+          label(label), parent(parent), changed(changed) {}
+
+    __host__ __device__
+    void operator()(const size_t n) const
+    {
+        const IndexType lu = label[row_indices[n]];
+        const IndexType lv = label[column_indices[n]];
+
+        if (lu == lv)
+            return;
+
+        // any of the racing writes leaves the root pointing to a smaller root
+        if (lv < lu)
+            parent[lu] = lv;
+        else
+            parent[lv] = lu;
+
+        *changed = 1;
+    }
+};
+
+// parent[i] <- root of i, concurrent writes only shorten the paths
+template <typename IndexType>
+struct cc_jump
+{
+    IndexType * parent;
+
+    cc_jump(IndexType * parent) : parent(parent) {}
+
+    __host__ __device__
+    void operator()(const IndexType i) const
+    {
+        IndexType r = parent[i];
+
+        while (parent[r] != r)
+            r = parent[r];
+
+        parent[i] = r;
+    }
+};
+
+template <typename IndexType>
+struct cc_is_root
+{
+    const IndexType * parent;
+
+    cc_is_root(const IndexType * parent) : parent(parent) {}
+
+    __host__ __device__
+    IndexType operator()(const IndexType i) const
+    {
+        return parent[i] == i ? 1 : 0;
+    }
+};
+
 template<typename MatrixType, typename ArrayType>
 size_t connected_components(const MatrixType& G, ArrayType& components)
 {
-    using namespace thrust::placeholders;
-
-    typedef typename MatrixType::index_type VertexId;
-
-    const VertexId UNSET = -1;
-    size_t num_components = 0;
-    VertexId num_rows = G.num_rows;
-
-    thrust::fill(components.begin(), components.end(), UNSET);
-    ArrayType levels(G.num_rows, UNSET);
-    VertexId src = rand() % G.num_rows;
-
-    while(src < num_rows) {
-        cusp::graph::breadth_first_search<false>(G, src, levels);
-        thrust::transform_if( thrust::constant_iterator<VertexId>(num_components),
-                              thrust::constant_iterator<VertexId>(num_components) + G.num_rows,
-                              levels.begin(), components.begin(), thrust::identity<VertexId>(), _1 != UNSET );
-    	thrust::fill(levels.begin(), levels.end(), UNSET);
-        src = thrust::find(components.begin(), components.end(), UNSET) - components.begin();
-        num_components++;
+    typedef typename MatrixType::index_type   VertexId;
+    typedef typename MatrixType::memory_space MemorySpace;
+
+    const VertexId num_rows = G.num_rows;
+
+    if (num_rows == 0)
+        return 0;
+
+    cusp::array1d<VertexId,MemorySpace> row_indices(G.num_entries);
+    cusp::detail::offsets_to_indices(G.row_offsets, row_indices);
+
+    cusp::array1d<VertexId,MemorySpace> parent(num_rows);
+    cusp::array1d<VertexId,MemorySpace> label(num_rows);
+    cusp::array1d<int,MemorySpace>      changed(1);
+
+    thrust::sequence(parent.begin(), parent.end());
+
+    const VertexId * rows    = G.num_entries ? thrust::raw_pointer_cast(&row_indices[0]) : 0;
+    const VertexId * columns = G.num_entries ? thrust::raw_pointer_cast(&G.column_indices[0]) : 0;
+
+    while (G.num_entries > 0)
+    {
+        label = parent;
+        changed[0] = 0;
+
+        thrust::for_each(thrust::counting_iterator<size_t>(0),
+                         thrust::counting_iterator<size_t>(G.num_entries),
+                         cc_hook<VertexId>(rows, columns,
+                                           thrust::raw_pointer_cast(&label[0]),
+                                           thrust::raw_pointer_cast(&parent[0]),
+                                           thrust::raw_pointer_cast(&changed[0])));
+
+        if (changed[0] == 0)
+            break;
+
+        thrust::for_each(thrust::counting_iterator<VertexId>(0),
+                         thrust::counting_iterator<VertexId>(num_rows),
+                         cc_jump<VertexId>(thrust::raw_pointer_cast(&parent[0])));
     }
 
-    return num_components;
+    // number the components in the order of their smallest vertex
+    cusp::array1d<VertexId,MemorySpace> component_of_root(num_rows);
+    thrust::transform(thrust::counting_iterator<VertexId>(0),
+                      thrust::counting_iterator<VertexId>(num_rows),
+                      component_of_root.begin(),
+                      cc_is_root<VertexId>(thrust::raw_pointer_cast(&parent[0])));
+
+    const VertexId last_is_root = component_of_root[num_rows - 1];
+    thrust::exclusive_scan(component_of_root.begin(), component_of_root.end(), component_of_root.begin());
+
+    thrust::gather(parent.begin(), parent.end(), component_of_root.begin(), components.begin());
+
+    return component_of_root[num_rows - 1] + last_is_root;
 }
 
 } // end namespace device
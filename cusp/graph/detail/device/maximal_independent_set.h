@@ -14,21 +14,25 @@
  *  limitations under the License.
  */
 
-#include <cusp/detail/device/generalized_spmv/csr_scalar.h>
-
-#include <cusp/copy.h>
 #include <cusp/array1d.h>
 #include <cusp/exception.h>
 #include <cusp/coo_matrix.h>
 #include <cusp/detail/random.h>
 #include <cusp/detail/format_utils.h>
 
+#include <thrust/copy.h>
 #include <thrust/count.h>
+#include <thrust/fill.h>
+#include <thrust/for_each.h>
+#include <thrust/remove.h>
+#include <thrust/sequence.h>
 #include <thrust/transform.h>
-#include <thrust/transform_scan.h>
 #include <thrust/iterator/constant_iterator.h>
 #include <thrust/iterator/counting_iterator.h>
-#include <thrust/iterator/zip_iterator.h>
+#include <thrust/iterator/permutation_iterator.h>
+
+#include <cstddef>
+#include <vector>
 
 namespace cusp
 {
@@ -39,226 +43,272 @@ namespace detail
 namespace device
 {
 
-struct process_mis_nodes
+// Luby-style MIS(k).  Every vertex carries the tuple (state, priority,
+// index), where the state of an undecided vertex is 1, of an MIS vertex 2
+// and of a non-MIS vertex 0, and the priority is a hash of the index
+// computed on the fly.  Each round finds the largest tuple in the k-ring
+// of every undecided vertex: the vertices which are their own maximum
+// join the MIS, and those whose maximum is an MIS vertex leave the graph.
+//
+// Decided vertices never change, so a round only computes ring r of the
+// vertices within distance k - r of an undecided one.  These are kept in
+// compacted lists, the first of which is the list of undecided vertices,
+// and ring r of such a vertex only reads ring r - 1 of itself and of its
+// neighbors, which lie in the next list.  Late rounds, which decide few
+// vertices, therefore touch only the rows around them.
+
+template <typename IndexType, typename NodeStateType, typename RandomType>
+struct mis_ring_maximum
 {
-    template <typename Tuple>
+    // the hash of cusp::detail::random_integers
+    typedef cusp::detail::detail::random_integer_functor<ptrdiff_t,RandomType> Priority;
+
+    const IndexType * Ap;
+    const IndexType * Aj;
+    const NodeStateType * states;
+    Priority priority;
+
+    // ring r - 1, or NULL for r == 1, whose ring 0 is the vertex itself
+    const NodeStateType * last_states;
+    const RandomType * last_values;
+    const IndexType * last_indices;
+
+    NodeStateType * maximal_states;
+    RandomType * maximal_values;
+    IndexType * maximal_indices;
+
+    mis_ring_maximum(const IndexType * Ap, const IndexType * Aj, const NodeStateType * states, const Priority priority,
+                     const NodeStateType * last_states, const RandomType * last_values, const IndexType * last_indices,
+                     NodeStateType * maximal_states, RandomType * maximal_values, IndexType * maximal_indices)
+        : Ap(Ap), Aj(Aj), states(states), priority(priority),
+          last_states(last_states), last_values(last_values), last_indices(last_indices),
+          maximal_states(maximal_states), maximal_values(maximal_values), maximal_indices(maximal_indices) {}
+
     __host__ __device__
-    void operator()(Tuple t)
+    void load(const IndexType j, NodeStateType& s, RandomType& v, IndexType& n) const
     {
-        if (thrust::get<1>(t) == 1)                     // undecided node
+        if (last_states == NULL)
+        {
+            s = states[j];
+            v = priority(ptrdiff_t(j));
+            n = j;
+        }
+        else
         {
-            if (thrust::get<0>(t) == thrust::get<3>(t)) // i == maximal_index
-              thrust::get<1>(t) = 2;                    // mis_node
+            s = last_states[j];
+            v = last_values[j];
+            n = last_indices[j];
         }
     }
+
+    __host__ __device__
+    void operator()(const IndexType i) const
+    {
+        NodeStateType s;
+        RandomType    v;
+        IndexType     n;
+
+        load(i, s, v, n);
+
+        for(IndexType jj = Ap[i]; jj < Ap[i + 1]; jj++)
+        {
+            NodeStateType t;
+            RandomType    w;
+            IndexType     m;
+
+            load(Aj[jj], t, w, m);
+
+            // lexicographic comparison of (state, priority, index)
+            if (t > s || (t == s && (w > v || (w == v && m > n))))
+            {
+                s = t;
+                v = w;
+                n = m;
+            }
+        }
+
+        maximal_states[i]  = s;
+        maximal_values[i]  = v;
+        maximal_indices[i] = n;
+    }
 };
 
+// undecided vertices which are the maximum of their k-ring join the MIS
+template <typename IndexType, typename NodeStateType>
+struct process_mis_nodes
+{
+    const IndexType * maximal_indices;
+    NodeStateType * states;
+
+    process_mis_nodes(const IndexType * maximal_indices, NodeStateType * states)
+        : maximal_indices(maximal_indices), states(states) {}
+
+    __host__ __device__
+    void operator()(const IndexType i) const
+    {
+        if (maximal_indices[i] == i)
+            states[i] = 2;
+    }
+};
+
+// undecided vertices whose k-ring maximum is an MIS vertex leave the graph
+template <typename IndexType, typename NodeStateType>
 struct process_non_mis_nodes
 {
-    template <typename Tuple>
+    const IndexType * maximal_indices;
+    NodeStateType * states;
+
+    process_non_mis_nodes(const IndexType * maximal_indices, NodeStateType * states)
+        : maximal_indices(maximal_indices), states(states) {}
+
     __host__ __device__
-    void operator()(Tuple t)
+    void operator()(const IndexType i) const
     {
-        if (thrust::get<0>(t) == 1)            // undecided node
-        {
-            if (thrust::get<1>(t) == 2)        // maximal_state == mis_node
-              thrust::get<0>(t) = 0;           // non_mis_node
-        }
+        if (states[i] == 1 && states[maximal_indices[i]] == 2)
+            states[i] = 0;
     }
 };
 
-struct is_subgraph_edge
+// marks the neighbors of the vertices of a list
+template <typename IndexType>
+struct mark_neighbors
 {
-  template <typename Tuple>
-  __host__ __device__
-  bool operator()(const Tuple& t) const
-  {
-    return thrust::get<0>(t) && thrust::get<1>(t);
-  }
+    const IndexType * Ap;
+    const IndexType * Aj;
+    unsigned char * reached;
+
+    mark_neighbors(const IndexType * Ap, const IndexType * Aj, unsigned char * reached)
+        : Ap(Ap), Aj(Aj), reached(reached) {}
+
+    __host__ __device__
+    void operator()(const IndexType i) const
+    {
+        for(IndexType jj = Ap[i]; jj < Ap[i + 1]; jj++)
+            reached[Aj[jj]] = 1;
+    }
 };
 
 template <typename NodeStateType>
-struct is_active_node
+struct is_decided_node
 {
-  __host__ __device__
-  bool operator()(const NodeStateType& s) const
-  {
-    return s == 1;
-  }
+    const NodeStateType * states;
+
+    is_decided_node(const NodeStateType * states)
+        : states(states) {}
+
+    template <typename IndexType>
+    __host__ __device__
+    bool operator()(const IndexType i) const
+    {
+        return states[i] != 1;
+    }
 };
 
+struct is_reached_node
+{
+    __host__ __device__
+    bool operator()(const unsigned char r) const
+    {
+        return r != 0;
+    }
+};
 
 template <typename Array1,
           typename Array2,
-          typename Array3,
-          typename Array4>
+          typename Array3>
 void compute_mis_states(const size_t k,
                         const Array1& row_indices,
                         const Array2& column_indices,
-                        const Array3& random_values,
-                              Array4& states)
+                              Array3& states)
 {
     typedef typename Array1::value_type   IndexType;
-    typedef typename Array3::value_type   RandomType;
-    typedef typename Array4::value_type   NodeStateType;
+    typedef typename Array3::value_type   NodeStateType;
     typedef typename Array1::memory_space MemorySpace;
+    typedef unsigned int                  RandomType;
 
-    typedef typename thrust::tuple<NodeStateType,RandomType,IndexType> Tuple;
-    
-    const size_t N = states.size();
+    typedef mis_ring_maximum<IndexType,NodeStateType,RandomType> RingMaximum;
 
-    const IndexType num_rows    = states.size();
-    //const IndexType num_entries = row_indices.size();
+    const size_t N = states.size();
 
-    // TODO remove this WAR when generalize COO SpMV problem is resolved
-    cusp::array1d<IndexType,MemorySpace> row_offsets(num_rows + 1);
+    cusp::array1d<IndexType,MemorySpace> row_offsets(N + 1);
     cusp::detail::indices_to_offsets(row_indices, row_offsets);
-    
-    cusp::array1d<NodeStateType,MemorySpace> maximal_states(N);
-    cusp::array1d<RandomType,MemorySpace>    maximal_values(N);
-    cusp::array1d<IndexType,MemorySpace>     maximal_indices(N);
 
-    cusp::array1d<NodeStateType,MemorySpace> last_states;
-    cusp::array1d<RandomType,MemorySpace>    last_values;
-    cusp::array1d<IndexType,MemorySpace>     last_indices;;
-    
-    // TODO choose threshold in a more principled manner
-//    size_t compaction_threshold = (N < 10000) ? 0 : N / 10;
-    size_t active_nodes = N;
-    
-//    size_t num_iters = 0;
+    const IndexType * Ap = thrust::raw_pointer_cast(&row_offsets[0]);
+    const IndexType * Aj = column_indices.size() == 0 ? NULL : thrust::raw_pointer_cast(&column_indices[0]);
+    NodeStateType * states_ptr = thrust::raw_pointer_cast(&states[0]);
+
+    // ring r is only read by ring r + 1, so two buffers suffice
+    cusp::array1d<NodeStateType,MemorySpace> maximal_states(N,  cusp::uninitialized);
+    cusp::array1d<RandomType,MemorySpace>    maximal_values(N,  cusp::uninitialized);
+    cusp::array1d<IndexType,MemorySpace>     maximal_indices(N, cusp::uninitialized);
+    cusp::array1d<NodeStateType,MemorySpace> last_states(k > 1 ? N : 0,  cusp::uninitialized);
+    cusp::array1d<RandomType,MemorySpace>    last_values(k > 1 ? N : 0,  cusp::uninitialized);
+    cusp::array1d<IndexType,MemorySpace>     last_indices(k > 1 ? N : 0, cusp::uninitialized);
+
+    cusp::array1d<unsigned char,MemorySpace> reached(k > 1 ? N : 0);
+
+    // lists[d] <- vertices within distance d of an undecided vertex
+    std::vector< cusp::array1d<IndexType,MemorySpace> > lists(k);
 
-    do
+    // every vertex is undecided at first
+    lists[0].resize(N, cusp::uninitialized);
+    thrust::sequence(lists[0].begin(), lists[0].end(), IndexType(0));
+    lists[0].resize(thrust::remove_if(lists[0].begin(), lists[0].end(), is_decided_node<NodeStateType>(states_ptr)) - lists[0].begin());
+
+    const typename RingMaximum::Priority priority(0);
+
+    while (lists[0].size() > 0)
     {
-        // find the largest (state,value,index) 1-ring neighbor for each node
-        cusp::detail::device::cuda::spmv_csr_scalar
-            (num_rows,
-             row_offsets.begin(), column_indices.begin(), thrust::constant_iterator<Tuple>(Tuple(0,0)),  // XXX should we mask explicit zeros? (e.g. DIA, array2d)
-             thrust::make_zip_iterator(thrust::make_tuple(states.begin(), random_values.begin(), thrust::counting_iterator<IndexType>(0))),
-             thrust::make_zip_iterator(thrust::make_tuple(states.begin(), random_values.begin(), thrust::counting_iterator<IndexType>(0))),
-             thrust::make_zip_iterator(thrust::make_tuple(maximal_states.begin(), maximal_values.begin(), maximal_indices.begin())),
-             thrust::project2nd<Tuple,Tuple>(), thrust::maximum<Tuple>());
-        //cusp::detail::device::cuda::spmv_coo
-        //    (num_rows, num_entries,
-        //     row_indices.begin(), column_indices.begin(), thrust::constant_iterator<Tuple>(Tuple(0,0)),  // XXX should we mask explicit zeros? (e.g. DIA, array2d)
-        //     thrust::make_zip_iterator(thrust::make_tuple(states.begin(), random_values.begin(), thrust::counting_iterator<IndexType>(0))),
-        //     thrust::make_zip_iterator(thrust::make_tuple(states.begin(), random_values.begin(), thrust::counting_iterator<IndexType>(0))),
-        //     thrust::make_zip_iterator(thrust::make_tuple(maximal_states.begin(), maximal_values.begin(), maximal_indices.begin())),
-        //     thrust::project2nd<Tuple,Tuple>(), thrust::maximum<Tuple>());
-
-        // find the largest (state,value,index) k-ring neighbor for each node (if k > 1)
-        for(size_t ring = 1; ring < k; ring++)
+        // grow the lists one ring at a time from the undecided vertices
+        for(size_t d = 1; d < k; d++)
         {
-            last_states.resize (N); last_states.swap (maximal_states);
-            last_values.resize (N); last_values.swap (maximal_values);
-            last_indices.resize(N); last_indices.swap(maximal_indices);
-
-            // TODO replace with call to generalized method
-            cusp::detail::device::cuda::spmv_csr_scalar
-                (num_rows,
-                 row_offsets.begin(), column_indices.begin(), thrust::constant_iterator<Tuple>(Tuple(0,0)),  // XXX should we mask explicit zeros? (e.g. DIA, array2d)
-                 thrust::make_zip_iterator(thrust::make_tuple(last_states.begin(), last_values.begin(), last_indices.begin())),
-                 thrust::make_zip_iterator(thrust::make_tuple(last_states.begin(), last_values.begin(), last_indices.begin())),
-                 thrust::make_zip_iterator(thrust::make_tuple(maximal_states.begin(), maximal_values.begin(), maximal_indices.begin())),
-                 thrust::project2nd<Tuple,Tuple>(), thrust::maximum<Tuple>());
+            thrust::fill(reached.begin(), reached.end(), (unsigned char) 0);
+            thrust::fill(thrust::make_permutation_iterator(reached.begin(), lists[d - 1].begin()),
+                         thrust::make_permutation_iterator(reached.begin(), lists[d - 1].end()),
+                         (unsigned char) 1);
+            thrust::for_each(lists[d - 1].begin(), lists[d - 1].end(),
+                             mark_neighbors<IndexType>(Ap, Aj, thrust::raw_pointer_cast(&reached[0])));
+
+            lists[d].resize(thrust::count_if(reached.begin(), reached.end(), is_reached_node()), cusp::uninitialized);
+            thrust::copy_if(thrust::counting_iterator<IndexType>(0), thrust::counting_iterator<IndexType>(N),
+                            reached.begin(), lists[d].begin(), is_reached_node());
         }
-       
+
+        // ring r of the vertices within distance k - r of an undecided vertex
+        for(size_t r = 1; r <= k; r++)
+        {
+            const cusp::array1d<IndexType,MemorySpace>& list = lists[k - r];
+
+            if (r > 1)
+            {
+                last_states.swap(maximal_states);
+                last_values.swap(maximal_values);
+                last_indices.swap(maximal_indices);
+            }
+
+            thrust::for_each(list.begin(), list.end(),
+                             RingMaximum(Ap, Aj, states_ptr, priority,
+                                         r == 1 ? NULL : thrust::raw_pointer_cast(&last_states[0]),
+                                         r == 1 ? NULL : thrust::raw_pointer_cast(&last_values[0]),
+                                         r == 1 ? NULL : thrust::raw_pointer_cast(&last_indices[0]),
+                                         thrust::raw_pointer_cast(&maximal_states[0]),
+                                         thrust::raw_pointer_cast(&maximal_values[0]),
+                                         thrust::raw_pointer_cast(&maximal_indices[0])));
+        }
+
+        const IndexType * maximal_indices_ptr = thrust::raw_pointer_cast(&maximal_indices[0]);
+
         // label local maxima as MIS nodes
-        thrust::for_each(thrust::make_zip_iterator(thrust::make_tuple(thrust::counting_iterator<IndexType>(0), states.begin(), maximal_states.begin(), maximal_indices.begin())),
-                         thrust::make_zip_iterator(thrust::make_tuple(thrust::counting_iterator<IndexType>(0), states.begin(), maximal_states.begin(), maximal_indices.begin())) + N,
-                         process_mis_nodes());
-        
+        thrust::for_each(lists[0].begin(), lists[0].end(),
+                         process_mis_nodes<IndexType,NodeStateType>(maximal_indices_ptr, states_ptr));
+
         // label k-ring neighbors of MIS nodes as non-MIS nodes
-        thrust::for_each(thrust::make_zip_iterator(thrust::make_tuple(states.begin(), thrust::make_permutation_iterator(states.begin(), maximal_indices.begin()))),
-                         thrust::make_zip_iterator(thrust::make_tuple(states.begin(), thrust::make_permutation_iterator(states.begin(), maximal_indices.begin()))) + N,
-                         process_non_mis_nodes());
+        thrust::for_each(lists[0].begin(), lists[0].end(),
+                         process_non_mis_nodes<IndexType,NodeStateType>(maximal_indices_ptr, states_ptr));
 
-        active_nodes = thrust::count(states.begin(), states.end(), 1);
-        
-//        num_iters++;
-//        std::cout << "(iter " <<  num_iters << "," << (double(active_nodes) / double(N)) << ")" << std::endl;
-//        std::cout << "N= " << N << " iteration=" << num_iters << " active_nodes=" << active_nodes << " compaction_threshold=" << compaction_threshold << "\n";
-//        std::cout << "states\n";
-//        cusp::print(states);
-//
-//        if (active_nodes < compaction_threshold)
-//        {
-//            cusp::array1d<bool,MemorySpace> retained_nodes(N);
-//            cusp::array1d<bool,MemorySpace> last_retained_nodes(N);
-//
-//            thrust::transform(maximal_states.begin(), maximal_states.end(), thrust::constant_iterator<NodeStateType>(1), retained_nodes.begin(), thrust::equal_to<NodeStateType>());
-//
-//            // propagate retained region outward
-//            for(size_t ring = 1; 2*ring <= k; ring++)
-//            {
-//                retained_nodes.swap(last_retained_nodes);
-//
-//                // TODO replace with call to generalized method
-//                cusp::detail::device::cuda::spmv_coo
-//                    (num_rows, num_entries,
-//                     row_indices.begin(), column_indices.begin(), thrust::constant_iterator<bool>(false), 
-//                     last_retained_nodes.begin(),
-//                     last_retained_nodes.begin(),
-//                     retained_nodes.begin(),
-//                     thrust::project2nd<bool,bool>(), thrust::logical_or<bool>());
-//            }
-//        
-//            std::cout << "retained nodes\n";
-//            cusp::print(retained_nodes);
-//
-//            size_t num_subgraph_nodes = thrust::count(retained_nodes.begin(), retained_nodes.end(), true);
-//            size_t num_subgraph_edges = thrust::count
-//                (thrust::make_zip_iterator(thrust::make_tuple(thrust::make_permutation_iterator(retained_nodes.begin(), row_indices.begin()),
-//                                                              thrust::make_permutation_iterator(retained_nodes.begin(), column_indices.begin()))),
-//                 thrust::make_zip_iterator(thrust::make_tuple(thrust::make_permutation_iterator(retained_nodes.begin(), row_indices.end()),
-//                                                              thrust::make_permutation_iterator(retained_nodes.begin(), column_indices.end()))),
-//                 thrust::make_tuple(true,true));
-//
-//
-//            std::cout << "subgraph nodes: " << double(100*num_subgraph_nodes)/N << "% edges " << double(100*num_subgraph_edges)/num_entries << "%" << std::endl;
-//
-//            // map old indices into subgraph indices
-//            cusp::array1d<IndexType, MemorySpace> index_map(N);
-//            thrust::transform_exclusive_scan(retained_nodes.begin(), retained_nodes.end(), index_map.begin(), thrust::identity<IndexType>(), IndexType(0), thrust::plus<IndexType>());
-//            
-//            std::cout << "index map\n";
-//            cusp::print(index_map);
-//    
-//            // storage for subgraph
-//            cusp::array1d<IndexType,     MemorySpace> subgraph_row_indices(num_subgraph_edges);
-//            cusp::array1d<IndexType,     MemorySpace> subgraph_column_indices(num_subgraph_edges);
-//            cusp::array1d<NodeStateType, MemorySpace> subgraph_states(num_subgraph_nodes);
-//            cusp::array1d<RandomType,    MemorySpace> subgraph_random_values(num_subgraph_nodes);
-//            
-//            thrust::copy_if
-//                (thrust::make_zip_iterator(thrust::make_tuple(thrust::make_permutation_iterator(index_map.begin(), row_indices.begin()),
-//                                                              thrust::make_permutation_iterator(index_map.begin(), column_indices.begin()))),
-//                 thrust::make_zip_iterator(thrust::make_tuple(thrust::make_permutation_iterator(index_map.begin(), row_indices.end()),
-//                                                              thrust::make_permutation_iterator(index_map.begin(), column_indices.end()))),
-//                 thrust::make_zip_iterator(thrust::make_tuple(thrust::make_permutation_iterator(retained_nodes.begin(), row_indices.begin()),
-//                                                              thrust::make_permutation_iterator(retained_nodes.begin(), column_indices.begin()))),
-//                 thrust::make_zip_iterator(thrust::make_tuple(subgraph_row_indices.begin(),
-//                                                              subgraph_column_indices.begin())),
-//                 is_subgraph_edge());
-//
-//            thrust::scatter_if
-//                (thrust::make_zip_iterator(thrust::make_tuple(states.begin(), random_values.begin())),
-//                 thrust::make_zip_iterator(thrust::make_tuple(states.end(),   random_values.end())),
-//                 index_map.begin(),
-//                 retained_nodes.begin(),
-//                 thrust::make_zip_iterator(thrust::make_tuple(subgraph_states.begin(), subgraph_random_values.begin())));
-//        
-//    
-//            compute_mis_states(k, subgraph_row_indices, subgraph_column_indices, subgraph_random_values, subgraph_states);
-//
-//            // update active node states from subgraph
-//            thrust::gather_if(index_map.begin(), index_map.end(),
-//                              retained_nodes.begin(),
-//                              subgraph_states.begin(),
-//                              states.begin());
-//            return;
-//        }
-    } while (active_nodes > 0);
+        // compact the undecided vertices
+        lists[0].resize(thrust::remove_if(lists[0].begin(), lists[0].end(), is_decided_node<NodeStateType>(states_ptr)) - lists[0].begin());
+    }
 }
 
 
@@ -270,19 +320,15 @@ template <typename Matrix, typename Array>
 size_t maximal_independent_set(const Matrix& A, Array& stencil, size_t k)
 {
     typedef typename Matrix::index_type   IndexType;
-    typedef typename Matrix::value_type   ValueType;
     typedef typename Matrix::memory_space MemorySpace;
-    typedef unsigned int  RandomType;
     typedef unsigned char NodeStateType;
         
     const IndexType N = A.num_rows;
     
-    cusp::array1d<RandomType,MemorySpace> random_values(N);
-    cusp::copy(cusp::detail::random_integers<RandomType>(N), random_values);
-
     cusp::array1d<NodeStateType,MemorySpace> states(N, 1);
 
-    compute_mis_states(k, A.row_indices, A.column_indices, random_values, states);
+    if (N > 0)
+        compute_mis_states(k, A.row_indices, A.column_indices, states);
     
     // resize output
     stencil.resize(N);
@@ -298,4 +344,3 @@ size_t maximal_independent_set(const Matrix& A, Array& stencil, size_t k)
 } // end namespace detail
 } // end namespace graph
 } // end namespace cusp
-
@@ -18,15 +18,13 @@
 
 #include <cusp/array1d.h>
 
-#include <cusp/graph/breadth_first_search.h>
+#include <cusp/graph/detail/flow_network.h>
 
-#include <cusp/detail/device/arch.h>
-#include <cusp/detail/device/common.h>
-#include <cusp/detail/device/utils.h>
-#include <cusp/detail/device/texture.h>
-
-#include <thrust/scatter.h>
-#include <thrust/iterator/constant_iterator.h>
+#include <thrust/count.h>
+#include <thrust/fill.h>
+#include <thrust/for_each.h>
+#include <thrust/transform.h>
+#include <thrust/iterator/counting_iterator.h>
 
 namespace cusp
 {
@@ -38,203 +36,315 @@ namespace device
 {
 namespace detail
 {
-template <typename IndexType, typename ValueType, unsigned int VECTORS_PER_BLOCK, unsigned int THREADS_PER_VECTOR>
-__launch_bounds__(VECTORS_PER_BLOCK * THREADS_PER_VECTOR,1)
-__global__ void
-bfs_edge_index_locator_kernel(const IndexType num_rows,
-                              const IndexType * Ap,
-                              const IndexType * Aj,
-                              const ValueType * Ax,
-                              const IndexType * bfs_tree,
-                              IndexType * positions)
+
+// Synchronous push-relabel.  Every round each active vertex pushes along
+// its admissible edges (height one less than its own) into per-edge slots,
+// then every vertex gathers the pushes sent to it through the reverse
+// edges, and finally active vertices without admissible edges relabel
+// from the heights of the previous round.  Writes never overlap, so a
+// round needs no atomics.
+
+template <typename IndexType>
+__host__ __device__
+bool is_active(const IndexType v, const IndexType src, const IndexType sink,
+               const IndexType height, const IndexType limit, const bool positive_excess)
 {
-    __shared__ volatile IndexType ptrs[VECTORS_PER_BLOCK][2];
-    __shared__ volatile IndexType perm_row[VECTORS_PER_BLOCK];
+    return positive_excess && v != src && v != sink && height < limit;
+}
 
-    const IndexType THREADS_PER_BLOCK = VECTORS_PER_BLOCK * THREADS_PER_VECTOR;
+template <typename IndexType, typename ValueType>
+struct active_vertex
+{
+    const ValueType * excess;
+    const IndexType * height;
+    IndexType src, sink, limit;
 
-    const IndexType thread_id   = THREADS_PER_BLOCK * blockIdx.x + threadIdx.x;    // global thread index
-    const IndexType thread_lane = threadIdx.x & (THREADS_PER_VECTOR - 1);          // thread index within the vector
-    const IndexType vector_id   = thread_id   /  THREADS_PER_VECTOR;               // global vector index
-    const IndexType vector_lane = threadIdx.x /  THREADS_PER_VECTOR;               // vector index within the block
-    const IndexType num_vectors = VECTORS_PER_BLOCK * gridDim.x;                   // total number of active vectors
+    active_vertex(const ValueType * excess, const IndexType * height,
+                  const IndexType src, const IndexType sink, const IndexType limit)
+        : excess(excess), height(height), src(src), sink(sink), limit(limit) {}
 
-    for(IndexType row = vector_id; row < num_rows; row += num_vectors)
+    __host__ __device__
+    bool operator()(const IndexType v) const
     {
-        if(thread_lane == 0)
-            perm_row[vector_lane] = bfs_tree[row];
-
-        if(perm_row[vector_lane] < 0) continue;
-        // use two threads to fetch Ap[row] and Ap[row+1]
-        // this is considerably faster than the straightforward version
-        if(thread_lane < 2)
-            ptrs[vector_lane][thread_lane] = Ap[perm_row[vector_lane] + thread_lane];
-
-        const IndexType row_start = ptrs[vector_lane][0];                   //same as: row_start = Ap[row];
-        const IndexType row_end   = ptrs[vector_lane][1];                   //same as: row_end   = Ap[row+1];
-
-        // check current row neighbors
-        for(IndexType jj = row_start + thread_lane; jj < row_end; jj += THREADS_PER_VECTOR)
-            if(Aj[jj] == row) {
-                positions[row] = jj;
-            }
+        return is_active(v, src, sink, height[v], limit, excess[v] > ValueType(0));
     }
-}
+};
 
-template <unsigned int THREADS_PER_VECTOR, typename Matrix, typename ArrayType>
-void __bfs_edge_index_locator(const Matrix&    A,
-                              const ArrayType& bfs_tree,
-                              ArrayType& positions)
+// send excess along the edges of the source
+template <typename IndexType, typename ValueType>
+struct saturate_edge
 {
-    typedef typename Matrix::index_type IndexType;
-    typedef typename Matrix::value_type ValueType;
-
-    const size_t THREADS_PER_BLOCK  = 128;
-    const size_t VECTORS_PER_BLOCK  = THREADS_PER_BLOCK / THREADS_PER_VECTOR;
+    const IndexType * Aj;
+    const IndexType * reverse;
+    ValueType * residual;
+    ValueType * excess;
 
-    const size_t MAX_BLOCKS = cusp::detail::device::arch::max_active_blocks(bfs_edge_index_locator_kernel<IndexType, ValueType, VECTORS_PER_BLOCK, THREADS_PER_VECTOR>, THREADS_PER_BLOCK, (size_t) 0);
-    const size_t NUM_BLOCKS = std::min<size_t>(MAX_BLOCKS, cusp::detail::device::DIVIDE_INTO(A.num_rows, VECTORS_PER_BLOCK));
+    saturate_edge(const IndexType * Aj, const IndexType * reverse, ValueType * residual, ValueType * excess)
+        : Aj(Aj), reverse(reverse), residual(residual), excess(excess) {}
 
-    bfs_edge_index_locator_kernel<IndexType, ValueType, VECTORS_PER_BLOCK, THREADS_PER_VECTOR> <<<NUM_BLOCKS, THREADS_PER_BLOCK>>>
-    (A.num_rows,
-     thrust::raw_pointer_cast(&A.row_offsets[0]),
-     thrust::raw_pointer_cast(&A.column_indices[0]),
-     thrust::raw_pointer_cast(&A.values[0]),
-     thrust::raw_pointer_cast(&bfs_tree[0]),
-     thrust::raw_pointer_cast(&positions[0]));
-}
+    __host__ __device__
+    void operator()(const IndexType k) const
+    {
+        const ValueType c = residual[k];
+        residual[k] = ValueType(0);
+        residual[reverse[k]] += c;
+        excess[Aj[k]] += c;
+    }
+};
 
-template <typename Matrix,
-         typename ArrayType>
-void bfs_edge_index_locator(const Matrix&    A,
-                            const ArrayType& bfs_tree,
-                            ArrayType& positions)
+template <typename IndexType, typename ValueType>
+struct push_vertex
 {
-    typedef typename Matrix::index_type IndexType;
+    const IndexType * Ap;
+    const IndexType * Aj;
+    const IndexType * height;
+    ValueType * residual;
+    ValueType * excess;
+    ValueType * pushed;
+    IndexType src, sink, limit;
+
+    push_vertex(const IndexType * Ap, const IndexType * Aj, const IndexType * height,
+                ValueType * residual, ValueType * excess, ValueType * pushed,
+                const IndexType src, const IndexType sink, const IndexType limit)
+        : Ap(Ap), Aj(Aj), height(height), residual(residual), excess(excess), pushed(pushed),
+          src(src), sink(sink), limit(limit) {}
+
+    __host__ __device__
+    void operator()(const IndexType v) const
+    {
+        const IndexType h = height[v];
+        ValueType e = excess[v];
+
+        const bool active = is_active(v, src, sink, h, limit, e > ValueType(0));
+
+        for (IndexType k = Ap[v]; k < Ap[v + 1]; k++)
+        {
+            ValueType delta = ValueType(0);
+
+            if (active && e > ValueType(0) && residual[k] > ValueType(0) && height[Aj[k]] == h - 1)
+            {
+                delta = e < residual[k] ? e : residual[k];
+                residual[k] -= delta;
+                e -= delta;
+            }
 
-    const IndexType nnz_per_row = A.num_entries / A.num_rows;
+            pushed[k] = delta;
+        }
 
-    if (nnz_per_row <=  2) {
-        __bfs_edge_index_locator<2>(A, bfs_tree, positions);
-        return;
+        excess[v] = e;
     }
-    if (nnz_per_row <=  4) {
-        __bfs_edge_index_locator<4>(A, bfs_tree, positions);
-        return;
+};
+
+template <typename IndexType, typename ValueType>
+struct gather_vertex
+{
+    const IndexType * Ap;
+    const IndexType * reverse;
+    const ValueType * pushed;
+    ValueType * residual;
+    ValueType * excess;
+
+    gather_vertex(const IndexType * Ap, const IndexType * reverse, const ValueType * pushed,
+                  ValueType * residual, ValueType * excess)
+        : Ap(Ap), reverse(reverse), pushed(pushed), residual(residual), excess(excess) {}
+
+    __host__ __device__
+    void operator()(const IndexType v) const
+    {
+        ValueType e = excess[v];
+
+        for (IndexType k = Ap[v]; k < Ap[v + 1]; k++)
+        {
+            const ValueType delta = pushed[reverse[k]];
+            residual[k] += delta;
+            e += delta;
+        }
+
+        excess[v] = e;
     }
-    if (nnz_per_row <=  8) {
-        __bfs_edge_index_locator<8>(A, bfs_tree, positions);
-        return;
+};
+
+template <typename IndexType, typename ValueType>
+struct relabel_vertex
+{
+    const IndexType * Ap;
+    const IndexType * Aj;
+    const IndexType * height;
+    const ValueType * residual;
+    const ValueType * excess;
+    IndexType * new_height;
+    IndexType src, sink, limit;
+
+    relabel_vertex(const IndexType * Ap, const IndexType * Aj, const IndexType * height,
+                   const ValueType * residual, const ValueType * excess, IndexType * new_height,
+                   const IndexType src, const IndexType sink, const IndexType limit)
+        : Ap(Ap), Aj(Aj), height(height), residual(residual), excess(excess), new_height(new_height),
+          src(src), sink(sink), limit(limit) {}
+
+    __host__ __device__
+    void operator()(const IndexType v) const
+    {
+        const IndexType h = height[v];
+
+        new_height[v] = h;
+
+        if (!is_active(v, src, sink, h, limit, excess[v] > ValueType(0)))
+            return;
+
+        IndexType min_height = limit - 1;
+
+        for (IndexType k = Ap[v]; k < Ap[v + 1]; k++)
+        {
+            if (residual[k] > ValueType(0))
+            {
+                const IndexType hu = height[Aj[k]];
+
+                if (hu == h - 1)
+                    return;
+
+                if (hu < min_height)
+                    min_height = hu;
+            }
+        }
+
+        new_height[v] = min_height + 1;
     }
-    if (nnz_per_row <= 16) {
-        __bfs_edge_index_locator<16>(A, bfs_tree, positions);
-        return;
+};
+
+// exact heights from the residual distances to the target
+template <typename IndexType>
+struct height_from_distance
+{
+    IndexType base, limit;
+
+    height_from_distance(const IndexType base, const IndexType limit)
+        : base(base), limit(limit) {}
+
+    __host__ __device__
+    IndexType operator()(const IndexType d) const
+    {
+        return d < 0 ? limit : base + d;
     }
+};
+
+// rounds between global relabels, which reset every height to the
+// residual distance found by a BFS from the target
+const size_t GLOBAL_RELABEL_INTERVAL = 8;
+
+// Moves the excess of the active vertices towards target until none is
+// left with height below limit.  With target the sink and limit N this is
+// the first phase of push-relabel and leaves a maximum preflow; with
+// target the source and heights offset by N it returns the excess which
+// cannot reach the sink to the source.
+template <typename IndexType, typename ValueType, typename MemorySpace>
+void discharge(const cusp::graph::detail::flow_network<IndexType,ValueType,MemorySpace>& network,
+               cusp::array1d<ValueType,MemorySpace>& residual,
+               cusp::array1d<ValueType,MemorySpace>& excess,
+               const IndexType src, const IndexType sink,
+               const IndexType target, const IndexType base, const IndexType limit)
+{
+    const IndexType N = network.num_vertices;
+
+    cusp::array1d<IndexType,MemorySpace> height(N);
+    cusp::array1d<IndexType,MemorySpace> new_height(N);
+    cusp::array1d<IndexType,MemorySpace> distance(N);
+    cusp::array1d<ValueType,MemorySpace> pushed(network.num_edges);
+
+    const IndexType * Ap      = thrust::raw_pointer_cast(&network.row_offsets[0]);
+    const IndexType * Aj      = network.num_edges == 0 ? NULL : thrust::raw_pointer_cast(&network.column_indices[0]);
+    const IndexType * reverse = network.num_edges == 0 ? NULL : thrust::raw_pointer_cast(&network.reverse[0]);
+    ValueType * residual_ptr  = network.num_edges == 0 ? NULL : thrust::raw_pointer_cast(&residual[0]);
+    ValueType * pushed_ptr    = network.num_edges == 0 ? NULL : thrust::raw_pointer_cast(&pushed[0]);
+    ValueType * excess_ptr    = thrust::raw_pointer_cast(&excess[0]);
+
+    thrust::counting_iterator<IndexType> first(0);
+    thrust::counting_iterator<IndexType> last(N);
+
+    for (size_t round = 0; ; round++)
+    {
+        if (round % GLOBAL_RELABEL_INTERVAL == 0)
+        {
+            network.distance_to(residual, target, distance);
+            thrust::transform(distance.begin(), distance.end(), height.begin(),
+                              height_from_distance<IndexType>(base, limit));
+            height[src] = N;
+        }
 
-    __bfs_edge_index_locator<32>(A, bfs_tree, positions);
+        const IndexType * height_ptr = thrust::raw_pointer_cast(&height[0]);
+
+        if (thrust::count_if(first, last, active_vertex<IndexType,ValueType>(excess_ptr, height_ptr, src, sink, limit)) == 0)
+            break;
+
+        thrust::for_each(first, last,
+                         push_vertex<IndexType,ValueType>(Ap, Aj, height_ptr, residual_ptr, excess_ptr, pushed_ptr,
+                                                          src, sink, limit));
+        thrust::for_each(first, last,
+                         gather_vertex<IndexType,ValueType>(Ap, reverse, pushed_ptr, residual_ptr, excess_ptr));
+        thrust::for_each(first, last,
+                         relabel_vertex<IndexType,ValueType>(Ap, Aj, height_ptr, residual_ptr, excess_ptr,
+                                                             thrust::raw_pointer_cast(&new_height[0]),
+                                                             src, sink, limit));
+        height.swap(new_height);
+    }
 }
-} // end namespace detail
 
 template<typename MatrixType, typename ArrayType, typename IndexType>
 typename MatrixType::value_type
-maximum_flow(const MatrixType& G, ArrayType& flow, IndexType src, IndexType sink)
+push_relabel(const MatrixType& G, ArrayType& flow, const IndexType src, const IndexType sink, const bool complete)
 {
-    typedef typename MatrixType::value_type ValueType;
+    typedef typename MatrixType::value_type   ValueType;
     typedef typename MatrixType::memory_space MemorySpace;
-    typedef cusp::csr_matrix_view<
-    typename MatrixType::row_offsets_array_type,
-             typename MatrixType::column_indices_array_type,
-             typename MatrixType::values_array_type> MatrixType_view;
 
-    const size_t N = G.num_rows;
+    const IndexType N = G.num_rows;
 
-    // copy of column indices
-    cusp::array1d<IndexType,MemorySpace> column_indices(G.column_indices);
-    // create view using new column indices
-    MatrixType_view G_view(G.num_rows, G.num_cols, G.num_entries,
-                           G.row_offsets, column_indices, G.values);
+    if (src < 0 || src >= N || sink < 0 || sink >= N || src == sink)
+        throw cusp::invalid_input_exception("source and sink must be distinct vertices of the graph");
 
-    // initialize device memory arrays
-    cusp::array1d<IndexType,MemorySpace> bfs_tree(N);
-    cusp::array1d<IndexType,MemorySpace> positions(N);
+    cusp::graph::detail::flow_network<IndexType,ValueType,MemorySpace> network(G);
 
-    // initialize host memory arrays
-    cusp::array1d<IndexType,cusp::host_memory> bfs_tree_h(N);
-    cusp::array1d<IndexType,cusp::host_memory> positions_h(N);
-    cusp::array1d<IndexType,cusp::host_memory> update_positions(N);
+    cusp::array1d<ValueType,MemorySpace> residual(network.capacity);
+    cusp::array1d<ValueType,MemorySpace> excess(N, ValueType(0));
 
-    // copy of capacities to host
-    cusp::array1d<ValueType,cusp::host_memory> capacities(G.values);
+    const IndexType src_begin = network.row_offsets[src];
+    const IndexType src_end   = network.row_offsets[src + 1];
 
-    ValueType max_flow = 0;
+    if (src_begin < src_end)
+        thrust::for_each(thrust::counting_iterator<IndexType>(src_begin),
+                         thrust::counting_iterator<IndexType>(src_end),
+                         saturate_edge<IndexType,ValueType>(thrust::raw_pointer_cast(&network.column_indices[0]),
+                                                            thrust::raw_pointer_cast(&network.reverse[0]),
+                                                            thrust::raw_pointer_cast(&residual[0]),
+                                                            thrust::raw_pointer_cast(&excess[0])));
 
-    // Edmonds-Karp algorithm
-    while(1)
-    {
-        // Construct BFS tree starting from the source
-        cusp::graph::breadth_first_search<true>(G_view, src, bfs_tree);
-        bfs_tree_h = bfs_tree;
-        // Break when the sink is not reachable from the source
-        if( bfs_tree_h[sink] < 0 ) break;
-
-        // BFS implementation returns the parents but we need to update the actual edges
-        // Use a custom spmv-like kernel to find positions of BFS tree entries
-        detail::bfs_edge_index_locator(G_view, bfs_tree, positions);
-        positions_h = positions;
-
-        int path_length = 0;
-        IndexType curr_node = sink;
-        ValueType min_capacity = std::numeric_limits<ValueType>::max();
-        // Traverse BFS tree starting from sink and ending at source
-        while(curr_node != src)
-        {
-            // track the minimum capacity
-            min_capacity = std::min(capacities[positions_h[curr_node]], min_capacity);
-            curr_node = bfs_tree_h[curr_node];
-            path_length++;
-        }
+    // phase one: heights are distances to the sink
+    discharge(network, residual, excess, src, sink, sink, IndexType(0), N);
 
-        if( min_capacity == 0 )
-        {
-            throw cusp::runtime_exception("Max-flow path from source to sink has zero capacity.");
-        }
-
-        max_flow += min_capacity;
+    // phase two: heights are N plus distances to the source
+    if (complete)
+        discharge(network, residual, excess, src, sink, src, N, IndexType(2 * N));
 
-        int zero_capacity_edges = 0;
-        curr_node = sink;
-        while(curr_node != src)
-        {
-            // update the capacities using the minimum capacity
-            capacities[positions_h[curr_node]] -= min_capacity;
-
-            // track edges with zero capacity for filtering
-            if( capacities[positions_h[curr_node]] == 0 )
-            {
-                update_positions[zero_capacity_edges++] = positions_h[curr_node];
-            }
+    network.flow(residual, flow);
 
-            curr_node = bfs_tree_h[curr_node];
-        }
+    return excess[sink];
+}
 
-        thrust::copy(update_positions.begin(), update_positions.begin() + zero_capacity_edges, positions.begin());
-        // edges with zero capacity are set to invalid vertex id
-        thrust::scatter(thrust::constant_iterator<IndexType>(-1),
-                        thrust::constant_iterator<IndexType>(-1) + zero_capacity_edges,
-                        positions.begin(),
-                        G_view.column_indices.begin());
-    }
+} // end namespace detail
 
-    // copy updated capacities back to device
-    flow = capacities;
-    // flow is equal to the difference in the capacities
-    cusp::blas::axpby(G.values, flow, flow, 1, -1);
+template<typename MatrixType, typename ArrayType, typename IndexType>
+typename MatrixType::value_type
+maximum_flow(const MatrixType& G, ArrayType& flow, IndexType src, IndexType sink)
+{
+    return detail::push_relabel(G, flow, src, sink, true);
+}
 
-    return max_flow;
+template<typename MatrixType, typename ArrayType, typename IndexType>
+typename MatrixType::value_type
+maximum_preflow(const MatrixType& G, ArrayType& flow, IndexType src, IndexType sink)
+{
+    return detail::push_relabel(G, flow, src, sink, false);
 }
 
 } // end namespace device
 } // end namespace detail
 } // end namespace graph
 } // end namespace cusp
-
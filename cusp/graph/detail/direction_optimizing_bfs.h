@@ -0,0 +1,268 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+#pragma once
+
+#include <cusp/array1d.h>
+#include <cusp/array2d.h>
+#include <cusp/exception.h>
+#include <cusp/sparse_vector.h>
+#include <cusp/spmspv.h>
+
+#include <thrust/binary_search.h>
+#include <thrust/copy.h>
+#include <thrust/fill.h>
+#include <thrust/functional.h>
+#include <thrust/scan.h>
+#include <thrust/scatter.h>
+#include <thrust/sort.h>
+#include <thrust/transform.h>
+#include <thrust/unique.h>
+#include <thrust/iterator/constant_iterator.h>
+#include <thrust/iterator/counting_iterator.h>
+
+#include <limits>
+
+// Breadth-first searches built on the sparse matrix-sparse vector products
+// of cusp/spmspv.h.  They run in either memory space with a fixed number of
+// launches per level, independent of the size of the frontier.
+
+namespace cusp
+{
+namespace graph
+{
+namespace detail
+{
+
+// the parent of a discovered vertex is the frontier vertex which reaches it
+struct bfs_parent
+{
+    template <typename T1, typename T2>
+    __host__ __device__
+    T2 operator()(const T1&, const T2& parent) const
+    {
+        return parent;
+    }
+};
+
+template<bool MARK_PREDECESSORS, typename MatrixType, typename ArrayType>
+void direction_optimizing_bfs(const MatrixType& G, const typename MatrixType::index_type src,
+                              ArrayType& labels, cusp::spmspv_direction direction)
+{
+    typedef typename MatrixType::index_type   IndexType;
+    typedef typename MatrixType::value_type   ValueType;
+    typedef typename MatrixType::memory_space MemorySpace;
+
+    const size_t N = G.num_rows;
+
+    if (labels.size() != N)
+        throw cusp::invalid_input_exception("BFS traversal labels do not match the number of vertices");
+
+    // the pulls read the neighbors of a vertex from its row, which are the
+    // vertices reaching it only when G is symmetric
+    cusp::spmspv_matrix<IndexType,ValueType,MemorySpace> A(G, true);
+    A.direction = direction;
+
+    cusp::array1d<unsigned char,MemorySpace> unvisited(N, 1);
+    unvisited[src] = 0;
+
+    thrust::fill(labels.begin(), labels.end(), IndexType(-1));
+    labels[src] = MARK_PREDECESSORS ? IndexType(-1) : IndexType(0);
+
+    // the values of the frontier are the vertices themselves
+    cusp::sparse_vector<IndexType,IndexType,MemorySpace> frontier(N, 1);
+    cusp::sparse_vector<IndexType,IndexType,MemorySpace> discovered;
+    frontier.indices[0] = src;
+    frontier.values[0]  = src;
+
+    for(IndexType depth = 1; frontier.num_entries > 0; depth++)
+    {
+        // unvisited neighbors of the frontier with their smallest parent
+        cusp::generalized_spmspv(A, frontier, unvisited, discovered,
+                                 bfs_parent(), thrust::minimum<IndexType>());
+
+        const size_t num_discovered = discovered.num_entries;
+
+        if (MARK_PREDECESSORS)
+            thrust::scatter(discovered.values.begin(), discovered.values.end(),
+                            discovered.indices.begin(), labels.begin());
+        else
+            thrust::scatter(thrust::constant_iterator<IndexType>(depth),
+                            thrust::constant_iterator<IndexType>(depth) + num_discovered,
+                            discovered.indices.begin(), labels.begin());
+
+        thrust::scatter(thrust::constant_iterator<unsigned char>(0),
+                        thrust::constant_iterator<unsigned char>(0) + num_discovered,
+                        discovered.indices.begin(), unvisited.begin());
+
+        frontier.swap(discovered);
+        thrust::copy(frontier.indices.begin(), frontier.indices.end(), frontier.values.begin());
+    }
+}
+
+// The searches from all sources advance one level together.  The frontier
+// holds the keys s * N + v of the vertices v reached from source s, which
+// are the positions of the column-major level array.
+template <typename IndexType>
+struct bfs_key_degree
+{
+    IndexType N;
+    const IndexType * row_offsets;
+
+    bfs_key_degree(IndexType N, const IndexType * row_offsets)
+      : N(N), row_offsets(row_offsets) {}
+
+    __host__ __device__
+    IndexType operator()(const IndexType& key) const
+    {
+        const IndexType v = key % N;
+        return row_offsets[v + 1] - row_offsets[v];
+    }
+};
+
+template <typename IndexType>
+struct bfs_key_source
+{
+    IndexType N;
+    const IndexType * sources;
+
+    bfs_key_source(IndexType N, const IndexType * sources)
+      : N(N), sources(sources) {}
+
+    __host__ __device__
+    IndexType operator()(const IndexType& s) const
+    {
+        return s * N + sources[s];
+    }
+};
+
+// edge e of the expansion leaves the frontier key number owner - 1,
+// neighbors which were already reached receive the key sentinel
+template <typename IndexType>
+struct bfs_expand_key
+{
+    IndexType N;
+    IndexType sentinel;
+    const IndexType * starts;
+    const IndexType * owners;
+    const IndexType * keys;
+    const IndexType * row_offsets;
+    const IndexType * column_indices;
+    const IndexType * levels;
+
+    bfs_expand_key(IndexType N, IndexType sentinel, const IndexType * starts, const IndexType * owners,
+                   const IndexType * keys, const IndexType * row_offsets,
+                   const IndexType * column_indices, const IndexType * levels)
+      : N(N), sentinel(sentinel), starts(starts), owners(owners), keys(keys),
+        row_offsets(row_offsets), column_indices(column_indices), levels(levels) {}
+
+    __host__ __device__
+    IndexType operator()(const IndexType& e) const
+    {
+        const IndexType n   = owners[e] - 1;
+        const IndexType key = keys[n];
+        const IndexType v   = key % N;
+        const IndexType u   = column_indices[row_offsets[v] + (e - starts[n])];
+
+        const IndexType neighbor = key - v + u;
+
+        return levels[neighbor] == IndexType(-1) ? neighbor : sentinel;
+    }
+};
+
+template<typename MatrixType, typename ArrayType1, typename IndexType, typename MemorySpace>
+void multi_source_bfs(const MatrixType& G, const ArrayType1& sources,
+                      cusp::array2d<IndexType,MemorySpace,cusp::column_major>& levels)
+{
+    const size_t N = G.num_rows;
+    const size_t K = sources.size();
+
+    if (N * K >= size_t(std::numeric_limits<IndexType>::max()))
+        throw cusp::invalid_input_exception("too many sources for the index type of the graph");
+
+    levels.resize(N, K);
+    thrust::fill(levels.values.begin(), levels.values.end(), IndexType(-1));
+
+    if (K == 0)
+        return;
+
+    const IndexType sentinel = N * K;
+
+    cusp::array1d<IndexType,MemorySpace> S(sources);
+    cusp::array1d<IndexType,MemorySpace> keys(K);
+    thrust::transform(thrust::counting_iterator<IndexType>(0), thrust::counting_iterator<IndexType>(K),
+                      keys.begin(), bfs_key_source<IndexType>(N, thrust::raw_pointer_cast(&S[0])));
+
+    thrust::scatter(thrust::constant_iterator<IndexType>(0),
+                    thrust::constant_iterator<IndexType>(0) + keys.size(),
+                    keys.begin(), levels.values.begin());
+
+    cusp::array1d<IndexType,MemorySpace> starts;
+    cusp::array1d<IndexType,MemorySpace> owners;
+
+    for(IndexType depth = 1; keys.size() > 0; depth++)
+    {
+        const size_t num_keys = keys.size();
+
+        starts.resize(num_keys + 1);
+        starts[num_keys] = 0;
+        thrust::transform(keys.begin(), keys.end(), starts.begin(),
+                          bfs_key_degree<IndexType>(N, thrust::raw_pointer_cast(&G.row_offsets[0])));
+        thrust::exclusive_scan(starts.begin(), starts.end(), starts.begin());
+
+        const IndexType num_edges = starts[num_keys];
+
+        if (num_edges == 0)
+            break;
+
+        owners.resize(num_edges);
+        thrust::upper_bound(starts.begin(), starts.end(),
+                            thrust::counting_iterator<IndexType>(0),
+                            thrust::counting_iterator<IndexType>(num_edges),
+                            owners.begin());
+
+        cusp::array1d<IndexType,MemorySpace> next(num_edges);
+        thrust::transform(thrust::counting_iterator<IndexType>(0), thrust::counting_iterator<IndexType>(num_edges),
+                          next.begin(),
+                          bfs_expand_key<IndexType>(N, sentinel,
+                                                    thrust::raw_pointer_cast(&starts[0]),
+                                                    thrust::raw_pointer_cast(&owners[0]),
+                                                    thrust::raw_pointer_cast(&keys[0]),
+                                                    thrust::raw_pointer_cast(&G.row_offsets[0]),
+                                                    thrust::raw_pointer_cast(&G.column_indices[0]),
+                                                    thrust::raw_pointer_cast(&levels.values[0])));
+
+        // the sentinel sorts last
+        thrust::sort(next.begin(), next.end());
+        size_t num_next = thrust::unique(next.begin(), next.end()) - next.begin();
+
+        if (num_next > 0 && next[num_next - 1] == sentinel)
+            num_next--;
+
+        next.resize(num_next);
+
+        thrust::scatter(thrust::constant_iterator<IndexType>(depth),
+                        thrust::constant_iterator<IndexType>(depth) + num_next,
+                        next.begin(), levels.values.begin());
+
+        keys.swap(next);
+    }
+}
+
+} // end namespace detail
+} // end namespace graph
+} // end namespace cusp
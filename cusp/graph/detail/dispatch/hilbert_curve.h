@@ -30,20 +30,20 @@ namespace dispatch
 // Host Paths //
 ////////////////
 template <class Array2d, class Array1d>
-void hilbert_curve(const Array2d& coord, const size_t num_parts, Array1d& parts,
+void hilbert_curve_keys(const Array2d& coord, Array1d& keys,
 	    cusp::host_memory)
 {
-    return cusp::graph::detail::host::hilbert_curve(coord, num_parts, parts);
+    return cusp::graph::detail::host::hilbert_curve_keys(coord, keys);
 }
 
 //////////////////
 // Device Paths //
 //////////////////
 template <class Array2d, class Array1d>
-void hilbert_curve(const Array2d& coord, const size_t num_parts, Array1d& parts,
+void hilbert_curve_keys(const Array2d& coord, Array1d& keys,
 	    cusp::device_memory)
 {
-    return cusp::graph::detail::device::hilbert_curve(coord, num_parts, parts);
+    return cusp::graph::detail::device::hilbert_curve_keys(coord, keys);
 }
 
 } // end namespace dispatch
@@ -36,6 +36,14 @@ maximum_flow(const MatrixType& G, ArrayType& flow, const IndexType src, const In
     return cusp::graph::detail::host::maximum_flow(G, flow, src, sink);
 }
 
+// the host solver discharges every vertex, so its preflow is a flow
+template<typename MatrixType, typename ArrayType, typename IndexType>
+typename MatrixType::value_type 
+maximum_preflow(const MatrixType& G, ArrayType& flow, const IndexType src, const IndexType sink, cusp::host_memory)
+{
+    return cusp::graph::detail::host::maximum_flow(G, flow, src, sink);
+}
+
 //////////////////
 // Device Paths //
 //////////////////
@@ -46,6 +54,13 @@ maximum_flow(const MatrixType& G, ArrayType& flow, const IndexType src, const In
     return cusp::graph::detail::device::maximum_flow(G, flow, src, sink);
 }
 
+template<typename MatrixType, typename ArrayType, typename IndexType>
+typename MatrixType::value_type 
+maximum_preflow(const MatrixType& G, ArrayType& flow, const IndexType src, const IndexType sink, cusp::device_memory)
+{
+    return cusp::graph::detail::device::maximum_preflow(G, flow, src, sink);
+}
+
 } // end namespace dispatch
 } // end namespace detail
 } // end namespace graph
@@ -0,0 +1,208 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include <cusp/array1d.h>
+#include <cusp/csr_matrix.h>
+#include <cusp/detail/format_utils.h>
+#include <cusp/graph/breadth_first_search.h>
+
+#include <thrust/binary_search.h>
+#include <thrust/copy.h>
+#include <thrust/count.h>
+#include <thrust/fill.h>
+#include <thrust/scatter.h>
+#include <thrust/sequence.h>
+#include <thrust/transform.h>
+#include <thrust/unique.h>
+#include <thrust/iterator/permutation_iterator.h>
+#include <thrust/iterator/zip_iterator.h>
+
+namespace cusp
+{
+namespace graph
+{
+namespace detail
+{
+
+template <typename ValueType>
+struct positive_residual
+{
+    __host__ __device__
+    bool operator()(const ValueType r) const
+    {
+        return r > ValueType(0);
+    }
+};
+
+// residual[k] = capacity[k] - flow[k] + flow[reverse[k]]
+template <typename ValueType>
+struct flow_residual
+{
+    template <typename Tuple>
+    __host__ __device__
+    ValueType operator()(const Tuple& t) const
+    {
+        return thrust::get<0>(t) - thrust::get<1>(t) + thrust::get<2>(t);
+    }
+};
+
+// max(capacity - residual, 0), the flow on an edge of G
+template <typename ValueType>
+struct flow_from_residual
+{
+    __host__ __device__
+    ValueType operator()(const ValueType capacity, const ValueType residual) const
+    {
+        return capacity > residual ? capacity - residual : ValueType(0);
+    }
+};
+
+// Residual network of the flow graph G.  Each entry (i,j) of G is paired
+// with a reverse edge (j,i) of zero capacity, merged with the entry (j,i)
+// of G when there is one, so the pattern is symmetric and every edge k has
+// a partner reverse[k].  The edges are sorted by row and then column, and
+// entry e of G is edge position[e] of the network.  G may not contain
+// duplicate entries.
+template <typename IndexType, typename ValueType, typename MemorySpace>
+struct flow_network
+{
+    typedef cusp::csr_matrix<IndexType,IndexType,MemorySpace> GraphType;
+
+    IndexType num_vertices;
+    IndexType num_edges;
+
+    cusp::array1d<IndexType,MemorySpace> row_offsets;
+    cusp::array1d<IndexType,MemorySpace> row_indices;
+    cusp::array1d<IndexType,MemorySpace> column_indices;
+    cusp::array1d<ValueType,MemorySpace> capacity;
+    cusp::array1d<IndexType,MemorySpace> reverse;
+    cusp::array1d<IndexType,MemorySpace> position;
+
+    template <typename MatrixType>
+    flow_network(const MatrixType& G)
+        : num_vertices(G.num_rows), position(G.num_entries)
+    {
+        const size_t E = G.num_entries;
+
+        cusp::array1d<IndexType,MemorySpace> G_row_indices(E);
+        cusp::detail::offsets_to_indices(G.row_offsets, G_row_indices);
+
+        // every entry of G and its reverse
+        cusp::array1d<IndexType,MemorySpace> rows(2 * E);
+        cusp::array1d<IndexType,MemorySpace> cols(2 * E);
+        cusp::array1d<IndexType,MemorySpace> unused(2 * E);
+
+        thrust::copy(G_row_indices.begin(),    G_row_indices.end(),    rows.begin());
+        thrust::copy(G.column_indices.begin(), G.column_indices.end(), rows.begin() + E);
+        thrust::copy(G.column_indices.begin(), G.column_indices.end(), cols.begin());
+        thrust::copy(G_row_indices.begin(),    G_row_indices.end(),    cols.begin() + E);
+
+        cusp::detail::sort_by_row_and_column(rows, cols, unused);
+
+        row_indices.resize(2 * E);
+        column_indices.resize(2 * E);
+
+        num_edges = thrust::unique_copy(thrust::make_zip_iterator(thrust::make_tuple(rows.begin(), cols.begin())),
+                                        thrust::make_zip_iterator(thrust::make_tuple(rows.end(),   cols.end())),
+                                        thrust::make_zip_iterator(thrust::make_tuple(row_indices.begin(), column_indices.begin())))
+                    - thrust::make_zip_iterator(thrust::make_tuple(row_indices.begin(), column_indices.begin()));
+
+        row_indices.resize(num_edges);
+        column_indices.resize(num_edges);
+
+        row_offsets.resize(num_vertices + 1);
+        cusp::detail::indices_to_offsets(row_indices, row_offsets);
+
+        // locate the entries of G among the edges
+        thrust::lower_bound(thrust::make_zip_iterator(thrust::make_tuple(row_indices.begin(), column_indices.begin())),
+                            thrust::make_zip_iterator(thrust::make_tuple(row_indices.end(),   column_indices.end())),
+                            thrust::make_zip_iterator(thrust::make_tuple(G_row_indices.begin(), G.column_indices.begin())),
+                            thrust::make_zip_iterator(thrust::make_tuple(G_row_indices.end(),   G.column_indices.end())),
+                            position.begin());
+
+        capacity.resize(num_edges);
+        thrust::fill(capacity.begin(), capacity.end(), ValueType(0));
+        thrust::scatter(G.values.begin(), G.values.end(), position.begin(), capacity.begin());
+
+        // sorting the edges by column and then row lists (j,i) in the
+        // place of (i,j), since the pattern is symmetric
+        cusp::array1d<IndexType,MemorySpace> transposed_rows(column_indices);
+        cusp::array1d<IndexType,MemorySpace> transposed_cols(row_indices);
+
+        reverse.resize(num_edges);
+        thrust::sequence(reverse.begin(), reverse.end());
+
+        cusp::detail::sort_by_row_and_column(transposed_rows, transposed_cols, reverse);
+    }
+
+    // residual capacity of each edge under a flow on the entries of G
+    template <typename ArrayType1, typename ArrayType2>
+    void residual(const ArrayType1& flow, ArrayType2& residual) const
+    {
+        cusp::array1d<ValueType,MemorySpace> edge_flow(num_edges, ValueType(0));
+        thrust::scatter(flow.begin(), flow.end(), position.begin(), edge_flow.begin());
+
+        residual.resize(num_edges);
+        thrust::transform(thrust::make_zip_iterator(thrust::make_tuple(capacity.begin(), edge_flow.begin(),
+                                                    thrust::make_permutation_iterator(edge_flow.begin(), reverse.begin()))),
+                          thrust::make_zip_iterator(thrust::make_tuple(capacity.end(), edge_flow.end(),
+                                                    thrust::make_permutation_iterator(edge_flow.begin(), reverse.end()))),
+                          residual.begin(), flow_residual<ValueType>());
+    }
+
+    // flow on the entries of G left by the residual capacities
+    template <typename ArrayType1, typename ArrayType2>
+    void flow(const ArrayType1& residual, ArrayType2& flow) const
+    {
+        flow.resize(position.size());
+        thrust::transform(thrust::make_permutation_iterator(capacity.begin(), position.begin()),
+                          thrust::make_permutation_iterator(capacity.begin(), position.end()),
+                          thrust::make_permutation_iterator(residual.begin(), position.begin()),
+                          flow.begin(), flow_from_residual<ValueType>());
+    }
+
+    // BFS levels from the target in the graph of reversed residual edges,
+    // that is the residual distance of each vertex to the target, or -1
+    // for vertices which cannot reach it
+    template <typename ArrayType1, typename ArrayType2>
+    void distance_to(const ArrayType1& residual, const IndexType target, ArrayType2& distance) const
+    {
+        // (i,j) is an edge of the reversed graph when (j,i) has residual capacity
+        const IndexType count = thrust::count_if(thrust::make_permutation_iterator(residual.begin(), reverse.begin()),
+                                                 thrust::make_permutation_iterator(residual.begin(), reverse.end()),
+                                                 positive_residual<ValueType>());
+
+        GraphType R(num_vertices, num_vertices, count);
+        cusp::array1d<IndexType,MemorySpace> R_row_indices(count);
+
+        thrust::copy_if(thrust::make_zip_iterator(thrust::make_tuple(row_indices.begin(), column_indices.begin())),
+                        thrust::make_zip_iterator(thrust::make_tuple(row_indices.end(),   column_indices.end())),
+                        thrust::make_permutation_iterator(residual.begin(), reverse.begin()),
+                        thrust::make_zip_iterator(thrust::make_tuple(R_row_indices.begin(), R.column_indices.begin())),
+                        positive_residual<ValueType>());
+
+        cusp::detail::indices_to_offsets(R_row_indices, R.row_offsets);
+
+        distance.resize(num_vertices);
+        cusp::graph::breadth_first_search<false>(R, target, distance);
+    }
+};
+
+} // end namespace detail
+} // end namespace graph
+} // end namespace cusp
@@ -14,22 +14,231 @@
  *  limitations under the License.
  */
 
+#include <cusp/array1d.h>
+#include <cusp/exception.h>
+#include <cusp/graph/detail/space_filling_curve.h>
 #include <cusp/graph/detail/dispatch/hilbert_curve.h>
 
+#include <thrust/binary_search.h>
+#include <thrust/copy.h>
+#include <thrust/extrema.h>
+#include <thrust/functional.h>
+#include <thrust/scatter.h>
+#include <thrust/sequence.h>
+#include <thrust/sort.h>
+#include <thrust/transform.h>
+#include <thrust/iterator/counting_iterator.h>
+#include <thrust/iterator/permutation_iterator.h>
+#include <thrust/iterator/transform_iterator.h>
+#include <thrust/iterator/zip_iterator.h>
+
 namespace cusp
 {
 namespace graph
 {
+namespace detail
+{
+
+template <class Array2d>
+void check_curve_coordinates(const Array2d& coord)
+{
+    typedef typename Array2d::const_column_view::iterator Iterator;
+    typedef typename Array2d::value_type ValueType;
+
+    const size_t dims = coord.num_cols;
+
+    if( (dims != 2) && (dims != 3) )
+        throw cusp::invalid_input_exception("Hilbert curve partitioning only implemented for 2D or 3D data.");
+
+    if( coord.num_rows == 0 )
+        return;
+
+    for( size_t d = 0; d < dims; d++ )
+    {
+        thrust::pair<Iterator,Iterator> iter = thrust::minmax_element(coord.column(d).begin(), coord.column(d).end());
+
+        if( *iter.first < ValueType(0) || *iter.second > ValueType(1) )
+            throw cusp::invalid_input_exception("Hilbert coordinates should be in the range [0,1]");
+    }
+}
+
+// sorts keys along the curve, with ties in the order of the points, and
+// sets permutation[i] to the point at position i
+template <class KeyArray, class Array1d>
+void sort_curve_keys(KeyArray& keys, Array1d& permutation)
+{
+    permutation.resize(keys.size());
+    thrust::sequence(permutation.begin(), permutation.end());
+    thrust::stable_sort_by_key(keys.begin(), keys.end(), permutation.begin());
+}
+
+// the point at position i along the curve goes to part i * num_parts / num_points
+template <class Array1d1, class Array1d2>
+void scatter_curve_parts(const Array1d1& permutation, const size_t num_parts, Array1d2& parts)
+{
+    typedef typename Array1d2::value_type PartType;
+
+    const size_t num_points = permutation.size();
+
+    thrust::scatter(thrust::make_transform_iterator(thrust::counting_iterator<PartType>(0),
+                                                    curve_part<PartType>(num_points, num_parts)),
+                    thrust::make_transform_iterator(thrust::counting_iterator<PartType>(num_points),
+                                                    curve_part<PartType>(num_points, num_parts)),
+                    permutation.begin(), parts.begin());
+}
+
+} // end namespace detail
+
+template <class Array2d, class Array1d>
+void space_filling_curve_keys(const Array2d& coord, Array1d& keys, const space_filling_curve curve)
+{
+    CUSP_PROFILE_SCOPED();
+
+    cusp::graph::detail::check_curve_coordinates(coord);
+
+    keys.resize(coord.num_rows);
+
+    if( coord.num_rows == 0 )
+        return;
+
+    if( curve == HILBERT_CURVE )
+    {
+        cusp::graph::detail::dispatch::hilbert_curve_keys(coord, keys,
+                                        typename Array2d::memory_space());
+    }
+    else if( coord.num_cols == 2 )
+    {
+        thrust::transform(thrust::make_zip_iterator(thrust::make_tuple(coord.column(0).begin(), coord.column(1).begin())),
+                          thrust::make_zip_iterator(thrust::make_tuple(coord.column(0).end(), coord.column(1).end())),
+                          keys.begin(), cusp::graph::detail::morton_transform_2d());
+    }
+    else
+    {
+        thrust::transform(thrust::make_zip_iterator(thrust::make_tuple(coord.column(0).begin(), coord.column(1).begin(), coord.column(2).begin())),
+                          thrust::make_zip_iterator(thrust::make_tuple(coord.column(0).end(), coord.column(1).end(), coord.column(2).end())),
+                          keys.begin(), cusp::graph::detail::morton_transform_3d());
+    }
+}
+
+template <class KeyArray, class Array1d>
+void space_filling_curve_ordering(const KeyArray& keys, Array1d& permutation)
+{
+    CUSP_PROFILE_SCOPED();
+
+    typedef typename KeyArray::value_type   KeyType;
+    typedef typename KeyArray::memory_space MemorySpace;
+
+    cusp::array1d<KeyType,MemorySpace> sorted_keys(keys);
+    cusp::graph::detail::sort_curve_keys(sorted_keys, permutation);
+}
+
+template <class KeyArray, class Array1d>
+void space_filling_curve_partition(const KeyArray& keys, const size_t num_parts, Array1d& parts)
+{
+    CUSP_PROFILE_SCOPED();
+
+    typedef typename Array1d::value_type    PartType;
+    typedef typename KeyArray::value_type   KeyType;
+    typedef typename KeyArray::memory_space MemorySpace;
+
+    const size_t num_points = keys.size();
+
+    if( num_parts == 0 )
+        throw cusp::invalid_input_exception("number of parts should be positive");
+
+    parts.resize(num_points);
+
+    if( num_points == 0 )
+        return;
+
+    cusp::array1d<KeyType,MemorySpace> sorted_keys(keys);
+    cusp::array1d<PartType,MemorySpace> perm;
+    cusp::graph::detail::sort_curve_keys(sorted_keys, perm);
+
+    cusp::graph::detail::scatter_curve_parts(perm, num_parts, parts);
+}
+
+template <class KeyArray, class Array1d1, class Array1d2>
+void space_filling_curve_distribution(const KeyArray& keys,
+                                      const cusp::distributed_layout& layout,
+                                      Array1d1& parts,
+                                      Array1d2& local_indices)
+{
+    CUSP_PROFILE_SCOPED();
+
+    typedef typename Array1d1::value_type   PartType;
+    typedef typename Array1d2::value_type   IndexType;
+    typedef typename KeyArray::memory_space MemorySpace;
+
+    const size_t num_points = keys.size();
+
+    if( layout.size() != num_points )
+        throw cusp::invalid_input_exception("layout size should equal the number of points");
+
+    parts.resize(num_points);
+    local_indices.resize(num_points);
+
+    if( num_points == 0 )
+        return;
+
+    // position of every point along the curve
+    {
+        cusp::array1d<IndexType,MemorySpace> perm;
+        space_filling_curve_ordering(keys, perm);
+
+        thrust::scatter(thrust::counting_iterator<IndexType>(0), thrust::counting_iterator<IndexType>(num_points),
+                        perm.begin(), local_indices.begin());
+    }
+
+    // the part holding each position, and the position within the part
+    cusp::array1d<IndexType,cusp::host_memory> h_offsets(layout.offsets.begin(), layout.offsets.end());
+    cusp::array1d<IndexType,MemorySpace> offsets(h_offsets);
+
+    thrust::upper_bound(offsets.begin(), offsets.end(), local_indices.begin(), local_indices.end(), parts.begin());
+    thrust::transform(parts.begin(), parts.end(), parts.begin(), thrust::placeholders::_1 - PartType(1));
+
+    thrust::transform(local_indices.begin(), local_indices.end(),
+                      thrust::make_permutation_iterator(offsets.begin(), parts.begin()),
+                      local_indices.begin(), thrust::minus<IndexType>());
+}
 
 template <class Array2d, class Array1d>
 void hilbert_curve(const Array2d& coord, const size_t num_parts, Array1d& parts)
 {
     CUSP_PROFILE_SCOPED();
 
-    return cusp::graph::detail::dispatch::hilbert_curve(coord, num_parts, parts,
-					 typename Array2d::memory_space());
+    typedef typename Array1d::value_type   PartType;
+    typedef typename Array2d::memory_space MemorySpace;
+
+    const size_t num_points = coord.num_rows;
+
+    if( num_parts == 0 )
+        throw cusp::invalid_input_exception("number of parts should be positive");
+
+    cusp::array1d<unsigned long long,MemorySpace> keys;
+    space_filling_curve_keys(coord, keys, HILBERT_CURVE);
+
+    if( num_points == 0 )
+        return;
+
+    cusp::array1d<PartType,MemorySpace> perm;
+    cusp::graph::detail::sort_curve_keys(keys, perm);
+
+    cusp::graph::detail::scatter_curve_parts(perm, num_parts, parts);
+}
+
+template <class Array2d, class Array1d>
+void hilbert_curve_ordering(const Array2d& coord, Array1d& permutation)
+{
+    CUSP_PROFILE_SCOPED();
+
+    typedef typename Array2d::memory_space MemorySpace;
+
+    cusp::array1d<unsigned long long,MemorySpace> keys;
+    space_filling_curve_keys(coord, keys, HILBERT_CURVE);
+
+    cusp::graph::detail::sort_curve_keys(keys, permutation);
 }
 
 } // end namespace graph
 } // end namespace cusp
-
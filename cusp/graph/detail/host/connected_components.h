@@ -14,11 +14,12 @@
  *  limitations under the License.
  */
 
-#include <stack>
 
-#include <cusp/exception.h>
+#include <vector>
+#include <utility>
 
-#include <thrust/fill.h>
+#include <cusp/array1d.h>
+#include <cusp/detail/host/parallel.h>
 
 namespace cusp
 {
@@ -29,43 +30,93 @@ namespace detail
 namespace host
 {
 
+// root of the tree of i, halving the path on the way
+template <typename ArrayType, typename VertexId>
+VertexId union_find_root(ArrayType& parent, VertexId i)
+{
+    while (parent[i] != i)
+    {
+        parent[i] = parent[parent[i]];
+        i = parent[i];
+    }
+
+    return i;
+}
+
+// merge the trees of i and j under the smaller root
+template <typename ArrayType, typename VertexId>
+void union_find_unite(ArrayType& parent, VertexId i, VertexId j)
+{
+    i = union_find_root(parent, i);
+    j = union_find_root(parent, j);
+
+    if (i < j)
+        parent[j] = i;
+    else if (j < i)
+        parent[i] = j;
+}
+
+// Union-find over the edges.  Each thread unites the edges inside its
+// block of rows, whose trees never leave the block, and keeps the edges
+// to other blocks, which are united afterwards by the calling thread.
+// The root of every tree is its smallest vertex, so the components are
+// numbered in the order of their smallest vertex.
 template<typename MatrixType, typename ArrayType>
 size_t connected_components(const MatrixType& G, ArrayType& components)
 {
     typedef typename MatrixType::index_type VertexId;
+    typedef std::vector< std::pair<VertexId,VertexId> > EdgeList;
+
+    using cusp::detail::host::balanced_split;
+
+    const VertexId num_rows = G.num_rows;
 
-    VertexId num_nodes = G.num_rows;
+    cusp::array1d<VertexId,cusp::host_memory> parent(num_rows);
 
-    thrust::fill(components.begin(), components.begin() + num_nodes, -1);
-    std::stack<VertexId> DFS;
-    VertexId component = 0;
+    const int P = cusp::detail::host::num_parts(G.num_rows + G.num_entries);
 
-    for(VertexId i = 0; i < num_nodes; i++)
+    std::vector<EdgeList> cut_edges(P);
+
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(static) num_threads(P)
+#endif
+    for(int part = 0; part < P; part++)
     {
-        if(components[i] == -1)
-        {
-            DFS.push(i);
-            components[i] = component;
+        const VertexId i_begin = balanced_split(G.row_offsets, G.num_rows, part, P);
+        const VertexId i_end   = balanced_split(G.row_offsets, G.num_rows, part + 1, P);
+
+        for(VertexId i = i_begin; i < i_end; i++)
+            parent[i] = i;
 
-            while (!DFS.empty())
+        for(VertexId i = i_begin; i < i_end; i++)
+        {
+            for(VertexId jj = G.row_offsets[i]; jj < G.row_offsets[i + 1]; jj++)
             {
-                VertexId top = DFS.top();
-                DFS.pop();
-   
-                for(VertexId jj = G.row_offsets[top]; jj < G.row_offsets[top + 1]; jj++){
-                    const VertexId j = G.column_indices[jj];
-                    if(components[j] == -1){
-                        DFS.push(j);
-                        components[j] = component;
-                    }
-                }
-            }
+                const VertexId j = G.column_indices[jj];
 
-            component++;
+                if (j >= i_begin && j < i_end)
+                    union_find_unite(parent, i, j);
+                else
+                    cut_edges[part].push_back(std::make_pair(i, j));
+            }
         }
     }
 
-    return component;
+    for(int part = 0; part < P; part++)
+        for(size_t n = 0; n < cut_edges[part].size(); n++)
+            union_find_unite(parent, cut_edges[part][n].first, cut_edges[part][n].second);
+
+    VertexId num_components = 0;
+
+    for(VertexId i = 0; i < num_rows; i++)
+    {
+        if (parent[i] == i)
+            components[i] = num_components++;
+        else
+            components[i] = components[union_find_root(parent, i)];
+    }
+
+    return num_components;
 }
 
 } // end namespace host
@@ -15,11 +15,10 @@
  */
 
 
-#include <cusp/exception.h>
+#include <cusp/graph/detail/space_filling_curve.h>
 
-#include <thrust/gather.h>
-#include <thrust/sort.h>
 #include <thrust/transform.h>
+#include <thrust/iterator/zip_iterator.h>
 
 namespace cusp
 {
@@ -31,9 +30,8 @@ namespace host
 {
 
 // Tables and Hilbert transform codes adapted from HSFC implementation in Zoltan v3.601
-static unsigned const int IMAX = ~(0U);
-static const int MAXLEVEL_2d = 28; // 56 bits of significance, 28 per dimension
-static const int MAXLEVEL_3d = 19; // 56 bits of significance, 18+ per dimension
+static const int MAXLEVEL_2d = 32; // 64 bits of significance, 32 per dimension
+static const int MAXLEVEL_3d = 21; // 63 bits of significance, 21 per dimension
 
 static unsigned const int idata2d[] =  // 2 dimension to nkey conversion
 {   0, 3, 1, 2,
@@ -124,133 +122,78 @@ static const unsigned int *s3d[] =
     istate3d +160, istate3d +168, istate3d +176, istate3d +184
 };
 
-struct hilbert_transform_2d : public thrust::unary_function<double,double>
+struct hilbert_transform_2d : public thrust::unary_function<double,unsigned long long>
 {
     template<typename Tuple>
     __host__
-    double operator()(const Tuple& t) const
+    unsigned long long operator()(const Tuple& t) const
     {
-        const double x = thrust::get<0>(t);
-        const double y = thrust::get<1>(t);
-
-        int level;
-        unsigned int key[2], c[2], temp, state;
-
-        // convert x,y coordinates to integers in range [0, IMAX]
-        c[0] = (unsigned int) (x * (double) IMAX);               // x
-        c[1] = (unsigned int) (y * (double) IMAX);               // y
+        // convert x,y coordinates to integers in range [0, 2^32)
+        const unsigned int c0 = cusp::graph::detail::curve_coordinate(thrust::get<0>(t));
+        const unsigned int c1 = cusp::graph::detail::curve_coordinate(thrust::get<1>(t));
 
         // use state tables to convert nested quadrant's coordinates level by level
-        key[0] = key[1] = 0;
-        state = 0;
-        for (level = 0; level < MAXLEVEL_2d; level++) {
-            temp = ((c[0] >> (30-level)) & 2)    // extract 2 bits at current level
-                   | ((c[1] >> (31-level)) & 1);
+        unsigned long long key = 0;
+        unsigned int state = 0;
 
-            // treat key[] as long shift register, shift in converted coordinate
-            key[0] = (key[0] << 2) | (key[1] >> 30);
-            key[1] = (key[1] << 2) | *(d2d[state] + temp);
+        for (int level = 0; level < MAXLEVEL_2d; level++) {
+            const int bit = 31 - level;
+            const unsigned int temp = (((c0 >> bit) & 1) << 1)    // extract 2 bits at current level
+                                    |  ((c1 >> bit) & 1);
+
+            // shift in converted coordinate
+            key = (key << 2) | *(d2d[state] + temp);
 
             state = *(s2d[state] + temp);
         }
 
-        // convert 2 part Hilbert key to double and return
-        return ldexp ((double) key[0], -24)  +  ldexp ((double) key[1], -56);
+        return key;
     }
 };
 
-struct hilbert_transform_3d : public thrust::unary_function<double,double>
+struct hilbert_transform_3d : public thrust::unary_function<double,unsigned long long>
 {
     template<typename Tuple>
     __host__
-    double operator()(const Tuple& t) const
+    unsigned long long operator()(const Tuple& t) const
     {
-        const double x = thrust::get<0>(t);
-        const double y = thrust::get<1>(t);
-        const double z = thrust::get<2>(t);
-
-        int level;
-        unsigned int key[2], c[3], temp, state;
+        // convert x,y,z coordinates to integers in range [0, 2^32)
+        const unsigned int c0 = cusp::graph::detail::curve_coordinate(thrust::get<0>(t));
+        const unsigned int c1 = cusp::graph::detail::curve_coordinate(thrust::get<1>(t));
+        const unsigned int c2 = cusp::graph::detail::curve_coordinate(thrust::get<2>(t));
 
-        // convert x,y,z coordinates to integers in range [0, IMAX]
-        c[0] = (unsigned int) (x * (double) IMAX);               // x
-        c[1] = (unsigned int) (y * (double) IMAX);               // y
-        c[2] = (unsigned int) (z * (double) IMAX);     		 // z
+        // use state tables to convert nested octant's coordinates level by level
+        unsigned long long key = 0;
+        unsigned int state = 0;
 
-        // use state tables to convert nested quadrant's coordinates level by level
-        key[0] = key[1] = 0;
-        state = 0;
-        for (level = 0; level < MAXLEVEL_3d; level++) {
-            temp = ((c[0] >> (29-level)) & 4)  // extract 3 bits at current level
-                   | ((c[1] >> (30-level)) & 2)
-                   | ((c[2] >> (31-level)) & 1);
+        for (int level = 0; level < MAXLEVEL_3d; level++) {
+            const int bit = 31 - level;
+            const unsigned int temp = (((c0 >> bit) & 1) << 2)    // extract 3 bits at current level
+                                    | (((c1 >> bit) & 1) << 1)
+                                    |  ((c2 >> bit) & 1);
 
-            // treat key[] as long shift register, shift in converted coordinate
-            key[0] = (key[0] << 3) |  (key[1] >> 29);
-            key[1] = (key[1] << 3) | *(d3d[state] + temp);
+            // shift in converted coordinate
+            key = (key << 3) | *(d3d[state] + temp);
 
             state = *(s3d[state] + temp);
         }
 
-        // convert 2 part Hilbert key to double and return
-        return ldexp ((double) key[0], -25)  +  ldexp ((double) key[1], -57);
+        return key;
     }
 };
 
 template <class Array2d, class Array1d>
-void hilbert_curve(const Array2d& coord,
-            size_t num_parts,
-            Array1d& parts)
+void hilbert_curve_keys(const Array2d& coord, Array1d& keys)
 {
-    typedef typename Array1d::value_type PartType;
-    typedef typename Array2d::const_column_view::iterator Iterator;
-    typedef typename Array2d::value_type ValueType;
-    typedef typename Array2d::memory_space MemorySpace;
-
-    size_t num_points = coord.num_rows;
-    size_t dims = coord.num_cols;
-
-    if( (dims != 2) && (dims != 3) )
-        throw cusp::invalid_input_exception("Hilbert curve partitioning only implemented for 2D or 3D data.");
-
-    thrust::pair<Iterator,Iterator> x_iter = thrust::minmax_element(coord.column(0).begin(), coord.column(0).end());
-    thrust::pair<Iterator,Iterator> y_iter = thrust::minmax_element(coord.column(1).begin(), coord.column(1).end());
-
-    ValueType xmin = *x_iter.first;
-    ValueType xmax = *x_iter.second;
-    ValueType ymin = *y_iter.first;
-    ValueType ymax = *y_iter.second;
-
-    if( xmin < ValueType(0) || xmax > ValueType(1) || ymin < ValueType(0) || ymax > ValueType(1) )
-        throw cusp::invalid_input_exception("Hilbert coordinates should be in the range [0,1]");
-
-    cusp::array1d<double, MemorySpace> hilbert_keys(coord.num_rows);
-
-    if( dims == 2 ) {
+    if( coord.num_cols == 2 ) {
         thrust::transform(thrust::make_zip_iterator(thrust::make_tuple(coord.column(0).begin(), coord.column(1).begin())),
                           thrust::make_zip_iterator(thrust::make_tuple(coord.column(0).end(), coord.column(1).end())),
-                          hilbert_keys.begin(), hilbert_transform_2d());
+                          keys.begin(), hilbert_transform_2d());
     } else {
-        thrust::pair<Iterator,Iterator> z_iter = thrust::minmax_element(coord.column(2).begin(), coord.column(2).end());
-        ValueType zmin = *z_iter.first;
-        ValueType zmax = *z_iter.second;
-
-        if( zmin < ValueType(0) || zmax > ValueType(1) )
-            throw cusp::invalid_input_exception("Hilbert coordinates should be in the range [0,1]");
-
         thrust::transform(thrust::make_zip_iterator(thrust::make_tuple(coord.column(0).begin(), coord.column(1).begin(), coord.column(2).begin())),
                           thrust::make_zip_iterator(thrust::make_tuple(coord.column(0).end(), coord.column(1).end(), coord.column(2).end())),
-                          hilbert_keys.begin(), hilbert_transform_3d());
+                          keys.begin(), hilbert_transform_3d());
     }
-
-    cusp::array1d<PartType, MemorySpace> perm(num_points);
-    thrust::sequence(perm.begin(), perm.end());
-    thrust::sort_by_key(hilbert_keys.begin(), hilbert_keys.end(), perm.begin());
-
-    cusp::array1d<PartType, MemorySpace> uniform_parts(num_points);
-    thrust::transform(thrust::counting_iterator<PartType>(0), thrust::counting_iterator<PartType>(num_points),
-                      thrust::constant_iterator<PartType>(num_points/num_parts), uniform_parts.begin(), thrust::divides<PartType>());
-    thrust::gather(perm.begin(), perm.end(), uniform_parts.begin(), parts.begin());
 }
 
 } // end namespace host
@@ -17,6 +17,7 @@
 #include <cusp/exception.h>
 #include <cusp/csr_matrix.h>
 
+#include <cusp/graph/detail/flow_network.h>
 #include <cusp/graph/detail/dispatch/maximum_flow.h>
 
 namespace cusp
@@ -26,6 +27,24 @@ namespace graph
 namespace detail
 {
 
+// edges of positive capacity from a vertex which cannot reach the sink
+// to one which can
+template <typename IndexType, typename ValueType>
+struct sink_side_cut_edge
+{
+    const IndexType * distance;
+
+    sink_side_cut_edge(const IndexType * distance) : distance(distance) {}
+
+    template <typename Tuple>
+    __host__ __device__
+    IndexType operator()(const Tuple& t) const
+    {
+        return thrust::get<2>(t) > ValueType(0) &&
+               distance[thrust::get<0>(t)] < 0 && distance[thrust::get<1>(t)] >= 0;
+    }
+};
+
 template<typename MatrixType, typename ArrayType, typename IndexType>
 typename MatrixType::value_type 
 maximum_flow(const MatrixType& G, ArrayType& flow, const IndexType src, const IndexType sink, cusp::csr_format)
@@ -34,6 +53,45 @@ maximum_flow(const MatrixType& G, ArrayType& flow, const IndexType src, const In
             typename MatrixType::memory_space());
 }
 
+template<typename MatrixType, typename ArrayType, typename IndexType>
+typename MatrixType::value_type 
+maximum_preflow(const MatrixType& G, ArrayType& flow, const IndexType src, const IndexType sink, cusp::csr_format)
+{
+    return cusp::graph::detail::dispatch::maximum_preflow(G, flow, src, sink,
+            typename MatrixType::memory_space());
+}
+
+template<typename MatrixType, typename ArrayType1, typename ArrayType2, typename IndexType>
+size_t max_flow_to_min_cut(const MatrixType& G, const ArrayType1& flow, const IndexType src, const IndexType sink,
+                           ArrayType2& min_cut_edges, cusp::csr_format)
+{
+    typedef typename MatrixType::value_type ValueType;
+    typedef typename MatrixType::memory_space MemorySpace;
+
+    cusp::graph::detail::flow_network<IndexType,ValueType,MemorySpace> network(G);
+
+    cusp::array1d<ValueType,MemorySpace> residual;
+    cusp::array1d<IndexType,MemorySpace> distance(G.num_rows);
+
+    // a preflow leaves excess on vertices of the source side, so the
+    // sink side, the vertices which still reach the sink, is the one that
+    // is known exactly
+    network.residual(flow, residual);
+    network.distance_to(residual, IndexType(sink), distance);
+
+    cusp::array1d<IndexType,MemorySpace> row_indices(G.num_entries);
+    cusp::detail::offsets_to_indices(G.row_offsets, row_indices);
+
+    min_cut_edges.resize(G.num_entries);
+
+    thrust::transform(thrust::make_zip_iterator(thrust::make_tuple(row_indices.begin(), G.column_indices.begin(), G.values.begin())),
+                      thrust::make_zip_iterator(thrust::make_tuple(row_indices.end(),   G.column_indices.end(),   G.values.end())),
+                      min_cut_edges.begin(),
+                      sink_side_cut_edge<IndexType,ValueType>(thrust::raw_pointer_cast(&distance[0])));
+
+    return thrust::reduce(min_cut_edges.begin(), min_cut_edges.end(), size_t(0));
+}
+
 template<typename MatrixType, typename ArrayType1, typename ArrayType2, typename IndexType>
 size_t max_flow_to_min_cut(const MatrixType& G, const ArrayType1& flow, const IndexType src, ArrayType2& min_cut_edges, cusp::csr_format)
 {
@@ -86,7 +144,7 @@ size_t max_flow_to_min_cut(const MatrixType& G, const ArrayType1& flow, const In
 
 template<typename MatrixType, typename ArrayType, typename IndexType, typename Format>
 typename MatrixType::value_type 
-size_tmaximum_flow(const MatrixType& G, ArrayType& flow, const IndexType src, const IndexType sink, Format)
+maximum_flow(const MatrixType& G, ArrayType& flow, const IndexType src, const IndexType sink, Format)
 {
   typedef typename MatrixType::value_type   ValueType;
   typedef typename MatrixType::memory_space MemorySpace;
@@ -97,6 +155,30 @@ size_tmaximum_flow(const MatrixType& G, ArrayType& flow, const IndexType src, co
   return cusp::graph::maximum_flow(G_csr, flow, src, sink);
 }
 
+template<typename MatrixType, typename ArrayType, typename IndexType, typename Format>
+typename MatrixType::value_type 
+maximum_preflow(const MatrixType& G, ArrayType& flow, const IndexType src, const IndexType sink, Format)
+{
+  typedef typename MatrixType::value_type   ValueType;
+  typedef typename MatrixType::memory_space MemorySpace;
+
+  cusp::csr_matrix<IndexType,ValueType,MemorySpace> G_csr(G);
+
+  return cusp::graph::maximum_preflow(G_csr, flow, src, sink);
+}
+
+template<typename MatrixType, typename ArrayType1, typename ArrayType2, typename IndexType, typename Format>
+size_t max_flow_to_min_cut(const MatrixType& G, const ArrayType1& flow, const IndexType src, const IndexType sink,
+                           ArrayType2& min_cut_edges, Format)
+{
+  typedef typename MatrixType::value_type   ValueType;
+  typedef typename MatrixType::memory_space MemorySpace;
+
+  cusp::csr_matrix<IndexType,ValueType,MemorySpace> G_csr(G);
+
+  return cusp::graph::max_flow_to_min_cut(G_csr, flow, src, sink, min_cut_edges);
+}
+
 template<typename MatrixType, typename ArrayType1, typename ArrayType2, typename IndexType, typename Format>
 size_t max_flow_to_min_cut(const MatrixType& G, const ArrayType1& flow, const IndexType src, ArrayType2& min_cut_edges, Format)
 {
@@ -142,6 +224,35 @@ maximum_flow(const MatrixType& G, const IndexType src, const IndexType sink)
             typename MatrixType::format());
 }
 
+template<typename MatrixType, typename ArrayType, typename IndexType>
+typename MatrixType::value_type
+maximum_preflow(const MatrixType& G, ArrayType& flow, const IndexType src, const IndexType sink)
+{
+    CUSP_PROFILE_SCOPED();
+
+    if(G.num_rows != G.num_cols)
+        throw cusp::invalid_input_exception("matrix must be square");
+
+    return cusp::graph::detail::maximum_preflow(G, flow, src, sink,
+            typename MatrixType::format());
+}
+
+template<typename MatrixType, typename ArrayType1, typename ArrayType2, typename IndexType>
+size_t max_flow_to_min_cut(const MatrixType& G, const ArrayType1& flow, const IndexType src, const IndexType sink,
+                           ArrayType2& min_cut_edges)
+{
+    CUSP_PROFILE_SCOPED();
+
+    if(G.num_rows != G.num_cols)
+        throw cusp::invalid_input_exception("matrix must be square");
+
+    if(flow.size() != G.num_entries)
+        throw cusp::invalid_input_exception("flow must have one value per edge");
+
+    return cusp::graph::detail::max_flow_to_min_cut(G, flow, src, sink, min_cut_edges,
+            typename MatrixType::format());
+}
+
 template<typename MatrixType, typename ArrayType1, typename ArrayType2, typename IndexType>
 size_t max_flow_to_min_cut(const MatrixType& G, const ArrayType1& flow, const IndexType src, ArrayType2& min_cut_edges)
 {
@@ -0,0 +1,334 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+
+#include <cusp/array1d.h>
+#include <cusp/array2d.h>
+#include <cusp/blas.h>
+#include <cusp/copy.h>
+#include <cusp/csr_matrix.h>
+#include <cusp/exception.h>
+#include <cusp/format.h>
+#include <cusp/transpose.h>
+
+#include <thrust/copy.h>
+#include <thrust/count.h>
+#include <thrust/functional.h>
+#include <thrust/reduce.h>
+#include <thrust/transform.h>
+#include <thrust/transform_reduce.h>
+#include <thrust/iterator/counting_iterator.h>
+#include <thrust/iterator/permutation_iterator.h>
+
+namespace cusp
+{
+namespace graph
+{
+namespace detail
+{
+
+// 1 / out-degree of a vertex, or 0 for a dangling vertex
+template <typename IndexType, typename ValueType>
+struct pagerank_inverse_degree
+{
+    const IndexType * Ap;
+
+    pagerank_inverse_degree(const IndexType * Ap) : Ap(Ap) {}
+
+    __host__ __device__
+    ValueType operator()(const IndexType i) const
+    {
+        const IndexType degree = Ap[i + 1] - Ap[i];
+
+        return degree == 0 ? ValueType(0) : ValueType(1) / ValueType(degree);
+    }
+};
+
+template <typename IndexType>
+struct pagerank_is_dangling
+{
+    const IndexType * Ap;
+
+    pagerank_is_dangling(const IndexType * Ap) : Ap(Ap) {}
+
+    __host__ __device__
+    bool operator()(const IndexType i) const
+    {
+        return Ap[i] == Ap[i + 1];
+    }
+};
+
+template <typename ValueType>
+struct pagerank_is_negative
+{
+    __host__ __device__
+    bool operator()(const ValueType v) const
+    {
+        return v < ValueType(0);
+    }
+};
+
+// Y(i,k) <- damping * sum of X(j,k) / degree(j) over the edges (j,i)
+//           + jump[k] * V(i,k)
+// for the columns of the ranks X, returning the L1 change of row i
+template <typename IndexType, typename ValueType>
+struct pagerank_row
+{
+    const IndexType * Tp;
+    const IndexType * Tj;
+    const ValueType * inverse_degree;
+    const ValueType * jump;
+    const ValueType * V;
+    const ValueType * X;
+    ValueType * Y;
+    ValueType damping;
+    IndexType num_rows, num_cols;
+
+    pagerank_row(const IndexType * Tp, const IndexType * Tj, const ValueType * inverse_degree,
+                 const ValueType * jump, const ValueType * V, const ValueType * X, ValueType * Y,
+                 const ValueType damping, const IndexType num_rows, const IndexType num_cols)
+        : Tp(Tp), Tj(Tj), inverse_degree(inverse_degree), jump(jump), V(V), X(X), Y(Y),
+          damping(damping), num_rows(num_rows), num_cols(num_cols) {}
+
+    __host__ __device__
+    ValueType operator()(const IndexType i) const
+    {
+        const IndexType row_start = Tp[i];
+        const IndexType row_end   = Tp[i + 1];
+
+        ValueType change = ValueType(0);
+
+        for (IndexType k = 0; k < num_cols; k++)
+        {
+            const ValueType * x = X + k * num_rows;
+
+            ValueType sum = ValueType(0);
+
+            for (IndexType jj = row_start; jj < row_end; jj++)
+            {
+                const IndexType j = Tj[jj];
+                sum += x[j] * inverse_degree[j];
+            }
+
+            const ValueType y = damping * sum + jump[k] * V[k * num_rows + i];
+
+            Y[k * num_rows + i] = y;
+            change += y < x[i] ? x[i] - y : y - x[i];
+        }
+
+        return change;
+    }
+};
+
+// Power iteration from X = V for the jump vectors in the columns of V,
+// which sum to one
+template <typename MatrixType, typename ValueType, typename MemorySpace>
+size_t pagerank(const MatrixType& G,
+                const cusp::array2d<ValueType,MemorySpace,cusp::column_major>& V,
+                      cusp::array2d<ValueType,MemorySpace,cusp::column_major>& X,
+                const ValueType damping, const ValueType tolerance, const size_t max_iterations)
+{
+    typedef typename MatrixType::index_type IndexType;
+    typedef thrust::counting_iterator<IndexType,MemorySpace> CountingIterator;
+
+    const IndexType N = V.num_rows;
+    const IndexType K = V.num_cols;
+
+    X = V;
+
+    if (N == 0)
+        return 0;
+
+    // the ranks are gathered along the edges into each vertex
+    cusp::csr_matrix<IndexType,ValueType,MemorySpace> G_csr(G);
+    cusp::csr_matrix<IndexType,ValueType,MemorySpace> G_t;
+    cusp::transpose(G_csr, G_t);
+
+    cusp::array1d<ValueType,MemorySpace> inverse_degree(N);
+    thrust::transform(CountingIterator(0), CountingIterator(N), inverse_degree.begin(),
+                      pagerank_inverse_degree<IndexType,ValueType>(thrust::raw_pointer_cast(G_csr.row_offsets.data())));
+
+    cusp::array1d<IndexType,MemorySpace> dangling(N);
+    dangling.erase(thrust::copy_if(CountingIterator(0), CountingIterator(N), dangling.begin(),
+                                   pagerank_is_dangling<IndexType>(thrust::raw_pointer_cast(G_csr.row_offsets.data()))),
+                   dangling.end());
+
+    cusp::array2d<ValueType,MemorySpace,cusp::column_major> Y(N, K);
+    cusp::array1d<ValueType,cusp::host_memory> jump(K);
+    cusp::array1d<ValueType,MemorySpace> jump_d(K);
+
+    size_t iteration = 0;
+
+    while (iteration < max_iterations)
+    {
+        // probability of a jump, by chance or from a dangling vertex
+        for (IndexType k = 0; k < K; k++)
+        {
+            ValueType dangling_rank = ValueType(0);
+
+            if (!dangling.empty())
+                dangling_rank = thrust::reduce(thrust::make_permutation_iterator(X.values.begin() + k * N, dangling.begin()),
+                                               thrust::make_permutation_iterator(X.values.begin() + k * N, dangling.end()),
+                                               ValueType(0));
+
+            jump[k] = ValueType(1) - damping + damping * dangling_rank;
+        }
+
+        jump_d = jump;
+
+        const ValueType change =
+            thrust::transform_reduce(CountingIterator(0), CountingIterator(N),
+                                     pagerank_row<IndexType,ValueType>(thrust::raw_pointer_cast(G_t.row_offsets.data()),
+                                                                       thrust::raw_pointer_cast(G_t.column_indices.data()),
+                                                                       thrust::raw_pointer_cast(inverse_degree.data()),
+                                                                       thrust::raw_pointer_cast(jump_d.data()),
+                                                                       thrust::raw_pointer_cast(V.values.data()),
+                                                                       thrust::raw_pointer_cast(X.values.data()),
+                                                                       thrust::raw_pointer_cast(Y.values.data()),
+                                                                       damping, N, K),
+                                     ValueType(0), thrust::plus<ValueType>());
+
+        X.values.swap(Y.values);
+        iteration++;
+
+        if (change < tolerance)
+            break;
+    }
+
+    return iteration;
+}
+
+template <typename MatrixType>
+void check_pagerank_arguments(const MatrixType& G, const double damping)
+{
+    if (G.num_rows != G.num_cols)
+        throw cusp::invalid_input_exception("matrix must be square");
+
+    if (!(damping >= 0.0 && damping < 1.0))
+        throw cusp::invalid_input_exception("damping must be in [0,1)");
+}
+
+template <typename ArrayType, typename ValueType, typename MemorySpace>
+void pagerank_personalization(const ArrayType& personalization,
+                              cusp::array2d<ValueType,MemorySpace,cusp::column_major>& V,
+                              cusp::array1d_format)
+{
+    V.resize(personalization.size(), 1);
+    thrust::copy(personalization.begin(), personalization.end(), V.values.begin());
+}
+
+template <typename ArrayType, typename ValueType, typename MemorySpace>
+void pagerank_personalization(const ArrayType& personalization,
+                              cusp::array2d<ValueType,MemorySpace,cusp::column_major>& V,
+                              cusp::array2d_format)
+{
+    // the columns of V are contiguous
+    V.resize(personalization.num_rows, personalization.num_cols);
+    cusp::copy(personalization, V);
+}
+
+template <typename ValueType, typename MemorySpace, typename ArrayType>
+void pagerank_ranks(const cusp::array2d<ValueType,MemorySpace,cusp::column_major>& X,
+                    ArrayType& ranks,
+                    cusp::array1d_format)
+{
+    ranks = X.values;
+}
+
+template <typename ValueType, typename MemorySpace, typename ArrayType>
+void pagerank_ranks(const cusp::array2d<ValueType,MemorySpace,cusp::column_major>& X,
+                    ArrayType& ranks,
+                    cusp::array2d_format)
+{
+    ranks = X;
+}
+
+} // end namespace detail
+
+/////////////////
+// Entry Point //
+/////////////////
+
+template<typename MatrixType, typename ArrayType>
+size_t pagerank(const MatrixType& G, ArrayType& ranks,
+                const double damping, const double tolerance,
+                const size_t max_iterations)
+{
+    CUSP_PROFILE_SCOPED();
+
+    typedef typename ArrayType::value_type    ValueType;
+    typedef typename MatrixType::memory_space MemorySpace;
+
+    cusp::graph::detail::check_pagerank_arguments(G, damping);
+
+    const size_t N = G.num_rows;
+
+    cusp::array2d<ValueType,MemorySpace,cusp::column_major> V(N, 1, N == 0 ? ValueType(0) : ValueType(1) / ValueType(N));
+    cusp::array2d<ValueType,MemorySpace,cusp::column_major> X;
+
+    const size_t iterations = cusp::graph::detail::pagerank(G, V, X, ValueType(damping), ValueType(tolerance), max_iterations);
+
+    ranks = X.values;
+
+    return iterations;
+}
+
+template<typename MatrixType, typename ArrayType1, typename ArrayType2>
+size_t personalized_pagerank(const MatrixType& G, const ArrayType1& personalization, ArrayType2& ranks,
+                             const double damping, const double tolerance,
+                             const size_t max_iterations)
+{
+    CUSP_PROFILE_SCOPED();
+
+    typedef typename ArrayType2::value_type   ValueType;
+    typedef typename MatrixType::memory_space MemorySpace;
+
+    cusp::graph::detail::check_pagerank_arguments(G, damping);
+
+    cusp::array2d<ValueType,MemorySpace,cusp::column_major> V;
+    cusp::graph::detail::pagerank_personalization(personalization, V, typename ArrayType1::format());
+
+    if (V.num_rows != G.num_rows)
+        throw cusp::invalid_input_exception("personalization must have one row per vertex");
+
+    if (thrust::count_if(V.values.begin(), V.values.end(), cusp::graph::detail::pagerank_is_negative<ValueType>()) > 0)
+        throw cusp::invalid_input_exception("personalization must be non-negative");
+
+    // every jump vector sums to one
+    for (size_t k = 0; k < V.num_cols && V.num_rows > 0; k++)
+    {
+        const ValueType sum = thrust::reduce(V.values.begin() + k * V.pitch,
+                                             V.values.begin() + k * V.pitch + V.num_rows,
+                                             ValueType(0));
+
+        if (!(sum > ValueType(0)))
+            throw cusp::invalid_input_exception("personalization vectors must have a positive sum");
+
+        cusp::blas::scal(V.column(k), ValueType(1) / sum);
+    }
+
+    cusp::array2d<ValueType,MemorySpace,cusp::column_major> X;
+
+    const size_t iterations = cusp::graph::detail::pagerank(G, V, X, ValueType(damping), ValueType(tolerance), max_iterations);
+
+    cusp::graph::detail::pagerank_ranks(X, ranks, typename ArrayType2::format());
+
+    return iterations;
+}
+
+} // end namespace graph
+} // end namespace cusp
@@ -0,0 +1,830 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+#include <cusp/array1d.h>
+#include <cusp/coo_matrix.h>
+#include <cusp/csr_matrix.h>
+#include <cusp/exception.h>
+#include <cusp/detail/random.h>
+#include <cusp/graph/symmetric_rcm.h>
+
+#include <thrust/binary_search.h>
+#include <thrust/copy.h>
+#include <thrust/count.h>
+#include <thrust/fill.h>
+#include <thrust/functional.h>
+#include <thrust/gather.h>
+#include <thrust/reduce.h>
+#include <thrust/remove.h>
+#include <thrust/scan.h>
+#include <thrust/scatter.h>
+#include <thrust/sequence.h>
+#include <thrust/sort.h>
+#include <thrust/transform.h>
+#include <thrust/transform_reduce.h>
+#include <thrust/tuple.h>
+#include <thrust/iterator/counting_iterator.h>
+#include <thrust/iterator/transform_iterator.h>
+#include <thrust/iterator/zip_iterator.h>
+
+#include <cmath>
+#include <vector>
+
+namespace cusp
+{
+namespace graph
+{
+namespace detail
+{
+
+// graph of one level of the hierarchy, with the vertex of the next
+// coarser level which contains each of its vertices
+template <typename IndexType, typename MemorySpace>
+struct partition_level
+{
+    size_t num_vertices;
+
+    cusp::array1d<IndexType,MemorySpace> rows;
+    cusp::array1d<IndexType,MemorySpace> columns;
+    cusp::array1d<IndexType,MemorySpace> edge_weights;
+    cusp::array1d<IndexType,MemorySpace> vertex_weights;
+    cusp::array1d<IndexType,MemorySpace> aggregates;
+
+    partition_level() : num_vertices(0) {}
+};
+
+////////////////
+// Coarsening //
+////////////////
+
+// the proposal of an edge holds its weight, a hash shared by both of its
+// endpoints which breaks ties, and the neighbor
+template <typename IndexType>
+struct partition_edge_proposal
+{
+    typedef thrust::tuple<IndexType,unsigned int,IndexType> result_type;
+
+    const IndexType * matches;
+    cusp::detail::detail::random_integer_functor<IndexType,unsigned int> hash;
+
+    partition_edge_proposal(const IndexType * matches, size_t seed)
+      : matches(matches), hash(seed) {}
+
+    template <typename Tuple>
+    __host__ __device__
+    result_type operator()(const Tuple& t) const
+    {
+        const IndexType r = thrust::get<0>(t);
+        const IndexType c = thrust::get<1>(t);
+
+        if (r == c || matches[r] != IndexType(-1) || matches[c] != IndexType(-1))
+            return result_type(IndexType(-1), 0, IndexType(-1));
+
+        const IndexType lo = r < c ? r : c;
+        const IndexType hi = r < c ? c : r;
+
+        return result_type(thrust::get<2>(t), hash(IndexType(hash(lo) ^ (unsigned int) hi)), c);
+    }
+};
+
+struct partition_heavier_proposal
+{
+    template <typename Tuple>
+    __host__ __device__
+    Tuple operator()(const Tuple& a, const Tuple& b) const
+    {
+        if (thrust::get<0>(a) != thrust::get<0>(b))
+            return thrust::get<0>(a) > thrust::get<0>(b) ? a : b;
+        if (thrust::get<1>(a) != thrust::get<1>(b))
+            return thrust::get<1>(a) > thrust::get<1>(b) ? a : b;
+        return thrust::get<2>(a) < thrust::get<2>(b) ? a : b;
+    }
+};
+
+// vertices which propose to each other are matched
+template <typename IndexType>
+struct partition_mutual_match
+{
+    const IndexType * matches;
+    const IndexType * proposals;
+
+    partition_mutual_match(const IndexType * matches, const IndexType * proposals)
+      : matches(matches), proposals(proposals) {}
+
+    __host__ __device__
+    IndexType operator()(const IndexType& v) const
+    {
+        if (matches[v] != IndexType(-1))
+            return matches[v];
+
+        const IndexType u = proposals[v];
+
+        return (u != IndexType(-1) && proposals[u] == v) ? u : IndexType(-1);
+    }
+};
+
+// the smaller vertex of each pair represents it on the coarse level
+template <typename IndexType>
+struct partition_representative
+{
+    const IndexType * matches;
+
+    partition_representative(const IndexType * matches)
+      : matches(matches) {}
+
+    __host__ __device__
+    IndexType operator()(const IndexType& v) const
+    {
+        const IndexType u = matches[v];
+        return (u == IndexType(-1) || v < u) ? v : u;
+    }
+};
+
+struct partition_self_loop
+{
+    template <typename Tuple>
+    __host__ __device__
+    bool operator()(const Tuple& t) const
+    {
+        return thrust::get<0>(t) == thrust::get<1>(t);
+    }
+};
+
+template <typename IndexType, typename MemorySpace>
+void partition_coarsen(partition_level<IndexType,MemorySpace>& fine,
+                       partition_level<IndexType,MemorySpace>& coarse,
+                       const size_t seed)
+{
+    const size_t N = fine.num_vertices;
+    const size_t E = fine.rows.size();
+
+    cusp::array1d<IndexType,MemorySpace> matches(N, IndexType(-1));
+    cusp::array1d<IndexType,MemorySpace> proposals(N);
+    cusp::array1d<IndexType,MemorySpace> keys(N);
+    cusp::array1d<IndexType,MemorySpace> weights(N);
+    cusp::array1d<unsigned int,MemorySpace> hashes(N);
+    cusp::array1d<IndexType,MemorySpace> neighbors(N);
+
+    // a few rounds of heavy-edge matching among the unmatched vertices
+    for(size_t round = 0; round < 4; round++)
+    {
+        thrust::fill(proposals.begin(), proposals.end(), IndexType(-1));
+
+        size_t num_keys =
+            thrust::reduce_by_key(fine.rows.begin(), fine.rows.end(),
+                                  thrust::make_transform_iterator(
+                                      thrust::make_zip_iterator(thrust::make_tuple(fine.rows.begin(), fine.columns.begin(), fine.edge_weights.begin())),
+                                      partition_edge_proposal<IndexType>(thrust::raw_pointer_cast(&matches[0]), seed + round)),
+                                  keys.begin(),
+                                  thrust::make_zip_iterator(thrust::make_tuple(weights.begin(), hashes.begin(), neighbors.begin())),
+                                  thrust::equal_to<IndexType>(),
+                                  partition_heavier_proposal()).first - keys.begin();
+
+        thrust::scatter(neighbors.begin(), neighbors.begin() + num_keys, keys.begin(), proposals.begin());
+
+        thrust::transform(thrust::counting_iterator<IndexType>(0), thrust::counting_iterator<IndexType>(N),
+                          matches.begin(),
+                          partition_mutual_match<IndexType>(thrust::raw_pointer_cast(&matches[0]),
+                                                            thrust::raw_pointer_cast(&proposals[0])));
+    }
+
+    // number the representatives of the pairs and unmatched vertices
+    cusp::array1d<IndexType,MemorySpace> representatives(N);
+    thrust::transform(thrust::counting_iterator<IndexType>(0), thrust::counting_iterator<IndexType>(N),
+                      representatives.begin(),
+                      partition_representative<IndexType>(thrust::raw_pointer_cast(&matches[0])));
+
+    cusp::array1d<IndexType,MemorySpace> ids(N);
+    thrust::transform(representatives.begin(), representatives.end(), thrust::counting_iterator<IndexType>(0),
+                      ids.begin(), thrust::equal_to<IndexType>());
+    const size_t num_coarse = thrust::reduce(ids.begin(), ids.end());
+    thrust::exclusive_scan(ids.begin(), ids.end(), ids.begin());
+
+    fine.aggregates.resize(N);
+    thrust::gather(representatives.begin(), representatives.end(), ids.begin(), fine.aggregates.begin());
+
+    // contract the edges, dropping those within an aggregate and summing parallel ones
+    cusp::array1d<IndexType,MemorySpace> rows(E);
+    cusp::array1d<IndexType,MemorySpace> columns(E);
+    cusp::array1d<IndexType,MemorySpace> edge_weights(fine.edge_weights);
+
+    thrust::gather(fine.rows.begin(),    fine.rows.end(),    fine.aggregates.begin(), rows.begin());
+    thrust::gather(fine.columns.begin(), fine.columns.end(), fine.aggregates.begin(), columns.begin());
+
+    const size_t num_edges =
+        thrust::remove_if(thrust::make_zip_iterator(thrust::make_tuple(rows.begin(), columns.begin(), edge_weights.begin())),
+                          thrust::make_zip_iterator(thrust::make_tuple(rows.end(),   columns.end(),   edge_weights.end())),
+                          partition_self_loop())
+        - thrust::make_zip_iterator(thrust::make_tuple(rows.begin(), columns.begin(), edge_weights.begin()));
+
+    thrust::stable_sort_by_key(columns.begin(), columns.begin() + num_edges,
+                               thrust::make_zip_iterator(thrust::make_tuple(rows.begin(), edge_weights.begin())));
+    thrust::stable_sort_by_key(rows.begin(), rows.begin() + num_edges,
+                               thrust::make_zip_iterator(thrust::make_tuple(columns.begin(), edge_weights.begin())));
+
+    coarse.rows.resize(num_edges);
+    coarse.columns.resize(num_edges);
+    coarse.edge_weights.resize(num_edges);
+
+    const size_t num_coarse_edges =
+        thrust::reduce_by_key(thrust::make_zip_iterator(thrust::make_tuple(rows.begin(), columns.begin())),
+                              thrust::make_zip_iterator(thrust::make_tuple(rows.begin(), columns.begin())) + num_edges,
+                              edge_weights.begin(),
+                              thrust::make_zip_iterator(thrust::make_tuple(coarse.rows.begin(), coarse.columns.begin())),
+                              coarse.edge_weights.begin()).second - coarse.edge_weights.begin();
+
+    coarse.rows.resize(num_coarse_edges);
+    coarse.columns.resize(num_coarse_edges);
+    coarse.edge_weights.resize(num_coarse_edges);
+
+    // the weight of a coarse vertex is the weight of its aggregate
+    cusp::array1d<IndexType,MemorySpace> aggregates(fine.aggregates);
+    cusp::array1d<IndexType,MemorySpace> vertex_weights(fine.vertex_weights);
+    thrust::sort_by_key(aggregates.begin(), aggregates.end(), vertex_weights.begin());
+
+    coarse.num_vertices = num_coarse;
+    coarse.vertex_weights.resize(num_coarse);
+    thrust::reduce_by_key(aggregates.begin(), aggregates.end(), vertex_weights.begin(),
+                          ids.begin(), coarse.vertex_weights.begin());
+}
+
+///////////////////////
+// Initial Partition //
+///////////////////////
+
+// the coarsest graph is cut into bands of equal weight along its RCM ordering
+template <typename IndexType, typename MemorySpace>
+void partition_initial(const partition_level<IndexType,MemorySpace>& level, const size_t num_parts,
+                       cusp::array1d<IndexType,MemorySpace>& parts)
+{
+    const size_t N = level.num_vertices;
+
+    cusp::coo_matrix<IndexType,IndexType,cusp::host_memory> coo(N, N, level.rows.size());
+    coo.row_indices    = level.rows;
+    coo.column_indices = level.columns;
+    coo.values         = level.edge_weights;
+
+    cusp::csr_matrix<IndexType,IndexType,cusp::host_memory> csr(coo);
+
+    cusp::array1d<IndexType,cusp::host_memory> permutation;
+    cusp::graph::symmetric_rcm(csr, permutation);
+
+    cusp::array1d<IndexType,cusp::host_memory> vertex_weights(level.vertex_weights);
+    cusp::array1d<IndexType,cusp::host_memory> h_parts(N);
+
+    size_t total_weight = 0;
+    for(size_t i = 0; i < N; i++)
+        total_weight += vertex_weights[i];
+
+    // each vertex goes to the band containing the middle of its weight
+    size_t prefix = 0;
+    for(size_t i = 0; i < N; i++)
+    {
+        const IndexType v = permutation[i];
+        const size_t part = ((2 * prefix + vertex_weights[v]) * num_parts) / (2 * total_weight);
+
+        h_parts[v] = part < num_parts ? part : num_parts - 1;
+        prefix += vertex_weights[v];
+    }
+
+    parts = h_parts;
+}
+
+////////////////
+// Refinement //
+////////////////
+
+// sum of the connections of a vertex to its own part and the strongest
+// connection to another part in the direction of the pass
+template <typename IndexType>
+struct partition_connection
+{
+    typedef thrust::tuple<IndexType,IndexType,IndexType> result_type;
+
+    const IndexType * parts;
+    bool upward;
+
+    partition_connection(const IndexType * parts, bool upward)
+      : parts(parts), upward(upward) {}
+
+    template <typename Tuple>
+    __host__ __device__
+    result_type operator()(const Tuple& t) const
+    {
+        const IndexType own  = parts[thrust::get<0>(t)];
+        const IndexType part = thrust::get<1>(t);
+
+        if (part == own)
+            return result_type(thrust::get<2>(t), IndexType(-1), IndexType(-1));
+
+        if ((part > own) != upward)
+            return result_type(IndexType(0), IndexType(-1), IndexType(-1));
+
+        return result_type(IndexType(0), thrust::get<2>(t), part);
+    }
+};
+
+struct partition_stronger_connection
+{
+    template <typename Tuple>
+    __host__ __device__
+    Tuple operator()(const Tuple& a, const Tuple& b) const
+    {
+        const bool a_wins = thrust::get<1>(a) != thrust::get<1>(b)
+                          ? thrust::get<1>(a) > thrust::get<1>(b)
+                          : thrust::get<2>(a) < thrust::get<2>(b);
+
+        return Tuple(thrust::get<0>(a) + thrust::get<0>(b),
+                     a_wins ? thrust::get<1>(a) : thrust::get<1>(b),
+                     a_wins ? thrust::get<2>(a) : thrust::get<2>(b));
+    }
+};
+
+// a vertex moves when it gains connections, or when its part is too heavy
+template <typename IndexType>
+struct partition_should_move
+{
+    const IndexType * parts;
+    const IndexType * part_weights;
+    IndexType max_weight;
+
+    partition_should_move(const IndexType * parts, const IndexType * part_weights, IndexType max_weight)
+      : parts(parts), part_weights(part_weights), max_weight(max_weight) {}
+
+    template <typename Tuple>
+    __host__ __device__
+    bool operator()(const Tuple& t) const
+    {
+        const IndexType v      = thrust::get<0>(t);
+        const IndexType own    = thrust::get<1>(t);
+        const IndexType strong = thrust::get<2>(t);
+        const IndexType target = thrust::get<3>(t);
+
+        if (target == IndexType(-1))
+            return false;
+
+        return strong > own || part_weights[parts[v]] > max_weight;
+    }
+};
+
+template <typename IndexType>
+struct partition_gain
+{
+    template <typename Tuple>
+    __host__ __device__
+    IndexType operator()(const Tuple& t) const
+    {
+        return thrust::get<2>(t) - thrust::get<1>(t);
+    }
+};
+
+// only moves which lose connections count against the excess of their part
+template <typename IndexType>
+struct partition_balance_weight
+{
+    template <typename Tuple>
+    __host__ __device__
+    IndexType operator()(const Tuple& t) const
+    {
+        return thrust::get<0>(t) > 0 ? IndexType(0) : thrust::get<1>(t);
+    }
+};
+
+// (gain, weight, prefix, source)
+template <typename IndexType>
+struct partition_source_admit
+{
+    const IndexType * part_weights;
+    IndexType max_weight;
+
+    partition_source_admit(const IndexType * part_weights, IndexType max_weight)
+      : part_weights(part_weights), max_weight(max_weight) {}
+
+    template <typename Tuple>
+    __host__ __device__
+    IndexType operator()(const Tuple& t) const
+    {
+        if (thrust::get<0>(t) > 0)
+            return 1;
+
+        return thrust::get<2>(t) - thrust::get<1>(t) < part_weights[thrust::get<3>(t)] - max_weight;
+    }
+};
+
+// (admitted, prefix, target)
+template <typename IndexType>
+struct partition_target_admit
+{
+    const IndexType * part_weights;
+    IndexType max_weight;
+
+    partition_target_admit(const IndexType * part_weights, IndexType max_weight)
+      : part_weights(part_weights), max_weight(max_weight) {}
+
+    template <typename Tuple>
+    __host__ __device__
+    IndexType operator()(const Tuple& t) const
+    {
+        return thrust::get<0>(t) && thrust::get<1>(t) <= max_weight - part_weights[thrust::get<2>(t)];
+    }
+};
+
+template <typename Array>
+void partition_part_weights(const Array& parts, const Array& vertex_weights, const size_t num_parts, Array& part_weights)
+{
+    typedef typename Array::value_type IndexType;
+
+    Array sorted_parts(parts);
+    Array weights(vertex_weights);
+    thrust::sort_by_key(sorted_parts.begin(), sorted_parts.end(), weights.begin());
+
+    Array keys(num_parts);
+    Array sums(num_parts);
+    size_t num_keys = thrust::reduce_by_key(sorted_parts.begin(), sorted_parts.end(), weights.begin(),
+                                            keys.begin(), sums.begin()).first - keys.begin();
+
+    part_weights.resize(num_parts);
+    thrust::fill(part_weights.begin(), part_weights.end(), IndexType(0));
+    thrust::scatter(sums.begin(), sums.begin() + num_keys, keys.begin(), part_weights.begin());
+}
+
+// weight of the proposals of the same part up to each proposal, taking the
+// proposals of a part in order of decreasing gain
+template <typename Array>
+void partition_prefix_weights(const Array& keys, const Array& gains, const Array& weights, Array& prefix)
+{
+    typedef typename Array::value_type IndexType;
+
+    const size_t Q = keys.size();
+
+    Array order(Q);
+    Array sorted(gains);
+    Array scanned(Q);
+
+    thrust::sequence(order.begin(), order.end());
+    thrust::stable_sort_by_key(sorted.begin(), sorted.end(), order.begin(), thrust::greater<IndexType>());
+    thrust::gather(order.begin(), order.end(), keys.begin(), sorted.begin());
+    thrust::stable_sort_by_key(sorted.begin(), sorted.end(), order.begin());
+
+    thrust::gather(order.begin(), order.end(), weights.begin(), scanned.begin());
+    thrust::inclusive_scan_by_key(sorted.begin(), sorted.end(), scanned.begin(), scanned.begin());
+
+    prefix.resize(Q);
+    thrust::scatter(scanned.begin(), scanned.end(), order.begin(), prefix.begin());
+}
+
+// parallel boundary refinement, alternating the direction of the moves
+// between passes so that neighbors do not swap parts back and forth
+template <typename IndexType, typename MemorySpace>
+void partition_refine(const partition_level<IndexType,MemorySpace>& level, const size_t num_parts,
+                      const IndexType max_weight, cusp::array1d<IndexType,MemorySpace>& parts)
+{
+    typedef cusp::array1d<IndexType,MemorySpace> Array;
+
+    const size_t N = level.num_vertices;
+    const size_t E = level.rows.size();
+
+    if (E == 0)
+        return;
+
+    Array part_weights;
+    Array rows(E), targets(E), weights(E);
+    Array vertices(N), own(N), strong(N), strongest(N);
+
+    size_t idle_passes = 0;
+
+    for(size_t pass = 0; pass < 8 && idle_passes < 2; pass++)
+    {
+        partition_part_weights(parts, level.vertex_weights, num_parts, part_weights);
+
+        // connection of each vertex to each neighboring part
+        thrust::copy(level.rows.begin(), level.rows.end(), rows.begin());
+        thrust::copy(level.edge_weights.begin(), level.edge_weights.end(), weights.begin());
+        thrust::gather(level.columns.begin(), level.columns.end(), parts.begin(), targets.begin());
+
+        thrust::stable_sort_by_key(targets.begin(), targets.end(),
+                                   thrust::make_zip_iterator(thrust::make_tuple(rows.begin(), weights.begin())));
+        thrust::stable_sort_by_key(rows.begin(), rows.end(),
+                                   thrust::make_zip_iterator(thrust::make_tuple(targets.begin(), weights.begin())));
+
+        Array connection_rows(E), connection_parts(E), connections(E);
+        size_t num_connections =
+            thrust::reduce_by_key(thrust::make_zip_iterator(thrust::make_tuple(rows.begin(), targets.begin())),
+                                  thrust::make_zip_iterator(thrust::make_tuple(rows.end(),   targets.end())),
+                                  weights.begin(),
+                                  thrust::make_zip_iterator(thrust::make_tuple(connection_rows.begin(), connection_parts.begin())),
+                                  connections.begin()).second - connections.begin();
+
+        size_t num_boundary =
+            thrust::reduce_by_key(connection_rows.begin(), connection_rows.begin() + num_connections,
+                                  thrust::make_transform_iterator(
+                                      thrust::make_zip_iterator(thrust::make_tuple(connection_rows.begin(), connection_parts.begin(), connections.begin())),
+                                      partition_connection<IndexType>(thrust::raw_pointer_cast(&parts[0]), pass % 2 == 0)),
+                                  vertices.begin(),
+                                  thrust::make_zip_iterator(thrust::make_tuple(own.begin(), strong.begin(), strongest.begin())),
+                                  thrust::equal_to<IndexType>(),
+                                  partition_stronger_connection()).first - vertices.begin();
+
+        // candidate moves
+        cusp::array1d<bool,MemorySpace> stencil(num_boundary);
+        thrust::transform(thrust::make_zip_iterator(thrust::make_tuple(vertices.begin(), own.begin(), strong.begin(), strongest.begin())),
+                          thrust::make_zip_iterator(thrust::make_tuple(vertices.begin(), own.begin(), strong.begin(), strongest.begin())) + num_boundary,
+                          stencil.begin(),
+                          partition_should_move<IndexType>(thrust::raw_pointer_cast(&parts[0]),
+                                                           thrust::raw_pointer_cast(&part_weights[0]), max_weight));
+
+        const size_t Q = thrust::count(stencil.begin(), stencil.end(), true);
+
+        if (Q == 0)
+        {
+            idle_passes++;
+            continue;
+        }
+
+        Array moved(Q), sources(Q), destinations(Q), gains(Q), moved_weights(Q);
+
+        thrust::copy_if(thrust::make_zip_iterator(thrust::make_tuple(vertices.begin(), strongest.begin(),
+                                                                     thrust::make_transform_iterator(
+                                                                         thrust::make_zip_iterator(thrust::make_tuple(vertices.begin(), own.begin(), strong.begin())),
+                                                                         partition_gain<IndexType>()))),
+                        thrust::make_zip_iterator(thrust::make_tuple(vertices.begin(), strongest.begin(),
+                                                                     thrust::make_transform_iterator(
+                                                                         thrust::make_zip_iterator(thrust::make_tuple(vertices.begin(), own.begin(), strong.begin())),
+                                                                         partition_gain<IndexType>()))) + num_boundary,
+                        stencil.begin(),
+                        thrust::make_zip_iterator(thrust::make_tuple(moved.begin(), destinations.begin(), gains.begin())),
+                        thrust::identity<bool>());
+
+        thrust::gather(moved.begin(), moved.end(), parts.begin(), sources.begin());
+        thrust::gather(moved.begin(), moved.end(), level.vertex_weights.begin(), moved_weights.begin());
+
+        // limit the moves out of heavy parts to their excess weight
+        Array balance_weights(Q), prefix(Q), admitted(Q);
+        thrust::transform(thrust::make_zip_iterator(thrust::make_tuple(gains.begin(), moved_weights.begin())),
+                          thrust::make_zip_iterator(thrust::make_tuple(gains.end(),   moved_weights.end())),
+                          balance_weights.begin(), partition_balance_weight<IndexType>());
+        partition_prefix_weights(sources, gains, balance_weights, prefix);
+        thrust::transform(thrust::make_zip_iterator(thrust::make_tuple(gains.begin(), balance_weights.begin(), prefix.begin(), sources.begin())),
+                          thrust::make_zip_iterator(thrust::make_tuple(gains.end(),   balance_weights.end(),   prefix.end(),   sources.end())),
+                          admitted.begin(),
+                          partition_source_admit<IndexType>(thrust::raw_pointer_cast(&part_weights[0]), max_weight));
+
+        // limit the moves into each part to its remaining capacity
+        thrust::transform(admitted.begin(), admitted.end(), moved_weights.begin(), balance_weights.begin(), thrust::multiplies<IndexType>());
+        partition_prefix_weights(destinations, gains, balance_weights, prefix);
+        thrust::transform(thrust::make_zip_iterator(thrust::make_tuple(admitted.begin(), prefix.begin(), destinations.begin())),
+                          thrust::make_zip_iterator(thrust::make_tuple(admitted.end(),   prefix.end(),   destinations.end())),
+                          admitted.begin(),
+                          partition_target_admit<IndexType>(thrust::raw_pointer_cast(&part_weights[0]), max_weight));
+
+        if (thrust::reduce(admitted.begin(), admitted.end()) == 0)
+        {
+            idle_passes++;
+            continue;
+        }
+
+        idle_passes = 0;
+
+        thrust::scatter_if(destinations.begin(), destinations.end(), moved.begin(), admitted.begin(), parts.begin());
+    }
+}
+
+template <typename IndexType>
+struct partition_excess
+{
+    IndexType max_weight;
+
+    partition_excess(IndexType max_weight)
+      : max_weight(max_weight) {}
+
+    __host__ __device__
+    IndexType operator()(const IndexType& weight) const
+    {
+        return weight > max_weight ? weight - max_weight : IndexType(0);
+    }
+};
+
+template <typename IndexType>
+struct partition_capacity
+{
+    IndexType max_weight;
+
+    partition_capacity(IndexType max_weight)
+      : max_weight(max_weight) {}
+
+    __host__ __device__
+    IndexType operator()(const IndexType& weight) const
+    {
+        return weight < max_weight ? max_weight - weight : IndexType(0);
+    }
+};
+
+// the last vertices of each heavy part in the sorted order are its surplus
+template <typename IndexType>
+struct partition_surplus
+{
+    const IndexType * sorted_parts;
+    const IndexType * starts;
+    const IndexType * sizes;
+    const IndexType * excess;
+
+    partition_surplus(const IndexType * sorted_parts, const IndexType * starts,
+                      const IndexType * sizes, const IndexType * excess)
+      : sorted_parts(sorted_parts), starts(starts), sizes(sizes), excess(excess) {}
+
+    __host__ __device__
+    IndexType operator()(const IndexType& i) const
+    {
+        const IndexType p = sorted_parts[i];
+        return i >= starts[p] + sizes[p] - excess[p];
+    }
+};
+
+// The refinement only moves boundary vertices, so parts which the initial
+// partition made too heavy from coarse vertex weights may stay too heavy.
+// With the unit weights of the finest level the surplus of each heavy part
+// is dealt out to the remaining capacity of the light parts.
+template <typename IndexType, typename MemorySpace>
+void partition_rebalance(const partition_level<IndexType,MemorySpace>& level, const size_t num_parts,
+                         const IndexType max_weight, cusp::array1d<IndexType,MemorySpace>& parts)
+{
+    typedef cusp::array1d<IndexType,MemorySpace> Array;
+
+    const size_t N = level.num_vertices;
+
+    Array sizes;
+    partition_part_weights(parts, level.vertex_weights, num_parts, sizes);
+
+    Array excess(num_parts);
+    thrust::transform(sizes.begin(), sizes.end(), excess.begin(), partition_excess<IndexType>(max_weight));
+
+    if (thrust::reduce(excess.begin(), excess.end()) == 0)
+        return;
+
+    Array capacity(num_parts);
+    thrust::transform(sizes.begin(), sizes.end(), capacity.begin(), partition_capacity<IndexType>(max_weight));
+    thrust::inclusive_scan(capacity.begin(), capacity.end(), capacity.begin());
+
+    Array order(N);
+    Array sorted_parts(parts);
+    thrust::sequence(order.begin(), order.end());
+    thrust::stable_sort_by_key(sorted_parts.begin(), sorted_parts.end(), order.begin());
+
+    Array starts(num_parts);
+    thrust::lower_bound(sorted_parts.begin(), sorted_parts.end(),
+                        thrust::counting_iterator<IndexType>(0),
+                        thrust::counting_iterator<IndexType>(num_parts),
+                        starts.begin());
+
+    Array surplus(N);
+    thrust::transform(thrust::counting_iterator<IndexType>(0), thrust::counting_iterator<IndexType>(N),
+                      surplus.begin(),
+                      partition_surplus<IndexType>(thrust::raw_pointer_cast(&sorted_parts[0]),
+                                                   thrust::raw_pointer_cast(&starts[0]),
+                                                   thrust::raw_pointer_cast(&sizes[0]),
+                                                   thrust::raw_pointer_cast(&excess[0])));
+
+    // surplus vertex j fills the j-th free slot
+    Array slots(N);
+    Array targets(N);
+    thrust::exclusive_scan(surplus.begin(), surplus.end(), slots.begin());
+    thrust::upper_bound(capacity.begin(), capacity.end(), slots.begin(), slots.end(), targets.begin());
+
+    thrust::scatter_if(targets.begin(), targets.end(), order.begin(), surplus.begin(), parts.begin());
+}
+
+template <typename IndexType>
+struct partition_cut_weight
+{
+    const IndexType * parts;
+
+    partition_cut_weight(const IndexType * parts)
+      : parts(parts) {}
+
+    template <typename Tuple>
+    __host__ __device__
+    size_t operator()(const Tuple& t) const
+    {
+        return parts[thrust::get<0>(t)] != parts[thrust::get<1>(t)] ? size_t(thrust::get<2>(t)) : size_t(0);
+    }
+};
+
+} // end namespace detail
+
+/////////////////
+// Entry Point //
+/////////////////
+
+template<typename MatrixType, typename ArrayType>
+size_t partition(const MatrixType& G, const size_t num_parts, ArrayType& parts, const float imbalance)
+{
+    CUSP_PROFILE_SCOPED();
+
+    typedef typename MatrixType::index_type   IndexType;
+    typedef typename MatrixType::value_type   ValueType;
+    typedef typename MatrixType::memory_space MemorySpace;
+
+    typedef cusp::graph::detail::partition_level<IndexType,MemorySpace> Level;
+
+    if(G.num_rows != G.num_cols)
+        throw cusp::invalid_input_exception("matrix must be square");
+
+    if(num_parts == 0)
+        throw cusp::invalid_input_exception("number of parts must be positive");
+
+    const size_t N = G.num_rows;
+
+    parts.resize(N);
+
+    if(num_parts == 1 || N == 0)
+    {
+        thrust::fill(parts.begin(), parts.end(), 0);
+        return 0;
+    }
+
+    // the hierarchy never reallocates, so references to levels stay valid
+    const size_t max_levels = 32;
+    std::vector<Level> levels;
+    levels.reserve(max_levels);
+    levels.resize(1);
+
+    {
+        cusp::coo_matrix<IndexType,ValueType,MemorySpace> coo(G);
+
+        Level& finest = levels[0];
+        finest.num_vertices = N;
+        finest.rows.swap(coo.row_indices);
+        finest.columns.swap(coo.column_indices);
+        finest.edge_weights.resize(finest.rows.size());
+        thrust::fill(finest.edge_weights.begin(), finest.edge_weights.end(), IndexType(1));
+        finest.vertex_weights.resize(N);
+        thrust::fill(finest.vertex_weights.begin(), finest.vertex_weights.end(), IndexType(1));
+    }
+
+    // coarsen until a few dozen vertices remain per part or matching stalls
+    const size_t coarse_size = 16 * num_parts;
+
+    while(levels.size() < max_levels && levels.back().num_vertices > coarse_size)
+    {
+        levels.push_back(Level());
+
+        Level& fine   = levels[levels.size() - 2];
+        Level& coarse = levels.back();
+
+        cusp::graph::detail::partition_coarsen(fine, coarse, 4 * levels.size());
+
+        if(coarse.num_vertices == fine.num_vertices)
+        {
+            levels.pop_back();
+            break;
+        }
+
+        if(10 * coarse.num_vertices > 9 * fine.num_vertices)
+            break;
+    }
+
+    const IndexType max_weight = IndexType(std::ceil((1.0 + imbalance) * double(N) / double(num_parts)));
+
+    cusp::array1d<IndexType,MemorySpace> level_parts;
+    cusp::graph::detail::partition_initial(levels.back(), num_parts, level_parts);
+
+    // project the partition back to the finest level, refining on the way
+    for(size_t l = levels.size() - 1; l > 0; l--)
+    {
+        cusp::graph::detail::partition_refine(levels[l], num_parts, max_weight, level_parts);
+
+        cusp::array1d<IndexType,MemorySpace> fine_parts(levels[l - 1].num_vertices);
+        thrust::gather(levels[l - 1].aggregates.begin(), levels[l - 1].aggregates.end(),
+                       level_parts.begin(), fine_parts.begin());
+        level_parts.swap(fine_parts);
+    }
+
+    cusp::graph::detail::partition_rebalance(levels[0], num_parts, max_weight, level_parts);
+    cusp::graph::detail::partition_refine(levels[0], num_parts, max_weight, level_parts);
+
+    thrust::copy(level_parts.begin(), level_parts.end(), parts.begin());
+
+    const Level& finest = levels[0];
+
+    return thrust::transform_reduce(thrust::make_zip_iterator(thrust::make_tuple(finest.rows.begin(), finest.columns.begin(), finest.edge_weights.begin())),
+                                    thrust::make_zip_iterator(thrust::make_tuple(finest.rows.end(),   finest.columns.end(),   finest.edge_weights.end())),
+                                    cusp::graph::detail::partition_cut_weight<IndexType>(thrust::raw_pointer_cast(&level_parts[0])),
+                                    size_t(0), thrust::plus<size_t>()) / 2;
+}
+
+} // end namespace graph
+} // end namespace cusp
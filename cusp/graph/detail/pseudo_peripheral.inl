@@ -19,9 +19,18 @@
 #include <cusp/exception.h>
 #include <cusp/graph/breadth_first_search.h>
 
+#include <cusp/array2d.h>
+
 #include <thrust/copy.h>
+#include <thrust/count.h>
+#include <thrust/extrema.h>
+#include <thrust/functional.h>
 #include <thrust/gather.h>
+#include <thrust/reduce.h>
+#include <thrust/sort.h>
 #include <thrust/iterator/counting_iterator.h>
+#include <thrust/iterator/discard_iterator.h>
+#include <thrust/iterator/transform_iterator.h>
 
 namespace cusp
 {
@@ -30,6 +39,9 @@ namespace graph
 namespace detail
 {
 
+// number of lowest-valence vertices of the last level evaluated per iteration
+const size_t pseudo_peripheral_candidates = 8;
+
 template<typename MatrixType, typename ArrayType>
 typename MatrixType::index_type pseudo_peripheral_vertex(const MatrixType& G, ArrayType& levels, cusp::csr_format)
 {
@@ -38,50 +50,78 @@ typename MatrixType::index_type pseudo_peripheral_vertex(const MatrixType& G, Ar
     typedef typename MatrixType::index_type IndexType;
     typedef typename MatrixType::memory_space MemorySpace;
 
-    IndexType delta = 0;
-    IndexType x = rand() % G.num_rows;
-    IndexType y;
+    const size_t N = G.num_rows;
+
+    IndexType x = rand() % N;
 
-    ArrayType row_lengths(G.num_rows);
+    cusp::graph::breadth_first_search<false>(G, x, levels);
+    IndexType delta = *thrust::max_element(levels.begin(), levels.end());
+
+    cusp::array1d<IndexType,MemorySpace> row_lengths(N);
     thrust::transform(G.row_offsets.begin() + 1, G.row_offsets.end(), G.row_offsets.begin(), row_lengths.begin(), thrust::minus<IndexType>());
 
+    cusp::array2d<IndexType,MemorySpace,cusp::column_major> candidate_levels;
+
     while(1) {
-        cusp::graph::breadth_first_search<false>(G, x, levels);
+        size_t max_count = thrust::count(levels.begin(), levels.end(), delta);
 
-        typename ArrayType::iterator max_level_iter = thrust::max_element(levels.begin(), levels.end());
-        int max_level = *max_level_iter;
-        int max_count = thrust::count(levels.begin(), levels.end(), max_level);
+        cusp::array1d<IndexType,MemorySpace> max_level_vertices(max_count);
+        cusp::array1d<IndexType,MemorySpace> max_level_valence(max_count);
 
-        if( max_count > 1 ) {
-            ArrayType max_level_vertices(max_count);
-            ArrayType max_level_valence(max_count);
+        thrust::copy_if(thrust::counting_iterator<IndexType>(0),
+                        thrust::counting_iterator<IndexType>(N),
+                        levels.begin(),
+                        max_level_vertices.begin(),
+                        _1 == delta);
 
-            thrust::copy_if(thrust::counting_iterator<IndexType>(0),
-                            thrust::counting_iterator<IndexType>(G.num_rows),
-                            levels.begin(),
-                            max_level_vertices.begin(),
-                            _1 == max_level);
+        thrust::gather(max_level_vertices.begin(), max_level_vertices.end(),
+                       row_lengths.begin(),
+                       max_level_valence.begin());
 
-            thrust::gather(thrust::counting_iterator<IndexType>(0),
-                           thrust::counting_iterator<IndexType>(max_count),
-                           row_lengths.begin(),
-                           max_level_valence.begin());
-            int min_valence_pos = thrust::min_element(max_level_valence.begin(), max_level_valence.end()) - max_level_valence.begin();
+        // search from the vertices of lowest valence together
+        thrust::stable_sort_by_key(max_level_valence.begin(), max_level_valence.end(), max_level_vertices.begin());
+        max_level_vertices.resize(thrust::min(max_count, pseudo_peripheral_candidates));
 
-            y = max_level_vertices[min_valence_pos];
-        }
-        else
+        cusp::graph::multi_source_breadth_first_search(G, max_level_vertices, candidate_levels);
+
+        // eccentricities of all candidates in one reduction over the columns
+        const size_t K = max_level_vertices.size();
+
+        cusp::array1d<IndexType,MemorySpace> eccentricities(K);
+        thrust::reduce_by_key(thrust::make_transform_iterator(thrust::counting_iterator<IndexType>(0), _1 / IndexType(N)),
+                              thrust::make_transform_iterator(thrust::counting_iterator<IndexType>(K * N), _1 / IndexType(N)),
+                              candidate_levels.values.begin(),
+                              thrust::make_discard_iterator(),
+                              eccentricities.begin(),
+                              thrust::equal_to<IndexType>(),
+                              thrust::maximum<IndexType>());
+
+        cusp::array1d<IndexType,cusp::host_memory> h_eccentricities(eccentricities);
+
+        // the first candidate of largest eccentricity has the lowest valence
+        size_t    best = 0;
+        IndexType best_eccentricity = delta;
+
+        for(size_t k = 0; k < K; k++)
         {
-            y = max_level_iter - levels.begin();
+            IndexType eccentricity = h_eccentricities[k];
+            if(eccentricity > best_eccentricity)
+            {
+                best = k;
+                best_eccentricity = eccentricity;
+            }
         }
 
-        if( levels[y] <= delta ) break;
+        if( best_eccentricity <= delta ) break;
 
-        x = y;
-        delta = levels[y];
+        x     = max_level_vertices[best];
+        delta = best_eccentricity;
+        thrust::copy(candidate_levels.values.begin() + best * N,
+                     candidate_levels.values.begin() + (best + 1) * N,
+                     levels.begin());
     }
 
-    return y;
+    return x;
 }
 
 //////////////////
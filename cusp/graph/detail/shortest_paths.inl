@@ -0,0 +1,309 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+#include <cusp/array1d.h>
+#include <cusp/csr_matrix.h>
+#include <cusp/exception.h>
+#include <cusp/sparse_vector.h>
+#include <cusp/spmspv.h>
+#include <cusp/transpose.h>
+
+#include <thrust/copy.h>
+#include <thrust/extrema.h>
+#include <thrust/fill.h>
+#include <thrust/functional.h>
+#include <thrust/gather.h>
+#include <thrust/partition.h>
+#include <thrust/reduce.h>
+#include <thrust/remove.h>
+#include <thrust/scatter.h>
+#include <thrust/sort.h>
+#include <thrust/unique.h>
+#include <thrust/iterator/permutation_iterator.h>
+#include <thrust/iterator/zip_iterator.h>
+
+#include <limits>
+
+namespace cusp
+{
+namespace graph
+{
+namespace detail
+{
+
+// a candidate (vertex, distance) which improves on the distance of its vertex
+template <typename ValueType>
+struct sssp_improves
+{
+    const ValueType * distances;
+
+    sssp_improves(const ValueType * distances) : distances(distances) {}
+
+    template <typename Tuple>
+    __host__ __device__
+    bool operator()(const Tuple& t) const
+    {
+        return thrust::get<1>(t) < distances[thrust::get<0>(t)];
+    }
+};
+
+// a (vertex, distance) below the threshold
+template <typename ValueType>
+struct sssp_near_entry
+{
+    ValueType threshold;
+
+    sssp_near_entry(const ValueType threshold) : threshold(threshold) {}
+
+    template <typename Tuple>
+    __host__ __device__
+    bool operator()(const Tuple& t) const
+    {
+        return thrust::get<1>(t) < threshold;
+    }
+};
+
+template <typename ValueType>
+struct sssp_far_distance
+{
+    ValueType threshold;
+
+    sssp_far_distance(const ValueType threshold) : threshold(threshold) {}
+
+    __host__ __device__
+    bool operator()(const ValueType& d) const
+    {
+        return !(d < threshold);
+    }
+};
+
+// a vertex whose distance is below the threshold
+template <typename IndexType, typename ValueType>
+struct sssp_near_vertex
+{
+    const ValueType * distances;
+    ValueType threshold;
+
+    sssp_near_vertex(const ValueType * distances, const ValueType threshold)
+        : distances(distances), threshold(threshold) {}
+
+    __host__ __device__
+    bool operator()(const IndexType& v) const
+    {
+        return distances[v] < threshold;
+    }
+};
+
+// a zero delta selects the mean edge weight
+template<typename MatrixType, typename ArrayType>
+void near_far_sssp(const MatrixType& G, const typename MatrixType::index_type src,
+                   ArrayType& distances, typename MatrixType::value_type delta)
+{
+    typedef typename MatrixType::index_type   IndexType;
+    typedef typename MatrixType::value_type   ValueType;
+    typedef typename MatrixType::memory_space MemorySpace;
+
+    const size_t N = G.num_rows;
+    const ValueType infinity = std::numeric_limits<ValueType>::max();
+
+    if (G.num_entries > 0)
+    {
+        if (*thrust::min_element(G.values.begin(), G.values.end()) < ValueType(0))
+            throw cusp::invalid_input_exception("edge weights must be non-negative");
+
+        if (delta == ValueType(0))
+            delta = thrust::reduce(G.values.begin(), G.values.end()) / ValueType(G.num_entries);
+    }
+
+    // all weights are zero
+    if (delta == ValueType(0))
+        delta = ValueType(1);
+
+    distances.resize(N);
+    thrust::fill(distances.begin(), distances.end(), infinity);
+    distances[src] = ValueType(0);
+
+    // A is the transpose of G, so the (min,+) product relaxes the edges
+    // leaving the frontier: pushes read them from the rows of G, pulls read
+    // the edges entering a vertex from the rows of the transpose
+    cusp::spmspv_matrix<IndexType,ValueType,MemorySpace> A;
+    A.num_rows    = N;
+    A.num_cols    = N;
+    A.num_entries = G.num_entries;
+    A.columns     = G;
+    cusp::transpose(G, A.rows);
+
+    ValueType * d = thrust::raw_pointer_cast(&distances[0]);
+
+    cusp::sparse_vector<IndexType,ValueType,MemorySpace> near(N, 1);
+    cusp::sparse_vector<IndexType,ValueType,MemorySpace> candidates;
+    near.indices[0] = src;
+    near.values[0]  = ValueType(0);
+
+    cusp::array1d<IndexType,MemorySpace> improved_indices;
+    cusp::array1d<ValueType,MemorySpace> improved_values;
+    cusp::array1d<IndexType,MemorySpace> far;
+
+    ValueType threshold = delta;
+
+    while (true)
+    {
+        // relax the near frontier until no distance below the threshold improves
+        while (near.num_entries > 0)
+        {
+            cusp::generalized_spmspv(A, near, candidates, thrust::plus<ValueType>(), thrust::minimum<ValueType>());
+
+            const size_t num_candidates = candidates.num_entries;
+
+            improved_indices.resize(num_candidates);
+            improved_values.resize(num_candidates);
+
+            const size_t num_improved =
+                thrust::copy_if(thrust::make_zip_iterator(thrust::make_tuple(candidates.indices.begin(), candidates.values.begin())),
+                                thrust::make_zip_iterator(thrust::make_tuple(candidates.indices.end(),   candidates.values.end())),
+                                thrust::make_zip_iterator(thrust::make_tuple(improved_indices.begin(), improved_values.begin())),
+                                sssp_improves<ValueType>(d))
+                - thrust::make_zip_iterator(thrust::make_tuple(improved_indices.begin(), improved_values.begin()));
+
+            thrust::scatter(improved_values.begin(), improved_values.begin() + num_improved,
+                            improved_indices.begin(), distances.begin());
+
+            // improved vertices below the threshold are relaxed again, the others wait
+            near.resize(N, num_improved);
+
+            const size_t num_near =
+                thrust::copy_if(thrust::make_zip_iterator(thrust::make_tuple(improved_indices.begin(), improved_values.begin())),
+                                thrust::make_zip_iterator(thrust::make_tuple(improved_indices.begin(), improved_values.begin())) + num_improved,
+                                thrust::make_zip_iterator(thrust::make_tuple(near.indices.begin(), near.values.begin())),
+                                sssp_near_entry<ValueType>(threshold))
+                - thrust::make_zip_iterator(thrust::make_tuple(near.indices.begin(), near.values.begin()));
+
+            near.resize(N, num_near);
+
+            const size_t num_far = far.size();
+            far.resize(num_far + num_improved - num_near);
+
+            thrust::copy_if(improved_indices.begin(), improved_indices.begin() + num_improved,
+                            improved_values.begin(), far.begin() + num_far,
+                            sssp_far_distance<ValueType>(threshold));
+        }
+
+        // drop the waiting vertices which have since been settled below
+        // the threshold, and the duplicates
+        far.resize(thrust::remove_if(far.begin(), far.end(), sssp_near_vertex<IndexType,ValueType>(d, threshold)) - far.begin());
+
+        if (far.empty())
+            break;
+
+        thrust::sort(far.begin(), far.end());
+        far.resize(thrust::unique(far.begin(), far.end()) - far.begin());
+
+        // advance the threshold by delta past the nearest waiting vertex
+        const ValueType nearest = thrust::reduce(thrust::make_permutation_iterator(distances.begin(), far.begin()),
+                                                 thrust::make_permutation_iterator(distances.begin(), far.end()),
+                                                 infinity, thrust::minimum<ValueType>());
+
+        threshold = nearest < infinity - delta ? nearest + delta : infinity;
+
+        // the waiting vertices below it form the next near frontier
+        const size_t num_near =
+            thrust::stable_partition(far.begin(), far.end(), sssp_near_vertex<IndexType,ValueType>(d, threshold)) - far.begin();
+
+        near.resize(N, num_near);
+        thrust::copy(far.begin(), far.begin() + num_near, near.indices.begin());
+        thrust::gather(near.indices.begin(), near.indices.end(), distances.begin(), near.values.begin());
+
+        cusp::array1d<IndexType,MemorySpace> waiting(far.begin() + num_near, far.end());
+        far.swap(waiting);
+    }
+}
+
+template<typename MatrixType, typename ArrayType>
+void single_source_shortest_paths(const MatrixType& G, const typename MatrixType::index_type src,
+                                  ArrayType& distances, const typename MatrixType::value_type delta,
+                                  cusp::csr_format)
+{
+    cusp::graph::detail::near_far_sssp(G, src, distances, delta);
+}
+
+//////////////////
+// General Path //
+//////////////////
+
+template<typename MatrixType, typename ArrayType, typename Format>
+void single_source_shortest_paths(const MatrixType& G, const typename MatrixType::index_type src,
+                                  ArrayType& distances, const typename MatrixType::value_type delta,
+                                  Format)
+{
+    typedef typename MatrixType::index_type   IndexType;
+    typedef typename MatrixType::value_type   ValueType;
+    typedef typename MatrixType::memory_space MemorySpace;
+
+    cusp::csr_matrix<IndexType,ValueType,MemorySpace> G_csr(G);
+
+    cusp::graph::detail::near_far_sssp(G_csr, src, distances, delta);
+}
+
+} // end namespace detail
+
+/////////////////
+// Entry Point //
+/////////////////
+
+template<typename MatrixType, typename ArrayType>
+void single_source_shortest_paths(const MatrixType& G, const typename MatrixType::index_type src,
+                                  ArrayType& distances)
+{
+    CUSP_PROFILE_SCOPED();
+
+    typedef typename MatrixType::index_type IndexType;
+    typedef typename MatrixType::value_type ValueType;
+
+    if(G.num_rows != G.num_cols)
+        throw cusp::invalid_input_exception("matrix must be square");
+
+    if(src < IndexType(0) || size_t(src) >= G.num_rows)
+        throw cusp::invalid_input_exception("source must be a vertex of the graph");
+
+    cusp::graph::detail::single_source_shortest_paths(G, src, distances, ValueType(0),
+            typename MatrixType::format());
+}
+
+template<typename MatrixType, typename ArrayType>
+void single_source_shortest_paths(const MatrixType& G, const typename MatrixType::index_type src,
+                                  ArrayType& distances, const typename MatrixType::value_type delta)
+{
+    CUSP_PROFILE_SCOPED();
+
+    typedef typename MatrixType::index_type IndexType;
+    typedef typename MatrixType::value_type ValueType;
+
+    if(!(delta > ValueType(0)))
+        throw cusp::invalid_input_exception("delta must be positive");
+
+    if(G.num_rows != G.num_cols)
+        throw cusp::invalid_input_exception("matrix must be square");
+
+    if(src < IndexType(0) || size_t(src) >= G.num_rows)
+        throw cusp::invalid_input_exception("source must be a vertex of the graph");
+
+    cusp::graph::detail::single_source_shortest_paths(G, src, distances, delta,
+            typename MatrixType::format());
+}
+
+} // end namespace graph
+} // end namespace cusp
@@ -0,0 +1,114 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+#pragma once
+
+#include <cusp/detail/config.h>
+
+#include <thrust/functional.h>
+#include <thrust/tuple.h>
+
+namespace cusp
+{
+namespace graph
+{
+namespace detail
+{
+
+// coordinate in [0,1] as an integer in [0, 2^32)
+template <typename ValueType>
+__host__ __device__
+unsigned int curve_coordinate(const ValueType x)
+{
+    return (unsigned int) (double(x) * (double) ~(0U));
+}
+
+// the bits of v spread to every second bit of the result
+__host__ __device__
+inline unsigned long long spread_bits_2d(const unsigned int v)
+{
+    unsigned long long x = v;
+
+    x = (x | (x << 16)) & 0x0000FFFF0000FFFFULL;
+    x = (x | (x <<  8)) & 0x00FF00FF00FF00FFULL;
+    x = (x | (x <<  4)) & 0x0F0F0F0F0F0F0F0FULL;
+    x = (x | (x <<  2)) & 0x3333333333333333ULL;
+    x = (x | (x <<  1)) & 0x5555555555555555ULL;
+
+    return x;
+}
+
+// the 21 low bits of v spread to every third bit of the result
+__host__ __device__
+inline unsigned long long spread_bits_3d(const unsigned int v)
+{
+    unsigned long long x = v & 0x1FFFFF;
+
+    x = (x | (x << 32)) & 0x001F00000000FFFFULL;
+    x = (x | (x << 16)) & 0x001F0000FF0000FFULL;
+    x = (x | (x <<  8)) & 0x100F00F00F00F00FULL;
+    x = (x | (x <<  4)) & 0x10C30C30C30C30C3ULL;
+    x = (x | (x <<  2)) & 0x1249249249249249ULL;
+
+    return x;
+}
+
+// Morton (Z-order) keys interleave the bits of the coordinates, with the
+// same resolution and order of the dimensions as the Hilbert keys
+struct morton_transform_2d : public thrust::unary_function<double,unsigned long long>
+{
+    template<typename Tuple>
+    __host__ __device__
+    unsigned long long operator()(const Tuple& t) const
+    {
+        return (spread_bits_2d(curve_coordinate(thrust::get<0>(t))) << 1)
+             |  spread_bits_2d(curve_coordinate(thrust::get<1>(t)));
+    }
+};
+
+struct morton_transform_3d : public thrust::unary_function<double,unsigned long long>
+{
+    template<typename Tuple>
+    __host__ __device__
+    unsigned long long operator()(const Tuple& t) const
+    {
+        return (spread_bits_3d(curve_coordinate(thrust::get<0>(t)) >> 11) << 2)
+             | (spread_bits_3d(curve_coordinate(thrust::get<1>(t)) >> 11) << 1)
+             |  spread_bits_3d(curve_coordinate(thrust::get<2>(t)) >> 11);
+    }
+};
+
+// part of the point at position i along the curve when n points are split
+// into num_parts parts whose sizes differ by at most one
+template <typename IndexType>
+struct curve_part : public thrust::unary_function<IndexType,IndexType>
+{
+    unsigned long long n, num_parts;
+
+    curve_part(const size_t n, const size_t num_parts)
+        : n(n), num_parts(num_parts) {}
+
+    __host__ __device__
+    IndexType operator()(const IndexType i) const
+    {
+        return IndexType((unsigned long long) i * num_parts / n);
+    }
+};
+
+} // end namespace detail
+} // end namespace graph
+} // end namespace cusp
@@ -17,11 +17,20 @@
 #include <cusp/detail/config.h>
 
 #include <cusp/array1d.h>
+#include <cusp/csr_matrix.h>
 #include <cusp/exception.h>
+#include <cusp/permute.h>
+#include <cusp/detail/format_utils.h>
 #include <cusp/graph/pseudo_peripheral.h>
 
+#include <thrust/binary_search.h>
 #include <thrust/copy.h>
+#include <thrust/functional.h>
 #include <thrust/gather.h>
+#include <thrust/scatter.h>
+#include <thrust/sequence.h>
+#include <thrust/sort.h>
+#include <thrust/transform.h>
 #include <thrust/iterator/counting_iterator.h>
 
 namespace cusp
@@ -31,53 +40,177 @@ namespace graph
 namespace detail
 {
 
-template<typename MatrixType>
-void symmetric_rcm(MatrixType& G, cusp::csr_format)
+// smallest Cuthill-McKee position among the neighbors in the previous level
+template <typename IndexType>
+struct rcm_parent_position
+{
+    IndexType N;
+    const IndexType * row_offsets;
+    const IndexType * column_indices;
+    const IndexType * levels;
+    const IndexType * positions;
+
+    rcm_parent_position(IndexType N, const IndexType * row_offsets, const IndexType * column_indices,
+                        const IndexType * levels, const IndexType * positions)
+      : N(N), row_offsets(row_offsets), column_indices(column_indices), levels(levels), positions(positions) {}
+
+    __host__ __device__
+    IndexType operator()(const IndexType& v) const
+    {
+        const IndexType parent_level = levels[v] - 1;
+
+        IndexType position = N;
+
+        for(IndexType jj = row_offsets[v]; jj < row_offsets[v + 1]; jj++)
+        {
+            const IndexType u = column_indices[jj];
+
+            if(levels[u] == parent_level && positions[u] < position)
+                position = positions[u];
+        }
+
+        return position;
+    }
+};
+
+template<typename MatrixType, typename ArrayType1, typename ArrayType2>
+void symmetric_rcm(const MatrixType& G, ArrayType1& permutation, const ArrayType2& levels, cusp::csr_format)
+{
+    typedef typename MatrixType::index_type IndexType;
+    typedef typename MatrixType::memory_space MemorySpace;
+
+    const size_t N = G.num_rows;
+
+    permutation.resize(N);
+
+    if(N == 0)
+        return;
+
+    cusp::array1d<IndexType,MemorySpace> degrees(N);
+    thrust::transform(G.row_offsets.begin() + 1, G.row_offsets.end(), G.row_offsets.begin(), degrees.begin(), thrust::minus<IndexType>());
+
+    // sort vertices by level in BFS traversal and by degree within a level,
+    // vertices unreachable from the peripheral vertex have level -1
+    cusp::array1d<IndexType,MemorySpace> order(N);
+    cusp::array1d<IndexType,MemorySpace> keys(degrees);
+    thrust::sequence(order.begin(), order.end());
+    thrust::stable_sort_by_key(keys.begin(), keys.end(), order.begin());
+    thrust::gather(order.begin(), order.end(), levels.begin(), keys.begin());
+    thrust::stable_sort_by_key(keys.begin(), keys.end(), order.begin());
+
+    // offsets of the levels -1 to max_level in the sorted order
+    IndexType max_level = keys[N - 1];
+    cusp::array1d<IndexType,MemorySpace> offsets(max_level + 3);
+    thrust::lower_bound(keys.begin(), keys.end(),
+                        thrust::counting_iterator<IndexType>(-1),
+                        thrust::counting_iterator<IndexType>(max_level + 2),
+                        offsets.begin());
+    cusp::array1d<IndexType,cusp::host_memory> level_offsets(offsets);
+
+    cusp::array1d<IndexType,MemorySpace> positions(N);
+    thrust::scatter(thrust::counting_iterator<IndexType>(0), thrust::counting_iterator<IndexType>(N),
+                    order.begin(), positions.begin());
+
+    // Cuthill-McKee numbers the vertices of each level by the position of
+    // their first numbered parent, which only depends on the previous level
+    for(IndexType level = 1; level <= max_level; level++)
+    {
+        const IndexType begin = level_offsets[level + 1];
+        const IndexType end   = level_offsets[level + 2];
+
+        keys.resize(end - begin);
+        thrust::transform(order.begin() + begin, order.begin() + end, keys.begin(),
+                          rcm_parent_position<IndexType>(N, thrust::raw_pointer_cast(&G.row_offsets[0]),
+                                                            thrust::raw_pointer_cast(&G.column_indices[0]),
+                                                            thrust::raw_pointer_cast(&levels[0]),
+                                                            thrust::raw_pointer_cast(&positions[0])));
+
+        // stable, so vertices with the same parent stay ordered by degree
+        thrust::stable_sort_by_key(keys.begin(), keys.end(), order.begin() + begin);
+        thrust::scatter(thrust::counting_iterator<IndexType>(begin), thrust::counting_iterator<IndexType>(end),
+                        order.begin() + begin, positions.begin());
+    }
+
+    // reverse the Cuthill-McKee order
+    thrust::copy(order.rbegin(), order.rend(), permutation.begin());
+}
+
+template<typename MatrixType, typename ArrayType>
+void symmetric_rcm(const MatrixType& G, ArrayType& permutation, cusp::csr_format)
 {
     typedef typename MatrixType::index_type IndexType;
-    typedef typename MatrixType::value_type ValueType;
     typedef typename MatrixType::memory_space MemorySpace;
 
     // find peripheral vertex and return BFS levels from vertex
     cusp::array1d<IndexType,MemorySpace> levels(G.num_rows);
-    cusp::graph::pseudo_peripheral_vertex(G, levels);
 
-    // sort vertices by level in BFS traversal
+    if(G.num_rows > 0)
+        cusp::graph::pseudo_peripheral_vertex(G, levels);
+
+    cusp::graph::detail::symmetric_rcm(G, permutation, levels, cusp::csr_format());
+}
+
+template<typename MatrixType>
+void symmetric_rcm(MatrixType& G, cusp::csr_format)
+{
+    typedef typename MatrixType::index_type IndexType;
+    typedef typename MatrixType::value_type ValueType;
+    typedef typename MatrixType::memory_space MemorySpace;
+
     cusp::array1d<IndexType,MemorySpace> perm(G.num_rows);
-    thrust::sequence(perm.begin(), perm.end());
-    thrust::sort_by_key(levels.begin(), levels.end(), perm.begin()); 
-    // transpose to form RCM permutation matrix
-    thrust::scatter(thrust::counting_iterator<IndexType>(0), thrust::counting_iterator<IndexType>(G.num_rows), perm.begin(), levels.begin());
-
-    // expand offsets to indices
-    cusp::array1d<IndexType,MemorySpace> row_indices(G.num_entries);
-    cusp::detail::offsets_to_indices(G.row_offsets, row_indices);
-
-    // reorder rows and column according to permutation
-    thrust::gather(row_indices.begin(), row_indices.end(), levels.begin(), row_indices.begin());
-    thrust::gather(G.column_indices.begin(), G.column_indices.end(), levels.begin(), G.column_indices.begin());
-
-    // order COO matrix
-    cusp::detail::sort_by_row_and_column(row_indices, G.column_indices, G.values);
-    // update row_offsets to match reordering
-    cusp::detail::indices_to_offsets(row_indices, G.row_offsets);
+    cusp::graph::detail::symmetric_rcm(G, perm, cusp::csr_format());
+
+    // the number of entries of every row is unchanged, so G is overwritten
+    cusp::csr_matrix<IndexType,ValueType,MemorySpace> B;
+    cusp::symmetric_permute(G, perm, B);
+
+    thrust::copy(B.row_offsets.begin(),    B.row_offsets.end(),    G.row_offsets.begin());
+    thrust::copy(B.column_indices.begin(), B.column_indices.end(), G.column_indices.begin());
+    thrust::copy(B.values.begin(),         B.values.end(),         G.values.begin());
 }
 
 //////////////////
 // General Path //
 //////////////////
 
+template<typename MatrixType, typename ArrayType, typename Format>
+void symmetric_rcm(const MatrixType& G, ArrayType& permutation, Format)
+{
+  typedef typename MatrixType::index_type   IndexType;
+  typedef typename MatrixType::value_type   ValueType;
+  typedef typename MatrixType::memory_space MemorySpace;
+
+  // convert matrix to CSR format
+  cusp::csr_matrix<IndexType,ValueType,MemorySpace> G_csr(G);
+
+  cusp::graph::detail::symmetric_rcm(G_csr, permutation, cusp::csr_format());
+}
+
+template<typename MatrixType, typename ArrayType1, typename ArrayType2, typename Format>
+void symmetric_rcm(const MatrixType& G, ArrayType1& permutation, const ArrayType2& levels, Format)
+{
+  typedef typename MatrixType::index_type   IndexType;
+  typedef typename MatrixType::value_type   ValueType;
+  typedef typename MatrixType::memory_space MemorySpace;
+
+  cusp::csr_matrix<IndexType,ValueType,MemorySpace> G_csr(G);
+
+  cusp::graph::detail::symmetric_rcm(G_csr, permutation, levels, cusp::csr_format());
+}
+
 template<typename MatrixType, typename Format>
-void symmetric_rcm(MatrixType& G)
+void symmetric_rcm(MatrixType& G, Format)
 {
   typedef typename MatrixType::index_type   IndexType;
   typedef typename MatrixType::value_type   ValueType;
   typedef typename MatrixType::memory_space MemorySpace;
 
-  // convert matrix to CSR format and compute on the host
+  // convert matrix to CSR format
   cusp::csr_matrix<IndexType,ValueType,MemorySpace> G_csr(G);
 
-  G = cusp::graph::symmetric_rcm(G_csr);
+  cusp::graph::detail::symmetric_rcm(G_csr, cusp::csr_format());
+
+  G = G_csr;
 }
 
 } // end namespace detail
@@ -97,5 +230,30 @@ void symmetric_rcm(MatrixType& G)
     cusp::graph::detail::symmetric_rcm(G, typename MatrixType::format());
 }
 
+template<typename MatrixType, typename ArrayType>
+void symmetric_rcm(const MatrixType& G, ArrayType& permutation)
+{
+    CUSP_PROFILE_SCOPED();
+
+    if(G.num_rows != G.num_cols)
+        throw cusp::invalid_input_exception("matrix must be square");
+
+    cusp::graph::detail::symmetric_rcm(G, permutation, typename MatrixType::format());
+}
+
+template<typename MatrixType, typename ArrayType1, typename ArrayType2>
+void symmetric_rcm(const MatrixType& G, ArrayType1& permutation, const ArrayType2& levels)
+{
+    CUSP_PROFILE_SCOPED();
+
+    if(G.num_rows != G.num_cols)
+        throw cusp::invalid_input_exception("matrix must be square");
+
+    if(levels.size() != G.num_rows)
+        throw cusp::invalid_input_exception("levels must have one entry per vertex");
+
+    cusp::graph::detail::symmetric_rcm(G, permutation, levels, typename MatrixType::format());
+}
+
 } // end namespace graph
 } // end namespace cusp
@@ -0,0 +1,93 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+
+#include <cusp/coo_matrix.h>
+#include <cusp/csr_matrix.h>
+#include <cusp/exception.h>
+#include <cusp/multiply.h>
+
+#include <thrust/copy.h>
+#include <thrust/count.h>
+#include <thrust/fill.h>
+#include <thrust/reduce.h>
+#include <thrust/iterator/zip_iterator.h>
+
+namespace cusp
+{
+namespace graph
+{
+namespace detail
+{
+
+struct is_strictly_lower
+{
+    template <typename Tuple>
+    __host__ __device__
+    bool operator()(const Tuple& t) const
+    {
+        return thrust::get<0>(t) > thrust::get<1>(t);
+    }
+};
+
+} // end namespace detail
+
+/////////////////
+// Entry Point //
+/////////////////
+
+template<typename MatrixType>
+size_t triangle_count(const MatrixType& G)
+{
+    CUSP_PROFILE_SCOPED();
+
+    typedef typename MatrixType::index_type   IndexType;
+    typedef typename MatrixType::value_type   ValueType;
+    typedef typename MatrixType::memory_space MemorySpace;
+
+    if(G.num_rows != G.num_cols)
+        throw cusp::invalid_input_exception("matrix must be square");
+
+    cusp::coo_matrix<IndexType,ValueType,MemorySpace> A(G);
+
+    // L <- strictly lower triangle of G with unit values
+    const size_t num_entries =
+        thrust::count_if(thrust::make_zip_iterator(thrust::make_tuple(A.row_indices.begin(), A.column_indices.begin())),
+                         thrust::make_zip_iterator(thrust::make_tuple(A.row_indices.end(),   A.column_indices.end())),
+                         detail::is_strictly_lower());
+
+    cusp::coo_matrix<IndexType,IndexType,MemorySpace> L(A.num_rows, A.num_cols, num_entries);
+
+    thrust::copy_if(thrust::make_zip_iterator(thrust::make_tuple(A.row_indices.begin(), A.column_indices.begin())),
+                    thrust::make_zip_iterator(thrust::make_tuple(A.row_indices.end(),   A.column_indices.end())),
+                    thrust::make_zip_iterator(thrust::make_tuple(L.row_indices.begin(), L.column_indices.begin())),
+                    detail::is_strictly_lower());
+    thrust::fill(L.values.begin(), L.values.end(), IndexType(1));
+
+    // the masked product needs sorted columns
+    L.sort_by_row_and_column();
+
+    cusp::csr_matrix<IndexType,IndexType,MemorySpace> L_csr(L);
+    cusp::csr_matrix<IndexType,IndexType,MemorySpace> C;
+
+    cusp::masked_product(L_csr, L_csr, L_csr, C);
+
+    return thrust::reduce(C.values.begin(), C.values.end(), size_t(0));
+}
+
+} // end namespace graph
+} // end namespace cusp
@@ -0,0 +1,557 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include <cusp/array1d.h>
+#include <cusp/csr_matrix.h>
+#include <cusp/exception.h>
+#include <cusp/detail/random.h>
+
+#include <thrust/adjacent_difference.h>
+#include <thrust/binary_search.h>
+#include <thrust/copy.h>
+#include <thrust/count.h>
+#include <thrust/fill.h>
+#include <thrust/functional.h>
+#include <thrust/gather.h>
+#include <thrust/reduce.h>
+#include <thrust/scan.h>
+#include <thrust/scatter.h>
+#include <thrust/sort.h>
+#include <thrust/transform.h>
+#include <thrust/iterator/constant_iterator.h>
+#include <thrust/iterator/counting_iterator.h>
+#include <thrust/iterator/permutation_iterator.h>
+#include <thrust/iterator/zip_iterator.h>
+
+#include <vector>
+
+namespace cusp
+{
+namespace graph
+{
+namespace detail
+{
+
+// an uncolored vertex takes the color of the round when its priority is
+// above those of all its uncolored neighbors, and the next color when it
+// is below all of them
+template <typename IndexType>
+struct vertex_coloring_round
+{
+    const IndexType * row_offsets;
+    const IndexType * column_indices;
+    const IndexType * colors;
+    IndexType color;
+    cusp::detail::detail::random_integer_functor<IndexType,unsigned int> hash;
+
+    vertex_coloring_round(const IndexType * row_offsets, const IndexType * column_indices,
+                          const IndexType * colors, IndexType color, size_t seed)
+        : row_offsets(row_offsets), column_indices(column_indices), colors(colors), color(color), hash(seed) {}
+
+    __host__ __device__
+    IndexType operator()(const IndexType v) const
+    {
+        if(colors[v] != IndexType(-1))
+            return colors[v];
+
+        const unsigned int hv = hash(v);
+
+        bool is_max = true;
+        bool is_min = true;
+
+        for(IndexType jj = row_offsets[v]; jj < row_offsets[v + 1]; jj++)
+        {
+            const IndexType w = column_indices[jj];
+
+            if(w == v || colors[w] != IndexType(-1))
+                continue;
+
+            const unsigned int hw = hash(w);
+
+            if(hw > hv || (hw == hv && w > v))
+                is_max = false;
+            else
+                is_min = false;
+        }
+
+        if(is_max)
+            return color;
+        else if(is_min)
+            return color + 1;
+        else
+            return IndexType(-1);
+    }
+};
+
+// the priority of a vertex with the vertex itself breaking ties
+template <typename IndexType>
+__host__ __device__
+unsigned long long coloring_priority(const cusp::detail::detail::random_integer_functor<IndexType,unsigned int>& hash,
+                                     const IndexType v)
+{
+    return (static_cast<unsigned long long>(hash(v)) << 32) | static_cast<unsigned int>(v);
+}
+
+// op of x over a vertex and its neighbors
+template <typename IndexType, typename T, typename BinaryFunction>
+struct neighborhood_reduce
+{
+    const IndexType * row_offsets;
+    const IndexType * column_indices;
+    const T * x;
+    BinaryFunction op;
+
+    neighborhood_reduce(const IndexType * row_offsets, const IndexType * column_indices,
+                        const T * x, BinaryFunction op)
+        : row_offsets(row_offsets), column_indices(column_indices), x(x), op(op) {}
+
+    __host__ __device__
+    T operator()(const IndexType v) const
+    {
+        T result = x[v];
+
+        for(IndexType jj = row_offsets[v]; jj < row_offsets[v + 1]; jj++)
+            result = op(result, x[column_indices[jj]]);
+
+        return result;
+    }
+};
+
+// x[v] <- op of x over the vertices within distance k of v
+template <typename MatrixType, typename ArrayType, typename BinaryFunction>
+void reduce_within_distance(const MatrixType& A, ArrayType& x, ArrayType& temp, const size_t k, BinaryFunction op)
+{
+    typedef typename MatrixType::index_type   IndexType;
+    typedef typename MatrixType::memory_space MemorySpace;
+    typedef typename ArrayType::value_type    T;
+    typedef thrust::counting_iterator<IndexType,MemorySpace> CountingIterator;
+
+    for(size_t i = 0; i < k; i++)
+    {
+        thrust::transform(CountingIterator(0), CountingIterator(A.num_rows), temp.begin(),
+                          neighborhood_reduce<IndexType,T,BinaryFunction>(thrust::raw_pointer_cast(A.row_offsets.data()),
+                                                                          thrust::raw_pointer_cast(A.column_indices.data()),
+                                                                          thrust::raw_pointer_cast(x.data()), op));
+        x.swap(temp);
+    }
+}
+
+// priority of the uncolored vertices, empty for the colored ones
+template <typename IndexType>
+struct uncolored_priority
+{
+    const IndexType * colors;
+    unsigned long long empty;
+    cusp::detail::detail::random_integer_functor<IndexType,unsigned int> hash;
+
+    uncolored_priority(const IndexType * colors, unsigned long long empty, size_t seed)
+        : colors(colors), empty(empty), hash(seed) {}
+
+    __host__ __device__
+    unsigned long long operator()(const IndexType v) const
+    {
+        return colors[v] == IndexType(-1) ? coloring_priority(hash, v) : empty;
+    }
+};
+
+// an uncolored vertex takes the color of the round when its priority is
+// the largest within distance k, and the next color when it is the
+// smallest
+template <typename IndexType>
+struct distance_coloring_round
+{
+    const IndexType * colors;
+    const unsigned long long * max_priority;
+    const unsigned long long * min_priority;
+    IndexType color;
+    cusp::detail::detail::random_integer_functor<IndexType,unsigned int> hash;
+
+    distance_coloring_round(const IndexType * colors, const unsigned long long * max_priority,
+                            const unsigned long long * min_priority, IndexType color, size_t seed)
+        : colors(colors), max_priority(max_priority), min_priority(min_priority), color(color), hash(seed) {}
+
+    __host__ __device__
+    IndexType operator()(const IndexType v) const
+    {
+        if(colors[v] != IndexType(-1))
+            return colors[v];
+
+        const unsigned long long p = coloring_priority(hash, v);
+
+        if(max_priority[v] == p)
+            return color;
+        else if(min_priority[v] == p)
+            return color + 1;
+        else
+            return IndexType(-1);
+    }
+};
+
+// vertices which may move to the target color: their color has more
+// vertices than the target size and no vertex within distance k has the
+// target color
+template <typename IndexType>
+struct balancing_candidate
+{
+    const IndexType * colors;
+    const IndexType * near_target;
+    const IndexType * surplus;
+
+    balancing_candidate(const IndexType * colors, const IndexType * near_target, const IndexType * surplus)
+        : colors(colors), near_target(near_target), surplus(surplus) {}
+
+    __host__ __device__
+    bool operator()(const IndexType v) const
+    {
+        return near_target[v] == 0 && surplus[colors[v]] > 0;
+    }
+};
+
+template <typename IndexType>
+struct candidate_priority
+{
+    balancing_candidate<IndexType> candidate;
+    cusp::detail::detail::random_integer_functor<IndexType,unsigned int> hash;
+
+    candidate_priority(const balancing_candidate<IndexType>& candidate, size_t seed)
+        : candidate(candidate), hash(seed) {}
+
+    __host__ __device__
+    unsigned long long operator()(const IndexType v) const
+    {
+        return candidate(v) ? coloring_priority(hash, v) : 0ull;
+    }
+};
+
+// candidates whose priority is the largest of the candidates within
+// distance k, so no two of them are within distance k of each other
+template <typename IndexType>
+struct selected_candidate
+{
+    balancing_candidate<IndexType> candidate;
+    const unsigned long long * max_priority;
+    cusp::detail::detail::random_integer_functor<IndexType,unsigned int> hash;
+
+    selected_candidate(const balancing_candidate<IndexType>& candidate,
+                       const unsigned long long * max_priority, size_t seed)
+        : candidate(candidate), max_priority(max_priority), hash(seed) {}
+
+    __host__ __device__
+    bool operator()(const IndexType v) const
+    {
+        return candidate(v) && max_priority[v] == coloring_priority(hash, v);
+    }
+};
+
+template <typename IndexType>
+struct is_color
+{
+    IndexType color;
+
+    is_color(IndexType color) : color(color) {}
+
+    __host__ __device__
+    IndexType operator()(const IndexType c) const
+    {
+        return c == color ? IndexType(1) : IndexType(0);
+    }
+};
+
+template <typename IndexType>
+struct rank_below
+{
+    template <typename Tuple>
+    __host__ __device__
+    IndexType operator()(const Tuple& t) const
+    {
+        return thrust::get<0>(t) < thrust::get<1>(t) ? IndexType(1) : IndexType(0);
+    }
+};
+
+// colors numbered consecutively in the order of their first use
+template <typename ArrayType>
+size_t renumber_colors(ArrayType& colors, const typename ArrayType::value_type max_color)
+{
+    typedef typename ArrayType::value_type   IndexType;
+    typedef typename ArrayType::memory_space MemorySpace;
+
+    cusp::array1d<IndexType,MemorySpace> renumber(max_color + 1, IndexType(0));
+    thrust::scatter(thrust::constant_iterator<IndexType>(1), thrust::constant_iterator<IndexType>(1) + colors.size(),
+                    colors.begin(), renumber.begin());
+    thrust::exclusive_scan(renumber.begin(), renumber.end(), renumber.begin());
+
+    ArrayType renumbered(colors.size());
+    thrust::gather(colors.begin(), colors.end(), renumber.begin(), renumbered.begin());
+    colors.swap(renumbered);
+
+    return renumber[max_color];
+}
+
+// passes over each target color when balancing
+const size_t COLOR_BALANCING_PASSES = 8;
+
+// Moves vertices from colors larger than ceil(N / num_colors) to the
+// smaller colors.  Each pass over a target color picks the candidates
+// which are the largest within distance k of the other candidates, so
+// the movers can share the color, and keeps as many of them as the target
+// is short of, taking no more from a color than it has in excess.
+template <typename MatrixType, typename ArrayType>
+void balance_colors(const MatrixType& A, ArrayType& colors, const size_t num_colors, const size_t k)
+{
+    typedef typename MatrixType::index_type   IndexType;
+    typedef typename MatrixType::memory_space MemorySpace;
+    typedef thrust::counting_iterator<IndexType,MemorySpace> CountingIterator;
+
+    const size_t N = A.num_rows;
+
+    if(num_colors < 2)
+        return;
+
+    const IndexType target = (N + num_colors - 1) / num_colors;
+
+    // size of each color
+    std::vector<IndexType> sizes(num_colors);
+    {
+        ArrayType sorted(colors);
+        thrust::sort(sorted.begin(), sorted.end());
+
+        cusp::array1d<IndexType,MemorySpace> ends(num_colors);
+        thrust::upper_bound(sorted.begin(), sorted.end(),
+                            CountingIterator(0), CountingIterator(num_colors), ends.begin());
+        thrust::adjacent_difference(ends.begin(), ends.end(), ends.begin());
+
+        cusp::array1d<IndexType,cusp::host_memory> ends_h(ends);
+        thrust::copy(ends_h.begin(), ends_h.end(), sizes.begin());
+    }
+
+    cusp::array1d<IndexType,MemorySpace> near_target(N);
+    cusp::array1d<IndexType,MemorySpace> temp(N);
+    cusp::array1d<unsigned long long,MemorySpace> priority(N);
+    cusp::array1d<unsigned long long,MemorySpace> priority_temp(N);
+
+    cusp::array1d<IndexType,cusp::host_memory> surplus_h(num_colors);
+    cusp::array1d<IndexType,MemorySpace> surplus(num_colors);
+
+    for(size_t c = 0; c < num_colors; c++)
+    {
+        for(size_t pass = 0; pass < COLOR_BALANCING_PASSES && sizes[c] < target; pass++)
+        {
+            IndexType total_surplus = 0;
+            for(size_t s = 0; s < num_colors; s++)
+            {
+                surplus_h[s] = sizes[s] > target ? sizes[s] - target : IndexType(0);
+                total_surplus += surplus_h[s];
+            }
+
+            if(total_surplus == 0)
+                return;
+
+            surplus = surplus_h;
+
+            // vertices within distance k of the target color
+            thrust::transform(colors.begin(), colors.end(), near_target.begin(), is_color<IndexType>(c));
+            reduce_within_distance(A, near_target, temp, k, thrust::maximum<IndexType>());
+
+            balancing_candidate<IndexType> candidate(thrust::raw_pointer_cast(colors.data()),
+                                                     thrust::raw_pointer_cast(near_target.data()),
+                                                     thrust::raw_pointer_cast(surplus.data()));
+
+            const size_t seed = c * COLOR_BALANCING_PASSES + pass + 1;
+
+            thrust::transform(CountingIterator(0), CountingIterator(N), priority.begin(),
+                              candidate_priority<IndexType>(candidate, seed));
+            reduce_within_distance(A, priority, priority_temp, k, thrust::maximum<unsigned long long>());
+
+            cusp::array1d<IndexType,MemorySpace> movers(N);
+            const size_t num_movers =
+                thrust::copy_if(CountingIterator(0), CountingIterator(N), movers.begin(),
+                                selected_candidate<IndexType>(candidate, thrust::raw_pointer_cast(priority.data()), seed))
+                - movers.begin();
+
+            if(num_movers == 0)
+                break;
+
+            movers.resize(num_movers);
+
+            // group the movers by their color, keeping the first of each
+            // color up to its surplus and then the first up to the deficit
+            cusp::array1d<IndexType,MemorySpace> sources(num_movers);
+            thrust::gather(movers.begin(), movers.end(), colors.begin(), sources.begin());
+            thrust::stable_sort_by_key(sources.begin(), sources.end(), movers.begin());
+
+            cusp::array1d<IndexType,MemorySpace> rank(num_movers);
+            cusp::array1d<IndexType,MemorySpace> accept(num_movers);
+            thrust::exclusive_scan_by_key(sources.begin(), sources.end(),
+                                          thrust::constant_iterator<IndexType>(1), rank.begin());
+            thrust::transform(thrust::make_zip_iterator(thrust::make_tuple(rank.begin(),
+                                                        thrust::make_permutation_iterator(surplus.begin(), sources.begin()))),
+                              thrust::make_zip_iterator(thrust::make_tuple(rank.end(),
+                                                        thrust::make_permutation_iterator(surplus.begin(), sources.end()))),
+                              accept.begin(), rank_below<IndexType>());
+
+            thrust::exclusive_scan(accept.begin(), accept.end(), rank.begin());
+            thrust::transform(thrust::make_zip_iterator(thrust::make_tuple(rank.begin(),
+                                                        thrust::make_constant_iterator(target - sizes[c]))),
+                              thrust::make_zip_iterator(thrust::make_tuple(rank.end(),
+                                                        thrust::make_constant_iterator(target - sizes[c]))),
+                              temp.begin(), rank_below<IndexType>());
+            thrust::transform(accept.begin(), accept.end(), temp.begin(), accept.begin(), thrust::multiplies<IndexType>());
+
+            thrust::scatter_if(thrust::constant_iterator<IndexType>(c), thrust::constant_iterator<IndexType>(c) + num_movers,
+                               movers.begin(), accept.begin(), colors.begin());
+
+            // update the sizes from the number moved out of each color
+            cusp::array1d<IndexType,MemorySpace> moved_colors(num_movers);
+            cusp::array1d<IndexType,MemorySpace> moved_counts(num_movers);
+            const size_t num_moved_colors =
+                thrust::reduce_by_key(sources.begin(), sources.end(), accept.begin(),
+                                      moved_colors.begin(), moved_counts.begin()).first - moved_colors.begin();
+
+            cusp::array1d<IndexType,cusp::host_memory> moved_colors_h(moved_colors.begin(), moved_colors.begin() + num_moved_colors);
+            cusp::array1d<IndexType,cusp::host_memory> moved_counts_h(moved_counts.begin(), moved_counts.begin() + num_moved_colors);
+
+            IndexType num_moved = 0;
+            for(size_t i = 0; i < num_moved_colors; i++)
+            {
+                sizes[moved_colors_h[i]] -= moved_counts_h[i];
+                num_moved += moved_counts_h[i];
+            }
+            sizes[c] += num_moved;
+
+            if(num_moved == 0)
+                break;
+        }
+    }
+}
+
+} // end namespace detail
+
+/////////////////
+// Entry Point //
+/////////////////
+
+template <typename Matrix, typename Array>
+size_t vertex_coloring(const Matrix& G, Array& colors)
+{
+    CUSP_PROFILE_SCOPED();
+
+    typedef typename Matrix::index_type   IndexType;
+    typedef typename Matrix::value_type   ValueType;
+    typedef typename Matrix::memory_space MemorySpace;
+    typedef thrust::counting_iterator<IndexType,MemorySpace> CountingIterator;
+
+    if(G.num_rows != G.num_cols)
+        throw cusp::invalid_input_exception("matrix must be square");
+
+    const size_t N = G.num_rows;
+
+    cusp::csr_matrix<IndexType,ValueType,MemorySpace> A(G);
+
+    cusp::array1d<IndexType,MemorySpace> current(N, IndexType(-1));
+    cusp::array1d<IndexType,MemorySpace> updated(N);
+
+    IndexType color = 0;
+
+    while(thrust::count(current.begin(), current.end(), IndexType(-1)) > 0)
+    {
+        thrust::transform(CountingIterator(0), CountingIterator(N), updated.begin(),
+                          detail::vertex_coloring_round<IndexType>(thrust::raw_pointer_cast(A.row_offsets.data()),
+                                                                   thrust::raw_pointer_cast(A.column_indices.data()),
+                                                                   thrust::raw_pointer_cast(current.data()),
+                                                                   color, 0));
+        current.swap(updated);
+        color += 2;
+    }
+
+    const size_t num_colors = detail::renumber_colors(current, color);
+
+    colors = current;
+
+    return num_colors;
+}
+
+template <typename Matrix, typename Array>
+size_t color(const Matrix& G, Array& colors, size_t k, bool balance)
+{
+    CUSP_PROFILE_SCOPED();
+
+    typedef typename Matrix::index_type   IndexType;
+    typedef typename Matrix::value_type   ValueType;
+    typedef typename Matrix::memory_space MemorySpace;
+    typedef thrust::counting_iterator<IndexType,MemorySpace> CountingIterator;
+
+    if(G.num_rows != G.num_cols)
+        throw cusp::invalid_input_exception("matrix must be square");
+
+    const size_t N = G.num_rows;
+
+    colors.resize(N);
+
+    if(N == 0)
+        return 0;
+
+    // every vertex may share a color at distance 0
+    if(k == 0)
+    {
+        thrust::fill(colors.begin(), colors.end(), typename Array::value_type(0));
+        return 1;
+    }
+
+    cusp::csr_matrix<IndexType,ValueType,MemorySpace> A(G);
+
+    cusp::array1d<IndexType,MemorySpace> current(N, IndexType(-1));
+    cusp::array1d<IndexType,MemorySpace> updated(N);
+
+    cusp::array1d<unsigned long long,MemorySpace> max_priority(N);
+    cusp::array1d<unsigned long long,MemorySpace> min_priority(N);
+    cusp::array1d<unsigned long long,MemorySpace> temp(N);
+
+    IndexType color = 0;
+
+    while(thrust::count(current.begin(), current.end(), IndexType(-1)) > 0)
+    {
+        const IndexType * current_ptr = thrust::raw_pointer_cast(current.data());
+
+        thrust::transform(CountingIterator(0), CountingIterator(N), max_priority.begin(),
+                          detail::uncolored_priority<IndexType>(current_ptr, 0ull, 0));
+        thrust::transform(CountingIterator(0), CountingIterator(N), min_priority.begin(),
+                          detail::uncolored_priority<IndexType>(current_ptr, ~0ull, 0));
+
+        detail::reduce_within_distance(A, max_priority, temp, k, thrust::maximum<unsigned long long>());
+        detail::reduce_within_distance(A, min_priority, temp, k, thrust::minimum<unsigned long long>());
+
+        thrust::transform(CountingIterator(0), CountingIterator(N), updated.begin(),
+                          detail::distance_coloring_round<IndexType>(current_ptr,
+                                                                     thrust::raw_pointer_cast(max_priority.data()),
+                                                                     thrust::raw_pointer_cast(min_priority.data()),
+                                                                     color, 0));
+        current.swap(updated);
+        color += 2;
+    }
+
+    const size_t num_colors = detail::renumber_colors(current, color);
+
+    if(balance)
+        detail::balance_colors(A, current, num_colors, k);
+
+    colors = current;
+
+    return num_colors;
+}
+
+} // end namespace graph
+} // end namespace cusp
+
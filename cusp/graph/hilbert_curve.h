@@ -22,6 +22,8 @@
 
 #include <cusp/detail/config.h>
 
+#include <cusp/distributed_array1d.h>
+
 namespace cusp
 {
 namespace graph
@@ -31,6 +33,86 @@ namespace graph
  *  \{
  */
 
+/*! Space filling curves which order points of the unit square or cube.
+ */
+enum space_filling_curve
+{
+    HILBERT_CURVE, /*!< Hilbert curve; consecutive points are neighbours */
+    MORTON_CURVE   /*!< Morton (Z-order) curve; cheaper keys with jumps between quadrants */
+};
+
+/*! \p space_filling_curve_keys : Computes the position of every point
+ * along a space filling curve as a 64-bit integer key.
+ *
+ * Each coordinate is quantized to 32 bits in 2D and to 21 bits in 3D, so
+ * the 2D keys use all 64 bits and the 3D keys the low 63 bits.  The keys
+ * can be computed once and reused by \p space_filling_curve_ordering,
+ * \p space_filling_curve_partition and
+ * \p space_filling_curve_distribution.
+ *
+ * \param coord Set of points in 2 or 3-D space, in the range [0,1]
+ * \param keys key of each point, e.g. an
+ *        <tt>array1d<unsigned long long, MemorySpace></tt>
+ * \param curve \c HILBERT_CURVE or \c MORTON_CURVE
+ *
+ * \throws cusp::invalid_input_exception if the points are not in 2 or 3
+ *         dimensions or lie outside of [0,1].
+ */
+template <class Array2d, class Array1d>
+void space_filling_curve_keys(const Array2d& coord, Array1d& keys,
+                              const space_filling_curve curve = HILBERT_CURVE);
+
+/*! \p space_filling_curve_ordering : Orders points by their keys.  Points
+ * with equal keys keep their relative order, so the ordering is
+ * deterministic.
+ *
+ * \param keys key of each point
+ * \param permutation point \c i of the ordering is point \c permutation[i]
+ *
+ * \note \p permutation must be in the memory space of \p keys.
+ */
+template <class KeyArray, class Array1d>
+void space_filling_curve_ordering(const KeyArray& keys, Array1d& permutation);
+
+/*! \p space_filling_curve_partition : Splits the points ordered by their
+ * keys into \p num_parts parts of consecutive points whose sizes differ
+ * by at most one.
+ *
+ * \param keys key of each point
+ * \param num_parts number of partitions to construct
+ * \param parts partition assigned to each point
+ */
+template <class KeyArray, class Array1d>
+void space_filling_curve_partition(const KeyArray& keys, const size_t num_parts, Array1d& parts);
+
+/*! \p space_filling_curve_distribution : Assigns the points ordered by
+ * their keys to the parts of a \p distributed_layout.  Part \c p receives
+ * the points at positions <tt>[layout.offsets[p], layout.offsets[p+1])</tt>
+ * along the curve, and each point is numbered by its position within its
+ * part.
+ *
+ * A matrix whose rows are renumbered by
+ * <tt>layout.offsets[parts[i]] + local_indices[i]</tt>, which is the
+ * position along the curve, can be passed to \p distributed_matrix with
+ * \p layout so that every part holds a compact region of space.
+ *
+ * \param keys key of each point
+ * \param layout partition of the points
+ * \param parts part of each point
+ * \param local_indices index of each point within its part
+ *
+ * \throws cusp::invalid_input_exception if the size of \p layout differs
+ *         from the number of points.
+ *
+ * \note Only the part offsets are copied from the host; the points stay
+ *       in the memory space of \p keys.
+ */
+template <class KeyArray, class Array1d1, class Array1d2>
+void space_filling_curve_distribution(const KeyArray& keys,
+                                      const cusp::distributed_layout& layout,
+                                      Array1d1& parts,
+                                      Array1d2& local_indices);
+
 /*! \p hilbert_curve : Uses a Hilbert space filling curve to partition
  * a set of points in 2 or 3 dimensional space.
  *
@@ -39,6 +121,10 @@ namespace graph
  * \param number of partitions to construct
  * \param partition assigned to each point
  *
+ * \note With \p num_parts equal to the number of points each point is
+ *       assigned its position along the curve.
+ * \note The sizes of the parts differ by at most one.
+ *
  * \tparam Array coord
  * \tparam size_t num_parts
  * \tparam Array parts
@@ -48,6 +134,21 @@ namespace graph
 template <class Array2d, class Array1d>
 void hilbert_curve(const Array2d& coord, const size_t num_parts, Array1d& parts);
 
+/*! \p hilbert_curve_ordering : Orders a set of points in 2 or 3 dimensional
+ * space along a Hilbert space filling curve, so that points close in space
+ * receive nearby indices.
+ *
+ * \param Set of points in 2 or 3-D space
+ * \param permutation point \c i of the ordering is point \c permutation[i]
+ *
+ * \tparam Array coord
+ * \tparam Array permutation
+ *
+ * \note \p permutation must be in the memory space of \p coord.
+ */
+template <class Array2d, class Array1d>
+void hilbert_curve_ordering(const Array2d& coord, Array1d& permutation);
+
 /*! \}
  */
 
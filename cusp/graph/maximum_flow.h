@@ -34,9 +34,20 @@ namespace graph
 /*! \p maximum_flow : Performs a maximum flow computation on a flow network
  * starting from a given source vertex to a given sink vertex.
  *
- * \param A matrix that represents a flow network
- * \param source vertex
- * \param sink vertex
+ * Both memory spaces use push-relabel.  On the host vertices are discharged
+ * one at a time from a FIFO queue, while on the device every active vertex
+ * pushes and relabels in synchronous rounds, with periodic global
+ * relabels that reset the heights to the BFS distances in the residual
+ * graph.  The device solver gives each entry (i,j) a reverse residual
+ * edge, so the pattern need not be symmetric, while the host solver
+ * expects the entry (j,i) to be present.  The graph may not contain
+ * duplicate entries.
+ *
+ * \param G matrix that represents a flow network, the values being the
+ * capacities of the edges
+ * \param flow flow on each entry of G
+ * \param src source vertex
+ * \param sink sink vertex
  *
  * \tparam Matrix matrix
  *
@@ -50,9 +61,63 @@ template<typename MatrixType, typename ArrayType, typename IndexType>
 typename MatrixType::value_type
 maximum_flow(const MatrixType& G, ArrayType& flow, const IndexType src, const IndexType sink);
 
+/*! \p maximum_preflow : Computes a maximum preflow, the first phase of
+ * push-relabel, and returns the value of the maximum flow.
+ *
+ * The preflow carries the maximum flow into the sink but may leave excess
+ * on vertices which cannot reach it; returning that excess to the source
+ * is the second phase, which \p maximum_flow also runs.  When only the
+ * flow value or a minimum cut is needed the second phase can be skipped
+ * and the cut taken from the preflow with \p max_flow_to_min_cut.  The
+ * host solver always completes the flow.
+ *
+ * \param G matrix that represents a flow network
+ * \param flow preflow on each entry of G
+ * \param src source vertex
+ * \param sink sink vertex
+ */
+template<typename MatrixType, typename ArrayType, typename IndexType>
+typename MatrixType::value_type
+maximum_preflow(const MatrixType& G, ArrayType& flow, const IndexType src, const IndexType sink);
+
+/*! \p max_flow_to_min_cut : Marks the edges of a minimum cut given a maximum flow,
+ * using the vertices reachable from the source in the residual graph.
+ *
+ * \return number of edges in the cut
+ */
 template<typename MatrixType, typename ArrayType1, typename ArrayType2, typename IndexType>
 size_t max_flow_to_min_cut(const MatrixType& G, const ArrayType1& flow, const IndexType src, ArrayType2& min_cut_edges);
 
+/*! \p max_flow_to_min_cut : Marks the edges of a minimum cut given a maximum
+ * flow or a maximum preflow.
+ *
+ * The sink side of the cut is the set of vertices which reach the sink in
+ * the residual graph, found by a BFS from the sink on the reversed
+ * residual edges, and \p min_cut_edges is 1 on each edge of positive
+ * capacity from the other vertices into the sink side.  Unlike the
+ * source side, the sink side does not depend on the excess a preflow
+ * leaves behind.
+ *
+ * \param G matrix that represents a flow network
+ * \param flow maximum flow or preflow on each entry of G
+ * \param src source vertex
+ * \param sink sink vertex
+ * \param min_cut_edges 1 for the edges of the cut and 0 otherwise
+ *
+ * \return number of edges in the cut
+ *
+ *  \code
+ *  cusp::array1d<int,cusp::device_memory> flow(G.num_entries);
+ *  cusp::array1d<int,cusp::device_memory> cut(G.num_entries);
+ *
+ *  int value = cusp::graph::maximum_preflow(G, flow, src, sink);
+ *  cusp::graph::max_flow_to_min_cut(G, flow, src, sink, cut);
+ *  \endcode
+ */
+template<typename MatrixType, typename ArrayType1, typename ArrayType2, typename IndexType>
+size_t max_flow_to_min_cut(const MatrixType& G, const ArrayType1& flow, const IndexType src, const IndexType sink,
+                           ArrayType2& min_cut_edges);
+
 /*! \}
  */
 
@@ -0,0 +1,120 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+/*! \file pagerank.h
+ *  \brief PageRank and personalized PageRank of a directed graph
+ */
+
+#pragma once
+
+#include <cusp/detail/config.h>
+
+#include <cstddef>
+
+namespace cusp
+{
+namespace graph
+{
+/*! \addtogroup algorithms Algorithms
+ *  \ingroup algorithms
+ *  \{
+ */
+
+/*! \p pagerank : Computes the PageRank of every vertex of a directed graph.
+ *
+ * The ranks are the stationary distribution of a random surfer who follows
+ * an edge out of its vertex, chosen uniformly, with probability \p damping
+ * and otherwise jumps to a uniformly chosen vertex.  The surfer at a
+ * vertex without edges (a dangling vertex) always jumps.
+ *
+ * The column-stochastic matrix of the surfer is never formed: the power
+ * iteration reads the pattern of the transpose of \p G and scales the
+ * ranks by the inverse out-degrees as it gathers them.  Each iteration is
+ * a single pass over the graph which computes the new ranks, adds the
+ * jump probabilities and reduces the L1 change of the ranks, plus a
+ * reduction over the dangling vertices only.
+ *
+ * \param G matrix whose entry <tt>(i,j)</tt> is an edge from vertex \c i
+ *        to vertex \c j; its values are ignored
+ * \param ranks rank of each vertex, summing to one; resized to the number
+ *        of vertices
+ * \param damping probability of following an edge, in <tt>[0,1)</tt>
+ * \param tolerance bound on the L1 change of the ranks at which the
+ *        iteration stops
+ * \param max_iterations maximum number of iterations
+ *
+ * \tparam MatrixType matrix
+ * \tparam ArrayType array1d
+ *
+ * \return number of iterations performed
+ *
+ * \throws cusp::invalid_input_exception if \p G is not square or \p damping
+ *         is not in <tt>[0,1)</tt>.
+ *
+ *  \see http://en.wikipedia.org/wiki/PageRank
+ */
+template<typename MatrixType, typename ArrayType>
+size_t pagerank(const MatrixType& G, ArrayType& ranks,
+                const double damping = 0.85, const double tolerance = 1e-6,
+                const size_t max_iterations = 100);
+
+/*! \p personalized_pagerank : Computes the PageRank of every vertex of a
+ * directed graph when the surfer jumps to the vertices in proportion to a
+ * personalization vector.
+ *
+ * Jumps from the dangling vertices follow the personalization as well.
+ * With an \p array2d of personalization vectors, one per column, the
+ * rankings are computed together: every iteration gathers the ranks of
+ * all columns from one row of the graph, as in a sparse matrix-dense
+ * matrix product, and stops once the L1 changes of all columns sum to
+ * less than \p tolerance.
+ *
+ * \param G matrix whose entry <tt>(i,j)</tt> is an edge from vertex \c i
+ *        to vertex \c j; its values are ignored
+ * \param personalization non-negative weight of each vertex as the target
+ *        of a jump, an \p array1d or the columns of an \p array2d; each
+ *        vector is normalized to sum to one
+ * \param ranks rank of each vertex, with the shape of \p personalization
+ * \param damping probability of following an edge, in <tt>[0,1)</tt>
+ * \param tolerance bound on the L1 change of the ranks at which the
+ *        iteration stops
+ * \param max_iterations maximum number of iterations
+ *
+ * \tparam MatrixType matrix
+ * \tparam ArrayType1 array1d or array2d
+ * \tparam ArrayType2 array1d or array2d
+ *
+ * \return number of iterations performed
+ *
+ * \throws cusp::invalid_input_exception if \p G is not square, \p damping
+ *         is not in <tt>[0,1)</tt>, or \p personalization does not have
+ *         one row per vertex, has a negative weight or a column summing
+ *         to zero.
+ */
+template<typename MatrixType, typename ArrayType1, typename ArrayType2>
+size_t personalized_pagerank(const MatrixType& G, const ArrayType1& personalization, ArrayType2& ranks,
+                             const double damping = 0.85, const double tolerance = 1e-6,
+                             const size_t max_iterations = 100);
+
+/*! \}
+ */
+
+
+} // end namespace graph
+} // end namespace cusp
+
+#include <cusp/graph/detail/pagerank.inl>
@@ -0,0 +1,76 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+/*! \file partition.h
+ *  \brief Multilevel k-way partitioning of a graph
+ */
+
+#pragma once
+
+#include <cusp/detail/config.h>
+
+#include <cstddef>
+
+namespace cusp
+{
+namespace graph
+{
+/*! \addtogroup algorithms Algorithms
+ *  \ingroup algorithms
+ *  \{
+ */
+
+/*! \p partition : Partitions the vertices of a graph into balanced parts
+ * with few edges between them, for graphs without coordinates.
+ *
+ * The graph is coarsened by repeatedly contracting a heavy-edge matching,
+ * which is computed in parallel by letting every vertex propose to the
+ * neighbor across its heaviest edge and matching mutual proposals.  The
+ * coarsest graph is split into bands of equal weight along its reverse
+ * Cuthill-McKee ordering.  The partition is then projected back through
+ * the levels and refined at each one by moving boundary vertices to the
+ * neighboring part they are most connected to, subject to the balance
+ * constraint, and any surplus the coarse vertex weights left in heavy
+ * parts is dealt out to the light parts on the finest level.  All steps run in the memory space of the graph except the
+ * ordering of the coarsest graph, which is small.
+ *
+ * \param G symmetric matrix that represents a graph
+ * \param num_parts number of parts to construct
+ * \param parts part assigned to each vertex
+ * \param imbalance allowed relative excess of the weight of a part over
+ *        the average (default 0.03)
+ *
+ * \return number of edges between vertices of different parts
+ *
+ * \tparam Matrix matrix
+ * \tparam Array array
+ *
+ * \note The values of \p G are ignored and every edge has unit weight.
+ *
+ *  \see http://en.wikipedia.org/wiki/Graph_partition
+ */
+template<typename MatrixType, typename ArrayType>
+size_t partition(const MatrixType& G, const size_t num_parts, ArrayType& parts, const float imbalance = 0.03f);
+
+/*! \}
+ */
+
+
+} // end namespace graph
+} // end namespace cusp
+
+#include <cusp/graph/detail/partition.inl>
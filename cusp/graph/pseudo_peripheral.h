@@ -35,6 +35,14 @@ namespace graph
  * a graph. The pseduo-peripheral vertex is the vertex which achieves
  * the diameter of the graph, i.e. achieves the maximum separation distance.
  *
+ * Each iteration evaluates the lowest-valence vertices of the last level
+ * set with a single multi-source breadth-first search and moves to the
+ * one of largest eccentricity, until the eccentricity stops growing.
+ *
+ * The levels are the level structure rooted at the vertex which
+ * \p symmetric_rcm would compute again; callers which order the same graph
+ * several times may keep them and pass them to \p symmetric_rcm.
+ *
  * \param A symmetric matrix that represents a graph
  * \param BFS level set of vertices starting from pseudo-peripheral vertex
  *
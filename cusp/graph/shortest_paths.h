@@ -0,0 +1,95 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+/*! \file shortest_paths.h
+ *  \brief Single-source shortest paths in a weighted graph
+ */
+
+#pragma once
+
+#include <cusp/detail/config.h>
+
+namespace cusp
+{
+namespace graph
+{
+/*! \addtogroup algorithms Algorithms
+ *  \ingroup algorithms
+ *  \{
+ */
+
+/*! \p single_source_shortest_paths : Computes the length of the shortest
+ * path from a source vertex to every vertex of a graph with non-negative
+ * edge weights.
+ *
+ * The paths are found by delta-stepping with two buckets, the near-far
+ * method of Davidson et al.  Vertices whose distance falls below the
+ * current threshold form the near frontier, which is relaxed with a
+ * (min,+) sparse matrix-sparse vector product until no distance below the
+ * threshold improves.  Vertices at or beyond the threshold wait in the far
+ * pile, from which the next near frontier is taken once the threshold
+ * advances by \p delta past the smallest waiting distance.  Each
+ * relaxation only touches the edges of the frontier, and the product
+ * switches between pushing and pulling like \p breadth_first_search.
+ *
+ * A small \p delta relaxes few vertices more than once but needs many
+ * thresholds, a large one approaches Bellman-Ford.  The default is the
+ * mean edge weight.
+ *
+ * \param G matrix whose entry <tt>(i,j)</tt> is the weight of the edge from
+ *        vertex \c i to vertex \c j
+ * \param src vertex to begin the paths
+ * \param distances length of the shortest path to each vertex, or
+ *        <tt>std::numeric_limits<ValueType>::max()</tt> when the vertex is
+ *        unreachable; resized to the number of vertices
+ *
+ * \tparam Matrix matrix
+ * \tparam Array array
+ *
+ * \throws cusp::invalid_input_exception if \p G is not square, \p src is not
+ *         a vertex or an edge weight is negative.
+ *
+ *  \see http://en.wikipedia.org/wiki/Shortest_path_problem
+ */
+template<typename MatrixType, typename ArrayType>
+void single_source_shortest_paths(const MatrixType& G, const typename MatrixType::index_type src,
+                                  ArrayType& distances);
+
+/*! \p single_source_shortest_paths : Computes the length of the shortest
+ * path from a source vertex to every vertex of a graph with non-negative
+ * edge weights, advancing the threshold by \p delta.
+ *
+ * \param G matrix whose entry <tt>(i,j)</tt> is the weight of the edge from
+ *        vertex \c i to vertex \c j
+ * \param src vertex to begin the paths
+ * \param distances length of the shortest path to each vertex
+ * \param delta positive width of the buckets
+ *
+ * \throws cusp::invalid_input_exception if \p delta is not positive.
+ */
+template<typename MatrixType, typename ArrayType>
+void single_source_shortest_paths(const MatrixType& G, const typename MatrixType::index_type src,
+                                  ArrayType& distances, const typename MatrixType::value_type delta);
+
+/*! \}
+ */
+
+
+} // end namespace graph
+} // end namespace cusp
+
+#include <cusp/graph/detail/shortest_paths.inl>
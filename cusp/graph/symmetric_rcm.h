@@ -44,6 +44,54 @@ namespace graph
 template<typename MatrixType>
 void symmetric_rcm(MatrixType& G);
 
+/*! \p symmetric_rcm : Computes the reverse Cuthill-McKee ordering of a
+ * graph represented by a symmetric sparse adjacency matrix without
+ * reordering the matrix.
+ *
+ * The vertices of each BFS level from a pseudo-peripheral vertex are
+ * numbered in parallel by the position of their first numbered neighbor in
+ * the previous level and then by degree, so the work is one sort per level.
+ * Vertices unreachable from the pseudo-peripheral vertex are numbered last,
+ * by degree.
+ *
+ * \param A symmetric matrix that represents a graph
+ * \param permutation row \c i of the reordered matrix is row
+ *        \c permutation[i] of \p G
+ *
+ * \tparam Matrix matrix
+ * \tparam Array array
+ *
+ *  \see http://en.wikipedia.org/wiki/Cuthill-McKee_algorithm
+ */
+template<typename MatrixType, typename ArrayType>
+void symmetric_rcm(const MatrixType& G, ArrayType& permutation);
+
+/*! \p symmetric_rcm : Computes the reverse Cuthill-McKee ordering of a
+ * graph from the BFS levels of a pseudo-peripheral vertex computed
+ * beforehand by \p pseudo_peripheral_vertex, skipping the search for the
+ * vertex, which dominates the cost of the ordering on large graphs.
+ *
+ * \param A symmetric matrix that represents a graph
+ * \param permutation row \c i of the reordered matrix is row
+ *        \c permutation[i] of \p G
+ * \param levels BFS levels from a pseudo-peripheral vertex of \p G, -1 for
+ *        unreachable vertices
+ *
+ * \tparam Matrix matrix
+ * \tparam Array array
+ *
+ *  \code
+ *  cusp::array1d<int,cusp::device_memory> levels(G.num_rows);
+ *  cusp::graph::pseudo_peripheral_vertex(G, levels);
+ *
+ *  // reorder G and graphs with its pattern without searching again
+ *  cusp::array1d<int,cusp::device_memory> permutation;
+ *  cusp::graph::symmetric_rcm(G, permutation, levels);
+ *  \endcode
+ */
+template<typename MatrixType, typename ArrayType1, typename ArrayType2>
+void symmetric_rcm(const MatrixType& G, ArrayType1& permutation, const ArrayType2& levels);
+
 /*! \}
  */
 
@@ -0,0 +1,66 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+/*! \file triangle_count.h
+ *  \brief Number of triangles in an undirected graph
+ */
+
+#pragma once
+
+#include <cusp/detail/config.h>
+
+#include <cstddef>
+
+namespace cusp
+{
+namespace graph
+{
+/*! \addtogroup algorithms Algorithms
+ *  \ingroup algorithms
+ *  \{
+ */
+
+/*! \p triangle_count : Counts the triangles of an undirected graph.
+ *
+ * Each triangle i > k > j is found once as an entry (i,j) of the strictly
+ * lower triangle L of the adjacency matrix reached through k, so the count
+ * is the sum of the values of L * L restricted to the pattern of L.  The
+ * product is computed by \p cusp::masked_product, which never forms the
+ * wedges i > k > j whose ends are not adjacent.
+ *
+ * \param G symmetric matrix whose pattern is the adjacency of the graph;
+ *        its values and diagonal are ignored
+ *
+ * \tparam MatrixType matrix
+ *
+ * \return number of triangles
+ *
+ * \throws cusp::invalid_input_exception if \p G is not square.
+ *
+ *  \see http://en.wikipedia.org/wiki/Triangle_graph
+ */
+template<typename MatrixType>
+size_t triangle_count(const MatrixType& G);
+
+/*! \}
+ */
+
+
+} // end namespace graph
+} // end namespace cusp
+
+#include <cusp/graph/detail/triangle_count.inl>
@@ -0,0 +1,122 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*! \file vertex_coloring.h
+ *  \brief Distance-1 and distance-k coloring of a graph
+ */
+
+#pragma once
+
+#include <cusp/detail/config.h>
+
+#include <cstddef>
+
+namespace cusp
+{
+namespace graph
+{
+/*! \addtogroup algorithms Algorithms
+ *  \ingroup algorithms
+ *  \{
+ */
+
+/*! \p vertex_coloring : computes a distance-1 coloring of a graph, such
+ * that no two adjacent vertices have the same color.
+ *
+ * The coloring is computed in rounds in the memory space of the graph.
+ * As in the computation of a maximal independent set, every vertex has a
+ * random priority, and in each round the uncolored vertices whose priority
+ * is higher (or lower) than that of all their uncolored neighbors form an
+ * independent set, which receives a new color.  Each round therefore adds
+ * two colors.  The colors are renumbered to be consecutive, so
+ * <tt>colors[i]</tt> is in <tt>[0, num_colors)</tt>.
+ *
+ * \param G symmetric matrix that represents a graph
+ * \param colors array to hold the color of each vertex
+ *
+ * \return number of colors
+ *
+ * \tparam Matrix matrix
+ * \tparam Array array
+ *
+ * \note The diagonal entries of \p G are ignored.
+ *
+ *  \see http://en.wikipedia.org/wiki/Graph_coloring
+ */
+template <typename Matrix, typename Array>
+size_t vertex_coloring(const Matrix& G, Array& colors);
+
+/*! \p color : computes a distance-k coloring of a graph, such that no two
+ * vertices joined by a path of \p k edges or less have the same color.
+ *
+ * The rounds are those of \p vertex_coloring with the neighborhoods
+ * widened to radius \p k, as in \p maximal_independent_set: the largest
+ * and smallest priorities of the uncolored vertices within distance
+ * \p k are found by \p k sweeps over the edges, and each round colors
+ * the vertices which hold either.  Paths pass through colored vertices.
+ * A distance-1 coloring gives the independent row blocks of multicolor
+ * Gauss-Seidel, and a distance-2 coloring of a symmetric pattern groups
+ * the columns of a Jacobian which share no row, and so may be estimated
+ * by the same finite difference.
+ *
+ * Colors found by independent sets are unbalanced, the first ones being
+ * much larger than the last.  When \p balance is set, vertices of colors
+ * larger than <tt>ceil(N / num_colors)</tt> move to smaller colors
+ * which no vertex within distance \p k has, one target color at a time
+ * and an independent set of movers at a time, without adding colors.
+ *
+ * \param G symmetric matrix that represents a graph
+ * \param colors array to hold the color of each vertex, in
+ * <tt>[0, num_colors)</tt>
+ * \param k distance of the coloring
+ * \param balance whether to even out the sizes of the colors
+ *
+ * \return number of colors
+ *
+ * \tparam Matrix matrix
+ * \tparam Array array
+ *
+ * \note The diagonal entries of \p G are ignored.
+ *
+ *  \code
+ *  #include <cusp/csr_matrix.h>
+ *  #include <cusp/gallery/poisson.h>
+ *  #include <cusp/graph/vertex_coloring.h>
+ *
+ *  int main(void)
+ *  {
+ *      cusp::csr_matrix<int,float,cusp::device_memory> A;
+ *      cusp::gallery::poisson5pt(A, 100, 100);
+ *
+ *      // columns with the same color share no row
+ *      cusp::array1d<int,cusp::device_memory> colors;
+ *      size_t num_colors = cusp::graph::color(A, colors, 2, true);
+ *
+ *      return 0;
+ *  }
+ *  \endcode
+ */
+template <typename Matrix, typename Array>
+size_t color(const Matrix& G, Array& colors, size_t k = 1, bool balance = false);
+
+/*! \}
+ */
+
+
+} // end namespace graph
+} // end namespace cusp
+
+#include <cusp/graph/detail/vertex_coloring.inl>
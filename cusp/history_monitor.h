@@ -0,0 +1,303 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*! \file history_monitor.h
+ *  \brief Record the residual history of iterative solvers in device memory
+ */
+
+#pragma once
+
+#include <cusp/detail/config.h>
+
+#include <cusp/array1d.h>
+#include <cusp/blas.h>
+#include <cusp/monitor.h>
+
+#include <cusp/detail/device/squared_norm.h>
+
+#include <thrust/copy.h>
+#include <thrust/transform_reduce.h>
+#include <thrust/functional.h>
+#include <thrust/detail/type_traits.h>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <iomanip>
+
+namespace cusp
+{
+namespace detail
+{
+
+// result[0] <- <r,r> in the memory space of result
+template <typename Vector, typename Array>
+void history_squared_norm(const Vector& r, Array& partials, Array& result, const size_t slot, cusp::host_memory)
+{
+    typedef typename Array::value_type ValueType;
+
+    result[slot] = thrust::transform_reduce(r.begin(), r.end(), cusp::blas::detail::norm_squared<ValueType>(),
+                                            ValueType(0), thrust::plus<ValueType>());
+}
+
+template <typename Vector, typename Array>
+void history_squared_norm(const Vector& r, Array& partials, Array& result, const size_t slot, cusp::device_memory)
+{
+    cusp::detail::device::squared_norm(thrust::raw_pointer_cast(&r[0]), r.size(),
+                                       thrust::raw_pointer_cast(&partials[0]),
+                                       thrust::raw_pointer_cast(&result[0]) + slot);
+}
+
+} // end namespace detail
+
+/*! \addtogroup iterative_solvers Iterative Solvers
+ *  \addtogroup monitors Monitors
+ *  \ingroup iterative_solvers
+ *  \{
+ */
+
+/*! \p history_monitor records the residual norm of every iteration in a
+ * preallocated ring buffer and tests convergence every \p check_interval
+ * iterations like \p interval_monitor.
+ *
+ * The squared norm of a residual in the memory space of the buffer is
+ * computed by kernels that write straight into the buffer, so recording
+ * does not synchronize with the host.  The buffer is copied to the host
+ * only by \p history, or when a residual is tested or reported.  The last
+ * \p capacity iterations are kept.
+ *
+ * With a nonzero \p report_interval the iteration number and residual
+ * norm are printed every \p report_interval iterations, in the format of
+ * \p verbose_monitor.
+ *
+ * \tparam ValueType scalar type used in the solver (e.g. \c float or \c cusp::complex<double>).
+ * \tparam MemorySpace memory space of the ring buffer
+ *
+ * \note The residual vectors passed to \p finished must be contiguous.
+ *
+ *  The following code snippet records the convergence history of \p bicgstab.
+ *
+ *  \code
+ *  #include <cusp/csr_matrix.h>
+ *  #include <cusp/history_monitor.h>
+ *  #include <cusp/krylov/bicgstab.h>
+ *  #include <cusp/gallery/poisson.h>
+ *
+ *  int main(void)
+ *  {
+ *      cusp::csr_matrix<int, float, cusp::device_memory> A;
+ *      cusp::gallery::poisson5pt(A, 10, 10);
+ *
+ *      cusp::array1d<float, cusp::device_memory> x(A.num_rows, 0);
+ *      cusp::array1d<float, cusp::device_memory> b(A.num_rows, 1);
+ *
+ *      // test every 10 iterations, report every 50
+ *      cusp::history_monitor<float> monitor(b, 1000, 1e-6, 0, 10, 1000, 50);
+ *
+ *      cusp::krylov::bicgstab(A, x, b, monitor);
+ *
+ *      // residual norm of every iteration
+ *      cusp::array1d<float, cusp::host_memory> history = monitor.history();
+ *
+ *      return 0;
+ *  }
+ *  \endcode
+ *
+ *  \see \p interval_monitor
+ *  \see \p convergence_monitor
+ */
+template <typename ValueType, typename MemorySpace = cusp::device_memory>
+class history_monitor : public interval_monitor<ValueType>
+{
+    typedef typename norm_type<ValueType>::type Real;
+    typedef cusp::interval_monitor<ValueType> super;
+    typedef cusp::default_monitor<ValueType> base;
+
+    public:
+    /*! Construct a \p history_monitor for a given right-hand-side \p b
+     *
+     *  \param b right-hand-side of the linear system A x = b
+     *  \param iteration_limit maximum number of solver iterations to allow
+     *  \param relative_tolerance determines convergence criteria
+     *  \param absolute_tolerance determines convergence criteria
+     *  \param check_interval number of iterations between two tests of the residual
+     *  \param capacity number of iterations kept in the ring buffer
+     *  \param report_interval number of iterations between two reports, 0 disables reporting
+     *
+     *  \tparam VectorType vector
+     */
+    template <typename Vector>
+    history_monitor(const Vector& b, size_t iteration_limit = 500, Real relative_tolerance = 1e-5, Real absolute_tolerance = 0,
+                    size_t check_interval = 10, size_t capacity = 1000, size_t report_interval = 0)
+        : super(b, iteration_limit, relative_tolerance, absolute_tolerance, check_interval),
+          buffer(capacity > 0 ? capacity : 1, ValueType(0)),
+          partials(cusp::detail::device::squared_norm_num_partials()),
+          num_recorded_(0),
+          report_interval_(report_interval)
+    {}
+
+    /*! records the norm of the residual vector \p r and applies the
+     *  convergence criteria if the current iteration is tested
+     */
+    template <typename Vector>
+    bool finished(const Vector& r)
+    {
+        typedef typename thrust::detail::is_same<typename Vector::memory_space, MemorySpace>::type same_space;
+
+        // residuals in another memory space are recorded through the host
+        if (!same_space::value)
+            return finished(cusp::blas::nrm2(r));
+
+        const size_t slot = record();
+
+        cusp::detail::history_squared_norm(r, partials, buffer, slot, MemorySpace());
+
+        return test(slot);
+    }
+
+    /*! records a residual norm computed by the solver and applies the
+     *  convergence criteria
+     */
+    bool finished(const Real& residual_norm)
+    {
+        const size_t slot = record();
+
+        buffer[slot] = ValueType(residual_norm * residual_norm);
+
+        report(residual_norm);
+
+        return base::finished(residual_norm);
+    }
+
+    /*! records the squared residual norm <r,r> held by the first entry
+     *  of \p squared_norm and applies the convergence criteria if the
+     *  current iteration is tested
+     */
+    template <typename Array>
+    bool finished_squared_norm(const Array& squared_norm)
+    {
+        const size_t slot = record();
+
+        thrust::copy(squared_norm.begin(), squared_norm.begin() + 1, buffer.begin() + slot);
+
+        return test(slot);
+    }
+
+    /*! copies the recorded residual norms to \p norms, oldest first.  The
+     *  first entry belongs to iteration \p first_recorded_iteration.
+     */
+    template <typename Array>
+    void history(Array& norms) const
+    {
+        cusp::array1d<ValueType,cusp::host_memory> squared(buffer);
+
+        const size_t n = num_recorded();
+        const size_t first = first_recorded_iteration();
+
+        norms.resize(n);
+
+        for (size_t i = 0; i < n; i++)
+            norms[i] = squared_to_norm(squared[(first + i) % capacity()]);
+    }
+
+    /*! recorded residual norms, oldest first
+     */
+    cusp::array1d<Real,cusp::host_memory> history(void) const
+    {
+        cusp::array1d<Real,cusp::host_memory> norms;
+        history(norms);
+        return norms;
+    }
+
+    /*! number of iterations held by the ring buffer
+     */
+    size_t num_recorded() const { return std::min(num_recorded_, capacity()); }
+
+    /*! iteration of the oldest recorded residual norm
+     */
+    size_t first_recorded_iteration() const { return num_recorded_ - num_recorded(); }
+
+    /*! number of iterations kept in the ring buffer
+     */
+    size_t capacity() const { return buffer.size(); }
+
+    /*! number of iterations between two reports, 0 if reporting is disabled
+     */
+    size_t report_interval() const { return report_interval_; }
+
+    protected:
+    cusp::array1d<ValueType,MemorySpace> buffer;     // squared residual norms
+    cusp::array1d<ValueType,MemorySpace> partials;   // partial sums of the norm kernels
+    size_t num_recorded_;
+    size_t report_interval_;
+
+    static Real squared_to_norm(const ValueType& rr)
+    {
+        using std::abs;
+        using std::sqrt;
+        return Real(sqrt(abs(rr)));
+    }
+
+    // slot of the current iteration, the last record of an iteration wins
+    size_t record(void)
+    {
+        num_recorded_ = std::max(num_recorded_, base::iteration_count() + 1);
+        return base::iteration_count() % capacity();
+    }
+
+    bool is_report_iteration(void) const
+    {
+        return report_interval_ > 0 && base::iteration_count() % report_interval_ == 0;
+    }
+
+    void report(const Real& residual_norm) const
+    {
+        if (!is_report_iteration())
+            return;
+
+        std::cout << "       "  << std::setw(10) << base::iteration_count();
+        std::cout << "       "  << std::setw(10) << std::scientific << residual_norm << std::endl;
+    }
+
+    // reads the recorded norm only on tested or reported iterations
+    bool test(const size_t slot)
+    {
+        if (!super::is_check_iteration() && !is_report_iteration())
+            return false;
+
+        const Real residual_norm = squared_to_norm(buffer[slot]);
+
+        report(residual_norm);
+
+        if (!super::is_check_iteration())
+            return false;
+
+        return base::finished(residual_norm);
+    }
+};
+/*! \}
+ */
+
+namespace detail
+{
+
+template <typename ValueType, typename MemorySpace>
+struct accepts_residual_norm< cusp::history_monitor<ValueType,MemorySpace> > : thrust::detail::true_type {};
+
+} // end namespace detail
+
+} // end namespace cusp
+
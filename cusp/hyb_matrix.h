@@ -304,6 +304,19 @@ class hyb_matrix_view : public detail::matrix_base<IndexType,ValueType,MemorySpa
       coo.resize(num_rows, num_cols, num_coo_entries);
     }
 };
+
+/*! \p make_hyb_matrix_view : Combine a view of the \p ELL portion and a
+ *  view of the \p COO portion (e.g. built with \p make_ell_matrix_view and
+ *  \p make_coo_matrix_view from external buffers) into a HYB view.
+ *  Nothing is copied.
+ */
+template <typename Matrix1,
+          typename Matrix2>
+hyb_matrix_view<Matrix1,Matrix2>
+make_hyb_matrix_view(const Matrix1& ell, const Matrix2& coo)
+{
+  return hyb_matrix_view<Matrix1,Matrix2>(ell, coo);
+}
 /*! \} // end Views
  */
 
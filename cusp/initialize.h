@@ -0,0 +1,91 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+/*! \file initialize.h
+ *  \brief Pay the start-up costs of the device ahead of the first solve
+ */
+
+#pragma once
+
+#include <cusp/detail/config.h>
+
+#include <cstddef>
+
+namespace cusp
+{
+
+/*! \addtogroup execution Execution
+ *  \{
+ */
+
+/*! \p initialize : Creates the CUDA context of a device and caches the
+ *  device properties used by the Cusp launchers.
+ *
+ * Without it these costs are paid by the first device operation: the
+ * creation of the context (typically the largest part, hundreds of
+ * milliseconds on some systems), the device properties, and the launch
+ * database named by \c CUSP_LAUNCH_DATABASE.  Calling \p initialize early,
+ * for example while the host reads the input, takes them off the critical
+ * path; calling it again is cheap.
+ *
+ * The occupancy of each kernel is queried on its first launch and cached
+ * afterwards.  With CUDA 11.7 and newer, kernel modules can also be loaded
+ * on first use instead of when the context is created, which shortens the
+ * start-up of programs which use few of the kernels compiled into them.
+ * \p initialize requests it (by setting \c CUDA_MODULE_LOADING=LAZY) unless
+ * \p lazy_module_loading is \c false or the variable is already set.  This
+ * only has an effect before the CUDA context is created, so \p initialize
+ * should be the first CUDA call of the program.  \p initialize_spmv then
+ * loads the SpMV kernels of a matrix type ahead of time.
+ *
+ *  \param device CUDA device to use, or -1 for the current device
+ *  \param lazy_module_loading load kernel modules on first use
+ *
+ *  \code
+ *  #include <cusp/initialize.h>
+ *  #include <cusp/csr_matrix.h>
+ *  ...
+ *
+ *  int main(void)
+ *  {
+ *      cusp::initialize();
+ *      cusp::initialize_spmv< cusp::csr_matrix<int, float, cusp::device_memory> >();
+ *      ...
+ *  }
+ *  \endcode
+ */
+inline void initialize(int device = -1, bool lazy_module_loading = true);
+
+/*! \p initialize_spmv : Runs <tt>y = A * x</tt> once on a small matrix of
+ *  type \p MatrixType, which loads the kernels it uses, caches their
+ *  occupancy and fills the device allocation cache.
+ *
+ *  The kernels of the CSR format depend on the average number of entries
+ *  per row, which should match the matrices of the application.
+ *
+ *  \tparam MatrixType device matrix type
+ *  \param entries_per_row entries in each row of the small matrix
+ */
+template <typename MatrixType>
+void initialize_spmv(size_t entries_per_row = 5);
+
+/*! \}
+ */
+
+} // end namespace cusp
+
+#include <cusp/detail/initialize.inl>
@@ -0,0 +1,191 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*! \file binary.h
+ *  \brief Native binary matrix file I/O
+ */
+
+#pragma once
+
+#include <cusp/detail/config.h>
+
+#include <cusp/array1d.h>
+#include <cusp/csr_matrix.h>
+
+#include <cusp/io/detail/mapped_file.h>
+
+#include <string>
+
+namespace cusp
+{
+namespace io
+{
+namespace detail
+{
+
+struct binary_header;
+
+} // end namespace detail
+
+/*! \addtogroup input_output Input/Output
+ *  \addtogroup binary Binary
+ *  \ingroup input_output
+ *  \{
+ */
+
+/*! \p write_binary_file : Write a matrix in the native binary format
+ *
+ * The arrays of the matrix are stored in their internal layout, including
+ * the padding of \p ell_matrix and \p dia_matrix, after a small header
+ * recording the format, the widths of the index and value types, and the
+ * offset and pitch of each array.  Every array starts at a multiple of 64
+ * bytes.
+ *
+ * \param mtx a \p array1d, \p coo_matrix, \p csr_matrix, \p dia_matrix,
+ *        \p ell_matrix or \p hyb_matrix in any memory space
+ * \param filename file name of the binary file
+ * \tparam Matrix matrix container
+ *
+ * \note other sparse formats are stored as \p csr_matrix
+ * \note if the file already exists it will be overwritten
+ * \note the file uses the byte order of the machine which wrote it
+ * \note file names ending in ".gz" or ".zst" are written gzip or zstd
+ *       compressed in independent blocks, which requires
+ *       \c __CUSP_USE_ZLIB__ or \c __CUSP_USE_ZSTD__ to be defined
+ *
+ * \see \p read_binary_file
+ */
+template <typename Matrix>
+void write_binary_file(const Matrix& mtx, const std::string& filename);
+
+/*! \p read_binary_file : Read a matrix in the native binary format
+ *
+ * When \p mtx has the format of the file, its arrays are copied directly
+ * from the file: host matrices copy from a memory mapping of the file and
+ * device matrices from a single read into page-locked memory.  Otherwise
+ * the file is loaded in its own format and converted.
+ *
+ * \param mtx a matrix container (e.g. \p csr_matrix or \p coo_matrix)
+ * \param filename file name of the binary file
+ * \tparam Matrix matrix container
+ *
+ * \note any contents of \p mtx will be overwritten
+ * \note the index and value types of \p mtx must have the widths stored
+ *       in the file
+ * \note compressed files are decompressed on the host first, in parallel
+ *       over their blocks, and read from there
+ *
+ * \code
+ * #include <cusp/io/binary.h>
+ * #include <cusp/io/matrix_market.h>
+ * #include <cusp/csr_matrix.h>
+ *
+ * int main(void)
+ * {
+ *     // convert a MatrixMarket file once
+ *     cusp::csr_matrix<int, float, cusp::host_memory> A;
+ *     cusp::io::read_matrix_market_file(A, "A.mtx");
+ *     cusp::io::write_binary_file(A, "A.bin");
+ *
+ *     // and load the binary file on later runs
+ *     cusp::csr_matrix<int, float, cusp::device_memory> B;
+ *     cusp::io::read_binary_file(B, "A.bin");
+ *
+ *     return 0;
+ * }
+ * \endcode
+ *
+ * \see \p write_binary_file
+ * \see \p binary_file
+ */
+template <typename Matrix>
+void read_binary_file(Matrix& mtx, const std::string& filename);
+
+/*! \p binary_file : Memory mapping of a native binary file
+ *
+ * Exposes the arrays of a file written by \p write_binary_file as host
+ * views without parsing or copying.  The views remain valid as long as
+ * the \p binary_file exists.
+ *
+ * \code
+ * #include <cusp/io/binary.h>
+ * #include <cusp/multiply.h>
+ *
+ * int main(void)
+ * {
+ *     cusp::io::binary_file file("A.bin");
+ *
+ *     cusp::array1d<float, cusp::host_memory> x(file.num_cols(), 1);
+ *     cusp::array1d<float, cusp::host_memory> y(file.num_rows());
+ *
+ *     cusp::multiply(file.make_csr_view<int,float>(), x, y);
+ *
+ *     return 0;
+ * }
+ * \endcode
+ */
+class binary_file
+{
+  public:
+    /*! type of the view of a CSR file
+     */
+    template <typename IndexType, typename ValueType>
+    struct csr_view
+    {
+      typedef cusp::csr_matrix_view<cusp::array1d_view<const IndexType *>,
+                                    cusp::array1d_view<const IndexType *>,
+                                    cusp::array1d_view<const ValueType *>,
+                                    IndexType, ValueType, cusp::host_memory> type;
+    };
+
+    /*! Map the file \p filename into memory and validate its header.
+     *  Compressed files cannot be mapped and throw \p io_exception.
+     */
+    binary_file(const std::string& filename);
+
+    size_t num_rows(void) const;
+    size_t num_cols(void) const;
+    size_t num_entries(void) const;
+
+    /*! View of a file written from a \p csr_matrix.
+     */
+    template <typename IndexType, typename ValueType>
+    typename csr_view<IndexType,ValueType>::type make_csr_view(void) const;
+
+    /*! View of a file written from a \p array1d.
+     */
+    template <typename ValueType>
+    cusp::array1d_view<const ValueType *> make_array1d_view(void) const;
+
+  private:
+    cusp::io::detail::mapped_file file;
+    const cusp::io::detail::binary_header * header;
+
+    template <typename T>
+    const T * array(size_t i) const;
+
+    // not copyable
+    binary_file(const binary_file&);
+    binary_file& operator=(const binary_file&);
+};
+
+/*! \}
+ */
+
+} //end namespace io
+} //end namespace cusp
+
+#include <cusp/io/detail/binary.inl>
@@ -0,0 +1,790 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include <cusp/array1d.h>
+#include <cusp/coo_matrix.h>
+#include <cusp/csr_matrix.h>
+#include <cusp/dia_matrix.h>
+#include <cusp/ell_matrix.h>
+#include <cusp/hyb_matrix.h>
+#include <cusp/complex.h>
+#include <cusp/convert.h>
+#include <cusp/exception.h>
+
+#include <cusp/detail/utils.h>
+
+#include <cusp/io/detail/compression.h>
+
+#include <cuda_runtime.h>
+
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace cusp
+{
+namespace io
+{
+namespace detail
+{
+
+enum binary_format_id
+{
+  BINARY_UNKNOWN = 0,
+  BINARY_ARRAY1D,
+  BINARY_COO,
+  BINARY_CSR,
+  BINARY_DIA,
+  BINARY_ELL,
+  BINARY_HYB
+};
+
+enum binary_value_kind
+{
+  BINARY_INTEGER = 0,
+  BINARY_REAL,
+  BINARY_COMPLEX
+};
+
+const char         binary_magic[8]    = {'C','U','S','P','B','I','N','\0'};
+const unsigned int binary_byte_order  = 0x01020304;
+const unsigned int binary_version     = 1;
+const unsigned int binary_alignment   = 64;
+const unsigned int binary_max_arrays  = 5;
+
+// location and shape of one array of the file
+struct binary_array
+{
+  unsigned long long offset;     // bytes from the start of the file
+  unsigned long long size;       // number of elements including padding
+  unsigned long long width;      // bytes per element
+  unsigned long long num_rows;   // logical shape of 2D arrays
+  unsigned long long num_cols;
+  unsigned long long pitch;
+};
+
+struct binary_header
+{
+  char magic[8];
+  unsigned int byte_order;
+  unsigned int version;
+  unsigned int format;
+  unsigned int index_size;
+  unsigned int value_size;
+  unsigned int value_kind;
+  unsigned int alignment;
+  unsigned int num_arrays;
+  unsigned long long num_rows;
+  unsigned long long num_cols;
+  unsigned long long num_entries;
+  binary_array arrays[binary_max_arrays];
+};
+
+inline unsigned int binary_format(cusp::array1d_format) { return BINARY_ARRAY1D; }
+inline unsigned int binary_format(cusp::coo_format)     { return BINARY_COO;     }
+inline unsigned int binary_format(cusp::csr_format)     { return BINARY_CSR;     }
+inline unsigned int binary_format(cusp::dia_format)     { return BINARY_DIA;     }
+inline unsigned int binary_format(cusp::ell_format)     { return BINARY_ELL;     }
+inline unsigned int binary_format(cusp::hyb_format)     { return BINARY_HYB;     }
+
+template <typename ValueType>
+unsigned int binary_kind(void)
+{
+  if (thrust::detail::is_same<ValueType, cusp::complex<typename norm_type<ValueType>::type> >::value)
+    return BINARY_COMPLEX;
+  else if (std::numeric_limits<ValueType>::is_integer)
+    return BINARY_INTEGER;
+  else
+    return BINARY_REAL;
+}
+
+/////////////
+// Writing //
+/////////////
+
+inline void initialize_binary_header(binary_header& header,
+                                     unsigned int format, unsigned int index_size, unsigned int value_size, unsigned int value_kind,
+                                     size_t num_rows, size_t num_cols, size_t num_entries)
+{
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.magic, binary_magic, sizeof(binary_magic));
+
+  header.byte_order  = binary_byte_order;
+  header.version     = binary_version;
+  header.format      = format;
+  header.index_size  = index_size;
+  header.value_size  = value_size;
+  header.value_kind  = value_kind;
+  header.alignment   = binary_alignment;
+  header.num_rows    = num_rows;
+  header.num_cols    = num_cols;
+  header.num_entries = num_entries;
+}
+
+// every array starts at a multiple of the alignment after the header;
+// returns the size of the file
+inline unsigned long long assign_binary_offsets(binary_header& header)
+{
+  unsigned long long offset = cusp::detail::round_up(sizeof(binary_header), size_t(binary_alignment));
+
+  for (unsigned int i = 0; i < header.num_arrays; i++)
+  {
+    header.arrays[i].offset = offset;
+    offset = cusp::detail::round_up(offset + header.arrays[i].size * header.arrays[i].width,
+                                    (unsigned long long) binary_alignment);
+  }
+
+  return offset;
+}
+
+class binary_writer
+{
+  binary_header header;
+  std::vector<const char *> data;
+
+  public:
+  binary_writer(unsigned int format, unsigned int index_size, unsigned int value_size, unsigned int value_kind,
+                size_t num_rows, size_t num_cols, size_t num_entries)
+  {
+    initialize_binary_header(header, format, index_size, value_size, value_kind, num_rows, num_cols, num_entries);
+  }
+
+  // host array with the given logical shape
+  template <typename Array>
+  void add(const Array& a, size_t num_rows, size_t num_cols, size_t pitch)
+  {
+    binary_array& entry = header.arrays[header.num_arrays++];
+
+    entry.size     = a.size();
+    entry.width    = sizeof(typename Array::value_type);
+    entry.num_rows = num_rows;
+    entry.num_cols = num_cols;
+    entry.pitch    = pitch;
+
+    data.push_back(a.size() == 0 ? 0 : reinterpret_cast<const char *>(thrust::raw_pointer_cast(&a[0])));
+  }
+
+  template <typename Array>
+  void add(const Array& a)
+  {
+    add(a, a.size(), 1, a.size());
+  }
+
+  void write(const std::string& filename)
+  {
+    assign_binary_offsets(header);
+
+    const int compression = compression_from_file_name(filename);
+
+    if (compression != COMPRESSION_NONE)
+    {
+      compressed_ostream file(filename, compression);
+
+      write_contents(file);
+
+      file.close();
+
+      return;
+    }
+
+    std::ofstream file(filename.c_str(), std::ios::out | std::ios::binary);
+
+    if (!file)
+      throw cusp::io_exception(std::string("unable to open file \"") + filename + std::string("\" for writing"));
+
+    write_contents(file);
+
+    if (!file)
+      throw cusp::io_exception(std::string("unable to write file \"") + filename + std::string("\""));
+  }
+
+  private:
+
+  template <typename Stream>
+  void write_contents(Stream& file)
+  {
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+    unsigned long long position = sizeof(header);
+    const char padding[binary_alignment] = {0};
+
+    for (unsigned int i = 0; i < header.num_arrays; i++)
+    {
+      file.write(padding, header.arrays[i].offset - position);
+      file.write(data[i], header.arrays[i].size * header.arrays[i].width);
+
+      position = header.arrays[i].offset + header.arrays[i].size * header.arrays[i].width;
+    }
+  }
+};
+
+template <typename ValueType>
+void write_binary_matrix(const cusp::array1d<ValueType,cusp::host_memory>& a, const std::string& filename)
+{
+  binary_writer writer(BINARY_ARRAY1D, 0, sizeof(ValueType), binary_kind<ValueType>(), a.size(), 1, a.size());
+  writer.add(a);
+  writer.write(filename);
+}
+
+template <typename IndexType, typename ValueType>
+void write_binary_matrix(const cusp::coo_matrix<IndexType,ValueType,cusp::host_memory>& A, const std::string& filename)
+{
+  binary_writer writer(BINARY_COO, sizeof(IndexType), sizeof(ValueType), binary_kind<ValueType>(), A.num_rows, A.num_cols, A.num_entries);
+  writer.add(A.row_indices);
+  writer.add(A.column_indices);
+  writer.add(A.values);
+  writer.write(filename);
+}
+
+template <typename IndexType, typename ValueType>
+void write_binary_matrix(const cusp::csr_matrix<IndexType,ValueType,cusp::host_memory>& A, const std::string& filename)
+{
+  binary_writer writer(BINARY_CSR, sizeof(IndexType), sizeof(ValueType), binary_kind<ValueType>(), A.num_rows, A.num_cols, A.num_entries);
+  writer.add(A.row_offsets);
+  writer.add(A.column_indices);
+  writer.add(A.values);
+  writer.write(filename);
+}
+
+template <typename IndexType, typename ValueType>
+void write_binary_matrix(const cusp::dia_matrix<IndexType,ValueType,cusp::host_memory>& A, const std::string& filename)
+{
+  binary_writer writer(BINARY_DIA, sizeof(IndexType), sizeof(ValueType), binary_kind<ValueType>(), A.num_rows, A.num_cols, A.num_entries);
+  writer.add(A.diagonal_offsets);
+  writer.add(A.values.values, A.values.num_rows, A.values.num_cols, A.values.pitch);
+  writer.write(filename);
+}
+
+template <typename IndexType, typename ValueType>
+void write_binary_matrix(const cusp::ell_matrix<IndexType,ValueType,cusp::host_memory>& A, const std::string& filename)
+{
+  binary_writer writer(BINARY_ELL, sizeof(IndexType), sizeof(ValueType), binary_kind<ValueType>(), A.num_rows, A.num_cols, A.num_entries);
+  writer.add(A.column_indices.values, A.column_indices.num_rows, A.column_indices.num_cols, A.column_indices.pitch);
+  writer.add(A.values.values,         A.values.num_rows,         A.values.num_cols,         A.values.pitch);
+  writer.write(filename);
+}
+
+template <typename IndexType, typename ValueType>
+void write_binary_matrix(const cusp::hyb_matrix<IndexType,ValueType,cusp::host_memory>& A, const std::string& filename)
+{
+  binary_writer writer(BINARY_HYB, sizeof(IndexType), sizeof(ValueType), binary_kind<ValueType>(), A.num_rows, A.num_cols, A.num_entries);
+  writer.add(A.ell.column_indices.values, A.ell.column_indices.num_rows, A.ell.column_indices.num_cols, A.ell.column_indices.pitch);
+  writer.add(A.ell.values.values,         A.ell.values.num_rows,         A.ell.values.num_cols,         A.ell.values.pitch);
+  writer.add(A.coo.row_indices);
+  writer.add(A.coo.column_indices);
+  writer.add(A.coo.values);
+  writer.write(filename);
+}
+
+// matrices in other memory spaces are copied to the host first
+template <typename Matrix>
+void write_binary_file(const Matrix& mtx, const std::string& filename, cusp::array1d_format)
+{
+  cusp::array1d<typename Matrix::value_type,cusp::host_memory> a(mtx);
+  write_binary_matrix(a, filename);
+}
+
+template <typename ValueType>
+void write_binary_file(const cusp::array1d<ValueType,cusp::host_memory>& a, const std::string& filename, cusp::array1d_format)
+{
+  write_binary_matrix(a, filename);
+}
+
+#define __CUSP_BINARY_WRITE(FORMAT, MATRIX)                                                                      \
+template <typename Matrix>                                                                                       \
+void write_binary_file(const Matrix& mtx, const std::string& filename, FORMAT)                                   \
+{                                                                                                                \
+  MATRIX<typename Matrix::index_type,typename Matrix::value_type,cusp::host_memory> A(mtx);                     \
+  write_binary_matrix(A, filename);                                                                              \
+}                                                                                                                \
+template <typename IndexType, typename ValueType>                                                                \
+void write_binary_file(const MATRIX<IndexType,ValueType,cusp::host_memory>& A, const std::string& filename, FORMAT) \
+{                                                                                                                \
+  write_binary_matrix(A, filename);                                                                              \
+}
+
+__CUSP_BINARY_WRITE(cusp::coo_format, cusp::coo_matrix)
+__CUSP_BINARY_WRITE(cusp::csr_format, cusp::csr_matrix)
+__CUSP_BINARY_WRITE(cusp::dia_format, cusp::dia_matrix)
+__CUSP_BINARY_WRITE(cusp::ell_format, cusp::ell_matrix)
+__CUSP_BINARY_WRITE(cusp::hyb_format, cusp::hyb_matrix)
+
+#undef __CUSP_BINARY_WRITE
+
+// other sparse formats are stored as CSR
+template <typename Matrix>
+void write_binary_file(const Matrix& mtx, const std::string& filename, cusp::sparse_format)
+{
+  cusp::csr_matrix<typename Matrix::index_type,typename Matrix::value_type,cusp::host_memory> A(mtx);
+  write_binary_matrix(A, filename);
+}
+
+/////////////
+// Reading //
+/////////////
+
+// contents of a binary file in host memory
+struct binary_source
+{
+  const char * data;
+  size_t length;
+  binary_header header;
+
+  binary_source(const char * data, size_t length)
+    : data(data), length(length)
+  {
+    if (length < sizeof(binary_header))
+      throw cusp::io_exception("invalid binary file header");
+
+    std::memcpy(&header, data, sizeof(binary_header));
+
+    if (std::memcmp(header.magic, binary_magic, sizeof(binary_magic)) != 0)
+      throw cusp::io_exception("invalid binary file header");
+
+    if (header.byte_order != binary_byte_order)
+      throw cusp::io_exception("binary file was written with a different byte order");
+
+    if (header.version != binary_version)
+      throw cusp::io_exception("unsupported binary file version");
+
+    if (header.num_arrays > binary_max_arrays)
+      throw cusp::io_exception("invalid binary file header");
+
+    for (unsigned int i = 0; i < header.num_arrays; i++)
+    {
+      const binary_array& a = header.arrays[i];
+
+      if (a.offset > length || a.size * a.width > length - a.offset)
+        throw cusp::io_exception("binary file is truncated");
+    }
+  }
+
+  const binary_array& array(unsigned int i, unsigned int format, unsigned int num_arrays) const
+  {
+    if (header.format != format || header.num_arrays != num_arrays)
+      throw cusp::io_exception("invalid binary file header");
+
+    return header.arrays[i];
+  }
+
+  template <typename ValueType>
+  void check_value_type(void) const
+  {
+    if (header.value_size != sizeof(ValueType) || header.value_kind != binary_kind<ValueType>())
+      throw cusp::io_exception("binary file value type does not match the matrix");
+  }
+
+  template <typename IndexType, typename ValueType>
+  void check_types(void) const
+  {
+    if (header.index_size != sizeof(IndexType))
+      throw cusp::io_exception("binary file index type does not match the matrix");
+
+    check_value_type<ValueType>();
+  }
+};
+
+// page-locked copy of a file for transfers to the device
+class pinned_file
+{
+  char * data;
+  size_t length;
+  bool pinned;
+
+  public:
+  pinned_file(const std::string& filename)
+    : data(0), length(0), pinned(false)
+  {
+    std::ifstream file(filename.c_str(), std::ios::in | std::ios::binary);
+
+    if (!file)
+      throw cusp::io_exception(std::string("unable to open file \"") + filename + std::string("\" for reading"));
+
+    file.seekg(0, std::ios::end);
+    length = file.tellg();
+    file.seekg(0, std::ios::beg);
+
+    if (length == 0)
+      return;
+
+    if (cudaMallocHost((void **) &data, length) == cudaSuccess)
+      pinned = true;
+    else
+    {
+      cudaGetLastError();
+      data = new char[length];
+    }
+
+    file.read(data, length);
+
+    if (size_t(file.gcount()) != length)
+      throw cusp::io_exception(std::string("unable to read file \"") + filename + std::string("\""));
+  }
+
+  ~pinned_file(void)
+  {
+    if (pinned)
+      cudaFreeHost(data);
+    else
+      delete[] data;
+  }
+
+  const char * begin(void) const { return data; }
+  size_t size(void) const { return length; }
+
+  private:
+  // not copyable
+  pinned_file(const pinned_file&);
+  pinned_file& operator=(const pinned_file&);
+};
+
+template <typename Array>
+void copy_binary_array(Array& dst, const binary_source& src, const binary_array& a, cusp::host_memory)
+{
+  if (a.size > 0)
+    std::memcpy(thrust::raw_pointer_cast(&dst[0]), src.data + a.offset, a.size * a.width);
+}
+
+template <typename Array>
+void copy_binary_array(Array& dst, const binary_source& src, const binary_array& a, cusp::device_memory)
+{
+  if (a.size > 0)
+    if (cudaMemcpy(thrust::raw_pointer_cast(&dst[0]), src.data + a.offset, a.size * a.width, cudaMemcpyHostToDevice) != cudaSuccess)
+      throw cusp::runtime_exception("failed to copy binary file contents to the device");
+}
+
+template <typename Array>
+void copy_binary_array(Array& dst, const binary_source& src, const binary_array& a)
+{
+  if (dst.size() != a.size || a.width != sizeof(typename Array::value_type))
+    throw cusp::io_exception("invalid binary file header");
+
+  copy_binary_array(dst, src, a, typename Array::memory_space());
+}
+
+// load the arrays of a file in the format of mtx
+template <typename Matrix>
+void load_binary_arrays(Matrix& a, const binary_source& src, cusp::array1d_format)
+{
+  src.check_value_type<typename Matrix::value_type>();
+
+  const binary_array& values = src.array(0, BINARY_ARRAY1D, 1);
+
+  a.resize(values.size);
+
+  copy_binary_array(a, src, values);
+}
+
+template <typename Matrix>
+void load_binary_arrays(Matrix& A, const binary_source& src, cusp::coo_format)
+{
+  src.check_types<typename Matrix::index_type, typename Matrix::value_type>();
+
+  A.resize(src.header.num_rows, src.header.num_cols, src.header.num_entries);
+
+  copy_binary_array(A.row_indices,    src, src.array(0, BINARY_COO, 3));
+  copy_binary_array(A.column_indices, src, src.array(1, BINARY_COO, 3));
+  copy_binary_array(A.values,         src, src.array(2, BINARY_COO, 3));
+}
+
+template <typename Matrix>
+void load_binary_arrays(Matrix& A, const binary_source& src, cusp::csr_format)
+{
+  src.check_types<typename Matrix::index_type, typename Matrix::value_type>();
+
+  A.resize(src.header.num_rows, src.header.num_cols, src.header.num_entries);
+
+  copy_binary_array(A.row_offsets,    src, src.array(0, BINARY_CSR, 3));
+  copy_binary_array(A.column_indices, src, src.array(1, BINARY_CSR, 3));
+  copy_binary_array(A.values,         src, src.array(2, BINARY_CSR, 3));
+}
+
+template <typename Matrix>
+void load_binary_arrays(Matrix& A, const binary_source& src, cusp::dia_format)
+{
+  src.check_types<typename Matrix::index_type, typename Matrix::value_type>();
+
+  const binary_array& offsets = src.array(0, BINARY_DIA, 2);
+  const binary_array& values  = src.array(1, BINARY_DIA, 2);
+
+  A.resize(src.header.num_rows, src.header.num_cols, src.header.num_entries, offsets.size);
+  A.values.resize(values.num_rows, values.num_cols, values.pitch);
+
+  copy_binary_array(A.diagonal_offsets, src, offsets);
+  copy_binary_array(A.values.values,    src, values);
+}
+
+template <typename Matrix>
+void load_binary_arrays(Matrix& A, const binary_source& src, cusp::ell_format)
+{
+  src.check_types<typename Matrix::index_type, typename Matrix::value_type>();
+
+  const binary_array& column_indices = src.array(0, BINARY_ELL, 2);
+  const binary_array& values         = src.array(1, BINARY_ELL, 2);
+
+  A.resize(src.header.num_rows, src.header.num_cols, src.header.num_entries, column_indices.num_cols);
+  A.column_indices.resize(column_indices.num_rows, column_indices.num_cols, column_indices.pitch);
+  A.values.resize(values.num_rows, values.num_cols, values.pitch);
+
+  copy_binary_array(A.column_indices.values, src, column_indices);
+  copy_binary_array(A.values.values,         src, values);
+}
+
+template <typename Matrix>
+void load_binary_arrays(Matrix& A, const binary_source& src, cusp::hyb_format)
+{
+  src.check_types<typename Matrix::index_type, typename Matrix::value_type>();
+
+  const binary_array& ell_column_indices = src.array(0, BINARY_HYB, 5);
+  const binary_array& ell_values         = src.array(1, BINARY_HYB, 5);
+  const binary_array& coo_row_indices    = src.array(2, BINARY_HYB, 5);
+
+  const size_t num_coo_entries = coo_row_indices.size;
+
+  if (num_coo_entries > src.header.num_entries)
+    throw cusp::io_exception("invalid binary file header");
+
+  A.resize(src.header.num_rows, src.header.num_cols,
+           src.header.num_entries - num_coo_entries, num_coo_entries,
+           ell_column_indices.num_cols);
+  A.ell.column_indices.resize(ell_column_indices.num_rows, ell_column_indices.num_cols, ell_column_indices.pitch);
+  A.ell.values.resize(ell_values.num_rows, ell_values.num_cols, ell_values.pitch);
+
+  copy_binary_array(A.ell.column_indices.values, src, ell_column_indices);
+  copy_binary_array(A.ell.values.values,         src, ell_values);
+  copy_binary_array(A.coo.row_indices,           src, coo_row_indices);
+  copy_binary_array(A.coo.column_indices,        src, src.array(3, BINARY_HYB, 5));
+  copy_binary_array(A.coo.values,                src, src.array(4, BINARY_HYB, 5));
+}
+
+// load a sparse matrix file in its own format on the host and convert it
+template <typename Matrix>
+void load_binary_converted(Matrix& mtx, const binary_source& src)
+{
+  typedef typename Matrix::index_type IndexType;
+  typedef typename Matrix::value_type ValueType;
+
+  switch (src.header.format)
+  {
+    case BINARY_COO:
+    {
+      cusp::coo_matrix<IndexType,ValueType,cusp::host_memory> temp;
+      load_binary_arrays(temp, src, cusp::coo_format());
+      cusp::convert(temp, mtx);
+      break;
+    }
+    case BINARY_CSR:
+    {
+      cusp::csr_matrix<IndexType,ValueType,cusp::host_memory> temp;
+      load_binary_arrays(temp, src, cusp::csr_format());
+      cusp::convert(temp, mtx);
+      break;
+    }
+    case BINARY_DIA:
+    {
+      cusp::dia_matrix<IndexType,ValueType,cusp::host_memory> temp;
+      load_binary_arrays(temp, src, cusp::dia_format());
+      cusp::convert(temp, mtx);
+      break;
+    }
+    case BINARY_ELL:
+    {
+      cusp::ell_matrix<IndexType,ValueType,cusp::host_memory> temp;
+      load_binary_arrays(temp, src, cusp::ell_format());
+      cusp::convert(temp, mtx);
+      break;
+    }
+    case BINARY_HYB:
+    {
+      cusp::hyb_matrix<IndexType,ValueType,cusp::host_memory> temp;
+      load_binary_arrays(temp, src, cusp::hyb_format());
+      cusp::convert(temp, mtx);
+      break;
+    }
+    default:
+      throw cusp::io_exception("binary file does not contain a sparse matrix");
+  }
+}
+
+template <typename Matrix>
+void load_binary(Matrix& a, const binary_source& src, cusp::array1d_format)
+{
+  load_binary_arrays(a, src, cusp::array1d_format());
+}
+
+template <typename Matrix, typename Format>
+void load_binary(Matrix& mtx, const binary_source& src, Format)
+{
+  load_binary_converted(mtx, src);
+}
+
+#define __CUSP_BINARY_LOAD(FORMAT)                                          \
+template <typename Matrix>                                                  \
+void load_binary(Matrix& mtx, const binary_source& src, FORMAT)             \
+{                                                                           \
+  if (src.header.format == binary_format(FORMAT()))                         \
+    load_binary_arrays(mtx, src, FORMAT());                                 \
+  else                                                                      \
+    load_binary_converted(mtx, src);                                        \
+}
+
+__CUSP_BINARY_LOAD(cusp::coo_format)
+__CUSP_BINARY_LOAD(cusp::csr_format)
+__CUSP_BINARY_LOAD(cusp::dia_format)
+__CUSP_BINARY_LOAD(cusp::ell_format)
+__CUSP_BINARY_LOAD(cusp::hyb_format)
+
+#undef __CUSP_BINARY_LOAD
+
+template <typename Matrix>
+void read_binary_file(Matrix& mtx, const std::string& filename, cusp::host_memory)
+{
+  // copy straight from the mapping of the file
+  cusp::io::detail::mapped_file file(filename);
+
+  const int compression = compression_from_contents(file.begin(), file.size());
+
+  if (compression != COMPRESSION_NONE)
+  {
+    std::vector<char> contents;
+
+    decompress(compression, file.begin(), file.end(), contents);
+
+    binary_source src(contents.empty() ? 0 : &contents[0], contents.size());
+
+    load_binary(mtx, src, typename Matrix::format());
+
+    return;
+  }
+
+  binary_source src(file.begin(), file.size());
+
+  load_binary(mtx, src, typename Matrix::format());
+}
+
+template <typename Matrix>
+void read_binary_file(Matrix& mtx, const std::string& filename, cusp::device_memory)
+{
+  const int compression = compression_from_file(filename);
+
+  // decompress on the host and transfer each array from there
+  if (compression != COMPRESSION_NONE)
+  {
+    cusp::io::detail::mapped_file file(filename);
+
+    std::vector<char> contents;
+
+    decompress(compression, file.begin(), file.end(), contents);
+
+    binary_source src(contents.empty() ? 0 : &contents[0], contents.size());
+
+    load_binary(mtx, src, typename Matrix::format());
+
+    return;
+  }
+
+  // read the file into page-locked memory once and transfer each array with DMA
+  pinned_file file(filename);
+
+  binary_source src(file.begin(), file.size());
+
+  load_binary(mtx, src, typename Matrix::format());
+}
+
+} // end namespace detail
+
+template <typename Matrix>
+void write_binary_file(const Matrix& mtx, const std::string& filename)
+{
+  cusp::io::detail::write_binary_file(mtx, filename, typename Matrix::format());
+}
+
+template <typename Matrix>
+void read_binary_file(Matrix& mtx, const std::string& filename)
+{
+  cusp::io::detail::read_binary_file(mtx, filename, typename Matrix::memory_space());
+}
+
+/////////////////
+// binary_file //
+/////////////////
+
+inline binary_file::binary_file(const std::string& filename)
+  : file(filename), header(0)
+{
+  // views point into the mapping, which needs the contents uncompressed
+  if (cusp::io::detail::compression_from_contents(file.begin(), file.size()) != cusp::io::detail::COMPRESSION_NONE)
+    throw cusp::io_exception(std::string("binary file \"") + filename + std::string("\" is compressed and cannot be mapped"));
+
+  // validate the header
+  cusp::io::detail::binary_source src(file.begin(), file.size());
+
+  header = reinterpret_cast<const cusp::io::detail::binary_header *>(file.begin());
+}
+
+inline size_t binary_file::num_rows(void) const    { return header->num_rows; }
+inline size_t binary_file::num_cols(void) const    { return header->num_cols; }
+inline size_t binary_file::num_entries(void) const { return header->num_entries; }
+
+template <typename T>
+const T * binary_file::array(size_t i) const
+{
+  return reinterpret_cast<const T *>(file.begin() + header->arrays[i].offset);
+}
+
+template <typename IndexType, typename ValueType>
+typename binary_file::csr_view<IndexType,ValueType>::type
+binary_file::make_csr_view(void) const
+{
+  cusp::io::detail::binary_source src(file.begin(), file.size());
+
+  src.check_types<IndexType,ValueType>();
+
+  if (header->format != cusp::io::detail::BINARY_CSR)
+    throw cusp::io_exception("binary file does not contain a csr_matrix");
+
+  const IndexType * row_offsets    = array<IndexType>(0);
+  const IndexType * column_indices = array<IndexType>(1);
+  const ValueType * values         = array<ValueType>(2);
+
+  return typename csr_view<IndexType,ValueType>::type
+    (header->num_rows, header->num_cols, header->num_entries,
+     cusp::make_array1d_view(row_offsets,    row_offsets    + header->arrays[0].size),
+     cusp::make_array1d_view(column_indices, column_indices + header->arrays[1].size),
+     cusp::make_array1d_view(values,         values         + header->arrays[2].size));
+}
+
+template <typename ValueType>
+cusp::array1d_view<const ValueType *> binary_file::make_array1d_view(void) const
+{
+  cusp::io::detail::binary_source src(file.begin(), file.size());
+
+  src.check_value_type<ValueType>();
+
+  if (header->format != cusp::io::detail::BINARY_ARRAY1D)
+    throw cusp::io_exception("binary file does not contain an array1d");
+
+  const ValueType * values = array<ValueType>(0);
+
+  return cusp::make_array1d_view(values, values + header->arrays[0].size);
+}
+
+} // end namespace io
+} // end namespace cusp
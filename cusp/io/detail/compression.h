@@ -0,0 +1,591 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+#pragma once
+
+#include <cusp/exception.h>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#ifdef __CUSP_USE_ZLIB__
+#include <zlib.h>
+#endif
+
+#ifdef __CUSP_USE_ZSTD__
+#include <zstd.h>
+#endif
+
+// Compressed files are written as a sequence of independent gzip members
+// or zstd frames, each holding compression_block_size bytes of the
+// contents, which the standard tools read as a single stream.  The blocks
+// of a batch are compressed in parallel and written in order.  A file of
+// independent blocks is also decompressed in parallel, each block into its
+// place in the output: zstd frames record their sizes, and the gzip members
+// carry theirs in an extra field, as in BGZF.  Any other compressed file is
+// decompressed serially.
+
+namespace cusp
+{
+namespace io
+{
+namespace detail
+{
+
+enum compression_type
+{
+  COMPRESSION_NONE = 0,
+  COMPRESSION_GZIP,
+  COMPRESSION_ZSTD
+};
+
+const size_t compression_block_size = 4 << 20;
+
+inline bool has_suffix(const std::string& filename, const std::string& suffix)
+{
+  return filename.size() > suffix.size() &&
+         filename.compare(filename.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+// compression of a file to be written, from its name
+inline int compression_from_file_name(const std::string& filename)
+{
+  if (has_suffix(filename, ".gz"))  return COMPRESSION_GZIP;
+  if (has_suffix(filename, ".zst")) return COMPRESSION_ZSTD;
+
+  return COMPRESSION_NONE;
+}
+
+// compression of a file to be read, from its magic number
+inline int compression_from_contents(const char * data, const size_t length)
+{
+  const unsigned char * p = reinterpret_cast<const unsigned char *>(data);
+
+  if (length >= 2 && p[0] == 0x1f && p[1] == 0x8b)
+    return COMPRESSION_GZIP;
+
+  if (length >= 4 && p[0] == 0x28 && p[1] == 0xb5 && p[2] == 0x2f && p[3] == 0xfd)
+    return COMPRESSION_ZSTD;
+
+  return COMPRESSION_NONE;
+}
+
+// compression of an existing file, from its first bytes
+inline int compression_from_file(const std::string& filename)
+{
+  std::ifstream file(filename.c_str(), std::ios::in | std::ios::binary);
+
+  if (!file)
+    throw cusp::io_exception(std::string("unable to open file \"") + filename + std::string("\" for reading"));
+
+  char magic[4] = {0, 0, 0, 0};
+  file.read(magic, sizeof(magic));
+
+  return compression_from_contents(magic, file.gcount());
+}
+
+inline void check_compression_support(const int compression)
+{
+#ifndef __CUSP_USE_ZLIB__
+  if (compression == COMPRESSION_GZIP)
+    throw cusp::not_implemented_exception("gzip compressed files require zlib (compile with __CUSP_USE_ZLIB__)");
+#endif
+
+#ifndef __CUSP_USE_ZSTD__
+  if (compression == COMPRESSION_ZSTD)
+    throw cusp::not_implemented_exception("zstd compressed files require zstd (compile with __CUSP_USE_ZSTD__)");
+#endif
+}
+
+inline int num_compression_threads(void)
+{
+#ifdef _OPENMP
+  return omp_get_max_threads();
+#else
+  return 1;
+#endif
+}
+
+inline void store_le(unsigned char * p, unsigned long long value, const int bytes)
+{
+  for (int i = 0; i < bytes; i++, value >>= 8)
+    p[i] = static_cast<unsigned char>(value & 0xff);
+}
+
+inline unsigned long long load_le(const unsigned char * p, const int bytes)
+{
+  unsigned long long value = 0;
+
+  for (int i = bytes - 1; i >= 0; i--)
+    value = (value << 8) | p[i];
+
+  return value;
+}
+
+//////////
+// gzip //
+//////////
+
+// header of the members written here: FEXTRA with the subfield "CS",
+// holding the size of the whole member
+const size_t gzip_member_header_size = 24;
+
+#ifdef __CUSP_USE_ZLIB__
+// compress [data, data + size) into one gzip member, and return false if zlib fails
+inline bool compress_gzip_member(const char * data, const size_t size, std::vector<char>& member)
+{
+  z_stream stream;
+  std::memset(&stream, 0, sizeof(stream));
+
+  // raw deflate, the header and trailer are written here
+  if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+    return false;
+
+  member.resize(gzip_member_header_size + deflateBound(&stream, uLong(size)) + 8);
+
+  stream.next_in   = reinterpret_cast<Bytef *>(const_cast<char *>(data));
+  stream.avail_in  = uInt(size);
+  stream.next_out  = reinterpret_cast<Bytef *>(&member[gzip_member_header_size]);
+  stream.avail_out = uInt(member.size() - gzip_member_header_size - 8);
+
+  const int status = deflate(&stream, Z_FINISH);
+  const size_t compressed_size = stream.total_out;
+
+  deflateEnd(&stream);
+
+  if (status != Z_STREAM_END)
+    return false;
+
+  member.resize(gzip_member_header_size + compressed_size + 8);
+
+  unsigned char * p = reinterpret_cast<unsigned char *>(&member[0]);
+
+  // ID1 ID2 CM FLG, MTIME, XFL OS, XLEN, and the subfield SI1 SI2 LEN
+  const unsigned char header[16] = {0x1f, 0x8b, 8, 4, 0, 0, 0, 0, 0, 0xff, 12, 0, 'C', 'S', 8, 0};
+  std::memcpy(p, header, sizeof(header));
+  store_le(p + 16, member.size(), 8);
+
+  // CRC32 and ISIZE
+  unsigned char * trailer = p + gzip_member_header_size + compressed_size;
+  store_le(trailer,     crc32(0, reinterpret_cast<const Bytef *>(data), uInt(size)), 4);
+  store_le(trailer + 4, size & 0xffffffffULL, 4);
+
+  return true;
+}
+
+// size of the member at p written by compress_gzip_member, or 0 for any
+// other member
+inline size_t gzip_member_size(const unsigned char * p, const size_t length)
+{
+  if (length < gzip_member_header_size || p[0] != 0x1f || p[1] != 0x8b || p[2] != 8 || p[3] != 4 ||
+      load_le(p + 10, 2) != 12 || p[12] != 'C' || p[13] != 'S' || load_le(p + 14, 2) != 8)
+    return 0;
+
+  const size_t size = load_le(p + 16, 8);
+
+  return size >= gzip_member_header_size + 8 && size <= length ? size : 0;
+}
+
+// decompress a member written by compress_gzip_member into [output, output + size)
+inline bool decompress_gzip_member(const char * member, const size_t member_size, char * output, const size_t size)
+{
+  z_stream stream;
+  std::memset(&stream, 0, sizeof(stream));
+
+  if (inflateInit2(&stream, -15) != Z_OK)
+    return false;
+
+  char empty = 0;
+
+  stream.next_in   = reinterpret_cast<Bytef *>(const_cast<char *>(member + gzip_member_header_size));
+  stream.avail_in  = uInt(member_size - gzip_member_header_size - 8);
+  stream.next_out  = reinterpret_cast<Bytef *>(size == 0 ? &empty : output);
+  stream.avail_out = uInt(size);
+
+  const int status = inflate(&stream, Z_FINISH);
+  const bool complete = status == Z_STREAM_END && stream.total_out == size;
+
+  inflateEnd(&stream);
+
+  const unsigned char * trailer = reinterpret_cast<const unsigned char *>(member + member_size - 8);
+
+  return complete && load_le(trailer, 4) == crc32(0, reinterpret_cast<const Bytef *>(output), uInt(size));
+}
+
+// decompress any gzip stream, including concatenated members, serially
+inline void decompress_gzip_stream(const char * first, const char * last, std::vector<char>& contents)
+{
+  z_stream stream;
+  std::memset(&stream, 0, sizeof(stream));
+
+  // automatic header detection
+  if (inflateInit2(&stream, 15 + 32) != Z_OK)
+    throw cusp::io_exception("unable to decompress gzip file");
+
+  stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(first));
+
+  contents.clear();
+
+  std::vector<char> buffer(1 << 20);
+  int status = Z_OK;
+
+  while (true)
+  {
+    // zlib counts the input in 32 bits
+    if (stream.avail_in == 0)
+    {
+      const char * next = reinterpret_cast<const char *>(stream.next_in);
+      stream.avail_in = uInt(std::min<size_t>(last - next, 1 << 30));
+    }
+
+    stream.next_out  = reinterpret_cast<Bytef *>(&buffer[0]);
+    stream.avail_out = uInt(buffer.size());
+
+    status = inflate(&stream, Z_NO_FLUSH);
+
+    contents.insert(contents.end(), buffer.begin(), buffer.end() - stream.avail_out);
+
+    if (status == Z_STREAM_END)
+    {
+      // continue with the next member
+      if (reinterpret_cast<const char *>(stream.next_in) == last)
+        break;
+
+      inflateReset(&stream);
+    }
+    else if (status != Z_OK)
+      break;
+  }
+
+  inflateEnd(&stream);
+
+  if (status != Z_STREAM_END)
+    throw cusp::io_exception("invalid or truncated gzip file");
+}
+#endif
+
+//////////
+// zstd //
+//////////
+
+#ifdef __CUSP_USE_ZSTD__
+inline bool compress_zstd_frame(const char * data, const size_t size, std::vector<char>& frame)
+{
+  frame.resize(ZSTD_compressBound(size));
+
+  const size_t result = ZSTD_compress(&frame[0], frame.size(), data, size, ZSTD_CLEVEL_DEFAULT);
+
+  if (ZSTD_isError(result))
+    return false;
+
+  frame.resize(result);
+
+  return true;
+}
+
+// decompress any zstd stream serially
+inline void decompress_zstd_stream(const char * first, const char * last, std::vector<char>& contents)
+{
+  ZSTD_DStream * stream = ZSTD_createDStream();
+
+  contents.clear();
+
+  std::vector<char> buffer(ZSTD_DStreamOutSize());
+
+  ZSTD_inBuffer input = {first, size_t(last - first), 0};
+  size_t result = 0;
+
+  while (true)
+  {
+    ZSTD_outBuffer output = {&buffer[0], buffer.size(), 0};
+
+    result = ZSTD_decompressStream(stream, &output, &input);
+
+    if (ZSTD_isError(result))
+      break;
+
+    contents.insert(contents.end(), buffer.begin(), buffer.begin() + output.pos);
+
+    // a full output buffer may leave data behind in the stream
+    if (input.pos == input.size && output.pos < output.size)
+      break;
+  }
+
+  ZSTD_freeDStream(stream);
+
+  // a nonzero result is the remainder of an incomplete frame
+  if (ZSTD_isError(result) || result != 0)
+    throw cusp::io_exception("invalid or truncated zstd file");
+}
+#endif
+
+/////////////////
+// Compression //
+/////////////////
+
+inline bool compress_block(const int compression, const char * data, const size_t size, std::vector<char>& block)
+{
+#ifdef __CUSP_USE_ZLIB__
+  if (compression == COMPRESSION_GZIP)
+    return compress_gzip_member(data, size, block);
+#endif
+#ifdef __CUSP_USE_ZSTD__
+  if (compression == COMPRESSION_ZSTD)
+    return compress_zstd_frame(data, size, block);
+#endif
+
+  return false;
+}
+
+// output stream which compresses everything written to it into the blocks
+// of a gzip or zstd file
+class compressed_ostream
+{
+  std::ofstream file;
+  int compression;
+  size_t block_size;
+  bool empty;
+  std::vector<char> batch;
+  std::vector< std::vector<char> > blocks;
+
+  // disallow copies
+  compressed_ostream(const compressed_ostream&);
+  compressed_ostream& operator=(const compressed_ostream&);
+
+  public:
+
+  compressed_ostream(const std::string& filename, const int compression,
+                     const size_t block_size = compression_block_size)
+    : compression(compression), block_size(block_size), empty(true), blocks(num_compression_threads())
+  {
+    check_compression_support(compression);
+
+    file.open(filename.c_str(), std::ios::out | std::ios::binary);
+
+    if (!file)
+      throw cusp::io_exception(std::string("unable to open file \"") + filename + std::string("\" for writing"));
+
+    batch.reserve(blocks.size() * block_size);
+  }
+
+  ~compressed_ostream(void)
+  {
+    // errors can only be reported by close()
+    try
+    {
+      close();
+    }
+    catch (...) {}
+  }
+
+  void write(const char * data, size_t size)
+  {
+    const size_t capacity = blocks.size() * block_size;
+
+    while (size > 0)
+    {
+      const size_t count = std::min(size, capacity - batch.size());
+
+      batch.insert(batch.end(), data, data + count);
+      data += count;
+      size -= count;
+
+      if (batch.size() == capacity)
+        flush_batch();
+    }
+  }
+
+  template <typename T>
+  compressed_ostream& operator<<(const T& value)
+  {
+    std::ostringstream text;
+    text << value;
+    write(text.str().data(), text.str().size());
+    return *this;
+  }
+
+  // compress the remaining contents and close the file
+  void close(void)
+  {
+    if (!file.is_open())
+      return;
+
+    flush_batch();
+
+    file.close();
+
+    if (!file)
+      throw cusp::io_exception("unable to write compressed file");
+  }
+
+  private:
+
+  // compress the blocks of the batch in parallel and write them in order
+  void flush_batch(void)
+  {
+    // an empty file still needs one block to be recognized
+    const int num_blocks = std::max(int((batch.size() + block_size - 1) / block_size), empty ? 1 : 0);
+
+    std::vector<int> status(num_blocks, 1);
+
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(dynamic)
+#endif
+    for (int b = 0; b < num_blocks; b++)
+    {
+      const size_t offset = b * block_size;
+      const size_t size   = std::min(block_size, batch.size() - offset);
+      const char * data   = batch.empty() ? 0 : &batch[0] + offset;
+
+      status[b] = compress_block(compression, data, size, blocks[b]);
+    }
+
+    for (int b = 0; b < num_blocks; b++)
+    {
+      if (!status[b])
+        throw cusp::io_exception("unable to compress file contents");
+
+      file.write(&blocks[b][0], blocks[b].size());
+    }
+
+    if (!file)
+      throw cusp::io_exception("unable to write compressed file");
+
+    batch.clear();
+    empty = false;
+  }
+};
+
+///////////////////
+// Decompression //
+///////////////////
+
+inline bool decompress_block(const int compression, const char * block, const size_t length, char * output, const size_t size)
+{
+#ifdef __CUSP_USE_ZLIB__
+  if (compression == COMPRESSION_GZIP)
+    return decompress_gzip_member(block, length, output, size);
+#endif
+#ifdef __CUSP_USE_ZSTD__
+  if (compression == COMPRESSION_ZSTD)
+    return ZSTD_decompress(output, size, block, length) == size;
+#endif
+
+  return false;
+}
+
+// decompress the gzip or zstd file [first, last) into contents
+inline void decompress(const int compression, const char * first, const char * last, std::vector<char>& contents)
+{
+  check_compression_support(compression);
+
+  const size_t length = last - first;
+
+  // split the file into its independent blocks
+  std::vector<size_t> block_offsets(1, 0);
+  std::vector<size_t> output_offsets(1, 0);
+  bool independent = true;
+
+  for (size_t offset = 0; offset < length && independent; )
+  {
+    size_t block_length = 0;
+    size_t output_length = 0;
+
+#ifdef __CUSP_USE_ZLIB__
+    if (compression == COMPRESSION_GZIP)
+    {
+      const unsigned char * p = reinterpret_cast<const unsigned char *>(first + offset);
+
+      block_length = gzip_member_size(p, length - offset);
+
+      if (block_length > 0)
+        output_length = load_le(p + block_length - 4, 4);
+    }
+#endif
+#ifdef __CUSP_USE_ZSTD__
+    if (compression == COMPRESSION_ZSTD)
+    {
+      const unsigned long long content_size = ZSTD_getFrameContentSize(first + offset, length - offset);
+
+      if (content_size != ZSTD_CONTENTSIZE_UNKNOWN && content_size != ZSTD_CONTENTSIZE_ERROR)
+      {
+        block_length  = ZSTD_findFrameCompressedSize(first + offset, length - offset);
+        output_length = content_size;
+
+        if (ZSTD_isError(block_length))
+          block_length = 0;
+      }
+    }
+#endif
+
+    if (block_length == 0)
+      independent = false;
+
+    offset += block_length;
+    block_offsets.push_back(offset);
+    output_offsets.push_back(output_offsets.back() + output_length);
+  }
+
+  if (!independent)
+  {
+#ifdef __CUSP_USE_ZLIB__
+    if (compression == COMPRESSION_GZIP)
+      decompress_gzip_stream(first, last, contents);
+#endif
+#ifdef __CUSP_USE_ZSTD__
+    if (compression == COMPRESSION_ZSTD)
+      decompress_zstd_stream(first, last, contents);
+#endif
+    return;
+  }
+
+  // decompress each block into its place
+  const int num_blocks = int(block_offsets.size()) - 1;
+
+  contents.resize(output_offsets.back());
+
+  std::vector<int> status(num_blocks, 1);
+
+#ifdef _OPENMP
+  #pragma omp parallel for schedule(dynamic)
+#endif
+  for (int b = 0; b < num_blocks; b++)
+  {
+    const char * block  = first + block_offsets[b];
+    const size_t length = block_offsets[b + 1] - block_offsets[b];
+    char *       output = contents.empty() ? 0 : &contents[0] + output_offsets[b];
+    const size_t size   = output_offsets[b + 1] - output_offsets[b];
+
+    status[b] = decompress_block(compression, block, length, output, size);
+  }
+
+  for (int b = 0; b < num_blocks; b++)
+    if (!status[b])
+      throw cusp::io_exception("invalid or truncated compressed file");
+}
+
+} // end namespace detail
+} // end namespace io
+} // end namespace cusp
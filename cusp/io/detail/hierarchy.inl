@@ -0,0 +1,263 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include <cusp/array1d.h>
+#include <cusp/array2d.h>
+#include <cusp/exception.h>
+
+#include <cusp/detail/lu.h>
+#include <cusp/io/binary.h>
+#include <cusp/relaxation/jacobi.h>
+
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <string>
+
+namespace cusp
+{
+namespace io
+{
+namespace detail
+{
+
+inline std::string level_filename(const std::string& prefix, const size_t lvl, const char * name)
+{
+    std::ostringstream filename;
+    filename << prefix << ".level" << lvl << "." << name << ".bin";
+    return filename.str();
+}
+
+// expects the next word of the manifest to be keyword
+inline void expect_keyword(std::istream& manifest, const char * keyword)
+{
+    std::string word;
+    manifest >> word;
+
+    if (!manifest || word != keyword)
+        throw cusp::io_exception(std::string("invalid hierarchy manifest, expected \"") + keyword + std::string("\""));
+}
+
+///////////////
+// Smoothers //
+///////////////
+
+// smoothers without stored state are rebuilt from the operator of their level
+template <typename SmootherType>
+void write_smoother(const SmootherType&, const std::string&, std::ostream& manifest)
+{
+    manifest << "smoother rebuild\n";
+}
+
+template <typename SmootherType, typename MatrixType>
+void read_smoother(SmootherType& smoother, const MatrixType& A, const std::string&, std::istream& manifest)
+{
+    expect_keyword(manifest, "smoother");
+    expect_keyword(manifest, "rebuild");
+
+    smoother = SmootherType(A);
+}
+
+template <typename ValueType, typename MemorySpace>
+void write_smoother(const cusp::relaxation::jacobi<ValueType,MemorySpace>& smoother, const std::string& filename, std::ostream& manifest)
+{
+    manifest << "smoother jacobi " << smoother.default_omega << " " << smoother.sweeps << "\n";
+
+    cusp::io::write_binary_file(smoother.diagonal, filename);
+}
+
+template <typename ValueType, typename MemorySpace, typename MatrixType>
+void read_smoother(cusp::relaxation::jacobi<ValueType,MemorySpace>& smoother, const MatrixType& A, const std::string& filename, std::istream& manifest)
+{
+    expect_keyword(manifest, "smoother");
+    expect_keyword(manifest, "jacobi");
+
+    manifest >> smoother.default_omega >> smoother.sweeps;
+
+    cusp::io::read_binary_file(smoother.diagonal, filename);
+    smoother.temp.resize(A.num_rows);
+}
+
+////////////////////
+// Coarse solvers //
+////////////////////
+
+template <typename SolverType>
+void write_solver(const SolverType&, const std::string&, std::ostream& manifest)
+{
+    manifest << "solver rebuild\n";
+}
+
+template <typename SolverType, typename MatrixType>
+void read_solver(SolverType& solver, const MatrixType& A, const std::string&, std::istream& manifest)
+{
+    expect_keyword(manifest, "solver");
+    expect_keyword(manifest, "rebuild");
+
+    solver = SolverType(A);
+}
+
+template <typename ValueType, typename MemorySpace>
+void write_solver(const cusp::detail::dense_inverse_solver<ValueType,MemorySpace>& solver, const std::string& filename, std::ostream& manifest)
+{
+    manifest << "solver dense_inverse " << solver.inverse.num_rows << "\n";
+
+    // the inverse is column_major and unpadded
+    cusp::array1d<ValueType,cusp::host_memory> values(solver.inverse.values);
+    cusp::io::write_binary_file(values, filename);
+}
+
+template <typename ValueType, typename MemorySpace, typename MatrixType>
+void read_solver(cusp::detail::dense_inverse_solver<ValueType,MemorySpace>& solver, const MatrixType& A, const std::string& filename, std::istream& manifest)
+{
+    expect_keyword(manifest, "solver");
+    expect_keyword(manifest, "dense_inverse");
+
+    size_t n = 0;
+    manifest >> n;
+
+    cusp::array1d<ValueType,cusp::host_memory> values;
+    cusp::io::read_binary_file(values, filename);
+
+    if (n != size_t(A.num_rows) || values.size() != n * n)
+        throw cusp::io_exception("coarse solver does not match the coarsest level");
+
+    solver = cusp::detail::dense_inverse_solver<ValueType,MemorySpace>();
+    solver.num_rows = solver.num_cols = n;
+    solver.num_entries = n * n;
+    solver.inverse.resize(n, n);
+    thrust::copy(values.begin(), values.end(), solver.inverse.values.begin());
+}
+
+} // end namespace detail
+
+template <typename MatrixType, typename SmootherType, typename SolverType, typename ValueType>
+void write_hierarchy(const cusp::multilevel<MatrixType,SmootherType,SolverType,ValueType>& M,
+                     const std::string& prefix)
+{
+    CUSP_PROFILE_SCOPED();
+
+    const std::string filename = prefix + ".hierarchy";
+
+    std::ofstream manifest(filename.c_str());
+
+    if (!manifest)
+        throw cusp::io_exception(std::string("unable to open file \"") + filename + std::string("\" for writing"));
+
+    manifest.precision(std::numeric_limits<double>::digits10 + 2);
+
+    manifest << "%%CuspHierarchy 1\n";
+    manifest << "levels " << M.levels.size() << "\n";
+    manifest << "cycle " << int(M.cycle) << " " << M.presmooth_sweeps << " " << M.postsmooth_sweeps << "\n";
+    manifest << "implicit_restriction " << int(M.implicit_restriction) << "\n";
+    manifest << "host_level_size " << M.host_level_size << "\n";
+    manifest << "graph_capture " << int(M.graph_capture) << "\n";
+
+    for (size_t lvl = 0; lvl < M.levels.size(); lvl++)
+    {
+        cusp::io::write_binary_file(M.levels[lvl].A, detail::level_filename(prefix, lvl, "A"));
+
+        // the coarsest level has no transfer operators or smoother
+        if (lvl + 1 == M.levels.size())
+            break;
+
+        if (!M.implicit_restriction)
+            cusp::io::write_binary_file(M.levels[lvl].R, detail::level_filename(prefix, lvl, "R"));
+        cusp::io::write_binary_file(M.levels[lvl].P, detail::level_filename(prefix, lvl, "P"));
+
+        detail::write_smoother(M.levels[lvl].smoother, detail::level_filename(prefix, lvl, "smoother"), manifest);
+    }
+
+    detail::write_solver(M.solver, prefix + ".solver.bin", manifest);
+
+    if (!manifest)
+        throw cusp::io_exception(std::string("unable to write file \"") + filename + std::string("\""));
+}
+
+template <typename MatrixType, typename SmootherType, typename SolverType, typename ValueType>
+void read_hierarchy(cusp::multilevel<MatrixType,SmootherType,SolverType,ValueType>& M,
+                    const std::string& prefix)
+{
+    CUSP_PROFILE_SCOPED();
+
+    typedef cusp::multilevel<MatrixType,SmootherType,SolverType,ValueType> Hierarchy;
+
+    const std::string filename = prefix + ".hierarchy";
+
+    std::ifstream manifest(filename.c_str());
+
+    if (!manifest)
+        throw cusp::io_exception(std::string("unable to open file \"") + filename + std::string("\""));
+
+    int version = 0;
+    detail::expect_keyword(manifest, "%%CuspHierarchy");
+    manifest >> version;
+
+    if (version != 1)
+        throw cusp::io_exception("unsupported hierarchy file version");
+
+    size_t num_levels = 0, presmooth_sweeps = 1, postsmooth_sweeps = 1, host_level_size = 0;
+    int cycle = 0, implicit_restriction = 0, graph_capture = 0;
+
+    detail::expect_keyword(manifest, "levels");               manifest >> num_levels;
+    detail::expect_keyword(manifest, "cycle");                manifest >> cycle >> presmooth_sweeps >> postsmooth_sweeps;
+    detail::expect_keyword(manifest, "implicit_restriction"); manifest >> implicit_restriction;
+    detail::expect_keyword(manifest, "host_level_size");      manifest >> host_level_size;
+    detail::expect_keyword(manifest, "graph_capture");        manifest >> graph_capture;
+
+    if (!manifest || num_levels == 0)
+        throw cusp::io_exception("invalid hierarchy manifest");
+
+    M.levels.clear();
+    M.levels.reserve(num_levels);
+
+    for (size_t lvl = 0; lvl < num_levels; lvl++)
+    {
+        M.levels.push_back(typename Hierarchy::level());
+        typename Hierarchy::level& level = M.levels.back();
+
+        cusp::io::read_binary_file(level.A, detail::level_filename(prefix, lvl, "A"));
+
+        if (lvl > 0)
+        {
+            level.x.resize(level.A.num_rows);
+            level.b.resize(level.A.num_rows);
+        }
+
+        if (lvl + 1 == num_levels)
+            break;
+
+        if (!implicit_restriction)
+            cusp::io::read_binary_file(level.R, detail::level_filename(prefix, lvl, "R"));
+        cusp::io::read_binary_file(level.P, detail::level_filename(prefix, lvl, "P"));
+
+        level.residual.resize(level.A.num_rows);
+
+        detail::read_smoother(level.smoother, level.A, detail::level_filename(prefix, lvl, "smoother"), manifest);
+    }
+
+    detail::read_solver(M.solver, M.levels.back().A, prefix + ".solver.bin", manifest);
+
+    M.implicit_restriction = implicit_restriction != 0;
+    M.set_cycle(cusp::cycle_type(cycle), presmooth_sweeps, postsmooth_sweeps);
+    M.set_graph_capture(graph_capture != 0);
+    M.set_host_levels(host_level_size);
+}
+
+} //end namespace io
+} //end namespace cusp
@@ -0,0 +1,124 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include <cusp/exception.h>
+
+#include <string>
+#include <vector>
+#include <fstream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define __CUSP_USE_MMAP__
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+namespace cusp
+{
+namespace io
+{
+namespace detail
+{
+
+// read-only view of the contents of a file, mapped into memory where the
+// platform supports it and read into a buffer otherwise
+class mapped_file
+{
+  const char * data;
+  size_t length;
+  bool mapped;
+  std::vector<char> buffer;
+
+  public:
+  mapped_file(const std::string& filename)
+    : data(0), length(0), mapped(false)
+  {
+#ifdef __CUSP_USE_MMAP__
+    int fd = open(filename.c_str(), O_RDONLY);
+
+    if (fd < 0)
+      throw cusp::io_exception(std::string("unable to open file \"") + filename + std::string("\" for reading"));
+
+    struct stat info;
+
+    if (fstat(fd, &info) == 0 && info.st_size > 0)
+    {
+      void * address = mmap(0, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+      if (address != MAP_FAILED)
+      {
+        madvise(address, info.st_size, MADV_SEQUENTIAL);
+
+        data   = static_cast<const char *>(address);
+        length = info.st_size;
+        mapped = true;
+      }
+    }
+
+    close(fd);
+
+    if (mapped)
+      return;
+#endif
+
+    // fall back to reading the whole file at once
+    std::ifstream file(filename.c_str(), std::ios::in | std::ios::binary);
+
+    if (!file)
+      throw cusp::io_exception(std::string("unable to open file \"") + filename + std::string("\" for reading"));
+
+    file.seekg(0, std::ios::end);
+    std::streamoff size = file.tellg();
+    file.seekg(0, std::ios::beg);
+
+    if (size > 0)
+    {
+      buffer.resize(size);
+      file.read(&buffer[0], size);
+      buffer.resize(file.gcount());
+    }
+
+    data   = buffer.empty() ? 0 : &buffer[0];
+    length = buffer.size();
+  }
+
+  ~mapped_file(void)
+  {
+#ifdef __CUSP_USE_MMAP__
+    if (mapped)
+      munmap(const_cast<char *>(data), length);
+#endif
+  }
+
+  const char * begin(void) const { return data; }
+  const char * end(void)   const { return data + length; }
+  size_t size(void)        const { return length; }
+
+  private:
+  // not copyable
+  mapped_file(const mapped_file&);
+  mapped_file& operator=(const mapped_file&);
+};
+
+} // end namespace detail
+} // end namespace io
+} // end namespace cusp
+
+#undef __CUSP_USE_MMAP__
@@ -23,13 +23,40 @@
 #include <cusp/convert.h>
 #include <cusp/exception.h>
 
+#include <cusp/io/detail/compression.h>
+#include <cusp/io/detail/mapped_file.h>
+
+#include <thrust/copy.h>
+#include <thrust/count.h>
+#include <thrust/find.h>
+#include <thrust/for_each.h>
+#include <thrust/functional.h>
+#include <thrust/gather.h>
+#include <thrust/scatter.h>
 #include <thrust/sort.h>
-
+#include <thrust/iterator/counting_iterator.h>
+#include <thrust/iterator/zip_iterator.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
 #include <vector>
 #include <string>
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <iterator>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#if (defined THRUST_DEVICE_BACKEND && THRUST_DEVICE_BACKEND == THRUST_DEVICE_BACKEND_CUDA) || (defined THRUST_DEVICE_SYSTEM && THRUST_DEVICE_SYSTEM == THRUST_DEVICE_SYSTEM_CUDA)
+#define __CUSP_USE_STAGED_COPY__
+#include <cusp/detail/device/staged_copy.h>
+#endif
 
 namespace cusp
 {
@@ -98,184 +125,773 @@ void read_matrix_market_banner(matrix_market_banner& banner, Stream& input)
 
 
 template <typename ScalarType>
+__host__ __device__
 void assign_complex(ScalarType& value, double real, double imag)
 {
   value = real;
 }
 
 template <typename ScalarType>
+__host__ __device__
 void assign_complex(cusp::complex<ScalarType>& value, double real, double imag)
 {
   value.real(real);
   value.imag(imag);
 }
 
-template <typename Stream, typename ScalarType>
-void write_value(Stream& output, const ScalarType& value)
+
+////////////////////////
+// Coordinate Entries //
+////////////////////////
+
+inline int num_parse_threads(void)
 {
-  output << value;
+#ifdef _OPENMP
+  return omp_get_max_threads();
+#else
+  return 1;
+#endif
 }
 
-template <typename Stream, typename ScalarType>
-void write_value(Stream& output, const cusp::complex<ScalarType>& value)
+__host__ __device__
+inline bool is_blank(char c)
 {
-  output << value.real() << " " << value.imag();
+  return c == ' ' || c == '\t' || c == '\r';
 }
 
+__host__ __device__
+inline bool is_digit(char c)
+{
+  return c >= '0' && c <= '9';
+}
 
-template <typename IndexType, typename ValueType, typename Stream>
-void read_coordinate_stream(cusp::coo_matrix<IndexType,ValueType,cusp::host_memory>& coo, Stream& input, const matrix_market_banner& banner)
+// first character of the line following p
+__host__ __device__
+inline const char * next_line(const char * p, const char * last)
 {
-  // read file contents line by line
-  std::string line;
-    
-  // skip over banner and comments
-  do
-  {
-    std::getline(input, line);
-  } while (line[0] == '%');
+  while (p != last && *p != '\n') p++;
+  return p == last ? last : p + 1;
+}
 
-  // line contains [num_rows num_columns num_entries]
-  std::vector<std::string> tokens;
-  detail::tokenize(tokens, line); 
+// end of the line containing p, excluding the newline
+__host__ __device__
+inline const char * line_end(const char * p, const char * last)
+{
+  while (p != last && *p != '\n') p++;
+  return p;
+}
 
-  if (tokens.size() != 3)
-    throw cusp::io_exception("invalid MatrixMarket coordinate format");
+// lines that are neither empty nor comments hold one entry each
+__host__ __device__
+inline bool is_entry_line(const char * p, const char * last)
+{
+  while (p != last && is_blank(*p)) p++;
+  return p != last && *p != '\n' && *p != '%';
+}
 
-  size_t num_rows, num_cols, num_entries;
+// signed decimal integer followed by a blank or the end of the line
+__host__ __device__
+inline bool scan_integer(const char *& p, const char * last, long long& value)
+{
+  while (p != last && is_blank(*p)) p++;
 
-  std::istringstream(tokens[0]) >> num_rows;
-  std::istringstream(tokens[1]) >> num_cols;
-  std::istringstream(tokens[2]) >> num_entries;
-  
-  coo.resize(num_rows, num_cols, num_entries);
+  bool negative = false;
 
-  size_t num_entries_read = 0;
+  if (p != last && (*p == '-' || *p == '+'))
+    negative = (*p++ == '-');
 
-  // read file contents
-  if (banner.type == "pattern")
+  if (p == last || !is_digit(*p))
+    return false;
+
+  long long result = 0;
+
+  while (p != last && is_digit(*p))
+    result = 10 * result + (*p++ - '0');
+
+  if (p != last && !is_blank(*p))
+    return false;
+
+  value = negative ? -result : result;
+
+  return true;
+}
+
+// 10^k for 0 <= k <= 22, each product of which is exact in double precision
+__host__ __device__
+inline double exact_power_of_ten(int k)
+{
+  double result = 1;
+
+  for (; k >= 4; k -= 4) result *= 1e4;
+  for (; k >  0; k--)    result *= 10;
+
+  return result;
+}
+
+enum scan_real_status
+{
+  SCAN_REAL_INVALID = 0,
+  SCAN_REAL_OK,
+  SCAN_REAL_INEXACT
+};
+
+// decimal floating point number followed by a blank or the end of the line
+//
+// Numbers with at most 17 significant digits and a small decimal exponent
+// are converted exactly with a single floating point operation.  Anything
+// else (long mantissas, large exponents, inf, nan) is SCAN_REAL_INEXACT and
+// leaves p at the start of the number, for a conversion with strtod.
+__host__ __device__
+inline int scan_exact_real(const char *& p, const char * last, double& value)
+{
+  while (p != last && is_blank(*p)) p++;
+
+  const char * token = p;
+
+  bool negative = false;
+
+  if (p != last && (*p == '-' || *p == '+'))
+    negative = (*p++ == '-');
+
+  unsigned long long mantissa = 0;
+  int exponent = 0;
+  bool digits = false;
+  bool exact = true;
+
+  for (; p != last && is_digit(*p); p++)
   {
-    while(num_entries_read < coo.num_entries && !input.eof())
+    digits = true;
+
+    if (mantissa < 10000000000000000ULL)
+      mantissa = 10 * mantissa + (*p - '0');
+    else
     {
-      input >> coo.row_indices[num_entries_read];
-      input >> coo.column_indices[num_entries_read];
-      num_entries_read++;
+      exponent++;
+      exact = false;
     }
+  }
 
-    std::fill(coo.values.begin(), coo.values.end(), ValueType(1));
-  } 
-  else if (banner.type == "real" || banner.type == "integer")
+  if (p != last && *p == '.')
   {
-    while(num_entries_read < coo.num_entries && !input.eof())
+    for (p++; p != last && is_digit(*p); p++)
     {
-      double real;
+      digits = true;
 
-      input >> coo.row_indices[num_entries_read];
-      input >> coo.column_indices[num_entries_read];
-      input >> real;
-
-      coo.values[num_entries_read] = real;
-      num_entries_read++;
+      if (mantissa < 10000000000000000ULL)
+      {
+        mantissa = 10 * mantissa + (*p - '0');
+        exponent--;
+      }
+      else
+        exact = false;
     }
-  } 
-  else if (banner.type == "complex")
+  }
+
+  if (digits && p != last && (*p == 'e' || *p == 'E'))
   {
-    while(num_entries_read < coo.num_entries && !input.eof())
-    {
-      double real, imag;
+    p++;
 
-      input >> coo.row_indices[num_entries_read];
-      input >> coo.column_indices[num_entries_read];
-      input >> real;
-      input >> imag;
+    bool negative_exponent = false;
 
-      assign_complex(coo.values[num_entries_read], real, imag);
+    if (p != last && (*p == '-' || *p == '+'))
+      negative_exponent = (*p++ == '-');
 
-      num_entries_read++;
-    }
+    if (p == last || !is_digit(*p))
+      return SCAN_REAL_INVALID;
+
+    int e = 0;
+
+    for (; p != last && is_digit(*p); p++)
+      if (e < 100000)
+        e = 10 * e + (*p - '0');
+
+    exponent += negative_exponent ? -e : e;
+  }
+
+  if (digits && (p == last || is_blank(*p)) && exact &&
+      mantissa <= (1ULL << 53) && exponent >= -22 && exponent <= 22)
+  {
+    double result = static_cast<double>(mantissa);
+
+    if (exponent < 0)
+      result /= exact_power_of_ten(-exponent);
+    else
+      result *= exact_power_of_ten(exponent);
+
+    value = negative ? -result : result;
+
+    return SCAN_REAL_OK;
+  }
+
+  p = token;
+
+  return SCAN_REAL_INEXACT;
+}
+
+// decimal floating point number followed by a blank or the end of the line,
+// converted exactly where possible and by strtod otherwise
+inline bool scan_real(const char *& p, const char * last, double& value)
+{
+  const int status = scan_exact_real(p, last, value);
+
+  if (status != SCAN_REAL_INEXACT)
+    return status == SCAN_REAL_OK;
+
+  // slow path
+  const char * token = p;
+
+  while (p != last && !is_blank(*p) && *p != '\n') p++;
+
+  char buffer[128];
+
+  if (p == token || size_t(p - token) >= sizeof(buffer))
+    return false;
+
+  std::copy(token, p, buffer);
+  buffer[p - token] = '\0';
+
+  char * end;
+  value = std::strtod(buffer, &end);
+
+  return end == buffer + (p - token);
+}
+
+enum coordinate_parse_status
+{
+  COORDINATE_OK = 0,
+  COORDINATE_INVALID_ENTRY,
+  COORDINATE_ROW_BELOW_ONE,
+  COORDINATE_COLUMN_BELOW_ONE,
+  COORDINATE_ROW_ABOVE_NUM_ROWS,
+  COORDINATE_COLUMN_ABOVE_NUM_COLUMNS,
+  COORDINATE_INEXACT
+};
+
+inline void throw_coordinate_parse_error(int status)
+{
+  switch (status)
+  {
+    case COORDINATE_INVALID_ENTRY:            throw cusp::io_exception("invalid MatrixMarket coordinate entry");
+    case COORDINATE_ROW_BELOW_ONE:            throw cusp::io_exception("found invalid row index (index < 1)");
+    case COORDINATE_COLUMN_BELOW_ONE:         throw cusp::io_exception("found invalid column index (index < 1)");
+    case COORDINATE_ROW_ABOVE_NUM_ROWS:       throw cusp::io_exception("found invalid row index (index > num_rows)");
+    case COORDINATE_COLUMN_ABOVE_NUM_COLUMNS: throw cusp::io_exception("found invalid column index (index > num_columns)");
   }
+}
+
+// parse the entry line [p, end) into entry n of coo
+template <typename IndexType, typename ValueType>
+int parse_coordinate_entry(cusp::coo_matrix<IndexType,ValueType,cusp::host_memory>& coo,
+                           const char * p, const char * end, size_t n,
+                           const bool is_pattern, const bool is_complex)
+{
+  const long long num_rows = coo.num_rows;
+  const long long num_cols = coo.num_cols;
+
+  long long i, j;
+  double real = 1, imag = 0;
+
+  if (!scan_integer(p, end, i) || !scan_integer(p, end, j))
+    return COORDINATE_INVALID_ENTRY;
+
+  if (!is_pattern && !scan_real(p, end, real))
+    return COORDINATE_INVALID_ENTRY;
+
+  if (is_complex && !scan_real(p, end, imag))
+    return COORDINATE_INVALID_ENTRY;
+
+  if (i < 1)        return COORDINATE_ROW_BELOW_ONE;
+  if (j < 1)        return COORDINATE_COLUMN_BELOW_ONE;
+  if (i > num_rows) return COORDINATE_ROW_ABOVE_NUM_ROWS;
+  if (j > num_cols) return COORDINATE_COLUMN_ABOVE_NUM_COLUMNS;
+
+  // convert base-1 indices to base-0
+  coo.row_indices[n]    = i - 1;
+  coo.column_indices[n] = j - 1;
+
+  if (is_complex)
+    assign_complex(coo.values[n], real, imag);
   else
+    coo.values[n] = real;
+
+  return COORDINATE_OK;
+}
+
+// parse the entry lines in [first, last) into coo, starting at entry n,
+// and return the status of the first invalid entry
+template <typename IndexType, typename ValueType>
+int parse_coordinate_entries(cusp::coo_matrix<IndexType,ValueType,cusp::host_memory>& coo,
+                             const char * first, const char * last, size_t n,
+                             const matrix_market_banner& banner)
+{
+  const bool is_pattern = banner.type == "pattern";
+  const bool is_complex = banner.type == "complex";
+
+  for (const char * p = first; p != last && n < coo.num_entries; p = next_line(p, last))
   {
-    throw cusp::io_exception("invalid MatrixMarket data type");
+    if (!is_entry_line(p, last))
+      continue;
+
+    const int status = parse_coordinate_entry(coo, p, line_end(p, last), n, is_pattern, is_complex);
+
+    if (status != COORDINATE_OK)
+      return status;
+
+    n++;
   }
 
-  if(num_entries_read != coo.num_entries)
-    throw cusp::io_exception("unexpected EOF while reading MatrixMarket entries");
+  return COORDINATE_OK;
+}
+
+// read the size line following the banner and comments, and return the
+// first character after it
+inline const char * read_coordinate_size(const char * first, const char * last,
+                                         size_t& num_rows, size_t& num_cols, size_t& num_entries)
+{
+  // skip over comments
+  while (first != last && !is_entry_line(first, last))
+    first = next_line(first, last);
+
+  // line contains [num_rows num_columns num_entries]
+  std::vector<std::string> tokens;
+  detail::tokenize(tokens, std::string(first, line_end(first, last)));
 
-  // check validity of row and column index data
-  if (coo.num_entries > 0)
+  if (tokens.size() != 3)
+    throw cusp::io_exception("invalid MatrixMarket coordinate format");
+
+  std::istringstream(tokens[0]) >> num_rows;
+  std::istringstream(tokens[1]) >> num_cols;
+  std::istringstream(tokens[2]) >> num_entries;
+
+  return next_line(first, last);
+}
+
+inline void check_coordinate_banner(const matrix_market_banner& banner)
+{
+  if (banner.type != "pattern" && banner.type != "real" &&
+      banner.type != "integer" && banner.type != "complex")
+    throw cusp::io_exception("invalid MatrixMarket data type");
+
+  if (banner.symmetry == "hermitian")
+    throw cusp::not_implemented_exception("MatrixMarket I/O does not currently support hermitian matrices");
+
+  if (banner.symmetry == "skew-symmetric")
+    throw cusp::not_implemented_exception("MatrixMarket I/O does not currently support skew-symmetric matrices");
+}
+
+// parse the first max_entries entry lines of [first, last) into coo,
+// whose dimensions are set by the caller
+//
+// The range is split into chunks at line boundaries.  The entry lines of
+// every chunk are counted in parallel, which gives the position of the first
+// entry of each chunk, and the chunks are then parsed in parallel.
+template <typename IndexType, typename ValueType>
+void parse_coordinate_block(cusp::coo_matrix<IndexType,ValueType,cusp::host_memory>& coo,
+                            const char * first, const char * last, size_t max_entries,
+                            const matrix_market_banner& banner)
+{
+  // split the entries at line boundaries
+  const int num_chunks = num_parse_threads() * 4;
+
+  std::vector<const char *> bounds(num_chunks + 1, last);
+  bounds[0] = first;
+
+  for (int k = 1; k < num_chunks; k++)
   {
-    size_t min_row_index = *std::min_element(coo.row_indices.begin(), coo.row_indices.end());
-    size_t max_row_index = *std::max_element(coo.row_indices.begin(), coo.row_indices.end());
-    size_t min_col_index = *std::min_element(coo.column_indices.begin(), coo.column_indices.end());
-    size_t max_col_index = *std::max_element(coo.column_indices.begin(), coo.column_indices.end());
+    const char * p = first + (last - first) / num_chunks * k;
 
-    if (min_row_index < 1)            throw cusp::io_exception("found invalid row index (index < 1)");
-    if (min_col_index < 1)            throw cusp::io_exception("found invalid column index (index < 1)");
-    if (max_row_index > coo.num_rows) throw cusp::io_exception("found invalid row index (index > num_rows)");
-    if (max_col_index > coo.num_cols) throw cusp::io_exception("found invalid column index (index > num_columns)");
+    if (p <= bounds[k - 1])
+      bounds[k] = bounds[k - 1];
+    else
+      bounds[k] = next_line(p - 1, last);
   }
 
-  // convert base-1 indices to base-0
-  for(size_t n = 0; n < coo.num_entries; n++)
+  // count the entries of each chunk
+  std::vector<size_t> offsets(num_chunks + 1, 0);
+
+#ifdef _OPENMP
+  #pragma omp parallel for schedule(dynamic)
+#endif
+  for (int k = 0; k < num_chunks; k++)
   {
-    coo.row_indices[n]    -= 1;
-    coo.column_indices[n] -= 1;
+    size_t count = 0;
+
+    for (const char * p = bounds[k]; p != bounds[k + 1]; p = next_line(p, bounds[k + 1]))
+      if (is_entry_line(p, bounds[k + 1]))
+        count++;
+
+    offsets[k + 1] = count;
   }
 
-  // expand symmetric formats to "general" format
-  if (banner.symmetry != "general")
+  for (int k = 0; k < num_chunks; k++)
+    offsets[k + 1] += offsets[k];
+
+  coo.resize(coo.num_rows, coo.num_cols, std::min(offsets[num_chunks], max_entries));
+
+  // parse the entries of each chunk
+  std::vector<int> status(num_chunks, COORDINATE_OK);
+
+#ifdef _OPENMP
+  #pragma omp parallel for schedule(dynamic)
+#endif
+  for (int k = 0; k < num_chunks; k++)
+    if (offsets[k] < coo.num_entries)
+      status[k] = parse_coordinate_entries(coo, bounds[k], bounds[k + 1], offsets[k], banner);
+
+  for (int k = 0; k < num_chunks; k++)
+    throw_coordinate_parse_error(status[k]);
+}
+
+// append the transpose of the off-diagonal entries of a symmetric matrix
+template <typename IndexType, typename ValueType>
+void expand_symmetric_entries(cusp::coo_matrix<IndexType,ValueType,cusp::host_memory>& coo)
+{
+  const int    num_chunks  = num_parse_threads() * 4;
+  const size_t num_entries = coo.num_entries;
+
+  // split the entries into blocks and count their off-diagonals
+  std::vector<size_t> block_offsets(num_chunks + 1, 0);
+
+#ifdef _OPENMP
+  #pragma omp parallel for
+#endif
+  for (int k = 0; k < num_chunks; k++)
   {
-    size_t off_diagonals = 0;
+    size_t count = 0;
+
+    for (size_t n = num_entries * k / num_chunks; n < num_entries * (k + 1) / num_chunks; n++)
+      if (coo.row_indices[n] != coo.column_indices[n])
+        count++;
 
-    for (size_t n = 0; n < coo.num_entries; n++)
-      if(coo.row_indices[n] != coo.column_indices[n])
-        off_diagonals++;
+    block_offsets[k + 1] = count;
+  }
 
-    size_t general_num_entries = coo.num_entries + off_diagonals;
+  for (int k = 0; k < num_chunks; k++)
+    block_offsets[k + 1] += block_offsets[k];
 
-    cusp::coo_matrix<IndexType,ValueType,cusp::host_memory> general(num_rows, num_cols, general_num_entries);
+  cusp::coo_matrix<IndexType,ValueType,cusp::host_memory> general(coo.num_rows, coo.num_cols, num_entries + block_offsets[num_chunks]);
 
-    if (banner.symmetry == "symmetric")
+  // copy the entries and append the transposed off-diagonals
+#ifdef _OPENMP
+  #pragma omp parallel for
+#endif
+  for (int k = 0; k < num_chunks; k++)
+  {
+    size_t nnz = num_entries + block_offsets[k];
+
+    for (size_t n = num_entries * k / num_chunks; n < num_entries * (k + 1) / num_chunks; n++)
     {
-      size_t nnz = 0;
+      general.row_indices[n]    = coo.row_indices[n];
+      general.column_indices[n] = coo.column_indices[n];
+      general.values[n]         = coo.values[n];
 
-      for (size_t n = 0; n < coo.num_entries; n++)
+      if (coo.row_indices[n] != coo.column_indices[n])
       {
-        // copy entry over
-        general.row_indices[nnz]    = coo.row_indices[n];
-        general.column_indices[nnz] = coo.column_indices[n];
+        general.row_indices[nnz]    = coo.column_indices[n];
+        general.column_indices[nnz] = coo.row_indices[n];
         general.values[nnz]         = coo.values[n];
         nnz++;
+      }
+    }
+  }
+
+  // store full matrix in coo
+  coo.swap(general);
+}
+
+// read the size line and entries following the banner from memory
+template <typename IndexType, typename ValueType>
+void read_coordinate_buffer(cusp::coo_matrix<IndexType,ValueType,cusp::host_memory>& coo,
+                            const char * first, const char * last,
+                            const matrix_market_banner& banner)
+{
+  check_coordinate_banner(banner);
+
+  size_t num_rows, num_cols, num_entries;
+
+  first = read_coordinate_size(first, last, num_rows, num_cols, num_entries);
+
+  coo.resize(num_rows, num_cols, 0);
+
+  parse_coordinate_block(coo, first, last, num_entries, banner);
+
+  if (coo.num_entries != num_entries)
+    throw cusp::io_exception("unexpected EOF while reading MatrixMarket entries");
+
+  // expand symmetric formats to "general" format
+  if (banner.symmetry == "symmetric")
+    expand_symmetric_entries(coo);
 
-        // duplicate off-diagonals
-        if (coo.row_indices[n] != coo.column_indices[n])
-        {
-          general.row_indices[nnz]    = coo.column_indices[n];
-          general.column_indices[nnz] = coo.row_indices[n];
-          general.values[nnz]         = coo.values[n];
-          nnz++;
-        } 
-      }       
-    } 
-    else if (banner.symmetry == "hermitian")
+  // sort indices by (row,column)
+  coo.sort_by_row_and_column();
+}
+
+template <typename IndexType, typename ValueType, typename Stream>
+void read_coordinate_stream(cusp::coo_matrix<IndexType,ValueType,cusp::host_memory>& coo, Stream& input, const matrix_market_banner& banner)
+{
+  // parse the remaining contents from memory
+  std::string contents((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+
+  read_coordinate_buffer(coo, contents.data(), contents.data() + contents.size(), banner);
+}
+
+/////////////////////
+// Device Parsing  //
+/////////////////////
+
+// Coordinate files read into device matrices are parsed on the device.
+// The text following the size line is copied to the device through the
+// page-locked staging buffers, the entry lines are located with a pass
+// over every character, and each line is then parsed by its own thread.
+// Values which need strtod are marked and parsed again on the host.
+
+// the first character of each entry line
+struct is_entry_line_start
+{
+  const char * text;
+  size_t length;
+
+  is_entry_line_start(const char * text, const size_t length)
+    : text(text), length(length) {}
+
+  __host__ __device__
+  bool operator()(const size_t p) const
+  {
+    return (p == 0 || text[p - 1] == '\n') && is_entry_line(text + p, text + length);
+  }
+};
+
+// parse entry line n into entry n of the output
+template <typename IndexType, typename ValueType>
+struct parse_coordinate_line
+{
+  const char * text;
+  size_t length;
+  const size_t * lines;
+  bool is_pattern;
+  bool is_complex;
+  long long num_rows;
+  long long num_cols;
+  IndexType * row_indices;
+  IndexType * column_indices;
+  ValueType * values;
+  int * status;
+
+  parse_coordinate_line(const char * text, const size_t length, const size_t * lines,
+                        const bool is_pattern, const bool is_complex,
+                        const long long num_rows, const long long num_cols,
+                        IndexType * row_indices, IndexType * column_indices, ValueType * values, int * status)
+    : text(text), length(length), lines(lines), is_pattern(is_pattern), is_complex(is_complex),
+      num_rows(num_rows), num_cols(num_cols),
+      row_indices(row_indices), column_indices(column_indices), values(values), status(status) {}
+
+  __host__ __device__
+  int parse(const char * p, const char * end, const size_t n) const
+  {
+    long long i, j;
+    double real = 1, imag = 0;
+
+    if (!scan_integer(p, end, i) || !scan_integer(p, end, j))
+      return COORDINATE_INVALID_ENTRY;
+
+    if (!is_pattern)
     {
-      throw cusp::not_implemented_exception("MatrixMarket I/O does not currently support hermitian matrices");
-      //TODO
-    } 
-    else if (banner.symmetry == "skew-symmetric")
+      const int result = scan_exact_real(p, end, real);
+
+      if (result != SCAN_REAL_OK)
+        return result == SCAN_REAL_INEXACT ? COORDINATE_INEXACT : COORDINATE_INVALID_ENTRY;
+    }
+
+    if (is_complex)
     {
-      //TODO
-      throw cusp::not_implemented_exception("MatrixMarket I/O does not currently support skew-symmetric matrices");
+      const int result = scan_exact_real(p, end, imag);
+
+      if (result != SCAN_REAL_OK)
+        return result == SCAN_REAL_INEXACT ? COORDINATE_INEXACT : COORDINATE_INVALID_ENTRY;
     }
 
-    // store full matrix in coo
-    coo.swap(general);
-  } // if (banner.symmetry != "general")
+    if (i < 1)        return COORDINATE_ROW_BELOW_ONE;
+    if (j < 1)        return COORDINATE_COLUMN_BELOW_ONE;
+    if (i > num_rows) return COORDINATE_ROW_ABOVE_NUM_ROWS;
+    if (j > num_cols) return COORDINATE_COLUMN_ABOVE_NUM_COLUMNS;
+
+    // convert base-1 indices to base-0
+    row_indices[n]    = i - 1;
+    column_indices[n] = j - 1;
+
+    if (is_complex)
+      assign_complex(values[n], real, imag);
+    else
+      values[n] = real;
+
+    return COORDINATE_OK;
+  }
+
+  __host__ __device__
+  void operator()(const size_t n) const
+  {
+    const char * p = text + lines[n];
+
+    status[n] = parse(p, line_end(p, text + length), n);
+  }
+};
+
+struct is_coordinate_error
+{
+  __host__ __device__
+  bool operator()(const int status) const
+  {
+    return status != COORDINATE_OK && status != COORDINATE_INEXACT;
+  }
+};
+
+struct is_off_diagonal_entry
+{
+  template <typename Tuple>
+  __host__ __device__
+  bool operator()(const Tuple& t) const
+  {
+    return thrust::get<0>(t) != thrust::get<1>(t);
+  }
+};
+
+// copy the text to the device, staged through page-locked memory in chunks
+inline void upload_text(cusp::array1d<char,cusp::device_memory>& text, const char * first, const char * last)
+{
+  text.resize(last - first, cusp::uninitialized);
+
+  if (text.size() == 0)
+    return;
+
+#ifdef __CUSP_USE_STAGED_COPY__
+  if (cusp::detail::device::staged_copy_to_device(thrust::raw_pointer_cast(&text[0]), first, text.size()))
+    return;
+#endif
+
+  thrust::copy(first, last, text.begin());
+}
+
+// parse the lines of [first, last) marked COORDINATE_INEXACT on the host,
+// where the values can be converted by strtod
+template <typename IndexType, typename ValueType>
+void parse_inexact_entries(cusp::coo_matrix<IndexType,ValueType,cusp::device_memory>& coo,
+                           const char * first, const char * last,
+                           const cusp::array1d<size_t,cusp::device_memory>& lines,
+                           const cusp::array1d<int,cusp::device_memory>& status,
+                           const matrix_market_banner& banner)
+{
+  const size_t num_inexact = thrust::count(status.begin(), status.end(), int(COORDINATE_INEXACT));
+
+  if (num_inexact == 0)
+    return;
+
+  cusp::array1d<size_t,cusp::device_memory> positions(num_inexact);
+  thrust::copy_if(thrust::counting_iterator<size_t>(0), thrust::counting_iterator<size_t>(status.size()),
+                  status.begin(), positions.begin(), thrust::placeholders::_1 == int(COORDINATE_INEXACT));
+
+  cusp::array1d<size_t,cusp::device_memory> inexact_lines(num_inexact);
+  thrust::gather(positions.begin(), positions.end(), lines.begin(), inexact_lines.begin());
+
+  cusp::array1d<size_t,cusp::host_memory> host_lines(inexact_lines);
+  cusp::coo_matrix<IndexType,ValueType,cusp::host_memory> entries(coo.num_rows, coo.num_cols, num_inexact);
+
+  for (size_t n = 0; n < num_inexact; n++)
+  {
+    const char * p = first + host_lines[n];
+
+    throw_coordinate_parse_error(parse_coordinate_entry(entries, p, line_end(p, last), n,
+                                                        banner.type == "pattern", banner.type == "complex"));
+  }
+
+  cusp::coo_matrix<IndexType,ValueType,cusp::device_memory> device_entries(entries);
+
+  thrust::scatter(device_entries.row_indices.begin(),    device_entries.row_indices.end(),    positions.begin(), coo.row_indices.begin());
+  thrust::scatter(device_entries.column_indices.begin(), device_entries.column_indices.end(), positions.begin(), coo.column_indices.begin());
+  thrust::scatter(device_entries.values.begin(),         device_entries.values.end(),         positions.begin(), coo.values.begin());
+}
+
+// append the transpose of the off-diagonal entries of a symmetric matrix
+template <typename IndexType, typename ValueType>
+void expand_symmetric_entries(cusp::coo_matrix<IndexType,ValueType,cusp::device_memory>& coo)
+{
+  const size_t num_entries = coo.num_entries;
+
+  const size_t num_off_diagonals =
+    thrust::count_if(thrust::make_zip_iterator(thrust::make_tuple(coo.row_indices.begin(), coo.column_indices.begin())),
+                     thrust::make_zip_iterator(thrust::make_tuple(coo.row_indices.end(),   coo.column_indices.end())),
+                     is_off_diagonal_entry());
+
+  coo.resize(coo.num_rows, coo.num_cols, num_entries + num_off_diagonals);
+
+  thrust::copy_if(thrust::make_zip_iterator(thrust::make_tuple(coo.column_indices.begin(), coo.row_indices.begin(), coo.values.begin())),
+                  thrust::make_zip_iterator(thrust::make_tuple(coo.column_indices.begin(), coo.row_indices.begin(), coo.values.begin())) + num_entries,
+                  thrust::make_zip_iterator(thrust::make_tuple(coo.row_indices.begin(), coo.column_indices.begin())),
+                  thrust::make_zip_iterator(thrust::make_tuple(coo.row_indices.begin(), coo.column_indices.begin(), coo.values.begin())) + num_entries,
+                  is_off_diagonal_entry());
+}
+
+// read the size line and entries following the banner from host memory
+// into a device matrix
+template <typename IndexType, typename ValueType>
+void read_coordinate_buffer(cusp::coo_matrix<IndexType,ValueType,cusp::device_memory>& coo,
+                            const char * first, const char * last,
+                            const matrix_market_banner& banner)
+{
+  check_coordinate_banner(banner);
+
+  size_t num_rows, num_cols, num_entries;
+
+  first = read_coordinate_size(first, last, num_rows, num_cols, num_entries);
+
+  cusp::array1d<char,cusp::device_memory> text;
+  upload_text(text, first, last);
+
+  const size_t length = text.size();
+  const char * text_ptr = length == 0 ? NULL : thrust::raw_pointer_cast(&text[0]);
+
+  // locate the entry lines
+  const size_t num_lines = thrust::count_if(thrust::counting_iterator<size_t>(0), thrust::counting_iterator<size_t>(length),
+                                            is_entry_line_start(text_ptr, length));
+
+  if (num_lines < num_entries)
+    throw cusp::io_exception("unexpected EOF while reading MatrixMarket entries");
+
+  cusp::array1d<size_t,cusp::device_memory> lines(num_lines, cusp::uninitialized);
+  thrust::copy_if(thrust::counting_iterator<size_t>(0), thrust::counting_iterator<size_t>(length),
+                  lines.begin(), is_entry_line_start(text_ptr, length));
+
+  // parse one entry per line
+  coo.resize(num_rows, num_cols, num_entries);
+
+  if (num_entries > 0)
+  {
+    cusp::array1d<int,cusp::device_memory> status(num_entries, cusp::uninitialized);
+
+    thrust::for_each(thrust::counting_iterator<size_t>(0), thrust::counting_iterator<size_t>(num_entries),
+                     parse_coordinate_line<IndexType,ValueType>(text_ptr, length, thrust::raw_pointer_cast(&lines[0]),
+                                                                banner.type == "pattern", banner.type == "complex",
+                                                                num_rows, num_cols,
+                                                                thrust::raw_pointer_cast(&coo.row_indices[0]),
+                                                                thrust::raw_pointer_cast(&coo.column_indices[0]),
+                                                                thrust::raw_pointer_cast(&coo.values[0]),
+                                                                thrust::raw_pointer_cast(&status[0])));
+
+    // report the first invalid entry
+    cusp::array1d<int,cusp::device_memory>::iterator error = thrust::find_if(status.begin(), status.end(), is_coordinate_error());
+
+    if (error != status.end())
+      throw_coordinate_parse_error(*error);
+
+    parse_inexact_entries(coo, first, last, lines, status, banner);
+  }
+
+  // expand symmetric formats to "general" format
+  if (banner.symmetry == "symmetric")
+    expand_symmetric_entries(coo);
 
   // sort indices by (row,column)
   coo.sort_by_row_and_column();
-} 
+}
 
 template <typename ValueType, typename Stream>
 void read_array_stream(cusp::array2d<ValueType,cusp::host_memory>& mtx, Stream& input, const matrix_market_banner& banner)
@@ -354,6 +970,195 @@ void read_array_stream(cusp::array2d<ValueType,cusp::host_memory>& mtx, Stream&
 
 
 
+////////////////////////
+// Entry Formatting   //
+////////////////////////
+
+// upper bound on the characters written for one formatted scalar
+const size_t max_formatted_scalar = 32;
+
+// writes the decimal digits of value and advances p
+inline void format_integer(char *& p, unsigned long long value)
+{
+  char digits[24];
+  int n = 0;
+
+  do
+  {
+    digits[n++] = char('0' + value % 10);
+    value /= 10;
+  } while (value != 0);
+
+  while (n > 0)
+    *p++ = digits[--n];
+}
+
+inline void format_integer(char *& p, long long value)
+{
+  if (value < 0)
+  {
+    *p++ = '-';
+    format_integer(p, static_cast<unsigned long long>(-(value + 1)) + 1);
+  }
+  else
+    format_integer(p, static_cast<unsigned long long>(value));
+}
+
+// writes m * 10^k in the style of printf("%g"), where m has no trailing zeros
+inline void format_decimal(char *& p, unsigned long long m, int k)
+{
+  char digits[24];
+  char * q = digits;
+  format_integer(q, m);
+
+  int n = int(q - digits);
+
+  // exponent of the leading digit
+  int e = k + n - 1;
+
+  if (e < -5 || e >= 17)
+  {
+    *p++ = digits[0];
+
+    if (n > 1)
+    {
+      *p++ = '.';
+      for (int i = 1; i < n; i++)
+        *p++ = digits[i];
+    }
+
+    *p++ = 'e';
+    *p++ = e < 0 ? '-' : '+';
+    if (e < 0) e = -e;
+    if (e < 10) *p++ = '0';
+    format_integer(p, static_cast<unsigned long long>(e));
+  }
+  else if (k >= 0)
+  {
+    for (int i = 0; i < n; i++) *p++ = digits[i];
+    for (int i = 0; i < k; i++) *p++ = '0';
+  }
+  else if (e >= 0)
+  {
+    for (int i = 0; i <= e; i++) *p++ = digits[i];
+    *p++ = '.';
+    for (int i = e + 1; i < n; i++) *p++ = digits[i];
+  }
+  else
+  {
+    *p++ = '0';
+    *p++ = '.';
+    for (int i = -1; i > e; i--) *p++ = '0';
+    for (int i = 0; i < n; i++) *p++ = digits[i];
+  }
+}
+
+// attempts to write x with the given number of significant digits such that
+// the text reads back as exactly the same ScalarType value
+template <typename ScalarType>
+bool format_exact(char *& p, double x, int precision)
+{
+  static const double powers_of_ten[] =
+    {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+     1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+  // x = m * 10^k with m < 10^precision
+  int k = int(std::floor(std::log10(x))) - (precision - 1);
+
+  if (k < -22 || k > 22)
+    return false;
+
+  double scaled = k < 0 ? x * powers_of_ten[-k] : x / powers_of_ten[k];
+
+  unsigned long long m = static_cast<unsigned long long>(scaled + 0.5);
+
+  if (m == 0 || m >= (1ULL << 53))
+    return false;
+
+  // the product is exact and correctly rounded, as in scan_real
+  double y = static_cast<double>(m);
+  y = k < 0 ? y / powers_of_ten[-k] : y * powers_of_ten[k];
+
+  if (static_cast<ScalarType>(y) != static_cast<ScalarType>(x))
+    return false;
+
+  while (m % 10 == 0)
+  {
+    m /= 10;
+    k++;
+  }
+
+  format_decimal(p, m, k);
+
+  return true;
+}
+
+// writes the shortest of digits10 and max_digits10 significant digits which
+// reads back as the same value, using printf for the remaining cases
+template <typename ScalarType>
+void format_real(char *& p, const ScalarType& value)
+{
+  const int digits10     = std::numeric_limits<ScalarType>::digits10;
+  const int max_digits10 = std::numeric_limits<ScalarType>::is_integer ?
+                           digits10 + 1 : 2 + std::numeric_limits<ScalarType>::digits * 30103 / 100000;
+
+  double x = static_cast<double>(value);
+
+  if (x == 0)
+  {
+    if (1 / x < 0) *p++ = '-';
+    *p++ = '0';
+    return;
+  }
+
+  if (x == x && x - x == 0)
+  {
+    char * q = p;
+
+    if (x < 0)
+    {
+      *q++ = '-';
+      x = -x;
+    }
+
+    if (format_exact<ScalarType>(q, x, digits10 < 15 ? digits10 : 15) ||
+        (max_digits10 <= 15 && format_exact<ScalarType>(q, x, max_digits10)))
+    {
+      p = q;
+      return;
+    }
+
+    x = static_cast<double>(value);
+  }
+
+  p += std::sprintf(p, "%.*g", max_digits10, x);
+}
+
+template <typename ScalarType>
+void format_value(char *& p, const ScalarType& value)
+{
+  format_real(p, value);
+}
+
+template <typename ScalarType>
+void format_value(char *& p, const cusp::complex<ScalarType>& value)
+{
+  format_real(p, value.real());
+  *p++ = ' ';
+  format_real(p, value.imag());
+}
+
+template <typename Stream, typename ValueType>
+void write_value(Stream& output, const ValueType& value)
+{
+  char buffer[2 * max_formatted_scalar];
+  char * p = buffer;
+
+  format_value(p, value);
+
+  output.write(buffer, p - buffer);
+}
+
 template <typename IndexType, typename ValueType, typename Stream>
 void write_coordinate_stream(const cusp::coo_matrix<IndexType,ValueType,cusp::host_memory>& coo, Stream& output)
 {
@@ -366,12 +1171,47 @@ void write_coordinate_stream(const cusp::coo_matrix<IndexType,ValueType,cusp::ho
 
   output << "\t" << coo.num_rows << "\t" << coo.num_cols << "\t" << coo.num_entries << "\n";
 
-  for(size_t i = 0; i < coo.num_entries; i++)
+  // each entry holds two indices, one or two values and three separators
+  const size_t max_entry_length = 2 * 21 + 2 * max_formatted_scalar + 3;
+
+  const size_t chunk_size = 1 << 13;
+  const size_t num_chunks = (coo.num_entries + chunk_size - 1) / chunk_size;
+  const size_t num_buffers = std::min<size_t>(2 * num_parse_threads(), num_chunks);
+
+  std::vector< std::vector<char> > buffers(num_buffers, std::vector<char>(chunk_size * max_entry_length));
+  std::vector<size_t> lengths(num_buffers);
+
+  // format a batch of chunks in parallel, then write them in order
+  for (size_t batch = 0; batch < num_chunks; batch += num_buffers)
   {
-    output << (coo.row_indices[i]    + 1) << " ";
-    output << (coo.column_indices[i] + 1) << " ";
-    cusp::io::detail::write_value(output, coo.values[i]);
-    output << "\n";
+    const long batch_size = long(std::min(num_buffers, num_chunks - batch));
+
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(dynamic)
+#endif
+    for (long b = 0; b < batch_size; b++)
+    {
+      const size_t begin = (batch + b) * chunk_size;
+      const size_t end   = std::min<size_t>(begin + chunk_size, coo.num_entries);
+
+      char * first = &buffers[b][0];
+      char * p     = first;
+
+      for (size_t n = begin; n < end; n++)
+      {
+        format_integer(p, static_cast<long long>(coo.row_indices[n])    + 1);
+        *p++ = ' ';
+        format_integer(p, static_cast<long long>(coo.column_indices[n]) + 1);
+        *p++ = ' ';
+        format_value(p, coo.values[n]);
+        *p++ = '\n';
+      }
+
+      lengths[b] = p - first;
+    }
+
+    for (long b = 0; b < batch_size; b++)
+      output.write(&buffers[b][0], lengths[b]);
   }
 }
 
@@ -418,6 +1258,66 @@ void read_matrix_market_stream(Matrix& mtx, Stream& input, cusp::array1d_format)
   cusp::convert(temp, mtx);
 }
 
+// device matrices are parsed on the device, all others on the host
+template <typename MemorySpace>
+struct coordinate_memory_space
+{
+  typedef typename thrust::detail::eval_if<
+    thrust::detail::is_convertible<MemorySpace,cusp::device_memory>::value,
+    thrust::detail::identity_<cusp::device_memory>,
+    thrust::detail::identity_<cusp::host_memory>
+  >::type type;
+};
+
+template <typename Matrix, typename Format>
+void read_matrix_market_buffer(Matrix& mtx, const char * first, const char * last, Format)
+{
+  // general case
+  typedef typename Matrix::index_type IndexType;
+  typedef typename Matrix::value_type ValueType;
+
+  // read banner
+  std::istringstream banner_line(std::string(first, line_end(first, last)));
+
+  matrix_market_banner banner;
+  read_matrix_market_banner(banner, banner_line);
+
+  first = next_line(first, last);
+
+  if (banner.storage == "coordinate")
+  {
+    // parse the entries in the memory space of the matrix
+    cusp::coo_matrix<IndexType,ValueType,typename coordinate_memory_space<typename Matrix::memory_space>::type> temp;
+
+    read_coordinate_buffer(temp, first, last, banner);
+
+    cusp::convert(temp, mtx);
+  }
+  else // banner.storage == "array"
+  {
+    std::istringstream input(std::string(first, last));
+
+    cusp::array2d<ValueType,cusp::host_memory> temp;
+
+    read_array_stream(temp, input, banner);
+
+    cusp::convert(temp, mtx);
+  }
+}
+
+template <typename Matrix>
+void read_matrix_market_buffer(Matrix& mtx, const char * first, const char * last, cusp::array1d_format)
+{
+  // array1d case
+  typedef typename Matrix::value_type ValueType;
+
+  cusp::array2d<ValueType,cusp::host_memory> temp;
+
+  read_matrix_market_buffer(temp, first, last, cusp::array2d_format());
+
+  cusp::convert(temp, mtx);
+}
+
 template <typename Matrix, typename Stream>
 void write_matrix_market_stream(const Matrix& mtx, Stream& output, cusp::sparse_format)
 {
@@ -481,23 +1381,25 @@ void write_matrix_market_stream(const Matrix& mtx, Stream& output, cusp::array2d
 template <typename Matrix>
 void read_matrix_market_file(Matrix& mtx, const std::string& filename)
 {
-  std::ifstream file(filename.c_str());
+  // parse the file contents directly from memory
+  cusp::io::detail::mapped_file file(filename);
 
-  if (!file)
-    throw cusp::io_exception(std::string("unable to open file \"") + filename + std::string("\" for reading"));
+  const int compression = cusp::io::detail::compression_from_contents(file.begin(), file.size());
 
-#ifdef __APPLE__
-  // WAR OSX-specific issue using rdbuf
-  std::stringstream file_string (std::stringstream::in | std::stringstream::out);
-  std::vector<char> buffer(file.rdbuf()->pubseekoff(0, std::ios::end,std::ios::in));
-  file.rdbuf()->pubseekpos(0, std::ios::in);
-  file.rdbuf()->sgetn(&buffer[0], buffer.size());
-  file_string.write(&buffer[0], buffer.size());
+  if (compression != cusp::io::detail::COMPRESSION_NONE)
+  {
+    std::vector<char> contents;
 
-  cusp::io::read_matrix_market_stream(mtx, file_string);
-#else
-  cusp::io::read_matrix_market_stream(mtx, file);
-#endif
+    cusp::io::detail::decompress(compression, file.begin(), file.end(), contents);
+
+    const char * first = contents.empty() ? file.end() : &contents[0];
+
+    cusp::io::detail::read_matrix_market_buffer(mtx, first, first + contents.size(), typename Matrix::format());
+
+    return;
+  }
+
+  cusp::io::detail::read_matrix_market_buffer(mtx, file.begin(), file.end(), typename Matrix::format());
 }
 
 template <typename Matrix, typename Stream>
@@ -509,6 +1411,19 @@ void read_matrix_market_stream(Matrix& mtx, Stream& input)
 template <typename Matrix>
 void write_matrix_market_file(const Matrix& mtx, const std::string& filename)
 {
+  const int compression = cusp::io::detail::compression_from_file_name(filename);
+
+  if (compression != cusp::io::detail::COMPRESSION_NONE)
+  {
+    cusp::io::detail::compressed_ostream file(filename, compression);
+
+    cusp::io::write_matrix_market_stream(mtx, file);
+
+    file.close();
+
+    return;
+  }
+
   std::ofstream file(filename.c_str());
 
   if (!file)
@@ -535,3 +1450,4 @@ void write_matrix_market_stream(const Matrix& mtx, Stream& output)
 } //end namespace io
 } //end namespace cusp
 
+#undef __CUSP_USE_STAGED_COPY__
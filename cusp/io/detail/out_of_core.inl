@@ -0,0 +1,373 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include <cusp/coo_matrix.h>
+#include <cusp/exception.h>
+
+#include <cusp/io/binary.h>
+#include <cusp/io/matrix_market.h>
+#include <cusp/io/detail/mapped_file.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace cusp
+{
+namespace io
+{
+namespace detail
+{
+
+template <typename IndexType, typename ValueType>
+struct assembly_entry
+{
+  IndexType row;
+  IndexType column;
+  ValueType value;
+};
+
+// sorted runs of entries spilled one after another to an anonymous
+// temporary file
+template <typename IndexType, typename ValueType>
+class assembly_spill
+{
+  typedef assembly_entry<IndexType,ValueType> entry;
+
+  FILE * file;
+  size_t num_entries;
+
+  public:
+  assembly_spill(void)
+    : file(std::tmpfile()), num_entries(0)
+  {
+    if (!file)
+      throw cusp::io_exception("unable to create a temporary file for out-of-core assembly");
+  }
+
+  ~assembly_spill(void)
+  {
+    std::fclose(file);
+  }
+
+  // append the entries of coo and return the position of the first one
+  size_t append(const cusp::coo_matrix<IndexType,ValueType,cusp::host_memory>& coo)
+  {
+    const size_t begin = num_entries;
+
+    std::vector<entry> block(std::min(size_t(1) << 16, size_t(coo.num_entries)));
+
+    seek(begin);
+
+    for (size_t n = 0; n < coo.num_entries; n += block.size())
+    {
+      const size_t count = std::min(block.size(), size_t(coo.num_entries) - n);
+
+      for (size_t i = 0; i < count; i++)
+      {
+        block[i].row    = coo.row_indices[n + i];
+        block[i].column = coo.column_indices[n + i];
+        block[i].value  = coo.values[n + i];
+      }
+
+      if (std::fwrite(&block[0], sizeof(entry), count, file) != count)
+        throw cusp::io_exception("unable to write a temporary file for out-of-core assembly");
+    }
+
+    num_entries += coo.num_entries;
+
+    return begin;
+  }
+
+  void read(size_t position, size_t count, entry * result)
+  {
+    seek(position);
+
+    if (std::fread(result, sizeof(entry), count, file) != count)
+      throw cusp::io_exception("unable to read a temporary file for out-of-core assembly");
+  }
+
+  private:
+  void seek(size_t position)
+  {
+#if defined(_WIN32)
+    int status = _fseeki64(file, (__int64) position * sizeof(entry), SEEK_SET);
+#elif defined(__unix__) || defined(__APPLE__)
+    int status = fseeko(file, (off_t) position * sizeof(entry), SEEK_SET);
+#else
+    int status = std::fseek(file, (long) (position * sizeof(entry)), SEEK_SET);
+#endif
+
+    if (status != 0)
+      throw cusp::io_exception("unable to seek in a temporary file for out-of-core assembly");
+  }
+
+  // not copyable
+  assembly_spill(const assembly_spill&);
+  assembly_spill& operator=(const assembly_spill&);
+};
+
+// buffered reads of one run of the spill file
+template <typename IndexType, typename ValueType>
+class assembly_run
+{
+  typedef assembly_entry<IndexType,ValueType> entry;
+
+  size_t next_read;
+  size_t end;
+  size_t position;
+  std::vector<entry> buffer;
+
+  public:
+  assembly_run(size_t begin, size_t end)
+    : next_read(begin), end(end), position(0) {}
+
+  void reserve(size_t buffer_size)
+  {
+    buffer.reserve(std::max(size_t(1), std::min(buffer_size, end - next_read)));
+  }
+
+  bool next(assembly_spill<IndexType,ValueType>& spill, entry& e)
+  {
+    if (position == buffer.size())
+    {
+      if (next_read == end)
+        return false;
+
+      buffer.resize(std::min(buffer.capacity(), end - next_read));
+      spill.read(next_read, buffer.size(), &buffer[0]);
+
+      next_read += buffer.size();
+      position   = 0;
+    }
+
+    e = buffer[position++];
+
+    return true;
+  }
+};
+
+// buffered writes to one array of a binary file
+template <typename T>
+class binary_array_writer
+{
+  std::ofstream& output;
+  unsigned long long position;
+  std::vector<T> buffer;
+
+  public:
+  binary_array_writer(std::ofstream& output, unsigned long long offset)
+    : output(output), position(offset)
+  {
+    buffer.reserve(1 << 16);
+  }
+
+  void push_back(const T& value)
+  {
+    buffer.push_back(value);
+
+    if (buffer.size() == buffer.capacity())
+      flush();
+  }
+
+  void flush(void)
+  {
+    if (buffer.empty())
+      return;
+
+    output.seekp(position);
+    output.write(reinterpret_cast<const char *>(&buffer[0]), buffer.size() * sizeof(T));
+
+    position += buffer.size() * sizeof(T);
+    buffer.clear();
+  }
+};
+
+} // end namespace detail
+
+template <typename IndexType, typename ValueType>
+void convert_matrix_market_to_binary(const std::string& input_filename,
+                                     const std::string& output_filename,
+                                     size_t max_memory)
+{
+  typedef cusp::io::detail::assembly_entry<IndexType,ValueType> entry;
+  typedef cusp::io::detail::assembly_run<IndexType,ValueType>   run;
+
+  cusp::io::detail::mapped_file file(input_filename);
+
+  const char * first = file.begin();
+  const char * last  = file.end();
+
+  // read banner
+  std::istringstream banner_line(std::string(first, cusp::io::detail::line_end(first, last)));
+
+  cusp::io::detail::matrix_market_banner banner;
+  cusp::io::detail::read_matrix_market_banner(banner, banner_line);
+
+  if (banner.storage != "coordinate")
+    throw cusp::io_exception("out-of-core assembly requires a coordinate MatrixMarket file");
+
+  cusp::io::detail::check_coordinate_banner(banner);
+
+  size_t num_rows, num_cols, num_entries;
+
+  first = cusp::io::detail::next_line(first, last);
+  first = cusp::io::detail::read_coordinate_size(first, last, num_rows, num_cols, num_entries);
+
+  // a chunk is held as parsed entries, their symmetric expansion and the
+  // sorted copy, and every entry line has at least four characters
+  const size_t expansion   = banner.symmetry == "symmetric" ? 2 : 1;
+  const size_t entry_bytes = 2 * sizeof(IndexType) + sizeof(ValueType);
+  const size_t run_entries = std::max(size_t(1), max_memory / (3 * expansion * entry_bytes));
+  const size_t run_bytes   = 4 * run_entries;
+
+  // parse, sort and spill the chunks
+  cusp::io::detail::assembly_spill<IndexType,ValueType> spill;
+  std::vector<run> runs;
+
+  size_t num_entries_read = 0;
+  size_t total_entries    = 0;
+
+  while (first != last && num_entries_read < num_entries)
+  {
+    const char * chunk_end = last;
+
+    if (size_t(last - first) > run_bytes)
+      chunk_end = cusp::io::detail::next_line(first + run_bytes - 1, last);
+
+    cusp::coo_matrix<IndexType,ValueType,cusp::host_memory> coo(num_rows, num_cols, 0);
+
+    cusp::io::detail::parse_coordinate_block(coo, first, chunk_end, num_entries - num_entries_read, banner);
+
+    num_entries_read += coo.num_entries;
+
+    if (banner.symmetry == "symmetric")
+      cusp::io::detail::expand_symmetric_entries(coo);
+
+    if (coo.num_entries > 0)
+    {
+      coo.sort_by_row_and_column();
+
+      const size_t begin = spill.append(coo);
+      runs.push_back(run(begin, begin + coo.num_entries));
+
+      total_entries += coo.num_entries;
+    }
+
+    first = chunk_end;
+  }
+
+  if (num_entries_read != num_entries)
+    throw cusp::io_exception("unexpected EOF while reading MatrixMarket entries");
+
+  if (total_entries > size_t(std::numeric_limits<IndexType>::max()))
+    throw cusp::io_exception("number of entries exceeds the range of the index type");
+
+  // lay out the CSR arrays of the binary file
+  cusp::io::detail::binary_header header;
+  cusp::io::detail::initialize_binary_header(header, cusp::io::detail::BINARY_CSR,
+                                             sizeof(IndexType), sizeof(ValueType),
+                                             cusp::io::detail::binary_kind<ValueType>(),
+                                             num_rows, num_cols, total_entries);
+
+  header.num_arrays = 3;
+
+  header.arrays[0].size  = num_rows + 1;
+  header.arrays[0].width = sizeof(IndexType);
+  header.arrays[1].size  = total_entries;
+  header.arrays[1].width = sizeof(IndexType);
+  header.arrays[2].size  = total_entries;
+  header.arrays[2].width = sizeof(ValueType);
+
+  for (int i = 0; i < 3; i++)
+  {
+    header.arrays[i].num_rows = header.arrays[i].size;
+    header.arrays[i].num_cols = 1;
+    header.arrays[i].pitch    = header.arrays[i].size;
+  }
+
+  cusp::io::detail::assign_binary_offsets(header);
+
+  std::ofstream output(output_filename.c_str(), std::ios::out | std::ios::binary);
+
+  if (!output)
+    throw cusp::io_exception(std::string("unable to open file \"") + output_filename + std::string("\" for writing"));
+
+  output.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+  cusp::io::detail::binary_array_writer<IndexType> row_offsets(output, header.arrays[0].offset);
+  cusp::io::detail::binary_array_writer<IndexType> column_indices(output, header.arrays[1].offset);
+  cusp::io::detail::binary_array_writer<ValueType> values(output, header.arrays[2].offset);
+
+  // k-way merge of the sorted runs, ties taken in file order
+  typedef std::pair<std::pair<IndexType,IndexType>, size_t> key;
+
+  std::priority_queue<key, std::vector<key>, std::greater<key> > heap;
+  std::vector<entry> heads(runs.size());
+
+  for (size_t r = 0; r < runs.size(); r++)
+  {
+    runs[r].reserve(run_entries / runs.size());
+
+    if (runs[r].next(spill, heads[r]))
+      heap.push(key(std::make_pair(heads[r].row, heads[r].column), r));
+  }
+
+  size_t row = 0;
+  size_t nnz = 0;
+
+  row_offsets.push_back(0);
+
+  while (!heap.empty())
+  {
+    const size_t r = heap.top().second;
+    heap.pop();
+
+    const entry& e = heads[r];
+
+    for (; row < size_t(e.row); row++)
+      row_offsets.push_back(nnz);
+
+    column_indices.push_back(e.column);
+    values.push_back(e.value);
+    nnz++;
+
+    if (runs[r].next(spill, heads[r]))
+      heap.push(key(std::make_pair(heads[r].row, heads[r].column), r));
+  }
+
+  for (; row < num_rows; row++)
+    row_offsets.push_back(nnz);
+
+  row_offsets.flush();
+  column_indices.flush();
+  values.flush();
+
+  if (!output)
+    throw cusp::io_exception(std::string("unable to write file \"") + output_filename + std::string("\""));
+}
+
+} //end namespace io
+} //end namespace cusp
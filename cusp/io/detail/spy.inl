@@ -0,0 +1,285 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+#pragma once
+
+#include <cusp/array1d.h>
+#include <cusp/csr_matrix.h>
+#include <cusp/exception.h>
+#include <cusp/format.h>
+
+#include <cusp/opengl/spy/density.h>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#ifdef __CUSP_USE_ZLIB__
+#include <zlib.h>
+#endif
+
+namespace cusp
+{
+namespace io
+{
+namespace detail
+{
+
+// shade of each bin of the pattern of mtx, 255 for an empty bin and 0 for
+// a full one, on a log scale of the fraction of its cells holding an entry
+template <typename Matrix>
+void spy_image(const Matrix& mtx, const size_t max_size,
+               std::vector<unsigned char>& image, size_t& width, size_t& height,
+               cusp::csr_format)
+{
+  const size_t num_rows = mtx.num_rows;
+  const size_t num_cols = mtx.num_cols;
+  const size_t size     = std::max<size_t>(max_size, 1);
+
+  const size_t bin = std::max<size_t>(1, std::max((num_rows + size - 1) / size, (num_cols + size - 1) / size));
+
+  width  = (num_cols + bin - 1) / bin;
+  height = (num_rows + bin - 1) / bin;
+
+  if (width == 0 || height == 0)
+  {
+    width = height = 1;
+    image.assign(1, 255);
+    return;
+  }
+
+  cusp::array1d<unsigned int,cusp::host_memory> counts;
+  cusp::opengl::spy::bin_density(mtx, 0, 0, bin, bin, height, width, counts);
+
+  const double inv_log_capacity = 1.0 / std::log(1.0 + double(bin) * double(bin));
+
+  image.resize(width * height);
+
+  for (size_t i = 0; i < image.size(); i++)
+  {
+    if (counts[i] == 0)
+    {
+      image[i] = 255;
+    }
+    else
+    {
+      const double v = std::min(1.0, std::log(1.0 + double(counts[i])) * inv_log_capacity);
+      image[i] = (unsigned char)(200.0 * (1.0 - v));
+    }
+  }
+}
+
+template <typename Matrix>
+void spy_image(const Matrix& mtx, const size_t max_size,
+               std::vector<unsigned char>& image, size_t& width, size_t& height,
+               cusp::known_format)
+{
+  // other formats are binned as CSR
+  cusp::csr_matrix<typename Matrix::index_type,typename Matrix::value_type,typename Matrix::memory_space> csr(mtx);
+
+  spy_image(csr, max_size, image, width, height, cusp::csr_format());
+}
+
+inline void append_be32(std::vector<unsigned char>& bytes, const unsigned int value)
+{
+  bytes.push_back((unsigned char)(value >> 24));
+  bytes.push_back((unsigned char)(value >> 16));
+  bytes.push_back((unsigned char)(value >> 8));
+  bytes.push_back((unsigned char)(value));
+}
+
+inline unsigned int png_crc(const std::vector<unsigned char>& bytes)
+{
+  unsigned int table[256];
+
+  for (unsigned int n = 0; n < 256; n++)
+  {
+    unsigned int c = n;
+
+    for (int k = 0; k < 8; k++)
+      c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+
+    table[n] = c;
+  }
+
+  unsigned int crc = 0xffffffffu;
+
+  for (size_t i = 0; i < bytes.size(); i++)
+    crc = table[(crc ^ bytes[i]) & 0xff] ^ (crc >> 8);
+
+  return crc ^ 0xffffffffu;
+}
+
+inline void write_png_chunk(std::ofstream& file, const char * type, const std::vector<unsigned char>& data)
+{
+  std::vector<unsigned char> chunk(type, type + 4);
+  chunk.insert(chunk.end(), data.begin(), data.end());
+
+  std::vector<unsigned char> header;
+  append_be32(header, (unsigned int) data.size());
+
+  std::vector<unsigned char> crc;
+  append_be32(crc, png_crc(chunk));
+
+  file.write((const char *) &header[0], header.size());
+  file.write((const char *) &chunk[0], chunk.size());
+  file.write((const char *) &crc[0], crc.size());
+}
+
+// zlib stream of the scanlines
+inline void png_deflate(const std::vector<unsigned char>& raw, std::vector<unsigned char>& stream)
+{
+#ifdef __CUSP_USE_ZLIB__
+  uLongf length = compressBound(raw.size());
+  stream.resize(length);
+
+  if (compress2(&stream[0], &length, &raw[0], raw.size(), Z_BEST_SPEED) != Z_OK)
+    throw cusp::io_exception("unable to compress the image");
+
+  stream.resize(length);
+#else
+  // stored deflate blocks, which need no compressor
+  stream.clear();
+  stream.push_back(0x78);
+  stream.push_back(0x01);
+
+  const size_t block_size = 65535;
+
+  for (size_t first = 0; first < raw.size(); first += block_size)
+  {
+    const size_t length = std::min(block_size, raw.size() - first);
+
+    stream.push_back(first + length == raw.size() ? 1 : 0);
+    stream.push_back((unsigned char)(length));
+    stream.push_back((unsigned char)(length >> 8));
+    stream.push_back((unsigned char)(~length));
+    stream.push_back((unsigned char)(~length >> 8));
+    stream.insert(stream.end(), raw.begin() + first, raw.begin() + first + length);
+  }
+
+  unsigned int a = 1, b = 0;
+
+  for (size_t i = 0; i < raw.size(); i++)
+  {
+    a = (a + raw[i]) % 65521;
+    b = (b + a) % 65521;
+  }
+
+  append_be32(stream, (b << 16) | a);
+#endif
+}
+
+} // end namespace detail
+
+template <typename Matrix>
+void write_spy_png(const Matrix& mtx, const std::string& filename, const size_t max_size)
+{
+  std::vector<unsigned char> image;
+  size_t width, height;
+
+  cusp::io::detail::spy_image(mtx, max_size, image, width, height, typename Matrix::format());
+
+  // scanlines without filtering
+  std::vector<unsigned char> raw;
+  raw.reserve((width + 1) * height);
+
+  for (size_t y = 0; y < height; y++)
+  {
+    raw.push_back(0);
+    raw.insert(raw.end(), image.begin() + y * width, image.begin() + (y + 1) * width);
+  }
+
+  std::vector<unsigned char> ihdr;
+  cusp::io::detail::append_be32(ihdr, (unsigned int) width);
+  cusp::io::detail::append_be32(ihdr, (unsigned int) height);
+  ihdr.push_back(8); // bit depth
+  ihdr.push_back(0); // grayscale
+  ihdr.push_back(0); // deflate
+  ihdr.push_back(0); // no filtering
+  ihdr.push_back(0); // no interlace
+
+  std::vector<unsigned char> idat;
+  cusp::io::detail::png_deflate(raw, idat);
+
+  std::ofstream file(filename.c_str(), std::ios::out | std::ios::binary);
+
+  if (!file)
+    throw cusp::io_exception(std::string("unable to open file \"") + filename + std::string("\" for writing"));
+
+  const unsigned char signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+  file.write((const char *) signature, 8);
+
+  cusp::io::detail::write_png_chunk(file, "IHDR", ihdr);
+  cusp::io::detail::write_png_chunk(file, "IDAT", idat);
+  cusp::io::detail::write_png_chunk(file, "IEND", std::vector<unsigned char>());
+
+  if (!file)
+    throw cusp::io_exception(std::string("unable to write file \"") + filename + std::string("\""));
+}
+
+template <typename Matrix>
+void write_spy_svg(const Matrix& mtx, const std::string& filename, const size_t max_size)
+{
+  std::vector<unsigned char> image;
+  size_t width, height;
+
+  cusp::io::detail::spy_image(mtx, max_size, image, width, height, typename Matrix::format());
+
+  std::ofstream file(filename.c_str());
+
+  if (!file)
+    throw cusp::io_exception(std::string("unable to open file \"") + filename + std::string("\" for writing"));
+
+  file << "<?xml version=\"1.0\" standalone=\"no\"?>\n";
+  file << "<svg xmlns=\"http://www.w3.org/2000/svg\" version=\"1.1\" width=\"" << width << "\" height=\"" << height
+       << "\" viewBox=\"0 0 " << width << " " << height << "\" shape-rendering=\"crispEdges\">\n";
+  file << "<rect x=\"0\" y=\"0\" width=\"" << width << "\" height=\"" << height << "\" fill=\"rgb(255,255,255)\"/>\n";
+
+  // one rectangle per run of equal shades in a row
+  for (size_t y = 0; y < height; y++)
+  {
+    const unsigned char * row = &image[y * width];
+
+    for (size_t x = 0; x < width; )
+    {
+      size_t x_end = x + 1;
+
+      while (x_end < width && row[x_end] == row[x])
+        x_end++;
+
+      if (row[x] != 255)
+      {
+        const int g = row[x];
+
+        file << "<rect x=\"" << x << "\" y=\"" << y << "\" width=\"" << (x_end - x)
+             << "\" height=\"1\" fill=\"rgb(" << g << "," << g << "," << g << ")\"/>\n";
+      }
+
+      x = x_end;
+    }
+  }
+
+  file << "</svg>\n";
+
+  if (!file)
+    throw cusp::io_exception(std::string("unable to write file \"") + filename + std::string("\""));
+}
+
+} // end namespace io
+} // end namespace cusp
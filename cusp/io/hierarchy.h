@@ -0,0 +1,100 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*! \file hierarchy.h
+ *  \brief Binary file I/O of multilevel hierarchies
+ */
+
+#pragma once
+
+#include <cusp/detail/config.h>
+
+#include <cusp/multilevel.h>
+
+#include <string>
+
+namespace cusp
+{
+namespace io
+{
+
+/*! \addtogroup input_output Input/Output
+ *  \addtogroup binary Binary
+ *  \ingroup input_output
+ *  \{
+ */
+
+/*! \p write_hierarchy : Write a built \p multilevel hierarchy
+ *
+ * The operators of every level are written with \p write_binary_file to
+ * <tt>prefix.level<i>.A.bin</tt>, <tt>.R.bin</tt> and <tt>.P.bin</tt>,
+ * next to a text manifest <tt>prefix.hierarchy</tt> holding the cycle
+ * and the other settings of the hierarchy.  The state of \p jacobi
+ * smoothers (diagonal, omega and sweeps) and the inverse of a
+ * \p dense_inverse_solver are written as well; other smoothers and
+ * coarse solvers are rebuilt from the level operators when the
+ * hierarchy is read.
+ *
+ * \param M hierarchy, e.g. a \p smoothed_aggregation preconditioner
+ * \param prefix path prefix of the files
+ *
+ * \note existing files are overwritten
+ *
+ * \see \p read_hierarchy
+ */
+template <typename MatrixType, typename SmootherType, typename SolverType, typename ValueType>
+void write_hierarchy(const cusp::multilevel<MatrixType,SmootherType,SolverType,ValueType>& M,
+                     const std::string& prefix);
+
+/*! \p read_hierarchy : Read a hierarchy written by \p write_hierarchy
+ *
+ * The hierarchy is ready to use without any setup, which skips the
+ * construction of e.g. a \p smoothed_aggregation preconditioner when the
+ * same matrix is solved in many runs.  Host levels and graph capture
+ * are enabled again if they were enabled when the hierarchy was written.
+ *
+ * \code
+ * #include <cusp/io/hierarchy.h>
+ * #include <cusp/precond/aggregation/smoothed_aggregation.h>
+ *
+ * typedef cusp::precond::aggregation::smoothed_aggregation<int, float, cusp::device_memory> SA;
+ *
+ * // first run
+ * SA M(A);
+ * cusp::io::write_hierarchy(M, "A.amg");
+ *
+ * // later runs
+ * SA::hierarchy_type H;
+ * cusp::io::read_hierarchy(H, "A.amg");
+ * cusp::krylov::cg(A, x, b, monitor, H);
+ * \endcode
+ *
+ * \param M hierarchy of the same types as the one written
+ * \param prefix path prefix of the files
+ *
+ * \see \p write_hierarchy
+ */
+template <typename MatrixType, typename SmootherType, typename SolverType, typename ValueType>
+void read_hierarchy(cusp::multilevel<MatrixType,SmootherType,SolverType,ValueType>& M,
+                    const std::string& prefix);
+
+/*! \}
+ */
+
+} //end namespace io
+} //end namespace cusp
+
+#include <cusp/io/detail/hierarchy.inl>
@@ -42,6 +42,15 @@ namespace io
  * \tparam Matrix matrix container
  *
  * \note any contents of \p mtx will be overwritten
+ * \note the file is mapped into memory and the coordinate entries are
+ *       parsed in parallel when compiled with OpenMP support
+ * \note the coordinate entries of matrices in \p device_memory are parsed
+ *       on the device: the text is copied there through page-locked
+ *       buffers and each entry line is parsed by its own thread, except
+ *       for the rare values which need \c strtod
+ * \note gzip and zstd compressed files are recognized from their contents
+ *       and decompressed first, in parallel for files written by
+ *       \p write_matrix_market_file
  *
  * \code
  * #include <cusp/io/matrix_market.h>
@@ -100,6 +109,14 @@ void read_matrix_market_stream(Matrix& mtx, Stream& input);
  * \tparam Matrix matrix container
  *
  * \note if the file already exists it will be overwritten
+ * \note the coordinate entries are formatted in parallel when OpenMP is
+ *       enabled and the values are written with enough digits to be read
+ *       back exactly
+ * \note file names ending in ".gz" or ".zst" are written gzip or zstd
+ *       compressed, as independent blocks compressed in parallel.  This
+ *       requires zlib and \c __CUSP_USE_ZLIB__, or zstd and
+ *       \c __CUSP_USE_ZSTD__, to be defined; otherwise
+ *       \p not_implemented_exception is thrown
  *
  * \code
  * #include <cusp/io/matrix_market.h>
@@ -0,0 +1,87 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*! \file out_of_core.h
+ *  \brief Out-of-core assembly of MatrixMarket files
+ */
+
+#pragma once
+
+#include <cusp/detail/config.h>
+
+#include <string>
+
+namespace cusp
+{
+namespace io
+{
+
+/*! \addtogroup input_output Input/Output
+ *  \{
+ */
+
+/*! \p convert_matrix_market_to_binary : Assemble a MatrixMarket coordinate
+ *  file into a CSR binary file without holding the matrix in memory
+ *
+ * The entries are parsed in chunks that fit in \p max_memory bytes.  Each
+ * chunk is expanded (for symmetric files), sorted by row and column, and
+ * spilled to an anonymous temporary file.  The sorted runs are then merged
+ * and streamed into a binary file in the format of \p write_binary_file,
+ * holding a \p csr_matrix with the given index and value types.  The
+ * result can be loaded with \p read_binary_file or mapped with
+ * \p binary_file.
+ *
+ * \param input_filename file name of the MatrixMarket file
+ * \param output_filename file name of the binary file
+ * \param max_memory approximate bound on the memory used for the entries
+ * \tparam IndexType index type of the stored \p csr_matrix
+ * \tparam ValueType value type of the stored \p csr_matrix
+ *
+ * \note duplicate entries are kept, as with \p read_matrix_market_file
+ * \note the temporary files require roughly as much disk space as the
+ *       entries of the assembled matrix
+ *
+ * \code
+ * #include <cusp/io/out_of_core.h>
+ * #include <cusp/io/binary.h>
+ *
+ * int main(void)
+ * {
+ *     // assemble with at most 4GB of entries in memory
+ *     cusp::io::convert_matrix_market_to_binary<long long, double>("A.mtx", "A.bin", size_t(4) << 30);
+ *
+ *     cusp::io::binary_file file("A.bin");
+ *     cusp::io::binary_file::csr_view<long long, double>::type A = file.make_csr_view<long long, double>();
+ *
+ *     return 0;
+ * }
+ * \endcode
+ *
+ * \see \p write_binary_file
+ * \see \p read_matrix_market_file
+ */
+template <typename IndexType, typename ValueType>
+void convert_matrix_market_to_binary(const std::string& input_filename,
+                                     const std::string& output_filename,
+                                     size_t max_memory = size_t(1) << 30);
+
+/*! \}
+ */
+
+} //end namespace io
+} //end namespace cusp
+
+#include <cusp/io/detail/out_of_core.inl>
@@ -0,0 +1,90 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+/*! \file spy.h
+ *  \brief Images of the sparsity pattern of a matrix
+ */
+
+#pragma once
+
+#include <cusp/detail/config.h>
+
+#include <string>
+
+namespace cusp
+{
+namespace io
+{
+
+/*! \addtogroup input_output Input/Output
+ *  \addtogroup spy Sparsity Pattern Images
+ *  \ingroup input_output
+ *  \{
+ */
+
+/*! \p write_spy_png : Write the sparsity pattern of a matrix as a PNG image
+ *
+ * The matrix is divided into square bins of cells so that the image is at
+ * most \p max_size pixels on a side, and each pixel is shaded by the
+ * fraction of the cells of its bin holding an entry, on a log scale, from
+ * white for an empty bin to black for a full one.  Matrices with at most
+ * \p max_size rows and columns are drawn one pixel per cell.  The entries
+ * are binned in the memory space of the matrix in time linear in their
+ * number, in parallel on the device or with OpenMP on the host, so the
+ * cost does not depend on the size of the image.
+ *
+ * \param mtx a matrix container (e.g. \p csr_matrix or \p coo_matrix)
+ * \param filename file name of the image
+ * \param max_size largest width and height of the image in pixels
+ * \tparam Matrix matrix container
+ *
+ * \note the image is 8-bit grayscale, deflated with zlib when
+ *       \c __CUSP_USE_ZLIB__ is defined and stored uncompressed otherwise
+ *
+ * \throws cusp::io_exception if the file cannot be written
+ *
+ * \see \p write_spy_svg
+ */
+template <typename Matrix>
+void write_spy_png(const Matrix& mtx, const std::string& filename, const size_t max_size = 512);
+
+/*! \p write_spy_svg : Write the sparsity pattern of a matrix as an SVG image
+ *
+ * The bins are those of \p write_spy_png.  Each run of bins with the same
+ * shade within a row of the image is one rectangle, so the size of the
+ * file is bounded by the number of pixels instead of the number of
+ * entries.
+ *
+ * \param mtx a matrix container (e.g. \p csr_matrix or \p coo_matrix)
+ * \param filename file name of the image
+ * \param max_size largest width and height of the image in bins
+ * \tparam Matrix matrix container
+ *
+ * \throws cusp::io_exception if the file cannot be written
+ *
+ * \see \p write_spy_png
+ */
+template <typename Matrix>
+void write_spy_svg(const Matrix& mtx, const std::string& filename, const size_t max_size = 512);
+
+/*! \}
+ */
+
+} // end namespace io
+} // end namespace cusp
+
+#include <cusp/io/detail/spy.inl>
@@ -0,0 +1,330 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*! \file batched.h
+ *  \brief Krylov methods for batches of small independent systems
+ */
+
+#pragma once
+
+#include <cusp/detail/config.h>
+
+#include <cusp/array1d.h>
+#include <cusp/complex.h>
+
+#include <cusp/krylov/workspace.h>
+
+namespace cusp
+{
+namespace krylov
+{
+
+/*! \addtogroup iterative_solvers Iterative Solvers
+ *  \addtogroup krylov_methods Krylov Methods
+ *  \ingroup iterative_solvers
+ *  \{
+ */
+
+/*! Preconditioner applied to every system of a batch
+ */
+enum batched_preconditioner
+{
+    BATCHED_IDENTITY,  //!< no preconditioning
+    BATCHED_JACOBI     //!< scaling by the inverse of the diagonal of each system
+};
+
+/*! \p batched_monitor : Stopping criteria and results of a batched solve
+ *
+ *  Every system of the batch is iterated until its residual norm satisfies
+ *  ||r|| <= absolute_tolerance + relative_tolerance * ||b|| or
+ *  \c iteration_limit iterations have been performed, independently of
+ *  the other systems.  After the solve the monitor holds the number of
+ *  iterations, the final residual norm and the convergence of each system.
+ *
+ *  \tparam ValueType value type of the systems
+ */
+template <typename ValueType>
+class batched_monitor
+{
+    public:
+    typedef typename norm_type<ValueType>::type Real;
+
+    /*! Construct a \p batched_monitor
+     *
+     *  \param iteration_limit maximum number of iterations of each system
+     *  \param relative_tolerance tolerance relative to the norm of the right-hand side of each system
+     *  \param absolute_tolerance absolute tolerance of each system
+     */
+    batched_monitor(size_t iteration_limit = 500, Real relative_tolerance = 1e-5, Real absolute_tolerance = 0)
+        : iteration_limit_(iteration_limit),
+          relative_tolerance_(relative_tolerance),
+          absolute_tolerance_(absolute_tolerance) {}
+
+    size_t iteration_limit() const { return iteration_limit_; }
+
+    Real relative_tolerance() const { return relative_tolerance_; }
+
+    Real absolute_tolerance() const { return absolute_tolerance_; }
+
+    /*! number of systems of the last solve
+     */
+    size_t num_systems() const { return iteration_counts.size(); }
+
+    /*! number of iterations performed on system \p i
+     */
+    size_t iteration_count(size_t i) const { return iteration_counts[i]; }
+
+    /*! residual norm of system \p i at the end of the solve
+     */
+    Real residual_norm(size_t i) const { return residual_norms[i]; }
+
+    /*! whether system \p i satisfied the tolerance
+     */
+    bool converged(size_t i) const { return convergence[i] != 0; }
+
+    /*! whether every system satisfied the tolerance
+     */
+    bool converged() const { return num_converged() == num_systems(); }
+
+    size_t num_converged() const
+    {
+        size_t count = 0;
+        for (size_t i = 0; i < convergence.size(); i++)
+            count += convergence[i] != 0;
+        return count;
+    }
+
+    /*! largest number of iterations performed on a system
+     */
+    size_t max_iteration_count() const
+    {
+        size_t count = 0;
+        for (size_t i = 0; i < iteration_counts.size(); i++)
+            count = iteration_counts[i] > count ? iteration_counts[i] : count;
+        return count;
+    }
+
+    /*! Store the results of a solve, called by the batched solvers
+     */
+    template <typename Array1, typename Array2, typename Array3>
+    void record(const Array1& iterations, const Array2& residuals, const Array3& converged)
+    {
+        iteration_counts = iterations;
+        residual_norms = residuals;
+        convergence = converged;
+    }
+
+    private:
+    size_t iteration_limit_;
+    Real relative_tolerance_;
+    Real absolute_tolerance_;
+
+    cusp::array1d<int,cusp::host_memory>  iteration_counts;
+    cusp::array1d<Real,cusp::host_memory> residual_norms;
+    cusp::array1d<int,cusp::host_memory>  convergence;
+};
+
+/*! \p batched_block_diagonal : Concatenate a batch of systems with the
+ *  same sparsity pattern
+ *
+ *  Forms the block diagonal matrix whose i-th block has the pattern of
+ *  \p pattern and the values \p values[i * nnz, (i + 1) * nnz), and the
+ *  row offsets of the systems, as expected by the batched solvers.
+ *
+ *  \param pattern CSR matrix with the common sparsity pattern
+ *  \param values values of the systems, one system after the other
+ *  \param num_systems number of systems
+ *  \param A block diagonal CSR matrix
+ *  \param offsets system i occupies rows [offsets[i], offsets[i+1]) of A
+ */
+template <typename Matrix1, typename Array1, typename Matrix2, typename Array2>
+void batched_block_diagonal(const Matrix1& pattern,
+                            const Array1& values,
+                            const size_t num_systems,
+                            Matrix2& A,
+                            Array2& offsets);
+
+/*! \p batched_cg : Conjugate Gradient method on a batch of systems
+ *
+ *  Solves the independent symmetric, positive-definite systems that form
+ *  the diagonal blocks of \p A.  In device memory each system is solved by
+ *  one thread block, which performs all of its iterations in a single
+ *  kernel launch with the reductions in shared memory, so the cost of a
+ *  batch does not depend on launch latency.  A block stops as soon as its
+ *  system has converged, leaving the multiprocessor to the remaining
+ *  systems.  In host memory the systems are solved one after the other.
+ *
+ *  \param A CSR matrix whose diagonal blocks are the systems
+ *  \param x approximate solutions of the systems
+ *  \param b right-hand sides of the systems
+ *  \param offsets system i occupies rows [offsets[i], offsets[i+1]) of A,
+ *         and no entry of these rows lies outside those columns
+ *  \param monitor stopping criteria, receives the per-system results
+ *  \param preconditioner preconditioner of the systems
+ *
+ *  \tparam Matrix is a \p csr_matrix
+ *  \tparam Array1 vector
+ *  \tparam Array2 vector
+ *  \tparam Array3 vector of row indices
+ *
+ *  The following code snippet solves 10000 10x10 Poisson problems.
+ *
+ *  \code
+ *  #include <cusp/csr_matrix.h>
+ *  #include <cusp/krylov/batched.h>
+ *  #include <cusp/gallery/poisson.h>
+ *
+ *  int main(void)
+ *  {
+ *      cusp::csr_matrix<int, float, cusp::device_memory> P;
+ *      cusp::gallery::poisson5pt(P, 10, 10);
+ *
+ *      // values of the systems, one after the other
+ *      const size_t num_systems = 10000;
+ *      cusp::array1d<float, cusp::device_memory> values(num_systems * P.num_entries);
+ *      for (size_t i = 0; i < num_systems; i++)
+ *          thrust::copy(P.values.begin(), P.values.end(), values.begin() + i * P.num_entries);
+ *
+ *      cusp::csr_matrix<int, float, cusp::device_memory> A;
+ *      cusp::array1d<int, cusp::device_memory> offsets;
+ *      cusp::krylov::batched_block_diagonal(P, values, num_systems, A, offsets);
+ *
+ *      cusp::array1d<float, cusp::device_memory> x(A.num_rows, 0);
+ *      cusp::array1d<float, cusp::device_memory> b(A.num_rows, 1);
+ *
+ *      cusp::krylov::batched_monitor<float> monitor(100, 1e-6);
+ *      cusp::krylov::batched_cg(A, x, b, offsets, monitor);
+ *
+ *      return monitor.converged() ? 0 : 1;
+ *  }
+ *  \endcode
+ */
+template <class Matrix,
+          class Array1,
+          class Array2,
+          class Array3,
+          class Monitor>
+void batched_cg(const Matrix& A,
+                Array1& x,
+                const Array2& b,
+                const Array3& offsets,
+                Monitor& monitor,
+                const batched_preconditioner preconditioner = BATCHED_IDENTITY);
+
+/*! \p batched_cg : Conjugate Gradient method on a batch of systems
+ *
+ *  Same as above, with the work vectors taken from \p workspace.
+ */
+template <class Matrix,
+          class Array1,
+          class Array2,
+          class Array3,
+          class Monitor,
+          class Workspace>
+void batched_cg(const Matrix& A,
+                Array1& x,
+                const Array2& b,
+                const Array3& offsets,
+                Monitor& monitor,
+                const batched_preconditioner preconditioner,
+                Workspace& workspace);
+
+/*! \p batched_bicgstab : BiConjugate Gradient Stabilized method on a
+ *  batch of systems
+ *
+ *  Solves the independent nonsymmetric systems that form the diagonal
+ *  blocks of \p A, one thread block per system as \p batched_cg.  The
+ *  preconditioner is applied from the right.
+ */
+template <class Matrix,
+          class Array1,
+          class Array2,
+          class Array3,
+          class Monitor>
+void batched_bicgstab(const Matrix& A,
+                      Array1& x,
+                      const Array2& b,
+                      const Array3& offsets,
+                      Monitor& monitor,
+                      const batched_preconditioner preconditioner = BATCHED_IDENTITY);
+
+/*! \p batched_bicgstab : BiConjugate Gradient Stabilized method on a
+ *  batch of systems
+ *
+ *  Same as above, with the work vectors taken from \p workspace.
+ */
+template <class Matrix,
+          class Array1,
+          class Array2,
+          class Array3,
+          class Monitor,
+          class Workspace>
+void batched_bicgstab(const Matrix& A,
+                      Array1& x,
+                      const Array2& b,
+                      const Array3& offsets,
+                      Monitor& monitor,
+                      const batched_preconditioner preconditioner,
+                      Workspace& workspace);
+
+/*! \p batched_gmres : GMRES method on a batch of systems
+ *
+ *  Solves the independent nonsymmetric systems that form the diagonal
+ *  blocks of \p A, one thread block per system as \p batched_cg, with
+ *  modified Gram-Schmidt and restarts every \p restart iterations.  The
+ *  preconditioner is applied from the right, and the residual norm of
+ *  each system is that of the least squares problem, as in \p gmres.
+ *  The basis takes restart + 1 work vectors of the size of \p x.
+ */
+template <class Matrix,
+          class Array1,
+          class Array2,
+          class Array3,
+          class Monitor>
+void batched_gmres(const Matrix& A,
+                   Array1& x,
+                   const Array2& b,
+                   const Array3& offsets,
+                   const size_t restart,
+                   Monitor& monitor,
+                   const batched_preconditioner preconditioner = BATCHED_IDENTITY);
+
+/*! \p batched_gmres : GMRES method on a batch of systems
+ *
+ *  Same as above, with the basis and work vectors taken from \p workspace.
+ */
+template <class Matrix,
+          class Array1,
+          class Array2,
+          class Array3,
+          class Monitor,
+          class Workspace>
+void batched_gmres(const Matrix& A,
+                   Array1& x,
+                   const Array2& b,
+                   const Array3& offsets,
+                   const size_t restart,
+                   Monitor& monitor,
+                   const batched_preconditioner preconditioner,
+                   Workspace& workspace);
+/*! \}
+ */
+
+} // end namespace krylov
+} // end namespace cusp
+
+#include <cusp/krylov/detail/batched.inl>
+
@@ -22,6 +22,8 @@
 
 #include <cusp/detail/config.h>
 
+#include <cusp/krylov/workspace.h>
+
 namespace cusp
 {
 namespace krylov
@@ -37,9 +39,10 @@ namespace krylov
  * Solves the linear system A x = b using the default convergence criteria.
  */
 template <class LinearOperator,
+          class TransposeOperator,
           class Vector>
 void bicg(LinearOperator& A,
-	  LinearOperator& At,
+	  TransposeOperator& At,
 	  Vector& x,
 	  Vector& b);
 
@@ -48,10 +51,11 @@ void bicg(LinearOperator& A,
  * Solves the linear system A x = b without preconditioning.
  */
 template <class LinearOperator,
+          class TransposeOperator,
           class Vector,
           class Monitor>
 void bicg(LinearOperator& A,
-	  LinearOperator& At,
+	  TransposeOperator& At,
 	  Vector& x,
 	  Vector& b,
 	  Monitor& monitor);
@@ -69,6 +73,9 @@ void bicg(LinearOperator& A,
  * \param Mt conjugate tranpose of the preconditioner for A
  *
  * \tparam LinearOperator is a matrix or subclass of \p linear_operator
+ * \tparam TransposeOperator is a matrix or subclass of \p linear_operator,
+ *         e.g. a \p transposed_operator of a real matrix \p A, which
+ *         applies A^T without storing it
  * \tparam Vector vector
  * \tparam Monitor is a monitor such as \p default_monitor or \p verbose_monitor
  * \tparam Preconditioner is a matrix or subclass of \p linear_operator
@@ -115,16 +122,41 @@ void bicg(LinearOperator& A,
  *  \see \p verbose_monitor
  */
 template <class LinearOperator,
+          class TransposeOperator,
           class Vector,
           class Monitor,
           class Preconditioner>
   void bicg(LinearOperator& A,
-	    LinearOperator& At,
+	    TransposeOperator& At,
 	    Vector& x,
 	    Vector& b,
 	    Monitor& monitor,
 	    Preconditioner& M,
 	    Preconditioner& Mt);
+
+/*! \p bicg : Biconjugate Gradient method
+ *
+ * Same as above, drawing the work vectors from \p workspace
+ * so that repeated solves do not allocate memory.
+ *
+ * \tparam Workspace is a \p cusp::krylov::workspace
+ *
+ *  \see \p workspace
+ */
+template <class LinearOperator,
+          class TransposeOperator,
+          class Vector,
+          class Monitor,
+          class Preconditioner,
+          class Workspace>
+  void bicg(LinearOperator& A,
+	    TransposeOperator& At,
+	    Vector& x,
+	    Vector& b,
+	    Monitor& monitor,
+	    Preconditioner& M,
+	    Preconditioner& Mt,
+	    Workspace& workspace);
 /*! \}
  */
 
@@ -22,6 +22,8 @@
 
 #include <cusp/detail/config.h>
 
+#include <cusp/krylov/workspace.h>
+
 namespace cusp
 {
 namespace krylov
@@ -117,6 +119,107 @@ void bicgstab(LinearOperator& A,
               Vector& b,
               Monitor& monitor,
               Preconditioner& M);
+
+/*! \p bicgstab : Biconjugate Gradient Stabilized method
+ *
+ * Same as above, drawing the work vectors from \p workspace
+ * so that repeated solves do not allocate memory.
+ *
+ * \tparam Workspace is a \p cusp::krylov::workspace
+ *
+ *  \see \p workspace
+ */
+template <class LinearOperator,
+          class Vector,
+          class Monitor,
+          class Preconditioner,
+          class Workspace>
+void bicgstab(LinearOperator& A,
+              Vector& x,
+              Vector& b,
+              Monitor& monitor,
+              Preconditioner& M,
+              Workspace& workspace);
+
+/*! \p reliable_bicgstab : mixed precision BiCGstab with reliable updates
+ *
+ * Runs the BiCGstab iteration with \p A_low and vectors in low precision
+ * and accumulates the solution of each group of iterations in a low
+ * precision vector.  Whenever the iterated residual norm drops below
+ * \p delta times its maximum since the last update, the accumulated
+ * solution is added to \p x and the true residual b - A x is recomputed
+ * with \p A in high precision and replaces the iterated one.  Convergence
+ * is only accepted for the true residual, so the solver reaches tolerances
+ * beyond the precision of the inner iteration.
+ *
+ * \param A matrix of the linear system in high precision
+ * \param A_low the same matrix in low precision
+ * \param x approximate solution of the linear system
+ * \param b right-hand side of the linear system
+ * \param monitor monitors iteration and determines stopping conditions
+ *
+ * \tparam LinearOperator is a matrix or subclass of \p linear_operator
+ * \tparam LowPrecisionOperator is a matrix or subclass of \p linear_operator
+ * \tparam Vector vector
+ * \tparam Monitor is a monitor such as \p default_monitor or \p verbose_monitor
+ *
+ *  The following code snippet solves a Poisson problem to a relative
+ *  tolerance of 1e-10 with single precision BiCGstab iterations.
+ *
+ *  \code
+ *  #include <cusp/csr_matrix.h>
+ *  #include <cusp/monitor.h>
+ *  #include <cusp/krylov/bicgstab.h>
+ *  #include <cusp/gallery/poisson.h>
+ *
+ *  int main(void)
+ *  {
+ *      cusp::csr_matrix<int, double, cusp::device_memory> A;
+ *      cusp::gallery::poisson5pt(A, 100, 100);
+ *
+ *      cusp::csr_matrix<int, float, cusp::device_memory> A_low(A);
+ *
+ *      cusp::array1d<double, cusp::device_memory> x(A.num_rows, 0);
+ *      cusp::array1d<double, cusp::device_memory> b(A.num_rows, 1);
+ *
+ *      cusp::default_monitor<double> monitor(b, 1000, 1e-10);
+ *
+ *      cusp::krylov::reliable_bicgstab(A, A_low, x, b, monitor);
+ *
+ *      return 0;
+ *  }
+ *  \endcode
+ *
+ *  \see \p iterative_refinement
+ */
+template <class LinearOperator,
+          class LowPrecisionOperator,
+          class Vector,
+          class Monitor>
+void reliable_bicgstab(LinearOperator& A,
+                       LowPrecisionOperator& A_low,
+                       Vector& x,
+                       Vector& b,
+                       Monitor& monitor);
+
+/*! \p reliable_bicgstab : mixed precision BiCGstab with reliable updates
+ *
+ * Same as above with the preconditioner \p M, which operates in the
+ * precision and memory space of \p A_low, and the reliable update
+ * threshold \p delta.
+ */
+template <class LinearOperator,
+          class LowPrecisionOperator,
+          class Vector,
+          class Monitor,
+          class Preconditioner>
+void reliable_bicgstab(LinearOperator& A,
+                       LowPrecisionOperator& A_low,
+                       Vector& x,
+                       Vector& b,
+                       Monitor& monitor,
+                       Preconditioner& M,
+                       const double delta = 0.1);
 /*! \}
  */
 
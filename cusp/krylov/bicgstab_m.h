@@ -165,6 +165,23 @@ template <class LinearOperator,
 void bicgstab_m(LinearOperator& A,
         VectorType1& x, VectorType2& b, VectorType3& sigma,
         Monitor& monitor);
+
+/*! \p bicgstab_m : Multi-mass Biconjugate Gradient stabilized method with
+ *  polynomial preconditioning
+ *
+ * The polynomial p is given by its coefficients, highest degree first as in
+ * \p cusp::relaxation::polynomial.  The shifted systems
+ * (A p(A) + \eta) y = b with \eta = \sigma p(-\sigma) are solved together
+ * and each solution is recovered as x = p_\sigma(A) y with
+ * p_\sigma(t) = (t p(t) + \eta) / (t + \sigma).  The monitor tests the
+ * residual of A p(A) y = b.
+ */
+template <class LinearOperator,
+          class VectorType1, class VectorType2, class VectorType3,
+          class Monitor, class Array>
+void bicgstab_m(LinearOperator& A,
+        VectorType1& x, VectorType2& b, VectorType3& sigma,
+        Monitor& monitor, const Array& coefficients);
 /*! \}
  */
 
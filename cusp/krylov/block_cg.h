@@ -0,0 +1,157 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*! \file block_cg.h
+ *  \brief Block Conjugate Gradient method for several right-hand sides
+ */
+
+#pragma once
+
+#include <cusp/detail/config.h>
+
+#include <cusp/krylov/block_monitor.h>
+#include <cusp/krylov/workspace.h>
+
+namespace cusp
+{
+namespace krylov
+{
+
+/*! \addtogroup iterative_solvers Iterative Solvers
+ *  \addtogroup krylov_methods Krylov Methods
+ *  \ingroup iterative_solvers
+ *  \{
+ */
+
+/*! \p block_cg : Block Conjugate Gradient method
+ *
+ * Solves the symmetric, positive-definite linear system A X = B
+ * using the default convergence criteria.
+ */
+template <class LinearOperator,
+          class Array2d>
+void block_cg(LinearOperator& A,
+              Array2d& X,
+              Array2d& B);
+
+/*! \p block_cg : Block Conjugate Gradient method
+ *
+ * Solves the symmetric, positive-definite linear system A X = B without preconditioning.
+ */
+template <class LinearOperator,
+          class Array2d,
+          class Monitor>
+void block_cg(LinearOperator& A,
+              Array2d& X,
+              Array2d& B,
+              Monitor& monitor);
+
+/*! \p block_cg : Block Conjugate Gradient method
+ *
+ * Solves the symmetric, positive-definite linear system A X = B
+ * with preconditioner \p M.
+ *
+ * The columns of \p B are solved together: every iteration multiplies A
+ * by the whole block of search directions, so that A is streamed once
+ * per iteration instead of once per right-hand side, and the search
+ * space of each column is the sum of the Krylov spaces of all columns,
+ * which usually takes fewer iterations than \p cg.  The inner products
+ * of the block are computed by one reduction each.
+ *
+ * A column is deflated as soon as its residual satisfies the tolerance
+ * of \p monitor: its solution is written back and the remaining columns
+ * continue with a smaller block.
+ *
+ * \param A matrix of the linear system
+ * \param X approximate solutions, one per column
+ * \param B right-hand sides, one per column
+ * \param monitor montiors iteration and determines stopping conditions
+ * \param M preconditioner for A
+ *
+ * \tparam LinearOperator is a sparse matrix
+ * \tparam Array2d column-major \p array2d
+ * \tparam Monitor is a \p block_monitor
+ * \tparam Preconditioner is a matrix or subclass of \p linear_operator
+ *
+ * \note \p A and \p M must be symmetric and positive-definite and the
+ * columns of \p B linearly independent.
+ *
+ *  The following code snippet demonstrates how to use \p block_cg to
+ *  solve a 10x10 Poisson problem with 16 right-hand sides.
+ *
+ *  \code
+ *  #include <cusp/csr_matrix.h>
+ *  #include <cusp/array2d.h>
+ *  #include <cusp/krylov/block_cg.h>
+ *  #include <cusp/gallery/poisson.h>
+ *
+ *  int main(void)
+ *  {
+ *      cusp::csr_matrix<int, float, cusp::device_memory> A;
+ *      cusp::gallery::poisson5pt(A, 10, 10);
+ *
+ *      cusp::array2d<float, cusp::device_memory, cusp::column_major> X(A.num_rows, 16, 0);
+ *      cusp::array2d<float, cusp::device_memory, cusp::column_major> B(A.num_rows, 16, 1);
+ *      ...
+ *
+ *      cusp::krylov::block_monitor<float> monitor(B, 100, 1e-6);
+ *      cusp::krylov::block_cg(A, X, B, monitor);
+ *
+ *      return monitor.converged() ? 0 : 1;
+ *  }
+ *  \endcode
+ *
+ *  \see \p cg
+ *  \see \p block_gmres
+ */
+template <class LinearOperator,
+          class Array2d,
+          class Monitor,
+          class Preconditioner>
+void block_cg(LinearOperator& A,
+              Array2d& X,
+              Array2d& B,
+              Monitor& monitor,
+              Preconditioner& M);
+
+/*! \p block_cg : Block Conjugate Gradient method
+ *
+ * Same as above, drawing the blocks of work vectors from \p workspace
+ * so that repeated solves do not allocate memory.
+ *
+ * \tparam Workspace is a \p cusp::krylov::workspace
+ *
+ *  \see \p workspace
+ */
+template <class LinearOperator,
+          class Array2d,
+          class Monitor,
+          class Preconditioner,
+          class Workspace>
+void block_cg(LinearOperator& A,
+              Array2d& X,
+              Array2d& B,
+              Monitor& monitor,
+              Preconditioner& M,
+              Workspace& workspace);
+/*! \}
+ */
+
+} // end namespace krylov
+} // end namespace cusp
+
+#include <cusp/krylov/detail/block_cg.inl>
+
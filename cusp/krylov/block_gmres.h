@@ -0,0 +1,144 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*! \file block_gmres.h
+ *  \brief Block GMRES method for several right-hand sides
+ */
+
+#pragma once
+
+#include <cusp/detail/config.h>
+
+#include <cusp/krylov/block_monitor.h>
+#include <cusp/krylov/workspace.h>
+
+namespace cusp
+{
+namespace krylov
+{
+
+/*! \addtogroup iterative_solvers Iterative Solvers
+ *  \addtogroup krylov_methods Krylov Methods
+ *  \ingroup iterative_solvers
+ *  \{
+ */
+
+/*! \p block_gmres : Block GMRES method
+ *
+ * Solves the nonsymmetric, linear system A X = B with restart parameter
+ * \p restart using the default convergence criteria.
+ */
+template <class LinearOperator,
+          class Array2d>
+void block_gmres(LinearOperator& A,
+                 Array2d& X,
+                 Array2d& B,
+                 const size_t restart);
+
+/*! \p block_gmres : Block GMRES method
+ *
+ * Solves the nonsymmetric, linear system A X = B with restart parameter
+ * \p restart without preconditioning.
+ */
+template <class LinearOperator,
+          class Array2d,
+          class Monitor>
+void block_gmres(LinearOperator& A,
+                 Array2d& X,
+                 Array2d& B,
+                 const size_t restart,
+                 Monitor& monitor);
+
+/*! \p block_gmres : Block GMRES method
+ *
+ * Solves the nonsymmetric, linear system A X = B with restart parameter
+ * \p restart and preconditioner \p M.
+ *
+ * The columns of \p B are solved together: every iteration multiplies A
+ * by a block of basis vectors, so that A is streamed once per iteration
+ * instead of once per right-hand side, and each column is minimized over
+ * the sum of the Krylov spaces of all columns.  A new block is
+ * orthogonalized by block Gram-Schmidt with Cholesky QR, applied twice,
+ * with one reduction per pass, and the banded Hessenberg matrix is
+ * reduced by Givens rotations on the host.
+ *
+ * \p restart counts block iterations, so the basis holds
+ * (restart + 1) * B.num_cols vectors.  A cycle ends early once the
+ * least squares residuals of all active columns satisfy their
+ * tolerance.  At every restart the true residuals are tested and the
+ * converged columns are deflated: their solutions are final and the
+ * next cycle runs with a smaller block.  As in \p gmres the preconditioner
+ * is applied from the left and the monitor receives the norms of the
+ * preconditioned residuals.
+ *
+ * \param A matrix of the linear system
+ * \param X approximate solutions, one per column
+ * \param B right-hand sides, one per column
+ * \param restart number of block iterations between restarts
+ * \param monitor montiors iteration and determines stopping conditions
+ * \param M preconditioner for A
+ *
+ * \tparam LinearOperator is a sparse matrix
+ * \tparam Array2d column-major \p array2d
+ * \tparam Monitor is a \p block_monitor
+ * \tparam Preconditioner is a matrix or subclass of \p linear_operator
+ *
+ * \note The residuals of the columns must stay linearly independent,
+ * otherwise the solve stops at the next restart.
+ *
+ *  \see \p gmres
+ *  \see \p block_cg
+ */
+template <class LinearOperator,
+          class Array2d,
+          class Monitor,
+          class Preconditioner>
+void block_gmres(LinearOperator& A,
+                 Array2d& X,
+                 Array2d& B,
+                 const size_t restart,
+                 Monitor& monitor,
+                 Preconditioner& M);
+
+/*! \p block_gmres : Block GMRES method
+ *
+ * Same as above, drawing the basis and work vectors from \p workspace
+ * so that repeated solves do not allocate memory.
+ *
+ * \tparam Workspace is a \p cusp::krylov::workspace
+ *
+ *  \see \p workspace
+ */
+template <class LinearOperator,
+          class Array2d,
+          class Monitor,
+          class Preconditioner,
+          class Workspace>
+void block_gmres(LinearOperator& A,
+                 Array2d& X,
+                 Array2d& B,
+                 const size_t restart,
+                 Monitor& monitor,
+                 Preconditioner& M,
+                 Workspace& workspace);
+/*! \}
+ */
+
+} // end namespace krylov
+} // end namespace cusp
+
+#include <cusp/krylov/detail/block_gmres.inl>
+
@@ -0,0 +1,176 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*! \file block_monitor.h
+ *  \brief Monitor the convergence of block iterative solvers
+ */
+
+#pragma once
+
+#include <cusp/detail/config.h>
+
+#include <cusp/array1d.h>
+#include <cusp/blas.h>
+#include <cusp/complex.h>
+
+#include <limits>
+
+namespace cusp
+{
+namespace krylov
+{
+
+/*! \addtogroup iterative_solvers Iterative Solvers
+ *  \addtogroup monitors Monitors
+ *  \ingroup iterative_solvers
+ *  \{
+ */
+
+/*! \p block_monitor : Convergence criteria of a system with several
+ *  right-hand sides
+ *
+ *  Column j of the solution has converged once its residual norm satisfies
+ *  ||B(:,j) - A X(:,j)|| <= absolute_tolerance + relative_tolerance * ||B(:,j)||.
+ *  The block solvers stop updating converged columns and finish when every
+ *  column has converged or the iteration limit is reached.
+ *
+ *  \tparam ValueType scalar type used in the solver
+ */
+template <typename ValueType>
+class block_monitor
+{
+    public:
+    typedef typename norm_type<ValueType>::type Real;
+
+    /*! Construct a \p block_monitor for the right-hand sides \p B
+     *
+     *  \param B column-major array2d of right-hand sides
+     *  \param iteration_limit maximum number of block iterations
+     *  \param relative_tolerance tolerance relative to the norm of each right-hand side
+     *  \param absolute_tolerance absolute tolerance of each column
+     */
+    template <typename Array2d>
+    block_monitor(const Array2d& B, size_t iteration_limit = 500, Real relative_tolerance = 1e-5, Real absolute_tolerance = 0)
+        : b_norms(B.num_cols),
+          r_norms(B.num_cols, std::numeric_limits<Real>::max()),
+          convergence_iterations(B.num_cols, -1),
+          iteration_limit_(iteration_limit),
+          iteration_count_(0),
+          relative_tolerance_(relative_tolerance),
+          absolute_tolerance_(absolute_tolerance)
+    {
+        for (size_t j = 0; j < B.num_cols; j++)
+            b_norms[j] = cusp::blas::nrm2(B.column(j));
+    }
+
+    /*! increment the iteration count
+     */
+    void operator++(void) {  ++iteration_count_; } // prefix increment
+
+    /*! applies the convergence criteria to column \p j, returns whether
+     *  the column has converged
+     *
+     *  \param j column of the solution
+     *  \param residual_norm Euclidean norm of its residual
+     */
+    bool finished(const size_t j, const Real& residual_norm)
+    {
+        r_norms[j] = residual_norm;
+
+        if (convergence_iterations[j] < 0 && residual_norm <= tolerance(j))
+            convergence_iterations[j] = int(iteration_count_);
+
+        return converged(j);
+    }
+
+    /*! whether every column has converged or the iteration limit is reached
+     */
+    bool finished() const
+    {
+        return converged() || iteration_count() >= iteration_limit();
+    }
+
+    /*! whether column \p j has converged
+     */
+    bool converged(const size_t j) const { return convergence_iterations[j] >= 0; }
+
+    /*! whether every column has converged
+     */
+    bool converged() const { return num_converged() == num_columns(); }
+
+    size_t num_converged() const
+    {
+        size_t count = 0;
+        for (size_t j = 0; j < num_columns(); j++)
+            count += converged(j);
+        return count;
+    }
+
+    /*! number of right-hand sides
+     */
+    size_t num_columns() const { return b_norms.size(); }
+
+    /*! Euclidean norm of the last residual of column \p j
+     */
+    Real residual_norm(const size_t j) const { return r_norms[j]; }
+
+    /*! number of block iterations
+     */
+    size_t iteration_count() const { return iteration_count_; }
+
+    /*! number of block iterations after which column \p j converged, or
+     *  the total number of iterations if it did not
+     */
+    size_t iteration_count(const size_t j) const
+    {
+        return converged(j) ? size_t(convergence_iterations[j]) : iteration_count_;
+    }
+
+    /*! maximum number of block iterations
+     */
+    size_t iteration_limit() const { return iteration_limit_; }
+
+    /*! relative tolerance
+     */
+    Real relative_tolerance() const { return relative_tolerance_; }
+
+    /*! absolute tolerance
+     */
+    Real absolute_tolerance() const { return absolute_tolerance_; }
+
+    /*! tolerance of column \p j
+     *
+     *  Equal to absolute_tolerance() + relative_tolerance() * ||B(:,j)||
+     */
+    Real tolerance(const size_t j) const { return absolute_tolerance() + relative_tolerance() * b_norms[j]; }
+
+    protected:
+
+    cusp::array1d<Real,cusp::host_memory> b_norms;
+    cusp::array1d<Real,cusp::host_memory> r_norms;
+    cusp::array1d<int,cusp::host_memory>  convergence_iterations;
+
+    size_t iteration_limit_;
+    size_t iteration_count_;
+    Real relative_tolerance_;
+    Real absolute_tolerance_;
+};
+/*! \}
+ */
+
+} // end namespace krylov
+} // end namespace cusp
+
@@ -22,6 +22,9 @@
 
 #include <cusp/detail/config.h>
 
+#include <cusp/krylov/workspace.h>
+#include <cusp/detail/forward_definitions.h>
+
 namespace cusp
 {
 namespace krylov
@@ -123,6 +126,103 @@ void cg(LinearOperator& A,
         Vector& b,
         Monitor& monitor,
         Preconditioner& M);
+
+/*! \p cg : Conjugate Gradient method
+ *
+ * Solves the symmetric, positive-definite linear system A x = b
+ * with preconditioner \p M, drawing the work vectors from \p workspace
+ * so that repeated solves do not allocate memory.
+ *
+ * \tparam Workspace is a \p cusp::krylov::workspace
+ *
+ *  \see \p workspace
+ */
+template <class LinearOperator,
+          class Vector,
+          class Monitor,
+          class Preconditioner,
+          class Workspace>
+void cg(LinearOperator& A,
+        Vector& x,
+        Vector& b,
+        Monitor& monitor,
+        Preconditioner& M,
+        Workspace& workspace);
+
+/*! \p cg : Conjugate Gradient method
+ *
+ * Solves the symmetric, positive-definite linear system A x = b
+ * with a matrix whose rows are distributed across several devices.
+ * The vectors must have the layout of \p A.
+ *
+ *  \see \p distributed_matrix
+ */
+template <class LocalMatrix,
+          class ValueType,
+          class Monitor,
+          class Preconditioner>
+void cg(cusp::distributed_matrix<LocalMatrix>& A,
+        cusp::distributed_array1d<ValueType>& x,
+        cusp::distributed_array1d<ValueType>& b,
+        Monitor& monitor,
+        Preconditioner& M);
+
+/*! \p cg : Conjugate Gradient method
+ *
+ * Solves the symmetric, positive-definite linear system A x = b
+ * with a matrix whose rows are distributed across several devices,
+ * drawing the work vectors from \p workspace.
+ *
+ *  \see \p distributed_workspace
+ */
+template <class LocalMatrix,
+          class ValueType,
+          class Monitor,
+          class Preconditioner>
+void cg(cusp::distributed_matrix<LocalMatrix>& A,
+        cusp::distributed_array1d<ValueType>& x,
+        cusp::distributed_array1d<ValueType>& b,
+        Monitor& monitor,
+        Preconditioner& M,
+        cusp::krylov::distributed_workspace<ValueType>& workspace);
+
+/*! \p cg : Conjugate Gradient method
+ *
+ * Solves the symmetric, positive-definite linear system A x = b
+ * with a matrix whose rows are distributed across MPI processes.  The
+ * vectors must have the layout of \p A and every process of its
+ * communicator must call the solver.
+ *
+ *  \see \p mpi_matrix
+ */
+template <class LocalMatrix,
+          class ValueType,
+          class Monitor,
+          class Preconditioner>
+void cg(cusp::mpi_matrix<LocalMatrix>& A,
+        cusp::mpi_array1d<ValueType>& x,
+        cusp::mpi_array1d<ValueType>& b,
+        Monitor& monitor,
+        Preconditioner& M);
+
+/*! \p cg : Conjugate Gradient method
+ *
+ * Solves the symmetric, positive-definite linear system A x = b
+ * with a matrix whose rows are distributed across MPI processes,
+ * drawing the work vectors from \p workspace.
+ *
+ *  \see \p mpi_workspace
+ */
+template <class LocalMatrix,
+          class ValueType,
+          class Monitor,
+          class Preconditioner>
+void cg(cusp::mpi_matrix<LocalMatrix>& A,
+        cusp::mpi_array1d<ValueType>& x,
+        cusp::mpi_array1d<ValueType>& b,
+        Monitor& monitor,
+        Preconditioner& M,
+        cusp::krylov::mpi_workspace<ValueType>& workspace);
 /*! \}
  */
 
@@ -77,6 +77,40 @@ void cg_m(LinearOperator& A,
           VectorType2& b,
           VectorType3& sigma,
           Monitor& monitor);
+
+/*! \p cg_m : Multi-mass Conjugate Gradient method with polynomial preconditioning
+ *
+ * Solves the symmetric, positive-definited linear system (A+\sigma) x = b
+ * for some set of constant shifts \p sigma, preconditioned with the
+ * polynomial p whose coefficients are given highest degree first as in
+ * \p cusp::relaxation::polynomial.
+ *
+ * The shifted systems (A p(A) + \eta) y = b with \eta = \sigma p(-\sigma)
+ * share one Krylov space and are solved together, then each solution is
+ * recovered as x = p_\sigma(A) y with p_\sigma(t) = (t p(t) + \eta) / (t + \sigma).
+ * The matrices A p(A) + \eta must be positive-definite, which holds when p
+ * is positive on the spectrum of A and on the negated shifts.
+ *
+ * \param A matrix of the linear system
+ * \param x solutions of the system
+ * \param b right-hand side of the linear system
+ * \param sigma array of shifts
+ * \param monitor monitors the residual of A p(A) y = b
+ * \param coefficients coefficients of the polynomial preconditioner
+ *
+ */
+template <class LinearOperator,
+          class VectorType1,
+          class VectorType2,
+          class VectorType3,
+          class Monitor,
+          class Array>
+void cg_m(LinearOperator& A,
+          VectorType1& x,
+          VectorType2& b,
+          VectorType3& sigma,
+          Monitor& monitor,
+          const Array& coefficients);
 /*! \}
  */
 
@@ -22,6 +22,8 @@
 
 #include <cusp/detail/config.h>
 
+#include <cusp/krylov/workspace.h>
+
 namespace cusp
 {
 namespace krylov
@@ -123,6 +125,27 @@ void cr(LinearOperator& A,
         Vector& b,
         Monitor& monitor,
         Preconditioner& M);
+
+/*! \p cr : Conjugate Residual method
+ *
+ * Same as above, drawing the work vectors from \p workspace
+ * so that repeated solves do not allocate memory.
+ *
+ * \tparam Workspace is a \p cusp::krylov::workspace
+ *
+ *  \see \p workspace
+ */
+template <class LinearOperator,
+          class Vector,
+          class Monitor,
+          class Preconditioner,
+          class Workspace>
+void cr(LinearOperator& A,
+        Vector& x,
+        Vector& b,
+        Monitor& monitor,
+        Preconditioner& M,
+        Workspace& workspace);
 /*! \}
  */
 
@@ -0,0 +1,180 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*! \file deflated_cg.h
+ *  \brief Deflated Conjugate Gradient method for sequences of systems
+ */
+
+#pragma once
+
+#include <cusp/detail/config.h>
+
+#include <cusp/array2d.h>
+#include <cusp/krylov/workspace.h>
+
+namespace cusp
+{
+namespace krylov
+{
+
+/*! \addtogroup iterative_solvers Iterative Solvers
+ *  \addtogroup krylov_methods Krylov Methods
+ *  \ingroup iterative_solvers
+ *  \{
+ */
+
+/*! \p deflated_cg : Deflated Conjugate Gradient method
+ *
+ * Solves a sequence of symmetric, positive-definite linear systems
+ * A_i x_i = b_i whose matrices change slowly, e.g. the systems of the
+ * time steps or Newton iterations of a simulation.  The solver object
+ * keeps a deflation subspace W between calls to \p solve.
+ *
+ * Each solve starts from the Galerkin projection of the solution on W
+ * and keeps the search directions A-orthogonal to W, so the eigenvalues
+ * captured by W no longer slow down the convergence.  After the solve,
+ * W is replaced by the Ritz vectors of the \p num_vectors smallest
+ * eigenvalues of A in the span of the old W and the first
+ * \p num_directions search directions.  The first solve runs plain CG
+ * and every later solve improves the approximation of the low end of
+ * the spectrum.
+ *
+ * \tparam ValueType value type of the systems
+ * \tparam MemorySpace memory space of the systems
+ *
+ * \note The matrices must be symmetric and positive-definite and all
+ * systems must have the same size, otherwise call \p clear first.
+ *
+ *  The following code snippet demonstrates how to use \p deflated_cg to
+ *  solve a sequence of shifted Poisson problems.
+ *
+ *  \code
+ *  #include <cusp/csr_matrix.h>
+ *  #include <cusp/monitor.h>
+ *  #include <cusp/krylov/deflated_cg.h>
+ *  #include <cusp/gallery/poisson.h>
+ *
+ *  int main(void)
+ *  {
+ *      cusp::csr_matrix<int, float, cusp::device_memory> A;
+ *      cusp::gallery::poisson5pt(A, 100, 100);
+ *
+ *      cusp::array1d<float, cusp::device_memory> x(A.num_rows, 0);
+ *      cusp::array1d<float, cusp::device_memory> b(A.num_rows, 1);
+ *
+ *      // recycle 8 vectors built from the first 16 search directions
+ *      cusp::krylov::deflated_cg<float, cusp::device_memory> solver(8, 16);
+ *
+ *      for (int step = 0; step < 10; step++)
+ *      {
+ *          // ... update the values of A and b ...
+ *
+ *          cusp::default_monitor<float> monitor(b, 1000, 1e-6);
+ *          solver.solve(A, x, b, monitor);
+ *      }
+ *
+ *      return 0;
+ *  }
+ *  \endcode
+ *
+ *  \see \p cg
+ *  \see \p gcro_dr
+ */
+template <typename ValueType, typename MemorySpace>
+class deflated_cg
+{
+    public:
+    typedef ValueType   value_type;
+    typedef MemorySpace memory_space;
+
+    typedef cusp::array2d<ValueType,MemorySpace,cusp::column_major> matrix_type;
+
+    /*! Construct a solver without a deflation subspace
+     *
+     *  \param num_vectors dimension of the deflation subspace
+     *  \param num_directions number of search directions of a solve
+     *  used to update the subspace
+     */
+    deflated_cg(size_t num_vectors = 8, size_t num_directions = 16);
+
+    /*! Solve A x = b using the default convergence criteria
+     */
+    template <class LinearOperator,
+              class Vector>
+    void solve(LinearOperator& A,
+               Vector& x,
+               Vector& b);
+
+    /*! Solve A x = b without preconditioning
+     */
+    template <class LinearOperator,
+              class Vector,
+              class Monitor>
+    void solve(LinearOperator& A,
+               Vector& x,
+               Vector& b,
+               Monitor& monitor);
+
+    /*! Solve A x = b with preconditioner \p M and update the deflation
+     *  subspace
+     *
+     * \param A matrix of the linear system
+     * \param x approximate solution of the linear system
+     * \param b right-hand side of the linear system
+     * \param monitor montiors iteration and determines stopping conditions
+     * \param M preconditioner for A
+     *
+     * \note With a preconditioner the subspace holds Ritz vectors of A
+     * rather than of the preconditioned operator.
+     */
+    template <class LinearOperator,
+              class Vector,
+              class Monitor,
+              class Preconditioner>
+    void solve(LinearOperator& A,
+               Vector& x,
+               Vector& b,
+               Monitor& monitor,
+               Preconditioner& M);
+
+    /*! dimension of the current deflation subspace
+     */
+    size_t num_recycled(void) const { return num_recycled_; }
+
+    /*! discard the deflation subspace
+     */
+    void clear(void) { num_recycled_ = 0; }
+
+    protected:
+    size_t num_vectors;
+    size_t num_directions;
+    size_t num_recycled_;
+
+    // the leading num_recycled_ columns hold W, the following ones the
+    // search directions of the current solve
+    matrix_type W;
+    matrix_type AW;
+
+    cusp::krylov::workspace<ValueType,MemorySpace> workspace;
+};
+/*! \}
+ */
+
+} // end namespace krylov
+} // end namespace cusp
+
+#include <cusp/krylov/detail/deflated_cg.inl>
+
@@ -0,0 +1,854 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include <cusp/array1d.h>
+#include <cusp/blas.h>
+#include <cusp/complex.h>
+
+#include <cusp/krylov/detail/device/batched.h>
+
+#include <thrust/copy.h>
+#include <thrust/sequence.h>
+#include <thrust/transform.h>
+#include <thrust/iterator/counting_iterator.h>
+
+#include <cassert>
+#include <cmath>
+
+namespace cusp
+{
+namespace krylov
+{
+namespace detail
+{
+
+// real part of an inner product
+__host__ __device__ inline float  batched_real(const float x)  { return x; }
+__host__ __device__ inline double batched_real(const double x) { return x; }
+
+template <typename T>
+__host__ __device__ T batched_real(const cusp::complex<T>& x) { return x.real(); }
+
+// the host solves each system with a single "thread"
+struct batched_serial_team
+{
+    __host__ __device__ size_t rank(void) const { return 0; }
+    __host__ __device__ size_t size(void) const { return 1; }
+    __host__ __device__ void sync(void) const {}
+
+    template <typename ValueType>
+    __host__ __device__ ValueType sum(const ValueType value) const { return value; }
+};
+
+// The batch and the results shared by the methods.  Work vector k of
+// system s occupies rows [offsets[s], offsets[s+1]) of work + k * N.
+template <typename IndexType, typename ValueType>
+struct batched_system
+{
+    typedef typename norm_type<ValueType>::type Real;
+
+    const IndexType * row_offsets;
+    const IndexType * column_indices;
+    const ValueType * values;
+    const IndexType * offsets;
+
+    ValueType * x;
+    const ValueType * b;
+
+    ValueType * work;
+    size_t N;
+
+    int * iterations;
+    Real * residuals;
+    int * converged;
+
+    size_t iteration_limit;
+    Real relative_tolerance;
+    Real absolute_tolerance;
+    bool jacobi;
+
+    __host__ __device__
+    ValueType * vector(const size_t k) const { return work + k * N; }
+
+    // y <- A x on rows [begin, end)
+    template <typename Team>
+    __host__ __device__
+    void spmv(const Team& team, const IndexType begin, const IndexType end,
+              const ValueType * x, ValueType * y) const
+    {
+        // x may have been written by other threads
+        team.sync();
+
+        for (IndexType i = begin + team.rank(); i < end; i += team.size())
+        {
+            ValueType sum = 0;
+            for (IndexType jj = row_offsets[i]; jj < row_offsets[i + 1]; jj++)
+                sum += values[jj] * x[column_indices[jj]];
+            y[i] = sum;
+        }
+
+        team.sync();
+    }
+
+    // <a^H, b> on rows [begin, end)
+    template <typename Team>
+    __host__ __device__
+    ValueType dot(const Team& team, const IndexType begin, const IndexType end,
+                  const ValueType * a, const ValueType * b) const
+    {
+        cusp::blas::detail::conjugate<ValueType> conj;
+
+        ValueType sum = 0;
+        for (IndexType i = begin + team.rank(); i < end; i += team.size())
+            sum += conj(a[i]) * b[i];
+
+        return team.sum(sum);
+    }
+
+    template <typename Team>
+    __host__ __device__
+    Real nrm2(const Team& team, const IndexType begin, const IndexType end, const ValueType * a) const
+    {
+        return sqrt(batched_real(dot(team, begin, end, a, a)));
+    }
+
+    // d <- inverse of the diagonal of the system, or ones without Jacobi
+    template <typename Team>
+    __host__ __device__
+    void inverse_diagonal(const Team& team, const IndexType begin, const IndexType end, ValueType * d) const
+    {
+        for (IndexType i = begin + team.rank(); i < end; i += team.size())
+        {
+            ValueType diagonal = 0;
+            if (jacobi)
+                for (IndexType jj = row_offsets[i]; jj < row_offsets[i + 1]; jj++)
+                    if (column_indices[jj] == i)
+                        diagonal += values[jj];
+            d[i] = (diagonal == ValueType(0)) ? ValueType(1) : ValueType(1) / diagonal;
+        }
+    }
+
+    template <typename Team>
+    __host__ __device__
+    void finish(const Team& team, const size_t system, const size_t iteration,
+                const Real residual, const Real tolerance) const
+    {
+        if (team.rank() == 0)
+        {
+            iterations[system] = int(iteration);
+            residuals[system] = residual;
+            converged[system] = residual <= tolerance;
+        }
+    }
+};
+
+template <typename IndexType, typename ValueType>
+struct batched_cg_method
+{
+    typedef typename norm_type<ValueType>::type Real;
+
+    batched_system<IndexType,ValueType> sys;
+
+    batched_cg_method(const batched_system<IndexType,ValueType>& sys) : sys(sys) {}
+
+    template <typename Team>
+    __host__ __device__
+    void operator()(const Team& team, const size_t system) const
+    {
+        const IndexType begin = sys.offsets[system];
+        const IndexType end   = sys.offsets[system + 1];
+
+        ValueType * x = sys.x;
+        ValueType * r = sys.vector(0);
+        ValueType * z = sys.vector(1);
+        ValueType * p = sys.vector(2);
+        ValueType * y = sys.vector(3);
+        ValueType * d = sys.vector(4);
+
+        sys.inverse_diagonal(team, begin, end, d);
+
+        // r <- b - A*x, z <- M*r, p <- z
+        sys.spmv(team, begin, end, x, y);
+
+        for (IndexType i = begin + team.rank(); i < end; i += team.size())
+        {
+            r[i] = sys.b[i] - y[i];
+            z[i] = d[i] * r[i];
+            p[i] = z[i];
+        }
+
+        const Real tolerance = sys.absolute_tolerance + sys.relative_tolerance * sys.nrm2(team, begin, end, sys.b);
+
+        ValueType rz = sys.dot(team, begin, end, r, z);
+        Real r_norm = sys.nrm2(team, begin, end, r);
+
+        size_t iteration = 0;
+
+        while (!(r_norm <= tolerance) && iteration < sys.iteration_limit)
+        {
+            // y <- Ap
+            sys.spmv(team, begin, end, p, y);
+
+            const ValueType yp = sys.dot(team, begin, end, y, p);
+
+            if (yp == ValueType(0))
+                break;
+
+            // alpha <- <r,z>/<y,p>
+            const ValueType alpha = rz / yp;
+
+            // x <- x + alpha * p, r <- r - alpha * y, z <- M*r
+            for (IndexType i = begin + team.rank(); i < end; i += team.size())
+            {
+                x[i] += alpha * p[i];
+                r[i] -= alpha * y[i];
+                z[i] = d[i] * r[i];
+            }
+
+            const ValueType rz_old = rz;
+
+            rz = sys.dot(team, begin, end, r, z);
+            r_norm = sys.nrm2(team, begin, end, r);
+
+            // p <- z + beta*p
+            const ValueType beta = rz / rz_old;
+
+            for (IndexType i = begin + team.rank(); i < end; i += team.size())
+                p[i] = z[i] + beta * p[i];
+
+            ++iteration;
+        }
+
+        sys.finish(team, system, iteration, r_norm, tolerance);
+    }
+};
+
+template <typename IndexType, typename ValueType>
+struct batched_bicgstab_method
+{
+    typedef typename norm_type<ValueType>::type Real;
+
+    batched_system<IndexType,ValueType> sys;
+
+    batched_bicgstab_method(const batched_system<IndexType,ValueType>& sys) : sys(sys) {}
+
+    template <typename Team>
+    __host__ __device__
+    void operator()(const Team& team, const size_t system) const
+    {
+        const IndexType begin = sys.offsets[system];
+        const IndexType end   = sys.offsets[system + 1];
+
+        ValueType * x      = sys.x;
+        ValueType * r      = sys.vector(0);
+        ValueType * r_star = sys.vector(1);
+        ValueType * p      = sys.vector(2);
+        ValueType * Mp     = sys.vector(3);
+        ValueType * AMp    = sys.vector(4);
+        ValueType * s      = sys.vector(5);
+        ValueType * Ms     = sys.vector(6);
+        ValueType * AMs    = sys.vector(7);
+        ValueType * d      = sys.vector(8);
+
+        sys.inverse_diagonal(team, begin, end, d);
+
+        // r <- b - A*x, p <- r, r_star <- r
+        sys.spmv(team, begin, end, x, AMp);
+
+        for (IndexType i = begin + team.rank(); i < end; i += team.size())
+        {
+            r[i] = sys.b[i] - AMp[i];
+            p[i] = r[i];
+            r_star[i] = r[i];
+        }
+
+        const Real tolerance = sys.absolute_tolerance + sys.relative_tolerance * sys.nrm2(team, begin, end, sys.b);
+
+        ValueType r_r_star_old = sys.dot(team, begin, end, r_star, r);
+        Real r_norm = sys.nrm2(team, begin, end, r);
+
+        size_t iteration = 0;
+
+        while (!(r_norm <= tolerance) && iteration < sys.iteration_limit)
+        {
+            // AMp <- A*M*p
+            for (IndexType i = begin + team.rank(); i < end; i += team.size())
+                Mp[i] = d[i] * p[i];
+
+            sys.spmv(team, begin, end, Mp, AMp);
+
+            const ValueType r_star_AMp = sys.dot(team, begin, end, r_star, AMp);
+
+            if (r_star_AMp == ValueType(0))
+                break;
+
+            // alpha = (r_j, r_star) / (A*M*p, r_star)
+            const ValueType alpha = r_r_star_old / r_star_AMp;
+
+            // s_j = r_j - alpha * AMp
+            for (IndexType i = begin + team.rank(); i < end; i += team.size())
+                s[i] = r[i] - alpha * AMp[i];
+
+            const Real s_norm = sys.nrm2(team, begin, end, s);
+
+            if (s_norm <= tolerance)
+            {
+                // x += alpha*M*p_j
+                for (IndexType i = begin + team.rank(); i < end; i += team.size())
+                    x[i] += alpha * Mp[i];
+
+                r_norm = s_norm;
+                break;
+            }
+
+            // AMs <- A*M*s
+            for (IndexType i = begin + team.rank(); i < end; i += team.size())
+                Ms[i] = d[i] * s[i];
+
+            sys.spmv(team, begin, end, Ms, AMs);
+
+            const ValueType AMs_AMs = sys.dot(team, begin, end, AMs, AMs);
+
+            if (AMs_AMs == ValueType(0))
+                break;
+
+            // omega = (AMs, s) / (AMs, AMs)
+            const ValueType omega = sys.dot(team, begin, end, AMs, s) / AMs_AMs;
+
+            // x_{j+1} = x_j + alpha*M*p_j + omega*M*s_j, r_{j+1} = s_j - omega*A*M*s
+            for (IndexType i = begin + team.rank(); i < end; i += team.size())
+            {
+                x[i] += alpha * Mp[i] + omega * Ms[i];
+                r[i] = s[i] - omega * AMs[i];
+            }
+
+            // beta_j = (r_{j+1}, r_star) / (r_j, r_star) * (alpha/omega)
+            const ValueType r_r_star_new = sys.dot(team, begin, end, r_star, r);
+            const ValueType beta = (r_r_star_new / r_r_star_old) * (alpha / omega);
+            r_r_star_old = r_r_star_new;
+
+            // p_{j+1} = r_{j+1} + beta*(p_j - omega*A*M*p)
+            for (IndexType i = begin + team.rank(); i < end; i += team.size())
+                p[i] = r[i] + beta * (p[i] - omega * AMp[i]);
+
+            r_norm = sys.nrm2(team, begin, end, r);
+
+            ++iteration;
+        }
+
+        sys.finish(team, system, iteration, r_norm, tolerance);
+    }
+};
+
+template <typename IndexType, typename ValueType>
+struct batched_gmres_method
+{
+    typedef typename norm_type<ValueType>::type Real;
+
+    batched_system<IndexType,ValueType> sys;
+
+    size_t restart;
+    ValueType * small;  // Hessenberg matrix, rotations and rhs of each system
+
+    batched_gmres_method(const batched_system<IndexType,ValueType>& sys, size_t restart, ValueType * small)
+        : sys(sys), restart(restart), small(small) {}
+
+    static size_t small_size(const size_t restart)
+    {
+        return (restart + 1) * restart + 3 * restart + 1;
+    }
+
+    __host__ __device__
+    static void plane_rotation(ValueType * H, const size_t ld, ValueType * cs, ValueType * sn, ValueType * g, const size_t i)
+    {
+        for (size_t k = 0; k < i; k++)
+        {
+            const ValueType t = cs[k] * H[i * ld + k] + sn[k] * H[i * ld + k + 1];
+            H[i * ld + k + 1] = -sn[k] * H[i * ld + k] + cs[k] * H[i * ld + k + 1];
+            H[i * ld + k] = t;
+        }
+
+        const ValueType dx = H[i * ld + i];
+        const ValueType dy = H[i * ld + i + 1];
+
+        if (dy == ValueType(0))
+        {
+            cs[i] = 1;
+            sn[i] = 0;
+        }
+        else if (abs(dy) > abs(dx))
+        {
+            const ValueType t = dx / dy;
+            sn[i] = ValueType(1) / sqrt(ValueType(1) + t * t);
+            cs[i] = t * sn[i];
+        }
+        else
+        {
+            const ValueType t = dy / dx;
+            cs[i] = ValueType(1) / sqrt(ValueType(1) + t * t);
+            sn[i] = t * cs[i];
+        }
+
+        H[i * ld + i] = cs[i] * dx + sn[i] * dy;
+        H[i * ld + i + 1] = 0;
+
+        const ValueType t = cs[i] * g[i] + sn[i] * g[i + 1];
+        g[i + 1] = -sn[i] * g[i] + cs[i] * g[i + 1];
+        g[i] = t;
+    }
+
+    template <typename Team>
+    __host__ __device__
+    void operator()(const Team& team, const size_t system) const
+    {
+        const IndexType begin = sys.offsets[system];
+        const IndexType end   = sys.offsets[system + 1];
+
+        const size_t m  = restart;
+        const size_t ld = m + 1;
+
+        ValueType * x = sys.x;
+        ValueType * w = sys.vector(m + 1);
+        ValueType * z = sys.vector(m + 2);
+        ValueType * d = sys.vector(m + 3);
+
+        ValueType * H  = small + system * small_size(m);
+        ValueType * cs = H + ld * m;
+        ValueType * sn = cs + m;
+        ValueType * g  = sn + m;
+
+        sys.inverse_diagonal(team, begin, end, d);
+
+        const Real tolerance = sys.absolute_tolerance + sys.relative_tolerance * sys.nrm2(team, begin, end, sys.b);
+
+        Real r_norm = 0;
+        size_t iteration = 0;
+
+        while (true)
+        {
+            // w <- b - A*x
+            sys.spmv(team, begin, end, x, w);
+
+            for (IndexType i = begin + team.rank(); i < end; i += team.size())
+                w[i] = sys.b[i] - w[i];
+
+            const Real beta = sys.nrm2(team, begin, end, w);
+
+            r_norm = beta;
+
+            if (r_norm <= tolerance || iteration >= sys.iteration_limit)
+                break;
+
+            // V(0) <- w / beta
+            ValueType * V0 = sys.vector(0);
+            for (IndexType i = begin + team.rank(); i < end; i += team.size())
+                V0[i] = w[i] / beta;
+
+            if (team.rank() == 0)
+            {
+                for (size_t k = 0; k <= m; k++)
+                    g[k] = 0;
+                g[0] = beta;
+            }
+
+            size_t j = 0;
+
+            while (j < m)
+            {
+                ValueType * Vj = sys.vector(j);
+                ValueType * Vn = sys.vector(j + 1);
+
+                // w <- A*M*V(j)
+                for (IndexType i = begin + team.rank(); i < end; i += team.size())
+                    z[i] = d[i] * Vj[i];
+
+                sys.spmv(team, begin, end, z, w);
+
+                // modified Gram-Schmidt
+                for (size_t k = 0; k <= j; k++)
+                {
+                    ValueType * Vk = sys.vector(k);
+
+                    const ValueType h = sys.dot(team, begin, end, Vk, w);
+
+                    for (IndexType i = begin + team.rank(); i < end; i += team.size())
+                        w[i] -= h * Vk[i];
+
+                    if (team.rank() == 0)
+                        H[j * ld + k] = h;
+                }
+
+                const Real h = sys.nrm2(team, begin, end, w);
+
+                // V(j+1) <- w / h, a zero h means the solution lies in the basis
+                for (IndexType i = begin + team.rank(); i < end; i += team.size())
+                    Vn[i] = (h == Real(0)) ? ValueType(0) : w[i] / h;
+
+                if (team.rank() == 0)
+                {
+                    H[j * ld + j + 1] = h;
+                    plane_rotation(H, ld, cs, sn, g, j);
+                }
+
+                team.sync();
+
+                r_norm = abs(g[j + 1]);
+
+                ++j;
+                ++iteration;
+
+                if (r_norm <= tolerance || iteration >= sys.iteration_limit)
+                    break;
+            }
+
+            // solve the upper triangular system in place
+            if (team.rank() == 0)
+            {
+                for (size_t c = j; c-- > 0; )
+                {
+                    g[c] /= H[c * ld + c];
+                    for (size_t k = 0; k < c; k++)
+                        g[k] -= H[c * ld + k] * g[c];
+                }
+            }
+
+            team.sync();
+
+            // x <- x + M*V(0:j)*g(0:j)
+            for (IndexType i = begin + team.rank(); i < end; i += team.size())
+            {
+                ValueType sum = 0;
+                for (size_t k = 0; k < j; k++)
+                    sum += sys.vector(k)[i] * g[k];
+                x[i] += d[i] * sum;
+            }
+
+            if (r_norm <= tolerance || iteration >= sys.iteration_limit)
+                break;
+        }
+
+        sys.finish(team, system, iteration, r_norm, tolerance);
+    }
+};
+
+template <typename ValueType, typename Method>
+void batched_launch(const Method& method, const size_t num_systems, cusp::host_memory)
+{
+    batched_serial_team team;
+
+    for (size_t system = 0; system < num_systems; system++)
+        method(team, system);
+}
+
+template <typename ValueType, typename Method>
+void batched_launch(const Method& method, const size_t num_systems, cusp::device_memory)
+{
+    cusp::krylov::detail::device::batched_launch<ValueType>(method, num_systems);
+}
+
+// results of a batched solve in the memory space of the systems
+template <typename Real, typename MemorySpace>
+struct batched_results
+{
+    cusp::array1d<int,MemorySpace>  iterations;
+    cusp::array1d<Real,MemorySpace> residuals;
+    cusp::array1d<int,MemorySpace>  converged;
+
+    batched_results(const size_t num_systems)
+        : iterations(num_systems), residuals(num_systems), converged(num_systems) {}
+};
+
+template <typename Matrix, typename Array1, typename Array2, typename Array3, typename Monitor, typename Array, typename Results>
+batched_system<typename Matrix::index_type, typename Matrix::value_type>
+make_batched_system(const Matrix& A, Array1& x, const Array2& b, const Array3& offsets,
+                    const Monitor& monitor, const batched_preconditioner preconditioner,
+                    Array& work, Results& results)
+{
+    batched_system<typename Matrix::index_type, typename Matrix::value_type> sys;
+
+    assert(A.num_rows == A.num_cols);        // sanity check
+    assert(offsets.size() > 0);
+
+    sys.row_offsets    = thrust::raw_pointer_cast(&A.row_offsets[0]);
+    sys.column_indices = thrust::raw_pointer_cast(&A.column_indices[0]);
+    sys.values         = thrust::raw_pointer_cast(&A.values[0]);
+    sys.offsets        = thrust::raw_pointer_cast(&offsets[0]);
+
+    sys.x = thrust::raw_pointer_cast(&x[0]);
+    sys.b = thrust::raw_pointer_cast(&b[0]);
+
+    sys.work = thrust::raw_pointer_cast(&work[0]);
+    sys.N    = A.num_rows;
+
+    sys.iterations = thrust::raw_pointer_cast(&results.iterations[0]);
+    sys.residuals  = thrust::raw_pointer_cast(&results.residuals[0]);
+    sys.converged  = thrust::raw_pointer_cast(&results.converged[0]);
+
+    sys.iteration_limit    = monitor.iteration_limit();
+    sys.relative_tolerance = monitor.relative_tolerance();
+    sys.absolute_tolerance = monitor.absolute_tolerance();
+    sys.jacobi             = preconditioner == BATCHED_JACOBI;
+
+    return sys;
+}
+
+// pattern row i of system s -> s * nnz + pattern.row_offsets[i]
+template <typename IndexType>
+struct batched_row_offsets_functor
+{
+    const IndexType * row_offsets;
+    IndexType num_rows;
+    IndexType num_entries;
+
+    batched_row_offsets_functor(const IndexType * row_offsets, IndexType num_rows, IndexType num_entries)
+        : row_offsets(row_offsets), num_rows(num_rows), num_entries(num_entries) {}
+
+    __host__ __device__
+    IndexType operator()(const IndexType idx) const
+    {
+        const IndexType s = idx / num_rows;
+        return s * num_entries + row_offsets[idx - s * num_rows];
+    }
+};
+
+// pattern entry k of system s -> s * num_cols + pattern.column_indices[k]
+template <typename IndexType>
+struct batched_column_indices_functor
+{
+    const IndexType * column_indices;
+    IndexType num_cols;
+    IndexType num_entries;
+
+    batched_column_indices_functor(const IndexType * column_indices, IndexType num_cols, IndexType num_entries)
+        : column_indices(column_indices), num_cols(num_cols), num_entries(num_entries) {}
+
+    __host__ __device__
+    IndexType operator()(const IndexType idx) const
+    {
+        const IndexType s = idx / num_entries;
+        return s * num_cols + column_indices[idx - s * num_entries];
+    }
+};
+
+} // end namespace detail
+
+template <typename Matrix1, typename Array1, typename Matrix2, typename Array2>
+void batched_block_diagonal(const Matrix1& pattern,
+                            const Array1& values,
+                            const size_t num_systems,
+                            Matrix2& A,
+                            Array2& offsets)
+{
+    typedef typename Matrix2::index_type IndexType;
+
+    assert(pattern.num_rows == pattern.num_cols);                  // sanity check
+    assert(values.size() == num_systems * pattern.num_entries);
+
+    const IndexType n   = pattern.num_rows;
+    const IndexType nnz = pattern.num_entries;
+
+    A.resize(num_systems * n, num_systems * n, num_systems * nnz);
+
+    thrust::transform(thrust::counting_iterator<IndexType>(0),
+                      thrust::counting_iterator<IndexType>(num_systems * n),
+                      A.row_offsets.begin(),
+                      detail::batched_row_offsets_functor<IndexType>(thrust::raw_pointer_cast(&pattern.row_offsets[0]), n, nnz));
+    A.row_offsets[num_systems * n] = num_systems * nnz;
+
+    thrust::transform(thrust::counting_iterator<IndexType>(0),
+                      thrust::counting_iterator<IndexType>(num_systems * nnz),
+                      A.column_indices.begin(),
+                      detail::batched_column_indices_functor<IndexType>(thrust::raw_pointer_cast(&pattern.column_indices[0]), n, nnz));
+
+    thrust::copy(values.begin(), values.end(), A.values.begin());
+
+    offsets.resize(num_systems + 1);
+    thrust::sequence(offsets.begin(), offsets.end(), IndexType(0), n);
+}
+
+template <class Matrix,
+          class Array1,
+          class Array2,
+          class Array3,
+          class Monitor>
+void batched_cg(const Matrix& A,
+                Array1& x,
+                const Array2& b,
+                const Array3& offsets,
+                Monitor& monitor,
+                const batched_preconditioner preconditioner)
+{
+    typedef typename Matrix::value_type   ValueType;
+    typedef typename Matrix::memory_space MemorySpace;
+
+    cusp::krylov::workspace<ValueType,MemorySpace> workspace;
+
+    cusp::krylov::batched_cg(A, x, b, offsets, monitor, preconditioner, workspace);
+}
+
+template <class Matrix,
+          class Array1,
+          class Array2,
+          class Array3,
+          class Monitor,
+          class Workspace>
+void batched_cg(const Matrix& A,
+                Array1& x,
+                const Array2& b,
+                const Array3& offsets,
+                Monitor& monitor,
+                const batched_preconditioner preconditioner,
+                Workspace& workspace)
+{
+    CUSP_PROFILE_SCOPED();
+
+    typedef typename Matrix::index_type   IndexType;
+    typedef typename Matrix::value_type   ValueType;
+    typedef typename Matrix::memory_space MemorySpace;
+    typedef typename norm_type<ValueType>::type Real;
+
+    const size_t num_systems = offsets.size() - 1;
+
+    detail::batched_results<Real,MemorySpace> results(num_systems);
+
+    detail::batched_cg_method<IndexType,ValueType> method
+        (detail::make_batched_system(A, x, b, offsets, monitor, preconditioner,
+                                     workspace.vector(0, 5 * A.num_rows), results));
+
+    detail::batched_launch<ValueType>(method, num_systems, MemorySpace());
+
+    monitor.record(results.iterations, results.residuals, results.converged);
+}
+
+template <class Matrix,
+          class Array1,
+          class Array2,
+          class Array3,
+          class Monitor>
+void batched_bicgstab(const Matrix& A,
+                      Array1& x,
+                      const Array2& b,
+                      const Array3& offsets,
+                      Monitor& monitor,
+                      const batched_preconditioner preconditioner)
+{
+    typedef typename Matrix::value_type   ValueType;
+    typedef typename Matrix::memory_space MemorySpace;
+
+    cusp::krylov::workspace<ValueType,MemorySpace> workspace;
+
+    cusp::krylov::batched_bicgstab(A, x, b, offsets, monitor, preconditioner, workspace);
+}
+
+template <class Matrix,
+          class Array1,
+          class Array2,
+          class Array3,
+          class Monitor,
+          class Workspace>
+void batched_bicgstab(const Matrix& A,
+                      Array1& x,
+                      const Array2& b,
+                      const Array3& offsets,
+                      Monitor& monitor,
+                      const batched_preconditioner preconditioner,
+                      Workspace& workspace)
+{
+    CUSP_PROFILE_SCOPED();
+
+    typedef typename Matrix::index_type   IndexType;
+    typedef typename Matrix::value_type   ValueType;
+    typedef typename Matrix::memory_space MemorySpace;
+    typedef typename norm_type<ValueType>::type Real;
+
+    const size_t num_systems = offsets.size() - 1;
+
+    detail::batched_results<Real,MemorySpace> results(num_systems);
+
+    detail::batched_bicgstab_method<IndexType,ValueType> method
+        (detail::make_batched_system(A, x, b, offsets, monitor, preconditioner,
+                                     workspace.vector(0, 9 * A.num_rows), results));
+
+    detail::batched_launch<ValueType>(method, num_systems, MemorySpace());
+
+    monitor.record(results.iterations, results.residuals, results.converged);
+}
+
+template <class Matrix,
+          class Array1,
+          class Array2,
+          class Array3,
+          class Monitor>
+void batched_gmres(const Matrix& A,
+                   Array1& x,
+                   const Array2& b,
+                   const Array3& offsets,
+                   const size_t restart,
+                   Monitor& monitor,
+                   const batched_preconditioner preconditioner)
+{
+    typedef typename Matrix::value_type   ValueType;
+    typedef typename Matrix::memory_space MemorySpace;
+
+    cusp::krylov::workspace<ValueType,MemorySpace> workspace;
+
+    cusp::krylov::batched_gmres(A, x, b, offsets, restart, monitor, preconditioner, workspace);
+}
+
+template <class Matrix,
+          class Array1,
+          class Array2,
+          class Array3,
+          class Monitor,
+          class Workspace>
+void batched_gmres(const Matrix& A,
+                   Array1& x,
+                   const Array2& b,
+                   const Array3& offsets,
+                   const size_t restart,
+                   Monitor& monitor,
+                   const batched_preconditioner preconditioner,
+                   Workspace& workspace)
+{
+    CUSP_PROFILE_SCOPED();
+
+    typedef typename Matrix::index_type   IndexType;
+    typedef typename Matrix::value_type   ValueType;
+    typedef typename Matrix::memory_space MemorySpace;
+    typedef typename norm_type<ValueType>::type Real;
+    typedef detail::batched_gmres_method<IndexType,ValueType> Method;
+
+    assert(restart > 0);
+
+    const size_t num_systems = offsets.size() - 1;
+
+    detail::batched_results<Real,MemorySpace> results(num_systems);
+
+    // basis V(0:restart+1), w, z and the inverse diagonal
+    typename Workspace::vector_type& work  = workspace.vector(0, (restart + 4) * A.num_rows);
+    typename Workspace::vector_type& small = workspace.vector(1, num_systems * Method::small_size(restart));
+
+    Method method(detail::make_batched_system(A, x, b, offsets, monitor, preconditioner, work, results),
+                  restart, thrust::raw_pointer_cast(&small[0]));
+
+    detail::batched_launch<ValueType>(method, num_systems, MemorySpace());
+
+    monitor.record(results.iterations, results.residuals, results.converged);
+}
+
+} // end namespace krylov
+} // end namespace cusp
+
@@ -29,9 +29,10 @@ namespace krylov
 {
 
 template <class LinearOperator,
+          class TransposeOperator,
           class Vector>
 void bicg(LinearOperator& A,
-	  LinearOperator& At,
+	  TransposeOperator& At,
 	  Vector& x,
 	  Vector& b)
 {
@@ -43,10 +44,11 @@ void bicg(LinearOperator& A,
 }
 
 template <class LinearOperator,
+          class TransposeOperator,
           class Vector,
           class Monitor>
 void bicg(LinearOperator& A,
-	  LinearOperator& At,
+	  TransposeOperator& At,
 	  Vector& x,
 	  Vector& b,
 	  Monitor& monitor)
@@ -60,37 +62,60 @@ void bicg(LinearOperator& A,
 }
 
 template <class LinearOperator,
+          class TransposeOperator,
           class Vector,
           class Monitor,
           class Preconditioner>
 void bicg(LinearOperator& A,
-	  LinearOperator& At,
+	  TransposeOperator& At,
 	  Vector& x,
 	  Vector& b,
 	  Monitor& monitor,
 	  Preconditioner& M,
 	  Preconditioner& Mt)
+{
+    typedef typename LinearOperator::value_type   ValueType;
+    typedef typename LinearOperator::memory_space MemorySpace;
+
+    cusp::krylov::workspace<ValueType,MemorySpace> workspace;
+
+    cusp::krylov::bicg(A, At, x, b, monitor, M, Mt, workspace);
+}
+
+template <class LinearOperator,
+          class TransposeOperator,
+          class Vector,
+          class Monitor,
+          class Preconditioner,
+          class Workspace>
+void bicg(LinearOperator& A,
+	  TransposeOperator& At,
+	  Vector& x,
+	  Vector& b,
+	  Monitor& monitor,
+	  Preconditioner& M,
+	  Preconditioner& Mt,
+	  Workspace& workspace)
 {
     CUSP_PROFILE_SCOPED();
 
     typedef typename LinearOperator::value_type   ValueType;
-    typedef typename LinearOperator::memory_space MemorySpace;
+    typedef typename Workspace::vector_type       Array;
 
     assert(A.num_rows == A.num_cols);        // sanity check
 
     const size_t N = A.num_rows;
 
-    // allocate workspace
-    cusp::array1d<ValueType,MemorySpace> y(N);
-
-    cusp::array1d<ValueType,MemorySpace>   p(N);
-    cusp::array1d<ValueType,MemorySpace>   p_star(N);
-    cusp::array1d<ValueType,MemorySpace>   q(N);
-    cusp::array1d<ValueType,MemorySpace>   q_star(N);
-    cusp::array1d<ValueType,MemorySpace>   r(N);
-    cusp::array1d<ValueType,MemorySpace>   r_star(N);
-    cusp::array1d<ValueType,MemorySpace>   z(N);
-    cusp::array1d<ValueType,MemorySpace>   z_star(N);
+    // get workspace
+    Array& y      = workspace.vector(0, N);
+    Array& p      = workspace.vector(1, N);
+    Array& p_star = workspace.vector(2, N);
+    Array& q      = workspace.vector(3, N);
+    Array& q_star = workspace.vector(4, N);
+    Array& r      = workspace.vector(5, N);
+    Array& r_star = workspace.vector(6, N);
+    Array& z      = workspace.vector(7, N);
+    Array& z_star = workspace.vector(8, N);
 
     // y <- Ax
     cusp::multiply(A, x, y);
@@ -21,6 +21,8 @@
 #include <cusp/monitor.h>
 #include <cusp/linear_operator.h>
 
+#include <algorithm>
+
 namespace blas = cusp::blas;
 
 namespace cusp
@@ -66,27 +68,46 @@ void bicgstab(LinearOperator& A,
               Vector& b,
               Monitor& monitor,
               Preconditioner& M)
+{
+    typedef typename LinearOperator::value_type   ValueType;
+    typedef typename LinearOperator::memory_space MemorySpace;
+
+    cusp::krylov::workspace<ValueType,MemorySpace> workspace;
+
+    cusp::krylov::bicgstab(A, x, b, monitor, M, workspace);
+}
+
+template <class LinearOperator,
+          class Vector,
+          class Monitor,
+          class Preconditioner,
+          class Workspace>
+void bicgstab(LinearOperator& A,
+              Vector& x,
+              Vector& b,
+              Monitor& monitor,
+              Preconditioner& M,
+              Workspace& workspace)
 {
     CUSP_PROFILE_SCOPED();
 
     typedef typename LinearOperator::value_type   ValueType;
-    typedef typename LinearOperator::memory_space MemorySpace;
+    typedef typename Workspace::vector_type       Array;
 
     assert(A.num_rows == A.num_cols);        // sanity check
 
     const size_t N = A.num_rows;
 
-    // allocate workspace
-    cusp::array1d<ValueType,MemorySpace> y(N);
-
-    cusp::array1d<ValueType,MemorySpace>   p(N);
-    cusp::array1d<ValueType,MemorySpace>   r(N);
-    cusp::array1d<ValueType,MemorySpace>   r_star(N);
-    cusp::array1d<ValueType,MemorySpace>   s(N);
-    cusp::array1d<ValueType,MemorySpace>  Mp(N);
-    cusp::array1d<ValueType,MemorySpace> AMp(N);
-    cusp::array1d<ValueType,MemorySpace>  Ms(N);
-    cusp::array1d<ValueType,MemorySpace> AMs(N);
+    // get workspace
+    Array& y      = workspace.vector(0, N);
+    Array& p      = workspace.vector(1, N);
+    Array& r      = workspace.vector(2, N);
+    Array& r_star = workspace.vector(3, N);
+    Array& s      = workspace.vector(4, N);
+    Array& Mp     = workspace.vector(5, N);
+    Array& AMp    = workspace.vector(6, N);
+    Array& Ms     = workspace.vector(7, N);
+    Array& AMs    = workspace.vector(8, N);
 
     // y <- Ax
     cusp::multiply(A, x, y);
@@ -128,8 +149,9 @@ void bicgstab(LinearOperator& A,
         // AMs = A*Ms
         cusp::multiply(A, Ms, AMs);
 
-        // omega = (AMs, s) / (AMs, AMs)
-        ValueType omega = blas::dotc(AMs, s) / blas::dotc(AMs, AMs);
+        // omega = (AMs, s) / (AMs, AMs), both dot products in one pass
+        thrust::pair<ValueType,ValueType> AMs_dots = blas::dotc2(AMs, s, AMs);
+        ValueType omega = AMs_dots.first / AMs_dots.second;
         
         // x_{j+1} = x_j + alpha*M*p_j + omega*M*s_j
         blas::axpbypcz(x, Mp, Ms, x, ValueType(1), alpha, omega);
@@ -149,6 +171,192 @@ void bicgstab(LinearOperator& A,
     }
 }
 
+namespace detail
+{
+
+// x <- x + y, r <- b - A*x in high precision, r_low <- r and y <- 0
+template <class LinearOperator,
+          class Vector1,
+          class Vector2,
+          class Vector3,
+          class LowVector>
+void reliable_update(LinearOperator& A,
+                     Vector1& x,
+                     Vector2& b,
+                     Vector3& r,
+                     LowVector& y,
+                     LowVector& r_low)
+{
+    typedef typename Vector3::value_type   ValueType;
+    typedef typename LowVector::value_type LowValueType;
+
+    // r <- y in high precision, then x <- x + y
+    r = y;
+    blas::axpy(r, x, ValueType(1));
+    blas::fill(y, LowValueType(0));
+
+    // r <- b - A*x
+    cusp::multiply(A, x, r);
+    blas::axpby(b, r, r, ValueType(1), ValueType(-1));
+
+    r_low = r;
+}
+
+} // end namespace detail
+
+template <class LinearOperator,
+          class LowPrecisionOperator,
+          class Vector,
+          class Monitor>
+void reliable_bicgstab(LinearOperator& A,
+                       LowPrecisionOperator& A_low,
+                       Vector& x,
+                       Vector& b,
+                       Monitor& monitor)
+{
+    typedef typename LowPrecisionOperator::value_type   LowValueType;
+    typedef typename LowPrecisionOperator::memory_space LowMemorySpace;
+
+    cusp::identity_operator<LowValueType,LowMemorySpace> M(A_low.num_rows, A_low.num_cols);
+
+    cusp::krylov::reliable_bicgstab(A, A_low, x, b, monitor, M);
+}
+
+template <class LinearOperator,
+          class LowPrecisionOperator,
+          class Vector,
+          class Monitor,
+          class Preconditioner>
+void reliable_bicgstab(LinearOperator& A,
+                       LowPrecisionOperator& A_low,
+                       Vector& x,
+                       Vector& b,
+                       Monitor& monitor,
+                       Preconditioner& M,
+                       const double delta)
+{
+    CUSP_PROFILE_SCOPED();
+
+    typedef typename LinearOperator::value_type         ValueType;
+    typedef typename LinearOperator::memory_space       MemorySpace;
+    typedef typename LowPrecisionOperator::value_type   LowValueType;
+    typedef typename LowPrecisionOperator::memory_space LowMemorySpace;
+    typedef typename norm_type<ValueType>::type         NormType;
+    typedef cusp::array1d<LowValueType,LowMemorySpace>  LowArray;
+
+    assert(A.num_rows == A.num_cols);        // sanity check
+    assert(A.num_rows == A_low.num_rows && A.num_cols == A_low.num_cols);
+
+    const size_t N = A.num_rows;
+
+    // true residual in high precision
+    cusp::array1d<ValueType,MemorySpace> r_high(N);
+
+    // iteration vectors and the solution accumulated since the last
+    // reliable update in low precision
+    LowArray y(N, LowValueType(0));
+    LowArray p(N);
+    LowArray r(N);
+    LowArray r_star(N);
+    LowArray s(N);
+    LowArray Mp(N);
+    LowArray AMp(N);
+    LowArray Ms(N);
+    LowArray AMs(N);
+
+    // r <- b - A*x
+    detail::reliable_update(A, x, b, r_high, y, r);
+
+    // p <- r
+    blas::copy(r, p);
+
+    // r_star <- r
+    blas::copy(r, r_star);
+
+    LowValueType r_r_star_old = blas::dotc(r_star, r);
+
+    // largest iterated residual norm since the last reliable update
+    NormType max_r_norm = blas::nrm2(r_high);
+
+    while (true)
+    {
+        if (monitor.finished(r))
+        {
+            if (!monitor.converged())
+                break;
+
+            // accept convergence only for the true residual, otherwise
+            // restart from it
+            detail::reliable_update(A, x, b, r_high, y, r);
+
+            if (monitor.finished(r_high))
+                break;
+
+            blas::copy(r, p);
+            r_r_star_old = blas::dotc(r_star, r);
+            max_r_norm = NormType(monitor.residual_norm());
+        }
+        else
+        {
+            NormType r_norm = NormType(monitor.residual_norm());
+
+            max_r_norm = std::max(max_r_norm, r_norm);
+
+            // the iterated residual lost a factor delta since the last
+            // update: replace it by the true residual
+            if (r_norm < delta * max_r_norm)
+            {
+                detail::reliable_update(A, x, b, r_high, y, r);
+
+                r_r_star_old = blas::dotc(r_star, r);
+                max_r_norm = blas::nrm2(r_high);
+            }
+        }
+
+        // Mp = M*p
+        cusp::multiply(M, p, Mp);
+
+        // AMp = A*Mp
+        cusp::multiply(A_low, Mp, AMp);
+
+        // alpha = (r_j, r_star) / (A*M*p, r_star)
+        LowValueType alpha = r_r_star_old / blas::dotc(r_star, AMp);
+
+        // s_j = r_j - alpha * AMp
+        blas::axpby(r, AMp, s, LowValueType(1), LowValueType(-alpha));
+
+        // Ms = M*s_j
+        cusp::multiply(M, s, Ms);
+
+        // AMs = A*Ms
+        cusp::multiply(A_low, Ms, AMs);
+
+        // omega = (AMs, s) / (AMs, AMs), both dot products in one pass
+        thrust::pair<LowValueType,LowValueType> AMs_dots = blas::dotc2(AMs, s, AMs);
+        LowValueType omega = AMs_dots.first / AMs_dots.second;
+
+        // y_{j+1} = y_j + alpha*M*p_j + omega*M*s_j
+        blas::axpbypcz(y, Mp, Ms, y, LowValueType(1), alpha, omega);
+
+        // r_{j+1} = s_j - omega*A*M*s
+        blas::axpby(s, AMs, r, LowValueType(1), -omega);
+
+        // beta_j = (r_{j+1}, r_star) / (r_j, r_star) * (alpha/omega)
+        LowValueType r_r_star_new = blas::dotc(r_star, r);
+        LowValueType beta = (r_r_star_new / r_r_star_old) * (alpha / omega);
+        r_r_star_old = r_r_star_new;
+
+        // p_{j+1} = r_{j+1} + beta*(p_j - omega*A*M*p)
+        blas::axpbypcz(r, p, AMp, p, LowValueType(1), beta, -beta*omega);
+
+        ++monitor;
+    }
+
+    // x <- x + y for the iterations since the last reliable update
+    if (!monitor.converged())
+        detail::reliable_update(A, x, b, r_high, y, r);
+}
+
 } // end namespace krylov
 } // end namespace cusp
 
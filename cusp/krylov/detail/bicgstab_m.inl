@@ -19,6 +19,9 @@
 #include <cusp/multiply.h>
 #include <cusp/monitor.h>
 
+#include <cusp/detail/stream.h>
+#include <cusp/krylov/detail/multishift.h>
+
 #include <thrust/copy.h>
 #include <thrust/fill.h>
 #include <thrust/functional.h>
@@ -26,7 +29,11 @@
 #include <thrust/transform_reduce.h>
 #include <thrust/inner_product.h>
 
+#include <thrust/iterator/counting_iterator.h>
 #include <thrust/iterator/transform_iterator.h>
+#include <thrust/iterator/zip_iterator.h>
+
+#include <cmath>
 
 
 /*
@@ -575,6 +582,182 @@ namespace trans_m
 
 } // end namespace trans_m
 
+namespace detail
+{
+
+// number of per-shift factors of the x^\sigma and s^\sigma updates
+const size_t bicgstab_m_num_factors = 6;
+
+// (Aw, w) -> (conj(Aw) w, conj(Aw) Aw)
+template <typename ValueType>
+struct bicgstab_m_chi_functor
+{
+    typedef thrust::tuple<ValueType,ValueType> result_type;
+
+    template <typename Tuple>
+    __host__ __device__
+    result_type operator()(Tuple t) const
+    {
+        const ValueType Aw = cusp::blas::detail::conjugate<ValueType>()(thrust::get<0>(t));
+
+        return result_type(Aw * thrust::get<1>(t), Aw * thrust::get<0>(t));
+    }
+};
+
+// r_1 <- w_1 - chi_0 Aw, returns (conj(w_0) r_1, conj(r_1) r_1)
+template <typename ValueType>
+struct bicgstab_m_residual_functor
+{
+    typedef thrust::tuple<ValueType,ValueType> result_type;
+
+    const ValueType chi_0;
+
+    bicgstab_m_residual_functor(const ValueType chi_0) : chi_0(chi_0) {}
+
+    // (w_1, Aw, r_1, w_0)
+    template <typename Tuple>
+    __host__ __device__
+    result_type operator()(Tuple t) const
+    {
+        const ValueType r = thrust::get<0>(t) - chi_0 * thrust::get<1>(t);
+        thrust::get<2>(t) = r;
+
+        cusp::blas::detail::conjugate<ValueType> conj;
+
+        return result_type(conj(thrust::get<3>(t)) * r, conj(r) * r);
+    }
+};
+
+// \zeta_1^\sigma, \beta_0^\sigma, \chi_0^\sigma, \rho_1^\sigma and
+// \alpha_0^\sigma of one shift in a single pass.  Stores the factors of
+// the x^\sigma and s^\sigma updates, recycles \zeta_i^\sigma, \rho_i^\sigma
+// and advances the shift state.
+template <typename ValueType, typename NormType>
+struct bicgstab_m_coefficients_functor
+{
+    const size_t N_s;
+    const ValueType beta_m1;
+    const ValueType beta_0;
+    const ValueType alpha_m1;
+    const ValueType alpha_0;
+    const ValueType chi_0;
+    const NormType  limit;
+    ValueType * factors;
+
+    bicgstab_m_coefficients_functor(const size_t N_s,
+                                    const ValueType beta_m1, const ValueType beta_0,
+                                    const ValueType alpha_m1, const ValueType alpha_0,
+                                    const ValueType chi_0, const NormType limit,
+                                    ValueType * factors)
+        : N_s(N_s), beta_m1(beta_m1), beta_0(beta_0), alpha_m1(alpha_m1),
+          alpha_0(alpha_0), chi_0(chi_0), limit(limit), factors(factors)
+    {}
+
+    // (z_m1, z_0, rho_0, sigma, state, shift)
+    template <typename Tuple>
+    __host__ __device__
+    void operator()(Tuple t) const
+    {
+        const ValueType zm1   = thrust::get<0>(t);
+        const ValueType z0    = thrust::get<1>(t);
+        const ValueType rho0  = thrust::get<2>(t);
+        const ValueType sigma = thrust::get<3>(t);
+        const size_t s = thrust::get<5>(t);
+
+        ValueType z1 = z0*zm1*beta_m1/(beta_0*alpha_m1*(zm1-z0)
+                                      +beta_m1*zm1*(ValueType(1)-beta_0*sigma));
+        const ValueType b0 = beta_0*z1/z0;
+
+        if (abs(z1) < NormType(1e-30))
+            z1 = ValueType(1e-18);
+
+        const ValueType den  = ValueType(1)+chi_0*sigma;
+        const ValueType c0   = chi_0/den;
+        const ValueType rho1 = rho0/den;
+        const ValueType a0   = alpha_0/beta_0*z1*b0/z0;
+        const ValueType c    = a0*c0*rho0/b0;
+
+        // x <- x + f_0 s + f_1 w_1
+        factors[0 * N_s + s] = -b0;
+        factors[1 * N_s + s] = c0*rho0*z1;
+
+        // s <- f_2 r_1 + f_3 s + f_4 w_1 + f_5 r_0
+        factors[2 * N_s + s] = z1*rho1;
+        factors[3 * N_s + s] = a0;
+        factors[4 * N_s + s] = -c*z1;
+        factors[5 * N_s + s] = c*z0;
+
+        thrust::get<0>(t) = z0;
+        thrust::get<1>(t) = z1;
+        thrust::get<2>(t) = rho1;
+
+        // the residual of the shifted system is \zeta_1^\sigma \rho_1^\sigma r
+        thrust::get<4>(t) = multishift_next_state(thrust::get<4>(t), z1*rho1, limit);
+    }
+};
+
+// s_0 and x^\sigma, s^\sigma of all shifts for one row, so r_0, r_1 and
+// w_1 are read once and the vectors of converged shifts are not touched
+template <typename ValueType>
+struct bicgstab_m_update_functor
+{
+    const size_t N;
+    const size_t N_s;
+    const ValueType alpha_0;
+    const ValueType chi_0;
+    const ValueType * factors;
+    const int * state;
+    ValueType * x;
+    ValueType * s_s;
+
+    bicgstab_m_update_functor(const size_t N, const size_t N_s,
+                              const ValueType alpha_0, const ValueType chi_0,
+                              const ValueType * factors, const int * state,
+                              ValueType * x, ValueType * s_s)
+        : N(N), N_s(N_s), alpha_0(alpha_0), chi_0(chi_0),
+          factors(factors), state(state), x(x), s_s(s_s)
+    {}
+
+    // (r_0, r_1, w_1, s_0, As, row)
+    template <typename Tuple>
+    __host__ __device__
+    void operator()(Tuple t) const
+    {
+        const ValueType r0 = thrust::get<0>(t);
+        const ValueType r1 = thrust::get<1>(t);
+        const ValueType w1 = thrust::get<2>(t);
+        const size_t i = thrust::get<5>(t);
+
+        thrust::get<3>(t) = r1 + alpha_0 * (thrust::get<3>(t) - chi_0 * thrust::get<4>(t));
+
+        for (size_t s = 0; s < N_s; s++)
+        {
+            if (state[s] == multishift_frozen)
+                continue;
+
+            const size_t k = s * N + i;
+            const ValueType p = s_s[k];
+
+            x[k]   = x[k] + factors[0 * N_s + s] * p + factors[1 * N_s + s] * w1;
+            s_s[k] = factors[2 * N_s + s] * r1 + factors[3 * N_s + s] * p
+                   + factors[4 * N_s + s] * w1 + factors[5 * N_s + s] * r0;
+        }
+    }
+};
+
+struct bicgstab_m_solver
+{
+    template <class LinearOperator, class VectorType1, class VectorType2,
+              class VectorType3, class Monitor>
+    void operator()(LinearOperator& A, VectorType1& x, VectorType2& b,
+                    VectorType3& sigma, Monitor& monitor) const
+    {
+        cusp::krylov::bicgstab_m(A, x, b, sigma, monitor);
+    }
+};
+
+} // end namespace detail
+
 // BiCGStab-M routine that uses the default monitor to determine completion
 template <class LinearOperator,
           class VectorType1, class VectorType2, class VectorType3>
@@ -606,6 +789,8 @@ void bicgstab_m(LinearOperator& A,
   // shorthand for typenames
   typedef typename LinearOperator::value_type   ValueType;
   typedef typename LinearOperator::memory_space MemorySpace;
+  typedef typename norm_type<ValueType>::type   NormType;
+  typedef thrust::tuple<ValueType,ValueType>    ValuePair;
 
   // sanity checking
   const size_t N = A.num_rows;
@@ -617,8 +802,6 @@ void bicgstab_m(LinearOperator& A,
   assert(N_t == N*N_s);
   assert(N == test);
 
-  //clock_t start = clock();
-
   // w has data used in computing the soln.
   cusp::array1d<ValueType,MemorySpace> w_1(N);
   cusp::array1d<ValueType,MemorySpace> w_0(N);
@@ -634,18 +817,17 @@ void bicgstab_m(LinearOperator& A,
   // stores parameters used in the iteration
   cusp::array1d<ValueType,MemorySpace> z_m1_s(N_s,ValueType(1));
   cusp::array1d<ValueType,MemorySpace> z_0_s(N_s,ValueType(1));
-  cusp::array1d<ValueType,MemorySpace> z_1_s(N_s);
+  cusp::array1d<ValueType,MemorySpace> rho_0_s(N_s,ValueType(1));
 
-  cusp::array1d<ValueType,MemorySpace> alpha_0_s(N_s,ValueType(0));
-  cusp::array1d<ValueType,MemorySpace> beta_0_s(N_s);
+  // factors of the x^\sigma and s^\sigma updates
+  cusp::array1d<ValueType,MemorySpace> factors(detail::bicgstab_m_num_factors*N_s);
 
-  cusp::array1d<ValueType,MemorySpace> rho_0_s(N_s,ValueType(1));
-  cusp::array1d<ValueType,MemorySpace> rho_1_s(N_s);
-  cusp::array1d<ValueType,MemorySpace> chi_0_s(N_s);
+  // convergence state of the shifted systems, kept on the device
+  cusp::array1d<int,MemorySpace> state(N_s,int(detail::multishift_active));
 
   // stores parameters used in the iteration for the undeformed system
   ValueType beta_m1, beta_0(ValueType(1));
-  ValueType alpha_0(ValueType(0));
+  ValueType alpha_m1, alpha_0(ValueType(0));
 
   ValueType delta_0, delta_1;
   ValueType phi_0;
@@ -670,41 +852,76 @@ void bicgstab_m(LinearOperator& A,
 
   delta_1 = cusp::blas::dotc(w_0,r_0);
   phi_0 = cusp::blas::dotc(w_0,As)/delta_1;
-  
+
+  NormType r_norm = cusp::blas::nrm2(r_0);
+
+  ValueType * raw_ptr_x = thrust::raw_pointer_cast(&x[0]);
+  ValueType * raw_ptr_s_0_s = thrust::raw_pointer_cast(&s_0_s[0]);
+
   //
   // Initialization is done. Solve iteratively
   //
-  while (!monitor.finished(r_0))
+  while (!detail::multishift_finished(monitor, r_0, r_norm,
+                                      typename cusp::detail::accepts_residual_norm<Monitor>::type()))
   {
     // recycle iterates
     beta_m1 = beta_0;
     beta_0 = ValueType(-1.0)/phi_0;
     delta_0 = delta_1;
+    alpha_m1 = alpha_0;
 
-    // compute \zeta_1^\sigma, \beta_0^\sigma
-    cusp::krylov::trans_m::compute_zb_m(z_0_s, z_m1_s, sigma, z_1_s, beta_0_s,
-                                      beta_m1, beta_0, alpha_0);
-
-    // call w_1 kernel
-    cusp::krylov::trans_m::compute_w_1_m(r_0, As, w_1, beta_0);
+    // compute w_1
+    cusp::blas::axpby(r_0,As,w_1,ValueType(1),beta_0);
 
     // compute the matrix-vector product Aw
     cusp::multiply(A,w_1,Aw);
 
-    // compute chi_0
-    chi_0 = cusp::blas::dotc(Aw,w_1)/cusp::blas::dotc(Aw,Aw);
+    // compute chi_0 with both inner products in one reduction
+    ValuePair chi = cusp::detail::stream::transform_reduce
+      (thrust::make_zip_iterator(thrust::make_tuple(Aw.begin(), w_1.begin())),
+       thrust::make_zip_iterator(thrust::make_tuple(Aw.begin(), w_1.begin())) + N,
+       detail::bicgstab_m_chi_functor<ValueType>(),
+       ValuePair(ValueType(0), ValueType(0)),
+       detail::multishift_pair_plus<ValueType>());
+
+    chi_0 = thrust::get<0>(chi)/thrust::get<1>(chi);
 
-    // compute new residual
-    cusp::krylov::trans_m::compute_r_1_m(w_1,Aw,r_1,chi_0);
+    // compute new residual, the new delta and (r_1,r_1)
+    ValuePair delta = cusp::detail::stream::transform_reduce
+      (thrust::make_zip_iterator(thrust::make_tuple(w_1.begin(), Aw.begin(), r_1.begin(), w_0.begin())),
+       thrust::make_zip_iterator(thrust::make_tuple(w_1.begin(), Aw.begin(), r_1.begin(), w_0.begin())) + N,
+       detail::bicgstab_m_residual_functor<ValueType>(chi_0),
+       ValuePair(ValueType(0), ValueType(0)),
+       detail::multishift_pair_plus<ValueType>());
+
+    delta_1 = thrust::get<0>(delta);
+    r_norm = NormType(std::sqrt(abs(thrust::get<1>(delta))));
 
-    // compute the new delta
-    delta_1 = cusp::blas::dotc(w_0,r_1);
- 
     // compute new alpha
     alpha_0 = -beta_0*delta_1/delta_0/chi_0;
 
-    // compute s_0
-    cusp::krylov::trans_m::compute_s_0_m(r_1,As,s_0,alpha_0,chi_0);
+    // compute the shifted coefficients and freeze the shifts that have
+    // converged
+    const NormType limit = detail::multishift_limit(NormType(monitor.tolerance()), r_norm);
+
+    cusp::detail::stream::for_each
+      (thrust::make_zip_iterator(thrust::make_tuple(z_m1_s.begin(), z_0_s.begin(), rho_0_s.begin(),
+                                                    sigma.begin(), state.begin(), thrust::counting_iterator<size_t>(0))),
+       thrust::make_zip_iterator(thrust::make_tuple(z_m1_s.begin(), z_0_s.begin(), rho_0_s.begin(),
+                                                    sigma.begin(), state.begin(), thrust::counting_iterator<size_t>(0))) + N_s,
+       detail::bicgstab_m_coefficients_functor<ValueType,NormType>(N_s, beta_m1, beta_0, alpha_m1, alpha_0, chi_0, limit,
+                                                                   thrust::raw_pointer_cast(&factors[0])));
+
+    // compute s_0, the new solutions and s_0^\sigma in one pass over the rows
+    cusp::detail::stream::for_each
+      (thrust::make_zip_iterator(thrust::make_tuple(r_0.begin(), r_1.begin(), w_1.begin(), s_0.begin(),
+                                                    As.begin(), thrust::counting_iterator<size_t>(0))),
+       thrust::make_zip_iterator(thrust::make_tuple(r_0.begin(), r_1.begin(), w_1.begin(), s_0.begin(),
+                                                    As.begin(), thrust::counting_iterator<size_t>(0))) + N,
+       detail::bicgstab_m_update_functor<ValueType>(N, N_s, alpha_0, chi_0,
+                                                    thrust::raw_pointer_cast(&factors[0]),
+                                                    thrust::raw_pointer_cast(&state[0]),
+                                                    raw_ptr_x, raw_ptr_s_0_s));
 
     // compute As
     cusp::multiply(A,s_0,As);
@@ -712,33 +929,27 @@ void bicgstab_m(LinearOperator& A,
     // compute new phi
     phi_0 = cusp::blas::dotc(w_0,As)/delta_1;
 
-    // compute shifted rho, chi
-    cusp::krylov::trans_m::compute_chirho_m(rho_0_s,sigma,chi_0_s,rho_1_s,
-		    chi_0);
-
-    // calculate \alpha_0^\sigma
-    cusp::krylov::trans_m::compute_a_m(z_0_s, z_1_s, beta_0_s,
-                                      alpha_0_s, beta_0, alpha_0);
-
-    // compute the new solution and s_0^sigma
-    cusp::krylov::trans_m::compute_xs_m(beta_0_s, chi_0_s, rho_0_s, z_0_s,
-		    alpha_0_s, rho_1_s, z_1_s, r_0, r_1, w_1, s_0_s, x);
-
     // recycle r_i
-    cusp::blas::copy(r_1,r_0);
+    r_0.swap(r_1);
 
-    // recycle \zeta_i^\sigma
-    cusp::blas::copy(z_0_s,z_m1_s);
-    cusp::blas::copy(z_1_s,z_0_s);
-
-    // recycle \rho_i^\sigma
-    cusp::blas::copy(rho_1_s,rho_0_s);
-    
     ++monitor;
 
   }// finished iteration
 
-} // end cg_m
+} // end bicgstab_m
+
+// BiCGStab-M routine with a polynomial preconditioner
+template <class LinearOperator,
+          class VectorType1, class VectorType2, class VectorType3,
+          class Monitor, class Array>
+void bicgstab_m(LinearOperator& A,
+        VectorType1& x, VectorType2& b, VectorType3& sigma,
+        Monitor& monitor, const Array& coefficients)
+{
+  CUSP_PROFILE_SCOPED();
+
+  detail::multishift_polynomial_solve(A, x, b, sigma, monitor, coefficients, detail::bicgstab_m_solver());
+}
 
 } // end namespace krylov
 } // end namespace cusp
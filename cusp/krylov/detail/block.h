@@ -0,0 +1,325 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+// Building blocks shared by the block Krylov methods: views of column
+// ranges of column-major blocks of vectors, block inner products and
+// products with small dense matrices, each computed in a single pass.
+
+#pragma once
+
+#include <cusp/array1d.h>
+#include <cusp/array2d.h>
+#include <cusp/blas.h>
+#include <cusp/complex.h>
+#include <cusp/detail/random.h>
+
+#include <cusp/krylov/detail/s_step.h>
+
+#include <thrust/copy.h>
+#include <thrust/for_each.h>
+#include <thrust/reduce.h>
+#include <thrust/swap.h>
+#include <thrust/iterator/counting_iterator.h>
+#include <thrust/iterator/discard_iterator.h>
+#include <thrust/iterator/transform_iterator.h>
+
+#include <cmath>
+
+namespace cusp
+{
+namespace krylov
+{
+namespace detail
+{
+
+// columns [first, first+n) of a column-major block of vectors
+template <typename Array2d>
+struct block_view
+{
+    typedef cusp::array1d_view<typename Array2d::values_array_type::iterator> values_view;
+    typedef cusp::array2d_view<values_view, cusp::column_major> type;
+};
+
+template <typename Array2d>
+typename block_view<Array2d>::type
+block_columns(Array2d& V, const size_t first, const size_t n)
+{
+    typedef typename block_view<Array2d>::values_view values_view;
+
+    return typename block_view<Array2d>::type
+        (V.num_rows, n, V.pitch, values_view(V.values.begin() + first * V.pitch,
+                                             V.values.begin() + (first + n) * V.pitch));
+}
+
+// element idx = (b * m + a) * N + i of an m x n block product -> b * m + a
+struct block_product_index
+{
+    size_t N;
+
+    block_product_index(size_t N) : N(N) {}
+
+    __host__ __device__
+    size_t operator()(size_t idx) const { return idx / N; }
+};
+
+// conj(U(i,a)) * V(i,b) for element idx = (b * m + a) * N + i
+template <typename ValueType>
+struct block_product
+{
+    const ValueType * U;
+    const ValueType * V;
+    size_t N;
+    size_t U_pitch;
+    size_t V_pitch;
+    size_t m;
+
+    block_product(const ValueType * U, const ValueType * V, size_t N, size_t U_pitch, size_t V_pitch, size_t m)
+      : U(U), V(V), N(N), U_pitch(U_pitch), V_pitch(V_pitch), m(m) {}
+
+    __host__ __device__
+    ValueType operator()(size_t idx) const
+    {
+        cusp::blas::detail::conjugate<ValueType> conj;
+        const size_t key = idx / N;
+        const size_t i = idx - key * N;
+        const size_t a = key % m;
+        const size_t b = key / m;
+        return conj(U[a * U_pitch + i]) * V[b * V_pitch + i];
+    }
+};
+
+// conj(U(i,b)) * V(i,b) for element idx = b * N + i
+template <typename ValueType>
+struct block_column_product
+{
+    const ValueType * U;
+    const ValueType * V;
+    size_t N;
+    size_t U_pitch;
+    size_t V_pitch;
+
+    block_column_product(const ValueType * U, const ValueType * V, size_t N, size_t U_pitch, size_t V_pitch)
+      : U(U), V(V), N(N), U_pitch(U_pitch), V_pitch(V_pitch) {}
+
+    __host__ __device__
+    ValueType operator()(size_t idx) const
+    {
+        cusp::blas::detail::conjugate<ValueType> conj;
+        const size_t b = idx / N;
+        const size_t i = idx - b * N;
+        return conj(U[b * U_pitch + i]) * V[b * V_pitch + i];
+    }
+};
+
+// G(a,b) = U(:,a)^H V(:,b) for a < U.num_cols and b < V.num_cols, stored
+// column-major in the leading entries of G, with one reduction
+template <typename Array2d1, typename Array2d2, typename Array1d>
+void block_inner_products(const Array2d1& U, const Array2d2& V, Array1d& G)
+{
+    typedef typename Array2d1::value_type ValueType;
+
+    const size_t N = U.num_rows;
+    const size_t m = U.num_cols;
+    const size_t n = V.num_cols;
+
+    thrust::reduce_by_key
+        (thrust::make_transform_iterator(thrust::counting_iterator<size_t>(0), block_product_index(N)),
+         thrust::make_transform_iterator(thrust::counting_iterator<size_t>(N * m * n), block_product_index(N)),
+         thrust::make_transform_iterator(thrust::counting_iterator<size_t>(0),
+                                         block_product<ValueType>(thrust::raw_pointer_cast(&U.values[0]),
+                                                                  thrust::raw_pointer_cast(&V.values[0]),
+                                                                  N, U.pitch, V.pitch, m)),
+         thrust::make_discard_iterator(),
+         G.begin());
+}
+
+// d[b] = U(:,b)^H V(:,b) for b < V.num_cols, with one reduction
+template <typename Array2d1, typename Array2d2, typename Array1d>
+void block_column_inner_products(const Array2d1& U, const Array2d2& V, Array1d& d)
+{
+    typedef typename Array2d1::value_type ValueType;
+
+    const size_t N = U.num_rows;
+    const size_t n = V.num_cols;
+
+    thrust::reduce_by_key
+        (thrust::make_transform_iterator(thrust::counting_iterator<size_t>(0), block_product_index(N)),
+         thrust::make_transform_iterator(thrust::counting_iterator<size_t>(N * n), block_product_index(N)),
+         thrust::make_transform_iterator(thrust::counting_iterator<size_t>(0),
+                                         block_column_product<ValueType>(thrust::raw_pointer_cast(&U.values[0]),
+                                                                         thrust::raw_pointer_cast(&V.values[0]),
+                                                                         N, U.pitch, V.pitch)),
+         thrust::make_discard_iterator(),
+         d.begin());
+}
+
+// row i of Y <- (accumulate ? Y : 0) + V C with C an m x n matrix (column-major)
+template <typename ValueType>
+struct block_multiply_functor
+{
+    const ValueType * V;
+    const ValueType * C;
+    ValueType * Y;
+    size_t V_pitch;
+    size_t Y_pitch;
+    size_t m;
+    size_t n;
+    bool accumulate;
+
+    block_multiply_functor(const ValueType * V, const ValueType * C, ValueType * Y,
+                           size_t V_pitch, size_t Y_pitch, size_t m, size_t n, bool accumulate)
+      : V(V), C(C), Y(Y), V_pitch(V_pitch), Y_pitch(Y_pitch), m(m), n(n), accumulate(accumulate) {}
+
+    __host__ __device__
+    void operator()(size_t i) const
+    {
+        for (size_t b = 0; b < n; b++)
+        {
+            ValueType y = accumulate ? Y[b * Y_pitch + i] : ValueType(0);
+            for (size_t a = 0; a < m; a++)
+                y += V[a * V_pitch + i] * C[b * m + a];
+            Y[b * Y_pitch + i] = y;
+        }
+    }
+};
+
+// Y <- (accumulate ? Y : 0) + V C, where C has V.num_cols rows and
+// Y.num_cols columns.  V and Y must not overlap.
+template <typename Array2d1, typename Array1d, typename Array2d2>
+void block_multiply(const Array2d1& V, const Array1d& C, Array2d2& Y, const bool accumulate)
+{
+    typedef typename Array2d1::value_type ValueType;
+
+    thrust::for_each(thrust::counting_iterator<size_t>(0), thrust::counting_iterator<size_t>(V.num_rows),
+                     block_multiply_functor<ValueType>(thrust::raw_pointer_cast(&V.values[0]),
+                                                       thrust::raw_pointer_cast(&C[0]),
+                                                       thrust::raw_pointer_cast(&Y.values[0]),
+                                                       V.pitch, Y.pitch, V.num_cols, Y.num_cols, accumulate));
+}
+
+template <typename Array2d>
+void block_swap_columns(Array2d& V, const size_t a, const size_t b)
+{
+    if (a != b)
+        thrust::swap_ranges(V.column(a).begin(), V.column(a).end(), V.column(b).begin());
+}
+
+// C <- G^-1 C for a small dense G by Gaussian elimination with partial
+// pivoting, returns false if G is singular
+template <typename ValueType>
+bool block_solve(cusp::array2d<ValueType,cusp::host_memory,cusp::column_major> G,
+                 cusp::array2d<ValueType,cusp::host_memory,cusp::column_major>& C)
+{
+    using std::abs;
+
+    const size_t n = G.num_rows;
+
+    for (size_t k = 0; k < n; k++)
+    {
+        size_t p = k;
+        for (size_t i = k + 1; i < n; i++)
+            if (abs(G(i,k)) > abs(G(p,k)))
+                p = i;
+
+        if (G(p,k) == ValueType(0))
+            return false;
+
+        for (size_t j = 0; j < n; j++)
+            thrust::swap(G(k,j), G(p,j));
+        for (size_t j = 0; j < C.num_cols; j++)
+            thrust::swap(C(k,j), C(p,j));
+
+        for (size_t i = k + 1; i < n; i++)
+        {
+            const ValueType f = G(i,k) / G(k,k);
+            for (size_t j = k; j < n; j++)
+                G(i,j) -= f * G(k,j);
+            for (size_t j = 0; j < C.num_cols; j++)
+                C(i,j) -= f * C(k,j);
+        }
+    }
+
+    for (size_t k = n; k-- > 0; )
+    {
+        for (size_t j = 0; j < C.num_cols; j++)
+        {
+            ValueType c = C(k,j);
+            for (size_t l = k + 1; l < n; l++)
+                c -= G(k,l) * C(l,j);
+            C(k,j) = c / G(k,k);
+        }
+    }
+
+    return true;
+}
+
+// Test the residual norms of the k active columns and deflate the converged
+// ones by swapping them behind the active columns of every block.  Returns
+// the new number of active columns.
+template <typename Monitor, typename Array2d, typename Array1d, typename HostArray>
+size_t block_deflate(Monitor& monitor, Array2d& R, const size_t k, Array1d& d_dev,
+                     HostArray& columns, Array2d * blocks[], const size_t num_blocks)
+{
+    typedef typename Array2d::value_type ValueType;
+
+    typename block_view<Array2d>::type Rk = block_columns(R, 0, k);
+    block_column_inner_products(Rk, Rk, d_dev);
+
+    cusp::array1d<ValueType,cusp::host_memory> d(d_dev.begin(), d_dev.begin() + k);
+
+    size_t active = k;
+
+    // columns behind s are tested, so the column swapped in has not converged
+    for (size_t s = k; s-- > 0; )
+    {
+        if (monitor.finished(columns[s], std::sqrt(std::abs(s_step_real(d[s])))))
+        {
+            --active;
+            for (size_t i = 0; i < num_blocks; i++)
+                block_swap_columns(*blocks[i], s, active);
+            thrust::swap(columns[s], columns[active]);
+        }
+    }
+
+    return active;
+}
+
+// V(:,j) <- random values in [0,1), seeded by j
+template <typename Array2d>
+void block_random_column(Array2d& V, const size_t j)
+{
+    typedef typename norm_type<typename Array2d::value_type>::type NormType;
+
+    cusp::detail::random_reals<NormType> r(V.num_rows, j);
+    thrust::copy(r.begin(), r.end(), V.column(j).begin());
+}
+
+template <typename Array1d, typename HostArray2d>
+void block_copy_to_device(const HostArray2d& C, Array1d& C_dev)
+{
+    thrust::copy(C.values.begin(), C.values.end(), C_dev.begin());
+}
+
+template <typename Array1d, typename HostArray2d>
+void block_copy_to_host(const Array1d& C_dev, HostArray2d& C)
+{
+    thrust::copy(C_dev.begin(), C_dev.begin() + C.values.size(), C.values.begin());
+}
+
+} // end namespace detail
+} // end namespace krylov
+} // end namespace cusp
+
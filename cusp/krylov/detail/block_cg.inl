@@ -0,0 +1,207 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include <cusp/array1d.h>
+#include <cusp/array2d.h>
+#include <cusp/blas.h>
+#include <cusp/multiply.h>
+#include <cusp/linear_operator.h>
+
+#include <cusp/krylov/detail/block.h>
+
+#include <thrust/copy.h>
+#include <thrust/sequence.h>
+
+#include <cmath>
+
+namespace blas = cusp::blas;
+
+namespace cusp
+{
+namespace krylov
+{
+
+template <class LinearOperator,
+          class Array2d>
+void block_cg(LinearOperator& A,
+              Array2d& X,
+              Array2d& B)
+{
+    typedef typename LinearOperator::value_type   ValueType;
+
+    cusp::krylov::block_monitor<ValueType> monitor(B);
+
+    cusp::krylov::block_cg(A, X, B, monitor);
+}
+
+template <class LinearOperator,
+          class Array2d,
+          class Monitor>
+void block_cg(LinearOperator& A,
+              Array2d& X,
+              Array2d& B,
+              Monitor& monitor)
+{
+    typedef typename LinearOperator::value_type   ValueType;
+    typedef typename LinearOperator::memory_space MemorySpace;
+
+    cusp::identity_operator<ValueType,MemorySpace> M(A.num_rows, A.num_cols);
+
+    cusp::krylov::block_cg(A, X, B, monitor, M);
+}
+
+template <class LinearOperator,
+          class Array2d,
+          class Monitor,
+          class Preconditioner>
+void block_cg(LinearOperator& A,
+              Array2d& X,
+              Array2d& B,
+              Monitor& monitor,
+              Preconditioner& M)
+{
+    typedef typename LinearOperator::value_type   ValueType;
+    typedef typename LinearOperator::memory_space MemorySpace;
+
+    cusp::krylov::workspace<ValueType,MemorySpace> workspace;
+
+    cusp::krylov::block_cg(A, X, B, monitor, M, workspace);
+}
+
+template <class LinearOperator,
+          class Array2d,
+          class Monitor,
+          class Preconditioner,
+          class Workspace>
+void block_cg(LinearOperator& A,
+              Array2d& X,
+              Array2d& B,
+              Monitor& monitor,
+              Preconditioner& M,
+              Workspace& workspace)
+{
+    CUSP_PROFILE_SCOPED();
+
+    typedef typename LinearOperator::value_type   ValueType;
+    typedef typename Workspace::vector_type       Array1d;
+    typedef typename Workspace::matrix_type       WorkArray2d;
+    typedef typename detail::block_view<WorkArray2d>::type View;
+    typedef cusp::array2d<ValueType,cusp::host_memory,cusp::column_major> HostArray2d;
+
+    assert(A.num_rows == A.num_cols);        // sanity check
+    assert(X.num_cols == B.num_cols);
+
+    const size_t N = A.num_rows;
+    const size_t K = B.num_cols;
+
+    // get workspace, the active columns of every block come first
+    WorkArray2d& Xw = workspace.matrix(0, N, K);
+    WorkArray2d& R  = workspace.matrix(1, N, K);
+    WorkArray2d& Z  = workspace.matrix(2, N, K);
+    WorkArray2d& P  = workspace.matrix(3, N, K);
+    WorkArray2d& Q  = workspace.matrix(4, N, K);
+    Array1d& G_dev  = workspace.vector(0, K * K);
+
+    // column of X held by each column of the blocks
+    cusp::array1d<size_t,cusp::host_memory> columns(K);
+    thrust::sequence(columns.begin(), columns.end());
+
+    WorkArray2d * blocks[] = { &Xw, &R, &Z, &P };
+
+    // R <- B - A*X
+    for (size_t j = 0; j < K; j++)
+        blas::copy(X.column(j), Xw.column(j));
+
+    cusp::multiply(A, Xw, R);
+
+    for (size_t j = 0; j < K; j++)
+    {
+        blas::axpby(B.column(j), R.column(j), R.column(j), ValueType(1), ValueType(-1));
+        cusp::multiply(M, R.column(j), Z.column(j));
+    }
+
+    // P <- Z
+    blas::copy(Z.values, P.values);
+
+    size_t k = K;
+
+    while (true)
+    {
+        k = detail::block_deflate(monitor, R, k, G_dev, columns, blocks, 4);
+
+        if (k == 0 || monitor.finished())
+            break;
+
+        View Xk = detail::block_columns(Xw, 0, k);
+        View Rk = detail::block_columns(R, 0, k);
+        View Zk = detail::block_columns(Z, 0, k);
+        View Pk = detail::block_columns(P, 0, k);
+        View Qk = detail::block_columns(Q, 0, k);
+
+        // Q <- A*P
+        cusp::multiply(A, Pk, Qk);
+
+        HostArray2d PQ(k, k), alpha(k, k), beta(k, k);
+
+        // alpha <- (P^H Q)^-1 P^H R
+        detail::block_inner_products(Pk, Qk, G_dev);
+        detail::block_copy_to_host(G_dev, PQ);
+
+        detail::block_inner_products(Pk, Rk, G_dev);
+        detail::block_copy_to_host(G_dev, alpha);
+
+        // the search directions lost their rank
+        if (!detail::block_solve(PQ, alpha))
+            break;
+
+        // X <- X + P alpha, R <- R - Q alpha
+        detail::block_copy_to_device(alpha, G_dev);
+        detail::block_multiply(Pk, G_dev, Xk, true);
+
+        for (size_t i = 0; i < alpha.values.size(); i++)
+            alpha.values[i] = -alpha.values[i];
+
+        detail::block_copy_to_device(alpha, G_dev);
+        detail::block_multiply(Qk, G_dev, Rk, true);
+
+        // Z <- M*R
+        for (size_t j = 0; j < k; j++)
+            cusp::multiply(M, R.column(j), Z.column(j));
+
+        // beta <- -(P^H Q)^-1 Q^H Z makes the new directions A-conjugate to P
+        detail::block_inner_products(Qk, Zk, G_dev);
+        detail::block_copy_to_host(G_dev, beta);
+
+        for (size_t i = 0; i < beta.values.size(); i++)
+            beta.values[i] = -beta.values[i];
+
+        detail::block_solve(PQ, beta);
+
+        // P <- Z + P beta
+        detail::block_copy_to_device(beta, G_dev);
+        detail::block_multiply(Pk, G_dev, Zk, true);
+        P.swap(Z);
+
+        ++monitor;
+    }
+
+    for (size_t j = 0; j < K; j++)
+        blas::copy(Xw.column(j), X.column(columns[j]));
+}
+
+} // end namespace krylov
+} // end namespace cusp
+
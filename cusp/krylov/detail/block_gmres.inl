@@ -0,0 +1,311 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include <cusp/array1d.h>
+#include <cusp/array2d.h>
+#include <cusp/blas.h>
+#include <cusp/multiply.h>
+#include <cusp/linear_operator.h>
+
+#include <cusp/krylov/gmres.h>
+#include <cusp/krylov/s_step_gmres.h>
+#include <cusp/krylov/detail/block.h>
+#include <cusp/krylov/detail/s_step.h>
+
+#include <thrust/copy.h>
+#include <thrust/fill.h>
+#include <thrust/sequence.h>
+
+#include <cmath>
+
+namespace blas = cusp::blas;
+
+namespace cusp
+{
+namespace krylov
+{
+
+template <class LinearOperator,
+          class Array2d>
+void block_gmres(LinearOperator& A,
+                 Array2d& X,
+                 Array2d& B,
+                 const size_t restart)
+{
+    typedef typename LinearOperator::value_type   ValueType;
+
+    cusp::krylov::block_monitor<ValueType> monitor(B);
+
+    cusp::krylov::block_gmres(A, X, B, restart, monitor);
+}
+
+template <class LinearOperator,
+          class Array2d,
+          class Monitor>
+void block_gmres(LinearOperator& A,
+                 Array2d& X,
+                 Array2d& B,
+                 const size_t restart,
+                 Monitor& monitor)
+{
+    typedef typename LinearOperator::value_type   ValueType;
+    typedef typename LinearOperator::memory_space MemorySpace;
+
+    cusp::identity_operator<ValueType,MemorySpace> M(A.num_rows, A.num_cols);
+
+    cusp::krylov::block_gmres(A, X, B, restart, monitor, M);
+}
+
+template <class LinearOperator,
+          class Array2d,
+          class Monitor,
+          class Preconditioner>
+void block_gmres(LinearOperator& A,
+                 Array2d& X,
+                 Array2d& B,
+                 const size_t restart,
+                 Monitor& monitor,
+                 Preconditioner& M)
+{
+    typedef typename LinearOperator::value_type   ValueType;
+    typedef typename LinearOperator::memory_space MemorySpace;
+
+    cusp::krylov::workspace<ValueType,MemorySpace> workspace;
+
+    cusp::krylov::block_gmres(A, X, B, restart, monitor, M, workspace);
+}
+
+template <class LinearOperator,
+          class Array2d,
+          class Monitor,
+          class Preconditioner,
+          class Workspace>
+void block_gmres(LinearOperator& A,
+                 Array2d& X,
+                 Array2d& B,
+                 const size_t restart,
+                 Monitor& monitor,
+                 Preconditioner& M,
+                 Workspace& workspace)
+{
+    CUSP_PROFILE_SCOPED();
+
+    typedef typename LinearOperator::value_type   ValueType;
+    typedef typename norm_type<ValueType>::type   NormType;
+    typedef typename Workspace::vector_type       Array1d;
+    typedef typename Workspace::matrix_type       WorkArray2d;
+    typedef typename detail::block_view<WorkArray2d>::type View;
+    typedef cusp::array2d<ValueType,cusp::host_memory,cusp::column_major> HostArray2d;
+
+    assert(A.num_rows == A.num_cols);        // sanity check
+    assert(X.num_cols == B.num_cols);
+    assert(restart > 0);
+
+    const size_t N = A.num_rows;
+    const size_t K = B.num_cols;
+    const size_t L = (restart + 1) * K;
+
+    // get workspace, the active columns of every block come first
+    WorkArray2d& Xw = workspace.matrix(0, N, K);
+    WorkArray2d& T  = workspace.matrix(1, N, K);
+    WorkArray2d& V  = workspace.matrix(2, N, L);       // Arnoldi basis
+    Array1d& G_dev    = workspace.vector(0, L * K);   // block inner products
+    Array1d& C_dev    = workspace.vector(1, L * K);   // projection on the basis
+    Array1d& Rinv_dev = workspace.vector(2, K * K);   // inverse Cholesky factor
+
+    // column of X held by each column of the blocks
+    cusp::array1d<size_t,cusp::host_memory> columns(K);
+    thrust::sequence(columns.begin(), columns.end());
+
+    WorkArray2d * blocks[] = { &Xw, &V };
+
+    HostArray2d C1, R1, C2, R2, C_total, R_total;
+
+    for (size_t j = 0; j < K; j++)
+        blas::copy(X.column(j), Xw.column(j));
+
+    size_t k = K;
+
+    while (true)
+    {
+        // V(:,0:k) <- M (B - A*X)
+        {
+            View Xk = detail::block_columns(Xw, 0, k);
+            View Tk = detail::block_columns(T, 0, k);
+
+            cusp::multiply(A, Xk, Tk);
+
+            for (size_t l = 0; l < k; l++)
+            {
+                blas::axpby(B.column(columns[l]), T.column(l), T.column(l), ValueType(1), ValueType(-1));
+                cusp::multiply(M, T.column(l), V.column(l));
+            }
+        }
+
+        k = detail::block_deflate(monitor, V, k, G_dev, columns, blocks, 2);
+
+        if (k == 0 || monitor.finished())
+            break;
+
+        // V(:,0:k) S = M (B - A*X), by Cholesky QR applied twice
+        const size_t k1 = detail::s_step_orthogonalize(V, 0, k, G_dev, C_dev, Rinv_dev, C1, R1);
+        const size_t k2 = (k1 == k) ? detail::s_step_orthogonalize(V, 0, k, G_dev, C_dev, Rinv_dev, C2, R2) : 0;
+
+        // the residuals are linearly dependent
+        if (k2 < k)
+            break;
+
+        const size_t rows = (restart + 1) * k;
+
+        // least squares right-hand sides, Hessenberg matrix and rotations
+        HostArray2d G(rows, k, ValueType(0));
+        HostArray2d H(rows, restart * k, ValueType(0));
+        HostArray2d cs(restart * k, k);
+        HostArray2d sn(restart * k, k);
+
+        for (size_t b = 0; b < k; b++)
+            for (size_t a = 0; a <= b; a++)
+            {
+                ValueType s = 0;
+                for (size_t q = a; q <= b; q++)
+                    s += R2(a,q) * R1(q,b);
+                G(a,b) = s;
+            }
+
+        size_t num_blocks = 0;
+
+        for (size_t j = 0; j < restart; j++)
+        {
+            const size_t f = (j + 1) * k;
+
+            // V(:,f:f+k) <- M A V(:,f-k:f)
+            {
+                View Vj = detail::block_columns(V, j * k, k);
+                View Tk = detail::block_columns(T, 0, k);
+
+                cusp::multiply(A, Vj, Tk);
+
+                for (size_t l = 0; l < k; l++)
+                    cusp::multiply(M, T.column(l), V.column(f + l));
+            }
+
+            // block Gram-Schmidt with Cholesky QR, applied twice:
+            // M A V(:,f-k:f) = V(:,0:f) C_total + V(:,f:f+k) R_total
+            const size_t n1 = detail::s_step_orthogonalize(V, f, k, G_dev, C_dev, Rinv_dev, C1, R1);
+            const size_t n2 = (n1 == k) ? detail::s_step_orthogonalize(V, f, k, G_dev, C_dev, Rinv_dev, C2, R2) : 0;
+
+            // a rank deficient block ends the cycle, the lost directions
+            // lie in the basis and the next cycle starts from the true residuals
+            const bool breakdown = n2 < k;
+
+            C_total.resize(f, k);
+            R_total.resize(k, k);
+            thrust::fill(R_total.values.begin(), R_total.values.end(), ValueType(0));
+
+            for (size_t l = 0; l < k; l++)
+            {
+                for (size_t a = 0; a < f; a++)
+                {
+                    ValueType c = C1(a,l);
+                    if (n1 == k)
+                        for (size_t q = 0; q <= l; q++)
+                            c += C2(a,q) * R1(q,l);
+                    C_total(a,l) = c;
+                }
+                if (!breakdown)
+                    for (size_t r = 0; r <= l; r++)
+                    {
+                        ValueType c = 0;
+                        for (size_t q = r; q <= l; q++)
+                            c += R2(r,q) * R1(q,l);
+                        R_total(r,l) = c;
+                    }
+            }
+
+            for (size_t l = 0; l < k; l++)
+            {
+                const size_t c = j * k + l;
+
+                for (size_t a = 0; a < f; a++)
+                    H(a,c) = C_total(a,l);
+                for (size_t r = 0; r <= l; r++)
+                    H(f + r,c) = R_total(r,l);
+
+                // rotations of the previous columns, column c' mixes rows c' and c'+i
+                for (size_t p = 0; p < c; p++)
+                    for (size_t i = 1; i <= k; i++)
+                        ApplyPlaneRotation(H(p,c), H(p + i,c), cs(p,i-1), sn(p,i-1));
+
+                // annihilate the k subdiagonal entries of column c
+                for (size_t i = 1; i <= k; i++)
+                {
+                    GeneratePlaneRotation(H(c,c), H(c + i,c), cs(c,i-1), sn(c,i-1));
+                    ApplyPlaneRotation(H(c,c), H(c + i,c), cs(c,i-1), sn(c,i-1));
+
+                    for (size_t q = 0; q < k; q++)
+                        ApplyPlaneRotation(G(c,q), G(c + i,q), cs(c,i-1), sn(c,i-1));
+                }
+            }
+
+            ++monitor;
+            num_blocks = j + 1;
+
+            // least squares residual norms of the active columns
+            bool done = true;
+            for (size_t q = 0; q < k; q++)
+            {
+                NormType r = 0;
+                for (size_t i = f; i < f + k; i++)
+                    r += detail::s_step_real(cusp::blas::detail::conjugate<ValueType>()(G(i,q)) * G(i,q));
+                if (std::sqrt(r) > monitor.tolerance(columns[q]))
+                    done = false;
+            }
+
+            if (done || breakdown || monitor.iteration_count() >= monitor.iteration_limit())
+                break;
+        }
+
+        // solve upper triangular system in place
+        const size_t n = num_blocks * k;
+
+        for (size_t c = n; c-- > 0; )
+            for (size_t q = 0; q < k; q++)
+            {
+                G(c,q) /= H(c,c);
+                for (size_t r = 0; r < c; r++)
+                    G(r,q) -= H(r,c) * G(c,q);
+            }
+
+        // X <- X + V(:,0:n) G(0:n,:)
+        HostArray2d Y(n, k);
+        for (size_t q = 0; q < k; q++)
+            for (size_t r = 0; r < n; r++)
+                Y(r,q) = G(r,q);
+
+        detail::block_copy_to_device(Y, C_dev);
+
+        View Vn = detail::block_columns(V, 0, n);
+        View Xk = detail::block_columns(Xw, 0, k);
+        detail::block_multiply(Vn, C_dev, Xk, true);
+    }
+
+    for (size_t j = 0; j < K; j++)
+        blas::copy(Xw.column(j), X.column(columns[j]));
+}
+
+} // end namespace krylov
+} // end namespace cusp
+
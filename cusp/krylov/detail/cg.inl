@@ -20,6 +20,12 @@
 #include <cusp/multiply.h>
 #include <cusp/monitor.h>
 #include <cusp/linear_operator.h>
+#include <cusp/detail/stream.h>
+
+#include <thrust/functional.h>
+#include <thrust/iterator/zip_iterator.h>
+
+#include <cmath>
 
 namespace blas = cusp::blas;
 
@@ -28,65 +34,66 @@ namespace cusp
 namespace krylov
 {
 
-template <class LinearOperator,
-          class Vector>
-void cg(LinearOperator& A,
-        Vector& x,
-        Vector& b)
+namespace detail
 {
-    typedef typename LinearOperator::value_type   ValueType;
 
-    cusp::default_monitor<ValueType> monitor(b);
+template <typename ValueType>
+struct cg_update_functor
+{
+    typedef ValueType result_type;
 
-    cusp::krylov::cg(A, x, b, monitor);
-}
+    const ValueType alpha;
 
-template <class LinearOperator,
-          class Vector,
-          class Monitor>
-void cg(LinearOperator& A,
-        Vector& x,
-        Vector& b,
-        Monitor& monitor)
-{
-    typedef typename LinearOperator::value_type   ValueType;
-    typedef typename LinearOperator::memory_space MemorySpace;
+    cg_update_functor(const ValueType alpha) : alpha(alpha) {}
 
-    cusp::identity_operator<ValueType,MemorySpace> M(A.num_rows, A.num_cols);
+    // (p, y, x, r) -> x += alpha * p, r -= alpha * y, returns r * conj(r)
+    template <typename Tuple>
+    __host__ __device__
+    ValueType operator()(Tuple t) const
+    {
+        thrust::get<2>(t) = thrust::get<2>(t) + alpha * thrust::get<0>(t);
 
-    cusp::krylov::cg(A, x, b, monitor, M);
-}
+        const ValueType r = thrust::get<3>(t) - alpha * thrust::get<1>(t);
+        thrust::get<3>(t) = r;
+
+        return r * cusp::blas::detail::conjugate<ValueType>()(r);
+    }
+};
+
+template <typename Preconditioner>
+struct is_identity_operator : thrust::detail::false_type {};
+
+template <typename ValueType, typename MemorySpace, typename IndexType>
+struct is_identity_operator< cusp::identity_operator<ValueType,MemorySpace,IndexType> > : thrust::detail::true_type {};
 
 template <class LinearOperator,
           class Vector,
           class Monitor,
-          class Preconditioner>
+          class Preconditioner,
+          class Workspace>
 void cg(LinearOperator& A,
         Vector& x,
         Vector& b,
         Monitor& monitor,
-        Preconditioner& M)
+        Preconditioner& M,
+        Workspace& workspace,
+        thrust::detail::false_type)
 {
-    CUSP_PROFILE_SCOPED();
-
     typedef typename LinearOperator::value_type   ValueType;
-    typedef typename LinearOperator::memory_space MemorySpace;
+    typedef typename Workspace::vector_type       Array;
 
     assert(A.num_rows == A.num_cols);        // sanity check
 
     const size_t N = A.num_rows;
 
-    // allocate workspace
-    cusp::array1d<ValueType,MemorySpace> y(N);
-    cusp::array1d<ValueType,MemorySpace> z(N);
-    cusp::array1d<ValueType,MemorySpace> r(N);
-    cusp::array1d<ValueType,MemorySpace> p(N);
+    // get workspace
+    Array& y = workspace.vector(0, N);
+    Array& z = workspace.vector(1, N);
+    Array& r = workspace.vector(2, N);
+    Array& p = workspace.vector(3, N);
         
-    // y <- Ax
-    cusp::multiply(A, x, y);
-
     // r <- b - A*x
-    blas::axpby(b, y, r, ValueType(1), ValueType(-1));
+    cusp::detail::residual(A, x, b, r);
    
     // z <- M*r
     cusp::multiply(M, r, z);
@@ -99,11 +106,8 @@ void cg(LinearOperator& A,
 
     while (!monitor.finished(r))
     {
-        // y <- Ap
-        cusp::multiply(A, p, y);
-        
-        // alpha <- <r,z>/<y,p>
-        ValueType alpha =  rz / blas::dotc(y, p);
+        // y <- Ap, alpha <- <r,z>/<y,p>
+        ValueType alpha =  rz / cusp::multiply_dot(A, p, y);
 
         // x <- x + alpha * p
         blas::axpy(p, x, alpha);
@@ -129,6 +133,228 @@ void cg(LinearOperator& A,
     }
 }
 
+// CG with the solution and residual updates fused with the residual norm
+template <class LinearOperator,
+          class Vector,
+          class Monitor,
+          class Preconditioner,
+          class Workspace>
+void cg(LinearOperator& A,
+        Vector& x,
+        Vector& b,
+        Monitor& monitor,
+        Preconditioner& M,
+        Workspace& workspace,
+        thrust::detail::true_type)
+{
+    typedef typename LinearOperator::value_type   ValueType;
+    typedef typename norm_type<ValueType>::type   NormType;
+    typedef typename Workspace::vector_type       Array;
+
+    assert(A.num_rows == A.num_cols);        // sanity check
+
+    const size_t N = A.num_rows;
+
+    // with the identity preconditioner z = r and <r^H, z> = ||r||^2
+    const bool identity = is_identity_operator<Preconditioner>::value;
+
+    // get workspace
+    Array& y = workspace.vector(0, N);
+    Array& z = identity ? workspace.vector(2, N) : workspace.vector(1, N);
+    Array& r = workspace.vector(2, N);
+    Array& p = workspace.vector(3, N);
+        
+    // r <- b - A*x
+    cusp::detail::residual(A, x, b, r);
+   
+    // z <- M*r
+    if (!identity)
+        cusp::multiply(M, r, z);
+
+    // p <- z
+    blas::copy(z, p);
+		
+    // rz = <r^H, z>
+    ValueType rz = blas::dotc(r, z);
+
+    bool done = monitor.finished(r);
+
+    while (!done)
+    {
+        // y <- Ap, alpha <- <r,z>/<y,p>
+        ValueType alpha =  rz / cusp::multiply_dot(A, p, y);
+
+        // x <- x + alpha * p, r <- r - alpha * y, rr <- <r^H, r>
+        ValueType rr =
+            cusp::detail::stream::transform_reduce
+                (thrust::make_zip_iterator(thrust::make_tuple(p.begin(), y.begin(), x.begin(), r.begin())),
+                 thrust::make_zip_iterator(thrust::make_tuple(p.begin(), y.begin(), x.begin(), r.begin())) + N,
+                 cg_update_functor<ValueType>(alpha),
+                 ValueType(0),
+                 thrust::plus<ValueType>());
+
+        ValueType rz_old = rz;
+
+        if (identity)
+        {
+            rz = rr;
+        }
+        else
+        {
+            // z <- M*r
+            cusp::multiply(M, r, z);
+
+            // rz = <r^H, z>
+            rz = blas::dotc(r, z);
+        }
+
+        // beta <- <r_{i+1},r_{i+1}>/<r,r> 
+        ValueType beta = rz / rz_old;
+		
+        // p <- r + beta*p
+        blas::axpby(z, p, p, ValueType(1), beta);
+
+        ++monitor;
+
+        done = monitor.finished(NormType(std::sqrt(abs(rr))));
+    }
+}
+
+} // end namespace detail
+
+
+template <class LinearOperator,
+          class Vector>
+void cg(LinearOperator& A,
+        Vector& x,
+        Vector& b)
+{
+    typedef typename LinearOperator::value_type   ValueType;
+
+    cusp::default_monitor<ValueType> monitor(b);
+
+    cusp::krylov::cg(A, x, b, monitor);
+}
+
+template <class LinearOperator,
+          class Vector,
+          class Monitor>
+void cg(LinearOperator& A,
+        Vector& x,
+        Vector& b,
+        Monitor& monitor)
+{
+    typedef typename LinearOperator::value_type   ValueType;
+    typedef typename LinearOperator::memory_space MemorySpace;
+
+    cusp::identity_operator<ValueType,MemorySpace> M(A.num_rows, A.num_cols);
+
+    cusp::krylov::cg(A, x, b, monitor, M);
+}
+
+template <class LinearOperator,
+          class Vector,
+          class Monitor,
+          class Preconditioner>
+void cg(LinearOperator& A,
+        Vector& x,
+        Vector& b,
+        Monitor& monitor,
+        Preconditioner& M)
+{
+    typedef typename LinearOperator::value_type   ValueType;
+    typedef typename LinearOperator::memory_space MemorySpace;
+
+    cusp::krylov::workspace<ValueType,MemorySpace> workspace;
+
+    cusp::krylov::cg(A, x, b, monitor, M, workspace);
+}
+
+template <class LinearOperator,
+          class Vector,
+          class Monitor,
+          class Preconditioner,
+          class Workspace>
+void cg(LinearOperator& A,
+        Vector& x,
+        Vector& b,
+        Monitor& monitor,
+        Preconditioner& M,
+        Workspace& workspace)
+{
+    CUSP_PROFILE_SCOPED();
+
+    // use the fused iteration when the monitor can take a precomputed residual norm
+    cusp::krylov::detail::cg(A, x, b, monitor, M, workspace,
+                             typename cusp::detail::accepts_residual_norm<Monitor>::type());
+}
+
+template <class LocalMatrix,
+          class ValueType,
+          class Monitor,
+          class Preconditioner>
+void cg(cusp::distributed_matrix<LocalMatrix>& A,
+        cusp::distributed_array1d<ValueType>& x,
+        cusp::distributed_array1d<ValueType>& b,
+        Monitor& monitor,
+        Preconditioner& M)
+{
+    cusp::krylov::distributed_workspace<ValueType> workspace(A.layout);
+
+    cusp::krylov::cg(A, x, b, monitor, M, workspace);
+}
+
+template <class LocalMatrix,
+          class ValueType,
+          class Monitor,
+          class Preconditioner>
+void cg(cusp::distributed_matrix<LocalMatrix>& A,
+        cusp::distributed_array1d<ValueType>& x,
+        cusp::distributed_array1d<ValueType>& b,
+        Monitor& monitor,
+        Preconditioner& M,
+        cusp::krylov::distributed_workspace<ValueType>& workspace)
+{
+    CUSP_PROFILE_SCOPED();
+
+    // the fused update works on a single range, so the blas
+    // operations of the distributed vectors are used instead
+    cusp::krylov::detail::cg(A, x, b, monitor, M, workspace, thrust::detail::false_type());
+}
+
+template <class LocalMatrix,
+          class ValueType,
+          class Monitor,
+          class Preconditioner>
+void cg(cusp::mpi_matrix<LocalMatrix>& A,
+        cusp::mpi_array1d<ValueType>& x,
+        cusp::mpi_array1d<ValueType>& b,
+        Monitor& monitor,
+        Preconditioner& M)
+{
+    cusp::krylov::mpi_workspace<ValueType> workspace(A.layout);
+
+    cusp::krylov::cg(A, x, b, monitor, M, workspace);
+}
+
+template <class LocalMatrix,
+          class ValueType,
+          class Monitor,
+          class Preconditioner>
+void cg(cusp::mpi_matrix<LocalMatrix>& A,
+        cusp::mpi_array1d<ValueType>& x,
+        cusp::mpi_array1d<ValueType>& b,
+        Monitor& monitor,
+        Preconditioner& M,
+        cusp::krylov::mpi_workspace<ValueType>& workspace)
+{
+    CUSP_PROFILE_SCOPED();
+
+    // the fused update reduces the local rows only, so the blas
+    // operations of the MPI vectors are used instead
+    cusp::krylov::detail::cg(A, x, b, monitor, M, workspace, thrust::detail::false_type());
+}
+
 } // end namespace krylov
 } // end namespace cusp
 
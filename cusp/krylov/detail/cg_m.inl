@@ -20,6 +20,9 @@
 #include <cusp/multiply.h>
 #include <cusp/monitor.h>
 
+#include <cusp/detail/stream.h>
+#include <cusp/krylov/detail/multishift.h>
+
 #include <thrust/copy.h>
 #include <thrust/fill.h>
 #include <thrust/functional.h>
@@ -27,7 +30,11 @@
 #include <thrust/transform_reduce.h>
 #include <thrust/inner_product.h>
 
+#include <thrust/iterator/counting_iterator.h>
 #include <thrust/iterator/transform_iterator.h>
+#include <thrust/iterator/zip_iterator.h>
+
+#include <cmath>
 
 /*
  * The point of these routines is to solve systems of the type
@@ -376,6 +383,136 @@ namespace trans_m
 } // end namespace trans_m
 
 
+namespace detail
+{
+
+// r <- r + beta * Ap, returns r * conj(r)
+template <typename ValueType>
+struct cg_m_residual_functor
+{
+    typedef ValueType result_type;
+
+    const ValueType beta;
+
+    cg_m_residual_functor(const ValueType beta) : beta(beta) {}
+
+    // (Ap, r)
+    template <typename Tuple>
+    __host__ __device__
+    ValueType operator()(Tuple t) const
+    {
+        const ValueType r = thrust::get<1>(t) + beta * thrust::get<0>(t);
+        thrust::get<1>(t) = r;
+
+        return r * cusp::blas::detail::conjugate<ValueType>()(r);
+    }
+};
+
+// \zeta_1^\sigma, \beta_0^\sigma and \alpha_0^\sigma of one shift in a
+// single pass, recycles \zeta_i^\sigma and advances the shift state
+template <typename ValueType, typename NormType>
+struct cg_m_coefficients_functor
+{
+    const ValueType beta_m1;
+    const ValueType beta_0;
+    const ValueType alpha_m1;
+    const ValueType alpha_0;
+    const NormType  limit;
+
+    cg_m_coefficients_functor(const ValueType beta_m1, const ValueType beta_0,
+                              const ValueType alpha_m1, const ValueType alpha_0,
+                              const NormType limit)
+        : beta_m1(beta_m1), beta_0(beta_0), alpha_m1(alpha_m1), alpha_0(alpha_0), limit(limit)
+    {}
+
+    // (z_m1, z_0, z_1, alpha, beta, sigma, state)
+    template <typename Tuple>
+    __host__ __device__
+    void operator()(Tuple t) const
+    {
+        const ValueType zm1   = thrust::get<0>(t);
+        const ValueType z0    = thrust::get<1>(t);
+        const ValueType sigma = thrust::get<5>(t);
+
+        ValueType z1 = z0*zm1*beta_m1/(beta_0*alpha_m1*(zm1-z0)
+                                      +beta_m1*zm1*(ValueType(1)-beta_0*sigma));
+        const ValueType b0 = beta_0*z1/z0;
+
+        if (abs(z1) < NormType(1e-30))
+            z1 = ValueType(1e-18);
+
+        thrust::get<0>(t) = z0;
+        thrust::get<1>(t) = z1;
+        thrust::get<2>(t) = z1;
+        thrust::get<3>(t) = alpha_0/beta_0*z1*b0/z0;
+        thrust::get<4>(t) = b0;
+
+        // the residual of the shifted system is \zeta_1^\sigma r
+        thrust::get<6>(t) = multishift_next_state(thrust::get<6>(t), z1, limit);
+    }
+};
+
+// p <- r + alpha_0 p and x^\sigma, p^\sigma of all shifts for one row,
+// so r is read once and the vectors of converged shifts are not touched
+template <typename ValueType>
+struct cg_m_update_functor
+{
+    const size_t N;
+    const size_t N_s;
+    const ValueType alpha_0;
+    const ValueType * alpha_s;
+    const ValueType * beta_s;
+    const ValueType * z_1_s;
+    const int * state;
+    ValueType * x;
+    ValueType * p_s;
+
+    cg_m_update_functor(const size_t N, const size_t N_s, const ValueType alpha_0,
+                        const ValueType * alpha_s, const ValueType * beta_s,
+                        const ValueType * z_1_s, const int * state,
+                        ValueType * x, ValueType * p_s)
+        : N(N), N_s(N_s), alpha_0(alpha_0), alpha_s(alpha_s), beta_s(beta_s),
+          z_1_s(z_1_s), state(state), x(x), p_s(p_s)
+    {}
+
+    // (r, p, row)
+    template <typename Tuple>
+    __host__ __device__
+    void operator()(Tuple t) const
+    {
+        const ValueType r = thrust::get<0>(t);
+        const size_t i = thrust::get<2>(t);
+
+        thrust::get<1>(t) = r + alpha_0 * thrust::get<1>(t);
+
+        for (size_t s = 0; s < N_s; s++)
+        {
+            if (state[s] == multishift_frozen)
+                continue;
+
+            const size_t k = s * N + i;
+            const ValueType p = p_s[k];
+
+            x[k]   = x[k] - beta_s[s] * p;
+            p_s[k] = z_1_s[s] * r + alpha_s[s] * p;
+        }
+    }
+};
+
+struct cg_m_solver
+{
+    template <class LinearOperator, class VectorType1, class VectorType2,
+              class VectorType3, class Monitor>
+    void operator()(LinearOperator& A, VectorType1& x, VectorType2& b,
+                    VectorType3& sigma, Monitor& monitor) const
+    {
+        cusp::krylov::cg_m(A, x, b, sigma, monitor);
+    }
+};
+
+} // end namespace detail
+
+
 // CG-M routine that uses the default monitor to determine completion
 template <class LinearOperator,
           class VectorType1,
@@ -405,6 +542,8 @@ void cg_m(LinearOperator& A,
           VectorType3& sigma,
           Monitor& monitor)
 {
+  CUSP_PROFILE_SCOPED();
+
   //
   // This bit is initialization of the solver.
   //
@@ -412,6 +551,7 @@ void cg_m(LinearOperator& A,
   // shorthand for typenames
   typedef typename LinearOperator::value_type   ValueType;
   typedef typename LinearOperator::memory_space MemorySpace;
+  typedef typename norm_type<ValueType>::type   NormType;
 
   // sanity checking
   const size_t N = A.num_rows;
@@ -423,8 +563,6 @@ void cg_m(LinearOperator& A,
   assert(N_t == N*N_s);
   assert(N == test);
 
-  //clock_t start = clock();
-
   // p has data used in computing the soln.
   cusp::array1d<ValueType,MemorySpace> p_0_s(N_t);
 
@@ -441,10 +579,12 @@ void cg_m(LinearOperator& A,
   cusp::array1d<ValueType,MemorySpace> alpha_0_s(N_s,ValueType(0));
   cusp::array1d<ValueType,MemorySpace> beta_0_s(N_s);
 
+  // convergence state of the shifted systems, kept on the device
+  cusp::array1d<int,MemorySpace> state(N_s,int(detail::multishift_active));
+
   // stores parameters used in the iteration for the undeformed system
   ValueType beta_m1, beta_0(ValueType(1));
-  ValueType alpha_0(ValueType(0));
-  //ValueType alpha_0_inv;
+  ValueType alpha_m1, alpha_0(ValueType(0));
 
   // stores the value of the matrix-vector product we have to compute
   cusp::array1d<ValueType,MemorySpace> Ap(N);
@@ -460,21 +600,25 @@ void cg_m(LinearOperator& A,
   rsq_1=cusp::blas::dotc(r_0,r_0);
 
   // set up the intitial guess
-  //  cusp::blas::fill(x.begin(),x.end(),ValueType(0));
   cusp::blas::fill(x,ValueType(0));
 
   // set up initial value of p_0 and p_0^\sigma
   cusp::krylov::trans_m::vectorize_copy(b,p_0_s);
   cusp::blas::copy(b,p_0);
-  
+
+  ValueType * raw_ptr_x = thrust::raw_pointer_cast(&x[0]);
+  ValueType * raw_ptr_p_0_s = thrust::raw_pointer_cast(&p_0_s[0]);
+
   //
   // Initialization is done. Solve iteratively
   //
-  while (!monitor.finished(r_0))
+  while (!detail::multishift_finished(monitor, r_0, NormType(std::sqrt(abs(rsq_1))),
+                                      typename cusp::detail::accepts_residual_norm<Monitor>::type()))
   {
     // recycle iterates
     rsq_0 = rsq_1;
     beta_m1 = beta_0;
+    alpha_m1 = alpha_0;
 
     // compute the matrix-vector product Ap
     cusp::multiply(A,p_0,Ap);
@@ -485,35 +629,64 @@ void cg_m(LinearOperator& A,
     // compute \beta_0
     beta_0 = -rsq_0/pAp;
 
-    // compute the new residual
-    cusp::blas::axpy(Ap,r_0,beta_0);
-
-    // compute \zeta_1^\sigma, \beta_0^\sigma
-    cusp::krylov::trans_m::compute_zb_m(z_0_s, z_m1_s, sigma, z_1_s, beta_0_s,
-		    beta_m1, beta_0, alpha_0);
+    // compute the new residual and (r_{i+1},r_{i+1})
+    rsq_1 = cusp::detail::stream::transform_reduce
+      (thrust::make_zip_iterator(thrust::make_tuple(Ap.begin(), r_0.begin())),
+       thrust::make_zip_iterator(thrust::make_tuple(Ap.begin(), r_0.begin())) + N,
+       detail::cg_m_residual_functor<ValueType>(beta_0),
+       ValueType(0),
+       thrust::plus<ValueType>());
 
     // compute \alpha_0
-    rsq_1 = cusp::blas::dotc(r_0,r_0);
     alpha_0 = rsq_1/rsq_0;
-    cusp::krylov::trans_m::xpay(r_0,p_0,alpha_0);
-    
-    // calculate \alpha_0^\sigma
-    cusp::krylov::trans_m::compute_a_m(z_0_s, z_1_s, beta_0_s,
-                                      alpha_0_s, beta_0, alpha_0);
-
-    // compute x_0^\sigma, p_0^\sigma
-    cusp::krylov::trans_m::compute_xp_m(alpha_0_s, z_1_s, beta_0_s, r_0,
-                                      x, p_0_s);
-
-    // recycle \zeta_i^\sigma
-    cusp::krylov::trans_m::doublecopy(z_1_s,z_0_s,z_m1_s);
-    
+
+    // compute \zeta_1^\sigma, \beta_0^\sigma, \alpha_0^\sigma, recycle
+    // \zeta_i^\sigma and freeze the shifts that have converged
+    const NormType limit = detail::multishift_limit(NormType(monitor.tolerance()),
+                                                    NormType(std::sqrt(abs(rsq_1))));
+
+    cusp::detail::stream::for_each
+      (thrust::make_zip_iterator(thrust::make_tuple(z_m1_s.begin(), z_0_s.begin(), z_1_s.begin(),
+                                                    alpha_0_s.begin(), beta_0_s.begin(), sigma.begin(), state.begin())),
+       thrust::make_zip_iterator(thrust::make_tuple(z_m1_s.begin(), z_0_s.begin(), z_1_s.begin(),
+                                                    alpha_0_s.begin(), beta_0_s.begin(), sigma.begin(), state.begin())) + N_s,
+       detail::cg_m_coefficients_functor<ValueType,NormType>(beta_m1, beta_0, alpha_m1, alpha_0, limit));
+
+    // compute p_0, x_0^\sigma and p_0^\sigma in one pass over the rows
+    cusp::detail::stream::for_each
+      (thrust::make_zip_iterator(thrust::make_tuple(r_0.begin(), p_0.begin(), thrust::counting_iterator<size_t>(0))),
+       thrust::make_zip_iterator(thrust::make_tuple(r_0.begin(), p_0.begin(), thrust::counting_iterator<size_t>(0))) + N,
+       detail::cg_m_update_functor<ValueType>(N, N_s, alpha_0,
+                                              thrust::raw_pointer_cast(&alpha_0_s[0]),
+                                              thrust::raw_pointer_cast(&beta_0_s[0]),
+                                              thrust::raw_pointer_cast(&z_1_s[0]),
+                                              thrust::raw_pointer_cast(&state[0]),
+                                              raw_ptr_x, raw_ptr_p_0_s));
+
     ++monitor;
 
   }// finished iteration
 
 } // end cg_m
 
+// CG-M routine with a polynomial preconditioner
+template <class LinearOperator,
+          class VectorType1,
+          class VectorType2,
+          class VectorType3,
+          class Monitor,
+          class Array>
+void cg_m(LinearOperator& A,
+          VectorType1& x,
+          VectorType2& b,
+          VectorType3& sigma,
+          Monitor& monitor,
+          const Array& coefficients)
+{
+  CUSP_PROFILE_SCOPED();
+
+  detail::multishift_polynomial_solve(A, x, b, sigma, monitor, coefficients, detail::cg_m_solver());
+}
+
 } // end namespace krylov
 } // end namespace cusp
-
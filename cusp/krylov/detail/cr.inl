@@ -66,24 +66,44 @@ void cr(LinearOperator& A,
         Vector& b,
         Monitor& monitor,
         Preconditioner& M)
+{
+    typedef typename LinearOperator::value_type   ValueType;
+    typedef typename LinearOperator::memory_space MemorySpace;
+
+    cusp::krylov::workspace<ValueType,MemorySpace> workspace;
+
+    cusp::krylov::cr(A, x, b, monitor, M, workspace);
+}
+
+template <class LinearOperator,
+         class Vector,
+         class Monitor,
+         class Preconditioner,
+         class Workspace>
+void cr(LinearOperator& A,
+        Vector& x,
+        Vector& b,
+        Monitor& monitor,
+        Preconditioner& M,
+        Workspace& workspace)
 {
     CUSP_PROFILE_SCOPED();
 
     typedef typename LinearOperator::value_type   ValueType;
-    typedef typename LinearOperator::memory_space MemorySpace;
+    typedef typename Workspace::vector_type       Array;
 
     assert(A.num_rows == A.num_cols);        // sanity check
 
     const size_t N = A.num_rows;
     const size_t recompute_r = 8;	     // interval to update r
 
-    // allocate workspace
-    cusp::array1d<ValueType,MemorySpace> y(N);
-    cusp::array1d<ValueType,MemorySpace> z(N);
-    cusp::array1d<ValueType,MemorySpace> r(N);
-    cusp::array1d<ValueType,MemorySpace> p(N);
-    cusp::array1d<ValueType,MemorySpace> Az(N);
-    cusp::array1d<ValueType,MemorySpace> Ax(N);
+    // get workspace
+    Array& y  = workspace.vector(0, N);
+    Array& z  = workspace.vector(1, N);
+    Array& r  = workspace.vector(2, N);
+    Array& p  = workspace.vector(3, N);
+    Array& Az = workspace.vector(4, N);
+    Array& Ax = workspace.vector(5, N);
 
     // y <- A*x
     cusp::multiply(A, x, Ax);
@@ -0,0 +1,292 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include <cusp/array1d.h>
+#include <cusp/array2d.h>
+#include <cusp/blas.h>
+#include <cusp/multiply.h>
+#include <cusp/monitor.h>
+#include <cusp/linear_operator.h>
+
+#include <cusp/krylov/detail/block.h>
+#include <cusp/krylov/detail/ritz.h>
+
+#include <cmath>
+
+namespace blas = cusp::blas;
+
+namespace cusp
+{
+namespace krylov
+{
+namespace detail
+{
+
+// p <- p - W (W^H A W)^-1 (A W)^H z makes p A-orthogonal to W
+template <typename Array2d, typename View, typename Array1d, typename HostArray2d>
+void deflated_cg_project(Array2d& W, Array2d& AW, const size_t s, View& z, View& p,
+                         Array1d& G_dev, const HostArray2d& WAW)
+{
+    typedef typename Array2d::value_type ValueType;
+
+    if (s == 0)
+        return;
+
+    typename block_view<Array2d>::type Ws  = block_columns(W, 0, s);
+    typename block_view<Array2d>::type AWs = block_columns(AW, 0, s);
+
+    HostArray2d mu(s, 1);
+    block_inner_products(AWs, z, G_dev);
+    block_copy_to_host(G_dev, mu);
+
+    block_solve(WAW, mu);
+
+    for (size_t i = 0; i < s; i++)
+        mu(i,0) = -mu(i,0);
+
+    block_copy_to_device(mu, G_dev);
+    block_multiply(Ws, G_dev, p, true);
+}
+
+} // end namespace detail
+
+template <typename ValueType, typename MemorySpace>
+deflated_cg<ValueType,MemorySpace>::deflated_cg(size_t num_vectors, size_t num_directions)
+    : num_vectors(num_vectors), num_directions(num_directions), num_recycled_(0)
+{}
+
+template <typename ValueType, typename MemorySpace>
+template <class LinearOperator,
+          class Vector>
+void deflated_cg<ValueType,MemorySpace>::solve(LinearOperator& A,
+                                               Vector& x,
+                                               Vector& b)
+{
+    cusp::default_monitor<ValueType> monitor(b);
+
+    solve(A, x, b, monitor);
+}
+
+template <typename ValueType, typename MemorySpace>
+template <class LinearOperator,
+          class Vector,
+          class Monitor>
+void deflated_cg<ValueType,MemorySpace>::solve(LinearOperator& A,
+                                               Vector& x,
+                                               Vector& b,
+                                               Monitor& monitor)
+{
+    cusp::identity_operator<ValueType,MemorySpace> M(A.num_rows, A.num_cols);
+
+    solve(A, x, b, monitor, M);
+}
+
+template <typename ValueType, typename MemorySpace>
+template <class LinearOperator,
+          class Vector,
+          class Monitor,
+          class Preconditioner>
+void deflated_cg<ValueType,MemorySpace>::solve(LinearOperator& A,
+                                               Vector& x,
+                                               Vector& b,
+                                               Monitor& monitor,
+                                               Preconditioner& M)
+{
+    CUSP_PROFILE_SCOPED();
+
+    typedef typename norm_type<ValueType>::type   NormType;
+    typedef typename cusp::krylov::workspace<ValueType,MemorySpace>::vector_type Array1d;
+    typedef typename detail::block_view<matrix_type>::type View;
+    typedef cusp::array2d<ValueType,cusp::host_memory,cusp::column_major> HostArray2d;
+
+    assert(A.num_rows == A.num_cols);        // sanity check
+
+    const size_t N = A.num_rows;
+    const size_t L = num_vectors + num_directions;
+
+    // the subspace of a system of another size is useless
+    if (W.num_rows != N)
+        num_recycled_ = 0;
+
+    W.resize(N, L);
+    AW.resize(N, L);
+
+    // get workspace, the vectors are columns so that they can be
+    // combined with the columns of W by the block kernels
+    matrix_type& T = workspace.matrix(0, N, 5);
+    Array1d& G_dev = workspace.vector(0, L * L);
+
+    View xv = detail::block_columns(T, 0, 1);
+    View rv = detail::block_columns(T, 1, 1);
+    View zv = detail::block_columns(T, 2, 1);
+    View pv = detail::block_columns(T, 3, 1);
+
+    typename matrix_type::column_view xc = T.column(0);
+    typename matrix_type::column_view r  = T.column(1);
+    typename matrix_type::column_view z  = T.column(2);
+    typename matrix_type::column_view p  = T.column(3);
+    typename matrix_type::column_view y  = T.column(4);
+
+    size_t s = num_recycled_;
+
+    HostArray2d WAW(s, s);
+
+    // r <- b - A*x
+    blas::copy(x, xc);
+    cusp::multiply(A, xc, y);
+    blas::axpby(b, y, r, ValueType(1), ValueType(-1));
+
+    if (s > 0)
+    {
+        View Ws  = detail::block_columns(W, 0, s);
+        View AWs = detail::block_columns(AW, 0, s);
+
+        // AW <- A*W for the current matrix
+        cusp::multiply(A, Ws, AWs);
+
+        detail::block_inner_products(Ws, AWs, G_dev);
+        detail::block_copy_to_host(G_dev, WAW);
+
+        // x <- x + W (W^H A W)^-1 W^H r, r <- r - A W (W^H A W)^-1 W^H r
+        HostArray2d c(s, 1);
+        detail::block_inner_products(Ws, rv, G_dev);
+        detail::block_copy_to_host(G_dev, c);
+
+        if (detail::block_solve(WAW, c))
+        {
+            detail::block_copy_to_device(c, G_dev);
+            detail::block_multiply(Ws, G_dev, xv, true);
+
+            for (size_t i = 0; i < s; i++)
+                c(i,0) = -c(i,0);
+
+            detail::block_copy_to_device(c, G_dev);
+            detail::block_multiply(AWs, G_dev, rv, true);
+        }
+        else
+        {
+            // W lost its rank, start over
+            s = 0;
+        }
+    }
+
+    // z <- M*r, p <- z - W (W^H A W)^-1 (A W)^H z
+    cusp::multiply(M, r, z);
+    blas::copy(z, p);
+    detail::deflated_cg_project(W, AW, s, zv, pv, G_dev, WAW);
+
+    // rz = <r^H, z>
+    ValueType rz = blas::dotc(r, z);
+
+    // number of search directions kept in W(:,s:s+n)
+    size_t n = 0;
+
+    while (!monitor.finished(r))
+    {
+        // y <- Ap
+        cusp::multiply(A, p, y);
+
+        ValueType py = blas::dotc(p, y);
+
+        // keep A-normalized directions and their products with A
+        if (n < num_directions && detail::s_step_real(py) > 0)
+        {
+            const ValueType scale = ValueType(1) / NormType(std::sqrt(detail::s_step_real(py)));
+
+            blas::copy(p, W.column(s + n));
+            blas::scal(W.column(s + n), scale);
+            blas::copy(y, AW.column(s + n));
+            blas::scal(AW.column(s + n), scale);
+            n++;
+        }
+
+        // alpha <- <r,z>/<y,p>
+        ValueType alpha = rz / py;
+
+        // x <- x + alpha * p
+        blas::axpy(p, xc, alpha);
+
+        // r <- r - alpha * y
+        blas::axpy(y, r, -alpha);
+
+        // z <- M*r
+        cusp::multiply(M, r, z);
+
+        ValueType rz_old = rz;
+
+        // rz = <r^H, z>
+        rz = blas::dotc(r, z);
+
+        // beta <- <r_{i+1},r_{i+1}>/<r,r>
+        ValueType beta = rz / rz_old;
+
+        // p <- z + beta*p - W (W^H A W)^-1 (A W)^H z
+        blas::axpby(z, p, p, ValueType(1), beta);
+        detail::deflated_cg_project(W, AW, s, zv, pv, G_dev, WAW);
+
+        ++monitor;
+    }
+
+    blas::copy(xc, x);
+
+    // Rayleigh-Ritz on Z = [W, P]: the eigenvectors y of
+    // (Z^H A Z)^-1 Z^H Z with the largest eigenvalues 1/theta
+    // approximate the eigenvectors of A with the smallest eigenvalues
+    const size_t m = s + n;
+
+    if (m == 0)
+    {
+        num_recycled_ = 0;
+        return;
+    }
+
+    View Zm  = detail::block_columns(W, 0, m);
+    View AZm = detail::block_columns(AW, 0, m);
+
+    HostArray2d G(m, m), F(m, m), Y;
+
+    detail::block_inner_products(Zm, AZm, G_dev);
+    detail::block_copy_to_host(G_dev, G);
+
+    detail::block_inner_products(Zm, Zm, G_dev);
+    detail::block_copy_to_host(G_dev, F);
+
+    if (!detail::block_solve(G, F))
+    {
+        num_recycled_ = 0;
+        return;
+    }
+
+    const size_t k = detail::ritz_select(F, num_vectors, Y);
+
+    // W <- Z Y with normalized columns
+    matrix_type& W_new = workspace.matrix(1, N, L);
+    View Wk = detail::block_columns(W_new, 0, k);
+
+    detail::block_copy_to_device(Y, G_dev);
+    detail::block_multiply(Zm, G_dev, Wk, false);
+
+    for (size_t j = 0; j < k; j++)
+        blas::scal(W_new.column(j), ValueType(1) / blas::nrm2(W_new.column(j)));
+
+    W.swap(W_new);
+
+    num_recycled_ = k;
+}
+
+} // end namespace krylov
+} // end namespace cusp
+
@@ -0,0 +1,131 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+#pragma once
+
+#include <cusp/detail/device/arch.h>
+#include <cusp/detail/device/common.h>
+#include <cusp/detail/device/utils.h>
+#include <cusp/detail/device/stream.h>
+
+#include <algorithm>
+
+namespace cusp
+{
+namespace krylov
+{
+namespace detail
+{
+namespace device
+{
+
+// The threads of a block cooperating on one system.  Rows are distributed
+// cyclically over the threads and sum() reduces in shared memory.
+template <typename ValueType, unsigned int BLOCK_SIZE>
+struct batched_block_team
+{
+    ValueType * s_sum;
+
+    __host__ __device__
+    batched_block_team(ValueType * s_sum) : s_sum(s_sum) {}
+
+    __host__ __device__
+    size_t rank(void) const
+    {
+#ifdef __CUDA_ARCH__
+        return threadIdx.x;
+#else
+        return 0;
+#endif
+    }
+
+    __host__ __device__
+    size_t size(void) const { return BLOCK_SIZE; }
+
+    __host__ __device__
+    void sync(void) const
+    {
+#ifdef __CUDA_ARCH__
+        __syncthreads();
+#endif
+    }
+
+    // sum of value over the block, returned to every thread
+    __host__ __device__
+    ValueType sum(const ValueType value) const
+    {
+#ifdef __CUDA_ARCH__
+        s_sum[threadIdx.x] = value;
+
+        __syncthreads();
+
+        // reduce within the block (BLOCK_SIZE is a power of two)
+        for(unsigned int offset = BLOCK_SIZE / 2; offset > 0; offset /= 2)
+        {
+            if (threadIdx.x < offset)
+                s_sum[threadIdx.x] = s_sum[threadIdx.x] + s_sum[threadIdx.x + offset];
+
+            __syncthreads();
+        }
+
+        const ValueType result = s_sum[0];
+
+        // s_sum is reused by the next reduction
+        __syncthreads();
+
+        return result;
+#else
+        return value;
+#endif
+    }
+};
+
+// one block per system, grid-stride loop over the systems
+template <typename ValueType, unsigned int BLOCK_SIZE, typename Method>
+__launch_bounds__(BLOCK_SIZE,1)
+__global__ void
+batched_kernel(const Method method, const size_t num_systems)
+{
+    __shared__ ValueType s_sum[BLOCK_SIZE];
+
+    batched_block_team<ValueType,BLOCK_SIZE> team(s_sum);
+
+    for(size_t system = blockIdx.x; system < num_systems; system += gridDim.x)
+        method(team, system);
+}
+
+template <typename ValueType, typename Method>
+void batched_launch(const Method& method, const size_t num_systems)
+{
+    // systems of a few hundred rows leave most threads of larger blocks idle
+    const unsigned int BLOCK_SIZE = 128;
+
+    if (num_systems == 0)
+        return;
+
+    const size_t num_blocks = std::min<size_t>(num_systems, 65535);
+
+    cudaStream_t stream = cusp::detail::device::current_stream();
+
+    batched_kernel<ValueType, BLOCK_SIZE, Method> <<<num_blocks, BLOCK_SIZE, 0, stream>>>(method, num_systems);
+}
+
+} // end namespace device
+} // end namespace detail
+} // end namespace krylov
+} // end namespace cusp
+
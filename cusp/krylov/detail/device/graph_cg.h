@@ -0,0 +1,245 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+#pragma once
+
+#include <cusp/array1d.h>
+#include <cusp/blas.h>
+#include <cusp/exception.h>
+
+#include <cusp/detail/device/arch.h>
+#include <cusp/detail/device/common.h>
+#include <cusp/detail/device/utils.h>
+#include <cusp/detail/device/stream.h>
+
+#include <thrust/device_ptr.h>
+
+#include <cuda_runtime_api.h>
+
+#include <algorithm>
+
+namespace cusp
+{
+namespace krylov
+{
+namespace detail
+{
+namespace device
+{
+
+// Computes the block partial sums of <x^H,y> and <x^H,x>.
+// partials[2 * block + {0,1}] holds the contribution of each block.
+template <typename IndexType, typename ValueType, unsigned int BLOCK_SIZE>
+__launch_bounds__(BLOCK_SIZE,1)
+__global__ void
+graph_cg_dots_kernel(const IndexType N,
+                     const ValueType * x,
+                     const ValueType * y,
+                           ValueType * partials)
+{
+    __shared__ ValueType s_xy[BLOCK_SIZE];
+    __shared__ ValueType s_xx[BLOCK_SIZE];
+
+    const IndexType thread_id = BLOCK_SIZE * blockIdx.x + threadIdx.x;
+    const IndexType grid_size = BLOCK_SIZE * gridDim.x;
+
+    cusp::blas::detail::conjugate<ValueType> conj;
+
+    ValueType xy = 0;
+    ValueType xx = 0;
+
+    for(IndexType i = thread_id; i < N; i += grid_size)
+    {
+        const ValueType xi = conj(x[i]);
+
+        xy += xi * y[i];
+        xx += xi * x[i];
+    }
+
+    s_xy[threadIdx.x] = xy;
+    s_xx[threadIdx.x] = xx;
+
+    __syncthreads();
+
+    // reduce within the block (BLOCK_SIZE is a power of two)
+    for(unsigned int offset = BLOCK_SIZE / 2; offset > 0; offset /= 2)
+    {
+        if (threadIdx.x < offset)
+        {
+            s_xy[threadIdx.x] = s_xy[threadIdx.x] + s_xy[threadIdx.x + offset];
+            s_xx[threadIdx.x] = s_xx[threadIdx.x] + s_xx[threadIdx.x + offset];
+        }
+
+        __syncthreads();
+    }
+
+    if (threadIdx.x == 0)
+    {
+        partials[2 * blockIdx.x + 0] = s_xy[0];
+        partials[2 * blockIdx.x + 1] = s_xx[0];
+    }
+}
+
+// Sums the block partial sums with a single block and updates the CG
+// scalars in device memory, so that no value returns to the host:
+//
+//   INITIAL : rz <- <r^H,z>, rr <- <r^H,r>
+//   ALPHA   : alpha <- rz / <p^H,A p>
+//   BETA    : beta <- <r^H,z> / rz, rz <- <r^H,z>, rr <- <r^H,r>
+template <typename ValueType, unsigned int BLOCK_SIZE>
+__launch_bounds__(BLOCK_SIZE,1)
+__global__ void
+graph_cg_scalars_kernel(const unsigned int num_partials,
+                        const ValueType * partials,
+                              ValueType * scalars,
+                        const int step)
+{
+    __shared__ ValueType s_xy[BLOCK_SIZE];
+    __shared__ ValueType s_xx[BLOCK_SIZE];
+
+    ValueType xy = 0;
+    ValueType xx = 0;
+
+    for(unsigned int i = threadIdx.x; i < num_partials; i += BLOCK_SIZE)
+    {
+        xy += partials[2 * i + 0];
+        xx += partials[2 * i + 1];
+    }
+
+    s_xy[threadIdx.x] = xy;
+    s_xx[threadIdx.x] = xx;
+
+    __syncthreads();
+
+    for(unsigned int offset = BLOCK_SIZE / 2; offset > 0; offset /= 2)
+    {
+        if (threadIdx.x < offset)
+        {
+            s_xy[threadIdx.x] = s_xy[threadIdx.x] + s_xy[threadIdx.x + offset];
+            s_xx[threadIdx.x] = s_xx[threadIdx.x] + s_xx[threadIdx.x + offset];
+        }
+
+        __syncthreads();
+    }
+
+    if (threadIdx.x == 0)
+    {
+        // scalars = [rz, rr, alpha, beta]
+        if (step == 0)
+        {
+            scalars[0] = s_xy[0];
+            scalars[1] = s_xx[0];
+        }
+        else if (step == 1)
+        {
+            scalars[2] = scalars[0] / s_xy[0];
+        }
+        else
+        {
+            scalars[3] = s_xy[0] / scalars[0];
+            scalars[0] = s_xy[0];
+            scalars[1] = s_xx[0];
+        }
+    }
+}
+
+// The scalars of a CG iteration kept in device memory.
+//
+// dots() enqueues the inner products and the update of the scalars on the
+// current stream without waiting for them, and fetch_residual() enqueues a
+// copy of <r^H,r> into page-locked host memory.  An iteration built from
+// these operations contains no synchronization, so it can be recorded as
+// a CUDA Graph, and residual() is the only point at which the host waits.
+template <typename ValueType>
+class graph_cg_scalars
+{
+    public:
+    static const unsigned int BLOCK_SIZE = 256;
+
+    enum step_type { INITIAL = 0, ALPHA = 1, BETA = 2 };
+
+    graph_cg_scalars(size_t N)
+        : scalars(4, ValueType(0)), h_rr(0)
+    {
+        const size_t MAX_BLOCKS = cusp::detail::device::arch::max_active_blocks(graph_cg_dots_kernel<int, ValueType, BLOCK_SIZE>, BLOCK_SIZE, (size_t) 0);
+        num_blocks = std::max<size_t>(1, std::min<size_t>(MAX_BLOCKS, DIVIDE_INTO(N, BLOCK_SIZE)));
+
+        partials.resize(2 * num_blocks);
+
+        if (cudaMallocHost((void **) &h_rr, sizeof(ValueType)) != cudaSuccess)
+            throw cusp::runtime_exception("graph_cg: unable to allocate page-locked memory");
+
+        *h_rr = ValueType(0);
+    }
+
+    ~graph_cg_scalars(void)
+    {
+        cudaFreeHost(h_rr);
+    }
+
+    // update the scalars from <x^H,y> and <x^H,x>
+    template <typename Array>
+    void dots(const Array& x, const Array& y, step_type step)
+    {
+        cudaStream_t stream = cusp::detail::device::current_stream();
+
+        graph_cg_dots_kernel<int, ValueType, BLOCK_SIZE> <<<num_blocks, BLOCK_SIZE, 0, stream>>>
+            (int(x.size()),
+             thrust::raw_pointer_cast(&x[0]),
+             thrust::raw_pointer_cast(&y[0]),
+             thrust::raw_pointer_cast(&partials[0]));
+
+        graph_cg_scalars_kernel<ValueType, BLOCK_SIZE> <<<1, BLOCK_SIZE, 0, stream>>>
+            (num_blocks,
+             thrust::raw_pointer_cast(&partials[0]),
+             thrust::raw_pointer_cast(&scalars[0]),
+             int(step));
+    }
+
+    const ValueType * alpha(void) const { return thrust::raw_pointer_cast(&scalars[2]); }
+    const ValueType * beta (void) const { return thrust::raw_pointer_cast(&scalars[3]); }
+
+    // copy <r^H,r> to the host once the work before it completes
+    void fetch_residual(void)
+    {
+        cudaMemcpyAsync(h_rr, thrust::raw_pointer_cast(&scalars[1]), sizeof(ValueType),
+                        cudaMemcpyDeviceToHost, cusp::detail::device::current_stream());
+    }
+
+    // wait for the last fetch_residual() and return <r^H,r>
+    ValueType residual(void) const
+    {
+        cudaStreamSynchronize(cusp::detail::device::current_stream());
+
+        return *h_rr;
+    }
+
+    private:
+    unsigned int num_blocks;
+    cusp::array1d<ValueType,cusp::device_memory> partials;
+    cusp::array1d<ValueType,cusp::device_memory> scalars;
+    ValueType * h_rr;
+
+    // non-copyable
+    graph_cg_scalars(const graph_cg_scalars&);
+    graph_cg_scalars& operator=(const graph_cg_scalars&);
+};
+
+} // end namespace device
+} // end namespace detail
+} // end namespace krylov
+} // end namespace cusp
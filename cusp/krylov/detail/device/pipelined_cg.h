@@ -0,0 +1,183 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+#pragma once
+
+#include <cusp/array1d.h>
+#include <cusp/blas.h>
+#include <cusp/exception.h>
+
+#include <cusp/detail/device/arch.h>
+#include <cusp/detail/device/common.h>
+#include <cusp/detail/device/utils.h>
+#include <cusp/detail/device/stream.h>
+
+#include <thrust/device_ptr.h>
+
+#include <cuda_runtime_api.h>
+
+namespace cusp
+{
+namespace krylov
+{
+namespace detail
+{
+namespace device
+{
+
+// Computes the block partial sums of <r^H,u>, <w^H,u> and <r^H,r>.
+// partials[3 * block + {0,1,2}] holds the contribution of each block.
+template <typename IndexType, typename ValueType, unsigned int BLOCK_SIZE>
+__launch_bounds__(BLOCK_SIZE,1)
+__global__ void
+pipelined_cg_dots_kernel(const IndexType N,
+                         const ValueType * r,
+                         const ValueType * u,
+                         const ValueType * w,
+                               ValueType * partials)
+{
+    __shared__ ValueType s_gamma[BLOCK_SIZE];
+    __shared__ ValueType s_delta[BLOCK_SIZE];
+    __shared__ ValueType s_rr   [BLOCK_SIZE];
+
+    const IndexType thread_id = BLOCK_SIZE * blockIdx.x + threadIdx.x;
+    const IndexType grid_size = BLOCK_SIZE * gridDim.x;
+
+    cusp::blas::detail::conjugate<ValueType> conj;
+
+    ValueType gamma = 0;
+    ValueType delta = 0;
+    ValueType rr    = 0;
+
+    for(IndexType i = thread_id; i < N; i += grid_size)
+    {
+        const ValueType ri = r[i];
+        const ValueType ui = u[i];
+
+        gamma += conj(ri)   * ui;
+        delta += conj(w[i]) * ui;
+        rr    += conj(ri)   * ri;
+    }
+
+    s_gamma[threadIdx.x] = gamma;
+    s_delta[threadIdx.x] = delta;
+    s_rr   [threadIdx.x] = rr;
+
+    __syncthreads();
+
+    // reduce within the block (BLOCK_SIZE is a power of two)
+    for(unsigned int offset = BLOCK_SIZE / 2; offset > 0; offset /= 2)
+    {
+        if (threadIdx.x < offset)
+        {
+            s_gamma[threadIdx.x] = s_gamma[threadIdx.x] + s_gamma[threadIdx.x + offset];
+            s_delta[threadIdx.x] = s_delta[threadIdx.x] + s_delta[threadIdx.x + offset];
+            s_rr   [threadIdx.x] = s_rr   [threadIdx.x] + s_rr   [threadIdx.x + offset];
+        }
+
+        __syncthreads();
+    }
+
+    if (threadIdx.x == 0)
+    {
+        partials[3 * blockIdx.x + 0] = s_gamma[0];
+        partials[3 * blockIdx.x + 1] = s_delta[0];
+        partials[3 * blockIdx.x + 2] = s_rr[0];
+    }
+}
+
+// Issues the reduction of a pipelined CG iteration without waiting for it.
+//
+// begin() enqueues the reduction kernel and an asynchronous copy of the
+// block partial sums into page-locked host memory on the current stream,
+// followed by an event.  Work enqueued after begin() (the preconditioner
+// and the SpMV) runs while end() waits on the event, so only the reduction
+// itself is on the host's critical path.
+template <typename ValueType>
+class pipelined_cg_reduction
+{
+    public:
+    static const unsigned int BLOCK_SIZE = 256;
+
+    pipelined_cg_reduction(size_t N)
+        : h_partials(0)
+    {
+        const size_t MAX_BLOCKS = cusp::detail::device::arch::max_active_blocks(pipelined_cg_dots_kernel<int, ValueType, BLOCK_SIZE>, BLOCK_SIZE, (size_t) 0);
+        num_blocks = std::max<size_t>(1, std::min<size_t>(MAX_BLOCKS, DIVIDE_INTO(N, BLOCK_SIZE)));
+
+        d_partials.resize(3 * num_blocks);
+
+        if (cudaMallocHost((void **) &h_partials, 3 * num_blocks * sizeof(ValueType)) != cudaSuccess)
+            throw cusp::runtime_exception("pipelined_cg: unable to allocate page-locked memory");
+
+        cudaEventCreateWithFlags(&event, cudaEventDisableTiming);
+    }
+
+    ~pipelined_cg_reduction(void)
+    {
+        cudaEventDestroy(event);
+        cudaFreeHost(h_partials);
+    }
+
+    template <typename Array>
+    void begin(const Array& r, const Array& u, const Array& w)
+    {
+        cudaStream_t stream = cusp::detail::device::current_stream();
+
+        pipelined_cg_dots_kernel<int, ValueType, BLOCK_SIZE> <<<num_blocks, BLOCK_SIZE, 0, stream>>>
+            (int(r.size()),
+             thrust::raw_pointer_cast(&r[0]),
+             thrust::raw_pointer_cast(&u[0]),
+             thrust::raw_pointer_cast(&w[0]),
+             thrust::raw_pointer_cast(&d_partials[0]));
+
+        cudaMemcpyAsync(h_partials, thrust::raw_pointer_cast(&d_partials[0]),
+                        3 * num_blocks * sizeof(ValueType), cudaMemcpyDeviceToHost, stream);
+
+        cudaEventRecord(event, stream);
+    }
+
+    void end(ValueType& gamma, ValueType& delta, ValueType& rr)
+    {
+        cudaEventSynchronize(event);
+
+        gamma = delta = rr = ValueType(0);
+
+        for(size_t i = 0; i < num_blocks; i++)
+        {
+            gamma += h_partials[3 * i + 0];
+            delta += h_partials[3 * i + 1];
+            rr    += h_partials[3 * i + 2];
+        }
+    }
+
+    private:
+    size_t num_blocks;
+    cusp::array1d<ValueType,cusp::device_memory> d_partials;
+    ValueType * h_partials;
+    cudaEvent_t event;
+
+    // non-copyable
+    pipelined_cg_reduction(const pipelined_cg_reduction&);
+    pipelined_cg_reduction& operator=(const pipelined_cg_reduction&);
+};
+
+} // end namespace device
+} // end namespace detail
+} // end namespace krylov
+} // end namespace cusp
+
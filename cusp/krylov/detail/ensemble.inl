@@ -0,0 +1,696 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+#include <cusp/array1d.h>
+#include <cusp/array2d.h>
+#include <cusp/complex.h>
+#include <cusp/exception.h>
+#include <cusp/multiply.h>
+
+#include <cusp/detail/functional.h>
+
+#include <thrust/copy.h>
+#include <thrust/fill.h>
+#include <thrust/for_each.h>
+#include <thrust/reduce.h>
+#include <thrust/iterator/counting_iterator.h>
+#include <thrust/iterator/discard_iterator.h>
+#include <thrust/iterator/transform_iterator.h>
+
+#include <cassert>
+#include <cmath>
+
+namespace cusp
+{
+namespace krylov
+{
+namespace detail
+{
+
+// The blocks of vectors of an ensemble are row-major N x E arrays: entry i
+// of the vector of member e is at i * pitch + e.  The updates run over
+// idx = i * E + e, so consecutive threads touch consecutive members of a
+// row, and take their per-member scalars from a device array of size E.
+
+// row-major N x E block over the leading N * E entries of a work vector
+template <typename Vector>
+struct ensemble_block
+{
+    typedef cusp::array1d_view<typename Vector::iterator>  values_view;
+    typedef cusp::array2d_view<values_view, cusp::row_major> type;
+};
+
+template <typename Vector>
+typename ensemble_block<Vector>::type
+make_ensemble_block(Vector& v, const size_t N, const size_t E)
+{
+    typedef typename ensemble_block<Vector>::values_view values_view;
+
+    return typename ensemble_block<Vector>::type(N, E, E, values_view(v.begin(), v.begin() + N * E));
+}
+
+// Y(i,e) <- Y(i,e) + alpha[e] * X(i,e)
+template <typename ValueType>
+struct ensemble_axpy_functor
+{
+    const ValueType * X;
+    ValueType * Y;
+    const ValueType * alpha;
+    size_t X_pitch;
+    size_t Y_pitch;
+    size_t E;
+
+    ensemble_axpy_functor(const ValueType * X, ValueType * Y, const ValueType * alpha,
+                          size_t X_pitch, size_t Y_pitch, size_t E)
+      : X(X), Y(Y), alpha(alpha), X_pitch(X_pitch), Y_pitch(Y_pitch), E(E) {}
+
+    __host__ __device__
+    void operator()(const size_t idx) const
+    {
+        const size_t i = idx / E;
+        const size_t e = idx - i * E;
+        Y[i * Y_pitch + e] += alpha[e] * X[i * X_pitch + e];
+    }
+};
+
+// Y(i,e) <- X(i,e) + beta[e] * Y(i,e)
+template <typename ValueType>
+struct ensemble_xpby_functor
+{
+    const ValueType * X;
+    ValueType * Y;
+    const ValueType * beta;
+    size_t X_pitch;
+    size_t Y_pitch;
+    size_t E;
+
+    ensemble_xpby_functor(const ValueType * X, ValueType * Y, const ValueType * beta,
+                          size_t X_pitch, size_t Y_pitch, size_t E)
+      : X(X), Y(Y), beta(beta), X_pitch(X_pitch), Y_pitch(Y_pitch), E(E) {}
+
+    __host__ __device__
+    void operator()(const size_t idx) const
+    {
+        const size_t i = idx / E;
+        const size_t e = idx - i * E;
+        Y[i * Y_pitch + e] = X[i * X_pitch + e] + beta[e] * Y[i * Y_pitch + e];
+    }
+};
+
+// Z(i,e) <- D(i,e) * R(i,e), all with pitch E
+template <typename ValueType>
+struct ensemble_scale_functor
+{
+    const ValueType * D;
+    const ValueType * R;
+    ValueType * Z;
+
+    ensemble_scale_functor(const ValueType * D, const ValueType * R, ValueType * Z)
+      : D(D), R(R), Z(Z) {}
+
+    __host__ __device__
+    void operator()(const size_t idx) const
+    {
+        Z[idx] = D[idx] * R[idx];
+    }
+};
+
+// D(i,e) <- inverse of the diagonal entry of row i of member e, or one
+// when the row has none
+template <typename IndexType, typename ValueType>
+struct ensemble_inverse_diagonal_functor
+{
+    const IndexType * Ap;
+    const IndexType * Aj;
+    const ValueType * Ax;
+    ValueType * D;
+    size_t E;
+
+    ensemble_inverse_diagonal_functor(const IndexType * Ap, const IndexType * Aj, const ValueType * Ax,
+                                      ValueType * D, size_t E)
+      : Ap(Ap), Aj(Aj), Ax(Ax), D(D), E(E) {}
+
+    __host__ __device__
+    void operator()(const size_t idx) const
+    {
+        const size_t i = idx / E;
+        const size_t e = idx - i * E;
+
+        ValueType d = ValueType(0);
+
+        for (IndexType jj = Ap[i]; jj < Ap[i + 1]; jj++)
+            if (size_t(Aj[jj]) == i)
+                d += Ax[jj * E + e];
+
+        D[idx] = d == ValueType(0) ? ValueType(1) : ValueType(1) / d;
+    }
+};
+
+// the reductions run over idx = e * N + i, so that each member is one key
+struct ensemble_member_key
+{
+    size_t N;
+
+    ensemble_member_key(size_t N) : N(N) {}
+
+    __host__ __device__
+    size_t operator()(const size_t idx) const { return idx / N; }
+};
+
+// conj(U(i,e)) * V(i,e) for idx = e * N + i
+template <typename ValueType>
+struct ensemble_product
+{
+    const ValueType * U;
+    const ValueType * V;
+    size_t U_pitch;
+    size_t V_pitch;
+    size_t N;
+
+    ensemble_product(const ValueType * U, const ValueType * V, size_t U_pitch, size_t V_pitch, size_t N)
+      : U(U), V(V), U_pitch(U_pitch), V_pitch(V_pitch), N(N) {}
+
+    __host__ __device__
+    ValueType operator()(const size_t idx) const
+    {
+        const size_t e = idx / N;
+        const size_t i = idx - e * N;
+        return cusp::detail::conjugate_value(U[i * U_pitch + e]) * V[i * V_pitch + e];
+    }
+};
+
+// scalars of the members, kept on the host and copied to the device
+// before each update
+template <typename ValueType, typename MemorySpace>
+struct ensemble_scalars
+{
+    typedef cusp::array1d<ValueType,cusp::host_memory> host_array;
+
+    cusp::array1d<ValueType,MemorySpace> device;
+
+    ensemble_scalars(const size_t E) : device(E, ValueType(0)) {}
+
+    const ValueType * upload(const host_array& s)
+    {
+        device = s;
+        return thrust::raw_pointer_cast(&device[0]);
+    }
+};
+
+// d[e] = U(:,e)^H V(:,e) for every member, with one reduction
+template <typename Array2d1, typename Array2d2, typename ValueType, typename MemorySpace>
+void ensemble_dot(const Array2d1& U, const Array2d2& V,
+                  ensemble_scalars<ValueType,MemorySpace>& work,
+                  cusp::array1d<ValueType,cusp::host_memory>& d)
+{
+    const size_t N = U.num_rows;
+    const size_t E = U.num_cols;
+
+    thrust::fill(work.device.begin(), work.device.end(), ValueType(0));
+
+    thrust::reduce_by_key
+        (thrust::make_transform_iterator(thrust::counting_iterator<size_t>(0), ensemble_member_key(N)),
+         thrust::make_transform_iterator(thrust::counting_iterator<size_t>(N * E), ensemble_member_key(N)),
+         thrust::make_transform_iterator(thrust::counting_iterator<size_t>(0),
+                                         ensemble_product<ValueType>(thrust::raw_pointer_cast(&U.values[0]),
+                                                                     thrust::raw_pointer_cast(&V.values[0]),
+                                                                     U.pitch, V.pitch, N)),
+         thrust::make_discard_iterator(),
+         work.device.begin());
+
+    d = work.device;
+}
+
+template <typename Array2d, typename ValueType, typename MemorySpace, typename Real>
+void ensemble_norms(const Array2d& U,
+                    ensemble_scalars<ValueType,MemorySpace>& work,
+                    cusp::array1d<Real,cusp::host_memory>& norms)
+{
+    cusp::array1d<ValueType,cusp::host_memory> d;
+    ensemble_dot(U, U, work, d);
+
+    for (size_t e = 0; e < d.size(); e++)
+        norms[e] = std::sqrt(batched_real(d[e]));
+}
+
+// Y(:,e) <- Y(:,e) + alpha[e] X(:,e)
+template <typename Array2d1, typename Array2d2, typename ValueType, typename MemorySpace>
+void ensemble_axpy(const Array2d1& X, Array2d2& Y,
+                   ensemble_scalars<ValueType,MemorySpace>& work,
+                   const cusp::array1d<ValueType,cusp::host_memory>& alpha)
+{
+    const ValueType * a = work.upload(alpha);
+
+    thrust::for_each(thrust::counting_iterator<size_t>(0),
+                     thrust::counting_iterator<size_t>(X.num_rows * X.num_cols),
+                     ensemble_axpy_functor<ValueType>(thrust::raw_pointer_cast(&X.values[0]),
+                                                      thrust::raw_pointer_cast(&Y.values[0]),
+                                                      a, X.pitch, Y.pitch, X.num_cols));
+}
+
+// Y(:,e) <- X(:,e) + beta[e] Y(:,e)
+template <typename Array2d1, typename Array2d2, typename ValueType, typename MemorySpace>
+void ensemble_xpby(const Array2d1& X, Array2d2& Y,
+                   ensemble_scalars<ValueType,MemorySpace>& work,
+                   const cusp::array1d<ValueType,cusp::host_memory>& beta)
+{
+    const ValueType * b = work.upload(beta);
+
+    thrust::for_each(thrust::counting_iterator<size_t>(0),
+                     thrust::counting_iterator<size_t>(X.num_rows * X.num_cols),
+                     ensemble_xpby_functor<ValueType>(thrust::raw_pointer_cast(&X.values[0]),
+                                                      thrust::raw_pointer_cast(&Y.values[0]),
+                                                      b, X.pitch, Y.pitch, X.num_cols));
+}
+
+// R <- B - A X
+template <typename Matrix, typename Array2d1, typename Array2d2, typename Array2d3, typename ValueType, typename MemorySpace>
+void ensemble_residual(const Matrix& A, const Array2d1& X, const Array2d2& B, Array2d3& R,
+                       ensemble_scalars<ValueType,MemorySpace>& work)
+{
+    cusp::multiply(A, X, R);
+    ensemble_xpby(B, R, work, cusp::array1d<ValueType,cusp::host_memory>(R.num_cols, ValueType(-1)));
+}
+
+// Z <- M R, with M the identity or the inverse diagonals in D
+template <typename Vector, typename Array2d1, typename Array2d2>
+void ensemble_precondition(const Vector& D, const bool jacobi, const Array2d1& R, Array2d2& Z)
+{
+    typedef typename Vector::value_type ValueType;
+
+    if (!jacobi)
+    {
+        thrust::copy(R.values.begin(), R.values.end(), Z.values.begin());
+        return;
+    }
+
+    thrust::for_each(thrust::counting_iterator<size_t>(0),
+                     thrust::counting_iterator<size_t>(R.num_rows * R.num_cols),
+                     ensemble_scale_functor<ValueType>(thrust::raw_pointer_cast(&D[0]),
+                                                       thrust::raw_pointer_cast(&R.values[0]),
+                                                       thrust::raw_pointer_cast(&Z.values[0])));
+}
+
+template <typename Matrix, typename Vector>
+void ensemble_inverse_diagonal(const Matrix& A, Vector& D)
+{
+    typedef typename Matrix::index_type IndexType;
+    typedef typename Matrix::value_type ValueType;
+
+    thrust::for_each(thrust::counting_iterator<size_t>(0),
+                     thrust::counting_iterator<size_t>(A.num_rows * A.num_members),
+                     ensemble_inverse_diagonal_functor<IndexType,ValueType>
+                         (thrust::raw_pointer_cast(&A.row_offsets[0]),
+                          A.column_indices.empty() ? NULL : thrust::raw_pointer_cast(&A.column_indices[0]),
+                          A.values.empty() ? NULL : thrust::raw_pointer_cast(&A.values[0]),
+                          thrust::raw_pointer_cast(&D[0]), A.num_members));
+}
+
+// per-member tolerances, iteration counts and convergence of a solve
+template <typename Real>
+struct ensemble_progress
+{
+    cusp::array1d<Real,cusp::host_memory> tolerances;
+    cusp::array1d<Real,cusp::host_memory> residuals;
+    cusp::array1d<int,cusp::host_memory>  iterations;
+    cusp::array1d<int,cusp::host_memory>  converged;
+    cusp::array1d<int,cusp::host_memory>  active;
+
+    template <typename Monitor>
+    ensemble_progress(const Monitor& monitor, const cusp::array1d<Real,cusp::host_memory>& b_norms)
+      : tolerances(b_norms.size()), residuals(b_norms.size(), Real(0)),
+        iterations(b_norms.size(), 0), converged(b_norms.size(), 0), active(b_norms.size(), 1)
+    {
+        for (size_t e = 0; e < b_norms.size(); e++)
+            tolerances[e] = monitor.absolute_tolerance() + monitor.relative_tolerance() * b_norms[e];
+    }
+
+    // retire the members whose residual satisfies the tolerance and
+    // return the number of members still iterating
+    size_t update(const cusp::array1d<Real,cusp::host_memory>& r_norms)
+    {
+        size_t num_active = 0;
+
+        for (size_t e = 0; e < r_norms.size(); e++)
+        {
+            if (!active[e])
+                continue;
+
+            residuals[e] = r_norms[e];
+
+            if (r_norms[e] <= tolerances[e])
+            {
+                converged[e] = 1;
+                active[e] = 0;
+            }
+
+            num_active += active[e];
+        }
+
+        return num_active;
+    }
+
+    // stop member e after a breakdown
+    void retire(const size_t e) { active[e] = 0; }
+
+    template <typename Monitor>
+    void record(Monitor& monitor) const
+    {
+        monitor.record(iterations, residuals, converged);
+    }
+};
+
+template <typename Matrix, typename Array2d1, typename Array2d2>
+void ensemble_check(const Matrix& A, const Array2d1& X, const Array2d2& B)
+{
+    if (A.num_rows != A.num_cols)
+        throw cusp::invalid_input_exception("ensemble solvers require square matrices");
+
+    cusp::detail::ensemble_check_vectors(X, A.num_cols, A.num_members, typename Array2d1::orientation());
+    cusp::detail::ensemble_check_vectors(B, A.num_rows, A.num_members, typename Array2d2::orientation());
+}
+
+} // end namespace detail
+
+template <class Matrix,
+          class Array2d1,
+          class Array2d2,
+          class Monitor>
+void ensemble_cg(const Matrix& A,
+                 Array2d1& X,
+                 const Array2d2& B,
+                 Monitor& monitor,
+                 const batched_preconditioner preconditioner)
+{
+    typedef typename Matrix::value_type   ValueType;
+    typedef typename Matrix::memory_space MemorySpace;
+
+    cusp::krylov::workspace<ValueType,MemorySpace> workspace;
+
+    cusp::krylov::ensemble_cg(A, X, B, monitor, preconditioner, workspace);
+}
+
+template <class Matrix,
+          class Array2d1,
+          class Array2d2,
+          class Monitor,
+          class Workspace>
+void ensemble_cg(const Matrix& A,
+                 Array2d1& X,
+                 const Array2d2& B,
+                 Monitor& monitor,
+                 const batched_preconditioner preconditioner,
+                 Workspace& workspace)
+{
+    CUSP_PROFILE_SCOPED();
+
+    typedef typename Matrix::value_type         ValueType;
+    typedef typename Matrix::memory_space       MemorySpace;
+    typedef typename norm_type<ValueType>::type Real;
+    typedef typename Workspace::vector_type     Vector;
+    typedef typename detail::ensemble_block<Vector>::type Block;
+    typedef cusp::array1d<ValueType,cusp::host_memory> Scalars;
+
+    detail::ensemble_check(A, X, B);
+
+    const size_t N = A.num_rows;
+    const size_t E = A.num_members;
+    const bool jacobi = preconditioner == BATCHED_JACOBI;
+
+    detail::ensemble_scalars<ValueType,MemorySpace> work(E);
+
+    cusp::array1d<Real,cusp::host_memory> r_norms(E, Real(0));
+
+    if (N > 0)
+        detail::ensemble_norms(B, work, r_norms);
+
+    detail::ensemble_progress<Real> progress(monitor, r_norms);
+
+    if (N == 0 || E == 0)
+    {
+        progress.update(r_norms);
+        progress.record(monitor);
+        return;
+    }
+
+    Block R = detail::make_ensemble_block(workspace.vector(0, N * E), N, E);
+    Block Z = detail::make_ensemble_block(workspace.vector(1, N * E), N, E);
+    Block P = detail::make_ensemble_block(workspace.vector(2, N * E), N, E);
+    Block Q = detail::make_ensemble_block(workspace.vector(3, N * E), N, E);
+    Vector& D = workspace.vector(4, jacobi ? N * E : 0);
+
+    if (jacobi)
+        detail::ensemble_inverse_diagonal(A, D);
+
+    Scalars rho(E), rho_new(E), pq(E), alpha(E), beta(E);
+
+    // r <- b - A x, z <- M r, p <- z
+    detail::ensemble_residual(A, X, B, R, work);
+    detail::ensemble_precondition(D, jacobi, R, Z);
+    thrust::copy(Z.values.begin(), Z.values.end(), P.values.begin());
+
+    detail::ensemble_dot(R, Z, work, rho);
+    detail::ensemble_norms(R, work, r_norms);
+
+    for (size_t iteration = 0; progress.update(r_norms) > 0 && iteration < monitor.iteration_limit(); iteration++)
+    {
+        // q <- A p, alpha <- <r,z> / <p,q>
+        cusp::multiply(A, P, Q);
+        detail::ensemble_dot(P, Q, work, pq);
+
+        for (size_t e = 0; e < E; e++)
+        {
+            alpha[e] = ValueType(0);
+
+            if (!progress.active[e])
+                continue;
+
+            if (pq[e] == ValueType(0))
+                progress.retire(e);
+            else
+                alpha[e] = rho[e] / pq[e];
+        }
+
+        // x <- x + alpha p, r <- r - alpha q
+        detail::ensemble_axpy(P, X, work, alpha);
+
+        for (size_t e = 0; e < E; e++)
+            alpha[e] = -alpha[e];
+
+        detail::ensemble_axpy(Q, R, work, alpha);
+
+        // z <- M r, beta <- <r_new,z_new> / <r,z>, p <- z + beta p
+        detail::ensemble_precondition(D, jacobi, R, Z);
+        detail::ensemble_dot(R, Z, work, rho_new);
+        detail::ensemble_norms(R, work, r_norms);
+
+        for (size_t e = 0; e < E; e++)
+        {
+            beta[e] = ValueType(0);
+
+            if (!progress.active[e])
+                continue;
+
+            progress.iterations[e]++;
+
+            if (rho[e] != ValueType(0))
+                beta[e] = rho_new[e] / rho[e];
+
+            rho[e] = rho_new[e];
+        }
+
+        detail::ensemble_xpby(Z, P, work, beta);
+    }
+
+    progress.record(monitor);
+}
+
+template <class Matrix,
+          class Array2d1,
+          class Array2d2,
+          class Monitor>
+void ensemble_bicgstab(const Matrix& A,
+                       Array2d1& X,
+                       const Array2d2& B,
+                       Monitor& monitor,
+                       const batched_preconditioner preconditioner)
+{
+    typedef typename Matrix::value_type   ValueType;
+    typedef typename Matrix::memory_space MemorySpace;
+
+    cusp::krylov::workspace<ValueType,MemorySpace> workspace;
+
+    cusp::krylov::ensemble_bicgstab(A, X, B, monitor, preconditioner, workspace);
+}
+
+template <class Matrix,
+          class Array2d1,
+          class Array2d2,
+          class Monitor,
+          class Workspace>
+void ensemble_bicgstab(const Matrix& A,
+                       Array2d1& X,
+                       const Array2d2& B,
+                       Monitor& monitor,
+                       const batched_preconditioner preconditioner,
+                       Workspace& workspace)
+{
+    CUSP_PROFILE_SCOPED();
+
+    typedef typename Matrix::value_type         ValueType;
+    typedef typename Matrix::memory_space       MemorySpace;
+    typedef typename norm_type<ValueType>::type Real;
+    typedef typename Workspace::vector_type     Vector;
+    typedef typename detail::ensemble_block<Vector>::type Block;
+    typedef cusp::array1d<ValueType,cusp::host_memory> Scalars;
+
+    detail::ensemble_check(A, X, B);
+
+    const size_t N = A.num_rows;
+    const size_t E = A.num_members;
+    const bool jacobi = preconditioner == BATCHED_JACOBI;
+
+    detail::ensemble_scalars<ValueType,MemorySpace> work(E);
+
+    cusp::array1d<Real,cusp::host_memory> r_norms(E, Real(0));
+
+    if (N > 0)
+        detail::ensemble_norms(B, work, r_norms);
+
+    detail::ensemble_progress<Real> progress(monitor, r_norms);
+
+    if (N == 0 || E == 0)
+    {
+        progress.update(r_norms);
+        progress.record(monitor);
+        return;
+    }
+
+    Block R     = detail::make_ensemble_block(workspace.vector(0, N * E), N, E);
+    Block R0    = detail::make_ensemble_block(workspace.vector(1, N * E), N, E);
+    Block P     = detail::make_ensemble_block(workspace.vector(2, N * E), N, E);
+    Block V     = detail::make_ensemble_block(workspace.vector(3, N * E), N, E);
+    Block S     = detail::make_ensemble_block(workspace.vector(4, N * E), N, E);
+    Block T     = detail::make_ensemble_block(workspace.vector(5, N * E), N, E);
+    Block P_hat = detail::make_ensemble_block(workspace.vector(6, N * E), N, E);
+    Block S_hat = detail::make_ensemble_block(workspace.vector(7, N * E), N, E);
+    Vector& D = workspace.vector(8, jacobi ? N * E : 0);
+
+    if (jacobi)
+        detail::ensemble_inverse_diagonal(A, D);
+
+    Scalars rho(E), rho_new(E), r0v(E), ts(E), tt(E), alpha(E), omega(E), beta(E), scale(E);
+
+    // r <- b - A x, r0 <- r, p <- r
+    detail::ensemble_residual(A, X, B, R, work);
+    thrust::copy(R.values.begin(), R.values.end(), R0.values.begin());
+    thrust::copy(R.values.begin(), R.values.end(), P.values.begin());
+
+    detail::ensemble_dot(R0, R, work, rho);
+    detail::ensemble_norms(R, work, r_norms);
+
+    for (size_t iteration = 0; progress.update(r_norms) > 0 && iteration < monitor.iteration_limit(); iteration++)
+    {
+        // p_hat <- M p, v <- A p_hat, alpha <- <r0,r> / <r0,v>
+        detail::ensemble_precondition(D, jacobi, P, P_hat);
+        cusp::multiply(A, P_hat, V);
+        detail::ensemble_dot(R0, V, work, r0v);
+
+        for (size_t e = 0; e < E; e++)
+        {
+            alpha[e] = ValueType(0);
+
+            if (!progress.active[e])
+                continue;
+
+            if (r0v[e] == ValueType(0))
+                progress.retire(e);
+            else
+                alpha[e] = rho[e] / r0v[e];
+        }
+
+        // s <- r - alpha v
+        thrust::copy(R.values.begin(), R.values.end(), S.values.begin());
+
+        for (size_t e = 0; e < E; e++)
+            scale[e] = -alpha[e];
+
+        detail::ensemble_axpy(V, S, work, scale);
+
+        // s_hat <- M s, t <- A s_hat, omega <- <t,s> / <t,t>
+        detail::ensemble_precondition(D, jacobi, S, S_hat);
+        cusp::multiply(A, S_hat, T);
+        detail::ensemble_dot(T, S, work, ts);
+        detail::ensemble_dot(T, T, work, tt);
+
+        for (size_t e = 0; e < E; e++)
+        {
+            omega[e] = ValueType(0);
+
+            if (progress.active[e] && tt[e] != ValueType(0))
+                omega[e] = ts[e] / tt[e];
+        }
+
+        // x <- x + alpha p_hat + omega s_hat, r <- s - omega t
+        detail::ensemble_axpy(P_hat, X, work, alpha);
+        detail::ensemble_axpy(S_hat, X, work, omega);
+
+        thrust::copy(S.values.begin(), S.values.end(), R.values.begin());
+
+        for (size_t e = 0; e < E; e++)
+            scale[e] = -omega[e];
+
+        detail::ensemble_axpy(T, R, work, scale);
+
+        detail::ensemble_dot(R0, R, work, rho_new);
+        detail::ensemble_norms(R, work, r_norms);
+
+        // p <- r + beta (p - omega v)
+        for (size_t e = 0; e < E; e++)
+        {
+            beta[e] = ValueType(0);
+
+            if (!progress.active[e])
+                continue;
+
+            progress.iterations[e]++;
+
+            // a member without a stabilizing step cannot go on, unless
+            // its residual already vanishes
+            if (omega[e] == ValueType(0) || rho[e] == ValueType(0))
+            {
+                if (r_norms[e] > progress.tolerances[e])
+                {
+                    progress.residuals[e] = r_norms[e];
+                    progress.retire(e);
+                }
+                continue;
+            }
+
+            beta[e] = (rho_new[e] / rho[e]) * (alpha[e] / omega[e]);
+            rho[e] = rho_new[e];
+        }
+
+        detail::ensemble_axpy(V, P, work, scale);
+        detail::ensemble_xpby(R, P, work, beta);
+    }
+
+    progress.record(monitor);
+}
+
+} // end namespace krylov
+} // end namespace cusp
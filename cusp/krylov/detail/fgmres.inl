@@ -0,0 +1,161 @@
+/*
+ *  Copyright 2011 The Regents of the University of California
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include <cusp/blas.h>
+#include <cusp/multiply.h>
+#include <cusp/monitor.h>
+#include <cusp/linear_operator.h>
+
+#include <cusp/krylov/gmres.h>
+
+#include <thrust/copy.h>
+
+namespace cusp
+{
+  namespace krylov
+  {
+    template <class LinearOperator,
+	      class Vector,
+	      class Monitor>
+    void fgmres(LinearOperator& A,
+		Vector& x,
+		Vector& b,
+		const size_t restart,
+		Monitor& monitor)
+    {
+      typedef typename LinearOperator::value_type   ValueType;
+      typedef typename LinearOperator::memory_space MemorySpace;
+      cusp::identity_operator<ValueType,MemorySpace> M(A.num_rows, A.num_cols);
+      cusp::krylov::fgmres(A, x, b, restart, monitor, M);
+    }
+
+    template <class LinearOperator,
+	      class Vector,
+	      class Monitor,
+	      class Preconditioner>
+    void fgmres(LinearOperator& A,
+		Vector& x,
+		Vector& b,
+		const size_t restart,
+		Monitor& monitor,
+		Preconditioner& M)
+    {
+      typedef typename LinearOperator::value_type   ValueType;
+      typedef typename LinearOperator::memory_space MemorySpace;
+      cusp::krylov::workspace<ValueType,MemorySpace> workspace;
+      cusp::krylov::fgmres(A, x, b, restart, monitor, M, workspace);
+    }
+
+    template <class LinearOperator,
+	      class Vector,
+	      class Monitor,
+	      class Preconditioner,
+	      class Workspace>
+    void fgmres(LinearOperator& A,
+		Vector& x,
+		Vector& b,
+		const size_t restart,
+		Monitor& monitor,
+		Preconditioner& M,
+		Workspace& workspace)
+    {
+      typedef typename LinearOperator::value_type   ValueType;
+      typedef typename Workspace::vector_type       Array1d;
+      typedef typename Workspace::matrix_type       Array2d;
+      typedef typename norm_type<ValueType>::type NormType;
+      assert(A.num_rows == A.num_cols);        // sanity check
+      const size_t N = A.num_rows;
+      const int R = restart;
+      int i, j, k;
+      NormType beta = 0;
+      cusp::array1d<NormType,cusp::host_memory> resid(1);
+      //get workspace
+      Array1d& w  = workspace.vector(0, N);
+      Array1d& z  = workspace.vector(1, N);
+      Array2d& V  = workspace.matrix(0, N, R+1); //Arnoldi matrix
+      Array2d& Z  = workspace.matrix(1, N, R);   //preconditioned Arnoldi vectors
+      Array1d& sDev  = workspace.vector(2, R+1);
+      Array1d& hDev  = workspace.vector(3, R+1);
+      Array1d& h2Dev = workspace.vector(4, R+1);
+      //HOST WORKSPACE
+      cusp::array2d<ValueType,cusp::host_memory,cusp::column_major> H(R+1, R); //Hessenberg matrix
+      cusp::array1d<ValueType,cusp::host_memory> s(R+1);
+      cusp::array1d<ValueType,cusp::host_memory> cs(R);
+      cusp::array1d<ValueType,cusp::host_memory> sn(R);
+      do{
+	// compute initial residual and its norm //
+	cusp::multiply(A, x, w);                     // w = A*x            //
+	blas::axpby(b, w, w, ValueType(1), ValueType(-1)); // w = b - w   //
+	beta = blas::nrm2(w);                        // beta = norm(w)     //
+	s[0] = beta;
+	resid[0] = beta;
+	if (monitor.finished(resid)){
+	  break;
+	}
+	blas::scal(w, ValueType(1.0/beta));          // V(0) = w/beta      //
+	blas::copy(w,V.column(0));
+	//s = 0 //
+	blas::fill(s,ValueType(0.0));
+	s[0] = beta;
+	i = -1;
+
+	do{
+	  ++i;
+	  ++monitor;
+
+	  // Z(i) = M*V(i), the preconditioner may differ between calls //
+	  cusp::multiply(M,w,z);
+	  blas::copy(z,Z.column(i));
+	  // V(i+1) = A*Z(i) //
+	  cusp::multiply(A,z,w);
+
+	  // H(0:i,i) = V(0:i)^H V(i+1), V(i+1) -= V(0:i) H(0:i,i) //
+	  detail::classical_gram_schmidt2(V, i+1, w, hDev, h2Dev);
+	  thrust::copy(hDev.begin(), hDev.begin() + i + 1, H.values.begin() + i * H.pitch);
+
+	  H(i+1,i) = blas::nrm2(w);
+	  // V(i+1) = V(i+1) / H(i+1, i) //
+	  blas::scal(w,ValueType(1.0)/H(i+1,i));
+	  blas::copy(w,V.column(i+1));
+
+	  PlaneRotation(H,cs,sn,s,i);
+
+	  resid[0] = abs(s[i+1]);
+
+	  //check convergence condition
+	  if (monitor.finished(resid)){
+	    break;
+	  }
+	}while (i+1 < R && monitor.iteration_count()+1 <= monitor.iteration_limit());
+
+	// solve upper triangular system in place //
+	for (j = i; j >= 0; j--){
+	  s[j] /= H(j,j);
+	  //S(0:j) = s(0:j) - s[j] H(0:j,j)
+	  for (k = j-1; k >= 0; k--){
+	    s[k] -= H(k,j) * s[j];
+	  }
+	}
+
+	// update the solution from the preconditioned vectors //
+	// x = x + Z(0:N,0:i) s(0:i) = x - Z(0:N,0:i) (-s(0:i)) //
+	blas::scal(s, ValueType(-1));
+	blas::copy(s,sDev);
+	detail::gemv_subtract(Z, i+1, sDev, x);
+      } while (!monitor.finished(resid));
+    }
+  } // end namespace krylov
+} // end namespace cusp
@@ -0,0 +1,495 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include <cusp/array1d.h>
+#include <cusp/array2d.h>
+#include <cusp/blas.h>
+#include <cusp/multiply.h>
+#include <cusp/monitor.h>
+#include <cusp/linear_operator.h>
+
+#include <cusp/krylov/gmres.h>
+#include <cusp/krylov/s_step_gmres.h>
+#include <cusp/krylov/detail/block.h>
+#include <cusp/krylov/detail/ritz.h>
+#include <cusp/krylov/detail/s_step.h>
+
+#include <thrust/copy.h>
+#include <thrust/fill.h>
+
+#include <cmath>
+
+namespace blas = cusp::blas;
+
+namespace cusp
+{
+namespace krylov
+{
+namespace detail
+{
+
+// Harmonic Ritz vectors of a cycle.  With U~ = U D, D = diag(1 / ||U(:,i)||),
+// the cycle satisfies M A [U~, V(:,0:j)] = [C, V(:,0:j+1)] G with
+//
+//   G = [ D  B ]
+//       [ 0  H ]
+//
+// and the harmonic Ritz vectors are [U~, V(:,0:j)] P for the eigenvectors
+// P of (G^H G)^-1 G^H [C, V]^H [U~, V(:,0:j)] with the largest eigenvalues.
+// The new subspace is U = [U~, V] P R^-1 with C = [C, V] Q from G P = Q R,
+// so that M A U = C still holds.  Returns the dimension of the new subspace,
+// or 0 if the projected problem is singular.
+template <typename HostArray2d, typename HostArray1d>
+size_t gcro_dr_harmonic_ritz(const HostArray2d& H, const HostArray2d& B, const HostArray1d& u_norms,
+                             const HostArray2d& CU, const HostArray2d& VU,
+                             const size_t s, const size_t j, const size_t num_recycled,
+                             HostArray2d& U_from_U, HostArray2d& U_from_V,
+                             HostArray2d& C_from_C, HostArray2d& C_from_V)
+{
+    typedef typename HostArray2d::value_type ValueType;
+
+    cusp::blas::detail::conjugate<ValueType> conj;
+
+    const size_t n = s + j;
+
+    HostArray2d G(n + 1, n, ValueType(0));
+    HostArray2d VW(n + 1, n, ValueType(0));
+
+    for (size_t a = 0; a < s; a++)
+    {
+        G(a,a) = ValueType(1) / u_norms[a];
+
+        for (size_t c = 0; c < s; c++)
+            VW(c,a) = CU(c,a) / u_norms[a];
+        for (size_t r = 0; r <= j; r++)
+            VW(s + r,a) = VU(r,a) / u_norms[a];
+    }
+
+    for (size_t q = 0; q < j; q++)
+    {
+        for (size_t a = 0; a < s; a++)
+            G(a,s + q) = B(a,q);
+        for (size_t r = 0; r <= j; r++)
+            G(s + r,s + q) = H(r,q);
+
+        VW(s + q,s + q) = 1;
+    }
+
+    // S <- (G^H G)^-1 G^H VW
+    HostArray2d GG(n, n), S(n, n);
+
+    for (size_t b = 0; b < n; b++)
+        for (size_t a = 0; a < n; a++)
+        {
+            ValueType g = 0, v = 0;
+            for (size_t r = 0; r <= n; r++)
+            {
+                g += conj(G(r,a)) * G(r,b);
+                v += conj(G(r,a)) * VW(r,b);
+            }
+            GG(a,b) = g;
+            S(a,b)  = v;
+        }
+
+    if (!block_solve(GG, S))
+        return 0;
+
+    HostArray2d P;
+    const size_t k = ritz_select(S, num_recycled, P);
+
+    // G P = Q R by modified Gram-Schmidt applied twice
+    HostArray2d Q(n + 1, k, ValueType(0));
+    HostArray2d R(k, k, ValueType(0));
+
+    for (size_t c = 0; c < k; c++)
+    {
+        for (size_t r = 0; r <= n; r++)
+        {
+            ValueType g = 0;
+            for (size_t a = 0; a < n; a++)
+                g += G(r,a) * P(a,c);
+            Q(r,c) = g;
+        }
+
+        for (size_t pass = 0; pass < 2; pass++)
+            for (size_t a = 0; a < c; a++)
+            {
+                ValueType h = 0;
+                for (size_t r = 0; r <= n; r++)
+                    h += conj(Q(r,a)) * Q(r,c);
+                R(a,c) += h;
+                for (size_t r = 0; r <= n; r++)
+                    Q(r,c) -= h * Q(r,a);
+            }
+
+        typename norm_type<ValueType>::type norm = 0;
+        for (size_t r = 0; r <= n; r++)
+            norm += s_step_real(conj(Q(r,c)) * Q(r,c));
+        norm = std::sqrt(norm);
+
+        if (norm == 0)
+            return 0;
+
+        R(c,c) = norm;
+        for (size_t r = 0; r <= n; r++)
+            Q(r,c) /= norm;
+    }
+
+    HostArray2d Rinv;
+    s_step_triangular_inverse(R, k, Rinv);
+
+    U_from_U.resize(s, k);
+    U_from_V.resize(j, k);
+    C_from_C.resize(s, k);
+    C_from_V.resize(j + 1, k);
+
+    for (size_t c = 0; c < k; c++)
+    {
+        for (size_t a = 0; a < n; a++)
+        {
+            ValueType u = 0;
+            for (size_t q = 0; q <= c; q++)
+                u += P(a,q) * Rinv(q,c);
+
+            if (a < s)
+                U_from_U(a,c) = u / u_norms[a];
+            else
+                U_from_V(a - s,c) = u;
+        }
+
+        for (size_t a = 0; a < s; a++)
+            C_from_C(a,c) = Q(a,c);
+        for (size_t r = 0; r <= j; r++)
+            C_from_V(r,c) = Q(s + r,c);
+    }
+
+    return k;
+}
+
+} // end namespace detail
+
+template <typename ValueType, typename MemorySpace>
+gcro_dr<ValueType,MemorySpace>::gcro_dr(size_t restart, size_t num_recycled)
+    : restart(restart), max_recycled(num_recycled), num_recycled_(0)
+{}
+
+template <typename ValueType, typename MemorySpace>
+template <class LinearOperator,
+          class Vector>
+void gcro_dr<ValueType,MemorySpace>::solve(LinearOperator& A,
+                                           Vector& x,
+                                           Vector& b)
+{
+    cusp::default_monitor<ValueType> monitor(b);
+
+    solve(A, x, b, monitor);
+}
+
+template <typename ValueType, typename MemorySpace>
+template <class LinearOperator,
+          class Vector,
+          class Monitor>
+void gcro_dr<ValueType,MemorySpace>::solve(LinearOperator& A,
+                                           Vector& x,
+                                           Vector& b,
+                                           Monitor& monitor)
+{
+    cusp::identity_operator<ValueType,MemorySpace> M(A.num_rows, A.num_cols);
+
+    solve(A, x, b, monitor, M);
+}
+
+template <typename ValueType, typename MemorySpace>
+template <class LinearOperator,
+          class Vector,
+          class Monitor,
+          class Preconditioner>
+void gcro_dr<ValueType,MemorySpace>::solve(LinearOperator& A,
+                                           Vector& x,
+                                           Vector& b,
+                                           Monitor& monitor,
+                                           Preconditioner& M)
+{
+    CUSP_PROFILE_SCOPED();
+
+    typedef typename norm_type<ValueType>::type   NormType;
+    typedef typename cusp::krylov::workspace<ValueType,MemorySpace>::vector_type Array1d;
+    typedef typename detail::block_view<matrix_type>::type View;
+    typedef cusp::array2d<ValueType,cusp::host_memory,cusp::column_major> HostArray2d;
+    typedef cusp::array1d<ValueType,cusp::host_memory> HostArray1d;
+
+    assert(A.num_rows == A.num_cols);        // sanity check
+    assert(restart > max_recycled);
+
+    const size_t N = A.num_rows;
+    const size_t m = restart;
+    const size_t K = max_recycled;
+
+    // the subspace of a system of another size is useless
+    if (U.num_rows != N)
+        num_recycled_ = 0;
+
+    U.resize(N, K);
+
+    // get workspace
+    matrix_type& T     = workspace.matrix(0, N, 1);       // solution
+    matrix_type& V     = workspace.matrix(1, N, m + 1);   // Arnoldi basis
+    matrix_type& C     = workspace.matrix(2, N, K);       // C = M A U
+    matrix_type& U_new = workspace.matrix(3, N, K);
+    matrix_type& C_new = workspace.matrix(4, N, K);
+    Array1d& w        = workspace.vector(0, N);
+    Array1d& t        = workspace.vector(1, N);
+    Array1d& G_dev    = workspace.vector(2, (m + 1) * (m + 1));
+    Array1d& C_dev    = workspace.vector(3, K * K);
+    Array1d& Rinv_dev = workspace.vector(4, K * K);
+    Array1d& h_dev    = workspace.vector(5, m + 1);
+    Array1d& h2_dev   = workspace.vector(6, m + 1);
+
+    View xv = detail::block_columns(T, 0, 1);
+    typename matrix_type::column_view xc = T.column(0);
+
+    blas::copy(x, xc);
+
+    cusp::array1d<NormType,cusp::host_memory> resid(1);
+    HostArray2d C1, R1, C2, R2, R, Rinv;
+
+    size_t s = num_recycled_;
+
+    if (s > 0)
+    {
+        View Us = detail::block_columns(U, 0, s);
+        View Cs = detail::block_columns(C, 0, s);
+
+        // C <- M A U for the current matrix
+        cusp::multiply(A, Us, Cs);
+
+        for (size_t l = 0; l < s; l++)
+        {
+            cusp::multiply(M, C.column(l), t);
+            blas::copy(t, C.column(l));
+        }
+
+        // C R = M A U by Cholesky QR applied twice, U <- U R^-1
+        const size_t k1 = detail::s_step_orthogonalize(C, 0, s, G_dev, C_dev, Rinv_dev, C1, R1);
+        const size_t k2 = (k1 == s) ? detail::s_step_orthogonalize(C, 0, s, G_dev, C_dev, Rinv_dev, C2, R2) : 0;
+
+        if (k2 < s)
+        {
+            // U lost its rank, start over
+            s = 0;
+        }
+        else
+        {
+            R.resize(s, s);
+            thrust::fill(R.values.begin(), R.values.end(), ValueType(0));
+
+            for (size_t c = 0; c < s; c++)
+                for (size_t r = 0; r <= c; r++)
+                {
+                    ValueType v = 0;
+                    for (size_t q = r; q <= c; q++)
+                        v += R2(r,q) * R1(q,c);
+                    R(r,c) = v;
+                }
+
+            detail::s_step_triangular_inverse(R, s, Rinv);
+            detail::block_copy_to_device(Rinv, Rinv_dev);
+
+            View Un = detail::block_columns(U_new, 0, s);
+            detail::block_multiply(Us, Rinv_dev, Un, false);
+            U.swap(U_new);
+        }
+    }
+
+    // w <- M (b - A*x)
+    cusp::multiply(A, xc, t);
+    blas::axpby(b, t, t, ValueType(1), ValueType(-1));
+    cusp::multiply(M, t, w);
+
+    while (true)
+    {
+        // x <- x + U C^H r, r <- r - C C^H r
+        if (s > 0)
+        {
+            View Us = detail::block_columns(U, 0, s);
+
+            detail::gemv_conjugate_transpose(C, s, w, h_dev);
+            detail::gemv_subtract(C, s, h_dev, w);
+            detail::block_multiply(Us, h_dev, xv, true);
+        }
+
+        resid[0] = blas::nrm2(w);
+
+        if (monitor.finished(resid))
+            break;
+
+        // Arnoldi with (I - C C^H) M A, the recycled vectors take s
+        // dimensions of the search space
+        const size_t mm = m - s;
+
+        blas::copy(w, V.column(0));
+        blas::scal(V.column(0), ValueType(1) / resid[0]);
+
+        HostArray2d H(mm + 1, mm, ValueType(0));    // Hessenberg matrix
+        HostArray2d Hr(mm + 1, mm, ValueType(0));   // its rotated copy
+        HostArray2d B(s, mm, ValueType(0));         // B = C^H M A V
+        HostArray1d g(mm + 1, ValueType(0));
+        HostArray1d cs(mm);
+        HostArray1d sn(mm);
+
+        g[0] = resid[0];
+
+        size_t j = 0;
+
+        while (j < mm)
+        {
+            // w <- M A V(:,j)
+            cusp::multiply(A, V.column(j), t);
+            cusp::multiply(M, t, w);
+
+            // B(:,j) = C^H w, w -= C B(:,j)
+            if (s > 0)
+            {
+                detail::classical_gram_schmidt2(C, s, w, h_dev, h2_dev);
+                thrust::copy(h_dev.begin(), h_dev.begin() + s, B.values.begin() + j * B.pitch);
+            }
+
+            // H(0:j,j) = V(:,0:j)^H w, w -= V(:,0:j) H(0:j,j)
+            detail::classical_gram_schmidt2(V, j + 1, w, h_dev, h2_dev);
+            thrust::copy(h_dev.begin(), h_dev.begin() + j + 1, H.values.begin() + j * H.pitch);
+
+            H(j + 1,j) = blas::nrm2(w);
+
+            // on breakdown the zero vector keeps the relations intact
+            if (H(j + 1,j) != ValueType(0))
+                blas::scal(w, ValueType(1) / H(j + 1,j));
+            blas::copy(w, V.column(j + 1));
+
+            for (size_t r = 0; r <= j + 1; r++)
+                Hr(r,j) = H(r,j);
+
+            PlaneRotation(Hr, cs, sn, g, int(j));
+
+            ++monitor;
+            ++j;
+
+            using std::abs;
+            resid[0] = abs(g[j]);
+
+            if (monitor.finished(resid) || H(j,j - 1) == ValueType(0))
+                break;
+        }
+
+        // solve upper triangular system in place
+        for (size_t c = j; c-- > 0; )
+        {
+            g[c] /= Hr(c,c);
+            for (size_t r = 0; r < c; r++)
+                g[r] -= Hr(r,c) * g[c];
+        }
+
+        // x <- x + V(:,0:j) y - U B y
+        {
+            View Vj = detail::block_columns(V, 0, j);
+
+            thrust::copy(g.begin(), g.begin() + j, h_dev.begin());
+            detail::block_multiply(Vj, h_dev, xv, true);
+        }
+
+        if (s > 0)
+        {
+            View Us = detail::block_columns(U, 0, s);
+
+            HostArray1d By(s, ValueType(0));
+            for (size_t a = 0; a < s; a++)
+                for (size_t q = 0; q < j; q++)
+                    By[a] -= B(a,q) * g[q];
+
+            thrust::copy(By.begin(), By.end(), h_dev.begin());
+            detail::block_multiply(Us, h_dev, xv, true);
+        }
+
+        // replace U and C by the harmonic Ritz vectors of the cycle
+        {
+            View Us  = detail::block_columns(U, 0, s);
+            View Cs  = detail::block_columns(C, 0, s);
+            View Vj  = detail::block_columns(V, 0, j);
+            View Vj1 = detail::block_columns(V, 0, j + 1);
+
+            HostArray2d CU(s, s), VU(j + 1, s);
+            HostArray1d u_norms(s);
+
+            if (s > 0)
+            {
+                detail::block_column_inner_products(Us, Us, G_dev);
+                thrust::copy(G_dev.begin(), G_dev.begin() + s, u_norms.begin());
+                for (size_t a = 0; a < s; a++)
+                    u_norms[a] = NormType(std::sqrt(detail::s_step_real(u_norms[a])));
+
+                detail::block_inner_products(Cs, Us, G_dev);
+                detail::block_copy_to_host(G_dev, CU);
+
+                detail::block_inner_products(Vj1, Us, G_dev);
+                detail::block_copy_to_host(G_dev, VU);
+            }
+
+            HostArray2d U_from_U, U_from_V, C_from_C, C_from_V;
+
+            const size_t k = detail::gcro_dr_harmonic_ritz(H, B, u_norms, CU, VU, s, j, K,
+                                                           U_from_U, U_from_V, C_from_C, C_from_V);
+
+            // otherwise U and C stay valid for the next cycle
+            if (k > 0)
+            {
+                View Un = detail::block_columns(U_new, 0, k);
+                View Cn = detail::block_columns(C_new, 0, k);
+
+                detail::block_copy_to_device(U_from_V, G_dev);
+                detail::block_multiply(Vj, G_dev, Un, false);
+
+                detail::block_copy_to_device(C_from_V, G_dev);
+                detail::block_multiply(Vj1, G_dev, Cn, false);
+
+                if (s > 0)
+                {
+                    detail::block_copy_to_device(U_from_U, G_dev);
+                    detail::block_multiply(Us, G_dev, Un, true);
+
+                    detail::block_copy_to_device(C_from_C, G_dev);
+                    detail::block_multiply(Cs, G_dev, Cn, true);
+                }
+
+                U.swap(U_new);
+                C.swap(C_new);
+
+                s = k;
+            }
+        }
+
+        // w <- M (b - A*x)
+        cusp::multiply(A, xc, t);
+        blas::axpby(b, t, t, ValueType(1), ValueType(-1));
+        cusp::multiply(M, t, w);
+    }
+
+    blas::copy(xc, x);
+
+    num_recycled_ = s;
+}
+
+} // end namespace krylov
+} // end namespace cusp
+
@@ -19,11 +19,122 @@
 #include <cusp/monitor.h>
 #include <cusp/linear_operator.h>
 
+#include <thrust/copy.h>
+#include <thrust/reduce.h>
+#include <thrust/transform.h>
+#include <thrust/iterator/counting_iterator.h>
+#include <thrust/iterator/discard_iterator.h>
+#include <thrust/iterator/transform_iterator.h>
+
 namespace blas = cusp::blas;
 namespace cusp
 {
   namespace krylov
   {    
+    namespace detail
+    {
+      // column of element idx of the leading N x m block of V
+      struct gmres_column_index
+      {
+	size_t N;
+
+	gmres_column_index(size_t N) : N(N) {}
+
+	__host__ __device__
+	size_t operator()(size_t idx) const { return idx / N; }
+      };
+
+      // conj(V(i,k)) * w[i] for element idx = k * N + i
+      template <typename ValueType>
+      struct gmres_conjugate_product
+      {
+	const ValueType * V;
+	const ValueType * w;
+	size_t N;
+	size_t pitch;
+
+	gmres_conjugate_product(const ValueType * V, const ValueType * w, size_t N, size_t pitch)
+	  : V(V), w(w), N(N), pitch(pitch) {}
+
+	__host__ __device__
+	ValueType operator()(size_t idx) const
+	{
+	  cusp::blas::detail::conjugate<ValueType> conj;
+	  const size_t k = idx / N;
+	  const size_t i = idx - k * N;
+	  return conj(V[k * pitch + i]) * w[i];
+	}
+      };
+
+      // w[i] - sum_k V(i,k) * h[k] over the first m columns
+      template <typename ValueType>
+      struct gmres_subtract_projection
+      {
+	const ValueType * V;
+	const ValueType * h;
+	size_t m;
+	size_t pitch;
+
+	gmres_subtract_projection(const ValueType * V, const ValueType * h, size_t m, size_t pitch)
+	  : V(V), h(h), m(m), pitch(pitch) {}
+
+	__host__ __device__
+	ValueType operator()(size_t i, ValueType wi) const
+	{
+	  for (size_t k = 0; k < m; k++)
+	    wi -= V[k * pitch + i] * h[k];
+	  return wi;
+	}
+      };
+
+      // h(0:m) = V(:,0:m)^H w, one reduction over the leading m columns
+      template <typename Array2d, typename Array1, typename Array2>
+      void gemv_conjugate_transpose(const Array2d& V, const size_t m, const Array1& w, Array2& h)
+      {
+	typedef typename Array2d::value_type ValueType;
+
+	const size_t N = V.num_rows;
+
+	thrust::reduce_by_key
+	  (thrust::make_transform_iterator(thrust::counting_iterator<size_t>(0), gmres_column_index(N)),
+	   thrust::make_transform_iterator(thrust::counting_iterator<size_t>(N * m), gmres_column_index(N)),
+	   thrust::make_transform_iterator(thrust::counting_iterator<size_t>(0),
+					   gmres_conjugate_product<ValueType>(thrust::raw_pointer_cast(&V.values[0]),
+									      thrust::raw_pointer_cast(&w[0]), N, V.pitch)),
+	   thrust::make_discard_iterator(),
+	   h.begin());
+      }
+
+      // w = w - V(:,0:m) h(0:m), one pass over the leading m columns
+      template <typename Array2d, typename Array1, typename Array2>
+      void gemv_subtract(const Array2d& V, const size_t m, const Array1& h, Array2& w)
+      {
+	typedef typename Array2d::value_type ValueType;
+
+	thrust::transform(thrust::counting_iterator<size_t>(0), thrust::counting_iterator<size_t>(V.num_rows),
+			  w.begin(), w.begin(),
+			  gmres_subtract_projection<ValueType>(thrust::raw_pointer_cast(&V.values[0]),
+							       thrust::raw_pointer_cast(&h[0]), m, V.pitch));
+      }
+
+      // classical Gram-Schmidt with one reorthogonalization (CGS2): w is
+      // orthogonalized against the first m columns of V with two passes
+      // of two GEMVs each and h(0:m) receives the projection coefficients
+      template <typename Array2d, typename Array1, typename Array2>
+      void classical_gram_schmidt2(const Array2d& V, const size_t m, Array1& w, Array2& h, Array2& h2)
+      {
+	typedef typename Array2d::value_type ValueType;
+
+	gemv_conjugate_transpose(V, m, w, h);
+	gemv_subtract(V, m, h, w);
+
+	gemv_conjugate_transpose(V, m, w, h2);
+	gemv_subtract(V, m, h2, w);
+
+	thrust::transform(h.begin(), h.begin() + m, h2.begin(), h.begin(), thrust::plus<ValueType>());
+      }
+    } // end namespace detail
+
     template <typename ValueType> 
     void ApplyPlaneRotation(ValueType& dx,
 			    ValueType& dy,
@@ -110,6 +221,27 @@ namespace cusp
     {
       typedef typename LinearOperator::value_type   ValueType;
       typedef typename LinearOperator::memory_space MemorySpace;
+      cusp::krylov::workspace<ValueType,MemorySpace> workspace;
+      cusp::krylov::gmres(A, x, b, restart, monitor, M, workspace);
+    }
+
+    template <class LinearOperator,
+	      class Vector,
+	      class Monitor,
+	      class Preconditioner,
+	      class Workspace>
+    void gmres(LinearOperator& A,
+	       Vector& x,
+	       Vector& b,
+	       const size_t restart,
+	       Monitor& monitor,
+	       Preconditioner& M,
+	       Workspace& workspace,
+	       const gmres_orthogonalization orthogonalization)
+    {
+      typedef typename LinearOperator::value_type   ValueType;
+      typedef typename Workspace::vector_type       Array1d;
+      typedef typename Workspace::matrix_type       Array2d;
       typedef typename norm_type<ValueType>::type NormType;
       assert(A.num_rows == A.num_cols);        // sanity check
       const size_t N = A.num_rows;
@@ -117,12 +249,15 @@ namespace cusp
       int i, j, k;
       NormType beta = 0;
       cusp::array1d<NormType,cusp::host_memory> resid(1);
-      //allocate workspace
-      cusp::array1d<ValueType,MemorySpace> w(N);
-      cusp::array1d<ValueType,MemorySpace> V0(N); //Arnoldi matrix pos 0
-      cusp::array2d<ValueType,MemorySpace,cusp::column_major> V(N,R+1,ValueType(0.0)); //Arnoldi matrix
+      //get workspace
+      Array1d& w  = workspace.vector(0, N);
+      Array1d& V0 = workspace.vector(1, N); //Arnoldi matrix pos 0
+      Array2d& V  = workspace.matrix(0, N, R+1); //Arnoldi matrix
       //duplicate copy of s on GPU
-      cusp::array1d<ValueType,MemorySpace> sDev(R+1);
+      Array1d& sDev = workspace.vector(2, R+1);
+      //column of H computed on the GPU by CGS2
+      Array1d& hDev  = workspace.vector(3, R+1);
+      Array1d& h2Dev = workspace.vector(4, R+1);
       //HOST WORKSPACE
       cusp::array2d<ValueType,cusp::host_memory,cusp::column_major> H(R+1, R); //Hessenberg matrix
       cusp::array1d<ValueType,cusp::host_memory> s(R+1);
@@ -130,11 +265,10 @@ namespace cusp
       cusp::array1d<ValueType,cusp::host_memory> sn(R);
       do{
 	// compute initial residual and its norm //
-	cusp::multiply(A, x, w);                     // V(0) = A*x        //
-	blas::axpy(b,w,ValueType(-1));               // V(0) = V(0) - b   //
+	cusp::detail::residual(A, x, b, w);          // V(0) = b - A*x    //
 	cusp::multiply(M,w,w);                       // V(0) = M*V(0)     //
 	beta = blas::nrm2(w);                        // beta = norm(V(0)) //
-	blas::scal(w, ValueType(-1.0/beta));         // V(0) = -V(0)/beta //
+	blas::scal(w, ValueType(1.0/beta));          // V(0) = V(0)/beta  //
 	blas::copy(w,V.column(0));
 	//s = 0 //
 	blas::fill(s,ValueType(0.0));
@@ -155,11 +289,17 @@ namespace cusp
 	  //V(i+1) = A*w = M*A*V(i)    //
 	  cusp::multiply(M,V0,w);
 	  
-	  for (k = 0; k <= i; k++){
-	    //  H(k,i) = <V(i+1),V(k)>    //
-	    H(k, i) = blas::dotc(w, V.column(k));
-	    // V(i+1) -= H(k, i) * V(k)  //
-	    blas::axpy(V.column(k),w,-H(k,i));
+	  if (orthogonalization == CLASSICAL_GRAM_SCHMIDT_2){
+	    // H(0:i,i) = V(0:i)^H V(i+1), V(i+1) -= V(0:i) H(0:i,i) //
+	    detail::classical_gram_schmidt2(V, i+1, w, hDev, h2Dev);
+	    thrust::copy(hDev.begin(), hDev.begin() + i + 1, H.values.begin() + i * H.pitch);
+	  }else{
+	    for (k = 0; k <= i; k++){
+	      //  H(k,i) = <V(i+1),V(k)>    //
+	      H(k, i) = blas::dotc(w, V.column(k));
+	      // V(i+1) -= H(k, i) * V(k)  //
+	      blas::axpy(V.column(k),w,-H(k,i));
+	    }
 	  }
 	  
 	  H(i+1,i) = blas::nrm2(w);   
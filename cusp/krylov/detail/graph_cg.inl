@@ -0,0 +1,292 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+#include <cusp/array1d.h>
+#include <cusp/blas.h>
+#include <cusp/multiply.h>
+#include <cusp/monitor.h>
+#include <cusp/linear_operator.h>
+#include <cusp/stream.h>
+#include <cusp/detail/stream.h>
+#include <cusp/detail/device/graph.h>
+
+#include <cusp/krylov/cg.h>
+#include <cusp/krylov/detail/device/graph_cg.h>
+
+#include <thrust/tuple.h>
+#include <thrust/iterator/zip_iterator.h>
+
+#include <cmath>
+
+namespace blas = cusp::blas;
+
+namespace cusp
+{
+namespace krylov
+{
+namespace detail
+{
+
+// (p, y, x, r) -> x += alpha * p, r -= alpha * y with alpha in device memory
+template <typename ValueType>
+struct graph_cg_update_functor
+{
+    const ValueType * alpha;
+
+    graph_cg_update_functor(const ValueType * alpha) : alpha(alpha) {}
+
+    template <typename Tuple>
+    __host__ __device__
+    void operator()(Tuple t) const
+    {
+        const ValueType a = *alpha;
+
+        thrust::get<2>(t) = thrust::get<2>(t) + a * thrust::get<0>(t);
+        thrust::get<3>(t) = thrust::get<3>(t) - a * thrust::get<1>(t);
+    }
+};
+
+// (z, p) -> p = z + beta * p with beta in device memory
+template <typename ValueType>
+struct graph_cg_direction_functor
+{
+    const ValueType * beta;
+
+    graph_cg_direction_functor(const ValueType * beta) : beta(beta) {}
+
+    template <typename Tuple>
+    __host__ __device__
+    void operator()(Tuple t) const
+    {
+        thrust::get<1>(t) = thrust::get<0>(t) + *beta * thrust::get<1>(t);
+    }
+};
+
+template <typename Monitor, typename Vector, typename NormType>
+bool graph_cg_finished(Monitor& monitor, const Vector& r, const NormType, thrust::detail::false_type)
+{
+    return monitor.finished(r);
+}
+
+template <typename Monitor, typename Vector, typename NormType>
+bool graph_cg_finished(Monitor& monitor, const Vector&, const NormType r_norm, thrust::detail::true_type)
+{
+    return monitor.finished(r_norm);
+}
+
+// one preconditioned iteration without host synchronization
+template <class LinearOperator, class Preconditioner, class Vector, class Array, class Scalars>
+void graph_cg_iteration(LinearOperator& A, Preconditioner& M, Vector& x,
+                        Array& r, Array& z, Array& p, Array& y, Scalars& scalars)
+{
+    typedef typename LinearOperator::value_type ValueType;
+
+    const size_t N = r.size();
+
+    // y <- Ap
+    cusp::multiply(A, p, y);
+
+    // alpha <- <r,z>/<p,y>
+    scalars.dots(p, y, Scalars::ALPHA);
+
+    // x <- x + alpha * p, r <- r - alpha * y
+    cusp::detail::stream::for_each
+        (thrust::make_zip_iterator(thrust::make_tuple(p.begin(), y.begin(), x.begin(), r.begin())),
+         thrust::make_zip_iterator(thrust::make_tuple(p.begin(), y.begin(), x.begin(), r.begin())) + N,
+         graph_cg_update_functor<ValueType>(scalars.alpha()));
+
+    // z <- M*r
+    cusp::multiply(M, r, z);
+
+    // beta <- <r_{i+1},z_{i+1}>/<r,z>, rr <- <r^H,r>
+    scalars.dots(r, z, Scalars::BETA);
+
+    // p <- z + beta*p
+    cusp::detail::stream::for_each
+        (thrust::make_zip_iterator(thrust::make_tuple(z.begin(), p.begin())),
+         thrust::make_zip_iterator(thrust::make_tuple(z.begin(), p.begin())) + N,
+         graph_cg_direction_functor<ValueType>(scalars.beta()));
+
+    scalars.fetch_residual();
+}
+
+// the reductions of cg for host memory already stay on the host
+template <class LinearOperator,
+          class Vector,
+          class Monitor,
+          class Preconditioner,
+          class Workspace>
+void graph_cg(LinearOperator& A,
+              Vector& x,
+              Vector& b,
+              Monitor& monitor,
+              Preconditioner& M,
+              Workspace& workspace,
+              cusp::host_memory)
+{
+    cusp::krylov::cg(A, x, b, monitor, M, workspace);
+}
+
+template <class LinearOperator,
+          class Vector,
+          class Monitor,
+          class Preconditioner,
+          class Workspace>
+void graph_cg(LinearOperator& A,
+              Vector& x,
+              Vector& b,
+              Monitor& monitor,
+              Preconditioner& M,
+              Workspace& workspace,
+              cusp::device_memory)
+{
+    typedef typename LinearOperator::value_type   ValueType;
+    typedef typename norm_type<ValueType>::type   NormType;
+    typedef typename Workspace::vector_type       Array;
+    typedef cusp::krylov::detail::device::graph_cg_scalars<ValueType> Scalars;
+
+    assert(A.num_rows == A.num_cols);        // sanity check
+
+    const size_t N = A.num_rows;
+
+    // get workspace
+    Array& y = workspace.vector(0, N);
+    Array& z = workspace.vector(1, N);
+    Array& r = workspace.vector(2, N);
+    Array& p = workspace.vector(3, N);
+
+    Scalars scalars(N);
+
+    // r <- b - A*x
+    cusp::multiply(A, x, r);
+    blas::axpby(b, r, r, ValueType(1), ValueType(-1));
+
+    // z <- M*r
+    cusp::multiply(M, r, z);
+
+    // p <- z
+    blas::copy(z, p);
+
+    // rz <- <r^H,z>, rr <- <r^H,r>
+    scalars.dots(r, z, Scalars::INITIAL);
+    scalars.fetch_residual();
+
+    cudaStream_t stream = cusp::current_stream();
+
+    // an enclosing capture records the iterations directly
+    const bool capture = N > 0 && cusp::detail::device::captured_graph::supported() &&
+                         !cusp::detail::device::is_capturing(stream);
+
+    cusp::detail::device::captured_graph graph;
+
+    for (size_t i = 0; ; i++)
+    {
+        if (graph_cg_finished(monitor, r, NormType(std::sqrt(abs(scalars.residual()))),
+                              typename cusp::detail::accepts_residual_norm<Monitor>::type()))
+            break;
+
+        // the first iteration runs normally, the second one is captured
+        if (i == 1 && capture && graph.begin_capture())
+        {
+            {
+                cusp::stream_scope scope(graph.stream());
+                graph_cg_iteration(A, M, x, r, z, p, y, scalars);
+            }
+
+            // nothing was executed while capturing
+            graph.end_capture();
+        }
+
+        if (graph.empty())
+            graph_cg_iteration(A, M, x, r, z, p, y, scalars);
+        else
+            graph.launch(stream);
+
+        ++monitor;
+    }
+}
+
+} // end namespace detail
+
+template <class LinearOperator,
+          class Vector>
+void graph_cg(LinearOperator& A,
+              Vector& x,
+              Vector& b)
+{
+    typedef typename LinearOperator::value_type   ValueType;
+
+    cusp::default_monitor<ValueType> monitor(b);
+
+    cusp::krylov::graph_cg(A, x, b, monitor);
+}
+
+template <class LinearOperator,
+          class Vector,
+          class Monitor>
+void graph_cg(LinearOperator& A,
+              Vector& x,
+              Vector& b,
+              Monitor& monitor)
+{
+    typedef typename LinearOperator::value_type   ValueType;
+    typedef typename LinearOperator::memory_space MemorySpace;
+
+    cusp::identity_operator<ValueType,MemorySpace> M(A.num_rows, A.num_cols);
+
+    cusp::krylov::graph_cg(A, x, b, monitor, M);
+}
+
+template <class LinearOperator,
+          class Vector,
+          class Monitor,
+          class Preconditioner>
+void graph_cg(LinearOperator& A,
+              Vector& x,
+              Vector& b,
+              Monitor& monitor,
+              Preconditioner& M)
+{
+    typedef typename LinearOperator::value_type   ValueType;
+    typedef typename LinearOperator::memory_space MemorySpace;
+
+    cusp::krylov::workspace<ValueType,MemorySpace> workspace;
+
+    cusp::krylov::graph_cg(A, x, b, monitor, M, workspace);
+}
+
+template <class LinearOperator,
+          class Vector,
+          class Monitor,
+          class Preconditioner,
+          class Workspace>
+void graph_cg(LinearOperator& A,
+              Vector& x,
+              Vector& b,
+              Monitor& monitor,
+              Preconditioner& M,
+              Workspace& workspace)
+{
+    CUSP_PROFILE_SCOPED();
+
+    typedef typename LinearOperator::memory_space MemorySpace;
+
+    cusp::krylov::detail::graph_cg(A, x, b, monitor, M, workspace, MemorySpace());
+}
+
+} // end namespace krylov
+} // end namespace cusp
@@ -0,0 +1,145 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+#include <cusp/array1d.h>
+#include <cusp/blas.h>
+#include <cusp/multiply.h>
+#include <cusp/linear_operator.h>
+
+#include <cusp/krylov/cg.h>
+#include <cusp/krylov/gmres.h>
+
+namespace blas = cusp::blas;
+
+namespace cusp
+{
+namespace krylov
+{
+
+template <typename ValueType, typename MemorySpace>
+template <typename LinearOperator, typename Vector, typename Preconditioner>
+void refinement_cg<ValueType,MemorySpace>
+::operator()(LinearOperator& A, Vector& x, Vector& b, Preconditioner& M)
+{
+    cusp::default_monitor<ValueType> monitor(b, iteration_limit, relative_tolerance);
+    cusp::krylov::cg(A, x, b, monitor, M, workspace);
+}
+
+template <typename ValueType, typename MemorySpace>
+template <typename LinearOperator, typename Vector, typename Preconditioner>
+void refinement_gmres<ValueType,MemorySpace>
+::operator()(LinearOperator& A, Vector& x, Vector& b, Preconditioner& M)
+{
+    cusp::default_monitor<ValueType> monitor(b, iteration_limit, relative_tolerance);
+    cusp::krylov::gmres(A, x, b, restart, monitor, M, workspace);
+}
+
+template <class LinearOperator,
+          class LowPrecisionOperator,
+          class Vector,
+          class Monitor>
+void iterative_refinement(LinearOperator& A,
+                          LowPrecisionOperator& A_low,
+                          Vector& x,
+                          Vector& b,
+                          Monitor& monitor)
+{
+    typedef typename LowPrecisionOperator::value_type   LowValueType;
+    typedef typename LowPrecisionOperator::memory_space LowMemorySpace;
+
+    cusp::krylov::refinement_cg<LowValueType,LowMemorySpace> inner;
+
+    cusp::krylov::iterative_refinement(A, A_low, x, b, monitor, inner);
+}
+
+template <class LinearOperator,
+          class LowPrecisionOperator,
+          class Vector,
+          class Monitor,
+          class InnerSolver>
+void iterative_refinement(LinearOperator& A,
+                          LowPrecisionOperator& A_low,
+                          Vector& x,
+                          Vector& b,
+                          Monitor& monitor,
+                          InnerSolver& inner)
+{
+    typedef typename LowPrecisionOperator::value_type   LowValueType;
+    typedef typename LowPrecisionOperator::memory_space LowMemorySpace;
+
+    cusp::identity_operator<LowValueType,LowMemorySpace> M(A_low.num_rows, A_low.num_cols);
+
+    cusp::krylov::iterative_refinement(A, A_low, x, b, monitor, inner, M);
+}
+
+template <class LinearOperator,
+          class LowPrecisionOperator,
+          class Vector,
+          class Monitor,
+          class InnerSolver,
+          class Preconditioner>
+void iterative_refinement(LinearOperator& A,
+                          LowPrecisionOperator& A_low,
+                          Vector& x,
+                          Vector& b,
+                          Monitor& monitor,
+                          InnerSolver& inner,
+                          Preconditioner& M)
+{
+    CUSP_PROFILE_SCOPED();
+
+    typedef typename LinearOperator::value_type         ValueType;
+    typedef typename LinearOperator::memory_space       MemorySpace;
+    typedef typename LowPrecisionOperator::value_type   LowValueType;
+    typedef typename LowPrecisionOperator::memory_space LowMemorySpace;
+
+    assert(A.num_rows == A.num_cols);        // sanity check
+    assert(A.num_rows == A_low.num_rows && A.num_cols == A_low.num_cols);
+
+    const size_t N = A.num_rows;
+
+    cusp::array1d<ValueType,MemorySpace> r(N);
+    cusp::array1d<ValueType,MemorySpace> d(N);
+
+    cusp::array1d<LowValueType,LowMemorySpace> r_low(N);
+    cusp::array1d<LowValueType,LowMemorySpace> d_low(N);
+
+    // r <- b - A*x in high precision
+    cusp::multiply(A, x, r);
+    blas::axpby(b, r, r, ValueType(1), ValueType(-1));
+
+    while (!monitor.finished(r))
+    {
+        // solve A_low * d = r in low precision
+        r_low = r;
+        blas::fill(d_low, LowValueType(0));
+        inner(A_low, d_low, r_low, M);
+        d = d_low;
+
+        // x <- x + d
+        blas::axpy(d, x, ValueType(1));
+
+        // r <- b - A*x
+        cusp::multiply(A, x, r);
+        blas::axpby(b, r, r, ValueType(1), ValueType(-1));
+
+        ++monitor;
+    }
+}
+
+} // end namespace krylov
+} // end namespace cusp
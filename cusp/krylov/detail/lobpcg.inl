@@ -0,0 +1,295 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include <cusp/array1d.h>
+#include <cusp/array2d.h>
+#include <cusp/blas.h>
+#include <cusp/exception.h>
+#include <cusp/linear_operator.h>
+#include <cusp/multiply.h>
+
+#include <cusp/krylov/workspace.h>
+#include <cusp/krylov/detail/block.h>
+#include <cusp/krylov/detail/ritz.h>
+#include <cusp/krylov/detail/s_step.h>
+
+#include <thrust/sequence.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace blas = cusp::blas;
+
+namespace cusp
+{
+namespace krylov
+{
+namespace detail
+{
+
+// orders the Ritz values increasingly
+struct lobpcg_order
+{
+    const cusp::array1d<double,cusp::host_memory>& theta;
+
+    lobpcg_order(const cusp::array1d<double,cusp::host_memory>& theta)
+        : theta(theta) {}
+
+    bool operator()(const size_t a, const size_t b) const
+    {
+        return theta[a] < theta[b];
+    }
+};
+
+} // end namespace detail
+
+template <class LinearOperator,
+          class Array1d,
+          class Array2d>
+size_t lobpcg(LinearOperator& A,
+              Array1d& eigenvalues,
+              Array2d& X,
+              const size_t k,
+              const double tolerance,
+              const size_t maxiter)
+{
+    typedef typename LinearOperator::value_type   ValueType;
+    typedef typename LinearOperator::memory_space MemorySpace;
+
+    cusp::identity_operator<ValueType,MemorySpace> M(A.num_rows, A.num_cols);
+
+    return cusp::krylov::lobpcg(A, eigenvalues, X, k, tolerance, maxiter, M);
+}
+
+template <class LinearOperator,
+          class Array1d,
+          class Array2d,
+          class Preconditioner>
+size_t lobpcg(LinearOperator& A,
+              Array1d& eigenvalues,
+              Array2d& X,
+              const size_t k,
+              const double tolerance,
+              const size_t maxiter,
+              Preconditioner& M)
+{
+    CUSP_PROFILE_SCOPED();
+
+    typedef typename LinearOperator::value_type                   ValueType;
+    typedef typename LinearOperator::memory_space                 MemorySpace;
+    typedef cusp::krylov::workspace<ValueType,MemorySpace>        Workspace;
+    typedef typename Workspace::vector_type                       WorkArray1d;
+    typedef typename Workspace::matrix_type                       WorkArray2d;
+    typedef typename detail::block_view<WorkArray2d>::type        View;
+    typedef cusp::array2d<ValueType,cusp::host_memory,cusp::column_major> HostArray2d;
+
+    if (A.num_rows != A.num_cols)
+        throw cusp::invalid_input_exception("lobpcg requires a square operator");
+
+    const size_t N = A.num_rows;
+
+    if (k == 0 || k > N)
+        throw cusp::invalid_input_exception("number of eigenpairs must be between one and the dimension of the operator");
+
+    Workspace workspace;
+
+    // the basis [X W P] and its product with A, X first
+    WorkArray2d& S  = workspace.matrix(0, N, 3 * k);
+    WorkArray2d& AS = workspace.matrix(1, N, 3 * k);
+    WorkArray2d& T  = workspace.matrix(2, N, 2 * k);   // new X and P
+    WorkArray2d& AT = workspace.matrix(3, N, 2 * k);
+    WorkArray2d& Q  = workspace.matrix(4, N, k);       // residuals
+    WorkArray1d& G_dev    = workspace.vector(0, 9 * k * k);
+    WorkArray1d& C_dev    = workspace.vector(1, 2 * k * k);
+    WorkArray1d& Rinv_dev = workspace.vector(2, k * k);
+    WorkArray1d& Y_dev    = workspace.vector(3, 3 * k * k);
+    WorkArray1d& d_dev    = workspace.vector(4, k);
+
+    HostArray2d C1, R1, C2, R2;
+
+    detail::ritz_matrix G, Y;
+    cusp::array1d<double,cusp::host_memory> theta;
+    cusp::array1d<size_t,cusp::host_memory> order;
+    detail::ritz_demote<ValueType> demote;
+
+    // orthonormal initial block
+    for (size_t j = 0; j < k; j++)
+    {
+        if (X.num_rows == N && X.num_cols == k)
+            blas::copy(X.column(j), S.column(j));
+        else
+            detail::block_random_column(S, j);
+    }
+
+    const size_t k1 = detail::s_step_orthogonalize(S, 0, k, G_dev, C_dev, Rinv_dev, C1, R1);
+    const size_t k2 = (k1 == k) ? detail::s_step_orthogonalize(S, 0, k, G_dev, C_dev, Rinv_dev, C2, R2) : 0;
+
+    if (k2 < k)
+        throw cusp::invalid_input_exception("lobpcg requires linearly independent initial vectors");
+
+    for (size_t j = 0; j < k; j++)
+    {
+        typename WorkArray2d::column_view s  = S.column(j);
+        typename WorkArray2d::column_view As = AS.column(j);
+        cusp::multiply(A, s, As);
+    }
+
+    size_t kw = 0;          // columns of W
+    size_t kp = 0;          // columns of P
+    size_t converged = 0;
+
+    for (size_t iteration = 0; ; iteration++)
+    {
+        const size_t n = k + kw + kp;
+
+        View Sn  = detail::block_columns(S,  0, n);
+        View ASn = detail::block_columns(AS, 0, n);
+
+        // Rayleigh-Ritz on the orthonormal basis, G = S^H A S
+        detail::block_inner_products(Sn, ASn, G_dev);
+
+        HostArray2d Gh(n, n);
+        detail::block_copy_to_host(G_dev, Gh);
+
+        G.resize(n, n);
+        for (size_t b = 0; b < n; b++)
+            for (size_t a = 0; a < n; a++)
+                G(a,b) = detail::ritz_promote(Gh(a,b));
+
+        detail::ritz_hermitian_eigen(G, theta, Y);
+
+        order.resize(n);
+        thrust::sequence(order.begin(), order.end());
+        std::stable_sort(order.begin(), order.end(), detail::lobpcg_order(theta));
+
+        HostArray2d Yk(n, k);
+        for (size_t b = 0; b < k; b++)
+            for (size_t a = 0; a < n; a++)
+                Yk(a,b) = demote(Y(a, order[b]));
+
+        // X <- S Y and A X <- (A S) Y
+        View Tx  = detail::block_columns(T,  0, k);
+        View ATx = detail::block_columns(AT, 0, k);
+
+        detail::block_copy_to_device(Yk, Y_dev);
+        detail::block_multiply(Sn,  Y_dev, Tx,  false);
+        detail::block_multiply(ASn, Y_dev, ATx, false);
+
+        // P <- the part of the update outside X, S(:,k:n) Y(k:n,:)
+        const size_t kp_new = (n > k) ? k : 0;
+
+        if (kp_new > 0)
+        {
+            HostArray2d Yt(n - k, k);
+            for (size_t b = 0; b < k; b++)
+                for (size_t a = 0; a < n - k; a++)
+                    Yt(a,b) = Yk(k + a, b);
+
+            View St  = detail::block_columns(S,  k, n - k);
+            View ASt = detail::block_columns(AS, k, n - k);
+            View Tp  = detail::block_columns(T,  k, k);
+            View ATp = detail::block_columns(AT, k, k);
+
+            detail::block_copy_to_device(Yt, Y_dev);
+            detail::block_multiply(St,  Y_dev, Tp,  false);
+            detail::block_multiply(ASt, Y_dev, ATp, false);
+        }
+
+        for (size_t j = 0; j < k; j++)
+        {
+            blas::copy(T.column(j),  S.column(j));
+            blas::copy(AT.column(j), AS.column(j));
+        }
+
+        // residuals A X - X Lambda
+        for (size_t j = 0; j < k; j++)
+            blas::axpby(AS.column(j), S.column(j), Q.column(j), ValueType(1), ValueType(-theta[order[j]]));
+
+        View Qk = detail::block_columns(Q, 0, k);
+        detail::block_column_inner_products(Qk, Qk, d_dev);
+
+        cusp::array1d<ValueType,cusp::host_memory> d(d_dev.begin(), d_dev.begin() + k);
+
+        double theta_max = 0;
+        for (size_t i = 0; i < n; i++)
+            theta_max = std::max(theta_max, std::abs(theta[i]));
+
+        converged = 0;
+        for (size_t j = 0; j < k; j++)
+            if (std::sqrt(std::abs(detail::s_step_real(d[j]))) <= tolerance * theta_max)
+                converged++;
+
+        if (converged == k || iteration == maxiter)
+            break;
+
+        // W <- M (A X - X Lambda), orthonormalized against X
+        for (size_t j = 0; j < k; j++)
+        {
+            typename WorkArray2d::column_view q  = Q.column(j);
+            typename WorkArray2d::column_view Mq = S.column(k + j);
+            cusp::multiply(M, q, Mq);
+        }
+
+        const size_t w1 = detail::s_step_orthogonalize(S, k, k, G_dev, C_dev, Rinv_dev, C1, R1);
+        kw = w1 ? detail::s_step_orthogonalize(S, k, w1, G_dev, C_dev, Rinv_dev, C2, R2) : 0;
+
+        for (size_t j = 0; j < kw; j++)
+        {
+            typename WorkArray2d::column_view w  = S.column(k + j);
+            typename WorkArray2d::column_view Aw = AS.column(k + j);
+            cusp::multiply(A, w, Aw);
+        }
+
+        // P behind W, orthonormalized against X and W.  A P is transformed
+        // along with P instead of being recomputed.
+        kp = 0;
+
+        if (kp_new > 0)
+        {
+            const size_t f = k + kw;
+
+            for (size_t j = 0; j < kp_new; j++)
+            {
+                blas::copy(T.column(k + j),  S.column(f + j));
+                blas::copy(AT.column(k + j), AS.column(f + j));
+            }
+
+            const size_t p1 = detail::s_step_orthogonalize(S, f, kp_new, G_dev, C_dev, Rinv_dev, C1, R1);
+            if (p1 > 0)
+                detail::block_update(AS, f, f, p1, C_dev, Rinv_dev);
+
+            const size_t p2 = p1 ? detail::s_step_orthogonalize(S, f, p1, G_dev, C_dev, Rinv_dev, C2, R2) : 0;
+            if (p2 > 0)
+                detail::block_update(AS, f, f, p2, C_dev, Rinv_dev);
+
+            kp = p2;
+        }
+    }
+
+    eigenvalues.resize(k);
+    X.resize(N, k);
+
+    for (size_t j = 0; j < k; j++)
+    {
+        eigenvalues[j] = typename Array1d::value_type(theta[order[j]]);
+        blas::copy(S.column(j), X.column(j));
+    }
+
+    return converged;
+}
+
+} // end namespace krylov
+} // end namespace cusp
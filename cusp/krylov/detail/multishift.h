@@ -0,0 +1,224 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+// Building blocks shared by the multi-shift solvers CG-M and BiCGStab-M:
+// the per-shift convergence state kept in device memory, paired
+// reductions and the polynomial preconditioning of shifted systems.
+
+#pragma once
+
+#include <cusp/array1d.h>
+#include <cusp/blas.h>
+#include <cusp/linear_operator.h>
+#include <cusp/monitor.h>
+#include <cusp/multiply.h>
+
+#include <thrust/tuple.h>
+#include <thrust/functional.h>
+#include <thrust/detail/type_traits.h>
+
+#include <limits>
+
+namespace cusp
+{
+namespace krylov
+{
+namespace detail
+{
+
+// x^\sigma of a shift is updated while its state is not multishift_frozen
+enum multishift_state
+{
+    multishift_frozen      = 0,
+    multishift_last_update = 1,
+    multishift_active      = 2
+};
+
+// advances the state of a shift whose residual is factor * r, where
+// |factor| <= limit means ||factor * r|| <= tolerance.  The update that
+// made the shift converge is still applied.
+template <typename ValueType, typename NormType>
+__host__ __device__
+int multishift_next_state(const int state, const ValueType& factor, const NormType limit)
+{
+    if (state == multishift_last_update)
+        return multishift_frozen;
+
+    if (state == multishift_active && abs(factor) <= limit)
+        return multishift_last_update;
+
+    return state;
+}
+
+// bound on |factor| for a residual norm of r_norm
+template <typename NormType>
+NormType multishift_limit(const NormType tolerance, const NormType r_norm)
+{
+    if (r_norm == NormType(0))
+        return std::numeric_limits<NormType>::max();
+
+    return tolerance / r_norm;
+}
+
+// sums two reductions at once
+template <typename ValueType>
+struct multishift_pair_plus
+{
+    typedef thrust::tuple<ValueType,ValueType> result_type;
+
+    __host__ __device__
+    result_type operator()(const result_type& a, const result_type& b) const
+    {
+        return result_type(thrust::get<0>(a) + thrust::get<0>(b),
+                           thrust::get<1>(a) + thrust::get<1>(b));
+    }
+};
+
+// passes the residual norm computed by the solver to monitors that accept it
+template <typename Monitor, typename Vector, typename NormType>
+bool multishift_finished(Monitor& monitor, const Vector& r, const NormType r_norm, thrust::detail::true_type)
+{
+    return monitor.finished(r_norm);
+}
+
+template <typename Monitor, typename Vector, typename NormType>
+bool multishift_finished(Monitor& monitor, const Vector& r, const NormType r_norm, thrust::detail::false_type)
+{
+    return monitor.finished(r);
+}
+
+// h <- c(A) x for the polynomial with coefficients c, highest degree first
+template <typename LinearOperator, typename Array1, typename Vector1, typename Vector2, typename Vector3>
+void multishift_polynomial_multiply(LinearOperator& A, const Array1& coefficients,
+                                    const Vector1& x, Vector2& h, Vector3& t)
+{
+    typedef typename Vector2::value_type ValueType;
+
+    cusp::blas::axpby(x, h, h, ValueType(coefficients[0]), ValueType(0));
+
+    for (size_t i = 1; i < coefficients.size(); i++)
+    {
+        cusp::multiply(A, h, t);
+        cusp::blas::axpby(t, x, h, ValueType(1), ValueType(coefficients[i]));
+    }
+}
+
+// B = A p(A) for a polynomial preconditioner p
+//
+// For every shift \sigma the polynomial
+//
+//     p_\sigma(t) = (t p(t) + \eta) / (t + \sigma),  \eta = \sigma p(-\sigma)
+//
+// satisfies (A + \sigma) p_\sigma(A) = B + \eta, so the shifted systems
+// of B with the shifts \eta share one Krylov space and x = p_\sigma(A) y
+// solves (A + \sigma) x = b whenever (B + \eta) y = b.
+template <typename LinearOperator, typename ValueType, typename MemorySpace>
+class multishift_polynomial_operator : public cusp::linear_operator<ValueType,MemorySpace>
+{
+    typedef cusp::linear_operator<ValueType,MemorySpace> Parent;
+
+    public:
+
+    LinearOperator& A;
+    cusp::array1d<ValueType,cusp::host_memory> coefficients;
+    mutable cusp::array1d<ValueType,MemorySpace> h;
+    mutable cusp::array1d<ValueType,MemorySpace> t;
+
+    template <typename Array>
+    multishift_polynomial_operator(LinearOperator& A, const Array& coefficients)
+        : Parent(A.num_rows, A.num_cols), A(A), coefficients(coefficients),
+          h(A.num_rows), t(A.num_rows)
+    {}
+
+    // y <- A p(A) x
+    template <typename VectorType1, typename VectorType2>
+    void operator()(const VectorType1& x, VectorType2& y) const
+    {
+        multishift_polynomial_multiply(A, coefficients, x, h, t);
+        cusp::multiply(A, h, y);
+    }
+
+    // \eta = \sigma p(-\sigma)
+    ValueType shift(const ValueType sigma) const
+    {
+        ValueType value = coefficients[0];
+
+        for (size_t i = 1; i < coefficients.size(); i++)
+            value = value * (-sigma) + coefficients[i];
+
+        return sigma * value;
+    }
+
+    // coefficients of p_\sigma, the quotient of t p(t) + \eta by t + \sigma
+    template <typename Array>
+    void shifted_coefficients(const ValueType sigma, Array& c) const
+    {
+        c.resize(coefficients.size());
+
+        c[0] = coefficients[0];
+
+        for (size_t i = 1; i < coefficients.size(); i++)
+            c[i] = coefficients[i] - sigma * c[i - 1];
+    }
+};
+
+// solves (A + \sigma) x = b for all shifts with a polynomial preconditioner
+// by running Solver on B = A p(A) with the shifts \eta
+template <typename LinearOperator, typename VectorType1, typename VectorType2,
+          typename VectorType3, typename Monitor, typename Array, typename Solver>
+void multishift_polynomial_solve(LinearOperator& A, VectorType1& x, VectorType2& b,
+                                 VectorType3& sigma, Monitor& monitor,
+                                 const Array& coefficients, Solver solver)
+{
+    typedef typename LinearOperator::value_type   ValueType;
+    typedef typename LinearOperator::memory_space MemorySpace;
+
+    assert(coefficients.size() > 0);
+
+    const size_t N   = A.num_rows;
+    const size_t N_s = sigma.size();
+
+    multishift_polynomial_operator<LinearOperator,ValueType,MemorySpace> B(A, coefficients);
+
+    cusp::array1d<ValueType,cusp::host_memory> sigma_h(sigma);
+    cusp::array1d<ValueType,cusp::host_memory> eta_h(N_s);
+
+    for (size_t i = 0; i < N_s; i++)
+        eta_h[i] = B.shift(sigma_h[i]);
+
+    cusp::array1d<ValueType,MemorySpace> eta(eta_h);
+    cusp::array1d<ValueType,MemorySpace> y(x.size());
+
+    solver(B, y, b, eta, monitor);
+
+    // x^\sigma <- p_\sigma(A) y^\sigma
+    cusp::array1d<ValueType,cusp::host_memory> c;
+
+    for (size_t i = 0; i < N_s; i++)
+    {
+        B.shifted_coefficients(sigma_h[i], c);
+
+        typename cusp::array1d<ValueType,MemorySpace>::view y_s(y.begin() + i * N, y.begin() + (i + 1) * N);
+        typename VectorType1::view x_s(x.begin() + i * N, x.begin() + (i + 1) * N);
+
+        multishift_polynomial_multiply(A, c, y_s, x_s, B.t);
+    }
+}
+
+} // end namespace detail
+} // end namespace krylov
+} // end namespace cusp
+
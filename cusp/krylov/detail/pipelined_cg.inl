@@ -0,0 +1,446 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+#include <cusp/array1d.h>
+#include <cusp/blas.h>
+#include <cusp/multiply.h>
+#include <cusp/monitor.h>
+#include <cusp/linear_operator.h>
+#include <cusp/detail/stream.h>
+
+#include <cusp/krylov/detail/device/pipelined_cg.h>
+
+#ifdef __CUSP_USE_MPI__
+#include <cusp/detail/mpi.h>
+#endif
+
+#include <thrust/functional.h>
+#include <thrust/tuple.h>
+#include <thrust/iterator/zip_iterator.h>
+
+#include <cmath>
+
+namespace blas = cusp::blas;
+
+namespace cusp
+{
+namespace krylov
+{
+namespace detail
+{
+
+// (r, u, w) -> (<r^H,u>, <w^H,u>, <r^H,r>)
+template <typename ValueType>
+struct pipelined_cg_dots_functor
+{
+    typedef thrust::tuple<ValueType,ValueType,ValueType> result_type;
+
+    template <typename Tuple>
+    __host__ __device__
+    result_type operator()(const Tuple& t) const
+    {
+        cusp::blas::detail::conjugate<ValueType> conj;
+
+        const ValueType r = thrust::get<0>(t);
+        const ValueType u = thrust::get<1>(t);
+        const ValueType w = thrust::get<2>(t);
+
+        return result_type(conj(r) * u, conj(w) * u, conj(r) * r);
+    }
+};
+
+template <typename ValueType>
+struct pipelined_cg_dots_plus
+{
+    typedef thrust::tuple<ValueType,ValueType,ValueType> result_type;
+
+    __host__ __device__
+    result_type operator()(const result_type& a, const result_type& b) const
+    {
+        return result_type(thrust::get<0>(a) + thrust::get<0>(b),
+                           thrust::get<1>(a) + thrust::get<1>(b),
+                           thrust::get<2>(a) + thrust::get<2>(b));
+    }
+};
+
+// Host reduction: computed immediately in begin()
+template <typename ValueType, typename MemorySpace>
+class pipelined_cg_reduction
+{
+    public:
+    typedef thrust::tuple<ValueType,ValueType,ValueType> Tuple;
+
+    pipelined_cg_reduction(size_t) {}
+
+    template <typename Array>
+    void begin(const Array& r, const Array& u, const Array& w)
+    {
+        result = cusp::detail::stream::transform_reduce
+            (thrust::make_zip_iterator(thrust::make_tuple(r.begin(), u.begin(), w.begin())),
+             thrust::make_zip_iterator(thrust::make_tuple(r.begin(), u.begin(), w.begin())) + r.size(),
+             pipelined_cg_dots_functor<ValueType>(),
+             Tuple(ValueType(0), ValueType(0), ValueType(0)),
+             pipelined_cg_dots_plus<ValueType>());
+    }
+
+    void end(ValueType& gamma, ValueType& delta, ValueType& rr)
+    {
+        gamma = thrust::get<0>(result);
+        delta = thrust::get<1>(result);
+        rr    = thrust::get<2>(result);
+    }
+
+    private:
+    Tuple result;
+};
+
+// Device reduction: overlapped with the work issued after begin()
+template <typename ValueType>
+class pipelined_cg_reduction<ValueType, cusp::device_memory>
+    : public cusp::krylov::detail::device::pipelined_cg_reduction<ValueType>
+{
+    public:
+    pipelined_cg_reduction(size_t N)
+        : cusp::krylov::detail::device::pipelined_cg_reduction<ValueType>(N) {}
+};
+
+// (n, m, z, q, s, p, x, r, u, w)
+//   z <- n + beta * z,  q <- m + beta * q,  s <- w + beta * s,  p <- u + beta * p
+//   x <- x + alpha * p, r <- r - alpha * s, u <- u - alpha * q, w <- w - alpha * z
+template <typename ValueType>
+struct pipelined_cg_update_functor
+{
+    const ValueType alpha;
+    const ValueType beta;
+
+    pipelined_cg_update_functor(const ValueType alpha, const ValueType beta)
+        : alpha(alpha), beta(beta) {}
+
+    template <typename Tuple>
+    __host__ __device__
+    void operator()(Tuple t) const
+    {
+        const ValueType z = thrust::get<0>(t) + beta * thrust::get<2>(t);
+        const ValueType q = thrust::get<1>(t) + beta * thrust::get<3>(t);
+        const ValueType s = thrust::get<9>(t) + beta * thrust::get<4>(t);
+        const ValueType p = thrust::get<8>(t) + beta * thrust::get<5>(t);
+
+        thrust::get<2>(t) = z;
+        thrust::get<3>(t) = q;
+        thrust::get<4>(t) = s;
+        thrust::get<5>(t) = p;
+
+        thrust::get<6>(t) = thrust::get<6>(t) + alpha * p;
+        thrust::get<7>(t) = thrust::get<7>(t) - alpha * s;
+        thrust::get<8>(t) = thrust::get<8>(t) - alpha * q;
+        thrust::get<9>(t) = thrust::get<9>(t) - alpha * z;
+    }
+};
+
+template <typename Monitor, typename Vector, typename NormType>
+bool pipelined_cg_finished(Monitor& monitor, const Vector& r, const NormType, thrust::detail::false_type)
+{
+    return monitor.finished(r);
+}
+
+template <typename Monitor, typename Vector, typename NormType>
+bool pipelined_cg_finished(Monitor& monitor, const Vector&, const NormType r_norm, thrust::detail::true_type)
+{
+    return monitor.finished(r_norm);
+}
+
+} // end namespace detail
+
+template <class LinearOperator,
+          class Vector>
+void pipelined_cg(LinearOperator& A,
+                  Vector& x,
+                  Vector& b)
+{
+    typedef typename LinearOperator::value_type   ValueType;
+
+    cusp::default_monitor<ValueType> monitor(b);
+
+    cusp::krylov::pipelined_cg(A, x, b, monitor);
+}
+
+template <class LinearOperator,
+          class Vector,
+          class Monitor>
+void pipelined_cg(LinearOperator& A,
+                  Vector& x,
+                  Vector& b,
+                  Monitor& monitor)
+{
+    typedef typename LinearOperator::value_type   ValueType;
+    typedef typename LinearOperator::memory_space MemorySpace;
+
+    cusp::identity_operator<ValueType,MemorySpace> M(A.num_rows, A.num_cols);
+
+    cusp::krylov::pipelined_cg(A, x, b, monitor, M);
+}
+
+template <class LinearOperator,
+          class Vector,
+          class Monitor,
+          class Preconditioner>
+void pipelined_cg(LinearOperator& A,
+                  Vector& x,
+                  Vector& b,
+                  Monitor& monitor,
+                  Preconditioner& M)
+{
+    typedef typename LinearOperator::value_type   ValueType;
+    typedef typename LinearOperator::memory_space MemorySpace;
+
+    cusp::krylov::workspace<ValueType,MemorySpace> workspace;
+
+    cusp::krylov::pipelined_cg(A, x, b, monitor, M, workspace);
+}
+
+template <class LinearOperator,
+          class Vector,
+          class Monitor,
+          class Preconditioner,
+          class Workspace>
+void pipelined_cg(LinearOperator& A,
+                  Vector& x,
+                  Vector& b,
+                  Monitor& monitor,
+                  Preconditioner& M,
+                  Workspace& workspace)
+{
+    CUSP_PROFILE_SCOPED();
+
+    typedef typename LinearOperator::value_type   ValueType;
+    typedef typename LinearOperator::memory_space MemorySpace;
+    typedef typename norm_type<ValueType>::type   NormType;
+    typedef typename Workspace::vector_type       Array;
+
+    assert(A.num_rows == A.num_cols);        // sanity check
+
+    const size_t N = A.num_rows;
+
+    // get workspace
+    Array& r = workspace.vector(0, N);
+    Array& u = workspace.vector(1, N);
+    Array& w = workspace.vector(2, N);
+    Array& m = workspace.vector(3, N);
+    Array& n = workspace.vector(4, N);
+    Array& z = workspace.vector(5, N);
+    Array& q = workspace.vector(6, N);
+    Array& s = workspace.vector(7, N);
+    Array& p = workspace.vector(8, N);
+
+    detail::pipelined_cg_reduction<ValueType,MemorySpace> reduction(N);
+
+    // r <- b - A*x
+    cusp::multiply(A, x, r);
+    blas::axpby(b, r, r, ValueType(1), ValueType(-1));
+
+    // u <- M*r
+    cusp::multiply(M, r, u);
+
+    // w <- A*u
+    cusp::multiply(A, u, w);
+
+    // the first update uses beta = 0
+    blas::fill(z, ValueType(0));
+    blas::fill(q, ValueType(0));
+    blas::fill(s, ValueType(0));
+    blas::fill(p, ValueType(0));
+
+    ValueType alpha = 0;
+    ValueType gamma_old = 0;
+
+    for (size_t i = 0; ; i++)
+    {
+        // gamma <- <r^H,u>, delta <- <w^H,u>, rr <- <r^H,r>
+        reduction.begin(r, u, w);
+
+        // m <- M*w
+        cusp::multiply(M, w, m);
+
+        // n <- A*m
+        cusp::multiply(A, m, n);
+
+        ValueType gamma, delta, rr;
+        reduction.end(gamma, delta, rr);
+
+        if (detail::pipelined_cg_finished(monitor, r, NormType(std::sqrt(abs(rr))),
+                                          typename cusp::detail::accepts_residual_norm<Monitor>::type()))
+            break;
+
+        ValueType beta;
+
+        if (i == 0)
+        {
+            beta  = 0;
+            alpha = gamma / delta;
+        }
+        else
+        {
+            beta  = gamma / gamma_old;
+            alpha = gamma / (delta - beta * gamma / alpha);
+        }
+
+        gamma_old = gamma;
+
+        // update the recurrences
+        cusp::detail::stream::for_each
+            (thrust::make_zip_iterator(thrust::make_tuple(n.begin(), m.begin(), z.begin(), q.begin(), s.begin(),
+                                                          p.begin(), x.begin(), r.begin(), u.begin(), w.begin())),
+             thrust::make_zip_iterator(thrust::make_tuple(n.begin(), m.begin(), z.begin(), q.begin(), s.begin(),
+                                                          p.begin(), x.begin(), r.begin(), u.begin(), w.begin())) + N,
+             detail::pipelined_cg_update_functor<ValueType>(alpha, beta));
+
+        ++monitor;
+    }
+}
+
+#ifdef __CUSP_USE_MPI__
+
+template <class LocalMatrix,
+          class ValueType,
+          class Monitor,
+          class Preconditioner>
+void pipelined_cg(cusp::mpi_matrix<LocalMatrix>& A,
+                  cusp::mpi_array1d<ValueType>& x,
+                  cusp::mpi_array1d<ValueType>& b,
+                  Monitor& monitor,
+                  Preconditioner& M)
+{
+    cusp::krylov::mpi_workspace<ValueType> workspace(A.layout);
+
+    cusp::krylov::pipelined_cg(A, x, b, monitor, M, workspace);
+}
+
+template <class LocalMatrix,
+          class ValueType,
+          class Monitor,
+          class Preconditioner>
+void pipelined_cg(cusp::mpi_matrix<LocalMatrix>& A,
+                  cusp::mpi_array1d<ValueType>& x,
+                  cusp::mpi_array1d<ValueType>& b,
+                  Monitor& monitor,
+                  Preconditioner& M,
+                  cusp::krylov::mpi_workspace<ValueType>& workspace)
+{
+    CUSP_PROFILE_SCOPED();
+
+    typedef typename norm_type<ValueType>::type         NormType;
+    typedef cusp::mpi_array1d<ValueType>                Array;
+    typedef thrust::tuple<ValueType,ValueType,ValueType> Tuple;
+
+    const size_t N = A.num_rows;
+    const size_t num_local_rows = A.layout.local_size();
+
+    // get workspace
+    Array& r = workspace.vector(0, N);
+    Array& u = workspace.vector(1, N);
+    Array& w = workspace.vector(2, N);
+    Array& m = workspace.vector(3, N);
+    Array& n = workspace.vector(4, N);
+    Array& z = workspace.vector(5, N);
+    Array& q = workspace.vector(6, N);
+    Array& s = workspace.vector(7, N);
+    Array& p = workspace.vector(8, N);
+
+    cusp::detail::mpi_nonblocking_sum<ValueType,3> reduction(A.layout.comm);
+
+    // r <- b - A*x
+    cusp::multiply(A, x, r);
+    blas::axpby(b, r, r, ValueType(1), ValueType(-1));
+
+    // u <- M*r
+    cusp::multiply(M, r, u);
+
+    // w <- A*u
+    cusp::multiply(A, u, w);
+
+    // the first update uses beta = 0
+    blas::fill(z, ValueType(0));
+    blas::fill(q, ValueType(0));
+    blas::fill(s, ValueType(0));
+    blas::fill(p, ValueType(0));
+
+    ValueType alpha = 0;
+    ValueType gamma_old = 0;
+
+    for (size_t i = 0; ; i++)
+    {
+        // local parts of gamma <- <r^H,u>, delta <- <w^H,u>, rr <- <r^H,r>
+        const Tuple local = cusp::detail::stream::transform_reduce
+            (thrust::make_zip_iterator(thrust::make_tuple(r.local.begin(), u.local.begin(), w.local.begin())),
+             thrust::make_zip_iterator(thrust::make_tuple(r.local.begin(), u.local.begin(), w.local.begin())) + num_local_rows,
+             detail::pipelined_cg_dots_functor<ValueType>(),
+             Tuple(ValueType(0), ValueType(0), ValueType(0)),
+             detail::pipelined_cg_dots_plus<ValueType>());
+
+        ValueType dots[3] = { thrust::get<0>(local), thrust::get<1>(local), thrust::get<2>(local) };
+
+        // sum them over the processes while M and A are applied
+        reduction.begin(dots);
+
+        // m <- M*w
+        cusp::multiply(M, w, m);
+
+        // n <- A*m
+        cusp::multiply(A, m, n);
+
+        reduction.end(dots);
+
+        const ValueType gamma = dots[0];
+        const ValueType delta = dots[1];
+        const ValueType rr    = dots[2];
+
+        if (detail::pipelined_cg_finished(monitor, r, NormType(std::sqrt(abs(rr))),
+                                          typename cusp::detail::accepts_residual_norm<Monitor>::type()))
+            break;
+
+        ValueType beta;
+
+        if (i == 0)
+        {
+            beta  = 0;
+            alpha = gamma / delta;
+        }
+        else
+        {
+            beta  = gamma / gamma_old;
+            alpha = gamma / (delta - beta * gamma / alpha);
+        }
+
+        gamma_old = gamma;
+
+        // update the recurrences of the local rows
+        cusp::detail::stream::for_each
+            (thrust::make_zip_iterator(thrust::make_tuple(n.local.begin(), m.local.begin(), z.local.begin(), q.local.begin(), s.local.begin(),
+                                                          p.local.begin(), x.local.begin(), r.local.begin(), u.local.begin(), w.local.begin())),
+             thrust::make_zip_iterator(thrust::make_tuple(n.local.begin(), m.local.begin(), z.local.begin(), q.local.begin(), s.local.begin(),
+                                                          p.local.begin(), x.local.begin(), r.local.begin(), u.local.begin(), w.local.begin())) + num_local_rows,
+             detail::pipelined_cg_update_functor<ValueType>(alpha, beta));
+
+        ++monitor;
+    }
+}
+
+#endif // __CUSP_USE_MPI__
+
+} // end namespace krylov
+} // end namespace cusp
+
@@ -0,0 +1,438 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+// Ritz vectors of the small projected eigenvalue problems that select the
+// subspaces recycled by deflated_cg and gcro_dr.  The problems have a few
+// dozen rows and are solved on the host in double precision complex
+// arithmetic, whatever the value type of the solver.
+
+#pragma once
+
+#include <cusp/array1d.h>
+#include <cusp/array2d.h>
+#include <cusp/complex.h>
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <limits>
+
+namespace cusp
+{
+namespace krylov
+{
+namespace detail
+{
+
+typedef std::complex<double> ritz_complex;
+typedef cusp::array2d<ritz_complex,cusp::host_memory,cusp::column_major> ritz_matrix;
+
+inline ritz_complex ritz_promote(const float x)  { return ritz_complex(x); }
+inline ritz_complex ritz_promote(const double x) { return ritz_complex(x); }
+
+template <typename T>
+ritz_complex ritz_promote(const cusp::complex<T>& x) { return ritz_complex(x.real(), x.imag()); }
+
+template <typename ValueType>
+struct ritz_demote
+{
+    ValueType operator()(const ritz_complex& x) const { return ValueType(x.real()); }
+};
+
+template <typename T>
+struct ritz_demote< cusp::complex<T> >
+{
+    cusp::complex<T> operator()(const ritz_complex& x) const { return cusp::complex<T>(T(x.real()), T(x.imag())); }
+};
+
+// Givens rotation G = [c s; -conj(s) c] with G [x; y] = [r; 0]
+inline void ritz_rotation(const ritz_complex& x, const ritz_complex& y, double& c, ritz_complex& s)
+{
+    const double ax = std::abs(x);
+    const double r  = std::sqrt(ax * ax + std::norm(y));
+
+    if (r == 0)
+    {
+        c = 1;
+        s = 0;
+    }
+    else if (ax == 0)
+    {
+        c = 0;
+        s = 1;
+    }
+    else
+    {
+        c = ax / r;
+        s = (x / ax) * std::conj(y) / r;
+    }
+}
+
+// Eigenvalues and eigenvectors of a small general matrix: reduction to
+// Hessenberg form by Householder reflections followed by the shifted QR
+// algorithm in complex arithmetic.  A is overwritten by its Schur form.
+inline void ritz_eigen(ritz_matrix& A, cusp::array1d<ritz_complex,cusp::host_memory>& lambda, ritz_matrix& Z)
+{
+    const size_t n = A.num_rows;
+    const double eps = std::numeric_limits<double>::epsilon();
+
+    Z.resize(n, n);
+    lambda.resize(n);
+
+    if (n == 0)
+        return;
+
+    for (size_t j = 0; j < n; j++)
+        for (size_t i = 0; i < n; i++)
+            Z(i,j) = (i == j) ? 1 : 0;
+
+    // Hessenberg reduction
+    cusp::array1d<ritz_complex,cusp::host_memory> v(n);
+
+    for (size_t k = 0; k + 2 < n; k++)
+    {
+        double x_norm = 0;
+        for (size_t i = k + 1; i < n; i++)
+            x_norm += std::norm(A(i,k));
+        x_norm = std::sqrt(x_norm);
+
+        if (x_norm == 0)
+            continue;
+
+        const ritz_complex x0 = A(k+1,k);
+        const ritz_complex alpha = (std::abs(x0) == 0) ? ritz_complex(-x_norm) : -x0 / std::abs(x0) * x_norm;
+
+        double v_norm = 0;
+        for (size_t i = k + 1; i < n; i++)
+        {
+            v[i] = A(i,k) - ((i == k + 1) ? alpha : ritz_complex(0));
+            v_norm += std::norm(v[i]);
+        }
+        v_norm = std::sqrt(v_norm);
+
+        if (v_norm == 0)
+            continue;
+
+        for (size_t i = k + 1; i < n; i++)
+            v[i] /= v_norm;
+
+        // A <- (I - 2 v v^H) A (I - 2 v v^H), Z <- Z (I - 2 v v^H)
+        for (size_t j = k; j < n; j++)
+        {
+            ritz_complex t = 0;
+            for (size_t i = k + 1; i < n; i++)
+                t += std::conj(v[i]) * A(i,j);
+            for (size_t i = k + 1; i < n; i++)
+                A(i,j) -= 2.0 * v[i] * t;
+        }
+        for (size_t i = 0; i < n; i++)
+        {
+            ritz_complex t = 0, u = 0;
+            for (size_t j = k + 1; j < n; j++)
+            {
+                t += A(i,j) * v[j];
+                u += Z(i,j) * v[j];
+            }
+            for (size_t j = k + 1; j < n; j++)
+            {
+                A(i,j) -= 2.0 * t * std::conj(v[j]);
+                Z(i,j) -= 2.0 * u * std::conj(v[j]);
+            }
+        }
+        for (size_t i = k + 2; i < n; i++)
+            A(i,k) = 0;
+    }
+
+    // shifted QR iterations on the active window [l, hi]
+    cusp::array1d<double,cusp::host_memory> cs(n);
+    cusp::array1d<ritz_complex,cusp::host_memory> sn(n);
+
+    size_t hi = n - 1;
+    size_t iterations = 0;
+
+    while (hi > 0 && iterations < 100 * n)
+    {
+        size_t l = hi;
+        while (l > 0 && std::abs(A(l,l-1)) > eps * (std::abs(A(l,l)) + std::abs(A(l-1,l-1))))
+            l--;
+
+        if (l > 0)
+            A(l,l-1) = 0;
+
+        if (l == hi)
+        {
+            hi--;
+            continue;
+        }
+
+        ++iterations;
+
+        // Wilkinson shift, with an exceptional shift from time to time
+        const ritz_complex a = A(hi-1,hi-1), b = A(hi-1,hi), c = A(hi,hi-1), d = A(hi,hi);
+        const ritz_complex t = 0.5 * (a + d);
+        const ritz_complex r = std::sqrt(0.25 * (a - d) * (a - d) + b * c);
+        ritz_complex mu = (std::abs(t + r - d) < std::abs(t - r - d)) ? t + r : t - r;
+        if (iterations % 11 == 0)
+            mu = d + std::abs(c);
+
+        for (size_t j = l; j <= hi; j++)
+            A(j,j) -= mu;
+
+        // A - mu I = Q R
+        for (size_t j = l; j < hi; j++)
+        {
+            ritz_rotation(A(j,j), A(j+1,j), cs[j], sn[j]);
+
+            for (size_t k = j; k < n; k++)
+            {
+                const ritz_complex t1 = A(j,k), t2 = A(j+1,k);
+                A(j,k)   = cs[j] * t1 + sn[j] * t2;
+                A(j+1,k) = -std::conj(sn[j]) * t1 + cs[j] * t2;
+            }
+        }
+
+        // R Q + mu I
+        for (size_t j = l; j < hi; j++)
+        {
+            for (size_t i = 0; i <= std::min(j + 1, hi); i++)
+            {
+                const ritz_complex t1 = A(i,j), t2 = A(i,j+1);
+                A(i,j)   = t1 * cs[j] + t2 * std::conj(sn[j]);
+                A(i,j+1) = -t1 * sn[j] + t2 * cs[j];
+            }
+            for (size_t i = 0; i < n; i++)
+            {
+                const ritz_complex t1 = Z(i,j), t2 = Z(i,j+1);
+                Z(i,j)   = t1 * cs[j] + t2 * std::conj(sn[j]);
+                Z(i,j+1) = -t1 * sn[j] + t2 * cs[j];
+            }
+        }
+
+        for (size_t j = l; j <= hi; j++)
+            A(j,j) += mu;
+    }
+
+    for (size_t i = 0; i < n; i++)
+        lambda[i] = A(i,i);
+
+    // eigenvectors of the triangular factor, transformed back by Z
+    double A_norm = 0;
+    for (size_t j = 0; j < n; j++)
+        for (size_t i = 0; i <= j; i++)
+            A_norm = std::max(A_norm, std::abs(A(i,j)));
+    const double small = eps * std::max(A_norm, 1.0);
+
+    ritz_matrix Y(n, n, ritz_complex(0));
+
+    for (size_t k = 0; k < n; k++)
+    {
+        Y(k,k) = 1;
+        for (size_t j = k; j-- > 0; )
+        {
+            ritz_complex sum = 0;
+            for (size_t l = j + 1; l <= k; l++)
+                sum += A(j,l) * Y(l,k);
+            ritz_complex den = A(j,j) - lambda[k];
+            if (std::abs(den) < small)
+                den = small;
+            Y(j,k) = -sum / den;
+        }
+    }
+
+    ritz_matrix ZY(n, n);
+    for (size_t k = 0; k < n; k++)
+    {
+        double norm = 0;
+        for (size_t i = 0; i < n; i++)
+        {
+            ritz_complex sum = 0;
+            for (size_t l = 0; l <= k; l++)
+                sum += Z(i,l) * Y(l,k);
+            ZY(i,k) = sum;
+            norm += std::norm(sum);
+        }
+        norm = std::sqrt(norm);
+        for (size_t i = 0; i < n; i++)
+            ZY(i,k) /= norm;
+    }
+
+    Z = ZY;
+}
+
+// Eigenvalues and orthonormal eigenvectors of a small Hermitian matrix by
+// cyclic Jacobi rotations, which keep the eigenvectors of a real symmetric
+// matrix real.  Only the upper triangle of A is read and A is overwritten.
+inline void ritz_hermitian_eigen(ritz_matrix& A, cusp::array1d<double,cusp::host_memory>& lambda, ritz_matrix& Z)
+{
+    const size_t n = A.num_rows;
+    const double eps = std::numeric_limits<double>::epsilon();
+
+    Z.resize(n, n);
+    lambda.resize(n);
+
+    for (size_t j = 0; j < n; j++)
+        for (size_t i = 0; i < n; i++)
+            Z(i,j) = (i == j) ? 1 : 0;
+
+    for (size_t j = 0; j < n; j++)
+    {
+        A(j,j) = A(j,j).real();
+        for (size_t i = j + 1; i < n; i++)
+            A(i,j) = std::conj(A(j,i));
+    }
+
+    for (size_t sweep = 0; sweep < 50; sweep++)
+    {
+        double off = 0, diag = 0;
+        for (size_t j = 0; j < n; j++)
+        {
+            diag += std::norm(A(j,j));
+            for (size_t i = 0; i < j; i++)
+                off += std::norm(A(i,j));
+        }
+
+        if (off <= eps * eps * diag)
+            break;
+
+        for (size_t p = 0; p < n; p++)
+        {
+            for (size_t q = p + 1; q < n; q++)
+            {
+                const double a = std::abs(A(p,q));
+
+                if (a == 0)
+                    continue;
+
+                // J = [c, s e; -s conj(e), c] with J^H A J zero at (p,q)
+                const ritz_complex e = A(p,q) / a;
+                const double theta = (A(q,q).real() - A(p,p).real()) / (2 * a);
+                const double t = (theta < 0 ? -1.0 : 1.0) / (std::abs(theta) + std::sqrt(theta * theta + 1));
+                const double c = 1 / std::sqrt(t * t + 1);
+                const double s = t * c;
+
+                for (size_t k = 0; k < n; k++)
+                {
+                    const ritz_complex x = A(k,p), y = A(k,q);
+                    A(k,p) = c * x - s * std::conj(e) * y;
+                    A(k,q) = s * e * x + c * y;
+                }
+                for (size_t k = 0; k < n; k++)
+                {
+                    const ritz_complex x = A(p,k), y = A(q,k);
+                    A(p,k) = c * x - s * e * y;
+                    A(q,k) = s * std::conj(e) * x + c * y;
+                }
+                for (size_t k = 0; k < n; k++)
+                {
+                    const ritz_complex x = Z(k,p), y = Z(k,q);
+                    Z(k,p) = c * x - s * std::conj(e) * y;
+                    Z(k,q) = s * e * x + c * y;
+                }
+
+                A(p,q) = A(q,p) = 0;
+            }
+        }
+    }
+
+    for (size_t i = 0; i < n; i++)
+        lambda[i] = A(i,i).real();
+}
+
+template <typename ValueType>
+struct ritz_is_real { static const bool value = true; };
+
+template <typename T>
+struct ritz_is_real< cusp::complex<T> > { static const bool value = false; };
+
+// Columns spanning the eigenvectors of S whose eigenvalues have the largest
+// magnitude, at most k of them.  For real value types a complex conjugate
+// pair contributes the real and imaginary parts of one of its vectors.
+// Returns the number of columns of P.
+template <typename ValueType>
+size_t ritz_select(const cusp::array2d<ValueType,cusp::host_memory,cusp::column_major>& S, const size_t k,
+                   cusp::array2d<ValueType,cusp::host_memory,cusp::column_major>& P)
+{
+    const size_t n = S.num_rows;
+
+    ritz_matrix A(n, n), Z;
+    for (size_t j = 0; j < n; j++)
+        for (size_t i = 0; i < n; i++)
+            A(i,j) = ritz_promote(S(i,j));
+
+    cusp::array1d<ritz_complex,cusp::host_memory> lambda;
+    ritz_eigen(A, lambda, Z);
+
+    cusp::array1d<bool,cusp::host_memory> used(n, false);
+    ritz_demote<ValueType> demote;
+
+    P.resize(n, std::min(k, n));
+
+    size_t count = 0;
+
+    while (count < P.num_cols)
+    {
+        // largest remaining eigenvalue
+        size_t e = n;
+        for (size_t i = 0; i < n; i++)
+            if (!used[i] && (e == n || std::abs(lambda[i]) > std::abs(lambda[e])))
+                e = i;
+
+        if (e == n)
+            break;
+
+        used[e] = true;
+
+        // scale the vector so that its largest entry is real
+        size_t i_max = 0;
+        for (size_t i = 0; i < n; i++)
+            if (std::abs(Z(i,e)) > std::abs(Z(i_max,e)))
+                i_max = i;
+        const ritz_complex phase = std::conj(Z(i_max,e)) / std::abs(Z(i_max,e));
+
+        for (size_t i = 0; i < n; i++)
+            P(i,count) = demote(Z(i,e) * phase);
+        count++;
+
+        const bool pair = ritz_is_real<ValueType>::value &&
+            std::abs(lambda[e].imag()) > std::sqrt(std::numeric_limits<double>::epsilon()) * std::abs(lambda[e]);
+
+        if (pair)
+        {
+            // the conjugate eigenvalue spans the same real subspace
+            size_t partner = n;
+            for (size_t i = 0; i < n; i++)
+                if (!used[i] && (partner == n || std::abs(lambda[i] - std::conj(lambda[e])) <
+                                                 std::abs(lambda[partner] - std::conj(lambda[e]))))
+                    partner = i;
+            if (partner < n)
+                used[partner] = true;
+
+            if (count < P.num_cols)
+            {
+                for (size_t i = 0; i < n; i++)
+                    P(i,count) = demote(Z(i,e) * phase * ritz_complex(0,-1));
+                count++;
+            }
+        }
+    }
+
+    return count;
+}
+
+} // end namespace detail
+} // end namespace krylov
+} // end namespace cusp
+
@@ -0,0 +1,354 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+// Building blocks shared by the s-step Krylov methods: the matrix powers
+// kernel, block inner products computed by a single reduction and the
+// Cholesky QR factorization of a block of basis vectors, which the
+// eigensolvers use as well.
+
+#pragma once
+
+#include <cusp/array1d.h>
+#include <cusp/array2d.h>
+#include <cusp/blas.h>
+#include <cusp/complex.h>
+#include <cusp/multiply.h>
+
+#include <thrust/copy.h>
+#include <thrust/fill.h>
+#include <thrust/for_each.h>
+#include <thrust/reduce.h>
+#include <thrust/iterator/counting_iterator.h>
+#include <thrust/iterator/discard_iterator.h>
+#include <thrust/iterator/transform_iterator.h>
+#include <thrust/iterator/zip_iterator.h>
+
+#include <cmath>
+#include <limits>
+
+namespace cusp
+{
+namespace krylov
+{
+namespace detail
+{
+
+// u holds V(:,first) on entry, V(:,first+k+1) <- (M A)^(k+1) V(:,first)
+// for k < n.  The products are issued back to back without any reduction
+// in between.
+template <typename LinearOperator, typename Preconditioner, typename Array2d, typename Array1d>
+void matrix_powers(LinearOperator& A, Preconditioner& M, Array2d& V,
+                   const size_t first, const size_t n, Array1d& u, Array1d& t)
+{
+    for (size_t k = 0; k < n; k++)
+    {
+        cusp::multiply(A, u, t);
+        cusp::multiply(M, t, u);
+        cusp::blas::copy(u, V.column(first + k + 1));
+    }
+}
+
+// as above with the powers scaled by 1/sigma, V(:,r_first+k+1) additionally
+// receives A (M A)^k V(:,first) / sigma^(k+1)
+template <typename LinearOperator, typename Preconditioner, typename Array2d, typename Array1d>
+void matrix_powers(LinearOperator& A, Preconditioner& M, Array2d& V,
+                   const size_t first, const size_t r_first, const size_t n, Array1d& u, Array1d& t,
+                   const typename Array1d::value_type sigma)
+{
+    typedef typename Array1d::value_type ValueType;
+
+    for (size_t k = 0; k < n; k++)
+    {
+        cusp::multiply(A, u, t);
+        cusp::blas::scal(t, ValueType(1) / sigma);
+        cusp::blas::copy(t, V.column(r_first + k + 1));
+        cusp::multiply(M, t, u);
+        cusp::blas::copy(u, V.column(first + k + 1));
+    }
+}
+
+// element idx = (b * m + a) * N + i of the m x n block product -> b * m + a
+struct s_step_block_index
+{
+    size_t N;
+
+    s_step_block_index(size_t N) : N(N) {}
+
+    __host__ __device__
+    size_t operator()(size_t idx) const { return idx / N; }
+};
+
+// conj(V(i,a)) * V(i,first+b) for element idx = (b * m + a) * N + i
+template <typename ValueType>
+struct s_step_block_product
+{
+    const ValueType * V;
+    size_t N;
+    size_t pitch;
+    size_t m;
+    size_t first;
+
+    s_step_block_product(const ValueType * V, size_t N, size_t pitch, size_t m, size_t first)
+      : V(V), N(N), pitch(pitch), m(m), first(first) {}
+
+    __host__ __device__
+    ValueType operator()(size_t idx) const
+    {
+        cusp::blas::detail::conjugate<ValueType> conj;
+        const size_t key = idx / N;
+        const size_t i = idx - key * N;
+        const size_t a = key % m;
+        const size_t b = key / m;
+        return conj(V[a * pitch + i]) * V[(first + b) * pitch + i];
+    }
+};
+
+// G(a,b) = V(:,a)^H V(:,first+b) for a < m and b < n, stored column-major
+// in the first m * n entries of G, with one reduction over all pairs
+template <typename Array2d, typename Array1d>
+void block_conjugate_transpose(const Array2d& V, const size_t m, const size_t first, const size_t n, Array1d& G)
+{
+    typedef typename Array2d::value_type ValueType;
+
+    const size_t N = V.num_rows;
+
+    thrust::reduce_by_key
+        (thrust::make_transform_iterator(thrust::counting_iterator<size_t>(0), s_step_block_index(N)),
+         thrust::make_transform_iterator(thrust::counting_iterator<size_t>(N * m * n), s_step_block_index(N)),
+         thrust::make_transform_iterator(thrust::counting_iterator<size_t>(0),
+                                         s_step_block_product<ValueType>(thrust::raw_pointer_cast(&V.values[0]),
+                                                                         N, V.pitch, m, first)),
+         thrust::make_discard_iterator(),
+         G.begin());
+}
+
+// row i of V(:,first:first+n) <- (V(:,first:first+n) - V(:,0:m) C) Rinv
+// with C an m x n and Rinv an upper triangular n x n matrix (column-major)
+template <typename ValueType>
+struct s_step_block_update
+{
+    ValueType * V;
+    const ValueType * C;
+    const ValueType * Rinv;
+    size_t pitch;
+    size_t m;
+    size_t first;
+    size_t n;
+
+    s_step_block_update(ValueType * V, const ValueType * C, const ValueType * Rinv,
+                        size_t pitch, size_t m, size_t first, size_t n)
+      : V(V), C(C), Rinv(Rinv), pitch(pitch), m(m), first(first), n(n) {}
+
+    __host__ __device__
+    void operator()(size_t i) const
+    {
+        for (size_t l = 0; l < n; l++)
+        {
+            ValueType y = V[(first + l) * pitch + i];
+            for (size_t a = 0; a < m; a++)
+                y -= V[a * pitch + i] * C[l * m + a];
+            V[(first + l) * pitch + i] = y;
+        }
+
+        // column b only depends on the columns l <= b
+        for (size_t b = n; b-- > 0; )
+        {
+            ValueType y = 0;
+            for (size_t l = 0; l <= b; l++)
+                y += V[(first + l) * pitch + i] * Rinv[b * n + l];
+            V[(first + b) * pitch + i] = y;
+        }
+    }
+};
+
+template <typename Array2d, typename Array1d>
+void block_update(Array2d& V, const size_t m, const size_t first, const size_t n,
+                  const Array1d& C, const Array1d& Rinv)
+{
+    typedef typename Array2d::value_type ValueType;
+
+    thrust::for_each(thrust::counting_iterator<size_t>(0), thrust::counting_iterator<size_t>(V.num_rows),
+                     s_step_block_update<ValueType>(thrust::raw_pointer_cast(&V.values[0]),
+                                                    thrust::raw_pointer_cast(&C[0]),
+                                                    thrust::raw_pointer_cast(&Rinv[0]),
+                                                    V.pitch, m, first, n));
+}
+
+// y[i] <- (accumulate ? y[i] : 0) + sum_k V(i,first+k) c[k] for k < n
+template <typename ValueType>
+struct s_step_block_combination
+{
+    const ValueType * V;
+    const ValueType * c;
+    size_t pitch;
+    size_t first;
+    size_t n;
+    bool accumulate;
+
+    s_step_block_combination(const ValueType * V, const ValueType * c, size_t pitch,
+                             size_t first, size_t n, bool accumulate)
+      : V(V), c(c), pitch(pitch), first(first), n(n), accumulate(accumulate) {}
+
+    template <typename Tuple>
+    __host__ __device__
+    void operator()(Tuple t) const
+    {
+        const size_t i = thrust::get<0>(t);
+        ValueType y = accumulate ? ValueType(thrust::get<1>(t)) : ValueType(0);
+        for (size_t k = 0; k < n; k++)
+            y += V[(first + k) * pitch + i] * c[k];
+        thrust::get<1>(t) = y;
+    }
+};
+
+template <typename Array2d, typename Array1, typename Array2>
+void block_combination(const Array2d& V, const size_t first, const size_t n,
+                       const Array1& c, Array2& y, const bool accumulate)
+{
+    typedef typename Array2d::value_type ValueType;
+
+    thrust::for_each(thrust::make_zip_iterator(thrust::make_tuple(thrust::counting_iterator<size_t>(0), y.begin())),
+                     thrust::make_zip_iterator(thrust::make_tuple(thrust::counting_iterator<size_t>(0), y.begin())) + V.num_rows,
+                     s_step_block_combination<ValueType>(thrust::raw_pointer_cast(&V.values[0]),
+                                                         thrust::raw_pointer_cast(&c[0]),
+                                                         V.pitch, first, n, accumulate));
+}
+
+// real part of a (diagonal) inner product
+inline float  s_step_real(const float x)  { return x; }
+inline double s_step_real(const double x) { return x; }
+
+template <typename T>
+T s_step_real(const cusp::complex<T>& x) { return x.real(); }
+
+// Upper triangular R with R^H R = G - C^H C, where G is the n x n Gram
+// matrix of a block and C (m x n) its projection on an orthonormal basis.
+// Factorization stops at the first column whose remaining norm is lost in
+// rounding, the number of factored columns is returned.
+template <typename ValueType>
+size_t s_step_cholesky(const cusp::array2d<ValueType,cusp::host_memory,cusp::column_major>& G,
+                       const cusp::array2d<ValueType,cusp::host_memory,cusp::column_major>& C,
+                       cusp::array2d<ValueType,cusp::host_memory,cusp::column_major>& R)
+{
+    typedef typename norm_type<ValueType>::type NormType;
+
+    cusp::blas::detail::conjugate<ValueType> conj;
+
+    const size_t m = C.num_rows;
+    const size_t n = G.num_cols;
+    const NormType tolerance = 64 * std::numeric_limits<NormType>::epsilon();
+
+    R.resize(n, n);
+    thrust::fill(R.values.begin(), R.values.end(), ValueType(0));
+
+    for (size_t c = 0; c < n; c++)
+    {
+        for (size_t r = 0; r <= c; r++)
+        {
+            ValueType g = G(r,c);
+            for (size_t a = 0; a < m; a++)
+                g -= conj(C(a,r)) * C(a,c);
+            for (size_t k = 0; k < r; k++)
+                g -= conj(R(k,r)) * R(k,c);
+
+            if (r < c)
+            {
+                R(r,c) = g / R(r,r);
+            }
+            else
+            {
+                const NormType d = s_step_real(g);
+                if (!(d > tolerance * s_step_real(G(c,c))))
+                    return c;
+                R(c,c) = ValueType(std::sqrt(d));
+            }
+        }
+    }
+
+    return n;
+}
+
+// inverse of the leading n x n block of the upper triangular R
+template <typename ValueType>
+void s_step_triangular_inverse(const cusp::array2d<ValueType,cusp::host_memory,cusp::column_major>& R,
+                               const size_t n,
+                               cusp::array2d<ValueType,cusp::host_memory,cusp::column_major>& Rinv)
+{
+    Rinv.resize(n, n);
+    thrust::fill(Rinv.values.begin(), Rinv.values.end(), ValueType(0));
+
+    for (size_t c = 0; c < n; c++)
+    {
+        Rinv(c,c) = ValueType(1) / R(c,c);
+        for (size_t r = c; r-- > 0; )
+        {
+            ValueType y = 0;
+            for (size_t k = r + 1; k <= c; k++)
+                y += R(r,k) * Rinv(k,c);
+            Rinv(r,c) = -y / R(r,r);
+        }
+    }
+}
+
+// One pass of block classical Gram-Schmidt with Cholesky QR: the n columns
+// V(:,m:m+n) are orthogonalized against V(:,0:m) and orthonormalized, so
+// that old = V(:,0:m) C + new R.  All inner products are computed by a
+// single reduction.  Returns the number of columns kept.
+template <typename Array2d, typename Array1d, typename HostArray2d>
+size_t s_step_orthogonalize(Array2d& V, const size_t m, const size_t n,
+                            Array1d& G_dev, Array1d& C_dev, Array1d& Rinv_dev,
+                            HostArray2d& C, HostArray2d& R)
+{
+    typedef typename Array2d::value_type ValueType;
+
+    const size_t L = m + n;
+
+    // [C; G] = V(:,0:m+n)^H V(:,m:m+n)
+    detail::block_conjugate_transpose(V, L, m, n, G_dev);
+
+    cusp::array1d<ValueType,cusp::host_memory> CG(G_dev.begin(), G_dev.begin() + L * n);
+
+    HostArray2d G(n, n);
+    C.resize(m, n);
+
+    for (size_t b = 0; b < n; b++)
+    {
+        for (size_t a = 0; a < m; a++)
+            C(a,b) = CG[b * L + a];
+        for (size_t a = 0; a < n; a++)
+            G(a,b) = CG[b * L + m + a];
+    }
+
+    const size_t k = detail::s_step_cholesky(G, C, R);
+
+    if (k == 0)
+        return 0;
+
+    HostArray2d Rinv;
+    detail::s_step_triangular_inverse(R, k, Rinv);
+
+    thrust::copy(C.values.begin(), C.values.begin() + m * k, C_dev.begin());
+    thrust::copy(Rinv.values.begin(), Rinv.values.end(), Rinv_dev.begin());
+
+    detail::block_update(V, m, m, k, C_dev, Rinv_dev);
+
+    return k;
+}
+
+} // end namespace detail
+} // end namespace krylov
+} // end namespace cusp
+
@@ -0,0 +1,303 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include <cusp/array1d.h>
+#include <cusp/blas.h>
+#include <cusp/multiply.h>
+#include <cusp/monitor.h>
+#include <cusp/linear_operator.h>
+
+#include <cusp/krylov/detail/s_step.h>
+
+#include <thrust/copy.h>
+
+#include <cmath>
+
+namespace blas = cusp::blas;
+
+namespace cusp
+{
+namespace krylov
+{
+namespace detail
+{
+
+// a^H G(:,offset:offset+m) c for the m x m block of a column-major matrix
+template <typename Array1, typename Array2>
+typename Array1::value_type
+s_step_quadratic_form(const Array1& G, const size_t offset, const size_t m, const Array2& a, const Array2& c)
+{
+    typedef typename Array1::value_type ValueType;
+
+    cusp::blas::detail::conjugate<ValueType> conj;
+
+    ValueType sum = 0;
+    for (size_t j = 0; j < m; j++)
+    {
+        ValueType Gc = 0;
+        for (size_t i = 0; i < m; i++)
+            Gc += conj(a[i]) * G[(offset + j) * m + i];
+        sum += Gc * c[j];
+    }
+    return sum;
+}
+
+// v <- sigma B v, where B shifts the coefficients of each monomial block
+template <typename Array, typename ValueType>
+void s_step_cg_shift(const Array& v, Array& Bv, const size_t s, const ValueType sigma)
+{
+    thrust::fill(Bv.begin(), Bv.end(), ValueType(0));
+    for (size_t k = 0; k < s; k++)
+        Bv[k + 1] = sigma * v[k];
+    for (size_t k = 0; k + 1 < s; k++)
+        Bv[s + 2 + k] = sigma * v[s + 1 + k];
+}
+
+template <typename Monitor, typename Array2d, typename HostArray, typename Array, typename NormType>
+bool s_step_cg_finished(Monitor& monitor, const Array2d& Y, const size_t m, const HostArray& r_coef,
+                        Array& c, Array& r, const NormType, thrust::detail::false_type)
+{
+    // form the residual for monitors that only accept vectors
+    thrust::copy(r_coef.begin(), r_coef.end(), c.begin());
+    detail::block_combination(Y, 0, m, c, r, false);
+    return monitor.finished(r);
+}
+
+template <typename Monitor, typename Array2d, typename HostArray, typename Array, typename NormType>
+bool s_step_cg_finished(Monitor& monitor, const Array2d&, const size_t, const HostArray&,
+                        Array&, Array&, const NormType r_norm, thrust::detail::true_type)
+{
+    return monitor.finished(r_norm);
+}
+
+} // end namespace detail
+
+template <class LinearOperator,
+          class Vector>
+void s_step_cg(LinearOperator& A,
+               Vector& x,
+               Vector& b,
+               const size_t s)
+{
+    typedef typename LinearOperator::value_type   ValueType;
+
+    cusp::default_monitor<ValueType> monitor(b);
+
+    cusp::krylov::s_step_cg(A, x, b, s, monitor);
+}
+
+template <class LinearOperator,
+          class Vector,
+          class Monitor>
+void s_step_cg(LinearOperator& A,
+               Vector& x,
+               Vector& b,
+               const size_t s,
+               Monitor& monitor)
+{
+    typedef typename LinearOperator::value_type   ValueType;
+    typedef typename LinearOperator::memory_space MemorySpace;
+
+    cusp::identity_operator<ValueType,MemorySpace> M(A.num_rows, A.num_cols);
+
+    cusp::krylov::s_step_cg(A, x, b, s, monitor, M);
+}
+
+template <class LinearOperator,
+          class Vector,
+          class Monitor,
+          class Preconditioner>
+void s_step_cg(LinearOperator& A,
+               Vector& x,
+               Vector& b,
+               const size_t s,
+               Monitor& monitor,
+               Preconditioner& M)
+{
+    typedef typename LinearOperator::value_type   ValueType;
+    typedef typename LinearOperator::memory_space MemorySpace;
+
+    cusp::krylov::workspace<ValueType,MemorySpace> workspace;
+
+    cusp::krylov::s_step_cg(A, x, b, s, monitor, M, workspace);
+}
+
+template <class LinearOperator,
+          class Vector,
+          class Monitor,
+          class Preconditioner,
+          class Workspace>
+void s_step_cg(LinearOperator& A,
+               Vector& x,
+               Vector& b,
+               const size_t s,
+               Monitor& monitor,
+               Preconditioner& M,
+               Workspace& workspace)
+{
+    CUSP_PROFILE_SCOPED();
+
+    typedef typename LinearOperator::value_type   ValueType;
+    typedef typename norm_type<ValueType>::type   NormType;
+    typedef typename Workspace::vector_type       Array;
+    typedef typename Workspace::matrix_type       Array2d;
+    typedef cusp::array1d<ValueType,cusp::host_memory> HostArray;
+
+    assert(A.num_rows == A.num_cols);        // sanity check
+    assert(s > 0);
+
+    const size_t N = A.num_rows;
+
+    // coefficients of the p-block [0, s] and of the z-block [s+1, 2s]
+    const size_t m = 2 * s + 1;
+
+    // get workspace
+    Array& r = workspace.vector(0, N);
+    Array& z = workspace.vector(1, N);
+    Array& p = workspace.vector(2, N);
+    Array& q = workspace.vector(3, N);   // M^-1 p
+    Array& u = workspace.vector(4, N);
+    Array& t = workspace.vector(5, N);
+    Array& G_dev = workspace.vector(6, 2 * m * m);
+    Array& c_dev = workspace.vector(7, m);
+
+    // Y(:,0:m) holds the images under M^-1 of the bases in Y(:,m:2m)
+    Array2d& Y = workspace.matrix(0, N, 2 * m);
+
+    // r <- b - A*x
+    cusp::multiply(A, x, t);
+    blas::axpby(b, t, r, ValueType(1), ValueType(-1));
+
+    // z <- M*r, p <- z, q <- r
+    cusp::multiply(M, r, z);
+    blas::copy(z, p);
+    blas::copy(r, q);
+
+    // scale of the monomial bases, estimated from ||M A z|| / ||z||
+    cusp::multiply(A, z, t);
+    cusp::multiply(M, t, u);
+    ValueType sigma = blas::nrm2(u) / blas::nrm2(z);
+    if (!(detail::s_step_real(sigma) > 0))
+        sigma = 1;
+
+    HostArray G(2 * m * m);
+    HostArray p_coef(m), r_coef(m), x_coef(m), Bp(m);
+
+    bool done = monitor.finished(r);
+
+    while (!done)
+    {
+        // bases [p, (M A) p, ...] and [z, (M A) z, ...] with their M^-1 images
+        blas::copy(p, Y.column(m));
+        blas::copy(q, Y.column(0));
+        blas::copy(z, Y.column(m + s + 1));
+        blas::copy(r, Y.column(s + 1));
+
+        blas::copy(p, u);
+        detail::matrix_powers(A, M, Y, m, 0, s, u, t, sigma);
+        blas::copy(z, u);
+        detail::matrix_powers(A, M, Y, m + s + 1, s + 1, s - 1, u, t, sigma);
+
+        // [Y_r^H Y_r, Y_r^H Y_z] with a single reduction
+        detail::block_conjugate_transpose(Y, m, 0, 2 * m, G_dev);
+        thrust::copy(G_dev.begin(), G_dev.begin() + 2 * m * m, G.begin());
+
+        // s iterations of CG on the coefficients
+        thrust::fill(p_coef.begin(), p_coef.end(), ValueType(0));
+        thrust::fill(r_coef.begin(), r_coef.end(), ValueType(0));
+        thrust::fill(x_coef.begin(), x_coef.end(), ValueType(0));
+        p_coef[0] = 1;
+        r_coef[s + 1] = 1;
+
+        // rz = <r^H, z>
+        ValueType rz = detail::s_step_quadratic_form(G, m, m, r_coef, r_coef);
+
+        for (size_t j = 0; j < s; j++)
+        {
+            // coefficients of M A p (and of A p in the M^-1 images)
+            detail::s_step_cg_shift(p_coef, Bp, s, sigma);
+
+            // alpha <- <r,z>/<Ap,p>
+            const ValueType pAp = detail::s_step_quadratic_form(G, m, m, Bp, p_coef);
+
+            // the basis lost its rank, restart the block from the current vectors
+            if (j > 0 && !(detail::s_step_real(pAp) > 0))
+                break;
+
+            const ValueType alpha = rz / pAp;
+
+            // x <- x + alpha * p, r <- r - alpha * A p
+            for (size_t k = 0; k < m; k++)
+            {
+                x_coef[k] += alpha * p_coef[k];
+                r_coef[k] -= alpha * Bp[k];
+            }
+
+            ++monitor;
+
+            const NormType r_norm =
+                std::sqrt(abs(detail::s_step_real(detail::s_step_quadratic_form(G, 0, m, r_coef, r_coef))));
+
+            if (detail::s_step_cg_finished(monitor, Y, m, r_coef, c_dev, r, r_norm,
+                                           typename cusp::detail::accepts_residual_norm<Monitor>::type()))
+            {
+                done = true;
+                break;
+            }
+
+            ValueType rz_old = rz;
+
+            // rz = <r^H, z>
+            rz = detail::s_step_quadratic_form(G, m, m, r_coef, r_coef);
+
+            // beta <- <r_{i+1},z_{i+1}>/<r,z>
+            const ValueType beta = rz / rz_old;
+
+            // p <- z + beta*p
+            for (size_t k = 0; k < m; k++)
+                p_coef[k] = r_coef[k] + beta * p_coef[k];
+        }
+
+        // recover the vectors from the bases
+        thrust::copy(x_coef.begin(), x_coef.end(), c_dev.begin());
+        detail::block_combination(Y, m, m, c_dev, x, true);
+
+        if (done)
+            break;
+
+        thrust::copy(r_coef.begin(), r_coef.end(), c_dev.begin());
+        detail::block_combination(Y, 0, m, c_dev, r, false);
+        detail::block_combination(Y, m, m, c_dev, z, false);
+
+        thrust::copy(p_coef.begin(), p_coef.end(), c_dev.begin());
+        detail::block_combination(Y, 0, m, c_dev, q, false);
+        detail::block_combination(Y, m, m, c_dev, p, false);
+
+        // rescale by the growth of the M^-1 images over the block
+        if (s > 1)
+        {
+            const NormType growth =
+                std::pow(detail::s_step_real(G[s * m + s]) / detail::s_step_real(G[m + 1]),
+                         NormType(0.5) / NormType(s - 1));
+            if (growth > 0 && growth < std::numeric_limits<NormType>::max())
+                sigma *= growth;
+        }
+    }
+}
+
+} // end namespace krylov
+} // end namespace cusp
+
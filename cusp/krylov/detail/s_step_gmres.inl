@@ -0,0 +1,302 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include <cusp/array1d.h>
+#include <cusp/array2d.h>
+#include <cusp/blas.h>
+#include <cusp/multiply.h>
+#include <cusp/monitor.h>
+#include <cusp/linear_operator.h>
+
+#include <cusp/krylov/gmres.h>
+#include <cusp/krylov/detail/s_step.h>
+
+#include <thrust/copy.h>
+
+#include <algorithm>
+
+namespace blas = cusp::blas;
+
+namespace cusp
+{
+namespace krylov
+{
+
+template <class LinearOperator,
+          class Vector>
+void s_step_gmres(LinearOperator& A,
+                  Vector& x,
+                  Vector& b,
+                  const size_t restart,
+                  const size_t s)
+{
+    typedef typename LinearOperator::value_type   ValueType;
+
+    cusp::default_monitor<ValueType> monitor(b);
+
+    cusp::krylov::s_step_gmres(A, x, b, restart, s, monitor);
+}
+
+template <class LinearOperator,
+          class Vector,
+          class Monitor>
+void s_step_gmres(LinearOperator& A,
+                  Vector& x,
+                  Vector& b,
+                  const size_t restart,
+                  const size_t s,
+                  Monitor& monitor)
+{
+    typedef typename LinearOperator::value_type   ValueType;
+    typedef typename LinearOperator::memory_space MemorySpace;
+
+    cusp::identity_operator<ValueType,MemorySpace> M(A.num_rows, A.num_cols);
+
+    cusp::krylov::s_step_gmres(A, x, b, restart, s, monitor, M);
+}
+
+template <class LinearOperator,
+          class Vector,
+          class Monitor,
+          class Preconditioner>
+void s_step_gmres(LinearOperator& A,
+                  Vector& x,
+                  Vector& b,
+                  const size_t restart,
+                  const size_t s,
+                  Monitor& monitor,
+                  Preconditioner& M)
+{
+    typedef typename LinearOperator::value_type   ValueType;
+    typedef typename LinearOperator::memory_space MemorySpace;
+
+    cusp::krylov::workspace<ValueType,MemorySpace> workspace;
+
+    cusp::krylov::s_step_gmres(A, x, b, restart, s, monitor, M, workspace);
+}
+
+template <class LinearOperator,
+          class Vector,
+          class Monitor,
+          class Preconditioner,
+          class Workspace>
+void s_step_gmres(LinearOperator& A,
+                  Vector& x,
+                  Vector& b,
+                  const size_t restart,
+                  const size_t s,
+                  Monitor& monitor,
+                  Preconditioner& M,
+                  Workspace& workspace)
+{
+    CUSP_PROFILE_SCOPED();
+
+    typedef typename LinearOperator::value_type   ValueType;
+    typedef typename norm_type<ValueType>::type   NormType;
+    typedef typename Workspace::vector_type       Array1d;
+    typedef typename Workspace::matrix_type       Array2d;
+    typedef cusp::array2d<ValueType,cusp::host_memory,cusp::column_major> HostArray2d;
+
+    assert(A.num_rows == A.num_cols);        // sanity check
+    assert(s > 0);
+
+    const size_t N = A.num_rows;
+    const size_t R = restart;
+
+    cusp::array1d<NormType,cusp::host_memory> resid(1);
+
+    // get workspace
+    Array1d& u = workspace.vector(0, N);
+    Array1d& t = workspace.vector(1, N);
+    Array2d& V = workspace.matrix(0, N, R+1);          // Arnoldi basis
+    Array1d& G_dev    = workspace.vector(2, (R+1) * s); // block inner products
+    Array1d& C_dev    = workspace.vector(3, (R+1) * s); // projection on the basis
+    Array1d& Rinv_dev = workspace.vector(4, s * s);     // inverse Cholesky factor
+    Array1d& s_dev    = workspace.vector(5, R+1);
+
+    // host workspace
+    HostArray2d H(R+1, R);     // Hessenberg matrix, rotated
+    HostArray2d H_raw(R+1, R); // Hessenberg matrix before the rotations
+    cusp::array1d<ValueType,cusp::host_memory> g(R+1);
+    cusp::array1d<ValueType,cusp::host_memory> cs(R);
+    cusp::array1d<ValueType,cusp::host_memory> sn(R);
+
+    HostArray2d C1, R1, C2, R2;
+    HostArray2d C_total, R_total, Hblock;
+    cusp::array1d<ValueType,cusp::host_memory> h;
+
+    do
+    {
+        // u <- M (b - A x), beta <- ||u|| and V(0) <- u / beta
+        cusp::multiply(A, x, t);
+        blas::axpby(b, t, t, ValueType(1), ValueType(-1));
+        cusp::multiply(M, t, u);
+        const NormType beta = blas::nrm2(u);
+
+        resid[0] = beta;
+        if (monitor.finished(resid))
+            break;
+
+        blas::scal(u, ValueType(1.0/beta));
+        blas::copy(u, V.column(0));
+
+        blas::fill(g, ValueType(0));
+        g[0] = beta;
+
+        size_t j = 0;    // V(0:j+1) is orthonormal, H(:,0:j) is known
+        bool done = false;
+
+        while (!done && j < R)
+        {
+            const size_t m = j + 1;
+            size_t n = std::min(s, R - j);
+
+            // V(:,j+1:j+n+1) <- (M A)^k V(:,j) for k = 1 .. n
+            blas::copy(V.column(j), u);
+            detail::matrix_powers(A, M, V, j, n, u, t);
+
+            // block Gram-Schmidt with Cholesky QR, applied twice
+            bool breakdown = false;
+
+            size_t k1 = detail::s_step_orthogonalize(V, m, n, G_dev, C_dev, Rinv_dev, C1, R1);
+            size_t k2 = 0;
+
+            if (k1 > 0)
+                k2 = detail::s_step_orthogonalize(V, m, k1, G_dev, C_dev, Rinv_dev, C2, R2);
+
+            // W(:,1:n+1) = V(:,0:m) C_total + V(:,m:m+n) R_total
+            if (k2 > 0)
+            {
+                n = k2;
+                C_total.resize(m, n);
+                R_total.resize(n, n);
+
+                for (size_t l = 0; l < n; l++)
+                {
+                    for (size_t a = 0; a < m; a++)
+                    {
+                        ValueType c = C1(a,l);
+                        for (size_t q = 0; q <= l; q++)
+                            c += C2(a,q) * R1(q,l);
+                        C_total(a,l) = c;
+                    }
+                    for (size_t r = 0; r < n; r++)
+                    {
+                        ValueType c = 0;
+                        for (size_t q = r; q <= l; q++)
+                            c += R2(r,q) * R1(q,l);
+                        R_total(r,l) = c;
+                    }
+                }
+            }
+            else
+            {
+                // M A V(:,j) lies in the span of the basis: the last column
+                // of H ends with a zero and the residual vanishes
+                breakdown = true;
+                n = 1;
+                C_total.resize(m, 1);
+                R_total.resize(1, 1);
+
+                for (size_t a = 0; a < m; a++)
+                    C_total(a,0) = (k1 > 0) ? C1(a,0) + C2(a,0) * R1(0,0) : C1(a,0);
+                R_total(0,0) = 0;
+            }
+
+            // Hessenberg columns j .. j+n-1 from the change of basis.  With
+            // w_t = (M A)^t V(:,j) the column of V(:,j+t) is
+            //   h_t = (coef(w_{t+1}) - sum_k C(k,t-1) h(V(:,k)) - sum_l R(l,t-1) h_{l+1}) / R(t-1,t-1)
+            const size_t L = m + n;
+            Hblock.resize(L, n);
+            thrust::fill(Hblock.values.begin(), Hblock.values.end(), ValueType(0));
+
+            for (size_t c = 0; c < n; c++)
+            {
+                // coefficients of w_{c+1}
+                h.resize(L);
+                for (size_t r = 0; r < L; r++)
+                    h[r] = (r < m) ? C_total(r,c) : ((r - m <= c) ? R_total(r - m,c) : ValueType(0));
+
+                if (c > 0)
+                {
+                    for (size_t k = 0; k < m; k++)
+                    {
+                        const ValueType coef = C_total(k,c-1);
+                        if (k < j)
+                            for (size_t r = 0; r <= k + 1; r++)
+                                h[r] -= coef * H_raw(r,k);
+                        else
+                            for (size_t r = 0; r < L; r++)
+                                h[r] -= coef * Hblock(r,0);
+                    }
+                    for (size_t l = 0; l + 1 < c; l++)
+                        for (size_t r = 0; r < L; r++)
+                            h[r] -= R_total(l,c-1) * Hblock(r,l+1);
+                    for (size_t r = 0; r < L; r++)
+                        h[r] /= R_total(c-1,c-1);
+                }
+
+                for (size_t r = 0; r < L; r++)
+                    Hblock(r,c) = h[r];
+            }
+
+            for (size_t c = 0; c < n; c++)
+            {
+                const size_t i = j + c;
+
+                for (size_t r = 0; r <= i + 1; r++)
+                {
+                    H_raw(r,i) = Hblock(r,c);
+                    H(r,i)     = Hblock(r,c);
+                }
+
+                PlaneRotation(H, cs, sn, g, int(i));
+
+                ++monitor;
+
+                resid[0] = abs(g[i+1]);
+
+                if (monitor.finished(resid))
+                {
+                    n = c + 1;
+                    done = true;
+                    break;
+                }
+            }
+
+            j += n;
+
+            if (breakdown)
+                done = true;
+        }
+
+        // solve upper triangular system in place
+        for (size_t c = j; c-- > 0; )
+        {
+            g[c] /= H(c,c);
+            for (size_t r = 0; r < c; r++)
+                g[r] -= H(r,c) * g[c];
+        }
+
+        // x <- x + V(:,0:j) g(0:j)
+        blas::copy(g, s_dev);
+        detail::block_combination(V, 0, j, s_dev, x, true);
+    } while (!monitor.finished(resid));
+}
+
+} // end namespace krylov
+} // end namespace cusp
+
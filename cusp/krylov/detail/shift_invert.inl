@@ -0,0 +1,78 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include <cusp/blas.h>
+#include <cusp/exception.h>
+#include <cusp/monitor.h>
+
+#include <cusp/krylov/gmres.h>
+
+namespace cusp
+{
+namespace krylov
+{
+
+template <typename LinearOperator, typename Vector>
+void shift_invert_gmres
+::operator()(LinearOperator& A, Vector& x, Vector& b) const
+{
+    cusp::default_monitor<typename Vector::value_type> monitor(b, iteration_limit, tolerance);
+
+    cusp::krylov::gmres(A, x, b, restart, monitor);
+}
+
+template <typename LinearOperator, typename Solver>
+shift_invert_operator<LinearOperator,Solver>
+::shift_invert_operator(const LinearOperator& A, const value_type sigma, const Solver& solver)
+    : Parent(A.num_rows, A.num_cols, 0),
+      sigma(sigma),
+      shifted(cusp::make_shifted(A, sigma)),
+      solver(solver),
+      b(A.num_rows),
+      z(A.num_rows)
+{
+    if (A.num_rows != A.num_cols)
+        throw cusp::invalid_input_exception("shift_invert_operator requires a square operator");
+}
+
+template <typename LinearOperator, typename Solver>
+template <typename VectorType1, typename VectorType2>
+void shift_invert_operator<LinearOperator,Solver>
+::operator()(const VectorType1& x, VectorType2& y) const
+{
+    CUSP_PROFILE_SCOPED();
+
+    if (x.size() != b.size() || y.size() != z.size())
+        throw cusp::invalid_input_exception("array dimensions do not match the operator");
+
+    cusp::blas::copy(x, b);
+    cusp::blas::fill(z, value_type(0));
+
+    solver(shifted, z, b);
+
+    cusp::blas::copy(z, y);
+}
+
+template <typename LinearOperator, typename Solver>
+typename shift_invert_operator<LinearOperator,Solver>::value_type
+shift_invert_operator<LinearOperator,Solver>
+::eigenvalue(const value_type theta) const
+{
+    return sigma + value_type(1) / theta;
+}
+
+} // end namespace krylov
+} // end namespace cusp
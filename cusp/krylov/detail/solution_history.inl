@@ -0,0 +1,242 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include <cusp/array1d.h>
+#include <cusp/array2d.h>
+#include <cusp/blas.h>
+#include <cusp/multiply.h>
+#include <cusp/monitor.h>
+#include <cusp/linear_operator.h>
+
+#include <cusp/krylov/cg.h>
+#include <cusp/krylov/gmres.h>
+#include <cusp/krylov/detail/block.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace blas = cusp::blas;
+
+namespace cusp
+{
+namespace krylov
+{
+
+template <typename ValueType, typename MemorySpace>
+solution_history<ValueType,MemorySpace>::solution_history(size_t num_solutions, history_guess method)
+    : num_solutions(std::max(num_solutions, size_t(1))), method(method), count(0), newest(0)
+{}
+
+template <typename ValueType, typename MemorySpace>
+template <class LinearOperator,
+          class Vector>
+void solution_history<ValueType,MemorySpace>::initial_guess(LinearOperator& A,
+                                                            Vector& x,
+                                                            Vector& b)
+{
+    CUSP_PROFILE_SCOPED();
+
+    typedef typename norm_type<ValueType>::type   NormType;
+    typedef typename cusp::krylov::workspace<ValueType,MemorySpace>::vector_type Array1d;
+    typedef typename detail::block_view<matrix_type>::type View;
+    typedef cusp::array2d<ValueType,cusp::host_memory,cusp::column_major> HostArray2d;
+    typedef cusp::array1d_view<typename Vector::iterator> VectorView;
+
+    const size_t N = A.num_rows;
+
+    // the solutions of a system of another size are useless
+    if (count == 0 || X.num_rows != N)
+        return;
+
+    // the filled columns are [0, count) whether or not the buffer wrapped
+    View Xm = detail::block_columns(X, 0, count);
+
+    // x as a block of one column, so that x <- X c is a single pass
+    cusp::array2d_view<VectorView,cusp::column_major> xv(N, 1, N, VectorView(x.begin(), x.end()));
+
+    Array1d& G_dev = workspace.vector(0, (count + 1) * (count + 1));
+
+    HostArray2d c(count, 1, ValueType(0));
+
+    if (method == polynomial_extrapolation)
+    {
+        // x <- sum_j (-1)^j binomial(m, j+1) x_{n-j} over the last m solutions
+        NormType binomial = 1;
+
+        for (size_t j = 0; j < count; j++)
+        {
+            binomial = binomial * NormType(count - j) / NormType(j + 1);
+            c((newest + num_solutions - j) % num_solutions, 0) = (j % 2 == 0) ? ValueType(binomial) : ValueType(-binomial);
+        }
+    }
+    else
+    {
+        // Y = [A X, b] and G = Y^H Y hold both sides of the normal
+        // equations (A X)^H A X c = (A X)^H b
+        matrix_type& Y = workspace.matrix(0, N, count + 1);
+        View AXm = detail::block_columns(Y, 0, count);
+        View Ym  = detail::block_columns(Y, 0, count + 1);
+
+        cusp::multiply(A, Xm, AXm);
+        blas::copy(b, Y.column(count));
+
+        HostArray2d G(count + 1, count + 1);
+        detail::block_inner_products(Ym, Ym, G_dev);
+        detail::block_copy_to_host(G_dev, G);
+
+        using std::abs;
+
+        HostArray2d Gm(count, count);
+        NormType scale = 0;
+
+        for (size_t j = 0; j < count; j++)
+        {
+            for (size_t i = 0; i < count; i++)
+                Gm(i,j) = G(i,j);
+
+            c(j,0) = G(j,count);
+            scale = std::max(scale, NormType(abs(G(j,j))));
+        }
+
+        // the history is nearly dependent when the solutions converge,
+        // a small shift keeps the normal equations solvable
+        for (size_t j = 0; j < count; j++)
+            Gm(j,j) += ValueType(NormType(100) * std::numeric_limits<NormType>::epsilon() * scale);
+
+        if (scale == NormType(0) || !detail::block_solve(Gm, c))
+        {
+            // fall back to the last solution
+            for (size_t j = 0; j < count; j++)
+                c(j,0) = ValueType(j == newest ? 1 : 0);
+        }
+    }
+
+    detail::block_copy_to_device(c, G_dev);
+    detail::block_multiply(Xm, G_dev, xv, false);
+}
+
+template <typename ValueType, typename MemorySpace>
+template <class Vector>
+void solution_history<ValueType,MemorySpace>::push(const Vector& x)
+{
+    const size_t N = x.size();
+
+    if (X.num_rows != N || X.num_cols != num_solutions)
+    {
+        X.resize(N, num_solutions);
+        clear();
+    }
+
+    newest = (count == 0) ? 0 : (newest + 1) % num_solutions;
+    count  = std::min(count + 1, num_solutions);
+
+    blas::copy(x, X.column(newest));
+}
+
+template <typename ValueType, typename MemorySpace>
+template <class LinearOperator,
+          class Vector>
+void solution_history<ValueType,MemorySpace>::cg(LinearOperator& A,
+                                                 Vector& x,
+                                                 Vector& b)
+{
+    cusp::default_monitor<ValueType> monitor(b);
+
+    cg(A, x, b, monitor);
+}
+
+template <typename ValueType, typename MemorySpace>
+template <class LinearOperator,
+          class Vector,
+          class Monitor>
+void solution_history<ValueType,MemorySpace>::cg(LinearOperator& A,
+                                                 Vector& x,
+                                                 Vector& b,
+                                                 Monitor& monitor)
+{
+    cusp::identity_operator<ValueType,MemorySpace> M(A.num_rows, A.num_cols);
+
+    cg(A, x, b, monitor, M);
+}
+
+template <typename ValueType, typename MemorySpace>
+template <class LinearOperator,
+          class Vector,
+          class Monitor,
+          class Preconditioner>
+void solution_history<ValueType,MemorySpace>::cg(LinearOperator& A,
+                                                 Vector& x,
+                                                 Vector& b,
+                                                 Monitor& monitor,
+                                                 Preconditioner& M)
+{
+    initial_guess(A, x, b);
+
+    cusp::krylov::cg(A, x, b, monitor, M);
+
+    push(x);
+}
+
+template <typename ValueType, typename MemorySpace>
+template <class LinearOperator,
+          class Vector>
+void solution_history<ValueType,MemorySpace>::gmres(LinearOperator& A,
+                                                    Vector& x,
+                                                    Vector& b,
+                                                    const size_t restart)
+{
+    cusp::default_monitor<ValueType> monitor(b);
+
+    gmres(A, x, b, restart, monitor);
+}
+
+template <typename ValueType, typename MemorySpace>
+template <class LinearOperator,
+          class Vector,
+          class Monitor>
+void solution_history<ValueType,MemorySpace>::gmres(LinearOperator& A,
+                                                    Vector& x,
+                                                    Vector& b,
+                                                    const size_t restart,
+                                                    Monitor& monitor)
+{
+    cusp::identity_operator<ValueType,MemorySpace> M(A.num_rows, A.num_cols);
+
+    gmres(A, x, b, restart, monitor, M);
+}
+
+template <typename ValueType, typename MemorySpace>
+template <class LinearOperator,
+          class Vector,
+          class Monitor,
+          class Preconditioner>
+void solution_history<ValueType,MemorySpace>::gmres(LinearOperator& A,
+                                                    Vector& x,
+                                                    Vector& b,
+                                                    const size_t restart,
+                                                    Monitor& monitor,
+                                                    Preconditioner& M)
+{
+    initial_guess(A, x, b);
+
+    cusp::krylov::gmres(A, x, b, restart, monitor, M);
+
+    push(x);
+}
+
+} // end namespace krylov
+} // end namespace cusp
@@ -0,0 +1,241 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include <cusp/array1d.h>
+#include <cusp/array2d.h>
+#include <cusp/blas.h>
+#include <cusp/exception.h>
+#include <cusp/multiply.h>
+
+#include <cusp/krylov/workspace.h>
+#include <cusp/krylov/detail/block.h>
+#include <cusp/krylov/detail/ritz.h>
+#include <cusp/krylov/detail/s_step.h>
+
+#include <thrust/copy.h>
+#include <thrust/fill.h>
+#include <thrust/sequence.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace blas = cusp::blas;
+
+namespace cusp
+{
+namespace krylov
+{
+namespace detail
+{
+
+// orders the Ritz values with the wanted ones first
+struct eigen_order
+{
+    const cusp::array1d<double,cusp::host_memory>& theta;
+    eigen_target which;
+
+    eigen_order(const cusp::array1d<double,cusp::host_memory>& theta, eigen_target which)
+        : theta(theta), which(which) {}
+
+    bool operator()(const size_t a, const size_t b) const
+    {
+        switch (which)
+        {
+            case smallest_algebraic: return theta[a] < theta[b];
+            case largest_magnitude:  return std::abs(theta[a]) > std::abs(theta[b]);
+            default:                 return theta[a] > theta[b];
+        }
+    }
+};
+
+} // end namespace detail
+
+template <class LinearOperator,
+          class Array1d,
+          class Array2d>
+size_t thick_restart_lanczos(LinearOperator& A,
+                             Array1d& eigenvalues,
+                             Array2d& eigenvectors,
+                             const size_t k,
+                             const eigen_target which,
+                             const double tolerance,
+                             const size_t max_restarts,
+                             const size_t subspace)
+{
+    CUSP_PROFILE_SCOPED();
+
+    typedef typename LinearOperator::value_type                   ValueType;
+    typedef typename LinearOperator::memory_space                 MemorySpace;
+    typedef cusp::krylov::workspace<ValueType,MemorySpace>        Workspace;
+    typedef typename Workspace::vector_type                       WorkArray1d;
+    typedef typename Workspace::matrix_type                       WorkArray2d;
+    typedef typename detail::block_view<WorkArray2d>::type        View;
+    typedef cusp::array2d<ValueType,cusp::host_memory,cusp::column_major> HostArray2d;
+
+    if (A.num_rows != A.num_cols)
+        throw cusp::invalid_input_exception("thick_restart_lanczos requires a square operator");
+
+    const size_t N = A.num_rows;
+
+    if (k == 0 || k > N)
+        throw cusp::invalid_input_exception("number of eigenpairs must be between one and the dimension of the operator");
+
+    // at least one vector beyond the wanted ones, unless the basis spans the space
+    const size_t m = std::min(std::max(subspace == 0 ? std::max(2 * k + 1, size_t(20)) : subspace, k + 1), N);
+
+    Workspace workspace;
+
+    WorkArray2d& V    = workspace.matrix(0, N, m + 1);   // Lanczos basis
+    WorkArray2d& W    = workspace.matrix(1, N, m);       // Ritz vectors
+    WorkArray1d& G_dev    = workspace.vector(0, m + 1);
+    WorkArray1d& C_dev    = workspace.vector(1, m + 1);
+    WorkArray1d& Rinv_dev = workspace.vector(2, 1);
+    WorkArray1d& Y_dev    = workspace.vector(3, m * m);
+
+    HostArray2d C1, R1, C2, R2;
+
+    // projected matrix, its eigenpairs and their order
+    detail::ritz_matrix T(m, m, detail::ritz_complex(0));
+    detail::ritz_matrix S, Y;
+    cusp::array1d<double,cusp::host_memory> theta;
+    cusp::array1d<size_t,cusp::host_memory> order;
+    detail::ritz_demote<ValueType> demote;
+
+    // normalized random start vector
+    detail::block_random_column(V, 0);
+    detail::s_step_orthogonalize(V, 0, 1, G_dev, C_dev, Rinv_dev, C1, R1);
+
+    size_t l         = 0;   // Ritz vectors kept at the last restart
+    size_t n         = m;   // size of the basis
+    size_t converged = 0;
+
+    for (size_t restart = 0; ; restart++)
+    {
+        double beta = 0;
+
+        for (size_t j = l; j < m; j++)
+        {
+            typename WorkArray2d::column_view v  = V.column(j);
+            typename WorkArray2d::column_view Av = V.column(j + 1);
+            cusp::multiply(A, v, Av);
+
+            // A V(:,j) = V(:,0:j+1) h + V(:,j+1) beta, by block classical
+            // Gram-Schmidt applied twice
+            const size_t n1 = detail::s_step_orthogonalize(V, j + 1, 1, G_dev, C_dev, Rinv_dev, C1, R1);
+            const size_t n2 = n1 ? detail::s_step_orthogonalize(V, j + 1, 1, G_dev, C_dev, Rinv_dev, C2, R2) : 0;
+
+            for (size_t i = 0; i <= j; i++)
+                T(i,j) = detail::ritz_promote(n1 ? ValueType(C1(i,0) + C2(i,0) * R1(0,0)) : C1(i,0));
+
+            beta = n2 ? std::abs(detail::ritz_promote(R2(0,0) * R1(0,0))) : 0;
+
+            if (n2 == 0)
+            {
+                // invariant subspace, continue in a random direction orthogonal to it
+                detail::block_random_column(V, j + 1);
+
+                const size_t r1 = detail::s_step_orthogonalize(V, j + 1, 1, G_dev, C_dev, Rinv_dev, C1, R1);
+                const size_t r2 = r1 ? detail::s_step_orthogonalize(V, j + 1, 1, G_dev, C_dev, Rinv_dev, C2, R2) : 0;
+
+                if (r2 == 0 || j + 1 == m)
+                {
+                    // the basis spans an invariant subspace, its Ritz pairs are exact
+                    n = j + 1;
+                    break;
+                }
+            }
+        }
+
+        // Ritz pairs of the Hermitian projected matrix
+        S.resize(n, n);
+        for (size_t b = 0; b < n; b++)
+            for (size_t a = 0; a < n; a++)
+                S(a,b) = T(a,b);
+
+        detail::ritz_hermitian_eigen(S, theta, Y);
+
+        order.resize(n);
+        thrust::sequence(order.begin(), order.end());
+        std::stable_sort(order.begin(), order.end(), detail::eigen_order(theta, which));
+
+        // residual norm of a Ritz pair is beta times the last entry of its vector
+        double theta_max = 0;
+        for (size_t i = 0; i < n; i++)
+            theta_max = std::max(theta_max, std::abs(theta[i]));
+
+        converged = 0;
+        for (size_t i = 0; i < std::min(k, n); i++)
+            if (beta * std::abs(Y(n - 1, order[i])) <= tolerance * theta_max)
+                converged++;
+
+        if (converged == k || restart == max_restarts || n < m)
+            break;
+
+        // keep the wanted Ritz vectors and half of the others, V(:,0:l) <- V(:,0:n) Y(:,order[0:l])
+        l = std::min(k + (n - k) / 2, n - 1);
+
+        HostArray2d Yl(n, l);
+        for (size_t b = 0; b < l; b++)
+            for (size_t a = 0; a < n; a++)
+                Yl(a,b) = demote(Y(a, order[b]));
+
+        detail::block_copy_to_device(Yl, Y_dev);
+
+        View Vn = detail::block_columns(V, 0, n);
+        View Wl = detail::block_columns(W, 0, l);
+        detail::block_multiply(Vn, Y_dev, Wl, false);
+
+        for (size_t b = 0; b < l; b++)
+            blas::copy(W.column(b), V.column(b));
+
+        // the last Lanczos vector continues the basis
+        blas::copy(V.column(n), V.column(l));
+
+        // the projection on the Ritz vectors is diagonal, the couplings of
+        // V(:,l) with them are computed by the next orthogonalization
+        thrust::fill(T.values.begin(), T.values.end(), detail::ritz_complex(0));
+        for (size_t i = 0; i < l; i++)
+            T(i,i) = theta[order[i]];
+    }
+
+    // the wanted Ritz pairs, fewer than k only if rounding ended the basis early
+    const size_t num_pairs = std::min(k, n);
+
+    HostArray2d Yk(n, num_pairs);
+    for (size_t b = 0; b < num_pairs; b++)
+        for (size_t a = 0; a < n; a++)
+            Yk(a,b) = demote(Y(a, order[b]));
+
+    detail::block_copy_to_device(Yk, Y_dev);
+
+    View Vn = detail::block_columns(V, 0, n);
+    View Wk = detail::block_columns(W, 0, num_pairs);
+    detail::block_multiply(Vn, Y_dev, Wk, false);
+
+    eigenvalues.resize(num_pairs);
+    eigenvectors.resize(N, num_pairs);
+
+    for (size_t b = 0; b < num_pairs; b++)
+    {
+        eigenvalues[b] = typename Array1d::value_type(theta[order[b]]);
+        blas::copy(W.column(b), eigenvectors.column(b));
+    }
+
+    return converged;
+}
+
+} // end namespace krylov
+} // end namespace cusp
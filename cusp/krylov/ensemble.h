@@ -0,0 +1,157 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+/*! \file ensemble.h
+ *  \brief Krylov methods for ensembles of systems with a common sparsity pattern
+ */
+
+#pragma once
+
+#include <cusp/detail/config.h>
+
+#include <cusp/ensemble_csr_operator.h>
+#include <cusp/krylov/batched.h>
+#include <cusp/krylov/workspace.h>
+
+namespace cusp
+{
+namespace krylov
+{
+
+/*! \addtogroup iterative_solvers Iterative Solvers
+ *  \addtogroup krylov_methods Krylov Methods
+ *  \ingroup iterative_solvers
+ *  \{
+ */
+
+/*! \p ensemble_cg : Conjugate Gradient method on an ensemble of systems
+ *
+ *  Solves A_e X(:,e) = B(:,e) for every member \c e of \p A, with the
+ *  scalars of each member computed from its own inner products, so every
+ *  member follows the iterates of \p cg on its own system.  Each step is
+ *  one pass over the whole ensemble: one multiply with \p A, one
+ *  reduction per inner product giving the values of all members, and
+ *  one update of each block of vectors.  A member stops as soon as its
+ *  residual satisfies the tolerance of \p monitor while the others go on.
+ *
+ *  Unlike \p batched_cg, which suits many small systems, the systems here
+ *  may be large: the ensemble shares the index arrays of the pattern and
+ *  each step costs a few launches whatever the number of members.
+ *
+ *  \param A ensemble of symmetric, positive-definite matrices
+ *  \param X approximate solutions, row-major, one member per column
+ *  \param B right-hand sides, row-major, one member per column
+ *  \param monitor stopping criteria, receives the per-member results
+ *  \param preconditioner preconditioner of the members
+ *
+ *  \tparam Matrix is an \p ensemble_csr_operator
+ *  \tparam Array2d1 row-major \p array2d
+ *  \tparam Array2d2 row-major \p array2d
+ *  \tparam Monitor is a \p batched_monitor
+ *
+ *  The following code snippet solves 16 scaled Poisson problems.
+ *
+ *  \code
+ *  #include <cusp/ensemble_csr_operator.h>
+ *  #include <cusp/krylov/ensemble.h>
+ *  #include <cusp/gallery/poisson.h>
+ *
+ *  int main(void)
+ *  {
+ *      cusp::csr_matrix<int, float, cusp::device_memory> P;
+ *      cusp::gallery::poisson5pt(P, 100, 100);
+ *
+ *      const size_t E = 16;
+ *      cusp::ensemble_csr_operator<int, float, cusp::device_memory> A(P, E);
+ *
+ *      cusp::array2d<float, cusp::device_memory, cusp::row_major> X(A.num_rows, E, 0);
+ *      cusp::array2d<float, cusp::device_memory, cusp::row_major> B(A.num_rows, E, 1);
+ *
+ *      cusp::krylov::batched_monitor<float> monitor(1000, 1e-6);
+ *      cusp::krylov::ensemble_cg(A, X, B, monitor, cusp::krylov::BATCHED_JACOBI);
+ *
+ *      return monitor.converged() ? 0 : 1;
+ *  }
+ *  \endcode
+ */
+template <class Matrix,
+          class Array2d1,
+          class Array2d2,
+          class Monitor>
+void ensemble_cg(const Matrix& A,
+                 Array2d1& X,
+                 const Array2d2& B,
+                 Monitor& monitor,
+                 const batched_preconditioner preconditioner = BATCHED_IDENTITY);
+
+/*! \p ensemble_cg : Conjugate Gradient method on an ensemble of systems
+ *
+ *  Same as above, with the work vectors taken from \p workspace.
+ */
+template <class Matrix,
+          class Array2d1,
+          class Array2d2,
+          class Monitor,
+          class Workspace>
+void ensemble_cg(const Matrix& A,
+                 Array2d1& X,
+                 const Array2d2& B,
+                 Monitor& monitor,
+                 const batched_preconditioner preconditioner,
+                 Workspace& workspace);
+
+/*! \p ensemble_bicgstab : BiConjugate Gradient Stabilized method on an
+ *  ensemble of systems
+ *
+ *  Solves the nonsymmetric systems of the members of \p A with
+ *  per-member scalars as \p ensemble_cg.  The preconditioner is applied
+ *  from the right.  A member whose iteration breaks down stops without
+ *  converging.
+ */
+template <class Matrix,
+          class Array2d1,
+          class Array2d2,
+          class Monitor>
+void ensemble_bicgstab(const Matrix& A,
+                       Array2d1& X,
+                       const Array2d2& B,
+                       Monitor& monitor,
+                       const batched_preconditioner preconditioner = BATCHED_IDENTITY);
+
+/*! \p ensemble_bicgstab : BiConjugate Gradient Stabilized method on an
+ *  ensemble of systems
+ *
+ *  Same as above, with the work vectors taken from \p workspace.
+ */
+template <class Matrix,
+          class Array2d1,
+          class Array2d2,
+          class Monitor,
+          class Workspace>
+void ensemble_bicgstab(const Matrix& A,
+                       Array2d1& X,
+                       const Array2d2& B,
+                       Monitor& monitor,
+                       const batched_preconditioner preconditioner,
+                       Workspace& workspace);
+/*! \}
+ */
+
+} // end namespace krylov
+} // end namespace cusp
+
+#include <cusp/krylov/detail/ensemble.inl>
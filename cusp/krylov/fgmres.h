@@ -0,0 +1,115 @@
+/*
+ *  Copyright 2011 The Regents of the University of California
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*! \file fgmres.h
+ *  \brief Flexible Generalized Minimum Residual (FGMRES) method
+ */
+
+#pragma once
+
+#include <cusp/detail/config.h>
+
+#include <cusp/krylov/workspace.h>
+
+namespace cusp
+{
+   namespace krylov
+   {
+
+      /*! \addtogroup iterative_solvers Iterative Solvers
+       *  \addtogroup krylov_methods Krylov Methods
+       *  \ingroup iterative_solvers
+       *  \{
+       */
+
+      /*! \p fgmres : Flexible GMRES method
+       *
+       * Solves the nonsymmetric, linear system A x = b without preconditioning.
+       */
+      template <class LinearOperator,
+	        class Vector,
+                class Monitor>
+	void fgmres(LinearOperator& A,
+		    Vector& x,
+		    Vector& b,
+		    const size_t restart,
+		    Monitor& monitor);
+
+      /*! \p fgmres : Flexible GMRES method
+       *
+       * Solves the nonsymmetric, linear system A x = b with right
+       * preconditioner \p M, which may change from one application to the
+       * next.  The preconditioned vectors z_i = M v_i are kept alongside
+       * the Arnoldi basis V and the solution is updated from them, so
+       * \p M may be a K-cycle \p multilevel hierarchy, an inner Krylov
+       * solve with a loose tolerance or any other nonlinear operator.
+       * This costs a second basis of \p restart + 1 vectors.
+       *
+       * The monitor sees the norm of the true (unpreconditioned) residual.
+       *
+       * \param A matrix of the linear system
+       * \param x approximate solution of the linear system
+       * \param b right-hand side of the linear system
+       * \param restart the method every restart inner iterations
+       * \param monitor montiors iteration and determines stopping conditions
+       * \param M preconditioner for A
+       *
+       * \tparam LinearOperator is a matrix or subclass of \p linear_operator
+       * \tparam Vector vector
+       * \tparam Monitor is a monitor such as \p default_monitor or \p verbose_monitor
+       * \tparam Preconditioner is a matrix or subclass of \p linear_operator
+       *
+       *  \see \p gmres
+       */
+      template <class LinearOperator,
+               class Vector,
+               class Monitor,
+               class Preconditioner>
+                  void fgmres(LinearOperator& A,
+                        Vector& x,
+                        Vector& b,
+                        const size_t restart,
+                        Monitor& monitor,
+                        Preconditioner& M);
+
+      /*! \p fgmres : Flexible GMRES method
+       *
+       * Same as above, drawing both bases and the work vectors from
+       * \p workspace so that repeated solves do not allocate device memory.
+       *
+       * \tparam Workspace is a \p cusp::krylov::workspace
+       *
+       *  \see \p workspace
+       */
+      template <class LinearOperator,
+               class Vector,
+               class Monitor,
+               class Preconditioner,
+               class Workspace>
+                  void fgmres(LinearOperator& A,
+                        Vector& x,
+                        Vector& b,
+                        const size_t restart,
+                        Monitor& monitor,
+                        Preconditioner& M,
+                        Workspace& workspace);
+      /*! \}
+      */
+
+   } // end namespace krylov
+} // end namespace cusp
+
+#include <cusp/krylov/detail/fgmres.inl>
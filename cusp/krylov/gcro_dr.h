@@ -0,0 +1,176 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*! \file gcro_dr.h
+ *  \brief GCRO-DR method for sequences of nonsymmetric systems
+ */
+
+#pragma once
+
+#include <cusp/detail/config.h>
+
+#include <cusp/array2d.h>
+#include <cusp/krylov/workspace.h>
+
+namespace cusp
+{
+namespace krylov
+{
+
+/*! \addtogroup iterative_solvers Iterative Solvers
+ *  \addtogroup krylov_methods Krylov Methods
+ *  \ingroup iterative_solvers
+ *  \{
+ */
+
+/*! \p gcro_dr : GCRO with deflated restarting
+ *
+ * Solves a sequence of nonsymmetric linear systems A_i x_i = b_i whose
+ * matrices change slowly.  Like \p gmres the method restarts after
+ * \p restart iterations, but instead of discarding the Krylov basis it
+ * keeps a subspace U of \p num_recycled harmonic Ritz vectors, both
+ * across the restarts of a solve and between calls to \p solve.
+ *
+ * A cycle minimizes the residual over U plus a Krylov space of the
+ * operator projected against C = M A U, so the eigenvalues captured by
+ * U no longer slow down the convergence and the restarts lose far less
+ * than those of GMRES.  At the start of a solve C and U are rebuilt for
+ * the new matrix with one multiplication of A by the block U.
+ *
+ * \tparam ValueType value type of the systems
+ * \tparam MemorySpace memory space of the systems
+ *
+ * \note \p restart must exceed \p num_recycled.  All systems must have
+ * the same size, otherwise call \p clear first.
+ *
+ *  The following code snippet demonstrates how to use \p gcro_dr to
+ *  solve a sequence of systems.
+ *
+ *  \code
+ *  #include <cusp/csr_matrix.h>
+ *  #include <cusp/monitor.h>
+ *  #include <cusp/krylov/gcro_dr.h>
+ *  #include <cusp/gallery/poisson.h>
+ *
+ *  int main(void)
+ *  {
+ *      cusp::csr_matrix<int, float, cusp::device_memory> A;
+ *      cusp::gallery::poisson5pt(A, 100, 100);
+ *
+ *      cusp::array1d<float, cusp::device_memory> x(A.num_rows, 0);
+ *      cusp::array1d<float, cusp::device_memory> b(A.num_rows, 1);
+ *
+ *      // cycles of 30 iterations recycling 10 vectors
+ *      cusp::krylov::gcro_dr<float, cusp::device_memory> solver(30, 10);
+ *
+ *      for (int step = 0; step < 10; step++)
+ *      {
+ *          // ... update the values of A and b ...
+ *
+ *          cusp::default_monitor<float> monitor(b, 1000, 1e-6);
+ *          solver.solve(A, x, b, monitor);
+ *      }
+ *
+ *      return 0;
+ *  }
+ *  \endcode
+ *
+ *  \see \p gmres
+ *  \see \p deflated_cg
+ */
+template <typename ValueType, typename MemorySpace>
+class gcro_dr
+{
+    public:
+    typedef ValueType   value_type;
+    typedef MemorySpace memory_space;
+
+    typedef cusp::array2d<ValueType,MemorySpace,cusp::column_major> matrix_type;
+
+    /*! Construct a solver without a recycled subspace
+     *
+     *  \param restart dimension of the search space of a cycle,
+     *  including the recycled vectors
+     *  \param num_recycled dimension of the recycled subspace
+     */
+    gcro_dr(size_t restart = 30, size_t num_recycled = 10);
+
+    /*! Solve A x = b using the default convergence criteria
+     */
+    template <class LinearOperator,
+              class Vector>
+    void solve(LinearOperator& A,
+               Vector& x,
+               Vector& b);
+
+    /*! Solve A x = b without preconditioning
+     */
+    template <class LinearOperator,
+              class Vector,
+              class Monitor>
+    void solve(LinearOperator& A,
+               Vector& x,
+               Vector& b,
+               Monitor& monitor);
+
+    /*! Solve A x = b with preconditioner \p M and update the recycled
+     *  subspace
+     *
+     * As in \p gmres the preconditioner is applied from the left and the
+     * monitor receives the norms of the preconditioned residuals.
+     *
+     * \param A matrix of the linear system
+     * \param x approximate solution of the linear system
+     * \param b right-hand side of the linear system
+     * \param monitor montiors iteration and determines stopping conditions
+     * \param M preconditioner for A
+     */
+    template <class LinearOperator,
+              class Vector,
+              class Monitor,
+              class Preconditioner>
+    void solve(LinearOperator& A,
+               Vector& x,
+               Vector& b,
+               Monitor& monitor,
+               Preconditioner& M);
+
+    /*! dimension of the current recycled subspace
+     */
+    size_t num_recycled(void) const { return num_recycled_; }
+
+    /*! discard the recycled subspace
+     */
+    void clear(void) { num_recycled_ = 0; }
+
+    protected:
+    size_t restart;
+    size_t max_recycled;
+    size_t num_recycled_;
+
+    // recycled subspace, the leading num_recycled_ columns are used
+    matrix_type U;
+
+    cusp::krylov::workspace<ValueType,MemorySpace> workspace;
+};
+/*! \}
+ */
+
+} // end namespace krylov
+} // end namespace cusp
+
+#include <cusp/krylov/detail/gcro_dr.inl>
+
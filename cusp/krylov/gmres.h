@@ -22,6 +22,8 @@
 
 #include <cusp/detail/config.h>
 
+#include <cusp/krylov/workspace.h>
+
 namespace cusp
 {
    namespace krylov
@@ -33,6 +35,14 @@ namespace cusp
        *  \{
        */
 
+      /*! Orthogonalization of the Arnoldi basis in \p gmres
+       */
+      enum gmres_orthogonalization
+      {
+        MODIFIED_GRAM_SCHMIDT,    //!< one dot product and one axpy per basis vector
+        CLASSICAL_GRAM_SCHMIDT_2  //!< classical Gram-Schmidt applied twice, as two GEMVs over the basis per pass
+      };
+
       /*! \p gmres : GMRES method
        *
        * Solves the nonsymmetric, linear system A x = b
@@ -125,6 +135,38 @@ namespace cusp
                         const size_t restart,
                         Monitor& monitor,
                         Preconditioner& M);
+
+      /*! \p gmres : GMRES method
+       *
+       * Same as above, drawing the Arnoldi basis and work vectors from
+       * \p workspace so that repeated solves do not allocate device memory.
+       *
+       * By default each new basis vector is orthogonalized with classical
+       * Gram-Schmidt and one reorthogonalization (CGS2).  Each pass computes
+       * all projection coefficients with one GEMV over the basis and removes
+       * them with a second one, so an inner iteration transfers one column
+       * of the Hessenberg matrix to the host instead of synchronizing once
+       * per basis vector.  CGS2 is as stable as modified Gram-Schmidt.
+       *
+       * \param orthogonalization orthogonalization of the Arnoldi basis
+       *
+       * \tparam Workspace is a \p cusp::krylov::workspace
+       *
+       *  \see \p workspace
+       */
+      template <class LinearOperator,
+               class Vector,
+               class Monitor,
+               class Preconditioner,
+               class Workspace>
+                  void gmres(LinearOperator& A,
+                        Vector& x,
+                        Vector& b,
+                        const size_t restart,
+                        Monitor& monitor,
+                        Preconditioner& M,
+                        Workspace& workspace,
+                        const gmres_orthogonalization orthogonalization = CLASSICAL_GRAM_SCHMIDT_2);
       /*! \}
       */
 
@@ -0,0 +1,168 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+/*! \file graph_cg.h
+ *  \brief Conjugate Gradient (CG) method replayed as a CUDA Graph
+ */
+
+#pragma once
+
+#include <cusp/detail/config.h>
+
+#include <cusp/krylov/workspace.h>
+
+namespace cusp
+{
+namespace krylov
+{
+
+/*! \addtogroup iterative_solvers Iterative Solvers
+ *  \addtogroup krylov_methods Krylov Methods
+ *  \ingroup iterative_solvers
+ *  \{
+ */
+
+/*! \p graph_cg : Conjugate Gradient method replayed as a CUDA Graph
+ *
+ * Solves the symmetric, positive-definite linear system A x = b
+ * using the default convergence criteria.
+ */
+template <class LinearOperator,
+          class Vector>
+void graph_cg(LinearOperator& A,
+              Vector& x,
+              Vector& b);
+
+/*! \p graph_cg : Conjugate Gradient method replayed as a CUDA Graph
+ *
+ * Solves the symmetric, positive-definite linear system A x = b without preconditioning.
+ */
+template <class LinearOperator,
+          class Vector,
+          class Monitor>
+void graph_cg(LinearOperator& A,
+              Vector& x,
+              Vector& b,
+              Monitor& monitor);
+
+/*! \p graph_cg : Conjugate Gradient method replayed as a CUDA Graph
+ *
+ * Solves the symmetric, positive-definite linear system A x = b
+ * with preconditioner \p M.
+ *
+ * The iteration is that of \p cg, but for device memory the step lengths
+ * \c alpha and \c beta are computed by the device and never return to the
+ * host.  A whole preconditioned iteration is then a fixed sequence of
+ * kernels, which is recorded once as a CUDA Graph and replayed with a
+ * single launch on every later iteration.  The only synchronization per
+ * iteration is the copy of the residual norm for the monitor.  This pays
+ * off when launch overhead dominates, e.g. for systems of up to a few
+ * million rows with a multilevel preconditioner.
+ *
+ * The first iteration runs normally and the second one is captured, so
+ * that \p M may allocate its storage on first use.  Every operation of
+ * \p A and \p M must be legal during stream capture: no synchronization
+ * with the host and no allocations of temporary storage.  If the capture
+ * fails (or the CUDA runtime predates graph support) the iterations run
+ * without a graph.  A \p multilevel preconditioner is recorded into the
+ * iteration, whether or not its own graph capture is enabled.  For host
+ * memory \p graph_cg is the same as \p cg.  Operations are issued on
+ * \p cusp::current_stream().
+ *
+ * \param A matrix of the linear system 
+ * \param x approximate solution of the linear system
+ * \param b right-hand side of the linear system
+ * \param monitor montiors iteration and determines stopping conditions
+ * \param M preconditioner for A
+ *
+ * \tparam LinearOperator is a matrix or subclass of \p linear_operator
+ * \tparam Vector vector
+ * \tparam Monitor is a monitor such as \p default_monitor or \p verbose_monitor
+ * \tparam Preconditioner is a matrix or subclass of \p linear_operator
+ *
+ * \note \p A and \p M must be symmetric and positive-definite.
+ *
+ *  The following code snippet demonstrates how to use \p graph_cg to 
+ *  solve a 1000x1000 Poisson problem with an AMG preconditioner.
+ *
+ *  \code
+ *  #include <cusp/csr_matrix.h>
+ *  #include <cusp/monitor.h>
+ *  #include <cusp/krylov/graph_cg.h>
+ *  #include <cusp/precond/aggregation/smoothed_aggregation.h>
+ *  #include <cusp/gallery/poisson.h>
+ *  
+ *  int main(void)
+ *  {
+ *      cusp::csr_matrix<int, float, cusp::device_memory> A;
+ *      cusp::gallery::poisson5pt(A, 1000, 1000);
+ *
+ *      cusp::array1d<float, cusp::device_memory> x(A.num_rows, 0);
+ *      cusp::array1d<float, cusp::device_memory> b(A.num_rows, 1);
+ *
+ *      cusp::default_monitor<float> monitor(b, 100, 1e-6);
+ *
+ *      cusp::precond::aggregation::smoothed_aggregation<int, float, cusp::device_memory> M(A);
+ *
+ *      cusp::krylov::graph_cg(A, x, b, monitor, M);
+ *
+ *      return 0;
+ *  }
+ *  \endcode
+ 
+ *  \see \p cg
+ *  \see \p default_monitor
+ *  \see \p verbose_monitor
+ *
+ */
+template <class LinearOperator,
+          class Vector,
+          class Monitor,
+          class Preconditioner>
+void graph_cg(LinearOperator& A,
+              Vector& x,
+              Vector& b,
+              Monitor& monitor,
+              Preconditioner& M);
+
+/*! \p graph_cg : Conjugate Gradient method replayed as a CUDA Graph
+ *
+ * Same as above, drawing the work vectors from \p workspace
+ * so that repeated solves do not allocate memory.
+ *
+ * \tparam Workspace is a \p cusp::krylov::workspace
+ *
+ *  \see \p workspace
+ */
+template <class LinearOperator,
+          class Vector,
+          class Monitor,
+          class Preconditioner,
+          class Workspace>
+void graph_cg(LinearOperator& A,
+              Vector& x,
+              Vector& b,
+              Monitor& monitor,
+              Preconditioner& M,
+              Workspace& workspace);
+/*! \}
+ */
+
+} // end namespace krylov
+} // end namespace cusp
+
+#include <cusp/krylov/detail/graph_cg.inl>
@@ -0,0 +1,203 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+/*! \file iterative_refinement.h
+ *  \brief Mixed precision iterative refinement
+ */
+
+#pragma once
+
+#include <cusp/detail/config.h>
+
+#include <cusp/monitor.h>
+#include <cusp/krylov/workspace.h>
+
+namespace cusp
+{
+namespace krylov
+{
+
+/*! \addtogroup iterative_solvers Iterative Solvers
+ *  \addtogroup krylov_methods Krylov Methods
+ *  \ingroup iterative_solvers
+ *  \{
+ */
+
+/*! \p refinement_cg : inner \p cg solve of \p iterative_refinement
+ *
+ * Solves each correction equation with \p cg to a loose relative tolerance.
+ * The work vectors are kept in a \p workspace, so the corrections after the
+ * first one perform no allocations.
+ *
+ * \tparam ValueType value type of the inner solve (e.g. \c float)
+ * \tparam MemorySpace memory space of the inner solve
+ */
+template <typename ValueType, typename MemorySpace>
+struct refinement_cg
+{
+    typedef ValueType   value_type;
+    typedef MemorySpace memory_space;
+
+    size_t    iteration_limit;
+    ValueType relative_tolerance;
+
+    cusp::krylov::workspace<ValueType,MemorySpace> workspace;
+
+    refinement_cg(size_t iteration_limit = 100, ValueType relative_tolerance = 1e-3)
+      : iteration_limit(iteration_limit), relative_tolerance(relative_tolerance) {}
+
+    template <typename LinearOperator, typename Vector, typename Preconditioner>
+    void operator()(LinearOperator& A, Vector& x, Vector& b, Preconditioner& M);
+};
+
+/*! \p refinement_gmres : inner \p gmres solve of \p iterative_refinement
+ *
+ * Solves each correction equation with restarted \p gmres to a loose
+ * relative tolerance, reusing the Arnoldi basis between corrections.
+ *
+ * \tparam ValueType value type of the inner solve (e.g. \c float)
+ * \tparam MemorySpace memory space of the inner solve
+ */
+template <typename ValueType, typename MemorySpace>
+struct refinement_gmres
+{
+    typedef ValueType   value_type;
+    typedef MemorySpace memory_space;
+
+    size_t    restart;
+    size_t    iteration_limit;
+    ValueType relative_tolerance;
+
+    cusp::krylov::workspace<ValueType,MemorySpace> workspace;
+
+    refinement_gmres(size_t restart = 30, size_t iteration_limit = 100, ValueType relative_tolerance = 1e-3)
+      : restart(restart), iteration_limit(iteration_limit), relative_tolerance(relative_tolerance) {}
+
+    template <typename LinearOperator, typename Vector, typename Preconditioner>
+    void operator()(LinearOperator& A, Vector& x, Vector& b, Preconditioner& M);
+};
+
+/*! \p iterative_refinement : mixed precision iterative refinement
+ *
+ * Solves the linear system A x = b by repeatedly computing the residual
+ * r = b - A x with \p A and the vectors in their own (high) precision and
+ * solving the correction equation A_low d = r approximately with
+ * \p refinement_cg in the precision of \p A_low.  Each inner iteration
+ * therefore moves single precision data, while the outer iteration
+ * converges to the accuracy of the high precision residual as long as the
+ * inner solve reduces the residual by some fixed factor.
+ *
+ * \param A matrix of the linear system in high precision
+ * \param A_low the same matrix in low precision
+ * \param x approximate solution of the linear system
+ * \param b right-hand side of the linear system
+ * \param monitor monitors the outer iteration and determines stopping conditions
+ *
+ * \tparam LinearOperator is a matrix or subclass of \p linear_operator
+ * \tparam LowPrecisionOperator is a matrix or subclass of \p linear_operator
+ * \tparam Vector vector
+ * \tparam Monitor is a monitor such as \p default_monitor or \p verbose_monitor
+ *
+ *  The following code snippet demonstrates how to use \p iterative_refinement
+ *  to solve a Poisson problem to double accuracy with single precision CG.
+ *
+ *  \code
+ *  #include <cusp/csr_matrix.h>
+ *  #include <cusp/monitor.h>
+ *  #include <cusp/krylov/iterative_refinement.h>
+ *  #include <cusp/gallery/poisson.h>
+ *
+ *  int main(void)
+ *  {
+ *      cusp::csr_matrix<int, double, cusp::device_memory> A;
+ *      cusp::gallery::poisson5pt(A, 100, 100);
+ *
+ *      cusp::csr_matrix<int, float, cusp::device_memory> A_low(A);
+ *
+ *      cusp::array1d<double, cusp::device_memory> x(A.num_rows, 0);
+ *      cusp::array1d<double, cusp::device_memory> b(A.num_rows, 1);
+ *
+ *      // relative_tolerance = 1e-12, beyond the reach of float
+ *      cusp::default_monitor<double> monitor(b, 50, 1e-12);
+ *
+ *      // inner CG solves reduce the residual by 1e-3 in at most 200 iterations
+ *      cusp::krylov::refinement_cg<float, cusp::device_memory> inner(200, 1e-3);
+ *
+ *      cusp::krylov::iterative_refinement(A, A_low, x, b, monitor, inner);
+ *
+ *      return 0;
+ *  }
+ *  \endcode
+ *
+ *  \see \p refinement_cg
+ *  \see \p refinement_gmres
+ */
+template <class LinearOperator,
+          class LowPrecisionOperator,
+          class Vector,
+          class Monitor>
+void iterative_refinement(LinearOperator& A,
+                          LowPrecisionOperator& A_low,
+                          Vector& x,
+                          Vector& b,
+                          Monitor& monitor);
+
+/*! \p iterative_refinement : mixed precision iterative refinement
+ *
+ * Same as above with the inner solve performed by \p inner, e.g. a
+ * \p refinement_cg or \p refinement_gmres.
+ *
+ * \tparam InnerSolver is a \p refinement_cg, \p refinement_gmres, or any
+ *         functor accepting <tt>(A_low, d, r, M)</tt>
+ */
+template <class LinearOperator,
+          class LowPrecisionOperator,
+          class Vector,
+          class Monitor,
+          class InnerSolver>
+void iterative_refinement(LinearOperator& A,
+                          LowPrecisionOperator& A_low,
+                          Vector& x,
+                          Vector& b,
+                          Monitor& monitor,
+                          InnerSolver& inner);
+
+/*! \p iterative_refinement : mixed precision iterative refinement
+ *
+ * Same as above with the inner solve preconditioned by \p M, which operates
+ * in the precision and memory space of \p A_low.
+ */
+template <class LinearOperator,
+          class LowPrecisionOperator,
+          class Vector,
+          class Monitor,
+          class InnerSolver,
+          class Preconditioner>
+void iterative_refinement(LinearOperator& A,
+                          LowPrecisionOperator& A_low,
+                          Vector& x,
+                          Vector& b,
+                          Monitor& monitor,
+                          InnerSolver& inner,
+                          Preconditioner& M);
+/*! \}
+ */
+
+} // end namespace krylov
+} // end namespace cusp
+
+#include <cusp/krylov/detail/iterative_refinement.inl>
@@ -0,0 +1,136 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*! \file lobpcg.h
+ *  \brief Locally Optimal Block Preconditioned Conjugate Gradient eigensolver
+ */
+
+#pragma once
+
+#include <cusp/detail/config.h>
+
+namespace cusp
+{
+namespace krylov
+{
+
+/*! \addtogroup iterative_solvers Iterative Solvers
+ *  \addtogroup krylov_methods Krylov Methods
+ *  \ingroup iterative_solvers
+ *  \{
+ */
+
+/*! \p lobpcg : LOBPCG eigensolver
+ *
+ * Computes the \p k smallest eigenvalues and their eigenvectors of a
+ * Hermitian positive-definite operator without preconditioning.
+ */
+template <class LinearOperator,
+          class Array1d,
+          class Array2d>
+size_t lobpcg(LinearOperator& A,
+              Array1d& eigenvalues,
+              Array2d& X,
+              const size_t k,
+              const double tolerance = 1e-6,
+              const size_t maxiter = 500);
+
+/*! \p lobpcg : LOBPCG eigensolver
+ *
+ * Computes the \p k smallest eigenvalues and their eigenvectors of a
+ * Hermitian positive-definite operator \p A with preconditioner \p M
+ * (Knyazev's Locally Optimal Block Preconditioned Conjugate Gradient).
+ *
+ * Each iteration applies the Rayleigh-Ritz method to the subspace
+ * spanned by the current block of approximate eigenvectors X, the
+ * preconditioned residuals <tt>W = M (A X - X Lambda)</tt> and the
+ * previous search directions P, and takes the Ritz vectors of the
+ * \p k smallest Ritz values as the new X.  The blocks are orthonormalized
+ * by block classical Gram-Schmidt with Cholesky QR applied twice, whose
+ * inner products are computed by one reduction on the device; the
+ * products A P are updated along with P, so A is applied to \p k
+ * vectors per iteration.
+ *
+ * An eigenpair has converged when the residual norm
+ * <tt>|| A x - lambda x ||</tt> is at most \p tolerance times the
+ * largest Ritz value.
+ *
+ * \param A Hermitian positive-definite matrix or \p linear_operator
+ * \param eigenvalues the \p k smallest eigenvalues in increasing order
+ * \param X the \p k eigenvectors, one per column.  A block of \p k
+ *        linearly independent columns on input is the initial guess,
+ *        otherwise the iteration starts from random vectors.
+ * \param k number of eigenpairs
+ * \param tolerance relative tolerance of the residual norms
+ * \param maxiter maximum number of iterations
+ * \param M Hermitian positive-definite preconditioner for A
+ *
+ * \return the number of converged eigenpairs
+ *
+ * \tparam LinearOperator is a matrix or subclass of \p linear_operator
+ * \tparam Array1d \p array1d of real values
+ * \tparam Array2d column-major \p array2d in the memory space of \p A
+ * \tparam Preconditioner is a matrix or subclass of \p linear_operator
+ *
+ * \throws cusp::invalid_input_exception if \p A is not square, \p k is
+ *         zero or exceeds the dimension of \p A, or the initial guess is
+ *         rank deficient
+ *
+ *  The following code snippet computes the four lowest modes of a
+ *  Poisson problem with a smoothed aggregation preconditioner.
+ *
+ *  \code
+ *  #include <cusp/csr_matrix.h>
+ *  #include <cusp/gallery/poisson.h>
+ *  #include <cusp/krylov/lobpcg.h>
+ *  #include <cusp/precond/aggregation/smoothed_aggregation.h>
+ *
+ *  int main(void)
+ *  {
+ *      cusp::csr_matrix<int, double, cusp::device_memory> A;
+ *      cusp::gallery::poisson5pt(A, 200, 200);
+ *
+ *      cusp::precond::aggregation::smoothed_aggregation<int, double, cusp::device_memory> M(A);
+ *
+ *      cusp::array1d<double, cusp::host_memory> lambda;
+ *      cusp::array2d<double, cusp::device_memory, cusp::column_major> X;
+ *
+ *      size_t converged = cusp::krylov::lobpcg(A, lambda, X, 4, 1e-6, 200, M);
+ *
+ *      return converged == 4 ? 0 : 1;
+ *  }
+ *  \endcode
+ *
+ *  \see \p thick_restart_lanczos
+ */
+template <class LinearOperator,
+          class Array1d,
+          class Array2d,
+          class Preconditioner>
+size_t lobpcg(LinearOperator& A,
+              Array1d& eigenvalues,
+              Array2d& X,
+              const size_t k,
+              const double tolerance,
+              const size_t maxiter,
+              Preconditioner& M);
+/*! \}
+ */
+
+} // end namespace krylov
+} // end namespace cusp
+
+#include <cusp/krylov/detail/lobpcg.inl>
@@ -0,0 +1,214 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+/*! \file pipelined_cg.h
+ *  \brief Pipelined Conjugate Gradient (CG) method
+ */
+
+#pragma once
+
+#include <cusp/detail/config.h>
+
+#include <cusp/krylov/workspace.h>
+#include <cusp/detail/forward_definitions.h>
+
+namespace cusp
+{
+namespace krylov
+{
+
+/*! \addtogroup iterative_solvers Iterative Solvers
+ *  \addtogroup krylov_methods Krylov Methods
+ *  \ingroup iterative_solvers
+ *  \{
+ */
+
+/*! \p pipelined_cg : Pipelined Conjugate Gradient method
+ *
+ * Solves the symmetric, positive-definite linear system A x = b
+ * using the default convergence criteria.
+ */
+template <class LinearOperator,
+          class Vector>
+void pipelined_cg(LinearOperator& A,
+                  Vector& x,
+                  Vector& b);
+
+/*! \p pipelined_cg : Pipelined Conjugate Gradient method
+ *
+ * Solves the symmetric, positive-definite linear system A x = b without preconditioning.
+ */
+template <class LinearOperator,
+          class Vector,
+          class Monitor>
+void pipelined_cg(LinearOperator& A,
+                  Vector& x,
+                  Vector& b,
+                  Monitor& monitor);
+
+/*! \p pipelined_cg : Pipelined Conjugate Gradient method
+ *
+ * Solves the symmetric, positive-definite linear system A x = b
+ * with preconditioner \p M.
+ *
+ * This is the pipelined variant of \p cg due to Ghysels and Vanroose.
+ * All inner products of an iteration are computed by a single reduction
+ * which, for device memory, is issued before the preconditioner and the
+ * matrix-vector product of the same iteration.  The host only waits for the
+ * reduction result while those operations execute, so the latency of the
+ * reduction is hidden behind the SpMV instead of stalling the device.  The
+ * method requires more vector updates per iteration than \p cg (which are
+ * fused into one pass) and can be slightly less stable in finite precision.
+ *
+ * The residual norm passed to the monitor is that of the recurrence
+ * residual, exactly as in \p cg, so the stopping criteria are unchanged.
+ * Operations are issued on \p cusp::current_stream().
+ *
+ * \param A matrix of the linear system 
+ * \param x approximate solution of the linear system
+ * \param b right-hand side of the linear system
+ * \param monitor montiors iteration and determines stopping conditions
+ * \param M preconditioner for A
+ *
+ * \tparam LinearOperator is a matrix or subclass of \p linear_operator
+ * \tparam Vector vector
+ * \tparam Monitor is a monitor such as \p default_monitor or \p verbose_monitor
+ * \tparam Preconditioner is a matrix or subclass of \p linear_operator
+ *
+ * \note \p A and \p M must be symmetric and positive-definite.
+ *
+ *  The following code snippet demonstrates how to use \p pipelined_cg to 
+ *  solve a 10x10 Poisson problem.
+ *
+ *  \code
+ *  #include <cusp/csr_matrix.h>
+ *  #include <cusp/monitor.h>
+ *  #include <cusp/krylov/pipelined_cg.h>
+ *  #include <cusp/gallery/poisson.h>
+ *  
+ *  int main(void)
+ *  {
+ *      // create an empty sparse matrix structure (CSR format)
+ *      cusp::csr_matrix<int, float, cusp::device_memory> A;
+ *
+ *      // initialize matrix
+ *      cusp::gallery::poisson5pt(A, 10, 10);
+ *
+ *      // allocate storage for solution (x) and right hand side (b)
+ *      cusp::array1d<float, cusp::device_memory> x(A.num_rows, 0);
+ *      cusp::array1d<float, cusp::device_memory> b(A.num_rows, 1);
+ *
+ *      // set stopping criteria:
+ *      //  iteration_limit    = 100
+ *      //  relative_tolerance = 1e-6
+ *      cusp::verbose_monitor<float> monitor(b, 100, 1e-6);
+ *
+ *      // set preconditioner (identity)
+ *      cusp::identity_operator<float, cusp::device_memory> M(A.num_rows, A.num_rows);
+ *
+ *      // solve the linear system A x = b
+ *      cusp::krylov::pipelined_cg(A, x, b, monitor, M);
+ *
+ *      return 0;
+ *  }
+ *  \endcode
+ 
+ *  \see \p cg
+ *  \see \p default_monitor
+ *  \see \p verbose_monitor
+ *
+ */
+template <class LinearOperator,
+          class Vector,
+          class Monitor,
+          class Preconditioner>
+void pipelined_cg(LinearOperator& A,
+                  Vector& x,
+                  Vector& b,
+                  Monitor& monitor,
+                  Preconditioner& M);
+
+/*! \p pipelined_cg : Pipelined Conjugate Gradient method
+ *
+ * Same as above, drawing the work vectors from \p workspace
+ * so that repeated solves do not allocate memory.
+ *
+ * \tparam Workspace is a \p cusp::krylov::workspace
+ *
+ *  \see \p workspace
+ */
+template <class LinearOperator,
+          class Vector,
+          class Monitor,
+          class Preconditioner,
+          class Workspace>
+void pipelined_cg(LinearOperator& A,
+                  Vector& x,
+                  Vector& b,
+                  Monitor& monitor,
+                  Preconditioner& M,
+                  Workspace& workspace);
+
+/*! \p pipelined_cg : Pipelined Conjugate Gradient method
+ *
+ * Solves the symmetric, positive-definite linear system A x = b
+ * with a matrix whose rows are distributed across MPI processes.  The
+ * vectors must have the layout of \p A and every process of its
+ * communicator must call the solver.
+ *
+ * The three inner products of an iteration are summed over the processes
+ * by one \c MPI_Iallreduce, which is started before the preconditioner and
+ * the product with \p A and completed after them, so the latency of the
+ * global reduction overlaps with the halo exchange and the local work.
+ * Requires \c __CUSP_USE_MPI__.
+ *
+ *  \see \p mpi_matrix
+ */
+template <class LocalMatrix,
+          class ValueType,
+          class Monitor,
+          class Preconditioner>
+void pipelined_cg(cusp::mpi_matrix<LocalMatrix>& A,
+                  cusp::mpi_array1d<ValueType>& x,
+                  cusp::mpi_array1d<ValueType>& b,
+                  Monitor& monitor,
+                  Preconditioner& M);
+
+/*! \p pipelined_cg : Pipelined Conjugate Gradient method
+ *
+ * Same as above, drawing the work vectors from \p workspace.
+ *
+ *  \see \p mpi_workspace
+ */
+template <class LocalMatrix,
+          class ValueType,
+          class Monitor,
+          class Preconditioner>
+void pipelined_cg(cusp::mpi_matrix<LocalMatrix>& A,
+                  cusp::mpi_array1d<ValueType>& x,
+                  cusp::mpi_array1d<ValueType>& b,
+                  Monitor& monitor,
+                  Preconditioner& M,
+                  cusp::krylov::mpi_workspace<ValueType>& workspace);
+/*! \}
+ */
+
+} // end namespace krylov
+} // end namespace cusp
+
+#include <cusp/krylov/detail/pipelined_cg.inl>
+
@@ -0,0 +1,141 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*! \file s_step_cg.h
+ *  \brief s-step (communication-avoiding) Conjugate Gradient method
+ */
+
+#pragma once
+
+#include <cusp/detail/config.h>
+
+#include <cusp/krylov/workspace.h>
+
+namespace cusp
+{
+namespace krylov
+{
+
+/*! \addtogroup iterative_solvers Iterative Solvers
+ *  \addtogroup krylov_methods Krylov Methods
+ *  \ingroup iterative_solvers
+ *  \{
+ */
+
+/*! \p s_step_cg : s-step Conjugate Gradient method
+ *
+ * Solves the symmetric, positive-definite linear system A x = b
+ * using the default convergence criteria.
+ */
+template <class LinearOperator,
+          class Vector>
+void s_step_cg(LinearOperator& A,
+               Vector& x,
+               Vector& b,
+               const size_t s);
+
+/*! \p s_step_cg : s-step Conjugate Gradient method
+ *
+ * Solves the symmetric, positive-definite linear system A x = b without preconditioning.
+ */
+template <class LinearOperator,
+          class Vector,
+          class Monitor>
+void s_step_cg(LinearOperator& A,
+               Vector& x,
+               Vector& b,
+               const size_t s,
+               Monitor& monitor);
+
+/*! \p s_step_cg : s-step Conjugate Gradient method
+ *
+ * Solves the symmetric, positive-definite linear system A x = b
+ * with preconditioner \p M.
+ *
+ * This is the communication-avoiding variant of \p cg.  Every outer
+ * iteration generates the bases [p, (M A) p, ..., (M A)^s p] and
+ * [z, (M A) z, ..., (M A)^(s-1) z] with the matrix powers kernel, along
+ * with their images under M^-1, and computes all of their inner products
+ * with one block reduction.  The next \p s iterations of \p cg then run
+ * on the host on coefficient vectors of length 2 s + 1, and the solution,
+ * residual and search direction are recovered from the bases in one pass
+ * each.  This replaces the 2 s reductions of \p s iterations of \p cg by
+ * a single one, at the price of about twice the matrix and preconditioner
+ * applications and 4 s + 2 work vectors.
+ *
+ * The bases are monomial, scaled by a running estimate of the spectral
+ * radius of M A.  Their conditioning still grows quickly with \p s, so
+ * \p s should stay small: up to 4 in single precision and up to 8 in
+ * double precision.  The residual norm passed to the monitor is that of
+ * the coefficient recurrence, as in \p cg.
+ *
+ * \param A matrix of the linear system 
+ * \param x approximate solution of the linear system
+ * \param b right-hand side of the linear system
+ * \param s number of iterations per block reduction
+ * \param monitor montiors iteration and determines stopping conditions
+ * \param M preconditioner for A
+ *
+ * \tparam LinearOperator is a matrix or subclass of \p linear_operator
+ * \tparam Vector vector
+ * \tparam Monitor is a monitor such as \p default_monitor or \p verbose_monitor
+ * \tparam Preconditioner is a matrix or subclass of \p linear_operator
+ *
+ * \note \p A and \p M must be symmetric and positive-definite.
+ *
+ *  \see \p cg
+ *  \see \p pipelined_cg
+ *  \see \p s_step_gmres
+ */
+template <class LinearOperator,
+          class Vector,
+          class Monitor,
+          class Preconditioner>
+void s_step_cg(LinearOperator& A,
+               Vector& x,
+               Vector& b,
+               const size_t s,
+               Monitor& monitor,
+               Preconditioner& M);
+
+/*! \p s_step_cg : s-step Conjugate Gradient method
+ *
+ * Same as above, drawing the bases and work vectors from \p workspace
+ * so that repeated solves do not allocate memory.
+ *
+ * \tparam Workspace is a \p cusp::krylov::workspace
+ *
+ *  \see \p workspace
+ */
+template <class LinearOperator,
+          class Vector,
+          class Monitor,
+          class Preconditioner,
+          class Workspace>
+void s_step_cg(LinearOperator& A,
+               Vector& x,
+               Vector& b,
+               const size_t s,
+               Monitor& monitor,
+               Preconditioner& M,
+               Workspace& workspace);
+/*! \}
+ */
+
+} // end namespace krylov
+} // end namespace cusp
+
+#include <cusp/krylov/detail/s_step_cg.inl>
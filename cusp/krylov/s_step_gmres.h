@@ -0,0 +1,141 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*! \file s_step_gmres.h
+ *  \brief s-step (communication-avoiding) GMRES method
+ */
+
+#pragma once
+
+#include <cusp/detail/config.h>
+
+#include <cusp/krylov/workspace.h>
+
+namespace cusp
+{
+namespace krylov
+{
+
+/*! \addtogroup iterative_solvers Iterative Solvers
+ *  \addtogroup krylov_methods Krylov Methods
+ *  \ingroup iterative_solvers
+ *  \{
+ */
+
+/*! \p s_step_gmres : s-step GMRES method
+ *
+ * Solves the nonsymmetric, linear system A x = b
+ * using the default convergence criteria.
+ */
+template <class LinearOperator,
+          class Vector>
+void s_step_gmres(LinearOperator& A,
+                  Vector& x,
+                  Vector& b,
+                  const size_t restart,
+                  const size_t s);
+
+/*! \p s_step_gmres : s-step GMRES method
+ *
+ * Solves the nonsymmetric, linear system A x = b without preconditioning.
+ */
+template <class LinearOperator,
+          class Vector,
+          class Monitor>
+void s_step_gmres(LinearOperator& A,
+                  Vector& x,
+                  Vector& b,
+                  const size_t restart,
+                  const size_t s,
+                  Monitor& monitor);
+
+/*! \p s_step_gmres : s-step GMRES method
+ *
+ * Solves the nonsymmetric, linear system A x = b
+ * with preconditioner \p M.
+ *
+ * This is the communication-avoiding variant of \p gmres.  Each block step
+ * extends the Arnoldi basis by \p s vectors at once: the matrix powers
+ * kernel applies M A to the last basis vector \p s times in a row, and
+ * the new block is orthogonalized against the basis and factored by
+ * Cholesky QR, twice for stability, with one block reduction per pass.
+ * The Hessenberg columns follow from the change of basis on the host.  A
+ * cycle of \p restart iterations therefore needs about 2 * restart / s
+ * global reductions instead of the 2 * restart of \p gmres, which matters
+ * when the reductions are latency bound.
+ *
+ * The block uses the monomial basis, whose conditioning degrades quickly
+ * with its length, so \p s should stay small (4 to 8).  A block is
+ * shortened when its last vectors are numerically dependent on the
+ * others.  The monitor is applied to the residual norm of every column,
+ * so the iteration count matches \p gmres up to rounding.
+ *
+ * \param A matrix of the linear system 
+ * \param x approximate solution of the linear system
+ * \param b right-hand side of the linear system
+ * \param restart the method every restart inner iterations
+ * \param s number of basis vectors generated per block step
+ * \param monitor montiors iteration and determines stopping conditions
+ * \param M preconditioner for A
+ *
+ * \tparam LinearOperator is a matrix or subclass of \p linear_operator
+ * \tparam Vector vector
+ * \tparam Monitor is a monitor such as \p default_monitor or \p verbose_monitor
+ * \tparam Preconditioner is a matrix or subclass of \p linear_operator
+ *
+ *  \see \p gmres
+ *  \see \p s_step_cg
+ */
+template <class LinearOperator,
+          class Vector,
+          class Monitor,
+          class Preconditioner>
+void s_step_gmres(LinearOperator& A,
+                  Vector& x,
+                  Vector& b,
+                  const size_t restart,
+                  const size_t s,
+                  Monitor& monitor,
+                  Preconditioner& M);
+
+/*! \p s_step_gmres : s-step GMRES method
+ *
+ * Same as above, with the basis and the work vectors taken from \p workspace.
+ *
+ * \tparam Workspace is a \p cusp::krylov::workspace
+ *
+ *  \see \p workspace
+ */
+template <class LinearOperator,
+          class Vector,
+          class Monitor,
+          class Preconditioner,
+          class Workspace>
+void s_step_gmres(LinearOperator& A,
+                  Vector& x,
+                  Vector& b,
+                  const size_t restart,
+                  const size_t s,
+                  Monitor& monitor,
+                  Preconditioner& M,
+                  Workspace& workspace);
+/*! \}
+ */
+
+} // end namespace krylov
+} // end namespace cusp
+
+#include <cusp/krylov/detail/s_step_gmres.inl>
@@ -0,0 +1,151 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*! \file shift_invert.h
+ *  \brief Shift-and-invert spectral transformation for the eigensolvers
+ */
+
+#pragma once
+
+#include <cusp/detail/config.h>
+
+#include <cusp/array1d.h>
+#include <cusp/composite_operator.h>
+#include <cusp/linear_operator.h>
+
+namespace cusp
+{
+namespace krylov
+{
+
+/*! \addtogroup iterative_solvers Iterative Solvers
+ *  \addtogroup krylov_methods Krylov Methods
+ *  \ingroup iterative_solvers
+ *  \{
+ */
+
+/*! \p shift_invert_gmres : solves the shifted systems of a
+ *  \p shift_invert_operator with restarted GMRES to a relative
+ *  residual of \p tolerance.
+ */
+struct shift_invert_gmres
+{
+    double tolerance;
+    size_t restart;
+    size_t iteration_limit;
+
+    shift_invert_gmres(const double tolerance = 1e-8,
+                       const size_t restart = 50,
+                       const size_t iteration_limit = 1000)
+        : tolerance(tolerance), restart(restart), iteration_limit(iteration_limit) {}
+
+    template <typename LinearOperator, typename Vector>
+    void operator()(LinearOperator& A, Vector& x, Vector& b) const;
+};
+
+/*! \p shift_invert_operator : the operator <tt>(A - sigma I)^{-1}</tt>
+ *
+ *  Applying the operator solves <tt>(A - sigma I) y = x</tt> with
+ *  \p Solver, a function object called as <tt>solver(S, y, x)</tt> on
+ *  the shifted operator \c S, which may wrap any of the Krylov solvers
+ *  with its own monitor and preconditioner.  The eigenvalues of \p A
+ *  closest to \p sigma become the largest in magnitude, so passing the
+ *  operator to \p thick_restart_lanczos with \p largest_magnitude finds
+ *  interior eigenvalues, which \p eigenvalue maps back to those of \p A.
+ *  The eigenvectors are shared.
+ *
+ *  \p A is referred to and must outlive the operator.  The accuracy of
+ *  the eigenpairs is limited by the tolerance of the inner solves.
+ *
+ *  \tparam LinearOperator type of \c A
+ *  \tparam Solver function object which solves the shifted systems
+ *
+ *  \code
+ *  #include <cusp/csr_matrix.h>
+ *  #include <cusp/gallery/poisson.h>
+ *  #include <cusp/krylov/shift_invert.h>
+ *  #include <cusp/krylov/thick_restart_lanczos.h>
+ *
+ *  int main(void)
+ *  {
+ *      typedef cusp::csr_matrix<int, double, cusp::device_memory> Matrix;
+ *
+ *      Matrix A;
+ *      cusp::gallery::poisson5pt(A, 100, 100);
+ *
+ *      // the four eigenvalues closest to 4
+ *      cusp::krylov::shift_invert_operator<Matrix> S(A, 4.0);
+ *
+ *      cusp::array1d<double, cusp::host_memory> mu;
+ *      cusp::array2d<double, cusp::device_memory, cusp::column_major> V;
+ *
+ *      cusp::krylov::thick_restart_lanczos(S, mu, V, 4, cusp::krylov::largest_magnitude);
+ *
+ *      for (size_t i = 0; i < mu.size(); i++)
+ *          mu[i] = S.eigenvalue(mu[i]);
+ *
+ *      return 0;
+ *  }
+ *  \endcode
+ */
+template <typename LinearOperator, typename Solver = shift_invert_gmres>
+class shift_invert_operator
+  : public cusp::linear_operator<typename LinearOperator::value_type,
+                                 typename LinearOperator::memory_space,
+                                 typename LinearOperator::index_type>
+{
+    typedef cusp::linear_operator<typename LinearOperator::value_type,
+                                  typename LinearOperator::memory_space,
+                                  typename LinearOperator::index_type> Parent;
+    typedef cusp::identity_operator<typename LinearOperator::value_type,
+                                    typename LinearOperator::memory_space,
+                                    typename LinearOperator::index_type> Identity;
+  public:
+    typedef typename LinearOperator::value_type   value_type;
+    typedef typename LinearOperator::memory_space memory_space;
+
+    value_type sigma;
+
+    /*! Construct <tt>(A - sigma I)^{-1}</tt>.
+     *
+     *  \throws cusp::invalid_input_exception if \p A is not square
+     */
+    shift_invert_operator(const LinearOperator& A, const value_type sigma,
+                          const Solver& solver = Solver());
+
+    /*! Compute y = (A - sigma I)^{-1} x.
+     */
+    template <typename VectorType1, typename VectorType2>
+    void operator()(const VectorType1& x, VectorType2& y) const;
+
+    /*! The eigenvalue of \p A of the eigenvalue \p theta of the operator,
+     *  <tt>sigma + 1 / theta</tt>.
+     */
+    value_type eigenvalue(const value_type theta) const;
+
+  private:
+    mutable cusp::sum_operator<LinearOperator,Identity> shifted;
+    mutable Solver solver;
+    mutable cusp::array1d<value_type, memory_space> b;
+    mutable cusp::array1d<value_type, memory_space> z;
+}; // class shift_invert_operator
+/*! \}
+ */
+
+} // end namespace krylov
+} // end namespace cusp
+
+#include <cusp/krylov/detail/shift_invert.inl>
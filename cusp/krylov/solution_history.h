@@ -0,0 +1,224 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*! \file solution_history.h
+ *  \brief Initial guesses from the solutions of previous systems
+ */
+
+#pragma once
+
+#include <cusp/detail/config.h>
+
+#include <cusp/array2d.h>
+#include <cusp/krylov/workspace.h>
+
+namespace cusp
+{
+namespace krylov
+{
+
+/*! \addtogroup iterative_solvers Iterative Solvers
+ *  \addtogroup krylov_methods Krylov Methods
+ *  \ingroup iterative_solvers
+ *  \{
+ */
+
+/*! Initial guesses built by \p solution_history
+ */
+enum history_guess
+{
+  polynomial_extrapolation,  //!< extrapolate the last solutions as a polynomial of the step
+  minimal_residual           //!< minimize the residual over the span of the last solutions
+};
+
+/*! \p solution_history : initial guesses for sequences of systems
+ *
+ * Keeps the last \p num_solutions solutions of a sequence of systems
+ * A_i x_i = b_i, e.g. the time steps of a simulation, as the columns of
+ * a block in the memory space of the systems and starts every solve
+ * from a guess built out of them.
+ *
+ * \p polynomial_extrapolation fits a polynomial through the last m
+ * solutions, taken at equally spaced steps, and evaluates it at the
+ * next step: 2 x_n - x_{n-1} for m = 2, 3 x_n - 3 x_{n-1} + x_{n-2}
+ * for m = 3.  It needs neither A nor b and costs one pass over the
+ * history.
+ *
+ * \p minimal_residual picks the combination X c of the history X
+ * which minimizes || b - A X c ||, so the guess is never worse than
+ * the zero vector and exact whenever b lies in the span of A X.  It
+ * costs one product with A per stored solution, one reduction for all
+ * inner products of the normal equations and one pass to form X c.
+ *
+ * \tparam ValueType value type of the systems
+ * \tparam MemorySpace memory space of the systems
+ *
+ * \note All systems must have the same size, otherwise call \p clear
+ * first.  High order extrapolation amplifies the noise of inexact
+ * solutions, so \p num_solutions should stay small (2 or 3) with
+ * \p polynomial_extrapolation.
+ *
+ *  The following code snippet demonstrates how to use \p solution_history
+ *  to solve a sequence of Poisson problems with slowly changing
+ *  right-hand sides.
+ *
+ *  \code
+ *  #include <cusp/csr_matrix.h>
+ *  #include <cusp/monitor.h>
+ *  #include <cusp/krylov/solution_history.h>
+ *  #include <cusp/gallery/poisson.h>
+ *
+ *  int main(void)
+ *  {
+ *      cusp::csr_matrix<int, float, cusp::device_memory> A;
+ *      cusp::gallery::poisson5pt(A, 100, 100);
+ *
+ *      cusp::array1d<float, cusp::device_memory> x(A.num_rows, 0);
+ *      cusp::array1d<float, cusp::device_memory> b(A.num_rows, 1);
+ *
+ *      // guesses from the span of the last 4 solutions
+ *      cusp::krylov::solution_history<float, cusp::device_memory> history(4);
+ *
+ *      for (int step = 0; step < 10; step++)
+ *      {
+ *          // ... update b ...
+ *
+ *          cusp::default_monitor<float> monitor(b, 1000, 1e-6);
+ *          history.cg(A, x, b, monitor);
+ *      }
+ *
+ *      return 0;
+ *  }
+ *  \endcode
+ *
+ *  \see \p cg
+ *  \see \p gmres
+ *  \see \p deflated_cg
+ */
+template <typename ValueType, typename MemorySpace>
+class solution_history
+{
+    public:
+    typedef ValueType   value_type;
+    typedef MemorySpace memory_space;
+
+    typedef cusp::array2d<ValueType,MemorySpace,cusp::column_major> matrix_type;
+
+    /*! Construct an empty history
+     *
+     *  \param num_solutions number of solutions kept
+     *  \param method how the initial guesses are built
+     */
+    solution_history(size_t num_solutions = 4, history_guess method = minimal_residual);
+
+    /*! x <- initial guess for A x = b, x is left unchanged while the
+     *  history is empty
+     */
+    template <class LinearOperator,
+              class Vector>
+    void initial_guess(LinearOperator& A,
+                       Vector& x,
+                       Vector& b);
+
+    /*! add the solution x to the history, replacing the oldest one when
+     *  the history is full
+     */
+    template <class Vector>
+    void push(const Vector& x);
+
+    /*! Solve A x = b with \p cg from the initial guess and add the
+     *  solution to the history
+     */
+    template <class LinearOperator,
+              class Vector>
+    void cg(LinearOperator& A,
+            Vector& x,
+            Vector& b);
+
+    template <class LinearOperator,
+              class Vector,
+              class Monitor>
+    void cg(LinearOperator& A,
+            Vector& x,
+            Vector& b,
+            Monitor& monitor);
+
+    template <class LinearOperator,
+              class Vector,
+              class Monitor,
+              class Preconditioner>
+    void cg(LinearOperator& A,
+            Vector& x,
+            Vector& b,
+            Monitor& monitor,
+            Preconditioner& M);
+
+    /*! Solve A x = b with \p gmres from the initial guess and add the
+     *  solution to the history
+     */
+    template <class LinearOperator,
+              class Vector>
+    void gmres(LinearOperator& A,
+               Vector& x,
+               Vector& b,
+               const size_t restart);
+
+    template <class LinearOperator,
+              class Vector,
+              class Monitor>
+    void gmres(LinearOperator& A,
+               Vector& x,
+               Vector& b,
+               const size_t restart,
+               Monitor& monitor);
+
+    template <class LinearOperator,
+              class Vector,
+              class Monitor,
+              class Preconditioner>
+    void gmres(LinearOperator& A,
+               Vector& x,
+               Vector& b,
+               const size_t restart,
+               Monitor& monitor,
+               Preconditioner& M);
+
+    /*! number of solutions in the history
+     */
+    size_t size(void) const { return count; }
+
+    /*! discard the history
+     */
+    void clear(void) { count = 0; newest = 0; }
+
+    protected:
+    size_t num_solutions;
+    history_guess method;
+    size_t count;
+    size_t newest;
+
+    // circular buffer of the solutions, column newest is the last one
+    matrix_type X;
+
+    cusp::krylov::workspace<ValueType,MemorySpace> workspace;
+};
+/*! \}
+ */
+
+} // end namespace krylov
+} // end namespace cusp
+
+#include <cusp/krylov/detail/solution_history.inl>
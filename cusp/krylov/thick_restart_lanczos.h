@@ -0,0 +1,126 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*! \file thick_restart_lanczos.h
+ *  \brief Thick-restart Lanczos method for extreme eigenpairs
+ */
+
+#pragma once
+
+#include <cusp/detail/config.h>
+
+namespace cusp
+{
+namespace krylov
+{
+
+/*! \addtogroup iterative_solvers Iterative Solvers
+ *  \addtogroup krylov_methods Krylov Methods
+ *  \ingroup iterative_solvers
+ *  \{
+ */
+
+/*! Eigenvalues sought by \p thick_restart_lanczos
+ */
+enum eigen_target
+{
+  largest_algebraic,   //!< the largest eigenvalues
+  smallest_algebraic,  //!< the smallest eigenvalues
+  largest_magnitude    //!< the eigenvalues of largest magnitude, e.g. with a \p shift_invert_operator
+};
+
+/*! \p thick_restart_lanczos : Thick-restart Lanczos method
+ *
+ * Computes \p k extreme eigenvalues and eigenvectors of a Hermitian
+ * (real symmetric) operator \p A.
+ *
+ * A Lanczos basis of \p subspace vectors is built and the eigenpairs of
+ * the projected matrix are computed on the host.  At a restart the
+ * basis is contracted to the Ritz vectors of the wanted eigenvalues and
+ * about half of the remaining ones, together with the last Lanczos
+ * vector (Wu and Simon), so the Krylov space keeps its information
+ * about the wanted eigenvectors.  Every new Lanczos vector is
+ * reorthogonalized against the whole basis by block classical
+ * Gram-Schmidt applied twice, whose inner products are computed in one
+ * reduction on the device, and the basis is contracted on the device
+ * by one block product.
+ *
+ * An eigenpair has converged when the residual norm
+ * <tt>|| A v - lambda v ||</tt> is at most \p tolerance times the
+ * largest Ritz value in magnitude.
+ *
+ * \param A Hermitian matrix or \p linear_operator
+ * \param eigenvalues the \p k eigenvalues, wanted ones first
+ * \param eigenvectors the \p k eigenvectors, one per column
+ * \param k number of eigenpairs
+ * \param which eigenvalues sought
+ * \param tolerance relative tolerance of the residual norms
+ * \param max_restarts maximum number of restarts
+ * \param subspace size of the Lanczos basis, by default
+ *        <tt>max(2 k + 1, 20)</tt>
+ *
+ * \return the number of converged eigenpairs
+ *
+ * \tparam LinearOperator is a matrix or subclass of \p linear_operator
+ * \tparam Array1d \p array1d of real values
+ * \tparam Array2d column-major \p array2d in the memory space of \p A
+ *
+ * \throws cusp::invalid_input_exception if \p A is not square or \p k
+ *         is zero or exceeds the dimension of \p A
+ *
+ *  The following code snippet computes the five smallest eigenvalues of
+ *  a Poisson matrix.
+ *
+ *  \code
+ *  #include <cusp/csr_matrix.h>
+ *  #include <cusp/gallery/poisson.h>
+ *  #include <cusp/krylov/thick_restart_lanczos.h>
+ *
+ *  int main(void)
+ *  {
+ *      cusp::csr_matrix<int, double, cusp::device_memory> A;
+ *      cusp::gallery::poisson5pt(A, 100, 100);
+ *
+ *      cusp::array1d<double, cusp::host_memory> lambda;
+ *      cusp::array2d<double, cusp::device_memory, cusp::column_major> V;
+ *
+ *      size_t converged = cusp::krylov::thick_restart_lanczos(A, lambda, V, 5, cusp::krylov::smallest_algebraic);
+ *
+ *      return converged == 5 ? 0 : 1;
+ *  }
+ *  \endcode
+ *
+ *  \see \p lobpcg
+ *  \see \p shift_invert_operator
+ */
+template <class LinearOperator,
+          class Array1d,
+          class Array2d>
+size_t thick_restart_lanczos(LinearOperator& A,
+                             Array1d& eigenvalues,
+                             Array2d& eigenvectors,
+                             const size_t k,
+                             const eigen_target which = largest_algebraic,
+                             const double tolerance = 1e-6,
+                             const size_t max_restarts = 100,
+                             const size_t subspace = 0);
+/*! \}
+ */
+
+} // end namespace krylov
+} // end namespace cusp
+
+#include <cusp/krylov/detail/thick_restart_lanczos.inl>
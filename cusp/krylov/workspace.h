@@ -0,0 +1,245 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+/*! \file workspace.h
+ *  \brief Reusable workspace for Krylov solvers
+ */
+
+#pragma once
+
+#include <cusp/detail/config.h>
+
+#include <cusp/array1d.h>
+#include <cusp/array2d.h>
+#include <cusp/distributed_array1d.h>
+
+#include <cassert>
+#include <deque>
+
+namespace cusp
+{
+namespace krylov
+{
+
+/*! \addtogroup iterative_solvers Iterative Solvers
+ *  \addtogroup krylov_methods Krylov Methods
+ *  \ingroup iterative_solvers
+ *  \{
+ */
+
+/*! \p workspace : Temporary storage shared by successive Krylov solves
+ *
+ * Each Krylov solver allocates several work vectors of length \c A.num_rows.
+ * When a \p workspace is passed as the last argument of a solver the vectors
+ * are taken from the workspace instead, and they remain allocated after the
+ * solver returns.  Repeated solves of systems with the same dimensions
+ * therefore perform no device allocations after the first solve.
+ *
+ * A single \p workspace may be used with different solvers and sizes; the
+ * storage grows as needed and is released when the \p workspace is
+ * destroyed or \p release is called.
+ *
+ * \tparam ValueType value type of the work vectors
+ * \tparam MemorySpace memory space of the work vectors
+ *
+ *  The following code snippet demonstrates how to reuse the storage of
+ *  \p cg across many solves.
+ *
+ *  \code
+ *  #include <cusp/csr_matrix.h>
+ *  #include <cusp/monitor.h>
+ *  #include <cusp/krylov/cg.h>
+ *  #include <cusp/krylov/workspace.h>
+ *  #include <cusp/gallery/poisson.h>
+ *
+ *  int main(void)
+ *  {
+ *      cusp::csr_matrix<int, float, cusp::device_memory> A;
+ *      cusp::gallery::poisson5pt(A, 10, 10);
+ *
+ *      cusp::array1d<float, cusp::device_memory> x(A.num_rows, 0);
+ *      cusp::array1d<float, cusp::device_memory> b(A.num_rows, 1);
+ *
+ *      cusp::identity_operator<float, cusp::device_memory> M(A.num_rows, A.num_rows);
+ *      cusp::krylov::workspace<float, cusp::device_memory> workspace;
+ *
+ *      for (int step = 0; step < 1000; step++)
+ *      {
+ *          cusp::default_monitor<float> monitor(b, 100, 1e-6);
+ *          cusp::krylov::cg(A, x, b, monitor, M, workspace);
+ *      }
+ *
+ *      return 0;
+ *  }
+ *  \endcode
+ */
+template <typename ValueType, typename MemorySpace>
+class workspace
+{
+    public:
+    typedef ValueType   value_type;
+    typedef MemorySpace memory_space;
+
+    typedef cusp::array1d<ValueType,MemorySpace>                     vector_type;
+    typedef cusp::array2d<ValueType,MemorySpace,cusp::column_major> matrix_type;
+
+    /*! Return the \p i-th work vector resized to length \p N.
+     *  Storage is only reallocated when \p N exceeds the capacity
+     *  of the vector, and its contents are undefined.
+     */
+    vector_type& vector(size_t i, size_t N)
+    {
+        // std::deque keeps references to existing elements valid
+        while (vectors.size() <= i)
+            vectors.push_back(vector_type());
+
+        // nothing to keep, so growing copies nothing and fills nothing
+        vectors[i].resize(0);
+        vectors[i].resize(N, cusp::uninitialized);
+
+        return vectors[i];
+    }
+
+    /*! Return the \p i-th (column-major) work matrix resized to
+     *  \p num_rows by \p num_cols.  Its columns start at multiples
+     *  of 128 bytes, so column accesses of block kernels are aligned.
+     */
+    matrix_type& matrix(size_t i, size_t num_rows, size_t num_cols)
+    {
+        while (matrices.size() <= i)
+            matrices.push_back(matrix_type());
+
+        matrices[i].resize_pitched(num_rows, num_cols);
+
+        return matrices[i];
+    }
+
+    /*! Free all work vectors and matrices
+     */
+    void release(void)
+    {
+        vectors.clear();
+        matrices.clear();
+    }
+
+    private:
+    std::deque<vector_type> vectors;
+    std::deque<matrix_type> matrices;
+};
+
+/*! \p distributed_workspace : Temporary storage of Krylov solves with
+ * \p distributed_matrix operators
+ *
+ * The work vectors are \p distributed_array1d with the layout given to the
+ * constructor, so their parts are allocated on the devices of the matrix.
+ *
+ * \tparam ValueType value type of the work vectors
+ */
+template <typename ValueType>
+class distributed_workspace
+{
+    public:
+    typedef ValueType                             value_type;
+    typedef cusp::distributed_array1d<ValueType>  vector_type;
+
+    /*! Construct a workspace for vectors with the given layout
+     */
+    distributed_workspace(const cusp::distributed_layout& layout)
+      : layout(layout) {}
+
+    /*! Return the \p i-th work vector.  \p N must equal the size
+     *  of the layout.
+     */
+    vector_type& vector(size_t i, size_t N)
+    {
+        assert(N == layout.size());
+
+        while (vectors.size() <= i)
+            vectors.push_back(vector_type());
+
+        if (vectors[i].layout != layout)
+            vectors[i].resize(layout);
+
+        return vectors[i];
+    }
+
+    /*! Free all work vectors
+     */
+    void release(void)
+    {
+        vectors.clear();
+    }
+
+    private:
+    cusp::distributed_layout layout;
+    std::deque<vector_type> vectors;
+};
+
+/*! \p mpi_workspace : Temporary storage of Krylov solves with
+ * \p mpi_matrix operators
+ *
+ * The work vectors are \p mpi_array1d with the layout given to the
+ * constructor, so each process only allocates its local rows.
+ *
+ * \tparam ValueType value type of the work vectors
+ */
+template <typename ValueType>
+class mpi_workspace
+{
+    public:
+    typedef ValueType                             value_type;
+    typedef cusp::mpi_array1d<ValueType>          vector_type;
+    typedef typename vector_type::layout_type     layout_type;
+
+    /*! Construct a workspace for vectors with the given layout
+     */
+    mpi_workspace(const layout_type& layout)
+      : layout(layout) {}
+
+    /*! Return the \p i-th work vector.  \p N must equal the size
+     *  of the layout.
+     */
+    vector_type& vector(size_t i, size_t N)
+    {
+        assert(N == layout.size());
+
+        while (vectors.size() <= i)
+            vectors.push_back(vector_type());
+
+        if (vectors[i].layout != layout)
+            vectors[i].resize(layout);
+
+        return vectors[i];
+    }
+
+    /*! Free all work vectors
+     */
+    void release(void)
+    {
+        vectors.clear();
+    }
+
+    private:
+    layout_type layout;
+    std::deque<vector_type> vectors;
+};
+/*! \}
+ */
+
+} // end namespace krylov
+} // end namespace cusp
+
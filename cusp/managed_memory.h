@@ -0,0 +1,110 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+/*! \file managed_memory.h
+ *  \brief Prefetch and advice for containers in managed memory
+ */
+
+#pragma once
+
+#include <cusp/detail/config.h>
+
+#include <cusp/memory.h>
+
+namespace cusp
+{
+
+/*! \addtogroup execution Execution
+ *  \{
+ */
+
+/*! \p prefetch : Migrates the storage of an array or a matrix in
+ *  \p managed_memory to the current device, asynchronously on the current
+ *  stream (see \p stream_scope).
+ *
+ * Pages of managed memory otherwise move when a kernel first touches
+ * them, one fault at a time.  \p cusp::multiply prefetches its operands
+ * itself; call \p prefetch after filling a container on the host and
+ * before handing it to other algorithms, e.g. a solver.  Containers in
+ * other memory spaces, views and operators without arrays are ignored,
+ * as are devices which do not support prefetching.
+ *
+ *  \param A array or matrix
+ *
+ *  \code
+ *  #include <cusp/managed_memory.h>
+ *  #include <cusp/csr_matrix.h>
+ *  #include <cusp/krylov/cg.h>
+ *  #include <cusp/gallery/poisson.h>
+ *
+ *  int main(void)
+ *  {
+ *      cusp::csr_matrix<int, float, cusp::managed_memory> A;
+ *      cusp::gallery::poisson5pt(A, 100, 100);
+ *
+ *      // x and b are filled on the host through the managed pointers
+ *      cusp::array1d<float, cusp::managed_memory> x(A.num_rows, 0);
+ *      cusp::array1d<float, cusp::managed_memory> b(A.num_rows, 1);
+ *
+ *      // A is only read by the solver
+ *      cusp::advise_read_mostly(A);
+ *
+ *      cusp::prefetch(A);
+ *      cusp::prefetch(x);
+ *      cusp::prefetch(b);
+ *
+ *      cusp::krylov::cg(A, x, b);
+ *
+ *      // read the solution on the host without faulting page by page
+ *      cusp::prefetch_to_host(x);
+ *  }
+ *  \endcode
+ */
+template <typename ArrayOrMatrix>
+void prefetch(const ArrayOrMatrix& A);
+
+/*! \p prefetch_to_host : Migrates the storage of an array or a matrix in
+ *  \p managed_memory to the host, asynchronously on the current stream.
+ *
+ *  \param A array or matrix
+ *
+ *  \note Synchronize with the stream before reading \p A on the host.
+ */
+template <typename ArrayOrMatrix>
+void prefetch_to_host(const ArrayOrMatrix& A);
+
+/*! \p advise_read_mostly : Advises that the arrays of a matrix in
+ *  \p managed_memory are mostly read.
+ *
+ * Every processor which reads an array advised read-mostly keeps its own
+ * copy of the pages, so a matrix used by kernels and inspected on the
+ * host is not migrated back and forth.  A write invalidates the other
+ * copies, which is correct but slow; advise the matrix once it is
+ * assembled, and clear the advice before modifying it repeatedly.
+ *
+ *  \param A array or matrix
+ *  \param read_mostly set (\c true) or clear (\c false) the advice
+ */
+template <typename ArrayOrMatrix>
+void advise_read_mostly(const ArrayOrMatrix& A, bool read_mostly = true);
+
+/*! \}
+ */
+
+} // end namespace cusp
+
+#include <cusp/detail/managed_memory.inl>
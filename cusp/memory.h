@@ -36,6 +36,19 @@ namespace cusp
   typedef thrust::detail::default_device_space_tag device_memory;
   typedef thrust::any_space_tag                    any_memory;
 #endif
+
+  /*! \p managed_memory : Memory space of unified (managed) memory.
+   *
+   * Containers in \p managed_memory allocate with \c cudaMallocManaged, so
+   * their storage is addressable from the host and from the device and
+   * its pages migrate on demand.  The algorithms treat it as
+   * \p device_memory and run on the device; \p cusp::multiply prefetches
+   * its operands to the device first, and \p cusp::advise_read_mostly
+   * lets the matrix arrays be duplicated on every processor which reads
+   * them (see cusp/managed_memory.h).  Without the CUDA device backend the
+   * containers allocate like \p device_memory.
+   */
+  struct managed_memory : public device_memory {};
    
   template<typename T, typename MemorySpace>
   struct default_memory_allocator;
@@ -0,0 +1,111 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+/*! \file mkl.h
+ *  \brief Host SpMV with the Intel MKL inspector-executor interface
+ */
+
+#pragma once
+
+#include <cusp/detail/config.h>
+
+#include <cusp/csr_matrix.h>
+#include <cusp/linear_operator.h>
+#include <cusp/detail/host/mkl.h>
+
+#if INTEL_MKL_VERSION < 20180000
+#error "cusp/mkl.h requires the inspector-executor interface of MKL 2018 or newer"
+#endif
+
+namespace cusp
+{
+
+/*! \addtogroup sparse_matrices Sparse Matrices
+ */
+
+/*! \addtogroup algorithms Algorithms
+ *  \ingroup sparse_matrices
+ *  \{
+ */
+
+/*! \p mkl_spmv : Host linear operator which multiplies with a matrix
+ *  analyzed by \c mkl_sparse_optimize.
+ *
+ *  A plain \p cusp::multiply with a host matrix already uses MKL when cusp
+ *  is built with \c INTEL_MKL_SPBLAS (scons hostspblas=mkl), but it cannot
+ *  keep the analysis between calls.  This operator stores a CSR copy of the
+ *  matrix and lets MKL choose and prepare a kernel for the expected number
+ *  of SpMVs, which pays off when the same matrix is applied many times, e.g.
+ *  in a Krylov solver.
+ *
+ * \tparam IndexType integer type of the operator dimensions
+ * \tparam ValueType \c float or \c double
+ *
+ *  \code
+ *  #include <cusp/mkl.h>
+ *  #include <cusp/krylov/cg.h>
+ *  #include <cusp/gallery/poisson.h>
+ *
+ *  int main(void)
+ *  {
+ *      cusp::csr_matrix<int, double, cusp::host_memory> A;
+ *      cusp::gallery::poisson5pt(A, 100, 100);
+ *
+ *      cusp::mkl_spmv<int, double> M(A, 1000);
+ *
+ *      cusp::array1d<double, cusp::host_memory> x(A.num_rows, 0);
+ *      cusp::array1d<double, cusp::host_memory> b(A.num_rows, 1);
+ *
+ *      cusp::krylov::cg(M, x, b);
+ *
+ *      return 0;
+ *  }
+ *  \endcode
+ */
+template <typename IndexType, typename ValueType>
+class mkl_spmv : public cusp::linear_operator<ValueType,cusp::host_memory,IndexType>
+{
+    typedef cusp::linear_operator<ValueType,cusp::host_memory,IndexType> Parent;
+
+    cusp::csr_matrix<MKL_INT,ValueType,cusp::host_memory> A;
+    cusp::detail::host::mkl::sparse_matrix handle;
+
+    // not copyable
+    mkl_spmv(const mkl_spmv&);
+    mkl_spmv& operator=(const mkl_spmv&);
+
+    public:
+
+    /*! Construct the operator from a host or device matrix.
+     *
+     * \param matrix input matrix in any format
+     * \param expected_calls number of SpMVs the analysis is tuned for
+     */
+    template <typename MatrixType>
+    mkl_spmv(const MatrixType& matrix, size_t expected_calls = 100);
+
+    /*! Compute y = A * x with the optimized MKL kernel.
+     */
+    template <typename VectorType1, typename VectorType2>
+    void operator()(const VectorType1& x, VectorType2& y) const;
+};
+/*! \}
+ */
+
+} // end namespace cusp
+
+#include <cusp/detail/mkl.inl>
@@ -24,6 +24,9 @@
 
 #include <cusp/blas.h>
 
+#include <thrust/detail/type_traits.h>
+
+#include <cmath>
 #include <limits>
 #include <iostream>
 #include <iomanip>
@@ -123,6 +126,28 @@ class default_monitor
           absolute_tolerance_(absolute_tolerance)
     {}
 
+    /*! restart the monitor for another system with right-hand-side \p b,
+     *  keeping the iteration limit and the tolerances
+     *
+     *  \param b right-hand-side of the next linear system
+     */
+    template <typename Vector>
+    void reset(const Vector& b)
+    {
+        reset(cusp::blas::nrm2(b));
+    }
+
+    /*! restart the monitor for another system whose right-hand-side has
+     *  the precomputed norm \p b_norm, e.g. the nonlinear residual norm
+     *  of a Newton step, which saves a reduction per solve
+     */
+    void reset(const Real& b_norm)
+    {
+        this->b_norm = b_norm;
+        r_norm = std::numeric_limits<Real>::max();
+        iteration_count_ = 0;
+    }
+
     /*! increment the iteration count
      */
     void operator++(void) {  ++iteration_count_; } // prefix increment
@@ -135,7 +160,16 @@ class default_monitor
     template <typename Vector>
     bool finished(const Vector& r)
     {
-        r_norm = cusp::blas::nrm2(r);
+        return finished(cusp::blas::nrm2(r));
+    }
+
+    /*! applies convergence criteria to a residual norm computed by the solver
+     *
+     *  \param residual_norm Euclidean norm of the residual vector
+     */
+    bool finished(const Real& residual_norm)
+    {
+        r_norm = residual_norm;
         
         return converged() || iteration_count() >= iteration_limit();
     }
@@ -175,6 +209,16 @@ class default_monitor
     Real tolerance() const { return absolute_tolerance() + relative_tolerance() * b_norm; }
 
     protected:
+
+    // for monitors which receive ||b|| through reset
+    default_monitor(const Real& b_norm, size_t iteration_limit, Real relative_tolerance, Real absolute_tolerance)
+        : b_norm(b_norm),
+          r_norm(std::numeric_limits<Real>::max()),
+          iteration_limit_(iteration_limit),
+          iteration_count_(0),
+          relative_tolerance_(relative_tolerance),
+          absolute_tolerance_(absolute_tolerance)
+    {}
     
     Real r_norm;
     Real b_norm;
@@ -227,7 +271,12 @@ class verbose_monitor : public default_monitor<ValueType>
     template <typename Vector>
     bool finished(const Vector& r)
     {
-        super::r_norm = cusp::blas::nrm2(r);
+        return finished(cusp::blas::nrm2(r));
+    }
+
+    bool finished(const Real& residual_norm)
+    {
+        super::r_norm = residual_norm;
 
         std::cout << "       "  << std::setw(10) << super::iteration_count();
         std::cout << "       "  << std::setw(10) << std::scientific << super::residual_norm() << std::endl;
@@ -294,7 +343,12 @@ class convergence_monitor : public default_monitor<ValueType>
     template <typename Vector>
     bool finished(const Vector& r)
     {
-        super::r_norm = cusp::blas::nrm2(r);
+        return finished(cusp::blas::nrm2(r));
+    }
+
+    bool finished(const Real& residual_norm)
+    {
+        super::r_norm = residual_norm;
 	residuals.push_back(super::r_norm);
 
         return super::converged() || super::iteration_count() >= super::iteration_limit();
@@ -339,5 +393,128 @@ class convergence_monitor : public default_monitor<ValueType>
 /*! \}
  */
 
+/*! \p interval_monitor is similar to \p default_monitor except that
+ * it only tests the residual every \p check_interval iterations.
+ *
+ * Computing the norm of a residual in device memory returns the result
+ * to the host and therefore waits for every kernel queued by the solver.
+ * Between two tests \p finished returns \c false without touching the
+ * residual, so the kernels of consecutive iterations are queued back to
+ * back.  The solver may run up to <tt>check_interval - 1</tt> iterations
+ * past convergence.
+ *
+ * Residual norms computed by the solver anyway are always tested, as are
+ * residual vectors in host memory, whose norm requires no synchronization.
+ * A solver may also keep the squared residual norm in device memory and
+ * pass it to \p finished_squared_norm, which only reads it on the
+ * iterations that are tested.
+ *
+ * \tparam ValueType scalar type used in the solver (e.g. \c float or \c cusp::complex<double>).
+ *
+ * \see \p default_monitor
+ */
+template <typename ValueType>
+class interval_monitor : public default_monitor<ValueType>
+{
+    typedef typename norm_type<ValueType>::type Real;
+    typedef cusp::default_monitor<ValueType> super;
+
+    public:
+    /*! Construct an \p interval_monitor for a given right-hand-side \p b
+     *
+     *  \param b right-hand-side of the linear system A x = b
+     *  \param iteration_limit maximum number of solver iterations to allow
+     *  \param relative_tolerance determines convergence criteria
+     *  \param absolute_tolerance determines convergence criteria
+     *  \param check_interval number of iterations between two tests of the residual
+     *
+     *  \tparam VectorType vector
+     */
+    template <typename Vector>
+    interval_monitor(const Vector& b, size_t iteration_limit = 500, Real relative_tolerance = 1e-5, Real absolute_tolerance = 0,
+                     size_t check_interval = 10)
+        : super(b, iteration_limit, relative_tolerance, absolute_tolerance),
+          check_interval_(check_interval > 0 ? check_interval : 1)
+    {}
+
+    /*! applies convergence criteria to the residual vector \p r if the
+     *  current iteration is tested
+     */
+    template <typename Vector>
+    bool finished(const Vector& r)
+    {
+        typedef typename thrust::detail::is_convertible<typename Vector::memory_space, cusp::host_memory>::type on_host;
+
+        if (!on_host::value && !is_check_iteration())
+            return false;
+
+        return finished(cusp::blas::nrm2(r));
+    }
+
+    /*! applies convergence criteria to a residual norm computed by the solver
+     */
+    bool finished(const Real& residual_norm)
+    {
+        return super::finished(residual_norm);
+    }
+
+    /*! applies convergence criteria to the squared residual norm <r,r>
+     *  held by the first entry of \p squared_norm if the current iteration
+     *  is tested.  \p squared_norm may reside in device memory.
+     */
+    template <typename Array>
+    bool finished_squared_norm(const Array& squared_norm)
+    {
+        if (!is_check_iteration())
+            return false;
+
+        using std::abs;
+        using std::sqrt;
+
+        const typename Array::value_type rr = squared_norm[0];
+
+        return finished(Real(sqrt(abs(rr))));
+    }
+
+    /*! whether the residual is tested at the current iteration
+     */
+    bool is_check_iteration() const
+    {
+        return super::iteration_count() % check_interval_ == 0 ||
+               super::iteration_count() >= super::iteration_limit();
+    }
+
+    /*! number of iterations between two tests of the residual
+     */
+    size_t check_interval() const { return check_interval_; }
+
+    protected:
+    size_t check_interval_;
+};
+/*! \}
+ */
+
+namespace detail
+{
+
+// monitors whose finished() also accepts a precomputed residual norm,
+// which allows solvers to fuse the norm computation with other updates
+template <typename Monitor>
+struct accepts_residual_norm : thrust::detail::false_type {};
+
+template <typename ValueType>
+struct accepts_residual_norm< cusp::default_monitor<ValueType> > : thrust::detail::true_type {};
+
+template <typename ValueType>
+struct accepts_residual_norm< cusp::verbose_monitor<ValueType> > : thrust::detail::true_type {};
+
+template <typename ValueType>
+struct accepts_residual_norm< cusp::convergence_monitor<ValueType> > : thrust::detail::true_type {};
+
+template <typename ValueType>
+struct accepts_residual_norm< cusp::interval_monitor<ValueType> > : thrust::detail::true_type {};
+
+} // end namespace detail
+
 } // end namespace cusp
 
@@ -0,0 +1,209 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*! \file mpi_array1d.h
+ *  \brief One-dimensional array partitioned across MPI processes
+ */
+
+#pragma once
+
+#include <cusp/detail/config.h>
+
+#include <cusp/array1d.h>
+#include <cusp/memory.h>
+
+#include <cusp/detail/mpi.h>
+
+#include <vector>
+
+namespace cusp
+{
+
+/*! \addtogroup distributed_containers Distributed Containers
+ *  \{
+ */
+
+/*! \p mpi_layout : Partition of the rows [0, N) into contiguous parts
+ * which are each owned by one process of an MPI communicator.
+ *
+ * The process of rank \c r owns the rows <tt>[offsets[r], offsets[r+1])</tt>
+ * and stores them on its current device.  Unlike \p distributed_layout,
+ * which places every part in one process, each process only holds its own
+ * rows, so the layer scales across nodes.
+ *
+ * \note The containers require an MPI library and are only available
+ *       when \c __CUSP_USE_MPI__ is defined.  The halo exchange passes
+ *       device pointers to MPI when the library is CUDA-aware (detected
+ *       through \c MPIX_Query_cuda_support, or forced by defining
+ *       \c __CUSP_MPI_CUDA_AWARE__) and stages the messages on the host
+ *       otherwise.
+ */
+struct mpi_layout
+{
+    /*! communicator of the processes
+     */
+    MPI_Comm comm;
+
+    /*! rank of this process in \c comm
+     */
+    int rank;
+
+    /*! first row of each process followed by the total number of rows
+     */
+    std::vector<size_t> offsets;
+
+    /*! Construct an empty layout.
+     */
+    mpi_layout(void)
+      : comm(MPI_COMM_NULL), rank(0), offsets(1, 0) {}
+
+    /*! Collect the numbers of rows owned by the processes of \p comm.
+     *  Every process of \p comm must call the constructor.
+     *
+     *  \param comm Communicator of the processes.
+     *  \param num_local_rows Number of rows owned by this process.
+     */
+    mpi_layout(MPI_Comm comm, size_t num_local_rows);
+
+    /*! Number of processes.
+     */
+    size_t num_ranks(void) const { return offsets.size() - 1; }
+
+    /*! Total number of rows.
+     */
+    size_t size(void) const { return offsets.back(); }
+
+    /*! Number of rows owned by this process.
+     */
+    size_t local_size(void) const { return offsets[rank + 1] - offsets[rank]; }
+
+    /*! First row owned by this process.
+     */
+    size_t first_row(void) const { return offsets[rank]; }
+
+    /*! Rank which owns row \p i.
+     */
+    int owner(size_t i) const;
+
+    bool operator==(const mpi_layout& other) const
+    {
+      return comm == other.comm && rank == other.rank && offsets == other.offsets;
+    }
+
+    bool operator!=(const mpi_layout& other) const
+    {
+      return !(*this == other);
+    }
+};
+
+/*! Split \p N rows between the processes of \p comm such that the
+ *  numbers of rows differ by at most one.  Needs no communication.
+ */
+inline mpi_layout mpi_uniform_layout(MPI_Comm comm, size_t N);
+
+/*! \p mpi_array1d : One-dimensional array whose rows are split between
+ * the processes of an MPI communicator according to an \p mpi_layout.
+ * Each process stores its rows in a \p cusp::array1d on its current
+ * device.
+ *
+ * The \p cusp::blas functions accept arrays with identical layouts.  The
+ * element-wise operations only touch the local rows, and reductions such
+ * as \p cusp::blas::dot sum the local results of all processes with
+ * \c MPI_Allreduce, so they are collective.
+ *
+ * \tparam ValueType Type of the elements (e.g. \c float).
+ *
+ *  The following code snippet demonstrates how to distribute a vector
+ *  between the processes of \c MPI_COMM_WORLD.
+ *
+ *  \code
+ *  #include <cusp/mpi_array1d.h>
+ *  #include <cusp/blas.h>
+ *  ...
+ *
+ *  cusp::mpi_layout layout = cusp::mpi_uniform_layout(MPI_COMM_WORLD, 1000000);
+ *
+ *  // the local rows of every process are set to 2
+ *  cusp::mpi_array1d<float> x(layout, 2.0f);
+ *
+ *  // collective: every process obtains the same norm
+ *  float norm = cusp::blas::nrm2(x);
+ *  \endcode
+ */
+template <typename ValueType>
+class mpi_array1d
+{
+    public:
+    typedef ValueType                                     value_type;
+    typedef cusp::device_memory                           memory_space;
+    typedef cusp::array1d<ValueType,cusp::device_memory>  local_array_type;
+    typedef cusp::mpi_layout                              layout_type;
+
+    /*! partition of the rows
+     */
+    cusp::mpi_layout layout;
+
+    /*! rows owned by this process
+     */
+    local_array_type local;
+
+    /*! Construct an empty array.
+     */
+    mpi_array1d(void) {}
+
+    /*! Construct an array with the given layout.
+     */
+    mpi_array1d(const cusp::mpi_layout& layout);
+
+    /*! Construct an array with the given layout whose elements are
+     *  set to \p value.
+     */
+    mpi_array1d(const cusp::mpi_layout& layout, const ValueType& value);
+
+    /*! Construct an array with the given layout from the local rows,
+     *  a host or device array of length <tt>layout.local_size()</tt>.
+     */
+    template <typename Array>
+    mpi_array1d(const cusp::mpi_layout& layout, const Array& local_rows);
+
+    /*! Total number of elements.
+     */
+    size_t size(void) const { return layout.size(); }
+
+    /*! Number of elements owned by this process.
+     */
+    size_t local_size(void) const { return local.size(); }
+
+    /*! Reallocate the local rows for a new layout.  The values are not preserved.
+     */
+    void resize(const cusp::mpi_layout& layout);
+
+    /*! Collect all elements into a host or device array on every process.
+     *  \p x is resized to \p size().  Collective.
+     */
+    template <typename Array>
+    void gather(Array& x) const;
+
+    /*! Swap the contents of two arrays.
+     */
+    void swap(mpi_array1d& x);
+}; // class mpi_array1d
+/*! \}
+ */
+
+} // end namespace cusp
+
+#include <cusp/detail/mpi_array1d.inl>
@@ -0,0 +1,220 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*! \file mpi_matrix.h
+ *  \brief Sparse matrix partitioned by rows across MPI processes
+ */
+
+#pragma once
+
+#include <cusp/detail/config.h>
+
+#include <cusp/array1d.h>
+#include <cusp/coo_matrix.h>
+#include <cusp/linear_operator.h>
+#include <cusp/mpi_array1d.h>
+
+#include <cuda_runtime_api.h>
+
+#include <vector>
+
+namespace cusp
+{
+
+/*! \addtogroup distributed_containers Distributed Containers
+ *  \{
+ */
+
+/*! \p mpi_matrix : Square sparse matrix whose rows are partitioned across
+ * the processes of an MPI communicator according to an \p mpi_layout.  The
+ * columns are partitioned like the rows.
+ *
+ * Every process assembles its own rows, with global column indices, and
+ * the constructor splits them into two blocks on the current device.  The
+ * \c interior block holds the entries whose columns are owned by the same
+ * process and is stored in the \p LocalMatrix format.  The \c boundary
+ * block holds the remaining entries in a \p coo_matrix whose columns index
+ * the \c halo vector.  \c ghost_columns maps each entry of the halo to its
+ * global column, in increasing order, so the ghosts owned by one neighbour
+ * are contiguous.
+ *
+ * The constructor exchanges the ghost lists once to learn which local rows
+ * each neighbour needs, and creates persistent MPI requests for the
+ * messages of the halo exchange.  The product <tt>y = A * x</tt> then
+ * starts the receives, gathers the rows requested by the neighbours on a
+ * second stream, starts the sends and multiplies the interior block while
+ * the messages are in flight.  Once they have arrived the product of the
+ * boundary block is added.  With a CUDA-aware MPI library the messages are
+ * sent from and received into device memory; otherwise they are staged
+ * through host buffers.
+ *
+ * \tparam LocalMatrix Device matrix type of the interior block
+ *         (e.g. <tt>cusp::hyb_matrix<int,float,cusp::device_memory></tt>).
+ *
+ * \note The constructor and the product are collective over the
+ *       communicator of the layout, which is duplicated so that the
+ *       messages of different matrices never match each other.
+ * \note \p cusp::krylov::cg and \p cusp::krylov::pipelined_cg accept an
+ *       \p mpi_matrix together with \p mpi_array1d vectors, and
+ *       \p cusp::precond::aggregation::mpi_smoothed_aggregation provides a
+ *       matching preconditioner.
+ *
+ *  The following code snippet demonstrates how to solve a Poisson problem
+ *  assembled by rows on every process.
+ *
+ *  \code
+ *  #include <cusp/hyb_matrix.h>
+ *  #include <cusp/mpi_matrix.h>
+ *  #include <cusp/krylov/cg.h>
+ *  ...
+ *
+ *  cusp::mpi_layout layout = cusp::mpi_uniform_layout(MPI_COMM_WORLD, N);
+ *
+ *  // rows [layout.first_row(), layout.first_row() + layout.local_size())
+ *  // of the matrix, with global column indices in [0, N)
+ *  cusp::csr_matrix<int,float,cusp::host_memory> A_local = ...;
+ *
+ *  cusp::mpi_matrix< cusp::hyb_matrix<int,float,cusp::device_memory> > A(A_local, layout);
+ *
+ *  cusp::mpi_array1d<float> x(layout, 0.0f);
+ *  cusp::mpi_array1d<float> b(layout, 1.0f);
+ *
+ *  cusp::default_monitor<float> monitor(b, 1000, 1e-6);
+ *  cusp::krylov::cg(A, x, b, monitor);
+ *  \endcode
+ */
+template <typename LocalMatrix>
+class mpi_matrix
+  : public cusp::linear_operator<typename LocalMatrix::value_type,
+                                 cusp::device_memory,
+                                 typename LocalMatrix::index_type>
+{
+    typedef cusp::linear_operator<typename LocalMatrix::value_type,
+                                  cusp::device_memory,
+                                  typename LocalMatrix::index_type> Parent;
+    public:
+    typedef typename LocalMatrix::index_type IndexType;
+    typedef typename LocalMatrix::value_type ValueType;
+
+    typedef LocalMatrix                                               local_matrix_type;
+    typedef cusp::coo_matrix<IndexType,ValueType,cusp::device_memory> boundary_matrix_type;
+
+    /*! entries of the halo exchanged with one neighbouring process
+     */
+    struct message
+    {
+        int    rank;     // neighbouring process
+        size_t offset;   // first entry in the halo or the send buffer
+        size_t size;     // number of entries
+    };
+
+    /*! partition of the rows and columns
+     */
+    cusp::mpi_layout layout;
+
+    /*! entries of the local rows whose columns are owned by this process
+     */
+    local_matrix_type interior;
+
+    /*! entries of the local rows whose columns are owned by other
+     *  processes, with columns indexing \c halo
+     */
+    boundary_matrix_type boundary;
+
+    /*! global column of each entry of \c halo, in increasing order
+     */
+    cusp::array1d<IndexType,cusp::host_memory> ghost_columns;
+
+    /*! entries of x owned by other processes
+     */
+    mutable cusp::array1d<ValueType,cusp::device_memory> halo;
+
+    /*! local rows of x needed by other processes and their send buffer
+     */
+    cusp::array1d<IndexType,cusp::device_memory>         send_indices;
+    mutable cusp::array1d<ValueType,cusp::device_memory> send_buffer;
+
+    /*! halo entries received from each neighbour, offsets into \c halo
+     */
+    std::vector<message> receives;
+
+    /*! entries sent to each neighbour, offsets into \c send_buffer
+     */
+    std::vector<message> sends;
+
+    /*! whether the messages use device pointers
+     */
+    bool cuda_aware;
+
+    /*! Construct an empty matrix.
+     */
+    mpi_matrix(void);
+
+    /*! Split the local rows of a square matrix.  Collective.
+     *
+     *  \param local_rows Sparse or dense matrix on the host or device of
+     *         <tt>layout.local_size()</tt> rows and <tt>layout.size()</tt>
+     *         columns holding the rows owned by this process.
+     *  \param layout Partition of the rows and columns.
+     *
+     *  \throws cusp::invalid_input_exception if \p local_rows does not
+     *          match the layout.
+     */
+    template <typename MatrixType>
+    mpi_matrix(const MatrixType& local_rows, const cusp::mpi_layout& layout);
+
+    ~mpi_matrix(void);
+
+    /*! Number of entries of x received from other processes in each product.
+     */
+    size_t num_halo_entries(void) const { return halo.size(); }
+
+    /*! Compute y = A * x.  Collective.
+     *
+     *  \throws cusp::invalid_input_exception if the layouts of \p x and
+     *          \p y differ from \c layout.
+     */
+    void operator()(const cusp::mpi_array1d<ValueType>& x,
+                          cusp::mpi_array1d<ValueType>& y) const;
+
+    private:
+    MPI_Comm comm;                              // duplicate of layout.comm
+
+    mutable std::vector<MPI_Request> requests;  // receives followed by sends
+
+    // host staging of the messages without a CUDA-aware library
+    mutable cusp::array1d<ValueType,cusp::host_memory> halo_host;
+    mutable cusp::array1d<ValueType,cusp::host_memory> send_host;
+
+    cudaStream_t halo_stream;                   // gathering of the send buffer
+    cudaEvent_t  x_ready;                       // x has been written
+    cudaEvent_t  finished;                      // the halo has been read
+
+    template <typename MatrixType>
+    void initialize(const MatrixType& local_rows);
+
+    void release(void);
+
+    // not copyable
+    mpi_matrix(const mpi_matrix&);
+    mpi_matrix& operator=(const mpi_matrix&);
+}; // class mpi_matrix
+/*! \}
+ */
+
+} // end namespace cusp
+
+#include <cusp/detail/mpi_matrix.inl>
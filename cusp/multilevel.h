@@ -25,7 +25,19 @@
 #include <cusp/detail/lu.h>
 
 #include <cusp/array1d.h>
+#include <cusp/conversion_plan.h>
+#include <cusp/csr_matrix.h>
 #include <cusp/linear_operator.h>
+#include <cusp/multiply.h>
+#include <cusp/stream.h>
+
+#include <cusp/detail/device/graph.h>
+#include <cusp/detail/timer.h>
+
+#include <thrust/device_ptr.h>
+
+#include <ostream>
+#include <vector>
 
 namespace cusp
 {
@@ -35,21 +47,256 @@ namespace cusp
  *  \{
  */
 
+namespace detail
+{
+// T<ValueType,MemorySpace> (e.g. a smoother or a coarse solver) in another
+// memory space, other types are kept as they are
+template <typename T, typename MemorySpace>
+struct rebind_memory_space { typedef T type; };
+
+template <template <typename,typename> class T, typename ValueType, typename MemorySpace1, typename MemorySpace2>
+struct rebind_memory_space<T<ValueType,MemorySpace1>, MemorySpace2> { typedef T<ValueType,MemorySpace2> type; };
+
+// a linear operator of any type applied through views of its vectors,
+// e.g. the operator of the finest level (see multilevel::set_fine_operator)
+template <typename ValueType, typename MemorySpace, typename IndexType>
+class erased_operator : public cusp::linear_operator<ValueType,MemorySpace,IndexType>
+{
+    typedef cusp::linear_operator<ValueType,MemorySpace,IndexType> Parent;
+
+    template <typename T, typename Space>
+    struct pointer_type { typedef thrust::device_ptr<T> type; };
+
+    template <typename T>
+    struct pointer_type<T, cusp::host_memory> { typedef T * type; };
+
+    typedef typename pointer_type<const ValueType,MemorySpace>::type ConstPointer;
+    typedef typename pointer_type<ValueType,MemorySpace>::type       Pointer;
+
+    typedef cusp::array1d_view<ConstPointer> const_view;
+    typedef cusp::array1d_view<Pointer>      view;
+
+    struct base
+    {
+        virtual ~base() {}
+        virtual base* clone() const = 0;
+        virtual void apply(const const_view& x, view& y) const = 0;
+        virtual void residual(const const_view& x, const const_view& b, view& r) const = 0;
+    };
+
+    template <typename LinearOperator>
+    struct holder : public base
+    {
+        LinearOperator A;
+
+        holder(const LinearOperator& A) : A(A) {}
+
+        base* clone() const { return new holder(A); }
+
+        void apply(const const_view& x, view& y) const { cusp::multiply(A, x, y); }
+
+        void residual(const const_view& x, const const_view& b, view& r) const { cusp::detail::residual(A, x, b, r); }
+    };
+
+    base* impl;
+
+public:
+
+    erased_operator() : Parent(), impl(NULL) {}
+
+    template <typename LinearOperator>
+    explicit erased_operator(const LinearOperator& A)
+        : Parent(A.num_rows, A.num_cols, A.num_entries), impl(new holder<LinearOperator>(A)) {}
+
+    erased_operator(const erased_operator& A)
+        : Parent(A), impl(A.impl == NULL ? NULL : A.impl->clone()) {}
+
+    ~erased_operator() { delete impl; }
+
+    erased_operator& operator=(const erased_operator& A)
+    {
+        if (this != &A)
+        {
+            base* copy = A.impl == NULL ? NULL : A.impl->clone();
+            delete impl;
+            impl = copy;
+            this->resize(A.num_rows, A.num_cols, A.num_entries);
+        }
+
+        return *this;
+    }
+
+    bool empty(void) const { return impl == NULL; }
+
+    template <typename VectorType1, typename VectorType2>
+    void operator()(const VectorType1& x, VectorType2& y) const
+    {
+        if (this->num_rows == 0)
+            return;
+
+        const ConstPointer x_ptr(thrust::raw_pointer_cast(&x[0]));
+        const Pointer      y_ptr(thrust::raw_pointer_cast(&y[0]));
+
+        const_view x_view(x_ptr, x_ptr + x.size());
+        view       y_view(y_ptr, y_ptr + y.size());
+
+        impl->apply(x_view, y_view);
+    }
+
+    // r <- b - A x, fused when the operator has a fused kernel
+    template <typename VectorType1, typename VectorType2, typename VectorType3>
+    void residual(const VectorType1& x, const VectorType2& b, VectorType3& r) const
+    {
+        if (this->num_rows == 0)
+            return;
+
+        const ConstPointer x_ptr(thrust::raw_pointer_cast(&x[0]));
+        const ConstPointer b_ptr(thrust::raw_pointer_cast(&b[0]));
+        const Pointer      r_ptr(thrust::raw_pointer_cast(&r[0]));
+
+        const_view x_view(x_ptr, x_ptr + x.size());
+        const_view b_view(b_ptr, b_ptr + b.size());
+        view       r_view(r_ptr, r_ptr + r.size());
+
+        impl->residual(x_view, b_view, r_view);
+    }
+};
+
+template <typename ValueType, typename MemorySpace, typename IndexType,
+          typename Vector1, typename Vector2, typename Vector3>
+void residual(const erased_operator<ValueType,MemorySpace,IndexType>& A,
+              const Vector1& x,
+              const Vector2& b,
+                    Vector3& r)
+{
+    A.residual(x, b, r);
+}
+} // end namespace detail
+
+/*! Cycles of a \p multilevel hierarchy
+ */
+enum cycle_type
+{
+    V_CYCLE,  //!< one coarse grid correction per level
+    W_CYCLE,  //!< two coarse grid corrections per level
+    F_CYCLE,  //!< an F-cycle followed by a V-cycle on each coarse level
+    K_CYCLE   //!< two flexible CG steps on each coarse level, preconditioned by the K-cycle
+};
+
+/*! Storage formats of the operators of a \p multilevel level
+ */
+enum level_format
+{
+    LEVEL_MATRIX_TYPE,  //!< the \c MatrixType of the hierarchy
+    LEVEL_COO,          //!< \p coo_matrix
+    LEVEL_CSR,          //!< \p csr_matrix
+    LEVEL_DIA,          //!< \p dia_matrix
+    LEVEL_ELL,          //!< \p ell_matrix
+    LEVEL_HYB,          //!< \p hyb_matrix
+    LEVEL_DENSE,        //!< \p array2d
+    LEVEL_AUTO          //!< the format of least estimated SpMV time
+};
+
+// time in milliseconds spent in each stage of the cycles on one level
+struct multilevel_level_timings
+{
+    size_t visits;          // number of cycles through the level
+    double presmooth;       // presmoothing
+    double residual;        // residual b - A x after presmoothing
+    double restriction;     // restriction of the residual
+    double prolongation;    // prolongation and addition of the correction
+    double postsmooth;      // postsmoothing
+    double coarse_solve;    // direct solve of the coarsest level
+
+    multilevel_level_timings()
+      : visits(0), presmooth(0), residual(0), restriction(0), prolongation(0), postsmooth(0), coarse_solve(0) {}
+
+    double total(void) const
+    {
+        return presmooth + residual + restriction + prolongation + postsmooth + coarse_solve;
+    }
+};
+
 /*! \p multilevel : multilevel hierarchy
  *
+ *  \tparam MatrixType Type of the level operators.
+ *  \tparam SmootherType Type of the smoother of each level.
+ *  \tparam SolverType Type of the coarse grid solver.
+ *  \tparam ValueType Type of the vectors and of the residual computation,
+ *          which may be wider than the values stored in \c MatrixType
+ *          (e.g. \c float operators with \c double vectors).
+ *
+ *  Each application performs one cycle of the type given by \c cycle
+ *  (the V-cycle by default) with \c presmooth_sweeps and
+ *  \c postsmooth_sweeps applications of the smoother on each level.  The
+ *  K-cycle accelerates the coarse grid corrections with two steps of
+ *  flexible CG each, which usually lowers the iteration count for
+ *  anisotropic problems at the price of two coarse cycles and a few
+ *  reductions per level.  Since the coefficients of those steps depend on
+ *  the residual the K-cycle is not a linear operator, so it is safest
+ *  with a simple iteration (\p solve) or a flexible Krylov method.
+ *
+ *  The coarse levels of a device hierarchy are often too small to occupy
+ *  the device, so their cycles are dominated by launch latency.
+ *  \p set_host_levels keeps a host copy (in CSR format) of the levels
+ *  from the first one with at most a given number of rows on, and the
+ *  coarse grid correction of those levels then runs on the host with one
+ *  transfer of the restricted residual and of the correction.
+ *
+ *  A cycle of a device hierarchy issues the same sequence of small
+ *  kernels on every application.  \p set_graph_capture records that
+ *  sequence once as a CUDA Graph and replays it with a single launch,
+ *  which removes most of the launch overhead of the coarse levels.  The
+ *  first application with a given pair of vectors runs normally (so that
+ *  lazily allocated storage exists), the second one is captured and later
+ *  applications with the same vectors replay the graph.  The K-cycle,
+ *  host levels and coarse solvers in host memory synchronize with the
+ *  host and are never captured.
+ *
+ *  The restriction of smoothed aggregation is the transpose of the
+ *  prolongator.  \p set_implicit_restriction releases the explicit
+ *  restriction operators and applies P^T with a transposed SpMV instead,
+ *  which saves the storage of R on every level at the price of atomic
+ *  updates in the restriction.
+ *
+ *  \p set_fine_operator applies another operator in place of the finest
+ *  matrix, e.g. a matrix-free \p stencil_operator of the matrix from
+ *  which the hierarchy was built, so that the smoothing sweeps and
+ *  residuals of the largest level read no matrix entries (smoothers such
+ *  as \p jacobi then use their unfused path with one multiply per sweep).
+ *
+ *  Every level stores its operators as \c MatrixType, although the best
+ *  format depends on the level: a structured fine level may be best in
+ *  DIA, the middle levels in ELL and the small coarse levels in CSR or
+ *  dense, where the COO part of HYB costs launches and no bandwidth.
+ *  \p set_level_formats keeps a copy of the operators A, R and P of each
+ *  level in another format, which the cycles apply instead.  With
+ *  \c LEVEL_AUTO the format of each operator is chosen by the cost model
+ *  of \p plan_conversion from its row lengths and diagonals, including a
+ *  dense \p array2d whose single launch wins for small dense levels.
  *
- *  TODO
+ *  \p set_profiling times every stage of the cycles on each level with
+ *  events on the current stream.  Each stage then synchronizes, smoothing
+ *  and the residual are computed in separate passes and graph capture is
+ *  suspended, so profiled cycles are slower than normal ones.
+ *  \p write_profile reports the timings, with the effective bandwidth of
+ *  each level estimated from the operators it reads, as JSON.
  */
-template <typename MatrixType, typename SmootherType, typename SolverType>
-class multilevel : public cusp::linear_operator<typename MatrixType::value_type,
+template <typename MatrixType, typename SmootherType, typename SolverType,
+          typename ValueType = typename MatrixType::value_type>
+class multilevel : public cusp::linear_operator<ValueType,
     						typename MatrixType::memory_space>
 {
 public:
 
     typedef typename MatrixType::index_type IndexType;
-    typedef typename MatrixType::value_type ValueType;
     typedef typename MatrixType::memory_space MemorySpace;
 
+    typedef cusp::csr_matrix<IndexType,typename MatrixType::value_type,cusp::host_memory> HostMatrixType;
+    typedef typename detail::rebind_memory_space<SmootherType,cusp::host_memory>::type HostSmootherType;
+    typedef typename detail::rebind_memory_space<SolverType,cusp::host_memory>::type HostSolverType;
+    typedef multilevel<HostMatrixType,HostSmootherType,HostSolverType,ValueType> host_hierarchy;
+
     struct level
     {
         MatrixType R;  // restriction operator
@@ -61,20 +308,66 @@ public:
 
         SmootherType smoother;
 
-	level(){}
+        // work vectors of the W-, F- and K-cycle corrections, sized on first use
+        cusp::array1d<ValueType,MemorySpace> cycle_b;
+        cusp::array1d<ValueType,MemorySpace> cycle_x;
+        cusp::array1d<ValueType,MemorySpace> cycle_Ax;
+
+        multilevel_level_timings timings;  // recorded when profiling
+
+        // copies of R, A and P in other formats, applied instead when not
+        // empty (see set_level_formats)
+        detail::erased_operator<ValueType,MemorySpace,IndexType> R_op;
+        detail::erased_operator<ValueType,MemorySpace,IndexType> A_op;
+        detail::erased_operator<ValueType,MemorySpace,IndexType> P_op;
+        level_format R_format;
+        level_format A_format;
+        level_format P_format;
+
+	level() : R_format(LEVEL_MATRIX_TYPE), A_format(LEVEL_MATRIX_TYPE), P_format(LEVEL_MATRIX_TYPE) {}
 
 	template<typename Level_Type>
-	level(const Level_Type& level) : R(level.R), A(level.A), P(level.P), x(level.x), b(level.b), residual(level.residual), smoother(level.smoother){}
+	level(const Level_Type& level) : R(level.R), A(level.A), P(level.P), x(level.x), b(level.b), residual(level.residual), smoother(level.smoother),
+	    R_format(LEVEL_MATRIX_TYPE), A_format(LEVEL_MATRIX_TYPE), P_format(LEVEL_MATRIX_TYPE) {}
     };
 
     SolverType solver;
 
     std::vector<level> levels;
 
-    multilevel(){};
+    cycle_type cycle;
+    size_t presmooth_sweeps;
+    size_t postsmooth_sweeps;
+
+    size_t host_level_size;   // levels with at most this many rows run on the host, 0 disables
+    size_t host_level_begin;  // first level of host_levels
+    host_hierarchy* host_levels;
+
+    bool implicit_restriction; // restrict with P^T, the levels hold no R
+
+    bool graph_capture;       // replay the cycle as a CUDA Graph
+
+    bool profiling;           // time the stages of every cycle
+
+    // applied in place of levels[0].A when not empty
+    detail::erased_operator<ValueType,MemorySpace,IndexType> fine_operator;
+
+    // cost model of the level formats (see set_level_formats)
+    cusp::conversion_plan_options level_format_options;
+
+    multilevel() : cycle(V_CYCLE), presmooth_sweeps(1), postsmooth_sweeps(1),
+                   host_level_size(0), host_level_begin(0), host_levels(NULL),
+                   implicit_restriction(false),
+                   graph_capture(false), profiling(false), graph_b(NULL), graph_x(NULL) {};
+
+    multilevel(const multilevel& M);
+
+    template <typename MatrixType2, typename SmootherType2, typename SolverType2, typename ValueType2>
+    multilevel(const multilevel<MatrixType2, SmootherType2, SolverType2, ValueType2>& M);
 
-    template <typename MatrixType2, typename SmootherType2, typename SolverType2>
-    multilevel(const multilevel<MatrixType2, SmootherType2, SolverType2>& M);
+    ~multilevel();
+
+    multilevel& operator=(const multilevel& M);
 
     template <typename Array1, typename Array2>
     void operator()(const Array1& x, Array2& y);
@@ -85,6 +378,97 @@ public:
     template <typename Array1, typename Array2, typename Monitor>
     void solve(const Array1& b, Array2& x, Monitor& monitor);
 
+    /*! Select the cycle performed by each application of the hierarchy.
+     *
+     *  \param cycle the cycle type
+     *  \param presmooth_sweeps number of smoother applications before the coarse grid correction
+     *  \param postsmooth_sweeps number of smoother applications after the coarse grid correction
+     */
+    void set_cycle(cycle_type cycle, size_t presmooth_sweeps = 1, size_t postsmooth_sweeps = 1);
+
+    /*! Run the coarse levels of a device hierarchy on the host.  The
+     *  host copy is taken from the current levels, so call this again
+     *  after the levels change.
+     *
+     *  \param max_rows levels after the first one with at most this many
+     *         rows, and all coarser levels, run on the host (0 disables)
+     */
+    void set_host_levels(size_t max_rows);
+
+    /*! Capture the cycle of a device hierarchy as a CUDA Graph and replay
+     *  it on later applications to the same vectors.  The graph is
+     *  discarded whenever the cycle, the host levels or the vectors
+     *  change, or when this is called again, so call it after modifying
+     *  the levels directly.
+     *
+     *  \param enable whether cycles are captured and replayed
+     */
+    void set_graph_capture(bool enable);
+
+    /*! Apply the restriction of each level as the transpose of its
+     *  prolongator.  Enabling releases the restriction operators of the
+     *  levels, disabling forms them again as the transposes of the
+     *  prolongators.
+     *
+     *  \param enable whether the restriction is applied as P^T
+     */
+    void set_implicit_restriction(bool enable);
+
+    /*! Apply \p A instead of the matrix of the finest level in the
+     *  smoothing sweeps and residuals of that level.  \p A must represent
+     *  the same matrix, since the smoothers, transfer operators and
+     *  coarse levels are kept.  The operator is dropped when the hierarchy
+     *  is copied to another memory space.
+     *
+     *  \param A linear operator with \c operator()(x, y) computing y = A x
+     */
+    template <typename LinearOperator>
+    void set_fine_operator(const LinearOperator& A);
+
+    /*! Apply the matrix of the finest level again.
+     */
+    void clear_fine_operator(void);
+
+    /*! Apply the operators of every level in \p format.  The operators
+     *  in \c MatrixType are kept for the setup, the host levels and
+     *  copies of the hierarchy, so other formats add their storage; the
+     *  copies are dropped when the hierarchy is copied to another memory
+     *  space, and \p smoothed_aggregation::resetup converts them again.
+     *  The operator set by \p set_fine_operator takes precedence on the
+     *  finest level, and implicit restrictions keep applying P^T.
+     *
+     *  \param format format of the operators, \c LEVEL_MATRIX_TYPE drops
+     *         the copies and \c LEVEL_AUTO chooses one for each operator
+     *  \param options parameters of the cost model of \c LEVEL_AUTO and
+     *         of the DIA, ELL and HYB conversions
+     */
+    void set_level_formats(level_format format = LEVEL_AUTO,
+                           const cusp::conversion_plan_options& options = cusp::conversion_plan_options());
+
+    /*! Apply the operators of level \c i in \p formats[i]
+     *
+     *  \throws cusp::invalid_input_exception if \p formats does not hold
+     *  one format per level
+     */
+    void set_level_formats(const std::vector<level_format>& formats,
+                           const cusp::conversion_plan_options& options = cusp::conversion_plan_options());
+
+    /*! Time the stages of the cycles on every level.  Enabling or
+     *  disabling clears the timings recorded so far.
+     *
+     *  \param enable whether cycles are profiled
+     */
+    void set_profiling(bool enable);
+
+    /*! Write the per-level timings recorded while profiling as a JSON
+     *  object with the number of rows and nonzeros of each level, the
+     *  time of each stage, the bytes read by one visit of the level and
+     *  the resulting effective bandwidth in GB/s.
+     *
+     *  \param os output stream
+     */
+    void write_profile(std::ostream& os) const;
+
     void print( void );
 
     double operator_complexity( void );
@@ -93,8 +477,52 @@ public:
 
 protected:
 
+    template <typename MatrixType2, typename SmootherType2, typename SolverType2, typename ValueType2>
+    friend class multilevel;
+
     template <typename Array1, typename Array2>
     void _solve(const Array1& b, Array2& x, const size_t i);
+
+    template <typename Array1, typename Array2>
+    void _solve(const Array1& b, Array2& x, const size_t i, const cycle_type level_cycle);
+
+    // one cycle on level i whose operator is A
+    template <typename LevelOperator, typename Array1, typename Array2>
+    void _solve(const LevelOperator& A, const Array1& b, Array2& x, const size_t i, const cycle_type level_cycle);
+
+    // residual <- b - A x with the operator of the finest level
+    template <typename Array1, typename Array2, typename Array3>
+    void _fine_residual(const Array1& b, const Array2& x, Array3& residual);
+
+    // convert the operators of the levels again in their formats, after
+    // their values changed
+    void _refresh_level_formats(void);
+
+    // y <- A x and r <- b - A x with the operator applied on level i
+    template <typename Array1, typename Array2>
+    void _level_multiply(const size_t i, const Array1& x, Array2& y);
+
+    template <typename Array1, typename Array2, typename Array3>
+    void _level_residual(const size_t i, const Array1& x, const Array2& b, Array3& r);
+
+    // levels[i].x <- approximate solution of levels[i].A x = levels[i].b
+    void _coarse_correction(const size_t i, const cycle_type level_cycle);
+
+    // levels[i].x <- levels[i].x + cycle(levels[i].b - levels[i].A x)
+    void _correct(const size_t i, const cycle_type level_cycle);
+
+    // two steps of flexible CG on level i preconditioned by the K-cycle
+    void _k_cycle(const size_t i);
+
+    // whether one cycle can be recorded with stream capture
+    bool _graph_capturable(void) const;
+
+    // timings of level i, which may be a level of the host hierarchy
+    const multilevel_level_timings& _level_timings(const size_t i) const;
+
+    cusp::detail::device::captured_graph graph;
+    const void* graph_b;  // vectors of the captured cycle
+    const void* graph_x;
 };
 /*! \}
  */
@@ -22,6 +22,8 @@
 
 #include <cusp/detail/config.h>
 
+#include <cusp/linear_operator.h>
+
 namespace cusp
 {
 
@@ -89,6 +91,334 @@ template <typename LinearOperator,
 void multiply(const LinearOperator&  A,
               const MatrixOrVector1& B,
               const MatrixOrVector2& C);
+/*! \p generalized_multiply : Computes a matrix-vector product over
+ * an arbitrary semiring
+ *
+ * Each entry of the output is updated as
+ * <tt>y[i] = reduce(initialize(y[i]), reduce_j combine(A(i,j), x[j]))</tt>
+ * where \c j runs over the stored entries of row \c i.  With
+ * \c thrust::multiplies, \c thrust::plus and an initialize which returns
+ * zero this is the usual product y = A * x, while for instance
+ * \c thrust::plus with \c thrust::minimum gives the min-plus product
+ * of shortest path computations and \c thrust::logical_and with
+ * \c thrust::logical_or the boolean product of a breadth-first search.
+ *
+ * Any number of rows may have no stored entries, reduce needs no identity
+ * element, but it must be associative and commutative since the entries
+ * of a row are reduced in parallel.  Only stored entries take part, which
+ * includes the explicit zeros within the diagonals of a \p dia_matrix and
+ * the blocks of a \p bsr_matrix.  The vectors x and y must not overlap.
+ *
+ * The CSR, COO, ELL, DIA and HYB formats use dedicated kernels on the
+ * device, the other formats are converted to CSR first.
+ *
+ * \param A sparse matrix
+ * \param x input vector
+ * \param y input and output vector
+ * \param initialize unary function applied to y before the reduction
+ * \param combine binary function applied to the pairs A(i,j) and x[j]
+ * \param reduce binary function which reduces the combined values
+ *
+ * \tparam Matrix sparse matrix
+ * \tparam Vector1 vector
+ * \tparam Vector2 vector
+ * \tparam UnaryFunction unary function
+ * \tparam BinaryFunction1 binary function
+ * \tparam BinaryFunction2 binary function
+ *
+ * \throws cusp::invalid_input_exception if the vector sizes do not match the matrix
+ *
+ *  The following code snippet demonstrates how to relax the distances of a
+ *  single source shortest path computation with \p generalized_multiply.
+ *
+ *  \code
+ *  #include <cusp/multiply.h>
+ *  #include <cusp/csr_matrix.h>
+ *  #include <thrust/functional.h>
+ *  ...
+ *
+ *  // A(i,j) is the weight of the edge from j to i
+ *  cusp::csr_matrix<int,float,cusp::device_memory> A;
+ *  ...
+ *  cusp::array1d<float,cusp::device_memory> d(A.num_rows, FLT_MAX);
+ *  cusp::array1d<float,cusp::device_memory> e(A.num_rows);
+ *  d[source] = 0;
+ *
+ *  // e[i] = min(d[i], min_j A(i,j) + d[j])
+ *  e = d;
+ *  cusp::generalized_multiply(A, d, e,
+ *                             thrust::identity<float>(),
+ *                             thrust::plus<float>(),
+ *                             thrust::minimum<float>());
+ *  \endcode
+ */
+template <typename Matrix,
+          typename Vector1,
+          typename Vector2,
+          typename UnaryFunction,
+          typename BinaryFunction1,
+          typename BinaryFunction2>
+void generalized_multiply(const Matrix&  A,
+                          const Vector1& x,
+                                Vector2& y,
+                          UnaryFunction   initialize,
+                          BinaryFunction1 combine,
+                          BinaryFunction2 reduce);
+
+/*! \p masked_multiply : Computes the rows of a matrix-vector product
+ * selected by a mask
+ *
+ * Like \p generalized_multiply, but only the rows with
+ * <tt>mask[i] != 0</tt> are computed and the other entries of y are left
+ * unchanged.  The rows which are skipped cost no memory traffic besides
+ * the mask, so the pull step of a frontier-based graph algorithm only
+ * touches the vertices which are still unvisited.  CSR matrices are
+ * used as they are, the other formats are converted to CSR first.
+ *
+ * \param A sparse matrix
+ * \param x input vector
+ * \param mask rows to compute
+ * \param y input and output vector
+ * \param initialize unary function applied to y before the reduction
+ * \param combine binary function applied to the pairs A(i,j) and x[j]
+ * \param reduce binary function which reduces the combined values
+ *
+ * \throws cusp::invalid_input_exception if the vector sizes do not match the matrix
+ */
+template <typename Matrix,
+          typename Vector1,
+          typename Vector2,
+          typename Vector3,
+          typename UnaryFunction,
+          typename BinaryFunction1,
+          typename BinaryFunction2>
+void masked_multiply(const Matrix&  A,
+                     const Vector1& x,
+                     const Vector2& mask,
+                           Vector3& y,
+                     UnaryFunction   initialize,
+                     BinaryFunction1 combine,
+                     BinaryFunction2 reduce);
+
+/*! \p masked_multiply : Computes the rows of y = A * x selected by a mask
+ *
+ * \param A sparse matrix
+ * \param x input vector
+ * \param mask rows to compute
+ * \param y output vector
+ */
+template <typename Matrix,
+          typename Vector1,
+          typename Vector2,
+          typename Vector3>
+void masked_multiply(const Matrix&  A,
+                     const Vector1& x,
+                     const Vector2& mask,
+                           Vector3& y);
+
+/*! \p multiply_transpose : Computes the transposed product y = A^T * x
+ *
+ * The product is formed from the entries of A as they are stored, without
+ * a transposed copy of A.  On the device every entry A(i,j) adds
+ * A(i,j) * x[i] to y[j] with an atomic operation, so the order of the
+ * additions, and with it the rounding of y, may differ between calls.
+ * The COO, CSR, DIA, ELL and HYB formats and dense matrices use dedicated
+ * kernels on the device, the other sparse formats are converted to COO
+ * first.  The DIA and dense kernels gather the columns of A and need no
+ * atomics.
+ *
+ * \param A sparse matrix
+ * \param x input vector of size A.num_rows
+ * \param y output vector of size A.num_cols
+ *
+ * \tparam Matrix sparse matrix
+ * \tparam Vector1 vector
+ * \tparam Vector2 vector
+ *
+ * \throws cusp::invalid_input_exception if the vector sizes do not match the matrix
+ */
+template <typename Matrix,
+          typename Vector1,
+          typename Vector2>
+void multiply_transpose(const Matrix&  A,
+                        const Vector1& x,
+                              Vector2& y);
+
+/*! \p multiply : Computes y = A * x or, with \p transpose, y = A^T * x
+ *
+ * \param A matrix
+ * \param x input vector
+ * \param y output vector
+ * \param transpose whether A^T is applied, see \p multiply_transpose
+ *
+ * \throws cusp::not_implemented_exception if \p transpose is set for a
+ *         user-defined \p linear_operator
+ */
+template <typename LinearOperator,
+          typename Vector1,
+          typename Vector2>
+void multiply(const LinearOperator& A,
+              const Vector1& x,
+                    Vector2& y,
+              const bool transpose);
+
+/*! \p multiply : Computes y = alpha * A * x + beta * y
+ *
+ * The scaling by \p alpha and the update of y are applied as each row is
+ * reduced, so a residual r = b - A * x costs a copy of b into r and one
+ * product with alpha = -1 and beta = 1, rather than a product followed by
+ * \p blas::axpby.  When \p beta is zero y is not read and may hold any
+ * values.  The COO, CSR, DIA, ELL and HYB formats, as well as SELL, BSR
+ * and CSR16 on the host, use the kernels of \p generalized_multiply; the
+ * other formats and user-defined operators compute A * x into a temporary
+ * first.
+ *
+ * \param A matrix or linear operator
+ * \param x input vector
+ * \param y input and output vector
+ * \param alpha scaling of A * x
+ * \param beta scaling of y
+ *
+ * \throws cusp::invalid_input_exception if the vector sizes do not match the matrix
+ *
+ *  \code
+ *  // r <- b - A * x
+ *  cusp::blas::copy(b, r);
+ *  cusp::multiply(A, x, r, -1.0f, 1.0f);
+ *  \endcode
+ */
+template <typename LinearOperator,
+          typename Vector1,
+          typename Vector2,
+          typename ScalarType1,
+          typename ScalarType2>
+void multiply(const LinearOperator& A,
+              const Vector1& x,
+                    Vector2& y,
+              const ScalarType1 alpha,
+              const ScalarType2 beta);
+
+/*! \p multiply_dot : Computes y = A * x and returns conj(y)^T x
+ *
+ * This is the product and the curvature <A p, p> of a conjugate gradient
+ * step.  On the device the CSR, ELL, DIA and HYB formats compute the dot
+ * product as the rows of y are written: each block reduces the terms of
+ * its rows and a small final reduction adds the blocks, so neither y nor
+ * x is read again.  \p symmetric_csr_operator and \p hermitian_csr_operator
+ * sum the dot product over the entries of their triangle in the same pass,
+ * on the host and the device.  The other formats, the host, and the
+ * reproducible and compensated reduction modes compute \p multiply
+ * followed by \p blas::dotc.
+ *
+ * \param A matrix or linear operator
+ * \param x input vector
+ * \param y output vector
+ *
+ * \return conj(y)^T x
+ *
+ * \throws cusp::invalid_input_exception if A is not square or the vector
+ *         sizes do not match the matrix
+ */
+template <typename LinearOperator,
+          typename Vector1,
+          typename Vector2>
+typename Vector2::value_type
+multiply_dot(const LinearOperator& A,
+             const Vector1& x,
+                   Vector2& y);
+
+/*! \p transposed_operator : the transpose of a matrix as a linear operator
+ *
+ * Applying a \p transposed_operator computes y = A^T * x with
+ * \p multiply_transpose, so solvers which need A^T, such as \p bicg, run
+ * without a transposed copy of A.  The operator refers to \p A, which
+ * must outlive it.
+ *
+ *  \code
+ *  cusp::csr_matrix<int, float, cusp::device_memory> A;
+ *  ...
+ *  cusp::transposed_operator< cusp::csr_matrix<int, float, cusp::device_memory> > At(A);
+ *  cusp::krylov::bicg(A, At, x, b, monitor);
+ *  \endcode
+ */
+template <typename Matrix>
+class transposed_operator
+  : public cusp::linear_operator<typename Matrix::value_type, typename Matrix::memory_space, typename Matrix::index_type>
+{
+    typedef cusp::linear_operator<typename Matrix::value_type, typename Matrix::memory_space, typename Matrix::index_type> Parent;
+
+    const Matrix& A;
+
+    public:
+
+    transposed_operator(const Matrix& A)
+        : Parent(A.num_cols, A.num_rows, A.num_entries), A(A) {}
+
+    template <typename VectorType1,
+              typename VectorType2>
+    void operator()(const VectorType1& x, VectorType2& y) const
+    {
+        cusp::multiply_transpose(A, x, y);
+    }
+};
+
+/*! \p galerkin_product : Computes the triple product RAP = R * A * P
+ *
+ * On the device the product is formed row by row without storing the
+ * intermediate matrix A * P.  On the host it is computed as R * (A * P).
+ *
+ * \param R input matrix (restriction)
+ * \param A input matrix
+ * \param P input matrix (prolongation)
+ * \param RAP output matrix
+ *
+ * \tparam Matrix1 sparse matrix
+ * \tparam Matrix2 sparse matrix
+ * \tparam Matrix3 sparse matrix
+ * \tparam Matrix4 sparse matrix
+ *
+ * \throws cusp::invalid_input_exception if the dimensions of the matrices are incompatible
+ */
+template <typename Matrix1,
+          typename Matrix2,
+          typename Matrix3,
+          typename Matrix4>
+void galerkin_product(const Matrix1& R,
+                      const Matrix2& A,
+                      const Matrix3& P,
+                            Matrix4& RAP);
+
+/*! \p masked_product : Computes the sparse product C = A * B only at the
+ * entries of the mask M
+ *
+ * C takes the pattern of M, including entries where A * B is zero, and
+ * no entry of A * B outside of M is formed, so the product costs at most
+ * the work of A * B and often much less.  For instance the triangles of
+ * an undirected graph are counted from the strictly lower triangle L of
+ * its adjacency matrix as the sum of the values of (L * L) at L.
+ *
+ * \param A input matrix
+ * \param B input matrix
+ * \param M mask, whose values are ignored
+ * \param C output matrix with the pattern of M
+ *
+ * \tparam Matrix1 sparse matrix
+ * \tparam Matrix2 sparse matrix
+ * \tparam Matrix3 sparse matrix
+ * \tparam Matrix4 sparse matrix
+ *
+ * \note CSR matrices B and M must have sorted column indices within each row.
+ *
+ * \throws cusp::invalid_input_exception if the dimensions of the matrices are incompatible
+ */
+template <typename Matrix1,
+          typename Matrix2,
+          typename Matrix3,
+          typename Matrix4>
+void masked_product(const Matrix1& A,
+                    const Matrix2& B,
+                    const Matrix3& M,
+                          Matrix4& C);
 /*! \}
  */
 
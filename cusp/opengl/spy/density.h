@@ -0,0 +1,57 @@
+/*
+ *  Copyright 2008-2013 Steven Dalton
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/**
+ * @file density.h
+ * Binning of the entries of a sparse matrix into a density image, the
+ * tiles which the matrix_canvas draws once entries are smaller than a
+ * pixel.
+ */
+
+#pragma once
+
+#include <cusp/array1d.h>
+
+#include <cstddef>
+
+namespace cusp
+{
+namespace opengl
+{
+namespace spy
+{
+
+/**
+ * Count the entries of the CSR matrix A in each bin of row_bin x col_bin
+ * cells of the rows [row_begin, row_begin + num_bin_rows*row_bin) and the
+ * columns [col_begin, col_begin + num_bin_cols*col_bin) into counts, a
+ * row-major num_bin_rows by num_bin_cols image on the host.  The work is
+ * linear in the entries of those rows.  On the host each thread fills its
+ * own image for a block of the entries; on the device the entries are
+ * binned a chunk at a time by sorting their bins, and only the counts of
+ * the non-empty bins are copied back.
+ */
+template< typename MatrixType >
+void bin_density(const MatrixType& A, size_t row_begin, size_t col_begin,
+                 size_t row_bin, size_t col_bin,
+                 size_t num_bin_rows, size_t num_bin_cols,
+                 cusp::array1d<unsigned int,cusp::host_memory>& counts);
+
+} // end spy
+} // end opengl
+} // end cusp
+
+#include <cusp/opengl/spy/detail/density.inl>
@@ -0,0 +1,231 @@
+/*
+ *  Copyright 2008-2013 Steven Dalton
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include <cusp/detail/host/parallel.h>
+
+#include <thrust/fill.h>
+#include <thrust/reduce.h>
+#include <thrust/sort.h>
+#include <thrust/transform.h>
+#include <thrust/iterator/constant_iterator.h>
+#include <thrust/iterator/counting_iterator.h>
+
+#include <algorithm>
+#include <vector>
+
+namespace cusp
+{
+namespace opengl
+{
+namespace spy
+{
+namespace detail
+{
+
+// entries binned per pass on the device, which bounds the scratch space
+const size_t density_chunk_size = 1 << 24;
+
+const unsigned int density_outside = ~0u;
+
+// bin of the entry (r,c), or density_outside for the columns outside
+struct density_bin_index
+{
+    size_t row_begin, col_begin, col_end;
+    size_t row_bin, col_bin, num_bin_cols;
+
+    density_bin_index(size_t row_begin, size_t col_begin, size_t col_end,
+                      size_t row_bin, size_t col_bin, size_t num_bin_cols)
+        : row_begin(row_begin), col_begin(col_begin), col_end(col_end),
+          row_bin(row_bin), col_bin(col_bin), num_bin_cols(num_bin_cols) {}
+
+    __host__ __device__
+    unsigned int operator()(const size_t r, const size_t c) const
+    {
+        if (c < col_begin || c >= col_end)
+            return density_outside;
+
+        return (unsigned int)(((r - row_begin) / row_bin) * num_bin_cols + (c - col_begin) / col_bin);
+    }
+};
+
+// bin of entry n, whose row is found by a binary search in the band
+template< typename IndexType >
+struct density_bin
+{
+    const IndexType * Ap;
+    const IndexType * Aj;
+    size_t row_begin, row_end;
+    density_bin_index index;
+
+    density_bin(const IndexType * Ap, const IndexType * Aj,
+                size_t row_begin, size_t row_end, density_bin_index index)
+        : Ap(Ap), Aj(Aj), row_begin(row_begin), row_end(row_end), index(index) {}
+
+    __host__ __device__
+    unsigned int operator()(const IndexType n) const
+    {
+        // the last row starting at or before n
+        size_t lo = row_begin, hi = row_end;
+
+        while (hi - lo > 1)
+        {
+            const size_t mid = lo + (hi - lo) / 2;
+
+            if (size_t(Ap[mid]) <= size_t(n))
+                lo = mid;
+            else
+                hi = mid;
+        }
+
+        return index(lo, Aj[n]);
+    }
+};
+
+template< typename MatrixType >
+void bin_density(const MatrixType& A, size_t row_begin, size_t row_end,
+                 const density_bin_index& index,
+                 cusp::array1d<unsigned int,cusp::host_memory>& counts,
+                 cusp::host_memory)
+{
+    typedef typename MatrixType::index_type IndexType;
+
+    const size_t entry_begin = A.row_offsets[row_begin];
+    const size_t num_entries = size_t(A.row_offsets[row_end]) - entry_begin;
+    const size_t num_bins    = counts.size();
+
+    const int P = cusp::detail::host::num_parts(num_entries);
+
+    std::vector< std::vector<unsigned int> > part_counts(P);
+
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(static) num_threads(P)
+#endif
+    for (int part = 0; part < P; part++)
+    {
+        std::vector<unsigned int>& local = part_counts[part];
+        local.assign(num_bins, 0);
+
+        const size_t n_begin = entry_begin + cusp::detail::host::uniform_split(num_entries, part, P);
+        const size_t n_end   = entry_begin + cusp::detail::host::uniform_split(num_entries, part + 1, P);
+
+        if (n_begin == n_end)
+            continue;
+
+        // the row of the first entry of the block
+        size_t r = std::upper_bound(&A.row_offsets[0] + row_begin, &A.row_offsets[0] + row_end + 1,
+                                    IndexType(n_begin)) - &A.row_offsets[0] - 1;
+
+        for (size_t n = n_begin; n < n_end; n++)
+        {
+            while (size_t(A.row_offsets[r + 1]) <= n)
+                r++;
+
+            const unsigned int b = index(r, A.column_indices[n]);
+
+            if (b != density_outside)
+                local[b]++;
+        }
+    }
+
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(static) num_threads(P)
+#endif
+    for (int part = 0; part < P; part++)
+    {
+        const size_t b_end = cusp::detail::host::uniform_split(num_bins, part + 1, P);
+
+        for (size_t b = cusp::detail::host::uniform_split(num_bins, part, P); b < b_end; b++)
+            for (int q = 0; q < P; q++)
+                counts[b] += part_counts[q][b];
+    }
+}
+
+template< typename MatrixType, typename MemorySpace >
+void bin_density(const MatrixType& A, size_t row_begin, size_t row_end,
+                 const density_bin_index& index,
+                 cusp::array1d<unsigned int,cusp::host_memory>& counts,
+                 MemorySpace)
+{
+    typedef typename MatrixType::index_type IndexType;
+
+    const size_t entry_begin = A.row_offsets[row_begin];
+    const size_t entry_end   = A.row_offsets[row_end];
+
+    const size_t chunk = std::min(density_chunk_size, entry_end - entry_begin);
+
+    cusp::array1d<unsigned int,MemorySpace> keys(chunk);
+    cusp::array1d<unsigned int,MemorySpace> bins(chunk);
+    cusp::array1d<unsigned int,MemorySpace> bin_counts(chunk);
+
+    density_bin<IndexType> bin_of(thrust::raw_pointer_cast(A.row_offsets.data()),
+                                  thrust::raw_pointer_cast(A.column_indices.data()),
+                                  row_begin, row_end, index);
+
+    for (size_t first = entry_begin; first < entry_end; first += chunk)
+    {
+        const size_t last = std::min(first + chunk, entry_end);
+
+        thrust::transform(thrust::counting_iterator<IndexType,MemorySpace>(first),
+                          thrust::counting_iterator<IndexType,MemorySpace>(last),
+                          keys.begin(), bin_of);
+
+        thrust::sort(keys.begin(), keys.begin() + (last - first));
+
+        size_t num_bins =
+            thrust::reduce_by_key(keys.begin(), keys.begin() + (last - first),
+                                  thrust::constant_iterator<unsigned int>(1),
+                                  bins.begin(), bin_counts.begin()).first - bins.begin();
+
+        // the entries outside of the columns sort last
+        if (num_bins > 0 && bins[num_bins - 1] == density_outside)
+            num_bins--;
+
+        cusp::array1d<unsigned int,cusp::host_memory> bins_host(bins.begin(), bins.begin() + num_bins);
+        cusp::array1d<unsigned int,cusp::host_memory> bin_counts_host(bin_counts.begin(), bin_counts.begin() + num_bins);
+
+        for (size_t i = 0; i < num_bins; i++)
+            counts[bins_host[i]] += bin_counts_host[i];
+    }
+}
+
+} // end detail
+
+template< typename MatrixType >
+void bin_density(const MatrixType& A, size_t row_begin, size_t col_begin,
+                 size_t row_bin, size_t col_bin,
+                 size_t num_bin_rows, size_t num_bin_cols,
+                 cusp::array1d<unsigned int,cusp::host_memory>& counts)
+{
+    counts.resize(num_bin_rows * num_bin_cols);
+    thrust::fill(counts.begin(), counts.end(), 0u);
+
+    const size_t row_end = std::min<size_t>(A.num_rows, row_begin + num_bin_rows * row_bin);
+    const size_t col_end = std::min<size_t>(A.num_cols, col_begin + num_bin_cols * col_bin);
+
+    if (row_begin >= row_end || col_begin >= col_end)
+        return;
+
+    if (A.row_offsets[row_begin] == A.row_offsets[row_end])
+        return;
+
+    detail::density_bin_index index(row_begin, col_begin, col_end, row_bin, col_bin, num_bin_cols);
+
+    detail::bin_density(A, row_begin, row_end, index, counts, typename MatrixType::memory_space());
+}
+
+} // end spy
+} // end opengl
+} // end cusp
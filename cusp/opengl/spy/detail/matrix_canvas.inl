@@ -124,7 +124,13 @@ void matrix_canvas<IndexType,ValueType,MemorySpace>::draw()
     int r1=(int)floor(y1),r2=(int)floor(y2);
     int c1=(int)floor(x1),c2=(int)floor(x2);
 
-    if (std::max(x2-x1,y2-y1) < 16384)
+    if (_m.num_entries > (size_t)large_scale_nz &&
+            permutation_state == no_permutation && x2-x1 > width)
+    {
+        // entries are smaller than a pixel, so draw their density
+        draw_density(x1,y1,x2,y2);
+    }
+    else if (std::max(x2-x1,y2-y1) < 16384)
     {
         //std::cout << "drawing partial matrix (" << r1 << ", " << c1 << ") - ("
         //     << r2 << ", " << c2 << ")" << std::endl;
@@ -321,6 +327,184 @@ void matrix_canvas<IndexType,ValueType,MemorySpace>::draw_partial_matrix(int r1,
     draw_matrix_dispatch<true>(r1,c1,r2,c2);
 }
 
+/**
+ * Draw the density tiles covering the world extents (x1,y1)-(x2,y2) at
+ * the finest level whose bins are at least a pixel.  A missing band of
+ * tiles is binned on the memory space of the matrix; when more are
+ * missing the display continues in the next frame, so zooming in only
+ * refines the visible tiles.
+ */
+template< typename IndexType, typename ValueType, typename MemorySpace >
+void matrix_canvas<IndexType,ValueType,MemorySpace>::draw_density(float x1, float y1, float x2, float y2)
+{
+    long m = _m.num_rows;
+    long n = _m.num_cols;
+
+    float cells_per_pixel = (x2 - x1) / (float)width;
+
+    int level = 0;
+    while (level < 30 && (float)(1L << level) < cells_per_pixel) {
+        ++level;
+    }
+
+    long span = (long)density_tile_size << level;
+
+    int tr1 = (int)(std::max(0L, (long)floor(y1)) / span);
+    int tr2 = (int)(std::min(m - 1, (long)floor(y2)) / span);
+    int tc1 = (int)(std::max(0L, (long)floor(x1)) / span);
+    int tc2 = (int)(std::min(n - 1, (long)floor(x2)) / span);
+
+    if (tr1 > tr2 || tc1 > tc2) {
+        return;
+    }
+
+    if ((int)density_tiles.size() > max_density_tiles) {
+        clear_density_tiles(level);
+    }
+    if ((int)density_tiles.size() > max_density_tiles) {
+        clear_density_tiles();
+    }
+
+    // bin one band of tiles per frame
+    bool built = false;
+    for (int tr = tr1; tr <= tr2; ++tr)
+    {
+        for (int tc = tc1; tc <= tc2; ++tc)
+        {
+            if (density_tiles.count(density_tile_key(level, std::make_pair(tr, tc))) == 0)
+            {
+                if (built) {
+                    display_finished = false;
+                } else {
+                    build_density_band(level, tr, tc1, tc2);
+                    built = true;
+                }
+                break;
+            }
+        }
+    }
+
+    glEnable(GL_TEXTURE_2D);
+    glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE);
+
+    for (int tr = tr1; tr <= tr2; ++tr)
+    {
+        for (int tc = tc1; tc <= tc2; ++tc)
+        {
+            typename std::map< density_tile_key, GLuint >::iterator tile =
+                density_tiles.find(density_tile_key(level, std::make_pair(tr, tc)));
+
+            if (tile == density_tiles.end()) {
+                continue;
+            }
+
+            GLfloat x = (GLfloat)(tc*span) - 0.5f;
+            GLfloat y = (GLfloat)(tr*span) - 0.5f;
+            GLfloat s = (GLfloat)span;
+
+            glBindTexture(GL_TEXTURE_2D, tile->second);
+            glBegin(GL_QUADS);
+            glTexCoord2f(0.0f, 0.0f); glVertex2f(x, y);
+            glTexCoord2f(1.0f, 0.0f); glVertex2f(x + s, y);
+            glTexCoord2f(1.0f, 1.0f); glVertex2f(x + s, y + s);
+            glTexCoord2f(0.0f, 1.0f); glVertex2f(x, y + s);
+            glEnd();
+        }
+    }
+
+    glDisable(GL_TEXTURE_2D);
+}
+
+/**
+ * Bin the tiles [tile_col1, tile_col2] of a row of tiles at level in one
+ * pass over the entries of its rows and upload them as textures.  The
+ * color of a texel is the fraction of its cells holding an entry on a log
+ * scale, and empty texels are transparent.
+ */
+template< typename IndexType, typename ValueType, typename MemorySpace >
+void matrix_canvas<IndexType,ValueType,MemorySpace>::build_density_band(int level, int tile_row,
+                                                                        int tile_col1, int tile_col2)
+{
+    const int ts = density_tile_size;
+
+    size_t bin = size_t(1) << level;
+    size_t span = bin * ts;
+    int num_tiles = tile_col2 - tile_col1 + 1;
+
+    cusp::array1d<unsigned int,cusp::host_memory> counts;
+    bin_density(_m, tile_row*span, tile_col1*span, bin, bin, ts, num_tiles*ts, counts);
+
+    float inv_log_capacity = 1.0f/log(1.0f + (float)bin*(float)bin);
+
+    std::vector<GLubyte> image(4*ts*ts);
+
+    for (int t = 0; t < num_tiles; ++t)
+    {
+        for (int i = 0; i < ts; ++i)
+        {
+            for (int j = 0; j < ts; ++j)
+            {
+                unsigned int count = counts[(size_t)i*num_tiles*ts + t*ts + j];
+                GLubyte *texel = &image[4*(i*ts + j)];
+
+                if (count == 0) {
+                    texel[0] = texel[1] = texel[2] = texel[3] = 0;
+                    continue;
+                }
+
+                float v = std::min(1.0f, log(1.0f + (float)count)*inv_log_capacity);
+
+                int colormap_entry = (int)(v*(colormap.size-1));
+                if (colormap_invert) {
+                    colormap_entry = colormap.size-1-colormap_entry;
+                }
+
+                texel[0] = (GLubyte)(255.0f*colormap.map[colormap_entry*3]);
+                texel[1] = (GLubyte)(255.0f*colormap.map[colormap_entry*3+1]);
+                texel[2] = (GLubyte)(255.0f*colormap.map[colormap_entry*3+2]);
+                texel[3] = 255;
+            }
+        }
+
+        density_tile_key key(level, std::make_pair(tile_row, tile_col1 + t));
+
+        GLuint texture;
+        if (density_tiles.count(key)) {
+            texture = density_tiles[key];
+        } else {
+            glGenTextures(1, &texture);
+        }
+
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, ts, ts, 0, GL_RGBA, GL_UNSIGNED_BYTE, &image[0]);
+
+        density_tiles[key] = texture;
+    }
+}
+
+/**
+ * Delete the density tiles of every level but keep_level.
+ */
+template< typename IndexType, typename ValueType, typename MemorySpace >
+void matrix_canvas<IndexType,ValueType,MemorySpace>::clear_density_tiles(int keep_level)
+{
+    typename std::map< density_tile_key, GLuint >::iterator tile = density_tiles.begin();
+
+    while (tile != density_tiles.end())
+    {
+        if (tile->first.first != keep_level) {
+            glDeleteTextures(1, &tile->second);
+            density_tiles.erase(tile++);
+        } else {
+            ++tile;
+        }
+    }
+}
+
 /**
  * Compute a point_alpha from the current zoom level.
  *
@@ -545,6 +729,7 @@ bool matrix_canvas<IndexType,ValueType,MemorySpace>::load_matrix(const MatrixTyp
     matrix_loaded = false;
 
     _m = A;
+    clear_density_tiles();
 
     int m = A.num_rows;
     int n = A.num_cols;
@@ -808,6 +993,7 @@ void matrix_canvas<IndexType,ValueType,MemorySpace>::set_colormap(colormap_state
 	break;
     }
 
+    clear_density_tiles();
     glutPostRedisplay();
 }
 
@@ -922,6 +1108,7 @@ void matrix_canvas<IndexType,ValueType,MemorySpace>::menu(int value)
 
     case menu_colormap_invert:
         colormap_invert = !colormap_invert;
+        clear_density_tiles();
         update_screen = true;
         break;
 
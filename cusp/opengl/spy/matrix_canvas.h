@@ -19,9 +19,12 @@
 #include <string>
 #include <limits>
 #include <cmath>
+#include <map>
+#include <utility>
 #include <vector>
 
 #include <cusp/csr_matrix.h>
+#include <cusp/opengl/spy/density.h>
 #include <cusp/opengl/spy/glut_2d_canvas.h>
 #include <cusp/opengl/spy/matrix_data_panel.h>
 #include <cusp/opengl/spy/matrix_data_cursor.h>
@@ -45,10 +48,20 @@ class matrix_canvas
 protected:
     typedef glut_2d_canvas super;
 
-    // large_scale_nz controls when we build the matrix _m_fast to draw
-    // quickly and then ``fill in'' later
+    // matrices with more than large_scale_nz entries are drawn from
+    // density tiles instead of points once an entry is smaller than a pixel
     const static int large_scale_nz = 524288;
 
+    // The density tiles form a level-of-detail pyramid: each texel of a
+    // tile at level l counts the entries of 2^l by 2^l cells, and a tile
+    // covers density_tile_size texels on a side.  Only the visible tiles of
+    // the level matching the zoom are binned, one band of tiles per frame.
+    const static int density_tile_size = 256;
+    const static int max_density_tiles = 512;
+
+    typedef std::pair< int, std::pair<int,int> > density_tile_key;
+    std::map< density_tile_key, GLuint > density_tiles;
+
     cusp::csr_matrix<IndexType, ValueType, MemorySpace> _m;
 
     std::vector<IndexType> irperm;
@@ -165,6 +178,10 @@ protected:
     template <bool partial>
     void draw_matrix_dispatch(int r1, int c1, int r2, int c2);
 
+    void draw_density(float x1, float y1, float x2, float y2);
+    void build_density_band(int level, int tile_row, int tile_col1, int tile_col2);
+    void clear_density_tiles(int keep_level = -1);
+
     void write_svg();
 
     float alpha_from_zoom();
@@ -0,0 +1,94 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*! \file permute.h
+ *  \brief Symmetric permutation and submatrix extraction
+ */
+
+#pragma once
+
+#include <cusp/detail/config.h>
+
+namespace cusp
+{
+
+/*! \addtogroup algorithms Algorithms
+ *  \ingroup algorithms
+ *  \{
+ */
+
+/*! \p symmetric_permute : reorder the rows and columns of a square matrix
+ *
+ * Computes <tt>B = P A P^T</tt>, where row \c i of \c B is row
+ * \c permutation[i] of \c A and the columns are renumbered the same way.
+ * The rows of \c A are copied directly into their new positions in CSR
+ * format, with one thread per row renumbering and, only when the new
+ * column order requires it, sorting the entries of its row.
+ *
+ * \param A square input matrix
+ * \param permutation row \c i of \p B is row \c permutation[i] of \p A
+ * \param B output matrix
+ *
+ * \tparam MatrixType1 matrix
+ * \tparam ArrayType array1d of indices
+ * \tparam MatrixType2 matrix
+ *
+ *  The following code snippet reorders a matrix in RCM order.
+ *
+ *  \code
+ *  #include <cusp/permute.h>
+ *  #include <cusp/graph/symmetric_rcm.h>
+ *  ...
+ *
+ *  cusp::array1d<int,cusp::device_memory> permutation;
+ *  cusp::graph::symmetric_rcm(A, permutation);
+ *
+ *  cusp::csr_matrix<int,float,cusp::device_memory> B;
+ *  cusp::symmetric_permute(A, permutation, B);
+ *  \endcode
+ */
+template <typename MatrixType1, typename ArrayType, typename MatrixType2>
+void symmetric_permute(const MatrixType1& A, const ArrayType& permutation, MatrixType2& B);
+
+/*! \p extract_submatrix : extract the entries of a matrix in given rows and columns
+ *
+ * Computes <tt>B(i,j) = A(rows[i], cols[j])</tt>.  The columns are looked
+ * up in a map from the columns of \c A to those of \c B, so that every row
+ * of \c B is counted and filled by one thread without forming the matrix
+ * in COO format.
+ *
+ * \param A input matrix
+ * \param rows rows of \p A to extract, in the order of the rows of \p B
+ * \param cols distinct columns of \p A to extract, in the order of the
+ *        columns of \p B
+ * \param B output matrix
+ *
+ * \tparam MatrixType1 matrix
+ * \tparam ArrayType1 array1d of indices
+ * \tparam ArrayType2 array1d of indices
+ * \tparam MatrixType2 matrix
+ *
+ * \note \p rows may repeat a row of \p A, but \p cols must be distinct.
+ */
+template <typename MatrixType1, typename ArrayType1, typename ArrayType2, typename MatrixType2>
+void extract_submatrix(const MatrixType1& A, const ArrayType1& rows, const ArrayType2& cols, MatrixType2& B);
+
+/*! \}
+ */
+
+} // end namespace cusp
+
+#include <cusp/detail/permute.inl>
@@ -0,0 +1,164 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+/*! \file permuted_matrix.h
+ *  \brief Symmetrically reordered matrix which works in the original ordering
+ */
+
+#pragma once
+
+#include <cusp/detail/config.h>
+
+#include <cusp/array1d.h>
+#include <cusp/linear_operator.h>
+
+namespace cusp
+{
+
+/*! \addtogroup sparse_matrices Sparse Matrices
+ */
+
+/*! \addtogroup sparse_matrix_containers Sparse Matrix Containers
+ *  \ingroup sparse_matrices
+ *  \{
+ */
+
+/*! Orderings computed by \p permuted_matrix from the matrix alone.
+ *
+ *  \c reorder_rcm uses the reverse Cuthill-McKee ordering of
+ *  \p cusp::graph::symmetric_rcm to reduce the bandwidth and
+ *  \c reorder_degree sorts the rows by increasing number of entries.
+ *  Orderings from coordinates, such as
+ *  \p cusp::graph::hilbert_curve_ordering, are passed as a permutation.
+ */
+enum reordering_method
+{
+  reorder_rcm,
+  reorder_degree
+};
+
+/*! \p permuted_matrix : symmetrically reordered copy of a square matrix
+ *
+ * The matrix <tt>B = P A P^T</tt> is stored in \p matrix together with the
+ * \p permutation which defines it, row \c i of \c B being row
+ * \c permutation[i] of \c A.  Reorderings which cluster the entries near
+ * the diagonal improve the reuse of \c x during multiplication.
+ *
+ * A \p permuted_matrix is a linear operator in the original ordering, so
+ * it can replace \c A in any solver.  Each application then permutes its
+ * input and output, which solvers avoid by working on \p matrix in the
+ * reordered space and calling \p permute on entry and \p unpermute on exit.
+ *
+ * \tparam MatrixType Type of the reordered matrix (e.g. \c cusp::csr_matrix).
+ *
+ *  The following code snippet solves a linear system in RCM order.
+ *
+ *  \code
+ *  #include <cusp/csr_matrix.h>
+ *  #include <cusp/permuted_matrix.h>
+ *  #include <cusp/krylov/cg.h>
+ *  ...
+ *
+ *  cusp::permuted_matrix< cusp::csr_matrix<int,float,cusp::device_memory> > P(A, cusp::reorder_rcm);
+ *
+ *  cusp::array1d<float,cusp::device_memory> x_new(P.num_rows, 0);
+ *  cusp::array1d<float,cusp::device_memory> b_new(P.num_rows);
+ *
+ *  P.permute(b, b_new);
+ *  cusp::krylov::cg(P.matrix, x_new, b_new);
+ *  P.unpermute(x_new, x);
+ *  \endcode
+ */
+template <typename MatrixType>
+class permuted_matrix
+  : public cusp::linear_operator<typename MatrixType::value_type,
+                                 typename MatrixType::memory_space,
+                                 typename MatrixType::index_type>
+{
+    typedef cusp::linear_operator<typename MatrixType::value_type,
+                                  typename MatrixType::memory_space,
+                                  typename MatrixType::index_type> Parent;
+  public:
+    typedef typename MatrixType::index_type   index_type;
+    typedef typename MatrixType::value_type   value_type;
+    typedef typename MatrixType::memory_space memory_space;
+
+    /*! type of the reordered matrix
+     */
+    typedef MatrixType matrix_type;
+
+    /*! type of permutation array
+     */
+    typedef typename cusp::array1d<index_type, memory_space> permutation_array_type;
+
+    /*! Original row index of each row of the reordered matrix.
+     */
+    permutation_array_type permutation;
+
+    /*! The reordered matrix.
+     */
+    MatrixType matrix;
+
+    /*! Construct an empty \p permuted_matrix.
+     */
+    permuted_matrix() {}
+
+    /*! Reorder a matrix with one of the orderings computed from its structure.
+     *
+     *  \param A Square sparse matrix.
+     *  \param method Ordering to compute (default \c reorder_rcm).
+     */
+    template <typename MatrixType2>
+    permuted_matrix(const MatrixType2& A, reordering_method method = reorder_rcm);
+
+    /*! Reorder a matrix with a given permutation.
+     *
+     *  \param A Square sparse matrix.
+     *  \param permutation Row \c i of the reordered matrix is row
+     *         \c permutation[i] of \p A.
+     */
+    template <typename MatrixType2, typename ArrayType>
+    permuted_matrix(const MatrixType2& A, const ArrayType& permutation);
+
+    /*! Gather a vector in the original ordering into the reordered space.
+     */
+    template <typename VectorType1, typename VectorType2>
+    void permute(const VectorType1& x, VectorType2& x_new) const;
+
+    /*! Scatter a vector in the reordered space back into the original ordering.
+     */
+    template <typename VectorType1, typename VectorType2>
+    void unpermute(const VectorType1& x_new, VectorType2& x) const;
+
+    /*! Compute <tt>y = A * x</tt> with \p x and \p y in the original ordering.
+     */
+    template <typename VectorType1, typename VectorType2>
+    void operator()(const VectorType1& x, VectorType2& y) const;
+
+  private:
+    template <typename MatrixType2>
+    void reorder(const MatrixType2& A);
+
+    mutable cusp::array1d<value_type, memory_space> x_work;
+    mutable cusp::array1d<value_type, memory_space> y_work;
+}; // class permuted_matrix
+/*! \}
+ */
+
+} // end namespace cusp
+
+#include <cusp/detail/permuted_matrix.inl>
@@ -0,0 +1,240 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*! \file additive_schwarz.h
+ *  \brief Overlapping additive Schwarz preconditioner.
+ */
+
+#pragma once
+
+#include <cusp/detail/config.h>
+
+#include <cusp/array1d.h>
+#include <cusp/csr_matrix.h>
+#include <cusp/linear_operator.h>
+
+#include <cusp/precond/block_jacobi.h>
+#include <cusp/precond/parilu.h>
+
+namespace cusp
+{
+namespace precond
+{
+
+/*! \addtogroup preconditioners Preconditioners
+ *  \ingroup preconditioners
+ *  \{
+ */
+
+/*! Solvers of the subdomain problems of \p additive_schwarz
+ */
+enum schwarz_local_solver
+{
+    schwarz_automatic,      //!< dense LU when every subdomain is small, ILU otherwise
+    schwarz_dense_lu,       //!< exact solves with the dense inverse of each subdomain matrix
+    schwarz_incomplete_lu   //!< approximate solves with a \p parilu factorization
+};
+
+/*! \p additive_schwarz : overlapping additive Schwarz preconditioner
+ *
+ *  The rows of \c A are partitioned into subdomains, for instance by
+ *  \p cusp::graph::partition or \p cusp::graph::hilbert_curve, and each
+ *  subdomain is extended by the rows within \c overlap edges of the graph
+ *  of \c A.  The preconditioner implements
+ *
+ *  <tt>y = sum_i R_i^T A_i^-1 R_i x</tt>
+ *
+ *  where \c R_i restricts a vector to the extended subdomain \c i and
+ *  <tt>A_i = R_i A R_i^T</tt>.  The matrices \c A_i are extracted once
+ *  during the setup into one block diagonal matrix, so all subdomains are
+ *  solved together by the same kernels: small subdomains by the batched
+ *  dense LU of \p block_jacobi, large ones by a \p parilu factorization,
+ *  whose factors never couple two subdomains.
+ *
+ *  With \c restricted set, each row takes its value from the subdomain it
+ *  belongs to only (restricted additive Schwarz).  This usually converges
+ *  faster, but the preconditioner is not symmetric and should be used with
+ *  a nonsymmetric solver such as \p cusp::krylov::gmres.
+ *
+ *  An optional coarse space adds the correction <tt>P A_c^-1 P^T x</tt>,
+ *  where \c P is constant on every part (or on every aggregate, when
+ *  aggregates such as those of \p standard_aggregation are given) and
+ *  <tt>A_c = P^T A P</tt>.  It propagates information between distant
+ *  subdomains, so the number of iterations no longer grows with the
+ *  number of subdomains.
+ *
+ *  \tparam ValueType Type used for matrix values (e.g. \c float or \c double).
+ *  \tparam MemorySpace A memory space (e.g. \c cusp::host_memory or cusp::device_memory)
+ *
+ *  \note The coarse matrix is inverted as a single dense block, so the
+ *        number of parts or aggregates of the coarse space should stay in
+ *        the hundreds.
+ *  \note A \p cusp::runtime_exception is thrown if a subdomain matrix
+ *        solved by dense LU or the coarse matrix is singular.
+ *
+ *  The following code snippet demonstrates how to use an \p additive_schwarz
+ *  preconditioner with 64 subdomains, an overlap of two and a coarse space.
+ *
+ *  \code
+ *  #include <cusp/precond/additive_schwarz.h>
+ *  #include <cusp/graph/partition.h>
+ *  #include <cusp/krylov/cg.h>
+ *  ...
+ *
+ *  cusp::array1d<int, cusp::device_memory> parts(A.num_rows);
+ *  cusp::graph::partition(A, 64, parts);
+ *
+ *  cusp::precond::additive_schwarz<float, cusp::device_memory> M(A, parts, 2, true);
+ *
+ *  cusp::krylov::cg(A, x, b, monitor, M);
+ *  \endcode
+ */
+template <typename ValueType, typename MemorySpace>
+class additive_schwarz : public linear_operator<ValueType, MemorySpace>
+{
+    typedef linear_operator<ValueType, MemorySpace> Parent;
+
+public:
+    /*! Number of graph levels added around every part.
+     */
+    size_t overlap;
+
+    /*! Whether rows take their value from their own subdomain only.
+     */
+    bool restricted;
+
+    /*! Solver of the subdomain problems.
+     */
+    schwarz_local_solver local_solver;
+
+    /*! Rows of the extended subdomains sorted by subdomain, subdomain \c i
+     *  holds <tt>subdomain_rows[subdomain_offsets[i], subdomain_offsets[i+1])</tt>
+     *  in increasing order.
+     */
+    cusp::array1d<int,MemorySpace> subdomain_rows;
+    cusp::array1d<int,MemorySpace> subdomain_offsets;
+
+    /*! Subdomain of each entry of \c subdomain_rows.
+     */
+    cusp::array1d<int,MemorySpace> subdomain_parts;
+
+    /*! Entries of \c subdomain_rows sorted by row, the copies of row \c i
+     *  are <tt>row_copies[row_offsets[i], row_offsets[i+1])</tt>.  Empty
+     *  when \c restricted is set.
+     */
+    cusp::array1d<int,MemorySpace> row_copies;
+    cusp::array1d<int,MemorySpace> row_offsets;
+
+    /*! Entry of \c subdomain_rows of each row in its own part.  Empty
+     *  unless \c restricted is set.
+     */
+    cusp::array1d<int,MemorySpace> row_owners;
+
+    /*! Solvers of the block diagonal matrix of the subdomain problems,
+     *  only the one selected by \c local_solver is set.
+     */
+    block_jacobi<ValueType,MemorySpace> dense_solver;
+    parilu<ValueType,MemorySpace> ilu_solver;
+
+    /*! Coarse space: aggregate of each row, restriction <tt>P^T</tt> and
+     *  dense inverse of the coarse matrix.  Empty without coarse space.
+     */
+    cusp::array1d<int,MemorySpace> aggregates;
+    cusp::csr_matrix<int,ValueType,MemorySpace> restriction;
+    block_jacobi<ValueType,MemorySpace> coarse_solver;
+
+    mutable cusp::array1d<ValueType,MemorySpace> x_local;
+    mutable cusp::array1d<ValueType,MemorySpace> y_local;
+    mutable cusp::array1d<ValueType,MemorySpace> x_coarse;
+    mutable cusp::array1d<ValueType,MemorySpace> y_coarse;
+
+    /*! construct an empty \p additive_schwarz preconditioner
+     */
+    additive_schwarz(void);
+
+    /*! construct an \p additive_schwarz preconditioner
+     *
+     * \param A square matrix to precondition
+     * \param parts part of each row
+     * \param overlap number of graph levels added around every part
+     * \param coarse_space add a coarse correction constant on every part
+     * \param restricted use restricted additive Schwarz
+     * \param local_solver solver of the subdomain problems
+     * \tparam MatrixType matrix
+     */
+    template <typename MatrixType, typename IndexType, typename MemorySpace2>
+    additive_schwarz(const MatrixType& A, const cusp::array1d<IndexType,MemorySpace2>& parts,
+                     const size_t overlap = 1, const bool coarse_space = false, const bool restricted = false,
+                     const schwarz_local_solver local_solver = schwarz_automatic);
+
+    /*! construct an \p additive_schwarz preconditioner with a coarse space
+     *  constant on given aggregates
+     *
+     * \param A square matrix to precondition
+     * \param parts part of each row
+     * \param aggregates aggregate of each row
+     * \param overlap number of graph levels added around every part
+     * \param restricted use restricted additive Schwarz
+     * \param local_solver solver of the subdomain problems
+     * \tparam MatrixType matrix
+     */
+    template <typename MatrixType, typename IndexType, typename MemorySpace2, typename IndexType2, typename MemorySpace3>
+    additive_schwarz(const MatrixType& A, const cusp::array1d<IndexType,MemorySpace2>& parts,
+                     const cusp::array1d<IndexType2,MemorySpace3>& aggregates,
+                     const size_t overlap = 1, const bool restricted = false,
+                     const schwarz_local_solver local_solver = schwarz_automatic);
+
+    template <typename MemorySpace2>
+    additive_schwarz(const additive_schwarz<ValueType,MemorySpace2>& M);
+
+    /*! number of subdomains
+     */
+    size_t num_subdomains(void) const
+    {
+        return subdomain_offsets.size() == 0 ? 0 : subdomain_offsets.size() - 1;
+    }
+
+    /*! whether the preconditioner has a coarse space
+     */
+    bool has_coarse_space(void) const
+    {
+        return aggregates.size() > 0;
+    }
+
+    /*! apply the preconditioner to vector \p x and store the result in \p y
+     *
+     * \param x input vector
+     * \param y ouput vector
+     * \tparam VectorType1 vector
+     * \tparam VectorType2 vector
+     */
+    template <typename VectorType1, typename VectorType2>
+    void operator()(const VectorType1& x, VectorType2& y) const;
+
+private:
+    template <typename MatrixType>
+    void setup(const MatrixType& A, const cusp::array1d<int,MemorySpace>& parts);
+
+    template <typename MatrixType>
+    void setup_coarse_space(const MatrixType& A);
+};
+/*! \}
+ */
+
+} // end namespace precond
+} // end namespace cusp
+
+#include <cusp/precond/detail/additive_schwarz.inl>
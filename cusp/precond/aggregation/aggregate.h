@@ -31,6 +31,16 @@ void standard_aggregation(const Matrix& C, Array& aggregates);
 template <typename Matrix, typename Array>
 void standard_aggregation(const Matrix& C, Array& aggregates, Array& roots);
 
+/*! Aggressive coarsening: \p standard_aggregation followed by
+ *  <tt>passes - 1</tt> standard aggregations of the graph of the previous
+ *  aggregates, so each pass merges neighbouring aggregates into one.  Two
+ *  passes give aggregates of roughly twice the diameter and much fewer
+ *  levels for 3D problems.  Aggregates that are left isolated in a pass
+ *  are kept as they are and unaggregated nodes remain -1.
+ */
+template <typename Matrix, typename Array>
+void aggressive_aggregation(const Matrix& C, Array& aggregates, const size_t passes = 2);
+
 } // end namespace aggregation
 } // end namespace precond
 } // end namespace cusp
@@ -18,16 +18,22 @@
 #include <cusp/csr_matrix.h>
 
 #include <cusp/graph/maximal_independent_set.h>
+#include <cusp/detail/format_utils.h>
+#include <cusp/detail/host/parallel.h>
 #include <cusp/detail/device/generalized_spmv/coo_flat.h>
 
 #include <thrust/count.h>
+#include <thrust/extrema.h>
 #include <thrust/fill.h>
+#include <thrust/remove.h>
 #include <thrust/scan.h>
 #include <thrust/gather.h>
 #include <thrust/transform.h>
+#include <thrust/unique.h>
 #include <thrust/iterator/zip_iterator.h>
 #include <thrust/iterator/constant_iterator.h>
 #include <thrust/iterator/counting_iterator.h>
+#include <thrust/iterator/permutation_iterator.h>
 
 namespace cusp
 {
@@ -143,125 +149,331 @@ void standard_aggregation(const Matrix& C,
     }
 }
 
-template <typename Matrix, typename Array>
-void standard_aggregation(const Matrix& C,
-                          Array& aggregates,
-                          Array& roots,
-                          cusp::csr_format,
-                          cusp::host_memory)
-{
-    CUSP_PROFILE_SCOPED();
+// The host path aggregates around an MIS(2), like the device path, but
+// with every pass parallel over the rows of C.  The MIS is found by the
+// rounds of the device MIS(k), with the same hashed priorities, and every
+// node then joins the largest root of its 2-ring.  A pass only reads the
+// arrays of the previous pass and writes the entries of its own rows, so
+// the aggregates are the same for any number of threads.
 
+// f(i) for the rows i of C, in blocks of rows balanced by their entries
+template <typename Matrix, typename UnaryFunction>
+void for_each_row(const Matrix& C, const UnaryFunction f)
+{
     typedef typename Matrix::index_type IndexType;
-    CUSP_PROFILE_SCOPED();
 
-    IndexType next_aggregate = 1; // number of aggregates + 1
+    const size_t N = C.num_rows;
+    const int    P = cusp::detail::host::num_parts(C.num_entries + N);
 
-    // initialize aggregates to 0
-    thrust::fill(aggregates.begin(), aggregates.end(), 0);
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(static) num_threads(P)
+#endif
+    for (int part = 0; part < P; part++)
+    {
+        const size_t i_end = cusp::detail::host::balanced_split(C.row_offsets, N, part + 1, P);
 
-    IndexType n_row = C.num_rows;
+        for (size_t i = cusp::detail::host::balanced_split(C.row_offsets, N, part, P); i < i_end; i++)
+            f(IndexType(i));
+    }
+}
 
-    //Pass #1
-    for (IndexType i = 0; i < n_row; i++)
-    {
-        if (aggregates[i]) {
-            continue;    //already marked
-        }
+// undecided nodes which are the maximum of their 2-ring join the MIS, and
+// those whose maximum joins it, or has joined it before, leave the graph
+template <typename IndexType>
+struct decide_mis_node
+{
+    const int * states;
+    const IndexType * maximal_indices;
+    int * next_states;
 
-        const IndexType row_start = C.row_offsets[i];
-        const IndexType row_end   = C.row_offsets[i+1];
+    decide_mis_node(const int * states, const IndexType * maximal_indices, int * next_states)
+        : states(states), maximal_indices(maximal_indices), next_states(next_states) {}
 
-        //Determine whether all neighbors of this node are free (not already aggregates)
-        bool has_aggregated_neighbors = false;
-        bool has_neighbors            = false;
+    void operator()(const IndexType i) const
+    {
+        int s = states[i];
 
-        for (IndexType jj = row_start; jj < row_end; jj++)
+        if (s == 1)
         {
-            const IndexType j = C.column_indices[jj];
-            if ( i != j )
-            {
-                has_neighbors = true;
-                if ( aggregates[j] )
-                {
-                    has_aggregated_neighbors = true;
-                    break;
-                }
-            }
+            const IndexType j = maximal_indices[i];
+
+            if (j == i)
+                s = 2;
+            else if (states[j] == 2 || (states[j] == 1 && maximal_indices[j] == j))
+                s = 0;
         }
 
-        if (!has_neighbors)
+        next_states[i] = s;
+    }
+};
+
+// largest (weight, root) of the 1-ring of every node.  On the first ring
+// the pair of node j is (1, j) for the MIS nodes and (0, j) otherwise, and
+// the MIS nodes add one to their weight so that they keep themselves on
+// the second ring, whose pairs are those found on the first.
+template <typename IndexType>
+struct largest_root_in_ring
+{
+    const IndexType * Ap;
+    const IndexType * Aj;
+    const int * states;
+
+    // first ring, or NULL on the first ring
+    const int * last_weights;
+    const IndexType * last_roots;
+
+    int * weights;
+    IndexType * roots;
+
+    largest_root_in_ring(const IndexType * Ap, const IndexType * Aj, const int * states,
+                         const int * last_weights, const IndexType * last_roots,
+                         int * weights, IndexType * roots)
+        : Ap(Ap), Aj(Aj), states(states), last_weights(last_weights), last_roots(last_roots),
+          weights(weights), roots(roots) {}
+
+    void load(const IndexType j, int& w, IndexType& r) const
+    {
+        if (last_weights == NULL)
         {
-            //isolated node, do not aggregate
-            aggregates[i] = -n_row;
+            w = states[j] == 2;
+            r = j;
         }
-        else if (!has_aggregated_neighbors)
+        else
         {
-            //Make an aggregate out of this node and its neighbors
-            aggregates[i] = next_aggregate;
-            roots[next_aggregate-1] = i;
-            for (IndexType jj = row_start; jj < row_end; jj++) {
-                aggregates[C.column_indices[jj]] = next_aggregate;
-            }
-            next_aggregate++;
+            w = last_weights[j];
+            r = last_roots[j];
         }
     }
 
-    //Pass #2
-    // Add unaggregated nodes to any neighboring aggregate
-    for (IndexType i = 0; i < n_row; i++) {
-        if (aggregates[i]) {
-            continue;    //already marked
-        }
+    void operator()(const IndexType i) const
+    {
+        int       w;
+        IndexType r;
+
+        load(i, w, r);
+
+        for (IndexType jj = Ap[i]; jj < Ap[i + 1]; jj++)
+        {
+            int       v;
+            IndexType s;
 
-        for (IndexType jj = C.row_offsets[i]; jj < C.row_offsets[i+1]; jj++) {
-            const IndexType j = C.column_indices[jj];
+            load(Aj[jj], v, s);
 
-            const IndexType tj = aggregates[j];
-            if (tj > 0) {
-                aggregates[i] = -tj;
-                break;
+            if (v > w || (v == w && s > r))
+            {
+                w = v;
+                r = s;
             }
         }
+
+        if (last_weights == NULL && states[i] == 2)
+            w++;
+
+        weights[i] = w;
+        roots[i]   = r;
     }
+};
 
-    next_aggregate--;
-
-    //Pass #3
-    for (IndexType i = 0; i < n_row; i++) {
-        const IndexType ti = aggregates[i];
-
-        if (ti != 0) {
-            // node i has been aggregated
-            if (ti > 0)
-                aggregates[i] = ti - 1;
-            else if (ti == -n_row)
-                aggregates[i] = -1;
-            else
-                aggregates[i] = -ti - 1;
-            continue;
-        }
+// 1 for the MIS nodes with a neighbor, which root an aggregate, else 0
+template <typename IndexType>
+struct count_root_node
+{
+    const IndexType * Ap;
+    const IndexType * Aj;
+    const int * states;
+    IndexType * counts;
 
-        // node i has not been aggregated
-        const IndexType row_start = C.row_offsets[i];
-        const IndexType row_end   = C.row_offsets[i+1];
+    count_root_node(const IndexType * Ap, const IndexType * Aj, const int * states, IndexType * counts)
+        : Ap(Ap), Aj(Aj), states(states), counts(counts) {}
 
-        aggregates[i] = next_aggregate;
-        roots[next_aggregate] = i;
+    void operator()(const IndexType i) const
+    {
+        IndexType count = 0;
 
-        for (IndexType jj = row_start; jj < row_end; jj++) {
-            const IndexType j = C.column_indices[jj];
+        if (states[i] == 2)
+            for (IndexType jj = Ap[i]; jj < Ap[i + 1] && count == 0; jj++)
+                if (Aj[jj] != i)
+                    count = 1;
 
-            if (aggregates[j] == 0) { //unmarked neighbors
-                aggregates[j] = next_aggregate;
-            }
+        counts[i] = count;
+    }
+};
+
+// every node joins the aggregate of its root, and isolated nodes none
+template <typename IndexType, typename T>
+struct join_root_aggregate
+{
+    const int * weights;
+    const IndexType * ring_roots;
+    const IndexType * aggregate_ids;
+    T * aggregates;
+    T * roots;
+
+    join_root_aggregate(const int * weights, const IndexType * ring_roots, const IndexType * aggregate_ids,
+                        T * aggregates, T * roots)
+        : weights(weights), ring_roots(ring_roots), aggregate_ids(aggregate_ids),
+          aggregates(aggregates), roots(roots) {}
+
+    void operator()(const IndexType i) const
+    {
+        const IndexType r = ring_roots[i];
+
+        if (weights[i] > 0 && aggregate_ids[r + 1] != aggregate_ids[r])
+            aggregates[i] = aggregate_ids[r];
+        else
+            aggregates[i] = -1;
+
+        if (aggregate_ids[i + 1] != aggregate_ids[i])
+            roots[aggregate_ids[i]] = i;
+    }
+};
+
+template <typename Matrix, typename Array>
+void standard_aggregation(const Matrix& C,
+                          Array& aggregates,
+                          Array& roots,
+                          cusp::csr_format,
+                          cusp::host_memory)
+{
+    CUSP_PROFILE_SCOPED();
+
+    typedef typename Matrix::index_type IndexType;
+    typedef typename Array::value_type  T;
+    typedef cusp::graph::detail::device::mis_ring_maximum<IndexType,int,unsigned int> RingMaximum;
+
+    const IndexType N = C.num_rows;
+
+    if (N == 0)
+        return;
+
+    const IndexType * Ap = &C.row_offsets[0];
+    const IndexType * Aj = C.num_entries == 0 ? NULL : &C.column_indices[0];
+
+    const typename RingMaximum::Priority priority(0);
+
+    // MIS(2) states: 1 undecided, 2 in the MIS, 0 out of it
+    cusp::array1d<int,cusp::host_memory> states(N, 1);
+    cusp::array1d<int,cusp::host_memory> next_states(N, cusp::uninitialized);
+
+    {
+        cusp::array1d<int,cusp::host_memory>          ring1_states(N, cusp::uninitialized);
+        cusp::array1d<unsigned int,cusp::host_memory> ring1_values(N, cusp::uninitialized);
+        cusp::array1d<IndexType,cusp::host_memory>    ring1_indices(N, cusp::uninitialized);
+        cusp::array1d<int,cusp::host_memory>          ring2_states(N, cusp::uninitialized);
+        cusp::array1d<unsigned int,cusp::host_memory> ring2_values(N, cusp::uninitialized);
+        cusp::array1d<IndexType,cusp::host_memory>    ring2_indices(N, cusp::uninitialized);
+
+        while (thrust::count(states.begin(), states.end(), 1) > 0)
+        {
+            for_each_row(C, RingMaximum(Ap, Aj, &states[0], priority,
+                                        NULL, NULL, NULL,
+                                        &ring1_states[0], &ring1_values[0], &ring1_indices[0]));
+            for_each_row(C, RingMaximum(Ap, Aj, &states[0], priority,
+                                        &ring1_states[0], &ring1_values[0], &ring1_indices[0],
+                                        &ring2_states[0], &ring2_values[0], &ring2_indices[0]));
+            for_each_row(C, decide_mis_node<IndexType>(&states[0], &ring2_indices[0], &next_states[0]));
+
+            states.swap(next_states);
         }
-        next_aggregate++;
     }
 
-    if ( next_aggregate == 0 ) {
-        thrust::fill( aggregates.begin(), aggregates.end(), 0 );
+    // find the largest root of the 2-ring of every node
+    cusp::array1d<int,cusp::host_memory>       weights1(N, cusp::uninitialized);
+    cusp::array1d<IndexType,cusp::host_memory> roots1(N, cusp::uninitialized);
+    cusp::array1d<int,cusp::host_memory>       weights2(N, cusp::uninitialized);
+    cusp::array1d<IndexType,cusp::host_memory> roots2(N, cusp::uninitialized);
+
+    for_each_row(C, largest_root_in_ring<IndexType>(Ap, Aj, &states[0], NULL, NULL, &weights1[0], &roots1[0]));
+    for_each_row(C, largest_root_in_ring<IndexType>(Ap, Aj, &states[0], &weights1[0], &roots1[0], &weights2[0], &roots2[0]));
+
+    // enumerate the roots which are not isolated
+    cusp::array1d<IndexType,cusp::host_memory> aggregate_ids(N + 1, cusp::uninitialized);
+    for_each_row(C, count_root_node<IndexType>(Ap, Aj, &states[0], &aggregate_ids[0]));
+    cusp::detail::host::counts_to_offsets(aggregate_ids, N);
+
+    if (aggregate_ids[N] == 0)
+    {
+        // every node is isolated
+        thrust::fill(aggregates.begin(), aggregates.end(), 0);
+        return;
     }
+
+    for_each_row(C, join_root_aggregate<IndexType,T>(&weights2[0], &roots2[0], &aggregate_ids[0],
+                                                     &aggregates[0], &roots[0]));
+}
+
+// true for edges with an unaggregated endpoint
+template <typename Tuple>
+struct has_unaggregated_node : thrust::unary_function<Tuple,bool>
+{
+    __host__ __device__
+    bool operator()(const Tuple& t) const
+    {
+        return thrust::get<0>(t) < 0 || thrust::get<1>(t) < 0;
+    }
+};
+
+// unaggregated nodes become aggregates of their own, numbered from the scan
+template <typename IndexType>
+struct unaggregated_to_singleton : thrust::binary_function<IndexType,IndexType,IndexType>
+{
+    __host__ __device__
+    IndexType operator()(const IndexType aggregate, const IndexType next) const
+    {
+        return aggregate < 0 ? next : aggregate;
+    }
+};
+
+// graph of the aggregates: aggregates a and b are adjacent when some
+// node of a is adjacent to some node of b in C
+template <typename Matrix, typename Array>
+void aggregate_graph(const Matrix& C,
+                     const Array& aggregates,
+                     const typename Matrix::index_type num_aggregates,
+                     Matrix& C_coarse)
+{
+    CUSP_PROFILE_SCOPED();
+
+    typedef typename Matrix::index_type   IndexType;
+    typedef typename Matrix::value_type   ValueType;
+    typedef typename Matrix::memory_space MemorySpace;
+    typedef thrust::tuple<IndexType,IndexType> Tuple;
+
+    cusp::coo_matrix<IndexType,ValueType,MemorySpace> C_coo(C);
+
+    cusp::array1d<IndexType,MemorySpace> rows(C_coo.num_entries);
+    cusp::array1d<IndexType,MemorySpace> cols(C_coo.num_entries);
+
+    thrust::copy(thrust::make_permutation_iterator(aggregates.begin(), C_coo.row_indices.begin()),
+                 thrust::make_permutation_iterator(aggregates.begin(), C_coo.row_indices.end()),
+                 rows.begin());
+    thrust::copy(thrust::make_permutation_iterator(aggregates.begin(), C_coo.column_indices.begin()),
+                 thrust::make_permutation_iterator(aggregates.begin(), C_coo.column_indices.end()),
+                 cols.begin());
+
+    IndexType num_entries =
+        thrust::remove_if(thrust::make_zip_iterator(thrust::make_tuple(rows.begin(), cols.begin())),
+                          thrust::make_zip_iterator(thrust::make_tuple(rows.end(),   cols.end())),
+                          has_unaggregated_node<Tuple>())
+        - thrust::make_zip_iterator(thrust::make_tuple(rows.begin(), cols.begin()));
+
+    rows.resize(num_entries);
+    cols.resize(num_entries);
+
+    cusp::array1d<ValueType,MemorySpace> values(num_entries, ValueType(1));
+    cusp::detail::sort_by_row_and_column(rows, cols, values);
+
+    num_entries =
+        thrust::unique(thrust::make_zip_iterator(thrust::make_tuple(rows.begin(), cols.begin())),
+                       thrust::make_zip_iterator(thrust::make_tuple(rows.end(),   cols.end())))
+        - thrust::make_zip_iterator(thrust::make_tuple(rows.begin(), cols.begin()));
+
+    cusp::coo_matrix<IndexType,ValueType,MemorySpace> G(num_aggregates, num_aggregates, num_entries);
+    thrust::copy(rows.begin(), rows.begin() + num_entries, G.row_indices.begin());
+    thrust::copy(cols.begin(), cols.begin() + num_entries, G.column_indices.begin());
+    thrust::fill(G.values.begin(), G.values.end(), ValueType(1));
+
+    C_coarse = G;
 }
 
 } // end namespace detail
@@ -282,6 +494,52 @@ void standard_aggregation(const Matrix& C,
     detail::standard_aggregation(C, aggregates, roots, typename Matrix::format(), typename Matrix::memory_space());
 }
 
+template <typename Matrix, typename Array>
+void aggressive_aggregation(const Matrix& C,
+                            Array& aggregates,
+                            const size_t passes)
+{
+    CUSP_PROFILE_SCOPED();
+
+    typedef typename Matrix::index_type IndexType;
+
+    standard_aggregation(C, aggregates);
+
+    for (size_t pass = 1; pass < passes; pass++)
+    {
+        const IndexType num_aggregates = *thrust::max_element(aggregates.begin(), aggregates.end()) + 1;
+
+        if (num_aggregates <= 1)
+            break;
+
+        // aggregate the graph of the aggregates
+        Matrix C_coarse;
+        detail::aggregate_graph(C, aggregates, num_aggregates, C_coarse);
+
+        Array coarse_aggregates(num_aggregates);
+        standard_aggregation(C_coarse, coarse_aggregates);
+
+        // aggregates left out of the second aggregation are kept as they are
+        {
+            const IndexType num_coarse = *thrust::max_element(coarse_aggregates.begin(), coarse_aggregates.end()) + 1;
+
+            Array next(num_aggregates);
+            thrust::transform(coarse_aggregates.begin(), coarse_aggregates.end(), next.begin(), thrust::placeholders::_1 < 0);
+            thrust::exclusive_scan(next.begin(), next.end(), next.begin(), num_coarse);
+            thrust::transform(coarse_aggregates.begin(), coarse_aggregates.end(), next.begin(),
+                              coarse_aggregates.begin(), detail::unaggregated_to_singleton<IndexType>());
+        }
+
+        // aggregates[i] <- coarse_aggregates[aggregates[i]] for aggregated nodes
+        Array fine_aggregates(aggregates);
+        thrust::gather_if(fine_aggregates.begin(), fine_aggregates.end(),
+                          fine_aggregates.begin(),
+                          coarse_aggregates.begin(),
+                          aggregates.begin(),
+                          thrust::placeholders::_1 >= 0);
+    }
+}
+
 
 } // end namespace aggregation
 } // end namespace precond
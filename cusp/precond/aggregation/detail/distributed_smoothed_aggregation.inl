@@ -0,0 +1,444 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include <cusp/blas.h>
+#include <cusp/exception.h>
+#include <cusp/multiply.h>
+
+#include <cusp/relaxation/jacobi.h>
+
+#include <cusp/detail/format_utils.h>
+#include <cusp/detail/stream.h>
+#include <cusp/detail/device/utils.h>
+
+#include <thrust/iterator/zip_iterator.h>
+
+#include <algorithm>
+
+namespace cusp
+{
+namespace precond
+{
+namespace aggregation
+{
+namespace detail
+{
+
+// rows and columns [begin, end) of a CSR matrix
+template <typename MatrixType>
+void extract_diagonal_block(const MatrixType& A, size_t begin, size_t end, MatrixType& B)
+{
+    typedef typename MatrixType::index_type IndexType;
+
+    size_t num_entries = 0;
+
+    for (size_t jj = A.row_offsets[begin]; jj < size_t(A.row_offsets[end]); jj++)
+        if (size_t(A.column_indices[jj]) >= begin && size_t(A.column_indices[jj]) < end)
+            num_entries++;
+
+    B.resize(end - begin, end - begin, num_entries);
+
+    size_t n = 0;
+
+    B.row_offsets[0] = 0;
+
+    for (size_t i = begin; i < end; i++)
+    {
+        for (IndexType jj = A.row_offsets[i]; jj < A.row_offsets[i + 1]; jj++)
+        {
+            const size_t j = A.column_indices[jj];
+
+            if (j >= begin && j < end)
+            {
+                B.column_indices[n] = j - begin;
+                B.values[n]         = A.values[jj];
+                n++;
+            }
+        }
+
+        B.row_offsets[i - begin + 1] = n;
+    }
+}
+
+// merges pairs of neighbouring parts until the parts hold at least
+// min_part_size rows on average or a single part remains
+inline cusp::distributed_layout
+merge_parts(const cusp::distributed_layout& layout, size_t min_part_size)
+{
+    cusp::distributed_layout merged(layout);
+
+    while (merged.num_parts() > 1 && merged.size() < min_part_size * merged.num_parts())
+    {
+        cusp::distributed_layout halved;
+        halved.offsets.clear();
+
+        for (size_t p = 0; p < merged.num_parts(); p += 2)
+        {
+            halved.devices.push_back(merged.devices[p]);
+            halved.offsets.push_back(merged.offsets[p]);
+        }
+
+        halved.offsets.push_back(merged.size());
+
+        merged = halved;
+    }
+
+    return merged;
+}
+
+} // end namespace detail
+
+///////////
+// Level //
+///////////
+
+template <typename IndexType, typename ValueType>
+distributed_smoothed_aggregation<IndexType,ValueType>::level
+::level(const SetupMatrixType& A_,
+        const cusp::distributed_layout& layout)
+  : A(A_, layout),
+    omega(0),
+    x(layout), b(layout),
+    redistribute(false)
+{
+}
+
+template <typename IndexType, typename ValueType>
+distributed_smoothed_aggregation<IndexType,ValueType>::level
+::level(const SetupMatrixType& A_,
+        const SetupMatrixType& P_,
+        const SetupMatrixType& R_,
+        const cusp::distributed_layout& layout,
+        const cusp::distributed_layout& coarse_layout,
+        const cusp::distributed_layout& next_layout,
+        const cusp::array1d<ValueType,cusp::host_memory>& diagonal_,
+        ValueType omega)
+  : A(A_, layout),
+    P(P_, layout, coarse_layout),
+    R(R_, coarse_layout, layout),
+    diagonal(layout, diagonal_),
+    omega(omega),
+    x(layout), b(layout), residual(layout), temp(layout),
+    redistribute(coarse_layout != next_layout),
+    coarse_b(redistribute ? coarse_layout : cusp::distributed_layout()),
+    coarse_x(redistribute ? coarse_layout : cusp::distributed_layout())
+{
+}
+
+//////////////////
+// Constructors //
+//////////////////
+
+template <typename IndexType, typename ValueType>
+template <typename MatrixType>
+distributed_smoothed_aggregation<IndexType,ValueType>
+::distributed_smoothed_aggregation(const MatrixType& A, const std::vector<int>& devices)
+  : Parent(A.num_rows, A.num_cols, A.num_entries), coarse_device(0), solver(0)
+{
+    initialize(A, cusp::distributed_layout(A.num_rows, devices), Options(), 4096);
+}
+
+template <typename IndexType, typename ValueType>
+template <typename MatrixType>
+distributed_smoothed_aggregation<IndexType,ValueType>
+::distributed_smoothed_aggregation(const MatrixType& A,
+                                   const cusp::distributed_layout& layout,
+                                   const Options& sa_options,
+                                   size_t min_part_size)
+  : Parent(A.num_rows, A.num_cols, A.num_entries), coarse_device(0), solver(0)
+{
+    initialize(A, layout, sa_options, min_part_size);
+}
+
+template <typename IndexType, typename ValueType>
+distributed_smoothed_aggregation<IndexType,ValueType>
+::~distributed_smoothed_aggregation(void)
+{
+    for (size_t lvl = 0; lvl < levels.size(); lvl++)
+        delete levels[lvl];
+
+    if (solver)
+    {
+        cusp::detail::device::device_scope scope(coarse_device);
+        delete solver;
+    }
+}
+
+//////////////////////
+// Member Functions //
+//////////////////////
+
+template <typename IndexType, typename ValueType>
+template <typename MatrixType>
+void distributed_smoothed_aggregation<IndexType,ValueType>
+::initialize(const MatrixType& A,
+             const cusp::distributed_layout& layout,
+             const Options& sa_options,
+             size_t min_part_size)
+{
+    CUSP_PROFILE_SCOPED();
+
+    if (A.num_rows != A.num_cols)
+        throw cusp::invalid_input_exception("distributed_smoothed_aggregation requires a square matrix");
+
+    if (layout.size() != A.num_rows)
+        throw cusp::invalid_input_exception("distributed layout does not match the matrix dimensions");
+
+    SetupMatrixType A_fine(A);
+    cusp::distributed_layout fine_layout(layout);
+
+    // near-nullspace candidates
+    cusp::array1d<ValueType,cusp::host_memory> B(A.num_rows, ValueType(1));
+
+    while ((A_fine.num_rows > sa_options.min_level_size) &&
+           (levels.size() + 1 < sa_options.max_levels))
+    {
+        const size_t num_parts = fine_layout.num_parts();
+
+        // compute strength of connection matrix
+        SetupMatrixType C;
+        sa_options.strength_of_connection(A_fine, C);
+
+        // aggregate the diagonal block of each part independently
+        cusp::array1d<IndexType,cusp::host_memory> aggregates(A_fine.num_rows);
+        std::vector<size_t> coarse_offsets(num_parts + 1, 0);
+
+        for (size_t p = 0; p < num_parts; p++)
+        {
+            const size_t begin = fine_layout.offsets[p];
+            const size_t end   = fine_layout.offsets[p + 1];
+
+            IndexType num_aggregates = 0;
+
+            if (begin < end)
+            {
+                SetupMatrixType C_block;
+                detail::extract_diagonal_block(C, begin, end, C_block);
+
+                cusp::array1d<IndexType,cusp::host_memory> block_aggregates(end - begin, IndexType(0));
+                sa_options.aggregate(C_block, block_aggregates);
+
+                for (size_t i = begin; i < end; i++)
+                {
+                    const IndexType a = block_aggregates[i - begin];
+
+                    // unaggregated nodes remain -1
+                    aggregates[i] = a < 0 ? IndexType(-1) : IndexType(coarse_offsets[p] + a);
+                    num_aggregates = std::max(num_aggregates, IndexType(a + 1));
+                }
+            }
+
+            coarse_offsets[p + 1] = coarse_offsets[p] + num_aggregates;
+        }
+
+        // stop when the aggregation no longer coarsens
+        if (coarse_offsets.back() == 0 || coarse_offsets.back() >= size_t(A_fine.num_rows))
+            break;
+
+        // compute tentative prolongator and coarse nullspace vector
+        SetupMatrixType T;
+        cusp::array1d<ValueType,cusp::host_memory> B_coarse;
+        sa_options.fit_candidates(aggregates, B, T, B_coarse);
+
+        // compute prolongation operator
+        SetupMatrixType P;
+        ValueType rho_DinvA = 0;
+        sa_options.smooth_prolongator(A_fine, T, P, rho_DinvA);
+
+        // compute restriction operator (transpose of prolongator)
+        SetupMatrixType R;
+        sa_options.form_restriction(P, R);
+
+        // construct Galerkin product R*A*P
+        SetupMatrixType RAP;
+        sa_options.galerkin_product(R, A_fine, P, RAP);
+
+        // the aggregates of part p form part p of the coarse level,
+        // which may then be merged onto fewer devices
+        cusp::distributed_layout coarse_layout;
+        coarse_layout.devices = fine_layout.devices;
+        coarse_layout.offsets = coarse_offsets;
+
+        cusp::distributed_layout next_layout = detail::merge_parts(coarse_layout, min_part_size);
+
+        cusp::array1d<ValueType,cusp::host_memory> diagonal;
+        cusp::detail::extract_diagonal(A_fine, diagonal);
+
+        const ValueType omega = rho_DinvA == ValueType(0) ? ValueType(1) : ValueType(4.0/3.0) / rho_DinvA;
+
+        levels.push_back(new level(A_fine, P, R, fine_layout, coarse_layout, next_layout, diagonal, omega));
+
+        A_fine.swap(RAP);
+        B.swap(B_coarse);
+        fine_layout = next_layout;
+    }
+
+    levels.push_back(new level(A_fine, fine_layout));
+
+    // collect the coarsest level on the device of its first part
+    coarse_device = fine_layout.devices[0];
+
+    if (fine_layout.num_parts() > 1)
+    {
+        cusp::distributed_layout single_layout(A_fine.num_rows, std::vector<int>(1, coarse_device));
+        coarse_b.resize(single_layout);
+        coarse_x.resize(single_layout);
+    }
+
+    cusp::detail::device::device_scope scope(coarse_device);
+    solver = new cusp::detail::dense_inverse_solver<ValueType,cusp::device_memory>(A_fine);
+}
+
+template <typename IndexType, typename ValueType>
+double distributed_smoothed_aggregation<IndexType,ValueType>
+::operator_complexity(void) const
+{
+    size_t nnz = 0;
+
+    for (size_t lvl = 0; lvl < levels.size(); lvl++)
+        nnz += levels[lvl]->A.num_entries;
+
+    return (double) nnz / (double) levels[0]->A.num_entries;
+}
+
+template <typename IndexType, typename ValueType>
+void distributed_smoothed_aggregation<IndexType,ValueType>
+::operator()(const Array& b, Array& x)
+{
+    CUSP_PROFILE_SCOPED();
+
+    if (b.layout != levels[0]->A.layout || x.layout != levels[0]->A.layout)
+        throw cusp::invalid_input_exception("distributed array layouts do not match the hierarchy");
+
+    // perform 1 V-cycle
+    cycle(b, x, 0);
+}
+
+template <typename IndexType, typename ValueType>
+void distributed_smoothed_aggregation<IndexType,ValueType>
+::presmooth(level& L, const Array& b, Array& x)
+{
+    // x <- omega * D^-1 * b
+    for (size_t p = 0; p < b.num_parts(); p++)
+    {
+        cusp::detail::device::device_scope scope(b.layout.devices[p]);
+
+        cusp::detail::stream::transform(b.parts[p].begin(), b.parts[p].end(),
+                                        L.diagonal.parts[p].begin(),
+                                        x.parts[p].begin(),
+                                        cusp::relaxation::detail::jacobi_presmooth_functor<ValueType>(L.omega));
+    }
+}
+
+template <typename IndexType, typename ValueType>
+void distributed_smoothed_aggregation<IndexType,ValueType>
+::postsmooth(level& L, const Array& b, Array& x)
+{
+    // y <- A*x
+    cusp::multiply(L.A, x, L.temp);
+
+    // x <- x + omega * D^-1 * (b - y)
+    for (size_t p = 0; p < b.num_parts(); p++)
+    {
+        cusp::detail::device::device_scope scope(b.layout.devices[p]);
+
+        cusp::detail::stream::transform(thrust::make_zip_iterator(thrust::make_tuple(x.parts[p].begin(), L.diagonal.parts[p].begin(), b.parts[p].begin(), L.temp.parts[p].begin())),
+                                        thrust::make_zip_iterator(thrust::make_tuple(x.parts[p].end(),   L.diagonal.parts[p].end(),   b.parts[p].end(),   L.temp.parts[p].end())),
+                                        x.parts[p].begin(),
+                                        cusp::relaxation::detail::jacobi_postsmooth_functor<ValueType>(L.omega));
+    }
+}
+
+template <typename IndexType, typename ValueType>
+void distributed_smoothed_aggregation<IndexType,ValueType>
+::coarse_solve(const Array& b, Array& x)
+{
+    if (coarse_b.num_parts() > 0)
+    {
+        // the coarsest level is split across several devices
+        coarse_b.redistribute(b);
+
+        {
+            cusp::detail::device::device_scope scope(coarse_device);
+            (*solver)(coarse_b.parts[0], coarse_x.parts[0]);
+        }
+
+        x.redistribute(coarse_x);
+    }
+    else
+    {
+        cusp::detail::device::device_scope scope(coarse_device);
+        (*solver)(b.parts[0], x.parts[0]);
+    }
+}
+
+template <typename IndexType, typename ValueType>
+void distributed_smoothed_aggregation<IndexType,ValueType>
+::cycle(const Array& b, Array& x, const size_t i)
+{
+    CUSP_PROFILE_SCOPED();
+
+    if (i + 1 == levels.size())
+    {
+        // coarse grid solve
+        coarse_solve(b, x);
+        return;
+    }
+
+    level& fine   = *levels[i];
+    level& coarse = *levels[i + 1];
+
+    // presmooth
+    presmooth(fine, b, x);
+
+    // compute residual <- b - A*x
+    cusp::multiply(fine.A, x, fine.residual);
+    cusp::blas::axpby(b, fine.residual, fine.residual, ValueType(1.0), ValueType(-1.0));
+
+    // restrict to coarse grid
+    if (fine.redistribute)
+    {
+        cusp::multiply(fine.R, fine.residual, fine.coarse_b);
+        coarse.b.redistribute(fine.coarse_b);
+    }
+    else
+    {
+        cusp::multiply(fine.R, fine.residual, coarse.b);
+    }
+
+    // compute coarse grid solution
+    cycle(coarse.b, coarse.x, i + 1);
+
+    // apply coarse grid correction
+    if (fine.redistribute)
+    {
+        fine.coarse_x.redistribute(coarse.x);
+        cusp::multiply(fine.P, fine.coarse_x, fine.residual);
+    }
+    else
+    {
+        cusp::multiply(fine.P, coarse.x, fine.residual);
+    }
+
+    cusp::blas::axpy(fine.residual, x, ValueType(1.0));
+
+    // postsmooth
+    postsmooth(fine, b, x);
+}
+
+} // end namespace aggregation
+} // end namespace precond
+} // end namespace cusp
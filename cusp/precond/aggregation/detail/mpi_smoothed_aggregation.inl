@@ -0,0 +1,589 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include <cusp/blas.h>
+#include <cusp/exception.h>
+#include <cusp/multiply.h>
+
+#include <cusp/relaxation/jacobi.h>
+
+#include <cusp/detail/format_utils.h>
+#include <cusp/detail/mpi.h>
+#include <cusp/detail/stream.h>
+
+#include <thrust/copy.h>
+#include <thrust/iterator/zip_iterator.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace cusp
+{
+namespace precond
+{
+namespace aggregation
+{
+namespace detail
+{
+
+// columns [first, first + A.num_rows) of the local rows of a CSR matrix
+template <typename MatrixType>
+void extract_local_block(const MatrixType& A, size_t first, MatrixType& B)
+{
+    typedef typename MatrixType::index_type IndexType;
+
+    const size_t begin = first;
+    const size_t end   = first + A.num_rows;
+
+    size_t num_entries = 0;
+
+    for (size_t jj = 0; jj < A.num_entries; jj++)
+        if (size_t(A.column_indices[jj]) >= begin && size_t(A.column_indices[jj]) < end)
+            num_entries++;
+
+    B.resize(A.num_rows, A.num_rows, num_entries);
+
+    size_t n = 0;
+
+    B.row_offsets[0] = 0;
+
+    for (size_t i = 0; i < A.num_rows; i++)
+    {
+        for (IndexType jj = A.row_offsets[i]; jj < A.row_offsets[i + 1]; jj++)
+        {
+            const size_t j = A.column_indices[jj];
+
+            if (j >= begin && j < end)
+            {
+                B.column_indices[n] = j - begin;
+                B.values[n]         = A.values[jj];
+                n++;
+            }
+        }
+
+        B.row_offsets[i + 1] = n;
+    }
+}
+
+// The rows of a matrix distributed by rows according to layout, with
+// global columns, whose indices are requested by every process in
+// increasing order.  Collective.
+template <typename MatrixType, typename IndexType>
+void mpi_fetch_rows(const MatrixType& A, const cusp::mpi_layout& layout,
+                    const std::vector<IndexType>& rows, MatrixType& B)
+{
+    typedef typename MatrixType::value_type ValueType;
+
+    const size_t num_ranks = layout.num_ranks();
+    const MPI_Comm comm    = layout.comm;
+
+    std::vector<int> request_counts(num_ranks, 0), request_displacements(num_ranks, 0);
+    std::vector<int> serve_counts(num_ranks, 0),   serve_displacements(num_ranks, 0);
+
+    for (size_t k = 0; k < rows.size(); k++)
+        request_counts[layout.owner(rows[k])]++;
+
+    cusp::detail::mpi_check(MPI_Alltoall(&request_counts[0], 1, MPI_INT, &serve_counts[0], 1, MPI_INT, comm), "MPI_Alltoall");
+
+    size_t num_served = 0;
+
+    for (size_t r = 0; r < num_ranks; r++)
+    {
+        serve_displacements[r] = int(num_served);
+        num_served += serve_counts[r];
+
+        if (r > 0)
+            request_displacements[r] = request_displacements[r - 1] + request_counts[r - 1];
+    }
+
+    // indices of the rows requested by the other processes
+    std::vector<long long> requested(rows.begin(), rows.end());
+    std::vector<long long> served(num_served);
+
+    cusp::detail::mpi_check(MPI_Alltoallv(requested.empty() ? NULL : &requested[0], &request_counts[0], &request_displacements[0], MPI_LONG_LONG,
+                                          served.empty()    ? NULL : &served[0],    &serve_counts[0],   &serve_displacements[0],   MPI_LONG_LONG, comm),
+                            "MPI_Alltoallv");
+
+    // lengths of the rows
+    std::vector<int> served_lengths(num_served);
+    std::vector<int> lengths(rows.size());
+
+    for (size_t k = 0; k < num_served; k++)
+    {
+        const size_t i = served[k] - layout.first_row();
+        served_lengths[k] = int(A.row_offsets[i + 1] - A.row_offsets[i]);
+    }
+
+    cusp::detail::mpi_check(MPI_Alltoallv(served_lengths.empty() ? NULL : &served_lengths[0], &serve_counts[0],   &serve_displacements[0],   MPI_INT,
+                                          lengths.empty()        ? NULL : &lengths[0],        &request_counts[0], &request_displacements[0], MPI_INT, comm),
+                            "MPI_Alltoallv");
+
+    // entries of the rows
+    std::vector<int> entry_counts(num_ranks, 0), entry_displacements(num_ranks, 0);
+    std::vector<int> served_entry_counts(num_ranks, 0), served_entry_displacements(num_ranks, 0);
+
+    for (size_t r = 0, k = 0; r < num_ranks; r++)
+        for (int n = 0; n < request_counts[r]; n++, k++)
+            entry_counts[r] += lengths[k];
+
+    for (size_t r = 0, k = 0; r < num_ranks; r++)
+        for (int n = 0; n < serve_counts[r]; n++, k++)
+            served_entry_counts[r] += served_lengths[k];
+
+    for (size_t r = 1; r < num_ranks; r++)
+    {
+        entry_displacements[r]        = entry_displacements[r - 1]        + entry_counts[r - 1];
+        served_entry_displacements[r] = served_entry_displacements[r - 1] + served_entry_counts[r - 1];
+    }
+
+    const size_t num_entries        = entry_displacements[num_ranks - 1]        + entry_counts[num_ranks - 1];
+    const size_t num_served_entries = served_entry_displacements[num_ranks - 1] + served_entry_counts[num_ranks - 1];
+
+    std::vector<long long> served_columns;
+    std::vector<ValueType> served_values;
+    served_columns.reserve(num_served_entries);
+    served_values.reserve(num_served_entries);
+
+    for (size_t k = 0; k < num_served; k++)
+    {
+        const size_t i = served[k] - layout.first_row();
+
+        for (IndexType jj = A.row_offsets[i]; jj < A.row_offsets[i + 1]; jj++)
+        {
+            served_columns.push_back(A.column_indices[jj]);
+            served_values.push_back(A.values[jj]);
+        }
+    }
+
+    std::vector<long long> columns(num_entries);
+    std::vector<ValueType> values(num_entries);
+
+    cusp::detail::mpi_check(MPI_Alltoallv(served_columns.empty() ? NULL : &served_columns[0], &served_entry_counts[0], &served_entry_displacements[0], MPI_LONG_LONG,
+                                          columns.empty()        ? NULL : &columns[0],        &entry_counts[0],        &entry_displacements[0],        MPI_LONG_LONG, comm),
+                            "MPI_Alltoallv");
+
+    cusp::detail::mpi_check(MPI_Alltoallv(served_values.empty() ? NULL : &served_values[0], &served_entry_counts[0], &served_entry_displacements[0],
+                                          cusp::detail::mpi_datatype<ValueType>::type(),
+                                          values.empty()        ? NULL : &values[0],        &entry_counts[0],        &entry_displacements[0],
+                                          cusp::detail::mpi_datatype<ValueType>::type(), comm),
+                            "MPI_Alltoallv");
+
+    B.resize(rows.size(), A.num_cols, num_entries);
+
+    B.row_offsets[0] = 0;
+
+    for (size_t k = 0; k < rows.size(); k++)
+        B.row_offsets[k + 1] = B.row_offsets[k] + lengths[k];
+
+    for (size_t n = 0; n < num_entries; n++)
+    {
+        B.column_indices[n] = IndexType(columns[n]);
+        B.values[n]         = values[n];
+    }
+}
+
+// Coarse rows R * A * P of this process, where A holds the local rows with
+// global columns, and P and R are the local blocks of a prolongator which
+// maps the local rows to the local aggregates.  Collective.
+template <typename MatrixType>
+void mpi_galerkin_product(const MatrixType& A, const MatrixType& P, const MatrixType& R,
+                          const cusp::mpi_layout& layout, const cusp::mpi_layout& coarse_layout,
+                          MatrixType& RAP)
+{
+    typedef typename MatrixType::index_type IndexType;
+    typedef typename MatrixType::value_type ValueType;
+
+    const size_t num_rows = A.num_rows;
+    const size_t first    = layout.first_row();
+
+    // prolongator of the local rows with global coarse columns
+    MatrixType P_global(P);
+    P_global.num_cols = coarse_layout.size();
+
+    for (size_t n = 0; n < P_global.num_entries; n++)
+        P_global.column_indices[n] += IndexType(coarse_layout.first_row());
+
+    // columns of A owned by other processes
+    std::vector<IndexType> ghosts;
+
+    for (size_t n = 0; n < A.num_entries; n++)
+        if (size_t(A.column_indices[n]) < first || size_t(A.column_indices[n]) >= first + num_rows)
+            ghosts.push_back(A.column_indices[n]);
+
+    std::sort(ghosts.begin(), ghosts.end());
+    ghosts.erase(std::unique(ghosts.begin(), ghosts.end()), ghosts.end());
+
+    MatrixType P_ghost;
+    mpi_fetch_rows(P_global, layout, ghosts, P_ghost);
+
+    if (R.num_rows == 0)
+    {
+        RAP.resize(0, coarse_layout.size(), 0);
+        return;
+    }
+
+    // the local rows of P followed by those of the ghosts
+    MatrixType P_extended(num_rows + ghosts.size(), coarse_layout.size(), P_global.num_entries + P_ghost.num_entries);
+
+    thrust::copy(P_global.row_offsets.begin(), P_global.row_offsets.end(), P_extended.row_offsets.begin());
+    thrust::copy(P_global.column_indices.begin(), P_global.column_indices.end(), P_extended.column_indices.begin());
+    thrust::copy(P_global.values.begin(), P_global.values.end(), P_extended.values.begin());
+
+    for (size_t k = 0; k < ghosts.size(); k++)
+        P_extended.row_offsets[num_rows + k + 1] = P_global.num_entries + P_ghost.row_offsets[k + 1];
+
+    thrust::copy(P_ghost.column_indices.begin(), P_ghost.column_indices.end(), P_extended.column_indices.begin() + P_global.num_entries);
+    thrust::copy(P_ghost.values.begin(), P_ghost.values.end(), P_extended.values.begin() + P_global.num_entries);
+
+    // A with its columns renumbered to the rows of P_extended
+    MatrixType A_extended(A);
+    A_extended.num_cols = num_rows + ghosts.size();
+
+    for (size_t n = 0; n < A.num_entries; n++)
+    {
+        const size_t j = A.column_indices[n];
+
+        if (j >= first && j < first + num_rows)
+            A_extended.column_indices[n] = IndexType(j - first);
+        else
+            A_extended.column_indices[n] = IndexType(num_rows + (std::lower_bound(ghosts.begin(), ghosts.end(), IndexType(j)) - ghosts.begin()));
+    }
+
+    MatrixType AP;
+    cusp::multiply(A_extended, P_extended, AP);
+    cusp::multiply(R, AP, RAP);
+}
+
+// upper bound of the spectral radius of D^-1 A over all processes
+template <typename MatrixType>
+typename MatrixType::value_type
+mpi_gershgorin_radius(const MatrixType& A, const cusp::mpi_layout& layout)
+{
+    typedef typename MatrixType::index_type      IndexType;
+    typedef typename MatrixType::value_type      ValueType;
+    typedef typename norm_type<ValueType>::type  NormType;
+
+    NormType radius(0);
+
+    for (size_t i = 0; i < A.num_rows; i++)
+    {
+        NormType diagonal(0), row_sum(0);
+
+        for (IndexType jj = A.row_offsets[i]; jj < A.row_offsets[i + 1]; jj++)
+        {
+            if (size_t(A.column_indices[jj]) == layout.first_row() + i)
+                diagonal += abs(A.values[jj]);
+
+            row_sum += abs(A.values[jj]);
+        }
+
+        if (diagonal > NormType(0))
+            radius = std::max(radius, row_sum / diagonal);
+    }
+
+    return cusp::detail::mpi_max(radius, layout.comm);
+}
+
+// all rows of a matrix distributed by rows, on every process.  Collective.
+template <typename MatrixType>
+void mpi_allgather_rows(const MatrixType& A, const cusp::mpi_layout& layout, MatrixType& B)
+{
+    std::vector<typename MatrixType::index_type> rows(layout.size());
+
+    for (size_t i = 0; i < rows.size(); i++)
+        rows[i] = i;
+
+    mpi_fetch_rows(A, layout, rows, B);
+}
+
+// y <- A * x for a local block whose dimensions may be zero
+template <typename MatrixType, typename Array1, typename Array2>
+void local_multiply(const MatrixType& A, const Array1& x, Array2& y)
+{
+    typedef typename Array2::value_type ValueType;
+
+    if (y.size() == 0)
+        return;
+
+    if (x.size() == 0 || A.num_entries == 0)
+        cusp::blas::fill(y, ValueType(0));
+    else
+        cusp::multiply(A, x, y);
+}
+
+} // end namespace detail
+
+///////////
+// Level //
+///////////
+
+template <typename IndexType, typename ValueType>
+mpi_smoothed_aggregation<IndexType,ValueType>::level
+::level(const SetupMatrixType& A_local,
+        const cusp::mpi_layout& layout)
+  : A(A_local, layout),
+    omega(0),
+    x(layout), b(layout)
+{
+}
+
+template <typename IndexType, typename ValueType>
+mpi_smoothed_aggregation<IndexType,ValueType>::level
+::level(const SetupMatrixType& A_local,
+        const SetupMatrixType& P_,
+        const SetupMatrixType& R_,
+        const cusp::mpi_layout& layout,
+        const cusp::array1d<ValueType,cusp::host_memory>& diagonal_,
+        ValueType omega)
+  : A(A_local, layout),
+    P(P_), R(R_),
+    diagonal(diagonal_),
+    omega(omega),
+    x(layout), b(layout), residual(layout), temp(layout)
+{
+}
+
+//////////////////
+// Constructors //
+//////////////////
+
+template <typename IndexType, typename ValueType>
+template <typename MatrixType>
+mpi_smoothed_aggregation<IndexType,ValueType>
+::mpi_smoothed_aggregation(const MatrixType& local_rows,
+                           const cusp::mpi_layout& layout,
+                           const Options& sa_options)
+  : Parent(layout.size(), layout.size(), 0), solver(0)
+{
+    initialize(local_rows, layout, sa_options);
+}
+
+template <typename IndexType, typename ValueType>
+mpi_smoothed_aggregation<IndexType,ValueType>
+::~mpi_smoothed_aggregation(void)
+{
+    for (size_t lvl = 0; lvl < levels.size(); lvl++)
+        delete levels[lvl];
+
+    delete solver;
+}
+
+//////////////////////
+// Member Functions //
+//////////////////////
+
+template <typename IndexType, typename ValueType>
+template <typename MatrixType>
+void mpi_smoothed_aggregation<IndexType,ValueType>
+::initialize(const MatrixType& local_rows,
+             const cusp::mpi_layout& layout,
+             const Options& sa_options)
+{
+    CUSP_PROFILE_SCOPED();
+
+    if (local_rows.num_rows != layout.local_size() || local_rows.num_cols != layout.size())
+        throw cusp::invalid_input_exception("local rows do not match the MPI layout");
+
+    SetupMatrixType A_local(local_rows);
+    cusp::mpi_layout fine_layout(layout);
+
+    // near-nullspace candidates of the local rows
+    cusp::array1d<ValueType,cusp::host_memory> B(A_local.num_rows, ValueType(1));
+
+    while ((fine_layout.size() > sa_options.min_level_size) &&
+           (levels.size() + 1 < sa_options.max_levels))
+    {
+        const size_t num_rows = fine_layout.local_size();
+
+        SetupMatrixType A_block;
+        detail::extract_local_block(A_local, fine_layout.first_row(), A_block);
+
+        // aggregate the diagonal block of this process
+        cusp::array1d<IndexType,cusp::host_memory> aggregates(num_rows, IndexType(0));
+        IndexType num_aggregates = 0;
+
+        if (num_rows > 0)
+        {
+            SetupMatrixType C;
+            sa_options.strength_of_connection(A_block, C);
+            sa_options.aggregate(C, aggregates);
+
+            for (size_t i = 0; i < num_rows; i++)
+                num_aggregates = std::max(num_aggregates, IndexType(aggregates[i] + 1));
+        }
+
+        // the aggregates of this process form its rows of the coarse level
+        cusp::mpi_layout coarse_layout(fine_layout.comm, num_aggregates);
+
+        // stop when the aggregation no longer coarsens
+        if (coarse_layout.size() == 0 || coarse_layout.size() >= fine_layout.size())
+            break;
+
+        // compute tentative prolongator and coarse nullspace vector
+        SetupMatrixType T;
+        cusp::array1d<ValueType,cusp::host_memory> B_coarse;
+
+        // compute prolongation operator, smoothed with the diagonal block
+        SetupMatrixType P;
+        SetupMatrixType R;
+
+        if (num_aggregates > 0)
+        {
+            ValueType rho_DinvA = 0;
+
+            sa_options.fit_candidates(aggregates, B, T, B_coarse);
+            sa_options.smooth_prolongator(A_block, T, P, rho_DinvA);
+            sa_options.form_restriction(P, R);
+        }
+        else
+        {
+            P.resize(num_rows, 0, 0);
+            R.resize(0, num_rows, 0);
+        }
+
+        // construct Galerkin product R*A*P
+        SetupMatrixType RAP;
+        detail::mpi_galerkin_product(A_local, P, R, fine_layout, coarse_layout, RAP);
+
+        cusp::array1d<ValueType,cusp::host_memory> diagonal;
+        cusp::detail::extract_diagonal(A_block, diagonal);
+
+        const ValueType rho = detail::mpi_gershgorin_radius(A_local, fine_layout);
+        const ValueType omega = rho == ValueType(0) ? ValueType(1) : ValueType(4.0/3.0) / rho;
+
+        levels.push_back(new level(A_local, P, R, fine_layout, diagonal, omega));
+
+        A_local.swap(RAP);
+        B.swap(B_coarse);
+        fine_layout = coarse_layout;
+    }
+
+    levels.push_back(new level(A_local, fine_layout));
+
+    // every process solves the whole coarsest level
+    SetupMatrixType A_coarse;
+    detail::mpi_allgather_rows(A_local, fine_layout, A_coarse);
+
+    solver = new cusp::detail::dense_inverse_solver<ValueType,cusp::device_memory>(A_coarse);
+    coarse_b.resize(A_coarse.num_rows);
+    coarse_x.resize(A_coarse.num_rows);
+}
+
+template <typename IndexType, typename ValueType>
+double mpi_smoothed_aggregation<IndexType,ValueType>
+::operator_complexity(void) const
+{
+    size_t nnz = 0;
+
+    for (size_t lvl = 0; lvl < levels.size(); lvl++)
+        nnz += levels[lvl]->A.num_entries;
+
+    return (double) nnz / (double) levels[0]->A.num_entries;
+}
+
+template <typename IndexType, typename ValueType>
+void mpi_smoothed_aggregation<IndexType,ValueType>
+::operator()(const Array& b, Array& x)
+{
+    CUSP_PROFILE_SCOPED();
+
+    if (b.layout != levels[0]->A.layout || x.layout != levels[0]->A.layout)
+        throw cusp::invalid_input_exception("MPI array layouts do not match the hierarchy");
+
+    // perform 1 V-cycle
+    cycle(b, x, 0);
+}
+
+template <typename IndexType, typename ValueType>
+void mpi_smoothed_aggregation<IndexType,ValueType>
+::presmooth(level& L, const Array& b, Array& x)
+{
+    // x <- omega * D^-1 * b
+    cusp::detail::stream::transform(b.local.begin(), b.local.end(),
+                                    L.diagonal.begin(),
+                                    x.local.begin(),
+                                    cusp::relaxation::detail::jacobi_presmooth_functor<ValueType>(L.omega));
+}
+
+template <typename IndexType, typename ValueType>
+void mpi_smoothed_aggregation<IndexType,ValueType>
+::postsmooth(level& L, const Array& b, Array& x)
+{
+    // y <- A*x
+    cusp::multiply(L.A, x, L.temp);
+
+    // x <- x + omega * D^-1 * (b - y)
+    cusp::detail::stream::transform(thrust::make_zip_iterator(thrust::make_tuple(x.local.begin(), L.diagonal.begin(), b.local.begin(), L.temp.local.begin())),
+                                    thrust::make_zip_iterator(thrust::make_tuple(x.local.end(),   L.diagonal.end(),   b.local.end(),   L.temp.local.end())),
+                                    x.local.begin(),
+                                    cusp::relaxation::detail::jacobi_postsmooth_functor<ValueType>(L.omega));
+}
+
+template <typename IndexType, typename ValueType>
+void mpi_smoothed_aggregation<IndexType,ValueType>
+::coarse_solve(const Array& b, Array& x)
+{
+    // gather the right-hand side on every process
+    b.gather(coarse_b);
+
+    (*solver)(coarse_b, coarse_x);
+
+    const size_t first = b.layout.first_row();
+
+    thrust::copy(coarse_x.begin() + first, coarse_x.begin() + first + x.local_size(), x.local.begin());
+}
+
+template <typename IndexType, typename ValueType>
+void mpi_smoothed_aggregation<IndexType,ValueType>
+::cycle(const Array& b, Array& x, const size_t i)
+{
+    CUSP_PROFILE_SCOPED();
+
+    if (i + 1 == levels.size())
+    {
+        // coarse grid solve
+        coarse_solve(b, x);
+        return;
+    }
+
+    level& fine   = *levels[i];
+    level& coarse = *levels[i + 1];
+
+    // presmooth
+    presmooth(fine, b, x);
+
+    // compute residual <- b - A*x
+    cusp::multiply(fine.A, x, fine.residual);
+    cusp::blas::axpby(b, fine.residual, fine.residual, ValueType(1.0), ValueType(-1.0));
+
+    // restrict to coarse grid, which needs no communication
+    detail::local_multiply(fine.R, fine.residual.local, coarse.b.local);
+
+    // compute coarse grid solution
+    cycle(coarse.b, coarse.x, i + 1);
+
+    // apply coarse grid correction
+    detail::local_multiply(fine.P, coarse.x.local, fine.residual.local);
+
+    cusp::blas::axpy(fine.residual, x, ValueType(1.0));
+
+    // postsmooth
+    postsmooth(fine, b, x);
+}
+
+} // end namespace aggregation
+} // end namespace precond
+} // end namespace cusp
@@ -18,11 +18,17 @@
 #include <cusp/coo_matrix.h>
 #include <cusp/csr_matrix.h>
 #include <cusp/elementwise.h>
+#include <cusp/exception.h>
+#include <cusp/multiply.h>
+
+#include <cusp/precond/aggregation/truncate.h>
 
 #include <cusp/detail/spectral_radius.h>
 
+#include <thrust/binary_search.h>
 #include <thrust/extrema.h>
 #include <thrust/fill.h>
+#include <thrust/for_each.h>
 #include <thrust/gather.h>
 #include <thrust/transform.h>
 #include <thrust/reduce.h>
@@ -30,6 +36,8 @@
 #include <thrust/iterator/zip_iterator.h>
 #include <thrust/iterator/constant_iterator.h>
 #include <thrust/iterator/counting_iterator.h>
+#include <thrust/iterator/permutation_iterator.h>
+#include <thrust/iterator/transform_iterator.h>
 
 namespace cusp
 {
@@ -168,6 +176,434 @@ void smooth_prolongator(const MatrixType& S,
     cusp::subtract( T, temp, P );
 }
 
+template <typename MatrixType>
+void filtered_matrix(const MatrixType& A,
+                     const MatrixType& C,
+                     MatrixType& A_F)
+{
+    CUSP_PROFILE_SCOPED();
+
+    typedef typename MatrixType::index_type   IndexType;
+    typedef typename MatrixType::value_type   ValueType;
+    typedef typename MatrixType::memory_space MemorySpace;
+
+    cusp::coo_matrix<IndexType,ValueType,MemorySpace> A_coo(A);
+    cusp::coo_matrix<IndexType,ValueType,MemorySpace> F(C);
+
+    const size_t N = A_coo.num_rows;
+
+    // lumped <- rowsum(A) - rowsum(C), the weak entries of each row
+    cusp::array1d<ValueType,MemorySpace> lumped(N);
+    cusp::array1d<ValueType,MemorySpace> strong(N);
+    reduce_rows(A_coo.row_indices, A_coo.values.begin(), lumped, thrust::plus<ValueType>());
+    reduce_rows(F.row_indices, F.values.begin(), strong, thrust::plus<ValueType>());
+    thrust::transform(lumped.begin(), lumped.end(), strong.begin(), lumped.begin(), thrust::minus<ValueType>());
+
+    thrust::transform(thrust::make_zip_iterator(thrust::make_tuple(F.row_indices.begin(), F.column_indices.begin(), F.values.begin(),
+                                                                   thrust::make_permutation_iterator(lumped.begin(), F.row_indices.begin()))),
+                      thrust::make_zip_iterator(thrust::make_tuple(F.row_indices.end(), F.column_indices.end(), F.values.end(),
+                                                                   thrust::make_permutation_iterator(lumped.begin(), F.row_indices.end()))),
+                      F.values.begin(),
+                      lump_to_diagonal<ValueType>());
+
+    A_F = F;
+}
+
+// largest number of candidates of the energy minimizing prolongator
+const size_t max_energy_candidates = 8;
+
+// value of entry (row, column) of a matrix sorted by row and column, 0 if
+// it has no such entry, given the lower bound of (row, column) in it
+template <typename IndexType, typename ValueType>
+struct pattern_entry_value
+{
+    const IndexType* rows;
+    const IndexType* columns;
+    const ValueType* values;
+    const IndexType num_entries;
+
+    pattern_entry_value(const IndexType* rows, const IndexType* columns, const ValueType* values, const IndexType num_entries)
+        : rows(rows), columns(columns), values(values), num_entries(num_entries) {}
+
+    template <typename Tuple>
+    __host__ __device__
+    ValueType operator()(const Tuple& t) const
+    {
+        const IndexType position = thrust::get<0>(t);
+
+        if (position < num_entries && rows[position] == thrust::get<1>(t) && columns[position] == thrust::get<2>(t))
+            return values[position];
+        else
+            return ValueType(0);
+    }
+};
+
+template <typename ValueType>
+struct multiply_pair
+{
+    template <typename Tuple>
+    __host__ __device__
+    ValueType operator()(const Tuple& t) const
+    {
+        return thrust::get<0>(t) * thrust::get<1>(t);
+    }
+};
+
+// G_i <- (G_i + delta I)^-1 for the k x k Gram matrix of every row, stored
+// as G[(c * k + d) * N + i].  The shift, relative to the trace, stands in
+// for the pseudo-inverse of rows with fewer entries than candidates.
+template <typename ValueType>
+struct invert_row_gram
+{
+    ValueType* G;
+    const size_t N;
+    const size_t k;
+
+    invert_row_gram(ValueType* G, const size_t N, const size_t k) : G(G), N(N), k(k) {}
+
+    template <typename IndexType>
+    __host__ __device__
+    void operator()(const IndexType i) const
+    {
+        ValueType a[max_energy_candidates * max_energy_candidates];
+        ValueType inv[max_energy_candidates * max_energy_candidates];
+
+        ValueType trace(0);
+        for (size_t c = 0; c < k; c++)
+            trace += G[(c * k + c) * N + i];
+
+        for (size_t c = 0; c < k; c++)
+            for (size_t d = 0; d < k; d++)
+            {
+                a[c * k + d]   = G[(c * k + d) * N + i] + (c == d ? ValueType(1e-6) * trace / k : ValueType(0));
+                inv[c * k + d] = (c == d) ? ValueType(1) : ValueType(0);
+            }
+
+        // Gauss-Jordan elimination of the symmetric positive definite system
+        for (size_t c = 0; c < k; c++)
+        {
+            const ValueType pivot = a[c * k + c];
+
+            for (size_t d = 0; d < k; d++)
+            {
+                a[c * k + d]   = (pivot == ValueType(0)) ? ValueType(0) : a[c * k + d]   / pivot;
+                inv[c * k + d] = (pivot == ValueType(0)) ? ValueType(0) : inv[c * k + d] / pivot;
+            }
+
+            for (size_t r = 0; r < k; r++)
+            {
+                if (r == c)
+                    continue;
+
+                const ValueType factor = a[r * k + c];
+
+                for (size_t d = 0; d < k; d++)
+                {
+                    a[r * k + d]   -= factor * a[c * k + d];
+                    inv[r * k + d] -= factor * inv[c * k + d];
+                }
+            }
+        }
+
+        for (size_t c = 0; c < k; c++)
+            for (size_t d = 0; d < k; d++)
+                G[(c * k + d) * N + i] = inv[c * k + d];
+    }
+};
+
+// Z_e <- G_i^-1 w_e for entry e of row i
+template <typename IndexType, typename ValueType>
+struct constraint_directions
+{
+    const IndexType* rows;
+    const ValueType* Ginv;
+    const ValueType* W;
+    ValueType* Z;
+    const size_t N;
+    const size_t num_entries;
+    const size_t k;
+
+    constraint_directions(const IndexType* rows, const ValueType* Ginv, const ValueType* W, ValueType* Z,
+                          const size_t N, const size_t num_entries, const size_t k)
+        : rows(rows), Ginv(Ginv), W(W), Z(Z), N(N), num_entries(num_entries), k(k) {}
+
+    __host__ __device__
+    void operator()(const IndexType e) const
+    {
+        const IndexType i = rows[e];
+
+        for (size_t c = 0; c < k; c++)
+        {
+            ValueType sum(0);
+            for (size_t d = 0; d < k; d++)
+                sum += Ginv[(c * k + d) * N + i] * W[d * num_entries + e];
+            Z[c * num_entries + e] = sum;
+        }
+    }
+};
+
+// u_e <- u_e - sum_c Z_e[c] (U B_coarse)_i[c] for entry e of row i
+template <typename IndexType, typename ValueType>
+struct remove_constraint_components
+{
+    const IndexType* rows;
+    const ValueType* Z;
+    const ValueType* UB;
+    const size_t N;
+    const size_t num_entries;
+    const size_t k;
+
+    remove_constraint_components(const IndexType* rows, const ValueType* Z, const ValueType* UB,
+                                 const size_t N, const size_t num_entries, const size_t k)
+        : rows(rows), Z(Z), UB(UB), N(N), num_entries(num_entries), k(k) {}
+
+    template <typename Tuple>
+    __host__ __device__
+    ValueType operator()(const Tuple& t) const
+    {
+        const IndexType e = thrust::get<0>(t);
+        const IndexType i = rows[e];
+
+        ValueType u = thrust::get<1>(t);
+        for (size_t c = 0; c < k; c++)
+            u -= Z[c * num_entries + e] * UB[c * N + i];
+
+        return u;
+    }
+};
+
+// projection of the updates U of the prolongator onto U * B_coarse = 0,
+// row by row over the fixed sparsity pattern
+template <typename IndexType, typename ValueType, typename MemorySpace>
+struct prolongator_constraints
+{
+    const cusp::array1d<IndexType,MemorySpace>& rows;
+    const size_t N;
+    const size_t num_entries;
+    const size_t k;
+
+    cusp::array1d<ValueType,MemorySpace> W;  // W[c * num_entries + e] = B_coarse(column of e, c)
+    cusp::array1d<ValueType,MemorySpace> Z;  // Z[c * num_entries + e] = (G_i^-1 w_e)[c]
+
+    template <typename Array2>
+    prolongator_constraints(const cusp::array1d<IndexType,MemorySpace>& rows,
+                            const cusp::array1d<IndexType,MemorySpace>& columns,
+                            const size_t N, const Array2& B_coarse)
+        : rows(rows), N(N), num_entries(rows.size()), k(B_coarse.num_cols),
+          W(rows.size() * B_coarse.num_cols), Z(rows.size() * B_coarse.num_cols)
+    {
+        if (num_entries == 0)
+            return;
+
+        for (size_t c = 0; c < k; c++)
+            thrust::gather(columns.begin(), columns.end(),
+                           B_coarse.values.begin() + c * B_coarse.num_rows,
+                           W.begin() + c * num_entries);
+
+        // Gram matrices G_i = sum_e w_e w_e^T of the entries of each row
+        cusp::array1d<ValueType,MemorySpace> G(k * k * N);
+        cusp::array1d<ValueType,MemorySpace> sums(N);
+
+        for (size_t c = 0; c < k; c++)
+            for (size_t d = 0; d <= c; d++)
+            {
+                reduce_rows(rows,
+                            thrust::make_transform_iterator(thrust::make_zip_iterator(thrust::make_tuple(W.begin() + c * num_entries,
+                                                                                                         W.begin() + d * num_entries)),
+                                                            multiply_pair<ValueType>()),
+                            sums, thrust::plus<ValueType>());
+                thrust::copy(sums.begin(), sums.end(), G.begin() + (c * k + d) * N);
+                thrust::copy(sums.begin(), sums.end(), G.begin() + (d * k + c) * N);
+            }
+
+        thrust::for_each(thrust::counting_iterator<IndexType>(0), thrust::counting_iterator<IndexType>(N),
+                         invert_row_gram<ValueType>(thrust::raw_pointer_cast(&G[0]), N, k));
+
+        thrust::for_each(thrust::counting_iterator<IndexType>(0), thrust::counting_iterator<IndexType>(num_entries),
+                         constraint_directions<IndexType,ValueType>(thrust::raw_pointer_cast(&rows[0]),
+                                                                    thrust::raw_pointer_cast(&G[0]),
+                                                                    thrust::raw_pointer_cast(&W[0]),
+                                                                    thrust::raw_pointer_cast(&Z[0]),
+                                                                    N, num_entries, k));
+    }
+
+    void project(cusp::array1d<ValueType,MemorySpace>& U) const
+    {
+        if (num_entries == 0)
+            return;
+
+        // UB_i = sum_e u_e w_e over the entries of row i
+        cusp::array1d<ValueType,MemorySpace> UB(k * N);
+        cusp::array1d<ValueType,MemorySpace> sums(N);
+
+        for (size_t c = 0; c < k; c++)
+        {
+            reduce_rows(rows,
+                        thrust::make_transform_iterator(thrust::make_zip_iterator(thrust::make_tuple(U.begin(), W.begin() + c * num_entries)),
+                                                        multiply_pair<ValueType>()),
+                        sums, thrust::plus<ValueType>());
+            thrust::copy(sums.begin(), sums.end(), UB.begin() + c * N);
+        }
+
+        thrust::transform(thrust::make_zip_iterator(thrust::make_tuple(thrust::counting_iterator<IndexType>(0), U.begin())),
+                          thrust::make_zip_iterator(thrust::make_tuple(thrust::counting_iterator<IndexType>(num_entries), U.end())),
+                          U.begin(),
+                          remove_constraint_components<IndexType,ValueType>(thrust::raw_pointer_cast(&rows[0]),
+                                                                            thrust::raw_pointer_cast(&Z[0]),
+                                                                            thrust::raw_pointer_cast(&UB[0]),
+                                                                            N, num_entries, k));
+    }
+};
+
+// values <- entries of M at the positions of the sorted pattern (rows, columns)
+template <typename Array1, typename CooMatrix, typename Array2>
+void restrict_to_pattern(const Array1& rows, const Array1& columns, const CooMatrix& M, Array2& values)
+{
+    typedef typename CooMatrix::index_type IndexType;
+    typedef typename CooMatrix::value_type ValueType;
+    typedef typename CooMatrix::memory_space MemorySpace;
+
+    if (M.num_entries == 0)
+    {
+        thrust::fill(values.begin(), values.end(), ValueType(0));
+        return;
+    }
+
+    cusp::array1d<IndexType,MemorySpace> positions(rows.size());
+    thrust::lower_bound(thrust::make_zip_iterator(thrust::make_tuple(M.row_indices.begin(), M.column_indices.begin())),
+                        thrust::make_zip_iterator(thrust::make_tuple(M.row_indices.end(),   M.column_indices.end())),
+                        thrust::make_zip_iterator(thrust::make_tuple(rows.begin(), columns.begin())),
+                        thrust::make_zip_iterator(thrust::make_tuple(rows.end(),   columns.end())),
+                        positions.begin());
+
+    thrust::transform(thrust::make_zip_iterator(thrust::make_tuple(positions.begin(), rows.begin(), columns.begin())),
+                      thrust::make_zip_iterator(thrust::make_tuple(positions.end(),   rows.end(),   columns.end())),
+                      values.begin(),
+                      pattern_entry_value<IndexType,ValueType>(thrust::raw_pointer_cast(&M.row_indices[0]),
+                                                               thrust::raw_pointer_cast(&M.column_indices[0]),
+                                                               thrust::raw_pointer_cast(&M.values[0]),
+                                                               M.num_entries));
+}
+
+// AX <- (A * X) restricted to the pattern of X, with X given by its values
+template <typename MatrixType, typename CooMatrix, typename Array>
+void multiply_on_pattern(const MatrixType& A, CooMatrix& X, const Array& x, Array& AX)
+{
+    thrust::copy(x.begin(), x.end(), X.values.begin());
+
+    MatrixType X_(X);
+    MatrixType AX_;
+    cusp::multiply(A, X_, AX_);
+
+    CooMatrix product(AX_);
+    product.sort_by_row_and_column();
+
+    restrict_to_pattern(X.row_indices, X.column_indices, product, AX);
+}
+
+template <typename MatrixType, typename Array2>
+void energy_minimization_prolongator(const MatrixType& A,
+                                     const MatrixType& T,
+                                     const Array2& B_coarse,
+                                     MatrixType& P,
+                                     const size_t iterations)
+{
+    CUSP_PROFILE_SCOPED();
+
+    typedef typename MatrixType::index_type   IndexType;
+    typedef typename MatrixType::value_type   ValueType;
+    typedef typename MatrixType::memory_space MemorySpace;
+    typedef cusp::coo_matrix<IndexType,ValueType,MemorySpace> CooMatrix;
+    typedef cusp::array1d<ValueType,MemorySpace> Array;
+
+    if (B_coarse.num_cols > max_energy_candidates)
+        throw cusp::invalid_input_exception("energy minimization supports at most 8 near-nullspace candidates");
+
+    // pattern of A * T, computed from the magnitudes so that no entry cancels
+    CooMatrix pattern;
+    {
+        CooMatrix A_abs(A);
+        CooMatrix T_abs(T);
+        thrust::fill(A_abs.values.begin(), A_abs.values.end(), ValueType(1));
+        thrust::transform(T_abs.values.begin(), T_abs.values.end(), T_abs.values.begin(), cusp::detail::absolute<ValueType>());
+
+        MatrixType A_(A_abs);
+        MatrixType T_(T_abs);
+        MatrixType AT;
+        cusp::multiply(A_, T_, AT);
+
+        pattern = AT;
+        pattern.sort_by_row_and_column();
+    }
+
+    const size_t num_entries = pattern.num_entries;
+
+    // P <- T on the pattern
+    Array p_values(num_entries);
+    {
+        CooMatrix T_coo(T);
+        T_coo.sort_by_row_and_column();
+        restrict_to_pattern(pattern.row_indices, pattern.column_indices, T_coo, p_values);
+    }
+
+    prolongator_constraints<IndexType,ValueType,MemorySpace> constraints(pattern.row_indices, pattern.column_indices,
+                                                                          A.num_rows, B_coarse);
+
+    Array D(A.num_rows);
+    cusp::detail::extract_diagonal(A, D);
+
+    // R <- -A * P on the pattern, the negative gradient of trace(P^T A P)
+    Array r(num_entries);
+    Array z(num_entries);
+    Array d(num_entries);
+    Array Ad(num_entries);
+
+    multiply_on_pattern(A, pattern, p_values, r);
+    cusp::blas::scal(r, ValueType(-1));
+    constraints.project(r);
+
+    ValueType rz_old(0);
+
+    for (size_t iteration = 0; iteration < iterations; iteration++)
+    {
+        // z <- D^-1 r
+        thrust::transform(r.begin(), r.end(),
+                          thrust::make_permutation_iterator(D.begin(), pattern.row_indices.begin()),
+                          z.begin(),
+                          thrust::divides<ValueType>());
+        constraints.project(z);
+
+        const ValueType rz = cusp::blas::dot(r, z);
+
+        if (rz == ValueType(0))
+            break;
+
+        if (iteration == 0)
+            cusp::blas::copy(z, d);
+        else
+            cusp::blas::axpby(z, d, d, ValueType(1), rz / rz_old);
+
+        multiply_on_pattern(A, pattern, d, Ad);
+        constraints.project(Ad);
+
+        const ValueType dAd = cusp::blas::dot(d, Ad);
+
+        if (dAd == ValueType(0))
+            break;
+
+        const ValueType alpha = rz / dAd;
+
+        cusp::blas::axpy(d,  p_values,  alpha);
+        cusp::blas::axpy(Ad, r,        -alpha);
+
+        rz_old = rz;
+    }
+
+    thrust::copy(p_values.begin(), p_values.end(), pattern.values.begin());
+
+    P = pattern;
+}
+
 } // end namespace detail
 
 template <typename MatrixType, typename ValueType>
@@ -180,6 +616,24 @@ void smooth_prolongator(const MatrixType& S,
     detail::smooth_prolongator(S, T, P, omega, rho_Dinv_S, typename MatrixType::format(), typename MatrixType::memory_space());
 }
 
+template <typename MatrixType>
+void filtered_matrix(const MatrixType& A,
+                     const MatrixType& C,
+                     MatrixType& A_F)
+{
+    detail::filtered_matrix(A, C, A_F);
+}
+
+template <typename MatrixType, typename Array2>
+void energy_minimization_prolongator(const MatrixType& A,
+                                     const MatrixType& T,
+                                     const Array2& B_coarse,
+                                     MatrixType& P,
+                                     const size_t iterations)
+{
+    detail::energy_minimization_prolongator(A, T, B_coarse, P, iterations);
+}
+
 } // end namespace aggregation
 } // end namespace precond
 } // end namespace cusp
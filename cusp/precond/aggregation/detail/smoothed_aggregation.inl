@@ -15,10 +15,13 @@
  */
 
 #include <cusp/blas.h>
+#include <cusp/exception.h>
 #include <cusp/elementwise.h>
 #include <cusp/multiply.h>
+#include <cusp/stream.h>
 
 #include <cusp/detail/format_utils.h>
+#include <cusp/detail/timer.h>
 
 namespace cusp
 {
@@ -39,13 +42,42 @@ void setup_level_matrix(Matrix1& dst, Matrix2& src) {
     dst = src;
 }
 
+// the candidates of the finest level as the columns of an array2d
+template <typename Array1, typename Array2>
+void assign_candidates(Array1& dst, const Array2& B, cusp::array1d_format)
+{
+    dst.resize(B.size(), 1);
+    thrust::copy(B.begin(), B.end(), dst.values.begin());
+}
+
+template <typename Array1, typename Array2>
+void assign_candidates(Array1& dst, const Array2& B, cusp::array2d_format)
+{
+    dst = B;
+}
+
+// whether the finest level is better applied by a tiled_csr_operator:
+// a COO part of more than a tenth of the entries means rows much longer
+// than the ELL width, which the COO kernel handles slowly
+template <typename IndexType, typename ValueType, typename MemorySpace>
+bool is_irregular_level(const cusp::hyb_matrix<IndexType,ValueType,MemorySpace>& A)
+{
+    return A.coo.num_entries * 10 > A.num_entries;
+}
+
+template <typename Matrix>
+bool is_irregular_level(const Matrix&)
+{
+    return false;
+}
+
 } // end namespace detail
 
-template <typename IndexType, typename ValueType, typename MemorySpace, typename SmootherType, typename SolverType>
+template <typename IndexType, typename ValueType, typename MemorySpace, typename SmootherType, typename SolverType, typename SolveValueType>
 template <typename MatrixType>
-smoothed_aggregation<IndexType,ValueType,MemorySpace,SmootherType,SolverType>
+smoothed_aggregation<IndexType,ValueType,MemorySpace,SmootherType,SolverType,SolveValueType>
 ::smoothed_aggregation(const MatrixType& A)
-  : sa_options(default_sa_options)
+  : sa_options(default_sa_options), solve_only(false)
 {
     typedef typename cusp::array1d_view< thrust::constant_iterator<ValueType> > ConstantView;
 
@@ -54,12 +86,12 @@ smoothed_aggregation<IndexType,ValueType,MemorySpace,SmootherType,SolverType>
     sa_initialize(A, B);
 }
 
-template <typename IndexType, typename ValueType, typename MemorySpace, typename SmootherType, typename SolverType>
+template <typename IndexType, typename ValueType, typename MemorySpace, typename SmootherType, typename SolverType, typename SolveValueType>
 template <typename MatrixType, typename Options>
-smoothed_aggregation<IndexType,ValueType,MemorySpace,SmootherType,SolverType>
+smoothed_aggregation<IndexType,ValueType,MemorySpace,SmootherType,SolverType,SolveValueType>
 ::smoothed_aggregation(const MatrixType& A,
                        const Options& sa_options)
-  : sa_options(sa_options)
+  : sa_options(sa_options), solve_only(false)
 {
     typedef typename cusp::array1d_view< thrust::constant_iterator<ValueType> > ConstantView;
 
@@ -68,38 +100,60 @@ smoothed_aggregation<IndexType,ValueType,MemorySpace,SmootherType,SolverType>
     sa_initialize(A, B);
 }
 
-template <typename IndexType, typename ValueType, typename MemorySpace, typename SmootherType, typename SolverType>
+template <typename IndexType, typename ValueType, typename MemorySpace, typename SmootherType, typename SolverType, typename SolveValueType>
 template <typename MatrixType>
-smoothed_aggregation<IndexType,ValueType,MemorySpace,SmootherType,SolverType>
+smoothed_aggregation<IndexType,ValueType,MemorySpace,SmootherType,SolverType,SolveValueType>
 ::smoothed_aggregation(const MatrixType& A, const cusp::array1d<ValueType,MemorySpace>& B)
-  : sa_options(default_sa_options)
+  : sa_options(default_sa_options), solve_only(false)
 {
     sa_initialize(A, B);
 }
 
-template <typename IndexType, typename ValueType, typename MemorySpace, typename SmootherType, typename SolverType>
+template <typename IndexType, typename ValueType, typename MemorySpace, typename SmootherType, typename SolverType, typename SolveValueType>
 template <typename MatrixType, typename Options>
-smoothed_aggregation<IndexType,ValueType,MemorySpace,SmootherType,SolverType>
+smoothed_aggregation<IndexType,ValueType,MemorySpace,SmootherType,SolverType,SolveValueType>
 ::smoothed_aggregation(const MatrixType& A, const cusp::array1d<ValueType,MemorySpace>& B,
                        const Options& sa_options)
-  : sa_options(sa_options)
+  : sa_options(sa_options), solve_only(false)
 {
     sa_initialize(A, B);
 }
 
-template <typename IndexType, typename ValueType, typename MemorySpace, typename SmootherType, typename SolverType>
-template <typename MemorySpace2, typename SmootherType2, typename SolverType2>
-smoothed_aggregation<IndexType,ValueType,MemorySpace,SmootherType,SolverType>
-::smoothed_aggregation(const smoothed_aggregation<IndexType,ValueType,MemorySpace2,SmootherType2,SolverType2>& M)
-    : sa_options(M.sa_options), Parent(M)
+template <typename IndexType, typename ValueType, typename MemorySpace, typename SmootherType, typename SolverType, typename SolveValueType>
+template <typename MatrixType>
+smoothed_aggregation<IndexType,ValueType,MemorySpace,SmootherType,SolverType,SolveValueType>
+::smoothed_aggregation(const MatrixType& A, const cusp::array2d<ValueType,MemorySpace,cusp::column_major>& B)
+  : sa_options(default_sa_options), solve_only(false)
+{
+    sa_initialize(A, B);
+}
+
+template <typename IndexType, typename ValueType, typename MemorySpace, typename SmootherType, typename SolverType, typename SolveValueType>
+template <typename MatrixType, typename Options>
+smoothed_aggregation<IndexType,ValueType,MemorySpace,SmootherType,SolverType,SolveValueType>
+::smoothed_aggregation(const MatrixType& A, const cusp::array2d<ValueType,MemorySpace,cusp::column_major>& B,
+                       const Options& sa_options)
+  : sa_options(sa_options), solve_only(false)
+{
+    sa_initialize(A, B);
+}
+
+template <typename IndexType, typename ValueType, typename MemorySpace, typename SmootherType, typename SolverType, typename SolveValueType>
+template <typename MemorySpace2, typename SmootherType2, typename SolverType2, typename SolveValueType2>
+smoothed_aggregation<IndexType,ValueType,MemorySpace,SmootherType,SolverType,SolveValueType>
+::smoothed_aggregation(const smoothed_aggregation<IndexType,ValueType,MemorySpace2,SmootherType2,SolverType2,SolveValueType2>& M)
+    : sa_options(M.sa_options), solve_only(M.solve_only), Parent(M)
 {
    for( size_t lvl = 0; lvl < M.sa_levels.size(); lvl++ )
       sa_levels.push_back(M.sa_levels[lvl]);
+
+   // the fine operator is dropped between memory spaces
+   tiled_fine = M.tiled_fine && !Parent::fine_operator.empty();
 }
 
-template <typename IndexType, typename ValueType, typename MemorySpace, typename SmootherType, typename SolverType>
+template <typename IndexType, typename ValueType, typename MemorySpace, typename SmootherType, typename SolverType, typename SolveValueType>
 template <typename MatrixType, typename ArrayType>
-void smoothed_aggregation<IndexType,ValueType,MemorySpace,SmootherType,SolverType>
+void smoothed_aggregation<IndexType,ValueType,MemorySpace,SmootherType,SolverType,SolveValueType>
 ::sa_initialize(const MatrixType& A, const ArrayType& B)
 {
     CUSP_PROFILE_SCOPED();
@@ -107,10 +161,12 @@ void smoothed_aggregation<IndexType,ValueType,MemorySpace,SmootherType,SolverTyp
     Parent* ML = this;
     ML->levels.reserve(sa_options.max_levels); // avoid reallocations which force matrix copies
 
+    tiled_fine = false;
+
     sa_levels.push_back(sa_level<SetupMatrixType>());
     ML->levels.push_back(typename Parent::level());
 
-    sa_levels.back().B = B;
+    detail::assign_candidates(sa_levels.back().B, B, typename ArrayType::format());
     sa_levels.back().A_ = A; // copy
 
     while ((sa_levels.back().A_.num_rows > sa_options.min_level_size) &&
@@ -122,61 +178,212 @@ void smoothed_aggregation<IndexType,ValueType,MemorySpace,SmootherType,SolverTyp
     // Setup solve matrix for each level
     for( size_t lvl = 0; lvl < sa_levels.size(); lvl++ )
         detail::setup_level_matrix( ML->levels[lvl].A, sa_levels[lvl].A_ );
+
+    if (detail::is_irregular_level(ML->levels[0].A))
+        set_tiled_fine_operator();
+}
+
+template <typename IndexType, typename ValueType, typename MemorySpace, typename SmootherType, typename SolverType, typename SolveValueType>
+template <typename MatrixType>
+void smoothed_aggregation<IndexType,ValueType,MemorySpace,SmootherType,SolverType,SolveValueType>
+::resetup(const MatrixType& A)
+{
+    CUSP_PROFILE_SCOPED();
+
+    Parent* ML = this;
+
+    if (A.num_rows != ML->levels[0].A.num_rows || A.num_cols != ML->levels[0].A.num_cols)
+        throw cusp::invalid_input_exception("matrix dimensions do not match the existing hierarchy");
+
+    sa_levels[0].A_ = A; // copy
+
+    // rebuild the operators of each level from the existing aggregates
+    for( size_t lvl = 0; lvl + 1 < sa_levels.size(); lvl++ )
+    {
+        SetupMatrixType C;
+        if (sa_options.prolongation == FILTERED_JACOBI_PROLONGATION)
+            sa_options.strength_of_connection(sa_levels[lvl].A_, C);
+
+        setup_level(lvl, C);
+    }
+
+    ML->solver = SolverType(sa_levels.back().A_);
+
+    // Setup solve matrix for each level
+    for( size_t lvl = 0; lvl < sa_levels.size(); lvl++ )
+        detail::setup_level_matrix( ML->levels[lvl].A, sa_levels[lvl].A_ );
+
+    // the tiled operator holds the old values
+    if (tiled_fine)
+        set_tiled_fine_operator();
+
+    // and so do the operators in other formats
+    this->_refresh_level_formats();
+
+    // refresh the host copy of the coarse levels
+    if (ML->host_level_size > 0)
+        ML->set_host_levels(ML->host_level_size);
+
+    // the captured cycle refers to the old levels
+    ML->set_graph_capture(ML->graph_capture);
+
+    if (solve_only)
+        set_solve_only(true);
 }
 
-template <typename IndexType, typename ValueType, typename MemorySpace, typename SmootherType, typename SolverType>
-void smoothed_aggregation<IndexType,ValueType,MemorySpace,SmootherType,SolverType>
+template <typename IndexType, typename ValueType, typename MemorySpace, typename SmootherType, typename SolverType, typename SolveValueType>
+void smoothed_aggregation<IndexType,ValueType,MemorySpace,SmootherType,SolverType,SolveValueType>
+::set_tiled_fine_operator(void)
+{
+    typedef typename SolveMatrixType::value_type SolveType;
+
+    Parent* ML = this;
+
+    ML->set_fine_operator(cusp::tiled_csr_operator<IndexType,SolveType,MemorySpace>(ML->levels[0].A));
+    tiled_fine = true;
+}
+
+template <typename IndexType, typename ValueType, typename MemorySpace, typename SmootherType, typename SolverType, typename SolveValueType>
+void smoothed_aggregation<IndexType,ValueType,MemorySpace,SmootherType,SolverType,SolveValueType>
+::set_solve_only(bool enable)
+{
+    solve_only = enable;
+
+    if (!enable)
+        return;
+
+    // the level operators live on in ML->levels, the setup copies are
+    // rebuilt by resetup() from the aggregates and candidates
+    for( size_t lvl = 0; lvl < sa_levels.size(); lvl++ )
+    {
+        SetupMatrixType empty;
+        sa_levels[lvl].A_.swap(empty);
+    }
+}
+
+template <typename IndexType, typename ValueType, typename MemorySpace, typename SmootherType, typename SolverType, typename SolveValueType>
+void smoothed_aggregation<IndexType,ValueType,MemorySpace,SmootherType,SolverType,SolveValueType>
+::write_profile(std::ostream& os) const
+{
+    double total = 0;
+
+    os << "{\n\"setup\": [";
+
+    for( size_t lvl = 0; lvl < sa_levels.size(); lvl++ )
+    {
+        const sa_level_timings& T = sa_levels[lvl].timings;
+        total += T.total();
+
+        os << (lvl == 0 ? "\n" : ",\n");
+        os << "  {\"level\": " << lvl
+           << ", \"strength_ms\": " << T.strength
+           << ", \"aggregate_ms\": " << T.aggregate
+           << ", \"fit_candidates_ms\": " << T.tentative
+           << ", \"smooth_ms\": " << T.smooth
+           << ", \"restriction_ms\": " << T.restriction
+           << ", \"galerkin_ms\": " << T.galerkin
+           << ", \"total_ms\": " << T.total() << "}";
+    }
+
+    os << "\n],\n\"setup_total_ms\": " << total << ",\n\"solve\": ";
+    Parent::write_profile(os);
+    os << "\n}\n";
+}
+
+template <typename IndexType, typename ValueType, typename MemorySpace, typename SmootherType, typename SolverType, typename SolveValueType>
+void smoothed_aggregation<IndexType,ValueType,MemorySpace,SmootherType,SolverType,SolveValueType>
 ::extend_hierarchy(void)
 {
     CUSP_PROFILE_SCOPED();
 
     Parent* ML = this;
 
+    const size_t lvl = sa_levels.size() - 1;
+
+    // events on the current stream, or the host clock for a host hierarchy
+    cusp::detail::lap_timer stage_timer(cusp::current_stream(), true,
+                                        cusp::detail::is_device_space<MemorySpace>::value);
+
+    // strength of connection matrix, kept for a filtered prolongator
+    SetupMatrixType C;
+
     cusp::array1d<IndexType,MemorySpace> aggregates;
     {
         // compute stength of connection matrix
-        SetupMatrixType C;
-        sa_options.strength_of_connection(sa_levels.back().A_, C);
+        sa_options.strength_of_connection(sa_levels[lvl].A_, C);
+        sa_levels[lvl].timings.strength = stage_timer.lap();
 
         // compute aggregates
         aggregates.resize(C.num_rows);
         cusp::blas::fill(aggregates,IndexType(0));
-        sa_options.aggregate(C, aggregates);
+        sa_options.aggregate(C, aggregates, lvl);
+        sa_levels[lvl].timings.aggregate = stage_timer.lap();
     }
 
+    sa_levels[lvl].aggregates.swap(aggregates);
+    ML->levels[lvl].residual.resize(sa_levels[lvl].A_.num_rows, cusp::uninitialized);
+
+    ML->levels.push_back(typename Parent::level());
+    sa_levels.push_back(sa_level<SetupMatrixType>());
+
+    if (sa_options.prolongation != FILTERED_JACOBI_PROLONGATION)
+    {
+        SetupMatrixType empty;
+        C.swap(empty);
+    }
+
+    setup_level(lvl, C);
+
+    ML->levels.back().x.resize(sa_levels.back().A_.num_rows);
+    ML->levels.back().b.resize(sa_levels.back().A_.num_rows);
+}
+
+template <typename IndexType, typename ValueType, typename MemorySpace, typename SmootherType, typename SolverType, typename SolveValueType>
+void smoothed_aggregation<IndexType,ValueType,MemorySpace,SmootherType,SolverType,SolveValueType>
+::setup_level(const size_t lvl, const SetupMatrixType& C)
+{
+    CUSP_PROFILE_SCOPED();
+
+    Parent* ML = this;
+
+    sa_level<SetupMatrixType>& fine = sa_levels[lvl];
+    sa_level_timings& timings = fine.timings;
+
+    cusp::detail::lap_timer stage_timer(cusp::current_stream(), true,
+                                        cusp::detail::is_device_space<MemorySpace>::value);
+
     SetupMatrixType P;
-    cusp::array1d<ValueType,MemorySpace>  B_coarse;
+    cusp::array2d<ValueType,MemorySpace,cusp::column_major> B_coarse;
     {
-        // compute tenative prolongator and coarse nullspace vector
+        // compute tenative prolongator and coarse nullspace candidates
         SetupMatrixType 				T;
-        sa_options.fit_candidates(aggregates, sa_levels.back().B, T, B_coarse);
+        sa_options.fit_candidates(fine.aggregates, fine.B, T, B_coarse);
+        timings.tentative = stage_timer.lap();
 
         // compute prolongation operator
-        sa_options.smooth_prolongator(sa_levels.back().A_, T, P, sa_levels.back().rho_DinvA);  // TODO if C != A then compute rho_Dinv_C
+        sa_options.smooth_prolongator(fine.A_, C, T, B_coarse, P, fine.rho_DinvA);
+        timings.smooth = stage_timer.lap();
     }
 
     // compute restriction operator (transpose of prolongator)
     SetupMatrixType R;
     sa_options.form_restriction(P,R);
+    timings.restriction = stage_timer.lap();
 
     // construct Galerkin product R*A*P
     SetupMatrixType RAP;
-    sa_options.galerkin_product(R,sa_levels.back().A_,P,RAP);
-
-    ML->levels.back().smoother = SmootherType(sa_levels.back());
+    sa_options.galerkin_product(R,fine.A_,P,RAP);
+    timings.galerkin = stage_timer.lap();
 
-    sa_levels.back().aggregates.swap(aggregates);
-    detail::setup_level_matrix( ML->levels.back().R, R );
-    detail::setup_level_matrix( ML->levels.back().P, P );
-    ML->levels.back().residual.resize(sa_levels.back().A_.num_rows);
+    ML->levels[lvl].smoother = SmootherType(fine);
 
-    ML->levels.push_back(typename Parent::level());
-    sa_levels.push_back(sa_level<SetupMatrixType>());
+    // an implicit restriction applies P^T instead
+    if (!ML->implicit_restriction)
+        detail::setup_level_matrix( ML->levels[lvl].R, R );
+    detail::setup_level_matrix( ML->levels[lvl].P, P );
 
-    sa_levels.back().A_.swap(RAP);
-    sa_levels.back().B.swap(B_coarse);
-    ML->levels.back().x.resize(sa_levels.back().A_.num_rows);
-    ML->levels.back().b.resize(sa_levels.back().A_.num_rows);
+    sa_levels[lvl + 1].A_.swap(RAP);
+    sa_levels[lvl + 1].B.swap(B_coarse);
 }
 
 } // end namespace aggregation
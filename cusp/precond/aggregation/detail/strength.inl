@@ -17,14 +17,33 @@
 
 #include <cusp/copy.h>
 #include <cusp/array1d.h>
+#include <cusp/blas.h>
 #include <cusp/convert.h>
+#include <cusp/coo_matrix.h>
 #include <cusp/csr_matrix.h>
+#include <cusp/elementwise.h>
+#include <cusp/multiply.h>
+#include <cusp/transpose.h>
 #include <cusp/detail/format_utils.h>
+#include <cusp/detail/host/parallel.h>
+#include <cusp/detail/random.h>
+#include <cusp/detail/spectral_radius.h>
 
+#include <cusp/precond/aggregation/smooth.h>
+#include <cusp/precond/aggregation/truncate.h>
+
+#include <thrust/binary_search.h>
+#include <thrust/copy.h>
 #include <thrust/count.h>
 #include <thrust/functional.h>
+#include <thrust/sequence.h>
+#include <thrust/transform.h>
 #include <thrust/iterator/zip_iterator.h>
 #include <thrust/iterator/permutation_iterator.h>
+#include <thrust/iterator/transform_iterator.h>
+
+#include <cmath>
+#include <limits>
 
 namespace cusp
 {
@@ -46,6 +65,17 @@ ValueType absolute_value(const ValueType& x)
 // Host Paths //
 ////////////////
 
+// |A(i,j)| >= theta * sqrt(|A(i,i)|*|A(j,j)|), squared to eliminate the sqrt()
+template <typename ValueType>
+bool is_strong_entry(const ValueType Aij, const ValueType Aii, const ValueType Ajj, const double theta)
+{
+  return Aij * Aij >= (theta * theta) * absolute_value(Aii * Ajj);
+}
+
+// The rows are filtered in parallel: each block of rows counts its strong
+// entries, the counts are scanned into the row offsets of S, and each block
+// then copies its entries from the offsets of its rows.  The output is the
+// same for any number of threads.
 template <typename Matrix1, typename Matrix2>
 void symmetric_strength_of_connection(const Matrix1& A, Matrix2& S, const double theta,
                                       cusp::csr_format, cusp::host_memory,
@@ -53,60 +83,72 @@ void symmetric_strength_of_connection(const Matrix1& A, Matrix2& S, const double
 {
   typedef typename Matrix1::index_type IndexType;
   typedef typename Matrix1::value_type ValueType;
+  typedef typename Matrix2::index_type IndexType2;
 
   // extract matrix diagonal
   cusp::array1d<ValueType,cusp::host_memory> diagonal;
   cusp::detail::extract_diagonal(A, diagonal);
 
-  IndexType num_entries = 0;
-  
-  // count num_entries in output
-  for(size_t i = 0; i < A.num_rows; i++)
+  const size_t N = A.num_rows;
+  const int    P = cusp::detail::host::num_parts(A.num_entries + N);
+
+  // count the strong connections of each row
+  S.resize(A.num_rows, A.num_cols, 0);
+
+#ifdef _OPENMP
+  #pragma omp parallel for schedule(static) num_threads(P)
+#endif
+  for (int part = 0; part < P; part++)
   {
-    const ValueType Aii = diagonal[i];
+    const size_t i_end = cusp::detail::host::balanced_split(A.row_offsets, N, part + 1, P);
 
-    for(IndexType jj = A.row_offsets[i]; jj < A.row_offsets[i + 1]; jj++)
+    for (size_t i = cusp::detail::host::balanced_split(A.row_offsets, N, part, P); i < i_end; i++)
     {
-      const IndexType   j = A.column_indices[jj];
-      const ValueType Aij = A.values[jj];
-      const ValueType Ajj = diagonal[j];
+      const ValueType Aii = diagonal[i];
 
-      //  |A(i,j)| >= theta * sqrt(|A(i,i)|*|A(j,j)|)
-      if(Aij*Aij >= (theta * theta) * absolute_value(Aii * Ajj))
-        num_entries++;
+      IndexType2 count = 0;
+
+      for (IndexType jj = A.row_offsets[i]; jj < A.row_offsets[i + 1]; jj++)
+        if (is_strong_entry(A.values[jj], Aii, diagonal[A.column_indices[jj]], theta))
+          count++;
+
+      S.row_offsets[i] = count;
     }
   }
-  
-  // resize output
-  S.resize(A.num_rows, A.num_cols, num_entries);
 
-  // reset counter for second pass
-  num_entries = 0;
+  cusp::detail::host::counts_to_offsets(S.row_offsets, N);
+
+  // resize output, keeping the row offsets
+  S.resize(A.num_rows, A.num_cols, S.row_offsets[N]);
 
   // copy strong connections to output
-  for(size_t i = 0; i < A.num_rows; i++)
+#ifdef _OPENMP
+  #pragma omp parallel for schedule(static) num_threads(P)
+#endif
+  for (int part = 0; part < P; part++)
   {
-    const ValueType Aii = diagonal[i];
-  
-    S.row_offsets[i] = num_entries;
+    const size_t i_end = cusp::detail::host::balanced_split(A.row_offsets, N, part + 1, P);
 
-    for(IndexType jj = A.row_offsets[i]; jj < A.row_offsets[i + 1]; jj++)
+    for (size_t i = cusp::detail::host::balanced_split(A.row_offsets, N, part, P); i < i_end; i++)
     {
-      const IndexType   j = A.column_indices[jj];
-      const ValueType Aij = A.values[jj];
-      const ValueType Ajj = diagonal[j];
-      
-      //  |A(i,j)| >= theta * sqrt(|A(i,i)|*|A(j,j)|)
-      if(Aij*Aij >= (theta * theta) * absolute_value(Aii * Ajj))
+      const ValueType Aii = diagonal[i];
+
+      IndexType2 n = S.row_offsets[i];
+
+      for (IndexType jj = A.row_offsets[i]; jj < A.row_offsets[i + 1]; jj++)
       {
-        S.column_indices[num_entries] =   j;
-        S.values[num_entries]         = Aij;
-        num_entries++;
+        const IndexType   j = A.column_indices[jj];
+        const ValueType Aij = A.values[jj];
+
+        if (is_strong_entry(Aij, Aii, diagonal[j], theta))
+        {
+          S.column_indices[n] =   j;
+          S.values[n]         = Aij;
+          n++;
+        }
       }
     }
   }
-    
-  S.row_offsets[S.num_rows] = num_entries;
 }
 
 //////////////////
@@ -205,6 +247,331 @@ void symmetric_strength_of_connection(const Matrix1& A, Matrix2& S, const double
   cusp::convert(S_csr, S);
 }
 
+///////////////////////
+// Distance Measures //
+///////////////////////
+
+// measure of off-diagonal entries, the largest value for the diagonal
+template <typename IndexType, typename ValueType>
+struct off_diagonal_measure
+{
+  ValueType largest;
+
+  off_diagonal_measure(const ValueType largest) : largest(largest) {}
+
+  template <typename Tuple>
+    __host__ __device__
+  ValueType operator()(const Tuple& t) const
+  {
+    return thrust::get<0>(t) == thrust::get<1>(t) ? largest : thrust::get<2>(t);
+  }
+};
+
+// diagonal entries and m(i,j) <= theta * min_k m(i,k)
+template <typename ValueType>
+struct is_close_connection
+{
+  ValueType theta;
+
+  is_close_connection(const ValueType theta) : theta(theta) {}
+
+  template <typename Tuple>
+    __host__ __device__
+  int operator()(const Tuple& t) const
+  {
+    return thrust::get<0>(t) == thrust::get<1>(t) || thrust::get<2>(t) <= theta * thrust::get<3>(t);
+  }
+};
+
+// combines the value of entry (i,j) with the value of entry (j,i), given
+// the lower bound of (j,i) in the matrix, when the transposed entry exists
+template <typename IndexType, typename ValueType, typename BinaryFunction>
+struct combine_with_transpose
+{
+  const IndexType* rows;
+  const IndexType* columns;
+  const ValueType* values;
+  const IndexType num_entries;
+  BinaryFunction op;
+
+  combine_with_transpose(const IndexType* rows, const IndexType* columns, const ValueType* values,
+                         const IndexType num_entries, BinaryFunction op)
+    : rows(rows), columns(columns), values(values), num_entries(num_entries), op(op) {}
+
+  template <typename Tuple>
+    __host__ __device__
+  ValueType operator()(const Tuple& t) const
+  {
+    const IndexType position = thrust::get<0>(t);
+    const ValueType value    = thrust::get<3>(t);
+
+    if (position < num_entries && rows[position] == thrust::get<2>(t) && columns[position] == thrust::get<1>(t))
+      return op(value, values[position]);
+    else
+      return value;
+  }
+};
+
+// values[e] <- op(values[e], values[e']) where e' is entry (j,i) of entry
+// e = (i,j), for a matrix sorted by row and column
+template <typename Matrix, typename Array, typename BinaryFunction>
+void symmetrize_entries(const Matrix& A, Array& values, BinaryFunction op)
+{
+  typedef typename Matrix::index_type   IndexType;
+  typedef typename Array::value_type    ValueType;
+  typedef typename Matrix::memory_space MemorySpace;
+
+  if (A.num_entries == 0)
+    return;
+
+  cusp::array1d<IndexType,MemorySpace> positions(A.num_entries);
+  thrust::lower_bound(thrust::make_zip_iterator(thrust::make_tuple(A.row_indices.begin(),    A.column_indices.begin())),
+                      thrust::make_zip_iterator(thrust::make_tuple(A.row_indices.end(),      A.column_indices.end())),
+                      thrust::make_zip_iterator(thrust::make_tuple(A.column_indices.begin(), A.row_indices.begin())),
+                      thrust::make_zip_iterator(thrust::make_tuple(A.column_indices.end(),   A.row_indices.end())),
+                      positions.begin());
+
+  cusp::array1d<ValueType,MemorySpace> original(values);
+
+  thrust::transform(thrust::make_zip_iterator(thrust::make_tuple(positions.begin(), A.row_indices.begin(), A.column_indices.begin(), original.begin())),
+                    thrust::make_zip_iterator(thrust::make_tuple(positions.end(),   A.row_indices.end(),   A.column_indices.end(),   original.end())),
+                    values.begin(),
+                    combine_with_transpose<IndexType,ValueType,BinaryFunction>(thrust::raw_pointer_cast(&A.row_indices[0]),
+                                                                               thrust::raw_pointer_cast(&A.column_indices[0]),
+                                                                               thrust::raw_pointer_cast(&original[0]),
+                                                                               A.num_entries, op));
+}
+
+// S <- the entries (i,j) of A, sorted by row and column, with a distance
+// m(i,j) <= theta * min_{k != i} m(i,k) in row i or row j, and the diagonal
+template <typename Matrix1, typename Array, typename Matrix2>
+void distance_filter(const Matrix1& A, const Array& measure, Matrix2& S, const double theta)
+{
+  typedef typename Matrix1::index_type   IndexType;
+  typedef typename Matrix1::value_type   ValueType;
+  typedef typename Array::value_type     MeasureType;
+  typedef typename Matrix1::memory_space MemorySpace;
+
+  // smallest off-diagonal distance of each row
+  cusp::array1d<MeasureType,MemorySpace> row_min(A.num_rows);
+  reduce_rows(A.row_indices,
+              thrust::make_transform_iterator(thrust::make_zip_iterator(thrust::make_tuple(A.row_indices.begin(), A.column_indices.begin(), measure.begin())),
+                                              off_diagonal_measure<IndexType,MeasureType>(std::numeric_limits<MeasureType>::max())),
+              row_min, thrust::minimum<MeasureType>());
+
+  cusp::array1d<int,MemorySpace> keep(A.num_entries);
+  thrust::transform(thrust::make_zip_iterator(thrust::make_tuple(A.row_indices.begin(), A.column_indices.begin(), measure.begin(),
+                                                                 thrust::make_permutation_iterator(row_min.begin(), A.row_indices.begin()))),
+                    thrust::make_zip_iterator(thrust::make_tuple(A.row_indices.end(), A.column_indices.end(), measure.end(),
+                                                                 thrust::make_permutation_iterator(row_min.begin(), A.row_indices.end()))),
+                    keep.begin(),
+                    is_close_connection<MeasureType>(MeasureType(theta)));
+
+  // a connection strong for either of its points is kept in both rows
+  symmetrize_entries(A, keep, thrust::logical_or<int>());
+
+  const IndexType num_entries = thrust::count(keep.begin(), keep.end(), 1);
+
+  cusp::coo_matrix<IndexType,ValueType,MemorySpace> S_coo(A.num_rows, A.num_cols, num_entries);
+  thrust::copy_if(thrust::make_zip_iterator(thrust::make_tuple(A.row_indices.begin(), A.column_indices.begin(), A.values.begin())),
+                  thrust::make_zip_iterator(thrust::make_tuple(A.row_indices.end(),   A.column_indices.end(),   A.values.end())),
+                  keep.begin(),
+                  thrust::make_zip_iterator(thrust::make_tuple(S_coo.row_indices.begin(), S_coo.column_indices.begin(), S_coo.values.begin())),
+                  thrust::identity<int>());
+
+  cusp::convert(S_coo, S);
+}
+
+// z_ii for diagonal entries, 0 otherwise
+template <typename ValueType>
+struct diagonal_entry_value
+{
+  template <typename Tuple>
+    __host__ __device__
+  ValueType operator()(const Tuple& t) const
+  {
+    return thrust::get<0>(t) == thrust::get<1>(t) ? thrust::get<2>(t) : ValueType(0);
+  }
+};
+
+// |1 - z_ij / z_ii|, how well the evolved point i is approximated at j
+template <typename ValueType>
+struct approximation_ratio
+{
+  ValueType largest;
+
+  approximation_ratio(const ValueType largest) : largest(largest) {}
+
+  template <typename Tuple>
+    __host__ __device__
+  ValueType operator()(const Tuple& t) const
+  {
+    const ValueType z_ij = thrust::get<0>(t);
+    const ValueType z_ii = thrust::get<1>(t);
+
+    if (z_ii == ValueType(0))
+      return largest;
+
+    return absolute_value(ValueType(1) - z_ij / z_ii);
+  }
+};
+
+template <typename Matrix1, typename Matrix2>
+void evolution_strength_of_connection(const Matrix1& A, Matrix2& S, const double theta, const size_t k)
+{
+  typedef typename Matrix1::index_type   IndexType;
+  typedef typename Matrix1::value_type   ValueType;
+  typedef typename Matrix1::memory_space MemorySpace;
+  typedef cusp::coo_matrix<IndexType,ValueType,MemorySpace> CooMatrix;
+
+  CooMatrix A_coo(A);
+  A_coo.sort_by_row_and_column();
+
+  const size_t N = A_coo.num_rows;
+
+  cusp::array1d<ValueType,MemorySpace> diagonal(N);
+  cusp::detail::extract_diagonal(A_coo, diagonal);
+
+  const ValueType rho = cusp::detail::estimate_spectral_radius_Dinv_A(A_coo);
+
+  // E <- I - (1 / rho) D^-1 A, one Jacobi step
+  CooMatrix E;
+  {
+    CooMatrix Dinv_A(A_coo);
+    thrust::transform(Dinv_A.values.begin(), Dinv_A.values.end(),
+                      thrust::make_permutation_iterator(diagonal.begin(), Dinv_A.row_indices.begin()),
+                      Dinv_A.values.begin(),
+                      thrust::divides<ValueType>());
+    cusp::blas::scal(Dinv_A.values, ValueType(-1) / (rho == 0 ? ValueType(1) : rho));
+
+    CooMatrix I(N, N, N);
+    thrust::sequence(I.row_indices.begin(), I.row_indices.end());
+    thrust::sequence(I.column_indices.begin(), I.column_indices.end());
+    thrust::fill(I.values.begin(), I.values.end(), ValueType(1));
+
+    cusp::add(I, Dinv_A, E);
+  }
+
+  // Z <- (E^k)^T, column i is point i after k steps
+  CooMatrix Z(E);
+  for (size_t step = 1; step < k; step++)
+  {
+    CooMatrix temp;
+    cusp::multiply(Z, E, temp);
+    Z.swap(temp);
+  }
+  {
+    CooMatrix temp;
+    cusp::transpose(Z, temp);
+    Z.swap(temp);
+  }
+  Z.sort_by_row_and_column();
+
+  // the evolved values on the pattern of A
+  cusp::array1d<ValueType,MemorySpace> z(A_coo.num_entries);
+  restrict_to_pattern(A_coo.row_indices, A_coo.column_indices, Z, z);
+
+  cusp::array1d<ValueType,MemorySpace> z_diagonal(N);
+  reduce_rows(A_coo.row_indices,
+              thrust::make_transform_iterator(thrust::make_zip_iterator(thrust::make_tuple(A_coo.row_indices.begin(), A_coo.column_indices.begin(), z.begin())),
+                                              diagonal_entry_value<ValueType>()),
+              z_diagonal, thrust::plus<ValueType>());
+
+  cusp::array1d<ValueType,MemorySpace> measure(A_coo.num_entries);
+  thrust::transform(thrust::make_zip_iterator(thrust::make_tuple(z.begin(), thrust::make_permutation_iterator(z_diagonal.begin(), A_coo.row_indices.begin()))),
+                    thrust::make_zip_iterator(thrust::make_tuple(z.end(),   thrust::make_permutation_iterator(z_diagonal.begin(), A_coo.row_indices.end()))),
+                    measure.begin(),
+                    approximation_ratio<ValueType>(std::numeric_limits<ValueType>::max() / 4));
+
+  // m(i,j) + m(j,i), the filter only compares distances
+  symmetrize_entries(A_coo, measure, thrust::plus<ValueType>());
+
+  distance_filter(A_coo, measure, S, theta);
+}
+
+// (sum_r (x_r[i] - x_r[j])^2)^(1/2) over the columns of X
+template <typename IndexType, typename ValueType>
+struct algebraic_distance
+{
+  const ValueType* X;
+  const size_t N;
+  const size_t num_vectors;
+
+  algebraic_distance(const ValueType* X, const size_t N, const size_t num_vectors)
+    : X(X), N(N), num_vectors(num_vectors) {}
+
+  template <typename Tuple>
+    __host__ __device__
+  ValueType operator()(const Tuple& t) const
+  {
+    const IndexType i = thrust::get<0>(t);
+    const IndexType j = thrust::get<1>(t);
+
+    ValueType sum(0);
+    for (size_t r = 0; r < num_vectors; r++)
+    {
+      const ValueType difference = X[r * N + i] - X[r * N + j];
+      sum += difference * difference;
+    }
+
+    return sqrt(sum);
+  }
+};
+
+template <typename Matrix1, typename Matrix2>
+void algebraic_distance_strength_of_connection(const Matrix1& A, Matrix2& S, const double theta,
+                                               const size_t num_vectors, const size_t sweeps)
+{
+  typedef typename Matrix1::index_type   IndexType;
+  typedef typename Matrix1::value_type   ValueType;
+  typedef typename Matrix1::memory_space MemorySpace;
+  typedef typename cusp::array1d<ValueType,MemorySpace>::iterator Iterator;
+
+  // Jacobi weight of the relaxation
+  const ValueType omega(0.5);
+
+  cusp::coo_matrix<IndexType,ValueType,MemorySpace> A_coo(A);
+  A_coo.sort_by_row_and_column();
+
+  const size_t N = A_coo.num_rows;
+
+  cusp::array1d<ValueType,MemorySpace> diagonal(N);
+  cusp::detail::extract_diagonal(A_coo, diagonal);
+
+  // random vectors in [-1,1), one after the other
+  cusp::array1d<ValueType,MemorySpace> X(N * num_vectors);
+  cusp::copy(cusp::detail::random_reals<ValueType>(N * num_vectors), X);
+  thrust::transform(X.begin(), X.end(), X.begin(), ValueType(2) * thrust::placeholders::_1 - ValueType(1));
+
+  cusp::array1d<ValueType,MemorySpace> y(N);
+
+  for (size_t r = 0; r < num_vectors; r++)
+  {
+    cusp::array1d_view<Iterator> x(X.begin() + r * N, X.begin() + (r + 1) * N);
+
+    // x <- x - omega D^-1 A x, smooths x towards the near-nullspace of A
+    for (size_t sweep = 0; sweep < sweeps; sweep++)
+    {
+      cusp::multiply(A_coo, x, y);
+      thrust::transform(y.begin(), y.end(), diagonal.begin(), y.begin(), thrust::divides<ValueType>());
+      cusp::blas::axpy(y, x, -omega);
+    }
+
+    const ValueType norm = cusp::blas::nrm2(x);
+    if (norm > ValueType(0))
+      cusp::blas::scal(x, ValueType(1) / norm);
+  }
+
+  cusp::array1d<ValueType,MemorySpace> measure(A_coo.num_entries);
+  if (A_coo.num_entries > 0)
+    thrust::transform(thrust::make_zip_iterator(thrust::make_tuple(A_coo.row_indices.begin(), A_coo.column_indices.begin())),
+                      thrust::make_zip_iterator(thrust::make_tuple(A_coo.row_indices.end(),   A_coo.column_indices.end())),
+                      measure.begin(),
+                      algebraic_distance<IndexType,ValueType>(thrust::raw_pointer_cast(&X[0]), N, num_vectors));
+
+  distance_filter(A_coo, measure, S, theta);
+}
+
 } // end namepace detail
 
 /////////////////
@@ -231,7 +598,23 @@ void symmetric_strength_of_connection(const Matrix1& A, Matrix2& S, const double
   }
 }
 
+template <typename Matrix1, typename Matrix2>
+void evolution_strength_of_connection(const Matrix1& A, Matrix2& S, const double theta, const size_t k)
+{
+  CUSP_PROFILE_SCOPED();
+
+  detail::evolution_strength_of_connection(A, S, theta, k);
+}
+
+template <typename Matrix1, typename Matrix2>
+void algebraic_distance_strength_of_connection(const Matrix1& A, Matrix2& S, const double theta,
+                                               const size_t num_vectors, const size_t sweeps)
+{
+  CUSP_PROFILE_SCOPED();
+
+  detail::algebraic_distance_strength_of_connection(A, S, theta, num_vectors, sweeps);
+}
+
 } // end namespace aggregation
 } // end namespace precond
 } // end namespace cusp
-
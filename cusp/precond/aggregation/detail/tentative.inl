@@ -17,15 +17,24 @@
 
 #include <cusp/copy.h>
 #include <cusp/array1d.h>
+#include <cusp/array2d.h>
 #include <cusp/convert.h>
 #include <cusp/csr_matrix.h>
 #include <cusp/detail/format_utils.h>
 
+#include <thrust/binary_search.h>
 #include <thrust/count.h>
+#include <thrust/extrema.h>
+#include <thrust/for_each.h>
 #include <thrust/functional.h>
+#include <thrust/scan.h>
+#include <thrust/sequence.h>
+#include <thrust/sort.h>
 #include <thrust/iterator/zip_iterator.h>
 #include <thrust/iterator/permutation_iterator.h>
 
+#include <limits>
+
 namespace cusp
 {
 namespace precond
@@ -46,6 +55,202 @@ struct sqrt_functor : thrust::unary_function<T,T>
     }
 };
 
+// X[k * r + j] = B(rows[r], j), the candidates of the sorted rows in row-major order
+template <typename IndexType, typename ValueType, typename Orientation>
+struct gather_candidates : thrust::unary_function<IndexType,ValueType>
+{
+    const IndexType* rows;
+    const ValueType* B;
+    IndexType k;
+    IndexType pitch;
+
+    gather_candidates(const IndexType* rows, const ValueType* B, IndexType k, IndexType pitch)
+        : rows(rows), B(B), k(k), pitch(pitch) {}
+
+    __host__ __device__
+    ValueType operator()(const IndexType n) const
+    {
+        return B[cusp::detail::index_of(rows[n / k], n % k, pitch, Orientation())];
+    }
+};
+
+// number of coarse degrees of freedom of an aggregate, min(k, size)
+template <typename IndexType>
+struct aggregate_columns : thrust::binary_function<IndexType,IndexType,IndexType>
+{
+    IndexType k;
+
+    aggregate_columns(IndexType k) : k(k) {}
+
+    __host__ __device__
+    IndexType operator()(const IndexType end, const IndexType begin) const
+    {
+        return thrust::min(k, end - begin);
+    }
+};
+
+// number of entries of the block of Q of an aggregate
+template <typename IndexType>
+struct aggregate_entries : thrust::binary_function<IndexType,IndexType,IndexType>
+{
+    IndexType k;
+
+    aggregate_entries(IndexType k) : k(k) {}
+
+    __host__ __device__
+    IndexType operator()(const IndexType end, const IndexType begin) const
+    {
+        return (end - begin) * thrust::min(k, end - begin);
+    }
+};
+
+// Thin QR factorization B_a = Q_a R_a of the candidates restricted to
+// aggregate a with modified Gram-Schmidt.  An aggregate of s rows has
+// min(k,s) coarse degrees of freedom; a candidate that is (numerically)
+// a combination of the previous ones on the aggregate gets a zero
+// diagonal in R_a and Q_a is completed with an orthogonalized unit vector.
+template <typename IndexType, typename ValueType>
+struct fit_aggregate_candidates
+{
+    const IndexType* offsets;      // first sorted row of each aggregate
+    const IndexType* col_offsets;  // first coarse column of each aggregate
+    const IndexType* entry_offsets;// first entry of Q of each aggregate
+    const IndexType* rows;         // sorted rows
+    ValueType* X;                  // sorted candidates, row-major
+    IndexType* Q_rows;
+    IndexType* Q_cols;
+    ValueType* Q_vals;
+    ValueType* R;                  // column-major
+    IndexType k;
+    IndexType R_pitch;
+    ValueType tolerance;
+
+    fit_aggregate_candidates(const IndexType* offsets, const IndexType* col_offsets, const IndexType* entry_offsets,
+                             const IndexType* rows, ValueType* X,
+                             IndexType* Q_rows, IndexType* Q_cols, ValueType* Q_vals,
+                             ValueType* R, IndexType k, IndexType R_pitch, ValueType tolerance)
+        : offsets(offsets), col_offsets(col_offsets), entry_offsets(entry_offsets), rows(rows), X(X),
+          Q_rows(Q_rows), Q_cols(Q_cols), Q_vals(Q_vals), R(R), k(k), R_pitch(R_pitch), tolerance(tolerance) {}
+
+    __host__ __device__
+    ValueType dot(const ValueType* Xa, const IndexType size, const IndexType i, const IndexType j) const
+    {
+        ValueType sum = 0;
+        for (IndexType n = 0; n < size; n++)
+            sum += Xa[n * k + i] * Xa[n * k + j];
+        return sum;
+    }
+
+    // column j <- column j - sum_{i<j} (q_i . column j) q_i
+    __host__ __device__
+    void orthogonalize(ValueType* Xa, const IndexType size, const IndexType j, ValueType* Ra) const
+    {
+        for (IndexType i = 0; i < j; i++)
+        {
+            const ValueType r = dot(Xa, size, i, j);
+
+            for (IndexType n = 0; n < size; n++)
+                Xa[n * k + j] -= r * Xa[n * k + i];
+
+            if (Ra != NULL)
+                Ra[i + j * R_pitch] = r;
+        }
+    }
+
+    // column j <- e_m orthogonalized against the previous columns
+    __host__ __device__
+    ValueType unit_column(ValueType* Xa, const IndexType size, const IndexType j, const IndexType m) const
+    {
+        for (IndexType n = 0; n < size; n++)
+            Xa[n * k + j] = (n == m) ? ValueType(1) : ValueType(0);
+
+        orthogonalize(Xa, size, j, NULL);
+
+        return sqrt(dot(Xa, size, j, j));
+    }
+
+    __host__ __device__
+    void operator()(const IndexType a) const
+    {
+        const IndexType begin   = offsets[a];
+        const IndexType size    = offsets[a + 1] - begin;
+        const IndexType columns = col_offsets[a + 1] - col_offsets[a];
+
+        ValueType* Xa = X + begin * k;
+        ValueType* Ra = R + col_offsets[a];
+
+        for (IndexType j = 0; j < k; j++)
+        {
+            const ValueType norm_b = sqrt(dot(Xa, size, j, j));
+
+            // the first min(k,size) columns span the aggregate, so the
+            // remaining candidates only have components along them
+            if (j >= columns)
+            {
+                for (IndexType i = 0; i < columns; i++)
+                    Ra[i + j * R_pitch] = dot(Xa, size, i, j);
+                continue;
+            }
+
+            orthogonalize(Xa, size, j, Ra);
+
+            ValueType norm_q = sqrt(dot(Xa, size, j, j));
+
+            if (norm_q > tolerance * norm_b)
+            {
+                Ra[j + j * R_pitch] = norm_q;
+            }
+            else
+            {
+                // complete Q_a with the unit vector furthest from the span
+                // of the previous columns, which exists since j < size
+                Ra[j + j * R_pitch] = 0;
+
+                IndexType best = 0;
+                ValueType best_norm = 0;
+                for (IndexType m = 0; m < size; m++)
+                {
+                    const ValueType norm = unit_column(Xa, size, j, m);
+                    if (norm > best_norm)
+                    {
+                        best = m;
+                        best_norm = norm;
+                    }
+                }
+
+                norm_q = unit_column(Xa, size, j, best);
+            }
+
+            for (IndexType n = 0; n < size; n++)
+                Xa[n * k + j] /= norm_q;
+        }
+
+        // scatter the block of Q_a
+        IndexType entry = entry_offsets[a];
+        for (IndexType n = 0; n < size; n++)
+        {
+            for (IndexType j = 0; j < columns; j++, entry++)
+            {
+                Q_rows[entry] = rows[begin + n];
+                Q_cols[entry] = col_offsets[a] + j;
+                Q_vals[entry] = Xa[n * k + j];
+            }
+        }
+    }
+};
+
+template <typename Matrix>
+void assign_tentative(Matrix& dst, Matrix& src)
+{
+    dst.swap(src);
+}
+
+template <typename Matrix1, typename Matrix2>
+void assign_tentative(Matrix1& dst, Matrix2& src)
+{
+    dst = src;
+}
+
 template <typename Array1,
          typename Array2,
          typename MatrixType,
@@ -98,8 +303,98 @@ void fit_candidates(const Array1& aggregates,
                       Q.values.begin(),
                       thrust::divides<ValueType>());
 
-    // copy/convert Q to output matrix Q_
-    Q_ = Q;
+    // move/convert Q to output matrix Q_
+    assign_tentative(Q_, Q);
+}
+
+template <typename Array1,
+         typename Array2,
+         typename MatrixType,
+         typename Array3>
+void fit_candidates(const Array1& aggregates,
+                    const Array2& B,
+                    MatrixType& Q_,
+                    Array3& R,
+                    cusp::array1d_format)
+{
+    fit_candidates(aggregates, B, Q_, R);
+}
+
+template <typename Array1,
+         typename Array2,
+         typename MatrixType,
+         typename Array3>
+void fit_candidates(const Array1& aggregates,
+                    const Array2& B,
+                    MatrixType& Q_,
+                    Array3& R,
+                    cusp::array2d_format)
+{
+    typedef typename MatrixType::index_type IndexType;
+    typedef typename MatrixType::value_type ValueType;
+    typedef typename MatrixType::memory_space MemorySpace;
+
+    CUSP_PROFILE_SCOPED();
+
+    const IndexType num_rows = aggregates.size();
+    const IndexType k = B.num_cols;
+
+    IndexType num_aggregates = *thrust::max_element(aggregates.begin(), aggregates.end()) + 1;
+
+    // sort the rows by aggregate, unaggregated rows (-1) come first
+    cusp::array1d<IndexType,MemorySpace> keys(aggregates);
+    cusp::array1d<IndexType,MemorySpace> rows(num_rows);
+    thrust::sequence(rows.begin(), rows.end());
+    thrust::stable_sort_by_key(keys.begin(), keys.end(), rows.begin());
+
+    cusp::array1d<IndexType,MemorySpace> offsets(num_aggregates + 1);
+    thrust::lower_bound(keys.begin(), keys.end(),
+                        thrust::counting_iterator<IndexType>(0),
+                        thrust::counting_iterator<IndexType>(num_aggregates + 1),
+                        offsets.begin());
+
+    // coarse columns and entries of Q of each aggregate
+    cusp::array1d<IndexType,MemorySpace> col_offsets(num_aggregates + 1, IndexType(0));
+    cusp::array1d<IndexType,MemorySpace> entry_offsets(num_aggregates + 1, IndexType(0));
+    thrust::transform(offsets.begin() + 1, offsets.end(), offsets.begin(), col_offsets.begin(), aggregate_columns<IndexType>(k));
+    thrust::transform(offsets.begin() + 1, offsets.end(), offsets.begin(), entry_offsets.begin(), aggregate_entries<IndexType>(k));
+    thrust::exclusive_scan(col_offsets.begin(), col_offsets.end(), col_offsets.begin());
+    thrust::exclusive_scan(entry_offsets.begin(), entry_offsets.end(), entry_offsets.begin());
+
+    const IndexType num_coarse  = col_offsets[num_aggregates];
+    const IndexType num_entries = entry_offsets[num_aggregates];
+
+    cusp::array1d<ValueType,MemorySpace> X(num_rows * k);
+    thrust::transform(thrust::counting_iterator<IndexType>(0),
+                      thrust::counting_iterator<IndexType>(num_rows * k),
+                      X.begin(),
+                      gather_candidates<IndexType,ValueType,typename Array2::orientation>
+                          (thrust::raw_pointer_cast(rows.data()), thrust::raw_pointer_cast(B.values.data()), k, B.pitch));
+
+    cusp::coo_matrix<IndexType,ValueType,MemorySpace> Q(num_rows, num_coarse, num_entries);
+    R.resize(num_coarse, k);
+    thrust::fill(R.values.begin(), R.values.end(), ValueType(0));
+
+    const ValueType tolerance = 100 * std::numeric_limits<ValueType>::epsilon();
+
+    thrust::for_each(thrust::counting_iterator<IndexType>(0),
+                     thrust::counting_iterator<IndexType>(num_aggregates),
+                     fit_aggregate_candidates<IndexType,ValueType>
+                         (thrust::raw_pointer_cast(offsets.data()),
+                          thrust::raw_pointer_cast(col_offsets.data()),
+                          thrust::raw_pointer_cast(entry_offsets.data()),
+                          thrust::raw_pointer_cast(rows.data()),
+                          thrust::raw_pointer_cast(X.data()),
+                          thrust::raw_pointer_cast(Q.row_indices.data()),
+                          thrust::raw_pointer_cast(Q.column_indices.data()),
+                          thrust::raw_pointer_cast(Q.values.data()),
+                          thrust::raw_pointer_cast(R.values.data()),
+                          k, R.pitch, tolerance));
+
+    Q.sort_by_row_and_column();
+
+    // move/convert Q to output matrix Q_
+    assign_tentative(Q_, Q);
 }
 
 } // end namepace detail
@@ -119,7 +414,7 @@ void fit_candidates(const Array1& aggregates,
 {
   CUSP_PROFILE_SCOPED();
 
-  detail::fit_candidates(aggregates, B, Q_, R);
+  detail::fit_candidates(aggregates, B, Q_, R, typename Array2::format());
 }
 
 } // end namespace aggregation
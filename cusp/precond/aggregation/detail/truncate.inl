@@ -0,0 +1,310 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include <cusp/array1d.h>
+#include <cusp/coo_matrix.h>
+
+#include <cusp/detail/format_utils.h>
+#include <cusp/detail/spectral_radius.h>
+
+#include <thrust/binary_search.h>
+#include <thrust/fill.h>
+#include <thrust/functional.h>
+#include <thrust/gather.h>
+#include <thrust/reduce.h>
+#include <thrust/remove.h>
+#include <thrust/scatter.h>
+#include <thrust/sequence.h>
+#include <thrust/sort.h>
+#include <thrust/transform.h>
+
+#include <thrust/iterator/constant_iterator.h>
+#include <thrust/iterator/counting_iterator.h>
+#include <thrust/iterator/permutation_iterator.h>
+#include <thrust/iterator/transform_iterator.h>
+#include <thrust/iterator/zip_iterator.h>
+
+namespace cusp
+{
+namespace precond
+{
+namespace aggregation
+{
+namespace detail
+{
+
+// sums[i] = reduction of the values of row i (0 for empty rows), rows sorted
+template <typename Array1, typename Iterator, typename Array2, typename BinaryFunction>
+void reduce_rows(const Array1& rows, Iterator values, Array2& sums, BinaryFunction op)
+{
+    typedef typename Array1::value_type IndexType;
+    typedef typename Array2::value_type ValueType;
+    typedef typename Array2::memory_space MemorySpace;
+
+    cusp::array1d<IndexType,MemorySpace> keys(rows.size());
+    cusp::array1d<ValueType,MemorySpace> reduced(rows.size());
+
+    const size_t num_keys =
+        thrust::reduce_by_key(rows.begin(), rows.end(), values,
+                              keys.begin(), reduced.begin(),
+                              thrust::equal_to<IndexType>(), op).first - keys.begin();
+
+    thrust::fill(sums.begin(), sums.end(), ValueType(0));
+    thrust::scatter(reduced.begin(), reduced.begin() + num_keys, keys.begin(), sums.begin());
+}
+
+// |p_ij| >= tolerance * max_k |p_ik|, explicit zeros are dropped
+template <typename ValueType>
+struct keep_relative_entry
+{
+    ValueType tolerance;
+
+    keep_relative_entry(ValueType tolerance) : tolerance(tolerance) {}
+
+    template <typename Tuple>
+    __host__ __device__
+    int operator()(const Tuple& t) const
+    {
+        const ValueType value   = thrust::get<0>(t);
+        const ValueType row_max = thrust::get<1>(t);
+        const ValueType magnitude = value < ValueType(0) ? -value : value;
+
+        return magnitude > ValueType(0) && magnitude >= tolerance * row_max;
+    }
+};
+
+// magnitude of kept entries, -1 for dropped entries so they sort last
+template <typename ValueType>
+struct kept_magnitude
+{
+    template <typename Tuple>
+    __host__ __device__
+    ValueType operator()(const Tuple& t) const
+    {
+        const ValueType value = thrust::get<0>(t);
+        return thrust::get<1>(t) ? (value < ValueType(0) ? -value : value) : ValueType(-1);
+    }
+};
+
+// scale that restores the row sum, rows without (kept) sum are left alone
+template <typename ValueType>
+struct row_sum_scale : thrust::binary_function<ValueType,ValueType,ValueType>
+{
+    __host__ __device__
+    ValueType operator()(const ValueType sum, const ValueType kept_sum) const
+    {
+        return (sum == ValueType(0) || kept_sum == ValueType(0)) ? ValueType(1) : sum / kept_sum;
+    }
+};
+
+// off-diagonal a_ij with |a_ij| < tolerance * sqrt(|a_ii * a_jj|)
+template <typename ValueType>
+struct weak_galerkin_entry
+{
+    ValueType tolerance;
+
+    weak_galerkin_entry(ValueType tolerance) : tolerance(tolerance) {}
+
+    template <typename Tuple>
+    __host__ __device__
+    int operator()(const Tuple& t) const
+    {
+        const ValueType value = thrust::get<2>(t);
+        const ValueType a_ii  = thrust::get<3>(t);
+        const ValueType a_jj  = thrust::get<4>(t);
+        const ValueType diagonal = a_ii * a_jj;
+
+        return thrust::get<0>(t) != thrust::get<1>(t) &&
+               value * value < tolerance * tolerance * (diagonal < ValueType(0) ? -diagonal : diagonal);
+    }
+};
+
+// adds the dropped entries of each row to its diagonal
+template <typename ValueType>
+struct lump_to_diagonal
+{
+    template <typename Tuple>
+    __host__ __device__
+    ValueType operator()(const Tuple& t) const
+    {
+        return thrust::get<0>(t) == thrust::get<1>(t) ? thrust::get<2>(t) + thrust::get<3>(t) : thrust::get<2>(t);
+    }
+};
+
+template <typename MatrixType, typename ValueType>
+void truncate_prolongator(MatrixType& P,
+                          const ValueType drop_tolerance,
+                          const size_t max_entries)
+{
+    CUSP_PROFILE_SCOPED();
+
+    typedef typename MatrixType::index_type   IndexType;
+    typedef typename MatrixType::value_type   V;
+    typedef typename MatrixType::memory_space MemorySpace;
+
+    cusp::coo_matrix<IndexType,V,MemorySpace> C(P);
+
+    const size_t N = C.num_rows;
+    const size_t num_entries = C.num_entries;
+
+    if (num_entries == 0)
+        return;
+
+    cusp::array1d<V,MemorySpace> row_sums(N);
+    cusp::array1d<V,MemorySpace> row_max(N);
+    reduce_rows(C.row_indices, C.values.begin(), row_sums, thrust::plus<V>());
+    reduce_rows(C.row_indices, thrust::make_transform_iterator(C.values.begin(), cusp::detail::absolute<V>()),
+                row_max, thrust::maximum<V>());
+
+    // drop the entries below the threshold of their row
+    cusp::array1d<int,MemorySpace> keep(num_entries);
+    thrust::transform(thrust::make_zip_iterator(thrust::make_tuple(C.values.begin(), thrust::make_permutation_iterator(row_max.begin(), C.row_indices.begin()))),
+                      thrust::make_zip_iterator(thrust::make_tuple(C.values.end(),   thrust::make_permutation_iterator(row_max.begin(), C.row_indices.end()))),
+                      keep.begin(),
+                      keep_relative_entry<V>(V(drop_tolerance)));
+
+    // keep the max_entries largest entries of each row
+    if (max_entries > 0)
+    {
+        cusp::array1d<V,MemorySpace> magnitudes(num_entries);
+        thrust::transform(thrust::make_zip_iterator(thrust::make_tuple(C.values.begin(), keep.begin())),
+                          thrust::make_zip_iterator(thrust::make_tuple(C.values.end(),   keep.end())),
+                          magnitudes.begin(),
+                          kept_magnitude<V>());
+
+        // order the entries by row and by decreasing magnitude within each row
+        cusp::array1d<IndexType,MemorySpace> order(num_entries);
+        thrust::sequence(order.begin(), order.end());
+        thrust::stable_sort_by_key(magnitudes.begin(), magnitudes.end(), order.begin(), thrust::greater<V>());
+
+        cusp::array1d<IndexType,MemorySpace> rows(num_entries);
+        thrust::gather(order.begin(), order.end(), C.row_indices.begin(), rows.begin());
+        thrust::stable_sort_by_key(rows.begin(), rows.end(), order.begin());
+
+        // rank of each entry within its row
+        cusp::array1d<IndexType,MemorySpace> rank(num_entries);
+        thrust::lower_bound(rows.begin(), rows.end(), rows.begin(), rows.end(), rank.begin());
+        thrust::transform(thrust::counting_iterator<IndexType>(0), thrust::counting_iterator<IndexType>(num_entries),
+                          rank.begin(), rank.begin(), thrust::minus<IndexType>());
+
+        thrust::scatter_if(thrust::make_constant_iterator(0), thrust::make_constant_iterator(0) + num_entries,
+                           order.begin(), rank.begin(), keep.begin(),
+                           thrust::placeholders::_1 >= IndexType(max_entries));
+    }
+
+    // remove the dropped entries, the order by row is preserved
+    const size_t num_kept =
+        thrust::remove_if(thrust::make_zip_iterator(thrust::make_tuple(C.row_indices.begin(), C.column_indices.begin(), C.values.begin())),
+                          thrust::make_zip_iterator(thrust::make_tuple(C.row_indices.end(),   C.column_indices.end(),   C.values.end())),
+                          keep.begin(),
+                          thrust::logical_not<int>())
+        - thrust::make_zip_iterator(thrust::make_tuple(C.row_indices.begin(), C.column_indices.begin(), C.values.begin()));
+
+    C.resize(C.num_rows, C.num_cols, num_kept);
+
+    // rescale the kept entries to the original row sums
+    cusp::array1d<V,MemorySpace> kept_sums(N);
+    reduce_rows(C.row_indices, C.values.begin(), kept_sums, thrust::plus<V>());
+    thrust::transform(row_sums.begin(), row_sums.end(), kept_sums.begin(), row_sums.begin(), row_sum_scale<V>());
+    thrust::transform(C.values.begin(), C.values.end(),
+                      thrust::make_permutation_iterator(row_sums.begin(), C.row_indices.begin()),
+                      C.values.begin(),
+                      thrust::multiplies<V>());
+
+    P = C;
+}
+
+template <typename MatrixType, typename ValueType>
+void filter_galerkin_product(MatrixType& A,
+                             const ValueType drop_tolerance)
+{
+    CUSP_PROFILE_SCOPED();
+
+    typedef typename MatrixType::index_type   IndexType;
+    typedef typename MatrixType::value_type   V;
+    typedef typename MatrixType::memory_space MemorySpace;
+
+    cusp::coo_matrix<IndexType,V,MemorySpace> C(A);
+
+    const size_t N = C.num_rows;
+    const size_t num_entries = C.num_entries;
+
+    if (num_entries == 0)
+        return;
+
+    cusp::array1d<V,MemorySpace> diagonal(N);
+    cusp::detail::extract_diagonal(C, diagonal);
+
+    cusp::array1d<int,MemorySpace> weak(num_entries);
+    thrust::transform(thrust::make_zip_iterator(thrust::make_tuple(C.row_indices.begin(), C.column_indices.begin(), C.values.begin(),
+                                                                   thrust::make_permutation_iterator(diagonal.begin(), C.row_indices.begin()),
+                                                                   thrust::make_permutation_iterator(diagonal.begin(), C.column_indices.begin()))),
+                      thrust::make_zip_iterator(thrust::make_tuple(C.row_indices.end(), C.column_indices.end(), C.values.end(),
+                                                                   thrust::make_permutation_iterator(diagonal.begin(), C.row_indices.end()),
+                                                                   thrust::make_permutation_iterator(diagonal.begin(), C.column_indices.end()))),
+                      weak.begin(),
+                      weak_galerkin_entry<V>(V(drop_tolerance)));
+
+    // sum of the dropped entries of each row
+    cusp::array1d<V,MemorySpace> dropped(num_entries);
+    thrust::transform(weak.begin(), weak.end(), C.values.begin(), dropped.begin(), thrust::multiplies<V>());
+
+    cusp::array1d<V,MemorySpace> lumped(N);
+    reduce_rows(C.row_indices, dropped.begin(), lumped, thrust::plus<V>());
+
+    thrust::transform(thrust::make_zip_iterator(thrust::make_tuple(C.row_indices.begin(), C.column_indices.begin(), C.values.begin(),
+                                                                   thrust::make_permutation_iterator(lumped.begin(), C.row_indices.begin()))),
+                      thrust::make_zip_iterator(thrust::make_tuple(C.row_indices.end(), C.column_indices.end(), C.values.end(),
+                                                                   thrust::make_permutation_iterator(lumped.begin(), C.row_indices.end()))),
+                      C.values.begin(),
+                      lump_to_diagonal<V>());
+
+    const size_t num_kept =
+        thrust::remove_if(thrust::make_zip_iterator(thrust::make_tuple(C.row_indices.begin(), C.column_indices.begin(), C.values.begin())),
+                          thrust::make_zip_iterator(thrust::make_tuple(C.row_indices.end(),   C.column_indices.end(),   C.values.end())),
+                          weak.begin(),
+                          thrust::identity<int>())
+        - thrust::make_zip_iterator(thrust::make_tuple(C.row_indices.begin(), C.column_indices.begin(), C.values.begin()));
+
+    C.resize(C.num_rows, C.num_cols, num_kept);
+
+    A = C;
+}
+
+} // end namespace detail
+
+template <typename MatrixType, typename ValueType>
+void truncate_prolongator(MatrixType& P,
+                          const ValueType drop_tolerance,
+                          const size_t max_entries)
+{
+    CUSP_PROFILE_SCOPED();
+
+    detail::truncate_prolongator(P, drop_tolerance, max_entries);
+}
+
+template <typename MatrixType, typename ValueType>
+void filter_galerkin_product(MatrixType& A,
+                             const ValueType drop_tolerance)
+{
+    CUSP_PROFILE_SCOPED();
+
+    detail::filter_galerkin_product(A, drop_tolerance);
+}
+
+} // end namespace aggregation
+} // end namespace precond
+} // end namespace cusp
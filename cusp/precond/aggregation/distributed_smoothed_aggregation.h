@@ -0,0 +1,223 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+/*! \file distributed_smoothed_aggregation.h
+ *  \brief Smoothed aggregation hierarchy distributed across several devices.
+ */
+
+#pragma once
+
+#include <cusp/detail/config.h>
+
+#include <cusp/csr_matrix.h>
+#include <cusp/hyb_matrix.h>
+#include <cusp/linear_operator.h>
+#include <cusp/distributed_array1d.h>
+#include <cusp/distributed_matrix.h>
+
+#include <cusp/detail/lu.h>
+
+#include <cusp/precond/aggregation/smoothed_aggregation_options.h>
+
+#include <vector>
+
+namespace cusp
+{
+namespace precond
+{
+namespace aggregation
+{
+
+/*! \addtogroup preconditioners Preconditioners
+ *  \ingroup preconditioners
+ *  \{
+ */
+
+/*! \p distributed_smoothed_aggregation : smoothed aggregation preconditioner
+ *  for a \p distributed_matrix
+ *
+ *  The hierarchy is built on the host and its operators are stored as
+ *  \p distributed_matrix objects, so a V-cycle applies the same halo
+ *  exchange as the products of the Krylov solver.
+ *
+ *  Aggregation is decoupled: the strength of connection matrix of each
+ *  level is restricted to the diagonal block of every part and the parts
+ *  are aggregated independently, so no aggregate crosses a part boundary.
+ *  The couplings between the parts are kept by the smoothed prolongator and
+ *  the Galerkin product, whose off-part entries are exchanged as halos.
+ *  The aggregates of part \c p form part \c p of the next level.
+ *
+ *  Once the mean number of rows per part of a level drops below
+ *  \c min_part_size, pairs of neighbouring parts are merged onto the device
+ *  of the first one, and the vectors of the cycle are redistributed between
+ *  the two layouts.  The coarsest level is collected on a single device and
+ *  solved with a dense inverse.  The levels are smoothed with weighted
+ *  Jacobi.
+ *
+ *  \tparam IndexType Type used for matrix indices (e.g. \c int).
+ *  \tparam ValueType Type used for matrix values (e.g. \c float).
+ *
+ *  The following code snippet demonstrates how to precondition \p cg on
+ *  four devices.
+ *
+ *  \code
+ *  #include <cusp/distributed_matrix.h>
+ *  #include <cusp/krylov/cg.h>
+ *  #include <cusp/precond/aggregation/distributed_smoothed_aggregation.h>
+ *  #include <cusp/gallery/poisson.h>
+ *  ...
+ *
+ *  cusp::csr_matrix<int,double,cusp::host_memory> A;
+ *  cusp::gallery::poisson5pt(A, 1000, 1000);
+ *
+ *  std::vector<int> devices;
+ *  for (int d = 0; d < 4; d++)
+ *      devices.push_back(d);
+ *
+ *  cusp::distributed_matrix< cusp::hyb_matrix<int,double,cusp::device_memory> > d_A(A, devices);
+ *  cusp::precond::aggregation::distributed_smoothed_aggregation<int,double> M(A, d_A.layout);
+ *
+ *  cusp::distributed_array1d<double> x(d_A.layout, 0.0);
+ *  cusp::distributed_array1d<double> b(d_A.layout, 1.0);
+ *
+ *  cusp::default_monitor<double> monitor(b, 100, 1e-8);
+ *  cusp::krylov::cg(d_A, x, b, monitor, M);
+ *  \endcode
+ */
+template <typename IndexType, typename ValueType>
+class distributed_smoothed_aggregation
+  : public cusp::linear_operator<ValueType,cusp::device_memory,IndexType>
+{
+    typedef cusp::linear_operator<ValueType,cusp::device_memory,IndexType> Parent;
+
+    public:
+    typedef cusp::csr_matrix<IndexType,ValueType,cusp::host_memory>   SetupMatrixType;
+    typedef cusp::hyb_matrix<IndexType,ValueType,cusp::device_memory> SolveMatrixType;
+    typedef cusp::distributed_array1d<ValueType>                      Array;
+
+    typedef smoothed_aggregation_options<IndexType,ValueType,cusp::host_memory> Options;
+
+    struct level
+    {
+        cusp::distributed_matrix<SolveMatrixType> A;
+        cusp::distributed_matrix<SolveMatrixType> P;   // empty on the coarsest level
+        cusp::distributed_matrix<SolveMatrixType> R;   // empty on the coarsest level
+
+        Array diagonal;          // diagonal of A for the Jacobi smoother
+        ValueType omega;         // weight of the Jacobi smoother
+
+        Array x;                 // solution
+        Array b;                 // right-hand side
+        Array residual;
+        Array temp;
+
+        // coarse vectors in the layout induced by the aggregates of this
+        // level, used when the next level merges parts
+        bool redistribute;
+        Array coarse_b;
+        Array coarse_x;
+
+        // coarsest level
+        level(const SetupMatrixType& A_,
+              const cusp::distributed_layout& layout);
+
+        level(const SetupMatrixType& A_,
+              const SetupMatrixType& P_,
+              const SetupMatrixType& R_,
+              const cusp::distributed_layout& layout,
+              const cusp::distributed_layout& coarse_layout,
+              const cusp::distributed_layout& next_layout,
+              const cusp::array1d<ValueType,cusp::host_memory>& diagonal_,
+              ValueType omega);
+    };
+
+    /*! Build the hierarchy for a matrix distributed in parts of equal
+     *  numbers of rows on the given devices.
+     *
+     *  \param A Square matrix on the host or device.
+     *  \param devices Device of each part of the finest level.
+     */
+    template <typename MatrixType>
+    distributed_smoothed_aggregation(const MatrixType& A, const std::vector<int>& devices);
+
+    /*! Build the hierarchy for a matrix distributed according to \p layout,
+     *  typically the layout of the \p distributed_matrix being solved.
+     *
+     *  \param A Square matrix on the host or device.
+     *  \param layout Partition of the rows of the finest level.
+     *  \param sa_options Parameters of the setup.
+     *  \param min_part_size Mean number of rows per part below which
+     *         neighbouring parts are merged.
+     */
+    template <typename MatrixType>
+    distributed_smoothed_aggregation(const MatrixType& A,
+                                     const cusp::distributed_layout& layout,
+                                     const Options& sa_options = Options(),
+                                     size_t min_part_size = 4096);
+
+    ~distributed_smoothed_aggregation(void);
+
+    /*! Apply one V-cycle to \p b with a zero initial guess.
+     */
+    void operator()(const Array& b, Array& x);
+
+    /*! Number of levels of the hierarchy.
+     */
+    size_t num_levels(void) const { return levels.size(); }
+
+    /*! Layout of the vectors of level \p lvl.
+     */
+    const cusp::distributed_layout& layout(size_t lvl) const { return levels[lvl]->A.layout; }
+
+    /*! Number of rows of level \p lvl.
+     */
+    size_t level_size(size_t lvl) const { return levels[lvl]->A.num_rows; }
+
+    /*! Sum of the nonzeros of all levels relative to the finest level.
+     */
+    double operator_complexity(void) const;
+
+    private:
+    std::vector<level*> levels;
+
+    // dense inverse of the coarsest level on a single device
+    int coarse_device;
+    cusp::detail::dense_inverse_solver<ValueType,cusp::device_memory> * solver;
+    Array coarse_b;
+    Array coarse_x;
+
+    template <typename MatrixType>
+    void initialize(const MatrixType& A,
+                    const cusp::distributed_layout& layout,
+                    const Options& sa_options,
+                    size_t min_part_size);
+
+    void presmooth(level& L, const Array& b, Array& x);
+    void postsmooth(level& L, const Array& b, Array& x);
+    void coarse_solve(const Array& b, Array& x);
+    void cycle(const Array& b, Array& x, const size_t i);
+
+    // not copyable
+    distributed_smoothed_aggregation(const distributed_smoothed_aggregation&);
+    distributed_smoothed_aggregation& operator=(const distributed_smoothed_aggregation&);
+};
+/*! \}
+ */
+
+} // end namespace aggregation
+} // end namespace precond
+} // end namespace cusp
+
+#include <cusp/precond/aggregation/detail/distributed_smoothed_aggregation.inl>
@@ -0,0 +1,202 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*! \file mpi_smoothed_aggregation.h
+ *  \brief Smoothed aggregation hierarchy distributed across MPI processes.
+ */
+
+#pragma once
+
+#include <cusp/detail/config.h>
+
+#include <cusp/csr_matrix.h>
+#include <cusp/hyb_matrix.h>
+#include <cusp/linear_operator.h>
+#include <cusp/mpi_array1d.h>
+#include <cusp/mpi_matrix.h>
+
+#include <cusp/detail/lu.h>
+
+#include <cusp/precond/aggregation/smoothed_aggregation_options.h>
+
+#include <vector>
+
+namespace cusp
+{
+namespace precond
+{
+namespace aggregation
+{
+
+/*! \addtogroup preconditioners Preconditioners
+ *  \ingroup preconditioners
+ *  \{
+ */
+
+/*! \p mpi_smoothed_aggregation : smoothed aggregation preconditioner
+ *  for an \p mpi_matrix
+ *
+ *  Every process builds its share of the hierarchy from its own rows.
+ *  Aggregation is decoupled: each process aggregates the diagonal block
+ *  of its rows, so no aggregate crosses a process boundary, and its
+ *  aggregates form its rows of the next level.  The tentative prolongator
+ *  is also smoothed with the diagonal block, which keeps the prolongator
+ *  and the restriction local to every process: a V-cycle only
+ *  communicates in the products with the level operators, which are
+ *  \p mpi_matrix objects.  The coarse operator <tt>R * A * P</tt> keeps
+ *  the couplings between the processes; forming it fetches the rows of
+ *  the prolongator belonging to the ghost columns of each process.
+ *
+ *  The coarsest level is gathered on every process and solved redundantly
+ *  with a dense inverse.  The levels are smoothed with weighted Jacobi,
+ *  whose weight uses a Gershgorin bound of the spectral radius of
+ *  <tt>D^-1 A</tt> over all processes.
+ *
+ *  \tparam IndexType Type used for matrix indices (e.g. \c int).
+ *  \tparam ValueType Type used for matrix values (e.g. \c float).
+ *
+ *  \note The constructor and the V-cycle are collective over the
+ *        communicator of the layout.  Requires \c __CUSP_USE_MPI__.
+ *
+ *  The following code snippet demonstrates how to precondition \p cg on
+ *  the processes of \c MPI_COMM_WORLD.
+ *
+ *  \code
+ *  #include <cusp/mpi_matrix.h>
+ *  #include <cusp/krylov/cg.h>
+ *  #include <cusp/precond/aggregation/mpi_smoothed_aggregation.h>
+ *  ...
+ *
+ *  cusp::mpi_layout layout = cusp::mpi_uniform_layout(MPI_COMM_WORLD, N);
+ *
+ *  // local rows with global column indices
+ *  cusp::csr_matrix<int,double,cusp::host_memory> A_local = ...;
+ *
+ *  cusp::mpi_matrix< cusp::hyb_matrix<int,double,cusp::device_memory> > A(A_local, layout);
+ *  cusp::precond::aggregation::mpi_smoothed_aggregation<int,double> M(A_local, layout);
+ *
+ *  cusp::mpi_array1d<double> x(layout, 0.0);
+ *  cusp::mpi_array1d<double> b(layout, 1.0);
+ *
+ *  cusp::default_monitor<double> monitor(b, 100, 1e-8);
+ *  cusp::krylov::cg(A, x, b, monitor, M);
+ *  \endcode
+ */
+template <typename IndexType, typename ValueType>
+class mpi_smoothed_aggregation
+  : public cusp::linear_operator<ValueType,cusp::device_memory,IndexType>
+{
+    typedef cusp::linear_operator<ValueType,cusp::device_memory,IndexType> Parent;
+
+    public:
+    typedef cusp::csr_matrix<IndexType,ValueType,cusp::host_memory>   SetupMatrixType;
+    typedef cusp::hyb_matrix<IndexType,ValueType,cusp::device_memory> SolveMatrixType;
+    typedef cusp::mpi_array1d<ValueType>                              Array;
+
+    typedef smoothed_aggregation_options<IndexType,ValueType,cusp::host_memory> Options;
+
+    struct level
+    {
+        cusp::mpi_matrix<SolveMatrixType> A;
+        SolveMatrixType P;       // local rows to local aggregates, empty on the coarsest level
+        SolveMatrixType R;       // transpose of P
+
+        cusp::array1d<ValueType,cusp::device_memory> diagonal;   // of the local rows of A
+        ValueType omega;         // weight of the Jacobi smoother
+
+        Array x;                 // solution
+        Array b;                 // right-hand side
+        Array residual;
+        Array temp;
+
+        // coarsest level
+        level(const SetupMatrixType& A_local,
+              const cusp::mpi_layout& layout);
+
+        level(const SetupMatrixType& A_local,
+              const SetupMatrixType& P_,
+              const SetupMatrixType& R_,
+              const cusp::mpi_layout& layout,
+              const cusp::array1d<ValueType,cusp::host_memory>& diagonal_,
+              ValueType omega);
+    };
+
+    /*! Build the hierarchy from the rows of this process.  Collective.
+     *
+     *  \param local_rows Rows <tt>[layout.first_row(), layout.first_row() +
+     *         layout.local_size())</tt> of a square matrix, with global
+     *         column indices, on the host or device.
+     *  \param layout Partition of the rows of the finest level, typically
+     *         the layout of the \p mpi_matrix being solved.
+     *  \param sa_options Parameters of the setup.
+     */
+    template <typename MatrixType>
+    mpi_smoothed_aggregation(const MatrixType& local_rows,
+                             const cusp::mpi_layout& layout,
+                             const Options& sa_options = Options());
+
+    ~mpi_smoothed_aggregation(void);
+
+    /*! Apply one V-cycle to \p b with a zero initial guess.  Collective.
+     */
+    void operator()(const Array& b, Array& x);
+
+    /*! Number of levels of the hierarchy.
+     */
+    size_t num_levels(void) const { return levels.size(); }
+
+    /*! Layout of the vectors of level \p lvl.
+     */
+    const cusp::mpi_layout& layout(size_t lvl) const { return levels[lvl]->A.layout; }
+
+    /*! Number of rows of level \p lvl over all processes.
+     */
+    size_t level_size(size_t lvl) const { return levels[lvl]->A.num_rows; }
+
+    /*! Sum of the nonzeros of all levels relative to the finest level.
+     */
+    double operator_complexity(void) const;
+
+    private:
+    std::vector<level*> levels;
+
+    // dense inverse of the coarsest level, gathered on every process
+    cusp::detail::dense_inverse_solver<ValueType,cusp::device_memory> * solver;
+    cusp::array1d<ValueType,cusp::device_memory> coarse_b;
+    cusp::array1d<ValueType,cusp::device_memory> coarse_x;
+
+    template <typename MatrixType>
+    void initialize(const MatrixType& local_rows,
+                    const cusp::mpi_layout& layout,
+                    const Options& sa_options);
+
+    void presmooth(level& L, const Array& b, Array& x);
+    void postsmooth(level& L, const Array& b, Array& x);
+    void coarse_solve(const Array& b, Array& x);
+    void cycle(const Array& b, Array& x, const size_t i);
+
+    // not copyable
+    mpi_smoothed_aggregation(const mpi_smoothed_aggregation&);
+    mpi_smoothed_aggregation& operator=(const mpi_smoothed_aggregation&);
+};
+/*! \}
+ */
+
+} // end namespace aggregation
+} // end namespace precond
+} // end namespace cusp
+
+#include <cusp/precond/aggregation/detail/mpi_smoothed_aggregation.inl>
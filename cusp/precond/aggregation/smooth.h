@@ -35,6 +35,28 @@ void smooth_prolongator(const MatrixType& S,
                         const ValueType omega,
                         const ValueType rho_Dinv_S);
 
+//   Filtered matrix A_F of the strength of connection matrix C of A: the
+//   strong entries of A (those kept in C) with the weak entries of each
+//   row added to its diagonal, so A_F has the row sums of A.  C holds the
+//   values of A and includes the diagonal.
+template <typename MatrixType>
+void filtered_matrix(const MatrixType& A,
+                     const MatrixType& C,
+                     MatrixType& A_F);
+
+//   Energy minimizing prolongator: starting from P = T, a fixed number of
+//   Jacobi preconditioned CG iterations reduce trace(P^T A P) over the
+//   matrices with the sparsity pattern of A * T while keeping
+//   P * B_coarse equal to T * B_coarse, i.e. the fine near-nullspace
+//   candidates stay in the range of P.  B_coarse holds at most 8
+//   candidates (columns).
+template <typename MatrixType, typename Array2>
+void energy_minimization_prolongator(const MatrixType& A,
+                                     const MatrixType& T,
+                                     const Array2& B_coarse,
+                                     MatrixType& P,
+                                     const size_t iterations = 4);
+
 } // end namespace aggregation
 } // end namespace precond
 } // end namespace cusp
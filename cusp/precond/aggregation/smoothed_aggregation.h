@@ -26,16 +26,19 @@
 #include <vector> // TODO replace with host_vector
 #include <cusp/linear_operator.h>
 
+#include <cusp/array2d.h>
 #include <cusp/coo_matrix.h>
 #include <cusp/csr_matrix.h>
 #include <cusp/hyb_matrix.h>
 #include <cusp/multilevel.h>
+#include <cusp/tiled_csr_operator.h>
 
 #include <cusp/precond/aggregation/smoothed_aggregation_options.h>
 
 #include <cusp/relaxation/jacobi.h>
 
 #include <cusp/detail/spectral_radius.h>
+#include <cusp/detail/timer.h>
 
 namespace cusp
 {
@@ -49,6 +52,25 @@ namespace aggregation
  *  \{
  */
 
+// time in milliseconds spent in each stage of the setup of one level
+struct sa_level_timings
+{
+    double strength;       // strength of connection
+    double aggregate;      // aggregation
+    double tentative;      // tentative prolongator and coarse candidates
+    double smooth;         // prolongator smoothing
+    double restriction;    // restriction operator
+    double galerkin;       // Galerkin product R * A * P
+
+    sa_level_timings()
+      : strength(0), aggregate(0), tentative(0), smooth(0), restriction(0), galerkin(0) {}
+
+    double total(void) const
+    {
+        return strength + aggregate + tentative + smooth + restriction + galerkin;
+    }
+};
+
 template<typename MatrixType>
 struct sa_level
 {
@@ -58,38 +80,65 @@ struct sa_level
 
     MatrixType A_; 					                              // matrix
     cusp::array1d<IndexType,MemorySpace> aggregates;      // aggregates
-    cusp::array1d<ValueType,MemorySpace> B;               // near-nullspace candidates
+    cusp::array2d<ValueType,MemorySpace,cusp::column_major> B; // near-nullspace candidates, one per column
+
+    ValueType rho_DinvA;                                  // spectral radius of D^-1 A, estimated once by
+                                                          // smooth_prolongator and reused by the smoother
 
-    ValueType rho_DinvA;
+    sa_level_timings timings;                             // setup time of each stage
 
     sa_level() : rho_DinvA(0) {}
 
     template<typename SA_Level_Type>
     sa_level(const SA_Level_Type& sa_level)
-      : A_(sa_level.A_), aggregates(sa_level.aggregates), B(sa_level.B), rho_DinvA(sa_level.rho_DinvA) {}
+      : A_(sa_level.A_), aggregates(sa_level.aggregates), B(sa_level.B), rho_DinvA(sa_level.rho_DinvA),
+        timings(sa_level.timings) {}
 };
 
 
 /*! \p smoothed_aggregation : algebraic multigrid preconditoner based on
  *  smoothed aggregation
  *
+ *  The hierarchy is built in \c ValueType and the vectors of the cycle are
+ *  of type \c ValueType.  The operators of the solve phase store their
+ *  values in \c SolveValueType, so a \c float \c SolveValueType with a
+ *  \c double \c ValueType applies single precision operators with double
+ *  precision accumulation.
+ *
+ *  The near-nullspace candidates default to the constant vector.  Systems
+ *  with several near-nullspace modes, such as the six rigid body modes of
+ *  3D elasticity, pass them as the columns of a \c column_major
+ *  \p array2d; every aggregate then has one coarse degree of freedom per
+ *  candidate (fewer if it has fewer rows than candidates) and the
+ *  tentative prolongator is block structured.
+ *
+ *  On the device the finest level is applied by a \p tiled_csr_operator
+ *  when the COO part of its \p hyb_matrix holds more than a tenth of the
+ *  entries, i.e. when the row lengths vary too much for the ELL part.
+ *  The HYB matrix of the level is kept for the smoothers and the copies.
  */
 template <typename IndexType, typename ValueType, typename MemorySpace,
 	  typename SmootherType = cusp::relaxation::jacobi<ValueType,MemorySpace>,
-	  typename SolverType = cusp::detail::lu_solver<ValueType,cusp::host_memory> >
+	  typename SolverType = cusp::detail::dense_inverse_solver<ValueType,MemorySpace>,
+	  typename SolveValueType = ValueType>
 class smoothed_aggregation :
-  public cusp::multilevel< typename amg_container<IndexType,ValueType,MemorySpace>::solve_type, SmootherType, SolverType>
+  public cusp::multilevel< typename amg_container<IndexType,ValueType,MemorySpace,SolveValueType>::solve_type, SmootherType, SolverType, ValueType>
 {
 
-    typedef typename amg_container<IndexType,ValueType,MemorySpace>::setup_type SetupMatrixType;
-    typedef typename amg_container<IndexType,ValueType,MemorySpace>::solve_type SolveMatrixType;
-    typedef typename cusp::multilevel<SolveMatrixType,SmootherType,SolverType> Parent;
+    typedef typename amg_container<IndexType,ValueType,MemorySpace,SolveValueType>::setup_type SetupMatrixType;
+    typedef typename amg_container<IndexType,ValueType,MemorySpace,SolveValueType>::solve_type SolveMatrixType;
+    typedef typename cusp::multilevel<SolveMatrixType,SmootherType,SolverType,ValueType> Parent;
 
 public:
 
+    // the solve phase, e.g. for cusp::io::read_hierarchy
+    typedef Parent hierarchy_type;
+
     const smoothed_aggregation_options<IndexType,ValueType,MemorySpace> & sa_options;
     const smoothed_aggregation_options<IndexType,ValueType,MemorySpace> default_sa_options;
     std::vector< sa_level<SetupMatrixType> > sa_levels;
+    bool solve_only;          // release the setup copies of the level operators
+    bool tiled_fine;          // the finest level is applied by a tiled_csr_operator
 
     template <typename MatrixType>
     smoothed_aggregation(const MatrixType& A);
@@ -105,8 +154,48 @@ public:
     smoothed_aggregation(const MatrixType& A, const cusp::array1d<ValueType,MemorySpace>& B,
                          const Options& sa_options);
 
-    template <typename MemorySpace2,typename SmootherType2,typename SolverType2>
-    smoothed_aggregation(const smoothed_aggregation<IndexType,ValueType,MemorySpace2,SmootherType2,SolverType2>& M);
+    template <typename MatrixType>
+    smoothed_aggregation(const MatrixType& A, const cusp::array2d<ValueType,MemorySpace,cusp::column_major>& B);
+
+    template <typename MatrixType, typename Options>
+    smoothed_aggregation(const MatrixType& A, const cusp::array2d<ValueType,MemorySpace,cusp::column_major>& B,
+                         const Options& sa_options);
+
+    template <typename MemorySpace2,typename SmootherType2,typename SolverType2,typename SolveValueType2>
+    smoothed_aggregation(const smoothed_aggregation<IndexType,ValueType,MemorySpace2,SmootherType2,SolverType2,SolveValueType2>& M);
+
+    /*! Rebuild the hierarchy for a matrix with the same sparsity pattern
+     *  as the one it was constructed from, e.g. after the values change
+     *  between Newton iterations or time steps.  The aggregates and the
+     *  near-nullspace candidates of every level are kept; only the
+     *  prolongators, restrictions, coarse operators, smoothers and the
+     *  coarse solver are recomputed.
+     *
+     *  \param A matrix with the same dimensions and pattern as the original
+     */
+    template <typename MatrixType>
+    void resetup(const MatrixType& A);
+
+    /*! Release the setup-phase copy (\c sa_levels[i].A_) of every level
+     *  operator once the hierarchy is built, so that each operator is
+     *  stored only once, in the solve format.  The aggregates and the
+     *  near-nullspace candidates are kept, so \p resetup still works and
+     *  releases the copies again afterwards.  Combine with
+     *  \p set_implicit_restriction to release the restriction operators
+     *  as well.
+     *
+     *  \param enable whether the setup copies are released
+     */
+    void set_solve_only(bool enable);
+
+    /*! Write the setup time of each stage of every level (see
+     *  \p sa_level_timings) followed by the solve phase profile of
+     *  \p multilevel::write_profile as one JSON object.  Enable
+     *  \p set_profiling before the cycles to record the solve phase.
+     *
+     *  \param os output stream
+     */
+    void write_profile(std::ostream& os) const;
 
 protected:
 
@@ -114,6 +203,13 @@ protected:
     void sa_initialize(const MatrixType& A, const ArrayType& B);
 
     void extend_hierarchy(void);
+
+    // operators of level lvl + 1, C is the strength of connection matrix
+    // of level lvl when the prolongator is filtered and empty otherwise
+    void setup_level(const size_t lvl, const SetupMatrixType& C);
+
+    // apply the finest level with a tiled_csr_operator of its matrix
+    void set_tiled_fine_operator(void);
 };
 /*! \}
  */
@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include <cusp/array2d.h>
 #include <cusp/coo_matrix.h>
 #include <cusp/csr_matrix.h>
 #include <cusp/hyb_matrix.h>
@@ -24,11 +25,14 @@
 
 #include <cusp/krylov/arnoldi.h>
 
+#include <cusp/detail/spectral_radius.h>
+
 #include <cusp/precond/diagonal.h>
 #include <cusp/precond/aggregation/aggregate.h>
 #include <cusp/precond/aggregation/smooth.h>
 #include <cusp/precond/aggregation/strength.h>
 #include <cusp/precond/aggregation/tentative.h>
+#include <cusp/precond/aggregation/truncate.h>
 
 namespace cusp
 {
@@ -68,23 +72,51 @@ double estimate_rho_Dinv_A(const MatrixType& A)
 
 } // end namespace detail
 
-template <typename IndexType, typename ValueType, typename MemorySpace>
+// SolveValueType is the type stored in the operators of the solve phase,
+// e.g. float operators applied to double vectors to halve the traffic of
+// every SpMV of the cycle while the setup stays in ValueType
+template <typename IndexType, typename ValueType, typename MemorySpace, typename SolveValueType = ValueType>
 struct amg_container {};
 
-template <typename IndexType, typename ValueType>
-struct amg_container<IndexType,ValueType,cusp::host_memory>
+template <typename IndexType, typename ValueType, typename SolveValueType>
+struct amg_container<IndexType,ValueType,cusp::host_memory,SolveValueType>
 {
     // use CSR on host
     typedef typename cusp::csr_matrix<IndexType,ValueType,cusp::host_memory> setup_type;
-    typedef typename cusp::csr_matrix<IndexType,ValueType,cusp::host_memory> solve_type;
+    typedef typename cusp::csr_matrix<IndexType,SolveValueType,cusp::host_memory> solve_type;
 };
 
-template <typename IndexType, typename ValueType>
-struct amg_container<IndexType,ValueType,cusp::device_memory>
+template <typename IndexType, typename ValueType, typename SolveValueType>
+struct amg_container<IndexType,ValueType,cusp::device_memory,SolveValueType>
 {
     // use COO on device
     typedef typename cusp::coo_matrix<IndexType,ValueType,cusp::device_memory> setup_type;
-    typedef typename cusp::hyb_matrix<IndexType,ValueType,cusp::device_memory> solve_type;
+    typedef typename cusp::hyb_matrix<IndexType,SolveValueType,cusp::device_memory> solve_type;
+};
+
+// strength of connection measure, theta is the threshold of each measure
+enum strength_measure
+{
+    SYMMETRIC_STRENGTH,          // |a_ij| >= theta sqrt(|a_ii a_jj|)
+    EVOLUTION_STRENGTH,          // evolution measure, theta >= 1 (e.g. 2)
+    ALGEBRAIC_DISTANCE_STRENGTH  // algebraic distance of relaxed random vectors, theta >= 1 (e.g. 2)
+};
+
+// smoothing of the tentative prolongator
+enum prolongation_smoother
+{
+    JACOBI_PROLONGATION,           // one damped Jacobi step with A
+    FILTERED_JACOBI_PROLONGATION,  // one damped Jacobi step with the filtered matrix of C
+    ENERGY_MINIMIZATION            // CG iterations on trace(P^T A P) in the pattern of A * T
+};
+
+// estimate of the spectral radius of D^-1 A on each level, computed once
+// per level and shared by the prolongation smoothing and the smoother
+enum spectral_radius_estimate
+{
+    RITZ_SPECTRAL_RADIUS,   // largest Ritz value of 8 Arnoldi steps, Hessenberg matrix on the host
+    POWER_SPECTRAL_RADIUS,  // 15 steps of power iteration, SpMVs and reductions only
+    DISKS_SPECTRAL_RADIUS   // Gershgorin bound max_i sum_j |a_ij| / |a_ii|, a few reductions
 };
 
 template<typename IndexType, typename ValueType, typename MemorySpace>
@@ -95,20 +127,73 @@ public:
     typedef typename amg_container<IndexType,ValueType,MemorySpace>::setup_type MatrixType;
     typedef cusp::array1d<IndexType,MemorySpace> IndexArray;
     typedef cusp::array1d<ValueType,MemorySpace> ValueArray;
+    typedef cusp::array2d<ValueType,MemorySpace,cusp::column_major> CandidateArray;
 
     const ValueType theta;
     const ValueType omega;
     const size_t min_level_size;
     const size_t max_levels;
+    const size_t aggressive_levels;  // levels from the finest on that coarsen aggressively
+    const size_t aggressive_passes;  // aggregation passes of an aggressive level
+
+    // operator complexity controls, 0 disables each of them
+    const ValueType prolongator_drop_tolerance;  // drop |p_ij| below this fraction of the row maximum
+    const size_t prolongator_max_entries;        // keep at most this many entries per row of P
+    const ValueType galerkin_drop_tolerance;     // lump weak entries of R*A*P into the diagonal
+
+    const prolongation_smoother prolongation;    // smoothing of the tentative prolongator
+    const size_t energy_iterations;              // iterations of ENERGY_MINIMIZATION
+
+    const strength_measure strength;             // measure of strength_of_connection
+
+    const spectral_radius_estimate spectral_radius;  // estimate of rho(D^-1 A)
 
     smoothed_aggregation_options(const ValueType theta = 0.0, const ValueType omega = 4.0/3.0,
-                                 const size_t coarse_grid_size = 100, const size_t max_levels = 20)
-        : theta(theta), omega(omega), min_level_size(coarse_grid_size), max_levels(max_levels)
+                                 const size_t coarse_grid_size = 100, const size_t max_levels = 20,
+                                 const size_t aggressive_levels = 0, const size_t aggressive_passes = 2,
+                                 const ValueType prolongator_drop_tolerance = 0.0,
+                                 const size_t prolongator_max_entries = 0,
+                                 const ValueType galerkin_drop_tolerance = 0.0,
+                                 const prolongation_smoother prolongation = JACOBI_PROLONGATION,
+                                 const size_t energy_iterations = 4,
+                                 const strength_measure strength = SYMMETRIC_STRENGTH,
+                                 const spectral_radius_estimate spectral_radius = RITZ_SPECTRAL_RADIUS)
+        : theta(theta), omega(omega), min_level_size(coarse_grid_size), max_levels(max_levels),
+          aggressive_levels(aggressive_levels), aggressive_passes(aggressive_passes),
+          prolongator_drop_tolerance(prolongator_drop_tolerance),
+          prolongator_max_entries(prolongator_max_entries),
+          galerkin_drop_tolerance(galerkin_drop_tolerance),
+          prolongation(prolongation), energy_iterations(energy_iterations),
+          strength(strength), spectral_radius(spectral_radius)
     {}
 
+    // spectral radius of diag(A)^-1 * A with the estimate selected by spectral_radius
+    virtual ValueType estimate_rho_Dinv_A(const MatrixType& A) const
+    {
+        switch (spectral_radius)
+        {
+            case POWER_SPECTRAL_RADIUS:
+                return cusp::detail::estimate_spectral_radius_Dinv_A(A);
+            case DISKS_SPECTRAL_RADIUS:
+                return cusp::detail::disks_spectral_radius_Dinv_A(A);
+            default:
+                return detail::estimate_rho_Dinv_A(A);
+        }
+    }
+
     virtual void strength_of_connection(const MatrixType& A, MatrixType& C) const
     {
-        cusp::precond::aggregation::symmetric_strength_of_connection(A, C, theta);
+        switch (strength)
+        {
+            case EVOLUTION_STRENGTH:
+                cusp::precond::aggregation::evolution_strength_of_connection(A, C, theta);
+                break;
+            case ALGEBRAIC_DISTANCE_STRENGTH:
+                cusp::precond::aggregation::algebraic_distance_strength_of_connection(A, C, theta);
+                break;
+            default:
+                cusp::precond::aggregation::symmetric_strength_of_connection(A, C, theta);
+        }
     }
 
     virtual void aggregate(const MatrixType& C, IndexArray& aggregates) const
@@ -116,17 +201,79 @@ public:
         cusp::precond::aggregation::standard_aggregation(C, aggregates);
     }
 
+    // aggregates of level lvl, the first aggressive_levels levels merge
+    // the aggregates of several passes to skip levels
+    virtual void aggregate(const MatrixType& C, IndexArray& aggregates, const size_t lvl) const
+    {
+        if (lvl < aggressive_levels && aggressive_passes > 1)
+            cusp::precond::aggregation::aggressive_aggregation(C, aggregates, aggressive_passes);
+        else
+            aggregate(C, aggregates);
+    }
+
     virtual void fit_candidates(const IndexArray& aggregates, const ValueArray& B, MatrixType& T, ValueArray& B_coarse) const
     {
         cusp::precond::aggregation::fit_candidates(aggregates, B, T, B_coarse);
     }
 
+    // several candidates, a single one goes through the overload above
+    virtual void fit_candidates(const IndexArray& aggregates, const CandidateArray& B, MatrixType& T, CandidateArray& B_coarse) const
+    {
+        if (B.num_cols == 1)
+        {
+            ValueArray b(B.values.begin(), B.values.begin() + B.num_rows);
+            ValueArray b_coarse;
+            fit_candidates(aggregates, b, T, b_coarse);
+
+            B_coarse.resize(b_coarse.size(), 1);
+            thrust::copy(b_coarse.begin(), b_coarse.end(), B_coarse.values.begin());
+        }
+        else
+        {
+            cusp::precond::aggregation::fit_candidates(aggregates, B, T, B_coarse);
+        }
+    }
+
     virtual void smooth_prolongator(const MatrixType& A, const MatrixType& T, MatrixType& P, ValueType& rho_DinvA) const
     {
         // compute spectral radius of diag(C)^-1 * C
-        rho_DinvA = detail::estimate_rho_Dinv_A(A);
+        rho_DinvA = estimate_rho_Dinv_A(A);
 
         cusp::precond::aggregation::smooth_prolongator(A, T, P, omega, rho_DinvA);
+
+        if (prolongator_drop_tolerance > 0 || prolongator_max_entries > 0)
+            cusp::precond::aggregation::truncate_prolongator(P, prolongator_drop_tolerance, prolongator_max_entries);
+    }
+
+    // smoothing selected by prolongation, C is the strength of connection
+    // matrix of A (only formed for FILTERED_JACOBI_PROLONGATION) and
+    // B_coarse the coarse candidates.  rho_DinvA is the spectral radius
+    // of D^-1 A for the smoother of the level in every case.
+    virtual void smooth_prolongator(const MatrixType& A, const MatrixType& C, const MatrixType& T,
+                                    const CandidateArray& B_coarse, MatrixType& P, ValueType& rho_DinvA) const
+    {
+        switch (prolongation)
+        {
+            case FILTERED_JACOBI_PROLONGATION:
+            {
+                MatrixType A_F;
+                cusp::precond::aggregation::filtered_matrix(A, C, A_F);
+                smooth_prolongator(A_F, T, P, rho_DinvA);
+                rho_DinvA = estimate_rho_Dinv_A(A);
+                break;
+            }
+            case ENERGY_MINIMIZATION:
+            {
+                rho_DinvA = estimate_rho_Dinv_A(A);
+                cusp::precond::aggregation::energy_minimization_prolongator(A, T, B_coarse, P, energy_iterations);
+
+                if (prolongator_drop_tolerance > 0 || prolongator_max_entries > 0)
+                    cusp::precond::aggregation::truncate_prolongator(P, prolongator_drop_tolerance, prolongator_max_entries);
+                break;
+            }
+            default:
+                smooth_prolongator(A, T, P, rho_DinvA);
+        }
     }
 
     virtual void form_restriction(const MatrixType& P, MatrixType& R) const
@@ -136,10 +283,10 @@ public:
 
     virtual void galerkin_product(const MatrixType& R, const MatrixType& A, const MatrixType& P, MatrixType& RAP) const
     {
-        // TODO test speed of R * (A * P) vs. (R * A) * P
-        MatrixType AP;
-        cusp::multiply(A, P, AP);
-        cusp::multiply(R, AP, RAP);
+        cusp::galerkin_product(R, A, P, RAP);
+
+        if (galerkin_drop_tolerance > 0)
+            cusp::precond::aggregation::filter_galerkin_product(RAP, galerkin_drop_tolerance);
     }
 };
 
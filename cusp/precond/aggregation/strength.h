@@ -37,6 +37,40 @@ namespace aggregation
 template <typename Matrix1, typename Matrix2>
 void symmetric_strength_of_connection(const Matrix1& A, Matrix2& S, const double theta = 0.0);
 
+/*  Compute a strength of connection matrix using the evolution measure.
+ *  The point i evolves as z_i = (I - 1/rho D^-1 A)^k e_i (k Jacobi steps
+ *  scaled by the spectral radius rho of D^-1 A) and the distance of an
+ *  entry A[i,j] is how poorly z_i is matched by a constant at j::
+ *
+ *     m(i,j) = abs(1 - z_i[j] / z_i[i]) + abs(1 - z_j[i] / z_j[j])
+ *
+ *  A connection is strong iff m(i,j) <= theta * min_{k != i} m(i,k) in
+ *  row i or in row j, so theta is at least 1 (e.g. 2).  Unlike the
+ *  symmetric measure it separates the strong directions of anisotropic
+ *  problems and of matrices with positive off-diagonal entries.
+ *
+ *  The entries of S hold the values of A, and the diagonal is kept.
+ */
+template <typename Matrix1, typename Matrix2>
+void evolution_strength_of_connection(const Matrix1& A, Matrix2& S, const double theta = 2.0, const size_t k = 2);
+
+/*  Compute a strength of connection matrix using algebraic distances.
+ *  num_vectors random vectors are relaxed with sweeps steps of weighted
+ *  Jacobi on A x = 0 and normalized, and the distance of an entry A[i,j]
+ *  is::
+ *
+ *     m(i,j) = ( sum_r (x_r[i] - x_r[j])^2 )^(1/2)
+ *
+ *  Points with a strong (high affinity) connection end up with nearly
+ *  equal values in every smoothed vector.  A connection is strong iff
+ *  m(i,j) <= theta * min_{k != i} m(i,k) in row i or in row j.
+ *
+ *  The entries of S hold the values of A, and the diagonal is kept.
+ */
+template <typename Matrix1, typename Matrix2>
+void algebraic_distance_strength_of_connection(const Matrix1& A, Matrix2& S, const double theta = 2.0,
+                                               const size_t num_vectors = 5, const size_t sweeps = 20);
+
 } // end namespace aggregation
 } // end namespace precond
 } // end namespace cusp
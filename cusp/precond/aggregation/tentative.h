@@ -25,6 +25,17 @@ namespace precond
 namespace aggregation
 {
 
+/*! Tentative prolongator Q and coarse candidates R with B = Q * R.
+ *
+ *  \p B is either an \p array1d holding one near-nullspace candidate,
+ *  in which case Q has one column per aggregate and R one entry per
+ *  aggregate, or an \p array2d with k candidates (e.g. the rigid body
+ *  modes of elasticity) as its columns.  In the latter case the
+ *  candidates of each aggregate are factored with a thin QR, so an
+ *  aggregate of s rows contributes a block of min(k,s) consecutive
+ *  columns to Q and R is a \p column_major \p array2d with k columns
+ *  holding the upper triangular factors of the aggregates.
+ */
 template <typename Array1,
          typename Array2,
          typename MatrixType,
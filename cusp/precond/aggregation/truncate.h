@@ -0,0 +1,48 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include <cusp/detail/config.h>
+
+namespace cusp
+{
+namespace precond
+{
+namespace aggregation
+{
+
+//   Truncated prolongator: drops the entries of each row of P with
+//   |p_ij| < drop_tolerance * max_k |p_ik| and keeps at most max_entries
+//   of the largest remaining entries per row (0 keeps all).  The kept
+//   entries of each row are scaled to preserve its row sum.
+template <typename MatrixType, typename ValueType>
+void truncate_prolongator(MatrixType& P,
+                          const ValueType drop_tolerance,
+                          const size_t max_entries = 0);
+
+//   Filtered coarse operator: drops the off-diagonal entries of A with
+//   |a_ij| < drop_tolerance * sqrt(|a_ii * a_jj|) and adds them to the
+//   diagonal, which keeps the row sums and the symmetry of A.
+template <typename MatrixType, typename ValueType>
+void filter_galerkin_product(MatrixType& A,
+                             const ValueType drop_tolerance);
+
+} // end namespace aggregation
+} // end namespace precond
+} // end namespace cusp
+
+#include <cusp/precond/aggregation/detail/truncate.inl>
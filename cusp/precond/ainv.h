@@ -54,8 +54,7 @@ class scaled_bridson_ainv : public linear_operator<ValueType, MemorySpace>
     typedef linear_operator<ValueType, MemorySpace> Parent;
 
 public:
-    cusp::hyb_matrix<int, ValueType, MemorySpace> w;
-    cusp::hyb_matrix<int, ValueType, MemorySpace> w_t;
+    cusp::hyb_matrix<int, ValueType, MemorySpace> w;    // applied as w^T * w, w^T is not stored
 
     /*! construct a \p ainv preconditioner
      *
@@ -96,6 +95,10 @@ public:
  *  Lin, C. and More, J. J. 1999. Incomplete Cholesky Factorizations with Limited Memory. 
  *  SIAM J. Sci. Comput. 21, 1 (Aug. 1999), 24-45. 
  *  This preconditioner will only work for SPD matrices. 
+ *
+ *  The factorization is computed on the host with the rows of the factor
+ *  stored as flat sorted arrays.  When compiled with OpenMP the updates of
+ *  the later rows at each step of the factorization are applied in parallel.
  */
 
 template <typename ValueType, typename MemorySpace>
@@ -104,8 +107,7 @@ class bridson_ainv : public linear_operator<ValueType, MemorySpace>
     typedef linear_operator<ValueType, MemorySpace> Parent;
 
 public:
-    cusp::hyb_matrix<int, ValueType, MemorySpace> w;
-    cusp::hyb_matrix<int, ValueType, MemorySpace> w_t;
+    cusp::hyb_matrix<int, ValueType, MemorySpace> w;    // applied as w^T * D * w, w^T is not stored
     cusp::array1d<ValueType, MemorySpace> diagonals;
 
     /*! construct a \p ainv preconditioner
@@ -151,7 +153,7 @@ class nonsym_bridson_ainv : public linear_operator<ValueType, MemorySpace>
     typedef linear_operator<ValueType, MemorySpace> Parent;
 
 public:
-    cusp::hyb_matrix<int, ValueType, MemorySpace> w_t;
+    cusp::hyb_matrix<int, ValueType, MemorySpace> w;    // applied as w^T * D * z, w^T is not stored
     cusp::hyb_matrix<int, ValueType, MemorySpace> z;
     cusp::array1d<ValueType, MemorySpace> diagonals;
 
@@ -0,0 +1,152 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*! \file block_jacobi.h
+ *  \brief Block Jacobi preconditioner.
+ */
+
+#pragma once
+
+#include <cusp/detail/config.h>
+
+#include <cusp/array1d.h>
+#include <cusp/linear_operator.h>
+
+namespace cusp
+{
+namespace precond
+{
+
+/*! \addtogroup preconditioners Preconditioners
+ *  \ingroup preconditioners
+ *  \{
+ */
+
+/*! \p block_jacobi : block diagonal preconditioner
+ *
+ *  The rows of \c A are grouped into blocks and the preconditioner
+ *  implements <tt>y = D^-1 x</tt>, where \c D holds the entries of \c A
+ *  which couple two rows of the same block.  The blocks are either the
+ *  consecutive ranges of \c block_size rows, which matches the blocks of a
+ *  \p bsr_matrix, or are given by a partition of the rows such as the one
+ *  computed by \p cusp::graph::hilbert_curve or \p cusp::graph::partition.
+ *
+ *  The diagonal blocks are extracted and inverted during the setup by one
+ *  thread per block, using an LU factorization with partial pivoting.  The
+ *  application is a batch of small dense matrix-vector products with one
+ *  thread per row.  Consecutive blocks of 1 to 6 rows use kernels with the
+ *  block size fixed at compile time.
+ *
+ *  \tparam ValueType Type used for matrix values (e.g. \c float or \c double).
+ *  \tparam MemorySpace A memory space (e.g. \c cusp::host_memory or cusp::device_memory)
+ *
+ *  \note The blocks should be small, the setup stores the dense inverse of
+ *        every block and its cost grows with the cube of the block size.
+ *  \note A \p cusp::runtime_exception is thrown if a diagonal block is singular.
+ *
+ *  The following code snippet demonstrates how to use a \p block_jacobi
+ *  preconditioner with blocks of 3 rows.
+ *
+ *  \code
+ *  #include <cusp/precond/block_jacobi.h>
+ *  #include <cusp/krylov/cg.h>
+ *  ...
+ *
+ *  cusp::precond::block_jacobi<float, cusp::device_memory> M(A, 3);
+ *
+ *  cusp::krylov::cg(A, x, b, monitor, M);
+ *  \endcode
+ */
+template <typename ValueType, typename MemorySpace>
+class block_jacobi : public linear_operator<ValueType, MemorySpace>
+{
+    typedef linear_operator<ValueType, MemorySpace> Parent;
+
+public:
+    /*! Number of rows per block when the blocks are consecutive ranges of
+     *  equal size, zero otherwise.
+     */
+    size_t block_size;
+
+    /*! Rows sorted by block, block \c b holds
+     *  <tt>block_rows[block_offsets[b], block_offsets[b+1])</tt>.
+     */
+    cusp::array1d<int,MemorySpace> block_rows;
+    cusp::array1d<int,MemorySpace> block_offsets;
+
+    /*! Block of each entry of \c block_rows.
+     */
+    cusp::array1d<int,MemorySpace> row_blocks;
+
+    /*! Row-major inverse of block \c b starts at \c inverse_offsets[b].
+     */
+    cusp::array1d<int,MemorySpace> inverse_offsets;
+    cusp::array1d<ValueType,MemorySpace> inverses;
+
+    /*! construct an empty \p block_jacobi preconditioner
+     */
+    block_jacobi(void) : Parent(), block_size(0) {}
+
+    /*! construct a \p block_jacobi preconditioner with consecutive blocks
+     *
+     * \param A matrix to precondition
+     * \param block_size number of rows per block, the last block is
+     *        smaller when it does not divide the number of rows
+     * \tparam MatrixType matrix
+     */
+    template <typename MatrixType>
+    block_jacobi(const MatrixType& A, const size_t block_size);
+
+    /*! construct a \p block_jacobi preconditioner from a partition
+     *
+     * \param A matrix to precondition
+     * \param parts block of each row
+     * \tparam MatrixType matrix
+     */
+    template <typename MatrixType, typename IndexType, typename MemorySpace2>
+    block_jacobi(const MatrixType& A, const cusp::array1d<IndexType,MemorySpace2>& parts);
+
+    template <typename MemorySpace2>
+    block_jacobi(const block_jacobi<ValueType,MemorySpace2>& M);
+
+    /*! number of diagonal blocks
+     */
+    size_t num_blocks(void) const
+    {
+        return block_offsets.size() == 0 ? 0 : block_offsets.size() - 1;
+    }
+
+    /*! apply the preconditioner to vector \p x and store the result in \p y
+     *
+     * \param x input vector
+     * \param y ouput vector
+     * \tparam VectorType1 vector
+     * \tparam VectorType2 vector
+     */
+    template <typename VectorType1, typename VectorType2>
+    void operator()(const VectorType1& x, VectorType2& y) const;
+
+private:
+    template <typename MatrixType, typename ArrayType>
+    void setup(const MatrixType& A, const ArrayType& parts);
+};
+/*! \}
+ */
+
+} // end namespace precond
+} // end namespace cusp
+
+#include <cusp/precond/detail/block_jacobi.inl>
@@ -0,0 +1,248 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include <cusp/array1d.h>
+#include <cusp/coo_matrix.h>
+
+#include <cusp/detail/format_utils.h>
+#include <cusp/precond/aggregation/truncate.h>
+
+#include <thrust/binary_search.h>
+#include <thrust/copy.h>
+#include <thrust/count.h>
+#include <thrust/functional.h>
+#include <thrust/scan.h>
+#include <thrust/transform.h>
+
+#include <thrust/iterator/constant_iterator.h>
+#include <thrust/iterator/counting_iterator.h>
+#include <thrust/iterator/permutation_iterator.h>
+#include <thrust/iterator/transform_iterator.h>
+#include <thrust/iterator/zip_iterator.h>
+
+namespace cusp
+{
+namespace precond
+{
+namespace classical
+{
+namespace detail
+{
+
+// strong connection of an F point to a C point
+template <typename IndexType>
+struct is_interpolatory
+{
+    template <typename Tuple>
+    __host__ __device__
+    bool operator()(const Tuple& t) const
+    {
+        // (strong, cf[i], cf[j])
+        return thrust::get<0>(t) && !thrust::get<1>(t) && thrust::get<2>(t);
+    }
+};
+
+// the negative or positive off-diagonal entries of a row, optionally only
+// those of interpolatory connections
+template <typename ValueType>
+struct off_diagonal_part
+{
+    bool negative;
+    bool interpolatory;
+
+    off_diagonal_part(bool negative, bool interpolatory)
+        : negative(negative), interpolatory(interpolatory) {}
+
+    template <typename Tuple>
+    __host__ __device__
+    ValueType operator()(const Tuple& t) const
+    {
+        // (i, j, a_ij, interpolatory)
+        const ValueType value = thrust::get<2>(t);
+
+        if (thrust::get<0>(t) == thrust::get<1>(t) || (interpolatory && !thrust::get<3>(t)))
+            return ValueType(0);
+
+        return (negative ? value < ValueType(0) : value > ValueType(0)) ? value : ValueType(0);
+    }
+};
+
+template <typename ValueType>
+struct safe_ratio : thrust::binary_function<ValueType,ValueType,ValueType>
+{
+    __host__ __device__
+    ValueType operator()(const ValueType num, const ValueType den) const
+    {
+        return den == ValueType(0) ? ValueType(0) : num / den;
+    }
+};
+
+// the diagonal with the positive entries lumped in when none interpolate
+template <typename ValueType>
+struct interpolation_diagonal
+{
+    template <typename Tuple>
+    __host__ __device__
+    ValueType operator()(const Tuple& t) const
+    {
+        // (a_ii, positive sum, interpolatory positive sum)
+        return thrust::get<0>(t) + (thrust::get<2>(t) == ValueType(0) ? thrust::get<1>(t) : ValueType(0));
+    }
+};
+
+template <typename ValueType>
+struct interpolation_weight
+{
+    template <typename Tuple>
+    __host__ __device__
+    ValueType operator()(const Tuple& t) const
+    {
+        // (a_ij, alpha_i, beta_i, diagonal_i)
+        const ValueType value = thrust::get<0>(t);
+        const ValueType scale = value < ValueType(0) ? thrust::get<1>(t) : thrust::get<2>(t);
+
+        return -scale * value / thrust::get<3>(t);
+    }
+};
+
+template <typename MatrixType, typename ArrayType>
+void direct_interpolation(const MatrixType& A,
+                          const MatrixType& S,
+                          const ArrayType& cf,
+                          MatrixType& P)
+{
+    CUSP_PROFILE_SCOPED();
+
+    typedef typename MatrixType::index_type   IndexType;
+    typedef typename MatrixType::value_type   ValueType;
+    typedef typename MatrixType::memory_space MemorySpace;
+
+    using cusp::precond::aggregation::detail::reduce_rows;
+
+    cusp::coo_matrix<IndexType,ValueType,MemorySpace> C(A);
+    cusp::coo_matrix<IndexType,ValueType,MemorySpace> S_coo(S);
+
+    const size_t N = C.num_rows;
+
+    // coarse index of each C point
+    cusp::array1d<IndexType,MemorySpace> coarse_index(N);
+    thrust::exclusive_scan(cf.begin(), cf.end(), coarse_index.begin());
+    const IndexType num_coarse = thrust::count(cf.begin(), cf.end(), 1);
+
+    // entries of A that are strong connections, S is a sorted subset of A
+    cusp::array1d<bool,MemorySpace> strong(C.num_entries);
+    thrust::binary_search(thrust::make_zip_iterator(thrust::make_tuple(S_coo.row_indices.begin(), S_coo.column_indices.begin())),
+                          thrust::make_zip_iterator(thrust::make_tuple(S_coo.row_indices.end(),   S_coo.column_indices.end())),
+                          thrust::make_zip_iterator(thrust::make_tuple(C.row_indices.begin(), C.column_indices.begin())),
+                          thrust::make_zip_iterator(thrust::make_tuple(C.row_indices.end(),   C.column_indices.end())),
+                          strong.begin());
+
+    // interpolatory entries: strong connections of F points to C points
+    cusp::array1d<bool,MemorySpace> interpolatory(C.num_entries);
+    thrust::transform(thrust::make_zip_iterator(thrust::make_tuple(strong.begin(),
+                                                                   thrust::make_permutation_iterator(cf.begin(), C.row_indices.begin()),
+                                                                   thrust::make_permutation_iterator(cf.begin(), C.column_indices.begin()))),
+                      thrust::make_zip_iterator(thrust::make_tuple(strong.end(),
+                                                                   thrust::make_permutation_iterator(cf.begin(), C.row_indices.end()),
+                                                                   thrust::make_permutation_iterator(cf.begin(), C.column_indices.end()))),
+                      interpolatory.begin(),
+                      is_interpolatory<IndexType>());
+
+    // sums of the negative and positive off-diagonal entries of each row
+    cusp::array1d<ValueType,MemorySpace> negative_sum(N), positive_sum(N);
+    cusp::array1d<ValueType,MemorySpace> negative_P(N),   positive_P(N);
+    {
+        typedef thrust::zip_iterator< thrust::tuple<typename cusp::array1d<IndexType,MemorySpace>::iterator,
+                                                    typename cusp::array1d<IndexType,MemorySpace>::iterator,
+                                                    typename cusp::array1d<ValueType,MemorySpace>::iterator,
+                                                    typename cusp::array1d<bool,MemorySpace>::iterator> > EntryIterator;
+
+        EntryIterator entries(thrust::make_tuple(C.row_indices.begin(), C.column_indices.begin(), C.values.begin(), interpolatory.begin()));
+
+        reduce_rows(C.row_indices, thrust::make_transform_iterator(entries, off_diagonal_part<ValueType>(true,  false)), negative_sum, thrust::plus<ValueType>());
+        reduce_rows(C.row_indices, thrust::make_transform_iterator(entries, off_diagonal_part<ValueType>(false, false)), positive_sum, thrust::plus<ValueType>());
+        reduce_rows(C.row_indices, thrust::make_transform_iterator(entries, off_diagonal_part<ValueType>(true,  true)),  negative_P,   thrust::plus<ValueType>());
+        reduce_rows(C.row_indices, thrust::make_transform_iterator(entries, off_diagonal_part<ValueType>(false, true)),  positive_P,   thrust::plus<ValueType>());
+    }
+
+    cusp::array1d<ValueType,MemorySpace> diagonal(N);
+    cusp::detail::extract_diagonal(C, diagonal);
+    thrust::transform(thrust::make_zip_iterator(thrust::make_tuple(diagonal.begin(), positive_sum.begin(), positive_P.begin())),
+                      thrust::make_zip_iterator(thrust::make_tuple(diagonal.end(),   positive_sum.end(),   positive_P.end())),
+                      diagonal.begin(),
+                      interpolation_diagonal<ValueType>());
+
+    // alpha_i and beta_i
+    cusp::array1d<ValueType,MemorySpace>& alpha = negative_sum;
+    cusp::array1d<ValueType,MemorySpace>& beta  = positive_sum;
+    thrust::transform(negative_sum.begin(), negative_sum.end(), negative_P.begin(), alpha.begin(), safe_ratio<ValueType>());
+    thrust::transform(positive_sum.begin(), positive_sum.end(), positive_P.begin(), beta.begin(),  safe_ratio<ValueType>());
+
+    const size_t num_interpolatory = thrust::count(interpolatory.begin(), interpolatory.end(), true);
+
+    cusp::coo_matrix<IndexType,ValueType,MemorySpace> P_coo(N, num_coarse, num_interpolatory + num_coarse);
+
+    // rows of the F points
+    thrust::copy_if(thrust::make_zip_iterator(thrust::make_tuple(C.row_indices.begin(),
+                                                                 thrust::make_permutation_iterator(coarse_index.begin(), C.column_indices.begin()),
+                                                                 thrust::make_transform_iterator(
+                                                                     thrust::make_zip_iterator(thrust::make_tuple(C.values.begin(),
+                                                                                               thrust::make_permutation_iterator(alpha.begin(), C.row_indices.begin()),
+                                                                                               thrust::make_permutation_iterator(beta.begin(), C.row_indices.begin()),
+                                                                                               thrust::make_permutation_iterator(diagonal.begin(), C.row_indices.begin()))),
+                                                                     interpolation_weight<ValueType>()))),
+                    thrust::make_zip_iterator(thrust::make_tuple(C.row_indices.end(),
+                                                                 thrust::make_permutation_iterator(coarse_index.begin(), C.column_indices.end()),
+                                                                 thrust::make_transform_iterator(
+                                                                     thrust::make_zip_iterator(thrust::make_tuple(C.values.end(),
+                                                                                               thrust::make_permutation_iterator(alpha.begin(), C.row_indices.end()),
+                                                                                               thrust::make_permutation_iterator(beta.begin(), C.row_indices.end()),
+                                                                                               thrust::make_permutation_iterator(diagonal.begin(), C.row_indices.end()))),
+                                                                     interpolation_weight<ValueType>()))),
+                    interpolatory.begin(),
+                    thrust::make_zip_iterator(thrust::make_tuple(P_coo.row_indices.begin(), P_coo.column_indices.begin(), P_coo.values.begin())),
+                    thrust::identity<bool>());
+
+    // rows of the C points
+    thrust::copy_if(thrust::make_zip_iterator(thrust::make_tuple(thrust::counting_iterator<IndexType>(0), coarse_index.begin(), thrust::constant_iterator<ValueType>(1))),
+                    thrust::make_zip_iterator(thrust::make_tuple(thrust::counting_iterator<IndexType>(N), coarse_index.end(), thrust::constant_iterator<ValueType>(1) + N)),
+                    cf.begin(),
+                    thrust::make_zip_iterator(thrust::make_tuple(P_coo.row_indices.begin()    + num_interpolatory,
+                                                                 P_coo.column_indices.begin() + num_interpolatory,
+                                                                 P_coo.values.begin()         + num_interpolatory)),
+                    thrust::identity<IndexType>());
+
+    P_coo.sort_by_row_and_column();
+
+    P = P_coo;
+}
+
+} // end namespace detail
+
+template <typename MatrixType, typename ArrayType>
+void direct_interpolation(const MatrixType& A,
+                          const MatrixType& S,
+                          const ArrayType& cf,
+                          MatrixType& P)
+{
+    CUSP_PROFILE_SCOPED();
+
+    detail::direct_interpolation(A, S, cf, P);
+}
+
+} // end namespace classical
+} // end namespace precond
+} // end namespace cusp
@@ -0,0 +1,132 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include <cusp/multiply.h>
+#include <cusp/transpose.h>
+
+#include <cusp/precond/classical/interpolate.h>
+#include <cusp/precond/classical/split.h>
+#include <cusp/precond/classical/strength.h>
+
+#include <thrust/count.h>
+
+namespace cusp
+{
+namespace precond
+{
+namespace classical
+{
+namespace detail
+{
+
+template <typename Matrix>
+void setup_level_matrix(Matrix& dst, Matrix& src) {
+    dst.swap(src);
+}
+
+template <typename Matrix1, typename Matrix2>
+void setup_level_matrix(Matrix1& dst, Matrix2& src) {
+    dst = src;
+}
+
+} // end namespace detail
+
+template <typename IndexType, typename ValueType, typename MemorySpace, typename SmootherType, typename SolverType>
+template <typename MatrixType>
+ruge_stuben<IndexType,ValueType,MemorySpace,SmootherType,SolverType>
+::ruge_stuben(const MatrixType& A, const ValueType theta,
+              const size_t coarse_grid_size, const size_t max_levels)
+  : theta(theta), min_level_size(coarse_grid_size), max_levels(max_levels)
+{
+    CUSP_PROFILE_SCOPED();
+
+    Parent* ML = this;
+    ML->levels.reserve(max_levels); // avoid reallocations which force matrix copies
+
+    ML->levels.push_back(typename Parent::level());
+
+    SetupMatrixType A_level(A); // copy
+
+    while ((A_level.num_rows > min_level_size) &&
+           (ML->levels.size() < max_levels))
+    {
+        if (!extend_hierarchy(A_level))
+            break;
+    }
+
+    ML->solver = SolverType(A_level);
+    detail::setup_level_matrix( ML->levels.back().A, A_level );
+}
+
+template <typename IndexType, typename ValueType, typename MemorySpace, typename SmootherType, typename SolverType>
+template <typename MemorySpace2, typename SmootherType2, typename SolverType2>
+ruge_stuben<IndexType,ValueType,MemorySpace,SmootherType,SolverType>
+::ruge_stuben(const ruge_stuben<IndexType,ValueType,MemorySpace2,SmootherType2,SolverType2>& M)
+  : Parent(M), theta(M.theta), min_level_size(M.min_level_size), max_levels(M.max_levels)
+{
+}
+
+template <typename IndexType, typename ValueType, typename MemorySpace, typename SmootherType, typename SolverType>
+bool ruge_stuben<IndexType,ValueType,MemorySpace,SmootherType,SolverType>
+::extend_hierarchy(SetupMatrixType& A)
+{
+    CUSP_PROFILE_SCOPED();
+
+    Parent* ML = this;
+
+    const size_t lvl = ML->levels.size() - 1;
+
+    // strong connections and C/F splitting
+    SetupMatrixType S;
+    classical_strength_of_connection(A, S, theta);
+
+    cusp::array1d<IndexType,MemorySpace> cf;
+    cf_splitting(S, cf);
+
+    const size_t num_coarse = thrust::count(cf.begin(), cf.end(), IndexType(1));
+
+    if (num_coarse == 0 || num_coarse == size_t(A.num_rows))
+        return false;
+
+    // interpolation, restriction and Galerkin product R*A*P
+    SetupMatrixType P;
+    direct_interpolation(A, S, cf, P);
+
+    SetupMatrixType R;
+    cusp::transpose(P, R);
+
+    SetupMatrixType RAP;
+    cusp::galerkin_product(R, A, P, RAP);
+
+    ML->levels[lvl].smoother = SmootherType(A);
+    ML->levels[lvl].residual.resize(A.num_rows);
+
+    detail::setup_level_matrix( ML->levels[lvl].R, R );
+    detail::setup_level_matrix( ML->levels[lvl].P, P );
+    detail::setup_level_matrix( ML->levels[lvl].A, A );
+
+    A.swap(RAP);
+
+    ML->levels.push_back(typename Parent::level());
+    ML->levels.back().x.resize(A.num_rows);
+    ML->levels.back().b.resize(A.num_rows);
+
+    return true;
+}
+
+} // end namespace classical
+} // end namespace precond
+} // end namespace cusp
@@ -0,0 +1,131 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include <cusp/array1d.h>
+#include <cusp/coo_matrix.h>
+
+#include <cusp/detail/format_utils.h>
+#include <cusp/graph/maximal_independent_set.h>
+#include <cusp/precond/aggregation/truncate.h>
+
+#include <thrust/copy.h>
+#include <thrust/fill.h>
+#include <thrust/scatter.h>
+#include <thrust/transform.h>
+#include <thrust/unique.h>
+
+#include <thrust/iterator/constant_iterator.h>
+#include <thrust/iterator/permutation_iterator.h>
+#include <thrust/iterator/zip_iterator.h>
+
+namespace cusp
+{
+namespace precond
+{
+namespace classical
+{
+namespace detail
+{
+
+// C points of the MIS with strong connections, and F points that depend
+// strongly on no C point
+template <typename IndexType>
+struct select_coarse_point
+{
+    template <typename Tuple>
+    __host__ __device__
+    IndexType operator()(const Tuple& t) const
+    {
+        const IndexType in_set        = thrust::get<0>(t);
+        const IndexType connected     = thrust::get<1>(t);
+        const IndexType dependencies  = thrust::get<2>(t);
+        const IndexType c_dependencies = thrust::get<3>(t);
+
+        if (!connected)
+            return 0;
+
+        return (in_set || (dependencies > 0 && c_dependencies == 0)) ? 1 : 0;
+    }
+};
+
+template <typename MatrixType, typename ArrayType>
+void cf_splitting(const MatrixType& S,
+                  ArrayType& cf)
+{
+    CUSP_PROFILE_SCOPED();
+
+    typedef typename MatrixType::index_type   IndexType;
+    typedef typename MatrixType::value_type   ValueType;
+    typedef typename MatrixType::memory_space MemorySpace;
+
+    cusp::coo_matrix<IndexType,ValueType,MemorySpace> S_coo(S);
+
+    const size_t N = S_coo.num_rows;
+    const size_t num_entries = S_coo.num_entries;
+
+    // graph of S + S^T
+    cusp::coo_matrix<IndexType,ValueType,MemorySpace> G(N, N, 2 * num_entries);
+    thrust::copy(S_coo.row_indices.begin(),    S_coo.row_indices.end(),    G.row_indices.begin());
+    thrust::copy(S_coo.column_indices.begin(), S_coo.column_indices.end(), G.column_indices.begin());
+    thrust::copy(S_coo.column_indices.begin(), S_coo.column_indices.end(), G.row_indices.begin() + num_entries);
+    thrust::copy(S_coo.row_indices.begin(),    S_coo.row_indices.end(),    G.column_indices.begin() + num_entries);
+    thrust::fill(G.values.begin(), G.values.end(), ValueType(1));
+    G.sort_by_row_and_column();
+
+    const size_t num_edges =
+        thrust::unique(thrust::make_zip_iterator(thrust::make_tuple(G.row_indices.begin(), G.column_indices.begin())),
+                       thrust::make_zip_iterator(thrust::make_tuple(G.row_indices.end(),   G.column_indices.end())))
+        - thrust::make_zip_iterator(thrust::make_tuple(G.row_indices.begin(), G.column_indices.begin()));
+    G.resize(N, N, num_edges);
+
+    cusp::array1d<IndexType,MemorySpace> mis(N);
+    cusp::graph::maximal_independent_set(G, mis, 1);
+
+    // points with a strong connection in either direction
+    cusp::array1d<IndexType,MemorySpace> connected(N, IndexType(0));
+    thrust::scatter(thrust::make_constant_iterator(IndexType(1)),
+                    thrust::make_constant_iterator(IndexType(1)) + num_edges,
+                    G.row_indices.begin(), connected.begin());
+
+    // strong dependencies of each point and those on MIS points
+    cusp::array1d<IndexType,MemorySpace> dependencies(N);
+    cusp::array1d<IndexType,MemorySpace> c_dependencies(N);
+    cusp::precond::aggregation::detail::reduce_rows(S_coo.row_indices, thrust::make_constant_iterator(IndexType(1)),
+                                                    dependencies, thrust::plus<IndexType>());
+    cusp::precond::aggregation::detail::reduce_rows(S_coo.row_indices, thrust::make_permutation_iterator(mis.begin(), S_coo.column_indices.begin()),
+                                                    c_dependencies, thrust::plus<IndexType>());
+
+    cf.resize(N);
+    thrust::transform(thrust::make_zip_iterator(thrust::make_tuple(mis.begin(), connected.begin(), dependencies.begin(), c_dependencies.begin())),
+                      thrust::make_zip_iterator(thrust::make_tuple(mis.end(),   connected.end(),   dependencies.end(),   c_dependencies.end())),
+                      cf.begin(),
+                      select_coarse_point<IndexType>());
+}
+
+} // end namespace detail
+
+template <typename MatrixType, typename ArrayType>
+void cf_splitting(const MatrixType& S,
+                  ArrayType& cf)
+{
+    CUSP_PROFILE_SCOPED();
+
+    detail::cf_splitting(S, cf);
+}
+
+} // end namespace classical
+} // end namespace precond
+} // end namespace cusp
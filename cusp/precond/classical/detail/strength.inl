@@ -0,0 +1,126 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include <cusp/array1d.h>
+#include <cusp/coo_matrix.h>
+
+#include <cusp/precond/aggregation/truncate.h>
+
+#include <thrust/copy.h>
+#include <thrust/count.h>
+#include <thrust/functional.h>
+#include <thrust/transform.h>
+
+#include <thrust/iterator/permutation_iterator.h>
+#include <thrust/iterator/transform_iterator.h>
+#include <thrust/iterator/zip_iterator.h>
+
+namespace cusp
+{
+namespace precond
+{
+namespace classical
+{
+namespace detail
+{
+
+// -a_ij for off-diagonal entries, 0 on the diagonal
+template <typename ValueType>
+struct negative_off_diagonal
+{
+    template <typename Tuple>
+    __host__ __device__
+    ValueType operator()(const Tuple& t) const
+    {
+        return thrust::get<0>(t) == thrust::get<1>(t) ? ValueType(0) : -thrust::get<2>(t);
+    }
+};
+
+// -a_ij >= theta * max_{k != i} -a_ik > 0
+template <typename ValueType>
+struct is_strong_connection
+{
+    ValueType theta;
+
+    is_strong_connection(ValueType theta) : theta(theta) {}
+
+    template <typename Tuple>
+    __host__ __device__
+    bool operator()(const Tuple& t) const
+    {
+        const ValueType value   = -thrust::get<2>(t);
+        const ValueType row_max = thrust::get<3>(t);
+
+        return thrust::get<0>(t) != thrust::get<1>(t) && value > ValueType(0) && value >= theta * row_max;
+    }
+};
+
+template <typename MatrixType, typename ValueType>
+void classical_strength_of_connection(const MatrixType& A,
+                                      MatrixType& S,
+                                      const ValueType theta)
+{
+    CUSP_PROFILE_SCOPED();
+
+    typedef typename MatrixType::index_type   IndexType;
+    typedef typename MatrixType::value_type   V;
+    typedef typename MatrixType::memory_space MemorySpace;
+
+    cusp::coo_matrix<IndexType,V,MemorySpace> C(A);
+
+    // largest negative off-diagonal coupling of each row
+    cusp::array1d<V,MemorySpace> row_max(C.num_rows);
+    cusp::precond::aggregation::detail::reduce_rows
+        (C.row_indices,
+         thrust::make_transform_iterator(thrust::make_zip_iterator(thrust::make_tuple(C.row_indices.begin(), C.column_indices.begin(), C.values.begin())),
+                                         negative_off_diagonal<V>()),
+         row_max, thrust::maximum<V>());
+
+    cusp::array1d<bool,MemorySpace> strong(C.num_entries);
+    thrust::transform(thrust::make_zip_iterator(thrust::make_tuple(C.row_indices.begin(), C.column_indices.begin(), C.values.begin(),
+                                                                   thrust::make_permutation_iterator(row_max.begin(), C.row_indices.begin()))),
+                      thrust::make_zip_iterator(thrust::make_tuple(C.row_indices.end(), C.column_indices.end(), C.values.end(),
+                                                                   thrust::make_permutation_iterator(row_max.begin(), C.row_indices.end()))),
+                      strong.begin(),
+                      is_strong_connection<V>(V(theta)));
+
+    const size_t num_strong = thrust::count(strong.begin(), strong.end(), true);
+
+    cusp::coo_matrix<IndexType,V,MemorySpace> S_coo(C.num_rows, C.num_cols, num_strong);
+    thrust::copy_if(thrust::make_zip_iterator(thrust::make_tuple(C.row_indices.begin(), C.column_indices.begin(), C.values.begin())),
+                    thrust::make_zip_iterator(thrust::make_tuple(C.row_indices.end(),   C.column_indices.end(),   C.values.end())),
+                    strong.begin(),
+                    thrust::make_zip_iterator(thrust::make_tuple(S_coo.row_indices.begin(), S_coo.column_indices.begin(), S_coo.values.begin())),
+                    thrust::identity<bool>());
+
+    S = S_coo;
+}
+
+} // end namespace detail
+
+template <typename MatrixType, typename ValueType>
+void classical_strength_of_connection(const MatrixType& A,
+                                      MatrixType& S,
+                                      const ValueType theta)
+{
+    CUSP_PROFILE_SCOPED();
+
+    detail::classical_strength_of_connection(A, S, theta);
+}
+
+} // end namespace classical
+} // end namespace precond
+} // end namespace cusp
@@ -0,0 +1,49 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include <cusp/detail/config.h>
+
+namespace cusp
+{
+namespace precond
+{
+namespace classical
+{
+
+//   Direct interpolation.  A C point i takes the value of its coarse
+//   point and an F point i interpolates from its strong C dependencies
+//   P_i with
+//
+//     w_ij = -alpha_i a_ij / a_ii   (a_ij < 0)
+//     w_ij = -beta_i  a_ij / a_ii   (a_ij > 0)
+//
+//   where alpha_i (beta_i) is the ratio of the sums of the negative
+//   (positive) off-diagonal entries of row i over all of its neighbors
+//   and over P_i.  Positive entries are added to the diagonal when P_i
+//   has none.  The coarse points are numbered in the order of the C points.
+template <typename MatrixType, typename ArrayType>
+void direct_interpolation(const MatrixType& A,
+                          const MatrixType& S,
+                          const ArrayType& cf,
+                          MatrixType& P);
+
+} // end namespace classical
+} // end namespace precond
+} // end namespace cusp
+
+#include <cusp/precond/classical/detail/interpolate.inl>
@@ -0,0 +1,100 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*! \file ruge_stuben.h
+ *  \brief Classical (Ruge-Stuben) algebraic multigrid preconditioner
+ *
+ */
+
+#pragma once
+
+#include <cusp/detail/config.h>
+
+#include <cusp/detail/lu.h>
+#include <cusp/multilevel.h>
+
+#include <cusp/precond/aggregation/smoothed_aggregation_options.h>
+
+#include <cusp/relaxation/gauss_seidel.h>
+
+namespace cusp
+{
+namespace precond
+{
+namespace classical
+{
+
+/*! \addtogroup preconditioners Preconditioners
+ *  \ingroup preconditioners
+ *  \{
+ */
+
+/*! \p ruge_stuben : classical algebraic multigrid preconditioner
+ *
+ *  Each level splits its points into C and F points on the graph of the
+ *  strong connections (\p classical_strength_of_connection and
+ *  \p cf_splitting), interpolates the F points from their strong C
+ *  dependencies (\p direct_interpolation) and forms the coarse operator
+ *  with the Galerkin product P^T A P.  Unlike smoothed aggregation the
+ *  interpolation follows the strong couplings of each row, which suits
+ *  strongly anisotropic problems.  The solve phase is the one of
+ *  \p cusp::multilevel, with the same matrix formats as
+ *  \p smoothed_aggregation.
+ *
+ *  The smoother is constructed from the matrix of each level; the
+ *  default multicolor Gauss-Seidel keeps the cycle symmetric.
+ */
+template <typename IndexType, typename ValueType, typename MemorySpace,
+	  typename SmootherType = cusp::relaxation::gauss_seidel<ValueType,MemorySpace>,
+	  typename SolverType = cusp::detail::dense_inverse_solver<ValueType,MemorySpace> >
+class ruge_stuben :
+  public cusp::multilevel< typename cusp::precond::aggregation::amg_container<IndexType,ValueType,MemorySpace>::solve_type, SmootherType, SolverType, ValueType>
+{
+
+    typedef typename cusp::precond::aggregation::amg_container<IndexType,ValueType,MemorySpace>::setup_type SetupMatrixType;
+    typedef typename cusp::precond::aggregation::amg_container<IndexType,ValueType,MemorySpace>::solve_type SolveMatrixType;
+    typedef typename cusp::multilevel<SolveMatrixType,SmootherType,SolverType,ValueType> Parent;
+
+public:
+
+    // the solve phase, e.g. for cusp::io::read_hierarchy
+    typedef Parent hierarchy_type;
+
+    ValueType theta;          // strength of connection threshold
+    size_t min_level_size;    // levels with at most this many rows are solved directly
+    size_t max_levels;
+
+    template <typename MatrixType>
+    ruge_stuben(const MatrixType& A, const ValueType theta = 0.25,
+                const size_t coarse_grid_size = 100, const size_t max_levels = 20);
+
+    template <typename MemorySpace2, typename SmootherType2, typename SolverType2>
+    ruge_stuben(const ruge_stuben<IndexType,ValueType,MemorySpace2,SmootherType2,SolverType2>& M);
+
+protected:
+
+    // adds the level below A and returns its operator in A, false when A
+    // no longer coarsens
+    bool extend_hierarchy(SetupMatrixType& A);
+};
+/*! \}
+ */
+
+} // end namespace classical
+} // end namespace precond
+} // end namespace cusp
+
+#include <cusp/precond/classical/detail/ruge_stuben.inl>
@@ -0,0 +1,42 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include <cusp/detail/config.h>
+
+namespace cusp
+{
+namespace precond
+{
+namespace classical
+{
+
+//   C/F splitting of the strength matrix S in the manner of PMIS: the C
+//   points are a maximal independent set of the graph of S + S^T, points
+//   without strong connections are F points and F points that depend
+//   strongly on no C point are promoted to C, so that every F point with
+//   strong dependencies interpolates from at least one of them.
+//   cf[i] is 1 for C points and 0 for F points.
+template <typename MatrixType, typename ArrayType>
+void cf_splitting(const MatrixType& S,
+                  ArrayType& cf);
+
+} // end namespace classical
+} // end namespace precond
+} // end namespace cusp
+
+#include <cusp/precond/classical/detail/split.inl>
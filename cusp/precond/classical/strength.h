@@ -0,0 +1,40 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include <cusp/detail/config.h>
+
+namespace cusp
+{
+namespace precond
+{
+namespace classical
+{
+
+//   Classical strength of connection: i depends strongly on j != i when
+//   -a_ij >= theta * max_{k != i} -a_ik > 0.  S holds the entries a_ij
+//   of the strong connections of each row.
+template <typename MatrixType, typename ValueType>
+void classical_strength_of_connection(const MatrixType& A,
+                                      MatrixType& S,
+                                      const ValueType theta = 0.25);
+
+} // end namespace classical
+} // end namespace precond
+} // end namespace cusp
+
+#include <cusp/precond/classical/detail/strength.inl>
@@ -0,0 +1,543 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*! \file additive_schwarz.inl
+ *  \brief Inline file for additive_schwarz.h
+ */
+
+#include <cusp/coo_matrix.h>
+#include <cusp/exception.h>
+#include <cusp/multiply.h>
+#include <cusp/transpose.h>
+#include <cusp/detail/format_utils.h>
+#include <cusp/detail/stream.h>
+
+#include <thrust/binary_search.h>
+#include <thrust/extrema.h>
+#include <thrust/fill.h>
+#include <thrust/functional.h>
+#include <thrust/scan.h>
+#include <thrust/sequence.h>
+#include <thrust/sort.h>
+#include <thrust/transform.h>
+#include <thrust/unique.h>
+#include <thrust/iterator/counting_iterator.h>
+
+namespace cusp
+{
+namespace precond
+{
+namespace detail
+{
+
+// largest subdomain solved by dense LU when the local solver is automatic
+const size_t SCHWARZ_DENSE_LU_LIMIT = 64;
+
+// position of row j in the sorted rows[first, last), -1 when absent
+template <typename IndexType>
+__host__ __device__
+IndexType schwarz_find(const IndexType * rows, IndexType first, IndexType last, const IndexType j)
+{
+    const IndexType end = last;
+
+    while(first < last)
+    {
+        const IndexType middle = first + (last - first) / 2;
+
+        if(rows[middle] < j)
+            first = middle + 1;
+        else
+            last = middle;
+    }
+
+    return (first < end && rows[first] == j) ? first : IndexType(-1);
+}
+
+// number of entries of A coupling the row p of a subdomain to rows of the same subdomain
+template <typename IndexType>
+struct schwarz_count_local
+{
+    const IndexType * Ap;
+    const IndexType * Aj;
+    const IndexType * subdomain_rows;
+    const IndexType * subdomain_parts;
+    const IndexType * subdomain_offsets;
+    IndexType * counts;
+
+    schwarz_count_local(const IndexType * Ap, const IndexType * Aj, const IndexType * subdomain_rows,
+                        const IndexType * subdomain_parts, const IndexType * subdomain_offsets, IndexType * counts)
+        : Ap(Ap), Aj(Aj), subdomain_rows(subdomain_rows), subdomain_parts(subdomain_parts),
+          subdomain_offsets(subdomain_offsets), counts(counts) {}
+
+    __host__ __device__
+    void operator()(const IndexType p) const
+    {
+        const IndexType i     = subdomain_rows[p];
+        const IndexType s     = subdomain_parts[p];
+        const IndexType first = subdomain_offsets[s];
+        const IndexType last  = subdomain_offsets[s + 1];
+
+        IndexType count = 0;
+
+        for(IndexType k = Ap[i]; k < Ap[i + 1]; k++)
+            if(schwarz_find(subdomain_rows, first, last, Aj[k]) >= 0)
+                count++;
+
+        counts[p] = count;
+    }
+};
+
+// copies those entries into row p of the block diagonal matrix of the subdomains
+template <typename IndexType, typename ValueType>
+struct schwarz_extract_local
+{
+    const IndexType * Ap;
+    const IndexType * Aj;
+    const ValueType * Ax;
+    const IndexType * subdomain_rows;
+    const IndexType * subdomain_parts;
+    const IndexType * subdomain_offsets;
+    const IndexType * Lp;
+    IndexType * Lj;
+    ValueType * Lx;
+
+    schwarz_extract_local(const IndexType * Ap, const IndexType * Aj, const ValueType * Ax,
+                          const IndexType * subdomain_rows, const IndexType * subdomain_parts,
+                          const IndexType * subdomain_offsets, const IndexType * Lp, IndexType * Lj, ValueType * Lx)
+        : Ap(Ap), Aj(Aj), Ax(Ax), subdomain_rows(subdomain_rows), subdomain_parts(subdomain_parts),
+          subdomain_offsets(subdomain_offsets), Lp(Lp), Lj(Lj), Lx(Lx) {}
+
+    __host__ __device__
+    void operator()(const IndexType p) const
+    {
+        const IndexType i     = subdomain_rows[p];
+        const IndexType s     = subdomain_parts[p];
+        const IndexType first = subdomain_offsets[s];
+        const IndexType last  = subdomain_offsets[s + 1];
+
+        IndexType n = Lp[p];
+
+        // the rows of a subdomain are sorted, so are the local columns
+        for(IndexType k = Ap[i]; k < Ap[i + 1]; k++)
+        {
+            const IndexType q = schwarz_find(subdomain_rows, first, last, Aj[k]);
+
+            if(q >= 0)
+            {
+                Lj[n] = q;
+                Lx[n] = Ax[k];
+                n++;
+            }
+        }
+    }
+};
+
+// the copy of every row in the subdomain of its own part
+template <typename IndexType>
+struct schwarz_owner
+{
+    const IndexType * parts;
+    const IndexType * subdomain_rows;
+    const IndexType * subdomain_parts;
+    IndexType * row_owners;
+
+    schwarz_owner(const IndexType * parts, const IndexType * subdomain_rows,
+                  const IndexType * subdomain_parts, IndexType * row_owners)
+        : parts(parts), subdomain_rows(subdomain_rows), subdomain_parts(subdomain_parts), row_owners(row_owners) {}
+
+    __host__ __device__
+    void operator()(const IndexType p) const
+    {
+        const IndexType i = subdomain_rows[p];
+
+        if(parts[i] == subdomain_parts[p])
+            row_owners[i] = p;
+    }
+};
+
+// x_local = R x
+template <typename IndexType, typename ValueType>
+struct schwarz_restrict
+{
+    const IndexType * subdomain_rows;
+    const ValueType * x;
+    ValueType * x_local;
+
+    schwarz_restrict(const IndexType * subdomain_rows, const ValueType * x, ValueType * x_local)
+        : subdomain_rows(subdomain_rows), x(x), x_local(x_local) {}
+
+    __host__ __device__
+    void operator()(const IndexType p) const
+    {
+        x_local[p] = x[subdomain_rows[p]];
+    }
+};
+
+// y = R^T y_local, one thread per row summing its copies
+template <typename IndexType, typename ValueType>
+struct schwarz_prolongate
+{
+    const IndexType * row_offsets;
+    const IndexType * row_copies;
+    const ValueType * y_local;
+    ValueType * y;
+
+    schwarz_prolongate(const IndexType * row_offsets, const IndexType * row_copies,
+                       const ValueType * y_local, ValueType * y)
+        : row_offsets(row_offsets), row_copies(row_copies), y_local(y_local), y(y) {}
+
+    __host__ __device__
+    void operator()(const IndexType i) const
+    {
+        ValueType sum = 0;
+
+        for(IndexType k = row_offsets[i]; k < row_offsets[i + 1]; k++)
+            sum += y_local[row_copies[k]];
+
+        y[i] = sum;
+    }
+};
+
+// y = y_local restricted to the copy of every row in its own part
+template <typename IndexType, typename ValueType>
+struct schwarz_prolongate_owned
+{
+    const IndexType * row_owners;
+    const ValueType * y_local;
+    ValueType * y;
+
+    schwarz_prolongate_owned(const IndexType * row_owners, const ValueType * y_local, ValueType * y)
+        : row_owners(row_owners), y_local(y_local), y(y) {}
+
+    __host__ __device__
+    void operator()(const IndexType i) const
+    {
+        y[i] = y_local[row_owners[i]];
+    }
+};
+
+// y += P y_coarse
+template <typename IndexType, typename ValueType>
+struct schwarz_add_coarse
+{
+    const IndexType * aggregates;
+    const ValueType * y_coarse;
+    ValueType * y;
+
+    schwarz_add_coarse(const IndexType * aggregates, const ValueType * y_coarse, ValueType * y)
+        : aggregates(aggregates), y_coarse(y_coarse), y(y) {}
+
+    __host__ __device__
+    void operator()(const IndexType i) const
+    {
+        y[i] += y_coarse[aggregates[i]];
+    }
+};
+
+} // end namespace detail
+
+
+template <typename ValueType, typename MemorySpace>
+additive_schwarz<ValueType,MemorySpace>
+::additive_schwarz(void)
+    : Parent(), overlap(0), restricted(false), local_solver(schwarz_dense_lu)
+{
+}
+
+template <typename ValueType, typename MemorySpace>
+template <typename MatrixType, typename IndexType, typename MemorySpace2>
+additive_schwarz<ValueType,MemorySpace>
+::additive_schwarz(const MatrixType& A, const cusp::array1d<IndexType,MemorySpace2>& parts,
+                   const size_t overlap, const bool coarse_space, const bool restricted,
+                   const schwarz_local_solver local_solver)
+    : Parent(A.num_rows, A.num_cols, 0), overlap(overlap), restricted(restricted), local_solver(local_solver)
+{
+    cusp::array1d<int,MemorySpace> int_parts(parts);
+
+    setup(A, int_parts);
+
+    if(coarse_space && A.num_rows > 0)
+    {
+        aggregates = int_parts;
+        setup_coarse_space(A);
+    }
+}
+
+template <typename ValueType, typename MemorySpace>
+template <typename MatrixType, typename IndexType, typename MemorySpace2, typename IndexType2, typename MemorySpace3>
+additive_schwarz<ValueType,MemorySpace>
+::additive_schwarz(const MatrixType& A, const cusp::array1d<IndexType,MemorySpace2>& parts,
+                   const cusp::array1d<IndexType2,MemorySpace3>& aggregates,
+                   const size_t overlap, const bool restricted, const schwarz_local_solver local_solver)
+    : Parent(A.num_rows, A.num_cols, 0), overlap(overlap), restricted(restricted), local_solver(local_solver)
+{
+    if(aggregates.size() != A.num_rows)
+        throw cusp::invalid_input_exception("coarse space must assign an aggregate to every row");
+
+    cusp::array1d<int,MemorySpace> int_parts(parts);
+
+    setup(A, int_parts);
+
+    if(A.num_rows > 0)
+    {
+        this->aggregates = aggregates;
+        setup_coarse_space(A);
+    }
+}
+
+template <typename ValueType, typename MemorySpace>
+template <typename MemorySpace2>
+additive_schwarz<ValueType,MemorySpace>
+::additive_schwarz(const additive_schwarz<ValueType,MemorySpace2>& M)
+    : Parent(M.num_rows, M.num_cols, M.num_entries), overlap(M.overlap), restricted(M.restricted),
+      local_solver(M.local_solver), subdomain_rows(M.subdomain_rows), subdomain_offsets(M.subdomain_offsets),
+      subdomain_parts(M.subdomain_parts), row_copies(M.row_copies), row_offsets(M.row_offsets),
+      row_owners(M.row_owners), dense_solver(M.dense_solver), ilu_solver(M.ilu_solver),
+      aggregates(M.aggregates), restriction(M.restriction), coarse_solver(M.coarse_solver),
+      x_local(M.x_local.size()), y_local(M.y_local.size()),
+      x_coarse(M.x_coarse.size()), y_coarse(M.y_coarse.size())
+{
+}
+
+template <typename ValueType, typename MemorySpace>
+template <typename MatrixType>
+void additive_schwarz<ValueType,MemorySpace>
+::setup(const MatrixType& A, const cusp::array1d<int,MemorySpace>& parts)
+{
+    CUSP_PROFILE_SCOPED();
+
+    typedef thrust::counting_iterator<int,MemorySpace> CountingIterator;
+
+    if(A.num_rows != A.num_cols)
+        throw cusp::invalid_input_exception("matrix must be square");
+
+    if(parts.size() != A.num_rows)
+        throw cusp::invalid_input_exception("partition must assign a part to every row");
+
+    const size_t N = A.num_rows;
+
+    if(N == 0)
+    {
+        subdomain_offsets.resize(1, 0);
+        return;
+    }
+
+    if(*thrust::min_element(parts.begin(), parts.end()) < 0)
+        throw cusp::invalid_input_exception("partition contains a negative part index");
+
+    const size_t num_parts = *thrust::max_element(parts.begin(), parts.end()) + 1;
+
+    cusp::csr_matrix<int,ValueType,MemorySpace> A_csr(A);
+
+    // S(i,s) is nonzero when row i belongs to the extended subdomain s,
+    // every level of overlap multiplies S by the pattern of A
+    cusp::csr_matrix<int,ValueType,MemorySpace> S(N, num_parts, N);
+    thrust::sequence(S.row_offsets.begin(), S.row_offsets.end());
+    S.column_indices = parts;
+    thrust::fill(S.values.begin(), S.values.end(), ValueType(1));
+
+    if(overlap > 0)
+    {
+        cusp::csr_matrix<int,ValueType,MemorySpace> G(A_csr);
+        thrust::fill(G.values.begin(), G.values.end(), ValueType(1));
+
+        for(size_t level = 0; level < overlap; level++)
+        {
+            cusp::csr_matrix<int,ValueType,MemorySpace> T;
+            cusp::multiply(G, S, T);
+            S.swap(T);
+            thrust::fill(S.values.begin(), S.values.end(), ValueType(1));
+        }
+    }
+
+    // (subdomain, row) pairs sorted by subdomain, then by row
+    {
+        cusp::coo_matrix<int,ValueType,MemorySpace> C(S);
+
+        subdomain_parts.swap(C.column_indices);
+        subdomain_rows.swap(C.row_indices);
+        cusp::detail::sort_by_row_and_column(subdomain_parts, subdomain_rows, C.values);
+    }
+
+    const size_t M = subdomain_rows.size();
+
+    subdomain_offsets.resize(num_parts + 1);
+    cusp::detail::indices_to_offsets(subdomain_parts, subdomain_offsets);
+
+    // block diagonal matrix of the subdomain problems
+    cusp::array1d<int,MemorySpace> local_offsets(M + 1);
+
+    cusp::detail::stream::for_each(CountingIterator(0), CountingIterator(M),
+                                   detail::schwarz_count_local<int>(thrust::raw_pointer_cast(A_csr.row_offsets.data()),
+                                                                    thrust::raw_pointer_cast(A_csr.column_indices.data()),
+                                                                    thrust::raw_pointer_cast(subdomain_rows.data()),
+                                                                    thrust::raw_pointer_cast(subdomain_parts.data()),
+                                                                    thrust::raw_pointer_cast(subdomain_offsets.data()),
+                                                                    thrust::raw_pointer_cast(local_offsets.data())));
+    local_offsets[M] = 0;
+    thrust::exclusive_scan(local_offsets.begin(), local_offsets.end(), local_offsets.begin());
+
+    cusp::csr_matrix<int,ValueType,MemorySpace> local_matrix(M, M, local_offsets[M]);
+    local_matrix.row_offsets.swap(local_offsets);
+
+    cusp::detail::stream::for_each(CountingIterator(0), CountingIterator(M),
+                                   detail::schwarz_extract_local<int,ValueType>(thrust::raw_pointer_cast(A_csr.row_offsets.data()),
+                                                                                thrust::raw_pointer_cast(A_csr.column_indices.data()),
+                                                                                thrust::raw_pointer_cast(A_csr.values.data()),
+                                                                                thrust::raw_pointer_cast(subdomain_rows.data()),
+                                                                                thrust::raw_pointer_cast(subdomain_parts.data()),
+                                                                                thrust::raw_pointer_cast(subdomain_offsets.data()),
+                                                                                thrust::raw_pointer_cast(local_matrix.row_offsets.data()),
+                                                                                thrust::raw_pointer_cast(local_matrix.column_indices.data()),
+                                                                                thrust::raw_pointer_cast(local_matrix.values.data())));
+
+    // prolongation of the local solutions
+    if(restricted)
+    {
+        row_owners.resize(N);
+
+        cusp::detail::stream::for_each(CountingIterator(0), CountingIterator(M),
+                                       detail::schwarz_owner<int>(thrust::raw_pointer_cast(parts.data()),
+                                                                  thrust::raw_pointer_cast(subdomain_rows.data()),
+                                                                  thrust::raw_pointer_cast(subdomain_parts.data()),
+                                                                  thrust::raw_pointer_cast(row_owners.data())));
+    }
+    else
+    {
+        cusp::array1d<int,MemorySpace> rows(subdomain_rows);
+
+        row_copies.resize(M);
+        thrust::sequence(row_copies.begin(), row_copies.end());
+        thrust::stable_sort_by_key(rows.begin(), rows.end(), row_copies.begin());
+
+        row_offsets.resize(N + 1);
+        cusp::detail::indices_to_offsets(rows, row_offsets);
+    }
+
+    // local solver
+    if(local_solver == schwarz_automatic)
+    {
+        cusp::array1d<int,MemorySpace> sizes(num_parts);
+        thrust::transform(subdomain_offsets.begin() + 1, subdomain_offsets.end(), subdomain_offsets.begin(),
+                          sizes.begin(), thrust::minus<int>());
+
+        const size_t largest = *thrust::max_element(sizes.begin(), sizes.end());
+
+        local_solver = largest <= detail::SCHWARZ_DENSE_LU_LIMIT ? schwarz_dense_lu : schwarz_incomplete_lu;
+    }
+
+    if(local_solver == schwarz_dense_lu)
+        dense_solver = block_jacobi<ValueType,MemorySpace>(local_matrix, subdomain_parts);
+    else
+        ilu_solver = parilu<ValueType,MemorySpace>(local_matrix);
+
+    x_local.resize(M);
+    y_local.resize(M);
+}
+
+template <typename ValueType, typename MemorySpace>
+template <typename MatrixType>
+void additive_schwarz<ValueType,MemorySpace>
+::setup_coarse_space(const MatrixType& A)
+{
+    CUSP_PROFILE_SCOPED();
+
+    const size_t N = A.num_rows;
+
+    cusp::csr_matrix<int,ValueType,MemorySpace> A_csr(A);
+
+    // number the aggregates consecutively, so that none is empty
+    cusp::array1d<int,MemorySpace> labels(aggregates);
+    thrust::sort(labels.begin(), labels.end());
+    labels.erase(thrust::unique(labels.begin(), labels.end()), labels.end());
+    thrust::lower_bound(labels.begin(), labels.end(), aggregates.begin(), aggregates.end(), aggregates.begin());
+
+    const size_t num_aggregates = labels.size();
+
+    // P is constant on every aggregate and A_c = P^T A P
+    cusp::csr_matrix<int,ValueType,MemorySpace> P(N, num_aggregates, N);
+    thrust::sequence(P.row_offsets.begin(), P.row_offsets.end());
+    P.column_indices = aggregates;
+    thrust::fill(P.values.begin(), P.values.end(), ValueType(1));
+
+    cusp::transpose(P, restriction);
+
+    cusp::csr_matrix<int,ValueType,MemorySpace> RA;
+    cusp::csr_matrix<int,ValueType,MemorySpace> A_c;
+    cusp::multiply(restriction, A_csr, RA);
+    cusp::multiply(RA, P, A_c);
+
+    coarse_solver = block_jacobi<ValueType,MemorySpace>(A_c, cusp::array1d<int,MemorySpace>(num_aggregates, 0));
+
+    x_coarse.resize(num_aggregates);
+    y_coarse.resize(num_aggregates);
+}
+
+template <typename ValueType, typename MemorySpace>
+template <typename VectorType1, typename VectorType2>
+void additive_schwarz<ValueType,MemorySpace>
+::operator()(const VectorType1& x, VectorType2& y) const
+{
+    CUSP_PROFILE_SCOPED();
+
+    typedef thrust::counting_iterator<int,MemorySpace> CountingIterator;
+
+    const size_t N = this->num_rows;
+    const size_t M = subdomain_rows.size();
+
+    if(N == 0)
+        return;
+
+    const ValueType * x_ptr = thrust::raw_pointer_cast(&x[0]);
+    ValueType * y_ptr       = thrust::raw_pointer_cast(&y[0]);
+
+    // local solves on every extended subdomain
+    cusp::detail::stream::for_each(CountingIterator(0), CountingIterator(M),
+                                   detail::schwarz_restrict<int,ValueType>(thrust::raw_pointer_cast(subdomain_rows.data()),
+                                                                           x_ptr, thrust::raw_pointer_cast(x_local.data())));
+
+    if(local_solver == schwarz_dense_lu)
+        dense_solver(x_local, y_local);
+    else
+        ilu_solver(x_local, y_local);
+
+    if(restricted)
+        cusp::detail::stream::for_each(CountingIterator(0), CountingIterator(N),
+                                       detail::schwarz_prolongate_owned<int,ValueType>(thrust::raw_pointer_cast(row_owners.data()),
+                                                                                       thrust::raw_pointer_cast(y_local.data()),
+                                                                                       y_ptr));
+    else
+        cusp::detail::stream::for_each(CountingIterator(0), CountingIterator(N),
+                                       detail::schwarz_prolongate<int,ValueType>(thrust::raw_pointer_cast(row_offsets.data()),
+                                                                                 thrust::raw_pointer_cast(row_copies.data()),
+                                                                                 thrust::raw_pointer_cast(y_local.data()),
+                                                                                 y_ptr));
+
+    // coarse correction
+    if(has_coarse_space())
+    {
+        cusp::multiply(restriction, x, x_coarse);
+        coarse_solver(x_coarse, y_coarse);
+
+        cusp::detail::stream::for_each(CountingIterator(0), CountingIterator(N),
+                                       detail::schwarz_add_coarse<int,ValueType>(thrust::raw_pointer_cast(aggregates.data()),
+                                                                                 thrust::raw_pointer_cast(y_coarse.data()),
+                                                                                 y_ptr));
+    }
+}
+
+} // end namespace precond
+} // end namespace cusp
@@ -24,6 +24,7 @@
 #include <cusp/multiply.h>
 #include <cusp/csr_matrix.h>
 
+#include <algorithm>
 #include <map>
 #include <vector>
 
@@ -231,80 +232,165 @@ public:
   }
 }; // end struct ainv_matrix_row
 
+// Row of a factor stored as indices sorted in increasing order with their
+// values.  Rows are short, so the flat arrays are cheaper to search and
+// update than a node-based map and can be updated from many threads.
 template<typename IndexType, typename ValueType>
-void vector_scalar(std::map<IndexType, ValueType> &vec, ValueType scalar)
+struct ainv_sparse_row
 {
-    for (typename std::map<IndexType, ValueType>::iterator vec_iter = vec.begin(); vec_iter != vec.end(); ++vec_iter) {
-      vec_iter->second *= scalar;
+  std::vector<IndexType> indices;
+  std::vector<ValueType> values;
+
+  ainv_sparse_row() {}
+
+  ainv_sparse_row(IndexType i, ValueType v) : indices(1, i), values(1, v) {}
+
+  size_t size() const { return indices.size(); }
+
+  void mult_by_scalar(ValueType scalar) {
+    for (size_t n = 0; n < values.size(); n++)
+      values[n] *= scalar;
+  }
+
+  void insert(size_t position, IndexType i, ValueType v) {
+    indices.insert(indices.begin() + position, i);
+    values.insert(values.begin() + position, v);
+  }
+
+  void erase(size_t position) {
+    indices.erase(indices.begin() + position);
+    values.erase(values.begin() + position);
+  }
+
+  // position of the entry of smallest magnitude
+  size_t min_abs_position() const {
+    size_t position = 0;
+    for (size_t n = 1; n < values.size(); n++)
+      if (less_than_abs(values[n], values[position]))
+        position = n;
+    return position;
+  }
+}; // end struct ainv_sparse_row
+
+// Dense accumulator for the sparse product of A with a row of a factor.
+// Only the touched entries are reset between products.
+template<typename IndexType, typename ValueType>
+struct ainv_accumulator
+{
+  std::vector<ValueType> values;
+  std::vector<char> occupied;
+  std::vector<IndexType> indices;
+
+  ainv_accumulator(size_t n) : values(n, ValueType(0)), occupied(n, 0) {}
+
+  void clear() {
+    for (size_t n = 0; n < indices.size(); n++) {
+      values[indices[n]] = ValueType(0);
+      occupied[indices[n]] = 0;
     }
-}
+    indices.clear();
+  }
+
+  void add(IndexType i, ValueType v) {
+    if (!occupied[i]) {
+      occupied[i] = 1;
+      indices.push_back(i);
+    }
+    values[i] += v;
+  }
+
+  void scale(ValueType scalar) {
+    for (size_t n = 0; n < indices.size(); n++)
+      values[indices[n]] *= scalar;
+  }
+}; // end struct ainv_accumulator
 
 
 template<typename IndexType, typename ValueType>
-void matrix_vector_product(const csr_matrix<IndexType, ValueType, host_memory> &A, const detail::ainv_matrix_row<IndexType, ValueType> &x, std::map<IndexType, ValueType> &b)
+void matrix_vector_product(const csr_matrix<IndexType, ValueType, host_memory> &A, const detail::ainv_sparse_row<IndexType, ValueType> &x, detail::ainv_accumulator<IndexType, ValueType> &b)
 {
     b.clear();
 
-    for (typename detail::ainv_matrix_row<IndexType, ValueType>::const_iterator x_iter = x.begin(); x_iter != x.end(); ++x_iter) {
-        ValueType x_i  = x_iter->second.value;
-        IndexType row = x_iter->first;
+    for (size_t n = 0; n < x.size(); n++) {
+        ValueType x_i  = x.values[n];
+        IndexType row = x.indices[n];
 
         IndexType row_start = A.row_offsets[row];
         IndexType row_end = A.row_offsets[row+1];
 
-        for (IndexType row_j = row_start; row_j < row_end; row_j++) {
-            IndexType col = A.column_indices[row_j];
-            ValueType Aij = A.values[row_j];
-
-            ValueType product = Aij * x_i;
-
-            // add to b if it's not already in b
-            typename std::map<IndexType, ValueType>::iterator b_iter = b.find(col);
-            if (b_iter == b.end())
-                b[col] = product;
-            else 
-                b_iter->second += product;
-        }
+        for (IndexType row_j = row_start; row_j < row_end; row_j++)
+            b.add(A.column_indices[row_j], A.values[row_j] * x_i);
     }
 
+    // the updates visit the entries in increasing order
+    std::sort(b.indices.begin(), b.indices.end());
 }
 
 
 template<typename IndexType, typename ValueType>
-ValueType dot_product(const detail::ainv_matrix_row<IndexType, ValueType> &a, const std::map<IndexType, ValueType> &b) 
+ValueType dot_product(const detail::ainv_sparse_row<IndexType, ValueType> &a, const detail::ainv_accumulator<IndexType, ValueType> &b)
 {
-    typename detail::ainv_matrix_row<IndexType, ValueType>::const_iterator a_iter = a.begin();
-    typename std::map<IndexType, ValueType>::const_iterator b_iter = b.begin();
-
     ValueType sum = 0;
-    while (a_iter != a.end() && b_iter != b.end()) {
-        IndexType a_ind = a_iter->first;
-        IndexType b_ind = b_iter->first;
-        if (a_ind == b_ind) {
-            sum += a_iter->second.value * b_iter->second;
-            ++a_iter;
-            ++b_iter;
-        }
-        else if (a_ind < b_ind) 
-            ++a_iter;
-        else 
-            ++b_iter;
-    }
+
+    for (size_t n = 0; n < a.size(); n++)
+        if (b.occupied[a.indices[n]])
+            sum += a.values[n] * b.values[a.indices[n]];
 
     return sum;
 }
 
 
 template<typename IndexType, typename ValueType>
-void vector_add_inplace_drop(detail::ainv_matrix_row<IndexType, ValueType> &result, ValueType mult, const detail::ainv_matrix_row<IndexType, ValueType> &operand, ValueType tolerance, int nonzeros_this_row)
+void vector_add_inplace_drop(detail::ainv_sparse_row<IndexType, ValueType> &result, ValueType mult, const detail::ainv_sparse_row<IndexType, ValueType> &operand, ValueType tolerance, int nonzeros_this_row)
 {
     // write into result:
     // result += mult * operand
     // but dropping any terms from (mult * operand) if they are less than tolerance
 
-    for (typename detail::ainv_matrix_row<IndexType, ValueType>::const_iterator op_iter = operand.begin(); op_iter != operand.end(); ++op_iter) {
-        IndexType i = op_iter->first;
-        ValueType term = mult * op_iter->second.value;
+    if (nonzeros_this_row < 0) {
+        // without a bound on the row size this is a merge of the two rows
+        std::vector<IndexType> indices;
+        std::vector<ValueType> values;
+        indices.reserve(result.size() + operand.size());
+        values.reserve(result.size() + operand.size());
+
+        size_t r = 0;
+        for (size_t n = 0; n < operand.size(); n++) {
+            IndexType i = operand.indices[n];
+            ValueType term = mult * operand.values[n];
+            ValueType abs_term = term < 0 ? -term : term;
+
+            if (abs_term < tolerance)
+                continue;
+
+            while (r < result.size() && result.indices[r] < i) {
+                indices.push_back(result.indices[r]);
+                values.push_back(result.values[r]);
+                r++;
+            }
+
+            if (r < result.size() && result.indices[r] == i) {
+                indices.push_back(i);
+                values.push_back(result.values[r] + term);
+                r++;
+            }
+            else {
+                indices.push_back(i);
+                values.push_back(term);
+            }
+        }
+
+        indices.insert(indices.end(), result.indices.begin() + r, result.indices.end());
+        values.insert(values.end(), result.values.begin() + r, result.values.end());
+
+        result.indices.swap(indices);
+        result.values.swap(values);
+        return;
+    }
+
+    for (size_t n = 0; n < operand.size(); n++) {
+        IndexType i = operand.indices[n];
+        ValueType term = mult * operand.values[n];
         ValueType abs_term = term < 0 ? -term : term;
 
         if (abs_term < tolerance)
@@ -317,30 +403,64 @@ void vector_add_inplace_drop(detail::ainv_matrix_row<IndexType, ValueType> &resu
         // This idea has been applied to IC factorization, but not to AINV as far as I'm aware.
         // See: Lin, C. and More, J. J. 1999. Incomplete Cholesky Factorizations with Limited Memory. 
         //      SIAM J. Sci. Comput. 21, 1 (Aug. 1999), 24-45. 
+        size_t position = std::lower_bound(result.indices.begin(), result.indices.end(), i) - result.indices.begin();
 
-        // can improve this by storing min idx & min_abs_val for each matrix row, and keeping up to date.
-        // as new entry is considered, skip if below min_val.  Otherwise, remove entry corresponding to min_val, insert new entry, and search for the new min.
-        // best case, this cuts from O(n) to O(1).  Worst case stays as before.
-        // even better: could i just use a heap?  i need both the map for fast inserts & deletes, and a heap to maintain lowest entry
-        // this makes it O(log n) worst case, i think...
-        // idea: instead of using a map for the matrix rows, wrap it in a struct that also maintains a heap of entries by abs_value
-        if (result.has_entry_at_index(i))
-            result.add_to_value(i, term);
-        else {
-          if (nonzeros_this_row < 0 || result.size() < (size_t) nonzeros_this_row) {
+        if (position < result.size() && result.indices[position] == i)
+            result.values[position] += term;
+        else if (result.size() < (size_t) nonzeros_this_row)
             // there is an empty slot left, so just insert
-            result.insert(i, term);
-          }
-          else {
+            result.insert(position, i, term);
+        else if (result.size() == 0)
+            result.insert(0, i, term);
+        else {
             // check if this is larger than one of the existing values.  If so, replace the smallest value.
-            result.replace_min_if_greater(i, term);
-          }
+            size_t min_position = result.min_abs_position();
+
+            if (!less_than_abs(term, result.values[min_position])) {
+                result.erase(min_position);
+                if (min_position < position)
+                    position--;
+                result.insert(position, i, term);
+            }
         }
     }
 }
 
+// Subtracts the multiples u_i / divisor of row j from the rows i > j of
+// the factor.  Each update writes a different row and only reads row j,
+// so the updates of one step run in parallel.
+template<typename IndexType, typename ValueType>
+void ainv_update_rows(std::vector<detail::ainv_sparse_row<IndexType, ValueType> > &factor, IndexType j,
+                      const detail::ainv_accumulator<IndexType, ValueType> &u, ValueType divisor,
+                      const csr_matrix<IndexType, ValueType, host_memory> &A,
+                      ValueType drop_tolerance, int nonzero_per_row, bool lin_dropping, int lin_param)
+{
+    // for i = j+1 to n, skipping where u_i == 0
+    typename std::vector<IndexType>::const_iterator first = std::upper_bound(u.indices.begin(), u.indices.end(), j);
+    const int num_updates = u.indices.end() - first;
+
+    if (num_updates == 0)
+        return;
+
+    const IndexType * targets = &*first;
+
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(dynamic, 8) if(num_updates >= 64)
+#endif
+    for (int k = 0; k < num_updates; k++) {
+        IndexType i = targets[k];
+        int row_count = nonzero_per_row;
+        if (lin_dropping) {
+          row_count = lin_param + (int) (A.row_offsets[i+1] - A.row_offsets[i]); 
+          if (row_count < 1) row_count = 1;
+        }
+
+        detail::vector_add_inplace_drop(factor[i], -u.values[i]/divisor, factor[j], drop_tolerance, row_count);
+    }
+}
+
 template<typename IndexTypeA, typename ValueTypeA, typename IndexTypeB, typename ValueTypeB, typename MemorySpaceB>
-void convert_to_device_csr(const std::vector<detail::ainv_matrix_row<IndexTypeA, ValueTypeA> > &src, cusp::hyb_matrix<IndexTypeB, ValueTypeB, MemorySpaceB> &dst)
+void convert_to_device_csr(const std::vector<detail::ainv_sparse_row<IndexTypeA, ValueTypeA> > &src, cusp::hyb_matrix<IndexTypeB, ValueTypeB, MemorySpaceB> &dst)
 {
   // convert wt to csr
     IndexTypeA nnz = 0;
@@ -356,13 +476,9 @@ void convert_to_device_csr(const std::vector<detail::ainv_matrix_row<IndexTypeA,
     host_src.row_offsets[0] = 0;
 
     for (i=0; i < n; i++) {
-      typename detail::ainv_matrix_row<IndexTypeA, ValueTypeA>::const_iterator src_iter = src[i].begin();
-      while (src_iter != src[i].end()) {
-        host_src.column_indices[pos] = src_iter->first;
-        host_src.values        [pos] = src_iter->second.value;
-
-        ++src_iter;
-        ++pos;
+      for (size_t k = 0; k < src[i].size(); k++, pos++) {
+        host_src.column_indices[pos] = src[i].indices[k];
+        host_src.values        [pos] = src[i].values[k];
       }
       host_src.row_offsets[i+1] = pos;
     }
@@ -383,68 +499,47 @@ template <typename ValueType, typename MemorySpace>
     ::nonsym_bridson_ainv(const MatrixTypeA & A, ValueType drop_tolerance, int nonzero_per_row, bool lin_dropping, int lin_param)
         : linear_operator<ValueType,MemorySpace>(A.num_rows, A.num_cols, A.num_rows)
     {
-        typename MatrixTypeA::index_type n = A.num_rows;
+        typedef typename MatrixTypeA::index_type IndexTypeA;
+        typedef typename MatrixTypeA::value_type ValueTypeA;
+
+        IndexTypeA n = A.num_rows;
         MatrixTypeA At;
         cusp::transpose(A, At);
 
         // copy A, At to host
-        typename cusp::csr_matrix<typename MatrixTypeA::index_type, typename MatrixTypeA::value_type, host_memory> host_A = A;
-        typename cusp::csr_matrix<typename MatrixTypeA::index_type, typename MatrixTypeA::value_type, host_memory> host_At = At;
+        typename cusp::csr_matrix<IndexTypeA, ValueTypeA, host_memory> host_A = A;
+        typename cusp::csr_matrix<IndexTypeA, ValueTypeA, host_memory> host_At = At;
         cusp::array1d<ValueType, host_memory> host_diagonals(n);
         
         // perform factorization
-        typename std::vector<detail::ainv_matrix_row<typename MatrixTypeA::index_type, typename MatrixTypeA::value_type> > wt_factor(n);
-        typename std::vector<detail::ainv_matrix_row<typename MatrixTypeA::index_type, typename MatrixTypeA::value_type> > z_factor(n);
+        typename std::vector<detail::ainv_sparse_row<IndexTypeA, ValueTypeA> > wt_factor(n);
+        typename std::vector<detail::ainv_sparse_row<IndexTypeA, ValueTypeA> > z_factor(n);
 
-        typename MatrixTypeA::index_type i,j;
-        for (i=0; i < n; i++) {
-          wt_factor[i].insert(i, (typename MatrixTypeA::value_type)1); 
-          z_factor[i].insert(i, (typename MatrixTypeA::value_type)1); 
+        IndexTypeA j;
+        for (j=0; j < n; j++) {
+          wt_factor[j] = detail::ainv_sparse_row<IndexTypeA, ValueTypeA>(j, (ValueTypeA)1); 
+          z_factor[j]  = detail::ainv_sparse_row<IndexTypeA, ValueTypeA>(j, (ValueTypeA)1); 
         }
 
-        typename std::map<typename MatrixTypeA::index_type, typename MatrixTypeA::value_type> u, l;
+        detail::ainv_accumulator<IndexTypeA, ValueTypeA> u(n), l(n);
 
         for (j=0; j < n; j++)
         {
           cusp::precond::detail::matrix_vector_product(host_At, wt_factor[j], u);
           cusp::precond::detail::matrix_vector_product(host_A, z_factor[j], l);
-          typename MatrixTypeA::value_type p = detail::dot_product(wt_factor[j], l);
-          //could also do: typename MatrixTypeA::value_type p = detail::dot_product(z_factor[j], u);
+          ValueTypeA p = detail::dot_product(wt_factor[j], l);
+          //could also do: ValueTypeA p = detail::dot_product(z_factor[j], u);
           host_diagonals[j] = (ValueType) (1.0/p);
 
-          // for i = j+1 to n, skipping where u_i == 0
-          // this should be a O(1)-time operation, since u is a sparse vector
-          for (typename std::map<typename MatrixTypeA::index_type,typename MatrixTypeA::value_type>::const_iterator u_iter = u.upper_bound(j); u_iter != u.end(); ++u_iter) {
-            i = u_iter->first;
-            int row_count = nonzero_per_row;
-            if (lin_dropping) {
-              row_count = lin_param + (int) (host_A.row_offsets[i+1] - host_A.row_offsets[i]); 
-              if (row_count < 1) row_count = 1;
-            }
-
-            detail::vector_add_inplace_drop(z_factor[i], -u_iter->second/p, z_factor[j], drop_tolerance, row_count);
-          }
-
-          for (typename std::map<typename MatrixTypeA::index_type,typename MatrixTypeA::value_type>::const_iterator l_iter = l.upper_bound(j); l_iter != l.end(); ++l_iter) {
-            i = l_iter->first;
-            int row_count = nonzero_per_row;
-            if (lin_dropping) {
-              row_count = lin_param + (int) (host_A.row_offsets[i+1] - host_A.row_offsets[i]); 
-              if (row_count < 1) row_count = 1;
-            }
-
-            detail::vector_add_inplace_drop(wt_factor[i], -l_iter->second/p, wt_factor[j], drop_tolerance, row_count);
-          }
-
+          detail::ainv_update_rows(z_factor,  j, u, p, host_A, (ValueTypeA) drop_tolerance, nonzero_per_row, lin_dropping, lin_param);
+          detail::ainv_update_rows(wt_factor, j, l, p, host_A, (ValueTypeA) drop_tolerance, nonzero_per_row, lin_dropping, lin_param);
         }
 
-        // copy w_factor into w, w_t
+        // copy w_factor into w and z
         diagonals = host_diagonals;
 
         // convert wt to csr
-        typename cusp::hyb_matrix<int, ValueType, MemorySpace> w;
         detail::convert_to_device_csr(wt_factor, w);
-        cusp::transpose(w, w_t);
         detail::convert_to_device_csr(z_factor, z);
     }
         
@@ -457,7 +552,7 @@ template <typename ValueType, typename MemorySpace>
         VectorType2 temp1(x.size()), temp2(x.size());
         cusp::multiply(z, x, temp1);
         cusp::blas::xmy(temp1, diagonals, temp2);
-        cusp::multiply(w_t, temp2, y);
+        cusp::multiply_transpose(w, temp2, y);
     }
 
 
@@ -469,48 +564,38 @@ template <typename ValueType, typename MemorySpace>
     ::bridson_ainv(const MatrixTypeA & A, ValueType drop_tolerance, int nonzero_per_row, bool lin_dropping, int lin_param)
         : linear_operator<ValueType,MemorySpace>(A.num_rows, A.num_cols, A.num_rows)
     {
-        typename MatrixTypeA::index_type n = A.num_rows;
+        typedef typename MatrixTypeA::index_type IndexTypeA;
+        typedef typename MatrixTypeA::value_type ValueTypeA;
+
+        IndexTypeA n = A.num_rows;
   
         // copy A to host
-        typename cusp::csr_matrix<typename MatrixTypeA::index_type, typename MatrixTypeA::value_type, host_memory> host_A = A;
+        typename cusp::csr_matrix<IndexTypeA, ValueTypeA, host_memory> host_A = A;
         cusp::array1d<ValueType, host_memory> host_diagonals(n);
         
 
         // perform factorization
-        typename std::vector<detail::ainv_matrix_row<typename MatrixTypeA::index_type, typename MatrixTypeA::value_type> > w_factor(n);
+        typename std::vector<detail::ainv_sparse_row<IndexTypeA, ValueTypeA> > w_factor(n);
 
-        typename MatrixTypeA::index_type i,j;
-        for (i=0; i < n; i++) {
-          w_factor[i].insert(i, (typename MatrixTypeA::value_type)1); 
+        IndexTypeA j;
+        for (j=0; j < n; j++) {
+          w_factor[j] = detail::ainv_sparse_row<IndexTypeA, ValueTypeA>(j, (ValueTypeA)1); 
         }
 
-        typename std::map<typename MatrixTypeA::index_type, typename MatrixTypeA::value_type> u;
+        detail::ainv_accumulator<IndexTypeA, ValueTypeA> u(n);
 
         for (j=0; j < n; j++)
         {
           cusp::precond::detail::matrix_vector_product(host_A, w_factor[j], u);
-          typename MatrixTypeA::value_type p = detail::dot_product(w_factor[j], u);
+          ValueTypeA p = detail::dot_product(w_factor[j], u);
           host_diagonals[j] = (ValueType) (1.0/p);
 
-          // for i = j+1 to n, skipping where u_i == 0
-          // this should be a O(1)-time operation, since u is a sparse vector
-          for (typename std::map<typename MatrixTypeA::index_type,typename MatrixTypeA::value_type>::const_iterator u_iter = u.upper_bound(j); u_iter != u.end(); ++u_iter) {
-            i = u_iter->first;
-            int row_count = nonzero_per_row;
-            if (lin_dropping) {
-              row_count = lin_param + (int) (host_A.row_offsets[i+1] - host_A.row_offsets[i]); 
-              if (row_count < 1) row_count = 1;
-            }
-
-            detail::vector_add_inplace_drop(w_factor[i], -u_iter->second/p, w_factor[j], drop_tolerance, row_count);
-          }
-
+          detail::ainv_update_rows(w_factor, j, u, p, host_A, (ValueTypeA) drop_tolerance, nonzero_per_row, lin_dropping, lin_param);
         }
 
-        // copy diagonal & w_factor into w, w_t
+        // copy diagonal & w_factor into w
         diagonals = host_diagonals;
         detail::convert_to_device_csr(w_factor, w);
-        cusp::transpose(w, w_t);
     }
         
 // linear operator
@@ -522,7 +607,7 @@ template <typename ValueType, typename MemorySpace>
         VectorType2 temp1(x.size()), temp2(x.size());
         cusp::multiply(w, x, temp1);
         cusp::blas::xmy(temp1, diagonals, temp2);
-        cusp::multiply(w_t, temp2, y);
+        cusp::multiply_transpose(w, temp2, y);
     }
 
 
@@ -535,45 +620,36 @@ template <typename ValueType, typename MemorySpace>
     ::scaled_bridson_ainv(const MatrixTypeA & A, ValueType drop_tolerance, int nonzero_per_row, bool lin_dropping, int lin_param)
         : linear_operator<ValueType,MemorySpace>(A.num_rows, A.num_cols, A.num_rows)
     {
-        typename MatrixTypeA::index_type n = A.num_rows;
+        typedef typename MatrixTypeA::index_type IndexTypeA;
+        typedef typename MatrixTypeA::value_type ValueTypeA;
+
+        IndexTypeA n = A.num_rows;
   
         // copy A to host
-        typename cusp::csr_matrix<typename MatrixTypeA::index_type, typename MatrixTypeA::value_type, host_memory> host_A = A;
+        typename cusp::csr_matrix<IndexTypeA, ValueTypeA, host_memory> host_A = A;
         
         // perform factorization
-        typename std::vector<detail::ainv_matrix_row<typename MatrixTypeA::index_type, typename MatrixTypeA::value_type> > w_factor(n);
+        typename std::vector<detail::ainv_sparse_row<IndexTypeA, ValueTypeA> > w_factor(n);
 
-        typename MatrixTypeA::index_type i,j;
-        for (i=0; i < n; i++) {
-          w_factor[i].insert(i, (typename MatrixTypeA::value_type)1); 
+        IndexTypeA j;
+        for (j=0; j < n; j++) {
+          w_factor[j] = detail::ainv_sparse_row<IndexTypeA, ValueTypeA>(j, (ValueTypeA)1); 
         }
 
-        typename std::map<typename MatrixTypeA::index_type, typename MatrixTypeA::value_type> u;
+        detail::ainv_accumulator<IndexTypeA, ValueTypeA> u(n);
 
         for (j=0; j < n; j++) {
           cusp::precond::detail::matrix_vector_product(host_A, w_factor[j], u);
-          typename MatrixTypeA::value_type p = detail::dot_product(w_factor[j], u);
-
-          detail::vector_scalar(u, (typename MatrixTypeA::value_type) (1.0/sqrt((ValueType) p)));
-          w_factor[j].mult_by_scalar((typename MatrixTypeA::value_type) (1.0/sqrt((ValueType) p)));
-
-          // for i = j+1 to n, skipping where u_i == 0
-          // this should be a O(1)-time operation, since u is a sparse vector
-          for (typename std::map<typename MatrixTypeA::index_type,typename MatrixTypeA::value_type>::const_iterator u_iter = u.upper_bound(j); u_iter != u.end(); ++u_iter) {
-            i = u_iter->first;
-            int row_count = nonzero_per_row;
-            if (lin_dropping) {
-              row_count = lin_param + (int) (host_A.row_offsets[i+1] - host_A.row_offsets[i]); 
-              if (row_count < 1) row_count = 1;
-            }
-            detail::vector_add_inplace_drop(w_factor[i], -u_iter->second, w_factor[j], drop_tolerance, row_count);
-          }
+          ValueTypeA p = detail::dot_product(w_factor[j], u);
+
+          u.scale((ValueTypeA) (1.0/sqrt((ValueType) p)));
+          w_factor[j].mult_by_scalar((ValueTypeA) (1.0/sqrt((ValueType) p)));
 
+          detail::ainv_update_rows(w_factor, j, u, (ValueTypeA) 1, host_A, (ValueTypeA) drop_tolerance, nonzero_per_row, lin_dropping, lin_param);
         }
 
         // copy w_factor into w:
         detail::convert_to_device_csr(w_factor, w);
-        cusp::transpose(w, w_t);
     }
 
 template <typename ValueType, typename MemorySpace>
@@ -583,7 +659,7 @@ template <typename ValueType, typename MemorySpace>
     {
         VectorType2 temp1(x.size());
         cusp::multiply(w, x, temp1);
-        cusp::multiply(w_t, temp1, y);
+        cusp::multiply_transpose(w, temp1, y);
     }
 
 } // end namespace precond
@@ -0,0 +1,449 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*! \file block_jacobi.inl
+ *  \brief Inline file for block_jacobi.h
+ */
+
+#include <cusp/coo_matrix.h>
+#include <cusp/exception.h>
+#include <cusp/detail/format_utils.h>
+#include <cusp/detail/stream.h>
+
+#include <thrust/count.h>
+#include <thrust/extrema.h>
+#include <thrust/fill.h>
+#include <thrust/scan.h>
+#include <thrust/scatter.h>
+#include <thrust/sequence.h>
+#include <thrust/sort.h>
+#include <thrust/transform.h>
+#include <thrust/iterator/counting_iterator.h>
+#include <thrust/iterator/zip_iterator.h>
+
+namespace cusp
+{
+namespace precond
+{
+namespace detail
+{
+
+template <typename IndexType>
+struct block_jacobi_consecutive_part
+{
+    IndexType block_size;
+
+    block_jacobi_consecutive_part(IndexType block_size) : block_size(block_size) {}
+
+    __host__ __device__
+    IndexType operator()(const IndexType i) const
+    {
+        return i / block_size;
+    }
+};
+
+template <typename IndexType>
+struct block_jacobi_squared_size
+{
+    const IndexType * block_offsets;
+
+    block_jacobi_squared_size(const IndexType * block_offsets) : block_offsets(block_offsets) {}
+
+    __host__ __device__
+    IndexType operator()(const IndexType b) const
+    {
+        const IndexType n = block_offsets[b + 1] - block_offsets[b];
+        return n * n;
+    }
+};
+
+// copies the entries coupling two rows of the same block into the dense blocks
+template <typename IndexType, typename ValueType>
+struct block_jacobi_extract
+{
+    const IndexType * parts;
+    const IndexType * positions;
+    const IndexType * block_offsets;
+    const IndexType * inverse_offsets;
+    ValueType * blocks;
+
+    block_jacobi_extract(const IndexType * parts, const IndexType * positions, const IndexType * block_offsets,
+                         const IndexType * inverse_offsets, ValueType * blocks)
+        : parts(parts), positions(positions), block_offsets(block_offsets),
+          inverse_offsets(inverse_offsets), blocks(blocks) {}
+
+    template <typename Tuple>
+    __host__ __device__
+    void operator()(const Tuple& t) const
+    {
+        const IndexType i = thrust::get<0>(t);
+        const IndexType j = thrust::get<1>(t);
+        const IndexType b = parts[i];
+
+        if(parts[j] != b)
+            return;
+
+        const IndexType start = block_offsets[b];
+        const IndexType n     = block_offsets[b + 1] - start;
+
+        blocks[inverse_offsets[b] + (positions[i] - start) * n + (positions[j] - start)] = thrust::get<2>(t);
+    }
+};
+
+// inverts block b by LU factorization with partial pivoting, flags singular blocks
+template <typename IndexType, typename ValueType>
+struct block_jacobi_invert
+{
+    const IndexType * block_offsets;
+    const IndexType * inverse_offsets;
+    ValueType * blocks;
+    ValueType * inverses;
+    IndexType * pivots;
+    IndexType * singular;
+
+    block_jacobi_invert(const IndexType * block_offsets, const IndexType * inverse_offsets,
+                        ValueType * blocks, ValueType * inverses, IndexType * pivots, IndexType * singular)
+        : block_offsets(block_offsets), inverse_offsets(inverse_offsets),
+          blocks(blocks), inverses(inverses), pivots(pivots), singular(singular) {}
+
+    __host__ __device__
+    void operator()(const IndexType b) const
+    {
+        const IndexType n = block_offsets[b + 1] - block_offsets[b];
+
+        ValueType * A = blocks   + inverse_offsets[b];
+        ValueType * X = inverses + inverse_offsets[b];
+        IndexType * P = pivots   + block_offsets[b];
+
+        singular[b] = 0;
+
+        // A <- L U with row interchanges P
+        for(IndexType k = 0; k < n; k++)
+        {
+            IndexType p = k;
+            ValueType max_abs = A[k * n + k] < ValueType(0) ? -A[k * n + k] : A[k * n + k];
+
+            for(IndexType i = k + 1; i < n; i++)
+            {
+                const ValueType v = A[i * n + k] < ValueType(0) ? -A[i * n + k] : A[i * n + k];
+
+                if(v > max_abs)
+                {
+                    max_abs = v;
+                    p = i;
+                }
+            }
+
+            if(max_abs == ValueType(0))
+            {
+                singular[b] = 1;
+                return;
+            }
+
+            P[k] = p;
+
+            if(p != k)
+                for(IndexType j = 0; j < n; j++)
+                {
+                    const ValueType temp = A[k * n + j];
+                    A[k * n + j] = A[p * n + j];
+                    A[p * n + j] = temp;
+                }
+
+            for(IndexType i = k + 1; i < n; i++)
+            {
+                const ValueType l = A[i * n + k] / A[k * n + k];
+                A[i * n + k] = l;
+
+                for(IndexType j = k + 1; j < n; j++)
+                    A[i * n + j] -= l * A[k * n + j];
+            }
+        }
+
+        // X <- P I
+        for(IndexType i = 0; i < n; i++)
+            for(IndexType j = 0; j < n; j++)
+                X[i * n + j] = i == j ? ValueType(1) : ValueType(0);
+
+        for(IndexType k = 0; k < n; k++)
+        {
+            const IndexType p = P[k];
+
+            if(p != k)
+                for(IndexType j = 0; j < n; j++)
+                {
+                    const ValueType temp = X[k * n + j];
+                    X[k * n + j] = X[p * n + j];
+                    X[p * n + j] = temp;
+                }
+        }
+
+        // X <- U^-1 L^-1 X
+        for(IndexType c = 0; c < n; c++)
+        {
+            for(IndexType i = 1; i < n; i++)
+                for(IndexType k = 0; k < i; k++)
+                    X[i * n + c] -= A[i * n + k] * X[k * n + c];
+
+            for(IndexType i = n - 1; i >= 0; i--)
+            {
+                for(IndexType k = i + 1; k < n; k++)
+                    X[i * n + c] -= A[i * n + k] * X[k * n + c];
+
+                X[i * n + c] /= A[i * n + i];
+            }
+        }
+    }
+};
+
+// y = D^-1 x for consecutive blocks of BLOCK_SIZE rows, one thread per row
+template <typename IndexType, typename ValueType, unsigned int BLOCK_SIZE>
+struct block_jacobi_fixed_gemv
+{
+    const ValueType * inverses;
+    const ValueType * x;
+    ValueType * y;
+
+    block_jacobi_fixed_gemv(const ValueType * inverses, const ValueType * x, ValueType * y)
+        : inverses(inverses), x(x), y(y) {}
+
+    __host__ __device__
+    void operator()(const IndexType row) const
+    {
+        const IndexType bs = BLOCK_SIZE;
+        const IndexType b  = row / bs;
+        const IndexType r  = row - b * bs;
+
+        const ValueType * Ab = inverses + (b * bs + r) * bs;
+        const ValueType * xb = x + b * bs;
+
+        ValueType sum = 0;
+
+        for(IndexType c = 0; c < bs; c++)
+            sum += Ab[c] * xb[c];
+
+        y[row] = sum;
+    }
+};
+
+// y = D^-1 x for arbitrary blocks, one thread per entry of block_rows
+template <typename IndexType, typename ValueType>
+struct block_jacobi_gemv
+{
+    const IndexType * block_rows;
+    const IndexType * row_blocks;
+    const IndexType * block_offsets;
+    const IndexType * inverse_offsets;
+    const ValueType * inverses;
+    const ValueType * x;
+    ValueType * y;
+
+    block_jacobi_gemv(const IndexType * block_rows, const IndexType * row_blocks, const IndexType * block_offsets,
+                      const IndexType * inverse_offsets, const ValueType * inverses, const ValueType * x, ValueType * y)
+        : block_rows(block_rows), row_blocks(row_blocks), block_offsets(block_offsets),
+          inverse_offsets(inverse_offsets), inverses(inverses), x(x), y(y) {}
+
+    __host__ __device__
+    void operator()(const IndexType p) const
+    {
+        const IndexType b     = row_blocks[p];
+        const IndexType start = block_offsets[b];
+        const IndexType n     = block_offsets[b + 1] - start;
+
+        const ValueType * Ab = inverses + inverse_offsets[b] + (p - start) * n;
+
+        ValueType sum = 0;
+
+        for(IndexType c = 0; c < n; c++)
+            sum += Ab[c] * x[block_rows[start + c]];
+
+        y[block_rows[p]] = sum;
+    }
+};
+
+template <unsigned int BLOCK_SIZE, typename ArrayType, typename VectorType1, typename VectorType2>
+void block_jacobi_fixed_apply(const ArrayType& inverses, const VectorType1& x, VectorType2& y)
+{
+    typedef typename ArrayType::value_type   ValueType;
+    typedef typename ArrayType::memory_space MemorySpace;
+
+    cusp::detail::stream::for_each(thrust::counting_iterator<int,MemorySpace>(0),
+                                   thrust::counting_iterator<int,MemorySpace>(x.size()),
+                                   block_jacobi_fixed_gemv<int,ValueType,BLOCK_SIZE>(thrust::raw_pointer_cast(inverses.data()),
+                                                                                     thrust::raw_pointer_cast(&x[0]),
+                                                                                     thrust::raw_pointer_cast(&y[0])));
+}
+
+} // end namespace detail
+
+
+template <typename ValueType, typename MemorySpace>
+template <typename MatrixType>
+block_jacobi<ValueType,MemorySpace>
+::block_jacobi(const MatrixType& A, const size_t block_size)
+    : Parent(A.num_rows, A.num_cols, 0),
+      block_size(block_size > 0 && A.num_rows % block_size == 0 ? block_size : 0)
+{
+    if(block_size == 0)
+        throw cusp::invalid_input_exception("block size must be positive");
+
+    cusp::array1d<int,MemorySpace> parts(A.num_rows);
+    thrust::transform(thrust::counting_iterator<int>(0), thrust::counting_iterator<int>(A.num_rows),
+                      parts.begin(), detail::block_jacobi_consecutive_part<int>(block_size));
+
+    setup(A, parts);
+}
+
+template <typename ValueType, typename MemorySpace>
+template <typename MatrixType, typename IndexType, typename MemorySpace2>
+block_jacobi<ValueType,MemorySpace>
+::block_jacobi(const MatrixType& A, const cusp::array1d<IndexType,MemorySpace2>& parts)
+    : Parent(A.num_rows, A.num_cols, 0), block_size(0)
+{
+    if(parts.size() != A.num_rows)
+        throw cusp::invalid_input_exception("partition must assign a block to every row");
+
+    cusp::array1d<int,MemorySpace> int_parts(parts);
+
+    setup(A, int_parts);
+}
+
+template <typename ValueType, typename MemorySpace>
+template <typename MemorySpace2>
+block_jacobi<ValueType,MemorySpace>
+::block_jacobi(const block_jacobi<ValueType,MemorySpace2>& M)
+    : Parent(M.num_rows, M.num_cols, M.num_entries), block_size(M.block_size),
+      block_rows(M.block_rows), block_offsets(M.block_offsets), row_blocks(M.row_blocks),
+      inverse_offsets(M.inverse_offsets), inverses(M.inverses)
+{
+}
+
+template <typename ValueType, typename MemorySpace>
+template <typename MatrixType, typename ArrayType>
+void block_jacobi<ValueType,MemorySpace>
+::setup(const MatrixType& A, const ArrayType& parts)
+{
+    CUSP_PROFILE_SCOPED();
+
+    typedef thrust::counting_iterator<int,MemorySpace> CountingIterator;
+
+    if(A.num_rows != A.num_cols)
+        throw cusp::invalid_input_exception("matrix must be square");
+
+    const size_t N = A.num_rows;
+
+    if(N == 0)
+    {
+        block_offsets.resize(1, 0);
+        inverse_offsets.resize(1, 0);
+        return;
+    }
+
+    if(*thrust::min_element(parts.begin(), parts.end()) < 0)
+        throw cusp::invalid_input_exception("partition contains a negative block index");
+
+    const size_t num_blocks = *thrust::max_element(parts.begin(), parts.end()) + 1;
+
+    // group the rows by block, keeping their order within each block
+    row_blocks = parts;
+    block_rows.resize(N);
+    thrust::sequence(block_rows.begin(), block_rows.end());
+    thrust::stable_sort_by_key(row_blocks.begin(), row_blocks.end(), block_rows.begin());
+
+    block_offsets.resize(num_blocks + 1);
+    cusp::detail::indices_to_offsets(row_blocks, block_offsets);
+
+    // position of each row in block_rows
+    cusp::array1d<int,MemorySpace> positions(N);
+    thrust::scatter(CountingIterator(0), CountingIterator(N), block_rows.begin(), positions.begin());
+
+    // storage of the dense blocks
+    inverse_offsets.resize(num_blocks + 1);
+    thrust::transform(CountingIterator(0), CountingIterator(num_blocks), inverse_offsets.begin(),
+                      detail::block_jacobi_squared_size<int>(thrust::raw_pointer_cast(block_offsets.data())));
+    inverse_offsets[num_blocks] = 0;
+    thrust::exclusive_scan(inverse_offsets.begin(), inverse_offsets.end(), inverse_offsets.begin());
+
+    const size_t num_values = inverse_offsets[num_blocks];
+
+    cusp::array1d<ValueType,MemorySpace> blocks(num_values, ValueType(0));
+    inverses.resize(num_values);
+
+    {
+        cusp::coo_matrix<int,ValueType,MemorySpace> C(A);
+
+        cusp::detail::stream::for_each(thrust::make_zip_iterator(thrust::make_tuple(C.row_indices.begin(), C.column_indices.begin(), C.values.begin())),
+                                       thrust::make_zip_iterator(thrust::make_tuple(C.row_indices.end(),   C.column_indices.end(),   C.values.end())),
+                                       detail::block_jacobi_extract<int,ValueType>(thrust::raw_pointer_cast(parts.data()),
+                                                                                   thrust::raw_pointer_cast(positions.data()),
+                                                                                   thrust::raw_pointer_cast(block_offsets.data()),
+                                                                                   thrust::raw_pointer_cast(inverse_offsets.data()),
+                                                                                   thrust::raw_pointer_cast(blocks.data())));
+    }
+
+    // batched LU factorization and inversion
+    cusp::array1d<int,MemorySpace> pivots(N);
+    cusp::array1d<int,MemorySpace> singular(num_blocks);
+
+    cusp::detail::stream::for_each(CountingIterator(0), CountingIterator(num_blocks),
+                                   detail::block_jacobi_invert<int,ValueType>(thrust::raw_pointer_cast(block_offsets.data()),
+                                                                              thrust::raw_pointer_cast(inverse_offsets.data()),
+                                                                              thrust::raw_pointer_cast(blocks.data()),
+                                                                              thrust::raw_pointer_cast(inverses.data()),
+                                                                              thrust::raw_pointer_cast(pivots.data()),
+                                                                              thrust::raw_pointer_cast(singular.data())));
+
+    if(thrust::count(singular.begin(), singular.end(), 1) > 0)
+        throw cusp::runtime_exception("block_jacobi: singular diagonal block");
+
+    Parent::num_entries = num_values;
+}
+
+template <typename ValueType, typename MemorySpace>
+template <typename VectorType1, typename VectorType2>
+void block_jacobi<ValueType,MemorySpace>
+::operator()(const VectorType1& x, VectorType2& y) const
+{
+    CUSP_PROFILE_SCOPED();
+
+    if(x.size() == 0)
+        return;
+
+    switch(block_size)
+    {
+        case 1:  detail::block_jacobi_fixed_apply<1>(inverses, x, y); return;
+        case 2:  detail::block_jacobi_fixed_apply<2>(inverses, x, y); return;
+        case 3:  detail::block_jacobi_fixed_apply<3>(inverses, x, y); return;
+        case 4:  detail::block_jacobi_fixed_apply<4>(inverses, x, y); return;
+        case 5:  detail::block_jacobi_fixed_apply<5>(inverses, x, y); return;
+        case 6:  detail::block_jacobi_fixed_apply<6>(inverses, x, y); return;
+        default: break;
+    }
+
+    cusp::detail::stream::for_each(thrust::counting_iterator<int,MemorySpace>(0),
+                                   thrust::counting_iterator<int,MemorySpace>(x.size()),
+                                   detail::block_jacobi_gemv<int,ValueType>(thrust::raw_pointer_cast(block_rows.data()),
+                                                                            thrust::raw_pointer_cast(row_blocks.data()),
+                                                                            thrust::raw_pointer_cast(block_offsets.data()),
+                                                                            thrust::raw_pointer_cast(inverse_offsets.data()),
+                                                                            thrust::raw_pointer_cast(inverses.data()),
+                                                                            thrust::raw_pointer_cast(&x[0]),
+                                                                            thrust::raw_pointer_cast(&y[0])));
+}
+
+} // end namespace precond
+} // end namespace cusp
+
@@ -0,0 +1,423 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*! \file ilu.inl
+ *  \brief Inline file for ilu.h
+ */
+
+#include <cusp/blas.h>
+#include <cusp/coo_matrix.h>
+#include <cusp/csr_matrix.h>
+#include <cusp/exception.h>
+#include <cusp/multiply.h>
+#include <cusp/transpose.h>
+
+#include <cmath>
+#include <vector>
+
+namespace cusp
+{
+namespace precond
+{
+namespace detail
+{
+
+// host copy of A with the columns of each row sorted
+template <typename MatrixType, typename IndexType, typename ValueType>
+void ilu_host_matrix(const MatrixType& A, cusp::csr_matrix<IndexType,ValueType,cusp::host_memory>& H)
+{
+    if(A.num_rows != A.num_cols)
+        throw cusp::invalid_input_exception("matrix must be square");
+
+    cusp::coo_matrix<IndexType,ValueType,cusp::host_memory> C(A);
+    C.sort_by_row_and_column();
+
+    H = C;
+}
+
+// position of the diagonal entry of each row
+template <typename IndexType, typename ValueType>
+void ilu_diagonal_positions(const cusp::csr_matrix<IndexType,ValueType,cusp::host_memory>& A,
+                            std::vector<IndexType>& diagonal)
+{
+    diagonal.assign(A.num_rows, IndexType(-1));
+
+    for(size_t i = 0; i < A.num_rows; i++)
+        for(IndexType jj = A.row_offsets[i]; jj < A.row_offsets[i + 1]; jj++)
+            if(A.column_indices[jj] == IndexType(i))
+                diagonal[i] = jj;
+
+    for(size_t i = 0; i < A.num_rows; i++)
+        if(diagonal[i] == IndexType(-1))
+            throw cusp::invalid_input_exception("incomplete factorization requires every diagonal entry to be stored");
+}
+
+// copies the entries of A below (lower) or above the diagonal
+template <typename IndexType, typename ValueType>
+void ilu_strict_part(const cusp::csr_matrix<IndexType,ValueType,cusp::host_memory>& A,
+                     cusp::csr_matrix<IndexType,ValueType,cusp::host_memory>& S,
+                     const bool lower)
+{
+    size_t num_entries = 0;
+
+    for(size_t i = 0; i < A.num_rows; i++)
+        for(IndexType jj = A.row_offsets[i]; jj < A.row_offsets[i + 1]; jj++)
+            if(lower ? A.column_indices[jj] < IndexType(i) : A.column_indices[jj] > IndexType(i))
+                num_entries++;
+
+    S.resize(A.num_rows, A.num_cols, num_entries);
+
+    size_t n = 0;
+    S.row_offsets[0] = 0;
+
+    for(size_t i = 0; i < A.num_rows; i++)
+    {
+        for(IndexType jj = A.row_offsets[i]; jj < A.row_offsets[i + 1]; jj++)
+        {
+            if(lower ? A.column_indices[jj] < IndexType(i) : A.column_indices[jj] > IndexType(i))
+            {
+                S.column_indices[n] = A.column_indices[jj];
+                S.values[n]         = A.values[jj];
+                n++;
+            }
+        }
+
+        S.row_offsets[i + 1] = n;
+    }
+}
+
+// in place ILU(0) of a matrix with sorted rows (IKJ variant), the
+// multipliers of L overwrite the lower triangle and U the rest
+template <typename IndexType, typename ValueType>
+void ilu0_factorize(cusp::csr_matrix<IndexType,ValueType,cusp::host_memory>& A)
+{
+    const size_t N = A.num_rows;
+
+    std::vector<IndexType> diagonal;
+    ilu_diagonal_positions(A, diagonal);
+
+    std::vector<IndexType> position(N, IndexType(-1));
+
+    for(size_t i = 0; i < N; i++)
+    {
+        const IndexType row_start = A.row_offsets[i];
+        const IndexType row_end   = A.row_offsets[i + 1];
+
+        for(IndexType jj = row_start; jj < row_end; jj++)
+            position[A.column_indices[jj]] = jj;
+
+        for(IndexType kk = row_start; kk < diagonal[i]; kk++)
+        {
+            const IndexType k = A.column_indices[kk];
+            const ValueType pivot = A.values[diagonal[k]];
+
+            if(pivot == ValueType(0))
+                throw cusp::runtime_exception("zero pivot in ILU(0) factorization");
+
+            const ValueType multiplier = A.values[kk] / pivot;
+            A.values[kk] = multiplier;
+
+            // row i -= multiplier * (row k of U), within the pattern of row i
+            for(IndexType jj = diagonal[k] + 1; jj < A.row_offsets[k + 1]; jj++)
+            {
+                const IndexType p = position[A.column_indices[jj]];
+
+                if(p != IndexType(-1))
+                    A.values[p] -= multiplier * A.values[jj];
+            }
+        }
+
+        for(IndexType jj = row_start; jj < row_end; jj++)
+            position[A.column_indices[jj]] = IndexType(-1);
+    }
+}
+
+// IC(0) of the lower triangle of a matrix with sorted rows, returns the
+// strict lower part of L and its diagonal
+template <typename IndexType, typename ValueType>
+void ic0_factorize(const cusp::csr_matrix<IndexType,ValueType,cusp::host_memory>& A,
+                   cusp::csr_matrix<IndexType,ValueType,cusp::host_memory>& S,
+                   cusp::array1d<ValueType,cusp::host_memory>& D)
+{
+    const size_t N = A.num_rows;
+
+    std::vector<IndexType> diagonal;
+    ilu_diagonal_positions(A, diagonal);
+
+    ilu_strict_part(A, S, true);
+
+    D.resize(N);
+    for(size_t i = 0; i < N; i++)
+        D[i] = A.values[diagonal[i]];
+
+    std::vector<IndexType> position(N, IndexType(-1));
+
+    for(size_t i = 0; i < N; i++)
+    {
+        const IndexType row_start = S.row_offsets[i];
+        const IndexType row_end   = S.row_offsets[i + 1];
+
+        for(IndexType kk = row_start; kk < row_end; kk++)
+            position[S.column_indices[kk]] = kk;
+
+        ValueType d = D[i];
+
+        // L_ik = (A_ik - sum_{j < k} L_ij L_kj) / L_kk, the entries L_ij
+        // with j < k precede L_ik in the sorted row
+        for(IndexType kk = row_start; kk < row_end; kk++)
+        {
+            const IndexType k = S.column_indices[kk];
+
+            ValueType sum = S.values[kk];
+
+            for(IndexType jj = S.row_offsets[k]; jj < S.row_offsets[k + 1]; jj++)
+            {
+                const IndexType p = position[S.column_indices[jj]];
+
+                if(p != IndexType(-1))
+                    sum -= S.values[p] * S.values[jj];
+            }
+
+            S.values[kk] = sum / D[k];
+            d -= S.values[kk] * S.values[kk];
+        }
+
+        if(!(d > ValueType(0)))
+            throw cusp::runtime_exception("nonpositive pivot in IC(0) factorization");
+
+        D[i] = std::sqrt(d);
+
+        for(IndexType kk = row_start; kk < row_end; kk++)
+            position[S.column_indices[kk]] = IndexType(-1);
+    }
+}
+
+template <typename ValueType, typename MemorySpace, typename MatrixType>
+void ilu0_setup(const MatrixType& A,
+                triangular_factor<int,ValueType,MemorySpace>& L,
+                triangular_factor<int,ValueType,MemorySpace>& U)
+{
+    CUSP_PROFILE_SCOPED();
+
+    cusp::csr_matrix<int,ValueType,cusp::host_memory> LU;
+    ilu_host_matrix(A, LU);
+
+    ilu0_factorize(LU);
+
+    std::vector<int> diagonal;
+    ilu_diagonal_positions(LU, diagonal);
+
+    cusp::array1d<ValueType,cusp::host_memory> ones(LU.num_rows, ValueType(1));
+    cusp::array1d<ValueType,cusp::host_memory> D(LU.num_rows);
+    for(size_t i = 0; i < LU.num_rows; i++)
+        D[i] = LU.values[diagonal[i]];
+
+    cusp::csr_matrix<int,ValueType,cusp::host_memory> S;
+
+    ilu_strict_part(LU, S, true);
+    L = triangular_factor<int,ValueType,MemorySpace>(S, ones, true);
+
+    ilu_strict_part(LU, S, false);
+    U = triangular_factor<int,ValueType,MemorySpace>(S, D, false);
+}
+
+template <typename ValueType, typename MemorySpace, typename MatrixType>
+void ic0_setup(const MatrixType& A,
+               triangular_factor<int,ValueType,MemorySpace>& L,
+               triangular_factor<int,ValueType,MemorySpace>& U)
+{
+    CUSP_PROFILE_SCOPED();
+
+    cusp::csr_matrix<int,ValueType,cusp::host_memory> H;
+    ilu_host_matrix(A, H);
+
+    cusp::csr_matrix<int,ValueType,cusp::host_memory> S;
+    cusp::array1d<ValueType,cusp::host_memory> D;
+
+    ic0_factorize(H, S, D);
+
+    L = triangular_factor<int,ValueType,MemorySpace>(S, D, true);
+
+    // L^T is stored by rows for the backward solve
+    cusp::csr_matrix<int,ValueType,cusp::host_memory> St;
+    cusp::transpose(S, St);
+
+    U = triangular_factor<int,ValueType,MemorySpace>(St, D, false);
+}
+
+// y <- U^-1 L^-1 x
+template <typename Factor, typename Array1, typename Array2, typename Array3>
+void ilu_apply(const Factor& L, const Factor& U, const Array1& x, Array2& temp, Array3& y)
+{
+    L.solve(x, temp);
+    U.solve(temp, y);
+}
+
+// x <- x + U^-1 L^-1 (b - A x)
+template <typename Factor, typename MatrixType, typename Array1, typename Array2, typename Array3, typename Array4>
+void ilu_postsmooth(const Factor& L, const Factor& U, const MatrixType& A, const Array1& b, Array2& x,
+                    Array3& temp, Array4& residual)
+{
+    typedef typename Array2::value_type ValueType;
+
+    cusp::multiply(A, x, residual);
+    cusp::blas::axpby(b, residual, residual, ValueType(1), ValueType(-1));
+
+    ilu_apply(L, U, residual, temp, residual);
+
+    cusp::blas::axpy(residual, x, ValueType(1));
+}
+
+} // end namespace detail
+
+
+///////////
+// ilu0  //
+///////////
+template <typename ValueType, typename MemorySpace>
+ilu0<ValueType,MemorySpace>
+::ilu0(void)
+{
+}
+
+template <typename ValueType, typename MemorySpace>
+template <typename MatrixType>
+ilu0<ValueType,MemorySpace>
+::ilu0(const MatrixType& A)
+    : Parent(A.num_rows, A.num_cols, A.num_entries), temp(A.num_rows), residual(A.num_rows)
+{
+    detail::ilu0_setup(A, L, U);
+}
+
+template <typename ValueType, typename MemorySpace>
+template <typename MemorySpace2>
+ilu0<ValueType,MemorySpace>
+::ilu0(const ilu0<ValueType,MemorySpace2>& M)
+    : Parent(M.num_rows, M.num_cols, M.num_entries), L(M.L), U(M.U), temp(M.temp), residual(M.residual)
+{
+}
+
+template <typename ValueType, typename MemorySpace>
+template <typename MatrixType>
+ilu0<ValueType,MemorySpace>
+::ilu0(const cusp::precond::aggregation::sa_level<MatrixType>& sa_level)
+    : Parent(sa_level.A_.num_rows, sa_level.A_.num_cols, sa_level.A_.num_entries),
+      temp(sa_level.A_.num_rows), residual(sa_level.A_.num_rows)
+{
+    detail::ilu0_setup(sa_level.A_, L, U);
+}
+
+template <typename ValueType, typename MemorySpace>
+template <typename VectorType1, typename VectorType2>
+void ilu0<ValueType,MemorySpace>
+::operator()(const VectorType1& x, VectorType2& y) const
+{
+    CUSP_PROFILE_SCOPED();
+
+    detail::ilu_apply(L, U, x, temp, y);
+}
+
+template <typename ValueType, typename MemorySpace>
+template <typename MatrixType, typename VectorType1, typename VectorType2>
+void ilu0<ValueType,MemorySpace>
+::presmooth(const MatrixType&, const VectorType1& b, VectorType2& x)
+{
+    CUSP_PROFILE_SCOPED();
+
+    // x <- U^-1 L^-1 b
+    detail::ilu_apply(L, U, b, temp, x);
+}
+
+template <typename ValueType, typename MemorySpace>
+template <typename MatrixType, typename VectorType1, typename VectorType2>
+void ilu0<ValueType,MemorySpace>
+::postsmooth(const MatrixType& A, const VectorType1& b, VectorType2& x)
+{
+    CUSP_PROFILE_SCOPED();
+
+    detail::ilu_postsmooth(L, U, A, b, x, temp, residual);
+}
+
+///////////
+// ic0   //
+///////////
+template <typename ValueType, typename MemorySpace>
+ic0<ValueType,MemorySpace>
+::ic0(void)
+{
+}
+
+template <typename ValueType, typename MemorySpace>
+template <typename MatrixType>
+ic0<ValueType,MemorySpace>
+::ic0(const MatrixType& A)
+    : Parent(A.num_rows, A.num_cols, A.num_entries), temp(A.num_rows), residual(A.num_rows)
+{
+    detail::ic0_setup(A, L, U);
+}
+
+template <typename ValueType, typename MemorySpace>
+template <typename MemorySpace2>
+ic0<ValueType,MemorySpace>
+::ic0(const ic0<ValueType,MemorySpace2>& M)
+    : Parent(M.num_rows, M.num_cols, M.num_entries), L(M.L), U(M.U), temp(M.temp), residual(M.residual)
+{
+}
+
+template <typename ValueType, typename MemorySpace>
+template <typename MatrixType>
+ic0<ValueType,MemorySpace>
+::ic0(const cusp::precond::aggregation::sa_level<MatrixType>& sa_level)
+    : Parent(sa_level.A_.num_rows, sa_level.A_.num_cols, sa_level.A_.num_entries),
+      temp(sa_level.A_.num_rows), residual(sa_level.A_.num_rows)
+{
+    detail::ic0_setup(sa_level.A_, L, U);
+}
+
+template <typename ValueType, typename MemorySpace>
+template <typename VectorType1, typename VectorType2>
+void ic0<ValueType,MemorySpace>
+::operator()(const VectorType1& x, VectorType2& y) const
+{
+    CUSP_PROFILE_SCOPED();
+
+    detail::ilu_apply(L, U, x, temp, y);
+}
+
+template <typename ValueType, typename MemorySpace>
+template <typename MatrixType, typename VectorType1, typename VectorType2>
+void ic0<ValueType,MemorySpace>
+::presmooth(const MatrixType&, const VectorType1& b, VectorType2& x)
+{
+    CUSP_PROFILE_SCOPED();
+
+    // x <- L^-T L^-1 b
+    detail::ilu_apply(L, U, b, temp, x);
+}
+
+template <typename ValueType, typename MemorySpace>
+template <typename MatrixType, typename VectorType1, typename VectorType2>
+void ic0<ValueType,MemorySpace>
+::postsmooth(const MatrixType& A, const VectorType1& b, VectorType2& x)
+{
+    CUSP_PROFILE_SCOPED();
+
+    detail::ilu_postsmooth(L, U, A, b, x, temp, residual);
+}
+
+} // end namespace precond
+} // end namespace cusp
+
@@ -0,0 +1,502 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*! \file parilu.inl
+ *  \brief Inline file for parilu.h
+ */
+
+#include <cusp/array1d.h>
+#include <cusp/blas.h>
+#include <cusp/coo_matrix.h>
+#include <cusp/csr_matrix.h>
+#include <cusp/exception.h>
+#include <cusp/multiply.h>
+#include <cusp/transpose.h>
+#include <cusp/detail/format_utils.h>
+
+#include <thrust/copy.h>
+#include <thrust/count.h>
+#include <thrust/functional.h>
+#include <thrust/gather.h>
+#include <thrust/sequence.h>
+#include <thrust/sort.h>
+#include <thrust/transform.h>
+#include <thrust/iterator/counting_iterator.h>
+#include <thrust/iterator/zip_iterator.h>
+
+#include <cmath>
+
+namespace cusp
+{
+namespace precond
+{
+namespace detail
+{
+
+// selects the entries (row, column) with Compare()(row, column)
+template <typename Compare>
+struct parilu_entry_is
+{
+    template <typename Tuple>
+    __host__ __device__
+    bool operator()(const Tuple& t) const
+    {
+        return Compare()(thrust::get<0>(t), thrust::get<1>(t));
+    }
+};
+
+template <typename T>
+struct parilu_reciprocal : public thrust::unary_function<T,T>
+{
+    __host__ __device__
+    T operator()(const T& v) const
+    {
+        return T(1) / v;
+    }
+};
+
+// initial factors L = A D^-1 and U = A, or L = A D^-1/2 when symmetric
+template <typename IndexType, typename ValueType>
+struct parilu_initial
+{
+    const IndexType * rows;
+    const IndexType * cols;
+    const ValueType * a;
+    const IndexType * diagonal;
+    bool symmetric;
+
+    parilu_initial(const IndexType * rows, const IndexType * cols, const ValueType * a,
+                   const IndexType * diagonal, bool symmetric)
+        : rows(rows), cols(cols), a(a), diagonal(diagonal), symmetric(symmetric) {}
+
+    __host__ __device__
+    ValueType operator()(const IndexType e) const
+    {
+        const IndexType i = rows[e];
+        const IndexType j = cols[e];
+
+        if(symmetric)
+            return i == j ? sqrt(a[e]) : a[e] / sqrt(a[diagonal[j]]);
+        else
+            return i > j ? a[e] / a[diagonal[j]] : a[e];
+    }
+};
+
+// one fixed-point update of the factor entry e = (i,j)
+//
+//   l_ij = (a_ij - sum_{k < j} l_ik u_kj) / u_jj    i > j
+//   u_ij =  a_ij - sum_{k < i} l_ik u_kj            i <= j
+//
+// row i of L is traversed in the pattern and column j of U through
+// u_offsets/u_rows/u_entries, for IC(0) U = L^T and u_ii = sqrt(...)
+template <typename IndexType, typename ValueType>
+struct parilu_sweep
+{
+    const IndexType * row_offsets;
+    const IndexType * rows;
+    const IndexType * cols;
+    const ValueType * a;
+    const IndexType * u_offsets;
+    const IndexType * u_rows;
+    const IndexType * u_entries;
+    const IndexType * diagonal;
+    const ValueType * factors;
+    bool symmetric;
+
+    parilu_sweep(const IndexType * row_offsets, const IndexType * rows, const IndexType * cols, const ValueType * a,
+                 const IndexType * u_offsets, const IndexType * u_rows, const IndexType * u_entries,
+                 const IndexType * diagonal, const ValueType * factors, bool symmetric)
+        : row_offsets(row_offsets), rows(rows), cols(cols), a(a),
+          u_offsets(u_offsets), u_rows(u_rows), u_entries(u_entries),
+          diagonal(diagonal), factors(factors), symmetric(symmetric) {}
+
+    __host__ __device__
+    ValueType operator()(const IndexType e) const
+    {
+        const IndexType i = rows[e];
+        const IndexType j = cols[e];
+        const IndexType m = i < j ? i : j;
+
+        IndexType p = row_offsets[i];
+        IndexType q = u_offsets[j];
+
+        const IndexType p_end = row_offsets[i + 1];
+        const IndexType q_end = u_offsets[j + 1];
+
+        ValueType sum = a[e];
+
+        while(p < p_end && q < q_end)
+        {
+            const IndexType kp = cols[p];
+            const IndexType kq = u_rows[q];
+
+            if(kp >= m || kq >= m)
+                break;
+
+            if(kp == kq)
+            {
+                sum -= factors[p] * factors[u_entries[q]];
+                p++;
+                q++;
+            }
+            else if(kp < kq)
+            {
+                p++;
+            }
+            else
+            {
+                q++;
+            }
+        }
+
+        if(i > j)
+            return sum / factors[diagonal[j]];
+        else if(symmetric)
+            return sqrt(sum);
+        else
+            return sum;
+    }
+};
+
+// extracts the entries of (rows, cols, values) selected by Compare
+template <typename Compare, typename IndexArray, typename ValueArray, typename MatrixType>
+void parilu_extract(const size_t num_rows, const IndexArray& rows, const IndexArray& cols,
+                    const ValueArray& values, MatrixType& S)
+{
+    typedef typename IndexArray::value_type   IndexType;
+    typedef typename ValueArray::value_type   ValueType;
+    typedef typename IndexArray::memory_space MemorySpace;
+
+    const size_t num_entries =
+        thrust::count_if(thrust::make_zip_iterator(thrust::make_tuple(rows.begin(), cols.begin())),
+                         thrust::make_zip_iterator(thrust::make_tuple(rows.end(),   cols.end())),
+                         parilu_entry_is<Compare>());
+
+    cusp::coo_matrix<IndexType,ValueType,MemorySpace> C(num_rows, num_rows, num_entries);
+
+    thrust::copy_if(thrust::make_zip_iterator(thrust::make_tuple(rows.begin(), cols.begin(), values.begin())),
+                    thrust::make_zip_iterator(thrust::make_tuple(rows.end(),   cols.end(),   values.end())),
+                    thrust::make_zip_iterator(thrust::make_tuple(rows.begin(), cols.begin())),
+                    thrust::make_zip_iterator(thrust::make_tuple(C.row_indices.begin(), C.column_indices.begin(), C.values.begin())),
+                    parilu_entry_is<Compare>());
+
+    S = C;
+}
+
+template <typename ValueType, typename MemorySpace, typename MatrixType>
+void parilu_setup(const MatrixType& A, const bool symmetric, const size_t sweeps, const size_t solve_iterations,
+                  jacobi_triangular_factor<int,ValueType,MemorySpace>& L,
+                  jacobi_triangular_factor<int,ValueType,MemorySpace>& U)
+{
+    CUSP_PROFILE_SCOPED();
+
+    typedef int IndexType;
+    typedef thrust::counting_iterator<IndexType,MemorySpace> CountingIterator;
+
+    if(A.num_rows != A.num_cols)
+        throw cusp::invalid_input_exception("matrix must be square");
+
+    const size_t N = A.num_rows;
+
+    // the pattern, only the lower triangle is used when symmetric
+    cusp::coo_matrix<IndexType,ValueType,MemorySpace> C;
+    {
+        cusp::coo_matrix<IndexType,ValueType,MemorySpace> B(A);
+
+        if(symmetric)
+            parilu_extract< thrust::greater_equal<IndexType> >(N, B.row_indices, B.column_indices, B.values, C);
+        else
+            C.swap(B);
+
+        C.sort_by_row_and_column();
+    }
+
+    const size_t num_entries = C.num_entries;
+
+    const size_t num_diagonals =
+        thrust::count_if(thrust::make_zip_iterator(thrust::make_tuple(C.row_indices.begin(), C.column_indices.begin())),
+                         thrust::make_zip_iterator(thrust::make_tuple(C.row_indices.end(),   C.column_indices.end())),
+                         parilu_entry_is< thrust::equal_to<IndexType> >());
+
+    if(num_diagonals != N)
+        throw cusp::invalid_input_exception("incomplete factorization requires every diagonal entry to be stored");
+
+    cusp::array1d<IndexType,MemorySpace> row_offsets(N + 1);
+    cusp::detail::indices_to_offsets(C.row_indices, row_offsets);
+
+    // position of the diagonal entry of each row
+    cusp::array1d<IndexType,MemorySpace> diagonal(N);
+    thrust::copy_if(CountingIterator(0), CountingIterator(num_entries),
+                    thrust::make_zip_iterator(thrust::make_tuple(C.row_indices.begin(), C.column_indices.begin())),
+                    diagonal.begin(),
+                    parilu_entry_is< thrust::equal_to<IndexType> >());
+
+    // the columns of U, as positions in the pattern
+    cusp::array1d<IndexType,MemorySpace> u_offsets(N + 1);
+    cusp::array1d<IndexType,MemorySpace> u_rows;
+    cusp::array1d<IndexType,MemorySpace> u_entries;
+
+    if(symmetric)
+    {
+        // column j of L^T is row j of L
+        u_offsets = row_offsets;
+        u_rows    = C.column_indices;
+        u_entries.resize(num_entries);
+        thrust::sequence(u_entries.begin(), u_entries.end());
+    }
+    else
+    {
+        const size_t num_upper =
+            thrust::count_if(thrust::make_zip_iterator(thrust::make_tuple(C.row_indices.begin(), C.column_indices.begin())),
+                             thrust::make_zip_iterator(thrust::make_tuple(C.row_indices.end(),   C.column_indices.end())),
+                             parilu_entry_is< thrust::less_equal<IndexType> >());
+
+        u_entries.resize(num_upper);
+        thrust::copy_if(CountingIterator(0), CountingIterator(num_entries),
+                        thrust::make_zip_iterator(thrust::make_tuple(C.row_indices.begin(), C.column_indices.begin())),
+                        u_entries.begin(),
+                        parilu_entry_is< thrust::less_equal<IndexType> >());
+
+        // the stable sort keeps the rows of each column in order
+        cusp::array1d<IndexType,MemorySpace> u_columns(num_upper);
+        thrust::gather(u_entries.begin(), u_entries.end(), C.column_indices.begin(), u_columns.begin());
+        thrust::stable_sort_by_key(u_columns.begin(), u_columns.end(), u_entries.begin());
+
+        u_rows.resize(num_upper);
+        thrust::gather(u_entries.begin(), u_entries.end(), C.row_indices.begin(), u_rows.begin());
+
+        cusp::detail::indices_to_offsets(u_columns, u_offsets);
+    }
+
+    // fixed-point sweeps, each one reads the factors of the previous sweep
+    cusp::array1d<ValueType,MemorySpace> factors(num_entries);
+    cusp::array1d<ValueType,MemorySpace> updated(num_entries);
+
+    thrust::transform(CountingIterator(0), CountingIterator(num_entries), factors.begin(),
+                      parilu_initial<IndexType,ValueType>(thrust::raw_pointer_cast(C.row_indices.data()),
+                                                          thrust::raw_pointer_cast(C.column_indices.data()),
+                                                          thrust::raw_pointer_cast(C.values.data()),
+                                                          thrust::raw_pointer_cast(diagonal.data()),
+                                                          symmetric));
+
+    for(size_t sweep = 0; sweep < sweeps; sweep++)
+    {
+        thrust::transform(CountingIterator(0), CountingIterator(num_entries), updated.begin(),
+                          parilu_sweep<IndexType,ValueType>(thrust::raw_pointer_cast(row_offsets.data()),
+                                                            thrust::raw_pointer_cast(C.row_indices.data()),
+                                                            thrust::raw_pointer_cast(C.column_indices.data()),
+                                                            thrust::raw_pointer_cast(C.values.data()),
+                                                            thrust::raw_pointer_cast(u_offsets.data()),
+                                                            thrust::raw_pointer_cast(u_rows.data()),
+                                                            thrust::raw_pointer_cast(u_entries.data()),
+                                                            thrust::raw_pointer_cast(diagonal.data()),
+                                                            thrust::raw_pointer_cast(factors.data()),
+                                                            symmetric));
+        factors.swap(updated);
+    }
+
+    // split the factors
+    cusp::array1d<ValueType,MemorySpace> inv_diagonal(N);
+    thrust::gather(diagonal.begin(), diagonal.end(), factors.begin(), inv_diagonal.begin());
+    thrust::transform(inv_diagonal.begin(), inv_diagonal.end(), inv_diagonal.begin(), parilu_reciprocal<ValueType>());
+
+    cusp::csr_matrix<IndexType,ValueType,MemorySpace> S;
+    parilu_extract< thrust::greater<IndexType> >(N, C.row_indices, C.column_indices, factors, S);
+
+    if(symmetric)
+    {
+        cusp::csr_matrix<IndexType,ValueType,MemorySpace> St;
+        cusp::transpose(S, St);
+
+        L = jacobi_triangular_factor<IndexType,ValueType,MemorySpace>(S,  inv_diagonal, solve_iterations);
+        U = jacobi_triangular_factor<IndexType,ValueType,MemorySpace>(St, inv_diagonal, solve_iterations);
+    }
+    else
+    {
+        cusp::array1d<ValueType,MemorySpace> ones(N, ValueType(1));
+        L = jacobi_triangular_factor<IndexType,ValueType,MemorySpace>(S, ones, solve_iterations);
+
+        parilu_extract< thrust::less<IndexType> >(N, C.row_indices, C.column_indices, factors, S);
+        U = jacobi_triangular_factor<IndexType,ValueType,MemorySpace>(S, inv_diagonal, solve_iterations);
+    }
+}
+
+// y <- U^-1 L^-1 x, approximately
+template <typename Factor, typename Array1, typename Array2, typename Array3, typename Array4>
+void parilu_apply(const Factor& L, const Factor& U, const Array1& x, Array2& temp, Array3& work, Array4& y)
+{
+    L.solve(x, temp, work);
+    U.solve(temp, y, work);
+}
+
+// x <- x + U^-1 L^-1 (b - A x)
+template <typename Factor, typename MatrixType, typename Array1, typename Array2,
+          typename Array3, typename Array4, typename Array5>
+void parilu_postsmooth(const Factor& L, const Factor& U, const MatrixType& A, const Array1& b, Array2& x,
+                       Array3& temp, Array4& work, Array5& residual)
+{
+    typedef typename Array2::value_type ValueType;
+
+    cusp::multiply(A, x, residual);
+    cusp::blas::axpby(b, residual, residual, ValueType(1), ValueType(-1));
+
+    parilu_apply(L, U, residual, temp, work, residual);
+
+    cusp::blas::axpy(residual, x, ValueType(1));
+}
+
+} // end namespace detail
+
+
+////////////
+// parilu //
+////////////
+template <typename ValueType, typename MemorySpace>
+parilu<ValueType,MemorySpace>
+::parilu(void)
+{
+}
+
+template <typename ValueType, typename MemorySpace>
+template <typename MatrixType>
+parilu<ValueType,MemorySpace>
+::parilu(const MatrixType& A, const size_t sweeps, const size_t solve_iterations)
+    : Parent(A.num_rows, A.num_cols, A.num_entries),
+      temp(A.num_rows), work(A.num_rows), residual(A.num_rows)
+{
+    detail::parilu_setup(A, false, sweeps, solve_iterations, L, U);
+}
+
+template <typename ValueType, typename MemorySpace>
+template <typename MemorySpace2>
+parilu<ValueType,MemorySpace>
+::parilu(const parilu<ValueType,MemorySpace2>& M)
+    : Parent(M.num_rows, M.num_cols, M.num_entries), L(M.L), U(M.U),
+      temp(M.temp), work(M.work), residual(M.residual)
+{
+}
+
+template <typename ValueType, typename MemorySpace>
+template <typename MatrixType>
+parilu<ValueType,MemorySpace>
+::parilu(const cusp::precond::aggregation::sa_level<MatrixType>& sa_level)
+    : Parent(sa_level.A_.num_rows, sa_level.A_.num_cols, sa_level.A_.num_entries),
+      temp(sa_level.A_.num_rows), work(sa_level.A_.num_rows), residual(sa_level.A_.num_rows)
+{
+    detail::parilu_setup(sa_level.A_, false, 3, 3, L, U);
+}
+
+template <typename ValueType, typename MemorySpace>
+template <typename VectorType1, typename VectorType2>
+void parilu<ValueType,MemorySpace>
+::operator()(const VectorType1& x, VectorType2& y) const
+{
+    CUSP_PROFILE_SCOPED();
+
+    detail::parilu_apply(L, U, x, temp, work, y);
+}
+
+template <typename ValueType, typename MemorySpace>
+template <typename MatrixType, typename VectorType1, typename VectorType2>
+void parilu<ValueType,MemorySpace>
+::presmooth(const MatrixType&, const VectorType1& b, VectorType2& x)
+{
+    CUSP_PROFILE_SCOPED();
+
+    detail::parilu_apply(L, U, b, temp, work, x);
+}
+
+template <typename ValueType, typename MemorySpace>
+template <typename MatrixType, typename VectorType1, typename VectorType2>
+void parilu<ValueType,MemorySpace>
+::postsmooth(const MatrixType& A, const VectorType1& b, VectorType2& x)
+{
+    CUSP_PROFILE_SCOPED();
+
+    detail::parilu_postsmooth(L, U, A, b, x, temp, work, residual);
+}
+
+///////////
+// paric //
+///////////
+template <typename ValueType, typename MemorySpace>
+paric<ValueType,MemorySpace>
+::paric(void)
+{
+}
+
+template <typename ValueType, typename MemorySpace>
+template <typename MatrixType>
+paric<ValueType,MemorySpace>
+::paric(const MatrixType& A, const size_t sweeps, const size_t solve_iterations)
+    : Parent(A.num_rows, A.num_cols, A.num_entries),
+      temp(A.num_rows), work(A.num_rows), residual(A.num_rows)
+{
+    detail::parilu_setup(A, true, sweeps, solve_iterations, L, U);
+}
+
+template <typename ValueType, typename MemorySpace>
+template <typename MemorySpace2>
+paric<ValueType,MemorySpace>
+::paric(const paric<ValueType,MemorySpace2>& M)
+    : Parent(M.num_rows, M.num_cols, M.num_entries), L(M.L), U(M.U),
+      temp(M.temp), work(M.work), residual(M.residual)
+{
+}
+
+template <typename ValueType, typename MemorySpace>
+template <typename MatrixType>
+paric<ValueType,MemorySpace>
+::paric(const cusp::precond::aggregation::sa_level<MatrixType>& sa_level)
+    : Parent(sa_level.A_.num_rows, sa_level.A_.num_cols, sa_level.A_.num_entries),
+      temp(sa_level.A_.num_rows), work(sa_level.A_.num_rows), residual(sa_level.A_.num_rows)
+{
+    detail::parilu_setup(sa_level.A_, true, 3, 3, L, U);
+}
+
+template <typename ValueType, typename MemorySpace>
+template <typename VectorType1, typename VectorType2>
+void paric<ValueType,MemorySpace>
+::operator()(const VectorType1& x, VectorType2& y) const
+{
+    CUSP_PROFILE_SCOPED();
+
+    detail::parilu_apply(L, U, x, temp, work, y);
+}
+
+template <typename ValueType, typename MemorySpace>
+template <typename MatrixType, typename VectorType1, typename VectorType2>
+void paric<ValueType,MemorySpace>
+::presmooth(const MatrixType&, const VectorType1& b, VectorType2& x)
+{
+    CUSP_PROFILE_SCOPED();
+
+    detail::parilu_apply(L, U, b, temp, work, x);
+}
+
+template <typename ValueType, typename MemorySpace>
+template <typename MatrixType, typename VectorType1, typename VectorType2>
+void paric<ValueType,MemorySpace>
+::postsmooth(const MatrixType& A, const VectorType1& b, VectorType2& x)
+{
+    CUSP_PROFILE_SCOPED();
+
+    detail::parilu_postsmooth(L, U, A, b, x, temp, work, residual);
+}
+
+} // end namespace precond
+} // end namespace cusp
+
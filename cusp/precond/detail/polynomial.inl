@@ -0,0 +1,106 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*! \file polynomial.inl
+ *  \brief Inline file for polynomial.h
+ */
+
+#include <cusp/multiply.h>
+#include <cusp/detail/format_utils.h>
+#include <cusp/detail/spectral_radius.h>
+#include <cusp/detail/stream.h>
+#include <cusp/relaxation/chebyshev.h>
+
+#include <thrust/transform.h>
+#include <thrust/iterator/constant_iterator.h>
+#include <thrust/iterator/zip_iterator.h>
+
+#include <algorithm>
+
+namespace cusp
+{
+namespace precond
+{
+
+// constructor
+template <typename MatrixType>
+    polynomial<MatrixType>
+    ::polynomial(const MatrixType& A, size_t degree, Real lower_bound, Real upper_bound)
+        : Parent(A.num_rows, A.num_cols, A.num_entries),
+          A(A), degree(std::max(degree, size_t(1))),
+          lower_bound(lower_bound), upper_bound(upper_bound)
+    {
+        CUSP_PROFILE_SCOPED();
+
+        if(this->upper_bound == 0)
+        {
+            // the power iteration approaches rho from below, so the
+            // interval is widened but need not exceed the Gershgorin bound
+            const double rho = cusp::detail::estimate_spectral_radius_Dinv_A(A, 10);
+
+            this->upper_bound = Real(std::min(1.1 * rho, cusp::detail::disks_spectral_radius_Dinv_A(A)));
+        }
+
+        if(this->lower_bound == 0)
+            this->lower_bound = this->upper_bound / 30;
+
+        // extract the main diagonal
+        cusp::detail::extract_diagonal(A, inv_diagonal);
+        thrust::transform(inv_diagonal.begin(), inv_diagonal.end(), inv_diagonal.begin(),
+                          cusp::relaxation::detail::chebyshev_reciprocal<ValueType>());
+
+        residual.resize(A.num_rows);
+        direction.resize(A.num_rows);
+        temp.resize(A.num_rows);
+    }
+
+// linear operator
+template <typename MatrixType>
+    template <typename VectorType1, typename VectorType2>
+    void polynomial<MatrixType>
+    ::operator()(const VectorType1& x, VectorType2& y) const
+    {
+        CUSP_PROFILE_SCOPED();
+
+        const ValueType theta = ValueType((upper_bound + lower_bound) / 2);
+        const ValueType delta = ValueType((upper_bound - lower_bound) / 2);
+        const ValueType sigma = theta / delta;
+
+        // y <- D^-1 x / theta, the first step from y = 0 needs no SpMV
+        cusp::detail::stream::for_each(thrust::make_zip_iterator(thrust::make_tuple(y.begin(), residual.begin(), direction.begin(), inv_diagonal.begin(), x.begin(), thrust::constant_iterator<ValueType>(0))),
+                                       thrust::make_zip_iterator(thrust::make_tuple(y.end(),   residual.end(),   direction.end(),   inv_diagonal.end(),   x.end(),   thrust::constant_iterator<ValueType>(0))),
+                                       cusp::relaxation::detail::chebyshev_initial_functor<ValueType>(1 / theta, true));
+
+        ValueType rho = 1 / sigma;
+
+        for(size_t k = 1; k < degree; k++)
+        {
+            const ValueType rho_next = 1 / (2 * sigma - rho);
+
+            // temp <- A*d
+            cusp::multiply(A, direction, temp);
+
+            // r <- r - D^-1 A d, d <- alpha d + beta r, y <- y + d
+            cusp::detail::stream::for_each(thrust::make_zip_iterator(thrust::make_tuple(y.begin(), residual.begin(), direction.begin(), inv_diagonal.begin(), temp.begin())),
+                                           thrust::make_zip_iterator(thrust::make_tuple(y.end(),   residual.end(),   direction.end(),   inv_diagonal.end(),   temp.end())),
+                                           cusp::relaxation::detail::chebyshev_step_functor<ValueType>(rho_next * rho, 2 * rho_next / delta));
+
+            rho = rho_next;
+        }
+    }
+
+} // end namespace precond
+} // end namespace cusp
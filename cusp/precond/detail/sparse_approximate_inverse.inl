@@ -0,0 +1,432 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*! \file sparse_approximate_inverse.inl
+ *  \brief Inline file for sparse_approximate_inverse.h
+ */
+
+#include <cusp/array1d.h>
+#include <cusp/coo_matrix.h>
+#include <cusp/csr_matrix.h>
+#include <cusp/exception.h>
+#include <cusp/multiply.h>
+#include <cusp/transpose.h>
+#include <cusp/detail/format_utils.h>
+#include <cusp/precond/parilu.h>
+
+#include <thrust/count.h>
+#include <thrust/for_each.h>
+#include <thrust/functional.h>
+#include <thrust/scan.h>
+#include <thrust/transform.h>
+#include <thrust/iterator/counting_iterator.h>
+#include <thrust/iterator/zip_iterator.h>
+
+#include <cmath>
+
+namespace cusp
+{
+namespace precond
+{
+namespace detail
+{
+
+// A(i,j) of a CSR matrix with sorted rows, 0 if not stored
+template <typename IndexType, typename ValueType>
+__host__ __device__
+ValueType sai_entry(const IndexType * Ap, const IndexType * Aj, const ValueType * Ax,
+                    const IndexType i, const IndexType j)
+{
+    IndexType first = Ap[i];
+    IndexType last  = Ap[i + 1];
+
+    while(first < last)
+    {
+        const IndexType mid = first + (last - first) / 2;
+
+        if(Aj[mid] < j)
+            first = mid + 1;
+        else
+            last = mid;
+    }
+
+    return (first < Ap[i + 1] && Aj[first] == j) ? Ax[first] : ValueType(0);
+}
+
+// A(i,:) A(j,:)^T of a CSR matrix with sorted rows
+template <typename IndexType, typename ValueType>
+__host__ __device__
+ValueType sai_row_dot(const IndexType * Ap, const IndexType * Aj, const ValueType * Ax,
+                      const IndexType i, const IndexType j)
+{
+    IndexType p = Ap[i];
+    IndexType q = Ap[j];
+
+    const IndexType p_end = Ap[i + 1];
+    const IndexType q_end = Ap[j + 1];
+
+    ValueType sum = 0;
+
+    while(p < p_end && q < q_end)
+    {
+        if(Aj[p] == Aj[q])
+            sum += Ax[p++] * Ax[q++];
+        else if(Aj[p] < Aj[q])
+            p++;
+        else
+            q++;
+    }
+
+    return sum;
+}
+
+// y <- S^-1 y for the n x n symmetric positive-definite S, of which the
+// lower triangle is stored row-major and overwritten by its Cholesky
+// factor.  Returns false if S is not positive definite.
+template <typename ValueType>
+__host__ __device__
+bool sai_cholesky_solve(ValueType * S, ValueType * y, const int n)
+{
+    for(int k = 0; k < n; k++)
+    {
+        ValueType d = S[k * n + k];
+        for(int p = 0; p < k; p++)
+            d -= S[k * n + p] * S[k * n + p];
+
+        if(!(d > ValueType(0)))
+            return false;
+
+        d = sqrt(d);
+        S[k * n + k] = d;
+
+        for(int i = k + 1; i < n; i++)
+        {
+            ValueType v = S[i * n + k];
+            for(int p = 0; p < k; p++)
+                v -= S[i * n + p] * S[k * n + p];
+            S[i * n + k] = v / d;
+        }
+    }
+
+    for(int i = 0; i < n; i++)
+    {
+        ValueType v = y[i];
+        for(int p = 0; p < i; p++)
+            v -= S[i * n + p] * y[p];
+        y[i] = v / S[i * n + i];
+    }
+
+    for(int i = n - 1; i >= 0; i--)
+    {
+        ValueType v = y[i];
+        for(int p = i + 1; p < n; p++)
+            v -= S[p * n + i] * y[p];
+        y[i] = v / S[i * n + i];
+    }
+
+    return true;
+}
+
+template <typename IndexType>
+struct sai_squared_length
+{
+    const IndexType * offsets;
+
+    sai_squared_length(const IndexType * offsets) : offsets(offsets) {}
+
+    __host__ __device__
+    size_t operator()(const IndexType i) const
+    {
+        const size_t n = offsets[i + 1] - offsets[i];
+        return n * n;
+    }
+};
+
+// row i of G from A(P,P) g = e_i on the lower pattern P of row i, whose
+// last column is i, scaled by 1 / sqrt(g_i)
+template <typename IndexType, typename ValueType>
+struct fsai_row
+{
+    const IndexType * Ap;
+    const IndexType * Aj;
+    const ValueType * Ax;
+    const IndexType * Gp;
+    const IndexType * Gj;
+    ValueType * Gx;
+    const size_t * scratch_offsets;
+    ValueType * scratch;
+
+    fsai_row(const IndexType * Ap, const IndexType * Aj, const ValueType * Ax,
+             const IndexType * Gp, const IndexType * Gj, ValueType * Gx,
+             const size_t * scratch_offsets, ValueType * scratch)
+        : Ap(Ap), Aj(Aj), Ax(Ax), Gp(Gp), Gj(Gj), Gx(Gx),
+          scratch_offsets(scratch_offsets), scratch(scratch) {}
+
+    __host__ __device__
+    void operator()(const IndexType i) const
+    {
+        const IndexType first = Gp[i];
+        const int n = Gp[i + 1] - first;
+
+        const IndexType * P = Gj + first;
+        ValueType * g = Gx + first;
+        ValueType * S = scratch + scratch_offsets[i];
+
+        for(int a = 0; a < n; a++)
+        {
+            for(int b = 0; b <= a; b++)
+                S[a * n + b] = sai_entry(Ap, Aj, Ax, P[a], P[b]);
+
+            g[a] = ValueType(a == n - 1 ? 1 : 0);
+        }
+
+        if(sai_cholesky_solve(S, g, n) && g[n - 1] > ValueType(0))
+        {
+            const ValueType scale = ValueType(1) / sqrt(g[n - 1]);
+
+            for(int a = 0; a < n; a++)
+                g[a] *= scale;
+        }
+        else
+        {
+            const ValueType d = sai_entry(Ap, Aj, Ax, i, i);
+
+            for(int a = 0; a < n - 1; a++)
+                g[a] = ValueType(0);
+
+            g[n - 1] = d > ValueType(0) ? ValueType(1) / sqrt(d) : ValueType(1);
+        }
+    }
+};
+
+// row i of M from the normal equations A(J,:) A(J,:)^T m = A(J,i) on the
+// pattern J of row i
+template <typename IndexType, typename ValueType>
+struct spai_row
+{
+    const IndexType * Ap;
+    const IndexType * Aj;
+    const ValueType * Ax;
+    ValueType * Mx;
+    const size_t * scratch_offsets;
+    ValueType * scratch;
+
+    spai_row(const IndexType * Ap, const IndexType * Aj, const ValueType * Ax, ValueType * Mx,
+             const size_t * scratch_offsets, ValueType * scratch)
+        : Ap(Ap), Aj(Aj), Ax(Ax), Mx(Mx), scratch_offsets(scratch_offsets), scratch(scratch) {}
+
+    __host__ __device__
+    void operator()(const IndexType i) const
+    {
+        const IndexType first = Ap[i];
+        const int n = Ap[i + 1] - first;
+
+        const IndexType * J = Aj + first;
+        ValueType * m = Mx + first;
+        ValueType * S = scratch + scratch_offsets[i];
+
+        for(int a = 0; a < n; a++)
+        {
+            for(int b = 0; b <= a; b++)
+                S[a * n + b] = sai_row_dot(Ap, Aj, Ax, J[a], J[b]);
+
+            m[a] = sai_entry(Ap, Aj, Ax, J[a], i);
+        }
+
+        if(!sai_cholesky_solve(S, m, n))
+        {
+            const ValueType d = sai_entry(Ap, Aj, Ax, i, i);
+
+            for(int a = 0; a < n; a++)
+                m[a] = (J[a] == i && d != ValueType(0)) ? ValueType(1) / d : ValueType(0);
+        }
+    }
+};
+
+// exclusive sums of the squared row lengths of a CSR pattern, the offsets
+// of the dense systems of the rows in the scratch space
+template <typename IndexArray, typename OffsetArray>
+size_t sai_scratch_offsets(const IndexArray& row_offsets, OffsetArray& scratch_offsets)
+{
+    typedef typename IndexArray::value_type   IndexType;
+    typedef typename IndexArray::memory_space MemorySpace;
+    typedef thrust::counting_iterator<IndexType,MemorySpace> CountingIterator;
+
+    const IndexType N = row_offsets.size() - 1;
+
+    scratch_offsets.resize(N + 1);
+    thrust::transform(CountingIterator(0), CountingIterator(N), scratch_offsets.begin(),
+                      sai_squared_length<IndexType>(thrust::raw_pointer_cast(row_offsets.data())));
+    scratch_offsets[N] = 0;
+    thrust::exclusive_scan(scratch_offsets.begin(), scratch_offsets.end(), scratch_offsets.begin());
+
+    return scratch_offsets[N];
+}
+
+} // end namespace detail
+
+
+// constructors
+template <typename ValueType, typename MemorySpace>
+    fsai<ValueType,MemorySpace>
+    ::fsai(void)
+    {
+    }
+
+template <typename ValueType, typename MemorySpace>
+template <typename MemorySpace2>
+    fsai<ValueType,MemorySpace>
+    ::fsai(const fsai<ValueType,MemorySpace2>& M)
+        : Parent(M.num_rows, M.num_cols, M.num_entries), w(M.w), w_t(M.w_t)
+    {
+    }
+
+template <typename ValueType, typename MemorySpace>
+template <typename MatrixType>
+    fsai<ValueType,MemorySpace>
+    ::fsai(const MatrixType& A)
+    {
+        CUSP_PROFILE_SCOPED();
+
+        typedef int IndexType;
+        typedef thrust::counting_iterator<IndexType,MemorySpace> CountingIterator;
+
+        if(A.num_rows != A.num_cols)
+            throw cusp::invalid_input_exception("matrix must be square");
+
+        const size_t N = A.num_rows;
+
+        cusp::csr_matrix<IndexType,ValueType,MemorySpace> B;
+        cusp::coo_matrix<IndexType,ValueType,MemorySpace> C;
+        {
+            cusp::coo_matrix<IndexType,ValueType,MemorySpace> D(A);
+            D.sort_by_row_and_column();
+            detail::parilu_extract< thrust::greater_equal<IndexType> >(N, D.row_indices, D.column_indices, D.values, C);
+            B = D;
+        }
+
+        const size_t num_diagonals =
+            thrust::count_if(thrust::make_zip_iterator(thrust::make_tuple(C.row_indices.begin(), C.column_indices.begin())),
+                             thrust::make_zip_iterator(thrust::make_tuple(C.row_indices.end(),   C.column_indices.end())),
+                             detail::parilu_entry_is< thrust::equal_to<IndexType> >());
+
+        if(num_diagonals != N)
+            throw cusp::invalid_input_exception("fsai requires every diagonal entry to be stored");
+
+        // G has the sorted pattern of the lower triangle of A
+        cusp::csr_matrix<IndexType,ValueType,MemorySpace> G(C);
+
+        cusp::array1d<size_t,MemorySpace> scratch_offsets;
+        cusp::array1d<ValueType,MemorySpace> scratch(detail::sai_scratch_offsets(G.row_offsets, scratch_offsets));
+
+        thrust::for_each(CountingIterator(0), CountingIterator(N),
+                         detail::fsai_row<IndexType,ValueType>(thrust::raw_pointer_cast(B.row_offsets.data()),
+                                                               thrust::raw_pointer_cast(B.column_indices.data()),
+                                                               thrust::raw_pointer_cast(B.values.data()),
+                                                               thrust::raw_pointer_cast(G.row_offsets.data()),
+                                                               thrust::raw_pointer_cast(G.column_indices.data()),
+                                                               thrust::raw_pointer_cast(G.values.data()),
+                                                               thrust::raw_pointer_cast(scratch_offsets.data()),
+                                                               thrust::raw_pointer_cast(scratch.data())));
+
+        cusp::csr_matrix<IndexType,ValueType,MemorySpace> Gt;
+        cusp::transpose(G, Gt);
+
+        w   = G;
+        w_t = Gt;
+
+        Parent::resize(N, N, 2 * G.num_entries);
+        temp.resize(N);
+    }
+
+template <typename ValueType, typename MemorySpace>
+template <typename VectorType1, typename VectorType2>
+    void fsai<ValueType,MemorySpace>
+    ::operator()(const VectorType1& x, VectorType2& y) const
+    {
+        CUSP_PROFILE_SCOPED();
+
+        cusp::multiply(w, x, temp);
+        cusp::multiply(w_t, temp, y);
+    }
+
+template <typename ValueType, typename MemorySpace>
+    spai<ValueType,MemorySpace>
+    ::spai(void)
+    {
+    }
+
+template <typename ValueType, typename MemorySpace>
+template <typename MemorySpace2>
+    spai<ValueType,MemorySpace>
+    ::spai(const spai<ValueType,MemorySpace2>& M)
+        : Parent(M.num_rows, M.num_cols, M.num_entries), m(M.m)
+    {
+    }
+
+template <typename ValueType, typename MemorySpace>
+template <typename MatrixType>
+    spai<ValueType,MemorySpace>
+    ::spai(const MatrixType& A)
+    {
+        CUSP_PROFILE_SCOPED();
+
+        typedef int IndexType;
+        typedef thrust::counting_iterator<IndexType,MemorySpace> CountingIterator;
+
+        if(A.num_rows != A.num_cols)
+            throw cusp::invalid_input_exception("matrix must be square");
+
+        const size_t N = A.num_rows;
+
+        cusp::csr_matrix<IndexType,ValueType,MemorySpace> B;
+        {
+            cusp::coo_matrix<IndexType,ValueType,MemorySpace> D(A);
+            D.sort_by_row_and_column();
+            B = D;
+        }
+
+        // M has the pattern of A
+        cusp::csr_matrix<IndexType,ValueType,MemorySpace> M(B);
+
+        cusp::array1d<size_t,MemorySpace> scratch_offsets;
+        cusp::array1d<ValueType,MemorySpace> scratch(detail::sai_scratch_offsets(B.row_offsets, scratch_offsets));
+
+        thrust::for_each(CountingIterator(0), CountingIterator(N),
+                         detail::spai_row<IndexType,ValueType>(thrust::raw_pointer_cast(B.row_offsets.data()),
+                                                               thrust::raw_pointer_cast(B.column_indices.data()),
+                                                               thrust::raw_pointer_cast(B.values.data()),
+                                                               thrust::raw_pointer_cast(M.values.data()),
+                                                               thrust::raw_pointer_cast(scratch_offsets.data()),
+                                                               thrust::raw_pointer_cast(scratch.data())));
+
+        m = M;
+
+        Parent::resize(N, N, M.num_entries);
+    }
+
+template <typename ValueType, typename MemorySpace>
+template <typename VectorType1, typename VectorType2>
+    void spai<ValueType,MemorySpace>
+    ::operator()(const VectorType1& x, VectorType2& y) const
+    {
+        CUSP_PROFILE_SCOPED();
+
+        cusp::multiply(m, x, y);
+    }
+
+} // end namespace precond
+} // end namespace cusp
@@ -0,0 +1,132 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*! \file triangular_solve.h
+ *  \brief Exact and approximate sparse triangular solves
+ */
+
+#pragma once
+
+#include <cusp/detail/config.h>
+
+#include <cusp/array1d.h>
+#include <cusp/blas.h>
+#include <cusp/csr_matrix.h>
+#include <cusp/exception.h>
+#include <cusp/multiply.h>
+#include <cusp/triangular_solve.h>
+#include <cusp/detail/stream.h>
+
+#include <thrust/iterator/zip_iterator.h>
+
+namespace cusp
+{
+namespace precond
+{
+namespace detail
+{
+
+/*! \p triangular_factor : sparse triangular matrix <tt>T = D + S</tt>
+ *  prepared for repeated solves, see \p cusp::triangular_solve_plan.
+ */
+template <typename IndexType, typename ValueType, typename MemorySpace>
+class triangular_factor : public cusp::triangular_solve_plan<IndexType,ValueType,MemorySpace>
+{
+    typedef cusp::triangular_solve_plan<IndexType,ValueType,MemorySpace> Parent;
+
+public:
+    triangular_factor(void) {}
+
+    template <typename MemorySpace2>
+    triangular_factor(const triangular_factor<IndexType,ValueType,MemorySpace2>& T)
+        : Parent(T) {}
+
+    /*! analyze the triangular matrix with strict part \p S and main diagonal
+     *  \p diagonal, \p lower selects a lower or an upper triangular matrix
+     */
+    triangular_factor(const cusp::csr_matrix<IndexType,ValueType,cusp::host_memory>& S,
+                      const cusp::array1d<ValueType,cusp::host_memory>& diagonal,
+                      const bool lower)
+    {
+        Parent::analyze(S, diagonal, lower);
+    }
+};
+
+// x <- D^-1 (b - S x)
+template <typename ValueType>
+struct jacobi_triangular_update
+{
+    template <typename Tuple>
+    __host__ __device__
+    ValueType operator()(const Tuple& t) const
+    {
+        return (thrust::get<0>(t) - thrust::get<1>(t)) * thrust::get<2>(t);
+    }
+};
+
+/*! \p jacobi_triangular_factor : sparse triangular matrix <tt>T = D + S</tt>
+ *  solved approximately by a fixed number of Jacobi iterations
+ *
+ *  Starting from <tt>x = D^-1 b</tt> each iteration computes
+ *  <tt>x = D^-1 (b - S x)</tt>.  Since \c S is strictly triangular the
+ *  iteration is exact after as many iterations as the solve has levels,
+ *  but a few iterations are usually enough for preconditioning.  Unlike
+ *  \p triangular_factor every iteration is a single SpMV over all rows.
+ */
+template <typename IndexType, typename ValueType, typename MemorySpace>
+class jacobi_triangular_factor
+{
+public:
+    cusp::csr_matrix<IndexType,ValueType,MemorySpace> strict;  // S
+    cusp::array1d<ValueType,MemorySpace> inv_diagonal;         // D^-1
+    size_t iterations;
+
+    jacobi_triangular_factor(void) : iterations(0) {}
+
+    template <typename MemorySpace2>
+    jacobi_triangular_factor(const jacobi_triangular_factor<IndexType,ValueType,MemorySpace2>& T)
+        : strict(T.strict), inv_diagonal(T.inv_diagonal), iterations(T.iterations) {}
+
+    template <typename MatrixType, typename ArrayType>
+    jacobi_triangular_factor(const MatrixType& S, const ArrayType& inv_diagonal, const size_t iterations)
+        : strict(S), inv_diagonal(inv_diagonal), iterations(iterations) {}
+
+    /*! approximately solve <tt>T x = b</tt> using \p temp as workspace,
+     *  \p b and \p x must not overlap
+     */
+    template <typename Array1, typename Array2, typename Array3>
+    void solve(const Array1& b, Array2& x, Array3& temp) const
+    {
+        CUSP_PROFILE_SCOPED();
+
+        cusp::blas::xmy(inv_diagonal, b, x);
+
+        for(size_t k = 0; k < iterations; k++)
+        {
+            cusp::multiply(strict, x, temp);
+
+            cusp::detail::stream::transform(thrust::make_zip_iterator(thrust::make_tuple(b.begin(), temp.begin(), inv_diagonal.begin())),
+                                            thrust::make_zip_iterator(thrust::make_tuple(b.end(),   temp.end(),   inv_diagonal.end())),
+                                            x.begin(),
+                                            jacobi_triangular_update<ValueType>());
+        }
+    }
+};
+
+} // end namespace detail
+} // end namespace precond
+} // end namespace cusp
+
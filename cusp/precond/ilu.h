@@ -0,0 +1,213 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*! \file ilu.h
+ *  \brief Incomplete LU and incomplete Cholesky preconditioners.
+ */
+
+#pragma once
+
+#include <cusp/detail/config.h>
+
+#include <cusp/linear_operator.h>
+#include <cusp/precond/detail/triangular_solve.h>
+
+namespace cusp
+{
+namespace precond
+{
+namespace aggregation
+{
+// forward definitions
+template<typename MatrixType> struct sa_level;
+} // end namespace aggregation
+
+/*! \addtogroup preconditioners Preconditioners
+ *  \ingroup preconditioners
+ *  \{
+ */
+
+/*! \p ilu0 : incomplete LU factorization preconditioner with zero fill-in
+ *
+ *  The factorization <tt>A ~ L U</tt> keeps the sparsity pattern of \c A,
+ *  where \c L is unit lower triangular and \c U is upper triangular.  It is
+ *  computed once on the host and applying the preconditioner solves
+ *  <tt>L U y = x</tt> with two sparse triangular solves in \p MemorySpace.
+ *  The rows of each factor are grouped into levels which only depend on
+ *  earlier levels, so each solve launches one kernel per level.  The level
+ *  analysis is part of the setup and is reused by every application.
+ *
+ *  \p ilu0 also implements the smoother interface of \p cusp::multilevel
+ *  and may be used as the \c SmootherType of \p smoothed_aggregation.
+ *
+ *  \tparam ValueType Type used for matrix values (e.g. \c float or \c double).
+ *  \tparam MemorySpace A memory space (e.g. \c cusp::host_memory or cusp::device_memory)
+ *
+ *  \note Every diagonal entry of \c A must be stored.
+ *  \note The number of levels of a factor bounds the parallelism of the
+ *        solves, matrices with long dependency chains (e.g. tridiagonal
+ *        matrices) are solved one row at a time.
+ *
+ *  The following code snippet demonstrates how to use an \p ilu0
+ *  preconditioner to solve a linear system.
+ *
+ *  \code
+ *  #include <cusp/precond/ilu.h>
+ *  #include <cusp/krylov/bicgstab.h>
+ *  ...
+ *
+ *  cusp::array1d<float, cusp::device_memory> x(A.num_rows, 0);
+ *  cusp::array1d<float, cusp::device_memory> b(A.num_rows, 1);
+ *
+ *  cusp::default_monitor<float> monitor(b, 100, 1e-6);
+ *
+ *  // setup preconditioner
+ *  cusp::precond::ilu0<float, cusp::device_memory> M(A);
+ *
+ *  // solve
+ *  cusp::krylov::bicgstab(A, x, b, monitor, M);
+ *  \endcode
+ */
+template <typename ValueType, typename MemorySpace>
+class ilu0 : public linear_operator<ValueType, MemorySpace>
+{
+    typedef linear_operator<ValueType, MemorySpace> Parent;
+
+public:
+    detail::triangular_factor<int,ValueType,MemorySpace> L;
+    detail::triangular_factor<int,ValueType,MemorySpace> U;
+
+    mutable cusp::array1d<ValueType,MemorySpace> temp;
+    cusp::array1d<ValueType,MemorySpace> residual;
+
+    /*! construct an empty \p ilu0 preconditioner
+     */
+    ilu0(void);
+
+    /*! construct an \p ilu0 preconditioner
+     *
+     * \param A matrix to precondition
+     * \tparam MatrixType matrix
+     */
+    template <typename MatrixType>
+    ilu0(const MatrixType& A);
+
+    template <typename MemorySpace2>
+    ilu0(const ilu0<ValueType,MemorySpace2>& M);
+
+    template <typename MatrixType>
+    ilu0(const cusp::precond::aggregation::sa_level<MatrixType>& sa_level);
+
+    /*! apply the preconditioner to vector \p x and store the result in \p y
+     *
+     * \param x input vector
+     * \param y ouput vector
+     * \tparam VectorType1 vector
+     * \tparam VectorType2 vector
+     */
+    template <typename VectorType1, typename VectorType2>
+    void operator()(const VectorType1& x, VectorType2& y) const;
+
+    // ignores initial x
+    template <typename MatrixType, typename VectorType1, typename VectorType2>
+    void presmooth(const MatrixType& A, const VectorType1& b, VectorType2& x);
+
+    // smooths initial x
+    template <typename MatrixType, typename VectorType1, typename VectorType2>
+    void postsmooth(const MatrixType& A, const VectorType1& b, VectorType2& x);
+};
+
+/*! \p ic0 : incomplete Cholesky factorization preconditioner with zero fill-in
+ *
+ *  The factorization <tt>A ~ L L^T</tt> keeps the sparsity pattern of the
+ *  lower triangle of \c A, the upper triangle is ignored.  \c L^T is stored
+ *  explicitly in \c U so that both triangular solves traverse rows.  The
+ *  factorization and the solves are otherwise organized as in \p ilu0.
+ *
+ *  \tparam ValueType Type used for matrix values (e.g. \c float or \c double).
+ *  \tparam MemorySpace A memory space (e.g. \c cusp::host_memory or cusp::device_memory)
+ *
+ *  \note \c A should be symmetric positive definite.  An exception is thrown
+ *        when the factorization encounters a nonpositive pivot.
+ *
+ *  The following code snippet demonstrates how to use an \p ic0
+ *  preconditioner with the conjugate gradient method.
+ *
+ *  \code
+ *  #include <cusp/precond/ilu.h>
+ *  #include <cusp/krylov/cg.h>
+ *  ...
+ *
+ *  cusp::precond::ic0<float, cusp::device_memory> M(A);
+ *
+ *  cusp::krylov::cg(A, x, b, monitor, M);
+ *  \endcode
+ */
+template <typename ValueType, typename MemorySpace>
+class ic0 : public linear_operator<ValueType, MemorySpace>
+{
+    typedef linear_operator<ValueType, MemorySpace> Parent;
+
+public:
+    detail::triangular_factor<int,ValueType,MemorySpace> L;
+    detail::triangular_factor<int,ValueType,MemorySpace> U;
+
+    mutable cusp::array1d<ValueType,MemorySpace> temp;
+    cusp::array1d<ValueType,MemorySpace> residual;
+
+    /*! construct an empty \p ic0 preconditioner
+     */
+    ic0(void);
+
+    /*! construct an \p ic0 preconditioner
+     *
+     * \param A symmetric positive definite matrix to precondition
+     * \tparam MatrixType matrix
+     */
+    template <typename MatrixType>
+    ic0(const MatrixType& A);
+
+    template <typename MemorySpace2>
+    ic0(const ic0<ValueType,MemorySpace2>& M);
+
+    template <typename MatrixType>
+    ic0(const cusp::precond::aggregation::sa_level<MatrixType>& sa_level);
+
+    /*! apply the preconditioner to vector \p x and store the result in \p y
+     *
+     * \param x input vector
+     * \param y ouput vector
+     * \tparam VectorType1 vector
+     * \tparam VectorType2 vector
+     */
+    template <typename VectorType1, typename VectorType2>
+    void operator()(const VectorType1& x, VectorType2& y) const;
+
+    // ignores initial x
+    template <typename MatrixType, typename VectorType1, typename VectorType2>
+    void presmooth(const MatrixType& A, const VectorType1& b, VectorType2& x);
+
+    // smooths initial x
+    template <typename MatrixType, typename VectorType1, typename VectorType2>
+    void postsmooth(const MatrixType& A, const VectorType1& b, VectorType2& x);
+};
+/*! \}
+ */
+
+} // end namespace precond
+} // end namespace cusp
+
+#include <cusp/precond/detail/ilu.inl>
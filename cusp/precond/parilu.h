@@ -0,0 +1,200 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*! \file parilu.h
+ *  \brief Fine-grained parallel incomplete LU and Cholesky preconditioners.
+ */
+
+#pragma once
+
+#include <cusp/detail/config.h>
+
+#include <cusp/linear_operator.h>
+#include <cusp/precond/detail/triangular_solve.h>
+
+namespace cusp
+{
+namespace precond
+{
+namespace aggregation
+{
+// forward definitions
+template<typename MatrixType> struct sa_level;
+} // end namespace aggregation
+
+/*! \addtogroup preconditioners Preconditioners
+ *  \ingroup preconditioners
+ *  \{
+ */
+
+/*! \p parilu : incomplete LU factorization with zero fill-in computed by
+ *  fixed-point sweeps
+ *
+ *  Every nonzero of the factors satisfies a bilinear equation in the other
+ *  nonzeros of <tt>L U = A</tt> on the pattern of \c A.  Instead of the
+ *  sequential elimination of \p ilu0, \p parilu starts from the scaled
+ *  entries of \c A and updates all nonzeros in parallel for a few sweeps,
+ *  each of which reads the factors of the previous sweep.  The triangular
+ *  solves of the preconditioner are replaced by a fixed number of Jacobi
+ *  iterations, so both setup and application consist of SpMV-like kernels
+ *  over all nonzeros and do not depend on the ordering of \c A.
+ *
+ *  \p parilu also implements the smoother interface of \p cusp::multilevel.
+ *
+ *  \tparam ValueType Type used for matrix values (e.g. \c float or \c double).
+ *  \tparam MemorySpace A memory space (e.g. \c cusp::host_memory or cusp::device_memory)
+ *
+ *  \note Every diagonal entry of \c A must be stored.
+ *  \note The factors converge to those of \p ilu0 as the number of sweeps
+ *        grows, and the Jacobi triangular solves become exact once the
+ *        number of iterations reaches the number of levels of the factors.
+ *
+ *  The following code snippet demonstrates how to use a \p parilu
+ *  preconditioner with three sweeps and two Jacobi iterations per
+ *  triangular solve.
+ *
+ *  \code
+ *  #include <cusp/precond/parilu.h>
+ *  #include <cusp/krylov/bicgstab.h>
+ *  ...
+ *
+ *  cusp::precond::parilu<float, cusp::device_memory> M(A, 3, 2);
+ *
+ *  cusp::krylov::bicgstab(A, x, b, monitor, M);
+ *  \endcode
+ */
+template <typename ValueType, typename MemorySpace>
+class parilu : public linear_operator<ValueType, MemorySpace>
+{
+    typedef linear_operator<ValueType, MemorySpace> Parent;
+
+public:
+    detail::jacobi_triangular_factor<int,ValueType,MemorySpace> L;
+    detail::jacobi_triangular_factor<int,ValueType,MemorySpace> U;
+
+    mutable cusp::array1d<ValueType,MemorySpace> temp;
+    mutable cusp::array1d<ValueType,MemorySpace> work;
+    cusp::array1d<ValueType,MemorySpace> residual;
+
+    /*! construct an empty \p parilu preconditioner
+     */
+    parilu(void);
+
+    /*! construct a \p parilu preconditioner
+     *
+     * \param A matrix to precondition
+     * \param sweeps number of fixed-point sweeps of the factorization
+     * \param solve_iterations number of Jacobi iterations per triangular solve
+     * \tparam MatrixType matrix
+     */
+    template <typename MatrixType>
+    parilu(const MatrixType& A, const size_t sweeps = 3, const size_t solve_iterations = 3);
+
+    template <typename MemorySpace2>
+    parilu(const parilu<ValueType,MemorySpace2>& M);
+
+    template <typename MatrixType>
+    parilu(const cusp::precond::aggregation::sa_level<MatrixType>& sa_level);
+
+    /*! apply the preconditioner to vector \p x and store the result in \p y
+     *
+     * \param x input vector
+     * \param y ouput vector
+     * \tparam VectorType1 vector
+     * \tparam VectorType2 vector
+     */
+    template <typename VectorType1, typename VectorType2>
+    void operator()(const VectorType1& x, VectorType2& y) const;
+
+    // ignores initial x
+    template <typename MatrixType, typename VectorType1, typename VectorType2>
+    void presmooth(const MatrixType& A, const VectorType1& b, VectorType2& x);
+
+    // smooths initial x
+    template <typename MatrixType, typename VectorType1, typename VectorType2>
+    void postsmooth(const MatrixType& A, const VectorType1& b, VectorType2& x);
+};
+
+/*! \p paric : incomplete Cholesky factorization with zero fill-in computed
+ *  by fixed-point sweeps
+ *
+ *  The symmetric counterpart of \p parilu, computing <tt>A ~ L L^T</tt> on
+ *  the pattern of the lower triangle of \c A.  \c L^T is stored explicitly
+ *  in \c U.
+ *
+ *  \tparam ValueType Type used for matrix values (e.g. \c float or \c double).
+ *  \tparam MemorySpace A memory space (e.g. \c cusp::host_memory or cusp::device_memory)
+ *
+ *  \note \c A should be symmetric positive definite.
+ */
+template <typename ValueType, typename MemorySpace>
+class paric : public linear_operator<ValueType, MemorySpace>
+{
+    typedef linear_operator<ValueType, MemorySpace> Parent;
+
+public:
+    detail::jacobi_triangular_factor<int,ValueType,MemorySpace> L;
+    detail::jacobi_triangular_factor<int,ValueType,MemorySpace> U;
+
+    mutable cusp::array1d<ValueType,MemorySpace> temp;
+    mutable cusp::array1d<ValueType,MemorySpace> work;
+    cusp::array1d<ValueType,MemorySpace> residual;
+
+    /*! construct an empty \p paric preconditioner
+     */
+    paric(void);
+
+    /*! construct a \p paric preconditioner
+     *
+     * \param A symmetric positive definite matrix to precondition
+     * \param sweeps number of fixed-point sweeps of the factorization
+     * \param solve_iterations number of Jacobi iterations per triangular solve
+     * \tparam MatrixType matrix
+     */
+    template <typename MatrixType>
+    paric(const MatrixType& A, const size_t sweeps = 3, const size_t solve_iterations = 3);
+
+    template <typename MemorySpace2>
+    paric(const paric<ValueType,MemorySpace2>& M);
+
+    template <typename MatrixType>
+    paric(const cusp::precond::aggregation::sa_level<MatrixType>& sa_level);
+
+    /*! apply the preconditioner to vector \p x and store the result in \p y
+     *
+     * \param x input vector
+     * \param y ouput vector
+     * \tparam VectorType1 vector
+     * \tparam VectorType2 vector
+     */
+    template <typename VectorType1, typename VectorType2>
+    void operator()(const VectorType1& x, VectorType2& y) const;
+
+    // ignores initial x
+    template <typename MatrixType, typename VectorType1, typename VectorType2>
+    void presmooth(const MatrixType& A, const VectorType1& b, VectorType2& x);
+
+    // smooths initial x
+    template <typename MatrixType, typename VectorType1, typename VectorType2>
+    void postsmooth(const MatrixType& A, const VectorType1& b, VectorType2& x);
+};
+/*! \}
+ */
+
+} // end namespace precond
+} // end namespace cusp
+
+#include <cusp/precond/detail/parilu.inl>
@@ -0,0 +1,133 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*! \file polynomial.h
+ *  \brief Chebyshev polynomial preconditioner.
+ */
+
+#pragma once
+
+#include <cusp/detail/config.h>
+
+#include <cusp/array1d.h>
+#include <cusp/linear_operator.h>
+
+namespace cusp
+{
+namespace precond
+{
+
+/*! \addtogroup preconditioners Preconditioners
+ *  \ingroup preconditioners
+ *  \{
+ */
+
+/*! \p polynomial : Chebyshev polynomial preconditioner
+ *
+ *  Applies <tt>y = p(D^-1 A) D^-1 x</tt>, where \c D is the main diagonal
+ *  of \c A and \c p is the polynomial of the given degree which best
+ *  approximates <tt>1 / lambda</tt> on the interval
+ *  <tt>[lower_bound, upper_bound]</tt> in the sense of Chebyshev.  This
+ *  is the result of \c degree steps of the Chebyshev iteration for
+ *  <tt>A y = x</tt> from <tt>y = 0</tt>: one SpMV and one fused vector
+ *  update per step, with no inner products.  Applying the
+ *  preconditioner therefore needs no global reduction, which makes it
+ *  attractive on the GPU and across devices, where reductions are the
+ *  synchronization points of a Krylov method.
+ *
+ *  Unless given, the upper bound is estimated on the device by a power
+ *  iteration for the spectral radius of <tt>D^-1 A</tt>, widened by 10%
+ *  and capped by its Gershgorin bound, and the lower bound is a fixed
+ *  fraction of the upper one.
+ *
+ *  \tparam MatrixType Type of the matrix \c A, which is held by reference
+ *  and must outlive the preconditioner.
+ *
+ *  \note For symmetric positive-definite \c A the preconditioner is
+ *  symmetric positive-definite too, as long as \c upper_bound bounds the
+ *  spectrum of <tt>D^-1 A</tt>, so it may be used with \p cg.
+ *
+ *  The following code snippet demonstrates how to use a \p polynomial
+ *  preconditioner of degree 8 with \p cg.
+ *
+ *  \code
+ *  #include <cusp/precond/polynomial.h>
+ *  #include <cusp/krylov/cg.h>
+ *  ...
+ *
+ *  typedef cusp::csr_matrix<int, float, cusp::device_memory> Matrix;
+ *
+ *  cusp::precond::polynomial<Matrix> M(A, 8);
+ *
+ *  cusp::krylov::cg(A, x, b, monitor, M);
+ *  \endcode
+ *
+ *  \see \p cusp::relaxation::chebyshev
+ */
+template <typename MatrixType>
+class polynomial
+  : public linear_operator<typename MatrixType::value_type,
+                           typename MatrixType::memory_space,
+                           typename MatrixType::index_type>
+{
+    typedef linear_operator<typename MatrixType::value_type,
+                            typename MatrixType::memory_space,
+                            typename MatrixType::index_type> Parent;
+
+public:
+    typedef typename MatrixType::value_type   ValueType;
+    typedef typename MatrixType::memory_space MemorySpace;
+    typedef typename norm_type<ValueType>::type Real;
+
+    const MatrixType& A;
+
+    size_t degree;
+    Real lower_bound;
+    Real upper_bound;
+
+    cusp::array1d<ValueType,MemorySpace> inv_diagonal;
+
+    /*! construct a \p polynomial preconditioner
+     *
+     * \param A matrix to precondition
+     * \param degree number of Chebyshev steps, i.e. of SpMVs per application
+     * \param lower_bound lower end of the interval, or 0 for <tt>upper_bound / 30</tt>
+     * \param upper_bound upper end of the interval, or 0 for an estimate
+     */
+    polynomial(const MatrixType& A, size_t degree = 4, Real lower_bound = 0, Real upper_bound = 0);
+
+    /*! apply the preconditioner to vector \p x and store the result in \p y
+     *
+     * \param x input vector
+     * \param y ouput vector
+     * \tparam VectorType1 vector
+     * \tparam VectorType2 vector
+     */
+    template <typename VectorType1, typename VectorType2>
+    void operator()(const VectorType1& x, VectorType2& y) const;
+
+private:
+    mutable cusp::array1d<ValueType,MemorySpace> residual;
+    mutable cusp::array1d<ValueType,MemorySpace> direction;
+    mutable cusp::array1d<ValueType,MemorySpace> temp;
+};
+/*! \}
+ */
+
+} // end namespace precond
+} // end namespace cusp
+
+#include <cusp/precond/detail/polynomial.inl>
@@ -0,0 +1,179 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*! \file sparse_approximate_inverse.h
+ *  \brief Sparse approximate inverse preconditioners built by independent
+ *  small solves.
+ */
+
+#pragma once
+
+#include <cusp/detail/config.h>
+
+#include <cusp/array1d.h>
+#include <cusp/hyb_matrix.h>
+#include <cusp/linear_operator.h>
+
+namespace cusp
+{
+namespace precond
+{
+
+/*! \addtogroup preconditioners Preconditioners
+ *  \ingroup preconditioners
+ *  \{
+ */
+
+/*! \p fsai : factorized sparse approximate inverse preconditioner
+ *
+ *  Computes a lower triangular \c G with the pattern of the lower
+ *  triangle of \c A such that <tt>G^T G ~ A^-1</tt>, by minimizing the
+ *  Kaporin condition number of <tt>G A G^T</tt>.  Row \c i of \c G is the
+ *  solution of the small symmetric positive-definite system
+ *  <tt>A(P,P) g = e_i</tt> on its pattern \c P, scaled so that
+ *  <tt>(G A G^T)_ii = 1</tt>.  The systems of all rows are independent and
+ *  solved by one thread each with a dense Cholesky factorization, so
+ *  the setup runs entirely in the memory space of the preconditioner.
+ *  Applying the preconditioner costs two SpMVs, with \c G and with its
+ *  explicitly stored transpose.
+ *
+ *  \tparam ValueType Type used for matrix values (\c float or \c double).
+ *  \tparam MemorySpace A memory space (e.g. \c cusp::host_memory or cusp::device_memory)
+ *
+ *  \note \c A should be symmetric positive definite, with every diagonal
+ *  entry stored.  Rows whose system is not positive definite fall back
+ *  to the Jacobi row <tt>e_i / sqrt(a_ii)</tt>.
+ *  \note The setup needs scratch memory for the sum of the squared row
+ *  lengths of the lower triangle of \c A.
+ *
+ *  The following code snippet demonstrates how to use an \p fsai
+ *  preconditioner with \p cg.
+ *
+ *  \code
+ *  #include <cusp/precond/sparse_approximate_inverse.h>
+ *  #include <cusp/krylov/cg.h>
+ *  ...
+ *
+ *  cusp::precond::fsai<float, cusp::device_memory> M(A);
+ *
+ *  cusp::krylov::cg(A, x, b, monitor, M);
+ *  \endcode
+ *
+ *  \see \p spai
+ *  \see \p bridson_ainv
+ */
+template <typename ValueType, typename MemorySpace>
+class fsai : public linear_operator<ValueType, MemorySpace>
+{
+    typedef linear_operator<ValueType, MemorySpace> Parent;
+
+public:
+    cusp::hyb_matrix<int, ValueType, MemorySpace> w;      // G
+    cusp::hyb_matrix<int, ValueType, MemorySpace> w_t;    // G^T, applied as G^T * G
+
+    /*! construct an empty \p fsai preconditioner
+     */
+    fsai(void);
+
+    /*! construct an \p fsai preconditioner
+     *
+     * \param A symmetric positive definite matrix to precondition
+     * \tparam MatrixType matrix
+     */
+    template <typename MatrixType>
+    fsai(const MatrixType& A);
+
+    template <typename MemorySpace2>
+    fsai(const fsai<ValueType,MemorySpace2>& M);
+
+    /*! apply the preconditioner to vector \p x and store the result in \p y
+     *
+     * \param x input vector
+     * \param y ouput vector
+     * \tparam VectorType1 vector
+     * \tparam VectorType2 vector
+     */
+    template <typename VectorType1, typename VectorType2>
+    void operator()(const VectorType1& x, VectorType2& y) const;
+
+private:
+    mutable cusp::array1d<ValueType,MemorySpace> temp;
+};
+
+/*! \p spai : sparse approximate inverse preconditioner with a static
+ *  pattern
+ *
+ *  Computes \c M with the pattern of \c A which minimizes the Frobenius
+ *  norm of <tt>I - M A</tt>.  Row \c i of \c M only couples to the rows
+ *  \c J of \c A in its pattern, so it is the least-squares solution of
+ *  <tt>m^T A(J,:) = e_i^T</tt>.  Its normal equations involve the inner
+ *  products of the rows of \c A, which are merged from the sparse rows
+ *  directly, and are solved by one thread per row with a dense
+ *  Cholesky factorization.  Applying the preconditioner is one SpMV.
+ *
+ *  \tparam ValueType Type used for matrix values (\c float or \c double).
+ *  \tparam MemorySpace A memory space (e.g. \c cusp::host_memory or cusp::device_memory)
+ *
+ *  \note The normal equations square the condition number of the small
+ *  systems, which is harmless for the short rows this preconditioner is
+ *  meant for.  Rows whose system is singular fall back to the Jacobi
+ *  row <tt>e_i / a_ii</tt>.
+ *  \note The setup needs scratch memory for the sum of the squared row
+ *  lengths of \c A.
+ *
+ *  \see \p fsai
+ *  \see \p nonsym_bridson_ainv
+ */
+template <typename ValueType, typename MemorySpace>
+class spai : public linear_operator<ValueType, MemorySpace>
+{
+    typedef linear_operator<ValueType, MemorySpace> Parent;
+
+public:
+    cusp::hyb_matrix<int, ValueType, MemorySpace> m;
+
+    /*! construct an empty \p spai preconditioner
+     */
+    spai(void);
+
+    /*! construct an \p spai preconditioner
+     *
+     * \param A matrix to precondition
+     * \tparam MatrixType matrix
+     */
+    template <typename MatrixType>
+    spai(const MatrixType& A);
+
+    template <typename MemorySpace2>
+    spai(const spai<ValueType,MemorySpace2>& M);
+
+    /*! apply the preconditioner to vector \p x and store the result in \p y
+     *
+     * \param x input vector
+     * \param y ouput vector
+     * \tparam VectorType1 vector
+     * \tparam VectorType2 vector
+     */
+    template <typename VectorType1, typename VectorType2>
+    void operator()(const VectorType1& x, VectorType2& y) const;
+};
+/*! \}
+ */
+
+} // end namespace precond
+} // end namespace cusp
+
+#include <cusp/precond/detail/sparse_approximate_inverse.inl>
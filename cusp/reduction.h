@@ -0,0 +1,147 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+/*! \file reduction.h
+ *  \brief Select how the BLAS reductions order their sums
+ */
+
+#pragma once
+
+#include <cusp/detail/config.h>
+
+#include <cusp/detail/mutex.h>
+
+namespace cusp
+{
+
+/*! \addtogroup execution Execution
+ *  \{
+ */
+
+/*! \p reduction_mode : How \p cusp::blas::dot, \p dotc and \p nrm2 (and
+ *  the fused \p dot2, \p axpy_dot and \p mdot) add up their terms.
+ *
+ *  \note Compensated summation relies on IEEE rounding of each operation;
+ *  host code built with fast-math options may lose the compensation.
+ */
+enum reduction_mode
+{
+    /*! Use the fastest available reduction.  The order of the additions
+     *  depends on the number of threads or the launch configuration, so
+     *  the last bits of the result may change between runs, thread counts
+     *  and devices.
+     */
+    fast_reduction,
+
+    /*! Add the terms in an order which only depends on the length of the
+     *  vectors.  Repeated runs give bitwise identical results on any
+     *  number of host threads and on any device, at the cost of a second,
+     *  much smaller pass over the partial sums.  The fused routines fall
+     *  back to separate reproducible passes.
+     */
+    reproducible_reduction,
+
+    /*! Carry the rounding errors of the additions and products in a second
+     *  term (compensated summation), so that the result is about as
+     *  accurate as one computed in twice the working precision.  This also
+     *  applies to the CSR and ELL SpMV kernels, which lets a \c float solve
+     *  keep \c float storage and bandwidth with close to \c double
+     *  accuracy in its reductions.  The fused routines fall back to
+     *  separate compensated passes, and the device CSR SpMV always uses the
+     *  vector kernel.
+     */
+    compensated_reduction
+};
+
+namespace detail
+{
+
+// blocking of the reproducible reductions, shared by the host and the
+// device so that both add the terms in the same order: each chunk of
+// REDUCTION_LANES * REDUCTION_ITEMS terms is summed by REDUCTION_LANES lanes
+const unsigned int REDUCTION_LANES = 256;
+const unsigned int REDUCTION_ITEMS = 8;
+
+// kept per host thread, like the current stream
+inline cusp::reduction_mode& current_reduction_storage(void)
+{
+    static __CUSP_THREAD_LOCAL cusp::reduction_mode mode = cusp::fast_reduction;
+    return mode;
+}
+
+} // end namespace detail
+
+/*! \p reduction_scope : Selects the \p reduction_mode of the BLAS
+ *  reductions (and, for \p compensated_reduction, the CSR and ELL SpMVs)
+ *  issued while the scope is alive.
+ *
+ * The mode may also be passed to \p dot, \p dotc and \p nrm2 directly,
+ * which overrides the scope for that call.  Scopes may be nested; the
+ * previous mode is restored when the scope is destroyed.
+ *
+ * \note Like the current stream, the mode is kept per host thread, so a
+ * scope only affects the reductions issued by the thread which opened it.
+ *
+ *  \code
+ *  #include <cusp/reduction.h>
+ *  #include <cusp/krylov/cg.h>
+ *  ...
+ *
+ *  {
+ *      // same iteration count on every run and every device
+ *      cusp::reduction_scope scope(cusp::reproducible_reduction);
+ *      cusp::krylov::cg(A, x, b, monitor);
+ *  }
+ *  \endcode
+ */
+class reduction_scope
+{
+    public:
+    /*! Use \p mode for subsequent reductions
+     */
+    explicit reduction_scope(cusp::reduction_mode mode)
+        : previous(cusp::detail::current_reduction_storage())
+    {
+        cusp::detail::current_reduction_storage() = mode;
+    }
+
+    /*! Restore the previously active mode
+     */
+    ~reduction_scope(void)
+    {
+        cusp::detail::current_reduction_storage() = previous;
+    }
+
+    private:
+    cusp::reduction_mode previous;
+
+    // non-copyable
+    reduction_scope(const reduction_scope&);
+    reduction_scope& operator=(const reduction_scope&);
+};
+
+/*! \p current_reduction_mode : mode currently used by the BLAS reductions
+ */
+inline cusp::reduction_mode current_reduction_mode(void)
+{
+    return cusp::detail::current_reduction_storage();
+}
+
+/*! \}
+ */
+
+} // end namespace cusp
@@ -0,0 +1,120 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+/*! \file async_jacobi.h
+ *  \brief Block-asynchronous Jacobi relaxation.
+ */
+
+#pragma once
+
+#include <cusp/detail/config.h>
+
+#include <cusp/array1d.h>
+#include <cusp/csr_matrix.h>
+#include <cusp/linear_operator.h>
+
+namespace cusp
+{
+namespace precond
+{
+namespace aggregation
+{
+// forward definitions
+template<typename MatrixType> struct sa_level;
+} // end namespace aggregation
+} // end namespace precond
+
+namespace relaxation
+{
+
+// Block-asynchronous relaxation.  The rows are split into blocks of
+// block_size consecutive rows and a step relaxes every block independently:
+// the coupling to the other blocks is taken from x once, then local_sweeps
+// Jacobi or Gauss-Seidel sweeps (SOR when omega != 1) update the rows of
+// the block only.  A step needs no global synchronization between sweeps.
+//
+// On the device a step is a single persistent kernel with one thread block
+// per row block and one thread per row.  The values of the other blocks
+// are read while they are being updated, so a block may see either their
+// old or their new values: the smoothing approaches Gauss-Seidel at the
+// cost of Jacobi, but the results are not reproducible from one run to the
+// next.  On the host the blocks are relaxed in parallel against a copy of
+// x taken at the start of the step, which makes the results deterministic.
+//
+// presmooth performs a step with the rows and blocks in increasing order
+// and postsmooth one in decreasing order.  block_size must be a power of
+// two from 32 to 1024.
+template <typename ValueType, typename MemorySpace>
+class async_jacobi : public cusp::linear_operator<ValueType, MemorySpace>
+{
+public:
+    ValueType default_omega;
+    size_t local_sweeps;                                // sweeps over each block per step
+    size_t block_size;                                  // rows per block
+    bool local_gauss_seidel;                            // Gauss-Seidel rather than Jacobi sweeps
+    cusp::csr_matrix<int,ValueType,MemorySpace> matrix;
+    cusp::array1d<ValueType,MemorySpace> inv_diagonal;
+    cusp::array1d<ValueType,MemorySpace> temp;          // copy of x, host only
+    cusp::array1d<ValueType,MemorySpace> work;          // local Jacobi values, host only
+
+    async_jacobi();
+
+    template <typename MatrixType>
+    async_jacobi(const MatrixType& A, ValueType omega=1.0, size_t local_sweeps=2,
+                 size_t block_size=256, bool local_gauss_seidel=true);
+
+    template <typename MemorySpace2>
+    async_jacobi(const async_jacobi<ValueType,MemorySpace2>& A);
+
+    template <typename MatrixType>
+    async_jacobi(const cusp::precond::aggregation::sa_level<MatrixType>& sa_level, ValueType omega=1.0,
+                 size_t local_sweeps=2, size_t block_size=256, bool local_gauss_seidel=true);
+
+    // relaxes every block once, in decreasing order when backward is set
+    template <typename VectorType1, typename VectorType2>
+    void step(const VectorType1& b, VectorType2& x, ValueType omega, bool backward=false);
+
+    // ignores initial x
+    template<typename MatrixType, typename VectorType1, typename VectorType2>
+    void presmooth(const MatrixType& A, const VectorType1& b, VectorType2& x);
+
+    // smooths initial x
+    template<typename MatrixType, typename VectorType1, typename VectorType2>
+    void postsmooth(const MatrixType& A, const VectorType1& b, VectorType2& x);
+
+    // forward and backward step
+    template <typename MatrixType, typename VectorType1, typename VectorType2>
+    void operator()(const MatrixType& A, const VectorType1& b, VectorType2& x);
+
+    template <typename MatrixType, typename VectorType1, typename VectorType2>
+    void operator()(const MatrixType& A, const VectorType1& b, VectorType2& x, ValueType omega);
+
+private:
+    template <typename MatrixType>
+    void setup(const MatrixType& A);
+
+    template <typename VectorType1, typename VectorType2>
+    void relax_blocks(const VectorType1& b, VectorType2& x, ValueType omega, bool backward, cusp::host_memory);
+
+    template <typename VectorType1, typename VectorType2>
+    void relax_blocks(const VectorType1& b, VectorType2& x, ValueType omega, bool backward, cusp::device_memory);
+};
+
+} // end namespace relaxation
+} // end namespace cusp
+
+#include <cusp/relaxation/detail/async_jacobi.inl>
@@ -0,0 +1,97 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*! \file chebyshev.h
+ *  \brief Chebyshev polynomial relaxation.
+ */
+
+#pragma once
+
+#include <cusp/detail/config.h>
+
+#include <cusp/array1d.h>
+#include <cusp/linear_operator.h>
+
+namespace cusp
+{
+namespace precond
+{
+namespace aggregation
+{
+// forward definitions
+template<typename MatrixType> struct sa_level;
+} // end namespace aggregation
+} // end namespace precond
+
+namespace relaxation
+{
+
+// Chebyshev relaxation of D^-1 A x = D^-1 b.  Each application performs
+// \c degree steps of the three-term Chebyshev recurrence for the interval
+// [lower_bound, upper_bound] of the spectrum of D^-1 A, one SpMV and one
+// fused vector update per step, so the degree may be chosen freely.
+//
+// The interval is derived from an estimate rho of the spectral radius of
+// D^-1 A as [lower * rho, upper * rho].  Unless the estimate of the
+// aggregation level is available, rho is found on the device with a few
+// power iterations and is capped by the Gershgorin bound of D^-1 A.
+template <typename ValueType, typename MemorySpace>
+class chebyshev : public cusp::linear_operator<ValueType, MemorySpace>
+{
+public:
+    size_t degree;
+    ValueType lower_bound;
+    ValueType upper_bound;
+    cusp::array1d<ValueType,MemorySpace> inv_diagonal;
+    cusp::array1d<ValueType,MemorySpace> residual;
+    cusp::array1d<ValueType,MemorySpace> direction;
+    cusp::array1d<ValueType,MemorySpace> temp;
+
+    chebyshev();
+
+    template <typename MatrixType>
+    chebyshev(const MatrixType& A, size_t degree=3, ValueType lower=1.0/30.0, ValueType upper=1.1);
+
+    template <typename MemorySpace2>
+    chebyshev(const chebyshev<ValueType,MemorySpace2>& A);
+
+    template <typename MatrixType>
+    chebyshev(const cusp::precond::aggregation::sa_level<MatrixType>& sa_level, size_t degree=3);
+
+    // ignores initial x
+    template<typename MatrixType, typename VectorType1, typename VectorType2>
+    void presmooth(const MatrixType& A, const VectorType1& b, VectorType2& x);
+
+    // smooths initial x
+    template<typename MatrixType, typename VectorType1, typename VectorType2>
+    void postsmooth(const MatrixType& A, const VectorType1& b, VectorType2& x);
+
+    template <typename MatrixType, typename VectorType1, typename VectorType2>
+    void operator()(const MatrixType& A, const VectorType1& b, VectorType2& x);
+
+private:
+    template <typename MatrixType>
+    void setup(const MatrixType& A, double rho, ValueType lower, ValueType upper);
+
+    // remaining degree - 1 steps after the initial one
+    template <typename MatrixType, typename VectorType>
+    void iterate(const MatrixType& A, VectorType& x);
+};
+
+} // end namespace relaxation
+} // end namespace cusp
+
+#include <cusp/relaxation/detail/chebyshev.inl>
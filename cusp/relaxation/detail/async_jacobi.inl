@@ -0,0 +1,267 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+/*! \file async_jacobi.inl
+ *  \brief Inline file for async_jacobi.h
+ */
+
+#include <cusp/exception.h>
+#include <cusp/detail/format_utils.h>
+#include <cusp/detail/device/async_jacobi.h>
+#include <cusp/detail/host/parallel.h>
+
+#include <thrust/copy.h>
+#include <thrust/fill.h>
+#include <thrust/transform.h>
+
+#include <algorithm>
+
+namespace cusp
+{
+namespace relaxation
+{
+namespace detail
+{
+
+template <typename ValueType>
+struct async_jacobi_reciprocal
+{
+    __host__ __device__
+    ValueType operator()(const ValueType& d) const
+    {
+        return ValueType(1) / d;
+    }
+};
+
+// relaxes the rows [first, last) of one block on the host, reading the
+// other rows from the copy x_old of x
+template <typename IndexType, typename ValueType>
+void async_jacobi_block(const IndexType * Ap, const IndexType * Aj, const ValueType * Ax,
+                        const ValueType * inv_diagonal, const ValueType * b,
+                        const ValueType * x_old, ValueType * x, ValueType * work,
+                        const IndexType first, const IndexType last,
+                        const ValueType omega, const size_t local_sweeps,
+                        const bool gauss_seidel, const bool backward)
+{
+    for(size_t sweep = 0; sweep < local_sweeps; sweep++)
+    {
+        // Gauss-Seidel sweeps update x in place, Jacobi sweeps through work
+        ValueType * x_new = gauss_seidel ? x : work;
+
+        for(IndexType n = first; n < last; n++)
+        {
+            const IndexType row = backward ? first + last - 1 - n : n;
+
+            ValueType sum = b[row];
+
+            for(IndexType jj = Ap[row]; jj < Ap[row + 1]; jj++)
+            {
+                const IndexType j = Aj[jj];
+
+                sum -= Ax[jj] * (j >= first && j < last ? x[j] : x_old[j]);
+            }
+
+            x_new[row] = x[row] + omega * sum * inv_diagonal[row];
+        }
+
+        if (!gauss_seidel)
+            std::copy(work + first, work + last, x + first);
+    }
+}
+
+} // end namespace detail
+
+
+// constructor
+template <typename ValueType, typename MemorySpace>
+    async_jacobi<ValueType,MemorySpace>
+    ::async_jacobi() : default_omega(0.0), local_sweeps(0), block_size(0), local_gauss_seidel(true)
+    {
+    }
+
+template <typename ValueType, typename MemorySpace>
+template<typename MemorySpace2>
+    async_jacobi<ValueType,MemorySpace>
+    ::async_jacobi(const async_jacobi<ValueType,MemorySpace2>& A)
+        : default_omega(A.default_omega), local_sweeps(A.local_sweeps), block_size(A.block_size),
+          local_gauss_seidel(A.local_gauss_seidel), matrix(A.matrix), inv_diagonal(A.inv_diagonal)
+    {
+        this->num_rows    = A.num_rows;
+        this->num_cols    = A.num_cols;
+        this->num_entries = A.num_entries;
+    }
+
+template <typename ValueType, typename MemorySpace>
+template<typename MatrixType>
+    async_jacobi<ValueType,MemorySpace>
+    ::async_jacobi(const MatrixType& A, ValueType omega, size_t local_sweeps, size_t block_size, bool local_gauss_seidel)
+        : default_omega(omega), local_sweeps(local_sweeps), block_size(block_size), local_gauss_seidel(local_gauss_seidel)
+    {
+        setup(A);
+    }
+
+template <typename ValueType, typename MemorySpace>
+template<typename MatrixType>
+    async_jacobi<ValueType,MemorySpace>
+    ::async_jacobi(const cusp::precond::aggregation::sa_level<MatrixType>& sa_level, ValueType omega,
+                   size_t local_sweeps, size_t block_size, bool local_gauss_seidel)
+        : default_omega(omega), local_sweeps(local_sweeps), block_size(block_size), local_gauss_seidel(local_gauss_seidel)
+    {
+        setup(sa_level.A_);
+    }
+
+template <typename ValueType, typename MemorySpace>
+template<typename MatrixType>
+    void async_jacobi<ValueType,MemorySpace>
+    ::setup(const MatrixType& A)
+    {
+        CUSP_PROFILE_SCOPED();
+
+        // the device kernels are instantiated for these block sizes
+        if (block_size < 32 || block_size > 1024 || (block_size & (block_size - 1)) != 0)
+            throw cusp::invalid_input_exception("async_jacobi block_size must be a power of two from 32 to 1024");
+
+        if (local_sweeps == 0)
+            throw cusp::invalid_input_exception("async_jacobi requires at least one local sweep");
+
+        matrix = A;
+
+        cusp::detail::extract_diagonal(A, inv_diagonal);
+        thrust::transform(inv_diagonal.begin(), inv_diagonal.end(), inv_diagonal.begin(),
+                          detail::async_jacobi_reciprocal<ValueType>());
+
+        this->num_rows    = A.num_rows;
+        this->num_cols    = A.num_cols;
+        this->num_entries = matrix.num_entries;
+    }
+
+template <typename ValueType, typename MemorySpace>
+template<typename VectorType1, typename VectorType2>
+    void async_jacobi<ValueType,MemorySpace>
+    ::relax_blocks(const VectorType1& b, VectorType2& x, ValueType omega, bool backward, cusp::host_memory)
+    {
+        const size_t N          = matrix.num_rows;
+        const size_t num_blocks = (N + block_size - 1) / block_size;
+
+        temp.resize(N);
+        work.resize(N);
+
+        thrust::copy(x.begin(), x.end(), temp.begin());
+
+        const int *       Ap    = thrust::raw_pointer_cast(&matrix.row_offsets[0]);
+        const int *       Aj    = thrust::raw_pointer_cast(&matrix.column_indices[0]);
+        const ValueType * Ax    = thrust::raw_pointer_cast(&matrix.values[0]);
+        const ValueType * d     = thrust::raw_pointer_cast(&inv_diagonal[0]);
+        const ValueType * b_ptr = thrust::raw_pointer_cast(&b[0]);
+        const ValueType * x_old = thrust::raw_pointer_cast(&temp[0]);
+        ValueType *       x_ptr = thrust::raw_pointer_cast(&x[0]);
+        ValueType *       w_ptr = thrust::raw_pointer_cast(&work[0]);
+
+        const int P = cusp::detail::host::num_parts(N + matrix.num_entries);
+
+        // every block only writes its own rows
+#ifdef _OPENMP
+        #pragma omp parallel for schedule(static) num_threads(P)
+#endif
+        for(int part = 0; part < P; part++)
+        {
+            const size_t block_end = cusp::detail::host::uniform_split(num_blocks, part + 1, P);
+
+            for(size_t block = cusp::detail::host::uniform_split(num_blocks, part, P); block < block_end; block++)
+            {
+                const int first = block * block_size;
+                const int last  = std::min(first + block_size, N);
+
+                detail::async_jacobi_block(Ap, Aj, Ax, d, b_ptr, x_old, x_ptr, w_ptr, first, last,
+                                           omega, local_sweeps, local_gauss_seidel, backward);
+            }
+        }
+    }
+
+template <typename ValueType, typename MemorySpace>
+template<typename VectorType1, typename VectorType2>
+    void async_jacobi<ValueType,MemorySpace>
+    ::relax_blocks(const VectorType1& b, VectorType2& x, ValueType omega, bool backward, cusp::device_memory)
+    {
+        cusp::detail::device::async_jacobi_step(int(matrix.num_rows), block_size,
+                                                thrust::raw_pointer_cast(&matrix.row_offsets[0]),
+                                                thrust::raw_pointer_cast(&matrix.column_indices[0]),
+                                                thrust::raw_pointer_cast(&matrix.values[0]),
+                                                thrust::raw_pointer_cast(&inv_diagonal[0]),
+                                                thrust::raw_pointer_cast(&b[0]),
+                                                thrust::raw_pointer_cast(&x[0]),
+                                                omega, int(local_sweeps), local_gauss_seidel, backward);
+    }
+
+template <typename ValueType, typename MemorySpace>
+template<typename VectorType1, typename VectorType2>
+    void async_jacobi<ValueType,MemorySpace>
+    ::step(const VectorType1& b, VectorType2& x, ValueType omega, bool backward)
+    {
+        CUSP_PROFILE_SCOPED();
+
+        if (matrix.num_rows == 0)
+            return;
+
+        relax_blocks(b, x, omega, backward, MemorySpace());
+    }
+
+// linear_operator
+template <typename ValueType, typename MemorySpace>
+template<typename MatrixType, typename VectorType1, typename VectorType2>
+    void async_jacobi<ValueType,MemorySpace>
+    ::operator()(const MatrixType& A, const VectorType1& b, VectorType2& x)
+    {
+        async_jacobi<ValueType,MemorySpace>::operator()(A,b,x,default_omega);
+    }
+
+// override default omega
+template <typename ValueType, typename MemorySpace>
+template<typename MatrixType, typename VectorType1, typename VectorType2>
+    void async_jacobi<ValueType,MemorySpace>
+    ::operator()(const MatrixType&, const VectorType1& b, VectorType2& x, ValueType omega)
+    {
+        CUSP_PROFILE_SCOPED();
+
+        step(b, x, omega, false);
+        step(b, x, omega, true);
+    }
+
+template <typename ValueType, typename MemorySpace>
+template<typename MatrixType, typename VectorType1, typename VectorType2>
+    void async_jacobi<ValueType,MemorySpace>
+    ::presmooth(const MatrixType&, const VectorType1& b, VectorType2& x)
+    {
+        CUSP_PROFILE_SCOPED();
+
+        // x <- 0, then a forward step
+        thrust::fill(x.begin(), x.end(), ValueType(0));
+        step(b, x, default_omega, false);
+    }
+
+template <typename ValueType, typename MemorySpace>
+template<typename MatrixType, typename VectorType1, typename VectorType2>
+    void async_jacobi<ValueType,MemorySpace>
+    ::postsmooth(const MatrixType&, const VectorType1& b, VectorType2& x)
+    {
+        CUSP_PROFILE_SCOPED();
+
+        step(b, x, default_omega, true);
+    }
+
+} // end namespace relaxation
+} // end namespace cusp
@@ -0,0 +1,238 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*! \file chebyshev.inl
+ *  \brief Inline file for chebyshev.h
+ */
+
+#include <cusp/multiply.h>
+#include <cusp/detail/format_utils.h>
+#include <cusp/detail/spectral_radius.h>
+#include <cusp/detail/stream.h>
+
+#include <thrust/transform.h>
+#include <thrust/iterator/constant_iterator.h>
+#include <thrust/iterator/zip_iterator.h>
+
+#include <algorithm>
+
+namespace cusp
+{
+namespace relaxation
+{
+namespace detail
+{
+
+template <typename ValueType>
+struct chebyshev_reciprocal
+{
+    __host__ __device__
+    ValueType operator()(const ValueType& d) const
+    {
+        return ValueType(1) / d;
+    }
+};
+
+// r <- D^-1 (b - A x), d <- r / theta, x <- x + d
+template <typename ValueType>
+struct chebyshev_initial_functor
+{
+    ValueType inv_theta;
+    bool zero_initial_guess;
+
+    chebyshev_initial_functor(ValueType inv_theta, bool zero_initial_guess)
+        : inv_theta(inv_theta), zero_initial_guess(zero_initial_guess) {}
+
+    // (x, r, d, D^-1, b, A x)
+    template <typename Tuple>
+    __host__ __device__
+    void operator()(Tuple t) const
+    {
+        const ValueType r = thrust::get<3>(t) * (thrust::get<4>(t) - thrust::get<5>(t));
+        const ValueType d = r * inv_theta;
+
+        thrust::get<1>(t) = r;
+        thrust::get<2>(t) = d;
+        thrust::get<0>(t) = zero_initial_guess ? d : ValueType(thrust::get<0>(t) + d);
+    }
+};
+
+// r <- r - D^-1 A d, d <- alpha d + beta r, x <- x + d
+template <typename ValueType>
+struct chebyshev_step_functor
+{
+    ValueType alpha;
+    ValueType beta;
+
+    chebyshev_step_functor(ValueType alpha, ValueType beta)
+        : alpha(alpha), beta(beta) {}
+
+    // (x, r, d, D^-1, A d)
+    template <typename Tuple>
+    __host__ __device__
+    void operator()(Tuple t) const
+    {
+        const ValueType r = thrust::get<1>(t) - thrust::get<3>(t) * thrust::get<4>(t);
+        const ValueType d = alpha * thrust::get<2>(t) + beta * r;
+
+        thrust::get<1>(t) = r;
+        thrust::get<2>(t) = d;
+        thrust::get<0>(t) += d;
+    }
+};
+
+} // end namespace detail
+
+
+// constructor
+template <typename ValueType, typename MemorySpace>
+    chebyshev<ValueType,MemorySpace>
+    ::chebyshev() : degree(0), lower_bound(0), upper_bound(0)
+    {
+    }
+
+template <typename ValueType, typename MemorySpace>
+template<typename MemorySpace2>
+    chebyshev<ValueType,MemorySpace>
+    ::chebyshev(const chebyshev<ValueType,MemorySpace2>& A)
+        : degree(A.degree), lower_bound(A.lower_bound), upper_bound(A.upper_bound),
+          inv_diagonal(A.inv_diagonal), residual(A.residual), direction(A.direction), temp(A.temp)
+    {
+    }
+
+template <typename ValueType, typename MemorySpace>
+template<typename MatrixType>
+    chebyshev<ValueType,MemorySpace>
+    ::chebyshev(const MatrixType& A, size_t degree, ValueType lower, ValueType upper)
+        : degree(degree)
+    {
+        setup(A, 0.0, lower, upper);
+    }
+
+template <typename ValueType, typename MemorySpace>
+template<typename MatrixType>
+    chebyshev<ValueType,MemorySpace>
+    ::chebyshev(const cusp::precond::aggregation::sa_level<MatrixType>& sa_level, size_t degree)
+        : degree(degree)
+    {
+        setup(sa_level.A_, sa_level.rho_DinvA, ValueType(1.0/30.0), ValueType(1.1));
+    }
+
+template <typename ValueType, typename MemorySpace>
+template<typename MatrixType>
+    void chebyshev<ValueType,MemorySpace>
+    ::setup(const MatrixType& A, double rho, ValueType lower, ValueType upper)
+    {
+        CUSP_PROFILE_SCOPED();
+
+        if(rho == 0)
+          rho = cusp::detail::estimate_spectral_radius_Dinv_A(A, 10);
+
+        // the power iteration approaches rho from below, so the interval is
+        // widened by upper but need not exceed the Gershgorin bound
+        lower_bound = lower * rho;
+        upper_bound = std::min(upper * rho, cusp::detail::disks_spectral_radius_Dinv_A(A));
+
+        // extract the main diagonal
+        cusp::detail::extract_diagonal(A, inv_diagonal);
+        thrust::transform(inv_diagonal.begin(), inv_diagonal.end(), inv_diagonal.begin(),
+                          detail::chebyshev_reciprocal<ValueType>());
+
+        residual.resize(A.num_rows);
+        direction.resize(A.num_rows);
+        temp.resize(A.num_rows);
+    }
+
+template <typename ValueType, typename MemorySpace>
+template<typename MatrixType, typename VectorType>
+    void chebyshev<ValueType,MemorySpace>
+    ::iterate(const MatrixType& A, VectorType& x)
+    {
+        const ValueType theta = (upper_bound + lower_bound) / 2;
+        const ValueType delta = (upper_bound - lower_bound) / 2;
+        const ValueType sigma = theta / delta;
+
+        ValueType rho = 1 / sigma;
+
+        for(size_t k = 1; k < degree; k++)
+        {
+            const ValueType rho_next = 1 / (2 * sigma - rho);
+
+            // y <- A*d
+            cusp::multiply(A, direction, temp);
+
+            cusp::detail::stream::for_each(thrust::make_zip_iterator(thrust::make_tuple(x.begin(), residual.begin(), direction.begin(), inv_diagonal.begin(), temp.begin())),
+                                           thrust::make_zip_iterator(thrust::make_tuple(x.end(),   residual.end(),   direction.end(),   inv_diagonal.end(),   temp.end())),
+                                           detail::chebyshev_step_functor<ValueType>(rho_next * rho, 2 * rho_next / delta));
+
+            rho = rho_next;
+        }
+    }
+
+// linear_operator
+template <typename ValueType, typename MemorySpace>
+template<typename MatrixType, typename VectorType1, typename VectorType2>
+    void chebyshev<ValueType,MemorySpace>
+    ::operator()(const MatrixType& A, const VectorType1& b, VectorType2& x)
+    {
+        postsmooth(A, b, x);
+    }
+
+template <typename ValueType, typename MemorySpace>
+template<typename MatrixType, typename VectorType1, typename VectorType2>
+    void chebyshev<ValueType,MemorySpace>
+    ::presmooth(const MatrixType& A, const VectorType1& b, VectorType2& x)
+    {
+        CUSP_PROFILE_SCOPED();
+
+        if(degree == 0)
+          return;
+
+        const ValueType theta = (upper_bound + lower_bound) / 2;
+
+        // x <- D^-1 b / theta, which skips the SpMV of the zero initial guess
+        cusp::detail::stream::for_each(thrust::make_zip_iterator(thrust::make_tuple(x.begin(), residual.begin(), direction.begin(), inv_diagonal.begin(), b.begin(), thrust::constant_iterator<ValueType>(0))),
+                                       thrust::make_zip_iterator(thrust::make_tuple(x.end(),   residual.end(),   direction.end(),   inv_diagonal.end(),   b.end(),   thrust::constant_iterator<ValueType>(0))),
+                                       detail::chebyshev_initial_functor<ValueType>(1 / theta, true));
+
+        iterate(A, x);
+    }
+
+template <typename ValueType, typename MemorySpace>
+template<typename MatrixType, typename VectorType1, typename VectorType2>
+    void chebyshev<ValueType,MemorySpace>
+    ::postsmooth(const MatrixType& A, const VectorType1& b, VectorType2& x)
+    {
+        CUSP_PROFILE_SCOPED();
+
+        if(degree == 0)
+          return;
+
+        const ValueType theta = (upper_bound + lower_bound) / 2;
+
+        // y <- A*x
+        cusp::multiply(A, x, temp);
+
+        // x <- x + D^-1 (b - y) / theta
+        cusp::detail::stream::for_each(thrust::make_zip_iterator(thrust::make_tuple(x.begin(), residual.begin(), direction.begin(), inv_diagonal.begin(), b.begin(), temp.begin())),
+                                       thrust::make_zip_iterator(thrust::make_tuple(x.end(),   residual.end(),   direction.end(),   inv_diagonal.end(),   b.end(),   temp.end())),
+                                       detail::chebyshev_initial_functor<ValueType>(1 / theta, false));
+
+        iterate(A, x);
+    }
+
+} // end namespace relaxation
+} // end namespace cusp
@@ -0,0 +1,261 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*! \file gauss_seidel.inl
+ *  \brief Inline file for gauss_seidel.h
+ */
+
+#include <cusp/coo_matrix.h>
+#include <cusp/detail/format_utils.h>
+#include <cusp/detail/stream.h>
+#include <cusp/graph/vertex_coloring.h>
+
+#include <thrust/fill.h>
+#include <thrust/gather.h>
+#include <thrust/scatter.h>
+#include <thrust/sequence.h>
+#include <thrust/sort.h>
+#include <thrust/transform.h>
+#include <thrust/iterator/counting_iterator.h>
+
+namespace cusp
+{
+namespace relaxation
+{
+namespace detail
+{
+
+template <typename ValueType>
+struct gauss_seidel_reciprocal
+{
+    __host__ __device__
+    ValueType operator()(const ValueType& d) const
+    {
+        return ValueType(1) / d;
+    }
+};
+
+// x[i] <- x[i] + omega * (b[i] - A[i,:] x) / A[i,i] for the row p of a color
+template <typename IndexType, typename ValueType>
+struct gauss_seidel_row
+{
+    const IndexType * row_offsets;
+    const IndexType * column_indices;
+    const ValueType * values;
+    const IndexType * ordered_rows;
+    const ValueType * inv_diagonal;
+    const ValueType * b;
+    ValueType * x;
+    ValueType omega;
+
+    gauss_seidel_row(const IndexType * row_offsets, const IndexType * column_indices, const ValueType * values,
+                     const IndexType * ordered_rows, const ValueType * inv_diagonal,
+                     const ValueType * b, ValueType * x, ValueType omega)
+        : row_offsets(row_offsets), column_indices(column_indices), values(values),
+          ordered_rows(ordered_rows), inv_diagonal(inv_diagonal), b(b), x(x), omega(omega) {}
+
+    __host__ __device__
+    void operator()(const IndexType p) const
+    {
+        const IndexType row = ordered_rows[p];
+
+        ValueType sum = b[row];
+
+        for(IndexType jj = row_offsets[p]; jj < row_offsets[p + 1]; jj++)
+            sum -= values[jj] * x[column_indices[jj]];
+
+        x[row] += omega * sum * inv_diagonal[p];
+    }
+};
+
+} // end namespace detail
+
+
+// constructor
+template <typename ValueType, typename MemorySpace>
+    gauss_seidel<ValueType,MemorySpace>
+    ::gauss_seidel() : default_omega(0.0)
+    {
+    }
+
+template <typename ValueType, typename MemorySpace>
+template<typename MemorySpace2>
+    gauss_seidel<ValueType,MemorySpace>
+    ::gauss_seidel(const gauss_seidel<ValueType,MemorySpace2>& A)
+        : default_omega(A.default_omega), ordered_A(A.ordered_A), ordered_rows(A.ordered_rows),
+          inv_diagonal(A.inv_diagonal), color_offsets(A.color_offsets)
+    {
+    }
+
+template <typename ValueType, typename MemorySpace>
+template<typename MatrixType>
+    gauss_seidel<ValueType,MemorySpace>
+    ::gauss_seidel(const MatrixType& A, ValueType omega)
+        : default_omega(omega)
+    {
+        setup(A);
+    }
+
+template <typename ValueType, typename MemorySpace>
+template<typename MatrixType>
+    gauss_seidel<ValueType,MemorySpace>
+    ::gauss_seidel(const cusp::precond::aggregation::sa_level<MatrixType>& sa_level, ValueType omega)
+        : default_omega(omega)
+    {
+        setup(sa_level.A_);
+    }
+
+template <typename ValueType, typename MemorySpace>
+template<typename MatrixType>
+    void gauss_seidel<ValueType,MemorySpace>
+    ::setup(const MatrixType& A)
+    {
+        CUSP_PROFILE_SCOPED();
+
+        typedef thrust::counting_iterator<int,MemorySpace> CountingIterator;
+
+        const size_t N = A.num_rows;
+
+        cusp::coo_matrix<int,ValueType,MemorySpace> C(A);
+
+        // group the rows by color
+        cusp::array1d<int,MemorySpace> colors;
+        const size_t num_colors = cusp::graph::vertex_coloring(C, colors);
+
+        ordered_rows.resize(N);
+        thrust::sequence(ordered_rows.begin(), ordered_rows.end());
+        thrust::stable_sort_by_key(colors.begin(), colors.end(), ordered_rows.begin());
+
+        cusp::array1d<int,MemorySpace> offsets(num_colors + 1);
+        cusp::detail::indices_to_offsets(colors, offsets);
+
+        cusp::array1d<int,cusp::host_memory> h_offsets(offsets);
+        color_offsets.assign(h_offsets.begin(), h_offsets.end());
+
+        // store the rows in color order
+        cusp::array1d<int,MemorySpace> positions(N);
+        thrust::scatter(CountingIterator(0), CountingIterator(N), ordered_rows.begin(), positions.begin());
+
+        cusp::array1d<int,MemorySpace> ordered_row_indices(C.num_entries);
+        thrust::gather(C.row_indices.begin(), C.row_indices.end(), positions.begin(), ordered_row_indices.begin());
+        C.row_indices.swap(ordered_row_indices);
+        C.sort_by_row();
+
+        ordered_A = C;
+
+        // the diagonal in color order
+        cusp::array1d<ValueType,MemorySpace> diagonal;
+        cusp::detail::extract_diagonal(A, diagonal);
+
+        inv_diagonal.resize(N);
+        thrust::gather(ordered_rows.begin(), ordered_rows.end(), diagonal.begin(), inv_diagonal.begin());
+        thrust::transform(inv_diagonal.begin(), inv_diagonal.end(), inv_diagonal.begin(),
+                          detail::gauss_seidel_reciprocal<ValueType>());
+
+        this->num_rows    = N;
+        this->num_cols    = A.num_cols;
+        this->num_entries = C.num_entries;
+    }
+
+template <typename ValueType, typename MemorySpace>
+template<typename VectorType1, typename VectorType2>
+    void gauss_seidel<ValueType,MemorySpace>
+    ::sweep_color(const size_t color, const VectorType1& b, VectorType2& x, ValueType omega) const
+    {
+        typedef thrust::counting_iterator<int,MemorySpace> CountingIterator;
+
+        detail::gauss_seidel_row<int,ValueType> f(thrust::raw_pointer_cast(ordered_A.row_offsets.data()),
+                                                  thrust::raw_pointer_cast(ordered_A.column_indices.data()),
+                                                  thrust::raw_pointer_cast(ordered_A.values.data()),
+                                                  thrust::raw_pointer_cast(ordered_rows.data()),
+                                                  thrust::raw_pointer_cast(inv_diagonal.data()),
+                                                  thrust::raw_pointer_cast(&b[0]),
+                                                  thrust::raw_pointer_cast(&x[0]),
+                                                  omega);
+
+        cusp::detail::stream::for_each(CountingIterator(color_offsets[color]),
+                                       CountingIterator(color_offsets[color + 1]),
+                                       f);
+    }
+
+template <typename ValueType, typename MemorySpace>
+template<typename VectorType1, typename VectorType2>
+    void gauss_seidel<ValueType,MemorySpace>
+    ::forward_sweep(const VectorType1& b, VectorType2& x, ValueType omega) const
+    {
+        CUSP_PROFILE_SCOPED();
+
+        for(size_t color = 0; color < num_colors(); color++)
+            sweep_color(color, b, x, omega);
+    }
+
+template <typename ValueType, typename MemorySpace>
+template<typename VectorType1, typename VectorType2>
+    void gauss_seidel<ValueType,MemorySpace>
+    ::backward_sweep(const VectorType1& b, VectorType2& x, ValueType omega) const
+    {
+        CUSP_PROFILE_SCOPED();
+
+        for(size_t color = num_colors(); color > 0; color--)
+            sweep_color(color - 1, b, x, omega);
+    }
+
+// linear_operator
+template <typename ValueType, typename MemorySpace>
+template<typename MatrixType, typename VectorType1, typename VectorType2>
+    void gauss_seidel<ValueType,MemorySpace>
+    ::operator()(const MatrixType& A, const VectorType1& b, VectorType2& x)
+    {
+        gauss_seidel<ValueType,MemorySpace>::operator()(A,b,x,default_omega);
+    }
+
+// override default omega
+template <typename ValueType, typename MemorySpace>
+template<typename MatrixType, typename VectorType1, typename VectorType2>
+    void gauss_seidel<ValueType,MemorySpace>
+    ::operator()(const MatrixType&, const VectorType1& b, VectorType2& x, ValueType omega)
+    {
+        CUSP_PROFILE_SCOPED();
+
+        forward_sweep(b, x, omega);
+        backward_sweep(b, x, omega);
+    }
+
+template <typename ValueType, typename MemorySpace>
+template<typename MatrixType, typename VectorType1, typename VectorType2>
+    void gauss_seidel<ValueType,MemorySpace>
+    ::presmooth(const MatrixType&, const VectorType1& b, VectorType2& x)
+    {
+        CUSP_PROFILE_SCOPED();
+
+        // x <- 0, then a forward sweep
+        thrust::fill(x.begin(), x.end(), ValueType(0));
+        forward_sweep(b, x, default_omega);
+    }
+
+template <typename ValueType, typename MemorySpace>
+template<typename MatrixType, typename VectorType1, typename VectorType2>
+    void gauss_seidel<ValueType,MemorySpace>
+    ::postsmooth(const MatrixType&, const VectorType1& b, VectorType2& x)
+    {
+        CUSP_PROFILE_SCOPED();
+
+        backward_sweep(b, x, default_omega);
+    }
+
+} // end namespace relaxation
+} // end namespace cusp
+
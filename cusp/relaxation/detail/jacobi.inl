@@ -18,12 +18,18 @@
  *  \brief Inline file for jacobi.h
  */
 
+#include <cusp/blas.h>
+#include <cusp/format.h>
 #include <cusp/multiply.h>
 #include <cusp/detail/format_utils.h>
+#include <cusp/detail/stream.h>
 #include <cusp/precond/aggregation/smoothed_aggregation_options.h>
 
+#include <thrust/copy.h>
 #include <thrust/functional.h>
+#include <thrust/swap.h>
 #include <thrust/transform.h>
+#include <thrust/iterator/counting_iterator.h>
 #include <thrust/iterator/zip_iterator.h>
 
 namespace cusp
@@ -67,13 +73,204 @@ struct jacobi_postsmooth_functor
     }
 };
 
+// fused pass over row i: the residual r = b[i] - A[i,:] x is written to
+// residual and x + omega * r / d to x_next, each unless it is NULL
+template <typename IndexType, typename MatrixValueType, typename ValueType>
+struct jacobi_csr_row
+{
+    const IndexType * row_offsets;
+    const IndexType * column_indices;
+    const MatrixValueType * values;
+    const ValueType * diagonal;
+    const ValueType * b;
+    const ValueType * x;
+    ValueType * x_next;
+    ValueType * residual;
+    ValueType omega;
+
+    jacobi_csr_row(const IndexType * row_offsets, const IndexType * column_indices, const MatrixValueType * values,
+                   const ValueType * diagonal, const ValueType * b, const ValueType * x,
+                   ValueType * x_next, ValueType * residual, ValueType omega)
+        : row_offsets(row_offsets), column_indices(column_indices), values(values),
+          diagonal(diagonal), b(b), x(x), x_next(x_next), residual(residual), omega(omega) {}
+
+    __host__ __device__
+    void operator()(const IndexType i) const
+    {
+        ValueType sum = b[i];
+
+        for(IndexType jj = row_offsets[i]; jj < row_offsets[i + 1]; jj++)
+            sum -= values[jj] * x[column_indices[jj]];
+
+        if (residual != NULL)
+            residual[i] = sum;
+        if (x_next != NULL)
+            x_next[i] = x[i] + omega * sum / diagonal[i];
+    }
+};
+
+// same as jacobi_csr_row for the column-major ELL arrays
+template <typename IndexType, typename MatrixValueType, typename ValueType>
+struct jacobi_ell_row
+{
+    IndexType pitch;
+    IndexType num_entries_per_row;
+    IndexType invalid_index;
+    const IndexType * column_indices;
+    const MatrixValueType * values;
+    const ValueType * diagonal;
+    const ValueType * b;
+    const ValueType * x;
+    ValueType * x_next;
+    ValueType * residual;
+    ValueType omega;
+
+    jacobi_ell_row(IndexType pitch, IndexType num_entries_per_row, IndexType invalid_index,
+                   const IndexType * column_indices, const MatrixValueType * values,
+                   const ValueType * diagonal, const ValueType * b, const ValueType * x,
+                   ValueType * x_next, ValueType * residual, ValueType omega)
+        : pitch(pitch), num_entries_per_row(num_entries_per_row), invalid_index(invalid_index),
+          column_indices(column_indices), values(values),
+          diagonal(diagonal), b(b), x(x), x_next(x_next), residual(residual), omega(omega) {}
+
+    __host__ __device__
+    void operator()(const IndexType i) const
+    {
+        ValueType sum = b[i];
+
+        for(IndexType n = 0, offset = i; n < num_entries_per_row; n++, offset += pitch)
+        {
+            const IndexType j = column_indices[offset];
+
+            if (j != invalid_index)
+                sum -= values[offset] * x[j];
+        }
+
+        if (residual != NULL)
+            residual[i] = sum;
+        if (x_next != NULL)
+            x_next[i] = x[i] + omega * sum / diagonal[i];
+    }
+};
+
+template <typename MatrixType, typename ValueType>
+void jacobi_row_pass(const MatrixType& A, const ValueType * diagonal, const ValueType * b, const ValueType * x,
+                     ValueType * x_next, ValueType * residual, ValueType omega, cusp::csr_format)
+{
+    typedef typename MatrixType::index_type   IndexType;
+    typedef typename MatrixType::value_type   MatrixValueType;
+    typedef typename MatrixType::memory_space MemorySpace;
+
+    cusp::detail::stream::for_each(thrust::counting_iterator<IndexType,MemorySpace>(0),
+                                   thrust::counting_iterator<IndexType,MemorySpace>(A.num_rows),
+                                   jacobi_csr_row<IndexType,MatrixValueType,ValueType>
+                                       (thrust::raw_pointer_cast(&A.row_offsets[0]),
+                                        thrust::raw_pointer_cast(&A.column_indices[0]),
+                                        thrust::raw_pointer_cast(&A.values[0]),
+                                        diagonal, b, x, x_next, residual, omega));
+}
+
+template <typename MatrixType, typename ValueType>
+void jacobi_row_pass(const MatrixType& A, const ValueType * diagonal, const ValueType * b, const ValueType * x,
+                     ValueType * x_next, ValueType * residual, ValueType omega, cusp::ell_format)
+{
+    typedef typename MatrixType::index_type   IndexType;
+    typedef typename MatrixType::value_type   MatrixValueType;
+    typedef typename MatrixType::memory_space MemorySpace;
+
+    const IndexType num_entries_per_row = A.column_indices.num_cols;
+
+    cusp::detail::stream::for_each(thrust::counting_iterator<IndexType,MemorySpace>(0),
+                                   thrust::counting_iterator<IndexType,MemorySpace>(A.num_rows),
+                                   jacobi_ell_row<IndexType,MatrixValueType,ValueType>
+                                       (IndexType(A.column_indices.pitch), num_entries_per_row, IndexType(MatrixType::invalid_index),
+                                        num_entries_per_row == 0 ? (const IndexType *) NULL : thrust::raw_pointer_cast(&A.column_indices.values[0]),
+                                        num_entries_per_row == 0 ? (const MatrixValueType *) NULL : thrust::raw_pointer_cast(&A.values.values[0]),
+                                        diagonal, b, x, x_next, residual, omega));
+}
+
+// sweeps of the formats with a fused row pass alternate between x and work
+template <typename MatrixType, typename Array1, typename Array2, typename Array3, typename Array4, typename ValueType>
+void jacobi_fused_sweeps(const MatrixType& A, const Array1& diagonal, const Array2& b, Array3& x, Array4& work,
+                         size_t count, ValueType omega)
+{
+    work.resize(A.num_rows, cusp::uninitialized);
+
+    ValueType * x_ptr    = thrust::raw_pointer_cast(&x[0]);
+    ValueType * work_ptr = thrust::raw_pointer_cast(&work[0]);
+
+    for(size_t k = 0; k < count; k++)
+    {
+        jacobi_row_pass(A, thrust::raw_pointer_cast(&diagonal[0]), thrust::raw_pointer_cast(&b[0]),
+                        x_ptr, work_ptr, (ValueType *) NULL, omega, typename MatrixType::format());
+        thrust::swap(x_ptr, work_ptr);
+    }
+
+    // an odd number of sweeps leaves the result in work
+    if (count % 2 == 1)
+        thrust::copy(work.begin(), work.end(), x.begin());
+}
+
+template <typename MatrixType, typename Array1, typename Array2, typename Array3, typename Array4, typename Array5, typename ValueType>
+void jacobi_sweeps(const MatrixType& A, const Array1& diagonal, const Array2& b, Array3& x, Array4& work, Array5&,
+                   size_t count, ValueType omega, cusp::csr_format)
+{
+    jacobi_fused_sweeps(A, diagonal, b, x, work, count, omega);
+}
+
+template <typename MatrixType, typename Array1, typename Array2, typename Array3, typename Array4, typename Array5, typename ValueType>
+void jacobi_sweeps(const MatrixType& A, const Array1& diagonal, const Array2& b, Array3& x, Array4& work, Array5&,
+                   size_t count, ValueType omega, cusp::ell_format)
+{
+    jacobi_fused_sweeps(A, diagonal, b, x, work, count, omega);
+}
+
+// other formats perform an SpMV followed by an in-place update
+template <typename MatrixType, typename Array1, typename Array2, typename Array3, typename Array4, typename Array5, typename ValueType, typename Format>
+void jacobi_sweeps(const MatrixType& A, const Array1& diagonal, const Array2& b, Array3& x, Array4&, Array5& temp,
+                   size_t count, ValueType omega, Format)
+{
+    for(size_t k = 0; k < count; k++)
+    {
+        // y <- A*x
+        cusp::multiply(A, x, temp);
+
+        // x <- x + omega * D^-1 * (b - y)
+        cusp::detail::stream::transform(thrust::make_zip_iterator(thrust::make_tuple(x.begin(), diagonal.begin(), b.begin(), temp.begin())),
+                                        thrust::make_zip_iterator(thrust::make_tuple(x.end(),   diagonal.end(),   b.end(),   temp.end())),
+                                        x.begin(),
+                                        jacobi_postsmooth_functor<ValueType>(omega));
+    }
+}
+
+template <typename MatrixType, typename Array1, typename Array2, typename Array3, typename ValueType>
+void jacobi_residual(const MatrixType& A, const Array1& b, const Array2& x, Array3& residual, ValueType, cusp::csr_format)
+{
+    jacobi_row_pass(A, (const ValueType *) NULL, thrust::raw_pointer_cast(&b[0]), thrust::raw_pointer_cast(&x[0]),
+                    (ValueType *) NULL, thrust::raw_pointer_cast(&residual[0]), ValueType(0), cusp::csr_format());
+}
+
+template <typename MatrixType, typename Array1, typename Array2, typename Array3, typename ValueType>
+void jacobi_residual(const MatrixType& A, const Array1& b, const Array2& x, Array3& residual, ValueType, cusp::ell_format)
+{
+    jacobi_row_pass(A, (const ValueType *) NULL, thrust::raw_pointer_cast(&b[0]), thrust::raw_pointer_cast(&x[0]),
+                    (ValueType *) NULL, thrust::raw_pointer_cast(&residual[0]), ValueType(0), cusp::ell_format());
+}
+
+template <typename MatrixType, typename Array1, typename Array2, typename Array3, typename ValueType, typename Format>
+void jacobi_residual(const MatrixType& A, const Array1& b, const Array2& x, Array3& residual, ValueType, Format)
+{
+    // residual <- b - A*x
+    cusp::detail::residual(A, x, b, residual);
+}
+
 } // end namespace detail
 
 
 // constructor
 template <typename ValueType, typename MemorySpace>
     jacobi<ValueType,MemorySpace>
-    ::jacobi() : default_omega(0.0)
+    ::jacobi() : default_omega(0.0), sweeps(1)
     {
     }
 
@@ -81,15 +278,15 @@ template <typename ValueType, typename MemorySpace>
 template<typename MemorySpace2>
     jacobi<ValueType,MemorySpace>
     ::jacobi(const jacobi<ValueType,MemorySpace2>& A)
-        : default_omega(A.default_omega), temp(A.temp), diagonal(A.diagonal)
+        : default_omega(A.default_omega), sweeps(A.sweeps), diagonal(A.diagonal), temp(A.temp), work(A.work)
     {
     }
 
 template <typename ValueType, typename MemorySpace>
 template<typename MatrixType>
     jacobi<ValueType,MemorySpace>
-    ::jacobi(const MatrixType& A, ValueType omega)
-        : default_omega(omega), temp(A.num_rows)
+    ::jacobi(const MatrixType& A, ValueType omega, size_t sweeps)
+        : default_omega(omega), sweeps(sweeps), temp(A.num_rows)
     {
         CUSP_PROFILE_SCOPED();
 
@@ -100,8 +297,8 @@ template<typename MatrixType>
 template <typename ValueType, typename MemorySpace>
 template<typename MatrixType>
     jacobi<ValueType,MemorySpace>
-    ::jacobi(const cusp::precond::aggregation::sa_level<MatrixType>& sa_level, ValueType weight)
-        : temp(sa_level.A_.num_rows)
+    ::jacobi(const cusp::precond::aggregation::sa_level<MatrixType>& sa_level, ValueType weight, size_t sweeps)
+        : sweeps(sweeps), temp(sa_level.A_.num_rows)
     {
         CUSP_PROFILE_SCOPED();
 
@@ -118,6 +315,17 @@ template<typename MatrixType>
         cusp::detail::extract_diagonal(sa_level.A_, diagonal);
     }
 
+template <typename ValueType, typename MemorySpace>
+template<typename MatrixType, typename VectorType1, typename VectorType2>
+    void jacobi<ValueType,MemorySpace>
+    ::sweep(const MatrixType& A, const VectorType1& b, VectorType2& x, size_t count, ValueType omega)
+    {
+        if (count == 0 || A.num_rows == 0)
+          return;
+
+        detail::jacobi_sweeps(A, diagonal, b, x, work, temp, count, omega, typename MatrixType::format());
+    }
+
 // linear_operator
 template <typename ValueType, typename MemorySpace>
 template<typename MatrixType, typename VectorType1, typename VectorType2>
@@ -135,28 +343,26 @@ template<typename MatrixType, typename VectorType1, typename VectorType2>
     {
         CUSP_PROFILE_SCOPED();
 
-        // y <- A*x
-        cusp::multiply(A, x, temp);
-        
-        // x <- x + omega * D^-1 * (b - y)
-        thrust::transform(thrust::make_zip_iterator(thrust::make_tuple(x.begin(), diagonal.begin(), b.begin(), temp.begin())),
-                          thrust::make_zip_iterator(thrust::make_tuple(x.end(),   diagonal.end(),   b.end(),   temp.end())),
-                          x.begin(),
-                          detail::jacobi_postsmooth_functor<ValueType>(omega));
+        // x <- x + omega * D^-1 * (b - A*x)
+        sweep(A, b, x, 1, omega);
     }
 
 template <typename ValueType, typename MemorySpace>
 template<typename MatrixType, typename VectorType1, typename VectorType2>
     void jacobi<ValueType,MemorySpace>
-    ::presmooth(const MatrixType&, const VectorType1& b, VectorType2& x)
+    ::presmooth(const MatrixType& A, const VectorType1& b, VectorType2& x)
     {
         CUSP_PROFILE_SCOPED();
         
         // x <- omega * D^-1 * b 
-        thrust::transform(b.begin(), b.end(),
-                          diagonal.begin(),
-                          x.begin(),
-                          detail::jacobi_presmooth_functor<ValueType>(default_omega));
+        cusp::detail::stream::transform(b.begin(), b.end(),
+                                        diagonal.begin(),
+                                        x.begin(),
+                                        detail::jacobi_presmooth_functor<ValueType>(default_omega));
+
+        // the first sweep from x = 0 needs no SpMV
+        if (sweeps > 1)
+          sweep(A, b, x, sweeps - 1, default_omega);
     }
 
 template <typename ValueType, typename MemorySpace>
@@ -166,16 +372,50 @@ template<typename MatrixType, typename VectorType1, typename VectorType2>
     {
         CUSP_PROFILE_SCOPED();
 
-        // y <- A*x
-        cusp::multiply(A, x, temp);
-        
-        // x <- x + omega * D^-1 * (b - y)
-        thrust::transform(thrust::make_zip_iterator(thrust::make_tuple(x.begin(), diagonal.begin(), b.begin(), temp.begin())),
-                          thrust::make_zip_iterator(thrust::make_tuple(x.end(),   diagonal.end(),   b.end(),   temp.end())),
-                          x.begin(),
-                          detail::jacobi_postsmooth_functor<ValueType>(default_omega));
+        sweep(A, b, x, sweeps, default_omega);
+    }
+
+template <typename ValueType, typename MemorySpace>
+template<typename MatrixType, typename VectorType1, typename VectorType2, typename VectorType3>
+    void jacobi<ValueType,MemorySpace>
+    ::presmooth(const MatrixType& A, const VectorType1& b, VectorType2& x, VectorType3& residual)
+    {
+        CUSP_PROFILE_SCOPED();
+
+        presmooth(A, b, x);
+
+        if (A.num_rows > 0)
+          detail::jacobi_residual(A, b, x, residual, ValueType(0), typename MatrixType::format());
     }
 
+template <typename ValueType, typename MemorySpace>
+template<typename MatrixType, typename VectorType1, typename VectorType2, typename VectorType3>
+    void jacobi<ValueType,MemorySpace>
+    ::postsmooth(const MatrixType& A, const VectorType1& b, VectorType2& x, VectorType3& residual)
+    {
+        CUSP_PROFILE_SCOPED();
+
+        postsmooth(A, b, x);
+
+        if (A.num_rows > 0)
+          detail::jacobi_residual(A, b, x, residual, ValueType(0), typename MatrixType::format());
+    }
+
+template <typename ValueType, typename MemorySpace,
+          typename MatrixType, typename VectorType1, typename VectorType2, typename VectorType3>
+void presmooth_with_residual(jacobi<ValueType,MemorySpace>& smoother,
+                             const MatrixType& A, const VectorType1& b, VectorType2& x, VectorType3& residual)
+{
+    smoother.presmooth(A, b, x, residual);
+}
+
+template <typename ValueType, typename MemorySpace,
+          typename MatrixType, typename VectorType1, typename VectorType2, typename VectorType3>
+void postsmooth_with_residual(jacobi<ValueType,MemorySpace>& smoother,
+                              const MatrixType& A, const VectorType1& b, VectorType2& x, VectorType3& residual)
+{
+    smoother.postsmooth(A, b, x, residual);
+}
 
 } // end namespace relaxation
 } // end namespace cusp
@@ -0,0 +1,120 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*! \file l1_jacobi.inl
+ *  \brief Inline file for l1_jacobi.h
+ */
+
+#include <cusp/coo_matrix.h>
+#include <cusp/detail/format_utils.h>
+#include <cusp/detail/spectral_radius.h>
+
+#include <thrust/transform.h>
+
+namespace cusp
+{
+namespace relaxation
+{
+namespace detail
+{
+
+// A(i,i) + sum_{j != i} |A(i,j)| from the absolute row sum and A(i,i)
+template <typename ValueType>
+struct l1_diagonal_functor
+{
+    __host__ __device__
+    ValueType operator()(const ValueType& sum, const ValueType& d) const
+    {
+        return sum - (d < 0 ? -d : d) + d;
+    }
+};
+
+} // end namespace detail
+
+
+// constructor
+template <typename ValueType, typename MemorySpace>
+    l1_jacobi<ValueType,MemorySpace>
+    ::l1_jacobi() : Parent()
+    {
+    }
+
+template <typename ValueType, typename MemorySpace>
+template<typename MemorySpace2>
+    l1_jacobi<ValueType,MemorySpace>
+    ::l1_jacobi(const l1_jacobi<ValueType,MemorySpace2>& A)
+        : Parent(A)
+    {
+    }
+
+template <typename ValueType, typename MemorySpace>
+template<typename MatrixType>
+    l1_jacobi<ValueType,MemorySpace>
+    ::l1_jacobi(const MatrixType& A, ValueType omega)
+    {
+        Parent::default_omega = omega;
+        setup(A);
+    }
+
+template <typename ValueType, typename MemorySpace>
+template<typename MatrixType>
+    l1_jacobi<ValueType,MemorySpace>
+    ::l1_jacobi(const cusp::precond::aggregation::sa_level<MatrixType>& sa_level, ValueType omega)
+    {
+        Parent::default_omega = omega;
+        setup(sa_level.A_);
+    }
+
+template <typename ValueType, typename MemorySpace>
+template<typename MatrixType>
+    void l1_jacobi<ValueType,MemorySpace>
+    ::setup(const MatrixType& A)
+    {
+        CUSP_PROFILE_SCOPED();
+
+        typedef typename MatrixType::index_type IndexType;
+
+        const cusp::coo_matrix<IndexType,ValueType,MemorySpace> C(A);
+
+        cusp::array1d<ValueType,MemorySpace> row_sums;
+        cusp::detail::absolute_row_sums(C, row_sums);
+
+        // d_i <- A(i,i) + sum_{j != i} |A(i,j)|
+        cusp::detail::extract_diagonal(C, Parent::diagonal);
+        thrust::transform(row_sums.begin(), row_sums.end(), Parent::diagonal.begin(), Parent::diagonal.begin(),
+                          detail::l1_diagonal_functor<ValueType>());
+
+        Parent::temp.resize(A.num_rows);
+    }
+
+template <typename ValueType, typename MemorySpace,
+          typename MatrixType, typename VectorType1, typename VectorType2, typename VectorType3>
+void presmooth_with_residual(l1_jacobi<ValueType,MemorySpace>& smoother,
+                             const MatrixType& A, const VectorType1& b, VectorType2& x, VectorType3& residual)
+{
+    smoother.presmooth(A, b, x, residual);
+}
+
+template <typename ValueType, typename MemorySpace,
+          typename MatrixType, typename VectorType1, typename VectorType2, typename VectorType3>
+void postsmooth_with_residual(l1_jacobi<ValueType,MemorySpace>& smoother,
+                              const MatrixType& A, const VectorType1& b, VectorType2& x, VectorType3& residual)
+{
+    smoother.postsmooth(A, b, x, residual);
+}
+
+} // end namespace relaxation
+} // end namespace cusp
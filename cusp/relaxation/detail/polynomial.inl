@@ -23,6 +23,8 @@
 #include <cusp/detail/format_utils.h>
 #include <cusp/detail/spectral_radius.h>
 
+#include <thrust/extrema.h>
+
 #include <math.h>
 
 namespace cusp
@@ -109,7 +111,24 @@ polynomial<ValueType,MemorySpace>
 
     size_t N = sa_level.A_.num_rows;
 
-    ValueType rho = cusp::detail::ritz_spectral_radius_symmetric(sa_level.A_, 8);
+    typedef typename MatrixType::memory_space LevelMemorySpace;
+
+    ValueType rho;
+
+    if (sa_level.rho_DinvA != ValueType(0) && N > 0)
+    {
+        // reuse the estimate of rho(D^-1 A) of the level, since
+        // rho(A) <= rho(D^-1 A) max_i a_ii for a symmetric positive definite A
+        cusp::array1d<ValueType,LevelMemorySpace> diagonal;
+        cusp::detail::extract_diagonal(sa_level.A_, diagonal);
+
+        rho = sa_level.rho_DinvA * ValueType(*thrust::max_element(diagonal.begin(), diagonal.end()));
+    }
+    else
+    {
+        rho = cusp::detail::ritz_spectral_radius_symmetric(sa_level.A_, 8);
+    }
+
     detail::chebyshev_polynomial_coefficients(rho, default_coefficients);
     default_coefficients.resize( default_coefficients.size() - 1 );
 
@@ -0,0 +1,114 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*! \file gauss_seidel.h
+ *  \brief Multicolor Gauss-Seidel relaxation.
+ */
+
+#pragma once
+
+#include <cusp/detail/config.h>
+
+#include <cusp/array1d.h>
+#include <cusp/csr_matrix.h>
+#include <cusp/linear_operator.h>
+
+#include <vector>
+
+namespace cusp
+{
+namespace precond
+{
+namespace aggregation
+{
+// forward definitions
+template<typename MatrixType> struct sa_level;
+} // end namespace aggregation
+} // end namespace precond
+
+namespace relaxation
+{
+
+// Multicolor Gauss-Seidel (SOR when omega != 1).  The rows are colored with
+// cusp::graph::vertex_coloring and stored in color order, so the rows of a
+// color are contiguous and independent of each other.  A sweep updates the
+// colors one after another, each with a single SpMV-like launch.
+//
+// presmooth performs a forward sweep and postsmooth a backward sweep, so
+// a multilevel cycle remains symmetric and may be used with CG.  The sweeps
+// use the matrix given at construction, the pattern of which should be
+// symmetric.
+template <typename ValueType, typename MemorySpace>
+class gauss_seidel : public cusp::linear_operator<ValueType, MemorySpace>
+{
+public:
+    ValueType default_omega;
+    cusp::csr_matrix<int,ValueType,MemorySpace> ordered_A;  // rows of A in color order
+    cusp::array1d<int,MemorySpace> ordered_rows;            // row of A of each row of ordered_A
+    cusp::array1d<ValueType,MemorySpace> inv_diagonal;      // in color order
+    std::vector<size_t> color_offsets;                      // rows of each color in ordered_A
+
+    gauss_seidel();
+
+    template <typename MatrixType>
+    gauss_seidel(const MatrixType& A, ValueType omega=1.0);
+
+    template <typename MemorySpace2>
+    gauss_seidel(const gauss_seidel<ValueType,MemorySpace2>& A);
+
+    template <typename MatrixType>
+    gauss_seidel(const cusp::precond::aggregation::sa_level<MatrixType>& sa_level, ValueType omega=1.0);
+
+    size_t num_colors(void) const
+    {
+        return color_offsets.empty() ? 0 : color_offsets.size() - 1;
+    }
+
+    // updates the colors in increasing order
+    template <typename VectorType1, typename VectorType2>
+    void forward_sweep(const VectorType1& b, VectorType2& x, ValueType omega) const;
+
+    // updates the colors in decreasing order
+    template <typename VectorType1, typename VectorType2>
+    void backward_sweep(const VectorType1& b, VectorType2& x, ValueType omega) const;
+
+    // ignores initial x
+    template<typename MatrixType, typename VectorType1, typename VectorType2>
+    void presmooth(const MatrixType& A, const VectorType1& b, VectorType2& x);
+
+    // smooths initial x
+    template<typename MatrixType, typename VectorType1, typename VectorType2>
+    void postsmooth(const MatrixType& A, const VectorType1& b, VectorType2& x);
+
+    // symmetric sweep
+    template <typename MatrixType, typename VectorType1, typename VectorType2>
+    void operator()(const MatrixType& A, const VectorType1& b, VectorType2& x);
+
+    template <typename MatrixType, typename VectorType1, typename VectorType2>
+    void operator()(const MatrixType& A, const VectorType1& b, VectorType2& x, ValueType omega);
+
+private:
+    template <typename MatrixType>
+    void setup(const MatrixType& A);
+
+    template <typename VectorType1, typename VectorType2>
+    void sweep_color(const size_t color, const VectorType1& b, VectorType2& x, ValueType omega) const;
+};
+
+} // end namespace relaxation
+} // end namespace cusp
+
+#include <cusp/relaxation/detail/gauss_seidel.inl>
@@ -37,24 +37,32 @@ template<typename MatrixType> struct sa_level;
 namespace relaxation
 {
 
+template <typename ValueType, typename MemorySpace>
+// Damped Jacobi relaxation.  presmooth and postsmooth perform \c sweeps
+// sweeps.  For CSR and ELL matrices each sweep is a single pass over the
+// matrix which computes the residual b - A x and the update of x together,
+// and the overloads taking a residual vector also return the residual of
+// the smoothed x from one fused pass instead of an SpMV and an axpby.
 template <typename ValueType, typename MemorySpace>
 class jacobi : public cusp::linear_operator<ValueType, MemorySpace>
 {
 public:
     ValueType default_omega;
+    size_t sweeps;
     cusp::array1d<ValueType,MemorySpace> diagonal;
     cusp::array1d<ValueType,MemorySpace> temp;
+    cusp::array1d<ValueType,MemorySpace> work;
 
     jacobi();
 
     template <typename MatrixType>
-    jacobi(const MatrixType& A, ValueType omega=1.0);
+    jacobi(const MatrixType& A, ValueType omega=1.0, size_t sweeps=1);
 
     template <typename MemorySpace2>
     jacobi(const jacobi<ValueType,MemorySpace2>& A);
 
     template <typename MatrixType>
-    jacobi(const cusp::precond::aggregation::sa_level<MatrixType>& sa_level, ValueType weight=4.0/3.0);
+    jacobi(const cusp::precond::aggregation::sa_level<MatrixType>& sa_level, ValueType weight=4.0/3.0, size_t sweeps=1);
     
     // ignores initial x
     template<typename MatrixType, typename VectorType1, typename VectorType2>
@@ -64,13 +72,37 @@ public:
     template<typename MatrixType, typename VectorType1, typename VectorType2>
     void postsmooth(const MatrixType& A, const VectorType1& b, VectorType2& x);
 
+    // ignores initial x, residual <- b - A x of the smoothed x
+    template<typename MatrixType, typename VectorType1, typename VectorType2, typename VectorType3>
+    void presmooth(const MatrixType& A, const VectorType1& b, VectorType2& x, VectorType3& residual);
+
+    // smooths initial x, residual <- b - A x of the smoothed x
+    template<typename MatrixType, typename VectorType1, typename VectorType2, typename VectorType3>
+    void postsmooth(const MatrixType& A, const VectorType1& b, VectorType2& x, VectorType3& residual);
+
     template <typename MatrixType, typename VectorType1, typename VectorType2>
     void operator()(const MatrixType& A, const VectorType1& b, VectorType2& x);
         
     template <typename MatrixType, typename VectorType1, typename VectorType2>
     void operator()(const MatrixType& A, const VectorType1& b, VectorType2& x, ValueType omega);
+
+private:
+    // performs the given number of sweeps starting from x
+    template<typename MatrixType, typename VectorType1, typename VectorType2>
+    void sweep(const MatrixType& A, const VectorType1& b, VectorType2& x, size_t count, ValueType omega);
 };
 
+// smooth and return the residual with the fused passes, used by cusp::multilevel
+template <typename ValueType, typename MemorySpace,
+          typename MatrixType, typename VectorType1, typename VectorType2, typename VectorType3>
+void presmooth_with_residual(jacobi<ValueType,MemorySpace>& smoother,
+                             const MatrixType& A, const VectorType1& b, VectorType2& x, VectorType3& residual);
+
+template <typename ValueType, typename MemorySpace,
+          typename MatrixType, typename VectorType1, typename VectorType2, typename VectorType3>
+void postsmooth_with_residual(jacobi<ValueType,MemorySpace>& smoother,
+                              const MatrixType& A, const VectorType1& b, VectorType2& x, VectorType3& residual);
+
 } // end namespace relaxation
 } // end namespace cusp
 
@@ -0,0 +1,69 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*! \file l1_jacobi.h
+ *  \brief L1-Jacobi relaxation.
+ */
+
+#pragma once
+
+#include <cusp/detail/config.h>
+#include <cusp/relaxation/jacobi.h>
+
+namespace cusp
+{
+namespace relaxation
+{
+
+// Jacobi relaxation with the diagonal replaced by the l1 row sums
+// d_i = A(i,i) + sum_{j != i} |A(i,j)|.  For symmetric positive definite
+// matrices the relaxation converges without damping, so no estimate of the
+// spectral radius of D^-1 A is needed and omega defaults to one.
+template <typename ValueType, typename MemorySpace>
+class l1_jacobi : public cusp::relaxation::jacobi<ValueType, MemorySpace>
+{
+    typedef cusp::relaxation::jacobi<ValueType, MemorySpace> Parent;
+public:
+    l1_jacobi();
+
+    template <typename MatrixType>
+    l1_jacobi(const MatrixType& A, ValueType omega=1.0);
+
+    template <typename MemorySpace2>
+    l1_jacobi(const l1_jacobi<ValueType,MemorySpace2>& A);
+
+    template <typename MatrixType>
+    l1_jacobi(const cusp::precond::aggregation::sa_level<MatrixType>& sa_level, ValueType omega=1.0);
+
+private:
+    template <typename MatrixType>
+    void setup(const MatrixType& A);
+};
+
+template <typename ValueType, typename MemorySpace,
+          typename MatrixType, typename VectorType1, typename VectorType2, typename VectorType3>
+void presmooth_with_residual(l1_jacobi<ValueType,MemorySpace>& smoother,
+                             const MatrixType& A, const VectorType1& b, VectorType2& x, VectorType3& residual);
+
+template <typename ValueType, typename MemorySpace,
+          typename MatrixType, typename VectorType1, typename VectorType2, typename VectorType3>
+void postsmooth_with_residual(l1_jacobi<ValueType,MemorySpace>& smoother,
+                              const MatrixType& A, const VectorType1& b, VectorType2& x, VectorType3& residual);
+
+} // end namespace relaxation
+} // end namespace cusp
+
+#include <cusp/relaxation/detail/l1_jacobi.inl>
@@ -0,0 +1,236 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*! \file sell_matrix.h
+ *  \brief Sliced ELLPACK (SELL-C-sigma) matrix format.
+ */
+
+#pragma once
+
+#include <cusp/detail/config.h>
+
+#include <cusp/array1d.h>
+#include <cusp/format.h>
+#include <cusp/memory.h>
+#include <cusp/detail/matrix_base.h>
+#include <cusp/detail/utils.h>
+
+namespace cusp
+{
+
+/*! \addtogroup sparse_matrices Sparse Matrices
+ */
+
+/*! \addtogroup sparse_matrix_containers Sparse Matrix Containers
+ *  \ingroup sparse_matrices
+ *  \{
+ */
+
+/*! \p sell_matrix : Sliced ELLPACK (SELL-C-sigma) matrix container
+ *
+ * The rows are sorted by decreasing length within consecutive windows of
+ * \c sorting_window rows and the sorted rows are grouped into slices of
+ * \c slice_height rows.  Each slice is stored as a small column-major ELL
+ * matrix which is only as wide as its longest row, so the padding is
+ * bounded by the variation of the row lengths within a window rather than
+ * over the whole matrix.
+ *
+ * Stored row \c p holds row \c row_permutation[p] of the matrix, and the
+ * entries of slice \c s begin at \c slice_offsets[s].  Entry \c k of the
+ * stored row \c p is located at
+ * <tt>slice_offsets[p / slice_height] + k * slice_height + p % slice_height</tt>.
+ * Multiplication writes the results through \c row_permutation, so vectors
+ * are always in the original row order.
+ *
+ * \tparam IndexType Type used for matrix indices (e.g. \c int).
+ * \tparam ValueType Type used for matrix values (e.g. \c float).
+ * \tparam MemorySpace A memory space (e.g. \c cusp::host_memory or cusp::device_memory)
+ *
+ * \note The entries within each row are sorted by column index and shifted to the left.
+ * \note The matrix should not contain duplicate entries.
+ * \note The parameters of the conversion are taken from the destination
+ *       matrix, so set \c slice_height and \c sorting_window before calling
+ *       \p cusp::convert, or use the constructor which takes them.
+ *
+ *  The following code snippet demonstrates how to convert a \p csr_matrix
+ *  to a \p sell_matrix on the device with slices of 32 rows, sorting the
+ *  rows within windows of 256 rows.
+ *
+ *  \code
+ *  #include <cusp/csr_matrix.h>
+ *  #include <cusp/sell_matrix.h>
+ *  #include <cusp/multiply.h>
+ *  #include <cusp/gallery/poisson.h>
+ *  ...
+ *
+ *  cusp::csr_matrix<int,float,cusp::device_memory> A;
+ *  cusp::gallery::poisson5pt(A, 100, 100);
+ *
+ *  cusp::sell_matrix<int,float,cusp::device_memory> B(A, 32, 256);
+ *
+ *  cusp::array1d<float,cusp::device_memory> x(B.num_cols, 1);
+ *  cusp::array1d<float,cusp::device_memory> y(B.num_rows);
+ *
+ *  // y is in the original row order of A
+ *  cusp::multiply(B, x, y);
+ *  \endcode
+ *
+ */
+template <typename IndexType, typename ValueType, class MemorySpace>
+class sell_matrix : public detail::matrix_base<IndexType,ValueType,MemorySpace,cusp::sell_format>
+{
+  typedef cusp::detail::matrix_base<IndexType,ValueType,MemorySpace,cusp::sell_format> Parent;
+  public:
+    /*! rebind matrix to a different MemorySpace
+     */
+    template<typename MemorySpace2>
+    struct rebind { typedef cusp::sell_matrix<IndexType, ValueType, MemorySpace2> type; };
+
+    /*! type of slice offsets array
+     */
+    typedef typename cusp::array1d<IndexType, MemorySpace> slice_offsets_array_type;
+
+    /*! type of row permutation array
+     */
+    typedef typename cusp::array1d<IndexType, MemorySpace> row_permutation_array_type;
+
+    /*! type of column indices array
+     */
+    typedef typename cusp::array1d<IndexType, MemorySpace> column_indices_array_type;
+
+    /*! type of values array
+     */
+    typedef typename cusp::array1d<ValueType, MemorySpace> values_array_type;
+
+    /*! equivalent container type
+     */
+    typedef typename cusp::sell_matrix<IndexType, ValueType, MemorySpace> container;
+
+    /*! Value used to pad the rows of the column_indices array.
+     */
+    const static IndexType invalid_index = static_cast<IndexType>(-1);
+
+    /*! Number of rows per slice (C).
+     */
+    size_t slice_height;
+
+    /*! Number of consecutive rows sorted by length (sigma).  A value of
+     *  one keeps the original row order.
+     */
+    size_t sorting_window;
+
+    /*! Offsets of the slices in the column_indices and values arrays.
+     */
+    slice_offsets_array_type slice_offsets;
+
+    /*! Original row index of each stored row.
+     */
+    row_permutation_array_type row_permutation;
+
+    /*! Storage for the column indices of the SELL data structure.
+     */
+    column_indices_array_type column_indices;
+
+    /*! Storage for the nonzero entries of the SELL data structure.
+     */
+    values_array_type values;
+
+    /*! Construct an empty \p sell_matrix.
+     */
+    sell_matrix()
+      : slice_height(32), sorting_window(256) {}
+
+    /*! Construct a \p sell_matrix with a specific shape and storage size.
+     *
+     *  \param num_rows Number of rows.
+     *  \param num_cols Number of columns.
+     *  \param num_entries Number of nonzero matrix entries.
+     *  \param num_stored_entries Number of stored entries including padding.
+     *  \param slice_height Number of rows per slice (default 32).
+     *  \param sorting_window Number of rows sorted by length (default 256).
+     */
+    sell_matrix(size_t num_rows, size_t num_cols, size_t num_entries,
+                size_t num_stored_entries, size_t slice_height = 32, size_t sorting_window = 256)
+      : Parent(num_rows, num_cols, num_entries),
+        slice_height(slice_height), sorting_window(sorting_window),
+        slice_offsets(detail::round_up(num_rows, slice_height) / slice_height + 1),
+        row_permutation(num_rows),
+        column_indices(num_stored_entries), values(num_stored_entries) {}
+
+    /*! Construct a \p sell_matrix from another matrix.
+     *
+     *  \param matrix Another sparse or dense matrix.
+     */
+    template <typename MatrixType>
+    sell_matrix(const MatrixType& matrix);
+
+    /*! Construct a \p sell_matrix from another matrix with the given
+     *  slice height and sorting window.
+     *
+     *  \param matrix Another sparse or dense matrix.
+     *  \param slice_height Number of rows per slice.
+     *  \param sorting_window Number of rows sorted by length.
+     */
+    template <typename MatrixType>
+    sell_matrix(const MatrixType& matrix, size_t slice_height, size_t sorting_window);
+
+    /*! Number of slices.
+     */
+    size_t num_slices(void) const
+    {
+      return slice_offsets.size() == 0 ? 0 : slice_offsets.size() - 1;
+    }
+
+    /*! Resize matrix dimensions and underlying storage
+     */
+    void resize(size_t num_rows, size_t num_cols, size_t num_entries,
+                size_t num_stored_entries)
+    {
+      Parent::resize(num_rows, num_cols, num_entries);
+      slice_offsets.resize(detail::round_up(num_rows, slice_height) / slice_height + 1);
+      row_permutation.resize(num_rows);
+      column_indices.resize(num_stored_entries);
+      values.resize(num_stored_entries);
+    }
+
+    /*! Swap the contents of two \p sell_matrix objects.
+     *
+     *  \param matrix Another \p sell_matrix with the same IndexType and ValueType.
+     */
+    void swap(sell_matrix& matrix)
+    {
+      Parent::swap(matrix);
+      thrust::swap(slice_height,   matrix.slice_height);
+      thrust::swap(sorting_window, matrix.sorting_window);
+      slice_offsets.swap(matrix.slice_offsets);
+      row_permutation.swap(matrix.row_permutation);
+      column_indices.swap(matrix.column_indices);
+      values.swap(matrix.values);
+    }
+
+    /*! Assignment from another matrix.
+     *
+     *  \param matrix Another sparse or dense matrix.
+     */
+    template <typename MatrixType>
+    sell_matrix& operator=(const MatrixType& matrix);
+}; // class sell_matrix
+/*! \}
+ */
+
+} // end namespace cusp
+
+#include <cusp/detail/sell_matrix.inl>
@@ -0,0 +1,273 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+/*! \file solve_scheduler.h
+ *  \brief Distribute many independent solves across devices and streams
+ */
+
+#pragma once
+
+#include <cusp/detail/config.h>
+
+#include <cusp/array1d.h>
+#include <cusp/csr_matrix.h>
+#include <cusp/detail/mutex.h>
+
+#include <list>
+#include <string>
+#include <vector>
+
+namespace cusp
+{
+
+/*! \addtogroup iterative_solvers Iterative Solvers
+ *  \{
+ */
+
+/*! Krylov method of a scheduled solve
+ */
+enum scheduled_solver
+{
+    scheduled_cg,           //!< \p cusp::krylov::cg
+    scheduled_bicgstab,     //!< \p cusp::krylov::bicgstab
+    scheduled_gmres         //!< \p cusp::krylov::gmres
+};
+
+/*! Preconditioner of a scheduled solve
+ */
+enum scheduled_preconditioner
+{
+    scheduled_identity,             //!< no preconditioning
+    scheduled_diagonal,             //!< \p cusp::precond::diagonal
+    scheduled_smoothed_aggregation  //!< \p cusp::precond::aggregation::smoothed_aggregation
+};
+
+/*! \p solve_config : Method and stopping criteria of a scheduled solve
+ */
+struct solve_config
+{
+    scheduled_solver solver;
+    scheduled_preconditioner preconditioner;
+
+    /*! iterations before the solve stops without converging */
+    size_t iteration_limit;
+
+    /*! the solve converges when ||b - A x|| <= absolute_tolerance + relative_tolerance * ||b|| */
+    double relative_tolerance;
+    double absolute_tolerance;
+
+    /*! restart length of \p scheduled_gmres */
+    size_t restart;
+
+    solve_config(scheduled_solver solver = scheduled_cg,
+                 scheduled_preconditioner preconditioner = scheduled_identity,
+                 size_t iteration_limit = 500,
+                 double relative_tolerance = 1e-5,
+                 double absolute_tolerance = 0,
+                 size_t restart = 50)
+        : solver(solver), preconditioner(preconditioner), iteration_limit(iteration_limit),
+          relative_tolerance(relative_tolerance), absolute_tolerance(absolute_tolerance), restart(restart) {}
+};
+
+/*! \p solve_report : Outcome and timings of one scheduled solve
+ *
+ *  The times are measured with CUDA events on the stream of the solve.
+ */
+struct solve_report
+{
+    /*! index returned by \p solve_scheduler::submit */
+    size_t task;
+
+    /*! device and worker (one per device and stream) which ran the solve */
+    int device;
+    size_t worker;
+
+    /*! false if the solve threw, see \c error */
+    bool completed;
+    bool converged;
+    size_t iterations;
+    double residual_norm;
+
+    /*! the matrix, resp. its smoothed aggregation hierarchy, was reused from
+     *  the cache of the device instead of being copied, resp. built */
+    bool matrix_cached;
+    bool hierarchy_cached;
+
+    /*! milliseconds spent copying the system to the device and building the
+     *  preconditioner, iterating, and copying the solution back */
+    float setup_milliseconds;
+    float solve_milliseconds;
+    float download_milliseconds;
+
+    /*! message of the exception thrown by the solve, if any */
+    std::string error;
+
+    solve_report(void)
+        : task(0), device(0), worker(0), completed(false), converged(false), iterations(0),
+          residual_norm(0), matrix_cached(false), hierarchy_cached(false),
+          setup_milliseconds(0), solve_milliseconds(0), download_milliseconds(0) {}
+};
+
+/*! \p solve_scheduler : Work queue which runs many independent solves
+ *  (e.g. a parameter sweep) on all devices at once.
+ *
+ *  Tasks are submitted with a host matrix, a right-hand side, an initial
+ *  guess which receives the solution, and a \p solve_config.  \p run starts
+ *  \p streams_per_device host threads per device, each issuing its solves
+ *  on its own stream (see \p stream_scope), and returns a \p solve_report
+ *  per task once the queue is empty.
+ *
+ *  Each device keeps the most recently used matrices in a cache, together
+ *  with the smoothed aggregation hierarchies built for them, so that the
+ *  tasks of a sweep which share a matrix copy it and set it up once per
+ *  device.  A worker first takes the pending tasks whose matrix is cached
+ *  on its device.  A hierarchy is used by one solve at a time, so a matrix
+ *  solved on several streams at once gets one hierarchy per stream.
+ *
+ *  Matrices are identified by their address and dimensions: the matrices,
+ *  right-hand sides and solutions must stay alive and unchanged until
+ *  \p run returns, and \p invalidate must be called for a cached matrix
+ *  whose values change between runs.
+ *
+ *  \tparam IndexType type of the column indices
+ *  \tparam ValueType type of the matrix and vector values
+ *
+ *  \code
+ *  #include <cusp/solve_scheduler.h>
+ *  #include <cusp/gallery/poisson.h>
+ *
+ *  int main(void)
+ *  {
+ *      cusp::csr_matrix<int, double, cusp::host_memory> A;
+ *      cusp::gallery::poisson5pt(A, 256, 256);
+ *
+ *      std::vector< cusp::array1d<double, cusp::host_memory> > b(100), x(100);
+ *
+ *      // all visible devices, two streams each
+ *      cusp::solve_scheduler<int, double> scheduler;
+ *
+ *      for (size_t i = 0; i < b.size(); i++)
+ *      {
+ *          b[i].resize(A.num_rows, double(i));
+ *          x[i].resize(A.num_rows, 0.0);
+ *          scheduler.submit(A, b[i], x[i], cusp::solve_config(cusp::scheduled_cg, cusp::scheduled_smoothed_aggregation));
+ *      }
+ *
+ *      std::vector<cusp::solve_report> reports = scheduler.run();
+ *
+ *      return 0;
+ *  }
+ *  \endcode
+ */
+template <typename IndexType, typename ValueType>
+class solve_scheduler
+{
+    public:
+    typedef cusp::csr_matrix<IndexType,ValueType,cusp::host_memory> matrix_type;
+    typedef cusp::array1d<ValueType,cusp::host_memory>              array_type;
+
+    /*! Use every visible device.
+     *
+     * \param streams_per_device workers, each with its own stream, per device
+     * \param cached_matrices_per_device matrices kept on each device between tasks
+     *
+     * \throws cusp::runtime_exception if no device is visible
+     */
+    solve_scheduler(size_t streams_per_device = 2, size_t cached_matrices_per_device = 4);
+
+    /*! Use the given devices, ignoring repeated entries.
+     */
+    solve_scheduler(const std::vector<int>& devices, size_t streams_per_device = 2, size_t cached_matrices_per_device = 4);
+
+    /*! Release the cached matrices and hierarchies.
+     */
+    ~solve_scheduler(void);
+
+    /*! Queue the solve of A x = b, starting from the values of \p x.
+     *
+     * \return index of the task in the reports of \p run
+     *
+     * \throws cusp::invalid_input_exception if A is not square or the sizes
+     *         of b and x differ from its number of rows
+     */
+    size_t submit(const matrix_type& A, const array_type& b, array_type& x,
+                  const solve_config& config = solve_config());
+
+    /*! Run the queued tasks and empty the queue.  The errors of a task are
+     *  reported in its \p solve_report rather than thrown.
+     *
+     * \return one report per task, in the order of submission
+     */
+    std::vector<cusp::solve_report> run(void);
+
+    /*! Drop the cached copies of \p A, e.g. after its values change.
+     */
+    void invalidate(const matrix_type& A);
+
+    /*! Drop all cached matrices and hierarchies.
+     */
+    void clear_cache(void);
+
+    /*! Devices of the workers.
+     */
+    const std::vector<int>& devices(void) const { return devices_; }
+
+    private:
+    struct task
+    {
+        const matrix_type * A;
+        const array_type * b;
+        array_type * x;
+        solve_config config;
+    };
+
+    struct cache_entry;
+
+    std::vector<int> devices_;
+    size_t streams_per_device;
+    size_t cached_matrices_per_device;
+
+    std::vector<task> tasks;
+
+    // state shared by the workers of run(), guarded by lock
+    cusp::detail::mutex lock;
+    std::list<size_t> pending;
+    std::vector<cusp::solve_report> reports;
+    std::vector< std::list<cache_entry *> > caches;   // per entry of devices_, most recent first
+
+    static void worker(void * scheduler, size_t w);
+
+    void run_worker(size_t w);
+    bool next_task(size_t slot, size_t& t);
+    void execute(size_t slot, size_t t, cusp::solve_report& report);
+
+    cache_entry * acquire_matrix(size_t slot, const matrix_type& A, bool& cached);
+    void release_matrix(size_t slot, cache_entry * entry);
+    void evict(size_t slot);
+    void clear_slot(size_t slot, const matrix_type * A);
+
+    // non-copyable
+    solve_scheduler(const solve_scheduler&);
+    solve_scheduler& operator=(const solve_scheduler&);
+};
+
+/*! \}
+ */
+
+} // end namespace cusp
+
+#include <cusp/detail/solve_scheduler.inl>
@@ -0,0 +1,181 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+/*! \file sparse_vector.h
+ *  \brief Sparse vector container
+ */
+
+#pragma once
+
+#include <cusp/detail/config.h>
+
+#include <cusp/array1d.h>
+#include <cusp/format.h>
+#include <cusp/memory.h>
+
+#include <thrust/swap.h>
+
+namespace cusp
+{
+
+/*! \addtogroup containers Containers
+ *  \{
+ */
+
+/*! \p sparse_vector : Sparse vector container
+ *
+ * Stores the \c num_entries nonzero entries of a vector of \c size()
+ * entries as pairs of an index and a value, for instance the frontier of
+ * a breadth-first search.  Products with sparse vectors only touch the
+ * columns of the matrix which match the stored entries.
+ *
+ * \tparam IndexType Type used for the indices (e.g. \c int).
+ * \tparam ValueType Type used for the values (e.g. \c float).
+ * \tparam MemorySpace A memory space (e.g. \c cusp::host_memory or cusp::device_memory)
+ *
+ * \note The indices are sorted and contain no duplicates.
+ * \note Construction from a dense \p array1d keeps the nonzero entries.
+ *
+ *  \code
+ *  #include <cusp/sparse_vector.h>
+ *  ...
+ *
+ *  // a vector of 10 entries with nonzeros at 2 and 7
+ *  cusp::sparse_vector<int,float,cusp::host_memory> x(10, 2);
+ *  x.indices[0] = 2; x.values[0] = 1.0f;
+ *  x.indices[1] = 7; x.values[1] = 3.0f;
+ *
+ *  // expand on the device
+ *  cusp::sparse_vector<int,float,cusp::device_memory> d_x(x);
+ *  cusp::array1d<float,cusp::device_memory> y;
+ *  d_x.to_dense(y);
+ *  \endcode
+ */
+template <typename IndexType, typename ValueType, class MemorySpace>
+class sparse_vector
+{
+  public:
+    typedef IndexType   index_type;
+    typedef ValueType   value_type;
+    typedef MemorySpace memory_space;
+    typedef cusp::sparse_vector_format format;
+
+    /*! rebind vector to a different MemorySpace
+     */
+    template<typename MemorySpace2>
+    struct rebind { typedef cusp::sparse_vector<IndexType, ValueType, MemorySpace2> type; };
+
+    /*! type of indices array
+     */
+    typedef typename cusp::array1d<IndexType, MemorySpace> indices_array_type;
+
+    /*! type of values array
+     */
+    typedef typename cusp::array1d<ValueType, MemorySpace> values_array_type;
+
+    /*! equivalent container type
+     */
+    typedef typename cusp::sparse_vector<IndexType, ValueType, MemorySpace> container;
+
+    /*! Number of entries of the vector, including the zeros.
+     */
+    size_t length;
+
+    /*! Number of stored entries.
+     */
+    size_t num_entries;
+
+    /*! Storage for the indices of the stored entries.
+     */
+    indices_array_type indices;
+
+    /*! Storage for the values of the stored entries.
+     */
+    values_array_type values;
+
+    /*! Construct an empty \p sparse_vector.
+     */
+    sparse_vector(void)
+      : length(0), num_entries(0) {}
+
+    /*! Construct a \p sparse_vector with a specific length and storage size.
+     *
+     *  \param length Number of entries of the vector.
+     *  \param num_entries Number of stored entries.
+     */
+    sparse_vector(size_t length, size_t num_entries)
+      : length(length), num_entries(num_entries),
+        indices(num_entries), values(num_entries) {}
+
+    /*! Construct a \p sparse_vector from another sparse vector or from
+     *  the nonzero entries of a dense \p array1d.
+     *
+     *  \param vector Another sparse or dense vector.
+     */
+    template <typename VectorType>
+    sparse_vector(const VectorType& vector);
+
+    /*! Number of entries of the vector, including the zeros.
+     */
+    size_t size(void) const
+    {
+      return length;
+    }
+
+    /*! Resize the vector and the underlying storage
+     */
+    void resize(size_t length, size_t num_entries)
+    {
+      this->length      = length;
+      this->num_entries = num_entries;
+      indices.resize(num_entries);
+      values.resize(num_entries);
+    }
+
+    /*! Swap the contents of two \p sparse_vector objects.
+     *
+     *  \param vector Another \p sparse_vector with the same IndexType and ValueType.
+     */
+    void swap(sparse_vector& vector)
+    {
+      thrust::swap(length,      vector.length);
+      thrust::swap(num_entries, vector.num_entries);
+      indices.swap(vector.indices);
+      values.swap(vector.values);
+    }
+
+    /*! Write the vector into a dense array of \c size() entries.
+     *
+     *  \param dense Dense \p array1d in any memory space, resized as necessary.
+     */
+    template <typename ArrayType>
+    void to_dense(ArrayType& dense) const;
+
+    /*! Assignment from another sparse vector or from the nonzero entries
+     *  of a dense \p array1d.
+     *
+     *  \param vector Another sparse or dense vector.
+     */
+    template <typename VectorType>
+    sparse_vector& operator=(const VectorType& vector);
+}; // class sparse_vector
+/*! \}
+ */
+
+} // end namespace cusp
+
+#include <cusp/detail/sparse_vector.inl>
@@ -0,0 +1,226 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+/*! \file spmspv.h
+ *  \brief Products of sparse matrices with sparse vectors
+ */
+
+#pragma once
+
+#include <cusp/detail/config.h>
+
+#include <cusp/csr_matrix.h>
+#include <cusp/sparse_vector.h>
+
+namespace cusp
+{
+
+/*! \addtogroup algorithms Algorithms
+ *  \ingroup algorithms
+ *  \{
+ */
+
+/*! Traversal used by the products with a sparse vector.  A push visits
+ *  the columns of the matrix which match the entries of x, a pull visits
+ *  the rows of the matrix which are to be computed.
+ */
+enum spmspv_direction
+{
+  spmspv_auto,
+  spmspv_push,
+  spmspv_pull
+};
+
+/*! \p spmspv_matrix : Sparse matrix stored by rows and by columns for
+ *  products with sparse vectors.
+ *
+ *  The product y = A * x with a sparse x is computed either by pushing the
+ *  entries of x along the columns of A, which costs the number of entries
+ *  in those columns, or by pulling the rows of A which are to be computed,
+ *  which costs the number of entries in these rows.  Pushing wins while x
+ *  holds few entries, as the frontier of a breadth-first search does at
+ *  the beginning and at the end, while pulling wins when x is dense or
+ *  when a mask leaves few rows to compute.  With \c spmspv_auto each
+ *  product pushes while <tt>alpha</tt> times the push cost is below the
+ *  pull cost, as in direction-optimizing breadth-first search.
+ *
+ *  The columns are stored as the rows of the transpose, unless the matrix
+ *  is declared symmetric, in which case the rows serve for both directions.
+ *
+ * \tparam IndexType Type used for matrix indices (e.g. \c int).
+ * \tparam ValueType Type used for matrix values (e.g. \c float).
+ * \tparam MemorySpace A memory space (e.g. \c cusp::host_memory or cusp::device_memory)
+ *
+ *  \code
+ *  #include <cusp/spmspv.h>
+ *  #include <cusp/gallery/poisson.h>
+ *  ...
+ *
+ *  cusp::csr_matrix<int,float,cusp::device_memory> G;
+ *  cusp::gallery::poisson5pt(G, 100, 100);
+ *
+ *  // the graph is undirected, so no transpose is stored
+ *  cusp::spmspv_matrix<int,float,cusp::device_memory> A(G, true);
+ *
+ *  // the frontier holds vertex 0
+ *  cusp::sparse_vector<int,float,cusp::device_memory> x(G.num_rows, 1);
+ *  x.indices[0] = 0; x.values[0] = 1;
+ *
+ *  // the neighbors of the frontier
+ *  cusp::sparse_vector<int,float,cusp::device_memory> y;
+ *  cusp::spmspv(A, x, y);
+ *  \endcode
+ */
+template <typename IndexType, typename ValueType, class MemorySpace>
+class spmspv_matrix
+{
+  public:
+    typedef IndexType   index_type;
+    typedef ValueType   value_type;
+    typedef MemorySpace memory_space;
+
+    /*! Number of rows.
+     */
+    size_t num_rows;
+
+    /*! Number of columns.
+     */
+    size_t num_cols;
+
+    /*! Number of stored entries.
+     */
+    size_t num_entries;
+
+    /*! The matrix by rows, used by pulls.
+     */
+    cusp::csr_matrix<IndexType,ValueType,MemorySpace> rows;
+
+    /*! The transpose of the matrix, whose rows are the columns used by
+     *  pushes.  Empty when the matrix is symmetric.
+     */
+    cusp::csr_matrix<IndexType,ValueType,MemorySpace> columns;
+
+    /*! Whether \c rows also serves as the columns.
+     */
+    bool symmetric;
+
+    /*! Traversal of the products, \c spmspv_auto chooses for each product.
+     */
+    spmspv_direction direction;
+
+    /*! Ratio of the pull cost to the push cost above which \c spmspv_auto
+     *  pushes (default 14).
+     */
+    float alpha;
+
+    /*! Construct an empty \p spmspv_matrix.
+     */
+    spmspv_matrix(void)
+      : num_rows(0), num_cols(0), num_entries(0),
+        symmetric(false), direction(spmspv_auto), alpha(14.0f) {}
+
+    /*! Construct a \p spmspv_matrix from another matrix.
+     *
+     *  \param matrix Another sparse or dense matrix.
+     *  \param symmetric Whether the matrix is symmetric, which saves its transpose.
+     */
+    template <typename MatrixType>
+    spmspv_matrix(const MatrixType& matrix, bool symmetric = false);
+
+    /*! The columns of the matrix as the rows of a CSR matrix.
+     */
+    const cusp::csr_matrix<IndexType,ValueType,MemorySpace>& column_matrix(void) const
+    {
+      return symmetric ? rows : columns;
+    }
+};
+
+/*! \p generalized_spmspv : Computes a product of a sparse matrix with a
+ *  sparse vector over an arbitrary semiring
+ *
+ * Computes <tt>y[i] = reduce_j combine(A(i,j), x[j])</tt> where \c j runs
+ * over the stored entries of x.  Only the rows which receive at least one
+ * contribution are stored in y, in increasing order.  reduce needs no
+ * identity element but must be associative and commutative.
+ *
+ * \param A sparse matrix
+ * \param x input sparse vector
+ * \param y output sparse vector, resized as necessary
+ * \param combine binary function applied to the pairs A(i,j) and x[j]
+ * \param reduce binary function which reduces the combined values
+ *
+ * \return the direction which was used, \c spmspv_push or \c spmspv_pull
+ *
+ * \throws cusp::invalid_input_exception if the size of x does not match the matrix
+ */
+template <typename IndexType, typename ValueType, class MemorySpace,
+          typename SparseVector1, typename SparseVector2,
+          typename BinaryFunction1, typename BinaryFunction2>
+spmspv_direction generalized_spmspv(const cusp::spmspv_matrix<IndexType,ValueType,MemorySpace>& A,
+                                    const SparseVector1& x,
+                                          SparseVector2& y,
+                                    BinaryFunction1 combine,
+                                    BinaryFunction2 reduce);
+
+/*! \p generalized_spmspv : Computes the rows of a product of a sparse
+ *  matrix with a sparse vector selected by a mask
+ *
+ * Like the unmasked version, but the rows with <tt>mask[i] == 0</tt> are
+ * neither computed nor stored, for instance the vertices a breadth-first
+ * search has already visited.
+ *
+ * \param A sparse matrix
+ * \param x input sparse vector
+ * \param mask dense array of the rows to compute
+ * \param y output sparse vector, resized as necessary
+ * \param combine binary function applied to the pairs A(i,j) and x[j]
+ * \param reduce binary function which reduces the combined values
+ *
+ * \return the direction which was used, \c spmspv_push or \c spmspv_pull
+ *
+ * \throws cusp::invalid_input_exception if the sizes of x or mask do not match the matrix
+ */
+template <typename IndexType, typename ValueType, class MemorySpace,
+          typename SparseVector1, typename Array, typename SparseVector2,
+          typename BinaryFunction1, typename BinaryFunction2>
+spmspv_direction generalized_spmspv(const cusp::spmspv_matrix<IndexType,ValueType,MemorySpace>& A,
+                                    const SparseVector1& x,
+                                    const Array& mask,
+                                          SparseVector2& y,
+                                    BinaryFunction1 combine,
+                                    BinaryFunction2 reduce);
+
+/*! \p spmspv : Computes y = A * x for a sparse vector x
+ *
+ * \param A sparse matrix
+ * \param x input sparse vector
+ * \param y output sparse vector, resized as necessary
+ *
+ * \return the direction which was used, \c spmspv_push or \c spmspv_pull
+ */
+template <typename IndexType, typename ValueType, class MemorySpace,
+          typename SparseVector1, typename SparseVector2>
+spmspv_direction spmspv(const cusp::spmspv_matrix<IndexType,ValueType,MemorySpace>& A,
+                        const SparseVector1& x,
+                              SparseVector2& y);
+
+/*! \}
+ */
+
+} // end namespace cusp
+
+#include <cusp/detail/spmspv.inl>
@@ -0,0 +1,130 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*! \file stencil_operator.h
+ *  \brief Matrix-free operator of a constant-coefficient stencil
+ */
+
+#pragma once
+
+#include <cusp/detail/config.h>
+
+#include <cusp/array1d.h>
+#include <cusp/linear_operator.h>
+#include <cusp/detail/stencil.h>
+#include <cusp/detail/device/spmv/stencil.h>
+
+namespace cusp
+{
+
+/*! \addtogroup algorithms Algorithms
+ *  \ingroup algorithms
+ *  \{
+ */
+
+/*! \p stencil_operator : Linear operator which applies a
+ *  constant-coefficient stencil on a regular grid of up to three
+ *  dimensions without forming the matrix.
+ *
+ *  The operator takes the same stencil and grid as
+ *  \p cusp::gallery::generate_matrix_from_stencil and computes the same
+ *  products, but it only stores the coefficients of the stencil (at most
+ *  27 points) and the grid dimensions.  On the device the stencil is
+ *  applied to tiles of x staged in shared memory, so a multiply reads x
+ *  and writes y and nothing else, where the DIA matrix of a 5-point
+ *  stencil reads five values per row in addition.
+ *
+ *  The operator can be passed to the Krylov solvers wherever a matrix is
+ *  expected, and \p multilevel::set_fine_operator applies it on the
+ *  finest level of a hierarchy built from the explicit matrix.
+ *
+ * \tparam ValueType scalar type of the stencil coefficients
+ * \tparam MemorySpace memory space of the vectors
+ * \tparam IndexType integer type of the grid dimensions
+ *
+ *  \code
+ *  #include <cusp/stencil_operator.h>
+ *  #include <cusp/krylov/cg.h>
+ *
+ *  int main(void)
+ *  {
+ *      typedef thrust::tuple<int,int>             StencilIndex;
+ *      typedef thrust::tuple<StencilIndex,float>  StencilPoint;
+ *
+ *      // 5-point Laplacian on a 256x256 grid
+ *      cusp::array1d<StencilPoint, cusp::host_memory> stencil;
+ *      stencil.push_back(StencilPoint(StencilIndex( 0, -1), -1));
+ *      stencil.push_back(StencilPoint(StencilIndex(-1,  0), -1));
+ *      stencil.push_back(StencilPoint(StencilIndex( 0,  0),  4));
+ *      stencil.push_back(StencilPoint(StencilIndex( 1,  0), -1));
+ *      stencil.push_back(StencilPoint(StencilIndex( 0,  1), -1));
+ *
+ *      cusp::stencil_operator<float, cusp::device_memory> A(stencil, StencilIndex(256, 256));
+ *
+ *      cusp::array1d<float, cusp::device_memory> x(A.num_rows, 0);
+ *      cusp::array1d<float, cusp::device_memory> b(A.num_rows, 1);
+ *
+ *      cusp::krylov::cg(A, x, b);
+ *
+ *      return 0;
+ *  }
+ *  \endcode
+ */
+template <typename ValueType, typename MemorySpace, typename IndexType=int>
+class stencil_operator : public cusp::linear_operator<ValueType,MemorySpace,IndexType>
+{
+    typedef cusp::linear_operator<ValueType,MemorySpace,IndexType> Parent;
+
+    public:
+
+    /*! Coefficients, offsets and grid dimensions of the stencil.
+     */
+    cusp::detail::stencil_coefficients<IndexType,ValueType> stencil;
+
+    /*! Construct an empty operator.
+     */
+    stencil_operator(void);
+
+    /*! Construct the operator of a stencil on a grid.
+     *
+     * \param stencil points of the stencil, each a \p thrust::tuple of the
+     *        tuple of its offsets in each dimension and its coefficient
+     * \param grid \p thrust::tuple of the number of points in each dimension,
+     *        the first of which varies fastest
+     *
+     * \throws cusp::invalid_input_exception if the grid has more than three
+     *         dimensions or the stencil more than 27 points
+     */
+    template <typename StencilPoint, typename GridDimension>
+    stencil_operator(const cusp::array1d<StencilPoint,cusp::host_memory>& stencil,
+                     const GridDimension& grid);
+
+    /*! Construct a copy of an operator in another memory space.
+     */
+    template <typename MemorySpace2>
+    stencil_operator(const stencil_operator<ValueType,MemorySpace2,IndexType>& A);
+
+    /*! Compute y = A * x.
+     */
+    template <typename VectorType1, typename VectorType2>
+    void operator()(const VectorType1& x, VectorType2& y) const;
+};
+/*! \}
+ */
+
+} // end namespace cusp
+
+#include <cusp/detail/stencil_operator.inl>
@@ -0,0 +1,140 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*! \file stream.h
+ *  \brief Issue device operations on a CUDA stream
+ */
+
+#pragma once
+
+#include <cusp/detail/config.h>
+
+#include <cusp/detail/device/stream.h>
+
+namespace cusp
+{
+
+/*! \addtogroup execution Execution
+ *  \{
+ */
+
+/*! \p stream_scope : Directs Cusp device operations to a CUDA stream
+ *
+ * While a \p stream_scope is alive, every device kernel and Thrust algorithm
+ * issued by \p cusp::multiply, the \p cusp::blas functions, the Krylov
+ * solvers and \p cusp::multilevel is enqueued on the given stream instead of
+ * the default stream.  Independent solves issued on different streams may
+ * therefore overlap on one device.  Scopes may be nested; the previous stream
+ * is restored when the scope is destroyed.
+ *
+ * \note Functions that return a scalar to the host (e.g. \p cusp::blas::dot
+ * or a monitor testing convergence) synchronize with the stream.
+ * \note Allocations of the Cusp containers are stream-ordered through the
+ * device cache (see \p device_cache_scope); temporary storage allocated
+ * inside Thrust algorithms is not.
+ * \note The current stream is kept per host thread: a scope only directs
+ * the work issued by the thread which opened it, and threads without a
+ * scope use the default stream.  Compile with \c CUSP_PER_THREAD_DEFAULT_STREAM
+ * to give every thread its own default stream (\c cudaStreamPerThread), so
+ * that requests served from several host threads overlap without a scope.
+ * The device cache, the cached device properties and the cuBLAS handles are
+ * safe to use from several threads at once.
+ *
+ *  The following code snippet demonstrates how to solve two independent
+ *  systems on separate streams.
+ *
+ *  \code
+ *  #include <cusp/stream.h>
+ *  #include <cusp/csr_matrix.h>
+ *  #include <cusp/krylov/cg.h>
+ *  #include <cusp/gallery/poisson.h>
+ *
+ *  int main(void)
+ *  {
+ *      cusp::csr_matrix<int, float, cusp::device_memory> A;
+ *      cusp::gallery::poisson5pt(A, 100, 100);
+ *
+ *      cusp::array1d<float, cusp::device_memory> x0(A.num_rows, 0), b0(A.num_rows, 1);
+ *      cusp::array1d<float, cusp::device_memory> x1(A.num_rows, 0), b1(A.num_rows, 2);
+ *
+ *      cudaStream_t s0, s1;
+ *      cudaStreamCreate(&s0);
+ *      cudaStreamCreate(&s1);
+ *
+ *      {
+ *          cusp::stream_scope scope(s0);
+ *          cusp::krylov::cg(A, x0, b0);
+ *      }
+ *
+ *      {
+ *          cusp::stream_scope scope(s1);
+ *          cusp::krylov::cg(A, x1, b1);
+ *      }
+ *
+ *      cudaStreamDestroy(s0);
+ *      cudaStreamDestroy(s1);
+ *
+ *      return 0;
+ *  }
+ *  \endcode
+ */
+class stream_scope
+{
+    public:
+    /*! Issue subsequent device operations on \p stream
+     */
+    explicit stream_scope(cudaStream_t stream)
+        : stream_(stream), previous(cusp::detail::device::current_stream())
+    {
+        cusp::detail::device::set_current_stream(stream);
+    }
+
+    /*! Restore the previously active stream
+     */
+    ~stream_scope(void)
+    {
+        cusp::detail::device::set_current_stream(previous);
+    }
+
+    /*! stream on which device operations are issued
+     */
+    cudaStream_t get(void) const { return stream_; }
+
+    /*! block until all operations issued on the stream have completed
+     */
+    void synchronize(void) const { cudaStreamSynchronize(get()); }
+
+    private:
+    cudaStream_t stream_;
+    cudaStream_t previous;
+
+    // non-copyable
+    stream_scope(const stream_scope&);
+    stream_scope& operator=(const stream_scope&);
+};
+
+/*! \p current_stream : stream on which Cusp currently issues device operations
+ */
+inline cudaStream_t current_stream(void)
+{
+    return cusp::detail::device::current_stream();
+}
+
+/*! \}
+ */
+
+} // end namespace cusp
+
@@ -0,0 +1,158 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+/*! \file streamed_operator.h
+ *  \brief Device operator of a CSR matrix kept in host memory
+ */
+
+#pragma once
+
+#include <cusp/detail/config.h>
+
+#include <cusp/array1d.h>
+#include <cusp/linear_operator.h>
+
+#include <cuda_runtime_api.h>
+
+#include <vector>
+
+namespace cusp
+{
+
+/*! \addtogroup algorithms Algorithms
+ *  \ingroup algorithms
+ *  \{
+ */
+
+/*! \p streamed_operator : Linear operator which multiplies device vectors
+ *  by a CSR matrix too large for the device.
+ *
+ *  The rows of the matrix are split into blocks of at most \p block_bytes
+ *  bytes, which are copied into page-locked host memory when the operator
+ *  is constructed.  A multiply streams the blocks through two device
+ *  buffers: block k+1 is copied on a dedicated stream while the CSR kernel
+ *  multiplies block k on the current stream (see \p stream_scope), so the
+ *  product runs at the bandwidth of the host link rather than that of the
+ *  host SpMV.  x and y stay on the device; only the matrix moves.  When
+ *  the matrix fits in the two buffers it is copied once and kept.
+ *
+ *  The operator has \p device_memory as its memory space and can be
+ *  passed to the Krylov solvers wherever a matrix is expected.
+ *
+ *  \tparam IndexType type of the column indices
+ *  \tparam ValueType type of the matrix and vector values
+ *
+ *  \code
+ *  #include <cusp/streamed_operator.h>
+ *  #include <cusp/io/binary.h>
+ *  #include <cusp/krylov/cg.h>
+ *
+ *  int main(void)
+ *  {
+ *      // map the matrix instead of reading it into pageable memory
+ *      cusp::io::binary_file file("A.bin");
+ *      cusp::io::binary_file::csr_view<long long, double>::type A_h = file.make_csr_view<long long, double>();
+ *
+ *      // blocks of 512MB
+ *      cusp::streamed_operator<long long, double> A(A_h, size_t(512) << 20);
+ *
+ *      cusp::array1d<double, cusp::device_memory> x(A.num_rows, 0);
+ *      cusp::array1d<double, cusp::device_memory> b(A.num_rows, 1);
+ *
+ *      cusp::krylov::cg(A, x, b);
+ *
+ *      return 0;
+ *  }
+ *  \endcode
+ */
+template <typename IndexType, typename ValueType>
+class streamed_operator : public cusp::linear_operator<ValueType,cusp::device_memory,IndexType>
+{
+    typedef cusp::linear_operator<ValueType,cusp::device_memory,IndexType> Parent;
+
+    public:
+
+    /*! Construct an empty operator.
+     */
+    streamed_operator(void);
+
+    /*! Construct the operator of a CSR matrix.
+     *
+     * \param A \p csr_matrix or \p csr_matrix_view in host memory, which is
+     *        not referenced after the construction
+     * \param block_bytes bound on the bytes of the row offsets, column
+     *        indices and values of a block; a single row larger than the
+     *        bound forms its own block
+     *
+     * \throws std::bad_alloc if the page-locked host memory or the device
+     *         buffers cannot be allocated
+     */
+    template <typename MatrixType>
+    streamed_operator(const MatrixType& A, size_t block_bytes = size_t(256) << 20);
+
+    /*! Release the page-locked memory, the buffers and the copy stream.
+     */
+    ~streamed_operator(void);
+
+    /*! Number of row blocks.
+     */
+    size_t num_blocks(void) const;
+
+    /*! Compute y = A * x.
+     */
+    template <typename VectorType1, typename VectorType2>
+    void operator()(const VectorType1& x, VectorType2& y) const;
+
+    private:
+
+    // rows [block_rows[k], block_rows[k+1]) form block k, whose entries
+    // are [block_entries[k], block_entries[k+1]); the row offsets of each
+    // block start at zero and take num_rows + num_blocks places
+    std::vector<size_t> block_rows;
+    std::vector<size_t> block_entries;
+
+    // page-locked copies of the matrix
+    IndexType * row_offsets;
+    IndexType * column_indices;
+    ValueType * values;
+
+    // two device buffers, one being multiplied while the other is filled
+    mutable cusp::array1d<IndexType,cusp::device_memory> buffer_offsets[2];
+    mutable cusp::array1d<IndexType,cusp::device_memory> buffer_indices[2];
+    mutable cusp::array1d<ValueType,cusp::device_memory> buffer_values[2];
+
+    // the blocks are copied on copy_stream; copied[b] marks buffer b
+    // filled and consumed[b] the multiply which last read it
+    cudaStream_t copy_stream;
+    cudaEvent_t copied[2];
+    cudaEvent_t consumed[2];
+
+    // all blocks are in the buffers
+    mutable bool resident;
+
+    void release(void);
+
+    // not copyable
+    streamed_operator(const streamed_operator&);
+    streamed_operator& operator=(const streamed_operator&);
+};
+/*! \}
+ */
+
+} // end namespace cusp
+
+#include <cusp/detail/streamed_operator.inl>
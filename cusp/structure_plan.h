@@ -0,0 +1,124 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*! \file structure_plan.h
+ *  \brief Value updates of converted matrices with a fixed sparsity pattern
+ */
+
+#pragma once
+
+#include <cusp/detail/config.h>
+
+#include <cusp/array1d.h>
+#include <cusp/memory.h>
+
+namespace cusp
+{
+
+/*! \addtogroup algorithms Algorithms
+ *  \ingroup algorithms
+ *  \{
+ */
+
+/*! \p structure_plan : Placement of the entries of a source matrix in a
+ *  converted matrix.
+ *
+ *  The plan is recorded by the three argument \p convert and stores, for
+ *  every value slot of the destination, the index of the source entry it
+ *  holds, or -1 for padding.  When the values of the source change but its
+ *  sparsity pattern does not, \p update_values refreshes the destination
+ *  with a single gather per value array, without analyzing the structure
+ *  again or reallocating the destination.
+ *
+ * \tparam IndexType Type used for entry indices (e.g. \c int).
+ * \tparam MemorySpace Memory space of the destination matrix.
+ *
+ * \note The source must be a \p coo_matrix or \p csr_matrix and the
+ *       destination a \p coo_matrix, \p csr_matrix, \p ell_matrix or
+ *       \p hyb_matrix.
+ *
+ *  \code
+ *  #include <cusp/structure_plan.h>
+ *  #include <cusp/coo_matrix.h>
+ *  #include <cusp/hyb_matrix.h>
+ *  ...
+ *
+ *  cusp::coo_matrix<int,float,cusp::device_memory> A = ...;
+ *  cusp::hyb_matrix<int,float,cusp::device_memory> B;
+ *
+ *  // convert once and record where the entries of A are placed
+ *  cusp::structure_plan<int,cusp::device_memory> plan;
+ *  cusp::convert(A, B, plan);
+ *
+ *  for (int step = 0; step < num_steps; step++)
+ *  {
+ *      // recompute A.values
+ *      ...
+ *
+ *      // copy the new values of A into B
+ *      cusp::update_values(A, B, plan);
+ *  }
+ *  \endcode
+ */
+template <typename IndexType, class MemorySpace>
+class structure_plan
+{
+  public:
+    /*! Number of entries of the source matrix.
+     */
+    size_t num_entries;
+
+    /*! Source entry of each destination value slot, in the order of the
+     *  destination value arrays (the ELL part of a \p hyb_matrix first).
+     */
+    cusp::array1d<IndexType, MemorySpace> sources;
+
+    /*! Construct an empty \p structure_plan.
+     */
+    structure_plan(void)
+      : num_entries(0) {}
+};
+
+/*! \p convert : Convert between matrix formats and record the placement
+ *  of the source entries.
+ *
+ * \param src source sparse matrix
+ * \param dst destination sparse matrix, resized as necessary
+ * \param plan placement of the entries of \p src in \p dst
+ */
+template <typename SourceType, typename DestinationType, typename IndexType, class MemorySpace>
+void convert(const SourceType& src, DestinationType& dst,
+             cusp::structure_plan<IndexType,MemorySpace>& plan);
+
+/*! \p update_values : Overwrite the values of a converted matrix with
+ *  the values of a source matrix with the same sparsity pattern.
+ *
+ * \param src source sparse matrix with the structure used to build \p plan
+ * \param dst destination sparse matrix produced by \p convert with \p plan
+ * \param plan placement of the entries of \p src in \p dst
+ *
+ * \throws cusp::invalid_input_exception if \p src or \p dst do not match \p plan
+ */
+template <typename SourceType, typename DestinationType, typename IndexType, class MemorySpace>
+void update_values(const SourceType& src, DestinationType& dst,
+                   const cusp::structure_plan<IndexType,MemorySpace>& plan);
+
+/*! \}
+ */
+
+} // end namespace cusp
+
+#include <cusp/detail/structure_plan.inl>
@@ -0,0 +1,167 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+/*! \file symmetric_csr_operator.h
+ *  \brief Operators of symmetric and Hermitian matrices stored as their
+ *  upper triangle
+ */
+
+#pragma once
+
+#include <cusp/detail/config.h>
+
+#include <cusp/csr_matrix.h>
+#include <cusp/linear_operator.h>
+
+namespace cusp
+{
+
+/*! \addtogroup algorithms Algorithms
+ *  \ingroup algorithms
+ *  \{
+ */
+
+/*! \p symmetric_csr_operator : Linear operator of a symmetric matrix which
+ *  stores only the upper triangle, diagonal included, in CSR format.
+ *
+ *  The operator holds about half the entries of the full matrix.  A
+ *  multiply reads each stored entry A(i,j) once and applies it to both
+ *  y[i] and, off the diagonal, y[j], so it also moves about half the
+ *  bytes of a CSR multiply with the full matrix.  On the device the
+ *  mirrored contributions are added with atomics, so the rounding of the
+ *  result may differ between runs.
+ *
+ *  The operator can be passed to the Krylov solvers wherever a matrix is
+ *  expected, e.g. to \p cusp::krylov::cg for SPD systems, and
+ *  \p cusp::multiply_dot sums the dot product of the CG step in the same
+ *  pass over the triangle.  For complex values the matrix is complex
+ *  symmetric (A = A^T); see \p hermitian_csr_operator for A = A^H.
+ *
+ * \tparam IndexType type of the row offsets and column indices
+ * \tparam ValueType type of the values
+ * \tparam MemorySpace memory space of the arrays and vectors
+ *
+ *  \code
+ *  #include <cusp/symmetric_csr_operator.h>
+ *  #include <cusp/gallery/poisson.h>
+ *  #include <cusp/krylov/cg.h>
+ *
+ *  int main(void)
+ *  {
+ *      cusp::csr_matrix<int, float, cusp::device_memory> B;
+ *      cusp::gallery::poisson5pt(B, 256, 256);
+ *
+ *      // keeps the entries with column >= row
+ *      cusp::symmetric_csr_operator<int, float, cusp::device_memory> A(B);
+ *
+ *      cusp::array1d<float, cusp::device_memory> x(A.num_rows, 0);
+ *      cusp::array1d<float, cusp::device_memory> b(A.num_rows, 1);
+ *
+ *      cusp::krylov::cg(A, x, b);
+ *
+ *      return 0;
+ *  }
+ *  \endcode
+ */
+template <typename IndexType, typename ValueType, typename MemorySpace>
+class symmetric_csr_operator : public cusp::linear_operator<ValueType,MemorySpace,IndexType>
+{
+    typedef cusp::linear_operator<ValueType,MemorySpace,IndexType> Parent;
+
+    public:
+
+    /*! Upper triangle of the matrix, diagonal included.
+     */
+    cusp::csr_matrix<IndexType,ValueType,MemorySpace> upper;
+
+    /*! Construct an empty operator.
+     */
+    symmetric_csr_operator(void);
+
+    /*! Construct the operator of a symmetric matrix.  Only the entries on
+     *  and above the diagonal are read; the others are assumed to mirror
+     *  them.
+     *
+     * \param A square matrix in any format and memory space
+     *
+     * \throws cusp::invalid_input_exception if \p A is not square
+     */
+    template <typename MatrixType>
+    symmetric_csr_operator(const MatrixType& A);
+
+    /*! Construct a copy of an operator in another memory space.
+     */
+    template <typename MemorySpace2>
+    symmetric_csr_operator(const symmetric_csr_operator<IndexType,ValueType,MemorySpace2>& A);
+
+    /*! Compute y = A * x.
+     */
+    template <typename VectorType1, typename VectorType2>
+    void operator()(const VectorType1& x, VectorType2& y) const;
+};
+
+/*! \p hermitian_csr_operator : Linear operator of a Hermitian matrix which
+ *  stores only the upper triangle, diagonal included, in CSR format.
+ *
+ *  The storage and the multiply are those of \p symmetric_csr_operator,
+ *  except that the entry mirrored below the diagonal is the conjugate
+ *  conj(A(i,j)) of the stored entry.  Use it with \p cusp::krylov::cg or
+ *  \p cusp::krylov::cr for Hermitian positive definite systems.  For real
+ *  values it is the same as \p symmetric_csr_operator.
+ *
+ * \tparam IndexType type of the row offsets and column indices
+ * \tparam ValueType type of the values, e.g. \c cusp::complex<double>
+ * \tparam MemorySpace memory space of the arrays and vectors
+ */
+template <typename IndexType, typename ValueType, typename MemorySpace>
+class hermitian_csr_operator : public symmetric_csr_operator<IndexType,ValueType,MemorySpace>
+{
+    typedef symmetric_csr_operator<IndexType,ValueType,MemorySpace> Parent;
+
+    public:
+
+    /*! Construct an empty operator.
+     */
+    hermitian_csr_operator(void);
+
+    /*! Construct the operator of a Hermitian matrix.  Only the entries on
+     *  and above the diagonal are read; the others are assumed to be
+     *  their conjugates.
+     *
+     * \param A square matrix in any format and memory space
+     *
+     * \throws cusp::invalid_input_exception if \p A is not square
+     */
+    template <typename MatrixType>
+    hermitian_csr_operator(const MatrixType& A);
+
+    /*! Construct a copy of an operator in another memory space.
+     */
+    template <typename MemorySpace2>
+    hermitian_csr_operator(const hermitian_csr_operator<IndexType,ValueType,MemorySpace2>& A);
+
+    /*! Compute y = A * x.
+     */
+    template <typename VectorType1, typename VectorType2>
+    void operator()(const VectorType1& x, VectorType2& y) const;
+};
+/*! \}
+ */
+
+} // end namespace cusp
+
+#include <cusp/detail/symmetric_csr_operator.inl>
@@ -0,0 +1,140 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+
+/*! \file tiled_csr_operator.h
+ *  \brief Operator of a sparse matrix stored in tiles of equal work
+ */
+
+#pragma once
+
+#include <cusp/detail/config.h>
+
+#include <cusp/array1d.h>
+#include <cusp/linear_operator.h>
+
+namespace cusp
+{
+
+/*! \addtogroup algorithms Algorithms
+ *  \ingroup algorithms
+ *  \{
+ */
+
+/*! \p tiled_csr_operator : Linear operator of a sparse matrix whose entries
+ *  are split into tiles of the same size regardless of the rows, in the
+ *  manner of the CSR5 format.
+ *
+ *  The entries in CSR order are cut into tiles of 32 lanes of 16
+ *  consecutive entries, and stored transposed within each tile so that
+ *  the threads of a warp read the entries of all lanes at once.  A few
+ *  descriptor bits per lane mark where rows begin, and one row index per
+ *  lane locates them.  Every thread of a multiply therefore handles 16
+ *  entries, whether the matrix has rows of two entries or of a million,
+ *  and empty rows cost nothing.  Rows spread over several lanes are
+ *  summed with atomic additions on the device, so the rounding of those
+ *  rows may differ between runs.  The construction from a \p csr_matrix
+ *  is a handful of scans, gathers and scatters.
+ *
+ *  The operator suits matrices whose row lengths vary widely, for which
+ *  the COO part of a \p hyb_matrix dominates.  It can be passed to the
+ *  Krylov solvers wherever a matrix is expected, and smoothed aggregation
+ *  on the device applies it on the finest level of such matrices.
+ *
+ * \tparam IndexType type of the column indices
+ * \tparam ValueType type of the values
+ * \tparam MemorySpace memory space of the arrays and vectors
+ *
+ *  \code
+ *  #include <cusp/tiled_csr_operator.h>
+ *  #include <cusp/io/matrix_market.h>
+ *  #include <cusp/krylov/cg.h>
+ *
+ *  int main(void)
+ *  {
+ *      cusp::csr_matrix<int, float, cusp::device_memory> B;
+ *      cusp::io::read_matrix_market_file(B, "A.mtx");
+ *
+ *      cusp::tiled_csr_operator<int, float, cusp::device_memory> A(B);
+ *
+ *      cusp::array1d<float, cusp::device_memory> x(A.num_rows, 0);
+ *      cusp::array1d<float, cusp::device_memory> b(A.num_rows, 1);
+ *
+ *      cusp::krylov::cg(A, x, b);
+ *
+ *      return 0;
+ *  }
+ *  \endcode
+ */
+template <typename IndexType, typename ValueType, typename MemorySpace>
+class tiled_csr_operator : public cusp::linear_operator<ValueType,MemorySpace,IndexType>
+{
+    typedef cusp::linear_operator<ValueType,MemorySpace,IndexType> Parent;
+
+    public:
+
+    /*! Column indices of the entries in tile order, padded to whole tiles.
+     */
+    cusp::array1d<IndexType,MemorySpace> column_indices;
+
+    /*! Values of the entries in tile order, padded with zeros.
+     */
+    cusp::array1d<ValueType,MemorySpace> values;
+
+    /*! Index among the nonempty rows of the row of the first entry of
+     *  each lane.
+     */
+    cusp::array1d<IndexType,MemorySpace> lane_rows;
+
+    /*! Row starts of the entries of each lane, one bit per entry.
+     */
+    cusp::array1d<unsigned int,MemorySpace> lane_flags;
+
+    /*! Row of each nonempty row, empty when no row is empty.
+     */
+    cusp::array1d<IndexType,MemorySpace> row_map;
+
+    /*! Number of nonempty rows.
+     */
+    size_t num_compact_rows;
+
+    /*! Construct an empty operator.
+     */
+    tiled_csr_operator(void);
+
+    /*! Construct the operator of a matrix.
+     *
+     * \param A matrix in any format and memory space
+     */
+    template <typename MatrixType>
+    tiled_csr_operator(const MatrixType& A);
+
+    /*! Construct a copy of an operator in another memory space.
+     */
+    template <typename MemorySpace2>
+    tiled_csr_operator(const tiled_csr_operator<IndexType,ValueType,MemorySpace2>& A);
+
+    /*! Compute y = A * x.
+     */
+    template <typename VectorType1, typename VectorType2>
+    void operator()(const VectorType1& x, VectorType2& y) const;
+};
+/*! \}
+ */
+
+} // end namespace cusp
+
+#include <cusp/detail/tiled_csr_operator.inl>
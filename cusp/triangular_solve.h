@@ -0,0 +1,182 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*! \file triangular_solve.h
+ *  \brief Sparse triangular solves with a reusable analysis
+ */
+
+#pragma once
+
+#include <cusp/detail/config.h>
+
+#include <cusp/array1d.h>
+#include <cusp/csr_matrix.h>
+
+#include <vector>
+
+namespace cusp
+{
+
+/*! \addtogroup algorithms Algorithms
+ *  \ingroup algorithms
+ *  \{
+ */
+
+/*! \p triangle_type : Triangle of a matrix used by a triangular solve
+ */
+enum triangle_type
+{
+    /*! Entries on and below the diagonal */
+    lower_triangle,
+
+    /*! Entries on and above the diagonal */
+    upper_triangle
+};
+
+/*! \p diagonal_type : Diagonal of a triangular solve
+ */
+enum diagonal_type
+{
+    /*! The diagonal entries stored in the matrix, which must be nonzero */
+    stored_diagonal,
+
+    /*! A diagonal of ones, stored diagonal entries are ignored */
+    unit_diagonal
+};
+
+/*! \p triangular_solve_plan : Analysis of a sparse triangular matrix
+ *  <tt>T = D + S</tt> for repeated solves <tt>T x = b</tt>.
+ *
+ *  The strict part \c S is stored in CSR format separately from the
+ *  reciprocals of the diagonal \c D.  The analysis computes level sets: the
+ *  level of a row is one more than the highest level of the rows it
+ *  references, so the rows of a level are independent and a solve is one
+ *  launch per level, over the rows of that level.  The analysis runs on
+ *  the host once; the solves run in the memory space of the plan.
+ *
+ *  The triangle of a general matrix is selected by \p triangle_type, the
+ *  entries of the other triangle are ignored, so the \c L and \c U factors
+ *  stored together in one matrix or the lower triangle of a matrix for a
+ *  Gauss-Seidel sweep need no copies.  With \p transposed the plan solves
+ *  with the transpose of that triangle, e.g. <tt>L^T x = b</tt> with the
+ *  lower triangle of a Cholesky factor.
+ *
+ * \tparam IndexType Type used for matrix indices (e.g. \c int).
+ * \tparam ValueType Type used for matrix values (e.g. \c float).
+ * \tparam MemorySpace A memory space (e.g. \c cusp::host_memory or \c cusp::device_memory)
+ *
+ *  \code
+ *  #include <cusp/triangular_solve.h>
+ *  #include <cusp/csr_matrix.h>
+ *  ...
+ *
+ *  cusp::csr_matrix<int,float,cusp::device_memory> LU = ...;
+ *
+ *  // analyze once
+ *  cusp::triangular_solve_plan<int,float,cusp::device_memory> L(LU, cusp::lower_triangle, cusp::unit_diagonal);
+ *  cusp::triangular_solve_plan<int,float,cusp::device_memory> U(LU, cusp::upper_triangle);
+ *
+ *  // solve L U x = b as often as needed
+ *  L.solve(b, y);
+ *  U.solve(y, x);
+ *  \endcode
+ */
+template <typename IndexType, typename ValueType, typename MemorySpace>
+class triangular_solve_plan
+{
+public:
+    cusp::csr_matrix<IndexType,ValueType,MemorySpace> strict;  // S
+    cusp::array1d<ValueType,MemorySpace> inv_diagonal;         // D^-1
+    cusp::array1d<IndexType,MemorySpace> level_rows;           // rows sorted by level
+    std::vector<size_t> level_offsets;                         // level l holds level_rows[level_offsets[l], level_offsets[l+1])
+
+    /*! Construct an empty plan
+     */
+    triangular_solve_plan(void) {}
+
+    /*! Copy a plan from another memory space
+     */
+    template <typename MemorySpace2>
+    triangular_solve_plan(const triangular_solve_plan<IndexType,ValueType,MemorySpace2>& T)
+        : strict(T.strict), inv_diagonal(T.inv_diagonal),
+          level_rows(T.level_rows), level_offsets(T.level_offsets) {}
+
+    /*! Analyze a triangle of a square matrix
+     *
+     *  \param A matrix in any format and memory space
+     *  \param triangle triangle of \p A which is solved with
+     *  \param diagonal stored or unit diagonal
+     *  \param transposed solve with the transpose of the triangle
+     *
+     *  \throws cusp::invalid_input_exception if \p A is not square or a
+     *  stored diagonal entry is zero or missing
+     */
+    template <typename MatrixType>
+    triangular_solve_plan(const MatrixType& A,
+                          const cusp::triangle_type triangle,
+                          const cusp::diagonal_type diagonal = cusp::stored_diagonal,
+                          const bool transposed = false);
+
+    /*! Analyze the triangular matrix with strict part \p S and main
+     *  diagonal \p diagonal, \p lower selects a lower or an upper
+     *  triangular matrix
+     *
+     *  \throws cusp::invalid_input_exception if an entry of \p S is not
+     *  strictly in the triangle or a diagonal entry is zero
+     */
+    void analyze(const cusp::csr_matrix<IndexType,ValueType,cusp::host_memory>& S,
+                 const cusp::array1d<ValueType,cusp::host_memory>& diagonal,
+                 const bool lower);
+
+    /*! Number of launches of a solve
+     */
+    size_t num_levels(void) const
+    {
+        return level_offsets.empty() ? 0 : level_offsets.size() - 1;
+    }
+
+    /*! Solve <tt>T x = b</tt>, \p b and \p x must not overlap
+     */
+    template <typename Array1, typename Array2>
+    void solve(const Array1& b, Array2& x) const;
+};
+
+/*! \p solve_triangular : Solve with a triangle of a sparse matrix
+ *
+ *  Analyzes the triangle with a \p triangular_solve_plan and solves once.
+ *  Construct the plan instead when solving with the same matrix again.
+ *
+ *  \param A square matrix
+ *  \param b right hand side
+ *  \param x solution, must not overlap \p b
+ *  \param triangle triangle of \p A which is solved with
+ *  \param diagonal stored or unit diagonal
+ *  \param transposed solve with the transpose of the triangle
+ */
+template <typename MatrixType, typename Array1, typename Array2>
+void solve_triangular(const MatrixType& A,
+                      const Array1& b,
+                            Array2& x,
+                      const cusp::triangle_type triangle,
+                      const cusp::diagonal_type diagonal = cusp::stored_diagonal,
+                      const bool transposed = false);
+
+/*! \}
+ */
+
+} // end namespace cusp
+
+#include <cusp/detail/triangular_solve.inl>
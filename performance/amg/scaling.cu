@@ -0,0 +1,389 @@
+#include <cusp/array1d.h>
+#include <cusp/blas.h>
+#include <cusp/csr_matrix.h>
+#include <cusp/monitor.h>
+#include <cusp/gallery/diffusion.h>
+#include <cusp/gallery/poisson.h>
+#include <cusp/krylov/cg.h>
+#include <cusp/precond/aggregation/smoothed_aggregation.h>
+
+#include <cusp/detail/work_estimate.h>
+
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../benchmark/benchmark.h"
+
+// Scaling of smoothed aggregation AMG with the problem size
+//
+// Sweeps the model problems from --min-unknowns to --max-unknowns (powers
+// of ten) on host and device memory and records, for every problem and
+// size, the setup time by stage, the hierarchy memory, the operator and
+// grid complexities, the V-cycle time, the CG iterations and the time to
+// solution.  Each record is one line of the --json output.  Built with
+// -DCUSP_BENCHMARK_NVML, the device runs also record the energy drawn by
+// the board per V-cycle and per solve.
+//
+// The growth exponent log(t1 / t0) / log(n1 / n0) between consecutive
+// sizes is 1 for a setup or solve that scales linearly; exponents above
+// --superlinear (default 1.2) are reported, ignoring sizes too small to
+// occupy the device.
+
+typedef int    IndexType;
+typedef double ValueType;
+
+struct options
+{
+    double min_unknowns;
+    double max_unknowns;
+    double max_host_unknowns;
+    double superlinear;
+    double tolerance;
+    size_t cycles;
+    std::string problems;
+    std::string spaces;
+    std::string json;
+
+    options(void)
+        : min_unknowns(1e4), max_unknowns(1e7), max_host_unknowns(1e6),
+          superlinear(1.2), tolerance(1e-8), cycles(10),
+          problems("poisson5pt,poisson7pt,poisson27pt,diffusion"),
+          spaces("host,device"), json("amg_scaling.json") {}
+};
+
+struct record
+{
+    std::string problem;
+    std::string memory_space;
+    size_t unknowns;
+    size_t nonzeros;
+    size_t num_levels;
+    double operator_complexity;
+    double grid_complexity;
+    double hierarchy_bytes;     // operators and vectors of the solve phase
+    double setup_bytes;         // setup copies, aggregates and candidates
+    double device_bytes;        // decrease of the free device memory during the setup
+    cusp::precond::aggregation::sa_level_timings stages;   // summed over the levels
+    double setup_ms;
+    double cycle_ms;            // one V-cycle
+    size_t iterations;
+    bool converged;
+    double solve_ms;
+    double cycle_joules;        // negative when not measured
+    double solve_joules;
+};
+
+// build the problem with about n unknowns, returns false for an unknown name
+template <typename Matrix>
+bool build_problem(const std::string& name, double n, Matrix& A)
+{
+    if (name == "poisson5pt")
+    {
+        const size_t m = size_t(std::sqrt(n) + 0.5);
+        cusp::gallery::poisson5pt(A, m, m);
+    }
+    else if (name == "poisson7pt")
+    {
+        const size_t m = size_t(std::pow(n, 1.0 / 3.0) + 0.5);
+        cusp::gallery::poisson7pt(A, m, m, m);
+    }
+    else if (name == "poisson27pt")
+    {
+        const size_t m = size_t(std::pow(n, 1.0 / 3.0) + 0.5);
+        cusp::gallery::poisson27pt(A, m, m, m);
+    }
+    else if (name == "diffusion")
+    {
+        const size_t m = size_t(std::sqrt(n) + 0.5);
+        cusp::gallery::diffusion<cusp::gallery::FD>(A, m, m);
+    }
+    else
+    {
+        return false;
+    }
+
+    return true;
+}
+
+size_t free_device_memory(void)
+{
+    size_t free_bytes = 0, total_bytes = 0;
+    cudaMemGetInfo(&free_bytes, &total_bytes);
+    return free_bytes;
+}
+
+template <typename Array>
+double array_bytes(const Array& x)
+{
+    return double(x.size()) * sizeof(typename Array::value_type);
+}
+
+template <typename MemorySpace>
+record run(const std::string& problem, double n, const options& opts, benchmark::energy_meter& meter)
+{
+    typedef cusp::precond::aggregation::smoothed_aggregation<IndexType, ValueType, MemorySpace> Preconditioner;
+
+    cusp::csr_matrix<IndexType, ValueType, MemorySpace> A;
+    build_problem(problem, n, A);
+
+    record r;
+    r.problem      = problem;
+    r.memory_space = thrust::detail::is_same<MemorySpace, cusp::host_memory>::value ? "host" : "device";
+    r.unknowns     = A.num_rows;
+    r.nonzeros     = A.num_entries;
+    r.cycle_joules = -1.0;
+    r.solve_joules = -1.0;
+
+    // the board draws the same power whatever the host does
+    const bool measure_energy = meter.available() && r.memory_space == "device";
+
+    // setup
+    const size_t free_before = free_device_memory();
+
+    cudaDeviceSynchronize();
+    double start = benchmark::wall_clock_ms();
+
+    Preconditioner M(A);
+
+    cudaDeviceSynchronize();
+    r.setup_ms = benchmark::wall_clock_ms() - start;
+
+    const size_t free_after = free_device_memory();
+    r.device_bytes = free_before > free_after ? double(free_before - free_after) : 0.0;
+
+    r.num_levels          = M.levels.size();
+    r.operator_complexity = M.operator_complexity();
+    r.grid_complexity     = M.grid_complexity();
+    r.hierarchy_bytes     = 0.0;
+    r.setup_bytes         = 0.0;
+
+    for (size_t lvl = 0; lvl < M.levels.size(); lvl++)
+    {
+        r.hierarchy_bytes += cusp::detail::storage_bytes(M.levels[lvl].A) +
+                             cusp::detail::storage_bytes(M.levels[lvl].R) +
+                             cusp::detail::storage_bytes(M.levels[lvl].P) +
+                             array_bytes(M.levels[lvl].x) + array_bytes(M.levels[lvl].b) +
+                             array_bytes(M.levels[lvl].residual);
+    }
+
+    for (size_t lvl = 0; lvl < M.sa_levels.size(); lvl++)
+    {
+        const cusp::precond::aggregation::sa_level_timings& T = M.sa_levels[lvl].timings;
+
+        r.stages.strength    += T.strength;
+        r.stages.aggregate   += T.aggregate;
+        r.stages.tentative   += T.tentative;
+        r.stages.smooth      += T.smooth;
+        r.stages.restriction += T.restriction;
+        r.stages.galerkin    += T.galerkin;
+
+        r.setup_bytes += cusp::detail::storage_bytes(M.sa_levels[lvl].A_) +
+                         array_bytes(M.sa_levels[lvl].aggregates) +
+                         double(M.sa_levels[lvl].B.num_entries) * sizeof(ValueType);
+    }
+
+    cusp::array1d<ValueType, MemorySpace> b(A.num_rows, 1);
+    cusp::array1d<ValueType, MemorySpace> x(A.num_rows, 0);
+
+    // V-cycles
+    M(b, x);
+    cudaDeviceSynchronize();
+    start = benchmark::wall_clock_ms();
+    if (measure_energy)
+        meter.start();
+
+    for (size_t i = 0; i < opts.cycles; i++)
+        M(b, x);
+
+    cudaDeviceSynchronize();
+    r.cycle_ms = (benchmark::wall_clock_ms() - start) / opts.cycles;
+    if (measure_energy)
+        r.cycle_joules = meter.stop() / opts.cycles;
+
+    // preconditioned CG
+    cusp::blas::fill(x, ValueType(0));
+    cusp::default_monitor<ValueType> monitor(b, 1000, opts.tolerance);
+
+    cudaDeviceSynchronize();
+    start = benchmark::wall_clock_ms();
+    if (measure_energy)
+        meter.start();
+
+    cusp::krylov::cg(A, x, b, monitor, M);
+
+    cudaDeviceSynchronize();
+    r.solve_ms   = benchmark::wall_clock_ms() - start;
+    if (measure_energy)
+        r.solve_joules = meter.stop();
+    r.iterations = monitor.iteration_count();
+    r.converged  = monitor.converged();
+
+    return r;
+}
+
+void write_json(std::ostream& os, const record& r)
+{
+    os << "{\"problem\": "              << benchmark::json_string(r.problem)
+       << ", \"memory_space\": "        << benchmark::json_string(r.memory_space)
+       << ", \"unknowns\": "            << r.unknowns
+       << ", \"nonzeros\": "            << r.nonzeros
+       << ", \"num_levels\": "          << r.num_levels
+       << ", \"operator_complexity\": " << r.operator_complexity
+       << ", \"grid_complexity\": "     << r.grid_complexity
+       << ", \"hierarchy_bytes\": "     << r.hierarchy_bytes
+       << ", \"setup_bytes\": "         << r.setup_bytes
+       << ", \"device_bytes\": "        << r.device_bytes
+       << ", \"setup_ms\": "            << r.setup_ms
+       << ", \"strength_ms\": "         << r.stages.strength
+       << ", \"aggregate_ms\": "        << r.stages.aggregate
+       << ", \"fit_candidates_ms\": "   << r.stages.tentative
+       << ", \"smooth_ms\": "           << r.stages.smooth
+       << ", \"restriction_ms\": "      << r.stages.restriction
+       << ", \"galerkin_ms\": "         << r.stages.galerkin
+       << ", \"cycle_ms\": "            << r.cycle_ms
+       << ", \"iterations\": "          << r.iterations
+       << ", \"converged\": "           << (r.converged ? "true" : "false")
+       << ", \"solve_ms\": "            << r.solve_ms
+       << ", \"time_to_solution_ms\": " << r.setup_ms + r.solve_ms;
+
+    if (r.solve_joules >= 0.0)
+        os << ", \"cycle_joules\": " << r.cycle_joules
+           << ", \"solve_joules\": " << r.solve_joules;
+
+    os << "}";
+}
+
+// growth exponent of t between two sizes
+double growth(double t0, double t1, double n0, double n1)
+{
+    return (t0 > 0.0 && t1 > 0.0 && n1 > n0) ? std::log(t1 / t0) / std::log(n1 / n0) : 0.0;
+}
+
+void report_growth(const std::vector<record>& records, const options& opts)
+{
+    for (size_t i = 1; i < records.size(); i++)
+    {
+        const record& r0 = records[i - 1];
+        const record& r1 = records[i];
+
+        if (r0.problem != r1.problem || r0.memory_space != r1.memory_space)
+            continue;
+
+        // small problems are dominated by launch overhead
+        if (r0.unknowns < 1e5)
+            continue;
+
+        const char * stages[]   = {"setup", "strength", "aggregate", "fit_candidates", "smooth", "restriction", "galerkin", "cycle"};
+        const double before[]   = {r0.setup_ms, r0.stages.strength, r0.stages.aggregate, r0.stages.tentative, r0.stages.smooth, r0.stages.restriction, r0.stages.galerkin, r0.cycle_ms};
+        const double after[]    = {r1.setup_ms, r1.stages.strength, r1.stages.aggregate, r1.stages.tentative, r1.stages.smooth, r1.stages.restriction, r1.stages.galerkin, r1.cycle_ms};
+
+        for (size_t s = 0; s < sizeof(stages) / sizeof(stages[0]); s++)
+        {
+            const double exponent = growth(before[s], after[s], r0.unknowns, r1.unknowns);
+
+            if (exponent > opts.superlinear)
+                printf("superlinear %s of %s on %s: exponent %.2f from %lu to %lu unknowns\n",
+                       stages[s], r1.problem.c_str(), r1.memory_space.c_str(), exponent,
+                       (unsigned long) r0.unknowns, (unsigned long) r1.unknowns);
+        }
+    }
+}
+
+bool contains(const std::string& list, const std::string& item)
+{
+    return ("," + list + ",").find("," + item + ",") != std::string::npos;
+}
+
+void usage(const char * program)
+{
+    std::cout << "usage: " << program << " [options]\n"
+              << "  --problems=<list>         poisson5pt,poisson7pt,poisson27pt,diffusion\n"
+              << "  --spaces=<list>           host,device\n"
+              << "  --min-unknowns=<n>        smallest problem (default 1e4)\n"
+              << "  --max-unknowns=<n>        largest problem (default 1e7, up to 1e8)\n"
+              << "  --max-host-unknowns=<n>   largest problem on the host (default 1e6)\n"
+              << "  --cycles=<n>              V-cycles timed per size (default 10)\n"
+              << "  --tolerance=<x>           relative tolerance of the solve (default 1e-8)\n"
+              << "  --superlinear=<x>         growth exponent reported (default 1.2)\n"
+              << "  --json=<file>             output (default amg_scaling.json)\n";
+}
+
+int main(int argc, char ** argv)
+{
+    options opts;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string arg(argv[i]);
+        std::string value;
+
+        if      (benchmark::parse_option(arg, "problems", value))          opts.problems = value;
+        else if (benchmark::parse_option(arg, "spaces", value))            opts.spaces = value;
+        else if (benchmark::parse_option(arg, "min-unknowns", value))      opts.min_unknowns = atof(value.c_str());
+        else if (benchmark::parse_option(arg, "max-unknowns", value))      opts.max_unknowns = atof(value.c_str());
+        else if (benchmark::parse_option(arg, "max-host-unknowns", value)) opts.max_host_unknowns = atof(value.c_str());
+        else if (benchmark::parse_option(arg, "cycles", value))            opts.cycles = std::max(1, atoi(value.c_str()));
+        else if (benchmark::parse_option(arg, "tolerance", value))         opts.tolerance = atof(value.c_str());
+        else if (benchmark::parse_option(arg, "superlinear", value))       opts.superlinear = atof(value.c_str());
+        else if (benchmark::parse_option(arg, "json", value))              opts.json = value;
+        else
+        {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    const char * problems[] = {"poisson5pt", "poisson7pt", "poisson27pt", "diffusion"};
+
+    std::vector<record> records;
+    std::ofstream file(opts.json.c_str());
+
+    benchmark::energy_meter meter(0);
+
+    file << "{\n\"context\": " << benchmark::device_context_json(0) << ",\n\"results\": [\n";
+
+    for (size_t p = 0; p < sizeof(problems) / sizeof(problems[0]); p++)
+    {
+        if (!contains(opts.problems, problems[p]))
+            continue;
+
+        for (int space = 0; space < 2; space++)
+        {
+            if (!contains(opts.spaces, space == 0 ? "host" : "device"))
+                continue;
+
+            const double max_unknowns = space == 0 ? std::min(opts.max_unknowns, opts.max_host_unknowns) : opts.max_unknowns;
+
+            for (double n = opts.min_unknowns; n <= max_unknowns * 1.0001; n *= 10)
+            {
+                record r = space == 0 ? run<cusp::host_memory>(problems[p], n, opts, meter)
+                                      : run<cusp::device_memory>(problems[p], n, opts, meter);
+
+                printf("%-12s %-6s %10lu unknowns %2lu levels  setup %10.2f ms  cycle %8.3f ms  %4lu iterations  solution %10.2f ms",
+                       r.problem.c_str(), r.memory_space.c_str(), (unsigned long) r.unknowns, (unsigned long) r.num_levels,
+                       r.setup_ms, r.cycle_ms, (unsigned long) r.iterations, r.setup_ms + r.solve_ms);
+
+                if (r.solve_joules >= 0.0)
+                    printf("  cycle %8.3f mJ  solve %8.3f J", 1.0e3 * r.cycle_joules, r.solve_joules);
+
+                printf("\n");
+                fflush(stdout);
+
+                file << (records.empty() ? "" : ",\n");
+                write_json(file, r);
+                file.flush();
+
+                records.push_back(r);
+            }
+        }
+    }
+
+    file << "\n]\n}\n";
+
+    report_growth(records, opts);
+
+    return 0;
+}
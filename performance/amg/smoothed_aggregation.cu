@@ -8,6 +8,10 @@
 #include <iostream>
 
 #include "../timer.h"
+#include "../benchmark/benchmark.h"
+
+// energy drawn by the device, when built with -DCUSP_BENCHMARK_NVML
+benchmark::energy_meter meter(0);
 
 template<typename IndexType, typename ValueType, typename MemorySpace>
 class unsmoothed_aggregation_options
@@ -43,6 +47,18 @@ void report_status(Monitor& monitor)
     }
 }
 
+template <typename Monitor>
+void report_energy(double joules, Monitor& monitor)
+{
+    if (!meter.available())
+        return;
+
+    std::cout << "consumed " << joules << " J";
+    if (monitor.iteration_count() > 0)
+        std::cout << " (" << 1e3 * joules / monitor.iteration_count() << " mJ per iteration)";
+    std::cout << std::endl;
+}
+
 template<typename MatrixType, typename Prec>
 void run_amg(const MatrixType& A, Prec& M)
 {
@@ -59,11 +75,32 @@ void run_amg(const MatrixType& A, Prec& M)
 
     // solve
     timer t1;
+    meter.start();
     cusp::krylov::cg(A, x, b, monitor, M);
     std::cout << "solved system  in " << t1.milliseconds_elapsed() << " ms " << std::endl;
+    const double joules = meter.stop();
 
     // report status
     report_status(monitor);
+    report_energy(joules, monitor);
+
+    // V-cycles alone
+    if (meter.available())
+    {
+        const int cycles = 10;
+
+        M(b, x);
+        cudaDeviceSynchronize();
+
+        timer t2;
+        meter.start();
+        for (int i = 0; i < cycles; i++)
+            M(b, x);
+        const float ms = t2.milliseconds_elapsed();
+        const double cycle_joules = meter.stop() / cycles;
+
+        std::cout << "V-cycle takes " << ms / cycles << " ms and " << 1e3 * cycle_joules << " mJ" << std::endl;
+    }
 }
 
 int main(int argc, char ** argv)
@@ -93,11 +130,14 @@ int main(int argc, char ** argv)
 
         // solve
         timer t0;
+        meter.start();
         cusp::krylov::cg(A, x, b, monitor);
         std::cout << "solved system  in " << t0.milliseconds_elapsed() << " ms " << std::endl;
+        const double joules = meter.stop();
 
         // report status
         report_status(monitor);
+        report_energy(joules, monitor);
     }
 
     // solve with smoothed aggregation algebraic multigrid preconditioner
@@ -124,6 +164,30 @@ int main(int argc, char ** argv)
         run_amg(A,M);
     }
 
+    // solve with the cheaper estimates of the spectral radius of each level
+    {
+        const char * names[2] = { "power iteration", "Gershgorin" };
+        cusp::precond::aggregation::spectral_radius_estimate estimates[2] = {
+            cusp::precond::aggregation::POWER_SPECTRAL_RADIUS,
+            cusp::precond::aggregation::DISKS_SPECTRAL_RADIUS };
+
+        for (int i = 0; i < 2; i++)
+        {
+            std::cout << "\nSolving with smoothed aggregation preconditioner and " << names[i] << " spectral radius" << std::endl;
+
+            cusp::precond::aggregation::smoothed_aggregation_options<IndexType, ValueType, MemorySpace>
+                opts(0.0, 4.0/3.0, 100, 20, 0, 2, 0.0, 0, 0.0,
+                     cusp::precond::aggregation::JACOBI_PROLONGATION, 4,
+                     cusp::precond::aggregation::SYMMETRIC_STRENGTH, estimates[i]);
+
+            timer t0;
+            cusp::precond::aggregation::smoothed_aggregation<IndexType, ValueType, MemorySpace> M(A, opts);
+            std::cout << "constructed hierarchy in " << t0.milliseconds_elapsed() << " ms " << std::endl;
+
+            run_amg(A,M);
+        }
+    }
+
     // solve with unsmoothed aggregation algebraic multigrid preconditioner and polynomial smoother
     {
         std::cout << "\nSolving with unsmoothed aggregation preconditioner" << std::endl;
@@ -0,0 +1,864 @@
+/*
+ *  Copyright 2008-2009 NVIDIA Corporation
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+// A small benchmark framework shared by the cusp performance programs.
+//
+// Benchmarks are functions taking a benchmark::state, registered with
+// BENCHMARK(function) or BENCHMARK_NAMED(function, "name").  They do their
+// setup and then repeat the measured operation while state.keep_running()
+// returns true:
+//
+//   void spmv_csr(benchmark::state& state)
+//   {
+//       ... setup ...
+//       state.set_work(bytes, flops);          // per iteration
+//       while (state.keep_running())
+//           cusp::multiply(A, x, y);
+//   }
+//   BENCHMARK_NAMED(spmv_csr, "spmv/csr");
+//
+// keep_running() first runs a few warm-up iterations, then calibrates the
+// number of iterations per sample so that each sample lasts at least
+// --min-sample-ms, and finally collects --repetitions samples.  A sample
+// is timed on the host with a device synchronization at its end, so it
+// covers host and device work alike.  The report gives the median, the
+// mean, the 10th and 90th percentiles and a 95% confidence interval of
+// the median per iteration, and the achieved GB/s and GFLOP/s.
+//
+// benchmark::main parses the common options, runs the selected benchmarks
+// and writes the results as JSON (--json), one benchmark per line, which
+// is also the format read by --baseline to flag regressions.
+//
+// Built with -DCUSP_BENCHMARK_NVML, the energy drawn by the device over
+// the measured samples is read from NVML and reported as millijoules per
+// iteration next to the bandwidth.  The energy counter of the board is
+// only updated every few tens of milliseconds, so the measured phase
+// (--repetitions times --min-sample-ms) should last well over a second.
+
+#include <cuda_runtime_api.h>
+
+#if defined(CUSP_BENCHMARK_NVML)
+#include <nvml.h>
+#include <pthread.h>
+#endif
+
+#include <cusp/version.h>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+namespace benchmark
+{
+
+/////////////
+// Options //
+/////////////
+
+struct options
+{
+    std::string filter;
+    std::string json;
+    std::string baseline;
+    std::string matrix;
+    size_t repetitions;
+    size_t warmup;
+    double min_sample_ms;
+    double threshold;
+    int device;
+    int lock_clocks;
+    bool list;
+
+    options(void)
+        : repetitions(20), warmup(3), min_sample_ms(10.0), threshold(0.05),
+          device(0), lock_clocks(0), list(false) {}
+};
+
+inline options& current_options(void)
+{
+    static options opts;
+    return opts;
+}
+
+inline double wall_clock_ms(void)
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return 1.0e3 * tv.tv_sec + 1.0e-3 * tv.tv_usec;
+}
+
+////////////////
+// Statistics //
+////////////////
+
+struct statistics
+{
+    size_t samples;
+    double median;
+    double mean;
+    double stddev;
+    double min;
+    double max;
+    double p10;
+    double p90;
+    double ci95_low;
+    double ci95_high;
+
+    statistics(void)
+        : samples(0), median(0), mean(0), stddev(0), min(0), max(0),
+          p10(0), p90(0), ci95_low(0), ci95_high(0) {}
+};
+
+// linear interpolation between the closest ranks of sorted values
+inline double percentile(const std::vector<double>& sorted, double p)
+{
+    if (sorted.empty())
+        return 0.0;
+
+    const double rank = p * (sorted.size() - 1);
+    const size_t lower = size_t(rank);
+    const size_t upper = std::min(lower + 1, sorted.size() - 1);
+
+    return sorted[lower] + (rank - lower) * (sorted[upper] - sorted[lower]);
+}
+
+inline statistics compute_statistics(std::vector<double> values)
+{
+    statistics s;
+
+    if (values.empty())
+        return s;
+
+    std::sort(values.begin(), values.end());
+
+    const size_t n = values.size();
+
+    double sum = 0.0;
+    for (size_t i = 0; i < n; i++)
+        sum += values[i];
+
+    double squares = 0.0;
+    for (size_t i = 0; i < n; i++)
+        squares += (values[i] - sum / n) * (values[i] - sum / n);
+
+    s.samples = n;
+    s.mean    = sum / n;
+    s.stddev  = n > 1 ? std::sqrt(squares / (n - 1)) : 0.0;
+    s.min     = values.front();
+    s.max     = values.back();
+    s.median  = percentile(values, 0.5);
+    s.p10     = percentile(values, 0.1);
+    s.p90     = percentile(values, 0.9);
+
+    // distribution-free interval of the median from the order statistics
+    // at ranks n/2 -+ 1.96 sqrt(n)/2 (normal approximation of the binomial)
+    const double half_width = 0.98 * std::sqrt(double(n));
+    const double low_rank   = std::max(0.0, std::floor(0.5 * n - half_width));
+    const double high_rank  = std::min(double(n - 1), std::ceil(0.5 * n + half_width) - 1.0);
+
+    s.ci95_low  = values[size_t(low_rank)];
+    s.ci95_high = values[size_t(std::max(low_rank, high_rank))];
+
+    return s;
+}
+
+////////////
+// Energy //
+////////////
+
+#if defined(CUSP_BENCHMARK_NVML)
+// NVML handle of a CUDA device, whose numbering may differ from NVML's
+inline bool nvml_device_handle(int device, nvmlDevice_t& handle)
+{
+    cudaDeviceProp properties;
+    cudaGetDeviceProperties(&properties, device);
+
+    char bus_id[32];
+    snprintf(bus_id, sizeof(bus_id), "%04x:%02x:%02x.0",
+             properties.pciDomainID, properties.pciBusID, properties.pciDeviceID);
+
+    return nvmlDeviceGetHandleByPciBusId(bus_id, &handle) == NVML_SUCCESS;
+}
+#endif
+
+// energy drawn by the board of a device between start() and stop(), in
+// joules.  Boards with a cumulative energy counter (Volta and later) are
+// read directly; older boards have their power sampled by a thread every
+// SAMPLE_MS milliseconds and integrated with the trapezoidal rule.
+// available() is false without NVML or when the board reports neither.
+class energy_meter
+{
+#if defined(CUSP_BENCHMARK_NVML)
+    static const unsigned int SAMPLE_MS = 5;
+
+    bool initialized;
+    bool has_counter;
+    bool has_power;
+    nvmlDevice_t handle;
+
+    unsigned long long start_mj;
+
+    // state shared with the sampling thread
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    bool sampling;
+    double joules;
+
+    static void * sample(void * arg)
+    {
+        energy_meter& meter = *static_cast<energy_meter*>(arg);
+
+        double last_ms = wall_clock_ms();
+        double last_watts = meter.power();
+
+        for (;;)
+        {
+            usleep(1000 * SAMPLE_MS);
+
+            const double now_ms = wall_clock_ms();
+            const double watts  = meter.power();
+
+            pthread_mutex_lock(&meter.mutex);
+            const bool running = meter.sampling;
+            meter.joules += 0.5e-3 * (watts + last_watts) * (now_ms - last_ms);
+            pthread_mutex_unlock(&meter.mutex);
+
+            if (!running)
+                return NULL;
+
+            last_ms    = now_ms;
+            last_watts = watts;
+        }
+    }
+
+    double power(void)
+    {
+        unsigned int mw = 0;
+        return nvmlDeviceGetPowerUsage(handle, &mw) == NVML_SUCCESS ? 1.0e-3 * mw : 0.0;
+    }
+
+    public:
+    energy_meter(int device)
+        : initialized(false), has_counter(false), has_power(false),
+          start_mj(0), sampling(false), joules(0.0)
+    {
+        pthread_mutex_init(&mutex, NULL);
+
+        if (nvmlInit() != NVML_SUCCESS)
+            return;
+
+        initialized = true;
+
+        if (!nvml_device_handle(device, handle))
+            return;
+
+        unsigned long long mj = 0;
+        unsigned int mw = 0;
+
+        has_counter = nvmlDeviceGetTotalEnergyConsumption(handle, &mj) == NVML_SUCCESS;
+        has_power   = nvmlDeviceGetPowerUsage(handle, &mw) == NVML_SUCCESS;
+    }
+
+    ~energy_meter(void)
+    {
+        if (sampling)
+            stop();
+        if (initialized)
+            nvmlShutdown();
+        pthread_mutex_destroy(&mutex);
+    }
+
+    bool available(void) const
+    {
+        return has_counter || has_power;
+    }
+
+    void start(void)
+    {
+        if (has_counter)
+        {
+            nvmlDeviceGetTotalEnergyConsumption(handle, &start_mj);
+        }
+        else if (has_power && !sampling)
+        {
+            joules   = 0.0;
+            sampling = true;
+
+            if (pthread_create(&thread, NULL, sample, this) != 0)
+                sampling = false;
+        }
+    }
+
+    double stop(void)
+    {
+        if (has_counter)
+        {
+            unsigned long long mj = start_mj;
+            nvmlDeviceGetTotalEnergyConsumption(handle, &mj);
+            return 1.0e-3 * double(mj - start_mj);
+        }
+
+        if (!sampling)
+            return 0.0;
+
+        pthread_mutex_lock(&mutex);
+        sampling = false;
+        pthread_mutex_unlock(&mutex);
+
+        pthread_join(thread, NULL);
+
+        return joules;
+    }
+#else
+    public:
+    energy_meter(int) {}
+
+    bool available(void) const { return false; }
+    void start(void) {}
+    double stop(void) { return 0.0; }
+#endif
+};
+
+///////////
+// State //
+///////////
+
+class state
+{
+    enum phase { WARMUP, CALIBRATE, MEASURE, DONE };
+
+    phase current_phase;
+    size_t batch_size;
+    size_t remaining;
+    bool in_batch;
+    double batch_start;
+
+    const options& opts;
+    energy_meter * meter;
+
+    public:
+    std::vector<double> samples;     // milliseconds per iteration
+    size_t iterations_per_sample;
+    double bytes;                    // per iteration
+    double flops;                    // per iteration
+    double joules;                   // per iteration, negative when not measured
+    std::string label;
+    std::string skip_reason;
+    std::map<std::string, double> counters;
+
+    state(const options& opts, energy_meter * meter = NULL)
+        : current_phase(opts.warmup > 0 ? WARMUP : CALIBRATE),
+          batch_size(opts.warmup > 0 ? opts.warmup : 1),
+          remaining(0), in_batch(false), batch_start(0.0), opts(opts), meter(meter),
+          iterations_per_sample(1), bytes(0.0), flops(0.0), joules(-1.0) {}
+
+    // bytes moved and floating point operations of one iteration
+    void set_work(double bytes_per_iteration, double flops_per_iteration)
+    {
+        bytes = bytes_per_iteration;
+        flops = flops_per_iteration;
+    }
+
+    void set_label(const std::string& text)
+    {
+        label = text;
+    }
+
+    void set_counter(const std::string& name, double value)
+    {
+        counters[name] = value;
+    }
+
+    // mark the benchmark as not applicable, e.g. an unsupported conversion
+    void skip(const std::string& reason)
+    {
+        skip_reason = reason;
+        current_phase = DONE;
+    }
+
+    bool skipped(void) const
+    {
+        return !skip_reason.empty();
+    }
+
+    bool keep_running(void)
+    {
+        if (current_phase == DONE)
+            return false;
+
+        if (in_batch && --remaining > 0)
+            return true;
+
+        if (in_batch)
+        {
+            cudaDeviceSynchronize();
+            finish_batch(wall_clock_ms() - batch_start);
+        }
+
+        if (current_phase == DONE)
+            return false;
+
+        cudaDeviceSynchronize();
+
+        // the energy covers the whole measured phase, the counter is too
+        // coarse for single samples
+        if (current_phase == MEASURE && samples.empty() && meter != NULL && meter->available())
+            meter->start();
+
+        remaining   = batch_size;
+        in_batch    = true;
+        batch_start = wall_clock_ms();
+
+        return true;
+    }
+
+    private:
+    void finish_batch(double elapsed)
+    {
+        in_batch = false;
+
+        switch (current_phase)
+        {
+            case WARMUP:
+                current_phase = CALIBRATE;
+                batch_size = 1;
+                break;
+
+            case CALIBRATE:
+                // grow the batch until a sample lasts min_sample_ms
+                if (elapsed < opts.min_sample_ms && batch_size < (size_t(1) << 24))
+                {
+                    if (elapsed * 16 < opts.min_sample_ms)
+                        batch_size *= 16;
+                    else
+                        batch_size = size_t(std::ceil(batch_size * opts.min_sample_ms / std::max(elapsed, 1.0e-3)));
+                    break;
+                }
+                iterations_per_sample = batch_size;
+                current_phase = opts.repetitions > 0 ? MEASURE : DONE;
+                break;
+
+            case MEASURE:
+                samples.push_back(elapsed / batch_size);
+                if (samples.size() >= opts.repetitions)
+                {
+                    current_phase = DONE;
+                    if (meter != NULL && meter->available())
+                        joules = meter->stop() / double(samples.size() * batch_size);
+                }
+                break;
+
+            default:
+                break;
+        }
+    }
+};
+
+//////////////
+// Registry //
+//////////////
+
+typedef void (*function)(state&);
+
+struct entry
+{
+    std::string name;
+    benchmark::function function;
+};
+
+inline std::vector<entry>& registry(void)
+{
+    static std::vector<entry> entries;
+    return entries;
+}
+
+struct registration
+{
+    registration(benchmark::function f, const std::string& name)
+    {
+        entry e;
+        e.name = name;
+        e.function = f;
+        registry().push_back(e);
+    }
+};
+
+#define BENCHMARK_CONCAT_DETAIL(a, b) a##b
+#define BENCHMARK_CONCAT(a, b)        BENCHMARK_CONCAT_DETAIL(a, b)
+
+// register function under name, function may be a template instantiation
+// in parentheses, e.g. BENCHMARK_NAMED((spmv<Matrix, float>), "spmv/float")
+#define BENCHMARK_NAMED(function, name) \
+    static benchmark::registration BENCHMARK_CONCAT(benchmark_registration_, __LINE__)(function, name)
+
+#define BENCHMARK(function) BENCHMARK_NAMED(function, #function)
+
+////////////
+// Report //
+////////////
+
+struct result
+{
+    std::string name;
+    std::string label;
+    std::string skip_reason;
+    statistics stats;
+    size_t iterations_per_sample;
+    double bytes;
+    double flops;
+    double joules;
+    std::map<std::string, double> counters;
+
+    double gbytes_per_second(void) const
+    {
+        return stats.median > 0.0 ? bytes / (stats.median * 1.0e6) : 0.0;
+    }
+
+    double gflops_per_second(void) const
+    {
+        return stats.median > 0.0 ? flops / (stats.median * 1.0e6) : 0.0;
+    }
+};
+
+inline std::string json_string(const std::string& text)
+{
+    std::string out = "\"";
+    for (size_t i = 0; i < text.size(); i++)
+    {
+        if (text[i] == '"' || text[i] == '\\')
+            out += '\\';
+        out += text[i];
+    }
+    return out + "\"";
+}
+
+inline void write_json(std::ostream& os, const result& r)
+{
+    os << "{\"name\": " << json_string(r.name);
+
+    if (!r.skip_reason.empty())
+    {
+        os << ", \"skipped\": " << json_string(r.skip_reason) << "}";
+        return;
+    }
+
+    os << ", \"label\": " << json_string(r.label)
+       << ", \"samples\": " << r.stats.samples
+       << ", \"iterations_per_sample\": " << r.iterations_per_sample
+       << ", \"median_ms\": " << r.stats.median
+       << ", \"mean_ms\": " << r.stats.mean
+       << ", \"stddev_ms\": " << r.stats.stddev
+       << ", \"min_ms\": " << r.stats.min
+       << ", \"max_ms\": " << r.stats.max
+       << ", \"p10_ms\": " << r.stats.p10
+       << ", \"p90_ms\": " << r.stats.p90
+       << ", \"ci95_low_ms\": " << r.stats.ci95_low
+       << ", \"ci95_high_ms\": " << r.stats.ci95_high
+       << ", \"bytes\": " << r.bytes
+       << ", \"flops\": " << r.flops
+       << ", \"gbytes_per_second\": " << r.gbytes_per_second()
+       << ", \"gflops_per_second\": " << r.gflops_per_second();
+
+    if (r.joules >= 0.0)
+        os << ", \"joules\": " << r.joules
+           << ", \"watts\": " << (r.stats.mean > 0.0 ? 1.0e3 * r.joules / r.stats.mean : 0.0);
+
+    os << ", \"counters\": {";
+
+    for (std::map<std::string, double>::const_iterator it = r.counters.begin(); it != r.counters.end(); ++it)
+        os << (it == r.counters.begin() ? "" : ", ") << json_string(it->first) << ": " << it->second;
+
+    os << "}}";
+}
+
+inline std::string device_context_json(int device)
+{
+    cudaDeviceProp properties;
+    cudaGetDeviceProperties(&properties, device);
+
+    int driver_version = 0, runtime_version = 0;
+    cudaDriverGetVersion(&driver_version);
+    cudaRuntimeGetVersion(&runtime_version);
+
+    char date[64];
+    time_t now = time(NULL);
+    strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", gmtime(&now));
+
+    std::ostringstream os;
+    os << "{\"device\": " << json_string(properties.name)
+       << ", \"compute_capability\": \"" << properties.major << "." << properties.minor << "\""
+       << ", \"sm_clock_khz\": " << properties.clockRate
+       << ", \"memory_clock_khz\": " << properties.memoryClockRate
+       << ", \"memory_bus_width\": " << properties.memoryBusWidth
+       << ", \"locked_clocks_mhz\": " << current_options().lock_clocks
+       << ", \"driver_version\": " << driver_version
+       << ", \"runtime_version\": " << runtime_version
+       << ", \"cusp_version\": \"" << CUSP_MAJOR_VERSION << "." << CUSP_MINOR_VERSION << "." << CUSP_SUBMINOR_VERSION << "\""
+       << ", \"date\": \"" << date << "\""
+       << ", \"repetitions\": " << current_options().repetitions
+       << ", \"min_sample_ms\": " << current_options().min_sample_ms << "}";
+
+    return os.str();
+}
+
+// read the medians of a previous --json report
+inline std::map<std::string, double> read_baseline(const std::string& filename)
+{
+    std::map<std::string, double> medians;
+
+    std::ifstream file(filename.c_str());
+    std::string line;
+
+    while (std::getline(file, line))
+    {
+        const std::string name_key   = "{\"name\": \"";
+        const std::string median_key = "\"median_ms\": ";
+
+        size_t name_begin = line.find(name_key);
+        size_t median_pos = line.find(median_key);
+
+        if (name_begin == std::string::npos || median_pos == std::string::npos)
+            continue;
+
+        name_begin += name_key.size();
+        const size_t name_end = line.find('"', name_begin);
+
+        medians[line.substr(name_begin, name_end - name_begin)] =
+            atof(line.c_str() + median_pos + median_key.size());
+    }
+
+    return medians;
+}
+
+//////////////////
+// Clock control //
+//////////////////
+
+// lock the SM clock of the device to mhz through NVML (requires
+// CUSP_BENCHMARK_NVML and sufficient privileges), so that repeated runs
+// are not affected by boost clocks and thermal throttling
+struct clock_lock
+{
+    bool locked;
+
+#if defined(CUSP_BENCHMARK_NVML)
+    bool initialized;
+    nvmlDevice_t handle;
+
+    clock_lock(int device, int mhz) : locked(false), initialized(false)
+    {
+        if (mhz <= 0 || nvmlInit() != NVML_SUCCESS)
+            return;
+
+        initialized = true;
+
+        if (nvml_device_handle(device, handle) &&
+            nvmlDeviceSetGpuLockedClocks(handle, mhz, mhz) == NVML_SUCCESS)
+            locked = true;
+        else
+            std::cerr << "warning: could not lock the clocks of device " << device << std::endl;
+    }
+
+    ~clock_lock(void)
+    {
+        if (locked)
+            nvmlDeviceResetGpuLockedClocks(handle);
+        if (initialized)
+            nvmlShutdown();
+    }
+#else
+    clock_lock(int device, int mhz) : locked(false)
+    {
+        if (mhz > 0)
+            std::cerr << "warning: --lock-clocks requires building with -DCUSP_BENCHMARK_NVML" << std::endl;
+    }
+#endif
+};
+
+//////////
+// Main //
+//////////
+
+inline void usage(const char * program)
+{
+    std::cout << "usage: " << program << " [options]\n"
+              << "  --filter=<text>       run the benchmarks whose name contains text\n"
+              << "  --list                list the benchmarks and exit\n"
+              << "  --matrix=<file.mtx>   input matrix (default: 2D Poisson problem)\n"
+              << "  --repetitions=<n>     samples per benchmark (default 20)\n"
+              << "  --warmup=<n>          warm-up iterations (default 3)\n"
+              << "  --min-sample-ms=<ms>  minimum duration of a sample (default 10)\n"
+              << "  --device=<n>          CUDA device (default 0)\n"
+              << "  --lock-clocks=<MHz>   lock the SM clock through NVML\n"
+              << "  --json=<file>         write the results as JSON\n"
+              << "  --baseline=<file>     compare the medians with a previous --json report\n"
+              << "  --threshold=<x>       relative slowdown reported as a regression (default 0.05)\n";
+}
+
+inline bool parse_option(const std::string& arg, const char * name, std::string& value)
+{
+    const std::string prefix = std::string("--") + name + "=";
+
+    if (arg.compare(0, prefix.size(), prefix) != 0)
+        return false;
+
+    value = arg.substr(prefix.size());
+    return true;
+}
+
+// returns false when the program should exit
+inline bool parse_arguments(int argc, char ** argv)
+{
+    options& opts = current_options();
+
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string arg(argv[i]);
+        std::string value;
+
+        if      (parse_option(arg, "filter", value))        opts.filter = value;
+        else if (parse_option(arg, "json", value))          opts.json = value;
+        else if (parse_option(arg, "baseline", value))      opts.baseline = value;
+        else if (parse_option(arg, "matrix", value))        opts.matrix = value;
+        else if (parse_option(arg, "repetitions", value))   opts.repetitions = atoi(value.c_str());
+        else if (parse_option(arg, "warmup", value))        opts.warmup = atoi(value.c_str());
+        else if (parse_option(arg, "min-sample-ms", value)) opts.min_sample_ms = atof(value.c_str());
+        else if (parse_option(arg, "threshold", value))     opts.threshold = atof(value.c_str());
+        else if (parse_option(arg, "device", value))        opts.device = atoi(value.c_str());
+        else if (parse_option(arg, "lock-clocks", value))   opts.lock_clocks = atoi(value.c_str());
+        else if (arg == "--list")                           opts.list = true;
+        else
+        {
+            usage(argv[0]);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// run the registered benchmarks, returns the number of regressions
+// against the baseline
+inline int main(int argc, char ** argv)
+{
+    if (!parse_arguments(argc, argv))
+        return 1;
+
+    const options& opts = current_options();
+    const std::vector<entry>& entries = registry();
+
+    if (opts.list)
+    {
+        for (size_t i = 0; i < entries.size(); i++)
+            std::cout << entries[i].name << "\n";
+        return 0;
+    }
+
+    cudaSetDevice(opts.device);
+
+    clock_lock lock(opts.device, opts.lock_clocks);
+    energy_meter meter(opts.device);
+
+    std::map<std::string, double> baseline;
+    if (!opts.baseline.empty())
+        baseline = read_baseline(opts.baseline);
+
+    std::vector<result> results;
+    int regressions = 0;
+
+    for (size_t i = 0; i < entries.size(); i++)
+    {
+        if (entries[i].name.find(opts.filter) == std::string::npos)
+            continue;
+
+        state s(opts, &meter);
+        entries[i].function(s);
+
+        result r;
+        r.name                  = entries[i].name;
+        r.label                 = s.label;
+        r.skip_reason           = s.skip_reason;
+        r.stats                 = compute_statistics(s.samples);
+        r.iterations_per_sample = s.iterations_per_sample;
+        r.bytes                 = s.bytes;
+        r.flops                 = s.flops;
+        r.joules                = s.joules;
+        r.counters              = s.counters;
+        results.push_back(r);
+
+        if (s.skipped())
+        {
+            printf("%-48s skipped (%s)\n", r.name.c_str(), r.skip_reason.c_str());
+            continue;
+        }
+
+        printf("%-48s %10.4f ms [%10.4f, %10.4f] %8.2f GB/s %8.2f GFLOP/s",
+               r.name.c_str(), r.stats.median, r.stats.ci95_low, r.stats.ci95_high,
+               r.gbytes_per_second(), r.gflops_per_second());
+
+        if (r.joules >= 0.0)
+            printf(" %9.4f mJ", 1.0e3 * r.joules);
+
+        std::map<std::string, double>::const_iterator old = baseline.find(r.name);
+        if (old != baseline.end() && old->second > 0.0)
+        {
+            const double change = r.stats.median / old->second - 1.0;
+            const bool regression = change > opts.threshold && r.stats.ci95_low > old->second;
+
+            printf(" %+7.1f%%%s", 100.0 * change, regression ? " REGRESSION" : "");
+
+            if (regression)
+                regressions++;
+        }
+
+        printf("\n");
+        fflush(stdout);
+    }
+
+    if (!opts.json.empty())
+    {
+        std::ofstream file(opts.json.c_str());
+
+        file << "{\n\"context\": " << device_context_json(opts.device) << ",\n\"benchmarks\": [\n";
+        for (size_t i = 0; i < results.size(); i++)
+        {
+            write_json(file, results[i]);
+            file << (i + 1 < results.size() ? ",\n" : "\n");
+        }
+        file << "]\n}\n";
+    }
+
+    if (!baseline.empty())
+        printf("\n%d regression(s) beyond %.1f%% against %s\n", regressions, 100.0 * opts.threshold, opts.baseline.c_str());
+
+    return regressions > 0 ? 2 : 0;
+}
+
+} // end namespace benchmark
@@ -0,0 +1,412 @@
+#include "benchmark.h"
+
+#include <cusp/array1d.h>
+#include <cusp/blas.h>
+#include <cusp/convert.h>
+#include <cusp/coo_matrix.h>
+#include <cusp/csr_matrix.h>
+#include <cusp/dia_matrix.h>
+#include <cusp/ell_matrix.h>
+#include <cusp/hyb_matrix.h>
+#include <cusp/sell_matrix.h>
+#include <cusp/monitor.h>
+#include <cusp/multiply.h>
+#include <cusp/gallery/poisson.h>
+#include <cusp/io/matrix_market.h>
+#include <cusp/krylov/cg.h>
+#include <cusp/precond/aggregation/smoothed_aggregation.h>
+
+#include <cusp/detail/work_estimate.h>
+
+#include <cusp/detail/device/spmv/coo_flat.h>
+#include <cusp/detail/device/spmv/csr_scalar.h>
+#include <cusp/detail/device/spmv/csr_vector.h>
+#include <cusp/detail/device/spmv/csr_merge.h>
+#include <cusp/detail/device/spmv/csr_adaptive.h>
+#include <cusp/detail/device/spmv/dia.h>
+#include <cusp/detail/device/spmv/ell.h>
+#include <cusp/detail/device/spmv/hyb.h>
+#include <cusp/detail/device/spmv/sell.h>
+
+// The benchmarks of the cusp entry points, run on one input matrix: the
+// file given with --matrix or a 2D Poisson problem on a 512x512 grid.
+// See benchmark.h for the options and the report.
+
+typedef int                 IndexType;
+typedef float               ValueType;
+typedef cusp::device_memory MemorySpace;
+
+typedef cusp::csr_matrix<IndexType, ValueType, cusp::host_memory> HostMatrix;
+typedef cusp::csr_matrix<IndexType, ValueType, MemorySpace>       DeviceMatrix;
+typedef cusp::array1d<ValueType, MemorySpace>                     DeviceArray;
+
+const HostMatrix& input_matrix(void)
+{
+    static HostMatrix A;
+    static bool loaded = false;
+
+    if (!loaded)
+    {
+        const std::string& filename = benchmark::current_options().matrix;
+
+        if (filename.empty())
+            cusp::gallery::poisson5pt(A, 512, 512);
+        else
+            cusp::io::read_matrix_market_file(A, filename);
+
+        loaded = true;
+    }
+
+    return A;
+}
+
+std::string matrix_label(void)
+{
+    const HostMatrix& A = input_matrix();
+
+    std::ostringstream label;
+    label << A.num_rows << "x" << A.num_cols << " nnz=" << A.num_entries;
+    return label.str();
+}
+
+//////////
+// SpMV //
+//////////
+
+// y = A * x through cusp::multiply in the format of Matrix
+template <typename Matrix>
+void spmv(benchmark::state& state)
+{
+    Matrix A;
+
+    try
+    {
+        A = input_matrix();
+    }
+    catch (cusp::format_conversion_exception)
+    {
+        state.skip("matrix not representable in this format");
+        return;
+    }
+
+    DeviceArray x(A.num_cols, 1);
+    DeviceArray y(A.num_rows, 0);
+
+    state.set_label(matrix_label());
+    state.set_work(cusp::detail::spmv_bytes(A, typename Matrix::format()),
+                   cusp::detail::spmv_flops(A, typename Matrix::format()));
+
+    while (state.keep_running())
+        cusp::multiply(A, x, y);
+}
+
+BENCHMARK_NAMED((spmv< cusp::coo_matrix <IndexType, ValueType, MemorySpace> >), "spmv/coo");
+BENCHMARK_NAMED((spmv< cusp::csr_matrix <IndexType, ValueType, MemorySpace> >), "spmv/csr");
+BENCHMARK_NAMED((spmv< cusp::dia_matrix <IndexType, ValueType, MemorySpace> >), "spmv/dia");
+BENCHMARK_NAMED((spmv< cusp::ell_matrix <IndexType, ValueType, MemorySpace> >), "spmv/ell");
+BENCHMARK_NAMED((spmv< cusp::hyb_matrix <IndexType, ValueType, MemorySpace> >), "spmv/hyb");
+BENCHMARK_NAMED((spmv< cusp::sell_matrix<IndexType, ValueType, MemorySpace> >), "spmv/sell");
+
+// y = A * x through one device kernel, bypassing the dispatch
+template <typename Matrix, void (*Kernel)(const Matrix&, const ValueType*, ValueType*)>
+void spmv_kernel(benchmark::state& state)
+{
+    Matrix A;
+
+    try
+    {
+        A = input_matrix();
+    }
+    catch (cusp::format_conversion_exception)
+    {
+        state.skip("matrix not representable in this format");
+        return;
+    }
+
+    DeviceArray x(A.num_cols, 1);
+    DeviceArray y(A.num_rows, 0);
+
+    state.set_label(matrix_label());
+    state.set_work(cusp::detail::spmv_bytes(A, typename Matrix::format()),
+                   cusp::detail::spmv_flops(A, typename Matrix::format()));
+
+    while (state.keep_running())
+        Kernel(A, thrust::raw_pointer_cast(&x[0]), thrust::raw_pointer_cast(&y[0]));
+}
+
+typedef cusp::coo_matrix <IndexType, ValueType, MemorySpace> DeviceCoo;
+typedef cusp::dia_matrix <IndexType, ValueType, MemorySpace> DeviceDia;
+typedef cusp::ell_matrix <IndexType, ValueType, MemorySpace> DeviceEll;
+typedef cusp::hyb_matrix <IndexType, ValueType, MemorySpace> DeviceHyb;
+typedef cusp::sell_matrix<IndexType, ValueType, MemorySpace> DeviceSell;
+
+using namespace cusp::detail::device;
+
+BENCHMARK_NAMED((spmv_kernel<DeviceCoo,    spmv_coo_flat          <DeviceCoo,    ValueType> >), "spmv_kernel/coo_flat");
+BENCHMARK_NAMED((spmv_kernel<DeviceCoo,    spmv_coo_flat_tex      <DeviceCoo,    ValueType> >), "spmv_kernel/coo_flat_tex");
+BENCHMARK_NAMED((spmv_kernel<DeviceMatrix, spmv_csr_scalar        <DeviceMatrix, ValueType> >), "spmv_kernel/csr_scalar");
+BENCHMARK_NAMED((spmv_kernel<DeviceMatrix, spmv_csr_scalar_tex    <DeviceMatrix, ValueType> >), "spmv_kernel/csr_scalar_tex");
+BENCHMARK_NAMED((spmv_kernel<DeviceMatrix, spmv_csr_vector        <DeviceMatrix, ValueType> >), "spmv_kernel/csr_vector");
+BENCHMARK_NAMED((spmv_kernel<DeviceMatrix, spmv_csr_vector_tex    <DeviceMatrix, ValueType> >), "spmv_kernel/csr_vector_tex");
+BENCHMARK_NAMED((spmv_kernel<DeviceMatrix, spmv_csr_merge         <DeviceMatrix, ValueType> >), "spmv_kernel/csr_merge");
+BENCHMARK_NAMED((spmv_kernel<DeviceMatrix, spmv_csr_merge_tex     <DeviceMatrix, ValueType> >), "spmv_kernel/csr_merge_tex");
+BENCHMARK_NAMED((spmv_kernel<DeviceDia,    spmv_dia               <DeviceDia,    ValueType> >), "spmv_kernel/dia");
+BENCHMARK_NAMED((spmv_kernel<DeviceDia,    spmv_dia_tex           <DeviceDia,    ValueType> >), "spmv_kernel/dia_tex");
+BENCHMARK_NAMED((spmv_kernel<DeviceEll,    spmv_ell               <DeviceEll,    ValueType> >), "spmv_kernel/ell");
+BENCHMARK_NAMED((spmv_kernel<DeviceEll,    spmv_ell_tex           <DeviceEll,    ValueType> >), "spmv_kernel/ell_tex");
+BENCHMARK_NAMED((spmv_kernel<DeviceHyb,    spmv_hyb               <DeviceHyb,    ValueType> >), "spmv_kernel/hyb");
+BENCHMARK_NAMED((spmv_kernel<DeviceHyb,    spmv_hyb_tex           <DeviceHyb,    ValueType> >), "spmv_kernel/hyb_tex");
+BENCHMARK_NAMED((spmv_kernel<DeviceSell,   spmv_sell              <DeviceSell,   ValueType> >), "spmv_kernel/sell");
+BENCHMARK_NAMED((spmv_kernel<DeviceSell,   spmv_sell_tex          <DeviceSell,   ValueType> >), "spmv_kernel/sell_tex");
+
+// the adaptive CSR kernel takes the row binning computed once per pattern
+template <bool UseCache>
+void spmv_csr_adaptive_kernel(benchmark::state& state)
+{
+    DeviceMatrix A(input_matrix());
+
+    DeviceArray x(A.num_cols, 1);
+    DeviceArray y(A.num_rows, 0);
+
+    csr_adaptive_analysis<IndexType> analysis;
+    analyze_csr_adaptive(A, analysis);
+
+    state.set_label(matrix_label());
+    state.set_work(cusp::detail::spmv_bytes(A, cusp::csr_format()),
+                   cusp::detail::spmv_flops(A, cusp::csr_format()));
+
+    while (state.keep_running())
+    {
+        if (UseCache)
+            spmv_csr_adaptive_tex(A, analysis, thrust::raw_pointer_cast(&x[0]), thrust::raw_pointer_cast(&y[0]));
+        else
+            spmv_csr_adaptive    (A, analysis, thrust::raw_pointer_cast(&x[0]), thrust::raw_pointer_cast(&y[0]));
+    }
+}
+
+BENCHMARK_NAMED(spmv_csr_adaptive_kernel<false>, "spmv_kernel/csr_adaptive");
+BENCHMARK_NAMED(spmv_csr_adaptive_kernel<true>,  "spmv_kernel/csr_adaptive_tex");
+
+////////////
+// SpGEMM //
+////////////
+
+// C = A * A
+template <typename Matrix>
+void spgemm(benchmark::state& state)
+{
+    Matrix A(input_matrix());
+    Matrix C;
+
+    cusp::multiply(A, A, C);
+
+    state.set_label(matrix_label());
+    state.set_work(2.0 * cusp::detail::storage_bytes(A) + cusp::detail::storage_bytes(C), 0.0);
+    state.set_counter("output_entries", C.num_entries);
+
+    while (state.keep_running())
+        cusp::multiply(A, A, C);
+}
+
+BENCHMARK_NAMED(spgemm<DeviceCoo>,    "spgemm/coo");
+BENCHMARK_NAMED(spgemm<DeviceMatrix>, "spgemm/csr");
+
+/////////////////
+// Conversions //
+/////////////////
+
+template <typename SourceMatrix, typename DestinationMatrix>
+void conversion(benchmark::state& state)
+{
+    SourceMatrix A(input_matrix());
+    DestinationMatrix B;
+
+    try
+    {
+        cusp::convert(A, B);
+    }
+    catch (cusp::format_conversion_exception)
+    {
+        state.skip("matrix not representable in the destination format");
+        return;
+    }
+
+    state.set_label(matrix_label());
+    state.set_work(cusp::detail::storage_bytes(A) + cusp::detail::storage_bytes(B), 0.0);
+
+    while (state.keep_running())
+        cusp::convert(A, B);
+}
+
+BENCHMARK_NAMED((conversion<DeviceMatrix, DeviceCoo >), "convert/csr_to_coo");
+BENCHMARK_NAMED((conversion<DeviceCoo,    DeviceMatrix>), "convert/coo_to_csr");
+BENCHMARK_NAMED((conversion<DeviceMatrix, DeviceDia >), "convert/csr_to_dia");
+BENCHMARK_NAMED((conversion<DeviceMatrix, DeviceEll >), "convert/csr_to_ell");
+BENCHMARK_NAMED((conversion<DeviceMatrix, DeviceHyb >), "convert/csr_to_hyb");
+BENCHMARK_NAMED((conversion<DeviceMatrix, DeviceSell>), "convert/csr_to_sell");
+BENCHMARK_NAMED((conversion<DeviceEll,    DeviceMatrix>), "convert/ell_to_csr");
+BENCHMARK_NAMED((conversion<DeviceHyb,    DeviceMatrix>), "convert/hyb_to_csr");
+
+////////////
+// BLAS-1 //
+////////////
+
+// vectors of one entry per row of the input matrix
+void blas_axpy(benchmark::state& state)
+{
+    DeviceArray x(input_matrix().num_rows, 1);
+    DeviceArray y(input_matrix().num_rows, 2);
+
+    state.set_work(cusp::detail::vector_bytes(x, 3), 2.0 * x.size());
+
+    while (state.keep_running())
+        cusp::blas::axpy(x, y, ValueType(0.5));
+}
+BENCHMARK_NAMED(blas_axpy, "blas/axpy");
+
+void blas_axpby(benchmark::state& state)
+{
+    DeviceArray x(input_matrix().num_rows, 1);
+    DeviceArray y(input_matrix().num_rows, 2);
+    DeviceArray z(input_matrix().num_rows);
+
+    state.set_work(cusp::detail::vector_bytes(x, 3), 3.0 * x.size());
+
+    while (state.keep_running())
+        cusp::blas::axpby(x, y, z, ValueType(0.5), ValueType(2));
+}
+BENCHMARK_NAMED(blas_axpby, "blas/axpby");
+
+void blas_copy(benchmark::state& state)
+{
+    DeviceArray x(input_matrix().num_rows, 1);
+    DeviceArray y(input_matrix().num_rows);
+
+    state.set_work(cusp::detail::vector_bytes(x, 2), 0.0);
+
+    while (state.keep_running())
+        cusp::blas::copy(x, y);
+}
+BENCHMARK_NAMED(blas_copy, "blas/copy");
+
+void blas_dot(benchmark::state& state)
+{
+    DeviceArray x(input_matrix().num_rows, 1);
+    DeviceArray y(input_matrix().num_rows, 2);
+
+    state.set_work(cusp::detail::vector_bytes(x, 2), 2.0 * x.size());
+
+    while (state.keep_running())
+        cusp::blas::dot(x, y);
+}
+BENCHMARK_NAMED(blas_dot, "blas/dot");
+
+void blas_nrm2(benchmark::state& state)
+{
+    DeviceArray x(input_matrix().num_rows, 1);
+
+    state.set_work(cusp::detail::vector_bytes(x, 1), 2.0 * x.size());
+
+    while (state.keep_running())
+        cusp::blas::nrm2(x);
+}
+BENCHMARK_NAMED(blas_nrm2, "blas/nrm2");
+
+void blas_scal(benchmark::state& state)
+{
+    DeviceArray x(input_matrix().num_rows, 1);
+
+    state.set_work(cusp::detail::vector_bytes(x, 2), 1.0 * x.size());
+
+    while (state.keep_running())
+        cusp::blas::scal(x, ValueType(1));
+}
+BENCHMARK_NAMED(blas_scal, "blas/scal");
+
+/////////////
+// Solvers //
+/////////////
+
+// one sample is a fixed number of CG iterations, reported per iteration
+template <typename Matrix>
+void cg_iterations(benchmark::state& state)
+{
+    const size_t iterations = 100;
+
+    Matrix A(input_matrix());
+
+    DeviceArray b(A.num_rows, 1);
+    DeviceArray x(A.num_rows);
+
+    state.set_label(matrix_label());
+    state.set_counter("iterations", iterations);
+
+    while (state.keep_running())
+    {
+        cusp::blas::fill(x, ValueType(0));
+
+        // a zero tolerance runs to the iteration limit
+        cusp::default_monitor<ValueType> monitor(b, iterations, 0);
+        cusp::krylov::cg(A, x, b, monitor);
+    }
+
+    // the median is per solve, report the work of one solve
+    state.set_work(iterations * (cusp::detail::spmv_bytes(A, typename Matrix::format()) + cusp::detail::vector_bytes(x, 10)),
+                   iterations * (cusp::detail::spmv_flops(A, typename Matrix::format()) + 10.0 * x.size()));
+}
+
+BENCHMARK_NAMED(cg_iterations<DeviceMatrix>, "krylov/cg_100_iterations/csr");
+BENCHMARK_NAMED(cg_iterations<DeviceHyb>,    "krylov/cg_100_iterations/hyb");
+
+/////////
+// AMG //
+/////////
+
+typedef cusp::precond::aggregation::smoothed_aggregation<IndexType, ValueType, MemorySpace> Preconditioner;
+
+void amg_setup(benchmark::state& state)
+{
+    DeviceHyb A(input_matrix());
+
+    state.set_label(matrix_label());
+
+    while (state.keep_running())
+    {
+        Preconditioner M(A);
+    }
+
+    Preconditioner M(A);
+    state.set_counter("levels", M.levels.size());
+}
+BENCHMARK_NAMED(amg_setup, "amg/setup");
+
+void amg_solve(benchmark::state& state)
+{
+    DeviceHyb A(input_matrix());
+    Preconditioner M(A);
+
+    DeviceArray b(A.num_rows, 1);
+    DeviceArray x(A.num_rows);
+
+    size_t iterations = 0;
+
+    state.set_label(matrix_label());
+
+    while (state.keep_running())
+    {
+        cusp::blas::fill(x, ValueType(0));
+
+        cusp::default_monitor<ValueType> monitor(b, 1000, 1e-6);
+        cusp::krylov::cg(A, x, b, monitor, M);
+
+        iterations = monitor.iteration_count();
+    }
+
+    state.set_counter("iterations", iterations);
+}
+BENCHMARK_NAMED(amg_solve, "amg/solve");
+
+int main(int argc, char ** argv)
+{
+    return benchmark::main(argc, argv);
+}
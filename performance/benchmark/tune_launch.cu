@@ -0,0 +1,256 @@
+#include "benchmark.h"
+
+#include <cusp/array1d.h>
+#include <cusp/convert.h>
+#include <cusp/csr_matrix.h>
+#include <cusp/ell_matrix.h>
+#include <cusp/io/matrix_market.h>
+
+#include <cusp/detail/device/launch_config.h>
+#include <cusp/detail/device/spmv/csr_vector.h>
+#include <cusp/detail/device/spmv/ell.h>
+
+// Offline tuning of the launch configurations of the SpMV kernels, see
+// cusp/detail/device/launch_config.h.
+//
+// For each kernel, value type and class of rows the program times the
+// candidate configurations (block size, threads per row for csr_vector,
+// cap on the blocks per multiprocessor) with the sampling of benchmark.h,
+// and writes the fastest one to the database when it beats the built-in
+// default by more than --threshold.  The entries of an existing database
+// for other devices are kept, so one file can collect several machines.
+//
+//   ./tune_launch --output=launch.db
+//   CUSP_LAUNCH_DATABASE=launch.db ./application
+//
+// The csr_vector classes are tuned on banded matrices with 2, 4, 8, 16 and
+// 32 entries per row unless --matrix gives the input.
+
+namespace arch = cusp::detail::device::arch;
+
+typedef int                                                    IndexType;
+typedef cusp::csr_matrix<IndexType, double, cusp::host_memory> HostMatrix;
+
+struct tuning_options
+{
+    std::string output;
+    size_t num_rows;
+
+    tuning_options(void) : output("launch.db"), num_rows(1 << 20) {}
+};
+
+// rows of nnz_per_row consecutive entries around the diagonal
+void banded_matrix(HostMatrix& A, size_t num_rows, size_t nnz_per_row)
+{
+    A.resize(num_rows, num_rows, num_rows * nnz_per_row);
+
+    for (size_t i = 0; i < num_rows; i++)
+    {
+        const size_t first = std::min(i - std::min(i, nnz_per_row / 2), num_rows - nnz_per_row);
+
+        A.row_offsets[i] = i * nnz_per_row;
+
+        for (size_t k = 0; k < nnz_per_row; k++)
+        {
+            A.column_indices[i * nnz_per_row + k] = first + k;
+            A.values[i * nnz_per_row + k]         = 1.0;
+        }
+    }
+
+    A.row_offsets[num_rows] = num_rows * nnz_per_row;
+}
+
+// the class of rows by which __spmv_csr_vector_select looks up csr_vector
+unsigned int csr_vector_class(size_t nnz_per_row)
+{
+    if (nnz_per_row <=  2) return  2;
+    if (nnz_per_row <=  4) return  4;
+    if (nnz_per_row <=  8) return  8;
+    if (nnz_per_row <= 16) return 16;
+    return 32;
+}
+
+std::vector<arch::launch_config> candidates(bool threads_per_vector)
+{
+    const unsigned int block_sizes[]   = {64, 128, 256, 512};
+    const unsigned int vector_sizes[]  = {2, 4, 8, 16, 32};
+    const unsigned int blocks_per_sm[] = {0, 2, 4, 8};
+
+    // the built-in default first, it is the reference
+    std::vector<arch::launch_config> configs(1, arch::launch_config());
+
+    for (size_t b = 0; b < 4; b++)
+        for (size_t v = 0; v < (threads_per_vector ? 5 : 1); v++)
+            for (size_t s = 0; s < 4; s++)
+                configs.push_back(arch::launch_config(block_sizes[b], threads_per_vector ? vector_sizes[v] : 0, blocks_per_sm[s]));
+
+    return configs;
+}
+
+// time every candidate of kernel on A and record the fastest in tuned
+template <typename Matrix, typename ValueType>
+void tune(const std::string& kernel,
+          void (*spmv)(const Matrix&, const ValueType*, ValueType*),
+          const Matrix& A,
+          const std::vector<arch::launch_config>& configs,
+          arch::launch_database& tuned)
+{
+    const benchmark::options& opts = benchmark::current_options();
+    const std::string& device_arch = arch::current_device_description().arch;
+
+    arch::launch_database& active = arch::current_launch_database();
+
+    cusp::array1d<ValueType, cusp::device_memory> x(A.num_cols, 1);
+    cusp::array1d<ValueType, cusp::device_memory> y(A.num_rows, 0);
+
+    double default_ms = 0.0;
+    double best_ms    = 0.0;
+    arch::launch_config best;
+
+    for (size_t i = 0; i < configs.size(); i++)
+    {
+        active.clear();
+        active.set(device_arch, kernel, sizeof(ValueType), configs[i]);
+
+        benchmark::state state(opts);
+        while (state.keep_running())
+            spmv(A, thrust::raw_pointer_cast(&x[0]), thrust::raw_pointer_cast(&y[0]));
+
+        const double ms = benchmark::compute_statistics(state.samples).median;
+
+        if (i == 0)
+            default_ms = ms;
+
+        if (i == 0 || ms < best_ms)
+        {
+            best_ms = ms;
+            best    = configs[i];
+        }
+    }
+
+    active.clear();
+
+    const bool improved = best_ms < default_ms * (1.0 - opts.threshold);
+
+    printf("%-20s %2lu bytes  block %3u  threads/row %2u  blocks/SM %u  %9.4f ms  default %9.4f ms  %+6.1f%%%s\n",
+           kernel.c_str(), (unsigned long) sizeof(ValueType), best.block_size, best.threads_per_vector, best.blocks_per_sm,
+           best_ms, default_ms, 100.0 * (best_ms / default_ms - 1.0), improved ? "" : "  (default kept)");
+    fflush(stdout);
+
+    // an entry of zeros replaces a stale one and keeps the default
+    tuned.set(device_arch, kernel, sizeof(ValueType), improved ? best : arch::launch_config());
+}
+
+template <typename ValueType>
+void tune_csr_vector(const HostMatrix& H, arch::launch_database& tuned)
+{
+    typedef cusp::csr_matrix<IndexType, ValueType, cusp::device_memory> Matrix;
+
+    const Matrix A(H);
+    const unsigned int row_class = csr_vector_class(A.num_entries / A.num_rows);
+
+    tune(cusp::detail::device::csr_vector_launch_name(false, row_class),
+         cusp::detail::device::spmv_csr_vector<Matrix, ValueType>, A, candidates(true), tuned);
+    tune(cusp::detail::device::csr_vector_launch_name(true, row_class),
+         cusp::detail::device::spmv_csr_vector_tex<Matrix, ValueType>, A, candidates(true), tuned);
+}
+
+template <typename ValueType>
+void tune_ell(const HostMatrix& H, arch::launch_database& tuned)
+{
+    typedef cusp::ell_matrix<IndexType, ValueType, cusp::device_memory> Matrix;
+
+    Matrix A;
+
+    try
+    {
+        cusp::convert(H, A);
+    }
+    catch (cusp::format_conversion_exception)
+    {
+        printf("%-20s skipped (matrix not representable in ELL)\n", "ell");
+        return;
+    }
+
+    tune("ell",     cusp::detail::device::spmv_ell    <Matrix, ValueType>, A, candidates(false), tuned);
+    tune("ell_tex", cusp::detail::device::spmv_ell_tex<Matrix, ValueType>, A, candidates(false), tuned);
+}
+
+template <typename ValueType>
+void tune_all(const tuning_options& tuning, arch::launch_database& tuned)
+{
+    const std::string& filename = benchmark::current_options().matrix;
+
+    if (!filename.empty())
+    {
+        HostMatrix H;
+        cusp::io::read_matrix_market_file(H, filename);
+
+        tune_csr_vector<ValueType>(H, tuned);
+        tune_ell<ValueType>(H, tuned);
+        return;
+    }
+
+    const size_t row_lengths[] = {2, 4, 8, 16, 32};
+
+    for (size_t i = 0; i < 5; i++)
+    {
+        HostMatrix H;
+        banded_matrix(H, tuning.num_rows, row_lengths[i]);
+
+        tune_csr_vector<ValueType>(H, tuned);
+
+        if (row_lengths[i] == 8)
+            tune_ell<ValueType>(H, tuned);
+    }
+}
+
+int main(int argc, char ** argv)
+{
+    benchmark::options& opts = benchmark::current_options();
+    tuning_options tuning;
+
+    // each configuration is one sample set, fewer samples keep the sweep short
+    opts.repetitions   = 7;
+    opts.min_sample_ms = 5.0;
+
+    std::vector<char *> harness_args(1, argv[0]);
+
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string arg(argv[i]);
+        std::string value;
+
+        if      (benchmark::parse_option(arg, "output", value)) tuning.output   = value;
+        else if (benchmark::parse_option(arg, "rows", value))   tuning.num_rows = atoi(value.c_str());
+        else    harness_args.push_back(argv[i]);
+    }
+
+    if (!benchmark::parse_arguments(int(harness_args.size()), &harness_args[0]))
+    {
+        std::cout << "  --output=<file>       launch database to write (default launch.db)\n"
+                  << "  --rows=<n>            rows of the generated matrices (default 1048576)\n";
+        return 1;
+    }
+
+    cudaSetDevice(opts.device);
+
+    benchmark::clock_lock lock(opts.device, opts.lock_clocks);
+
+    // keep the entries of the other devices
+    arch::launch_database tuned;
+    if (std::ifstream(tuning.output.c_str()))
+        tuned.load(tuning.output.c_str());
+
+    printf("tuning %s\n", arch::current_device_description().arch.c_str());
+
+    tune_all<float>(tuning, tuned);
+    tune_all<double>(tuning, tuned);
+
+    std::ofstream file(tuning.output.c_str());
+    tuned.write(file);
+
+    printf("wrote %s\n", tuning.output.c_str());
+
+    return 0;
+}
@@ -1,5 +1,3 @@
-#define CUSP_USE_TEXTURE_MEMORY
-
 #include <cusp/dia_matrix.h>
 #include <cusp/csr_matrix.h>
 #include <cusp/io/matrix_market.h>
@@ -24,18 +22,16 @@ void perform_spmv(const cusp::csr_matrix<IndexType,ValueType,cusp::device_memory
     const unsigned int MAX_BLOCKS = 16 * 1024;
     const unsigned int NUM_BLOCKS = std::min(MAX_BLOCKS, static_cast<unsigned int>((csr.num_rows + (VECTORS_PER_BLOCK - 1)) / VECTORS_PER_BLOCK));
     
-    if (UseCache)
-        bind_x(x);
+    const cusp::detail::device::cached_x<ValueType> x_cached = cusp::detail::device::bind_x<UseCache>(x, csr.num_cols);
 
-    cusp::detail::device::spmv_csr_vector_kernel<IndexType, ValueType, VECTORS_PER_BLOCK, THREADS_PER_VECTOR, UseCache> <<<NUM_BLOCKS, THREADS_PER_BLOCK>>> 
+    cusp::detail::device::spmv_csr_vector_kernel<cusp::detail::device::arch::sm35_policy, IndexType, ValueType, ValueType, VECTORS_PER_BLOCK, THREADS_PER_VECTOR, UseCache, cusp::detail::plain_accumulation> <<<NUM_BLOCKS, THREADS_PER_BLOCK>>> 
         (csr.num_rows,
          thrust::raw_pointer_cast(&csr.row_offsets[0]),
          thrust::raw_pointer_cast(&csr.column_indices[0]),
          thrust::raw_pointer_cast(&csr.values[0]),
-         x, y);
+         x_cached, y);
 
-    if (UseCache)
-        unbind_x(x);
+    cusp::detail::device::unbind_x(x_cached);
 }
  
 template <unsigned int ThreadsPerVector, typename IndexType, typename ValueType>
@@ -32,6 +32,18 @@ void MaxFlow(const MatrixType& G)
         size_t min_cut_size = cusp::graph::max_flow_to_min_cut(G_flow, flow, source, min_cut_edges);
         std::cout << "\tMin-Cut time : " << t.milliseconds_elapsed() << " (ms), found " << min_cut_size << " edge cuts." << std::endl;
     }
+
+    {
+        timer t;
+        ValueType capacity = cusp::graph::maximum_preflow(G_flow, flow, source, sink);
+        std::cout << "\tMax-Preflow time : " << t.milliseconds_elapsed() << " (ms), with capacity : " << capacity << std::endl;
+    }
+
+    {
+        timer t;
+        size_t min_cut_size = cusp::graph::max_flow_to_min_cut(G_flow, flow, source, sink, min_cut_edges);
+        std::cout << "\tMin-Cut from preflow time : " << t.milliseconds_elapsed() << " (ms), found " << min_cut_size << " edge cuts." << std::endl;
+    }
 }
 
 int main(int argc, char*argv[])
@@ -1,7 +1,19 @@
+// count the allocations of the cusp containers per call path
+#define CUSP_TRACK_MEMORY
+
 #include <cuda.h>
 #include <thrust/device_vector.h>
 #include "../timer.h"
 
+#include <cusp/array1d.h>
+#include <cusp/coo_matrix.h>
+#include <cusp/device_cache.h>
+#include <cusp/csr_matrix.h>
+#include <cusp/hyb_matrix.h>
+#include <cusp/multiply.h>
+#include <cusp/gallery/poisson.h>
+#include <cusp/precond/aggregation/smoothed_aggregation.h>
+
 #include <iostream>
 #include <iomanip>
 
@@ -67,6 +79,87 @@ void benchmark(TestFunction f, size_t max_n = (size_t) 1 << 30, size_t num_itera
 }
 
 
+struct cusp_array1d
+{
+    void operator()(size_t n)
+    {
+        cusp::array1d<char, cusp::device_memory> v(n);
+    }
+};
+
+struct cusp_array1d_uncached
+{
+    void operator()(size_t n)
+    {
+        cusp::device_cache_scope scope(false);
+        cusp::array1d<char, cusp::device_memory> v(n);
+    }
+};
+
+// allocations of the device containers during common cusp operations:
+// the time of each operation, the number and size of its allocations and
+// the peak of device memory per call path
+template <typename Operation>
+void allocation_pattern(const char * name, Operation op)
+{
+    namespace tracker = cusp::detail::memory_tracker;
+
+    tracker::reset();
+    const size_t before = tracker::current_bytes();
+
+    timer t;
+    {
+        tracker::scoped region(name);
+        op();
+    }
+    float ms = t.milliseconds_elapsed();
+
+    const tracker::call_path * path = tracker::state().root.child(name);
+
+    std::cout << name << ": " << std::setiosflags(std::ios::fixed) << std::setprecision(3) << ms << " ms, "
+              << path->allocations << " allocations in the region itself, peak "
+              << tracker::megabytes(path->peak_growth) << " MB above "
+              << tracker::megabytes(before) << " MB" << std::endl;
+    CUSP_MEMORY_DUMP();
+}
+
+struct smoothed_aggregation_setup
+{
+    const cusp::csr_matrix<int, float, cusp::device_memory>& A;
+
+    smoothed_aggregation_setup(const cusp::csr_matrix<int, float, cusp::device_memory>& A) : A(A) {}
+
+    void operator()(void)
+    {
+        cusp::precond::aggregation::smoothed_aggregation<int, float, cusp::device_memory> M(A);
+    }
+};
+
+struct coo_spgemm
+{
+    const cusp::coo_matrix<int, float, cusp::device_memory>& A;
+
+    coo_spgemm(const cusp::coo_matrix<int, float, cusp::device_memory>& A) : A(A) {}
+
+    void operator()(void)
+    {
+        cusp::coo_matrix<int, float, cusp::device_memory> C;
+        cusp::multiply(A, A, C);
+    }
+};
+
+struct csr_to_hyb
+{
+    const cusp::csr_matrix<int, float, cusp::device_memory>& A;
+
+    csr_to_hyb(const cusp::csr_matrix<int, float, cusp::device_memory>& A) : A(A) {}
+
+    void operator()(void)
+    {
+        cusp::hyb_matrix<int, float, cusp::device_memory> B(A);
+    }
+};
+
 int main(void)
 {
     std::cout << "malloc() & free()" << std::endl;
@@ -81,6 +174,21 @@ int main(void)
     std::cout << "thrust::device_vector" << std::endl;
     benchmark(thrust_device_vector());
 
+    std::cout << "cusp::array1d (device cache)" << std::endl;
+    benchmark(cusp_array1d());
+
+    std::cout << "cusp::array1d (device cache disabled)" << std::endl;
+    benchmark(cusp_array1d_uncached());
+
+    cusp::csr_matrix<int, float, cusp::device_memory> A;
+    cusp::gallery::poisson5pt(A, 1000, 1000);
+    cusp::coo_matrix<int, float, cusp::device_memory> A_coo(A);
+
+    std::cout << std::endl;
+    allocation_pattern("smoothed_aggregation setup", smoothed_aggregation_setup(A));
+    allocation_pattern("coo SpGEMM A * A", coo_spgemm(A_coo));
+    allocation_pattern("csr to hyb conversion", csr_to_hyb(A));
+
     return 0;
 }
 
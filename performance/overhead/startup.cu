@@ -0,0 +1,96 @@
+// time the start-up of a short solve: context creation, first SpMV and
+// first CG solve, with and without cusp::initialize
+//
+//   ./startup            lazy module loading, warm-up through cusp::initialize
+//   ./startup --eager    load every module when the context is created
+//   ./startup --cold     no cusp::initialize, the first solve pays everything
+//
+// Each configuration must run in its own process since the context is only
+// created once.
+
+#include <cusp/initialize.h>
+#include <cusp/array1d.h>
+#include <cusp/csr_matrix.h>
+#include <cusp/monitor.h>
+#include <cusp/multiply.h>
+#include <cusp/gallery/poisson.h>
+#include <cusp/krylov/cg.h>
+
+#include <sys/time.h>
+
+#include <stdio.h>
+#include <string.h>
+
+typedef cusp::csr_matrix<int, float, cusp::device_memory> DeviceMatrix;
+
+double wall_clock_ms(void)
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return 1.0e3 * tv.tv_sec + 1.0e-3 * tv.tv_usec;
+}
+
+int main(int argc, char ** argv)
+{
+    bool eager = false;
+    bool cold  = false;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if      (strcmp(argv[i], "--eager") == 0) eager = true;
+        else if (strcmp(argv[i], "--cold")  == 0) cold  = true;
+        else
+        {
+            printf("usage: %s [--eager] [--cold]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    const double start = wall_clock_ms();
+    double last = start;
+
+    if (!cold)
+    {
+        cusp::initialize(-1, !eager);
+        printf("%-24s %10.2f ms\n", "initialize", wall_clock_ms() - last);
+        last = wall_clock_ms();
+
+        cusp::initialize_spmv<DeviceMatrix>();
+        printf("%-24s %10.2f ms\n", "initialize_spmv", wall_clock_ms() - last);
+        last = wall_clock_ms();
+    }
+
+    cusp::csr_matrix<int, float, cusp::host_memory> H;
+    cusp::gallery::poisson5pt(H, 256, 256);
+
+    DeviceMatrix A(H);
+    cusp::array1d<float, cusp::device_memory> x(A.num_rows, 0);
+    cusp::array1d<float, cusp::device_memory> b(A.num_rows, 1);
+    cudaDeviceSynchronize();
+
+    printf("%-24s %10.2f ms\n", "setup", wall_clock_ms() - last);
+    last = wall_clock_ms();
+
+    cusp::multiply(A, b, x);
+    cudaDeviceSynchronize();
+
+    printf("%-24s %10.2f ms\n", "first spmv", wall_clock_ms() - last);
+    last = wall_clock_ms();
+
+    cusp::multiply(A, b, x);
+    cudaDeviceSynchronize();
+
+    printf("%-24s %10.2f ms\n", "second spmv", wall_clock_ms() - last);
+    last = wall_clock_ms();
+
+    cusp::blas::fill(x, 0.0f);
+    cusp::default_monitor<float> monitor(b, 100, 1e-6);
+    cusp::krylov::cg(A, x, b, monitor);
+    cudaDeviceSynchronize();
+
+    printf("%-24s %10.2f ms (%d iterations)\n", "first cg", wall_clock_ms() - last, (int) monitor.iteration_count());
+
+    printf("%-24s %10.2f ms\n", "total", wall_clock_ms() - start);
+
+    return 0;
+}
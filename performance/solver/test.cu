@@ -1,14 +1,16 @@
-#define CUSP_USE_TEXTURE_MEMORY
-
 #include <cusp/csr_matrix.h>
 #include <cusp/hyb_matrix.h>
 #include <cusp/gallery/poisson.h>
 #include <cusp/io/matrix_market.h>
 #include <cusp/krylov/cg.h>
+#include <cusp/multiply.h>
+
+#include <cusp/detail/work_estimate.h>
 
 #include <iostream>
 
 #include "../timer.h"
+#include "../benchmark/benchmark.h"
  
 template <typename Matrix>
 void benchmark_matrix(const Matrix& A)
@@ -23,8 +25,16 @@ void benchmark_matrix(const Matrix& A)
 
     cusp::default_monitor<ValueType> monitor(b, 2000, 1e-5);
 
+    // the energy of the board only means something for the device solve
+    // (requires -DCUSP_BENCHMARK_NVML)
+    static benchmark::energy_meter meter(0);
+    const bool measure_energy = meter.available() &&
+        thrust::detail::is_same<MemorySpace, cusp::device_memory>::value;
+
     // time solver
     timer t;
+    if (measure_energy)
+        meter.start();
 
     cusp::krylov::cg(A, x, b, monitor);
 
@@ -32,6 +42,8 @@ void benchmark_matrix(const Matrix& A)
 
     cudaThreadSynchronize();
 
+    const double joules = measure_energy ? meter.stop() : 0.0;
+
     if (monitor.converged())
         std::cout << "  Successfully converged";
     else
@@ -39,6 +51,29 @@ void benchmark_matrix(const Matrix& A)
     std::cout << " after " << monitor.iteration_count() << " iterations." << std::endl;
 
     std::cout << "  Solver time " << time << " seconds (" << (1e3 * time / monitor.iteration_count()) << "ms per iteration)" << std::endl;
+
+    if (measure_energy)
+        std::cout << "  Solver energy " << joules << " joules (" << (1e3 * joules / monitor.iteration_count()) << "mJ per iteration)" << std::endl;
+
+    // one SpMV, the bulk of a CG iteration on sparse matrices
+    if (measure_energy)
+    {
+        const int repetitions = 100;
+
+        cudaThreadSynchronize();
+
+        timer t_spmv;
+        meter.start();
+        for (int i = 0; i < repetitions; i++)
+            cusp::multiply(A, x, b);
+        float spmv_ms = t_spmv.milliseconds_elapsed();
+        const double spmv_joules = meter.stop() / repetitions;
+
+        const double bytes = cusp::detail::storage_bytes(A) + 2.0 * N * sizeof(ValueType);
+
+        std::cout << "  SpMV " << (spmv_ms / repetitions) << " ms, " << (bytes * repetitions / (spmv_ms * 1e6)) << " GB/s, "
+                  << (1e3 * spmv_joules) << " mJ" << std::endl;
+    }
 }
 
 
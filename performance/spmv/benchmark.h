@@ -5,6 +5,7 @@
 #include <stdio.h>
 
 #include "bytes_per_spmv.h"
+#include "roofline.h"
 
 #include "../timer.h"
 #include <cusp/detail/device/spmv/coo_flat_k.h>
@@ -119,7 +120,19 @@ void test_spmv(std::string         kernel_name,
 
     //record results to file
     FILE * fid = fopen(BENCHMARK_OUTPUT_FILE_NAME, "a");
-    fprintf(fid, "kernel=%s gflops=%f gbytes=%f msec=%f\n", kernel_name.c_str(), GFLOPs, GBYTEs, 1e3 * time);
+    fprintf(fid, "kernel=%s gflops=%f gbytes=%f msec=%f", kernel_name.c_str(), GFLOPs, GBYTEs, 1e3 * time);
+
+    if (PEAK_GBYTES_PER_SECOND > 0)
+    {
+        roofline_result roofline = spmv_roofline(test_matrix_on_host, time);
+
+        printf("\t%-20s  %5.1f%% of peak (%5.1f GB/s lower bound) x reuse %5.2f\n", "", 100.0 * roofline.peak_fraction,
+               (time == 0) ? 0 : (roofline.lower_bound_bytes / time) / 1e9, roofline.x_reuse);
+
+        fprintf(fid, " peak_fraction=%f x_reuse=%f", roofline.peak_fraction, roofline.x_reuse);
+    }
+
+    fprintf(fid, "\n");
     fclose(fid);
 }
 
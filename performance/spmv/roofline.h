@@ -0,0 +1,125 @@
+#pragma once
+
+// Roofline view of the SpMV kernels (--roofline)
+//
+// SpMV does O(1) flops per byte, so its roof is the memory bandwidth.  The
+// peak is measured once with a STREAM-like copy kernel, and every kernel
+// is compared with the time this peak needs for the compulsory traffic:
+// the matrix in its format (padding included) plus one read of x and one
+// write of y.  A kernel close to this bound cannot get faster without a
+// smaller format; a kernel far from it is limited by the kernel itself
+// (imbalance, latency, uncoalesced or repeated loads of x).
+//
+// The x-reuse factor estimates how many accesses to x each byte of x
+// traffic served, assuming the kernel streams at the measured peak:
+//
+//   x_traffic = peak * time - (matrix + y bytes),  at least the size of x
+//   x_reuse   = (bytes of x read per nonzero) / x_traffic
+//
+// A value of 1 means every access to x went to memory; the maximum is
+// nonzeros / columns, when x is read exactly once.  Kernels well below
+// the roof underestimate their reuse, so the factor is most meaningful for
+// the memory-bound kernels.
+
+#include <cusp/detail/work_estimate.h>
+
+#include <thrust/device_vector.h>
+
+#include <algorithm>
+
+#include "../timer.h"
+
+// measured copy bandwidth in GB/s, zero when --roofline is not requested
+double PEAK_GBYTES_PER_SECOND = 0.0;
+
+template <typename ValueType>
+__global__ void
+stream_copy_kernel(const size_t N, const ValueType * source, ValueType * destination)
+{
+    const size_t grid_size = gridDim.x * blockDim.x;
+
+    for (size_t i = blockIdx.x * blockDim.x + threadIdx.x; i < N; i += grid_size)
+        destination[i] = source[i];
+}
+
+// best of several copies of an array well beyond the size of the L2 cache
+inline double measure_peak_bandwidth(size_t trials = 20)
+{
+    int device = 0;
+    cudaDeviceProp properties;
+    cudaGetDevice(&device);
+    cudaGetDeviceProperties(&properties, device);
+
+    const size_t N = std::min<size_t>(properties.totalGlobalMem / 8, size_t(256) << 20) / sizeof(float);
+    const unsigned int BLOCK_SIZE = 256;
+    const unsigned int NUM_BLOCKS = 8 * properties.multiProcessorCount * (properties.maxThreadsPerMultiProcessor / BLOCK_SIZE);
+
+    thrust::device_vector<float> source(N, 1.0f);
+    thrust::device_vector<float> destination(N);
+
+    const float * src = thrust::raw_pointer_cast(&source[0]);
+          float * dst = thrust::raw_pointer_cast(&destination[0]);
+
+    // warmup
+    stream_copy_kernel<<<NUM_BLOCKS, BLOCK_SIZE>>>(N, src, dst);
+    cudaThreadSynchronize();
+
+    float best = 0.0f;
+
+    for (size_t i = 0; i < trials; i++)
+    {
+        timer t;
+        stream_copy_kernel<<<NUM_BLOCKS, BLOCK_SIZE>>>(N, src, dst);
+        const float ms = t.milliseconds_elapsed();
+
+        if (i == 0 || ms < best)
+            best = ms;
+    }
+
+    return (2.0 * N * sizeof(float)) / (best * 1.0e6);
+}
+
+// theoretical DRAM bandwidth in GB/s (double data rate)
+inline double theoretical_peak_bandwidth(void)
+{
+    int device = 0;
+    cudaDeviceProp properties;
+    cudaGetDevice(&device);
+    cudaGetDeviceProperties(&properties, device);
+
+    return 2.0 * properties.memoryClockRate * 1.0e3 * (properties.memoryBusWidth / 8) / 1.0e9;
+}
+
+struct roofline_result
+{
+    double lower_bound_bytes;   // matrix + one read of x + one write of y
+    double peak_fraction;       // time at peak for the lower bound / measured time
+    double x_reuse;             // accesses to x per byte of x traffic
+};
+
+template <typename HostMatrix>
+roofline_result spmv_roofline(const HostMatrix& matrix, double seconds)
+{
+    typedef typename HostMatrix::value_type ValueType;
+
+    const double matrix_bytes = cusp::detail::storage_bytes(matrix);
+    const double x_bytes      = double(matrix.num_cols) * sizeof(ValueType);
+    const double y_bytes      = double(matrix.num_rows) * sizeof(ValueType);
+    const double x_accesses   = double(matrix.num_entries) * sizeof(ValueType);
+
+    roofline_result result;
+    result.lower_bound_bytes = matrix_bytes + x_bytes + y_bytes;
+    result.peak_fraction     = 0.0;
+    result.x_reuse           = 0.0;
+
+    if (seconds > 0.0 && PEAK_GBYTES_PER_SECOND > 0.0)
+    {
+        const double peak_bytes = PEAK_GBYTES_PER_SECOND * 1.0e9 * seconds;
+        const double x_traffic  = std::max(peak_bytes - matrix_bytes - y_bytes, x_bytes);
+
+        result.peak_fraction = result.lower_bound_bytes / peak_bytes;
+        result.x_reuse       = x_traffic > 0.0 ? x_accesses / x_traffic : 0.0;
+    }
+
+    return result;
+}
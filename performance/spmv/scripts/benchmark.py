@@ -5,6 +5,7 @@ device_id = '0'  # index of the device to use
 
 binary_filename = '../spmv'                  # command used to run the tests
 output_file = 'benchmark_output.log'        # file where results are stored
+roofline = True                             # compare each kernel with the measured peak bandwidth
 
 
 # The unstructured matrices are available online:
@@ -53,6 +54,8 @@ def run_tests(value_type):
         cmd += ' ' + matrix_filename                  # e.g. pwtk.mtx
         cmd += ' --device=' + device_id               # e.g. 0 or 1
         cmd += ' --value_type=' + value_type          # e.g. float or double
+        if roofline:
+            cmd += ' --roofline'                      # peak fraction and x reuse
 
         # execute the benchmark on this file
         os.system(cmd)
@@ -83,14 +86,14 @@ def run_tests(value_type):
     def write_csv(field):
         fid = open('bench_' + value_type + '_' + field + '.csv','w')
         writer = csv.writer(fid)
-        writer.writerow(['matrix','file','rows','cols','nonzeros'] + kernels)
+        writer.writerow(['matrix','file','rows','cols','nonzeros','peak_gbytes'] + kernels)
         
         for (matrix,file,path) in trials:
-            line = [matrix, file, matrices[file]['rows'], matrices[file]['cols'], matrices[file]['nonzeros']]
+            line = [matrix, file, matrices[file]['rows'], matrices[file]['cols'], matrices[file]['nonzeros'], matrices[file].get('peak_gbytes',' ')]
         
             matrix_results = results[file]
             for kernel in kernels:
-                if kernel in matrix_results:
+                if kernel in matrix_results and field in matrix_results[kernel]:
                     line.append( matrix_results[kernel][field] )
                 else:
                     line.append(' ')
@@ -100,6 +103,10 @@ def run_tests(value_type):
     write_csv('gflops') #GFLOP/s
     write_csv('gbytes') #GBytes/s
 
+    if roofline:
+        write_csv('peak_fraction') # lower bound traffic at peak bandwidth / measured time
+        write_csv('x_reuse')       # accesses to x per byte of x traffic
+
 
 run_tests('float')
 run_tests('double')
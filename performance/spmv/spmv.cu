@@ -1,8 +1,10 @@
-#define CUSP_USE_TEXTURE_MEMORY
-
 #include <cusp/csr_matrix.h>
 #include <cusp/io/matrix_market.h>
 #include <cusp/gallery/poisson.h>
+#include <cusp/gallery/rmat.h>
+#include <cusp/gallery/banded.h>
+#include <cusp/gallery/block.h>
+#include <cusp/gallery/row_lengths.h>
 
 #include <iostream>
 #include <string>
@@ -52,9 +54,13 @@ void usage(int argc, char** argv)
     std::cout << "\t" << argv[0] << "\n";
     std::cout << "\t" << argv[0] << " my_matrix.mtx\n";
     std::cout << "\t" << argv[0] << " my_matrix.mtx --device=1\n";
-    std::cout << "\t" << argv[0] << " my_matrix.mtx --value_type=double\n\n";
+    std::cout << "\t" << argv[0] << " my_matrix.mtx --value_type=double\n";
+    std::cout << "\t" << argv[0] << " my_matrix.mtx --roofline\n";
+    std::cout << "\t" << argv[0] << " --gallery=rmat --seed=3\n\n";
     std::cout << "Note: my_matrix.mtx must be real-valued sparse matrix in the MatrixMarket file format.\n"; 
     std::cout << "      If no matrix file is provided then a simple example is created.\n";
+    std::cout << "      --roofline compares each kernel with the measured copy bandwidth of the device.\n";
+    std::cout << "      --gallery generates a poisson5pt, rmat, banded, block or skewed matrix instead.\n";
 }
 
 
@@ -66,14 +72,44 @@ void test_all_formats(std::string& filename)
     list_devices();
 
     std::cout << "Running on Device " << device_id << "\n\n";
+
+    if (args.count("roofline"))
+    {
+        PEAK_GBYTES_PER_SECOND = measure_peak_bandwidth();
+        std::cout << "Measured copy bandwidth " << PEAK_GBYTES_PER_SECOND << " GB/s"
+                  << " (theoretical " << theoretical_peak_bandwidth() << " GB/s)\n\n";
+    }
     
     // load a matrix stored in MatrixMarket format
     cusp::csr_matrix<IndexType, ValueType, cusp::host_memory> host_matrix;
 
     if (filename == "")
     {
-        std::cout << "Generated matrix (poisson5pt) ";
-        cusp::gallery::poisson5pt(host_matrix, 512, 512);
+        std::string gallery = args.count("gallery") ? args["gallery"] : "poisson5pt";
+        size_t      seed    = args.count("seed")    ? atoi(args["seed"].c_str()) : 0;
+
+        if (gallery == "rmat")
+            cusp::gallery::rmat(host_matrix, 18, 16, seed);
+        else if (gallery == "banded")
+            cusp::gallery::random_banded(host_matrix, 1 << 18, 16, seed);
+        else if (gallery == "block")
+            cusp::gallery::random_block(host_matrix, 1 << 16, 3, 12, seed);
+        else if (gallery == "skewed")
+        {
+            // mostly short rows with a few rows a thousand times longer
+            cusp::array1d<IndexType, cusp::host_memory> row_lengths(1 << 18);
+            for (size_t i = 0; i < row_lengths.size(); i++)
+                row_lengths[i] = i % 1024 == 0 ? 4096 : 4;
+            cusp::gallery::random_row_lengths(host_matrix, 1 << 18, row_lengths, seed);
+        }
+        else
+        {
+            gallery = "poisson5pt";
+            cusp::gallery::poisson5pt(host_matrix, 512, 512);
+        }
+
+        std::cout << "Generated matrix (" << gallery << ") ";
+        filename = gallery;
     }
     else
     {
@@ -85,7 +121,7 @@ void test_all_formats(std::string& filename)
               << host_matrix.num_entries << " entries" << "\n\n";
     
     FILE * fid = fopen(BENCHMARK_OUTPUT_FILE_NAME, "a");
-    fprintf(fid, "file=%s rows=%d cols=%d nonzeros=%d\n", filename.c_str(), (int) host_matrix.num_rows, (int) host_matrix.num_cols, (int) host_matrix.num_entries);
+    fprintf(fid, "file=%s rows=%d cols=%d nonzeros=%d peak_gbytes=%f\n", filename.c_str(), (int) host_matrix.num_rows, (int) host_matrix.num_cols, (int) host_matrix.num_entries, PEAK_GBYTES_PER_SECOND);
     fclose(fid);
     
     test_coo(host_matrix);
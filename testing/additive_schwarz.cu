@@ -0,0 +1,181 @@
+#include <unittest/unittest.h>
+
+#include <cusp/precond/additive_schwarz.h>
+#include <cusp/precond/block_jacobi.h>
+
+#include <cusp/gallery/poisson.h>
+#include <cusp/krylov/cg.h>
+#include <cusp/krylov/gmres.h>
+#include <cusp/monitor.h>
+
+// square tiles of tile x tile points of an n x n grid
+template <typename Array>
+void schwarz_tiles(Array& parts, const int n, const int tile)
+{
+    cusp::array1d<int,cusp::host_memory> h_parts(n * n);
+
+    for(int j = 0; j < n; j++)
+        for(int i = 0; i < n; i++)
+            h_parts[j * n + i] = (j / tile) * ((n + tile - 1) / tile) + i / tile;
+
+    parts = h_parts;
+}
+
+template <typename Matrix, typename Array, typename Preconditioner>
+size_t schwarz_cg_iterations(const Matrix& A, const Array& b, const Preconditioner& M)
+{
+    typedef typename Matrix::memory_space Space;
+
+    cusp::array1d<float,Space> x(A.num_rows, 0.0f);
+    cusp::default_monitor<float> monitor(b, 500, 1e-5);
+    cusp::krylov::cg(A, x, b, monitor, M);
+
+    ASSERT_EQUAL(monitor.converged(), true);
+
+    return monitor.iteration_count();
+}
+
+template <class Space>
+void TestAdditiveSchwarzSubdomains(void)
+{
+    // path graph 0 - 1 - ... - 5 split into two parts
+    cusp::csr_matrix<int,float,Space> A;
+    cusp::gallery::poisson5pt(A, 6, 1);
+
+    cusp::array1d<int,cusp::host_memory> parts(6);
+    for(int i = 0; i < 6; i++)
+        parts[i] = i / 3;
+
+    cusp::precond::additive_schwarz<float,Space> M(A, parts);
+
+    ASSERT_EQUAL(M.num_subdomains(), 2);
+    ASSERT_EQUAL(M.local_solver == cusp::precond::schwarz_dense_lu, true);
+    ASSERT_EQUAL(M.has_coarse_space(), false);
+
+    const int expected_rows[]  = {0, 1, 2, 3, 2, 3, 4, 5};
+    const int expected_parts[] = {0, 0, 0, 0, 1, 1, 1, 1};
+
+    cusp::array1d<int,cusp::host_memory> rows(M.subdomain_rows);
+    cusp::array1d<int,cusp::host_memory> subdomain_parts(M.subdomain_parts);
+
+    ASSERT_EQUAL(rows.size(), 8);
+    for(int p = 0; p < 8; p++)
+    {
+        ASSERT_EQUAL(rows[p], expected_rows[p]);
+        ASSERT_EQUAL(subdomain_parts[p], expected_parts[p]);
+    }
+
+    // no overlap is block Jacobi
+    cusp::precond::additive_schwarz<float,Space> S(A, parts, 0);
+    cusp::precond::block_jacobi<float,Space> J(A, parts);
+
+    ASSERT_EQUAL(S.subdomain_rows.size(), 6);
+
+    cusp::array1d<float,Space> x = unittest::random_samples<float>(6);
+    cusp::array1d<float,Space> y(6);
+    cusp::array1d<float,Space> z(6);
+
+    S(x, y);
+    J(x, z);
+
+    cusp::array1d<float,cusp::host_memory> h_y(y);
+    cusp::array1d<float,cusp::host_memory> h_z(z);
+    ASSERT_ALMOST_EQUAL(h_y, h_z);
+
+    // copy to another memory space
+    cusp::precond::additive_schwarz<float,cusp::host_memory> C(M);
+    ASSERT_EQUAL(C.num_subdomains(), 2);
+    ASSERT_EQUAL(C.subdomain_rows, rows);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestAdditiveSchwarzSubdomains);
+
+template <class Space>
+void TestAdditiveSchwarzPreconditionedCG(void)
+{
+    cusp::csr_matrix<int,float,Space> A;
+    cusp::gallery::poisson5pt(A, 32, 32);
+
+    cusp::array1d<int,Space> parts;
+    schwarz_tiles(parts, 32, 8);
+
+    cusp::array1d<float,Space> b = unittest::random_samples<float>(A.num_rows);
+
+    const size_t jacobi_iterations =
+        schwarz_cg_iterations(A, b, cusp::precond::block_jacobi<float,Space>(A, parts));
+
+    // overlapping subdomains
+    cusp::precond::additive_schwarz<float,Space> M(A, parts, 2);
+    ASSERT_EQUAL(M.num_subdomains(), 16);
+
+    const size_t schwarz_iterations = schwarz_cg_iterations(A, b, M);
+    ASSERT_EQUAL(schwarz_iterations < jacobi_iterations, true);
+
+    // coarse space constant on every tile
+    cusp::precond::additive_schwarz<float,Space> C(A, parts, 2, true);
+    ASSERT_EQUAL(C.has_coarse_space(), true);
+    ASSERT_EQUAL(C.restriction.num_rows, 16);
+
+    ASSERT_EQUAL(schwarz_cg_iterations(A, b, C) < schwarz_iterations, true);
+
+    // coarse space on given aggregates
+    cusp::array1d<int,Space> aggregates;
+    schwarz_tiles(aggregates, 32, 4);
+
+    cusp::precond::additive_schwarz<float,Space> D(A, parts, aggregates, 2);
+    ASSERT_EQUAL(D.restriction.num_rows, 64);
+    ASSERT_EQUAL(schwarz_cg_iterations(A, b, D) < schwarz_iterations, true);
+
+    // large subdomains solved by ILU
+    cusp::array1d<int,Space> halves;
+    schwarz_tiles(halves, 32, 16);
+
+    cusp::precond::additive_schwarz<float,Space> I(A, halves, 1);
+    ASSERT_EQUAL(I.local_solver == cusp::precond::schwarz_incomplete_lu, true);
+
+    cusp::array1d<float,Space> x(A.num_rows, 0.0f);
+    cusp::default_monitor<float> monitor(b, 500, 1e-5);
+    cusp::krylov::gmres(A, x, b, 50, monitor, I);
+    ASSERT_EQUAL(monitor.converged(), true);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestAdditiveSchwarzPreconditionedCG);
+
+template <class Space>
+void TestAdditiveSchwarzRestrictedGMRES(void)
+{
+    cusp::csr_matrix<int,float,Space> A;
+    cusp::gallery::poisson5pt(A, 24, 24);
+
+    cusp::array1d<int,Space> parts;
+    schwarz_tiles(parts, 24, 6);
+
+    cusp::array1d<float,Space> b = unittest::random_samples<float>(A.num_rows);
+
+    cusp::precond::additive_schwarz<float,Space> M(A, parts, 1, true, true);
+    ASSERT_EQUAL(M.row_owners.size(), A.num_rows);
+    ASSERT_EQUAL(M.row_copies.size(), 0);
+
+    cusp::array1d<float,Space> x(A.num_rows, 0.0f);
+    cusp::default_monitor<float> monitor(b, 200, 1e-5);
+    cusp::krylov::gmres(A, x, b, 30, monitor, M);
+
+    ASSERT_EQUAL(monitor.converged(), true);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestAdditiveSchwarzRestrictedGMRES);
+
+void TestAdditiveSchwarzInvalidInput(void)
+{
+    cusp::csr_matrix<int,float,cusp::host_memory> A;
+    cusp::gallery::poisson5pt(A, 6, 1);
+
+    cusp::array1d<int,cusp::host_memory> parts(5, 0);
+    ASSERT_THROWS((cusp::precond::additive_schwarz<float,cusp::host_memory>(A, parts)), cusp::invalid_input_exception);
+
+    parts.resize(6, 0);
+    parts[2] = -1;
+    ASSERT_THROWS((cusp::precond::additive_schwarz<float,cusp::host_memory>(A, parts)), cusp::invalid_input_exception);
+
+    parts[2] = 0;
+    cusp::array1d<int,cusp::host_memory> aggregates(3, 0);
+    ASSERT_THROWS((cusp::precond::additive_schwarz<float,cusp::host_memory>(A, parts, aggregates)), cusp::invalid_input_exception);
+}
+DECLARE_UNITTEST(TestAdditiveSchwarzInvalidInput);
@@ -258,3 +258,44 @@ void TestAINVConvergence(void)
 }
 DECLARE_UNITTEST(TestAINVConvergence);
 
+
+void TestAINVRowBound(void)
+{
+    typedef int                 IndexType;
+    typedef float               ValueType;
+    typedef cusp::host_memory   MemorySpace;
+
+    cusp::csr_matrix<IndexType,ValueType,MemorySpace> A;
+    cusp::gallery::poisson5pt(A, 20, 20);
+
+    // rows of w hold at most nonzero_per_row entries
+    {
+        cusp::precond::bridson_ainv<ValueType,MemorySpace> M(A, 0, 3);
+        cusp::csr_matrix<IndexType,ValueType,MemorySpace> W(M.w);
+
+        for (size_t i = 0; i < W.num_rows; i++)
+            ASSERT_EQUAL(W.row_offsets[i + 1] - W.row_offsets[i] <= 3, true);
+    }
+
+    // and lin_param more entries than the row of A with lin dropping
+    {
+        cusp::precond::bridson_ainv<ValueType,MemorySpace> M(A, 0, -1, true, 2);
+        cusp::csr_matrix<IndexType,ValueType,MemorySpace> W(M.w);
+
+        for (size_t i = 0; i < W.num_rows; i++)
+            ASSERT_EQUAL(W.row_offsets[i + 1] - W.row_offsets[i] <= A.row_offsets[i + 1] - A.row_offsets[i] + 2, true);
+    }
+
+    // row i of the factor has columns up to i and a unit diagonal
+    {
+        cusp::precond::bridson_ainv<ValueType,MemorySpace> M(A, 0.01);
+        cusp::csr_matrix<IndexType,ValueType,MemorySpace> W(M.w);
+
+        for (size_t i = 0; i < W.num_rows; i++)
+        {
+            ASSERT_EQUAL(W.column_indices[W.row_offsets[i + 1] - 1], int(i));
+            ASSERT_EQUAL(W.values[W.row_offsets[i + 1] - 1], 1.0f);
+        }
+    }
+}
+DECLARE_UNITTEST(TestAINVRowBound);
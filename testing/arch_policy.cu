@@ -0,0 +1,56 @@
+#include <unittest/unittest.h>
+
+#include <cusp/cache.h>
+#include <cusp/csr_matrix.h>
+#include <cusp/multiply.h>
+#include <cusp/gallery/poisson.h>
+
+#include <cusp/detail/device/arch_policy.h>
+#include <cusp/detail/device/spmv/csr_vector.h>
+
+namespace arch = cusp::detail::device::arch;
+
+void TestArchPolicySelection(void)
+{
+    const arch::device_description& device = arch::current_device_description();
+
+    ASSERT_EQUAL(device.compute_capability >= 200, true);
+    ASSERT_EQUAL(device.multiprocessors > 0, true);
+
+    if (device.compute_capability >= 350 || CUSP_MIN_ARCH >= 350)
+        ASSERT_EQUAL(arch::current_policy(), arch::SM35_POLICY);
+    else
+        ASSERT_EQUAL(arch::current_policy(), arch::SM20_POLICY);
+}
+DECLARE_UNITTEST(TestArchPolicySelection);
+
+void TestArchPolicySpMV(void)
+{
+    cusp::csr_matrix<int,float,cusp::host_memory> A;
+    cusp::gallery::poisson5pt(A, 50, 40);
+
+    cusp::array1d<float,cusp::host_memory> x(A.num_cols);
+    for(size_t i = 0; i < x.size(); i++)
+        x[i] = int(i % 5) - 2;
+
+    cusp::array1d<float,cusp::host_memory> y(A.num_rows);
+    cusp::multiply(A, x, y);
+
+    // the kernels of the policy of the device, in both cache modes
+    cusp::csr_matrix<int,float,cusp::device_memory> d_A(A);
+    cusp::array1d<float,cusp::device_memory> d_x(x);
+    cusp::array1d<float,cusp::device_memory> d_y(A.num_rows);
+
+    cusp::detail::device::spmv_csr_vector(d_A, thrust::raw_pointer_cast(&d_x[0]), thrust::raw_pointer_cast(&d_y[0]));
+    ASSERT_EQUAL(d_y, y);
+
+    {
+        cusp::spmv_cache_scope scope(cusp::texture_cache);
+        cusp::detail::device::spmv_csr_vector_tex(d_A, thrust::raw_pointer_cast(&d_x[0]), thrust::raw_pointer_cast(&d_y[0]));
+        ASSERT_EQUAL(d_y, y);
+    }
+
+    cusp::detail::device::spmv_csr_vector_tex(d_A, thrust::raw_pointer_cast(&d_x[0]), thrust::raw_pointer_cast(&d_y[0]));
+    ASSERT_EQUAL(d_y, y);
+}
+DECLARE_UNITTEST(TestArchPolicySpMV);
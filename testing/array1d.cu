@@ -192,3 +192,39 @@ void TestArray1dEquality(void)
 }
 DECLARE_HOST_DEVICE_UNITTEST(TestArray1dEquality);
 
+
+template <typename MemorySpace>
+void TestArray1dUninitialized(void)
+{
+    cusp::array1d<int, MemorySpace> A(4, cusp::uninitialized);
+    ASSERT_EQUAL(A.size(), 4);
+
+    A[0] = 10; A[1] = 20; A[2] = 30; A[3] = 40;
+
+    // shrinking keeps the storage and the leading elements
+    const size_t capacity = A.capacity();
+    A.resize(2, cusp::uninitialized);
+    ASSERT_EQUAL(A.size(), 2);
+    ASSERT_EQUAL(A.capacity(), capacity);
+    ASSERT_EQUAL(A[0], 10);
+    ASSERT_EQUAL(A[1], 20);
+
+    // so does growing within the capacity
+    A.resize(capacity, cusp::uninitialized);
+    ASSERT_EQUAL(A.size(), capacity);
+    ASSERT_EQUAL(A[1], 20);
+
+    // growing beyond it copies the elements
+    A.resize(capacity + 100, cusp::uninitialized);
+    ASSERT_EQUAL(A.size(), capacity + 100);
+    ASSERT_EQUAL(A.capacity() >= capacity + 100, true);
+    ASSERT_EQUAL(A[0], 10);
+    ASSERT_EQUAL(A[1], 20);
+
+    // the value-initializing resize is unchanged
+    A.resize(2);
+    A.resize(4);
+    ASSERT_EQUAL(A[2], 0);
+    ASSERT_EQUAL(A[3], 0);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestArray1dUninitialized);
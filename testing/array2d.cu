@@ -224,6 +224,52 @@ void TestArray2dResize(void)
 }
 DECLARE_HOST_DEVICE_UNITTEST(TestArray2dResize);
 
+template <class Space>
+void TestArray2dResizePitched(void)
+{
+  // rows of 3 floats are padded to 4, rows of 40 floats to 64
+  cusp::array2d<float, Space, cusp::row_major> A;
+
+  A.resize_pitched(5, 3);
+
+  ASSERT_EQUAL(A.num_rows,       5);
+  ASSERT_EQUAL(A.num_cols,       3);
+  ASSERT_EQUAL(A.pitch,          4);
+  ASSERT_EQUAL(A.num_entries,   15);
+  ASSERT_EQUAL(A.values.size(), 20);
+
+  A.resize_pitched(2, 40);
+
+  ASSERT_EQUAL(A.pitch,         64);
+  ASSERT_EQUAL(A.values.size(),128);
+
+  // columns of 100 doubles are padded to a multiple of 16
+  cusp::array2d<double, Space, cusp::column_major> B;
+
+  B.resize_pitched(100, 3);
+
+  ASSERT_EQUAL(B.pitch,         112);
+  ASSERT_EQUAL(B.values.size(), 336);
+
+  // other alignments
+  B.resize_pitched(100, 3, 256);
+
+  ASSERT_EQUAL(B.pitch,         128);
+
+  // copies preserve the pitch of the destination
+  cusp::array2d<float, cusp::host_memory> C(5, 3);
+  for (size_t i = 0; i < 5; i++)
+    for (size_t j = 0; j < 3; j++)
+      C(i,j) = 10 * i + j;
+
+  A.resize_pitched(5, 3);
+  cusp::copy(C, A);
+
+  ASSERT_EQUAL(A.pitch, 4);
+  ASSERT_EQUAL_QUIET(C, (cusp::array2d<float, cusp::host_memory>(A)));
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestArray2dResizePitched);
+
 template <class Space>
 void TestArray2dSwap(void)
 {
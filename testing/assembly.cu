@@ -0,0 +1,160 @@
+#include <unittest/unittest.h>
+
+#include <cusp/assembly.h>
+#include <cusp/array2d.h>
+#include <cusp/coo_matrix.h>
+#include <cusp/csr_matrix.h>
+
+#include <thrust/sequence.h>
+
+// 1D linear elements on n nodes, appended from the last element to the first
+template <typename Assembler>
+void append_element_matrices(Assembler& assembler, size_t num_nodes, float scale)
+{
+    for(size_t e = num_nodes - 1; e > 0; e--)
+    {
+        cusp::array1d<int,   cusp::host_memory> rows(4);
+        cusp::array1d<int,   cusp::host_memory> cols(4);
+        cusp::array1d<float, cusp::host_memory> vals(4);
+
+        rows[0] = e - 1; cols[0] = e - 1; vals[0] =  scale;
+        rows[1] = e - 1; cols[1] = e;     vals[1] = -scale;
+        rows[2] = e;     cols[2] = e - 1; vals[2] = -scale;
+        rows[3] = e;     cols[3] = e;     vals[3] =  scale;
+
+        assembler.append(rows, cols, vals);
+    }
+}
+
+template <class Space>
+void TestMatrixAssemblerFinalize(void)
+{
+    cusp::matrix_assembler<int, float, Space> assembler(5, 5);
+
+    append_element_matrices(assembler, 5, 1.0f);
+
+    ASSERT_EQUAL(assembler.num_triplets(), 16);
+
+    cusp::csr_matrix<int, float, Space> A;
+    assembler.finalize(A);
+
+    ASSERT_EQUAL(assembler.num_triplets(), 0);
+    ASSERT_EQUAL(A.num_rows,    5);
+    ASSERT_EQUAL(A.num_cols,    5);
+    ASSERT_EQUAL(A.num_entries, 13);
+
+    cusp::array2d<float, cusp::host_memory> D(A);
+
+    for(size_t i = 0; i < 5; i++)
+        for(size_t j = 0; j < 5; j++)
+        {
+            float expected = 0.0f;
+            if (i == j)     expected = (i == 0 || i == 4) ? 1.0f : 2.0f;
+            if (i == j + 1) expected = -1.0f;
+            if (j == i + 1) expected = -1.0f;
+            ASSERT_EQUAL(D(i,j), expected);
+        }
+
+    // single triplets into another format
+    assembler.push_back(2, 3, 1.0f);
+    assembler.push_back(0, 1, 2.0f);
+    assembler.push_back(2, 3, 4.0f);
+
+    cusp::coo_matrix<int, float, Space> B;
+    assembler.finalize(B);
+
+    cusp::coo_matrix<int, float, cusp::host_memory> C(B);
+    ASSERT_EQUAL(C.num_entries, 2);
+    ASSERT_EQUAL(C.row_indices[0], 0); ASSERT_EQUAL(C.column_indices[0], 1); ASSERT_EQUAL(C.values[0], 2.0f);
+    ASSERT_EQUAL(C.row_indices[1], 2); ASSERT_EQUAL(C.column_indices[1], 3); ASSERT_EQUAL(C.values[1], 5.0f);
+
+    // indices outside of the matrix
+    assembler.push_back(5, 0, 1.0f);
+    ASSERT_THROWS(assembler.finalize(B), cusp::invalid_input_exception);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestMatrixAssemblerFinalize);
+
+template <class Space>
+void TestMatrixAssemblerAssembleValues(void)
+{
+    cusp::matrix_assembler<int, float, Space> assembler(6, 6);
+
+    append_element_matrices(assembler, 6, 1.0f);
+
+    cusp::csr_matrix<int, float, Space> A;
+    assembler.finalize(A);
+
+    cusp::array1d<int, Space> row_offsets(A.row_offsets);
+    cusp::array1d<int, Space> column_indices(A.column_indices);
+
+    // the next step only changes the values
+    append_element_matrices(assembler, 6, 3.0f);
+    size_t capacity = assembler.values.capacity();
+
+    assembler.assemble_values(A);
+
+    ASSERT_EQUAL(assembler.num_triplets(), 0);
+    ASSERT_EQUAL(assembler.values.capacity(), capacity);
+    ASSERT_EQUAL(A.row_offsets,    row_offsets);
+    ASSERT_EQUAL(A.column_indices, column_indices);
+
+    append_element_matrices(assembler, 6, 3.0f);
+
+    cusp::csr_matrix<int, float, Space> B;
+    assembler.finalize(B);
+
+    ASSERT_EQUAL(A.values, B.values);
+
+    // entries without triplets become zero
+    assembler.push_back(2, 3, 7.0f);
+    assembler.assemble_values(A);
+
+    cusp::array2d<float, cusp::host_memory> D(A);
+    ASSERT_EQUAL(D(2,3), 7.0f);
+    ASSERT_EQUAL(D(3,2), 0.0f);
+    ASSERT_EQUAL(D(0,0), 0.0f);
+
+    // triplets outside of the pattern
+    assembler.push_back(0, 5, 1.0f);
+    ASSERT_THROWS(assembler.assemble_values(A), cusp::invalid_input_exception);
+    assembler.clear();
+
+    cusp::csr_matrix<int, float, Space> C(5, 6, 0);
+    ASSERT_THROWS(assembler.assemble_values(C), cusp::invalid_input_exception);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestMatrixAssemblerAssembleValues);
+
+template <class Space>
+void TestMatrixAssemblerAppendRange(void)
+{
+    cusp::matrix_assembler<int, float, Space> assembler(4, 4, 8);
+
+    ASSERT_EQUAL(assembler.values.capacity() >= 8, true);
+
+    // fill reserved ranges in place, as a kernel would
+    size_t offset = assembler.append(4);
+    ASSERT_EQUAL(offset, 0);
+
+    thrust::sequence(assembler.row_indices.begin(),    assembler.row_indices.end());
+    thrust::sequence(assembler.column_indices.begin(), assembler.column_indices.end());
+    thrust::fill(assembler.values.begin(), assembler.values.end(), 1.0f);
+
+    offset = assembler.append(4);
+    ASSERT_EQUAL(offset, 4);
+
+    thrust::sequence(assembler.row_indices.begin()    + offset, assembler.row_indices.end());
+    thrust::sequence(assembler.column_indices.begin() + offset, assembler.column_indices.end());
+    thrust::fill(assembler.values.begin() + offset, assembler.values.end(), 2.0f);
+
+    cusp::array1d<int,   cusp::host_memory> rows(2, 0);
+    cusp::array1d<int,   cusp::host_memory> cols(1, 0);
+    cusp::array1d<float, cusp::host_memory> vals(2, 0.0f);
+    ASSERT_THROWS(assembler.append(rows, cols, vals), cusp::invalid_input_exception);
+
+    cusp::csr_matrix<int, float, Space> A;
+    assembler.finalize(A);
+
+    ASSERT_EQUAL(A.num_entries, 4);
+    ASSERT_EQUAL(A.values, (cusp::array1d<float, Space>(4, 3.0f)));
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestMatrixAssemblerAppendRange);
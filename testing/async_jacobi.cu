@@ -0,0 +1,160 @@
+#include <unittest/unittest.h>
+
+#include <cusp/relaxation/async_jacobi.h>
+#include <cusp/precond/aggregation/smoothed_aggregation.h>
+
+#include <cusp/blas.h>
+#include <cusp/gallery/poisson.h>
+#include <cusp/krylov/fgmres.h>
+#include <cusp/monitor.h>
+#include <cusp/multiply.h>
+
+// x <- x + omega * D^-1 (b - A x), sweeps times
+void async_jacobi_reference(const cusp::csr_matrix<int,float,cusp::host_memory>& A,
+                            const cusp::array1d<float,cusp::host_memory>& b,
+                            cusp::array1d<float,cusp::host_memory>& x,
+                            float omega, int sweeps, bool gauss_seidel)
+{
+    for(int sweep = 0; sweep < sweeps; sweep++)
+    {
+        cusp::array1d<float,cusp::host_memory> x_old(x);
+
+        for(size_t i = 0; i < A.num_rows; i++)
+        {
+            float d = 0, sum = b[i];
+            for(int jj = A.row_offsets[i]; jj < A.row_offsets[i + 1]; jj++)
+            {
+                const int j = A.column_indices[jj];
+                if(j == int(i))
+                    d = A.values[jj];
+                sum -= A.values[jj] * (gauss_seidel ? x[j] : x_old[j]);
+            }
+
+            x[i] += omega * sum / d;
+        }
+    }
+}
+
+template <class Space>
+void TestAsyncJacobiSingleBlock(void)
+{
+    cusp::csr_matrix<int,float,cusp::host_memory> A;
+    cusp::gallery::poisson5pt(A, 12, 10);
+
+    cusp::array1d<float,cusp::host_memory> b = unittest::random_samples<float>(A.num_rows);
+
+    // with all the rows in one block local Jacobi sweeps are damped Jacobi
+    cusp::csr_matrix<int,float,Space> d_A(A);
+    cusp::relaxation::async_jacobi<float,Space> M(d_A, 0.8f, 3, 128, false);
+
+    cusp::array1d<float,cusp::host_memory> x(A.num_rows, 0.0f);
+    async_jacobi_reference(A, b, x, 0.8f, 3, false);
+
+    cusp::array1d<float,Space> d_b(b);
+    cusp::array1d<float,Space> d_x(A.num_rows, 5.0f);
+    M.presmooth(d_A, d_b, d_x);
+
+    cusp::array1d<float,cusp::host_memory> h_x(d_x);
+    ASSERT_ALMOST_EQUAL(h_x, x);
+
+    // copy to another memory space
+    cusp::relaxation::async_jacobi<float,cusp::host_memory> C(M);
+    ASSERT_EQUAL(C.block_size,   M.block_size);
+    ASSERT_EQUAL(C.local_sweeps, M.local_sweeps);
+    ASSERT_EQUAL(C.inv_diagonal, M.inv_diagonal);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestAsyncJacobiSingleBlock);
+
+void TestAsyncJacobiHostGaussSeidel(void)
+{
+    cusp::csr_matrix<int,float,cusp::host_memory> A;
+    cusp::gallery::poisson5pt(A, 12, 10);
+
+    cusp::array1d<float,cusp::host_memory> b = unittest::random_samples<float>(A.num_rows);
+
+    // a single block is relaxed by sequential Gauss-Seidel sweeps on the host
+    cusp::relaxation::async_jacobi<float,cusp::host_memory> M(A, 1.0f, 2, 128);
+
+    cusp::array1d<float,cusp::host_memory> x(A.num_rows, 0.0f);
+    async_jacobi_reference(A, b, x, 1.0f, 2, true);
+
+    cusp::array1d<float,cusp::host_memory> y(A.num_rows, 0.0f);
+    M.step(b, y, 1.0f);
+
+    ASSERT_ALMOST_EQUAL(y, x);
+
+    // blocks of 32 rows only see the values of the other blocks from the
+    // start of the step
+    cusp::relaxation::async_jacobi<float,cusp::host_memory> B(A, 1.0f, 1, 32);
+
+    cusp::array1d<float,cusp::host_memory> z(A.num_rows, 0.0f);
+    B.step(b, z, 1.0f);
+
+    cusp::array1d<float,cusp::host_memory> z_ref(A.num_rows, 0.0f);
+    for(size_t first = 0; first < A.num_rows; first += 32)
+        for(size_t i = first; i < std::min<size_t>(first + 32, A.num_rows); i++)
+        {
+            float d = 0, sum = b[i];
+            for(int jj = A.row_offsets[i]; jj < A.row_offsets[i + 1]; jj++)
+            {
+                const size_t j = A.column_indices[jj];
+                if(j == i)
+                    d = A.values[jj];
+                if(j >= first && j < first + 32)
+                    sum -= A.values[jj] * z_ref[j];
+            }
+
+            z_ref[i] += sum / d;
+        }
+
+    ASSERT_ALMOST_EQUAL(z, z_ref);
+
+    // the device kernels only exist for these block sizes
+    typedef cusp::relaxation::async_jacobi<float,cusp::host_memory> Relaxation;
+    ASSERT_THROWS(Relaxation(A, 1.0f, 2, 100), cusp::invalid_input_exception);
+    ASSERT_THROWS(Relaxation(A, 1.0f, 0, 128), cusp::invalid_input_exception);
+}
+DECLARE_UNITTEST(TestAsyncJacobiHostGaussSeidel);
+
+template <class Space>
+void TestAsyncJacobiSmoother(void)
+{
+    typedef cusp::relaxation::async_jacobi<float,Space> Smoother;
+
+    cusp::csr_matrix<int,float,Space> A;
+    cusp::gallery::poisson5pt(A, 50, 50);
+
+    cusp::array1d<float,Space> b = unittest::random_samples<float>(A.num_rows);
+
+    // every step reduces the residual
+    {
+        Smoother M(A, 1.0f, 2, 64);
+
+        cusp::array1d<float,Space> x(A.num_rows, 0.0f);
+        cusp::array1d<float,Space> r(A.num_rows);
+
+        float previous_residual = cusp::blas::nrm2(b);
+        for(int i = 0; i < 5; i++)
+        {
+            M(A, b, x);
+
+            cusp::multiply(A, x, r);
+            cusp::blas::axpby(b, r, r, 1.0f, -1.0f);
+            float residual = cusp::blas::nrm2(r);
+
+            ASSERT_EQUAL(residual < previous_residual, true);
+            previous_residual = residual;
+        }
+    }
+
+    // the device smoother is not exactly the same operator from one
+    // application to the next, so it is used with flexible GMRES
+    {
+        cusp::precond::aggregation::smoothed_aggregation<int,float,Space,Smoother> M(A);
+        cusp::array1d<float,Space> x(A.num_rows, 0.0f);
+        cusp::default_monitor<float> monitor(b, 100, 1e-6);
+        cusp::krylov::fgmres(A, x, b, 50, monitor, M);
+        ASSERT_EQUAL(monitor.converged(), true);
+    }
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestAsyncJacobiSmoother);
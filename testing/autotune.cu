@@ -0,0 +1,130 @@
+#include <unittest/unittest.h>
+
+#include <cusp/autotune.h>
+#include <cusp/multiply.h>
+#include <cusp/gallery/poisson.h>
+#include <cusp/gallery/random.h>
+
+template <typename Matrix>
+void CompareAutotunedSpMV(const Matrix& A, const cusp::autotune_options& options)
+{
+    typedef typename Matrix::index_type IndexType;
+    typedef typename Matrix::value_type ValueType;
+
+    cusp::autotuned_spmv<IndexType,ValueType> M(A, options);
+
+    ASSERT_EQUAL(M.num_rows, A.num_rows);
+    ASSERT_EQUAL(M.num_cols, A.num_cols);
+
+    cusp::array1d<ValueType,cusp::host_memory> x(A.num_cols);
+    for(size_t i = 0; i < x.size(); i++)
+        x[i] = int(i % 7) - 3;
+
+    cusp::array1d<ValueType,cusp::host_memory> y(A.num_rows);
+    cusp::multiply(A, x, y);
+
+    cusp::array1d<ValueType,cusp::device_memory> d_x(x);
+    cusp::array1d<ValueType,cusp::device_memory> d_y(A.num_rows, ValueType(10));
+    M(d_x, d_y);
+
+    ASSERT_EQUAL(d_y, y);
+}
+
+void TestAnalyzeStructure(void)
+{
+    cusp::csr_matrix<int,float,cusp::host_memory> A;
+    cusp::gallery::poisson5pt(A, 3, 3);
+
+    cusp::matrix_structure s = cusp::analyze_structure(A);
+
+    ASSERT_EQUAL(s.num_rows,            9);
+    ASSERT_EQUAL(s.num_cols,            9);
+    ASSERT_EQUAL(s.num_entries,        33);
+    ASSERT_EQUAL(s.min_entries_per_row, 3);
+    ASSERT_EQUAL(s.max_entries_per_row, 5);
+    ASSERT_EQUAL(s.num_diagonals,       5);
+    ASSERT_EQUAL(s.bandwidth,           3);
+
+    ASSERT_EQUAL(s.row_length_histogram.size(), 4);
+    ASSERT_EQUAL(s.row_length_histogram[0], 0);
+    ASSERT_EQUAL(s.row_length_histogram[1], 0);
+    ASSERT_EQUAL(s.row_length_histogram[2], 4);
+    ASSERT_EQUAL(s.row_length_histogram[3], 5);
+}
+DECLARE_UNITTEST(TestAnalyzeStructure);
+
+void TestAutotunedSpMVHeuristic(void)
+{
+    cusp::autotune_options options;
+
+    // banded matrices are stored in DIA format
+    cusp::csr_matrix<int,float,cusp::host_memory> A;
+    cusp::gallery::poisson5pt(A, 20, 30);
+    {
+        cusp::autotuned_spmv<int,float> M(A, options);
+        ASSERT_EQUAL(M.kernel_name().substr(0,3), "dia");
+        ASSERT_EQUAL(M.milliseconds_per_spmv(), 0.0f);
+    }
+    CompareAutotunedSpMV(A, options);
+
+    // one dense row among short rows
+    cusp::coo_matrix<int,float,cusp::host_memory> B_coo(100, 100, 199);
+    for(int j = 0; j < 100; j++)
+    {
+        B_coo.row_indices[j] = 0;  B_coo.column_indices[j] = j;  B_coo.values[j] = 1.0f;
+    }
+    for(int i = 1; i < 100; i++)
+    {
+        B_coo.row_indices[99 + i] = i;  B_coo.column_indices[99 + i] = i;  B_coo.values[99 + i] = 2.0f;
+    }
+    cusp::csr_matrix<int,float,cusp::host_memory> B(B_coo);
+    {
+        cusp::autotuned_spmv<int,float> M(B, options);
+        ASSERT_EQUAL(M.kernel_name().substr(0,9), "csr_merge");
+    }
+    CompareAutotunedSpMV(B, options);
+
+    // random structure with a looser fill limit
+    cusp::csr_matrix<int,float,cusp::host_memory> C;
+    cusp::gallery::random(300, 200, 2000, C);
+    options.max_fill = 1.0f;
+    CompareAutotunedSpMV(C, options);
+
+    // empty matrix
+    cusp::csr_matrix<int,float,cusp::host_memory> D(10, 10, 0);
+    CompareAutotunedSpMV(D, options);
+}
+DECLARE_UNITTEST(TestAutotunedSpMVHeuristic);
+
+void TestAutotunedSpMVBenchmark(void)
+{
+    cusp::autotune_options options;
+    options.benchmark  = true;
+    options.iterations = 2;
+
+    cusp::csr_matrix<int,float,cusp::host_memory> A;
+    cusp::gallery::poisson5pt(A, 20, 30);
+    CompareAutotunedSpMV(A, options);
+
+    cusp::csr_matrix<int,float,cusp::host_memory> C;
+    cusp::gallery::random(300, 200, 2000, C);
+    CompareAutotunedSpMV(C, options);
+
+    cusp::autotuned_spmv<int,float> M(C, options);
+    ASSERT_EQUAL(M.milliseconds_per_spmv() > 0.0f, true);
+}
+DECLARE_UNITTEST(TestAutotunedSpMVBenchmark);
+
+void TestAutotunedSpMVDimensions(void)
+{
+    cusp::csr_matrix<int,float,cusp::host_memory> A;
+    cusp::gallery::poisson5pt(A, 4, 4);
+
+    cusp::autotuned_spmv<int,float> M(A);
+
+    cusp::array1d<float,cusp::device_memory> x(A.num_cols + 1);
+    cusp::array1d<float,cusp::device_memory> y(A.num_rows);
+
+    ASSERT_THROWS(M(x, y), cusp::invalid_input_exception);
+}
+DECLARE_UNITTEST(TestAutotunedSpMVDimensions);
@@ -0,0 +1,48 @@
+#include <unittest/unittest.h>
+
+#include <cusp/csr_matrix.h>
+#include <cusp/gallery/banded.h>
+
+template <class MemorySpace>
+void TestRandomBanded(void)
+{
+    cusp::csr_matrix<int, float, MemorySpace> A;
+    cusp::gallery::random_banded(A, 500, 7, 11);
+
+    cusp::csr_matrix<int, float, cusp::host_memory> B(A);
+
+    ASSERT_EQUAL(B.num_rows, 500);
+    ASSERT_EQUAL(B.num_cols, 500);
+
+    size_t min_length = 500;
+    size_t max_length = 0;
+
+    for (int i = 0; i < B.num_rows; i++)
+    {
+        const int start  = B.row_offsets[i];
+        const int length = B.row_offsets[i + 1] - start;
+
+        min_length = std::min<size_t>(min_length, length);
+        max_length = std::max<size_t>(max_length, length);
+
+        // contiguous columns around the diagonal
+        ASSERT_EQUAL(B.column_indices[start] <= i && i - B.column_indices[start] <= 7, true);
+        ASSERT_EQUAL(B.column_indices[start + length - 1] - B.column_indices[start], length - 1);
+
+        for (int jj = start; jj < start + length; jj++)
+            ASSERT_EQUAL(B.values[jj], B.column_indices[jj] == i ? float(length) : -1.0f);
+    }
+
+    // the bandwidth varies between rows
+    ASSERT_EQUAL(min_length < max_length, true);
+    ASSERT_EQUAL(max_length <= 15, true);
+
+    // the same matrix in the other memory space
+    cusp::csr_matrix<int, float, cusp::host_memory> C;
+    cusp::gallery::random_banded(C, 500, 7, 11);
+    ASSERT_EQUAL(C.column_indices, B.column_indices);
+
+    cusp::gallery::random_banded(A, 0, 7);
+    ASSERT_EQUAL(A.num_entries, 0);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestRandomBanded);
@@ -0,0 +1,166 @@
+#include <unittest/unittest.h>
+
+#include <cusp/gallery/poisson.h>
+#include <cusp/csr_matrix.h>
+#include <cusp/multiply.h>
+#include <cusp/krylov/batched.h>
+
+#include <thrust/sequence.h>
+
+// a batch of scaled Poisson problems, the right-hand side of system 3 vanishes
+template <class MemorySpace>
+void BatchedPoissonSystems(cusp::csr_matrix<int, float, MemorySpace>& A,
+                           cusp::array1d<int, MemorySpace>& offsets,
+                           cusp::array1d<float, MemorySpace>& b,
+                           const size_t num_systems)
+{
+    cusp::csr_matrix<int, float, cusp::host_memory> P;
+    cusp::gallery::poisson5pt(P, 6, 7);
+
+    cusp::array1d<float, cusp::host_memory> values(num_systems * P.num_entries);
+    for (size_t s = 0; s < num_systems; s++)
+        for (size_t k = 0; k < P.num_entries; k++)
+            values[s * P.num_entries + k] = (s + 1) * P.values[k];
+
+    cusp::csr_matrix<int, float, cusp::host_memory> A_host;
+    cusp::array1d<int, cusp::host_memory> offsets_host;
+    cusp::krylov::batched_block_diagonal(P, values, num_systems, A_host, offsets_host);
+
+    cusp::array1d<float, cusp::host_memory> b_host = unittest::random_samples<float>(A_host.num_rows);
+    for (int i = offsets_host[3]; i < offsets_host[4]; i++)
+        b_host[i] = 0;
+
+    A = A_host;
+    offsets = offsets_host;
+    b = b_host;
+}
+
+template <class Matrix, class Array1, class Array2, class Array3>
+void CheckBatchedSolution(const Matrix& A, const Array1& x, const Array2& b, const Array3& offsets,
+                          const cusp::krylov::batched_monitor<float>& monitor)
+{
+    cusp::array1d<float, cusp::host_memory> residual(A.num_rows, 0.0f);
+    cusp::csr_matrix<int, float, cusp::host_memory> A_host(A);
+    cusp::array1d<float, cusp::host_memory> x_host(x);
+    cusp::array1d<float, cusp::host_memory> b_host(b);
+    cusp::array1d<int, cusp::host_memory> offsets_host(offsets);
+
+    cusp::multiply(A_host, x_host, residual);
+    cusp::blas::axpby(residual, b_host, residual, -1.0f, 1.0f);
+
+    ASSERT_EQUAL(monitor.num_systems(), offsets.size() - 1);
+    ASSERT_EQUAL(monitor.converged(), true);
+
+    for (size_t s = 0; s + 1 < offsets_host.size(); s++)
+    {
+        float r_norm = 0, b_norm = 0;
+        for (int i = offsets_host[s]; i < offsets_host[s + 1]; i++)
+        {
+            r_norm += residual[i] * residual[i];
+            b_norm += b_host[i] * b_host[i];
+        }
+
+        ASSERT_EQUAL(std::sqrt(r_norm) <= 1e-4 * std::sqrt(b_norm) + 1e-6, true);
+    }
+
+    // the system with a zero right-hand side is solved by x = 0
+    ASSERT_EQUAL(monitor.iteration_count(3), 0);
+}
+
+template <class MemorySpace>
+void TestBatchedBlockDiagonal(void)
+{
+    cusp::csr_matrix<int, float, MemorySpace> P;
+    cusp::gallery::poisson5pt(P, 3, 4);
+
+    cusp::array1d<float, MemorySpace> values(3 * P.num_entries);
+    thrust::sequence(values.begin(), values.end());
+
+    cusp::csr_matrix<int, float, MemorySpace> A;
+    cusp::array1d<int, MemorySpace> offsets;
+    cusp::krylov::batched_block_diagonal(P, values, 3, A, offsets);
+
+    cusp::csr_matrix<int, float, cusp::host_memory> P_host(P);
+    cusp::csr_matrix<int, float, cusp::host_memory> A_host(A);
+
+    ASSERT_EQUAL(A_host.num_rows, 3 * P_host.num_rows);
+    ASSERT_EQUAL(A_host.num_entries, 3 * P_host.num_entries);
+    ASSERT_EQUAL(offsets.size(), 4);
+    ASSERT_EQUAL(offsets[3], A_host.num_rows);
+
+    for (size_t s = 0; s < 3; s++)
+    {
+        for (size_t i = 0; i <= P_host.num_rows; i++)
+            ASSERT_EQUAL(A_host.row_offsets[s * P_host.num_rows + i], s * P_host.num_entries + P_host.row_offsets[i]);
+        for (size_t k = 0; k < P_host.num_entries; k++)
+        {
+            ASSERT_EQUAL(A_host.column_indices[s * P_host.num_entries + k], s * P_host.num_rows + P_host.column_indices[k]);
+            ASSERT_EQUAL(A_host.values[s * P_host.num_entries + k], float(s * P_host.num_entries + k));
+        }
+    }
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestBatchedBlockDiagonal);
+
+template <class MemorySpace>
+void TestBatchedConjugateGradient(void)
+{
+    cusp::csr_matrix<int, float, MemorySpace> A;
+    cusp::array1d<int, MemorySpace> offsets;
+    cusp::array1d<float, MemorySpace> b;
+    BatchedPoissonSystems(A, offsets, b, 50);
+
+    for (int jacobi = 0; jacobi < 2; jacobi++)
+    {
+        cusp::array1d<float, MemorySpace> x(A.num_rows, 0.0f);
+        cusp::krylov::batched_monitor<float> monitor(100, 1e-5);
+
+        cusp::krylov::batched_cg(A, x, b, offsets, monitor,
+                                 jacobi ? cusp::krylov::BATCHED_JACOBI : cusp::krylov::BATCHED_IDENTITY);
+
+        CheckBatchedSolution(A, x, b, offsets, monitor);
+    }
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestBatchedConjugateGradient);
+
+template <class MemorySpace>
+void TestBatchedBiConjugateGradientStabilized(void)
+{
+    cusp::csr_matrix<int, float, MemorySpace> A;
+    cusp::array1d<int, MemorySpace> offsets;
+    cusp::array1d<float, MemorySpace> b;
+    BatchedPoissonSystems(A, offsets, b, 50);
+
+    for (int jacobi = 0; jacobi < 2; jacobi++)
+    {
+        cusp::array1d<float, MemorySpace> x(A.num_rows, 0.0f);
+        cusp::krylov::batched_monitor<float> monitor(100, 1e-5);
+
+        cusp::krylov::batched_bicgstab(A, x, b, offsets, monitor,
+                                       jacobi ? cusp::krylov::BATCHED_JACOBI : cusp::krylov::BATCHED_IDENTITY);
+
+        CheckBatchedSolution(A, x, b, offsets, monitor);
+    }
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestBatchedBiConjugateGradientStabilized);
+
+template <class MemorySpace>
+void TestBatchedGeneralizedMinimumResidual(void)
+{
+    cusp::csr_matrix<int, float, MemorySpace> A;
+    cusp::array1d<int, MemorySpace> offsets;
+    cusp::array1d<float, MemorySpace> b;
+    BatchedPoissonSystems(A, offsets, b, 50);
+
+    for (int jacobi = 0; jacobi < 2; jacobi++)
+    {
+        cusp::array1d<float, MemorySpace> x(A.num_rows, 0.0f);
+        cusp::krylov::batched_monitor<float> monitor(200, 1e-5);
+
+        cusp::krylov::batched_gmres(A, x, b, offsets, 10, monitor,
+                                    jacobi ? cusp::krylov::BATCHED_JACOBI : cusp::krylov::BATCHED_IDENTITY);
+
+        CheckBatchedSolution(A, x, b, offsets, monitor);
+    }
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestBatchedGeneralizedMinimumResidual);
+
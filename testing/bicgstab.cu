@@ -58,3 +58,30 @@ void TestBiConjugateGradientStabilizedZeroResidual(void)
 }
 DECLARE_HOST_DEVICE_UNITTEST(TestBiConjugateGradientStabilizedZeroResidual);
 
+
+template <class MemorySpace>
+void TestReliableBiConjugateGradientStabilized(void)
+{
+    cusp::csr_matrix<int, double, MemorySpace> A;
+
+    cusp::gallery::poisson5pt(A, 20, 20);
+
+    cusp::csr_matrix<int, float, MemorySpace> A_low(A);
+
+    cusp::array1d<double, MemorySpace> x(A.num_rows, 0.0);
+    cusp::array1d<double, MemorySpace> b(A.num_rows, 1.0);
+
+    // beyond the accuracy of float iterations
+    cusp::default_monitor<double> monitor(b, 500, 1e-10);
+
+    cusp::krylov::reliable_bicgstab(A, A_low, x, b, monitor);
+
+    // check the true residual norm
+    cusp::array1d<double, MemorySpace> residual(A.num_rows, 0.0);
+    cusp::multiply(A, x, residual);
+    cusp::blas::axpby(residual, b, residual, -1.0, 1.0);
+
+    ASSERT_EQUAL(monitor.converged(), true);
+    ASSERT_EQUAL(cusp::blas::nrm2(residual) <= 1e-10 * cusp::blas::nrm2(b), true);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestReliableBiConjugateGradientStabilized);
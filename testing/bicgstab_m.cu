@@ -0,0 +1,91 @@
+#include <unittest/unittest.h>
+
+#include <cusp/gallery/poisson.h>
+#include <cusp/csr_matrix.h>
+#include <cusp/krylov/bicgstab_m.h>
+
+template <class LinearOperator, class VectorType1, class VectorType2, class VectorType3>
+void check_residuals(LinearOperator& A, VectorType1& xs, VectorType2& b, VectorType3& sigma)
+{
+    typedef typename LinearOperator::value_type   ValueType;
+    typedef typename LinearOperator::memory_space MemorySpace;
+
+    size_t N = A.num_rows;
+
+    for (size_t i = 0; i < sigma.size(); i++)
+    {
+        // compute residual = b - (A + \sigma * I) x
+        ValueType s = sigma[i];
+
+        cusp::array1d<ValueType, MemorySpace> residual(A.num_rows, 0.0f);
+        
+        // TODO replace this with a array1d view of a array2d
+        cusp::array1d<ValueType, MemorySpace> x(xs.begin() + i * N, xs.begin() + (i + 1) * N);
+        cusp::multiply(A, x, residual);
+        cusp::blas::axpby(residual, x, residual,  1.0f,     s);
+        cusp::blas::axpby(residual, b, residual, -1.0f,  1.0f);
+
+        ASSERT_EQUAL(cusp::blas::nrm2(residual) < 1e-4 * cusp::blas::nrm2(b), true);
+    }
+} // end check_residuals
+
+
+template <class MemorySpace>
+void TestBiConjugateGradientStabilizedM(void)
+{
+    typedef float ValueType;
+
+    cusp::csr_matrix<int, ValueType, MemorySpace> A;
+    cusp::gallery::poisson5pt(A, 10, 10);
+
+    size_t N_s = 4;
+    cusp::array1d<ValueType, MemorySpace> x(A.num_rows*N_s, ValueType(0));
+    cusp::array1d<ValueType, MemorySpace> b(A.num_rows, ValueType(1));
+
+    cusp::array1d<ValueType, MemorySpace> sigma(N_s);
+    sigma[0] = ValueType(0.1);
+    sigma[1] = ValueType(0.5);
+    sigma[2] = ValueType(1.0);
+    sigma[3] = ValueType(50.0);
+
+    cusp::default_monitor<ValueType> monitor(b, 100, 1e-6);
+
+    cusp::krylov::bicgstab_m(A, x, b, sigma, monitor);
+
+    ASSERT_EQUAL(monitor.converged(), true);
+
+    check_residuals(A, x, b, sigma);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestBiConjugateGradientStabilizedM);
+
+template <class MemorySpace>
+void TestBiConjugateGradientStabilizedMPolynomial(void)
+{
+    typedef float ValueType;
+
+    cusp::csr_matrix<int, ValueType, MemorySpace> A;
+    cusp::gallery::poisson5pt(A, 10, 10);
+
+    size_t N_s = 3;
+    cusp::array1d<ValueType, MemorySpace> x(A.num_rows*N_s, ValueType(0));
+    cusp::array1d<ValueType, MemorySpace> b(A.num_rows, ValueType(1));
+
+    cusp::array1d<ValueType, MemorySpace> sigma(N_s);
+    sigma[0] = ValueType(0.1);
+    sigma[1] = ValueType(1.0);
+    sigma[2] = ValueType(5.0);
+
+    // p(t) = 1.5 - t/8
+    cusp::array1d<ValueType, cusp::host_memory> coefficients(2);
+    coefficients[0] = ValueType(-0.125);
+    coefficients[1] = ValueType(1.5);
+
+    cusp::default_monitor<ValueType> monitor(b, 100, 1e-6);
+
+    cusp::krylov::bicgstab_m(A, x, b, sigma, monitor, coefficients);
+
+    ASSERT_EQUAL(monitor.converged(), true);
+
+    check_residuals(A, x, b, sigma);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestBiConjugateGradientStabilizedMPolynomial);
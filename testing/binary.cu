@@ -0,0 +1,191 @@
+#include <unittest/unittest.h>
+
+#include <cusp/io/binary.h>
+
+#include <cusp/array1d.h>
+#include <cusp/array2d.h>
+#include <cusp/coo_matrix.h>
+#include <cusp/csr_matrix.h>
+#include <cusp/dia_matrix.h>
+#include <cusp/ell_matrix.h>
+#include <cusp/hyb_matrix.h>
+#include <cusp/multiply.h>
+#include <cusp/gallery/poisson.h>
+
+#include <stdio.h>
+
+const char binary_file_name[] = "test_58210945731962.bin";
+
+template <typename SparseMatrix>
+void TestReadWriteBinaryFile(void)
+{
+  typedef typename SparseMatrix::index_type   IndexType;
+  typedef typename SparseMatrix::value_type   ValueType;
+  typedef typename SparseMatrix::memory_space MemorySpace;
+
+  cusp::csr_matrix<IndexType, ValueType, cusp::host_memory> A;
+  cusp::gallery::poisson5pt(A, 7, 9);
+
+  SparseMatrix B(A);
+
+  cusp::io::write_binary_file(B, binary_file_name);
+
+  SparseMatrix C;
+  cusp::io::read_binary_file(C, binary_file_name);
+
+  // the matrix is restored in the same format, including its padding
+  ASSERT_EQUAL(C.num_rows,    B.num_rows);
+  ASSERT_EQUAL(C.num_cols,    B.num_cols);
+  ASSERT_EQUAL(C.num_entries, B.num_entries);
+
+  cusp::array2d<ValueType, cusp::host_memory> B_dense(B);
+  cusp::array2d<ValueType, cusp::host_memory> C_dense(C);
+  ASSERT_EQUAL(C_dense == B_dense, true);
+
+  // and may be loaded in any other format
+  cusp::hyb_matrix<IndexType, ValueType, MemorySpace> D;
+  cusp::io::read_binary_file(D, binary_file_name);
+
+  cusp::array2d<ValueType, cusp::host_memory> D_dense(D);
+  ASSERT_EQUAL(D_dense == B_dense, true);
+
+  remove(binary_file_name);
+}
+DECLARE_SPARSE_MATRIX_UNITTEST(TestReadWriteBinaryFile);
+
+template <class Space>
+void TestReadWriteBinaryFileArray1d(void)
+{
+  cusp::array1d<float, Space> a(10);
+  for (int i = 0; i < 10; i++)
+    a[i] = 0.5f * i - 1.0f;
+
+  cusp::io::write_binary_file(a, binary_file_name);
+
+  cusp::array1d<float, Space> b;
+  cusp::io::read_binary_file(b, binary_file_name);
+
+  ASSERT_EQUAL(b, a);
+
+  // a matrix cannot be read from an array file
+  cusp::csr_matrix<int, float, Space> A;
+  ASSERT_THROWS(cusp::io::read_binary_file(A, binary_file_name), cusp::io_exception);
+
+  remove(binary_file_name);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestReadWriteBinaryFileArray1d);
+
+void TestBinaryFileCsrView(void)
+{
+  cusp::csr_matrix<int, double, cusp::host_memory> A;
+  cusp::gallery::poisson5pt(A, 10, 12);
+
+  cusp::io::write_binary_file(A, binary_file_name);
+
+  {
+    cusp::io::binary_file file(binary_file_name);
+
+    ASSERT_EQUAL(file.num_rows(),    A.num_rows);
+    ASSERT_EQUAL(file.num_cols(),    A.num_cols);
+    ASSERT_EQUAL(file.num_entries(), A.num_entries);
+
+    cusp::io::binary_file::csr_view<int, double>::type V = file.make_csr_view<int, double>();
+
+    ASSERT_EQUAL(V.row_offsets.size(),    A.row_offsets.size());
+    ASSERT_EQUAL(V.column_indices.size(), A.column_indices.size());
+
+    cusp::array1d<double, cusp::host_memory> x(A.num_cols);
+    for (size_t i = 0; i < x.size(); i++)
+      x[i] = int(i % 5) - 2;
+
+    cusp::array1d<double, cusp::host_memory> y(A.num_rows);
+    cusp::array1d<double, cusp::host_memory> z(A.num_rows);
+
+    cusp::multiply(A, x, y);
+    cusp::multiply(V, x, z);
+
+    ASSERT_EQUAL(z, y);
+
+    // the types must match the file
+    ASSERT_THROWS((file.make_csr_view<int, float>()), cusp::io_exception);
+    ASSERT_THROWS(file.make_array1d_view<double>(), cusp::io_exception);
+  }
+
+  remove(binary_file_name);
+}
+DECLARE_UNITTEST(TestBinaryFileCsrView);
+
+void TestReadBinaryFileErrors(void)
+{
+  cusp::csr_matrix<int, float, cusp::host_memory> A;
+  cusp::gallery::poisson5pt(A, 4, 4);
+
+  cusp::io::write_binary_file(A, binary_file_name);
+
+  // value and index widths must match
+  cusp::csr_matrix<int, double, cusp::host_memory> B;
+  ASSERT_THROWS(cusp::io::read_binary_file(B, binary_file_name), cusp::io_exception);
+
+  cusp::csr_matrix<long long, float, cusp::host_memory> C;
+  ASSERT_THROWS(cusp::io::read_binary_file(C, binary_file_name), cusp::io_exception);
+
+  // not a binary file
+  FILE * file = fopen(binary_file_name, "w");
+  fputs("%%MatrixMarket matrix coordinate real general\n", file);
+  fclose(file);
+
+  ASSERT_THROWS(cusp::io::read_binary_file(A, binary_file_name), cusp::io_exception);
+
+  remove(binary_file_name);
+
+  ASSERT_THROWS(cusp::io::read_binary_file(A, binary_file_name), cusp::io_exception);
+}
+DECLARE_UNITTEST(TestReadBinaryFileErrors);
+
+template <typename SparseMatrix>
+void TestReadWriteBinaryFileCompressed(void)
+{
+  typedef typename SparseMatrix::index_type   IndexType;
+  typedef typename SparseMatrix::value_type   ValueType;
+
+  const char * compressed_file_names[] = {"test_58210945731962.bin.gz", "test_58210945731962.bin.zst"};
+
+  cusp::csr_matrix<IndexType, ValueType, cusp::host_memory> A;
+  cusp::gallery::poisson5pt(A, 50, 40);
+
+  SparseMatrix B(A);
+
+  cusp::array2d<ValueType, cusp::host_memory> B_dense(B);
+
+  for (int i = 0; i < 2; i++)
+  {
+#ifndef __CUSP_USE_ZLIB__
+    if (i == 0)
+    {
+      ASSERT_THROWS(cusp::io::write_binary_file(B, compressed_file_names[i]), cusp::not_implemented_exception);
+      continue;
+    }
+#endif
+#ifndef __CUSP_USE_ZSTD__
+    if (i == 1)
+    {
+      ASSERT_THROWS(cusp::io::write_binary_file(B, compressed_file_names[i]), cusp::not_implemented_exception);
+      continue;
+    }
+#endif
+
+    cusp::io::write_binary_file(B, compressed_file_names[i]);
+
+    SparseMatrix C;
+    cusp::io::read_binary_file(C, compressed_file_names[i]);
+
+    cusp::array2d<ValueType, cusp::host_memory> C_dense(C);
+    ASSERT_EQUAL(C_dense == B_dense, true);
+
+    // compressed files cannot be mapped
+    ASSERT_THROWS(cusp::io::binary_file file(compressed_file_names[i]), cusp::io_exception);
+
+    remove(compressed_file_names[i]);
+  }
+}
+DECLARE_SPARSE_MATRIX_UNITTEST(TestReadWriteBinaryFileCompressed);
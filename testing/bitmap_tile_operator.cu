@@ -0,0 +1,109 @@
+#include <unittest/unittest.h>
+
+#include <cusp/bitmap_tile_operator.h>
+#include <cusp/array1d.h>
+#include <cusp/array2d.h>
+#include <cusp/coo_matrix.h>
+#include <cusp/csr_matrix.h>
+#include <cusp/hyb_matrix.h>
+#include <cusp/multiply.h>
+#include <cusp/gallery/poisson.h>
+#include <cusp/gallery/random.h>
+
+template <typename MemorySpace, typename MatrixType>
+void CheckBitmapTileMultiply(const MatrixType& B)
+{
+    typedef typename MatrixType::value_type ValueType;
+
+    cusp::bitmap_tile_operator<int, ValueType, MemorySpace> A(B);
+
+    ASSERT_EQUAL(A.num_rows,    B.num_rows);
+    ASSERT_EQUAL(A.num_cols,    B.num_cols);
+    ASSERT_EQUAL(A.num_entries, B.num_entries);
+
+    // every entry is in a tile or in the tail
+    ASSERT_EQUAL(A.tile_values.size() + A.tail.num_entries, B.num_entries);
+    ASSERT_EQUAL(size_t(A.tile_value_offsets[A.num_tiles()]), A.tile_values.size());
+
+    cusp::array1d<ValueType, cusp::host_memory> x_h(B.num_cols);
+    for (size_t i = 0; i < x_h.size(); i++)
+        x_h[i] = ValueType(i % 7) - 3;
+
+    cusp::array1d<ValueType, cusp::host_memory> z_h(B.num_rows);
+    cusp::multiply(B, x_h, z_h);
+
+    cusp::array1d<ValueType, MemorySpace> x(x_h);
+    cusp::array1d<ValueType, MemorySpace> y(B.num_rows, ValueType(-1));
+
+    cusp::multiply(A, x, y);
+
+    ASSERT_ALMOST_EQUAL((cusp::array1d<ValueType, cusp::host_memory>(y)), z_h);
+
+    // a copy in the other memory space
+    cusp::bitmap_tile_operator<int, ValueType, cusp::host_memory> C(A);
+    cusp::array1d<ValueType, cusp::host_memory> w_h(B.num_rows, ValueType(-1));
+    cusp::multiply(C, x_h, w_h);
+
+    ASSERT_ALMOST_EQUAL(w_h, z_h);
+}
+
+// poisson5pt with dense blocks of several sizes, which do not line up
+// with the tiles, coupling distant unknowns
+void coupled_matrix(cusp::coo_matrix<int, float, cusp::host_memory>& A, const int nx, const int ny)
+{
+    cusp::csr_matrix<int, float, cusp::host_memory> P;
+    cusp::gallery::poisson5pt(P, nx, ny);
+
+    cusp::array2d<float, cusp::host_memory> D(P);
+
+    const int N = P.num_rows;
+    const int sizes[3] = {5, 12, 21};
+    const int starts[3][2] = {{3, N - 40}, {N / 2, 7}, {N - 30, N - 30}};
+
+    for (int b = 0; b < 3; b++)
+        for (int i = 0; i < sizes[b]; i++)
+            for (int j = 0; j < sizes[b]; j++)
+                D(starts[b][0] + i, starts[b][1] + j) = float((i + 2 * j) % 5 + 1);
+
+    A = D;
+}
+
+template <class MemorySpace>
+void TestBitmapTileOperator(void)
+{
+    cusp::coo_matrix<int, float, cusp::host_memory> B;
+    coupled_matrix(B, 12, 10);
+
+    cusp::bitmap_tile_operator<int, float, MemorySpace> A(B);
+    ASSERT_EQUAL(A.num_tiles() > 0, true);
+    ASSERT_EQUAL(A.tail.num_entries > 0, true);
+    CheckBitmapTileMultiply<MemorySpace>(B);
+
+    // any format in either memory space
+    CheckBitmapTileMultiply<MemorySpace>(cusp::hyb_matrix<int, float, MemorySpace>(B));
+
+    // everything in tiles, or everything in the tail
+    cusp::bitmap_tile_operator<int, float, MemorySpace> T(B, 1);
+    ASSERT_EQUAL(T.tail.num_entries, size_t(0));
+
+    cusp::bitmap_tile_operator<int, float, MemorySpace> U(B, 65);
+    ASSERT_EQUAL(U.num_tiles(), size_t(0));
+
+    cusp::csr_matrix<int, double, cusp::host_memory> Q;
+    cusp::gallery::poisson27pt(Q, 6, 5, 4);
+    CheckBitmapTileMultiply<MemorySpace>(Q);
+
+    // many empty rows
+    cusp::coo_matrix<int, double, cusp::host_memory> S;
+    cusp::gallery::random(300, 200, 250, S);
+    CheckBitmapTileMultiply<MemorySpace>(S);
+
+    // empty
+    cusp::csr_matrix<int, float, cusp::host_memory> E(4, 5, 0);
+    CheckBitmapTileMultiply<MemorySpace>(E);
+
+    cusp::array1d<float, MemorySpace> x(B.num_cols + 1);
+    cusp::array1d<float, MemorySpace> y(B.num_rows);
+    ASSERT_THROWS(cusp::multiply(A, x, y), cusp::invalid_input_exception);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestBitmapTileOperator);
@@ -1,5 +1,6 @@
 #include <unittest/unittest.h>
 
+#include <cusp/array2d.h>
 #include <cusp/blas.h>
 
 
@@ -224,6 +225,32 @@ void TestDot(void)
 }
 DECLARE_HOST_DEVICE_UNITTEST(TestDot);
 
+void TestDotLargeHost(void)
+{
+    // large enough for the host reductions to run in parallel
+    const size_t N = 100000;
+
+    cusp::array1d<float, cusp::host_memory> x(N);
+    cusp::array1d<float, cusp::host_memory> y(N);
+
+    float expected = 0;
+    for(size_t i = 0; i < N; i++)
+    {
+        x[i] = int(i % 5) - 2;
+        y[i] = int(i % 3);
+        expected += x[i] * y[i];
+    }
+
+    ASSERT_EQUAL(cusp::blas::dot(x, y), expected);
+    ASSERT_EQUAL(cusp::blas::nrm1(x), 120000.0f);
+    ASSERT_EQUAL(cusp::blas::nrmmax(x), 2.0f);
+
+    cusp::blas::axpy(x, y, 2.0f);
+    ASSERT_EQUAL(y[7], 2.0f * 0 + 1);
+    ASSERT_EQUAL(y[N - 1], 2.0f * (int((N - 1) % 5) - 2) + int((N - 1) % 3));
+}
+DECLARE_UNITTEST(TestDotLargeHost);
+
 
 template <class MemorySpace>
 void TestDotc(void)
@@ -253,6 +280,260 @@ void TestDotc(void)
 DECLARE_HOST_DEVICE_UNITTEST(TestDotc);
 
 
+template <class MemorySpace>
+void TestDot2(void)
+{
+    typedef typename cusp::array1d<float, MemorySpace>       Array;
+    typedef typename cusp::array1d<float, MemorySpace>::view View;
+
+    Array x(4);
+    Array y(4);
+    Array z(4);
+
+    x[0] =  7.0f;   y[0] =  0.0f;   z[0] =  1.0f;
+    x[1] =  5.0f;   y[1] = -2.0f;   z[1] =  1.0f;
+    x[2] =  4.0f;   y[2] =  0.0f;   z[2] = -1.0f;
+    x[3] = -3.0f;   y[3] =  5.0f;   z[3] =  2.0f;
+
+    thrust::pair<float,float> dots = cusp::blas::dot2(x, y, z);
+
+    ASSERT_EQUAL(dots.first,  -25.0f);
+    ASSERT_EQUAL(dots.second,   2.0f);
+
+    dots = cusp::blas::dotc2(View(x), View(y), View(x));
+
+    ASSERT_EQUAL(dots.first,  -25.0f);
+    ASSERT_EQUAL(dots.second,  99.0f);
+
+    // test size checking
+    Array w(3);
+    ASSERT_THROWS(cusp::blas::dot2(x, y, w), cusp::invalid_input_exception);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestDot2);
+
+
+template <class MemorySpace>
+void TestComplexDotc2(void)
+{
+    typedef cusp::complex<float>                    ValueType;
+    typedef cusp::array1d<ValueType, MemorySpace>   Array;
+
+    Array x(2);
+    Array y(2);
+
+    x[0] = ValueType(1.0f, 2.0f);   y[0] = ValueType(3.0f, 0.0f);
+    x[1] = ValueType(0.0f, 1.0f);   y[1] = ValueType(1.0f, 1.0f);
+
+    // conjugate(x)^T y = (1 - 2i) 3 + (-i)(1 + i) = 4 - 7i and ||x||^2 = 6
+    thrust::pair<ValueType,ValueType> dots = cusp::blas::dotc2(x, y, x);
+
+    ASSERT_EQUAL(dots.first,  ValueType(4.0f, -7.0f));
+    ASSERT_EQUAL(dots.second, ValueType(6.0f,  0.0f));
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestComplexDotc2);
+
+
+template <class MemorySpace>
+void TestAxpyDot(void)
+{
+    typedef typename cusp::array1d<float, MemorySpace>       Array;
+    typedef typename cusp::array1d<float, MemorySpace>::view View;
+
+    Array x(4);
+    Array y(4);
+    Array z(4, 1.0f);
+
+    x[0] =  7.0f;   y[0] =  0.0f;
+    x[1] =  5.0f;   y[1] = -2.0f;
+    x[2] =  4.0f;   y[2] =  0.0f;
+    x[3] = -3.0f;   y[3] =  5.0f;
+
+    // y = 2 * x + y = [14, 8, 8, -1]
+    ASSERT_EQUAL(cusp::blas::axpy_dot(x, y, z, 2.0f), 29.0f);
+
+    ASSERT_EQUAL(y[0], 14.0f);
+    ASSERT_EQUAL(y[1],  8.0f);
+    ASSERT_EQUAL(y[2],  8.0f);
+    ASSERT_EQUAL(y[3], -1.0f);
+
+    // y = y - 2 * x = [0, -2, 0, 5] and its squared norm
+    ASSERT_EQUAL(cusp::blas::axpy_dotc(View(x), View(y), View(y), -2.0f), 29.0f);
+
+    ASSERT_EQUAL(y[0],  0.0f);
+    ASSERT_EQUAL(y[1], -2.0f);
+    ASSERT_EQUAL(y[2],  0.0f);
+    ASSERT_EQUAL(y[3],  5.0f);
+
+    // test size checking
+    Array w(3);
+    ASSERT_THROWS(cusp::blas::axpy_dot(x, w, w, 1.0f), cusp::invalid_input_exception);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestAxpyDot);
+
+
+template <typename MemorySpace, typename Orientation>
+void TestMdotOrientation(void)
+{
+    // enough rows and columns for several blocks and column groups
+    const int n = 1000;
+    const int k = 7;
+
+    cusp::array1d<float, cusp::host_memory> x(n);
+    cusp::array2d<float, cusp::host_memory> Y(n, k);
+    cusp::array1d<float, cusp::host_memory> expected(k, 0.0f);
+
+    for (int i = 0; i < n; i++)
+    {
+        x[i] = float(i % 5 - 2);
+
+        for (int j = 0; j < k; j++)
+        {
+            Y(i,j) = float((i + j) % 3 - 1);
+            expected[j] += x[i] * Y(i,j);
+        }
+    }
+
+    cusp::array1d<float, MemorySpace> x_test(x);
+    cusp::array2d<float, MemorySpace, Orientation> Y_test(Y);
+
+    // results in the memory space of Y and on the host
+    cusp::array1d<float, MemorySpace>       result1(k);
+    cusp::array1d<float, cusp::host_memory> result2(k);
+
+    cusp::blas::mdot(x_test, Y_test, result1);
+    cusp::blas::mdotc(x_test, Y_test, result2);
+
+    ASSERT_EQUAL(result1, expected);
+    ASSERT_EQUAL(result2, expected);
+
+    // test size checking
+    cusp::array1d<float, MemorySpace> w(k - 1);
+    ASSERT_THROWS(cusp::blas::mdot(x_test, Y_test, w), cusp::invalid_input_exception);
+}
+
+template <class MemorySpace>
+void TestMdot(void)
+{
+    TestMdotOrientation<MemorySpace, cusp::row_major>();
+    TestMdotOrientation<MemorySpace, cusp::column_major>();
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestMdot);
+
+
+template <class MemorySpace>
+void TestReproducibleDot(void)
+{
+    // several chunks of the reproducible reduction and a second pass
+    const size_t N = 100003;
+
+    cusp::array1d<float, cusp::host_memory> x(N);
+    cusp::array1d<float, cusp::host_memory> y(N);
+
+    float expected = 0;
+    for(size_t i = 0; i < N; i++)
+    {
+        x[i] = int(i % 5) - 2;
+        y[i] = int(i % 3);
+        expected += x[i] * y[i];
+    }
+
+    cusp::array1d<float, MemorySpace> x_test(x);
+    cusp::array1d<float, MemorySpace> y_test(y);
+
+    // integer terms are summed exactly in any order
+    ASSERT_EQUAL(cusp::blas::dot (x_test, y_test, cusp::reproducible_reduction), expected);
+    ASSERT_EQUAL(cusp::blas::dotc(x_test, y_test, cusp::reproducible_reduction), expected);
+    ASSERT_EQUAL(cusp::blas::nrm2(y_test, cusp::reproducible_reduction), float(std::sqrt(float(5 * (N / 3)))));
+
+    // terms which round differently in different orders
+    for(size_t i = 0; i < N; i++)
+    {
+        x[i] = 1.0f / (i + 1);
+        y[i] = (i % 2) ? 3.1f : -2.7f;
+    }
+
+    x_test = x;
+    y_test = y;
+
+    const float dot  = cusp::blas::dot(x_test, y_test, cusp::reproducible_reduction);
+    const float norm = cusp::blas::nrm2(x_test, cusp::reproducible_reduction);
+
+    for(int run = 0; run < 3; run++)
+    {
+        ASSERT_EQUAL(cusp::blas::dot(x_test, y_test, cusp::reproducible_reduction), dot);
+        ASSERT_EQUAL(cusp::blas::nrm2(x_test, cusp::reproducible_reduction), norm);
+    }
+
+    ASSERT_ALMOST_EQUAL(cusp::blas::dot(x_test, y_test, cusp::fast_reduction), dot);
+
+    {
+        cusp::reduction_scope scope(cusp::reproducible_reduction);
+
+        ASSERT_EQUAL(cusp::current_reduction_mode(), cusp::reproducible_reduction);
+        ASSERT_EQUAL(cusp::blas::dot(x_test, y_test), dot);
+        ASSERT_EQUAL(cusp::blas::nrm2(x_test), norm);
+
+        // the fused reductions fall back to separate reproducible passes
+        thrust::pair<float,float> dots = cusp::blas::dot2(x_test, y_test, x_test);
+        ASSERT_EQUAL(dots.first,  dot);
+        ASSERT_EQUAL(dots.second, cusp::blas::dot(x_test, x_test, cusp::reproducible_reduction));
+    }
+
+    ASSERT_EQUAL(cusp::current_reduction_mode(), cusp::fast_reduction);
+
+    // test size checking
+    cusp::array1d<float, MemorySpace> w(3);
+    ASSERT_THROWS(cusp::blas::dot(x_test, w, cusp::reproducible_reduction), cusp::invalid_input_exception);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestReproducibleDot);
+
+
+template <class MemorySpace>
+void TestCompensatedDot(void)
+{
+    // (1e8, 1, -1e8) triples whose plain float sums lose the small terms
+    const size_t N = 3 * 10000;
+
+    cusp::array1d<float, cusp::host_memory> x(N);
+    cusp::array1d<float, cusp::host_memory> y(N, 1.0f);
+
+    for(size_t i = 0; i < N; i += 3)
+    {
+        x[i + 0] =  1e8f;
+        x[i + 1] =  1.0f;
+        x[i + 2] = -1e8f;
+    }
+
+    cusp::array1d<float, MemorySpace> x_test(x);
+    cusp::array1d<float, MemorySpace> y_test(y);
+
+    ASSERT_EQUAL(cusp::blas::dot (x_test, y_test, cusp::compensated_reduction), 10000.0f);
+    ASSERT_EQUAL(cusp::blas::dotc(x_test, y_test, cusp::compensated_reduction), 10000.0f);
+
+    // products whose rounding errors cancel the sum: (1 + e)(1 - e) - 1 = -e^2
+    const float e = 1.0f / 8192;
+
+    cusp::array1d<float, MemorySpace> a(2);
+    cusp::array1d<float, MemorySpace> b(2);
+    a[0] = 1 + e;  b[0] =  1 - e;
+    a[1] = 1;      b[1] = -1;
+
+    ASSERT_EQUAL(cusp::blas::dot(a, b, cusp::compensated_reduction), -e * e);
+
+    {
+        cusp::reduction_scope scope(cusp::compensated_reduction);
+
+        ASSERT_EQUAL(cusp::blas::dot(x_test, y_test), 10000.0f);
+        ASSERT_EQUAL(cusp::blas::nrm2(b), float(std::sqrt(2.0f - 2 * e + e * e)));
+
+        thrust::pair<float,float> dots = cusp::blas::dot2(x_test, y_test, y_test);
+        ASSERT_EQUAL(dots.first,  10000.0f);
+        ASSERT_EQUAL(dots.second, 10000.0f);
+    }
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestCompensatedDot);
+
+
 template <class MemorySpace>
 void TestFill(void)
 {
@@ -449,3 +730,191 @@ void TestScal(void)
 }
 DECLARE_HOST_DEVICE_UNITTEST(TestScal);
 
+
+
+template <typename MemorySpace, typename Orientation>
+void TestGemvOrientation(void)
+{
+    typedef typename cusp::array1d<float, MemorySpace> Array;
+
+    cusp::array2d<float, MemorySpace, Orientation> A(3, 2);
+    A(0,0) = 1.0f;  A(0,1) = 2.0f;
+    A(1,0) = 3.0f;  A(1,1) = 4.0f;
+    A(2,0) = 5.0f;  A(2,1) = 6.0f;
+
+    Array x(2);
+    x[0] =  1.0f;
+    x[1] = -1.0f;
+
+    Array y(3, -7.0f);
+
+    cusp::blas::gemv(A, x, y);
+
+    ASSERT_EQUAL(y[0], -1.0f);
+    ASSERT_EQUAL(y[1], -1.0f);
+    ASSERT_EQUAL(y[2], -1.0f);
+
+    y[0] = 1.0f;
+    y[1] = 2.0f;
+    y[2] = 3.0f;
+
+    cusp::blas::gemv(A, x, typename Array::view(y), 2.0f, 1.0f);
+
+    ASSERT_EQUAL(y[0], -1.0f);
+    ASSERT_EQUAL(y[1],  0.0f);
+    ASSERT_EQUAL(y[2],  1.0f);
+
+    // test size checking
+    Array w(2);
+    ASSERT_THROWS(cusp::blas::gemv(A, x, w), cusp::invalid_input_exception);
+}
+
+template <class MemorySpace>
+void TestGemv(void)
+{
+    TestGemvOrientation<MemorySpace, cusp::row_major>();
+    TestGemvOrientation<MemorySpace, cusp::column_major>();
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestGemv);
+
+
+template <typename MemorySpace, typename Orientation1, typename Orientation2, typename Orientation3>
+void TestGemmOrientation(void)
+{
+    // large enough to span several tiles in each dimension
+    const int m = 70;
+    const int n = 40;
+    const int k = 50;
+
+    cusp::array2d<float, cusp::host_memory> A(m, k);
+    cusp::array2d<float, cusp::host_memory> B(k, n);
+    cusp::array2d<float, cusp::host_memory> C(m, n, 0.0f);
+
+    for (int i = 0; i < m; i++)
+        for (int j = 0; j < k; j++)
+            A(i,j) = float((i + 2 * j) % 7 - 3);
+
+    for (int i = 0; i < k; i++)
+        for (int j = 0; j < n; j++)
+            B(i,j) = float((3 * i + j) % 5 - 2);
+
+    for (int i = 0; i < m; i++)
+        for (int j = 0; j < n; j++)
+            for (int l = 0; l < k; l++)
+                C(i,j) += A(i,l) * B(l,j);
+
+    cusp::array2d<float, MemorySpace, Orientation1> A_test(A);
+    cusp::array2d<float, MemorySpace, Orientation2> B_test(B);
+    cusp::array2d<float, MemorySpace, Orientation3> C_test;
+    C_test.resize_pitched(m, n);
+
+    cusp::blas::gemm(A_test, B_test, C_test);
+
+    ASSERT_EQUAL_QUIET((cusp::array2d<float, cusp::host_memory>(C_test)), C);
+
+    // C = 3 * A * B - 2 * C
+    cusp::blas::gemm(A_test, B_test, C_test, 3.0f, -2.0f);
+
+    ASSERT_EQUAL_QUIET((cusp::array2d<float, cusp::host_memory>(C_test)), C);
+}
+
+template <class MemorySpace>
+void TestGemm(void)
+{
+    TestGemmOrientation<MemorySpace, cusp::row_major,    cusp::row_major,    cusp::row_major>();
+    TestGemmOrientation<MemorySpace, cusp::column_major, cusp::row_major,    cusp::row_major>();
+    TestGemmOrientation<MemorySpace, cusp::row_major,    cusp::column_major, cusp::row_major>();
+    TestGemmOrientation<MemorySpace, cusp::row_major,    cusp::row_major,    cusp::column_major>();
+    TestGemmOrientation<MemorySpace, cusp::column_major, cusp::column_major, cusp::column_major>();
+
+    // test size checking
+    cusp::array2d<float, MemorySpace> A(3, 2, 1.0f);
+    cusp::array2d<float, MemorySpace> B(3, 2, 1.0f);
+    cusp::array2d<float, MemorySpace> C(3, 2, 1.0f);
+    ASSERT_THROWS(cusp::blas::gemm(A, B, C), cusp::invalid_input_exception);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestGemm);
+
+
+template <typename MemorySpace, typename Orientation1, typename Orientation2>
+void TestTrsmOrientation(void)
+{
+    cusp::array2d<float, cusp::host_memory> A(3, 3, 99.0f);
+    A(0,0) = 2.0f;
+    A(1,0) = 1.0f;  A(1,1) = 4.0f;
+    A(2,0) = 3.0f;  A(2,1) = 2.0f;  A(2,2) = 1.0f;
+
+    // the upper triangle of the transpose
+    cusp::array2d<float, cusp::host_memory> U(3, 3, 99.0f);
+    for (int i = 0; i < 3; i++)
+        for (int j = 0; j <= i; j++)
+            U(j,i) = A(i,j);
+
+    // B = L * X for X = [1 2; -1 0; 2 1]
+    cusp::array2d<float, cusp::host_memory> X(3, 2);
+    X(0,0) =  1.0f;  X(0,1) = 2.0f;
+    X(1,0) = -1.0f;  X(1,1) = 0.0f;
+    X(2,0) =  2.0f;  X(2,1) = 1.0f;
+
+    cusp::array2d<float, cusp::host_memory> B(3, 2, 0.0f);
+    for (int i = 0; i < 3; i++)
+        for (int j = 0; j < 2; j++)
+            for (int l = 0; l <= i; l++)
+                B(i,j) += A(i,l) * X(l,j);
+
+    {
+        cusp::array2d<float, MemorySpace, Orientation1> A_test(A);
+        cusp::array2d<float, MemorySpace, Orientation2> B_test(B);
+
+        cusp::blas::trsm(A_test, B_test, true);
+
+        ASSERT_EQUAL_QUIET((cusp::array2d<float, cusp::host_memory>(B_test)), X);
+    }
+
+    // B = U * X with U = L^T, solved in reverse order
+    cusp::array2d<float, cusp::host_memory> C(3, 2, 0.0f);
+    for (int i = 0; i < 3; i++)
+        for (int j = 0; j < 2; j++)
+            for (int l = i; l < 3; l++)
+                C(i,j) += U(i,l) * X(l,j);
+
+    {
+        cusp::array2d<float, MemorySpace, Orientation1> U_test(U);
+        cusp::array2d<float, MemorySpace, Orientation2> C_test(C);
+
+        cusp::blas::trsm(U_test, C_test, false);
+
+        ASSERT_EQUAL_QUIET((cusp::array2d<float, cusp::host_memory>(C_test)), X);
+    }
+
+    // with a unit diagonal B = X + strictly lower part of L * X
+    cusp::array2d<float, cusp::host_memory> D(X);
+    for (int i = 0; i < 3; i++)
+        for (int j = 0; j < 2; j++)
+            for (int l = 0; l < i; l++)
+                D(i,j) += A(i,l) * X(l,j);
+
+    {
+        cusp::array2d<float, MemorySpace, Orientation1> A_test(A);
+        cusp::array2d<float, MemorySpace, Orientation2> D_test(D);
+
+        cusp::blas::trsm(A_test, D_test, true, true);
+
+        ASSERT_EQUAL_QUIET((cusp::array2d<float, cusp::host_memory>(D_test)), X);
+    }
+}
+
+template <class MemorySpace>
+void TestTrsm(void)
+{
+    TestTrsmOrientation<MemorySpace, cusp::row_major,    cusp::row_major>();
+    TestTrsmOrientation<MemorySpace, cusp::row_major,    cusp::column_major>();
+    TestTrsmOrientation<MemorySpace, cusp::column_major, cusp::row_major>();
+    TestTrsmOrientation<MemorySpace, cusp::column_major, cusp::column_major>();
+
+    // test size checking
+    cusp::array2d<float, MemorySpace> A(3, 2, 1.0f);
+    cusp::array2d<float, MemorySpace> B(3, 2, 1.0f);
+    ASSERT_THROWS(cusp::blas::trsm(A, B, true), cusp::invalid_input_exception);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestTrsm);
@@ -0,0 +1,58 @@
+#include <unittest/unittest.h>
+
+#include <cusp/csr_matrix.h>
+#include <cusp/transpose.h>
+#include <cusp/gallery/block.h>
+
+template <class MemorySpace>
+void TestRandomBlock(void)
+{
+    cusp::csr_matrix<int, float, MemorySpace> A;
+    cusp::gallery::random_block(A, 200, 3, 6, 2);
+
+    cusp::csr_matrix<int, float, cusp::host_memory> B(A);
+
+    ASSERT_EQUAL(B.num_rows, 600);
+    ASSERT_EQUAL(B.num_cols, 600);
+
+    // dense 3x3 blocks, about 7 per block row, within 12 block rows of the diagonal
+    ASSERT_EQUAL(B.num_entries % 9, 0);
+    ASSERT_EQUAL(B.num_entries / 9 > 200 * 4, true);
+    ASSERT_EQUAL(B.num_entries / 9 <= 200 * 7, true);
+
+    for (int i = 0; i < B.num_rows; i++)
+    {
+        const int length = B.row_offsets[i + 1] - B.row_offsets[i];
+
+        ASSERT_EQUAL(length % 3, 0);
+
+        for (int jj = B.row_offsets[i]; jj < B.row_offsets[i + 1]; jj++)
+        {
+            const int j = B.column_indices[jj];
+
+            if (jj > B.row_offsets[i])
+                ASSERT_EQUAL(B.column_indices[jj - 1] < j, true);
+
+            ASSERT_EQUAL(std::abs(j / 3 - i / 3) <= 12, true);
+            ASSERT_EQUAL(B.values[jj], j == i ? 1.0f : -1.0f / length);
+        }
+    }
+
+    // the block pattern is symmetric
+    cusp::csr_matrix<int, float, cusp::host_memory> T;
+    cusp::transpose(B, T);
+    ASSERT_EQUAL(T.row_offsets,    B.row_offsets);
+    ASSERT_EQUAL(T.column_indices, B.column_indices);
+
+    // the same matrix in the other memory space
+    cusp::csr_matrix<int, float, cusp::host_memory> C;
+    cusp::gallery::random_block(C, 200, 3, 6, 2);
+    ASSERT_EQUAL(C.column_indices, B.column_indices);
+
+    // block diagonal
+    cusp::gallery::random_block(A, 10, 4, 0);
+    ASSERT_EQUAL(A.num_entries, 10 * 16);
+
+    ASSERT_THROWS(cusp::gallery::random_block(A, 10, 0, 2), cusp::invalid_input_exception);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestRandomBlock);
@@ -0,0 +1,93 @@
+#include <unittest/unittest.h>
+
+#include <cusp/gallery/poisson.h>
+#include <cusp/array2d.h>
+#include <cusp/csr_matrix.h>
+#include <cusp/multiply.h>
+#include <cusp/krylov/block_cg.h>
+#include <cusp/krylov/cg.h>
+#include <cusp/precond/diagonal.h>
+
+template <class MemorySpace>
+void TestBlockConjugateGradient(void)
+{
+    cusp::csr_matrix<int, float, MemorySpace> A;
+
+    cusp::gallery::poisson5pt(A, 20, 20);
+
+    const size_t K = 8;
+
+    // random right-hand sides, column 3 is scaled to converge earlier
+    cusp::array1d<float, cusp::host_memory> samples = unittest::random_samples<float>(A.num_rows * K);
+    cusp::array2d<float, cusp::host_memory, cusp::column_major> B_host(A.num_rows, K);
+    for (size_t j = 0; j < K; j++)
+        for (size_t i = 0; i < A.num_rows; i++)
+            B_host(i,j) = samples[j * A.num_rows + i] * (j == 3 ? 1e-3f : 1.0f);
+
+    cusp::array2d<float, MemorySpace, cusp::column_major> B(B_host);
+    cusp::array2d<float, MemorySpace, cusp::column_major> X(A.num_rows, K, 0.0f);
+
+    cusp::krylov::block_monitor<float> monitor(B, 200, 1e-4);
+
+    cusp::krylov::block_cg(A, X, B, monitor);
+
+    ASSERT_EQUAL(monitor.converged(), true);
+
+    // each column needs fewer iterations than cg on its own
+    cusp::default_monitor<float> single_monitor(B.column(0), 200, 1e-4);
+    cusp::array1d<float, MemorySpace> x(A.num_rows, 0.0f);
+    cusp::array1d<float, MemorySpace> b(B.column(0).begin(), B.column(0).end());
+    cusp::krylov::cg(A, x, b, single_monitor);
+
+    ASSERT_EQUAL(monitor.iteration_count() <= single_monitor.iteration_count(), true);
+
+    // check residual norms
+    for (size_t j = 0; j < K; j++)
+    {
+        cusp::array1d<float, MemorySpace> residual(A.num_rows, 0.0f);
+        cusp::multiply(A, X.column(j), residual);
+        cusp::blas::axpby(residual, B.column(j), residual, -1.0f, 1.0f);
+
+        ASSERT_EQUAL(cusp::blas::nrm2(residual) < 1e-3 * cusp::blas::nrm2(B.column(j)), true);
+    }
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestBlockConjugateGradient);
+
+template <class MemorySpace>
+void TestBlockConjugateGradientPreconditionedDeflation(void)
+{
+    cusp::csr_matrix<int, float, MemorySpace> A;
+
+    cusp::gallery::poisson5pt(A, 20, 20);
+
+    const size_t K = 4;
+
+    // column 1 is zero and converges immediately
+    cusp::array1d<float, cusp::host_memory> samples = unittest::random_samples<float>(A.num_rows * K);
+    cusp::array2d<float, cusp::host_memory, cusp::column_major> B_host(A.num_rows, K);
+    for (size_t j = 0; j < K; j++)
+        for (size_t i = 0; i < A.num_rows; i++)
+            B_host(i,j) = (j == 1) ? 0.0f : samples[j * A.num_rows + i];
+
+    cusp::array2d<float, MemorySpace, cusp::column_major> B(B_host);
+    cusp::array2d<float, MemorySpace, cusp::column_major> X(A.num_rows, K, 0.0f);
+
+    cusp::precond::diagonal<float, MemorySpace> M(A);
+    cusp::krylov::block_monitor<float> monitor(B, 200, 1e-4);
+
+    cusp::krylov::block_cg(A, X, B, monitor, M);
+
+    ASSERT_EQUAL(monitor.converged(), true);
+    ASSERT_EQUAL(monitor.iteration_count(1), 0);
+    ASSERT_EQUAL(cusp::blas::nrm2(X.column(1)), 0.0f);
+
+    for (size_t j = 0; j < K; j++)
+    {
+        cusp::array1d<float, MemorySpace> residual(A.num_rows, 0.0f);
+        cusp::multiply(A, X.column(j), residual);
+        cusp::blas::axpby(residual, B.column(j), residual, -1.0f, 1.0f);
+
+        ASSERT_EQUAL(cusp::blas::nrm2(residual) <= 1e-3 * cusp::blas::nrm2(B.column(j)), true);
+    }
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestBlockConjugateGradientPreconditionedDeflation);
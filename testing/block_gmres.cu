@@ -0,0 +1,56 @@
+#include <unittest/unittest.h>
+
+#include <cusp/gallery/poisson.h>
+#include <cusp/array2d.h>
+#include <cusp/csr_matrix.h>
+#include <cusp/multiply.h>
+#include <cusp/krylov/block_gmres.h>
+
+template <class MemorySpace>
+void TestBlockGeneralizedMinimumResidual(void)
+{
+    // nonsymmetric convection-diffusion operator
+    cusp::csr_matrix<int, float, cusp::host_memory> A_host;
+    cusp::gallery::poisson5pt(A_host, 20, 20);
+    for (size_t i = 0; i < A_host.num_rows; i++)
+        for (int jj = A_host.row_offsets[i]; jj < A_host.row_offsets[i + 1]; jj++)
+            if (A_host.column_indices[jj] == int(i) - 1)
+                A_host.values[jj] = -1.4f;
+            else if (A_host.column_indices[jj] == int(i) + 1)
+                A_host.values[jj] = -0.6f;
+
+    cusp::csr_matrix<int, float, MemorySpace> A(A_host);
+
+    const size_t K = 6;
+
+    // column 2 is zero and converges immediately
+    cusp::array1d<float, cusp::host_memory> samples = unittest::random_samples<float>(A.num_rows * K);
+    cusp::array2d<float, cusp::host_memory, cusp::column_major> B_host(A.num_rows, K);
+    for (size_t j = 0; j < K; j++)
+        for (size_t i = 0; i < A.num_rows; i++)
+            B_host(i,j) = (j == 2) ? 0.0f : samples[j * A.num_rows + i];
+
+    cusp::array2d<float, MemorySpace, cusp::column_major> B(B_host);
+
+    for (size_t restart = 5; restart <= 20; restart += 15)
+    {
+        cusp::array2d<float, MemorySpace, cusp::column_major> X(A.num_rows, K, 0.0f);
+
+        cusp::krylov::block_monitor<float> monitor(B, 400, 1e-4);
+
+        cusp::krylov::block_gmres(A, X, B, restart, monitor);
+
+        ASSERT_EQUAL(monitor.converged(), true);
+        ASSERT_EQUAL(monitor.iteration_count(2), 0);
+
+        for (size_t j = 0; j < K; j++)
+        {
+            cusp::array1d<float, MemorySpace> residual(A.num_rows, 0.0f);
+            cusp::multiply(A, X.column(j), residual);
+            cusp::blas::axpby(residual, B.column(j), residual, -1.0f, 1.0f);
+
+            ASSERT_EQUAL(cusp::blas::nrm2(residual) <= 1e-3 * cusp::blas::nrm2(B.column(j)), true);
+        }
+    }
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestBlockGeneralizedMinimumResidual);
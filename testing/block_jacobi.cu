@@ -0,0 +1,202 @@
+#include <unittest/unittest.h>
+
+#include <cusp/precond/block_jacobi.h>
+#include <cusp/precond/diagonal.h>
+
+#include <cusp/gallery/poisson.h>
+#include <cusp/krylov/cg.h>
+#include <cusp/monitor.h>
+#include <cusp/multiply.h>
+
+#include <vector>
+
+// couples every pair of rows of the same part, and neighbouring rows of
+// different parts when coupled is set
+template <typename Matrix>
+void initialize_block_jacobi_matrix(Matrix& A, const std::vector<int>& parts, bool coupled)
+{
+    const int N = parts.size();
+
+    cusp::coo_matrix<int,float,cusp::host_memory> C(N, N, 0);
+    std::vector<int>   rows;
+    std::vector<int>   cols;
+    std::vector<float> vals;
+
+    for(int i = 0; i < N; i++)
+        for(int j = 0; j < N; j++)
+        {
+            if(parts[i] == parts[j])
+            {
+                rows.push_back(i);  cols.push_back(j);
+                vals.push_back(i == j ? 40.0f : float((i * 3 + j * 5) % 7) - 3.0f);
+            }
+            else if(coupled && (j == i + 1 || j == i - 1))
+            {
+                rows.push_back(i);  cols.push_back(j);  vals.push_back(-1.0f);
+            }
+        }
+
+    C.resize(N, N, rows.size());
+    for(size_t n = 0; n < rows.size(); n++)
+    {
+        C.row_indices[n] = rows[n];  C.column_indices[n] = cols[n];  C.values[n] = vals[n];
+    }
+
+    A = C;
+}
+
+// M (A x) = x when A is block diagonal
+template <typename Matrix, typename Preconditioner>
+void check_block_jacobi_inverse(const Matrix& A, const Preconditioner& M)
+{
+    typedef typename Matrix::memory_space Space;
+
+    cusp::array1d<float,cusp::host_memory> x(A.num_rows);
+    for(size_t i = 0; i < x.size(); i++)
+        x[i] = int(i % 5) - 2;
+
+    cusp::array1d<float,Space> d_x(x);
+    cusp::array1d<float,Space> b(A.num_rows);
+    cusp::array1d<float,Space> y(A.num_rows, 10.0f);
+
+    cusp::multiply(A, d_x, b);
+    M(b, y);
+
+    cusp::array1d<float,cusp::host_memory> h_y(y);
+    ASSERT_ALMOST_EQUAL(h_y, x);
+}
+
+template <class Space>
+void TestBlockJacobiConsecutive(void)
+{
+    // blocks of 1 to 6 rows use the fixed size kernels, 8 the general one
+    for(int bs = 1; bs <= 8; bs++)
+    {
+        const int N = 4 * bs;
+
+        std::vector<int> parts(N);
+        for(int i = 0; i < N; i++)
+            parts[i] = i / bs;
+
+        cusp::csr_matrix<int,float,Space> A;
+        initialize_block_jacobi_matrix(A, parts, false);
+
+        cusp::precond::block_jacobi<float,Space> M(A, bs);
+
+        ASSERT_EQUAL(M.num_rows,     N);
+        ASSERT_EQUAL(M.num_blocks(), 4);
+        ASSERT_EQUAL(M.block_size,   bs);
+        ASSERT_EQUAL(M.inverses.size(), 4 * bs * bs);
+
+        check_block_jacobi_inverse(A, M);
+    }
+
+    // the last block is smaller
+    std::vector<int> parts(10);
+    for(int i = 0; i < 10; i++)
+        parts[i] = i / 4;
+
+    cusp::csr_matrix<int,float,Space> A;
+    initialize_block_jacobi_matrix(A, parts, false);
+
+    cusp::precond::block_jacobi<float,Space> M(A, 4);
+
+    ASSERT_EQUAL(M.num_blocks(), 3);
+    ASSERT_EQUAL(M.block_size,   0);
+    ASSERT_EQUAL(M.inverses.size(), 4 * 4 + 4 * 4 + 2 * 2);
+
+    check_block_jacobi_inverse(A, M);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestBlockJacobiConsecutive);
+
+template <class Space>
+void TestBlockJacobiPartition(void)
+{
+    cusp::array1d<int,cusp::host_memory> h_parts(20);
+    std::vector<int> parts(20);
+    for(int i = 0; i < 20; i++)
+        h_parts[i] = parts[i] = (i * 7) % 5;
+
+    cusp::array1d<int,Space> d_parts(h_parts);
+
+    cusp::csr_matrix<int,float,Space> A;
+    cusp::csr_matrix<int,float,Space> B;
+    initialize_block_jacobi_matrix(A, parts, false);
+    initialize_block_jacobi_matrix(B, parts, true);
+
+    cusp::precond::block_jacobi<float,Space> M(A, d_parts);
+    cusp::precond::block_jacobi<float,Space> N(B, h_parts);
+
+    ASSERT_EQUAL(M.num_blocks(), 5);
+    ASSERT_EQUAL(M.block_size,   0);
+
+    check_block_jacobi_inverse(A, M);
+
+    // the entries coupling different blocks are ignored
+    cusp::array1d<float,Space> x = unittest::random_samples<float>(20);
+    cusp::array1d<float,Space> y(20);
+    cusp::array1d<float,Space> z(20);
+
+    M(x, y);
+    N(x, z);
+
+    cusp::array1d<float,cusp::host_memory> h_y(y);
+    cusp::array1d<float,cusp::host_memory> h_z(z);
+    ASSERT_ALMOST_EQUAL(h_y, h_z);
+
+    // copy to another memory space
+    cusp::precond::block_jacobi<float,cusp::host_memory> C(M);
+    ASSERT_EQUAL(C.num_blocks(), 5);
+    ASSERT_EQUAL(C.block_rows, M.block_rows);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestBlockJacobiPartition);
+
+template <class Space>
+void TestBlockJacobiPreconditionedCG(void)
+{
+    cusp::csr_matrix<int,float,Space> A;
+    cusp::gallery::poisson5pt(A, 32, 32);
+
+    cusp::array1d<float,Space> b = unittest::random_samples<float>(A.num_rows);
+
+    size_t diagonal_iterations;
+    {
+        cusp::precond::diagonal<float,Space> M(A);
+        cusp::array1d<float,Space> x(A.num_rows, 0.0f);
+        cusp::default_monitor<float> monitor(b, 500, 1e-5);
+        cusp::krylov::cg(A, x, b, monitor, M);
+        ASSERT_EQUAL(monitor.converged(), true);
+        diagonal_iterations = monitor.iteration_count();
+    }
+
+    {
+        // blocks of 4 consecutive grid points
+        cusp::precond::block_jacobi<float,Space> M(A, 4);
+        cusp::array1d<float,Space> x(A.num_rows, 0.0f);
+        cusp::default_monitor<float> monitor(b, 500, 1e-5);
+        cusp::krylov::cg(A, x, b, monitor, M);
+        ASSERT_EQUAL(monitor.converged(), true);
+        ASSERT_LEQUAL(monitor.iteration_count(), diagonal_iterations);
+    }
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestBlockJacobiPreconditionedCG);
+
+void TestBlockJacobiInvalidInput(void)
+{
+    // the second block is singular
+    cusp::coo_matrix<int,float,cusp::host_memory> A(4, 4, 7);
+    A.row_indices[0] = 0;  A.column_indices[0] = 0;  A.values[0] = 2.0f;
+    A.row_indices[1] = 0;  A.column_indices[1] = 1;  A.values[1] = 1.0f;
+    A.row_indices[2] = 1;  A.column_indices[2] = 1;  A.values[2] = 2.0f;
+    A.row_indices[3] = 2;  A.column_indices[3] = 2;  A.values[3] = 1.0f;
+    A.row_indices[4] = 2;  A.column_indices[4] = 3;  A.values[4] = 2.0f;
+    A.row_indices[5] = 3;  A.column_indices[5] = 2;  A.values[5] = 0.5f;
+    A.row_indices[6] = 3;  A.column_indices[6] = 3;  A.values[6] = 1.0f;
+
+    ASSERT_THROWS((cusp::precond::block_jacobi<float,cusp::host_memory>(A, 2)), cusp::runtime_exception);
+
+    cusp::array1d<int,cusp::host_memory> parts(3, 0);
+    ASSERT_THROWS((cusp::precond::block_jacobi<float,cusp::host_memory>(A, parts)), cusp::invalid_input_exception);
+    ASSERT_THROWS((cusp::precond::block_jacobi<float,cusp::host_memory>(A, 0)),     cusp::invalid_input_exception);
+}
+DECLARE_UNITTEST(TestBlockJacobiInvalidInput);
@@ -0,0 +1,160 @@
+#include <unittest/unittest.h>
+
+#include <cusp/graph/breadth_first_search.h>
+#include <cusp/graph/pseudo_peripheral.h>
+
+#include <cusp/array2d.h>
+#include <cusp/coo_matrix.h>
+#include <cusp/csr_matrix.h>
+#include <cusp/gallery/poisson.h>
+
+#include <thrust/extrema.h>
+
+// symmetric graph of a long path with a few chords and isolated vertices
+template <typename MatrixType>
+void initialize_bfs_graph(MatrixType& G)
+{
+    const int N = 300;
+    const int num_path = 290;
+
+    cusp::coo_matrix<int,float,cusp::host_memory> coo(N, N, 2 * (num_path - 1) + 2 * 29);
+
+    size_t n = 0;
+    for(int i = 0; i + 1 < num_path; i++)
+    {
+        coo.row_indices[n] = i;     coo.column_indices[n] = i + 1; coo.values[n++] = 1;
+        coo.row_indices[n] = i + 1; coo.column_indices[n] = i;     coo.values[n++] = 1;
+    }
+    for(int i = 0; i < 29; i++)
+    {
+        int u = (37 * i) % num_path;
+        int v = (u + 11 + 5 * i) % num_path;
+        coo.row_indices[n] = u; coo.column_indices[n] = v; coo.values[n++] = 1;
+        coo.row_indices[n] = v; coo.column_indices[n] = u; coo.values[n++] = 1;
+    }
+
+    coo.sort_by_row_and_column();
+
+    G = coo;
+}
+
+template <typename MatrixType>
+void CompareBreadthFirstSearch(const MatrixType& G_host, int src)
+{
+    typedef cusp::csr_matrix<int,float,cusp::device_memory> DeviceMatrix;
+
+    cusp::array1d<int,cusp::host_memory> reference(G_host.num_rows);
+    cusp::graph::breadth_first_search<false>(G_host, src, reference);
+
+    DeviceMatrix G(G_host);
+
+    cusp::spmspv_direction directions[3] = {cusp::spmspv_push, cusp::spmspv_pull, cusp::spmspv_auto};
+
+    for(int d = 0; d < 3; d++)
+    {
+        cusp::array1d<int,cusp::host_memory>   h_labels(G.num_rows);
+        cusp::array1d<int,cusp::device_memory> d_labels(G.num_rows);
+
+        cusp::graph::breadth_first_search<false>(G_host, src, h_labels, directions[d]);
+        cusp::graph::breadth_first_search<false>(G,      src, d_labels, directions[d]);
+
+        ASSERT_EQUAL(h_labels, reference);
+        ASSERT_EQUAL(d_labels, reference);
+    }
+
+    // each predecessor is a neighbor one level closer to the source
+    cusp::array1d<int,cusp::device_memory> d_parents(G.num_rows);
+    cusp::graph::breadth_first_search<true>(G, src, d_parents, cusp::spmspv_auto);
+
+    cusp::array1d<int,cusp::host_memory> parents(d_parents);
+
+    ASSERT_EQUAL(parents[src], -1);
+
+    for(size_t v = 0; v < G_host.num_rows; v++)
+    {
+        if(int(v) == src) continue;
+
+        if(reference[v] == -1)
+        {
+            ASSERT_EQUAL(parents[v], -1);
+            continue;
+        }
+
+        int p = parents[v];
+        ASSERT_EQUAL(reference[p], reference[v] - 1);
+
+        bool adjacent = false;
+        for(int jj = G_host.row_offsets[v]; jj < G_host.row_offsets[v + 1]; jj++)
+            if(G_host.column_indices[jj] == p)
+                adjacent = true;
+        ASSERT_EQUAL(adjacent, true);
+    }
+}
+
+void TestDirectionOptimizingBreadthFirstSearch(void)
+{
+    cusp::csr_matrix<int,float,cusp::host_memory> A;
+    cusp::gallery::poisson5pt(A, 21, 17);
+    CompareBreadthFirstSearch(A, 0);
+    CompareBreadthFirstSearch(A, 180);
+
+    cusp::csr_matrix<int,float,cusp::host_memory> B;
+    initialize_bfs_graph(B);
+    CompareBreadthFirstSearch(B, 7);
+    CompareBreadthFirstSearch(B, 295);
+
+    // the labels must match the number of vertices
+    cusp::array1d<int,cusp::host_memory> labels(A.num_rows - 1);
+    ASSERT_THROWS(cusp::graph::breadth_first_search<false>(A, 0, labels, cusp::spmspv_push),
+                  cusp::invalid_input_exception);
+}
+DECLARE_UNITTEST(TestDirectionOptimizingBreadthFirstSearch);
+
+template <class MemorySpace>
+void TestMultiSourceBreadthFirstSearch(void)
+{
+    cusp::csr_matrix<int,float,cusp::host_memory> G_host;
+    initialize_bfs_graph(G_host);
+
+    cusp::coo_matrix<int,float,MemorySpace> G(G_host);
+
+    cusp::array1d<int,cusp::host_memory> sources(5);
+    sources[0] = 0; sources[1] = 150; sources[2] = 289; sources[3] = 150; sources[4] = 296;
+
+    cusp::array2d<int,MemorySpace,cusp::column_major> levels;
+    cusp::graph::multi_source_breadth_first_search(G, cusp::array1d<int,MemorySpace>(sources), levels);
+
+    ASSERT_EQUAL(levels.num_rows, G.num_rows);
+    ASSERT_EQUAL(levels.num_cols, sources.size());
+
+    cusp::array2d<int,cusp::host_memory,cusp::column_major> L(levels);
+
+    for(size_t s = 0; s < sources.size(); s++)
+    {
+        cusp::array1d<int,cusp::host_memory> reference(G.num_rows);
+        cusp::graph::breadth_first_search<false>(G_host, sources[s], reference);
+
+        for(size_t v = 0; v < G.num_rows; v++)
+            ASSERT_EQUAL(L(v,s), reference[v]);
+    }
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestMultiSourceBreadthFirstSearch);
+
+template <class MemorySpace>
+void TestPseudoPeripheralVertex(void)
+{
+    // the corners of a grid are its peripheral vertices
+    cusp::csr_matrix<int,float,MemorySpace> G;
+    cusp::gallery::poisson5pt(G, 10, 10);
+
+    cusp::array1d<int,MemorySpace> levels(G.num_rows);
+    int x = cusp::graph::pseudo_peripheral_vertex(G, levels);
+
+    ASSERT_EQUAL(x == 0 || x == 9 || x == 90 || x == 99, true);
+    ASSERT_EQUAL(*thrust::max_element(levels.begin(), levels.end()), 18);
+
+    cusp::array1d<int,MemorySpace> reference(G.num_rows);
+    cusp::graph::breadth_first_search<false>(G, x, reference, cusp::spmspv_auto);
+    ASSERT_EQUAL(levels, reference);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestPseudoPeripheralVertex);
@@ -0,0 +1,222 @@
+#include <unittest/unittest.h>
+
+#include <cusp/bsr_matrix.h>
+#include <cusp/multiply.h>
+#include <cusp/verify.h>
+#include <cusp/gallery/poisson.h>
+
+// expands every entry of a scalar matrix into a dense block
+template <typename Matrix>
+void initialize_block_matrix(Matrix& A, size_t block_size, size_t nx, size_t ny)
+{
+    cusp::coo_matrix<int,float,cusp::host_memory> S;
+    cusp::gallery::poisson5pt(S, nx, ny);
+
+    const size_t bs = block_size;
+
+    cusp::coo_matrix<int,float,cusp::host_memory> B(S.num_rows * bs, S.num_cols * bs, S.num_entries * bs * bs);
+
+    size_t n = 0;
+    for(size_t k = 0; k < S.num_entries; k++)
+        for(size_t r = 0; r < bs; r++)
+            for(size_t c = 0; c < bs; c++, n++)
+            {
+                B.row_indices[n]    = S.row_indices[k]    * bs + r;
+                B.column_indices[n] = S.column_indices[k] * bs + c;
+                B.values[n]         = S.values[k] * (r == c ? 2.0f : 0.5f) + (r + 2 * c) % 3;
+            }
+
+    B.sort_by_row_and_column();
+
+    A = B;
+}
+
+template <class Space>
+void TestBsrMatrixBasicConstructor(void)
+{
+    cusp::bsr_matrix<int, float, Space> matrix(6, 9, 4, 3);
+
+    ASSERT_EQUAL(matrix.num_rows,              6);
+    ASSERT_EQUAL(matrix.num_cols,              9);
+    ASSERT_EQUAL(matrix.num_entries,          36);
+    ASSERT_EQUAL(matrix.block_size,            3);
+    ASSERT_EQUAL(matrix.num_block_rows(),      2);
+    ASSERT_EQUAL(matrix.num_blocks(),          4);
+    ASSERT_EQUAL(matrix.row_offsets.size(),    3);
+    ASSERT_EQUAL(matrix.column_indices.size(), 4);
+    ASSERT_EQUAL(matrix.values.size(),        36);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestBsrMatrixBasicConstructor);
+
+template <class Space>
+void TestBsrMatrixSwap(void)
+{
+    cusp::bsr_matrix<int, float, Space> A(2, 2, 1, 2);
+    cusp::bsr_matrix<int, float, Space> B(6, 3, 2, 3);
+
+    A.swap(B);
+
+    ASSERT_EQUAL(A.num_rows,              6);
+    ASSERT_EQUAL(A.num_cols,              3);
+    ASSERT_EQUAL(A.num_entries,          18);
+    ASSERT_EQUAL(A.block_size,            3);
+    ASSERT_EQUAL(A.num_blocks(),          2);
+
+    ASSERT_EQUAL(B.num_rows,              2);
+    ASSERT_EQUAL(B.num_cols,              2);
+    ASSERT_EQUAL(B.num_entries,           4);
+    ASSERT_EQUAL(B.block_size,            2);
+    ASSERT_EQUAL(B.num_blocks(),          1);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestBsrMatrixSwap);
+
+template <class Space>
+void TestBsrMatrixConversion(void)
+{
+    // [10  0 | 0  0]
+    // [ 0 20 | 0 30]
+    // [------+-----]
+    // [ 0  0 | 0  0]
+    // [ 0  0 |40  0]
+    cusp::coo_matrix<int, float, cusp::host_memory> S(4, 4, 4);
+    S.row_indices[0] = 0; S.column_indices[0] = 0; S.values[0] = 10;
+    S.row_indices[1] = 1; S.column_indices[1] = 1; S.values[1] = 20;
+    S.row_indices[2] = 1; S.column_indices[2] = 3; S.values[2] = 30;
+    S.row_indices[3] = 3; S.column_indices[3] = 2; S.values[3] = 40;
+
+    cusp::csr_matrix<int, float, Space> A(S);
+    cusp::bsr_matrix<int, float, Space> B(A, 2);
+
+    ASSERT_EQUAL(B.num_rows,       4);
+    ASSERT_EQUAL(B.num_cols,       4);
+    ASSERT_EQUAL(B.num_entries,   12);
+    ASSERT_EQUAL(B.block_size,     2);
+    ASSERT_EQUAL(B.num_blocks(),   3);
+    ASSERT_EQUAL(cusp::is_valid_matrix(B), true);
+
+    cusp::bsr_matrix<int, float, cusp::host_memory> H(B);
+
+    ASSERT_EQUAL(H.row_offsets[0], 0);
+    ASSERT_EQUAL(H.row_offsets[1], 2);
+    ASSERT_EQUAL(H.row_offsets[2], 3);
+
+    ASSERT_EQUAL(H.column_indices[0], 0);
+    ASSERT_EQUAL(H.column_indices[1], 1);
+    ASSERT_EQUAL(H.column_indices[2], 1);
+
+    ASSERT_EQUAL(H.values[ 0], 10); ASSERT_EQUAL(H.values[ 1],  0);
+    ASSERT_EQUAL(H.values[ 2],  0); ASSERT_EQUAL(H.values[ 3], 20);
+    ASSERT_EQUAL(H.values[ 4],  0); ASSERT_EQUAL(H.values[ 5],  0);
+    ASSERT_EQUAL(H.values[ 6],  0); ASSERT_EQUAL(H.values[ 7], 30);
+    ASSERT_EQUAL(H.values[ 8],  0); ASSERT_EQUAL(H.values[ 9],  0);
+    ASSERT_EQUAL(H.values[10], 40); ASSERT_EQUAL(H.values[11],  0);
+
+    // round trip through CSR and COO keeps the explicit zeros of the blocks
+    cusp::csr_matrix<int, float, Space> C(B);
+    cusp::coo_matrix<int, float, Space> D(B);
+
+    ASSERT_EQUAL(C.num_entries, 12);
+    ASSERT_EQUAL(D.num_entries, 12);
+    ASSERT_EQUAL(cusp::is_valid_matrix(C), true);
+    ASSERT_EQUAL(cusp::is_valid_matrix(D), true);
+
+    cusp::array2d<float, cusp::host_memory> A_dense(A);
+    cusp::array2d<float, cusp::host_memory> C_dense(C);
+    cusp::array2d<float, cusp::host_memory> D_dense(D);
+
+    ASSERT_EQUAL_QUIET(A_dense, C_dense);
+    ASSERT_EQUAL_QUIET(A_dense, D_dense);
+
+    // conversion from COO
+    cusp::coo_matrix<int, float, Space> E(S);
+    cusp::bsr_matrix<int, float, Space> F(E, 2);
+
+    ASSERT_EQUAL_QUIET(B.row_offsets,    F.row_offsets);
+    ASSERT_EQUAL_QUIET(B.column_indices, F.column_indices);
+    ASSERT_EQUAL_QUIET(B.values,         F.values);
+
+    // dimensions must be multiples of the block size
+    ASSERT_THROWS((cusp::bsr_matrix<int, float, Space>(A, 3)), cusp::format_conversion_exception);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestBsrMatrixConversion);
+
+void TestBsrMatrixHostDeviceConversion(void)
+{
+    cusp::csr_matrix<int, float, cusp::host_memory> A;
+    initialize_block_matrix(A, 3, 5, 4);
+
+    cusp::bsr_matrix<int, float, cusp::host_memory>   B(A, 3);
+    cusp::bsr_matrix<int, float, cusp::device_memory> C(cusp::csr_matrix<int, float, cusp::device_memory>(A), 3);
+
+    ASSERT_EQUAL_QUIET(B.row_offsets,    C.row_offsets);
+    ASSERT_EQUAL_QUIET(B.column_indices, C.column_indices);
+    ASSERT_EQUAL_QUIET(B.values,         C.values);
+
+    // the block size is preserved across memory spaces
+    cusp::bsr_matrix<int, float, cusp::device_memory> D(A, 3);
+    ASSERT_EQUAL(D.block_size,   3);
+    ASSERT_EQUAL(D.num_blocks(), B.num_blocks());
+}
+DECLARE_UNITTEST(TestBsrMatrixHostDeviceConversion);
+
+template <class Space>
+void CompareBsrSpMV(size_t block_size)
+{
+    cusp::csr_matrix<int, float, Space> A;
+    initialize_block_matrix(A, block_size, 7, 5);
+
+    cusp::bsr_matrix<int, float, Space> B(A, block_size);
+
+    ASSERT_EQUAL(B.num_blocks(), (7 * 5 * 5 - 2 * 7 - 2 * 5));
+
+    cusp::array1d<float, cusp::host_memory> x(A.num_cols);
+    for(size_t i = 0; i < x.size(); i++)
+        x[i] = int(i % 5) - 2;
+
+    cusp::array1d<float, Space> d_x(x);
+    cusp::array1d<float, Space> y(A.num_rows, 0.0f);
+    cusp::array1d<float, Space> z(A.num_rows, 10.0f);
+
+    cusp::multiply(A, d_x, y);
+    cusp::multiply(B, d_x, z);
+
+    ASSERT_EQUAL(z, y);
+
+    // multiply a block of vectors
+    cusp::array2d<float, cusp::host_memory> X(A.num_cols, 3);
+    for(size_t i = 0; i < X.num_rows; i++)
+        for(size_t j = 0; j < X.num_cols; j++)
+            X(i,j) = int((i + 2 * j) % 7) - 3;
+
+    cusp::array2d<float, Space> d_X(X);
+    cusp::array2d<float, Space> Y(A.num_rows, 3, 0.0f);
+    cusp::array2d<float, Space> Z(A.num_rows, 3, 10.0f);
+
+    cusp::multiply(A, d_X, Y);
+    cusp::multiply(B, d_X, Z);
+
+    ASSERT_EQUAL(Z.values, Y.values);
+}
+
+template <class Space>
+void TestBsrMatrixMultiply(void)
+{
+    // sizes 1 to 6 use the specialized kernels
+    for(size_t block_size = 1; block_size <= 7; block_size++)
+        CompareBsrSpMV<Space>(block_size);
+
+    // empty matrix
+    cusp::csr_matrix<int, float, Space> A(6, 6, 0);
+    thrust::fill(A.row_offsets.begin(), A.row_offsets.end(), 0);
+
+    cusp::bsr_matrix<int, float, Space> B(A, 3);
+    ASSERT_EQUAL(B.num_blocks(), 0);
+
+    cusp::array1d<float, Space> x(6, 1.0f);
+    cusp::array1d<float, Space> y(6, 10.0f);
+
+    cusp::multiply(B, x, y);
+
+    ASSERT_EQUAL(y, (cusp::array1d<float, Space>(6, 0.0f)));
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestBsrMatrixMultiply);
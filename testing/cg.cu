@@ -4,6 +4,8 @@
 #include <cusp/csr_matrix.h>
 #include <cusp/multiply.h>
 #include <cusp/krylov/cg.h>
+#include <cusp/distributed_matrix.h>
+#include <cusp/precond/diagonal.h>
 
 template <class MemorySpace>
 void TestConjugateGradient(void)
@@ -58,3 +60,148 @@ void TestConjugateGradientZeroResidual(void)
 }
 DECLARE_HOST_DEVICE_UNITTEST(TestConjugateGradientZeroResidual);
 
+
+template <class MemorySpace>
+void TestConjugateGradientWorkspace(void)
+{
+    cusp::csr_matrix<int, float, MemorySpace> A;
+
+    cusp::gallery::poisson5pt(A, 10, 10);
+
+    cusp::array1d<float, MemorySpace> b(A.num_rows, 1.0f);
+    cusp::array1d<float, MemorySpace> x0(A.num_rows, 0.0f);
+    cusp::array1d<float, MemorySpace> x1(A.num_rows, 0.0f);
+
+    cusp::identity_operator<float, MemorySpace> M(A.num_rows, A.num_rows);
+    cusp::krylov::workspace<float, MemorySpace> workspace;
+
+    // reference solve without a workspace
+    {
+        cusp::default_monitor<float> monitor(b, 20, 1e-4);
+        cusp::krylov::cg(A, x0, b, monitor, M);
+    }
+
+    {
+        cusp::default_monitor<float> monitor(b, 20, 1e-4);
+        cusp::krylov::cg(A, x1, b, monitor, M, workspace);
+    }
+
+    ASSERT_EQUAL(x1, x0);
+
+    // the second solve reuses the storage of the first
+    const float * y_ptr = thrust::raw_pointer_cast(&workspace.vector(0, A.num_rows)[0]);
+
+    cusp::blas::fill(x1, 0.0f);
+    {
+        cusp::default_monitor<float> monitor(b, 20, 1e-4);
+        cusp::krylov::cg(A, x1, b, monitor, M, workspace);
+    }
+
+    ASSERT_EQUAL(x1, x0);
+    ASSERT_EQUAL(thrust::raw_pointer_cast(&workspace.vector(0, A.num_rows)[0]) == y_ptr, true);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestConjugateGradientWorkspace);
+
+// a monitor unknown to cg, which selects the unfused iteration
+template <typename ValueType>
+struct plain_monitor : public cusp::default_monitor<ValueType>
+{
+    template <typename Vector>
+    plain_monitor(const Vector& b, size_t iteration_limit, ValueType relative_tolerance)
+        : cusp::default_monitor<ValueType>(b, iteration_limit, relative_tolerance) {}
+};
+
+template <class MemorySpace>
+void TestConjugateGradientFused(void)
+{
+    cusp::csr_matrix<int, float, MemorySpace> A;
+
+    cusp::gallery::poisson5pt(A, 10, 10);
+
+    cusp::array1d<float, MemorySpace> b(A.num_rows, 1.0f);
+
+    // identity preconditioner
+    {
+        cusp::array1d<float, MemorySpace> x0(A.num_rows, 0.0f);
+        cusp::array1d<float, MemorySpace> x1(A.num_rows, 0.0f);
+
+        plain_monitor<float>         monitor0(b, 50, 1e-5f);
+        cusp::default_monitor<float> monitor1(b, 50, 1e-5f);
+
+        cusp::krylov::cg(A, x0, b, monitor0);
+        cusp::krylov::cg(A, x1, b, monitor1);
+
+        ASSERT_EQUAL(monitor1.iteration_count(), monitor0.iteration_count());
+        ASSERT_ALMOST_EQUAL(x1, x0);
+    }
+
+    // diagonal preconditioner
+    {
+        cusp::array1d<float, MemorySpace> x0(A.num_rows, 0.0f);
+        cusp::array1d<float, MemorySpace> x1(A.num_rows, 0.0f);
+
+        plain_monitor<float>         monitor0(b, 50, 1e-5f);
+        cusp::default_monitor<float> monitor1(b, 50, 1e-5f);
+
+        cusp::precond::diagonal<float, MemorySpace> M(A);
+
+        cusp::krylov::cg(A, x0, b, monitor0, M);
+        cusp::krylov::cg(A, x1, b, monitor1, M);
+
+        ASSERT_EQUAL(monitor1.iteration_count(), monitor0.iteration_count());
+        ASSERT_ALMOST_EQUAL(x1, x0);
+    }
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestConjugateGradientFused);
+
+
+void TestConjugateGradientDistributed(void)
+{
+    cusp::csr_matrix<int, double, cusp::host_memory> A;
+    cusp::gallery::poisson5pt(A, 20, 20);
+
+    // solve on a single device for reference
+    cusp::array1d<double, cusp::device_memory> x0(A.num_rows, 0.0);
+    cusp::array1d<double, cusp::device_memory> b0(A.num_rows, 1.0);
+    cusp::csr_matrix<int, double, cusp::device_memory> A0(A);
+
+    cusp::default_monitor<double> monitor0(b0, 200, 1e-8);
+    cusp::krylov::cg(A0, x0, b0, monitor0);
+
+    int num_devices = 1;
+    cudaGetDeviceCount(&num_devices);
+
+    for (size_t num_parts = 2; num_parts <= 4; num_parts++)
+    {
+        std::vector<int> devices(num_parts);
+        for (size_t p = 0; p < num_parts; p++)
+            devices[p] = p % num_devices;
+
+        cusp::distributed_matrix< cusp::csr_matrix<int, double, cusp::device_memory> > D(A, devices);
+
+        cusp::distributed_array1d<double> x(D.layout, 0.0);
+        cusp::distributed_array1d<double> b(D.layout, 1.0);
+
+        cusp::default_monitor<double> monitor(b, 200, 1e-8);
+        cusp::krylov::cg(D, x, b, monitor);
+
+        ASSERT_EQUAL(monitor.converged(), true);
+        ASSERT_EQUAL(monitor.iteration_count() <= monitor0.iteration_count() + 1, true);
+
+        cusp::array1d<double, cusp::host_memory> x_host;
+        x.gather(x_host);
+
+        ASSERT_ALMOST_EQUAL(x_host, (cusp::array1d<double, cusp::host_memory>(x0)));
+
+        // the workspace keeps its vectors for the next solve
+        cusp::krylov::distributed_workspace<double> workspace(D.layout);
+        cusp::identity_operator<double, cusp::device_memory> M(D.num_rows, D.num_rows);
+
+        cusp::blas::fill(x, 0.0);
+        cusp::default_monitor<double> monitor2(b, 200, 1e-8);
+        cusp::krylov::cg(D, x, b, monitor2, M, workspace);
+
+        ASSERT_EQUAL(monitor2.iteration_count(), monitor.iteration_count());
+    }
+}
+DECLARE_UNITTEST(TestConjugateGradientDistributed);
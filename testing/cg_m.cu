@@ -69,3 +69,64 @@ void TestConjugateGradientM(void)
 }
 DECLARE_HOST_DEVICE_UNITTEST(TestConjugateGradientM);
 
+
+template <class MemorySpace>
+void TestConjugateGradientMConvergedShifts(void)
+{
+    typedef float ValueType;
+
+    cusp::csr_matrix<int, ValueType, MemorySpace> A;
+    cusp::gallery::poisson5pt(A, 10, 10);
+
+    // the large shifts converge long before the base system and are frozen
+    size_t N_s = 3;
+    cusp::array1d<ValueType, MemorySpace> x(A.num_rows*N_s, ValueType(0));
+    cusp::array1d<ValueType, MemorySpace> b(A.num_rows, ValueType(1));
+
+    cusp::array1d<ValueType, MemorySpace> sigma(N_s);
+    sigma[0] = ValueType(0.01);
+    sigma[1] = ValueType(50.0);
+    sigma[2] = ValueType(500.0);
+
+    cusp::default_monitor<ValueType> monitor(b, 200, 1e-6);
+
+    cusp::krylov::cg_m(A, x, b, sigma, monitor);
+
+    ASSERT_EQUAL(monitor.converged(), true);
+
+    check_residuals(A, x, b, sigma);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestConjugateGradientMConvergedShifts);
+
+template <class MemorySpace>
+void TestConjugateGradientMPolynomial(void)
+{
+    typedef float ValueType;
+
+    cusp::csr_matrix<int, ValueType, MemorySpace> A;
+    cusp::gallery::poisson5pt(A, 10, 10);
+
+    size_t N_s = 4;
+    cusp::array1d<ValueType, MemorySpace> x(A.num_rows*N_s, ValueType(0));
+    cusp::array1d<ValueType, MemorySpace> b(A.num_rows, ValueType(1));
+
+    cusp::array1d<ValueType, MemorySpace> sigma(N_s);
+    sigma[0] = ValueType(0.1);
+    sigma[1] = ValueType(0.5);
+    sigma[2] = ValueType(1.0);
+    sigma[3] = ValueType(5.0);
+
+    // p(t) = 1.5 - t/8 is positive on the spectrum of A and on -sigma
+    cusp::array1d<ValueType, cusp::host_memory> coefficients(2);
+    coefficients[0] = ValueType(-0.125);
+    coefficients[1] = ValueType(1.5);
+
+    cusp::default_monitor<ValueType> monitor(b, 100, 1e-6);
+
+    cusp::krylov::cg_m(A, x, b, sigma, monitor, coefficients);
+
+    ASSERT_EQUAL(monitor.converged(), true);
+
+    check_residuals(A, x, b, sigma);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestConjugateGradientMPolynomial);
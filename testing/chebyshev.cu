@@ -0,0 +1,129 @@
+#include <unittest/unittest.h>
+
+#include <cusp/relaxation/chebyshev.h>
+#include <cusp/relaxation/jacobi.h>
+#include <cusp/precond/aggregation/smoothed_aggregation.h>
+
+#include <cusp/blas.h>
+#include <cusp/gallery/poisson.h>
+#include <cusp/krylov/cg.h>
+#include <cusp/monitor.h>
+#include <cusp/multiply.h>
+
+template <typename Matrix, typename Array>
+float chebyshev_residual_norm(const Matrix& A, const Array& b, const Array& x)
+{
+    Array r(A.num_rows);
+    cusp::multiply(A, x, r);
+    cusp::blas::axpby(b, r, r, 1.0f, -1.0f);
+    return cusp::blas::nrm2(r);
+}
+
+template <class Space>
+void TestChebyshevBounds(void)
+{
+    cusp::csr_matrix<int,float,Space> A;
+    cusp::gallery::poisson5pt(A, 16, 16);
+
+    cusp::relaxation::chebyshev<float,Space> M(A);
+
+    // the eigenvalues of D^-1 A lie in (0,2)
+    ASSERT_EQUAL(M.degree, 3);
+    ASSERT_EQUAL(M.upper_bound > 1.8f,  true);
+    ASSERT_EQUAL(M.upper_bound <= 2.0f, true);
+    ASSERT_EQUAL(M.lower_bound > 0.0f,  true);
+    ASSERT_EQUAL(M.lower_bound < M.upper_bound, true);
+
+    // copy to another memory space
+    cusp::relaxation::chebyshev<float,cusp::host_memory> C(M);
+    ASSERT_EQUAL(C.degree, M.degree);
+    ASSERT_EQUAL(C.upper_bound, M.upper_bound);
+    ASSERT_EQUAL(C.inv_diagonal, M.inv_diagonal);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestChebyshevBounds);
+
+template <class Space>
+void TestChebyshevRelaxation(void)
+{
+    cusp::csr_matrix<int,float,Space> A;
+    cusp::gallery::poisson5pt(A, 20, 20);
+
+    cusp::array1d<float,Space> b = unittest::random_samples<float>(A.num_rows);
+
+    // a polynomial of degree one is Jacobi weighted by the inverse of the
+    // center of the interval
+    {
+        cusp::relaxation::chebyshev<float,Space> M(A, 1);
+        cusp::relaxation::jacobi<float,Space>    J(A, 2.0f / (M.upper_bound + M.lower_bound));
+
+        cusp::array1d<float,Space> x(A.num_rows, 1.0f);
+        cusp::array1d<float,Space> y(A.num_rows, 1.0f);
+
+        M(A, b, x);
+        J(A, b, y);
+
+        ASSERT_ALMOST_EQUAL((cusp::array1d<float,cusp::host_memory>(x)), (cusp::array1d<float,cusp::host_memory>(y)));
+    }
+
+    // higher degrees reduce the residual further
+    float initial_residual = cusp::blas::nrm2(b);
+    float previous_residual = initial_residual;
+
+    for(size_t degree = 2; degree <= 6; degree += 2)
+    {
+        cusp::relaxation::chebyshev<float,Space> M(A, degree);
+
+        cusp::array1d<float,Space> x(A.num_rows, 0.0f);
+        for(int i = 0; i < 3; i++)
+            M(A, b, x);
+
+        float residual = chebyshev_residual_norm(A, b, x);
+        ASSERT_EQUAL(residual < previous_residual, true);
+        previous_residual = residual;
+    }
+
+    // presmooth ignores the initial x
+    {
+        cusp::relaxation::chebyshev<float,Space> M(A, 4);
+
+        cusp::array1d<float,Space> x(A.num_rows, 0.0f);
+        cusp::array1d<float,Space> y(A.num_rows, 5.0f);
+
+        M.postsmooth(A, b, x);
+        M.presmooth(A, b, y);
+
+        ASSERT_ALMOST_EQUAL((cusp::array1d<float,cusp::host_memory>(x)), (cusp::array1d<float,cusp::host_memory>(y)));
+    }
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestChebyshevRelaxation);
+
+template <class Space>
+void TestChebyshevSmoother(void)
+{
+    typedef cusp::relaxation::chebyshev<float,Space> Smoother;
+
+    cusp::coo_matrix<int,float,Space> A;
+    cusp::gallery::poisson5pt(A, 50, 50);
+
+    cusp::array1d<float,Space> b = unittest::random_samples<float>(A.num_rows);
+
+    size_t jacobi_iterations;
+    {
+        cusp::precond::aggregation::smoothed_aggregation<int,float,Space> M(A);
+        cusp::array1d<float,Space> x(A.num_rows, 0.0f);
+        cusp::default_monitor<float> monitor(b, 100, 1e-6);
+        cusp::krylov::cg(A, x, b, monitor, M);
+        ASSERT_EQUAL(monitor.converged(), true);
+        jacobi_iterations = monitor.iteration_count();
+    }
+
+    {
+        cusp::precond::aggregation::smoothed_aggregation<int,float,Space,Smoother> M(A);
+        cusp::array1d<float,Space> x(A.num_rows, 0.0f);
+        cusp::default_monitor<float> monitor(b, 100, 1e-6);
+        cusp::krylov::cg(A, x, b, monitor, M);
+        ASSERT_EQUAL(monitor.converged(), true);
+        ASSERT_LEQUAL(monitor.iteration_count(), jacobi_iterations);
+    }
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestChebyshevSmoother);
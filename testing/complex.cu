@@ -2,9 +2,17 @@
 #include <cusp/array1d.h>
 #include <cusp/complex.h>
 #include <complex>
+#include <vector>
 
 #include <cusp/verify.h>
 
+#include <cusp/csr_matrix.h>
+#include <cusp/ell_matrix.h>
+#include <cusp/ellr_operator.h>
+#include <cusp/hyb_matrix.h>
+#include <cusp/multiply.h>
+#include <cusp/gallery/poisson.h>
+
 #define ASSERT_COMPLEX_ALMOST_EQUAL(X,Y) {unittest::assert_almost_equal((X.real()),(Y.real()), __FILE__, __LINE__);unittest::assert_almost_equal((X.imag()),(Y.imag()), __FILE__, __LINE__);}
 
 template< typename T1, typename T2 >
@@ -457,3 +465,65 @@ void TestComplex()
 DECLARE_NUMERIC_UNITTEST(TestComplex);
 
 
+
+
+template <typename MatrixType, typename ValueType>
+void CheckComplexMultiply(const MatrixType& A,
+                          const cusp::array1d<cusp::complex<ValueType>, cusp::host_memory>& x,
+                          const std::vector< std::complex<ValueType> >& expected)
+{
+  typedef cusp::complex<ValueType> Complex;
+
+  cusp::array1d<Complex, cusp::device_memory> x_d(x);
+  cusp::array1d<Complex, cusp::device_memory> y_d(A.num_rows, Complex(-1, -1));
+
+  cusp::multiply(A, x_d, y_d);
+
+  cusp::array1d<Complex, cusp::host_memory> y(y_d);
+
+  for(size_t i = 0; i < y.size(); i++)
+    ASSERT_COMPLEX_ALMOST_EQUAL(y[i], expected[i]);
+}
+
+// the device kernels accumulate complex products component-wise
+template <typename ValueType>
+struct TestComplexMultiply
+{
+  void operator()(void)
+  {
+    typedef cusp::complex<ValueType> Complex;
+
+    cusp::csr_matrix<int, ValueType, cusp::host_memory> P;
+    cusp::gallery::poisson5pt(P, 17, 13);
+
+    cusp::csr_matrix<int, Complex, cusp::host_memory> A(P.num_rows, P.num_cols, P.num_entries);
+    A.row_offsets = P.row_offsets;
+    A.column_indices = P.column_indices;
+
+    for(size_t n = 0; n < A.num_entries; n++)
+      A.values[n] = Complex(P.values[n], ValueType(int(n % 5) - 2) / 4);
+
+    cusp::array1d<Complex, cusp::host_memory> x(A.num_cols);
+    for(size_t i = 0; i < x.size(); i++)
+      x[i] = Complex(ValueType(int(i % 7) - 3), ValueType(int(i % 3) - 1));
+
+    std::vector< std::complex<ValueType> > expected(A.num_rows);
+    for(size_t i = 0; i < A.num_rows; i++)
+    {
+      std::complex<ValueType> sum(0, 0);
+      for(int jj = A.row_offsets[i]; jj < A.row_offsets[i + 1]; jj++)
+      {
+        const Complex a = A.values[jj];
+        const Complex b = x[A.column_indices[jj]];
+        sum += std::complex<ValueType>(a.real(), a.imag()) * std::complex<ValueType>(b.real(), b.imag());
+      }
+      expected[i] = sum;
+    }
+
+    CheckComplexMultiply(cusp::csr_matrix<int, Complex, cusp::device_memory>(A), x, expected);
+    CheckComplexMultiply(cusp::ell_matrix<int, Complex, cusp::device_memory>(A), x, expected);
+    CheckComplexMultiply(cusp::hyb_matrix<int, Complex, cusp::device_memory>(A), x, expected);
+    CheckComplexMultiply(cusp::ellr_operator<int, Complex, cusp::device_memory>(A), x, expected);
+  }
+};
+SimpleUnitTest<TestComplexMultiply, unittest::type_list<float,double> > TestComplexMultiplyInstance;
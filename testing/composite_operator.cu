@@ -0,0 +1,148 @@
+#include <unittest/unittest.h>
+
+#include <cusp/composite_operator.h>
+#include <cusp/csr_matrix.h>
+#include <cusp/ell_matrix.h>
+#include <cusp/monitor.h>
+#include <cusp/multiply.h>
+#include <cusp/gallery/poisson.h>
+#include <cusp/gallery/random.h>
+#include <cusp/krylov/cg.h>
+
+// y = alpha * A * x + beta * B * x computed with explicit products
+template <typename MatrixType1, typename MatrixType2, typename ArrayType>
+ArrayType reference_sum(const MatrixType1& A, const MatrixType2& B, const ArrayType& x, float alpha, float beta)
+{
+    ArrayType y(A.num_rows);
+    ArrayType z(B.num_rows);
+    cusp::multiply(A, x, y);
+    cusp::multiply(B, x, z);
+    cusp::blas::axpby(y, z, y, alpha, beta);
+    return y;
+}
+
+template <class MemorySpace>
+void TestCompositeOperatorSum(void)
+{
+    typedef cusp::csr_matrix<int,float,MemorySpace> CsrMatrix;
+    typedef cusp::ell_matrix<int,float,MemorySpace> EllMatrix;
+    typedef cusp::array1d<float,MemorySpace>        Array;
+
+    CsrMatrix A;
+    cusp::gallery::poisson5pt(A, 10, 12);
+    CsrMatrix R;
+    cusp::gallery::random(A.num_rows, A.num_cols, 300, R, 3);
+    EllMatrix B(R);
+
+    // integer values keep every sum exact
+    cusp::array1d<float,cusp::host_memory> h(A.num_cols);
+    for(size_t i = 0; i < h.size(); i++)
+        h[i] = int(i % 5) - 2;
+    Array x(h);
+    Array y(A.num_rows, 7.0f);
+
+    // fused products
+    cusp::make_sum(A, B)(x, y);
+    ASSERT_EQUAL(y, reference_sum(A, B, x, 1, 1));
+
+    cusp::make_shifted(A, 3, B)(x, y);
+    ASSERT_EQUAL(y, reference_sum(A, B, x, 1, -3));
+
+    cusp::make_shifted(A, 2)(x, y);
+    ASSERT_EQUAL(y, reference_sum(A, cusp::identity_operator<float,MemorySpace>(A.num_rows, A.num_cols), x, 1, -2));
+
+    // a user-defined operator goes through the work vector
+    cusp::transposed_operator<CsrMatrix> Rt(R);
+    cusp::make_sum(A, Rt)(x, y);
+    ASSERT_EQUAL(y, reference_sum(A, Rt, x, 1, 1));
+
+    cusp::make_shifted(Rt, -2, A)(x, y);
+    ASSERT_EQUAL(y, reference_sum(Rt, A, x, 1, 2));
+
+    ASSERT_THROWS((cusp::make_sum(A, CsrMatrix(3, 3, 0))), cusp::invalid_input_exception);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestCompositeOperatorSum);
+
+template <class MemorySpace>
+void TestCompositeOperatorProduct(void)
+{
+    typedef cusp::csr_matrix<int,float,MemorySpace> CsrMatrix;
+    typedef cusp::array1d<float,MemorySpace>        Array;
+
+    CsrMatrix B;
+    cusp::gallery::random(20, 30, 100, B, 1);
+    CsrMatrix C;
+    cusp::gallery::random(30, 20, 100, C, 2);
+    CsrMatrix D;
+    cusp::gallery::poisson5pt(D, 5, 4);
+
+    Array x(30);
+    for(size_t i = 0; i < x.size(); i++)
+        x[i] = int(i % 3) - 1;
+
+    // y = C * (B * x)
+    Array Bx(20);
+    Array CBx(30);
+    cusp::multiply(B, x, Bx);
+    cusp::multiply(C, Bx, CBx);
+
+    Array y(30);
+    cusp::make_product(C, B)(x, y);
+    ASSERT_EQUAL(y, CBx);
+
+    // scaled, fused and through a user-defined operator
+    cusp::make_scaled(-2, cusp::make_product(C, B))(x, y);
+    cusp::blas::scal(CBx, -2.0f);
+    ASSERT_EQUAL(y, CBx);
+
+    Array z(20, 1.0f);
+    Array Dz(20);
+    cusp::multiply(D, z, Dz);
+    cusp::make_scaled(0.5f, D)(z, Bx);
+    cusp::blas::scal(Dz, 0.5f);
+    ASSERT_EQUAL(Bx, Dz);
+
+    // Schur-complement-like D - B C, the nested operators are copied
+    Array BCz(20);
+    Array Cz(30);
+    cusp::multiply(C, z, Cz);
+    cusp::multiply(B, Cz, BCz);
+    cusp::multiply(D, z, Dz);
+    cusp::blas::axpy(BCz, Dz, -1.0f);
+
+    cusp::sum_operator<CsrMatrix, cusp::scaled_operator< cusp::product_operator<CsrMatrix,CsrMatrix> > >
+        S = cusp::make_sum(D, cusp::make_scaled(-1, cusp::make_product(B, C)));
+
+    cusp::multiply(S, z, Bx);
+    ASSERT_EQUAL(Bx, Dz);
+
+    ASSERT_THROWS((cusp::make_product(B, B)), cusp::invalid_input_exception);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestCompositeOperatorProduct);
+
+template <class MemorySpace>
+void TestCompositeOperatorKrylov(void)
+{
+    typedef cusp::csr_matrix<int,float,MemorySpace> CsrMatrix;
+
+    CsrMatrix A;
+    cusp::gallery::poisson5pt(A, 30, 30);
+
+    // A + I is symmetric positive definite
+    cusp::sum_operator<CsrMatrix, cusp::identity_operator<float,MemorySpace> > S = cusp::make_shifted(A, -1);
+
+    cusp::array1d<float,MemorySpace> b(A.num_rows, 1.0f);
+    cusp::array1d<float,MemorySpace> x(A.num_rows, 0.0f);
+
+    cusp::convergence_monitor<float> monitor(b, 200, 1e-5);
+    cusp::krylov::cg(S, x, b, monitor);
+    ASSERT_EQUAL(monitor.converged(), true);
+
+    // the residual of the explicit matrix
+    cusp::array1d<float,MemorySpace> r(A.num_rows);
+    cusp::multiply(A, x, r);
+    cusp::blas::axpy(x, r, 1.0f);
+    cusp::blas::axpy(b, r, -1.0f);
+    ASSERT_EQUAL(cusp::blas::nrm2(r) < 1e-4 * cusp::blas::nrm2(b), true);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestCompositeOperatorKrylov);
@@ -0,0 +1,136 @@
+#include <unittest/unittest.h>
+
+#include <cusp/graph/connected_components.h>
+
+#include <cusp/coo_matrix.h>
+#include <cusp/csr_matrix.h>
+#include <cusp/gallery/poisson.h>
+
+#include <algorithm>
+#include <stack>
+#include <vector>
+
+// components numbered in the order of their smallest vertex, by DFS
+template <typename MatrixType>
+size_t reference_components(const MatrixType& A, cusp::array1d<int,cusp::host_memory>& components)
+{
+    cusp::csr_matrix<int,float,cusp::host_memory> G(A);
+
+    components.resize(G.num_rows);
+    std::fill(components.begin(), components.end(), -1);
+
+    int num_components = 0;
+
+    for (int i = 0; i < int(G.num_rows); i++)
+    {
+        if (components[i] != -1)
+            continue;
+
+        std::stack<int> DFS;
+        DFS.push(i);
+        components[i] = num_components;
+
+        while (!DFS.empty())
+        {
+            const int v = DFS.top();
+            DFS.pop();
+
+            for (int jj = G.row_offsets[v]; jj < G.row_offsets[v + 1]; jj++)
+            {
+                const int j = G.column_indices[jj];
+                if (components[j] == -1)
+                {
+                    components[j] = num_components;
+                    DFS.push(j);
+                }
+            }
+        }
+
+        num_components++;
+    }
+
+    return num_components;
+}
+
+// chains of 1 to 7 vertices over a shuffled vertex order, 7919 is
+// prime and so i -> 7919 i mod n a permutation
+void many_components(cusp::coo_matrix<int,float,cusp::host_memory>& A, const int num_vertices)
+{
+    std::vector<int> order(num_vertices);
+    for (int i = 0; i < num_vertices; i++)
+        order[i] = (int(i * 7919L) % num_vertices);
+
+    std::vector<int> rows, cols;
+
+    int first = 0;
+    for (int c = 0; first < num_vertices; c++)
+    {
+        const int length = std::min(c % 7 + 1, num_vertices - first);
+
+        for (int i = first; i + 1 < first + length; i++)
+        {
+            rows.push_back(order[i]);     cols.push_back(order[i + 1]);
+            rows.push_back(order[i + 1]); cols.push_back(order[i]);
+        }
+
+        first += length;
+    }
+
+    A.resize(num_vertices, num_vertices, rows.size());
+    for (size_t n = 0; n < rows.size(); n++)
+    {
+        A.row_indices[n]    = rows[n];
+        A.column_indices[n] = cols[n];
+        A.values[n]         = 1;
+    }
+    A.sort_by_row_and_column();
+}
+
+template <class MemorySpace>
+void TestConnectedComponents(void)
+{
+    cusp::coo_matrix<int,float,cusp::host_memory> A;
+    many_components(A, 5000);
+
+    cusp::array1d<int,cusp::host_memory> expected;
+    const size_t num_expected = reference_components(A, expected);
+
+    cusp::csr_matrix<int,float,MemorySpace> G(A);
+    cusp::array1d<int,MemorySpace> components(G.num_rows);
+
+    ASSERT_EQUAL(cusp::graph::connected_components(G, components), num_expected);
+    ASSERT_EQUAL(components, expected);
+
+    // through the general path
+    cusp::coo_matrix<int,float,MemorySpace> C(A);
+    cusp::array1d<int,MemorySpace> components_coo(C.num_rows);
+
+    ASSERT_EQUAL(cusp::graph::connected_components(C, components_coo), num_expected);
+    ASSERT_EQUAL(components_coo, expected);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestConnectedComponents);
+
+template <class MemorySpace>
+void TestConnectedComponentsConnected(void)
+{
+    cusp::csr_matrix<int,float,MemorySpace> G;
+    cusp::gallery::poisson5pt(G, 200, 150);
+
+    cusp::array1d<int,MemorySpace> components(G.num_rows, 5);
+
+    ASSERT_EQUAL(cusp::graph::connected_components(G, components), 1);
+    ASSERT_EQUAL(components, (cusp::array1d<int,MemorySpace>(G.num_rows, 0)));
+
+    // no edges
+    cusp::csr_matrix<int,float,MemorySpace> E(10, 10, 0);
+    thrust::fill(E.row_offsets.begin(), E.row_offsets.end(), 0);
+    cusp::array1d<int,MemorySpace> isolated(10);
+
+    ASSERT_EQUAL(cusp::graph::connected_components(E, isolated), 10);
+
+    cusp::array1d<int,cusp::host_memory> expected(10);
+    for (int i = 0; i < 10; i++)
+        expected[i] = i;
+    ASSERT_EQUAL(isolated, expected);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestConnectedComponentsConnected);
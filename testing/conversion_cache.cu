@@ -0,0 +1,108 @@
+#include <unittest/unittest.h>
+
+#include <cusp/conversion_cache.h>
+
+#include <cusp/array2d.h>
+#include <cusp/coo_matrix.h>
+#include <cusp/csr_matrix.h>
+#include <cusp/dia_matrix.h>
+#include <cusp/elementwise.h>
+#include <cusp/hyb_matrix.h>
+#include <cusp/multiply.h>
+#include <cusp/gallery/poisson.h>
+
+template <class MemorySpace>
+void TestConversionCacheMultiply(void)
+{
+    cusp::csr_matrix<int,float,MemorySpace> A;
+    cusp::gallery::poisson5pt(A, 10, 10);
+
+    cusp::hyb_matrix<int,float,MemorySpace> B(A);
+    cusp::dia_matrix<int,float,MemorySpace> D(A);
+
+    // reference without a cache
+    cusp::csr_matrix<int,float,MemorySpace> C_ref;
+    cusp::multiply(A, B, C_ref);
+
+    cusp::conversion_cache cache;
+    ASSERT_EQUAL(cusp::current_conversion_cache() == NULL, true);
+
+    {
+        cusp::conversion_cache_scope scope(cache);
+        ASSERT_EQUAL(cusp::current_conversion_cache(), &cache);
+
+        for (int k = 0; k < 3; k++)
+        {
+            cusp::csr_matrix<int,float,MemorySpace> C;
+            cusp::multiply(A, B, C);
+
+            ASSERT_EQUAL((cusp::array2d<float,cusp::host_memory>(C)), (cusp::array2d<float,cusp::host_memory>(C_ref)));
+        }
+
+        // B is converted once, A is already in CSR
+        ASSERT_EQUAL(cache.size(), size_t(1));
+        ASSERT_EQUAL(cache.misses(), size_t(1));
+        ASSERT_EQUAL(cache.hits(), size_t(2));
+
+        // and converted again once its values changed
+        cusp::blas::scal(B.ell.values.values, 2.0f);
+        cusp::blas::scal(B.coo.values, 2.0f);
+        cache.touch(B);
+        ASSERT_EQUAL(cache.version(B), size_t(1));
+        ASSERT_EQUAL(cache.size(), size_t(0));
+
+        cusp::csr_matrix<int,float,MemorySpace> C;
+        cusp::multiply(A, B, C);
+
+        cusp::array2d<float,cusp::host_memory> C_h(C);
+        cusp::array2d<float,cusp::host_memory> C_ref_h(C_ref);
+        cusp::blas::scal(C_ref_h.values, 2.0f);
+        ASSERT_EQUAL(C_h, C_ref_h);
+
+        // elementwise operations on other formats
+        cusp::coo_matrix<int,float,MemorySpace> S;
+        cusp::add(D, B, S);
+        cusp::add(D, B, S);
+
+        cusp::array2d<float,cusp::host_memory> S_ref(D);
+        cusp::array2d<float,cusp::host_memory> B_h(B);
+        cusp::blas::axpy(B_h.values, S_ref.values, 1.0f);
+        ASSERT_EQUAL((cusp::array2d<float,cusp::host_memory>(S)), S_ref);
+        ASSERT_EQUAL(cache.hits() >= size_t(4), true);
+    }
+
+    ASSERT_EQUAL(cusp::current_conversion_cache() == NULL, true);
+
+    cache.clear();
+    ASSERT_EQUAL(cache.size(), size_t(0));
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestConversionCacheMultiply);
+
+void TestConversionCacheResize(void)
+{
+    cusp::dia_matrix<int,float,cusp::host_memory> A;
+    cusp::gallery::poisson5pt(A, 4, 4);
+
+    cusp::array1d<float,cusp::host_memory> x(A.num_rows, 1.0f);
+    cusp::array1d<float,cusp::host_memory> y(A.num_rows);
+
+    cusp::conversion_cache cache;
+    cusp::conversion_cache_scope scope(cache);
+
+    cusp::multiply_transpose(A, x, y);
+    ASSERT_EQUAL(cache.misses(), size_t(1));
+
+    // a matrix of other dimensions at the same address is converted again
+    cusp::gallery::poisson5pt(A, 5, 5);
+    x.resize(A.num_rows, 1.0f);
+    y.resize(A.num_rows);
+
+    cusp::multiply_transpose(A, x, y);
+    ASSERT_EQUAL(cache.misses(), size_t(2));
+    ASSERT_EQUAL(cache.size(), size_t(1));
+
+    cusp::array1d<float,cusp::host_memory> y_ref(A.num_rows);
+    cusp::multiply(A, x, y_ref);
+    ASSERT_EQUAL(y, y_ref);
+}
+DECLARE_UNITTEST(TestConversionCacheResize);
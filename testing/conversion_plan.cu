@@ -0,0 +1,162 @@
+#include <unittest/unittest.h>
+
+#include <cusp/conversion_plan.h>
+#include <cusp/coo_matrix.h>
+#include <cusp/csr_matrix.h>
+#include <cusp/dia_matrix.h>
+#include <cusp/ell_matrix.h>
+#include <cusp/hyb_matrix.h>
+#include <cusp/gallery/poisson.h>
+#include <cusp/gallery/random.h>
+
+template <typename MemorySpace>
+void TestPlanConversionPoisson(void)
+{
+    cusp::csr_matrix<int, float, MemorySpace> A;
+    cusp::gallery::poisson5pt(A, 10, 10);
+
+    cusp::conversion_plan plan = cusp::plan_conversion(A);
+
+    ASSERT_EQUAL(plan.num_rows,            100);
+    ASSERT_EQUAL(plan.num_entries,         460);
+    ASSERT_EQUAL(plan.num_diagonals,       5);
+    ASSERT_EQUAL(plan.max_entries_per_row, 5);
+
+    // 100 rows are padded to 128
+    ASSERT_EQUAL(plan.dia_fill, float(5 * 128) / 460.0f);
+    ASSERT_EQUAL(plan.ell_fill, float(5 * 128) / 460.0f);
+
+    // x and y traffic: (460 + 100) * 4 bytes
+    ASSERT_EQUAL(plan.bytes[cusp::conversion_plan::coo], 460 * 12 + 2240);
+    ASSERT_EQUAL(plan.bytes[cusp::conversion_plan::csr], 101 * 4 + 460 * 8 + 2240);
+    ASSERT_EQUAL(plan.bytes[cusp::conversion_plan::dia], 5 * 4 + 5 * 128 * 4 + 2240);
+    ASSERT_EQUAL(plan.bytes[cusp::conversion_plan::ell], 5 * 128 * 8 + 2240);
+
+    ASSERT_EQUAL(plan.format, cusp::conversion_plan::dia);
+    ASSERT_EQUAL(std::string(plan.format_name()), "dia");
+
+    // the same plan from COO
+    cusp::coo_matrix<int, float, MemorySpace> B(A);
+    cusp::conversion_plan plan_coo = cusp::plan_conversion(B);
+
+    ASSERT_EQUAL(plan_coo.num_diagonals,       plan.num_diagonals);
+    ASSERT_EQUAL(plan_coo.hyb_entries_per_row, plan.hyb_entries_per_row);
+    ASSERT_EQUAL(plan_coo.format,              plan.format);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestPlanConversionPoisson);
+
+template <typename MemorySpace>
+void TestPlanConversionHybSplit(void)
+{
+    // a diagonal matrix with one dense row
+    cusp::coo_matrix<int, float, cusp::host_memory> A(64, 64, 127);
+
+    for (int j = 0; j < 64; j++)
+    {
+        A.row_indices[j] = 0; A.column_indices[j] = j; A.values[j] = j + 1;
+    }
+
+    for (int i = 1; i < 64; i++)
+    {
+        A.row_indices[63 + i] = i; A.column_indices[63 + i] = i; A.values[63 + i] = -i;
+    }
+
+    cusp::csr_matrix<int, float, MemorySpace> B(A);
+
+    // count bytes only
+    cusp::conversion_plan_options options;
+    options.launch_latency = 0;
+
+    cusp::conversion_plan plan = cusp::plan_conversion(B, options);
+
+    ASSERT_EQUAL(plan.max_entries_per_row, 64);
+    ASSERT_EQUAL(plan.num_diagonals,       64);
+    ASSERT_EQUAL(plan.hyb_entries_per_row, 1);
+    ASSERT_EQUAL(plan.hyb_coo_entries,     63);
+    ASSERT_EQUAL(plan.bytes[cusp::conversion_plan::hyb], 64 * 8 + 63 * 12 + (127 + 64) * 4);
+    ASSERT_EQUAL(plan.format, cusp::conversion_plan::hyb);
+
+    cusp::hyb_matrix<int, float, MemorySpace> C;
+    cusp::convert(B, C, plan);
+
+    ASSERT_EQUAL(C.ell.column_indices.num_cols, 1);
+    ASSERT_EQUAL(C.coo.num_entries,             63);
+
+    cusp::array2d<float, cusp::host_memory> A_dense(A);
+    cusp::array2d<float, cusp::host_memory> C_dense(C);
+    ASSERT_EQUAL_QUIET(A_dense, C_dense);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestPlanConversionHybSplit);
+
+template <typename SourceType, typename DestinationType>
+void ComparePlannedConversion(const SourceType& A, const cusp::conversion_plan& plan)
+{
+    DestinationType B;
+    cusp::convert(A, B, plan);
+
+    cusp::array2d<float, cusp::host_memory> A_dense(A);
+    cusp::array2d<float, cusp::host_memory> B_dense(B);
+    ASSERT_EQUAL_QUIET(A_dense, B_dense);
+}
+
+template <typename SourceType, typename MemorySpace>
+void ComparePlannedConversions(const SourceType& A)
+{
+    cusp::conversion_plan plan = cusp::plan_conversion(A);
+
+    ComparePlannedConversion< SourceType, cusp::coo_matrix<int, float, MemorySpace> >(A, plan);
+    ComparePlannedConversion< SourceType, cusp::csr_matrix<int, float, MemorySpace> >(A, plan);
+    ComparePlannedConversion< SourceType, cusp::dia_matrix<int, float, MemorySpace> >(A, plan);
+    ComparePlannedConversion< SourceType, cusp::ell_matrix<int, float, MemorySpace> >(A, plan);
+    ComparePlannedConversion< SourceType, cusp::hyb_matrix<int, float, MemorySpace> >(A, plan);
+}
+
+template <typename MemorySpace>
+void TestConvertWithPlan(void)
+{
+    cusp::coo_matrix<int, float, cusp::host_memory> R;
+    cusp::gallery::random(40, 30, 200, R);
+
+    cusp::coo_matrix<int, float, MemorySpace> A(R);
+    cusp::csr_matrix<int, float, MemorySpace> B(R);
+
+    ComparePlannedConversions<cusp::coo_matrix<int, float, MemorySpace>, MemorySpace>(A);
+    ComparePlannedConversions<cusp::csr_matrix<int, float, MemorySpace>, MemorySpace>(B);
+
+    // destinations in the other memory space
+    ComparePlannedConversions<cusp::csr_matrix<int, float, MemorySpace>, cusp::host_memory>(B);
+    ComparePlannedConversions<cusp::csr_matrix<int, float, MemorySpace>, cusp::device_memory>(B);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestConvertWithPlan);
+
+template <typename MemorySpace>
+void TestConvertWithPlanFill(void)
+{
+    // an anti-diagonal matrix occupies every other diagonal
+    cusp::coo_matrix<int, float, cusp::host_memory> A(4, 4, 4);
+
+    for (int i = 0; i < 4; i++)
+    {
+        A.row_indices[i] = i; A.column_indices[i] = 3 - i; A.values[i] = i + 1;
+    }
+
+    cusp::coo_matrix<int, float, MemorySpace> B(A);
+
+    cusp::conversion_plan plan = cusp::plan_conversion(B);
+
+    ASSERT_EQUAL(plan.num_diagonals, 4);
+    ASSERT_EQUAL(plan.dia_fill,      32.0f);
+    ASSERT_EQUAL(plan.ell_fill,       8.0f);
+
+    // the DIA conversion is built whatever its fill
+    cusp::dia_matrix<int, float, MemorySpace> C;
+    cusp::convert(B, C, plan);
+
+    ASSERT_EQUAL(C.diagonal_offsets.size(), 4);
+
+    // plans only apply to matrices of the same size
+    cusp::coo_matrix<int, float, MemorySpace> D(5, 4, 4);
+    ASSERT_THROWS(cusp::convert(D, C, plan), cusp::invalid_input_exception);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestConvertWithPlanFill);
+
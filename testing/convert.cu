@@ -11,6 +11,10 @@
 
 #include <cusp/verify.h>
 
+#include <algorithm>
+#include <set>
+#include <vector>
+
 
 template <typename Matrix>
 void reset_view(Matrix& view, cusp::coo_format)
@@ -230,6 +234,12 @@ void TestConversionToMatrixFormat(void)
         {  DestinationType dst;       dst = src;                verify_conversion_example(dst);  cusp::assert_is_valid_matrix(dst); }
         {  DestinationType dst;       cusp::convert(src,dst);   verify_conversion_example(dst);  cusp::assert_is_valid_matrix(dst); }
         {  DestinationType dst;       cusp::convert(view,dst);  verify_conversion_example(dst);  cusp::assert_is_valid_matrix(dst); }
+
+        // reuse the temporary storage of a workspace
+        cusp::convert_workspace<cusp::device_memory> workspace;
+
+        {  DestinationType dst;       cusp::convert(src,dst,workspace);   verify_conversion_example(dst);  cusp::assert_is_valid_matrix(dst); }
+        {  DestinationType dst;       cusp::convert(view,dst,workspace);  verify_conversion_example(dst);  cusp::assert_is_valid_matrix(dst); }
     }
         
     {
@@ -370,6 +380,114 @@ void TestConvertCsrToEllMatrixHost(void)
 }
 DECLARE_UNITTEST(TestConvertCsrToEllMatrixHost);
 
+// csr <- coo with entries in arbitrary order, placing the entries of a row
+// in their coo order as the serial conversion does
+void ReferenceCooToCsr(const cusp::coo_matrix<int, float, cusp::host_memory>& coo,
+                       cusp::csr_matrix<int, float, cusp::host_memory>& csr)
+{
+    csr.resize(coo.num_rows, coo.num_cols, coo.num_entries);
+
+    std::vector<int> next(coo.num_rows + 1, 0);
+    for (size_t n = 0; n < coo.num_entries; n++)
+        next[coo.row_indices[n] + 1]++;
+    for (size_t i = 0; i < coo.num_rows; i++)
+        next[i + 1] += next[i];
+    for (size_t i = 0; i <= coo.num_rows; i++)
+        csr.row_offsets[i] = next[i];
+
+    for (size_t n = 0; n < coo.num_entries; n++)
+    {
+        const int dest = next[coo.row_indices[n]]++;
+        csr.column_indices[dest] = coo.column_indices[n];
+        csr.values[dest]         = coo.values[n];
+    }
+}
+
+void CompareCsrMatrices(const cusp::csr_matrix<int, float, cusp::host_memory>& A,
+                        const cusp::csr_matrix<int, float, cusp::host_memory>& B)
+{
+    ASSERT_EQUAL(A.num_rows,       B.num_rows);
+    ASSERT_EQUAL(A.num_cols,       B.num_cols);
+    ASSERT_EQUAL(A.row_offsets,    B.row_offsets);
+    ASSERT_EQUAL(A.column_indices, B.column_indices);
+    ASSERT_EQUAL(A.values,         B.values);
+}
+
+void TestHostConversionLarge(void)
+{
+    // large enough for the host conversions to split the work among
+    // threads, with empty rows, long rows and a few far diagonals
+    const int N = 30000;
+
+    // sorted, distinct columns in every row
+    std::vector<int> I, J;
+    for (int i = 0; i < N; i++)
+    {
+        const int length = (i % 3000 == 0) ? 200 : (i % 7 == 0 ? 0 : 1 + i % 5);
+
+        std::set<int> columns;
+        for (int k = 0; k < length; k++)
+            columns.insert(k < 3 ? std::min(N - 1, i + k) : (i * 13 + k * 101) % N);
+
+        for (std::set<int>::const_iterator j = columns.begin(); j != columns.end(); ++j)
+        {
+            I.push_back(i);
+            J.push_back(*j);
+        }
+    }
+
+    cusp::coo_matrix<int, float, cusp::host_memory> sorted(N, N, I.size());
+    for (size_t n = 0; n < I.size(); n++)
+    {
+        sorted.row_indices[n]    = I[n];
+        sorted.column_indices[n] = J[n];
+        sorted.values[n]         = float(n % 17) + 1.0f;
+    }
+
+    // the same entries in an order which is not sorted by row
+    cusp::coo_matrix<int, float, cusp::host_memory> shuffled(sorted);
+    for (size_t n = 0; n < shuffled.num_entries; n++)
+    {
+        const size_t m = (n * 7919) % shuffled.num_entries;
+        std::swap(shuffled.row_indices[n],    shuffled.row_indices[m]);
+        std::swap(shuffled.column_indices[n], shuffled.column_indices[m]);
+        std::swap(shuffled.values[n],         shuffled.values[m]);
+    }
+
+    for (int order = 0; order < 2; order++)
+    {
+        const cusp::coo_matrix<int, float, cusp::host_memory>& coo = order ? shuffled : sorted;
+
+        cusp::csr_matrix<int, float, cusp::host_memory> expected;
+        ReferenceCooToCsr(coo, expected);
+
+        cusp::csr_matrix<int, float, cusp::host_memory> csr(coo);
+
+        ASSERT_EQUAL(csr.row_offsets,    expected.row_offsets);
+        ASSERT_EQUAL(csr.column_indices, expected.column_indices);
+        ASSERT_EQUAL(csr.values,         expected.values);
+    }
+
+    cusp::csr_matrix<int, float, cusp::host_memory> csr(sorted);
+
+    // DIA, ELL and HYB round trips
+    cusp::dia_matrix<int, float, cusp::host_memory> dia;
+    cusp::detail::host::convert(csr, dia, cusp::csr_format(), cusp::dia_format(), 1e6, 32);
+    cusp::assert_is_valid_matrix(dia);
+    CompareCsrMatrices(cusp::csr_matrix<int, float, cusp::host_memory>(dia), csr);
+
+    cusp::ell_matrix<int, float, cusp::host_memory> ell;
+    cusp::detail::host::convert(csr, ell, cusp::csr_format(), cusp::ell_format(), 1e6, 32);
+    cusp::assert_is_valid_matrix(ell);
+    CompareCsrMatrices(cusp::csr_matrix<int, float, cusp::host_memory>(ell), csr);
+
+    cusp::hyb_matrix<int, float, cusp::host_memory> hyb(csr);
+    cusp::assert_is_valid_matrix(hyb);
+    ASSERT_EQUAL(hyb.coo.num_entries > 0, true);
+    CompareCsrMatrices(cusp::csr_matrix<int, float, cusp::host_memory>(hyb), csr);
+}
+DECLARE_UNITTEST(TestHostConversionLarge);
+
 template <class Matrix>
 void TestConversionFromArray1dTo(void)
 {
@@ -542,3 +660,52 @@ void TestConversionFromPitchedArray2dToArray1d(void)
 }
 DECLARE_HOST_DEVICE_UNITTEST(TestConversionFromPitchedArray2dToArray1d);
 
+
+
+template <class MemorySpace>
+void TestConvertInPlace(void)
+{
+    // CSR -> COO
+    {
+        cusp::csr_matrix<int, float, MemorySpace> src;
+        initialize_conversion_example(src);
+
+        cusp::coo_matrix<int, float, MemorySpace> dst;
+        cusp::convert_in_place(src, dst);
+
+        verify_conversion_example(dst);  cusp::assert_is_valid_matrix(dst);
+
+        ASSERT_EQUAL(src.num_entries,           0);
+        ASSERT_EQUAL(src.column_indices.size(), 0);
+        ASSERT_EQUAL(src.values.size(),         0);
+    }
+
+    // COO -> CSR
+    {
+        cusp::coo_matrix<int, float, MemorySpace> src;
+        initialize_conversion_example(src);
+
+        cusp::csr_matrix<int, float, MemorySpace> dst;
+        cusp::convert_in_place(src, dst);
+
+        verify_conversion_example(dst);  cusp::assert_is_valid_matrix(dst);
+
+        ASSERT_EQUAL(src.num_entries,           0);
+        ASSERT_EQUAL(src.row_indices.size(),    0);
+        ASSERT_EQUAL(src.values.size(),         0);
+    }
+
+    // other formats are converted and src is released
+    {
+        cusp::csr_matrix<int, float, MemorySpace> src;
+        initialize_conversion_example(src);
+
+        cusp::hyb_matrix<int, float, MemorySpace> dst;
+        cusp::convert_in_place(src, dst);
+
+        verify_conversion_example(dst);  cusp::assert_is_valid_matrix(dst);
+
+        ASSERT_EQUAL(src.num_entries, 0);
+    }
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestConvertInPlace);
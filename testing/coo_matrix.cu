@@ -148,6 +148,57 @@ void TestCooMatrixSortByRowAndColumn(void)
 }
 DECLARE_HOST_DEVICE_UNITTEST(TestCooMatrixSortByRowAndColumn);
 
+template <class Space>
+void TestCooMatrixSortByRowAndColumnDuplicates(void)
+{
+    // entries with equal coordinates keep their order
+    cusp::array1d<int,   Space> rows(6);
+    cusp::array1d<int,   Space> cols(6);
+    cusp::array1d<float, Space> vals(6);
+
+    rows[0] = 2; cols[0] = 0; vals[0] = 1;
+    rows[1] = 0; cols[1] = 5; vals[1] = 2;
+    rows[2] = 2; cols[2] = 0; vals[2] = 3;
+    rows[3] = 0; cols[3] = 1; vals[3] = 4;
+    rows[4] = 0; cols[4] = 5; vals[4] = 5;
+    rows[5] = 1; cols[5] = 0; vals[5] = 6;
+
+    cusp::detail::sort_by_row_and_column(rows, cols, vals);
+
+    ASSERT_EQUAL(rows[0], 0); ASSERT_EQUAL(cols[0], 1); ASSERT_EQUAL(vals[0], 4);
+    ASSERT_EQUAL(rows[1], 0); ASSERT_EQUAL(cols[1], 5); ASSERT_EQUAL(vals[1], 2);
+    ASSERT_EQUAL(rows[2], 0); ASSERT_EQUAL(cols[2], 5); ASSERT_EQUAL(vals[2], 5);
+    ASSERT_EQUAL(rows[3], 1); ASSERT_EQUAL(cols[3], 0); ASSERT_EQUAL(vals[3], 6);
+    ASSERT_EQUAL(rows[4], 2); ASSERT_EQUAL(cols[4], 0); ASSERT_EQUAL(vals[4], 1);
+    ASSERT_EQUAL(rows[5], 2); ASSERT_EQUAL(cols[5], 0); ASSERT_EQUAL(vals[5], 3);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestCooMatrixSortByRowAndColumnDuplicates);
+
+template <class Space>
+void TestCooMatrixSortByRowAndColumnWideIndices(void)
+{
+    // the coordinates need more than 64 bits together
+    const long long big_row    = 1ll << 40;
+    const long long big_column = 1ll << 30;
+
+    cusp::array1d<long long, Space> rows(4);
+    cusp::array1d<long long, Space> cols(4);
+    cusp::array1d<float,     Space> vals(4);
+
+    rows[0] = big_row; cols[0] = 1;          vals[0] = 1;
+    rows[1] = 3;       cols[1] = big_column; vals[1] = 2;
+    rows[2] = big_row; cols[2] = 0;          vals[2] = 3;
+    rows[3] = 3;       cols[3] = 2;          vals[3] = 4;
+
+    cusp::detail::sort_by_row_and_column(rows, cols, vals);
+
+    ASSERT_EQUAL(rows[0], 3);       ASSERT_EQUAL(cols[0], 2);          ASSERT_EQUAL(vals[0], 4);
+    ASSERT_EQUAL(rows[1], 3);       ASSERT_EQUAL(cols[1], big_column); ASSERT_EQUAL(vals[1], 2);
+    ASSERT_EQUAL(rows[2], big_row); ASSERT_EQUAL(cols[2], 0);          ASSERT_EQUAL(vals[2], 3);
+    ASSERT_EQUAL(rows[3], big_row); ASSERT_EQUAL(cols[3], 1);          ASSERT_EQUAL(vals[3], 1);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestCooMatrixSortByRowAndColumnWideIndices);
+
 template <class Space>
 void TestCooMatrixIsSortedByRow(void)
 {
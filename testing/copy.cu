@@ -0,0 +1,62 @@
+#include <unittest/unittest.h>
+
+#include <cusp/copy.h>
+#include <cusp/array1d.h>
+#include <cusp/csr_matrix.h>
+#include <cusp/multiply.h>
+#include <cusp/gallery/poisson.h>
+
+#include <thrust/reduce.h>
+
+void TestCopyLargeArray1dHostDevice(void)
+{
+    // spans several staging buffers and ends with a partial one
+    cusp::array1d<float, cusp::host_memory> a(3 * (1 << 20) + 12345);
+    for(size_t i = 0; i < a.size(); i++)
+        a[i] = float(i % 1021) - 510.0f;
+
+    cusp::array1d<float, cusp::device_memory> b;
+    cusp::copy(a, b);
+
+    cusp::array1d<float, cusp::host_memory> c;
+    cusp::copy(b, c);
+
+    ASSERT_EQUAL(b.size(), a.size());
+    ASSERT_EQUAL(c == a, true);
+
+    // consecutive uploads into the same array
+    cusp::array1d<float, cusp::host_memory> d(a.size(), 2.0f);
+    cusp::copy(a, b);
+    cusp::copy(d, b);
+
+    ASSERT_EQUAL(thrust::reduce(b.begin(), b.end()), 2.0f * a.size());
+}
+DECLARE_UNITTEST(TestCopyLargeArray1dHostDevice);
+
+void TestCopyLargeMatrixHostDevice(void)
+{
+    cusp::csr_matrix<int, float, cusp::host_memory> A;
+    cusp::gallery::poisson5pt(A, 400, 300);
+
+    cusp::csr_matrix<int, float, cusp::device_memory> B;
+    cusp::copy(A, B);
+
+    // the multiply is ordered after the uploads
+    cusp::array1d<float, cusp::device_memory> x(A.num_cols, 1.0f);
+    cusp::array1d<float, cusp::device_memory> y(A.num_rows);
+    cusp::multiply(B, x, y);
+
+    cusp::array1d<float, cusp::host_memory> h_x(A.num_cols, 1.0f);
+    cusp::array1d<float, cusp::host_memory> h_y(A.num_rows);
+    cusp::multiply(A, h_x, h_y);
+
+    ASSERT_EQUAL(y, h_y);
+
+    cusp::csr_matrix<int, float, cusp::host_memory> C;
+    cusp::copy(B, C);
+
+    ASSERT_EQUAL(C.row_offsets,    A.row_offsets);
+    ASSERT_EQUAL(C.column_indices, A.column_indices);
+    ASSERT_EQUAL(C.values,         A.values);
+}
+DECLARE_UNITTEST(TestCopyLargeMatrixHostDevice);
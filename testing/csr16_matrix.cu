@@ -0,0 +1,184 @@
+#include <unittest/unittest.h>
+
+#include <cusp/csr16_matrix.h>
+#include <cusp/multiply.h>
+#include <cusp/verify.h>
+#include <cusp/gallery/poisson.h>
+#include <cusp/gallery/random.h>
+
+template <class Space>
+void TestCsr16MatrixBasicConstructor(void)
+{
+    cusp::csr16_matrix<int, float, Space> matrix(3, 2, 6);
+
+    ASSERT_EQUAL(matrix.num_rows,              3);
+    ASSERT_EQUAL(matrix.num_cols,              2);
+    ASSERT_EQUAL(matrix.num_entries,           6);
+    ASSERT_EQUAL(matrix.row_offsets.size(),    4);
+    ASSERT_EQUAL(matrix.column_offsets.size(), 6);
+    ASSERT_EQUAL(matrix.values.size(),         6);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestCsr16MatrixBasicConstructor);
+
+template <class Space>
+void TestCsr16MatrixSwap(void)
+{
+    cusp::csr16_matrix<int, float, Space> A(1, 2, 3);
+    cusp::csr16_matrix<int, float, Space> B(4, 5, 6);
+
+    A.swap(B);
+
+    ASSERT_EQUAL(A.num_rows,              4);
+    ASSERT_EQUAL(A.num_cols,              5);
+    ASSERT_EQUAL(A.num_entries,           6);
+    ASSERT_EQUAL(A.row_offsets.size(),    5);
+    ASSERT_EQUAL(A.column_offsets.size(), 6);
+
+    ASSERT_EQUAL(B.num_rows,              1);
+    ASSERT_EQUAL(B.num_cols,              2);
+    ASSERT_EQUAL(B.num_entries,           3);
+    ASSERT_EQUAL(B.row_offsets.size(),    2);
+    ASSERT_EQUAL(B.column_offsets.size(), 3);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestCsr16MatrixSwap);
+
+template <class Space>
+void TestCsr16MatrixConversion(void)
+{
+    // [10  0 20]
+    // [ 0  0  0]
+    // [ 0  0 30]
+    // [40 50 60]
+    cusp::csr_matrix<int, float, cusp::host_memory> S(4, 3, 6);
+    S.row_offsets[0] = 0;
+    S.row_offsets[1] = 2;
+    S.row_offsets[2] = 2;
+    S.row_offsets[3] = 3;
+    S.row_offsets[4] = 6;
+    S.column_indices[0] = 0; S.values[0] = 10;
+    S.column_indices[1] = 2; S.values[1] = 20;
+    S.column_indices[2] = 2; S.values[2] = 30;
+    S.column_indices[3] = 0; S.values[3] = 40;
+    S.column_indices[4] = 1; S.values[4] = 50;
+    S.column_indices[5] = 2; S.values[5] = 60;
+
+    cusp::csr_matrix<int, float, Space>   A(S);
+    cusp::csr16_matrix<int, float, Space> B(A);
+
+    ASSERT_EQUAL(B.num_rows,    4);
+    ASSERT_EQUAL(B.num_cols,    3);
+    ASSERT_EQUAL(B.num_entries, 6);
+    ASSERT_EQUAL(cusp::is_valid_matrix(B), true);
+
+    cusp::csr16_matrix<int, float, cusp::host_memory> H(B);
+
+    ASSERT_EQUAL_QUIET(H.row_offsets, S.row_offsets);
+    ASSERT_EQUAL_QUIET(H.values,      S.values);
+
+    ASSERT_EQUAL(H.column_offsets[0],  0);
+    ASSERT_EQUAL(H.column_offsets[1],  2);
+    ASSERT_EQUAL(H.column_offsets[2],  0);
+    ASSERT_EQUAL(H.column_offsets[3], -3);
+    ASSERT_EQUAL(H.column_offsets[4], -2);
+    ASSERT_EQUAL(H.column_offsets[5], -1);
+
+    // round trip through CSR and COO
+    cusp::csr_matrix<int, float, Space> C(B);
+    cusp::coo_matrix<int, float, Space> D(B);
+
+    ASSERT_EQUAL_QUIET(A.row_offsets,    C.row_offsets);
+    ASSERT_EQUAL_QUIET(A.column_indices, C.column_indices);
+    ASSERT_EQUAL_QUIET(A.values,         C.values);
+
+    cusp::array2d<float, cusp::host_memory> A_dense(A);
+    cusp::array2d<float, cusp::host_memory> D_dense(D);
+    ASSERT_EQUAL_QUIET(A_dense, D_dense);
+
+    // conversion from COO
+    cusp::coo_matrix<int, float, Space>   E(S);
+    cusp::csr16_matrix<int, float, Space> F(E);
+
+    ASSERT_EQUAL_QUIET(B.row_offsets,    F.row_offsets);
+    ASSERT_EQUAL_QUIET(B.column_offsets, F.column_offsets);
+    ASSERT_EQUAL_QUIET(B.values,         F.values);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestCsr16MatrixConversion);
+
+template <class Space>
+void TestCsr16MatrixConversionRange(void)
+{
+    // the entries of row 0 are 32767 and 32768 columns right of the diagonal
+    cusp::coo_matrix<int, float, cusp::host_memory> S(2, 40000, 2);
+    S.row_indices[0] = 0; S.column_indices[0] = 32767; S.values[0] = 1;
+    S.row_indices[1] = 1; S.column_indices[1] = 32768; S.values[1] = 2;
+
+    cusp::csr_matrix<int, float, Space>   A(S);
+    cusp::csr16_matrix<int, float, Space> B(A);
+    ASSERT_EQUAL(cusp::is_valid_matrix(B), true);
+
+    S.column_indices[1] = 32769;
+    cusp::csr_matrix<int, float, Space> C(S);
+
+    ASSERT_THROWS((cusp::csr16_matrix<int, float, Space>(C)), cusp::format_conversion_exception);
+
+    // and 32768 columns left of the diagonal
+    cusp::coo_matrix<int, float, cusp::host_memory> T(40000, 2, 1);
+    T.row_indices[0] = 32768; T.column_indices[0] = 0; T.values[0] = 1;
+
+    cusp::csr_matrix<int, float, Space>   D(T);
+    cusp::csr16_matrix<int, float, Space> E(D);
+    ASSERT_EQUAL(cusp::is_valid_matrix(E), true);
+
+    T.row_indices[0] = 32769;
+    cusp::csr_matrix<int, float, Space> F(T);
+
+    ASSERT_THROWS((cusp::csr16_matrix<int, float, Space>(F)), cusp::format_conversion_exception);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestCsr16MatrixConversionRange);
+
+template <typename SourceType, class Space>
+void CompareCsr16SpMV(const SourceType& S)
+{
+    cusp::csr_matrix<int, float, Space>   A(S);
+    cusp::csr16_matrix<int, float, Space> B(A);
+
+    cusp::array1d<float, cusp::host_memory> x(A.num_cols);
+    for(size_t i = 0; i < x.size(); i++)
+        x[i] = int(i % 5) - 2;
+
+    cusp::array1d<float, Space> d_x(x);
+    cusp::array1d<float, Space> y(A.num_rows, 0.0f);
+    cusp::array1d<float, Space> z(A.num_rows, 10.0f);
+
+    cusp::multiply(A, d_x, y);
+    cusp::multiply(B, d_x, z);
+
+    ASSERT_EQUAL(z, y);
+}
+
+template <class Space>
+void TestCsr16MatrixMultiply(void)
+{
+    cusp::csr_matrix<int, float, cusp::host_memory> A;
+    cusp::gallery::poisson5pt(A, 13, 17);
+    CompareCsr16SpMV<cusp::csr_matrix<int, float, cusp::host_memory>, Space>(A);
+
+    cusp::csr_matrix<int, float, cusp::host_memory> B;
+    cusp::gallery::poisson9pt(B, 20, 30);
+    CompareCsr16SpMV<cusp::csr_matrix<int, float, cusp::host_memory>, Space>(B);
+
+    cusp::csr_matrix<int, float, cusp::host_memory> C;
+    cusp::gallery::random(300, 200, 2000, C);
+    CompareCsr16SpMV<cusp::csr_matrix<int, float, cusp::host_memory>, Space>(C);
+
+    // long rows select the wider vectors
+    cusp::csr_matrix<int, float, cusp::host_memory> D;
+    cusp::gallery::random(100, 500, 5000, D);
+    CompareCsr16SpMV<cusp::csr_matrix<int, float, cusp::host_memory>, Space>(D);
+
+    // empty matrix
+    cusp::csr_matrix<int, float, cusp::host_memory> E(10, 10, 0);
+    thrust::fill(E.row_offsets.begin(), E.row_offsets.end(), 0);
+    CompareCsr16SpMV<cusp::csr_matrix<int, float, cusp::host_memory>, Space>(E);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestCsr16MatrixMultiply);
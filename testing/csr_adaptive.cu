@@ -0,0 +1,105 @@
+#include <unittest/unittest.h>
+
+#include <cusp/csr_adaptive.h>
+#include <cusp/multiply.h>
+#include <cusp/gallery/poisson.h>
+#include <cusp/gallery/random.h>
+
+template <typename Matrix>
+void CompareCsrAdaptiveSpMV(const Matrix& A)
+{
+    typedef typename Matrix::index_type IndexType;
+    typedef typename Matrix::value_type ValueType;
+
+    cusp::csr_adaptive_spmv<IndexType,ValueType> M(A);
+
+    ASSERT_EQUAL(M.num_rows, A.num_rows);
+    ASSERT_EQUAL(M.num_cols, A.num_cols);
+
+    // integer values keep every sum exact, whatever the order of the partial sums
+    cusp::array1d<ValueType,cusp::host_memory> x(A.num_cols);
+    for(size_t i = 0; i < x.size(); i++)
+        x[i] = int(i % 7) - 3;
+
+    cusp::array1d<ValueType,cusp::host_memory> y(A.num_rows);
+    cusp::multiply(A, x, y);
+
+    cusp::array1d<ValueType,cusp::device_memory> d_x(x);
+    cusp::array1d<ValueType,cusp::device_memory> d_y(A.num_rows, ValueType(10));
+
+    // the analysis is reused by every multiply
+    M(d_x, d_y);
+    ASSERT_EQUAL(d_y, y);
+
+    cusp::multiply(M, d_x, d_y);
+    ASSERT_EQUAL(d_y, y);
+}
+
+void TestCsrAdaptiveSpMV(void)
+{
+    cusp::csr_matrix<int,float,cusp::host_memory> A;
+    cusp::gallery::poisson5pt(A, 20, 30);
+    CompareCsrAdaptiveSpMV(A);
+
+    cusp::csr_matrix<int,float,cusp::host_memory> B;
+    cusp::gallery::random(300, 200, 2000, B);
+    CompareCsrAdaptiveSpMV(B);
+
+    // empty rows and rows for every bin, including rows processed by thread blocks
+    const size_t N = 6000;
+
+    std::vector<int> I, J;
+    for(size_t i = 0; i < N; i++)
+    {
+        const size_t length = (i % 1000 == 0) ? 5000 : (i % 3 == 0 ? 0 : (i * 7) % 70);
+
+        for(size_t k = 0; k < length; k++)
+        {
+            I.push_back(i);
+            J.push_back((i * 31 + k) % N);
+        }
+    }
+
+    cusp::coo_matrix<int,float,cusp::host_memory> C(N, N, I.size());
+    for(size_t n = 0; n < I.size(); n++)
+    {
+        C.row_indices[n]    = I[n];
+        C.column_indices[n] = J[n];
+        C.values[n]         = int(n % 5) - 2;
+    }
+    C.sort_by_row_and_column();
+
+    cusp::csr_matrix<int,float,cusp::host_memory> D(C);
+    CompareCsrAdaptiveSpMV(D);
+
+    cusp::csr_adaptive_spmv<int,float> M(D);
+
+    ASSERT_EQUAL(M.num_binned_rows(0), 6);
+
+    size_t num_rows = M.num_binned_rows(0);
+    for(size_t threads = 1; threads <= 32; threads *= 2)
+        num_rows += M.num_binned_rows(threads);
+    ASSERT_EQUAL(num_rows, N);
+
+    ASSERT_THROWS(M.num_binned_rows(3), cusp::invalid_input_exception);
+
+    // empty matrix
+    cusp::csr_matrix<int,float,cusp::host_memory> E(10, 10, 0);
+    thrust::fill(E.row_offsets.begin(), E.row_offsets.end(), 0);
+    CompareCsrAdaptiveSpMV(E);
+}
+DECLARE_UNITTEST(TestCsrAdaptiveSpMV);
+
+void TestCsrAdaptiveSpMVDimensions(void)
+{
+    cusp::csr_matrix<int,float,cusp::host_memory> A;
+    cusp::gallery::poisson5pt(A, 4, 4);
+
+    cusp::csr_adaptive_spmv<int,float> M(A);
+
+    cusp::array1d<float,cusp::device_memory> x(A.num_cols + 1);
+    cusp::array1d<float,cusp::device_memory> y(A.num_rows);
+
+    ASSERT_THROWS(M(x, y), cusp::invalid_input_exception);
+}
+DECLARE_UNITTEST(TestCsrAdaptiveSpMVDimensions);
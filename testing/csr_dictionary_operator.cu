@@ -0,0 +1,114 @@
+#include <unittest/unittest.h>
+
+#include <cusp/csr_dictionary_operator.h>
+#include <cusp/array1d.h>
+#include <cusp/coo_matrix.h>
+#include <cusp/csr_matrix.h>
+#include <cusp/multiply.h>
+#include <cusp/gallery/poisson.h>
+#include <cusp/krylov/cg.h>
+
+template <typename CodeType, typename MatrixType>
+void CheckDictionaryMultiply(const MatrixType& B)
+{
+    typedef typename MatrixType::index_type   IndexType;
+    typedef typename MatrixType::value_type   ValueType;
+    typedef typename MatrixType::memory_space MemorySpace;
+
+    cusp::csr_dictionary_operator<IndexType, ValueType, MemorySpace, CodeType> A(B);
+
+    ASSERT_EQUAL(A.num_rows,    B.num_rows);
+    ASSERT_EQUAL(A.num_cols,    B.num_cols);
+    ASSERT_EQUAL(A.num_entries, B.num_entries);
+
+    cusp::array1d<ValueType, cusp::host_memory> x_h(B.num_cols);
+    for (size_t i = 0; i < x_h.size(); i++)
+        x_h[i] = ValueType(i % 7) - 3;
+
+    cusp::array1d<ValueType, MemorySpace> x(x_h);
+    cusp::array1d<ValueType, MemorySpace> y(B.num_rows, ValueType(-1));
+    cusp::array1d<ValueType, MemorySpace> z(B.num_rows, ValueType(-1));
+
+    cusp::multiply(A, x, y);
+    cusp::multiply(B, x, z);
+
+    ASSERT_EQUAL(y, z);
+}
+
+template <class MemorySpace>
+void TestCsrDictionaryOperator(void)
+{
+    cusp::csr_matrix<int, float, MemorySpace> A;
+    cusp::gallery::poisson5pt(A, 20, 15);
+
+    cusp::csr_dictionary_operator<int, float, MemorySpace> D(A);
+
+    // -1 and 4
+    ASSERT_EQUAL(D.dictionary.size(), size_t(2));
+    ASSERT_EQUAL(float(D.dictionary[0]), -1.0f);
+    ASSERT_EQUAL(float(D.dictionary[1]),  4.0f);
+    ASSERT_EQUAL(D.row_offsets, A.row_offsets);
+    ASSERT_EQUAL(D.column_indices, A.column_indices);
+
+    CheckDictionaryMultiply<unsigned char>(A);
+
+    cusp::csr_matrix<int, double, MemorySpace> B;
+    cusp::gallery::poisson9pt(B, 13, 11);
+    CheckDictionaryMultiply<unsigned char>(B);
+
+    // a copy in host memory
+    cusp::csr_dictionary_operator<int, float, cusp::host_memory> D_h(D);
+    ASSERT_EQUAL(D_h.dictionary.size(), size_t(2));
+    ASSERT_EQUAL((cusp::array1d<unsigned char, cusp::host_memory>(D.codes)), D_h.codes);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestCsrDictionaryOperator);
+
+template <class MemorySpace>
+void TestCsrDictionaryOperatorCodeType(void)
+{
+    // 300 distinct values, and an empty row
+    cusp::coo_matrix<int, float, cusp::host_memory> C(4, 300, 300);
+
+    for (int n = 0; n < 300; n++)
+    {
+        C.row_indices[n]    = n < 150 ? 0 : 2 + n % 2;
+        C.column_indices[n] = n;
+        C.values[n]         = float(n) / 4;
+    }
+
+    C.sort_by_row_and_column();
+
+    cusp::csr_matrix<int, float, MemorySpace> A(C);
+
+    ASSERT_THROWS((cusp::csr_dictionary_operator<int, float, MemorySpace, unsigned char>(A)),
+                  cusp::invalid_input_exception);
+
+    CheckDictionaryMultiply<unsigned short>(A);
+
+    // no entries
+    cusp::csr_matrix<int, float, MemorySpace> E(5, 5, 0);
+    CheckDictionaryMultiply<unsigned char>(E);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestCsrDictionaryOperatorCodeType);
+
+template <class MemorySpace>
+void TestCsrDictionaryOperatorConjugateGradient(void)
+{
+    cusp::csr_matrix<int, float, MemorySpace> B;
+    cusp::gallery::poisson5pt(B, 10, 10);
+
+    cusp::csr_dictionary_operator<int, float, MemorySpace> A(B);
+
+    cusp::array1d<float, MemorySpace> x(A.num_rows, 0.0f);
+    cusp::array1d<float, MemorySpace> b(A.num_rows, 1.0f);
+
+    cusp::default_monitor<float> monitor(b, 20, 1e-4);
+    cusp::krylov::cg(A, x, b, monitor);
+
+    cusp::array1d<float, MemorySpace> residual(A.num_rows, 0.0f);
+    cusp::multiply(B, x, residual);
+    cusp::blas::axpby(residual, b, residual, -1.0f, 1.0f);
+
+    ASSERT_EQUAL(cusp::blas::nrm2(residual) < 1e-4 * cusp::blas::nrm2(b), true);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestCsrDictionaryOperatorConjugateGradient);
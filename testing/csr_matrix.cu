@@ -1,6 +1,8 @@
 #include <unittest/unittest.h>
 #include <cusp/csr_matrix.h>
 
+#include <map>
+
 template <class Space>
 void TestCsrMatrixBasicConstructor(void)
 {
@@ -117,3 +119,97 @@ void TestCsrMatrixRebind(void)
 }
 DECLARE_UNITTEST(TestCsrMatrixRebind);
 
+
+// rows short enough for an insertion sort, a heapsort and the shared sort,
+// with shuffled columns which repeat
+void unsorted_csr_matrix(cusp::csr_matrix<int,float,cusp::host_memory>& A)
+{
+    const int lengths[5] = {0, 7, 3, 90, 700};
+
+    A.resize(5, 50, 800);
+    A.row_offsets[0] = 0;
+
+    int n = 0;
+    for (int i = 0; i < 5; i++)
+    {
+        for (int k = 0; k < lengths[i]; k++, n++)
+        {
+            A.column_indices[n] = (37 * n + 11 * i) % 50;
+            A.values[n] = float(n % 13);
+        }
+
+        A.row_offsets[i + 1] = n;
+    }
+}
+
+template <class Space>
+void TestCsrMatrixSortByColumn(void)
+{
+    cusp::csr_matrix<int,float,cusp::host_memory> A;
+    unsorted_csr_matrix(A);
+
+    cusp::csr_matrix<int,float,Space> B(A);
+    B.sort_by_column();
+
+    cusp::csr_matrix<int,float,cusp::host_memory> C(B);
+
+    ASSERT_EQUAL(C.row_offsets == A.row_offsets, true);
+
+    for (int i = 0; i < 5; i++)
+    {
+        std::multimap<int,float> row;
+        for (int k = A.row_offsets[i]; k < A.row_offsets[i + 1]; k++)
+            row.insert(std::make_pair(int(A.column_indices[k]), float(A.values[k])));
+
+        float sum = 0;
+        for (std::multimap<int,float>::iterator it = row.begin(); it != row.end(); it++)
+            sum += it->second;
+
+        float sorted_sum = 0;
+        std::multimap<int,float>::iterator it = row.begin();
+        for (int k = C.row_offsets[i]; k < C.row_offsets[i + 1]; k++, it++)
+        {
+            ASSERT_EQUAL(C.column_indices[k], it->first);
+            sorted_sum += C.values[k];
+        }
+
+        ASSERT_EQUAL(sorted_sum, sum);
+    }
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestCsrMatrixSortByColumn);
+
+template <class Space>
+void TestCsrMatrixSumDuplicates(void)
+{
+    cusp::csr_matrix<int,float,cusp::host_memory> A;
+    unsorted_csr_matrix(A);
+
+    cusp::csr_matrix<int,float,Space> B(A);
+    B.sum_duplicates();
+
+    cusp::csr_matrix<int,float,cusp::host_memory> C(B);
+
+    size_t num_entries = 0;
+
+    for (int i = 0; i < 5; i++)
+    {
+        std::map<int,float> row;
+        for (int k = A.row_offsets[i]; k < A.row_offsets[i + 1]; k++)
+            row[A.column_indices[k]] += A.values[k];
+
+        ASSERT_EQUAL(C.row_offsets[i], int(num_entries));
+        num_entries += row.size();
+
+        std::map<int,float>::iterator it = row.begin();
+        for (int k = C.row_offsets[i]; k < C.row_offsets[i + 1]; k++, it++)
+        {
+            ASSERT_EQUAL(C.column_indices[k], it->first);
+            ASSERT_EQUAL(C.values[k], it->second);
+        }
+    }
+
+    ASSERT_EQUAL(C.num_entries, num_entries);
+    ASSERT_EQUAL(C.row_offsets[5], int(num_entries));
+    ASSERT_EQUAL(C.column_indices.size(), num_entries);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestCsrMatrixSumDuplicates);
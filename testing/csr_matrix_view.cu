@@ -1,6 +1,8 @@
 #include <unittest/unittest.h>
 
+#include <cusp/coo_matrix.h>
 #include <cusp/csr_matrix.h>
+#include <cusp/ell_matrix.h>
 #include <cusp/multiply.h>
 
 template <typename MemorySpace>
@@ -187,3 +189,129 @@ void TestMakeCsrMatrixView(void)
 }
 DECLARE_HOST_DEVICE_UNITTEST(TestMakeCsrMatrixView);
 
+
+template <typename MemorySpace>
+void TestMakeCsrMatrixViewFromPointers(void)
+{
+  typedef int                                                           IndexType;
+  typedef float                                                         ValueType;
+  typedef typename cusp::csr_matrix<IndexType,ValueType,MemorySpace>    Matrix;
+
+  // [10  0 20]
+  // [ 0  0  0]
+  // [ 0  0 30]
+  // [40 50 60]
+  Matrix M(4, 3, 6);
+  M.row_offsets[0] = 0;  M.row_offsets[1] = 2;  M.row_offsets[2] = 2;  M.row_offsets[3] = 3;  M.row_offsets[4] = 6;
+  M.column_indices[0] = 0;  M.values[0] = 10;
+  M.column_indices[1] = 2;  M.values[1] = 20;
+  M.column_indices[2] = 2;  M.values[2] = 30;
+  M.column_indices[3] = 0;  M.values[3] = 40;
+  M.column_indices[4] = 1;  M.values[4] = 50;
+  M.column_indices[5] = 2;  M.values[5] = 60;
+
+  IndexType * row_offsets    = thrust::raw_pointer_cast(&M.row_offsets[0]);
+  IndexType * column_indices = thrust::raw_pointer_cast(&M.column_indices[0]);
+  ValueType * values         = thrust::raw_pointer_cast(&M.values[0]);
+
+  // the view has the same type as the view of a csr_matrix
+  typename Matrix::view V =
+    cusp::make_csr_matrix_view(4, 3, 6, row_offsets, column_indices, values, MemorySpace());
+
+  ASSERT_EQUAL(V.num_rows,    4);
+  ASSERT_EQUAL(V.num_cols,    3);
+  ASSERT_EQUAL(V.num_entries, 6);
+
+  ASSERT_EQUAL_QUIET(V.row_offsets.begin(),    M.row_offsets.begin());
+  ASSERT_EQUAL_QUIET(V.row_offsets.end(),      M.row_offsets.end());
+  ASSERT_EQUAL_QUIET(V.column_indices.begin(), M.column_indices.begin());
+  ASSERT_EQUAL_QUIET(V.column_indices.end(),   M.column_indices.end());
+  ASSERT_EQUAL_QUIET(V.values.begin(),         M.values.begin());
+  ASSERT_EQUAL_QUIET(V.values.end(),           M.values.end());
+
+  // and const pointers give its const_view
+  typename Matrix::const_view C =
+    cusp::make_csr_matrix_view(4, 3, 6,
+                               (const IndexType *) row_offsets,
+                               (const IndexType *) column_indices,
+                               (const ValueType *) values,
+                               MemorySpace());
+
+  cusp::array1d<ValueType, MemorySpace> x(3);
+  x[0] = 1;  x[1] = 2;  x[2] = 3;
+
+  cusp::array1d<ValueType, MemorySpace> y(4);
+
+  cusp::multiply(C, x, y);
+
+  ASSERT_EQUAL(y[0],  70);
+  ASSERT_EQUAL(y[1],   0);
+  ASSERT_EQUAL(y[2],  90);
+  ASSERT_EQUAL(y[3], 320);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestMakeCsrMatrixViewFromPointers);
+
+template <typename MemorySpace>
+void TestCsrMatrixViewWideOffsets(void)
+{
+  typedef int                                                           IndexType;
+  typedef long long                                                     OffsetType;
+  typedef float                                                         ValueType;
+
+  // [10  0 20]
+  // [ 0  0  0]
+  // [ 0  0 30]
+  // [40 50 60]
+  cusp::array1d<OffsetType, MemorySpace> row_offsets(5);
+  cusp::array1d<IndexType,  MemorySpace> column_indices(6);
+  cusp::array1d<ValueType,  MemorySpace> values(6);
+
+  row_offsets[0] = 0;  row_offsets[1] = 2;  row_offsets[2] = 2;  row_offsets[3] = 3;  row_offsets[4] = 6;
+  column_indices[0] = 0;  values[0] = 10;
+  column_indices[1] = 2;  values[1] = 20;
+  column_indices[2] = 2;  values[2] = 30;
+  column_indices[3] = 0;  values[3] = 40;
+  column_indices[4] = 1;  values[4] = 50;
+  column_indices[5] = 2;  values[5] = 60;
+
+  // 64-bit row offsets with 32-bit column indices
+  OffsetType * Ap = thrust::raw_pointer_cast(&row_offsets[0]);
+  IndexType  * Aj = thrust::raw_pointer_cast(&column_indices[0]);
+  ValueType  * Ax = thrust::raw_pointer_cast(&values[0]);
+
+  typedef typename cusp::array1d<OffsetType, MemorySpace>::view OffsetView;
+  typedef typename cusp::array1d<IndexType,  MemorySpace>::view IndexView;
+  typedef typename cusp::array1d<ValueType,  MemorySpace>::view ValueView;
+
+  cusp::csr_matrix_view<OffsetView, IndexView, ValueView, IndexType, ValueType, MemorySpace> V =
+    cusp::make_csr_matrix_view(4, 3, 6, Ap, Aj, Ax, MemorySpace());
+
+  cusp::array1d<ValueType, MemorySpace> x(3);
+  x[0] = 1;  x[1] = 2;  x[2] = 3;
+
+  cusp::array1d<ValueType, MemorySpace> y(4);
+
+  cusp::multiply(V, x, y);
+
+  ASSERT_EQUAL(y[0],  70);
+  ASSERT_EQUAL(y[1],   0);
+  ASSERT_EQUAL(y[2],  90);
+  ASSERT_EQUAL(y[3], 320);
+
+  // conversions read the entries through the wide offsets
+  cusp::coo_matrix<IndexType, ValueType, MemorySpace> C(V);
+
+  ASSERT_EQUAL(C.num_entries, 6);
+  ASSERT_EQUAL(C.row_indices[2], 2);
+  ASSERT_EQUAL(C.row_indices[3], 3);
+  ASSERT_EQUAL(C.column_indices[4], 1);
+  ASSERT_EQUAL(C.values[5], 60);
+
+  cusp::ell_matrix<IndexType, ValueType, MemorySpace> E(V);
+
+  cusp::array1d<ValueType, MemorySpace> z(4);
+  cusp::multiply(E, x, z);
+
+  ASSERT_EQUAL(z, y);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestCsrMatrixViewWideOffsets);
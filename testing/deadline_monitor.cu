@@ -0,0 +1,96 @@
+#include <unittest/unittest.h>
+
+#include <cusp/deadline_monitor.h>
+
+#include <cusp/csr_matrix.h>
+#include <cusp/gallery/poisson.h>
+#include <cusp/krylov/cg.h>
+
+#include <limits>
+
+template <typename MemorySpace>
+void TestDeadlineMonitor(void)
+{
+    cusp::array1d<float,MemorySpace> b(4, 1.0f);
+
+    // a budget which is never reached behaves as interval_monitor
+    cusp::deadline_monitor<float> monitor(b, 1e9, 10, 0.25, 0.0, 1);
+
+    ASSERT_EQUAL(monitor.time_limit(), 1e9);
+    ASSERT_EQUAL(monitor.will_converge_in_time(), true);
+
+    ASSERT_EQUAL(monitor.finished(1.0f), false);
+    ASSERT_EQUAL(monitor.projected_time(), std::numeric_limits<double>::infinity());
+
+    ++monitor;
+    ASSERT_EQUAL(monitor.finished(2.0f), false);
+    ASSERT_EQUAL(monitor.best_residual_norm(), 1.0f);
+
+    // the residual grows, so the tolerance is never reached
+    ASSERT_EQUAL(monitor.will_converge_in_time(), false);
+
+    ++monitor;
+    ASSERT_EQUAL(monitor.finished(0.75f), false);
+    ASSERT_EQUAL(monitor.best_residual_norm(), 0.75f);
+    ASSERT_EQUAL(monitor.will_converge_in_time(), true);
+
+    cusp::array1d<float,MemorySpace> r(4, 0.2f);
+    ASSERT_EQUAL(monitor.finished(r), true);
+    ASSERT_EQUAL(monitor.converged(), true);
+    ASSERT_EQUAL(monitor.timed_out(), false);
+    ASSERT_EQUAL(monitor.stopped_late(), false);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestDeadlineMonitor);
+
+template <typename MemorySpace>
+void TestDeadlineMonitorTimeout(void)
+{
+    cusp::array1d<float,MemorySpace> b(4, 1.0f);
+
+    // an empty budget stops at the first test
+    cusp::deadline_monitor<float> monitor(b, 0.0, 10, 0.25, 0.0, 1);
+
+    ASSERT_EQUAL(monitor.finished(1.0f), true);
+    ASSERT_EQUAL(monitor.timed_out(), true);
+    ASSERT_EQUAL(monitor.converged(), false);
+    ASSERT_EQUAL(monitor.iteration_count(), 0);
+
+    // a residual which stalls is abandoned at once
+    cusp::deadline_monitor<float> late(b, 1e9, 10, 0.25, 0.0, 1, cusp::wall_clock, true);
+
+    ASSERT_EQUAL(late.finished(1.0f), false);
+    ++late;
+    ASSERT_EQUAL(late.finished(1.0f), true);
+    ASSERT_EQUAL(late.stopped_late(), true);
+    ASSERT_EQUAL(late.timed_out(), false);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestDeadlineMonitorTimeout);
+
+void TestDeadlineMonitorDeviceClock(void)
+{
+    cusp::csr_matrix<int, float, cusp::device_memory> A;
+    cusp::gallery::poisson5pt(A, 50, 50);
+
+    cusp::array1d<float, cusp::device_memory> x(A.num_rows, 0.0f);
+    cusp::array1d<float, cusp::device_memory> b(A.num_rows, 1.0f);
+
+    // the device clock stops the solve without converging
+    cusp::deadline_monitor<float> monitor(b, 0.0, 1000, 1e-6, 0.0, 5, cusp::device_clock);
+
+    cusp::krylov::cg(A, x, b, monitor);
+
+    ASSERT_EQUAL(monitor.timed_out(), true);
+    ASSERT_EQUAL(monitor.converged(), false);
+    ASSERT_EQUAL(monitor.iteration_count() < 1000, true);
+    ASSERT_EQUAL(monitor.best_residual_norm() <= cusp::blas::nrm2(b), true);
+
+    // a generous budget converges
+    cusp::blas::fill(x, 0.0f);
+    cusp::deadline_monitor<float> relaxed(b, 1e9, 1000, 1e-6, 0.0, 5, cusp::device_clock);
+
+    cusp::krylov::cg(A, x, b, relaxed);
+
+    ASSERT_EQUAL(relaxed.converged(), true);
+    ASSERT_EQUAL(relaxed.timed_out(), false);
+}
+DECLARE_UNITTEST(TestDeadlineMonitorDeviceClock);
@@ -0,0 +1,144 @@
+#include <unittest/unittest.h>
+
+#include <cusp/device_cache.h>
+#include <cusp/array1d.h>
+#include <cusp/coo_matrix.h>
+#include <cusp/csr_matrix.h>
+#include <cusp/multiply.h>
+#include <cusp/stream.h>
+#include <cusp/gallery/poisson.h>
+
+void TestDeviceCacheReuse(void)
+{
+    cusp::trim_device_cache();
+
+    {
+        cusp::array1d<float, cusp::device_memory> x(1000, 1.0f);
+    }
+
+    cusp::device_cache_statistics before = cusp::device_cache_usage();
+
+    {
+        // same size class as the freed vector
+        cusp::array1d<float, cusp::device_memory> y(900, 2.0f);
+        ASSERT_EQUAL(y[899], 2.0f);
+    }
+
+    cusp::device_cache_statistics after = cusp::device_cache_usage();
+
+#if defined(CUSP_USE_DEVICE_CACHE)
+    ASSERT_EQUAL(after.hits, before.hits + 1);
+    ASSERT_EQUAL(after.device_mallocs, before.device_mallocs);
+    ASSERT_EQUAL(after.cached_bytes > 0, true);
+
+    cusp::trim_device_cache();
+    ASSERT_EQUAL(cusp::device_cache_usage().cached_bytes, size_t(0));
+#else
+    ASSERT_EQUAL(after.allocations, size_t(0));
+#endif
+}
+DECLARE_UNITTEST(TestDeviceCacheReuse);
+
+void TestDeviceCacheScope(void)
+{
+    {
+        cusp::array1d<float, cusp::device_memory> x(1000, 1.0f);
+    }
+
+    {
+        cusp::device_cache_scope scope(false);
+
+        // disabling releases the cache and bypasses it
+        ASSERT_EQUAL(cusp::device_cache_usage().cached_bytes, size_t(0));
+
+        cusp::array1d<float, cusp::device_memory> x(1000, 1.0f);
+        cusp::array1d<float, cusp::device_memory> y(x);
+        ASSERT_EQUAL(y[999], 1.0f);
+    }
+
+    ASSERT_EQUAL(cusp::device_cache_usage().cached_bytes, size_t(0));
+}
+DECLARE_UNITTEST(TestDeviceCacheScope);
+
+void TestDeviceCacheLimit(void)
+{
+    cusp::set_device_cache_limit(4096);
+
+    {
+        cusp::array1d<float, cusp::device_memory> x(100000, 1.0f);
+    }
+
+    // beyond the limit the block is released
+    ASSERT_EQUAL(cusp::device_cache_usage().cached_bytes <= size_t(4096), true);
+
+    cusp::set_device_cache_limit(size_t(-1));
+}
+DECLARE_UNITTEST(TestDeviceCacheLimit);
+
+void TestDeviceCacheStreams(void)
+{
+    cusp::csr_matrix<int, float, cusp::device_memory> A;
+    cusp::gallery::poisson5pt(A, 20, 20);
+
+    cusp::array1d<float, cusp::device_memory> x(A.num_rows, 1.0f);
+    cusp::array1d<float, cusp::device_memory> y_reference(A.num_rows);
+    cusp::multiply(A, x, y_reference);
+
+    cudaStream_t s0, s1;
+    cudaStreamCreate(&s0);
+    cudaStreamCreate(&s1);
+
+    cusp::array1d<float, cusp::device_memory> y0, y1;
+
+    // temporaries freed on one stream and reused on the other
+    for (int i = 0; i < 4; i++)
+    {
+        {
+            cusp::stream_scope scope(s0);
+            cusp::array1d<float, cusp::device_memory> t(x);
+            cusp::multiply(A, t, y0);
+        }
+        {
+            cusp::stream_scope scope(s1);
+            cusp::array1d<float, cusp::device_memory> t(x);
+            cusp::multiply(A, t, y1);
+        }
+    }
+
+    cudaStreamSynchronize(s0);
+    cudaStreamSynchronize(s1);
+
+    ASSERT_EQUAL(y0, y_reference);
+    ASSERT_EQUAL(y1, y_reference);
+
+    cudaStreamDestroy(s0);
+    cudaStreamDestroy(s1);
+}
+DECLARE_UNITTEST(TestDeviceCacheStreams);
+
+void TestDeviceCacheCooSpmvScratch(void)
+{
+    cusp::coo_matrix<int, float, cusp::device_memory> A;
+    cusp::gallery::poisson5pt(A, 40, 40);
+
+    cusp::array1d<float, cusp::device_memory> x(A.num_rows, 1.0f);
+    cusp::array1d<float, cusp::device_memory> y0(A.num_rows);
+    cusp::array1d<float, cusp::device_memory> y1(A.num_rows);
+
+    cusp::multiply(A, x, y0);
+
+    cusp::device_cache_statistics before = cusp::device_cache_usage();
+
+    // the tile states of the second product come from the cache
+    cusp::multiply(A, x, y1);
+
+    cusp::device_cache_statistics after = cusp::device_cache_usage();
+
+    ASSERT_EQUAL(y1, y0);
+
+#if defined(CUSP_USE_DEVICE_CACHE)
+    ASSERT_EQUAL(after.device_mallocs, before.device_mallocs);
+    ASSERT_EQUAL(after.hits > before.hits, true);
+#endif
+}
+DECLARE_UNITTEST(TestDeviceCacheCooSpmvScratch);
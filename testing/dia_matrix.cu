@@ -1,5 +1,8 @@
 #include <unittest/unittest.h>
 #include <cusp/dia_matrix.h>
+#include <cusp/csr_matrix.h>
+#include <cusp/multiply.h>
+#include <cusp/gallery/poisson.h>
 
 template <class Space>
 void TestDiaMatrixBasicConstructor(void)
@@ -120,3 +123,50 @@ void TestDiaMatrixRebind(void)
 }
 DECLARE_UNITTEST(TestDiaMatrixRebind);
 
+
+template <typename ValueType>
+void CheckDiaMatrixMultiply(const cusp::dia_matrix<int, ValueType, cusp::host_memory>& A)
+{
+    cusp::array1d<ValueType, cusp::host_memory> x(A.num_cols);
+    for (size_t i = 0; i < x.size(); i++)
+        x[i] = ValueType(i % 11) - 5;
+
+    cusp::array1d<ValueType, cusp::host_memory> y(A.num_rows);
+    cusp::multiply(A, x, y);
+
+    cusp::dia_matrix<int, ValueType, cusp::device_memory> A_d(A);
+    cusp::array1d<ValueType, cusp::device_memory> x_d(x);
+    cusp::array1d<ValueType, cusp::device_memory> y_d(A.num_rows, ValueType(-1));
+    cusp::multiply(A_d, x_d, y_d);
+
+    ASSERT_ALMOST_EQUAL((cusp::array1d<ValueType, cusp::host_memory>(y_d)), y);
+}
+
+void TestDiaMatrixTiledMultiply(void)
+{
+    // all the diagonals in one tile of x
+    cusp::dia_matrix<int, float, cusp::host_memory> A;
+    cusp::gallery::poisson5pt(A, 30, 40);
+    CheckDiaMatrixMultiply(A);
+
+    // the diagonals at -nx and nx each in their own tile
+    cusp::gallery::poisson5pt(A, 700, 3);
+    CheckDiaMatrixMultiply(A);
+
+    // nine tiles of three diagonals
+    cusp::dia_matrix<int, double, cusp::host_memory> B;
+    cusp::gallery::poisson27pt(B, 30, 25, 6);
+    CheckDiaMatrixMultiply(B);
+
+    // offsets out of order, and rectangular
+    cusp::dia_matrix<int, float, cusp::host_memory> C(500, 2000, 2500, 5);
+    const int offsets[5] = {1500, -3, 0, 1200, 2};
+    for (int n = 0; n < 5; n++)
+    {
+        C.diagonal_offsets[n] = offsets[n];
+        for (int i = 0; i < 500; i++)
+            C.values(i, n) = float(n + 1) + float(i % 3);
+    }
+    CheckDiaMatrixMultiply(C);
+}
+DECLARE_UNITTEST(TestDiaMatrixTiledMultiply);
@@ -0,0 +1,132 @@
+#include <unittest/unittest.h>
+
+#include <cusp/distributed_array1d.h>
+#include <cusp/blas.h>
+
+// places part p on device p, wrapping around when there are fewer devices
+std::vector<int> distributed_devices(size_t num_parts)
+{
+    int num_devices = 1;
+    cudaGetDeviceCount(&num_devices);
+
+    std::vector<int> devices(num_parts);
+    for(size_t p = 0; p < num_parts; p++)
+        devices[p] = p % num_devices;
+
+    return devices;
+}
+
+void TestDistributedLayout(void)
+{
+    cusp::distributed_layout layout(10, std::vector<int>(3, 0));
+
+    ASSERT_EQUAL(layout.num_parts(), 3);
+    ASSERT_EQUAL(layout.size(),     10);
+
+    ASSERT_EQUAL(layout.offsets[0],  0);
+    ASSERT_EQUAL(layout.offsets[1],  4);
+    ASSERT_EQUAL(layout.offsets[2],  7);
+    ASSERT_EQUAL(layout.offsets[3], 10);
+
+    ASSERT_EQUAL(layout.part_size(0), 4);
+    ASSERT_EQUAL(layout.part_size(2), 3);
+
+    ASSERT_EQUAL(layout.owner(0), 0);
+    ASSERT_EQUAL(layout.owner(3), 0);
+    ASSERT_EQUAL(layout.owner(4), 1);
+    ASSERT_EQUAL(layout.owner(9), 2);
+
+    ASSERT_EQUAL(layout == cusp::distributed_layout(10, std::vector<int>(3, 0)), true);
+    ASSERT_EQUAL(layout != cusp::distributed_layout(10, std::vector<int>(2, 0)), true);
+
+    ASSERT_THROWS(cusp::distributed_layout(10, std::vector<int>()), cusp::invalid_input_exception);
+}
+DECLARE_UNITTEST(TestDistributedLayout);
+
+void TestDistributedArray1dScatterGather(void)
+{
+    cusp::distributed_layout layout(11, distributed_devices(3));
+
+    cusp::array1d<float,cusp::host_memory> x(11);
+    for(size_t i = 0; i < x.size(); i++)
+        x[i] = i;
+
+    cusp::distributed_array1d<float> d_x(layout, x);
+
+    ASSERT_EQUAL(d_x.size(),              11);
+    ASSERT_EQUAL(d_x.num_parts(),          3);
+    ASSERT_EQUAL(d_x.parts[0].size(),      4);
+    ASSERT_EQUAL(d_x.parts[1].size(),      4);
+    ASSERT_EQUAL(d_x.parts[2].size(),      3);
+    ASSERT_EQUAL(float(d_x.parts[1][0]),   4);
+    ASSERT_EQUAL(float(d_x.parts[2][2]),  10);
+
+    cusp::array1d<float,cusp::device_memory> y;
+    d_x.gather(y);
+    ASSERT_EQUAL(y, x);
+
+    // copies are independent
+    cusp::distributed_array1d<float> d_z(d_x);
+    cusp::blas::fill(d_x, 0.0f);
+
+    cusp::array1d<float,cusp::host_memory> z;
+    d_z.gather(z);
+    ASSERT_EQUAL(z, x);
+
+    ASSERT_THROWS(d_x.scatter(cusp::array1d<float,cusp::host_memory>(10)), cusp::invalid_input_exception);
+}
+DECLARE_UNITTEST(TestDistributedArray1dScatterGather);
+
+void TestDistributedArray1dBlas(void)
+{
+    const size_t N = 1000;
+
+    cusp::array1d<float,cusp::host_memory> x(N);
+    cusp::array1d<float,cusp::host_memory> y(N);
+    for(size_t i = 0; i < N; i++)
+    {
+        x[i] = int(i % 7) - 3;
+        y[i] = int(i % 5) - 2;
+    }
+
+    for(size_t num_parts = 1; num_parts <= 4; num_parts++)
+    {
+        cusp::distributed_layout layout(N, distributed_devices(num_parts));
+
+        cusp::distributed_array1d<float> d_x(layout, x);
+        cusp::distributed_array1d<float> d_y(layout, y);
+        cusp::distributed_array1d<float> d_z(layout);
+
+        ASSERT_EQUAL(cusp::blas::dot(d_x, d_y),  cusp::blas::dot(x, y));
+        ASSERT_EQUAL(cusp::blas::dotc(d_x, d_y), cusp::blas::dotc(x, y));
+        ASSERT_ALMOST_EQUAL(cusp::blas::nrm2(d_x), cusp::blas::nrm2(x));
+
+        cusp::array1d<float,cusp::host_memory> z(N);
+        cusp::array1d<float,cusp::host_memory> result;
+
+        cusp::blas::axpby(d_x, d_y, d_z, 2.0f, -1.0f);
+        cusp::blas::axpby(x, y, z, 2.0f, -1.0f);
+        d_z.gather(result);
+        ASSERT_EQUAL(result, z);
+
+        cusp::blas::axpy(d_x, d_z, 3.0f);
+        cusp::blas::axpy(x, z, 3.0f);
+        d_z.gather(result);
+        ASSERT_EQUAL(result, z);
+
+        cusp::blas::scal(d_z, 0.5f);
+        cusp::blas::scal(z, 0.5f);
+        d_z.gather(result);
+        ASSERT_EQUAL(result, z);
+
+        cusp::blas::copy(d_x, d_z);
+        d_z.gather(result);
+        ASSERT_EQUAL(result, x);
+    }
+
+    // layouts must match
+    cusp::distributed_array1d<float> d_x(cusp::distributed_layout(N, distributed_devices(2)), x);
+    cusp::distributed_array1d<float> d_y(cusp::distributed_layout(N, distributed_devices(3)), y);
+    ASSERT_THROWS(cusp::blas::dot(d_x, d_y), cusp::invalid_input_exception);
+}
+DECLARE_UNITTEST(TestDistributedArray1dBlas);
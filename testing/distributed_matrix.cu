@@ -0,0 +1,175 @@
+#include <unittest/unittest.h>
+
+#include <cusp/distributed_matrix.h>
+#include <cusp/csr_matrix.h>
+#include <cusp/hyb_matrix.h>
+#include <cusp/multiply.h>
+#include <cusp/gallery/poisson.h>
+#include <cusp/gallery/random.h>
+
+// assigns the parts to the available devices in turn
+std::vector<int> round_robin_devices(size_t num_parts)
+{
+    int num_devices = 1;
+    cudaGetDeviceCount(&num_devices);
+
+    std::vector<int> devices(num_parts);
+    for(size_t p = 0; p < num_parts; p++)
+        devices[p] = p % num_devices;
+
+    return devices;
+}
+
+void TestDistributedMatrixPartition(void)
+{
+    // 1D Poisson matrix of 9 rows in three parts
+    cusp::coo_matrix<int,float,cusp::host_memory> A(9, 9, 25);
+    for(int i = 0, n = 0; i < 9; i++)
+    {
+        if (i > 0) { A.row_indices[n] = i; A.column_indices[n] = i - 1; A.values[n] = -1; n++; }
+                     A.row_indices[n] = i; A.column_indices[n] = i;     A.values[n] =  2; n++;
+        if (i < 8) { A.row_indices[n] = i; A.column_indices[n] = i + 1; A.values[n] = -1; n++; }
+    }
+
+    cusp::distributed_matrix< cusp::csr_matrix<int,float,cusp::device_memory> > B(A, round_robin_devices(3));
+
+    ASSERT_EQUAL(B.num_rows,    9);
+    ASSERT_EQUAL(B.num_cols,    9);
+    ASSERT_EQUAL(B.num_entries, 25);
+    ASSERT_EQUAL(B.parts.size(), 3);
+
+    // interior blocks are tridiagonal 3x3 matrices
+    ASSERT_EQUAL(B.parts[0].interior.num_entries, 7);
+    ASSERT_EQUAL(B.parts[1].interior.num_entries, 7);
+    ASSERT_EQUAL(B.parts[2].interior.num_entries, 7);
+
+    // the middle part needs one entry of each neighbour
+    ASSERT_EQUAL(B.parts[0].boundary.num_entries, 1);
+    ASSERT_EQUAL(B.parts[1].boundary.num_entries, 2);
+    ASSERT_EQUAL(B.parts[2].boundary.num_entries, 1);
+    ASSERT_EQUAL(B.parts[1].halo.size(),          2);
+    ASSERT_EQUAL(B.num_halo_entries(),            4);
+
+    ASSERT_EQUAL(B.parts[0].messages.size(), 1);
+    ASSERT_EQUAL(B.parts[1].messages.size(), 2);
+    ASSERT_EQUAL(B.parts[1].sources.size(),  2);
+
+    // non-square matrices and mismatched layouts are rejected
+    cusp::csr_matrix<int,float,cusp::host_memory> C(4, 5, 0);
+    ASSERT_THROWS((cusp::distributed_matrix< cusp::csr_matrix<int,float,cusp::device_memory> >(C, round_robin_devices(2))),
+                  cusp::invalid_input_exception);
+    ASSERT_THROWS((cusp::distributed_matrix< cusp::csr_matrix<int,float,cusp::device_memory> >(A, cusp::distributed_layout(8, round_robin_devices(2)))),
+                  cusp::invalid_input_exception);
+}
+DECLARE_UNITTEST(TestDistributedMatrixPartition);
+
+template <typename LocalMatrix>
+void CompareDistributedSpMV(const cusp::csr_matrix<int,float,cusp::host_memory>& A, size_t num_parts)
+{
+    cusp::distributed_matrix<LocalMatrix> B(A, round_robin_devices(num_parts));
+
+    cusp::array1d<float,cusp::host_memory> x(A.num_cols);
+    for(size_t i = 0; i < x.size(); i++)
+        x[i] = int(i % 5) - 2;
+
+    cusp::array1d<float,cusp::host_memory> y(A.num_rows);
+    cusp::multiply(A, x, y);
+
+    cusp::distributed_array1d<float> d_x(B.layout, x);
+    cusp::distributed_array1d<float> d_y(B.layout, 10.0f);
+
+    // repeated products reuse the halo buffers
+    cusp::multiply(B, d_x, d_y);
+    cusp::multiply(B, d_x, d_y);
+
+    cusp::array1d<float,cusp::host_memory> z;
+    d_y.gather(z);
+
+    ASSERT_ALMOST_EQUAL(z, y);
+}
+
+void TestDistributedMatrixMultiply(void)
+{
+    typedef cusp::csr_matrix<int,float,cusp::device_memory> CsrMatrix;
+    typedef cusp::hyb_matrix<int,float,cusp::device_memory> HybMatrix;
+
+    cusp::csr_matrix<int,float,cusp::host_memory> A;
+    cusp::gallery::poisson5pt(A, 13, 17);
+
+    cusp::csr_matrix<int,float,cusp::host_memory> B;
+    cusp::gallery::random(300, 300, 3000, B);
+
+    for(size_t num_parts = 1; num_parts <= 8; num_parts++)
+    {
+        CompareDistributedSpMV<CsrMatrix>(A, num_parts);
+        CompareDistributedSpMV<HybMatrix>(A, num_parts);
+        CompareDistributedSpMV<CsrMatrix>(B, num_parts);
+        CompareDistributedSpMV<HybMatrix>(B, num_parts);
+    }
+
+    // more parts than rows
+    cusp::csr_matrix<int,float,cusp::host_memory> C;
+    cusp::gallery::poisson5pt(C, 2, 2);
+    CompareDistributedSpMV<CsrMatrix>(C, 6);
+}
+DECLARE_UNITTEST(TestDistributedMatrixMultiply);
+
+void TestDistributedMatrixMultiplyLayout(void)
+{
+    cusp::csr_matrix<int,float,cusp::host_memory> A;
+    cusp::gallery::poisson5pt(A, 4, 4);
+
+    cusp::distributed_matrix< cusp::csr_matrix<int,float,cusp::device_memory> > B(A, round_robin_devices(2));
+
+    cusp::distributed_array1d<float> x(cusp::distributed_layout(A.num_rows, round_robin_devices(3)), 1.0f);
+    cusp::distributed_array1d<float> y(B.layout);
+
+    ASSERT_THROWS(cusp::multiply(B, x, y), cusp::invalid_input_exception);
+}
+DECLARE_UNITTEST(TestDistributedMatrixMultiplyLayout);
+
+void TestDistributedMatrixMultiplyRectangular(void)
+{
+    cusp::csr_matrix<int,float,cusp::host_memory> A;
+    cusp::gallery::random(300, 200, 2000, A);
+
+    for(size_t num_parts = 1; num_parts <= 4; num_parts++)
+    {
+        std::vector<int> devices = round_robin_devices(num_parts);
+
+        cusp::distributed_layout row_layout(A.num_rows, devices);
+        cusp::distributed_layout column_layout(A.num_cols, devices);
+
+        cusp::distributed_matrix< cusp::hyb_matrix<int,float,cusp::device_memory> > B(A, row_layout, column_layout);
+
+        ASSERT_EQUAL(B.num_rows, 300);
+        ASSERT_EQUAL(B.num_cols, 200);
+
+        cusp::array1d<float,cusp::host_memory> x(A.num_cols);
+        for(size_t i = 0; i < x.size(); i++)
+            x[i] = int(i % 5) - 2;
+
+        cusp::array1d<float,cusp::host_memory> y(A.num_rows);
+        cusp::multiply(A, x, y);
+
+        cusp::distributed_array1d<float> d_x(column_layout, x);
+        cusp::distributed_array1d<float> d_y(row_layout, 10.0f);
+
+        cusp::multiply(B, d_x, d_y);
+
+        cusp::array1d<float,cusp::host_memory> z;
+        d_y.gather(z);
+
+        ASSERT_ALMOST_EQUAL(z, y);
+
+        // the vectors must match the row and column layouts
+        ASSERT_THROWS(cusp::multiply(B, d_y, d_y), cusp::invalid_input_exception);
+    }
+
+    // both layouts must use the same devices
+    std::vector<int> devices = round_robin_devices(2);
+    ASSERT_THROWS((cusp::distributed_matrix< cusp::csr_matrix<int,float,cusp::device_memory> >
+                   (A, cusp::distributed_layout(300, devices), cusp::distributed_layout(200, round_robin_devices(3)))),
+                  cusp::invalid_input_exception);
+}
+DECLARE_UNITTEST(TestDistributedMatrixMultiplyRectangular);
@@ -0,0 +1,98 @@
+#include <unittest/unittest.h>
+
+#include <cusp/precond/aggregation/distributed_smoothed_aggregation.h>
+#include <cusp/distributed_matrix.h>
+#include <cusp/krylov/cg.h>
+#include <cusp/monitor.h>
+#include <cusp/gallery/poisson.h>
+
+// assigns the parts to the available devices in turn
+std::vector<int> sa_part_devices(size_t num_parts)
+{
+    int num_devices = 1;
+    cudaGetDeviceCount(&num_devices);
+
+    std::vector<int> devices(num_parts);
+    for(size_t p = 0; p < num_parts; p++)
+        devices[p] = p % num_devices;
+
+    return devices;
+}
+
+void TestDistributedSmoothedAggregationHierarchy(void)
+{
+    typedef cusp::precond::aggregation::distributed_smoothed_aggregation<int,double> Preconditioner;
+
+    cusp::csr_matrix<int,double,cusp::host_memory> A;
+    cusp::gallery::poisson5pt(A, 30, 30);
+
+    for(size_t num_parts = 1; num_parts <= 4; num_parts++)
+    {
+        cusp::distributed_layout layout(A.num_rows, sa_part_devices(num_parts));
+
+        Preconditioner M(A, layout, Preconditioner::Options(), 64);
+
+        ASSERT_EQUAL(M.num_levels() > 1, true);
+        ASSERT_EQUAL(M.layout(0) == layout, true);
+        ASSERT_EQUAL(M.operator_complexity() > 1.0, true);
+
+        for(size_t lvl = 1; lvl < M.num_levels(); lvl++)
+        {
+            ASSERT_EQUAL(M.level_size(lvl) < M.level_size(lvl - 1), true);
+            ASSERT_EQUAL(M.layout(lvl).num_parts() <= M.layout(lvl - 1).num_parts(), true);
+            ASSERT_EQUAL(M.layout(lvl).size(), M.level_size(lvl));
+        }
+
+        // the coarsest levels are merged onto fewer devices
+        if (num_parts > 1)
+            ASSERT_EQUAL(M.layout(M.num_levels() - 1).num_parts() < num_parts, true);
+    }
+
+    // square matrices only
+    cusp::csr_matrix<int,double,cusp::host_memory> B(4, 5, 0);
+    thrust::fill(B.row_offsets.begin(), B.row_offsets.end(), 0);
+    ASSERT_THROWS(Preconditioner(B, sa_part_devices(2)), cusp::invalid_input_exception);
+}
+DECLARE_UNITTEST(TestDistributedSmoothedAggregationHierarchy);
+
+void TestDistributedSmoothedAggregationSolve(void)
+{
+    typedef cusp::csr_matrix<int,double,cusp::host_memory>   HostMatrix;
+    typedef cusp::hyb_matrix<int,double,cusp::device_memory> DeviceMatrix;
+
+    HostMatrix A;
+    cusp::gallery::poisson5pt(A, 40, 40);
+
+    for(size_t num_parts = 1; num_parts <= 4; num_parts++)
+    {
+        cusp::distributed_matrix<DeviceMatrix> D(A, sa_part_devices(num_parts));
+
+        // unpreconditioned solve
+        cusp::distributed_array1d<double> x0(D.layout, 0.0);
+        cusp::distributed_array1d<double> b(D.layout, 1.0);
+
+        cusp::default_monitor<double> monitor0(b, 500, 1e-8);
+        cusp::krylov::cg(D, x0, b, monitor0);
+
+        // preconditioned solve
+        cusp::precond::aggregation::distributed_smoothed_aggregation<int,double>
+            M(A, D.layout, cusp::precond::aggregation::distributed_smoothed_aggregation<int,double>::Options(), 64);
+
+        cusp::distributed_array1d<double> x(D.layout, 0.0);
+
+        cusp::default_monitor<double> monitor(b, 500, 1e-8);
+        cusp::krylov::cg(D, x, b, monitor, M);
+
+        ASSERT_EQUAL(monitor0.converged(), true);
+        ASSERT_EQUAL(monitor.converged(), true);
+        ASSERT_EQUAL(monitor.iteration_count() < monitor0.iteration_count(), true);
+
+        cusp::array1d<double,cusp::host_memory> x0_host;
+        cusp::array1d<double,cusp::host_memory> x_host;
+        x0.gather(x0_host);
+        x.gather(x_host);
+
+        ASSERT_ALMOST_EQUAL(x_host, x0_host);
+    }
+}
+DECLARE_UNITTEST(TestDistributedSmoothedAggregationSolve);
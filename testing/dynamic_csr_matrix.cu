@@ -0,0 +1,125 @@
+#include <unittest/unittest.h>
+
+#include <cusp/dynamic_csr_matrix.h>
+
+#include <cusp/array2d.h>
+#include <cusp/csr_matrix.h>
+#include <cusp/hyb_matrix.h>
+#include <cusp/multiply.h>
+#include <cusp/gallery/poisson.h>
+
+template <class MemorySpace>
+void TestDynamicCsrMatrixInsertErase(void)
+{
+    cusp::csr_matrix<int,float,cusp::host_memory> A;
+    cusp::gallery::poisson5pt(A, 4, 4);
+
+    cusp::array2d<float,cusp::host_memory> reference(A);
+
+    cusp::dynamic_csr_matrix<int,float,MemorySpace> D(A, 1);
+
+    ASSERT_EQUAL(D.num_entries, A.num_entries);
+    ASSERT_EQUAL(D.capacity(), A.num_entries + A.num_rows);
+
+    // a new entry, an existing one, a duplicated pair and a row which overflows
+    cusp::array1d<int,cusp::host_memory> rows(7);
+    cusp::array1d<int,cusp::host_memory> cols(7);
+    cusp::array1d<float,cusp::host_memory> vals(7);
+    rows[0] = 0;  cols[0] = 5;  vals[0] = 1.0f;
+    rows[1] = 3;  cols[1] = 3;  vals[1] = 9.0f;
+    rows[2] = 7;  cols[2] = 12; vals[2] = 2.0f;
+    rows[3] = 7;  cols[3] = 12; vals[3] = 3.0f;
+    rows[4] = 9;  cols[4] = 0;  vals[4] = 4.0f;
+    rows[5] = 9;  cols[5] = 15; vals[5] = 5.0f;
+    rows[6] = 9;  cols[6] = 2;  vals[6] = 6.0f;
+
+    reference(0,5)  = 1.0f;
+    reference(3,3)  = 9.0f;
+    reference(7,12) = 5.0f;
+    reference(9,0)  = 4.0f;
+    reference(9,15) = 5.0f;
+    reference(9,2)  = 6.0f;
+
+    ASSERT_EQUAL(D.insert(rows, cols, vals), size_t(5));
+    ASSERT_EQUAL(D.num_entries, A.num_entries + 5);
+
+    cusp::csr_matrix<int,float,MemorySpace> C;
+    D.compact(C);
+
+    ASSERT_EQUAL((cusp::array2d<float,cusp::host_memory>(C) == reference), true);
+
+    // positions without an entry are ignored
+    cusp::array1d<int,cusp::host_memory> erase_rows(3);
+    cusp::array1d<int,cusp::host_memory> erase_cols(3);
+    erase_rows[0] = 9; erase_cols[0] = 15;
+    erase_rows[1] = 0; erase_cols[1] = 1;
+    erase_rows[2] = 0; erase_cols[2] = 14;
+
+    reference(9,15) = 0.0f;
+    reference(0,1)  = 0.0f;
+
+    ASSERT_EQUAL(D.erase(erase_rows, erase_cols), size_t(2));
+
+    cusp::hyb_matrix<int,float,MemorySpace> H;
+    D.compact(H);
+
+    ASSERT_EQUAL((cusp::array2d<float,cusp::host_memory>(H) == reference), true);
+
+    // insertions after a reserve do not overflow
+    D.reserve(2);
+    ASSERT_EQUAL(D.capacity(), D.num_entries + 2 * A.num_rows);
+
+    rows[1] = 0; cols[1] = 1;
+    reference(0,1) = 9.0f;
+    ASSERT_EQUAL(D.insert(rows, cols, vals), size_t(2));
+    ASSERT_EQUAL(D.capacity(), D.num_entries + 2 * A.num_rows - 2);
+
+    reference(9,15) = 5.0f;
+
+    D.compact(C);
+    ASSERT_EQUAL((cusp::array2d<float,cusp::host_memory>(C) == reference), true);
+
+    ASSERT_THROWS(D.insert(cusp::array1d<int,cusp::host_memory>(1, 16),
+                           cusp::array1d<int,cusp::host_memory>(1, 0),
+                           cusp::array1d<float,cusp::host_memory>(1, 1.0f)),
+                  cusp::invalid_input_exception);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestDynamicCsrMatrixInsertErase);
+
+template <class MemorySpace>
+void TestDynamicCsrMatrixMultiply(void)
+{
+    cusp::csr_matrix<int,float,cusp::host_memory> A;
+    cusp::gallery::poisson5pt(A, 10, 7);
+
+    cusp::dynamic_csr_matrix<int,float,MemorySpace> D(A);
+
+    cusp::array1d<int,cusp::host_memory> rows(A.num_rows);
+    cusp::array1d<int,cusp::host_memory> cols(A.num_rows);
+    cusp::array1d<float,cusp::host_memory> vals(A.num_rows);
+
+    for(size_t i = 0; i < A.num_rows; i++)
+    {
+        rows[i] = i;
+        cols[i] = (7 * i + 3) % A.num_cols;
+        vals[i] = float(i % 5) - 2.0f;
+    }
+
+    D.insert(rows, cols, vals);
+
+    cusp::csr_matrix<int,float,MemorySpace> C;
+    D.compact(C);
+
+    cusp::array1d<float,MemorySpace> x(A.num_cols);
+    for(size_t i = 0; i < x.size(); i++)
+        x[i] = float(i % 3) + 0.5f;
+
+    cusp::array1d<float,MemorySpace> y(A.num_rows);
+    cusp::array1d<float,MemorySpace> z(A.num_rows);
+
+    cusp::multiply(D, x, y);
+    cusp::multiply(C, x, z);
+
+    ASSERT_ALMOST_EQUAL(y, z);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestDynamicCsrMatrixMultiply);
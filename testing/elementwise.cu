@@ -165,3 +165,177 @@ void TestSubtract(void)
 }
 DECLARE_SPARSE_MATRIX_UNITTEST(TestSubtract);
 
+
+
+template <typename SparseMatrix>
+void TestAddScaled(void)
+{
+    typedef cusp::array2d<float,cusp::host_memory> DenseMatrix;
+
+    std::vector< DenseMatrix > matrices;
+
+    example_matrices(matrices);
+    
+    // test alpha * A + beta * B for every pair of compatible matrices
+    for(size_t i = 0; i < matrices.size(); i++)
+    {
+        for(size_t j = 0; j < matrices.size(); j++)
+        {
+            const DenseMatrix& A = matrices[i];
+            const DenseMatrix& B = matrices[j];
+
+            if (A.num_rows == B.num_rows && A.num_cols == B.num_cols)
+            {
+                DenseMatrix C;
+                cusp::add(2.0f, A, -0.5f, B, C);
+
+                SparseMatrix _A(A), _B(B), _C;
+                cusp::add(2.0f, _A, -0.5f, _B, _C);
+
+                ASSERT_ALMOST_EQUAL(C.values, DenseMatrix(_C).values);
+            }
+        }
+    }
+
+    SparseMatrix A = DenseMatrix(2,2,1);
+    SparseMatrix B = DenseMatrix(2,3,1); 
+    SparseMatrix D;
+
+    ASSERT_THROWS(cusp::add(1.0f, A, 1.0f, B, D), cusp::invalid_input_exception);
+}
+DECLARE_SPARSE_MATRIX_UNITTEST(TestAddScaled);
+
+
+template <class MemorySpace>
+void TestAddReusePattern(void)
+{
+    typedef cusp::csr_matrix<int,float,MemorySpace> SparseMatrix;
+    typedef cusp::array2d<float,cusp::host_memory>  DenseMatrix;
+
+    DenseMatrix A(3,4,0);
+    A(0,0) = 1.0; A(0,2) = 2.0;
+    A(1,1) = 3.0;
+    A(2,0) = 4.0; A(2,3) = 5.0;
+
+    DenseMatrix B(3,4,0);
+    B(0,2) = 1.0; B(0,3) = 6.0;
+    B(2,0) = 4.0; B(2,1) = 7.0;
+
+    SparseMatrix _A(A), _B(B), _C;
+
+    // entries that cancel stay in the pattern
+    cusp::add(1.0f, _A, -1.0f, _B, _C);
+
+    ASSERT_EQUAL(_C.num_entries, 7);
+
+    cusp::array1d<int,cusp::host_memory> C_row_offsets(_C.row_offsets);
+    cusp::array1d<int,cusp::host_memory> C_column_indices(_C.column_indices);
+
+    ASSERT_EQUAL(C_row_offsets[0], 0);
+    ASSERT_EQUAL(C_row_offsets[1], 3);
+    ASSERT_EQUAL(C_row_offsets[2], 4);
+    ASSERT_EQUAL(C_row_offsets[3], 7);
+    ASSERT_EQUAL(C_column_indices[0], 0);
+    ASSERT_EQUAL(C_column_indices[1], 2);
+    ASSERT_EQUAL(C_column_indices[2], 3);
+    ASSERT_EQUAL(C_column_indices[3], 1);
+    ASSERT_EQUAL(C_column_indices[4], 0);
+    ASSERT_EQUAL(C_column_indices[5], 1);
+    ASSERT_EQUAL(C_column_indices[6], 3);
+
+    // new values with the same patterns
+    _A.values[0] = 10.0;
+    _B.values[3] = -2.0;
+
+    cusp::add(3.0f, _A, 2.0f, _B, _C, true);
+
+    ASSERT_EQUAL(_C.num_entries, 7);
+
+    DenseMatrix C(_C);
+
+    ASSERT_EQUAL(C(0,0), 30.0f);
+    ASSERT_EQUAL(C(0,2),  8.0f);
+    ASSERT_EQUAL(C(0,3), 12.0f);
+    ASSERT_EQUAL(C(1,1),  9.0f);
+    ASSERT_EQUAL(C(2,0), 20.0f);
+    ASSERT_EQUAL(C(2,1), -4.0f);
+    ASSERT_EQUAL(C(2,3), 15.0f);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestAddReusePattern);
+
+
+template <typename SparseMatrix>
+void TestElementwiseMultiply(void)
+{
+    typedef cusp::array2d<float,cusp::host_memory> DenseMatrix;
+
+    std::vector< DenseMatrix > matrices;
+
+    example_matrices(matrices);
+
+    // test the product of every pair of compatible matrices
+    for(size_t i = 0; i < matrices.size(); i++)
+    {
+        for(size_t j = 0; j < matrices.size(); j++)
+        {
+            const DenseMatrix& A = matrices[i];
+            const DenseMatrix& B = matrices[j];
+
+            if (A.num_rows == B.num_rows && A.num_cols == B.num_cols)
+            {
+                DenseMatrix C(A.num_rows, A.num_cols);
+                for(size_t r = 0; r < A.num_rows; r++)
+                    for(size_t c = 0; c < A.num_cols; c++)
+                        C(r,c) = A(r,c) * B(r,c);
+
+                SparseMatrix _A(A), _B(B), _C;
+                cusp::elementwise_multiply(_A, _B, _C);
+
+                ASSERT_EQUAL(C == DenseMatrix(_C), true);
+            }
+        }
+    }
+
+    SparseMatrix A = DenseMatrix(2,2,1);
+    SparseMatrix B = DenseMatrix(2,3,1);
+    SparseMatrix D;
+
+    ASSERT_THROWS(cusp::elementwise_multiply(A,B,D), cusp::invalid_input_exception);
+}
+DECLARE_SPARSE_MATRIX_UNITTEST(TestElementwiseMultiply);
+
+
+template <typename T>
+struct square_value
+{
+    __host__ __device__
+    T operator()(const T& x) const
+    {
+        return x * x;
+    }
+};
+
+template <typename SparseMatrix>
+void TestTransformValues(void)
+{
+    typedef cusp::array2d<float,cusp::host_memory> DenseMatrix;
+
+    std::vector< DenseMatrix > matrices;
+
+    example_matrices(matrices);
+
+    for(size_t i = 0; i < matrices.size(); i++)
+    {
+        DenseMatrix A = matrices[i];
+
+        SparseMatrix _A(A);
+        cusp::transform_values(_A, square_value<float>());
+
+        for(size_t r = 0; r < A.num_rows; r++)
+            for(size_t c = 0; c < A.num_cols; c++)
+                A(r,c) = A(r,c) * A(r,c);
+
+        ASSERT_EQUAL(A == DenseMatrix(_A), true);
+    }
+}
+DECLARE_SPARSE_MATRIX_UNITTEST(TestTransformValues);
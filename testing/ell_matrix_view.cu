@@ -213,3 +213,60 @@ void TestMakeEllMatrixView(void)
 }
 DECLARE_HOST_DEVICE_UNITTEST(TestMakeEllMatrixView);
 
+
+template <typename MemorySpace>
+void TestMakeEllMatrixViewFromPointers(void)
+{
+  typedef int                                                           IndexType;
+  typedef float                                                         ValueType;
+  typedef typename cusp::ell_matrix<IndexType,ValueType,MemorySpace>    Matrix;
+
+  const IndexType X = Matrix::invalid_index;
+
+  // [10  0 20]
+  // [ 0  0  0]
+  // [ 0  0 30]
+  // [40 50 60]
+  Matrix M(4, 3, 6, 3);
+  M.column_indices(0,0) = 0;  M.values(0,0) = 10;
+  M.column_indices(0,1) = 2;  M.values(0,1) = 20;
+  M.column_indices(0,2) = X;  M.values(0,2) =  0;
+  M.column_indices(1,0) = X;  M.values(1,0) =  0;
+  M.column_indices(1,1) = X;  M.values(1,1) =  0;
+  M.column_indices(1,2) = X;  M.values(1,2) =  0;
+  M.column_indices(2,0) = 2;  M.values(2,0) = 30;
+  M.column_indices(2,1) = X;  M.values(2,1) =  0;
+  M.column_indices(2,2) = X;  M.values(2,2) =  0;
+  M.column_indices(3,0) = 0;  M.values(3,0) = 40;
+  M.column_indices(3,1) = 1;  M.values(3,1) = 50;
+  M.column_indices(3,2) = 2;  M.values(3,2) = 60;
+
+  IndexType * column_indices = thrust::raw_pointer_cast(&M.column_indices.values[0]);
+  ValueType * values         = thrust::raw_pointer_cast(&M.values.values[0]);
+
+  // the view has the same type as the view of an ell_matrix
+  typename Matrix::view V =
+    cusp::make_ell_matrix_view(4, 3, 6, 3, M.values.pitch, column_indices, values, MemorySpace());
+
+  ASSERT_EQUAL(V.num_rows,    4);
+  ASSERT_EQUAL(V.num_cols,    3);
+  ASSERT_EQUAL(V.num_entries, 6);
+  ASSERT_EQUAL(V.values.num_cols, 3);
+  ASSERT_EQUAL(V.values.pitch,    M.values.pitch);
+
+  ASSERT_EQUAL_QUIET(V.column_indices.values.begin(), M.column_indices.values.begin());
+  ASSERT_EQUAL_QUIET(V.values.values.begin(),         M.values.values.begin());
+
+  cusp::array1d<ValueType, MemorySpace> x(3);
+  x[0] = 1;  x[1] = 2;  x[2] = 3;
+
+  cusp::array1d<ValueType, MemorySpace> y(4);
+
+  cusp::multiply(V, x, y);
+
+  ASSERT_EQUAL(y[0],  70);
+  ASSERT_EQUAL(y[1],   0);
+  ASSERT_EQUAL(y[2],  90);
+  ASSERT_EQUAL(y[3], 320);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestMakeEllMatrixViewFromPointers);
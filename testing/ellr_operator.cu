@@ -0,0 +1,116 @@
+#include <unittest/unittest.h>
+
+#include <cusp/ellr_operator.h>
+#include <cusp/array1d.h>
+#include <cusp/coo_matrix.h>
+#include <cusp/csr_matrix.h>
+#include <cusp/ell_matrix.h>
+#include <cusp/multiply.h>
+#include <cusp/reduction.h>
+#include <cusp/gallery/poisson.h>
+#include <cusp/gallery/random.h>
+#include <cusp/krylov/cg.h>
+
+template <typename MemorySpace, typename MatrixType>
+void CheckEllrMultiply(const MatrixType& B)
+{
+    typedef typename MatrixType::value_type ValueType;
+
+    cusp::ellr_operator<int, ValueType, MemorySpace> A(B);
+
+    ASSERT_EQUAL(A.num_rows,    B.num_rows);
+    ASSERT_EQUAL(A.num_cols,    B.num_cols);
+    ASSERT_EQUAL(A.num_entries, B.num_entries);
+    ASSERT_EQUAL(A.pitch % 32,  size_t(0));
+    ASSERT_EQUAL(A.values.size() % (4 * A.pitch), size_t(0));
+
+    cusp::array1d<ValueType, cusp::host_memory> x_h(B.num_cols);
+    for (size_t i = 0; i < x_h.size(); i++)
+        x_h[i] = ValueType(i % 7) - 3;
+
+    cusp::array1d<ValueType, cusp::host_memory> z_h(B.num_rows);
+    cusp::multiply(B, x_h, z_h);
+
+    cusp::array1d<ValueType, MemorySpace> x(x_h);
+    cusp::array1d<ValueType, MemorySpace> y(B.num_rows, ValueType(-1));
+
+    cusp::multiply(A, x, y);
+
+    ASSERT_ALMOST_EQUAL((cusp::array1d<ValueType, cusp::host_memory>(y)), z_h);
+
+    // a copy in the other memory space
+    cusp::ellr_operator<int, ValueType, cusp::host_memory> C(A);
+    cusp::array1d<ValueType, cusp::host_memory> w_h(B.num_rows, ValueType(-1));
+    cusp::multiply(C, x_h, w_h);
+
+    ASSERT_ALMOST_EQUAL(w_h, z_h);
+}
+
+template <class MemorySpace>
+void TestEllrOperator(void)
+{
+    cusp::csr_matrix<int, float, cusp::host_memory> P;
+    cusp::gallery::poisson5pt(P, 20, 15);
+    CheckEllrMultiply<MemorySpace>(P);
+
+    cusp::ellr_operator<int, float, MemorySpace> A(P);
+
+    // two chunks of four for the five point rows
+    ASSERT_EQUAL(A.values.size(), 2 * 4 * A.pitch);
+    ASSERT_EQUAL(A.row_lengths[0], 3);
+    ASSERT_EQUAL(A.row_lengths[21], 5);
+
+    // any format in either memory space
+    CheckEllrMultiply<MemorySpace>(cusp::ell_matrix<int, float, MemorySpace>(P));
+
+    cusp::csr_matrix<int, double, cusp::host_memory> Q;
+    cusp::gallery::poisson27pt(Q, 6, 5, 4);
+    CheckEllrMultiply<MemorySpace>(Q);
+
+    // rows of very different lengths, some empty
+    cusp::coo_matrix<int, double, cusp::host_memory> R;
+    cusp::gallery::random(300, 200, 2000, R);
+    CheckEllrMultiply<MemorySpace>(R);
+
+    // empty
+    cusp::csr_matrix<int, float, cusp::host_memory> E(4, 5, 0);
+    CheckEllrMultiply<MemorySpace>(E);
+
+    cusp::array1d<float, MemorySpace> x(P.num_cols + 1);
+    cusp::array1d<float, MemorySpace> y(P.num_rows);
+    ASSERT_THROWS(cusp::multiply(A, x, y), cusp::invalid_input_exception);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestEllrOperator);
+
+template <class MemorySpace>
+void TestEllrOperatorCompensated(void)
+{
+    cusp::csr_matrix<int, double, cusp::host_memory> Q;
+    cusp::gallery::poisson27pt(Q, 6, 5, 4);
+
+    cusp::reduction_scope scope(cusp::compensated_reduction);
+    CheckEllrMultiply<MemorySpace>(Q);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestEllrOperatorCompensated);
+
+template <class MemorySpace>
+void TestEllrOperatorConjugateGradient(void)
+{
+    cusp::csr_matrix<int, float, MemorySpace> B;
+    cusp::gallery::poisson5pt(B, 10, 10);
+
+    cusp::ellr_operator<int, float, MemorySpace> A(B);
+
+    cusp::array1d<float, MemorySpace> x(A.num_rows, 0.0f);
+    cusp::array1d<float, MemorySpace> b(A.num_rows, 1.0f);
+
+    cusp::default_monitor<float> monitor(b, 20, 1e-4);
+    cusp::krylov::cg(A, x, b, monitor);
+
+    cusp::array1d<float, MemorySpace> residual(A.num_rows, 0.0f);
+    cusp::multiply(B, x, residual);
+    cusp::blas::axpby(residual, b, residual, -1.0f, 1.0f);
+
+    ASSERT_EQUAL(cusp::blas::nrm2(residual) < 1e-4 * cusp::blas::nrm2(b), true);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestEllrOperatorConjugateGradient);
@@ -0,0 +1,139 @@
+#include <unittest/unittest.h>
+
+#include <cusp/ensemble_csr_operator.h>
+#include <cusp/array1d.h>
+#include <cusp/array2d.h>
+#include <cusp/csr_matrix.h>
+#include <cusp/multiply.h>
+#include <cusp/gallery/poisson.h>
+#include <cusp/gallery/random.h>
+
+// values of member e of the pattern P: entry k gets P.values[k] * (e + 1) + k % 3
+void EnsembleValues(const cusp::csr_matrix<int, float, cusp::host_memory>& P,
+                    const size_t num_members,
+                    cusp::array1d<float, cusp::host_memory>& values)
+{
+    values.resize(num_members * P.num_entries);
+
+    for (size_t e = 0; e < num_members; e++)
+        for (size_t k = 0; k < P.num_entries; k++)
+            values[e * P.num_entries + k] = P.values[k] * float(e + 1) + float(k % 3);
+}
+
+template <class MemorySpace>
+void CheckEnsembleMultiply(const cusp::csr_matrix<int, float, cusp::host_memory>& P, const size_t num_members)
+{
+    cusp::array1d<float, cusp::host_memory> values;
+    EnsembleValues(P, num_members, values);
+
+    cusp::ensemble_csr_operator<int, float, MemorySpace> A(P, values, num_members);
+
+    ASSERT_EQUAL(A.num_rows,    P.num_rows);
+    ASSERT_EQUAL(A.num_cols,    P.num_cols);
+    ASSERT_EQUAL(A.num_entries, P.num_entries);
+    ASSERT_EQUAL(A.num_members, num_members);
+    ASSERT_EQUAL(A.values.size(), num_members * P.num_entries);
+
+    cusp::array2d<float, cusp::host_memory, cusp::row_major> X_h(P.num_cols, num_members);
+    for (size_t i = 0; i < P.num_cols; i++)
+        for (size_t e = 0; e < num_members; e++)
+            X_h(i, e) = float((i + 2 * e) % 7) - 3.0f;
+
+    cusp::array2d<float, MemorySpace, cusp::row_major> X(X_h);
+    cusp::array2d<float, MemorySpace, cusp::row_major> Y(P.num_rows, num_members, -1.0f);
+
+    cusp::multiply(A, X, Y);
+
+    cusp::array2d<float, cusp::host_memory, cusp::row_major> Y_h(Y);
+
+    // every member against the multiply of its own CSR matrix
+    for (size_t e = 0; e < num_members; e++)
+    {
+        cusp::csr_matrix<int, float, cusp::host_memory> M(P);
+        thrust::copy(values.begin() + e * P.num_entries, values.begin() + (e + 1) * P.num_entries, M.values.begin());
+
+        cusp::array1d<float, cusp::host_memory> x(P.num_cols);
+        cusp::array1d<float, cusp::host_memory> y(P.num_rows);
+        for (size_t i = 0; i < P.num_cols; i++)
+            x[i] = X_h(i, e);
+
+        cusp::multiply(M, x, y);
+
+        cusp::array1d<float, cusp::host_memory> z(P.num_rows);
+        for (size_t i = 0; i < P.num_rows; i++)
+            z[i] = Y_h(i, e);
+
+        ASSERT_ALMOST_EQUAL(z, y);
+
+        // the values of the member round trip
+        cusp::array1d<float, cusp::host_memory> member;
+        A.get_member(e, member);
+        ASSERT_EQUAL(member, M.values);
+    }
+}
+
+template <class MemorySpace>
+void TestEnsembleCsrOperator(void)
+{
+    cusp::csr_matrix<int, float, cusp::host_memory> P;
+    cusp::gallery::poisson5pt(P, 13, 11);
+
+    CheckEnsembleMultiply<MemorySpace>(P, 1);
+    CheckEnsembleMultiply<MemorySpace>(P, 8);
+    CheckEnsembleMultiply<MemorySpace>(P, 13);
+
+    // rectangular, with empty rows
+    cusp::csr_matrix<int, float, cusp::host_memory> R;
+    cusp::gallery::random(70, 50, 120, R);
+    CheckEnsembleMultiply<MemorySpace>(R, 5);
+
+    cusp::csr_matrix<int, float, cusp::host_memory> E(5, 5, 0);
+    CheckEnsembleMultiply<MemorySpace>(E, 4);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestEnsembleCsrOperator);
+
+template <class MemorySpace>
+void TestEnsembleCsrOperatorMembers(void)
+{
+    cusp::csr_matrix<int, float, cusp::host_memory> P;
+    cusp::gallery::poisson5pt(P, 4, 5);
+
+    // every member starts with the values of the pattern
+    cusp::ensemble_csr_operator<int, float, MemorySpace> A(P, 3);
+
+    cusp::array1d<float, cusp::host_memory> member;
+    for (size_t e = 0; e < 3; e++)
+    {
+        A.get_member(e, member);
+        ASSERT_EQUAL(member, P.values);
+    }
+
+    cusp::array1d<float, cusp::host_memory> scaled(P.values);
+    for (size_t k = 0; k < scaled.size(); k++)
+        scaled[k] *= 2.0f;
+
+    A.set_member(1, scaled);
+
+    A.get_member(1, member);
+    ASSERT_EQUAL(member, scaled);
+    A.get_member(2, member);
+    ASSERT_EQUAL(member, P.values);
+
+    // a copy to the other memory space has the same members
+    cusp::ensemble_csr_operator<int, float, cusp::host_memory> B(A);
+    B.get_member(1, member);
+    ASSERT_EQUAL(member, scaled);
+
+    ASSERT_THROWS(A.set_member(3, scaled), cusp::invalid_input_exception);
+    ASSERT_THROWS(A.set_member(0, cusp::array1d<float, cusp::host_memory>(3)), cusp::invalid_input_exception);
+    ASSERT_THROWS((cusp::ensemble_csr_operator<int, float, MemorySpace>(P, scaled, 2)), cusp::invalid_input_exception);
+
+    // vectors of the wrong size or orientation
+    cusp::array2d<float, MemorySpace, cusp::row_major> X(P.num_cols, 2);
+    cusp::array2d<float, MemorySpace, cusp::row_major> Y(P.num_rows, 3);
+    ASSERT_THROWS(cusp::multiply(A, X, Y), cusp::invalid_input_exception);
+
+    cusp::array2d<float, MemorySpace, cusp::column_major> Xc(P.num_cols, 3);
+    ASSERT_THROWS(cusp::multiply(A, Xc, Y), cusp::invalid_input_exception);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestEnsembleCsrOperatorMembers);
@@ -0,0 +1,119 @@
+#include <unittest/unittest.h>
+
+#include <cusp/ensemble_csr_operator.h>
+#include <cusp/gallery/poisson.h>
+#include <cusp/csr_matrix.h>
+#include <cusp/multiply.h>
+#include <cusp/krylov/ensemble.h>
+
+#include <cmath>
+
+// an ensemble of scaled Poisson problems, made nonsymmetric by adding
+// skew to the entries above the diagonal; member 3 has a zero right-hand side
+template <class MemorySpace>
+void EnsemblePoissonSystems(cusp::ensemble_csr_operator<int, float, MemorySpace>& A,
+                            cusp::array2d<float, MemorySpace, cusp::row_major>& B,
+                            const size_t num_members,
+                            const bool symmetric)
+{
+    cusp::csr_matrix<int, float, cusp::host_memory> P;
+    cusp::gallery::poisson5pt(P, 9, 8);
+
+    cusp::array1d<float, cusp::host_memory> values(num_members * P.num_entries);
+    for (size_t e = 0; e < num_members; e++)
+    {
+        for (size_t i = 0; i < P.num_rows; i++)
+        {
+            for (int k = P.row_offsets[i]; k < P.row_offsets[i + 1]; k++)
+            {
+                float v = (e + 1) * P.values[k];
+                if (!symmetric && size_t(P.column_indices[k]) > i)
+                    v += 0.1f * (e + 1);
+                values[e * P.num_entries + k] = v;
+            }
+        }
+    }
+
+    A = cusp::ensemble_csr_operator<int, float, MemorySpace>(P, values, num_members);
+
+    cusp::array1d<float, cusp::host_memory> samples = unittest::random_samples<float>(P.num_rows * num_members);
+
+    cusp::array2d<float, cusp::host_memory, cusp::row_major> B_host(P.num_rows, num_members);
+    for (size_t i = 0; i < P.num_rows; i++)
+        for (size_t e = 0; e < num_members; e++)
+            B_host(i, e) = e == 3 ? 0.0f : samples[i * num_members + e];
+
+    B = B_host;
+}
+
+template <class MemorySpace>
+void CheckEnsembleSolution(const cusp::ensemble_csr_operator<int, float, MemorySpace>& A,
+                           const cusp::array2d<float, MemorySpace, cusp::row_major>& X,
+                           const cusp::array2d<float, MemorySpace, cusp::row_major>& B,
+                           const cusp::krylov::batched_monitor<float>& monitor)
+{
+    cusp::array2d<float, MemorySpace, cusp::row_major> AX(A.num_rows, A.num_members);
+    cusp::multiply(A, X, AX);
+
+    cusp::array2d<float, cusp::host_memory, cusp::row_major> AX_host(AX);
+    cusp::array2d<float, cusp::host_memory, cusp::row_major> B_host(B);
+
+    ASSERT_EQUAL(monitor.num_systems(), A.num_members);
+    ASSERT_EQUAL(monitor.converged(), true);
+
+    for (size_t e = 0; e < A.num_members; e++)
+    {
+        float r_norm = 0, b_norm = 0;
+        for (size_t i = 0; i < A.num_rows; i++)
+        {
+            const float r = B_host(i, e) - AX_host(i, e);
+            r_norm += r * r;
+            b_norm += B_host(i, e) * B_host(i, e);
+        }
+
+        ASSERT_EQUAL(std::sqrt(r_norm) <= 1e-4 * std::sqrt(b_norm) + 1e-6, true);
+    }
+
+    // the member with a zero right-hand side is solved by x = 0
+    ASSERT_EQUAL(monitor.iteration_count(3), 0);
+}
+
+template <class MemorySpace>
+void TestEnsembleConjugateGradient(void)
+{
+    cusp::ensemble_csr_operator<int, float, MemorySpace> A;
+    cusp::array2d<float, MemorySpace, cusp::row_major> B;
+    EnsemblePoissonSystems(A, B, 12, true);
+
+    for (int jacobi = 0; jacobi < 2; jacobi++)
+    {
+        cusp::array2d<float, MemorySpace, cusp::row_major> X(A.num_rows, A.num_members, 0.0f);
+        cusp::krylov::batched_monitor<float> monitor(200, 1e-5);
+
+        cusp::krylov::ensemble_cg(A, X, B, monitor,
+                                  jacobi ? cusp::krylov::BATCHED_JACOBI : cusp::krylov::BATCHED_IDENTITY);
+
+        CheckEnsembleSolution(A, X, B, monitor);
+    }
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestEnsembleConjugateGradient);
+
+template <class MemorySpace>
+void TestEnsembleBiConjugateGradientStabilized(void)
+{
+    cusp::ensemble_csr_operator<int, float, MemorySpace> A;
+    cusp::array2d<float, MemorySpace, cusp::row_major> B;
+    EnsemblePoissonSystems(A, B, 12, false);
+
+    for (int jacobi = 0; jacobi < 2; jacobi++)
+    {
+        cusp::array2d<float, MemorySpace, cusp::row_major> X(A.num_rows, A.num_members, 0.0f);
+        cusp::krylov::batched_monitor<float> monitor(200, 1e-5);
+
+        cusp::krylov::ensemble_bicgstab(A, X, B, monitor,
+                                        jacobi ? cusp::krylov::BATCHED_JACOBI : cusp::krylov::BATCHED_IDENTITY);
+
+        CheckEnsembleSolution(A, X, B, monitor);
+    }
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestEnsembleBiConjugateGradientStabilized);
@@ -0,0 +1,186 @@
+#include <unittest/unittest.h>
+
+#include <cusp/equilibrate.h>
+#include <cusp/equilibrated_matrix.h>
+
+#include <cusp/array2d.h>
+#include <cusp/coo_matrix.h>
+#include <cusp/csr_matrix.h>
+#include <cusp/dia_matrix.h>
+#include <cusp/ell_matrix.h>
+#include <cusp/hyb_matrix.h>
+#include <cusp/multiply.h>
+#include <cusp/gallery/poisson.h>
+#include <cusp/krylov/gmres.h>
+#include <cusp/monitor.h>
+
+#include <algorithm>
+#include <cmath>
+
+// Poisson matrix whose rows and columns are scaled by up to 10^4
+void badly_scaled_matrix(cusp::array2d<float,cusp::host_memory>& D, const int n)
+{
+    cusp::csr_matrix<int,float,cusp::host_memory> A;
+    cusp::gallery::poisson5pt(A, n, n);
+
+    D = A;
+
+    for(size_t i = 0; i < D.num_rows; i++)
+        for(size_t j = 0; j < D.num_cols; j++)
+            D(i,j) *= std::pow(10.0f, float(i % 5) - 1.0f) * std::pow(10.0f, float(j % 3) - 1.0f);
+}
+
+template <typename MatrixType>
+void CheckScaleRowsAndColumns(void)
+{
+    typedef typename MatrixType::memory_space Space;
+
+    cusp::array2d<float,cusp::host_memory> D;
+    badly_scaled_matrix(D, 4);
+
+    cusp::array1d<float,cusp::host_memory> r(D.num_rows);
+    cusp::array1d<float,cusp::host_memory> c(D.num_cols);
+    for(size_t i = 0; i < r.size(); i++)
+        r[i] = float(i % 4) + 0.5f;
+    for(size_t j = 0; j < c.size(); j++)
+        c[j] = 2.0f - float(j % 3) * 0.25f;
+
+    cusp::array1d<float,Space> d_r(r);
+    cusp::array1d<float,Space> d_c(c);
+
+    {
+        MatrixType A(D);
+        cusp::scale_rows_and_columns(A, d_r, d_c);
+
+        cusp::array2d<float,cusp::host_memory> B(A);
+        for(size_t i = 0; i < D.num_rows; i++)
+            for(size_t j = 0; j < D.num_cols; j++)
+                ASSERT_ALMOST_EQUAL(B(i,j), r[i] * D(i,j) * c[j]);
+    }
+
+    {
+        MatrixType A(D);
+        cusp::scale_rows(A, r);
+        cusp::scale_columns(A, d_c);
+
+        cusp::array2d<float,cusp::host_memory> B(A);
+        for(size_t i = 0; i < D.num_rows; i++)
+            for(size_t j = 0; j < D.num_cols; j++)
+                ASSERT_ALMOST_EQUAL(B(i,j), r[i] * D(i,j) * c[j]);
+    }
+
+    MatrixType A(D);
+    cusp::array1d<float,Space> short_r(D.num_rows - 1);
+    ASSERT_THROWS(cusp::scale_rows(A, short_r), cusp::invalid_input_exception);
+}
+
+template <class Space>
+void TestScaleRowsAndColumns(void)
+{
+    CheckScaleRowsAndColumns< cusp::coo_matrix<int,float,Space> >();
+    CheckScaleRowsAndColumns< cusp::csr_matrix<int,float,Space> >();
+    CheckScaleRowsAndColumns< cusp::dia_matrix<int,float,Space> >();
+    CheckScaleRowsAndColumns< cusp::ell_matrix<int,float,Space> >();
+    CheckScaleRowsAndColumns< cusp::hyb_matrix<int,float,Space> >();
+    CheckScaleRowsAndColumns< cusp::array2d<float,Space,cusp::row_major> >();
+    CheckScaleRowsAndColumns< cusp::array2d<float,Space,cusp::column_major> >();
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestScaleRowsAndColumns);
+
+template <class Space>
+void TestRuizEquilibrate(void)
+{
+    cusp::array2d<float,cusp::host_memory> D;
+    badly_scaled_matrix(D, 6);
+
+    cusp::csr_matrix<int,float,Space> A(D);
+    cusp::array1d<float,Space> r;
+    cusp::array1d<float,Space> c;
+
+    const size_t iterations = cusp::ruiz_equilibrate(A, r, c, 20, 1e-3);
+
+    ASSERT_EQUAL(iterations > 0, true);
+    ASSERT_EQUAL(iterations < 20, true);
+    ASSERT_EQUAL(r.size(), D.num_rows);
+    ASSERT_EQUAL(c.size(), D.num_cols);
+
+    // A = R D C with unit row and column norms
+    cusp::array2d<float,cusp::host_memory> B(A);
+    cusp::array1d<float,cusp::host_memory> h_r(r);
+    cusp::array1d<float,cusp::host_memory> h_c(c);
+
+    for(size_t i = 0; i < D.num_rows; i++)
+    {
+        float row_norm = 0;
+
+        for(size_t j = 0; j < D.num_cols; j++)
+        {
+            ASSERT_EQUAL(std::fabs(B(i,j) - h_r[i] * D(i,j) * h_c[j]) <= 1e-4f * std::fabs(B(i,j)), true);
+            row_norm = std::max(row_norm, std::fabs(B(i,j)));
+        }
+
+        ASSERT_EQUAL(std::fabs(row_norm - 1.0f) <= 2e-3f, true);
+    }
+
+    for(size_t j = 0; j < D.num_cols; j++)
+    {
+        float column_norm = 0;
+
+        for(size_t i = 0; i < D.num_rows; i++)
+            column_norm = std::max(column_norm, std::fabs(B(i,j)));
+
+        ASSERT_EQUAL(std::fabs(column_norm - 1.0f) <= 2e-3f, true);
+    }
+
+    // an equilibrated matrix stops at once
+    ASSERT_EQUAL(cusp::ruiz_equilibrate(A, r, c, 20, 2e-3), size_t(0));
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestRuizEquilibrate);
+
+struct equilibrate_gmres_solver
+{
+    template <typename Matrix, typename Vector1, typename Vector2>
+    void operator()(const Matrix& B, Vector1& y, const Vector2& c) const
+    {
+        cusp::default_monitor<float> monitor(c, 400, 1e-5);
+        cusp::krylov::gmres(B, y, c, 40, monitor);
+    }
+};
+
+template <class Space>
+void TestEquilibratedMatrix(void)
+{
+    cusp::array2d<float,cusp::host_memory> D;
+    badly_scaled_matrix(D, 8);
+
+    cusp::csr_matrix<int,double,Space> A(D);
+    cusp::equilibrated_matrix< cusp::csr_matrix<int,float,Space> > E(A);
+
+    ASSERT_EQUAL(E.num_rows, A.num_rows);
+    ASSERT_EQUAL(E.iterations > 0, true);
+
+    // the operator works in the original scaling
+    cusp::array1d<float,Space> x = unittest::random_samples<float>(A.num_rows);
+    cusp::array1d<float,Space> y(A.num_rows);
+    cusp::array1d<double,Space> z(A.num_rows);
+
+    E(x, y);
+    cusp::multiply(A, cusp::array1d<double,Space>(x), z);
+
+    cusp::array1d<float,cusp::host_memory> h_y(y);
+    cusp::array1d<float,cusp::host_memory> h_z(z);
+    for(size_t i = 0; i < h_y.size(); i++)
+        ASSERT_EQUAL(std::fabs(h_y[i] - h_z[i]) <= 1e-3f * (std::fabs(h_z[i]) + 1.0f), true);
+
+    // solve A x = b in the equilibrated scaling
+    cusp::array1d<float,Space> b(y);
+    cusp::array1d<float,Space> solution(A.num_rows, 0.0f);
+
+    E.solve(equilibrate_gmres_solver(), solution, b);
+
+    cusp::array1d<float,cusp::host_memory> h_x(x);
+    cusp::array1d<float,cusp::host_memory> h_solution(solution);
+    for(size_t i = 0; i < h_x.size(); i++)
+        ASSERT_EQUAL(std::fabs(h_solution[i] - h_x[i]) <= 1e-2f * (std::fabs(h_x[i]) + 1.0f), true);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestEquilibratedMatrix);
@@ -0,0 +1,70 @@
+#include <unittest/unittest.h>
+
+#include <cusp/gallery/diffusion.h>
+#include <cusp/gallery/poisson.h>
+#include <cusp/csr_matrix.h>
+#include <cusp/multiply.h>
+#include <cusp/krylov/fgmres.h>
+#include <cusp/precond/aggregation/smoothed_aggregation.h>
+
+template <class MemorySpace>
+void TestFlexibleGeneralizedMinimumResidual(void)
+{
+    cusp::csr_matrix<int, float, MemorySpace> A;
+
+    cusp::gallery::poisson5pt(A, 10, 10);
+
+    cusp::array1d<float, MemorySpace> x(A.num_rows, 0.0f);
+    cusp::array1d<float, MemorySpace> b(A.num_rows, 1.0f);
+
+    cusp::default_monitor<float> monitor(b, 100, 1e-4);
+
+    cusp::krylov::fgmres(A, x, b, 20, monitor);
+
+    // check residual norm
+    cusp::array1d<float, MemorySpace> residual(A.num_rows, 0.0f);
+    cusp::multiply(A, x, residual);
+    cusp::blas::axpby(residual, b, residual, -1.0f, 1.0f);
+
+    ASSERT_EQUAL(monitor.converged(), true);
+    ASSERT_EQUAL(cusp::blas::nrm2(residual) < 1e-3 * cusp::blas::nrm2(b), true);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestFlexibleGeneralizedMinimumResidual);
+
+
+template <class MemorySpace>
+void TestFlexibleGeneralizedMinimumResidualVariablePreconditioner(void)
+{
+    // nonsymmetric rotated anisotropic diffusion
+    cusp::csr_matrix<int, float, MemorySpace> A;
+    cusp::gallery::diffusion<cusp::gallery::FD>(A, 24, 24, 0.1, 0.5);
+
+    cusp::array1d<float, MemorySpace> b = unittest::random_samples<float>(A.num_rows);
+
+    // the K-cycle depends on its input nonlinearly
+    cusp::precond::aggregation::smoothed_aggregation<int, float, MemorySpace> M(A);
+    M.set_cycle(cusp::K_CYCLE);
+
+    cusp::krylov::workspace<float, MemorySpace> workspace;
+
+    cusp::array1d<float, MemorySpace> x(A.num_rows, 0.0f);
+    cusp::default_monitor<float> monitor(b, 100, 1e-5);
+    cusp::krylov::fgmres(A, x, b, 20, monitor, M, workspace);
+
+    ASSERT_EQUAL(monitor.converged(), true);
+
+    // a second solve reuses the workspace
+    cusp::array1d<float, MemorySpace> y(A.num_rows, 0.0f);
+    cusp::default_monitor<float> monitor2(b, 100, 1e-5);
+    cusp::krylov::fgmres(A, y, b, 20, monitor2, M, workspace);
+
+    ASSERT_EQUAL(monitor2.converged(), true);
+    ASSERT_EQUAL(monitor.iteration_count(), monitor2.iteration_count());
+
+    cusp::array1d<float, MemorySpace> residual(A.num_rows, 0.0f);
+    cusp::multiply(A, x, residual);
+    cusp::blas::axpby(residual, b, residual, -1.0f, 1.0f);
+
+    ASSERT_EQUAL(cusp::blas::nrm2(residual) < 1e-4 * cusp::blas::nrm2(b), true);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestFlexibleGeneralizedMinimumResidualVariablePreconditioner);
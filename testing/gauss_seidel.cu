@@ -0,0 +1,128 @@
+#include <unittest/unittest.h>
+
+#include <cusp/relaxation/gauss_seidel.h>
+#include <cusp/relaxation/jacobi.h>
+#include <cusp/precond/aggregation/smoothed_aggregation.h>
+
+#include <cusp/blas.h>
+#include <cusp/gallery/poisson.h>
+#include <cusp/krylov/cg.h>
+#include <cusp/monitor.h>
+#include <cusp/multiply.h>
+
+template <class Space>
+void TestGaussSeidelSweep(void)
+{
+    cusp::csr_matrix<int,float,cusp::host_memory> A;
+    cusp::gallery::poisson5pt(A, 12, 10);
+
+    cusp::csr_matrix<int,float,Space> d_A(A);
+    cusp::relaxation::gauss_seidel<float,Space> M(d_A, 0.8f);
+
+    ASSERT_EQUAL(M.num_colors() >= 2, true);
+    ASSERT_EQUAL(M.color_offsets.back(), A.num_rows);
+
+    cusp::array1d<float,cusp::host_memory> b = unittest::random_samples<float>(A.num_rows);
+    cusp::array1d<float,cusp::host_memory> x(A.num_rows, 0.0f);
+
+    // sequential reference sweeping the rows of each color in turn
+    cusp::array1d<int,cusp::host_memory> ordered_rows(M.ordered_rows);
+
+    for(size_t c = 0; c < M.num_colors(); c++)
+        for(size_t p = M.color_offsets[c]; p < M.color_offsets[c + 1]; p++)
+        {
+            const int i = ordered_rows[p];
+
+            float d = 0, sum = b[i];
+            for(int jj = A.row_offsets[i]; jj < A.row_offsets[i + 1]; jj++)
+            {
+                if(A.column_indices[jj] == i)
+                    d = A.values[jj];
+                sum -= A.values[jj] * x[A.column_indices[jj]];
+            }
+
+            x[i] += 0.8f * sum / d;
+        }
+
+    cusp::array1d<float,Space> d_b(b);
+    cusp::array1d<float,Space> d_x(A.num_rows, 0.0f);
+    M.forward_sweep(d_b, d_x, 0.8f);
+
+    cusp::array1d<float,cusp::host_memory> h_x(d_x);
+    ASSERT_ALMOST_EQUAL(h_x, x);
+
+    // presmooth ignores the initial x
+    cusp::array1d<float,Space> y(A.num_rows, 5.0f);
+    M.presmooth(d_A, d_b, y);
+    ASSERT_ALMOST_EQUAL((cusp::array1d<float,cusp::host_memory>(y)), x);
+
+    // copy to another memory space
+    cusp::relaxation::gauss_seidel<float,cusp::host_memory> C(M);
+    ASSERT_EQUAL(C.num_colors(), M.num_colors());
+    ASSERT_EQUAL(C.ordered_rows, M.ordered_rows);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestGaussSeidelSweep);
+
+template <class Space>
+void TestGaussSeidelRelaxation(void)
+{
+    cusp::csr_matrix<int,float,Space> A;
+    cusp::gallery::poisson5pt(A, 20, 20);
+
+    cusp::array1d<float,Space> b = unittest::random_samples<float>(A.num_rows);
+    cusp::array1d<float,Space> x(A.num_rows, 0.0f);
+    cusp::array1d<float,Space> y(A.num_rows, 0.0f);
+    cusp::array1d<float,Space> r(A.num_rows);
+
+    cusp::relaxation::gauss_seidel<float,Space> GS(A);
+    cusp::relaxation::jacobi<float,Space>       J(A, 2.0f / 3.0f);
+
+    for(int i = 0; i < 10; i++)
+    {
+        GS(A, b, x);
+        J(A, b, y);
+    }
+
+    cusp::multiply(A, x, r);
+    cusp::blas::axpby(b, r, r, 1.0f, -1.0f);
+    float gs_residual = cusp::blas::nrm2(r);
+
+    cusp::multiply(A, y, r);
+    cusp::blas::axpby(b, r, r, 1.0f, -1.0f);
+    float jacobi_residual = cusp::blas::nrm2(r);
+
+    ASSERT_EQUAL(gs_residual < jacobi_residual, true);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestGaussSeidelRelaxation);
+
+template <class Space>
+void TestGaussSeidelSmoother(void)
+{
+    typedef cusp::relaxation::gauss_seidel<float,Space> Smoother;
+
+    cusp::coo_matrix<int,float,Space> A;
+    cusp::gallery::poisson5pt(A, 50, 50);
+
+    cusp::array1d<float,Space> b = unittest::random_samples<float>(A.num_rows);
+
+    size_t jacobi_iterations;
+    {
+        cusp::precond::aggregation::smoothed_aggregation<int,float,Space> M(A);
+        cusp::array1d<float,Space> x(A.num_rows, 0.0f);
+        cusp::default_monitor<float> monitor(b, 100, 1e-6);
+        cusp::krylov::cg(A, x, b, monitor, M);
+        ASSERT_EQUAL(monitor.converged(), true);
+        jacobi_iterations = monitor.iteration_count();
+    }
+
+    {
+        // forward presmoothing and backward postsmoothing keep the cycle symmetric
+        cusp::precond::aggregation::smoothed_aggregation<int,float,Space,Smoother> M(A);
+        cusp::array1d<float,Space> x(A.num_rows, 0.0f);
+        cusp::default_monitor<float> monitor(b, 100, 1e-6);
+        cusp::krylov::cg(A, x, b, monitor, M);
+        ASSERT_EQUAL(monitor.converged(), true);
+        ASSERT_LEQUAL(monitor.iteration_count(), jacobi_iterations);
+    }
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestGaussSeidelSmoother);
@@ -0,0 +1,68 @@
+#include <unittest/unittest.h>
+
+#include <cusp/gallery/poisson.h>
+#include <cusp/csr_matrix.h>
+#include <cusp/monitor.h>
+#include <cusp/multiply.h>
+#include <cusp/krylov/gmres.h>
+#include <cusp/krylov/gcro_dr.h>
+
+template <class MemorySpace>
+void TestGCRODR(void)
+{
+    cusp::csr_matrix<int, float, cusp::host_memory> P;
+    cusp::gallery::poisson5pt(P, 20, 20);
+
+    cusp::krylov::gcro_dr<float, MemorySpace> solver(20, 5);
+
+    ASSERT_EQUAL(solver.num_recycled(), 0);
+
+    size_t first_iterations = 0;
+
+    // a sequence of slowly changing convection-diffusion operators
+    for (size_t step = 0; step < 4; step++)
+    {
+        cusp::csr_matrix<int, float, cusp::host_memory> A_host(P);
+        for (size_t i = 0; i < A_host.num_rows; i++)
+            for (int jj = A_host.row_offsets[i]; jj < A_host.row_offsets[i + 1]; jj++)
+                if (A_host.column_indices[jj] == int(i))
+                    A_host.values[jj] += 0.01f * step;
+                else if (A_host.column_indices[jj] == int(i) - 1)
+                    A_host.values[jj] = -1.4f;
+                else if (A_host.column_indices[jj] == int(i) + 1)
+                    A_host.values[jj] = -0.6f;
+
+        cusp::csr_matrix<int, float, MemorySpace> A(A_host);
+        cusp::array1d<float, MemorySpace> b = unittest::random_samples<float>(A.num_rows);
+        cusp::array1d<float, MemorySpace> x(A.num_rows, 0.0f);
+        cusp::array1d<float, MemorySpace> x_gmres(A.num_rows, 0.0f);
+
+        cusp::default_monitor<float> monitor(b, 500, 1e-5);
+        solver.solve(A, x, b, monitor);
+
+        cusp::default_monitor<float> monitor_gmres(b, 500, 1e-5);
+        cusp::krylov::gmres(A, x_gmres, b, 20, monitor_gmres);
+
+        ASSERT_EQUAL(monitor.converged(), true);
+        ASSERT_EQUAL(solver.num_recycled(), 5);
+
+        cusp::array1d<float, MemorySpace> residual(A.num_rows, 0.0f);
+        cusp::multiply(A, x, residual);
+        cusp::blas::axpby(residual, b, residual, -1.0f, 1.0f);
+
+        ASSERT_EQUAL(cusp::blas::nrm2(residual) <= 1e-4 * cusp::blas::nrm2(b), true);
+
+        // recycling across restarts already beats restarted GMRES
+        ASSERT_EQUAL(monitor.iteration_count() < monitor_gmres.iteration_count(), true);
+
+        // and the recycled subspace speeds up the later solves
+        if (step == 0)
+            first_iterations = monitor.iteration_count();
+        else
+            ASSERT_EQUAL(monitor.iteration_count() < first_iterations, true);
+    }
+
+    solver.clear();
+    ASSERT_EQUAL(solver.num_recycled(), 0);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestGCRODR);
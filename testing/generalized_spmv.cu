@@ -1,12 +1,14 @@
 #include <unittest/unittest.h>
 
 #include <cusp/detail/device/generalized_spmv/coo_flat.h>
-#include <cusp/detail/device/generalized_spmv/csr_scalar.h>
 
 #include <cusp/array1d.h>
 #include <cusp/coo_matrix.h>
 #include <cusp/csr_matrix.h>
+#include <cusp/hyb_matrix.h>
+#include <cusp/convert.h>
 #include <cusp/multiply.h>
+#include <cusp/detail/functional.h>
 #include <cusp/gallery/poisson.h>
 #include <cusp/gallery/random.h>
 
@@ -24,11 +26,9 @@ void generalized_spmv(const Matrix& A,
                       BinaryFunction2 reduce,
                       cusp::csr_format)
 {
-    cusp::detail::device::cuda::spmv_csr_scalar
-        (A.num_rows,
-         A.row_offsets.begin(), A.column_indices.begin(), A.values.begin(),
-         x.begin(), y.begin(), z.begin(),
-         combine, reduce);
+    // z <- reduce(y, A x) with the semiring kernels of cusp::generalized_multiply
+    z = y;
+    cusp::generalized_multiply(A, x, z, thrust::identity<typename Array3::value_type>(), combine, reduce);
 }
 
 template <typename Matrix,
@@ -159,3 +159,199 @@ void TestCooGeneralizedSpMV(void)
 DECLARE_UNITTEST(TestCooGeneralizedSpMV);
 
 
+
+template <class SparseMatrix>
+void TestGeneralizedMultiply(void)
+{
+  typedef typename SparseMatrix::value_type   ValueType;
+  typedef typename SparseMatrix::memory_space MemorySpace;
+
+  // tridiagonal, so the DIA format stores no explicit zeros
+  cusp::array2d<ValueType, cusp::host_memory> D(4, 4, 0);
+  D(0,0) = 2; D(0,1) = 5;
+  D(1,0) = 1; D(1,1) = 3; D(1,2) = 4;
+              D(2,1) = 6; D(2,2) = 2; D(2,3) = 7;
+                          D(3,2) = 3; D(3,3) = 1;
+
+  SparseMatrix A(D);
+
+  cusp::array1d<ValueType, cusp::host_memory> x(4);
+  x[0] = 1; x[1] = 2; x[2] = 3; x[3] = 4;
+
+  cusp::array1d<ValueType, cusp::host_memory> y(4);
+  y[0] = 10; y[1] = 1; y[2] = 30; y[3] = 4;
+
+  // min-plus
+  {
+    cusp::array1d<ValueType, MemorySpace> d_x(x);
+    cusp::array1d<ValueType, MemorySpace> d_y(y);
+
+    cusp::generalized_multiply(A, d_x, d_y,
+                               thrust::identity<ValueType>(),
+                               thrust::plus<ValueType>(),
+                               thrust::minimum<ValueType>());
+
+    ASSERT_EQUAL(d_y[0], 3);
+    ASSERT_EQUAL(d_y[1], 1);
+    ASSERT_EQUAL(d_y[2], 5);
+    ASSERT_EQUAL(d_y[3], 4);
+  }
+
+  // max-times
+  {
+    cusp::array1d<ValueType, MemorySpace> d_x(x);
+    cusp::array1d<ValueType, MemorySpace> d_y(y);
+
+    cusp::generalized_multiply(A, d_x, d_y,
+                               cusp::detail::zero_function<ValueType>(),
+                               thrust::multiplies<ValueType>(),
+                               thrust::maximum<ValueType>());
+
+    ASSERT_EQUAL(d_y[0], 10);
+    ASSERT_EQUAL(d_y[1], 12);
+    ASSERT_EQUAL(d_y[2], 28);
+    ASSERT_EQUAL(d_y[3],  9);
+  }
+
+  // boolean
+  {
+    cusp::array1d<ValueType, MemorySpace> d_x(4, 0);
+    cusp::array1d<ValueType, MemorySpace> d_y(4, 1);
+    d_x[2] = 1;
+
+    cusp::generalized_multiply(A, d_x, d_y,
+                               cusp::detail::zero_function<ValueType>(),
+                               thrust::logical_and<ValueType>(),
+                               thrust::logical_or<ValueType>());
+
+    ASSERT_EQUAL(d_y[0], 0);
+    ASSERT_EQUAL(d_y[1], 1);
+    ASSERT_EQUAL(d_y[2], 1);
+    ASSERT_EQUAL(d_y[3], 1);
+  }
+
+  // plus-times is the usual product
+  {
+    cusp::array1d<ValueType, MemorySpace> d_x(x);
+    cusp::array1d<ValueType, MemorySpace> d_y(y);
+    cusp::array1d<ValueType, MemorySpace> reference(4);
+
+    cusp::generalized_multiply(A, d_x, d_y,
+                               cusp::detail::zero_function<ValueType>(),
+                               thrust::multiplies<ValueType>(),
+                               thrust::plus<ValueType>());
+    cusp::multiply(A, d_x, reference);
+
+    ASSERT_EQUAL(d_y, reference);
+  }
+
+  {
+    cusp::array1d<ValueType, MemorySpace> d_x(5);
+    cusp::array1d<ValueType, MemorySpace> d_y(4);
+
+    ASSERT_THROWS(cusp::generalized_multiply(A, d_x, d_y,
+                                             thrust::identity<ValueType>(),
+                                             thrust::plus<ValueType>(),
+                                             thrust::minimum<ValueType>()),
+                  cusp::invalid_input_exception);
+  }
+}
+DECLARE_SPARSE_MATRIX_UNITTEST(TestGeneralizedMultiply);
+
+template <class MemorySpace>
+void TestGeneralizedMultiplyRowLengths(void)
+{
+  // rows of every length up to 40, with empty rows in between, cover
+  // all the vector widths of the CSR kernel
+  cusp::coo_matrix<int, float, cusp::host_memory> A(81, 50, 40 * 41 / 2);
+
+  size_t n = 0;
+  for(int i = 0; i < 81; i++)
+    for(int k = 0; k < (i % 2 ? i / 2 : 0); k++, n++)
+    {
+      A.row_indices[n]    = i;
+      A.column_indices[n] = (3 * k + i) % 50;
+      A.values[n]         = (k + 2 * i) % 7 + 1;
+    }
+  A.resize(81, 50, n);
+  A.sort_by_row_and_column();
+
+  cusp::array1d<float, cusp::host_memory> x(50);
+  for(size_t j = 0; j < x.size(); j++)
+    x[j] = (5 * j) % 11;
+
+  cusp::array1d<float, cusp::host_memory> reference(81, 100.0f);
+  cusp::generalized_multiply(A, x, reference,
+                             thrust::identity<float>(),
+                             thrust::plus<float>(),
+                             thrust::minimum<float>());
+
+  cusp::csr_matrix<int, float, MemorySpace> B(A);
+  cusp::coo_matrix<int, float, MemorySpace> C(A);
+  cusp::hyb_matrix<int, float, MemorySpace> H;
+  cusp::convert(A, H);
+
+  cusp::array1d<float, MemorySpace> d_x(x);
+
+  cusp::array1d<float, MemorySpace> y(81, 100.0f);
+  cusp::generalized_multiply(B, d_x, y, thrust::identity<float>(), thrust::plus<float>(), thrust::minimum<float>());
+  ASSERT_EQUAL(y, reference);
+
+  cusp::array1d<float, MemorySpace> z(81, 100.0f);
+  cusp::generalized_multiply(C, d_x, z, thrust::identity<float>(), thrust::plus<float>(), thrust::minimum<float>());
+  ASSERT_EQUAL(z, reference);
+
+  cusp::array1d<float, MemorySpace> w(81, 100.0f);
+  cusp::generalized_multiply(H, d_x, w, thrust::identity<float>(), thrust::plus<float>(), thrust::minimum<float>());
+  ASSERT_EQUAL(w, reference);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestGeneralizedMultiplyRowLengths);
+
+template <class MemorySpace>
+void TestMaskedMultiply(void)
+{
+  cusp::csr_matrix<int, float, cusp::host_memory> A;
+  cusp::gallery::poisson5pt(A, 7, 6);
+
+  cusp::array1d<float, cusp::host_memory> x(A.num_cols);
+  for(size_t j = 0; j < x.size(); j++)
+    x[j] = int(j % 5) - 2;
+
+  cusp::array1d<float, cusp::host_memory> reference(A.num_rows);
+  cusp::multiply(A, x, reference);
+
+  cusp::array1d<int, MemorySpace> mask(A.num_rows, 0);
+  for(size_t i = 0; i < mask.size(); i += 4)
+    mask[i] = 1;
+
+  // the rows outside the mask keep their values
+  cusp::array1d<float, cusp::host_memory> expected(A.num_rows, -7.0f);
+  for(size_t i = 0; i < expected.size(); i += 4)
+    expected[i] = reference[i];
+
+  cusp::csr_matrix<int, float, MemorySpace> B(A);
+  cusp::hyb_matrix<int, float, MemorySpace> H;
+  cusp::convert(A, H);
+
+  cusp::array1d<float, MemorySpace> d_x(x);
+
+  cusp::array1d<float, MemorySpace> y(A.num_rows, -7.0f);
+  cusp::masked_multiply(B, d_x, mask, y);
+  ASSERT_EQUAL(y, expected);
+
+  cusp::array1d<float, MemorySpace> z(A.num_rows, -7.0f);
+  cusp::masked_multiply(H, d_x, mask, z);
+  ASSERT_EQUAL(z, expected);
+
+  // min-plus over the selected rows
+  cusp::array1d<float, MemorySpace> w(A.num_rows, 100.0f);
+  cusp::array1d<int, MemorySpace> all(A.num_rows, 1);
+  cusp::array1d<float, MemorySpace> v(A.num_rows, 100.0f);
+  cusp::masked_multiply(B, d_x, all, w, thrust::identity<float>(), thrust::plus<float>(), thrust::minimum<float>());
+  cusp::generalized_multiply(B, d_x, v, thrust::identity<float>(), thrust::plus<float>(), thrust::minimum<float>());
+  ASSERT_EQUAL(w, v);
+
+  cusp::array1d<int, MemorySpace> short_mask(A.num_rows - 1, 1);
+  ASSERT_THROWS(cusp::masked_multiply(B, d_x, short_mask, y), cusp::invalid_input_exception);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestMaskedMultiply);
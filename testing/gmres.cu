@@ -0,0 +1,69 @@
+#include <unittest/unittest.h>
+
+#include <cusp/gallery/diffusion.h>
+#include <cusp/gallery/poisson.h>
+#include <cusp/csr_matrix.h>
+#include <cusp/multiply.h>
+#include <cusp/krylov/gmres.h>
+
+template <class MemorySpace>
+void TestGeneralizedMinimumResidual(void)
+{
+    cusp::csr_matrix<int, float, MemorySpace> A;
+
+    cusp::gallery::poisson5pt(A, 10, 10);
+
+    cusp::array1d<float, MemorySpace> x(A.num_rows, 0.0f);
+    cusp::array1d<float, MemorySpace> b(A.num_rows, 1.0f);
+
+    cusp::default_monitor<float> monitor(b, 100, 1e-4);
+
+    cusp::krylov::gmres(A, x, b, 20, monitor);
+
+    // check residual norm
+    cusp::array1d<float, MemorySpace> residual(A.num_rows, 0.0f);
+    cusp::multiply(A, x, residual);
+    cusp::blas::axpby(residual, b, residual, -1.0f, 1.0f);
+
+    ASSERT_EQUAL(monitor.converged(), true);
+    ASSERT_EQUAL(cusp::blas::nrm2(residual) < 1e-3 * cusp::blas::nrm2(b), true);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestGeneralizedMinimumResidual);
+
+
+template <class MemorySpace>
+void TestGeneralizedMinimumResidualOrthogonalization(void)
+{
+    // nonsymmetric rotated anisotropic diffusion
+    cusp::csr_matrix<int, float, MemorySpace> A;
+    cusp::gallery::diffusion<cusp::gallery::FD>(A, 20, 20, 0.1, 0.5);
+
+    cusp::array1d<float, MemorySpace> b = unittest::random_samples<float>(A.num_rows);
+
+    cusp::krylov::workspace<float, MemorySpace> workspace;
+    cusp::identity_operator<float, MemorySpace> M(A.num_rows, A.num_rows);
+
+    // modified Gram-Schmidt
+    cusp::array1d<float, MemorySpace> x_mgs(A.num_rows, 0.0f);
+    cusp::default_monitor<float> monitor_mgs(b, 200, 1e-4);
+    cusp::krylov::gmres(A, x_mgs, b, 30, monitor_mgs, M, workspace, cusp::krylov::MODIFIED_GRAM_SCHMIDT);
+
+    // classical Gram-Schmidt with reorthogonalization
+    cusp::array1d<float, MemorySpace> x_cgs(A.num_rows, 0.0f);
+    cusp::default_monitor<float> monitor_cgs(b, 200, 1e-4);
+    cusp::krylov::gmres(A, x_cgs, b, 30, monitor_cgs, M, workspace, cusp::krylov::CLASSICAL_GRAM_SCHMIDT_2);
+
+    ASSERT_EQUAL(monitor_mgs.converged(), true);
+    ASSERT_EQUAL(monitor_cgs.converged(), true);
+
+    // both build the same Krylov basis up to rounding
+    const int difference = int(monitor_mgs.iteration_count()) - int(monitor_cgs.iteration_count());
+    ASSERT_EQUAL(difference * difference <= 4, true);
+
+    cusp::array1d<float, MemorySpace> residual(A.num_rows, 0.0f);
+    cusp::multiply(A, x_cgs, residual);
+    cusp::blas::axpby(residual, b, residual, -1.0f, 1.0f);
+
+    ASSERT_EQUAL(cusp::blas::nrm2(residual) < 1e-3 * cusp::blas::nrm2(b), true);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestGeneralizedMinimumResidualOrthogonalization);
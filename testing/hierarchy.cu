@@ -0,0 +1,76 @@
+#include <unittest/unittest.h>
+
+#include <cusp/io/hierarchy.h>
+
+#include <cusp/array1d.h>
+#include <cusp/coo_matrix.h>
+#include <cusp/gallery/poisson.h>
+#include <cusp/precond/aggregation/smoothed_aggregation.h>
+
+#include <stdio.h>
+
+#include <string>
+
+const char hierarchy_prefix[] = "test_73019466251843";
+
+void remove_hierarchy_files(size_t num_levels)
+{
+  const std::string prefix(hierarchy_prefix);
+  const char * names[] = {"A", "R", "P", "smoother"};
+
+  for (size_t lvl = 0; lvl < num_levels; lvl++)
+    for (size_t i = 0; i < 4; i++)
+      remove(cusp::io::detail::level_filename(prefix, lvl, names[i]).c_str());
+
+  remove((prefix + ".solver.bin").c_str());
+  remove((prefix + ".hierarchy").c_str());
+}
+
+template <typename MemorySpace>
+void TestReadWriteHierarchy(void)
+{
+  typedef cusp::precond::aggregation::smoothed_aggregation<int, float, MemorySpace> SA;
+
+  cusp::coo_matrix<int, float, MemorySpace> A;
+  cusp::gallery::poisson5pt(A, 50, 50);
+
+  SA M(A);
+  M.set_cycle(cusp::W_CYCLE, 2, 1);
+
+  cusp::io::write_hierarchy(M, hierarchy_prefix);
+
+  typename SA::hierarchy_type H;
+  cusp::io::read_hierarchy(H, hierarchy_prefix);
+
+  ASSERT_EQUAL(H.levels.size(), M.levels.size());
+  ASSERT_EQUAL(H.cycle, cusp::W_CYCLE);
+  ASSERT_EQUAL(H.presmooth_sweeps, 2);
+  ASSERT_EQUAL(H.postsmooth_sweeps, 1);
+
+  for (size_t lvl = 0; lvl < M.levels.size(); lvl++)
+  {
+    ASSERT_EQUAL(H.levels[lvl].A.num_rows, M.levels[lvl].A.num_rows);
+    ASSERT_EQUAL(H.levels[lvl].A.num_entries, M.levels[lvl].A.num_entries);
+  }
+
+  // the loaded hierarchy applies the same cycle
+  cusp::array1d<float, MemorySpace> b = unittest::random_samples<float>(A.num_rows);
+  cusp::array1d<float, MemorySpace> x1(A.num_rows, 0);
+  cusp::array1d<float, MemorySpace> x2(A.num_rows, 0);
+
+  M(b, x1);
+  H(b, x2);
+
+  ASSERT_ALMOST_EQUAL((cusp::array1d<float, cusp::host_memory>(x1)), (cusp::array1d<float, cusp::host_memory>(x2)));
+
+  remove_hierarchy_files(M.levels.size());
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestReadWriteHierarchy);
+
+void TestReadHierarchyMissingFile(void)
+{
+  cusp::precond::aggregation::smoothed_aggregation<int, float, cusp::host_memory>::hierarchy_type H;
+
+  ASSERT_THROWS(cusp::io::read_hierarchy(H, "test_missing_hierarchy"), cusp::io_exception);
+}
+DECLARE_UNITTEST(TestReadHierarchyMissingFile);
@@ -0,0 +1,198 @@
+#include <unittest/unittest.h>
+
+#include <cusp/graph/hilbert_curve.h>
+
+#include <cusp/array1d.h>
+#include <cusp/array2d.h>
+
+#include <cstdlib>
+#include <vector>
+
+// cell centers of an n x n (x n) grid, in a scrambled order
+void grid_points(cusp::array2d<double,cusp::host_memory>& coord, const int n, const int dims)
+{
+    const int num_points = dims == 2 ? n * n : n * n * n;
+
+    coord.resize(num_points, dims);
+
+    for (int k = 0; k < num_points; k++)
+    {
+        const int p = (7 * k + 3) % num_points;
+
+        coord(k, 0) = (p % n + 0.5) / n;
+        coord(k, 1) = (p / n % n + 0.5) / n;
+        if (dims == 3)
+            coord(k, 2) = (p / (n * n) + 0.5) / n;
+    }
+}
+
+int grid_distance(const cusp::array2d<double,cusp::host_memory>& coord, const int n, const int a, const int b)
+{
+    int distance = 0;
+
+    for (size_t d = 0; d < coord.num_cols; d++)
+        distance += std::abs(int(coord(a, d) * n) - int(coord(b, d) * n));
+
+    return distance;
+}
+
+template <class MemorySpace>
+void TestHilbertCurveKeys(void)
+{
+    for (int dims = 2; dims <= 3; dims++)
+    {
+        const int n = 8;
+
+        cusp::array2d<double,cusp::host_memory> coord;
+        grid_points(coord, n, dims);
+
+        cusp::array2d<double,MemorySpace> d_coord(coord);
+        cusp::array1d<unsigned long long,MemorySpace> keys;
+        cusp::graph::space_filling_curve_keys(d_coord, keys);
+
+        ASSERT_EQUAL(keys.size(), coord.num_rows);
+
+        cusp::array1d<int,MemorySpace> d_permutation;
+        cusp::graph::space_filling_curve_ordering(keys, d_permutation);
+
+        // consecutive cells along the Hilbert curve share a face
+        cusp::array1d<int,cusp::host_memory> permutation(d_permutation);
+        for (size_t i = 1; i < permutation.size(); i++)
+            ASSERT_EQUAL(grid_distance(coord, n, permutation[i - 1], permutation[i]), 1);
+
+        // hilbert_curve_ordering gives the same ordering
+        cusp::array1d<int,MemorySpace> ordering;
+        cusp::graph::hilbert_curve_ordering(d_coord, ordering);
+        ASSERT_EQUAL(ordering, d_permutation);
+    }
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestHilbertCurveKeys);
+
+template <class MemorySpace>
+void TestMortonCurveKeys(void)
+{
+    cusp::array2d<double,cusp::host_memory> coord(4, 2);
+    coord(0,0) = 0.75; coord(0,1) = 0.75;
+    coord(1,0) = 0.25; coord(1,1) = 0.75;
+    coord(2,0) = 0.75; coord(2,1) = 0.25;
+    coord(3,0) = 0.25; coord(3,1) = 0.25;
+
+    cusp::array2d<double,MemorySpace> d_coord(coord);
+    cusp::array1d<unsigned long long,MemorySpace> keys;
+    cusp::graph::space_filling_curve_keys(d_coord, keys, cusp::graph::MORTON_CURVE);
+
+    // the quadrants in Z order, with x the most significant bit
+    cusp::array1d<int,MemorySpace> permutation;
+    cusp::graph::space_filling_curve_ordering(keys, permutation);
+
+    ASSERT_EQUAL(permutation[0], 3);
+    ASSERT_EQUAL(permutation[1], 1);
+    ASSERT_EQUAL(permutation[2], 2);
+    ASSERT_EQUAL(permutation[3], 0);
+
+    // the corners take the extreme keys
+    cusp::array2d<double,cusp::host_memory> corners(2, 3);
+    corners(0,0) = 0.0; corners(0,1) = 0.0; corners(0,2) = 0.0;
+    corners(1,0) = 1.0; corners(1,1) = 1.0; corners(1,2) = 1.0;
+
+    cusp::array2d<double,MemorySpace> d_corners(corners);
+    cusp::graph::space_filling_curve_keys(d_corners, keys, cusp::graph::MORTON_CURVE);
+
+    ASSERT_EQUAL(keys[0] == 0ULL, true);
+    ASSERT_EQUAL(keys[1] == 0x7FFFFFFFFFFFFFFFULL, true);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestMortonCurveKeys);
+
+template <class MemorySpace>
+void TestHilbertCurvePartition(void)
+{
+    cusp::array2d<double,cusp::host_memory> coord;
+    grid_points(coord, 10, 2);
+
+    cusp::array2d<double,MemorySpace> d_coord(coord);
+
+    const size_t num_parts = 7;
+
+    cusp::array1d<int,MemorySpace> d_parts(coord.num_rows);
+    cusp::graph::hilbert_curve(d_coord, num_parts, d_parts);
+
+    // the keys can be reused for the same partition
+    cusp::array1d<unsigned long long,MemorySpace> keys;
+    cusp::array1d<int,MemorySpace> parts_from_keys;
+    cusp::graph::space_filling_curve_keys(d_coord, keys);
+    cusp::graph::space_filling_curve_partition(keys, num_parts, parts_from_keys);
+    ASSERT_EQUAL(parts_from_keys, d_parts);
+
+    // balanced parts of consecutive points along the curve
+    cusp::array1d<int,cusp::host_memory> parts(d_parts);
+    cusp::array1d<int,MemorySpace> d_permutation;
+    cusp::graph::space_filling_curve_ordering(keys, d_permutation);
+    cusp::array1d<int,cusp::host_memory> permutation(d_permutation);
+
+    std::vector<size_t> sizes(num_parts, 0);
+    for (size_t i = 0; i < permutation.size(); i++)
+    {
+        ASSERT_EQUAL(parts[permutation[i]] >= 0 && parts[permutation[i]] < int(num_parts), true);
+        if (i > 0)
+            ASSERT_EQUAL(parts[permutation[i]] >= parts[permutation[i - 1]], true);
+        sizes[parts[permutation[i]]]++;
+    }
+
+    for (size_t p = 0; p < num_parts; p++)
+        ASSERT_EQUAL(sizes[p] == 14 || sizes[p] == 15, true);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestHilbertCurvePartition);
+
+template <class MemorySpace>
+void TestSpaceFillingCurveDistribution(void)
+{
+    cusp::array2d<double,cusp::host_memory> coord;
+    grid_points(coord, 5, 3);
+
+    cusp::array2d<double,MemorySpace> d_coord(coord);
+    cusp::array1d<unsigned long long,MemorySpace> keys;
+    cusp::graph::space_filling_curve_keys(d_coord, keys);
+
+    std::vector<int> devices(3, 0);
+    cusp::distributed_layout layout(coord.num_rows, devices);
+
+    cusp::array1d<int,MemorySpace> d_parts;
+    cusp::array1d<int,MemorySpace> d_local_indices;
+    cusp::graph::space_filling_curve_distribution(keys, layout, d_parts, d_local_indices);
+
+    cusp::array1d<int,MemorySpace> d_permutation;
+    cusp::graph::space_filling_curve_ordering(keys, d_permutation);
+
+    cusp::array1d<int,cusp::host_memory> parts(d_parts);
+    cusp::array1d<int,cusp::host_memory> local_indices(d_local_indices);
+    cusp::array1d<int,cusp::host_memory> permutation(d_permutation);
+
+    // the global number of every point is its position along the curve
+    for (size_t i = 0; i < permutation.size(); i++)
+    {
+        const int k = permutation[i];
+
+        ASSERT_EQUAL(local_indices[k] >= 0 && size_t(local_indices[k]) < layout.part_size(parts[k]), true);
+        ASSERT_EQUAL(layout.offsets[parts[k]] + local_indices[k], i);
+    }
+
+    cusp::distributed_layout wrong_layout(coord.num_rows + 1, devices);
+    ASSERT_THROWS(cusp::graph::space_filling_curve_distribution(keys, wrong_layout, d_parts, d_local_indices),
+                  cusp::invalid_input_exception);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestSpaceFillingCurveDistribution);
+
+template <class MemorySpace>
+void TestSpaceFillingCurveInvalidInput(void)
+{
+    cusp::array1d<unsigned long long,MemorySpace> keys;
+
+    cusp::array2d<double,MemorySpace> outside(2, 2, 0.5);
+    outside(1, 1) = 1.5;
+    ASSERT_THROWS(cusp::graph::space_filling_curve_keys(outside, keys), cusp::invalid_input_exception);
+
+    cusp::array2d<double,MemorySpace> four_dims(2, 4, 0.5);
+    ASSERT_THROWS(cusp::graph::space_filling_curve_keys(four_dims, keys, cusp::graph::MORTON_CURVE),
+                  cusp::invalid_input_exception);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestSpaceFillingCurveInvalidInput);
@@ -0,0 +1,75 @@
+#include <unittest/unittest.h>
+
+#include <cusp/gallery/poisson.h>
+#include <cusp/csr_matrix.h>
+#include <cusp/history_monitor.h>
+#include <cusp/krylov/bicgstab.h>
+
+template <typename MemorySpace>
+void TestHistoryMonitorRingBuffer(void)
+{
+    cusp::array1d<float,MemorySpace> b(2, 0.0f);
+    b[0] = 10;
+
+    cusp::array1d<float,MemorySpace> r(2, 0.0f);
+
+    cusp::history_monitor<float,MemorySpace> monitor(b, 100, 0.1, 0.0, 4, 3);
+
+    ASSERT_EQUAL(monitor.capacity(), 3);
+    ASSERT_EQUAL(monitor.num_recorded(), 0);
+
+    // norms 8, 7, 6, 5, 4 in iterations 0 .. 4
+    for (size_t i = 0; i < 5; i++)
+    {
+        r[1] = 8.0f - i;
+
+        ASSERT_EQUAL(monitor.finished(r), false);
+
+        ++monitor;
+    }
+
+    // the ring buffer keeps iterations 2 .. 4
+    cusp::array1d<float,cusp::host_memory> history = monitor.history();
+
+    ASSERT_EQUAL(monitor.num_recorded(), 3);
+    ASSERT_EQUAL(monitor.first_recorded_iteration(), 2);
+    ASSERT_EQUAL(history.size(), 3);
+    ASSERT_ALMOST_EQUAL(history[0], 6.0f);
+    ASSERT_ALMOST_EQUAL(history[1], 5.0f);
+    ASSERT_ALMOST_EQUAL(history[2], 4.0f);
+
+    // only iteration 4 was tested
+    ASSERT_EQUAL(monitor.residual_norm(), 4.0f);
+
+    // a norm pushed by the solver is recorded and tested
+    ASSERT_EQUAL(monitor.finished(0.5f), true);
+
+    history = monitor.history();
+    ASSERT_EQUAL(history.size(), 3);
+    ASSERT_ALMOST_EQUAL(history[2], 0.5f);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestHistoryMonitorRingBuffer);
+
+template <typename MemorySpace>
+void TestHistoryMonitorSolver(void)
+{
+    cusp::csr_matrix<int, float, MemorySpace> A;
+    cusp::gallery::poisson5pt(A, 20, 20);
+
+    cusp::array1d<float, MemorySpace> x(A.num_rows, 0.0f);
+    cusp::array1d<float, MemorySpace> b = unittest::random_samples<float>(A.num_rows);
+
+    cusp::history_monitor<float,MemorySpace> monitor(b, 500, 1e-5, 0.0, 5);
+
+    cusp::krylov::bicgstab(A, x, b, monitor);
+
+    ASSERT_EQUAL(monitor.converged(), true);
+    ASSERT_EQUAL(monitor.iteration_count() % 5, 0);
+
+    cusp::array1d<float,cusp::host_memory> history = monitor.history();
+
+    ASSERT_EQUAL(history.size(), monitor.iteration_count() + 1);
+    ASSERT_EQUAL(history[0] < cusp::blas::nrm2(b), true);
+    ASSERT_ALMOST_EQUAL(history[history.size() - 1], monitor.residual_norm());
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestHistoryMonitorSolver);
@@ -0,0 +1,216 @@
+#include <unittest/unittest.h>
+
+#include <cusp/precond/ilu.h>
+#include <cusp/precond/aggregation/smoothed_aggregation.h>
+
+#include <cusp/gallery/poisson.h>
+#include <cusp/krylov/bicgstab.h>
+#include <cusp/krylov/cg.h>
+#include <cusp/monitor.h>
+#include <cusp/multiply.h>
+
+// nonsymmetric tridiagonal matrix, its ILU(0) is the exact LU factorization
+template <typename Matrix>
+void initialize_ilu_tridiagonal(Matrix& A, int N)
+{
+    cusp::coo_matrix<int,float,cusp::host_memory> T(N, N, 3 * N - 2);
+
+    int n = 0;
+    for(int i = 0; i < N; i++)
+    {
+        if(i > 0)
+        {
+            T.row_indices[n] = i;  T.column_indices[n] = i - 1;  T.values[n] = -1.0f - 0.25f * (i % 3);  n++;
+        }
+
+        T.row_indices[n] = i;  T.column_indices[n] = i;  T.values[n] = 4.0f;  n++;
+
+        if(i + 1 < N)
+        {
+            T.row_indices[n] = i;  T.column_indices[n] = i + 1;  T.values[n] = -2.0f;  n++;
+        }
+    }
+
+    A = T;
+}
+
+template <class Space>
+void TestILU0Tridiagonal(void)
+{
+    cusp::csr_matrix<int,float,Space> A;
+    initialize_ilu_tridiagonal(A, 20);
+
+    cusp::precond::ilu0<float,Space> M(A);
+
+    ASSERT_EQUAL(M.num_rows, 20);
+    ASSERT_EQUAL(M.num_cols, 20);
+
+    // every row depends on its neighbour
+    ASSERT_EQUAL(M.L.num_levels(), 20);
+    ASSERT_EQUAL(M.U.num_levels(), 20);
+
+    cusp::array1d<float,cusp::host_memory> x(20);
+    for(size_t i = 0; i < x.size(); i++)
+        x[i] = int(i % 5) - 2;
+
+    cusp::array1d<float,Space> d_x(x);
+    cusp::array1d<float,Space> b(20);
+    cusp::array1d<float,Space> y(20, 10.0f);
+
+    cusp::multiply(A, d_x, b);
+    M(b, y);
+
+    cusp::array1d<float,cusp::host_memory> h_y(y);
+    ASSERT_ALMOST_EQUAL(h_y, x);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestILU0Tridiagonal);
+
+template <class Space>
+void TestILU0Levels(void)
+{
+    cusp::csr_matrix<int,float,Space> A;
+    cusp::gallery::poisson5pt(A, 16, 12);
+
+    cusp::precond::ilu0<float,Space> M(A);
+
+    // the levels of the 5-point stencil are the anti-diagonals of the grid
+    ASSERT_EQUAL(M.L.num_levels(), 16 + 12 - 1);
+    ASSERT_EQUAL(M.U.num_levels(), 16 + 12 - 1);
+
+    ASSERT_EQUAL(M.L.strict.num_entries, (A.num_entries - A.num_rows) / 2);
+    ASSERT_EQUAL(M.U.strict.num_entries, (A.num_entries - A.num_rows) / 2);
+
+    // the first level of L holds the rows without lower neighbours
+    cusp::array1d<int,cusp::host_memory> level_rows(M.L.level_rows);
+    ASSERT_EQUAL(M.L.level_offsets[1], 1);
+    ASSERT_EQUAL(level_rows[0], 0);
+
+    // the factors are the same in both memory spaces
+    cusp::csr_matrix<int,float,cusp::host_memory> H(A);
+    cusp::precond::ilu0<float,cusp::host_memory> N(H);
+
+    ASSERT_EQUAL(N.L.level_offsets == M.L.level_offsets, true);
+    ASSERT_EQUAL(N.U.level_offsets == M.U.level_offsets, true);
+    ASSERT_EQUAL(N.L.level_rows, M.L.level_rows);
+    ASSERT_EQUAL(N.U.level_rows, M.U.level_rows);
+    cusp::array1d<float,cusp::host_memory> U_values(M.U.strict.values);
+    ASSERT_ALMOST_EQUAL(N.U.strict.values, U_values);
+
+    // copy to another memory space
+    cusp::precond::ilu0<float,cusp::host_memory> C(M);
+    ASSERT_EQUAL(C.L.level_rows, M.L.level_rows);
+    ASSERT_EQUAL(C.num_rows, M.num_rows);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestILU0Levels);
+
+template <class Space>
+void TestIC0(void)
+{
+    cusp::csr_matrix<int,float,Space> A;
+    cusp::gallery::poisson5pt(A, 10, 10);
+
+    cusp::precond::ilu0<float,Space> M(A);
+    cusp::precond::ic0<float,Space>  N(A);
+
+    ASSERT_EQUAL(N.L.num_levels(), 19);
+    ASSERT_EQUAL(N.U.num_levels(), 19);
+
+    // for a symmetric matrix L U = L' L'^T, so both apply the same operator
+    cusp::array1d<float,Space> x = unittest::random_samples<float>(A.num_rows);
+    cusp::array1d<float,Space> y(A.num_rows);
+    cusp::array1d<float,Space> z(A.num_rows);
+
+    M(x, y);
+    N(x, z);
+
+    cusp::array1d<float,cusp::host_memory> h_y(y);
+    cusp::array1d<float,cusp::host_memory> h_z(z);
+    ASSERT_ALMOST_EQUAL(h_y, h_z);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestIC0);
+
+template <class Space>
+void TestILUPreconditionedSolvers(void)
+{
+    cusp::csr_matrix<int,float,Space> A;
+    cusp::gallery::poisson5pt(A, 32, 32);
+
+    cusp::array1d<float,Space> b = unittest::random_samples<float>(A.num_rows);
+
+    size_t unpreconditioned;
+    {
+        cusp::array1d<float,Space> x(A.num_rows, 0.0f);
+        cusp::default_monitor<float> monitor(b, 500, 1e-5);
+        cusp::krylov::cg(A, x, b, monitor);
+        ASSERT_EQUAL(monitor.converged(), true);
+        unpreconditioned = monitor.iteration_count();
+    }
+
+    {
+        cusp::precond::ic0<float,Space> M(A);
+        cusp::array1d<float,Space> x(A.num_rows, 0.0f);
+        cusp::default_monitor<float> monitor(b, 500, 1e-5);
+        cusp::krylov::cg(A, x, b, monitor, M);
+        ASSERT_EQUAL(monitor.converged(), true);
+        ASSERT_EQUAL(monitor.iteration_count() < unpreconditioned, true);
+    }
+
+    {
+        cusp::precond::ilu0<float,Space> M(A);
+        cusp::array1d<float,Space> x(A.num_rows, 0.0f);
+        cusp::default_monitor<float> monitor(b, 500, 1e-5);
+        cusp::krylov::bicgstab(A, x, b, monitor, M);
+        ASSERT_EQUAL(monitor.converged(), true);
+    }
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestILUPreconditionedSolvers);
+
+template <class Space>
+void TestILUSmoother(void)
+{
+    typedef cusp::precond::ic0<float,Space>  IC0;
+    typedef cusp::precond::ilu0<float,Space> ILU0;
+
+    cusp::coo_matrix<int,float,Space> A;
+    cusp::gallery::poisson5pt(A, 50, 50);
+
+    cusp::array1d<float,Space> b = unittest::random_samples<float>(A.num_rows);
+
+    {
+        cusp::precond::aggregation::smoothed_aggregation<int,float,Space,IC0> M(A);
+        cusp::array1d<float,Space> x(A.num_rows, 0.0f);
+        cusp::default_monitor<float> monitor(b, 30, 1e-5);
+        cusp::krylov::cg(A, x, b, monitor, M);
+        ASSERT_EQUAL(monitor.converged(), true);
+    }
+
+    {
+        cusp::precond::aggregation::smoothed_aggregation<int,float,Space,ILU0> M(A);
+        cusp::array1d<float,Space> x(A.num_rows, 0.0f);
+        cusp::default_monitor<float> monitor(b, 30, 1e-5);
+        M.solve(b, x, monitor);
+        ASSERT_EQUAL(monitor.converged(), true);
+    }
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestILUSmoother);
+
+void TestILUInvalidInput(void)
+{
+    // missing diagonal entry
+    cusp::coo_matrix<int,float,cusp::host_memory> A(2, 2, 3);
+    A.row_indices[0] = 0;  A.column_indices[0] = 0;  A.values[0] = 1.0f;
+    A.row_indices[1] = 0;  A.column_indices[1] = 1;  A.values[1] = 1.0f;
+    A.row_indices[2] = 1;  A.column_indices[2] = 0;  A.values[2] = 1.0f;
+
+    ASSERT_THROWS((cusp::precond::ilu0<float,cusp::host_memory>(A)), cusp::invalid_input_exception);
+    ASSERT_THROWS((cusp::precond::ic0<float,cusp::host_memory>(A)),  cusp::invalid_input_exception);
+
+    // indefinite matrix
+    cusp::csr_matrix<int,float,cusp::host_memory> B;
+    cusp::gallery::poisson5pt(B, 4, 4);
+    for(size_t n = 0; n < B.num_entries; n++)
+        B.values[n] = -B.values[n];
+
+    ASSERT_THROWS((cusp::precond::ic0<float,cusp::host_memory>(B)), cusp::runtime_exception);
+}
+DECLARE_UNITTEST(TestILUInvalidInput);
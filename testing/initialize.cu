@@ -0,0 +1,39 @@
+#include <unittest/unittest.h>
+
+#include <cusp/initialize.h>
+#include <cusp/csr_matrix.h>
+#include <cusp/ell_matrix.h>
+#include <cusp/hyb_matrix.h>
+
+#include <cusp/detail/device/arch.h>
+
+void TestInitialize(void)
+{
+    int device = 0;
+    cudaGetDevice(&device);
+
+    // the context exists already, only the caches are filled
+    cusp::initialize(device, false);
+    cusp::initialize();
+
+    int current = -1;
+    cudaGetDevice(&current);
+    ASSERT_EQUAL(current, device);
+}
+DECLARE_UNITTEST(TestInitialize);
+
+void TestInitializeSpMV(void)
+{
+    cusp::initialize_spmv< cusp::csr_matrix<int, float,  cusp::device_memory> >();
+    cusp::initialize_spmv< cusp::csr_matrix<int, double, cusp::device_memory> >(30);
+    cusp::initialize_spmv< cusp::ell_matrix<int, float,  cusp::device_memory> >();
+    cusp::initialize_spmv< cusp::hyb_matrix<int, float,  cusp::device_memory> >(1);
+
+    // the occupancy of the kernels which ran is cached
+    ASSERT_EQUAL(cusp::detail::device::arch::occupancy_cache().empty(), false);
+
+    const size_t cached = cusp::detail::device::arch::occupancy_cache().size();
+    cusp::initialize_spmv< cusp::csr_matrix<int, float, cusp::device_memory> >();
+    ASSERT_EQUAL(cusp::detail::device::arch::occupancy_cache().size(), cached);
+}
+DECLARE_UNITTEST(TestInitializeSpMV);
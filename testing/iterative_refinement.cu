@@ -0,0 +1,93 @@
+#include <unittest/unittest.h>
+
+#include <cusp/gallery/poisson.h>
+#include <cusp/csr_matrix.h>
+#include <cusp/multiply.h>
+#include <cusp/krylov/iterative_refinement.h>
+#include <cusp/precond/diagonal.h>
+
+template <typename Matrix, typename Array>
+double relative_residual(const Matrix& A, const Array& x, const Array& b)
+{
+    typedef typename Array::value_type   ValueType;
+    typedef typename Array::memory_space MemorySpace;
+
+    cusp::array1d<ValueType, MemorySpace> residual(A.num_rows);
+    cusp::multiply(A, x, residual);
+    cusp::blas::axpby(residual, b, residual, ValueType(-1), ValueType(1));
+
+    return cusp::blas::nrm2(residual) / cusp::blas::nrm2(b);
+}
+
+template <class MemorySpace>
+void TestIterativeRefinement(void)
+{
+    cusp::csr_matrix<int, double, MemorySpace> A;
+    cusp::gallery::poisson5pt(A, 20, 20);
+
+    cusp::csr_matrix<int, float, MemorySpace> A_low(A);
+
+    cusp::array1d<double, MemorySpace> b(A.num_rows, 1.0);
+
+    // the tolerance is beyond the accuracy of a single precision solve
+    {
+        cusp::array1d<double, MemorySpace> x(A.num_rows, 0.0);
+        cusp::default_monitor<double> monitor(b, 30, 1e-12);
+
+        cusp::krylov::iterative_refinement(A, A_low, x, b, monitor);
+
+        ASSERT_EQUAL(monitor.converged(), true);
+        ASSERT_EQUAL(relative_residual(A, x, b) < 1e-12, true);
+    }
+
+    // inner CG with a diagonal preconditioner
+    {
+        cusp::array1d<double, MemorySpace> x(A.num_rows, 0.0);
+        cusp::default_monitor<double> monitor(b, 30, 1e-12);
+
+        cusp::krylov::refinement_cg<float, MemorySpace> inner(200, 1e-4f);
+        cusp::precond::diagonal<float, MemorySpace> M(A_low);
+
+        cusp::krylov::iterative_refinement(A, A_low, x, b, monitor, inner, M);
+
+        ASSERT_EQUAL(monitor.converged(), true);
+        ASSERT_EQUAL(monitor.iteration_count() < 10, true);
+        ASSERT_EQUAL(relative_residual(A, x, b) < 1e-12, true);
+    }
+
+    // inner GMRES
+    {
+        cusp::array1d<double, MemorySpace> x(A.num_rows, 0.0);
+        cusp::default_monitor<double> monitor(b, 30, 1e-12);
+
+        cusp::krylov::refinement_gmres<float, MemorySpace> inner(40, 200, 1e-3f);
+
+        cusp::krylov::iterative_refinement(A, A_low, x, b, monitor, inner);
+
+        ASSERT_EQUAL(monitor.converged(), true);
+        ASSERT_EQUAL(relative_residual(A, x, b) < 1e-12, true);
+    }
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestIterativeRefinement);
+
+template <class MemorySpace>
+void TestIterativeRefinementZeroResidual(void)
+{
+    cusp::csr_matrix<int, double, MemorySpace> A;
+    cusp::gallery::poisson5pt(A, 5, 5);
+
+    cusp::csr_matrix<int, float, MemorySpace> A_low(A);
+
+    cusp::array1d<double, MemorySpace> x(A.num_rows, 1.0);
+    cusp::array1d<double, MemorySpace> b(A.num_rows);
+    cusp::multiply(A, x, b);
+
+    cusp::default_monitor<double> monitor(b, 20, 0.0);
+
+    cusp::krylov::iterative_refinement(A, A_low, x, b, monitor);
+
+    ASSERT_EQUAL(monitor.converged(),    true);
+    ASSERT_EQUAL(monitor.iteration_count(), 0);
+    ASSERT_EQUAL(x, (cusp::array1d<double, MemorySpace>(A.num_rows, 1.0)));
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestIterativeRefinementZeroResidual);
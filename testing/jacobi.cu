@@ -8,6 +8,9 @@
 #include <cusp/dia_matrix.h>
 #include <cusp/ell_matrix.h>
 #include <cusp/hyb_matrix.h>
+#include <cusp/multiply.h>
+#include <cusp/detail/format_utils.h>
+#include <cusp/gallery/poisson.h>
 
 template <typename Matrix>
 void TestJacobiRelaxation(void)
@@ -74,3 +77,59 @@ void TestJacobiRelaxationWithWeighting(void)
 }
 DECLARE_SPARSE_MATRIX_UNITTEST(TestJacobiRelaxationWithWeighting);
 
+
+template <typename Matrix>
+void TestJacobiSweepsWithResidual(void)
+{
+    typedef typename Matrix::memory_space Space;
+
+    cusp::csr_matrix<int, float, cusp::host_memory> A_host;
+    cusp::gallery::poisson5pt(A_host, 9, 7);
+
+    const size_t N = A_host.num_rows;
+
+    cusp::array1d<float, cusp::host_memory> b = unittest::random_samples<float>(N);
+    cusp::array1d<float, cusp::host_memory> diagonal;
+    cusp::detail::extract_diagonal(A_host, diagonal);
+
+    // reference: three sweeps from x = 0
+    cusp::array1d<float, cusp::host_memory> expected(N, 0.0f);
+    cusp::array1d<float, cusp::host_memory> y(N);
+    for(int k = 0; k < 3; k++)
+    {
+        cusp::multiply(A_host, expected, y);
+        for(size_t i = 0; i < N; i++)
+            expected[i] += 0.8f * (b[i] - y[i]) / diagonal[i];
+    }
+
+    cusp::array1d<float, cusp::host_memory> expected_residual(N);
+    cusp::multiply(A_host, expected, y);
+    for(size_t i = 0; i < N; i++)
+        expected_residual[i] = b[i] - y[i];
+
+    Matrix A(A_host);
+    cusp::array1d<float, Space> d_b(b);
+
+    cusp::relaxation::jacobi<float, Space> relax(A, 0.8f, 3);
+
+    // presmooth: one sweep without SpMV and two fused sweeps
+    {
+        cusp::array1d<float, Space> x(N, 5.0f);
+        cusp::array1d<float, Space> r(N);
+        relax.presmooth(A, d_b, x, r);
+
+        ASSERT_ALMOST_EQUAL((cusp::array1d<float, cusp::host_memory>(x)), expected);
+        ASSERT_ALMOST_EQUAL((cusp::array1d<float, cusp::host_memory>(r)), expected_residual);
+    }
+
+    // postsmooth from x = 0
+    {
+        cusp::array1d<float, Space> x(N, 0.0f);
+        cusp::array1d<float, Space> r(N);
+        relax.postsmooth(A, d_b, x, r);
+
+        ASSERT_ALMOST_EQUAL((cusp::array1d<float, cusp::host_memory>(x)), expected);
+        ASSERT_ALMOST_EQUAL((cusp::array1d<float, cusp::host_memory>(r)), expected_residual);
+    }
+}
+DECLARE_SPARSE_MATRIX_UNITTEST(TestJacobiSweepsWithResidual);
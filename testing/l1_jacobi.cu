@@ -0,0 +1,78 @@
+#include <unittest/unittest.h>
+
+#include <cusp/relaxation/l1_jacobi.h>
+#include <cusp/precond/aggregation/smoothed_aggregation.h>
+
+#include <cusp/array2d.h>
+#include <cusp/blas.h>
+#include <cusp/gallery/poisson.h>
+#include <cusp/krylov/cg.h>
+#include <cusp/monitor.h>
+#include <cusp/multiply.h>
+
+template <typename Matrix>
+void TestL1JacobiRelaxation(void)
+{
+    typedef typename Matrix::memory_space Space;
+
+    cusp::array2d<float, Space> M(2,2);
+    M(0,0) = 2.0;  M(0,1) = 1.0;
+    M(1,0) = 1.0;  M(1,1) = 3.0;
+
+    Matrix A(M);
+
+    cusp::array1d<float, Space> b(2,  5.0);
+    cusp::array1d<float, Space> x(2, -1.0);
+
+    cusp::relaxation::l1_jacobi<float, Space> relax(A);
+
+    ASSERT_EQUAL(relax.diagonal[0], 3.0f);
+    ASSERT_EQUAL(relax.diagonal[1], 4.0f);
+
+    relax(A, b, x);
+
+    ASSERT_ALMOST_EQUAL(x[0], 5.0f / 3.0f);  // -1 + (5 + 3) / 3
+    ASSERT_ALMOST_EQUAL(x[1], 1.25f);        // -1 + (5 + 4) / 4
+}
+DECLARE_SPARSE_MATRIX_UNITTEST(TestL1JacobiRelaxation);
+
+template <class Space>
+void TestL1JacobiSmoother(void)
+{
+    typedef cusp::relaxation::l1_jacobi<float,Space> Smoother;
+
+    cusp::coo_matrix<int,float,Space> A;
+    cusp::gallery::poisson5pt(A, 50, 50);
+
+    cusp::array1d<float,Space> b = unittest::random_samples<float>(A.num_rows);
+
+    // undamped sweeps reduce the residual
+    {
+        Smoother M(A);
+
+        cusp::array1d<float,Space> x(A.num_rows, 0.0f);
+        cusp::array1d<float,Space> r(A.num_rows);
+
+        float previous_residual = cusp::blas::nrm2(b);
+        for(int i = 0; i < 5; i++)
+        {
+            M(A, b, x);
+
+            cusp::multiply(A, x, r);
+            cusp::blas::axpby(b, r, r, 1.0f, -1.0f);
+            float residual = cusp::blas::nrm2(r);
+
+            ASSERT_EQUAL(residual < previous_residual, true);
+            previous_residual = residual;
+        }
+    }
+
+    {
+        cusp::precond::aggregation::smoothed_aggregation<int,float,Space,Smoother> M(A);
+        cusp::array1d<float,Space> x(A.num_rows, 0.0f);
+        cusp::default_monitor<float> monitor(b, 100, 1e-6);
+        cusp::krylov::cg(A, x, b, monitor, M);
+        ASSERT_EQUAL(monitor.converged(), true);
+    }
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestL1JacobiSmoother);
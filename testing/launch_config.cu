@@ -0,0 +1,125 @@
+#include <unittest/unittest.h>
+
+#include <cusp/csr_matrix.h>
+#include <cusp/ell_matrix.h>
+#include <cusp/multiply.h>
+#include <cusp/gallery/poisson.h>
+#include <cusp/gallery/random.h>
+
+#include <cusp/detail/device/launch_config.h>
+#include <cusp/detail/device/spmv/csr_vector.h>
+#include <cusp/detail/device/spmv/ell.h>
+
+namespace arch = cusp::detail::device::arch;
+
+template <typename DeviceMatrix, typename HostMatrix>
+void CompareTunedSpMV(const HostMatrix& A,
+                      void (*spmv)(const DeviceMatrix&, const typename HostMatrix::value_type*, typename HostMatrix::value_type*))
+{
+    typedef typename HostMatrix::value_type ValueType;
+
+    // integer values keep every sum exact, whatever the order of the partial sums
+    cusp::array1d<ValueType,cusp::host_memory> x(A.num_cols);
+    for(size_t i = 0; i < x.size(); i++)
+        x[i] = int(i % 7) - 3;
+
+    cusp::array1d<ValueType,cusp::host_memory> y(A.num_rows);
+    cusp::multiply(A, x, y);
+
+    DeviceMatrix d_A(A);
+    cusp::array1d<ValueType,cusp::device_memory> d_x(x);
+    cusp::array1d<ValueType,cusp::device_memory> d_y(A.num_rows, ValueType(10));
+
+    spmv(d_A, thrust::raw_pointer_cast(&d_x[0]), thrust::raw_pointer_cast(&d_y[0]));
+    ASSERT_EQUAL(d_y, y);
+}
+
+void TestLaunchConfigCsrVector(void)
+{
+    typedef cusp::csr_matrix<int,float,cusp::host_memory>   HostMatrix;
+    typedef cusp::csr_matrix<int,float,cusp::device_memory> DeviceMatrix;
+
+    HostMatrix A;
+    cusp::gallery::poisson5pt(A, 40, 30);
+
+    HostMatrix B;
+    cusp::gallery::random(500, 300, 8000, B);
+
+    const std::string& device_arch = arch::current_device_description().arch;
+    arch::launch_database& database = arch::current_launch_database();
+
+    const unsigned int block_sizes[]  = {64, 128, 256, 512};
+    const unsigned int vector_sizes[] = {2, 4, 8, 16, 32};
+
+    for(size_t b = 0; b < 4; b++)
+    {
+        for(size_t v = 0; v < 5; v++)
+        {
+            // every class of rows uses the configuration, with a small grid
+            database.clear();
+            for(unsigned int row_class = 2; row_class <= 32; row_class *= 2)
+                for(int use_cache = 0; use_cache < 2; use_cache++)
+                    database.set(device_arch, cusp::detail::device::csr_vector_launch_name(use_cache, row_class),
+                                 sizeof(float), arch::launch_config(block_sizes[b], vector_sizes[v], 1));
+
+            CompareTunedSpMV(A, cusp::detail::device::spmv_csr_vector    <DeviceMatrix, float>);
+            CompareTunedSpMV(A, cusp::detail::device::spmv_csr_vector_tex<DeviceMatrix, float>);
+            CompareTunedSpMV(B, cusp::detail::device::spmv_csr_vector    <DeviceMatrix, float>);
+            CompareTunedSpMV(B, cusp::detail::device::spmv_csr_vector_tex<DeviceMatrix, float>);
+        }
+    }
+
+    database.clear();
+}
+DECLARE_UNITTEST(TestLaunchConfigCsrVector);
+
+void TestLaunchConfigEll(void)
+{
+    typedef cusp::csr_matrix<int,float,cusp::host_memory>   HostMatrix;
+    typedef cusp::ell_matrix<int,float,cusp::device_memory> DeviceMatrix;
+
+    HostMatrix A;
+    cusp::gallery::poisson5pt(A, 40, 30);
+
+    const std::string& device_arch = arch::current_device_description().arch;
+    arch::launch_database& database = arch::current_launch_database();
+
+    const unsigned int block_sizes[] = {64, 128, 256, 512};
+
+    for(size_t b = 0; b < 4; b++)
+    {
+        database.clear();
+        database.set(device_arch, "ell",     sizeof(float), arch::launch_config(block_sizes[b], 0, 1));
+        database.set(device_arch, "ell_tex", sizeof(float), arch::launch_config(block_sizes[b], 0, 1));
+
+        CompareTunedSpMV(A, cusp::detail::device::spmv_ell    <DeviceMatrix, float>);
+        CompareTunedSpMV(A, cusp::detail::device::spmv_ell_tex<DeviceMatrix, float>);
+    }
+
+    database.clear();
+}
+DECLARE_UNITTEST(TestLaunchConfigEll);
+
+void TestLaunchDatabaseEntries(void)
+{
+    arch::launch_database database;
+    database.clear();
+
+    database.set("sm_80", "ell", 4, arch::launch_config(512, 0, 2));
+
+    // unsupported values fall back to the defaults
+    database.set("sm_80", "csr_vector/8", 4, arch::launch_config(96, 3, 0));
+
+    arch::launch_config ell = database.lookup("sm_80", "ell", 4);
+    ASSERT_EQUAL(ell.block_size,    512u);
+    ASSERT_EQUAL(ell.blocks_per_sm, 2u);
+
+    arch::launch_config csr = database.lookup("sm_80", "csr_vector/8", 4);
+    ASSERT_EQUAL(csr.block_size,         0u);
+    ASSERT_EQUAL(csr.threads_per_vector, 0u);
+
+    // other architectures and value sizes are separate entries
+    ASSERT_EQUAL(database.lookup("sm_70", "ell", 4).block_size, 0u);
+    ASSERT_EQUAL(database.lookup("sm_80", "ell", 8).block_size, 0u);
+}
+DECLARE_UNITTEST(TestLaunchDatabaseEntries);
@@ -0,0 +1,108 @@
+#include <unittest/unittest.h>
+
+#include <cusp/array2d.h>
+#include <cusp/csr_matrix.h>
+#include <cusp/multiply.h>
+#include <cusp/gallery/poisson.h>
+#include <cusp/krylov/lobpcg.h>
+#include <cusp/precond/diagonal.h>
+
+#include <algorithm>
+#include <cmath>
+
+// largest residual norm of the eigenpairs of A
+template <typename Matrix, typename Array1d, typename Array2d>
+double LobpcgResidual(const Matrix& A, const Array1d& lambda, const Array2d& X)
+{
+    cusp::csr_matrix<int, double, cusp::host_memory> A_host(A);
+    cusp::array2d<double, cusp::host_memory, cusp::column_major> X_host(X);
+
+    double residual = 0;
+
+    for (size_t j = 0; j < lambda.size(); j++)
+    {
+        cusp::array1d<double, cusp::host_memory> x(X_host.column(j).begin(), X_host.column(j).end());
+        cusp::array1d<double, cusp::host_memory> r(A_host.num_rows);
+
+        cusp::multiply(A_host, x, r);
+        cusp::blas::axpy(x, r, -lambda[j]);
+
+        residual = std::max(residual, double(cusp::blas::nrm2(r)));
+    }
+
+    return residual;
+}
+
+template <class MemorySpace>
+void TestLobpcg(void)
+{
+    const size_t N = 100;
+
+    // 1D Laplacian with diagonal 4
+    cusp::csr_matrix<int, double, MemorySpace> A;
+    cusp::gallery::poisson5pt(A, N, 1);
+
+    cusp::array1d<double, cusp::host_memory> lambda;
+    cusp::array2d<double, MemorySpace, cusp::column_major> X;
+
+    size_t converged = cusp::krylov::lobpcg(A, lambda, X, 4, 1e-8, 500);
+
+    ASSERT_EQUAL(converged, 4);
+    ASSERT_EQUAL(lambda.size(), 4);
+    ASSERT_EQUAL(X.num_rows, N);
+    ASSERT_EQUAL(X.num_cols, 4);
+
+    for (size_t i = 0; i < 4; i++)
+        ASSERT_EQUAL(std::abs(lambda[i] - (4.0 - 2.0 * std::cos((i + 1) * M_PI / (N + 1)))) < 1e-6, true);
+
+    ASSERT_EQUAL(LobpcgResidual(A, lambda, X) < 1e-6, true);
+
+    // the converged block as initial guess
+    converged = cusp::krylov::lobpcg(A, lambda, X, 4, 1e-6, 0);
+
+    ASSERT_EQUAL(converged, 4);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestLobpcg);
+
+template <class MemorySpace>
+void TestLobpcgPreconditioned(void)
+{
+    cusp::csr_matrix<int, double, MemorySpace> A;
+    cusp::gallery::poisson5pt(A, 12, 12);
+
+    cusp::precond::diagonal<double, MemorySpace> M(A);
+
+    cusp::array1d<double, cusp::host_memory> lambda;
+    cusp::array2d<double, MemorySpace, cusp::column_major> X;
+
+    size_t converged = cusp::krylov::lobpcg(A, lambda, X, 3, 1e-8, 500, M);
+
+    ASSERT_EQUAL(converged, 3);
+
+    // 4 - 2 cos(i pi / 13) - 2 cos(j pi / 13) for (1,1), (1,2) and (2,1)
+    const double h = M_PI / 13;
+    ASSERT_EQUAL(std::abs(lambda[0] - (4.0 - 4.0 * std::cos(h))) < 1e-6, true);
+    ASSERT_EQUAL(std::abs(lambda[1] - (4.0 - 2.0 * std::cos(h) - 2.0 * std::cos(2 * h))) < 1e-6, true);
+    ASSERT_EQUAL(std::abs(lambda[2] - (4.0 - 2.0 * std::cos(h) - 2.0 * std::cos(2 * h))) < 1e-6, true);
+
+    ASSERT_EQUAL(LobpcgResidual(A, lambda, X) < 1e-6, true);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestLobpcgPreconditioned);
+
+void TestLobpcgInvalidInput(void)
+{
+    cusp::csr_matrix<int, double, cusp::host_memory> A;
+    cusp::gallery::poisson5pt(A, 10, 1);
+
+    cusp::array1d<double, cusp::host_memory> lambda;
+    cusp::array2d<double, cusp::host_memory, cusp::column_major> X;
+
+    ASSERT_THROWS(cusp::krylov::lobpcg(A, lambda, X, 0), cusp::invalid_input_exception);
+    ASSERT_THROWS(cusp::krylov::lobpcg(A, lambda, X, 11), cusp::invalid_input_exception);
+
+    // rank deficient initial guess
+    X.resize(10, 2);
+    thrust::fill(X.values.begin(), X.values.end(), 1.0);
+    ASSERT_THROWS(cusp::krylov::lobpcg(A, lambda, X, 2), cusp::invalid_input_exception);
+}
+DECLARE_UNITTEST(TestLobpcgInvalidInput);
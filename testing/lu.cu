@@ -1,6 +1,8 @@
 #include <unittest/unittest.h>
 
 #include <cusp/detail/lu.h>
+#include <cusp/csr_matrix.h>
+#include <cusp/gallery/poisson.h>
 
 void TestLUFactorAndSolve(void)
 {
@@ -65,3 +67,108 @@ void TestLUSolver(void)
 }
 DECLARE_UNITTEST(TestLUSolver);
 
+
+template <class MemorySpace>
+void TestDenseInverseSolver(void)
+{
+    cusp::array2d<float, cusp::host_memory> A(4,4);
+    A(0,0) = 0.83228434;  A(0,1) = 0.41106598;  A(0,2) = 0.72609841;  A(0,3) = 0.80428486;
+    A(1,0) = 0.00890590;  A(1,1) = 0.29940800;  A(1,2) = 0.60630740;  A(1,3) = 0.33654542;
+    A(2,0) = 0.22525064;  A(2,1) = 0.93054253;  A(2,2) = 0.37939225;  A(2,3) = 0.16235888;
+    A(3,0) = 0.83911960;  A(3,1) = 0.21176293;  A(3,2) = 0.21010691;  A(3,3) = 0.52911885;
+    
+    cusp::array1d<float, MemorySpace> b(4);
+    b[0] = 1.31699541; 
+    b[1] = 0.87768331;
+    b[2] = 1.18994714;
+    b[3] = 0.61914723;
+
+    cusp::array1d<float, MemorySpace> x(4, 0.0f);
+
+    cusp::detail::dense_inverse_solver<float, MemorySpace> solver(A);
+    solver(b, x);
+
+    cusp::array1d<float, cusp::host_memory> h_x(x);
+
+    ASSERT_EQUAL(std::fabs(0.21713221 - h_x[0]) < 1e-4, true);
+    ASSERT_EQUAL(std::fabs(0.80528582 - h_x[1]) < 1e-4, true);
+    ASSERT_EQUAL(std::fabs(0.98416811 - h_x[2]) < 1e-4, true);
+    ASSERT_EQUAL(std::fabs(0.11271028 - h_x[3]) < 1e-4, true);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestDenseInverseSolver);
+
+template <typename Orientation>
+void _TestBlockedLUFactor(void)
+{
+    // larger than the block size so the trailing update is exercised
+    const int n = 150;
+
+    cusp::array2d<double, cusp::host_memory, Orientation> A(n,n);
+    for (int i = 0; i < n; i++)
+        for (int j = 0; j < n; j++)
+            A(i,j) = ((i * 37 + j * 101) % 97) / 97.0 + (i == j ? 1.0 : 0.0);
+
+    cusp::array2d<double, cusp::host_memory, Orientation> LU(A);
+    cusp::array1d<int, cusp::host_memory>    pivot(n);
+    cusp::array1d<double, cusp::host_memory> b(n);
+    cusp::array1d<double, cusp::host_memory> x(n);
+
+    for (int i = 0; i < n; i++)
+        b[i] = (i % 7) - 3.0;
+
+    ASSERT_EQUAL(cusp::detail::lu_factor(LU, pivot), 0);
+    cusp::detail::lu_solve(LU, pivot, b, x);
+
+    double residual = 0;
+    for (int i = 0; i < n; i++)
+    {
+        double sum = -b[i];
+        for (int j = 0; j < n; j++)
+            sum += A(i,j) * x[j];
+        residual = std::max(residual, std::fabs(sum));
+    }
+
+    ASSERT_EQUAL(residual < 1e-8, true);
+}
+
+void TestBlockedLUFactor(void)
+{
+    _TestBlockedLUFactor<cusp::row_major>();
+    _TestBlockedLUFactor<cusp::column_major>();
+}
+DECLARE_UNITTEST(TestBlockedLUFactor);
+
+void TestCholeskySolver(void)
+{
+    cusp::csr_matrix<int, double, cusp::host_memory> S;
+    cusp::gallery::poisson5pt(S, 10, 10);
+
+    cusp::array2d<double, cusp::host_memory> A(S);
+
+    const int n = A.num_rows;
+
+    cusp::array1d<double, cusp::host_memory> b(n, 1.0);
+    cusp::array1d<double, cusp::host_memory> x(n, 0.0);
+
+    cusp::detail::cholesky_solver<double, cusp::host_memory> solver(A);
+    solver(b, x);
+
+    double residual = 0;
+    for (int i = 0; i < n; i++)
+    {
+        double sum = -b[i];
+        for (int j = 0; j < n; j++)
+            sum += A(i,j) * x[j];
+        residual = std::max(residual, std::fabs(sum));
+    }
+
+    ASSERT_EQUAL(residual < 1e-10, true);
+
+    // indefinite matrices are rejected
+    cusp::array2d<double, cusp::host_memory> B(2,2);
+    B(0,0) = 1.0;  B(0,1) = 2.0;
+    B(1,0) = 2.0;  B(1,1) = 1.0;
+
+    ASSERT_THROWS((cusp::detail::cholesky_solver<double, cusp::host_memory>(B)), cusp::invalid_input_exception);
+}
+DECLARE_UNITTEST(TestCholeskySolver);
@@ -0,0 +1,108 @@
+#include <unittest/unittest.h>
+
+#include <cusp/managed_memory.h>
+#include <cusp/array1d.h>
+#include <cusp/blas.h>
+#include <cusp/coo_matrix.h>
+#include <cusp/csr_matrix.h>
+#include <cusp/hyb_matrix.h>
+#include <cusp/multiply.h>
+#include <cusp/gallery/poisson.h>
+#include <cusp/krylov/cg.h>
+
+void TestManagedMemoryArray(void)
+{
+    cusp::array1d<float, cusp::managed_memory> x(100, 1.0f);
+
+    // managed storage is addressable from the host
+    float * ptr = thrust::raw_pointer_cast(x.data());
+    for (size_t i = 0; i < x.size(); i++)
+        ptr[i] = float(i);
+
+    cusp::prefetch(x);
+
+    cusp::array1d<float, cusp::managed_memory> y(x);
+    cusp::blas::scal(y, 2.0f);
+
+    cusp::prefetch_to_host(y);
+
+    cusp::array1d<float, cusp::host_memory> y_h(y);
+    for (size_t i = 0; i < y_h.size(); i++)
+        ASSERT_EQUAL(y_h[i], 2.0f * i);
+
+    // empty containers and other spaces are ignored
+    cusp::array1d<float, cusp::managed_memory> empty;
+    cusp::prefetch(empty);
+    cusp::prefetch(y_h);
+    cusp::advise_read_mostly(y_h);
+}
+DECLARE_UNITTEST(TestManagedMemoryArray);
+
+template <typename ManagedMatrix>
+void CheckManagedMemoryMultiply(void)
+{
+    cusp::csr_matrix<int, float, cusp::host_memory> A_h;
+    cusp::gallery::poisson5pt(A_h, 10, 10);
+
+    ManagedMatrix A(A_h);
+    cusp::advise_read_mostly(A);
+
+    cusp::array1d<float, cusp::host_memory>    x_h(A.num_cols);
+    for (size_t i = 0; i < x_h.size(); i++)
+        x_h[i] = float(i % 7) - 3.0f;
+
+    cusp::array1d<float, cusp::managed_memory> x(x_h);
+    cusp::array1d<float, cusp::managed_memory> y(A.num_rows, 0.0f);
+    cusp::array1d<float, cusp::host_memory>    y_h(A.num_rows, 0.0f);
+
+    cusp::multiply(A, x, y);
+    cusp::multiply(A_h, x_h, y_h);
+
+    ASSERT_EQUAL((cusp::array1d<float, cusp::host_memory>(y)), y_h);
+
+    // the read-mostly advice does not prevent updates
+    cusp::advise_read_mostly(x);
+    cusp::blas::fill(x, 1.0f);
+    cusp::blas::fill(x_h, 1.0f);
+
+    cusp::multiply(A, x, y);
+    cusp::multiply(A_h, x_h, y_h);
+
+    ASSERT_EQUAL((cusp::array1d<float, cusp::host_memory>(y)), y_h);
+}
+
+void TestManagedMemoryMultiply(void)
+{
+    CheckManagedMemoryMultiply< cusp::coo_matrix<int, float, cusp::managed_memory> >();
+    CheckManagedMemoryMultiply< cusp::csr_matrix<int, float, cusp::managed_memory> >();
+    CheckManagedMemoryMultiply< cusp::hyb_matrix<int, float, cusp::managed_memory> >();
+}
+DECLARE_UNITTEST(TestManagedMemoryMultiply);
+
+void TestManagedMemoryConjugateGradient(void)
+{
+    cusp::csr_matrix<int, float, cusp::managed_memory> A;
+    cusp::gallery::poisson5pt(A, 10, 10);
+
+    cusp::array1d<float, cusp::managed_memory> x(A.num_rows, 0.0f);
+    cusp::array1d<float, cusp::managed_memory> b(A.num_rows, 1.0f);
+
+    cusp::advise_read_mostly(A);
+    cusp::prefetch(A);
+
+    cusp::default_monitor<float> monitor(b, 100, 1e-5f);
+    cusp::krylov::cg(A, x, b, monitor);
+
+    ASSERT_EQUAL(monitor.converged(), true);
+
+    // the residual of the managed solution, checked on the host
+    cusp::csr_matrix<int, float, cusp::host_memory> A_h(A);
+    cusp::array1d<float, cusp::host_memory> x_h(x);
+    cusp::array1d<float, cusp::host_memory> r_h(A.num_rows);
+
+    cusp::multiply(A_h, x_h, r_h);
+    cusp::blas::axpy(cusp::array1d<float, cusp::host_memory>(b), r_h, -1.0f);
+
+    ASSERT_EQUAL(cusp::blas::nrm2(r_h) < 1e-4f * cusp::blas::nrm2(cusp::array1d<float, cusp::host_memory>(b)), true);
+}
+DECLARE_UNITTEST(TestManagedMemoryConjugateGradient);
@@ -240,3 +240,320 @@ void TestWriteMatrixMarketFileCoordinateComplexGeneral(void)
 }
 DECLARE_HOST_DEVICE_UNITTEST(TestWriteMatrixMarketFileCoordinateComplexGeneral);
 
+
+void TestReadMatrixMarketStreamCoordinateParsing(void)
+{
+  // comments, blank lines, tabs and carriage returns between the entries
+  std::stringstream input;
+  input << "%%MatrixMarket matrix coordinate real symmetric\n";
+  input << "% comment\n";
+  input << "\n";
+  input << "4 4 5\n";
+  input << "1 1 1.5\n";
+  input << "2\t1\t-2.5e-1\r\n";
+  input << "% comment between entries\n";
+  input << "\n";
+  input << "3 3 3E1\n";
+  input << "  4 2 +1.25 \n";
+  input << "4 4 -.5\n";
+
+  cusp::coo_matrix<int, double, cusp::host_memory> coo;
+  cusp::io::read_matrix_market_stream(coo, input);
+
+  cusp::array2d<double, cusp::host_memory> D(coo);
+
+  cusp::array2d<double, cusp::host_memory> E(4, 4, 0.0);
+  E(0,0) =   1.5; E(0,1) = -0.25;
+  E(1,0) = -0.25;                  E(1,3) = 1.25;
+  E(2,2) =  30.0;
+  E(3,1) =  1.25;                  E(3,3) = -0.5;
+
+  ASSERT_EQUAL(coo.num_entries, 7);
+  ASSERT_EQUAL(D == E, true);
+}
+DECLARE_UNITTEST(TestReadMatrixMarketStreamCoordinateParsing);
+
+void TestReadMatrixMarketFileCoordinateLarge(void)
+{
+  // enough entries to be split across several threads
+  cusp::coo_matrix<int, double, cusp::host_memory> A(100, 400, 20000);
+  for(size_t n = 0; n < A.num_entries; n++)
+  {
+    A.row_indices[n]    = n / 200;
+    A.column_indices[n] = (n % 200) * 2;
+    A.values[n]         = (n % 2 ? -0.1 : 3.0e-7) * (n % 97);
+  }
+
+  cusp::io::write_matrix_market_file(A, random_file_name);
+
+  cusp::coo_matrix<int, double, cusp::host_memory> B;
+  cusp::io::read_matrix_market_file(B, random_file_name);
+
+  remove(random_file_name);
+
+  ASSERT_EQUAL(B.num_rows,    A.num_rows);
+  ASSERT_EQUAL(B.num_cols,    A.num_cols);
+  ASSERT_EQUAL(B.num_entries, A.num_entries);
+  ASSERT_EQUAL(B.row_indices,    A.row_indices);
+  ASSERT_EQUAL(B.column_indices, A.column_indices);
+  ASSERT_ALMOST_EQUAL(B.values,  A.values);
+}
+DECLARE_UNITTEST(TestReadMatrixMarketFileCoordinateLarge);
+
+void TestReadMatrixMarketStreamCoordinateErrors(void)
+{
+  cusp::coo_matrix<int, float, cusp::host_memory> coo;
+
+  {
+    std::stringstream input("%%MatrixMarket matrix coordinate real general\n2 2 2\n1 1 1.0\n");
+    ASSERT_THROWS(cusp::io::read_matrix_market_stream(coo, input), cusp::io_exception);
+  }
+  {
+    std::stringstream input("%%MatrixMarket matrix coordinate real general\n2 2 1\n3 1 1.0\n");
+    ASSERT_THROWS(cusp::io::read_matrix_market_stream(coo, input), cusp::io_exception);
+  }
+  {
+    std::stringstream input("%%MatrixMarket matrix coordinate real general\n2 2 1\n1 2 x\n");
+    ASSERT_THROWS(cusp::io::read_matrix_market_stream(coo, input), cusp::io_exception);
+  }
+}
+DECLARE_UNITTEST(TestReadMatrixMarketStreamCoordinateErrors);
+
+void write_text_file(const char * filename, const char * text)
+{
+  FILE * file = fopen(filename, "w");
+  fputs(text, file);
+  fclose(file);
+}
+
+void TestReadMatrixMarketFileCoordinateDevice(void)
+{
+  // the device parser matches the host parser, including the values
+  // which are converted on the host and the symmetric expansion
+  write_text_file(random_file_name,
+                  "%%MatrixMarket matrix coordinate real symmetric\n"
+                  "% comment\n"
+                  "\n"
+                  "4 4 6\n"
+                  "1 1 1.5\n"
+                  "2\t1\t-2.5e-1\r\n"
+                  "% comment between entries\n"
+                  "3 3 3E1\n"
+                  "  4 2 +1.25 \n"
+                  "4 3 0.12345678901234567890123\n"
+                  "4 4 1e300\n");
+
+  cusp::coo_matrix<int, double, cusp::host_memory> A;
+  cusp::io::read_matrix_market_file(A, random_file_name);
+
+  cusp::coo_matrix<int, double, cusp::device_memory> B;
+  cusp::io::read_matrix_market_file(B, random_file_name);
+
+  cusp::csr_matrix<int, double, cusp::device_memory> C;
+  cusp::io::read_matrix_market_file(C, random_file_name);
+
+  ASSERT_EQUAL(A.num_entries, 9);
+  ASSERT_EQUAL(B.num_rows,    A.num_rows);
+  ASSERT_EQUAL(B.num_cols,    A.num_cols);
+  ASSERT_EQUAL(B.num_entries, A.num_entries);
+  ASSERT_EQUAL(B.row_indices,    A.row_indices);
+  ASSERT_EQUAL(B.column_indices, A.column_indices);
+  ASSERT_EQUAL(B.values,         A.values);
+
+  cusp::coo_matrix<int, double, cusp::host_memory> D(C);
+  ASSERT_EQUAL(D.row_indices,    A.row_indices);
+  ASSERT_EQUAL(D.column_indices, A.column_indices);
+  ASSERT_EQUAL(D.values,         A.values);
+
+  // complex entries of a larger file
+  cusp::coo_matrix<int, cusp::complex<float>, cusp::host_memory> E(400, 200, 40000);
+  for(size_t n = 0; n < E.num_entries; n++)
+  {
+    E.row_indices[n]    = 2 * (n / 200) + (n % 3 == 0);
+    E.column_indices[n] = n % 200;
+    E.values[n]         = cusp::complex<float>(0.5f * (n % 13), -3.0e-5f * (n % 7));
+  }
+  E.sort_by_row_and_column();
+
+  cusp::io::write_matrix_market_file(E, random_file_name);
+
+  cusp::coo_matrix<int, cusp::complex<float>, cusp::host_memory> F;
+  cusp::io::read_matrix_market_file(F, random_file_name);
+
+  cusp::coo_matrix<int, cusp::complex<float>, cusp::device_memory> G;
+  cusp::io::read_matrix_market_file(G, random_file_name);
+
+  ASSERT_EQUAL(G.num_entries,    F.num_entries);
+  ASSERT_EQUAL(G.row_indices,    F.row_indices);
+  ASSERT_EQUAL(G.column_indices, F.column_indices);
+  ASSERT_EQUAL(G.values,         F.values);
+
+  // errors are reported as on the host
+  write_text_file(random_file_name, "%%MatrixMarket matrix coordinate real general\n2 2 2\n1 1 1.0\n");
+  ASSERT_THROWS(cusp::io::read_matrix_market_file(G, random_file_name), cusp::io_exception);
+
+  write_text_file(random_file_name, "%%MatrixMarket matrix coordinate real general\n2 2 2\n1 1 1.0\n1 3 1.0\n");
+  ASSERT_THROWS(cusp::io::read_matrix_market_file(G, random_file_name), cusp::io_exception);
+
+  write_text_file(random_file_name, "%%MatrixMarket matrix coordinate real general\n2 2 1\n1 2 x\n");
+  ASSERT_THROWS(cusp::io::read_matrix_market_file(G, random_file_name), cusp::io_exception);
+
+  remove(random_file_name);
+}
+DECLARE_UNITTEST(TestReadMatrixMarketFileCoordinateDevice);
+
+void TestWriteMatrixMarketStreamCoordinateFormatting(void)
+{
+  cusp::coo_matrix<int, float, cusp::host_memory> A(2, 3, 4);
+  A.row_indices[0] = 0; A.column_indices[0] = 0; A.values[0] =   1.5f;
+  A.row_indices[1] = 0; A.column_indices[1] = 2; A.values[1] =  -0.1f;
+  A.row_indices[2] = 1; A.column_indices[2] = 1; A.values[2] = 250.5f;
+  A.row_indices[3] = 1; A.column_indices[3] = 2; A.values[3] =  3e-7f;
+
+  std::stringstream output;
+  cusp::io::write_matrix_market_stream(A, output);
+
+  std::string expected;
+  expected += "%%MatrixMarket matrix coordinate real general\n";
+  expected += "\t2\t3\t4\n";
+  expected += "1 1 1.5\n";
+  expected += "1 3 -0.1\n";
+  expected += "2 2 250.5\n";
+  expected += "2 3 3e-07\n";
+
+  ASSERT_EQUAL(output.str(), expected);
+}
+DECLARE_UNITTEST(TestWriteMatrixMarketStreamCoordinateFormatting);
+
+void TestWriteMatrixMarketFileCoordinateExact(void)
+{
+  // enough entries to be formatted in several chunks
+  cusp::coo_matrix<int, double, cusp::host_memory> A(100, 400, 40000);
+  for(size_t n = 0; n < A.num_entries; n++)
+  {
+    A.row_indices[n]    = n / 400;
+    A.column_indices[n] = n % 400;
+    A.values[n]         = (n % 3 ? 1.0 : -1.0e-200) / (n + 1) + (n % 5) * 1.0e20;
+  }
+
+  cusp::io::write_matrix_market_file(A, random_file_name);
+
+  cusp::coo_matrix<int, double, cusp::host_memory> B;
+  cusp::io::read_matrix_market_file(B, random_file_name);
+
+  remove(random_file_name);
+
+  // the values are read back without any loss of precision
+  ASSERT_EQUAL(B.row_indices,    A.row_indices);
+  ASSERT_EQUAL(B.column_indices, A.column_indices);
+  ASSERT_EQUAL(B.values,         A.values);
+
+  cusp::coo_matrix<int, float, cusp::host_memory> C(A);
+
+  cusp::io::write_matrix_market_file(C, random_file_name);
+
+  cusp::coo_matrix<int, float, cusp::host_memory> D;
+  cusp::io::read_matrix_market_file(D, random_file_name);
+
+  remove(random_file_name);
+
+  ASSERT_EQUAL(D.values, C.values);
+}
+DECLARE_UNITTEST(TestWriteMatrixMarketFileCoordinateExact);
+
+void TestWriteMatrixMarketFileCompressed(void)
+{
+  const char compressed_file_name[] = "test_93298409283221.mtx.gz";
+
+  cusp::coo_matrix<int, float, cusp::host_memory> A(2, 2, 1);
+  A.row_indices[0] = 1; A.column_indices[0] = 0; A.values[0] = 2.0f;
+
+#ifdef __CUSP_USE_ZLIB__
+  cusp::io::write_matrix_market_file(A, compressed_file_name);
+
+  FILE * file = fopen(compressed_file_name, "rb");
+  ASSERT_EQUAL(file != NULL, true);
+
+  // gzip magic number
+  unsigned char magic[2] = {0, 0};
+  ASSERT_EQUAL(fread(magic, 1, 2, file), 2);
+  fclose(file);
+
+  remove(compressed_file_name);
+
+  ASSERT_EQUAL(magic[0], 0x1f);
+  ASSERT_EQUAL(magic[1], 0x8b);
+#else
+  ASSERT_THROWS(cusp::io::write_matrix_market_file(A, compressed_file_name), cusp::not_implemented_exception);
+#endif
+}
+DECLARE_UNITTEST(TestWriteMatrixMarketFileCompressed);
+
+template <class MemorySpace>
+void TestReadWriteMatrixMarketFileCompressed(void)
+{
+  const char * compressed_file_names[] = {"test_93298409283221.mtx.gz", "test_93298409283221.mtx.zst"};
+
+  // large enough to span several compressed blocks
+  const int N = 600000;
+
+  cusp::coo_matrix<int, double, cusp::host_memory> A(N, N, N);
+  for (int i = 0; i < N; i++)
+  {
+    A.row_indices[i]    = i;
+    A.column_indices[i] = (7 * i) % N;
+    A.values[i]         = 1.0 / (i + 1);
+  }
+
+  for (int i = 0; i < 2; i++)
+  {
+#ifndef __CUSP_USE_ZLIB__
+    if (i == 0) continue;
+#endif
+#ifndef __CUSP_USE_ZSTD__
+    if (i == 1) continue;
+#endif
+
+    cusp::io::write_matrix_market_file(A, compressed_file_names[i]);
+
+    cusp::coo_matrix<int, double, MemorySpace> B;
+    cusp::io::read_matrix_market_file(B, compressed_file_names[i]);
+
+    remove(compressed_file_names[i]);
+
+    ASSERT_EQUAL(B.num_rows,    A.num_rows);
+    ASSERT_EQUAL(B.num_entries, A.num_entries);
+    ASSERT_EQUAL(B.row_indices,    A.row_indices);
+    ASSERT_EQUAL(B.column_indices, A.column_indices);
+    ASSERT_EQUAL(B.values,         A.values);
+  }
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestReadWriteMatrixMarketFileCompressed);
+
+#ifdef __CUSP_USE_ZLIB__
+void TestReadMatrixMarketFileGzipStream(void)
+{
+  // files compressed by other tools are decompressed serially, including
+  // concatenated gzip members
+  const char compressed_file_name[] = "test_93298409283221.mtx.gz";
+
+  gzFile file = gzopen(compressed_file_name, "wb");
+  gzputs(file, "%%MatrixMarket matrix coordinate real general\n3 3 2\n");
+  gzclose(file);
+
+  file = gzopen(compressed_file_name, "ab");
+  gzputs(file, "1 2 1.5\n3 1 -2.0\n");
+  gzclose(file);
+
+  cusp::coo_matrix<int, float, cusp::host_memory> A;
+  cusp::io::read_matrix_market_file(A, compressed_file_name);
+
+  remove(compressed_file_name);
+
+  ASSERT_EQUAL(A.num_rows,    3);
+  ASSERT_EQUAL(A.num_entries, 2);
+  ASSERT_EQUAL(A.row_indices[0], 0);  ASSERT_EQUAL(A.column_indices[0], 1);  ASSERT_EQUAL(A.values[0],  1.5f);
+  ASSERT_EQUAL(A.row_indices[1], 2);  ASSERT_EQUAL(A.column_indices[1], 0);  ASSERT_EQUAL(A.values[1], -2.0f);
+}
+DECLARE_UNITTEST(TestReadMatrixMarketFileGzipStream);
+#endif
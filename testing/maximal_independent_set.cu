@@ -153,3 +153,26 @@ void TestMaximalIndependentSet(void)
 }
 DECLARE_SPARSE_MATRIX_UNITTEST(TestMaximalIndependentSet);
 
+
+template <typename MemorySpace>
+void TestMaximalIndependentSetDistanceThree(void)
+{
+    // MIS(3) takes three rings per round, and the rounds after the first
+    // only visit the rows around the undecided vertices
+    cusp::coo_matrix<int,float,MemorySpace> A;
+    cusp::gallery::poisson5pt(A, 41, 37);
+    thrust::fill(A.values.begin(), A.values.end(), 1.0f);
+
+    cusp::array1d<int, MemorySpace> stencil(A.num_rows);
+
+    size_t num_nodes = cusp::graph::maximal_independent_set(A, stencil, 3);
+
+    cusp::coo_matrix<int,float,MemorySpace> A2;
+    cusp::coo_matrix<int,float,MemorySpace> A3;
+    cusp::multiply(A, A, A2);
+    cusp::multiply(A2, A, A3);
+
+    ASSERT_EQUAL(is_valid_mis(A3, stencil), true);
+    ASSERT_EQUAL(thrust::count(stencil.begin(), stencil.end(), 1), num_nodes);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestMaximalIndependentSetDistanceThree);
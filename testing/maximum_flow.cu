@@ -0,0 +1,183 @@
+#include <unittest/unittest.h>
+
+#include <cusp/graph/maximum_flow.h>
+
+#include <cusp/coo_matrix.h>
+#include <cusp/csr_matrix.h>
+#include <cusp/gallery/grid.h>
+
+#include <cstdlib>
+#include <vector>
+
+// network of Cormen et al., Fig. 26.1, whose maximum flow is 23, with the
+// entry (j,i) of zero capacity added for each edge (i,j) when symmetric
+void clrs_network(cusp::csr_matrix<int,int,cusp::host_memory>& G, const bool symmetric)
+{
+    const int edges[9][3] = {{0, 1, 16}, {0, 2, 13}, {1, 3, 12}, {2, 1, 4}, {2, 4, 14},
+                             {3, 2, 9},  {3, 5, 20}, {4, 3, 7},  {4, 5, 4}};
+
+    cusp::coo_matrix<int,int,cusp::host_memory> A(6, 6, symmetric ? 16 : 9);
+
+    int n = 0;
+    for (int e = 0; e < 9; e++)
+    {
+        A.row_indices[n] = edges[e][0];
+        A.column_indices[n] = edges[e][1];
+        A.values[n++] = edges[e][2];
+    }
+
+    // (1,2) and (2,1) are both edges
+    if (symmetric)
+    {
+        for (int e = 0; e < 9; e++)
+        {
+            if (edges[e][0] == 2 && edges[e][1] == 1)
+                continue;
+
+            A.row_indices[n] = edges[e][1];
+            A.column_indices[n] = edges[e][0];
+            A.values[n++] = 0;
+        }
+    }
+
+    A.sort_by_row_and_column();
+    G = A;
+}
+
+// 0 <= flow <= capacity on every edge, no vertex but the source sends more
+// than it receives, and the sink receives value
+void check_preflow(const cusp::csr_matrix<int,int,cusp::host_memory>& G,
+                   const cusp::array1d<int,cusp::host_memory>& flow,
+                   const int src, const int sink, const int value, const bool complete)
+{
+    std::vector<int> net_inflow(G.num_rows, 0);
+
+    for (int i = 0; i < int(G.num_rows); i++)
+    {
+        for (int jj = G.row_offsets[i]; jj < G.row_offsets[i + 1]; jj++)
+        {
+            ASSERT_EQUAL(flow[jj] >= 0, true);
+            ASSERT_EQUAL(flow[jj] <= G.values[jj], true);
+
+            net_inflow[i] -= flow[jj];
+            net_inflow[G.column_indices[jj]] += flow[jj];
+        }
+    }
+
+    for (int i = 0; i < int(G.num_rows); i++)
+    {
+        if (i == src || i == sink)
+            continue;
+
+        if (complete)
+            ASSERT_EQUAL(net_inflow[i], 0);
+        else
+            ASSERT_EQUAL(net_inflow[i] >= 0, true);
+    }
+
+    ASSERT_EQUAL(net_inflow[sink], value);
+}
+
+int cut_capacity(const cusp::csr_matrix<int,int,cusp::host_memory>& G,
+                 const cusp::array1d<int,cusp::host_memory>& cut)
+{
+    int capacity = 0;
+
+    for (size_t n = 0; n < G.num_entries; n++)
+        if (cut[n])
+            capacity += G.values[n];
+
+    return capacity;
+}
+
+template <typename MemorySpace>
+void CheckMaximumFlow(const cusp::csr_matrix<int,int,cusp::host_memory>& G,
+                      const int src, const int sink, const int expected)
+{
+    cusp::csr_matrix<int,int,MemorySpace> G_d(G);
+
+    // complete flow
+    {
+        cusp::array1d<int,MemorySpace> flow(G.num_entries);
+        cusp::array1d<int,MemorySpace> cut(G.num_entries);
+
+        const int value = cusp::graph::maximum_flow(G_d, flow, src, sink);
+        ASSERT_EQUAL(value, expected);
+
+        check_preflow(G, cusp::array1d<int,cusp::host_memory>(flow), src, sink, value, true);
+
+        cusp::graph::max_flow_to_min_cut(G_d, flow, src, sink, cut);
+        ASSERT_EQUAL(cut_capacity(G, cusp::array1d<int,cusp::host_memory>(cut)), expected);
+    }
+
+    // the preflow gives the same value and cut
+    {
+        cusp::array1d<int,MemorySpace> flow(G.num_entries);
+        cusp::array1d<int,MemorySpace> cut(G.num_entries);
+
+        const int value = cusp::graph::maximum_preflow(G_d, flow, src, sink);
+        ASSERT_EQUAL(value, expected);
+
+        check_preflow(G, cusp::array1d<int,cusp::host_memory>(flow), src, sink, value, false);
+
+        cusp::graph::max_flow_to_min_cut(G_d, flow, src, sink, cut);
+        ASSERT_EQUAL(cut_capacity(G, cusp::array1d<int,cusp::host_memory>(cut)), expected);
+    }
+}
+
+template <class MemorySpace>
+void TestMaximumFlowSmall(void)
+{
+    cusp::csr_matrix<int,int,cusp::host_memory> G;
+    clrs_network(G, true);
+
+    CheckMaximumFlow<MemorySpace>(G, 0, 5, 23);
+
+    // the cut nearest the sink is {(1,3), (4,3), (4,5)}
+    cusp::csr_matrix<int,int,MemorySpace> G_d(G);
+    cusp::array1d<int,MemorySpace> flow(G.num_entries);
+    cusp::array1d<int,MemorySpace> cut(G.num_entries);
+
+    cusp::graph::maximum_preflow(G_d, flow, 0, 5);
+    ASSERT_EQUAL(cusp::graph::max_flow_to_min_cut(G_d, flow, 0, 5, cut), size_t(3));
+
+    // no path from the source
+    ASSERT_EQUAL(cusp::graph::maximum_flow(G_d, 5, 0), 0);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestMaximumFlowSmall);
+
+template <class MemorySpace>
+void TestMaximumFlowGrid(void)
+{
+    cusp::csr_matrix<int,int,cusp::host_memory> G;
+    cusp::gallery::grid2d(G, 30, 20);
+
+    srand(13);
+    for (size_t n = 0; n < G.num_entries; n++)
+        G.values[n] = rand() % 20 + 1;
+
+    // maximum flow of the host solver, as the reference for both
+    cusp::array1d<int,cusp::host_memory> flow(G.num_entries);
+    const int expected = cusp::graph::maximum_flow(G, flow, 0, int(G.num_rows) - 1);
+
+    ASSERT_EQUAL(expected > 0, true);
+
+    CheckMaximumFlow<MemorySpace>(G, 0, G.num_rows - 1, expected);
+    CheckMaximumFlow<MemorySpace>(G, 17, 311, cusp::graph::maximum_flow(G, flow, 17, 311));
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestMaximumFlowGrid);
+
+void TestMaximumFlowDeviceUnsymmetric(void)
+{
+    // the device solver adds the reverse residual edges itself
+    cusp::csr_matrix<int,int,cusp::host_memory> G;
+    clrs_network(G, false);
+
+    CheckMaximumFlow<cusp::device_memory>(G, 0, 5, 23);
+
+    cusp::csr_matrix<int,int,cusp::device_memory> G_d(G);
+    cusp::array1d<int,cusp::device_memory> flow(G.num_entries);
+
+    ASSERT_THROWS(cusp::graph::maximum_flow(G_d, flow, 2, 2), cusp::invalid_input_exception);
+}
+DECLARE_UNITTEST(TestMaximumFlowDeviceUnsymmetric);
@@ -30,6 +30,15 @@ void TestMinimumSpace(void)
   ASSERT_EQUAL(((bool) thrust::detail::is_same<cusp::minimum_space<D,D,D>::type, D>::value), true);
   ASSERT_EQUAL(((bool) thrust::detail::is_same<cusp::minimum_space<D,A,D>::type, D>::value), true);
   ASSERT_EQUAL(((bool) thrust::detail::is_same<cusp::minimum_space<A,D,D>::type, D>::value), true);
+
+  // managed arrays meet device arrays in device memory
+  typedef cusp::managed_memory M;
+
+  ASSERT_EQUAL(((bool) thrust::detail::is_same<cusp::minimum_space<M,M>::type, M>::value), true);
+  ASSERT_EQUAL(((bool) thrust::detail::is_same<cusp::minimum_space<M,A>::type, M>::value), true);
+  ASSERT_EQUAL(((bool) thrust::detail::is_same<cusp::minimum_space<M,D>::type, D>::value), true);
+  ASSERT_EQUAL(((bool) thrust::detail::is_same<cusp::minimum_space<D,M>::type, D>::value), true);
+  ASSERT_EQUAL(((bool) thrust::detail::is_same<cusp::minimum_space<D,M,A>::type, D>::value), true);
 }
 DECLARE_UNITTEST(TestMinimumSpace);
 
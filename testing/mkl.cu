@@ -0,0 +1,142 @@
+#include <unittest/unittest.h>
+
+#ifdef INTEL_MKL_SPBLAS
+
+#include <cusp/mkl.h>
+#include <cusp/multiply.h>
+#include <cusp/verify.h>
+#include <cusp/gallery/poisson.h>
+#include <cusp/gallery/random.h>
+
+// y = A * x with the dense reference
+template <typename Matrix, typename ValueType>
+void CompareMklSpMV(const Matrix& A)
+{
+    cusp::array2d<ValueType, cusp::host_memory> D(A);
+
+    cusp::array1d<ValueType, cusp::host_memory> x(A.num_cols);
+    for(size_t i = 0; i < x.size(); i++)
+        x[i] = int(i % 7) - 3;
+
+    cusp::array1d<ValueType, cusp::host_memory> y(A.num_rows, ValueType(10));
+    cusp::array1d<ValueType, cusp::host_memory> z(A.num_rows, ValueType(10));
+
+    cusp::multiply(D, x, y);
+    cusp::multiply(A, x, z);
+
+    ASSERT_EQUAL(z, y);
+}
+
+template <typename ValueType>
+void CompareMklMatrixVectorMultiply(void)
+{
+    cusp::csr_matrix<int, ValueType, cusp::host_memory> A;
+    cusp::gallery::poisson5pt(A, 13, 17);
+
+    CompareMklSpMV<cusp::csr_matrix<int,  ValueType, cusp::host_memory>, ValueType>(A);
+    CompareMklSpMV<cusp::csr_matrix<long, ValueType, cusp::host_memory>, ValueType>(A);
+    CompareMklSpMV<cusp::coo_matrix<int,  ValueType, cusp::host_memory>, ValueType>(A);
+
+    // rectangular
+    cusp::csr_matrix<int, ValueType, cusp::host_memory> B;
+    cusp::gallery::random(300, 200, 2000, B);
+
+    CompareMklSpMV<cusp::csr_matrix<int, ValueType, cusp::host_memory>, ValueType>(B);
+    CompareMklSpMV<cusp::coo_matrix<int, ValueType, cusp::host_memory>, ValueType>(B);
+
+    // empty matrix
+    cusp::csr_matrix<int, ValueType, cusp::host_memory> C(10, 10, 0);
+    thrust::fill(C.row_offsets.begin(), C.row_offsets.end(), 0);
+
+    CompareMklSpMV<cusp::csr_matrix<int, ValueType, cusp::host_memory>, ValueType>(C);
+}
+
+void TestMklMatrixVectorMultiply(void)
+{
+    CompareMklMatrixVectorMultiply<float>();
+    CompareMklMatrixVectorMultiply<double>();
+}
+DECLARE_UNITTEST(TestMklMatrixVectorMultiply);
+
+template <typename Orientation>
+void CompareMklSpMM(const cusp::csr_matrix<int, double, cusp::host_memory>& A)
+{
+    cusp::array2d<double, cusp::host_memory> D(A);
+
+    cusp::array2d<double, cusp::host_memory, Orientation> X(A.num_cols, 3);
+    for(size_t i = 0; i < X.num_rows; i++)
+        for(size_t j = 0; j < X.num_cols; j++)
+            X(i,j) = int((i + 2 * j) % 7) - 3;
+
+    cusp::array2d<double, cusp::host_memory, Orientation> Y(A.num_rows, 3, 10.0);
+    cusp::array2d<double, cusp::host_memory, Orientation> Z(A.num_rows, 3, 10.0);
+
+    for(size_t j = 0; j < X.num_cols; j++)
+        cusp::multiply(D, X.column(j), Y.column(j));
+
+    cusp::multiply(A, X, Z);
+
+    ASSERT_EQUAL(Z.values, Y.values);
+}
+
+void TestMklMatrixMatrixMultiply(void)
+{
+    cusp::csr_matrix<int, double, cusp::host_memory> A;
+    cusp::gallery::random(60, 40, 300, A);
+
+    CompareMklSpMM<cusp::row_major>(A);
+    CompareMklSpMM<cusp::column_major>(A);
+
+    // SpGEMM
+    cusp::csr_matrix<int, double, cusp::host_memory> B;
+    cusp::gallery::random(40, 50, 200, B);
+
+    cusp::csr_matrix<int, double, cusp::host_memory> C;
+    cusp::multiply(A, B, C);
+
+    ASSERT_EQUAL(cusp::is_valid_matrix(C), true);
+
+    cusp::array2d<double, cusp::host_memory> A_dense(A);
+    cusp::array2d<double, cusp::host_memory> B_dense(B);
+    cusp::array2d<double, cusp::host_memory> C_dense;
+    cusp::multiply(A_dense, B_dense, C_dense);
+
+    ASSERT_EQUAL_QUIET(C_dense, (cusp::array2d<double, cusp::host_memory>(C)));
+}
+DECLARE_UNITTEST(TestMklMatrixMatrixMultiply);
+
+void TestMklSpMVOperator(void)
+{
+    cusp::csr_matrix<int, double, cusp::host_memory> A;
+    cusp::gallery::poisson5pt(A, 20, 30);
+
+    cusp::mkl_spmv<int, double> M(A, 10);
+
+    ASSERT_EQUAL(M.num_rows, A.num_rows);
+    ASSERT_EQUAL(M.num_cols, A.num_cols);
+
+    cusp::array1d<double, cusp::host_memory> x(A.num_cols);
+    for(size_t i = 0; i < x.size(); i++)
+        x[i] = int(i % 7) - 3;
+
+    cusp::array1d<double, cusp::host_memory> y(A.num_rows);
+    cusp::multiply(A, x, y);
+
+    cusp::array1d<double, cusp::host_memory> z(A.num_rows, 10.0);
+    cusp::multiply(M, x, z);
+
+    ASSERT_EQUAL(z, y);
+
+    // vectors in device memory are staged through the host
+    cusp::array1d<double, cusp::device_memory> d_x(x);
+    cusp::array1d<double, cusp::device_memory> d_z(A.num_rows, 10.0);
+    M(d_x, d_z);
+
+    ASSERT_EQUAL(d_z, y);
+
+    cusp::array1d<double, cusp::host_memory> w(A.num_rows + 1);
+    ASSERT_THROWS(M(x, w), cusp::invalid_input_exception);
+}
+DECLARE_UNITTEST(TestMklSpMVOperator);
+
+#endif // INTEL_MKL_SPBLAS
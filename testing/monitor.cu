@@ -1,6 +1,9 @@
 #include <unittest/unittest.h>
 
 #include <cusp/monitor.h>
+#include <cusp/eisenstat_walker_monitor.h>
+
+#include <cmath>
 
 template <typename MemorySpace>
 void TestMonitorSimple(void)
@@ -61,3 +64,165 @@ void TestMonitorSimple(void)
 }
 DECLARE_HOST_DEVICE_UNITTEST(TestMonitorSimple);
 
+template <typename MemorySpace>
+void TestIntervalMonitor(void)
+{
+    cusp::array1d<float,MemorySpace> b(2);
+    b[0] = 10;
+    b[1] =  0;
+
+    cusp::array1d<float,MemorySpace> r(2);
+    r[0] = 10;
+    r[1] =  0;
+
+    cusp::interval_monitor<float> monitor(b, 10, 0.5, 1.0, 3);
+
+    ASSERT_EQUAL(monitor.check_interval(), 3);
+    ASSERT_EQUAL(monitor.is_check_iteration(), true);
+    ASSERT_EQUAL(monitor.finished(r), false);
+    ASSERT_EQUAL(monitor.residual_norm(), 10.0);
+
+    r[0] = 2;
+    ++monitor;
+
+    // residuals in device memory are only tested every third iteration
+    bool on_host = thrust::detail::is_convertible<MemorySpace, cusp::host_memory>::value;
+
+    ASSERT_EQUAL(monitor.is_check_iteration(), false);
+    ASSERT_EQUAL(monitor.finished(r), on_host);
+    ASSERT_EQUAL(monitor.residual_norm(), on_host ? 2.0 : 10.0);
+
+    // norms computed by the solver are always tested
+    ASSERT_EQUAL(monitor.finished(7.0f), false);
+    ASSERT_EQUAL(monitor.residual_norm(), 7.0);
+
+    ++monitor;
+
+    ASSERT_EQUAL(monitor.finished(r), on_host);
+    ASSERT_EQUAL(monitor.residual_norm(), on_host ? 2.0 : 7.0);
+
+    ++monitor;
+
+    ASSERT_EQUAL(monitor.is_check_iteration(), true);
+    ASSERT_EQUAL(monitor.finished(r), true);
+    ASSERT_EQUAL(monitor.residual_norm(), 2.0);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestIntervalMonitor);
+
+template <typename MemorySpace>
+void TestIntervalMonitorSquaredNorm(void)
+{
+    cusp::array1d<float,MemorySpace> b(2, 1.0f);
+
+    cusp::interval_monitor<float> monitor(b, 4, 0.0, 1.0, 2);
+
+    // squared residual norm kept by the solver
+    cusp::array1d<float,MemorySpace> rr(1, 16.0f);
+
+    ASSERT_EQUAL(monitor.finished_squared_norm(rr), false);
+    ASSERT_EQUAL(monitor.residual_norm(), 4.0);
+
+    rr[0] = 0.25f;
+    ++monitor;
+
+    ASSERT_EQUAL(monitor.finished_squared_norm(rr), false);
+    ASSERT_EQUAL(monitor.residual_norm(), 4.0);
+
+    ++monitor;
+
+    ASSERT_EQUAL(monitor.finished_squared_norm(rr), true);
+    ASSERT_EQUAL(monitor.residual_norm(), 0.5);
+
+    // the iteration limit is always tested
+    rr[0] = 16.0f;
+    ++monitor;
+    ++monitor;
+
+    ASSERT_EQUAL(monitor.finished_squared_norm(rr), true);
+    ASSERT_EQUAL(monitor.converged(), false);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestIntervalMonitorSquaredNorm);
+
+template <typename MemorySpace>
+void TestMonitorReset(void)
+{
+    cusp::array1d<float,MemorySpace> b(2);
+    b[0] = 3;
+    b[1] = 4;
+
+    cusp::default_monitor<float> monitor(b, 5, 0.5, 1.0);
+
+    ++monitor;
+    ASSERT_EQUAL(monitor.finished(2.0f), true);
+
+    // a precomputed norm of the next right-hand-side
+    monitor.reset(10.0f);
+
+    ASSERT_EQUAL(monitor.iteration_count(), 0);
+    ASSERT_EQUAL(monitor.tolerance(), 6.0);
+    ASSERT_EQUAL(monitor.converged(), false);
+
+    monitor.reset(b);
+
+    ASSERT_EQUAL(monitor.tolerance(), 3.5);
+    ASSERT_EQUAL(monitor.iteration_limit(), 5);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestMonitorReset);
+
+void TestEisenstatWalkerMonitor(void)
+{
+    cusp::eisenstat_walker_monitor<float> monitor(10, 0.9, cusp::eisenstat_walker_2);
+
+    // the first step uses the largest forcing term
+    monitor.next_step(10.0f);
+
+    ASSERT_ALMOST_EQUAL(monitor.forcing_term(), 0.9f);
+    ASSERT_ALMOST_EQUAL(monitor.tolerance(), 9.0f);
+    ASSERT_EQUAL(monitor.step_count(), 1);
+
+    ++monitor;
+    ++monitor;
+    ASSERT_EQUAL(monitor.finished(5.0f), true);
+
+    // 0.9 (1/10)^2 is raised to 0.9 * 0.9^2 by the safeguard
+    monitor.next_step(1.0f);
+
+    ASSERT_ALMOST_EQUAL(monitor.forcing_term(), 0.729f);
+    ASSERT_ALMOST_EQUAL(monitor.tolerance(), 0.729f);
+    ASSERT_EQUAL(monitor.iteration_count(), 0);
+    ASSERT_EQUAL(monitor.total_iteration_count(), 2);
+
+    monitor.next_step(0.01f);
+    ASSERT_ALMOST_EQUAL(monitor.forcing_term(), 0.9f * 0.729f * 0.729f);
+
+    monitor.next_step(0.0001f);
+    monitor.next_step(0.000001f);
+
+    // the safeguard no longer applies below 0.1
+    ASSERT_ALMOST_EQUAL(monitor.forcing_term(), 0.9e-4f);
+
+    // bounded when the nonlinear residual grows
+    monitor.next_step(1.0f);
+    ASSERT_ALMOST_EQUAL(monitor.forcing_term(), 0.9f);
+}
+DECLARE_UNITTEST(TestEisenstatWalkerMonitor);
+
+void TestEisenstatWalkerMonitorChoice1(void)
+{
+    cusp::eisenstat_walker_monitor<float> monitor(10, 0.9, cusp::eisenstat_walker_1);
+
+    monitor.next_step(10.0f);
+    ASSERT_EQUAL(monitor.finished(2.0f), true);
+
+    // |4 - 2| / 10 is raised to 0.9^((1 + sqrt(5)) / 2)
+    monitor.next_step(4.0f);
+    ASSERT_ALMOST_EQUAL(monitor.forcing_term(), std::pow(0.9f, 1.618034f));
+
+    // no solve beyond half the nonlinear tolerance
+    cusp::eisenstat_walker_monitor<float> bounded(10, 0.5, cusp::eisenstat_walker_2, 0.01f);
+
+    bounded.next_step(1.0f);
+    bounded.next_step(0.01f);
+    ASSERT_ALMOST_EQUAL(bounded.forcing_term(), 0.5f);
+}
+DECLARE_UNITTEST(TestEisenstatWalkerMonitorChoice1);
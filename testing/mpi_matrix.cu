@@ -0,0 +1,211 @@
+#include <unittest/unittest.h>
+
+// the MPI containers are only built with MPI support; run the tests with
+// mpirun to exercise the halo exchange between several processes
+#ifdef __CUSP_USE_MPI__
+
+#include <cusp/mpi_matrix.h>
+#include <cusp/csr_matrix.h>
+#include <cusp/hyb_matrix.h>
+#include <cusp/multiply.h>
+#include <cusp/monitor.h>
+#include <cusp/krylov/cg.h>
+#include <cusp/krylov/pipelined_cg.h>
+#include <cusp/precond/aggregation/mpi_smoothed_aggregation.h>
+#include <cusp/gallery/poisson.h>
+
+#include <cstdlib>
+
+void finalize_mpi(void)
+{
+    int finalized = 0;
+    MPI_Finalized(&finalized);
+
+    if (!finalized)
+        MPI_Finalize();
+}
+
+// initializes MPI on first use, so that the tests also run as a single process
+MPI_Comm test_communicator(void)
+{
+    int initialized = 0;
+    MPI_Initialized(&initialized);
+
+    if (!initialized)
+    {
+        MPI_Init(NULL, NULL);
+        atexit(finalize_mpi);
+    }
+
+    MPI_Comm_set_errhandler(MPI_COMM_WORLD, MPI_ERRORS_RETURN);
+
+    return MPI_COMM_WORLD;
+}
+
+// rows of A owned by this process, with global columns
+template <typename MatrixType>
+void local_rows(const MatrixType& A, const cusp::mpi_layout& layout, MatrixType& B)
+{
+    const size_t first = layout.first_row();
+    const size_t last  = first + layout.local_size();
+
+    B.resize(last - first, A.num_cols, A.row_offsets[last] - A.row_offsets[first]);
+
+    for (size_t i = first; i <= last; i++)
+        B.row_offsets[i - first] = A.row_offsets[i] - A.row_offsets[first];
+
+    for (int jj = A.row_offsets[first]; jj < A.row_offsets[last]; jj++)
+    {
+        B.column_indices[jj - A.row_offsets[first]] = A.column_indices[jj];
+        B.values[jj - A.row_offsets[first]]         = A.values[jj];
+    }
+}
+
+void TestMPILayout(void)
+{
+    MPI_Comm comm = test_communicator();
+
+    int num_ranks = 0;
+    MPI_Comm_size(comm, &num_ranks);
+
+    cusp::mpi_layout uniform = cusp::mpi_uniform_layout(comm, 100);
+
+    ASSERT_EQUAL(uniform.num_ranks(), size_t(num_ranks));
+    ASSERT_EQUAL(uniform.size(), 100);
+    ASSERT_EQUAL(uniform.owner(0), 0);
+    ASSERT_EQUAL(uniform.owner(99), num_ranks - 1);
+
+    // the layout collected from the local sizes is identical
+    cusp::mpi_layout collected(comm, uniform.local_size());
+    ASSERT_EQUAL(collected == uniform, true);
+
+    cusp::mpi_array1d<float> x(uniform, 2.0f);
+    cusp::mpi_array1d<float> y(uniform, 3.0f);
+
+    ASSERT_EQUAL(x.local_size(), uniform.local_size());
+    ASSERT_ALMOST_EQUAL(cusp::blas::dot(x, y), 600.0f);
+    ASSERT_ALMOST_EQUAL(cusp::blas::nrm2(x), 20.0f);
+
+    cusp::blas::axpby(x, y, y, 1.0f, -1.0f);
+
+    cusp::array1d<float,cusp::host_memory> y_host;
+    y.gather(y_host);
+
+    ASSERT_EQUAL(y_host, (cusp::array1d<float,cusp::host_memory>(100, -1.0f)));
+
+    // the layouts of the operands must match
+    cusp::mpi_array1d<float> z(cusp::mpi_uniform_layout(comm, 99), 1.0f);
+    ASSERT_THROWS(cusp::blas::dot(x, z), cusp::invalid_input_exception);
+}
+DECLARE_UNITTEST(TestMPILayout);
+
+template <typename LocalMatrix>
+void CompareMPISpMV(const cusp::csr_matrix<int,float,cusp::host_memory>& A)
+{
+    cusp::mpi_layout layout = cusp::mpi_uniform_layout(test_communicator(), A.num_rows);
+
+    cusp::csr_matrix<int,float,cusp::host_memory> A_local;
+    local_rows(A, layout, A_local);
+
+    cusp::mpi_matrix<LocalMatrix> B(A_local, layout);
+
+    ASSERT_EQUAL(B.num_rows,    A.num_rows);
+    ASSERT_EQUAL(B.num_entries, A.num_entries);
+    ASSERT_EQUAL(B.ghost_columns.size(), B.num_halo_entries());
+
+    cusp::array1d<float,cusp::host_memory> x(A.num_cols);
+    for(size_t i = 0; i < x.size(); i++)
+        x[i] = int(i % 5) - 2;
+
+    cusp::array1d<float,cusp::host_memory> y(A.num_rows);
+    cusp::multiply(A, x, y);
+
+    cusp::array1d<float,cusp::host_memory> x_local(x.begin() + layout.first_row(),
+                                                   x.begin() + layout.first_row() + layout.local_size());
+
+    cusp::mpi_array1d<float> d_x(layout, x_local);
+    cusp::mpi_array1d<float> d_y(layout, 10.0f);
+
+    // repeated products reuse the persistent requests
+    for(int k = 0; k < 2; k++)
+    {
+        cusp::multiply(B, d_x, d_y);
+
+        cusp::array1d<float,cusp::host_memory> result;
+        d_y.gather(result);
+
+        ASSERT_EQUAL(result, y);
+    }
+}
+
+void TestMPIMatrixSpMV(void)
+{
+    cusp::csr_matrix<int,float,cusp::host_memory> A;
+    cusp::gallery::poisson5pt(A, 30, 17);
+
+    CompareMPISpMV< cusp::csr_matrix<int,float,cusp::device_memory> >(A);
+    CompareMPISpMV< cusp::hyb_matrix<int,float,cusp::device_memory> >(A);
+
+    // the local rows must match the layout
+    cusp::mpi_layout layout = cusp::mpi_uniform_layout(test_communicator(), A.num_rows + 1);
+    ASSERT_THROWS((cusp::mpi_matrix< cusp::csr_matrix<int,float,cusp::device_memory> >(A, layout)),
+                  cusp::invalid_input_exception);
+}
+DECLARE_UNITTEST(TestMPIMatrixSpMV);
+
+void TestMPIKrylov(void)
+{
+    typedef cusp::csr_matrix<int,double,cusp::host_memory>   HostMatrix;
+    typedef cusp::hyb_matrix<int,double,cusp::device_memory> DeviceMatrix;
+    typedef cusp::precond::aggregation::mpi_smoothed_aggregation<int,double> Preconditioner;
+
+    HostMatrix A;
+    cusp::gallery::poisson5pt(A, 40, 40);
+
+    cusp::mpi_layout layout = cusp::mpi_uniform_layout(test_communicator(), A.num_rows);
+
+    HostMatrix A_local;
+    local_rows(A, layout, A_local);
+
+    cusp::mpi_matrix<DeviceMatrix> D(A_local, layout);
+
+    cusp::mpi_array1d<double> b(layout, 1.0);
+
+    // unpreconditioned solves
+    cusp::mpi_array1d<double> x0(layout, 0.0);
+    cusp::default_monitor<double> monitor0(b, 500, 1e-8);
+    cusp::krylov::cg(D, x0, b, monitor0);
+
+    cusp::mpi_array1d<double> x1(layout, 0.0);
+    cusp::default_monitor<double> monitor1(b, 500, 1e-8);
+    cusp::krylov::pipelined_cg(D, x1, b, monitor1);
+
+    // preconditioned solve
+    Preconditioner M(A_local, layout);
+
+    ASSERT_EQUAL(M.num_levels() > 1, true);
+    ASSERT_EQUAL(M.level_size(0), A.num_rows);
+
+    for(size_t lvl = 1; lvl < M.num_levels(); lvl++)
+        ASSERT_EQUAL(M.level_size(lvl) < M.level_size(lvl - 1), true);
+
+    cusp::mpi_array1d<double> x(layout, 0.0);
+    cusp::default_monitor<double> monitor(b, 500, 1e-8);
+    cusp::krylov::cg(D, x, b, monitor, M);
+
+    ASSERT_EQUAL(monitor0.converged(), true);
+    ASSERT_EQUAL(monitor1.converged(), true);
+    ASSERT_EQUAL(monitor.converged(), true);
+    ASSERT_EQUAL(monitor.iteration_count() < monitor0.iteration_count(), true);
+
+    cusp::array1d<double,cusp::host_memory> x0_host, x1_host, x_host;
+    x0.gather(x0_host);
+    x1.gather(x1_host);
+    x.gather(x_host);
+
+    ASSERT_ALMOST_EQUAL(x1_host, x0_host);
+    ASSERT_ALMOST_EQUAL(x_host, x0_host);
+}
+DECLARE_UNITTEST(TestMPIKrylov);
+
+#endif // __CUSP_USE_MPI__
@@ -1,22 +1,32 @@
 #include <unittest/unittest.h>
 
-#ifndef _MSC_VER
-#define CUSP_USE_TEXTURE_MEMORY
-#endif
-
 #include <cusp/multiply.h>
+#include <cusp/blas.h>
+#include <cusp/complex.h>
+#include <cusp/cache.h>
+#include <cusp/reduction.h>
+#include <cusp/detail/device/spmm/csr.h>
 
 #include <cusp/linear_operator.h>
 #include <cusp/print.h>
+#include <cusp/transpose.h>
 #include <cusp/gallery/poisson.h>
 #include <cusp/gallery/random.h>
 
 #include <cusp/array2d.h>
+#include <cusp/bsr_matrix.h>
 #include <cusp/coo_matrix.h>
 #include <cusp/csr_matrix.h>
+#include <cusp/csr16_matrix.h>
 #include <cusp/dia_matrix.h>
 #include <cusp/ell_matrix.h>
 #include <cusp/hyb_matrix.h>
+#include <cusp/sell_matrix.h>
+
+#include <algorithm>
+#include <limits>
+#include <map>
+#include <vector>
 
 /////////////////////////////////////////
 // Sparse Matrix-Matrix Multiplication //
@@ -129,6 +139,324 @@ void TestSparseMatrixMatrixMultiply(void)
 }
 DECLARE_SPARSE_MATRIX_UNITTEST(TestSparseMatrixMatrixMultiply);
 
+template <typename DenseMatrixType>
+void CompareSparseMatrixMatrixMultiplyTwoPhase(DenseMatrixType A, DenseMatrixType B)
+{
+    typedef cusp::csr_matrix<int,float,cusp::device_memory> SparseMatrixType;
+
+    DenseMatrixType C;
+    cusp::multiply(A, B, C);
+
+    SparseMatrixType _A(A), _B(B), _C;
+    cusp::detail::device::spmm_csr_symbolic(_A, _B, _C);
+    cusp::detail::device::spmm_csr_numeric(_A, _B, _C);
+
+    ASSERT_EQUAL(C == DenseMatrixType(_C), true);
+
+    // reuse the pattern of C after changing the values of A
+    cusp::blas::scal(_A.values, 2.0f);
+    cusp::blas::scal(C.values,  2.0f);
+    cusp::detail::device::spmm_csr_numeric(_A, _B, _C);
+
+    ASSERT_EQUAL(C == DenseMatrixType(_C), true);
+}
+
+void TestSparseMatrixMatrixMultiplyTwoPhase(void)
+{
+    cusp::array2d<float,cusp::host_memory> G;
+    cusp::gallery::poisson5pt(G, 4, 6);
+
+    cusp::array2d<float,cusp::host_memory> I;
+    cusp::gallery::random(24, 24, 150, I);
+
+    CompareSparseMatrixMatrixMultiplyTwoPhase(G, G);
+    CompareSparseMatrixMatrixMultiplyTwoPhase(G, I);
+    CompareSparseMatrixMatrixMultiplyTwoPhase(I, G);
+
+    // rows of C which exceed the shared memory tables
+    cusp::array2d<float,cusp::host_memory> L(3, 700, 0.0f);
+    for (size_t j = 0; j < L.num_cols; j++)
+    {
+        L(0,j) = 1.0f;
+        L(2,j) = float(j % 3);
+    }
+    L(1,5) = 2.0f;
+
+    cusp::array2d<float,cusp::host_memory> M(700, 700, 0.0f);
+    for (size_t i = 0; i < M.num_rows; i++)
+    {
+        M(i,i) = 1.0f;
+        M(i,(i * 7) % M.num_cols) += 1.0f;
+    }
+
+    CompareSparseMatrixMatrixMultiplyTwoPhase(L, M);
+}
+DECLARE_UNITTEST(TestSparseMatrixMatrixMultiplyTwoPhase);
+
+// index and value types which the row-wise kernels do not support
+template <typename DeviceMatrix>
+void CompareSparseMatrixMatrixMultiplyExpand(void)
+{
+    typedef typename DeviceMatrix::index_type IndexType;
+    typedef typename DeviceMatrix::value_type ValueType;
+    typedef cusp::coo_matrix<IndexType,ValueType,cusp::host_memory> HostMatrix;
+    typedef cusp::array2d<ValueType,cusp::host_memory>               DenseMatrix;
+
+    cusp::array2d<float,cusp::host_memory> G;
+    cusp::gallery::poisson5pt(G, 4, 6);
+
+    HostMatrix A(G);
+    for (size_t n = 0; n < A.num_entries; n++)
+        A.values[n] = ValueType(A.values[n]) * ValueType(n % 3 + 1);
+
+    cusp::array2d<float,cusp::host_memory> Q;
+    cusp::gallery::random(24, 12, 40, Q);
+
+    HostMatrix P(Q), R;
+    for (size_t n = 0; n < P.num_entries; n++)
+        P.values[n] = ValueType(n % 5 + 1);
+    cusp::transpose(P, R);
+
+    // C = A * A
+    {
+        HostMatrix C;
+        cusp::multiply(A, A, C);
+
+        DeviceMatrix _A(A), _C;
+        cusp::multiply(_A, _A, _C);
+
+        ASSERT_EQUAL(DenseMatrix(C) == DenseMatrix(_C), true);
+    }
+
+    // RAP = R * (A * P)
+    {
+        HostMatrix AP, RAP;
+        cusp::multiply(A, P, AP);
+        cusp::multiply(R, AP, RAP);
+
+        DeviceMatrix _R(R), _A(A), _P(P), _RAP;
+        cusp::galerkin_product(_R, _A, _P, _RAP);
+
+        ASSERT_EQUAL(DenseMatrix(RAP) == DenseMatrix(_RAP), true);
+    }
+}
+
+void TestSparseMatrixMatrixMultiplyExpand(void)
+{
+    CompareSparseMatrixMatrixMultiplyExpand< cusp::coo_matrix<long long,float,cusp::device_memory> >();
+    CompareSparseMatrixMatrixMultiplyExpand< cusp::csr_matrix<long long,float,cusp::device_memory> >();
+    CompareSparseMatrixMatrixMultiplyExpand< cusp::hyb_matrix<long long,float,cusp::device_memory> >();
+    CompareSparseMatrixMatrixMultiplyExpand< cusp::coo_matrix<int,cusp::complex<float>,cusp::device_memory> >();
+    CompareSparseMatrixMatrixMultiplyExpand< cusp::csr_matrix<int,cusp::complex<float>,cusp::device_memory> >();
+}
+DECLARE_UNITTEST(TestSparseMatrixMatrixMultiplyExpand);
+
+// rows of A * B as sorted maps, without the entries which cancel
+template <typename Matrix>
+void ReferenceSparseMatrixMatrixMultiply(const Matrix& A, const Matrix& B,
+                                         std::vector< std::map<int,float> >& rows)
+{
+    rows.assign(A.num_rows, std::map<int,float>());
+
+    for (size_t i = 0; i < A.num_rows; i++)
+        for (int jj = A.row_offsets[i]; jj < A.row_offsets[i + 1]; jj++)
+            for (int kk = B.row_offsets[A.column_indices[jj]]; kk < B.row_offsets[A.column_indices[jj] + 1]; kk++)
+                rows[i][B.column_indices[kk]] += A.values[jj] * B.values[kk];
+
+    for (size_t i = 0; i < rows.size(); i++)
+        for (std::map<int,float>::iterator it = rows[i].begin(); it != rows[i].end(); )
+            if (it->second == 0.0f)
+                rows[i].erase(it++);
+            else
+                ++it;
+}
+
+void CompareHostSparseMatrixMatrixMultiply(const cusp::csr_matrix<int,float,cusp::host_memory>& A,
+                                           const cusp::csr_matrix<int,float,cusp::host_memory>& B)
+{
+    std::vector< std::map<int,float> > rows;
+    ReferenceSparseMatrixMatrixMultiply(A, B, rows);
+
+    cusp::csr_matrix<int,float,cusp::host_memory> C;
+    cusp::multiply(A, B, C);
+
+    ASSERT_EQUAL(C.num_rows, A.num_rows);
+    ASSERT_EQUAL(C.num_cols, B.num_cols);
+
+    size_t num_entries = 0;
+    for (size_t i = 0; i < rows.size(); i++)
+    {
+        ASSERT_EQUAL(size_t(C.row_offsets[i + 1] - C.row_offsets[i]), rows[i].size());
+
+        for (int jj = C.row_offsets[i]; jj < C.row_offsets[i + 1]; jj++)
+            ASSERT_EQUAL(C.values[jj], rows[i][C.column_indices[jj]]);
+
+        num_entries += rows[i].size();
+    }
+
+    ASSERT_EQUAL(C.num_entries, num_entries);
+
+    // COO takes the same path
+    cusp::coo_matrix<int,float,cusp::host_memory> A_coo(A), B_coo(B), C_coo;
+    cusp::multiply(A_coo, B_coo, C_coo);
+    ASSERT_EQUAL(C_coo.num_entries, num_entries);
+}
+
+void TestHostSparseMatrixMatrixMultiplyLarge(void)
+{
+    // enough products for the rows to be split among threads
+    cusp::csr_matrix<int,float,cusp::host_memory> P;
+    cusp::gallery::poisson5pt(P, 120, 100);
+
+    CompareHostSparseMatrixMatrixMultiply(P, P);
+
+    // long rows of A hitting long rows of B, and entries which cancel
+    const int N = 3000;
+
+    std::vector<int> I, J;
+    std::vector<float> V;
+    for (int i = 0; i < N; i++)
+    {
+        const int length = (i % 500 == 0) ? 400 : i % 4;
+
+        for (int k = 0; k < length; k++)
+        {
+            I.push_back(i);
+            J.push_back((i * 31 + k * 17) % N);
+            V.push_back((k % 2) ? 1.0f : -1.0f);
+        }
+    }
+
+    cusp::coo_matrix<int,float,cusp::host_memory> R(N, N, I.size());
+    for (size_t n = 0; n < I.size(); n++)
+    {
+        R.row_indices[n] = I[n];
+        R.column_indices[n] = J[n];
+        R.values[n] = V[n];
+    }
+    R.sort_by_row_and_column();
+
+    cusp::csr_matrix<int,float,cusp::host_memory> S(R);
+    CompareHostSparseMatrixMatrixMultiply(S, S);
+
+    // a wide B whose rows of C touch few of its columns take the hash
+    // accumulator
+    const int W = 200000;
+
+    cusp::coo_matrix<int,float,cusp::host_memory> T(N, W, 2 * N);
+    for (int i = 0; i < N; i++)
+    {
+        T.row_indices[2 * i] = i;
+        T.column_indices[2 * i] = (i * 7919) % W;
+        T.values[2 * i] = 1.0f;
+        T.row_indices[2 * i + 1] = i;
+        T.column_indices[2 * i + 1] = (i * 104729 + 13) % W;
+        T.values[2 * i + 1] = float(i % 5) - 2.0f;
+    }
+    T.sort_by_row_and_column();
+
+    cusp::csr_matrix<int,float,cusp::host_memory> U(T);
+    CompareHostSparseMatrixMatrixMultiply(S, U);
+}
+DECLARE_UNITTEST(TestHostSparseMatrixMatrixMultiplyLarge);
+
+template <typename TestMatrix>
+void TestGalerkinProduct(void)
+{
+    typedef typename TestMatrix::value_type ValueType;
+
+    cusp::array2d<ValueType,cusp::host_memory> A;
+    cusp::gallery::poisson5pt(A, 4, 6);
+
+    cusp::array2d<ValueType,cusp::host_memory> P;
+    cusp::gallery::random(24, 12, 40, P);
+
+    cusp::array2d<ValueType,cusp::host_memory> R;
+    cusp::transpose(P, R);
+
+    // reference RAP = R * (A * P)
+    cusp::array2d<ValueType,cusp::host_memory> AP, RAP;
+    cusp::multiply(A, P, AP);
+    cusp::multiply(R, AP, RAP);
+
+    TestMatrix _R(R), _A(A), _P(P), _RAP;
+    cusp::galerkin_product(_R, _A, _P, _RAP);
+
+    ASSERT_EQUAL((RAP == cusp::array2d<ValueType,cusp::host_memory>(_RAP)), true);
+
+    // incompatible dimensions
+    ASSERT_THROWS(cusp::galerkin_product(_P, _A, _P, _RAP), cusp::invalid_input_exception);
+}
+DECLARE_SPARSE_MATRIX_UNITTEST(TestGalerkinProduct);
+
+template <typename TestMatrix>
+void TestMaskedProduct(void)
+{
+    typedef typename TestMatrix::value_type ValueType;
+
+    cusp::array2d<ValueType,cusp::host_memory> A;
+    cusp::gallery::poisson5pt(A, 4, 6);
+
+    cusp::array2d<ValueType,cusp::host_memory> B;
+    cusp::gallery::random(24, 12, 40, B);
+
+    cusp::array2d<ValueType,cusp::host_memory> M;
+    cusp::gallery::random(24, 12, 60, M);
+
+    TestMatrix _A(A), _B(B), _M(M), _C;
+    cusp::masked_product(_A, _B, _M, _C);
+
+    // reference A * B at the stored entries of the mask, including any
+    // explicit zeros the format keeps
+    cusp::array2d<ValueType,cusp::host_memory> AB;
+    cusp::multiply(A, B, AB);
+
+    cusp::csr_matrix<int,ValueType,cusp::host_memory> mask(_M);
+    cusp::array2d<ValueType,cusp::host_memory> C(24, 12, ValueType(0));
+
+    for (size_t i = 0; i < mask.num_rows; i++)
+        for (int jj = mask.row_offsets[i]; jj < mask.row_offsets[i + 1]; jj++)
+            C(i, mask.column_indices[jj]) = AB(i, mask.column_indices[jj]);
+
+    ASSERT_EQUAL((C == cusp::array2d<ValueType,cusp::host_memory>(_C)), true);
+
+    // incompatible dimensions
+    ASSERT_THROWS(cusp::masked_product(_B, _A, _M, _C), cusp::invalid_input_exception);
+    ASSERT_THROWS(cusp::masked_product(_A, _B, _A, _C), cusp::invalid_input_exception);
+}
+DECLARE_SPARSE_MATRIX_UNITTEST(TestMaskedProduct);
+
+template <class MemorySpace>
+void TestMaskedProductPattern(void)
+{
+    // C takes the pattern of M, with zeros where A * B has no entry
+    cusp::csr_matrix<int,float,cusp::host_memory> A(2, 2, 2);
+    A.row_offsets[0] = 0; A.row_offsets[1] = 1; A.row_offsets[2] = 2;
+    A.column_indices[0] = 0; A.values[0] = 2;
+    A.column_indices[1] = 0; A.values[1] = 3;
+
+    cusp::csr_matrix<int,float,cusp::host_memory> M(2, 2, 3);
+    M.row_offsets[0] = 0; M.row_offsets[1] = 2; M.row_offsets[2] = 3;
+    M.column_indices[0] = 0; M.values[0] = 7;
+    M.column_indices[1] = 1; M.values[1] = 7;
+    M.column_indices[2] = 1; M.values[2] = 7;
+
+    cusp::csr_matrix<int,float,MemorySpace> _A(A), _M(M), _C;
+    cusp::masked_product(_A, _A, _M, _C);
+
+    cusp::csr_matrix<int,float,cusp::host_memory> C(_C);
+
+    ASSERT_EQUAL(C.num_rows, size_t(2));
+    ASSERT_EQUAL(C.num_cols, size_t(2));
+    ASSERT_EQUAL(C.num_entries, size_t(3));
+    ASSERT_EQUAL(C.row_offsets,    M.row_offsets);
+    ASSERT_EQUAL(C.column_indices, M.column_indices);
+    ASSERT_EQUAL(C.values[0], 4);
+    ASSERT_EQUAL(C.values[1], 0);
+    ASSERT_EQUAL(C.values[2], 0);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestMaskedProductPattern);
+
 ///////////////////////////////////////////////
 // Sparse Matrix-Dense Matrix Multiplication //
 ///////////////////////////////////////////////
@@ -262,6 +590,112 @@ void TestSparseMatrixDenseMatrixMultiply(void)
 }
 DECLARE_SPARSE_MATRIX_UNITTEST(TestSparseMatrixDenseMatrixMultiply);
 
+template <typename TestMatrix>
+void TestSparseMatrixDenseMatrixMultiplyRowMajor(void)
+{
+    typedef typename TestMatrix::memory_space MemorySpace;
+
+    cusp::array2d<float,cusp::host_memory> A;
+    cusp::gallery::poisson5pt(A, 8, 5);
+
+    // block of 6 vectors
+    cusp::array2d<float,cusp::host_memory> B(A.num_cols, 6);
+    for(size_t i = 0; i < B.num_rows; i++)
+        for(size_t j = 0; j < B.num_cols; j++)
+            B(i,j) = (i + 3 * j) % 7;
+
+    cusp::array2d<float,cusp::host_memory> C(A.num_rows, B.num_cols);
+    cusp::multiply(A, B, C);
+
+    TestMatrix _A(A);
+    cusp::array2d<float,MemorySpace,cusp::row_major> _B(B);
+    cusp::array2d<float,MemorySpace,cusp::row_major> _C(A.num_rows, B.num_cols, -1.0f);
+
+    cusp::multiply(_A, _B, _C);
+
+    ASSERT_EQUAL((C == cusp::array2d<float,cusp::host_memory>(_C)), true);
+}
+DECLARE_SPARSE_MATRIX_UNITTEST(TestSparseMatrixDenseMatrixMultiplyRowMajor);
+
+template <typename TestMatrix, typename Orientation>
+void CompareSparseMatrixDenseMatrixMultiplyWide(size_t num_vectors)
+{
+    typedef typename TestMatrix::memory_space MemorySpace;
+
+    cusp::array2d<float,cusp::host_memory> A;
+    cusp::gallery::poisson5pt(A, 8, 5);
+
+    cusp::array2d<float,cusp::host_memory> B(A.num_cols, num_vectors);
+    for(size_t i = 0; i < B.num_rows; i++)
+        for(size_t j = 0; j < B.num_cols; j++)
+            B(i,j) = (i + 3 * j) % 7;
+
+    cusp::array2d<float,cusp::host_memory> C(A.num_rows, B.num_cols);
+    cusp::multiply(A, B, C);
+
+    TestMatrix _A(A);
+    cusp::array2d<float,MemorySpace,Orientation> _B(B);
+    cusp::array2d<float,MemorySpace,Orientation> _C(A.num_rows, B.num_cols, -1.0f);
+
+    cusp::multiply(_A, _B, _C);
+
+    ASSERT_EQUAL((C == cusp::array2d<float,cusp::host_memory>(_C)), true);
+}
+
+template <typename TestMatrix>
+void TestSparseMatrixDenseMatrixMultiplyWide(void)
+{
+    // more vectors than a warp has threads, with a partial last tile
+    const size_t widths[] = {33, 64, 100, 128, 150};
+
+    for(size_t i = 0; i < sizeof(widths) / sizeof(size_t); i++)
+    {
+        CompareSparseMatrixDenseMatrixMultiplyWide<TestMatrix, cusp::row_major>(widths[i]);
+        CompareSparseMatrixDenseMatrixMultiplyWide<TestMatrix, cusp::column_major>(widths[i]);
+    }
+}
+DECLARE_SPARSE_MATRIX_UNITTEST(TestSparseMatrixDenseMatrixMultiplyWide);
+
+template <typename TestMatrix, typename Orientation>
+void CompareSparseMatrixDenseMatrixMultiplyPitched(void)
+{
+    typedef typename TestMatrix::memory_space MemorySpace;
+
+    cusp::array2d<float,cusp::host_memory> A;
+    cusp::gallery::poisson5pt(A, 8, 5);
+
+    cusp::array2d<float,cusp::host_memory> B(A.num_cols, 6);
+    for(size_t i = 0; i < B.num_rows; i++)
+        for(size_t j = 0; j < B.num_cols; j++)
+            B(i,j) = (i + 3 * j) % 7;
+
+    cusp::array2d<float,cusp::host_memory> C(A.num_rows, B.num_cols);
+    cusp::multiply(A, B, C);
+
+    TestMatrix _A(A);
+
+    // rows or columns padded to 128 byte boundaries
+    cusp::array2d<float,MemorySpace,Orientation> _B;
+    _B.resize_pitched(B.num_rows, B.num_cols);
+    cusp::copy(B, _B);
+
+    cusp::array2d<float,MemorySpace,Orientation> _C;
+    _C.resize_pitched(C.num_rows, C.num_cols);
+
+    cusp::multiply(_A, _B, _C);
+
+    ASSERT_EQUAL(_C.pitch, _B.pitch);
+    ASSERT_EQUAL((C == cusp::array2d<float,cusp::host_memory>(_C)), true);
+}
+
+template <typename TestMatrix>
+void TestSparseMatrixDenseMatrixMultiplyPitched(void)
+{
+    CompareSparseMatrixDenseMatrixMultiplyPitched<TestMatrix, cusp::row_major>();
+    CompareSparseMatrixDenseMatrixMultiplyPitched<TestMatrix, cusp::column_major>();
+}
+DECLARE_SPARSE_MATRIX_UNITTEST(TestSparseMatrixDenseMatrixMultiplyPitched);
+
 
 /////////////////////////////////////////
 // Sparse Matrix-Vector Multiplication //
@@ -397,6 +831,866 @@ void TestSparseMatrixVectorMultiply()
 }
 DECLARE_SPARSE_MATRIX_UNITTEST(TestSparseMatrixVectorMultiply);
 
+template <typename TestMatrix>
+void CompareScaledMatrixVectorMultiply(const cusp::array2d<float,cusp::host_memory>& A,
+                                       const float alpha, const float beta)
+{
+    typedef typename TestMatrix::memory_space MemorySpace;
+
+    cusp::array1d<float,cusp::host_memory> x(A.num_cols);
+    cusp::array1d<float,cusp::host_memory> y(A.num_rows);
+
+    for (size_t i = 0; i < x.size(); i++)
+        x[i] = float(i % 7) - 3.0f;
+    for (size_t i = 0; i < y.size(); i++)
+        y[i] = float(i % 5) + 1.0f;
+
+    // alpha * A * x + beta * y
+    cusp::array1d<float,cusp::host_memory> expected(A.num_rows);
+    cusp::multiply(A, x, expected);
+    cusp::blas::axpby(expected, y, expected, alpha, beta);
+
+    TestMatrix _A(A);
+    cusp::array1d<float,MemorySpace> _x(x);
+    cusp::array1d<float,MemorySpace> _y(y);
+
+    // y is not read when beta is zero
+    if (beta == 0.0f)
+        cusp::blas::fill(_y, std::numeric_limits<float>::quiet_NaN());
+
+    cusp::multiply(_A, _x, _y, alpha, beta);
+
+    ASSERT_ALMOST_EQUAL(_y, expected);
+}
+
+template <class TestMatrix>
+void TestSparseMatrixVectorMultiplyScaled(void)
+{
+    cusp::array2d<float,cusp::host_memory> A;
+    cusp::gallery::poisson5pt(A, 6, 5);
+
+    cusp::array2d<float,cusp::host_memory> B;
+    cusp::gallery::random(23, 31, 150, B);
+
+    CompareScaledMatrixVectorMultiply<TestMatrix>(A, -1.0f, 1.0f);
+    CompareScaledMatrixVectorMultiply<TestMatrix>(A,  2.5f, 0.0f);
+    CompareScaledMatrixVectorMultiply<TestMatrix>(B,  0.5f, -2.0f);
+    CompareScaledMatrixVectorMultiply<TestMatrix>(B,  0.0f, 3.0f);
+
+    // dimensions must match
+    TestMatrix _B(B);
+    cusp::array1d<float,typename TestMatrix::memory_space> x(B.num_rows);
+    cusp::array1d<float,typename TestMatrix::memory_space> y(B.num_rows);
+
+    ASSERT_THROWS(cusp::multiply(_B, x, y, 1.0f, 1.0f), cusp::invalid_input_exception);
+}
+DECLARE_SPARSE_MATRIX_UNITTEST(TestSparseMatrixVectorMultiplyScaled);
+
+template <class MemorySpace>
+void TestDenseMatrixVectorMultiplyScaled(void)
+{
+    cusp::array2d<float,cusp::host_memory> A;
+    cusp::gallery::random(17, 12, 80, A);
+
+    // dense matrices take the unfused path
+    CompareScaledMatrixVectorMultiply< cusp::array2d<float,MemorySpace> >(A, -1.0f, 1.0f);
+    CompareScaledMatrixVectorMultiply< cusp::array2d<float,MemorySpace> >(A,  3.0f, 0.0f);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestDenseMatrixVectorMultiplyScaled);
+
+template <typename TestMatrix>
+void CompareMatrixVectorMultiplyDot(const cusp::array2d<float,cusp::host_memory>& A)
+{
+    typedef typename TestMatrix::memory_space MemorySpace;
+
+    cusp::array1d<float,cusp::host_memory> x(A.num_cols);
+    for (size_t i = 0; i < x.size(); i++)
+        x[i] = float(i % 7) - 3.0f;
+
+    cusp::array1d<float,cusp::host_memory> expected(A.num_rows);
+    cusp::multiply(A, x, expected);
+
+    TestMatrix _A(A);
+    cusp::array1d<float,MemorySpace> _x(x);
+    cusp::array1d<float,MemorySpace> _y(A.num_rows, -1.0f);
+
+    const float dot = cusp::multiply_dot(_A, _x, _y);
+
+    ASSERT_ALMOST_EQUAL(_y, expected);
+    ASSERT_ALMOST_EQUAL(dot, cusp::blas::dotc(expected, x));
+}
+
+template <class TestMatrix>
+void TestSparseMatrixVectorMultiplyDot(void)
+{
+    cusp::array2d<float,cusp::host_memory> A;
+    cusp::gallery::poisson5pt(A, 9, 7);
+
+    cusp::array2d<float,cusp::host_memory> B;
+    cusp::gallery::random(40, 40, 300, B);
+
+    // a long row puts entries into the COO part of a HYB matrix
+    cusp::array2d<float,cusp::host_memory> C(B);
+    for (size_t j = 0; j < C.num_cols; j++)
+        C(3, j) = float(j % 3) + 1.0f;
+
+    CompareMatrixVectorMultiplyDot<TestMatrix>(A);
+    CompareMatrixVectorMultiplyDot<TestMatrix>(B);
+    CompareMatrixVectorMultiplyDot<TestMatrix>(C);
+
+    // A must be square
+    cusp::array2d<float,cusp::host_memory> D;
+    cusp::gallery::random(10, 12, 40, D);
+
+    TestMatrix _D(D);
+    cusp::array1d<float,typename TestMatrix::memory_space> x(D.num_cols);
+    cusp::array1d<float,typename TestMatrix::memory_space> y(D.num_rows);
+
+    ASSERT_THROWS(cusp::multiply_dot(_D, x, y), cusp::invalid_input_exception);
+}
+DECLARE_SPARSE_MATRIX_UNITTEST(TestSparseMatrixVectorMultiplyDot);
+
+template <class MemorySpace>
+void TestCsrMatrixVectorMultiplyIrregular(void)
+{
+    // a few dense rows among many short rows (power-law like)
+    const size_t N = 4000;
+
+    cusp::coo_matrix<int, float, cusp::host_memory> coo;
+    std::vector<int> I, J;
+    for(size_t i = 0; i < N; i++)
+    {
+        if (i % 97 == 0)
+        {
+            for(size_t j = 0; j < N; j++)
+            {
+                I.push_back(i);
+                J.push_back(j);
+            }
+        }
+        else
+        {
+            I.push_back(i);
+            J.push_back(i);
+        }
+    }
+
+    coo.resize(N, N, I.size());
+    for(size_t n = 0; n < I.size(); n++)
+    {
+        coo.row_indices[n]    = I[n];
+        coo.column_indices[n] = J[n];
+        coo.values[n]         = (n % 3) + 1;
+    }
+
+    cusp::array1d<float, cusp::host_memory> x(N);
+    cusp::array1d<float, cusp::host_memory> y(N, 10);
+    for(size_t i = 0; i < x.size(); i++)
+        x[i] = i % 10;
+
+    // compute reference output
+    cusp::multiply(coo, x, y);
+
+    cusp::csr_matrix<int, float, MemorySpace> A(coo);
+    cusp::array1d<float, MemorySpace> _x(x);
+    cusp::array1d<float, MemorySpace> _y(N, 10);
+
+    cusp::multiply(A, _x, _y);
+
+    ASSERT_EQUAL(_y, y);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestCsrMatrixVectorMultiplyIrregular);
+
+template <typename SparseMatrixType>
+void CompareHostMatrixVectorMultiplyLarge(const cusp::coo_matrix<int, float, cusp::host_memory>& S)
+{
+    // integer values keep every sum exact, whatever the order of the partial sums
+    cusp::array1d<float, cusp::host_memory> x(S.num_cols);
+    for(size_t i = 0; i < x.size(); i++)
+        x[i] = int(i % 7) - 3;
+
+    cusp::array1d<float, cusp::host_memory> y(S.num_rows, 0);
+    for(size_t n = 0; n < S.num_entries; n++)
+        y[S.row_indices[n]] += S.values[n] * x[S.column_indices[n]];
+
+    SparseMatrixType A(S);
+    cusp::array1d<float, cusp::host_memory> z(S.num_rows, 10);
+
+    cusp::multiply(A, x, z);
+
+    ASSERT_EQUAL(z, y);
+}
+
+void TestHostMatrixVectorMultiplyLarge(void)
+{
+    // large enough for the host kernels to split the rows among threads
+    cusp::coo_matrix<int, float, cusp::host_memory> A;
+    cusp::gallery::poisson5pt(A, 250, 200);
+
+    CompareHostMatrixVectorMultiplyLarge< cusp::coo_matrix<int, float, cusp::host_memory> >(A);
+    CompareHostMatrixVectorMultiplyLarge< cusp::csr_matrix<int, float, cusp::host_memory> >(A);
+    CompareHostMatrixVectorMultiplyLarge< cusp::dia_matrix<int, float, cusp::host_memory> >(A);
+    CompareHostMatrixVectorMultiplyLarge< cusp::ell_matrix<int, float, cusp::host_memory> >(A);
+    CompareHostMatrixVectorMultiplyLarge< cusp::hyb_matrix<int, float, cusp::host_memory> >(A);
+    CompareHostMatrixVectorMultiplyLarge< cusp::sell_matrix<int, float, cusp::host_memory> >(A);
+    CompareHostMatrixVectorMultiplyLarge< cusp::csr16_matrix<int, float, cusp::host_memory> >(A);
+
+    {
+        cusp::csr_matrix<int, float, cusp::host_memory> A_csr(A);
+        cusp::bsr_matrix<int, float, cusp::host_memory> A_bsr(A_csr, 2);
+
+        cusp::array1d<float, cusp::host_memory> x(A.num_cols);
+        for(size_t i = 0; i < x.size(); i++)
+            x[i] = int(i % 7) - 3;
+
+        cusp::array1d<float, cusp::host_memory> y(A.num_rows, 0);
+        cusp::array1d<float, cusp::host_memory> z(A.num_rows, 10);
+
+        cusp::multiply(A_csr, x, y);
+        cusp::multiply(A_bsr, x, z);
+
+        ASSERT_EQUAL(z, y);
+    }
+
+    // long rows, empty rows and short rows
+    const size_t N = 40000;
+
+    std::vector<int> I, J;
+    for(size_t i = 0; i < N; i++)
+    {
+        const size_t length = (i % 5000 == 0) ? 3000 : (i % 3 == 0 ? 0 : i % 6);
+
+        for(size_t k = 0; k < length; k++)
+        {
+            I.push_back(i);
+            J.push_back((i * 31 + k * 17) % N);
+        }
+    }
+
+    cusp::coo_matrix<int, float, cusp::host_memory> B(N, N, I.size());
+    for(size_t n = 0; n < I.size(); n++)
+    {
+        B.row_indices[n]    = I[n];
+        B.column_indices[n] = J[n];
+        B.values[n]         = int(n % 5) - 2;
+    }
+    B.sort_by_row_and_column();
+
+    CompareHostMatrixVectorMultiplyLarge< cusp::coo_matrix<int, float, cusp::host_memory> >(B);
+    CompareHostMatrixVectorMultiplyLarge< cusp::csr_matrix<int, float, cusp::host_memory> >(B);
+    CompareHostMatrixVectorMultiplyLarge< cusp::hyb_matrix<int, float, cusp::host_memory> >(B);
+    CompareHostMatrixVectorMultiplyLarge< cusp::sell_matrix<int, float, cusp::host_memory> >(B);
+}
+DECLARE_UNITTEST(TestHostMatrixVectorMultiplyLarge);
+
+template <typename SparseMatrixType>
+void CompareMixedPrecisionMatrixVectorMultiply(const cusp::csr_matrix<int, float, cusp::host_memory>& S)
+{
+    typedef typename SparseMatrixType::memory_space MemorySpace;
+
+    // the offsets of x are below the precision of float, so the result only
+    // matches the double reference when the products and the sums are in double
+    cusp::array1d<double, cusp::host_memory> x(S.num_cols);
+    for(size_t i = 0; i < x.size(); i++)
+        x[i] = 1.0 + (i % 7) / 1073741824.0;
+
+    cusp::csr_matrix<int, double, cusp::host_memory> R(S);
+    cusp::array1d<double, cusp::host_memory> y(S.num_rows, 10.0);
+    cusp::multiply(R, x, y);
+
+    SparseMatrixType A(S);
+    cusp::array1d<double, MemorySpace> _x(x);
+    cusp::array1d<double, MemorySpace> _y(S.num_rows, 10.0);
+
+    cusp::multiply(A, _x, _y);
+
+    ASSERT_EQUAL(_y, y);
+}
+
+template <class MemorySpace>
+void TestMixedPrecisionMatrixVectorMultiply(void)
+{
+    cusp::csr_matrix<int, float, cusp::host_memory> A;
+    cusp::gallery::poisson5pt(A, 30, 20);
+
+    // a dense row among short rows exercises the merge based CSR kernel
+    cusp::coo_matrix<int, float, cusp::host_memory> coo(2000, 2000, 3999);
+    for(int j = 0; j < 2000; j++)
+    {
+        coo.row_indices[j] = 0;  coo.column_indices[j] = j;  coo.values[j] = (j % 3) + 1;
+    }
+    for(int i = 1; i < 2000; i++)
+    {
+        coo.row_indices[1999 + i] = i;  coo.column_indices[1999 + i] = i;  coo.values[1999 + i] = 2;
+    }
+    cusp::csr_matrix<int, float, cusp::host_memory> B(coo);
+
+    CompareMixedPrecisionMatrixVectorMultiply< cusp::coo_matrix<int, float, MemorySpace> >(A);
+    CompareMixedPrecisionMatrixVectorMultiply< cusp::csr_matrix<int, float, MemorySpace> >(A);
+    CompareMixedPrecisionMatrixVectorMultiply< cusp::ell_matrix<int, float, MemorySpace> >(A);
+    CompareMixedPrecisionMatrixVectorMultiply< cusp::hyb_matrix<int, float, MemorySpace> >(A);
+
+    CompareMixedPrecisionMatrixVectorMultiply< cusp::coo_matrix<int, float, MemorySpace> >(B);
+    CompareMixedPrecisionMatrixVectorMultiply< cusp::csr_matrix<int, float, MemorySpace> >(B);
+    CompareMixedPrecisionMatrixVectorMultiply< cusp::hyb_matrix<int, float, MemorySpace> >(B);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestMixedPrecisionMatrixVectorMultiply);
+
+template <typename SparseMatrixType>
+void CompareMatrixVectorMultiplyCacheModes(const cusp::coo_matrix<int, float, cusp::host_memory>& S)
+{
+    cusp::array1d<float, cusp::host_memory> x(S.num_cols + 1);
+    for(size_t i = 0; i < x.size(); i++)
+        x[i] = int(i % 7) - 3;
+
+    cusp::array1d<float, cusp::host_memory> y(S.num_rows, 0);
+    for(size_t n = 0; n < S.num_entries; n++)
+        y[S.row_indices[n]] += S.values[n] * x[S.column_indices[n]];
+
+    SparseMatrixType A(S);
+    cusp::array1d<float, cusp::device_memory> d_x(x.begin(), x.begin() + S.num_cols);
+    cusp::array1d<float, cusp::device_memory> z(S.num_rows, 10);
+
+    cusp::multiply(A, d_x, z);
+    ASSERT_EQUAL(z, y);
+
+    {
+        cusp::spmv_cache_scope scope(cusp::texture_cache);
+        ASSERT_EQUAL(cusp::current_spmv_cache_mode(), cusp::texture_cache);
+
+        thrust::fill(z.begin(), z.end(), 10.0f);
+        cusp::multiply(A, d_x, z);
+        ASSERT_EQUAL(z, y);
+
+        // a vector which is not aligned for a texture falls back to the read-only cache
+        cusp::array1d<float, cusp::device_memory> buffer(S.num_cols + 1, 0);
+        thrust::copy(d_x.begin(), d_x.end(), buffer.begin() + 1);
+
+        thrust::fill(z.begin(), z.end(), 10.0f);
+        cusp::multiply(A, cusp::make_array1d_view(buffer.begin() + 1, buffer.end()), z);
+        ASSERT_EQUAL(z, y);
+    }
+
+    ASSERT_EQUAL(cusp::current_spmv_cache_mode(), cusp::read_only_cache);
+}
+
+void TestMatrixVectorMultiplyCacheModes(void)
+{
+    cusp::coo_matrix<int, float, cusp::host_memory> A;
+    cusp::gallery::poisson5pt(A, 30, 20);
+
+    CompareMatrixVectorMultiplyCacheModes< cusp::coo_matrix<int, float, cusp::device_memory> >(A);
+    CompareMatrixVectorMultiplyCacheModes< cusp::csr_matrix<int, float, cusp::device_memory> >(A);
+    CompareMatrixVectorMultiplyCacheModes< cusp::dia_matrix<int, float, cusp::device_memory> >(A);
+    CompareMatrixVectorMultiplyCacheModes< cusp::ell_matrix<int, float, cusp::device_memory> >(A);
+    CompareMatrixVectorMultiplyCacheModes< cusp::hyb_matrix<int, float, cusp::device_memory> >(A);
+    CompareMatrixVectorMultiplyCacheModes< cusp::sell_matrix<int, float, cusp::device_memory> >(A);
+}
+DECLARE_UNITTEST(TestMatrixVectorMultiplyCacheModes);
+
+template <typename SparseMatrixType>
+void CompareMatrixVectorMultiplyL2Persistence(const cusp::coo_matrix<int, float, cusp::host_memory>& S)
+{
+    cusp::array1d<float, cusp::host_memory> x(S.num_cols);
+    for(size_t i = 0; i < x.size(); i++)
+        x[i] = int(i % 5) - 2;
+
+    cusp::array1d<float, cusp::host_memory> y(S.num_rows, 0);
+    for(size_t n = 0; n < S.num_entries; n++)
+        y[S.row_indices[n]] += S.values[n] * x[S.column_indices[n]];
+
+    SparseMatrixType A(S);
+    cusp::array1d<float, cusp::device_memory> d_x(x);
+    cusp::array1d<float, cusp::device_memory> z(S.num_rows, 10);
+
+    // the window is only a hint, on any device the products are unchanged
+    {
+        cusp::l2_persistence_scope scope;
+        ASSERT_EQUAL(cusp::l2_persistence_enabled(), true);
+
+        cusp::multiply(A, d_x, z);
+        ASSERT_EQUAL(z, y);
+
+        {
+            cusp::l2_persistence_scope inner(false);
+            ASSERT_EQUAL(cusp::l2_persistence_enabled(), false);
+
+            thrust::fill(z.begin(), z.end(), 10.0f);
+            cusp::multiply(A, d_x, z);
+            ASSERT_EQUAL(z, y);
+        }
+
+        ASSERT_EQUAL(cusp::l2_persistence_enabled(), true);
+
+        cusp::spmv_cache_scope cache(cusp::texture_cache);
+
+        thrust::fill(z.begin(), z.end(), 10.0f);
+        cusp::multiply(A, d_x, z);
+        ASSERT_EQUAL(z, y);
+    }
+
+    ASSERT_EQUAL(cusp::l2_persistence_enabled(), false);
+}
+
+void TestMatrixVectorMultiplyL2Persistence(void)
+{
+    cusp::coo_matrix<int, float, cusp::host_memory> A;
+    cusp::gallery::poisson5pt(A, 30, 20);
+
+    CompareMatrixVectorMultiplyL2Persistence< cusp::coo_matrix<int, float, cusp::device_memory> >(A);
+    CompareMatrixVectorMultiplyL2Persistence< cusp::csr_matrix<int, float, cusp::device_memory> >(A);
+    CompareMatrixVectorMultiplyL2Persistence< cusp::ell_matrix<int, float, cusp::device_memory> >(A);
+    CompareMatrixVectorMultiplyL2Persistence< cusp::hyb_matrix<int, float, cusp::device_memory> >(A);
+}
+DECLARE_UNITTEST(TestMatrixVectorMultiplyL2Persistence);
+
+// y = S x computed on the host from the entries of S
+void ReferenceMatrixVectorMultiply(const cusp::coo_matrix<int, float, cusp::host_memory>& S,
+                                   cusp::array1d<float, cusp::host_memory>& x,
+                                   cusp::array1d<float, cusp::host_memory>& y)
+{
+    x.resize(S.num_cols);
+    for(size_t i = 0; i < x.size(); i++)
+        x[i] = int(i % 7) - 3;
+
+    y.resize(S.num_rows);
+    thrust::fill(y.begin(), y.end(), 0.0f);
+    for(size_t n = 0; n < S.num_entries; n++)
+        y[S.row_indices[n]] += S.values[n] * x[S.column_indices[n]];
+}
+
+void CompareEllMatrixVectorMultiplyWidths(const cusp::coo_matrix<int, float, cusp::host_memory>& S)
+{
+    cusp::array1d<float, cusp::host_memory> x, y;
+    ReferenceMatrixVectorMultiply(S, x, y);
+
+    cusp::array1d<float, cusp::device_memory> d_x(x);
+
+    // the width of the stencil, which has an unrolled kernel
+    cusp::ell_matrix<int, float, cusp::host_memory> A(S);
+    {
+        cusp::ell_matrix<int, float, cusp::device_memory> d_A(A);
+        cusp::array1d<float, cusp::device_memory> z(S.num_rows, 10);
+
+        cusp::multiply(d_A, d_x, z);
+        ASSERT_EQUAL(z, y);
+
+        cusp::spmv_cache_scope scope(cusp::texture_cache);
+        cusp::multiply(d_A, d_x, z);
+        ASSERT_EQUAL(z, y);
+    }
+
+    // one padding column more, which has the generic kernel unless it is listed too
+    const size_t width = A.column_indices.num_cols;
+    const int invalid_index = cusp::ell_matrix<int, float, cusp::host_memory>::invalid_index;
+
+    cusp::ell_matrix<int, float, cusp::host_memory> B(S.num_rows, S.num_cols, S.num_entries, width + 1);
+    for(size_t i = 0; i < S.num_rows; i++)
+    {
+        for(size_t n = 0; n < width; n++)
+        {
+            B.column_indices(i, n) = A.column_indices(i, n);
+            B.values(i, n)         = A.values(i, n);
+        }
+
+        B.column_indices(i, width) = invalid_index;
+        B.values(i, width)         = 0;
+    }
+
+    {
+        cusp::ell_matrix<int, float, cusp::device_memory> d_B(B);
+        cusp::array1d<float, cusp::device_memory> z(S.num_rows, 10);
+
+        cusp::multiply(d_B, d_x, z);
+        ASSERT_EQUAL(z, y);
+    }
+}
+
+void TestEllMatrixVectorMultiplyUnrolledWidths(void)
+{
+    cusp::coo_matrix<int, float, cusp::host_memory> A;
+
+    cusp::gallery::poisson5pt(A, 30, 20);
+    CompareEllMatrixVectorMultiplyWidths(A);
+
+    cusp::gallery::poisson9pt(A, 30, 20);
+    CompareEllMatrixVectorMultiplyWidths(A);
+
+    cusp::gallery::poisson7pt(A, 10, 8, 6);
+    CompareEllMatrixVectorMultiplyWidths(A);
+
+    cusp::gallery::poisson27pt(A, 10, 8, 6);
+    CompareEllMatrixVectorMultiplyWidths(A);
+}
+DECLARE_UNITTEST(TestEllMatrixVectorMultiplyUnrolledWidths);
+
+void TestBsrMatrixVectorMultiplyUnrolledSizes(void)
+{
+    cusp::coo_matrix<int, float, cusp::host_memory> S;
+    cusp::gallery::poisson5pt(S, 28, 14);
+
+    cusp::array1d<float, cusp::host_memory> x, y;
+    ReferenceMatrixVectorMultiply(S, x, y);
+
+    cusp::csr_matrix<int, float, cusp::device_memory> A(S);
+    cusp::array1d<float, cusp::device_memory> d_x(x);
+
+    // unrolled sizes and, for 7 and 8, the generic kernel
+    const size_t sizes[5] = { 1, 2, 4, 7, 8 };
+
+    for(size_t k = 0; k < 5; k++)
+    {
+        cusp::bsr_matrix<int, float, cusp::device_memory> B(A, sizes[k]);
+        cusp::array1d<float, cusp::device_memory> z(S.num_rows, 10);
+
+        cusp::multiply(B, d_x, z);
+        ASSERT_ALMOST_EQUAL(z, y);
+    }
+}
+DECLARE_UNITTEST(TestBsrMatrixVectorMultiplyUnrolledSizes);
+
+
+template <typename SparseMatrixType>
+void CompareCompensatedMatrixVectorMultiply(const cusp::coo_matrix<int, float, cusp::host_memory>& S)
+{
+    typedef typename SparseMatrixType::memory_space MemorySpace;
+
+    SparseMatrixType A(S);
+    cusp::array1d<float, MemorySpace> x(S.num_cols, 1.0f);
+    cusp::array1d<float, MemorySpace> y(S.num_rows, 10.0f);
+
+    cusp::reduction_scope scope(cusp::compensated_reduction);
+
+    cusp::multiply(A, x, y);
+
+    // every (1e8, 1, -1e8) triple adds exactly 1
+    for(size_t i = 0; i < S.num_rows; i++)
+        ASSERT_EQUAL(float(y[i]), float(1 + i % 20));
+}
+
+template <class MemorySpace>
+void TestCompensatedMatrixVectorMultiply(void)
+{
+    // rows of 1 to 20 triples whose plain float sums lose the small terms
+    const int num_rows = 64;
+
+    cusp::coo_matrix<int, float, cusp::host_memory> S;
+    S.resize(num_rows, 60, 3 * 20 * num_rows);
+
+    size_t n = 0;
+    for(int i = 0; i < num_rows; i++)
+        for(int t = 0; t < 1 + i % 20; t++)
+        {
+            S.row_indices[n] = i; S.column_indices[n] = 3 * t + 0; S.values[n] =  1e8f; n++;
+            S.row_indices[n] = i; S.column_indices[n] = 3 * t + 1; S.values[n] =  1.0f; n++;
+            S.row_indices[n] = i; S.column_indices[n] = 3 * t + 2; S.values[n] = -1e8f; n++;
+        }
+    S.resize(num_rows, 60, n);
+
+    CompareCompensatedMatrixVectorMultiply< cusp::csr_matrix<int, float, MemorySpace> >(S);
+    CompareCompensatedMatrixVectorMultiply< cusp::ell_matrix<int, float, MemorySpace> >(S);
+
+    ASSERT_EQUAL(cusp::current_reduction_mode(), cusp::fast_reduction);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestCompensatedMatrixVectorMultiply);
+
+void TestCooMatrixVectorMultiplyTiles(void)
+{
+    // rows which span several tiles of the COO kernel, rows which end at
+    // tile boundaries and empty rows between them
+    const size_t lengths[] = {256, 0, 256, 1000, 1, 255, 2, 0, 0, 3000, 7, 512, 31, 33, 0, 600};
+    const size_t num_lengths = sizeof(lengths) / sizeof(size_t);
+
+    std::vector<int> I;
+    for(size_t n = 0; n < 3; n++)
+        for(size_t i = 0; i < num_lengths; i++)
+            I.insert(I.end(), lengths[i], int(n * num_lengths + i));
+
+    const int N = 3 * num_lengths;
+
+    cusp::coo_matrix<int, float, cusp::host_memory> A(N, 4000, I.size());
+    for(size_t n = 0; n < I.size(); n++)
+    {
+        A.row_indices[n]    = I[n];
+        A.column_indices[n] = n % 4000;
+        A.values[n]         = int(n % 5) - 2;
+    }
+    A.sort_by_row_and_column();
+
+    cusp::array1d<float, cusp::host_memory> x(A.num_cols);
+    for(size_t i = 0; i < x.size(); i++)
+        x[i] = int(i % 7) - 3;
+
+    cusp::array1d<float, cusp::host_memory> y(A.num_rows, 0);
+    for(size_t n = 0; n < A.num_entries; n++)
+        y[A.row_indices[n]] += A.values[n] * x[A.column_indices[n]];
+
+    cusp::array1d<float, cusp::device_memory> d_x(x);
+
+    {
+        cusp::coo_matrix<int, float, cusp::device_memory> B(A);
+        cusp::array1d<float, cusp::device_memory> z(A.num_rows, 10);
+        cusp::multiply(B, d_x, z);
+        ASSERT_EQUAL(z, y);
+    }
+
+    {
+        cusp::hyb_matrix<int, float, cusp::device_memory> B(A);
+        cusp::array1d<float, cusp::device_memory> z(A.num_rows, 10);
+        cusp::multiply(B, d_x, z);
+        ASSERT_EQUAL(z, y);
+    }
+}
+DECLARE_UNITTEST(TestCooMatrixVectorMultiplyTiles);
+
+// the first width entries of each row go to the ELL part, the rest to the COO part
+void SplitHybMatrix(const cusp::csr_matrix<int, float, cusp::host_memory>& A, const size_t width,
+                    cusp::hyb_matrix<int, float, cusp::host_memory>& B)
+{
+    size_t num_ell_entries = 0;
+    for(size_t i = 0; i < A.num_rows; i++)
+        num_ell_entries += std::min<size_t>(width, A.row_offsets[i + 1] - A.row_offsets[i]);
+
+    B.resize(A.num_rows, A.num_cols, num_ell_entries, A.num_entries - num_ell_entries, width);
+
+    const int invalid_index = cusp::ell_matrix<int, float, cusp::host_memory>::invalid_index;
+
+    size_t m = 0;
+    for(size_t i = 0; i < A.num_rows; i++)
+    {
+        for(size_t k = 0; k < width; k++)
+        {
+            B.ell.column_indices(i, k) = invalid_index;
+            B.ell.values(i, k)         = 0;
+        }
+
+        for(int n = A.row_offsets[i], k = 0; n < A.row_offsets[i + 1]; n++, k++)
+        {
+            if (size_t(k) < width)
+            {
+                B.ell.column_indices(i, k) = A.column_indices[n];
+                B.ell.values(i, k)         = A.values[n];
+            }
+            else
+            {
+                B.coo.row_indices[m]    = i;
+                B.coo.column_indices[m] = A.column_indices[n];
+                B.coo.values[m]         = A.values[n];
+                m++;
+            }
+        }
+    }
+}
+
+void CompareHybMatrixVectorMultiplyFused(const cusp::csr_matrix<int, float, cusp::host_memory>& A, const size_t width)
+{
+    cusp::hyb_matrix<int, float, cusp::host_memory> H;
+    SplitHybMatrix(A, width, H);
+
+    cusp::hyb_matrix<int, float, cusp::device_memory> B(H);
+
+    // integer values keep every sum exact, whatever the order of the partial sums
+    cusp::array1d<float, cusp::device_memory> x(A.num_cols);
+    for(size_t i = 0; i < x.size(); i++)
+        x[i] = int(i % 7) - 3;
+
+    // the ELL and COO parts with separate kernels
+    cusp::array1d<float, cusp::device_memory> y(A.num_rows, 10);
+    cusp::array1d<float, cusp::device_memory> y_coo(A.num_rows, 10);
+    cusp::multiply(B.ell, x, y);
+    cusp::multiply(B.coo, x, y_coo);
+    cusp::blas::axpy(y_coo, y, 1.0f);
+
+    // both parts in one launch
+    cusp::array1d<float, cusp::device_memory> z(A.num_rows, 10);
+    cusp::multiply(B, x, z);
+
+    ASSERT_EQUAL(z, y);
+}
+
+void TestHybMatrixVectorMultiplyFused(void)
+{
+    // long rows cross the tiles of the COO part, which hold 256 entries
+    const size_t lengths[] = {3, 0, 700, 1, 2, 255, 0, 4, 1300, 5, 257, 2};
+    const size_t num_lengths = sizeof(lengths) / sizeof(size_t);
+
+    const size_t N = 40 * num_lengths;
+    const size_t M = 2000;
+
+    cusp::array1d<int, cusp::host_memory> row_offsets(N + 1, 0);
+    for(size_t i = 0; i < N; i++)
+        row_offsets[i + 1] = row_offsets[i] + lengths[i % num_lengths];
+
+    cusp::csr_matrix<int, float, cusp::host_memory> A(N, M, row_offsets[N]);
+    A.row_offsets = row_offsets;
+    for(size_t i = 0; i < N; i++)
+    {
+        for(int n = A.row_offsets[i]; n < A.row_offsets[i + 1]; n++)
+        {
+            A.column_indices[n] = (13 * i + 7 * (n - A.row_offsets[i])) % M;
+            A.values[n]         = int(n % 5) - 2;
+        }
+    }
+
+    // rows split between both parts
+    CompareHybMatrixVectorMultiplyFused(A, 2);
+
+    // an empty ELL part
+    CompareHybMatrixVectorMultiplyFused(A, 0);
+
+    // an empty COO part
+    CompareHybMatrixVectorMultiplyFused(A, 1300);
+}
+DECLARE_UNITTEST(TestHybMatrixVectorMultiplyFused);
+
+
+template <class MemorySpace>
+void TestSparseMatrixVectorMultiplyTranspose(void)
+{
+    // rectangular, with empty rows and columns
+    cusp::coo_matrix<int, float, cusp::host_memory> A;
+    cusp::gallery::random(50, 30, 200, A);
+    A.sort_by_row_and_column();
+
+    cusp::coo_matrix<int, float, cusp::host_memory> At;
+    cusp::transpose(A, At);
+
+    cusp::array1d<float, cusp::host_memory> x(A.num_rows);
+    for(size_t i = 0; i < x.size(); i++)
+        x[i] = int(i % 7) - 3;
+
+    cusp::array1d<float, cusp::host_memory> y(A.num_cols);
+    cusp::multiply(At, x, y);
+
+    cusp::array1d<float, MemorySpace> d_x(x);
+
+    {
+        cusp::coo_matrix<int, float, MemorySpace> B(A);
+        cusp::array1d<float, MemorySpace> z(A.num_cols, 10);
+        cusp::multiply_transpose(B, d_x, z);
+        ASSERT_ALMOST_EQUAL((cusp::array1d<float, cusp::host_memory>(z)), y);
+    }
+
+    {
+        cusp::csr_matrix<int, float, MemorySpace> B(A);
+        cusp::array1d<float, MemorySpace> z(A.num_cols, 10);
+        cusp::multiply_transpose(B, d_x, z);
+        ASSERT_ALMOST_EQUAL((cusp::array1d<float, cusp::host_memory>(z)), y);
+    }
+
+    {
+        cusp::dia_matrix<int, float, MemorySpace> B(A);
+        cusp::array1d<float, MemorySpace> z(A.num_cols, 10);
+        cusp::multiply_transpose(B, d_x, z);
+        ASSERT_ALMOST_EQUAL((cusp::array1d<float, cusp::host_memory>(z)), y);
+    }
+
+    {
+        cusp::ell_matrix<int, float, MemorySpace> B(A);
+        cusp::array1d<float, MemorySpace> z(A.num_cols, 10);
+        cusp::multiply_transpose(B, d_x, z);
+        ASSERT_ALMOST_EQUAL((cusp::array1d<float, cusp::host_memory>(z)), y);
+    }
+
+    {
+        cusp::array2d<float, MemorySpace, cusp::row_major> B(A);
+        cusp::array1d<float, MemorySpace> z(A.num_cols, 10);
+        cusp::multiply_transpose(B, d_x, z);
+        ASSERT_ALMOST_EQUAL((cusp::array1d<float, cusp::host_memory>(z)), y);
+    }
+
+    {
+        cusp::array2d<float, MemorySpace, cusp::column_major> B(A);
+        cusp::array1d<float, MemorySpace> z(A.num_cols, 10);
+        cusp::multiply_transpose(B, d_x, z);
+        ASSERT_ALMOST_EQUAL((cusp::array1d<float, cusp::host_memory>(z)), y);
+    }
+
+    {
+        cusp::sell_matrix<int, float, MemorySpace> B(A);
+        cusp::array1d<float, MemorySpace> z(A.num_cols, 10);
+        cusp::multiply_transpose(B, d_x, z);
+        ASSERT_ALMOST_EQUAL((cusp::array1d<float, cusp::host_memory>(z)), y);
+    }
+
+    // the flag of multiply and transposed_operator
+    {
+        cusp::csr_matrix<int, float, MemorySpace> B(A);
+        cusp::array1d<float, MemorySpace> z(A.num_cols, 10);
+        cusp::multiply(B, d_x, z, true);
+        ASSERT_ALMOST_EQUAL((cusp::array1d<float, cusp::host_memory>(z)), y);
+
+        cusp::array1d<float, MemorySpace> d_w(A.num_cols, 1);
+        cusp::array1d<float, MemorySpace> w(A.num_rows, 10);
+        cusp::multiply(B, d_w, w, false);
+        cusp::array1d<float, MemorySpace> v(A.num_rows, 10);
+        cusp::multiply(B, d_w, v);
+        ASSERT_EQUAL(w, v);
+
+        cusp::transposed_operator< cusp::csr_matrix<int, float, MemorySpace> > Bt(B);
+        ASSERT_EQUAL(Bt.num_rows, A.num_cols);
+        ASSERT_EQUAL(Bt.num_cols, A.num_rows);
+
+        cusp::blas::fill(z, 10);
+        cusp::multiply(Bt, d_x, z);
+        ASSERT_ALMOST_EQUAL((cusp::array1d<float, cusp::host_memory>(z)), y);
+
+        cusp::identity_operator<float, MemorySpace> I(A.num_rows, A.num_rows);
+        cusp::array1d<float, MemorySpace> u(A.num_rows);
+        ASSERT_THROWS(cusp::multiply(I, d_x, u, true), cusp::not_implemented_exception);
+    }
+
+    {
+        cusp::hyb_matrix<int, float, MemorySpace> B(A);
+        cusp::array1d<float, MemorySpace> z(A.num_cols, 10);
+        cusp::multiply_transpose(B, d_x, z);
+        ASSERT_ALMOST_EQUAL((cusp::array1d<float, cusp::host_memory>(z)), y);
+    }
+
+    // the vector sizes are those of A^T
+    {
+        cusp::coo_matrix<int, float, MemorySpace> B(A);
+        cusp::array1d<float, MemorySpace> z(A.num_rows, 10);
+        ASSERT_THROWS(cusp::multiply_transpose(B, d_x, z), cusp::invalid_input_exception);
+    }
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestSparseMatrixVectorMultiplyTranspose);
+
+
+/////////////////////////////////
+// Dense Matrix-Vector Multiply //
+/////////////////////////////////
+
+template <class MemorySpace, class Orientation>
+void CompareDenseMatrixVectorMultiply(const cusp::array2d<float,cusp::host_memory>& A)
+{
+    cusp::array1d<float,cusp::host_memory> x(A.num_cols);
+    for(size_t i = 0; i < x.size(); i++)
+        x[i] = float((i % 5) + 1);
+
+    cusp::array1d<float,cusp::host_memory> expected(A.num_rows);
+    cusp::multiply(A, x, expected);
+
+    cusp::array2d<float,MemorySpace,Orientation> M(A);
+    cusp::array1d<float,MemorySpace> d_x(x);
+    cusp::array1d<float,MemorySpace> d_y(A.num_rows, -1.0f);
+
+    cusp::multiply(M, d_x, d_y);
+
+    ASSERT_ALMOST_EQUAL(d_y, expected);
+}
+
+template <class MemorySpace>
+void TestDenseMatrixVectorMultiply(void)
+{
+    cusp::array2d<float,cusp::host_memory> A;
+    cusp::gallery::random(37, 50, 400, A);
+
+    CompareDenseMatrixVectorMultiply<MemorySpace,cusp::row_major>(A);
+    CompareDenseMatrixVectorMultiply<MemorySpace,cusp::column_major>(A);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestDenseMatrixVectorMultiply);
+
 
 //////////////////////////////
 // General Linear Operators //
@@ -0,0 +1,104 @@
+#include <unittest/unittest.h>
+
+#include <cusp/io/out_of_core.h>
+#include <cusp/io/binary.h>
+#include <cusp/io/matrix_market.h>
+
+#include <cusp/coo_matrix.h>
+#include <cusp/csr_matrix.h>
+#include <cusp/gallery/random.h>
+
+#include <fstream>
+#include <stdio.h>
+
+const char out_of_core_mtx_name[] = "test_73104962385517.mtx";
+const char out_of_core_bin_name[] = "test_73104962385517.bin";
+
+template <typename IndexType, typename ValueType>
+void CompareOutOfCoreAssembly(size_t max_memory)
+{
+  cusp::io::convert_matrix_market_to_binary<IndexType, ValueType>(out_of_core_mtx_name, out_of_core_bin_name, max_memory);
+
+  cusp::csr_matrix<IndexType, ValueType, cusp::host_memory> A;
+  cusp::io::read_matrix_market_file(A, out_of_core_mtx_name);
+
+  cusp::csr_matrix<IndexType, ValueType, cusp::host_memory> B;
+  cusp::io::read_binary_file(B, out_of_core_bin_name);
+
+  remove(out_of_core_bin_name);
+
+  ASSERT_EQUAL(B.num_rows,    A.num_rows);
+  ASSERT_EQUAL(B.num_cols,    A.num_cols);
+  ASSERT_EQUAL(B.num_entries, A.num_entries);
+  ASSERT_EQUAL(B.row_offsets,    A.row_offsets);
+  ASSERT_EQUAL(B.column_indices, A.column_indices);
+  ASSERT_EQUAL(B.values,         A.values);
+}
+
+void TestConvertMatrixMarketToBinaryGeneral(void)
+{
+  cusp::coo_matrix<int, float, cusp::host_memory> A;
+  cusp::gallery::random(250, 180, 3000, A);
+
+  // leave some rows empty
+  for (size_t n = 0; n < A.num_entries; n++)
+    if (A.row_indices[n] % 7 == 3)
+      A.row_indices[n]--;
+
+  cusp::io::write_matrix_market_file(A, out_of_core_mtx_name);
+
+  // a single run, and many runs merged together
+  CompareOutOfCoreAssembly<int, float>(size_t(1) << 30);
+  CompareOutOfCoreAssembly<int, float>(2048);
+  CompareOutOfCoreAssembly<long long, double>(1);
+
+  remove(out_of_core_mtx_name);
+}
+DECLARE_UNITTEST(TestConvertMatrixMarketToBinaryGeneral);
+
+void TestConvertMatrixMarketToBinarySymmetric(void)
+{
+  {
+    std::ofstream file(out_of_core_mtx_name);
+    file << "%%MatrixMarket matrix coordinate real symmetric\n";
+    file << "% comment\n";
+    file << "6 6 9\n";
+    for (int i = 1; i <= 6; i++)
+      file << i << " " << i << " " << 2 * i << "\n";
+    file << "4 1 -1.5\n";
+    file << "% comment between entries\n";
+    file << "6 2 0.25\n";
+    file << "5 4 3\n";
+  }
+
+  CompareOutOfCoreAssembly<int, float>(size_t(1) << 30);
+  CompareOutOfCoreAssembly<int, float>(64);
+
+  // the result is a CSR file
+  cusp::io::convert_matrix_market_to_binary<int, float>(out_of_core_mtx_name, out_of_core_bin_name, 64);
+
+  {
+    cusp::io::binary_file file(out_of_core_bin_name);
+    ASSERT_EQUAL(file.num_entries(), 12);
+
+    cusp::io::binary_file::csr_view<int, float>::type V = file.make_csr_view<int, float>();
+    ASSERT_EQUAL(V.row_offsets[0], 0);
+    ASSERT_EQUAL(V.row_offsets[1], 2);
+    ASSERT_EQUAL(V.column_indices[1], 3);
+    ASSERT_EQUAL(V.values[1], -1.5f);
+  }
+
+  remove(out_of_core_bin_name);
+
+  // array files cannot be assembled
+  {
+    std::ofstream file(out_of_core_mtx_name);
+    file << "%%MatrixMarket matrix array real general\n";
+    file << "2 1\n1\n2\n";
+  }
+
+  ASSERT_THROWS((cusp::io::convert_matrix_market_to_binary<int, float>(out_of_core_mtx_name, out_of_core_bin_name)), cusp::io_exception);
+
+  remove(out_of_core_mtx_name);
+}
+DECLARE_UNITTEST(TestConvertMatrixMarketToBinarySymmetric);
@@ -0,0 +1,179 @@
+#include <unittest/unittest.h>
+
+#include <cusp/graph/pagerank.h>
+
+#include <cusp/array1d.h>
+#include <cusp/array2d.h>
+#include <cusp/coo_matrix.h>
+#include <cusp/csr_matrix.h>
+
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+// power iteration with the normalized matrix formed explicitly
+std::vector<double> reference_pagerank(const cusp::array2d<int,cusp::host_memory>& A,
+                                       const std::vector<double>& personalization,
+                                       const double damping)
+{
+    const int N = A.num_rows;
+
+    double total = 0;
+    for (int i = 0; i < N; i++)
+        total += personalization[i];
+
+    std::vector<double> v(N), x(N), y(N);
+    for (int i = 0; i < N; i++)
+        v[i] = x[i] = personalization[i] / total;
+
+    std::vector<int> degree(N, 0);
+    for (int i = 0; i < N; i++)
+        for (int j = 0; j < N; j++)
+            degree[i] += A(i,j) != 0;
+
+    for (int iteration = 0; iteration < 1000; iteration++)
+    {
+        double dangling = 0;
+        for (int i = 0; i < N; i++)
+            if (degree[i] == 0)
+                dangling += x[i];
+
+        for (int i = 0; i < N; i++)
+            y[i] = (1 - damping + damping * dangling) * v[i];
+
+        for (int i = 0; i < N; i++)
+            for (int j = 0; j < N; j++)
+                if (A(i,j) != 0)
+                    y[j] += damping * x[i] / degree[i];
+
+        x.swap(y);
+    }
+
+    return x;
+}
+
+// directed graph in which every seventh vertex is dangling
+void random_graph(cusp::array2d<int,cusp::host_memory>& A, const int N)
+{
+    A.resize(N, N);
+
+    srand(11);
+    for (int i = 0; i < N; i++)
+        for (int j = 0; j < N; j++)
+            A(i,j) = (i % 7 != 3 && i != j && rand() % 6 == 0) ? 1 : 0;
+}
+
+template <typename Array>
+void check_ranks(const Array& ranks, const std::vector<double>& expected)
+{
+    cusp::array1d<double,cusp::host_memory> x(ranks);
+
+    ASSERT_EQUAL(x.size(), expected.size());
+
+    double sum = 0;
+    for (size_t i = 0; i < x.size(); i++)
+    {
+        ASSERT_EQUAL(std::abs(x[i] - expected[i]) < 1e-8, true);
+        sum += x[i];
+    }
+
+    ASSERT_EQUAL(std::abs(sum - 1.0) < 1e-8, true);
+}
+
+template <class MemorySpace>
+void TestPageRank(void)
+{
+    const int N = 50;
+
+    cusp::array2d<int,cusp::host_memory> A;
+    random_graph(A, N);
+
+    cusp::csr_matrix<int,float,MemorySpace> G(A);
+    cusp::array1d<double,MemorySpace> ranks;
+
+    const size_t iterations = cusp::graph::pagerank(G, ranks, 0.85, 1e-12, 1000);
+
+    ASSERT_EQUAL(iterations > 1, true);
+    ASSERT_EQUAL(iterations < 1000, true);
+
+    check_ranks(ranks, reference_pagerank(A, std::vector<double>(N, 1.0), 0.85));
+
+    // other formats, and a damping of zero leaves the jump vector
+    cusp::coo_matrix<int,float,MemorySpace> G_coo(A);
+
+    cusp::graph::pagerank(G_coo, ranks, 0.5, 1e-12, 1000);
+    check_ranks(ranks, reference_pagerank(A, std::vector<double>(N, 1.0), 0.5));
+
+    cusp::graph::pagerank(G_coo, ranks, 0.0);
+    check_ranks(ranks, std::vector<double>(N, 1.0 / N));
+
+    // invalid arguments
+    ASSERT_THROWS(cusp::graph::pagerank(G, ranks, 1.0), cusp::invalid_input_exception);
+
+    cusp::csr_matrix<int,float,MemorySpace> R(4, 5, 0);
+    ASSERT_THROWS(cusp::graph::pagerank(R, ranks), cusp::invalid_input_exception);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestPageRank);
+
+template <class MemorySpace>
+void TestPersonalizedPageRank(void)
+{
+    const int N = 40;
+    const int K = 3;
+
+    cusp::array2d<int,cusp::host_memory> A;
+    random_graph(A, N);
+
+    cusp::csr_matrix<int,float,MemorySpace> G(A);
+
+    // one vector jumping to a single vertex, the others weighted
+    cusp::array2d<double,cusp::host_memory,cusp::row_major> P(N, K, 0.0);
+    P(5, 0) = 1.0;
+    for (int i = 0; i < N; i++)
+    {
+        P(i, 1) = i % 4;
+        P(i, 2) = 1.0 + i;
+    }
+
+    std::vector< std::vector<double> > expected(K);
+    for (int k = 0; k < K; k++)
+    {
+        std::vector<double> p(N);
+        for (int i = 0; i < N; i++)
+            p[i] = P(i, k);
+
+        expected[k] = reference_pagerank(A, p, 0.85);
+
+        // a single vector
+        cusp::array1d<double,MemorySpace> personalization(p.begin(), p.end());
+        cusp::array1d<double,MemorySpace> ranks;
+
+        cusp::graph::personalized_pagerank(G, personalization, ranks, 0.85, 1e-12, 1000);
+        check_ranks(ranks, expected[k]);
+    }
+
+    // all vectors at once
+    cusp::array2d<double,MemorySpace,cusp::row_major> personalization(P);
+    cusp::array2d<double,MemorySpace,cusp::row_major> ranks;
+
+    cusp::graph::personalized_pagerank(G, personalization, ranks, 0.85, 1e-12, 1000);
+
+    ASSERT_EQUAL(ranks.num_rows, size_t(N));
+    ASSERT_EQUAL(ranks.num_cols, size_t(K));
+
+    cusp::array2d<double,cusp::host_memory,cusp::column_major> X(ranks);
+    for (int k = 0; k < K; k++)
+        check_ranks(X.column(k), expected[k]);
+
+    // invalid personalization vectors
+    cusp::array1d<double,MemorySpace> zero(N, 0.0);
+    cusp::array1d<double,MemorySpace> negative(N, 1.0);
+    cusp::array1d<double,MemorySpace> short_vector(N - 1, 1.0);
+    cusp::array1d<double,MemorySpace> x;
+    negative[2] = -1.0;
+
+    ASSERT_THROWS(cusp::graph::personalized_pagerank(G, zero, x), cusp::invalid_input_exception);
+    ASSERT_THROWS(cusp::graph::personalized_pagerank(G, negative, x), cusp::invalid_input_exception);
+    ASSERT_THROWS(cusp::graph::personalized_pagerank(G, short_vector, x), cusp::invalid_input_exception);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestPersonalizedPageRank);
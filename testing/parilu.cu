@@ -0,0 +1,179 @@
+#include <unittest/unittest.h>
+
+#include <cusp/precond/parilu.h>
+#include <cusp/precond/ilu.h>
+#include <cusp/precond/aggregation/smoothed_aggregation.h>
+
+#include <cusp/gallery/poisson.h>
+#include <cusp/krylov/bicgstab.h>
+#include <cusp/krylov/cg.h>
+#include <cusp/monitor.h>
+#include <cusp/multiply.h>
+
+template <typename Matrix>
+void initialize_parilu_tridiagonal(Matrix& A, int N)
+{
+    cusp::coo_matrix<int,float,cusp::host_memory> T(N, N, 3 * N - 2);
+
+    int n = 0;
+    for(int i = 0; i < N; i++)
+    {
+        if(i > 0)
+        {
+            T.row_indices[n] = i;  T.column_indices[n] = i - 1;  T.values[n] = -1.0f - 0.5f * (i % 2);  n++;
+        }
+
+        T.row_indices[n] = i;  T.column_indices[n] = i;  T.values[n] = 5.0f;  n++;
+
+        if(i + 1 < N)
+        {
+            T.row_indices[n] = i;  T.column_indices[n] = i + 1;  T.values[n] = -2.0f;  n++;
+        }
+    }
+
+    A = T;
+}
+
+template <class Space>
+void TestParILUFixedPoint(void)
+{
+    cusp::csr_matrix<int,float,Space> A;
+    cusp::gallery::poisson5pt(A, 6, 6);
+
+    // enough sweeps reach the fixed point, which is the ILU(0) factorization
+    cusp::precond::ilu0<float,Space>   M(A);
+    cusp::precond::parilu<float,Space> N(A, 40, 3);
+
+    ASSERT_EQUAL(N.L.strict.num_entries, M.L.strict.num_entries);
+    ASSERT_EQUAL(N.U.strict.num_entries, M.U.strict.num_entries);
+    ASSERT_EQUAL(N.L.iterations, 3);
+
+    cusp::array1d<float,cusp::host_memory> L_values(M.L.strict.values);
+    cusp::array1d<float,cusp::host_memory> U_values(M.U.strict.values);
+    cusp::array1d<float,cusp::host_memory> U_inv_diagonal(M.U.inv_diagonal);
+
+    ASSERT_ALMOST_EQUAL(L_values,       (cusp::array1d<float,cusp::host_memory>(N.L.strict.values)));
+    ASSERT_ALMOST_EQUAL(U_values,       (cusp::array1d<float,cusp::host_memory>(N.U.strict.values)));
+    ASSERT_ALMOST_EQUAL(U_inv_diagonal, (cusp::array1d<float,cusp::host_memory>(N.U.inv_diagonal)));
+
+    // and likewise for IC(0)
+    cusp::precond::ic0<float,Space>   P(A);
+    cusp::precond::paric<float,Space> Q(A, 40, 3);
+
+    cusp::array1d<float,cusp::host_memory> IC_values(P.L.strict.values);
+    cusp::array1d<float,cusp::host_memory> IC_inv_diagonal(P.L.inv_diagonal);
+
+    ASSERT_ALMOST_EQUAL(IC_values,       (cusp::array1d<float,cusp::host_memory>(Q.L.strict.values)));
+    ASSERT_ALMOST_EQUAL(IC_inv_diagonal, (cusp::array1d<float,cusp::host_memory>(Q.L.inv_diagonal)));
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestParILUFixedPoint);
+
+template <class Space>
+void TestParILUJacobiSolves(void)
+{
+    cusp::csr_matrix<int,float,Space> A;
+    initialize_parilu_tridiagonal(A, 10);
+
+    // the exact factorization with as many Jacobi iterations as levels
+    // solves exactly
+    cusp::precond::parilu<float,Space> M(A, 20, 10);
+
+    cusp::array1d<float,cusp::host_memory> x(10);
+    for(size_t i = 0; i < x.size(); i++)
+        x[i] = int(i % 5) - 2;
+
+    cusp::array1d<float,Space> d_x(x);
+    cusp::array1d<float,Space> b(10);
+    cusp::array1d<float,Space> y(10, 10.0f);
+
+    cusp::multiply(A, d_x, b);
+    M(b, y);
+
+    cusp::array1d<float,cusp::host_memory> h_y(y);
+    ASSERT_ALMOST_EQUAL(h_y, x);
+
+    // the factors are the same in both memory spaces
+    cusp::csr_matrix<int,float,cusp::host_memory> H(A);
+    cusp::precond::parilu<float,cusp::host_memory> N(H, 2, 2);
+    cusp::precond::parilu<float,Space>             P(A, 2, 2);
+
+    ASSERT_ALMOST_EQUAL(N.L.strict.values, (cusp::array1d<float,cusp::host_memory>(P.L.strict.values)));
+    ASSERT_ALMOST_EQUAL(N.U.strict.values, (cusp::array1d<float,cusp::host_memory>(P.U.strict.values)));
+
+    // copy to another memory space
+    cusp::precond::parilu<float,cusp::host_memory> C(P);
+    ASSERT_EQUAL(C.U.iterations, 2);
+    ASSERT_EQUAL(C.num_rows, 10);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestParILUJacobiSolves);
+
+template <class Space>
+void TestParILUPreconditionedSolvers(void)
+{
+    cusp::csr_matrix<int,float,Space> A;
+    cusp::gallery::poisson5pt(A, 32, 32);
+
+    cusp::array1d<float,Space> b = unittest::random_samples<float>(A.num_rows);
+
+    size_t unpreconditioned;
+    {
+        cusp::array1d<float,Space> x(A.num_rows, 0.0f);
+        cusp::default_monitor<float> monitor(b, 500, 1e-5);
+        cusp::krylov::cg(A, x, b, monitor);
+        ASSERT_EQUAL(monitor.converged(), true);
+        unpreconditioned = monitor.iteration_count();
+    }
+
+    {
+        cusp::precond::paric<float,Space> M(A);
+        cusp::array1d<float,Space> x(A.num_rows, 0.0f);
+        cusp::default_monitor<float> monitor(b, 500, 1e-5);
+        cusp::krylov::cg(A, x, b, monitor, M);
+        ASSERT_EQUAL(monitor.converged(), true);
+        ASSERT_EQUAL(monitor.iteration_count() < unpreconditioned, true);
+    }
+
+    {
+        cusp::precond::parilu<float,Space> M(A);
+        cusp::array1d<float,Space> x(A.num_rows, 0.0f);
+        cusp::default_monitor<float> monitor(b, 500, 1e-5);
+        cusp::krylov::bicgstab(A, x, b, monitor, M);
+        ASSERT_EQUAL(monitor.converged(), true);
+    }
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestParILUPreconditionedSolvers);
+
+template <class Space>
+void TestParILUSmoother(void)
+{
+    typedef cusp::precond::paric<float,Space> Smoother;
+
+    cusp::coo_matrix<int,float,Space> A;
+    cusp::gallery::poisson5pt(A, 50, 50);
+
+    cusp::array1d<float,Space> b = unittest::random_samples<float>(A.num_rows);
+    cusp::array1d<float,Space> x(A.num_rows, 0.0f);
+
+    cusp::precond::aggregation::smoothed_aggregation<int,float,Space,Smoother> M(A);
+
+    cusp::default_monitor<float> monitor(b, 30, 1e-5);
+    cusp::krylov::cg(A, x, b, monitor, M);
+
+    ASSERT_EQUAL(monitor.converged(), true);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestParILUSmoother);
+
+void TestParILUInvalidInput(void)
+{
+    cusp::coo_matrix<int,float,cusp::host_memory> A(2, 2, 3);
+    A.row_indices[0] = 0;  A.column_indices[0] = 0;  A.values[0] = 1.0f;
+    A.row_indices[1] = 0;  A.column_indices[1] = 1;  A.values[1] = 1.0f;
+    A.row_indices[2] = 1;  A.column_indices[2] = 0;  A.values[2] = 1.0f;
+
+    ASSERT_THROWS((cusp::precond::parilu<float,cusp::host_memory>(A)), cusp::invalid_input_exception);
+    ASSERT_THROWS((cusp::precond::paric<float,cusp::host_memory>(A)),  cusp::invalid_input_exception);
+
+    cusp::coo_matrix<int,float,cusp::host_memory> B(2, 3, 0);
+    ASSERT_THROWS((cusp::precond::parilu<float,cusp::host_memory>(B)), cusp::invalid_input_exception);
+}
+DECLARE_UNITTEST(TestParILUInvalidInput);
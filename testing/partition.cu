@@ -0,0 +1,103 @@
+#include <unittest/unittest.h>
+
+#include <cusp/graph/partition.h>
+
+#include <cusp/coo_matrix.h>
+#include <cusp/csr_matrix.h>
+#include <cusp/gallery/poisson.h>
+
+#include <cmath>
+#include <vector>
+
+// check the parts, their balance and the reported edge cut of a partition
+template <typename MatrixType, typename ArrayType>
+void check_partition(const MatrixType& G, size_t num_parts, const ArrayType& parts, size_t cut, float imbalance)
+{
+    cusp::coo_matrix<int,float,cusp::host_memory> A(G);
+    cusp::array1d<int,cusp::host_memory> P(parts);
+
+    ASSERT_EQUAL(P.size(), A.num_rows);
+
+    std::vector<size_t> weights(num_parts, 0);
+    for(size_t i = 0; i < P.size(); i++)
+    {
+        ASSERT_EQUAL(P[i] >= 0 && P[i] < int(num_parts), true);
+        weights[P[i]]++;
+    }
+
+    size_t max_weight = std::ceil((1.0 + imbalance) * A.num_rows / num_parts);
+    for(size_t p = 0; p < num_parts; p++)
+        ASSERT_EQUAL(weights[p] <= max_weight, true);
+
+    size_t num_cut = 0;
+    for(size_t n = 0; n < A.num_entries; n++)
+        if(P[A.row_indices[n]] != P[A.column_indices[n]])
+            num_cut++;
+
+    ASSERT_EQUAL(num_cut / 2, cut);
+}
+
+template <class MemorySpace>
+void TestPartition(void)
+{
+    cusp::csr_matrix<int,float,MemorySpace> G;
+    cusp::gallery::poisson5pt(G, 32, 32);
+
+    cusp::array1d<int,MemorySpace> parts;
+
+    // four quadrants cut 64 of the 1984 edges and a random assignment 1488
+    size_t cut = cusp::graph::partition(G, 4, parts);
+    check_partition(G, 4, parts, cut, 0.03f);
+    ASSERT_EQUAL(cut < 250, true);
+
+    cut = cusp::graph::partition(G, 7, parts, 0.1f);
+    check_partition(G, 7, parts, cut, 0.1f);
+    ASSERT_EQUAL(cut < 450, true);
+
+    cut = cusp::graph::partition(cusp::coo_matrix<int,float,MemorySpace>(G), 2, parts);
+    check_partition(G, 2, parts, cut, 0.03f);
+    ASSERT_EQUAL(cut < 100, true);
+
+    // a single part
+    cut = cusp::graph::partition(G, 1, parts);
+    ASSERT_EQUAL(cut, 0);
+    ASSERT_EQUAL(parts, (cusp::array1d<int,MemorySpace>(G.num_rows, 0)));
+
+    ASSERT_THROWS(cusp::graph::partition(G, 0, parts), cusp::invalid_input_exception);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestPartition);
+
+template <class MemorySpace>
+void TestPartitionDisconnected(void)
+{
+    // two grids and isolated vertices
+    cusp::coo_matrix<int,float,cusp::host_memory> A;
+    cusp::gallery::poisson5pt(A, 10, 10);
+
+    cusp::coo_matrix<int,float,cusp::host_memory> B(250, 250, 2 * A.num_entries);
+    for(size_t n = 0; n < A.num_entries; n++)
+    {
+        B.row_indices[n] = A.row_indices[n];
+        B.column_indices[n] = A.column_indices[n];
+        B.values[n] = A.values[n];
+
+        B.row_indices[A.num_entries + n] = A.row_indices[n] + 100;
+        B.column_indices[A.num_entries + n] = A.column_indices[n] + 100;
+        B.values[A.num_entries + n] = A.values[n];
+    }
+
+    cusp::csr_matrix<int,float,MemorySpace> G(B);
+    cusp::array1d<int,MemorySpace> parts;
+
+    size_t cut = cusp::graph::partition(G, 5, parts);
+    check_partition(G, 5, parts, cut, 0.03f);
+
+    // a graph without edges
+    cusp::csr_matrix<int,float,MemorySpace> H(40, 40, 0);
+    thrust::fill(H.row_offsets.begin(), H.row_offsets.end(), 0);
+
+    cut = cusp::graph::partition(H, 4, parts);
+    check_partition(H, 4, parts, cut, 0.03f);
+    ASSERT_EQUAL(cut, 0);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestPartitionDisconnected);
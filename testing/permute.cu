@@ -0,0 +1,160 @@
+#include <unittest/unittest.h>
+
+#include <cusp/permute.h>
+
+#include <cusp/array2d.h>
+#include <cusp/coo_matrix.h>
+#include <cusp/csr_matrix.h>
+#include <cusp/hyb_matrix.h>
+#include <cusp/gallery/poisson.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+// random N x M matrix with a dense row, longer than the rows sorted by
+// their own thread
+void random_permute_matrix(cusp::csr_matrix<int,float,cusp::host_memory>& A, const int N, const int M)
+{
+    cusp::array2d<float,cusp::host_memory> D(N, M, 0.0f);
+
+    srand(N + M);
+    for(int i = 0; i < N; i++)
+        for(int j = 0; j < M; j++)
+            if(i == 3 || rand() % 8 == 0)
+                D(i,j) = float(i * M + j + 1);
+
+    A = D;
+}
+
+// B(i,j) = A(rows[i], cols[j]) and the columns of every row are sorted
+template <typename MatrixType>
+void check_submatrix(const cusp::csr_matrix<int,float,cusp::host_memory>& A,
+                     const std::vector<int>& rows, const std::vector<int>& cols,
+                     const MatrixType& B)
+{
+    cusp::csr_matrix<int,float,cusp::host_memory> C(B);
+    cusp::array2d<float,cusp::host_memory> dense_A(A);
+    cusp::array2d<float,cusp::host_memory> dense_C(C);
+
+    ASSERT_EQUAL(C.num_rows, rows.size());
+    ASSERT_EQUAL(C.num_cols, cols.size());
+
+    for(size_t i = 0; i < rows.size(); i++)
+        for(size_t j = 0; j < cols.size(); j++)
+            ASSERT_EQUAL(dense_C(i,j), dense_A(rows[i], cols[j]));
+
+    for(size_t i = 0; i < C.num_rows; i++)
+        for(int k = C.row_offsets[i] + 1; k < C.row_offsets[i + 1]; k++)
+            ASSERT_EQUAL(C.column_indices[k - 1] < C.column_indices[k], true);
+}
+
+template <class Space>
+void TestSymmetricPermute(void)
+{
+    for(int N = 10; N <= 100; N += 90)
+    {
+        cusp::csr_matrix<int,float,cusp::host_memory> A;
+        random_permute_matrix(A, N, N);
+
+        std::vector<int> permutation(N);
+        for(int i = 0; i < N; i++)
+            permutation[i] = i;
+        std::random_shuffle(permutation.begin(), permutation.end());
+
+        cusp::array1d<int,Space> d_permutation(permutation.begin(), permutation.end());
+        cusp::csr_matrix<int,float,Space> d_A(A);
+
+        // CSR to CSR
+        cusp::csr_matrix<int,float,Space> B;
+        cusp::symmetric_permute(d_A, d_permutation, B);
+        ASSERT_EQUAL(B.num_entries, A.num_entries);
+        check_submatrix(A, permutation, permutation, B);
+
+        // other formats go through CSR
+        cusp::coo_matrix<int,float,Space> d_C(A);
+        cusp::hyb_matrix<int,float,Space> H;
+        cusp::symmetric_permute(d_C, permutation, H);
+        check_submatrix(A, permutation, permutation, H);
+    }
+
+    // the identity keeps the matrix
+    cusp::csr_matrix<int,float,Space> A;
+    cusp::gallery::poisson5pt(A, 5, 4);
+
+    cusp::array1d<int,Space> identity(A.num_rows);
+    for(size_t i = 0; i < A.num_rows; i++)
+        identity[i] = i;
+
+    cusp::csr_matrix<int,float,Space> B;
+    cusp::symmetric_permute(A, identity, B);
+
+    ASSERT_EQUAL(B.row_offsets,    A.row_offsets);
+    ASSERT_EQUAL(B.column_indices, A.column_indices);
+    ASSERT_EQUAL(B.values,         A.values);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestSymmetricPermute);
+
+template <class Space>
+void TestExtractSubmatrix(void)
+{
+    cusp::csr_matrix<int,float,cusp::host_memory> A;
+    random_permute_matrix(A, 30, 90);
+
+    cusp::csr_matrix<int,float,Space> d_A(A);
+
+    // repeated rows and unordered columns, with more than the rows sorted
+    // by their own thread in the dense row
+    std::vector<int> rows;
+    rows.push_back(3);  rows.push_back(17);  rows.push_back(3);  rows.push_back(0);  rows.push_back(29);
+
+    std::vector<int> cols;
+    for(int j = 89; j >= 0; j -= 1)
+        if(j % 7 != 2)
+            cols.push_back(j);
+
+    cusp::array1d<int,Space> d_rows(rows.begin(), rows.end());
+    cusp::array1d<int,Space> d_cols(cols.begin(), cols.end());
+
+    cusp::csr_matrix<int,float,Space> B;
+    cusp::extract_submatrix(d_A, d_rows, d_cols, B);
+    check_submatrix(A, rows, cols, B);
+
+    // increasing columns of a COO matrix
+    std::sort(cols.begin(), cols.end());
+    cusp::array1d<int,cusp::host_memory> h_cols(cols.begin(), cols.end());
+
+    cusp::coo_matrix<int,float,Space> d_C(A);
+    cusp::coo_matrix<int,float,Space> C;
+    cusp::extract_submatrix(d_C, d_rows, h_cols, C);
+    check_submatrix(A, rows, cols, C);
+
+    // empty submatrix
+    cusp::array1d<int,Space> none(0);
+    cusp::extract_submatrix(d_A, none, d_cols, B);
+    ASSERT_EQUAL(B.num_rows,    0);
+    ASSERT_EQUAL(B.num_entries, 0);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestExtractSubmatrix);
+
+void TestSymmetricPermuteInvalidInput(void)
+{
+    cusp::csr_matrix<int,float,cusp::host_memory> A;
+    random_permute_matrix(A, 4, 5);
+
+    cusp::csr_matrix<int,float,cusp::host_memory> B;
+    cusp::array1d<int,cusp::host_memory> permutation(4, 0);
+
+    ASSERT_THROWS(cusp::symmetric_permute(A, permutation, B), cusp::invalid_input_exception);
+
+    cusp::gallery::poisson5pt(A, 2, 2);
+    permutation.resize(3);
+
+    ASSERT_THROWS(cusp::symmetric_permute(A, permutation, B), cusp::invalid_input_exception);
+
+    cusp::array1d<int,cusp::host_memory> rows(1, 0);
+    cusp::array1d<int,cusp::host_memory> cols(5, 0);
+
+    ASSERT_THROWS(cusp::extract_submatrix(A, rows, cols, B), cusp::invalid_input_exception);
+}
+DECLARE_UNITTEST(TestSymmetricPermuteInvalidInput);
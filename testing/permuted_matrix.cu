@@ -0,0 +1,249 @@
+#include <unittest/unittest.h>
+
+#include <cusp/permuted_matrix.h>
+#include <cusp/graph/hilbert_curve.h>
+#include <cusp/graph/symmetric_rcm.h>
+
+#include <cusp/array2d.h>
+#include <cusp/coo_matrix.h>
+#include <cusp/csr_matrix.h>
+#include <cusp/ell_matrix.h>
+#include <cusp/multiply.h>
+#include <cusp/gallery/poisson.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+// bandwidth of a matrix
+template <typename MatrixType>
+int matrix_bandwidth(const MatrixType& A)
+{
+    cusp::coo_matrix<int,float,cusp::host_memory> B(A);
+
+    int bandwidth = 0;
+    for(size_t n = 0; n < B.num_entries; n++)
+        bandwidth = std::max(bandwidth, std::abs(B.row_indices[n] - B.column_indices[n]));
+
+    return bandwidth;
+}
+
+// average distance of the entries from the diagonal
+template <typename MatrixType>
+double matrix_profile(const MatrixType& A)
+{
+    cusp::coo_matrix<int,float,cusp::host_memory> B(A);
+
+    double distance = 0;
+    for(size_t n = 0; n < B.num_entries; n++)
+        distance += std::abs(B.row_indices[n] - B.column_indices[n]);
+
+    return distance / B.num_entries;
+}
+
+// check that an array holds a permutation of 0 to N - 1
+template <typename ArrayType>
+bool is_permutation_array(const ArrayType& permutation, size_t N)
+{
+    cusp::array1d<int,cusp::host_memory> P(permutation);
+
+    if(P.size() != N)
+        return false;
+
+    std::vector<bool> seen(N, false);
+    for(size_t i = 0; i < N; i++)
+    {
+        if(P[i] < 0 || P[i] >= int(N) || seen[P[i]])
+            return false;
+        seen[P[i]] = true;
+    }
+
+    return true;
+}
+
+// grid whose vertices are numbered randomly
+void initialize_shuffled_grid(cusp::csr_matrix<int,float,cusp::host_memory>& A,
+                              cusp::array1d<int,cusp::host_memory>& shuffle)
+{
+    cusp::coo_matrix<int,float,cusp::host_memory> B;
+    cusp::gallery::poisson5pt(B, 16, 16);
+
+    shuffle.resize(B.num_rows);
+    for(size_t i = 0; i < shuffle.size(); i++)
+        shuffle[i] = (i * 97) % B.num_rows;
+
+    for(size_t n = 0; n < B.num_entries; n++)
+    {
+        B.row_indices[n]    = shuffle[B.row_indices[n]];
+        B.column_indices[n] = shuffle[B.column_indices[n]];
+    }
+    B.sort_by_row_and_column();
+
+    A = B;
+}
+
+template <class MemorySpace>
+void TestSymmetricRCM(void)
+{
+    cusp::csr_matrix<int,float,cusp::host_memory> A;
+    cusp::array1d<int,cusp::host_memory> shuffle;
+    initialize_shuffled_grid(A, shuffle);
+
+    cusp::csr_matrix<int,float,MemorySpace> G(A);
+
+    cusp::array1d<int,MemorySpace> permutation;
+    cusp::graph::symmetric_rcm(G, permutation);
+    ASSERT_EQUAL(is_permutation_array(permutation, G.num_rows), true);
+
+    // the grid has bandwidth 16 in its natural ordering
+    cusp::graph::symmetric_rcm(G);
+    ASSERT_EQUAL(matrix_bandwidth(A) > 100, true);
+    ASSERT_EQUAL(matrix_bandwidth(G) <= 2 * 16, true);
+    ASSERT_EQUAL(G.num_entries, A.num_entries);
+
+    // general path
+    cusp::coo_matrix<int,float,MemorySpace> C(A);
+    cusp::graph::symmetric_rcm(C);
+    ASSERT_EQUAL(matrix_bandwidth(C) <= 2 * 16, true);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestSymmetricRCM);
+
+template <class MemorySpace>
+void TestSymmetricRCMCachedLevels(void)
+{
+    cusp::csr_matrix<int,float,cusp::host_memory> A;
+    cusp::array1d<int,cusp::host_memory> shuffle;
+    initialize_shuffled_grid(A, shuffle);
+
+    cusp::csr_matrix<int,float,MemorySpace> G(A);
+
+    cusp::array1d<int,MemorySpace> levels(G.num_rows);
+    cusp::graph::pseudo_peripheral_vertex(G, levels);
+
+    // the same levels give the same ordering every time
+    cusp::array1d<int,MemorySpace> permutation;
+    cusp::array1d<int,MemorySpace> reference;
+    cusp::graph::symmetric_rcm(G, permutation, levels);
+    cusp::graph::symmetric_rcm(G, reference, levels);
+
+    ASSERT_EQUAL(is_permutation_array(permutation, G.num_rows), true);
+    ASSERT_EQUAL(permutation, reference);
+
+    // bandwidth of the reordered matrix
+    cusp::array1d<int,cusp::host_memory> h_permutation(permutation);
+    std::vector<int> inverse(A.num_rows);
+    for(size_t i = 0; i < A.num_rows; i++)
+        inverse[h_permutation[i]] = i;
+
+    int bandwidth = 0;
+    for(size_t i = 0; i < A.num_rows; i++)
+        for(int jj = A.row_offsets[i]; jj < A.row_offsets[i + 1]; jj++)
+            bandwidth = std::max(bandwidth, std::abs(inverse[i] - inverse[A.column_indices[jj]]));
+
+    ASSERT_EQUAL(bandwidth <= 2 * 16, true);
+
+    // general path and invalid levels
+    cusp::coo_matrix<int,float,MemorySpace> C(A);
+    cusp::graph::symmetric_rcm(C, reference, levels);
+    ASSERT_EQUAL(permutation, reference);
+
+    cusp::array1d<int,MemorySpace> short_levels(G.num_rows - 1, 0);
+    ASSERT_THROWS(cusp::graph::symmetric_rcm(G, permutation, short_levels), cusp::invalid_input_exception);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestSymmetricRCMCachedLevels);
+
+template <typename MatrixType, typename PermutedType>
+void ComparePermutedMatrix(const MatrixType& A, const PermutedType& P)
+{
+    typedef typename PermutedType::memory_space MemorySpace;
+
+    ASSERT_EQUAL(is_permutation_array(P.permutation, A.num_rows), true);
+    ASSERT_EQUAL(P.matrix.num_entries, A.num_entries);
+
+    cusp::array1d<float,cusp::host_memory> x(A.num_cols);
+    for(size_t i = 0; i < x.size(); i++)
+        x[i] = int(i % 7) - 3;
+
+    cusp::array1d<float,cusp::host_memory> y(A.num_rows);
+    cusp::multiply(A, x, y);
+
+    // multiply in the original ordering
+    cusp::array1d<float,MemorySpace> d_x(x);
+    cusp::array1d<float,MemorySpace> d_y(A.num_rows, 10.0f);
+    cusp::multiply(P, d_x, d_y);
+    ASSERT_EQUAL(d_y, y);
+
+    // multiply in the reordered space
+    cusp::array1d<float,MemorySpace> x_new(A.num_cols);
+    cusp::array1d<float,MemorySpace> y_new(A.num_rows);
+    cusp::array1d<float,MemorySpace> z(A.num_rows, 10.0f);
+    P.permute(d_x, x_new);
+    cusp::multiply(P.matrix, x_new, y_new);
+    P.unpermute(y_new, z);
+    ASSERT_EQUAL(z, y);
+}
+
+template <class MemorySpace>
+void TestPermutedMatrix(void)
+{
+    cusp::csr_matrix<int,float,cusp::host_memory> A;
+    cusp::array1d<int,cusp::host_memory> shuffle;
+    initialize_shuffled_grid(A, shuffle);
+
+    typedef cusp::permuted_matrix< cusp::csr_matrix<int,float,MemorySpace> > CsrPermuted;
+    typedef cusp::permuted_matrix< cusp::ell_matrix<int,float,MemorySpace> > EllPermuted;
+
+    CsrPermuted P(A);
+    ComparePermutedMatrix(A, P);
+    ASSERT_EQUAL(matrix_bandwidth(P.matrix) <= 2 * 16, true);
+
+    EllPermuted Q(cusp::coo_matrix<int,float,MemorySpace>(A), cusp::reorder_degree);
+    ComparePermutedMatrix(A, Q);
+
+    // the interior vertices of the grid have the most entries
+    cusp::csr_matrix<int,float,cusp::host_memory> Q_csr(Q.matrix);
+    ASSERT_EQUAL(Q_csr.row_offsets[1] - Q_csr.row_offsets[0], 3);
+    ASSERT_EQUAL(Q_csr.row_offsets[Q.num_rows] - Q_csr.row_offsets[Q.num_rows - 1], 5);
+
+    // undo the shuffle of the grid
+    cusp::array1d<int,cusp::host_memory> natural(A.num_rows);
+    for(size_t i = 0; i < natural.size(); i++)
+        natural[i] = shuffle[i];
+
+    CsrPermuted R(A, natural);
+    ComparePermutedMatrix(A, R);
+    ASSERT_EQUAL(matrix_bandwidth(R.matrix), 16);
+
+    cusp::array1d<int,cusp::host_memory> short_permutation(A.num_rows - 1);
+    ASSERT_THROWS(CsrPermuted(A, short_permutation), cusp::invalid_input_exception);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestPermutedMatrix);
+
+template <class MemorySpace>
+void TestHilbertCurveOrdering(void)
+{
+    cusp::csr_matrix<int,float,cusp::host_memory> A;
+    cusp::array1d<int,cusp::host_memory> shuffle;
+    initialize_shuffled_grid(A, shuffle);
+
+    // vertex shuffle[16 * i + j] of the grid lies at point (i, j)
+    cusp::array2d<double,cusp::host_memory> coord(A.num_rows, 2);
+    for(size_t i = 0; i < 16; i++)
+        for(size_t j = 0; j < 16; j++)
+        {
+            coord(shuffle[16 * i + j], 0) = (i + 0.5) / 16.0;
+            coord(shuffle[16 * i + j], 1) = (j + 0.5) / 16.0;
+        }
+
+    cusp::array2d<double,MemorySpace> d_coord(coord);
+    cusp::array1d<int,MemorySpace> permutation;
+    cusp::graph::hilbert_curve_ordering(d_coord, permutation);
+
+    cusp::permuted_matrix< cusp::csr_matrix<int,float,MemorySpace> > P(A, permutation);
+    ComparePermutedMatrix(A, P);
+
+    // points close along the curve are close in the grid
+    ASSERT_EQUAL(matrix_profile(P.matrix) < matrix_profile(A), true);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestHilbertCurveOrdering);
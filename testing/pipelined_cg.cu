@@ -0,0 +1,88 @@
+#include <unittest/unittest.h>
+
+#include <cusp/gallery/poisson.h>
+#include <cusp/csr_matrix.h>
+#include <cusp/multiply.h>
+#include <cusp/krylov/cg.h>
+#include <cusp/krylov/pipelined_cg.h>
+#include <cusp/precond/diagonal.h>
+
+template <class MemorySpace>
+void TestPipelinedConjugateGradient(void)
+{
+    cusp::csr_matrix<int, float, MemorySpace> A;
+
+    cusp::gallery::poisson5pt(A, 10, 10);
+
+    cusp::array1d<float, MemorySpace> x(A.num_rows, 0.0f);
+    cusp::array1d<float, MemorySpace> b(A.num_rows, 1.0f);
+
+    cusp::default_monitor<float> monitor(b, 20, 1e-4);
+    
+    cusp::krylov::pipelined_cg(A, x, b, monitor);
+
+    // check residual norm
+    cusp::array1d<float, MemorySpace> residual(A.num_rows, 0.0f);
+    cusp::multiply(A, x, residual);
+    cusp::blas::axpby(residual, b, residual, -1.0f, 1.0f);
+
+    ASSERT_EQUAL(cusp::blas::nrm2(residual) < 1e-4 * cusp::blas::nrm2(b), true);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestPipelinedConjugateGradient);
+
+
+template <class MemorySpace>
+void TestPipelinedConjugateGradientPreconditioned(void)
+{
+    cusp::csr_matrix<int, float, MemorySpace> A;
+
+    cusp::gallery::poisson5pt(A, 10, 10);
+
+    cusp::array1d<float, MemorySpace> x0(A.num_rows, 0.0f);
+    cusp::array1d<float, MemorySpace> x1(A.num_rows, 0.0f);
+    cusp::array1d<float, MemorySpace> b(A.num_rows, 1.0f);
+
+    cusp::precond::diagonal<float, MemorySpace> M(A);
+
+    cusp::default_monitor<float> monitor0(b, 50, 1e-5);
+    cusp::default_monitor<float> monitor1(b, 50, 1e-5);
+    
+    cusp::krylov::cg(A, x0, b, monitor0, M);
+    cusp::krylov::pipelined_cg(A, x1, b, monitor1, M);
+
+    // same residual semantics as cg, up to rounding
+    ASSERT_EQUAL(monitor1.converged(), true);
+    ASSERT_EQUAL(monitor1.iteration_count() <= monitor0.iteration_count() + 1, true);
+
+    cusp::array1d<float, MemorySpace> residual(A.num_rows, 0.0f);
+    cusp::multiply(A, x1, residual);
+    cusp::blas::axpby(residual, b, residual, -1.0f, 1.0f);
+
+    ASSERT_EQUAL(cusp::blas::nrm2(residual) < 1e-4 * cusp::blas::nrm2(b), true);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestPipelinedConjugateGradientPreconditioned);
+
+
+template <class MemorySpace>
+void TestPipelinedConjugateGradientZeroResidual(void)
+{
+    cusp::array2d<float, MemorySpace> M(2,2);
+    M(0,0) = 8; M(0,1) = 0;
+    M(1,0) = 0; M(1,1) = 4;
+
+    cusp::csr_matrix<int, float, MemorySpace> A(M);
+
+    cusp::array1d<float, MemorySpace> x(A.num_rows, 1.0f);
+    cusp::array1d<float, MemorySpace> b(A.num_rows);
+
+    cusp::multiply(A, x, b);
+
+    cusp::default_monitor<float> monitor(b, 20, 0.0f);
+    
+    cusp::krylov::pipelined_cg(A, x, b, monitor);
+
+    ASSERT_EQUAL(monitor.converged(),        true);
+    ASSERT_EQUAL(monitor.iteration_count(),     0);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestPipelinedConjugateGradientZeroResidual);
+
@@ -0,0 +1,83 @@
+#include <unittest/unittest.h>
+
+#include <cusp/precond/polynomial.h>
+#include <cusp/precond/diagonal.h>
+
+#include <cusp/blas.h>
+#include <cusp/csr_matrix.h>
+#include <cusp/gallery/poisson.h>
+#include <cusp/krylov/cg.h>
+#include <cusp/monitor.h>
+
+template <class Space>
+void TestPolynomialPreconditioner(void)
+{
+    typedef cusp::csr_matrix<int,float,Space> Matrix;
+
+    Matrix A;
+    cusp::gallery::poisson5pt(A, 32, 32);
+
+    cusp::precond::polynomial<Matrix> M(A, 6);
+
+    // the eigenvalues of D^-1 A lie in (0,2)
+    ASSERT_EQUAL(M.degree, 6);
+    ASSERT_EQUAL(M.upper_bound > 1.8f,  true);
+    ASSERT_EQUAL(M.upper_bound <= 2.0f, true);
+    ASSERT_EQUAL(M.lower_bound > 0.0f,  true);
+    ASSERT_EQUAL(M.lower_bound < M.upper_bound, true);
+
+    // the preconditioner is symmetric
+    cusp::array1d<float,Space> u = unittest::random_samples<float>(A.num_rows);
+    cusp::array1d<float,Space> v = unittest::random_samples<float>(A.num_rows);
+    cusp::array1d<float,Space> Mu(A.num_rows);
+    cusp::array1d<float,Space> Mv(A.num_rows);
+
+    M(u, Mu);
+    M(v, Mv);
+
+    ASSERT_ALMOST_EQUAL(cusp::blas::dot(u, Mv), cusp::blas::dot(Mu, v));
+
+    // and reduces the iterations of cg well below those of Jacobi
+    cusp::array1d<float,Space> b = unittest::random_samples<float>(A.num_rows);
+
+    cusp::array1d<float,Space> x(A.num_rows, 0.0f);
+    cusp::default_monitor<float> monitor(b, 1000, 1e-5);
+    cusp::krylov::cg(A, x, b, monitor, M);
+
+    cusp::precond::diagonal<float,Space> D(A);
+    cusp::array1d<float,Space> x_jacobi(A.num_rows, 0.0f);
+    cusp::default_monitor<float> monitor_jacobi(b, 1000, 1e-5);
+    cusp::krylov::cg(A, x_jacobi, b, monitor_jacobi, D);
+
+    ASSERT_EQUAL(monitor.converged(), true);
+    ASSERT_EQUAL(2 * monitor.iteration_count() < monitor_jacobi.iteration_count(), true);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestPolynomialPreconditioner);
+
+template <class Space>
+void TestPolynomialPreconditionerDegreeOne(void)
+{
+    typedef cusp::csr_matrix<int,float,Space> Matrix;
+
+    Matrix A;
+    cusp::gallery::poisson5pt(A, 10, 10);
+
+    // a given interval is kept, and degree one is Jacobi scaled by the
+    // inverse of the center of the interval
+    cusp::precond::polynomial<Matrix> M(A, 1, 0.5f, 1.5f);
+
+    ASSERT_EQUAL(M.lower_bound, 0.5f);
+    ASSERT_EQUAL(M.upper_bound, 1.5f);
+
+    cusp::array1d<float,Space> x = unittest::random_samples<float>(A.num_rows);
+    cusp::array1d<float,Space> y(A.num_rows);
+    cusp::array1d<float,Space> z(A.num_rows);
+
+    M(x, y);
+
+    cusp::precond::diagonal<float,Space> D(A);
+    D(x, z);
+
+    ASSERT_ALMOST_EQUAL(y, z);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestPolynomialPreconditionerDegreeOne);
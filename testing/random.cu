@@ -114,3 +114,48 @@ struct TestRandomReals
 };
 SimpleUnitTest<TestRandomReals, unittest::type_list<float> > TestRandomRealsInstance;
 
+
+
+#include <cusp/coo_matrix.h>
+#include <cusp/csr_matrix.h>
+#include <cusp/gallery/random.h>
+
+void TestGalleryRandom(void)
+{
+    cusp::coo_matrix<int, float, cusp::host_memory>   h;
+    cusp::coo_matrix<int, float, cusp::device_memory> d;
+
+    cusp::gallery::random(300, 200, 2000, h, 7);
+    cusp::gallery::random(300, 200, 2000, d, 7);
+
+    // the same matrix in both memory spaces
+    ASSERT_EQUAL(h.num_entries, d.num_entries);
+    ASSERT_EQUAL(h.row_indices,    d.row_indices);
+    ASSERT_EQUAL(h.column_indices, d.column_indices);
+    ASSERT_EQUAL(h.values,         d.values);
+
+    // sorted without duplicates, in range
+    ASSERT_EQUAL(h.num_entries <= 2000, true);
+    ASSERT_EQUAL(h.num_entries > 1800, true);
+    for (size_t n = 0; n < h.num_entries; n++)
+    {
+        ASSERT_EQUAL(h.row_indices[n] < 300 && h.column_indices[n] < 200, true);
+        if (n > 0)
+            ASSERT_EQUAL(h.row_indices[n - 1] < h.row_indices[n] ||
+                         (h.row_indices[n - 1] == h.row_indices[n] && h.column_indices[n - 1] < h.column_indices[n]), true);
+    }
+
+    // other seeds give other positions
+    cusp::coo_matrix<int, float, cusp::host_memory> other;
+    cusp::gallery::random(300, 200, 2000, other, 8);
+    ASSERT_EQUAL(other.row_indices == h.row_indices && other.column_indices == h.column_indices, false);
+
+    // other formats
+    cusp::csr_matrix<int, float, cusp::device_memory> csr;
+    cusp::gallery::random(300, 200, 2000, csr, 7);
+    ASSERT_EQUAL(csr.num_entries, h.num_entries);
+
+    cusp::gallery::random(0, 200, 2000, h);
+    ASSERT_EQUAL(h.num_entries, 0);
+}
+DECLARE_UNITTEST(TestGalleryRandom);
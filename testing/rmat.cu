@@ -0,0 +1,40 @@
+#include <unittest/unittest.h>
+
+#include <cusp/coo_matrix.h>
+#include <cusp/csr_matrix.h>
+#include <cusp/gallery/rmat.h>
+
+void TestRmat(void)
+{
+    cusp::coo_matrix<int, float, cusp::host_memory>   h;
+    cusp::coo_matrix<int, float, cusp::device_memory> d;
+
+    cusp::gallery::rmat(h, 10, 8, 5);
+    cusp::gallery::rmat(d, 10, 8, 5);
+
+    ASSERT_EQUAL(h.num_rows, 1024);
+    ASSERT_EQUAL(h.num_cols, 1024);
+    ASSERT_EQUAL(h.num_entries <= 8 * 1024, true);
+    ASSERT_EQUAL(h.num_entries > 4 * 1024, true);
+
+    ASSERT_EQUAL(h.row_indices,    d.row_indices);
+    ASSERT_EQUAL(h.column_indices, d.column_indices);
+    ASSERT_EQUAL(h.values,         d.values);
+
+    // the first quadrant is the most likely, so the first row is the longest
+    cusp::array1d<int, cusp::host_memory> row_lengths(h.num_rows, 0);
+    for (size_t n = 0; n < h.num_entries; n++)
+        row_lengths[h.row_indices[n]]++;
+
+    for (size_t i = 1; i < row_lengths.size(); i++)
+        ASSERT_EQUAL(row_lengths[0] >= row_lengths[i], true);
+
+    // uniform probabilities
+    cusp::csr_matrix<int, float, cusp::host_memory> A;
+    cusp::gallery::rmat(A, 4, 2, 0, 0.25, 0.25, 0.25);
+    ASSERT_EQUAL(A.num_rows, 16);
+
+    ASSERT_THROWS(cusp::gallery::rmat(A, 4, 2, 0, 0.5, 0.5, 0.5), cusp::invalid_input_exception);
+    ASSERT_THROWS(cusp::gallery::rmat(A, 31, 2), cusp::invalid_input_exception);
+}
+DECLARE_UNITTEST(TestRmat);
@@ -0,0 +1,45 @@
+#include <unittest/unittest.h>
+
+#include <cusp/coo_matrix.h>
+#include <cusp/csr_matrix.h>
+#include <cusp/gallery/row_lengths.h>
+
+template <class MemorySpace>
+void TestRandomRowLengths(void)
+{
+    // a power law of row lengths
+    cusp::array1d<int, cusp::host_memory> row_lengths(300);
+    for (size_t i = 0; i < row_lengths.size(); i++)
+        row_lengths[i] = 1000 / (i + 1);
+    row_lengths[7] = 0;
+
+    cusp::csr_matrix<int, float, MemorySpace> A;
+    cusp::gallery::random_row_lengths(A, 1000, cusp::array1d<int, MemorySpace>(row_lengths), 4);
+
+    cusp::csr_matrix<int, float, cusp::host_memory> B(A);
+
+    ASSERT_EQUAL(B.num_rows, 300);
+    ASSERT_EQUAL(B.num_cols, 1000);
+
+    for (int i = 0; i < B.num_rows; i++)
+    {
+        ASSERT_EQUAL(B.row_offsets[i + 1] - B.row_offsets[i], row_lengths[i]);
+
+        // sorted, distinct and in range
+        for (int jj = B.row_offsets[i]; jj < B.row_offsets[i + 1]; jj++)
+        {
+            ASSERT_EQUAL(B.column_indices[jj] >= 0 && B.column_indices[jj] < 1000, true);
+            if (jj > B.row_offsets[i])
+                ASSERT_EQUAL(B.column_indices[jj - 1] < B.column_indices[jj], true);
+        }
+    }
+
+    // the same matrix from host lengths and in another format
+    cusp::coo_matrix<int, float, cusp::host_memory> C;
+    cusp::gallery::random_row_lengths(C, 1000, row_lengths, 4);
+    ASSERT_EQUAL(C.column_indices, B.column_indices);
+
+    row_lengths[0] = 1001;
+    ASSERT_THROWS(cusp::gallery::random_row_lengths(A, 1000, row_lengths), cusp::invalid_input_exception);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestRandomRowLengths);
@@ -0,0 +1,121 @@
+#include <unittest/unittest.h>
+
+#include <cusp/precond/classical/ruge_stuben.h>
+
+#include <cusp/array2d.h>
+#include <cusp/coo_matrix.h>
+#include <cusp/csr_matrix.h>
+
+#include <cusp/gallery/diffusion.h>
+#include <cusp/gallery/poisson.h>
+#include <cusp/krylov/cg.h>
+
+template <class MemorySpace>
+void TestClassicalStrengthOfConnection(void)
+{
+    typedef typename cusp::precond::aggregation::amg_container<int,float,MemorySpace>::setup_type SetupMatrixType;
+
+    cusp::array2d<float,cusp::host_memory> A_host(3, 3);
+    A_host(0,0) =  4.0f; A_host(0,1) = -1.0f; A_host(0,2) = -0.1f;
+    A_host(1,0) = -1.0f; A_host(1,1) =  4.0f; A_host(1,2) =  1.0f;
+    A_host(2,0) = -0.1f; A_host(2,1) =  1.0f; A_host(2,2) =  4.0f;
+
+    SetupMatrixType A(A_host);
+    SetupMatrixType S;
+    cusp::precond::classical::classical_strength_of_connection(A, S, 0.25f);
+
+    // row 0: -1 is strong, -0.1 is weak; row 1: only -1; row 2: only -0.1
+    cusp::array2d<float,cusp::host_memory> D(S);
+    ASSERT_EQUAL(S.num_entries, 3);
+    ASSERT_EQUAL(D(0,1), -1.0f);
+    ASSERT_EQUAL(D(1,0), -1.0f);
+    ASSERT_EQUAL(D(2,0), -0.1f);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestClassicalStrengthOfConnection);
+
+template <class MemorySpace>
+void TestDirectInterpolation(void)
+{
+    typedef typename cusp::precond::aggregation::amg_container<int,float,MemorySpace>::setup_type SetupMatrixType;
+
+    SetupMatrixType A;
+    cusp::gallery::poisson5pt(A, 10, 10);
+
+    SetupMatrixType S;
+    cusp::precond::classical::classical_strength_of_connection(A, S, 0.25f);
+
+    cusp::array1d<int,MemorySpace> cf;
+    cusp::precond::classical::cf_splitting(S, cf);
+
+    SetupMatrixType P;
+    cusp::precond::classical::direct_interpolation(A, S, cf, P);
+
+    cusp::array1d<int,cusp::host_memory> cf_host(cf);
+    cusp::csr_matrix<int,float,cusp::host_memory> P_host(P);
+    cusp::csr_matrix<int,float,cusp::host_memory> A_host(A);
+
+    ASSERT_EQUAL(P_host.num_cols, thrust::count(cf_host.begin(), cf_host.end(), 1));
+
+    for (int i = 0; i < A_host.num_rows; i++)
+    {
+        const int begin = P_host.row_offsets[i];
+        const int end   = P_host.row_offsets[i + 1];
+
+        if (cf_host[i])
+        {
+            // C points are injected
+            ASSERT_EQUAL(end - begin, 1);
+            ASSERT_EQUAL(P_host.values[begin], 1.0f);
+            continue;
+        }
+
+        // every F point interpolates and the weights sum to the ratio of
+        // the off-diagonal and diagonal sums of its row
+        ASSERT_EQUAL(end - begin > 0, true);
+
+        float diagonal = 0.0f, off_diagonal = 0.0f, weights = 0.0f;
+        for (int jj = A_host.row_offsets[i]; jj < A_host.row_offsets[i + 1]; jj++)
+        {
+            if (A_host.column_indices[jj] == i)
+                diagonal = A_host.values[jj];
+            else
+                off_diagonal -= A_host.values[jj];
+        }
+        for (int jj = begin; jj < end; jj++)
+            weights += P_host.values[jj];
+
+        ASSERT_ALMOST_EQUAL(weights, off_diagonal / diagonal);
+    }
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestDirectInterpolation);
+
+template <class MemorySpace>
+void TestRugeStuben(void)
+{
+    typedef int                 IndexType;
+    typedef float               ValueType;
+
+    // isotropic and strongly anisotropic diffusion
+    for (int problem = 0; problem < 2; problem++)
+    {
+        cusp::coo_matrix<IndexType,ValueType,MemorySpace> A;
+        if (problem == 0)
+            cusp::gallery::poisson5pt(A, 100, 100);
+        else
+            cusp::gallery::diffusion<cusp::gallery::FD>(A, 100, 100, 0.001, 0.0);
+
+        cusp::precond::classical::ruge_stuben<IndexType,ValueType,MemorySpace> M(A);
+
+        ASSERT_EQUAL(M.levels.size() > 1, true);
+
+        cusp::array1d<ValueType,MemorySpace> b = unittest::random_samples<ValueType>(A.num_rows);
+        cusp::array1d<ValueType,MemorySpace> x(A.num_rows, 0);
+
+        // set stopping criteria (iteration_limit = 30, relative_tolerance = 1e-4)
+        cusp::convergence_monitor<ValueType> monitor(b, 30, 1e-4);
+        cusp::krylov::cg(A, x, b, monitor, M);
+
+        ASSERT_EQUAL(monitor.converged(), true);
+    }
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestRugeStuben);
@@ -0,0 +1,68 @@
+#include <unittest/unittest.h>
+
+#include <cusp/gallery/poisson.h>
+#include <cusp/csr_matrix.h>
+#include <cusp/multiply.h>
+#include <cusp/krylov/cg.h>
+#include <cusp/krylov/s_step_cg.h>
+#include <cusp/precond/diagonal.h>
+
+template <class MemorySpace>
+void TestSStepConjugateGradient(void)
+{
+    cusp::csr_matrix<int, float, MemorySpace> A;
+
+    cusp::gallery::poisson5pt(A, 10, 10);
+
+    cusp::array1d<float, MemorySpace> x(A.num_rows, 0.0f);
+    cusp::array1d<float, MemorySpace> b(A.num_rows, 1.0f);
+
+    cusp::default_monitor<float> monitor(b, 40, 1e-4);
+    
+    cusp::krylov::s_step_cg(A, x, b, 4, monitor);
+
+    // check residual norm
+    cusp::array1d<float, MemorySpace> residual(A.num_rows, 0.0f);
+    cusp::multiply(A, x, residual);
+    cusp::blas::axpby(residual, b, residual, -1.0f, 1.0f);
+
+    ASSERT_EQUAL(monitor.converged(), true);
+    ASSERT_EQUAL(cusp::blas::nrm2(residual) < 1e-3 * cusp::blas::nrm2(b), true);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestSStepConjugateGradient);
+
+
+template <class MemorySpace>
+void TestSStepConjugateGradientPreconditioned(void)
+{
+    cusp::csr_matrix<int, float, MemorySpace> A;
+
+    cusp::gallery::poisson5pt(A, 20, 20);
+
+    cusp::array1d<float, MemorySpace> b = unittest::random_samples<float>(A.num_rows);
+
+    cusp::precond::diagonal<float, MemorySpace> M(A);
+
+    cusp::array1d<float, MemorySpace> x0(A.num_rows, 0.0f);
+    cusp::default_monitor<float> monitor0(b, 200, 1e-4);
+    cusp::krylov::cg(A, x0, b, monitor0, M);
+
+    // s = 1 is CG with one reduction per iteration
+    for (size_t s = 1; s <= 4; s++)
+    {
+        cusp::array1d<float, MemorySpace> x(A.num_rows, 0.0f);
+        cusp::default_monitor<float> monitor(b, 200, 1e-4);
+        cusp::krylov::s_step_cg(A, x, b, s, monitor, M);
+
+        ASSERT_EQUAL(monitor.converged(), true);
+        // the monomial bases lose some accuracy as s grows
+        ASSERT_EQUAL(monitor.iteration_count() <= 2 * monitor0.iteration_count(), true);
+
+        cusp::array1d<float, MemorySpace> residual(A.num_rows, 0.0f);
+        cusp::multiply(A, x, residual);
+        cusp::blas::axpby(residual, b, residual, -1.0f, 1.0f);
+
+        ASSERT_EQUAL(cusp::blas::nrm2(residual) < 1e-3 * cusp::blas::nrm2(b), true);
+    }
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestSStepConjugateGradientPreconditioned);
@@ -0,0 +1,66 @@
+#include <unittest/unittest.h>
+
+#include <cusp/gallery/diffusion.h>
+#include <cusp/gallery/poisson.h>
+#include <cusp/csr_matrix.h>
+#include <cusp/multiply.h>
+#include <cusp/krylov/gmres.h>
+#include <cusp/krylov/s_step_gmres.h>
+#include <cusp/precond/diagonal.h>
+
+template <class MemorySpace>
+void TestSStepGeneralizedMinimumResidual(void)
+{
+    cusp::csr_matrix<int, float, MemorySpace> A;
+
+    cusp::gallery::poisson5pt(A, 10, 10);
+
+    cusp::array1d<float, MemorySpace> x(A.num_rows, 0.0f);
+    cusp::array1d<float, MemorySpace> b(A.num_rows, 1.0f);
+
+    cusp::default_monitor<float> monitor(b, 100, 1e-4);
+
+    cusp::krylov::s_step_gmres(A, x, b, 20, 4, monitor);
+
+    // check residual norm
+    cusp::array1d<float, MemorySpace> residual(A.num_rows, 0.0f);
+    cusp::multiply(A, x, residual);
+    cusp::blas::axpby(residual, b, residual, -1.0f, 1.0f);
+
+    ASSERT_EQUAL(monitor.converged(), true);
+    ASSERT_EQUAL(cusp::blas::nrm2(residual) < 1e-3 * cusp::blas::nrm2(b), true);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestSStepGeneralizedMinimumResidual);
+
+
+template <class MemorySpace>
+void TestSStepGeneralizedMinimumResidualPreconditioned(void)
+{
+    // nonsymmetric rotated anisotropic diffusion
+    cusp::csr_matrix<int, float, MemorySpace> A;
+    cusp::gallery::diffusion<cusp::gallery::FD>(A, 20, 20, 0.1, 0.5);
+
+    cusp::array1d<float, MemorySpace> b = unittest::random_samples<float>(A.num_rows);
+
+    cusp::precond::diagonal<float, MemorySpace> M(A);
+    cusp::krylov::workspace<float, MemorySpace> workspace;
+
+    cusp::array1d<float, MemorySpace> x0(A.num_rows, 0.0f);
+    cusp::default_monitor<float> monitor0(b, 300, 1e-4);
+    cusp::krylov::gmres(A, x0, b, 30, monitor0, M, workspace);
+
+    // the restart is not a multiple of s, so the last block of a cycle is shorter
+    for (size_t s = 1; s <= 4; s += 3)
+    {
+        cusp::array1d<float, MemorySpace> x(A.num_rows, 0.0f);
+        cusp::default_monitor<float> monitor(b, 300, 1e-4);
+        cusp::krylov::s_step_gmres(A, x, b, 30, s, monitor, M, workspace);
+
+        ASSERT_EQUAL(monitor.converged(), true);
+
+        // same Krylov space up to rounding
+        const int difference = int(monitor.iteration_count()) - int(monitor0.iteration_count());
+        ASSERT_EQUAL(difference * difference <= 25, true);
+    }
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestSStepGeneralizedMinimumResidualPreconditioned);
@@ -0,0 +1,214 @@
+#include <unittest/unittest.h>
+
+#include <cusp/sell_matrix.h>
+#include <cusp/multiply.h>
+#include <cusp/verify.h>
+#include <cusp/gallery/poisson.h>
+#include <cusp/gallery/random.h>
+
+// rows of length 2, 0, 5, 1 and 3
+template <typename Matrix>
+void initialize_irregular_matrix(Matrix& A)
+{
+    cusp::coo_matrix<int,float,cusp::host_memory> coo(5, 6, 11);
+
+    coo.row_indices[ 0] = 0; coo.column_indices[ 0] = 1; coo.values[ 0] =  1;
+    coo.row_indices[ 1] = 0; coo.column_indices[ 1] = 4; coo.values[ 1] =  2;
+    coo.row_indices[ 2] = 2; coo.column_indices[ 2] = 0; coo.values[ 2] =  3;
+    coo.row_indices[ 3] = 2; coo.column_indices[ 3] = 1; coo.values[ 3] =  4;
+    coo.row_indices[ 4] = 2; coo.column_indices[ 4] = 2; coo.values[ 4] =  5;
+    coo.row_indices[ 5] = 2; coo.column_indices[ 5] = 3; coo.values[ 5] =  6;
+    coo.row_indices[ 6] = 2; coo.column_indices[ 6] = 5; coo.values[ 6] =  7;
+    coo.row_indices[ 7] = 3; coo.column_indices[ 7] = 2; coo.values[ 7] =  8;
+    coo.row_indices[ 8] = 4; coo.column_indices[ 8] = 0; coo.values[ 8] =  9;
+    coo.row_indices[ 9] = 4; coo.column_indices[ 9] = 3; coo.values[ 9] = 10;
+    coo.row_indices[10] = 4; coo.column_indices[10] = 5; coo.values[10] = 11;
+
+    A = coo;
+}
+
+template <class Space>
+void TestSellMatrixBasicConstructor(void)
+{
+    cusp::sell_matrix<int, float, Space> matrix(5, 3, 7, 12, 2, 4);
+
+    ASSERT_EQUAL(matrix.num_rows,               5);
+    ASSERT_EQUAL(matrix.num_cols,               3);
+    ASSERT_EQUAL(matrix.num_entries,            7);
+    ASSERT_EQUAL(matrix.slice_height,           2);
+    ASSERT_EQUAL(matrix.sorting_window,         4);
+    ASSERT_EQUAL(matrix.num_slices(),           3);
+    ASSERT_EQUAL(matrix.slice_offsets.size(),   4);
+    ASSERT_EQUAL(matrix.row_permutation.size(), 5);
+    ASSERT_EQUAL(matrix.column_indices.size(), 12);
+    ASSERT_EQUAL(matrix.values.size(),         12);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestSellMatrixBasicConstructor);
+
+template <class Space>
+void TestSellMatrixSwap(void)
+{
+    cusp::sell_matrix<int, float, Space> A(1, 2, 2, 2, 1, 1);
+    cusp::sell_matrix<int, float, Space> B(3, 1, 3, 4, 2, 2);
+
+    A.swap(B);
+
+    ASSERT_EQUAL(A.num_rows,              3);
+    ASSERT_EQUAL(A.num_cols,              1);
+    ASSERT_EQUAL(A.num_entries,           3);
+    ASSERT_EQUAL(A.slice_height,          2);
+    ASSERT_EQUAL(A.sorting_window,        2);
+    ASSERT_EQUAL(A.column_indices.size(), 4);
+
+    ASSERT_EQUAL(B.num_rows,              1);
+    ASSERT_EQUAL(B.num_cols,              2);
+    ASSERT_EQUAL(B.num_entries,           2);
+    ASSERT_EQUAL(B.slice_height,          1);
+    ASSERT_EQUAL(B.sorting_window,        1);
+    ASSERT_EQUAL(B.column_indices.size(), 2);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestSellMatrixSwap);
+
+template <class Space>
+void TestSellMatrixConversion(void)
+{
+    cusp::csr_matrix<int, float, Space> A;
+    initialize_irregular_matrix(A);
+
+    cusp::sell_matrix<int, float, Space> B(A, 2, 4);
+
+    ASSERT_EQUAL(B.num_rows,       5);
+    ASSERT_EQUAL(B.num_cols,       6);
+    ASSERT_EQUAL(B.num_entries,   11);
+    ASSERT_EQUAL(B.slice_height,   2);
+    ASSERT_EQUAL(B.sorting_window, 4);
+    ASSERT_EQUAL(cusp::is_valid_matrix(B), true);
+
+    // the first window holds rows 2, 0, 3, 1 and the second one row 4
+    cusp::array1d<int, cusp::host_memory> row_permutation(B.row_permutation);
+    ASSERT_EQUAL(row_permutation[0], 2);
+    ASSERT_EQUAL(row_permutation[1], 0);
+    ASSERT_EQUAL(row_permutation[2], 3);
+    ASSERT_EQUAL(row_permutation[3], 1);
+    ASSERT_EQUAL(row_permutation[4], 4);
+
+    // slices of width 5, 1 and 3
+    cusp::array1d<int, cusp::host_memory> slice_offsets(B.slice_offsets);
+    ASSERT_EQUAL(slice_offsets.size(), 4);
+    ASSERT_EQUAL(slice_offsets[0],  0);
+    ASSERT_EQUAL(slice_offsets[1], 10);
+    ASSERT_EQUAL(slice_offsets[2], 12);
+    ASSERT_EQUAL(slice_offsets[3], 18);
+
+    // an ELL matrix of the same rows stores 5 * 5 entries
+    ASSERT_EQUAL(B.column_indices.size() < 25, true);
+
+    // round trip through CSR and COO
+    cusp::csr_matrix<int, float, Space> C(B);
+    cusp::coo_matrix<int, float, Space> D(B);
+
+    cusp::array2d<float, cusp::host_memory> A_dense(A);
+    cusp::array2d<float, cusp::host_memory> C_dense(C);
+    cusp::array2d<float, cusp::host_memory> D_dense(D);
+
+    ASSERT_EQUAL_QUIET(A_dense, C_dense);
+    ASSERT_EQUAL_QUIET(A_dense, D_dense);
+
+    // conversion from COO
+    cusp::coo_matrix<int, float, Space> E(A);
+    cusp::sell_matrix<int, float, Space> F(E, 2, 4);
+
+    ASSERT_EQUAL_QUIET(B.slice_offsets,   F.slice_offsets);
+    ASSERT_EQUAL_QUIET(B.row_permutation, F.row_permutation);
+    ASSERT_EQUAL_QUIET(B.column_indices,  F.column_indices);
+    ASSERT_EQUAL_QUIET(B.values,          F.values);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestSellMatrixConversion);
+
+void TestSellMatrixHostDeviceConversion(void)
+{
+    cusp::csr_matrix<int, float, cusp::host_memory> A;
+    cusp::gallery::random(100, 80, 700, A);
+
+    cusp::sell_matrix<int, float, cusp::host_memory>   B(A, 8, 32);
+    cusp::sell_matrix<int, float, cusp::device_memory> C(cusp::csr_matrix<int, float, cusp::device_memory>(A), 8, 32);
+
+    ASSERT_EQUAL_QUIET(B.slice_offsets,   C.slice_offsets);
+    ASSERT_EQUAL_QUIET(B.row_permutation, C.row_permutation);
+    ASSERT_EQUAL_QUIET(B.column_indices,  C.column_indices);
+    ASSERT_EQUAL_QUIET(B.values,          C.values);
+
+    // the parameters are preserved across memory spaces
+    cusp::sell_matrix<int, float, cusp::device_memory> D(A, 4, 16);
+    ASSERT_EQUAL(D.slice_height,    4);
+    ASSERT_EQUAL(D.sorting_window, 16);
+}
+DECLARE_UNITTEST(TestSellMatrixHostDeviceConversion);
+
+template <typename SourceType, class Space>
+void CompareSellSpMV(const SourceType& S, size_t slice_height, size_t sorting_window)
+{
+    cusp::csr_matrix<int, float, Space>  A(S);
+    cusp::sell_matrix<int, float, Space> B(A, slice_height, sorting_window);
+
+    cusp::array1d<float, cusp::host_memory> x(A.num_cols);
+    for(size_t i = 0; i < x.size(); i++)
+        x[i] = int(i % 5) - 2;
+
+    cusp::array1d<float, Space> d_x(x);
+    cusp::array1d<float, Space> y(A.num_rows, 0.0f);
+    cusp::array1d<float, Space> z(A.num_rows, 10.0f);
+
+    cusp::multiply(A, d_x, y);
+    cusp::multiply(B, d_x, z);
+
+    ASSERT_EQUAL(z, y);
+}
+
+template <class Space>
+void TestSellMatrixMultiply(void)
+{
+    cusp::csr_matrix<int, float, cusp::host_memory> A;
+    initialize_irregular_matrix(A);
+
+    CompareSellSpMV<cusp::csr_matrix<int, float, cusp::host_memory>, Space>(A, 2, 4);
+    CompareSellSpMV<cusp::csr_matrix<int, float, cusp::host_memory>, Space>(A, 1, 1);
+    CompareSellSpMV<cusp::csr_matrix<int, float, cusp::host_memory>, Space>(A, 32, 256);
+
+    cusp::csr_matrix<int, float, cusp::host_memory> B;
+    cusp::gallery::poisson5pt(B, 13, 17);
+    CompareSellSpMV<cusp::csr_matrix<int, float, cusp::host_memory>, Space>(B, 32, 1);
+    CompareSellSpMV<cusp::csr_matrix<int, float, cusp::host_memory>, Space>(B, 8, 64);
+
+    cusp::csr_matrix<int, float, cusp::host_memory> C;
+    cusp::gallery::random(300, 200, 2000, C);
+    CompareSellSpMV<cusp::csr_matrix<int, float, cusp::host_memory>, Space>(C, 32, 256);
+    CompareSellSpMV<cusp::csr_matrix<int, float, cusp::host_memory>, Space>(C, 16, 16);
+
+    // empty matrix
+    cusp::csr_matrix<int, float, cusp::host_memory> D(10, 10, 0);
+    thrust::fill(D.row_offsets.begin(), D.row_offsets.end(), 0);
+    CompareSellSpMV<cusp::csr_matrix<int, float, cusp::host_memory>, Space>(D, 4, 4);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestSellMatrixMultiply);
+
+void TestSellMatrixPadding(void)
+{
+    // one long row among short rows
+    cusp::coo_matrix<int, float, cusp::host_memory> A(64, 64, 127);
+    for(int j = 0; j < 64; j++)
+    {
+        A.row_indices[j] = 0;  A.column_indices[j] = j;  A.values[j] = 1.0f;
+    }
+    for(int i = 1; i < 64; i++)
+    {
+        A.row_indices[63 + i] = i;  A.column_indices[63 + i] = i;  A.values[63 + i] = 2.0f;
+    }
+
+    cusp::sell_matrix<int, float, cusp::host_memory> B(A, 8, 64);
+
+    // the long row is padded within its slice only, while ELL
+    // would store 64 * 64 entries
+    ASSERT_EQUAL(B.column_indices.size(), 8 * 64 + 7 * 8 * 1);
+}
+DECLARE_UNITTEST(TestSellMatrixPadding);
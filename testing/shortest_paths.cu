@@ -0,0 +1,163 @@
+#include <unittest/unittest.h>
+
+#include <cusp/graph/shortest_paths.h>
+
+#include <cusp/coo_matrix.h>
+#include <cusp/csr_matrix.h>
+#include <cusp/gallery/grid.h>
+
+#include <cstdlib>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <utility>
+#include <vector>
+
+// Dijkstra's algorithm with a binary heap
+template <typename ValueType>
+void dijkstra(const cusp::csr_matrix<int,ValueType,cusp::host_memory>& G, const int src,
+              std::vector<ValueType>& distances)
+{
+    typedef std::pair<ValueType,int> Entry;
+
+    distances.assign(G.num_rows, std::numeric_limits<ValueType>::max());
+    distances[src] = 0;
+
+    std::priority_queue< Entry, std::vector<Entry>, std::greater<Entry> > heap;
+    heap.push(Entry(ValueType(0), src));
+
+    while (!heap.empty())
+    {
+        const Entry top = heap.top();
+        heap.pop();
+
+        const int u = top.second;
+
+        if (top.first > distances[u])
+            continue;
+
+        for (int jj = G.row_offsets[u]; jj < G.row_offsets[u + 1]; jj++)
+        {
+            const int v = G.column_indices[jj];
+            const ValueType d = distances[u] + G.values[jj];
+
+            if (d < distances[v])
+            {
+                distances[v] = d;
+                heap.push(Entry(d, v));
+            }
+        }
+    }
+}
+
+// random directed graph with integer weights in [0, max_weight]
+void random_weighted_graph(cusp::csr_matrix<int,int,cusp::host_memory>& G,
+                           const int N, const int degree, const int max_weight)
+{
+    cusp::coo_matrix<int,int,cusp::host_memory> A(N, N, N * degree);
+
+    for (int i = 0; i < N; i++)
+    {
+        for (int k = 0; k < degree; k++)
+        {
+            A.row_indices[i * degree + k]    = i;
+            A.column_indices[i * degree + k] = (i + 1 + rand() % (N - 1)) % N;
+            A.values[i * degree + k]         = rand() % (max_weight + 1);
+        }
+    }
+
+    A.sort_by_row_and_column();
+    G = A;
+}
+
+template <typename MemorySpace, typename ValueType>
+void CheckShortestPaths(const cusp::csr_matrix<int,ValueType,cusp::host_memory>& G, const int src)
+{
+    std::vector<ValueType> expected;
+    dijkstra(G, src, expected);
+
+    cusp::csr_matrix<int,ValueType,MemorySpace> G_d(G);
+
+    const ValueType deltas[3] = {ValueType(1), ValueType(10), ValueType(1000)};
+
+    for (int n = 0; n <= 3; n++)
+    {
+        cusp::array1d<ValueType,MemorySpace> distances;
+
+        if (n < 3)
+            cusp::graph::single_source_shortest_paths(G_d, src, distances, deltas[n]);
+        else
+            cusp::graph::single_source_shortest_paths(G_d, src, distances);
+
+        cusp::array1d<ValueType,cusp::host_memory> h_distances(distances);
+
+        ASSERT_EQUAL(h_distances.size(), G.num_rows);
+
+        for (size_t i = 0; i < G.num_rows; i++)
+            ASSERT_EQUAL(h_distances[i], expected[i]);
+    }
+}
+
+template <class MemorySpace>
+void TestShortestPathsRandom(void)
+{
+    srand(17);
+
+    cusp::csr_matrix<int,int,cusp::host_memory> G;
+    random_weighted_graph(G, 500, 4, 40);
+
+    CheckShortestPaths<MemorySpace>(G, 0);
+    CheckShortestPaths<MemorySpace>(G, 123);
+
+    // zero weights and unreachable vertices
+    random_weighted_graph(G, 300, 1, 3);
+    CheckShortestPaths<MemorySpace>(G, 7);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestShortestPathsRandom);
+
+template <class MemorySpace>
+void TestShortestPathsGrid(void)
+{
+    cusp::csr_matrix<int,float,cusp::host_memory> G;
+    cusp::gallery::grid2d(G, 40, 30);
+
+    // weights which are exact in float, so every order of the sums agrees
+    for (size_t n = 0; n < G.num_entries; n++)
+        G.values[n] = float(1 + (G.row_offsets.size() + n * 7) % 5) * 0.25f;
+
+    CheckShortestPaths<MemorySpace>(G, 0);
+
+    // other formats are converted
+    cusp::coo_matrix<int,float,MemorySpace> C(G);
+    cusp::array1d<float,MemorySpace> distances;
+    cusp::graph::single_source_shortest_paths(C, 599, distances);
+
+    std::vector<float> expected;
+    dijkstra(G, 599, expected);
+
+    cusp::array1d<float,cusp::host_memory> h_distances(distances);
+    for (size_t i = 0; i < G.num_rows; i++)
+        ASSERT_EQUAL(h_distances[i], expected[i]);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestShortestPathsGrid);
+
+template <class MemorySpace>
+void TestShortestPathsInvalidInput(void)
+{
+    cusp::csr_matrix<int,float,cusp::host_memory> G;
+    cusp::gallery::grid2d(G, 4, 4);
+
+    cusp::array1d<float,MemorySpace> distances;
+
+    cusp::csr_matrix<int,float,MemorySpace> G_d(G);
+    ASSERT_THROWS(cusp::graph::single_source_shortest_paths(G_d, 16, distances), cusp::invalid_input_exception);
+    ASSERT_THROWS(cusp::graph::single_source_shortest_paths(G_d, 0, distances, 0.0f), cusp::invalid_input_exception);
+
+    G.values[3] = -1.0f;
+    cusp::csr_matrix<int,float,MemorySpace> negative(G);
+    ASSERT_THROWS(cusp::graph::single_source_shortest_paths(negative, 0, distances), cusp::invalid_input_exception);
+
+    cusp::csr_matrix<int,float,MemorySpace> rectangular(3, 4, 0);
+    ASSERT_THROWS(cusp::graph::single_source_shortest_paths(rectangular, 0, distances), cusp::invalid_input_exception);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestShortestPathsInvalidInput);
@@ -1,6 +1,7 @@
 #include <unittest/unittest.h>
 
 #include <cusp/precond/aggregation/smoothed_aggregation.h>
+#include <cusp/detail/device/graph.h>
 
 #include <cusp/array2d.h>
 #include <cusp/coo_matrix.h>
@@ -9,10 +10,15 @@
 #include <cusp/ell_matrix.h>
 #include <cusp/hyb_matrix.h>
 
+#include <cusp/gallery/diffusion.h>
 #include <cusp/gallery/poisson.h>
 #include <cusp/krylov/cg.h>
+#include <cusp/relaxation/polynomial.h>
 #include <cusp/print.h>
 
+#include <sstream>
+#include <vector>
+
 template <class MemorySpace>
 void TestStandardAggregation(void)
 {
@@ -28,6 +34,91 @@ void TestStandardAggregation(void)
 }
 DECLARE_HOST_DEVICE_UNITTEST(TestStandardAggregation);
 
+void TestStandardAggregationHostMatchesDevice(void)
+{
+    // the host path aggregates around the same MIS(2) as the device path
+    cusp::csr_matrix<int,float,cusp::host_memory> A;
+    cusp::gallery::poisson5pt(A, 61, 47);
+
+    cusp::array1d<int,cusp::host_memory> aggregates(A.num_rows);
+    cusp::array1d<int,cusp::host_memory> roots(A.num_rows);
+    cusp::precond::aggregation::standard_aggregation(A, aggregates, roots);
+
+    cusp::coo_matrix<int,float,cusp::device_memory> A_d(A);
+    cusp::array1d<int,cusp::device_memory> aggregates_d(A.num_rows);
+    cusp::precond::aggregation::standard_aggregation(A_d, aggregates_d);
+
+    ASSERT_EQUAL(aggregates, (cusp::array1d<int,cusp::host_memory>(aggregates_d)));
+
+    // every node is aggregated, and every root lies in its own aggregate
+    int num_aggregates = *thrust::max_element(aggregates.begin(), aggregates.end()) + 1;
+
+    ASSERT_EQUAL(*thrust::min_element(aggregates.begin(), aggregates.end()), 0);
+
+    for (int a = 0; a < num_aggregates; a++)
+        ASSERT_EQUAL(aggregates[roots[a]], a);
+
+    // isolated nodes are not aggregated
+    cusp::coo_matrix<int,float,cusp::host_memory> B(5, 5, 7);
+    B.row_indices[0] = 0; B.column_indices[0] = 0;
+    B.row_indices[1] = 0; B.column_indices[1] = 1;
+    B.row_indices[2] = 1; B.column_indices[2] = 0;
+    B.row_indices[3] = 1; B.column_indices[3] = 1;
+    B.row_indices[4] = 2; B.column_indices[4] = 2;
+    B.row_indices[5] = 3; B.column_indices[5] = 3;
+    B.row_indices[6] = 4; B.column_indices[6] = 4;
+    thrust::fill(B.values.begin(), B.values.end(), 1.0f);
+
+    cusp::csr_matrix<int,float,cusp::host_memory> B_csr(B);
+    cusp::array1d<int,cusp::host_memory> B_aggregates(5);
+    cusp::precond::aggregation::standard_aggregation(B_csr, B_aggregates);
+
+    ASSERT_EQUAL(B_aggregates[0], 0);
+    ASSERT_EQUAL(B_aggregates[1], 0);
+    ASSERT_EQUAL(B_aggregates[2], -1);
+    ASSERT_EQUAL(B_aggregates[3], -1);
+    ASSERT_EQUAL(B_aggregates[4], -1);
+}
+DECLARE_UNITTEST(TestStandardAggregationHostMatchesDevice);
+
+template <class MemorySpace>
+void TestAggressiveAggregation(void)
+{
+    typedef typename cusp::precond::aggregation::amg_container<int,float,MemorySpace>::setup_type SetupMatrixType;
+
+    SetupMatrixType A;
+    cusp::gallery::poisson5pt(A, 20, 20);
+
+    cusp::array1d<int,MemorySpace> standard(A.num_rows);
+    cusp::precond::aggregation::standard_aggregation(A, standard);
+
+    cusp::array1d<int,MemorySpace> aggressive(A.num_rows);
+    cusp::precond::aggregation::aggressive_aggregation(A, aggressive, 2);
+
+    cusp::array1d<int,cusp::host_memory> aggregates(aggressive);
+
+    int num_standard   = *thrust::max_element(standard.begin(), standard.end()) + 1;
+    int num_aggressive = *thrust::max_element(aggregates.begin(), aggregates.end()) + 1;
+
+    ASSERT_EQUAL(num_aggressive > 0, true);
+    ASSERT_EQUAL(2 * num_aggressive <= num_standard, true);
+
+    // every node is aggregated and every aggregate is used
+    cusp::array1d<int,cusp::host_memory> counts(num_aggressive, 0);
+    for (size_t i = 0; i < aggregates.size(); i++)
+    {
+        ASSERT_EQUAL(aggregates[i] >= 0, true);
+        counts[aggregates[i]]++;
+    }
+    ASSERT_EQUAL(thrust::count(counts.begin(), counts.end(), 0), 0);
+
+    // a single pass is the standard aggregation
+    cusp::precond::aggregation::aggressive_aggregation(A, aggressive, 1);
+    ASSERT_EQUAL(aggressive, standard);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestAggressiveAggregation);
+
+
 
 template <class MemorySpace>
 void TestEstimateRhoDinvA(void)
@@ -138,6 +229,73 @@ void TestFitCandidates(void)
 DECLARE_HOST_DEVICE_UNITTEST(TestFitCandidates);
 
 
+template <typename MemorySpace>
+void TestFitMultipleCandidates(void)
+{
+    typedef typename cusp::precond::aggregation::amg_container<int,float,MemorySpace>::setup_type SetupMatrixType;
+
+    // aggregates of 3, 2 and 1 nodes with 2 candidates
+    cusp::array1d<int,MemorySpace> aggregates(6);
+    aggregates[0] = 1;
+    aggregates[1] = 0;
+    aggregates[2] = 0;
+    aggregates[3] = 2;
+    aggregates[4] = 1;
+    aggregates[5] = 0;
+
+    cusp::array2d<float,cusp::host_memory,cusp::column_major> B_host(6, 2);
+    for (int i = 0; i < 6; i++)
+    {
+        B_host(i,0) = 1.0f;
+        B_host(i,1) = float(i);
+    }
+    cusp::array2d<float,MemorySpace,cusp::column_major> B(B_host);
+
+    SetupMatrixType Q_;
+    cusp::array2d<float,MemorySpace,cusp::column_major> R_;
+
+    cusp::precond::aggregation::fit_candidates(aggregates, B, Q_, R_);
+
+    // two columns for each of the first two aggregates, one for the last
+    ASSERT_EQUAL(Q_.num_rows, 6);
+    ASSERT_EQUAL(Q_.num_cols, 5);
+    ASSERT_EQUAL(R_.num_rows, 5);
+    ASSERT_EQUAL(R_.num_cols, 2);
+
+    cusp::array2d<float,cusp::host_memory> Q(Q_);
+    cusp::array2d<float,cusp::host_memory> R(R_);
+
+    // the columns of Q are orthonormal
+    for (int i = 0; i < 5; i++)
+    {
+        for (int j = 0; j < 5; j++)
+        {
+            float dot = 0.0f;
+            for (int n = 0; n < 6; n++)
+                dot += Q(n,i) * Q(n,j);
+            ASSERT_ALMOST_EQUAL(dot, i == j ? 1.0f : 0.0f);
+        }
+    }
+
+    // Q * R = B
+    for (int n = 0; n < 6; n++)
+    {
+        for (int j = 0; j < 2; j++)
+        {
+            float sum = 0.0f;
+            for (int i = 0; i < 5; i++)
+                sum += Q(n,i) * R(i,j);
+            ASSERT_ALMOST_EQUAL(sum, B_host(n,j));
+        }
+    }
+
+    // the single row aggregate only sees the constant
+    ASSERT_ALMOST_EQUAL(R(4,0), 1.0f);
+    ASSERT_ALMOST_EQUAL(R(4,1), 3.0f);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestFitMultipleCandidates);
+
+
 template <class MemorySpace>
 void TestSmoothProlongator(void)
 {
@@ -284,6 +442,164 @@ void TestSmoothProlongator(void)
 }
 DECLARE_HOST_DEVICE_UNITTEST(TestSmoothProlongator);
 
+
+template <class MemorySpace>
+void TestFilteredMatrix(void)
+{
+    typedef typename cusp::precond::aggregation::amg_container<int,float,MemorySpace>::setup_type SetupMatrixType;
+
+    cusp::array2d<float,cusp::host_memory> A_host(3, 3);
+    A_host(0,0) =  4.0f; A_host(0,1) = -0.1f; A_host(0,2) = -2.0f;
+    A_host(1,0) = -0.1f; A_host(1,1) =  4.0f; A_host(1,2) = -2.0f;
+    A_host(2,0) = -2.0f; A_host(2,1) = -2.0f; A_host(2,2) =  4.0f;
+
+    SetupMatrixType A(A_host);
+    SetupMatrixType C;
+    cusp::precond::aggregation::symmetric_strength_of_connection(A, C, 0.25);
+
+    SetupMatrixType A_F;
+    cusp::precond::aggregation::filtered_matrix(A, C, A_F);
+
+    // the weak connection between 0 and 1 moves to the diagonal
+    cusp::array2d<float,cusp::host_memory> D(A_F);
+    ASSERT_EQUAL(A_F.num_entries, 7);
+    ASSERT_ALMOST_EQUAL(D(0,0),  3.9f);
+    ASSERT_ALMOST_EQUAL(D(0,1),  0.0f);
+    ASSERT_ALMOST_EQUAL(D(0,2), -2.0f);
+    ASSERT_ALMOST_EQUAL(D(1,1),  3.9f);
+    ASSERT_ALMOST_EQUAL(D(2,2),  4.0f);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestFilteredMatrix);
+
+
+template <class MemorySpace>
+void TestEnergyMinimizationProlongator(void)
+{
+    typedef typename cusp::precond::aggregation::amg_container<int,float,MemorySpace>::setup_type SetupMatrixType;
+
+    SetupMatrixType A;
+    cusp::gallery::poisson5pt(A, 10, 10);
+
+    cusp::array1d<int,MemorySpace> aggregates(A.num_rows);
+    cusp::precond::aggregation::standard_aggregation(A, aggregates);
+
+    // constant and linear candidates
+    cusp::array2d<float,cusp::host_memory,cusp::column_major> B_host(A.num_rows, 2);
+    for (size_t i = 0; i < A.num_rows; i++)
+    {
+        B_host(i,0) = 1.0f;
+        B_host(i,1) = float(i % 10) / 10.0f;
+    }
+    cusp::array2d<float,MemorySpace,cusp::column_major> B(B_host);
+
+    SetupMatrixType T;
+    cusp::array2d<float,MemorySpace,cusp::column_major> B_coarse;
+    cusp::precond::aggregation::fit_candidates(aggregates, B, T, B_coarse);
+
+    SetupMatrixType P;
+    cusp::precond::aggregation::energy_minimization_prolongator(A, T, B_coarse, P, 4);
+
+    ASSERT_EQUAL(P.num_rows, T.num_rows);
+    ASSERT_EQUAL(P.num_cols, T.num_cols);
+
+    cusp::array2d<float,cusp::host_memory> A_dense(A);
+    cusp::array2d<float,cusp::host_memory> T_dense(T);
+    cusp::array2d<float,cusp::host_memory> P_dense(P);
+    cusp::array2d<float,cusp::host_memory,cusp::column_major> B_coarse_host(B_coarse);
+
+    // P keeps the candidates in its range
+    for (size_t i = 0; i < P_dense.num_rows; i++)
+    {
+        for (size_t j = 0; j < 2; j++)
+        {
+            float sum = 0.0f;
+            for (size_t k = 0; k < P_dense.num_cols; k++)
+                sum += P_dense(i,k) * B_coarse_host(k,j);
+            ASSERT_ALMOST_EQUAL(sum, B_host(i,j));
+        }
+    }
+
+    // and has less energy than T
+    float T_energy = 0.0f;
+    float P_energy = 0.0f;
+    for (size_t k = 0; k < P_dense.num_cols; k++)
+    {
+        for (size_t i = 0; i < A_dense.num_rows; i++)
+        {
+            for (size_t j = 0; j < A_dense.num_cols; j++)
+            {
+                T_energy += T_dense(i,k) * A_dense(i,j) * T_dense(j,k);
+                P_energy += P_dense(i,k) * A_dense(i,j) * P_dense(j,k);
+            }
+        }
+    }
+
+    ASSERT_EQUAL(P_energy < T_energy, true);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestEnergyMinimizationProlongator);
+
+
+template <class MemorySpace>
+void TestTruncateProlongator(void)
+{
+    typedef typename cusp::precond::aggregation::amg_container<int,float,MemorySpace>::setup_type SetupMatrixType;
+
+    cusp::coo_matrix<int,float,cusp::host_memory> P_host(2, 3, 4);
+    P_host.row_indices[0] = 0; P_host.column_indices[0] = 0; P_host.values[0] = 0.50f;
+    P_host.row_indices[1] = 0; P_host.column_indices[1] = 1; P_host.values[1] = 0.05f;
+    P_host.row_indices[2] = 0; P_host.column_indices[2] = 2; P_host.values[2] = 0.45f;
+    P_host.row_indices[3] = 1; P_host.column_indices[3] = 1; P_host.values[3] = 1.00f;
+
+    // relative threshold
+    {
+        SetupMatrixType P(P_host);
+        cusp::precond::aggregation::truncate_prolongator(P, 0.2f);
+
+        cusp::array2d<float,cusp::host_memory> D(P);
+        ASSERT_EQUAL(P.num_entries, 3);
+        ASSERT_ALMOST_EQUAL(D(0,0), 0.5f / 0.95f);
+        ASSERT_ALMOST_EQUAL(D(0,1), 0.0f);
+        ASSERT_ALMOST_EQUAL(D(0,2), 0.45f / 0.95f);
+        ASSERT_ALMOST_EQUAL(D(1,1), 1.0f);
+    }
+
+    // largest entry of each row
+    {
+        SetupMatrixType P(P_host);
+        cusp::precond::aggregation::truncate_prolongator(P, 0.0f, 1);
+
+        cusp::array2d<float,cusp::host_memory> D(P);
+        ASSERT_EQUAL(P.num_entries, 2);
+        ASSERT_ALMOST_EQUAL(D(0,0), 1.0f);
+        ASSERT_ALMOST_EQUAL(D(1,1), 1.0f);
+    }
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestTruncateProlongator);
+
+
+template <class MemorySpace>
+void TestFilterGalerkinProduct(void)
+{
+    typedef typename cusp::precond::aggregation::amg_container<int,float,MemorySpace>::setup_type SetupMatrixType;
+
+    cusp::array2d<float,cusp::host_memory> A_host(3, 3);
+    A_host(0,0) =  4.00f; A_host(0,1) = -0.01f; A_host(0,2) = -1.00f;
+    A_host(1,0) = -0.01f; A_host(1,1) =  4.00f; A_host(1,2) = -1.00f;
+    A_host(2,0) = -1.00f; A_host(2,1) = -1.00f; A_host(2,2) =  4.00f;
+
+    SetupMatrixType A(A_host);
+    cusp::precond::aggregation::filter_galerkin_product(A, 0.1f);
+
+    cusp::array2d<float,cusp::host_memory> D(A);
+    ASSERT_EQUAL(A.num_entries, 7);
+    ASSERT_ALMOST_EQUAL(D(0,0), 3.99f);
+    ASSERT_ALMOST_EQUAL(D(0,1), 0.00f);
+    ASSERT_ALMOST_EQUAL(D(1,0), 0.00f);
+    ASSERT_ALMOST_EQUAL(D(1,1), 3.99f);
+    ASSERT_ALMOST_EQUAL(D(2,2), 4.00f);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestFilterGalerkinProduct);
+
 template <class MemorySpace>
 void TestSmoothedAggregation(void)
 {
@@ -326,6 +642,654 @@ void TestSmoothedAggregation(void)
 DECLARE_HOST_DEVICE_UNITTEST(TestSmoothedAggregation);
 
 
+template <class MemorySpace>
+void TestSmoothedAggregationMultipleCandidates(void)
+{
+    typedef int                 IndexType;
+    typedef float               ValueType;
+
+    // Create 2D Poisson problem
+    cusp::coo_matrix<IndexType,ValueType,MemorySpace> A;
+    cusp::gallery::poisson5pt(A, 50, 50);
+
+    // the constant and the (scaled) x coordinate as candidates
+    cusp::array2d<ValueType,cusp::host_memory,cusp::column_major> B_host(A.num_rows, 2);
+    for (int i = 0; i < A.num_rows; i++)
+    {
+        B_host(i,0) = 1.0f;
+        B_host(i,1) = (i % 50) / 50.0f;
+    }
+    cusp::array2d<ValueType,MemorySpace,cusp::column_major> B(B_host);
+
+    cusp::precond::aggregation::smoothed_aggregation<IndexType,ValueType,MemorySpace> M(A, B);
+
+    ASSERT_EQUAL(M.sa_levels.size() > 1, true);
+    ASSERT_EQUAL(M.sa_levels[1].B.num_cols, 2);
+    ASSERT_EQUAL(M.sa_levels[1].B.num_rows, M.levels[1].A.num_rows);
+
+    cusp::array1d<ValueType,MemorySpace> b = unittest::random_samples<ValueType>(A.num_rows);
+    cusp::array1d<ValueType,MemorySpace> x(A.num_rows, 0);
+
+    // set stopping criteria (iteration_limit = 20, relative_tolerance = 1e-4)
+    cusp::convergence_monitor<ValueType> monitor(b, 20, 1e-4);
+    cusp::krylov::cg(A, x, b, monitor, M);
+
+    ASSERT_EQUAL(monitor.converged(), true);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestSmoothedAggregationMultipleCandidates);
+
+
+template <class MemorySpace>
+void TestSmoothedAggregationAggressiveCoarsening(void)
+{
+    typedef int                 IndexType;
+    typedef float               ValueType;
+
+    cusp::coo_matrix<IndexType,ValueType,MemorySpace> A;
+    cusp::gallery::poisson5pt(A, 100, 100);
+
+    cusp::precond::aggregation::smoothed_aggregation<IndexType,ValueType,MemorySpace> M(A);
+
+    // aggressive coarsening of the first level
+    cusp::precond::aggregation::smoothed_aggregation_options<IndexType,ValueType,MemorySpace> opts(0.0, 4.0/3.0, 100, 20, 1, 2);
+    cusp::precond::aggregation::smoothed_aggregation<IndexType,ValueType,MemorySpace> M_aggressive(A, opts);
+
+    ASSERT_EQUAL(M_aggressive.levels[1].A.num_rows < M.levels[1].A.num_rows, true);
+    ASSERT_EQUAL(M_aggressive.levels.size() <= M.levels.size(), true);
+
+    cusp::array1d<ValueType,MemorySpace> b = unittest::random_samples<ValueType>(A.num_rows);
+    cusp::array1d<ValueType,MemorySpace> x(A.num_rows, 0);
+
+    // set stopping criteria (iteration_limit = 40, relative_tolerance = 1e-4)
+    cusp::convergence_monitor<ValueType> monitor(b, 40, 1e-4);
+    cusp::krylov::cg(A, x, b, monitor, M_aggressive);
+
+    ASSERT_EQUAL(monitor.converged(), true);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestSmoothedAggregationAggressiveCoarsening);
+
+
+template <class MemorySpace>
+void TestSmoothedAggregationTruncation(void)
+{
+    typedef int                 IndexType;
+    typedef float               ValueType;
+
+    cusp::coo_matrix<IndexType,ValueType,MemorySpace> A;
+    cusp::gallery::poisson5pt(A, 100, 100);
+
+    cusp::precond::aggregation::smoothed_aggregation<IndexType,ValueType,MemorySpace> M(A);
+
+    // truncated prolongators and filtered coarse operators
+    cusp::precond::aggregation::smoothed_aggregation_options<IndexType,ValueType,MemorySpace> opts(0.0, 4.0/3.0, 100, 20, 0, 2, 0.2, 4, 0.05);
+    cusp::precond::aggregation::smoothed_aggregation<IndexType,ValueType,MemorySpace> M_truncated(A, opts);
+
+    ASSERT_EQUAL(M_truncated.operator_complexity() < M.operator_complexity(), true);
+
+    cusp::array1d<ValueType,MemorySpace> b = unittest::random_samples<ValueType>(A.num_rows);
+    cusp::array1d<ValueType,MemorySpace> x(A.num_rows, 0);
+
+    // set stopping criteria (iteration_limit = 40, relative_tolerance = 1e-4)
+    cusp::convergence_monitor<ValueType> monitor(b, 40, 1e-4);
+    cusp::krylov::cg(A, x, b, monitor, M_truncated);
+
+    ASSERT_EQUAL(monitor.converged(), true);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestSmoothedAggregationTruncation);
+
+
+template <class MemorySpace>
+void TestSmoothedAggregationProlongationSmoothers(void)
+{
+    typedef int                 IndexType;
+    typedef float               ValueType;
+
+    cusp::coo_matrix<IndexType,ValueType,MemorySpace> A;
+    cusp::gallery::poisson5pt(A, 100, 100);
+
+    cusp::array1d<ValueType,MemorySpace> b = unittest::random_samples<ValueType>(A.num_rows);
+
+    // filtered Jacobi smoothing and energy minimization
+    cusp::precond::aggregation::prolongation_smoother smoothers[2] = {
+        cusp::precond::aggregation::FILTERED_JACOBI_PROLONGATION,
+        cusp::precond::aggregation::ENERGY_MINIMIZATION };
+
+    for (int i = 0; i < 2; i++)
+    {
+        cusp::precond::aggregation::smoothed_aggregation_options<IndexType,ValueType,MemorySpace>
+            opts(0.08, 4.0/3.0, 100, 20, 0, 2, 0.0, 0, 0.0, smoothers[i], 4);
+        cusp::precond::aggregation::smoothed_aggregation<IndexType,ValueType,MemorySpace> M(A, opts);
+
+        ASSERT_EQUAL(M.levels.size() > 1, true);
+
+        cusp::array1d<ValueType,MemorySpace> x(A.num_rows, 0);
+
+        // set stopping criteria (iteration_limit = 40, relative_tolerance = 1e-4)
+        cusp::convergence_monitor<ValueType> monitor(b, 40, 1e-4);
+        cusp::krylov::cg(A, x, b, monitor, M);
+
+        ASSERT_EQUAL(monitor.converged(), true);
+    }
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestSmoothedAggregationProlongationSmoothers);
+
+
+template <class MemorySpace>
+void TestSmoothedAggregationCycles(void)
+{
+    typedef int                 IndexType;
+    typedef float               ValueType;
+
+    // anisotropic 2D problem
+    cusp::coo_matrix<IndexType,ValueType,MemorySpace> A;
+    cusp::gallery::poisson5pt(A, 60, 60);
+    {
+        cusp::coo_matrix<IndexType,ValueType,cusp::host_memory> S(A);
+        for(size_t n = 0; n < S.num_entries; n++)
+        {
+            const IndexType i = S.row_indices[n];
+            const IndexType j = S.column_indices[n];
+
+            // strong coupling along x, weak coupling along y
+            if (i == j)
+                S.values[n] = 2.02f;
+            else if (std::abs(i - j) == 1)
+                S.values[n] = -1.0f;
+            else
+                S.values[n] = -0.01f;
+        }
+        A = S;
+    }
+
+    cusp::array1d<ValueType,MemorySpace> b = unittest::random_samples<ValueType>(A.num_rows);
+
+    cusp::precond::aggregation::smoothed_aggregation<IndexType,ValueType,MemorySpace> M(A);
+
+    ASSERT_EQUAL(M.cycle, cusp::V_CYCLE);
+    ASSERT_EQUAL(M.presmooth_sweeps,  1);
+    ASSERT_EQUAL(M.postsmooth_sweeps, 1);
+    ASSERT_EQUAL(M.levels.size() > 2, true);
+
+    size_t v_iterations;
+    {
+        cusp::array1d<ValueType,MemorySpace> x(A.num_rows, 0.0f);
+        cusp::convergence_monitor<ValueType> monitor(b, 200, 1e-4);
+        M.solve(b, x, monitor);
+        ASSERT_EQUAL(monitor.converged(), true);
+        v_iterations = monitor.iteration_count();
+    }
+
+    const cusp::cycle_type cycles[3] = { cusp::W_CYCLE, cusp::F_CYCLE, cusp::K_CYCLE };
+
+    // the stronger cycles need fewer iterations
+    for(int c = 0; c < 3; c++)
+    {
+        M.set_cycle(cycles[c]);
+
+        cusp::array1d<ValueType,MemorySpace> x(A.num_rows, 0.0f);
+        cusp::convergence_monitor<ValueType> monitor(b, 200, 1e-4);
+        M.solve(b, x, monitor);
+        ASSERT_EQUAL(monitor.converged(), true);
+        ASSERT_LEQUAL(monitor.iteration_count(), v_iterations);
+    }
+
+    // more smoothing sweeps per level
+    {
+        M.set_cycle(cusp::V_CYCLE, 2, 2);
+
+        cusp::array1d<ValueType,MemorySpace> x(A.num_rows, 0.0f);
+        cusp::convergence_monitor<ValueType> monitor(b, 200, 1e-4);
+        M.solve(b, x, monitor);
+        ASSERT_EQUAL(monitor.converged(), true);
+        ASSERT_LEQUAL(monitor.iteration_count(), v_iterations);
+    }
+
+    // the W-cycle is symmetric and may precondition CG
+    {
+        M.set_cycle(cusp::W_CYCLE, 1, 1);
+
+        cusp::array1d<ValueType,MemorySpace> x(A.num_rows, 0.0f);
+        cusp::convergence_monitor<ValueType> monitor(b, 100, 1e-4);
+        cusp::krylov::cg(A, x, b, monitor, M);
+        ASSERT_EQUAL(monitor.converged(), true);
+    }
+
+    // the cycle settings are copied with the hierarchy
+    cusp::precond::aggregation::smoothed_aggregation<IndexType,ValueType,cusp::host_memory> H(M);
+    ASSERT_EQUAL(H.cycle, cusp::W_CYCLE);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestSmoothedAggregationCycles);
+
+
+void TestSmoothedAggregationHostLevels(void)
+{
+    typedef int                 IndexType;
+    typedef float               ValueType;
+    typedef cusp::device_memory MemorySpace;
+
+    cusp::coo_matrix<IndexType,ValueType,MemorySpace> A;
+    cusp::gallery::poisson5pt(A, 100, 100);
+
+    cusp::precond::aggregation::smoothed_aggregation<IndexType,ValueType,MemorySpace> M(A);
+    cusp::precond::aggregation::smoothed_aggregation<IndexType,ValueType,MemorySpace> N(A);
+
+    ASSERT_EQUAL(M.levels.size() > 2, true);
+    ASSERT_EQUAL(M.host_levels == NULL, true);
+
+    const size_t max_rows = M.levels[1].A.num_rows;
+    N.set_host_levels(max_rows);
+
+    ASSERT_EQUAL(N.host_levels != NULL, true);
+    ASSERT_EQUAL(N.host_level_begin, 1);
+    ASSERT_EQUAL(N.host_levels->levels.size(), N.levels.size() - 1);
+
+    // the cycles agree with the device hierarchy
+    const cusp::cycle_type cycles[2] = { cusp::V_CYCLE, cusp::K_CYCLE };
+
+    for(int c = 0; c < 2; c++)
+    {
+        M.set_cycle(cycles[c]);
+        N.set_cycle(cycles[c]);
+
+        cusp::array1d<ValueType,MemorySpace> b = unittest::random_samples<ValueType>(A.num_rows);
+        cusp::array1d<ValueType,MemorySpace> x(A.num_rows, 0.0f);
+        cusp::array1d<ValueType,MemorySpace> y(A.num_rows, 0.0f);
+
+        M(b, x);
+        N(b, y);
+
+        ASSERT_ALMOST_EQUAL((cusp::array1d<ValueType,cusp::host_memory>(x)), (cusp::array1d<ValueType,cusp::host_memory>(y)));
+    }
+
+    // the host levels are rebuilt by copies and by resetup
+    cusp::precond::aggregation::smoothed_aggregation<IndexType,ValueType,MemorySpace> C(N);
+    ASSERT_EQUAL(C.host_levels != NULL, true);
+    ASSERT_EQUAL(C.host_levels != N.host_levels, true);
+
+    N.resetup(A);
+    ASSERT_EQUAL(N.host_levels != NULL, true);
+
+    {
+        cusp::array1d<ValueType,MemorySpace> b = unittest::random_samples<ValueType>(A.num_rows);
+        cusp::array1d<ValueType,MemorySpace> x(A.num_rows, 0.0f);
+        cusp::convergence_monitor<ValueType> monitor(b, 20, 1e-4);
+        cusp::krylov::cg(A, x, b, monitor, N);
+        ASSERT_EQUAL(monitor.converged(), true);
+    }
+
+    // host hierarchies ignore the setting
+    cusp::precond::aggregation::smoothed_aggregation<IndexType,ValueType,cusp::host_memory> H(M);
+    H.set_host_levels(max_rows);
+    ASSERT_EQUAL(H.host_levels == NULL, true);
+
+    // disabled again
+    N.set_host_levels(0);
+    ASSERT_EQUAL(N.host_levels == NULL, true);
+}
+DECLARE_UNITTEST(TestSmoothedAggregationHostLevels);
+
+
+template <class MemorySpace>
+void TestSmoothedAggregationSolveOnly(void)
+{
+    typedef int   IndexType;
+    typedef float ValueType;
+
+    cusp::coo_matrix<IndexType,ValueType,MemorySpace> A;
+    cusp::gallery::poisson5pt(A, 100, 100);
+
+    cusp::precond::aggregation::smoothed_aggregation<IndexType,ValueType,MemorySpace> M(A);
+    cusp::precond::aggregation::smoothed_aggregation<IndexType,ValueType,MemorySpace> N(A);
+
+    ASSERT_EQUAL(N.levels.size() > 2, true);
+
+    N.set_solve_only(true);
+    N.set_implicit_restriction(true);
+
+    for(size_t lvl = 0; lvl < N.levels.size(); lvl++)
+    {
+        ASSERT_EQUAL(N.sa_levels[lvl].A_.num_entries, 0);
+        ASSERT_EQUAL(N.levels[lvl].R.num_entries, 0);
+        ASSERT_EQUAL(N.levels[lvl].A.num_entries, M.levels[lvl].A.num_entries);
+    }
+
+    // restricting with P^T gives the same cycle
+    cusp::array1d<ValueType,MemorySpace> b = unittest::random_samples<ValueType>(A.num_rows);
+    cusp::array1d<ValueType,MemorySpace> x(A.num_rows, 0.0f);
+    cusp::array1d<ValueType,MemorySpace> y(A.num_rows, 0.0f);
+
+    M(b, x);
+    N(b, y);
+
+    ASSERT_ALMOST_EQUAL((cusp::array1d<ValueType,cusp::host_memory>(x)), (cusp::array1d<ValueType,cusp::host_memory>(y)));
+
+    // resetup rebuilds the levels and releases the copies again
+    N.resetup(A);
+
+    for(size_t lvl = 0; lvl < N.levels.size(); lvl++)
+    {
+        ASSERT_EQUAL(N.sa_levels[lvl].A_.num_entries, 0);
+        ASSERT_EQUAL(N.levels[lvl].R.num_entries, 0);
+    }
+
+    {
+        cusp::array1d<ValueType,MemorySpace> x(A.num_rows, 0.0f);
+        cusp::convergence_monitor<ValueType> monitor(b, 20, 1e-4);
+        cusp::krylov::cg(A, x, b, monitor, N);
+        ASSERT_EQUAL(monitor.converged(), true);
+    }
+
+    // the explicit restriction is formed again
+    N.set_implicit_restriction(false);
+
+    for(size_t lvl = 0; lvl + 1 < N.levels.size(); lvl++)
+        ASSERT_EQUAL(N.levels[lvl].R.num_entries, M.levels[lvl].R.num_entries);
+
+    cusp::blas::fill(y, 0.0f);
+    N(b, y);
+
+    ASSERT_ALMOST_EQUAL((cusp::array1d<ValueType,cusp::host_memory>(x)), (cusp::array1d<ValueType,cusp::host_memory>(y)));
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestSmoothedAggregationSolveOnly);
+
+
+void TestSmoothedAggregationGraphCapture(void)
+{
+    typedef int                 IndexType;
+    typedef float               ValueType;
+    typedef cusp::device_memory MemorySpace;
+
+    cusp::coo_matrix<IndexType,ValueType,MemorySpace> A;
+    cusp::gallery::poisson5pt(A, 100, 100);
+
+    cusp::precond::aggregation::smoothed_aggregation<IndexType,ValueType,MemorySpace> M(A);
+    cusp::precond::aggregation::smoothed_aggregation<IndexType,ValueType,MemorySpace> N(A);
+
+    ASSERT_EQUAL(N.graph_capture, false);
+    N.set_graph_capture(true);
+
+    const size_t instantiations = cusp::detail::device::captured_graph::instantiations();
+
+    const cusp::cycle_type cycles[2] = { cusp::V_CYCLE, cusp::W_CYCLE };
+
+    for(int c = 0; c < 2; c++)
+    {
+        M.set_cycle(cycles[c], 2, 1);
+        N.set_cycle(cycles[c], 2, 1);
+
+        cusp::array1d<ValueType,MemorySpace> b(A.num_rows);
+        cusp::array1d<ValueType,MemorySpace> x(A.num_rows, 0.0f);
+        cusp::array1d<ValueType,MemorySpace> y(A.num_rows, 0.0f);
+
+        // warm-up, capture and two replays with new contents of b
+        for(int k = 0; k < 4; k++)
+        {
+            b = unittest::random_samples<ValueType>(A.num_rows);
+
+            M(b, x);
+            N(b, y);
+
+            ASSERT_ALMOST_EQUAL((cusp::array1d<ValueType,cusp::host_memory>(x)), (cusp::array1d<ValueType,cusp::host_memory>(y)));
+        }
+
+        // other vectors are warmed up and captured again
+        cusp::array1d<ValueType,MemorySpace> z(A.num_rows, 0.0f);
+
+        for(int k = 0; k < 3; k++)
+        {
+            N(b, z);
+            ASSERT_ALMOST_EQUAL((cusp::array1d<ValueType,cusp::host_memory>(x)), (cusp::array1d<ValueType,cusp::host_memory>(z)));
+        }
+    }
+
+    // the cycles were replayed from graphs rather than run directly
+    if (cusp::detail::device::captured_graph::supported())
+    {
+        ASSERT_EQUAL(N.graph_capture, true);
+        ASSERT_EQUAL(cusp::detail::device::captured_graph::instantiations() >= instantiations + 4, true);
+    }
+
+    // the K-cycle runs without a graph
+    M.set_cycle(cusp::K_CYCLE);
+    N.set_cycle(cusp::K_CYCLE);
+
+    cusp::array1d<ValueType,MemorySpace> b = unittest::random_samples<ValueType>(A.num_rows);
+    cusp::array1d<ValueType,MemorySpace> x(A.num_rows, 0.0f);
+    cusp::array1d<ValueType,MemorySpace> y(A.num_rows, 0.0f);
+
+    for(int k = 0; k < 3; k++)
+    {
+        M(b, x);
+        N(b, y);
+    }
+
+    ASSERT_ALMOST_EQUAL((cusp::array1d<ValueType,cusp::host_memory>(x)), (cusp::array1d<ValueType,cusp::host_memory>(y)));
+}
+DECLARE_UNITTEST(TestSmoothedAggregationGraphCapture);
+
+
+template <class MemorySpace>
+void TestSmoothedAggregationSetupTimings(void)
+{
+    typedef int                 IndexType;
+    typedef float               ValueType;
+
+    cusp::coo_matrix<IndexType,ValueType,MemorySpace> A;
+    cusp::gallery::poisson5pt(A, 50, 50);
+
+    cusp::precond::aggregation::smoothed_aggregation<IndexType,ValueType,MemorySpace> M(A);
+
+    ASSERT_EQUAL(M.sa_levels.size() > 1, true);
+
+    // every level except the coarsest records the time of each setup stage
+    for (size_t lvl = 0; lvl < M.sa_levels.size() - 1; lvl++)
+    {
+        const cusp::precond::aggregation::sa_level_timings& timings = M.sa_levels[lvl].timings;
+
+        ASSERT_EQUAL(timings.strength    >= 0.0, true);
+        ASSERT_EQUAL(timings.aggregate   >= 0.0, true);
+        ASSERT_EQUAL(timings.tentative   >= 0.0, true);
+        ASSERT_EQUAL(timings.smooth      >= 0.0, true);
+        ASSERT_EQUAL(timings.restriction >= 0.0, true);
+        ASSERT_EQUAL(timings.galerkin    >= 0.0, true);
+        ASSERT_EQUAL(timings.total() > 0.0, true);
+    }
+
+    ASSERT_EQUAL(M.sa_levels.back().timings.total(), 0.0);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestSmoothedAggregationSetupTimings);
+
+template <class MemorySpace>
+void TestSmoothedAggregationProfile(void)
+{
+    typedef int                 IndexType;
+    typedef float               ValueType;
+
+    cusp::coo_matrix<IndexType,ValueType,MemorySpace> A;
+    cusp::gallery::poisson5pt(A, 50, 50);
+
+    cusp::precond::aggregation::smoothed_aggregation<IndexType,ValueType,MemorySpace> M(A);
+    M.set_profiling(true);
+
+    cusp::array1d<ValueType,MemorySpace> b(A.num_rows, 1.0f);
+    cusp::array1d<ValueType,MemorySpace> x(A.num_rows, 0.0f);
+    cusp::array1d<ValueType,MemorySpace> y(A.num_rows, 0.0f);
+
+    // profiling does not change the cycle
+    M(b, x);
+    M(b, x);
+    M.set_profiling(false);
+    M(b, y);
+    M(b, y);
+
+    cusp::array1d<ValueType,cusp::host_memory> x_h(x);
+    cusp::array1d<ValueType,cusp::host_memory> y_h(y);
+    ASSERT_ALMOST_EQUAL(x_h, y_h);
+
+    M.set_profiling(true);
+    M(b, x);
+    M(b, x);
+
+    // every level is visited once per V-cycle
+    for (size_t lvl = 0; lvl < M.levels.size(); lvl++)
+    {
+        const cusp::multilevel_level_timings& timings = M.levels[lvl].timings;
+
+        ASSERT_EQUAL(timings.visits, size_t(2));
+        ASSERT_EQUAL(timings.presmooth    >= 0.0, true);
+        ASSERT_EQUAL(timings.residual     >= 0.0, true);
+        ASSERT_EQUAL(timings.restriction  >= 0.0, true);
+        ASSERT_EQUAL(timings.prolongation >= 0.0, true);
+        ASSERT_EQUAL(timings.postsmooth   >= 0.0, true);
+        ASSERT_EQUAL(timings.coarse_solve >= 0.0, true);
+    }
+
+    std::ostringstream oss;
+    M.write_profile(oss);
+    const std::string report = oss.str();
+
+    ASSERT_EQUAL(report.find("\"setup\"") != std::string::npos, true);
+    ASSERT_EQUAL(report.find("\"solve\"") != std::string::npos, true);
+    ASSERT_EQUAL(report.find("\"effective_gbytes_per_second\"") != std::string::npos, true);
+
+    std::ostringstream last_level;
+    last_level << "{\"level\": " << M.levels.size() - 1 << ", \"rows\"";
+    ASSERT_EQUAL(report.find(last_level.str()) != std::string::npos, true);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestSmoothedAggregationProfile);
+
+
+template <class MemorySpace>
+void TestSmoothedAggregationResetup(void)
+{
+    typedef int                 IndexType;
+    typedef float               ValueType;
+
+    cusp::coo_matrix<IndexType,ValueType,MemorySpace> A;
+    cusp::gallery::poisson5pt(A, 100, 100);
+
+    cusp::precond::aggregation::smoothed_aggregation<IndexType,ValueType,MemorySpace> M(A);
+
+    const size_t num_levels = M.levels.size();
+    const size_t num_coarse = M.levels.back().A.num_rows;
+
+    // same pattern, new values
+    cusp::coo_matrix<IndexType,ValueType,MemorySpace> A2(A);
+    cusp::blas::scal(A2.values, ValueType(3));
+
+    M.resetup(A2);
+
+    ASSERT_EQUAL(M.levels.size(), num_levels);
+    ASSERT_EQUAL(M.levels.back().A.num_rows, num_coarse);
+
+    cusp::array1d<ValueType,MemorySpace> b = unittest::random_samples<ValueType>(A2.num_rows);
+    cusp::array1d<ValueType,MemorySpace> x = unittest::random_samples<ValueType>(A2.num_rows);
+
+    cusp::convergence_monitor<ValueType> monitor(b, 20, 1e-4);
+    cusp::krylov::cg(A2, x, b, monitor, M);
+
+    ASSERT_EQUAL(monitor.converged(), true);
+    ASSERT_EQUAL(monitor.geometric_rate() < 0.5, true);
+
+    // mismatched dimensions are rejected
+    cusp::coo_matrix<IndexType,ValueType,MemorySpace> B;
+    cusp::gallery::poisson5pt(B, 10, 10);
+
+    ASSERT_THROWS(M.resetup(B), cusp::invalid_input_exception);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestSmoothedAggregationResetup);
+
+
+template <class MemorySpace>
+void TestSmoothedAggregationLevelFormats(void)
+{
+    typedef int                 IndexType;
+    typedef float               ValueType;
+
+    cusp::coo_matrix<IndexType,ValueType,MemorySpace> A;
+    cusp::gallery::poisson5pt(A, 60, 60);
+
+    cusp::precond::aggregation::smoothed_aggregation<IndexType,ValueType,MemorySpace> M(A);
+    cusp::precond::aggregation::smoothed_aggregation<IndexType,ValueType,MemorySpace> N(A);
+
+    const size_t num_levels = M.levels.size();
+
+    cusp::array1d<ValueType,MemorySpace> b = unittest::random_samples<ValueType>(A.num_rows);
+    cusp::array1d<ValueType,MemorySpace> x(A.num_rows, 0.0f);
+    M(b, x);
+
+    const cusp::level_format formats[4] = { cusp::LEVEL_AUTO, cusp::LEVEL_CSR, cusp::LEVEL_DENSE, cusp::LEVEL_HYB };
+
+    // every format gives the same cycle
+    for (size_t f = 0; f < 4; f++)
+    {
+        if (formats[f] == cusp::LEVEL_DENSE)
+        {
+            // only the coarse levels are small enough
+            std::vector<cusp::level_format> level_formats(num_levels, cusp::LEVEL_DENSE);
+            level_formats[0] = cusp::LEVEL_DIA;
+            N.set_level_formats(level_formats);
+        }
+        else
+        {
+            N.set_level_formats(formats[f]);
+        }
+
+        for (size_t lvl = 0; lvl < num_levels; lvl++)
+            ASSERT_EQUAL(N.levels[lvl].A_op.empty(), false);
+
+        cusp::array1d<ValueType,MemorySpace> y(A.num_rows, 0.0f);
+        N(b, y);
+
+        ASSERT_ALMOST_EQUAL((cusp::array1d<ValueType,cusp::host_memory>(x)), (cusp::array1d<ValueType,cusp::host_memory>(y)));
+    }
+
+    // LEVEL_AUTO resolves to a format on every level, never dense on the fine level
+    N.set_level_formats(cusp::LEVEL_AUTO);
+    ASSERT_EQUAL(N.levels[0].A_format != cusp::LEVEL_DENSE, true);
+    for (size_t lvl = 0; lvl < num_levels; lvl++)
+        ASSERT_EQUAL(N.levels[lvl].A_format != cusp::LEVEL_AUTO && N.levels[lvl].A_format != cusp::LEVEL_MATRIX_TYPE, true);
+
+    std::ostringstream oss;
+    N.write_profile(oss);
+    ASSERT_EQUAL(oss.str().find("\"format\"") != std::string::npos, true);
+
+    // the K-cycle applies them too
+    M.set_cycle(cusp::K_CYCLE);
+    N.set_cycle(cusp::K_CYCLE);
+    {
+        cusp::array1d<ValueType,MemorySpace> y(A.num_rows, 0.0f);
+        cusp::array1d<ValueType,MemorySpace> z(A.num_rows, 0.0f);
+        M(b, y);
+        N(b, z);
+        ASSERT_ALMOST_EQUAL((cusp::array1d<ValueType,cusp::host_memory>(y)), (cusp::array1d<ValueType,cusp::host_memory>(z)));
+    }
+
+    // resetup converts the new values
+    cusp::coo_matrix<IndexType,ValueType,MemorySpace> A2(A);
+    cusp::blas::scal(A2.values, ValueType(3));
+    M.set_cycle(cusp::V_CYCLE);
+    N.set_cycle(cusp::V_CYCLE);
+    M.resetup(A2);
+    N.resetup(A2);
+    {
+        cusp::array1d<ValueType,MemorySpace> y(A.num_rows, 0.0f);
+        cusp::array1d<ValueType,MemorySpace> z(A.num_rows, 0.0f);
+        M(b, y);
+        N(b, z);
+        ASSERT_ALMOST_EQUAL((cusp::array1d<ValueType,cusp::host_memory>(y)), (cusp::array1d<ValueType,cusp::host_memory>(z)));
+    }
+
+    // the matrix type again
+    N.set_level_formats(cusp::LEVEL_MATRIX_TYPE);
+    ASSERT_EQUAL(N.levels[0].A_op.empty(), true);
+
+    ASSERT_THROWS(N.set_level_formats(std::vector<cusp::level_format>(num_levels + 1, cusp::LEVEL_CSR)),
+                  cusp::invalid_input_exception);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestSmoothedAggregationLevelFormats);
+
+
 template <typename SparseMatrix>
 void TestSymmetricStrengthOfConnection(void)
 {
@@ -455,3 +1419,208 @@ void TestSymmetricStrengthOfConnection(void)
 }
 DECLARE_SPARSE_MATRIX_UNITTEST(TestSymmetricStrengthOfConnection);
 
+void TestSymmetricStrengthOfConnectionLarge(void)
+{
+    // large enough for the host CSR path to split the rows among threads
+    cusp::coo_matrix<int,float,cusp::host_memory> A;
+    cusp::gallery::poisson5pt(A, 150, 130);
+
+    for (size_t n = 0; n < A.num_entries; n++)
+        if (A.row_indices[n] != A.column_indices[n] && (A.row_indices[n] + A.column_indices[n]) % 7 == 0)
+            A.values[n] = -0.1f;
+
+    cusp::coo_matrix<int,float,cusp::host_memory> S_coo;
+    cusp::precond::aggregation::symmetric_strength_of_connection(A, S_coo, 0.25);
+
+    cusp::csr_matrix<int,float,cusp::host_memory> A_csr(A);
+    cusp::csr_matrix<int,float,cusp::host_memory> S_csr;
+    cusp::precond::aggregation::symmetric_strength_of_connection(A_csr, S_csr, 0.25);
+
+    ASSERT_EQUAL(S_csr.num_entries < A.num_entries, true);
+
+    cusp::coo_matrix<int,float,cusp::host_memory> S(S_csr);
+    ASSERT_EQUAL(S.num_entries,    S_coo.num_entries);
+    ASSERT_EQUAL(S.row_indices,    S_coo.row_indices);
+    ASSERT_EQUAL(S.column_indices, S_coo.column_indices);
+    ASSERT_EQUAL(S.values,         S_coo.values);
+}
+DECLARE_UNITTEST(TestSymmetricStrengthOfConnectionLarge);
+
+
+// S keeps the diagonal and the strong (x direction) couplings of the
+// anisotropic problem A, with the values of A, and drops the weak ones
+template <typename Matrix>
+void CheckAnisotropicStrength(const Matrix& A_, const Matrix& S_)
+{
+    cusp::coo_matrix<int,float,cusp::host_memory> A(A_);
+    cusp::array2d<float,cusp::host_memory> S(S_);
+
+    ASSERT_EQUAL(S.num_rows, A.num_rows);
+    ASSERT_EQUAL(S.num_cols, A.num_cols);
+
+    size_t num_strong = 0;
+
+    for (size_t n = 0; n < A.num_entries; n++)
+    {
+        const int i = A.row_indices[n];
+        const int j = A.column_indices[n];
+
+        if (i == j)
+            ASSERT_EQUAL(S(i,j), A.values[n]);
+        else if (S(i,j) != 0.0f)
+        {
+            ASSERT_EQUAL(S(i,j), A.values[n]);
+            ASSERT_EQUAL(S(j,i) != 0.0f, true);
+            ASSERT_EQUAL(std::abs(A.values[n]) > 0.5f, true);
+            num_strong++;
+        }
+    }
+
+    ASSERT_EQUAL(num_strong > 0, true);
+}
+
+template <class MemorySpace>
+void TestEvolutionStrengthOfConnection(void)
+{
+    typedef typename cusp::precond::aggregation::amg_container<int,float,MemorySpace>::setup_type SetupMatrixType;
+
+    SetupMatrixType A;
+    cusp::gallery::diffusion<cusp::gallery::FD>(A, 20, 20, 0.001, 0.0);
+
+    SetupMatrixType S;
+    cusp::precond::aggregation::evolution_strength_of_connection(A, S);
+
+    CheckAnisotropicStrength(A, S);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestEvolutionStrengthOfConnection);
+
+template <class MemorySpace>
+void TestAlgebraicDistanceStrengthOfConnection(void)
+{
+    typedef typename cusp::precond::aggregation::amg_container<int,float,MemorySpace>::setup_type SetupMatrixType;
+
+    SetupMatrixType A;
+    cusp::gallery::diffusion<cusp::gallery::FD>(A, 20, 20, 0.001, 0.0);
+
+    SetupMatrixType S;
+    cusp::precond::aggregation::algebraic_distance_strength_of_connection(A, S);
+
+    CheckAnisotropicStrength(A, S);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestAlgebraicDistanceStrengthOfConnection);
+
+template <class MemorySpace>
+void TestSmoothedAggregationStrengthMeasures(void)
+{
+    typedef int                 IndexType;
+    typedef float               ValueType;
+
+    cusp::coo_matrix<IndexType,ValueType,MemorySpace> A;
+    cusp::gallery::diffusion<cusp::gallery::FD>(A, 100, 100, 0.001, 0.0);
+
+    cusp::array1d<ValueType,MemorySpace> b = unittest::random_samples<ValueType>(A.num_rows);
+
+    cusp::precond::aggregation::strength_measure measures[2] = {
+        cusp::precond::aggregation::EVOLUTION_STRENGTH,
+        cusp::precond::aggregation::ALGEBRAIC_DISTANCE_STRENGTH };
+
+    for (int i = 0; i < 2; i++)
+    {
+        cusp::precond::aggregation::smoothed_aggregation_options<IndexType,ValueType,MemorySpace>
+            opts(2.0, 4.0/3.0, 100, 20, 0, 2, 0.0, 0, 0.0,
+                 cusp::precond::aggregation::JACOBI_PROLONGATION, 4, measures[i]);
+        cusp::precond::aggregation::smoothed_aggregation<IndexType,ValueType,MemorySpace> M(A, opts);
+
+        ASSERT_EQUAL(M.levels.size() > 1, true);
+
+        cusp::array1d<ValueType,MemorySpace> x(A.num_rows, 0);
+
+        // set stopping criteria (iteration_limit = 100, relative_tolerance = 1e-4)
+        cusp::convergence_monitor<ValueType> monitor(b, 100, 1e-4);
+        cusp::krylov::cg(A, x, b, monitor, M);
+
+        ASSERT_EQUAL(monitor.converged(), true);
+    }
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestSmoothedAggregationStrengthMeasures);
+
+
+template <class MemorySpace>
+void TestSmoothedAggregationSpectralRadiusEstimates(void)
+{
+    typedef int                 IndexType;
+    typedef float               ValueType;
+    typedef cusp::relaxation::polynomial<ValueType,MemorySpace> Smoother;
+
+    cusp::coo_matrix<IndexType,ValueType,MemorySpace> A;
+    cusp::gallery::poisson5pt(A, 100, 100);
+
+    cusp::array1d<ValueType,MemorySpace> b = unittest::random_samples<ValueType>(A.num_rows);
+
+    cusp::precond::aggregation::spectral_radius_estimate estimates[3] = {
+        cusp::precond::aggregation::RITZ_SPECTRAL_RADIUS,
+        cusp::precond::aggregation::POWER_SPECTRAL_RADIUS,
+        cusp::precond::aggregation::DISKS_SPECTRAL_RADIUS };
+
+    ValueType rho[3];
+
+    for (int i = 0; i < 3; i++)
+    {
+        cusp::precond::aggregation::smoothed_aggregation_options<IndexType,ValueType,MemorySpace>
+            opts(0.0, 4.0/3.0, 100, 20, 0, 2, 0.0, 0, 0.0,
+                 cusp::precond::aggregation::JACOBI_PROLONGATION, 4,
+                 cusp::precond::aggregation::SYMMETRIC_STRENGTH, estimates[i]);
+        cusp::precond::aggregation::smoothed_aggregation<IndexType,ValueType,MemorySpace,Smoother> M(A, opts);
+
+        ASSERT_EQUAL(M.levels.size() > 1, true);
+
+        // rho(D^-1 A) of the 5-point Laplacian is below 2
+        rho[i] = M.sa_levels[0].rho_DinvA;
+        ASSERT_EQUAL(rho[i] > 1.5f && rho[i] <= 2.0f + 1e-5f, true);
+
+        cusp::array1d<ValueType,MemorySpace> x(A.num_rows, 0);
+
+        // set stopping criteria (iteration_limit = 100, relative_tolerance = 1e-4)
+        cusp::convergence_monitor<ValueType> monitor(b, 100, 1e-4);
+        cusp::krylov::cg(A, x, b, monitor, M);
+
+        ASSERT_EQUAL(monitor.converged(), true);
+    }
+
+    // the Gershgorin bound is an upper bound
+    ASSERT_EQUAL(rho[2] >= rho[0] && rho[2] >= rho[1], true);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestSmoothedAggregationSpectralRadiusEstimates);
+
+
+
+template <class MemorySpace>
+void TestSmoothedAggregationMixedPrecision(void)
+{
+    typedef int                 IndexType;
+    typedef double              ValueType;
+    typedef float               SolveValueType;
+
+    typedef cusp::relaxation::jacobi<ValueType,MemorySpace>             Smoother;
+    typedef cusp::detail::dense_inverse_solver<ValueType,MemorySpace>   Solver;
+
+    cusp::coo_matrix<IndexType,ValueType,MemorySpace> A;
+    cusp::gallery::poisson5pt(A, 100, 100);
+
+    // double setup and vectors, float operators in the cycle
+    cusp::precond::aggregation::smoothed_aggregation<IndexType,ValueType,MemorySpace,Smoother,Solver,SolveValueType> M(A);
+
+    typedef typename cusp::precond::aggregation::amg_container<IndexType,ValueType,MemorySpace,SolveValueType>::solve_type SolveMatrixType;
+    ASSERT_EQUAL(sizeof(typename SolveMatrixType::value_type), sizeof(float));
+
+    cusp::array1d<ValueType,MemorySpace> b = unittest::random_samples<ValueType>(A.num_rows);
+    cusp::array1d<ValueType,MemorySpace> x = unittest::random_samples<ValueType>(A.num_rows);
+
+    // the preconditioner is applied in reduced precision, the outer
+    // iteration still reaches a tolerance below float precision
+    cusp::convergence_monitor<ValueType> monitor(b, 40, 1e-9);
+    cusp::krylov::cg(A, x, b, monitor, M);
+
+    ASSERT_EQUAL(monitor.converged(), true);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestSmoothedAggregationMixedPrecision);
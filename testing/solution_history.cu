@@ -0,0 +1,111 @@
+#include <unittest/unittest.h>
+
+#include <cusp/gallery/poisson.h>
+#include <cusp/csr_matrix.h>
+#include <cusp/monitor.h>
+#include <cusp/multiply.h>
+#include <cusp/krylov/cg.h>
+#include <cusp/krylov/solution_history.h>
+
+template <class MemorySpace>
+void TestSolutionHistoryExtrapolation(void)
+{
+    typedef cusp::array1d<float, MemorySpace> Array;
+
+    cusp::csr_matrix<int, float, MemorySpace> A;
+    cusp::gallery::poisson5pt(A, 10, 10);
+
+    Array u = unittest::random_samples<float>(A.num_rows);
+    Array v = unittest::random_samples<float>(A.num_rows);
+    Array w = unittest::random_samples<float>(A.num_rows);
+    Array b(A.num_rows, 1.0f);
+
+    cusp::krylov::solution_history<float, MemorySpace> history(3, cusp::krylov::polynomial_extrapolation);
+
+    // x_t = u + t v + t^2 w is reproduced once three solutions are known
+    for (int t = 0; t < 6; t++)
+    {
+        Array expected(A.num_rows);
+        cusp::blas::axpbypcz(u, v, w, expected, 1.0f, float(t), float(t * t));
+
+        if (t >= 3)
+        {
+            Array x(A.num_rows, 0.0f);
+            history.initial_guess(A, x, b);
+            ASSERT_ALMOST_EQUAL(x, expected);
+        }
+
+        history.push(expected);
+        ASSERT_EQUAL(history.size(), size_t(t < 3 ? t + 1 : 3));
+    }
+
+    // a single solution is the guess itself
+    cusp::krylov::solution_history<float, MemorySpace> constant(1, cusp::krylov::polynomial_extrapolation);
+    constant.push(u);
+
+    Array x(A.num_rows, 0.0f);
+    constant.initial_guess(A, x, b);
+    ASSERT_ALMOST_EQUAL(x, u);
+
+    history.clear();
+    ASSERT_EQUAL(history.size(), size_t(0));
+
+    // an empty history leaves x alone
+    Array y(v);
+    history.initial_guess(A, y, b);
+    ASSERT_EQUAL(y, v);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestSolutionHistoryExtrapolation);
+
+template <class MemorySpace>
+void TestSolutionHistoryMinimalResidual(void)
+{
+    typedef cusp::array1d<float, MemorySpace> Array;
+
+    cusp::csr_matrix<int, float, MemorySpace> A;
+    cusp::gallery::poisson5pt(A, 20, 20);
+
+    Array b0 = unittest::random_samples<float>(A.num_rows);
+    Array b1 = unittest::random_samples<float>(A.num_rows);
+
+    cusp::krylov::solution_history<float, MemorySpace> history(4);
+
+    // right-hand sides b0 + t b1 lie in the span of the first two
+    // solutions, so the later solves start almost converged
+    size_t first_iterations = 0;
+
+    for (int t = 0; t < 5; t++)
+    {
+        Array b(A.num_rows);
+        cusp::blas::axpby(b0, b1, b, 1.0f, float(t));
+
+        Array x(A.num_rows, 0.0f);
+        cusp::default_monitor<float> monitor(b, 500, 1e-5);
+        history.cg(A, x, b, monitor);
+
+        ASSERT_EQUAL(monitor.converged(), true);
+
+        Array residual(A.num_rows);
+        cusp::multiply(A, x, residual);
+        cusp::blas::axpby(residual, b, residual, -1.0f, 1.0f);
+        ASSERT_EQUAL(cusp::blas::nrm2(residual) <= 1e-4 * cusp::blas::nrm2(b), true);
+
+        if (t == 0)
+            first_iterations = monitor.iteration_count();
+        else if (t >= 2)
+            ASSERT_EQUAL(monitor.iteration_count() < first_iterations / 2, true);
+    }
+
+    ASSERT_EQUAL(history.size(), size_t(4));
+
+    // the guess is never worse than the zero vector
+    Array b = unittest::random_samples<float>(A.num_rows);
+    Array x(A.num_rows, 0.0f);
+    history.initial_guess(A, x, b);
+
+    Array residual(A.num_rows);
+    cusp::multiply(A, x, residual);
+    cusp::blas::axpby(residual, b, residual, -1.0f, 1.0f);
+    ASSERT_EQUAL(cusp::blas::nrm2(residual) <= cusp::blas::nrm2(b) * 1.0001f, true);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestSolutionHistoryMinimalResidual);
@@ -0,0 +1,159 @@
+#include <unittest/unittest.h>
+
+#include <cusp/solve_scheduler.h>
+
+#include <cusp/array1d.h>
+#include <cusp/csr_matrix.h>
+#include <cusp/monitor.h>
+#include <cusp/gallery/poisson.h>
+#include <cusp/krylov/cg.h>
+
+#include <vector>
+
+void TestSolveSchedulerMatchesSolver(void)
+{
+    typedef cusp::csr_matrix<int, float, cusp::host_memory> Matrix;
+    typedef cusp::array1d<float, cusp::host_memory>         Array;
+
+    Matrix A, B;
+    cusp::gallery::poisson5pt(A, 20, 20);
+    cusp::gallery::poisson5pt(B, 15, 25);
+
+    const size_t num_tasks = 12;
+
+    std::vector<Array> b(num_tasks), x(num_tasks);
+
+    // two workers on the device share a cache of two matrices
+    std::vector<int> devices(1, 0);
+    cusp::solve_scheduler<int, float> scheduler(devices, 2, 2);
+
+    ASSERT_EQUAL(scheduler.devices().size(), size_t(1));
+
+    for (size_t i = 0; i < num_tasks; i++)
+    {
+        const Matrix& M = (i % 2) ? B : A;
+
+        b[i].resize(M.num_rows, float(i + 1));
+        x[i].resize(M.num_rows, 0.0f);
+
+        ASSERT_EQUAL(scheduler.submit(M, b[i], x[i]), i);
+    }
+
+    std::vector<cusp::solve_report> reports = scheduler.run();
+
+    ASSERT_EQUAL(reports.size(), num_tasks);
+
+    size_t copies = 0;
+
+    for (size_t i = 0; i < num_tasks; i++)
+    {
+        ASSERT_EQUAL(reports[i].task, i);
+        ASSERT_EQUAL(reports[i].completed, true);
+        ASSERT_EQUAL(reports[i].converged, true);
+        ASSERT_EQUAL(reports[i].device, 0);
+        ASSERT_EQUAL(reports[i].solve_milliseconds >= 0.0f, true);
+
+        if (!reports[i].matrix_cached)
+            copies++;
+
+        // the same iterates as a direct solve
+        cusp::csr_matrix<int, float, cusp::device_memory> M((i % 2) ? B : A);
+        cusp::array1d<float, cusp::device_memory> y(M.num_rows, 0.0f);
+        cusp::array1d<float, cusp::device_memory> c(b[i]);
+        cusp::default_monitor<float> monitor(c, 500, 1e-5f);
+
+        cusp::krylov::cg(M, y, c, monitor);
+
+        ASSERT_EQUAL(reports[i].iterations, monitor.iteration_count());
+        ASSERT_ALMOST_EQUAL(x[i], Array(y));
+    }
+
+    // each matrix is copied at most once per worker racing on its first use
+    ASSERT_EQUAL(copies >= 2 && copies <= 4, true);
+
+    // the queue is empty after a run
+    ASSERT_EQUAL(scheduler.run().size(), size_t(0));
+}
+DECLARE_UNITTEST(TestSolveSchedulerMatchesSolver);
+
+void TestSolveSchedulerHierarchyCache(void)
+{
+    cusp::csr_matrix<int, double, cusp::host_memory> A;
+    cusp::gallery::poisson5pt(A, 40, 40);
+
+    const size_t num_tasks = 6;
+
+    std::vector< cusp::array1d<double, cusp::host_memory> > b(num_tasks), x(num_tasks);
+
+    // one worker, so every task after the first reuses its hierarchy
+    std::vector<int> devices(1, 0);
+    cusp::solve_scheduler<int, double> scheduler(devices, 1, 1);
+
+    const cusp::solve_config config(cusp::scheduled_cg, cusp::scheduled_smoothed_aggregation, 100, 1e-8);
+
+    for (size_t i = 0; i < num_tasks; i++)
+    {
+        b[i].resize(A.num_rows, double(i) - 2.5);
+        x[i].resize(A.num_rows, 0.0);
+        scheduler.submit(A, b[i], x[i], config);
+    }
+
+    std::vector<cusp::solve_report> reports = scheduler.run();
+
+    for (size_t i = 0; i < num_tasks; i++)
+    {
+        ASSERT_EQUAL(reports[i].completed, true);
+        ASSERT_EQUAL(reports[i].converged, true);
+        ASSERT_EQUAL(reports[i].matrix_cached, i > 0);
+        ASSERT_EQUAL(reports[i].hierarchy_cached, i > 0);
+    }
+
+    // after invalidate the matrix is copied and set up again
+    scheduler.invalidate(A);
+    scheduler.submit(A, b[0], x[0], config);
+
+    reports = scheduler.run();
+
+    ASSERT_EQUAL(reports[0].completed, true);
+    ASSERT_EQUAL(reports[0].matrix_cached, false);
+    ASSERT_EQUAL(reports[0].hierarchy_cached, false);
+}
+DECLARE_UNITTEST(TestSolveSchedulerHierarchyCache);
+
+void TestSolveSchedulerErrors(void)
+{
+    cusp::csr_matrix<int, float, cusp::host_memory> A;
+    cusp::gallery::poisson5pt(A, 5, 5);
+
+    cusp::array1d<float, cusp::host_memory> b(A.num_rows, 1.0f);
+    cusp::array1d<float, cusp::host_memory> x(A.num_rows + 1, 0.0f);
+
+    std::vector<int> devices(1, 0);
+    cusp::solve_scheduler<int, float> scheduler(devices);
+
+    ASSERT_THROWS(scheduler.submit(A, b, x), cusp::invalid_input_exception);
+
+    cusp::csr_matrix<int, float, cusp::host_memory> R(3, 4, 0);
+    cusp::array1d<float, cusp::host_memory> r(3, 0.0f);
+    ASSERT_THROWS(scheduler.submit(R, r, r), cusp::invalid_input_exception);
+
+    typedef cusp::solve_scheduler<int, float> Scheduler;
+    const std::vector<int> no_devices;
+    ASSERT_THROWS(Scheduler empty(no_devices), cusp::invalid_input_exception);
+
+    // an invalid configuration fails its own task only
+    cusp::array1d<float, cusp::host_memory> x0(A.num_rows, 0.0f), x1(A.num_rows, 0.0f);
+    cusp::solve_config invalid;
+    invalid.solver = cusp::scheduled_solver(42);
+
+    scheduler.submit(A, b, x0, invalid);
+    scheduler.submit(A, b, x1);
+
+    std::vector<cusp::solve_report> reports = scheduler.run();
+
+    ASSERT_EQUAL(reports[0].completed, false);
+    ASSERT_EQUAL(reports[0].error.empty(), false);
+    ASSERT_EQUAL(reports[1].completed, true);
+    ASSERT_EQUAL(reports[1].converged, true);
+}
+DECLARE_UNITTEST(TestSolveSchedulerErrors);
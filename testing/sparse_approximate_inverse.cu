@@ -0,0 +1,126 @@
+#include <unittest/unittest.h>
+
+#include <cusp/precond/sparse_approximate_inverse.h>
+
+#include <cusp/blas.h>
+#include <cusp/coo_matrix.h>
+#include <cusp/csr_matrix.h>
+#include <cusp/gallery/poisson.h>
+#include <cusp/krylov/bicgstab.h>
+#include <cusp/krylov/cg.h>
+#include <cusp/monitor.h>
+#include <cusp/multiply.h>
+#include <cusp/detail/format_utils.h>
+
+#include <cmath>
+
+// ||I - B||_F for a square matrix B
+float identity_distance(const cusp::coo_matrix<int,float,cusp::host_memory>& B)
+{
+    float sum = B.num_rows;
+
+    for (size_t n = 0; n < B.num_entries; n++)
+    {
+        const float b = B.values[n];
+
+        if (B.row_indices[n] == B.column_indices[n])
+            sum += (1 - b) * (1 - b) - 1;
+        else
+            sum += b * b;
+    }
+
+    return std::sqrt(sum);
+}
+
+template <class Space>
+void TestFactorizedSparseApproximateInverse(void)
+{
+    cusp::csr_matrix<int,float,Space> A;
+    cusp::gallery::poisson5pt(A, 20, 20);
+
+    cusp::precond::fsai<float,Space> M(A);
+
+    // G is lower triangular and G A G^T has a unit diagonal
+    cusp::coo_matrix<int,float,cusp::host_memory> G(M.w);
+    cusp::csr_matrix<int,float,cusp::host_memory> A_host(A);
+
+    for (size_t n = 0; n < G.num_entries; n++)
+        ASSERT_EQUAL(G.column_indices[n] <= G.row_indices[n], true);
+
+    cusp::csr_matrix<int,float,cusp::host_memory> G_csr(G), Gt_csr(M.w_t), GA, GAGt;
+    cusp::multiply(G_csr, A_host, GA);
+    cusp::multiply(GA, Gt_csr, GAGt);
+
+    cusp::array1d<float,cusp::host_memory> diagonal;
+    cusp::detail::extract_diagonal(GAGt, diagonal);
+    ASSERT_ALMOST_EQUAL(diagonal, (cusp::array1d<float,cusp::host_memory>(A.num_rows, 1.0f)));
+
+    // and cg needs fewer iterations
+    cusp::array1d<float,Space> b = unittest::random_samples<float>(A.num_rows);
+
+    cusp::array1d<float,Space> x(A.num_rows, 0.0f);
+    cusp::default_monitor<float> monitor(b, 1000, 1e-5);
+    cusp::krylov::cg(A, x, b, monitor, M);
+
+    cusp::array1d<float,Space> x0(A.num_rows, 0.0f);
+    cusp::default_monitor<float> monitor0(b, 1000, 1e-5);
+    cusp::krylov::cg(A, x0, b, monitor0);
+
+    ASSERT_EQUAL(monitor.converged(), true);
+    ASSERT_EQUAL(monitor.iteration_count() < monitor0.iteration_count(), true);
+
+    // copy to another memory space
+    cusp::precond::fsai<float,cusp::host_memory> C(M);
+    ASSERT_EQUAL(C.num_rows, A.num_rows);
+    ASSERT_EQUAL(C.w.num_entries, M.w.num_entries);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestFactorizedSparseApproximateInverse);
+
+template <class Space>
+void TestFactorizedSparseApproximateInverseMissingDiagonal(void)
+{
+    cusp::coo_matrix<int,float,Space> A(2, 2, 2);
+    A.row_indices[0] = 0; A.column_indices[0] = 1; A.values[0] = 1.0f;
+    A.row_indices[1] = 1; A.column_indices[1] = 0; A.values[1] = 1.0f;
+
+    typedef cusp::precond::fsai<float,Space> Preconditioner;
+    ASSERT_THROWS(Preconditioner M(A), cusp::invalid_input_exception);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestFactorizedSparseApproximateInverseMissingDiagonal);
+
+template <class Space>
+void TestSparseApproximateInverse(void)
+{
+    cusp::csr_matrix<int,float,Space> A;
+    cusp::gallery::poisson5pt(A, 20, 20);
+
+    cusp::precond::spai<float,Space> M(A);
+
+    ASSERT_EQUAL(M.m.num_entries, A.num_entries);
+
+    // M A is closer to the identity than D^-1 A
+    cusp::csr_matrix<int,float,cusp::host_memory> A_host(A);
+    cusp::csr_matrix<int,float,cusp::host_memory> M_host(M.m);
+    cusp::coo_matrix<int,float,cusp::host_memory> MA, DA(A_host);
+
+    cusp::multiply(M_host, A_host, MA);
+
+    for (size_t n = 0; n < DA.num_entries; n++)
+        DA.values[n] /= 4.0f;
+
+    ASSERT_EQUAL(identity_distance(MA) < identity_distance(DA), true);
+
+    cusp::array1d<float,Space> b = unittest::random_samples<float>(A.num_rows);
+
+    cusp::array1d<float,Space> x(A.num_rows, 0.0f);
+    cusp::default_monitor<float> monitor(b, 1000, 1e-5);
+    cusp::krylov::bicgstab(A, x, b, monitor, M);
+
+    cusp::array1d<float,Space> x0(A.num_rows, 0.0f);
+    cusp::default_monitor<float> monitor0(b, 1000, 1e-5);
+    cusp::krylov::bicgstab(A, x0, b, monitor0);
+
+    ASSERT_EQUAL(monitor.converged(), true);
+    ASSERT_EQUAL(monitor.iteration_count() < monitor0.iteration_count(), true);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestSparseApproximateInverse);
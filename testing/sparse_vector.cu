@@ -0,0 +1,79 @@
+#include <unittest/unittest.h>
+
+#include <cusp/sparse_vector.h>
+
+template <class Space>
+void TestSparseVectorBasicConstructor(void)
+{
+    cusp::sparse_vector<int, float, Space> x(10, 3);
+
+    ASSERT_EQUAL(x.size(),          10);
+    ASSERT_EQUAL(x.length,          10);
+    ASSERT_EQUAL(x.num_entries,      3);
+    ASSERT_EQUAL(x.indices.size(),   3);
+    ASSERT_EQUAL(x.values.size(),    3);
+
+    x.resize(7, 2);
+
+    ASSERT_EQUAL(x.size(),           7);
+    ASSERT_EQUAL(x.num_entries,      2);
+    ASSERT_EQUAL(x.indices.size(),   2);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestSparseVectorBasicConstructor);
+
+template <class Space>
+void TestSparseVectorSwap(void)
+{
+    cusp::sparse_vector<int, float, Space> x(10, 3);
+    cusp::sparse_vector<int, float, Space> y(4, 1);
+
+    x.swap(y);
+
+    ASSERT_EQUAL(x.size(),          4);
+    ASSERT_EQUAL(x.num_entries,     1);
+    ASSERT_EQUAL(y.size(),         10);
+    ASSERT_EQUAL(y.num_entries,     3);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestSparseVectorSwap);
+
+template <class Space>
+void TestSparseVectorDenseConversion(void)
+{
+    cusp::array1d<float, cusp::host_memory> dense(8, 0.0f);
+    dense[1] = 5.0f;
+    dense[4] = -2.0f;
+    dense[7] = 1.0f;
+
+    // the nonzeros are kept in order
+    cusp::sparse_vector<int, float, Space> x(dense);
+
+    ASSERT_EQUAL(x.size(),       8);
+    ASSERT_EQUAL(x.num_entries,  3);
+    ASSERT_EQUAL(x.indices[0],   1);
+    ASSERT_EQUAL(x.indices[1],   4);
+    ASSERT_EQUAL(x.indices[2],   7);
+    ASSERT_EQUAL(x.values[0],  5.0f);
+    ASSERT_EQUAL(x.values[1], -2.0f);
+    ASSERT_EQUAL(x.values[2],  1.0f);
+
+    // and written back with the zeros
+    cusp::array1d<float, cusp::host_memory> y(3, 9.0f);
+    x.to_dense(y);
+    ASSERT_EQUAL(y, dense);
+
+    cusp::array1d<float, Space> z;
+    x.to_dense(z);
+    ASSERT_EQUAL(z, dense);
+
+    // across memory spaces
+    cusp::sparse_vector<int, float, cusp::host_memory> h(x);
+    ASSERT_EQUAL(h.size(),       8);
+    ASSERT_EQUAL_QUIET(h.indices, x.indices);
+    ASSERT_EQUAL_QUIET(h.values,  x.values);
+
+    // all zeros
+    cusp::sparse_vector<int, float, Space> e(cusp::array1d<float, Space>(5, 0.0f));
+    ASSERT_EQUAL(e.size(),        5);
+    ASSERT_EQUAL(e.num_entries,   0);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestSparseVectorDenseConversion);
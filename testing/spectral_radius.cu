@@ -47,6 +47,15 @@ void TestEstimateSpectralRadius(void)
         ASSERT_EQUAL((std::abs(cusp::detail::disks_spectral_radius(A) - rho) / rho) < 0.11f, true);
     }
 
+    // D^-1 A of the 4x4 Poisson problem
+    {
+        cusp::csr_matrix<int, float, MemorySpace> A; cusp::gallery::poisson5pt(A, 4, 4); 
+        float rho = 7.2360679774997871 / 4.0;
+        ASSERT_EQUAL((std::abs(cusp::detail::estimate_spectral_radius_Dinv_A(A) - rho) / rho) < 0.1f, true);
+        ASSERT_EQUAL((std::abs(cusp::detail::disks_spectral_radius_Dinv_A(A) - rho) / rho) < 0.11f, true);
+        ASSERT_EQUAL(cusp::detail::disks_spectral_radius_Dinv_A(A) >= rho, true);
+    }
+
     // TODO test larger sizes and non-symmetric matrices
 }
 DECLARE_HOST_DEVICE_UNITTEST(TestEstimateSpectralRadius);
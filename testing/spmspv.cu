@@ -0,0 +1,151 @@
+#include <unittest/unittest.h>
+
+#include <cusp/spmspv.h>
+#include <cusp/sparse_vector.h>
+#include <cusp/gallery/poisson.h>
+#include <cusp/gallery/random.h>
+
+#include <thrust/functional.h>
+
+#include <algorithm>
+
+// dense reference of the rows which receive a contribution
+template <typename Matrix>
+void spmspv_reference(const Matrix& A, const cusp::array1d<float,cusp::host_memory>& x,
+                      const cusp::array1d<int,cusp::host_memory>& mask,
+                      cusp::array1d<float,cusp::host_memory>& y,
+                      cusp::array1d<int,cusp::host_memory>& reached)
+{
+    y.resize(A.num_rows);
+    reached.resize(A.num_rows);
+
+    for(size_t i = 0; i < A.num_rows; i++)
+    {
+        y[i] = 0; reached[i] = 0;
+
+        if (!mask[i])
+            continue;
+
+        for(int jj = A.row_offsets[i]; jj < A.row_offsets[i + 1]; jj++)
+        {
+            const int j = A.column_indices[jj];
+
+            if (x[j] != 0)
+            {
+                y[i] = reached[i] ? std::min(y[i], A.values[jj] + x[j]) : A.values[jj] + x[j];
+                reached[i] = 1;
+            }
+        }
+    }
+}
+
+template <typename Space>
+void CompareSpMSpV(const cusp::csr_matrix<int,float,cusp::host_memory>& A, bool symmetric,
+                   const cusp::array1d<float,cusp::host_memory>& x_dense,
+                   const cusp::array1d<int,cusp::host_memory>& mask)
+{
+    cusp::array1d<float,cusp::host_memory> reference;
+    cusp::array1d<int,cusp::host_memory>   reached;
+    spmspv_reference(A, x_dense, mask, reference, reached);
+
+    cusp::spmspv_matrix<int,float,Space> M(A, symmetric);
+    cusp::sparse_vector<int,float,Space> x(x_dense);
+    cusp::array1d<int,Space>             d_mask(mask);
+
+    for(int d = 0; d < 3; d++)
+    {
+        M.direction = d == 0 ? cusp::spmspv_auto : (d == 1 ? cusp::spmspv_push : cusp::spmspv_pull);
+
+        cusp::sparse_vector<int,float,Space> y;
+        cusp::generalized_spmspv(M, x, d_mask, y, thrust::plus<float>(), thrust::minimum<float>());
+
+        ASSERT_EQUAL(y.size(), A.num_rows);
+
+        cusp::sparse_vector<int,float,cusp::host_memory> h_y(y);
+
+        size_t n = 0;
+        for(size_t i = 0; i < A.num_rows; i++)
+        {
+            if (!reached[i])
+                continue;
+
+            ASSERT_EQUAL(n < h_y.num_entries, true);
+            ASSERT_EQUAL(h_y.indices[n], int(i));
+            ASSERT_EQUAL(h_y.values[n],  reference[i]);
+            n++;
+        }
+        ASSERT_EQUAL(n, h_y.num_entries);
+    }
+}
+
+template <class Space>
+void TestSpMSpV(void)
+{
+    cusp::csr_matrix<int,float,cusp::host_memory> A;
+    cusp::gallery::random(120, 90, 800, A);
+    for(size_t n = 0; n < A.num_entries; n++)
+        A.values[n] = (n % 9) + 1;
+
+    cusp::array1d<float,cusp::host_memory> x(90, 0.0f);
+    x[3] = 2; x[17] = 1; x[40] = 5; x[89] = 3;
+
+    cusp::array1d<int,cusp::host_memory> all(120, 1);
+    CompareSpMSpV<Space>(A, false, x, all);
+
+    cusp::array1d<int,cusp::host_memory> mask(120, 0);
+    for(size_t i = 0; i < mask.size(); i += 3)
+        mask[i] = 1;
+    CompareSpMSpV<Space>(A, false, x, mask);
+
+    // dense input
+    cusp::array1d<float,cusp::host_memory> ones(90, 1.0f);
+    CompareSpMSpV<Space>(A, false, ones, mask);
+
+    // empty input
+    cusp::array1d<float,cusp::host_memory> zeros(90, 0.0f);
+    CompareSpMSpV<Space>(A, false, zeros, all);
+
+    // symmetric matrices are traversed by rows in both directions
+    cusp::csr_matrix<int,float,cusp::host_memory> B;
+    cusp::gallery::poisson5pt(B, 11, 9);
+    cusp::array1d<float,cusp::host_memory> y(99, 0.0f);
+    y[0] = 1; y[50] = 2;
+    CompareSpMSpV<Space>(B, true, y, all);
+    CompareSpMSpV<Space>(B, true, y, mask);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestSpMSpV);
+
+template <class Space>
+void TestSpMSpVDirection(void)
+{
+    cusp::csr_matrix<int,float,cusp::host_memory> A;
+    cusp::gallery::poisson5pt(A, 20, 20);
+
+    cusp::spmspv_matrix<int,float,Space> M(A, true);
+
+    // a single vertex is pushed
+    cusp::sparse_vector<int,float,Space> x(400, 1);
+    x.indices[0] = 210; x.values[0] = 1;
+
+    cusp::sparse_vector<int,float,Space> y;
+    ASSERT_EQUAL(cusp::spmspv(M, x, y), cusp::spmspv_push);
+    ASSERT_EQUAL(y.num_entries, 5);
+
+    // a full frontier is pulled
+    cusp::sparse_vector<int,float,Space> z(cusp::array1d<float,Space>(400, 1.0f));
+    ASSERT_EQUAL(cusp::spmspv(M, z, y), cusp::spmspv_pull);
+    ASSERT_EQUAL(y.num_entries, 400);
+
+    // so is a frontier whose rows are masked out
+    cusp::array1d<int,Space> mask(400, 0);
+    mask[210] = 1;
+    ASSERT_EQUAL(cusp::generalized_spmspv(M, x, mask, y, thrust::multiplies<float>(), thrust::plus<float>()), cusp::spmspv_pull);
+    ASSERT_EQUAL(y.num_entries, 1);
+    ASSERT_EQUAL(y.indices[0], 210);
+    ASSERT_EQUAL(y.values[0],  4.0f);
+
+    // sizes are checked
+    cusp::sparse_vector<int,float,Space> w(401, 0);
+    ASSERT_THROWS(cusp::spmspv(M, w, y), cusp::invalid_input_exception);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestSpMSpVDirection);
@@ -0,0 +1,230 @@
+// The vectorized host kernels are compiled out of CUDA translation units,
+// so they are tested from this host compiled file.
+
+#include <unittest/unittest.h>
+
+#include <cusp/csr_matrix.h>
+#include <cusp/ell_matrix.h>
+#include <cusp/sell_matrix.h>
+
+#include <cusp/detail/functional.h>
+#include <cusp/detail/host/spmv.h>
+
+#include <thrust/functional.h>
+
+#include <algorithm>
+
+#ifdef __CUSP_USE_HOST_SIMD__
+
+// ragged rows with empty rows and lengths on both sides of the vector widths
+template <typename ValueType>
+void initialize_simd_test_matrix(cusp::csr_matrix<int, ValueType, cusp::host_memory>& A)
+{
+    const int num_rows = 83;
+    const int num_cols = 61;
+    const int lengths[] = {0, 1, 3, 7, 8, 9, 15, 16, 17, 0, 31, 33, 40};
+    const int num_lengths = sizeof(lengths) / sizeof(int);
+
+    int num_entries = 0;
+    for (int i = 0; i < num_rows; i++)
+        num_entries += lengths[i % num_lengths];
+
+    A.resize(num_rows, num_cols, num_entries);
+
+    int n = 0;
+    for (int i = 0; i < num_rows; i++)
+    {
+        A.row_offsets[i] = n;
+
+        for (int k = 0; k < lengths[i % num_lengths]; k++, n++)
+        {
+            A.column_indices[n] = (i + 5 * k) % num_cols;
+            A.values[n]         = ValueType((3 * i + k) % 11 - 5) / ValueType(4);
+        }
+    }
+    A.row_offsets[num_rows] = n;
+}
+
+template <typename ValueType>
+void initialize_simd_test_vector(cusp::array1d<ValueType, cusp::host_memory>& x)
+{
+    for (size_t j = 0; j < x.size(); j++)
+        x[j] = ValueType(int(j % 7) - 3) / ValueType(2);
+}
+
+template <typename ValueType>
+void TestHostSimdSpmvCsr(void)
+{
+    namespace simd = cusp::detail::host::simd;
+
+    cusp::csr_matrix<int, ValueType, cusp::host_memory> A;
+    initialize_simd_test_matrix(A);
+
+    cusp::array1d<ValueType, cusp::host_memory> x(A.num_cols);
+    initialize_simd_test_vector(x);
+
+    cusp::array1d<ValueType, cusp::host_memory> reference(A.num_rows, -1);
+    cusp::detail::host::spmv_csr(A, x, reference,
+                                 cusp::detail::zero_function<ValueType>(),
+                                 thrust::multiplies<ValueType>(),
+                                 thrust::plus<ValueType>());
+
+    const int * Ap = &A.row_offsets[0];
+    const int * Aj = &A.column_indices[0];
+    const ValueType * Ax = &A.values[0];
+
+    // the widest instruction set of this processor
+    {
+        cusp::array1d<ValueType, cusp::host_memory> y(A.num_rows, -1);
+        ASSERT_EQUAL(simd::spmv_csr(A, x, y), simd::level() != simd::level_none);
+        if (simd::level() != simd::level_none)
+            ASSERT_ALMOST_EQUAL(y, reference);
+    }
+
+    if (simd::level() >= simd::level_avx2)
+    {
+        cusp::array1d<ValueType, cusp::host_memory> y(A.num_rows, -1);
+        simd::csr_rows_avx2<typename simd::avx2_ops<ValueType>::type>(Ap, Aj, Ax, &x[0], &y[0], 0, A.num_rows);
+        ASSERT_ALMOST_EQUAL(y, reference);
+    }
+
+    if (simd::level() >= simd::level_avx512)
+    {
+        cusp::array1d<ValueType, cusp::host_memory> y(A.num_rows, -1);
+        simd::csr_rows_avx512<typename simd::avx512_ops<ValueType>::type>(Ap, Aj, Ax, &x[0], &y[0], 0, A.num_rows);
+        ASSERT_ALMOST_EQUAL(y, reference);
+    }
+}
+
+template <typename ValueType>
+void TestHostSimdSpmvEll(void)
+{
+    namespace simd = cusp::detail::host::simd;
+
+    cusp::csr_matrix<int, ValueType, cusp::host_memory> B;
+    initialize_simd_test_matrix(B);
+
+    size_t num_entries_per_row = 0;
+    for (size_t i = 0; i < B.num_rows; i++)
+        num_entries_per_row = std::max<size_t>(num_entries_per_row, B.row_offsets[i + 1] - B.row_offsets[i]);
+
+    // the pitch exceeds the number of rows, which is not a multiple of the vector widths
+    cusp::ell_matrix<int, ValueType, cusp::host_memory> A(B.num_rows, B.num_cols, B.num_entries, num_entries_per_row);
+    for (size_t i = 0; i < B.num_rows; i++)
+    {
+        for (size_t n = 0; n < num_entries_per_row; n++)
+        {
+            const int jj = B.row_offsets[i] + n;
+
+            if (jj < B.row_offsets[i + 1])
+            {
+                A.column_indices(i, n) = B.column_indices[jj];
+                A.values(i, n)         = B.values[jj];
+            }
+            else
+            {
+                A.column_indices(i, n) = -1;
+                A.values(i, n)         = 0;
+            }
+        }
+    }
+
+    cusp::array1d<ValueType, cusp::host_memory> x(A.num_cols);
+    initialize_simd_test_vector(x);
+
+    cusp::array1d<ValueType, cusp::host_memory> reference(A.num_rows, -1);
+    cusp::detail::host::spmv_ell(A, x, reference,
+                                 cusp::detail::zero_function<ValueType>(),
+                                 thrust::multiplies<ValueType>(),
+                                 thrust::plus<ValueType>());
+
+    const size_t pitch = A.column_indices.pitch;
+    const int * Aj = &A.column_indices.values[0];
+    const ValueType * Ax = &A.values.values[0];
+
+    {
+        cusp::array1d<ValueType, cusp::host_memory> y(A.num_rows, -1);
+        ASSERT_EQUAL(simd::spmv_ell(A, x, y), simd::level() != simd::level_none);
+        if (simd::level() != simd::level_none)
+            ASSERT_ALMOST_EQUAL(y, reference);
+    }
+
+    if (simd::level() >= simd::level_avx2)
+    {
+        cusp::array1d<ValueType, cusp::host_memory> y(A.num_rows, -1);
+        simd::ell_rows_avx2<typename simd::avx2_ops<ValueType>::type>(Aj, Ax, pitch, num_entries_per_row, &x[0], &y[0], 0, A.num_rows);
+        ASSERT_ALMOST_EQUAL(y, reference);
+    }
+
+    if (simd::level() >= simd::level_avx512)
+    {
+        cusp::array1d<ValueType, cusp::host_memory> y(A.num_rows, -1);
+        simd::ell_rows_avx512<typename simd::avx512_ops<ValueType>::type>(Aj, Ax, pitch, num_entries_per_row, &x[0], &y[0], 0, A.num_rows);
+        ASSERT_ALMOST_EQUAL(y, reference);
+    }
+}
+
+template <typename ValueType>
+void TestHostSimdSpmvSell(void)
+{
+    namespace simd = cusp::detail::host::simd;
+
+    cusp::csr_matrix<int, ValueType, cusp::host_memory> B;
+    initialize_simd_test_matrix(B);
+
+    cusp::array1d<ValueType, cusp::host_memory> x(B.num_cols);
+    initialize_simd_test_vector(x);
+
+    // slices of one and two AVX-512 float vectors, the last slice partially filled
+    for (size_t slice_height = 16; slice_height <= 32; slice_height += 16)
+    {
+        cusp::sell_matrix<int, ValueType, cusp::host_memory> A(B, slice_height, 32);
+
+        const int * So = &A.slice_offsets[0];
+        const int * Sp = &A.row_permutation[0];
+        const int * Aj = &A.column_indices[0];
+        const ValueType * Ax = &A.values[0];
+
+        cusp::array1d<ValueType, cusp::host_memory> reference(A.num_rows, -1);
+        cusp::detail::host::spmv_sell(A, x, reference,
+                                      cusp::detail::zero_function<ValueType>(),
+                                      thrust::multiplies<ValueType>(),
+                                      thrust::plus<ValueType>());
+
+        {
+            cusp::array1d<ValueType, cusp::host_memory> y(A.num_rows, -1);
+            ASSERT_EQUAL(simd::spmv_sell(A, x, y), simd::level() != simd::level_none);
+            if (simd::level() != simd::level_none)
+                ASSERT_ALMOST_EQUAL(y, reference);
+        }
+
+        if (simd::level() >= simd::level_avx2)
+        {
+            cusp::array1d<ValueType, cusp::host_memory> y(A.num_rows, -1);
+            simd::sell_rows_avx2<typename simd::avx2_ops<ValueType>::type>(So, Sp, Aj, Ax, A.slice_height, A.num_rows, &x[0], &y[0], 0, A.num_slices());
+            ASSERT_ALMOST_EQUAL(y, reference);
+        }
+
+        if (simd::level() >= simd::level_avx512)
+        {
+            cusp::array1d<ValueType, cusp::host_memory> y(A.num_rows, -1);
+            simd::sell_rows_avx512<typename simd::avx512_ops<ValueType>::type>(So, Sp, Aj, Ax, A.slice_height, A.num_rows, &x[0], &y[0], 0, A.num_slices());
+            ASSERT_ALMOST_EQUAL(y, reference);
+        }
+    }
+}
+
+#endif // __CUSP_USE_HOST_SIMD__
+
+void TestHostSimdSpmv(void)
+{
+#ifdef __CUSP_USE_HOST_SIMD__
+    TestHostSimdSpmvCsr<float>();
+    TestHostSimdSpmvCsr<double>();
+    TestHostSimdSpmvEll<float>();
+    TestHostSimdSpmvEll<double>();
+    TestHostSimdSpmvSell<float>();
+    TestHostSimdSpmvSell<double>();
+#endif
+}
+DECLARE_UNITTEST(TestHostSimdSpmv);
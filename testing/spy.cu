@@ -0,0 +1,93 @@
+#include <unittest/unittest.h>
+
+#include <cusp/io/spy.h>
+
+#include <cusp/coo_matrix.h>
+#include <cusp/csr_matrix.h>
+#include <cusp/gallery/poisson.h>
+
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include <stdio.h>
+
+const char spy_png_file_name[] = "test_spy_40218835.png";
+const char spy_svg_file_name[] = "test_spy_40218835.svg";
+
+std::vector<unsigned char> read_spy_file(const char * filename)
+{
+  std::ifstream file(filename, std::ios::in | std::ios::binary);
+
+  return std::vector<unsigned char>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+unsigned int read_be32(const std::vector<unsigned char>& bytes, const size_t offset)
+{
+  return (unsigned int)(bytes[offset]) << 24 | (unsigned int)(bytes[offset + 1]) << 16 |
+         (unsigned int)(bytes[offset + 2]) << 8 | (unsigned int)(bytes[offset + 3]);
+}
+
+template <typename SparseMatrix>
+void TestWriteSpyPng(void)
+{
+  cusp::csr_matrix<int, float, cusp::host_memory> A;
+  cusp::gallery::poisson5pt(A, 30, 40);
+
+  SparseMatrix B(A);
+
+  // 1200 rows are binned by 3 into 400 pixels
+  cusp::io::write_spy_png(B, spy_png_file_name, 400);
+
+  std::vector<unsigned char> bytes = read_spy_file(spy_png_file_name);
+
+  ASSERT_EQUAL(bytes.size() > 33, true);
+
+  const unsigned char signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+  ASSERT_EQUAL(std::vector<unsigned char>(bytes.begin(), bytes.begin() + 8),
+               std::vector<unsigned char>(signature, signature + 8));
+
+  ASSERT_EQUAL(std::string(bytes.begin() + 12, bytes.begin() + 16), std::string("IHDR"));
+  ASSERT_EQUAL(read_be32(bytes, 16), 400u);
+  ASSERT_EQUAL(read_be32(bytes, 20), 400u);
+
+  ASSERT_EQUAL(std::string(bytes.end() - 8, bytes.end() - 4), std::string("IEND"));
+
+  remove(spy_png_file_name);
+}
+DECLARE_SPARSE_MATRIX_UNITTEST(TestWriteSpyPng);
+
+template <typename SparseMatrix>
+void TestWriteSpySvg(void)
+{
+  cusp::csr_matrix<int, float, cusp::host_memory> A;
+  cusp::gallery::poisson5pt(A, 4, 4);
+
+  SparseMatrix B(A);
+
+  // no binning: a rectangle per run of the 16x16 pattern
+  cusp::io::write_spy_svg(B, spy_svg_file_name);
+
+  std::vector<unsigned char> bytes = read_spy_file(spy_svg_file_name);
+  std::string svg(bytes.begin(), bytes.end());
+
+  ASSERT_EQUAL(svg.find("<svg") != std::string::npos, true);
+  ASSERT_EQUAL(svg.find("viewBox=\"0 0 16 16\"") != std::string::npos, true);
+  ASSERT_EQUAL(svg.find("</svg>") != std::string::npos, true);
+
+  // the first row holds entries 0 and 1, which are one run
+  ASSERT_EQUAL(svg.find("<rect x=\"0\" y=\"0\" width=\"2\" height=\"1\"") != std::string::npos, true);
+
+  remove(spy_svg_file_name);
+}
+DECLARE_SPARSE_MATRIX_UNITTEST(TestWriteSpySvg);
+
+void TestWriteSpyInvalidFile(void)
+{
+  cusp::coo_matrix<int, float, cusp::host_memory> A(3, 3, 0);
+
+  ASSERT_THROWS(cusp::io::write_spy_png(A, "does/not/exist/spy.png"), cusp::io_exception);
+  ASSERT_THROWS(cusp::io::write_spy_svg(A, "does/not/exist/spy.svg"), cusp::io_exception);
+}
+DECLARE_UNITTEST(TestWriteSpyInvalidFile);
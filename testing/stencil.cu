@@ -1,6 +1,10 @@
 #include <unittest/unittest.h>
 
 #include <cusp/gallery/stencil.h>
+#include <cusp/array2d.h>
+#include <cusp/coo_matrix.h>
+#include <cusp/csr_matrix.h>
+#include <cusp/dia_matrix.h>
 
 void TestGenerateMatrixFromStencil1d(void)
 {
@@ -75,3 +79,63 @@ void TestGenerateMatrixFromStencil2d(void)
 }
 DECLARE_UNITTEST(TestGenerateMatrixFromStencil2d);
 
+
+template <typename MatrixType, typename StencilPoint, typename GridDimension>
+void CompareGeneratedWithDia(const cusp::array1d<StencilPoint, cusp::host_memory>& stencil, const GridDimension& grid)
+{
+    cusp::dia_matrix<int, float, cusp::host_memory> dia;
+    cusp::gallery::generate_matrix_from_stencil(dia, stencil, grid);
+
+    MatrixType matrix;
+    cusp::gallery::generate_matrix_from_stencil(matrix, stencil, grid);
+
+    ASSERT_EQUAL(matrix.num_rows,    dia.num_rows);
+    ASSERT_EQUAL(matrix.num_entries, dia.num_entries);
+
+    cusp::array2d<float, cusp::host_memory> R(matrix);
+    cusp::array2d<float, cusp::host_memory> E(dia);
+
+    ASSERT_EQUAL_QUIET(R, E);
+}
+
+template <typename MemorySpace>
+void TestGenerateMatrixFromStencilCsrCoo(void)
+{
+    typedef cusp::csr_matrix<int, float, MemorySpace> CsrMatrix;
+    typedef cusp::coo_matrix<int, float, MemorySpace> CooMatrix;
+
+    {
+        typedef thrust::tuple<int,int>            StencilIndex;
+        typedef thrust::tuple<StencilIndex,float> StencilPoint;
+
+        // unsorted points, a zero coefficient and a repeated point
+        cusp::array1d<StencilPoint, cusp::host_memory> stencil;
+        stencil.push_back(StencilPoint(StencilIndex( 0,  2), 5));
+        stencil.push_back(StencilPoint(StencilIndex( 1,  0), 4));
+        stencil.push_back(StencilPoint(StencilIndex(-1, -1), 1));
+        stencil.push_back(StencilPoint(StencilIndex( 0,  0), 3));
+        stencil.push_back(StencilPoint(StencilIndex(-1,  0), 2));
+        stencil.push_back(StencilPoint(StencilIndex( 1,  1), 0));
+        stencil.push_back(StencilPoint(StencilIndex( 0,  2), 1));
+
+        CompareGeneratedWithDia<CsrMatrix>(stencil, StencilIndex(2, 3));
+        CompareGeneratedWithDia<CooMatrix>(stencil, StencilIndex(2, 3));
+        CompareGeneratedWithDia<CsrMatrix>(stencil, StencilIndex(13, 7));
+        CompareGeneratedWithDia<CooMatrix>(stencil, StencilIndex(13, 7));
+    }
+
+    {
+        typedef thrust::tuple<int,int,int>        StencilIndex;
+        typedef thrust::tuple<StencilIndex,float> StencilPoint;
+
+        cusp::array1d<StencilPoint, cusp::host_memory> stencil;
+        for(int k = -1; k <= 1; k++)
+            for(int j = -1; j <= 1; j++)
+                for(int i = -1; i <= 1; i++)
+                    stencil.push_back(StencilPoint(StencilIndex(i, j, k), 9 * k + 3 * j + i + 14));
+
+        CompareGeneratedWithDia<CsrMatrix>(stencil, StencilIndex(4, 5, 6));
+        CompareGeneratedWithDia<CooMatrix>(stencil, StencilIndex(4, 5, 6));
+    }
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestGenerateMatrixFromStencilCsrCoo);
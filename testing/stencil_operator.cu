@@ -0,0 +1,202 @@
+#include <unittest/unittest.h>
+
+#include <cusp/stencil_operator.h>
+#include <cusp/csr_matrix.h>
+#include <cusp/monitor.h>
+#include <cusp/multiply.h>
+#include <cusp/gallery/stencil.h>
+#include <cusp/krylov/cg.h>
+#include <cusp/precond/aggregation/smoothed_aggregation.h>
+
+template <typename MemorySpace, typename StencilPoint, typename GridDimension>
+void CompareStencilOperator(const cusp::array1d<StencilPoint,cusp::host_memory>& stencil, const GridDimension& grid)
+{
+    cusp::csr_matrix<int,float,cusp::host_memory> A;
+    cusp::gallery::generate_matrix_from_stencil(A, stencil, grid);
+
+    cusp::stencil_operator<float,MemorySpace> S(stencil, grid);
+
+    ASSERT_EQUAL(S.num_rows,    A.num_rows);
+    ASSERT_EQUAL(S.num_cols,    A.num_cols);
+    ASSERT_EQUAL(S.num_entries, A.num_entries);
+
+    // integer values keep every sum exact
+    cusp::array1d<float,cusp::host_memory> x(A.num_cols);
+    for(size_t i = 0; i < x.size(); i++)
+        x[i] = int(i % 7) - 3;
+
+    cusp::array1d<float,cusp::host_memory> y(A.num_rows);
+    cusp::multiply(A, x, y);
+
+    cusp::array1d<float,MemorySpace> x_S(x);
+    cusp::array1d<float,MemorySpace> y_S(A.num_rows, 10.0f);
+    cusp::multiply(S, x_S, y_S);
+
+    ASSERT_EQUAL(y_S, y);
+}
+
+template <class MemorySpace>
+void TestStencilOperator1d(void)
+{
+    typedef thrust::tuple<int>                StencilIndex;
+    typedef thrust::tuple<StencilIndex,float> StencilPoint;
+
+    cusp::array1d<StencilPoint, cusp::host_memory> stencil;
+    stencil.push_back(StencilPoint(StencilIndex(-1), -1));
+    stencil.push_back(StencilPoint(StencilIndex( 0),  2));
+    stencil.push_back(StencilPoint(StencilIndex( 2),  3));
+
+    CompareStencilOperator<MemorySpace>(stencil, StencilIndex(1000));
+    CompareStencilOperator<MemorySpace>(stencil, StencilIndex(1));
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestStencilOperator1d);
+
+template <class MemorySpace>
+void TestStencilOperator2d(void)
+{
+    typedef thrust::tuple<int,int>            StencilIndex;
+    typedef thrust::tuple<StencilIndex,float> StencilPoint;
+
+    // 9-point stencil with distinct coefficients
+    cusp::array1d<StencilPoint, cusp::host_memory> stencil;
+    for(int j = -1; j <= 1; j++)
+        for(int i = -1; i <= 1; i++)
+            stencil.push_back(StencilPoint(StencilIndex(i, j), 3 * j + i));
+
+    // grids smaller than, equal to and not divisible by the tiles
+    CompareStencilOperator<MemorySpace>(stencil, StencilIndex(5, 3));
+    CompareStencilOperator<MemorySpace>(stencil, StencilIndex(32, 8));
+    CompareStencilOperator<MemorySpace>(stencil, StencilIndex(77, 41));
+
+    // points further away than the halo of the tiles
+    stencil.push_back(StencilPoint(StencilIndex(0, 2), 5));
+    CompareStencilOperator<MemorySpace>(stencil, StencilIndex(77, 41));
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestStencilOperator2d);
+
+template <class MemorySpace>
+void TestStencilOperator3d(void)
+{
+    typedef thrust::tuple<int,int,int>        StencilIndex;
+    typedef thrust::tuple<StencilIndex,float> StencilPoint;
+
+    // 27-point stencil with distinct coefficients
+    cusp::array1d<StencilPoint, cusp::host_memory> stencil;
+    for(int k = -1; k <= 1; k++)
+        for(int j = -1; j <= 1; j++)
+            for(int i = -1; i <= 1; i++)
+                stencil.push_back(StencilPoint(StencilIndex(i, j, k), 9 * k + 3 * j + i));
+
+    CompareStencilOperator<MemorySpace>(stencil, StencilIndex(5, 3, 2));
+    CompareStencilOperator<MemorySpace>(stencil, StencilIndex(33, 17, 40));
+    CompareStencilOperator<MemorySpace>(stencil, StencilIndex(8, 8, 1));
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestStencilOperator3d);
+
+void TestStencilOperatorInvalidInput(void)
+{
+    typedef thrust::tuple<int,int>            StencilIndex;
+    typedef thrust::tuple<StencilIndex,float> StencilPoint;
+
+    cusp::array1d<StencilPoint, cusp::host_memory> stencil;
+    for(int i = 0; i < 28; i++)
+        stencil.push_back(StencilPoint(StencilIndex(i, 0), 1));
+
+    ASSERT_THROWS((cusp::stencil_operator<float,cusp::host_memory>(stencil, StencilIndex(40, 40))),
+                  cusp::invalid_input_exception);
+
+    stencil.resize(5);
+    cusp::stencil_operator<float,cusp::host_memory> S(stencil, StencilIndex(40, 40));
+
+    cusp::array1d<float,cusp::host_memory> x(10);
+    cusp::array1d<float,cusp::host_memory> y(S.num_rows);
+    ASSERT_THROWS(S(x, y), cusp::invalid_input_exception);
+}
+DECLARE_UNITTEST(TestStencilOperatorInvalidInput);
+
+template <typename StencilPoint>
+void Poisson5ptStencil(cusp::array1d<StencilPoint, cusp::host_memory>& stencil)
+{
+    typedef typename thrust::tuple_element<0,StencilPoint>::type StencilIndex;
+
+    stencil.push_back(StencilPoint(StencilIndex( 0, -1), -1));
+    stencil.push_back(StencilPoint(StencilIndex(-1,  0), -1));
+    stencil.push_back(StencilPoint(StencilIndex( 0,  0),  4));
+    stencil.push_back(StencilPoint(StencilIndex( 1,  0), -1));
+    stencil.push_back(StencilPoint(StencilIndex( 0,  1), -1));
+}
+
+template <class MemorySpace>
+void TestStencilOperatorKrylov(void)
+{
+    typedef thrust::tuple<int,int>            StencilIndex;
+    typedef thrust::tuple<StencilIndex,float> StencilPoint;
+
+    cusp::array1d<StencilPoint, cusp::host_memory> stencil;
+    Poisson5ptStencil(stencil);
+
+    cusp::stencil_operator<float,MemorySpace> S(stencil, StencilIndex(50, 50));
+
+    cusp::csr_matrix<int,float,MemorySpace> A;
+    cusp::gallery::generate_matrix_from_stencil(A, stencil, StencilIndex(50, 50));
+
+    cusp::array1d<float,MemorySpace> b(A.num_rows, 1.0f);
+    cusp::array1d<float,MemorySpace> x(A.num_rows, 0.0f);
+
+    cusp::convergence_monitor<float> monitor(b, 500, 1e-5);
+    cusp::krylov::cg(S, x, b, monitor);
+    ASSERT_EQUAL(monitor.converged(), true);
+
+    // the residual with the explicit matrix
+    cusp::array1d<float,MemorySpace> r(A.num_rows);
+    cusp::multiply(A, x, r);
+    cusp::blas::axpy(b, r, -1.0f);
+    ASSERT_EQUAL(cusp::blas::nrm2(r) < 1e-4 * cusp::blas::nrm2(b), true);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestStencilOperatorKrylov);
+
+template <class MemorySpace>
+void TestStencilOperatorMultilevel(void)
+{
+    typedef thrust::tuple<int,int>            StencilIndex;
+    typedef thrust::tuple<StencilIndex,float> StencilPoint;
+
+    cusp::array1d<StencilPoint, cusp::host_memory> stencil;
+    Poisson5ptStencil(stencil);
+
+    cusp::csr_matrix<int,float,MemorySpace> A;
+    cusp::gallery::generate_matrix_from_stencil(A, stencil, StencilIndex(100, 100));
+
+    cusp::precond::aggregation::smoothed_aggregation<int,float,MemorySpace> M(A);
+    cusp::precond::aggregation::smoothed_aggregation<int,float,MemorySpace> N(A);
+
+    N.set_fine_operator(cusp::stencil_operator<float,MemorySpace>(stencil, StencilIndex(100, 100)));
+
+    // the matrix-free finest level gives the same cycle
+    cusp::array1d<float,MemorySpace> b = unittest::random_samples<float>(A.num_rows);
+    cusp::array1d<float,MemorySpace> x(A.num_rows, 0.0f);
+    cusp::array1d<float,MemorySpace> y(A.num_rows, 0.0f);
+
+    M(b, x);
+    N(b, y);
+
+    ASSERT_ALMOST_EQUAL((cusp::array1d<float,cusp::host_memory>(x)), (cusp::array1d<float,cusp::host_memory>(y)));
+
+    {
+        cusp::array1d<float,MemorySpace> x(A.num_rows, 0.0f);
+        cusp::convergence_monitor<float> monitor(b, 20, 1e-4);
+        N.solve(b, x, monitor);
+        ASSERT_EQUAL(monitor.converged(), true);
+    }
+
+    // copies keep the operator
+    cusp::precond::aggregation::smoothed_aggregation<int,float,MemorySpace> P(N);
+    ASSERT_EQUAL(P.fine_operator.empty(), false);
+
+    N.clear_fine_operator();
+    ASSERT_EQUAL(N.fine_operator.empty(), true);
+
+    ASSERT_THROWS((N.set_fine_operator(cusp::stencil_operator<float,MemorySpace>(stencil, StencilIndex(10, 10)))),
+                  cusp::invalid_input_exception);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestStencilOperatorMultilevel);
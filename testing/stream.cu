@@ -0,0 +1,166 @@
+#include <unittest/unittest.h>
+
+#include <cusp/stream.h>
+#include <cusp/blas.h>
+#include <cusp/csr_matrix.h>
+#include <cusp/multiply.h>
+#include <cusp/gallery/poisson.h>
+#include <cusp/krylov/cg.h>
+
+#if !defined(_WIN32)
+#include <pthread.h>
+#endif
+
+void TestStreamScope(void)
+{
+    cudaStream_t s0, s1;
+    cudaStreamCreate(&s0);
+    cudaStreamCreate(&s1);
+
+    ASSERT_EQUAL(cusp::current_stream() == cusp::detail::device::default_stream(), true);
+
+    {
+        cusp::stream_scope scope0(s0);
+        ASSERT_EQUAL(cusp::current_stream() == s0, true);
+        ASSERT_EQUAL(scope0.get() == s0, true);
+
+        {
+            cusp::stream_scope scope1(s1);
+            ASSERT_EQUAL(cusp::current_stream() == s1, true);
+        }
+
+        ASSERT_EQUAL(cusp::current_stream() == s0, true);
+    }
+
+    ASSERT_EQUAL(cusp::current_stream() == cusp::detail::device::default_stream(), true);
+
+    cudaStreamDestroy(s0);
+    cudaStreamDestroy(s1);
+}
+DECLARE_UNITTEST(TestStreamScope);
+
+void TestStreamMultiplyAndSolve(void)
+{
+    cusp::csr_matrix<int, float, cusp::device_memory> A;
+    cusp::gallery::poisson5pt(A, 10, 10);
+
+    cusp::array1d<float, cusp::device_memory> x(A.num_rows, 1.0f);
+    cusp::array1d<float, cusp::device_memory> y_default(A.num_rows, 0.0f);
+    cusp::array1d<float, cusp::device_memory> y_stream(A.num_rows, 0.0f);
+
+    cusp::multiply(A, x, y_default);
+
+    cudaStream_t s;
+    cudaStreamCreate(&s);
+
+    {
+        cusp::stream_scope scope(s);
+
+        cusp::multiply(A, x, y_stream);
+        cusp::blas::scal(y_stream, 2.0f);
+        scope.synchronize();
+    }
+
+    cusp::blas::scal(y_default, 2.0f);
+    ASSERT_EQUAL(y_stream, y_default);
+
+    // solve on the stream
+    cusp::array1d<float, cusp::device_memory> b(A.num_rows, 1.0f);
+    cusp::array1d<float, cusp::device_memory> z(A.num_rows, 0.0f);
+    cusp::default_monitor<float> monitor(b, 100, 1e-5f);
+
+    {
+        cusp::stream_scope scope(s);
+        cusp::krylov::cg(A, z, b, monitor);
+    }
+
+    ASSERT_EQUAL(monitor.converged(), true);
+
+    cudaStreamDestroy(s);
+}
+DECLARE_UNITTEST(TestStreamMultiplyAndSolve);
+
+
+#if !defined(_WIN32)
+struct concurrent_solve
+{
+    const cusp::csr_matrix<int, float, cusp::device_memory> * A;
+    cusp::array1d<float, cusp::device_memory> x;
+    bool default_stream_before;
+    bool scoped_stream;
+    bool converged;
+    size_t iterations;
+};
+
+void * solve_on_own_stream(void * argument)
+{
+    concurrent_solve& solve = *static_cast<concurrent_solve *>(argument);
+
+    // a new thread starts on the default stream whatever the others use
+    solve.default_stream_before = cusp::current_stream() == cusp::detail::device::default_stream();
+
+    cudaStream_t s;
+    cudaStreamCreate(&s);
+
+    {
+        cusp::stream_scope scope(s);
+        solve.scoped_stream = cusp::current_stream() == s;
+
+        cusp::array1d<float, cusp::device_memory> b(solve.A->num_rows, 1.0f);
+        cusp::default_monitor<float> monitor(b, 100, 1e-5f);
+
+        cusp::krylov::cg(*solve.A, solve.x, b, monitor);
+        scope.synchronize();
+
+        solve.converged  = monitor.converged();
+        solve.iterations = monitor.iteration_count();
+    }
+
+    cudaStreamDestroy(s);
+
+    return NULL;
+}
+
+void TestStreamScopePerThread(void)
+{
+    cusp::csr_matrix<int, float, cusp::device_memory> A;
+    cusp::gallery::poisson5pt(A, 20, 20);
+
+    const size_t num_threads = 4;
+
+    concurrent_solve solves[num_threads];
+    pthread_t threads[num_threads];
+
+    cudaStream_t s;
+    cudaStreamCreate(&s);
+
+    {
+        // the scope of this thread is not seen by the others
+        cusp::stream_scope scope(s);
+
+        for (size_t t = 0; t < num_threads; t++)
+        {
+            solves[t].A = &A;
+            solves[t].x.resize(A.num_rows, 0.0f);
+            pthread_create(&threads[t], NULL, solve_on_own_stream, &solves[t]);
+        }
+
+        for (size_t t = 0; t < num_threads; t++)
+            pthread_join(threads[t], NULL);
+
+        ASSERT_EQUAL(cusp::current_stream() == s, true);
+    }
+
+    cudaStreamDestroy(s);
+
+    for (size_t t = 0; t < num_threads; t++)
+    {
+        ASSERT_EQUAL(solves[t].default_stream_before, true);
+        ASSERT_EQUAL(solves[t].scoped_stream, true);
+        ASSERT_EQUAL(solves[t].converged, true);
+        ASSERT_EQUAL(solves[t].iterations, solves[0].iterations);
+        ASSERT_EQUAL(solves[t].x, solves[0].x);
+    }
+}
+DECLARE_UNITTEST(TestStreamScopePerThread);
+#endif
@@ -0,0 +1,100 @@
+#include <unittest/unittest.h>
+
+#include <cusp/streamed_operator.h>
+#include <cusp/array1d.h>
+#include <cusp/csr_matrix.h>
+#include <cusp/multiply.h>
+#include <cusp/gallery/poisson.h>
+#include <cusp/gallery/random.h>
+#include <cusp/krylov/cg.h>
+
+template <typename MatrixType>
+void CheckStreamedOperator(const MatrixType& A_h, size_t block_bytes)
+{
+    typedef typename MatrixType::value_type ValueType;
+
+    cusp::streamed_operator<int, ValueType> A(A_h, block_bytes);
+
+    ASSERT_EQUAL(A.num_rows,    A_h.num_rows);
+    ASSERT_EQUAL(A.num_cols,    A_h.num_cols);
+    ASSERT_EQUAL(A.num_entries, A_h.num_entries);
+
+    cusp::array1d<ValueType, cusp::host_memory> x_h(A_h.num_cols);
+    for (size_t i = 0; i < x_h.size(); i++)
+        x_h[i] = ValueType(i % 5) - 2;
+
+    cusp::array1d<ValueType, cusp::host_memory> y_h(A_h.num_rows);
+    cusp::multiply(A_h, x_h, y_h);
+
+    cusp::array1d<ValueType, cusp::device_memory> x(x_h);
+    cusp::array1d<ValueType, cusp::device_memory> y(A_h.num_rows, ValueType(-1));
+
+    // the second product reuses the buffers (and the resident blocks)
+    for (int n = 0; n < 2; n++)
+    {
+        cusp::multiply(A, x, y);
+        ASSERT_ALMOST_EQUAL((cusp::array1d<ValueType, cusp::host_memory>(y)), y_h);
+    }
+}
+
+void TestStreamedOperator(void)
+{
+    cusp::csr_matrix<int, float, cusp::host_memory> A;
+    cusp::gallery::poisson5pt(A, 20, 15);
+
+    // one block, two blocks and one block every few rows
+    CheckStreamedOperator(A, size_t(1) << 30);
+    CheckStreamedOperator(A, A.num_entries * 4 + 256);
+    CheckStreamedOperator(A, 200);
+
+    // single rows larger than the bound
+    CheckStreamedOperator(A, 1);
+
+    ASSERT_EQUAL((cusp::streamed_operator<int, float>(A, 1).num_blocks()), size_t(A.num_rows));
+    ASSERT_EQUAL((cusp::streamed_operator<int, float>(A).num_blocks()), size_t(1));
+
+    // rectangular, with empty rows
+    cusp::csr_matrix<int, double, cusp::host_memory> B;
+    cusp::gallery::random(50, 80, 40, B);
+    CheckStreamedOperator(B, 160);
+
+    // no rows
+    cusp::csr_matrix<int, float, cusp::host_memory> E(0, 0, 0);
+    cusp::streamed_operator<int, float> A_empty(E);
+    ASSERT_EQUAL(A_empty.num_blocks(), size_t(0));
+
+    cusp::array1d<float, cusp::device_memory> x, y;
+    cusp::multiply(A_empty, x, y);
+
+    // wrong sizes
+    cusp::streamed_operator<int, float> A_streamed(A);
+    cusp::array1d<float, cusp::device_memory> z(A.num_rows + 1);
+    ASSERT_THROWS(cusp::multiply(A_streamed, z, z), cusp::invalid_input_exception);
+}
+DECLARE_UNITTEST(TestStreamedOperator);
+
+void TestStreamedOperatorConjugateGradient(void)
+{
+    cusp::csr_matrix<int, float, cusp::host_memory> A_h;
+    cusp::gallery::poisson5pt(A_h, 30, 30);
+
+    // about eight blocks
+    cusp::streamed_operator<int, float> A(A_h, A_h.num_entries);
+
+    cusp::array1d<float, cusp::device_memory> x(A.num_rows, 0.0f);
+    cusp::array1d<float, cusp::device_memory> b(A.num_rows, 1.0f);
+
+    cusp::default_monitor<float> monitor(b, 200, 1e-4);
+    cusp::krylov::cg(A, x, b, monitor);
+
+    ASSERT_EQUAL(monitor.converged(), true);
+
+    // residual with the explicit matrix
+    cusp::csr_matrix<int, float, cusp::device_memory> A_d(A_h);
+    cusp::array1d<float, cusp::device_memory> r(A.num_rows);
+    cusp::multiply(A_d, x, r);
+    cusp::blas::axpby(r, b, r, -1.0f, 1.0f);
+
+    ASSERT_EQUAL(cusp::blas::nrm2(r) < 1e-4 * cusp::blas::nrm2(b), true);
+}
+DECLARE_UNITTEST(TestStreamedOperatorConjugateGradient);
@@ -0,0 +1,104 @@
+#include <unittest/unittest.h>
+
+#include <cusp/structure_plan.h>
+#include <cusp/coo_matrix.h>
+#include <cusp/csr_matrix.h>
+#include <cusp/ell_matrix.h>
+#include <cusp/hyb_matrix.h>
+#include <cusp/gallery/poisson.h>
+#include <cusp/gallery/random.h>
+
+template <typename Matrix>
+void scale_matrix_values(Matrix& A, int step)
+{
+    cusp::array1d<float, cusp::host_memory> values(A.values);
+    for(size_t n = 0; n < values.size(); n++)
+        values[n] = int((n * 7 + step) % 11) - 5;
+    A.values = values;
+}
+
+template <typename SourceType, typename DestinationType>
+void CompareStructurePlan(SourceType& A)
+{
+    typedef typename DestinationType::memory_space MemorySpace;
+
+    scale_matrix_values(A, 0);
+
+    DestinationType B;
+    cusp::structure_plan<int, MemorySpace> plan;
+    cusp::convert(A, B, plan);
+
+    ASSERT_EQUAL(plan.num_entries, A.num_entries);
+
+    // same layout as a plain conversion
+    DestinationType C;
+    cusp::convert(A, C);
+
+    cusp::array2d<float, cusp::host_memory> B_dense(B);
+    cusp::array2d<float, cusp::host_memory> C_dense(C);
+    ASSERT_EQUAL_QUIET(B_dense, C_dense);
+
+    // the values change, the structure does not
+    for(int step = 1; step < 3; step++)
+    {
+        scale_matrix_values(A, step);
+
+        cusp::update_values(A, B, plan);
+        cusp::convert(A, C);
+
+        cusp::array2d<float, cusp::host_memory> B_dense(B);
+        cusp::array2d<float, cusp::host_memory> C_dense(C);
+        ASSERT_EQUAL_QUIET(B_dense, C_dense);
+    }
+}
+
+template <typename SourceType, class Space>
+void CompareStructurePlanFormats(SourceType& A)
+{
+    CompareStructurePlan< SourceType, cusp::coo_matrix<int, float, Space> >(A);
+    CompareStructurePlan< SourceType, cusp::csr_matrix<int, float, Space> >(A);
+    CompareStructurePlan< SourceType, cusp::hyb_matrix<int, float, Space> >(A);
+}
+
+template <class Space>
+void TestStructurePlanConvert(void)
+{
+    cusp::coo_matrix<int, float, Space> A;
+    cusp::gallery::poisson5pt(A, 6, 5);
+
+    CompareStructurePlanFormats<cusp::coo_matrix<int, float, Space>, Space>(A);
+    CompareStructurePlan< cusp::coo_matrix<int, float, Space>, cusp::ell_matrix<int, float, Space> >(A);
+
+    // irregular rows use the COO part of the HYB format
+    cusp::csr_matrix<int, float, Space> B;
+    cusp::gallery::random(60, 50, 400, B);
+
+    CompareStructurePlanFormats<cusp::csr_matrix<int, float, Space>, Space>(B);
+
+    // host source and device destination
+    cusp::coo_matrix<int, float, cusp::host_memory> C;
+    cusp::gallery::poisson9pt(C, 4, 7);
+
+    CompareStructurePlan< cusp::coo_matrix<int, float, cusp::host_memory>, cusp::hyb_matrix<int, float, Space> >(C);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestStructurePlanConvert);
+
+template <class Space>
+void TestStructurePlanMismatch(void)
+{
+    cusp::coo_matrix<int, float, Space> A;
+    cusp::gallery::poisson5pt(A, 4, 4);
+
+    cusp::hyb_matrix<int, float, Space> B;
+    cusp::structure_plan<int, Space> plan;
+    cusp::convert(A, B, plan);
+
+    cusp::coo_matrix<int, float, Space> C;
+    cusp::gallery::poisson5pt(C, 10, 10);
+    ASSERT_THROWS(cusp::update_values(C, B, plan), cusp::invalid_input_exception);
+
+    cusp::hyb_matrix<int, float, Space> D;
+    cusp::convert(C, D);
+    ASSERT_THROWS(cusp::update_values(A, D, plan), cusp::invalid_input_exception);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestStructurePlanMismatch);
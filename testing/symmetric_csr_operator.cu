@@ -0,0 +1,206 @@
+#include <unittest/unittest.h>
+
+#include <cusp/symmetric_csr_operator.h>
+#include <cusp/array1d.h>
+#include <cusp/coo_matrix.h>
+#include <cusp/csr_matrix.h>
+#include <cusp/hyb_matrix.h>
+#include <cusp/multiply.h>
+#include <cusp/transpose.h>
+#include <cusp/elementwise.h>
+#include <cusp/gallery/poisson.h>
+#include <cusp/gallery/random.h>
+#include <cusp/krylov/cg.h>
+#include <cusp/complex.h>
+#include <cusp/blas.h>
+
+#include <cstdlib>
+
+template <typename MemorySpace, typename MatrixType>
+void CheckSymmetricMultiply(const MatrixType& B)
+{
+    typedef typename MatrixType::value_type ValueType;
+
+    cusp::symmetric_csr_operator<int, ValueType, MemorySpace> A(B);
+
+    ASSERT_EQUAL(A.num_rows,    B.num_rows);
+    ASSERT_EQUAL(A.num_cols,    B.num_cols);
+    ASSERT_EQUAL(A.num_entries, B.num_entries);
+
+    cusp::array1d<ValueType, cusp::host_memory> x_h(B.num_cols);
+    for (size_t i = 0; i < x_h.size(); i++)
+        x_h[i] = ValueType(i % 7) - 3;
+
+    cusp::array1d<ValueType, cusp::host_memory> z_h(B.num_rows);
+    cusp::multiply(B, x_h, z_h);
+
+    cusp::array1d<ValueType, MemorySpace> x(x_h);
+    cusp::array1d<ValueType, MemorySpace> y(B.num_rows, ValueType(-1));
+
+    cusp::multiply(A, x, y);
+
+    ASSERT_ALMOST_EQUAL((cusp::array1d<ValueType, cusp::host_memory>(y)), z_h);
+}
+
+template <class MemorySpace>
+void TestSymmetricCsrOperator(void)
+{
+    cusp::csr_matrix<int, float, cusp::host_memory> P;
+    cusp::gallery::poisson5pt(P, 20, 15);
+
+    cusp::symmetric_csr_operator<int, float, MemorySpace> A(P);
+
+    // the diagonal and one neighbor in each direction
+    ASSERT_EQUAL(A.upper.num_entries, (P.num_entries + P.num_rows) / 2);
+
+    CheckSymmetricMultiply<MemorySpace>(P);
+
+    // any format in either memory space
+    CheckSymmetricMultiply<MemorySpace>(cusp::hyb_matrix<int, float, MemorySpace>(P));
+
+    cusp::csr_matrix<int, double, cusp::host_memory> Q;
+    cusp::gallery::poisson27pt(Q, 6, 5, 4);
+    CheckSymmetricMultiply<MemorySpace>(Q);
+
+    // B + B^T of a random matrix, with empty rows
+    cusp::coo_matrix<int, double, cusp::host_memory> R, Rt, S;
+    cusp::gallery::random(60, 60, 90, R);
+    cusp::transpose(R, Rt);
+    cusp::add(R, Rt, S);
+    CheckSymmetricMultiply<MemorySpace>(S);
+
+    // empty
+    cusp::csr_matrix<int, float, cusp::host_memory> E(4, 4, 0);
+    CheckSymmetricMultiply<MemorySpace>(E);
+
+    cusp::csr_matrix<int, float, cusp::host_memory> N(4, 5, 0);
+    ASSERT_THROWS((cusp::symmetric_csr_operator<int, float, MemorySpace>(N)), cusp::invalid_input_exception);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestSymmetricCsrOperator);
+
+template <class MemorySpace>
+void TestSymmetricCsrOperatorConjugateGradient(void)
+{
+    cusp::csr_matrix<int, float, MemorySpace> B;
+    cusp::gallery::poisson5pt(B, 10, 10);
+
+    cusp::symmetric_csr_operator<int, float, MemorySpace> A(B);
+
+    cusp::array1d<float, MemorySpace> x(A.num_rows, 0.0f);
+    cusp::array1d<float, MemorySpace> b(A.num_rows, 1.0f);
+
+    cusp::default_monitor<float> monitor(b, 20, 1e-4);
+    cusp::krylov::cg(A, x, b, monitor);
+
+    cusp::array1d<float, MemorySpace> residual(A.num_rows, 0.0f);
+    cusp::multiply(B, x, residual);
+    cusp::blas::axpby(residual, b, residual, -1.0f, 1.0f);
+
+    ASSERT_EQUAL(cusp::blas::nrm2(residual) < 1e-4 * cusp::blas::nrm2(b), true);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestSymmetricCsrOperatorConjugateGradient);
+
+template <typename Operator, typename MatrixType>
+void CheckSymmetricMultiplyDot(const MatrixType& B)
+{
+    typedef typename Operator::value_type   ValueType;
+    typedef typename Operator::memory_space MemorySpace;
+
+    Operator A(B);
+
+    cusp::array1d<ValueType, cusp::host_memory> x_h(B.num_cols);
+    for (size_t i = 0; i < x_h.size(); i++)
+        x_h[i] = ValueType(float(i % 7) - 3.0f, float(i % 5) - 2.0f);
+
+    cusp::array1d<ValueType, cusp::host_memory> z_h(B.num_rows);
+    cusp::multiply(B, x_h, z_h);
+
+    cusp::array1d<ValueType, MemorySpace> x(x_h);
+    cusp::array1d<ValueType, MemorySpace> y(B.num_rows, ValueType(-1));
+
+    cusp::multiply(A, x, y);
+    ASSERT_ALMOST_EQUAL((cusp::array1d<ValueType, cusp::host_memory>(y)), z_h);
+
+    cusp::blas::fill(y, ValueType(-1));
+
+    const ValueType dot = cusp::multiply_dot(A, x, y);
+
+    ASSERT_ALMOST_EQUAL((cusp::array1d<ValueType, cusp::host_memory>(y)), z_h);
+    ASSERT_ALMOST_EQUAL(dot, cusp::blas::dotc(z_h, x_h));
+}
+
+template <class MemorySpace>
+void TestHermitianCsrOperator(void)
+{
+    typedef cusp::complex<float> ValueType;
+
+    // U + U^H - D of a random upper triangle with a real diagonal
+    cusp::coo_matrix<int, ValueType, cusp::host_memory> B(50, 50, 250);
+
+    srand(17);
+
+    size_t n = 0;
+    for (int i = 0; i < 50; i++)
+    {
+        B.row_indices[n] = i;
+        B.column_indices[n] = i;
+        B.values[n++] = ValueType(float(rand() % 9) + 4.0f, 0.0f);
+    }
+
+    while (n < B.num_entries)
+    {
+        const int i = rand() % 49;
+        const int j = i + 1 + rand() % (49 - i);
+        const ValueType v(float(rand() % 7) - 3.0f, float(rand() % 5) - 2.0f);
+
+        B.row_indices[n] = i;
+        B.column_indices[n] = j;
+        B.values[n++] = v;
+        B.row_indices[n] = j;
+        B.column_indices[n] = i;
+        B.values[n++] = cusp::conj(v);
+    }
+
+    B.sort_by_row_and_column();
+
+    cusp::csr_matrix<int, ValueType, cusp::host_memory> H(B);
+
+    CheckSymmetricMultiplyDot< cusp::hermitian_csr_operator<int, ValueType, MemorySpace> >(H);
+
+    // the copy to the other memory space is Hermitian too
+    cusp::hermitian_csr_operator<int, ValueType, MemorySpace> A(H);
+    cusp::hermitian_csr_operator<int, ValueType, cusp::host_memory> A_h(A);
+
+    cusp::array1d<ValueType, cusp::host_memory> x(50, ValueType(1.0f, -1.0f));
+    cusp::array1d<ValueType, cusp::host_memory> y(50);
+    cusp::array1d<ValueType, cusp::host_memory> z(50);
+
+    cusp::multiply(A_h, x, y);
+    cusp::multiply(H, x, z);
+    ASSERT_ALMOST_EQUAL(y, z);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestHermitianCsrOperator);
+
+template <class MemorySpace>
+void TestSymmetricCsrOperatorMultiplyDot(void)
+{
+    typedef cusp::complex<double> ValueType;
+
+    // complex symmetric, A = A^T
+    cusp::csr_matrix<int, ValueType, cusp::host_memory> P;
+    cusp::gallery::poisson5pt(P, 12, 9);
+
+    for (size_t n = 0; n < P.num_entries; n++)
+        P.values[n] *= ValueType(1.0, 0.5);
+
+    CheckSymmetricMultiplyDot< cusp::symmetric_csr_operator<int, ValueType, MemorySpace> >(P);
+
+    // empty
+    cusp::csr_matrix<int, ValueType, cusp::host_memory> E(0, 0, 0);
+    cusp::symmetric_csr_operator<int, ValueType, MemorySpace> A(E);
+    cusp::array1d<ValueType, MemorySpace> x;
+    cusp::array1d<ValueType, MemorySpace> y;
+
+    ASSERT_EQUAL(cusp::multiply_dot(A, x, y), ValueType(0));
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestSymmetricCsrOperatorMultiplyDot);
@@ -0,0 +1,153 @@
+#include <unittest/unittest.h>
+
+#include <cusp/array2d.h>
+#include <cusp/csr_matrix.h>
+#include <cusp/multiply.h>
+#include <cusp/gallery/poisson.h>
+#include <cusp/krylov/shift_invert.h>
+#include <cusp/krylov/thick_restart_lanczos.h>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+// largest residual norm of the eigenpairs of A
+template <typename Matrix, typename Array1d, typename Array2d>
+double EigenResidual(const Matrix& A, const Array1d& lambda, const Array2d& V)
+{
+    cusp::csr_matrix<int, double, cusp::host_memory> A_host(A);
+    cusp::array2d<double, cusp::host_memory, cusp::column_major> V_host(V);
+
+    double residual = 0;
+
+    for (size_t j = 0; j < lambda.size(); j++)
+    {
+        cusp::array1d<double, cusp::host_memory> v(V_host.column(j).begin(), V_host.column(j).end());
+        cusp::array1d<double, cusp::host_memory> r(A_host.num_rows);
+
+        cusp::multiply(A_host, v, r);
+        cusp::blas::axpy(v, r, -lambda[j]);
+
+        residual = std::max(residual, double(cusp::blas::nrm2(r)));
+    }
+
+    return residual;
+}
+
+// eigenvalue i of the 1D Laplacian with diagonal 4, increasing
+inline double LaplacianEigenvalue(const size_t N, const size_t i)
+{
+    return 4.0 - 2.0 * std::cos((i + 1) * M_PI / (N + 1));
+}
+
+template <class MemorySpace>
+void TestThickRestartLanczos(void)
+{
+    const size_t N = 100;
+
+    cusp::csr_matrix<int, double, MemorySpace> A;
+    cusp::gallery::poisson5pt(A, N, 1);
+
+    cusp::array1d<double, cusp::host_memory> lambda;
+    cusp::array2d<double, MemorySpace, cusp::column_major> V;
+
+    size_t converged = cusp::krylov::thick_restart_lanczos(A, lambda, V, 4, cusp::krylov::largest_algebraic, 1e-8, 500);
+
+    ASSERT_EQUAL(converged, 4);
+    ASSERT_EQUAL(lambda.size(), 4);
+    ASSERT_EQUAL(V.num_rows, N);
+    ASSERT_EQUAL(V.num_cols, 4);
+
+    for (size_t i = 0; i < 4; i++)
+        ASSERT_EQUAL(std::abs(lambda[i] - LaplacianEigenvalue(N, N - 1 - i)) < 1e-6, true);
+
+    ASSERT_EQUAL(EigenResidual(A, lambda, V) < 1e-6, true);
+
+    converged = cusp::krylov::thick_restart_lanczos(A, lambda, V, 3, cusp::krylov::smallest_algebraic, 1e-8, 500);
+
+    ASSERT_EQUAL(converged, 3);
+
+    for (size_t i = 0; i < 3; i++)
+        ASSERT_EQUAL(std::abs(lambda[i] - LaplacianEigenvalue(N, i)) < 1e-6, true);
+
+    ASSERT_EQUAL(EigenResidual(A, lambda, V) < 1e-6, true);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestThickRestartLanczos);
+
+template <class MemorySpace>
+void TestThickRestartLanczosInvariantSubspace(void)
+{
+    // the basis spans the whole space
+    cusp::csr_matrix<int, double, MemorySpace> A;
+    cusp::gallery::poisson5pt(A, 6, 1);
+
+    cusp::array1d<double, cusp::host_memory> lambda;
+    cusp::array2d<double, MemorySpace, cusp::column_major> V;
+
+    size_t converged = cusp::krylov::thick_restart_lanczos(A, lambda, V, 2, cusp::krylov::largest_magnitude);
+
+    ASSERT_EQUAL(converged, 2);
+    ASSERT_EQUAL(std::abs(lambda[0] - LaplacianEigenvalue(6, 5)) < 1e-8, true);
+    ASSERT_EQUAL(std::abs(lambda[1] - LaplacianEigenvalue(6, 4)) < 1e-8, true);
+    ASSERT_EQUAL(EigenResidual(A, lambda, V) < 1e-8, true);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestThickRestartLanczosInvariantSubspace);
+
+template <class MemorySpace>
+void TestThickRestartLanczosShiftInvert(void)
+{
+    typedef cusp::csr_matrix<int, double, MemorySpace> Matrix;
+
+    const size_t N = 100;
+    const double sigma = 3.0;
+
+    Matrix A;
+    cusp::gallery::poisson5pt(A, N, 1);
+
+    // inner solves converge in at most N iterations
+    cusp::krylov::shift_invert_operator<Matrix> S(A, sigma, cusp::krylov::shift_invert_gmres(1e-12, N, 2 * N));
+
+    cusp::array1d<double, cusp::host_memory> mu;
+    cusp::array2d<double, MemorySpace, cusp::column_major> V;
+
+    size_t converged = cusp::krylov::thick_restart_lanczos(S, mu, V, 3, cusp::krylov::largest_magnitude, 1e-8, 500);
+
+    ASSERT_EQUAL(converged, 3);
+
+    // the eigenvalues of A closest to sigma
+    std::vector<double> expected(N);
+    for (size_t i = 0; i < N; i++)
+        expected[i] = LaplacianEigenvalue(N, i);
+
+    for (size_t i = 0; i < 3; i++)
+    {
+        std::vector<double>::iterator nearest = expected.begin();
+        for (std::vector<double>::iterator e = expected.begin(); e != expected.end(); ++e)
+            if (std::abs(*e - sigma) < std::abs(*nearest - sigma))
+                nearest = e;
+
+        mu[i] = S.eigenvalue(mu[i]);
+
+        ASSERT_EQUAL(std::abs(mu[i] - *nearest) < 1e-6, true);
+        expected.erase(nearest);
+    }
+
+    ASSERT_EQUAL(EigenResidual(A, mu, V) < 1e-6, true);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestThickRestartLanczosShiftInvert);
+
+void TestThickRestartLanczosInvalidInput(void)
+{
+    cusp::csr_matrix<int, double, cusp::host_memory> A;
+    cusp::gallery::poisson5pt(A, 10, 1);
+
+    cusp::array1d<double, cusp::host_memory> lambda;
+    cusp::array2d<double, cusp::host_memory, cusp::column_major> V;
+
+    ASSERT_THROWS(cusp::krylov::thick_restart_lanczos(A, lambda, V, 0), cusp::invalid_input_exception);
+    ASSERT_THROWS(cusp::krylov::thick_restart_lanczos(A, lambda, V, 11), cusp::invalid_input_exception);
+
+    cusp::csr_matrix<int, double, cusp::host_memory> B(10, 9, 0);
+    ASSERT_THROWS(cusp::krylov::thick_restart_lanczos(B, lambda, V, 2), cusp::invalid_input_exception);
+}
+DECLARE_UNITTEST(TestThickRestartLanczosInvalidInput);
@@ -0,0 +1,196 @@
+#include <unittest/unittest.h>
+
+#include <cusp/tiled_csr_operator.h>
+#include <cusp/array1d.h>
+#include <cusp/coo_matrix.h>
+#include <cusp/csr_matrix.h>
+#include <cusp/hyb_matrix.h>
+#include <cusp/multiply.h>
+#include <cusp/gallery/poisson.h>
+#include <cusp/gallery/random.h>
+#include <cusp/krylov/cg.h>
+#include <cusp/precond/aggregation/smoothed_aggregation.h>
+
+template <typename MemorySpace, typename MatrixType>
+void CheckTiledMultiply(const MatrixType& B)
+{
+    typedef typename MatrixType::value_type ValueType;
+
+    cusp::tiled_csr_operator<int, ValueType, MemorySpace> A(B);
+
+    ASSERT_EQUAL(A.num_rows,    B.num_rows);
+    ASSERT_EQUAL(A.num_cols,    B.num_cols);
+    ASSERT_EQUAL(A.num_entries, B.num_entries);
+
+    // whole tiles of 32 lanes of 16 entries
+    ASSERT_EQUAL(A.values.size() % 512, size_t(0));
+    ASSERT_EQUAL(A.lane_rows.size(), A.values.size() / 16);
+
+    cusp::array1d<ValueType, cusp::host_memory> x_h(B.num_cols);
+    for (size_t i = 0; i < x_h.size(); i++)
+        x_h[i] = ValueType(i % 7) - 3;
+
+    cusp::array1d<ValueType, cusp::host_memory> z_h(B.num_rows);
+    cusp::multiply(B, x_h, z_h);
+
+    cusp::array1d<ValueType, MemorySpace> x(x_h);
+    cusp::array1d<ValueType, MemorySpace> y(B.num_rows, ValueType(-1));
+
+    cusp::multiply(A, x, y);
+
+    ASSERT_ALMOST_EQUAL((cusp::array1d<ValueType, cusp::host_memory>(y)), z_h);
+
+    // a copy in the other memory space
+    cusp::tiled_csr_operator<int, ValueType, cusp::host_memory> C(A);
+    cusp::array1d<ValueType, cusp::host_memory> w_h(B.num_rows, ValueType(-1));
+    cusp::multiply(C, x_h, w_h);
+
+    ASSERT_ALMOST_EQUAL(w_h, z_h);
+}
+
+// poisson5pt with row and column 0 dense, kept positive definite by the
+// large diagonal of row 0 and the small entries -1/N
+void arrow_matrix(cusp::coo_matrix<int, float, cusp::host_memory>& A, const int nx, const int ny)
+{
+    cusp::coo_matrix<int, float, cusp::host_memory> P;
+    cusp::gallery::poisson5pt(P, nx, ny);
+
+    const int N = P.num_rows;
+
+    A.resize(N, N, P.num_entries + 2 * (N - 2));
+
+    int n = 0;
+    for (size_t k = 0; k < P.num_entries; k++)
+    {
+        A.row_indices[n] = P.row_indices[k];
+        A.column_indices[n] = P.column_indices[k];
+        A.values[n++] = P.row_indices[k] == 0 && P.column_indices[k] == 0 ? float(N) : P.values[k];
+    }
+
+    // entries (0,j) and (j,0) absent from the Laplacian
+    for (int j = 2; j < N; j++)
+    {
+        if (j == nx)
+            continue;
+
+        A.row_indices[n] = 0;
+        A.column_indices[n] = j;
+        A.values[n++] = -1.0f / N;
+        A.row_indices[n] = j;
+        A.column_indices[n] = 0;
+        A.values[n++] = -1.0f / N;
+    }
+
+    A.resize(N, N, n);
+    A.sort_by_row_and_column();
+}
+
+template <class MemorySpace>
+void TestTiledCsrOperator(void)
+{
+    cusp::csr_matrix<int, float, cusp::host_memory> P;
+    cusp::gallery::poisson5pt(P, 20, 15);
+    CheckTiledMultiply<MemorySpace>(P);
+
+    // any format in either memory space
+    CheckTiledMultiply<MemorySpace>(cusp::hyb_matrix<int, float, MemorySpace>(P));
+
+    cusp::csr_matrix<int, double, cusp::host_memory> Q;
+    cusp::gallery::poisson27pt(Q, 6, 5, 4);
+    CheckTiledMultiply<MemorySpace>(Q);
+
+    // rows spanning many lanes and tiles
+    cusp::coo_matrix<int, float, cusp::host_memory> R;
+    arrow_matrix(R, 40, 30);
+    CheckTiledMultiply<MemorySpace>(R);
+
+    // many empty rows
+    cusp::coo_matrix<int, double, cusp::host_memory> S;
+    cusp::gallery::random(300, 200, 250, S);
+    CheckTiledMultiply<MemorySpace>(S);
+
+    // fewer entries than a lane
+    cusp::coo_matrix<int, float, cusp::host_memory> T(5, 4, 3);
+    T.row_indices[0] = 1; T.column_indices[0] = 0; T.values[0] = 2;
+    T.row_indices[1] = 1; T.column_indices[1] = 3; T.values[1] = 3;
+    T.row_indices[2] = 4; T.column_indices[2] = 2; T.values[2] = 4;
+    CheckTiledMultiply<MemorySpace>(T);
+
+    // empty
+    cusp::csr_matrix<int, float, cusp::host_memory> E(4, 5, 0);
+    CheckTiledMultiply<MemorySpace>(E);
+
+    cusp::tiled_csr_operator<int, float, MemorySpace> A(P);
+    cusp::array1d<float, MemorySpace> x(P.num_cols + 1);
+    cusp::array1d<float, MemorySpace> y(P.num_rows);
+    ASSERT_THROWS(cusp::multiply(A, x, y), cusp::invalid_input_exception);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestTiledCsrOperator);
+
+template <class MemorySpace>
+void TestTiledCsrOperatorConjugateGradient(void)
+{
+    cusp::coo_matrix<int, float, cusp::host_memory> B;
+    arrow_matrix(B, 10, 10);
+
+    cusp::tiled_csr_operator<int, float, MemorySpace> A(B);
+
+    cusp::array1d<float, MemorySpace> x(A.num_rows, 0.0f);
+    cusp::array1d<float, MemorySpace> b(A.num_rows, 1.0f);
+
+    cusp::default_monitor<float> monitor(b, 100, 1e-4);
+    cusp::krylov::cg(A, x, b, monitor);
+
+    cusp::csr_matrix<int, float, MemorySpace> B_d(B);
+    cusp::array1d<float, MemorySpace> residual(A.num_rows, 0.0f);
+    cusp::multiply(B_d, x, residual);
+    cusp::blas::axpby(residual, b, residual, -1.0f, 1.0f);
+
+    ASSERT_EQUAL(cusp::blas::nrm2(residual) < 1e-4 * cusp::blas::nrm2(b), true);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestTiledCsrOperatorConjugateGradient);
+
+void TestTiledCsrOperatorSmoothedAggregation(void)
+{
+    typedef cusp::precond::aggregation::smoothed_aggregation<int, float, cusp::device_memory> Hierarchy;
+
+    // regular rows keep the HYB matrix
+    cusp::csr_matrix<int, float, cusp::device_memory> P;
+    cusp::gallery::poisson5pt(P, 30, 30);
+
+    Hierarchy M(P);
+    ASSERT_EQUAL(M.tiled_fine, false);
+    ASSERT_EQUAL(M.fine_operator.empty(), true);
+
+    // the dense row and column land in the COO part
+    cusp::coo_matrix<int, float, cusp::host_memory> B;
+    arrow_matrix(B, 30, 30);
+
+    cusp::csr_matrix<int, float, cusp::device_memory> A(B);
+
+    Hierarchy N(A);
+
+    const bool irregular = N.levels[0].A.coo.num_entries * 10 > N.levels[0].A.num_entries;
+    ASSERT_EQUAL(irregular, true);
+    ASSERT_EQUAL(N.tiled_fine, true);
+    ASSERT_EQUAL(N.fine_operator.empty(), false);
+
+    cusp::array1d<float, cusp::device_memory> x(A.num_rows, 0.0f);
+    cusp::array1d<float, cusp::device_memory> b(A.num_rows, 1.0f);
+
+    cusp::default_monitor<float> monitor(b, 50, 1e-4);
+    cusp::krylov::cg(A, x, b, monitor, N);
+    ASSERT_EQUAL(monitor.converged(), true);
+
+    // resetup rebuilds the tiled operator from the new values
+    cusp::blas::scal(A.values, 2.0f);
+    N.resetup(A);
+    ASSERT_EQUAL(N.tiled_fine, true);
+
+    cusp::array1d<float, cusp::device_memory> y(A.num_rows);
+    cusp::array1d<float, cusp::device_memory> z(A.num_rows);
+    cusp::multiply(N.fine_operator, b, y);
+    cusp::multiply(A, b, z);
+    ASSERT_ALMOST_EQUAL(y, z);
+}
+DECLARE_UNITTEST(TestTiledCsrOperatorSmoothedAggregation);
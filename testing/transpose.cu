@@ -117,3 +117,43 @@ void TestTranspose(void)
 }
 DECLARE_MATRIX_UNITTEST(TestTranspose);
 
+
+template <class MemorySpace>
+void TestTransposeCsrRowLengths(void)
+{
+    // columns of about 27 entries, and the same with a dense first column
+    // which is longer than the insertion sort handles
+    for(int dense_column = 0; dense_column < 2; dense_column++)
+    {
+        cusp::coo_matrix<int,float,cusp::host_memory> A_coo(300, 200, 0);
+
+        for(int i = 0; i < 300; i++)
+            for(int j = 0; j < 200; j++)
+                if((i * 7 + j * 13) % 11 == 0 || (dense_column && j == 0))
+                {
+                    A_coo.row_indices.push_back(i);
+                    A_coo.column_indices.push_back(j);
+                    A_coo.values.push_back(i - 0.5f * j);
+                }
+
+        A_coo.num_entries = A_coo.values.size();
+
+        // reference from the sorted COO transpose
+        cusp::coo_matrix<int,float,cusp::host_memory> At_coo;
+        cusp::transpose(A_coo, At_coo);
+        cusp::csr_matrix<int,float,cusp::host_memory> expected(At_coo);
+
+        cusp::csr_matrix<int,float,MemorySpace> A(A_coo);
+        cusp::csr_matrix<int,float,MemorySpace> At;
+        cusp::transpose(A, At);
+
+        cusp::csr_matrix<int,float,cusp::host_memory> result(At);
+
+        ASSERT_EQUAL(result.num_rows,       expected.num_rows);
+        ASSERT_EQUAL(result.num_cols,       expected.num_cols);
+        ASSERT_EQUAL(result.row_offsets,    expected.row_offsets);
+        ASSERT_EQUAL(result.column_indices, expected.column_indices);
+        ASSERT_EQUAL(result.values,         expected.values);
+    }
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestTransposeCsrRowLengths);
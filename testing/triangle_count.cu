@@ -0,0 +1,83 @@
+#include <unittest/unittest.h>
+
+#include <cusp/graph/triangle_count.h>
+
+#include <cusp/array2d.h>
+#include <cusp/coo_matrix.h>
+#include <cusp/csr_matrix.h>
+#include <cusp/gallery/grid.h>
+
+#include <cstdlib>
+
+// triangles of the graph of the pattern of a symmetric dense matrix
+size_t count_triangles(const cusp::array2d<int,cusp::host_memory>& A)
+{
+    const int N = A.num_rows;
+
+    size_t count = 0;
+
+    for (int i = 0; i < N; i++)
+        for (int j = i + 1; j < N; j++)
+            for (int k = j + 1; k < N; k++)
+                if (A(i,j) != 0 && A(j,k) != 0 && A(i,k) != 0)
+                    count++;
+
+    return count;
+}
+
+template <class MemorySpace>
+void TestTriangleCountComplete(void)
+{
+    // K_10 has C(10,3) triangles, the diagonal is ignored
+    cusp::array2d<int,cusp::host_memory> A(10, 10, 1);
+
+    cusp::csr_matrix<int,float,MemorySpace> G(A);
+    ASSERT_EQUAL(cusp::graph::triangle_count(G), size_t(120));
+
+    cusp::coo_matrix<int,float,MemorySpace> G_coo(A);
+    ASSERT_EQUAL(cusp::graph::triangle_count(G_coo), size_t(120));
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestTriangleCountComplete);
+
+template <class MemorySpace>
+void TestTriangleCountGrid(void)
+{
+    // grids are bipartite
+    cusp::csr_matrix<int,float,MemorySpace> G;
+    cusp::gallery::grid2d(G, 12, 9);
+
+    ASSERT_EQUAL(cusp::graph::triangle_count(G), size_t(0));
+
+    cusp::csr_matrix<int,float,MemorySpace> E(0, 0, 0);
+    ASSERT_EQUAL(cusp::graph::triangle_count(E), size_t(0));
+
+    cusp::csr_matrix<int,float,MemorySpace> R(4, 5, 0);
+    ASSERT_THROWS(cusp::graph::triangle_count(R), cusp::invalid_input_exception);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestTriangleCountGrid);
+
+template <class MemorySpace>
+void TestTriangleCountRandom(void)
+{
+    const int N = 60;
+
+    cusp::array2d<int,cusp::host_memory> A(N, N, 0);
+
+    srand(7);
+    for (int i = 0; i < N; i++)
+    {
+        for (int j = i + 1; j < N; j++)
+        {
+            if (rand() % 5 == 0)
+            {
+                A(i,j) = 1;
+                A(j,i) = 1;
+            }
+        }
+    }
+
+    cusp::csr_matrix<int,int,MemorySpace> G(A);
+
+    ASSERT_EQUAL(cusp::graph::triangle_count(G), count_triangles(A));
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestTriangleCountRandom);
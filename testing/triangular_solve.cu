@@ -0,0 +1,152 @@
+#include <unittest/unittest.h>
+
+#include <cusp/triangular_solve.h>
+
+#include <cusp/array2d.h>
+#include <cusp/coo_matrix.h>
+#include <cusp/csr_matrix.h>
+#include <cusp/multiply.h>
+#include <cusp/gallery/poisson.h>
+
+// nonsymmetric matrix with the pattern of the 5-point stencil
+void initialize_triangular_test_matrix(cusp::coo_matrix<int,float,cusp::host_memory>& A)
+{
+    cusp::gallery::poisson5pt(A, 9, 7);
+
+    for(size_t n = 0; n < A.num_entries; n++)
+    {
+        const int i = A.row_indices[n];
+        const int j = A.column_indices[n];
+
+        A.values[n] = i == j ? 4.0f + (i % 3) : -0.1f * (1 + (i + 2 * j) % 5);
+    }
+}
+
+// the matrix solved by a plan, as a dense matrix
+void dense_triangle(const cusp::coo_matrix<int,float,cusp::host_memory>& A,
+                    cusp::array2d<float,cusp::host_memory>& T,
+                    const cusp::triangle_type triangle, const cusp::diagonal_type diagonal,
+                    const bool transposed)
+{
+    T.resize(A.num_rows, A.num_cols);
+    thrust::fill(T.values.begin(), T.values.end(), 0.0f);
+
+    for(size_t n = 0; n < A.num_entries; n++)
+    {
+        const int i = A.row_indices[n];
+        const int j = A.column_indices[n];
+
+        if(i == j)
+            T(i, i) = diagonal == cusp::unit_diagonal ? 1.0f : A.values[n];
+        else if(triangle == cusp::lower_triangle ? j < i : j > i)
+            T(transposed ? j : i, transposed ? i : j) = A.values[n];
+    }
+}
+
+template <typename MemorySpace>
+void CheckTriangularSolve(const cusp::coo_matrix<int,float,cusp::host_memory>& A,
+                          const cusp::triangle_type triangle, const cusp::diagonal_type diagonal,
+                          const bool transposed)
+{
+    cusp::array2d<float,cusp::host_memory> T;
+    dense_triangle(A, T, triangle, diagonal, transposed);
+
+    cusp::array1d<float,cusp::host_memory> x(A.num_rows);
+    for(size_t i = 0; i < x.size(); i++)
+        x[i] = int(i % 7) - 3;
+
+    cusp::array1d<float,cusp::host_memory> b(A.num_rows);
+    cusp::multiply(T, x, b);
+
+    cusp::csr_matrix<int,float,MemorySpace> A_d(A);
+    cusp::array1d<float,MemorySpace> b_d(b);
+    cusp::array1d<float,MemorySpace> y_d(A.num_rows, 10.0f);
+
+    cusp::triangular_solve_plan<int,float,MemorySpace> plan(A_d, triangle, diagonal, transposed);
+    plan.solve(b_d, y_d);
+
+    cusp::array1d<float,cusp::host_memory> y(y_d);
+    ASSERT_ALMOST_EQUAL(y, x);
+
+    // the plan is reused, and works from any format
+    cusp::array1d<float,MemorySpace> z_d(A.num_rows, 0.0f);
+    cusp::solve_triangular(cusp::coo_matrix<int,float,MemorySpace>(A), b_d, z_d, triangle, diagonal, transposed);
+
+    cusp::array1d<float,cusp::host_memory> z(z_d);
+    ASSERT_ALMOST_EQUAL(z, x);
+
+    plan.solve(b_d, y_d);
+    ASSERT_EQUAL(y_d, z_d);
+}
+
+template <typename MemorySpace>
+void TestTriangularSolve(void)
+{
+    cusp::coo_matrix<int,float,cusp::host_memory> A;
+    initialize_triangular_test_matrix(A);
+
+    for(int t = 0; t < 2; t++)
+    {
+        const cusp::triangle_type triangle = t == 0 ? cusp::lower_triangle : cusp::upper_triangle;
+
+        CheckTriangularSolve<MemorySpace>(A, triangle, cusp::stored_diagonal, false);
+        CheckTriangularSolve<MemorySpace>(A, triangle, cusp::unit_diagonal,   false);
+        CheckTriangularSolve<MemorySpace>(A, triangle, cusp::stored_diagonal, true);
+        CheckTriangularSolve<MemorySpace>(A, triangle, cusp::unit_diagonal,   true);
+    }
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestTriangularSolve);
+
+template <typename MemorySpace>
+void TestTriangularSolvePlan(void)
+{
+    cusp::csr_matrix<int,float,MemorySpace> A;
+    cusp::gallery::poisson5pt(A, 16, 12);
+
+    cusp::triangular_solve_plan<int,float,MemorySpace> L(A, cusp::lower_triangle);
+    cusp::triangular_solve_plan<int,float,MemorySpace> U(A, cusp::upper_triangle);
+
+    // the levels of the 5-point stencil are the anti-diagonals of the grid
+    ASSERT_EQUAL(L.num_levels(), 16 + 12 - 1);
+    ASSERT_EQUAL(U.num_levels(), 16 + 12 - 1);
+    ASSERT_EQUAL(L.strict.num_entries, (A.num_entries - A.num_rows) / 2);
+
+    // the transposed lower triangle of a symmetric matrix is its upper triangle
+    cusp::triangular_solve_plan<int,float,MemorySpace> Lt(A, cusp::lower_triangle, cusp::stored_diagonal, true);
+    ASSERT_EQUAL(Lt.level_offsets == U.level_offsets, true);
+    ASSERT_EQUAL(Lt.level_rows, U.level_rows);
+
+    // copy to another memory space
+    cusp::triangular_solve_plan<int,float,cusp::host_memory> H(L);
+    ASSERT_EQUAL(H.level_rows, L.level_rows);
+    ASSERT_EQUAL(H.inv_diagonal, L.inv_diagonal);
+
+    cusp::array1d<float,MemorySpace> b(A.num_rows, 1.0f);
+    cusp::array1d<float,MemorySpace> x(A.num_rows + 1);
+    ASSERT_THROWS(L.solve(b, x), cusp::invalid_input_exception);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestTriangularSolvePlan);
+
+template <typename MemorySpace>
+void TestTriangularSolveInvalid(void)
+{
+    typedef cusp::triangular_solve_plan<int,float,MemorySpace> Plan;
+
+    cusp::coo_matrix<int,float,cusp::host_memory> A;
+    initialize_triangular_test_matrix(A);
+
+    // zero on the diagonal, which a unit diagonal ignores
+    for(size_t n = 0; n < A.num_entries; n++)
+        if(A.row_indices[n] == 5 && A.column_indices[n] == 5)
+            A.values[n] = 0.0f;
+
+    cusp::csr_matrix<int,float,MemorySpace> B(A);
+    ASSERT_THROWS((Plan(B, cusp::lower_triangle)), cusp::invalid_input_exception);
+
+    Plan unit(B, cusp::lower_triangle, cusp::unit_diagonal);
+    ASSERT_EQUAL(unit.num_levels() > 0, true);
+
+    cusp::csr_matrix<int,float,MemorySpace> C(4, 5, 0);
+    ASSERT_THROWS((Plan(C, cusp::upper_triangle)), cusp::invalid_input_exception);
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestTriangularSolveInvalid);
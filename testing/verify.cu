@@ -9,6 +9,9 @@
 #include <cusp/ell_matrix.h>
 #include <cusp/hyb_matrix.h>
 
+#include <sstream>
+#include <string>
+
 template <typename MemorySpace>
 void TestIsValidMatrixCoo(void)
 {
@@ -259,3 +262,94 @@ void TestAssertIsValidMatrix(void)
 }
 DECLARE_SPARSE_MATRIX_UNITTEST(TestAssertIsValidMatrix);
 
+
+template <typename MemorySpace>
+void TestIsValidMatrixFirstViolation(void)
+{
+    cusp::coo_matrix<int, float, cusp::host_memory> B(4, 4, 6);
+    B.row_indices[0] = 0;  B.column_indices[0] = 0;  B.values[0] = 1;
+    B.row_indices[1] = 0;  B.column_indices[1] = 2;  B.values[1] = 1;
+    B.row_indices[2] = 1;  B.column_indices[2] = 1;  B.values[2] = 1;
+    B.row_indices[3] = 2;  B.column_indices[3] = 0;  B.values[3] = 1;
+    B.row_indices[4] = 2;  B.column_indices[4] = 3;  B.values[4] = 1;
+    B.row_indices[5] = 3;  B.column_indices[5] = 3;  B.values[5] = 1;
+
+    // the earliest of several violations is reported
+    {
+        cusp::coo_matrix<int, float, MemorySpace> M(B);
+        M.column_indices[4] = 7;
+        M.row_indices[3] = 0;
+
+        std::ostringstream oss;
+        ASSERT_EQUAL(cusp::is_valid_matrix(M, oss), false);
+        ASSERT_EQUAL(oss.str(), std::string("row indices should form a non-decreasing sequence (first violation at position 3)"));
+    }
+    {
+        cusp::csr_matrix<int, float, MemorySpace> M(B);
+        M.column_indices[4] = 7;
+        M.column_indices[5] = -1;
+
+        std::ostringstream oss;
+        ASSERT_EQUAL(cusp::is_valid_matrix(M, oss), false);
+        ASSERT_EQUAL(oss.str(), std::string("column indices should be less than num_cols (4) (first violation at position 4)"));
+    }
+    {
+        cusp::csr_matrix<int, float, MemorySpace> M(B);
+        M.row_offsets[2] = 1;
+
+        std::ostringstream oss;
+        ASSERT_EQUAL(cusp::is_valid_matrix(M, oss), false);
+        ASSERT_EQUAL(oss.str(), std::string("row offsets should form a non-decreasing sequence (first violation at position 2)"));
+    }
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestIsValidMatrixFirstViolation);
+
+template <typename MemorySpace>
+void TestIsValidMatrixThenSort(void)
+{
+    cusp::coo_matrix<int, float, cusp::host_memory> B(3, 3, 5);
+    B.row_indices[0] = 0;  B.column_indices[0] = 1;  B.values[0] = 1;
+    B.row_indices[1] = 0;  B.column_indices[1] = 2;  B.values[1] = 2;
+    B.row_indices[2] = 1;  B.column_indices[2] = 2;  B.values[2] = 3;
+    B.row_indices[3] = 2;  B.column_indices[3] = 0;  B.values[3] = 4;
+    B.row_indices[4] = 2;  B.column_indices[4] = 1;  B.values[4] = 5;
+
+    // validation must not change the result of sorting entries
+    // which are modified in place afterwards
+    {
+        cusp::coo_matrix<int, float, MemorySpace> M(B);
+        ASSERT_EQUAL(cusp::is_valid_matrix(M), true);
+
+        M.row_indices[0] = 2;  M.column_indices[0] = 2;
+        ASSERT_EQUAL(M.is_sorted_by_row(), false);
+        ASSERT_EQUAL(M.is_sorted_by_row_and_column(), false);
+
+        M.sort_by_row_and_column();
+        ASSERT_EQUAL(M.is_sorted_by_row_and_column(), true);
+        ASSERT_EQUAL(M.row_indices[4],    2);
+        ASSERT_EQUAL(M.column_indices[4], 2);
+        ASSERT_EQUAL(M.values[4],         1);
+    }
+    {
+        cusp::csr_matrix<int, float, MemorySpace> M(B);
+        ASSERT_EQUAL(cusp::is_valid_matrix(M), true);
+
+        M.column_indices[0] = 2;  M.values[0] = 1;
+        M.column_indices[1] = 1;  M.values[1] = 2;
+
+        M.sort_by_column();
+        ASSERT_EQUAL(M.column_indices[0], 1);
+        ASSERT_EQUAL(M.column_indices[1], 2);
+        ASSERT_EQUAL(M.values[0],         2);
+        ASSERT_EQUAL(M.values[1],         1);
+
+        ASSERT_EQUAL(cusp::is_valid_matrix(M), true);
+
+        M.column_indices[4] = 0;
+        M.sum_duplicates();
+        ASSERT_EQUAL(M.num_entries,       4);
+        ASSERT_EQUAL(M.column_indices[3], 0);
+        ASSERT_EQUAL(M.values[3],         9);
+    }
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestIsValidMatrixThenSort);
@@ -0,0 +1,206 @@
+#include <unittest/unittest.h>
+
+#include <cusp/graph/vertex_coloring.h>
+
+#include <cusp/coo_matrix.h>
+#include <cusp/csr_matrix.h>
+#include <cusp/gallery/poisson.h>
+
+#include <algorithm>
+#include <queue>
+#include <vector>
+
+// check that adjacent vertices have different colors and that every
+// color is used
+template <typename MatrixType, typename ArrayType>
+bool is_valid_coloring(const MatrixType& A, const ArrayType& colors, size_t num_colors)
+{
+    typedef typename MatrixType::index_type IndexType;
+    typedef typename MatrixType::value_type ValueType;
+
+    cusp::csr_matrix<IndexType,ValueType,cusp::host_memory> csr(A);
+    cusp::array1d<int,cusp::host_memory> h_colors(colors);
+
+    std::vector<bool> used(num_colors, false);
+
+    for(size_t i = 0; i < csr.num_rows; i++)
+    {
+        if(h_colors[i] < 0 || size_t(h_colors[i]) >= num_colors)
+            return false;
+
+        used[h_colors[i]] = true;
+
+        for(IndexType jj = csr.row_offsets[i]; jj < csr.row_offsets[i + 1]; jj++)
+        {
+            const size_t j = csr.column_indices[jj];
+
+            if(i != j && h_colors[i] == h_colors[j])
+                return false;
+        }
+    }
+
+    for(size_t c = 0; c < num_colors; c++)
+        if(!used[c])
+            return false;
+
+    return true;
+}
+
+template <class MatrixType>
+void TestVertexColoring(void)
+{
+    typedef typename MatrixType::memory_space MemorySpace;
+
+    {
+        cusp::coo_matrix<int,float,MemorySpace> A;
+        cusp::gallery::poisson5pt(A, 14, 11);
+
+        MatrixType M(A);
+        cusp::array1d<int,MemorySpace> colors;
+        size_t num_colors = cusp::graph::vertex_coloring(M, colors);
+
+        ASSERT_EQUAL(colors.size(), 14 * 11);
+        ASSERT_EQUAL(num_colors >= 2, true);
+        ASSERT_EQUAL(is_valid_coloring(M, colors, num_colors), true);
+    }
+
+    {
+        cusp::coo_matrix<int,float,MemorySpace> A;
+        cusp::gallery::poisson27pt(A, 6, 5, 4);
+
+        MatrixType M(A);
+        cusp::array1d<int,MemorySpace> colors;
+        size_t num_colors = cusp::graph::vertex_coloring(M, colors);
+
+        ASSERT_EQUAL(num_colors >= 8, true);
+        ASSERT_EQUAL(is_valid_coloring(M, colors, num_colors), true);
+    }
+
+    {
+        // vertices without neighbors share a single color
+        cusp::coo_matrix<int,float,cusp::host_memory> A(7, 7, 7);
+        for(int i = 0; i < 7; i++)
+        {
+            A.row_indices[i] = i;  A.column_indices[i] = i;  A.values[i] = 1.0f;
+        }
+
+        MatrixType M(A);
+        cusp::array1d<int,MemorySpace> colors;
+        ASSERT_EQUAL(cusp::graph::vertex_coloring(M, colors), 1);
+        ASSERT_EQUAL(colors, (cusp::array1d<int,MemorySpace>(7, 0)));
+    }
+}
+DECLARE_SPARSE_MATRIX_UNITTEST(TestVertexColoring);
+
+// check that vertices within distance k have different colors
+template <typename MatrixType, typename ArrayType>
+bool is_valid_distance_coloring(const MatrixType& A, const ArrayType& colors, size_t num_colors, int k)
+{
+    cusp::csr_matrix<int,float,cusp::host_memory> csr(A);
+    cusp::array1d<int,cusp::host_memory> h_colors(colors);
+
+    for(int i = 0; i < int(csr.num_rows); i++)
+    {
+        if(h_colors[i] < 0 || size_t(h_colors[i]) >= num_colors)
+            return false;
+
+        // BFS to depth k
+        std::vector<int> distance(csr.num_rows, -1);
+        std::queue<int> Q;
+        distance[i] = 0;
+        Q.push(i);
+
+        while(!Q.empty())
+        {
+            const int v = Q.front();
+            Q.pop();
+
+            if(v != i && h_colors[v] == h_colors[i])
+                return false;
+
+            if(distance[v] == k)
+                continue;
+
+            for(int jj = csr.row_offsets[v]; jj < csr.row_offsets[v + 1]; jj++)
+            {
+                const int w = csr.column_indices[jj];
+                if(distance[w] < 0)
+                {
+                    distance[w] = distance[v] + 1;
+                    Q.push(w);
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+template <class MatrixType>
+void TestDistanceColoring(void)
+{
+    typedef typename MatrixType::memory_space MemorySpace;
+
+    cusp::coo_matrix<int,float,MemorySpace> A;
+    cusp::gallery::poisson5pt(A, 21, 17);
+
+    MatrixType M(A);
+
+    for(int k = 1; k <= 3; k++)
+    {
+        cusp::array1d<int,MemorySpace> colors;
+        size_t num_colors = cusp::graph::color(M, colors, k);
+
+        ASSERT_EQUAL(colors.size(), 21 * 17);
+        ASSERT_EQUAL(is_valid_distance_coloring(M, colors, num_colors, k), true);
+
+        // any k+1 consecutive vertices of a grid line are within distance k
+        ASSERT_EQUAL(num_colors >= size_t(k + 1), true);
+    }
+
+    // everything shares a color at distance 0
+    cusp::array1d<int,MemorySpace> colors;
+    ASSERT_EQUAL(cusp::graph::color(M, colors, 0), 1);
+    ASSERT_EQUAL(colors, (cusp::array1d<int,MemorySpace>(21 * 17, 0)));
+}
+DECLARE_SPARSE_MATRIX_UNITTEST(TestDistanceColoring);
+
+template <class MemorySpace>
+void TestDistanceColoringBalanced(void)
+{
+    cusp::csr_matrix<int,float,MemorySpace> A;
+    cusp::gallery::poisson5pt(A, 60, 50);
+
+    const int N = 60 * 50;
+
+    for(int k = 1; k <= 2; k++)
+    {
+        cusp::array1d<int,MemorySpace> unbalanced;
+        cusp::array1d<int,MemorySpace> balanced;
+
+        size_t num_colors = cusp::graph::color(A, unbalanced, k);
+
+        // the balancing pass does not add colors
+        ASSERT_EQUAL(cusp::graph::color(A, balanced, k, true), num_colors);
+        ASSERT_EQUAL(is_valid_distance_coloring(A, balanced, num_colors, k), true);
+
+        std::vector<int> unbalanced_sizes(num_colors, 0);
+        std::vector<int> balanced_sizes(num_colors, 0);
+
+        cusp::array1d<int,cusp::host_memory> h_unbalanced(unbalanced);
+        cusp::array1d<int,cusp::host_memory> h_balanced(balanced);
+
+        for(int i = 0; i < N; i++)
+        {
+            unbalanced_sizes[h_unbalanced[i]]++;
+            balanced_sizes[h_balanced[i]]++;
+        }
+
+        const int target = (N + num_colors - 1) / num_colors;
+
+        ASSERT_EQUAL(*std::max_element(unbalanced_sizes.begin(), unbalanced_sizes.end()) > target, true);
+        ASSERT_EQUAL(*std::max_element(balanced_sizes.begin(), balanced_sizes.end()) <= target + target / 4, true);
+        ASSERT_EQUAL(*std::min_element(balanced_sizes.begin(), balanced_sizes.end()) >= target / 2, true);
+    }
+}
+DECLARE_HOST_DEVICE_UNITTEST(TestDistanceColoringBalanced);